@@ -230,6 +230,9 @@ int DnDTransferObjectWrite(PDNDTRANSFEROBJECT pObj, const void *pvBuf, size_t cb
 /** Defines the default chunk size of DnD data transfers.
  *  Supported on all (older) Guest Additions which also support DnD. */
 #define DND_DEFAULT_CHUNK_SIZE                       _64K
+/** Chunk size used for data transfers when both host and guest support
+ *  VBOX_DND_GF_0_LARGE_CHUNKS / VBOX_DND_HF_0_LARGE_CHUNKS. */
+#define DND_MAX_CHUNK_SIZE                           _1M
 
 /** Separator for a formats list. */
 #define DND_FORMATS_SEPARATOR_STR                    "\r\n"
@@ -282,6 +282,9 @@ enum eGuestFn
  * @{ */
 /** No flags set. */
 #define VBOX_DND_GF_NONE                          0
+/** Guest can handle data chunks of up to DND_MAX_CHUNK_SIZE bytes.
+ * @since 7.2 */
+#define VBOX_DND_GF_0_LARGE_CHUNKS                RT_BIT_64(0)
 /** Bit that must be set in the 2nd parameter, will be cleared if the host reponds
  * correctly (old hosts might not). */
 #define VBOX_DND_GF_1_MUST_BE_ONE                 RT_BIT_64(63)
@@ -292,6 +295,9 @@ enum eGuestFn
  * @{ */
 /** No flags set. */
 #define VBOX_DND_HF_NONE                          0
+/** Host can handle data chunks of up to DND_MAX_CHUNK_SIZE bytes.
+ * @since 7.2 */
+#define VBOX_DND_HF_0_LARGE_CHUNKS                RT_BIT_64(0)
 /** @} */
 
 /**
@@ -849,6 +849,10 @@ enum GUEST_FILE_SEEKTYPE
 /** Supports enumerating the guest mount points / drive letters.
  *  @since 7.1 */
 #define VBOX_GUESTCTRL_GF_0_MOUNT_POINTS_ENUM       RT_BIT_64(6)
+/** Guest file read and write requests (HOST_MSG_FILE_READ[_AT] and
+ *  HOST_MSG_FILE_WRITE[_AT]) may be bigger than 64 KiB; the guest grows its
+ *  buffer as needed.  Used for copying files in bigger chunks. */
+#define VBOX_GUESTCTRL_GF_0_FILE_BIG_CHUNKS         RT_BIT_64(7)
 /** Bit that must be set in the 2nd parameter, will be cleared if the host reponds
  * correctly (old hosts might not). */
 #define VBOX_GUESTCTRL_GF_1_MUST_BE_ONE             RT_BIT_64(63)
@@ -325,6 +325,8 @@ DECLINLINE(int) GuestPropWriteFlags(uint32_t fFlags, char *pszFlags)
 #define GUEST_PROP_FN_ENUM_PROPS            5
 /** Poll for guest notifications */
 #define GUEST_PROP_FN_GET_NOTIFICATION      6
+/** Set several guest properties in one go */
+#define GUEST_PROP_FN_SET_PROPS             7
 /** @} */
 
 
@@ -459,6 +461,30 @@ typedef struct GuestPropMsgDelProperty
 } GuestPropMsgDelProperty;
 AssertCompileSize(GuestPropMsgDelProperty, 40 + 1 * (ARCH_BITS == 64 ? 16 : 12));
 
+/**
+ * The guest is requesting to change several properties in one call.
+ *
+ * The properties are applied in order, each one behaving as if it had been
+ * passed to SET_PROP individually, and processing stops at the first one that
+ * fails.  All entries are validated before any of them is applied, so a
+ * malformed block leaves the registry untouched.
+ */
+typedef struct GuestPropMsgSetProperties
+{
+    VBGLIOCHGCMCALL hdr;
+
+    /**
+     * The properties to set.  (IN pointer)
+     * A sequence of "Name\0Value\0Flags\0" triplets terminated by an empty
+     * string in place of the next name, i.e. the block ends with a double
+     * zero terminator.  Each string must satisfy the same criteria as the
+     * corresponding SET_PROP parameter.  At most GUEST_PROP_MAX_PROPS triplets
+     * are accepted.
+     */
+    HGCMFunctionParameter props;
+} GuestPropMsgSetProperties;
+AssertCompileSize(GuestPropMsgSetProperties, 40 + 1 * (ARCH_BITS == 64 ? 16 : 12));
+
 /** The guest is requesting to enumerate properties */
 typedef struct GuestPropMsgEnumProperties
 {
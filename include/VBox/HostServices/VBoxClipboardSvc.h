@@ -616,9 +616,59 @@
  * @since   7.1
  */
 #define VBOX_SHCL_GUEST_FN_NEGOTIATE_CHUNK_SIZE     28
+/** Reads a chunk of host clipboard data.
+ *
+ * Replaces VBOX_SHCL_GUEST_FN_DATA_READ for guests which report
+ * VBOX_SHCL_GF_0_DATA_CHUNKS to a host reporting VBOX_SHCL_HF_0_DATA_CHUNKS.
+ * The host fetches the data from the host clipboard when the guest asks for
+ * the chunk at offset zero and serves all following chunks from that copy, so
+ * nothing is read from the host clipboard until the guest actually needs it
+ * and the guest never has to guess the total size up front.
+ *
+ * The parameters are a 32-bit format bit (VBOX_SHCL_FMT_XXX), the 64-bit
+ * offset to read at, the data buffer, a 32-bit count of bytes returned and the
+ * 32-bit total size of the data, see VBoxShClParmDataReadChunk.  Offsets must
+ * be read in order; reading the last byte releases the host copy.
+ *
+ * @retval  VINF_SUCCESS on success.
+ * @retval  VERR_INVALID_CLIENT_ID
+ * @retval  VERR_WRONG_PARAMETER_COUNT
+ * @retval  VERR_WRONG_PARAMETER_TYPE
+ * @retval  VERR_WRONG_ORDER if the offset does not continue the current read.
+ * @retval  VERR_INVALID_STATE if the host clipboard changed during the read;
+ *          the guest should start over at offset zero.
+ * @retval  VERR_ACCESS_DENIED if the clipboard mode is not bi-directional or
+ *          host-to-guest.
+ * @since   7.2
+ */
+#define VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK          29
+/** Writes a chunk of guest clipboard data to the host.
+ *
+ * Replaces VBOX_SHCL_GUEST_FN_DATA_WRITE for guests which report
+ * VBOX_SHCL_GF_0_DATA_CHUNKS to a host reporting VBOX_SHCL_HF_0_DATA_CHUNKS.
+ * The chunks are collected by the host and handed on as a whole once the
+ * chunk flagged VBOX_SHCL_DATA_CHUNK_F_LAST arrives.
+ *
+ * The parameters are the 64-bit context ID from the data request message, a
+ * 32-bit format bit (VBOX_SHCL_FMT_XXX), the 64-bit offset of the chunk, 32-bit
+ * VBOX_SHCL_DATA_CHUNK_F_XXX flags and the data, see
+ * VBoxShClParmDataWriteChunk.  Chunks must be sent in order.
+ *
+ * @retval  VINF_SUCCESS on success.
+ * @retval  VERR_INVALID_CLIENT_ID
+ * @retval  VERR_WRONG_PARAMETER_COUNT
+ * @retval  VERR_WRONG_PARAMETER_TYPE
+ * @retval  VERR_INVALID_CONTEXT if the context ID didn't match up.
+ * @retval  VERR_WRONG_ORDER if the offset does not continue the current write.
+ * @retval  VERR_TOO_MUCH_DATA if the total exceeds VBOX_SHCL_MAX_DATA_SIZE.
+ * @retval  VERR_ACCESS_DENIED if the clipboard mode is not bi-directional or
+ *          guest-to-host.
+ * @since   7.2
+ */
+#define VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK         30
 
 /** The last function number (used for validation/sanity).   */
-#define VBOX_SHCL_GUEST_FN_LAST                     VBOX_SHCL_GUEST_FN_NEGOTIATE_CHUNK_SIZE
+#define VBOX_SHCL_GUEST_FN_LAST                     VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK
 /** @} */
 
 
@@ -626,6 +676,19 @@
 #define VBOX_SHCL_MAX_CHUNK_SIZE                  VMMDEV_MAX_HGCM_DATA_SIZE - _4K
 /** Default chunk size for a single data transfer. */
 #define VBOX_SHCL_DEFAULT_CHUNK_SIZE              RT_MIN(_64K, VBOX_SHCL_MAX_CHUNK_SIZE);
+/** Maximum size of clipboard data of a single (non-file) format moved in
+ *  chunks, see VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK. */
+#define VBOX_SHCL_MAX_DATA_SIZE                   _256M
+
+/** @name VBOX_SHCL_DATA_CHUNK_F_XXX - Flags for VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK.
+ * @{ */
+/** No flags set. */
+#define VBOX_SHCL_DATA_CHUNK_F_NONE               UINT32_C(0)
+/** This is the last chunk, the data is complete. */
+#define VBOX_SHCL_DATA_CHUNK_F_LAST               RT_BIT_32(0)
+/** Valid flags mask. */
+#define VBOX_SHCL_DATA_CHUNK_F_VALID_MASK         UINT32_C(0x00000001)
+/** @} */
 
 
 /** @name VBOX_SHCL_GF_XXX - Guest features.
@@ -643,6 +706,10 @@
  *  a guest-specific temporary location first.
  *  Currently only supported for Windows guests (integrated into Windows Explorer via IDataObject). */
 #define VBOX_SHCL_GF_0_TRANSFERS_FRONTEND         RT_BIT_64(2)
+/** The guest can move clipboard data in chunks, see
+ *  VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK and VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK.
+ * @since 7.2 */
+#define VBOX_SHCL_GF_0_DATA_CHUNKS                RT_BIT_64(3)
 /** Bit that must be set in the 2nd parameter, will be cleared if the host reponds
  * correctly (old hosts might not). */
 #define VBOX_SHCL_GF_1_MUST_BE_ONE                RT_BIT_64(63)
@@ -660,6 +727,10 @@
  *  This includes messages like
  * @since 7.1 */
 #define VBOX_SHCL_HF_0_TRANSFERS                  RT_BIT_64(1)
+/** The host can move clipboard data in chunks, see
+ *  VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK and VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK.
+ * @since 7.2 */
+#define VBOX_SHCL_HF_0_DATA_CHUNKS                RT_BIT_64(2)
 /** @} */
 
 /** @name Context ID related macros and limits
@@ -774,6 +845,46 @@ typedef struct VBoxShClParmDataWriteOld
 #define VBOX_SHCL_CPARMS_DATA_WRITE_61B 5   /**< The 6.1 dev cycle variant, see VBOX_SHCL_GUEST_FN_DATA_WRITE.  */
 /** @} */
 
+/** @name VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK
+ * @{ */
+/** VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK parameters. */
+typedef struct VBoxShClParmDataReadChunk
+{
+    /** uint32_t, in:   Requested format (VBOX_SHCL_FMT_XXX). */
+    HGCMFunctionParameter f32Format;
+    /** uint64_t, in:   Offset to read at. */
+    HGCMFunctionParameter off64;
+    /** ptr, out:       The data buffer to put the chunk in. */
+    HGCMFunctionParameter pData;
+    /** uint32_t, out:  Number of bytes returned in the buffer. */
+    HGCMFunctionParameter cb32Read;
+    /** uint32_t, out:  Total size of the data. */
+    HGCMFunctionParameter cb32Total;
+} VBoxShClParmDataReadChunk;
+
+#define VBOX_SHCL_CPARMS_DATA_READ_CHUNK    5   /**< The parameter count for VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK. */
+/** @}  */
+
+/** @name VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK
+ * @{ */
+/** VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK parameters. */
+typedef struct VBoxShClParmDataWriteChunk
+{
+    /** uint64_t, in:   Context ID from VBOX_SHCL_HOST_MSG_READ_DATA_CID. */
+    HGCMFunctionParameter id64Context;
+    /** uint32_t, in:   The data format (VBOX_SHCL_FMT_XXX). */
+    HGCMFunctionParameter f32Format;
+    /** uint64_t, in:   Offset of this chunk within the data. */
+    HGCMFunctionParameter off64;
+    /** uint32_t, in:   VBOX_SHCL_DATA_CHUNK_F_XXX. */
+    HGCMFunctionParameter f32Flags;
+    /** ptr, in:        The chunk data. */
+    HGCMFunctionParameter pData;
+} VBoxShClParmDataWriteChunk;
+
+#define VBOX_SHCL_CPARMS_DATA_WRITE_CHUNK   5   /**< The parameter count for VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK. */
+/** @} */
+
 /**
  * Reports a transfer status.
  */
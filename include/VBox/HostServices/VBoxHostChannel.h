@@ -61,6 +61,7 @@
 #define VBOX_HOST_CHANNEL_FN_EVENT_WAIT   6 /* Blocking wait for a host event. */
 #define VBOX_HOST_CHANNEL_FN_EVENT_CANCEL 7 /* Cancel the blocking wait. */
 #define VBOX_HOST_CHANNEL_FN_QUERY        8 /* Generic data exchange using a channel name. */
+#define VBOX_HOST_CHANNEL_FN_SEND_BATCH   9 /* Send several records to the host in one call. */
 
 /*
  * The host event ids for the guest.
@@ -78,12 +79,26 @@
 
 #pragma pack(1)
 
-/* Parameter of VBOX_HOST_CHANNEL_EVENT_RECV */
+/* Parameter of VBOX_HOST_CHANNEL_EVENT_RECV.
+ * Queued RECV events of a channel are coalesced, only the latest size is reported. */
 typedef struct VBOXHOSTCHANNELEVENTRECV
 {
     uint32_t u32SizeAvailable; /* How many bytes can be read from the channel. */
 } VBOXHOSTCHANNELEVENTRECV;
 
+/* Record header in the VBOX_HOST_CHANNEL_FN_SEND_BATCH buffer. The data follows
+ * the header and is padded to VBOX_HOST_CHANNEL_RECORD_ALIGN. Each record is
+ * passed to the channel provider as a separate send. */
+typedef struct VBOXHOSTCHANNELRECORD
+{
+    uint32_t cbData;           /* Size of the record data, excluding header and padding. */
+} VBOXHOSTCHANNELRECORD;
+
+#define VBOX_HOST_CHANNEL_RECORD_ALIGN 4
+/* Size of a record with cbData bytes of data, including header and padding. */
+#define VBOX_HOST_CHANNEL_RECORD_SIZE(cbData) \
+    RT_ALIGN_32((uint32_t)sizeof(VBOXHOSTCHANNELRECORD) + (cbData), VBOX_HOST_CHANNEL_RECORD_ALIGN)
+
 /*
  * Guest calls.
  */
@@ -109,6 +124,14 @@ typedef struct VBoxHostChannelSend
     HGCMFunctionParameter data;   /* IN linear pointer: Data to be sent. */
 } VBoxHostChannelSend;
 
+typedef struct VBoxHostChannelSendBatch
+{
+    VBGLIOCHGCMCALL hdr;
+    HGCMFunctionParameter handle;   /* IN uint32_t: The channel handle. */
+    HGCMFunctionParameter data;     /* IN linear pointer: VBOXHOSTCHANNELRECORD records. */
+    HGCMFunctionParameter cRecords; /* OUT uint32_t: Number of records delivered. */
+} VBoxHostChannelSendBatch;
+
 typedef struct VBoxHostChannelRecv
 {
     VBGLIOCHGCMCALL hdr;
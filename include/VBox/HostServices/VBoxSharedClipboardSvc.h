@@ -224,6 +224,34 @@ typedef struct _SHCLCLIENT
     uint32_t volatile           cMsgAllocated;
     /** Legacy cruft we have to keep to support old(er) Guest Additions. */
     SHCLCLIENTLEGACYSTATE       Legacy;
+    /** State of chunked data reads and writes (VBOX_SHCL_GF_0_DATA_CHUNKS).
+     *  Not part of the saved state; protected by the service lock. */
+    struct
+    {
+        /** Copy of the host clipboard data being read by the guest, NULL if none. */
+        void                   *pvRead;
+        /** Size (in bytes) of \a pvRead. */
+        uint32_t                cbRead;
+        /** Offset of the next chunk the guest is expected to read. */
+        uint32_t                offRead;
+        /** Format of \a pvRead. */
+        SHCLFORMAT              uReadFormat;
+        /** Value of \a idHostFormatsGen when \a pvRead was fetched. */
+        uint32_t                idReadGen;
+        /** Bumped whenever new host formats are reported to this client,
+         *  invalidating \a pvRead.  Updated atomically. */
+        uint32_t volatile       idHostFormatsGen;
+        /** Guest clipboard data collected so far, NULL if none. */
+        void                   *pvWrite;
+        /** Number of bytes collected in \a pvWrite. */
+        uint32_t                cbWrite;
+        /** Allocated size (in bytes) of \a pvWrite. */
+        uint32_t                cbWriteAlloc;
+        /** Format of \a pvWrite. */
+        SHCLFORMAT              uWriteFormat;
+        /** Context ID of the host request \a pvWrite answers. */
+        uint64_t                idWriteContext;
+    } Chunks;
     /** The client's own event source.
      *  Needed for events which are not bound to a specific transfer. */
     SHCLEVENTSOURCE             EventSrc;
@@ -778,6 +778,40 @@ typedef VBGLIOCWRITECOREDUMP VBoxGuestWriteCoreDump;
 /** @} */
 
 
+/** @name VBGL_IOCTL_SET_STATS_PAGE
+ * IOCTL to VBoxGuest to register or unregister the guest statistics page.
+ *
+ * The guest kernel module / device driver locks down the supplied user page
+ * and passes its physical address to the host (VMMDevReq_SetStatisticsPage),
+ * which then samples the VMMDevStatsPage content periodically.  Only one page
+ * can be registered at a time, it is automatically unregistered when the
+ * session owning it is closed.
+ *
+ * @{ */
+#define VBGL_IOCTL_SET_STATS_PAGE                   VBGL_IOCTL_CODE_SIZE(21, VBGL_IOCTL_SET_STATS_PAGE_SIZE)
+#define VBGL_IOCTL_SET_STATS_PAGE_SIZE              sizeof(VBGLIOCSETSTATSPAGE)
+#define VBGL_IOCTL_SET_STATS_PAGE_SIZE_IN           sizeof(VBGLIOCSETSTATSPAGE)
+#define VBGL_IOCTL_SET_STATS_PAGE_SIZE_OUT          sizeof(VBGLREQHDR)
+typedef struct VBGLIOCSETSTATSPAGE
+{
+    /** The header. */
+    VBGLREQHDR          Hdr;
+    union
+    {
+        struct
+        {
+            /** Page aligned address of the page (user space address), NIL_RTR3PTR
+             *  to unregister. */
+            RTR3PTR     pvPage;
+            /** Explicit alignment padding, MBZ. */
+            uint8_t     abPadding[ARCH_BITS == 64 ? 0 + 8 : 4 + 8];
+        } In;
+    } u;
+} VBGLIOCSETSTATSPAGE, RT_FAR *PVBGLIOCSETSTATSPAGE;
+AssertCompileSize(VBGLIOCSETSTATSPAGE, 24+16);
+/** @} */
+
+
 #ifdef VBOX_WITH_DPC_LATENCY_CHECKER
 /** @name VBGL_IOCTL_DPC_LATENCY_CHECKER
  * IOCTL to VBoxGuest to perform DPC latency tests, printing the result in
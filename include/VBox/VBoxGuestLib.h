@@ -828,7 +828,9 @@ VBGLR3DECL(int)     VbglR3VrdpGetChangeRequest(bool *pfActive, uint32_t *puExper
 VBGLR3DECL(int)     VbglR3StatQueryInterval(uint32_t *pu32Interval);
 # if defined(VBOX_INCLUDED_VMMDev_h) || defined(DOXYGEN_RUNNING)
 VBGLR3DECL(int)     VbglR3StatReport(VMMDevReportGuestStats *pReq);
+VBGLR3DECL(int)     VbglR3StatSetPage(VMMDevStatsPage *pPage);
 # endif
+VBGLR3DECL(int)     VbglR3StatClearPage(void);
 /** @}  */
 
 /** @name Memory ballooning
@@ -1406,6 +1408,8 @@ VBGLR3DECL(int)  VbglR3HostChannelAttach(uint32_t *pu32ChannelHandle, uint32_t u
 VBGLR3DECL(void) VbglR3HostChannelDetach(uint32_t u32ChannelHandle, uint32_t u32HGCMClientId);
 VBGLR3DECL(int)  VbglR3HostChannelSend(uint32_t u32ChannelHandle, uint32_t u32HGCMClientId,
                                        void *pvData, uint32_t cbData);
+VBGLR3DECL(int)  VbglR3HostChannelSendBatch(uint32_t u32ChannelHandle, uint32_t u32HGCMClientId,
+                                            void *pvRecords, uint32_t cbRecords, uint32_t *pcRecords);
 VBGLR3DECL(int)  VbglR3HostChannelRecv(uint32_t u32ChannelHandle, uint32_t u32HGCMClientId,
                                        void *pvData, uint32_t cbData,
                                        uint32_t *pu32SizeReceived, uint32_t *pu32SizeRemaining);
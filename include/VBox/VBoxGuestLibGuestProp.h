@@ -68,6 +68,8 @@ DECLVBGL(int)  VbglGuestPropWrite(PVBGLGSTPROPCLIENT pClient, const char *pszNam
 DECLVBGL(int)  VbglGuestPropWriteValue(PVBGLGSTPROPCLIENT pClient, const char *pszName, const char *pszValue);
 DECLVBGL(int)  VbglGuestPropWriteValueV(PVBGLGSTPROPCLIENT pClient, const char *pszName, const char *pszValueFormat, va_list va);
 DECLVBGL(int)  VbglGuestPropWriteValueF(PVBGLGSTPROPCLIENT pClient, const char *pszName, const char *pszValueFormat, ...);
+DECLVBGL(int)  VbglGuestPropWriteMulti(PVBGLGSTPROPCLIENT pClient, uint32_t cProps, const char * const *papszNames,
+                                       const char * const *papszValues, const char * const *papszFlags);
 DECLVBGL(int)  VbglGuestPropRead(PVBGLGSTPROPCLIENT pClient, const char *pszName, void *pvBuf, uint32_t cbBuf,
                                  char **ppszValue, uint64_t *pu64Timestamp, char **ppszFlags, uint32_t *pcbBufActual);
 DECLVBGL(int)  VbglGuestPropReadEx(PVBGLGSTPROPCLIENT pClient,
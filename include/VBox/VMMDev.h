@@ -222,6 +222,7 @@ typedef enum VMMDevRequestType
     VMMDevReq_VideoUpdateMonitorPositions= 222,
     VMMDevReq_GetMouseStatusEx           = 223,
     VMMDevReq_GetHostGraphicsCapability  = 224,
+    VMMDevReq_SetStatisticsPage          = 225,
     VMMDevReq_SizeHack                   = 0x7fffffff
 } VMMDevRequestType;
 
@@ -999,6 +1000,10 @@ AssertCompileSize(VBoxGuestStatistics, 19*4);
 #define VBOX_GUEST_STAT_MEM_KERNEL_NONPAGED RT_BIT(13)
 #define VBOX_GUEST_STAT_MEM_SYSTEM_CACHE    RT_BIT(14)
 #define VBOX_GUEST_STAT_PAGE_FILE_SIZE      RT_BIT(15)
+/** VMMDevStatsPage::cRunnable is valid (statistics page only). */
+#define VBOX_GUEST_STAT_RUN_QUEUE           RT_BIT(16)
+/** VMMDevStatsPage::uMemPressure is valid (statistics page only). */
+#define VBOX_GUEST_STAT_MEM_PRESSURE        RT_BIT(17)
 /** @} */
 
 /**
@@ -1078,6 +1083,109 @@ typedef struct
 AssertCompileSize(VMMDevGetStatisticsChangeRequest, 24+8);
 
 
+/** Maximum number of CPUs in the guest statistics page. */
+#define VMMDEV_STATS_PAGE_MAX_CPUS      128
+/** VMMDevStatsPage::u32Magic value (Sergei Vasilyevich Rachmaninoff). */
+#define VMMDEV_STATS_PAGE_MAGIC         UINT32_C(0x18730401)
+/** VMMDevStatsPage::u32Version value. */
+#define VMMDEV_STATS_PAGE_VERSION       UINT32_C(0x00010000)
+
+/**
+ * Per CPU part of the guest statistics page.
+ */
+typedef struct VMMDevStatsPageCpu
+{
+    /** Idle CPU load (0-100) for the last interval. */
+    uint32_t            u32CpuLoad_Idle;
+    /** Kernel CPU load (0-100) for the last interval. */
+    uint32_t            u32CpuLoad_Kernel;
+    /** User CPU load (0-100) for the last interval. */
+    uint32_t            u32CpuLoad_User;
+    /** Reserved, MBZ. */
+    uint32_t            u32Reserved;
+} VMMDevStatsPageCpu;
+AssertCompileSize(VMMDevStatsPageCpu, 16);
+
+/**
+ * Guest statistics page.
+ *
+ * Registered with VMMDevReq_SetStatisticsPage and updated in place by the
+ * guest, the host samples it once a second.  This replaces one
+ * VMMDevReq_ReportGuestStats request (and thus VM exit) per CPU and interval.
+ *
+ * The guest increments u32Seq before and after updating the page, so the host
+ * ignores the sample when u32Seq is odd or changed while it was reading.
+ * Memory sizes are in 4KB pages like in VBoxGuestStatistics.
+ */
+typedef struct VMMDevStatsPage
+{
+    /** VMMDEV_STATS_PAGE_MAGIC. */
+    uint32_t            u32Magic;
+    /** VMMDEV_STATS_PAGE_VERSION. */
+    uint32_t            u32Version;
+    /** Update sequence number, odd while the guest is updating the page. */
+    uint32_t volatile   u32Seq;
+    /** Number of valid aCpus entries. */
+    uint32_t            cCpus;
+    /** Valid statistics (VBOX_GUEST_STAT_XXX). */
+    uint32_t            u32StatCaps;
+    /** Page size of guest system. */
+    uint32_t            u32PageSize;
+    /** Memory load (0-100). */
+    uint32_t            u32MemoryLoad;
+    /** Total physical memory. */
+    uint32_t            u32PhysMemTotal;
+    /** Available physical memory. */
+    uint32_t            u32PhysMemAvail;
+    /** Ballooned physical memory. */
+    uint32_t            u32PhysMemBalloon;
+    /** Total committed memory. */
+    uint32_t            u32MemCommitTotal;
+    /** Memory used by the kernel. */
+    uint32_t            u32MemKernelTotal;
+    /** Paged memory used by the kernel. */
+    uint32_t            u32MemKernelPaged;
+    /** Nonpaged memory used by the kernel. */
+    uint32_t            u32MemKernelNonPaged;
+    /** Memory used for the system cache. */
+    uint32_t            u32MemSystemCache;
+    /** Pagefile size. */
+    uint32_t            u32PageFileSize;
+    /** Nr of threads. */
+    uint32_t            u32Threads;
+    /** Nr of processes. */
+    uint32_t            u32Processes;
+    /** Nr of handles. */
+    uint32_t            u32Handles;
+    /** Number of runnable threads (run queue length). */
+    uint32_t            cRunnable;
+    /** Memory pressure: share of the last interval tasks were stalled waiting
+     * for memory, in 1/100 percent (0-10000). */
+    uint32_t            uMemPressure;
+    /** Reserved, MBZ. */
+    uint32_t            au32Reserved[11];
+    /** Per CPU statistics, indexed by CPU ID. */
+    VMMDevStatsPageCpu  aCpus[VMMDEV_STATS_PAGE_MAX_CPUS];
+} VMMDevStatsPage;
+AssertCompileSize(VMMDevStatsPage, 128 + VMMDEV_STATS_PAGE_MAX_CPUS * 16);
+AssertCompile(sizeof(VMMDevStatsPage) <= _4K);
+
+/**
+ * Guest statistics page registration.
+ *
+ * Used by VMMDevReq_SetStatisticsPage.
+ */
+typedef struct
+{
+    /** Header. */
+    VMMDevRequestHeader header;
+    /** Guest physical address of the page, NIL_RTGCPHYS to unregister.
+     * Must be page aligned. */
+    RTGCPHYS64          GCPhysPage;
+} VMMDevReqStatisticsPage;
+AssertCompileSize(VMMDevReqStatisticsPage, 24+8);
+
+
 /** The size of a string field in the credentials request (including '\\0').
  * @see VMMDevCredentials  */
 #define VMMDEV_CREDENTIALS_SZ_SIZE          128
@@ -1954,6 +2062,8 @@ DECLINLINE(size_t) vmmdevGetRequestSize(VMMDevRequestType requestType)
             return sizeof(VMMDevVideoUpdateMonitorPositions);
         case VMMDevReq_GetHostGraphicsCapability:
             return sizeof(VMMDevGetHostGraphicsCapability);
+        case VMMDevReq_SetStatisticsPage:
+            return sizeof(VMMDevReqStatisticsPage);
         default:
             break;
     }
@@ -280,6 +280,9 @@
  * This is also used for dealing with locked alignment conflicts with the host
  * in general from IEM. */
 #define VINF_EM_EMULATE_SPLIT_LOCK           1162
+/** Reason for leaving RZ: Pending ring-3 APIC ICR write (INIT or SIPI sent
+ * by a virtualized ICR write, see PDMApicSetIcrLoVirtualized). */
+#define VINF_EM_PENDING_R3_APIC_ICR_WRITE    1163
 /** @} */
 
 
@@ -671,6 +674,9 @@
 #define VERR_PGM_PHYS_RAM_LOOKUP_IPE            (-1691)
 /** Too many ROM ranges. */
 #define VERR_PGM_TOO_MANY_ROM_RANGES            (-1692)
+/** Large pages are required by the configuration but could not be provided
+ * by the host. */
+#define VERR_PGM_LARGE_PAGES_UNAVAILABLE        (-1693)
 /** @} */
 
 
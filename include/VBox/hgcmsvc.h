@@ -94,9 +94,10 @@
  *          acMaxClients and acMaxCallsPerClient added (VBox 6.1.26).
  * 9.1->10.1 Because pfnDisconnectClient was added back (VBox 6.1.28).
  * 10.1->11.1 Because pVMM added to pfnSaveState & pfnLoadState (VBox 7.0).
+ * 11.1->11.2 Because cWorkerThreads, fWorkerFlags & pfnIsParallelCall were added.
  */
 #define VBOX_HGCM_SVC_VERSION_MAJOR (0x000b)
-#define VBOX_HGCM_SVC_VERSION_MINOR (0x0001)
+#define VBOX_HGCM_SVC_VERSION_MINOR (0x0002)
 #define VBOX_HGCM_SVC_VERSION ((VBOX_HGCM_SVC_VERSION_MAJOR << 16) + VBOX_HGCM_SVC_VERSION_MINOR)
 
 
@@ -638,6 +639,19 @@ typedef enum HGCMNOTIFYEVENT
 #define HGCM_CLIENT_CATEGORY_MAX    3   /**< Max number of categories. */
 /** @} */
 
+/** @name VBOX_HGCM_SVC_WORKER_F_XXX - Worker thread flags (VBOXHGCMSVCFNTABLE::fWorkerFlags)
+ * @{ */
+/** Calls from the same client are always dispatched to the same worker thread
+ *  and are thus processed in the order they arrived.  Without this flag a call
+ *  goes to the least busy worker and calls may be processed in any order. */
+#define VBOX_HGCM_SVC_WORKER_F_PER_CLIENT_ORDER     RT_BIT_32(0)
+/** Valid flag mask. */
+#define VBOX_HGCM_SVC_WORKER_F_VALID_MASK           UINT32_C(0x00000001)
+/** @} */
+
+/** The max number of worker threads a service can ask for. */
+#define VBOX_HGCM_SVC_MAX_WORKER_THREADS            16
+
 
 /** The Service DLL entry points.
  *
@@ -720,6 +734,23 @@ typedef struct VBOXHGCMSVCFNTABLE
     /** Notification (VM state). */
     DECLR3CALLBACKMEMBER(void, pfnNotify, (void *pvService, HGCMNOTIFYEVENT enmEvent));
 
+    /** Number of worker threads guest calls can be dispatched to, in addition
+     * to the service thread.  Zero (the default) processes everything on the
+     * service thread.  Requires pfnIsParallelCall.
+     * Max VBOX_HGCM_SVC_MAX_WORKER_THREADS. */
+    uint32_t                cWorkerThreads;
+    /** VBOX_HGCM_SVC_WORKER_F_XXX. */
+    uint32_t                fWorkerFlags;
+
+    /** Checks whether a guest call may be processed on a worker thread (optional).
+     *
+     * Called on the thread submitting the call, so it should only look at the
+     * function number.  Calls for which this returns false, host calls and all
+     * other requests are processed on the service thread as before, which
+     * never runs concurrently with pfnCall on a worker thread.  Calls on the
+     * worker threads may run concurrently with each other. */
+    DECLR3CALLBACKMEMBER(bool, pfnIsParallelCall, (void *pvService, uint32_t function));
+
     /** User/instance data pointer for the service. */
     void *pvService;
 
@@ -164,8 +164,12 @@ typedef struct INTNETBUF
     STAMCOUNTER     cStatLost;
     /** Number of bad frames (both rings). */
     STAMCOUNTER     cStatBadFrames;
-    /** Reserved for future use. */
-    STAMCOUNTER     aStatReserved[2];
+    /** Number of unicast frames from this interface that were switched using
+     * the hashed MAC address lookup. */
+    STAMCOUNTER     cStatSwitchHashed;
+    /** Number of unicast frames from this interface that required a full scan
+     * of the MAC address table (promiscuous or unknown-address interfaces). */
+    STAMCOUNTER     cStatSwitchScanned;
     /** Reserved for future send profiling. */
     STAMPROFILE     StatSend1;
     /** Reserved for future send profiling. */
@@ -136,6 +136,8 @@ typedef enum SCSICMD
     SCSI_WRITE_6                        = 0x0a,
     SCSI_LOG_SENSE                      = 0x4d,
     SCSI_UNMAP                          = 0x42,
+    SCSI_WRITE_SAME_10                  = 0x41,
+    SCSI_WRITE_SAME_16                  = 0x93,
     SCSI_RESERVE_6                      = 0x16,
     SCSI_RELEASE_6                      = 0x17,
     SCSI_RESERVE_10                     = 0x56,
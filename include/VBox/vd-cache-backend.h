@@ -147,7 +147,13 @@ typedef struct VDCACHEBACKEND
     /**
      * Start a write request.
      *
+     * For caches implementing pfnQueryDirty() the data is newer than the image
+     * and stays dirty until it was written back and pfnMarkClean() was called.
+     *
      * @returns VBox status code.
+     * @retval  VERR_VD_BLOCK_FREE if there is no room in the cache, the data
+     *          must be written to the image instead. Nothing was consumed from
+     *          the I/O context in this case.
      * @param   pBackendData    Opaque state data for this image.
      * @param   uOffset         The offset of the virtual disk to write to.
      * @param   cbToWrite       How many bytes to write.
@@ -155,9 +161,7 @@ typedef struct VDCACHEBACKEND
      * @param   pcbWriteProcess Pointer to returned number of bytes that could
      *                          be processed. In case the function returned
      *                          VERR_VD_BLOCK_FREE this is the number of bytes
-     *                          that could be written in a full block write,
-     *                          when prefixed/postfixed by the appropriate
-     *                          amount of (previously read) padding data.
+     *                          which could not be written to the cache.
      */
     DECLR3CALLBACKMEMBER(int, pfnWrite, (void *pBackendData, uint64_t uOffset, size_t cbToWrite,
                                          PVDIOCTX pIoCtx, size_t *pcbWriteProcess));
@@ -317,6 +321,82 @@ typedef struct VDCACHEBACKEND
      *  VD_CAP_FILE and NULL otherwise. */
     DECLR3CALLBACKMEMBER(int, pfnComposeName, (PVDINTERFACE pConfig, char **pszName));
 
+    /**
+     * Puts data which was read from or written to the image into the cache.
+     * Optional, NULL if the cache only handles read misses through pfnWrite.
+     *
+     * @returns VBox status code.
+     * @param   pBackendData    Opaque state data for this image.
+     * @param   uOffset         The offset of the virtual disk the data belongs to.
+     * @param   pvBuf           The data.
+     * @param   cbFill          Number of bytes in the buffer.
+     * @param   fFill           Combination of VD_CACHE_FILL_F_* flags.
+     * @param   uToken          The token returned by pfnQueryFillToken() before the
+     *                          data was read from the image, ignored for
+     *                          VD_CACHE_FILL_F_OVERWRITE.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnFill, (void *pBackendData, uint64_t uOffset, const void *pvBuf,
+                                        size_t cbFill, uint32_t fFill, uint64_t uToken));
+
+    /**
+     * Returns a token for a subsequent pfnFill() call. Data read from the image
+     * after acquiring the token is dropped by pfnFill() if the range was
+     * written in the meantime without updating the cache.
+     *
+     * @returns Fill token.
+     * @param   pBackendData    Opaque state data for this image.
+     */
+    DECLR3CALLBACKMEMBER(uint64_t, pfnQueryFillToken, (void *pBackendData));
+
+    /**
+     * Returns the next range of dirty data, i.e. data which was written with
+     * pfnWrite() but not yet written back to the image.
+     *
+     * @returns VBox status code.
+     * @retval  VERR_NOT_FOUND if there is no dirty data after the cursor.
+     * @param   pBackendData    Opaque state data for this image.
+     * @param   puCursor        Opaque cursor, 0 to start at the beginning.
+     *                          Updated to continue after the returned range.
+     * @param   puOffset        Where to store the offset of the virtual disk
+     *                          the dirty data belongs to.
+     * @param   pvBuf           Where to store the dirty data.
+     * @param   cbBuf           Size of the buffer, at least 64KiB.
+     * @param   pcbDirty        Where to store the number of bytes returned.
+     * @param   puGen           Where to store the generation to pass to pfnMarkClean().
+     */
+    DECLR3CALLBACKMEMBER(int, pfnQueryDirty, (void *pBackendData, uint64_t *puCursor, uint64_t *puOffset,
+                                              void *pvBuf, size_t cbBuf, size_t *pcbDirty, uint32_t *puGen));
+
+    /**
+     * Marks a range returned by pfnQueryDirty() as written back to the image.
+     * The range stays dirty if it was written again after pfnQueryDirty().
+     *
+     * @returns VBox status code.
+     * @param   pBackendData    Opaque state data for this image.
+     * @param   uOffset         The offset of the virtual disk.
+     * @param   cbClean         Number of bytes to mark clean.
+     * @param   uGen            The generation returned by pfnQueryDirty().
+     */
+    DECLR3CALLBACKMEMBER(int, pfnMarkClean, (void *pBackendData, uint64_t uOffset, size_t cbClean, uint32_t uGen));
+
+    /**
+     * Returns the amount of dirty data in the cache.
+     *
+     * @returns Number of dirty bytes.
+     * @param   pBackendData    Opaque state data for this image.
+     */
+    DECLR3CALLBACKMEMBER(uint64_t, pfnGetDirtySize, (void *pBackendData));
+
+    /**
+     * Drops the given range from the cache, including dirty data.
+     *
+     * @returns VBox status code.
+     * @param   pBackendData    Opaque state data for this image.
+     * @param   uOffset         The offset of the virtual disk.
+     * @param   cbInvalidate    Number of bytes to drop.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnInvalidate, (void *pBackendData, uint64_t uOffset, size_t cbInvalidate));
+
     /** Initialization safty marker. */
     uint32_t            u32VersionEnd;
 
@@ -327,6 +407,17 @@ typedef VDCACHEBACKEND *PVDCACHEBACKEND;
 typedef const VDCACHEBACKEND *PCVDCACHEBACKEND;
 
 /** The current version of the VDCACHEBACKEND structure. */
-#define VD_CACHEBACKEND_VERSION                 VD_VERSION_MAKE(0xff03, 1, 0)
+#define VD_CACHEBACKEND_VERSION                 VD_VERSION_MAKE(0xff03, 2, 0)
+
+/** @name VD_CACHE_FILL_F_XXX - Flags for VDCACHEBACKEND::pfnFill
+ * @{ */
+/** Data read from the image, only ranges not in the cache are filled. */
+#define VD_CACHE_FILL_F_DEFAULT                 UINT32_C(0)
+/** Data written to the image, ranges already in the cache are updated and
+ * nothing new is allocated. */
+#define VD_CACHE_FILL_F_OVERWRITE               RT_BIT_32(0)
+/** Mask of valid flags. */
+#define VD_CACHE_FILL_F_VALID_MASK              UINT32_C(0x00000001)
+/** @} */
 
 #endif /* !VBOX_INCLUDED_vd_cache_backend_h */
@@ -189,6 +189,23 @@ typedef enum VDISKPARTTYPE
     VDISKPARTTYPE_GPT
 } VDISKPARTTYPE;
 
+/**
+ * How an attached cache image is used for writes.
+ */
+typedef enum VDCACHEMODE
+{
+    /** Invalid mode. */
+    VDCACHEMODE_INVALID = 0,
+    /** Writes go to the image and update the data already cached, the cache
+     * only gets filled by reads (default). */
+    VDCACHEMODE_WRITE_THROUGH,
+    /** Writes go to the cache and are written back to the image in the
+     * background, the image is incomplete while the cache holds dirty data. */
+    VDCACHEMODE_WRITE_BACK,
+    /** 32bit hack. */
+    VDCACHEMODE_32BIT_HACK = 0x7fffffff
+} VDCACHEMODE;
+
 /**
  * Auxiliary data structure for creating raw disks.
  */
@@ -465,6 +482,38 @@ typedef struct VDFILTERINFO
     PCVDCONFIGINFO paConfigInfo;
 } VDFILTERINFO, *PVDFILTERINFO;
 
+/**
+ * Read-ahead statistics, see VDSetReadAhead().
+ */
+typedef struct VDREADAHEADSTATS
+{
+    /** Number of prefetch reads issued. */
+    uint64_t    cPrefetches;
+    /** Number of bytes prefetched. */
+    uint64_t    cbPrefetched;
+    /** Number of reads completely served from prefetched data. */
+    uint64_t    cHits;
+    /** Number of sequential reads which couldn't be served (completely) from prefetched data. */
+    uint64_t    cMisses;
+    /** Number of bytes served from prefetched data. */
+    uint64_t    cbHit;
+    /** Number of prefetched bytes dropped without being read. */
+    uint64_t    cbWasted;
+} VDREADAHEADSTATS;
+/** Pointer to read-ahead statistics. */
+typedef VDREADAHEADSTATS *PVDREADAHEADSTATS;
+
+/**
+ * Completion callback for the background stream operation, see VDStreamStart().
+ *
+ * @param   pvUser      Opaque user data passed to VDStreamStart().
+ * @param   rcReq       Status code of the operation, VERR_CANCELLED if it was
+ *                      stopped before it completed.
+ */
+typedef DECLCALLBACKTYPE(void, FNVDSTREAMCOMPLETE,(void *pvUser, int rcReq));
+/** Pointer to a FNVDSTREAMCOMPLETE(). */
+typedef FNVDSTREAMCOMPLETE *PFNVDSTREAMCOMPLETE;
+
 
 /**
  * Request completion callback for the async read/write API.
@@ -646,6 +695,21 @@ VBOXDDU_DECL(int) VDCacheOpen(PVDISK pDisk, const char *pszBackend,
                               const char *pszFilename, unsigned uOpenFlags,
                               PVDINTERFACE pVDIfsCache);
 
+/**
+ * Sets how the cache image attached to the HDD container is used for writes.
+ *
+ * Switching from write-back to write-through writes back all dirty data
+ * first.
+ *
+ * @return  VBox status code.
+ * @return  VERR_VD_NOT_OPENED if no cache is opened in HDD container.
+ * @return  VERR_NOT_SUPPORTED if the cache backend doesn't support the mode.
+ * @return  VERR_VD_IMAGE_READ_ONLY if write-back is requested for a read-only cache.
+ * @param   pDisk           Pointer to the HDD container.
+ * @param   enmMode         The cache mode.
+ */
+VBOXDDU_DECL(int) VDCacheSetMode(PVDISK pDisk, VDCACHEMODE enmMode);
+
 /**
  * Adds a filter to the disk.
  *
@@ -745,6 +809,19 @@ VBOXDDU_DECL(int) VDCreateCache(PVDISK pDisk, const char *pszBackend,
 VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
                           unsigned nImageTo, PVDINTERFACE pVDIfsOperation);
 
+/**
+ * Limits the rate at which VDMerge() copies data.
+ *
+ * Meant for merges of a disk in use, the merge copies smaller chunks then and
+ * sleeps between them so that the disk lock is released regularly and guest
+ * I/O isn't stalled for long periods.
+ *
+ * @return  VBox status code.
+ * @param   pDisk           Pointer to HDD container.
+ * @param   cbPerSecMax     Maximum number of bytes copied per second, 0 for no limit.
+ */
+VBOXDDU_DECL(int) VDSetMergeRate(PVDISK pDisk, uint64_t cbPerSecMax);
+
 /**
  * Copies an image from one HDD container to another - extended version.
  *
@@ -796,6 +873,9 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
  * @param   uOpenFlags      Image file open mode, see VD_OPEN_FLAGS_* constants.
  *                          Only used if the destination image is created.
  * @param   pVDIfsOperation Pointer to the per-operation VD interface list.
+ *                          An optional config interface may provide the
+ *                          "CopyPipelineDepth" key (number of chunks read ahead
+ *                          of the destination writes, 1 copies serially).
  * @param   pDstVDIfsImage  Pointer to the per-image VD interface list, for the
  *                          destination image.
  * @param   pDstVDIfsOperation  Pointer to the per-operation VD interface list,
@@ -1006,6 +1086,22 @@ VBOXDDU_DECL(int) VDRead(PVDISK pDisk, uint64_t uOffset, void *pvBuf, size_t cbR
  */
 VBOXDDU_DECL(int) VDWrite(PVDISK pDisk, uint64_t uOffset, const void *pvBuf, size_t cbWrite);
 
+/**
+ * Writes zeroes to the given range of the virtual HDD.
+ *
+ * Unallocated blocks stay unallocated if the backend detects all zero writes.
+ *
+ * @return  VBox status code.
+ * @retval  VERR_VD_NOT_OPENED if no image is opened in HDD container.
+ * @retval  VERR_NOT_SUPPORTED if a write filter is active on the disk.
+ * @param   pDisk           Pointer to HDD container.
+ * @param   uOffset         Offset of first byte to zero from start of disk.
+ *                          Must be aligned to a sector boundary.
+ * @param   cbWrite         Number of bytes to zero.
+ *                          Must be aligned to a sector boundary.
+ */
+VBOXDDU_DECL(int) VDWriteZeroes(PVDISK pDisk, uint64_t uOffset, size_t cbWrite);
+
 /**
  * Make sure the on disk representation of a virtual HDD is up to date.
  *
@@ -1187,6 +1283,89 @@ VBOXDDU_DECL(int) VDGetOpenFlags(PVDISK pDisk, unsigned nImage, unsigned *puOpen
  */
 VBOXDDU_DECL(int) VDSetOpenFlags(PVDISK pDisk, unsigned nImage, unsigned uOpenFlags);
 
+/**
+ * Sets the size of the host-wide shared read cache for images opened read-only
+ * afterwards.
+ *
+ * Every image file opened read-only gets a shared memory cache of the given
+ * size which is shared by all processes on the host opening the same file,
+ * identified by its UUID, modification UUID and location. The cache is
+ * disabled for an image as soon as it is written to or reopened read-write.
+ *
+ * @return  VBox status code.
+ * @param   pDisk           Pointer to HDD container.
+ * @param   cbCache         Size of the cache per image file in bytes, 0 disables it.
+ */
+VBOXDDU_DECL(int) VDSetSharedReadCache(PVDISK pDisk, uint64_t cbCache);
+
+/**
+ * Configures the adaptive read-ahead for sequential read streams.
+ *
+ * Sequential streams of asynchronous reads (VDAsyncRead()) are detected and
+ * the data following the stream is prefetched asynchronously into a small
+ * dedicated buffer. The prefetch window starts small, grows while the
+ * prefetched data is consumed and shrinks again if it gets dropped unused.
+ *
+ * @return  VBox status code.
+ * @return  VERR_NOT_SUPPORTED if the disk uses the thread synchronization interface.
+ * @param   pDisk           Pointer to HDD container.
+ * @param   cbWindowMax     Maximum size of the prefetch window in bytes, 0 disables read-ahead.
+ * @param   pStats          Where to account the read-ahead statistics, optional.
+ *                          Must stay valid until read-ahead is disabled or the
+ *                          container is destroyed.
+ */
+VBOXDDU_DECL(int) VDSetReadAhead(PVDISK pDisk, size_t cbWindowMax, PVDREADAHEADSTATS pStats);
+
+/**
+ * Starts flattening the image chain in the background while the disk is in use.
+ *
+ * All data of the parent images which is not allocated in the last image is
+ * copied into the last image by a background thread, racing guest writes are
+ * detected through the I/O context framework and the affected ranges are
+ * retried.  When everything is copied the parent reference of the last image is
+ * cleared and the parent images are removed from the chain.  They are closed
+ * when the container is closed, as I/O started before might still use them.
+ *
+ * The operation is stopped (with VERR_CANCELLED) whenever the image chain is
+ * changed.
+ *
+ * @return  VBox status code.
+ * @return  VERR_VD_INVALID_STATE if there is no parent image.
+ * @return  VERR_VD_IMAGE_READ_ONLY if the last image is opened read-only.
+ * @return  VERR_RESOURCE_BUSY if a stream operation is already running.
+ * @param   pDisk           Pointer to HDD container.
+ * @param   cbPerSecMax     Maximum number of bytes copied per second, 0 for no limit.
+ * @param   pfnComplete     Called from the background thread when the operation
+ *                          completed, optional.
+ * @param   pvUser          Opaque user data passed to the completion callback.
+ */
+VBOXDDU_DECL(int) VDStreamStart(PVDISK pDisk, uint64_t cbPerSecMax,
+                                PFNVDSTREAMCOMPLETE pfnComplete, void *pvUser);
+
+/**
+ * Stops a running background stream operation, see VDStreamStart().
+ *
+ * The parent images stay in the chain, the data copied so far stays in the last
+ * image.
+ *
+ * @return  VBox status code.
+ * @param   pDisk           Pointer to HDD container.
+ */
+VBOXDDU_DECL(int) VDStreamCancel(PVDISK pDisk);
+
+/**
+ * Queries the progress of the background stream operation, see VDStreamStart().
+ *
+ * @return  VBox status code.
+ * @return  VERR_NOT_FOUND if no stream operation was started.
+ * @param   pDisk           Pointer to HDD container.
+ * @param   pcbDone         Where to store the number of bytes processed so far.
+ * @param   pcbTotal        Where to store the size of the disk.
+ * @param   pfRunning       Where to store whether the operation is still running, optional.
+ */
+VBOXDDU_DECL(int) VDStreamQueryProgress(PVDISK pDisk, uint64_t *pcbDone, uint64_t *pcbTotal,
+                                        bool *pfRunning);
+
 /**
  * Get base filename of image in HDD container. Some image formats use
  * other filenames as well, so don't use this for anything but informational
@@ -1349,6 +1528,22 @@ VBOXDDU_DECL(int) VDAsyncWrite(PVDISK pDisk, uint64_t off, size_t cbWrite,
                                PFNVDASYNCTRANSFERCOMPLETE pfnComplete,
                                void *pvUser1, void *pvUser2);
 
+/**
+ * Start an asynchronous write zeroes request.
+ *
+ * @return  VBox status code.
+ * @retval  VERR_NOT_SUPPORTED if a write filter is active on the disk.
+ * @param   pDisk           Pointer to the HDD container.
+ * @param   off             The offset of the virtual disk to zero.
+ * @param   cbWrite         How many bytes to zero.
+ * @param   pfnComplete     Completion callback.
+ * @param   pvUser1         User data which is passed on completion.
+ * @param   pvUser2         User data which is passed on completion.
+ */
+VBOXDDU_DECL(int) VDAsyncWriteZeroes(PVDISK pDisk, uint64_t off, size_t cbWrite,
+                                     PFNVDASYNCTRANSFERCOMPLETE pfnComplete,
+                                     void *pvUser1, void *pvUser2);
+
 
 /**
  * Start an asynchronous flush request.
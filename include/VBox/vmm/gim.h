@@ -191,6 +191,7 @@ VMMR3_INT_DECL(int)         GIMR3InitCompleted(PVM pVM);
 VMMR3_INT_DECL(void)        GIMR3Relocate(PVM pVM, RTGCINTPTR offDelta);
 VMMR3_INT_DECL(int)         GIMR3Term(PVM pVM);
 VMMR3_INT_DECL(void)        GIMR3Reset(PVM pVM);
+VMMR3_INT_DECL(void)        GIMR3UpdateStealTime(PVM pVM, PVMCPU pVCpu);
 VMMR3DECL(void)             GIMR3GimDeviceRegister(PVM pVM, PPDMDEVINS pDevInsR3, PGIMDEBUG pDbg);
 VMMR3DECL(int)              GIMR3GetDebugSetup(PVM pVM, PGIMDEBUGSETUP pDbgSetup);
 /** @} */
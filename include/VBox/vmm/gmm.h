@@ -360,8 +360,9 @@ typedef struct GMMSTATS
     uint64_t            cShareableModules;
     /** The current chunk freeing generation use by the per-VM TLB validation (GMM::idFreeGeneration). */
     uint64_t            idFreeGeneration;
-    /** Space reserved for later. */
-    uint64_t            au64Reserved[1];
+    /** The number of free pages zeroed ahead of allocation by the background
+     * zeroing thread (GMM::cPreZeroedPages). */
+    uint64_t            cPreZeroedPages;
 
     /** Statistics for the specified VM. (Zero filled if not requested.) */
     GMMVMSTATS          VMStats;
@@ -681,6 +682,37 @@ typedef GMMUNREGISTERSHAREDMODULEREQ *PGMMUNREGISTERSHAREDMODULEREQ;
 
 VMMR0_INT_DECL(int) GMMR0UnregisterSharedModuleReq(PGVM pGVM, VMCPUID idCpu, PGMMUNREGISTERSHAREDMODULEREQ pReq);
 
+/**
+ * Request buffer for GMMR0ScanDuplicatePagesReq / VMMR0_DO_GMM_SCAN_DUPLICATE_PAGES.
+ * @see GMMR0ScanDuplicatePagesReq.
+ */
+typedef struct GMMSCANDUPLICATEPAGESREQ
+{
+    /** The header. */
+    SUPVMMR0REQHDR              Hdr;
+    /** The RAM range ID to resume scanning at (in/out). */
+    uint32_t                    idRamRange;
+    /** The page index within the RAM range to resume scanning at (in/out). */
+    uint32_t                    iPage;
+    /** The max number of pages to look at (in). */
+    uint32_t                    cMaxPages;
+    /** The number of pages looked at (out). */
+    uint32_t                    cScanned;
+    /** The number of private pages replaced by an existing shared page (out). */
+    uint32_t                    cMerged;
+    /** The number of private pages converted into new shared ones (out). */
+    uint32_t                    cShared;
+    /** The number of merged and converted pages that were all zeros (out). */
+    uint32_t                    cZero;
+    /** Set if the scan wrapped around to the first RAM range (out). */
+    bool                        fWrapped;
+} GMMSCANDUPLICATEPAGESREQ;
+/** Pointer to a GMMR0ScanDuplicatePagesReq / VMMR0_DO_GMM_SCAN_DUPLICATE_PAGES request buffer. */
+typedef GMMSCANDUPLICATEPAGESREQ *PGMMSCANDUPLICATEPAGESREQ;
+
+VMMR0_INT_DECL(int) GMMR0ScanDuplicatePagesReq(PGVM pGVM, VMCPUID idCpu, PGMMSCANDUPLICATEPAGESREQ pReq);
+VMMR0_INT_DECL(int) GMMR0ScanCheckPage(PGVM pGVM, PGMMSHAREDPAGEDESC pPageDesc, bool *pfZero);
+
 #if defined(VBOX_STRICT)
 /**
  * Request buffer for GMMR0FindDuplicatePageReq / VMMR0_DO_GMM_FIND_DUPLICATE_PAGE.
@@ -770,6 +802,7 @@ VMMR3_INT_DECL(int)  GMMR3RegisterSharedModule(PVM pVM, PGMMREGISTERSHAREDMODULE
 VMMR3_INT_DECL(int)  GMMR3UnregisterSharedModule(PVM pVM, PGMMUNREGISTERSHAREDMODULEREQ pReq);
 VMMR3_INT_DECL(int)  GMMR3CheckSharedModules(PVM pVM);
 VMMR3_INT_DECL(int)  GMMR3ResetSharedModules(PVM pVM);
+VMMR3_INT_DECL(int)  GMMR3ScanDuplicatePages(PVM pVM, PGMMSCANDUPLICATEPAGESREQ pReq);
 
 # if defined(VBOX_STRICT)
 VMMR3_INT_DECL(bool) GMMR3IsDuplicatePage(PVM pVM, uint32_t idPage);
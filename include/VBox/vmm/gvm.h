@@ -121,7 +121,7 @@ typedef struct GVMCPU
 # if defined(VMM_INCLUDED_SRC_include_HMInternal_h) && defined(IN_RING0)
         struct HMR0PERVCPU  s;
 # endif
-        uint8_t             padding[1024];
+        uint8_t             padding[1088];
     } hmr0;
 
 # ifdef VBOX_WITH_NEM_R0
@@ -157,9 +157,9 @@ typedef struct GVMCPU
 #ifdef VBOX_WITH_MINIMAL_R0
     uint8_t                 abPadding3[16384 - 64*2 - 256 - 896];
 #elif defined(VBOX_WITH_NEM_R0)
-    uint8_t                 abPadding3[16384 - 64*2 - 256 - 896 - 1024 - 64 - 576 - 1856];
+    uint8_t                 abPadding3[16384 - 64*2 - 256 - 896 - 1088 - 64 - 576 - 1856];
 #else
-    uint8_t                 abPadding3[16384 - 64*2 - 256 - 896 - 1024      - 576 - 1856];
+    uint8_t                 abPadding3[16384 - 64*2 - 256 - 896 - 1088      - 576 - 1856];
 #endif
 } GVMCPU;
 #ifndef IN_TSTVMSTRUCT
@@ -133,6 +133,10 @@ typedef struct GVMMSTATSVMCPU
     uint32_t            cWakeUpTimerMisses;
     uint32_t            cWakeUpTimerCanceled;
     uint32_t            cWakeUpTimerSameCpu;
+    /** Number of halts that ended while polling (no blocking needed). */
+    uint32_t            cHaltPollHits;
+    /** Number of halts that polled and then had to block anyway. */
+    uint32_t            cHaltPollMisses;
     STAMPROFILE         Start;
     STAMPROFILE         Stop;
 } GVMMSTATSVMCPU;
@@ -202,7 +206,7 @@ VMMR0_INT_DECL(int)     GVMMR0SetConfig(PSUPDRVSESSION pSession, const char *psz
 VMMR0_INT_DECL(int)     GVMMR0QueryConfig(PSUPDRVSESSION pSession, const char *pszName, uint64_t *pu64Value);
 
 VMMR0_INT_DECL(int)     GVMMR0CreateVM(PSUPDRVSESSION pSession, VMTARGET enmTarget, uint32_t cCpus, PVMCC *ppVM);
-VMMR0_INT_DECL(int)     GVMMR0InitVM(PGVM pGVM);
+VMMR0_INT_DECL(int)     GVMMR0InitVM(PGVM pGVM, uint32_t cNsHaltPollMax);
 VMMR0_INT_DECL(void)    GVMMR0DoneInitVM(PGVM pGVM);
 VMMR0_INT_DECL(bool)    GVMMR0DoingTermVM(PGVM pGVM);
 VMMR0_INT_DECL(int)     GVMMR0DestroyVM(PGVM pGVM);
@@ -322,6 +322,7 @@ VMMR3_INT_DECL(int)             HMR3DisablePatching(PVM pVM, RTGCPTR pPatchMem,
 VMMR3_INT_DECL(int)             HMR3PatchTprInstr(PVM pVM, PVMCPU pVCpu);
 VMMR3_INT_DECL(bool)            HMR3IsRescheduleRequired(PVM pVM, PCCPUMCTX pCtx);
 VMMR3_INT_DECL(bool)            HMR3IsVmxPreemptionTimerUsed(PVM pVM);
+VMMR3_INT_DECL(void)            HMR3NoteExitCompletedInR3(PVMCPU pVCpu, uint64_t uTscStart);
 /** @} */
 #endif /* IN_RING3 */
 
@@ -380,6 +380,14 @@ DECLINLINE(const char *) VMXGetIdtVectoringInfoTypeDesc(uint8_t uType)
 DECLASM(int) VMXDispatchHostNmi(void);
 
 
+/**
+ * Dispatches an external interrupt acknowledged on VM-exit to the host.
+ *
+ * @param   uVector     The interrupt vector.
+ */
+DECLASM(void) VMXDispatchHostIntr(uint8_t uVector);
+
+
 /**
  * Executes VMXON.
  *
@@ -171,8 +171,16 @@ RT_C_DECLS_BEGIN
  * @sa IOMMMIO_OFF_F_READING_MISSING_BYTES  */
 #define IOMMMIO_FLAGS_SET_HI_OFF_BIT_READING_MISSING    UINT32_C(0x00002000)
 
+/** Writes may be buffered by the hypervisor and replayed in batches later
+ * (KVM coalesced MMIO), as long as they are replayed in order and before any
+ * read from the region is serviced.  Only for regions where a delayed write
+ * has no side effect the guest can observe without reading from the region,
+ * like framebuffers.
+ * @note Ignored unless executing under NEM on Linux. */
+#define IOMMMIO_FLAGS_COALESCE_WRITES                   UINT32_C(0x00004000)
+
 /** Mask of valid flags. */
-#define IOMMMIO_FLAGS_VALID_MASK                        UINT32_C(0x00003373)
+#define IOMMMIO_FLAGS_VALID_MASK                        UINT32_C(0x00007373)
 /** @} */
 
 /**
@@ -470,6 +478,33 @@ typedef DECLCALLBACKTYPE(VBOXSTRICTRC, FNIOMMMIONEWFILL,(PPDMDEVINS pDevIns, voi
 /** Pointer to a FNIOMMMIONEWFILL(). */
 typedef FNIOMMMIONEWFILL *PFNIOMMMIONEWFILL;
 
+/**
+ * MMIO doorbell notification callback.
+ *
+ * Called when the guest wrote to a doorbell registered by
+ * IOMR3MmioDoorbellRegister and the write was consumed by the hypervisor
+ * without a regular MMIO exit.  The regular write callback is @b not invoked
+ * for such writes.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pvUser      User argument.
+ * @remarks This is called on a NEM worker thread without the device critical
+ *          section.  Implementations should do no more than wake up
+ *          whatever processes the doorbell and must not wait for an EMT.
+ */
+typedef DECLCALLBACKTYPE(void, FNIOMMMIODOORBELL,(PPDMDEVINS pDevIns, void *pvUser));
+/** Pointer to a FNIOMMMIODOORBELL(). */
+typedef FNIOMMMIODOORBELL *PFNIOMMMIODOORBELL;
+
+/** @name IOMMMIO_DOORBELL_F_XXX - Flags for IOMR3MmioDoorbellRegister().
+ * @{ */
+/** Only writes of the given value trigger the doorbell, others are regular
+ *  MMIO writes. */
+#define IOMMMIO_DOORBELL_F_DATAMATCH    RT_BIT_32(1)
+/** Valid flags. */
+#define IOMMMIO_DOORBELL_F_VALID_MASK   UINT32_C(0x00000002)
+/** @} */
+
 VMMDECL(VBOXSTRICTRC)   IOMIOPortRead(PVMCC pVM, PVMCPU pVCpu, RTIOPORT Port, uint32_t *pu32Value, size_t cbValue);
 VMMDECL(VBOXSTRICTRC)   IOMIOPortWrite(PVMCC pVM, PVMCPU pVCpu, RTIOPORT Port, uint32_t u32Value, size_t cbValue);
 VMM_INT_DECL(VBOXSTRICTRC) IOMIOPortReadString(PVMCC pVM, PVMCPU pVCpu, RTIOPORT Port, void *pvDst,
@@ -518,6 +553,10 @@ VMMR3_INT_DECL(int)  IOMR3MmioUnmap(PVM pVM, PVMCPU pVCpu, PPDMDEVINS pDevIns, I
 VMMR3_INT_DECL(int)  IOMR3MmioReduce(PVM pVM, PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS cbRegion);
 VMMR3_INT_DECL(int)  IOMR3MmioValidateHandle(PVM pVM, PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion);
 VMMR3_INT_DECL(RTGCPHYS) IOMR3MmioGetMappingAddress(PVM pVM, PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion);
+VMMR3_INT_DECL(int)  IOMR3MmioDoorbellRegister(PVM pVM, PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off, uint32_t cb,
+                                               uint32_t fFlags, uint64_t uDataMatch, PFNIOMMMIODOORBELL pfnNotify, void *pvUser);
+VMMR3_INT_DECL(int)  IOMR3MmioDoorbellDeregister(PVM pVM, PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off);
+VMMR3_INT_DECL(void) IOMR3MmioDoorbellDestroyDevice(PVM pVM, PPDMDEVINS pDevIns);
 
 VMMR3_INT_DECL(VBOXSTRICTRC) IOMR3ProcessForceFlag(PVM pVM, PVMCPU pVCpu, VBOXSTRICTRC rcStrict);
 
@@ -77,6 +77,44 @@ VMMR3_INT_DECL(int)  NEMR3Halt(PVM pVM, PVMCPU pVCpu);
 VMMR3_INT_DECL(int) NEMR3WinGetPartitionHandle(PVM pVM, PRTHCUINTPTR pHCPtrHandle);
 #endif
 
+/**
+ * Doorbell notification callback.
+ *
+ * This is called on a NEM worker thread (not an EMT) after the guest wrote to a
+ * doorbell registered with NEMR3DoorbellRegister.  The write itself is not
+ * passed along, so this is only suitable for "kick" style registers where the
+ * value written carries no information (or has been matched by
+ * NEM_DOORBELL_F_DATAMATCH).
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pvUser      The user argument given at registration time.
+ */
+typedef DECLCALLBACKTYPE(void, FNNEMR3DOORBELL,(PVM pVM, void *pvUser));
+/** Pointer to a doorbell notification callback. */
+typedef FNNEMR3DOORBELL *PFNNEMR3DOORBELL;
+
+/** @name NEM_DOORBELL_F_XXX - Flags for NEMR3DoorbellRegister.
+ * @{ */
+/** The doorbell is an I/O port rather than an MMIO address. */
+#define NEM_DOORBELL_F_PIO          RT_BIT_32(0)
+/** Only writes of the given value trigger the doorbell. */
+#define NEM_DOORBELL_F_DATAMATCH    RT_BIT_32(1)
+/** Valid flag mask. */
+#define NEM_DOORBELL_F_VALID_MASK   UINT32_C(0x00000003)
+/** @} */
+
+/** NIL doorbell handle. */
+#define NEM_DOORBELL_HANDLE_NIL     UINT32_MAX
+
+VMMR3_INT_DECL(int)  NEMR3DoorbellRegister(PVM pVM, uint32_t fFlags, RTGCPHYS GCPhysOrPort, uint32_t cb, uint64_t uDataMatch,
+                                           PFNNEMR3DOORBELL pfnNotify, void *pvUser, uint32_t *phDoorbell);
+VMMR3_INT_DECL(int)  NEMR3DoorbellDeregister(PVM pVM, uint32_t hDoorbell);
+VMMR3_INT_DECL(int)  NEMR3MmioCoalesceRegister(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb);
+VMMR3_INT_DECL(int)  NEMR3MmioCoalesceDeregister(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb);
+VMMR3_INT_DECL(int)  NEMR3PhysRamDirtyTracking(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb, void *pvR3, uint32_t uNemRange, bool fEnable);
+VMMR3_INT_DECL(int)  NEMR3PhysRamQueryAndResetDirtyBitmap(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb, uint32_t uNemRange,
+                                                          void *pvBitmap, size_t cbBitmap);
+
 /**
  * Checks if dirty page tracking for MMIO2 ranges is supported.
  *
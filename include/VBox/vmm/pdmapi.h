@@ -392,6 +392,8 @@ typedef struct PDMQUEUECREATEREQ
     uint32_t                cbItem;
     /** Owner type (PDMQUEUETYPE). */
     uint32_t                enmType;
+    /** Queue flags (PDMQUEUE_F_XXX). */
+    uint32_t                fFlags;
     /** The ring-3 owner pointer. */
     RTR3PTR                 pvOwner;
     /** The ring-3 callback function address. */
@@ -359,9 +359,19 @@ typedef struct PDMAPICBACKENDR3
      */
     DECLR3CALLBACKMEMBER(VBOXSTRICTRC, pfnExportState, (PVMCPUCC pVCpu));
 
+    /**
+     * Sends the IPI for an ICR low dword write the CPU has already stored into
+     * the APIC page (APIC-write VM-exit with virtual-interrupt delivery).
+     *
+     * @returns Strict VBox status code.
+     * @param   pVCpu   The cross context virtual CPU structure.
+     * @param   rcRZ    The return code if the operation cannot be performed in
+     *                  the current context.
+     */
+    DECLR3CALLBACKMEMBER(VBOXSTRICTRC, pfnSetIcrLoVirtualized, (PVMCPUCC pVCpu, int rcRZ));
+
     /** @name Reserved for future (MBZ).
      * @{ */
-    DECLR3CALLBACKMEMBER(int, pfnReserved0, (void));
     DECLR3CALLBACKMEMBER(int, pfnReserved1, (void));
     DECLR3CALLBACKMEMBER(int, pfnReserved2, (void));
     DECLR3CALLBACKMEMBER(int, pfnReserved3, (void));
@@ -622,11 +632,38 @@ typedef struct PDMAPICBACKENDR0
      */
     DECLR0CALLBACKMEMBER(VBOXSTRICTRC, pfnExportState, (PVMCPUCC pVCpu));
 
+    /**
+     * Sends the IPI for an ICR low dword write the CPU has already stored into
+     * the APIC page (APIC-write VM-exit with virtual-interrupt delivery).
+     *
+     * @returns Strict VBox status code.
+     * @param   pVCpu   The cross context virtual CPU structure.
+     * @param   rcRZ    The return code if the operation cannot be performed in
+     *                  the current context.
+     */
+    DECLR0CALLBACKMEMBER(VBOXSTRICTRC, pfnSetIcrLoVirtualized, (PVMCPUCC pVCpu, int rcRZ));
+
+    /**
+     * Gets the posted-interrupt descriptor for the specified VCPU.
+     *
+     * @returns VBox status code.
+     * @param   pVCpu           The cross context virtual CPU structure.
+     * @param   pHCPhys         Where to store the host-context physical address.
+     */
+    DECLR0CALLBACKMEMBER(int, pfnGetPibForCpu, (PCVMCPUCC pVCpu, PRTHCPHYS pHCPhys));
+
+    /**
+     * Completes an EOI the CPU has virtualized for a vector in the EOI-exit
+     * bitmap (virtualized-EOI VM-exit).
+     *
+     * @returns Strict VBox status code.
+     * @param   pVCpu           The cross context virtual CPU structure.
+     * @param   uVector         The vector the CPU cleared from the ISR.
+     */
+    DECLR0CALLBACKMEMBER(VBOXSTRICTRC, pfnSetEoiVirtualized, (PVMCPUCC pVCpu, uint8_t uVector));
+
     /** @name Reserved for future (MBZ).
      * @{ */
-    DECLR0CALLBACKMEMBER(int, pfnReserved0, (void));
-    DECLR0CALLBACKMEMBER(int, pfnReserved1, (void));
-    DECLR0CALLBACKMEMBER(int, pfnReserved2, (void));
     DECLR0CALLBACKMEMBER(int, pfnReserved3, (void));
     DECLR0CALLBACKMEMBER(int, pfnReserved4, (void));
     DECLR0CALLBACKMEMBER(int, pfnReserved5, (void));
@@ -937,8 +974,11 @@ VMM_INT_DECL(int)           PDMApicSetBaseMsr(PVMCPUCC pVCpu, uint64_t u64BaseMs
 VMM_INT_DECL(int)           PDMApicGetInterrupt(PVMCPUCC pVCpu, uint8_t *pu8Vector, uint32_t *puSrcTag);
 VMM_INT_DECL(int)           PDMApicBusDeliver(PVMCC pVM, uint8_t uDest, uint8_t uDestMode, uint8_t uDeliveryMode, uint8_t uVector,
                                               uint8_t uPolarity, uint8_t uTriggerMode, uint32_t uTagSrc);
+VMM_INT_DECL(VBOXSTRICTRC)  PDMApicSetIcrLoVirtualized(PVMCPUCC pVCpu);
 #ifdef IN_RING0
 VMM_INT_DECL(int)           PDMR0ApicGetApicPageForCpu(PCVMCPUCC pVCpu, PRTHCPHYS pHCPhys, PRTR0PTR pR0Ptr, PRTR3PTR pR3Ptr);
+VMM_INT_DECL(int)           PDMR0ApicGetPibForCpu(PCVMCPUCC pVCpu, PRTHCPHYS pHCPhys);
+VMM_INT_DECL(VBOXSTRICTRC)  PDMR0ApicSetEoiVirtualized(PVMCPUCC pVCpu, uint8_t uVector);
 #endif
 
 /** @name Hyper-V interface (Ring-3 and all-context API).
@@ -50,6 +50,7 @@
 #include <VBox/vmm/pdmins.h>
 #include <VBox/vmm/pdmcommon.h>
 #include <VBox/vmm/pdmpcidev.h>
+#include <VBox/vmm/pdmphysmapcache.h>
 #include <VBox/vmm/iom.h>
 #include <VBox/vmm/mm.h>
 #include <VBox/vmm/tm.h>
@@ -2392,7 +2393,7 @@ typedef const PDMRTCHLP *PCPDMRTCHLP;
 /** @} */
 
 /** Current PDMDEVHLPR3 version number. */
-#define PDM_DEVHLPR3_VERSION                PDM_VERSION_MAKE_PP(0xffe7, 69, 0)
+#define PDM_DEVHLPR3_VERSION                PDM_VERSION_MAKE_PP(0xffe7, 71, 0)
 
 /**
  * PDM Device API.
@@ -4005,6 +4006,25 @@ typedef struct PDMDEVHLPR3
      */
     DECLR3CALLBACKMEMBER(void, pfnPCISetIrqNoWait,(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, int iIrq, int iLevel));
 
+    /**
+     * Sets several IRQs of the given PCI device in one go.
+     *
+     * This is meant for MSI-X capable devices signalling several vectors at the
+     * same time (e.g. when a number of queues complete at once), it saves taking
+     * the PDM lock and calling into the PCI bus for each vector separately.
+     *
+     * @param   pDevIns             The device instance.
+     * @param   pPciDev             The PCI device structure.  If NULL the default
+     *                              PCI device for this device instance is used.
+     * @param   pbmIrqs             Bitmap of the IRQ numbers (MSI-X vectors) to set.
+     * @param   cIrqs               The number of bits in the bitmap, must be a
+     *                              multiple of 32.
+     * @param   iLevel              IRQ level. See the PDM_IRQ_LEVEL_* \#defines.
+     * @thread  Any thread, but will involve the emulation thread.
+     */
+    DECLR3CALLBACKMEMBER(void, pfnPCISetIrqMulti,(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs, uint32_t cIrqs,
+                                                 int iLevel));
+
     /**
      * Set ISA IRQ for a device.
      *
@@ -4106,6 +4126,20 @@ typedef struct PDMDEVHLPR3
 
     DECLR3CALLBACKMEMBER(PPDMQUEUEITEMCORE, pfnQueueAlloc,(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue));
     DECLR3CALLBACKMEMBER(int, pfnQueueInsert,(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem));
+    /**
+     * Frees an item allocated by pfnQueueAlloc that will not be inserted.
+     *
+     * Must be used when giving up on an item after allocating it, with ring
+     * queues the consumer would otherwise stop at the item for good.
+     *
+     * @returns VBox status code.
+     * @param   pDevIns             The device instance.
+     * @param   hQueue              The queue handle.
+     * @param   pItem               The item to free.
+     * @thread  Any thread.
+     * @sa      PDMQueueFree
+     */
+    DECLR3CALLBACKMEMBER(int, pfnQueueFree,(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem));
     DECLR3CALLBACKMEMBER(bool, pfnQueueFlushIfNecessary,(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue));
     /** @} */
 
@@ -4647,15 +4681,123 @@ typedef struct PDMDEVHLPR3
      */
     DECLR3CALLBACKMEMBER(uint64_t, pfnCpuGetGuestScalableBusFrequency,(PPDMDEVINS pDevIns));
 
+    /**
+     * Registers a doorbell within a MMIO region.
+     *
+     * Guest writes to the doorbell may be signalled to @a pfnNotify on a worker
+     * thread instead of going thru the region write callback, if the execution
+     * engine supports it (KVM ioeventfd).  The device must handle both cases.
+     *
+     * @returns VBox status code.
+     * @retval  VERR_NOT_SUPPORTED if not supported by the execution engine.
+     * @param   pDevIns     The device instance owning the region.
+     * @param   hRegion     The MMIO region handle.
+     * @param   off         The offset of the doorbell into the region.
+     * @param   cb          The doorbell access size: 1, 2, 4 or 8.
+     * @param   fFlags      IOMMMIO_DOORBELL_F_XXX.
+     * @param   uDataMatch  The value to match if IOMMMIO_DOORBELL_F_DATAMATCH.
+     * @param   pfnNotify   The notification callback, see FNIOMMMIODOORBELL
+     *                      for restrictions.
+     * @param   pvUser      User argument for the callback.
+     * @thread  EMT(0)
+     * @sa      IOMR3MmioDoorbellRegister
+     */
+    DECLR3CALLBACKMEMBER(int, pfnMmioDoorbellRegister,(PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off, uint32_t cb,
+                                                       uint32_t fFlags, uint64_t uDataMatch, PFNIOMMMIODOORBELL pfnNotify,
+                                                       void *pvUser));
+
+    /**
+     * Deregisters a doorbell registered by pfnMmioDoorbellRegister.
+     *
+     * Doorbells are automatically deregistered before the device destructor is
+     * called.
+     *
+     * @returns VBox status code.
+     * @param   pDevIns     The device instance owning the region.
+     * @param   hRegion     The MMIO region handle.
+     * @param   off         The offset of the doorbell into the region.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnMmioDoorbellDeregister,(PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off));
+
+    /**
+     * Creates a guest physical mapping cache.
+     *
+     * The cache keeps ring-3 mappings (and page mapping locks) of recently
+     * accessed guest pages, see @ref grp_pdm_physmapcache.  It is not
+     * serialized, so each thread or lock domain needs its own cache.  Caches
+     * are automatically destroyed before the device destructor is called.
+     *
+     * @returns VBox status code.
+     * @param   pDevIns     The device instance.
+     * @param   pPciDev     The PCI device the accesses are made on behalf of.
+     *                      NULL for the default one.
+     * @param   cEntries    Number of entries, rounded up to a power of two.  Zero
+     *                      for the default (PDMPHYSMAPCACHE_ENTRIES_DEF).
+     * @param   pszName     Cache name for the statistics, unique per device
+     *                      instance.
+     * @param   ppCache     Where to return the cache handle.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnPhysMapCacheCreate,(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t cEntries,
+                                                     const char *pszName, PPDMPHYSMAPCACHE *ppCache));
+
+    /**
+     * Destroys a guest physical mapping cache.
+     *
+     * @returns VBox status code.
+     * @param   pDevIns     The device instance.
+     * @param   pCache      The cache.  NULL is ignored.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnPhysMapCacheDestroy,(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache));
+
+    /**
+     * Releases all the page mappings held by a guest physical mapping cache.
+     *
+     * Should be called when the device is reset or stops bus mastering.
+     *
+     * @param   pDevIns     The device instance.
+     * @param   pCache      The cache.
+     */
+    DECLR3CALLBACKMEMBER(void, pfnPhysMapCacheFlush,(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache));
+
+    /**
+     * Maps a guest page into the cache (slow path of PDMDevHlpPhysMapCacheMap).
+     *
+     * @returns VBox status code.
+     * @retval  VERR_NOT_SUPPORTED if the accesses must be translated by an
+     *          IOMMU.  Use the PCI physical access helpers instead.
+     * @param   pDevIns     The device instance.
+     * @param   pCache      The cache.
+     * @param   GCPhys      The guest physical address.
+     * @param   fWrite      Whether write access is required.
+     * @param   ppv         Where to return the pointer corresponding to @a GCPhys.
+     *                      Valid up to the end of the guest page until the next
+     *                      call using the cache.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnPhysMapCacheMap,(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache, RTGCPHYS GCPhys,
+                                                  bool fWrite, void **ppv));
+
+    /**
+     * Gets the guest RAM ranges together with their ring-3 mappings.
+     *
+     * Intended for handing guest memory to host kernel facilities doing DMA
+     * on behalf of the device (e.g. the Linux vhost memory table).  This is
+     * only possible if guest RAM is backed by contiguous ring-3 allocations,
+     * i.e. in NEM mode, and the mappings stay valid for the lifetime of the VM.
+     *
+     * @returns VBox status code.
+     * @retval  VERR_NOT_SUPPORTED if the guest RAM has no such mappings.
+     * @retval  VERR_BUFFER_OVERFLOW if there are more than @a cMaxMappings
+     *          ranges, @a pcMappings is set to the number required.
+     * @param   pDevIns         The device instance.
+     * @param   paMappings      Where to return the ranges, in ascending order.
+     * @param   cMaxMappings    The number of entries in @a paMappings.
+     * @param   pcMappings      Where to return the number of ranges.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnPhysQueryRamMappings,(PPDMDEVINS pDevIns, PPGMPHYSRAMMAPPING paMappings, uint32_t cMaxMappings,
+                                                       uint32_t *pcMappings));
+
     /** Space reserved for future members.
      * @{ */
-    DECLR3CALLBACKMEMBER(void, pfnReserved1,(void));
-    DECLR3CALLBACKMEMBER(void, pfnReserved2,(void));
-    DECLR3CALLBACKMEMBER(void, pfnReserved3,(void));
-    DECLR3CALLBACKMEMBER(void, pfnReserved4,(void));
-    DECLR3CALLBACKMEMBER(void, pfnReserved5,(void));
-    DECLR3CALLBACKMEMBER(void, pfnReserved6,(void));
-    DECLR3CALLBACKMEMBER(void, pfnReserved7,(void));
     DECLR3CALLBACKMEMBER(void, pfnReserved8,(void));
     DECLR3CALLBACKMEMBER(void, pfnReserved9,(void));
     DECLR3CALLBACKMEMBER(void, pfnReserved10,(void));
@@ -5234,6 +5376,25 @@ typedef struct PDMDEVHLPRC
      */
     DECLRCCALLBACKMEMBER(void, pfnPCISetIrq,(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, int iIrq, int iLevel));
 
+    /**
+     * Sets several IRQs of the given PCI device in one go.
+     *
+     * This is meant for MSI-X capable devices signalling several vectors at the
+     * same time (e.g. when a number of queues complete at once), it saves taking
+     * the PDM lock and calling into the PCI bus for each vector separately.
+     *
+     * @param   pDevIns             The device instance.
+     * @param   pPciDev             The PCI device structure.  If NULL the default
+     *                              PCI device for this device instance is used.
+     * @param   pbmIrqs             Bitmap of the IRQ numbers (MSI-X vectors) to set.
+     * @param   cIrqs               The number of bits in the bitmap, must be a
+     *                              multiple of 32.
+     * @param   iLevel              IRQ level. See the PDM_IRQ_LEVEL_* \#defines.
+     * @thread  Any thread, but will involve the emulation thread.
+     */
+    DECLRCCALLBACKMEMBER(void, pfnPCISetIrqMulti,(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs, uint32_t cIrqs,
+                                                 int iLevel));
+
     /**
      * Set ISA IRQ for a device.
      *
@@ -5516,7 +5677,7 @@ typedef RGPTRTYPE(struct PDMDEVHLPRC *) PPDMDEVHLPRC;
 typedef RGPTRTYPE(const struct PDMDEVHLPRC *) PCPDMDEVHLPRC;
 
 /** Current PDMDEVHLP version number. */
-#define PDM_DEVHLPRC_VERSION                    PDM_VERSION_MAKE(0xffe6, 19, 0)
+#define PDM_DEVHLPRC_VERSION                    PDM_VERSION_MAKE(0xffe6, 20, 0)
 
 
 /**
@@ -5652,6 +5813,25 @@ typedef struct PDMDEVHLPR0
      */
     DECLR0CALLBACKMEMBER(void, pfnPCISetIrq,(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, int iIrq, int iLevel));
 
+    /**
+     * Sets several IRQs of the given PCI device in one go.
+     *
+     * This is meant for MSI-X capable devices signalling several vectors at the
+     * same time (e.g. when a number of queues complete at once), it saves taking
+     * the PDM lock and calling into the PCI bus for each vector separately.
+     *
+     * @param   pDevIns             The device instance.
+     * @param   pPciDev             The PCI device structure.  If NULL the default
+     *                              PCI device for this device instance is used.
+     * @param   pbmIrqs             Bitmap of the IRQ numbers (MSI-X vectors) to set.
+     * @param   cIrqs               The number of bits in the bitmap, must be a
+     *                              multiple of 32.
+     * @param   iLevel              IRQ level. See the PDM_IRQ_LEVEL_* \#defines.
+     * @thread  Any thread, but will involve the emulation thread.
+     */
+    DECLR0CALLBACKMEMBER(void, pfnPCISetIrqMulti,(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs, uint32_t cIrqs,
+                                                 int iLevel));
+
     /**
      * Set ISA IRQ for a device.
      *
@@ -5790,6 +5970,8 @@ typedef struct PDMDEVHLPR0
      * @{ */
     DECLR0CALLBACKMEMBER(PPDMQUEUEITEMCORE, pfnQueueAlloc,(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue));
     DECLR0CALLBACKMEMBER(int, pfnQueueInsert,(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem));
+    /** @copydoc PDMDEVHLPR3::pfnQueueFree */
+    DECLR0CALLBACKMEMBER(int, pfnQueueFree,(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem));
     DECLR0CALLBACKMEMBER(bool, pfnQueueFlushIfNecessary,(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue));
     /** @} */
 
@@ -6104,7 +6286,7 @@ typedef R0PTRTYPE(struct PDMDEVHLPR0 *) PPDMDEVHLPR0;
 typedef R0PTRTYPE(const struct PDMDEVHLPR0 *) PCPDMDEVHLPR0;
 
 /** Current PDMDEVHLP version number. */
-#define PDM_DEVHLPR0_VERSION                    PDM_VERSION_MAKE(0xffe5, 27, 0)
+#define PDM_DEVHLPR0_VERSION                    PDM_VERSION_MAKE(0xffe5, 29, 0)
 
 
 /**
@@ -6798,6 +6980,158 @@ DECLINLINE(RTGCPHYS) PDMDevHlpMmioGetMappingAddress(PPDMDEVINS pDevIns, IOMMMIOH
     return pDevIns->pHlpR3->pfnMmioGetMappingAddress(pDevIns, hRegion);
 }
 
+/**
+ * @copydoc PDMDEVHLPR3::pfnMmioDoorbellRegister
+ */
+DECLINLINE(int) PDMDevHlpMmioDoorbellRegister(PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off, uint32_t cb,
+                                              uint32_t fFlags, uint64_t uDataMatch, PFNIOMMMIODOORBELL pfnNotify, void *pvUser)
+{
+    return pDevIns->pHlpR3->pfnMmioDoorbellRegister(pDevIns, hRegion, off, cb, fFlags, uDataMatch, pfnNotify, pvUser);
+}
+
+/**
+ * @copydoc PDMDEVHLPR3::pfnMmioDoorbellDeregister
+ */
+DECLINLINE(int) PDMDevHlpMmioDoorbellDeregister(PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off)
+{
+    return pDevIns->pHlpR3->pfnMmioDoorbellDeregister(pDevIns, hRegion, off);
+}
+
+/**
+ * @copydoc PDMDEVHLPR3::pfnPhysMapCacheCreate
+ */
+DECLINLINE(int) PDMDevHlpPhysMapCacheCreate(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t cEntries, const char *pszName,
+                                            PPDMPHYSMAPCACHE *ppCache)
+{
+    return pDevIns->pHlpR3->pfnPhysMapCacheCreate(pDevIns, pPciDev, cEntries, pszName, ppCache);
+}
+
+/**
+ * @copydoc PDMDEVHLPR3::pfnPhysMapCacheDestroy
+ */
+DECLINLINE(int) PDMDevHlpPhysMapCacheDestroy(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache)
+{
+    return pDevIns->pHlpR3->pfnPhysMapCacheDestroy(pDevIns, pCache);
+}
+
+/**
+ * @copydoc PDMDEVHLPR3::pfnPhysMapCacheFlush
+ */
+DECLINLINE(void) PDMDevHlpPhysMapCacheFlush(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache)
+{
+    pDevIns->pHlpR3->pfnPhysMapCacheFlush(pDevIns, pCache);
+}
+
+/**
+ * @copydoc PDMDEVHLPR3::pfnPhysQueryRamMappings
+ */
+DECLINLINE(int) PDMDevHlpPhysQueryRamMappings(PPDMDEVINS pDevIns, PPGMPHYSRAMMAPPING paMappings, uint32_t cMaxMappings,
+                                              uint32_t *pcMappings)
+{
+    return pDevIns->pHlpR3->pfnPhysQueryRamMappings(pDevIns, paMappings, cMaxMappings, pcMappings);
+}
+
+/**
+ * Gets a ring-3 pointer to a guest address thru a guest physical mapping cache.
+ *
+ * @returns VBox status code, see PDMDEVHLPR3::pfnPhysMapCacheMap.
+ * @param   pDevIns     The device instance.
+ * @param   pCache      The cache.
+ * @param   GCPhys      The guest physical address.
+ * @param   fWrite      Whether write access is required.
+ * @param   ppv         Where to return the pointer corresponding to @a GCPhys.
+ *                      Valid up to the end of the guest page until the next
+ *                      call using the cache.
+ */
+DECLINLINE(int) PDMDevHlpPhysMapCacheMap(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache, RTGCPHYS GCPhys, bool fWrite, void **ppv)
+{
+    /* Cached entries must not outlive bus mastering being disabled. */
+    if (RT_LIKELY(PCIDevIsBusmaster(pCache->pPciDev)))
+    {
+        void *pv = PDMPhysMapCacheLookup(pCache, GCPhys, fWrite);
+        if (RT_LIKELY(pv))
+        {
+            *ppv = pv;
+            return VINF_SUCCESS;
+        }
+    }
+    return pDevIns->pHlpR3->pfnPhysMapCacheMap(pDevIns, pCache, GCPhys, fWrite, ppv);
+}
+
+/**
+ * Bus master physical memory read thru a guest physical mapping cache.
+ *
+ * Falls back on PDMDevHlpPCIPhysRead for pages which can't be cached.
+ *
+ * @returns VBox status code, see PDMDevHlpPCIPhysRead.
+ * @param   pDevIns     The device instance.
+ * @param   pCache      The cache.
+ * @param   GCPhys      Physical address start reading from.
+ * @param   pvBuf       Where to put the read bits.
+ * @param   cbRead      How many bytes to read.
+ */
+DECLINLINE(int) PDMDevHlpPhysMapCacheRead(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache, RTGCPHYS GCPhys,
+                                          void *pvBuf, size_t cbRead)
+{
+    uint8_t *pbDst = (uint8_t *)pvBuf;
+    while (cbRead > 0)
+    {
+        size_t const cbChunk = RT_MIN(cbRead, GUEST_PAGE_SIZE - (GCPhys & GUEST_PAGE_OFFSET_MASK));
+        void        *pvSrc;
+        int rc = PDMDevHlpPhysMapCacheMap(pDevIns, pCache, GCPhys, false /*fWrite*/, &pvSrc);
+        if (RT_SUCCESS(rc))
+            memcpy(pbDst, pvSrc, cbChunk);
+        else
+        {
+            rc = pDevIns->pHlpR3->pfnPCIPhysRead(pDevIns, pCache->pPciDev, GCPhys, pbDst, cbChunk,
+                                                 PDM_DEVHLP_PHYS_RW_F_DEFAULT);
+            if (RT_FAILURE(rc))
+                return rc;
+        }
+        pbDst  += cbChunk;
+        GCPhys += cbChunk;
+        cbRead -= cbChunk;
+    }
+    return VINF_SUCCESS;
+}
+
+/**
+ * Bus master physical memory write thru a guest physical mapping cache.
+ *
+ * Falls back on PDMDevHlpPCIPhysWrite for pages which can't be cached.
+ *
+ * @returns VBox status code, see PDMDevHlpPCIPhysWrite.
+ * @param   pDevIns     The device instance.
+ * @param   pCache      The cache.
+ * @param   GCPhys      Physical address to write to.
+ * @param   pvBuf       What to write.
+ * @param   cbWrite     How many bytes to write.
+ */
+DECLINLINE(int) PDMDevHlpPhysMapCacheWrite(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache, RTGCPHYS GCPhys,
+                                           const void *pvBuf, size_t cbWrite)
+{
+    uint8_t const *pbSrc = (uint8_t const *)pvBuf;
+    while (cbWrite > 0)
+    {
+        size_t const cbChunk = RT_MIN(cbWrite, GUEST_PAGE_SIZE - (GCPhys & GUEST_PAGE_OFFSET_MASK));
+        void        *pvDst;
+        int rc = PDMDevHlpPhysMapCacheMap(pDevIns, pCache, GCPhys, true /*fWrite*/, &pvDst);
+        if (RT_SUCCESS(rc))
+            memcpy(pvDst, pbSrc, cbChunk);
+        else
+        {
+            rc = pDevIns->pHlpR3->pfnPCIPhysWrite(pDevIns, pCache->pPciDev, GCPhys, pbSrc, cbChunk,
+                                                  PDM_DEVHLP_PHYS_RW_F_DEFAULT);
+            if (RT_FAILURE(rc))
+                return rc;
+        }
+        pbSrc   += cbChunk;
+        GCPhys  += cbChunk;
+        cbWrite -= cbChunk;
+    }
+    return VINF_SUCCESS;
+}
+
 #endif /* IN_RING3 */
 #if !defined(IN_RING3) || defined(DOXYGEN_RUNNING)
 
@@ -8450,6 +8784,14 @@ DECLINLINE(void) PDMDevHlpPCISetIrqNoWaitEx(PPDMDEVINS pDevIns, PPDMPCIDEV pPciD
     pDevIns->CTX_SUFF(pHlp)->pfnPCISetIrq(pDevIns, pPciDev, iIrq, iLevel);
 }
 
+/**
+ * @copydoc PDMDEVHLPR3::pfnPCISetIrqMulti
+ */
+DECLINLINE(void) PDMDevHlpPCISetIrqMulti(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs, uint32_t cIrqs, int iLevel)
+{
+    pDevIns->CTX_SUFF(pHlp)->pfnPCISetIrqMulti(pDevIns, pPciDev, pbmIrqs, cIrqs, iLevel);
+}
+
 /**
  * @copydoc PDMDEVHLPR3::pfnISASetIrq
  */
@@ -8541,6 +8883,14 @@ DECLINLINE(int) PDMDevHlpQueueInsert(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue,
     return pDevIns->CTX_SUFF(pHlp)->pfnQueueInsert(pDevIns, hQueue, pItem);
 }
 
+/**
+ * @copydoc PDMDEVHLPR3::pfnQueueFree
+ */
+DECLINLINE(int) PDMDevHlpQueueFree(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem)
+{
+    return pDevIns->CTX_SUFF(pHlp)->pfnQueueFree(pDevIns, hQueue, pItem);
+}
+
 /**
  * @copydoc PDMDEVHLPR3::pfnQueueFlushIfNecessary
  */
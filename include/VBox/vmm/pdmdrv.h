@@ -840,6 +840,20 @@ typedef struct PDMDRVHLPR3
 
     DECLR3CALLBACKMEMBER(PPDMQUEUEITEMCORE, pfnQueueAlloc,(PPDMDRVINS pDrvIns, PDMQUEUEHANDLE hQueue));
     DECLR3CALLBACKMEMBER(int, pfnQueueInsert,(PPDMDRVINS pDrvIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem));
+    /**
+     * Frees an item allocated by pfnQueueAlloc that will not be inserted.
+     *
+     * Must be used when giving up on an item after allocating it, with ring
+     * queues the consumer would otherwise stop at the item for good.
+     *
+     * @returns VBox status code.
+     * @param   pDrvIns             The driver instance.
+     * @param   hQueue              The queue handle.
+     * @param   pItem               The item to free.
+     * @thread  Any thread.
+     * @sa      PDMQueueFree
+     */
+    DECLR3CALLBACKMEMBER(int, pfnQueueFree,(PPDMDRVINS pDrvIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem));
     DECLR3CALLBACKMEMBER(bool, pfnQueueFlushIfNecessary,(PPDMDRVINS pDrvIns, PDMQUEUEHANDLE hQueue));
     /** @} */
 
@@ -1523,7 +1537,7 @@ typedef struct PDMDRVHLPR3
     uint32_t                        u32TheEnd;
 } PDMDRVHLPR3;
 /** Current DRVHLP version number. */
-#define PDM_DRVHLPR3_VERSION                    PDM_VERSION_MAKE(0xf0fb, 16, 0)
+#define PDM_DRVHLPR3_VERSION                    PDM_VERSION_MAKE(0xf0fb, 17, 0)
 
 
 /**
@@ -1716,6 +1730,14 @@ DECLINLINE(int) PDMDrvHlpQueueInsert(PPDMDRVINS pDrvIns, PDMQUEUEHANDLE hQueue,
     return pDrvIns->CTX_SUFF(pHlp)->pfnQueueInsert(pDrvIns, hQueue, pItem);
 }
 
+/**
+ * @copydoc PDMDRVHLPR3::pfnQueueFree
+ */
+DECLINLINE(int) PDMDrvHlpQueueFree(PPDMDRVINS pDrvIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem)
+{
+    return pDrvIns->CTX_SUFF(pHlp)->pfnQueueFree(pDrvIns, hQueue, pItem);
+}
+
 /**
  * @copydoc PDMDRVHLPR3::pfnQueueFlushIfNecessary
  */
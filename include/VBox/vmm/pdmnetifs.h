@@ -127,6 +127,23 @@ DECLINLINE(void) PDMScatterGatherSetOwner(PPDMSCATTERGATHER pSgBuf, uint32_t uNe
 
 
 
+/**
+ * A received frame handed to PDMINETWORKDOWN::pfnReceiveBurst.
+ */
+typedef struct PDMNETWORKRECVFRAME
+{
+    /** The frame data. */
+    const void             *pvFrame;
+    /** The size of the frame in bytes. */
+    size_t                  cbFrame;
+    /** Segmentation context, NULL for plain frames. */
+    PCPDMNETWORKGSO         pGso;
+} PDMNETWORKRECVFRAME;
+/** Pointer to a received frame. */
+typedef PDMNETWORKRECVFRAME *PPDMNETWORKRECVFRAME;
+/** Pointer to a const received frame. */
+typedef PDMNETWORKRECVFRAME const *PCPDMNETWORKRECVFRAME;
+
 /** Pointer to a network port interface */
 typedef struct PDMINETWORKDOWN *PPDMINETWORKDOWN;
 /**
@@ -188,9 +205,35 @@ typedef struct PDMINETWORKDOWN
      */
     DECLR3CALLBACKMEMBER(void, pfnXmitPending,(PPDMINETWORKDOWN pInterface));
 
+    /**
+     * Receive a burst of frames from the network.
+     *
+     * Optional, NULL if not implemented, in which case the frames must be passed
+     * up one by one using pfnReceive / pfnReceiveGso.  Devices implementing this
+     * publish all the frames to the guest at once, which saves the per frame
+     * guest notification.
+     *
+     * Like for pfnReceive, pfnWaitReceiveAvail must have succeeded before this
+     * is called.  Frames which are not accepted (filtered) count as done.
+     *
+     * @returns VBox status code.
+     * @retval  VERR_NET_NO_BUFFER_SPACE if the device ran out of receive buffers
+     *          before all frames were taken, *pcDone tells how many were.  The
+     *          caller should wait (pfnWaitReceiveAvail) and pass up the rest.
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   paFrames        The frames.
+     * @param   cFrames         Number of frames, at least one.
+     * @param   pcDone          Where to return the number of frames taken
+     *                          (always set).
+     *
+     * @thread  Non-EMT.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnReceiveBurst,(PPDMINETWORKDOWN pInterface, PCPDMNETWORKRECVFRAME paFrames,
+                                               uint32_t cFrames, uint32_t *pcDone));
+
 } PDMINETWORKDOWN;
 /** PDMINETWORKDOWN interface ID. */
-#define PDMINETWORKDOWN_IID                     "52b8cdbb-a087-493b-baa7-81ec3b803e06"
+#define PDMINETWORKDOWN_IID                     "8f1d4d2e-6b0a-4c71-9a7e-2f3c1e5b9d40"
 
 
 /**
@@ -482,6 +525,71 @@ typedef struct PDMINETWORKNATCONFIG
 } PDMINETWORKNATCONFIG;
 /** PDMINETWORKNATCONFIG interface ID. */
 #define PDMINETWORKNATCONFIG_IID                "16de6afe-e48f-4cad-abc0-f96507683376"
+
+
+/** @name PDMINETWORKVHOST_OFFLOAD_F_XXX - Receive offloads for PDMINETWORKVHOST::pfnHandOver.
+ * @{ */
+/** The guest accepts packets with partial checksums. */
+#define PDMINETWORKVHOST_OFFLOAD_F_CSUM         RT_BIT_32(0)
+/** The guest accepts TCPv4 segmentation offload frames. */
+#define PDMINETWORKVHOST_OFFLOAD_F_TSO4         RT_BIT_32(1)
+/** The guest accepts TCPv6 segmentation offload frames. */
+#define PDMINETWORKVHOST_OFFLOAD_F_TSO6         RT_BIT_32(2)
+/** The guest accepts segmentation offload frames with ECN. */
+#define PDMINETWORKVHOST_OFFLOAD_F_TSO_ECN      RT_BIT_32(3)
+/** The guest accepts UDP fragmentation offload frames. */
+#define PDMINETWORKVHOST_OFFLOAD_F_UFO          RT_BIT_32(4)
+/** Valid flags. */
+#define PDMINETWORKVHOST_OFFLOAD_F_VALID_MASK   UINT32_C(0x0000001f)
+/** @} */
+
+/** Pointer to a kernel offload network interface. */
+typedef struct PDMINETWORKVHOST *PPDMINETWORKVHOST;
+/**
+ * Kernel offload network interface (up), Linux vhost-net.
+ *
+ * Implemented by network drivers whose host end is a TAP device, so that a
+ * virtio device can hand its rings and the TAP device to the host kernel
+ * which then moves packets between guest memory and the TAP device directly.
+ * No interface pair.
+ */
+typedef struct PDMINETWORKVHOST
+{
+    /**
+     * Hands the TAP device over to the host kernel.
+     *
+     * The driver stops reading from the TAP device and configures it for the
+     * given virtio-net header size and receive offloads.  Frames passed to the
+     * driver thru PDMINETWORKUP while handed over are still sent.
+     *
+     * Returns only after a frame the driver already read was passed up, so the
+     * caller must make sure PDMINETWORKDOWN::pfnWaitReceiveAvail doesn't block
+     * before calling this.
+     *
+     * @returns VBox status code.
+     * @retval  VERR_NOT_SUPPORTED if the TAP device wasn't set up with virtio-net
+     *          headers (IFF_VNET_HDR).
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   cbVnetHdr       The size of the virtio-net header used by the guest.
+     * @param   fOffloads       PDMINETWORKVHOST_OFFLOAD_F_XXX.
+     * @param   phNative        Where to return the native TAP file handle.  The
+     *                          driver keeps ownership.
+     * @thread  EMT
+     */
+    DECLR3CALLBACKMEMBER(int, pfnHandOver,(PPDMINETWORKVHOST pInterface, uint32_t cbVnetHdr, uint32_t fOffloads,
+                                           RTHCINTPTR *phNative));
+
+    /**
+     * Takes the TAP device back after the kernel was detached from it.
+     *
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @thread  EMT
+     */
+    DECLR3CALLBACKMEMBER(void, pfnTakeBack,(PPDMINETWORKVHOST pInterface));
+
+} PDMINETWORKVHOST;
+/** PDMINETWORKVHOST interface ID. */
+#define PDMINETWORKVHOST_IID                    "cb4b88ff-56b0-47e0-82ef-b1b4fc4856e6"
 /** @} */
 
 RT_C_DECLS_END
@@ -53,6 +53,7 @@
 
 #define PDM_NETSHAPER_MIN_BUCKET_SIZE UINT32_C(65536) /**< bytes */
 #define PDM_NETSHAPER_MAX_LATENCY     UINT32_C(100)   /**< milliseconds */
+#define PDM_NETSHAPER_MAX_DEPTH       UINT32_C(8)     /**< max group nesting (root included) */
 
 RT_C_DECLS_BEGIN
 
@@ -76,6 +77,8 @@ typedef struct PDMNSFILTER
     bool                                fChoked;
     /** Aligment padding. */
     bool                                afPadding[3];
+    /** RTTimeNanoTS of when the filter got choked (for statistics). */
+    uint64_t volatile                   nsChoked;
     /** The driver this filter is aggregated into (ring-3). */
     R3PTRTYPE(PPDMINETWORKDOWN)         pIDrvNetR3;
 } PDMNSFILTER;
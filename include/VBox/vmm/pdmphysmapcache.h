@@ -0,0 +1,174 @@
+/** @file
+ * PDM - Pluggable Device Manager, Guest Physical Mapping Cache.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+#ifndef VBOX_INCLUDED_vmm_pdmphysmapcache_h
+#define VBOX_INCLUDED_vmm_pdmphysmapcache_h
+#ifndef RT_WITHOUT_PRAGMA_ONCE
+# pragma once
+#endif
+
+#include <VBox/types.h>
+#include <VBox/param.h>
+#include <VBox/vmm/stam.h>
+
+RT_C_DECLS_BEGIN
+
+/** @defgroup grp_pdm_physmapcache     The PDM Guest Physical Mapping Cache API
+ * @ingroup grp_pdm
+ *
+ * A small direct mapped cache of ring-3 mappings of guest pages, keeping the
+ * PGM page mapping lock for as long as an entry is in the cache.  It is meant
+ * for device workers accessing the same descriptor rings and buffer pages over
+ * and over again, so that hits are plain memory accesses without PGM lookups
+ * or taking the PGM lock.
+ *
+ * Entries are validated against the PGM mapping generation, which PGM bumps
+ * whenever a page is freed, replaced, remapped or ballooned, so stale entries
+ * are remapped on the next access.  Pages that cannot be mapped (MMIO, IOMMU
+ * translated accesses, etc.) are not cached and the read/write helpers fall
+ * back on the regular PCI physical access helpers for them.
+ *
+ * A cache is not serialized, each thread (or lock domain) accessing guest
+ * memory needs its own cache instance.
+ *
+ * @{
+ */
+
+/** Pointer to a guest physical mapping cache. */
+typedef struct PDMPHYSMAPCACHE *PPDMPHYSMAPCACHE;
+
+#ifdef IN_RING3
+
+/** Magic value of PDMPHYSMAPCACHE::u32Magic (Ada Lovelace). */
+#define PDMPHYSMAPCACHE_MAGIC           UINT32_C(0x18151210)
+/** The default number of entries. */
+#define PDMPHYSMAPCACHE_ENTRIES_DEF     64
+/** The maximum number of entries. */
+#define PDMPHYSMAPCACHE_ENTRIES_MAX     4096
+
+/**
+ * A guest physical mapping cache entry.
+ */
+typedef struct PDMPHYSMAPCACHEENTRY
+{
+    /** The guest physical address of the page, NIL_RTGCPHYS if unused. */
+    RTGCPHYS                GCPhysPage;
+    /** The ring-3 mapping of the page. */
+    uint8_t                *pbPage;
+    /** The PGM mapping generation this entry was mapped under. */
+    uint32_t                uGen;
+    /** Whether the page was mapped writable. */
+    bool                    fWritable;
+    bool                    afPadding[3];
+    /** The page mapping lock. */
+    PGMPAGEMAPLOCK          Lock;
+} PDMPHYSMAPCACHEENTRY;
+/** Pointer to a guest physical mapping cache entry. */
+typedef PDMPHYSMAPCACHEENTRY *PPDMPHYSMAPCACHEENTRY;
+
+/**
+ * A guest physical mapping cache.
+ *
+ * Created by PDMDevHlpPhysMapCacheCreate, the members are read-only to the
+ * owner and only exposed for the inlined lookup.
+ */
+typedef struct PDMPHYSMAPCACHE
+{
+    /** Magic value (PDMPHYSMAPCACHE_MAGIC). */
+    uint32_t                u32Magic;
+    /** Mask for the entry index (number of entries - 1). */
+    uint32_t                fIdxMask;
+    /** Pointer to the PGM mapping generation. */
+    uint32_t volatile const *puGen;
+    /** The owning device instance. */
+    PPDMDEVINSR3            pDevIns;
+    /** The PCI device accesses are made on behalf of. */
+    PPDMPCIDEV              pPciDev;
+    /** Number of lookups which hit a valid entry. */
+    STAMCOUNTER             StatHits;
+    /** Number of lookups which had to map the page. */
+    STAMCOUNTER             StatMisses;
+    /** Number of entries found stale because the PGM mapping generation changed. */
+    STAMCOUNTER             StatStale;
+    /** Number of accesses to pages which can't be cached. */
+    STAMCOUNTER             StatUncacheable;
+    /** Number of explicit flushes. */
+    STAMCOUNTER             StatFlushes;
+    /** Pointer to the next cache (PDMUSERPERVM::pPhysMapCaches, protected by
+     * PDMUSERPERVM::ListCritSect). */
+    struct PDMPHYSMAPCACHE *pNext;
+    /** The entries (variable size). */
+    RT_FLEXIBLE_ARRAY_EXTENSION
+    PDMPHYSMAPCACHEENTRY    aEntries[RT_FLEXIBLE_ARRAY];
+} PDMPHYSMAPCACHE;
+
+/**
+ * Calculates the entry index for a guest physical address.
+ *
+ * @returns Entry index.
+ * @param   pCache      The cache.
+ * @param   GCPhys      The guest physical address.
+ */
+#define PDMPHYSMAPCACHE_IDX(a_pCache, a_GCPhys) ((uint32_t)((a_GCPhys) >> GUEST_PAGE_SHIFT) & (a_pCache)->fIdxMask)
+
+/**
+ * Looks up a guest address in the cache without mapping anything.
+ *
+ * @returns Pointer to the byte at @a GCPhys, valid to the end of the guest
+ *          page, or NULL if not cached (or stale).
+ * @param   pCache      The cache.
+ * @param   GCPhys      The guest physical address.
+ * @param   fWrite      Whether write access is required.
+ */
+DECLINLINE(void *) PDMPhysMapCacheLookup(PPDMPHYSMAPCACHE pCache, RTGCPHYS GCPhys, bool fWrite)
+{
+    PPDMPHYSMAPCACHEENTRY const pEntry = &pCache->aEntries[PDMPHYSMAPCACHE_IDX(pCache, GCPhys)];
+    if (   pEntry->GCPhysPage == (GCPhys & ~(RTGCPHYS)GUEST_PAGE_OFFSET_MASK)
+        && pEntry->uGen       == *pCache->puGen
+        && (pEntry->fWritable || !fWrite))
+    {
+        STAM_COUNTER_INC(&pCache->StatHits);
+        return pEntry->pbPage + (GCPhys & GUEST_PAGE_OFFSET_MASK);
+    }
+    return NULL;
+}
+
+#endif /* IN_RING3 */
+
+/** @} */
+
+RT_C_DECLS_END
+
+#endif /* !VBOX_INCLUDED_vmm_pdmphysmapcache_h */
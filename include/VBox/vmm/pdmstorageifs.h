@@ -573,7 +573,9 @@ typedef enum PDMMEDIAEXIOREQTYPE
     /** Discard request. */
     PDMMEDIAEXIOREQTYPE_DISCARD,
     /** SCSI command. */
-    PDMMEDIAEXIOREQTYPE_SCSI
+    PDMMEDIAEXIOREQTYPE_SCSI,
+    /** Write zeroes request. */
+    PDMMEDIAEXIOREQTYPE_WRITE_ZEROES
 } PDMMEDIAEXIOREQTYPE;
 /** Pointer to a I/O request type. */
 typedef PDMMEDIAEXIOREQTYPE *PPDMMEDIAEXIOREQTYPE;
@@ -622,8 +624,11 @@ typedef PDMMEDIAEXIOREQSTATE *PPDMMEDIAEXIOREQSTATE;
 #define PDMIMEDIAEX_FEATURE_F_DISCARD           RT_BIT_32(1)
 /** The send raw SCSI command request is supported. */
 #define PDMIMEDIAEX_FEATURE_F_RAWSCSICMD        RT_BIT_32(2)
+/** The write zeroes request is supported. */
+#define PDMIMEDIAEX_FEATURE_F_WRITE_ZEROES      RT_BIT_32(3)
 /** Mask of valid flags. */
-#define PDMIMEDIAEX_FEATURE_F_VALID             (PDMIMEDIAEX_FEATURE_F_ASYNC | PDMIMEDIAEX_FEATURE_F_DISCARD | PDMIMEDIAEX_FEATURE_F_RAWSCSICMD)
+#define PDMIMEDIAEX_FEATURE_F_VALID             (  PDMIMEDIAEX_FEATURE_F_ASYNC | PDMIMEDIAEX_FEATURE_F_DISCARD \
+                                                 | PDMIMEDIAEX_FEATURE_F_RAWSCSICMD | PDMIMEDIAEX_FEATURE_F_WRITE_ZEROES)
 /** @} */
 
 /** @name I/O request specific flags
@@ -722,6 +727,29 @@ typedef struct PDMIMEDIAEXPORT
     DECLR3CALLBACKMEMBER(int, pfnIoReqQueryBuf, (PPDMIMEDIAEXPORT pInterface, PDMMEDIAEXIOREQ hIoReq,
                                                  void *pvIoReqAlloc, void **ppvBuf, size_t *pcbBuf));
 
+    /**
+     * Queries the memory buffer for the request from the drive/device above as a list
+     * of segments mapping the complete guest buffer.
+     *
+     * @returns VBox status code.
+     * @retval  VERR_NOT_SUPPORTED if this is not supported for this request, for example
+     *          because the guest buffer is not page aligned, spans memory which can't be
+     *          mapped or doesn't fit into the given segment array.
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   hIoReq          The I/O request handle.
+     * @param   pvIoReqAlloc    The allocator specific memory for this request.
+     * @param   paSegs          Where to store the segments describing the guest buffer on success.
+     * @param   pcSegs          On input the number of entries in @a paSegs, on success the number
+     *                          of segments used.
+     *
+     * @note This is an optional feature like PDMIMEDIAEXPORT::pfnIoReqQueryBuf and takes precedence
+     *       over it if both are implemented.  The mappings stay valid until the request is completed
+     *       through PDMIMEDIAEXPORT::pfnIoReqCompleteNotify, where they get released by the callee.
+     *       The caller must not transform the data in place as it would be visible to the guest.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnIoReqQuerySgBuf, (PPDMIMEDIAEXPORT pInterface, PDMMEDIAEXIOREQ hIoReq,
+                                                   void *pvIoReqAlloc, PRTSGSEG paSegs, unsigned *pcSegs));
+
     /**
      * Queries the specified amount of ranges to discard from the callee for the given I/O request.
      *
@@ -760,7 +788,7 @@ typedef struct PDMIMEDIAEXPORT
 } PDMIMEDIAEXPORT;
 
 /** PDMIMEDIAAEXPORT interface ID. */
-#define PDMIMEDIAEXPORT_IID                  "0ae2e534-6c28-41d6-9a88-7f88f2cb2ff8"
+#define PDMIMEDIAEXPORT_IID                  "9d3f1b62-7c4e-4a85-b0d6-2e8a51f47c93"
 
 
 /** Pointer to an extended media interface. */
@@ -944,6 +972,27 @@ typedef struct PDMIMEDIAEX
      */
     DECLR3CALLBACKMEMBER(int, pfnIoReqDiscard, (PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq, unsigned cRangesMax));
 
+    /**
+     * Writes zeroes to the given range.
+     *
+     * Unlike a discard the range is guaranteed to read back as zeroes afterwards,
+     * the driver keeps unallocated blocks unallocated where it can.
+     *
+     * @returns VBox status code.
+     * @retval  VERR_NOT_SUPPORTED if the driver doesn't support the request, see PDMIMEDIAEX_FEATURE_F_WRITE_ZEROES.
+     * @retval  VERR_PDM_MEDIAEX_IOREQ_CANCELED if the request was canceled  by a call to
+     *          PDMIMEDIAEX::pfnIoReqCancel.
+     * @retval  VINF_PDM_MEDIAEX_IOREQ_IN_PROGRESS if the request was successfully submitted but is still in progress.
+     *          Completion will be notified through PDMIMEDIAEXPORT::pfnIoReqCompleteNotify with the appropriate status code.
+     * @retval  VINF_SUCCESS if the request completed successfully.
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   hIoReq          The I/O request to associate the write zeroes request with.
+     * @param   off             Start offset of the range to zero.
+     * @param   cbZero          Number of bytes to zero.
+     * @thread  Any thread.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnIoReqWriteZeroes, (PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq, uint64_t off, size_t cbZero));
+
     /**
      * Send a raw command to the underlying device (CDROM).
      *
@@ -1047,7 +1096,7 @@ typedef struct PDMIMEDIAEX
 
 } PDMIMEDIAEX;
 /** PDMIMEDIAEX interface ID. */
-#define PDMIMEDIAEX_IID                      "29c9e82b-934e-45c5-bb84-0d871c3cc9dd"
+#define PDMIMEDIAEX_IID                      "4b6e2c18-5d3a-4f0e-9a71-c2e8b0d5f349"
 
 /** @} */
 
@@ -135,6 +135,8 @@ typedef const PDMUSBDESCCACHE *PCPDMUSBDESCCACHE;
 #define PDM_USBREG_SAVED_STATE_SUPPORTED    RT_BIT(1)
 /** A SuperSpeed USB 3.0 device. */
 #define PDM_USBREG_SUPERSPEED_CAPABLE       RT_BIT(2)
+/** The device can send bulk OUT data straight from VUSBURB::paGuestSegs. */
+#define PDM_USBREG_GUEST_SG_URBS            RT_BIT(3)
 /** @} */
 
 /** PDM USB Device Registration Structure,
@@ -146,9 +146,28 @@ typedef struct PDMIWEBCAMDEV
     DECLR3CALLBACKMEMBER(void, pfnFrame,(PPDMIWEBCAMDEV pInterface, uint64_t idDevice,
                                          struct VRDEVIDEOINPAYLOADHDR const *pHeader, uint32_t cbHeader,
                                          const void *pvFrame, uint32_t cbFrame));
+
+    /**
+     * A new frame in a buffer which is handed over to the device.
+     *
+     * Same as pfnFrame, but the device takes ownership of the frame data
+     * instead of copying it.  This saves a copy per frame for backends which
+     * have to allocate a buffer anyway, e.g. when encoding raw frames to JPEG.
+     *
+     * @param   pInterface      Pointer to the interface.
+     * @param   idDevice        Unique id for the reported webcam assigned by the driver.
+     * @param   pHeader         Payload header (defined in VRDE).
+     * @param   cbHeader        Size of the payload header.
+     * @param   pvFrame         Frame (image) data allocated with RTMemAlloc.  The
+     *                          device frees it with RTMemFree, also on failure.
+     * @param   cbFrame         Size of the image data.
+     */
+    DECLR3CALLBACKMEMBER(void, pfnFrameOwned,(PPDMIWEBCAMDEV pInterface, uint64_t idDevice,
+                                              struct VRDEVIDEOINPAYLOADHDR const *pHeader, uint32_t cbHeader,
+                                              void *pvFrame, uint32_t cbFrame));
 } PDMIWEBCAMDEV;
 /** Interface ID for PDMIWEBCAMDEV. */
-#define PDMIWEBCAMDEV_IID "6ac03e3c-f56c-4a35-80af-c13ce47a9dd7"
+#define PDMIWEBCAMDEV_IID "3f1c2a8e-7b64-4d09-9e5a-c21d8f06b7a4"
 
 /** @} */
 
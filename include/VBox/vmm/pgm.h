@@ -1080,6 +1080,24 @@ typedef PGMPHYSRANGES *PPGMPHYSRANGES;
 /** Pointer to a const list of physical memory ranges. */
 typedef PGMPHYSRANGES const *PCPGMPHYSRANGES;
 
+/**
+ * A guest RAM range with a contiguous ring-3 mapping.
+ *
+ * Returned by PGMR3PhysQueryRamMappings for handing guest memory to host
+ * kernel facilities (e.g. the Linux vhost memory table).
+ */
+typedef struct PGMPHYSRAMMAPPING
+{
+    /** The first guest physical address of the range. */
+    RTGCPHYS        GCPhys;
+    /** The size of the range in bytes. */
+    RTGCPHYS        cb;
+    /** The ring-3 mapping of the range. */
+    RTR3PTR         pvR3;
+} PGMPHYSRAMMAPPING;
+/** Pointer to a guest RAM range mapping. */
+typedef PGMPHYSRAMMAPPING *PPGMPHYSRAMMAPPING;
+
 
 VMM_INT_DECL(PGMPAGETYPE) PGMPhysGetPageType(PVMCC pVM, RTGCPHYS GCPhys);
 
@@ -1333,6 +1351,7 @@ VMMR0_INT_DECL(int)  PGMR0HandlerPhysicalTypeSetUpContext(PGVM pGVM, PGMPHYSHAND
 
 VMMR0DECL(int)       PGMR0SharedModuleCheck(PVMCC pVM, PGVM pGVM, VMCPUID idCpu, PGMMSHAREDMODULE pModule,
                                             PCRTGCPTR64 paRegionsGCPtrs);
+VMMR0DECL(int)       PGMR0SharedPageScan(PGVM pGVM, VMCPUID idCpu, PGMMSCANDUPLICATEPAGESREQ pReq);
 VMMR0DECL(int)       PGMR0Trap0eHandlerNestedPaging(PGVM pGVM, PGVMCPU pGVCpu, PGMMODE enmShwPagingMode, RTGCUINT uErr,
                                                     PCPUMCTX pCtx, RTGCPHYS pvFault);
 VMMR0DECL(VBOXSTRICTRC) PGMR0Trap0eHandlerNPMisconfig(PGVM pGVM, PGVMCPU pGVCpu, PGMMODE enmShwPagingMode,
@@ -1467,10 +1486,35 @@ VMMR3DECL(int)      PGMR3PhysWriteProtectRAM(PVM pVM);
 VMMR3DECL(uint32_t) PGMR3PhysGetRamRangeCount(PVM pVM);
 VMMR3DECL(int)      PGMR3PhysGetRange(PVM pVM, uint32_t iRange, PRTGCPHYS pGCPhysStart, PRTGCPHYS pGCPhysLast,
                                       const char **ppszDesc, bool *pfIsMmio);
+VMMR3_INT_DECL(uint32_t volatile const *) PGMR3PhysGetMapGenerationPtr(PVM pVM);
 VMMR3_INT_DECL(int) PGMR3PhysGetRamBootZeroedRanges(PVM pVM, PPGMPHYSRANGES pRanges, uint32_t cMaxRanges);
+VMMR3_INT_DECL(int) PGMR3PhysQueryRamMappings(PVM pVM, PPGMPHYSRAMMAPPING paMappings, uint32_t cMaxMappings,
+                                              uint32_t *pcMappings);
 VMMR3DECL(int)      PGMR3QueryMemoryStats(PUVM pUVM, uint64_t *pcbTotalMem, uint64_t *pcbPrivateMem, uint64_t *pcbSharedMem, uint64_t *pcbZeroMem);
 VMMR3DECL(int)      PGMR3QueryGlobalMemoryStats(PUVM pUVM, uint64_t *pcbAllocMem, uint64_t *pcbFreeMem, uint64_t *pcbBallonedMem, uint64_t *pcbSharedMem);
 
+/**
+ * Callback for fetching guest RAM pages from the teleportation source after
+ * the VM has been resumed on the target (post-copy).
+ *
+ * Called with cPages = 0, GCPhys = NIL_RTGCPHYS and pvBuf = NULL exactly once
+ * when no more pages will be fetched, after which @a pvUser can be freed.
+ *
+ * @returns VBox status code.  Failures are fatal to the VM.
+ * @param   pvUser      The user argument given to PGMR3PhysPostCopySetFetcher.
+ * @param   GCPhys      The address of the first page.
+ * @param   pvBuf       Where to return the page content.
+ * @param   cPages      The number of pages to fetch.
+ * @thread  Any EMT.  Calls are not serialized.
+ */
+typedef DECLCALLBACKTYPE(int, FNPGMPOSTCOPYFETCH,(void *pvUser, RTGCPHYS GCPhys, void *pvBuf, uint32_t cPages));
+/** Pointer to a FNPGMPOSTCOPYFETCH function. */
+typedef FNPGMPOSTCOPYFETCH *PFNPGMPOSTCOPYFETCH;
+
+VMMR3DECL(int)      PGMR3PhysPostCopyEnable(PUVM pUVM, bool fEnable);
+VMMR3DECL(int)      PGMR3PhysPostCopyRead(PUVM pUVM, RTGCPHYS GCPhys, void *pvBuf, uint32_t cPages);
+VMMR3DECL(int)      PGMR3PhysPostCopySetFetcher(PUVM pUVM, PFNPGMPOSTCOPYFETCH pfnFetch, void *pvUser);
+
 VMMR3_INT_DECL(int) PGMR3PhysMmioRegister(PVM pVM, PVMCPU pVCpu, RTGCPHYS cb, const char *pszDesc, uint16_t *pidRamRange);
 VMMR3_INT_DECL(int) PGMR3PhysMmioMap(PVM pVM, PVMCPU pVCpu, RTGCPHYS GCPhys, RTGCPHYS cb, uint16_t idRamRange,
                                      PGMPHYSHANDLERTYPE hType, uint64_t uUser);
@@ -40,6 +40,7 @@
 #endif
 
 #include <VBox/types.h>
+#include <iprt/assertcompile.h>
 #include <iprt/stdarg.h>
 #ifdef _MSC_VER
 # if RT_MSC_PREREQ(RT_MSC_VER_VS2005)
@@ -175,6 +176,8 @@ typedef enum STAMTYPE
     STAMTYPE_BOOL,
     /** Generic boolean value. Reset to false. */
     STAMTYPE_BOOL_RESET,
+    /** Profiling with a log2 histogram of the sample sizes. */
+    STAMTYPE_HISTOGRAM,
     /** Start of the internal types. */
     STAMTYPE_FIRST_INTERNAL_TYPE,
     /** Sum of two or more other samples. */
@@ -1220,6 +1223,120 @@ typedef const STAMPROFILEADV *PCSTAMPROFILEADV;
 #endif
 
 
+/** Number of buckets in a STAMHISTOGRAM. */
+#define STAM_HISTOGRAM_BUCKETS          24
+/** The log2 of the upper bound (exclusive) of the first STAMHISTOGRAM bucket. */
+#define STAM_HISTOGRAM_FIRST_SHIFT      8
+
+/**
+ * Histogram sample - STAMTYPE_HISTOGRAM.
+ *
+ * A STAMPROFILE with a log2 distribution of the sample sizes tacked on, so
+ * that tail latencies can be read off it and not just the average.
+ *
+ * Bucket 0 counts samples below 2^STAM_HISTOGRAM_FIRST_SHIFT, bucket i counts
+ * samples in the range [2^(i + STAM_HISTOGRAM_FIRST_SHIFT - 1),
+ * 2^(i + STAM_HISTOGRAM_FIRST_SHIFT)), and the last bucket gets everything
+ * that doesn't fit anywhere else.
+ */
+typedef struct STAMHISTOGRAM
+{
+    /** The STAMPROFILE core. */
+    STAMPROFILE         Core;
+    /** The number of samples per bucket. */
+    volatile uint32_t   acBuckets[STAM_HISTOGRAM_BUCKETS];
+} STAMHISTOGRAM;
+/** Pointer to a histogram sample. */
+typedef STAMHISTOGRAM *PSTAMHISTOGRAM;
+/** Pointer to a const histogram sample. */
+typedef const STAMHISTOGRAM *PCSTAMHISTOGRAM;
+
+
+/** @def STAM_HISTOGRAM_BUCKET
+ * Calculates the STAMHISTOGRAM::acBuckets index for a sample.
+ *
+ * @param   cTicks          The sample value.
+ */
+#define STAM_HISTOGRAM_BUCKET(cTicks) \
+    RT_MIN(ASMBitLastSetU64((uint64_t)(cTicks) >> STAM_HISTOGRAM_FIRST_SHIFT), STAM_HISTOGRAM_BUCKETS - 1)
+
+/** @def STAM_REL_HISTOGRAM_ADD_PERIOD
+ * Adds a period to a histogram sample.
+ *
+ * @param   pHistogram      Pointer to the STAMHISTOGRAM structure to operate on.
+ * @param   cTicksInPeriod  The number of tick (or whatever) of the period
+ *                          being added.  This is only referenced once.
+ */
+#ifndef VBOX_WITHOUT_RELEASE_STATISTICS
+# define STAM_REL_HISTOGRAM_ADD_PERIOD(pHistogram, cTicksInPeriod) \
+    do { \
+        uint64_t const StamPrefix_cTicksHist = (cTicksInPeriod); \
+        STAM_REL_PROFILE_ADD_PERIOD(&(pHistogram)->Core, StamPrefix_cTicksHist); \
+        (pHistogram)->acBuckets[STAM_HISTOGRAM_BUCKET(StamPrefix_cTicksHist)]++; \
+    } while (0)
+#else
+# define STAM_REL_HISTOGRAM_ADD_PERIOD(pHistogram, cTicksInPeriod) do { } while (0)
+#endif
+/** @def STAM_HISTOGRAM_ADD_PERIOD
+ * Adds a period to a histogram sample.
+ *
+ * @param   pHistogram      Pointer to the STAMHISTOGRAM structure to operate on.
+ * @param   cTicksInPeriod  The number of tick (or whatever) of the period
+ *                          being added.  This is only referenced once.
+ */
+#ifdef VBOX_WITH_STATISTICS
+# define STAM_HISTOGRAM_ADD_PERIOD(pHistogram, cTicksInPeriod) STAM_REL_HISTOGRAM_ADD_PERIOD(pHistogram, cTicksInPeriod)
+#else
+# define STAM_HISTOGRAM_ADD_PERIOD(pHistogram, cTicksInPeriod) do { } while (0)
+#endif
+
+/** @def STAM_REL_HISTOGRAM_ADD_PERIOD_ATOMIC
+ * Adds a period to a histogram sample, atomically.
+ *
+ * Use this instead of STAM_REL_HISTOGRAM_ADD_PERIOD when the sample is updated
+ * concurrently from several threads (or ring-0 and ring-3), e.g. by I/O
+ * completion callbacks.  It is lock-free and requires iprt/asm.h.
+ *
+ * @param   pHistogram      Pointer to the STAMHISTOGRAM structure to operate on.
+ * @param   cTicksInPeriod  The number of tick (or whatever) of the period
+ *                          being added.  This is only referenced once.
+ */
+#ifndef VBOX_WITHOUT_RELEASE_STATISTICS
+# define STAM_REL_HISTOGRAM_ADD_PERIOD_ATOMIC(pHistogram, cTicksInPeriod) \
+    do { \
+        uint64_t const StamPrefix_cTicksHist = (cTicksInPeriod); \
+        STAMHISTOGRAM * const StamPrefix_pHist = (pHistogram); \
+        ASMAtomicAddU64(&StamPrefix_pHist->Core.cTicks, StamPrefix_cTicksHist); \
+        ASMAtomicIncU64(&StamPrefix_pHist->Core.cPeriods); \
+        uint64_t StamPrefix_uOld = ASMAtomicUoReadU64(&StamPrefix_pHist->Core.cTicksMax); \
+        while (   StamPrefix_uOld < StamPrefix_cTicksHist \
+               && !ASMAtomicCmpXchgExU64(&StamPrefix_pHist->Core.cTicksMax, StamPrefix_cTicksHist, \
+                                         StamPrefix_uOld, &StamPrefix_uOld)) \
+        { /* retry */ } \
+        StamPrefix_uOld = ASMAtomicUoReadU64(&StamPrefix_pHist->Core.cTicksMin); \
+        while (   StamPrefix_uOld > StamPrefix_cTicksHist \
+               && !ASMAtomicCmpXchgExU64(&StamPrefix_pHist->Core.cTicksMin, StamPrefix_cTicksHist, \
+                                         StamPrefix_uOld, &StamPrefix_uOld)) \
+        { /* retry */ } \
+        ASMAtomicIncU32(&StamPrefix_pHist->acBuckets[STAM_HISTOGRAM_BUCKET(StamPrefix_cTicksHist)]); \
+    } while (0)
+#else
+# define STAM_REL_HISTOGRAM_ADD_PERIOD_ATOMIC(pHistogram, cTicksInPeriod) do { } while (0)
+#endif
+/** @def STAM_HISTOGRAM_ADD_PERIOD_ATOMIC
+ * Adds a period to a histogram sample, atomically.
+ *
+ * @param   pHistogram      Pointer to the STAMHISTOGRAM structure to operate on.
+ * @param   cTicksInPeriod  The number of tick (or whatever) of the period
+ *                          being added.  This is only referenced once.
+ */
+#ifdef VBOX_WITH_STATISTICS
+# define STAM_HISTOGRAM_ADD_PERIOD_ATOMIC(pHistogram, cTicksInPeriod) STAM_REL_HISTOGRAM_ADD_PERIOD_ATOMIC(pHistogram, cTicksInPeriod)
+#else
+# define STAM_HISTOGRAM_ADD_PERIOD_ATOMIC(pHistogram, cTicksInPeriod) do { } while (0)
+#endif
+
+
 /**
  * Ratio of A to B, uint32_t types.
  * @remark Use STAM_STATS or STAM_REL_STATS for modifying A & B values.
@@ -1237,6 +1354,109 @@ typedef STAMRATIOU32 *PSTAMRATIOU32;
 typedef const STAMRATIOU32 *PCSTAMRATIOU32;
 
 
+/** @defgroup grp_stam_shm   The STAM Shared Memory Export Layout
+ *
+ * When configured (see STAMR3InitCompleted), STAM periodically publishes the
+ * statistics in a named shared memory region so that external monitoring
+ * tools can sample them without calling into the VM process.
+ *
+ * The region starts with a STAMSHMHDR, followed by the STAMSHMDESC table at
+ * STAMSHMHDR::offDescs, the zero terminated name and description strings at
+ * STAMSHMHDR::offStrings and finally the uint64_t value array at
+ * STAMSHMHDR::offValues.  Everything is protected by the STAMSHMHDR::uSeq
+ * sequence lock: readers must read an even sequence number, copy what they
+ * need out of the region, and retry if the sequence number changed meanwhile.
+ * The layout (everything but the values) only changes when
+ * STAMSHMHDR::uGeneration does, so readers can cache the names and only copy
+ * the values on each sampling.
+ *
+ * The values for each descriptor are stored as follows:
+ *      - STAMTYPE_COUNTER, U8 thru X64 and BOOL: one value.
+ *      - STAMTYPE_PROFILE and STAMTYPE_PROFILE_ADV: cPeriods, cTicks,
+ *        cTicksMin and cTicksMax.
+ *      - STAMTYPE_HISTOGRAM: the profile values followed by the
+ *        STAM_HISTOGRAM_BUCKETS bucket counts.
+ *      - STAMTYPE_RATIO_U32: u32A and u32B.
+ *
+ * Sums are reported as the type of their summands and percent-of-sum samples
+ * as counters.  Callback samples are not exported.
+ * @{
+ */
+
+/** STAMSHMHDR::u32Magic value (David Bowie). */
+#define STAMSHM_MAGIC               UINT32_C(0x19470108)
+/** STAMSHMHDR::u32Version value. */
+#define STAMSHM_VERSION             UINT32_C(0x00010000)
+/** STAMSHMHDR::fFlags: Not all the selected samples fit in the region. */
+#define STAMSHM_F_TRUNCATED         RT_BIT_32(0)
+
+/**
+ * The header of the STAM shared memory export region.
+ */
+typedef struct STAMSHMHDR
+{
+    /** Magic value (STAMSHM_MAGIC). */
+    uint32_t            u32Magic;
+    /** Layout version (STAMSHM_VERSION). */
+    uint32_t            u32Version;
+    /** The sequence lock, odd while the region is being updated. */
+    uint32_t volatile   uSeq;
+    /** The layout generation, incremented whenever the descriptor table and
+     *  strings are rewritten. */
+    uint32_t volatile   uGeneration;
+    /** Number of entries in the descriptor table. */
+    uint32_t            cDescs;
+    /** Number of entries in the value array. */
+    uint32_t            cValues;
+    /** Offset of the descriptor table relative to the start of the region. */
+    uint32_t            offDescs;
+    /** Offset of the string table relative to the start of the region. */
+    uint32_t            offStrings;
+    /** Offset of the value array relative to the start of the region. */
+    uint32_t            offValues;
+    /** Number of bytes of the region in use. */
+    uint32_t            cbUsed;
+    /** Flags, STAMSHM_F_XXX. */
+    uint32_t            fFlags;
+    /** Interval between updates in milliseconds. */
+    uint32_t            cMsInterval;
+    /** RTTimeNanoTS() of the last update. */
+    uint64_t volatile   u64NanoTS;
+} STAMSHMHDR;
+AssertCompileSize(STAMSHMHDR, 56);
+/** Pointer to a STAM shared memory export header. */
+typedef STAMSHMHDR *PSTAMSHMHDR;
+
+/**
+ * A descriptor in the STAM shared memory export table.
+ */
+typedef struct STAMSHMDESC
+{
+    /** Offset of the sample name relative to STAMSHMHDR::offStrings. */
+    uint32_t            offName;
+    /** Offset of the description relative to STAMSHMHDR::offStrings,
+     *  UINT32_MAX if none. */
+    uint32_t            offDesc;
+    /** Index of the first value in the value array. */
+    uint32_t            iValue;
+    /** The sample type (STAMTYPE). */
+    uint8_t             enmType;
+    /** The sample unit (STAMUNIT). */
+    uint8_t             enmUnit;
+    /** The sample visibility (STAMVISIBILITY). */
+    uint8_t             enmVisibility;
+    /** Number of values. */
+    uint8_t             cValues;
+} STAMSHMDESC;
+AssertCompileSize(STAMSHMDESC, 16);
+/** Pointer to a STAM shared memory export descriptor. */
+typedef STAMSHMDESC *PSTAMSHMDESC;
+/** Pointer to a const STAM shared memory export descriptor. */
+typedef STAMSHMDESC const *PCSTAMSHMDESC;
+
+/** @} */
+
+
 
 
 /** @defgroup grp_stam_r3   The STAM Host Context Ring 3 API
@@ -1245,6 +1465,8 @@ typedef const STAMRATIOU32 *PCSTAMRATIOU32;
 
 VMMR3DECL(int)  STAMR3InitUVM(PUVM pUVM);
 VMMR3DECL(void) STAMR3TermUVM(PUVM pUVM);
+VMMR3_INT_DECL(int)  STAMR3InitCompleted(PVM pVM);
+VMMR3_INT_DECL(void) STAMR3Term(PVM pVM);
 VMMR3DECL(int)  STAMR3RegisterU(PUVM pUVM, void *pvSample, STAMTYPE enmType, STAMVISIBILITY enmVisibility,
                                 const char *pszName, STAMUNIT enmUnit, const char *pszDesc);
 VMMR3DECL(int)  STAMR3Register(PVM pVM, void *pvSample, STAMTYPE enmType, STAMVISIBILITY enmVisibility,
@@ -102,6 +102,7 @@ VMMDECL(void)           TMNotifyStartOfExecution(PVMCC pVM, PVMCPUCC pVCpu);
 VMMDECL(void)           TMNotifyEndOfExecution(PVMCC pVM, PVMCPUCC pVCpu, uint64_t uTsc);
 VMM_INT_DECL(void)      TMNotifyStartOfHalt(PVMCPUCC pVCpu);
 VMM_INT_DECL(void)      TMNotifyEndOfHalt(PVMCPUCC pVCpu);
+VMM_INT_DECL(void)      TMNotifyRing0Halt(PVMCPUCC pVCpu, uint64_t cNsHalted);
 #ifdef IN_RING3
 VMMR3DECL(int)          TMR3NotifySuspend(PVM pVM, PVMCPU pVCpu);
 VMMR3DECL(int)          TMR3NotifyResume(PVM pVM, PVMCPU pVCpu);
@@ -168,6 +169,7 @@ VMM_INT_DECL(uint64_t)  TMCpuTickGetDeadlineAndTscOffset(PVMCC pVM, PVMCPUCC pVC
 VMM_INT_DECL(int)       TMCpuTickSet(PVMCC pVM, PVMCPUCC pVCpu, uint64_t u64Tick);
 VMM_INT_DECL(int)       TMCpuTickSetLastSeen(PVMCPUCC pVCpu, uint64_t u64LastSeenTick);
 VMM_INT_DECL(uint64_t)  TMCpuTickGetLastSeen(PVMCPUCC pVCpu);
+VMM_INT_DECL(uint64_t)  TMCpuGetStealTime(PVMCPUCC pVCpu);
 VMMDECL(uint64_t)       TMCpuTicksPerSecond(PVMCC pVM);
 VMM_INT_DECL(bool)      TMCpuTickIsTicking(PVMCPUCC pVCpu);
 
@@ -303,11 +305,14 @@ VMMR3DECL(int)          TMR3TimerSkip(PSSMHANDLE pSSM, bool *pfActive);
 VMMR3DECL(int)          TMR3TimerSetCritSect(PVMCC pVM, TMTIMERHANDLE hTimer, PPDMCRITSECT pCritSect);
 VMMR3DECL(void)         TMR3TimerQueuesDo(PVM pVM);
 VMMR3_INT_DECL(void)    TMR3VirtualSyncFF(PVM pVM, PVMCPU pVCpu);
+VMMR3_INT_DECL(void)    TMR3CpuHotUnplug(PVM pVM, PVMCPU pVCpu);
 VMMR3_INT_DECL(PRTTIMESPEC) TMR3UtcNow(PVM pVM, PRTTIMESPEC pTime);
 
 VMMR3_INT_DECL(int)     TMR3CpuTickParavirtEnable(PVM pVM);
 VMMR3_INT_DECL(int)     TMR3CpuTickParavirtDisable(PVM pVM);
 VMMR3_INT_DECL(bool)    TMR3CpuTickIsFixedRateMonotonic(PVM pVM, bool fWithParavirtEnabled);
+VMMR3_INT_DECL(bool)    TMR3CpuUpdateStealTime(PVM pVM, PVMCPU pVCpu);
+VMMR3_INT_DECL(uint64_t) TMR3CpuGetRunTime(PVM pVM, PVMCPU pVCpu);
 /** @} */
 
 
@@ -144,7 +144,7 @@ typedef struct UVM
 #ifdef VMM_INCLUDED_SRC_include_STAMInternal_h
         struct STAMUSERPERVM    s;
 #endif
-        uint8_t                 padding[30208];
+        uint8_t                 padding[30720];
     } stam;
 
     /** The DBGF data. */
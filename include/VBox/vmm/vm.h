@@ -167,6 +167,7 @@ typedef struct VMCPU
         struct IEMCPU       s;
 #endif
         uint8_t             padding[  129984    /* The common base size. */
+                                    + 16384     /* For the two large page L2 TLBs. */
 #ifdef RT_ARCH_AMD64
                                     + 32768     /* For 256 entries per TLBs. */
 #else
@@ -216,7 +217,11 @@ typedef struct VMCPU
 #ifdef VMM_INCLUDED_SRC_include_HMInternal_h
         struct HMCPU    s;
 #endif
-        uint8_t             padding[9984];      /* multiple of 64 */
+        uint8_t             padding[  9984      /* multiple of 64 */
+#ifdef VBOX_WITH_STATISTICS
+                                    + 81920     /* For the exit latency histograms (multiple of 16384). */
+#endif
+        ];
     } hm;
 
     /** NEM part. */
@@ -243,7 +248,7 @@ typedef struct VMCPU
 #ifdef VMM_INCLUDED_SRC_include_TMInternal_h
         struct TMCPU        s;
 #endif
-        uint8_t             padding[5760];      /* multiple of 64 */
+        uint8_t             padding[5824];      /* multiple of 64 */
     } tm;
 
     /** VMM part. */
@@ -334,7 +339,7 @@ typedef struct VMCPU
     STAMPROFILEADV          aStatAdHoc[8];                          /* size: 40*8 = 320 */
 
     /** Align the following members on page boundary. */
-    uint8_t                 abAlignment2[1848];
+    uint8_t                 abAlignment2[1784];
 
     /** PGM part. */
     union VMCPUUNIONPGM
@@ -1520,7 +1525,7 @@ typedef struct VM
 #ifdef VMM_INCLUDED_SRC_include_PDMInternal_h
         struct PDM s;
 #endif
-        uint8_t     padding[22784];     /* multiple of 64 */
+        uint8_t     padding[24768];     /* multiple of 64 */
     } pdm;
 
     /** IOM part. */
@@ -1690,7 +1695,7 @@ typedef struct VM
     } gcm;
 
     /** Padding for aligning the structure size on a page boundrary. */
-    uint8_t         abAlignment2[0x3900 - sizeof(PVMCPUR3) * VMM_MAX_CPU_COUNT];
+    uint8_t         abAlignment2[0x3140 - sizeof(PVMCPUR3) * VMM_MAX_CPU_COUNT];
 
     /* ---- end small stuff ---- */
 
@@ -327,6 +327,8 @@ typedef enum VMMR0OPERATION
     VMMR0_DO_GMM_CHECK_SHARED_MODULES,
     /** Call GMMR0FindDuplicatePage. */
     VMMR0_DO_GMM_FIND_DUPLICATE_PAGE,
+    /** Call GMMR0ScanDuplicatePagesReq. */
+    VMMR0_DO_GMM_SCAN_DUPLICATE_PAGES,
     /** Call GMMR0QueryStatistics(). */
     VMMR0_DO_GMM_QUERY_STATISTICS,
     /** Call GMMR0ResetStatistics(). */
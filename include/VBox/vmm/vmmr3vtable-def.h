@@ -539,7 +539,7 @@ VTABLE_ENTRY(DBGFR3TypeSetSize)
 VTABLE_ENTRY(DBGFR3TypeValFree)
 VTABLE_ENTRY(DBGFR3TypeValDumpEx)
 
-VTABLE_RESERVED(pfnDBGFR3Reserved1)
+VTABLE_ENTRY(DBGFR3SampleReportDumpFoldedToFile)
 VTABLE_RESERVED(pfnDBGFR3Reserved2)
 VTABLE_RESERVED(pfnDBGFR3Reserved3)
 VTABLE_RESERVED(pfnDBGFR3Reserved4)
@@ -667,9 +667,9 @@ VTABLE_RESERVED(pfnPGMR3Reserved0)
 VTABLE_ENTRY(PGMR3QueryGlobalMemoryStats)
 VTABLE_ENTRY(PGMR3QueryMemoryStats)
 
-VTABLE_RESERVED(pfnPGMR3Reserved1)
-VTABLE_RESERVED(pfnPGMR3Reserved2)
-VTABLE_RESERVED(pfnPGMR3Reserved3)
+VTABLE_ENTRY(PGMR3PhysPostCopyEnable)
+VTABLE_ENTRY(PGMR3PhysPostCopyRead)
+VTABLE_ENTRY(PGMR3PhysPostCopySetFetcher)
 VTABLE_RESERVED(pfnPGMR3Reserved4)
 VTABLE_RESERVED(pfnPGMR3Reserved5)
 /** @} */
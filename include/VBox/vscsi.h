@@ -89,6 +89,8 @@ typedef enum VSCSIIOREQTXDIR
     VSCSIIOREQTXDIR_FLUSH,
     /** Unmap */
     VSCSIIOREQTXDIR_UNMAP,
+    /** Write zeroes */
+    VSCSIIOREQTXDIR_WRITE_ZEROES,
     /** 32bit hack */
     VSCSIIOREQTXDIR_32BIT_HACK = 0x7fffffff
 } VSCSIIOREQTXDIR;
@@ -141,6 +143,8 @@ typedef VSCSILUNTYPE *PVSCSILUNTYPE;
 #define VSCSI_LUN_FEATURE_NON_ROTATIONAL RT_BIT(1)
 /** The medium of the LUN is readonly. */
 #define VSCSI_LUN_FEATURE_READONLY       RT_BIT(2)
+/** The LUN can zero ranges without transferring any data. */
+#define VSCSI_LUN_FEATURE_WRITE_ZEROES   RT_BIT(3)
 
 /**
  * Virtual SCSI LUN I/O Callback table.
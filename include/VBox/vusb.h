@@ -42,6 +42,8 @@
 #include <VBox/cdefs.h>
 #include <VBox/types.h>
 #include <iprt/assert.h>
+#include <iprt/sg.h>
+#include <iprt/string.h>
 
 struct PDMLED;
 
@@ -1456,11 +1458,45 @@ typedef struct VUSBURB
      * IN: On host to device transfers, the data to be sent.
      * OUT: On device to host transfers, the data to be received. */
     uint8_t         *pbData;
+    /** Number of segments in paGuestSegs, zero if the data to send is in pbData.
+     * IN: Optional, only used for bulk OUT transfers. */
+    uint32_t        cGuestSegs;
+    /** Scatter/gather list describing the data to send in mapped guest memory.
+     * IN: When cGuestSegs is not zero the data is only described by these
+     *     segments and pbData was not filled in. The HCI keeps the memory
+     *     mapped until the URB completes (cancellation included), the device
+     *     must not access the segments afterwards. Devices without
+     *     PDM_USBREG_GUEST_SG_URBS never see this, VUSB copies the data into
+     *     pbData for them. */
+    PCRTSGSEG       paGuestSegs;
 } VUSBURB;
 
 /** The magic value of a valid VUSBURB. (Murakami Haruki) */
 #define VUSBURB_MAGIC       UINT32_C(0x19490112)
 
+/**
+ * Copies the data described by VUSBURB::paGuestSegs into the URB buffer
+ * and drops the scatter/gather list.
+ *
+ * This is for consumers which can't deal with the guest memory segments.
+ *
+ * @param   pUrb    The URB.
+ */
+DECLINLINE(void) VUSBUrbGuestSegsToData(PVUSBURB pUrb)
+{
+    uint32_t offData = 0;
+    for (uint32_t i = 0; i < pUrb->cGuestSegs && offData < pUrb->cbData; i++)
+    {
+        size_t const cbSeg = RT_MIN(pUrb->paGuestSegs[i].cbSeg, pUrb->cbData - offData);
+        /* The HCI may have placed parts of the data into the URB buffer already. */
+        if (pUrb->paGuestSegs[i].pvSeg != &pUrb->pbData[offData])
+            memcpy(&pUrb->pbData[offData], pUrb->paGuestSegs[i].pvSeg, cbSeg);
+        offData += (uint32_t)cbSeg;
+    }
+    pUrb->cGuestSegs  = 0;
+    pUrb->paGuestSegs = NULL;
+}
+
 /** @} */
 
 
@@ -0,0 +1,191 @@
+/** @file
+ * IPRT - B+Trees.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+#ifndef IPRT_INCLUDED_btree_h
+#define IPRT_INCLUDED_btree_h
+#ifndef RT_WITHOUT_PRAGMA_ONCE
+# pragma once
+#endif
+
+#include <iprt/cdefs.h>
+#include <iprt/types.h>
+
+RT_C_DECLS_BEGIN
+
+/** @defgroup grp_rt_btree      RTBTree - B+Trees
+ * @ingroup grp_rt
+ *
+ * A B+tree of non-overlapping uint64_t key ranges mapping to user pointers.
+ *
+ * This complements the AVL tree family (see @ref grp_rt_avl) for hot lookups on
+ * large sets.  The nodes hold many keys each in flat arrays and the leaves are
+ * linked, so a lookup touches a handful of cache lines instead of one node per
+ * tree level and enumerating is a linear walk.  Unlike the AVL trees the nodes
+ * are allocated by the tree, the caller only provides the value pointer.
+ *
+ * The operations mirror the AVL range trees (RTAvlrU64XXX): exact get, range
+ * get, best fit and enumeration.  Single keys are ranges with uKey == uKeyLast.
+ *
+ * There is no serialization, the caller is responsible for that.
+ *
+ * @{
+ */
+
+/** B+tree handle. */
+typedef struct RTBTREEU64INT   *RTBTREEU64;
+/** Pointer to a B+tree handle. */
+typedef RTBTREEU64             *PRTBTREEU64;
+/** NIL B+tree handle. */
+#define NIL_RTBTREEU64          ((RTBTREEU64)0)
+
+/**
+ * Callback for RTBTreeU64DoWithAll and RTBTreeU64Destroy.
+ *
+ * @returns IPRT status code.  Any status other than VINF_SUCCESS aborts
+ *          RTBTreeU64DoWithAll and is returned by it, it is ignored by
+ *          RTBTreeU64Destroy.
+ * @param   uKey            The first key of the range.
+ * @param   uKeyLast        The last key of the range (inclusive).
+ * @param   pvValue         The value.
+ * @param   pvUser          The user argument.
+ */
+typedef DECLCALLBACKTYPE(int, FNRTBTREEU64CALLBACK,(uint64_t uKey, uint64_t uKeyLast, void *pvValue, void *pvUser));
+/** Pointer to a B+tree callback. */
+typedef FNRTBTREEU64CALLBACK *PFNRTBTREEU64CALLBACK;
+
+/**
+ * Creates an empty B+tree.
+ *
+ * @returns IPRT status code.
+ * @param   phTree          Where to return the tree handle.
+ */
+RTDECL(int)      RTBTreeU64Create(PRTBTREEU64 phTree);
+
+/**
+ * Destroys a B+tree.
+ *
+ * @returns IPRT status code.
+ * @param   hTree           The tree handle, NIL is quietly ignored.
+ * @param   pfnCallback     Optional callback to call for each value before
+ *                          the tree is freed, e.g. to free the values.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(int)      RTBTreeU64Destroy(RTBTREEU64 hTree, PFNRTBTREEU64CALLBACK pfnCallback, void *pvUser);
+
+/**
+ * Inserts a key range.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_ALREADY_EXISTS if the range overlaps an existing one.
+ * @retval  VERR_NO_MEMORY
+ * @param   hTree           The tree handle.
+ * @param   uKey            The first key of the range.
+ * @param   uKeyLast        The last key of the range (inclusive).
+ * @param   pvValue         The value to associate with the range.
+ */
+RTDECL(int)      RTBTreeU64Insert(RTBTREEU64 hTree, uint64_t uKey, uint64_t uKeyLast, void *pvValue);
+
+/**
+ * Removes the range starting at the given key.
+ *
+ * @returns The value of the removed range, NULL if not found.
+ * @param   hTree           The tree handle.
+ * @param   uKey            The first key of the range to remove.
+ */
+RTDECL(void *)   RTBTreeU64Remove(RTBTREEU64 hTree, uint64_t uKey);
+
+/**
+ * Gets the value of the range starting at the given key.
+ *
+ * @returns The value, NULL if not found.
+ * @param   hTree           The tree handle.
+ * @param   uKey            The first key of the range.
+ */
+RTDECL(void *)   RTBTreeU64Get(RTBTREEU64 hTree, uint64_t uKey);
+
+/**
+ * Gets the value of the range containing the given key.
+ *
+ * @returns The value, NULL if no range contains the key.
+ * @param   hTree           The tree handle.
+ * @param   uKey            The key to look up.
+ * @param   puKey           Where to return the first key of the range. Optional.
+ * @param   puKeyLast       Where to return the last key of the range. Optional.
+ */
+RTDECL(void *)   RTBTreeU64RangeGet(RTBTREEU64 hTree, uint64_t uKey, uint64_t *puKey, uint64_t *puKeyLast);
+
+/**
+ * Gets the value of the range starting closest to the given key.
+ *
+ * @returns The value, NULL if there is no such range.
+ * @param   hTree           The tree handle.
+ * @param   uKey            The key to look up.
+ * @param   fAbove          false: the range with the largest first key less or
+ *                          equal to @a uKey;
+ *                          true: the range with the smallest first key greater
+ *                          or equal to @a uKey.
+ * @param   puKey           Where to return the first key of the range. Optional.
+ * @param   puKeyLast       Where to return the last key of the range. Optional.
+ */
+RTDECL(void *)   RTBTreeU64GetBestFit(RTBTREEU64 hTree, uint64_t uKey, bool fAbove, uint64_t *puKey, uint64_t *puKeyLast);
+
+/**
+ * Calls the callback for each range in key order.
+ *
+ * The tree must not be modified by the callback.
+ *
+ * @returns IPRT status code, the first one other than VINF_SUCCESS returned by
+ *          the callback.
+ * @param   hTree           The tree handle.
+ * @param   fFromLeft       true: ascending order; false: descending order.
+ * @param   pfnCallback     The callback.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(int)      RTBTreeU64DoWithAll(RTBTREEU64 hTree, bool fFromLeft, PFNRTBTREEU64CALLBACK pfnCallback, void *pvUser);
+
+/**
+ * Gets the number of ranges in the tree.
+ *
+ * @returns Number of ranges, 0 if the handle is invalid.
+ * @param   hTree           The tree handle.
+ */
+RTDECL(uint32_t) RTBTreeU64GetCount(RTBTREEU64 hTree);
+
+/** @} */
+
+RT_C_DECLS_END
+
+#endif /* !IPRT_INCLUDED_btree_h */
+
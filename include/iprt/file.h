@@ -723,7 +723,7 @@ RTDECL(int) RTFileCopyByHandlesEx(RTFILE FileSrc, RTFILE FileDst, PFNRTPROGRESS
  *                      RTFILE_O_APPEND must be be in effect.
  * @param   offDst      The destination file offset.
  * @param   cbToCopy    How many bytes to copy.
- * @param   fFlags      Reserved for the future, must be zero.
+ * @param   fFlags      RTFILECOPYPARTEX_F_XXX.
  * @param   pcbCopied   Where to return the exact number of bytes copied.
  *                      Optional.
  *
@@ -736,6 +736,16 @@ RTDECL(int) RTFileCopyPart(RTFILE hFileSrc, RTFOFF offSrc, RTFILE hFileDst, RTFO
                            uint32_t fFlags, uint64_t *pcbCopied);
 
 
+/** @name RTFILECOPYPARTEX_F_XXX - Flags for RTFileCopyPart and RTFileCopyPartEx.
+ * @{ */
+/** Skip source ranges which are holes or read as zeros instead of writing
+ * them.  The caller must make sure the destination range already reads as
+ * zeros, e.g. because the file was just extended to its final size. */
+#define RTFILECOPYPARTEX_F_SKIP_HOLES       RT_BIT_32(0)
+/** Valid flags mask. */
+#define RTFILECOPYPARTEX_F_VALID_MASK       UINT32_C(0x00000001)
+/** @} */
+
 /** Copy buffer state for RTFileCopyPartEx.
  * @note The fields are considered internal!
  */
@@ -796,7 +806,7 @@ RTDECL(void) RTFileCopyPartCleanup(PRTFILECOPYPARTBUFSTATE pBufState);
  *                      RTFILE_O_APPEND must be be in effect.
  * @param   offDst      The destination file offset.
  * @param   cbToCopy    How many bytes to copy.
- * @param   fFlags      Reserved for the future, must be zero.
+ * @param   fFlags      RTFILECOPYPARTEX_F_XXX.
  * @param   pBufState   Copy buffer state prepared by RTFileCopyPartPrep().
  * @param   pcbCopied   Where to return the exact number of bytes copied.
  *                      Optional.
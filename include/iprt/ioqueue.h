@@ -61,9 +61,9 @@ typedef enum RTIOQUEUEOP
 {
     /** The usual invalid option. */
     RTIOQUEUEOP_INVALID = 0,
-    /** Read request. */
+    /** Read request, receives data for socket handles. */
     RTIOQUEUEOP_READ,
-    /** Write request. */
+    /** Write request, sends data for socket handles. */
     RTIOQUEUEOP_WRITE,
     /** Synchronize (i.e. flush) request. */
     RTIOQUEUEOP_SYNC,
@@ -165,6 +165,27 @@ typedef struct RTIOQUEUEPROVVTABLE
      */
     DECLCALLBACKMEMBER(int, pfnHandleDeregister,(RTIOQUEUEPROV hIoQueueProv, PCRTHANDLE pHandle));
 
+    /**
+     * Registers the given buffer for use with the I/O queue instance, optional.
+     * The generic code already checked that there are no requests in flight.
+     *
+     * @returns IPRT status code.
+     * @param   hIoQueueProv    The I/O queue provider instance.
+     * @param   pvBuf           Start of the buffer to register.
+     * @param   cbBuf           Size of the buffer in bytes.
+     */
+    DECLCALLBACKMEMBER(int, pfnBufferRegister,(RTIOQUEUEPROV hIoQueueProv, void *pvBuf, size_t cbBuf));
+
+    /**
+     * Deregisters the given buffer from the I/O queue instance, optional.
+     * The generic code already checked that there are no requests in flight.
+     *
+     * @returns IPRT status code.
+     * @param   hIoQueueProv    The I/O queue provider instance.
+     * @param   pvBuf           Start of the buffer as given during registration.
+     */
+    DECLCALLBACKMEMBER(int, pfnBufferDeregister,(RTIOQUEUEPROV hIoQueueProv, void *pvBuf));
+
     /**
      * Prepares a request for the given I/O queue.
      *
@@ -238,7 +259,7 @@ typedef RTIOQUEUEPROVVTABLE *PRTIOQUEUEPROVVTABLE;
 typedef RTIOQUEUEPROVVTABLE const *PCRTIOQUEUEPROVVTABLE;
 
 /** The RTIOQUEUEPROVVTABLE structure version. */
-#define RTIOQUEUEPROVVTABLE_VERSION    RT_MAKE_U32_FROM_U8(0xff,0xf,1,0)
+#define RTIOQUEUEPROVVTABLE_VERSION    RT_MAKE_U32_FROM_U8(0xff,0xf,2,0)
 
 /** @name RTIOQUEUEPROVVTABLE::fFlags
  * @{ */
@@ -249,6 +270,17 @@ typedef RTIOQUEUEPROVVTABLE const *PCRTIOQUEUEPROVVTABLE;
 /** @}  */
 
 
+/** @name RTIoQueueCreate flags
+ * @{ */
+/** Let the host submit requests from a polling kernel thread (io_uring SQPOLL) if
+ * supported so committing requests doesn't require a syscall in the common case.
+ * Providers without support for it silently ignore the flag. */
+#define RTIOQUEUE_F_SQPOLL                  RT_BIT_32(0)
+/** Mask of the valid I/O queue flags. */
+#define RTIOQUEUE_F_VALID_MASK              UINT32_C(0x00000001)
+/** @}  */
+
+
 /**
  * Tries to return the best I/O queue provider for the given handle type on the called
  * host system.
@@ -276,7 +308,7 @@ RTDECL(PCRTIOQUEUEPROVVTABLE) RTIoQueueProviderGetById(const char *pszId);
  * @returns IPRT status code.
  * @param   phIoQueue           Where to store the handle to the I/O queue on success.
  * @param   pProvVTable         The I/O queue provider vtable which will process the requests.
- * @param   fFlags              Flags for the queue (MBZ for now).
+ * @param   fFlags              Flags for the queue, see RTIOQUEUE_F_XXX.
  * @param   cSqEntries          Number of entries for the submission queue.
  * @param   cCqEntries          Number of entries for the completion queue.
  *
@@ -322,6 +354,38 @@ RTDECL(int) RTIoQueueHandleRegister(RTIOQUEUE hIoQueue, PCRTHANDLE pHandle);
 RTDECL(int) RTIoQueueHandleDeregister(RTIOQUEUE hIoQueue, PCRTHANDLE pHandle);
 
 
+/**
+ * Registers the given buffer with the I/O queue.
+ *
+ * Read and write requests whose buffer lies completely within a registered buffer
+ * can be processed more efficiently by some providers (e.g. io_uring which doesn't
+ * need to map the pages for every request then). Registering buffers is a hint only,
+ * providers without support for it succeed without doing anything.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_IOQUEUE_BUSY if there are requests in flight.
+ * @retval  VERR_OUT_OF_RESOURCES if the provider can't register more buffers.
+ * @param   hIoQueue            The I/O queue handle.
+ * @param   pvBuf               Start of the buffer to register.
+ * @param   cbBuf               Size of the buffer in bytes.
+ *
+ * @note The buffer must stay valid until it is deregistered or the queue is destroyed.
+ */
+RTDECL(int) RTIoQueueBufferRegister(RTIOQUEUE hIoQueue, void *pvBuf, size_t cbBuf);
+
+
+/**
+ * Deregisters the given buffer from the I/O queue.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_IOQUEUE_BUSY if there are requests in flight.
+ * @retval  VERR_NOT_FOUND if the buffer wasn't registered.
+ * @param   hIoQueue            The I/O queue handle.
+ * @param   pvBuf               Start of the buffer as given to RTIoQueueBufferRegister().
+ */
+RTDECL(int) RTIoQueueBufferDeregister(RTIOQUEUE hIoQueue, void *pvBuf);
+
+
 /**
  * Prepares a request for the given I/O queue.
  *
@@ -156,6 +156,135 @@ RTDECL(int) RTJsonParseFromFile(PRTJSONVAL phJsonVal, uint32_t fFlags, const cha
  */
 RTDECL(int) RTJsonParseFromVfsFile(PRTJSONVAL phJsonVal, uint32_t fFlags, RTVFSFILE hVfsFile, PRTERRINFO pErrInfo);
 
+/**
+ * JSON parser events, see FNRTJSONEVENT.
+ */
+typedef enum RTJSONEVT
+{
+    /** Invalid first value. */
+    RTJSONEVT_INVALID = 0,
+    /** Start of an object, members follow as key/value event pairs. */
+    RTJSONEVT_BEGIN_OBJECT,
+    /** End of the current object. */
+    RTJSONEVT_END_OBJECT,
+    /** Start of an array, the items follow as value events. */
+    RTJSONEVT_BEGIN_ARRAY,
+    /** End of the current array. */
+    RTJSONEVT_END_ARRAY,
+    /** Object member name, RTJSONEVTDATA::u.Str is valid. */
+    RTJSONEVT_KEY,
+    /** String value, RTJSONEVTDATA::u.Str is valid. */
+    RTJSONEVT_STRING,
+    /** Integer value, RTJSONEVTDATA::u.i64Num is valid. */
+    RTJSONEVT_INTEGER,
+    /** Floating point value, RTJSONEVTDATA::u.rdNum is valid. */
+    RTJSONEVT_NUMBER,
+    /** The null value. */
+    RTJSONEVT_NULL,
+    /** The true value. */
+    RTJSONEVT_TRUE,
+    /** The false value. */
+    RTJSONEVT_FALSE,
+    /** 32-bit hack. */
+    RTJSONEVT_32BIT_HACK = 0x7fffffff
+} RTJSONEVT;
+
+/**
+ * Data accompanying a JSON parser event.
+ */
+typedef struct RTJSONEVTDATA
+{
+    /** The nesting depth of the event, 0 for the root value. */
+    uint32_t                cDepth;
+    /** Event specific data. */
+    union
+    {
+        /** RTJSONEVT_KEY and RTJSONEVT_STRING. */
+        struct
+        {
+            /** The decoded, zero terminated string.  This is a parser owned
+             * buffer which is only valid for the duration of the callback. */
+            const char     *psz;
+            /** The length of the string. */
+            size_t          cch;
+        } Str;
+        /** RTJSONEVT_INTEGER. */
+        int64_t             i64Num;
+        /** RTJSONEVT_NUMBER. */
+        double              rdNum;
+    } u;
+} RTJSONEVTDATA;
+/** Pointer to const JSON parser event data. */
+typedef const RTJSONEVTDATA *PCRTJSONEVTDATA;
+
+/**
+ * JSON parser event callback.
+ *
+ * @returns IPRT status code.  Any status other than VINF_SUCCESS stops the
+ *          parsing and is passed back to the caller, VINF_CALLBACK_RETURN can be
+ *          used to stop early without indicating a failure.
+ * @param   pvUser          The user argument given to RTJsonParseEventsFromXxx.
+ * @param   enmEvt          The event.
+ * @param   pData           The event data.
+ */
+typedef DECLCALLBACKTYPE(int, FNRTJSONEVENT,(void *pvUser, RTJSONEVT enmEvt, PCRTJSONEVTDATA pData));
+/** Pointer to a JSON parser event callback. */
+typedef FNRTJSONEVENT *PFNRTJSONEVENT;
+
+/**
+ * Parses a JSON document in the provided buffer, reporting the content as a
+ * sequence of events instead of building a value tree.
+ *
+ * This does not allocate anything per value, strings and keys are decoded
+ * into a single parser owned buffer which is reused for the next token.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_JSON_MALFORMED if the document does not conform to the spec.
+ * @param   fFlags          Combination of RTJSON_PARSE_F_XXX.
+ * @param   pbBuf           The byte buffer containing the JSON document.
+ * @param   cbBuf           Size of the buffer.
+ * @param   pfnEvent        The event callback.
+ * @param   pvUser          User argument for the callback.
+ * @param   pErrInfo        Where to store extended error info. Optional.
+ */
+RTDECL(int) RTJsonParseEventsFromBuf(uint32_t fFlags, const uint8_t *pbBuf, size_t cbBuf,
+                                     PFNRTJSONEVENT pfnEvent, void *pvUser, PRTERRINFO pErrInfo);
+
+/**
+ * Parses a JSON document from the provided string, reporting the content as a
+ * sequence of events.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_JSON_MALFORMED if the document does not conform to the spec.
+ * @param   fFlags          Combination of RTJSON_PARSE_F_XXX.
+ * @param   pszStr          The string containing the JSON document.
+ * @param   pfnEvent        The event callback.
+ * @param   pvUser          User argument for the callback.
+ * @param   pErrInfo        Where to store extended error info. Optional.
+ * @sa      RTJsonParseEventsFromBuf
+ */
+RTDECL(int) RTJsonParseEventsFromString(uint32_t fFlags, const char *pszStr,
+                                        PFNRTJSONEVENT pfnEvent, void *pvUser, PRTERRINFO pErrInfo);
+
+/**
+ * Parses a JSON document from the given VFS file, reporting the content as a
+ * sequence of events.
+ *
+ * The file is read incrementally, so memory usage does not depend on the size
+ * of the document.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_JSON_MALFORMED if the document does not conform to the spec.
+ * @param   fFlags          Combination of RTJSON_PARSE_F_XXX.
+ * @param   hVfsFile        The VFS file to parse.
+ * @param   pfnEvent        The event callback.
+ * @param   pvUser          User argument for the callback.
+ * @param   pErrInfo        Where to store extended error info. Optional.
+ * @sa      RTJsonParseEventsFromBuf
+ */
+RTDECL(int) RTJsonParseEventsFromVfsFile(uint32_t fFlags, RTVFSFILE hVfsFile,
+                                         PFNRTJSONEVENT pfnEvent, void *pvUser, PRTERRINFO pErrInfo);
+
 /**
  * Retain a given JSON value.
  *
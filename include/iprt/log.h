@@ -2959,6 +2959,96 @@ RTDECL(void) RTLogWriteStdOut(const char *pach, size_t cb);
  */
 RTDECL(void) RTLogWriteStdErr(const char *pach, size_t cb);
 
+
+#ifdef IN_RING3
+/** @defgroup grp_rt_log_async  Asynchronous Log Output
+ *
+ * A file output interface (RTLOGOUTPUTIF) which takes the actual file writes
+ * off the logging thread.  Output is copied into a ring buffer and written by
+ * a dedicated writer thread, so EMTs and I/O workers don't stall on a slow log
+ * disk.  Only when a burst exceeds the ring buffer will the logging thread
+ * write synchronously, preserving the ordering of the output.
+ *
+ * An optional byte rate limit makes the sink drop output exceeding the budget
+ * instead of writing it, noting the amount dropped in the log.
+ *
+ * @{ */
+
+/** Asynchronous log output handle. */
+typedef struct RTLOGASYNCOUTPUTINT *RTLOGASYNCOUTPUT;
+/** Pointer to an asynchronous log output handle. */
+typedef RTLOGASYNCOUTPUT *PRTLOGASYNCOUTPUT;
+/** Nil asynchronous log output handle. */
+#define NIL_RTLOGASYNCOUTPUT                    ((RTLOGASYNCOUTPUT)0)
+
+/** Default ring buffer size. */
+#define RTLOGASYNCOUTPUT_DEFAULT_BUFFER_SIZE    _1M
+
+/**
+ * Creates an asynchronous log output instance.
+ *
+ * Pass the interface returned by RTLogAsyncOutputGetIf() together with the
+ * handle as the user argument to RTLogCreateEx() and friends.
+ *
+ * @returns IPRT status code.
+ * @param   phAsync         Where to return the handle.
+ * @param   pLowerIf        The output interface doing the actual file I/O, NULL
+ *                          for plain RTFile access.
+ * @param   pvLowerUser     The user argument for @a pLowerIf.
+ * @param   cbBuffer        The ring buffer size, 0 for the default.  Rounded
+ *                          up to a power of two.
+ * @param   cbMaxPerSec     Maximum number of bytes to write per second, output
+ *                          exceeding it is dropped.  0 means no limit.
+ */
+RTDECL(int) RTLogAsyncOutputCreate(PRTLOGASYNCOUTPUT phAsync, PCRTLOGOUTPUTIF pLowerIf, void *pvLowerUser,
+                                   size_t cbBuffer, uint32_t cbMaxPerSec);
+
+/**
+ * Destroys an asynchronous log output instance.
+ *
+ * The logger using it must have been destroyed (or switched to a different
+ * output) first.  Pending output is written before returning.
+ *
+ * @returns IPRT status code.
+ * @param   hAsync          The handle.  NIL is quietly ignored.
+ */
+RTDECL(int) RTLogAsyncOutputDestroy(RTLOGASYNCOUTPUT hAsync);
+
+/**
+ * Gets the output interface to pass to the logger.
+ *
+ * @returns Pointer to the output interface, the user argument is the handle.
+ */
+RTDECL(PCRTLOGOUTPUTIF) RTLogAsyncOutputGetIf(void);
+
+/**
+ * Synchronously writes all pending output and flushes the file.
+ *
+ * @returns IPRT status code.
+ * @param   hAsync          The handle.
+ */
+RTDECL(int) RTLogAsyncOutputFlush(RTLOGASYNCOUTPUT hAsync);
+
+/**
+ * Synchronously writes the pending output of all instances.
+ *
+ * Meant for fatal error and assertion paths which must get everything into the
+ * log file before the process goes away.  Does nothing when there are no
+ * instances.
+ */
+RTDECL(void) RTLogAsyncOutputFlushAll(void);
+
+/**
+ * Gets the number of bytes dropped because of the rate limit.
+ *
+ * @returns Byte count, 0 for an invalid handle.
+ * @param   hAsync          The handle.
+ */
+RTDECL(uint64_t) RTLogAsyncOutputGetDropped(RTLOGASYNCOUTPUT hAsync);
+
+/** @} */
+#endif /* IN_RING3 */
+
 #ifdef VBOX
 
 /**
@@ -692,6 +692,15 @@
 # define RTBldCfgVersionBuild                           RT_MANGLER(RTBldCfgVersionBuild)
 # define RTBldCfgVersionMajor                           RT_MANGLER(RTBldCfgVersionMajor)
 # define RTBldCfgVersionMinor                           RT_MANGLER(RTBldCfgVersionMinor)
+# define RTBTreeU64Create                               RT_MANGLER(RTBTreeU64Create)
+# define RTBTreeU64Destroy                              RT_MANGLER(RTBTreeU64Destroy)
+# define RTBTreeU64DoWithAll                            RT_MANGLER(RTBTreeU64DoWithAll)
+# define RTBTreeU64Get                                  RT_MANGLER(RTBTreeU64Get)
+# define RTBTreeU64GetBestFit                           RT_MANGLER(RTBTreeU64GetBestFit)
+# define RTBTreeU64GetCount                             RT_MANGLER(RTBTreeU64GetCount)
+# define RTBTreeU64Insert                               RT_MANGLER(RTBTreeU64Insert)
+# define RTBTreeU64RangeGet                             RT_MANGLER(RTBTreeU64RangeGet)
+# define RTBTreeU64Remove                               RT_MANGLER(RTBTreeU64Remove)
 # define RTCdromOpen                                    RT_MANGLER(RTCdromOpen)
 # define RTCdromRetain                                  RT_MANGLER(RTCdromRetain)
 # define RTCdromRelease                                 RT_MANGLER(RTCdromRelease)
@@ -1347,6 +1356,8 @@
 # define RTIniFileRelease                               RT_MANGLER(RTIniFileRelease)
 # define RTIniFileQueryPair                             RT_MANGLER(RTIniFileQueryPair)
 # define RTIniFileQueryValue                            RT_MANGLER(RTIniFileQueryValue)
+# define RTIoQueueBufferDeregister                      RT_MANGLER(RTIoQueueBufferDeregister)
+# define RTIoQueueBufferRegister                        RT_MANGLER(RTIoQueueBufferRegister)
 # define RTIoQueueCommit                                RT_MANGLER(RTIoQueueCommit)
 # define RTIoQueueCreate                                RT_MANGLER(RTIoQueueCreate)
 # define RTIoQueueDestroy                               RT_MANGLER(RTIoQueueDestroy)
@@ -1364,6 +1375,9 @@
 # define RTJsonIteratorFree                             RT_MANGLER(RTJsonIteratorFree)
 # define RTJsonIteratorNext                             RT_MANGLER(RTJsonIteratorNext)
 # define RTJsonIteratorQueryValue                       RT_MANGLER(RTJsonIteratorQueryValue)
+# define RTJsonParseEventsFromBuf                       RT_MANGLER(RTJsonParseEventsFromBuf)
+# define RTJsonParseEventsFromString                    RT_MANGLER(RTJsonParseEventsFromString)
+# define RTJsonParseEventsFromVfsFile                   RT_MANGLER(RTJsonParseEventsFromVfsFile)
 # define RTJsonParseFromBuf                             RT_MANGLER(RTJsonParseFromBuf)
 # define RTJsonParseFromFile                            RT_MANGLER(RTJsonParseFromFile)
 # define RTJsonParseFromString                          RT_MANGLER(RTJsonParseFromString)
@@ -1566,6 +1580,12 @@
 # define RTLockValidatorWriteLockInc                    RT_MANGLER(RTLockValidatorWriteLockInc)
 # define RTLogAssert                                    RT_MANGLER(RTLogAssert)
 # define RTLogAssertV                                   RT_MANGLER(RTLogAssertV)
+# define RTLogAsyncOutputCreate                         RT_MANGLER(RTLogAsyncOutputCreate)
+# define RTLogAsyncOutputDestroy                        RT_MANGLER(RTLogAsyncOutputDestroy)
+# define RTLogAsyncOutputFlush                          RT_MANGLER(RTLogAsyncOutputFlush)
+# define RTLogAsyncOutputFlushAll                       RT_MANGLER(RTLogAsyncOutputFlushAll)
+# define RTLogAsyncOutputGetDropped                     RT_MANGLER(RTLogAsyncOutputGetDropped)
+# define RTLogAsyncOutputGetIf                          RT_MANGLER(RTLogAsyncOutputGetIf)
 # define RTLogBackdoorPrintf                            RT_MANGLER(RTLogBackdoorPrintf) /* r0drv-guest */
 # define RTLogBackdoorPrintfV                           RT_MANGLER(RTLogBackdoorPrintfV) /* r0drv-guest */
 # define RTLogBulkUpdate                                RT_MANGLER(RTLogBulkUpdate)
@@ -1684,6 +1704,7 @@
 # define RTMemCacheCreate                               RT_MANGLER(RTMemCacheCreate)
 # define RTMemCacheDestroy                              RT_MANGLER(RTMemCacheDestroy)
 # define RTMemCacheFree                                 RT_MANGLER(RTMemCacheFree)
+# define RTMemCacheQueryStats                           RT_MANGLER(RTMemCacheQueryStats)
 # define RTMemContAlloc                                 RT_MANGLER(RTMemContAlloc) /* r0drv */
 # define RTMemContFree                                  RT_MANGLER(RTMemContFree) /* r0drv */
 # define RTMemDump                                      RT_MANGLER(RTMemDump)
@@ -1792,6 +1813,8 @@
 # define RTMpOnPairIsConcurrentExecSupported            RT_MANGLER(RTMpOnPairIsConcurrentExecSupported) /* r0drv */
 # define RTMpOnSpecific                                 RT_MANGLER(RTMpOnSpecific)             /* r0drv */
 # define RTMpPokeCpu                                    RT_MANGLER(RTMpPokeCpu)                /* r0drv */
+# define RTMpPostIpiCpu                                 RT_MANGLER(RTMpPostIpiCpu)             /* r0drv */
+# define RTMpPostIpiGetVector                           RT_MANGLER(RTMpPostIpiGetVector)       /* r0drv */
 # define RTMpSetIndexFromCpuGroupMember                 RT_MANGLER(RTMpSetIndexFromCpuGroupMember)
 # define RTMsgError                                     RT_MANGLER(RTMsgError)
 # define RTMsgErrorExit                                 RT_MANGLER(RTMsgErrorExit)
@@ -2031,6 +2054,13 @@
 # define rtR3MemRealloc                                 RT_MANGLER(rtR3MemRealloc)
 # define RTRCInit                                       RT_MANGLER(RTRCInit)
 # define RTRCTerm                                       RT_MANGLER(RTRCTerm)
+# define RTRadixTreeCreate                              RT_MANGLER(RTRadixTreeCreate)
+# define RTRadixTreeDestroy                             RT_MANGLER(RTRadixTreeDestroy)
+# define RTRadixTreeDoWithAll                           RT_MANGLER(RTRadixTreeDoWithAll)
+# define RTRadixTreeGetCount                            RT_MANGLER(RTRadixTreeGetCount)
+# define RTRadixTreeInsert                              RT_MANGLER(RTRadixTreeInsert)
+# define RTRadixTreeLookup                              RT_MANGLER(RTRadixTreeLookup)
+# define RTRadixTreeRemove                              RT_MANGLER(RTRadixTreeRemove)
 # define RTRandAdvBytes                                 RT_MANGLER(RTRandAdvBytes)
 # define RTRandAdvCreateParkMiller                      RT_MANGLER(RTRandAdvCreateParkMiller)
 # define RTRandAdvCreateSystemFaster                    RT_MANGLER(RTRandAdvCreateSystemFaster)
@@ -2925,6 +2955,7 @@
 # define RTUdpServerCreateEx                            RT_MANGLER(RTUdpServerCreateEx)
 # define RTUdpServerDestroy                             RT_MANGLER(RTUdpServerDestroy)
 # define RTUdpServerListen                              RT_MANGLER(RTUdpServerListen)
+# define RTUdpServerQuerySocket                         RT_MANGLER(RTUdpServerQuerySocket)
 # define RTUdpServerShutdown                            RT_MANGLER(RTUdpServerShutdown)
 # define RTUdpWrite                                     RT_MANGLER(RTUdpWrite)
 # define RTUniFree                                      RT_MANGLER(RTUniFree)
@@ -4492,6 +4523,7 @@
 # define g_RTIoQueueStdFileProv                         RT_MANGLER(g_RTIoQueueStdFileProv) /* internal */
 # define g_RTIoQueueAioFileProv                         RT_MANGLER(g_RTIoQueueAioFileProv) /* internal */
 # define g_RTIoQueueLnxIoURingProv                      RT_MANGLER(g_RTIoQueueLnxIoURingProv) /* internal */
+# define g_RTIoQueueLnxIoURingSocketProv                RT_MANGLER(g_RTIoQueueLnxIoURingSocketProv) /* internal */
 
 #if 0 /* Disabled for now as I'm not sure the assmbler supports mangling yet. */
 # define g_abRTZeroPage                                 RT_MANGLER(g_abRTZeroPage)
@@ -72,6 +72,49 @@ typedef RTMEMCACHE                             *PRTMEMCACHE;
 /** Nil memory cache handle. */
 #define NIL_RTMEMCACHE                          ((RTMEMCACHE)0)
 
+/** @name RTMEMCACHE_F_XXX - RTMemCacheCreate flags.
+ * @{ */
+/** Put a magazine layer in front of the shared page list.
+ * Freed objects are kept in small per-thread-slot magazines and a depot of
+ * full and empty magazines, so threads beating on the same cache mostly stay
+ * off the shared bitmaps and counters.  Objects keep their constructed state
+ * while in a magazine. */
+#define RTMEMCACHE_F_MAGAZINES                  RT_BIT_32(0)
+/** Valid flags mask. */
+#define RTMEMCACHE_F_VALID_MASK                 UINT32_C(0x00000001)
+/** @} */
+
+/**
+ * Memory cache statistics, see RTMemCacheQueryStats.
+ */
+typedef struct RTMEMCACHESTATS
+{
+    /** The (aligned) object size. */
+    uint32_t            cbObject;
+    /** The total number of objects backed by pages. */
+    uint32_t            cTotal;
+    /** The number of objects free at the page level (excludes magazines). */
+    int32_t             cFree;
+    /** The number of full magazines sitting in the depot. */
+    uint32_t            cDepotFull;
+    /** The number of empty magazines sitting in the depot. */
+    uint32_t            cDepotEmpty;
+    /** Allocations served by a magazine. */
+    uint64_t            cMagAllocHits;
+    /** Allocations falling thru to the page level. */
+    uint64_t            cMagAllocMisses;
+    /** Frees absorbed by a magazine. */
+    uint64_t            cMagFreeHits;
+    /** Frees falling thru to the page level. */
+    uint64_t            cMagFreeMisses;
+    /** Number of times a magazine slot was busy (thread hash collision). */
+    uint64_t            cMagContention;
+    /** Number of times magazines were drained to satisfy an allocation. */
+    uint64_t            cReclaims;
+} RTMEMCACHESTATS;
+/** Pointer to memory cache statistics. */
+typedef RTMEMCACHESTATS *PRTMEMCACHESTATS;
+
 
 /**
  * Object constructor.
@@ -119,7 +162,7 @@ typedef FNMEMCACHEDTOR *PFNMEMCACHEDTOR;
  * @param   pfnCtor             Object constructor callback.  Optional.
  * @param   pfnDtor             Object destructor callback.  Optional.
  * @param   pvUser              User argument for the two callbacks.
- * @param   fFlags              Flags reserved for future use.  Must be zero.
+ * @param   fFlags              RTMEMCACHE_F_XXX.
  */
 RTDECL(int)     RTMemCacheCreate(PRTMEMCACHE phMemCache, size_t cbObject, size_t cbAlignment, uint32_t cMaxObjects,
                                  PFNMEMCACHECTOR pfnCtor, PFNMEMCACHEDTOR pfnDtor, void *pvUser, uint32_t fFlags);
@@ -162,6 +205,18 @@ RTDECL(int)     RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj);
  */
 RTDECL(void)    RTMemCacheFree(RTMEMCACHE hMemCache, void *pvObj);
 
+/**
+ * Queries cache statistics.
+ *
+ * The magazine counters are only maintained with RTMEMCACHE_F_MAGAZINES and
+ * are collected without serialization, so they are approximate.
+ *
+ * @returns IPRT status code.
+ * @param   hMemCache           The cache handle.
+ * @param   pStats              Where to return the statistics.
+ */
+RTDECL(int)     RTMemCacheQueryStats(RTMEMCACHE hMemCache, PRTMEMCACHESTATS pStats);
+
 /** @} */
 
 RT_C_DECLS_END
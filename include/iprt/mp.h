@@ -438,6 +438,35 @@ RTDECL(bool) RTMpOnPairIsConcurrentExecSupported(void);
 RTDECL(int) RTMpPokeCpu(RTCPUID idCpu);
 
 
+/**
+ * Gets the host interrupt vector used for posted-interrupt notifications.
+ *
+ * This is the vector which the host kernel has reserved for notifying a CPU
+ * running a VT-x guest that the posted-interrupt descriptor has been updated,
+ * i.e. the vector to program as the posted-interrupt notification vector.
+ *
+ * @returns The vector, 0 if posted-interrupt IPIs are not supported.
+ */
+RTDECL(uint8_t) RTMpPostIpiGetVector(void);
+
+/**
+ * Sends a posted-interrupt notification IPI to the specified CPU.
+ *
+ * If the CPU is executing a VT-x guest using the vector returned by
+ * RTMpPostIpiGetVector as notification vector, the CPU processes the
+ * posted-interrupt descriptor without leaving the guest.  Otherwise the host
+ * kernel simply dismisses the interrupt, which makes this a cheaper poke.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_NOT_SUPPORTED if not supported by the host.
+ * @retval  VERR_CPU_OFFLINE if the CPU is offline.
+ * @retval  VERR_CPU_NOT_FOUND if the CPU wasn't found.
+ *
+ * @param   idCpu           The id of the CPU to notify.
+ */
+RTDECL(int) RTMpPostIpiCpu(RTCPUID idCpu);
+
+
 /**
  * MP event, see FNRTMPNOTIFICATION.
  */
@@ -0,0 +1,161 @@
+/** @file
+ * IPRT - Radix Trees.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+#ifndef IPRT_INCLUDED_radixtree_h
+#define IPRT_INCLUDED_radixtree_h
+#ifndef RT_WITHOUT_PRAGMA_ONCE
+# pragma once
+#endif
+
+#include <iprt/cdefs.h>
+#include <iprt/types.h>
+
+RT_C_DECLS_BEGIN
+
+/** @defgroup grp_rt_radixtree  RTRadixTree - Radix Trees
+ * @ingroup grp_rt
+ *
+ * A radix tree mapping dense uint64_t indexes, typically page numbers, to user
+ * pointers.
+ *
+ * Each level resolves 6 bits of the index with a 64 entry node, so a lookup is
+ * a fixed number of array indexing steps without any key comparisons.  The
+ * height grows with the largest index inserted, a tree of 4KB page numbers
+ * below 1TB is 5 levels deep.  Nodes are allocated on demand and freed when
+ * they become empty.
+ *
+ * NULL cannot be stored as a value.  There is no serialization, the caller is
+ * responsible for that.
+ *
+ * @{
+ */
+
+/** Radix tree handle. */
+typedef struct RTRADIXTREEINT  *RTRADIXTREE;
+/** Pointer to a radix tree handle. */
+typedef RTRADIXTREE            *PRTRADIXTREE;
+/** NIL radix tree handle. */
+#define NIL_RTRADIXTREE         ((RTRADIXTREE)0)
+
+/**
+ * Callback for RTRadixTreeDoWithAll and RTRadixTreeDestroy.
+ *
+ * @returns IPRT status code.  Any status other than VINF_SUCCESS aborts
+ *          RTRadixTreeDoWithAll and is returned by it, it is ignored by
+ *          RTRadixTreeDestroy.
+ * @param   uIndex          The index.
+ * @param   pvValue         The value.
+ * @param   pvUser          The user argument.
+ */
+typedef DECLCALLBACKTYPE(int, FNRTRADIXTREECALLBACK,(uint64_t uIndex, void *pvValue, void *pvUser));
+/** Pointer to a radix tree callback. */
+typedef FNRTRADIXTREECALLBACK *PFNRTRADIXTREECALLBACK;
+
+/**
+ * Creates an empty radix tree.
+ *
+ * @returns IPRT status code.
+ * @param   phTree          Where to return the tree handle.
+ */
+RTDECL(int)      RTRadixTreeCreate(PRTRADIXTREE phTree);
+
+/**
+ * Destroys a radix tree.
+ *
+ * @returns IPRT status code.
+ * @param   hTree           The tree handle, NIL is quietly ignored.
+ * @param   pfnCallback     Optional callback to call for each value before
+ *                          the tree is freed, e.g. to free the values.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(int)      RTRadixTreeDestroy(RTRADIXTREE hTree, PFNRTRADIXTREECALLBACK pfnCallback, void *pvUser);
+
+/**
+ * Inserts a value.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_ALREADY_EXISTS if the index is already present.
+ * @retval  VERR_NO_MEMORY
+ * @param   hTree           The tree handle.
+ * @param   uIndex          The index.
+ * @param   pvValue         The value, must not be NULL.
+ */
+RTDECL(int)      RTRadixTreeInsert(RTRADIXTREE hTree, uint64_t uIndex, void *pvValue);
+
+/**
+ * Removes a value.
+ *
+ * @returns The removed value, NULL if not found.
+ * @param   hTree           The tree handle.
+ * @param   uIndex          The index.
+ */
+RTDECL(void *)   RTRadixTreeRemove(RTRADIXTREE hTree, uint64_t uIndex);
+
+/**
+ * Looks up a value.
+ *
+ * @returns The value, NULL if not found.
+ * @param   hTree           The tree handle.
+ * @param   uIndex          The index.
+ */
+RTDECL(void *)   RTRadixTreeLookup(RTRADIXTREE hTree, uint64_t uIndex);
+
+/**
+ * Calls the callback for each value in ascending index order.
+ *
+ * The tree must not be modified by the callback.
+ *
+ * @returns IPRT status code, the first one other than VINF_SUCCESS returned by
+ *          the callback.
+ * @param   hTree           The tree handle.
+ * @param   pfnCallback     The callback.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(int)      RTRadixTreeDoWithAll(RTRADIXTREE hTree, PFNRTRADIXTREECALLBACK pfnCallback, void *pvUser);
+
+/**
+ * Gets the number of values in the tree.
+ *
+ * @returns Number of values, 0 if the handle is invalid.
+ * @param   hTree           The tree handle.
+ */
+RTDECL(uint64_t) RTRadixTreeGetCount(RTRADIXTREE hTree);
+
+/** @} */
+
+RT_C_DECLS_END
+
+#endif /* !IPRT_INCLUDED_radixtree_h */
+
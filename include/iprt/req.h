@@ -385,6 +385,17 @@ typedef enum RTREQPOOLCFGVAR
     RTREQPOOLCFGVAR_PUSH_BACK_MAX_MS,
     /** The maximum number of free requests to keep handy for recycling. */
     RTREQPOOLCFGVAR_MAX_FREE_REQUESTS,
+    /** Work stealing mode (0 or 1, default 0).  When enabled, requests submitted
+     * by a worker thread of the pool go onto that thread's own deque instead of
+     * the shared queue, and idle workers steal from the deques of busy ones.
+     * Meant for fine grained parallel work fanned out from pool requests. */
+    RTREQPOOLCFGVAR_WORK_STEALING,
+    /** The number of CPU affinity groups to spread worker threads over, 0 (the
+     * default) for no affinity.  The online CPUs are split into this many
+     * contiguous ranges and new worker threads are assigned round-robin.  In
+     * work stealing mode, threads steal within their own group first.  Only
+     * affects threads created after the change. */
+    RTREQPOOLCFGVAR_AFFINITY_GROUPS,
     /** The end of the range of valid config variables. */
     RTREQPOOLCFGVAR_END,
     /** Blow the type up to 32-bits. */
@@ -444,6 +455,13 @@ typedef enum RTREQPOOLSTAT
     /** Average time the requests had to wait in the queue before being
      * scheduled. */
     RTREQPOOLSTAT_NS_AVERAGE_REQ_QUEUED,
+    /** The total number of requests taken from the deque of another worker
+     * (work stealing mode). */
+    RTREQPOOLSTAT_REQUESTS_STOLEN,
+    /** The total number of requests submitted by worker threads to their own
+     * deque (work stealing mode).  These aren't included in
+     * RTREQPOOLSTAT_REQUESTS_SUBMITTED and RTREQPOOLSTAT_REQUESTS_PENDING. */
+    RTREQPOOLSTAT_REQUESTS_SUBMITTED_LOCAL,
     /** The end of the valid statistics value names. */
     RTREQPOOLSTAT_END,
     /** Blow the type up to 32-bit. */
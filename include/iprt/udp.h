@@ -162,6 +162,22 @@ RTR3DECL(int)  RTUdpRead(RTSOCKET Sock, void *pvBuffer, size_t cbBuffer, size_t
 RTR3DECL(int)  RTUdpWrite(PRTUDPSERVER pServer, const void *pvBuffer,
                           size_t cbBuffer, PCRTNETADDR pDstAddr);
 
+/**
+ * Queries the socket of a UDP server.
+ *
+ * This is for callers wanting to use the socket directly, e.g. for sending
+ * batches of datagrams with system specific APIs.
+ *
+ * @returns iprt status code.
+ * @retval  VERR_INVALID_HANDLE if the server has no socket (any longer).
+ *
+ * @param   pServer     Handle to the server.
+ * @param   phSocket    Where to return the socket handle.  The handle is
+ *                      retained and must be released by the caller using
+ *                      RTSocketRelease.
+ */
+RTR3DECL(int) RTUdpServerQuerySocket(PRTUDPSERVER pServer, PRTSOCKET phSocket);
+
 /**
  * Create and connect a data socket.
  *
@@ -100,6 +100,8 @@ typedef enum RTZIPTYPE
     RTZIPTYPE_LZO,
     /* Zlib compression the data without zlib header. */
     RTZIPTYPE_ZLIB_NO_HEADER,
+    /** LZ4 block format compression (RTZipBlockCompress/RTZipBlockDecompress only). */
+    RTZIPTYPE_LZ4,
     /** End of valid the valid compression types.  */
     RTZIPTYPE_END
 } RTZIPTYPE;
@@ -274,13 +276,22 @@ RTDECL(int) RTZipXzDecompressIoStream(RTVFSIOSTREAM hVfsIosIn, uint32_t fFlags,
  * @param   hVfsIosDst          The compressed output stream (must be writable).
  *                              The reference is not consumed, instead another
  *                              one is retained.
- * @param   fFlags              Flags, MBZ.
+ * @param   fFlags              RTZIPGZIPCOMP_F_XXX.
  * @param   uLevel              The gzip compression level, 1 thru 9.
  * @param   phVfsIosGzip        Where to return the gzip input I/O stream handle
  *                              (you write to this).
  */
 RTDECL(int) RTZipGzipCompressIoStream(RTVFSIOSTREAM hVfsIosDst, uint32_t fFlags, uint8_t uLevel, PRTVFSIOSTREAM phVfsIosGzip);
 
+/** @name RTZipGzipCompressIoStream flags.
+ * @{ */
+/** Compress independent blocks on a pool of worker threads (pigz style).
+ * The output is still a single gzip member.  Each block is primed with the
+ * tail of the previous one, so the ratio is only marginally worse.  Silently
+ * ignored when there is only one CPU online. */
+#define RTZIPGZIPCOMP_F_PARALLEL            RT_BIT(0)
+/** @} */
+
 
 /**
  * Opens a xz decompression I/O stream.
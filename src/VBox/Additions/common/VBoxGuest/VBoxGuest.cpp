@@ -71,6 +71,7 @@
 #include <iprt/time.h>
 #include <iprt/memobj.h>
 #include <iprt/asm.h>
+#include <iprt/asm-mem.h>
 #if defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)
 # include <iprt/asm-amd64-x86.h>
 #endif
@@ -785,6 +786,81 @@ static void vgdrvCloseMemBalloon(PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTSESSION pSe
 
 
 
+/** @name Guest statistics page
+ * @{
+ */
+
+/**
+ * Tells the host about the statistics page (or that there no longer is one).
+ *
+ * @returns VBox status code.
+ * @param   GCPhysPage      The physical address of the page, NIL_RTGCPHYS to
+ *                          unregister it.
+ * @param   fRequestor      The requestor flags.
+ */
+static int vgdrvStatsPageSetOnHost(RTGCPHYS GCPhysPage, uint32_t fRequestor)
+{
+    VMMDevReqStatisticsPage *pReq;
+    int rc = VbglR0GRAlloc((VMMDevRequestHeader **)&pReq, sizeof(*pReq), VMMDevReq_SetStatisticsPage);
+    if (RT_SUCCESS(rc))
+    {
+        pReq->header.fRequestor = fRequestor;
+        pReq->GCPhysPage        = GCPhysPage;
+        rc = VbglR0GRPerform(&pReq->header);
+        VbglR0GRFree(&pReq->header);
+    }
+    return rc;
+}
+
+
+/**
+ * Unregisters the statistics page and unlocks it.
+ *
+ * Caller owns MemBalloon.hMtx.
+ *
+ * @param   pDevExt     The device extension.
+ */
+static void vgdrvStatsPageRelease(PVBOXGUESTDEVEXT pDevExt)
+{
+    if (pDevExt->hStatsPageMemObj != NIL_RTR0MEMOBJ)
+    {
+        /* fRequestor is kernel here, the page belongs to us until it is unlocked. */
+        int rc = vgdrvStatsPageSetOnHost(NIL_RTGCPHYS, VMMDEV_REQUESTOR_KERNEL);
+        if (RT_SUCCESS(rc))
+        {
+            RTR0MemObjFree(pDevExt->hStatsPageMemObj, false /*fFreeMappings*/);
+            pDevExt->hStatsPageMemObj = NIL_RTR0MEMOBJ;
+        }
+        else
+        {
+            /* Leaving the page locked is better than the host sampling random memory. */
+            LogRel(("vgdrvStatsPageRelease: Unregistering failed with rc=%Rrc.  Will leak the page.\n", rc));
+            pDevExt->hStatsPageMemObj = NIL_RTR0MEMOBJ;
+        }
+    }
+    pDevExt->pStatsPageOwner = NULL;
+}
+
+
+/**
+ * Cleanup the statistics page of a session.
+ *
+ * @param   pDevExt     The device extension.
+ * @param   pSession    The session.  Can be NULL at unload.
+ */
+static void vgdrvCloseStatsPage(PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTSESSION pSession)
+{
+    RTSemFastMutexRequest(pDevExt->MemBalloon.hMtx);
+    if (    pDevExt->pStatsPageOwner == pSession
+        ||  pSession == NULL /*unload*/)
+        vgdrvStatsPageRelease(pDevExt);
+    RTSemFastMutexRelease(pDevExt->MemBalloon.hMtx);
+}
+
+/** @} */
+
+
+
 /** @name Heartbeat
  * @{
  */
@@ -1024,6 +1100,8 @@ int VGDrvCommonInitDevExtFundament(PVBOXGUESTDEVEXT pDevExt)
     pDevExt->MemBalloon.fUseKernelAPI = true;
     pDevExt->MemBalloon.paMemObj = NULL;
     pDevExt->MemBalloon.pOwner = NULL;
+    pDevExt->hStatsPageMemObj = NIL_RTR0MEMOBJ;
+    pDevExt->pStatsPageOwner = NULL;
     pDevExt->pfnMouseNotifyCallback = NULL;
     pDevExt->pvMouseNotifyCallbackArg = NULL;
     pDevExt->pReqGuestHeartbeat = NULL;
@@ -1283,6 +1361,7 @@ void VGDrvCommonDeleteDevExtResources(PVBOXGUESTDEVEXT pDevExt)
     vgdrvResetMouseStatusOnHost(pDevExt);
 
     vgdrvCloseMemBalloon(pDevExt, (PVBOXGUESTSESSION)NULL);
+    vgdrvCloseStatsPage(pDevExt, (PVBOXGUESTSESSION)NULL);
 
     /*
      * No more IRQs.
@@ -1744,6 +1823,7 @@ void VGDrvCommonCloseSession(PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTSESSION pSessio
     pSession->Process = NIL_RTPROCESS;
     pSession->R0Process = NIL_RTR0PROCESS;
     vgdrvCloseMemBalloon(pDevExt, pSession);
+    vgdrvCloseStatsPage(pDevExt, pSession);
     RTMemFree(pSession);
 }
 
@@ -2367,6 +2447,7 @@ static int vgdrvCheckIfVmmReqIsAllowed(PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTSESSI
         case VMMDevReq_DeregisterPatchMemory:
         case VMMDevReq_GetMemBalloonChangeRequest:
         case VMMDevReq_ChangeMemBalloon:
+        case VMMDevReq_SetStatisticsPage:
             enmRequired = kLevel_OnlyVBoxGuest;
             break;
 
@@ -3066,6 +3147,67 @@ static int vgdrvIoCtl_ChangeMemoryBalloon(PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTSE
 }
 
 
+/**
+ * Handle a request for registering or unregistering the statistics page.
+ *
+ * @returns VBox status code.
+ *
+ * @param   pDevExt             The device extention.
+ * @param   pSession            The session.
+ * @param   pInfo               The request structure (input).
+ */
+static int vgdrvIoCtl_SetStatsPage(PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTSESSION pSession, PVBGLIOCSETSTATSPAGE pInfo)
+{
+    RTR3PTR const pvPage = pInfo->u.In.pvPage;
+    int           rc;
+    LogFlow(("VBGL_IOCTL_SET_STATS_PAGE: pvPage=%p\n", pvPage));
+    if (!ASMMemIsZero(pInfo->u.In.abPadding, sizeof(pInfo->u.In.abPadding)))
+    {
+        Log(("VBGL_IOCTL_SET_STATS_PAGE: Padding isn't all zero: %.*Rhxs\n", sizeof(pInfo->u.In.abPadding), pInfo->u.In.abPadding));
+        return VERR_INVALID_PARAMETER;
+    }
+    if (pvPage & PAGE_OFFSET_MASK)
+        return VERR_INVALID_POINTER;
+
+    rc = RTSemFastMutexRequest(pDevExt->MemBalloon.hMtx);
+    AssertRCReturn(rc, rc);
+
+    /*
+     * Like the balloon, the page belongs to the first session registering it
+     * until that session unregisters it or is closed.
+     */
+    if (   pDevExt->pStatsPageOwner != NULL
+        && pDevExt->pStatsPageOwner != pSession)
+        rc = VERR_RESOURCE_BUSY;
+    else
+    {
+        vgdrvStatsPageRelease(pDevExt);
+        if (pvPage != NIL_RTR3PTR)
+        {
+            RTR0MEMOBJ hMemObj;
+            rc = RTR0MemObjLockUser(&hMemObj, pvPage, PAGE_SIZE, RTMEM_PROT_READ | RTMEM_PROT_WRITE, NIL_RTR0PROCESS);
+            if (RT_SUCCESS(rc))
+            {
+                rc = vgdrvStatsPageSetOnHost(RTR0MemObjGetPagePhysAddr(hMemObj, 0), pSession->fRequestor);
+                if (RT_SUCCESS(rc))
+                {
+                    pDevExt->hStatsPageMemObj = hMemObj;
+                    pDevExt->pStatsPageOwner  = pSession;
+                }
+                else
+                {
+                    Log(("VBGL_IOCTL_SET_STATS_PAGE: VbglR0GRPerform failed, rc=%Rrc!\n", rc));
+                    RTR0MemObjFree(hMemObj, false /*fFreeMappings*/);
+                }
+            }
+        }
+    }
+
+    RTSemFastMutexRelease(pDevExt->MemBalloon.hMtx);
+    return rc;
+}
+
+
 /**
  * Handle a request for writing a core dump of the guest on the host.
  *
@@ -4285,6 +4427,11 @@ int VGDrvCommonIoCtl(uintptr_t iFunction, PVBOXGUESTDEVEXT pDevExt, PVBOXGUESTSE
                     pReqHdr->rc = vgdrvIoCtl_WriteCoreDump(pDevExt, pSession, (PVBGLIOCWRITECOREDUMP)pReqHdr);
                     break;
 
+                case VBGL_IOCTL_SET_STATS_PAGE:
+                    REQ_CHECK_SIZES(VBGL_IOCTL_SET_STATS_PAGE);
+                    pReqHdr->rc = vgdrvIoCtl_SetStatsPage(pDevExt, pSession, (PVBGLIOCSETSTATSPAGE)pReqHdr);
+                    break;
+
                 case VBGL_IOCTL_SET_MOUSE_STATUS:
                     REQ_CHECK_SIZES(VBGL_IOCTL_SET_MOUSE_STATUS);
                     pReqHdr->rc = vgdrvIoCtl_SetMouseStatus(pDevExt, pSession, ((PVBGLIOCSETMOUSESTATUS)pReqHdr)->u.In.fStatus);
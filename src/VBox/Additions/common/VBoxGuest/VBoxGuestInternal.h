@@ -214,6 +214,14 @@ typedef struct VBOXGUESTDEVEXT
     bool                        fLoggingEnabled;
     /** Memory balloon information for RTR0MemObjAllocPhysNC(). */
     VBOXGUESTMEMBALLOON         MemBalloon;
+    /** @name Guest statistics page (VBGL_IOCTL_SET_STATS_PAGE)
+     * Protected by MemBalloon.hMtx.
+     * @{ */
+    /** The locked down user page, NIL_RTR0MEMOBJ if not registered. */
+    RTR0MEMOBJ                  hStatsPageMemObj;
+    /** The session which registered the page. */
+    PVBOXGUESTSESSION           pStatsPageOwner;
+    /** @} */
     /** Mouse notification callback function. */
     PFNVBOXGUESTMOUSENOTIFY     pfnMouseNotifyCallback;
     /** The callback argument for the mouse ntofication callback. */
@@ -337,6 +337,80 @@ DECLVBGL(int) VbglGuestPropWriteValueF(PVBGLGSTPROPCLIENT pClient, const char *p
     return rc;
 }
 
+
+/**
+ * Write several properties in a single call.
+ *
+ * Falls back on writing them one by one if the host does not know the
+ * SET_PROPS call.  Unlike VbglGuestPropWrite, a NULL value is not allowed.
+ *
+ * @returns VBox status code.  On failure some of the properties may have
+ *          been written.
+ *
+ * @param   pClient         The client session state returned by
+ *                          VbglR0InfoSvcConnect().
+ * @param   cProps          The number of properties to write.
+ * @param   papszNames      The property names.  Must be valid UTF-8.
+ * @param   papszValues     The values to store.  Must be valid UTF-8.
+ * @param   papszFlags      The flags for each property, NULL for none.
+ */
+DECLVBGL(int) VbglGuestPropWriteMulti(PVBGLGSTPROPCLIENT pClient, uint32_t cProps, const char * const *papszNames,
+                                      const char * const *papszValues, const char * const *papszFlags)
+{
+    AssertPtrReturn(pClient, VERR_INVALID_HANDLE);
+    AssertReturn(cProps > 0 && cProps <= GUEST_PROP_MAX_PROPS, VERR_INVALID_PARAMETER);
+    AssertPtrReturn(papszNames, VERR_INVALID_POINTER);
+    AssertPtrReturn(papszValues, VERR_INVALID_POINTER);
+    AssertPtrNullReturn(papszFlags, VERR_INVALID_POINTER);
+
+    /*
+     * Pack the triplets into a double terminated block.
+     */
+    size_t cbBlock = 1;
+    for (uint32_t i = 0; i < cProps; i++)
+    {
+        AssertPtrReturn(papszNames[i], VERR_INVALID_POINTER);
+        AssertPtrReturn(papszValues[i], VERR_INVALID_POINTER);
+        cbBlock += strlen(papszNames[i]) + 1 + strlen(papszValues[i]) + 1
+                 + (papszFlags && papszFlags[i] ? strlen(papszFlags[i]) : 0) + 1;
+    }
+    AssertReturn(cbBlock <= _1M, VERR_TOO_MUCH_DATA);
+
+    char *pchBlock = (char *)RTMemTmpAlloc(cbBlock);
+    if (!pchBlock)
+        return VERR_NO_TMP_MEMORY;
+    char *pch = pchBlock;
+    for (uint32_t i = 0; i < cProps; i++)
+    {
+        const char *apsz[3] = { papszNames[i], papszValues[i], papszFlags && papszFlags[i] ? papszFlags[i] : "" };
+        for (unsigned j = 0; j < RT_ELEMENTS(apsz); j++)
+        {
+            size_t const cb = strlen(apsz[j]) + 1;
+            memcpy(pch, apsz[j], cb);
+            pch += cb;
+        }
+    }
+    *pch = '\0';
+
+    GuestPropMsgSetProperties Msg;
+    VBGL_HGCM_HDR_INIT(&Msg.hdr, pClient->idClient, GUEST_PROP_FN_SET_PROPS, 1);
+    VbglHGCMParmPtrSet(&Msg.props, pchBlock, (uint32_t)cbBlock);
+    int rc = vbglGuestPropDoCall(pClient, &Msg.hdr, sizeof(Msg));
+    RTMemTmpFree(pchBlock);
+
+    /*
+     * Older hosts: do it the slow way.
+     */
+    if (rc == VERR_NOT_IMPLEMENTED || rc == VERR_NOT_SUPPORTED)
+    {
+        rc = VINF_SUCCESS;
+        for (uint32_t i = 0; i < cProps && RT_SUCCESS(rc); i++)
+            rc = VbglGuestPropWrite(pClient, papszNames[i], papszValues[i],
+                                    papszFlags && papszFlags[i] ? papszFlags[i] : "");
+    }
+    return rc;
+}
+
 #endif /* !IN_RING0 && !VBOX_VBGLR3_XSERVER */
 
 /**
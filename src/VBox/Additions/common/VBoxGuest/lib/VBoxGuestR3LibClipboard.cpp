@@ -109,7 +109,7 @@ VBGLR3DECL(int) VbglR3ClipboardConnectEx(PVBGLR3SHCLCMDCTX pCtx, uint64_t fGuest
      * Intialize the context structure.
      */
     pCtx->idClient              = 0;
-    pCtx->fGuestFeatures        = fGuestFeatures;
+    pCtx->fGuestFeatures        = fGuestFeatures | VBOX_SHCL_GF_0_DATA_CHUNKS;
     pCtx->fHostFeatures         = 0;
     pCtx->fUseLegacyProtocol    = true;
     pCtx->idContext             = 0;
@@ -479,6 +479,95 @@ VBGLR3DECL(int) VbglR3ClipboardReadData(HGCMCLIENTID idClient, uint32_t fFormat,
 }
 
 
+/**
+ * Reads clipboard data from the host clipboard in chunks.
+ *
+ * The host reads its clipboard once when we ask for offset zero and hands out
+ * the rest from its copy, so we neither need to know the size up front nor
+ * have to pass a buffer for all of it through a single call.
+ *
+ * @returns VBox status code.
+ * @param   pCtx                The command context returned by VbglR3ClipboardConnectEx().
+ * @param   uFormat             Clipboard format of clipboard data to be read.
+ * @param   ppvData             Where to return the allocated data on success.
+ * @param   pcbData             Where to return the size of the data on success.
+ */
+static int vbglR3ClipboardReadDataChunked(PVBGLR3SHCLCMDCTX pCtx, SHCLFORMAT uFormat, void **ppvData, uint32_t *pcbData)
+{
+    uint32_t const cbChunk = VBOX_SHCL_DEFAULT_CHUNK_SIZE;
+
+    uint32_t cbAlloc = cbChunk;
+    uint8_t *pbData  = (uint8_t *)RTMemAlloc(cbAlloc);
+    if (!pbData)
+        return VERR_NO_MEMORY;
+
+    int      rc;
+    uint32_t offRead   = 0;
+    uint32_t cbTotal   = 0;
+    unsigned cRestarts = 0;
+    for (;;)
+    {
+        struct
+        {
+            VBGLIOCHGCMCALL             Hdr;
+            VBoxShClParmDataReadChunk   Parms;
+        } Msg;
+
+        VBGL_HGCM_HDR_INIT(&Msg.Hdr, pCtx->idClient, VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK, VBOX_SHCL_CPARMS_DATA_READ_CHUNK);
+        Msg.Parms.f32Format.SetUInt32(uFormat);
+        Msg.Parms.off64.SetUInt64(offRead);
+        Msg.Parms.pData.SetPtr(pbData + offRead, RT_MIN(cbChunk, cbAlloc - offRead));
+        Msg.Parms.cb32Read.SetUInt32(0);
+        Msg.Parms.cb32Total.SetUInt32(0);
+
+        rc = VbglR3HGCMCall(&Msg.Hdr, sizeof(Msg));
+        if (   rc == VERR_INVALID_STATE /* The host clipboard changed under our feet, start over. */
+            && offRead > 0
+            && cRestarts++ < 3)
+        {
+            offRead = 0;
+            continue;
+        }
+        if (RT_FAILURE(rc))
+            break;
+
+        uint32_t cbRead = 0;
+        rc = Msg.Parms.cb32Read.GetUInt32(&cbRead);
+        if (RT_SUCCESS(rc))
+            rc = Msg.Parms.cb32Total.GetUInt32(&cbTotal);
+        if (RT_FAILURE(rc))
+            break;
+        AssertBreakStmt(cbRead <= cbAlloc - offRead && cbTotal <= VBOX_SHCL_MAX_DATA_SIZE, rc = VERR_INVALID_PARAMETER);
+
+        offRead += cbRead;
+        if (offRead >= cbTotal)
+            break;
+        AssertBreakStmt(cbRead > 0, rc = VERR_NO_DATA);
+
+        /* Now that we know the total size, make room for all of it. */
+        if (cbTotal > cbAlloc)
+        {
+            void *pvNew = RTMemRealloc(pbData, cbTotal);
+            AssertBreakStmt(pvNew, rc = VERR_NO_MEMORY);
+            pbData  = (uint8_t *)pvNew;
+            cbAlloc = cbTotal;
+        }
+    }
+
+    if (RT_SUCCESS(rc) && !cbTotal)
+        rc = VERR_SHCLPB_NO_DATA;
+
+    if (RT_SUCCESS(rc))
+    {
+        *ppvData = pbData;
+        *pcbData = cbTotal;
+    }
+    else
+        RTMemFree(pbData);
+    return rc;
+}
+
+
 /**
  * Reads clipboard data from the host clipboard.
  *
@@ -500,6 +589,16 @@ VBGLR3DECL(int) VbglR3ClipboardReadDataEx(PVBGLR3SHCLCMDCTX pCtx,
 
     int rc;
 
+    if (   !pCtx->fUseLegacyProtocol
+        && (pCtx->fHostFeatures  & VBOX_SHCL_HF_0_DATA_CHUNKS)
+        && (pCtx->fGuestFeatures & VBOX_SHCL_GF_0_DATA_CHUNKS))
+    {
+        rc = vbglR3ClipboardReadDataChunked(pCtx, uFormat, ppvData, pcbData);
+        if (RT_FAILURE(rc) && rc != VERR_SHCLPB_NO_DATA)
+            LogRel(("Shared Clipboard: Reading clipboard data in format %#x from host failed with %Rrc\n", uFormat, rc));
+        return rc;
+    }
+
     uint32_t cbRead = 0;
     uint32_t cbData = _4K;
 
@@ -2921,7 +3020,8 @@ VBGLR3DECL(int) VbglR3ClipboardWriteDataEx(PVBGLR3SHCLCMDCTX pCtx, SHCLFORMAT fF
     int rc;
     if (pCtx->fUseLegacyProtocol)
         rc = VbglR3ClipboardWriteData(pCtx->idClient, fFormat, pvData, cbData);
-    else
+    else if (   !(pCtx->fHostFeatures  & VBOX_SHCL_HF_0_DATA_CHUNKS)
+             || !(pCtx->fGuestFeatures & VBOX_SHCL_GF_0_DATA_CHUNKS))
     {
         struct
         {
@@ -2940,6 +3040,33 @@ VBGLR3DECL(int) VbglR3ClipboardWriteDataEx(PVBGLR3SHCLCMDCTX pCtx, SHCLFORMAT fF
 
         rc = VbglR3HGCMCall(&Msg.Hdr, sizeof(Msg));
     }
+    else
+    {
+        /* Send the data in chunks, so that no single call has to carry all of it. */
+        uint32_t const cbChunk = VBOX_SHCL_DEFAULT_CHUNK_SIZE;
+        uint32_t       offData = 0;
+        do
+        {
+            struct
+            {
+                VBGLIOCHGCMCALL             Hdr;
+                VBoxShClParmDataWriteChunk  Parms;
+            } Msg;
+
+            uint32_t const cbThis = RT_MIN(cbChunk, cbData - offData);
+            uint32_t const fFlags = offData + cbThis >= cbData ? VBOX_SHCL_DATA_CHUNK_F_LAST : VBOX_SHCL_DATA_CHUNK_F_NONE;
+
+            VBGL_HGCM_HDR_INIT(&Msg.Hdr, pCtx->idClient, VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK, VBOX_SHCL_CPARMS_DATA_WRITE_CHUNK);
+            Msg.Parms.id64Context.SetUInt64(pCtx->idContext);
+            Msg.Parms.f32Format.SetUInt32(fFormat);
+            Msg.Parms.off64.SetUInt64(offData);
+            Msg.Parms.f32Flags.SetUInt32(fFlags);
+            Msg.Parms.pData.SetPtr((uint8_t *)pvData + offData, cbThis);
+
+            rc = VbglR3HGCMCall(&Msg.Hdr, sizeof(Msg));
+            offData += cbThis;
+        } while (RT_SUCCESS(rc) && offData < cbData);
+    }
 
     LogFlowFuncLeaveRC(rc);
     return rc;
@@ -175,7 +175,7 @@ static int vbglR3DnDHGRecvAction(PVBGLR3GUESTDNDCMDCTX pCtx,
     AssertPtrReturn(pCtx, VERR_INVALID_POINTER);
     /* The rest is optional. */
 
-    const uint32_t cbFormatsTmp = pCtx->cbMaxChunkSize;
+    const uint32_t cbFormatsTmp = DND_DEFAULT_CHUNK_SIZE; /* Format lists don't grow with the data chunk size. */
 
     char *pszFormatsTmp = static_cast<char *>(RTMemAlloc(cbFormatsTmp));
     if (!pszFormatsTmp)
@@ -881,7 +881,7 @@ static int vbglR3DnDHGRecvDataMain(PVBGLR3GUESTDNDCMDCTX   pCtx,
 
     VBOXDNDDATAHDR dataHdr;
     RT_ZERO(dataHdr);
-    dataHdr.cbMetaFmt = pCtx->cbMaxChunkSize;
+    dataHdr.cbMetaFmt = DND_DEFAULT_CHUNK_SIZE;
     dataHdr.pvMetaFmt = RTMemAllocZ(dataHdr.cbMetaFmt);
     if (!dataHdr.pvMetaFmt)
         return VERR_NO_MEMORY;
@@ -1019,7 +1019,7 @@ static int vbglR3DnDGHRecvDropped(PVBGLR3GUESTDNDCMDCTX pCtx,
     AssertPtrReturn(pCtx, VERR_INVALID_POINTER);
     /* The rest is optional. */
 
-    const uint32_t cbFormatTmp = pCtx->cbMaxChunkSize;
+    const uint32_t cbFormatTmp = DND_DEFAULT_CHUNK_SIZE; /* Format strings don't grow with the data chunk size. */
 
     char *pszFormatTmp = static_cast<char *>(RTMemAlloc(cbFormatTmp));
     if (!pszFormatTmp)
@@ -1081,7 +1081,7 @@ VBGLR3DECL(int) VbglR3DnDConnect(PVBGLR3GUESTDNDCMDCTX pCtx)
     pCtx->uProtocolDeprecated = 3;
 
     pCtx->fHostFeatures  = VBOX_DND_HF_NONE;
-    pCtx->fGuestFeatures = VBOX_DND_GF_NONE;
+    pCtx->fGuestFeatures = VBOX_DND_GF_0_LARGE_CHUNKS;
 
     /*
      * Get the VM's session ID.
@@ -1123,7 +1123,9 @@ VBGLR3DECL(int) VbglR3DnDConnect(PVBGLR3GUESTDNDCMDCTX pCtx)
                             ("Reporting features failed: %Rrc\n", rc2));
         }
 
-        pCtx->cbMaxChunkSize = DND_DEFAULT_CHUNK_SIZE; /** @todo Use a scratch buffer on the heap? */
+        /* Old hosts only can handle 64K chunks. */
+        pCtx->cbMaxChunkSize = pCtx->fHostFeatures & VBOX_DND_HF_0_LARGE_CHUNKS
+                             ? DND_MAX_CHUNK_SIZE : DND_DEFAULT_CHUNK_SIZE;
     }
     else
         pCtx->uProtocolDeprecated = 0; /*  We're using protocol v0 (initial draft) as a fallback. */
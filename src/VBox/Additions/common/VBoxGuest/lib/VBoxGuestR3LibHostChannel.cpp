@@ -106,6 +106,27 @@ VBGLR3DECL(int) VbglR3HostChannelSend(uint32_t u32ChannelHandle,
     return VbglR3HGCMCall(&parms.hdr, sizeof(parms));
 }
 
+/* Sends VBOXHOSTCHANNELRECORD records in one call. Older hosts return VERR_NOT_IMPLEMENTED. */
+VBGLR3DECL(int) VbglR3HostChannelSendBatch(uint32_t u32ChannelHandle,
+                                           uint32_t u32HGCMClientId,
+                                           void *pvRecords,
+                                           uint32_t cbRecords,
+                                           uint32_t *pcRecords)
+{
+    VBoxHostChannelSendBatch parms;
+    VBGL_HGCM_HDR_INIT(&parms.hdr, u32HGCMClientId, VBOX_HOST_CHANNEL_FN_SEND_BATCH, 3);
+    VbglHGCMParmUInt32Set(&parms.handle, u32ChannelHandle);
+    VbglHGCMParmPtrSet(&parms.data, pvRecords, cbRecords);
+    VbglHGCMParmUInt32Set(&parms.cRecords, 0);
+
+    int rc = VbglR3HGCMCall(&parms.hdr, sizeof(parms));
+
+    if (RT_SUCCESS(rc) && pcRecords)
+        *pcRecords = parms.cRecords.u.value32;
+
+    return rc;
+}
+
 VBGLR3DECL(int) VbglR3HostChannelRecv(uint32_t u32ChannelHandle,
                                       uint32_t u32HGCMClientId,
                                       void *pvData,
@@ -39,6 +39,8 @@
 *   Header Files                                                                                                                 *
 *********************************************************************************************************************************/
 #include "VBoxGuestR3LibInternal.h"
+#include <iprt/param.h>
+#include <iprt/string.h>
 
 
 /**
@@ -77,3 +79,45 @@ VBGLR3DECL(int) VbglR3StatReport(VMMDevReportGuestStats *pReq)
     return vbglR3GRPerform(&pReq->header);
 }
 
+
+/**
+ * Registers a page the guest statistics will be written to.
+ *
+ * The host samples the page periodically, so after this the statistics no
+ * longer have to be pushed with VbglR3StatReport.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_NOT_SUPPORTED, VERR_NOT_IMPLEMENTED if the host or driver
+ *          is too old.
+ * @retval  VERR_RESOURCE_BUSY if another process owns the page.
+ * @param   pPage       The page aligned statistics page.  Must stay valid
+ *                      until VbglR3StatClearPage is called or the process
+ *                      terminates.
+ */
+VBGLR3DECL(int) VbglR3StatSetPage(VMMDevStatsPage *pPage)
+{
+    AssertPtrReturn(pPage, VERR_INVALID_POINTER);
+    AssertReturn(!((uintptr_t)pPage & PAGE_OFFSET_MASK), VERR_INVALID_POINTER);
+
+    VBGLIOCSETSTATSPAGE Info;
+    VBGLREQHDR_INIT(&Info.Hdr, SET_STATS_PAGE);
+    Info.u.In.pvPage = (RTR3PTR)pPage;
+    RT_ZERO(Info.u.In.abPadding);
+    return vbglR3DoIOCtl(VBGL_IOCTL_SET_STATS_PAGE, &Info.Hdr, sizeof(Info));
+}
+
+
+/**
+ * Unregisters the page registered by VbglR3StatSetPage.
+ *
+ * @returns IPRT status code.
+ */
+VBGLR3DECL(int) VbglR3StatClearPage(void)
+{
+    VBGLIOCSETSTATSPAGE Info;
+    VBGLREQHDR_INIT(&Info.Hdr, SET_STATS_PAGE);
+    Info.u.In.pvPage = NIL_RTR3PTR;
+    RT_ZERO(Info.u.In.abPadding);
+    return vbglR3DoIOCtl(VBGL_IOCTL_SET_STATS_PAGE, &Info.Hdr, sizeof(Info));
+}
+
@@ -235,7 +235,8 @@ static int vgsvcGstCtrlInvalidate(void)
                                       | VBOX_GUESTCTRL_GF_0_TOOLBOX_AS_CMDS
 #endif /* VBOX_WITH_GSTCTL_TOOLBOX_AS_CMDS */
                                       | VBOX_GUESTCTRL_GF_0_SHUTDOWN
-                                      | VBOX_GUESTCTRL_GF_0_MOUNT_POINTS_ENUM;
+                                      | VBOX_GUESTCTRL_GF_0_MOUNT_POINTS_ENUM
+                                      | VBOX_GUESTCTRL_GF_0_FILE_BIG_CHUNKS;
         rc = VbglR3GuestCtrlReportFeatures(g_idControlSvcClient, fGuestFeatures, &g_fControlHostFeatures0);
         if (RT_SUCCESS(rc))
             VGSvcVerbose(3, "Host features: %#RX64\n", g_fControlHostFeatures0);
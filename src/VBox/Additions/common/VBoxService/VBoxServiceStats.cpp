@@ -57,6 +57,7 @@
 
 #endif
 
+#include <iprt/asm.h>
 #include <iprt/assert.h>
 #include <iprt/mem.h>
 #include <iprt/ldr.h>
@@ -85,6 +86,12 @@ typedef struct VBOXSTATSCONTEXT
     uint64_t        au64LastCpuLoad_User[VMM_MAX_CPU_COUNT];
     uint64_t        au64LastCpuLoad_Nice[VMM_MAX_CPU_COUNT];
 
+    /** The statistics page registered with the host, NULL if we're using
+     *  VMMDevReq_ReportGuestStats requests. */
+    VMMDevStatsPage *pStatsPage;
+    /** Where vgsvcVMStatsReport stages the statistics page content. */
+    VMMDevStatsPage StagedPage;
+
 #ifdef RT_OS_WINDOWS
     DECLCALLBACKMEMBER_EX(NTSTATUS, WINAPI, pfnNtQuerySystemInformation,(SYSTEM_INFORMATION_CLASS SystemInformationClass,
                                                                          PVOID SystemInformation, ULONG SystemInformationLength,
@@ -160,6 +167,172 @@ static DECLCALLBACK(int) vgsvcVMStatsInit(void)
 }
 
 
+/**
+ * Passes a statistics report on to the host.
+ *
+ * When the statistics page is registered, the report is merged into the
+ * staged page content instead and published by vgsvcVMStatsPagePublish.
+ *
+ * @returns VBox status code.
+ * @param   pReq        The report.
+ */
+static int vgsvcVMStatsSubmit(VMMDevReportGuestStats *pReq)
+{
+    if (!g_VMStat.pStatsPage)
+        return VbglR3StatReport(pReq);
+
+    VMMDevStatsPage           *pPage  = &g_VMStat.StagedPage;
+    VBoxGuestStatistics const *pStats = &pReq->guestStats;
+    uint32_t const fCpuCaps = VBOX_GUEST_STAT_CPU_LOAD_IDLE | VBOX_GUEST_STAT_CPU_LOAD_KERNEL | VBOX_GUEST_STAT_CPU_LOAD_USER;
+    if (   (pStats->u32StatCaps & fCpuCaps)
+        && pStats->u32CpuId < VMMDEV_STATS_PAGE_MAX_CPUS)
+    {
+        VMMDevStatsPageCpu *pCpu = &pPage->aCpus[pStats->u32CpuId];
+        pCpu->u32CpuLoad_Idle   = pStats->u32CpuLoad_Idle;
+        pCpu->u32CpuLoad_Kernel = pStats->u32CpuLoad_Kernel;
+        pCpu->u32CpuLoad_User   = pStats->u32CpuLoad_User;
+        pPage->cCpus = RT_MAX(pPage->cCpus, pStats->u32CpuId + 1);
+    }
+
+    /* The non-CPU values are the same in each per CPU report. */
+    pPage->u32StatCaps          |= pStats->u32StatCaps;
+    pPage->u32PageSize           = pStats->u32PageSize;
+    pPage->u32MemoryLoad         = pStats->u32MemoryLoad;
+    pPage->u32PhysMemTotal       = pStats->u32PhysMemTotal;
+    pPage->u32PhysMemAvail       = pStats->u32PhysMemAvail;
+    pPage->u32PhysMemBalloon     = pStats->u32PhysMemBalloon;
+    pPage->u32MemCommitTotal     = pStats->u32MemCommitTotal;
+    pPage->u32MemKernelTotal     = pStats->u32MemKernelTotal;
+    pPage->u32MemKernelPaged     = pStats->u32MemKernelPaged;
+    pPage->u32MemKernelNonPaged  = pStats->u32MemKernelNonPaged;
+    pPage->u32MemSystemCache     = pStats->u32MemSystemCache;
+    pPage->u32PageFileSize       = pStats->u32PageFileSize;
+    pPage->u32Threads            = pStats->u32Threads;
+    pPage->u32Processes          = pStats->u32Processes;
+    pPage->u32Handles            = pStats->u32Handles;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Registers the statistics page with the host.
+ *
+ * Failure is not fatal, we just keep using VMMDevReq_ReportGuestStats.
+ */
+static void vgsvcVMStatsPageRegister(void)
+{
+    AssertCompile(sizeof(VMMDevStatsPage) <= _4K);
+    VMMDevStatsPage *pPage = (VMMDevStatsPage *)RTMemPageAllocZ(PAGE_SIZE);
+    if (pPage)
+    {
+        pPage->u32Magic   = VMMDEV_STATS_PAGE_MAGIC;
+        pPage->u32Version = VMMDEV_STATS_PAGE_VERSION;
+        int rc = VbglR3StatSetPage(pPage);
+        if (RT_SUCCESS(rc))
+        {
+            VGSvcVerbose(1, "vgsvcVMStatsPageRegister: Using the statistics page\n");
+            g_VMStat.pStatsPage = pPage;
+            return;
+        }
+        VGSvcVerbose(1, "vgsvcVMStatsPageRegister: VbglR3StatSetPage failed with %Rrc, using requests\n", rc);
+        RTMemPageFree(pPage, PAGE_SIZE);
+    }
+}
+
+
+/**
+ * Counter to vgsvcVMStatsPageRegister.
+ */
+static void vgsvcVMStatsPageUnregister(void)
+{
+    if (g_VMStat.pStatsPage)
+    {
+        int rc = VbglR3StatClearPage();
+        if (RT_SUCCESS(rc))
+            RTMemPageFree(g_VMStat.pStatsPage, PAGE_SIZE);
+        else
+            VGSvcError("vgsvcVMStatsPageUnregister: VbglR3StatClearPage failed with %Rrc\n", rc); /* leak it */
+        g_VMStat.pStatsPage = NULL;
+    }
+}
+
+
+/**
+ * Copies the staged statistics into the registered page.
+ *
+ * u32Seq is odd while we are at it, so the host can tell torn samples apart.
+ */
+static void vgsvcVMStatsPagePublish(void)
+{
+    VMMDevStatsPage *pPage = g_VMStat.pStatsPage;
+    uint32_t const   uSeq  = pPage->u32Seq;
+    ASMAtomicWriteU32(&pPage->u32Seq, uSeq + 1);
+
+    g_VMStat.StagedPage.u32Magic   = VMMDEV_STATS_PAGE_MAGIC;
+    g_VMStat.StagedPage.u32Version = VMMDEV_STATS_PAGE_VERSION;
+    g_VMStat.StagedPage.u32Seq     = uSeq + 1;
+    memcpy(pPage, &g_VMStat.StagedPage, sizeof(*pPage));
+
+    ASMAtomicWriteU32(&pPage->u32Seq, uSeq + 2);
+}
+
+
+#ifdef RT_OS_LINUX
+/**
+ * Gathers the values only found in the statistics page: the number of
+ * runnable threads and the memory pressure (PSI).
+ *
+ * @param   pPage       The staged page.
+ */
+static void vgsvcVMStatsLinuxPageExtras(VMMDevStatsPage *pPage)
+{
+    PRTSTREAM pStrm;
+    char szLine[256];
+    char *psz;
+
+    int rc = RTStrmOpen("/proc/stat", "r", &pStrm);
+    if (RT_SUCCESS(rc))
+    {
+        while (RT_SUCCESS(RTStrmGetLine(pStrm, szLine, sizeof(szLine))))
+            if (strstr(szLine, "procs_running") == szLine)
+            {
+                /* This includes us, so subtract one. */
+                uint32_t cRunnable;
+                rc = RTStrToUInt32Ex(RTStrStripL(&szLine[13]), &psz, 0, &cRunnable);
+                if (RT_SUCCESS(rc))
+                {
+                    pPage->cRunnable    = cRunnable > 0 ? cRunnable - 1 : 0;
+                    pPage->u32StatCaps |= VBOX_GUEST_STAT_RUN_QUEUE;
+                }
+                break;
+            }
+        RTStrmClose(pStrm);
+    }
+
+    /* "some avg10=1.23 avg60=0.50 avg300=0.10 total=12345" */
+    rc = RTStrmOpen("/proc/pressure/memory", "r", &pStrm);
+    if (RT_SUCCESS(rc))
+    {
+        if (   RT_SUCCESS(RTStrmGetLine(pStrm, szLine, sizeof(szLine)))
+            && (psz = strstr(szLine, "avg10=")) != NULL)
+        {
+            uint32_t uInt  = 0;
+            uint32_t uFrac = 0;
+            rc = RTStrToUInt32Ex(&psz[6], &psz, 10, &uInt);
+            if (rc == VWRN_TRAILING_CHARS && *psz == '.')
+                rc = RTStrToUInt32Ex(psz + 1, &psz, 10, &uFrac);
+            if (RT_SUCCESS(rc) && uInt <= 100 && uFrac < 100)
+            {
+                pPage->uMemPressure = uInt * 100 + uFrac;
+                pPage->u32StatCaps |= VBOX_GUEST_STAT_MEM_PRESSURE;
+            }
+        }
+        RTStrmClose(pStrm);
+    }
+}
+#endif /* RT_OS_LINUX */
+
+
 /**
  * Gathers VM statistics and reports them to the host.
  */
@@ -277,11 +450,11 @@ static void vgsvcVMStatsReport(void)
                                             |  VBOX_GUEST_STAT_CPU_LOAD_USER;
             req.guestStats.u32CpuId          = i;
             fCpuInfoAvail = true;
-            int rc = VbglR3StatReport(&req);
+            int rc = vgsvcVMStatsSubmit(&req);
             if (RT_SUCCESS(rc))
                 VGSvcVerbose(3, "vgsvcVMStatsReport: new statistics (CPU %u) reported successfully!\n", i);
             else
-                VGSvcVerbose(3, "vgsvcVMStatsReport: VbglR3StatReport failed with rc=%Rrc\n", rc);
+                VGSvcVerbose(3, "vgsvcVMStatsReport: stats report failed with rc=%Rrc\n", rc);
 
             g_VMStat.au64LastCpuLoad_Idle[i]    = pProcInfo[i].IdleTime.QuadPart;
             g_VMStat.au64LastCpuLoad_Kernel[i]  = pProcInfo[i].KernelTime.QuadPart;
@@ -293,7 +466,7 @@ static void vgsvcVMStatsReport(void)
     if (!fCpuInfoAvail)
     {
         VGSvcVerbose(3, "vgsvcVMStatsReport: CPU info not available!\n");
-        int rc = VbglR3StatReport(&req);
+        int rc = vgsvcVMStatsSubmit(&req);
         if (RT_SUCCESS(rc))
             VGSvcVerbose(3, "vgsvcVMStatsReport: new statistics reported successfully!\n");
         else
@@ -438,7 +611,7 @@ static void vgsvcVMStatsReport(void)
                                                |  VBOX_GUEST_STAT_CPU_LOAD_USER;
                     req.guestStats.u32CpuId = u32CpuId;
                     fCpuInfoAvail = true;
-                    rc = VbglR3StatReport(&req);
+                    rc = vgsvcVMStatsSubmit(&req);
                     if (RT_SUCCESS(rc))
                         VGSvcVerbose(3, "vgsvcVMStatsReport: new statistics (CPU %u) reported successfully!\n", u32CpuId);
                     else
@@ -453,7 +626,7 @@ static void vgsvcVMStatsReport(void)
     if (!fCpuInfoAvail)
     {
         VGSvcVerbose(3, "vgsvcVMStatsReport: CPU info not available!\n");
-        rc = VbglR3StatReport(&req);
+        rc = vgsvcVMStatsSubmit(&req);
         if (RT_SUCCESS(rc))
             VGSvcVerbose(3, "vgsvcVMStatsReport: new statistics reported successfully!\n");
         else
@@ -593,7 +766,7 @@ static void vgsvcVMStatsReport(void)
                                                |  VBOX_GUEST_STAT_CPU_LOAD_KERNEL
                                                |  VBOX_GUEST_STAT_CPU_LOAD_USER;
                     fCpuInfoAvail = true;
-                    rc = VbglR3StatReport(&req);
+                    rc = vgsvcVMStatsSubmit(&req);
                     if (RT_SUCCESS(rc))
                         VGSvcVerbose(3, "vgsvcVMStatsReport: new statistics (CPU %u) reported successfully!\n", cCPUs);
                     else
@@ -611,7 +784,7 @@ static void vgsvcVMStatsReport(void)
         if (!fCpuInfoAvail)
         {
             VGSvcVerbose(3, "vgsvcVMStatsReport: CPU info not available!\n");
-            rc = VbglR3StatReport(&req);
+            rc = vgsvcVMStatsSubmit(&req);
             if (RT_SUCCESS(rc))
                 VGSvcVerbose(3, "vgsvcVMStatsReport: new statistics reported successfully!\n");
             else
@@ -647,6 +820,8 @@ static DECLCALLBACK(int) vgsvcVMStatsWorker(bool volatile *pfShutdown)
      */
     RTThreadUserSignal(RTThreadSelf());
 
+    vgsvcVMStatsPageRegister();
+
     /*
      * Now enter the loop retrieving runtime data continuously.
      */
@@ -663,8 +838,22 @@ static DECLCALLBACK(int) vgsvcVMStatsWorker(bool volatile *pfShutdown)
 
         if (g_VMStat.cMsStatInterval)
         {
-            vgsvcVMStatsReport();
-            cWaitMillies = g_VMStat.cMsStatInterval;
+            if (g_VMStat.pStatsPage)
+            {
+                /* Updating the page causes no VM exits, so refresh it at the rate the host samples it. */
+                RT_ZERO(g_VMStat.StagedPage);
+                vgsvcVMStatsReport();
+#ifdef RT_OS_LINUX
+                vgsvcVMStatsLinuxPageExtras(&g_VMStat.StagedPage);
+#endif
+                vgsvcVMStatsPagePublish();
+                cWaitMillies = RT_MIN(g_VMStat.cMsStatInterval, RT_MS_1SEC);
+            }
+            else
+            {
+                vgsvcVMStatsReport();
+                cWaitMillies = g_VMStat.cMsStatInterval;
+            }
         }
         else
             cWaitMillies = 3000;
@@ -687,6 +876,8 @@ static DECLCALLBACK(int) vgsvcVMStatsWorker(bool volatile *pfShutdown)
         }
     }
 
+    vgsvcVMStatsPageUnregister();
+
     /* Cancel monitoring of the stat event change event. */
     int rc2 = VbglR3CtlFilterMask(0, VMMDEV_EVENT_STATISTICS_INTERVAL_CHANGE_REQUEST);
     if (RT_FAILURE(rc2))
@@ -54,9 +54,18 @@
 /** Character indicating the end of a packet (excluding the checksum). */
 #define GDBSTUB_PKT_END                     '#'
 /** The escape character. */
-#define GDBSTUB_PKT_ESCAPE                  '{'
+#define GDBSTUB_PKT_ESCAPE                  '}'
+/** The value escaped characters are XORed with. */
+#define GDBSTUB_PKT_ESCAPE_XOR              0x20
 /** The out-of-band interrupt character. */
 #define GDBSTUB_OOB_INTERRUPT               0x03
+/** The maximum packet size we advertise to the remote end through qSupported,
+ * large enough to let GDB fetch big chunks of memory with a single request. */
+#define GDBSTUB_PKT_SIZE_MAX                _64K
+/** Size of the guest memory read-ahead cache. */
+#define GDBSTUB_MEM_CACHE_SIZE              _16K
+/** Alignment of the guest memory read-ahead cache. */
+#define GDBSTUB_MEM_CACHE_ALIGN             _4K
 
 
 /** Indicate support for the 'qXfer:features:read' packet to support the target description. */
@@ -170,6 +179,16 @@ typedef struct GDBSTUBCTX
     size_t                      cbChksumRecvLeft;
     /** Send packet checksum. */
     uint8_t                     uChkSumSend;
+    /** Output buffer, everything is collected in here and sent with a single write
+     * to avoid sending lots of tiny TCP segments. */
+    uint8_t                     *pbOutBuf;
+    /** Size of the output buffer in bytes. */
+    size_t                      cbOutBufMax;
+    /** Number of bytes queued in the output buffer. */
+    size_t                      offOutBuf;
+    /** Offset of the reply packet currently being assembled in the output buffer,
+     * ~(size_t)0 if there is none. */
+    size_t                      offOutBufPkt;
     /** Feature flags supported we negotiated with the remote end. */
     uint32_t                    fFeatures;
     /** Pointer to the XML target description. */
@@ -193,6 +212,18 @@ typedef struct GDBSTUBCTX
     bool                        fInThrdInfoQuery;
     /** Next ID to return in the current ThreadInfo query. */
     VMCPUID                     idCpuNextThrdInfoQuery;
+    /** Pointer to the XML thread list for the 'qXfer:threads:read' query, created at offset 0. */
+    char                        *pachThrdXml;
+    /** Size of the XML thread list. */
+    size_t                      cbThrdXml;
+    /** Guest memory read-ahead cache, allocated on first use. */
+    uint8_t                     *pbMemCache;
+    /** The guest address the cached data starts at. */
+    uint64_t                    GdbTgtAddrMemCache;
+    /** Number of valid bytes in the cache, 0 if the cache is invalid. */
+    size_t                      cbMemCacheValid;
+    /** The VCPU the cached data was read with. */
+    VMCPUID                     idCpuMemCache;
 } GDBSTUBCTX;
 /** Pointer to the GDB stub context data. */
 typedef GDBSTUBCTX *PGDBSTUBCTX;
@@ -413,6 +444,53 @@ DECLINLINE(int) dbgcGdbStubCtxWrite(PGDBSTUBCTX pThis, const void *pvPkt, size_t
 }
 
 
+/**
+ * Queues the given data in the output buffer.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pvData              The data to queue.
+ * @param   cbData              Size of the data in bytes.
+ */
+static int dbgcGdbStubCtxOutQueue(PGDBSTUBCTX pThis, const void *pvData, size_t cbData)
+{
+    if (pThis->cbOutBufMax - pThis->offOutBuf < cbData)
+    {
+        size_t cbOutBufMaxNew = RT_MAX(pThis->cbOutBufMax * 2, pThis->offOutBuf + cbData);
+        cbOutBufMaxNew = RT_ALIGN_Z(cbOutBufMaxNew, _4K);
+        void *pvNew = RTMemRealloc(pThis->pbOutBuf, cbOutBufMaxNew);
+        if (!pvNew)
+            return VERR_NO_MEMORY;
+
+        pThis->pbOutBuf    = (uint8_t *)pvNew;
+        pThis->cbOutBufMax = cbOutBufMaxNew;
+    }
+
+    memcpy(&pThis->pbOutBuf[pThis->offOutBuf], pvData, cbData);
+    pThis->offOutBuf += cbData;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Sends everything queued in the output buffer with a single write.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int dbgcGdbStubCtxOutFlush(PGDBSTUBCTX pThis)
+{
+    int rc = VINF_SUCCESS;
+    if (pThis->offOutBuf)
+    {
+        rc = dbgcGdbStubCtxWrite(pThis, pThis->pbOutBuf, pThis->offOutBuf);
+        pThis->offOutBuf = 0;
+    }
+
+    return rc;
+}
+
+
 /**
  * Starts transmission of a new reply packet.
  *
@@ -421,10 +499,11 @@ DECLINLINE(int) dbgcGdbStubCtxWrite(PGDBSTUBCTX pThis, const void *pvPkt, size_t
  */
 static int dbgcGdbStubCtxReplySendBegin(PGDBSTUBCTX pThis)
 {
-    pThis->uChkSumSend = 0;
+    pThis->uChkSumSend  = 0;
+    pThis->offOutBufPkt = pThis->offOutBuf;
 
     uint8_t chPktStart = GDBSTUB_PKT_START;
-    return dbgcGdbStubCtxWrite(pThis, &chPktStart, sizeof(chPktStart));
+    return dbgcGdbStubCtxOutQueue(pThis, &chPktStart, sizeof(chPktStart));
 }
 
 
@@ -443,7 +522,52 @@ static int dbgcGdbStubCtxReplySendData(PGDBSTUBCTX pThis, const void *pvReplyDat
     for (uint32_t i = 0; i < cbReplyData; i++)
         pThis->uChkSumSend += pbData[i];
 
-    return dbgcGdbStubCtxWrite(pThis, pvReplyData, cbReplyData);
+    return dbgcGdbStubCtxOutQueue(pThis, pvReplyData, cbReplyData);
+}
+
+
+/**
+ * Sends the given binary data in the reply, escaping the characters with a special
+ * meaning in the protocol.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pvReplyData         The reply data to send.
+ * @param   cbReplyData         Size of the reply data in bytes.
+ */
+static int dbgcGdbStubCtxReplySendBinData(PGDBSTUBCTX pThis, const void *pvReplyData, size_t cbReplyData)
+{
+    const uint8_t *pbData = (const uint8_t *)pvReplyData;
+    int rc = VINF_SUCCESS;
+
+    while (   cbReplyData
+           && RT_SUCCESS(rc))
+    {
+        uint8_t abEsc[512];
+        size_t  cbEsc = 0;
+
+        while (   cbReplyData
+               && cbEsc < sizeof(abEsc) - 1) /* Escaping needs two bytes. */
+        {
+            uint8_t const b = *pbData++;
+            cbReplyData--;
+
+            if (   b == GDBSTUB_PKT_START
+                || b == GDBSTUB_PKT_END
+                || b == GDBSTUB_PKT_ESCAPE
+                || b == '*') /* Run length encoding. */
+            {
+                abEsc[cbEsc++] = GDBSTUB_PKT_ESCAPE;
+                abEsc[cbEsc++] = b ^ GDBSTUB_PKT_ESCAPE_XOR;
+            }
+            else
+                abEsc[cbEsc++] = b;
+        }
+
+        rc = dbgcGdbStubCtxReplySendData(pThis, &abEsc[0], cbEsc);
+    }
+
+    return rc;
 }
 
 
@@ -461,7 +585,26 @@ static int dbgcGdbStubCtxReplySendEnd(PGDBSTUBCTX pThis)
     achPktEnd[1] = dbgcGdbStubCtxHexToChr(pThis->uChkSumSend >> 4);
     achPktEnd[2] = dbgcGdbStubCtxHexToChr(pThis->uChkSumSend & 0xf);
 
-    return dbgcGdbStubCtxWrite(pThis, &achPktEnd[0], sizeof(achPktEnd));
+    int rc = dbgcGdbStubCtxOutQueue(pThis, &achPktEnd[0], sizeof(achPktEnd));
+    pThis->offOutBufPkt = ~(size_t)0;
+    if (RT_SUCCESS(rc))
+        rc = dbgcGdbStubCtxOutFlush(pThis);
+    return rc;
+}
+
+
+/**
+ * Drops the reply currently being assembled, if any.
+ *
+ * @param   pThis               The GDB stub context.
+ */
+static void dbgcGdbStubCtxReplySendAbort(PGDBSTUBCTX pThis)
+{
+    if (pThis->offOutBufPkt != ~(size_t)0)
+    {
+        pThis->offOutBuf    = pThis->offOutBufPkt;
+        pThis->offOutBufPkt = ~(size_t)0;
+    }
 }
 
 
@@ -668,6 +811,75 @@ static int dbgcGdbStubCtxEnsurePktBufSpace(PGDBSTUBCTX pThis, size_t cbSpace)
 }
 
 
+/**
+ * Invalidates the guest memory read-ahead cache.
+ *
+ * Must be called whenever the guest gets the chance to run or something might have
+ * changed the guest memory or the address translation.
+ *
+ * @param   pThis               The GDB stub context.
+ */
+DECLINLINE(void) dbgcGdbStubCtxMemCacheInvalidate(PGDBSTUBCTX pThis)
+{
+    pThis->cbMemCacheValid = 0;
+}
+
+
+/**
+ * Reads guest memory going through the read-ahead cache.
+ *
+ * GDB tends to read memory in lots of tiny chunks when walking the stack or looking
+ * at data structures, so small reads fetch a bigger aligned block and the following
+ * requests are served from it.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtAddr          The guest address to read from.
+ * @param   pvBuf               Where to store the read data.
+ * @param   cbRead              Number of bytes to read.
+ */
+static int dbgcGdbStubCtxMemRead(PGDBSTUBCTX pThis, uint64_t GdbTgtAddr, void *pvBuf, size_t cbRead)
+{
+    if (   pThis->cbMemCacheValid
+        && pThis->idCpuMemCache == pThis->Dbgc.idCpu
+        && GdbTgtAddr >= pThis->GdbTgtAddrMemCache
+        && GdbTgtAddr - pThis->GdbTgtAddrMemCache <= pThis->cbMemCacheValid
+        && cbRead <= pThis->cbMemCacheValid - (GdbTgtAddr - pThis->GdbTgtAddrMemCache))
+    {
+        memcpy(pvBuf, &pThis->pbMemCache[GdbTgtAddr - pThis->GdbTgtAddrMemCache], cbRead);
+        return VINF_SUCCESS;
+    }
+
+    DBGFADDRESS AddrRead;
+    uint64_t const GdbTgtAddrCache = GdbTgtAddr & ~(uint64_t)(GDBSTUB_MEM_CACHE_ALIGN - 1);
+    if (   cbRead <= GDBSTUB_MEM_CACHE_SIZE - GDBSTUB_MEM_CACHE_ALIGN
+        && GdbTgtAddrCache + GDBSTUB_MEM_CACHE_SIZE > GdbTgtAddrCache) /* No wraparound. */
+    {
+        if (!pThis->pbMemCache)
+            pThis->pbMemCache = (uint8_t *)RTMemAlloc(GDBSTUB_MEM_CACHE_SIZE);
+        if (pThis->pbMemCache)
+        {
+            pThis->cbMemCacheValid = 0;
+
+            DBGFR3AddrFromFlat(pThis->Dbgc.pUVM, &AddrRead, GdbTgtAddrCache);
+            int rc = DBGFR3MemRead(pThis->Dbgc.pUVM, pThis->Dbgc.idCpu, &AddrRead, pThis->pbMemCache, GDBSTUB_MEM_CACHE_SIZE);
+            if (RT_SUCCESS(rc))
+            {
+                pThis->GdbTgtAddrMemCache = GdbTgtAddrCache;
+                pThis->cbMemCacheValid    = GDBSTUB_MEM_CACHE_SIZE;
+                pThis->idCpuMemCache      = pThis->Dbgc.idCpu;
+                memcpy(pvBuf, &pThis->pbMemCache[GdbTgtAddr - GdbTgtAddrCache], cbRead);
+                return VINF_SUCCESS;
+            }
+            /* The read-ahead most likely touched an unmapped page, read only what was asked for below. */
+        }
+    }
+
+    DBGFR3AddrFromFlat(pThis->Dbgc.pUVM, &AddrRead, GdbTgtAddr);
+    return DBGFR3MemRead(pThis->Dbgc.pUVM, pThis->Dbgc.idCpu, &AddrRead, pvBuf, cbRead);
+}
+
+
 /**
  * Parses the arguments of a 'Z' and 'z' packet.
  *
@@ -832,11 +1044,13 @@ static int dbgcGdbStubCtxQueryPktQueryFeatureLen(const uint8_t *pbArgs, size_t c
  */
 static int dbgcGdbStubCtxPktProcessQuerySupportedReply(PGDBSTUBCTX pThis)
 {
-    /** @todo Enhance. */
-    if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_TGT_DESC)
-        return dbgcGdbStubCtxReplySend(pThis, "qXfer:features:read+;vContSupported+", sizeof("qXfer:features:read+;vContSupported+") - 1);
-
-    return dbgcGdbStubCtxReplySend(pThis, NULL, 0);
+    char szReply[128];
+    ssize_t cchReply = RTStrPrintf2(&szReply[0], sizeof(szReply),
+                                    "PacketSize=%x;binary-upload+;qXfer:threads:read+;%svContSupported+",
+                                    GDBSTUB_PKT_SIZE_MAX,
+                                    pThis->fFeatures & GDBSTUBCTX_FEATURES_F_TGT_DESC ? "qXfer:features:read+;" : "");
+    AssertReturn(cchReply > 0, VERR_BUFFER_OVERFLOW);
+    return dbgcGdbStubCtxReplySend(pThis, &szReply[0], (size_t)cchReply);
 }
 
 
@@ -940,19 +1154,23 @@ static int dbgcGdbStubCtxQueryXferReadReply(PGDBSTUBCTX pThis, uint32_t offRead,
     int rc = VINF_SUCCESS;
     if (offRead < cbObj)
     {
-        /** @todo Escaping */
         size_t cbThisRead = offRead + cbRead < cbObj ? cbRead : cbObj - offRead;
 
-        rc = dbgcGdbStubCtxEnsurePktBufSpace(pThis, cbThisRead + 1);
+        rc = dbgcGdbStubCtxReplySendBegin(pThis);
         if (RT_SUCCESS(rc))
         {
-            uint8_t *pbPktBuf = pThis->pbPktBuf;
-            *pbPktBuf++ = cbThisRead < cbRead ? 'l' : 'm';
-            memcpy(pbPktBuf, pbObj + offRead, cbThisRead);
-            rc = dbgcGdbStubCtxReplySend(pThis, pThis->pbPktBuf, cbThisRead + 1);
+            uint8_t bReplyStart = cbThisRead < cbRead ? 'l' : 'm';
+            rc = dbgcGdbStubCtxReplySendData(pThis, &bReplyStart, sizeof(bReplyStart));
+            if (RT_SUCCESS(rc))
+                rc = dbgcGdbStubCtxReplySendBinData(pThis, pbObj + offRead, cbThisRead);
+            if (RT_SUCCESS(rc))
+                rc = dbgcGdbStubCtxReplySendEnd(pThis);
+            else
+            {
+                dbgcGdbStubCtxReplySendAbort(pThis);
+                rc = dbgcGdbStubCtxReplySendErrSts(pThis, rc);
+            }
         }
-        else
-            rc = dbgcGdbStubCtxReplySendErrSts(pThis, VERR_NO_MEMORY);
     }
     else if (offRead == cbObj)
         rc = dbgcGdbStubCtxReplySend(pThis, "l", sizeof("l") - 1);
@@ -1258,6 +1476,53 @@ static int dbgcGdbStubCtxTgtXmlDescCreate(PGDBSTUBCTX pThis)
 }
 
 
+/**
+ * Creates the XML thread list returned by the 'qXfer:threads:read' query.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int dbgcGdbStubCtxThrdXmlCreate(PGDBSTUBCTX pThis)
+{
+    RTStrFree(pThis->pachThrdXml);
+    pThis->pachThrdXml = NULL;
+    pThis->cbThrdXml   = 0;
+
+    VMCPUID const cCpus = DBGFR3CpuGetCount(pThis->Dbgc.pUVM);
+    size_t const  cbXml = 64 + cCpus * 128;
+    char *pachXmlCur = RTStrAlloc(cbXml);
+    if (!pachXmlCur)
+        return VERR_NO_MEMORY;
+
+    pThis->pachThrdXml = pachXmlCur;
+    size_t cbLeft = cbXml;
+    int rc = RTStrCatP(&pachXmlCur, &cbLeft, "<?xml version=\"1.0\"?>\n<threads>\n");
+    for (VMCPUID idCpu = 0; idCpu < cCpus && RT_SUCCESS(rc); idCpu++)
+    {
+        const char *pszCpuState = DBGFR3CpuGetState(pThis->Dbgc.pUVM, idCpu);
+        if (!pszCpuState)
+            pszCpuState = "DBGFR3CpuGetState() -> NULL";
+
+        /* The thread IDs must match the ones handed out by the ThreadInfo queries. */
+        ssize_t cchStr = RTStrPrintf2(pachXmlCur, cbLeft, "<thread id=\"%02x\" core=\"%u\" name=\"vCPU %u\">%s</thread>\n",
+                                      idCpu + 1, idCpu, idCpu, pszCpuState);
+        if (cchStr > 0)
+        {
+            pachXmlCur += cchStr;
+            cbLeft     -= cchStr;
+        }
+        else
+            rc = VERR_BUFFER_OVERFLOW;
+    }
+
+    if (RT_SUCCESS(rc))
+        rc = RTStrCatP(&pachXmlCur, &cbLeft, "</threads>\n");
+
+    pThis->cbThrdXml = cbXml - cbLeft;
+    return rc;
+}
+
+
 /**
  * Returns the GDB register descriptor describing the given DBGF register enum.
  *
@@ -1373,6 +1638,57 @@ static DECLCALLBACK(int) dbgcGdbStubCtxPktProcessQueryXferFeatRead(PGDBSTUBCTX p
 }
 
 
+/**
+ * Processes the 'Xfer:threads:read' query, returning all VCPUs with a single request
+ * instead of the qfThreadInfo/qsThreadInfo/qThreadExtraInfo round trips for each one.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static DECLCALLBACK(int) dbgcGdbStubCtxPktProcessQueryXferThrdRead(PGDBSTUBCTX pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    /* Skip the : following the Xfer:threads:read start. */
+    if (   cbArgs < 1
+        || pbArgs[0] != ':')
+        return VERR_NET_PROTOCOL_ERROR;
+
+    cbArgs--;
+    pbArgs++;
+
+    /* Parse annex (must be empty), offset and length and return the data. */
+    const char *pchAnnex = NULL;
+    size_t cchAnnex = 0;
+    uint32_t offRead = 0;
+    size_t cbRead = 0;
+
+    int rc = dbgcGdbStubCtxPktProcessQueryXferParseAnnexOffLen(pbArgs, cbArgs,
+                                                               &pchAnnex, &cchAnnex,
+                                                               &offRead, &cbRead);
+    if (RT_SUCCESS(rc))
+    {
+        if (!cchAnnex)
+        {
+            /* Take a fresh snapshot when a new transfer starts so the chunks don't get out of sync. */
+            if (!offRead || !pThis->pachThrdXml)
+                rc = dbgcGdbStubCtxThrdXmlCreate(pThis);
+            if (RT_SUCCESS(rc))
+                rc = dbgcGdbStubCtxQueryXferReadReply(pThis, offRead, cbRead, (const uint8_t *)pThis->pachThrdXml,
+                                                      pThis->cbThrdXml);
+            else
+                rc = dbgcGdbStubCtxReplySendErrSts(pThis, rc);
+        }
+        else
+            rc = dbgcGdbStubCtxReplySendErr(pThis, 0);
+    }
+    else
+        rc = dbgcGdbStubCtxReplySendErrSts(pThis, rc);
+
+    return rc;
+}
+
+
 /**
  * Processes the 'Rcmd' query.
  *
@@ -1578,6 +1894,7 @@ static const GDBSTUBQPKTPROC g_aQPktProcs[] =
     GDBSTUBQPKTPROC_INIT("TStatus",            dbgcGdbStubCtxPktProcessQueryTStatus),
     GDBSTUBQPKTPROC_INIT("Supported",          dbgcGdbStubCtxPktProcessQuerySupported),
     GDBSTUBQPKTPROC_INIT("Xfer:features:read", dbgcGdbStubCtxPktProcessQueryXferFeatRead),
+    GDBSTUBQPKTPROC_INIT("Xfer:threads:read",  dbgcGdbStubCtxPktProcessQueryXferThrdRead),
     GDBSTUBQPKTPROC_INIT("Rcmd",               dbgcGdbStubCtxPktProcessQueryRcmd),
     GDBSTUBQPKTPROC_INIT("fThreadInfo",        dbgcGdbStubCtxPktProcessQueryThreadInfoStart),
     GDBSTUBQPKTPROC_INIT("sThreadInfo",        dbgcGdbStubCtxPktProcessQueryThreadInfoCont),
@@ -1629,6 +1946,9 @@ static DECLCALLBACK(int) dbgcGdbStubCtxPktProcessVCont(PGDBSTUBCTX pThis, const
     pbArgs++;
     /*cbArgs--;*/ /* Not used */
 
+    /* The guest is going to run, so whatever was read ahead is stale afterwards. */
+    dbgcGdbStubCtxMemCacheInvalidate(pThis);
+
     /** @todo For now we don't care about multiple threads and ignore thread IDs and multiple actions. */
     switch (pbArgs[0])
     {
@@ -1791,6 +2111,8 @@ static int dbgcGdbStubCtxPktProcess(PGDBSTUBCTX pThis)
             }
             case 's': /* Single step, response will be sent in the event loop. */
             {
+                dbgcGdbStubCtxMemCacheInvalidate(pThis);
+
                 PDBGFADDRESS pStackPop  = NULL;
                 RTGCPTR      cbStackPop = 0;
                 rc = DBGFR3StepEx(pThis->Dbgc.pUVM, pThis->Dbgc.idCpu, DBGF_STEP_F_INTO, NULL,
@@ -1801,6 +2123,7 @@ static int dbgcGdbStubCtxPktProcess(PGDBSTUBCTX pThis)
             }
             case 'c': /* Continue, no response */
             {
+                dbgcGdbStubCtxMemCacheInvalidate(pThis);
                 if (DBGFR3IsHalted(pThis->Dbgc.pUVM, VMCPUID_ALL))
                     DBGFR3Resume(pThis->Dbgc.pUVM, VMCPUID_ALL);
                 break;
@@ -1866,7 +2189,9 @@ static int dbgcGdbStubCtxPktProcess(PGDBSTUBCTX pThis)
                 break;
             }
             case 'm': /* Read memory. */
+            case 'x': /* Read memory, binary reply. */
             {
+                bool const fBinary = pThis->pbPktBuf[1] == 'x';
                 uint64_t GdbTgtAddr = 0;
                 const uint8_t *pbPktSep = NULL;
 
@@ -1879,44 +2204,46 @@ static int dbgcGdbStubCtxPktProcess(PGDBSTUBCTX pThis)
                     rc = dbgcGdbStubCtxParseHexStringAsInteger(pbPktSep + 1, pThis->cbPkt - 1 - cbProcessed - 1, &cbRead, GDBSTUB_PKT_END, NULL);
                     if (RT_SUCCESS(rc))
                     {
-                        size_t cbReplyPkt = cbRead * 2 + 1; /* One byte needs two characters. */
+                        /* The reply is assembled directly in the output buffer and dropped again on failure. */
+                        rc = dbgcGdbStubCtxReplySendBegin(pThis);
+                        if (   RT_SUCCESS(rc)
+                            && fBinary)
+                        {
+                            uint8_t bReplyStart = 'b';
+                            rc = dbgcGdbStubCtxReplySendData(pThis, &bReplyStart, sizeof(bReplyStart));
+                        }
 
-                        rc = dbgcGdbStubCtxEnsurePktBufSpace(pThis, cbReplyPkt);
-                        if (RT_SUCCESS(rc))
+                        while (   cbRead
+                               && RT_SUCCESS(rc))
                         {
-                            uint8_t *pbPktBuf = pThis->pbPktBuf;
-                            size_t cbPktBufLeft = cbReplyPkt;
-                            DBGFADDRESS AddrRead;
+                            uint8_t abTmp[_4K];
+                            size_t cbThisRead = RT_MIN(cbRead, sizeof(abTmp));
 
-                            DBGFR3AddrFromFlat(pThis->Dbgc.pUVM, &AddrRead, GdbTgtAddr);
+                            rc = dbgcGdbStubCtxMemRead(pThis, GdbTgtAddr, &abTmp[0], cbThisRead);
+                            if (RT_FAILURE(rc))
+                                break;
 
-                            while (   cbRead
-                                   && RT_SUCCESS(rc))
+                            if (fBinary)
+                                rc = dbgcGdbStubCtxReplySendBinData(pThis, &abTmp[0], cbThisRead);
+                            else
                             {
-                                uint8_t abTmp[_4K];
-                                size_t cbThisRead = RT_MIN(cbRead, sizeof(abTmp));
-
-                                rc = DBGFR3MemRead(pThis->Dbgc.pUVM, pThis->Dbgc.idCpu, &AddrRead, &abTmp[0], cbThisRead);
-                                if (RT_FAILURE(rc))
-                                    break;
-
-                                rc = dbgcGdbStubCtxEncodeBinaryAsHex(pbPktBuf, cbPktBufLeft, &abTmp[0], cbThisRead);
-                                if (RT_FAILURE(rc))
-                                    break;
-
-                                DBGFR3AddrAdd(&AddrRead, cbThisRead);
-                                cbRead       -= cbThisRead;
-                                pbPktBuf     += cbThisRead;
-                                cbPktBufLeft -= cbThisRead;
+                                uint8_t achHex[sizeof(abTmp) * 2 + 1];
+                                rc = dbgcGdbStubCtxEncodeBinaryAsHex(&achHex[0], sizeof(achHex), &abTmp[0], cbThisRead);
+                                if (RT_SUCCESS(rc))
+                                    rc = dbgcGdbStubCtxReplySendData(pThis, &achHex[0], cbThisRead * 2);
                             }
 
-                            if (RT_SUCCESS(rc))
-                                rc = dbgcGdbStubCtxReplySend(pThis, pThis->pbPktBuf, cbReplyPkt);
-                            else
-                                rc = dbgcGdbStubCtxReplySendErrSts(pThis, rc);
+                            GdbTgtAddr += cbThisRead;
+                            cbRead     -= cbThisRead;
                         }
+
+                        if (RT_SUCCESS(rc))
+                            rc = dbgcGdbStubCtxReplySendEnd(pThis);
                         else
+                        {
+                            dbgcGdbStubCtxReplySendAbort(pThis);
                             rc = dbgcGdbStubCtxReplySendErrSts(pThis, rc);
+                        }
                     }
                     else
                         rc = dbgcGdbStubCtxReplySendErrSts(pThis, rc);
@@ -1930,6 +2257,8 @@ static int dbgcGdbStubCtxPktProcess(PGDBSTUBCTX pThis)
                 uint64_t GdbTgtAddr = 0;
                 const uint8_t *pbPktSep = NULL;
 
+                dbgcGdbStubCtxMemCacheInvalidate(pThis);
+
                 rc = dbgcGdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &GdbTgtAddr,
                                                            ',', &pbPktSep);
                 if (RT_SUCCESS(rc))
@@ -2020,6 +2349,8 @@ static int dbgcGdbStubCtxPktProcess(PGDBSTUBCTX pThis)
             {
                 uint64_t uReg = 0;
                 const uint8_t *pbPktSep = NULL;
+
+                dbgcGdbStubCtxMemCacheInvalidate(pThis); /* Might change the address translation (CR3 etc.). */
                 rc = dbgcGdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &uReg,
                                                        '=', &pbPktSep);
                 if (RT_SUCCESS(rc))
@@ -2054,6 +2385,8 @@ static int dbgcGdbStubCtxPktProcess(PGDBSTUBCTX pThis)
                 uint64_t      GdbTgtTpAddr = 0;
                 uint64_t      uKind = 0;
 
+                dbgcGdbStubCtxMemCacheInvalidate(pThis);
+
                 rc = dbgcGdbStubCtxParseTpPktArgs(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &enmTpType, &GdbTgtTpAddr, &uKind);
                 if (RT_SUCCESS(rc))
                 {
@@ -2126,6 +2459,8 @@ static int dbgcGdbStubCtxPktProcess(PGDBSTUBCTX pThis)
                 uint64_t      GdbTgtTpAddr = 0;
                 uint64_t      uKind = 0;
 
+                dbgcGdbStubCtxMemCacheInvalidate(pThis);
+
                 rc = dbgcGdbStubCtxParseTpPktArgs(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &enmTpType, &GdbTgtTpAddr, &uKind);
                 if (RT_SUCCESS(rc))
                 {
@@ -2313,17 +2648,28 @@ static int dbgcGdbStubCtxPktBufProcessChksum(PGDBSTUBCTX pThis, size_t cbData, s
 
         if (uSum == uChkSum)
         {
-            /* Checksum matches, send acknowledge and continue processing the complete payload. */
+            /*
+             * Checksum matches, queue the acknowledge and continue processing the complete payload.
+             * The acknowledge goes out together with the reply if there is an immediate one.
+             */
             char chAck = '+';
-            rc = dbgcGdbStubCtxWrite(pThis, &chAck, sizeof(chAck));
+            rc = dbgcGdbStubCtxOutQueue(pThis, &chAck, sizeof(chAck));
             if (RT_SUCCESS(rc))
                 rc = dbgcGdbStubCtxPktProcess(pThis);
+
+            /* Drop any partial reply left behind by a failure, the acknowledge must go out regardless. */
+            dbgcGdbStubCtxReplySendAbort(pThis);
+            int rc2 = dbgcGdbStubCtxOutFlush(pThis);
+            if (RT_SUCCESS(rc))
+                rc = rc2;
         }
         else
         {
             /* Send NACK and reset for the next packet. */
             char chAck = '-';
-            rc = dbgcGdbStubCtxWrite(pThis, &chAck, sizeof(chAck));
+            rc = dbgcGdbStubCtxOutQueue(pThis, &chAck, sizeof(chAck));
+            if (RT_SUCCESS(rc))
+                rc = dbgcGdbStubCtxOutFlush(pThis);
         }
 
         dbgcGdbStubCtxReset(pThis);
@@ -2419,6 +2765,7 @@ static int dbgcGdbStubCtxProcessEvent(PGDBSTUBCTX pThis, PCDBGFEVENT pEvent)
     PDBGC pDbgc = &pThis->Dbgc;
     pThis->Dbgc.pszScratch = &pThis->Dbgc.achInput[0];
     pThis->Dbgc.iArg       = 0;
+    dbgcGdbStubCtxMemCacheInvalidate(pThis); /* The guest was running. */
     int rc = VINF_SUCCESS;
     switch (pEvent->enmType)
     {
@@ -2835,6 +3182,14 @@ static int dbgcGdbStubCtxCreate(PPGDBSTUBCTX ppGdbStubCtx, PCDBGCIO pIo, unsigne
     pThis->fExtendedMode    = false;
     pThis->fOutput          = false;
     pThis->fInThrdInfoQuery = false;
+    pThis->pbOutBuf         = NULL;
+    pThis->cbOutBufMax      = 0;
+    pThis->offOutBuf        = 0;
+    pThis->offOutBufPkt     = ~(size_t)0;
+    pThis->pachThrdXml      = NULL;
+    pThis->cbThrdXml        = 0;
+    pThis->pbMemCache       = NULL;
+    pThis->cbMemCacheValid  = 0;
     RTListInit(&pThis->LstTps);
     dbgcGdbStubCtxReset(pThis);
 
@@ -2864,6 +3219,13 @@ static void dbgcGdbStubDestroy(PGDBSTUBCTX pThis)
     RTStrFree(pThis->Dbgc.pszHistoryFile);
     pThis->Dbgc.pszHistoryFile = NULL;
 
+    RTMemFree(pThis->pbOutBuf);
+    pThis->pbOutBuf = NULL;
+    RTMemFree(pThis->pbMemCache);
+    pThis->pbMemCache = NULL;
+    RTStrFree(pThis->pachThrdXml);
+    pThis->pachThrdXml = NULL;
+
     /* Finally, free the instance memory. */
     RTMemFree(pThis);
 }
@@ -1405,6 +1405,7 @@ VBoxDbgStatsModel::initNode(PDBGGUISTATSNODE pNode, STAMTYPE enmType, void *pvSa
 
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             pNode->Data.Profile = *(PSTAMPROFILE)pvSample;
             break;
 
@@ -1502,6 +1503,7 @@ VBoxDbgStatsModel::updateNode(PDBGGUISTATSNODE pNode, STAMTYPE enmType, void *pv
 
             case STAMTYPE_PROFILE:
             case STAMTYPE_PROFILE_ADV:
+            case STAMTYPE_HISTOGRAM:
             {
                 uint64_t cPrevPeriods = pNode->Data.Profile.cPeriods;
                 pNode->Data.Profile = *(PSTAMPROFILE)pvSample;
@@ -2588,6 +2590,7 @@ VBoxDbgStatsModel::strValueTimes(PCDBGGUISTATSNODE pNode)
 
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             return formatNumber(sz, pNode->Data.Profile.cPeriods);
 
         case STAMTYPE_RATIO_U32:
@@ -2660,6 +2663,7 @@ VBoxDbgStatsModel::getValueTimesAsUInt(PCDBGGUISTATSNODE pNode)
 
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             return pNode->Data.Profile.cPeriods;
 
         case STAMTYPE_RATIO_U32:
@@ -2716,6 +2720,7 @@ VBoxDbgStatsModel::getValueOrAvgAsUInt(PCDBGGUISTATSNODE pNode)
 
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             if (pNode->Data.Profile.cPeriods)
                 return pNode->Data.Profile.cTicks / pNode->Data.Profile.cPeriods;
             return 0;
@@ -2773,6 +2778,7 @@ VBoxDbgStatsModel::strMinValue(PCDBGGUISTATSNODE pNode)
     {
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             if (pNode->Data.Profile.cPeriods)
                 return formatNumber(sz, pNode->Data.Profile.cTicksMin);
             return "0"; /* cTicksMin is set to UINT64_MAX */
@@ -2789,6 +2795,7 @@ VBoxDbgStatsModel::getMinValueAsUInt(PCDBGGUISTATSNODE pNode)
     {
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             if (pNode->Data.Profile.cPeriods)
                 return pNode->Data.Profile.cTicksMin;
             return 0; /* cTicksMin is set to UINT64_MAX */
@@ -2807,6 +2814,7 @@ VBoxDbgStatsModel::strAvgValue(PCDBGGUISTATSNODE pNode)
     {
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             if (pNode->Data.Profile.cPeriods)
                 return formatNumber(sz, pNode->Data.Profile.cTicks / pNode->Data.Profile.cPeriods);
             return "0";
@@ -2823,6 +2831,7 @@ VBoxDbgStatsModel::getAvgValueAsUInt(PCDBGGUISTATSNODE pNode)
     {
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             if (pNode->Data.Profile.cPeriods)
                 return pNode->Data.Profile.cTicks / pNode->Data.Profile.cPeriods;
             return 0;
@@ -2842,6 +2851,7 @@ VBoxDbgStatsModel::strMaxValue(PCDBGGUISTATSNODE pNode)
     {
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             return formatNumber(sz, pNode->Data.Profile.cTicksMax);
         default:
             return "";
@@ -2856,6 +2866,7 @@ VBoxDbgStatsModel::getMaxValueAsUInt(PCDBGGUISTATSNODE pNode)
     {
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             return pNode->Data.Profile.cTicksMax;
         default:
             return UINT64_MAX;
@@ -2872,6 +2883,7 @@ VBoxDbgStatsModel::strTotalValue(PCDBGGUISTATSNODE pNode)
     {
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             return formatNumber(sz, pNode->Data.Profile.cTicks);
         default:
             return "";
@@ -2886,6 +2898,7 @@ VBoxDbgStatsModel::getTotalValueAsUInt(PCDBGGUISTATSNODE pNode)
     {
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             return pNode->Data.Profile.cTicks;
         default:
             return UINT64_MAX;
@@ -2900,6 +2913,7 @@ VBoxDbgStatsModel::strDeltaValue(PCDBGGUISTATSNODE pNode)
     {
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
         case STAMTYPE_COUNTER:
         case STAMTYPE_RATIO_U32:
         case STAMTYPE_RATIO_U32_RESET:
@@ -3060,6 +3074,7 @@ VBoxDbgStatsModel::stringifyNodeNoRecursion(PDBGGUISTATSNODE a_pNode, QString &a
 
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
         {
             uint64_t u64 = a_pNode->Data.Profile.cPeriods ? a_pNode->Data.Profile.cPeriods : 1;
             RTStrPrintf(szBuf, sizeof(szBuf),
@@ -3438,6 +3453,7 @@ VBoxDbgStatsSortFileProxyModel::filterAcceptsRow(int a_iSrcRow, const QModelInde
 
                                     case STAMTYPE_PROFILE:
                                     case STAMTYPE_PROFILE_ADV:
+                                    case STAMTYPE_HISTOGRAM:
                                         if (pNode->Data.Profile.cPeriods)
                                             break;
                                         return false;
@@ -73,6 +73,14 @@
 
 #include "AudioMixBuffer.h"
 
+#if defined(RT_ARCH_AMD64)
+# include <iprt/asm-amd64-x86.h>
+# include <iprt/x86.h>
+# include <immintrin.h>
+#elif defined(RT_ARCH_ARM64)
+# include <arm_neon.h>
+#endif
+
 
 /*********************************************************************************************************************************
 *   Defined Constants And Macros                                                                                                 *
@@ -100,6 +108,45 @@
 AssertCompile(AUDIOMIXBUF_VOL_0DB <= 0x40000000);   /* Must always hold. */
 AssertCompile(AUDIOMIXBUF_VOL_0DB == 0x40000000);   /* For now -- when only attenuation is used. */
 
+/** @def AUDIOMIXBUF_WITH_SSE2
+ * SSE2 kernels, always available on AMD64. */
+/** @def AUDIOMIXBUF_WITH_AVX2
+ * AVX2 kernels, used when the CPU and the host OS support them. */
+/** @def AUDIOMIXBUF_WITH_NEON
+ * NEON kernels, always available on ARM64. */
+/** @def AUDIOMIXBUF_TARGET_AVX2
+ * Function attribute for compiling an AVX2 kernel without raising the baseline
+ * of the whole file. */
+#if defined(RT_ARCH_AMD64)
+# define AUDIOMIXBUF_WITH_SSE2
+# define AUDIOMIXBUF_WITH_AVX2
+# if defined(__GNUC__)
+#  define AUDIOMIXBUF_TARGET_AVX2   __attribute__((__target__("avx2")))
+# else
+#  define AUDIOMIXBUF_TARGET_AVX2
+# endif
+#elif defined(RT_ARCH_ARM64)
+# define AUDIOMIXBUF_WITH_NEON
+#endif
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * The kernels used for blending, volume, S16/S32 conversion and stereo
+ * resampling, see audioMixBufSimdInit.
+ */
+typedef enum AUDIOMIXBUFSIMD
+{
+    AUDIOMIXBUFSIMD_NOT_INITIALIZED = 0,
+    /** Portable C code. */
+    AUDIOMIXBUFSIMD_GENERIC,
+    AUDIOMIXBUFSIMD_SSE2,
+    AUDIOMIXBUFSIMD_AVX2,
+    AUDIOMIXBUFSIMD_NEON
+} AUDIOMIXBUFSIMD;
+
 
 /*********************************************************************************************************************************
 *   Global Variables                                                                                                             *
@@ -143,6 +190,9 @@ static uint32_t const s_aVolumeConv[256] =
     48393, 50535, 52773, 55109, 57549, 60097, 62757, 65536, /* 255 */
 };
 
+/** The kernels picked for the host by audioMixBufSimdInit. */
+static AUDIOMIXBUFSIMD g_enmAudioMixBufSimd = AUDIOMIXBUFSIMD_NOT_INITIALIZED;
+
 
 
 #ifdef VBOX_STRICT
@@ -244,6 +294,252 @@ DECL_FORCE_INLINE(int32_t) audioMixBufBlendSampleRet(int32_t i32Sample1, int32_t
 }
 
 
+/**
+ * Picks the kernels for the host CPU.
+ *
+ * Racing callers all come up with the same answer, so no serialization needed.
+ */
+static void audioMixBufSimdInit(void)
+{
+    if (g_enmAudioMixBufSimd != AUDIOMIXBUFSIMD_NOT_INITIALIZED)
+        return;
+
+    AUDIOMIXBUFSIMD enmSimd = AUDIOMIXBUFSIMD_GENERIC;
+#if defined(AUDIOMIXBUF_WITH_SSE2)
+    enmSimd = AUDIOMIXBUFSIMD_SSE2;
+# ifdef AUDIOMIXBUF_WITH_AVX2
+    uint32_t uMaxLeaf, uEbx, uEcx, uEdx;
+    ASMCpuId(0, &uMaxLeaf, &uEbx, &uEcx, &uEdx);
+    if (uMaxLeaf >= 7)
+    {
+        uint32_t uEax;
+        ASMCpuId(1, &uEax, &uEbx, &uEcx, &uEdx);
+        if (   (uEcx & X86_CPUID_FEATURE_ECX_OSXSAVE)
+            && (ASMGetXcr0() & (XSAVE_C_SSE | XSAVE_C_YMM)) == (XSAVE_C_SSE | XSAVE_C_YMM))
+        {
+            ASMCpuId_Idx_ECX(7, 0, &uEax, &uEbx, &uEcx, &uEdx);
+            if (uEbx & X86_CPUID_STEXT_FEATURE_EBX_AVX2)
+                enmSimd = AUDIOMIXBUFSIMD_AVX2;
+        }
+    }
+# endif
+#elif defined(AUDIOMIXBUF_WITH_NEON)
+    enmSimd = AUDIOMIXBUFSIMD_NEON;
+#endif
+    g_enmAudioMixBufSimd = enmSimd;
+}
+
+
+/*
+ * SIMD kernels for blending, volume and interpolation.
+ *
+ * These must produce exactly the same results as the generic code, i.e. the
+ * blend average is rounded towards zero like the 64-bit division in
+ * audioMixBufBlendSample and the volume and interpolation products are done
+ * in full 64-bit precision.
+ */
+#ifdef AUDIOMIXBUF_WITH_SSE2
+
+/** SSE2 version of audioMixBufBlendSample for four samples. */
+DECL_FORCE_INLINE(__m128i) audioMixBufBlendSse2(__m128i uDst, __m128i uSrc)
+{
+    /* floor((dst + src) / 2) without overflow, then round towards zero. */
+    __m128i uAvg = _mm_add_epi32(_mm_add_epi32(_mm_srai_epi32(uDst, 1), _mm_srai_epi32(uSrc, 1)),
+                                 _mm_and_si128(_mm_and_si128(uDst, uSrc), _mm_set1_epi32(1)));
+    uAvg = _mm_add_epi32(uAvg, _mm_and_si128(_mm_xor_si128(uDst, uSrc), _mm_srli_epi32(uAvg, 31)));
+
+    /* Silent samples don't count. */
+    __m128i const fDstZero = _mm_cmpeq_epi32(uDst, _mm_setzero_si128());
+    __m128i const fSrcZero = _mm_cmpeq_epi32(uSrc, _mm_setzero_si128());
+    uAvg = _mm_or_si128(_mm_and_si128(fDstZero, uSrc), _mm_andnot_si128(fDstZero, uAvg));
+    return _mm_or_si128(_mm_and_si128(fSrcZero, uDst), _mm_andnot_si128(fSrcZero, uAvg));
+}
+
+static void audioMixBufBlendSamplesSse2(int32_t *pi32Dst, int32_t const *pi32Src, size_t cSamples)
+{
+    for (; cSamples >= 4; cSamples -= 4, pi32Dst += 4, pi32Src += 4)
+        _mm_storeu_si128((__m128i *)pi32Dst, audioMixBufBlendSse2(_mm_loadu_si128((__m128i const *)pi32Dst),
+                                                                  _mm_loadu_si128((__m128i const *)pi32Src)));
+    while (cSamples-- > 0)
+        audioMixBufBlendSample(pi32Dst++, *pi32Src++);
+}
+
+/**
+ * Signed 32x32->64 multiplication of the even lanes, SSE2 only has the unsigned
+ * one.  The factors are at most 2^32 - 1 and taken as unsigned.
+ */
+DECL_FORCE_INLINE(__m128i) audioMixBufMulEvenSse2(__m128i uSamples, __m128i uFactors)
+{
+    __m128i const uProd = _mm_mul_epu32(uSamples, uFactors);
+    return _mm_sub_epi64(uProd, _mm_slli_epi64(_mm_and_si128(_mm_srai_epi32(uSamples, 31), uFactors), 32));
+}
+
+/**
+ * Applies the volume factors to a multiple of four samples.
+ *
+ * @param   pi32Samples The samples.
+ * @param   cSamples    Number of samples, multiple of four.
+ * @param   pauFactors  The channel volume factors.
+ * @param   cChannels   Number of channels, 1, 2 or 4.
+ */
+static void audioMixBufVolumeSamplesSse2(int32_t *pi32Samples, size_t cSamples, uint32_t const *pauFactors, uint8_t cChannels)
+{
+    __m128i const uFactors    = _mm_setr_epi32((int)pauFactors[0],             (int)pauFactors[1 % cChannels],
+                                               (int)pauFactors[2 % cChannels], (int)pauFactors[3 % cChannels]);
+    __m128i const uFactorsOdd = _mm_srli_epi64(uFactors, 32);
+    __m128i const uLowMask    = _mm_setr_epi32(-1, 0, -1, 0);
+    for (; cSamples >= 4; cSamples -= 4, pi32Samples += 4)
+    {
+        __m128i const uSamples = _mm_loadu_si128((__m128i const *)pi32Samples);
+        __m128i const uEven = _mm_srli_epi64(audioMixBufMulEvenSse2(uSamples, uFactors), AUDIOMIXBUF_VOL_SHIFT);
+        __m128i const uOdd  = _mm_srli_epi64(audioMixBufMulEvenSse2(_mm_srli_epi64(uSamples, 32), uFactorsOdd),
+                                             AUDIOMIXBUF_VOL_SHIFT);
+        _mm_storeu_si128((__m128i *)pi32Samples, _mm_or_si128(_mm_and_si128(uEven, uLowMask), _mm_slli_epi64(uOdd, 32)));
+    }
+}
+
+/** SSE2 version of INTERPOLATE_2CH. */
+DECL_FORCE_INLINE(void) audioMixBufInterpolate2ChSse2(int32_t *pi32Dst, int32_t const *pi32Src, int32_t const *pi32Last,
+                                                      uint32_t uFactorCur)
+{
+    if (uFactorCur)
+    {
+        __m128i const uCur  = _mm_unpacklo_epi32(_mm_loadl_epi64((__m128i const *)pi32Src), _mm_setzero_si128());
+        __m128i const uLast = _mm_unpacklo_epi32(_mm_loadl_epi64((__m128i const *)pi32Last), _mm_setzero_si128());
+        __m128i const uSum  = _mm_add_epi64(audioMixBufMulEvenSse2(uCur, _mm_set1_epi64x(uFactorCur)),
+                                            audioMixBufMulEvenSse2(uLast, _mm_set1_epi64x((uint32_t)(0 - uFactorCur))));
+        _mm_storel_epi64((__m128i *)pi32Dst, _mm_shuffle_epi32(uSum, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    else
+    {
+        /* The last factor is 2^32 which doesn't fit the multiplication. */
+        pi32Dst[0] = pi32Last[0];
+        pi32Dst[1] = pi32Last[1];
+    }
+}
+
+#endif /* AUDIOMIXBUF_WITH_SSE2 */
+
+#ifdef AUDIOMIXBUF_WITH_AVX2
+
+/** AVX2 version of audioMixBufBlendSample for eight samples. */
+AUDIOMIXBUF_TARGET_AVX2 DECL_FORCE_INLINE(__m256i) audioMixBufBlendAvx2(__m256i uDst, __m256i uSrc)
+{
+    __m256i uAvg = _mm256_add_epi32(_mm256_add_epi32(_mm256_srai_epi32(uDst, 1), _mm256_srai_epi32(uSrc, 1)),
+                                    _mm256_and_si256(_mm256_and_si256(uDst, uSrc), _mm256_set1_epi32(1)));
+    uAvg = _mm256_add_epi32(uAvg, _mm256_and_si256(_mm256_xor_si256(uDst, uSrc), _mm256_srli_epi32(uAvg, 31)));
+    uAvg = _mm256_blendv_epi8(uAvg, uSrc, _mm256_cmpeq_epi32(uDst, _mm256_setzero_si256()));
+    return _mm256_blendv_epi8(uAvg, uDst, _mm256_cmpeq_epi32(uSrc, _mm256_setzero_si256()));
+}
+
+AUDIOMIXBUF_TARGET_AVX2
+static void audioMixBufBlendSamplesAvx2(int32_t *pi32Dst, int32_t const *pi32Src, size_t cSamples)
+{
+    for (; cSamples >= 8; cSamples -= 8, pi32Dst += 8, pi32Src += 8)
+        _mm256_storeu_si256((__m256i *)pi32Dst, audioMixBufBlendAvx2(_mm256_loadu_si256((__m256i const *)pi32Dst),
+                                                                     _mm256_loadu_si256((__m256i const *)pi32Src)));
+    while (cSamples-- > 0)
+        audioMixBufBlendSample(pi32Dst++, *pi32Src++);
+}
+
+/**
+ * Applies the volume factors to a multiple of eight samples.
+ *
+ * @param   pi32Samples The samples.
+ * @param   cSamples    Number of samples, multiple of eight.
+ * @param   pauFactors  The channel volume factors.
+ * @param   cChannels   Number of channels, 1, 2, 4 or 8.
+ */
+AUDIOMIXBUF_TARGET_AVX2
+static void audioMixBufVolumeSamplesAvx2(int32_t *pi32Samples, size_t cSamples, uint32_t const *pauFactors, uint8_t cChannels)
+{
+    /* The factors are at most AUDIOMIXBUF_VOL_0DB, so the signed multiplication is fine. */
+    __m256i const uFactors    = _mm256_setr_epi32((int)pauFactors[0],             (int)pauFactors[1 % cChannels],
+                                                  (int)pauFactors[2 % cChannels], (int)pauFactors[3 % cChannels],
+                                                  (int)pauFactors[4 % cChannels], (int)pauFactors[5 % cChannels],
+                                                  (int)pauFactors[6 % cChannels], (int)pauFactors[7 % cChannels]);
+    __m256i const uFactorsOdd = _mm256_srli_epi64(uFactors, 32);
+    for (; cSamples >= 8; cSamples -= 8, pi32Samples += 8)
+    {
+        __m256i const uSamples = _mm256_loadu_si256((__m256i const *)pi32Samples);
+        __m256i const uEven = _mm256_srli_epi64(_mm256_mul_epi32(uSamples, uFactors), AUDIOMIXBUF_VOL_SHIFT);
+        __m256i const uOdd  = _mm256_srli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(uSamples, 32), uFactorsOdd),
+                                                AUDIOMIXBUF_VOL_SHIFT);
+        _mm256_storeu_si256((__m256i *)pi32Samples, _mm256_blend_epi32(uEven, _mm256_slli_epi64(uOdd, 32), 0xaa));
+    }
+}
+
+#endif /* AUDIOMIXBUF_WITH_AVX2 */
+
+#ifdef AUDIOMIXBUF_WITH_NEON
+
+/** NEON version of audioMixBufBlendSample for four samples. */
+DECL_FORCE_INLINE(int32x4_t) audioMixBufBlendNeon(int32x4_t iDst, int32x4_t iSrc)
+{
+    int32x4_t iAvg = vhaddq_s32(iDst, iSrc);
+    iAvg = vaddq_s32(iAvg, vandq_s32(veorq_s32(iDst, iSrc), vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(iAvg), 31))));
+    iAvg = vbslq_s32(vceqq_s32(iDst, vdupq_n_s32(0)), iSrc, iAvg);
+    return vbslq_s32(vceqq_s32(iSrc, vdupq_n_s32(0)), iDst, iAvg);
+}
+
+static void audioMixBufBlendSamplesNeon(int32_t *pi32Dst, int32_t const *pi32Src, size_t cSamples)
+{
+    for (; cSamples >= 4; cSamples -= 4, pi32Dst += 4, pi32Src += 4)
+        vst1q_s32(pi32Dst, audioMixBufBlendNeon(vld1q_s32(pi32Dst), vld1q_s32(pi32Src)));
+    while (cSamples-- > 0)
+        audioMixBufBlendSample(pi32Dst++, *pi32Src++);
+}
+
+/**
+ * Applies the volume factors to a multiple of four samples.
+ *
+ * @param   pi32Samples The samples.
+ * @param   cSamples    Number of samples, multiple of four.
+ * @param   pauFactors  The channel volume factors.
+ * @param   cChannels   Number of channels, 1, 2 or 4.
+ */
+static void audioMixBufVolumeSamplesNeon(int32_t *pi32Samples, size_t cSamples, uint32_t const *pauFactors, uint8_t cChannels)
+{
+    int32_t const ai32Factors[4] = { (int32_t)pauFactors[0],             (int32_t)pauFactors[1 % cChannels],
+                                     (int32_t)pauFactors[2 % cChannels], (int32_t)pauFactors[3 % cChannels] };
+    int32x4_t const iFactors = vld1q_s32(ai32Factors);
+    for (; cSamples >= 4; cSamples -= 4, pi32Samples += 4)
+    {
+        int32x4_t const iSamples = vld1q_s32(pi32Samples);
+        int64x2_t const iLo = vmull_s32(vget_low_s32(iSamples), vget_low_s32(iFactors));
+        int64x2_t const iHi = vmull_high_s32(iSamples, iFactors);
+        vst1q_s32(pi32Samples, vcombine_s32(vshrn_n_s64(iLo, AUDIOMIXBUF_VOL_SHIFT), vshrn_n_s64(iHi, AUDIOMIXBUF_VOL_SHIFT)));
+    }
+}
+
+/** Unsigned factor version of vmull_s32, the factor is at most 2^32 - 1. */
+DECL_FORCE_INLINE(uint64x2_t) audioMixBufMulNeon(int32x2_t iSamples, uint32_t uFactor)
+{
+    uint64x2_t const uProd = vmull_n_u32(vreinterpret_u32_s32(iSamples), uFactor);
+    return vsubq_u64(uProd, vshll_n_u32(vand_u32(vreinterpret_u32_s32(vshr_n_s32(iSamples, 31)), vdup_n_u32(uFactor)), 32));
+}
+
+/** NEON version of INTERPOLATE_2CH. */
+DECL_FORCE_INLINE(void) audioMixBufInterpolate2ChNeon(int32_t *pi32Dst, int32_t const *pi32Src, int32_t const *pi32Last,
+                                                      uint32_t uFactorCur)
+{
+    if (uFactorCur)
+    {
+        uint64x2_t const uSum = vaddq_u64(audioMixBufMulNeon(vld1_s32(pi32Src), uFactorCur),
+                                          audioMixBufMulNeon(vld1_s32(pi32Last), 0 - uFactorCur));
+        vst1_s32(pi32Dst, vreinterpret_s32_u32(vshrn_n_u64(uSum, 32)));
+    }
+    else
+    {
+        /* The last factor is 2^32 which doesn't fit the multiplication. */
+        pi32Dst[0] = pi32Last[0];
+        pi32Dst[1] = pi32Last[1];
+    }
+}
+
+#endif /* AUDIOMIXBUF_WITH_NEON */
+
+
 /**
  * Blends (merges) the source buffer into the destination buffer.
  *
@@ -258,6 +554,27 @@ DECL_FORCE_INLINE(int32_t) audioMixBufBlendSampleRet(int32_t i32Sample1, int32_t
  */
 static void audioMixBufBlendBuffer(int32_t *pi32Dst, int32_t const *pi32Src, uint32_t cFrames, uint8_t cChannels)
 {
+    switch (g_enmAudioMixBufSimd)
+    {
+#ifdef AUDIOMIXBUF_WITH_SSE2
+        case AUDIOMIXBUFSIMD_SSE2:
+            audioMixBufBlendSamplesSse2(pi32Dst, pi32Src, (size_t)cFrames * cChannels);
+            return;
+#endif
+#ifdef AUDIOMIXBUF_WITH_AVX2
+        case AUDIOMIXBUFSIMD_AVX2:
+            audioMixBufBlendSamplesAvx2(pi32Dst, pi32Src, (size_t)cFrames * cChannels);
+            return;
+#endif
+#ifdef AUDIOMIXBUF_WITH_NEON
+        case AUDIOMIXBUFSIMD_NEON:
+            audioMixBufBlendSamplesNeon(pi32Dst, pi32Src, (size_t)cFrames * cChannels);
+            return;
+#endif
+        default:
+            break;
+    }
+
     switch (cChannels)
     {
         case 2:
@@ -365,6 +682,177 @@ static void audioMixBufBlendBuffer(int32_t *pi32Dst, int32_t const *pi32Src, uin
 #undef AUDMIXBUF_MACRO_LOG
 
 
+/*
+ * Conversion kernels for the same channel layout on both sides, where the
+ * conversion is sample by sample.
+ */
+
+/* S32 is the mixer format, so it's just copying. */
+static DECLCALLBACK(void) audioMixBufEncodeSameChS32(void *pvDst, int32_t const *pi32Src, uint32_t cFrames,
+                                                     PAUDIOMIXBUFPEEKSTATE pState)
+{
+    memcpy(pvDst, pi32Src, (size_t)cFrames * pState->cDstChannels * sizeof(int32_t));
+}
+
+static DECLCALLBACK(void) audioMixBufDecodeSameChS32(int32_t *pi32Dst, void const *pvSrc, uint32_t cFrames,
+                                                     PAUDIOMIXBUFWRITESTATE pState)
+{
+    memcpy(pi32Dst, pvSrc, (size_t)cFrames * pState->cDstChannels * sizeof(int32_t));
+}
+
+static DECLCALLBACK(void) audioMixBufDecodeSameChS32Blend(int32_t *pi32Dst, void const *pvSrc, uint32_t cFrames,
+                                                          PAUDIOMIXBUFWRITESTATE pState)
+{
+    audioMixBufBlendBuffer(pi32Dst, (int32_t const *)pvSrc, cFrames, pState->cDstChannels);
+}
+
+#ifdef AUDIOMIXBUF_WITH_SSE2
+
+static DECLCALLBACK(void) audioMixBufEncodeSameChS16Sse2(void *pvDst, int32_t const *pi32Src, uint32_t cFrames,
+                                                         PAUDIOMIXBUFPEEKSTATE pState)
+{
+    int16_t *pi16Dst  = (int16_t *)pvDst;
+    size_t   cSamples = (size_t)cFrames * pState->cDstChannels;
+    for (; cSamples >= 8; cSamples -= 8, pi16Dst += 8, pi32Src += 8)
+        _mm_storeu_si128((__m128i *)pi16Dst,
+                         _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((__m128i const *)pi32Src), 16),
+                                         _mm_srai_epi32(_mm_loadu_si128((__m128i const *)&pi32Src[4]), 16)));
+    while (cSamples-- > 0)
+        *pi16Dst++ = audioMixBufSampleToS16(*pi32Src++);
+}
+
+static DECLCALLBACK(void) audioMixBufDecodeSameChS16Sse2(int32_t *pi32Dst, void const *pvSrc, uint32_t cFrames,
+                                                         PAUDIOMIXBUFWRITESTATE pState)
+{
+    int16_t const *pi16Src  = (int16_t const *)pvSrc;
+    size_t         cSamples = (size_t)cFrames * pState->cDstChannels;
+    for (; cSamples >= 8; cSamples -= 8, pi32Dst += 8, pi16Src += 8)
+    {
+        __m128i const uSrc = _mm_loadu_si128((__m128i const *)pi16Src);
+        _mm_storeu_si128((__m128i *)pi32Dst,       _mm_unpacklo_epi16(_mm_setzero_si128(), uSrc));
+        _mm_storeu_si128((__m128i *)&pi32Dst[4],   _mm_unpackhi_epi16(_mm_setzero_si128(), uSrc));
+    }
+    while (cSamples-- > 0)
+        *pi32Dst++ = audioMixBufSampleFromS16(*pi16Src++);
+}
+
+static DECLCALLBACK(void) audioMixBufDecodeSameChS16Sse2Blend(int32_t *pi32Dst, void const *pvSrc, uint32_t cFrames,
+                                                              PAUDIOMIXBUFWRITESTATE pState)
+{
+    int16_t const *pi16Src  = (int16_t const *)pvSrc;
+    size_t         cSamples = (size_t)cFrames * pState->cDstChannels;
+    for (; cSamples >= 8; cSamples -= 8, pi32Dst += 8, pi16Src += 8)
+    {
+        __m128i const uSrc = _mm_loadu_si128((__m128i const *)pi16Src);
+        _mm_storeu_si128((__m128i *)pi32Dst,
+                         audioMixBufBlendSse2(_mm_loadu_si128((__m128i const *)pi32Dst),
+                                              _mm_unpacklo_epi16(_mm_setzero_si128(), uSrc)));
+        _mm_storeu_si128((__m128i *)&pi32Dst[4],
+                         audioMixBufBlendSse2(_mm_loadu_si128((__m128i const *)&pi32Dst[4]),
+                                              _mm_unpackhi_epi16(_mm_setzero_si128(), uSrc)));
+    }
+    while (cSamples-- > 0)
+        audioMixBufBlendSample(pi32Dst++, audioMixBufSampleFromS16(*pi16Src++));
+}
+
+#endif /* AUDIOMIXBUF_WITH_SSE2 */
+
+#ifdef AUDIOMIXBUF_WITH_AVX2
+
+AUDIOMIXBUF_TARGET_AVX2
+static DECLCALLBACK(void) audioMixBufEncodeSameChS16Avx2(void *pvDst, int32_t const *pi32Src, uint32_t cFrames,
+                                                         PAUDIOMIXBUFPEEKSTATE pState)
+{
+    int16_t *pi16Dst  = (int16_t *)pvDst;
+    size_t   cSamples = (size_t)cFrames * pState->cDstChannels;
+    for (; cSamples >= 16; cSamples -= 16, pi16Dst += 16, pi32Src += 16)
+    {
+        /* The packing is done per 128-bit lane, so the middle quarters need swapping afterwards. */
+        __m256i const uPacked = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((__m256i const *)pi32Src), 16),
+                                                   _mm256_srai_epi32(_mm256_loadu_si256((__m256i const *)&pi32Src[8]), 16));
+        _mm256_storeu_si256((__m256i *)pi16Dst, _mm256_permute4x64_epi64(uPacked, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    while (cSamples-- > 0)
+        *pi16Dst++ = audioMixBufSampleToS16(*pi32Src++);
+}
+
+AUDIOMIXBUF_TARGET_AVX2
+static DECLCALLBACK(void) audioMixBufDecodeSameChS16Avx2(int32_t *pi32Dst, void const *pvSrc, uint32_t cFrames,
+                                                         PAUDIOMIXBUFWRITESTATE pState)
+{
+    int16_t const *pi16Src  = (int16_t const *)pvSrc;
+    size_t         cSamples = (size_t)cFrames * pState->cDstChannels;
+    for (; cSamples >= 8; cSamples -= 8, pi32Dst += 8, pi16Src += 8)
+        _mm256_storeu_si256((__m256i *)pi32Dst,
+                            _mm256_slli_epi32(_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i const *)pi16Src)), 16));
+    while (cSamples-- > 0)
+        *pi32Dst++ = audioMixBufSampleFromS16(*pi16Src++);
+}
+
+AUDIOMIXBUF_TARGET_AVX2
+static DECLCALLBACK(void) audioMixBufDecodeSameChS16Avx2Blend(int32_t *pi32Dst, void const *pvSrc, uint32_t cFrames,
+                                                              PAUDIOMIXBUFWRITESTATE pState)
+{
+    int16_t const *pi16Src  = (int16_t const *)pvSrc;
+    size_t         cSamples = (size_t)cFrames * pState->cDstChannels;
+    for (; cSamples >= 8; cSamples -= 8, pi32Dst += 8, pi16Src += 8)
+        _mm256_storeu_si256((__m256i *)pi32Dst,
+                            audioMixBufBlendAvx2(_mm256_loadu_si256((__m256i const *)pi32Dst),
+                                                 _mm256_slli_epi32(_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i const *)pi16Src)),
+                                                                   16)));
+    while (cSamples-- > 0)
+        audioMixBufBlendSample(pi32Dst++, audioMixBufSampleFromS16(*pi16Src++));
+}
+
+#endif /* AUDIOMIXBUF_WITH_AVX2 */
+
+#ifdef AUDIOMIXBUF_WITH_NEON
+
+static DECLCALLBACK(void) audioMixBufEncodeSameChS16Neon(void *pvDst, int32_t const *pi32Src, uint32_t cFrames,
+                                                         PAUDIOMIXBUFPEEKSTATE pState)
+{
+    int16_t *pi16Dst  = (int16_t *)pvDst;
+    size_t   cSamples = (size_t)cFrames * pState->cDstChannels;
+    for (; cSamples >= 8; cSamples -= 8, pi16Dst += 8, pi32Src += 8)
+        vst1q_s16(pi16Dst, vcombine_s16(vshrn_n_s32(vld1q_s32(pi32Src), 16), vshrn_n_s32(vld1q_s32(&pi32Src[4]), 16)));
+    while (cSamples-- > 0)
+        *pi16Dst++ = audioMixBufSampleToS16(*pi32Src++);
+}
+
+static DECLCALLBACK(void) audioMixBufDecodeSameChS16Neon(int32_t *pi32Dst, void const *pvSrc, uint32_t cFrames,
+                                                         PAUDIOMIXBUFWRITESTATE pState)
+{
+    int16_t const *pi16Src  = (int16_t const *)pvSrc;
+    size_t         cSamples = (size_t)cFrames * pState->cDstChannels;
+    for (; cSamples >= 8; cSamples -= 8, pi32Dst += 8, pi16Src += 8)
+    {
+        int16x8_t const iSrc = vld1q_s16(pi16Src);
+        vst1q_s32(pi32Dst,     vshll_n_s16(vget_low_s16(iSrc), 16));
+        vst1q_s32(&pi32Dst[4], vshll_high_n_s16(iSrc, 16));
+    }
+    while (cSamples-- > 0)
+        *pi32Dst++ = audioMixBufSampleFromS16(*pi16Src++);
+}
+
+static DECLCALLBACK(void) audioMixBufDecodeSameChS16NeonBlend(int32_t *pi32Dst, void const *pvSrc, uint32_t cFrames,
+                                                              PAUDIOMIXBUFWRITESTATE pState)
+{
+    int16_t const *pi16Src  = (int16_t const *)pvSrc;
+    size_t         cSamples = (size_t)cFrames * pState->cDstChannels;
+    for (; cSamples >= 8; cSamples -= 8, pi32Dst += 8, pi16Src += 8)
+    {
+        int16x8_t const iSrc = vld1q_s16(pi16Src);
+        vst1q_s32(pi32Dst,     audioMixBufBlendNeon(vld1q_s32(pi32Dst),     vshll_n_s16(vget_low_s16(iSrc), 16)));
+        vst1q_s32(&pi32Dst[4], audioMixBufBlendNeon(vld1q_s32(&pi32Dst[4]), vshll_high_n_s16(iSrc, 16)));
+    }
+    while (cSamples-- > 0)
+        audioMixBufBlendSample(pi32Dst++, audioMixBufSampleFromS16(*pi16Src++));
+}
+
+#endif /* AUDIOMIXBUF_WITH_NEON */
+
+
+
 /*
  * Resampling core.
  */
@@ -577,7 +1065,7 @@ static void audioMixBufBlendBuffer(int32_t *pi32Dst, int32_t const *pi32Src, uin
         INTERPOLATE_ONE(a_pi32Dst, a_pi32Src, a_pi32Last, a_i64FactorCur, a_i64FactorLast, 11); \
     } while (0)
 
-#define AUDIOMIXBUF_RESAMPLE(a_cChannels, a_Suffix) \
+#define AUDIOMIXBUF_RESAMPLE_EX(a_cChannels, a_Suffix, a_Interpolate) \
     /** @returns Number of destination frames written. */ \
     static DECLCALLBACK(uint32_t) \
     audioMixBufResample##a_cChannels##Ch##a_Suffix(int32_t *pi32Dst, uint32_t cDstFrames, \
@@ -617,7 +1105,7 @@ static void audioMixBufBlendBuffer(int32_t *pi32Dst, int32_t const *pi32Src, uin
             /* Interpolate. */ \
             int64_t const offFactorCur  = pRate->offDst & UINT32_MAX; \
             int64_t const offFactorLast = (int64_t)_4G - offFactorCur; \
-            INTERPOLATE_##a_cChannels##CH(pi32Dst, pi32Src, ai32LastFrame, offFactorCur, offFactorLast, a_cChannels); \
+            a_Interpolate(pi32Dst, pi32Src, ai32LastFrame, offFactorCur, offFactorLast, a_cChannels); \
             \
             /* Advance. */ \
             pRate->offDst += pRate->uDstInc; \
@@ -630,6 +1118,9 @@ static void audioMixBufBlendBuffer(int32_t *pi32Dst, int32_t const *pi32Src, uin
         return (pi32Dst - pi32DstStart) / a_cChannels; \
     }
 
+#define AUDIOMIXBUF_RESAMPLE(a_cChannels, a_Suffix) \
+    AUDIOMIXBUF_RESAMPLE_EX(a_cChannels, a_Suffix, INTERPOLATE_##a_cChannels##CH)
+
 AUDIOMIXBUF_RESAMPLE(1,Generic)
 AUDIOMIXBUF_RESAMPLE(2,Generic)
 AUDIOMIXBUF_RESAMPLE(3,Generic)
@@ -643,6 +1134,19 @@ AUDIOMIXBUF_RESAMPLE(10,Generic)
 AUDIOMIXBUF_RESAMPLE(11,Generic)
 AUDIOMIXBUF_RESAMPLE(12,Generic)
 
+#ifdef AUDIOMIXBUF_WITH_SSE2
+# define INTERPOLATE_2CH_SSE2(a_pi32Dst, a_pi32Src, a_pi32Last, a_i64FactorCur, a_i64FactorLast, a_cChannels) \
+        do { audioMixBufInterpolate2ChSse2(a_pi32Dst, a_pi32Src, a_pi32Last, (uint32_t)(a_i64FactorCur)); \
+             RT_NOREF(a_i64FactorLast); } while (0)
+AUDIOMIXBUF_RESAMPLE_EX(2,Sse2,INTERPOLATE_2CH_SSE2)
+#endif
+#ifdef AUDIOMIXBUF_WITH_NEON
+# define INTERPOLATE_2CH_NEON(a_pi32Dst, a_pi32Src, a_pi32Last, a_i64FactorCur, a_i64FactorLast, a_cChannels) \
+        do { audioMixBufInterpolate2ChNeon(a_pi32Dst, a_pi32Src, a_pi32Last, (uint32_t)(a_i64FactorCur)); \
+             RT_NOREF(a_i64FactorLast); } while (0)
+AUDIOMIXBUF_RESAMPLE_EX(2,Neon,INTERPOLATE_2CH_NEON)
+#endif
+
 
 /**
  * Resets the resampling state unconditionally.
@@ -725,6 +1229,25 @@ DECLINLINE(int) audioMixBufRateInit(PAUDIOSTREAMRATE pRate, uint32_t uSrcHz, uin
             default:
                 AssertMsgFailedReturn(("resampling %u changes is not implemented yet\n", cChannels), VERR_OUT_OF_RANGE);
         }
+
+        /* The interpolation of stereo frames fits a vector register nicely. */
+        if (cChannels == 2)
+            switch (g_enmAudioMixBufSimd)
+            {
+#ifdef AUDIOMIXBUF_WITH_SSE2
+                case AUDIOMIXBUFSIMD_SSE2:
+                case AUDIOMIXBUFSIMD_AVX2:
+                    pRate->pfnResample = audioMixBufResample2ChSse2;
+                    break;
+#endif
+#ifdef AUDIOMIXBUF_WITH_NEON
+                case AUDIOMIXBUFSIMD_NEON:
+                    pRate->pfnResample = audioMixBufResample2ChNeon;
+                    break;
+#endif
+                default:
+                    break;
+            }
     }
     return VINF_SUCCESS;
 }
@@ -762,6 +1285,8 @@ int AudioMixBufInit(PAUDIOMIXBUF pMixBuf, const char *pszName, PCPDMAUDIOPCMPROP
     for (uintptr_t i = 0; i < RT_ELEMENTS(pMixBuf->Volume.auChannels); i++)
         pMixBuf->Volume.auChannels[i] = AUDIOMIXBUF_VOL_0DB;
 
+    audioMixBufSimdInit();
+
     int rc;
     uint8_t const cChannels = PDMAudioPropsChannels(pProps);
     if (cChannels >= 1 && cChannels <= PDMAUDIO_MAX_CHANNELS)
@@ -1211,6 +1736,30 @@ int AudioMixBufInitPeekState(PCAUDIOMIXBUF pMixBuf, PAUDIOMIXBUFPEEKSTATE pState
         }
     }
 
+    /* SIMD kernels for the stereo and mono layouts where it's just the sample format changing. */
+    audioMixBufSimdInit();
+    if (   cSrcCh == cDstCh
+        && cSrcCh <= 2
+        && PDMAudioPropsIsSigned(pProps))
+    {
+        if (cbSample == 4 && g_enmAudioMixBufSimd != AUDIOMIXBUFSIMD_GENERIC)
+            pState->pfnEncode = audioMixBufEncodeSameChS32;
+        else if (cbSample == 2)
+            switch (g_enmAudioMixBufSimd)
+            {
+#ifdef AUDIOMIXBUF_WITH_SSE2
+                case AUDIOMIXBUFSIMD_SSE2: pState->pfnEncode = audioMixBufEncodeSameChS16Sse2; break;
+#endif
+#ifdef AUDIOMIXBUF_WITH_AVX2
+                case AUDIOMIXBUFSIMD_AVX2: pState->pfnEncode = audioMixBufEncodeSameChS16Avx2; break;
+#endif
+#ifdef AUDIOMIXBUF_WITH_NEON
+                case AUDIOMIXBUFSIMD_NEON: pState->pfnEncode = audioMixBufEncodeSameChS16Neon; break;
+#endif
+                default: break;
+            }
+    }
+
     int rc = audioMixBufRateInit(&pState->Rate, PDMAudioPropsHz(&pMixBuf->Props), PDMAudioPropsHz(pProps), cSrcCh);
     AUDMIXBUF_LOG(("%s: %RU32 Hz to %RU32 Hz => uDstInc=0x%'RX64\n", pMixBuf->pszName, PDMAudioPropsHz(&pMixBuf->Props),
                    PDMAudioPropsHz(pProps), pState->Rate.uDstInc));
@@ -1453,6 +2002,43 @@ int AudioMixBufInitWriteState(PCAUDIOMIXBUF pMixBuf, PAUDIOMIXBUFWRITESTATE pSta
         }
     }
 
+    /* SIMD kernels for the stereo and mono layouts where it's just the sample format changing. */
+    audioMixBufSimdInit();
+    if (   cSrcCh == cDstCh
+        && cSrcCh <= 2
+        && PDMAudioPropsIsSigned(pProps))
+    {
+        if (cbSample == 4 && g_enmAudioMixBufSimd != AUDIOMIXBUFSIMD_GENERIC)
+        {
+            pState->pfnDecode      = audioMixBufDecodeSameChS32;
+            pState->pfnDecodeBlend = audioMixBufDecodeSameChS32Blend;
+        }
+        else if (cbSample == 2)
+            switch (g_enmAudioMixBufSimd)
+            {
+#ifdef AUDIOMIXBUF_WITH_SSE2
+                case AUDIOMIXBUFSIMD_SSE2:
+                    pState->pfnDecode      = audioMixBufDecodeSameChS16Sse2;
+                    pState->pfnDecodeBlend = audioMixBufDecodeSameChS16Sse2Blend;
+                    break;
+#endif
+#ifdef AUDIOMIXBUF_WITH_AVX2
+                case AUDIOMIXBUFSIMD_AVX2:
+                    pState->pfnDecode      = audioMixBufDecodeSameChS16Avx2;
+                    pState->pfnDecodeBlend = audioMixBufDecodeSameChS16Avx2Blend;
+                    break;
+#endif
+#ifdef AUDIOMIXBUF_WITH_NEON
+                case AUDIOMIXBUFSIMD_NEON:
+                    pState->pfnDecode      = audioMixBufDecodeSameChS16Neon;
+                    pState->pfnDecodeBlend = audioMixBufDecodeSameChS16NeonBlend;
+                    break;
+#endif
+                default:
+                    break;
+            }
+    }
+
     int rc = audioMixBufRateInit(&pState->Rate, PDMAudioPropsHz(pProps), PDMAudioPropsHz(&pMixBuf->Props), cDstCh);
     AUDMIXBUF_LOG(("%s: %RU32 Hz to %RU32 Hz => uDstInc=0x%'RX64\n", pMixBuf->pszName, PDMAudioPropsHz(pProps),
                    PDMAudioPropsHz(&pMixBuf->Props), pState->Rate.uDstInc));
@@ -1885,7 +2471,49 @@ void AudioMixBufAdvance(PAUDIOMIXBUF pMixBuf, uint32_t cFrames)
 static void audioMixAdjustVolumeWorker(PAUDIOMIXBUF pMixBuf, uint32_t off, uint32_t cFrames)
 {
     int32_t       *pi32Samples = &pMixBuf->pi32Samples[off * pMixBuf->cChannels];
-    switch (pMixBuf->cChannels)
+
+    /*
+     * The SIMD kernels take the channel counts dividing the vector width, the
+     * frames left over at the end are done by the code further down.
+     */
+    uint8_t const  cChannels   = pMixBuf->cChannels;
+    uint32_t       cSimdFrames = 0;
+    switch (g_enmAudioMixBufSimd)
+    {
+#ifdef AUDIOMIXBUF_WITH_SSE2
+        case AUDIOMIXBUFSIMD_SSE2:
+            if (cChannels == 1 || cChannels == 2 || cChannels == 4)
+            {
+                cSimdFrames = cFrames & ~(uint32_t)(4 / cChannels - 1);
+                audioMixBufVolumeSamplesSse2(pi32Samples, (size_t)cSimdFrames * cChannels, pMixBuf->Volume.auChannels, cChannels);
+            }
+            break;
+#endif
+#ifdef AUDIOMIXBUF_WITH_AVX2
+        case AUDIOMIXBUFSIMD_AVX2:
+            if (cChannels == 1 || cChannels == 2 || cChannels == 4 || cChannels == 8)
+            {
+                cSimdFrames = cFrames & ~(uint32_t)(8 / cChannels - 1);
+                audioMixBufVolumeSamplesAvx2(pi32Samples, (size_t)cSimdFrames * cChannels, pMixBuf->Volume.auChannels, cChannels);
+            }
+            break;
+#endif
+#ifdef AUDIOMIXBUF_WITH_NEON
+        case AUDIOMIXBUFSIMD_NEON:
+            if (cChannels == 1 || cChannels == 2 || cChannels == 4)
+            {
+                cSimdFrames = cFrames & ~(uint32_t)(4 / cChannels - 1);
+                audioMixBufVolumeSamplesNeon(pi32Samples, (size_t)cSimdFrames * cChannels, pMixBuf->Volume.auChannels, cChannels);
+            }
+            break;
+#endif
+        default:
+            break;
+    }
+    pi32Samples += (size_t)cSimdFrames * cChannels;
+    cFrames     -= cSimdFrames;
+
+    switch (cChannels)
     {
         case 1:
         {
@@ -2103,3 +2731,33 @@ void AudioMixBufSetVolume(PAUDIOMIXBUF pMixBuf, PCPDMAUDIOVOLUME pVol)
     }
 }
 
+
+#ifdef VBOX_AUDIO_MIX_BUFFER_TESTCASE
+
+/**
+ * Switches between the generic and the SIMD kernels for comparing them.
+ *
+ * Blending and volume follow immediately, the conversion and resampling
+ * kernels are picked up by states initialized after this call.
+ *
+ * @returns Name of the kernels now in use.
+ * @param   fSimd   Whether to use the SIMD kernels of the host (if any).
+ */
+const char *AudioMixBufTstSelectKernels(bool fSimd)
+{
+    g_enmAudioMixBufSimd = AUDIOMIXBUFSIMD_NOT_INITIALIZED;
+    if (fSimd)
+        audioMixBufSimdInit();
+    else
+        g_enmAudioMixBufSimd = AUDIOMIXBUFSIMD_GENERIC;
+
+    switch (g_enmAudioMixBufSimd)
+    {
+        case AUDIOMIXBUFSIMD_SSE2:  return "SSE2";
+        case AUDIOMIXBUFSIMD_AVX2:  return "AVX2";
+        case AUDIOMIXBUFSIMD_NEON:  return "NEON";
+        default:                    return "generic";
+    }
+}
+
+#endif /* VBOX_AUDIO_MIX_BUFFER_TESTCASE */
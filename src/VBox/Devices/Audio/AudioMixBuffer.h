@@ -247,6 +247,10 @@ void        AudioMixBufBlendGap(PAUDIOMIXBUF pMixBuf, PAUDIOMIXBUFWRITESTATE pSt
 void        AudioMixBufCommit(PAUDIOMIXBUF pMixBuf, uint32_t cFrames);
 /** @} */
 
+#ifdef VBOX_AUDIO_MIX_BUFFER_TESTCASE
+const char *AudioMixBufTstSelectKernels(bool fSimd);
+#endif
+
 /** @} */
 #endif /* !VBOX_INCLUDED_SRC_Audio_AudioMixBuffer_h */
 
@@ -3746,6 +3746,7 @@ static DECLCALLBACK(int) hdaR3LoadDone(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
                     }
                     pStreamShared->State.idxSchedule     = (uint16_t)j;
                     pStreamShared->State.idxScheduleLoop = (uint16_t)idxLoop;
+                    pStreamShared->State.cCurScheduleLoops = 1;
                     off = UINT32_MAX;
                     break;
                 }
@@ -4851,7 +4852,9 @@ static DECLCALLBACK(int) hdaR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
                                   "|BufSizeOutMs"
                                   "|DebugEnabled"
                                   "|DebugPathOut"
-                                  "|DeviceName",
+                                  "|DeviceName"
+                                  "|DmaIdleCoalesceMax"
+                                  "|DmaPeriodMaxMs",
                                   "");
 
     /** @devcfgm{hda,BufSizeInMs,uint16_t,0,2000,0,ms}
@@ -4874,6 +4877,30 @@ static DECLCALLBACK(int) hdaR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
         return PDMDEV_SET_ERROR(pDevIns, VERR_OUT_OF_RANGE,
                                 N_("HDA configuration error: 'BufSizeOutMs' is out of bound, max 2000 ms"));
 
+    /** @devcfgm{hda,DmaPeriodMaxMs,uint16_t,1,100,100,ms}
+     * The maximum DMA timer period expressed in milliseconds.  Lowering this
+     * gives shorter periods and smaller internal DMA buffers, i.e. lower
+     * latency, at the expense of more frequent timer callouts. */
+    rc = pHlp->pfnCFGMQueryU16Def(pCfg, "DmaPeriodMaxMs", &pThis->cMsDmaPeriodMax, 100);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc,
+                                N_("HDA configuration error: failed to read 'DmaPeriodMaxMs' as 16-bit unsigned integer"));
+    if (pThis->cMsDmaPeriodMax < 1 || pThis->cMsDmaPeriodMax > 100)
+        return PDMDEV_SET_ERROR(pDevIns, VERR_OUT_OF_RANGE,
+                                N_("HDA configuration error: 'DmaPeriodMaxMs' is out of bound, valid range 1..100 ms"));
+
+    /** @devcfgm{hda,DmaIdleCoalesceMax,uint16_t,1,64,1,}
+     * The maximum number of DMA timer periods to coalesce into a single callout
+     * while an output stream is muted or has no host streams attached.  The
+     * default (1) disables coalescing. */
+    rc = pHlp->pfnCFGMQueryU16Def(pCfg, "DmaIdleCoalesceMax", &pThis->cDmaIdleCoalesceMax, 1);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc,
+                                N_("HDA configuration error: failed to read 'DmaIdleCoalesceMax' as 16-bit unsigned integer"));
+    if (pThis->cDmaIdleCoalesceMax < 1 || pThis->cDmaIdleCoalesceMax > 64)
+        return PDMDEV_SET_ERROR(pDevIns, VERR_OUT_OF_RANGE,
+                                N_("HDA configuration error: 'DmaIdleCoalesceMax' is out of bound, valid range 1..64"));
+
     rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "DebugEnabled", &pThisCC->Dbg.fEnabled, false);
     if (RT_FAILURE(rc))
         return PDMDEV_SET_ERROR(pDevIns, rc,
@@ -5323,6 +5350,15 @@ static DECLCALLBACK(int) hdaR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
         }
         PDMDevHlpSTAMRegisterF(pDevIns, &pThisCC->aStreams[idxStream].State.StatDmaSkippedPendingBcis, STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
                                "DMA transfer period skipped because of BCIS pending.", "Stream%u/DMASkippedPendingBCIS", idxStream);
+        if (hdaGetDirFromSD(idxStream) == PDMAUDIODIR_OUT)
+        {
+            PDMDevHlpSTAMRegisterF(pDevIns, &pThisCC->aStreams[idxStream].State.StatDmaOutUnderruns, STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                                   "DMA timer callouts finding the internal DMA buffer drained.", "Stream%u/DMABufferUnderruns", idxStream);
+            PDMDevHlpSTAMRegisterF(pDevIns, &pThisCC->aStreams[idxStream].State.StatDmaCoalesced, STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                                   "DMA timer callouts coalesced while muted or idle.", "Stream%u/DMACoalesced", idxStream);
+        }
+        PDMDevHlpSTAMRegisterF(pDevIns, &pThisCC->aStreams[idxStream].State.StatDmaLatencyNs, STAMTYPE_U64, STAMVISIBILITY_USED, STAMUNIT_NS,
+                               "Effective DMA buffer latency at the last timer callout.", "Stream%u/DMALatency", idxStream);
 
         PDMDevHlpSTAMRegisterF(pDevIns, &pThis->aStreams[idxStream].State.offRead, STAMTYPE_U64, STAMVISIBILITY_USED, STAMUNIT_BYTES,
                                "Virtual internal buffer read position.",    "Stream%u/offRead", idxStream);
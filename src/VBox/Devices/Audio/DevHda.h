@@ -679,6 +679,14 @@ typedef struct HDASTATE
      * Zero means default size according to buffer and stream config.
      * @sa BufSizeOutMs config value.  */
     uint16_t                cMsCircBufOut;
+    /** Config: Maximum DMA timer period in milliseconds.
+     * Lower values give lower latency at the cost of more timer callouts.
+     * @sa DmaPeriodMaxMs config value. */
+    uint16_t                cMsDmaPeriodMax;
+    /** Config: Maximum number of DMA timer periods to coalesce into one callout
+     * while an output stream is muted or idle.  1 disables coalescing.
+     * @sa DmaIdleCoalesceMax config value. */
+    uint16_t                cDmaIdleCoalesceMax;
     /** The start time of the wall clock (WALCLK), measured on the virtual sync clock. */
     uint64_t                tsWalClkStart;
     /** CORB DMA task handle.
@@ -409,6 +409,7 @@ static int hdaR3StreamCreateSchedule(PHDASTREAM pStreamShared, uint32_t cSegment
     pStreamShared->State.cSchedulePrologue = 0;
     pStreamShared->State.idxSchedule       = 0;
     pStreamShared->State.idxScheduleLoop   = 0;
+    pStreamShared->State.cCurScheduleLoops = 1;
 
     /*
      * Do the basic schedule compilation.
@@ -718,7 +719,7 @@ int hdaR3StreamSetUp(PPDMDEVINS pDevIns, PHDASTATE pThis, PHDASTREAM pStreamShar
      * Create a DMA timer schedule.
      */
     rc = hdaR3StreamCreateSchedule(pStreamShared, cTransferFragments, cBufferIrqs, (uint32_t)cbTotal,
-                                   PDMAudioPropsMilliToBytes(&pCfg->Props, 100 /** @todo make configurable */),
+                                   PDMAudioPropsMilliToBytes(&pCfg->Props, pThis->cMsDmaPeriodMax),
                                    PDMDevHlpTimerGetFreq(pDevIns, pStreamShared->hTimer), &pCfg->Props);
     if (RT_FAILURE(rc))
         return rc;
@@ -1011,6 +1012,7 @@ void hdaR3StreamReset(PHDASTATE pThis, PHDASTATER3 pThisCC, PHDASTREAM pStreamSh
     pStreamShared->State.cSchedule         = 0;
     pStreamShared->State.idxSchedule       = 0;
     pStreamShared->State.idxScheduleLoop   = 0;
+    pStreamShared->State.cCurScheduleLoops = 1;
     pStreamShared->State.fInputPreBuffered = false;
 
     /* Note: Do *not* reset the stream's circular buffer here, as the audio mixer still relies on
@@ -1951,7 +1953,8 @@ VBOXSTRICTRC hdaStreamDoOnAccessDmaOutput(PPDMDEVINS pDevIns, PHDASTATE pThis, P
 # ifdef VBOX_STRICT
     uint32_t       idxSched = pStreamShared->State.idxSchedule;
     AssertStmt(idxSched < RT_MIN(RT_ELEMENTS(pStreamShared->State.aSchedule), pStreamShared->State.cSchedule), idxSched = 0);
-    uint32_t const cbPeriod = pStreamShared->State.aSchedule[idxSched].cbPeriod;
+    uint32_t const cbPeriod = pStreamShared->State.aSchedule[idxSched].cbPeriod
+                            * RT_MAX(pStreamShared->State.cCurScheduleLoops, 1);
     AssertMsg(pStreamShared->State.cbDmaTotal < cbPeriod, ("%#x vs %#x\n", pStreamShared->State.cbDmaTotal, cbPeriod));
 # endif
 
@@ -2213,6 +2216,49 @@ static void hdaR3StreamFlushDmaBounceBufferOutput(PHDASTREAM pStreamShared, PHDA
 # endif /* VBOX_HDA_WITH_ON_REG_ACCESS_DMA */
 
 
+/**
+ * Determines how many loops of the given schedule step the next DMA timer
+ * period should cover.
+ *
+ * Coalescing only applies to output streams which are muted or have no host
+ * streams attached, as nobody will notice the coarser timing there.  The
+ * periods are never merged across schedule steps so the buffer completion
+ * interrupts (IOC) are still raised at the right BDLE boundaries.
+ *
+ * @returns Number of loops, at least 1.
+ * @param   pThis           The shared HDA device state.
+ * @param   pStreamShared   HDA stream (shared bits).
+ * @param   pStreamR3       HDA stream (ring-3 bits).
+ * @param   idxSched        The schedule step of the next period.
+ * @param   idxLoop         The loop number within @a idxSched of the next period.
+ */
+static uint32_t hdaR3StreamCalcScheduleLoops(PHDASTATE pThis, PHDASTREAM pStreamShared, PHDASTREAMR3 pStreamR3,
+                                             uint32_t idxSched, uint32_t idxLoop)
+{
+    if (   pThis->cDmaIdleCoalesceMax <= 1
+        || hdaGetDirFromSD(pStreamShared->u8SD) != PDMAUDIODIR_OUT)
+        return 1;
+
+    /* Only when muted or idle.  Unlocked peeking is fine, worst case we pick
+       the wrong period length for one callout. */
+    PAUDMIXSINK const pSink = pStreamR3->pMixSink->pMixSink;
+    if (   !pSink->VolumeCombined.fMuted
+        && pSink->cStreams > 0)
+        return 1;
+
+    uint32_t cLoops = RT_MIN(pThis->cDmaIdleCoalesceMax, pStreamShared->State.aSchedule[idxSched].cLoops - idxLoop);
+    if (cLoops > 1)
+    {
+        /* Don't use more than half of the free DMA buffer space so the AIO
+           thread has some slack. */
+        uint32_t const cbPeriod = pStreamShared->State.aSchedule[idxSched].cbPeriod;
+        uint32_t const cbFree   = hdaR3StreamGetFree(pStreamR3) / 2;
+        cLoops = RT_MIN(cLoops, cbFree / RT_MAX(cbPeriod, 1));
+    }
+    return RT_MAX(cLoops, 1);
+}
+
+
 /**
  * The stream's main function when called by the timer.
  *
@@ -2243,7 +2289,7 @@ uint64_t hdaR3StreamTimerMain(PPDMDEVINS pDevIns, PHDASTATE pThis, PHDASTATER3 p
         /* Advance the schduling: */
         uint32_t idxSched = pStreamShared->State.idxSchedule;
         AssertStmt(idxSched < RT_ELEMENTS(pStreamShared->State.aSchedule), idxSched = 0);
-        uint32_t idxLoop  = pStreamShared->State.idxScheduleLoop + 1;
+        uint32_t idxLoop  = pStreamShared->State.idxScheduleLoop + RT_MAX(pStreamShared->State.cCurScheduleLoops, 1);
         if (idxLoop >= pStreamShared->State.aSchedule[idxSched].cLoops)
         {
             idxSched += 1;
@@ -2258,9 +2304,15 @@ uint64_t hdaR3StreamTimerMain(PPDMDEVINS pDevIns, PHDASTATE pThis, PHDASTATER3 p
         }
         pStreamShared->State.idxScheduleLoop = (uint16_t)idxLoop;
 
+        /* Coalesce periods if the stream is muted or idle: */
+        uint32_t const cLoops = hdaR3StreamCalcScheduleLoops(pThis, pStreamShared, pStreamR3, idxSched, idxLoop);
+        pStreamShared->State.cCurScheduleLoops = cLoops;
+        if (cLoops > 1)
+            STAM_REL_COUNTER_INC(&pStreamR3->State.StatDmaCoalesced);
+
         /* Do the actual timer re-arming. */
         uint64_t const tsNow = PDMDevHlpTimerGet(pDevIns, pStreamShared->hTimer); /* (For virtual sync this remains the same for the whole callout IIRC) */
-        uint64_t const tsTransferNext = tsNow + pStreamShared->State.aSchedule[idxSched].cPeriodTicks;
+        uint64_t const tsTransferNext = tsNow + (uint64_t)pStreamShared->State.aSchedule[idxSched].cPeriodTicks * cLoops;
         Log3Func(("[SD%RU8] fSinkActive=true, tsTransferNext=%RU64 (in %RU64)\n",
                   pStreamShared->u8SD, tsTransferNext, tsTransferNext - tsNow));
         int rc = PDMDevHlpTimerSet(pDevIns, pStreamShared->hTimer, tsTransferNext);
@@ -2268,7 +2320,7 @@ uint64_t hdaR3StreamTimerMain(PPDMDEVINS pDevIns, PHDASTATE pThis, PHDASTATER3 p
 
         /* Some legacy stuff: */
         pStreamShared->State.tsTransferNext = tsTransferNext;
-        pStreamShared->State.cbCurDmaPeriod = pStreamShared->State.aSchedule[idxSched].cbPeriod;
+        pStreamShared->State.cbCurDmaPeriod = pStreamShared->State.aSchedule[idxSched].cbPeriod * cLoops;
 
         return tsNow;
     }
@@ -2321,7 +2373,8 @@ static void hdaR3StreamUpdateDma(PPDMDEVINS pDevIns, PHDASTATE pThis, PHDASTATER
     const uint64_t tsNowNs  = RTTimeNanoTS();
     uint32_t       idxSched = pStreamShared->State.idxSchedule;
     AssertStmt(idxSched < RT_MIN(RT_ELEMENTS(pStreamShared->State.aSchedule), pStreamShared->State.cSchedule), idxSched = 0);
-    uint32_t       cbPeriod = pStreamShared->State.aSchedule[idxSched].cbPeriod;
+    uint32_t       cbPeriod = pStreamShared->State.aSchedule[idxSched].cbPeriod
+                            * RT_MAX(pStreamShared->State.cCurScheduleLoops, 1);
 
     /*
      * Output streams (SDO).
@@ -2342,6 +2395,16 @@ static void hdaR3StreamUpdateDma(PPDMDEVINS pDevIns, PHDASTATE pThis, PHDASTATER
             Assert(pStreamShared->State.cbDma == 0);
 # endif
 
+        /*
+         * Update the latency statistics and check whether the host side ran
+         * dry since the last callout (no point in counting before data was
+         * produced the first time).
+         */
+        uint32_t const cbStreamUsed = hdaR3StreamGetUsed(pStreamR3);
+        pStreamR3->State.StatDmaLatencyNs = PDMAudioPropsBytesToNano(&pStreamShared->State.Cfg.Props, cbStreamUsed);
+        if (cbStreamUsed == 0 && pStreamShared->State.offWrite > 0)
+            STAM_REL_COUNTER_INC(&pStreamR3->State.StatDmaOutUnderruns);
+
         /*
          * Check how much room we have in our DMA buffer.  There should be at
          * least one period worth of space there or we're in an overflow situation.
@@ -2392,6 +2455,7 @@ static void hdaR3StreamUpdateDma(PPDMDEVINS pDevIns, PHDASTATE pThis, PHDASTATER
          */
         bool     fWriteSilence = false;
         uint32_t cbStreamUsed  = hdaR3StreamGetUsed(pStreamR3);
+        pStreamR3->State.StatDmaLatencyNs = PDMAudioPropsBytesToNano(&pStreamShared->State.Cfg.Props, cbStreamUsed);
         if (pStreamShared->State.fInputPreBuffered && cbStreamUsed >= cbPeriod)
         { /*likely*/ }
         /*
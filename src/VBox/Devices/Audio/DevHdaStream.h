@@ -131,6 +131,11 @@ typedef struct HDASTREAMSTATE
     uint16_t                idxSchedule;
     /** Current loop number within the current scheduling step.  */
     uint32_t                idxScheduleLoop;
+    /** Number of loops of the current scheduling step covered by the current
+     * DMA timer period.  This is 1 unless idle coalescing kicked in, see
+     * HDASTATE::cDmaIdleCoalesceMax.  Zero is treated as 1. */
+    uint32_t                cCurScheduleLoops;
+    uint32_t                au32Padding1[3];
 
     /** Buffer descriptors and additional timer scheduling state.
      * (Same as HDABDLEDESC, with more sensible naming.)  */
@@ -225,9 +230,6 @@ typedef struct HDASTREAM
 
     /** The timer for pumping data thru the attached LUN drivers. */
     TMTIMERHANDLE               hTimer;
-
-    /** Pad the structure size to a 64 byte alignment. */
-    uint64_t                    au64Padding1[2];
 } HDASTREAM;
 AssertCompileMemberAlignment(HDASTREAM, State.aBdl, 16);
 AssertCompileMemberAlignment(HDASTREAM, State.aSchedule, 16);
@@ -274,6 +276,15 @@ typedef struct HDASTREAMR3
         STAMCOUNTER             StatDmaFlowErrorBytes;
         /** DMA skipped because buffer interrupt pending. */
         STAMCOUNTER             StatDmaSkippedPendingBcis;
+        /** Output: Number of DMA timer callouts finding the DMA buffer drained,
+         * i.e. the host side ran out of data before we produced more. */
+        STAMCOUNTER             StatDmaOutUnderruns;
+        /** Number of DMA timer callouts covering more than one schedule loop
+         * because the stream was muted or idle. */
+        STAMCOUNTER             StatDmaCoalesced;
+        /** The effective latency of the DMA buffer at the last DMA timer
+         * callout (buffered data in nanoseconds). */
+        uint64_t                StatDmaLatencyNs;
 
         STAMPROFILE             StatStart;
         STAMPROFILE             StatReset;
@@ -281,7 +292,6 @@ typedef struct HDASTREAMR3
     } State;
     /** Debug bits. */
     HDASTREAMDEBUG              Dbg;
-    uint64_t                    au64Alignment[3];
 } HDASTREAMR3;
 AssertCompileSizeAlignment(HDASTREAMR3, 64);
 /** Pointer to an HDA stream (SDI / SDO).  */
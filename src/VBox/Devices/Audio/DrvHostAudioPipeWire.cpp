@@ -0,0 +1,1412 @@
+/* $Id$ */
+/** @file
+ * Host audio driver - PipeWire.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#define LOG_GROUP LOG_GROUP_DRV_HOST_AUDIO
+#include <VBox/log.h>
+#include <VBox/vmm/pdmaudioifs.h>
+#include <VBox/vmm/pdmaudioinline.h>
+
+#include <iprt/asm.h>
+#include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/string.h>
+#include <iprt/uuid.h> /* For PDMIBASE_2_PDMDRV. */
+
+#include <errno.h>
+
+#include "DrvHostAudioPipeWireStubsMangling.h"
+#include "DrvHostAudioPipeWireStubs.h"
+
+#include <pipewire/pipewire.h>
+#include <spa/param/audio/format-utils.h>
+#include <spa/param/buffers.h>
+#include <spa/pod/builder.h>
+#include <spa/utils/result.h>
+
+#include "VBoxDD.h"
+
+
+/*********************************************************************************************************************************
+*   Defines                                                                                                                      *
+*********************************************************************************************************************************/
+/** Max number of errors reported by drvHstAudPwError per instance. */
+#define VBOX_PIPEWIRE_MAX_LOG_REL_ERRORS    99
+
+/** Max number of buffers we negotiate per stream.  This also sizes the
+ * input buffer queue in DRVHSTAUDPWSTREAM. */
+#define DRVHSTAUDPW_MAX_BUFFERS             32
+/** Smallest quantum (in frames) we ask the PipeWire graph for. */
+#define DRVHSTAUDPW_MIN_QUANTUM             64
+/** Largest quantum (in frames) we ask the PipeWire graph for. */
+#define DRVHSTAUDPW_MAX_QUANTUM             8192
+/** How long to wait for the server to respond (in seconds). */
+#define DRVHSTAUDPW_TIMEOUT_SECS            5
+
+
+/*********************************************************************************************************************************
+*   Structures                                                                                                                   *
+*********************************************************************************************************************************/
+/** Pointer to the instance data for a PipeWire host audio driver. */
+typedef struct DRVHSTAUDPW *PDRVHSTAUDPW;
+
+
+/**
+ * PipeWire stream data.
+ *
+ * Unlike the PulseAudio backend we do not stage any data ourselves: the
+ * buffers negotiated with the PipeWire graph are memory mapped into our
+ * process (PW_STREAM_FLAG_MAP_BUFFERS) and DrvAudio reads/writes straight
+ * from/into them.
+ */
+typedef struct DRVHSTAUDPWSTREAM
+{
+    /** Common part. */
+    PDMAUDIOBACKENDSTREAM   Core;
+    /** The stream's acquired configuration. */
+    PDMAUDIOSTREAMCFG       Cfg;
+    /** Pointer to driver instance. */
+    PDRVHSTAUDPW            pDrv;
+    /** The PipeWire stream. */
+    struct pw_stream       *pStream;
+    /** The stream event listener. */
+    struct spa_hook         StreamListener;
+    /** The current stream state (updated by the state changed callback). */
+    enum pw_stream_state volatile enmState;
+    /** The quantum (period) size in frames we asked the graph for. */
+    uint32_t                cFramesQuantum;
+    /** The quantum size in bytes. */
+    uint32_t                cbQuantum;
+    /** The number of buffers we asked for. */
+    uint32_t                cBuffersReq;
+    /** The number of buffers currently allocated for the stream. */
+    uint32_t                cBuffers;
+    /** The smallest usable buffer size (bytes, frame aligned). */
+    uint32_t                cbBufferMin;
+
+    /** Output: Buffer currently being filled.
+     *  Input: Buffer currently being consumed. */
+    struct pw_buffer       *pCurBuf;
+    /** Current offset into pCurBuf (bytes). */
+    uint32_t                offCurBuf;
+    /** Output: The capacity of pCurBuf.
+     *  Input: The end offset of the valid data in pCurBuf. */
+    uint32_t                cbCurBuf;
+
+    /** Input: Index of the first buffer in apInBufs. */
+    uint32_t                idxInBufs;
+    /** Input: Number of buffers in apInBufs. */
+    uint32_t                cInBufs;
+    /** Input: Number of bytes in apInBufs. */
+    uint32_t                cbInBufs;
+    /** Input: Queue of filled buffers dequeued by the process callback. */
+    struct pw_buffer       *apInBufs[DRVHSTAUDPW_MAX_BUFFERS];
+
+    /** Output: Set while draining. */
+    bool volatile           fDraining;
+    /** Output: Set when we've counted the current underrun. */
+    bool                    fStarved;
+    /** Internal byte offset. */
+    uint64_t                offInternal;
+} DRVHSTAUDPWSTREAM;
+/** Pointer to PipeWire stream data. */
+typedef DRVHSTAUDPWSTREAM *PDRVHSTAUDPWSTREAM;
+
+
+/**
+ * PipeWire host audio driver instance data.
+ * @implements PDMIAUDIOCONNECTOR
+ */
+typedef struct DRVHSTAUDPW
+{
+    /** Pointer to the driver instance structure. */
+    PPDMDRVINS              pDrvIns;
+    /** The PipeWire thread loop.
+     * @note All access to PipeWire objects must be done while owning the
+     *       thread loop lock, callbacks are invoked with it held. */
+    struct pw_thread_loop  *pThreadLoop;
+    /** The PipeWire context. */
+    struct pw_context      *pContext;
+    /** The connection to the PipeWire server. */
+    struct pw_core         *pCore;
+    /** The core event listener. */
+    struct spa_hook         CoreListener;
+    /** The core events (must stay valid while the listener is registered). */
+    struct pw_core_events   CoreEvents;
+    /** The stream events (must stay valid while any stream exists). */
+    struct pw_stream_events StreamEvents;
+    /** Sequence number of the pending core sync, -1 if none. */
+    int                     iSyncSeq;
+    /** Set when the pending core sync has completed. */
+    bool volatile           fSyncDone;
+    /** Set when a fatal core error occurred. */
+    bool volatile           fCoreError;
+    /** Error count for not flooding the release log.
+     *  Specify UINT32_MAX for unlimited logging. */
+    uint32_t                cLogErrors;
+    /** Pointer to host audio interface. */
+    PDMIHOSTAUDIO           IHostAudio;
+    /** Upwards notification interface. */
+    PPDMIHOSTAUDIOPORT      pIHostAudioPort;
+
+    /** The stream (base) name.
+     * This is needed for distinguishing streams in the PipeWire graph if
+     * multiple VMs are running at the same time. */
+    char                    szStreamName[64];
+    /** The name of the input device (node) to use. Empty string for default. */
+    char                    szInputDev[256];
+    /** The name of the output device (node) to use. Empty string for default. */
+    char                    szOutputDev[256];
+
+    /** Number of buffer underruns (for all streams). */
+    STAMCOUNTER             StatUnderruns;
+    /** Number of buffer overruns (for all streams). */
+    STAMCOUNTER             StatOverruns;
+} DRVHSTAUDPW;
+
+
+/**
+ * Logs a PipeWire error and converts it to VBox status.
+ *
+ * @returns VBox status code.
+ * @param   pThis       Our instance data.
+ * @param   rcPw        The PipeWire status code (negative errno).
+ * @param   pszFormat   The format string for the release log (no newline) .
+ * @param   ...         Format string arguments.
+ */
+static int drvHstAudPwError(PDRVHSTAUDPW pThis, int rcPw, const char *pszFormat, ...)
+{
+    AssertPtrReturn(pThis, VERR_INVALID_POINTER);
+    AssertPtr(pszFormat);
+
+    int const rcVBox = rcPw < 0 ? RTErrConvertFromErrno(-rcPw) : VERR_GENERAL_FAILURE;
+
+    if (pThis->cLogErrors < VBOX_PIPEWIRE_MAX_LOG_REL_ERRORS)
+    {
+        va_list va;
+        va_start(va, pszFormat);
+        LogRel(("PipeWire: %N: %s (%d, %Rrc)\n", pszFormat, &va, spa_strerror(rcPw), rcPw, rcVBox));
+        va_end(va);
+
+        if (++pThis->cLogErrors == VBOX_PIPEWIRE_MAX_LOG_REL_ERRORS)
+            LogRel(("PipeWire: muting errors (max %u)\n", VBOX_PIPEWIRE_MAX_LOG_REL_ERRORS));
+    }
+
+    return rcVBox;
+}
+
+
+/*********************************************************************************************************************************
+*   Core callbacks                                                                                                               *
+*********************************************************************************************************************************/
+
+/**
+ * Core 'done' event, completes a pw_core_sync() round trip.
+ */
+static void drvHstAudPwCoreDone(void *pvUser, uint32_t idObj, int iSeq)
+{
+    PDRVHSTAUDPW pThis = (PDRVHSTAUDPW)pvUser;
+    if (idObj == PW_ID_CORE && iSeq == pThis->iSyncSeq)
+    {
+        pThis->fSyncDone = true;
+        pw_thread_loop_signal(pThis->pThreadLoop, false /*wait_for_accept*/);
+    }
+}
+
+
+/**
+ * Core 'error' event.
+ */
+static void drvHstAudPwCoreError(void *pvUser, uint32_t idObj, int iSeq, int rcPw, const char *pszMsg)
+{
+    PDRVHSTAUDPW pThis = (PDRVHSTAUDPW)pvUser;
+    LogRel(("PipeWire: Error on object %u (seq %d): %s (%d)\n", idObj, iSeq, pszMsg ? pszMsg : "", rcPw));
+    if (idObj == PW_ID_CORE && rcPw == -EPIPE)
+    {
+        /* Lost the connection to the server. */
+        pThis->fCoreError = true;
+        pw_thread_loop_signal(pThis->pThreadLoop, false /*wait_for_accept*/);
+    }
+}
+
+
+/*********************************************************************************************************************************
+*   PDMIHOSTAUDIO                                                                                                                *
+*********************************************************************************************************************************/
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnGetConfig}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_GetConfig(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDCFG pBackendCfg)
+{
+    RT_NOREF(pInterface);
+    AssertPtrReturn(pBackendCfg, VERR_INVALID_POINTER);
+
+    RTStrCopy(pBackendCfg->szName, sizeof(pBackendCfg->szName), "PipeWire");
+    pBackendCfg->cbStream       = sizeof(DRVHSTAUDPWSTREAM);
+    pBackendCfg->fFlags         = 0;
+    pBackendCfg->cMaxStreamsOut = UINT32_MAX;
+    pBackendCfg->cMaxStreamsIn  = UINT32_MAX;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnSetDevice}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_SetDevice(PPDMIHOSTAUDIO pInterface, PDMAUDIODIR enmDir, const char *pszId)
+{
+    PDRVHSTAUDPW pThis = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+
+    /*
+     * Validate and normalize input.
+     */
+    AssertReturn(enmDir == PDMAUDIODIR_IN || enmDir == PDMAUDIODIR_OUT || enmDir == PDMAUDIODIR_DUPLEX, VERR_INVALID_PARAMETER);
+    AssertPtrNullReturn(pszId, VERR_INVALID_POINTER);
+    if (!pszId || !*pszId)
+        pszId = "";
+    else
+    {
+        size_t cch = strlen(pszId);
+        AssertReturn(cch < sizeof(pThis->szInputDev), VERR_INVALID_NAME);
+    }
+    LogFunc(("enmDir=%d pszId=%s\n", enmDir, pszId));
+
+    /*
+     * Update the device names and notify the parent so the streams are
+     * re-created with the new target.
+     */
+    static const PDMAUDIODIR s_aenmDirs[] = { PDMAUDIODIR_IN, PDMAUDIODIR_OUT };
+    for (unsigned i = 0; i < RT_ELEMENTS(s_aenmDirs); i++)
+    {
+        if (enmDir != s_aenmDirs[i] && enmDir != PDMAUDIODIR_DUPLEX)
+            continue;
+        char * const pszDev = s_aenmDirs[i] == PDMAUDIODIR_IN ? pThis->szInputDev : pThis->szOutputDev;
+
+        pw_thread_loop_lock(pThis->pThreadLoop);
+        if (strcmp(pszDev, pszId) == 0)
+            pw_thread_loop_unlock(pThis->pThreadLoop);
+        else
+        {
+            LogRel(("PipeWire: Changing %s device: '%s' -> '%s'\n", PDMAudioDirGetName(s_aenmDirs[i]), pszDev, pszId));
+            RTStrCopy(pszDev, sizeof(pThis->szInputDev), pszId);
+            PPDMIHOSTAUDIOPORT pIHostAudioPort = pThis->pIHostAudioPort;
+            pw_thread_loop_unlock(pThis->pThreadLoop);
+            if (pIHostAudioPort)
+            {
+                LogFlowFunc(("Notifying parent driver about %s device change...\n", PDMAudioDirGetName(s_aenmDirs[i])));
+                pIHostAudioPort->pfnNotifyDeviceChanged(pIHostAudioPort, s_aenmDirs[i], NULL /*pvUser*/);
+            }
+        }
+    }
+
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnGetStatus}
+ */
+static DECLCALLBACK(PDMAUDIOBACKENDSTS) drvHstAudPwHA_GetStatus(PPDMIHOSTAUDIO pInterface, PDMAUDIODIR enmDir)
+{
+    PDRVHSTAUDPW pThis = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    RT_NOREF(enmDir);
+    return !pThis->fCoreError ? PDMAUDIOBACKENDSTS_RUNNING : PDMAUDIOBACKENDSTS_ERROR;
+}
+
+
+/**
+ * Converts from PDM PCM properties to a SPA audio format.
+ *
+ * @returns SPA audio format.
+ * @retval  SPA_AUDIO_FORMAT_UNKNOWN if format not supported.
+ * @param   pProps      The PDM audio source properties.
+ */
+static enum spa_audio_format drvHstAudPwPropsToSpa(PCPDMAUDIOPCMPROPS pProps)
+{
+    bool const fLittleEndian = PDMAudioPropsIsLittleEndian(pProps);
+    switch (PDMAudioPropsSampleSize(pProps))
+    {
+        case 1:
+            return PDMAudioPropsIsSigned(pProps) ? SPA_AUDIO_FORMAT_S8 : SPA_AUDIO_FORMAT_U8;
+
+        case 2:
+            if (PDMAudioPropsIsSigned(pProps))
+                return fLittleEndian ? SPA_AUDIO_FORMAT_S16_LE : SPA_AUDIO_FORMAT_S16_BE;
+            return fLittleEndian ? SPA_AUDIO_FORMAT_U16_LE : SPA_AUDIO_FORMAT_U16_BE;
+
+        case 4:
+            if (PDMAudioPropsIsSigned(pProps))
+                return fLittleEndian ? SPA_AUDIO_FORMAT_S32_LE : SPA_AUDIO_FORMAT_S32_BE;
+            return fLittleEndian ? SPA_AUDIO_FORMAT_U32_LE : SPA_AUDIO_FORMAT_U32_BE;
+    }
+
+    AssertMsgFailed(("%RU8%s not supported\n", PDMAudioPropsSampleSize(pProps), PDMAudioPropsIsSigned(pProps) ? "S" : "U"));
+    return SPA_AUDIO_FORMAT_UNKNOWN;
+}
+
+
+/**
+ * Translates a PDM channel ID to a SPA channel position.
+ *
+ * @returns SPA channel position, SPA_AUDIO_CHANNEL_UNKNOWN if no mapping found.
+ */
+static uint32_t drvHstAudPwConvertChannelId(uint8_t idChannel)
+{
+    switch (idChannel)
+    {
+        case PDMAUDIOCHANNELID_FRONT_LEFT:              return SPA_AUDIO_CHANNEL_FL;
+        case PDMAUDIOCHANNELID_FRONT_RIGHT:             return SPA_AUDIO_CHANNEL_FR;
+        case PDMAUDIOCHANNELID_FRONT_CENTER:            return SPA_AUDIO_CHANNEL_FC;
+        case PDMAUDIOCHANNELID_LFE:                     return SPA_AUDIO_CHANNEL_LFE;
+        case PDMAUDIOCHANNELID_REAR_LEFT:               return SPA_AUDIO_CHANNEL_RL;
+        case PDMAUDIOCHANNELID_REAR_RIGHT:              return SPA_AUDIO_CHANNEL_RR;
+        case PDMAUDIOCHANNELID_FRONT_LEFT_OF_CENTER:    return SPA_AUDIO_CHANNEL_FLC;
+        case PDMAUDIOCHANNELID_FRONT_RIGHT_OF_CENTER:   return SPA_AUDIO_CHANNEL_FRC;
+        case PDMAUDIOCHANNELID_REAR_CENTER:             return SPA_AUDIO_CHANNEL_RC;
+        case PDMAUDIOCHANNELID_SIDE_LEFT:               return SPA_AUDIO_CHANNEL_SL;
+        case PDMAUDIOCHANNELID_SIDE_RIGHT:              return SPA_AUDIO_CHANNEL_SR;
+        case PDMAUDIOCHANNELID_TOP_CENTER:              return SPA_AUDIO_CHANNEL_TC;
+        case PDMAUDIOCHANNELID_FRONT_LEFT_HEIGHT:       return SPA_AUDIO_CHANNEL_TFL;
+        case PDMAUDIOCHANNELID_FRONT_CENTER_HEIGHT:     return SPA_AUDIO_CHANNEL_TFC;
+        case PDMAUDIOCHANNELID_FRONT_RIGHT_HEIGHT:      return SPA_AUDIO_CHANNEL_TFR;
+        case PDMAUDIOCHANNELID_REAR_LEFT_HEIGHT:        return SPA_AUDIO_CHANNEL_TRL;
+        case PDMAUDIOCHANNELID_REAR_CENTER_HEIGHT:      return SPA_AUDIO_CHANNEL_TRC;
+        case PDMAUDIOCHANNELID_REAR_RIGHT_HEIGHT:       return SPA_AUDIO_CHANNEL_TRR;
+        default:                                        return SPA_AUDIO_CHANNEL_UNKNOWN;
+    }
+}
+
+
+/**
+ * Returns all buffers we're holding on to back to the stream.
+ *
+ * Output buffers are returned empty, i.e. any partially filled buffer is
+ * discarded.  Input buffers are returned unread.
+ *
+ * @param   pStreamPW       The stream.
+ * @note    Caller owns the thread loop lock.
+ */
+static void drvHstAudPwStreamReturnBuffersLocked(PDRVHSTAUDPWSTREAM pStreamPW)
+{
+    if (pStreamPW->pCurBuf)
+    {
+        if (pStreamPW->Cfg.enmDir == PDMAUDIODIR_OUT)
+        {
+            pStreamPW->pCurBuf->buffer->datas[0].chunk->size = 0;
+            pStreamPW->pCurBuf->size = 0;
+        }
+        pw_stream_queue_buffer(pStreamPW->pStream, pStreamPW->pCurBuf);
+        pStreamPW->pCurBuf = NULL;
+    }
+    pStreamPW->offCurBuf = 0;
+    pStreamPW->cbCurBuf  = 0;
+
+    while (pStreamPW->cInBufs > 0)
+    {
+        pw_stream_queue_buffer(pStreamPW->pStream, pStreamPW->apInBufs[pStreamPW->idxInBufs]);
+        pStreamPW->apInBufs[pStreamPW->idxInBufs] = NULL;
+        pStreamPW->idxInBufs = (pStreamPW->idxInBufs + 1) % RT_ELEMENTS(pStreamPW->apInBufs);
+        pStreamPW->cInBufs--;
+    }
+    pStreamPW->idxInBufs = 0;
+    pStreamPW->cbInBufs  = 0;
+}
+
+
+/**
+ * Queues the output buffer currently being filled.
+ *
+ * @param   pStreamPW       The stream.
+ * @note    Caller owns the thread loop lock.
+ */
+static void drvHstAudPwStreamQueueCurBufLocked(PDRVHSTAUDPWSTREAM pStreamPW)
+{
+    struct pw_buffer * const pBuf  = pStreamPW->pCurBuf;
+    struct spa_data  * const pData = &pBuf->buffer->datas[0];
+    pData->chunk->offset = 0;
+    pData->chunk->size   = pStreamPW->offCurBuf;
+    pData->chunk->stride = PDMAudioPropsFrameSize(&pStreamPW->Cfg.Props);
+    pBuf->size           = PDMAudioPropsBytesToFrames(&pStreamPW->Cfg.Props, pStreamPW->offCurBuf);
+
+    int rcPw = pw_stream_queue_buffer(pStreamPW->pStream, pBuf);
+    if (rcPw < 0)
+        drvHstAudPwError(pStreamPW->pDrv, rcPw, "pw_stream_queue_buffer failed on '%s'", pStreamPW->Cfg.szName);
+
+    pStreamPW->pCurBuf   = NULL;
+    pStreamPW->offCurBuf = 0;
+    pStreamPW->cbCurBuf  = 0;
+}
+
+
+/**
+ * Stream 'state_changed' event.
+ */
+static void drvHstAudPwStreamStateChanged(void *pvUser, enum pw_stream_state enmOld, enum pw_stream_state enmState,
+                                          const char *pszError)
+{
+    PDRVHSTAUDPWSTREAM pStreamPW = (PDRVHSTAUDPWSTREAM)pvUser;
+    RT_NOREF(enmOld);
+    LogFlowFunc(("'%s': %s -> %s\n", pStreamPW->Cfg.szName, pw_stream_state_as_string(enmOld), pw_stream_state_as_string(enmState)));
+    if (enmState == PW_STREAM_STATE_ERROR)
+        LogRel(("PipeWire: Stream '%s' failed: %s\n", pStreamPW->Cfg.szName, pszError ? pszError : "<unknown>"));
+
+    pStreamPW->enmState = enmState;
+    pw_thread_loop_signal(pStreamPW->pDrv->pThreadLoop, false /*wait_for_accept*/);
+}
+
+
+/**
+ * Stream 'param_changed' event.
+ *
+ * Once the format has been fixed we tell the graph what kind of buffers we
+ * want: one quantum per buffer so each graph cycle maps onto one buffer.
+ */
+static void drvHstAudPwStreamParamChanged(void *pvUser, uint32_t idParam, const struct spa_pod *pParam)
+{
+    PDRVHSTAUDPWSTREAM pStreamPW = (PDRVHSTAUDPWSTREAM)pvUser;
+    if (idParam != SPA_PARAM_Format || !pParam)
+        return;
+
+    uint32_t const cbFrame = PDMAudioPropsFrameSize(&pStreamPW->Cfg.Props);
+    uint8_t        abPod[512];
+    struct spa_pod_builder PodBuilder;
+    spa_pod_builder_init(&PodBuilder, abPod, sizeof(abPod));
+    const struct spa_pod *apParams[1];
+    apParams[0] = (const struct spa_pod *)spa_pod_builder_add_object(&PodBuilder,
+                                                                     SPA_TYPE_OBJECT_ParamBuffers, SPA_PARAM_Buffers,
+                                                                     SPA_PARAM_BUFFERS_buffers, SPA_POD_CHOICE_RANGE_Int((int)pStreamPW->cBuffersReq, 2,
+                                                                                                                         DRVHSTAUDPW_MAX_BUFFERS),
+                                                                     SPA_PARAM_BUFFERS_blocks,  SPA_POD_Int(1),
+                                                                     SPA_PARAM_BUFFERS_size,    SPA_POD_Int((int)pStreamPW->cbQuantum),
+                                                                     SPA_PARAM_BUFFERS_stride,  SPA_POD_Int((int)cbFrame));
+    int rcPw = pw_stream_update_params(pStreamPW->pStream, apParams, RT_ELEMENTS(apParams));
+    if (rcPw < 0)
+        drvHstAudPwError(pStreamPW->pDrv, rcPw, "pw_stream_update_params failed on '%s'", pStreamPW->Cfg.szName);
+}
+
+
+/**
+ * Stream 'add_buffer' event.
+ */
+static void drvHstAudPwStreamAddBuffer(void *pvUser, struct pw_buffer *pBuf)
+{
+    PDRVHSTAUDPWSTREAM pStreamPW = (PDRVHSTAUDPWSTREAM)pvUser;
+    uint32_t const     cbBuf     = PDMAudioPropsFloorBytesToFrame(&pStreamPW->Cfg.Props,
+                                                                  RT_MIN(pBuf->buffer->datas[0].maxsize, pStreamPW->cbQuantum));
+    if (!pStreamPW->cBuffers || cbBuf < pStreamPW->cbBufferMin)
+        pStreamPW->cbBufferMin = cbBuf;
+    pStreamPW->cBuffers++;
+}
+
+
+/**
+ * Stream 'remove_buffer' event.
+ */
+static void drvHstAudPwStreamRemoveBuffer(void *pvUser, struct pw_buffer *pBuf)
+{
+    PDRVHSTAUDPWSTREAM pStreamPW = (PDRVHSTAUDPWSTREAM)pvUser;
+    Assert(pStreamPW->cBuffers > 0);
+    pStreamPW->cBuffers--;
+
+    /* Forget about it if we're holding on to it. */
+    if (pStreamPW->pCurBuf == pBuf)
+    {
+        pStreamPW->pCurBuf   = NULL;
+        pStreamPW->offCurBuf = 0;
+        pStreamPW->cbCurBuf  = 0;
+    }
+    for (uint32_t i = 0; i < pStreamPW->cInBufs; i++)
+    {
+        uint32_t const idx = (pStreamPW->idxInBufs + i) % RT_ELEMENTS(pStreamPW->apInBufs);
+        if (pStreamPW->apInBufs[idx] == pBuf)
+        {
+            /* The buffers are going away together, so just drop the whole queue. */
+            pStreamPW->idxInBufs = 0;
+            pStreamPW->cInBufs   = 0;
+            pStreamPW->cbInBufs  = 0;
+            break;
+        }
+    }
+}
+
+
+/**
+ * Stream 'process' event.
+ *
+ * Only relevant for input streams, where we pick up the filled buffers and
+ * queue them up for drvHstAudPwHA_StreamCapture.
+ */
+static void drvHstAudPwStreamProcess(void *pvUser)
+{
+    PDRVHSTAUDPWSTREAM pStreamPW = (PDRVHSTAUDPWSTREAM)pvUser;
+    if (pStreamPW->Cfg.enmDir != PDMAUDIODIR_IN)
+        return;
+
+    struct pw_buffer *pBuf;
+    while ((pBuf = pw_stream_dequeue_buffer(pStreamPW->pStream)) != NULL)
+    {
+        /* Drop the oldest buffer if nobody is reading. */
+        if (pStreamPW->cInBufs >= RT_ELEMENTS(pStreamPW->apInBufs))
+        {
+            struct pw_buffer *pOldBuf = pStreamPW->apInBufs[pStreamPW->idxInBufs];
+            pStreamPW->cbInBufs -= RT_MIN(pOldBuf->buffer->datas[0].chunk->size, pStreamPW->cbInBufs);
+            pw_stream_queue_buffer(pStreamPW->pStream, pOldBuf);
+            pStreamPW->idxInBufs = (pStreamPW->idxInBufs + 1) % RT_ELEMENTS(pStreamPW->apInBufs);
+            pStreamPW->cInBufs--;
+            STAM_REL_COUNTER_INC(&pStreamPW->pDrv->StatOverruns);
+        }
+
+        uint32_t const idx = (pStreamPW->idxInBufs + pStreamPW->cInBufs) % RT_ELEMENTS(pStreamPW->apInBufs);
+        pStreamPW->apInBufs[idx] = pBuf;
+        pStreamPW->cInBufs++;
+        pStreamPW->cbInBufs += pBuf->buffer->datas[0].chunk->size;
+    }
+}
+
+
+/**
+ * Stream 'drained' event.
+ */
+static void drvHstAudPwStreamDrained(void *pvUser)
+{
+    PDRVHSTAUDPWSTREAM pStreamPW = (PDRVHSTAUDPWSTREAM)pvUser;
+    LogFlowFunc(("'%s'\n", pStreamPW->Cfg.szName));
+    pStreamPW->fDraining = false;
+    pw_stream_set_active(pStreamPW->pStream, false);
+}
+
+
+/**
+ * Works out the quantum to ask the PipeWire graph for.
+ *
+ * We use the device's DMA scheduling hint so that every guest period maps
+ * onto one graph cycle, falling back on the backend period.
+ *
+ * @returns Quantum in frames (power of two).
+ * @param   pCfgReq         The requested stream config.
+ */
+static uint32_t drvHstAudPwCalcQuantum(PCPDMAUDIOSTREAMCFG pCfgReq)
+{
+    uint32_t cFrames = pCfgReq->Device.cMsSchedulingHint
+                     ? PDMAudioPropsMilliToFrames(&pCfgReq->Props, pCfgReq->Device.cMsSchedulingHint)
+                     : pCfgReq->Backend.cFramesPeriod;
+    cFrames = RT_MIN(RT_MAX(cFrames, DRVHSTAUDPW_MIN_QUANTUM), DRVHSTAUDPW_MAX_QUANTUM);
+    return RT_BIT_32(ASMBitLastSetU32(cFrames) - 1);
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamCreate}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_StreamCreate(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream,
+                                                    PCPDMAUDIOSTREAMCFG pCfgReq, PPDMAUDIOSTREAMCFG pCfgAcq)
+{
+    PDRVHSTAUDPW        pThis     = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW = (PDRVHSTAUDPWSTREAM)pStream;
+    AssertPtrReturn(pStreamPW, VERR_INVALID_POINTER);
+    AssertPtrReturn(pCfgReq, VERR_INVALID_POINTER);
+    AssertPtrReturn(pCfgAcq, VERR_INVALID_POINTER);
+    AssertReturn(pCfgReq->enmDir == PDMAUDIODIR_IN || pCfgReq->enmDir == PDMAUDIODIR_OUT, VERR_INVALID_PARAMETER);
+    Assert(PDMAudioStrmCfgEquals(pCfgReq, pCfgAcq));
+
+    /*
+     * Work out the format and the buffer layout.
+     */
+    struct spa_audio_info_raw Info;
+    RT_ZERO(Info);
+    Info.format   = drvHstAudPwPropsToSpa(&pCfgReq->Props);
+    Info.rate     = PDMAudioPropsHz(&pCfgReq->Props);
+    Info.channels = PDMAudioPropsChannels(&pCfgReq->Props);
+    if (Info.format == SPA_AUDIO_FORMAT_UNKNOWN || Info.channels > SPA_AUDIO_MAX_CHANNELS)
+    {
+        LogRel(("PipeWire: Unsupported stream format for '%s'\n", pCfgReq->szName));
+        return VERR_AUDIO_STREAM_COULD_NOT_CREATE;
+    }
+    for (uint32_t i = 0; i < Info.channels; i++)
+    {
+        Info.position[i] = Info.channels > 1 ? drvHstAudPwConvertChannelId(pCfgReq->Props.aidChannels[i])
+                         : (uint32_t)SPA_AUDIO_CHANNEL_MONO; /* PDMAUDIOCHANNELID_MONO is FRONT_CENTER. */
+        if (Info.position[i] == SPA_AUDIO_CHANNEL_UNKNOWN)
+            Info.flags |= SPA_AUDIO_FLAG_UNPOSITIONED;
+    }
+
+    pStreamPW->pDrv           = pThis;
+    pStreamPW->enmState       = PW_STREAM_STATE_UNCONNECTED;
+    pStreamPW->cFramesQuantum = drvHstAudPwCalcQuantum(pCfgReq);
+    pStreamPW->cbQuantum      = PDMAudioPropsFramesToBytes(&pCfgReq->Props, pStreamPW->cFramesQuantum);
+    pStreamPW->cBuffersReq    = RT_MIN(RT_MAX(pCfgReq->Backend.cFramesBufferSize / pStreamPW->cFramesQuantum, 2),
+                                       DRVHSTAUDPW_MAX_BUFFERS);
+    PDMAudioStrmCfgCopy(&pStreamPW->Cfg, pCfgReq);
+
+    /*
+     * Stream properties.  node.latency is what gets the graph quantum to
+     * follow the guest period.
+     */
+    char szName[256];
+    RTStrPrintf(szName, sizeof(szName), "VirtualBox %s [%s]", PDMAudioPathGetName(pCfgReq->enmPath), pThis->szStreamName);
+    char szLatency[32];
+    RTStrPrintf(szLatency, sizeof(szLatency), "%u/%u", pStreamPW->cFramesQuantum, Info.rate);
+    const char * const pszTarget = pCfgReq->enmDir == PDMAUDIODIR_IN ? pThis->szInputDev : pThis->szOutputDev;
+
+    struct spa_dict_item aItems[8];
+    uint32_t            cItems = 0;
+    aItems[cItems].key = PW_KEY_MEDIA_TYPE;         aItems[cItems++].value = "Audio";
+    aItems[cItems].key = PW_KEY_MEDIA_CATEGORY;     aItems[cItems++].value = pCfgReq->enmDir == PDMAUDIODIR_IN ? "Capture" : "Playback";
+    aItems[cItems].key = PW_KEY_MEDIA_ROLE;         aItems[cItems++].value = "Game";
+    aItems[cItems].key = PW_KEY_APP_NAME;           aItems[cItems++].value = "VirtualBox";
+    aItems[cItems].key = PW_KEY_NODE_NAME;          aItems[cItems++].value = szName;
+    aItems[cItems].key = PW_KEY_NODE_LATENCY;       aItems[cItems++].value = szLatency;
+    if (*pszTarget)
+    {
+#ifdef PW_KEY_TARGET_OBJECT
+        aItems[cItems].key = PW_KEY_TARGET_OBJECT;  aItems[cItems++].value = pszTarget;
+#else
+        aItems[cItems].key = PW_KEY_NODE_TARGET;    aItems[cItems++].value = pszTarget;
+#endif
+    }
+    Assert(cItems <= RT_ELEMENTS(aItems));
+    struct spa_dict Dict;
+    Dict.flags   = 0;
+    Dict.n_items = cItems;
+    Dict.items   = aItems;
+
+    /*
+     * Create and connect the stream.
+     */
+    uint8_t abPod[1024];
+    struct spa_pod_builder PodBuilder;
+    spa_pod_builder_init(&PodBuilder, abPod, sizeof(abPod));
+    const struct spa_pod *apParams[1];
+    apParams[0] = spa_format_audio_raw_build(&PodBuilder, SPA_PARAM_EnumFormat, &Info);
+
+    int rc = VINF_SUCCESS;
+    pw_thread_loop_lock(pThis->pThreadLoop);
+
+    pStreamPW->pStream = pw_stream_new(pThis->pCore, szName, pw_properties_new_dict(&Dict));
+    if (pStreamPW->pStream)
+    {
+        RT_ZERO(pStreamPW->StreamListener);
+        pw_stream_add_listener(pStreamPW->pStream, &pStreamPW->StreamListener, &pThis->StreamEvents, pStreamPW);
+
+        int rcPw = pw_stream_connect(pStreamPW->pStream,
+                                     pCfgReq->enmDir == PDMAUDIODIR_IN ? PW_DIRECTION_INPUT : PW_DIRECTION_OUTPUT,
+                                     PW_ID_ANY,
+                                     (enum pw_stream_flags)(  PW_STREAM_FLAG_AUTOCONNECT
+                                                            | PW_STREAM_FLAG_MAP_BUFFERS
+                                                            | PW_STREAM_FLAG_INACTIVE),
+                                     apParams, RT_ELEMENTS(apParams));
+        if (rcPw >= 0)
+        {
+            /* Wait for the stream to get linked up, so we know the buffers are
+               there when DrvAudio starts pushing data.  If it takes too long,
+               we report the stream as initializing via pfnStreamGetState. */
+            for (unsigned cSecs = 0; cSecs < DRVHSTAUDPW_TIMEOUT_SECS; cSecs++)
+            {
+                if (   pStreamPW->enmState != PW_STREAM_STATE_UNCONNECTED
+                    && pStreamPW->enmState != PW_STREAM_STATE_CONNECTING)
+                    break;
+                pw_thread_loop_timed_wait(pThis->pThreadLoop, 1);
+            }
+            if (pStreamPW->enmState == PW_STREAM_STATE_ERROR)
+                rc = VERR_AUDIO_STREAM_COULD_NOT_CREATE;
+        }
+        else
+            rc = drvHstAudPwError(pThis, rcPw, "pw_stream_connect failed on '%s'", szName);
+
+        if (RT_FAILURE(rc))
+        {
+            pw_stream_destroy(pStreamPW->pStream);
+            pStreamPW->pStream = NULL;
+        }
+    }
+    else
+        rc = drvHstAudPwError(pThis, -errno, "pw_stream_new failed on '%s'", szName);
+
+    pw_thread_loop_unlock(pThis->pThreadLoop);
+
+    if (RT_SUCCESS(rc))
+    {
+        pCfgAcq->Backend.cFramesPeriod       = pStreamPW->cFramesQuantum;
+        pCfgAcq->Backend.cFramesBufferSize   = pStreamPW->cFramesQuantum * pStreamPW->cBuffersReq;
+        pCfgAcq->Backend.cFramesPreBuffering = RT_MIN(pCfgReq->Backend.cFramesPreBuffering, pCfgAcq->Backend.cFramesBufferSize);
+        PDMAudioStrmCfgCopy(&pStreamPW->Cfg, pCfgAcq);
+        LogRel2(("PipeWire: Created '%s': quantum=%u frames, %u buffers\n",
+                 szName, pStreamPW->cFramesQuantum, pStreamPW->cBuffersReq));
+    }
+    else
+        LogRel(("PipeWire: Failed to create stream '%s': %Rrc\n", szName, rc));
+
+    LogFlowFuncLeaveRC(rc);
+    return rc;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamDestroy}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_StreamDestroy(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream, bool fImmediate)
+{
+    PDRVHSTAUDPW        pThis     = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW = (PDRVHSTAUDPWSTREAM)pStream;
+    AssertPtrReturn(pStreamPW, VERR_INVALID_POINTER);
+    RT_NOREF(fImmediate);
+
+    if (pStreamPW->pStream)
+    {
+        pw_thread_loop_lock(pThis->pThreadLoop);
+
+        /* The buffers go away with the stream, no need to return them. */
+        pStreamPW->pCurBuf = NULL;
+        pStreamPW->cInBufs = 0;
+        pw_stream_destroy(pStreamPW->pStream);
+        pStreamPW->pStream = NULL;
+
+        pw_thread_loop_unlock(pThis->pThreadLoop);
+    }
+
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamEnable}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_StreamEnable(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream)
+{
+    PDRVHSTAUDPW        pThis     = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW = (PDRVHSTAUDPWSTREAM)pStream;
+    LogFlowFunc(("\n"));
+
+    pw_thread_loop_lock(pThis->pThreadLoop);
+
+    drvHstAudPwStreamReturnBuffersLocked(pStreamPW);
+    pStreamPW->fDraining   = false;
+    pStreamPW->fStarved    = false;
+    pStreamPW->offInternal = 0;
+
+    int rcPw = pw_stream_set_active(pStreamPW->pStream, true);
+    int const rc = rcPw >= 0 ? VINF_SUCCESS
+                 : drvHstAudPwError(pThis, rcPw, "pw_stream_set_active('%s', true) failed", pStreamPW->Cfg.szName);
+
+    pw_thread_loop_unlock(pThis->pThreadLoop);
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamDisable}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_StreamDisable(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream)
+{
+    PDRVHSTAUDPW        pThis     = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW = (PDRVHSTAUDPWSTREAM)pStream;
+    LogFlowFunc(("\n"));
+
+    pw_thread_loop_lock(pThis->pThreadLoop);
+
+    /* A pending drain will deactivate the stream when it completes. */
+    int rc = VINF_SUCCESS;
+    if (!pStreamPW->fDraining)
+    {
+        drvHstAudPwStreamReturnBuffersLocked(pStreamPW);
+        pw_stream_flush(pStreamPW->pStream, false /*drain*/);
+        int rcPw = pw_stream_set_active(pStreamPW->pStream, false);
+        if (rcPw < 0)
+            rc = drvHstAudPwError(pThis, rcPw, "pw_stream_set_active('%s', false) failed", pStreamPW->Cfg.szName);
+    }
+    else
+        LogFlowFunc(("Drain already running on '%s', skipping.\n", pStreamPW->Cfg.szName));
+
+    pw_thread_loop_unlock(pThis->pThreadLoop);
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamPause}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_StreamPause(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream)
+{
+    /* Same as disable. */
+    return drvHstAudPwHA_StreamDisable(pInterface, pStream);
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamResume}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_StreamResume(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream)
+{
+    /* Same as enable. */
+    return drvHstAudPwHA_StreamEnable(pInterface, pStream);
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamDrain}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_StreamDrain(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream)
+{
+    PDRVHSTAUDPW        pThis     = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW = (PDRVHSTAUDPWSTREAM)pStream;
+    AssertReturn(pStreamPW->Cfg.enmDir == PDMAUDIODIR_OUT, VERR_INVALID_PARAMETER);
+    LogFlowFunc(("\n"));
+
+    pw_thread_loop_lock(pThis->pThreadLoop);
+
+    int rc = VINF_SUCCESS;
+    if (!pStreamPW->fDraining)
+    {
+        /* Push out what's left in the partially filled buffer first. */
+        if (pStreamPW->pCurBuf && pStreamPW->offCurBuf > 0)
+            drvHstAudPwStreamQueueCurBufLocked(pStreamPW);
+
+        int rcPw = pw_stream_flush(pStreamPW->pStream, true /*drain*/);
+        if (rcPw >= 0)
+            pStreamPW->fDraining = true;
+        else
+            rc = drvHstAudPwError(pThis, rcPw, "pw_stream_flush('%s', true) failed", pStreamPW->Cfg.szName);
+    }
+
+    pw_thread_loop_unlock(pThis->pThreadLoop);
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamGetState}
+ */
+static DECLCALLBACK(PDMHOSTAUDIOSTREAMSTATE) drvHstAudPwHA_StreamGetState(PPDMIHOSTAUDIO pInterface,
+                                                                          PPDMAUDIOBACKENDSTREAM pStream)
+{
+    PDRVHSTAUDPW        pThis     = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW = (PDRVHSTAUDPWSTREAM)pStream;
+    AssertPtrReturn(pStreamPW, PDMHOSTAUDIOSTREAMSTATE_INVALID);
+
+    PDMHOSTAUDIOSTREAMSTATE enmBackendStreamState = PDMHOSTAUDIOSTREAMSTATE_NOT_WORKING;
+    if (!pThis->fCoreError && pStreamPW->pStream)
+    {
+        switch (pStreamPW->enmState)
+        {
+            case PW_STREAM_STATE_UNCONNECTED:
+            case PW_STREAM_STATE_CONNECTING:
+                enmBackendStreamState = PDMHOSTAUDIOSTREAMSTATE_INITIALIZING;
+                break;
+            case PW_STREAM_STATE_PAUSED:
+            case PW_STREAM_STATE_STREAMING:
+                enmBackendStreamState = !pStreamPW->fDraining
+                                      ? PDMHOSTAUDIOSTREAMSTATE_OKAY : PDMHOSTAUDIOSTREAMSTATE_DRAINING;
+                break;
+            default:
+                break;
+        }
+    }
+    LogFlowFunc(("returns %s for stream '%s'\n", PDMHostAudioStreamStateGetName(enmBackendStreamState), pStreamPW->Cfg.szName));
+    return enmBackendStreamState;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamGetWritable}
+ */
+static DECLCALLBACK(uint32_t) drvHstAudPwHA_StreamGetWritable(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream)
+{
+    PDRVHSTAUDPW        pThis      = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW  = (PDRVHSTAUDPWSTREAM)pStream;
+    uint32_t            cbWritable = 0;
+    if (pStreamPW->Cfg.enmDir == PDMAUDIODIR_OUT && pStreamPW->cFramesQuantum)
+    {
+        pw_thread_loop_lock(pThis->pThreadLoop);
+
+        /* The queued count is in the unit we put in pw_buffer::size, i.e. frames. */
+        struct pw_time Time;
+        RT_ZERO(Time);
+        int rcPw = pw_stream_get_time_n(pStreamPW->pStream, &Time, sizeof(Time));
+        if (rcPw >= 0 && pStreamPW->cbBufferMin > 0)
+        {
+            uint32_t const cFramesPerBuf = PDMAudioPropsBytesToFrames(&pStreamPW->Cfg.Props, pStreamPW->cbBufferMin);
+            uint32_t const cBufsQueued   = (uint32_t)((Time.queued + cFramesPerBuf - 1) / cFramesPerBuf);
+            uint32_t const cBufsBusy     = cBufsQueued + (pStreamPW->pCurBuf != NULL);
+            if (cBufsBusy < pStreamPW->cBuffers)
+                cbWritable = (pStreamPW->cBuffers - cBufsBusy) * pStreamPW->cbBufferMin;
+            if (pStreamPW->pCurBuf)
+                cbWritable += pStreamPW->cbCurBuf - pStreamPW->offCurBuf;
+
+            /* Count underruns once per occurence. */
+            if (   Time.queued == 0
+                && pStreamPW->offInternal > 0
+                && pStreamPW->enmState == PW_STREAM_STATE_STREAMING
+                && !pStreamPW->fDraining)
+            {
+                if (!pStreamPW->fStarved)
+                {
+                    pStreamPW->fStarved = true;
+                    STAM_REL_COUNTER_INC(&pThis->StatUnderruns);
+                }
+            }
+            else
+                pStreamPW->fStarved = false;
+        }
+        else if (rcPw < 0)
+            drvHstAudPwError(pThis, rcPw, "pw_stream_get_time_n failed on '%s'", pStreamPW->Cfg.szName);
+
+        pw_thread_loop_unlock(pThis->pThreadLoop);
+    }
+    Log3Func(("returns %#x (%u)\n", cbWritable, cbWritable));
+    return cbWritable;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamPlay}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_StreamPlay(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream,
+                                                  const void *pvBuf, uint32_t cbBuf, uint32_t *pcbWritten)
+{
+    PDRVHSTAUDPW        pThis     = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW = (PDRVHSTAUDPWSTREAM)pStream;
+    AssertPtrReturn(pStreamPW, VERR_INVALID_POINTER);
+    AssertPtrReturn(pcbWritten, VERR_INVALID_POINTER);
+    if (cbBuf)
+        AssertPtrReturn(pvBuf, VERR_INVALID_POINTER);
+    else
+    {
+        /* Fend off draining calls. */
+        *pcbWritten = 0;
+        return VINF_SUCCESS;
+    }
+
+    pw_thread_loop_lock(pThis->pThreadLoop);
+
+    /*
+     * Copy straight into the mapped graph buffers, queueing each one as soon
+     * as it holds a full quantum.
+     */
+    uint32_t cbTotalWritten = 0;
+    while (cbBuf > 0)
+    {
+        if (!pStreamPW->pCurBuf)
+        {
+            struct pw_buffer *pBuf = pw_stream_dequeue_buffer(pStreamPW->pStream);
+            if (!pBuf)
+                break;
+            struct spa_data * const pData = &pBuf->buffer->datas[0];
+            if (!pData->data)
+            {
+                pw_stream_queue_buffer(pStreamPW->pStream, pBuf);
+                break;
+            }
+            pStreamPW->pCurBuf   = pBuf;
+            pStreamPW->offCurBuf = 0;
+            pStreamPW->cbCurBuf  = PDMAudioPropsFloorBytesToFrame(&pStreamPW->Cfg.Props,
+                                                                  RT_MIN(pData->maxsize, pStreamPW->cbQuantum));
+        }
+
+        uint32_t const cbToCopy = RT_MIN(cbBuf, pStreamPW->cbCurBuf - pStreamPW->offCurBuf);
+        memcpy((uint8_t *)pStreamPW->pCurBuf->buffer->datas[0].data + pStreamPW->offCurBuf, pvBuf, cbToCopy);
+        pStreamPW->offCurBuf   += cbToCopy;
+        pStreamPW->offInternal += cbToCopy;
+        cbTotalWritten         += cbToCopy;
+        cbBuf                  -= cbToCopy;
+        pvBuf                   = (uint8_t const *)pvBuf + cbToCopy;
+
+        if (pStreamPW->offCurBuf >= pStreamPW->cbCurBuf)
+            drvHstAudPwStreamQueueCurBufLocked(pStreamPW);
+    }
+
+    pw_thread_loop_unlock(pThis->pThreadLoop);
+
+    *pcbWritten = cbTotalWritten;
+    Log3Func(("returns VINF_SUCCESS *pcbWritten=%#x @%#RX64\n", cbTotalWritten, pStreamPW->offInternal));
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamGetReadable}
+ */
+static DECLCALLBACK(uint32_t) drvHstAudPwHA_StreamGetReadable(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream)
+{
+    PDRVHSTAUDPW        pThis      = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW  = (PDRVHSTAUDPWSTREAM)pStream;
+    uint32_t            cbReadable = 0;
+    if (pStreamPW->Cfg.enmDir == PDMAUDIODIR_IN)
+    {
+        pw_thread_loop_lock(pThis->pThreadLoop);
+        cbReadable = pStreamPW->cbInBufs;
+        if (pStreamPW->pCurBuf)
+            cbReadable += pStreamPW->cbCurBuf - pStreamPW->offCurBuf;
+        pw_thread_loop_unlock(pThis->pThreadLoop);
+    }
+    Log3Func(("returns %#x (%u)\n", cbReadable, cbReadable));
+    return cbReadable;
+}
+
+
+/**
+ * @interface_method_impl{PDMIHOSTAUDIO,pfnStreamCapture}
+ */
+static DECLCALLBACK(int) drvHstAudPwHA_StreamCapture(PPDMIHOSTAUDIO pInterface, PPDMAUDIOBACKENDSTREAM pStream,
+                                                     void *pvBuf, uint32_t cbBuf, uint32_t *pcbRead)
+{
+    PDRVHSTAUDPW        pThis     = RT_FROM_MEMBER(pInterface, DRVHSTAUDPW, IHostAudio);
+    PDRVHSTAUDPWSTREAM  pStreamPW = (PDRVHSTAUDPWSTREAM)pStream;
+    AssertPtrReturn(pStreamPW, VERR_INVALID_POINTER);
+    AssertPtrReturn(pvBuf, VERR_INVALID_POINTER);
+    AssertReturn(cbBuf, VERR_INVALID_PARAMETER);
+    AssertPtrReturn(pcbRead, VERR_INVALID_POINTER);
+
+    pw_thread_loop_lock(pThis->pThreadLoop);
+
+    /*
+     * Copy straight out of the mapped graph buffers, handing each one back
+     * as soon as it has been consumed.
+     */
+    uint32_t const cbFrame     = PDMAudioPropsFrameSize(&pStreamPW->Cfg.Props);
+    uint32_t       cbTotalRead = 0;
+    cbBuf = PDMAudioPropsFloorBytesToFrame(&pStreamPW->Cfg.Props, cbBuf);
+    while (cbBuf > 0)
+    {
+        if (!pStreamPW->pCurBuf)
+        {
+            if (!pStreamPW->cInBufs)
+                break;
+            struct pw_buffer * const pBuf = pStreamPW->apInBufs[pStreamPW->idxInBufs];
+            pStreamPW->apInBufs[pStreamPW->idxInBufs] = NULL;
+            pStreamPW->idxInBufs = (pStreamPW->idxInBufs + 1) % RT_ELEMENTS(pStreamPW->apInBufs);
+            pStreamPW->cInBufs--;
+
+            struct spa_data * const pData   = &pBuf->buffer->datas[0];
+            uint32_t const          offData = pData->maxsize ? pData->chunk->offset % pData->maxsize : 0;
+            uint32_t const          cbData  = RT_MIN(pData->chunk->size, pData->maxsize - offData);
+            pStreamPW->cbInBufs -= RT_MIN(pData->chunk->size, pStreamPW->cbInBufs);
+            if (!pData->data || cbData < cbFrame)
+            {
+                pw_stream_queue_buffer(pStreamPW->pStream, pBuf);
+                continue;
+            }
+            pStreamPW->pCurBuf   = pBuf;
+            pStreamPW->offCurBuf = offData;
+            pStreamPW->cbCurBuf  = offData + PDMAudioPropsFloorBytesToFrame(&pStreamPW->Cfg.Props, cbData);
+        }
+
+        uint32_t const cbToCopy = RT_MIN(cbBuf, pStreamPW->cbCurBuf - pStreamPW->offCurBuf);
+        memcpy(pvBuf, (uint8_t const *)pStreamPW->pCurBuf->buffer->datas[0].data + pStreamPW->offCurBuf, cbToCopy);
+        pStreamPW->offCurBuf   += cbToCopy;
+        pStreamPW->offInternal += cbToCopy;
+        cbTotalRead            += cbToCopy;
+        cbBuf                  -= cbToCopy;
+        pvBuf                   = (uint8_t *)pvBuf + cbToCopy;
+
+        if (pStreamPW->offCurBuf >= pStreamPW->cbCurBuf)
+        {
+            pw_stream_queue_buffer(pStreamPW->pStream, pStreamPW->pCurBuf);
+            pStreamPW->pCurBuf   = NULL;
+            pStreamPW->offCurBuf = 0;
+            pStreamPW->cbCurBuf  = 0;
+        }
+    }
+
+    pw_thread_loop_unlock(pThis->pThreadLoop);
+
+    *pcbRead = cbTotalRead;
+    Log3Func(("returns VINF_SUCCESS *pcbRead=%#x @%#RX64\n", cbTotalRead, pStreamPW->offInternal));
+    return VINF_SUCCESS;
+}
+
+
+/*********************************************************************************************************************************
+*   PDMIBASE                                                                                                                     *
+*********************************************************************************************************************************/
+
+/**
+ * @interface_method_impl{PDMIBASE,pfnQueryInterface}
+ */
+static DECLCALLBACK(void *) drvHstAudPwQueryInterface(PPDMIBASE pInterface, const char *pszIID)
+{
+    AssertPtrReturn(pInterface, NULL);
+    AssertPtrReturn(pszIID, NULL);
+
+    PPDMDRVINS   pDrvIns = PDMIBASE_2_PDMDRV(pInterface);
+    PDRVHSTAUDPW pThis   = PDMINS_2_DATA(pDrvIns, PDRVHSTAUDPW);
+    PDMIBASE_RETURN_INTERFACE(pszIID, PDMIBASE, &pDrvIns->IBase);
+    PDMIBASE_RETURN_INTERFACE(pszIID, PDMIHOSTAUDIO, &pThis->IHostAudio);
+
+    return NULL;
+}
+
+
+/*********************************************************************************************************************************
+*   PDMDRVREG                                                                                                                    *
+*********************************************************************************************************************************/
+
+/**
+ * Destructs a PipeWire Audio driver instance.
+ *
+ * @copydoc FNPDMDRVDESTRUCT
+ */
+static DECLCALLBACK(void) drvHstAudPwDestruct(PPDMDRVINS pDrvIns)
+{
+    PDMDRV_CHECK_VERSIONS_RETURN_VOID(pDrvIns);
+    PDRVHSTAUDPW pThis = PDMINS_2_DATA(pDrvIns, PDRVHSTAUDPW);
+    LogFlowFuncEnter();
+
+    if (pThis->pThreadLoop)
+        pw_thread_loop_stop(pThis->pThreadLoop);
+
+    if (pThis->pCore)
+    {
+        pw_core_disconnect(pThis->pCore);
+        pThis->pCore = NULL;
+    }
+
+    if (pThis->pContext)
+    {
+        pw_context_destroy(pThis->pContext);
+        pThis->pContext = NULL;
+    }
+
+    if (pThis->pThreadLoop)
+    {
+        pw_thread_loop_destroy(pThis->pThreadLoop);
+        pThis->pThreadLoop = NULL;
+    }
+
+    LogFlowFuncLeave();
+}
+
+
+/**
+ * Constructs a PipeWire Audio driver instance.
+ *
+ * @copydoc FNPDMDRVCONSTRUCT
+ */
+static DECLCALLBACK(int) drvHstAudPwConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint32_t fFlags)
+{
+    RT_NOREF(pCfg, fFlags);
+    PDMDRV_CHECK_VERSIONS_RETURN(pDrvIns);
+    PDRVHSTAUDPW    pThis = PDMINS_2_DATA(pDrvIns, PDRVHSTAUDPW);
+    PCPDMDRVHLPR3   pHlp  = pDrvIns->pHlpR3;
+
+    LogRel(("Audio: Initializing PipeWire driver\n"));
+
+    /*
+     * Initialize instance data.
+     */
+    pThis->pDrvIns                   = pDrvIns;
+    pThis->iSyncSeq                  = -1;
+    /* IBase */
+    pDrvIns->IBase.pfnQueryInterface = drvHstAudPwQueryInterface;
+    /* IHostAudio */
+    pThis->IHostAudio.pfnGetConfig                  = drvHstAudPwHA_GetConfig;
+    pThis->IHostAudio.pfnGetDevices                 = NULL;
+    pThis->IHostAudio.pfnSetDevice                  = drvHstAudPwHA_SetDevice;
+    pThis->IHostAudio.pfnGetStatus                  = drvHstAudPwHA_GetStatus;
+    pThis->IHostAudio.pfnDoOnWorkerThread           = NULL;
+    pThis->IHostAudio.pfnStreamConfigHint           = NULL;
+    pThis->IHostAudio.pfnStreamCreate               = drvHstAudPwHA_StreamCreate;
+    pThis->IHostAudio.pfnStreamInitAsync            = NULL;
+    pThis->IHostAudio.pfnStreamDestroy              = drvHstAudPwHA_StreamDestroy;
+    pThis->IHostAudio.pfnStreamNotifyDeviceChanged  = NULL;
+    pThis->IHostAudio.pfnStreamEnable               = drvHstAudPwHA_StreamEnable;
+    pThis->IHostAudio.pfnStreamDisable              = drvHstAudPwHA_StreamDisable;
+    pThis->IHostAudio.pfnStreamPause                = drvHstAudPwHA_StreamPause;
+    pThis->IHostAudio.pfnStreamResume               = drvHstAudPwHA_StreamResume;
+    pThis->IHostAudio.pfnStreamDrain                = drvHstAudPwHA_StreamDrain;
+    pThis->IHostAudio.pfnStreamGetState             = drvHstAudPwHA_StreamGetState;
+    pThis->IHostAudio.pfnStreamGetPending           = NULL;
+    pThis->IHostAudio.pfnStreamGetWritable          = drvHstAudPwHA_StreamGetWritable;
+    pThis->IHostAudio.pfnStreamPlay                 = drvHstAudPwHA_StreamPlay;
+    pThis->IHostAudio.pfnStreamGetReadable          = drvHstAudPwHA_StreamGetReadable;
+    pThis->IHostAudio.pfnStreamCapture              = drvHstAudPwHA_StreamCapture;
+    /* Core and stream events. */
+    pThis->CoreEvents.version                       = PW_VERSION_CORE_EVENTS;
+    pThis->CoreEvents.done                          = drvHstAudPwCoreDone;
+    pThis->CoreEvents.error                         = drvHstAudPwCoreError;
+    pThis->StreamEvents.version                     = PW_VERSION_STREAM_EVENTS;
+    pThis->StreamEvents.state_changed               = drvHstAudPwStreamStateChanged;
+    pThis->StreamEvents.param_changed               = drvHstAudPwStreamParamChanged;
+    pThis->StreamEvents.add_buffer                  = drvHstAudPwStreamAddBuffer;
+    pThis->StreamEvents.remove_buffer               = drvHstAudPwStreamRemoveBuffer;
+    pThis->StreamEvents.process                     = drvHstAudPwStreamProcess;
+    pThis->StreamEvents.drained                     = drvHstAudPwStreamDrained;
+
+    /*
+     * Read configuration.
+     */
+    PDMDRV_VALIDATE_CONFIG_RETURN(pDrvIns, "VmName|InputDeviceID|OutputDeviceID", "");
+    int rc = pHlp->pfnCFGMQueryString(pCfg, "VmName", pThis->szStreamName, sizeof(pThis->szStreamName));
+    AssertMsgRCReturn(rc, ("Confguration error: No/bad \"VmName\" value, rc=%Rrc\n", rc), rc);
+    rc = pHlp->pfnCFGMQueryStringDef(pCfg, "InputDeviceID", pThis->szInputDev, sizeof(pThis->szInputDev), "");
+    AssertMsgRCReturn(rc, ("Confguration error: Failed to read \"InputDeviceID\" as string: rc=%Rrc\n", rc), rc);
+    rc = pHlp->pfnCFGMQueryStringDef(pCfg, "OutputDeviceID", pThis->szOutputDev, sizeof(pThis->szOutputDev), "");
+    AssertMsgRCReturn(rc, ("Confguration error: Failed to read \"OutputDeviceID\" as string: rc=%Rrc\n", rc), rc);
+
+    /*
+     * Query the notification interface from the driver/device above us.
+     */
+    pThis->pIHostAudioPort = PDMIBASE_QUERY_INTERFACE(pDrvIns->pUpBase, PDMIHOSTAUDIOPORT);
+    AssertReturn(pThis->pIHostAudioPort, VERR_PDM_MISSING_INTERFACE_ABOVE);
+
+    /*
+     * Load the PipeWire library.
+     */
+    rc = audioLoadPipeWireLib();
+    if (RT_SUCCESS(rc))
+        LogRel(("PipeWire: Using version %s\n", pw_get_library_version()));
+    else
+    {
+        LogRel(("PipeWire: Failed to load the PipeWire shared library! Error %Rrc\n", rc));
+        return rc;
+    }
+
+    /*
+     * Set up the thread loop and context (remember the destructor is always called).
+     */
+    pThis->pThreadLoop = pw_thread_loop_new("VBoxPipeWire", NULL);
+    if (!pThis->pThreadLoop)
+    {
+        LogRel(("PipeWire: Failed to allocate thread loop\n"));
+        return VERR_NO_MEMORY;
+    }
+
+    pThis->pContext = pw_context_new(pw_thread_loop_get_loop(pThis->pThreadLoop), NULL, 0);
+    if (!pThis->pContext)
+    {
+        LogRel(("PipeWire: Failed to allocate context\n"));
+        return VERR_NO_MEMORY;
+    }
+
+    if (pw_thread_loop_start(pThis->pThreadLoop) < 0)
+    {
+        LogRel(("PipeWire: Failed to start thread loop\n"));
+        return VERR_AUDIO_BACKEND_INIT_FAILED;
+    }
+
+    /*
+     * Connect to the server and do a round trip to make sure it's really there.
+     */
+    pw_thread_loop_lock(pThis->pThreadLoop);
+    pThis->pCore = pw_context_connect(pThis->pContext, NULL, 0);
+    if (pThis->pCore)
+    {
+        RT_ZERO(pThis->CoreListener);
+        pw_core_add_listener(pThis->pCore, &pThis->CoreListener, &pThis->CoreEvents, pThis);
+
+        pThis->fSyncDone = false;
+        pThis->iSyncSeq  = pw_core_sync(pThis->pCore, PW_ID_CORE, 0);
+        for (unsigned cSecs = 0; cSecs < DRVHSTAUDPW_TIMEOUT_SECS && !pThis->fSyncDone && !pThis->fCoreError; cSecs++)
+            pw_thread_loop_timed_wait(pThis->pThreadLoop, 1);
+        if (!pThis->fSyncDone)
+        {
+            LogRel(("PipeWire: Server did not respond\n"));
+            rc = VERR_AUDIO_BACKEND_INIT_FAILED;
+        }
+    }
+    else
+    {
+        LogRel(("PipeWire: Failed to connect to server: %d\n", errno));
+        rc = VERR_AUDIO_BACKEND_INIT_FAILED;
+    }
+    pw_thread_loop_unlock(pThis->pThreadLoop);
+
+    /*
+     * Register statistics.
+     */
+    if (RT_SUCCESS(rc))
+    {
+        LogRel2(("PipeWire: Connected to PipeWire server\n"));
+
+        PDMDrvHlpSTAMRegister(pDrvIns, &pThis->StatOverruns, STAMTYPE_COUNTER, "Overruns", STAMUNIT_OCCURENCES,
+                              "Input buffers dropped because nobody was reading (all streams)");
+        PDMDrvHlpSTAMRegister(pDrvIns, &pThis->StatUnderruns, STAMTYPE_COUNTER, "Underruns", STAMUNIT_OCCURENCES,
+                              "Output streams running out of queued buffers (all streams)");
+    }
+
+    LogRel2(("PipeWire: Initialization ended with %Rrc\n", rc));
+    return rc;
+}
+
+
+/**
+ * PipeWire driver registration record.
+ */
+const PDMDRVREG g_DrvHostPipeWireAudio =
+{
+    /* u32Version */
+    PDM_DRVREG_VERSION,
+    /* szName */
+    "PipeWireAudio",
+    /* szRCMod */
+    "",
+    /* szR0Mod */
+    "",
+    /* pszDescription */
+    "PipeWire host driver",
+    /* fFlags */
+     PDM_DRVREG_FLAGS_HOST_BITS_DEFAULT,
+    /* fClass. */
+    PDM_DRVREG_CLASS_AUDIO,
+    /* cMaxInstances */
+    ~0U,
+    /* cbInstance */
+    sizeof(DRVHSTAUDPW),
+    /* pfnConstruct */
+    drvHstAudPwConstruct,
+    /* pfnDestruct */
+    drvHstAudPwDestruct,
+    /* pfnRelocate */
+    NULL,
+    /* pfnIOCtl */
+    NULL,
+    /* pfnPowerOn */
+    NULL,
+    /* pfnReset */
+    NULL,
+    /* pfnSuspend */
+    NULL,
+    /* pfnResume */
+    NULL,
+    /* pfnAttach */
+    NULL,
+    /* pfnDetach */
+    NULL,
+    /* pfnPowerOff */
+    NULL,
+    /* pfnSoftReset */
+    NULL,
+    /* u32EndVersion */
+    PDM_DRVREG_VERSION
+};
+
@@ -0,0 +1,253 @@
+/* $Id$ */
+/** @file
+ * Stubs for libpipewire.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#define LOG_GROUP LOG_GROUP_DRV_HOST_AUDIO
+#include <iprt/assert.h>
+#include <iprt/errcore.h>
+#include <iprt/ldr.h>
+#include <VBox/log.h>
+#include <iprt/once.h>
+
+#include <pipewire/pipewire.h>
+
+#include "DrvHostAudioPipeWireStubs.h"
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+#define VBOX_PIPEWIRE_LIB "libpipewire-0.3.so.0"
+
+#define PROXY_STUB(function, rettype, signature, shortsig) \
+    static rettype (*g_pfn_ ## function) signature; \
+    \
+    extern "C" rettype VBox_##function signature; \
+    rettype VBox_##function signature \
+    { \
+        return g_pfn_ ## function shortsig; \
+    }
+
+#define PROXY_STUB_VOID(function, signature, shortsig) \
+    static void (*g_pfn_ ## function) signature; \
+    \
+    extern "C" void VBox_##function signature; \
+    void VBox_##function signature \
+    { \
+        g_pfn_ ## function shortsig; \
+    }
+
+PROXY_STUB_VOID(pw_init,
+                (int *argc, char **argv[]),
+                (argc, argv))
+PROXY_STUB     (pw_get_library_version, const char *, (void), ())
+
+PROXY_STUB     (pw_thread_loop_new, struct pw_thread_loop *,
+                (const char *name, const struct spa_dict *props),
+                (name, props))
+PROXY_STUB_VOID(pw_thread_loop_destroy,
+                (struct pw_thread_loop *loop),
+                (loop))
+PROXY_STUB     (pw_thread_loop_start, int,
+                (struct pw_thread_loop *loop),
+                (loop))
+PROXY_STUB_VOID(pw_thread_loop_stop,
+                (struct pw_thread_loop *loop),
+                (loop))
+PROXY_STUB_VOID(pw_thread_loop_lock,
+                (struct pw_thread_loop *loop),
+                (loop))
+PROXY_STUB_VOID(pw_thread_loop_unlock,
+                (struct pw_thread_loop *loop),
+                (loop))
+PROXY_STUB_VOID(pw_thread_loop_signal,
+                (struct pw_thread_loop *loop, bool wait_for_accept),
+                (loop, wait_for_accept))
+PROXY_STUB_VOID(pw_thread_loop_wait,
+                (struct pw_thread_loop *loop),
+                (loop))
+PROXY_STUB     (pw_thread_loop_timed_wait, int,
+                (struct pw_thread_loop *loop, int wait_max_sec),
+                (loop, wait_max_sec))
+PROXY_STUB     (pw_thread_loop_get_loop, struct pw_loop *,
+                (struct pw_thread_loop *loop),
+                (loop))
+
+PROXY_STUB     (pw_context_new, struct pw_context *,
+                (struct pw_loop *main_loop, struct pw_properties *props, size_t user_data_size),
+                (main_loop, props, user_data_size))
+PROXY_STUB_VOID(pw_context_destroy,
+                (struct pw_context *context),
+                (context))
+PROXY_STUB     (pw_context_connect, struct pw_core *,
+                (struct pw_context *context, struct pw_properties *properties, size_t user_data_size),
+                (context, properties, user_data_size))
+PROXY_STUB     (pw_core_disconnect, int,
+                (struct pw_core *core),
+                (core))
+
+PROXY_STUB     (pw_properties_new_dict, struct pw_properties *,
+                (const struct spa_dict *dict),
+                (dict))
+PROXY_STUB     (pw_properties_set, int,
+                (struct pw_properties *properties, const char *key, const char *value),
+                (properties, key, value))
+
+PROXY_STUB     (pw_stream_new, struct pw_stream *,
+                (struct pw_core *core, const char *name, struct pw_properties *props),
+                (core, name, props))
+PROXY_STUB_VOID(pw_stream_destroy,
+                (struct pw_stream *stream),
+                (stream))
+PROXY_STUB_VOID(pw_stream_add_listener,
+                (struct pw_stream *stream, struct spa_hook *listener, const struct pw_stream_events *events, void *data),
+                (stream, listener, events, data))
+PROXY_STUB     (pw_stream_connect, int,
+                (struct pw_stream *stream, enum pw_direction direction, uint32_t target_id,
+                 enum pw_stream_flags flags, const struct spa_pod **params, uint32_t n_params),
+                (stream, direction, target_id, flags, params, n_params))
+PROXY_STUB     (pw_stream_disconnect, int,
+                (struct pw_stream *stream),
+                (stream))
+PROXY_STUB     (pw_stream_get_state, enum pw_stream_state,
+                (struct pw_stream *stream, const char **error),
+                (stream, error))
+PROXY_STUB     (pw_stream_state_as_string, const char *,
+                (enum pw_stream_state state),
+                (state))
+PROXY_STUB     (pw_stream_update_params, int,
+                (struct pw_stream *stream, const struct spa_pod **params, uint32_t n_params),
+                (stream, params, n_params))
+PROXY_STUB     (pw_stream_dequeue_buffer, struct pw_buffer *,
+                (struct pw_stream *stream),
+                (stream))
+PROXY_STUB     (pw_stream_queue_buffer, int,
+                (struct pw_stream *stream, struct pw_buffer *buffer),
+                (stream, buffer))
+PROXY_STUB     (pw_stream_set_active, int,
+                (struct pw_stream *stream, bool active),
+                (stream, active))
+PROXY_STUB     (pw_stream_flush, int,
+                (struct pw_stream *stream, bool drain),
+                (stream, drain))
+PROXY_STUB     (pw_stream_get_time_n, int,
+                (struct pw_stream *stream, struct pw_time *time, size_t size),
+                (stream, time, size))
+
+#define FUNC_ENTRY(function) { #function , (void (**)(void)) & g_pfn_ ## function }
+static struct
+{
+    const char *pszName;
+    void     (**pfn)(void);
+} const g_aImportedFunctions[] =
+{
+    FUNC_ENTRY(pw_init),
+    FUNC_ENTRY(pw_get_library_version),
+
+    FUNC_ENTRY(pw_thread_loop_new),
+    FUNC_ENTRY(pw_thread_loop_destroy),
+    FUNC_ENTRY(pw_thread_loop_start),
+    FUNC_ENTRY(pw_thread_loop_stop),
+    FUNC_ENTRY(pw_thread_loop_lock),
+    FUNC_ENTRY(pw_thread_loop_unlock),
+    FUNC_ENTRY(pw_thread_loop_signal),
+    FUNC_ENTRY(pw_thread_loop_wait),
+    FUNC_ENTRY(pw_thread_loop_timed_wait),
+    FUNC_ENTRY(pw_thread_loop_get_loop),
+
+    FUNC_ENTRY(pw_context_new),
+    FUNC_ENTRY(pw_context_destroy),
+    FUNC_ENTRY(pw_context_connect),
+    FUNC_ENTRY(pw_core_disconnect),
+
+    FUNC_ENTRY(pw_properties_new_dict),
+    FUNC_ENTRY(pw_properties_set),
+
+    FUNC_ENTRY(pw_stream_new),
+    FUNC_ENTRY(pw_stream_destroy),
+    FUNC_ENTRY(pw_stream_add_listener),
+    FUNC_ENTRY(pw_stream_connect),
+    FUNC_ENTRY(pw_stream_disconnect),
+    FUNC_ENTRY(pw_stream_get_state),
+    FUNC_ENTRY(pw_stream_state_as_string),
+    FUNC_ENTRY(pw_stream_update_params),
+    FUNC_ENTRY(pw_stream_dequeue_buffer),
+    FUNC_ENTRY(pw_stream_queue_buffer),
+    FUNC_ENTRY(pw_stream_set_active),
+    FUNC_ENTRY(pw_stream_flush),
+    FUNC_ENTRY(pw_stream_get_time_n)
+};
+#undef FUNC_ENTRY
+
+/** Init once.   */
+static RTONCE g_PipeWireLibInitOnce = RTONCE_INITIALIZER;
+
+/** @callback_method_impl{FNRTONCE} */
+static DECLCALLBACK(int32_t) drvHostAudioPipeWireLibInitOnce(void *pvUser)
+{
+    RT_NOREF(pvUser);
+    LogFlowFunc(("\n"));
+
+    RTLDRMOD hMod = NIL_RTLDRMOD;
+    int rc = RTLdrLoadSystemEx(VBOX_PIPEWIRE_LIB, RTLDRLOAD_FLAGS_NO_UNLOAD, &hMod);
+    if (RT_SUCCESS(rc))
+    {
+        for (unsigned i = 0; i < RT_ELEMENTS(g_aImportedFunctions); i++)
+        {
+            rc = RTLdrGetSymbol(hMod, g_aImportedFunctions[i].pszName, (void **)g_aImportedFunctions[i].pfn);
+            if (RT_FAILURE(rc))
+            {
+                LogRelFunc(("Failed to resolve function #%u: '%s' (%Rrc)\n", i, g_aImportedFunctions[i].pszName, rc));
+                break;
+            }
+        }
+
+        RTLdrClose(hMod);
+
+        /* The library must be initialized once per process before use. */
+        if (RT_SUCCESS(rc))
+            g_pfn_pw_init(NULL, NULL);
+    }
+    else
+        LogRelFunc(("Failed to load library %s: %Rrc\n", VBOX_PIPEWIRE_LIB, rc));
+    return rc;
+}
+
+/**
+ * Try to dynamically load the PipeWire libraries.
+ *
+ * @returns VBox status code.
+ */
+int audioLoadPipeWireLib(void)
+{
+    LogFlowFunc(("\n"));
+    return RTOnce(&g_PipeWireLibInitOnce, drvHostAudioPipeWireLibInitOnce, NULL);
+}
+
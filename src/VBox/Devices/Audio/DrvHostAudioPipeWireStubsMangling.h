@@ -0,0 +1,76 @@
+/* $Id$ */
+/** @file
+ * Mangle libpipewire symbols.
+ *
+ * This is necessary on hosts which don't support the -fvisibility gcc switch.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+#ifndef VBOX_INCLUDED_SRC_Audio_DrvHostAudioPipeWireStubsMangling_h
+#define VBOX_INCLUDED_SRC_Audio_DrvHostAudioPipeWireStubsMangling_h
+#ifndef RT_WITHOUT_PRAGMA_ONCE
+# pragma once
+#endif
+
+#define PIPEWIRE_MANGLER(symbol) VBox_##symbol
+
+#define pw_init                                 PIPEWIRE_MANGLER(pw_init)
+#define pw_get_library_version                  PIPEWIRE_MANGLER(pw_get_library_version)
+
+#define pw_thread_loop_new                      PIPEWIRE_MANGLER(pw_thread_loop_new)
+#define pw_thread_loop_destroy                  PIPEWIRE_MANGLER(pw_thread_loop_destroy)
+#define pw_thread_loop_start                    PIPEWIRE_MANGLER(pw_thread_loop_start)
+#define pw_thread_loop_stop                     PIPEWIRE_MANGLER(pw_thread_loop_stop)
+#define pw_thread_loop_lock                     PIPEWIRE_MANGLER(pw_thread_loop_lock)
+#define pw_thread_loop_unlock                   PIPEWIRE_MANGLER(pw_thread_loop_unlock)
+#define pw_thread_loop_signal                   PIPEWIRE_MANGLER(pw_thread_loop_signal)
+#define pw_thread_loop_wait                     PIPEWIRE_MANGLER(pw_thread_loop_wait)
+#define pw_thread_loop_timed_wait               PIPEWIRE_MANGLER(pw_thread_loop_timed_wait)
+#define pw_thread_loop_get_loop                 PIPEWIRE_MANGLER(pw_thread_loop_get_loop)
+
+#define pw_context_new                          PIPEWIRE_MANGLER(pw_context_new)
+#define pw_context_destroy                      PIPEWIRE_MANGLER(pw_context_destroy)
+#define pw_context_connect                      PIPEWIRE_MANGLER(pw_context_connect)
+
+#define pw_core_disconnect                      PIPEWIRE_MANGLER(pw_core_disconnect)
+
+#define pw_properties_new_dict                  PIPEWIRE_MANGLER(pw_properties_new_dict)
+#define pw_properties_set                       PIPEWIRE_MANGLER(pw_properties_set)
+
+#define pw_stream_new                           PIPEWIRE_MANGLER(pw_stream_new)
+#define pw_stream_destroy                       PIPEWIRE_MANGLER(pw_stream_destroy)
+#define pw_stream_add_listener                  PIPEWIRE_MANGLER(pw_stream_add_listener)
+#define pw_stream_connect                       PIPEWIRE_MANGLER(pw_stream_connect)
+#define pw_stream_disconnect                    PIPEWIRE_MANGLER(pw_stream_disconnect)
+#define pw_stream_get_state                     PIPEWIRE_MANGLER(pw_stream_get_state)
+#define pw_stream_state_as_string               PIPEWIRE_MANGLER(pw_stream_state_as_string)
+#define pw_stream_update_params                 PIPEWIRE_MANGLER(pw_stream_update_params)
+#define pw_stream_dequeue_buffer                PIPEWIRE_MANGLER(pw_stream_dequeue_buffer)
+#define pw_stream_queue_buffer                  PIPEWIRE_MANGLER(pw_stream_queue_buffer)
+#define pw_stream_set_active                    PIPEWIRE_MANGLER(pw_stream_set_active)
+#define pw_stream_flush                         PIPEWIRE_MANGLER(pw_stream_flush)
+#define pw_stream_get_time_n                    PIPEWIRE_MANGLER(pw_stream_get_time_n)
+
+#endif /* !VBOX_INCLUDED_SRC_Audio_DrvHostAudioPipeWireStubsMangling_h */
+
@@ -37,6 +37,7 @@
 #include <iprt/string.h>
 #include <iprt/test.h>
 #include <iprt/system.h>
+#include <iprt/time.h>
 
 #include <VBox/vmm/pdm.h>
 #include <VBox/vmm/pdmaudioinline.h>
@@ -865,6 +866,102 @@ static void tstVolume(RTTEST hTest)
 }
 
 
+/* Benchmark worker: pushes two streams through write, blend, volume and peek,
+   returning the time taken and the output produced. */
+static uint64_t tstBenchmarkRun(RTTEST hTest, PCPDMAUDIOPCMPROPS pSrcCfg, PCPDMAUDIOPCMPROPS pMixCfg,
+                                int16_t const *pai16Src, uint32_t cSrcFrames, uint32_t cRounds,
+                                uint8_t *pbOut, uint32_t cbOut, uint32_t *pcbOut)
+{
+    uint32_t const cBufSize = cSrcFrames * 2;
+    AUDIOMIXBUF    MixBuf;
+    RTTESTI_CHECK_RC_RET(AudioMixBufInit(&MixBuf, "Benchmark", pMixCfg, cBufSize), VINF_SUCCESS, 0);
+
+    AUDIOMIXBUFWRITESTATE WriteState;
+    RTTESTI_CHECK_RC_RET(AudioMixBufInitWriteState(&MixBuf, &WriteState, pSrcCfg), VINF_SUCCESS, 0);
+    AUDIOMIXBUFWRITESTATE BlendState;
+    RTTESTI_CHECK_RC_RET(AudioMixBufInitWriteState(&MixBuf, &BlendState, pSrcCfg), VINF_SUCCESS, 0);
+    AUDIOMIXBUFPEEKSTATE PeekState;
+    RTTESTI_CHECK_RC_RET(AudioMixBufInitPeekState(&MixBuf, &PeekState, pMixCfg), VINF_SUCCESS, 0);
+
+    PDMAUDIOVOLUME Vol;
+    PDMAudioVolumeInitFromStereo(&Vol, false, 255 - 16, 255 - 8);
+    AudioMixBufSetVolume(&MixBuf, &Vol);
+
+    uint32_t const cbSrc = PDMAudioPropsFramesToBytes(pSrcCfg, cSrcFrames);
+    *pcbOut = 0;
+    uint64_t const nsStart = RTTimeNanoTS();
+    for (uint32_t iRound = 0; iRound < cRounds; iRound++)
+    {
+        uint32_t cFramesWritten = 0;
+        AudioMixBufWrite(&MixBuf, &WriteState, pai16Src, cbSrc, 0 /*offDstFrame*/, cBufSize, &cFramesWritten);
+        uint32_t cFramesBlended = 0;
+        AudioMixBufBlend(&MixBuf, &BlendState, &pai16Src[cSrcFrames * 2], cbSrc, 0 /*offDstFrame*/, cFramesWritten,
+                         &cFramesBlended);
+        AudioMixBufCommit(&MixBuf, cFramesWritten);
+
+        uint32_t cFramesPeeked = 0;
+        uint32_t cbPeeked      = 0;
+        AudioMixBufPeek(&MixBuf, 0 /*offSrcFrame*/, cFramesWritten, &cFramesPeeked, &PeekState,
+                        &pbOut[*pcbOut], cbOut - *pcbOut, &cbPeeked);
+        AudioMixBufAdvance(&MixBuf, cFramesPeeked);
+        *pcbOut += cbPeeked;
+    }
+    uint64_t const cNsElapsed = RTTimeNanoTS() - nsStart;
+
+    AudioMixBufTerm(&MixBuf);
+    return cNsElapsed;
+}
+
+
+/* Benchmark the generic against the SIMD kernels, checking they produce the same output. */
+static void tstBenchmark(RTTEST hTest, uint32_t uSrcHz)
+{
+    RTTestSubF(hTest, "Benchmark %u to 48000 Hz (S16 2ch)", uSrcHz);
+
+    PDMAUDIOPCMPROPS const SrcCfg = PDMAUDIOPCMPROPS_INITIALIZER(2 /*cbSample*/, true /*fSigned*/, 2 /*cChannels*/, uSrcHz,
+                                                                 false /*fSwap*/);
+    PDMAUDIOPCMPROPS const MixCfg = PDMAUDIOPCMPROPS_INITIALIZER(2 /*cbSample*/, true /*fSigned*/, 2 /*cChannels*/, 48000,
+                                                                 false /*fSwap*/);
+
+    /* 10ms of noise for each of the two streams, with some silence thrown in. */
+    uint32_t const cSrcFrames = uSrcHz / 100;
+    uint32_t const cRounds    = 2000;
+    int16_t *pai16Src = (int16_t *)RTMemAlloc(cSrcFrames * 2 * 2 * sizeof(int16_t));
+    RTTESTI_CHECK_RETV(pai16Src);
+    for (uint32_t i = 0; i < cSrcFrames * 2 * 2; i++)
+        pai16Src[i] = (i % 64) < 8 ? 0 : (int16_t)RTRandU32Ex(0, UINT16_MAX);
+
+    uint32_t const cbOut = (48000 / 100 + 2) * 2 * sizeof(int16_t) * cRounds;
+    uint8_t *pbOutGeneric = (uint8_t *)RTMemAllocZ(cbOut);
+    uint8_t *pbOutSimd    = (uint8_t *)RTMemAllocZ(cbOut);
+    if (pbOutGeneric && pbOutSimd)
+    {
+        uint32_t cbOutGeneric = 0;
+        AudioMixBufTstSelectKernels(false);
+        uint64_t const cNsGeneric = tstBenchmarkRun(hTest, &SrcCfg, &MixCfg, pai16Src, cSrcFrames, cRounds,
+                                                    pbOutGeneric, cbOut, &cbOutGeneric);
+
+        uint32_t cbOutSimd = 0;
+        const char *pszSimd = AudioMixBufTstSelectKernels(true);
+        uint64_t const cNsSimd = tstBenchmarkRun(hTest, &SrcCfg, &MixCfg, pai16Src, cSrcFrames, cRounds,
+                                                 pbOutSimd, cbOut, &cbOutSimd);
+
+        uint64_t const cFrames = (uint64_t)cSrcFrames * cRounds;
+        RTTestValue(hTest, "generic", cNsGeneric / cFrames, RTTESTUNIT_NS_PER_FRAME);
+        RTTestValueF(hTest, cNsSimd / cFrames, RTTESTUNIT_NS_PER_FRAME, "%s", pszSimd);
+
+        if (cbOutGeneric != cbOutSimd || memcmp(pbOutGeneric, pbOutSimd, cbOutSimd) != 0)
+            RTTestFailed(hTest, "%s kernels produced different output: %#x vs %#x bytes\n", pszSimd, cbOutSimd, cbOutGeneric);
+    }
+    else
+        RTTestFailed(hTest, "Out of memory");
+
+    RTMemFree(pbOutSimd);
+    RTMemFree(pbOutGeneric);
+    RTMemFree(pai16Src);
+}
+
+
 int main(int argc, char **argv)
 {
     RTR3InitExe(argc, &argv, 0);
@@ -911,6 +1008,9 @@ int main(int argc, char **argv)
 
     tstVolume(hTest);
 
+    tstBenchmark(hTest, 48000);
+    tstBenchmark(hTest, 44100);
+
     /*
      * Summary
      */
@@ -55,10 +55,8 @@
 /** The IOMMU device instance magic. */
 #define IOMMU_MAGIC                                 0x10acce55
 
-/** Enable the IOTLBE cache only in ring-3 for now, see @bugref{9654#c95}. */
-#ifdef IN_RING3
-# define IOMMU_WITH_IOTLBE_CACHE
-#endif
+/** Enable the IOTLBE cache. */
+#define IOMMU_WITH_IOTLBE_CACHE
 /** Enable the interrupt cache. */
 #define IOMMU_WITH_IRTE_CACHE
 
@@ -89,8 +87,12 @@
 #endif  /* IOMMU_WITH_IRTE_CACHE */
 
 #ifdef IOMMU_WITH_IOTLBE_CACHE
+/** The number of sets in the IOTLB. */
+# define IOMMU_IOTLB_SETS                           32
+/** The number of entries (ways) in each IOTLB set. */
+# define IOMMU_IOTLB_WAYS                           4
 /** The maximum number of IOTLB entries. */
-# define IOMMU_IOTLBE_MAX                           64
+# define IOMMU_IOTLBE_MAX                           (IOMMU_IOTLB_SETS * IOMMU_IOTLB_WAYS)
 /** The mask of bits covering the domain ID in the IOTLBE key. */
 # define IOMMU_IOTLB_DOMAIN_ID_MASK                 UINT64_C(0xffffff0000000000)
 /** The mask of bits covering the IOVA in the IOTLBE key. */
@@ -114,6 +116,9 @@
  */
 # define IOMMU_IOTLB_KEY_MAKE(a_DomainId, a_uIova)  (  ((uint64_t)(a_DomainId) << IOMMU_IOTLB_DOMAIN_ID_SHIFT) \
                                                      | (((a_uIova) >> X86_PAGE_4K_SHIFT) & IOMMU_IOTLB_IOVA_MASK))
+/** Gets the IOTLB set index for an IOTLB entry key.
+ * Consecutive pages of a domain land in consecutive sets. */
+# define IOMMU_IOTLB_KEY_GET_SET(a_Key)             ((uint32_t)((a_Key) ^ IOMMU_IOTLB_KEY_GET_DOMAIN_ID(a_Key)) % IOMMU_IOTLB_SETS)
 #endif  /* IOMMU_WITH_IOTLBE_CACHE */
 
 #ifdef IOMMU_WITH_DTE_CACHE
@@ -305,21 +310,20 @@ AssertCompileSize(DTECACHE, 4);
  */
 typedef struct IOTLBE
 {
-    /** The AVL tree node. */
-    AVLU64NODECORE      Core;
-    /** The least recently used (LRU) list node. */
-    RTLISTNODE          NdLru;
+    /** The key, see IOMMU_IOTLB_KEY_MAKE. IOMMU_IOTLB_KEY_NIL if the entry is unused. */
+    uint64_t            uKey;
     /** The I/O page lookup results of the translation. */
     IOPAGELOOKUP        PageLookup;
-    /** Whether the entry needs to be evicted from the cache. */
-    bool                fEvictPending;
+    /** The IOTLB LRU clock value when this entry was last used. */
+    uint32_t            uLastUsed;
+    /** Padding. */
+    uint32_t            uPadding;
 } IOTLBE;
 /** Pointer to an IOMMU I/O TLB entry struct. */
 typedef IOTLBE *PIOTLBE;
 /** Pointer to a const IOMMU I/O TLB entry struct. */
 typedef IOTLBE const *PCIOTLBE;
 AssertCompileSizeAlignment(IOTLBE, 8);
-AssertCompileMemberOffset(IOTLBE, Core, 0);
 #endif  /* IOMMU_WITH_IOTLBE_CACHE */
 
 #ifdef IOMMU_WITH_IRTE_CACHE
@@ -373,6 +377,16 @@ typedef struct IOMMU
     /** Array of IRTE cache entries. */
     IRTECACHE                   aIrteCache[IOMMU_IRTE_CACHE_COUNT];
 #endif
+#ifdef IOMMU_WITH_IOTLBE_CACHE
+    /** The IOTLB, IOMMU_IOTLB_SETS sets of IOMMU_IOTLB_WAYS entries each.
+     * This lives in the shared state so translations in all contexts can use it,
+     * protected by CritSectCache like the DTE and IRTE caches. */
+    IOTLBE                      aIotlbes[IOMMU_IOTLBE_MAX];
+    /** The IOTLB LRU clock, advanced on every IOTLB hit and insertion. */
+    uint32_t                    uIotlbLruClock;
+    /** Number of cached IOTLB entries. */
+    uint32_t                    cCachedIotlbes;
+#endif
 
     /** @name PCI: Base capability block registers.
      * @{ */
@@ -524,7 +538,7 @@ typedef struct IOMMU
     STAMCOUNTER                 StatCmdInvIommuAll;        /**< Number of Invalidate IOMMU All commands processed. */
 
     STAMCOUNTER                 StatIotlbeCached;          /**< Number of IOTLB entries in the cache. */
-    STAMCOUNTER                 StatIotlbeLazyEvictReuse;  /**< Number of IOTLB entries re-used after lazy eviction. */
+    STAMCOUNTER                 StatIotlbeEvicted;         /**< Number of valid IOTLB entries evicted to make room. */
 
     STAMPROFILEADV              StatProfDteLookup;         /**< Profiling of I/O page walk (from memory). */
     STAMPROFILEADV              StatProfIotlbeLookup;      /**< Profiling of IOTLB entry lookup (from cache). */
@@ -561,6 +575,9 @@ AssertCompileMemberAlignment(IOMMU, aDteCache, 8);
 #ifdef IOMMU_WITH_IRTE_CACHE
 AssertCompileMemberAlignment(IOMMU, aIrteCache, 8);
 #endif
+#ifdef IOMMU_WITH_IOTLBE_CACHE
+AssertCompileMemberAlignment(IOMMU, aIotlbes, 8);
+#endif
 AssertCompileMemberAlignment(IOMMU, IommuBar, 8);
 AssertCompileMemberAlignment(IOMMU, aDevTabBaseAddrs, 8);
 AssertCompileMemberAlignment(IOMMU, CmdBufHeadPtr, 8);
@@ -577,28 +594,11 @@ typedef struct IOMMUR3
     R3PTRTYPE(PCPDMIOMMUHLPR3)  pIommuHlpR3;
     /** The command thread handle. */
     R3PTRTYPE(PPDMTHREAD)       pCmdThread;
-#ifdef IOMMU_WITH_IOTLBE_CACHE
-    /** Pointer to array of pre-allocated IOTLBEs. */
-    PIOTLBE                     paIotlbes;
-    /** Maps [DomainId,Iova] to [IOTLBE]. */
-    AVLU64TREE                  TreeIotlbe;
-    /** LRU list anchor for IOTLB entries. */
-    RTLISTANCHOR                LstLruIotlbe;
-    /** Index of the next unused IOTLB. */
-    uint32_t                    idxUnusedIotlbe;
-    /** Number of cached IOTLB entries in the tree. */
-    uint32_t                    cCachedIotlbes;
-#endif
 } IOMMUR3;
 /** Pointer to the ring-3 IOMMU device state. */
 typedef IOMMUR3 *PIOMMUR3;
 /** Pointer to the const ring-3 IOMMU device state. */
 typedef const IOMMUR3 *PCIOMMUR3;
-#ifdef IOMMU_WITH_IOTLBE_CACHE
-AssertCompileMemberAlignment(IOMMUR3, paIotlbes, 8);
-AssertCompileMemberAlignment(IOMMUR3, TreeIotlbe, 8);
-AssertCompileMemberAlignment(IOMMUR3, LstLruIotlbe, 8);
-#endif
 
 /**
  * The ring-0 IOMMU device state.
@@ -645,40 +645,6 @@ typedef IOMMUREGACC *PIOMMUREGACC;
 /** Pointer to a const IOMMU register access. */
 typedef IOMMUREGACC const *PCIOMMUREGACC;
 
-#ifdef IOMMU_WITH_IOTLBE_CACHE
-/**
- * IOTLBE flush argument.
- */
-typedef struct IOTLBEFLUSHARG
-{
-    /** The ring-3 IOMMU device state. */
-    PIOMMUR3            pIommuR3;
-    /** The domain ID to flush. */
-    uint16_t            idDomain;
-} IOTLBEFLUSHARG;
-/** Pointer to an IOTLBE flush argument. */
-typedef IOTLBEFLUSHARG *PIOTLBEFLUSHARG;
-/** Pointer to a const IOTLBE flush argument. */
-typedef IOTLBEFLUSHARG const *PCIOTLBEFLUSHARG;
-
-/**
- * IOTLBE Info. argument.
- */
-typedef struct IOTLBEINFOARG
-{
-    /** The ring-3 IOMMU device state. */
-    PIOMMUR3            pIommuR3;
-    /** The info helper. */
-    PCDBGFINFOHLP       pHlp;
-    /** The domain ID to dump IOTLB entry. */
-    uint16_t            idDomain;
-} IOTLBEINFOARG;
-/** Pointer to an IOTLBE flush argument. */
-typedef IOTLBEINFOARG *PIOTLBEINFOARG;
-/** Pointer to a const IOTLBE flush argument. */
-typedef IOTLBEINFOARG const *PCIOTLBEINFOARG;
-#endif
-
 /**
  * IOMMU operation auxiliary info.
  */
@@ -1076,283 +1042,106 @@ static void iommuAmdDteCacheRemoveAll(PPDMDEVINS pDevIns)
 
 #ifdef IOMMU_WITH_IOTLBE_CACHE
 /**
- * Moves the IOTLB entry to the least recently used slot.
- *
- * @param   pThisR3     The ring-3 IOMMU device state.
- * @param   pIotlbe     The IOTLB entry to move.
- */
-DECLINLINE(void) iommuAmdIotlbEntryMoveToLru(PIOMMUR3 pThisR3, PIOTLBE pIotlbe)
-{
-    if (!RTListNodeIsFirst(&pThisR3->LstLruIotlbe, &pIotlbe->NdLru))
-    {
-        RTListNodeRemove(&pIotlbe->NdLru);
-        RTListPrepend(&pThisR3->LstLruIotlbe, &pIotlbe->NdLru);
-    }
-}
-
-
-/**
- * Moves the IOTLB entry to the most recently used slot.
- *
- * @param   pThisR3     The ring-3 IOMMU device state.
- * @param   pIotlbe     The IOTLB entry to move.
- */
-DECLINLINE(void) iommuAmdIotlbEntryMoveToMru(PIOMMUR3 pThisR3, PIOTLBE pIotlbe)
-{
-    if (!RTListNodeIsLast(&pThisR3->LstLruIotlbe, &pIotlbe->NdLru))
-    {
-        RTListNodeRemove(&pIotlbe->NdLru);
-        RTListAppend(&pThisR3->LstLruIotlbe, &pIotlbe->NdLru);
-    }
-}
-
-
-# ifdef IN_RING3
-/**
- * Dumps the IOTLB entry via the debug info helper.
+ * Looks up an IOTLB from the cache.
  *
- * @returns VINF_SUCCESS.
- * @param   pNode       Pointer to an IOTLB entry to dump info.
- * @param   pvUser      Pointer to an IOTLBEINFOARG.
- */
-static DECLCALLBACK(int) iommuAmdR3IotlbEntryInfo(PAVLU64NODECORE pNode, void *pvUser)
-{
-    /* Validate. */
-    PCIOTLBEINFOARG pArgs = (PCIOTLBEINFOARG)pvUser;
-    AssertPtr(pArgs);
-    AssertPtr(pArgs->pIommuR3);
-    AssertPtr(pArgs->pHlp);
-    //Assert(pArgs->pIommuR3->u32Magic == IOMMU_MAGIC);
-
-    uint16_t const idDomain = IOMMU_IOTLB_KEY_GET_DOMAIN_ID(pNode->Key);
-    if (idDomain == pArgs->idDomain)
-    {
-        PCIOTLBE pIotlbe = (PCIOTLBE)pNode;
-        AVLU64KEY const  uKey          = pIotlbe->Core.Key;
-        uint64_t const   uIova         = IOMMU_IOTLB_KEY_GET_IOVA(uKey);
-        RTGCPHYS const   GCPhysSpa     = pIotlbe->PageLookup.GCPhysSpa;
-        uint8_t const    cShift        = pIotlbe->PageLookup.cShift;
-        size_t const     cbPage        = RT_BIT_64(cShift);
-        uint8_t const    fPerm         = pIotlbe->PageLookup.fPerm;
-        const char      *pszPerm       = iommuAmdMemAccessGetPermName(fPerm);
-        bool const       fEvictPending = pIotlbe->fEvictPending;
-
-        PCDBGFINFOHLP pHlp = pArgs->pHlp;
-        pHlp->pfnPrintf(pHlp, " Key           = %#RX64 (%#RX64)\n", uKey, uIova);
-        pHlp->pfnPrintf(pHlp, " GCPhys        = %#RGp\n",           GCPhysSpa);
-        pHlp->pfnPrintf(pHlp, " cShift        = %u (%zu bytes)\n",  cShift, cbPage);
-        pHlp->pfnPrintf(pHlp, " fPerm         = %#x (%s)\n",        fPerm, pszPerm);
-        pHlp->pfnPrintf(pHlp, " fEvictPending = %RTbool\n",         fEvictPending);
-    }
-
-    return VINF_SUCCESS;
-}
-# endif /* IN_RING3 */
-
-
-/**
- * Removes the IOTLB entry if it's associated with the specified domain ID.
+ * @returns Pointer to IOTLB entry if found, NULL otherwise.
+ * @param   pThis       The shared IOMMU device state.
+ * @param   idDomain    The domain ID.
+ * @param   uIova       The I/O virtual address.
  *
- * @returns VINF_SUCCESS.
- * @param   pNode       Pointer to an IOTLBE.
- * @param   pvUser      Pointer to an IOTLBEFLUSHARG containing the domain ID.
+ * @remarks The caller must hold the cache lock.
  */
-static DECLCALLBACK(int) iommuAmdIotlbEntryRemoveDomainId(PAVLU64NODECORE pNode, void *pvUser)
+static PIOTLBE iommuAmdIotlbLookup(PIOMMU pThis, uint64_t idDomain, uint64_t uIova)
 {
-    /* Validate. */
-    PCIOTLBEFLUSHARG pArgs = (PCIOTLBEFLUSHARG)pvUser;
-    AssertPtr(pArgs);
-    AssertPtr(pArgs->pIommuR3);
-    //Assert(pArgs->pIommuR3->u32Magic == IOMMU_MAGIC);
-
-    uint16_t const idDomain = IOMMU_IOTLB_KEY_GET_DOMAIN_ID(pNode->Key);
-    if (idDomain == pArgs->idDomain)
-    {
-        /* Mark this entry is as invalidated and needs to be evicted later. */
-        PIOTLBE pIotlbe = (PIOTLBE)pNode;
-        pIotlbe->fEvictPending = true;
-        iommuAmdIotlbEntryMoveToLru(pArgs->pIommuR3, (PIOTLBE)pNode);
-    }
-    return VINF_SUCCESS;
+    uint64_t const uKey   = IOMMU_IOTLB_KEY_MAKE(idDomain, uIova);
+    PIOTLBE        paSet  = &pThis->aIotlbes[IOMMU_IOTLB_KEY_GET_SET(uKey) * IOMMU_IOTLB_WAYS];
+    for (uint32_t i = 0; i < IOMMU_IOTLB_WAYS; i++)
+        if (paSet[i].uKey == uKey)
+        {
+            paSet[i].uLastUsed = ++pThis->uIotlbLruClock;
+            return &paSet[i];
+        }
+    return NULL;
 }
 
 
 /**
- * Destroys an IOTLB entry that's in the tree.
+ * Adds an IOTLB entry to the cache.
  *
- * @returns VINF_SUCCESS.
- * @param   pNode       Pointer to an IOTLBE.
- * @param   pvUser      Opaque data. Currently not used, will be NULL.
- */
-static DECLCALLBACK(int) iommuAmdIotlbEntryDestroy(PAVLU64NODECORE pNode, void *pvUser)
-{
-    RT_NOREF(pvUser);
-    PIOTLBE pIotlbe = (PIOTLBE)pNode;
-    Assert(pIotlbe);
-    pIotlbe->NdLru.pNext = NULL;
-    pIotlbe->NdLru.pPrev = NULL;
-    RT_ZERO(pIotlbe->PageLookup);
-    pIotlbe->fEvictPending = false;
-    return VINF_SUCCESS;
-}
-
-
-/**
- * Inserts an IOTLB entry into the cache.
+ * An existing entry for the same domain and page is updated, otherwise a free
+ * entry of the set is used, or the least recently used one evicted.
  *
  * @param   pThis           The shared IOMMU device state.
- * @param   pThisR3         The ring-3 IOMMU device state.
- * @param   pIotlbe         The IOTLB entry to initialize and insert.
  * @param   idDomain        The domain ID.
- * @param   uIova           The I/O virtual address.
+ * @param   uIovaPage       The I/O virtual address (must be 4K aligned).
  * @param   pPageLookup     The I/O page lookup result of the access.
+ *
+ * @remarks The caller must hold the cache lock.
  */
-static void iommuAmdIotlbEntryInsert(PIOMMU pThis, PIOMMUR3 pThisR3, PIOTLBE pIotlbe, uint16_t idDomain, uint64_t uIova,
-                                     PCIOPAGELOOKUP pPageLookup)
+static void iommuAmdIotlbAdd(PIOMMU pThis, uint16_t idDomain, uint64_t uIovaPage, PCIOPAGELOOKUP pPageLookup)
 {
-    /* Initialize the IOTLB entry with results of the I/O page walk. */
-    AVLU64KEY const uKey = IOMMU_IOTLB_KEY_MAKE(idDomain, uIova);
-    Assert(uKey != IOMMU_IOTLB_KEY_NIL);
+    Assert(!(uIovaPage & X86_PAGE_4K_OFFSET_MASK));
+    Assert(pPageLookup);
+    Assert(pPageLookup->cShift <= 51);
+    Assert(pPageLookup->fPerm != IOMMU_IO_PERM_NONE);
 
-    /* Check if the entry already exists. */
-    PIOTLBE pFound = (PIOTLBE)RTAvlU64Get(&pThisR3->TreeIotlbe, uKey);
-    if (!pFound)
-    {
-        /* Insert the entry into the cache. */
-        pIotlbe->Core.Key   = uKey;
-        pIotlbe->PageLookup = *pPageLookup;
-        Assert(!pIotlbe->fEvictPending);
+    uint64_t const uKey = IOMMU_IOTLB_KEY_MAKE(idDomain, uIovaPage);
+    Assert(uKey != IOMMU_IOTLB_KEY_NIL);
 
-        bool const fInserted = RTAvlU64Insert(&pThisR3->TreeIotlbe, &pIotlbe->Core);
-        Assert(fInserted); NOREF(fInserted);
-        Assert(pThisR3->cCachedIotlbes < IOMMU_IOTLBE_MAX);
-        ++pThisR3->cCachedIotlbes;
-        STAM_COUNTER_INC(&pThis->StatIotlbeCached); NOREF(pThis);
-    }
-    else
+    PIOTLBE paSet    = &pThis->aIotlbes[IOMMU_IOTLB_KEY_GET_SET(uKey) * IOMMU_IOTLB_WAYS];
+    PIOTLBE pIotlbe  = NULL;
+    PIOTLBE pVictim  = &paSet[0];
+    for (uint32_t i = 0; i < IOMMU_IOTLB_WAYS; i++)
     {
-        /* Update the existing entry. */
-        Assert(pFound->Core.Key == uKey);
-        if (pFound->fEvictPending)
+        if (paSet[i].uKey == uKey)
         {
-            pFound->fEvictPending = false;
-            STAM_COUNTER_INC(&pThis->StatIotlbeLazyEvictReuse); NOREF(pThis);
+            pIotlbe = &paSet[i];
+            break;
         }
-        pFound->PageLookup = *pPageLookup;
+        if (   pVictim->uKey != IOMMU_IOTLB_KEY_NIL
+            && (   paSet[i].uKey == IOMMU_IOTLB_KEY_NIL
+                || (int32_t)(paSet[i].uLastUsed - pVictim->uLastUsed) < 0))
+            pVictim = &paSet[i];
     }
-}
-
 
-/**
- * Removes an IOTLB entry from the cache for the given key.
- *
- * @returns Pointer to the removed IOTLB entry, NULL if the entry wasn't found in
- *          the tree.
- * @param   pThis       The shared IOMMU device state.
- * @param   pThisR3     The ring-3 IOMMU device state.
- * @param   uKey        The key of the IOTLB entry to remove.
- */
-static PIOTLBE iommuAmdIotlbEntryRemove(PIOMMU pThis, PIOMMUR3 pThisR3, AVLU64KEY uKey)
-{
-    PIOTLBE pIotlbe = (PIOTLBE)RTAvlU64Remove(&pThisR3->TreeIotlbe, uKey);
-    if (pIotlbe)
+    if (!pIotlbe)
     {
-        if (pIotlbe->fEvictPending)
-            STAM_COUNTER_INC(&pThis->StatIotlbeLazyEvictReuse);
-
-        RT_ZERO(pIotlbe->Core);
-        RT_ZERO(pIotlbe->PageLookup);
-        /* We must not erase the LRU node connections here! */
-        pIotlbe->fEvictPending = false;
-        Assert(pIotlbe->Core.Key == IOMMU_IOTLB_KEY_NIL);
-
-        Assert(pThisR3->cCachedIotlbes > 0);
-        --pThisR3->cCachedIotlbes;
-        STAM_COUNTER_DEC(&pThis->StatIotlbeCached); NOREF(pThis);
+        pIotlbe = pVictim;
+        if (pIotlbe->uKey != IOMMU_IOTLB_KEY_NIL)
+            STAM_COUNTER_INC(&pThis->StatIotlbeEvicted);
+        else
+        {
+            Assert(pThis->cCachedIotlbes < IOMMU_IOTLBE_MAX);
+            ++pThis->cCachedIotlbes;
+            STAM_COUNTER_INC(&pThis->StatIotlbeCached);
+        }
+        pIotlbe->uKey = uKey;
     }
-    return pIotlbe;
+    pIotlbe->PageLookup = *pPageLookup;
+    pIotlbe->uLastUsed  = ++pThis->uIotlbLruClock;
 }
 
 
 /**
- * Looks up an IOTLB from the cache.
+ * Removes an IOTLB entry from the cache.
  *
- * @returns Pointer to IOTLB entry if found, NULL otherwise.
  * @param   pThis       The shared IOMMU device state.
- * @param   pThisR3     The ring-3 IOMMU device state.
- * @param   idDomain    The domain ID.
- * @param   uIova       The I/O virtual address.
- */
-static PIOTLBE iommuAmdIotlbLookup(PIOMMU pThis, PIOMMUR3 pThisR3, uint64_t idDomain, uint64_t uIova)
-{
-    RT_NOREF(pThis);
-
-    uint64_t const uKey = IOMMU_IOTLB_KEY_MAKE(idDomain, uIova);
-    PIOTLBE pIotlbe = (PIOTLBE)RTAvlU64Get(&pThisR3->TreeIotlbe, uKey);
-    if (    pIotlbe
-        && !pIotlbe->fEvictPending)
-        return pIotlbe;
-
-    /*
-     * Domain Id wildcard invalidations only marks entries for eviction later but doesn't remove
-     * them from the cache immediately. We found an entry pending eviction, just return that
-     * nothing was found (rather than evicting now).
-     */
-    return NULL;
-}
-
-
-/**
- * Adds an IOTLB entry to the cache.
+ * @param   pIotlbe     The IOTLB entry to remove.
  *
- * @param   pThis           The shared IOMMU device state.
- * @param   pThisR3         The ring-3 IOMMU device state.
- * @param   idDomain        The domain ID.
- * @param   uIovaPage       The I/O virtual address (must be 4K aligned).
- * @param   pPageLookup     The I/O page lookup result of the access.
+ * @remarks The caller must hold the cache lock.
  */
-static void iommuAmdIotlbAdd(PIOMMU pThis, PIOMMUR3 pThisR3, uint16_t idDomain, uint64_t uIovaPage, PCIOPAGELOOKUP pPageLookup)
+DECLINLINE(void) iommuAmdIotlbEntryRemove(PIOMMU pThis, PIOTLBE pIotlbe)
 {
-    Assert(!(uIovaPage & X86_PAGE_4K_OFFSET_MASK));
-    Assert(pPageLookup);
-    Assert(pPageLookup->cShift <= 51);
-    Assert(pPageLookup->fPerm != IOMMU_IO_PERM_NONE);
-
-    /*
-     * If there are no unused IOTLB entries, evict the LRU entry.
-     * Otherwise, get a new IOTLB entry from the pre-allocated list.
-     */
-    if (pThisR3->idxUnusedIotlbe == IOMMU_IOTLBE_MAX)
-    {
-        /* Grab the least recently used entry. */
-        PIOTLBE pIotlbe = RTListGetFirst(&pThisR3->LstLruIotlbe, IOTLBE, NdLru);
-        Assert(pIotlbe);
-
-        /* If the entry is in the cache, remove it. */
-        if (pIotlbe->Core.Key != IOMMU_IOTLB_KEY_NIL)
-            iommuAmdIotlbEntryRemove(pThis, pThisR3, pIotlbe->Core.Key);
-
-        /* Initialize and insert the IOTLB entry into the cache. */
-        iommuAmdIotlbEntryInsert(pThis, pThisR3, pIotlbe, idDomain, uIovaPage, pPageLookup);
-
-        /* Move the entry to the most recently used slot. */
-        iommuAmdIotlbEntryMoveToMru(pThisR3, pIotlbe);
-    }
-    else
-    {
-        /* Grab an unused IOTLB entry from the pre-allocated list. */
-        PIOTLBE pIotlbe = &pThisR3->paIotlbes[pThisR3->idxUnusedIotlbe];
-        ++pThisR3->idxUnusedIotlbe;
-
-        /* Initialize and insert the IOTLB entry into the cache. */
-        iommuAmdIotlbEntryInsert(pThis, pThisR3, pIotlbe, idDomain, uIovaPage, pPageLookup);
-
-        /* Add the entry to the most recently used slot. */
-        RTListAppend(&pThisR3->LstLruIotlbe, &pIotlbe->NdLru);
-    }
+    Assert(pIotlbe->uKey != IOMMU_IOTLB_KEY_NIL);
+    pIotlbe->uKey = IOMMU_IOTLB_KEY_NIL;
+    RT_ZERO(pIotlbe->PageLookup);
+    Assert(pThis->cCachedIotlbes > 0);
+    --pThis->cCachedIotlbes;
+    STAM_COUNTER_DEC(&pThis->StatIotlbeCached);
 }
 
 
+# ifdef IN_RING3
 /**
  * Removes all IOTLB entries from the cache.
  *
@@ -1360,16 +1149,13 @@ static void iommuAmdIotlbAdd(PIOMMU pThis, PIOMMUR3 pThisR3, uint16_t idDomain,
  */
 static void iommuAmdIotlbRemoveAll(PPDMDEVINS pDevIns)
 {
-    PIOMMU   pThis   = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
-    PIOMMUR3 pThisR3 = PDMDEVINS_2_DATA_CC(pDevIns, PIOMMUR3);
+    PIOMMU pThis = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
     IOMMU_CACHE_LOCK(pDevIns, pThis);
 
-    if (pThisR3->cCachedIotlbes > 0)
+    if (pThis->cCachedIotlbes > 0)
     {
-        RTAvlU64Destroy(&pThisR3->TreeIotlbe, iommuAmdIotlbEntryDestroy, NULL /* pvParam */);
-        RTListInit(&pThisR3->LstLruIotlbe);
-        pThisR3->idxUnusedIotlbe = 0;
-        pThisR3->cCachedIotlbes  = 0;
+        RT_ZERO(pThis->aIotlbes);
+        pThis->cCachedIotlbes = 0;
         STAM_COUNTER_RESET(&pThis->StatIotlbeCached);
     }
 
@@ -1393,19 +1179,21 @@ static void iommuAmdIotlbRemoveRange(PPDMDEVINS pDevIns, uint16_t idDomain, uint
     Assert(!(cbInvalidate & X86_PAGE_4K_OFFSET_MASK));
     Assert(cbInvalidate >= X86_PAGE_4K_SIZE);
 
-    PIOMMU   pThis   = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
-    PIOMMUR3 pThisR3 = PDMDEVINS_2_DATA_CC(pDevIns, PIOMMUR3);
+    PIOMMU pThis = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
     IOMMU_CACHE_LOCK(pDevIns, pThis);
 
-    do
+    /* The cache is small, checking every entry beats probing each page of large ranges. */
+    uint64_t const uIovaLast = uIova + (cbInvalidate - 1);
+    for (uint32_t i = 0; i < RT_ELEMENTS(pThis->aIotlbes) && pThis->cCachedIotlbes > 0; i++)
     {
-        uint64_t const uKey = IOMMU_IOTLB_KEY_MAKE(idDomain, uIova);
-        PIOTLBE pIotlbe = iommuAmdIotlbEntryRemove(pThis, pThisR3, uKey);
-        if (pIotlbe)
-            iommuAmdIotlbEntryMoveToLru(pThisR3, pIotlbe);
-        uIova        += X86_PAGE_4K_SIZE;
-        cbInvalidate -= X86_PAGE_4K_SIZE;
-    } while (cbInvalidate > 0);
+        PIOTLBE        pIotlbe = &pThis->aIotlbes[i];
+        uint64_t const uKey    = pIotlbe->uKey;
+        if (   uKey != IOMMU_IOTLB_KEY_NIL
+            && IOMMU_IOTLB_KEY_GET_DOMAIN_ID(uKey) == idDomain
+            && IOMMU_IOTLB_KEY_GET_IOVA(uKey) >= uIova
+            && IOMMU_IOTLB_KEY_GET_IOVA(uKey) <= uIovaLast)
+            iommuAmdIotlbEntryRemove(pThis, pIotlbe);
+    }
 
     IOMMU_CACHE_UNLOCK(pDevIns, pThis);
 }
@@ -1419,23 +1207,20 @@ static void iommuAmdIotlbRemoveRange(PPDMDEVINS pDevIns, uint16_t idDomain, uint
  */
 static void iommuAmdIotlbRemoveDomainId(PPDMDEVINS pDevIns, uint16_t idDomain)
 {
-    /*
-     * We need to iterate the tree and search based on the domain ID.
-     * But it seems we cannot remove items while iterating the tree.
-     * Thus, we simply mark entries for eviction later but move them to the LRU
-     * so they will eventually get evicted and re-cycled as the cache gets re-populated.
-     */
-    PIOMMU   pThis   = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
-    PIOMMUR3 pThisR3 = PDMDEVINS_2_DATA_CC(pDevIns, PIOMMUR3);
+    PIOMMU pThis = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
     IOMMU_CACHE_LOCK(pDevIns, pThis);
 
-    IOTLBEFLUSHARG Args;
-    Args.pIommuR3 = pThisR3;
-    Args.idDomain = idDomain;
-    RTAvlU64DoWithAll(&pThisR3->TreeIotlbe, true /* fFromLeft */, iommuAmdIotlbEntryRemoveDomainId, &Args);
+    for (uint32_t i = 0; i < RT_ELEMENTS(pThis->aIotlbes) && pThis->cCachedIotlbes > 0; i++)
+    {
+        PIOTLBE pIotlbe = &pThis->aIotlbes[i];
+        if (   pIotlbe->uKey != IOMMU_IOTLB_KEY_NIL
+            && IOMMU_IOTLB_KEY_GET_DOMAIN_ID(pIotlbe->uKey) == idDomain)
+            iommuAmdIotlbEntryRemove(pThis, pIotlbe);
+    }
 
     IOMMU_CACHE_UNLOCK(pDevIns, pThis);
 }
+# endif /* IN_RING3 */
 
 
 /**
@@ -1455,8 +1240,7 @@ static void iommuAmdIotlbAddRange(PPDMDEVINS pDevIns, uint16_t idDomain, uint64_
 {
     Assert(!(uIovaPage & X86_PAGE_4K_OFFSET_MASK));
 
-    PIOMMU   pThis   = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
-    PIOMMUR3 pThisR3 = PDMDEVINS_2_DATA_CC(pDevIns, PIOMMUR3);
+    PIOMMU pThis = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
 
     IOPAGELOOKUP PageLookup;
     PageLookup.GCPhysSpa = pAddrOut->GCPhysSpa & X86_PAGE_4K_BASE_MASK;
@@ -1479,7 +1263,7 @@ static void iommuAmdIotlbAddRange(PPDMDEVINS pDevIns, uint16_t idDomain, uint64_
      */
     while (cPages > 0)
     {
-        iommuAmdIotlbAdd(pThis, pThisR3, idDomain, uIovaPage, &PageLookup);
+        iommuAmdIotlbAdd(pThis, idDomain, uIovaPage, &PageLookup);
         uIovaPage            += X86_PAGE_4K_SIZE;
         PageLookup.GCPhysSpa += X86_PAGE_4K_SIZE;
         --cPages;
@@ -4194,11 +3978,10 @@ static DECLCALLBACK(int) iommuAmdCacheLookupPage(PPDMDEVINS pDevIns, uint64_t uI
     Assert(pPageLookup);
     Assert(!(uIovaPage & X86_PAGE_4K_OFFSET_MASK));
 
-    PIOMMU   pThis   = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
-    PIOMMUR3 pThisR3 = PDMDEVINS_2_DATA_CC(pDevIns, PIOMMUR3);
+    PIOMMU pThis = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
 
     STAM_PROFILE_ADV_START(&pThis->StatProfIotlbeLookup, a);
-    PCIOTLBE pIotlbe = iommuAmdIotlbLookup(pThis, pThisR3, pAux->idDomain, uIovaPage);
+    PCIOTLBE pIotlbe = iommuAmdIotlbLookup(pThis, pAux->idDomain, uIovaPage);
     STAM_PROFILE_ADV_STOP(&pThis->StatProfIotlbeLookup, a);
     if (pIotlbe)
     {
@@ -6145,15 +5928,24 @@ static DECLCALLBACK(void) iommuAmdR3DbgInfoIotlb(PPDMDEVINS pDevIns, PCDBGFINFOH
         if (RT_SUCCESS(rc))
         {
             pHlp->pfnPrintf(pHlp, "IOTLBEs for domain %u (%#x):\n", idDomain, idDomain);
-            PIOMMU   pThis   = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
-            PIOMMUR3 pThisR3 = PDMDEVINS_2_DATA_CC(pDevIns, PIOMMUR3);
-            IOTLBEINFOARG Args;
-            Args.pIommuR3 = pThisR3;
-            Args.pHlp     = pHlp;
-            Args.idDomain = idDomain;
-
+            PIOMMU pThis = PDMDEVINS_2_DATA(pDevIns, PIOMMU);
             IOMMU_CACHE_LOCK(pDevIns, pThis);
-            RTAvlU64DoWithAll(&pThisR3->TreeIotlbe, true /* fFromLeft */, iommuAmdR3IotlbEntryInfo, &Args);
+            for (uint32_t i = 0; i < RT_ELEMENTS(pThis->aIotlbes); i++)
+            {
+                PCIOTLBE pIotlbe = &pThis->aIotlbes[i];
+                if (   pIotlbe->uKey != IOMMU_IOTLB_KEY_NIL
+                    && IOMMU_IOTLB_KEY_GET_DOMAIN_ID(pIotlbe->uKey) == idDomain)
+                {
+                    uint8_t const fPerm = pIotlbe->PageLookup.fPerm;
+                    pHlp->pfnPrintf(pHlp, " Entry[%u] (set %u)\n",   i, i / IOMMU_IOTLB_WAYS);
+                    pHlp->pfnPrintf(pHlp, "  Key           = %#RX64 (%#RX64)\n", pIotlbe->uKey,
+                                    IOMMU_IOTLB_KEY_GET_IOVA(pIotlbe->uKey));
+                    pHlp->pfnPrintf(pHlp, "  GCPhys        = %#RGp\n", pIotlbe->PageLookup.GCPhysSpa);
+                    pHlp->pfnPrintf(pHlp, "  cShift        = %u (%RU64 bytes)\n", pIotlbe->PageLookup.cShift,
+                                    RT_BIT_64(pIotlbe->PageLookup.cShift));
+                    pHlp->pfnPrintf(pHlp, "  fPerm         = %#x (%s)\n", fPerm, iommuAmdMemAccessGetPermName(fPerm));
+                }
+            }
             IOMMU_CACHE_UNLOCK(pDevIns, pThis);
         }
         else
@@ -6861,15 +6653,6 @@ static DECLCALLBACK(int) iommuAmdR3Destruct(PPDMDEVINS pDevIns)
         pThis->hEvtCmdThread = NIL_SUPSEMEVENT;
     }
 
-#ifdef IOMMU_WITH_IOTLBE_CACHE
-    if (pThisR3->paIotlbes)
-    {
-        PDMDevHlpMMHeapFree(pDevIns, pThisR3->paIotlbes);
-        pThisR3->paIotlbes = NULL;
-        pThisR3->idxUnusedIotlbe = 0;
-    }
-#endif
-
     IOMMU_UNLOCK(pDevIns, pThisR3);
     return VINF_SUCCESS;
 }
@@ -7112,7 +6895,7 @@ static DECLCALLBACK(int) iommuAmdR3Construct(PPDMDEVINS pDevIns, int iInstance,
 
 
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIotlbeCached, STAMTYPE_COUNTER, "IOTLB/Cached", STAMUNIT_OCCURENCES, "Number of IOTLB entries in the cache.");
-    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIotlbeLazyEvictReuse, STAMTYPE_COUNTER, "IOTLB/LazyEvictReuse", STAMUNIT_OCCURENCES, "Number of IOTLB entries reused after lazy eviction.");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIotlbeEvicted, STAMTYPE_COUNTER, "IOTLB/Evicted", STAMUNIT_OCCURENCES, "Number of valid IOTLB entries evicted to make room.");
 
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatProfDteLookup, STAMTYPE_PROFILE, "Profile/DteLookup", STAMUNIT_TICKS_PER_CALL, "Profiling DTE lookup.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatProfIotlbeLookup, STAMTYPE_PROFILE, "Profile/IotlbeLookup", STAMUNIT_TICKS_PER_CALL, "Profiling IOTLBE lookup.");
@@ -7159,23 +6942,6 @@ static DECLCALLBACK(int) iommuAmdR3Construct(PPDMDEVINS pDevIns, int iInstance,
     AssertCompile(RT_ELEMENTS(pThis->aDeviceIds) == RT_ELEMENTS(pThis->aDteCache));
 #endif
 
-#ifdef IOMMU_WITH_IOTLBE_CACHE
-    /*
-     * Allocate IOTLB entries.
-     * This is allocated upfront since we expect a relatively small number of entries,
-     * is more cache-line efficient and easier to track least recently used entries for
-     * eviction when the cache is full. This also avoids unpredictable behavior during
-     * the lifetime of the VM if the hyperheap gets full.
-     */
-    size_t const cbIotlbes = sizeof(IOTLBE) * IOMMU_IOTLBE_MAX;
-    pThisR3->paIotlbes = (PIOTLBE)PDMDevHlpMMHeapAllocZ(pDevIns, cbIotlbes);
-    if (!pThisR3->paIotlbes)
-        return PDMDevHlpVMSetError(pDevIns, VERR_NO_MEMORY, RT_SRC_POS,
-                                   N_("Failed to allocate %zu bytes from the hyperheap for the IOTLB cache."), cbIotlbes);
-    RTListInit(&pThisR3->LstLruIotlbe);
-    LogRel(("%s: Allocated %zu bytes from the hyperheap for the IOTLB cache\n", IOMMU_LOG_PFX, cbIotlbes));
-#endif
-
     /*
      * Initialize read-only registers.
      * NOTE! Fields here must match their corresponding field in the ACPI tables.
@@ -99,6 +99,16 @@
         RT_NOREF1(a_pThisCC); \
     } while (0)
 
+/** Acquires the translation-cache lock. */
+#define DMAR_CACHE_LOCK(a_pDevIns, a_pThis) \
+    do { \
+        int const rcLock = PDMDevHlpCritSectEnter((a_pDevIns), &(a_pThis)->CritSectCache, VINF_SUCCESS); \
+        PDM_CRITSECT_RELEASE_ASSERT_RC_DEV((a_pDevIns), &(a_pThis)->CritSectCache, rcLock); \
+    } while (0)
+
+/** Releases the translation-cache lock. */
+#define DMAR_CACHE_UNLOCK(a_pDevIns, a_pThis)       PDMDevHlpCritSectLeave((a_pDevIns), &(a_pThis)->CritSectCache)
+
 /** The number of fault recording registers our implementation supports.
  *  Normal guest operation shouldn't trigger faults anyway, so we only support the
  *  minimum number of registers (which is 1).
@@ -176,6 +186,20 @@ AssertCompile(DMAR_MMIO_OFF_FRCD_HI_REG == DMAR_MMIO_OFF_FRCD_LO_REG + 8);
 /** The current saved state version. */
 #define DMAR_SAVED_STATE_VERSION                    1
 
+/** @name Translation caches.
+ * @{ */
+/** The number of context-cache entries (must be a power of 2). */
+#define DMAR_CTX_CACHE_ENTRIES                      32
+/** The number of sets in the IOTLB (must be a power of 2). */
+#define DMAR_IOTLB_SETS                             32
+/** The number of ways (entries) in each IOTLB set. */
+#define DMAR_IOTLB_WAYS                             4
+/** The total number of IOTLB entries. */
+#define DMAR_IOTLBE_MAX                             (DMAR_IOTLB_SETS * DMAR_IOTLB_WAYS)
+/** Gets the IOTLB set index for the given domain ID and DMA page number. */
+#define DMAR_IOTLB_GET_SET(a_idDomain, a_uIovaPage) ((uint32_t)((a_uIovaPage) ^ (a_idDomain)) & (DMAR_IOTLB_SETS - 1))
+/** @} */
+
 
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
@@ -223,6 +247,10 @@ typedef enum
     kDmarDiag_CcmdReg_Qi_Enabled,
     kDmarDiag_CcmdReg_Ttm_Invalid,
 
+    /* IOTLB_REG faults. */
+    kDmarDiag_IotlbReg_Not_Supported,
+    kDmarDiag_IotlbReg_Qi_Enabled,
+
     /* IQA_REG faults. */
     kDmarDiag_IqaReg_Dsc_Fetch_Error,
     kDmarDiag_IqaReg_Dw_128_Invalid,
@@ -300,6 +328,10 @@ static const char *const g_apszDmarDiagDesc[] =
     DMARDIAG_DESC(CcmdReg_Qi_Enabled         ),
     DMARDIAG_DESC(CcmdReg_Ttm_Invalid        ),
 
+    /* IOTLB_REG faults. */
+    DMARDIAG_DESC(IotlbReg_Not_Supported     ),
+    DMARDIAG_DESC(IotlbReg_Qi_Enabled        ),
+
     /* IQA_REG faults. */
     DMARDIAG_DESC(IqaReg_Dsc_Fetch_Error     ),
     DMARDIAG_DESC(IqaReg_Dw_128_Invalid      ),
@@ -333,6 +365,62 @@ AssertCompile(RT_ELEMENTS(g_apszDmarDiagDesc) == kDmarDiag_End);
 # undef DMARDIAG_DESC
 #endif /* IN_RING3 */
 
+/**
+ * Context-cache entry.
+ *
+ * Caches the parts of a legacy-mode root and context entry needed to translate
+ * DMA requests from a device without reading the tables from guest memory.
+ */
+typedef struct DMARCTXCACHEENTRY
+{
+    /** The second-level page-table pointer (SLPTPTR). */
+    RTGCPHYS                    GCPhysSlPt;
+    /** The source ID (bus, device, function) of the device. */
+    uint16_t                    idDevice;
+    /** The domain ID (DID). */
+    uint16_t                    idDomain;
+    /** The translation type (VTD_TT_XXX). */
+    uint8_t                     fTt;
+    /** The paging level of the translation. */
+    uint8_t                     cPagingLevel;
+    /** The fault processing disabled (FPD) bit. */
+    uint8_t                     fFpd;
+    /** Whether this entry is valid. */
+    bool                        fValid;
+} DMARCTXCACHEENTRY;
+AssertCompileSize(DMARCTXCACHEENTRY, 16);
+/** Pointer to a context-cache entry. */
+typedef DMARCTXCACHEENTRY *PDMARCTXCACHEENTRY;
+/** Pointer to a const context-cache entry. */
+typedef DMARCTXCACHEENTRY const *PCDMARCTXCACHEENTRY;
+
+/**
+ * IOTLB entry.
+ *
+ * Caches the result of a second-level translation of a 4K DMA page. An entry
+ * with a zero page shift is unused.
+ */
+typedef struct DMARIOTLBE
+{
+    /** The DMA page number (DMA address >> X86_PAGE_4K_SHIFT). */
+    uint64_t                    uIovaPage;
+    /** The translated base address of the page. */
+    RTGCPHYS                    GCPhysBase;
+    /** The value of the LRU clock when this entry was last used. */
+    uint32_t                    uLastUsed;
+    /** The domain ID (DID). */
+    uint16_t                    idDomain;
+    /** The page shift of the translation, 0 if this entry is unused. */
+    uint8_t                     cShift;
+    /** The effective permissions of the page (DMAR_PERM_XXX). */
+    uint8_t                     fPerm;
+} DMARIOTLBE;
+AssertCompileSize(DMARIOTLBE, 24);
+/** Pointer to an IOTLB entry. */
+typedef DMARIOTLBE *PDMARIOTLBE;
+/** Pointer to a const IOTLB entry. */
+typedef DMARIOTLBE const *PCDMARIOTLBE;
+
 /**
  * The shared DMAR device state.
  */
@@ -394,6 +482,22 @@ typedef struct DMAR
     /** The MMIO handle. */
     IOMMMIOHANDLE               hMmio;
 
+    /** @name Translation caches.
+     * These are used in all contexts and are protected by CritSectCache.
+     * @{ */
+    /** The critical section protecting the translation caches. */
+    PDMCRITSECT                 CritSectCache;
+    /** The context cache, indexed by the low bits of the source ID. */
+    DMARCTXCACHEENTRY           aCtxCache[DMAR_CTX_CACHE_ENTRIES];
+    /** The IOTLB, DMAR_IOTLB_WAYS consecutive entries per set. */
+    DMARIOTLBE                  aIotlbes[DMAR_IOTLBE_MAX];
+    /** The LRU clock used for replacing IOTLB entries. */
+    uint32_t                    uIotlbLruClock;
+    /** The invalidation generation, incremented whenever cache entries are
+     *  invalidated so a concurrent table walk doesn't add a stale entry. */
+    uint32_t volatile           uCacheGen;
+    /** @} */
+
 #ifdef VBOX_WITH_STATISTICS
     STAMCOUNTER                 StatMmioReadR3;         /**< Number of MMIO reads in R3. */
     STAMCOUNTER                 StatMmioReadRZ;         /**< Number of MMIO reads in RZ. */
@@ -423,6 +527,12 @@ typedef struct DMAR
     STAMCOUNTER                 StatPasidIotlbInvDsc;   /**< Number of PASID-based IOTLB descriptors processed. */
     STAMCOUNTER                 StatPasidCacheInvDsc;   /**< Number of PASID-cache descriptors processed. */
     STAMCOUNTER                 StatPasidDevtlbInvDsc;  /**< Number of PASID-based device-TLB descriptors processed. */
+
+    STAMCOUNTER                 StatCtxCacheHit;        /**< Number of context-cache hits. */
+    STAMCOUNTER                 StatCtxCacheMiss;       /**< Number of context-cache misses. */
+    STAMCOUNTER                 StatIotlbHit;           /**< Number of IOTLB hits. */
+    STAMCOUNTER                 StatIotlbMiss;          /**< Number of IOTLB misses. */
+    STAMCOUNTER                 StatIotlbEvicted;       /**< Number of IOTLB entries evicted to make room. */
 #endif
 } DMAR;
 /** Pointer to the DMAR device state. */
@@ -431,6 +541,8 @@ typedef DMAR *PDMAR;
 typedef DMAR const *PCDMAR;
 AssertCompileMemberAlignment(DMAR, abRegs0, 8);
 AssertCompileMemberAlignment(DMAR, abRegs1, 8);
+AssertCompileMemberAlignment(DMAR, CritSectCache, 8);
+AssertCompileMemberAlignment(DMAR, aIotlbes, 8);
 
 /**
  * The ring-3 DMAR device state.
@@ -579,7 +691,10 @@ typedef struct DMARMEMREQAUX
     uint8_t             fFpd;
     /** The paging level of the translation. */
     uint8_t             cPagingLevel;
-    uint8_t             abPadding[5];
+    uint8_t             bPadding;
+    /** The domain ID of the translation (used for tagging IOTLB entries). */
+    uint16_t            idDomain;
+    uint8_t             abPadding[2];
     /** The address of the first-level page-table.  */
     uint64_t            GCPhysFlPt;
     /** The address of second-level page-table.  */
@@ -1727,6 +1842,205 @@ static void dmarIqeFaultRecord(PPDMDEVINS pDevIns, DMARDIAG enmDiag, VTDIQEI enm
 }
 
 
+/**
+ * Looks up the context cache for the given device.
+ *
+ * @returns Pointer to the context-cache entry if found, NULL otherwise.
+ * @param   pThis       The shared DMAR device state.
+ * @param   idDevice    The device ID (bus, device, function).
+ *
+ * @remarks Caller must hold the cache lock.
+ */
+static PCDMARCTXCACHEENTRY dmarCtxCacheLookup(PCDMAR pThis, uint16_t idDevice)
+{
+    PCDMARCTXCACHEENTRY pEntry = &pThis->aCtxCache[idDevice & (DMAR_CTX_CACHE_ENTRIES - 1)];
+    if (   pEntry->fValid
+        && pEntry->idDevice == idDevice)
+        return pEntry;
+    return NULL;
+}
+
+
+/**
+ * Adds or updates the context-cache entry for the given device.
+ *
+ * @param   pThis           The shared DMAR device state.
+ * @param   idDevice        The device ID (bus, device, function).
+ * @param   idDomain        The domain ID.
+ * @param   fTt             The translation type (VTD_TT_XXX).
+ * @param   pMemReqAux      The DMA memory request auxiliary info (paging level,
+ *                          SLPTPTR and FPD bit).
+ *
+ * @remarks Caller must hold the cache lock.
+ */
+static void dmarCtxCacheAdd(PDMAR pThis, uint16_t idDevice, uint16_t idDomain, uint8_t fTt, PCDMARMEMREQAUX pMemReqAux)
+{
+    PDMARCTXCACHEENTRY pEntry = &pThis->aCtxCache[idDevice & (DMAR_CTX_CACHE_ENTRIES - 1)];
+    pEntry->GCPhysSlPt   = pMemReqAux->GCPhysSlPt;
+    pEntry->idDevice     = idDevice;
+    pEntry->idDomain     = idDomain;
+    pEntry->fTt          = fTt;
+    pEntry->cPagingLevel = pMemReqAux->cPagingLevel;
+    pEntry->fFpd         = pMemReqAux->fFpd;
+    pEntry->fValid       = true;
+}
+
+
+/**
+ * Removes context-cache entries.
+ *
+ * @param   pDevIns         The IOMMU device instance.
+ * @param   fGranularity    The invalidation granularity, i.e. 1 for global, 2 for
+ *                          domain-selective and 3 for device-selective.
+ * @param   idDomain        The domain ID (ignored for global invalidations).
+ * @param   idDevice        The device ID (only used for device-selective
+ *                          invalidations).
+ */
+static void dmarCtxCacheRemove(PPDMDEVINS pDevIns, uint8_t fGranularity, uint16_t idDomain, uint16_t idDevice)
+{
+    PDMAR pThis = PDMDEVINS_2_DATA(pDevIns, PDMAR);
+    DMAR_CACHE_LOCK(pDevIns, pThis);
+    for (uint32_t i = 0; i < RT_ELEMENTS(pThis->aCtxCache); i++)
+    {
+        PDMARCTXCACHEENTRY pEntry = &pThis->aCtxCache[i];
+        if (   fGranularity == 1
+            || (fGranularity == 2 && pEntry->idDomain == idDomain)
+            || (fGranularity == 3 && pEntry->idDomain == idDomain && pEntry->idDevice == idDevice))
+            pEntry->fValid = false;
+    }
+    ASMAtomicIncU32(&pThis->uCacheGen);
+    DMAR_CACHE_UNLOCK(pDevIns, pThis);
+}
+
+
+/**
+ * Looks up the IOTLB for the given domain and DMA page.
+ *
+ * @returns Pointer to the IOTLB entry if found, NULL otherwise.
+ * @param   pThis       The shared DMAR device state.
+ * @param   idDomain    The domain ID.
+ * @param   uIovaPage   The DMA page number.
+ *
+ * @remarks Caller must hold the cache lock.
+ */
+static PDMARIOTLBE dmarIotlbLookup(PDMAR pThis, uint16_t idDomain, uint64_t uIovaPage)
+{
+    PDMARIOTLBE paSet = &pThis->aIotlbes[DMAR_IOTLB_GET_SET(idDomain, uIovaPage) * DMAR_IOTLB_WAYS];
+    for (uint32_t idxWay = 0; idxWay < DMAR_IOTLB_WAYS; idxWay++)
+    {
+        PDMARIOTLBE pIotlbe = &paSet[idxWay];
+        if (   pIotlbe->uIovaPage == uIovaPage
+            && pIotlbe->idDomain  == idDomain
+            && pIotlbe->cShift)
+        {
+            pIotlbe->uLastUsed = ++pThis->uIotlbLruClock;
+            return pIotlbe;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * Adds an IOTLB entry, replacing the least recently used entry in its set if
+ * necessary.
+ *
+ * @param   pThis       The shared DMAR device state.
+ * @param   idDomain    The domain ID.
+ * @param   uIovaPage   The DMA page number.
+ * @param   pIoPage     The result of the translation.
+ *
+ * @remarks Caller must hold the cache lock.
+ */
+static void dmarIotlbAdd(PDMAR pThis, uint16_t idDomain, uint64_t uIovaPage, PCDMARIOPAGE pIoPage)
+{
+    PDMARIOTLBE paSet   = &pThis->aIotlbes[DMAR_IOTLB_GET_SET(idDomain, uIovaPage) * DMAR_IOTLB_WAYS];
+    PDMARIOTLBE pIotlbe = &paSet[0];
+    for (uint32_t idxWay = 0; idxWay < DMAR_IOTLB_WAYS; idxWay++)
+    {
+        PDMARIOTLBE pCur = &paSet[idxWay];
+        if (   !pCur->cShift
+            || (   pCur->uIovaPage == uIovaPage
+                && pCur->idDomain  == idDomain))
+        {
+            pIotlbe = pCur;
+            break;
+        }
+        if (pCur->uLastUsed < pIotlbe->uLastUsed)
+            pIotlbe = pCur;
+    }
+
+#ifdef VBOX_WITH_STATISTICS
+    if (   pIotlbe->cShift
+        && (   pIotlbe->uIovaPage != uIovaPage
+            || pIotlbe->idDomain  != idDomain))
+        STAM_COUNTER_INC(&pThis->StatIotlbEvicted);
+#endif
+
+    pIotlbe->uIovaPage  = uIovaPage;
+    pIotlbe->GCPhysBase = pIoPage->GCPhysBase;
+    pIotlbe->uLastUsed  = ++pThis->uIotlbLruClock;
+    pIotlbe->idDomain   = idDomain;
+    pIotlbe->cShift     = pIoPage->cShift;
+    pIotlbe->fPerm      = pIoPage->fPerm;
+}
+
+
+/**
+ * Removes IOTLB entries.
+ *
+ * Page-selective invalidations remove every entry of a large page mapping
+ * overlapping the range, as entries are keyed by the 4K page that was looked
+ * up rather than by the base of the mapping.
+ *
+ * @param   pDevIns         The IOMMU device instance.
+ * @param   fGranularity    The invalidation granularity, i.e. 1 for global, 2 for
+ *                          domain-selective and 3 for page-selective.
+ * @param   idDomain        The domain ID (ignored for global invalidations).
+ * @param   uIovaPage       The first DMA page number (only used for
+ *                          page-selective invalidations).
+ * @param   cPages          The number of pages (only used for page-selective
+ *                          invalidations).
+ */
+static void dmarIotlbRemove(PPDMDEVINS pDevIns, uint8_t fGranularity, uint16_t idDomain, uint64_t uIovaPage, uint64_t cPages)
+{
+    PDMAR pThis = PDMDEVINS_2_DATA(pDevIns, PDMAR);
+    DMAR_CACHE_LOCK(pDevIns, pThis);
+    for (uint32_t i = 0; i < RT_ELEMENTS(pThis->aIotlbes); i++)
+    {
+        PDMARIOTLBE pIotlbe = &pThis->aIotlbes[i];
+        if (!pIotlbe->cShift)
+            continue;
+        if (   fGranularity == 1
+            || (fGranularity == 2 && pIotlbe->idDomain == idDomain))
+            pIotlbe->cShift = 0;
+        else if (fGranularity == 3 && pIotlbe->idDomain == idDomain)
+        {
+            Assert(pIotlbe->cShift >= X86_PAGE_4K_SHIFT);
+            uint64_t const cMapPages  = RT_BIT_64(pIotlbe->cShift - X86_PAGE_4K_SHIFT);
+            uint64_t const uFirstPage = pIotlbe->uIovaPage & ~(cMapPages - 1);
+            if (   uFirstPage < uIovaPage + cPages
+                && uIovaPage   < uFirstPage + cMapPages)
+                pIotlbe->cShift = 0;
+        }
+    }
+    ASMAtomicIncU32(&pThis->uCacheGen);
+    DMAR_CACHE_UNLOCK(pDevIns, pThis);
+}
+
+
+/**
+ * Removes all entries from the context cache and the IOTLB.
+ *
+ * @param   pDevIns     The IOMMU device instance.
+ */
+static void dmarCacheRemoveAll(PPDMDEVINS pDevIns)
+{
+    dmarCtxCacheRemove(pDevIns, 1 /* fGranularity: global */, 0 /* idDomain */, 0 /* idDevice */);
+    dmarIotlbRemove(pDevIns, 1 /* fGranularity: global */, 0 /* idDomain */, 0 /* uIovaPage */, 0 /* cPages */);
+}
+
+
 /**
  * Handles writes to GCMD_REG.
  *
@@ -1790,15 +2104,16 @@ static VBOXSTRICTRC dmarGcmdRegWrite(PPDMDEVINS pDevIns, uint32_t uGcmdReg)
     /* Set Root Table Pointer (SRTP). */
     if (uGcmdReg & VTD_BF_GCMD_REG_SRTP_MASK)
     {
-        /** @todo Perform global invalidation of all remapping translation caches when
-         *        ESRTPS is supported. */
+        /* Cached translations may have been derived from the previous root table. */
         pThis->uRtaddrReg = dmarRegReadRaw64(pThis, VTD_MMIO_OFF_RTADDR_REG);
+        dmarCacheRemoveAll(pDevIns);
         dmarRegChangeRaw32(pThis, VTD_MMIO_OFF_GSTS_REG, UINT32_MAX, VTD_BF_GSTS_REG_RTPS_MASK);
     }
 
     /* Translation (DMA remapping). */
     if (fChanged & VTD_BF_GCMD_REG_TE_MASK)
     {
+        dmarCacheRemoveAll(pDevIns);
         if (uGcmdReg & VTD_BF_GCMD_REG_TE_MASK)
             dmarRegChangeRaw32(pThis, VTD_MMIO_OFF_GSTS_REG, UINT32_MAX, VTD_BF_GSTS_REG_TES_MASK);
         else
@@ -1824,10 +2139,12 @@ static VBOXSTRICTRC dmarCcmdRegWrite(PPDMDEVINS pDevIns, uint16_t offReg, uint8_
     if (offReg + cbReg > VTD_MMIO_OFF_CCMD_REG + 4)
     {
         /* Check if we need to invalidate the context-context. */
+        PDMAR pThis = PDMDEVINS_2_DATA(pDevIns, PDMAR);
+        if (cbReg == 4)
+            uCcmdReg = dmarRegReadRaw64(pThis, VTD_MMIO_OFF_CCMD_REG);
         bool const fIcc = RT_BF_GET(uCcmdReg, VTD_BF_CCMD_REG_ICC);
         if (fIcc)
         {
-            PDMAR pThis = PDMDEVINS_2_DATA(pDevIns, PDMAR);
             uint8_t const uMajorVersion = RT_BF_GET(pThis->uVerReg, VTD_BF_VER_REG_MAX);
             if (uMajorVersion < 6)
             {
@@ -1839,7 +2156,14 @@ static VBOXSTRICTRC dmarCcmdRegWrite(PPDMDEVINS pDevIns, uint16_t offReg, uint8_
                     uint8_t const fTtm = RT_BF_GET(pThis->uRtaddrReg, VTD_BF_RTADDR_REG_TTM);
                     if (fTtm == VTD_TTM_LEGACY_MODE)
                     {
-                        /** @todo Invalidate. */
+                        uint8_t const  fCirg    = RT_BF_GET(uCcmdReg, VTD_BF_CCMD_REG_CIRG);
+                        uint16_t const idDomain = RT_BF_GET(uCcmdReg, VTD_BF_CCMD_REG_DID);
+                        uint16_t const idDevice = RT_BF_GET(uCcmdReg, VTD_BF_CCMD_REG_SID);
+                        dmarCtxCacheRemove(pDevIns, fCirg, idDomain, idDevice);
+
+                        /* Report completion with the granularity actually performed. */
+                        dmarRegChangeRaw64(pThis, VTD_MMIO_OFF_CCMD_REG, ~(VTD_BF_CCMD_REG_ICC_MASK | VTD_BF_CCMD_REG_CAIG_MASK),
+                                           RT_BF_MAKE(VTD_BF_CCMD_REG_CAIG, fCirg));
                         return VINF_SUCCESS;
                     }
                     pThis->enmDiag = kDmarDiag_CcmdReg_Ttm_Invalid;
@@ -1849,7 +2173,85 @@ static VBOXSTRICTRC dmarCcmdRegWrite(PPDMDEVINS pDevIns, uint16_t offReg, uint8_
             }
             else
                 pThis->enmDiag = kDmarDiag_CcmdReg_Not_Supported;
-            dmarRegChangeRaw64(pThis, VTD_MMIO_OFF_GSTS_REG, ~VTD_BF_CCMD_REG_CAIG_MASK, 0 /* fOrMask */);
+            dmarRegChangeRaw64(pThis, VTD_MMIO_OFF_CCMD_REG, ~(VTD_BF_CCMD_REG_ICC_MASK | VTD_BF_CCMD_REG_CAIG_MASK),
+                               0 /* fOrMask */);
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Handles writes to IOTLB_REG.
+ *
+ * Does the register-based IOTLB invalidation described by IOTLB_REG and
+ * IVA_REG.  The invalidation hint (IH) is ignored, as only leaf translations
+ * are cached.
+ *
+ * @returns Strict VBox status code.
+ * @param   pDevIns     The IOMMU device instance.
+ * @param   offReg      The MMIO register offset.
+ * @param   cbReg       The size of the MMIO access (in bytes).
+ */
+static VBOXSTRICTRC dmarIotlbRegWrite(PPDMDEVINS pDevIns, uint16_t offReg, uint8_t cbReg)
+{
+    /* Only the high 32-bits holds the IVT bit, the low 32-bits are reserved. */
+    if (offReg + cbReg > DMAR_MMIO_OFF_IOTLB_REG + 4)
+    {
+        PDMAR pThis = PDMDEVINS_2_DATA(pDevIns, PDMAR);
+        uint64_t const uIotlbReg = dmarRegReadRaw64(pThis, DMAR_MMIO_OFF_IOTLB_REG);
+        bool const fIvt = RT_BF_GET(uIotlbReg, VTD_BF_IOTLB_REG_IVT);
+        if (fIvt)
+        {
+            uint8_t fIaig = 0;
+            uint8_t const uMajorVersion = RT_BF_GET(pThis->uVerReg, VTD_BF_VER_REG_MAX);
+            if (uMajorVersion < 6)
+            {
+                /* Register-based invalidation can only be used when queued-invalidations are not enabled. */
+                uint32_t const uGstsReg = dmarRegReadRaw32(pThis, VTD_MMIO_OFF_GSTS_REG);
+                if (!(uGstsReg & VTD_BF_GSTS_REG_QIES_MASK))
+                {
+                    uint8_t const  fIirg    = RT_BF_GET(uIotlbReg, VTD_BF_IOTLB_REG_IIRG);
+                    uint16_t const idDomain = RT_BF_GET(uIotlbReg, VTD_BF_IOTLB_REG_DID);
+                    uint64_t const uIvaReg  = dmarRegReadRaw64(pThis, DMAR_MMIO_OFF_IVA_REG);
+                    uint8_t const  cAddrMask = RT_BF_GET(uIvaReg, VTD_BF_IVA_REG_AM);
+                    uint8_t const  cMaxMask  = RT_BF_GET(pThis->fCapReg, VTD_BF_CAP_REG_MAMV);
+                    switch (fIirg)
+                    {
+                        case 1:     /* Global. */
+                        case 2:     /* Domain-selective. */
+                            dmarIotlbRemove(pDevIns, fIirg, idDomain, 0 /* uIovaPage */, 0 /* cPages */);
+                            fIaig = fIirg;
+                            break;
+
+                        case 3:     /* Page-selective, done domain-selective if the address mask is out of range. */
+                            if (cAddrMask <= cMaxMask)
+                            {
+                                uint64_t const cPages    = RT_BIT_64(cAddrMask);
+                                uint64_t const uIovaPage = (uIvaReg >> X86_PAGE_4K_SHIFT) & ~(cPages - 1);
+                                dmarIotlbRemove(pDevIns, 3 /* fGranularity */, idDomain, uIovaPage, cPages);
+                                fIaig = 3;
+                            }
+                            else
+                            {
+                                dmarIotlbRemove(pDevIns, 2 /* fGranularity */, idDomain, 0 /* uIovaPage */, 0 /* cPages */);
+                                fIaig = 2;
+                            }
+                            break;
+
+                        default:    /* Reserved, nothing is invalidated and IAIG reports that. */
+                            break;
+                    }
+                }
+                else
+                    pThis->enmDiag = kDmarDiag_IotlbReg_Qi_Enabled;
+            }
+            else
+                pThis->enmDiag = kDmarDiag_IotlbReg_Not_Supported;
+
+            /* Report completion with the granularity actually performed (0 if none). */
+            dmarRegChangeRaw64(pThis, DMAR_MMIO_OFF_IOTLB_REG, ~(VTD_BF_IOTLB_REG_IVT_MASK | VTD_BF_IOTLB_REG_IAIG_MASK),
+                               RT_BF_MAKE(VTD_BF_IOTLB_REG_IAIG, fIaig));
         }
     }
     return VINF_SUCCESS;
@@ -2221,7 +2623,8 @@ static DECLCALLBACK(int) dmarDrSecondLevelTranslate(PPDMDEVINS pDevIns, PCDMARME
      */
     if (pMemReqAux->cPagingLevel > 0)
     {
-        uint64_t     uPtEntity = pMemReqAux->GCPhysSlPt;
+        uint8_t      fPtPermEff = pThis->fPermValidMask;
+        uint64_t     uPtEntity  = pMemReqAux->GCPhysSlPt;
         for (uint8_t idxLevel  = pMemReqAux->cPagingLevel - 1; /* not needed: idxLevel >= 0 */; idxLevel--)
         {
             /*
@@ -2278,6 +2681,9 @@ static DECLCALLBACK(int) dmarDrSecondLevelTranslate(PPDMDEVINS pDevIns, PCDMARME
                 break;
             }
 
+            /* Accumulate the permissions granted by all levels walked so far (used for caching the translation). */
+            fPtPermEff &= fPtPerm;
+
             /*
              * Check if this is a 1GB page or a 2MB page.
              */
@@ -2297,7 +2703,7 @@ static DECLCALLBACK(int) dmarDrSecondLevelTranslate(PPDMDEVINS pDevIns, PCDMARME
                     Assert(!(pThis->fExtCapReg & VTD_BF_ECAP_REG_MTS_MASK));
 
                     RTGCPHYS const GCPhysBase = uPtEntity & X86_GET_PAGE_BASE_MASK(cLevelShift);
-                    return dmarDrUpdateIoPageOut(pDevIns, GCPhysBase, cLevelShift, fPtPerm, pMemReqIn, pMemReqAux, pIoPageOut);
+                    return dmarDrUpdateIoPageOut(pDevIns, GCPhysBase, cLevelShift, fPtPermEff, pMemReqIn, pMemReqAux, pIoPageOut);
                 }
 
                 dmarAtFaultRecord(pDevIns, kDmarDiag_At_Xm_Pte_Sllps_Invalid, pMemReqIn, pMemReqAux);
@@ -2310,7 +2716,7 @@ static DECLCALLBACK(int) dmarDrSecondLevelTranslate(PPDMDEVINS pDevIns, PCDMARME
             if (idxLevel == 0)
             {
                 RTGCPHYS const GCPhysBase = uPtEntity & X86_GET_PAGE_BASE_MASK(cLevelShift);
-                return dmarDrUpdateIoPageOut(pDevIns, GCPhysBase, cLevelShift, fPtPerm, pMemReqIn, pMemReqAux, pIoPageOut);
+                return dmarDrUpdateIoPageOut(pDevIns, GCPhysBase, cLevelShift, fPtPermEff, pMemReqIn, pMemReqAux, pIoPageOut);
             }
         }
     }
@@ -2319,6 +2725,57 @@ static DECLCALLBACK(int) dmarDrSecondLevelTranslate(PPDMDEVINS pDevIns, PCDMARME
 }
 
 
+/**
+ * Performs second level translation, using the IOTLB when possible.
+ *
+ * This is a DMA address-lookup callback function which consults the IOTLB
+ * before walking the I/O page tables, and caches the result of the walk.
+ *
+ * @returns VBox status code.
+ * @param   pDevIns     The IOMMU device instance.
+ * @param   pMemReqIn   The DMA memory request input.
+ * @param   pMemReqAux  The DMA memory request auxiliary info.
+ * @param   pIoPageOut  Where to store the output of the translation.
+ */
+static DECLCALLBACK(int) dmarDrSecondLevelTranslateCached(PPDMDEVINS pDevIns, PCDMARMEMREQIN pMemReqIn,
+                                                          PCDMARMEMREQAUX pMemReqAux, PDMARIOPAGE pIoPageOut)
+{
+    PDMAR pThis = PDMDEVINS_2_DATA(pDevIns, PDMAR);
+    uint64_t const uIovaPage = pMemReqIn->AddrRange.uAddr >> X86_PAGE_4K_SHIFT;
+    uint8_t const  fReqPerm  = pMemReqIn->AddrRange.fPerm & pThis->fPermValidMask;
+
+    DMAR_CACHE_LOCK(pDevIns, pThis);
+    PCDMARIOTLBE pIotlbe = dmarIotlbLookup(pThis, pMemReqAux->idDomain, uIovaPage);
+    if (   pIotlbe
+        && (pIotlbe->fPerm & fReqPerm) == fReqPerm)
+    {
+        pIoPageOut->GCPhysBase = pIotlbe->GCPhysBase;
+        pIoPageOut->cShift     = pIotlbe->cShift;
+        pIoPageOut->fPerm      = pIotlbe->fPerm;
+        DMAR_CACHE_UNLOCK(pDevIns, pThis);
+        STAM_COUNTER_INC(&pThis->StatIotlbHit);
+        return VINF_SUCCESS;
+    }
+    uint32_t const uCacheGen = pThis->uCacheGen;
+    DMAR_CACHE_UNLOCK(pDevIns, pThis);
+    STAM_COUNTER_INC(&pThis->StatIotlbMiss);
+
+    /*
+     * Walk the page tables without holding the cache lock (faults are recorded under the DMAR lock)
+     * and don't cache the result if an invalidation happened in the meantime.
+     */
+    int const rc = dmarDrSecondLevelTranslate(pDevIns, pMemReqIn, pMemReqAux, pIoPageOut);
+    if (RT_SUCCESS(rc))
+    {
+        DMAR_CACHE_LOCK(pDevIns, pThis);
+        if (pThis->uCacheGen == uCacheGen)
+            dmarIotlbAdd(pThis, pMemReqAux->idDomain, uIovaPage, pIoPageOut);
+        DMAR_CACHE_UNLOCK(pDevIns, pThis);
+    }
+    return rc;
+}
+
+
 /**
  * Looks up the range of addresses for a DMA memory request remapping.
  *
@@ -2417,8 +2874,46 @@ static int dmarDrLegacyModeRemapAddr(PPDMDEVINS pDevIns, uint64_t uRtaddrReg, PD
     PCDMARMEMREQIN pMemReqIn  = &pMemReqRemap->In;
     PDMARMEMREQAUX pMemReqAux = &pMemReqRemap->Aux;
     PDMARMEMREQOUT pMemReqOut = &pMemReqRemap->Out;
+    PDMAR          pThis      = PDMDEVINS_2_DATA(pDevIns, PDMAR);
     Assert(pMemReqAux->fTtm == VTD_TTM_LEGACY_MODE);    /* Paranoia. */
 
+    /*
+     * Check the context cache before reading the root and context entries from guest memory.
+     * Only untranslated requests are cached, anything else takes the slow path so faults are
+     * recorded as usual.
+     */
+    DMAR_CACHE_LOCK(pDevIns, pThis);
+    PCDMARCTXCACHEENTRY pCtxCacheEntry = dmarCtxCacheLookup(pThis, pMemReqIn->idDevice);
+    if (   pCtxCacheEntry
+        && pMemReqIn->enmAddrType == PCIADDRTYPE_UNTRANSLATED)
+    {
+        DMARCTXCACHEENTRY const CtxCacheEntry = *pCtxCacheEntry;
+        DMAR_CACHE_UNLOCK(pDevIns, pThis);
+        STAM_COUNTER_INC(&pThis->StatCtxCacheHit);
+
+        pMemReqOut->idDomain = CtxCacheEntry.idDomain;
+        pMemReqAux->idDomain = CtxCacheEntry.idDomain;
+        pMemReqAux->fFpd     = CtxCacheEntry.fFpd;
+        if (CtxCacheEntry.fTt == VTD_TT_UNTRANSLATED_SLP)
+        {
+            pMemReqAux->cPagingLevel = CtxCacheEntry.cPagingLevel;
+            pMemReqAux->GCPhysSlPt   = CtxCacheEntry.GCPhysSlPt;
+            int rc = dmarDrMemRangeLookup(pDevIns, dmarDrSecondLevelTranslateCached, pMemReqRemap);
+            if (rc == VERR_OUT_OF_RANGE)
+                rc = VINF_SUCCESS;
+            return rc;
+        }
+
+        Assert(CtxCacheEntry.fTt == VTD_TT_UNTRANSLATED_PT);
+        pMemReqOut->AddrRange.uAddr = pMemReqIn->AddrRange.uAddr;
+        pMemReqOut->AddrRange.cb    = pMemReqIn->AddrRange.cb;
+        pMemReqOut->AddrRange.fPerm = DMAR_PERM_ALL;
+        return VINF_SUCCESS;
+    }
+    uint32_t const uCacheGen = pThis->uCacheGen;
+    DMAR_CACHE_UNLOCK(pDevIns, pThis);
+    STAM_COUNTER_INC(&pThis->StatCtxCacheMiss);
+
     /* Read the root-entry from guest memory. */
     uint8_t const idxRootEntry = RT_HI_U8(pMemReqIn->idDevice);
     VTD_ROOT_ENTRY_T RootEntry;
@@ -2453,12 +2948,12 @@ static int dmarDrLegacyModeRemapAddr(PPDMDEVINS pDevIns, uint64_t uRtaddrReg, PD
                     if (fCtxEntryPresent)
                     {
                         /* Validate reserved bits in the context-entry. */
-                        PCDMAR pThis = PDMDEVINS_2_DATA(pDevIns, PCDMAR);
                         if (   !(uCtxEntryQword0 & ~VTD_CONTEXT_ENTRY_0_VALID_MASK)
                             && !(uCtxEntryQword1 & ~pThis->fCtxEntryQw1ValidMask))
                         {
                             /* Get the domain ID for this mapping. */
                             pMemReqOut->idDomain = RT_BF_GET(uCtxEntryQword1, VTD_BF_1_CONTEXT_ENTRY_DID);
+                            pMemReqAux->idDomain = pMemReqOut->idDomain;
 
                             /* Validate the translation type (TT). */
                             uint8_t const fTt = RT_BF_GET(uCtxEntryQword0, VTD_BF_0_CONTEXT_ENTRY_TT);
@@ -2482,7 +2977,13 @@ static int dmarDrLegacyModeRemapAddr(PPDMDEVINS pDevIns, uint64_t uRtaddrReg, PD
                                              */
                                             pMemReqAux->cPagingLevel = cPagingLevel;
                                             pMemReqAux->GCPhysSlPt   = uCtxEntryQword0 & VTD_BF_0_CONTEXT_ENTRY_SLPTPTR_MASK;
-                                            rc = dmarDrMemRangeLookup(pDevIns, dmarDrSecondLevelTranslate, pMemReqRemap);
+
+                                            DMAR_CACHE_LOCK(pDevIns, pThis);
+                                            if (pThis->uCacheGen == uCacheGen)
+                                                dmarCtxCacheAdd(pThis, pMemReqIn->idDevice, pMemReqOut->idDomain, fTt, pMemReqAux);
+                                            DMAR_CACHE_UNLOCK(pDevIns, pThis);
+
+                                            rc = dmarDrMemRangeLookup(pDevIns, dmarDrSecondLevelTranslateCached, pMemReqRemap);
                                             if (rc == VERR_OUT_OF_RANGE)
                                                 rc = VINF_SUCCESS;
                                             return rc;
@@ -2507,6 +3008,12 @@ static int dmarDrLegacyModeRemapAddr(PPDMDEVINS pDevIns, uint64_t uRtaddrReg, PD
                                         {
                                             if (dmarDrLegacyModeIsAwValid(pThis, &CtxEntry, NULL /* pcPagingLevel */))
                                             {
+                                                DMAR_CACHE_LOCK(pDevIns, pThis);
+                                                if (pThis->uCacheGen == uCacheGen)
+                                                    dmarCtxCacheAdd(pThis, pMemReqIn->idDevice, pMemReqOut->idDomain, fTt,
+                                                                    pMemReqAux);
+                                                DMAR_CACHE_UNLOCK(pDevIns, pThis);
+
                                                 PDMARMEMREQOUT pOut = &pMemReqRemap->Out;
                                                 PCDMARMEMREQIN pIn  = &pMemReqRemap->In;
                                                 pOut->AddrRange.uAddr = pIn->AddrRange.uAddr;
@@ -3095,6 +3602,13 @@ static DECLCALLBACK(VBOXSTRICTRC) dmarMmioWrite(PPDMDEVINS pDevIns, void *pvUser
                 break;
             }
 
+            case DMAR_MMIO_OFF_IOTLB_REG:           /* 64-bit */
+            case DMAR_MMIO_OFF_IOTLB_REG + 4:
+            {
+                rcStrict = dmarIotlbRegWrite(pDevIns, offReg, cb);
+                break;
+            }
+
             case VTD_MMIO_OFF_FSTS_REG:             /* 32-bit */
             {
                 rcStrict = dmarFstsRegWrite(pDevIns, uRegWritten, uPrev);
@@ -3302,8 +3816,28 @@ static void dmarR3InvQueueProcessRequests(PPDMDEVINS pDevIns, void const *pvRequ
                 break;
             }
 
-            case VTD_CC_INV_DSC_TYPE:           STAM_COUNTER_INC(&pThis->StatCcInvDsc);             break;
-            case VTD_IOTLB_INV_DSC_TYPE:        STAM_COUNTER_INC(&pThis->StatIotlbInvDsc);          break;
+            case VTD_CC_INV_DSC_TYPE:
+            {
+                uint8_t const  fGranularity = RT_BF_GET(uQword0, VTD_BF_0_CC_INV_DSC_G);
+                uint16_t const idDomain     = RT_BF_GET(uQword0, VTD_BF_0_CC_INV_DSC_DID);
+                uint16_t const idDevice     = RT_BF_GET(uQword0, VTD_BF_0_CC_INV_DSC_SID);
+                dmarCtxCacheRemove(pDevIns, fGranularity, idDomain, idDevice);
+                STAM_COUNTER_INC(&pThis->StatCcInvDsc);
+                break;
+            }
+
+            case VTD_IOTLB_INV_DSC_TYPE:
+            {
+                uint8_t const  fGranularity = RT_BF_GET(uQword0, VTD_BF_0_IOTLB_INV_DSC_G);
+                uint16_t const idDomain     = RT_BF_GET(uQword0, VTD_BF_0_IOTLB_INV_DSC_DID);
+                uint8_t const  cAddrMask    = RT_BF_GET(uQword1, VTD_BF_1_IOTLB_INV_DSC_AM);
+                uint64_t const cPages       = RT_BIT_64(RT_MIN(cAddrMask, 52));
+                uint64_t const uIovaPage    = (uQword1 >> X86_PAGE_4K_SHIFT) & ~(cPages - 1);
+                dmarIotlbRemove(pDevIns, fGranularity, idDomain, uIovaPage, cPages);
+                STAM_COUNTER_INC(&pThis->StatIotlbInvDsc);
+                break;
+            }
+
             case VTD_DEV_TLB_INV_DSC_TYPE:      STAM_COUNTER_INC(&pThis->StatDevtlbInvDsc);         break;
             case VTD_IEC_INV_DSC_TYPE:          STAM_COUNTER_INC(&pThis->StatIecInvDsc);            break;
             case VTD_P_IOTLB_INV_DSC_TYPE:      STAM_COUNTER_INC(&pThis->StatPasidIotlbInvDsc);     break;
@@ -4125,6 +4659,7 @@ static DECLCALLBACK(int) dmarR3LoadDone(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
     AssertPtrReturn(pThisR3, VERR_INVALID_POINTER);
 
     DMAR_LOCK(pDevIns, pThisR3);
+    dmarCacheRemoveAll(pDevIns);
     dmarInvQueueThreadWakeUpIfNeeded(pDevIns);
     DMAR_UNLOCK(pDevIns, pThisR3);
     return VINF_SUCCESS;
@@ -4141,6 +4676,7 @@ static DECLCALLBACK(void) iommuIntelR3Reset(PPDMDEVINS pDevIns)
 
     DMAR_LOCK(pDevIns, pThisR3);
     dmarR3RegsInit(pDevIns);
+    dmarCacheRemoveAll(pDevIns);
     DMAR_UNLOCK(pDevIns, pThisR3);
 }
 
@@ -4213,6 +4749,12 @@ static DECLCALLBACK(int) iommuIntelR3Construct(PPDMDEVINS pDevIns, int iInstance
     rc = PDMDevHlpSetDeviceCritSect(pDevIns, PDMDevHlpCritSectGetNop(pDevIns));
     AssertRCReturn(rc, rc);
 
+    /*
+     * Initialize the critical section protecting the translation caches.
+     */
+    rc = PDMDevHlpCritSectInit(pDevIns, &pThis->CritSectCache, RT_SRC_POS, "IOMMUCache-#%u", iInstance);
+    AssertLogRelRCReturn(rc, rc);
+
     /*
      * Initialize PCI configuration registers.
      */
@@ -4299,6 +4841,12 @@ static DECLCALLBACK(int) iommuIntelR3Construct(PPDMDEVINS pDevIns, int iInstance
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatPasidIotlbInvDsc,  STAMTYPE_COUNTER, "R3/QI/PasidIotlbInv",  STAMUNIT_OCCURENCES, "Number of p_iotlb_inv_dsc processed.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatPasidCacheInvDsc,  STAMTYPE_COUNTER, "R3/QI/PasidCacheInv",  STAMUNIT_OCCURENCES, "Number of pc_inv_dsc pprocessed.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatPasidDevtlbInvDsc, STAMTYPE_COUNTER, "R3/QI/PasidDevtlbInv", STAMUNIT_OCCURENCES, "Number of p_dev_tlb_inv_dsc processed.");
+
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatCtxCacheHit,  STAMTYPE_COUNTER, "CtxCache/Hit",  STAMUNIT_OCCURENCES, "Number of context-cache hits.");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatCtxCacheMiss, STAMTYPE_COUNTER, "CtxCache/Miss", STAMUNIT_OCCURENCES, "Number of context-cache misses.");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIotlbHit,     STAMTYPE_COUNTER, "IOTLB/Hit",     STAMUNIT_OCCURENCES, "Number of IOTLB hits.");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIotlbMiss,    STAMTYPE_COUNTER, "IOTLB/Miss",    STAMUNIT_OCCURENCES, "Number of IOTLB misses.");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIotlbEvicted, STAMTYPE_COUNTER, "IOTLB/Evicted", STAMUNIT_OCCURENCES, "Number of IOTLB entries evicted to make room for new ones.");
 #endif
 
     /*
@@ -138,6 +138,10 @@ typedef struct VMSVGAR3STATE
     uint32_t volatile       fCmdBuf;
     /** Critical section for accessing the command buffer data. */
     RTCRITSECT              CritSectCmdBuf;
+    /** SVGA_IRQFLAG_* bits the FIFO thread wants raised, see vmsvgaR3CmdBufRaiseIRQDeferred. */
+    uint32_t volatile       fCmdBufIrqPending;
+    /** Event semaphore the command buffer IRQ thread waits on. */
+    SUPSEMEVENT             hCmdBufIrqSem;
 
     /** Object Tables: MOBs, etc. see SVGA_OTABLE_* */
     VMSVGAGBO               aGboOTables[SVGA_OTABLE_MAX];
@@ -248,6 +252,8 @@ typedef struct VMSVGAR3STATE
     STAMCOUNTER             StatFifoCursorPosition;
     STAMCOUNTER             StatFifoCursorVisiblity;
     STAMCOUNTER             StatFifoWatchdogWakeUps;
+    STAMCOUNTER             StatCmdBufIrqDeferred;
+    STAMCOUNTER             StatCmdBufIrqCoalesced;
 } VMSVGAR3STATE, *PVMSVGAR3STATE;
 
 
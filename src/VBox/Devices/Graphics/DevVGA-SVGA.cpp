@@ -3278,6 +3278,89 @@ static void vmsvgaR3CmdBufRaiseIRQ(PPDMDEVINS pDevIns, PVGASTATE pThis, uint32_t
 }
 
 
+/** Raises the interrupts collected by vmsvgaR3CmdBufRaiseIRQDeferred, if any.
+ *
+ * @param pDevIns     The device instance.
+ * @param pThis       The shared VGA/VMSVGA state.
+ * @param pSvgaR3State The VMSVGA ring-3 state.
+ * @thread IRQ or EMT.
+ */
+static void vmsvgaR3CmdBufFlushIRQ(PPDMDEVINS pDevIns, PVGASTATE pThis, PVMSVGAR3STATE pSvgaR3State)
+{
+    uint32_t const u32IrqStatus = ASMAtomicXchgU32(&pSvgaR3State->fCmdBufIrqPending, 0);
+    if (u32IrqStatus)
+        vmsvgaR3CmdBufRaiseIRQ(pDevIns, pThis, u32IrqStatus);
+}
+
+
+/** Raise an IRQ without entering the device critical section.
+ *
+ * The FIFO thread would otherwise stall on every completed command buffer while an
+ * EMT holds the device lock.  The bits are accumulated and raised by the command
+ * buffer IRQ thread, which also merges completions arriving while it is busy.
+ * Falls back to raising the IRQ directly when that thread is not running.
+ *
+ * @param pDevIns     The device instance.
+ * @param pThis       The shared VGA/VMSVGA state.
+ * @param pThisCC     The VGA/VMSVGA state for ring-3.
+ * @param u32IrqStatus SVGA_IRQFLAG_* bits.
+ * @thread FIFO
+ */
+static void vmsvgaR3CmdBufRaiseIRQDeferred(PPDMDEVINS pDevIns, PVGASTATE pThis, PVGASTATECC pThisCC, uint32_t u32IrqStatus)
+{
+    PVMSVGAR3STATE const pSvgaR3State = pThisCC->svga.pSvgaR3State;
+    PPDMTHREAD const     pThread      = pThisCC->svga.pCmdBufIrqThread;
+    if (RT_LIKELY(pThread && pThread->enmState == PDMTHREADSTATE_RUNNING))
+    {
+        STAM_REL_COUNTER_INC(&pSvgaR3State->StatCmdBufIrqDeferred);
+        if (ASMAtomicOrExU32(&pSvgaR3State->fCmdBufIrqPending, u32IrqStatus) == 0)
+            PDMDevHlpSUPSemEventSignal(pDevIns, pSvgaR3State->hCmdBufIrqSem);
+        else
+            STAM_REL_COUNTER_INC(&pSvgaR3State->StatCmdBufIrqCoalesced);
+    }
+    else
+        vmsvgaR3CmdBufRaiseIRQ(pDevIns, pThis, u32IrqStatus);
+}
+
+
+/**
+ * @callback_method_impl{PFNPDMTHREADDEV, Raises interrupts for the FIFO thread.}
+ */
+static DECLCALLBACK(int) vmsvgaR3CmdBufIrqLoop(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    PVGASTATE      pThis        = PDMDEVINS_2_DATA(pDevIns, PVGASTATE);
+    PVGASTATECC    pThisCC      = PDMDEVINS_2_DATA_CC(pDevIns, PVGASTATECC);
+    PVMSVGAR3STATE pSvgaR3State = pThisCC->svga.pSvgaR3State;
+
+    if (pThread->enmState == PDMTHREADSTATE_INITIALIZING)
+        return VINF_SUCCESS;
+
+    while (pThread->enmState == PDMTHREADSTATE_RUNNING)
+    {
+        /* The FIFO thread signals on the empty -> non-empty transition only,
+         * so take everything before going back to sleep. */
+        vmsvgaR3CmdBufFlushIRQ(pDevIns, pThis, pSvgaR3State);
+        PDMDevHlpSUPSemEventWaitNoResume(pDevIns, pSvgaR3State->hCmdBufIrqSem, RT_INDEFINITE_WAIT);
+    }
+
+    /* Do not leave anything behind when suspending. */
+    vmsvgaR3CmdBufFlushIRQ(pDevIns, pThis, pSvgaR3State);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @callback_method_impl{PFNPDMTHREADWAKEUPDEV,
+ * Unblock the command buffer IRQ thread so it can respond to a state change.}
+ */
+static DECLCALLBACK(int) vmsvgaR3CmdBufIrqLoopWakeUp(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    RT_NOREF(pThread);
+    PVGASTATECC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVGASTATECC);
+    return PDMDevHlpSUPSemEventSignal(pDevIns, pThisCC->svga.pSvgaR3State->hCmdBufIrqSem);
+}
+
+
 /** Allocate a command buffer structure.
  *
  * @param pCmdBufCtx  The command buffer context which must allocate the buffer.
@@ -4342,7 +4425,7 @@ static SVGACBStatus vmsvgaR3CmdBufProcessCommands(PPDMDEVINS pDevIns, PVGASTATE
         { /* likely */ }
         else
         {
-            vmsvgaR3CmdBufRaiseIRQ(pDevIns, pThis, *pu32IrqStatus);
+            vmsvgaR3CmdBufRaiseIRQDeferred(pDevIns, pThis, pThisCC, *pu32IrqStatus);
             *pu32IrqStatus = 0;
         }
     }
@@ -4442,7 +4525,7 @@ static void vmsvgaR3CmdBufProcessBuffers(PPDMDEVINS pDevIns, PVGASTATE pThis, PV
 
         vmsvgaR3CmdBufWriteStatus(pDevIns, pCmdBuf->GCPhysCB, CBstatus, offNextCmd);
         if (u32IrqStatus)
-            vmsvgaR3CmdBufRaiseIRQ(pDevIns, pThis, u32IrqStatus);
+            vmsvgaR3CmdBufRaiseIRQDeferred(pDevIns, pThis, pThisCC, u32IrqStatus);
 
         vmsvgaR3CmdBufFree(pCmdBuf);
     }
@@ -6739,6 +6822,9 @@ int vmsvgaR3SaveExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
     PCPDMDEVHLPR3   pHlp       = pDevIns->pHlpR3;
     int             rc;
 
+    /* Make sure deferred command buffer interrupts are part of the saved IRQ status. */
+    vmsvgaR3CmdBufFlushIRQ(pDevIns, pThis, pSVGAState);
+
     /* Save our part of the VGAState */
     rc = pHlp->pfnSSMPutStructEx(pSSM, &pThis->svga, sizeof(pThis->svga), 0, g_aVGAStateSVGAFields, NULL);
     AssertLogRelRCReturn(rc, rc);
@@ -6906,6 +6992,12 @@ static void vmsvgaR3StateTerm(PVGASTATE pThis, PVGASTATECC pThisCC)
         RTCritSectLeave(&pSVGAState->CritSectCmdBuf);
         RTCritSectDelete(&pSVGAState->CritSectCmdBuf);
     }
+
+    if (pSVGAState->hCmdBufIrqSem != NIL_SUPSEMEVENT)
+    {
+        PDMDevHlpSUPSemEventClose(pSVGAState->pDevIns, pSVGAState->hCmdBufIrqSem);
+        pSVGAState->hCmdBufIrqSem = NIL_SUPSEMEVENT;
+    }
 }
 
 /**
@@ -6934,6 +7026,9 @@ static int vmsvgaR3StateInit(PPDMDEVINS pDevIns, PVGASTATE pThis, PVMSVGAR3STATE
     rc = RTCritSectInit(&pSVGAState->CritSectCmdBuf);
     AssertRCReturn(rc, rc);
 
+    rc = PDMDevHlpSUPSemEventCreate(pDevIns, &pSVGAState->hCmdBufIrqSem);
+    AssertRCReturn(rc, rc);
+
     /* Init screen ids which are constant and allow to use a pointer to aScreens element and know its index. */
     for (uint32_t i = 0; i < RT_ELEMENTS(pSVGAState->aScreens); ++i)
         pSVGAState->aScreens[i].idScreen = i;
@@ -7592,6 +7687,13 @@ int vmsvgaR3Destruct(PPDMDEVINS pDevIns)
         pThisCC->svga.pFIFOIOThread = NULL;
     }
 
+    if (pThisCC->svga.pCmdBufIrqThread)
+    {
+        int rc = PDMDevHlpThreadDestroy(pDevIns, pThisCC->svga.pCmdBufIrqThread, NULL);
+        AssertLogRelRC(rc);
+        pThisCC->svga.pCmdBufIrqThread = NULL;
+    }
+
     /*
      * Destroy the special SVGA state.
      */
@@ -7750,6 +7852,10 @@ int vmsvgaR3Init(PPDMDEVINS pDevIns)
         return rc;
     }
 
+    rc = PDMDevHlpThreadCreate(pDevIns, &pThisCC->svga.pCmdBufIrqThread, pThis, vmsvgaR3CmdBufIrqLoop,
+                               vmsvgaR3CmdBufIrqLoopWakeUp, 0, RTTHREADTYPE_IO, "VMSVGA IRQ");
+    AssertLogRelRCReturn(rc, rc);
+
     /*
      * Statistics.
      */
@@ -7942,6 +8048,8 @@ int vmsvgaR3Init(PPDMDEVINS pDevIns)
     REG_CNT(&pSVGAState->StatFifoCursorPosition,          "VMSVGA/FifoCursorPosition",             "Cursor position and visibility changes.");
     REG_CNT(&pSVGAState->StatFifoCursorVisiblity,         "VMSVGA/FifoCursorVisiblity",            "Cursor visibility changes.");
     REG_CNT(&pSVGAState->StatFifoWatchdogWakeUps,         "VMSVGA/FifoWatchdogWakeUps",            "Number of times the FIFO refresh poller/watchdog woke up the FIFO thread.");
+    REG_CNT(&pSVGAState->StatCmdBufIrqDeferred,           "VMSVGA/CmdBufIrqDeferred",              "Command buffer interrupts handed to the IRQ thread.");
+    REG_CNT(&pSVGAState->StatCmdBufIrqCoalesced,          "VMSVGA/CmdBufIrqCoalesced",             "Command buffer interrupts merged with one already pending.");
 
     static const char * const s_apszGboNames[] =
     { "MOB", "SURFACE", "CONTEXT", "SHADER", "SCREENTARGET", "DXCONTEXT", "RESERVED1", "RESERVED2" };
@@ -566,6 +566,8 @@ typedef struct VMSVGASTATER3
     R3PTRTYPE(RTSEMEVENT)       hFIFOExtCmdSem;
     /** FIFO IO Thread. */
     R3PTRTYPE(PPDMTHREAD)       pFIFOIOThread;
+    /** Thread raising command buffer interrupts on behalf of the FIFO thread. */
+    R3PTRTYPE(PPDMTHREAD)       pCmdBufIrqThread;
 } VMSVGASTATER3;
 
 
@@ -413,6 +413,8 @@ typedef struct VMSVGA3DBACKEND
     SVGADXContextMobFormat     svgaDXContext;          /* Current state of pipeline. */
 
     DXBOUNDRESOURCES           resources;              /* What is currently applied to the pipeline. */
+
+    char                      *pszShaderCacheDir;      /* Directory of the translated shader cache, NULL if disabled. */
 } VMSVGA3DBACKEND;
 
 
@@ -3160,6 +3162,20 @@ static DECLCALLBACK(int) vmsvga3dBackInit(PPDMDEVINS pDevIns, PVGASTATE pThis, P
     }
 #endif
 
+    if (RT_SUCCESS(rc))
+    {
+        /* Optional on-disk cache of translated shaders, may be shared by several VMs. */
+        int rc2 = pDevIns->pHlpR3->pfnCFGMQueryStringAllocDef(pDevIns->pCfg, "VMSVGA3dShaderCacheDir",
+                                                              &pBackend->pszShaderCacheDir, NULL);
+        if (RT_SUCCESS(rc2) && pBackend->pszShaderCacheDir && *pBackend->pszShaderCacheDir)
+            LogRel(("VMSVGA3d: Shader cache in '%s'\n", pBackend->pszShaderCacheDir));
+        else
+        {
+            PDMDevHlpMMHeapFree(pDevIns, pBackend->pszShaderCacheDir);
+            pBackend->pszShaderCacheDir = NULL;
+        }
+    }
+
     vmsvga3dDXInitContextMobData(&pBackend->svgaDXContext);
 //DEBUG_BREAKPOINT_TEST();
     return rc;
@@ -7758,7 +7774,8 @@ static void dxSetupPipeline(PVGASTATECC pThisCC, PVMSVGA3DDXCONTEXT pDXContext)
 
                 vboxDXMatchShaderSignatures(pThisCC, pDXContext, pDXShader);
 
-                rc = DXShaderCreateDXBC(&pDXShader->shaderInfo, &pDXShader->pvDXBC, &pDXShader->cbDXBC);
+                rc = DXShaderCreateDXBCCached(&pDXShader->shaderInfo, pThisCC->svga.p3dState->pBackend->pszShaderCacheDir,
+                                              &pDXShader->pvDXBC, &pDXShader->cbDXBC);
                 if (RT_SUCCESS(rc))
                 {
 #ifdef LOG_ENABLED
@@ -34,8 +34,13 @@
 #include <VBox/log.h>
 
 #include <iprt/asm.h>
+#include <iprt/dir.h>
+#include <iprt/file.h>
 #include <iprt/md5.h>
 #include <iprt/mem.h>
+#include <iprt/path.h>
+#include <iprt/rand.h>
+#include <iprt/sha.h>
 #include <iprt/sort.h>
 #include <iprt/string.h>
 
@@ -2746,6 +2751,165 @@ int DXShaderCreateDXBC(DXShaderInfo const *pInfo, void **ppvDXBC, uint32_t *pcbD
 }
 
 
+/*
+ * On-disk cache of translated shaders.
+ *
+ * Files are named after the SHA-256 of everything dxbcCreateFromInfo consumes and live in
+ * a per translator revision subdirectory, so several VMs can share one cache directory and
+ * a changed translator never picks up stale containers.
+ */
+
+static void dxbcCacheHashSignatures(PRTSHA256CONTEXT pCtx, uint32_t cSignature, SVGA3dDXSignatureEntry const *paSignature,
+                                    DXShaderAttributeSemantic const *paSemantic)
+{
+    RTSha256Update(pCtx, &cSignature, sizeof(cSignature));
+    for (uint32_t i = 0; i < RT_MIN(cSignature, 32); ++i)
+    {
+        RTSha256Update(pCtx, &paSignature[i], sizeof(paSignature[i]));
+        char const *pszName = paSemantic[i].pcszSemanticName ? paSemantic[i].pcszSemanticName : "";
+        RTSha256Update(pCtx, pszName, strlen(pszName) + 1);
+        RTSha256Update(pCtx, &paSemantic[i].SemanticIndex, sizeof(paSemantic[i].SemanticIndex));
+    }
+}
+
+
+static int dxbcCacheMakePath(DXShaderInfo const *pInfo, const char *pszCacheDir, char *pszPath, size_t cbPath)
+{
+    RTSHA256CONTEXT Ctx;
+    RTSha256Init(&Ctx);
+    uint32_t const u32ProgramType = pInfo->enmProgramType;
+    uint8_t  const fGuestSignatures = pInfo->fGuestSignatures;
+    RTSha256Update(&Ctx, &u32ProgramType, sizeof(u32ProgramType));
+    RTSha256Update(&Ctx, &fGuestSignatures, sizeof(fGuestSignatures));
+    RTSha256Update(&Ctx, &pInfo->cbBytecode, sizeof(pInfo->cbBytecode));
+    RTSha256Update(&Ctx, pInfo->pvBytecode, pInfo->cbBytecode);
+    dxbcCacheHashSignatures(&Ctx, pInfo->cInputSignature, pInfo->aInputSignature, pInfo->aInputSemantic);
+    dxbcCacheHashSignatures(&Ctx, pInfo->cOutputSignature, pInfo->aOutputSignature, pInfo->aOutputSemantic);
+    dxbcCacheHashSignatures(&Ctx, pInfo->cPatchConstantSignature, pInfo->aPatchConstantSignature, pInfo->aPatchConstantSemantic);
+    uint8_t abHash[RTSHA256_HASH_SIZE];
+    RTSha256Final(&Ctx, abHash);
+
+    char szHash[RTSHA256_DIGEST_LEN + 1];
+    int rc = RTSha256ToString(abHash, szHash, sizeof(szHash));
+    AssertRCReturn(rc, rc);
+
+    ssize_t cch = RTStrPrintf2(pszPath, cbPath, "%s%cdxbc-r%u%c%s.dxbc", pszCacheDir, RTPATH_SLASH,
+                               DXSHADER_TRANSLATOR_REVISION, RTPATH_SLASH, szHash);
+    return cch > 0 ? VINF_SUCCESS : VERR_BUFFER_OVERFLOW;
+}
+
+
+static int dxbcCacheLoad(const char *pszPath, void **ppvDXBC, uint32_t *pcbDXBC)
+{
+    RTFILE hFile;
+    int rc = RTFileOpen(&hFile, pszPath, RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_NONE);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    uint64_t cbFile = 0;
+    rc = RTFileQuerySize(hFile, &cbFile);
+    if (RT_SUCCESS(rc))
+    {
+        if (cbFile >= sizeof(DXBCHeader) && cbFile <= _16M)
+        {
+            void *pvDXBC = RTMemAlloc((size_t)cbFile);
+            if (pvDXBC)
+            {
+                rc = RTFileRead(hFile, pvDXBC, (size_t)cbFile, NULL);
+                DXBCHeader const *pHdr = (DXBCHeader const *)pvDXBC;
+                if (   RT_SUCCESS(rc)
+                    && pHdr->u32DXBC == DXBC_MAGIC
+                    && pHdr->cbTotal == cbFile)
+                {
+                    *ppvDXBC = pvDXBC;
+                    *pcbDXBC = (uint32_t)cbFile;
+                }
+                else
+                {
+                    RTMemFree(pvDXBC);
+                    rc = VERR_INVALID_MAGIC;
+                }
+            }
+            else
+                rc = VERR_NO_MEMORY;
+        }
+        else
+            rc = VERR_INVALID_MAGIC;
+    }
+    RTFileClose(hFile);
+    return rc;
+}
+
+
+static void dxbcCacheStore(const char *pszPath, void const *pvDXBC, uint32_t cbDXBC)
+{
+    /* Write to a unique temporary file first and rename it into place, so a VM reading
+     * concurrently never sees a partial container. */
+    char szDir[RTPATH_MAX];
+    int rc = RTStrCopy(szDir, sizeof(szDir), pszPath);
+    AssertRCReturnVoid(rc);
+    RTPathStripFilename(szDir);
+    rc = RTDirCreateFullPath(szDir, 0755);
+    if (RT_FAILURE(rc))
+    {
+        LogRelMax(4, ("VMSVGA: Failed to create shader cache directory '%s': %Rrc\n", szDir, rc));
+        return;
+    }
+
+    char szTmp[RTPATH_MAX];
+    if (RTStrPrintf2(szTmp, sizeof(szTmp), "%s.%08x.tmp", pszPath, RTRandU32()) <= 0)
+        return;
+
+    RTFILE hFile;
+    rc = RTFileOpen(&hFile, szTmp, RTFILE_O_WRITE | RTFILE_O_CREATE | RTFILE_O_DENY_WRITE);
+    if (RT_SUCCESS(rc))
+    {
+        rc = RTFileWrite(hFile, pvDXBC, cbDXBC, NULL);
+        RTFileClose(hFile);
+        if (RT_SUCCESS(rc))
+            rc = RTFileRename(szTmp, pszPath, RTPATHRENAME_FLAGS_REPLACE);
+        if (RT_FAILURE(rc))
+            RTFileDelete(szTmp);
+    }
+    if (RT_FAILURE(rc))
+        LogRelMax(4, ("VMSVGA: Failed to store shader in cache '%s': %Rrc\n", pszPath, rc));
+}
+
+
+/**
+ * Same as DXShaderCreateDXBC, but first looks the container up in the on-disk
+ * cache and adds it there after a translation.
+ *
+ * @returns VBox status code.
+ * @param   pInfo           The parsed shader.
+ * @param   pszCacheDir     The cache directory, NULL to bypass the cache.
+ * @param   ppvDXBC         Where to return the container (free with RTMemFree).
+ * @param   pcbDXBC         Where to return the size of the container.
+ */
+int DXShaderCreateDXBCCached(DXShaderInfo const *pInfo, const char *pszCacheDir, void **ppvDXBC, uint32_t *pcbDXBC)
+{
+    if (!pszCacheDir)
+        return DXShaderCreateDXBC(pInfo, ppvDXBC, pcbDXBC);
+
+    char szPath[RTPATH_MAX];
+    int rc = dxbcCacheMakePath(pInfo, pszCacheDir, szPath, sizeof(szPath));
+    if (RT_FAILURE(rc))
+        return DXShaderCreateDXBC(pInfo, ppvDXBC, pcbDXBC);
+
+    rc = dxbcCacheLoad(szPath, ppvDXBC, pcbDXBC);
+    if (RT_SUCCESS(rc))
+    {
+        Log6Func(("Cache hit %s\n", szPath));
+        return rc;
+    }
+
+    rc = DXShaderCreateDXBC(pInfo, ppvDXBC, pcbDXBC);
+    if (RT_SUCCESS(rc))
+        dxbcCacheStore(szPath, *ppvDXBC, *pcbDXBC);
+    return rc;
+}
+
+
 static char const *dxbcGetOutputSemanticName(DXShaderInfo const *pInfo, uint32_t idxRegister, uint32_t u32BlobType,
                                              uint32_t cSignature, SVGA3dDXSignatureEntry const *paSignature,
                                              SVGA3dDXSignatureSemanticName *pSemanticName)
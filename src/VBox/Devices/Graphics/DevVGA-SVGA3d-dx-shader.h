@@ -44,6 +44,10 @@
 #pragma pack()
 #include "vmsvga_headers_end.h"
 
+/** Revision of the shader translator.  Bump whenever a change affects the
+ * generated DXBC, it versions the on-disk cache (DXShaderCreateDXBCCached). */
+#define DXSHADER_TRANSLATOR_REVISION 1
+
 /* SVGA3dDXSignatureRegisterComponentType (D3D10_SB_REGISTER_COMPONENT_TYPE) */
 #define SVGADX_SIGNATURE_REGISTER_COMPONENT_UINT32  1
 #define SVGADX_SIGNATURE_REGISTER_COMPONENT_SINT32  2
@@ -83,6 +87,7 @@ int DXShaderUpdateResources(DXShaderInfo const *pInfo, VGPU10_RESOURCE_DIMENSION
 VGPU10_RESOURCE_RETURN_TYPE DXShaderResourceReturnTypeFromFormat(SVGA3dSurfaceFormat format);
 SVGA3dDXSignatureRegisterComponentType DXShaderComponentTypeFromFormat(SVGA3dSurfaceFormat format);
 int DXShaderCreateDXBC(DXShaderInfo const *pInfo, void **ppvDXBC, uint32_t *pcbDXBC);
+int DXShaderCreateDXBCCached(DXShaderInfo const *pInfo, const char *pszCacheDir, void **ppvDXBC, uint32_t *pcbDXBC);
 char const *DXShaderGetOutputSemanticName(DXShaderInfo const *pInfo, uint32_t idxRegister, SVGA3dDXSignatureSemanticName *pSemanticName);
 
 #endif /* !VBOX_INCLUDED_SRC_Graphics_DevVGA_SVGA3d_dx_shader_h */
@@ -68,6 +68,10 @@
 #define VGA_BLINK_PERIOD_FULL           (RT_NS_100MS * 4)   /**< Blink cycle length. */
 #define VGA_BLINK_PERIOD_ON             (RT_NS_100MS * 2)   /**< How long cursor/text is visible. */
 
+/* Graphics mode damage tracking against the VRAM shadow copy. */
+#define VGA_DRAW_TILE_PIXELS            64                  /**< Width of a compared scanline tile, multiple of 8. */
+#define VGA_DRAW_SHADOW_MAX             _64M                /**< Largest shadow copy we are willing to keep. */
+
 /* EGA compatible switch values (in high nibble).
  * XENIX 2.1.x/2.2.x is known to rely on the switch values.
  */
@@ -2131,6 +2135,119 @@ static vga_draw_line_func * const vga_draw_line_table[4 * VGA_DRAW_LINE_NB] = {
     vga_draw_line32_32,
 };
 
+/**
+ * Marks the graphics mode shadow copy as stale, for when something other than
+ * vgaR3DrawGraphic writes the framebuffer.
+ */
+DECLINLINE(void) vgaR3DrawShadowInvalidate(PVGASTATER3 pThisCC)
+{
+    pThisCC->cbDrawShadowLine = 0;
+}
+
+/**
+ * Prepares the shadow copy of the VRAM for a linear graphics mode update.
+ *
+ * @returns Pointer to the shadow, NULL if not available (no memory, too big).
+ * @param   pThisCC     The VGA state for ring-3.
+ * @param   pDrv        The display connector.
+ * @param   cbLine      Source bytes per scanline.
+ * @param   cLines      Number of scanlines.
+ * @param   pfValid     Where to return whether the shadow content matches
+ *                      the framebuffer.  If not, the caller must do a full
+ *                      update.
+ */
+static uint8_t *vgaR3DrawShadowPrepare(PVGASTATER3 pThisCC, PDMIDISPLAYCONNECTOR *pDrv, uint32_t cbLine, uint32_t cLines,
+                                       bool *pfValid)
+{
+    *pfValid = false;
+
+    uint64_t const cbNeeded = (uint64_t)cbLine * cLines;
+    if (!cbNeeded || cbNeeded > VGA_DRAW_SHADOW_MAX)
+    {
+        vgaR3DrawShadowInvalidate(pThisCC);
+        return NULL;
+    }
+
+    if (cbNeeded > pThisCC->cbDrawShadow)
+    {
+        vgaR3DrawShadowInvalidate(pThisCC);
+        RTMemFree(pThisCC->pbDrawShadow);
+        pThisCC->pbDrawShadow = (uint8_t *)RTMemAlloc((size_t)cbNeeded);
+        pThisCC->cbDrawShadow = pThisCC->pbDrawShadow ? (size_t)cbNeeded : 0;
+        if (!pThisCC->pbDrawShadow)
+            return NULL;
+    }
+    else
+        *pfValid =    pThisCC->cbDrawShadowLine   == cbLine
+                   && pThisCC->cDrawShadowLines   == cLines
+                   && pThisCC->pbDrawShadowTarget == pDrv->pbData;
+
+    pThisCC->cbDrawShadowLine   = cbLine;
+    pThisCC->cDrawShadowLines   = cLines;
+    pThisCC->pbDrawShadowTarget = pDrv->pbData;
+    return pThisCC->pbDrawShadow;
+}
+
+/**
+ * Converts the tiles of a linear mode scanline which differ from the shadow copy.
+ *
+ * The changed source bytes are copied into the shadow first and converted from
+ * there, so the framebuffer always matches the shadow even while the guest keeps
+ * writing to VRAM.  Adjacent changed tiles are converted in one go.
+ *
+ * @returns true if anything was converted, false if the scanline is unchanged.
+ * @param   pThis           The shared VGA state.
+ * @param   pThisCC         The VGA state for ring-3.
+ * @param   pfnVgaDrawLine  The scanline conversion worker.
+ * @param   pbDst           The framebuffer scanline.
+ * @param   pbSrc           The VRAM scanline.
+ * @param   pbShadow        The shadow scanline.
+ * @param   cx              Width in pixels.
+ * @param   cbSrcPixel      Bytes per source pixel.
+ * @param   cbDstPixel      Bytes per framebuffer pixel.
+ * @param   pxMin           The leftmost converted pixel (in/out).
+ * @param   pxMax           The pixel after the rightmost converted one (in/out).
+ */
+static bool vgaR3DrawLineChangedTiles(PVGASTATE pThis, PVGASTATER3 pThisCC, vga_draw_line_func *pfnVgaDrawLine,
+                                      uint8_t *pbDst, const uint8_t *pbSrc, uint8_t *pbShadow, int cx,
+                                      unsigned cbSrcPixel, unsigned cbDstPixel, int *pxMin, int *pxMax)
+{
+    bool fChanged = false;
+    int  x        = 0;
+    while (x < cx)
+    {
+        int cxTile = RT_MIN(VGA_DRAW_TILE_PIXELS, cx - x);
+        if (!memcmp(&pbSrc[x * cbSrcPixel], &pbShadow[x * cbSrcPixel], cxTile * cbSrcPixel))
+        {
+            x += cxTile;
+            continue;
+        }
+
+        /* Extend the run over the following changed tiles. */
+        int xEnd = x + cxTile;
+        while (xEnd < cx)
+        {
+            cxTile = RT_MIN(VGA_DRAW_TILE_PIXELS, cx - xEnd);
+            if (!memcmp(&pbSrc[xEnd * cbSrcPixel], &pbShadow[xEnd * cbSrcPixel], cxTile * cbSrcPixel))
+                break;
+            xEnd += cxTile;
+            cxTile = 0;
+        }
+
+        memcpy(&pbShadow[x * cbSrcPixel], &pbSrc[x * cbSrcPixel], (xEnd - x) * cbSrcPixel);
+        pfnVgaDrawLine(pThis, pThisCC, &pbDst[x * cbDstPixel], &pbShadow[x * cbSrcPixel], xEnd - x);
+        STAM_COUNTER_ADD(&pThis->StatDrawTilesConverted, (xEnd - x + VGA_DRAW_TILE_PIXELS - 1) / VGA_DRAW_TILE_PIXELS);
+
+        *pxMin   = RT_MIN(*pxMin, x);
+        *pxMax   = RT_MAX(*pxMax, xEnd);
+        fChanged = true;
+
+        /* The tile which ended the run (if any) has been found unchanged already. */
+        x = xEnd + cxTile;
+    }
+    return fChanged;
+}
+
 static int vgaR3GetBpp(PVGASTATE pThis)
 {
     int ret;
@@ -2446,8 +2563,8 @@ static int vgaR3DrawGraphic(PVGASTATE pThis, PVGASTATER3 pThisCC, bool full_upda
 {
     int y1, y2, y, page_min, page_max, linesize, y_start, double_scan;
     int width, height, shift_control, line_offset, page0, page1, bwidth, bits;
-    int disp_width, multi_run;
-    uint8_t *d;
+    int disp_width, multi_run, x_min, x_max;
+    uint8_t *d, *pbShadow;
     uint32_t v, addr1, addr;
     vga_draw_line_func *pfnVgaDrawLine;
 
@@ -2574,6 +2691,28 @@ static int vgaR3DrawGraphic(PVGASTATE pThis, PVGASTATER3 pThisCC, bool full_upda
     else
         pThis->vga_addr_mask = UINT32_MAX;
 
+    /*
+     * Linear modes compare dirty scanlines against a copy of what was converted
+     * last time and only convert and report the tiles which really changed.
+     * Pages are dirty at 4KB granularity and the guest frequently rewrites
+     * identical data.  Not for screenshots (!reset_dirty), as they render into
+     * a different buffer.
+     */
+    pbShadow = NULL;
+    unsigned const cbSrcPixel = bits / 8;
+    unsigned const cbDstPixel = pDrv->cBits == 8 ? 1 : pDrv->cBits <= 16 ? 2 : 4;
+    if (bits >= 8 && pThis->fRenderVRAM && reset_dirty && !pThisCC->cursor_draw_line)
+    {
+        bool fShadowValid;
+        pbShadow = vgaR3DrawShadowPrepare(pThisCC, pDrv, bwidth, height, &fShadowValid);
+        if (pbShadow && !fShadowValid)
+            full_update = true;
+    }
+    else if (reset_dirty)
+        vgaR3DrawShadowInvalidate(pThisCC);
+    x_min = INT32_MAX;
+    x_max = 0;
+
     y1 = 0;
     y2 = pThis->cr[0x09] & 0x1F;    /* starting row scan count */
     for(y = 0; y < height; y++) {
@@ -2600,23 +2739,44 @@ static int vgaR3DrawGraphic(PVGASTATE pThis, PVGASTATER3 pThisCC, bool full_upda
             update |= vgaR3IsDirty(pThis, page0 + GUEST_PAGE_SIZE);
         }
         /* explicit invalidation for the hardware cursor */
-        update |= (pThis->invalidated_y_table[y >> 5] >> (y & 0x1f)) & 1;
+        bool const fInvalidated = (pThis->invalidated_y_table[y >> 5] >> (y & 0x1f)) & 1;
+        update |= fInvalidated;
         if (update) {
-            if (y_start < 0)
-                y_start = y;
             if (page0 < page_min)
                 page_min = page0;
             if (page1 > page_max)
                 page_max = page1;
-            if (pThis->fRenderVRAM)
-                pfnVgaDrawLine(pThis, pThisCC, d, pThisCC->pbVRam + addr, width);
+            if (pbShadow) {
+                uint8_t *pbLineShadow = pbShadow + (size_t)y * bwidth;
+                if (full_update || fInvalidated) {
+                    memcpy(pbLineShadow, pThisCC->pbVRam + addr, bwidth);
+                    pfnVgaDrawLine(pThis, pThisCC, d, pbLineShadow, width);
+                    x_min = 0;
+                    x_max = disp_width;
+                } else if (!vgaR3DrawLineChangedTiles(pThis, pThisCC, pfnVgaDrawLine, d, pThisCC->pbVRam + addr,
+                                                      pbLineShadow, width, cbSrcPixel, cbDstPixel, &x_min, &x_max)) {
+                    STAM_COUNTER_INC(&pThis->StatDrawLinesUnchanged);
+                    update = false;
+                }
+            } else {
+                if (pThis->fRenderVRAM)
+                    pfnVgaDrawLine(pThis, pThisCC, d, pThisCC->pbVRam + addr, width);
+                x_min = 0;
+                x_max = disp_width;
+            }
+        }
+        if (update) {
+            if (y_start < 0)
+                y_start = y;
             if (pThisCC->cursor_draw_line)
                 pThisCC->cursor_draw_line(pThis, d, y);
         } else {
             if (y_start >= 0) {
                 /* flush to display */
-                pDrv->pfnUpdateRect(pDrv, 0, y_start, disp_width, y - y_start);
+                pDrv->pfnUpdateRect(pDrv, x_min, y_start, x_max - x_min, y - y_start);
                 y_start = -1;
+                x_min = INT32_MAX;
+                x_max = 0;
             }
         }
         if (!multi_run) {
@@ -2639,7 +2799,7 @@ static int vgaR3DrawGraphic(PVGASTATE pThis, PVGASTATER3 pThisCC, bool full_upda
     }
     if (y_start >= 0) {
         /* flush to display */
-        pDrv->pfnUpdateRect(pDrv, 0, y_start, disp_width, y - y_start);
+        pDrv->pfnUpdateRect(pDrv, x_min, y_start, x_max - x_min, y - y_start);
     }
     /* reset modified pages */
     if (page_max != -1 && reset_dirty) {
@@ -4911,6 +5071,7 @@ static DECLCALLBACK(int) vgaR3PortUpdateDisplay(PPDMIDISPLAYPORT pInterface)
         &&  !pThis->svga.fTraces)
     {
         /* Nothing to do as the guest will explicitely update us about frame buffer changes. */
+        vgaR3DrawShadowInvalidate(pThisCC);
         PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
         return VINF_SUCCESS;
     }
@@ -4921,6 +5082,8 @@ static DECLCALLBACK(int) vgaR3PortUpdateDisplay(PPDMIDISPLAYPORT pInterface)
 # else
     if (VBVAUpdateDisplay(pThis, pThisCC) == VINF_SUCCESS)
     {
+        /* The guest draws into the framebuffer itself. */
+        vgaR3DrawShadowInvalidate(pThisCC);
         PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
         return VINF_SUCCESS;
     }
@@ -5485,8 +5648,18 @@ vgaR3PortCopyRect(PPDMIDISPLAYPORT pInterface,
         return VERR_INVALID_PARAMETER;
     }
 
-    int rc = PDMDevHlpCritSectEnter(pDevIns, &pThis->CritSect, VERR_SEM_BUSY);
-    AssertRCReturn(rc, rc);
+    /* While vbvaFlush processes the screens on several threads, the lock owner waits for the
+     * other threads, which get here via the display connector.  The state cannot change then. */
+# ifdef VBOX_WITH_HGSMI
+    bool const fLock = !ASMAtomicReadBool(&pThisCC->fVBVAParallelFlush);
+# else
+    bool const fLock = true;
+# endif
+    if (fLock)
+    {
+        int rc = PDMDevHlpCritSectEnter(pDevIns, &pThis->CritSect, VERR_SEM_BUSY);
+        AssertRCReturn(rc, rc);
+    }
 
     /* This method only works if the VGA device is in a VBE mode or not paused VBVA mode.
      * VGA modes are reported to the caller by returning VERR_INVALID_STATE.
@@ -5506,7 +5679,8 @@ vgaR3PortCopyRect(PPDMIDISPLAYPORT pInterface,
 # endif
        )
     {
-        PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
+        if (fLock)
+            PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
         return VERR_INVALID_STATE;
     }
 
@@ -5516,7 +5690,8 @@ vgaR3PortCopyRect(PPDMIDISPLAYPORT pInterface,
         default:
         case 0:
             /* Nothing to do, just return. */
-            PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
+            if (fLock)
+                PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
             return VINF_SUCCESS;
         case 8:
             v = VGA_DRAW_LINE8;
@@ -5557,7 +5732,8 @@ vgaR3PortCopyRect(PPDMIDISPLAYPORT pInterface,
         pbSrcCur += cbLineSrc;
     }
 
-    PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
+    if (fLock)
+        PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
 # ifdef DEBUG_sunlover
     LogFlow(("vgaR3PortCopyRect: completed.\n"));
 # endif
@@ -6413,6 +6589,10 @@ static DECLCALLBACK(int) vgaR3Destruct(PPDMDEVINS pDevIns)
         pThisCC->pbLogo = NULL;
     }
 
+    RTMemFree(pThisCC->pbDrawShadow);
+    pThisCC->pbDrawShadow = NULL;
+    pThisCC->cbDrawShadow = 0;
+
 # if defined(VBOX_WITH_VDMA) || defined(VBOX_WITH_WDDM)
     PDMDevHlpCritSectDelete(pDevIns, &pThis->CritSectIRQ);
 # endif
@@ -6518,9 +6698,13 @@ static DECLCALLBACK(int)   vgaR3Construct(PPDMDEVINS pDevIns, int iInstance, PCF
                                             "|VMSVGA3dEnabled"
                                             "|VMSVGA3dOverlayEnabled"
                                             "|VMSVGA3dMSAA"
+                                            "|VMSVGA3dShaderCacheDir"
                                             "|VMSVGA2dGBO"
 # endif
                                             "|SuppressNewYearSplash"
+# ifdef VBOX_WITH_HGSMI
+                                            "|VBVAFlushThreads"
+# endif
                                             "|3DEnabled";
 
     PDMDEV_VALIDATE_CONFIG_RETURN(pDevIns, s_szMscWorkaround, "");
@@ -6813,9 +6997,14 @@ static DECLCALLBACK(int)   vgaR3Construct(PPDMDEVINS pDevIns, int iInstance, PCF
 
         /*
          * The MDA/CGA/EGA/VGA/whatever fixed MMIO area.
+         *
+         * Writes only change VRAM and the latches, which the guest can only observe
+         * by reading the area (that flushes the buffered writes first) or thru the
+         * display, so allow the hypervisor to batch them up.
          */
         rc = PDMDevHlpMmioCreateExAndMap(pDevIns, 0x000a0000, 0x00020000,
-                                         IOMMMIO_FLAGS_READ_PASSTHRU | IOMMMIO_FLAGS_WRITE_PASSTHRU | IOMMMIO_FLAGS_ABS,
+                                         IOMMMIO_FLAGS_READ_PASSTHRU | IOMMMIO_FLAGS_WRITE_PASSTHRU | IOMMMIO_FLAGS_ABS
+                                         | IOMMMIO_FLAGS_COALESCE_WRITES,
                                          NULL /*pPciDev*/, UINT32_MAX /*iPciRegion*/,
                                          vgaMmioWrite, vgaMmioRead, vgaMmioFill, NULL /*pvUser*/,
                                          "VGA - VGA Video Buffer", &pThis->hMmioLegacy);
@@ -7368,6 +7557,8 @@ static DECLCALLBACK(int)   vgaR3Construct(PPDMDEVINS pDevIns, int iInstance, PCF
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatMapPage,       STAMTYPE_COUNTER, "MapPageCalls",  STAMUNIT_OCCURENCES,     "Calls to IOMMmioMapMmio2Page.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatMapReset,      STAMTYPE_COUNTER, "MapPageReset",  STAMUNIT_OCCURENCES,     "Calls to IOMMmioResetRegion.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatUpdateDisp,    STAMTYPE_COUNTER, "UpdateDisplay", STAMUNIT_OCCURENCES,     "Calls to vgaR3PortUpdateDisplay().");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDrawLinesUnchanged, STAMTYPE_COUNTER, "DrawLinesUnchanged", STAMUNIT_OCCURENCES, "Dirty scanlines identical to the last conversion.");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDrawTilesConverted, STAMTYPE_COUNTER, "DrawTilesConverted", STAMUNIT_OCCURENCES, "Scanline tiles converted because they changed.");
 # endif
 # ifdef VBOX_WITH_HGSMI
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatHgsmiMdaCgaAccesses, STAMTYPE_COUNTER, "HgmsiMdaCgaAccesses", STAMUNIT_OCCURENCES, "Number of non-HGMSI accesses for 03b0-3b3 and 03d0-3d3.");
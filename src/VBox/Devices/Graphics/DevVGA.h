@@ -521,6 +521,8 @@ typedef struct VGAState
     STAMCOUNTER                 StatMapPage;            /**< Counts IOMMmioMapMmio2Page calls.  */
     STAMCOUNTER                 StatMapReset;           /**< Counts IOMMmioResetRegion calls.  */
     STAMCOUNTER                 StatUpdateDisp;         /**< Counts vgaPortUpdateDisplay calls.  */
+    STAMCOUNTER                 StatDrawLinesUnchanged; /**< Dirty scanlines identical to the shadow copy. */
+    STAMCOUNTER                 StatDrawTilesConverted; /**< Scanline tiles converted after a shadow mismatch. */
 #ifdef VBOX_WITH_HGSMI
     STAMCOUNTER                 StatHgsmiMdaCgaAccesses;
 #endif
@@ -556,6 +558,8 @@ typedef struct VGASTATER3
     PPDMDEVINSR3                pDevIns;
 #ifdef VBOX_WITH_HGSMI
     R3PTRTYPE(PHGSMIINSTANCE)   pHGSMI;
+    /** Set while the VBVA screens are flushed on several threads, see vbvaFlush. */
+    bool volatile               fVBVAParallelFlush;
 #endif
 #ifdef VBOX_WITH_VDMA
     R3PTRTYPE(PVBOXVDMAHOST)    pVdma;
@@ -635,6 +639,20 @@ typedef struct VGASTATER3
     uint16_t                    Padding7[2];
     /** @} */
 
+    /** @name Shadow of the VRAM last converted by vgaR3DrawGraphic (linear modes)
+     * @{ */
+    /** Copy of the source bytes of each displayed scanline. */
+    R3PTRTYPE(uint8_t *)        pbDrawShadow;
+    /** Size of the pbDrawShadow allocation. */
+    size_t                      cbDrawShadow;
+    /** Bytes per scanline the shadow content is for, 0 if the content is invalid. */
+    uint32_t                    cbDrawShadowLine;
+    /** Number of scanlines the shadow content is for. */
+    uint32_t                    cDrawShadowLines;
+    /** The framebuffer the shadow content was converted into. */
+    R3PTRTYPE(uint8_t *)        pbDrawShadowTarget;
+    /** @} */
+
 } VGASTATER3;
 /** Pointer to the ring-3 VGA state. */
 typedef VGASTATER3 *PVGASTATER3;
@@ -40,6 +40,7 @@
 #include <iprt/alloc.h>
 #include <iprt/assert.h>
 #include <iprt/asm.h>
+#include <iprt/mp.h>
 #include <iprt/string.h>
 #include <iprt/param.h>
 
@@ -99,6 +100,9 @@ typedef struct VBVAMOUSESHAPEINFO
     uint8_t *pu8Shape;
 } VBVAMOUSESHAPEINFO;
 
+/** Maximum number of threads helping to flush the VBVA buffers of the secondary screens. */
+#define VBVA_FLUSH_MAX_THREADS 7
+
 /** @todo saved state: save and restore VBVACONTEXT */
 typedef struct VBVACONTEXT
 {
@@ -107,6 +111,18 @@ typedef struct VBVACONTEXT
     VBVAMOUSESHAPEINFO mouseShapeInfo;
     bool fPaused;
     VBVAMODEHINT aModeHints[VBOX_VIDEO_MAX_SCREENS];
+
+    /** Parallel flush of the secondary screens, see vbvaFlush. */
+    struct
+    {
+        uint32_t          cThreads;                              /**< Number of worker threads. */
+        PPDMTHREAD        apThreads[VBVA_FLUSH_MAX_THREADS];     /**< The worker threads. */
+        SUPSEMEVENT       ahEvtWork[VBVA_FLUSH_MAX_THREADS];     /**< Wakes up the corresponding worker. */
+        SUPSEMEVENT       hEvtDone;                              /**< Signalled by the worker completing the last screen. */
+        uint32_t volatile idxNext;                               /**< The next screen to be claimed. */
+        uint32_t volatile cPending;                              /**< Number of secondary screens not completed yet. */
+        int32_t volatile  rc;                                    /**< The first failure status. */
+    } flush;
 } VBVACONTEXT;
 
 
@@ -508,19 +524,131 @@ static int vbvaFlushProcess(PVGASTATECC pThisCC, VBVADATA *pVBVAData, unsigned u
     return VINF_SUCCESS;
 }
 
+/**
+ * Claims and processes secondary screens until there are none left.
+ *
+ * @returns true if the caller completed the last pending screen.
+ * @param   pThisCC     The VGA state, ring-3 part.
+ * @param   pCtx        The VBVA context.
+ * @thread  The thread flushing VBVA (owning the device lock) or a flush worker.
+ */
+static bool vbvaFlushScreens(PVGASTATECC pThisCC, VBVACONTEXT *pCtx)
+{
+    bool fLast = false;
+    for (;;)
+    {
+        uint32_t const uScreenId = ASMAtomicIncU32(&pCtx->flush.idxNext) - 1;
+        if (uScreenId >= pCtx->cViews)
+            break;
+
+        VBVADATA *pVBVAData = &pCtx->aViews[uScreenId].vbva;
+        if (pVBVAData->guest.pVBVA)
+        {
+            int rc = vbvaFlushProcess(pThisCC, pVBVAData, uScreenId);
+            if (RT_FAILURE(rc))
+                ASMAtomicCmpXchgS32(&pCtx->flush.rc, rc, VINF_SUCCESS);
+        }
+
+        fLast = ASMAtomicDecU32(&pCtx->flush.cPending) == 0;
+    }
+    return fLast;
+}
+
+/**
+ * @callback_method_impl{FNPDMTHREADDEV, VBVA flush worker.}
+ */
+static DECLCALLBACK(int) vbvaR3FlushWorker(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    PVGASTATECC const pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVGASTATECC);
+    VBVACONTEXT      *pCtx    = (VBVACONTEXT *)HGSMIContext(pThisCC->pHGSMI);
+    uintptr_t const   idx     = (uintptr_t)pThread->pvUser;
+
+    if (pThread->enmState == PDMTHREADSTATE_INITIALIZING)
+        return VINF_SUCCESS;
+
+    while (pThread->enmState == PDMTHREADSTATE_RUNNING)
+    {
+        PDMDevHlpSUPSemEventWaitNoResume(pDevIns, pCtx->flush.ahEvtWork[idx], RT_INDEFINITE_WAIT);
+        if (pThread->enmState != PDMTHREADSTATE_RUNNING)
+            break;
+
+        if (vbvaFlushScreens(pThisCC, pCtx))
+            PDMDevHlpSUPSemEventSignal(pDevIns, pCtx->flush.hEvtDone);
+    }
+
+    return VINF_SUCCESS;
+}
+
+/**
+ * @callback_method_impl{FNPDMTHREADWAKEUPDEV}
+ */
+static DECLCALLBACK(int) vbvaR3FlushWorkerWakeUp(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    PVGASTATECC const pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVGASTATECC);
+    VBVACONTEXT      *pCtx    = (VBVACONTEXT *)HGSMIContext(pThisCC->pHGSMI);
+    return PDMDevHlpSUPSemEventSignal(pDevIns, pCtx->flush.ahEvtWork[(uintptr_t)pThread->pvUser]);
+}
+
+/**
+ * Processes the VBVA buffers of all screens.
+ *
+ * The primary screen is always processed by the calling thread, because the display
+ * connector may call back into the device for it.  The secondary screens are claimed
+ * one by one by the calling thread and the flush workers, so that several monitors
+ * are processed in parallel.  The caller owns the device lock and waits for the workers;
+ * vgaR3PortCopyRect does not take the lock while pThisCC->fVBVAParallelFlush is set.
+ */
 static int vbvaFlush(PVGASTATE pThis, PVGASTATECC pThisCC, VBVACONTEXT *pCtx)
 {
     int rc = VINF_SUCCESS;
 
     unsigned uScreenId;
-    for (uScreenId = 0; uScreenId < pCtx->cViews; uScreenId++)
+    PPDMDEVINS const pDevIns  = pThisCC->pDevIns;
+    uint32_t         cWorkers = 0;
+    for (uint32_t i = 0; i < pCtx->flush.cThreads; i++)
+        if (pCtx->flush.apThreads[i] && pCtx->flush.apThreads[i]->enmState == PDMTHREADSTATE_RUNNING)
+            cWorkers++;
+
+    if (cWorkers && pCtx->cViews > 1)
     {
-        VBVADATA *pVBVAData = &pCtx->aViews[uScreenId].vbva;
-        if (pVBVAData->guest.pVBVA)
+        ASMAtomicWriteS32(&pCtx->flush.rc, VINF_SUCCESS);
+        ASMAtomicWriteU32(&pCtx->flush.cPending, pCtx->cViews - 1);
+        ASMAtomicWriteU32(&pCtx->flush.idxNext, 1);
+        ASMAtomicWriteBool(&pThisCC->fVBVAParallelFlush, true);
+
+        for (uint32_t i = 0; i < pCtx->flush.cThreads; i++)
+            if (pCtx->flush.apThreads[i])
+                PDMDevHlpSUPSemEventSignal(pDevIns, pCtx->flush.ahEvtWork[i]);
+
+        if (pCtx->aViews[0].vbva.guest.pVBVA)
+            rc = vbvaFlushProcess(pThisCC, &pCtx->aViews[0].vbva, 0);
+
+        /* Help with the secondary screens, then wait for the screens claimed by the workers. */
+        if (!vbvaFlushScreens(pThisCC, pCtx))
         {
-            rc = vbvaFlushProcess(pThisCC, pVBVAData, uScreenId);
-            if (RT_FAILURE(rc))
-                break;
+            int rc2;
+            do
+                rc2 = PDMDevHlpSUPSemEventWaitNoResume(pDevIns, pCtx->flush.hEvtDone, RT_INDEFINITE_WAIT);
+            while (rc2 == VERR_INTERRUPTED);
+            AssertRC(rc2);
+        }
+
+        ASMAtomicWriteBool(&pThisCC->fVBVAParallelFlush, false);
+
+        if (RT_SUCCESS(rc))
+            rc = ASMAtomicReadS32(&pCtx->flush.rc);
+    }
+    else
+    {
+        for (uScreenId = 0; uScreenId < pCtx->cViews; uScreenId++)
+        {
+            VBVADATA *pVBVAData = &pCtx->aViews[uScreenId].vbva;
+            if (pVBVAData->guest.pVBVA)
+            {
+                rc = vbvaFlushProcess(pThisCC, pVBVAData, uScreenId);
+                if (RT_FAILURE(rc))
+                    break;
+            }
         }
     }
 
@@ -1958,6 +2086,38 @@ int VBVAInit(PPDMDEVINS pDevIns, PVGASTATE pThis, PVGASTATECC pThisCC)
              pCtx->cViews = pThis->cMonitors;
              pCtx->fPaused = true;
              memset(pCtx->aModeHints, ~0, sizeof(pCtx->aModeHints));
+
+             /*
+              * Worker threads for flushing the secondary screens in parallel.  By default one
+              * per secondary screen, limited by the number of host CPUs.
+              */
+             uint32_t cThreads = UINT32_MAX;
+             rc = pDevIns->pHlpR3->pfnCFGMQueryU32Def(pDevIns->pCfg, "VBVAFlushThreads", &cThreads, UINT32_MAX);
+             AssertLogRelRCReturn(rc, rc);
+             if (cThreads == UINT32_MAX)
+             {
+                 RTCPUID const cCpus = RTMpGetOnlineCount();
+                 cThreads = cCpus > 1 ? (uint32_t)cCpus - 1 : 0;
+             }
+             cThreads = RT_MIN(RT_MIN(cThreads, pCtx->cViews - 1), VBVA_FLUSH_MAX_THREADS);
+             if (cThreads)
+             {
+                 rc = PDMDevHlpSUPSemEventCreate(pDevIns, &pCtx->flush.hEvtDone);
+                 AssertLogRelRCReturn(rc, rc);
+                 for (uint32_t i = 0; i < cThreads; i++)
+                 {
+                     pCtx->flush.cThreads = i + 1;
+                     rc = PDMDevHlpSUPSemEventCreate(pDevIns, &pCtx->flush.ahEvtWork[i]);
+                     AssertLogRelRCReturn(rc, rc);
+
+                     char szName[16];
+                     RTStrPrintf(szName, sizeof(szName), "VBVAFlush%u", i);
+                     rc = PDMDevHlpThreadCreate(pDevIns, &pCtx->flush.apThreads[i], (void *)(uintptr_t)i, vbvaR3FlushWorker,
+                                                vbvaR3FlushWorkerWakeUp, 0, RTTHREADTYPE_IO, szName);
+                     AssertLogRelRCReturn(rc, rc);
+                 }
+                 LogRel(("VBVA: Flushing %u screens using %u additional threads\n", pCtx->cViews, cThreads));
+             }
          }
      }
 
@@ -1971,6 +2131,27 @@ void VBVADestroy(PVGASTATECC pThisCC)
     if (pHgsmi)
     {
         VBVACONTEXT *pCtx = (VBVACONTEXT *)HGSMIContext(pHgsmi);
+        PPDMDEVINS pDevIns = pThisCC->pDevIns;
+        for (uint32_t i = 0; i < pCtx->flush.cThreads; i++)
+        {
+            if (pCtx->flush.apThreads[i])
+            {
+                PDMDevHlpThreadDestroy(pDevIns, pCtx->flush.apThreads[i], NULL);
+                pCtx->flush.apThreads[i] = NULL;
+            }
+            if (pCtx->flush.ahEvtWork[i] != NIL_SUPSEMEVENT)
+            {
+                PDMDevHlpSUPSemEventClose(pDevIns, pCtx->flush.ahEvtWork[i]);
+                pCtx->flush.ahEvtWork[i] = NIL_SUPSEMEVENT;
+            }
+        }
+        pCtx->flush.cThreads = 0;
+        if (pCtx->flush.hEvtDone != NIL_SUPSEMEVENT)
+        {
+            PDMDevHlpSUPSemEventClose(pDevIns, pCtx->flush.hEvtDone);
+            pCtx->flush.hEvtDone = NIL_SUPSEMEVENT;
+        }
+
         pCtx->mouseShapeInfo.fSet = false;
         RTMemFreeZ(pCtx->mouseShapeInfo.pu8Shape, pCtx->mouseShapeInfo.cbAllocated);
         pCtx->mouseShapeInfo.pu8Shape = NULL;
@@ -183,12 +183,18 @@ typedef struct HGSMIINSTANCE
 
     RTLISTANCHOR hostFIFO;             /**< Pending host buffers. */
     RTLISTANCHOR hostFIFORead;         /**< Host buffers read by the guest. */
-    RTLISTANCHOR hostFIFOProcessed;    /**< Processed by the guest. */
-    RTLISTANCHOR hostFIFOFree;         /**< Buffers for reuse. */
+    RTLISTANCHOR hostFIFOProcessed;    /**< Processed by the guest. The host heap buffers of these
+                                        * entries are released in a batch by the next host heap
+                                        * allocation, see hgsmiHostHeapReclaim. */
+    RTLISTANCHOR hostFIFOFree;         /**< Entries for reuse. */
 #ifdef VBOX_WITH_WDDM
     RTLISTANCHOR guestCmdCompleted;    /**< list of completed guest commands to be returned to the guest*/
+    RTLISTANCHOR guestCmdCompletedFree; /**< Completion entries for reuse. */
+    bool fGuestCmdCompletedNotified;   /**< Whether the guest was notified about the current
+                                        * content of guestCmdCompleted. */
 #endif
-    RTCRITSECT hostFIFOCritSect;       /**< FIFO serialization lock. */
+    RTCRITSECT hostFIFOCritSect;       /**< FIFO serialization lock. Taken after hostHeapCritSect
+                                        * if both are needed. */
 
     PFNHGSMINOTIFYGUEST pfnNotifyGuest; /**< Guest notification callback. */
     void *pvNotifyGuest;                /**< Guest notification callback context. */
@@ -224,8 +230,6 @@ typedef struct HGSMIHOSTFIFOENTRY
 #define HGSMI_F_HOST_FIFO_FREE      0x0010
 #define HGSMI_F_HOST_FIFO_CANCELED  0x0020
 
-static DECLCALLBACK(void) hgsmiHostCommandFreeCallback(void *pvCallback);
-
 #ifdef VBOX_WITH_WDDM
 
 typedef struct HGSMIGUESTCOMPLENTRY
@@ -253,6 +257,19 @@ static int hgsmiGuestCompletionFIFOAlloc(HGSMIINSTANCE *pIns, HGSMIGUESTCOMPLENT
     return VERR_NO_MEMORY;
 }
 
+/** Gets a completion entry from the free list or allocates a new one.
+ * @thread Caller owns hostFIFOCritSect. */
+static int hgsmiGuestCompletionFIFOAllocLocked(HGSMIINSTANCE *pIns, HGSMIGUESTCOMPLENTRY **ppEntry)
+{
+    HGSMIGUESTCOMPLENTRY *pEntry = RTListRemoveFirst(&pIns->guestCmdCompletedFree, HGSMIGUESTCOMPLENTRY, nodeEntry);
+    if (pEntry)
+    {
+        *ppEntry = pEntry;
+        return VINF_SUCCESS;
+    }
+    return hgsmiGuestCompletionFIFOAlloc(pIns, ppEntry);
+}
+
 #endif /* VBOX_WITH_WDDM */
 
 static int hgsmiLock(HGSMIINSTANCE *pIns)
@@ -306,24 +323,24 @@ static HGSMIOFFSET hgsmiProcessGuestCmdCompletion(HGSMIINSTANCE *pIns)
         if (pEntry)
         {
             RTListNodeRemove(&pEntry->nodeEntry);
+
+            offCmd = pEntry->offBuffer;
+
+            LogFlowFunc(("host FIFO head %p.\n", pEntry));
+
+            RTListAppend(&pIns->guestCmdCompletedFree, &pEntry->nodeEntry);
         }
 
         if (RTListIsEmpty(&pIns->guestCmdCompleted))
         {
             if (pIns->pHGFlags)
                 ASMAtomicAndU32(&pIns->pHGFlags->u32HostFlags, ~HGSMIHOSTFLAGS_GCOMMAND_COMPLETED);
+
+            /* The next completion starts a new batch. */
+            pIns->fGuestCmdCompletedNotified = false;
         }
 
         hgsmiFIFOUnlock(pIns);
-
-        if (pEntry)
-        {
-            offCmd = pEntry->offBuffer;
-
-            LogFlowFunc(("host FIFO head %p.\n", pEntry));
-
-            hgsmiGuestCompletionFIFOFree(pIns, pEntry);
-        }
     }
     return offCmd;
 }
@@ -384,11 +401,11 @@ static bool hgsmiProcessHostCmdCompletion(HGSMIINSTANCE *pIns, HGSMIOFFSET offBu
             pEntry->fl &= ~HGSMI_F_HOST_FIFO_READ;
             pEntry->fl |= HGSMI_F_HOST_FIFO_PROCESSED;
 
+            /* The host heap buffer is released by the next allocation, so that the
+             * EMT does not have to take the heap lock here. */
             RTListAppend(&pIns->hostFIFOProcessed, &pEntry->nodeEntry);
 
             hgsmiFIFOUnlock(pIns);
-
-            hgsmiHostCommandFreeCallback(pEntry);
             return true;
         }
 
@@ -671,33 +688,69 @@ static void hgsmiHostFIFOFree(HGSMIHOSTFIFOENTRY *pEntry)
     RTMemFree(pEntry);
 }
 
-static int hgsmiHostCommandFreeByEntry (HGSMIHOSTFIFOENTRY *pEntry)
+/** Gets a FIFO entry from the free list or allocates a new one.
+ * @thread Caller owns hostFIFOCritSect. */
+static int hgsmiHostFIFOAllocLocked(HGSMIINSTANCE *pIns, HGSMIHOSTFIFOENTRY **ppEntry)
 {
-    LogFlowFunc(("offBuffer 0x%08X\n", pEntry->offBuffer));
+    HGSMIHOSTFIFOENTRY *pEntry = RTListRemoveFirst(&pIns->hostFIFOFree, HGSMIHOSTFIFOENTRY, nodeEntry);
+    if (pEntry)
+    {
+        pEntry->fl = HGSMI_F_HOST_FIFO_ALLOCATED;
+        *ppEntry = pEntry;
+        return VINF_SUCCESS;
+    }
+    return hgsmiHostFIFOAlloc(ppEntry);
+}
 
-    HGSMIINSTANCE *pIns = pEntry->pIns;
-    int rc = hgsmiFIFOLock(pIns);
-    if (RT_SUCCESS(rc))
+static void hgsmiHostFIFOFreeList(RTLISTANCHOR *pList)
+{
+    HGSMIHOSTFIFOENTRY *pIter, *pNext;
+    RTListForEachSafe(pList, pIter, pNext, HGSMIHOSTFIFOENTRY, nodeEntry)
     {
-        RTListNodeRemove(&pEntry->nodeEntry);
-        hgsmiFIFOUnlock(pIns);
+        RTListNodeRemove(&pIter->nodeEntry);
+        hgsmiHostFIFOFree(pIter);
+    }
+}
 
-        void RT_UNTRUSTED_VOLATILE_GUEST *pvData = HGSMIBufferDataFromOffset(&pIns->hostHeap.area, pEntry->offBuffer);
+/**
+ * Releases the host heap buffers of all commands processed by the guest since
+ * the last call and recycles their FIFO entries.
+ *
+ * Completions arrive on the EMT one by one, so rather than taking the heap lock
+ * for each of them, the buffers are collected on the hostFIFOProcessed list and
+ * released here in one batch.
+ *
+ * @thread Caller owns hostHeapCritSect.
+ */
+static void hgsmiHostHeapReclaim(HGSMIINSTANCE *pIns)
+{
+    RTLISTANCHOR listProcessed;
+    RTListInit(&listProcessed);
 
-        rc = hgsmiHostHeapLock(pIns);
-        if (RT_SUCCESS(rc))
-        {
-            /* Deallocate the host heap memory. */
-            hgsmiHostHeapDataFree(&pIns->hostHeap, pvData);
+    int rc = hgsmiFIFOLock(pIns);
+    if (RT_FAILURE(rc))
+        return;
+    RTListMove(&listProcessed, &pIns->hostFIFOProcessed);
+    hgsmiFIFOUnlock(pIns);
 
-            hgsmiHostHeapUnlock(pIns);
-        }
+    if (RTListIsEmpty(&listProcessed))
+        return;
 
-        hgsmiHostFIFOFree(pEntry);
+    HGSMIHOSTFIFOENTRY *pIter;
+    RTListForEach(&listProcessed, pIter, HGSMIHOSTFIFOENTRY, nodeEntry)
+    {
+        Assert(pIter->fl == (HGSMI_F_HOST_FIFO_ALLOCATED | HGSMI_F_HOST_FIFO_PROCESSED));
+        hgsmiHostHeapDataFree(&pIns->hostHeap, HGSMIBufferDataFromOffset(&pIns->hostHeap.area, pIter->offBuffer));
     }
 
-    LogFlowFunc(("%Rrc\n", rc));
-    return rc;
+    rc = hgsmiFIFOLock(pIns);
+    if (RT_SUCCESS(rc))
+    {
+        RTListConcatenate(&pIns->hostFIFOFree, &listProcessed);
+        hgsmiFIFOUnlock(pIns);
+    }
+    else
+        hgsmiHostFIFOFreeList(&listProcessed);
 }
 
 static int hgsmiHostCommandFree(HGSMIINSTANCE *pIns, void RT_UNTRUSTED_VOLATILE_GUEST *pvData)
@@ -748,41 +801,28 @@ static int hgsmiHostCommandFree(HGSMIINSTANCE *pIns, void RT_UNTRUSTED_VOLATILE_
     return rc;
 }
 
-static DECLCALLBACK(void) hgsmiHostCommandFreeCallback(void *pvCallback)
-{
-    /* Guest has processed the command. */
-    HGSMIHOSTFIFOENTRY *pEntry = (HGSMIHOSTFIFOENTRY *)pvCallback;
-
-    Assert(pEntry->fl == (HGSMI_F_HOST_FIFO_ALLOCATED | HGSMI_F_HOST_FIFO_PROCESSED));
-
-    /* This is a simple callback, just signal the event. */
-    hgsmiHostCommandFreeByEntry(pEntry);
-}
-
 static int hgsmiHostCommandWrite(HGSMIINSTANCE *pIns, HGSMIOFFSET offBuffer)
 {
     AssertPtrReturn(pIns->pHGFlags, VERR_WRONG_ORDER);
 
-    HGSMIHOSTFIFOENTRY *pEntry;
-    int rc = hgsmiHostFIFOAlloc(&pEntry);
+    int rc = hgsmiFIFOLock(pIns);
     if (RT_SUCCESS(rc))
     {
-        /* Initialize the new entry and add it to the FIFO. */
-        pEntry->fl |= HGSMI_F_HOST_FIFO_QUEUED;
-
-        pEntry->pIns = pIns;
-        pEntry->offBuffer = offBuffer;
-
-        rc = hgsmiFIFOLock(pIns);
+        HGSMIHOSTFIFOENTRY *pEntry;
+        rc = hgsmiHostFIFOAllocLocked(pIns, &pEntry);
         if (RT_SUCCESS(rc))
         {
+            /* Initialize the new entry and add it to the FIFO. */
+            pEntry->fl |= HGSMI_F_HOST_FIFO_QUEUED;
+
+            pEntry->pIns = pIns;
+            pEntry->offBuffer = offBuffer;
+
             ASMAtomicOrU32(&pIns->pHGFlags->u32HostFlags, HGSMIHOSTFLAGS_COMMANDS_PENDING);
             RTListAppend(&pIns->hostFIFO, &pEntry->nodeEntry);
-
-            hgsmiFIFOUnlock(pIns);
         }
-        else
-            hgsmiHostFIFOFree(pEntry);
+
+        hgsmiFIFOUnlock(pIns);
     }
 
     return rc;
@@ -837,6 +877,8 @@ DECLHIDDEN(int) HGSMIHostCommandAlloc(HGSMIINSTANCE *pIns, void RT_UNTRUSTED_VOL
     int rc = hgsmiHostHeapLock(pIns);
     if (RT_SUCCESS(rc))
     {
+        hgsmiHostHeapReclaim(pIns);
+
         void RT_UNTRUSTED_VOLATILE_GUEST *pvData = hgsmiHostHeapDataAlloc(&pIns->hostHeap, cbData, u8Channel, u16ChannelInfo);
         hgsmiHostHeapUnlock(pIns);
 
@@ -949,6 +991,9 @@ DECLHIDDEN(int) HGSMIHostHeapSetup(PHGSMIINSTANCE pIns, HGSMIOFFSET RT_UNTRUSTED
     int rc = hgsmiHostHeapLock(pIns);
     AssertRCReturn(rc, rc);
 
+    /* Release buffers of the commands already processed by the guest. */
+    hgsmiHostHeapReclaim(pIns);
+
     /* It is possible to change the heap only if there is no pending allocations. */
     ASSERT_GUEST_LOGREL_MSG_STMT_RETURN(pIns->hostHeap.cRefs == 0,
                                         ("HGSMI[%s]: host heap setup ignored. %d allocated.\n", pIns->pszName, pIns->hostHeap.cRefs),
@@ -1576,7 +1621,10 @@ DECLHIDDEN(int) HGSMICreate(PHGSMIINSTANCE *ppIns,
             RTListInit(&pIns->hostFIFORead);
             RTListInit(&pIns->hostFIFOProcessed);
             RTListInit(&pIns->hostFIFOFree);
+#ifdef VBOX_WITH_WDDM
             RTListInit(&pIns->guestCmdCompleted);
+            RTListInit(&pIns->guestCmdCompletedFree);
+#endif
 
             rc = HGSMIHostChannelRegister(pIns, HGSMI_CH_HGSMI, hgsmiChannelHandler, pIns);
         }
@@ -1608,6 +1656,13 @@ DECLHIDDEN(uint32_t) HGSMIReset(PHGSMIINSTANCE pIns)
     while (hgsmiProcessHostCmdCompletion(pIns, 0, true))
     {}
 
+    int rc = hgsmiHostHeapLock(pIns);
+    if (RT_SUCCESS(rc))
+    {
+        hgsmiHostHeapReclaim(pIns);
+        hgsmiHostHeapUnlock(pIns);
+    }
+
 #ifdef VBOX_WITH_WDDM
     while (hgsmiProcessGuestCmdCompletion(pIns) != HGSMIOFFSET_VOID)
     {}
@@ -1625,6 +1680,22 @@ DECLHIDDEN(void) HGSMIDestroy(PHGSMIINSTANCE pIns)
     if (pIns)
     {
         hgsmiHostHeapDestroy(&pIns->hostHeap);
+
+        /* The lists are not initialized if HGSMICreate failed early. */
+        if (RTCritSectIsInitialized(&pIns->hostFIFOCritSect))
+        {
+            hgsmiHostFIFOFreeList(&pIns->hostFIFO);
+            hgsmiHostFIFOFreeList(&pIns->hostFIFORead);
+            hgsmiHostFIFOFreeList(&pIns->hostFIFOProcessed);
+            hgsmiHostFIFOFreeList(&pIns->hostFIFOFree);
+#ifdef VBOX_WITH_WDDM
+            HGSMIGUESTCOMPLENTRY *pIter, *pNext;
+            RTListForEachSafe(&pIns->guestCmdCompleted, pIter, pNext, HGSMIGUESTCOMPLENTRY, nodeEntry)
+                hgsmiGuestCompletionFIFOFree(pIns, pIter);
+            RTListForEachSafe(&pIns->guestCmdCompletedFree, pIter, pNext, HGSMIGUESTCOMPLENTRY, nodeEntry)
+                hgsmiGuestCompletionFIFOFree(pIns, pIter);
+#endif
+        }
         if (RTCritSectIsInitialized(&pIns->hostHeapCritSect))
             RTCritSectDelete(&pIns->hostHeapCritSect);
         if (RTCritSectIsInitialized(&pIns->instanceCritSect))
@@ -1641,28 +1712,45 @@ DECLHIDDEN(void) HGSMIDestroy(PHGSMIINSTANCE pIns)
 
 #ifdef VBOX_WITH_WDDM
 
-static int hgsmiGuestCommandComplete(HGSMIINSTANCE *pIns, HGSMIOFFSET offMem)
+/**
+ * Queues a completed guest command.
+ *
+ * @returns VBox status code.
+ * @param   pIns        HGSMI instance.
+ * @param   offMem      Offset of the guest command buffer.
+ * @param   fDoIrq      Whether the guest should be notified.
+ * @param   pfNotify    Where to return whether the caller must notify the guest.  This
+ *                      is false if the guest has already been notified about a completion
+ *                      which it did not fetch yet: it reads the FIFO until it is empty, so
+ *                      one interrupt covers the whole batch.
+ */
+static int hgsmiGuestCommandComplete(HGSMIINSTANCE *pIns, HGSMIOFFSET offMem, bool fDoIrq, bool *pfNotify)
 {
-    HGSMIGUESTCOMPLENTRY *pEntry = NULL;
+    *pfNotify = false;
 
     AssertPtrReturn(pIns->pHGFlags, VERR_WRONG_ORDER);
-    int rc = hgsmiGuestCompletionFIFOAlloc(pIns, &pEntry);
+    int rc = hgsmiFIFOLock(pIns);
     AssertRC(rc);
     if (RT_SUCCESS(rc))
     {
-        pEntry->offBuffer = offMem;
-
-        rc = hgsmiFIFOLock(pIns);
+        HGSMIGUESTCOMPLENTRY *pEntry = NULL;
+        rc = hgsmiGuestCompletionFIFOAllocLocked(pIns, &pEntry);
         AssertRC(rc);
         if (RT_SUCCESS(rc))
         {
+            pEntry->offBuffer = offMem;
+
             RTListAppend(&pIns->guestCmdCompleted, &pEntry->nodeEntry);
             ASMAtomicOrU32(&pIns->pHGFlags->u32HostFlags, HGSMIHOSTFLAGS_GCOMMAND_COMPLETED);
 
-            hgsmiFIFOUnlock(pIns);
+            if (fDoIrq && !pIns->fGuestCmdCompletedNotified)
+            {
+                pIns->fGuestCmdCompletedNotified = true;
+                *pfNotify = true;
+            }
         }
-        else
-            hgsmiGuestCompletionFIFOFree(pIns, pEntry);
+
+        hgsmiFIFOUnlock(pIns);
     }
 
     return rc;
@@ -1670,13 +1758,14 @@ static int hgsmiGuestCommandComplete(HGSMIINSTANCE *pIns, HGSMIOFFSET offMem)
 
 static int hgsmiCompleteGuestCommand(PHGSMIINSTANCE pIns, HGSMIOFFSET offBuffer, bool fDoIrq)
 {
-    int rc = hgsmiGuestCommandComplete(pIns, offBuffer);
-    if (RT_SUCCESS (rc))
-    {
 #ifdef DEBUG_misha
-        Assert(fDoIrq);
+    Assert(fDoIrq);
 #endif
-        if (fDoIrq)
+    bool fNotify = false;
+    int rc = hgsmiGuestCommandComplete(pIns, offBuffer, fDoIrq, &fNotify);
+    if (RT_SUCCESS (rc))
+    {
+        if (fNotify)
         {
             /* Now guest can read the FIFO, the notification is informational. */
             hgsmiNotifyGuest (pIns);
@@ -370,6 +370,7 @@ static const struct E1kChips
 #define ICR_RXT0            UINT32_C(0x00000080)
 #define ICR_TXD_LOW         UINT32_C(0x00008000)
 #define RDTR_FPD            UINT32_C(0x80000000)
+#define RDTR_DELAY_MASK     UINT32_C(0x0000FFFF)
 
 #define PSRCTL_BSIZE0_MASK  UINT32_C(0x0000007F)
 #define PSRCTL_BSIZE0_SHIFT 0
@@ -1501,6 +1502,8 @@ typedef struct E1KSTATE
     uint16_t    u16Padding0;
     /** EMT: Last time the interrupt was acknowledged.  */
     uint64_t    u64AckedAt;
+    /** All: Last time the interrupt was raised (ITR throttling reference). */
+    uint64_t    u64IntRaisedAt;
     /** All: Used for eliminating spurious interrupts. */
     bool        fIntRaised;
     /** EMT: false if the cable is disconnected by the GUI. */
@@ -1515,9 +1518,15 @@ typedef struct E1KSTATE
     bool        fItrRxEnabled;
     /** All: Delay TX interrupts using TIDV/TADV. */
     bool        fTidEnabled;
-    bool        afPadding[2];
+    /** All: Delay RX interrupts using RDTR/RADV. */
+    bool        fRidEnabled;
+    bool        afPadding[1];
     /** Link up delay (in milliseconds). */
     uint32_t    cMsLinkUpDelay;
+    /** All: Frames received since the last interrupt was raised (statistics). */
+    uint32_t    cRxFramesSinceInt;
+    /** All: Frames transmitted since the last interrupt was raised (statistics). */
+    uint32_t    cTxFramesSinceInt;
 
     /** All: Device register storage. */
     E1KREGS32   regs;
@@ -1555,6 +1564,9 @@ typedef struct E1KSTATE
     uint32_t    nRxDFetched;
     /** RX: Index in cache of RX descriptor being processed. */
     uint32_t    iRxDCurrent;
+    /** RX: Index in cache of the first processed RX descriptor which has not
+     * been written back to the RX ring yet (see e1kRxDWriteBack). */
+    uint32_t    iRxDWriteBack;
 #endif /* E1K_WITH_RXD_CACHE */
 
     /** TX: Context used for TCP segmentation packets. */
@@ -1638,6 +1650,8 @@ typedef struct E1KSTATE
     STAMCOUNTER                         StatLateInts;
     STAMCOUNTER                         StatIntsRaised;
     STAMCOUNTER                         StatIntsPrevented;
+    STAMPROFILE                         StatRxFramesPerInt;
+    STAMPROFILE                         StatTxFramesPerInt;
     STAMPROFILEADV                      StatReceive;
     STAMPROFILEADV                      StatReceiveCRC;
     STAMPROFILEADV                      StatReceiveFilter;
@@ -1773,6 +1787,11 @@ typedef struct E1KSTATER3
 
     /** EMT: EEPROM emulation */
     E1kEEPROM               eeprom;
+
+    /** TX: Guest mapping cache for fetching TX descriptors (csTx), NULL if none. */
+    R3PTRTYPE(PPDMPHYSMAPCACHE) pTxPhysMapCache;
+    /** RX: Guest mapping cache for fetching RX descriptors (csRx), NULL if none. */
+    R3PTRTYPE(PPDMPHYSMAPCACHE) pRxPhysMapCache;
 } E1KSTATER3;
 /** Pointer to the E1000 ring-3 device state. */
 typedef E1KSTATER3 *PE1KSTATER3;
@@ -2659,11 +2678,15 @@ static void e1kR3HardReset(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KSTATECC pThi
     pThis->iTxDCurrent  = 0;
     pThis->fGSO         = false;
     pThis->cbTxAlloc    = 0;
+    if (pThisCC->pTxPhysMapCache) /* The guest may reuse the ring memory. */
+        PDMDevHlpPhysMapCacheFlush(pDevIns, pThisCC->pTxPhysMapCache);
     e1kCsTxLeave(pThis);
 # endif /* E1K_WITH_TXD_CACHE */
 # ifdef E1K_WITH_RXD_CACHE
     e1kR3CsRxEnterAsserted(pThis);
-    pThis->iRxDCurrent = pThis->nRxDFetched = 0;
+    pThis->iRxDCurrent = pThis->nRxDFetched = pThis->iRxDWriteBack = 0;
+    if (pThisCC->pRxPhysMapCache)
+        PDMDevHlpPhysMapCacheFlush(pDevIns, pThisCC->pRxPhysMapCache);
     e1kR3SetDType(pDevIns, GET_BITS(RCTL, DTYP), RFCTL & RFCTL_EXSTEN); /* Legacy as we zeroed the registers */
     e1kCsRxLeave(pThis);
 # endif /* E1K_WITH_RXD_CACHE */
@@ -2796,6 +2819,31 @@ DECLINLINE(unsigned) e1kRxDIsCacheEmpty(PE1KSTATE pThis)
     return pThis->iRxDCurrent >= pThis->nRxDFetched;
 }
 
+/**
+ * Reads descriptors from guest memory, going thru the given ring-3 mapping
+ * cache if available.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pCache      The mapping cache, NULL if none.  The caller must own
+ *                      the lock serializing it (csTx or csRx).
+ * @param   GCPhys      The guest physical address of the descriptors.
+ * @param   pvBuf       Where to store the descriptors.
+ * @param   cbRead      Number of bytes to read.
+ */
+DECLINLINE(void) e1kDescRead(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache, RTGCPHYS GCPhys, void *pvBuf, size_t cbRead)
+{
+#ifdef IN_RING3
+    if (pCache)
+    {
+        PDMDevHlpPhysMapCacheRead(pDevIns, pCache, GCPhys, pvBuf, cbRead);
+        return;
+    }
+#else
+    RT_NOREF(pCache);
+#endif
+    PDMDevHlpPCIPhysRead(pDevIns, GCPhys, pvBuf, cbRead);
+}
+
 /**
  * Load receive descriptors from guest memory. The caller needs to be in Rx
  * critical section.
@@ -2829,9 +2877,14 @@ DECLINLINE(unsigned) e1kRxDPrefetch(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KRXD
     if (nDescsToFetch == 0)
         return 0;
     E1KRXLDESC* pFirstEmptyDesc = &pThis->aRxDescriptors[pThis->nRxDFetched];
-    PDMDevHlpPCIPhysRead(pDevIns,
-                         ((uint64_t)RDBAH << 32) + RDBAL + nFirstNotLoaded * sizeof(E1KRXLDESC),
-                         pFirstEmptyDesc, nDescsInSingleRead * sizeof(E1KRXLDESC));
+#ifdef IN_RING3
+    PPDMPHYSMAPCACHE const pCache = PDMDEVINS_2_DATA_CC(pDevIns, PE1KSTATECC)->pRxPhysMapCache;
+#else
+    PPDMPHYSMAPCACHE const pCache = NULL;
+#endif
+    e1kDescRead(pDevIns, pCache,
+                ((uint64_t)RDBAH << 32) + RDBAL + nFirstNotLoaded * sizeof(E1KRXLDESC),
+                pFirstEmptyDesc, nDescsInSingleRead * sizeof(E1KRXLDESC));
     // uint64_t addrBase = ((uint64_t)RDBAH << 32) + RDBAL;
     // unsigned i, j;
     // for (i = pThis->nRxDFetched; i < pThis->nRxDFetched + nDescsInSingleRead; ++i)
@@ -2845,10 +2898,10 @@ DECLINLINE(unsigned) e1kRxDPrefetch(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KRXD
              nFirstNotLoaded, pRxdc->rdlen, pRxdc->rdh, pRxdc->rdt));
     if (nDescsToFetch > nDescsInSingleRead)
     {
-        PDMDevHlpPCIPhysRead(pDevIns,
-                             ((uint64_t)RDBAH << 32) + RDBAL,
-                             pFirstEmptyDesc + nDescsInSingleRead,
-                             (nDescsToFetch - nDescsInSingleRead) * sizeof(E1KRXLDESC));
+        e1kDescRead(pDevIns, pCache,
+                    ((uint64_t)RDBAH << 32) + RDBAL,
+                    pFirstEmptyDesc + nDescsInSingleRead,
+                    (nDescsToFetch - nDescsInSingleRead) * sizeof(E1KRXLDESC));
         // Assert(i == pThis->nRxDFetched  + nDescsInSingleRead);
         // for (j = 0; i < pThis->nRxDFetched + nDescsToFetch; ++i, ++j)
         // {
@@ -3067,7 +3120,9 @@ static void e1kPrintTDesc(PE1KSTATE pThis, E1KTXDESC *pDesc, const char *pszDir,
 /**
  * Raise an interrupt later.
  *
+ * @param   pDevIns     The device instance.
  * @param   pThis       The device state structure.
+ * @param   nsDeadline  How long to wait (in nanoseconds) before raising it.
  */
 DECLINLINE(void) e1kPostponeInterrupt(PPDMDEVINS pDevIns, PE1KSTATE pThis, uint64_t nsDeadline)
 {
@@ -3105,14 +3160,21 @@ static int e1kRaiseInterrupt(PPDMDEVINS pDevIns, PE1KSTATE pThis, int rcBusy, ui
         }
         else
         {
-            uint64_t tsNow = PDMDevHlpTimerGet(pDevIns, pThis->hIntTimer);
-            if (!!ITR && tsNow - pThis->u64AckedAt < ITR * 256
+            /*
+             * ITR specifies the minimum inter-interrupt interval in 256 ns units,
+             * so measure it from the time the previous interrupt was asserted and
+             * only wait for whatever remains of the interval.
+             */
+            uint64_t const tsNow      = PDMDevHlpTimerGet(pDevIns, pThis->hIntTimer);
+            uint64_t const cNsItr     = (uint64_t)ITR * 256;
+            uint64_t const cNsElapsed = tsNow - pThis->u64IntRaisedAt;
+            if (cNsItr && cNsElapsed < cNsItr
                 && pThis->fItrEnabled && (pThis->fItrRxEnabled || !(ICR & ICR_RXT0)))
             {
                 E1K_INC_ISTAT_CNT(pThis->uStatIntEarly);
-                E1kLog2(("%s e1kRaiseInterrupt: Too early to raise again: %d ns < %d ns.\n",
-                        pThis->szPrf, (uint32_t)(tsNow - pThis->u64AckedAt), ITR * 256));
-                e1kPostponeInterrupt(pDevIns, pThis, ITR * 256);
+                E1kLog2(("%s e1kRaiseInterrupt: Too early to raise again: %RU64 ns < %RU64 ns.\n",
+                        pThis->szPrf, cNsElapsed, cNsItr));
+                e1kPostponeInterrupt(pDevIns, pThis, cNsItr - cNsElapsed);
             }
             else
             {
@@ -3123,6 +3185,11 @@ static int e1kRaiseInterrupt(PPDMDEVINS pDevIns, PE1KSTATE pThis, int rcBusy, ui
                 PDMDevHlpTimerStop(pDevIns, pThis->hIntTimer);
                 E1K_INC_ISTAT_CNT(pThis->uStatInt);
                 STAM_COUNTER_INC(&pThis->StatIntsRaised);
+                STAM_PROFILE_ADD_PERIOD(&pThis->StatRxFramesPerInt, pThis->cRxFramesSinceInt);
+                STAM_PROFILE_ADD_PERIOD(&pThis->StatTxFramesPerInt, pThis->cTxFramesSinceInt);
+                pThis->cRxFramesSinceInt = 0;
+                pThis->cTxFramesSinceInt = 0;
+                pThis->u64IntRaisedAt    = tsNow;
                 /* Got at least one unmasked interrupt cause */
                 pThis->fIntRaised = true;
                 /* Raise(1) INTA(0) */
@@ -3159,6 +3226,51 @@ DECLINLINE(RTGCPHYS) e1kDescAddr(uint32_t baseHigh, uint32_t baseLow, uint32_t i
 }
 
 #ifdef IN_RING3 /* currently only used in ring-3 due to stack space requirements of the caller */
+# ifdef E1K_WITH_RXD_CACHE
+/**
+ * Write the processed RX descriptors which are still pending in the cache
+ * back to the RX ring.
+ *
+ * The descriptors are returned to the guest in batches instead of one by one
+ * (similar to the write-back threshold of the real hardware), which saves a
+ * guest memory write per descriptor. The pending descriptors are the ones
+ * between iRxDWriteBack and iRxDCurrent, they precede RDH in the ring and take
+ * at most two writes as the range may wrap around the end of the ring.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The device state structure.
+ * @param   pRxdc       The receive descriptor register context.
+ * @thread  RX
+ */
+static void e1kRxDWriteBack(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KRXDC pRxdc)
+{
+    Assert(e1kCsRxIsOwner(pThis));
+    uint32_t cPending = pThis->iRxDCurrent - pThis->iRxDWriteBack;
+    if (!cPending)
+        return;
+    Assert(pThis->iRxDWriteBack < pThis->iRxDCurrent && pThis->iRxDCurrent <= E1K_RXD_CACHE_SIZE);
+
+    uint32_t const cDescsTotal = pRxdc->rdlen / sizeof(E1KRXLDESC);
+    if (RT_LIKELY(cDescsTotal >= cPending))
+    {
+        uint32_t const idxFirst = (pRxdc->rdh + cDescsTotal - cPending) % cDescsTotal;
+        uint32_t const cFirst   = RT_MIN(cPending, cDescsTotal - idxFirst);
+        PDMDevHlpPCIPhysWrite(pDevIns, e1kDescAddr(RDBAH, RDBAL, idxFirst),
+                              &pThis->aRxDescriptors[pThis->iRxDWriteBack], cFirst * sizeof(E1KRXLDESC));
+        if (cPending > cFirst)
+            PDMDevHlpPCIPhysWrite(pDevIns, e1kDescAddr(RDBAH, RDBAL, 0),
+                                  &pThis->aRxDescriptors[pThis->iRxDWriteBack + cFirst],
+                                  (cPending - cFirst) * sizeof(E1KRXLDESC));
+        E1kLog3(("%s e1kRxDWriteBack: wrote back %u RX descriptors at %x, RDH=%x\n",
+                 pThis->szPrf, cPending, idxFirst, pRxdc->rdh));
+    }
+    else
+        E1kLog(("%s e1kRxDWriteBack: RX ring shrunk under us (RDLEN=%x), dropping %u descriptors\n",
+                pThis->szPrf, pRxdc->rdlen, cPending));
+    pThis->iRxDWriteBack = pThis->iRxDCurrent;
+}
+# endif /* E1K_WITH_RXD_CACHE */
+
 /**
  * Advance the head pointer of the receive descriptor queue.
  *
@@ -3190,8 +3302,9 @@ DECLINLINE(void) e1kAdvanceRDH(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KRXDC pRx
      */
     if (e1kRxDIsCacheEmpty(pThis))
     {
-        /* Cache is empty, reset it and check if we can fetch more. */
-        pThis->iRxDCurrent = pThis->nRxDFetched = 0;
+        /* Cache is empty, write back what is left in it, reset it and check if we can fetch more. */
+        e1kRxDWriteBack(pDevIns, pThis, pRxdc);
+        pThis->iRxDCurrent = pThis->nRxDFetched = pThis->iRxDWriteBack = 0;
         E1kLog3(("%s e1kAdvanceRDH: Rx cache is empty, RDH=%x RDT=%x "
                  "iRxDCurrent=%x nRxDFetched=%x\n",
                  pThis->szPrf, pRxdc->rdh, pRxdc->rdt, pThis->iRxDCurrent, pThis->nRxDFetched));
@@ -3216,6 +3329,10 @@ DECLINLINE(void) e1kAdvanceRDH(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KRXDC pRx
         E1kLogRel(("E1000: low on RX descriptors, RDH=%x RDT=%x len=%x threshold=%x\n", pRxdc->rdh, pRxdc->rdt, uRQueueLen, uMinRQThreshold));
         E1kLog2(("%s Low on RX descriptors, RDH=%x RDT=%x len=%x threshold=%x, raise an interrupt\n",
                  pThis->szPrf, pRxdc->rdh, pRxdc->rdt, uRQueueLen, uMinRQThreshold));
+#ifdef E1K_WITH_RXD_CACHE
+        /* The guest is going to look at the ring, make sure it is up to date. */
+        e1kRxDWriteBack(pDevIns, pThis, pRxdc);
+#endif
         E1K_INC_ISTAT_CNT(pThis->uStatIntRXDMT0);
         e1kRaiseInterrupt(pDevIns, pThis, VERR_SEM_BUSY, ICR_RXDMT0);
     }
@@ -3260,8 +3377,9 @@ DECLINLINE(E1KRXDESC *) e1kRxDGet(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KRXDC
     /* Check the cache first. */
     if (pThis->iRxDCurrent + pRxdc->descSize <= pThis->nRxDFetched)
         return (E1KRXDESC *)&pThis->aRxDescriptors[pThis->iRxDCurrent];
-    /* Cache is empty, reset it and check if we can fetch more. */
-    pThis->iRxDCurrent = pThis->nRxDFetched = 0;
+    /* Cache is empty, write back what is left in it, reset it and check if we can fetch more. */
+    e1kRxDWriteBack(pDevIns, pThis, pRxdc);
+    pThis->iRxDCurrent = pThis->nRxDFetched = pThis->iRxDWriteBack = 0;
     if (e1kRxDPrefetch(pDevIns, pThis, pRxdc) >= pRxdc->descSize)
         return (E1KRXDESC *)&pThis->aRxDescriptors[pThis->iRxDCurrent];
     /* Out of Rx descriptors. */
@@ -3271,7 +3389,8 @@ DECLINLINE(E1KRXDESC *) e1kRxDGet(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KRXDC
 
 /**
  * Return the RX descriptor obtained with e1kRxDGet() and advance the cache
- * pointer. The descriptor gets written back to the RXD ring.
+ * pointer. The descriptor gets written back to the RXD ring later, by
+ * e1kRxDWriteBack().
  *
  * @param   pDevIns     The device instance.
  * @param   pThis       The device state structure.
@@ -3287,7 +3406,6 @@ DECLINLINE(void) e1kRxDPut(PPDMDEVINS pDevIns, PE1KSTATE pThis, E1KRXDESC* pDesc
     // uint64_t addr = e1kDescAddr(RDBAH, RDBAL, RDH);
     // uint32_t rdh = RDH;
     // Assert(pThis->aRxDescAddr[pDesc - pThis->aRxDescriptors] == addr);
-    PDMDevHlpPCIPhysWrite(pDevIns, e1kDescAddr(RDBAH, RDBAL, pRxdc->rdh), pDesc, sizeof(E1KRXLDESC) * pRxdc->descSize);
     /*
      * We need to print the descriptor before advancing RDH as it may fetch new
      * descriptors into the cache.
@@ -3421,6 +3539,62 @@ struct E1kRxPacketOut_st
 };
 typedef struct E1kRxPacketOut_st E1KRXPOUT;
 
+#ifdef IN_RING3
+/**
+ * Let the guest know that received packets have been stored: write back the
+ * pending RX descriptors and either raise RXT0 or, if the guest asked for it
+ * via RDTR/RADV and RX delay timers are enabled, arm the delay timers.
+ *
+ * @param   pDevIns         The device instance.
+ * @param   pThis           The device state structure.
+ * @param   fOwnRxCs        Whether the caller owns the RX critical section
+ *                          (it is left in any case).
+ * @param   pRxdc           The receive descriptor register context if
+ *                          @a fOwnRxCs is true, NULL otherwise.
+ * @thread  RX
+ */
+static void e1kR3RxNotify(PPDMDEVINS pDevIns, PE1KSTATE pThis, bool fOwnRxCs, PE1KRXDC pRxdc)
+{
+# ifdef E1K_WITH_RXD_CACHE
+    E1KRXDC rxdc;
+    if (!fOwnRxCs)
+    {
+        int rcLock = e1kCsRxEnter(pThis, VERR_SEM_BUSY);
+        AssertRCReturnVoid(rcLock);
+        pRxdc = &rxdc;
+        if (RT_UNLIKELY(!e1kUpdateRxDContext(pDevIns, pThis, pRxdc, "e1kR3RxNotify")))
+        {
+            e1kCsRxLeave(pThis);
+            E1kLog(("%s e1kR3RxNotify: failed to update Rx context\n", pThis->szPrf));
+            return;
+        }
+    }
+    e1kRxDWriteBack(pDevIns, pThis, pRxdc);
+# else
+    RT_NOREF(pRxdc);
+    if (!fOwnRxCs)
+        return;
+# endif
+    e1kCsRxLeave(pThis);
+
+    /* Complete packets have been stored -- it is time to let the guest know. */
+    if (pThis->fRidEnabled && (RDTR & RDTR_DELAY_MASK))
+    {
+        /* Arm the timer to fire in RDTR usec (discard .024) */
+        e1kArmTimer(pDevIns, pThis, pThis->hRIDTimer, RDTR & RDTR_DELAY_MASK);
+        /* If absolute timer delay is enabled and the timer is not running yet, arm it. */
+        if (RADV != 0 && !PDMDevHlpTimerIsActive(pDevIns, pThis->hRADTimer))
+            e1kArmTimer(pDevIns, pThis, pThis->hRADTimer, RADV);
+    }
+    else
+    {
+        /* 0 delay means immediate interrupt */
+        E1K_INC_ISTAT_CNT(pThis->uStatIntRx);
+        e1kRaiseInterrupt(pDevIns, pThis, VERR_SEM_BUSY, ICR_RXT0);
+    }
+}
+#endif /* IN_RING3 */
+
 /**
  * Pad and store received packet.
  *
@@ -3433,8 +3607,12 @@ typedef struct E1kRxPacketOut_st E1KRXPOUT;
  * @param   pvBuf           The available data.
  * @param   cb              Number of bytes available in the buffer.
  * @param   status          Bit fields containing status info.
+ * @param   fNotify         Whether to let the guest know right away, false
+ *                          when the caller stores a burst of packets and
+ *                          calls e1kR3RxNotify() itself when done.
  */
-static int e1kHandleRxPacket(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KSTATECC pThisCC, const void *pvBuf, size_t cb, E1KRXDESC *pWBDesc)
+static int e1kHandleRxPacket(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KSTATECC pThisCC, const void *pvBuf, size_t cb,
+                             E1KRXDESC *pWBDesc, bool fNotify)
 {
 #if defined(IN_RING3) /** @todo Remove this extra copying, it's gonna make us run out of kernel / hypervisor stack! */
     uint8_t   rxPacket[E1K_MAX_RX_PKT_SIZE];
@@ -3528,6 +3706,7 @@ static int e1kHandleRxPacket(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KSTATECC pT
         E1K_INC_CNT32(PRC1522);
 
     E1K_INC_ISTAT_CNT(pThis->uStatRxFrm);
+    pThis->cRxFramesSinceInt++;
 
     while (cb > 0)
     {
@@ -3605,32 +3784,14 @@ static int e1kHandleRxPacket(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KSTATECC pT
 
     pThis->led.Actual.s.fReading = 0;
 
-    e1kCsRxLeave(pThis);
-# ifdef E1K_WITH_RXD_CACHE
-    /* Complete packet has been stored -- it is time to let the guest know. */
-#  ifdef E1K_USE_RX_TIMERS
-    if (RDTR)
-    {
-        /* Arm the timer to fire in RDTR usec (discard .024) */
-        e1kArmTimer(pThis, pThis->hRIDTimer, RDTR);
-        /* If absolute timer delay is enabled and the timer is not running yet, arm it. */
-        if (RADV != 0 && !PDMDevHlpTimerIsActive(pDevIns, pThis->hRADTimer))
-            e1kArmTimer(pThis, pThis->hRADTimer, RADV);
-    }
+    if (fNotify)
+        e1kR3RxNotify(pDevIns, pThis, true /*fOwnRxCs*/, &rxdc);
     else
-    {
-#  endif /* E1K_USE_RX_TIMERS */
-        /* 0 delay means immediate interrupt */
-        E1K_INC_ISTAT_CNT(pThis->uStatIntRx);
-        e1kRaiseInterrupt(pDevIns, pThis, VERR_SEM_BUSY, ICR_RXT0);
-#  ifdef E1K_USE_RX_TIMERS
-    }
-#  endif /* E1K_USE_RX_TIMERS */
-# endif /* E1K_WITH_RXD_CACHE */
+        e1kCsRxLeave(pThis);
 
     return VINF_SUCCESS;
 #else  /* !IN_RING3 */
-    RT_NOREF(pDevIns, pThis, pThisCC, pvBuf, cb, pWBDesc);
+    RT_NOREF(pDevIns, pThis, pThisCC, pvBuf, cb, pWBDesc, fNotify);
     return VERR_INTERNAL_ERROR_2;
 #endif /* !IN_RING3 */
 }
@@ -4450,10 +4611,11 @@ static int e1kRegWriteRDTR(PPDMDEVINS pDevIns, PE1KSTATE pThis, uint32_t offset,
     if (value & RDTR_FPD)
     {
         /* Flush requested, cancel both timers and raise interrupt */
-#ifdef E1K_USE_RX_TIMERS
-        e1kCancelTimer(pDevIns, pThis, pThis->hRIDTimer);
-        e1kCancelTimer(pDevIns, pThis, pThis->hRADTimer);
-#endif
+        if (pThis->fRidEnabled)
+        {
+            e1kCancelTimer(pDevIns, pThis, pThis->hRIDTimer);
+            e1kCancelTimer(pDevIns, pThis, pThis->hRADTimer);
+        }
         E1K_INC_ISTAT_CNT(pThis->uStatIntRDTR);
         return e1kRaiseInterrupt(pDevIns, pThis, VINF_IOM_R3_MMIO_WRITE, ICR_RXT0);
     }
@@ -4527,7 +4689,6 @@ static DECLCALLBACK(void) e1kR3TxAbsDelayTimer(PPDMDEVINS pDevIns, TMTIMERHANDLE
 }
 
 //# endif /* E1K_USE_TX_TIMERS */
-# ifdef E1K_USE_RX_TIMERS
 
 /**
  * @callback_method_impl{FNTMTIMERDEV, Receive Interrupt Delay Timer handler.}
@@ -4557,8 +4718,6 @@ static DECLCALLBACK(void) e1kR3RxAbsDelayTimer(PPDMDEVINS pDevIns, TMTIMERHANDLE
     e1kRaiseInterrupt(pDevIns, pThis, VERR_IGNORED, ICR_RXT0);
 }
 
-# endif /* E1K_USE_RX_TIMERS */
-
 /**
  * @callback_method_impl{FNTMTIMERDEV, Late Interrupt Timer handler.}
  */
@@ -5002,19 +5161,24 @@ DECLINLINE(unsigned) e1kTxDLoadMore(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KTXD
     if (nDescsToFetch == 0)
         return 0;
     E1KTXDESC* pFirstEmptyDesc = &pThis->aTxDescriptors[pThis->nTxDFetched];
-    PDMDevHlpPCIPhysRead(pDevIns,
-                         ((uint64_t)TDBAH << 32) + TDBAL + nFirstNotLoaded * sizeof(E1KTXDESC),
-                         pFirstEmptyDesc, nDescsInSingleRead * sizeof(E1KTXDESC));
+#ifdef IN_RING3
+    PPDMPHYSMAPCACHE const pCache = PDMDEVINS_2_DATA_CC(pDevIns, PE1KSTATECC)->pTxPhysMapCache;
+#else
+    PPDMPHYSMAPCACHE const pCache = NULL;
+#endif
+    e1kDescRead(pDevIns, pCache,
+                ((uint64_t)TDBAH << 32) + TDBAL + nFirstNotLoaded * sizeof(E1KTXDESC),
+                pFirstEmptyDesc, nDescsInSingleRead * sizeof(E1KTXDESC));
     E1kLog3(("%s Fetched %u TX descriptors at %08x%08x(0x%x), TDLEN=%08x, TDH=%08x, TDT=%08x\n",
              pThis->szPrf, nDescsInSingleRead,
              TDBAH, TDBAL + pTxdc->tdh * sizeof(E1KTXDESC),
              nFirstNotLoaded, pTxdc->tdlen, pTxdc->tdh, pTxdc->tdt));
     if (nDescsToFetch > nDescsInSingleRead)
     {
-        PDMDevHlpPCIPhysRead(pDevIns,
-                             ((uint64_t)TDBAH << 32) + TDBAL,
-                             pFirstEmptyDesc + nDescsInSingleRead,
-                             (nDescsToFetch - nDescsInSingleRead) * sizeof(E1KTXDESC));
+        e1kDescRead(pDevIns, pCache,
+                    ((uint64_t)TDBAH << 32) + TDBAL,
+                    pFirstEmptyDesc + nDescsInSingleRead,
+                    (nDescsToFetch - nDescsInSingleRead) * sizeof(E1KTXDESC));
         E1kLog3(("%s Fetched %u TX descriptors at %08x%08x\n",
                  pThis->szPrf, nDescsToFetch - nDescsInSingleRead,
                  TDBAH, TDBAL));
@@ -5126,6 +5290,7 @@ static void e1kTransmitFrame(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KSTATECC pT
     E1K_INC_CNT32(TPT);
     E1K_ADD_CNT64(TOTL, TOTH, cbFrame);
     E1K_INC_CNT32(GPTC);
+    pThis->cTxFramesSinceInt++;
     if (pSg && e1kIsBroadcast(pSg->aSegs[0].pvSeg))
         E1K_INC_CNT32(BPTC);
     else if (pSg && e1kIsMulticast(pSg->aSegs[0].pvSeg))
@@ -5181,7 +5346,7 @@ static void e1kTransmitFrame(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KSTATECC pT
             RT_ZERO(writeBackRxDescPart);
             /// @todo Implement loopback! Or not?
             //pThisCC->pRxOps->setPIF(pThis, writeBackRxDescPart, true);
-            e1kHandleRxPacket(pDevIns, pThis, pThisCC, pSg->aSegs[0].pvSeg, cbFrame, &writeBackRxDescPart);
+            e1kHandleRxPacket(pDevIns, pThis, pThisCC, pSg->aSegs[0].pvSeg, cbFrame, &writeBackRxDescPart, true /*fNotify*/);
             rc = VINF_SUCCESS;
         }
         e1kXmitFreeBuf(pThis, pThisCC);
@@ -8063,15 +8228,15 @@ static bool e1kR3AddressFilter(PE1KSTATE pThis, PE1KSTATECC pThisCC, const void
 }
 
 /**
- * @interface_method_impl{PDMINETWORKDOWN,pfnReceive}
+ * Checks whether incoming packets should be dropped because the VM is not
+ * running or the receiver is disabled.
+ *
+ * @returns true if the packets should be dropped.
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The device state structure.
  */
-static DECLCALLBACK(int) e1kR3NetworkDown_Receive(PPDMINETWORKDOWN pInterface, const void *pvBuf, size_t cb)
+static bool e1kR3ShouldDropRx(PPDMDEVINS pDevIns, PE1KSTATE pThis)
 {
-    PE1KSTATECC pThisCC = RT_FROM_MEMBER(pInterface, E1KSTATECC, INetworkDown);
-    PE1KSTATE   pThis   = pThisCC->pShared;
-    PPDMDEVINS  pDevIns = pThisCC->pDevInsR3;
-    int         rc      = VINF_SUCCESS;
-
     /*
      * Drop packets if the VM is not running yet/anymore.
      */
@@ -8080,15 +8245,37 @@ static DECLCALLBACK(int) e1kR3NetworkDown_Receive(PPDMINETWORKDOWN pInterface, c
         &&  enmVMState != VMSTATE_RUNNING_LS)
     {
         E1kLog(("%s Dropping incoming packet as VM is not running.\n", pThis->szPrf));
-        return VINF_SUCCESS;
+        return true;
     }
 
     /* Discard incoming packets in locked state */
     if (!(RCTL & RCTL_EN) || pThis->fLocked || !(STATUS & STATUS_LU))
     {
         E1kLog(("%s Dropping incoming packet as receive operation is disabled.\n", pThis->szPrf));
-        return VINF_SUCCESS;
+        return true;
     }
+    return false;
+}
+
+/**
+ * Filters and stores one incoming frame.
+ *
+ * @returns VBox status code.
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The device state structure.
+ * @param   pThisCC     The ring-3 device state.
+ * @param   pvBuf       The frame.
+ * @param   cb          The size of the frame.
+ * @param   fNotify     Whether to notify the guest right away, see
+ *                      e1kHandleRxPacket().
+ * @param   pfStored    Where to return whether the frame got past the filter
+ *                      and was stored.
+ */
+static int e1kR3ReceiveFrame(PPDMDEVINS pDevIns, PE1KSTATE pThis, PE1KSTATECC pThisCC, const void *pvBuf, size_t cb,
+                             bool fNotify, bool *pfStored)
+{
+    int rc = VINF_SUCCESS;
+    *pfStored = false;
 
     STAM_PROFILE_ADV_START(&pThis->StatReceive, a);
 
@@ -8109,7 +8296,8 @@ static DECLCALLBACK(int) e1kR3NetworkDown_Receive(PPDMINETWORKDOWN pInterface, c
     STAM_PROFILE_ADV_STOP(&pThis->StatReceiveFilter, a);
     if (fPassed)
     {
-        rc = e1kHandleRxPacket(pDevIns, pThis, pThisCC, pvBuf, cb, &writeBackRxDescPart);
+        rc = e1kHandleRxPacket(pDevIns, pThis, pThisCC, pvBuf, cb, &writeBackRxDescPart, fNotify);
+        *pfStored = true;
     }
     //e1kCsLeave(pThis);
     STAM_PROFILE_ADV_STOP(&pThis->StatReceive, a);
@@ -8117,6 +8305,76 @@ static DECLCALLBACK(int) e1kR3NetworkDown_Receive(PPDMINETWORKDOWN pInterface, c
     return rc;
 }
 
+/**
+ * @interface_method_impl{PDMINETWORKDOWN,pfnReceive}
+ */
+static DECLCALLBACK(int) e1kR3NetworkDown_Receive(PPDMINETWORKDOWN pInterface, const void *pvBuf, size_t cb)
+{
+    PE1KSTATECC pThisCC = RT_FROM_MEMBER(pInterface, E1KSTATECC, INetworkDown);
+    PE1KSTATE   pThis   = pThisCC->pShared;
+    PPDMDEVINS  pDevIns = pThisCC->pDevInsR3;
+
+    if (e1kR3ShouldDropRx(pDevIns, pThis))
+        return VINF_SUCCESS;
+
+    bool fStored;
+    return e1kR3ReceiveFrame(pDevIns, pThis, pThisCC, pvBuf, cb, true /*fNotify*/, &fStored);
+}
+
+/**
+ * @interface_method_impl{PDMINETWORKDOWN,pfnReceiveBurst}
+ *
+ * Stores all the frames first and only then writes back the RX descriptors
+ * and raises (or delays) the receive interrupt, once for the whole burst.
+ */
+static DECLCALLBACK(int) e1kR3NetworkDown_ReceiveBurst(PPDMINETWORKDOWN pInterface, PCPDMNETWORKRECVFRAME paFrames,
+                                                       uint32_t cFrames, uint32_t *pcDone)
+{
+    PE1KSTATECC pThisCC = RT_FROM_MEMBER(pInterface, E1KSTATECC, INetworkDown);
+    PE1KSTATE   pThis   = pThisCC->pShared;
+    PPDMDEVINS  pDevIns = pThisCC->pDevInsR3;
+
+    *pcDone = 0;
+    if (e1kR3ShouldDropRx(pDevIns, pThis))
+    {
+        *pcDone = cFrames;
+        return VINF_SUCCESS;
+    }
+
+    int      rc      = VINF_SUCCESS;
+    bool     fStored = false;
+    uint32_t iFrame;
+    for (iFrame = 0; iFrame < cFrames; iFrame++)
+    {
+        /* The caller made sure there is room for the first frame, check for the others. */
+        if (iFrame > 0 && RT_FAILURE(e1kR3CanReceive(pDevIns, pThis)))
+        {
+            rc = VERR_NET_NO_BUFFER_SPACE;
+            break;
+        }
+
+        if (RT_UNLIKELY(paFrames[iFrame].pGso))
+        {
+            /* We never ask for segmentation offloading on the receive side. */
+            E1kLog(("%s e1kR3NetworkDown_ReceiveBurst: Dropping GSO frame #%u\n", pThis->szPrf, iFrame));
+            continue;
+        }
+
+        bool fFrameStored;
+        int rc2 = e1kR3ReceiveFrame(pDevIns, pThis, pThisCC, paFrames[iFrame].pvFrame, paFrames[iFrame].cbFrame,
+                                    false /*fNotify*/, &fFrameStored);
+        if (RT_FAILURE(rc2))
+            E1kLog(("%s e1kR3NetworkDown_ReceiveBurst: Dropped frame #%u: %Rrc\n", pThis->szPrf, iFrame, rc2));
+        fStored |= fFrameStored;
+    }
+
+    if (fStored)
+        e1kR3RxNotify(pDevIns, pThis, false /*fOwnRxCs*/, NULL);
+
+    *pcDone = iFrame;
+    return rc;
+}
+
 
 /* -=-=-=-=- PDMILEDPORTS -=-=-=-=- */
 
@@ -8560,6 +8818,8 @@ static DECLCALLBACK(int) e1kR3LoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uint
         pHlp->pfnSSMGetMem(pSSM, &pThis->aRecAddr, sizeof(pThis->aRecAddr));
         pHlp->pfnSSMGetMem(pSSM, &pThis->auVFTA, sizeof(pThis->auVFTA));
         pHlp->pfnSSMGetU64(pSSM, &pThis->u64AckedAt);
+        /* The last raise time is not saved, the last ack is a close enough approximation. */
+        pThis->u64IntRaisedAt = pThis->u64AckedAt;
         pHlp->pfnSSMGetU16(pSSM, &pThis->u16RxBSize);
         //pHlp->pfnSSMGetBool(pSSM, pThis->fDelayInts);
         //pHlp->pfnSSMGetBool(pSSM, pThis->fIntMaskUsed);
@@ -8605,7 +8865,7 @@ static DECLCALLBACK(int) e1kR3LoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uint
          * There is no point in storing the RX descriptor cache in the saved
          * state, we just need to make sure it is empty.
          */
-        pThis->iRxDCurrent = pThis->nRxDFetched = 0;
+        pThis->iRxDCurrent = pThis->nRxDFetched = pThis->iRxDWriteBack = 0;
 #endif /* E1K_WITH_RXD_CACHE */
         rc = pHlp->pfnSSMHandleGetStatus(pSSM);
         AssertRCReturn(rc, rc);
@@ -8922,6 +9182,7 @@ static DECLCALLBACK(void) e1kR3Reset(PPDMDEVINS pDevIns)
     pThis->fDelayInts   = false;
     pThis->fLocked      = false;
     pThis->u64AckedAt   = 0;
+    pThis->u64IntRaisedAt = 0;
     e1kR3HardReset(pDevIns, pThis, pThisCC);
 }
 
@@ -9169,6 +9430,7 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
     pThis->fDelayInts   = false;
     pThis->fLocked      = false;
     pThis->u64AckedAt   = 0;
+    pThis->u64IntRaisedAt = 0;
     pThis->led.u32Magic = PDMLED_MAGIC;
     pThis->u32PktNo     = 1;
     pThis->fIsAttached  = false;
@@ -9181,6 +9443,7 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
 
     pThisCC->INetworkDown.pfnWaitReceiveAvail = e1kR3NetworkDown_WaitReceiveAvail;
     pThisCC->INetworkDown.pfnReceive          = e1kR3NetworkDown_Receive;
+    pThisCC->INetworkDown.pfnReceiveBurst     = e1kR3NetworkDown_ReceiveBurst;
     pThisCC->INetworkDown.pfnXmitPending      = e1kR3NetworkDown_XmitPending;
 
     pThisCC->ILeds.pfnQueryStatusLed          = e1kR3QueryStatusLed;
@@ -9211,6 +9474,8 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
                                   "LineSpeed|"
                                   "ItrEnabled|"
                                   "ItrRxEnabled|"
+                                  "TidEnabled|"
+                                  "RidEnabled|"
                                   "EthernetCRC|"
                                   "GSOEnabled|"
                                   "LinkUpDelay|"
@@ -9262,6 +9527,11 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
         return PDMDEV_SET_ERROR(pDevIns, rc,
                                 N_("Configuration error: Failed to get the value of 'TidEnabled'"));
 
+    rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "RidEnabled", &pThis->fRidEnabled, false);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc,
+                                N_("Configuration error: Failed to get the value of 'RidEnabled'"));
+
     /*
      * Increased the link up delay from 3 to 5 seconds to make sure a guest notices the link loss
      * and updates its network configuration when the link is restored. See @bugref{10114}.
@@ -9281,13 +9551,14 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
     if (RT_FAILURE(rc))
         return PDMDEV_SET_ERROR(pDevIns, rc, N_("Configuration error: Failed to get the \"StatNo\" value"));
 
-    LogRel(("%s: Chip=%s LinkUpDelay=%ums EthernetCRC=%s GSO=%s Itr=%s ItrRx=%s TID=%s R0=%s RC=%s\n", pThis->szPrf,
+    LogRel(("%s: Chip=%s LinkUpDelay=%ums EthernetCRC=%s GSO=%s Itr=%s ItrRx=%s TID=%s RID=%s R0=%s RC=%s\n", pThis->szPrf,
             g_aChips[pThis->eChip].pcszName, pThis->cMsLinkUpDelay,
             pThis->fEthernetCRC ? "on" : "off",
             pThis->fGSOEnabled ? "enabled" : "disabled",
             pThis->fItrEnabled ? "enabled" : "disabled",
             pThis->fItrRxEnabled ? "enabled" : "disabled",
             pThis->fTidEnabled ? "enabled" : "disabled",
+            pThis->fRidEnabled ? "enabled" : "disabled",
             pDevIns->fR0Enabled ? "enabled" : "disabled",
             pDevIns->fRCEnabled ? "enabled" : "disabled"));
 
@@ -9355,6 +9626,14 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
 
         g_aE1kRegMap[EERD_IDX].pfnWrite = e1kRegWriteEERD82583;
     }
+
+    /* Guest mapping caches for the descriptor rings (optional, see e1kDescRead). */
+    rc = PDMDevHlpPhysMapCacheCreate(pDevIns, NULL /*pPciDev*/, 16 /*cEntries*/, "Tx", &pThisCC->pTxPhysMapCache);
+    if (RT_SUCCESS(rc))
+        rc = PDMDevHlpPhysMapCacheCreate(pDevIns, NULL /*pPciDev*/, 16 /*cEntries*/, "Rx", &pThisCC->pRxPhysMapCache);
+    if (RT_FAILURE(rc))
+        LogRel(("%s: Failed to create the descriptor mapping caches: %Rrc\n", pThis->szPrf, rc));
+
     /*
      * Map our registers to memory space (region 0, see e1kR3ConfigurePciDev)
      * From the spec (regarding flags):
@@ -9413,17 +9692,18 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
     }
 //#endif /* E1K_USE_TX_TIMERS */
 
-#ifdef E1K_USE_RX_TIMERS
-    /* Create Receive Interrupt Delay Timer */
-    rc = PDMDevHlpTimerCreate(pDevIns, TMCLOCK_VIRTUAL, e1kR3RxIntDelayTimer, pThis,
-                              TMTIMER_FLAGS_NO_CRIT_SECT | TMTIMER_FLAGS_RING0,  "E1000 Recv IRQ Delay", &pThis->hRIDTimer);
-    AssertRCReturn(rc, rc);
+    if (pThis->fRidEnabled)
+    {
+        /* Create Receive Interrupt Delay Timer */
+        rc = PDMDevHlpTimerCreate(pDevIns, TMCLOCK_VIRTUAL, e1kR3RxIntDelayTimer, pThis,
+                                  TMTIMER_FLAGS_NO_CRIT_SECT | TMTIMER_FLAGS_RING0,  "E1000 Recv IRQ Delay", &pThis->hRIDTimer);
+        AssertRCReturn(rc, rc);
 
-    /* Create Receive Absolute Delay Timer */
-    rc = PDMDevHlpTimerCreate(pDevIns, TMCLOCK_VIRTUAL, e1kR3RxAbsDelayTimer, pThis,
-                              TMTIMER_FLAGS_NO_CRIT_SECT | TMTIMER_FLAGS_RING0,  "E1000 Recv Abs Delay", &pThis->hRADTimer);
-    AssertRCReturn(rc, rc);
-#endif /* E1K_USE_RX_TIMERS */
+        /* Create Receive Absolute Delay Timer */
+        rc = PDMDevHlpTimerCreate(pDevIns, TMCLOCK_VIRTUAL, e1kR3RxAbsDelayTimer, pThis,
+                                  TMTIMER_FLAGS_NO_CRIT_SECT | TMTIMER_FLAGS_RING0,  "E1000 Recv Abs Delay", &pThis->hRADTimer);
+        AssertRCReturn(rc, rc);
+    }
 
     /* Create Late Interrupt Timer */
     rc = PDMDevHlpTimerCreate(pDevIns, TMCLOCK_VIRTUAL, e1kR3LateIntTimer, pThis,
@@ -9510,6 +9790,8 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatLateInts,           STAMTYPE_COUNTER, "LateInt/Occured",      STAMUNIT_OCCURENCES,     "Number of late interrupts");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntsRaised,         STAMTYPE_COUNTER, "Interrupts/Raised",    STAMUNIT_OCCURENCES,     "Number of raised interrupts");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntsPrevented,      STAMTYPE_COUNTER, "Interrupts/Prevented", STAMUNIT_OCCURENCES,     "Number of prevented interrupts");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatRxFramesPerInt,     STAMTYPE_PROFILE, "Interrupts/RxFramesPerInt", STAMUNIT_COUNT,      "Frames received per raised interrupt");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatTxFramesPerInt,     STAMTYPE_PROFILE, "Interrupts/TxFramesPerInt", STAMUNIT_COUNT,      "Frames transmitted per raised interrupt");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatReceive,            STAMTYPE_PROFILE, "Receive/Total",        STAMUNIT_TICKS_PER_CALL, "Profiling receive");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatReceiveCRC,         STAMTYPE_PROFILE, "Receive/CRC",          STAMUNIT_TICKS_PER_CALL, "Profiling receive checksumming");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatReceiveFilter,      STAMTYPE_PROFILE, "Receive/Filter",       STAMUNIT_TICKS_PER_CALL, "Profiling receive filtering");
@@ -393,7 +393,13 @@ typedef struct PCNETSTATE
     uint32_t                            uCntBadRMD;
     /** Emulated device type. */
     uint8_t                             uDevType;
-    bool                                afAlignment5[3];
+    /** Set if the last TDTE poll found the current transmit descriptor owned by
+     * the guest, i.e. there is nothing to transmit until the guest hands us more. */
+    bool                                fTxRingIdle;
+    /** Set once the guest has been seen kicking the transmitter through CSR0.TDMD,
+     * which allows us to stop polling an idle transmit ring. */
+    bool                                fGuestKicksTdmd;
+    bool                                afAlignment5[1];
     /** Link speed to be reported through CSR68. */
     uint32_t                            u32LinkSpeed;
     /** MS to wait before we enable the link. */
@@ -455,6 +461,8 @@ typedef struct PCNETSTATE
     STAMCOUNTER                         StatXmitSkipCurrent;
     STAMPROFILEADV                      StatInterrupt;
     STAMPROFILEADV                      StatPollTimer;
+    STAMCOUNTER                         StatPollTimerIdle;
+    STAMCOUNTER                         StatRdteCacheHit;
     STAMCOUNTER                         StatMIIReads;
 #endif /* VBOX_WITH_STATISTICS */
 } PCNETSTATE;
@@ -1471,6 +1479,7 @@ static void pcnetR3Init(PPDMDEVINS pDevIns, PPCNETSTATE pThis, PPCNETSTATECC pTh
     CSR_XMTRC(pThis) = CSR_XMTRL(pThis);
 
     /* Reset cached RX and TX states */
+    pThis->fTxRingIdle = false;
     CSR_CRST(pThis) = CSR_CRBC(pThis) = CSR_NRST(pThis) = CSR_NRBC(pThis) = 0;
     CSR_CXST(pThis) = CSR_CXBC(pThis) = CSR_NXST(pThis) = CSR_NXBC(pThis) = 0;
 
@@ -1551,7 +1560,8 @@ static void pcnetWakeupReceive(PPDMDEVINS pDevIns)
 static void pcnetRdtePoll(PPDMDEVINS pDevIns, PPCNETSTATE pThis, bool fSkipCurrent=false)
 {
     STAM_PROFILE_ADV_START(&pThis->CTX_SUFF_Z(StatRdtePoll), a);
-    /* assume lack of a next receive descriptor */
+    /* remember the cached next descriptor status, then assume lack of a next receive descriptor */
+    uint16_t const uNextRst = CSR_NRST(pThis);
     CSR_NRST(pThis) = 0;
 
     if (RT_LIKELY(pThis->GCRDRA))
@@ -1569,33 +1579,50 @@ static void pcnetRdtePoll(PPDMDEVINS pDevIns, PPCNETSTATE pThis, bool fSkipCurre
         if (!fSkipCurrent)
         {
             addr = pcnetRdraAddr(pThis, i);
-            CSR_CRDA(pThis) = CSR_CRBA(pThis) = 0;
-            CSR_CRBC(pThis) = CSR_CRST(pThis) = 0;
-            if (!pcnetRmdLoad(pDevIns, pThis, &rmd, PHYSADDR(pThis, addr), true))
+            if (   addr == CSR_NRDA(pThis)
+                && CARD_IS_OWNER(uNextRst)
+                && CSR_RCVRL(pThis) > 1)
             {
-                STAM_PROFILE_ADV_STOP(&pThis->CTX_SUFF_Z(StatRdtePoll), a);
-                return;
-            }
-            if (RT_LIKELY(!IS_RMD_BAD(rmd)))
-            {
-                CSR_CRDA(pThis) = addr;                        /* Receive Descriptor Address */
-                CSR_CRBA(pThis) = rmd.rmd0.rbadr;              /* Receive Buffer Address */
-                CSR_CRBC(pThis) = rmd.rmd1.bcnt;               /* Receive Byte Count */
-                CSR_CRST(pThis) = ((uint32_t *)&rmd)[1] >> 16; /* Receive Status */
+                /* The next descriptor was already loaded and we own it, so the guest
+                 * cannot have changed it since.  Promote it without re-reading it. */
+                STAM_COUNTER_INC(&pThis->StatRdteCacheHit);
+                CSR_CRDA(pThis) = addr;
+                CSR_CRBA(pThis) = CSR_NRBA(pThis);
+                CSR_CRBC(pThis) = CSR_NRBC(pThis);
+                CSR_CRST(pThis) = uNextRst;
                 if (pThis->fMaybeOutOfSpace)
                     pcnetWakeupReceive(pDevIns);
             }
             else
             {
-                STAM_PROFILE_ADV_STOP(&pThis->CTX_SUFF_Z(StatRdtePoll), a);
-                /* This is not problematic since we don't own the descriptor
-                 * We actually do own it, otherwise pcnetRmdLoad would have returned false.
-                 * Don't flood the release log with errors.
-                 */
-                if (++pThis->uCntBadRMD < 50)
-                    LogRel(("PCnet#%d: BAD RMD ENTRIES AT %#010x (i=%d)\n",
-                            PCNET_INST_NR, addr, i));
-                return;
+                CSR_CRDA(pThis) = CSR_CRBA(pThis) = 0;
+                CSR_CRBC(pThis) = CSR_CRST(pThis) = 0;
+                if (!pcnetRmdLoad(pDevIns, pThis, &rmd, PHYSADDR(pThis, addr), true))
+                {
+                    STAM_PROFILE_ADV_STOP(&pThis->CTX_SUFF_Z(StatRdtePoll), a);
+                    return;
+                }
+                if (RT_LIKELY(!IS_RMD_BAD(rmd)))
+                {
+                    CSR_CRDA(pThis) = addr;                        /* Receive Descriptor Address */
+                    CSR_CRBA(pThis) = rmd.rmd0.rbadr;              /* Receive Buffer Address */
+                    CSR_CRBC(pThis) = rmd.rmd1.bcnt;               /* Receive Byte Count */
+                    CSR_CRST(pThis) = ((uint32_t *)&rmd)[1] >> 16; /* Receive Status */
+                    if (pThis->fMaybeOutOfSpace)
+                        pcnetWakeupReceive(pDevIns);
+                }
+                else
+                {
+                    STAM_PROFILE_ADV_STOP(&pThis->CTX_SUFF_Z(StatRdtePoll), a);
+                    /* This is not problematic since we don't own the descriptor
+                     * We actually do own it, otherwise pcnetRmdLoad would have returned false.
+                     * Don't flood the release log with errors.
+                     */
+                    if (++pThis->uCntBadRMD < 50)
+                        LogRel(("PCnet#%d: BAD RMD ENTRIES AT %#010x (i=%d)\n",
+                                PCNET_INST_NR, addr, i));
+                    return;
+                }
             }
         }
 
@@ -1657,10 +1684,17 @@ static int pcnetTdtePoll(PPDMDEVINS pDevIns, PPCNETSTATE pThis, TMD *tmd)
 
         if (!pcnetTmdTryLoad(pDevIns, pThis, tmd, PHYSADDR(pThis, cxda)))
         {
+            pThis->fTxRingIdle = true;
             STAM_PROFILE_ADV_STOP(&pThis->CTX_SUFF_Z(StatTdtePoll), a);
             return 0;
         }
 
+        /* The ring is busy again, make sure the poller runs until we've drained it. */
+        if (   !CSR_DPOLL(pThis)
+            && !PDMDevHlpTimerIsActive(pDevIns, pThis->hTimerPoll))
+            pcnetPollTimerStart(pDevIns, pThis);
+        pThis->fTxRingIdle = false;
+
         if (RT_UNLIKELY(tmd->tmd1.ones != 15))
         {
             STAM_PROFILE_ADV_STOP(&pThis->CTX_SUFF_Z(StatTdtePoll), a);
@@ -1863,6 +1897,10 @@ static void pcnetReceiveNoSync(PPDMDEVINS pDevIns, PPCNETSTATE pThis, PPCNETSTAT
                 if (!pcnetRmdLoad(pDevIns, pThis, &next_rmd, PHYSADDR(pThis, next_crda), true))
                     break;
 
+                /* We're about to consume the descriptor pcnetRdtePoll() may have cached as next one. */
+                if (next_crda == CSR_NRDA(pThis))
+                    CSR_NRST(pThis) = 0;
+
                 /* Write back current descriptor, clear the own bit. */
                 pcnetRmdStorePassHost(pDevIns, pThis, &rmd, PHYSADDR(pThis, crda));
 
@@ -2699,7 +2737,19 @@ static void pcnetPollTimer(PPDMDEVINS pDevIns, PPCNETSTATE pThis, PPCNETSTATECC
             pcnetPollRxTx(pDevIns, pThis, pThisCC);
         }
         if (!PDMDevHlpTimerIsActive(pDevIns, pThis->hTimerPoll))
-            pcnetPollTimerStart(pDevIns, pThis);
+        {
+            /* Let the timer lapse while there is nothing to poll for: the transmit ring
+             * is empty and the guest rings TDMD when queuing frames, and nobody is waiting
+             * for receive buffers.  pcnetTdtePoll() and pcnetR3NetworkDown_WaitReceiveAvail()
+             * re-arm it as needed.  Guests relying purely on polling keep the 500Hz timer. */
+            if (   pThis->fTxRingIdle
+                && pThis->fGuestKicksTdmd
+                && !CSR_TDMD(pThis)
+                && !pThis->fMaybeOutOfSpace)
+                STAM_COUNTER_INC(&pThis->StatPollTimerIdle);
+            else
+                pcnetPollTimerStart(pDevIns, pThis);
+        }
     }
     STAM_PROFILE_ADV_STOP(&pThis->StatPollTimer, a);
 }
@@ -2781,6 +2831,8 @@ static VBOXSTRICTRC pcnetCSRWriteU16(PPDMDEVINS pDevIns, PPCNETSTATE pThis, PPCN
                 if (!CSR_STRT(pThis) && (val & 2))
                     pcnetStart(pDevIns, pThis);
 
+                if (val & 0x0008)
+                    pThis->fGuestKicksTdmd = true;
                 if (CSR_TDMD(pThis))
                     pcnetTransmit(pDevIns, pThis, pThisCC);
 
@@ -3283,6 +3335,10 @@ static void pcnetR3HardReset(PPDMDEVINS pDevIns, PPCNETSTATE pThis)
     int      i;
     uint16_t checksum;
 
+    /* Forget what we learned about the guest driver, the next one may rely on polling. */
+    pThis->fTxRingIdle     = false;
+    pThis->fGuestKicksTdmd = false;
+
     /* Lower any raised interrupts, see @bugref(9556) */
     if (RT_UNLIKELY(pThis->iISR))
     {
@@ -5298,6 +5354,8 @@ static DECLCALLBACK(int) pcnetR3Construct(PPDMDEVINS pDevIns, int iInstance, PCF
 
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatInterrupt,          STAMTYPE_PROFILE, "UpdateIRQ",          STAMUNIT_TICKS_PER_CALL,      "Profiling interrupt checks");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatPollTimer,          STAMTYPE_PROFILE, "PollTimer",          STAMUNIT_TICKS_PER_CALL,      "Profiling poll timer");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatPollTimerIdle,      STAMTYPE_COUNTER, "PollTimerIdle",      STAMUNIT_OCCURENCES,          "Number of times the poll timer was left stopped on an idle ring");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatRdteCacheHit,       STAMTYPE_COUNTER, "RdteCacheHit",       STAMUNIT_OCCURENCES,          "Number of current RDTEs taken from the cached next RDTE");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatMIIReads,           STAMTYPE_COUNTER, "MIIReads",           STAMUNIT_OCCURENCES,          "Number of MII reads");
     unsigned i;
     for (i = 0; i < RT_ELEMENTS(pThis->aStatXmitFlush) - 1; i++)
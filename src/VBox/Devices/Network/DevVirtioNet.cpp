@@ -57,12 +57,24 @@
 #ifdef IN_RING3
 # include <VBox/VBoxPktDmp.h>
 # include <iprt/alloc.h>
+# include <iprt/critsect.h>
 # include <iprt/memcache.h>
+# include <iprt/net.h>
 # include <iprt/semaphore.h>
 # include <iprt/sg.h>
 # include <iprt/param.h>
+# include <iprt/thread.h>
 # include <iprt/uuid.h>
 #endif
+#if defined(IN_RING3) && defined(RT_OS_LINUX)
+# define VIRTIONET_WITH_VHOST
+# include <errno.h>
+# include <fcntl.h>
+# include <poll.h>
+# include <unistd.h>
+# include <sys/eventfd.h>
+# include <sys/ioctl.h>
+#endif
 #include "../VirtIO/VirtioCore.h"
 
 #include "VBoxDD.h"
@@ -70,7 +82,9 @@
 #define VIRTIONET_TRANSITIONAL_ENABLE_FLAG             1       /** < If set behave as VirtIO "transitional" device  */
 
 /** The current saved state version for the virtio core. */
-#define VIRTIONET_SAVEDSTATE_VERSION                   UINT32_C(1)
+#define VIRTIONET_SAVEDSTATE_VERSION                   UINT32_C(3)
+/** The saved state version before the active queue pair count and RSS state were saved. */
+#define VIRTIONET_SAVEDSTATE_VERSION_PRE_MQ            UINT32_C(1)
 #define VIRTIONET_SAVEDSTATE_VERSION_3_1_BETA1_LEGACY  UINT32_C(1) /**< Grandfathered in from DevVirtioNet.cpp      */
 #define VIRTIONET_SAVEDSTATE_VERSION_LEGACY            UINT32_C(2) /**< Grandfathered in from DevVirtioNet.cpp      */
 #define VIRTIONET_VERSION_MARKER_MAC_ADDR { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } /**  SSM handling                  */
@@ -107,8 +121,80 @@
 #define VIRTIONET_F_GUEST_ANNOUNCE       RT_BIT_64(21)         /**< Driver can send gratuitous packets              */
 #define VIRTIONET_F_MQ                   RT_BIT_64(22)         /**< Support ultiqueue with auto receive steering    */
 #define VIRTIONET_F_CTRL_MAC_ADDR        RT_BIT_64(23)         /**< Set MAC address through control channel         */
+#define VIRTIONET_F_RSS                  RT_BIT_64(60)         /**< Device supports receive side scaling (VirtIO 1.1) */
 /** @} */
 
+#ifdef VIRTIONET_WITH_VHOST
+/** @name Linux vhost-net kernel interface (see linux/vhost.h).
+ *
+ * Defined here rather than including linux/vhost.h, which drags in the Linux
+ * virtio headers whose VIRTIO_F_XXX definitions clash with VirtioCore.h.
+ * @{ */
+/** Maximum number of guest memory regions passed to the kernel (the kernel
+ *  default for the vhost max_mem_regions module parameter). */
+# define VIRTIONET_VHOST_MAX_REGIONS        64
+/** Virtio features relating to the ring layout and notifications which
+ *  must be handed to the kernel when negotiated with the guest. */
+# define VIRTIONET_VHOST_RING_FEATURES      (  VIRTIO_F_VERSION_1 | VIRTIO_F_EVENT_IDX | VIRTIO_F_INDIRECT_DESC \
+                                             | VIRTIO_F_ANY_LAYOUT | VIRTIONET_F_MRG_RXBUF | VIRTIO_F_RING_PACKED \
+                                             | VIRTIO_F_IN_ORDER)
+
+/** struct vhost_vring_state */
+typedef struct VIRTIONETVHOSTVRINGSTATE
+{
+    uint32_t    uIndex;
+    uint32_t    uNum;
+} VIRTIONETVHOSTVRINGSTATE;
+
+/** struct vhost_vring_file */
+typedef struct VIRTIONETVHOSTVRINGFILE
+{
+    uint32_t    uIndex;
+    int32_t     fd;
+} VIRTIONETVHOSTVRINGFILE;
+
+/** struct vhost_vring_addr */
+typedef struct VIRTIONETVHOSTVRINGADDR
+{
+    uint32_t    uIndex;
+    uint32_t    fFlags;
+    uint64_t    uDescUserAddr;
+    uint64_t    uUsedUserAddr;
+    uint64_t    uAvailUserAddr;
+    uint64_t    uLogGuestAddr;
+} VIRTIONETVHOSTVRINGADDR;
+
+/** struct vhost_memory_region */
+typedef struct VIRTIONETVHOSTMEMREGION
+{
+    uint64_t    uGuestPhysAddr;
+    uint64_t    cbMemory;
+    uint64_t    uUserspaceAddr;
+    uint64_t    fFlagsPadding;
+} VIRTIONETVHOSTMEMREGION;
+
+/** struct vhost_memory (header only, the regions follow). */
+typedef struct VIRTIONETVHOSTMEM
+{
+    uint32_t    cRegions;
+    uint32_t    uPadding;
+} VIRTIONETVHOSTMEM;
+
+# define VIRTIONET_VHOST_IOC                0xaf
+# define VIRTIONET_VHOST_GET_FEATURES       _IOR(VIRTIONET_VHOST_IOC, 0x00, uint64_t)
+# define VIRTIONET_VHOST_SET_FEATURES       _IOW(VIRTIONET_VHOST_IOC, 0x00, uint64_t)
+# define VIRTIONET_VHOST_SET_OWNER          _IO(VIRTIONET_VHOST_IOC, 0x01)
+# define VIRTIONET_VHOST_SET_MEM_TABLE      _IOW(VIRTIONET_VHOST_IOC, 0x03, VIRTIONETVHOSTMEM)
+# define VIRTIONET_VHOST_SET_VRING_NUM      _IOW(VIRTIONET_VHOST_IOC, 0x10, VIRTIONETVHOSTVRINGSTATE)
+# define VIRTIONET_VHOST_SET_VRING_ADDR     _IOW(VIRTIONET_VHOST_IOC, 0x11, VIRTIONETVHOSTVRINGADDR)
+# define VIRTIONET_VHOST_SET_VRING_BASE     _IOW(VIRTIONET_VHOST_IOC, 0x12, VIRTIONETVHOSTVRINGSTATE)
+# define VIRTIONET_VHOST_GET_VRING_BASE     _IOWR(VIRTIONET_VHOST_IOC, 0x12, VIRTIONETVHOSTVRINGSTATE)
+# define VIRTIONET_VHOST_SET_VRING_KICK     _IOW(VIRTIONET_VHOST_IOC, 0x20, VIRTIONETVHOSTVRINGFILE)
+# define VIRTIONET_VHOST_SET_VRING_CALL     _IOW(VIRTIONET_VHOST_IOC, 0x21, VIRTIONETVHOSTVRINGFILE)
+# define VIRTIONET_VHOST_NET_SET_BACKEND    _IOW(VIRTIONET_VHOST_IOC, 0x30, VIRTIONETVHOSTVRINGFILE)
+/** @} */
+#endif /* VIRTIONET_WITH_VHOST */
+
 #ifdef IN_RING3
 static const VIRTIO_FEATURES_LIST s_aDevSpecificFeatures[] =
 {
@@ -130,6 +216,7 @@ static const VIRTIO_FEATURES_LIST s_aDevSpecificFeatures[] =
     { VIRTIONET_F_HOST_ECN,            "   HOST_ECN             Host can receive TSO with ECN.\n" },
     { VIRTIONET_F_HOST_UFO,            "   HOST_UFO             Host can receive UFO.\n" },
     { VIRTIONET_F_MQ,                  "   MQ                   Host supports multiqueue with automatic receive steering.\n" },
+    { VIRTIONET_F_RSS,                 "   RSS                  Host supports receive side scaling.\n" },
     { VIRTIONET_F_CSUM,                "   CSUM                 Host handles packets with partial checksum.\n" },
     { VIRTIONET_F_MRG_RXBUF,           "   MRG_RXBUF            Guest can merge receive buffers.\n" },
 };
@@ -157,22 +244,26 @@ static const VIRTIO_FEATURES_LIST s_aDevSpecificFeatures[] =
     | VIRTIONET_F_CTRL_RX               \
     | VIRTIONET_F_CTRL_VLAN             \
     | VIRTIONET_HOST_FEATURES_GSO       \
-    | VIRTIONET_F_MRG_RXBUF
+    | VIRTIONET_F_MRG_RXBUF             \
+    | VIRTIONET_F_MQ                    \
+    | VIRTIONET_F_RSS
+
+/** Features only offered if more than one queue pair is configured. */
+#define VIRTIONET_HOST_FEATURES_MQ      (VIRTIONET_F_MQ | VIRTIONET_F_RSS)
 
 #define FEATURE_ENABLED(feature)        RT_BOOL(!!(pThis->fNegotiatedFeatures & VIRTIONET_F_##feature))
 #define FEATURE_DISABLED(feature)       (!FEATURE_ENABLED(feature))
 #define FEATURE_OFFERED(feature)        VIRTIONET_HOST_FEATURES_OFFERED & VIRTIONET_F_##feature
 
-#if FEATURE_OFFERED(MQ)
-/* Instance data doesn't allow an array large enough to contain VIRTIONET_CTRL_MQ_VQ_PAIRS_MAX entries */
-#   define VIRTIONET_MAX_QPAIRS         1  /* This should be increased at some point and made to work */
-#else
-#   define VIRTIONET_MAX_QPAIRS         VIRTIONET_CTRL_MQ_VQ_PAIRS_MIN /* default, VirtIO 1.0, 5.1.6.5.5 */
-#endif
-
-#define VIRTIONET_CTRL_MQ_VQ_PAIRS      64
-#define VIRTIONET_MAX_WORKERS           VIRTIONET_MAX_QPAIRS + 1
+/** Maximum number of Rx/Tx queue pairs, limited by the virtqs the VirtIO core supports (VIRTQ_MAX_COUNT). */
+#define VIRTIONET_MAX_QPAIRS            8
+/** Workers: One per Tx queue plus the two possible control queue locations (with and without MQ). */
+#define VIRTIONET_MAX_WORKERS           (VIRTIONET_MAX_QPAIRS + 2)
 #define VIRTIONET_MAX_VIRTQS            (VIRTIONET_MAX_QPAIRS * 2 + 1)
+/** Number of transmitted buffers after which the Tx used ring is synced while the queue is
+ * still being drained, so the guest can reclaim buffers during long bursts. */
+#define VIRTIONET_TX_USED_SYNC_BATCH    64
+AssertCompile(VIRTIONET_MAX_VIRTQS <= VIRTQ_MAX_COUNT);
 #define VIRTIONET_MAX_FRAME_SIZE        65535 + 18  /**< Max IP pkt size + Eth. header w/VLAN tag  */
 #define VIRTIONET_MAC_FILTER_LEN        64
 #define VIRTIONET_MAX_VLAN_ID           4096
@@ -188,9 +279,12 @@ static const VIRTIO_FEATURES_LIST s_aDevSpecificFeatures[] =
 /*
  * Macros to calculate queue type-pecific index number regardless of scale. VirtIO 1.0, 5.1.2
  */
-#define RXQIDX(qPairIdx)                (qPairIdx * 2)
+#define RXQIDX(qPairIdx)                ((qPairIdx) * 2)
 #define TXQIDX(qPairIdx)                (RXQIDX(qPairIdx) + 1)
-#define CTRLQIDX                        (FEATURE_ENABLED(MQ) ? ((VIRTIONET_MAX_QPAIRS - 1) * 2 + 2) : 2)
+#define CTRLQIDX_WITHOUT_MQ             2
+#define CTRLQIDX_WITH_MQ(cMaxPairs)     ((cMaxPairs) * 2)
+#define CTRLQIDX                        (FEATURE_ENABLED(MQ) ? CTRLQIDX_WITH_MQ(pThis->virtioNetConfig.uMaxVirtqPairs) \
+                                                             : CTRLQIDX_WITHOUT_MQ)
 
 #define IS_LINK_UP(pState)              !!(pState->virtioNetConfig.uStatus & VIRTIONET_F_LINK_UP)
 #define IS_LINK_DOWN(pState)            !IS_LINK_UP(pState)
@@ -231,6 +325,15 @@ static const VIRTIO_FEATURES_LIST s_aDevSpecificFeatures[] =
                uint16_t uMaxVirtqPairs;                         /**< max_virtq_pairs                                */
 #endif
 
+#if     FEATURE_OFFERED(RSS)
+               uint16_t uMtu;                                   /**< mtu (VIRTIONET_F_MTU not offered)              */
+               uint32_t uSpeed;                                 /**< speed (VIRTIONET_F_SPEED_DUPLEX not offered)   */
+               uint8_t  uDuplex;                                /**< duplex (VIRTIONET_F_SPEED_DUPLEX not offered)  */
+               uint8_t  uRssMaxKeySize;                         /**< rss_max_key_size                               */
+               uint16_t uRssMaxIndirectionTableLength;          /**< rss_max_indirection_table_length               */
+               uint32_t fSupportedHashTypes;                    /**< supported_hash_types                           */
+#endif
+
     } VIRTIONET_CONFIG_T, PVIRTIONET_CONFIG_T;
 
 #pragma pack()
@@ -325,6 +428,22 @@ struct virtio_net_ctrl_mq {
 #define VIRTIONET_CTRL_MQ_VQ_PAIRS_MAX         0x8000           /**< Maximum number of TX/RX queues                 */
 /** @} */
 
+/** @name Control virtq: Receive side scaling (VirtIO 1.1, 5.1.6.5.7)
+ * @{  */
+#define VIRTIONET_CTRL_MQ_RSS_CONFIG                1           /**< Configure receive side scaling                 */
+#define VIRTIONET_RSS_HASH_TYPE_IPV4        RT_BIT_32(0)        /**< Hash over IPv4 addresses                       */
+#define VIRTIONET_RSS_HASH_TYPE_TCPV4       RT_BIT_32(1)        /**< Hash over IPv4 addresses and TCP ports         */
+#define VIRTIONET_RSS_HASH_TYPE_UDPV4       RT_BIT_32(2)        /**< Hash over IPv4 addresses and UDP ports         */
+#define VIRTIONET_RSS_HASH_TYPE_IPV6        RT_BIT_32(3)        /**< Hash over IPv6 addresses                       */
+#define VIRTIONET_RSS_HASH_TYPE_TCPV6       RT_BIT_32(4)        /**< Hash over IPv6 addresses and TCP ports         */
+#define VIRTIONET_RSS_HASH_TYPE_UDPV6       RT_BIT_32(5)        /**< Hash over IPv6 addresses and UDP ports         */
+#define VIRTIONET_RSS_HASH_TYPES_SUPPORTED  (  VIRTIONET_RSS_HASH_TYPE_IPV4 | VIRTIONET_RSS_HASH_TYPE_TCPV4 \
+                                             | VIRTIONET_RSS_HASH_TYPE_UDPV4 | VIRTIONET_RSS_HASH_TYPE_IPV6 \
+                                             | VIRTIONET_RSS_HASH_TYPE_TCPV6 | VIRTIONET_RSS_HASH_TYPE_UDPV6)
+#define VIRTIONET_RSS_MAX_KEY_SIZE                 40           /**< Maximum (Toeplitz) hash key size               */
+#define VIRTIONET_RSS_MAX_INDIRECTION_TABLE       128           /**< Maximum indirection table length               */
+/** @} */
+
 uint64_t    uOffloads;                                          /**< offloads                                       */
 
 /** @name Control virtq: Setting Offloads State (VirtIO 1.0, 5.1.6.5.6.1)
@@ -353,7 +472,7 @@ typedef struct VIRTIONETVIRTQ
 {
     uint16_t                       uIdx;                        /**< Index of this queue                            */
     uint16_t                       align;
-    bool                           fCtlVirtq;                   /**< If set this queue is the control queue         */
+    uint32_t volatile              uIsTransmitting;             /**< Tx queues: Transmission from this queue in progress */
     bool                           fHasWorker;                  /**< If set this queue has an associated worker     */
     bool                           fAttachedToVirtioCore;       /**< Set if queue attached to virtio core           */
     char                           szName[VIRTIO_MAX_VIRTQ_NAME_SIZE]; /**< Virtq name                              */
@@ -411,23 +530,38 @@ typedef struct VIRTIONET
     /** VirtIO features negotiated with the guest, including generic core and device specific */
     uint64_t                fNegotiatedFeatures;
 
-    /** Number of Rx/Tx queue pairs (only one if MQ feature not negotiated */
+    /** Number of Rx/Tx queue pairs in use (only one if MQ feature not negotiated or not set by the guest yet) */
     uint16_t                cVirtqPairs;
 
-    /** Number of Rx/Tx queue pairs that have already been initialized */
-    uint16_t                cInitializedVirtqPairs;
+    /** Alignment */
+    uint16_t                alignment0;
 
     /** Number of virtqueues total (which includes each queue of each pair plus one control queue */
     uint16_t                cVirtqs;
 
-    /** Number of worker threads (one for the control queue and one for each Tx queue) */
+    /** Number of worker threads (one for each control queue location and one for each Tx queue) */
     uint16_t                cWorkers;
 
-    /** Alignment */
-    uint16_t                alignment;
+    /** RSS: Set if the guest configured receive side scaling. */
+    bool                    fRssEnabled;
 
-    /** Indicates transmission in progress -- only one thread is allowed. */
-    uint32_t                uIsTransmitting;
+    /** RSS: Size of the hash key in bytes. */
+    uint8_t                 cbRssKey;
+
+    /** RSS: Mask applied to the hash for indexing the indirection table. */
+    uint16_t                fRssIndirectionMask;
+
+    /** RSS: Enabled hash types (VIRTIONET_RSS_HASH_TYPE_XXX). */
+    uint32_t                fRssHashTypes;
+
+    /** RSS: Queue pair index receiving packets no hash is calculated for. */
+    uint16_t                uRssUnclassifiedQueue;
+
+    /** RSS: Indirection table, maps hash values to receive queue pair indexes. */
+    uint16_t                auRssIndirectionTable[VIRTIONET_RSS_MAX_INDIRECTION_TABLE];
+
+    /** RSS: The Toeplitz hash key. */
+    uint8_t                 abRssKey[VIRTIONET_RSS_MAX_KEY_SIZE];
 
     /** Link up delay (in milliseconds). */
     uint32_t                cMsLinkUpDelay;
@@ -498,6 +632,10 @@ typedef struct VIRTIONET
     /** True if this device should offer legacy virtio support to the guest */
     bool                    fOfferLegacy;
 
+    /** Set while the host kernel (vhost-net) processes the Rx and Tx queues of the
+     * first pair, the device only relays notifications then. */
+    bool volatile           fVHostActive;
+
     /** @name Statistic
      * @{ */
     STAMCOUNTER             StatReceiveBytes;
@@ -515,6 +653,7 @@ typedef struct VIRTIONET
     STAMCOUNTER             StatRxOverflowWakeup;
     STAMCOUNTER             StatTransmitByNetwork;
     STAMCOUNTER             StatTransmitByThread;
+    STAMCOUNTER             StatReceiveBursts;
     /** @}  */
 #endif
 } VIRTIONET;
@@ -565,6 +704,36 @@ typedef struct VIRTIONETR3
     /** Link Up(/Restore) Timer. */
     TMTIMERHANDLE                   hLinkUpTimer;
 
+#ifdef VIRTIONET_WITH_VHOST
+    /** vhost-net: Kernel offload interface of the attached driver, NULL if not available. */
+    R3PTRTYPE(PPDMINETWORKVHOST)    pDrvVHost;
+    /** vhost-net: The /dev/vhost-net handle, -1 if not used. */
+    int                             fdVHost;
+    /** vhost-net: Guest notification (kick) eventfds for the Rx and Tx queue. */
+    int                             afdVHostKick[2];
+    /** vhost-net: Kernel interrupt request (call) eventfds for the Rx and Tx queue. */
+    int                             afdVHostCall[2];
+    /** vhost-net: Eventfd waking up the call relay thread. */
+    int                             fdVHostWakeup;
+    /** vhost-net: The call relay thread, also does the hand over to the kernel. */
+    R3PTRTYPE(PPDMTHREAD)           pVHostCallThread;
+    /** vhost-net: Serializes the hand over (relay thread) with taking the queues back (EMT). */
+    RTCRITSECT                      CritSectVHost;
+    /** vhost-net: Set by virtioNetR3VHostStart to have the relay thread do the hand over. */
+    bool volatile                   fVHostStartPending;
+    /** vhost-net: Set while a live save (live snapshot, teleportation) is in progress.
+     * The kernel writes guest RAM without PGM knowing about it, so the device keeps
+     * the queues while PGM tracks dirty pages. */
+    bool volatile                   fVHostSaving;
+    /** vhost-net: The features supported by the kernel. */
+    uint64_t                        fVHostFeatures;
+    /** vhost-net: Set once the missing guest RAM mappings were complained about. */
+    bool                            fVHostNoMappingsLogged;
+    /** vhost-net: Number of valid entries in aVHostMappings. */
+    uint32_t                        cVHostMappings;
+    /** vhost-net: The guest RAM mappings passed to the kernel. */
+    PGMPHYSRAMMAPPING               aVHostMappings[VIRTIONET_VHOST_MAX_REGIONS];
+#endif
 } VIRTIONETR3;
 
 /** Pointer to the ring-3 state of the VirtIO Host NET device. */
@@ -678,7 +847,19 @@ static DECLCALLBACK(void) virtioNetVirtqNotified(PPDMDEVINS pDevIns, PVIRTIOCORE
 #if defined (IN_RING3) && defined (LOG_ENABLED)
     RTLogFlush(NULL);
 #endif
-    if (IS_RX_VIRTQ(uVirtqNbr))
+    if (   ASMAtomicReadBool(&pThis->fVHostActive)
+        && uVirtqNbr <= TXQIDX(0))
+    {
+        /* The kernel processes the first queue pair, its Tx worker relays the notification. */
+        pWorker = &pThis->aWorkers[TXQIDX(0)];
+        if (   !ASMAtomicXchgBool(&pWorker->fNotified, true)
+            && ASMAtomicReadBool(&pWorker->fSleeping))
+        {
+            int rc = PDMDevHlpSUPSemEventSignal(pDevIns, pWorker->hEvtProcess);
+            AssertRC(rc);
+        }
+    }
+    else if (IS_RX_VIRTQ(uVirtqNbr))
     {
         uint16_t cBufsAvailable = virtioCoreVirtqAvailBufCount(pDevIns, pVirtio, uVirtqNbr);
 
@@ -741,12 +922,13 @@ static DECLCALLBACK(int) virtioNetR3WakeupWorker(PPDMDEVINS pDevIns, PPDMTHREAD
  */
 DECLINLINE(void) virtioNetR3SetVirtqNames(PVIRTIONET pThis, uint32_t fLegacy)
 {
-    RTStrCopy(pThis->aVirtqs[CTRLQIDX].szName, VIRTIO_MAX_VIRTQ_NAME_SIZE, fLegacy ? "legacy-ctrlq" : " modern-ctrlq");
-    for (uint16_t qPairIdx = 0; qPairIdx < pThis->cVirtqPairs; qPairIdx++)
+    for (uint16_t qPairIdx = 0; qPairIdx < pThis->virtioNetConfig.uMaxVirtqPairs; qPairIdx++)
     {
         RTStrPrintf(pThis->aVirtqs[RXQIDX(qPairIdx)].szName, VIRTIO_MAX_VIRTQ_NAME_SIZE, "%s-recvq<%d>", fLegacy ? "legacy" : "modern", qPairIdx);
         RTStrPrintf(pThis->aVirtqs[TXQIDX(qPairIdx)].szName, VIRTIO_MAX_VIRTQ_NAME_SIZE, "%s-xmitq<%d>", fLegacy ? "legacy" : "modern", qPairIdx);
     }
+    /* Last, as the control queue location depends on the negotiated MQ feature and may overlap with an Rx queue otherwise. */
+    RTStrCopy(pThis->aVirtqs[CTRLQIDX].szName, VIRTIO_MAX_VIRTQ_NAME_SIZE, fLegacy ? "legacy-ctrlq" : " modern-ctrlq");
 }
 
 /**
@@ -903,9 +1085,11 @@ static DECLCALLBACK(void) virtioNetR3Info(PPDMDEVINS pDevIns, PCDBGFINFOHLP pHlp
     if (fAll || fState)
     {
         pHlp->pfnPrintf(pHlp, "Device state:\n\n");
-        uint32_t fTransmitting = ASMAtomicReadU32(&pThis->uIsTransmitting);
+        uint32_t cTransmitting = 0;
+        for (uint16_t uVirtqPair = 0; uVirtqPair < pThis->virtioNetConfig.uMaxVirtqPairs; uVirtqPair++)
+            cTransmitting += ASMAtomicReadU32(&pThis->aVirtqs[TXQIDX(uVirtqPair)].uIsTransmitting);
 
-        pHlp->pfnPrintf(pHlp, "    Transmitting: ............. %s\n", fTransmitting ? "true" : "false");
+        pHlp->pfnPrintf(pHlp, "    Transmitting: ............. %u queue(s)\n", cTransmitting);
         pHlp->pfnPrintf(pHlp, "\n");
         pHlp->pfnPrintf(pHlp, "Misc state\n");
         pHlp->pfnPrintf(pHlp, "\n");
@@ -919,6 +1103,9 @@ static DECLCALLBACK(void) virtioNetR3Info(PPDMDEVINS pDevIns, PCDBGFINFOHLP pHlp
         pHlp->pfnPrintf(pHlp, "    cVirtqPairs .,............. %d\n",   pThis->cVirtqPairs);
         pHlp->pfnPrintf(pHlp, "    cVirtqs .,................. %d\n",   pThis->cVirtqs);
         pHlp->pfnPrintf(pHlp, "    cWorkers .................. %d\n",   pThis->cWorkers);
+        pHlp->pfnPrintf(pHlp, "    RSS ....................... %s (hash types %#x, %u table entries)\n",
+                        pThis->fRssEnabled ? "enabled" : "disabled", pThis->fRssHashTypes,
+                        pThis->fRssEnabled ? pThis->fRssIndirectionMask + 1 : 0);
         pHlp->pfnPrintf(pHlp, "    MMIO mapping name ......... %s\n",   pThisCC->Virtio.szMmioName);
         pHlp->pfnPrintf(pHlp, "\n");
     }
@@ -978,7 +1165,7 @@ static DECLCALLBACK(void) virtioNetR3Info(PPDMDEVINS pDevIns, PCDBGFINFOHLP pHlp
  * @returns             true if valid feature combination(s) found.
  *                      false if non-valid feature set.
  */
-DECLINLINE(bool) virtioNetValidateRequiredFeatures(uint32_t fFeatures)
+DECLINLINE(bool) virtioNetValidateRequiredFeatures(uint64_t fFeatures)
 {
     uint32_t fGuestChksumRequired =   fFeatures & VIRTIONET_F_GUEST_TSO4
                                    || fFeatures & VIRTIONET_F_GUEST_TSO6
@@ -1003,6 +1190,9 @@ DECLINLINE(bool) virtioNetValidateRequiredFeatures(uint32_t fFeatures)
     if (fCtrlVqRequired && !(fFeatures & VIRTIONET_F_CTRL_VQ))
         return false;
 
+    if ((fFeatures & VIRTIONET_F_RSS) && !(fFeatures & VIRTIONET_F_CTRL_VQ))
+        return false;
+
     if (   fFeatures & VIRTIONET_F_GUEST_ECN
         && !(   fFeatures & VIRTIONET_F_GUEST_TSO4
              || fFeatures & VIRTIONET_F_GUEST_TSO6))
@@ -1045,6 +1235,17 @@ static int virtioNetR3DevCfgAccess(PVIRTIONET pThis, uint32_t uOffsetOfAccess, v
     else
     if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uMaxVirtqPairs,   VIRTIONET_CONFIG_T, uOffsetOfAccess))
         VIRTIO_DEV_CONFIG_ACCESS_READONLY( uMaxVirtqPairs,   VIRTIONET_CONFIG_T, uOffsetOfAccess, &pThis->virtioNetConfig);
+#endif
+#if FEATURE_OFFERED(RSS)
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uRssMaxKeySize,   VIRTIONET_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uRssMaxKeySize,   VIRTIONET_CONFIG_T, uOffsetOfAccess, &pThis->virtioNetConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uRssMaxIndirectionTableLength, VIRTIONET_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uRssMaxIndirectionTableLength, VIRTIONET_CONFIG_T, uOffsetOfAccess, &pThis->virtioNetConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    fSupportedHashTypes, VIRTIONET_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( fSupportedHashTypes, VIRTIONET_CONFIG_T, uOffsetOfAccess, &pThis->virtioNetConfig);
 #endif
     else
     {
@@ -1105,7 +1306,6 @@ static int virtioNetR3VirtqDestroy(PVIRTIOCORE pVirtio, PVIRTIONETVIRTQ pVirtq)
         pVirtq->fHasWorker = false;
     }
     pWorker->fAssigned = false;
-    pVirtq->fCtlVirtq  = false;
     Log10(("\n"));
     return rc;
 }
@@ -1325,15 +1525,20 @@ static DECLCALLBACK(int) virtioNetR3ModernLoadExec(PPDMDEVINS pDevIns, PSSMHANDL
     Log7Func(("[%s] LOAD EXEC!!\n", pThis->szInst));
 
     AssertReturn(uPass == SSM_PASS_FINAL, VERR_SSM_UNEXPECTED_PASS);
-    AssertLogRelMsgReturn(uVersion == VIRTIONET_SAVEDSTATE_VERSION,
+    AssertLogRelMsgReturn(   uVersion == VIRTIONET_SAVEDSTATE_VERSION
+                          || uVersion == VIRTIONET_SAVEDSTATE_VERSION_PRE_MQ,
                           ("uVersion=%u\n", uVersion), VERR_SSM_UNSUPPORTED_DATA_UNIT_VERSION);
 
     virtioNetR3SetVirtqNames(pThis, false /* fLegacy */);
 
     pHlp->pfnSSMGetU64(     pSSM, &pThis->fNegotiatedFeatures);
 
+    uint16_t const cVirtqsConfigured = pThis->cVirtqs;
     pHlp->pfnSSMGetU16(     pSSM, &pThis->cVirtqs);
     AssertReturn(pThis->cVirtqs <= (VIRTIONET_MAX_QPAIRS * 2) + 1, VERR_OUT_OF_RANGE);
+    if (pThis->cVirtqs != cVirtqsConfigured)
+        return pHlp->pfnSSMSetCfgError(pSSM, RT_SRC_POS, N_("Config mismatch - saved state has %u virtqs, configured are %u (QueuePairs)"),
+                                       pThis->cVirtqs, cVirtqsConfigured);
     pHlp->pfnSSMGetU16(     pSSM, &pThis->cWorkers);
     AssertReturn(pThis->cWorkers <= VIRTIONET_MAX_WORKERS , VERR_OUT_OF_RANGE);
 
@@ -1369,10 +1574,10 @@ static DECLCALLBACK(int) virtioNetR3ModernLoadExec(PPDMDEVINS pDevIns, PSSMHANDL
 #if FEATURE_OFFERED(MQ)
     uint16_t uCheckMaxVirtqPairs;
     pHlp->pfnSSMGetU16(     pSSM, &uCheckMaxVirtqPairs);
+    /* Zero means the state was saved without the MQ feature, i.e. with a single queue pair (which the virtq count check covers). */
     if (uCheckMaxVirtqPairs)
-        pThis->virtioNetConfig.uMaxVirtqPairs = uCheckMaxVirtqPairs;
-    else
-        pThis->virtioNetConfig.uMaxVirtqPairs = VIRTIONET_CTRL_MQ_VQ_PAIRS;
+        AssertLogRelMsgReturn(uCheckMaxVirtqPairs == pThis->virtioNetConfig.uMaxVirtqPairs,
+                              ("uCheckMaxVirtqPairs=%u\n", uCheckMaxVirtqPairs), VERR_SSM_LOAD_CONFIG_MISMATCH);
 #else
     uint16_t fDiscard;
     pHlp->pfnSSMGetU16(     pSSM, &fDiscard);
@@ -1405,11 +1610,34 @@ static DECLCALLBACK(int) virtioNetR3ModernLoadExec(PPDMDEVINS pDevIns, PSSMHANDL
 
     rc = pHlp->pfnSSMGetMem(pSSM, pThis->aVlanFilter, sizeof(pThis->aVlanFilter));
     AssertRCReturn(rc, rc);
+
+    if (uVersion >= VIRTIONET_SAVEDSTATE_VERSION)
+    {
+        pHlp->pfnSSMGetU16(     pSSM, &pThis->cVirtqPairs);
+        AssertReturn(   pThis->cVirtqPairs >= 1
+                     && pThis->cVirtqPairs <= pThis->virtioNetConfig.uMaxVirtqPairs, VERR_OUT_OF_RANGE);
+        pHlp->pfnSSMGetBool(    pSSM, &pThis->fRssEnabled);
+        pHlp->pfnSSMGetU32(     pSSM, &pThis->fRssHashTypes);
+        pHlp->pfnSSMGetU16(     pSSM, &pThis->fRssIndirectionMask);
+        AssertReturn(pThis->fRssIndirectionMask < RT_ELEMENTS(pThis->auRssIndirectionTable), VERR_OUT_OF_RANGE);
+        pHlp->pfnSSMGetU16(     pSSM, &pThis->uRssUnclassifiedQueue);
+        pHlp->pfnSSMGetMem(     pSSM, pThis->auRssIndirectionTable, sizeof(pThis->auRssIndirectionTable));
+        pHlp->pfnSSMGetU8(      pSSM, &pThis->cbRssKey);
+        AssertReturn(pThis->cbRssKey <= sizeof(pThis->abRssKey), VERR_OUT_OF_RANGE);
+        rc = pHlp->pfnSSMGetMem(pSSM, pThis->abRssKey, sizeof(pThis->abRssKey));
+        AssertRCReturn(rc, rc);
+    }
+    else
+    {
+        pThis->cVirtqPairs = 1;
+        pThis->fRssEnabled = false;
+    }
+
     /*
      * Call the virtio core to let it load its state.
      */
     rc = virtioCoreR3ModernDeviceLoadExec(&pThis->Virtio, pDevIns->pHlpR3, pSSM, uVersion,
-                                          VIRTIONET_SAVEDSTATE_VERSION, pThis->cVirtqs);
+                                          uVersion /* the core state carries the same version */, pThis->cVirtqs);
     AssertRCReturn(rc, rc);
     /*
      * Since the control queue is created proactively in the constructor to accomodate worst-case
@@ -1539,7 +1767,16 @@ static DECLCALLBACK(int) virtioNetR3ModernSaveExec(PPDMDEVINS pDevIns, PSSMHANDL
     pHlp->pfnSSMPutU32(     pSSM, pThis->cUnicastFilterMacs);
     pHlp->pfnSSMPutMem(     pSSM, pThis->aMacUnicastFilter, pThis->cUnicastFilterMacs * sizeof(RTMAC));
 
-    int rc = pHlp->pfnSSMPutMem(pSSM, pThis->aVlanFilter, sizeof(pThis->aVlanFilter));
+    pHlp->pfnSSMPutMem(     pSSM, pThis->aVlanFilter, sizeof(pThis->aVlanFilter));
+
+    pHlp->pfnSSMPutU16(     pSSM, pThis->cVirtqPairs);
+    pHlp->pfnSSMPutBool(    pSSM, pThis->fRssEnabled);
+    pHlp->pfnSSMPutU32(     pSSM, pThis->fRssHashTypes);
+    pHlp->pfnSSMPutU16(     pSSM, pThis->fRssIndirectionMask);
+    pHlp->pfnSSMPutU16(     pSSM, pThis->uRssUnclassifiedQueue);
+    pHlp->pfnSSMPutMem(     pSSM, pThis->auRssIndirectionTable, sizeof(pThis->auRssIndirectionTable));
+    pHlp->pfnSSMPutU8(      pSSM, pThis->cbRssKey);
+    int rc = pHlp->pfnSSMPutMem(pSSM, pThis->abRssKey, sizeof(pThis->abRssKey));
     AssertRCReturn(rc, rc);
 
     /*
@@ -1716,16 +1953,14 @@ static int virtioNetR3CheckRxBufsAvail(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVI
 /**
  * Find an Rx queue that has Rx packets in it, if *any* do.
  *
- * @todo When multiqueue (MQ) mode is fully supported and tested, some kind of round-robin
- *       or randomization scheme should probably be incorporated here.
- *
  * @returns true if Rx pkts avail on queue and sets pRxVirtq to point to queue w/pkts found
  * @thread  RX
  *
  */
 static bool virtioNetR3AreRxBufsAvail(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIONETVIRTQ *pRxVirtq)
 {
-    for (int uVirtqPair = 0; uVirtqPair < pThis->cVirtqPairs; uVirtqPair++)
+    uint16_t const cRxVirtqs = FEATURE_ENABLED(MQ) ? pThis->virtioNetConfig.uMaxVirtqPairs : 1;
+    for (uint16_t uVirtqPair = 0; uVirtqPair < cRxVirtqs; uVirtqPair++)
     {
         PVIRTIONETVIRTQ pThisRxVirtq = &pThis->aVirtqs[RXQIDX(uVirtqPair)];
         if (RT_SUCCESS(virtioNetR3CheckRxBufsAvail(pDevIns, pThis, pThisRxVirtq)))
@@ -1747,7 +1982,8 @@ static DECLCALLBACK(int) virtioNetR3NetworkDown_WaitReceiveAvail(PPDMINETWORKDOW
     PPDMDEVINS   pDevIns = pThisCC->pDevIns;
     PVIRTIONET   pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIONET);
 
-    if (!virtioNetIsOperational(pThis, pDevIns))
+    if (   !virtioNetIsOperational(pThis, pDevIns)
+        || ASMAtomicReadBool(&pThis->fVHostActive))
         return VERR_INTERRUPTED;
 
     if (virtioNetR3AreRxBufsAvail(pDevIns, pThis, NULL /* pRxVirtq */))
@@ -1787,7 +2023,8 @@ static DECLCALLBACK(int) virtioNetR3NetworkDown_WaitReceiveAvail(PPDMINETWORKDOW
             LogFunc(("Waken due to failure %Rrc\n", rc));
             RTThreadSleep(1);
         }
-    } while (virtioNetIsOperational(pThis, pDevIns));
+    } while (   virtioNetIsOperational(pThis, pDevIns)
+             && !ASMAtomicReadBool(&pThis->fVHostActive));
 
     STAM_PROFILE_STOP(&pThis->StatRxOverflow, a);
     ASMAtomicXchgBool(&pThis->fLeafWantsEmptyRxBufs, false);
@@ -2085,7 +2322,9 @@ static int virtioNetR3RxPktMultibufXfer(PPDMDEVINS pDevIns, PVIRTIONET pThis, ui
     int rc = virtioCoreGCPhysWrite(&pThis->Virtio, pDevIns, GCPhysNumBuffers, &cVirtqBufsUsed, sizeof(cVirtqBufsUsed));
     AssertMsgRCReturn(rc, ("Failure updating descriptor count in pkt hdr in guest physical memory\n"), rc);
 
-    virtioCoreVirtqUsedRingSync(pDevIns, &pThis->Virtio, pRxVirtq->uIdx);
+    /* With packed rings the guest would see the frame's first buffer before the fix-up otherwise. */
+    virtioCoreR3VirtqUsedBufPublish(pDevIns, &pThis->Virtio, pRxVirtq->uIdx);
+
     Log7(("\n"));
     return rc;
 }
@@ -2103,6 +2342,8 @@ static int virtioNetR3RxPktMultibufXfer(PPDMDEVINS pDevIns, PVIRTIONET pThis, ui
  * @param   cb              Number of bytes available in the buffer.
  * @param   pGso            Pointer to Global Segmentation Offload structure
  * @param   pRxVirtq        Pointer to Rx virtqueue
+ * @remarks The buffers are only put on the used ring, the caller syncs the ring
+ *          (virtioCoreVirtqUsedRingSync) once it's done with the frame or burst.
  * @thread  RX
  */
 
@@ -2137,10 +2378,14 @@ static int virtioNetR3CopyRxPktToGuest(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVI
     {
         Log7Func(("Send Rx packet header and data to guest (single-buffer copy)...\n"));
         pRxPktHdr->uNumBuffers = 1;
-        rc = virtioCoreR3VirtqUsedBufPut(pDevIns, &pThis->Virtio, pRxVirtq->uIdx, cbPktHdr,  pRxPktHdr, pVirtqBuf, 0  /* cbEnqueue */);
-        if (rc == VINF_SUCCESS)
-            rc = virtioCoreR3VirtqUsedBufPut(pDevIns, &pThis->Virtio, pRxVirtq->uIdx, cb, pvBuf, pVirtqBuf, cbPktHdr + cb /* cbEnqueue */);
-        virtioCoreVirtqUsedRingSync(pDevIns, &pThis->Virtio, pRxVirtq->uIdx);
+        RTSGSEG aSegs[2];
+        aSegs[0].pvSeg = pRxPktHdr;
+        aSegs[0].cbSeg = cbPktHdr;
+        aSegs[1].pvSeg = (void *)pvBuf;
+        aSegs[1].cbSeg = cb;
+        RTSGBUF SgBuf;
+        RTSgBufInit(&SgBuf, aSegs, RT_ELEMENTS(aSegs));
+        rc = virtioCoreR3VirtqUsedBufPut(pDevIns, &pThis->Virtio, pRxVirtq->uIdx, &SgBuf, pVirtqBuf, true /* fFence */);
         AssertMsgReturn(rc == VINF_SUCCESS, ("%Rrc\n", rc), rc);
     }
     else
@@ -2157,22 +2402,181 @@ static int virtioNetR3CopyRxPktToGuest(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVI
     return VINF_SUCCESS;
 }
 
+/** The default Toeplitz key used for automatic receive steering when the guest didn't configure RSS. */
+static const uint8_t g_abVirtioNetDefaultRssKey[VIRTIONET_RSS_MAX_KEY_SIZE] =
+{
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+    0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+    0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa
+};
+
 /**
- * @interface_method_impl{PDMINETWORKDOWN,pfnReceiveGso}
+ * Calculates the Toeplitz hash over the given input as specified for RSS.
+ *
+ * @returns The 32-bit hash value.
+ * @param   pbKey       The hash key.
+ * @param   cbKey       Size of the hash key in bytes.
+ * @param   pbInput     The input (addresses and ports in network byte order).
+ * @param   cbInput     Size of the input in bytes.
  */
-static DECLCALLBACK(int) virtioNetR3NetworkDown_ReceiveGso(PPDMINETWORKDOWN pInterface, const void *pvBuf, size_t cb,
-                                                           PCPDMNETWORKGSO pGso)
+static uint32_t virtioNetR3ToeplitzHash(const uint8_t *pbKey, size_t cbKey, const uint8_t *pbInput, size_t cbInput)
 {
-    PVIRTIONETCC    pThisCC  = RT_FROM_MEMBER(pInterface, VIRTIONETCC, INetworkDown);
-    PPDMDEVINS      pDevIns  = pThisCC->pDevIns;
-    PVIRTIONET      pThis    = PDMDEVINS_2_DATA(pDevIns, PVIRTIONET);
-    VIRTIONETPKTHDR rxPktHdr = { 0, VIRTIONET_HDR_GSO_NONE, 0, 0, 0, 0, 0 };
+    uint32_t uHash = 0;
+    for (size_t offInput = 0; offInput < cbInput; offInput++)
+    {
+        /* The 64 key bits starting at the bit position of the current input byte, zero padded. */
+        uint64_t u64Key = 0;
+        for (size_t i = 0; i < 8; i++)
+            u64Key = (u64Key << 8) | (offInput + i < cbKey ? pbKey[offInput + i] : 0);
+
+        uint8_t const bInput = pbInput[offInput];
+        for (unsigned iBit = 0; iBit < 8; iBit++)
+            if (bInput & (0x80 >> iBit))
+                uHash ^= (uint32_t)(u64Key >> (32 - iBit));
+    }
+    return uHash;
+}
 
-    if (!pThis->fVirtioReady)
+/**
+ * Selects the receive queue pair for a frame from the network.
+ *
+ * If the guest configured RSS the hash types, key and indirection table it supplied are used,
+ * otherwise (plain MQ) flows are spread across the active queue pairs by hashing the addresses
+ * and ports with a default key so each flow sticks to one queue.
+ *
+ * @returns Queue pair index.
+ * @param   pThis       The virtio-net shared instance data.
+ * @param   pbFrame     The Ethernet frame.
+ * @param   cbFrame     Size of the frame in bytes.
+ * @thread  RX
+ */
+static uint16_t virtioNetR3RxSelectVirtqPair(PVIRTIONET pThis, const uint8_t *pbFrame, size_t cbFrame)
+{
+    bool const fRss = pThis->fRssEnabled;
+    uint16_t const uUnclassified = fRss ? pThis->uRssUnclassifiedQueue : 0;
+    if (!fRss && pThis->cVirtqPairs <= 1)
+        return 0;
+
+    /*
+     * Parse the headers, collecting the hash input for the L3 and the L4 hash types.
+     */
+    uint8_t  abInput[2 * sizeof(RTNETADDRIPV6) + 2 * sizeof(uint16_t)];
+    size_t   cbInputL3 = 0;
+    size_t   cbInputL4 = 0;
+    uint32_t fTypeL3   = 0;
+    uint32_t fTypeL4   = 0;
+
+    size_t   offL3 = sizeof(RTNETETHERHDR);
+    if (cbFrame < offL3)
+        return uUnclassified;
+    uint16_t uEtherType = RT_BE2H_U16(*(uint16_t const *)&pbFrame[RT_UOFFSETOF(RTNETETHERHDR, EtherType)]);
+    if (uEtherType == RTNET_ETHERTYPE_VLAN && cbFrame >= offL3 + 4)
     {
-        LogRelFunc(("VirtIO not ready, aborting downstream receive\n"));
-        return VERR_INTERRUPTED;
+        uEtherType = RT_BE2H_U16(*(uint16_t const *)&pbFrame[offL3 + 2]);
+        offL3 += 4;
+    }
+
+    if (uEtherType == RTNET_ETHERTYPE_IPV4 && cbFrame >= offL3 + sizeof(RTNETIPV4))
+    {
+        PCRTNETIPV4 pIpHdr = (PCRTNETIPV4)&pbFrame[offL3];
+        size_t const cbIpHdr = pIpHdr->ip_hl * 4;
+        if (pIpHdr->ip_v == 4 && cbIpHdr >= sizeof(RTNETIPV4) && offL3 + cbIpHdr <= cbFrame)
+        {
+            memcpy(&abInput[0], &pIpHdr->ip_src, sizeof(RTNETADDRIPV4));
+            memcpy(&abInput[sizeof(RTNETADDRIPV4)], &pIpHdr->ip_dst, sizeof(RTNETADDRIPV4));
+            cbInputL3 = 2 * sizeof(RTNETADDRIPV4);
+            fTypeL3   = VIRTIONET_RSS_HASH_TYPE_IPV4;
+
+            bool const fFragment = RT_BE2H_U16(pIpHdr->ip_off) & (RTNETIPV4_FLAGS_MF | UINT16_C(0x1fff) /* fragment offset */);
+            size_t const offL4 = offL3 + cbIpHdr;
+            if (!fFragment && offL4 + 2 * sizeof(uint16_t) <= cbFrame)
+            {
+                if (pIpHdr->ip_p == RTNETIPV4_PROT_TCP)
+                    fTypeL4 = VIRTIONET_RSS_HASH_TYPE_TCPV4;
+                else if (pIpHdr->ip_p == RTNETIPV4_PROT_UDP)
+                    fTypeL4 = VIRTIONET_RSS_HASH_TYPE_UDPV4;
+                if (fTypeL4)
+                {
+                    memcpy(&abInput[cbInputL3], &pbFrame[offL4], 2 * sizeof(uint16_t));
+                    cbInputL4 = cbInputL3 + 2 * sizeof(uint16_t);
+                }
+            }
+        }
+    }
+    else if (uEtherType == RTNET_ETHERTYPE_IPV6 && cbFrame >= offL3 + sizeof(RTNETIPV6))
+    {
+        PCRTNETIPV6 pIpHdr = (PCRTNETIPV6)&pbFrame[offL3];
+        memcpy(&abInput[0], &pIpHdr->ip6_src, sizeof(RTNETADDRIPV6));
+        memcpy(&abInput[sizeof(RTNETADDRIPV6)], &pIpHdr->ip6_dst, sizeof(RTNETADDRIPV6));
+        cbInputL3 = 2 * sizeof(RTNETADDRIPV6);
+        fTypeL3   = VIRTIONET_RSS_HASH_TYPE_IPV6;
+
+        /* Extension headers are not walked, such packets are hashed over the addresses only. */
+        size_t const offL4 = offL3 + sizeof(RTNETIPV6);
+        if (offL4 + 2 * sizeof(uint16_t) <= cbFrame)
+        {
+            if (pIpHdr->ip6_nxt == RTNETIPV4_PROT_TCP)
+                fTypeL4 = VIRTIONET_RSS_HASH_TYPE_TCPV6;
+            else if (pIpHdr->ip6_nxt == RTNETIPV4_PROT_UDP)
+                fTypeL4 = VIRTIONET_RSS_HASH_TYPE_UDPV6;
+            if (fTypeL4)
+            {
+                memcpy(&abInput[cbInputL3], &pbFrame[offL4], 2 * sizeof(uint16_t));
+                cbInputL4 = cbInputL3 + 2 * sizeof(uint16_t);
+            }
+        }
+    }
+
+    /*
+     * Pick the most specific hash type enabled and hash.
+     */
+    uint32_t const fHashTypes = fRss ? pThis->fRssHashTypes : VIRTIONET_RSS_HASH_TYPES_SUPPORTED;
+    size_t cbInput;
+    if (fTypeL4 & fHashTypes)
+        cbInput = cbInputL4;
+    else if (fTypeL3 & fHashTypes)
+        cbInput = cbInputL3;
+    else
+        return uUnclassified;
+
+    uint16_t uVirtqPair;
+    if (fRss)
+    {
+        uint32_t const uHash = virtioNetR3ToeplitzHash(pThis->abRssKey, pThis->cbRssKey, abInput, cbInput);
+        uVirtqPair = pThis->auRssIndirectionTable[uHash & pThis->fRssIndirectionMask & (VIRTIONET_RSS_MAX_INDIRECTION_TABLE - 1)];
+    }
+    else
+    {
+        uint32_t const uHash = virtioNetR3ToeplitzHash(g_abVirtioNetDefaultRssKey, sizeof(g_abVirtioNetDefaultRssKey),
+                                                       abInput, cbInput);
+        uVirtqPair = (uint16_t)(uHash % pThis->cVirtqPairs);
     }
+    return uVirtqPair;
+}
+
+/**
+ * Stores one frame from the network in the guest's Rx queue selected for it.
+ *
+ * The used ring isn't synced, the caller does that for the queues flagged in
+ * @a pbmVirtqPairs.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NET_NO_BUFFER_SPACE if no Rx queue has buffers available.
+ * @param   pDevIns         The device instance.
+ * @param   pThis           The virtio-net shared instance data.
+ * @param   pThisCC         The virtio-net ring-3 instance data.
+ * @param   pvBuf           The frame.
+ * @param   cb              Size of the frame in bytes.
+ * @param   pGso            Segmentation context, NULL if none.
+ * @param   pbmVirtqPairs   Bitmap of the queue pairs whose Rx queue was used,
+ *                          updated.
+ * @thread  RX
+ */
+static int virtioNetR3RxFrame(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIONETCC pThisCC, const void *pvBuf, size_t cb,
+                              PCPDMNETWORKGSO pGso, uint32_t *pbmVirtqPairs)
+{
+    VIRTIONETPKTHDR rxPktHdr = { 0, VIRTIONET_HDR_GSO_NONE, 0, 0, 0, 0, 0 };
+
     /*
      * If GSO (Global Segment Offloading) was received from downstream PDM network device, massage the
      * PDM-provided GSO parameters into VirtIO semantics, which get passed to guest virtio-net via
@@ -2187,17 +2591,24 @@ static DECLCALLBACK(int) virtioNetR3NetworkDown_ReceiveGso(PPDMINETWORKDOWN pInt
         rxPktHdr.uGsoSize      = pGso->cbMaxSeg;
         rxPktHdr.uChksumStart  = pGso->offHdr2;
 
+        /* Let the caller segment the frame if the guest cannot take it as it is. */
         switch (pGso->u8Type)
         {
             case PDMNETWORKGSOTYPE_IPV4_TCP:
+                if (FEATURE_DISABLED(GUEST_TSO4))
+                    return VERR_NOT_SUPPORTED;
                 rxPktHdr.uGsoType = VIRTIONET_HDR_GSO_TCPV4;
                 rxPktHdr.uChksumOffset = RT_OFFSETOF(RTNETTCP, th_sum);
                 break;
             case PDMNETWORKGSOTYPE_IPV6_TCP:
+                if (FEATURE_DISABLED(GUEST_TSO6))
+                    return VERR_NOT_SUPPORTED;
                 rxPktHdr.uGsoType = VIRTIONET_HDR_GSO_TCPV6;
                 rxPktHdr.uChksumOffset = RT_OFFSETOF(RTNETTCP, th_sum);
                 break;
             case PDMNETWORKGSOTYPE_IPV4_UDP:
+                if (FEATURE_DISABLED(GUEST_UFO))
+                    return VERR_NOT_SUPPORTED;
                 rxPktHdr.uGsoType = VIRTIONET_HDR_GSO_UDP;
                 rxPktHdr.uChksumOffset = RT_OFFSETOF(RTNETUDP, uh_sum);
                 break;
@@ -2212,29 +2623,131 @@ static DECLCALLBACK(int) virtioNetR3NetworkDown_ReceiveGso(PPDMINETWORKDOWN pInt
     }
 
     /*
-     * Find a virtq with Rx bufs on avail ring, if any, and copy the packet to the guest's Rx buffer.
-     * @todo pk: PROBABLY NOT A SOPHISTICATED ENOUGH QUEUE SELECTION ALGORTITH FOR OPTIMAL MQ (FEATURE) SUPPORT
+     * Steer the packet to the Rx queue selected by RSS (or the automatic flow hash with plain MQ).
+     * Should that queue be out of buffers, fall back on the next queue with buffers rather than
+     * dropping the packet, as the leaf driver only waits for any queue to have buffers available.
      */
-    for (int uVirtqPair = 0; uVirtqPair < pThis->cVirtqPairs; uVirtqPair++)
+    uint16_t const cRxVirtqs = FEATURE_ENABLED(MQ) ? pThis->virtioNetConfig.uMaxVirtqPairs : 1;
+    uint16_t uVirtqPairFirst = virtioNetR3RxSelectVirtqPair(pThis, (const uint8_t *)pvBuf, cb);
+    if (uVirtqPairFirst >= cRxVirtqs)
+        uVirtqPairFirst = 0;
+    for (uint16_t i = 0; i < cRxVirtqs; i++)
     {
+        uint16_t const uVirtqPair = (uint16_t)((uVirtqPairFirst + i) % cRxVirtqs);
         PVIRTIONETVIRTQ pRxVirtq = &pThis->aVirtqs[RXQIDX(uVirtqPair)];
         if (RT_SUCCESS(virtioNetR3CheckRxBufsAvail(pDevIns, pThis, pRxVirtq)))
         {
             int rc = VINF_SUCCESS;
-            STAM_PROFILE_START(&pThis->StatReceive, a);
-            virtioNetR3SetReadLed(pThisCC, true);
             if (virtioNetR3AddressFilter(pThis, pvBuf, cb))
             {
                 /* rxPktHdr is local stack variable that should not go out of scope in this use */
+                *pbmVirtqPairs |= RT_BIT_32(uVirtqPair);
                 rc = virtioNetR3CopyRxPktToGuest(pDevIns, pThis, pThisCC, pvBuf, cb, &rxPktHdr, pThis->cbPktHdr, pRxVirtq);
                 STAM_REL_COUNTER_ADD(&pThis->StatReceiveBytes, cb);
             }
-            virtioNetR3SetReadLed(pThisCC, false);
-            STAM_PROFILE_STOP(&pThis->StatReceive, a);
             return rc;
         }
     }
-    return VERR_INTERRUPTED;
+    return VERR_NET_NO_BUFFER_SPACE;
+}
+
+/**
+ * Syncs the used rings of the Rx queues frames were stored in.
+ *
+ * @param   pDevIns         The device instance.
+ * @param   pThis           The virtio-net shared instance data.
+ * @param   bmVirtqPairs    Bitmap of the queue pairs whose Rx queue was used.
+ * @thread  RX
+ */
+static void virtioNetR3RxSyncVirtqs(PPDMDEVINS pDevIns, PVIRTIONET pThis, uint32_t bmVirtqPairs)
+{
+    while (bmVirtqPairs)
+    {
+        unsigned const uVirtqPair = ASMBitFirstSetU32(bmVirtqPairs) - 1;
+        bmVirtqPairs &= ~RT_BIT_32(uVirtqPair);
+        virtioCoreVirtqUsedRingSync(pDevIns, &pThis->Virtio, RXQIDX(uVirtqPair));
+    }
+}
+
+/**
+ * @interface_method_impl{PDMINETWORKDOWN,pfnReceiveGso}
+ */
+static DECLCALLBACK(int) virtioNetR3NetworkDown_ReceiveGso(PPDMINETWORKDOWN pInterface, const void *pvBuf, size_t cb,
+                                                           PCPDMNETWORKGSO pGso)
+{
+    PVIRTIONETCC    pThisCC  = RT_FROM_MEMBER(pInterface, VIRTIONETCC, INetworkDown);
+    PPDMDEVINS      pDevIns  = pThisCC->pDevIns;
+    PVIRTIONET      pThis    = PDMDEVINS_2_DATA(pDevIns, PVIRTIONET);
+
+    if (!pThis->fVirtioReady)
+    {
+        LogRelFunc(("VirtIO not ready, aborting downstream receive\n"));
+        return VERR_INTERRUPTED;
+    }
+    if (ASMAtomicReadBool(&pThis->fVHostActive))
+    {
+        Log(("[%s] Dropping frame received while the kernel owns the Rx queue\n", pThis->szInst));
+        return VINF_SUCCESS;
+    }
+
+    STAM_PROFILE_START(&pThis->StatReceive, a);
+    virtioNetR3SetReadLed(pThisCC, true);
+    uint32_t bmVirtqPairs = 0;
+    int rc = virtioNetR3RxFrame(pDevIns, pThis, pThisCC, pvBuf, cb, pGso, &bmVirtqPairs);
+    virtioNetR3RxSyncVirtqs(pDevIns, pThis, bmVirtqPairs);
+    virtioNetR3SetReadLed(pThisCC, false);
+    STAM_PROFILE_STOP(&pThis->StatReceive, a);
+    return rc == VERR_NET_NO_BUFFER_SPACE ? VERR_INTERRUPTED : rc;
+}
+
+/**
+ * @interface_method_impl{PDMINETWORKDOWN,pfnReceiveBurst}
+ */
+static DECLCALLBACK(int) virtioNetR3NetworkDown_ReceiveBurst(PPDMINETWORKDOWN pInterface, PCPDMNETWORKRECVFRAME paFrames,
+                                                             uint32_t cFrames, uint32_t *pcDone)
+{
+    PVIRTIONETCC    pThisCC  = RT_FROM_MEMBER(pInterface, VIRTIONETCC, INetworkDown);
+    PPDMDEVINS      pDevIns  = pThisCC->pDevIns;
+    PVIRTIONET      pThis    = PDMDEVINS_2_DATA(pDevIns, PVIRTIONET);
+
+    *pcDone = 0;
+    if (!pThis->fVirtioReady)
+    {
+        LogRelFunc(("VirtIO not ready, aborting downstream receive\n"));
+        return VERR_INTERRUPTED;
+    }
+    if (ASMAtomicReadBool(&pThis->fVHostActive))
+    {
+        Log(("[%s] Dropping %u frames received while the kernel owns the Rx queue\n", pThis->szInst, cFrames));
+        *pcDone = cFrames;
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Store all the frames and only then publish them, so the guest sees the burst
+     * with one used idx update (and at most one interrupt) per Rx queue.
+     */
+    STAM_PROFILE_START(&pThis->StatReceive, a);
+    STAM_COUNTER_INC(&pThis->StatReceiveBursts);
+    virtioNetR3SetReadLed(pThisCC, true);
+    uint32_t bmVirtqPairs = 0;
+    int      rc           = VINF_SUCCESS;
+    uint32_t iFrame;
+    for (iFrame = 0; iFrame < cFrames; iFrame++)
+    {
+        rc = virtioNetR3RxFrame(pDevIns, pThis, pThisCC, paFrames[iFrame].pvFrame, paFrames[iFrame].cbFrame,
+                                paFrames[iFrame].pGso, &bmVirtqPairs);
+        if (rc == VERR_NET_NO_BUFFER_SPACE)
+            break;
+        if (RT_FAILURE(rc))
+            LogFunc(("[%s] Dropped frame #%u: %Rrc\n", pThis->szInst, iFrame, rc));
+        rc = VINF_SUCCESS;
+    }
+    virtioNetR3RxSyncVirtqs(pDevIns, pThis, bmVirtqPairs);
+    virtioNetR3SetReadLed(pThisCC, false);
+    STAM_PROFILE_STOP(&pThis->StatReceive, a);
+    *pcDone = iFrame;
+    return rc;
 }
 
 /**
@@ -2442,47 +2955,106 @@ static uint8_t virtioNetR3CtrlMultiQueue(PVIRTIONET pThis, PVIRTIONETCC pThisCC,
 {
     LogFunc(("[%s] Processing CTRL MQ command\n", pThis->szInst));
 
+    if (FEATURE_DISABLED(MQ) && FEATURE_DISABLED(RSS))
+    {
+        LogRelFunc(("[%s] CTRL MQ command without MQ or RSS negotiated\n", pThis->szInst));
+        return VIRTIONET_ERROR;
+    }
+
+    uint16_t const cMaxVirtqPairs = pThis->virtioNetConfig.uMaxVirtqPairs;
+    size_t cbRemaining = pVirtqBuf->cbPhysSend;
     uint16_t cVirtqPairs;
     switch(pCtrlPktHdr->uCmd)
     {
         case VIRTIONET_CTRL_MQ_VQ_PAIRS_SET:
         {
-            size_t cbRemaining = pVirtqBuf->cbPhysSend;
-
             AssertMsgReturn(cbRemaining >= sizeof(cVirtqPairs),
                 ("DESC chain too small for VIRTIONET_CTRL_MQ cmd processing"), VIRTIONET_ERROR);
 
             /* Fetch number of virtq pairs from guest buffer */
             virtioCoreR3VirtqBufDrain(&pThis->Virtio, pVirtqBuf, &cVirtqPairs, sizeof(cVirtqPairs));
 
-            AssertMsgReturn(cVirtqPairs <= VIRTIONET_MAX_QPAIRS,
+            AssertMsgReturn(cVirtqPairs >= VIRTIONET_CTRL_MQ_VQ_PAIRS_MIN && cVirtqPairs <= cMaxVirtqPairs,
                 ("[%s] Guest CTRL MQ virtq pair count out of range [%d])\n", pThis->szInst, cVirtqPairs), VIRTIONET_ERROR);
 
             LogFunc(("[%s] Guest specifies %d VQ pairs in use\n", pThis->szInst, cVirtqPairs));
             pThis->cVirtqPairs = cVirtqPairs;
             break;
         }
+        case VIRTIONET_CTRL_MQ_RSS_CONFIG:
+        {
+            /*
+             * struct virtio_net_rss_config: hash_types, indirection_table_mask, unclassified_queue,
+             * indirection_table[indirection_table_mask + 1], max_tx_vq, hash_key_length, hash_key_data[].
+             */
+            AssertMsgReturn(FEATURE_ENABLED(RSS), ("[%s] RSS config without RSS negotiated\n", pThis->szInst),
+                            VIRTIONET_ERROR);
+
+            uint32_t fHashTypes;
+            uint16_t fIndirectionMask;
+            uint16_t uUnclassifiedQueue;
+            AssertMsgReturn(cbRemaining >= sizeof(fHashTypes) + 2 * sizeof(uint16_t),
+                ("DESC chain too small for VIRTIONET_CTRL_MQ_RSS_CONFIG"), VIRTIONET_ERROR);
+            virtioCoreR3VirtqBufDrain(&pThis->Virtio, pVirtqBuf, &fHashTypes, sizeof(fHashTypes));
+            virtioCoreR3VirtqBufDrain(&pThis->Virtio, pVirtqBuf, &fIndirectionMask, sizeof(fIndirectionMask));
+            virtioCoreR3VirtqBufDrain(&pThis->Virtio, pVirtqBuf, &uUnclassifiedQueue, sizeof(uUnclassifiedQueue));
+            cbRemaining -= sizeof(fHashTypes) + 2 * sizeof(uint16_t);
+
+            uint32_t const cEntries = (uint32_t)fIndirectionMask + 1;
+            AssertMsgReturn(   RT_IS_POWER_OF_TWO(cEntries)
+                            && cEntries <= VIRTIONET_RSS_MAX_INDIRECTION_TABLE
+                            && uUnclassifiedQueue < cMaxVirtqPairs,
+                ("[%s] Invalid RSS config: mask=%#x unclassified=%u hash types=%#x\n",
+                 pThis->szInst, fIndirectionMask, uUnclassifiedQueue, fHashTypes), VIRTIONET_ERROR);
+
+            uint16_t auTable[VIRTIONET_RSS_MAX_INDIRECTION_TABLE];
+            AssertMsgReturn(cbRemaining >= cEntries * sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint8_t),
+                ("DESC chain too small for VIRTIONET_CTRL_MQ_RSS_CONFIG"), VIRTIONET_ERROR);
+            virtioCoreR3VirtqBufDrain(&pThis->Virtio, pVirtqBuf, auTable, cEntries * sizeof(uint16_t));
+            cbRemaining -= cEntries * sizeof(uint16_t);
+
+            /* The table entries and the unclassified queue are receive queue (i.e. queue pair) numbers. */
+            for (uint32_t i = 0; i < cEntries; i++)
+                AssertMsgReturn(auTable[i] < cMaxVirtqPairs,
+                    ("[%s] Invalid RSS indirection table entry %u: %u\n", pThis->szInst, i, auTable[i]), VIRTIONET_ERROR);
+
+            uint16_t cMaxTxVirtqs;
+            uint8_t  cbKey;
+            virtioCoreR3VirtqBufDrain(&pThis->Virtio, pVirtqBuf, &cMaxTxVirtqs, sizeof(cMaxTxVirtqs));
+            virtioCoreR3VirtqBufDrain(&pThis->Virtio, pVirtqBuf, &cbKey, sizeof(cbKey));
+            cbRemaining -= sizeof(cMaxTxVirtqs) + sizeof(cbKey);
+            AssertMsgReturn(   cMaxTxVirtqs >= VIRTIONET_CTRL_MQ_VQ_PAIRS_MIN
+                            && cMaxTxVirtqs <= cMaxVirtqPairs
+                            && cbKey <= VIRTIONET_RSS_MAX_KEY_SIZE
+                            && cbRemaining >= cbKey,
+                ("[%s] Invalid RSS config: max_tx_vq=%u key length=%u\n", pThis->szInst, cMaxTxVirtqs, cbKey),
+                VIRTIONET_ERROR);
+            uint8_t abKey[VIRTIONET_RSS_MAX_KEY_SIZE];
+            if (cbKey)
+                virtioCoreR3VirtqBufDrain(&pThis->Virtio, pVirtqBuf, abKey, cbKey);
+
+            /* Only commit the new configuration once everything checked out. */
+            pThis->fRssEnabled           = false;
+            pThis->fRssHashTypes         = fHashTypes & VIRTIONET_RSS_HASH_TYPES_SUPPORTED;
+            pThis->fRssIndirectionMask   = fIndirectionMask;
+            pThis->uRssUnclassifiedQueue = uUnclassifiedQueue;
+            pThis->cbRssKey              = cbKey;
+            memcpy(pThis->auRssIndirectionTable, auTable, cEntries * sizeof(uint16_t));
+            memcpy(pThis->abRssKey, abKey, cbKey);
+            pThis->cVirtqPairs           = cMaxTxVirtqs;
+            ASMAtomicWriteBool(&pThis->fRssEnabled, fHashTypes != 0);
+
+            LogRel(("[%s] RSS %s: hash types=%#x, %u table entries, %u queue pairs\n", pThis->szInst,
+                    fHashTypes ? "enabled" : "disabled", fHashTypes, cEntries, cMaxTxVirtqs));
+            break;
+        }
         default:
             LogRelFunc(("Unrecognized multiqueue subcommand in CTRL pkt from guest\n"));
             return VIRTIONET_ERROR;
     }
 
-    /*
-     * The MQ control function is invoked by the guest in an RPC like manner to change
-     * the Rx/Tx queue pair count. If the new value exceeds the number of queues
-     * (and associated workers) already initialized initialize only the new queues and
-     * respective workers.
-     */
-    if (pThis->cVirtqPairs > pThis->cInitializedVirtqPairs)
-    {
-        virtioNetR3SetVirtqNames(pThis, virtioCoreIsLegacyMode(&pThis->Virtio));
-        int rc = virtioNetR3CreateWorkerThreads(pDevIns, pThis, pThisCC);
-        if (RT_FAILURE(rc))
-        {
-            LogRelFunc(("Failed to create worker threads\n"));
-            return VIRTIONET_ERROR;
-        }
-    }
+    /* All queues and their workers are created up front in the constructor, nothing more to do. */
+    RT_NOREF(pThisCC, pDevIns);
     return VIRTIONET_OK;
 }
 
@@ -2775,11 +3347,21 @@ static int virtioNetR3TransmitPkts(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIO
     }
 
     /*
-     * Only one thread is allowed to transmit at a time, others should skip transmission as the packets
-     * will be picked up by the transmitting thread.
+     * Only one thread is allowed to transmit from a queue at a time, others should skip transmission as
+     * the packets will be picked up by the transmitting thread.  Different queues may be serviced
+     * concurrently, the attached driver serializes the actual transmission with its xmit lock.
      */
-    if (!ASMAtomicCmpXchgU32(&pThis->uIsTransmitting, 1, 0))
+    if (!ASMAtomicCmpXchgU32(&pTxVirtq->uIsTransmitting, 1, 0))
+        return VERR_IGNORED;
+
+    /* The kernel transmits from the first queue while vhost-net is active (checked after claiming
+       the queue, virtioNetR3VHostStart sets the flag before waiting for the queue to be released). */
+    if (   ASMAtomicReadBool(&pThis->fVHostActive)
+        && pTxVirtq->uIdx == TXQIDX(0))
+    {
+        ASMAtomicWriteU32(&pTxVirtq->uIsTransmitting, 0);
         return VERR_IGNORED;
+    }
 
     PPDMINETWORKUP pDrv = pThisCC->pDrv;
     if (pDrv)
@@ -2788,7 +3370,7 @@ static int virtioNetR3TransmitPkts(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIO
         Assert(rc == VINF_SUCCESS || rc == VERR_TRY_AGAIN);
         if (rc == VERR_TRY_AGAIN)
         {
-            ASMAtomicWriteU32(&pThis->uIsTransmitting, 0);
+            ASMAtomicWriteU32(&pTxVirtq->uIsTransmitting, 0);
             return VERR_TRY_AGAIN;
         }
     }
@@ -2804,7 +3386,7 @@ static int virtioNetR3TransmitPkts(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIO
         if (pDrv)
             pDrv->pfnEndXmit(pDrv);
 
-        ASMAtomicWriteU32(&pThis->uIsTransmitting, 0);
+        ASMAtomicWriteU32(&pTxVirtq->uIsTransmitting, 0);
         return VERR_MISSING;
     }
 #ifdef VIRTIO_REL_INFO_DUMP
@@ -2826,6 +3408,7 @@ static int virtioNetR3TransmitPkts(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIO
     VirtqBuf.cRefs     = 1;
 
     PVIRTQBUF pVirtqBuf = &VirtqBuf;
+    uint32_t  cUsedPending = 0;
     while ((rc = virtioCoreR3VirtqAvailBufPeek(pVirtio->pDevInsR3, pVirtio, pTxVirtq->uIdx, pVirtqBuf)) == VINF_SUCCESS)
     {
         Log10Func(("[%s] fetched descriptor chain from %s\n", pThis->szInst, pTxVirtq->szName));
@@ -2861,7 +3444,11 @@ static int virtioNetR3TransmitPkts(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIO
              */
             rc = virtioNetR3ReadVirtioTxPktHdr(pVirtio, pThis, pDevIns, paSegsFromGuest[0].GCPhys, pPktHdr, uFrameSize /* cbFrame */);
             if (RT_FAILURE(rc))
+            {
+                if (cUsedPending)
+                    virtioCoreVirtqUsedRingSync(pVirtio->pDevInsR3, pVirtio, pTxVirtq->uIdx);
                 return rc;
+            }
             virtioCoreGCPhysChainAdvance(pSgPhysSend, pThis->cbPktHdr);
 
             PDMNETWORKGSO  Gso, *pGso = virtioNetR3SetupGsoCtx(&Gso, pPktHdr);
@@ -2932,7 +3519,11 @@ static int virtioNetR3TransmitPkts(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIO
 
             /* No data to return to guest, but necessary to put elem (e.g. desc chain head idx) on used ring */
             virtioCoreR3VirtqUsedBufPut(pVirtio->pDevInsR3, pVirtio, pTxVirtq->uIdx, NULL, pVirtqBuf, true /* fFence */);
-            virtioCoreVirtqUsedRingSync(pVirtio->pDevInsR3, pVirtio, pTxVirtq->uIdx);
+            if (++cUsedPending >= VIRTIONET_TX_USED_SYNC_BATCH)
+            {
+                virtioCoreVirtqUsedRingSync(pVirtio->pDevInsR3, pVirtio, pTxVirtq->uIdx);
+                cUsedPending = 0;
+            }
         }
 
         /* Before we break the loop we need to check if the queue is empty,
@@ -2945,6 +3536,10 @@ static int virtioNetR3TransmitPkts(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIO
             && IS_VIRTQ_EMPTY(pDevIns, &pThis->Virtio, pTxVirtq->uIdx))
             virtioCoreVirtqEnableNotify(&pThis->Virtio, pTxVirtq->uIdx, true /* fEnable */);
     }
+
+    /* Publish the buffers transmitted since the last sync, signalling the guest at most once. */
+    if (cUsedPending)
+        virtioCoreVirtqUsedRingSync(pVirtio->pDevInsR3, pVirtio, pTxVirtq->uIdx);
 #ifdef VIRTIO_REL_INFO_DUMP
     if (rc == VERR_INVALID_STATE)
     {
@@ -2967,7 +3562,7 @@ static int virtioNetR3TransmitPkts(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIO
     if (pDrv)
         pDrv->pfnEndXmit(pDrv);
 
-    ASMAtomicWriteU32(&pThis->uIsTransmitting, 0);
+    ASMAtomicWriteU32(&pTxVirtq->uIsTransmitting, 0);
     return VINF_SUCCESS;
 }
 
@@ -2980,12 +3575,505 @@ static DECLCALLBACK(void) virtioNetR3NetworkDown_XmitPending(PPDMINETWORKDOWN pI
     PVIRTIONETCC    pThisCC = RT_FROM_MEMBER(pInterface, VIRTIONETCC, INetworkDown);
     PPDMDEVINS      pDevIns = pThisCC->pDevIns;
     PVIRTIONET      pThis   = PDMDEVINS_2_DATA(pThisCC->pDevIns, PVIRTIONET);
-    PVIRTIONETVIRTQ pTxVirtq  = &pThis->aVirtqs[TXQIDX(0)];
     STAM_COUNTER_INC(&pThis->StatTransmitByNetwork);
 
-    (void)virtioNetR3TransmitPkts(pDevIns, pThis, pThisCC, pTxVirtq, true /*fOnWorkerThread*/);
+    uint16_t const cTxVirtqs = FEATURE_ENABLED(MQ) ? pThis->cVirtqPairs : 1;
+    for (uint16_t uVirtqPair = 0; uVirtqPair < cTxVirtqs; uVirtqPair++)
+        (void)virtioNetR3TransmitPkts(pDevIns, pThis, pThisCC, &pThis->aVirtqs[TXQIDX(uVirtqPair)], true /*fOnWorkerThread*/);
 }
 
+#ifdef VIRTIONET_WITH_VHOST
+
+/*********************************************************************************************************************************
+*   vhost-net kernel data path (Linux)                                                                                           *
+*********************************************************************************************************************************/
+
+/**
+ * Translates a guest physical address range to the ring-3 address the kernel
+ * knows it by thru the memory table.
+ *
+ * @returns true if the whole range is covered by one mapping, false if not.
+ * @param   pThisCC     The ring-3 state.
+ * @param   GCPhys      The guest physical address.
+ * @param   cb          The size of the range.
+ * @param   puAddr      Where to return the ring-3 address.
+ */
+static bool virtioNetR3VHostGCPhysToUserAddr(PVIRTIONETCC pThisCC, RTGCPHYS GCPhys, size_t cb, uint64_t *puAddr)
+{
+    for (uint32_t i = 0; i < pThisCC->cVHostMappings; i++)
+    {
+        PGMPHYSRAMMAPPING const *pMapping = &pThisCC->aVHostMappings[i];
+        RTGCPHYS const off = GCPhys - pMapping->GCPhys;
+        if (   off < pMapping->cb
+            && cb <= pMapping->cb - off)
+        {
+            *puAddr = (uintptr_t)pMapping->pvR3 + off;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Passes the guest notifications for the first queue pair on to the kernel.
+ *
+ * @param   pThisCC     The ring-3 state.
+ */
+static void virtioNetR3VHostKick(PVIRTIONETCC pThisCC)
+{
+    uint64_t const uOne = 1;
+    for (unsigned i = 0; i < RT_ELEMENTS(pThisCC->afdVHostKick); i++)
+    {
+        ssize_t cbWritten = write(pThisCC->afdVHostKick[i], &uOne, sizeof(uOne));
+        RT_NOREF(cbWritten); /* EAGAIN means the counter is saturated, i.e. the kernel was kicked already. */
+    }
+}
+
+/**
+ * Hands the rings of the first queue pair over to the kernel.
+ *
+ * @returns VBox status code.
+ * @param   pThis       The shared state.
+ * @param   pThisCC     The ring-3 state.
+ */
+static int virtioNetR3VHostSetupRings(PVIRTIONET pThis, PVIRTIONETCC pThisCC)
+{
+    int const fd = pThisCC->fdVHost;
+
+    uint64_t fFeatures = pThis->fNegotiatedFeatures & VIRTIONET_VHOST_RING_FEATURES;
+    if (ioctl(fd, VIRTIONET_VHOST_SET_FEATURES, &fFeatures) != 0)
+        return RTErrConvertFromErrno(errno);
+
+    /* The memory table. */
+    struct
+    {
+        VIRTIONETVHOSTMEM       Hdr;
+        VIRTIONETVHOSTMEMREGION aRegions[VIRTIONET_VHOST_MAX_REGIONS];
+    } MemTable;
+    RT_ZERO(MemTable);
+    MemTable.Hdr.cRegions = pThisCC->cVHostMappings;
+    for (uint32_t i = 0; i < pThisCC->cVHostMappings; i++)
+    {
+        MemTable.aRegions[i].uGuestPhysAddr = pThisCC->aVHostMappings[i].GCPhys;
+        MemTable.aRegions[i].cbMemory       = pThisCC->aVHostMappings[i].cb;
+        MemTable.aRegions[i].uUserspaceAddr = (uintptr_t)pThisCC->aVHostMappings[i].pvR3;
+    }
+    if (ioctl(fd, VIRTIONET_VHOST_SET_MEM_TABLE, &MemTable) != 0)
+        return RTErrConvertFromErrno(errno);
+
+    /* The rings, virtq N is vhost-net ring N (Rx and Tx of the first pair). */
+    for (uint32_t uVirtq = RXQIDX(0); uVirtq <= TXQIDX(0); uVirtq++)
+    {
+        PVIRTQUEUE const pVirtq = &pThis->Virtio.aVirtqueues[uVirtq];
+        if (!virtioCoreIsVirtqEnabled(&pThis->Virtio, uVirtq))
+            return VERR_INVALID_STATE;
+
+        VIRTIONETVHOSTVRINGSTATE State = { uVirtq, pVirtq->uQueueSize };
+        if (ioctl(fd, VIRTIONET_VHOST_SET_VRING_NUM, &State) != 0)
+            return RTErrConvertFromErrno(errno);
+        State.uNum = pVirtq->uAvailIdxShadow;
+        if (pThis->fNegotiatedFeatures & VIRTIO_F_RING_PACKED) /* Packed rings pass the used position (and wrap) too. */
+            State.uNum |= (uint32_t)pVirtq->uUsedIdxShadow << 16;
+        if (ioctl(fd, VIRTIONET_VHOST_SET_VRING_BASE, &State) != 0)
+            return RTErrConvertFromErrno(errno);
+
+        VIRTIONETVHOSTVRINGADDR Addr;
+        RT_ZERO(Addr);
+        Addr.uIndex = uVirtq;
+        if (   !virtioNetR3VHostGCPhysToUserAddr(pThisCC, pVirtq->GCPhysVirtqDesc,
+                                                 16 * (size_t)pVirtq->uQueueSize, &Addr.uDescUserAddr)
+            || !virtioNetR3VHostGCPhysToUserAddr(pThisCC, pVirtq->GCPhysVirtqAvail,
+                                                 6 + 2 * (size_t)pVirtq->uQueueSize, &Addr.uAvailUserAddr)
+            || !virtioNetR3VHostGCPhysToUserAddr(pThisCC, pVirtq->GCPhysVirtqUsed,
+                                                 6 + 8 * (size_t)pVirtq->uQueueSize, &Addr.uUsedUserAddr))
+            return VERR_OUT_OF_RANGE;
+        if (ioctl(fd, VIRTIONET_VHOST_SET_VRING_ADDR, &Addr) != 0)
+            return RTErrConvertFromErrno(errno);
+
+        VIRTIONETVHOSTVRINGFILE File = { uVirtq, pThisCC->afdVHostKick[uVirtq] };
+        if (ioctl(fd, VIRTIONET_VHOST_SET_VRING_KICK, &File) != 0)
+            return RTErrConvertFromErrno(errno);
+        File.fd = pThisCC->afdVHostCall[uVirtq];
+        if (ioctl(fd, VIRTIONET_VHOST_SET_VRING_CALL, &File) != 0)
+            return RTErrConvertFromErrno(errno);
+    }
+    return VINF_SUCCESS;
+}
+
+/**
+ * Detaches the kernel from the rings of the first queue pair and resyncs the
+ * device's view of them.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The shared state.
+ * @param   pThisCC     The ring-3 state.
+ * @param   fRings      Whether the rings were set up, i.e. the ring indexes
+ *                      need syncing.
+ */
+static void virtioNetR3VHostDetachRings(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIONETCC pThisCC, bool fRings)
+{
+    int const fd = pThisCC->fdVHost;
+    for (uint32_t uVirtq = RXQIDX(0); uVirtq <= TXQIDX(0); uVirtq++)
+    {
+        VIRTIONETVHOSTVRINGFILE File = { uVirtq, -1 };
+        ioctl(fd, VIRTIONET_VHOST_NET_SET_BACKEND, &File);
+    }
+    if (!fRings)
+        return;
+
+    for (uint32_t uVirtq = RXQIDX(0); uVirtq <= TXQIDX(0); uVirtq++)
+    {
+        VIRTIONETVHOSTVRINGSTATE State = { uVirtq, 0 };
+        if (ioctl(fd, VIRTIONET_VHOST_GET_VRING_BASE, &State) == 0)
+            virtioCoreR3VirtqSyncShadowIdx(pDevIns, &pThis->Virtio, (uint16_t)uVirtq, (uint16_t)State.uNum);
+        else
+            LogRel(("[%s] vhost-net: Failed to get the base of ring %u: %d\n", pThis->szInst, uVirtq, errno));
+
+        /* Pass on an interrupt the kernel requested after the relay thread stopped looking. */
+        uint64_t cCalls = 0;
+        if (read(pThisCC->afdVHostCall[uVirtq], &cCalls, sizeof(cCalls)) == sizeof(cCalls) && cCalls)
+            virtioCoreR3VirtqRaiseInterrupt(pDevIns, &pThis->Virtio, (uint16_t)uVirtq);
+    }
+}
+
+/**
+ * Hands the first queue pair and the TAP device over to the kernel if possible.
+ *
+ * Runs on the relay thread owning CritSectVHost, as it has to wait for the
+ * device's Tx path and the driver's receive thread to let go.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The shared state.
+ * @param   pThisCC     The ring-3 state.
+ */
+static void virtioNetR3VHostHandOver(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIONETCC pThisCC)
+{
+    Assert(RTCritSectIsOwner(&pThisCC->CritSectVHost));
+    if (   ASMAtomicReadBool(&pThis->fVHostActive)
+        || ASMAtomicReadBool(&pThisCC->fVHostSaving)
+        || !pThis->fVirtioReady
+        || !pThis->fCableConnected
+        || pThis->Virtio.fLegacyDriver)
+        return;
+
+    /* The kernel only gets the first queue pair, the device must not be asked to use more. */
+    if (FEATURE_ENABLED(MQ))
+    {
+        LogRel(("[%s] vhost-net: Not used, the guest negotiated multiqueue\n", pThis->szInst));
+        return;
+    }
+
+    uint64_t const fRingFeatures = pThis->fNegotiatedFeatures & VIRTIONET_VHOST_RING_FEATURES;
+    if ((fRingFeatures & pThisCC->fVHostFeatures) != fRingFeatures)
+    {
+        LogRel(("[%s] vhost-net: Not used, the kernel lacks features %#RX64\n",
+                pThis->szInst, fRingFeatures & ~pThisCC->fVHostFeatures));
+        return;
+    }
+
+    /* The guest RAM must be mapped contiguously in our address space, i.e. NEM mode. */
+    int rc = PDMDevHlpPhysQueryRamMappings(pDevIns, pThisCC->aVHostMappings, RT_ELEMENTS(pThisCC->aVHostMappings),
+                                           &pThisCC->cVHostMappings);
+    if (RT_FAILURE(rc))
+    {
+        pThisCC->cVHostMappings = 0;
+        if (!pThisCC->fVHostNoMappingsLogged)
+        {
+            pThisCC->fVHostNoMappingsLogged = true;
+            LogRel(("[%s] vhost-net: Not used, guest RAM cannot be passed to the kernel (%Rrc)%s\n", pThis->szInst, rc,
+                    rc == VERR_NOT_SUPPORTED ? ", requires the native execution manager (NEM)" : ""));
+        }
+        return;
+    }
+
+    /*
+     * Take the Tx queue away from the device, TransmitPkts checks the flag after claiming the queue.
+     * Wake up the leaf driver's receive thread so it doesn't block the hand over below.
+     */
+    ASMAtomicWriteBool(&pThis->fVHostActive, true);
+    virtioNetWakeupRxBufWaiter(pDevIns);
+    PVIRTIONETVIRTQ const pTxVirtq = &pThis->aVirtqs[TXQIDX(0)];
+    for (unsigned cMsWait = 0; ASMAtomicReadU32(&pTxVirtq->uIsTransmitting) && cMsWait < RT_MS_5SEC; cMsWait++)
+        RTThreadSleep(1);
+
+    RTHCINTPTR hTap = -1;
+    uint32_t fOffloads = 0;
+    if (FEATURE_ENABLED(GUEST_CSUM))
+        fOffloads |= PDMINETWORKVHOST_OFFLOAD_F_CSUM;
+    if (FEATURE_ENABLED(GUEST_TSO4))
+        fOffloads |= PDMINETWORKVHOST_OFFLOAD_F_TSO4;
+    if (FEATURE_ENABLED(GUEST_TSO6))
+        fOffloads |= PDMINETWORKVHOST_OFFLOAD_F_TSO6;
+    if (FEATURE_ENABLED(GUEST_ECN))
+        fOffloads |= PDMINETWORKVHOST_OFFLOAD_F_TSO_ECN;
+    if (FEATURE_ENABLED(GUEST_UFO))
+        fOffloads |= PDMINETWORKVHOST_OFFLOAD_F_UFO;
+    rc = pThisCC->pDrvVHost->pfnHandOver(pThisCC->pDrvVHost, pThis->cbPktHdr, fOffloads, &hTap);
+    if (RT_SUCCESS(rc))
+    {
+        rc = virtioNetR3VHostSetupRings(pThis, pThisCC);
+        if (RT_SUCCESS(rc))
+        {
+            for (uint32_t uVirtq = RXQIDX(0); uVirtq <= TXQIDX(0) && RT_SUCCESS(rc); uVirtq++)
+            {
+                VIRTIONETVHOSTVRINGFILE File = { uVirtq, (int32_t)hTap };
+                if (ioctl(pThisCC->fdVHost, VIRTIONET_VHOST_NET_SET_BACKEND, &File) != 0)
+                    rc = RTErrConvertFromErrno(errno);
+            }
+            if (RT_SUCCESS(rc))
+            {
+                LogRel(("[%s] vhost-net: Kernel data path active (features %#RX64, offloads %#x)\n",
+                        pThis->szInst, fRingFeatures, fOffloads));
+                /* Let the kernel pick up whatever the guest queued meanwhile. */
+                virtioNetR3VHostKick(pThisCC);
+                return;
+            }
+            virtioNetR3VHostDetachRings(pDevIns, pThis, pThisCC, true /*fRings*/);
+        }
+        pThisCC->pDrvVHost->pfnTakeBack(pThisCC->pDrvVHost);
+    }
+    LogRel(("[%s] vhost-net: Failed to hand over to the kernel: %Rrc\n", pThis->szInst, rc));
+
+    ASMAtomicWriteBool(&pThis->fVHostActive, false);
+    virtioNetWakeupRxBufWaiter(pDevIns);
+}
+
+/**
+ * Requests the hand over of the first queue pair and the TAP device to the
+ * kernel, the relay thread does the actual work.
+ *
+ * Called on an EMT when the guest driver becomes ready, when the link comes up
+ * and when the VM resumes.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The shared state.
+ * @param   pThisCC     The ring-3 state.
+ */
+static void virtioNetR3VHostStart(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIONETCC pThisCC)
+{
+    RT_NOREF(pDevIns);
+    if (   pThisCC->fdVHost < 0
+        || !pThisCC->pDrvVHost)
+        return;
+
+    ASMAtomicWriteBool(&pThisCC->fVHostStartPending, true);
+    uint64_t const uOne = 1;
+    if (write(pThisCC->fdVHostWakeup, &uOne, sizeof(uOne)) != sizeof(uOne))
+        LogRel(("[%s] vhost-net: Failed to wake up the relay thread: %d\n", pThis->szInst, errno));
+}
+
+/**
+ * Takes the first queue pair and the TAP device back from the kernel.
+ *
+ * Called on reset, when the VM suspends or powers off and when the link goes
+ * down.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The shared state.
+ * @param   pThisCC     The ring-3 state.
+ */
+static void virtioNetR3VHostStop(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIONETCC pThisCC)
+{
+    if (pThisCC->fdVHost < 0)
+        return;
+
+    /* Waits for a hand over in progress, one requested but not yet started is dropped. */
+    RTCritSectEnter(&pThisCC->CritSectVHost);
+    ASMAtomicWriteBool(&pThisCC->fVHostStartPending, false);
+    if (!ASMAtomicReadBool(&pThis->fVHostActive))
+    {
+        RTCritSectLeave(&pThisCC->CritSectVHost);
+        return;
+    }
+
+    virtioNetR3VHostDetachRings(pDevIns, pThis, pThisCC, true /*fRings*/);
+    if (pThisCC->pDrvVHost)
+        pThisCC->pDrvVHost->pfnTakeBack(pThisCC->pDrvVHost);
+    ASMAtomicWriteBool(&pThis->fVHostActive, false);
+    RTCritSectLeave(&pThisCC->CritSectVHost);
+    LogRel(("[%s] vhost-net: Kernel data path stopped\n", pThis->szInst));
+
+    /* Re-enable guest notifications the kernel might have left suppressed and resume the device's data path. */
+    for (uint16_t uVirtq = RXQIDX(0); uVirtq <= TXQIDX(0); uVirtq++)
+        if (virtioCoreIsVirtqEnabled(&pThis->Virtio, uVirtq))
+            virtioCoreVirtqEnableNotify(&pThis->Virtio, uVirtq, true /* fEnable */);
+    virtioNetWakeupRxBufWaiter(pDevIns);
+    virtioNetVirtqNotified(pDevIns, &pThis->Virtio, TXQIDX(0));
+}
+
+/**
+ * @callback_method_impl{FNSSMDEVLIVEPREP,
+ *      Takes the queues back from the kernel for the duration of a live save.}
+ *
+ * The kernel writes Rx buffers and the used rings without any dirty logging,
+ * so PGM would not resend those pages.  The device's own data path goes thru
+ * PGM and is tracked.
+ */
+static DECLCALLBACK(int) virtioNetR3VHostLivePrep(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
+{
+    PVIRTIONET   pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIONET);
+    PVIRTIONETCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIONETCC);
+    RT_NOREF(pSSM);
+
+    ASMAtomicWriteBool(&pThisCC->fVHostSaving, true);
+    if (ASMAtomicReadBool(&pThis->fVHostActive))
+        LogRel(("[%s] vhost-net: Using the device data path during the live save\n", pThis->szInst));
+    virtioNetR3VHostStop(pDevIns, pThis, pThisCC);
+    return VINF_SUCCESS;
+}
+
+/**
+ * @callback_method_impl{FNSSMDEVSAVEDONE,
+ *      Allows the kernel data path again after a (live) save.}
+ */
+static DECLCALLBACK(int) virtioNetR3VHostSaveDone(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
+{
+    PVIRTIONET   pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIONET);
+    PVIRTIONETCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIONETCC);
+    RT_NOREF(pSSM);
+
+    if (ASMAtomicXchgBool(&pThisCC->fVHostSaving, false))
+    {
+        /* A failed or cancelled live save leaves the VM running, otherwise the resume restarts it. */
+        VMSTATE const enmVMState = PDMDevHlpVMState(pDevIns);
+        if (enmVMState == VMSTATE_RUNNING || enmVMState == VMSTATE_RUNNING_LS)
+            virtioNetR3VHostStart(pDevIns, pThis, pThisCC);
+    }
+    return VINF_SUCCESS;
+}
+
+/**
+ * @callback_method_impl{FNPDMTHREADDEV, Relays kernel interrupt requests to the guest.}
+ */
+static DECLCALLBACK(int) virtioNetR3VHostCallThread(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    PVIRTIONET   pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIONET);
+    PVIRTIONETCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIONETCC);
+
+    if (pThread->enmState == PDMTHREADSTATE_INITIALIZING)
+        return VINF_SUCCESS;
+
+    while (pThread->enmState == PDMTHREADSTATE_RUNNING)
+    {
+        struct pollfd aFds[3];
+        aFds[0].fd      = pThisCC->afdVHostCall[0];
+        aFds[1].fd      = pThisCC->afdVHostCall[1];
+        aFds[2].fd      = pThisCC->fdVHostWakeup;
+        for (unsigned i = 0; i < RT_ELEMENTS(aFds); i++)
+        {
+            aFds[i].events  = POLLIN;
+            aFds[i].revents = 0;
+        }
+        int rc = poll(&aFds[0], RT_ELEMENTS(aFds), -1 /* infinite */);
+        if (pThread->enmState != PDMTHREADSTATE_RUNNING)
+            break;
+        if (rc <= 0)
+            continue; /* EINTR */
+
+        uint64_t cEvents;
+        if (aFds[2].revents & POLLIN)
+        {
+            ssize_t cbRead = read(pThisCC->fdVHostWakeup, &cEvents, sizeof(cEvents));
+            RT_NOREF(cbRead);
+            if (ASMAtomicReadBool(&pThisCC->fVHostStartPending))
+            {
+                RTCritSectEnter(&pThisCC->CritSectVHost);
+                if (ASMAtomicXchgBool(&pThisCC->fVHostStartPending, false))
+                    virtioNetR3VHostHandOver(pDevIns, pThis, pThisCC);
+                RTCritSectLeave(&pThisCC->CritSectVHost);
+            }
+        }
+        for (uint16_t uVirtq = 0; uVirtq < RT_ELEMENTS(pThisCC->afdVHostCall); uVirtq++)
+            if (   (aFds[uVirtq].revents & POLLIN)
+                && read(pThisCC->afdVHostCall[uVirtq], &cEvents, sizeof(cEvents)) == sizeof(cEvents)
+                && ASMAtomicReadBool(&pThis->fVHostActive))
+                virtioCoreR3VirtqRaiseInterrupt(pDevIns, &pThis->Virtio, uVirtq);
+    }
+    return VINF_SUCCESS;
+}
+
+/**
+ * @callback_method_impl{FNPDMTHREADWAKEUPDEV}
+ */
+static DECLCALLBACK(int) virtioNetR3VHostCallThreadWakeup(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    PVIRTIONETCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIONETCC);
+    RT_NOREF(pThread);
+
+    uint64_t const uOne = 1;
+    if (write(pThisCC->fdVHostWakeup, &uOne, sizeof(uOne)) != sizeof(uOne))
+        return RTErrConvertFromErrno(errno);
+    return VINF_SUCCESS;
+}
+
+/**
+ * Opens /dev/vhost-net and creates the eventfds and the call relay thread.
+ *
+ * Failures are not fatal, the device just keeps using its own data path.
+ *
+ * @returns VBox status code.
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The shared state.
+ * @param   pThisCC     The ring-3 state.
+ */
+static int virtioNetR3VHostInit(PPDMDEVINS pDevIns, PVIRTIONET pThis, PVIRTIONETCC pThisCC)
+{
+    pThisCC->fdVHost = open("/dev/vhost-net", O_RDWR | O_CLOEXEC);
+    if (pThisCC->fdVHost < 0)
+        return RTErrConvertFromErrno(errno);
+    if (   ioctl(pThisCC->fdVHost, VIRTIONET_VHOST_SET_OWNER, NULL) != 0
+        || ioctl(pThisCC->fdVHost, VIRTIONET_VHOST_GET_FEATURES, &pThisCC->fVHostFeatures) != 0)
+        return RTErrConvertFromErrno(errno);
+
+    for (unsigned i = 0; i < RT_ELEMENTS(pThisCC->afdVHostKick); i++)
+    {
+        pThisCC->afdVHostKick[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        pThisCC->afdVHostCall[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (pThisCC->afdVHostKick[i] < 0 || pThisCC->afdVHostCall[i] < 0)
+            return RTErrConvertFromErrno(errno);
+    }
+    pThisCC->fdVHostWakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pThisCC->fdVHostWakeup < 0)
+        return RTErrConvertFromErrno(errno);
+
+    int rc = RTCritSectInit(&pThisCC->CritSectVHost);
+    AssertRCReturn(rc, rc);
+
+    char szName[16];
+    RTStrPrintf(szName, sizeof(szName), "VNetVHost%u", pDevIns->iInstance);
+    return PDMDevHlpThreadCreate(pDevIns, &pThisCC->pVHostCallThread, pThis, virtioNetR3VHostCallThread,
+                                 virtioNetR3VHostCallThreadWakeup, 0, RTTHREADTYPE_IO, szName);
+}
+
+/**
+ * Stops the relay thread and closes the vhost-net handles.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThisCC     The ring-3 state.
+ */
+static void virtioNetR3VHostTerm(PPDMDEVINS pDevIns, PVIRTIONETCC pThisCC)
+{
+    if (pThisCC->pVHostCallThread)
+    {
+        int rcThread;
+        PDMDevHlpThreadDestroy(pDevIns, pThisCC->pVHostCallThread, &rcThread);
+        pThisCC->pVHostCallThread = NULL;
+    }
+    if (RTCritSectIsInitialized(&pThisCC->CritSectVHost))
+        RTCritSectDelete(&pThisCC->CritSectVHost);
+
+    int *apfds[] = { &pThisCC->fdVHost, &pThisCC->afdVHostKick[0], &pThisCC->afdVHostKick[1],
+                     &pThisCC->afdVHostCall[0], &pThisCC->afdVHostCall[1], &pThisCC->fdVHostWakeup };
+    for (unsigned i = 0; i < RT_ELEMENTS(apfds); i++)
+        if (*apfds[i] >= 0)
+        {
+            close(*apfds[i]);
+            *apfds[i] = -1;
+        }
+}
+
+#endif /* VIRTIONET_WITH_VHOST */
+
 /**
  * @callback_method_impl{FNTMTIMERDEV, Link Up Timer handler.}
  */
@@ -3071,12 +4159,18 @@ static DECLCALLBACK(int) virtioNetR3NetworkConfig_SetLinkState(PPDMINETWORKCONFI
             Log(("[%s] Link is up\n", pThis->szInst));
             pThis->fCableConnected = true;
             SET_LINK_UP(pThis);
+#ifdef VIRTIONET_WITH_VHOST
+            virtioNetR3VHostStart(pDevIns, pThis, pThisCC);
+#endif
         }
         else /* Link requested to be brought down */
         {
             /* The link was brought down explicitly, make sure it won't come up by timer.  */
             PDMDevHlpTimerStop(pDevIns, pThisCC->hLinkUpTimer);
             Log(("[%s] Link is down\n", pThis->szInst));
+#ifdef VIRTIONET_WITH_VHOST
+            virtioNetR3VHostStop(pDevIns, pThis, pThisCC);
+#endif
             pThis->fCableConnected = false;
             SET_LINK_DOWN(pThis);
         }
@@ -3100,7 +4194,7 @@ static int virtioNetR3DestroyWorkerThreads(PPDMDEVINS pDevIns, PVIRTIONET pThis,
 {
     Log10Func(("[%s]\n", pThis->szInst));
     int rc = VINF_SUCCESS;
-    for (unsigned uIdxWorker = 0; uIdxWorker < pThis->cWorkers; uIdxWorker++)
+    for (unsigned uIdxWorker = 0; uIdxWorker < pThis->cVirtqs; uIdxWorker++)
     {
         PVIRTIONETWORKER   pWorker   = &pThis->aWorkers[uIdxWorker];
         PVIRTIONETWORKERR3 pWorkerR3 = &pThisCC->aWorkers[uIdxWorker];
@@ -3165,18 +4259,8 @@ static int virtioNetR3CreateWorkerThreads(PPDMDEVINS pDevIns, PVIRTIONET pThis,
     Log10Func(("[%s]\n", pThis->szInst));
     int rc;
 
-    /* Create the Control Queue worker anyway whether or not it is feature-negotiated or utilized by the guest.
-     * See related comment for queue construction in the device constructor function for more context.
-     */
-
-    PVIRTIONETVIRTQ pCtlVirtq = &pThis->aVirtqs[CTRLQIDX];
-    rc = virtioNetR3CreateOneWorkerThread(pDevIns, pThis,
-                                          &pThis->aWorkers[CTRLQIDX], &pThisCC->aWorkers[CTRLQIDX], pCtlVirtq);
-    AssertRCReturn(rc, rc);
-
-    pCtlVirtq->fHasWorker = true;
-
-    for (uint16_t uVirtqPair = pThis->cInitializedVirtqPairs; uVirtqPair < pThis->cVirtqPairs; uVirtqPair++)
+    uint16_t const cMaxVirtqPairs = pThis->virtioNetConfig.uMaxVirtqPairs;
+    for (uint16_t uVirtqPair = 0; uVirtqPair < cMaxVirtqPairs; uVirtqPair++)
     {
         PVIRTIONETVIRTQ pTxVirtq = &pThis->aVirtqs[TXQIDX(uVirtqPair)];
         PVIRTIONETVIRTQ pRxVirtq = &pThis->aVirtqs[RXQIDX(uVirtqPair)];
@@ -3189,10 +4273,26 @@ static int virtioNetR3CreateWorkerThreads(PPDMDEVINS pDevIns, PVIRTIONET pThis,
         pRxVirtq->fHasWorker = false;
     }
 
-    if (pThis->cVirtqPairs > pThis->cInitializedVirtqPairs)
-        pThis->cInitializedVirtqPairs = pThis->cVirtqPairs;
+    /* Create the Control Queue worker anyway whether or not it is feature-negotiated or utilized by the guest.
+     * See related comment for queue construction in the device constructor function for more context.
+     *
+     * The index of the control queue depends on whether the guest negotiates VIRTIONET_F_MQ, so when more than
+     * one queue pair is configured there is a worker for both possible locations.  The worker decides on each
+     * wakeup which role its queue currently has (the one at index 2 doubles as the Rx queue of pair 1 with MQ,
+     * in which case it just sleeps).
+     */
+    uint16_t const auCtrlQIdx[2]  = { CTRLQIDX_WITHOUT_MQ, (uint16_t)CTRLQIDX_WITH_MQ(cMaxVirtqPairs) };
+    for (unsigned i = 0; i < (cMaxVirtqPairs > 1 ? 2U : 1U); i++)
+    {
+        PVIRTIONETVIRTQ pCtlVirtq = &pThis->aVirtqs[auCtrlQIdx[i]];
+        rc = virtioNetR3CreateOneWorkerThread(pDevIns, pThis, &pThis->aWorkers[auCtrlQIdx[i]],
+                                              &pThisCC->aWorkers[auCtrlQIdx[i]], pCtlVirtq);
+        AssertRCReturn(rc, rc);
+
+        pCtlVirtq->fHasWorker = true;
+    }
 
-    pThis->cWorkers = pThis->cVirtqPairs + 1 /* One control virtq */;
+    pThis->cWorkers = cMaxVirtqPairs + (cMaxVirtqPairs > 1 ? 2 : 1) /* control virtq(s) */;
 
     return rc;
 }
@@ -3225,7 +4325,18 @@ static DECLCALLBACK(int) virtioNetR3WorkerThread(PPDMDEVINS pDevIns, PPDMTHREAD
     while (   pThread->enmState != PDMTHREADSTATE_TERMINATING
            && pThread->enmState != PDMTHREADSTATE_TERMINATED)
     {
-        if (IS_VIRTQ_EMPTY(pDevIns, &pThis->Virtio,  pVirtq->uIdx))
+        /* While the kernel processes the first queue pair its Tx worker only relays the guest notifications. */
+#ifdef VIRTIONET_WITH_VHOST
+        bool const fVHostRelay = uIdx == TXQIDX(0) && ASMAtomicReadBool(&pThis->fVHostActive);
+#else
+        bool const fVHostRelay = false;
+#endif
+        /* Rx queues are not driven by workers, see below.  A worker can find its queue in the Rx role
+           (or disabled) when it is one of the alternative control queue locations. */
+        if (   fVHostRelay
+            || IS_RX_VIRTQ(uIdx)
+            || !virtioCoreIsVirtqEnabled(&pThis->Virtio, uIdx)
+            || IS_VIRTQ_EMPTY(pDevIns, &pThis->Virtio, uIdx))
         {
             /*  Precisely coordinated atomic interlocks avoid a race condition that results in hung thread
              *  wherein a sloppily coordinated wake-up notification during a transition into or out
@@ -3249,10 +4360,17 @@ static DECLCALLBACK(int) virtioNetR3WorkerThread(PPDMDEVINS pDevIns, PPDMTHREAD
             }
             ASMAtomicWriteBool(&pWorker->fSleeping, false);
         }
+#ifdef VIRTIONET_WITH_VHOST
+        if (fVHostRelay)
+        {
+            virtioNetR3VHostKick(pThisCC);
+            continue;
+        }
+#endif
         /*
-         * Dispatch to the handler for the queue this worker is set up to drive
+         * Dispatch to the handler for the role the queue this worker drives currently has
          */
-        if (pVirtq->fCtlVirtq)
+        if (IS_CTRL_VIRTQ(uIdx))
         {
             Log10Func(("[%s] %s worker woken. Fetching desc chain\n", pThis->szInst, pVirtq->szName));
             VIRTQBUF_T VirtqBuf;
@@ -3272,10 +4390,13 @@ static DECLCALLBACK(int) virtioNetR3WorkerThread(PPDMDEVINS pDevIns, PPDMTHREAD
             }
             virtioNetR3Ctrl(pDevIns, pThis, pThisCC, pVirtqBuf);
         }
-        else /* Must be Tx queue */
+        else if (IS_TX_VIRTQ(uIdx))
         {
             Log10Func(("[%s] %s worker woken. Virtq has data to transmit\n",  pThis->szInst, pVirtq->szName));
-            virtioNetR3TransmitPkts(pDevIns, pThis, pThisCC, pVirtq, false /* fOnWorkerThread */);
+            int rc = virtioNetR3TransmitPkts(pDevIns, pThis, pThisCC, pVirtq, false /* fOnWorkerThread */);
+            /* Another queue holds the driver's xmit lock or another thread is draining this queue, don't spin. */
+            if (rc == VERR_TRY_AGAIN || rc == VERR_IGNORED)
+                RTThreadYield();
         }
         /* Note: Surprise! Rx queues aren't handled by local worker threads. Instead, the PDM network leaf driver
          * invokes PDMINETWORKDOWN.pfnWaitReceiveAvail() callback, which waits until woken by virtioNetVirtqNotified()
@@ -3327,6 +4448,9 @@ static DECLCALLBACK(void) virtioNetR3StatusChg(PVIRTIOCORE pVirtio, PVIRTIOCOREC
         }
 
         virtioNetWakeupRxBufWaiter(pThisCC->pDevIns);
+#ifdef VIRTIONET_WITH_VHOST
+        virtioNetR3VHostStart(pThisCC->pDevIns, pThis, pThisCC);
+#endif
     }
     else
     {
@@ -3335,6 +4459,9 @@ static DECLCALLBACK(void) virtioNetR3StatusChg(PVIRTIOCORE pVirtio, PVIRTIOCOREC
             LogRel(("[%s] Resetting...\n", pThis->szInst));
 #endif /* VIRTIO_REL_INFO_DUMP */
         Log(("\n%-23s: %s VirtIO is resetting ***\n", __FUNCTION__, pThis->szInst));
+#ifdef VIRTIONET_WITH_VHOST
+        virtioNetR3VHostStop(pThisCC->pDevIns, pThis, pThisCC);
+#endif
 
         pThis->virtioNetConfig.uStatus = pThis->fCableConnected ? VIRTIONET_F_LINK_UP : 0;
         Log7(("%-23s: %s Link is %s\n", __FUNCTION__, pThis->szInst, pThis->fCableConnected ? "up" : "down"));
@@ -3345,7 +4472,8 @@ static DECLCALLBACK(void) virtioNetR3StatusChg(PVIRTIOCORE pVirtio, PVIRTIOCOREC
         pThis->fNoMulticast         = false;
         pThis->fNoUnicast           = false;
         pThis->fNoBroadcast         = false;
-        pThis->uIsTransmitting      = 0;
+        pThis->cVirtqPairs          = 1;
+        pThis->fRssEnabled          = false;
         pThis->cUnicastFilterMacs   = 0;
         pThis->cMulticastFilterMacs = 0;
 
@@ -3360,6 +4488,7 @@ static DECLCALLBACK(void) virtioNetR3StatusChg(PVIRTIOCORE pVirtio, PVIRTIOCOREC
         {
             virtioCoreR3VirtqDetach(&pThis->Virtio, uVirtqNbr);
             pThis->aVirtqs[uVirtqNbr].fAttachedToVirtioCore = false;
+            ASMAtomicWriteU32(&pThis->aVirtqs[uVirtqNbr].uIsTransmitting, 0);
         }
     }
 
@@ -3415,6 +4544,10 @@ static DECLCALLBACK(void) virtioNetR3Detach(PPDMDEVINS pDevIns, unsigned iLUN, u
 
     AssertLogRelReturnVoid(iLUN == 0);
 
+#ifdef VIRTIONET_WITH_VHOST
+    virtioNetR3VHostStop(pDevIns, pThis, pThisCC);
+    pThisCC->pDrvVHost = NULL;
+#endif
     pThisCC->pDrvBase = NULL;
     pThisCC->pDrv     = NULL;
 }
@@ -3438,6 +4571,10 @@ static DECLCALLBACK(int) virtioNetR3Attach(PPDMDEVINS pDevIns, unsigned iLUN, ui
         pThisCC->pDrv = PDMIBASE_QUERY_INTERFACE(pThisCC->pDrvBase, PDMINETWORKUP);
         AssertMsgStmt(pThisCC->pDrv, ("Failed to obtain the PDMINETWORKUP interface!\n"),
                       rc = VERR_PDM_MISSING_INTERFACE_BELOW);
+#ifdef VIRTIONET_WITH_VHOST
+        if (pThisCC->fdVHost >= 0)
+            pThisCC->pDrvVHost = PDMIBASE_QUERY_INTERFACE(pThisCC->pDrvBase, PDMINETWORKVHOST);
+#endif
     }
     else if (   rc == VERR_PDM_NO_ATTACHED_DRIVER
              || rc == VERR_PDM_CFG_MISSING_DRIVER_NAME)
@@ -3476,6 +4613,34 @@ static DECLCALLBACK(void *) virtioNetR3QueryInterface(struct PDMIBASE *pInterfac
     return NULL;
 }
 
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnSuspend}
+ */
+static DECLCALLBACK(void) virtioNetR3Suspend(PPDMDEVINS pDevIns)
+{
+#ifdef VIRTIONET_WITH_VHOST
+    /* The kernel must not touch guest memory while the VM is suspended (saved state, etc.). */
+    PVIRTIONET   pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIONET);
+    PVIRTIONETCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIONETCC);
+    virtioNetR3VHostStop(pDevIns, pThis, pThisCC);
+#endif
+    virtioNetWakeupRxBufWaiter(pDevIns);
+}
+
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnResume}
+ */
+static DECLCALLBACK(void) virtioNetR3Resume(PPDMDEVINS pDevIns)
+{
+#ifdef VIRTIONET_WITH_VHOST
+    PVIRTIONET   pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIONET);
+    PVIRTIONETCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIONETCC);
+    virtioNetR3VHostStart(pDevIns, pThis, pThisCC);
+#else
+    RT_NOREF(pDevIns);
+#endif
+}
+
 /**
  * @interface_method_impl{PDMDEVREGR3,pfnReset}
  */
@@ -3506,6 +4671,9 @@ static DECLCALLBACK(int) virtioNetR3Destruct(PPDMDEVINS pDevIns)
     }
 
     virtioNetR3DestroyWorkerThreads(pDevIns, pThis, pThisCC);
+#ifdef VIRTIONET_WITH_VHOST
+    virtioNetR3VHostTerm(pDevIns, pThisCC);
+#endif
     virtioCoreR3Term(pDevIns, &pThis->Virtio, &pThisCC->Virtio);
     return VINF_SUCCESS;
 }
@@ -3587,6 +4755,7 @@ static DECLCALLBACK(int) virtioNetR3Construct(PPDMDEVINS pDevIns, int iInstance,
     pThisCC->INetworkDown.pfnWaitReceiveAvail = virtioNetR3NetworkDown_WaitReceiveAvail;
     pThisCC->INetworkDown.pfnReceive          = virtioNetR3NetworkDown_Receive;
     pThisCC->INetworkDown.pfnReceiveGso       = virtioNetR3NetworkDown_ReceiveGso;
+    pThisCC->INetworkDown.pfnReceiveBurst     = virtioNetR3NetworkDown_ReceiveBurst;
     pThisCC->INetworkDown.pfnXmitPending      = virtioNetR3NetworkDown_XmitPending;
     pThisCC->INetworkConfig.pfnGetMac         = virtioNetR3NetworkConfig_GetMac;
     pThisCC->INetworkConfig.pfnGetLinkState   = virtioNetR3NetworkConfig_GetLinkState;
@@ -3604,7 +4773,9 @@ static DECLCALLBACK(int) virtioNetR3Construct(PPDMDEVINS pDevIns, int iInstance,
                                            "|StatNo"
                                            "|Legacy"
                                            "|MmioBase"
-                                           "|Irq", "");
+                                           "|Irq"
+                                           "|QueuePairs"
+                                           "|VHostNet", "");
 
     /* Get config params */
     int rc = pHlp->pfnCFGMQueryBytes(pCfg, "MAC", pThis->macConfigured.au8, sizeof(pThis->macConfigured));
@@ -3632,6 +4803,28 @@ static DECLCALLBACK(int) virtioNetR3Construct(PPDMDEVINS pDevIns, int iInstance,
 
     Log(("[%s] Link up delay is set to %u seconds\n", pThis->szInst, pThis->cMsLinkUpDelay / 1000));
 
+    uint16_t cMaxVirtqPairs = 1;
+    rc = pHlp->pfnCFGMQueryU16Def(pCfg, "QueuePairs", &cMaxVirtqPairs, 1);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("Configuration error: Failed to get the value of 'QueuePairs'"));
+    if (cMaxVirtqPairs < 1 || cMaxVirtqPairs > VIRTIONET_MAX_QPAIRS)
+        return PDMDevHlpVMSetError(pDevIns, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                                   N_("Configuration error: 'QueuePairs' must be between 1 and %u"), VIRTIONET_MAX_QPAIRS);
+
+    bool fVHostNet = false;
+    rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "VHostNet", &fVHostNet, false);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("Configuration error: Failed to get the value of 'VHostNet'"));
+#ifdef VIRTIONET_WITH_VHOST
+    pThisCC->fdVHost          = -1;
+    pThisCC->afdVHostKick[0]  = pThisCC->afdVHostKick[1] = -1;
+    pThisCC->afdVHostCall[0]  = pThisCC->afdVHostCall[1] = -1;
+    pThisCC->fdVHostWakeup    = -1;
+#else
+    if (fVHostNet)
+        LogRel(("[%s] vhost-net is only available on Linux hosts, ignoring 'VHostNet'\n", pThis->szInst));
+#endif
+
     /* Copy the MAC address configured for the VM to the MMIO accessible Virtio dev-specific config area */
     memcpy(pThis->virtioNetConfig.uMacAddress.au8, pThis->macConfigured.au8, sizeof(pThis->virtioNetConfig.uMacAddress)); /* TBD */
 
@@ -3648,7 +4841,15 @@ static DECLCALLBACK(int) virtioNetR3Construct(PPDMDEVINS pDevIns, int iInstance,
         pThis->virtioNetConfig.uStatus = 0;
 #   endif
 
-    pThis->virtioNetConfig.uMaxVirtqPairs          = VIRTIONET_MAX_QPAIRS;
+    pThis->virtioNetConfig.uMaxVirtqPairs          = cMaxVirtqPairs;
+#   if FEATURE_OFFERED(RSS)
+        pThis->virtioNetConfig.uMtu                           = 0;
+        pThis->virtioNetConfig.uSpeed                         = UINT32_MAX; /* unknown */
+        pThis->virtioNetConfig.uDuplex                        = UINT8_MAX;  /* unknown */
+        pThis->virtioNetConfig.uRssMaxKeySize                 = VIRTIONET_RSS_MAX_KEY_SIZE;
+        pThis->virtioNetConfig.uRssMaxIndirectionTableLength  = VIRTIONET_RSS_MAX_INDIRECTION_TABLE;
+        pThis->virtioNetConfig.fSupportedHashTypes            = VIRTIONET_RSS_HASH_TYPES_SUPPORTED;
+#   endif
     pThisCC->Virtio.pfnFeatureNegotiationComplete  = pfnFeatureNegotiationComplete;
     pThisCC->Virtio.pfnVirtqNotified               = virtioNetVirtqNotified;
     pThisCC->Virtio.pfnStatusChanged               = virtioNetR3StatusChg;
@@ -3674,8 +4875,14 @@ static DECLCALLBACK(int) virtioNetR3Construct(PPDMDEVINS pDevIns, int iInstance,
     virtioNetConfigurePktHdr(pThis, pThis->fOfferLegacy); /* set defaults */
 
     /* Initialize VirtIO core. (*pfnStatusChanged)() callback occurs when both host VirtIO core & guest driver are ready) */
+    /* Multiqueue (and RSS which steers between the queues) is only offered if more than one queue pair is configured. */
+    /* VIRTIO_F_EVENT_IDX lets the guest suppress interrupts for all but the last buffer of an Rx/Tx burst. */
+    /* Buffers are always used in the order the guest made them available. */
+    uint64_t fFeaturesOffered = VIRTIONET_HOST_FEATURES_OFFERED | VIRTIO_F_EVENT_IDX | VIRTIO_F_IN_ORDER;
+    if (cMaxVirtqPairs == 1)
+        fFeaturesOffered &= ~VIRTIONET_HOST_FEATURES_MQ;
     rc = virtioCoreR3Init(pDevIns, &pThis->Virtio, &pThisCC->Virtio, &VirtioPciParams, pThis->szInst,
-                          VIRTIONET_HOST_FEATURES_OFFERED, pThis->fOfferLegacy,
+                          fFeaturesOffered, pThis->fOfferLegacy,
                           &pThis->virtioNetConfig /*pvDevSpecificCap*/, sizeof(pThis->virtioNetConfig));
     if (RT_FAILURE(rc))
         return PDMDEV_SET_ERROR(pDevIns, rc, N_("virtio-net: failed to initialize VirtIO"));
@@ -3684,9 +4891,9 @@ static DECLCALLBACK(int) virtioNetR3Construct(PPDMDEVINS pDevIns, int iInstance,
     /** @todo validating features at this point is most probably pointless, as the negotiation hasn't started yet. */
     if (!virtioNetValidateRequiredFeatures(pThis->fNegotiatedFeatures))
         return PDMDEV_SET_ERROR(pDevIns, rc, N_("virtio-net: Required features not successfully negotiated."));
-    pThis->cVirtqPairs = pThis->virtioNetConfig.uMaxVirtqPairs;
-    pThis->cVirtqs += pThis->cVirtqPairs * 2 + 1;
-    pThis->aVirtqs[CTRLQIDX].fCtlVirtq = true;
+    /* All queues are created up front, the guest activates additional pairs with VIRTIONET_CTRL_MQ_VQ_PAIRS_SET. */
+    pThis->cVirtqPairs = 1;
+    pThis->cVirtqs += cMaxVirtqPairs * 2 + 1;
 
     virtioNetR3SetVirtqNames(pThis, pThis->fOfferLegacy);
     for (unsigned uVirtqNbr = 0; uVirtqNbr < pThis->cVirtqs; uVirtqNbr++)
@@ -3727,6 +4934,32 @@ static DECLCALLBACK(int) virtioNetR3Construct(PPDMDEVINS pDevIns, int iInstance,
     }
     else
         return PDMDEV_SET_ERROR(pDevIns, rc, N_("Failed to attach the network LUN"));
+
+#ifdef VIRTIONET_WITH_VHOST
+    /*
+     * Optional kernel data path for the first queue pair (vhost-net), needs an attached
+     * driver able to hand its TAP device over.
+     */
+    if (fVHostNet)
+    {
+        pThisCC->pDrvVHost = pThisCC->pDrvBase ? PDMIBASE_QUERY_INTERFACE(pThisCC->pDrvBase, PDMINETWORKVHOST) : NULL;
+        if (pThisCC->pDrvVHost)
+        {
+            rc = virtioNetR3VHostInit(pDevIns, pThis, pThisCC);
+            if (RT_FAILURE(rc))
+            {
+                LogRel(("[%s] vhost-net: Not available (%Rrc)\n", pThis->szInst, rc));
+                virtioNetR3VHostTerm(pDevIns, pThisCC);
+                pThisCC->pDrvVHost = NULL;
+            }
+            else
+                LogRel(("[%s] vhost-net: Enabled, kernel features %#RX64\n", pThis->szInst, pThisCC->fVHostFeatures));
+        }
+        else
+            LogRel(("[%s] vhost-net: Not used, the attached network driver doesn't support it\n", pThis->szInst));
+    }
+#endif
+
     /*
      * Status driver
      */
@@ -3740,10 +4973,17 @@ static DECLCALLBACK(int) virtioNetR3Construct(PPDMDEVINS pDevIns, int iInstance,
     /*
      * Register saved state.
      */
+#ifdef VIRTIONET_WITH_VHOST
+    rc = PDMDevHlpSSMRegisterEx(pDevIns, VIRTIONET_SAVEDSTATE_VERSION, sizeof(*pThis), NULL,
+                                pThisCC->pDrvVHost ? virtioNetR3VHostLivePrep : NULL, NULL, NULL, /** @todo r=aeichner Teleportation? */
+                                NULL, virtioNetR3ModernSaveExec, pThisCC->pDrvVHost ? virtioNetR3VHostSaveDone : NULL,
+                                NULL, virtioNetR3ModernLoadExec, virtioNetR3ModernLoadDone);
+#else
     rc = PDMDevHlpSSMRegisterEx(pDevIns, VIRTIONET_SAVEDSTATE_VERSION, sizeof(*pThis), NULL,
                                 NULL, NULL, NULL, /** @todo r=aeichner Teleportation? */
                                 NULL, virtioNetR3ModernSaveExec, NULL,
                                 NULL, virtioNetR3ModernLoadExec, virtioNetR3ModernLoadDone);
+#endif
     AssertRCReturn(rc, rc);
     /*
      * Statistics and debug stuff.
@@ -3771,6 +5011,7 @@ static DECLCALLBACK(int) virtioNetR3Construct(PPDMDEVINS pDevIns, int iInstance,
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatTransmitSend,        STAMTYPE_PROFILE, "Transmit/Send",          STAMUNIT_TICKS_PER_CALL, "Profiling send transmit in HC");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatTransmitByNetwork,   STAMTYPE_COUNTER, "Transmit/ByNetwork",     STAMUNIT_COUNT,          "Network-initiated transmissions");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatTransmitByThread,    STAMTYPE_COUNTER, "Transmit/ByThread",      STAMUNIT_COUNT,          "Thread-initiated transmissions");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatReceiveBursts,       STAMTYPE_COUNTER, "Receive/Bursts",         STAMUNIT_COUNT,          "Frame bursts received from the network");
 # endif
     /*
      * Register the debugger info callback (ignore errors).
@@ -3826,13 +5067,13 @@ const PDMDEVREG g_DeviceVirtioNet =
     /* .pfnMemSetup = */            NULL,
     /* .pfnPowerOn = */             NULL,
     /* .pfnReset = */               virtioNetR3Reset,
-    /* .pfnSuspend = */             virtioNetWakeupRxBufWaiter,
-    /* .pfnResume = */              NULL,
+    /* .pfnSuspend = */             virtioNetR3Suspend,
+    /* .pfnResume = */              virtioNetR3Resume,
     /* .pfnAttach = */              virtioNetR3Attach,
     /* .pfnDetach = */              virtioNetR3Detach,
     /* .pfnQueryInterface = */      NULL,
     /* .pfnInitComplete = */        NULL,
-    /* .pfnPowerOff = */            virtioNetWakeupRxBufWaiter,
+    /* .pfnPowerOff = */            virtioNetR3Suspend,
     /* .pfnSoftReset = */           NULL,
     /* .pfnReserved0 = */           NULL,
     /* .pfnReserved1 = */           NULL,
@@ -55,6 +55,8 @@
 typedef int socklen_t;
 #else
 # include <errno.h>
+# include <netinet/in.h>
+# include <netinet/tcp.h>
  typedef int SOCKET;
 # define closesocket close
 # define INVALID_SOCKET -1
@@ -152,6 +154,9 @@ typedef struct DRVCLOUDTUNNEL
     SOCKET                  iSocketIn;
     /** I/O thread notification socket pair (out). */
     SOCKET                  iSocketOut;
+    /** Set when a notification byte is in flight to the I/O thread, so
+     * that back-to-back frames share a single doorbell. */
+    bool volatile           fIoNotifyPending;
 
     /** SSH private key. */
 
@@ -184,6 +189,10 @@ typedef struct DRVCLOUDTUNNEL
     STAMPROFILE             StatDevRecv;
     /** Profiling packet receive device waiting. */
     STAMPROFILE             StatDevRecvWait;
+    /** Number of transmit bursts drained by the I/O thread. */
+    STAMCOUNTER             StatXmitBursts;
+    /** Number of I/O thread notifications saved by coalescing. */
+    STAMCOUNTER             StatXmitNotifySkipped;
 #endif /* VBOX_WITH_STATISTICS */
 
 #ifdef LOG_ENABLED
@@ -331,6 +340,7 @@ DECLINLINE(void) drvCloudTunnelFreeSgBuf(PDRVCLOUDTUNNEL pThis, PPDMSCATTERGATHE
 DECLINLINE(void) drvCloudTunnelNotifyIoThread(PDRVCLOUDTUNNEL pThis, const char *pszWho)
 {
     RT_NOREF(pszWho);
+    ASMAtomicWriteBool(&pThis->fIoNotifyPending, true);
     int cBytes = send(pThis->iSocketOut, " ", 1, 0);
     if (cBytes == SOCKET_ERROR)
         LogRel(("Failed to send a signalling packet, error code %d", WSAGetLastError())); // @todo!
@@ -338,6 +348,54 @@ DECLINLINE(void) drvCloudTunnelNotifyIoThread(PDRVCLOUDTUNNEL pThis, const char
 }
 
 
+/**
+ * Same as drvCloudTunnelNotifyIoThread(), but does nothing if the I/O thread
+ * has already been notified and has not yet started draining its queue.
+ */
+DECLINLINE(void) drvCloudTunnelNotifyIoThreadCoalesced(PDRVCLOUDTUNNEL pThis, const char *pszWho)
+{
+    RT_NOREF(pszWho);
+    if (!ASMAtomicXchgBool(&pThis->fIoNotifyPending, true))
+    {
+        int cBytes = send(pThis->iSocketOut, " ", 1, 0);
+        if (cBytes == SOCKET_ERROR)
+            LogRel(("Failed to send a signalling packet, error code %d", WSAGetLastError())); // @todo!
+    }
+    else
+        STAM_COUNTER_INC(&pThis->StatXmitNotifySkipped);
+}
+
+
+/**
+ * Corks or uncorks the TCP connection underlying the SSH session.
+ *
+ * While corked, the SSH packets produced for individual frames are merged into
+ * full-sized TCP segments instead of going out one small segment per frame.
+ * Failures are ignored since the session may run over a proxy command pipe.
+ *
+ * @param   pThis               Pointer to the cloud tunnel instance.
+ * @param   fCork               Whether to cork (true) or uncork and push (false).
+ * @thread  I/O
+ */
+static void drvCloudTunnelCorkSession(PDRVCLOUDTUNNEL pThis, bool fCork)
+{
+#if defined(TCP_CORK) || defined(TCP_NOPUSH)
+    socket_t hSocket = ssh_get_fd(pThis->pSshSession);
+    if (hSocket != SSH_INVALID_SOCKET)
+    {
+        int iCork = fCork ? 1 : 0;
+# ifdef TCP_CORK
+        setsockopt(hSocket, IPPROTO_TCP, TCP_CORK, (char *)&iCork, sizeof(iCork));
+# else
+        setsockopt(hSocket, IPPROTO_TCP, TCP_NOPUSH, (char *)&iCork, sizeof(iCork));
+# endif
+    }
+#else
+    RT_NOREF(pThis, fCork);
+#endif
+}
+
+
 /**
  * Worker function for sending packets on I/O thread.
  *
@@ -423,7 +481,7 @@ static DECLCALLBACK(int) drvCloudTunnelUp_SendBuf(PPDMINETWORKUP pInterface, PPD
 
         if (RT_SUCCESS(rc))
         {
-            drvCloudTunnelNotifyIoThread(pThis, "drvCloudTunnelUp_SendBuf");
+            drvCloudTunnelNotifyIoThreadCoalesced(pThis, "drvCloudTunnelUp_SendBuf");
             return VINF_SUCCESS;
         }
 
@@ -563,10 +621,18 @@ static DECLCALLBACK(int) drvCloudTunnelIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD p
         /* Did we get notified by drvCloudTunnelNotifyIoThread() via connected sockets? */
         if (FD_ISSET(pThis->iSocketIn, &fds))
         {
-            char buf[2];
-            recv(pThis->iSocketIn, buf, 1, 0);
-            /* process all outstanding requests but don't wait */
+            char buf[64];
+            recv(pThis->iSocketIn, buf, sizeof(buf), 0);
+            /*
+             * Re-arm the doorbell before draining, so frames queued while we are busy
+             * either get picked up by this burst or ring it again.
+             */
+            ASMAtomicWriteBool(&pThis->fIoNotifyPending, false);
+            STAM_COUNTER_INC(&pThis->StatXmitBursts);
+            /* process all outstanding requests but don't wait, writing the whole burst out corked */
+            drvCloudTunnelCorkSession(pThis, true);
             RTReqQueueProcess(pThis->hIoReqQueue, 0);
+            drvCloudTunnelCorkSession(pThis, false);
         }
 //#endif /* RT_OS_WINDOWS */
     }
@@ -1393,6 +1459,8 @@ static DECLCALLBACK(void) drvCloudTunnelDestruct(PPDMDRVINS pDrvIns)
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReceive);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatDevRecv);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatDevRecvWait);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatXmitBursts);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatXmitNotifySkipped);
 #endif /* VBOX_WITH_STATISTICS */
 }
 
@@ -1435,6 +1503,7 @@ static DECLCALLBACK(int) drvCloudTunnelConstruct(PPDMDRVINS pDrvIns, PCFGMNODE p
     /* ??? */
     pThis->iSocketIn   = INVALID_SOCKET;
     pThis->iSocketOut  = INVALID_SOCKET;
+    pThis->fIoNotifyPending = false;
     pThis->pSshSession = 0;
     pThis->pSshChannel = 0;
 
@@ -1458,6 +1527,8 @@ static DECLCALLBACK(int) drvCloudTunnelConstruct(PPDMDRVINS pDrvIns, PCFGMNODE p
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatReceive,       STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL,    "Profiling packet receive runs.",   "/Drivers/CloudTunnel%d/Receive", pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatDevRecv,       STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL,    "Profiling device receive runs.",   "/Drivers/CloudTunnel%d/DeviceReceive", pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatDevRecvWait,   STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL,    "Profiling device receive waits.",  "/Drivers/CloudTunnel%d/DeviceReceiveWait", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatXmitBursts,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,        "Number of transmit bursts.",       "/Drivers/CloudTunnel%d/XmitBursts", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatXmitNotifySkipped, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,    "Number of coalesced I/O thread notifications.", "/Drivers/CloudTunnel%d/XmitNotifySkipped", pDrvIns->iInstance);
 #endif /* VBOX_WITH_STATISTICS */
 
     /*
@@ -71,6 +71,8 @@
 /** Enables the ring-0 part. */
 #define VBOX_WITH_DRVINTNET_IN_R0
 #endif
+/** The maximum number of frames passed up in one PDMINETWORKDOWN::pfnReceiveBurst call. */
+#define DRVINTNET_RECV_BURST_MAX    64
 
 
 /*********************************************************************************************************************************
@@ -177,6 +179,8 @@ typedef struct DRVINTNET
     STAMCOUNTER                     StatSentGso;
     /** Number of GSO packets received. */
     STAMCOUNTER                     StatReceivedGso;
+    /** Number of frame bursts passed up. */
+    STAMCOUNTER                     StatReceivedBursts;
     /** Number of packets send from ring-0. */
     STAMCOUNTER                     StatSentR0;
     /** The number of times we've had to wake up the xmit thread to continue the
@@ -202,10 +206,21 @@ typedef struct DRVINTNET
 #if defined(RT_OS_DARWIN) && defined(VBOX_WITH_INTNET_SERVICE_IN_R3)
     /** XPC connection handle to the R3 internal network switch service. */
     xpc_connection_t                hXpcCon;
-    /** Flag whether the R3 internal network service is being used. */
-    bool                            fIntNetR3Svc;
     /** Size of the communication buffer in bytes. */
     size_t                          cbBuf;
+    /** Number of send doorbells rung at the R3 switch service. */
+    STAMCOUNTER                     StatXmitDoorbells;
+    /** Number of send doorbells folded into one which was still in flight. */
+    STAMCOUNTER                     StatXmitDoorbellsCoalesced;
+    /** Flag whether the R3 internal network service is being used. */
+    bool                            fIntNetR3Svc;
+    /** Set while a send doorbell is in flight to the switch service, cleared
+     * by the reply handler once the switch has drained the send ring. (atomic) */
+    bool volatile                   fXmitDoorbellBusy;
+    /** Set when frames were committed during the current xmit batch and the
+     * doorbell still has to be rung in drvIntNetUp_EndXmit.  Always accessed
+     * while owning the XmitLock. */
+    bool                            fXmitDoorbellDeferred;
 #endif
 } DRVINTNET;
 AssertCompileMemberAlignment(DRVINTNET, XmitLock, 8);
@@ -289,11 +304,53 @@ static int drvR3IntNetCallSvcAsync(PDRVINTNET pThis, uint32_t uOperation, void *
         xpc_dictionary_set_uint64(hObj, "req-id", uOperation);
         xpc_dictionary_set_data(hObj, "req", pvArg, cbArg);
         xpc_connection_send_message(pThis->hXpcCon, hObj);
+        xpc_release(hObj);
         return VINF_SUCCESS;
     }
     else
         return PDMDrvHlpSUPCallVMMR0Ex(pThis->pDrvInsR3, uOperation, pvArg, cbArg);
 }
+
+
+/**
+ * Rings the send doorbell of the R3 switch service, telling it to drain the
+ * send ring of this interface.
+ *
+ * The frames live in the shared INTNETBUF, so all the switch needs is a
+ * nudge.  Only one doorbell is kept in flight at any time, anything rung while
+ * the previous one is still being processed is folded into it.  The reply
+ * handler clears the busy flag and rings again if the guest managed to commit
+ * more frames after the switch stopped reading the ring, so nothing gets stuck.
+ *
+ * @param   pThis           The internal network driver instance data.
+ */
+static void drvR3IntNetXmitDoorbell(PDRVINTNET pThis)
+{
+    Assert(pThis->fIntNetR3Svc);
+    if (ASMAtomicXchgBool(&pThis->fXmitDoorbellBusy, true))
+    {
+        STAM_REL_COUNTER_INC(&pThis->StatXmitDoorbellsCoalesced);
+        return;
+    }
+    STAM_REL_COUNTER_INC(&pThis->StatXmitDoorbells);
+
+    INTNETIFSENDREQ SendReq;
+    SendReq.Hdr.u32Magic = SUPVMMR0REQHDR_MAGIC;
+    SendReq.Hdr.cbReq = sizeof(SendReq);
+    SendReq.pSession = NIL_RTR0PTR;
+    SendReq.hIf = pThis->hIf;
+
+    xpc_object_t hObj = xpc_dictionary_create(NULL, NULL, 0);
+    xpc_dictionary_set_uint64(hObj, "req-id", VMMR0_DO_INTNET_IF_SEND);
+    xpc_dictionary_set_data(hObj, "req", &SendReq, sizeof(SendReq));
+    xpc_connection_send_message_with_reply(pThis->hXpcCon, hObj, NULL /*targetq*/, ^(xpc_object_t hObjReply) {
+        ASMAtomicWriteBool(&pThis->fXmitDoorbellBusy, false);
+        if (   xpc_get_type(hObjReply) != XPC_TYPE_ERROR
+            && IntNetRingHasMoreToRead(&pThis->pBufR3->Send))
+            drvR3IntNetXmitDoorbell(pThis);
+    });
+    xpc_release(hObj);
+}
 #endif
 
 
@@ -662,7 +719,15 @@ PDMBOTHCBDECL(int) drvIntNetUp_SendBuf(PPDMINETWORKUP pInterface, PPDMSCATTERGAT
      */
     PINTNETHDR pHdr = (PINTNETHDR)pSgBuf->pvAllocator;
     IntNetRingCommitFrameEx(&pThis->CTX_SUFF(pBuf)->Send, pHdr, pSgBuf->cbUsed);
+#if defined(IN_RING3) && defined(RT_OS_DARWIN) && defined(VBOX_WITH_INTNET_SERVICE_IN_R3)
+    int rc = VINF_SUCCESS;
+    if (pThis->fIntNetR3Svc)
+        pThis->fXmitDoorbellDeferred = true; /* Rung once for the whole batch in drvIntNetUp_EndXmit. */
+    else
+        rc = drvIntNetProcessXmit(pThis);
+#else
     int rc = drvIntNetProcessXmit(pThis);
+#endif
     STAM_PROFILE_STOP(&pThis->StatTransmit, a);
 
     /*
@@ -684,6 +749,13 @@ PDMBOTHCBDECL(int) drvIntNetUp_SendBuf(PPDMINETWORKUP pInterface, PPDMSCATTERGAT
 PDMBOTHCBDECL(void) drvIntNetUp_EndXmit(PPDMINETWORKUP pInterface)
 {
     PDRVINTNET pThis = RT_FROM_MEMBER(pInterface, DRVINTNET, CTX_SUFF(INetworkUp));
+#if defined(IN_RING3) && defined(RT_OS_DARWIN) && defined(VBOX_WITH_INTNET_SERVICE_IN_R3)
+    if (pThis->fXmitDoorbellDeferred)
+    {
+        pThis->fXmitDoorbellDeferred = false;
+        drvR3IntNetXmitDoorbell(pThis);
+    }
+#endif
     ASMAtomicUoWriteBool(&pThis->fXmitOnXmitThread, false);
     PDMDrvHlpCritSectLeave(pThis->CTX_SUFF(pDrvIns), &pThis->XmitLock);
 }
@@ -826,6 +898,72 @@ static int drvR3IntNetRecvWaitForSpace(PDRVINTNET pThis)
 }
 
 
+/**
+ * Passes the run of normal frames at the head of the receive ring up in one burst.
+ *
+ * The frames are passed up straight from the ring and only skipped once the
+ * device took them, so the sender cannot reuse the space before that.
+ *
+ * @param   pThis       The driver instance data.
+ * @param   pBuf        The interface buffer.
+ * @param   pRingBuf    The receive ring, the first frame must be a normal one.
+ */
+static void drvR3IntNetRecvBurst(PDRVINTNET pThis, PINTNETBUF pBuf, PINTNETRINGBUF pRingBuf)
+{
+    /*
+     * Collect the frames, walking the ring the same way IntNetRingSkipFrame does
+     * but without consuming anything.
+     */
+    PDMNETWORKRECVFRAME aFrames[DRVINTNET_RECV_BURST_MAX];
+    uint32_t            cFrames     = 0;
+    uint32_t const      offWriteCom = ASMAtomicReadU32(&pRingBuf->offWriteCom);
+    uint32_t            offRead     = ASMAtomicUoReadU32(&pRingBuf->offReadX);
+    while (   offRead != offWriteCom
+           && cFrames < RT_ELEMENTS(aFrames))
+    {
+        PINTNETHDR pHdr = (PINTNETHDR)((uint8_t *)pRingBuf + offRead);
+        if (pHdr->u8Type != INTNETHDR_TYPE_FRAME)
+            break;
+        aFrames[cFrames].pvFrame = IntNetHdrGetFramePtr(pHdr, pBuf);
+        aFrames[cFrames].cbFrame = pHdr->cbFrame;
+        aFrames[cFrames].pGso    = NULL;
+        cFrames++;
+
+        offRead = RT_ALIGN_32(offRead + pHdr->offFrame + pHdr->cbFrame, INTNETHDR_ALIGNMENT);
+        if (offRead >= pRingBuf->offEnd)
+            offRead = pRingBuf->offStart;
+    }
+    Assert(cFrames > 0);
+
+#ifdef LOG_ENABLED
+    if (LogIsEnabled())
+    {
+        uint64_t u64Now = RTTimeProgramNanoTS();
+        LogFlow(("drvR3IntNetRecvBurst: %u frames at %llu ns  deltas: r=%llu t=%llu\n",
+                 cFrames, u64Now, u64Now - pThis->u64LastReceiveTS, u64Now - pThis->u64LastTransferTS));
+        pThis->u64LastReceiveTS = u64Now;
+    }
+#endif
+    STAM_COUNTER_INC(&pThis->StatReceivedBursts);
+
+    /*
+     * Pass them up.  If the device ran out of buffers the rest stays in the ring
+     * and the caller waits for space, on other failures (NIC going down) the
+     * frames are dropped just like when passing them up one by one.
+     */
+    uint32_t cDone = 0;
+    int rc = pThis->pIAboveNet->pfnReceiveBurst(pThis->pIAboveNet, aFrames, cFrames, &cDone);
+    if (RT_FAILURE(rc) && rc != VERR_NET_NO_BUFFER_SPACE)
+    {
+        Log(("drvR3IntNetRecvBurst: pfnReceiveBurst -> %Rrc, dropping %u frames\n", rc, cFrames - cDone));
+        cDone = cFrames;
+    }
+    Assert(cDone <= cFrames);
+    while (cDone-- > 0)
+        IntNetRingSkipFrame(pRingBuf);
+}
+
+
 /**
  * Executes async I/O (RUNNING mode).
  *
@@ -874,7 +1012,15 @@ static int drvR3IntNetRecvRun(PDRVINTNET pThis)
                 int rc = pThis->pIAboveNet->pfnWaitReceiveAvail(pThis->pIAboveNet, 0);
                 if (rc == VINF_SUCCESS)
                 {
-                    if (u8Type == INTNETHDR_TYPE_FRAME)
+                    if (   u8Type == INTNETHDR_TYPE_FRAME
+                        && pThis->pIAboveNet->pfnReceiveBurst)
+                    {
+                        /*
+                         * Normal frames, passed up in bursts.
+                         */
+                        drvR3IntNetRecvBurst(pThis, pBuf, pRingBuf);
+                    }
+                    else if (u8Type == INTNETHDR_TYPE_FRAME)
                     {
                         /*
                          * Normal frame.
@@ -1413,14 +1559,21 @@ static DECLCALLBACK(void) drvR3IntNetDestruct(PPDMDRVINS pDrvIns)
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->cStatYieldsNok);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->cStatLost);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->cStatBadFrames);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->cStatSwitchHashed);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->cStatSwitchScanned);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->StatSend1);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->StatSend2);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->StatRecv1);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->StatRecv2);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pBufR3->StatReserved);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReceivedGso);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReceivedBursts);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatSentGso);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatSentR0);
+#if defined(RT_OS_DARWIN) && defined(VBOX_WITH_INTNET_SERVICE_IN_R3)
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatXmitDoorbells);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatXmitDoorbellsCoalesced);
+#endif
 #ifdef VBOX_WITH_STATISTICS
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReceive);
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatTransmit);
@@ -1430,6 +1583,15 @@ static DECLCALLBACK(void) drvR3IntNetDestruct(PPDMDRVINS pDrvIns)
         PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatXmitProcessRing);
     }
 
+#if defined(RT_OS_DARWIN) && defined(VBOX_WITH_INTNET_SERVICE_IN_R3)
+    /*
+     * Give an in-flight send doorbell a moment to complete, its reply handler
+     * references the instance data.
+     */
+    for (unsigned cTries = 0; cTries < 100 && ASMAtomicReadBool(&pThis->fXmitDoorbellBusy); cTries++)
+        RTThreadSleep(1);
+#endif
+
     /*
      * Close the interface
      */
@@ -2016,6 +2178,7 @@ static DECLCALLBACK(int) drvR3IntNetConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->pBufR3->Recv.cStatFrames,   "Packets/Received",     "Number of received packets.");
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->pBufR3->Send.cStatFrames,   "Packets/Sent",         "Number of sent packets.");
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->StatReceivedGso,            "Packets/Received-Gso", "The GSO portion of the received packets.");
+    PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->StatReceivedBursts,         "Packets/Received-Bursts", "Number of frame bursts passed up.");
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->StatSentGso,                "Packets/Sent-Gso",     "The GSO portion of the sent packets.");
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->StatSentR0,                 "Packets/Sent-R0",      "The ring-0 portion of the sent packets.");
 
@@ -2023,6 +2186,8 @@ static DECLCALLBACK(int) drvR3IntNetConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->pBufR3->cStatYieldsNok,     "YieldOk",              "Number of times yielding helped fix an overflow.");
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->pBufR3->cStatYieldsOk,      "YieldNok",             "Number of times yielding didn't help fix an overflow.");
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->pBufR3->cStatBadFrames,     "BadFrames",            "Number of bad frames seed by the consumers.");
+    PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->pBufR3->cStatSwitchHashed,  "Switch/Hashed",        "Unicast frames switched using the hashed MAC lookup.");
+    PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->pBufR3->cStatSwitchScanned, "Switch/Scanned",       "Unicast frames switched by scanning the whole MAC table.");
     PDMDrvHlpSTAMRegProfile(pDrvIns, &pThis->pBufR3->StatSend1,          "Send1",                "Profiling IntNetR0IfSend.");
     PDMDrvHlpSTAMRegProfile(pDrvIns, &pThis->pBufR3->StatSend2,          "Send2",                "Profiling sending to the trunk.");
     PDMDrvHlpSTAMRegProfile(pDrvIns, &pThis->pBufR3->StatRecv1,          "Recv1",                "Reserved for future receive profiling.");
@@ -2035,6 +2200,10 @@ static DECLCALLBACK(int) drvR3IntNetConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->StatXmitWakeupR0,           "XmitWakeup-R0",        "Xmit thread wakeups from ring-0.");
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->StatXmitWakeupR3,           "XmitWakeup-R3",        "Xmit thread wakeups from ring-3.");
     PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->StatXmitProcessRing,        "XmitProcessRing",      "Time xmit thread was told to process the ring.");
+#if defined(RT_OS_DARWIN) && defined(VBOX_WITH_INTNET_SERVICE_IN_R3)
+    PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->StatXmitDoorbells,          "XmitDoorbells",        "Send doorbells rung at the R3 switch service.");
+    PDMDrvHlpSTAMRegCounter(pDrvIns, &pThis->StatXmitDoorbellsCoalesced, "XmitDoorbellsCoalesced", "Send doorbells folded into one still in flight.");
+#endif
 
     /*
      * Create the async I/O threads.
@@ -58,6 +58,9 @@
 #ifdef RT_OS_FREEBSD
 # include <netinet/in.h>
 #endif
+#ifdef RT_OS_LINUX
+# include <sys/epoll.h>
+#endif
 
 #include <iprt/asm.h>
 #include <iprt/assert.h>
@@ -100,6 +103,24 @@
 #define IPV4_MAX_MTU 65521
 #define IPV4_MIN_MTU 68
 
+/** @def DRVNAT_WITH_EPOLL
+ * Use epoll with persistent registrations instead of handing poll() the
+ * complete socket list on every iteration of the NAT thread. */
+#ifdef RT_OS_LINUX
+# define DRVNAT_WITH_EPOLL
+#endif
+/** The maximum number of events retrieved by one epoll_wait call. */
+#define DRVNAT_EPOLL_MAX_EVENTS 256
+/** The maximum number of NAT engine shards (libslirp instances + threads). */
+#define DRVNAT_MAX_SHARDS 8
+/** The payload size of the pooled receive frame buffers, enough for the
+ * default 1500 byte MTU.  Bigger frames get a buffer of their own. */
+#define DRVNAT_RECV_FRAME_SIZE 1536
+/** The number of receive frame buffers pre-allocated and kept in the pool. */
+#define DRVNAT_RECV_POOL_SIZE 256
+/** The maximum number of frames passed up in one PDMINETWORKDOWN::pfnReceiveBurst call. */
+#define DRVNAT_RECV_BURST_MAX 64
+
 #if RT_CLANG_PREREQ(3, 4) /* Most of the defined functions are not used. */
 # pragma clang diagnostic push
 # pragma clang diagnostic ignored "-Wunused-function"
@@ -127,8 +148,122 @@ typedef struct slirpTimer
     SlirpTimerCb pHandler;
     /** Opaque object passed to callback. */
     void *opaque;
+    /** Index into DRVNAT::papTimerHeap, UINT32_MAX when not armed. */
+    uint32_t idxHeap;
 } SlirpTimer;
 
+#ifdef DRVNAT_WITH_EPOLL
+/**
+ * Per file descriptor epoll registration state.
+ */
+typedef struct DRVNATEPOLLFD
+{
+    /** The events registered with the epoll instance (EPOLLXXX). */
+    uint32_t    fRegistered;
+    /** The fill generation in which libslirp last asked for this descriptor. */
+    uint32_t    uGen;
+    /** The events reported by the last epoll_wait (SLIRP_POLL_XXX). */
+    int         fREvents;
+    /** Whether the descriptor is currently added to the epoll instance. */
+    bool        fInEPoll;
+} DRVNATEPOLLFD;
+/** Pointer to per file descriptor epoll registration state. */
+typedef DRVNATEPOLLFD *PDRVNATEPOLLFD;
+#endif
+
+/**
+ * A frame on its way from libslirp to the guest.
+ *
+ * Frames which fit DRVNAT_RECV_FRAME_SIZE come from a pre-allocated pool
+ * and go back there after delivery, so the NAT threads don't hit the heap
+ * for every frame they output.
+ */
+typedef struct DRVNATRECVFRAME
+{
+    /** Next frame in the receive queue or the free list. */
+    struct DRVNATRECVFRAME *pNext;
+    /** Size of the frame in bytes. */
+    size_t                  cbFrame;
+    /** Whether the buffer belongs to the pool (DRVNAT_RECV_FRAME_SIZE bytes). */
+    bool                    fPooled;
+    /** The frame data. */
+    RT_FLEXIBLE_ARRAY_EXTENSION
+    uint8_t                 abFrame[RT_FLEXIBLE_ARRAY];
+} DRVNATRECVFRAME;
+/** Pointer to a received frame. */
+typedef DRVNATRECVFRAME *PDRVNATRECVFRAME;
+
+/**
+ * A NAT engine shard.
+ *
+ * Each shard is a libslirp instance with its own thread, request queue,
+ * wakeup channel, poll state and timers.  Guest flows are hashed over the
+ * shards, see drvNATShardForFrame.
+ */
+typedef struct DRVNATSHARD
+{
+    /** Pointer to the NAT driver instance this shard belongs to. */
+    struct DRVNAT          *pThis;
+    /** The shard index. */
+    uint32_t                iShard;
+    /** Polling thread. */
+    PPDMTHREAD              pSlirpThread;
+    /** Queue for NAT-thread-external events. */
+    RTREQQUEUE              hSlirpReqQueue;
+#ifdef RT_OS_WINDOWS
+    /** Wakeup socket pair for NAT thread.
+     * Entry #0 is write, entry #1 is read. */
+    SOCKET                  ahWakeupSockPair[2];
+#else
+    /** The write end of the control pipe. */
+    RTPIPE                  hPipeWrite;
+    /** The read end of the control pipe. */
+    RTPIPE                  hPipeRead;
+#endif
+    /** count of unconsumed bytes sent to notify NAT thread */
+    volatile uint64_t       cbWakeupNotifs;
+
+    /**  Pointer to Slirp NAT engine instance */
+    Slirp *pSlirp;
+    /** Count of open socket connections as of last poll fill */
+    unsigned int cSockets;
+    /**
+     * A cSockets length list of file descriptors to poll, filled by slirp
+     *
+     * @note: Array is allocated to fit uPollCap number of pollfd structs.
+     * It is only populated with cSockets number of pollfd structs.
+     */
+    struct pollfd *aPolls;
+    /** Cap of the number of file descriptors to poll, can be increased when needed */
+    unsigned int uPollCap;
+    /** List of timers (in reverse creation order).
+     * @note There is currently only one libslirp timer (v4.8 / 2025-01-16).  */
+    SlirpTimer *pTimerHead;
+    /** Armed timers as a binary min-heap ordered by SlirpTimer::msExpire.
+     * Sized to hold all the timers, so arming a timer cannot fail. */
+    SlirpTimer **papTimerHeap;
+    /** Number of armed timers in papTimerHeap. */
+    uint32_t cTimerHeap;
+    /** Number of timers, i.e. the number of entries papTimerHeap can hold. */
+    uint32_t cTimers;
+#ifdef DRVNAT_WITH_EPOLL
+    /** The epoll instance, -1 if not used and we're falling back on poll(). */
+    int hEPoll;
+    /** The native read end of the control pipe (for epoll). */
+    int fdEPollWakeup;
+    /** Fill generation, incremented before each slirp_pollfds_fill_socket call. */
+    uint32_t uEPollGen;
+    /** Number of entries in paEPollFds. */
+    uint32_t cEPollFds;
+    /** Registration state indexed by file descriptor. */
+    PDRVNATEPOLLFD paEPollFds;
+    /** Event buffer for epoll_wait. */
+    struct epoll_event aEPollEvents[DRVNAT_EPOLL_MAX_EVENTS];
+#endif
+} DRVNATSHARD;
+/** Pointer to a NAT engine shard. */
+typedef DRVNATSHARD *PDRVNATSHARD;
+
 /**
  * NAT network transport driver instance data.
  *
@@ -150,28 +285,11 @@ typedef struct DRVNAT
     PDMNETWORKLINKSTATE     enmLinkState;
     /** tftp server name to provide in the DHCP server response. */
     char                   *pszNextServer;
-    /** Polling thread. */
-    PPDMTHREAD              pSlirpThread;
-    /** Queue for NAT-thread-external events. */
-    RTREQQUEUE              hSlirpReqQueue;
     /** The guest IP for port-forwarding. */
     uint32_t                GuestIP;
     /** Link state set when the VM is suspended. */
     PDMNETWORKLINKSTATE     enmLinkStateWant;
 
-#ifdef RT_OS_WINDOWS
-    /** Wakeup socket pair for NAT thread.
-     * Entry #0 is write, entry #1 is read. */
-    SOCKET                  ahWakeupSockPair[2];
-#else
-    /** The write end of the control pipe. */
-    RTPIPE                  hPipeWrite;
-    /** The read end of the control pipe. */
-    RTPIPE                  hPipeRead;
-#endif
-    /** count of unconsumed bytes sent to notify NAT thread */
-    volatile uint64_t       cbWakeupNotifs;
-
 #define DRV_PROFILE_COUNTER(name, dsc)     STAMPROFILE Stat ## name
 #define DRV_COUNTING_COUNTER(name, dsc)    STAMCOUNTER Stat ## name
 #include "slirp/counters.h"
@@ -186,25 +304,27 @@ typedef struct DRVNAT
     RTCRITSECT              DevAccessLock;
     /** Number of in-flight packets. */
     volatile uint32_t       cPkts;
+    /** Protects the receive frame queue and the frame pool. */
+    RTCRITSECT              RecvFrameLock;
+    /** Head of the queue of frames for the guest (oldest first). */
+    PDRVNATRECVFRAME        pRecvHead;
+    /** Where to link the next queued frame. */
+    PDRVNATRECVFRAME       *ppRecvTail;
+    /** Free list of pooled frame buffers. */
+    PDRVNATRECVFRAME        pRecvFree;
+    /** The pool allocation backing the pooled frame buffers. */
+    void                   *pvRecvPool;
     /** Transmit lock taken by BeginXmit and released by EndXmit. */
     RTCRITSECT              XmitLock;
 
-    /**  Pointer to Slirp NAT engine instance */
-    Slirp *pSlirp;
-    /** Count of open socket connections as of last poll fill */
-    unsigned int cSockets;
-    /**
-     * A cSockets length list of file descriptors to poll, filled by slirp
-     *
-     * @note: Array is allocated to fit uPollCap number of pollfd structs.
-     * It is only populated with cSockets number of pollfd structs.
-     */
-    struct pollfd *aPolls;
-    /** Cap of the number of file descriptors to poll, can be increased when needed */
-    unsigned int uPollCap = 0;
-    /** List of timers (in reverse creation order).
-     * @note There is currently only one libslirp timer (v4.8 / 2025-01-16).  */
-    SlirpTimer *pTimerHead;
+    /** Number of engine shards in use (1 unless configured otherwise). */
+    uint32_t                cShards;
+    /** Guest ports of the port forwarding rules, indexed by fUdp.  Frames from
+     * these ports must go to shard 0 which owns the forwarded connections.
+     * Bits are never cleared again, which errs on the safe side. */
+    uint32_t                abmFwdGuestPorts[2][_64K / 32];
+    /** The engine shards. */
+    DRVNATSHARD             aShards[DRVNAT_MAX_SHARDS];
     /** Flag from Main API that determines if we pass search domain via DHCP */
     bool fPassDomain;
 } DRVNAT;
@@ -216,12 +336,19 @@ typedef DRVNAT *PDRVNAT;
 /*********************************************************************************************************************************
 *   Internal Functions                                                                                                           *
 *********************************************************************************************************************************/
-static void drvNATNotifyNATThread(PDRVNAT pThis, const char *pszWho);
-static int  drvNATTimersAdjustTimeoutDown(PDRVNAT pThis, int cMsTimeout);
-static void drvNATTimersRunExpired(PDRVNAT pThis);
+static void drvNATNotifyNATThread(PDRVNATSHARD pShard, const char *pszWho);
+static void drvNATRecvDrain(PDRVNAT pThis);
+static int  drvNATTimersAdjustTimeoutDown(PDRVNATSHARD pShard, int cMsTimeout);
+static void drvNATTimersRunExpired(PDRVNATSHARD pShard);
 static DECLCALLBACK(int) drvNAT_AddPollCb(slirp_os_socket hFd, int iEvents, void *opaque);
 static int64_t drvNAT_ClockGetNsCb(void *opaque);
 static DECLCALLBACK(int) drvNAT_GetREventsCb(int idx, void *opaque);
+#ifdef DRVNAT_WITH_EPOLL
+static DECLCALLBACK(int) drvNAT_EPollAddCb(slirp_os_socket hFd, int iEvents, void *opaque);
+static DECLCALLBACK(int) drvNAT_EPollGetREventsCb(int idx, void *opaque);
+static int  drvNATEPollWait(PDRVNATSHARD pShard, int cMsTimeout, bool *pfWakeup);
+static void drvNATEPollRemove(PDRVNATSHARD pShard, int fd, PDRVNATEPOLLFD pFd);
+#endif
 static DECLCALLBACK(int) drvNATNotifyApplyPortForwardCommand(PDRVNAT pThis, bool fRemove, bool fUdp, const char *pszHostIp,
                                                              uint16_t u16HostPort, const char *pszGuestIp, uint16_t u16GuestPort);
 
@@ -246,6 +373,7 @@ static DECLCALLBACK(int) drvNATRecv(PPDMDRVINS pDrvIns, PPDMTHREAD pThread)
     while (pThread->enmState == PDMTHREADSTATE_RUNNING)
     {
         RTReqQueueProcess(pThis->hRecvReqQueue, 0);
+        drvNATRecvDrain(pThis);
         if (ASMAtomicReadU32(&pThis->cPkts) == 0)
             RTSemEventWait(pThis->hEventRecv, RT_INDEFINITE_WAIT);
     }
@@ -266,43 +394,157 @@ static DECLCALLBACK(int) drvNATRecvWakeup(PPDMDRVINS pDrvIns, PPDMTHREAD pThread
 }
 
 /**
- * @brief Processes incoming packet (to guest).
+ * Gets a buffer for a frame from libslirp, preferring the pool.
  *
+ * @returns Pointer to the frame buffer, NULL if out of memory.
  * @param   pThis   Pointer to DRVNAT state for current context.
- * @param   pBuf    Pointer to packet buffer.
- * @param   cb      Size of packet in buffer.
+ * @param   cb      The frame size.
  *
- * @thread  NATRX
+ * @thread  NAT
  */
-static DECLCALLBACK(void) drvNATRecvWorker(PDRVNAT pThis, void *pBuf, size_t cb)
+static PDRVNATRECVFRAME drvNATRecvFrameAlloc(PDRVNAT pThis, size_t cb)
 {
-    int rc;
-    STAM_PROFILE_START(&pThis->StatNATRecv, a);
-
-    rc = RTCritSectEnter(&pThis->DevAccessLock);
-    AssertRC(rc);
+    PDRVNATRECVFRAME pFrame = NULL;
+    if (cb <= DRVNAT_RECV_FRAME_SIZE)
+    {
+        RTCritSectEnter(&pThis->RecvFrameLock);
+        pFrame = pThis->pRecvFree;
+        if (pFrame)
+            pThis->pRecvFree = pFrame->pNext;
+        RTCritSectLeave(&pThis->RecvFrameLock);
+    }
+    if (!pFrame)
+    {
+        STAM_COUNTER_INC(&pThis->StatNATRecvFrameAllocs);
+        pFrame = (PDRVNATRECVFRAME)RTMemAlloc(RT_UOFFSETOF_DYN(DRVNATRECVFRAME, abFrame[cb]));
+        if (!pFrame)
+            return NULL;
+        pFrame->fPooled = false;
+    }
+    pFrame->pNext   = NULL;
+    pFrame->cbFrame = cb;
+    return pFrame;
+}
 
-    STAM_PROFILE_START(&pThis->StatNATRecvWait, b);
-    rc = pThis->pIAboveNet->pfnWaitReceiveAvail(pThis->pIAboveNet, RT_INDEFINITE_WAIT);
-    STAM_PROFILE_STOP(&pThis->StatNATRecvWait, b);
+/**
+ * Returns frames to the pool (or the heap).
+ *
+ * @param   pThis   Pointer to DRVNAT state for current context.
+ * @param   pFrames The frames, linked by pNext.
+ */
+static void drvNATRecvFramesFree(PDRVNAT pThis, PDRVNATRECVFRAME pFrames)
+{
+    PDRVNATRECVFRAME pPooled = NULL;
+    PDRVNATRECVFRAME pPooledTail = NULL;
+    while (pFrames)
+    {
+        PDRVNATRECVFRAME const pNext = pFrames->pNext;
+        if (pFrames->fPooled)
+        {
+            pFrames->pNext = pPooled;
+            if (!pPooled)
+                pPooledTail = pFrames;
+            pPooled = pFrames;
+        }
+        else
+            RTMemFree(pFrames);
+        pFrames = pNext;
+    }
 
-    if (RT_SUCCESS(rc))
+    if (pPooled)
     {
-        rc = pThis->pIAboveNet->pfnReceive(pThis->pIAboveNet, pBuf, cb);
-        AssertRC(rc);
-        RTMemFree(pBuf);
-        pBuf = NULL;
+        RTCritSectEnter(&pThis->RecvFrameLock);
+        pPooledTail->pNext = pThis->pRecvFree;
+        pThis->pRecvFree   = pPooled;
+        RTCritSectLeave(&pThis->RecvFrameLock);
     }
-    else if (   rc != VERR_TIMEOUT
-             && rc != VERR_INTERRUPTED)
+}
+
+/**
+ * @brief Passes queued frames up to the guest in bursts.
+ *
+ * Takes the whole receive queue at once and hands it to the device using
+ * PDMINETWORKDOWN::pfnReceiveBurst where available, so the device can
+ * publish a batch of frames with a single guest notification.
+ *
+ * @param   pThis   Pointer to DRVNAT state for current context.
+ *
+ * @thread  NATRX
+ */
+static void drvNATRecvDrain(PDRVNAT pThis)
+{
+    RTCritSectEnter(&pThis->RecvFrameLock);
+    PDRVNATRECVFRAME pFrames = pThis->pRecvHead;
+    pThis->pRecvHead  = NULL;
+    pThis->ppRecvTail = &pThis->pRecvHead;
+    RTCritSectLeave(&pThis->RecvFrameLock);
+
+    while (pFrames)
     {
+        STAM_PROFILE_START(&pThis->StatNATRecv, a);
+
+        /* Collect the next burst. */
+        PDMNETWORKRECVFRAME aFrames[DRVNAT_RECV_BURST_MAX];
+        PDRVNATRECVFRAME const pBurst = pFrames;
+        PDRVNATRECVFRAME pLast = NULL;
+        uint32_t cFrames = 0;
+        while (pFrames && cFrames < RT_ELEMENTS(aFrames))
+        {
+            aFrames[cFrames].pvFrame = pFrames->abFrame;
+            aFrames[cFrames].cbFrame = pFrames->cbFrame;
+            aFrames[cFrames].pGso    = NULL;
+            cFrames++;
+            pLast   = pFrames;
+            pFrames = pFrames->pNext;
+        }
+        pLast->pNext = NULL;
+
+        int rc = RTCritSectEnter(&pThis->DevAccessLock);
         AssertRC(rc);
-    }
 
-    rc = RTCritSectLeave(&pThis->DevAccessLock);
-    AssertRC(rc);
-    ASMAtomicDecU32(&pThis->cPkts);
-    STAM_PROFILE_STOP(&pThis->StatNATRecv, a);
+        uint32_t iFrame = 0;
+        while (iFrame < cFrames)
+        {
+            STAM_PROFILE_START(&pThis->StatNATRecvWait, b);
+            rc = pThis->pIAboveNet->pfnWaitReceiveAvail(pThis->pIAboveNet, RT_INDEFINITE_WAIT);
+            STAM_PROFILE_STOP(&pThis->StatNATRecvWait, b);
+            if (RT_FAILURE(rc))
+            {
+                /* Suspending or powering off, drop the rest like before. */
+                if (   rc != VERR_TIMEOUT
+                    && rc != VERR_INTERRUPTED)
+                    AssertRC(rc);
+                break;
+            }
+
+            if (   pThis->pIAboveNet->pfnReceiveBurst
+                && cFrames - iFrame > 1)
+            {
+                uint32_t cDone = 0;
+                rc = pThis->pIAboveNet->pfnReceiveBurst(pThis->pIAboveNet, &aFrames[iFrame], cFrames - iFrame, &cDone);
+                STAM_COUNTER_INC(&pThis->StatNATRecvBursts);
+                iFrame += cDone;
+                if (RT_FAILURE(rc) && rc != VERR_NET_NO_BUFFER_SPACE)
+                {
+                    AssertRC(rc);
+                    break;
+                }
+            }
+            else
+            {
+                rc = pThis->pIAboveNet->pfnReceive(pThis->pIAboveNet, aFrames[iFrame].pvFrame, aFrames[iFrame].cbFrame);
+                AssertRC(rc);
+                iFrame++;
+            }
+        }
+
+        rc = RTCritSectLeave(&pThis->DevAccessLock);
+        AssertRC(rc);
+
+        drvNATRecvFramesFree(pThis, pBurst);
+        ASMAtomicSubU32(&pThis->cPkts, cFrames);
+        STAM_PROFILE_STOP(&pThis->StatNATRecv, a);
+    }
 }
 
 /**
@@ -336,14 +578,15 @@ static void drvNATFreeSgBuf(PDRVNAT pThis, PPDMSCATTERGATHER pSgBuf)
 /**
  * Worker function for drvNATSend().
  *
- * @param   pThis               Pointer to the NAT instance.
+ * @param   pShard              The NAT engine shard the frame was steered to.
  * @param   pSgBuf              The scatter/gather buffer.
  *
  * @thread  NAT
  */
-static DECLCALLBACK(void) drvNATSendWorker(PDRVNAT pThis, PPDMSCATTERGATHER pSgBuf)
+static DECLCALLBACK(void) drvNATSendWorker(PDRVNATSHARD pShard, PPDMSCATTERGATHER pSgBuf)
 {
-    LogFlowFunc(("pThis=%p pSgBuf=%p\n", pThis, pSgBuf));
+    PDRVNAT const pThis = pShard->pThis;
+    LogFlowFunc(("pThis=%p iShard=%u pSgBuf=%p\n", pThis, pShard->iShard, pSgBuf));
 
     if (pThis->enmLinkState != PDMNETWORKLINKSTATE_UP)
     {
@@ -358,7 +601,7 @@ static DECLCALLBACK(void) drvNATSendWorker(PDRVNAT pThis, PPDMSCATTERGATHER pSgB
          * A normal frame.
          */
         LogFlowFunc(("Normal Frame -> pvAllocator=%p LB %#zx\n", pSgBuf->pvAllocator, pSgBuf->cbUsed));
-        slirp_input(pThis->pSlirp, (uint8_t const *)pSgBuf->pvAllocator, (int)pSgBuf->cbUsed);
+        slirp_input(pShard->pSlirp, (uint8_t const *)pSgBuf->pvAllocator, (int)pSgBuf->cbUsed);
         drvNATFreeSgBuf(pThis, pSgBuf);
         LogFlowFuncLeave();
         return;
@@ -389,7 +632,7 @@ static DECLCALLBACK(void) drvNATSendWorker(PDRVNAT pThis, PPDMSCATTERGATHER pSgB
 
             memcpy(&pbSeg[cbHdrs], &pbFrame[offPayload], cbPayload);
 
-            slirp_input(pThis->pSlirp, pbSeg, (int)(cbPayload + cbHdrs));
+            slirp_input(pShard->pSlirp, pbSeg, (int)(cbPayload + cbHdrs));
         }
     }
 
@@ -408,7 +651,7 @@ static DECLCALLBACK(int) drvNATNetworkUp_BeginXmit(PPDMINETWORKUP pInterface, bo
     if (RT_FAILURE(rc))
     {
         rc = VERR_TRY_AGAIN;
-        drvNATNotifyNATThread(pThis, "drvNATNetworkUp_BeginXmit");
+        drvNATNotifyNATThread(&pThis->aShards[0], "drvNATNetworkUp_BeginXmit");
     }
     LogFlowFunc(("Beginning xmit...\n"));
     return rc;
@@ -428,7 +671,7 @@ static DECLCALLBACK(int) drvNATNetworkUp_AllocBuf(PPDMINETWORKUP pInterface, siz
     /*
      * Drop the incoming frame if the NAT thread isn't running.
      */
-    if (pThis->pSlirpThread->enmState != PDMTHREADSTATE_RUNNING)
+    if (pThis->aShards[0].pSlirpThread->enmState != PDMTHREADSTATE_RUNNING)
     {
         Log(("drvNATNetowrkUp_AllocBuf: returns VERR_NET_DOWN\n"));
         return VERR_NET_DOWN;
@@ -514,6 +757,104 @@ static DECLCALLBACK(int) drvNATNetworkUp_FreeBuf(PPDMINETWORKUP pInterface, PPDM
     return VINF_SUCCESS;
 }
 
+/**
+ * Picks the NAT engine shard which owns the flow of a guest frame.
+ *
+ * Only IPv4 TCP and UDP flows are spread out, everything else the engines keep
+ * state about outside the socket layer (DHCP, ICMP, IPv6, fragments and port
+ * forwarding) stays with the first shard.  ARP goes to all of them.
+ *
+ * @returns Shard index, UINT32_MAX if the frame must be seen by all shards.
+ * @param   pThis               Pointer to the NAT instance.
+ * @param   pbFrame             The ethernet frame.
+ * @param   cbFrame             The size of the frame.
+ *
+ * @thread  EMT
+ */
+static uint32_t drvNATShardForFrame(PDRVNAT pThis, uint8_t const *pbFrame, size_t cbFrame)
+{
+    if (pThis->cShards <= 1)
+        return 0;
+    if (cbFrame < sizeof(RTNETETHERHDR))
+        return 0;
+
+    PCRTNETETHERHDR const pEthHdr = (PCRTNETETHERHDR)pbFrame;
+    uint16_t const u16EtherType = RT_BE2H_U16(pEthHdr->EtherType);
+    if (u16EtherType == RTNET_ETHERTYPE_ARP)
+    {
+        /* Every engine needs to learn the guest MAC address, which the engines do from
+           requests as well as replies.  Only the first shard answers requests, see
+           drvNAT_SendPacketCb. */
+        return UINT32_MAX;
+    }
+    if (u16EtherType != RTNET_ETHERTYPE_IPV4)
+        return 0;
+
+    if (cbFrame < sizeof(RTNETETHERHDR) + RTNETIPV4_MIN_LEN)
+        return 0;
+    PCRTNETIPV4 const pIpHdr = (PCRTNETIPV4)(pEthHdr + 1);
+    size_t const      cbIpHdr = pIpHdr->ip_hl * 4;
+    if (   cbIpHdr < RTNETIPV4_MIN_LEN
+        || (RT_BE2H_U16(pIpHdr->ip_off) & (RTNETIPV4_FLAGS_MF | UINT16_C(0x1fff) /* offset */))
+        || (pIpHdr->ip_p != RTNETIPV4_PROT_TCP && pIpHdr->ip_p != RTNETIPV4_PROT_UDP)
+        || cbFrame < sizeof(RTNETETHERHDR) + cbIpHdr + 4)
+        return 0;
+
+    /* The source and destination ports are at the same place for TCP and UDP. */
+    uint16_t const *pau16Ports = (uint16_t const *)((uint8_t const *)pIpHdr + cbIpHdr);
+    uint16_t const  uSrcPort   = RT_BE2H_U16(pau16Ports[0]);
+    uint16_t const  uDstPort   = RT_BE2H_U16(pau16Ports[1]);
+    bool const      fUdp       = pIpHdr->ip_p == RTNETIPV4_PROT_UDP;
+    if (ASMBitTest(&pThis->abmFwdGuestPorts[fUdp][0], uSrcPort))
+        return 0;
+    if (fUdp && uDstPort == RTNETIPV4_PORT_BOOTPS)
+        return 0;
+
+    uint32_t uHash = pIpHdr->ip_src.u ^ RT_BSWAP_U32(pIpHdr->ip_dst.u);
+    uHash ^= ((uint32_t)uSrcPort << 16 | uDstPort) ^ pIpHdr->ip_p;
+    uHash ^= uHash >> 16;
+    uHash *= UINT32_C(0x7feb352d);
+    uHash ^= uHash >> 15;
+    return uHash % pThis->cShards;
+}
+
+/**
+ * Queues a copy of a guest frame to a shard other than the one handling the
+ * original.
+ *
+ * @param   pShard              The NAT engine shard to queue the copy to.
+ * @param   pSgBuf              The (non-GSO) frame to copy.
+ *
+ * @thread  EMT
+ */
+static void drvNATShardQueueCopy(PDRVNATSHARD pShard, PPDMSCATTERGATHER pSgBuf)
+{
+    Assert(!pSgBuf->pvUser);
+    PPDMSCATTERGATHER pSgCopy = (PPDMSCATTERGATHER)RTMemAllocZ(sizeof(PDMSCATTERGATHER));
+    if (!pSgCopy)
+        return;
+    pSgCopy->aSegs[0].cbSeg = RT_ALIGN_Z(pSgBuf->cbUsed, 128);
+    pSgCopy->aSegs[0].pvSeg = RTMemAlloc(pSgCopy->aSegs[0].cbSeg);
+    pSgCopy->pvAllocator    = pSgCopy->aSegs[0].pvSeg;
+    if (!pSgCopy->pvAllocator)
+    {
+        RTMemFree(pSgCopy);
+        return;
+    }
+    memcpy(pSgCopy->aSegs[0].pvSeg, pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed);
+    pSgCopy->fFlags      = PDMSCATTERGATHER_FLAGS_MAGIC | PDMSCATTERGATHER_FLAGS_OWNER_1;
+    pSgCopy->cbUsed      = pSgBuf->cbUsed;
+    pSgCopy->cbAvailable = pSgCopy->aSegs[0].cbSeg;
+    pSgCopy->cSegs       = 1;
+
+    int rc = RTReqQueueCallEx(pShard->hSlirpReqQueue, NULL /*ppReq*/, 0 /*cMillies*/, RTREQFLAGS_VOID | RTREQFLAGS_NO_WAIT,
+                              (PFNRT)drvNATSendWorker, 2, pShard, pSgCopy);
+    if (RT_SUCCESS(rc))
+        drvNATNotifyNATThread(pShard, "drvNATShardQueueCopy");
+    else
+        drvNATFreeSgBuf(pShard->pThis, pSgCopy);
+}
+
 /**
  * @interface_method_impl{PDMINETWORKUP,pfnSendBuf}
  */
@@ -527,13 +868,23 @@ static DECLCALLBACK(int) drvNATNetworkUp_SendBuf(PPDMINETWORKUP pInterface, PPDM
     LogFlowFunc(("enter\n"));
 
     int rc;
-    if (pThis->pSlirpThread->enmState == PDMTHREADSTATE_RUNNING)
+    if (pThis->aShards[0].pSlirpThread->enmState == PDMTHREADSTATE_RUNNING)
     {
-        rc = RTReqQueueCallEx(pThis->hSlirpReqQueue, NULL /*ppReq*/, 0 /*cMillies*/, RTREQFLAGS_VOID | RTREQFLAGS_NO_WAIT,
-                              (PFNRT)drvNATSendWorker, 2, pThis, pSgBuf);
+        uint32_t iShard = drvNATShardForFrame(pThis, (uint8_t const *)pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed);
+        if (iShard == UINT32_MAX)
+        {
+            /* Hand copies to all but the first shard, which gets the original. */
+            for (iShard = 1; iShard < pThis->cShards; iShard++)
+                drvNATShardQueueCopy(&pThis->aShards[iShard], pSgBuf);
+            iShard = 0;
+        }
+
+        PDRVNATSHARD const pShard = &pThis->aShards[iShard];
+        rc = RTReqQueueCallEx(pShard->hSlirpReqQueue, NULL /*ppReq*/, 0 /*cMillies*/, RTREQFLAGS_VOID | RTREQFLAGS_NO_WAIT,
+                              (PFNRT)drvNATSendWorker, 2, pShard, pSgBuf);
         if (RT_SUCCESS(rc))
         {
-            drvNATNotifyNATThread(pThis, "drvNATNetworkUp_SendBuf");
+            drvNATNotifyNATThread(pShard, "drvNATNetworkUp_SendBuf");
             LogFlowFunc(("leave success\n"));
             return VINF_SUCCESS;
         }
@@ -559,30 +910,30 @@ static DECLCALLBACK(void) drvNATNetworkUp_EndXmit(PPDMINETWORKUP pInterface)
 /**
  * Get the NAT thread out of poll/WSAWaitForMultipleEvents
  */
-static void drvNATNotifyNATThread(PDRVNAT pThis, const char *pszWho)
+static void drvNATNotifyNATThread(PDRVNATSHARD pShard, const char *pszWho)
 {
 #ifndef LOG_ENABLED
     RT_NOREF(pszWho);
 #endif
     Log3(("Notifying NAT Thread. Culprit: %s\n", pszWho));
 #ifdef RT_OS_WINDOWS
-    int cbWritten = send(pThis->ahWakeupSockPair[0], "", 1, NULL);
+    int cbWritten = send(pShard->ahWakeupSockPair[0], "", 1, NULL);
     if (RT_LIKELY(cbWritten != SOCKET_ERROR))
     {
         /* Count how many bites we send down the socket */
-        ASMAtomicIncU64(&pThis->cbWakeupNotifs);
+        ASMAtomicIncU64(&pShard->cbWakeupNotifs);
     }
     else
         Log4(("Notify NAT Thread Error %d\n", WSAGetLastError()));
 #else
     /* kick poll() */
     size_t cbIgnored;
-    int rc = RTPipeWrite(pThis->hPipeWrite, "", 1, &cbIgnored);
+    int rc = RTPipeWrite(pShard->hPipeWrite, "", 1, &cbIgnored);
     AssertRC(rc);
     if (RT_SUCCESS(rc))
     {
         /* Count how many bites we send down the socket */
-        ASMAtomicIncU64(&pThis->cbWakeupNotifs);
+        ASMAtomicIncU64(&pShard->cbWakeupNotifs);
     }
 #endif
 }
@@ -641,18 +992,19 @@ static DECLCALLBACK(void) drvNATNetworkUp_NotifyLinkChanged(PPDMINETWORKUP pInte
 
     /* Don't queue new requests if the NAT thread is not running (e.g. paused,
      * stopping), otherwise we would deadlock. Memorize the change. */
-    if (pThis->pSlirpThread->enmState != PDMTHREADSTATE_RUNNING)
+    PDRVNATSHARD const pShard0 = &pThis->aShards[0];
+    if (pShard0->pSlirpThread->enmState != PDMTHREADSTATE_RUNNING)
     {
         pThis->enmLinkStateWant = enmLinkState;
         return;
     }
 
     PRTREQ pReq;
-    int rc = RTReqQueueCallEx(pThis->hSlirpReqQueue, &pReq, 0 /*cMillies*/, RTREQFLAGS_VOID,
+    int rc = RTReqQueueCallEx(pShard0->hSlirpReqQueue, &pReq, 0 /*cMillies*/, RTREQFLAGS_VOID,
                               (PFNRT)drvNATNotifyLinkChangedWorker, 2, pThis, enmLinkState);
     if (rc == VERR_TIMEOUT)
     {
-        drvNATNotifyNATThread(pThis, "drvNATNetworkUp_NotifyLinkChanged");
+        drvNATNotifyNATThread(pShard0, "drvNATNetworkUp_NotifyLinkChanged");
         rc = RTReqWait(pReq, RT_INDEFINITE_WAIT);
         AssertRC(rc);
     }
@@ -665,7 +1017,7 @@ static DECLCALLBACK(void) drvNATNetworkUp_NotifyLinkChanged(PPDMINETWORKUP pInte
  * NAT thread handling the slirp stuff.
  *
  * The slirp implementation is single-threaded so we execute this enginre in a
- * dedicated thread. We take care that this thread does not become the
+ * dedicated thread, one per shard. We take care that this thread does not become the
  * bottleneck: If the guest wants to send, a request is enqueued into the
  * hSlirpReqQueue and handled asynchronously by this thread. If this thread
  * wants to deliver packets to the guest, it enqueues a request into
@@ -680,26 +1032,29 @@ static DECLCALLBACK(void) drvNATNetworkUp_NotifyLinkChanged(PPDMINETWORKUP pInte
  */
 static DECLCALLBACK(int) drvNATAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThread)
 {
-    PDRVNAT pThis = PDMINS_2_DATA(pDrvIns, PDRVNAT);
+    PDRVNATSHARD const pShard = (PDRVNATSHARD)pThread->pvUser;
+    PDRVNAT const      pThis  = pShard->pThis;
+    RT_NOREF(pDrvIns);
 
     /* The first polling entry is for the control/wakeup pipe. */
 #ifdef RT_OS_WINDOWS
-    drvNAT_AddPollCb(pThis->ahWakeupSockPair[1], SLIRP_POLL_IN | SLIRP_POLL_HUP, pThis);
+    drvNAT_AddPollCb(pShard->ahWakeupSockPair[1], SLIRP_POLL_IN | SLIRP_POLL_HUP, pShard);
 #else
-    RTHCINTPTR const i64NativeReadPipe = RTPipeToNative(pThis->hPipeRead);
+    RTHCINTPTR const i64NativeReadPipe = RTPipeToNative(pShard->hPipeRead);
     int const        fdNativeReadPipe  = (int)i64NativeReadPipe;
     Assert(fdNativeReadPipe == i64NativeReadPipe);
     Assert(fdNativeReadPipe >= 0);
     drvNAT_AddPollCb(fdNativeReadPipe,
-                     SLIRP_POLL_IN | SLIRP_POLL_PRI | SLIRP_POLL_HUP, pThis);
+                     SLIRP_POLL_IN | SLIRP_POLL_PRI | SLIRP_POLL_HUP, pShard);
 #endif /* !RT_OS_WINDOWS */
 
-    LogFlowFunc(("pThis=%p\n", pThis));
+    LogFlowFunc(("pThis=%p iShard=%u\n", pThis, pShard->iShard));
 
     if (pThread->enmState == PDMTHREADSTATE_INITIALIZING)
         return VINF_SUCCESS;
 
-    if (pThis->enmLinkStateWant != pThis->enmLinkState)
+    /* Only the first shard owns the link state. */
+    if (pShard->iShard == 0 && pThis->enmLinkStateWant != pThis->enmLinkState)
         drvNATNotifyLinkChangedWorker(pThis, pThis->enmLinkStateWant);
 
     /*
@@ -707,41 +1062,64 @@ static DECLCALLBACK(int) drvNATAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
      */
     while (pThread->enmState == PDMTHREADSTATE_RUNNING)
     {
-        /*
-         * To prevent concurrent execution of sending/receiving threads
-         */
-        pThis->cSockets = 1;
+        bool fWakeup;
+#ifdef DRVNAT_WITH_EPOLL
+        if (pShard->hEPoll != -1)
+        {
+            /*
+             * Let libslirp tell us what it wants and have epoll_wait only
+             * report ready descriptors, no rebuilding of any array involved.
+             */
+            pShard->uEPollGen++;
+            uint32_t cMsTimeout = DRVNAT_DEFAULT_TIMEOUT;
+            slirp_pollfds_fill_socket(pShard->pSlirp, &cMsTimeout, drvNAT_EPollAddCb, pShard /* opaque */);
+            cMsTimeout = drvNATTimersAdjustTimeoutDown(pShard, cMsTimeout);
+            Log4Func(("Timeout adjust to: %d\n", cMsTimeout));
+
+            fWakeup = false;
+            int const cEvents = drvNATEPollWait(pShard, (int)cMsTimeout, &fWakeup);
+            slirp_pollfds_poll(pShard->pSlirp, cEvents < 0, drvNAT_EPollGetREventsCb, pShard /* opaque */);
+        }
+        else
+#endif
+        {
+            /*
+             * To prevent concurrent execution of sending/receiving threads
+             */
+            pShard->cSockets = 1;
 
-        uint32_t cMsTimeout = DRVNAT_DEFAULT_TIMEOUT;
-        slirp_pollfds_fill_socket(pThis->pSlirp, &cMsTimeout, drvNAT_AddPollCb /* SlirpAddPollCb */, pThis /* opaque */);
-        cMsTimeout = drvNATTimersAdjustTimeoutDown(pThis, cMsTimeout);
-        Log4Func(("Timeout adjust to: %d\n", cMsTimeout));
+            uint32_t cMsTimeout = DRVNAT_DEFAULT_TIMEOUT;
+            slirp_pollfds_fill_socket(pShard->pSlirp, &cMsTimeout, drvNAT_AddPollCb /* SlirpAddPollCb */, pShard /* opaque */);
+            cMsTimeout = drvNATTimersAdjustTimeoutDown(pShard, cMsTimeout);
+            Log4Func(("Timeout adjust to: %d\n", cMsTimeout));
 
 #ifdef RT_OS_WINDOWS
-        int cChangedFDs = WSAPoll(pThis->aPolls, pThis->cSockets, cMsTimeout);
+            int cChangedFDs = WSAPoll(pShard->aPolls, pShard->cSockets, cMsTimeout);
 #else
-        int cChangedFDs = poll(pThis->aPolls, pThis->cSockets, cMsTimeout);
+            int cChangedFDs = poll(pShard->aPolls, pShard->cSockets, cMsTimeout);
 #endif
-        if (RT_LIKELY(!(cChangedFDs >= 0)))
-        {
-            Log4Func(("Poll error\n"));
+            if (RT_LIKELY(!(cChangedFDs >= 0)))
+            {
+                Log4Func(("Poll error\n"));
 #ifdef RT_OS_WINDOWS
-            int const iLastErr = WSAGetLastError(); /* (In debug builds LogRel translates to two RTLogLoggerExWeak calls.) */
-            LogRel(("NAT: RTWinPoll returned error=%Rrc (cChangedFDs=%d)\n", iLastErr, cChangedFDs));
-            Log4(("NAT: cSockets = %d\n", pThis->cSockets));
+                int const iLastErr = WSAGetLastError(); /* (In debug builds LogRel translates to two RTLogLoggerExWeak calls.) */
+                LogRel(("NAT: RTWinPoll returned error=%Rrc (cChangedFDs=%d)\n", iLastErr, cChangedFDs));
+                Log4(("NAT: cSockets = %d\n", pShard->cSockets));
 #else
-            if (errno == EINTR)
-            {
-                Log2(("NAT: signal was caught while sleep on poll\n"));
-                /* No error, just process all outstanding requests but don't wait */
-                cChangedFDs = 0;
-            }
+                if (errno == EINTR)
+                {
+                    Log2(("NAT: signal was caught while sleep on poll\n"));
+                    /* No error, just process all outstanding requests but don't wait */
+                    cChangedFDs = 0;
+                }
 #endif
-        }
+            }
 
-        Log4Func(("poll\n"));
-        slirp_pollfds_poll(pThis->pSlirp, cChangedFDs < 0, drvNAT_GetREventsCb, pThis /* opaque */);
-        Log4Func(("management pipe revents = %d\n", pThis->aPolls[0].revents));
+            Log4Func(("poll\n"));
+            slirp_pollfds_poll(pShard->pSlirp, cChangedFDs < 0, drvNAT_GetREventsCb, pShard /* opaque */);
+            Log4Func(("management pipe revents = %d\n", pShard->aPolls[0].revents));
+            fWakeup = RT_BOOL(pShard->aPolls[0].revents & (POLLIN|POLLRDNORM|POLLPRI|POLLRDBAND)); /* POLLPRI won't be seen with WSAPoll. */
+        }
 
         /*
          * Drain the control pipe if necessary.
@@ -752,15 +1130,15 @@ static DECLCALLBACK(int) drvNATAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
          *       control pipe of all the notifications. If there is an error
          *       on reading the pipe, we try again next time around.
          */
-        if (pThis->aPolls[0].revents & (POLLIN|POLLRDNORM|POLLPRI|POLLRDBAND))   /* POLLPRI won't be seen with WSAPoll. */
+        if (fWakeup)
         {
             Log4(("Draining control pipe.\n"));
             char achBuf[1024];
             size_t cbRead = 0;
-            uint64_t cbWakeupNotifs = ASMAtomicReadU64(&pThis->cbWakeupNotifs);
+            uint64_t cbWakeupNotifs = ASMAtomicReadU64(&pShard->cbWakeupNotifs);
             int rc = VINF_SUCCESS;
 #ifdef RT_OS_WINDOWS
-            cbRead = recv(pThis->ahWakeupSockPair[1], &achBuf[0], RT_MIN(cbWakeupNotifs, sizeof(achBuf)), NULL);
+            cbRead = recv(pShard->ahWakeupSockPair[1], &achBuf[0], RT_MIN(cbWakeupNotifs, sizeof(achBuf)), NULL);
             int iError = WSAGetLastError();
             if(RT_LIKELY(!(cbRead != SOCKET_ERROR)))
             {
@@ -768,17 +1146,17 @@ static DECLCALLBACK(int) drvNATAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
                 rc = VERR_PIPE_IO_ERROR;
             }
 #else
-            rc = RTPipeRead(pThis->hPipeRead, &achBuf[0], RT_MIN(cbWakeupNotifs, sizeof(achBuf)), &cbRead);
+            rc = RTPipeRead(pShard->hPipeRead, &achBuf[0], RT_MIN(cbWakeupNotifs, sizeof(achBuf)), &cbRead);
             if (RT_FAILURE(rc))
                 LogRelFunc(("Wakup socket read error in poll loop (%Rrc)\n", rc));
 #endif
             if(RT_SUCCESS(rc))
-                ASMAtomicSubU64(&pThis->cbWakeupNotifs, cbRead);
+                ASMAtomicSubU64(&pShard->cbWakeupNotifs, cbRead);
         }
 
         /* process _all_ outstanding requests but don't wait */
-        RTReqQueueProcess(pThis->hSlirpReqQueue, 0);
-        drvNATTimersRunExpired(pThis);
+        RTReqQueueProcess(pShard->hSlirpReqQueue, 0);
+        drvNATTimersRunExpired(pShard);
     }
 
     LogFlowFunc(("Exiting poll loop...\n"));
@@ -798,10 +1176,10 @@ static DECLCALLBACK(int) drvNATAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
 static DECLCALLBACK(int) drvNATAsyncIoWakeup(PPDMDRVINS pDrvIns, PPDMTHREAD pThread)
 {
     LogFlowFuncEnter();
-    RT_NOREF(pThread);
-    PDRVNAT pThis = PDMINS_2_DATA(pDrvIns, PDRVNAT);
+    RT_NOREF(pDrvIns);
+    PDRVNATSHARD const pShard = (PDRVNATSHARD)pThread->pvUser;
 
-    drvNATNotifyNATThread(pThis, "drvNATAsyncIoWakeup");
+    drvNATNotifyNATThread(pShard, "drvNATAsyncIoWakeup");
     return VINF_SUCCESS;
 }
 
@@ -832,10 +1210,16 @@ static DECLCALLBACK(void) drvNATInfo(PPDMDRVINS pDrvIns, PCDBGFINFOHLP pHlp, con
 {
     RT_NOREF(pszArgs);
     PDRVNAT pThis = PDMINS_2_DATA(pDrvIns, PDRVNAT);
-    pHlp->pfnPrintf(pHlp, "libslirp Connection Info:\n");
-    pHlp->pfnPrintf(pHlp, slirp_connection_info(pThis->pSlirp));
-    pHlp->pfnPrintf(pHlp, "libslirp Neighbor Info:\n");
-    pHlp->pfnPrintf(pHlp, slirp_neighbor_info(pThis->pSlirp));
+    for (uint32_t iShard = 0; iShard < pThis->cShards; iShard++)
+    {
+        Slirp * const pSlirp = pThis->aShards[iShard].pSlirp;
+        if (pThis->cShards > 1)
+            pHlp->pfnPrintf(pHlp, "NAT engine shard #%u:\n", iShard);
+        pHlp->pfnPrintf(pHlp, "libslirp Connection Info:\n");
+        pHlp->pfnPrintf(pHlp, slirp_connection_info(pSlirp));
+        pHlp->pfnPrintf(pHlp, "libslirp Neighbor Info:\n");
+        pHlp->pfnPrintf(pHlp, slirp_neighbor_info(pSlirp));
+    }
     pHlp->pfnPrintf(pHlp, "libslirp Version String: %s \n", slirp_version_string());
 }
 
@@ -978,12 +1362,17 @@ static DECLCALLBACK(int) drvNATNotifyApplyPortForwardCommand(PDRVNAT pThis, bool
         || inet_aton(pszGuestIp, &guestIp) == 0)
         guestIp.s_addr = pThis->GuestIP;
 
+    /* Port forwarding lives in the first shard, so keep the guest side of
+       forwarded flows there as well (see drvNATShardForFrame). */
     int rc;
     if (fRemove)
-        rc = slirp_remove_hostfwd(pThis->pSlirp, fUdp, hostIp, u16HostPort);
+        rc = slirp_remove_hostfwd(pThis->aShards[0].pSlirp, fUdp, hostIp, u16HostPort);
     else
-        rc = slirp_add_hostfwd(pThis->pSlirp, fUdp, hostIp,
+    {
+        ASMAtomicBitSet(&pThis->abmFwdGuestPorts[fUdp][0], u16GuestPort);
+        rc = slirp_add_hostfwd(pThis->aShards[0].pSlirp, fUdp, hostIp,
                                u16HostPort, guestIp, u16GuestPort);
+    }
     if (rc < 0)
     {
         LogRelFunc(("Port forward modify FAIL! Details: fRemove=%d, fUdp=%d, pszHostIp=%s, u16HostPort=%u, pszGuestIp=%s, u16GuestPort=%u\n",
@@ -1008,18 +1397,19 @@ static DECLCALLBACK(int) drvNATAddRedirect(PPDMINETWORKNATCONFIG pInterface, boo
                         RT_BOOL(fRemove), RT_BOOL(fUdp), pHostIp, u16HostPort, pGuestIp, u16GuestPort));
     PDRVNAT pThis = RT_FROM_MEMBER(pInterface, DRVNAT, INetworkNATCfg);
     /* Execute the command directly if the VM is not running. */
+    PDRVNATSHARD const pShard0 = &pThis->aShards[0];
     int rc;
-    if (pThis->pSlirpThread->enmState != PDMTHREADSTATE_RUNNING)
+    if (pShard0->pSlirpThread->enmState != PDMTHREADSTATE_RUNNING)
         rc = drvNATNotifyApplyPortForwardCommand(pThis, fRemove, fUdp, pHostIp, u16HostPort, pGuestIp,u16GuestPort);
     else
     {
         PRTREQ pReq;
-        rc = RTReqQueueCallEx(pThis->hSlirpReqQueue, &pReq, 0 /*cMillies*/, RTREQFLAGS_VOID,
+        rc = RTReqQueueCallEx(pShard0->hSlirpReqQueue, &pReq, 0 /*cMillies*/, RTREQFLAGS_VOID,
                               (PFNRT)drvNATNotifyApplyPortForwardCommand, 7,
                               pThis, fRemove, fUdp, pHostIp, u16HostPort, pGuestIp, u16GuestPort);
         if (rc == VERR_TIMEOUT)
         {
-            drvNATNotifyNATThread(pThis, "drvNATAddRedirect");
+            drvNATNotifyNATThread(pShard0, "drvNATAddRedirect");
             rc = RTReqWait(pReq, RT_INDEFINITE_WAIT);
             AssertRC(rc);
         }
@@ -1037,20 +1427,24 @@ static DECLCALLBACK(int) drvNATAddRedirect(PPDMINETWORKNATCONFIG pInterface, boo
 static DECLCALLBACK(void) drvNATNotifyDnsChanged(PPDMINETWORKNATCONFIG pInterface, PCPDMINETWORKNATDNSCONFIG pDnsConf)
 {
     PDRVNAT const pThis = RT_FROM_MEMBER(pInterface, DRVNAT, INetworkNATCfg);
-    AssertReturnVoid(pThis->pSlirp);
+    AssertReturnVoid(pThis->aShards[0].pSlirp);
 
     LogRel(("NAT: DNS settings changed, triggering update\n"));
 
-    if (pThis->fPassDomain)
+    for (uint32_t iShard = 0; iShard < pThis->cShards; iShard++)
     {
-        if (pDnsConf->szDomainName[0] == '\0')
-            slirp_set_vdomainname(pThis->pSlirp, NULL);
-        else
-            slirp_set_vdomainname(pThis->pSlirp, pDnsConf->szDomainName);
-    }
+        Slirp * const pSlirp = pThis->aShards[iShard].pSlirp;
+        if (pThis->fPassDomain)
+        {
+            if (pDnsConf->szDomainName[0] == '\0')
+                slirp_set_vdomainname(pSlirp, NULL);
+            else
+                slirp_set_vdomainname(pSlirp, pDnsConf->szDomainName);
+        }
 
-    if (pDnsConf->papszSearchDomains)
-        slirp_set_vdnssearch(pThis->pSlirp, pDnsConf->papszSearchDomains);
+        if (pDnsConf->papszSearchDomains)
+            slirp_set_vdnssearch(pSlirp, pDnsConf->papszSearchDomains);
+    }
 
     if (pDnsConf->cNameServers > 0)
     {
@@ -1079,10 +1473,13 @@ static DECLCALLBACK(void) drvNATNotifyDnsChanged(PPDMINETWORKNATCONFIG pInterfac
                     "Falling back to libslirp DNS proxy.\n"));
 
             struct in_addr mProxyNameserver;
-            mProxyNameserver.s_addr = slirp_get_vnetwork_addr(pThis->pSlirp).s_addr | RT_H2N_U32_C(0x00000003);
+            mProxyNameserver.s_addr = slirp_get_vnetwork_addr(pThis->aShards[0].pSlirp).s_addr | RT_H2N_U32_C(0x00000003);
 
-            slirp_set_vnameserver(pThis->pSlirp, mProxyNameserver);
-            slirp_set_RealNameservers(pThis->pSlirp, 0, NULL);
+            for (uint32_t iShard = 0; iShard < pThis->cShards; iShard++)
+            {
+                slirp_set_vnameserver(pThis->aShards[iShard].pSlirp, mProxyNameserver);
+                slirp_set_RealNameservers(pThis->aShards[iShard].pSlirp, 0, NULL);
+            }
 
             LogRel(("fallback virtual nameserver: %u", mProxyNameserver.s_addr));
         }
@@ -1090,8 +1487,19 @@ static DECLCALLBACK(void) drvNATNotifyDnsChanged(PPDMINETWORKNATCONFIG pInterfac
         {
             LogRelMax(256, ("NAT DNS Update: Stored %u total nameservers\n", cNameservers));
 
+            /* Each engine takes ownership of the array it is handed, so the
+               other shards get their own copies. */
             struct in_addr *paDetachedNameservers = InAddrListDetach(&vNameservers);
-            slirp_set_RealNameservers(pThis->pSlirp, cNameservers, paDetachedNameservers);
+            for (uint32_t iShard = 1; iShard < pThis->cShards; iShard++)
+            {
+                struct in_addr *paCopy = (struct in_addr *)RTMemDup(paDetachedNameservers,
+                                                                    cNameservers * sizeof(paDetachedNameservers[0]));
+                if (paCopy)
+                    slirp_set_RealNameservers(pThis->aShards[iShard].pSlirp, cNameservers, paCopy);
+                else
+                    LogRel(("NAT DNS Update: Out of memory updating shard #%u\n", iShard));
+            }
+            slirp_set_RealNameservers(pThis->aShards[0].pSlirp, cNameservers, paDetachedNameservers);
         }
     }
 }
@@ -1101,32 +1509,111 @@ static DECLCALLBACK(void) drvNATNotifyDnsChanged(PPDMINETWORKNATCONFIG pInterfac
  * Libslirp Utility Functions
  */
 
+/**
+ * Moves a timer up the heap until its parent doesn't expire later.
+ *
+ * @param   pShard      Pointer to the NAT engine shard.
+ * @param   idx         The heap index of the timer to move.
+ *
+ * @thread  NAT
+ */
+static void drvNATTimerHeapSiftUp(PDRVNATSHARD pShard, uint32_t idx)
+{
+    SlirpTimer ** const papHeap = pShard->papTimerHeap;
+    SlirpTimer * const  pTimer  = papHeap[idx];
+    while (idx > 0)
+    {
+        uint32_t const idxParent = (idx - 1) / 2;
+        if (papHeap[idxParent]->msExpire <= pTimer->msExpire)
+            break;
+        papHeap[idx] = papHeap[idxParent];
+        papHeap[idx]->idxHeap = idx;
+        idx = idxParent;
+    }
+    papHeap[idx]    = pTimer;
+    pTimer->idxHeap = idx;
+}
+
+/**
+ * Moves a timer down the heap until no child expires earlier.
+ *
+ * @param   pShard      Pointer to the NAT engine shard.
+ * @param   idx         The heap index of the timer to move.
+ *
+ * @thread  NAT
+ */
+static void drvNATTimerHeapSiftDown(PDRVNATSHARD pShard, uint32_t idx)
+{
+    SlirpTimer ** const papHeap = pShard->papTimerHeap;
+    SlirpTimer * const  pTimer  = papHeap[idx];
+    uint32_t const      cHeap   = pShard->cTimerHeap;
+    for (;;)
+    {
+        uint32_t idxChild = idx * 2 + 1;
+        if (idxChild >= cHeap)
+            break;
+        if (   idxChild + 1 < cHeap
+            && papHeap[idxChild + 1]->msExpire < papHeap[idxChild]->msExpire)
+            idxChild++;
+        if (pTimer->msExpire <= papHeap[idxChild]->msExpire)
+            break;
+        papHeap[idx] = papHeap[idxChild];
+        papHeap[idx]->idxHeap = idx;
+        idx = idxChild;
+    }
+    papHeap[idx]    = pTimer;
+    pTimer->idxHeap = idx;
+}
+
+/**
+ * Takes an armed timer off the heap.
+ *
+ * @param   pShard      Pointer to the NAT engine shard.
+ * @param   pTimer      The timer.
+ *
+ * @thread  NAT
+ */
+static void drvNATTimerHeapRemove(PDRVNATSHARD pShard, SlirpTimer *pTimer)
+{
+    uint32_t const idx = pTimer->idxHeap;
+    Assert(idx < pShard->cTimerHeap && pShard->papTimerHeap[idx] == pTimer);
+    pTimer->idxHeap = UINT32_MAX;
+
+    uint32_t const idxLast = --pShard->cTimerHeap;
+    if (idx != idxLast)
+    {
+        SlirpTimer * const pLast = pShard->papTimerHeap[idxLast];
+        pShard->papTimerHeap[idx] = pLast;
+        pLast->idxHeap = idx;
+        drvNATTimerHeapSiftUp(pShard, idx);
+        drvNATTimerHeapSiftDown(pShard, pLast->idxHeap);
+    }
+    pShard->papTimerHeap[idxLast] = NULL;
+}
+
 /**
  * Reduce the given timeout to match the earliest timer deadline.
  *
  * @returns Updated cMsTimeout value.
- * @param   pThis       Pointer to NAT State context.
+ * @param   pShard      Pointer to the NAT engine shard.
  * @param   cMsTimeout  The timeout to adjust, in milliseconds.
  *
  * @thread  NAT
  */
-static int drvNATTimersAdjustTimeoutDown(PDRVNAT pThis, int cMsTimeout)
+static int drvNATTimersAdjustTimeoutDown(PDRVNATSHARD pShard, int cMsTimeout)
 {
     /** @todo r=bird: This and a most other stuff would be easier if msExpire was
      *                unsigned and we used UINT64_MAX for stopped timers.  */
     /** @todo The timer code isn't thread safe, it assumes a single user thread
      *        (NAT). */
 
-    /* Find the first (lowest) deadline. */
-    int64_t msDeadline = INT64_MAX;
-    for (SlirpTimer *pCurrent = pThis->pTimerHead; pCurrent; pCurrent = pCurrent->next)
-        if (pCurrent->msExpire < msDeadline && pCurrent->msExpire > 0)
-            msDeadline = pCurrent->msExpire;
+    /* The first (lowest) deadline is at the top of the heap. */
+    int64_t const msDeadline = pShard->cTimerHeap ? pShard->papTimerHeap[0]->msExpire : INT64_MAX;
 
     /* Adjust the timeout if there is a timer with a deadline. */
     if (msDeadline < INT64_MAX)
     {
-        int64_t const msNow = drvNAT_ClockGetNsCb(pThis) / RT_NS_1MS;
+        int64_t const msNow = drvNAT_ClockGetNsCb(pShard) / RT_NS_1MS;
         if (msNow < msDeadline)
         {
             int64_t cMilliesToDeadline = msDeadline - msNow;
@@ -1143,23 +1630,27 @@ static int drvNATTimersAdjustTimeoutDown(PDRVNAT pThis, int cMsTimeout)
 /**
  * Run expired timers.
  *
- * @param   opaque  Pointer to NAT State context.
+ * @param   opaque  Pointer to the NAT engine shard.
  *
  * @thread  NAT
  */
-static void drvNATTimersRunExpired(PDRVNAT pThis)
+static void drvNATTimersRunExpired(PDRVNATSHARD pShard)
 {
-    int64_t const msNow    = drvNAT_ClockGetNsCb(pThis) / RT_NS_1MS;
-    SlirpTimer   *pCurrent = pThis->pTimerHead;
-    while (pCurrent != NULL)
+    int64_t const msNow = drvNAT_ClockGetNsCb(pShard) / RT_NS_1MS;
+
+    /* Pop expired timers off the heap.  The callbacks may modify or destroy
+       timers, so look at the top again each time.  Limit the number of runs
+       so a timer rearmed in the past cannot keep us here forever. */
+    uint32_t cMaxRuns = pShard->cTimerHeap;
+    while (   pShard->cTimerHeap > 0
+           && cMaxRuns-- > 0)
     {
-        SlirpTimer * const pNext = pCurrent->next; /* (in case the timer is destroyed from the callback) */
-        if (pCurrent->msExpire <= msNow && pCurrent->msExpire > 0)
-        {
-            pCurrent->msExpire = 0;
-            pCurrent->pHandler(pCurrent->opaque);
-        }
-        pCurrent = pNext;
+        SlirpTimer * const pTimer = pShard->papTimerHeap[0];
+        if (pTimer->msExpire > msNow)
+            break;
+        drvNATTimerHeapRemove(pShard, pTimer);
+        pTimer->msExpire = 0;
+        pTimer->pHandler(pTimer->opaque);
     }
 }
 
@@ -1228,33 +1719,51 @@ static int drvNAT_PollEventHostToSlirp(int iEvents) {
  *
  * @param   pvBuf   Pointer to packet buffer.
  * @param   cb      Size of packet.
- * @param   pvUser  Pointer to NAT State context.
+ * @param   pvUser  Pointer to the NAT engine shard.
  *
  * @returns Size of packet received or -1 on error.
  *
  * @thread  NAT
  */
-static ssize_t drvNAT_SendPacketCb(const void *pvBuf, ssize_t cb, void *pvUser /* PDRVNAT */)
+static ssize_t drvNAT_SendPacketCb(const void *pvBuf, ssize_t cb, void *pvUser /* PDRVNATSHARD */)
 {
-    PDRVNAT const pThis = (PDRVNAT)pvUser;
-    Assert(pThis);
+    PDRVNATSHARD const pShard = (PDRVNATSHARD)pvUser;
+    Assert(pShard);
+    PDRVNAT const pThis = pShard->pThis;
 
-    void * const pvNewBuf = RTMemDup(pvBuf, cb);
-    AssertReturn(pvNewBuf, -1);
+    LogFlow(("slirp_output BEGIN %p %d\n", pvBuf, cb));
+    Log6(("slirp_output: pvBuf=%p cb=%#x (pThis=%p)\n"
+          "%.*Rhxd\n", pvBuf, cb, pThis, cb, pvBuf));
 
-    LogFlow(("slirp_output BEGIN %p %d\n", pvNewBuf, cb));
-    Log6(("slirp_output: pvNewBuf=%p cb=%#x (pThis=%p)\n"
-          "%.*Rhxd\n", pvNewBuf, cb, pThis, cb, pvNewBuf));
+    AssertReturn(cb > 0, -1);
 
-    /* don't queue new requests when the NAT thread is about to stop */
-    if (pThis->pSlirpThread->enmState != PDMTHREADSTATE_RUNNING)
+    /* don't queue new frames when the NAT thread is about to stop */
+    if (pShard->pSlirpThread->enmState != PDMTHREADSTATE_RUNNING)
         return -1;
 
-    ASMAtomicIncU32(&pThis->cPkts);
-    int rc = RTReqQueueCallEx(pThis->hRecvReqQueue, NULL /*ppReq*/, 0 /*cMillies*/, RTREQFLAGS_VOID | RTREQFLAGS_NO_WAIT,
-                              (PFNRT)drvNATRecvWorker, 3, pThis, pvNewBuf, cb);
-    AssertRCStmt(rc, RTMemFree(pvNewBuf));
-    drvNATRecvWakeup(pThis->pDrvIns, pThis->pRecvThread);
+    /* All shards see the guest ARP requests (drvNATShardForFrame), only let the first one answer them. */
+    if (   pShard->iShard != 0
+        && (size_t)cb >= sizeof(RTNETETHERHDR) + sizeof(RTNETARPHDR))
+    {
+        PCRTNETETHERHDR const pEthHdr = (PCRTNETETHERHDR)pvBuf;
+        PCRTNETARPHDR const   pArpHdr = (PCRTNETARPHDR)(pEthHdr + 1);
+        if (   pEthHdr->EtherType == RT_H2BE_U16_C(RTNET_ETHERTYPE_ARP)
+            && pArpHdr->ar_oper   == RT_H2BE_U16_C(RTNET_ARPOP_REPLY))
+            return cb;
+    }
+
+    PDRVNATRECVFRAME const pFrame = drvNATRecvFrameAlloc(pThis, (size_t)cb);
+    AssertReturn(pFrame, -1);
+    memcpy(pFrame->abFrame, pvBuf, (size_t)cb);
+
+    /* Queue it and only wake up the receive thread if it may be idle. */
+    RTCritSectEnter(&pThis->RecvFrameLock);
+    *pThis->ppRecvTail = pFrame;
+    pThis->ppRecvTail  = &pFrame->pNext;
+    uint32_t const cPkts = ASMAtomicIncU32(&pThis->cPkts);
+    RTCritSectLeave(&pThis->RecvFrameLock);
+    if (cPkts == 1)
+        drvNATRecvWakeup(pThis->pDrvIns, pThis->pRecvThread);
 
     STAM_COUNTER_INC(&pThis->StatQueuePktSent);
     LogFlowFuncLeave();
@@ -1302,7 +1811,7 @@ static int64_t drvNAT_ClockGetNsCb(void *pvUser)
  *                          Called later by the timeout handler.
  * @param   cb_opaque       Opaque object supplied to slirpTimeCb when called. Should be
  *                          Identical to the opaque parameter.
- * @param   opaque          Pointer to NAT State context.
+ * @param   opaque          Pointer to the NAT engine shard.
  *
  * @returns Pointer to new timer.
  *
@@ -1310,8 +1819,15 @@ static int64_t drvNAT_ClockGetNsCb(void *pvUser)
  */
 static void * drvNAT_TimerNewCb(SlirpTimerCb slirpTimeCb, void *cb_opaque, void *opaque)
 {
-    PDRVNAT pThis = (PDRVNAT)opaque;
-    Assert(pThis);
+    PDRVNATSHARD pShard = (PDRVNATSHARD)opaque;
+    Assert(pShard);
+
+    /* Make sure the heap can hold all timers so arming one never fails. */
+    SlirpTimer ** const papNewHeap = (SlirpTimer **)RTMemRealloc(pShard->papTimerHeap,
+                                                                 (pShard->cTimers + 1) * sizeof(pShard->papTimerHeap[0]));
+    if (!papNewHeap)
+        return NULL;
+    pShard->papTimerHeap = papNewHeap;
 
     SlirpTimer * const pNewTimer = (SlirpTimer *)RTMemAlloc(sizeof(SlirpTimer));
     if (pNewTimer)
@@ -1319,9 +1835,11 @@ static void * drvNAT_TimerNewCb(SlirpTimerCb slirpTimeCb, void *cb_opaque, void
         pNewTimer->msExpire = 0;
         pNewTimer->pHandler = slirpTimeCb;
         pNewTimer->opaque = cb_opaque;
+        pNewTimer->idxHeap = UINT32_MAX;
         /** @todo r=bird: Not thread safe. Assumes NAT */
-        pNewTimer->next = pThis->pTimerHead;
-        pThis->pTimerHead = pNewTimer;
+        pNewTimer->next = pShard->pTimerHead;
+        pShard->pTimerHead = pNewTimer;
+        pShard->cTimers++;
     }
     return pNewTimer;
 }
@@ -1330,26 +1848,30 @@ static void * drvNAT_TimerNewCb(SlirpTimerCb slirpTimeCb, void *cb_opaque, void
  * Callback called by slirp to free a timer.
  *
  * @param   pvTimer Pointer to slirpTimer object to be freed.
- * @param   pvUser  Pointer to NAT State context.
+ * @param   pvUser  Pointer to the NAT engine shard.
  *
  * @thread EMT
  */
 static void drvNAT_TimerFreeCb(void *pvTimer, void *pvUser)
 {
-    PDRVNAT const      pThis  = (PDRVNAT)pvUser;
+    PDRVNATSHARD const pShard = (PDRVNATSHARD)pvUser;
     SlirpTimer * const pTimer = (SlirpTimer *)pvTimer;
-    Assert(pThis);
+    Assert(pShard);
     /** @todo r=bird: Not thread safe. Assumes NAT */
 
+    if (pTimer && pTimer->idxHeap != UINT32_MAX)
+        drvNATTimerHeapRemove(pShard, pTimer);
+
     SlirpTimer *pPrev    = NULL;
-    SlirpTimer *pCurrent = pThis->pTimerHead;
+    SlirpTimer *pCurrent = pShard->pTimerHead;
     while (pCurrent != NULL)
     {
         if (pCurrent == pTimer)
         {
             /* unlink it. */
+            pShard->cTimers--;
             if (!pPrev)
-                pThis->pTimerHead = pCurrent->next;
+                pShard->pTimerHead = pCurrent->next;
             else
                 pPrev->next                  = pCurrent->next;
             pCurrent->next = NULL;
@@ -1370,7 +1892,7 @@ static void drvNAT_TimerFreeCb(void *pvTimer, void *pvUser)
  * @param   pvTimer         Pointer to slirpTimer object to be modified.
  * @param   msNewDeadlineTs The new absolute expiration time in milliseconds.
  *                          Zero stops it.
- * @param   pvUser          Pointer to NAT State context.
+ * @param   pvUser          Pointer to the NAT engine shard.
  *
  * @thread  EMT
  *
@@ -1379,31 +1901,44 @@ static void drvNAT_TimerFreeCb(void *pvTimer, void *pvUser)
  */
 static void drvNAT_TimerModCb(void *pvTimer, int64_t msNewDeadlineTs, void *pvUser)
 {
+    PDRVNATSHARD const pShard = (PDRVNATSHARD)pvUser;
     SlirpTimer * const pTimer = (SlirpTimer *)pvTimer;
     /** @todo r=bird: ASSUMES NAT, otherwise it may need to be woken up! */
     pTimer->msExpire = msNewDeadlineTs;
-    RT_NOREF(pvUser);
+    if (msNewDeadlineTs > 0)
+    {
+        if (pTimer->idxHeap == UINT32_MAX)
+        {
+            Assert(pShard->cTimerHeap < pShard->cTimers);
+            pTimer->idxHeap = pShard->cTimerHeap++;
+            pShard->papTimerHeap[pTimer->idxHeap] = pTimer;
+        }
+        drvNATTimerHeapSiftUp(pShard, pTimer->idxHeap);
+        drvNATTimerHeapSiftDown(pShard, pTimer->idxHeap);
+    }
+    else if (pTimer->idxHeap != UINT32_MAX)
+        drvNATTimerHeapRemove(pShard, pTimer);
 }
 
 /**
  * Callback called by slirp when there is I/O that needs to happen.
  *
- * @param   opaque  Pointer to NAT State context.
+ * @param   opaque  Pointer to the NAT engine shard.
  *
  * @thread  NAT
  */
 static void drvNAT_NotifyCb(void *opaque)
 {
     LogFlowFuncEnter();
-    PDRVNAT pThis = (PDRVNAT)opaque;
-    drvNATNotifyNATThread(pThis, "drvNAT_NotifyCb");
+    PDRVNATSHARD pShard = (PDRVNATSHARD)opaque;
+    drvNATNotifyNATThread(pShard, "drvNAT_NotifyCb");
 }
 
 /**
- * Registers poll. Unused function (other than logging).
+ * Registers poll.  Resets the epoll registration state of the descriptor.
  *
  * @param   socket  Slirp's OS specific socket tpye.
- * @param   opaque  Pointer to NAT State context.
+ * @param   opaque  Pointer to the NAT engine shard.
  *
  * @thread  NAT
  */
@@ -1415,13 +1950,23 @@ static void drvNAT_RegisterPoll(slirp_os_socket socket, void *opaque)
 #else
     Log4(("Poll registered: fd=%d\n", socket));
 #endif
+#ifdef DRVNAT_WITH_EPOLL
+    /* A new socket cannot be in the epoll set, forget any stale state left
+       behind by an earlier user of the descriptor number. */
+    PDRVNATSHARD const pShard = (PDRVNATSHARD)opaque;
+    if (pShard->hEPoll != -1 && (uint32_t)socket < pShard->cEPollFds)
+    {
+        pShard->paEPollFds[socket].fInEPoll    = false;
+        pShard->paEPollFds[socket].fRegistered = 0;
+    }
+#endif
 }
 
 /**
- * Unregisters poll. Unused function (other than logging).
+ * Unregisters poll.  Removes the descriptor from the epoll set.
  *
  * @param   socket  Slirp's OS specific socket tpye.
- * @param   opaque  Pointer to NAT State context.
+ * @param   opaque  Pointer to the NAT engine shard.
  *
  * @thread  NAT
  */
@@ -1433,6 +1978,12 @@ static void drvNAT_UnregisterPoll(slirp_os_socket socket, void *opaque)
 #else
     Log4(("Poll unregistered: fd=%d\n", socket));
 #endif
+#ifdef DRVNAT_WITH_EPOLL
+    /* The socket is about to be closed, drop it from the epoll set. */
+    PDRVNATSHARD const pShard = (PDRVNATSHARD)opaque;
+    if (pShard->hEPoll != -1 && (uint32_t)socket < pShard->cEPollFds)
+        drvNATEPollRemove(pShard, socket, &pShard->paEPollFds[socket]);
+#endif
 }
 
 /**
@@ -1441,7 +1992,7 @@ static void drvNAT_UnregisterPoll(slirp_os_socket socket, void *opaque)
  * @param   iFd     Integer of system file descriptor of socket.
  *                  (on windows, this is a VBox internal, not system, value).
  * @param   iEvents Integer of slirp type poll events.
- * @param   opaque  Pointer to NAT State context.
+ * @param   opaque  Pointer to the NAT engine shard.
  *
  * @returns Index of latest pollfd entry.
  *
@@ -1449,27 +2000,27 @@ static void drvNAT_UnregisterPoll(slirp_os_socket socket, void *opaque)
  */
 static DECLCALLBACK(int) drvNAT_AddPollCb(slirp_os_socket hFd, int iEvents, void *opaque)
 {
-    PDRVNAT pThis = (PDRVNAT)opaque;
+    PDRVNATSHARD pShard = (PDRVNATSHARD)opaque;
 
-    if (pThis->cSockets + 1 >= pThis->uPollCap)
+    if (pShard->cSockets + 1 >= pShard->uPollCap)
     {
-        size_t cbNew = pThis->uPollCap * 2 * sizeof(struct pollfd);
-        struct pollfd *pvNew = (struct pollfd *)RTMemRealloc(pThis->aPolls, cbNew);
+        size_t cbNew = pShard->uPollCap * 2 * sizeof(struct pollfd);
+        struct pollfd *pvNew = (struct pollfd *)RTMemRealloc(pShard->aPolls, cbNew);
         if (pvNew)
         {
-            pThis->aPolls = pvNew;
-            pThis->uPollCap *= 2;
+            pShard->aPolls = pvNew;
+            pShard->uPollCap *= 2;
         }
         else
             return -1;
     }
 
-    unsigned int uIdx = pThis->cSockets;
+    unsigned int uIdx = pShard->cSockets;
     Assert(uIdx < INT_MAX);
-    pThis->aPolls[uIdx].fd = hFd;
-    pThis->aPolls[uIdx].events = drvNAT_PollEventSlirpToHost(iEvents);
-    pThis->aPolls[uIdx].revents = 0;
-    pThis->cSockets += 1;
+    pShard->aPolls[uIdx].fd = hFd;
+    pShard->aPolls[uIdx].events = drvNAT_PollEventSlirpToHost(iEvents);
+    pShard->aPolls[uIdx].revents = 0;
+    pShard->cSockets += 1;
     return uIdx;
 }
 
@@ -1477,7 +2028,7 @@ static DECLCALLBACK(int) drvNAT_AddPollCb(slirp_os_socket hFd, int iEvents, void
  * Get translated revents from a poll at a given index.
  *
  * @param   idx     Integer index of poll.
- * @param   opaque  Pointer to NAT State context.
+ * @param   opaque  Pointer to the NAT engine shard.
  *
  * @returns Integer representing transalted revents.
  *
@@ -1485,11 +2036,201 @@ static DECLCALLBACK(int) drvNAT_AddPollCb(slirp_os_socket hFd, int iEvents, void
  */
 static DECLCALLBACK(int) drvNAT_GetREventsCb(int idx, void *opaque)
 {
-    PDRVNAT pThis = (PDRVNAT)opaque;
-    struct pollfd* aPolls = pThis->aPolls;
+    PDRVNATSHARD pShard = (PDRVNATSHARD)opaque;
+    struct pollfd* aPolls = pShard->aPolls;
     return drvNAT_PollEventHostToSlirp(aPolls[idx].revents);
 }
 
+#ifdef DRVNAT_WITH_EPOLL
+
+/**
+ * Converts slirp poll events to epoll events.
+ *
+ * @returns EPOLLXXX mask.
+ * @param   iEvents     SLIRP_POLL_XXX mask.
+ */
+static uint32_t drvNAT_PollEventSlirpToEPoll(int iEvents)
+{
+    uint32_t fRet = 0;
+    if (iEvents & SLIRP_POLL_IN)  fRet |= EPOLLIN;
+    if (iEvents & SLIRP_POLL_OUT) fRet |= EPOLLOUT;
+    if (iEvents & SLIRP_POLL_PRI) fRet |= EPOLLPRI;
+    if (iEvents & SLIRP_POLL_ERR) fRet |= EPOLLERR;
+    if (iEvents & SLIRP_POLL_HUP) fRet |= EPOLLHUP;
+    return fRet;
+}
+
+/**
+ * Converts epoll events to slirp poll events.
+ *
+ * @returns SLIRP_POLL_XXX mask.
+ * @param   fEvents     EPOLLXXX mask.
+ */
+static int drvNAT_EPollEventToSlirp(uint32_t fEvents)
+{
+    int iRet = 0;
+    if (fEvents & EPOLLIN)  iRet |= SLIRP_POLL_IN;
+    if (fEvents & EPOLLOUT) iRet |= SLIRP_POLL_OUT;
+    if (fEvents & EPOLLPRI) iRet |= SLIRP_POLL_PRI;
+    if (fEvents & EPOLLERR) iRet |= SLIRP_POLL_ERR;
+    if (fEvents & EPOLLHUP) iRet |= SLIRP_POLL_HUP;
+    return iRet;
+}
+
+/**
+ * Makes sure the registration state table covers the given descriptor.
+ *
+ * @returns Pointer to the registration state, NULL if out of memory.
+ * @param   pShard      Pointer to the NAT engine shard.
+ * @param   fd          The file descriptor.
+ */
+static PDRVNATEPOLLFD drvNATEPollFdEntry(PDRVNATSHARD pShard, int fd)
+{
+    if (RT_LIKELY((uint32_t)fd < pShard->cEPollFds))
+        return &pShard->paEPollFds[fd];
+
+    uint32_t const cNew  = RT_MAX(RT_ALIGN_32((uint32_t)fd + 1, 64), pShard->cEPollFds * 2);
+    PDRVNATEPOLLFD paNew = (PDRVNATEPOLLFD)RTMemRealloc(pShard->paEPollFds, cNew * sizeof(paNew[0]));
+    if (!paNew)
+        return NULL;
+    RT_BZERO(&paNew[pShard->cEPollFds], (cNew - pShard->cEPollFds) * sizeof(paNew[0]));
+    pShard->paEPollFds = paNew;
+    pShard->cEPollFds  = cNew;
+    return &paNew[fd];
+}
+
+/**
+ * Removes a descriptor from the epoll instance.
+ *
+ * @param   pShard      Pointer to the NAT engine shard.
+ * @param   fd          The file descriptor.
+ * @param   pFd         The registration state of @a fd.
+ */
+static void drvNATEPollRemove(PDRVNATSHARD pShard, int fd, PDRVNATEPOLLFD pFd)
+{
+    if (pFd->fInEPoll)
+    {
+        /* ENOENT/EBADF just means it was closed already, which drops it from the set. */
+        epoll_ctl(pShard->hEPoll, EPOLL_CTL_DEL, fd, NULL);
+        pFd->fInEPoll = false;
+    }
+    pFd->fRegistered = 0;
+    pFd->fREvents    = 0;
+}
+
+/**
+ * Callback for slirp_pollfds_fill_socket when using epoll.
+ *
+ * Only issues an epoll_ctl call when the descriptor isn't in the epoll set yet
+ * or libslirp wants a different set of events than last time.
+ *
+ * @returns The file descriptor, which doubles as index for
+ *          drvNAT_EPollGetREventsCb.  -1 on failure.
+ * @param   hFd         The socket.
+ * @param   iEvents     The SLIRP_POLL_XXX events to wait for.
+ * @param   opaque      Pointer to the NAT engine shard.
+ *
+ * @thread  NAT
+ */
+static DECLCALLBACK(int) drvNAT_EPollAddCb(slirp_os_socket hFd, int iEvents, void *opaque)
+{
+    PDRVNATSHARD const   pShard = (PDRVNATSHARD)opaque;
+    PDRVNATEPOLLFD const pFd   = hFd >= 0 ? drvNATEPollFdEntry(pShard, hFd) : NULL;
+    AssertReturn(pFd, -1);
+
+    pFd->uGen     = pShard->uEPollGen;
+    pFd->fREvents = 0;
+
+    uint32_t const fEvents = drvNAT_PollEventSlirpToEPoll(iEvents);
+    if (   !pFd->fInEPoll
+        || pFd->fRegistered != fEvents)
+    {
+        struct epoll_event Event;
+        RT_ZERO(Event);
+        Event.events  = fEvents;
+        Event.data.fd = hFd;
+        int rcPosix = epoll_ctl(pShard->hEPoll, pFd->fInEPoll ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, hFd, &Event);
+        /* The descriptor may have been closed and reused without us noticing, or
+           the other way around; retry with the other operation. */
+        if (rcPosix < 0 && errno == (pFd->fInEPoll ? ENOENT : EEXIST))
+            rcPosix = epoll_ctl(pShard->hEPoll, pFd->fInEPoll ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, hFd, &Event);
+        if (rcPosix < 0)
+        {
+            LogRelMax(64, ("NAT: epoll_ctl failed for fd=%d: errno=%d\n", hFd, errno));
+            pFd->fInEPoll    = false;
+            pFd->fRegistered = 0;
+            return -1;
+        }
+        pFd->fInEPoll    = true;
+        pFd->fRegistered = fEvents;
+    }
+    return hFd;
+}
+
+/**
+ * Get translated revents for a descriptor returned by drvNAT_EPollAddCb.
+ *
+ * @returns SLIRP_POLL_XXX mask.
+ * @param   idx         The file descriptor.
+ * @param   opaque      Pointer to the NAT engine shard.
+ *
+ * @thread  NAT
+ */
+static DECLCALLBACK(int) drvNAT_EPollGetREventsCb(int idx, void *opaque)
+{
+    PDRVNATSHARD const pShard = (PDRVNATSHARD)opaque;
+    AssertReturn((uint32_t)idx < pShard->cEPollFds, 0);
+    return pShard->paEPollFds[idx].fREvents;
+}
+
+/**
+ * Waits for events on the epoll instance and records them.
+ *
+ * Descriptors which libslirp did not ask about in the current fill generation
+ * are taken out of the set when they show up, so level triggered readiness
+ * nobody wants cannot keep waking us.
+ *
+ * @returns Number of events, 0 on timeout or signal, -1 on failure.
+ * @param   pShard      Pointer to the NAT engine shard.
+ * @param   cMsTimeout  The timeout in milliseconds.
+ * @param   pfWakeup    Set if the control pipe was signalled.
+ *
+ * @thread  NAT
+ */
+static int drvNATEPollWait(PDRVNATSHARD pShard, int cMsTimeout, bool *pfWakeup)
+{
+    int cEvents = epoll_wait(pShard->hEPoll, &pShard->aEPollEvents[0], RT_ELEMENTS(pShard->aEPollEvents), cMsTimeout);
+    if (cEvents < 0)
+    {
+        if (errno == EINTR)
+        {
+            Log2(("NAT: signal was caught while sleep on epoll\n"));
+            return 0;
+        }
+        LogRelMax(64, ("NAT: epoll_wait failed: errno=%d\n", errno));
+        return -1;
+    }
+
+    uint32_t const uGen = pShard->uEPollGen;
+    for (int i = 0; i < cEvents; i++)
+    {
+        int const fd = pShard->aEPollEvents[i].data.fd;
+        if (fd == pShard->fdEPollWakeup)
+            *pfWakeup = true;
+        else if ((uint32_t)fd < pShard->cEPollFds)
+        {
+            PDRVNATEPOLLFD const pFd = &pShard->paEPollFds[fd];
+            if (pFd->uGen == uGen)
+                pFd->fREvents = drvNAT_EPollEventToSlirp(pShard->aEPollEvents[i].events);
+            else
+                drvNATEPollRemove(pShard, fd, pFd);
+        }
+    }
+    return cEvents;
+}
+
+#endif /* DRVNAT_WITH_EPOLL */
+
 /**
  * Contructor/Destructor
  */
@@ -1511,10 +2252,39 @@ static DECLCALLBACK(void) drvNATDestruct(PPDMDRVINS pDrvIns)
 
     if (pThis)
     {
-        if (pThis->pSlirp)
+        for (uint32_t iShard = 0; iShard < pThis->cShards; iShard++)
         {
-            slirp_cleanup(pThis->pSlirp);
-            pThis->pSlirp = NULL;
+            PDRVNATSHARD const pShard = &pThis->aShards[iShard];
+            if (pShard->pSlirp)
+            {
+                slirp_cleanup(pShard->pSlirp);
+                pShard->pSlirp = NULL;
+            }
+
+            RTMemFree(pShard->aPolls);
+            pShard->aPolls = NULL;
+            RTMemFree(pShard->papTimerHeap);
+            pShard->papTimerHeap = NULL;
+#ifdef DRVNAT_WITH_EPOLL
+            if (pShard->hEPoll != -1)
+            {
+                close(pShard->hEPoll);
+                pShard->hEPoll = -1;
+            }
+            RTMemFree(pShard->paEPollFds);
+            pShard->paEPollFds = NULL;
+            pShard->cEPollFds  = 0;
+#endif
+
+            RTReqQueueDestroy(pShard->hSlirpReqQueue);
+            pShard->hSlirpReqQueue = NIL_RTREQQUEUE;
+
+#ifndef RT_OS_WINDOWS
+            RTPipeClose(pShard->hPipeRead);
+            RTPipeClose(pShard->hPipeWrite);
+            pShard->hPipeRead = NIL_RTPIPE;
+            pShard->hPipeWrite = NIL_RTPIPE;
+#endif
         }
 
 #ifdef VBOX_WITH_STATISTICS
@@ -1522,16 +2292,22 @@ static DECLCALLBACK(void) drvNATDestruct(PPDMDRVINS pDrvIns)
 # define DRV_COUNTING_COUNTER(name, dsc)    DEREGISTER_COUNTER(name, pThis)
 # include "slirp/counters.h"
 #endif
-        RTMemFree(pThis->aPolls);
-        pThis->aPolls = NULL;
     }
 
-    RTReqQueueDestroy(pThis->hSlirpReqQueue);
-    pThis->hSlirpReqQueue = NIL_RTREQQUEUE;
-
     RTReqQueueDestroy(pThis->hRecvReqQueue);
     pThis->hRecvReqQueue = NIL_RTREQQUEUE;
 
+    if (RTCritSectIsInitialized(&pThis->RecvFrameLock))
+    {
+        drvNATRecvFramesFree(pThis, pThis->pRecvHead);
+        pThis->pRecvHead  = NULL;
+        pThis->ppRecvTail = &pThis->pRecvHead;
+        pThis->pRecvFree  = NULL;
+        RTCritSectDelete(&pThis->RecvFrameLock);
+    }
+    RTMemFree(pThis->pvRecvPool);
+    pThis->pvRecvPool = NULL;
+
     RTSemEventDestroy(pThis->hEventRecv);
     pThis->hEventRecv = NIL_RTSEMEVENT;
 
@@ -1540,13 +2316,6 @@ static DECLCALLBACK(void) drvNATDestruct(PPDMDRVINS pDrvIns)
 
     if (RTCritSectIsInitialized(&pThis->XmitLock))
         RTCritSectDelete(&pThis->XmitLock);
-
-#ifndef RT_OS_WINDOWS
-    RTPipeClose(pThis->hPipeRead);
-    RTPipeClose(pThis->hPipeWrite);
-    pThis->hPipeRead = NIL_RTPIPE;
-    pThis->hPipeWrite = NIL_RTPIPE;
-#endif
 }
 
 /**
@@ -1564,18 +2333,36 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
      * Init the static parts.
      */
     pThis->pDrvIns                      = pDrvIns;
-    pThis->hSlirpReqQueue               = NIL_RTREQQUEUE;
     pThis->hEventRecv                   = NIL_RTSEMEVENT;
     pThis->hRecvReqQueue                = NIL_RTREQQUEUE;
+    pThis->pRecvHead                    = NULL;
+    pThis->ppRecvTail                   = &pThis->pRecvHead;
+    pThis->cShards                      = 0;
+    for (uint32_t iShard = 0; iShard < RT_ELEMENTS(pThis->aShards); iShard++)
+    {
+        PDRVNATSHARD const pShard = &pThis->aShards[iShard];
+        pShard->pThis                   = pThis;
+        pShard->iShard                  = iShard;
+        pShard->hSlirpReqQueue          = NIL_RTREQQUEUE;
 #ifndef RT_OS_WINDOWS
-    pThis->hPipeRead                    = NIL_RTPIPE;
-    pThis->hPipeWrite                   = NIL_RTPIPE;
+        pShard->hPipeRead               = NIL_RTPIPE;
+        pShard->hPipeWrite              = NIL_RTPIPE;
+#endif
+        pShard->cSockets                = 0;
+        pShard->pTimerHead              = NULL;
+        pShard->papTimerHeap            = NULL;
+        pShard->cTimerHeap              = 0;
+        pShard->cTimers                 = 0;
+#ifdef DRVNAT_WITH_EPOLL
+        pShard->hEPoll                  = -1;
+        pShard->fdEPollWakeup           = -1;
+        pShard->uEPollGen               = 0;
+        pShard->cEPollFds               = 0;
+        pShard->paEPollFds              = NULL;
 #endif
-    pThis->cSockets                     = 0;
-    pThis->pTimerHead                   = NULL;
-    pThis->aPolls                       = (struct pollfd *)RTMemAllocZ(64 * sizeof(struct pollfd));
-    AssertReturn(pThis->aPolls, VERR_NO_MEMORY);
-    pThis->uPollCap                 = 64;
+        pShard->aPolls                  = NULL;
+        pShard->uPollCap                = 0;
+    }
 
     /* IBase */
     pDrvIns->IBase.pfnQueryInterface    = drvNATQueryInterface;
@@ -1629,6 +2416,7 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
                                   "|HostResolverMappings"
                                   "|ForwardBroadcast"
                                   "|EnableTFTP"
+                                  "|Shards"
                                   , "PortForwarding");
 
     /*
@@ -1646,6 +2434,15 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     rc = pDrvIns->pHlpR3->pfnCFGMQueryBoolDef(pCfg, "PassDomain", &pThis->fPassDomain, true);
     AssertLogRelRCReturn(rc, rc);
 
+    /* Number of NAT engine threads to distribute the guest flows over. */
+    uint32_t cShards = 1;
+    rc = pDrvIns->pHlpR3->pfnCFGMQueryU32Def(pCfg, "Shards", &cShards, 1);
+    AssertLogRelRCReturn(rc, rc);
+    if (cShards < 1 || cShards > DRVNAT_MAX_SHARDS)
+        return PDMDrvHlpVMSetError(pDrvIns, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                                   N_("NAT#%d: Configuration error: Shards must be between 1 and %u"),
+                                   pDrvIns->iInstance, DRVNAT_MAX_SHARDS);
+
     rc = pDrvIns->pHlpR3->pfnCFGMQueryBoolDef(pCfg, "ForwardBroadcast", &slirpCfg.fForwardBroadcast, false);
     AssertLogRelRCReturn(rc, rc);
 
@@ -1795,14 +2592,27 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     slirpCallbacks.unregister_poll_socket = drvNAT_UnregisterPoll;
 
     /*
-     * Initialize Slirp
+     * Initialize Slirp, one instance per shard.
      */
-    Slirp * const pSlirp = slirp_new(/* cfg */ &slirpCfg, /* callbacks */ &slirpCallbacks, /* opaque */ pThis);
-    if (!pSlirp)
-        return PDMDRV_SET_ERROR(pDrvIns, VERR_INTERNAL_ERROR_4,
-                                N_("Configuration error: libslirp failed to create new instance - probably misconfiguration"));
+    pThis->cShards = cShards;
+    for (uint32_t iShard = 0; iShard < cShards; iShard++)
+    {
+        PDRVNATSHARD const pShard = &pThis->aShards[iShard];
+
+        pShard->aPolls = (struct pollfd *)RTMemAllocZ(64 * sizeof(struct pollfd));
+        AssertReturn(pShard->aPolls, VERR_NO_MEMORY);
+        pShard->uPollCap = 64;
 
-    pThis->pSlirp = pSlirp;
+        pShard->pSlirp = slirp_new(/* cfg */ &slirpCfg, /* callbacks */ &slirpCallbacks, /* opaque */ pShard);
+        if (!pShard->pSlirp)
+            return PDMDRV_SET_ERROR(pDrvIns, VERR_INTERNAL_ERROR_4,
+                                    N_("Configuration error: libslirp failed to create new instance - probably misconfiguration"));
+
+        rc = RTReqQueueCreate(&pShard->hSlirpReqQueue);
+        AssertLogRelRCReturn(rc, rc);
+    }
+    if (cShards > 1)
+        LogRel(("NAT#%d: Distributing guest flows over %u NAT engine threads\n", pDrvIns->iInstance, cShards));
 
     rc = drvNATConfigPreDefPortForward(pDrvIns->iInstance, pThis, pCfg, &Network);
     AssertLogRelRCReturn(rc, rc);
@@ -1810,12 +2620,25 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     rc = PDMDrvHlpSSMRegisterLoadDone(pDrvIns, NULL);
     AssertLogRelRCReturn(rc, rc);
 
-    rc = RTReqQueueCreate(&pThis->hSlirpReqQueue);
-    AssertLogRelRCReturn(rc, rc);
-
     rc = RTReqQueueCreate(&pThis->hRecvReqQueue);
     AssertLogRelRCReturn(rc, rc);
 
+    /*
+     * Pre-allocate the receive frame pool.
+     */
+    rc = RTCritSectInit(&pThis->RecvFrameLock);
+    AssertRCReturn(rc, rc);
+    size_t const cbPoolFrame = RT_ALIGN_Z(RT_UOFFSETOF(DRVNATRECVFRAME, abFrame) + DRVNAT_RECV_FRAME_SIZE, 64);
+    pThis->pvRecvPool = RTMemAlloc(cbPoolFrame * DRVNAT_RECV_POOL_SIZE);
+    AssertReturn(pThis->pvRecvPool, VERR_NO_MEMORY);
+    for (uint32_t i = 0; i < DRVNAT_RECV_POOL_SIZE; i++)
+    {
+        PDRVNATRECVFRAME pFrame = (PDRVNATRECVFRAME)((uint8_t *)pThis->pvRecvPool + i * cbPoolFrame);
+        pFrame->fPooled  = true;
+        pFrame->pNext    = pThis->pRecvFree;
+        pThis->pRecvFree = pFrame;
+    }
+
     rc = PDMDrvHlpThreadCreate(pDrvIns, &pThis->pRecvThread, pThis, drvNATRecv,
                                drvNATRecvWakeup, 256 * _1K, RTTHREADTYPE_IO, "NATRX");
     AssertRCReturn(rc, rc);
@@ -1839,23 +2662,56 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
 # include "slirp/counters.h"
 #endif
 
+    for (uint32_t iShard = 0; iShard < cShards; iShard++)
+    {
+        PDRVNATSHARD const pShard = &pThis->aShards[iShard];
+
 #ifdef RT_OS_WINDOWS
-    /* Create the wakeup socket pair (idx=0 is write, idx=1 is read). */
-    pThis->ahWakeupSockPair[0] = INVALID_SOCKET;
-    pThis->ahWakeupSockPair[1] = INVALID_SOCKET;
-    rc = RTWinSocketPair(AF_INET, SOCK_DGRAM, 0, pThis->ahWakeupSockPair);
-    AssertRCReturn(rc, rc);
+        /* Create the wakeup socket pair (idx=0 is write, idx=1 is read). */
+        pShard->ahWakeupSockPair[0] = INVALID_SOCKET;
+        pShard->ahWakeupSockPair[1] = INVALID_SOCKET;
+        rc = RTWinSocketPair(AF_INET, SOCK_DGRAM, 0, pShard->ahWakeupSockPair);
+        AssertRCReturn(rc, rc);
 #else
-    /* Create the control pipe. */
-    rc = RTPipeCreate(&pThis->hPipeRead, &pThis->hPipeWrite, 0 /*fFlags*/);
-    AssertRCReturn(rc, rc);
+        /* Create the control pipe. */
+        rc = RTPipeCreate(&pShard->hPipeRead, &pShard->hPipeWrite, 0 /*fFlags*/);
+        AssertRCReturn(rc, rc);
 #endif
-    /* initalize the notifier counter */
-    pThis->cbWakeupNotifs = 0;
+#ifdef DRVNAT_WITH_EPOLL
+        /*
+         * Set up the epoll instance with the control pipe as permanent member.
+         * Falls back on poll() if any of this fails.
+         */
+        pShard->fdEPollWakeup = (int)RTPipeToNative(pShard->hPipeRead);
+        pShard->hEPoll = epoll_create1(EPOLL_CLOEXEC);
+        if (pShard->hEPoll != -1)
+        {
+            struct epoll_event Event;
+            RT_ZERO(Event);
+            Event.events  = EPOLLIN | EPOLLPRI;
+            Event.data.fd = pShard->fdEPollWakeup;
+            if (epoll_ctl(pShard->hEPoll, EPOLL_CTL_ADD, pShard->fdEPollWakeup, &Event) != 0)
+            {
+                LogRel(("NAT: Failed to add the control pipe to the epoll set (errno=%d), using poll()\n", errno));
+                close(pShard->hEPoll);
+                pShard->hEPoll = -1;
+            }
+        }
+        else
+            LogRel(("NAT: epoll_create1 failed (errno=%d), using poll()\n", errno));
+#endif
+        /* initalize the notifier counter */
+        pShard->cbWakeupNotifs = 0;
 
-    rc = PDMDrvHlpThreadCreate(pDrvIns, &pThis->pSlirpThread, pThis, drvNATAsyncIoThread,
-                               drvNATAsyncIoWakeup, 256 * _1K, RTTHREADTYPE_IO, "NAT");
-    AssertRCReturn(rc, rc);
+        char szThreadName[16];
+        if (iShard == 0)
+            RTStrCopy(szThreadName, sizeof(szThreadName), "NAT");
+        else
+            RTStrPrintf(szThreadName, sizeof(szThreadName), "NAT%u", iShard);
+        rc = PDMDrvHlpThreadCreate(pDrvIns, &pShard->pSlirpThread, pShard, drvNATAsyncIoThread,
+                                   drvNATAsyncIoWakeup, 256 * _1K, RTTHREADTYPE_IO, szThreadName);
+        AssertRCReturn(rc, rc);
+    }
 
     pThis->enmLinkState = pThis->enmLinkStateWant = PDMNETWORKLINKSTATE_UP;
 
@@ -32,12 +32,16 @@
 #define LOG_GROUP LOG_GROUP_DRV_NAT
 #include <VBox/vmm/pdmdrv.h>
 #include <VBox/vmm/pdmnetifs.h>
+#include <VBox/vmm/pdmnetinline.h>
 
 #include <VBox/log.h>
+#include <iprt/asm.h>
 #include <iprt/assert.h>
 #include <iprt/critsect.h>
 #include <iprt/file.h>
+#include <iprt/mem.h>
 #include <iprt/process.h>
+#include <iprt/semaphore.h>
 #include <iprt/string.h>
 #include <iprt/time.h>
 #include <iprt/uuid.h>
@@ -48,6 +52,15 @@
 #include "VBoxDD.h"
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** The smallest ring buffer size. */
+#define DRVNETSNIFFER_RING_SIZE_MIN     _64K
+/** The largest ring buffer size. */
+#define DRVNETSNIFFER_RING_SIZE_MAX     _1G
+
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
@@ -85,10 +98,345 @@ typedef struct DRVNETSNIFFER
     PPDMDRVINS              pDrvIns;
     /** For when we're the leaf driver. */
     RTCRITSECT              XmitLock;
-
+    /** The max number of bytes captured per frame, UINT32_MAX if unlimited. */
+    uint32_t                cbSnapLen;
+
+    /** @name Ring buffer mode.
+     * Frames are put into the ring buffer as pcapng blocks by the data path
+     * and written to the file by the writer thread.  Space is reserved by
+     * advancing offRingReserve, a block is committed by setting its block type
+     * (the first 32-bit word) as the last thing.  Free ring space is all
+     * zeros, so the writer stops at the first block not yet committed.
+     * @{ */
+    /** The ring buffer, NULL if capturing synchronously in pcap format. */
+    uint8_t                *pbRing;
+    /** The size of the ring buffer (power of two). */
+    uint32_t                cbRing;
+    /** How long the writer thread waits for more data, in milliseconds. */
+    RTMSINTERVAL            cMsFlushInterval;
+    /** Free running offset of the next free ring byte. */
+    uint64_t volatile       offRingReserve;
+    /** Free running offset of the next ring byte to write to the file. */
+    uint64_t volatile       offRingRead;
+    /** Set when the writer thread should be woken up at the next frame. */
+    bool volatile           fWriterIdle;
+    /** The writer thread. */
+    PPDMTHREAD              pWriterThread;
+    /** The event the writer thread waits on. */
+    RTSEMEVENT              hEvtWriter;
+    /** Number of frames dropped because the ring buffer was full. */
+    uint64_t volatile       cDropped;
+    /** The number of drops already accounted for in previous files. */
+    uint64_t                cDroppedPrevFiles;
+    /** The nanosecond timestamp (RTTimeNanoTS) corresponding to
+     * u64StartEpochNs. */
+    uint64_t                u64StartNanoTS;
+    /** The wall clock time of the start of capturing, nanoseconds since the
+     * epoch. */
+    uint64_t                u64StartEpochNs;
+    /** Rotate the file when it reaches this size, 0 for no size rotation. */
+    uint64_t                cbRotateSize;
+    /** Rotate the file after this many seconds, 0 for no time rotation. */
+    uint32_t                cSecsRotateInterval;
+    /** The sequence number of the current file (0 = szFilename as is). */
+    uint32_t                iFileSeq;
+    /** The number of bytes written to the current file. */
+    uint64_t                cbFileWritten;
+    /** When the current file was started (RTTimeMilliTS). */
+    uint64_t                msFileStart;
+    /** @} */
+
+    /** Number of frames captured. */
+    STAMCOUNTER             StatCaptured;
+    /** Number of frames dropped because the ring buffer was full. */
+    STAMCOUNTER             StatDropped;
+    /** Number of bytes written by the writer thread. */
+    STAMCOUNTER             StatBytesWritten;
+    /** Number of file rotations. */
+    STAMCOUNTER             StatRotations;
 } DRVNETSNIFFER, *PDRVNETSNIFFER;
 
 
+/**
+ * Gets the pcapng timestamp for a frame captured now.
+ *
+ * @returns Nanoseconds since the epoch.
+ * @param   pThis           The sniffer instance.
+ */
+DECLINLINE(uint64_t) drvNetSnifferRingTimestamp(PDRVNETSNIFFER pThis)
+{
+    return pThis->u64StartEpochNs + (RTTimeNanoTS() - pThis->u64StartNanoTS);
+}
+
+
+/**
+ * Copies data into the ring buffer, wrapping around at the end.
+ *
+ * @param   pThis           The sniffer instance.
+ * @param   off             The free running ring offset to copy to.
+ * @param   pvSrc           The data.
+ * @param   cb              The number of bytes to copy.
+ */
+DECLINLINE(void) drvNetSnifferRingCopy(PDRVNETSNIFFER pThis, uint64_t off, const void *pvSrc, size_t cb)
+{
+    uint32_t const offRing = (uint32_t)(off & (pThis->cbRing - 1));
+    size_t const   cb1     = RT_MIN(cb, pThis->cbRing - offRing);
+    memcpy(&pThis->pbRing[offRing], pvSrc, cb1);
+    if (cb > cb1)
+        memcpy(pThis->pbRing, (uint8_t const *)pvSrc + cb1, cb - cb1);
+}
+
+
+/**
+ * Puts a frame into the ring buffer, dropping it if there is no room.
+ *
+ * This can be called concurrently by any number of threads.  The frame may
+ * come in two parts (the headers and payload of a carved GSO segment).
+ *
+ * @param   pThis           The sniffer instance.
+ * @param   pvPart1         The first part of the frame.
+ * @param   cbPart1         The size of the first part.
+ * @param   pvPart2         The second part of the frame, optional.
+ * @param   cbPart2         The size of the second part.
+ */
+static void drvNetSnifferRingPut(PDRVNETSNIFFER pThis, const void *pvPart1, size_t cbPart1,
+                                 const void *pvPart2, size_t cbPart2)
+{
+    size_t const   cbFrame    = cbPart1 + cbPart2;
+    size_t const   cbCaptured = RT_MIN(cbFrame, pThis->cbSnapLen);
+    uint32_t const cbBlock    = PCAPNG_EPB_SIZE(cbCaptured);
+
+    /*
+     * Reserve the space.
+     */
+    uint64_t off = ASMAtomicReadU64(&pThis->offRingReserve);
+    for (;;)
+    {
+        if (off + cbBlock - ASMAtomicReadU64(&pThis->offRingRead) > pThis->cbRing)
+        {
+            ASMAtomicIncU64(&pThis->cDropped);
+            STAM_REL_COUNTER_INC(&pThis->StatDropped);
+            return;
+        }
+        if (ASMAtomicCmpXchgExU64(&pThis->offRingReserve, off + cbBlock, off, &off))
+            break;
+    }
+
+    /*
+     * Fill in everything but the block type, the padding is already zero.
+     */
+    uint8_t abHdr[PCAPNG_EPB_HDR_SIZE];
+    PcapNgFrameHdr(abHdr, drvNetSnifferRingTimestamp(pThis), cbFrame, cbCaptured);
+    drvNetSnifferRingCopy(pThis, off + sizeof(uint32_t), &abHdr[sizeof(uint32_t)], sizeof(abHdr) - sizeof(uint32_t));
+    size_t const cbCaptured1 = RT_MIN(cbCaptured, cbPart1);
+    drvNetSnifferRingCopy(pThis, off + PCAPNG_EPB_HDR_SIZE, pvPart1, cbCaptured1);
+    if (cbCaptured > cbCaptured1)
+        drvNetSnifferRingCopy(pThis, off + PCAPNG_EPB_HDR_SIZE + cbCaptured1, pvPart2, cbCaptured - cbCaptured1);
+    drvNetSnifferRingCopy(pThis, off + cbBlock - sizeof(uint32_t), &cbBlock, sizeof(cbBlock));
+
+    /* Commit it (blocks are 32-bit aligned so the word never wraps). */
+    ASMAtomicWriteU32((uint32_t volatile *)&pThis->pbRing[off & (pThis->cbRing - 1)], PCAPNG_BLOCK_TYPE_EPB);
+    STAM_REL_COUNTER_INC(&pThis->StatCaptured);
+
+    /* Kick the writer when the ring is getting full. */
+    if (   off + cbBlock - ASMAtomicReadU64(&pThis->offRingRead) >= pThis->cbRing / 2
+        && ASMAtomicXchgBool(&pThis->fWriterIdle, false))
+        RTSemEventSignal(pThis->hEvtWriter);
+}
+
+
+/**
+ * Puts a GSO frame into the ring buffer, one block per segment like the pcap
+ * writers do.
+ *
+ * @param   pThis           The sniffer instance.
+ * @param   pGso            The GSO context.
+ * @param   pvFrame         The GSO frame.
+ * @param   cbFrame         The size of the GSO frame.
+ */
+static void drvNetSnifferRingPutGso(PDRVNETSNIFFER pThis, PCPDMNETWORKGSO pGso, const void *pvFrame, size_t cbFrame)
+{
+    uint8_t const  *pbFrame = (uint8_t const *)pvFrame;
+    uint8_t         abHdrs[256];
+    uint32_t const  cSegs   = PDMNetGsoCalcSegmentCount(pGso, cbFrame);
+    for (uint32_t iSeg = 0; iSeg < cSegs; iSeg++)
+    {
+        uint32_t cbSegPayload, cbHdrs;
+        uint32_t offSegPayload = PDMNetGsoCarveSegment(pGso, pbFrame, cbFrame, iSeg, cSegs, abHdrs, &cbHdrs, &cbSegPayload);
+        drvNetSnifferRingPut(pThis, abHdrs, cbHdrs, pbFrame + offSegPayload, cbSegPayload);
+    }
+}
+
+
+/**
+ * Formats the name of the capture file with the given sequence number.
+ *
+ * The first file gets the configured name, the following ones get the
+ * sequence number inserted before the suffix.
+ *
+ * @param   pThis           The sniffer instance.
+ * @param   iFileSeq        The sequence number.
+ * @param   pszDst          Where to return the name.
+ * @param   cbDst           The size of the buffer.
+ */
+static void drvNetSnifferFormatFilename(PDRVNETSNIFFER pThis, uint32_t iFileSeq, char *pszDst, size_t cbDst)
+{
+    if (!iFileSeq)
+        RTStrCopy(pszDst, cbDst, pThis->szFilename);
+    else
+    {
+        const char *pszSuffix = RTPathSuffix(pThis->szFilename);
+        if (!pszSuffix)
+            pszSuffix = strchr(pThis->szFilename, '\0');
+        RTStrPrintf(pszDst, cbDst, "%.*s-%u%s", (int)(pszSuffix - pThis->szFilename), pThis->szFilename, iFileSeq, pszSuffix);
+    }
+}
+
+
+/**
+ * Opens the capture file for the current sequence number and writes the
+ * pcapng header to it.
+ *
+ * @returns VBox status code.
+ * @param   pThis           The sniffer instance.
+ */
+static int drvNetSnifferRingOpenFile(PDRVNETSNIFFER pThis)
+{
+    char szFilename[RTPATH_MAX];
+    drvNetSnifferFormatFilename(pThis, pThis->iFileSeq, szFilename, sizeof(szFilename));
+    int rc = RTFileOpen(&pThis->hFile, szFilename, RTFILE_O_WRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_WRITE);
+    if (RT_SUCCESS(rc))
+    {
+        uint32_t au32Hdr[PCAPNG_HDR_SIZE / sizeof(uint32_t)];
+        PcapNgHdr(au32Hdr, pThis->cbSnapLen != UINT32_MAX ? pThis->cbSnapLen : 0);
+        rc = RTFileWrite(pThis->hFile, au32Hdr, sizeof(au32Hdr), NULL);
+        pThis->cbFileWritten = sizeof(au32Hdr);
+        pThis->msFileStart   = RTTimeMilliTS();
+    }
+    return rc;
+}
+
+
+/**
+ * Finishes the current capture file with the drop statistics and closes it.
+ *
+ * @param   pThis           The sniffer instance.
+ */
+static void drvNetSnifferRingCloseFile(PDRVNETSNIFFER pThis)
+{
+    if (pThis->hFile != NIL_RTFILE)
+    {
+        uint64_t const cDropped = ASMAtomicReadU64(&pThis->cDropped);
+        uint32_t au32Stats[PCAPNG_STATS_SIZE / sizeof(uint32_t)];
+        PcapNgStats(au32Stats, drvNetSnifferRingTimestamp(pThis), cDropped - pThis->cDroppedPrevFiles);
+        RTFileWrite(pThis->hFile, au32Stats, sizeof(au32Stats), NULL);
+        pThis->cDroppedPrevFiles = cDropped;
+
+        RTFileClose(pThis->hFile);
+        pThis->hFile = NIL_RTFILE;
+    }
+}
+
+
+/**
+ * Writes the committed ring buffer content to the file and rotates the file
+ * when it is due.
+ *
+ * @param   pThis           The sniffer instance.
+ * @thread  The writer thread, or the destructor after it is gone.
+ */
+static void drvNetSnifferRingFlush(PDRVNETSNIFFER pThis)
+{
+    uint32_t const fMask      = pThis->cbRing - 1;
+    uint64_t const offRead    = pThis->offRingRead;
+    uint64_t const offReserve = ASMAtomicReadU64(&pThis->offRingReserve);
+    uint64_t       offEnd     = offRead;
+    while (offEnd < offReserve)
+    {
+        if (!ASMAtomicReadU32((uint32_t volatile *)&pThis->pbRing[offEnd & fMask]))
+            break;
+        offEnd += *(uint32_t const *)&pThis->pbRing[(offEnd + sizeof(uint32_t)) & fMask];
+    }
+
+    if (offEnd != offRead)
+    {
+        /* Write it out in one or two chunks, then zero the space and hand it back. */
+        uint32_t const offRing = (uint32_t)(offRead & fMask);
+        size_t const   cb      = (size_t)(offEnd - offRead);
+        size_t const   cb1     = RT_MIN(cb, pThis->cbRing - offRing);
+        if (pThis->hFile != NIL_RTFILE)
+        {
+            int rc = RTFileWrite(pThis->hFile, &pThis->pbRing[offRing], cb1, NULL);
+            if (RT_SUCCESS(rc) && cb > cb1)
+                rc = RTFileWrite(pThis->hFile, pThis->pbRing, cb - cb1, NULL);
+            if (RT_FAILURE(rc))
+                LogRelMax(8, ("NetSniffer#%u: Writing %zu bytes failed: %Rrc\n", pThis->pDrvIns->iInstance, cb, rc));
+            pThis->cbFileWritten += cb;
+            STAM_REL_COUNTER_ADD(&pThis->StatBytesWritten, cb);
+        }
+        RT_BZERO(&pThis->pbRing[offRing], cb1);
+        if (cb > cb1)
+            RT_BZERO(pThis->pbRing, cb - cb1);
+        ASMAtomicWriteU64(&pThis->offRingRead, offEnd);
+    }
+
+    /*
+     * Rotate?
+     */
+    if (   pThis->hFile != NIL_RTFILE
+        && (   (pThis->cbRotateSize && pThis->cbFileWritten >= pThis->cbRotateSize)
+            || (   pThis->cSecsRotateInterval
+                && RTTimeMilliTS() - pThis->msFileStart >= pThis->cSecsRotateInterval * RT_MS_1SEC)))
+    {
+        drvNetSnifferRingCloseFile(pThis);
+        pThis->iFileSeq++;
+        int rc = drvNetSnifferRingOpenFile(pThis);
+        if (RT_FAILURE(rc))
+            LogRel(("NetSniffer#%u: Failed to open capture file #%u: %Rrc\n", pThis->pDrvIns->iInstance, pThis->iFileSeq, rc));
+        STAM_REL_COUNTER_INC(&pThis->StatRotations);
+    }
+}
+
+
+/**
+ * @callback_method_impl{FNPDMTHREADDRV, The ring buffer writer thread.}
+ */
+static DECLCALLBACK(int) drvNetSnifferWriterThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThread)
+{
+    PDRVNETSNIFFER pThis = PDMINS_2_DATA(pDrvIns, PDRVNETSNIFFER);
+    if (pThread->enmState == PDMTHREADSTATE_INITIALIZING)
+        return VINF_SUCCESS;
+
+    while (pThread->enmState == PDMTHREADSTATE_RUNNING)
+    {
+        ASMAtomicWriteBool(&pThis->fWriterIdle, true);
+        RTSemEventWait(pThis->hEvtWriter, pThis->cMsFlushInterval);
+        ASMAtomicWriteBool(&pThis->fWriterIdle, false);
+
+        RTCritSectEnter(&pThis->Lock);
+        drvNetSnifferRingFlush(pThis);
+        RTCritSectLeave(&pThis->Lock);
+    }
+
+    /* Don't leave anything behind when the VM is suspended. */
+    RTCritSectEnter(&pThis->Lock);
+    drvNetSnifferRingFlush(pThis);
+    RTCritSectLeave(&pThis->Lock);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @callback_method_impl{FNPDMTHREADWAKEUPDRV}
+ */
+static DECLCALLBACK(int) drvNetSnifferWriterWakeup(PPDMDRVINS pDrvIns, PPDMTHREAD pThread)
+{
+    RT_NOREF(pThread);
+    PDRVNETSNIFFER pThis = PDMINS_2_DATA(pDrvIns, PDRVNETSNIFFER);
+    return RTSemEventSignal(pThis->hEvtWriter);
+}
+
+
 
 /**
  * @interface_method_impl{PDMINETWORKUP,pfnBeginXmit}
@@ -142,18 +490,28 @@ static DECLCALLBACK(int) drvNetSnifferUp_SendBuf(PPDMINETWORKUP pInterface, PPDM
         return VERR_NET_DOWN;
 
     /* output to sniffer */
-    RTCritSectEnter(&pThis->Lock);
-    if (!pSgBuf->pvUser)
-        PcapFileFrame(pThis->hFile, pThis->StartNanoTS,
-                      pSgBuf->aSegs[0].pvSeg,
-                      pSgBuf->cbUsed,
-                      RT_MIN(pSgBuf->cbUsed, pSgBuf->aSegs[0].cbSeg));
+    if (pThis->pbRing)
+    {
+        if (!pSgBuf->pvUser)
+            drvNetSnifferRingPut(pThis, pSgBuf->aSegs[0].pvSeg, RT_MIN(pSgBuf->cbUsed, pSgBuf->aSegs[0].cbSeg), NULL, 0);
+        else
+            drvNetSnifferRingPutGso(pThis, (PCPDMNETWORKGSO)pSgBuf->pvUser, pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed);
+    }
     else
-        PcapFileGsoFrame(pThis->hFile, pThis->StartNanoTS, (PCPDMNETWORKGSO)pSgBuf->pvUser,
-                         pSgBuf->aSegs[0].pvSeg,
-                         pSgBuf->cbUsed,
-                         RT_MIN(pSgBuf->cbUsed, pSgBuf->aSegs[0].cbSeg));
-    RTCritSectLeave(&pThis->Lock);
+    {
+        RTCritSectEnter(&pThis->Lock);
+        if (!pSgBuf->pvUser)
+            PcapFileFrame(pThis->hFile, pThis->StartNanoTS,
+                          pSgBuf->aSegs[0].pvSeg,
+                          pSgBuf->cbUsed,
+                          RT_MIN(RT_MIN(pSgBuf->cbUsed, pSgBuf->aSegs[0].cbSeg), pThis->cbSnapLen));
+        else
+            PcapFileGsoFrame(pThis->hFile, pThis->StartNanoTS, (PCPDMNETWORKGSO)pSgBuf->pvUser,
+                             pSgBuf->aSegs[0].pvSeg,
+                             pSgBuf->cbUsed,
+                             RT_MIN(RT_MIN(pSgBuf->cbUsed, pSgBuf->aSegs[0].cbSeg), pThis->cbSnapLen));
+        RTCritSectLeave(&pThis->Lock);
+    }
 
     return pThis->pIBelowNet->pfnSendBuf(pThis->pIBelowNet, pSgBuf, fOnWorkerThread);
 }
@@ -215,9 +573,14 @@ static DECLCALLBACK(int) drvNetSnifferDown_Receive(PPDMINETWORKDOWN pInterface,
     PDRVNETSNIFFER pThis = RT_FROM_MEMBER(pInterface, DRVNETSNIFFER, INetworkDown);
 
     /* output to sniffer */
-    RTCritSectEnter(&pThis->Lock);
-    PcapFileFrame(pThis->hFile, pThis->StartNanoTS, pvBuf, cb, cb);
-    RTCritSectLeave(&pThis->Lock);
+    if (pThis->pbRing)
+        drvNetSnifferRingPut(pThis, pvBuf, cb, NULL, 0);
+    else
+    {
+        RTCritSectEnter(&pThis->Lock);
+        PcapFileFrame(pThis->hFile, pThis->StartNanoTS, pvBuf, cb, RT_MIN(cb, pThis->cbSnapLen));
+        RTCritSectLeave(&pThis->Lock);
+    }
 
     /* pass up */
     int rc = pThis->pIAboveNet->pfnReceive(pThis->pIAboveNet, pvBuf, cb);
@@ -363,6 +726,31 @@ static DECLCALLBACK(void) drvNetSnifferDestruct(PPDMDRVINS pDrvIns)
     PDRVNETSNIFFER pThis = PDMINS_2_DATA(pDrvIns, PDRVNETSNIFFER);
     PDMDRV_CHECK_VERSIONS_RETURN_VOID(pDrvIns);
 
+    /*
+     * Stop the writer thread and write out whatever is still in the ring.
+     */
+    if (pThis->pWriterThread)
+    {
+        int rcThread;
+        PDMDrvHlpThreadDestroy(pDrvIns, pThis->pWriterThread, &rcThread);
+        pThis->pWriterThread = NULL;
+    }
+    if (pThis->pbRing)
+    {
+        drvNetSnifferRingFlush(pThis);
+        drvNetSnifferRingCloseFile(pThis);
+        if (pThis->cDropped)
+            LogRel(("NetSniffer#%u: Dropped %RU64 frames because the ring buffer was full\n",
+                    pDrvIns->iInstance, pThis->cDropped));
+        RTMemPageFree(pThis->pbRing, pThis->cbRing);
+        pThis->pbRing = NULL;
+    }
+    if (pThis->hEvtWriter != NIL_RTSEMEVENT)
+    {
+        RTSemEventDestroy(pThis->hEvtWriter);
+        pThis->hEvtWriter = NIL_RTSEMEVENT;
+    }
+
     if (RTCritSectIsInitialized(&pThis->Lock))
         RTCritSectDelete(&pThis->Lock);
 
@@ -394,6 +782,7 @@ static DECLCALLBACK(int) drvNetSnifferConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pC
      */
     pThis->pDrvIns                                  = pDrvIns;
     pThis->hFile                                    = NIL_RTFILE;
+    pThis->hEvtWriter                               = NIL_RTSEMEVENT;
     /* The pcap file *must* start at time offset 0,0. */
     pThis->StartNanoTS                              = RTTimeNanoTS() - RTTimeProgramNanoTS();
     /* IBase */
@@ -426,7 +815,7 @@ static DECLCALLBACK(int) drvNetSnifferConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pC
     /*
      * Validate the config.
      */
-    PDMDRV_VALIDATE_CONFIG_RETURN(pDrvIns, "File", "");
+    PDMDRV_VALIDATE_CONFIG_RETURN(pDrvIns, "File|SnapLen|RingBufferSize|FlushInterval|RotateSize|RotateInterval", "");
 
     if (pHlp->pfnCFGMGetFirstChild(pCfg))
         LogRel(("NetSniffer: Found child config entries -- are you trying to redirect ports?\n"));
@@ -449,6 +838,52 @@ static DECLCALLBACK(int) drvNetSnifferConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pC
         return rc;
     }
 
+    /** @cfgm{SnapLen, uint32_t, 0}
+     * The max number of bytes captured per frame, 0 for all of it. */
+    rc = pHlp->pfnCFGMQueryU32Def(pCfg, "SnapLen", &pThis->cbSnapLen, 0);
+    if (RT_FAILURE(rc))
+        return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Configuration error: Failed to get the \"SnapLen\" value"));
+    if (!pThis->cbSnapLen)
+        pThis->cbSnapLen = UINT32_MAX;
+
+    /** @cfgm{RingBufferSize, uint32_t, 0}
+     * The size of the ring buffer frames are captured into and written from by
+     * a separate thread in pcapng format.  0 selects capturing synchronously on
+     * the data path in pcap format.  Rounded up to a power of two. */
+    uint32_t cbRing;
+    rc = pHlp->pfnCFGMQueryU32Def(pCfg, "RingBufferSize", &cbRing, 0);
+    if (RT_FAILURE(rc))
+        return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Configuration error: Failed to get the \"RingBufferSize\" value"));
+    if (cbRing)
+    {
+        cbRing = RT_MIN(RT_MAX(cbRing, DRVNETSNIFFER_RING_SIZE_MIN), DRVNETSNIFFER_RING_SIZE_MAX);
+        pThis->cbRing = RT_BIT_32(ASMBitLastSetU32(cbRing - 1));
+    }
+
+    /** @cfgm{FlushInterval, uint32_t, 200}
+     * How often the ring buffer is written to the file at the least, in
+     * milliseconds. */
+    rc = pHlp->pfnCFGMQueryU32Def(pCfg, "FlushInterval", &pThis->cMsFlushInterval, 200);
+    if (RT_FAILURE(rc))
+        return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Configuration error: Failed to get the \"FlushInterval\" value"));
+    pThis->cMsFlushInterval = RT_MAX(pThis->cMsFlushInterval, 1);
+
+    /** @cfgm{RotateSize, uint64_t, 0}
+     * Start a new capture file when the current one reaches this size, 0 for
+     * never.  Ring buffer mode only. */
+    rc = pHlp->pfnCFGMQueryU64Def(pCfg, "RotateSize", &pThis->cbRotateSize, 0);
+    if (RT_FAILURE(rc))
+        return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Configuration error: Failed to get the \"RotateSize\" value"));
+
+    /** @cfgm{RotateInterval, uint32_t, 0}
+     * Start a new capture file after this many seconds, 0 for never.  Ring
+     * buffer mode only. */
+    rc = pHlp->pfnCFGMQueryU32Def(pCfg, "RotateInterval", &pThis->cSecsRotateInterval, 0);
+    if (RT_FAILURE(rc))
+        return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Configuration error: Failed to get the \"RotateInterval\" value"));
+    if (!pThis->cbRing && (pThis->cbRotateSize || pThis->cSecsRotateInterval))
+        LogRel(("NetSniffer#%u: File rotation needs a ring buffer (RingBufferSize), ignored\n", pDrvIns->iInstance));
+
     /*
      * Query the network port interface.
      */
@@ -495,8 +930,16 @@ static DECLCALLBACK(int) drvNetSnifferConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pC
     /*
      * Open output file / pipe.
      */
-    rc = RTFileOpen(&pThis->hFile, pThis->szFilename,
-                    RTFILE_O_WRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_WRITE);
+    if (pThis->cbRing)
+    {
+        pThis->u64StartNanoTS  = RTTimeNanoTS();
+        RTTIMESPEC Now;
+        pThis->u64StartEpochNs = (uint64_t)RTTimeSpecGetNano(RTTimeNow(&Now));
+        rc = drvNetSnifferRingOpenFile(pThis);
+    }
+    else
+        rc = RTFileOpen(&pThis->hFile, pThis->szFilename,
+                        RTFILE_O_WRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_WRITE);
     if (RT_FAILURE(rc))
         return PDMDrvHlpVMSetError(pDrvIns, rc, RT_SRC_POS,
                                    N_("Netsniffer cannot open '%s' for writing. The directory must exist and it must be writable for the current user"), pThis->szFilename);
@@ -510,12 +953,43 @@ static DECLCALLBACK(int) drvNetSnifferConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pC
     else
         LogRel(("NetSniffer: Sniffing to '%s'\n", pThis->szFilename));
 
-    /*
-     * Write pcap header.
-     * Some time has gone by since capturing pThis->StartNanoTS so get the
-     * current time again.
-     */
-    PcapFileHdr(pThis->hFile, RTTimeNanoTS());
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatCaptured,     STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                           "Frames put into the ring buffer.",                  "/Drivers/NetSniffer%u/Captured", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatDropped,      STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                           "Frames dropped because the ring buffer was full.",  "/Drivers/NetSniffer%u/Dropped", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatBytesWritten, STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_BYTES,
+                           "Bytes written by the writer thread.",               "/Drivers/NetSniffer%u/BytesWritten", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatRotations,    STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                           "Capture file rotations.",                           "/Drivers/NetSniffer%u/Rotations", pDrvIns->iInstance);
+
+    if (pThis->cbRing)
+    {
+        /*
+         * Set up the ring buffer and the thread writing it out.
+         */
+        LogRel(("NetSniffer#%u: Ring buffer of %u bytes, snaplen %u, rotating at %RU64 bytes / %u seconds\n", pDrvIns->iInstance,
+                pThis->cbRing, pThis->cbSnapLen != UINT32_MAX ? pThis->cbSnapLen : 0, pThis->cbRotateSize,
+                pThis->cSecsRotateInterval));
+        pThis->pbRing = (uint8_t *)RTMemPageAllocZ(pThis->cbRing);
+        if (!pThis->pbRing)
+            return VERR_NO_MEMORY;
+
+        rc = RTSemEventCreate(&pThis->hEvtWriter);
+        AssertRCReturn(rc, rc);
+
+        rc = PDMDrvHlpThreadCreate(pDrvIns, &pThis->pWriterThread, pThis, drvNetSnifferWriterThread,
+                                   drvNetSnifferWriterWakeup, 0, RTTHREADTYPE_IO, "NetSniff");
+        AssertRCReturn(rc, rc);
+    }
+    else
+    {
+        /*
+         * Write pcap header.
+         * Some time has gone by since capturing pThis->StartNanoTS so get the
+         * current time again.
+         */
+        PcapFileHdr(pThis->hFile, RTTimeNanoTS());
+    }
 
     return VINF_SUCCESS;
 }
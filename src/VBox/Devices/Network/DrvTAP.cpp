@@ -71,12 +71,51 @@
 #else
 # include <sys/fcntl.h>
 #endif
+#ifdef RT_OS_LINUX
+# include <sys/uio.h>
+# include <net/if.h>
+# include <linux/if_tun.h>
+#endif
 #include <errno.h>
 #include <unistd.h>
 
 #include "VBoxDD.h"
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+#ifdef RT_OS_LINUX
+/** The virtio-net header size used by the driver itself on TAP devices set up
+ *  with IFF_VNET_HDR (struct virtio_net_hdr). */
+# define DRVTAP_VNET_HDR_SIZE       10
+/** The maximum virtio-net header size (struct virtio_net_hdr_v1). */
+# define DRVTAP_VNET_HDR_SIZE_MAX   12
+/** The maximum frame size read from the TAP device when the kernel may pass
+ *  up segmentation offload frames. */
+# define DRVTAP_RECV_GSO_FRAME_MAX  _64K
+
+/** @name DRVTAP_VNET_HDR_F_XXX - DRVTAPVNETHDR::fFlags
+ * @{ */
+# define DRVTAP_VNET_HDR_F_NEEDS_CSUM   UINT8_C(0x01)
+/** @} */
+/** @name DRVTAP_VNET_HDR_GSO_XXX - DRVTAPVNETHDR::bGsoType
+ * @{ */
+# define DRVTAP_VNET_HDR_GSO_NONE       UINT8_C(0x00)
+# define DRVTAP_VNET_HDR_GSO_TCPV4      UINT8_C(0x01)
+# define DRVTAP_VNET_HDR_GSO_UDP        UINT8_C(0x03)
+# define DRVTAP_VNET_HDR_GSO_TCPV6      UINT8_C(0x04)
+# define DRVTAP_VNET_HDR_GSO_ECN        UINT8_C(0x80)
+/** @} */
+#endif
+/** The maximum frame size read from the TAP device. */
+#define DRVTAP_RECV_FRAME_MAX       16384
+/** The size of the receive buffer frames of a burst are packed into. */
+#define DRVTAP_RECV_BUF_SIZE        _256K
+/** The maximum number of frames passed up in one burst. */
+#define DRVTAP_RECV_BURST_MAX       32
+
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
@@ -84,6 +123,7 @@
  * TAP driver instance data.
  *
  * @implements PDMINETWORKUP
+ * @implements PDMINETWORKVHOST (Linux)
  */
 typedef struct DRVTAP
 {
@@ -113,11 +153,34 @@ typedef struct DRVTAP
     RTPIPE                  hPipeRead;
     /** Reader thread. */
     PPDMTHREAD              pThread;
+    /** Receive buffer of DRVTAP_RECV_BUF_SIZE bytes (reader thread). */
+    uint8_t                *pbRecvBuf;
 
     /** @todo The transmit thread. */
     /** Transmit lock used by drvTAPNetworkUp_BeginXmit. */
     RTCRITSECT              XmitLock;
 
+#ifdef RT_OS_LINUX
+    /** The kernel offload interface. */
+    PDMINETWORKVHOST        IVHost;
+    /** The size of the virtio-net header on the TAP device, 0 if the device was
+     * set up without IFF_VNET_HDR. */
+    uint32_t volatile       cbVnetHdr;
+    /** The TUN_F_XXX receive offloads the driver itself uses, i.e. when the
+     * device above takes segmentation offload frames (pfnReceiveGso). */
+    unsigned                fTunOffloads;
+    /** The maximum frame size to read from the device, DRVTAP_RECV_GSO_FRAME_MAX
+     * with receive offloads and DRVTAP_RECV_FRAME_MAX otherwise. */
+    uint32_t                cbRecvFrameMax;
+    /** Set while the TAP device is handed over to the kernel (vhost-net), the
+     * receive thread leaves the device alone then. */
+    bool volatile           fHandedOver;
+    /** Set by drvTAPVHost_HandOver until the receive thread acknowledged it. */
+    bool volatile           fHandOverPending;
+    /** Signalled by the receive thread when it stopped touching the device. */
+    RTSEMEVENT              hEvtHandOverAck;
+#endif
+
 #ifdef VBOX_WITH_STATISTICS
     /** Number of sent packets. */
     STAMCOUNTER             StatPktSent;
@@ -127,6 +190,12 @@ typedef struct DRVTAP
     STAMCOUNTER             StatPktRecv;
     /** Number of received bytes. */
     STAMCOUNTER             StatPktRecvBytes;
+    /** Number of frame bursts passed up. */
+    STAMCOUNTER             StatRecvBursts;
+    /** Number of segmentation offload frames written to the kernel as they are. */
+    STAMCOUNTER             StatPktSentGso;
+    /** Number of segmentation offload frames received from the kernel. */
+    STAMCOUNTER             StatPktRecvGso;
     /** Profiling packet transmit runs. */
     STAMPROFILE             StatTransmit;
     /** Profiling packet receive runs. */
@@ -142,10 +211,47 @@ typedef struct DRVTAP
 } DRVTAP, *PDRVTAP;
 
 
+#ifdef RT_OS_LINUX
+/**
+ * The virtio-net header as used by the TAP device (struct virtio_net_hdr,
+ * linux/virtio_net.h cannot be used from C++), host endian.
+ */
+typedef struct DRVTAPVNETHDR
+{
+    /** DRVTAP_VNET_HDR_F_XXX. */
+    uint8_t                 fFlags;
+    /** DRVTAP_VNET_HDR_GSO_XXX. */
+    uint8_t                 bGsoType;
+    /** The size of the headers. */
+    uint16_t                cbHdrs;
+    /** The segment size (MSS). */
+    uint16_t                cbGsoSize;
+    /** Where to start checksumming. */
+    uint16_t                offCsumStart;
+    /** Where to put the checksum, relative to offCsumStart. */
+    uint16_t                offCsum;
+} DRVTAPVNETHDR;
+AssertCompileSize(DRVTAPVNETHDR, DRVTAP_VNET_HDR_SIZE);
+/** Pointer to a virtio-net header. */
+typedef DRVTAPVNETHDR *PDRVTAPVNETHDR;
+/** Pointer to a const virtio-net header. */
+typedef DRVTAPVNETHDR const *PCDRVTAPVNETHDR;
+#endif
+
+
 /** Converts a pointer to TAP::INetworkUp to a PRDVTAP. */
 #define PDMINETWORKUP_2_DRVTAP(pInterface) ( (PDRVTAP)((uintptr_t)pInterface - RT_UOFFSETOF(DRVTAP, INetworkUp)) )
 
 
+/*********************************************************************************************************************************
+*   Global Variables                                                                                                             *
+*********************************************************************************************************************************/
+#ifdef RT_OS_LINUX
+/** Zero virtio-net header prepended to frames sent on IFF_VNET_HDR devices. */
+static const uint8_t g_abZeroVnetHdr[DRVTAP_VNET_HDR_SIZE_MAX] = { 0 };
+#endif
+
+
 /*********************************************************************************************************************************
 *   Internal Functions                                                                                                           *
 *********************************************************************************************************************************/
@@ -155,6 +261,235 @@ static int              SolarisTAPAttach(PDRVTAP pThis);
 
 
 
+/**
+ * Writes one frame to the TAP device, prepending a virtio-net header if the
+ * device was set up with one.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance data.
+ * @param   pvFrame         The frame.
+ * @param   cbFrame         The frame size.
+ * @param   pvVnetHdr       The virtio-net header (DRVTAPVNETHDR) to use, NULL
+ *                          for a zero one.  Linux only.
+ */
+static int drvTAPWriteFrame(PDRVTAP pThis, const void *pvFrame, size_t cbFrame, const void *pvVnetHdr)
+{
+#ifdef RT_OS_LINUX
+    uint32_t const cbVnetHdr = ASMAtomicReadU32(&pThis->cbVnetHdr);
+    if (cbVnetHdr)
+    {
+        uint8_t      abVnetHdr[DRVTAP_VNET_HDR_SIZE_MAX];
+        struct iovec aIov[2];
+        if (!pvVnetHdr)
+            aIov[0].iov_base = (void *)&g_abZeroVnetHdr[0];
+        else
+        {
+            RT_ZERO(abVnetHdr);
+            memcpy(abVnetHdr, pvVnetHdr, sizeof(DRVTAPVNETHDR));
+            aIov[0].iov_base = abVnetHdr;
+        }
+        aIov[0].iov_len  = RT_MIN(cbVnetHdr, sizeof(g_abZeroVnetHdr));
+        aIov[1].iov_base = (void *)pvFrame;
+        aIov[1].iov_len  = cbFrame;
+        ssize_t cbWritten = writev(RTFileToNative(pThis->hFileDevice), aIov, RT_ELEMENTS(aIov));
+        if (cbWritten >= 0)
+            return VINF_SUCCESS;
+        return RTErrConvertFromErrno(errno);
+    }
+#else
+    Assert(!pvVnetHdr); RT_NOREF(pvVnetHdr);
+#endif
+    return RTFileWrite(pThis->hFileDevice, pvFrame, cbFrame, NULL);
+}
+
+
+#ifdef RT_OS_LINUX
+/**
+ * Translates a GSO context into the virtio-net header needed for writing the
+ * frame to the kernel as it is.
+ *
+ * @returns true if the kernel can take the frame, false if it must be
+ *          segmented here.
+ * @param   pGso            The GSO context.
+ * @param   pVnetHdr        Where to return the virtio-net header.
+ */
+static bool drvTAPGsoToVnetHdr(PCPDMNETWORKGSO pGso, PDRVTAPVNETHDR pVnetHdr)
+{
+    RT_ZERO(*pVnetHdr);
+    switch ((PDMNETWORKGSOTYPE)pGso->u8Type)
+    {
+        case PDMNETWORKGSOTYPE_IPV4_TCP:
+            pVnetHdr->bGsoType = DRVTAP_VNET_HDR_GSO_TCPV4;
+            break;
+        case PDMNETWORKGSOTYPE_IPV6_TCP:
+            pVnetHdr->bGsoType = DRVTAP_VNET_HDR_GSO_TCPV6;
+            break;
+        default:
+            /* UDP fragmentation offload is not taken by all kernels, and tunneled
+               frames have no virtio-net representation. */
+            return false;
+    }
+    pVnetHdr->fFlags       = DRVTAP_VNET_HDR_F_NEEDS_CSUM;
+    pVnetHdr->cbHdrs     = pGso->cbHdrsTotal;
+    pVnetHdr->cbGsoSize    = pGso->cbMaxSeg;
+    pVnetHdr->offCsumStart  = pGso->offHdr2;
+    pVnetHdr->offCsum = RT_UOFFSETOF(RTNETTCP, th_sum);
+    return true;
+}
+
+
+/**
+ * Deals with the offload information in the virtio-net header of a frame read
+ * from the kernel.
+ *
+ * Partial checksums are completed as there is no way of passing them on, and
+ * segmentation offload frames get a GSO context.
+ *
+ * @returns IPRT status code.
+ * @param   pVnetHdr        The virtio-net header of the frame.
+ * @param   pbFrame         The frame.
+ * @param   cbFrame         The frame size.
+ * @param   pGso            Where to return the GSO context.  The type is left
+ *                          at PDMNETWORKGSOTYPE_INVALID for normal frames.
+ */
+static int drvTAPRecvVnetHdr(PCDRVTAPVNETHDR pVnetHdr, uint8_t *pbFrame, size_t cbFrame, PPDMNETWORKGSO pGso)
+{
+    if (!(pVnetHdr->fFlags & DRVTAP_VNET_HDR_F_NEEDS_CSUM))
+        return VINF_SUCCESS;
+
+    uint32_t const offCsumStart = pVnetHdr->offCsumStart;
+    uint32_t const offCsum      = offCsumStart + pVnetHdr->offCsum;
+    if (   offCsumStart < sizeof(RTNETETHERHDR)
+        || offCsum + sizeof(uint16_t) > cbFrame)
+        return VERR_INVALID_PARAMETER;
+
+    switch (pVnetHdr->bGsoType & ~DRVTAP_VNET_HDR_GSO_ECN)
+    {
+        case DRVTAP_VNET_HDR_GSO_NONE:
+        {
+            /* The checksum field holds the pseudo header sum, add the rest. */
+            bool     fOdd   = false;
+            uint32_t u32Sum = RTNetIPv4AddDataChecksum(&pbFrame[offCsumStart], cbFrame - offCsumStart, 0, &fOdd);
+            uint16_t u16Sum = RTNetIPv4FinalizeChecksum(u32Sum);
+            if (!u16Sum)
+                u16Sum = 0xffff;
+            memcpy(&pbFrame[offCsum], &u16Sum, sizeof(u16Sum));
+            return VINF_SUCCESS;
+        }
+
+        case DRVTAP_VNET_HDR_GSO_TCPV4:
+        case DRVTAP_VNET_HDR_GSO_TCPV6:
+        {
+            if (offCsumStart + RTNETTCP_MIN_LEN > cbFrame)
+                return VERR_INVALID_PARAMETER;
+            PCRTNETTCP const pTcpHdr     = (PCRTNETTCP)&pbFrame[offCsumStart];
+            uint32_t const   cbHdrsTotal = offCsumStart + pTcpHdr->th_off * 4;
+            if (cbHdrsTotal > UINT8_MAX)
+                return VERR_NOT_SUPPORTED;
+            pGso->u8Type      = (pVnetHdr->bGsoType & ~DRVTAP_VNET_HDR_GSO_ECN) == DRVTAP_VNET_HDR_GSO_TCPV4
+                              ? PDMNETWORKGSOTYPE_IPV4_TCP : PDMNETWORKGSOTYPE_IPV6_TCP;
+            pGso->offHdr1     = sizeof(RTNETETHERHDR);
+            pGso->offHdr2     = (uint8_t)offCsumStart;
+            pGso->cbHdrsTotal = (uint8_t)cbHdrsTotal;
+            pGso->cbHdrsSeg   = (uint8_t)cbHdrsTotal;
+            pGso->cbMaxSeg    = pVnetHdr->cbGsoSize;
+            if (PDMNetGsoIsValid(pGso, sizeof(*pGso), cbFrame))
+                return VINF_SUCCESS;
+            pGso->u8Type      = PDMNETWORKGSOTYPE_INVALID;
+            return VERR_INVALID_PARAMETER;
+        }
+
+        default:
+            /* We don't ask for UFO. */
+            return VERR_NOT_SUPPORTED;
+    }
+}
+#endif /* RT_OS_LINUX */
+
+
+/**
+ * Reads one frame from the TAP device, stripping the virtio-net header if the
+ * device was set up with one.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance data.
+ * @param   pvBuf           Where to return the frame.
+ * @param   cbBuf           The buffer size.
+ * @param   pcbRead         Where to return the frame size.
+ * @param   pGso            Where to return the GSO context of segmentation
+ *                          offload frames.  The type is set to
+ *                          PDMNETWORKGSOTYPE_INVALID for normal frames.
+ */
+static int drvTAPReadFrame(PDRVTAP pThis, void *pvBuf, size_t cbBuf, size_t *pcbRead, PPDMNETWORKGSO pGso)
+{
+    pGso->u8Type = PDMNETWORKGSOTYPE_INVALID;
+#ifdef RT_OS_LINUX
+    uint32_t const cbVnetHdr = ASMAtomicReadU32(&pThis->cbVnetHdr);
+    if (cbVnetHdr)
+    {
+        union
+        {
+            DRVTAPVNETHDR           Hdr;
+            uint8_t                 ab[DRVTAP_VNET_HDR_SIZE_MAX];
+        }            VnetHdr;
+        struct iovec aIov[2];
+        aIov[0].iov_base = &VnetHdr;
+        aIov[0].iov_len  = RT_MIN(cbVnetHdr, sizeof(VnetHdr));
+        aIov[1].iov_base = pvBuf;
+        aIov[1].iov_len  = cbBuf;
+        ssize_t cbRead = readv(RTFileToNative(pThis->hFileDevice), aIov, RT_ELEMENTS(aIov));
+        if (cbRead >= (ssize_t)aIov[0].iov_len)
+        {
+            *pcbRead = (size_t)cbRead - aIov[0].iov_len;
+            return drvTAPRecvVnetHdr(&VnetHdr.Hdr, (uint8_t *)pvBuf, *pcbRead, pGso);
+        }
+        *pcbRead = 0;
+        if (cbRead >= 0)
+            return VERR_TRY_AGAIN; /* runt */
+        return RTErrConvertFromErrno(errno);
+    }
+#endif
+    return RTFileRead(pThis->hFileDevice, pvBuf, cbBuf, pcbRead);
+}
+
+
+/**
+ * Passes a segmentation offload frame up, segmenting it here if the device
+ * doesn't take those (or not right now).
+ *
+ * @returns VBox status code of the last pfnReceive / pfnReceiveGso call.
+ * @param   pThis           The instance data.
+ * @param   pFrame          The frame, pGso is not NULL.
+ */
+static int drvTAPRecvGsoFrame(PDRVTAP pThis, PCPDMNETWORKRECVFRAME pFrame)
+{
+    STAM_COUNTER_INC(&pThis->StatPktRecvGso);
+    int rc = pThis->pIAboveNet->pfnReceiveGso
+           ? pThis->pIAboveNet->pfnReceiveGso(pThis->pIAboveNet, pFrame->pvFrame, pFrame->cbFrame, pFrame->pGso)
+           : VERR_NOT_SUPPORTED;
+    if (rc != VERR_NOT_SUPPORTED)
+        return rc;
+
+    uint8_t         abHdrScratch[256];
+    uint8_t * const pbFrame = (uint8_t *)pFrame->pvFrame;
+    uint32_t const  cSegs   = PDMNetGsoCalcSegmentCount(pFrame->pGso, pFrame->cbFrame);
+    for (uint32_t iSeg = 0; iSeg < cSegs; iSeg++)
+    {
+        if (iSeg)
+        {
+            rc = pThis->pIAboveNet->pfnWaitReceiveAvail(pThis->pIAboveNet, RT_INDEFINITE_WAIT);
+            if (RT_FAILURE(rc))
+                break; /* we drop the rest. */
+        }
+        uint32_t cbSegFrame;
+        void    *pvSegFrame = PDMNetGsoCarveSegmentQD(pFrame->pGso, pbFrame, pFrame->cbFrame, abHdrScratch,
+                                                      iSeg, cSegs, &cbSegFrame);
+        rc = pThis->pIAboveNet->pfnReceive(pThis->pIAboveNet, pvSegFrame, cbSegFrame);
+    }
+    return rc;
+}
+
+
 /**
  * @interface_method_impl{PDMINETWORKUP,pfnBeginXmit}
  */
@@ -270,23 +605,38 @@ static DECLCALLBACK(int) drvTAPNetworkUp_SendBuf(PPDMINETWORKUP pInterface, PPDM
               "%.*Rhxd\n",
               pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed, pSgBuf->cbUsed, pSgBuf->aSegs[0].pvSeg));
 
-        rc = RTFileWrite(pThis->hFileDevice, pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed, NULL);
+        rc = drvTAPWriteFrame(pThis, pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed, NULL);
     }
     else
     {
-        uint8_t         abHdrScratch[256];
-        uint8_t const  *pbFrame = (uint8_t const *)pSgBuf->aSegs[0].pvSeg;
-        PCPDMNETWORKGSO pGso    = (PCPDMNETWORKGSO)pSgBuf->pvUser;
-        uint32_t const  cSegs   = PDMNetGsoCalcSegmentCount(pGso, pSgBuf->cbUsed);  Assert(cSegs > 1);
-        rc = VINF_SUCCESS;
-        for (size_t iSeg = 0; iSeg < cSegs; iSeg++)
+        PCPDMNETWORKGSO pGso = (PCPDMNETWORKGSO)pSgBuf->pvUser;
+#ifdef RT_OS_LINUX
+        DRVTAPVNETHDR VnetHdr;
+        if (   ASMAtomicReadU32(&pThis->cbVnetHdr)
+            && PDMNetGsoIsValid(pGso, sizeof(*pGso), pSgBuf->cbUsed)
+            && drvTAPGsoToVnetHdr(pGso, &VnetHdr))
         {
-            uint32_t cbSegFrame;
-            void *pvSegFrame = PDMNetGsoCarveSegmentQD(pGso, (uint8_t *)pbFrame, pSgBuf->cbUsed, abHdrScratch,
-                                                       iSeg, cSegs, &cbSegFrame);
-            rc = RTFileWrite(pThis->hFileDevice, pvSegFrame, cbSegFrame, NULL);
-            if (RT_FAILURE(rc))
-                break;
+            /* Let the kernel do the segmenting (or the NIC, if it goes that far). */
+            STAM_COUNTER_INC(&pThis->StatPktSentGso);
+            PDMNetGsoPrepForDirectUse(pGso, pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed, PDMNETCSUMTYPE_PSEUDO);
+            rc = drvTAPWriteFrame(pThis, pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed, &VnetHdr);
+        }
+        else
+#endif
+        {
+            uint8_t         abHdrScratch[256];
+            uint8_t const  *pbFrame = (uint8_t const *)pSgBuf->aSegs[0].pvSeg;
+            uint32_t const  cSegs   = PDMNetGsoCalcSegmentCount(pGso, pSgBuf->cbUsed);  Assert(cSegs > 1);
+            rc = VINF_SUCCESS;
+            for (size_t iSeg = 0; iSeg < cSegs; iSeg++)
+            {
+                uint32_t cbSegFrame;
+                void *pvSegFrame = PDMNetGsoCarveSegmentQD(pGso, (uint8_t *)pbFrame, pSgBuf->cbUsed, abHdrScratch,
+                                                           iSeg, cSegs, &cbSegFrame);
+                rc = drvTAPWriteFrame(pThis, pvSegFrame, cbSegFrame, NULL);
+                if (RT_FAILURE(rc))
+                    break;
+            }
         }
     }
 
@@ -359,11 +709,22 @@ static DECLCALLBACK(int) drvTAPAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
      */
     while (pThread->enmState == PDMTHREADSTATE_RUNNING)
     {
+#ifdef RT_OS_LINUX
+        /* Let drvTAPVHost_HandOver know we're done with any frame read before the hand over. */
+        if (ASMAtomicCmpXchgBool(&pThis->fHandOverPending, false, true))
+            RTSemEventSignal(pThis->hEvtHandOverAck);
+#endif
+
         /*
          * Wait for something to become available.
          */
         struct pollfd aFDs[2];
+#ifdef RT_OS_LINUX
+        /* A negative descriptor is ignored by poll(), the kernel owns the device while handed over. */
+        aFDs[0].fd      = !ASMAtomicReadBool(&pThis->fHandedOver) ? RTFileToNative(pThis->hFileDevice) : -1;
+#else
         aFDs[0].fd      = RTFileToNative(pThis->hFileDevice);
+#endif
         aFDs[0].events  = POLLIN | POLLPRI;
         aFDs[0].revents = 0;
         aFDs[1].fd      = RTPipeToNative(pThis->hPipeRead);
@@ -385,12 +746,11 @@ static DECLCALLBACK(int) drvTAPAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
             /*
              * Read the frame.
              */
-            char achBuf[16384];
-            size_t cbRead = 0;
-            /** @note At least on Linux we will never receive more than one network packet
-             *        after poll() returned successfully. I don't know why but a second
-             *        RTFileRead() operation will return with VERR_TRY_AGAIN in any case. */
-            rc = RTFileRead(pThis->hFileDevice, achBuf, sizeof(achBuf), &cbRead);
+            uint8_t      *pbBuf          = pThis->pbRecvBuf;
+            size_t const  cbRecvFrameMax = pThis->cbRecvFrameMax;
+            size_t        cbRead         = 0;
+            PDMNETWORKGSO aGso[DRVTAP_RECV_BURST_MAX];
+            rc = drvTAPReadFrame(pThis, pbBuf, cbRecvFrameMax, &cbRead, &aGso[0]);
             if (RT_SUCCESS(rc))
             {
                 /*
@@ -417,20 +777,107 @@ static DECLCALLBACK(int) drvTAPAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
                 if (RT_FAILURE(rc1))
                     continue;
 
+                /*
+                 * If the device takes bursts, also read whatever else is queued on the
+                 * (non-blocking) descriptor so it can all be passed up in one go.  Once
+                 * the queue is empty the read fails with VERR_TRY_AGAIN.
+                 */
+                PDMNETWORKRECVFRAME aFrames[DRVTAP_RECV_BURST_MAX];
+                aFrames[0].pvFrame = pbBuf;
+                aFrames[0].cbFrame = cbRead;
+                aFrames[0].pGso    = aGso[0].u8Type != PDMNETWORKGSOTYPE_INVALID ? &aGso[0] : NULL;
+                uint32_t cFrames   = 1;
+                size_t   cbTotal   = cbRead;
+                if (pThis->pIAboveNet->pfnReceiveBurst)
+                {
+                    size_t offBuf = RT_ALIGN_Z(cbRead, 16);
+                    while (   cFrames < RT_ELEMENTS(aFrames)
+                           && DRVTAP_RECV_BUF_SIZE - offBuf >= cbRecvFrameMax
+#ifdef RT_OS_LINUX
+                           && !ASMAtomicReadBool(&pThis->fHandOverPending)
+#endif
+                          )
+                    {
+                        size_t cbFrame = 0;
+                        rc = drvTAPReadFrame(pThis, &pbBuf[offBuf], cbRecvFrameMax, &cbFrame, &aGso[cFrames]);
+                        if (RT_FAILURE(rc) || !cbFrame)
+                            break;
+                        aFrames[cFrames].pvFrame = &pbBuf[offBuf];
+                        aFrames[cFrames].cbFrame = cbFrame;
+                        aFrames[cFrames].pGso    = aGso[cFrames].u8Type != PDMNETWORKGSOTYPE_INVALID ? &aGso[cFrames] : NULL;
+                        cFrames++;
+                        cbTotal += cbFrame;
+                        offBuf  += RT_ALIGN_Z(cbFrame, 16);
+                    }
+                }
+
                 /*
                  * Pass the data up.
                  */
 #ifdef LOG_ENABLED
                 uint64_t u64Now = RTTimeProgramNanoTS();
-                LogFlow(("drvTAPAsyncIoThread: %-4d bytes at %llu ns  deltas: r=%llu t=%llu\n",
-                         cbRead, u64Now, u64Now - pThis->u64LastReceiveTS, u64Now - pThis->u64LastTransferTS));
+                LogFlow(("drvTAPAsyncIoThread: %-4d bytes in %u frame(s) at %llu ns  deltas: r=%llu t=%llu\n",
+                         cbTotal, cFrames, u64Now, u64Now - pThis->u64LastReceiveTS, u64Now - pThis->u64LastTransferTS));
                 pThis->u64LastReceiveTS = u64Now;
 #endif
-                Log2(("drvTAPAsyncIoThread: cbRead=%#x\n" "%.*Rhxd\n", cbRead, cbRead, achBuf));
-                STAM_COUNTER_INC(&pThis->StatPktRecv);
-                STAM_COUNTER_ADD(&pThis->StatPktRecvBytes, cbRead);
-                rc1 = pThis->pIAboveNet->pfnReceive(pThis->pIAboveNet, achBuf, cbRead);
-                AssertRC(rc1);
+                Log2(("drvTAPAsyncIoThread: cbRead=%#x\n" "%.*Rhxd\n", cbRead, cbRead, pbBuf));
+                STAM_COUNTER_ADD(&pThis->StatPktRecv, cFrames);
+                STAM_COUNTER_ADD(&pThis->StatPktRecvBytes, cbTotal);
+                if (cFrames == 1)
+                {
+                    if (!aFrames[0].pGso)
+                        rc1 = pThis->pIAboveNet->pfnReceive(pThis->pIAboveNet, pbBuf, cbRead);
+                    else
+                        rc1 = drvTAPRecvGsoFrame(pThis, &aFrames[0]);
+                    AssertRC(rc1);
+                }
+                else
+                {
+                    /*
+                     * Normal frames go up in bursts, segmentation offload frames
+                     * one by one as they may have to be segmented here.
+                     */
+                    STAM_COUNTER_INC(&pThis->StatRecvBursts);
+                    uint32_t iFrame = 0;
+                    while (iFrame < cFrames)
+                    {
+                        if (aFrames[iFrame].pGso)
+                        {
+                            if (iFrame > 0)
+                            {
+                                STAM_PROFILE_ADV_STOP(&pThis->StatReceive, a);
+                                rc1 = pThis->pIAboveNet->pfnWaitReceiveAvail(pThis->pIAboveNet, RT_INDEFINITE_WAIT);
+                                STAM_PROFILE_ADV_START(&pThis->StatReceive, a);
+                                if (RT_FAILURE(rc1))
+                                    break;
+                            }
+                            drvTAPRecvGsoFrame(pThis, &aFrames[iFrame]);
+                            iFrame++;
+                            continue;
+                        }
+
+                        uint32_t iFrameEnd = iFrame + 1;
+                        while (iFrameEnd < cFrames && !aFrames[iFrameEnd].pGso)
+                            iFrameEnd++;
+                        for (;;)
+                        {
+                            uint32_t cDone = 0;
+                            rc1 = pThis->pIAboveNet->pfnReceiveBurst(pThis->pIAboveNet, &aFrames[iFrame], iFrameEnd - iFrame, &cDone);
+                            iFrame += cDone;
+                            if (rc1 != VERR_NET_NO_BUFFER_SPACE || iFrame >= iFrameEnd)
+                                break;
+
+                            /* Out of guest buffers part way, wait for more (dropping the rest on state changes). */
+                            STAM_PROFILE_ADV_STOP(&pThis->StatReceive, a);
+                            rc1 = pThis->pIAboveNet->pfnWaitReceiveAvail(pThis->pIAboveNet, RT_INDEFINITE_WAIT);
+                            STAM_PROFILE_ADV_START(&pThis->StatReceive, a);
+                            if (RT_FAILURE(rc1))
+                                break;
+                        }
+                        if (iFrame < iFrameEnd)
+                            break;
+                    }
+                }
             }
             else
             {
@@ -495,6 +942,112 @@ static DECLCALLBACK(int) drvTapAsyncIoWakeup(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
 }
 
 
+#ifdef RT_OS_LINUX
+
+/* -=-=-=-=- PDMINETWORKVHOST -=-=-=-=- */
+
+/**
+ * Configures the virtio-net header size and the receive offloads of the TAP device.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance data.
+ * @param   cbVnetHdr       The header size.
+ * @param   fTunOffloads    TUN_F_XXX.
+ */
+static int drvTAPSetVnetHdr(PDRVTAP pThis, uint32_t cbVnetHdr, unsigned fTunOffloads)
+{
+    int iHdrSize = (int)cbVnetHdr;
+    if (ioctl(RTFileToNative(pThis->hFileDevice), TUNSETVNETHDRSZ, &iHdrSize) != 0)
+        return RTErrConvertFromErrno(errno);
+    if (ioctl(RTFileToNative(pThis->hFileDevice), TUNSETOFFLOAD, (unsigned long)fTunOffloads) != 0)
+        return RTErrConvertFromErrno(errno);
+    ASMAtomicWriteU32(&pThis->cbVnetHdr, cbVnetHdr);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnHandOver}
+ */
+static DECLCALLBACK(int) drvTAPVHost_HandOver(PPDMINETWORKVHOST pInterface, uint32_t cbVnetHdr, uint32_t fOffloads,
+                                              RTHCINTPTR *phNative)
+{
+    PDRVTAP pThis = RT_FROM_MEMBER(pInterface, DRVTAP, IVHost);
+    AssertReturn(!(fOffloads & ~PDMINETWORKVHOST_OFFLOAD_F_VALID_MASK), VERR_INVALID_FLAGS);
+    AssertReturn(cbVnetHdr >= DRVTAP_VNET_HDR_SIZE && cbVnetHdr <= DRVTAP_VNET_HDR_SIZE_MAX, VERR_INVALID_PARAMETER);
+    if (!pThis->cbVnetHdr)
+        return VERR_NOT_SUPPORTED;
+
+    unsigned fTunOffloads = 0;
+    if (fOffloads & PDMINETWORKVHOST_OFFLOAD_F_CSUM)
+    {
+        /* The segmentation offloads require checksum offloading. */
+        fTunOffloads |= TUN_F_CSUM;
+        if (fOffloads & PDMINETWORKVHOST_OFFLOAD_F_TSO4)
+            fTunOffloads |= TUN_F_TSO4;
+        if (fOffloads & PDMINETWORKVHOST_OFFLOAD_F_TSO6)
+            fTunOffloads |= TUN_F_TSO6;
+        if ((fOffloads & PDMINETWORKVHOST_OFFLOAD_F_TSO_ECN) && (fTunOffloads & (TUN_F_TSO4 | TUN_F_TSO6)))
+            fTunOffloads |= TUN_F_TSO_ECN;
+        if (fOffloads & PDMINETWORKVHOST_OFFLOAD_F_UFO)
+            fTunOffloads |= TUN_F_UFO;
+    }
+
+    /*
+     * Get the receive thread off the device first, a frame it already read is
+     * still passed up and the device must not see any after we return.  No need
+     * to wait when the thread isn't running, it checks the flag when resumed.
+     */
+    ASMAtomicWriteBool(&pThis->fHandedOver, true);
+    ASMAtomicWriteBool(&pThis->fHandOverPending, true);
+    drvTapAsyncIoWakeup(pThis->pDrvIns, pThis->pThread);
+    if (   pThis->pThread
+        && pThis->pThread->enmState == PDMTHREADSTATE_RUNNING
+        && ASMAtomicReadBool(&pThis->fHandOverPending))
+    {
+        int rc2 = RTSemEventWait(pThis->hEvtHandOverAck, RT_MS_5SEC);
+        if (RT_FAILURE(rc2) && ASMAtomicReadBool(&pThis->fHandOverPending))
+            LogRel(("TAP#%u: Receive thread did not acknowledge the hand over: %Rrc\n", pThis->pDrvIns->iInstance, rc2));
+    }
+    ASMAtomicWriteBool(&pThis->fHandOverPending, false);
+
+    int rc = drvTAPSetVnetHdr(pThis, cbVnetHdr, fTunOffloads);
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("TAP#%u: Failed to configure the virtio-net header for kernel offload: %Rrc\n", pThis->pDrvIns->iInstance, rc));
+        drvTAPSetVnetHdr(pThis, DRVTAP_VNET_HDR_SIZE, pThis->fTunOffloads);
+        ASMAtomicWriteBool(&pThis->fHandedOver, false);
+        drvTapAsyncIoWakeup(pThis->pDrvIns, pThis->pThread);
+        return rc;
+    }
+
+    *phNative = (RTHCINTPTR)RTFileToNative(pThis->hFileDevice);
+    LogRel(("TAP#%u: Device handed over to the kernel (vnet hdr %u bytes, offloads %#x)\n",
+            pThis->pDrvIns->iInstance, cbVnetHdr, fTunOffloads));
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnTakeBack}
+ */
+static DECLCALLBACK(void) drvTAPVHost_TakeBack(PPDMINETWORKVHOST pInterface)
+{
+    PDRVTAP pThis = RT_FROM_MEMBER(pInterface, DRVTAP, IVHost);
+    if (!ASMAtomicReadBool(&pThis->fHandedOver))
+        return;
+
+    int rc = drvTAPSetVnetHdr(pThis, DRVTAP_VNET_HDR_SIZE, pThis->fTunOffloads);
+    AssertLogRelRC(rc);
+
+    ASMAtomicWriteBool(&pThis->fHandedOver, false);
+    drvTapAsyncIoWakeup(pThis->pDrvIns, pThis->pThread);
+    LogRel(("TAP#%u: Device taken back from the kernel\n", pThis->pDrvIns->iInstance));
+}
+
+#endif /* RT_OS_LINUX */
+
+
 #if defined(RT_OS_SOLARIS)
 /**
  * Calls OS-specific TAP setup application/script.
@@ -769,6 +1322,9 @@ static DECLCALLBACK(void *) drvTAPQueryInterface(PPDMIBASE pInterface, const cha
 
     PDMIBASE_RETURN_INTERFACE(pszIID, PDMIBASE, &pDrvIns->IBase);
     PDMIBASE_RETURN_INTERFACE(pszIID, PDMINETWORKUP, &pThis->INetworkUp);
+#ifdef RT_OS_LINUX
+    PDMIBASE_RETURN_INTERFACE(pszIID, PDMINETWORKVHOST, &pThis->IVHost);
+#endif
     return NULL;
 }
 
@@ -840,6 +1396,17 @@ static DECLCALLBACK(void) drvTAPDestruct(PPDMDRVINS pDrvIns)
     if (RTCritSectIsInitialized(&pThis->XmitLock))
         RTCritSectDelete(&pThis->XmitLock);
 
+#ifdef RT_OS_LINUX
+    if (pThis->hEvtHandOverAck != NIL_RTSEMEVENT)
+    {
+        RTSemEventDestroy(pThis->hEvtHandOverAck);
+        pThis->hEvtHandOverAck = NIL_RTSEMEVENT;
+    }
+#endif
+
+    RTMemFree(pThis->pbRecvBuf);
+    pThis->pbRecvBuf = NULL;
+
 #ifdef VBOX_WITH_STATISTICS
     /*
      * Deregister statistics.
@@ -848,6 +1415,9 @@ static DECLCALLBACK(void) drvTAPDestruct(PPDMDRVINS pDrvIns)
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatPktSentBytes);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatPktRecv);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatPktRecvBytes);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatRecvBursts);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatPktSentGso);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatPktRecvGso);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatTransmit);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReceive);
 #endif /* VBOX_WITH_STATISTICS */
@@ -880,6 +1450,11 @@ static DECLCALLBACK(int) drvTAPConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
 #endif
     pThis->pszSetupApplication          = NULL;
     pThis->pszTerminateApplication      = NULL;
+    pThis->cbRecvFrameMax               = DRVTAP_RECV_FRAME_MAX;
+#ifdef RT_OS_LINUX
+    pThis->fTunOffloads                 = 0;
+    pThis->hEvtHandOverAck              = NIL_RTSEMEVENT;
+#endif
 
     /* IBase */
     pDrvIns->IBase.pfnQueryInterface    = drvTAPQueryInterface;
@@ -891,6 +1466,11 @@ static DECLCALLBACK(int) drvTAPConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     pThis->INetworkUp.pfnEndXmit                = drvTAPNetworkUp_EndXmit;
     pThis->INetworkUp.pfnSetPromiscuousMode     = drvTAPNetworkUp_SetPromiscuousMode;
     pThis->INetworkUp.pfnNotifyLinkChanged      = drvTAPNetworkUp_NotifyLinkChanged;
+#ifdef RT_OS_LINUX
+    /* IVHost */
+    pThis->IVHost.pfnHandOver                   = drvTAPVHost_HandOver;
+    pThis->IVHost.pfnTakeBack                   = drvTAPVHost_TakeBack;
+#endif
 
 #ifdef VBOX_WITH_STATISTICS
     /*
@@ -900,6 +1480,9 @@ static DECLCALLBACK(int) drvTAPConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatPktSentBytes,  STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,             "Number of sent bytes.",            "/Drivers/TAP%d/Bytes/Sent", pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatPktRecv,       STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,        "Number of received packets.",      "/Drivers/TAP%d/Packets/Received", pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatPktRecvBytes,  STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,             "Number of received bytes.",        "/Drivers/TAP%d/Bytes/Received", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatRecvBursts,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,        "Number of frame bursts passed up.", "/Drivers/TAP%d/Packets/ReceivedBursts", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatPktSentGso,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,        "Number of GSO frames sent unsegmented.", "/Drivers/TAP%d/Packets/SentGso", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatPktRecvGso,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,        "Number of GSO frames received.",   "/Drivers/TAP%d/Packets/ReceivedGso", pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatTransmit,      STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL,    "Profiling packet transmit runs.",  "/Drivers/TAP%d/Transmit", pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatReceive,       STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL,    "Profiling packet receive runs.",   "/Drivers/TAP%d/Receive", pDrvIns->iInstance);
 #endif /* VBOX_WITH_STATISTICS */
@@ -993,6 +1576,11 @@ static DECLCALLBACK(int) drvTAPConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     rc = RTCritSectInit(&pThis->XmitLock);
     AssertRCReturn(rc, rc);
 
+#ifdef RT_OS_LINUX
+    rc = RTSemEventCreate(&pThis->hEvtHandOverAck);
+    AssertRCReturn(rc, rc);
+#endif
+
     /*
      * Make sure the descriptor is non-blocking and valid.
      *
@@ -1006,12 +1594,47 @@ static DECLCALLBACK(int) drvTAPConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     Log(("drvTAPContruct: %d (from fd)\n", (intptr_t)pThis->hFileDevice));
     rc = VINF_SUCCESS;
 
+#ifdef RT_OS_LINUX
+    /*
+     * If the device was set up with virtio-net headers, segmentation offload
+     * frames can be written as they are.  Let the kernel pass up large frames
+     * too if the device above takes them.
+     */
+    struct ifreq IfReq;
+    RT_ZERO(IfReq);
+    if (   ioctl(RTFileToNative(pThis->hFileDevice), TUNGETIFF, &IfReq) == 0
+        && (IfReq.ifr_flags & IFF_VNET_HDR))
+    {
+        if (pThis->pIAboveNet->pfnReceiveGso)
+            pThis->fTunOffloads = TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6;
+        rc = drvTAPSetVnetHdr(pThis, DRVTAP_VNET_HDR_SIZE, pThis->fTunOffloads);
+        if (RT_FAILURE(rc) && pThis->fTunOffloads)
+        {
+            LogRel(("TAP#%u: Failed to enable receive offloads (%Rrc), continuing without\n", pDrvIns->iInstance, rc));
+            pThis->fTunOffloads = 0;
+            rc = drvTAPSetVnetHdr(pThis, DRVTAP_VNET_HDR_SIZE, 0);
+        }
+        if (RT_FAILURE(rc))
+            return PDMDrvHlpVMSetError(pDrvIns, rc, RT_SRC_POS,
+                                       N_("Configuration error: Failed to configure the TAP virtio-net header"));
+        if (pThis->fTunOffloads)
+            pThis->cbRecvFrameMax = DRVTAP_RECV_GSO_FRAME_MAX;
+        LogRel(("TAP#%u: Device uses virtio-net headers, receive offloads %#x\n", pDrvIns->iInstance, pThis->fTunOffloads));
+    }
+#endif
+
     /*
      * Create the control pipe.
      */
     rc = RTPipeCreate(&pThis->hPipeRead, &pThis->hPipeWrite, 0 /*fFlags*/);
     AssertRCReturn(rc, rc);
 
+    /*
+     * Allocate the receive buffer (too big for the thread stack when taking bursts).
+     */
+    pThis->pbRecvBuf = (uint8_t *)RTMemAlloc(DRVTAP_RECV_BUF_SIZE);
+    AssertReturn(pThis->pbRecvBuf, VERR_NO_MEMORY);
+
     /*
      * Create the async I/O thread.
      */
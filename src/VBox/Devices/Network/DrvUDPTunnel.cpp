@@ -46,10 +46,51 @@
 #include <iprt/uuid.h>
 #include <iprt/string.h>
 #include <iprt/critsect.h>
+#ifdef RT_OS_LINUX
+# include <iprt/socket.h>
+
+# include <errno.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <netinet/udp.h>
+#endif
 
 #include "VBoxDD.h"
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+#ifdef RT_OS_LINUX
+/** The maximum number of frames passed up in one burst. */
+# define DRVUDPTUNNEL_RECV_BURST_MAX        32
+/** The maximum number of datagrams read by one recvmmsg call. */
+# define DRVUDPTUNNEL_RECV_MSGS_MAX         8
+/** The buffer size per datagram read by recvmmsg, big enough for the
+ *  datagrams the kernel glues together with UDP_GRO. */
+# define DRVUDPTUNNEL_RECV_MSG_SIZE         _64K
+/** The maximum number of datagrams sent by one sendmmsg call. */
+# define DRVUDPTUNNEL_XMIT_MSGS_MAX         32
+/** The maximum number of I/O vectors used by the datagrams of a batch. */
+# define DRVUDPTUNNEL_XMIT_IOVS_MAX         256
+/** The number of segment header buffers for carving GSO frames in a batch. */
+# define DRVUDPTUNNEL_XMIT_HDRS_MAX         128
+/** The size of a segment header buffer. */
+# define DRVUDPTUNNEL_XMIT_HDR_SIZE         256
+/** The maximum number of segments the kernel accepts in one UDP GSO datagram
+ *  (UDP_MAX_SEGMENTS of older kernels). */
+# define DRVUDPTUNNEL_UDP_GSO_SEGS_MAX      64
+/** The maximum payload of a UDP GSO datagram (IPv4). */
+# define DRVUDPTUNNEL_UDP_GSO_BYTES_MAX     65507
+# ifndef UDP_SEGMENT
+#  define UDP_SEGMENT                       103
+# endif
+# ifndef UDP_GRO
+#  define UDP_GRO                           104
+# endif
+#endif
+
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
@@ -85,6 +126,51 @@ typedef struct DRVUDPTUNNEL
     /** Flag whether the link is down. */
     bool volatile           fLinkDown;
 
+#ifdef RT_OS_LINUX
+    /** Whether the kernel segments UDP GSO datagrams for us (UDP_SEGMENT). */
+    bool                    fUdpGso;
+    /** The server socket used for sending batches (retained), NIL_RTSOCKET
+     * if not available.  Protected by XmitLock. */
+    RTSOCKET                hSocket;
+    /** The destination address in native form. */
+    struct sockaddr_storage DestSockAddr;
+    /** The size of DestSockAddr, 0 if not usable. */
+    socklen_t               cbDestSockAddr;
+
+    /** @name Transmit batch, protected by XmitLock and sent by
+     *        drvUDPTunnelXmitFlush at the latest when the device ends the
+     *        transmit run.
+     * @{ */
+    /** Number of queued datagrams. */
+    uint32_t                cXmitMsgs;
+    /** Number of used I/O vectors. */
+    uint32_t                cXmitIovs;
+    /** Number of used segment header buffers. */
+    uint32_t                cXmitHdrs;
+    /** Number of S/G buffers to free after sending. */
+    uint32_t                cXmitSgBufs;
+    /** The queued datagrams. */
+    struct mmsghdr          aXmitMsgs[DRVUDPTUNNEL_XMIT_MSGS_MAX];
+    /** The I/O vectors of the queued datagrams. */
+    struct iovec            aXmitIovs[DRVUDPTUNNEL_XMIT_IOVS_MAX];
+    /** The UDP_SEGMENT control messages of the queued datagrams. */
+    union
+    {
+        uint64_t            u64Align;
+        uint8_t             ab[CMSG_SPACE(sizeof(uint16_t))];
+    }                       aXmitCtl[DRVUDPTUNNEL_XMIT_MSGS_MAX];
+    /** The S/G buffers the queued datagrams refer to. */
+    PPDMSCATTERGATHER       apXmitSgBufs[DRVUDPTUNNEL_XMIT_MSGS_MAX];
+    /** Segment header buffers (DRVUDPTUNNEL_XMIT_HDRS_MAX times
+     * DRVUDPTUNNEL_XMIT_HDR_SIZE bytes). */
+    uint8_t                *pbXmitHdrs;
+    /** @} */
+
+    /** The recvmmsg buffer (DRVUDPTUNNEL_RECV_MSGS_MAX times
+     * DRVUDPTUNNEL_RECV_MSG_SIZE bytes). */
+    uint8_t                *pbRecvBuf;
+#endif
+
 #ifdef VBOX_WITH_STATISTICS
     /** Number of sent packets. */
     STAMCOUNTER             StatPktSent;
@@ -98,6 +184,14 @@ typedef struct DRVUDPTUNNEL
     STAMPROFILE             StatTransmit;
     /** Profiling packet receive runs. */
     STAMPROFILEADV          StatReceive;
+    /** Number of sendmmsg calls. */
+    STAMCOUNTER             StatXmitBatches;
+    /** Number of datagrams sent with UDP segmentation offload. */
+    STAMCOUNTER             StatXmitUdpGso;
+    /** Number of datagrams which could not be sent. */
+    STAMCOUNTER             StatXmitErrors;
+    /** Number of recvmmsg calls returning datagrams. */
+    STAMCOUNTER             StatRecvBatches;
 #endif /* VBOX_WITH_STATISTICS */
 
 #ifdef LOG_ENABLED
@@ -117,6 +211,166 @@ typedef struct DRVUDPTUNNEL
 *   Internal Functions                                                                                                           *
 *********************************************************************************************************************************/
 
+#ifdef RT_OS_LINUX
+
+/**
+ * Sends the queued datagrams and frees the S/G buffers they refer to.
+ *
+ * @param   pThis           The UDP tunnel driver instance.
+ */
+static void drvUDPTunnelXmitFlush(PDRVUDPTUNNEL pThis)
+{
+    Assert(RTCritSectIsOwner(&pThis->XmitLock));
+
+    uint32_t const cMsgs = pThis->cXmitMsgs;
+    if (cMsgs && pThis->hSocket != NIL_RTSOCKET)
+    {
+        int const fd   = (int)RTSocketToNative(pThis->hSocket);
+        uint32_t  iMsg = 0;
+        while (iMsg < cMsgs)
+        {
+            STAM_COUNTER_INC(&pThis->StatXmitBatches);
+            int const cSent = sendmmsg(fd, &pThis->aXmitMsgs[iMsg], cMsgs - iMsg, 0);
+            if (cSent > 0)
+                iMsg += (uint32_t)cSent;
+            else if (errno != EINTR)
+            {
+                /* The datagram at iMsg failed, drop it and carry on with the rest. */
+                LogFunc(("sendmmsg -> errno=%d (iMsg=%u of %u)\n", errno, iMsg, cMsgs));
+                STAM_COUNTER_INC(&pThis->StatXmitErrors);
+                iMsg++;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < pThis->cXmitSgBufs; i++)
+    {
+        PPDMSCATTERGATHER pSgBuf = pThis->apXmitSgBufs[i];
+        pSgBuf->fFlags = 0;
+        RTMemFree(pSgBuf);
+    }
+
+    pThis->cXmitMsgs   = 0;
+    pThis->cXmitIovs   = 0;
+    pThis->cXmitHdrs   = 0;
+    pThis->cXmitSgBufs = 0;
+}
+
+
+/**
+ * Makes sure the transmit batch has room for the given resources, flushing it
+ * if it hasn't.
+ *
+ * @param   pThis           The UDP tunnel driver instance.
+ * @param   cIovs           The number of I/O vectors needed.
+ * @param   cHdrs           The number of segment header buffers needed.
+ */
+DECLINLINE(void) drvUDPTunnelXmitReserve(PDRVUDPTUNNEL pThis, uint32_t cIovs, uint32_t cHdrs)
+{
+    if (   pThis->cXmitMsgs + 1     > DRVUDPTUNNEL_XMIT_MSGS_MAX
+        || pThis->cXmitIovs + cIovs > DRVUDPTUNNEL_XMIT_IOVS_MAX
+        || pThis->cXmitHdrs + cHdrs > DRVUDPTUNNEL_XMIT_HDRS_MAX)
+        drvUDPTunnelXmitFlush(pThis);
+}
+
+
+/**
+ * Queues a datagram made up of the I/O vectors from @a iIovFirst and up.
+ *
+ * @param   pThis           The UDP tunnel driver instance.
+ * @param   iIovFirst       The first I/O vector of the datagram.
+ * @param   cbGsoSeg        The UDP segment size if the kernel shall split
+ *                          the datagram (UDP_SEGMENT), 0 if not.
+ */
+static void drvUDPTunnelXmitQueueMsg(PDRVUDPTUNNEL pThis, uint32_t iIovFirst, uint32_t cbGsoSeg)
+{
+    uint32_t const  iMsg = pThis->cXmitMsgs++;
+    struct mmsghdr *pMsg = &pThis->aXmitMsgs[iMsg];
+    RT_ZERO(*pMsg);
+    pMsg->msg_hdr.msg_name    = &pThis->DestSockAddr;
+    pMsg->msg_hdr.msg_namelen = pThis->cbDestSockAddr;
+    pMsg->msg_hdr.msg_iov     = &pThis->aXmitIovs[iIovFirst];
+    pMsg->msg_hdr.msg_iovlen  = pThis->cXmitIovs - iIovFirst;
+    if (cbGsoSeg)
+    {
+        struct cmsghdr *pCmsg = (struct cmsghdr *)&pThis->aXmitCtl[iMsg].ab[0];
+        pCmsg->cmsg_level = SOL_UDP;
+        pCmsg->cmsg_type  = UDP_SEGMENT;
+        pCmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+        uint16_t const u16GsoSeg = (uint16_t)cbGsoSeg;
+        memcpy(CMSG_DATA(pCmsg), &u16GsoSeg, sizeof(u16GsoSeg));
+        pMsg->msg_hdr.msg_control    = pCmsg;
+        pMsg->msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+        STAM_COUNTER_INC(&pThis->StatXmitUdpGso);
+    }
+}
+
+
+/**
+ * Queues a frame for sending, taking ownership of the S/G buffer.
+ *
+ * GSO frames are carved into segments without copying the payload; with UDP
+ * segmentation offload the segments are sent as one big datagram which the
+ * kernel splits up again.
+ *
+ * @param   pThis           The UDP tunnel driver instance.
+ * @param   pSgBuf          The S/G buffer with the frame.
+ */
+static void drvUDPTunnelXmitQueue(PDRVUDPTUNNEL pThis, PPDMSCATTERGATHER pSgBuf)
+{
+    uint8_t        *pbFrame = (uint8_t *)pSgBuf->aSegs[0].pvSeg;
+    PCPDMNETWORKGSO pGso    = (PCPDMNETWORKGSO)pSgBuf->pvUser;
+    if (!pGso)
+    {
+        drvUDPTunnelXmitReserve(pThis, 1, 0);
+        uint32_t const iIov = pThis->cXmitIovs++;
+        pThis->aXmitIovs[iIov].iov_base = pbFrame;
+        pThis->aXmitIovs[iIov].iov_len  = pSgBuf->cbUsed;
+        drvUDPTunnelXmitQueueMsg(pThis, iIov, 0);
+    }
+    else
+    {
+        uint32_t const cSegs    = PDMNetGsoCalcSegmentCount(pGso, pSgBuf->cbUsed);  Assert(cSegs > 1);
+        uint32_t const cbGsoSeg = pGso->cbHdrsSeg + pGso->cbMaxSeg;
+
+        /* UDP GSO needs equally sized datagrams (bar the last one), which rules
+           out UFO frames where only the first segment carries the UDP header. */
+        uint32_t cSegsPerMsg = 1;
+        if (   pThis->fUdpGso
+            && pGso->cbHdrsSeg == pGso->cbHdrsTotal)
+            cSegsPerMsg = RT_MIN(DRVUDPTUNNEL_UDP_GSO_SEGS_MAX, DRVUDPTUNNEL_UDP_GSO_BYTES_MAX / cbGsoSeg);
+
+        uint32_t iSeg = 0;
+        while (iSeg < cSegs)
+        {
+            uint32_t const cMsgSegs = RT_MIN(cSegsPerMsg, cSegs - iSeg);
+            drvUDPTunnelXmitReserve(pThis, cMsgSegs * 2, cMsgSegs);
+
+            uint32_t const iIovFirst = pThis->cXmitIovs;
+            for (uint32_t i = 0; i < cMsgSegs; i++, iSeg++)
+            {
+                uint8_t *pbSegHdrs = &pThis->pbXmitHdrs[pThis->cXmitHdrs++ * DRVUDPTUNNEL_XMIT_HDR_SIZE];
+                uint32_t cbSegHdrs;
+                uint32_t cbSegPayload;
+                uint32_t const offSegPayload = PDMNetGsoCarveSegment(pGso, pbFrame, pSgBuf->cbUsed, iSeg, cSegs,
+                                                                     pbSegHdrs, &cbSegHdrs, &cbSegPayload);
+                struct iovec *paIovs = &pThis->aXmitIovs[pThis->cXmitIovs];
+                paIovs[0].iov_base = pbSegHdrs;
+                paIovs[0].iov_len  = cbSegHdrs;
+                paIovs[1].iov_base = &pbFrame[offSegPayload];
+                paIovs[1].iov_len  = cbSegPayload;
+                pThis->cXmitIovs += 2;
+            }
+            drvUDPTunnelXmitQueueMsg(pThis, iIovFirst, cMsgSegs > 1 ? cbGsoSeg : 0);
+        }
+    }
+
+    /* Queued after all the datagrams referring to it, so a flush above can't free it. */
+    pThis->apXmitSgBufs[pThis->cXmitSgBufs++] = pSgBuf;
+}
+
+#endif /* RT_OS_LINUX */
+
 /**
  * @interface_method_impl{PDMINETWORKUP,pfnBeginXmit}
  */
@@ -211,6 +465,19 @@ static DECLCALLBACK(int) drvUDPTunnelUp_SendBuf(PPDMINETWORKUP pInterface, PPDMS
     Assert((pSgBuf->fFlags & PDMSCATTERGATHER_FLAGS_MAGIC_MASK) == PDMSCATTERGATHER_FLAGS_MAGIC);
     Assert(RTCritSectIsOwner(&pThis->XmitLock));
 
+#ifdef RT_OS_LINUX
+    /*
+     * Queue it up for sendmmsg; the batch goes out when full or at the end of
+     * the transmit run.
+     */
+    if (pThis->hSocket != NIL_RTSOCKET)
+    {
+        drvUDPTunnelXmitQueue(pThis, pSgBuf);
+        STAM_PROFILE_STOP(&pThis->StatTransmit, a);
+        return VINF_SUCCESS;
+    }
+#endif
+
     int rc;
     if (!pSgBuf->pvUser)
     {
@@ -263,6 +530,9 @@ static DECLCALLBACK(int) drvUDPTunnelUp_SendBuf(PPDMINETWORKUP pInterface, PPDMS
 static DECLCALLBACK(void) drvUDPTunnelUp_EndXmit(PPDMINETWORKUP pInterface)
 {
     PDRVUDPTUNNEL pThis = PDMINETWORKUP_2_DRVUDPTUNNEL(pInterface);
+#ifdef RT_OS_LINUX
+    drvUDPTunnelXmitFlush(pThis);
+#endif
     RTCritSectLeave(&pThis->XmitLock);
 }
 
@@ -308,6 +578,199 @@ static DECLCALLBACK(void) drvUDPTunnelUp_NotifyLinkChanged(PPDMINETWORKUP pInter
 }
 
 
+#ifdef RT_OS_LINUX
+
+/**
+ * Passes received frames up to the device.
+ *
+ * @returns VBox status code, failure if the rest of the frames should be
+ *          dropped (VM state change).
+ * @param   pThis           The UDP tunnel driver instance.
+ * @param   paFrames        The frames.
+ * @param   cFrames         The number of frames.
+ */
+static int drvUDPTunnelRecvFrames(PDRVUDPTUNNEL pThis, PCPDMNETWORKRECVFRAME paFrames, uint32_t cFrames)
+{
+    uint32_t iFrame = 0;
+    while (iFrame < cFrames)
+    {
+        /*
+         * Wait for the device to have space.  As with single frames, non-zero
+         * cbMax is taken to mean there is room (see drvUDPTunnelReceive).
+         */
+        STAM_PROFILE_ADV_STOP(&pThis->StatReceive, a);
+        int rc = pThis->pIAboveNet->pfnWaitReceiveAvail(pThis->pIAboveNet, RT_INDEFINITE_WAIT);
+        STAM_PROFILE_ADV_START(&pThis->StatReceive, a);
+        if (RT_FAILURE(rc))
+            return rc;
+
+        if (   pThis->pIAboveNet->pfnReceiveBurst
+            && cFrames - iFrame > 1)
+        {
+            uint32_t cDone = 0;
+            rc = pThis->pIAboveNet->pfnReceiveBurst(pThis->pIAboveNet, &paFrames[iFrame], cFrames - iFrame, &cDone);
+            iFrame += cDone;
+            if (RT_FAILURE(rc) && rc != VERR_NET_NO_BUFFER_SPACE)
+                return rc;
+        }
+        else
+        {
+            rc = pThis->pIAboveNet->pfnReceive(pThis->pIAboveNet, paFrames[iFrame].pvFrame, paFrames[iFrame].cbFrame);
+            AssertRC(rc);
+            iFrame++;
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Reads whatever datagrams are queued on the socket with one recvmmsg call
+ * and passes them up in bursts.
+ *
+ * @returns VINF_SUCCESS or VERR_UDP_SERVER_STOP.
+ * @param   pThis           The UDP tunnel driver instance.
+ * @param   Sock            The socket to read from.
+ */
+static int drvUDPTunnelReceiveBatch(PDRVUDPTUNNEL pThis, RTSOCKET Sock)
+{
+    struct mmsghdr  aMsgs[DRVUDPTUNNEL_RECV_MSGS_MAX];
+    struct iovec    aIovs[DRVUDPTUNNEL_RECV_MSGS_MAX];
+    union
+    {
+        struct cmsghdr  Hdr;
+        uint8_t         ab[CMSG_SPACE(sizeof(int))];
+    }               aCtl[DRVUDPTUNNEL_RECV_MSGS_MAX];
+    RT_ZERO(aMsgs);
+    for (uint32_t i = 0; i < RT_ELEMENTS(aMsgs); i++)
+    {
+        aIovs[i].iov_base                = &pThis->pbRecvBuf[i * DRVUDPTUNNEL_RECV_MSG_SIZE];
+        aIovs[i].iov_len                 = DRVUDPTUNNEL_RECV_MSG_SIZE;
+        aMsgs[i].msg_hdr.msg_iov         = &aIovs[i];
+        aMsgs[i].msg_hdr.msg_iovlen      = 1;
+        aMsgs[i].msg_hdr.msg_control     = &aCtl[i];
+        aMsgs[i].msg_hdr.msg_controllen  = sizeof(aCtl[i]);
+    }
+
+    int const cMsgs = recvmmsg((int)RTSocketToNative(Sock), aMsgs, RT_ELEMENTS(aMsgs), MSG_DONTWAIT, NULL);
+    if (cMsgs <= 0)
+    {
+        int const iErr = cMsgs < 0 ? errno : 0;
+        LogFunc(("recvmmsg -> %d (errno=%d)\n", cMsgs, iErr));
+        if (iErr == EBADF || iErr == ENOTSOCK)
+            return VERR_UDP_SERVER_STOP;
+        return VINF_SUCCESS;
+    }
+    STAM_COUNTER_INC(&pThis->StatRecvBatches);
+    if (pThis->fLinkDown)
+        return VINF_SUCCESS;
+
+    /*
+     * Split the datagrams into frames.  With UDP_GRO the kernel may have glued
+     * several equally sized datagrams of the peer together.
+     */
+    PDMNETWORKRECVFRAME aFrames[DRVUDPTUNNEL_RECV_BURST_MAX];
+    uint32_t            cFrames = 0;
+    for (int iMsg = 0; iMsg < cMsgs; iMsg++)
+    {
+        struct msghdr *pMsgHdr = &aMsgs[iMsg].msg_hdr;
+        uint8_t const *pbMsg   = (uint8_t const *)aIovs[iMsg].iov_base;
+        size_t const   cbMsg   = aMsgs[iMsg].msg_len;
+        if (!cbMsg || (pMsgHdr->msg_flags & MSG_TRUNC))
+            continue;
+
+        size_t cbSeg = cbMsg;
+        for (struct cmsghdr *pCmsg = CMSG_FIRSTHDR(pMsgHdr); pCmsg; pCmsg = CMSG_NXTHDR(pMsgHdr, pCmsg))
+            if (   pCmsg->cmsg_level == SOL_UDP
+                && pCmsg->cmsg_type  == UDP_GRO
+                && pCmsg->cmsg_len   >= CMSG_LEN(sizeof(int)))
+            {
+                int cbGroSeg;
+                memcpy(&cbGroSeg, CMSG_DATA(pCmsg), sizeof(cbGroSeg));
+                if (cbGroSeg > 0)
+                    cbSeg = (size_t)cbGroSeg;
+            }
+
+        for (size_t off = 0; off < cbMsg; off += cbSeg)
+        {
+            if (cFrames >= RT_ELEMENTS(aFrames))
+            {
+                int rc = drvUDPTunnelRecvFrames(pThis, aFrames, cFrames);
+                cFrames = 0;
+                if (RT_FAILURE(rc))
+                    return VINF_SUCCESS;
+            }
+            aFrames[cFrames].pvFrame = &pbMsg[off];
+            aFrames[cFrames].cbFrame = RT_MIN(cbSeg, cbMsg - off);
+            aFrames[cFrames].pGso    = NULL;
+            STAM_COUNTER_INC(&pThis->StatPktRecv);
+            STAM_COUNTER_ADD(&pThis->StatPktRecvBytes, aFrames[cFrames].cbFrame);
+            Log2(("cbFrame=%#x\n" "%.*Rhxd\n", aFrames[cFrames].cbFrame, aFrames[cFrames].cbFrame, aFrames[cFrames].pvFrame));
+            cFrames++;
+        }
+    }
+    if (cFrames)
+        drvUDPTunnelRecvFrames(pThis, aFrames, cFrames);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Takes a reference to the server socket for sending batches and enables the
+ * UDP offloads the kernel supports on it.
+ *
+ * @param   pThis           The UDP tunnel driver instance.
+ */
+static void drvUDPTunnelAttachSocket(PDRVUDPTUNNEL pThis)
+{
+    if (!pThis->cbDestSockAddr || !pThis->pbXmitHdrs || !pThis->pServer)
+        return;
+
+    RTSOCKET hSocket;
+    int rc = RTUdpServerQuerySocket(pThis->pServer, &hSocket);
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("UDPTunnel#%d: Cannot batch datagrams: %Rrc\n", pThis->pDrvIns->iInstance, rc));
+        return;
+    }
+
+    /* Setting a zero segment size only tells us whether the kernel knows UDP_SEGMENT. */
+    int const fd     = (int)RTSocketToNative(hSocket);
+    int       iValue = 0;
+    bool const fUdpGso = setsockopt(fd, SOL_UDP, UDP_SEGMENT, &iValue, sizeof(iValue)) == 0;
+    iValue = 1;
+    bool const fUdpGro = setsockopt(fd, SOL_UDP, UDP_GRO, &iValue, sizeof(iValue)) == 0;
+    LogRel(("UDPTunnel#%d: Batching datagrams, UDP GSO %s, UDP GRO %s\n", pThis->pDrvIns->iInstance,
+            fUdpGso ? "on" : "off", fUdpGro ? "on" : "off"));
+
+    RTCritSectEnter(&pThis->XmitLock);
+    pThis->fUdpGso = fUdpGso;
+    pThis->hSocket = hSocket;
+    RTCritSectLeave(&pThis->XmitLock);
+}
+
+
+/**
+ * Drops the reference to the server socket taken by drvUDPTunnelAttachSocket.
+ *
+ * @param   pThis           The UDP tunnel driver instance.
+ */
+static void drvUDPTunnelDetachSocket(PDRVUDPTUNNEL pThis)
+{
+    if (pThis->hSocket == NIL_RTSOCKET)
+        return;
+
+    RTCritSectEnter(&pThis->XmitLock);
+    drvUDPTunnelXmitFlush(pThis);
+    RTSOCKET hSocket = pThis->hSocket;
+    pThis->hSocket = NIL_RTSOCKET;
+    RTCritSectLeave(&pThis->XmitLock);
+
+    RTSocketRelease(hSocket);
+}
+
+#endif /* RT_OS_LINUX */
+
 static DECLCALLBACK(int) drvUDPTunnelReceive(RTSOCKET Sock, void *pvUser)
 {
     PDRVUDPTUNNEL pThis = PDMINS_2_DATA((PPDMDRVINS)pvUser, PDRVUDPTUNNEL);
@@ -315,6 +778,15 @@ static DECLCALLBACK(int) drvUDPTunnelReceive(RTSOCKET Sock, void *pvUser)
 
     STAM_PROFILE_ADV_START(&pThis->StatReceive, a);
 
+#ifdef RT_OS_LINUX
+    if (pThis->pbRecvBuf)
+    {
+        int rc = drvUDPTunnelReceiveBatch(pThis, Sock);
+        STAM_PROFILE_ADV_STOP(&pThis->StatReceive, a);
+        return rc;
+    }
+#endif
+
     /*
      * Read the frame.
      */
@@ -427,12 +899,23 @@ static DECLCALLBACK(void) drvUDPTunnelDestruct(PPDMDRVINS pDrvIns)
         pThis->pszDestIP = NULL;
     }
 
+#ifdef RT_OS_LINUX
+    drvUDPTunnelDetachSocket(pThis);
+#endif
+
     if (pThis->pServer)
     {
         RTUdpServerDestroy(pThis->pServer);
         pThis->pServer = NULL;
     }
 
+#ifdef RT_OS_LINUX
+    RTMemFree(pThis->pbXmitHdrs);
+    pThis->pbXmitHdrs = NULL;
+    RTMemFree(pThis->pbRecvBuf);
+    pThis->pbRecvBuf = NULL;
+#endif
+
     /*
      * Kill the xmit lock.
      */
@@ -449,6 +932,10 @@ static DECLCALLBACK(void) drvUDPTunnelDestruct(PPDMDRVINS pDrvIns)
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatPktRecvBytes);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatTransmit);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReceive);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatXmitBatches);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatXmitUdpGso);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatXmitErrors);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatRecvBatches);
 #endif /* VBOX_WITH_STATISTICS */
 }
 
@@ -471,6 +958,9 @@ static DECLCALLBACK(int) drvUDPTunnelConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCf
     pThis->pDrvIns                      = pDrvIns;
     pThis->pszDestIP                    = NULL;
     pThis->pszInstance                  = NULL;
+#ifdef RT_OS_LINUX
+    pThis->hSocket                      = NIL_RTSOCKET;
+#endif
 
     /* IBase */
     pDrvIns->IBase.pfnQueryInterface    = drvUDPTunnelQueryInterface;
@@ -493,6 +983,10 @@ static DECLCALLBACK(int) drvUDPTunnelConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCf
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatPktRecvBytes,  STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,             "Number of received bytes.",        "/Drivers/UDPTunnel%d/Bytes/Received", pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatTransmit,      STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL,    "Profiling packet transmit runs.",  "/Drivers/UDPTunnel%d/Transmit", pDrvIns->iInstance);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatReceive,       STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL,    "Profiling packet receive runs.",   "/Drivers/UDPTunnel%d/Receive", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatXmitBatches,   STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_CALLS,             "Number of sendmmsg calls.",        "/Drivers/UDPTunnel%d/XmitBatches", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatXmitUdpGso,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,        "Number of UDP GSO datagrams sent.", "/Drivers/UDPTunnel%d/XmitUdpGso", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatXmitErrors,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,        "Number of datagrams not sent.",    "/Drivers/UDPTunnel%d/XmitErrors", pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatRecvBatches,   STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_CALLS,             "Number of recvmmsg calls.",        "/Drivers/UDPTunnel%d/RecvBatches", pDrvIns->iInstance);
 #endif /* VBOX_WITH_STATISTICS */
 
     /*
@@ -558,6 +1052,34 @@ static DECLCALLBACK(int) drvUDPTunnelConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCf
     rc = RTSocketParseInetAddress(pThis->pszDestIP, pThis->uDestPort, &pThis->DestAddress);
     AssertRCReturn(rc, rc);
 
+#ifdef RT_OS_LINUX
+    /*
+     * Prepare for sending and receiving in batches (sendmmsg/recvmmsg), which
+     * needs the destination in native form and some buffers.
+     */
+    RT_ZERO(pThis->DestSockAddr);
+    if (pThis->DestAddress.enmType == RTNETADDRTYPE_IPV4)
+    {
+        struct sockaddr_in *pSockAddr = (struct sockaddr_in *)&pThis->DestSockAddr;
+        pSockAddr->sin_family      = AF_INET;
+        pSockAddr->sin_port        = RT_H2N_U16(pThis->DestAddress.uPort);
+        pSockAddr->sin_addr.s_addr = pThis->DestAddress.uAddr.IPv4.u;
+        pThis->cbDestSockAddr      = sizeof(*pSockAddr);
+    }
+    else if (pThis->DestAddress.enmType == RTNETADDRTYPE_IPV6)
+    {
+        struct sockaddr_in6 *pSockAddr = (struct sockaddr_in6 *)&pThis->DestSockAddr;
+        pSockAddr->sin6_family     = AF_INET6;
+        pSockAddr->sin6_port       = RT_H2N_U16(pThis->DestAddress.uPort);
+        memcpy(&pSockAddr->sin6_addr, &pThis->DestAddress.uAddr.IPv6, sizeof(pSockAddr->sin6_addr));
+        pThis->cbDestSockAddr      = sizeof(*pSockAddr);
+    }
+    pThis->pbXmitHdrs = (uint8_t *)RTMemAlloc(DRVUDPTUNNEL_XMIT_HDRS_MAX * DRVUDPTUNNEL_XMIT_HDR_SIZE);
+    pThis->pbRecvBuf  = (uint8_t *)RTMemAlloc(DRVUDPTUNNEL_RECV_MSGS_MAX * DRVUDPTUNNEL_RECV_MSG_SIZE);
+    if (!pThis->pbXmitHdrs || !pThis->pbRecvBuf)
+        return VERR_NO_MEMORY;
+#endif
+
     /*
      * Create unique thread name for the UDP receiver.
      */
@@ -579,6 +1101,9 @@ static DECLCALLBACK(int) drvUDPTunnelConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCf
     rc = RTCritSectInit(&pThis->XmitLock);
     AssertRCReturn(rc, rc);
 
+#ifdef RT_OS_LINUX
+    drvUDPTunnelAttachSocket(pThis);
+#endif
     return rc;
 }
 
@@ -593,6 +1118,9 @@ static DECLCALLBACK(void) drvUDPTunnelSuspend(PPDMDRVINS pDrvIns)
     LogFlowFunc(("\n"));
     PDRVUDPTUNNEL pThis = PDMINS_2_DATA(pDrvIns, PDRVUDPTUNNEL);
 
+#ifdef RT_OS_LINUX
+    drvUDPTunnelDetachSocket(pThis);
+#endif
     if (pThis->pServer)
     {
         RTUdpServerDestroy(pThis->pServer);
@@ -616,7 +1144,10 @@ static DECLCALLBACK(void) drvUDPTunnelResume(PPDMDRVINS pDrvIns)
     if (RT_FAILURE(rc))
         PDMDrvHlpVMSetError(pThis->pDrvIns, VERR_PDM_HIF_OPEN_FAILED, RT_SRC_POS,
                             N_("UDPTunnel: Failed to start the UDP tunnel server"));
-
+#ifdef RT_OS_LINUX
+    else
+        drvUDPTunnelAttachSocket(pThis);
+#endif
 }
 
 
@@ -33,6 +33,7 @@
 
 #include <iprt/file.h>
 #include <iprt/stream.h>
+#include <iprt/string.h>
 #include <iprt/time.h>
 #include <iprt/errcore.h>
 #include <VBox/vmm/pdmnetinline.h>
@@ -265,3 +266,90 @@ int PcapFileGsoFrame(RTFILE File, uint64_t StartNanoTS, PCPDMNETWORKGSO pGso,
     return VINF_SUCCESS;
 }
 
+
+/**
+ * Formats the pcapng section header and interface description blocks.
+ *
+ * The interface uses Ethernet framing and nanosecond timestamps.
+ *
+ * @param   pvBuf           Where to format the blocks, PCAPNG_HDR_SIZE bytes.
+ * @param   cbSnapLen       The max number of bytes captured per frame, 0 for
+ *                          no limit.
+ */
+void PcapNgHdr(void *pvBuf, uint32_t cbSnapLen)
+{
+    uint32_t *pu32 = (uint32_t *)pvBuf;
+
+    /* Section header block. */
+    pu32[0]  = UINT32_C(0x0a0d0d0a);        /* block type */
+    pu32[1]  = 28;                          /* block total length */
+    pu32[2]  = UINT32_C(0x1a2b3c4d);        /* byte order magic */
+    pu32[3]  = RT_MAKE_U32(1, 0);           /* major version 1, minor version 0 */
+    pu32[4]  = UINT32_MAX;                  /* section length (unknown, 64-bit) */
+    pu32[5]  = UINT32_MAX;
+    pu32[6]  = 28;
+
+    /* Interface description block. */
+    pu32[7]  = UINT32_C(0x00000001);        /* block type */
+    pu32[8]  = 32;                          /* block total length */
+    pu32[9]  = RT_MAKE_U32(1 /* Ethernet */, 0);
+    pu32[10] = cbSnapLen;
+    pu32[11] = RT_MAKE_U32(9 /* if_tsresol */, 1);
+    pu32[12] = 9;                           /* 10^-9 seconds, padded */
+    pu32[13] = 0;                           /* opt_endofopt */
+    pu32[14] = 32;
+    AssertCompile(PCAPNG_HDR_SIZE == 15 * sizeof(uint32_t));
+}
+
+
+/**
+ * Formats the header of a pcapng enhanced packet block.
+ *
+ * The caller adds the frame data and the trailer (zero padding to a 32-bit
+ * boundary and the block total length).
+ *
+ * @returns The block total length, see PCAPNG_EPB_SIZE.
+ * @param   pvBuf           Where to format the header, PCAPNG_EPB_HDR_SIZE
+ *                          bytes.
+ * @param   u64TimestampNs  The timestamp, nanoseconds since the epoch.
+ * @param   cbFrame         The size of the frame.
+ * @param   cbCaptured      The number of frame bytes in the block.
+ */
+uint32_t PcapNgFrameHdr(void *pvBuf, uint64_t u64TimestampNs, size_t cbFrame, size_t cbCaptured)
+{
+    uint32_t const cbBlock = PCAPNG_EPB_SIZE(cbCaptured);
+    uint32_t      *pu32    = (uint32_t *)pvBuf;
+    pu32[0] = PCAPNG_BLOCK_TYPE_EPB;
+    pu32[1] = cbBlock;
+    pu32[2] = 0;                            /* interface ID */
+    pu32[3] = RT_HI_U32(u64TimestampNs);
+    pu32[4] = RT_LO_U32(u64TimestampNs);
+    pu32[5] = (uint32_t)cbCaptured;
+    pu32[6] = (uint32_t)cbFrame;
+    AssertCompile(PCAPNG_EPB_HDR_SIZE == 7 * sizeof(uint32_t));
+    return cbBlock;
+}
+
+
+/**
+ * Formats a pcapng interface statistics block.
+ *
+ * @param   pvBuf           Where to format the block, PCAPNG_STATS_SIZE bytes.
+ * @param   u64TimestampNs  The timestamp, nanoseconds since the epoch.
+ * @param   cDropped        The number of frames the capture dropped
+ *                          (isb_osdrop).
+ */
+void PcapNgStats(void *pvBuf, uint64_t u64TimestampNs, uint64_t cDropped)
+{
+    uint32_t *pu32 = (uint32_t *)pvBuf;
+    pu32[0] = UINT32_C(0x00000005);         /* block type */
+    pu32[1] = PCAPNG_STATS_SIZE;
+    pu32[2] = 0;                            /* interface ID */
+    pu32[3] = RT_HI_U32(u64TimestampNs);
+    pu32[4] = RT_LO_U32(u64TimestampNs);
+    pu32[5] = RT_MAKE_U32(7 /* isb_osdrop */, 8);
+    memcpy(&pu32[6], &cDropped, sizeof(cDropped));
+    pu32[8] = 0;                            /* opt_endofopt */
+    pu32[9] = PCAPNG_STATS_SIZE;
+    AssertCompile(PCAPNG_STATS_SIZE == 10 * sizeof(uint32_t));
+}
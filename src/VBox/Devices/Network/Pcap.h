@@ -46,6 +46,25 @@ int PcapFileFrame(RTFILE File, uint64_t StartNanoTS, const void *pvFrame, size_t
 int PcapFileGsoFrame(RTFILE File, uint64_t StartNanoTS, PCPDMNETWORKGSO pGso,
                      const void *pvFrame, size_t cbFrame, size_t cbSegMax);
 
+/** The pcapng enhanced packet block type. */
+#define PCAPNG_BLOCK_TYPE_EPB       UINT32_C(0x00000006)
+/** The size of the pcapng enhanced packet block header (the frame data
+ *  follows it). */
+#define PCAPNG_EPB_HDR_SIZE         28
+/** The size of the pcapng section and interface header written by
+ *  PcapNgHdr. */
+#define PCAPNG_HDR_SIZE             60
+/** The size of the pcapng interface statistics block written by
+ *  PcapNgStats. */
+#define PCAPNG_STATS_SIZE           40
+/** Calculates the size of the pcapng enhanced packet block holding
+ *  @a a_cbCaptured bytes of frame data. */
+#define PCAPNG_EPB_SIZE(a_cbCaptured) ((uint32_t)(PCAPNG_EPB_HDR_SIZE + RT_ALIGN_32((uint32_t)(a_cbCaptured), 4) + 4))
+
+void PcapNgHdr(void *pvBuf, uint32_t cbSnapLen);
+uint32_t PcapNgFrameHdr(void *pvBuf, uint64_t u64TimestampNs, size_t cbFrame, size_t cbCaptured);
+void PcapNgStats(void *pvBuf, uint64_t u64TimestampNs, uint64_t cDropped);
+
 RT_C_DECLS_END
 
 #endif /* !VBOX_INCLUDED_SRC_Network_Pcap_h */
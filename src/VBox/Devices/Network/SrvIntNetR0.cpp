@@ -72,6 +72,15 @@
 # define INTNET_GROW_DSTTAB_SIZE    1
 #endif
 
+/** The number of buckets in the MAC address table hash (power of two). */
+#define INTNET_MACTAB_HASH_SIZE     64
+/** End of a MAC address table hash chain. */
+#define INTNET_MACTAB_HASH_NIL      UINT32_MAX
+
+/** The max number of destination interfaces a sender batches receive
+ * notifications for before flushing them. */
+#define INTNET_MAX_DEFERRED_WAKEUPS 8
+
 /** The wakeup bit in the INTNETIF::cBusy and INTNETRUNKIF::cBusy counters. */
 #define INTNET_BUSY_WAKEUP_MASK     RT_BIT_32(30)
 
@@ -95,6 +104,9 @@ typedef struct INTNETMACTABENTRY
      * to this interface onto the trunk.  The reasoning for this is that this could
      * be the interface of a VM that just has been teleported to a different host. */
     bool                    fActive;
+    /** Index of the next entry in the same hash bucket, INTNET_MACTAB_HASH_NIL
+     * if last.  See INTNETMACTAB::aidxHashHeads. */
+    uint32_t                idxHashNext;
     /** Pointer to the network interface. */
     struct INTNETIF        *pIf;
 } INTNETMACTABENTRY;
@@ -121,6 +133,14 @@ typedef struct INTNETMACTAB
     /** The number of interface entries currently in promicuous mode that
      * shall not see unrelated trunk traffic. */
     uint32_t                cPromiscuousNoTrunkEntries;
+    /** The number of interface entries with a dummy (unknown) MAC address.
+     * Such entries match any destination, so unicast switching must scan the
+     * whole table while this is non-zero. */
+    uint32_t                cDummyMacEntries;
+    /** MAC address hash buckets, each holding the index of the first entry in
+     * the chain or INTNET_MACTAB_HASH_NIL.  Rebuilt by intnetR0MacTabRehash
+     * whenever an entry is added, removed or changes its address. */
+    uint32_t                aidxHashHeads[INTNET_MACTAB_HASH_SIZE];
 
     /** The host MAC address (reported). */
     RTMAC                   HostMac;
@@ -287,6 +307,13 @@ typedef struct INTNETIF
     PINTNETDSTTAB volatile  pDstTab;
     /** Pointer to the trunk's per interface data.  Can be NULL. */
     void                   *pvIfData;
+    /** The number of entries in apDeferredWakeups. */
+    uint32_t                cDeferredWakeups;
+    /** Destination interfaces which frames have been delivered to by the current
+     * IntNetR0IfSend call and whose consumers haven't been notified yet.  Each
+     * entry holds a busy reference.  Only accessed by the sending thread, which
+     * is serialized by the pDstTab exchange. */
+    struct INTNETIF        *apDeferredWakeups[INTNET_MAX_DEFERRED_WAKEUPS];
     /** Header buffer for when we're carving GSO frames. */
     uint8_t                 abGsoHdrs[256];
 } INTNETIF;
@@ -1663,6 +1690,54 @@ DECL_FORCE_INLINE(bool) intnetR0IsMacAddrDummy(PCRTMAC pMacAddr)
 }
 
 
+/**
+ * Calculates the MAC address table hash bucket for the given address.
+ *
+ * @returns Bucket index.
+ * @param   pMacAddr        The MAC address.
+ */
+DECL_FORCE_INLINE(uint32_t) intnetR0MacTabHash(PCRTMAC pMacAddr)
+{
+    uint32_t const uHash = pMacAddr->au16[0] ^ pMacAddr->au16[1] ^ pMacAddr->au16[2];
+    return (uHash ^ (uHash >> 8)) & (INTNET_MACTAB_HASH_SIZE - 1);
+}
+
+
+/**
+ * Rebuilds the MAC address hash and the dummy address count of the table.
+ *
+ * This must be called after adding, removing or changing the address of an
+ * entry, since entry indexes shift on removal.  The caller holds the MAC
+ * address table spinlock.
+ *
+ * @param   pTab            The MAC address table.
+ */
+static void intnetR0MacTabRehash(PINTNETMACTAB pTab)
+{
+    for (uint32_t iBucket = 0; iBucket < RT_ELEMENTS(pTab->aidxHashHeads); iBucket++)
+        pTab->aidxHashHeads[iBucket] = INTNET_MACTAB_HASH_NIL;
+
+    uint32_t cDummies = 0;
+    uint32_t iEntry   = pTab->cEntries;
+    while (iEntry-- > 0)
+    {
+        PINTNETMACTABENTRY pEntry = &pTab->paEntries[iEntry];
+        if (intnetR0IsMacAddrDummy(&pEntry->MacAddr))
+        {
+            pEntry->idxHashNext = INTNET_MACTAB_HASH_NIL;
+            cDummies++;
+        }
+        else
+        {
+            uint32_t const iBucket = intnetR0MacTabHash(&pEntry->MacAddr);
+            pEntry->idxHashNext = pTab->aidxHashHeads[iBucket];
+            pTab->aidxHashHeads[iBucket] = iEntry;
+        }
+    }
+    pTab->cDummyMacEntries = cDummies;
+}
+
+
 /**
  * Compares two MAC addresses.
  *
@@ -1870,21 +1945,28 @@ static INTNETSWDECISION intnetR0NetworkSwitchUnicast(PINTNETNETWORK pNetwork, ui
     pDstTab->pTrunk     = 0;
     pDstTab->cIfs       = 0;
 
-    /* Find exactly matching or promiscuous interfaces. */
+    /*
+     * Find exactly matching or promiscuous interfaces.
+     *
+     * Without promiscuous or unknown-address interfaces only exact matches can
+     * be destinations, so the hash chain suffices.  Otherwise scan it all.
+     */
     uint32_t cExactHits = 0;
-    uint32_t iIfMac     = pTab->cEntries;
-    while (iIfMac-- > 0)
+    uint32_t iIfMac;
+    if (   !pTab->cPromiscuousEntries
+        && !pTab->cDummyMacEntries)
     {
-        if (pTab->paEntries[iIfMac].fActive)
+        if (pIfSender)
+            STAM_REL_COUNTER_INC(&pIfSender->pIntBuf->cStatSwitchHashed);
+
+        iIfMac = pTab->aidxHashHeads[intnetR0MacTabHash(pDstAddr)];
+        while (iIfMac != INTNET_MACTAB_HASH_NIL)
         {
-            bool fExact = intnetR0AreMacAddrsEqual(&pTab->paEntries[iIfMac].MacAddr, pDstAddr);
-            if (   fExact
-                || intnetR0IsMacAddrDummy(&pTab->paEntries[iIfMac].MacAddr)
-                || (   pTab->paEntries[iIfMac].fPromiscuousSeeTrunk
-                    || (!fSrc && pTab->paEntries[iIfMac].fPromiscuousEff) )
-               )
+            Assert(iIfMac < pTab->cEntries);
+            if (   pTab->paEntries[iIfMac].fActive
+                && intnetR0AreMacAddrsEqual(&pTab->paEntries[iIfMac].MacAddr, pDstAddr))
             {
-                cExactHits += fExact;
+                cExactHits++;
 
                 PINTNETIF pIf = pTab->paEntries[iIfMac].pIf;        AssertPtr(pIf); Assert(pIf->pNetwork == pNetwork);
                 if (RT_LIKELY(pIf != pIfSender)) /* paranoia */
@@ -1895,6 +1977,38 @@ static INTNETSWDECISION intnetR0NetworkSwitchUnicast(PINTNETNETWORK pNetwork, ui
                     intnetR0BusyIncIf(pIf);
                 }
             }
+            iIfMac = pTab->paEntries[iIfMac].idxHashNext;
+        }
+    }
+    else
+    {
+        if (pIfSender)
+            STAM_REL_COUNTER_INC(&pIfSender->pIntBuf->cStatSwitchScanned);
+
+        iIfMac = pTab->cEntries;
+        while (iIfMac-- > 0)
+        {
+            if (pTab->paEntries[iIfMac].fActive)
+            {
+                bool fExact = intnetR0AreMacAddrsEqual(&pTab->paEntries[iIfMac].MacAddr, pDstAddr);
+                if (   fExact
+                    || intnetR0IsMacAddrDummy(&pTab->paEntries[iIfMac].MacAddr)
+                    || (   pTab->paEntries[iIfMac].fPromiscuousSeeTrunk
+                        || (!fSrc && pTab->paEntries[iIfMac].fPromiscuousEff) )
+                   )
+                {
+                    cExactHits += fExact;
+
+                    PINTNETIF pIf = pTab->paEntries[iIfMac].pIf;        AssertPtr(pIf); Assert(pIf->pNetwork == pNetwork);
+                    if (RT_LIKELY(pIf != pIfSender)) /* paranoia */
+                    {
+                        uint32_t iIfDst = pDstTab->cIfs++;
+                        pDstTab->aIfs[iIfDst].pIf            = pIf;
+                        pDstTab->aIfs[iIfDst].fReplaceDstMac = false;
+                        intnetR0BusyIncIf(pIf);
+                    }
+                }
+            }
         }
     }
 
@@ -2852,6 +2966,48 @@ DECL_FORCE_INLINE(void) intnetR0IfNotifyRecv(PINTNETIF pIf)
 }
 
 
+/**
+ * Notifies the consumers of all the interfaces @a pIfSender has deferred
+ * receive notifications for and drops the busy references.
+ *
+ * @param   pIfSender       The sending interface.
+ */
+static void intnetR0IfFlushDeferredWakeups(PINTNETIF pIfSender)
+{
+    uint32_t i = pIfSender->cDeferredWakeups;
+    while (i-- > 0)
+    {
+        PINTNETIF pIf = pIfSender->apDeferredWakeups[i];
+        pIfSender->apDeferredWakeups[i] = NULL;
+        intnetR0IfNotifyRecv(pIf);
+        intnetR0BusyDecIf(pIf);
+    }
+    pIfSender->cDeferredWakeups = 0;
+}
+
+
+/**
+ * Defers the receive notification of @a pIf until @a pIfSender is done with
+ * its send ring, so a burst of frames costs one wakeup per destination.
+ *
+ * @param   pIf             The interface that received a frame.
+ * @param   pIfSender       The sending interface.
+ */
+static void intnetR0IfDeferNotifyRecv(PINTNETIF pIf, PINTNETIF pIfSender)
+{
+    uint32_t i = pIfSender->cDeferredWakeups;
+    while (i-- > 0)
+        if (pIfSender->apDeferredWakeups[i] == pIf)
+            return;
+
+    if (pIfSender->cDeferredWakeups >= RT_ELEMENTS(pIfSender->apDeferredWakeups))
+        intnetR0IfFlushDeferredWakeups(pIfSender);
+
+    intnetR0BusyIncIf(pIf);
+    pIfSender->apDeferredWakeups[pIfSender->cDeferredWakeups++] = pIf;
+}
+
+
 /**
  * Sends a frame to a specific interface.
  *
@@ -2871,7 +3027,10 @@ static void intnetR0IfSend(PINTNETIF pIf, PINTNETIF pIfSender, PINTNETSG pSG, PC
     if (RT_SUCCESS(rc))
     {
         pIf->cYields = 0;
-        intnetR0IfNotifyRecv(pIf);
+        if (pIfSender)
+            intnetR0IfDeferNotifyRecv(pIf, pIfSender);
+        else
+            intnetR0IfNotifyRecv(pIf);
         return;
     }
 
@@ -4007,7 +4166,10 @@ static INTNETSWDECISION intnetR0NetworkSend(PINTNETNETWORK pNetwork, PINTNETIF p
 
         PINTNETMACTABENTRY pIfEntry = intnetR0NetworkFindMacAddrEntry(pNetwork, pIfSender);
         if (pIfEntry)
+        {
             pIfEntry->MacAddr = EthHdr.SrcMac;
+            intnetR0MacTabRehash(&pNetwork->MacTab);
+        }
         pIfSender->MacAddr    = EthHdr.SrcMac;
 
         RTSpinlockRelease(pNetwork->hAddrSpinlock);
@@ -4163,6 +4325,11 @@ INTNETR0DECL(int) IntNetR0IfSend(INTNETIFHANDLE hIf, PSUPDRVSESSION pSession)
                 IntNetRingSkipFrame(&pIf->pIntBuf->Send);
             }
 
+            /*
+             * Wake up the receivers of the frames we've delivered.
+             */
+            intnetR0IfFlushDeferredWakeups(pIf);
+
             /*
              * Put back the destination table.
              */
@@ -4462,7 +4629,10 @@ INTNETR0DECL(int) IntNetR0IfSetMacAddress(INTNETIFHANDLE hIf, PSUPDRVSESSION pSe
             /* Update the two copies. */
             PINTNETMACTABENTRY pEntry = intnetR0NetworkFindMacAddrEntry(pNetwork, pIf); Assert(pEntry);
             if (RT_LIKELY(pEntry))
+            {
                 pEntry->MacAddr = *pMac;
+                intnetR0MacTabRehash(&pNetwork->MacTab);
+            }
             pIf->MacAddr        = *pMac;
             pIf->fMacSet        = true;
 
@@ -5001,6 +5171,7 @@ static DECLCALLBACK(void) intnetR0IfDestruct(void *pvObj, void *pvUser1, void *p
                             &pNetwork->MacTab.paEntries[iIf + 1],
                             (pNetwork->MacTab.cEntries - iIf - 1) * sizeof(pNetwork->MacTab.paEntries[0]));
                 pNetwork->MacTab.cEntries--;
+                intnetR0MacTabRehash(&pNetwork->MacTab);
                 break;
             }
 
@@ -5202,6 +5373,7 @@ static int intnetR0NetworkCreateIf(PINTNETNETWORK pNetwork, PSUPDRVSESSION pSess
     pIf->cBusy              = 0;
     //pIf->pDstTab          = NULL;
     //pIf->pvIfData         = NULL;
+    //pIf->cDeferredWakeups = 0;
 
     for (int i = kIntNetAddrType_Invalid + 1; i < kIntNetAddrType_End && RT_SUCCESS(rc); i++)
         rc = intnetR0IfAddrCacheInit(&pIf->aAddrCache[i], (INTNETADDRTYPE)i,
@@ -5258,6 +5430,7 @@ static int intnetR0NetworkCreateIf(PINTNETNETWORK pNetwork, PSUPDRVSESSION pSess
                     pNetwork->MacTab.paEntries[iIf].pIf                  = pIf;
 
                     pNetwork->MacTab.cEntries = iIf + 1;
+                    intnetR0MacTabRehash(&pNetwork->MacTab);
                     pIf->pNetwork = pNetwork;
 
                     /*
@@ -6548,6 +6721,9 @@ static int intnetR0CreateNetwork(PINTNET pIntNet, PSUPDRVSESSION pSession, const
     pNetwork->MacTab.cEntriesAllocated      = INTNET_GROW_DSTTAB_SIZE;
     //pNetwork->MacTab.cPromiscuousEntries  = 0;
     //pNetwork->MacTab.cPromiscuousNoTrunkEntries = 0;
+    //pNetwork->MacTab.cDummyMacEntries     = 0;
+    for (uint32_t iBucket = 0; iBucket < RT_ELEMENTS(pNetwork->MacTab.aidxHashHeads); iBucket++)
+        pNetwork->MacTab.aidxHashHeads[iBucket] = INTNET_MACTAB_HASH_NIL;
     pNetwork->MacTab.paEntries              = NULL;
     pNetwork->MacTab.fHostPromiscuousReal   = false;
     pNetwork->MacTab.fHostPromiscuousEff    = false;
@@ -126,6 +126,8 @@ PROFILE_COUNTER(ALIAS_output, "ALIAS::output");
 DRV_COUNTING_COUNTER(NATRecvWakeups, "counting wakeups of NAT RX thread");
 DRV_PROFILE_COUNTER(NATRecv,"Time spent in NATRecv worker");
 DRV_PROFILE_COUNTER(NATRecvWait,"Time spent in NATRecv worker in waiting of free RX buffers");
+DRV_COUNTING_COUNTER(NATRecvBursts, "counting frame bursts passed up to the device");
+DRV_COUNTING_COUNTER(NATRecvFrameAllocs, "counting received frames not served from the frame pool");
 DRV_COUNTING_COUNTER(QueuePktSent, "counting packet sent via PDM Queue");
 DRV_COUNTING_COUNTER(QueuePktDropped, "counting packet drops by PDM Queue");
 DRV_COUNTING_COUNTER(ConsumerFalse, "counting consumer's reject number to process the queue's item");
@@ -0,0 +1,727 @@
+/* $Id$ */
+/** @file
+ * VBox - Internal networking switch throughput and latency benchmark.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#include "IntNetIf.h"
+
+#include <VBox/intnetinline.h>
+#include <VBox/err.h>
+#include <iprt/asm.h>
+#include <iprt/getopt.h>
+#include <iprt/initterm.h>
+#include <iprt/mem.h>
+#include <iprt/message.h>
+#include <iprt/net.h>
+#include <iprt/process.h>
+#include <iprt/sort.h>
+#include <iprt/stream.h>
+#include <iprt/string.h>
+#include <iprt/thread.h>
+#include <iprt/time.h>
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Maximum number of interfaces. */
+#define TST_MAX_IFS             32
+/** Maximum number of frame sizes and patterns given on the command line. */
+#define TST_MAX_RUNS            16
+/** Number of latency samples kept per interface (the most recent ones). */
+#define TST_LATENCY_SAMPLES     _256K
+/** The ether type used for the benchmark frames (IEEE local experimental). */
+#define TST_ETHERTYPE           UINT16_C(0x88b5)
+/** Smallest frame size (without FCS). */
+#define TST_MIN_FRAME           60
+/** Largest frame size. */
+#define TST_MAX_FRAME           _16K
+/** Send ring buffer size. */
+#define TST_CB_SEND             _512K
+/** Receive ring buffer size. */
+#define TST_CB_RECV             _1M
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * Traffic patterns.
+ */
+typedef enum TSTPATTERN
+{
+    /** Interface i sends to interface i + 1. */
+    kTstPattern_Unicast = 0,
+    /** Every interface sends to everyone else. */
+    kTstPattern_Broadcast,
+    /** Every interface sends to a MAC only reachable thru the trunk. */
+    kTstPattern_Trunk
+} TSTPATTERN;
+
+/**
+ * The payload following the ethernet header.
+ */
+typedef struct TSTPAYLOAD
+{
+    /** RTTimeNanoTS() when the frame was queued. */
+    uint64_t        tsSent;
+    /** The sending interface. */
+    uint32_t        iIfSrc;
+    /** Sequence number. */
+    uint32_t        uSeq;
+} TSTPAYLOAD;
+
+/**
+ * Per interface state.
+ */
+typedef struct TSTIF
+{
+    /** The interface handle. */
+    INTNETIFCTX         hIf;
+    /** The ring buffers. */
+    PINTNETBUF          pBuf;
+    /** Our MAC address. */
+    RTMAC               Mac;
+    /** The interface index. */
+    uint32_t            iIf;
+    /** The sender thread. */
+    RTTHREAD            hThreadSend;
+    /** The receiver thread. */
+    RTTHREAD            hThreadRecv;
+
+    /** @name Sender statistics.
+     * @{ */
+    uint64_t            cFramesSent;
+    uint64_t            cbSent;
+    uint64_t            cSendRingFull;
+    /** @} */
+
+    /** @name Receiver statistics.
+     * @{ */
+    uint64_t            cFramesRecv;
+    uint64_t            cbRecv;
+    uint64_t            cNsLatencyTotal;
+    uint64_t            cNsLatencyMin;
+    uint64_t            cNsLatencyMax;
+    /** Number of latency samples taken, paLatencies wraps around. */
+    uint64_t            cLatencies;
+    /** The latency samples in nanoseconds (TST_LATENCY_SAMPLES). */
+    uint32_t           *pacNsLatencies;
+    /** @} */
+} TSTIF;
+/** Pointer to the per interface state. */
+typedef TSTIF *PTSTIF;
+
+
+/*********************************************************************************************************************************
+*   Global Variables                                                                                                             *
+*********************************************************************************************************************************/
+/** The interfaces. */
+static TSTIF                g_aIfs[TST_MAX_IFS];
+/** Number of interfaces. */
+static uint32_t             g_cIfs          = 2;
+/** The pattern of the current run. */
+static TSTPATTERN           g_enmPattern    = kTstPattern_Unicast;
+/** The frame size of the current run. */
+static uint32_t             g_cbFrame       = 1514;
+/** Number of frames to queue before kicking the switch. */
+static uint32_t             g_cBatch        = 8;
+/** Set when the senders should start. */
+static bool volatile        g_fGo           = false;
+/** Set when the senders should stop. */
+static bool volatile        g_fStopSend     = false;
+/** Set when the receivers should stop. */
+static bool volatile        g_fStopRecv     = false;
+/** The destination MAC of the trunk pattern, owned by nobody on the network. */
+static RTMAC const          g_TrunkMac      = { { 0x02, 0x42, 0x42, 0x42, 0x42, 0xfe } };
+/** Number of JSON records written. */
+static uint32_t             g_cJsonRecords  = 0;
+
+
+/**
+ * Returns the MAC address of the destination for a frame sent by @a pIf.
+ */
+static void tstIntNetBenchGetDst(PTSTIF pIf, PRTMAC pDst)
+{
+    switch (g_enmPattern)
+    {
+        case kTstPattern_Unicast:
+            *pDst = g_aIfs[(pIf->iIf + 1) % g_cIfs].Mac;
+            break;
+        case kTstPattern_Broadcast:
+            memset(pDst, 0xff, sizeof(*pDst));
+            break;
+        case kTstPattern_Trunk:
+            *pDst = g_TrunkMac;
+            break;
+    }
+}
+
+
+/**
+ * Queues a benchmark frame on the send ring of @a pIf.
+ *
+ * @returns VBox status code, VERR_BUFFER_OVERFLOW if the ring is full.
+ */
+static int tstIntNetBenchQueueFrame(PTSTIF pIf, PCRTMAC pDst, uint32_t cbFrame, uint32_t uSeq)
+{
+    PINTNETHDR pHdr;
+    void      *pvFrame;
+    int rc = IntNetRingAllocateFrame(&pIf->pBuf->Send, cbFrame, &pHdr, &pvFrame);
+    if (RT_SUCCESS(rc))
+    {
+        PRTNETETHERHDR pEthHdr = (PRTNETETHERHDR)pvFrame;
+        pEthHdr->DstMac    = *pDst;
+        pEthHdr->SrcMac    = pIf->Mac;
+        pEthHdr->EtherType = RT_H2BE_U16(TST_ETHERTYPE);
+
+        TSTPAYLOAD Payload;
+        Payload.iIfSrc = pIf->iIf;
+        Payload.uSeq   = uSeq;
+        Payload.tsSent = RTTimeNanoTS();
+        memcpy(pEthHdr + 1, &Payload, sizeof(Payload));
+
+        IntNetRingCommitFrame(&pIf->pBuf->Send, pHdr);
+    }
+    return rc;
+}
+
+
+/**
+ * @callback_method_impl{FNRTTHREAD, Sends frames until told to stop.}
+ */
+static DECLCALLBACK(int) tstIntNetBenchSendThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    RT_NOREF(hThreadSelf);
+    PTSTIF   pIf  = (PTSTIF)pvUser;
+    RTMAC    Dst;
+    uint32_t uSeq = 0;
+    tstIntNetBenchGetDst(pIf, &Dst);
+
+    while (!ASMAtomicReadBool(&g_fGo))
+        RTThreadYield();
+
+    while (!ASMAtomicReadBool(&g_fStopSend))
+    {
+        uint32_t cQueued = 0;
+        while (cQueued < g_cBatch)
+        {
+            int rc = tstIntNetBenchQueueFrame(pIf, &Dst, g_cbFrame, uSeq);
+            if (RT_FAILURE(rc))
+            {
+                pIf->cSendRingFull++;
+                break;
+            }
+            uSeq++;
+            cQueued++;
+        }
+        pIf->cFramesSent += cQueued;
+        pIf->cbSent      += (uint64_t)cQueued * g_cbFrame;
+
+        int rc = IntNetR3IfSend(pIf->hIf);
+        if (RT_FAILURE(rc))
+        {
+            RTMsgError("IntNetR3IfSend failed on interface #%u: %Rrc", pIf->iIf, rc);
+            return rc;
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Drains the receive ring of @a pIf, accounting benchmark frames.
+ */
+static void tstIntNetBenchDrain(PTSTIF pIf, bool fAccount)
+{
+    PINTNETHDR pHdr;
+    while ((pHdr = IntNetRingGetNextFrameToRead(&pIf->pBuf->Recv)) != NULL)
+    {
+        if (   fAccount
+            && pHdr->u8Type == INTNETHDR_TYPE_FRAME
+            && pHdr->cbFrame >= sizeof(RTNETETHERHDR) + sizeof(TSTPAYLOAD))
+        {
+            uint64_t const        tsNow   = RTTimeNanoTS();
+            PCRTNETETHERHDR const pEthHdr = (PCRTNETETHERHDR)IntNetHdrGetFramePtr(pHdr, pIf->pBuf);
+            if (pEthHdr->EtherType == RT_H2BE_U16(TST_ETHERTYPE))
+            {
+                TSTPAYLOAD Payload;
+                memcpy(&Payload, pEthHdr + 1, sizeof(Payload));
+                uint64_t const cNsLatency = tsNow - Payload.tsSent;
+
+                pIf->cFramesRecv++;
+                pIf->cbRecv          += pHdr->cbFrame;
+                pIf->cNsLatencyTotal += cNsLatency;
+                pIf->cNsLatencyMin    = RT_MIN(pIf->cNsLatencyMin, cNsLatency);
+                pIf->cNsLatencyMax    = RT_MAX(pIf->cNsLatencyMax, cNsLatency);
+                pIf->pacNsLatencies[pIf->cLatencies++ % TST_LATENCY_SAMPLES] = (uint32_t)RT_MIN(cNsLatency, UINT32_MAX);
+            }
+        }
+        IntNetRingSkipFrame(&pIf->pBuf->Recv);
+    }
+}
+
+
+/**
+ * @callback_method_impl{FNRTTHREAD, Receives frames until told to stop.}
+ */
+static DECLCALLBACK(int) tstIntNetBenchRecvThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    RT_NOREF(hThreadSelf);
+    PTSTIF pIf = (PTSTIF)pvUser;
+
+    while (!ASMAtomicReadBool(&g_fStopRecv))
+    {
+        int rc = IntNetR3IfWait(pIf->hIf, 100 /*ms*/);
+        if (RT_FAILURE(rc) && rc != VERR_TIMEOUT && rc != VERR_INTERRUPTED)
+        {
+            RTMsgError("IntNetR3IfWait failed on interface #%u: %Rrc", pIf->iIf, rc);
+            return rc;
+        }
+        tstIntNetBenchDrain(pIf, true /*fAccount*/);
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @callback_method_impl{FNRTSORTCMP}
+ */
+static DECLCALLBACK(int) tstIntNetBenchLatencyCmp(void const *pvElement1, void const *pvElement2, void *pvUser)
+{
+    RT_NOREF(pvUser);
+    uint32_t const u1 = *(uint32_t const *)pvElement1;
+    uint32_t const u2 = *(uint32_t const *)pvElement2;
+    return u1 < u2 ? -1 : u1 > u2 ? 1 : 0;
+}
+
+
+/**
+ * Formats a value given in thousandths as a JSON number.
+ */
+static const char *tstIntNetBenchFmtMilli(char *pszBuf, size_t cbBuf, uint64_t uMilli)
+{
+    RTStrPrintf(pszBuf, cbBuf, "%RU64.%03RU64", uMilli / 1000, uMilli % 1000);
+    return pszBuf;
+}
+
+
+/**
+ * Runs one pattern / frame size combination and writes a JSON record for it.
+ *
+ * @returns VBox status code.
+ * @param   pStrm           The JSON output stream.
+ * @param   cSeconds        The duration of the run.
+ */
+static int tstIntNetBenchRun(PRTSTREAM pStrm, uint32_t cSeconds)
+{
+    static const char * const s_apszPatterns[] = { "unicast", "broadcast", "trunk" };
+
+    /*
+     * Reset the statistics and get rid of anything left over from the previous run.
+     */
+    for (uint32_t i = 0; i < g_cIfs; i++)
+    {
+        PTSTIF pIf = &g_aIfs[i];
+        tstIntNetBenchDrain(pIf, false /*fAccount*/);
+        pIf->cFramesSent     = 0;
+        pIf->cbSent          = 0;
+        pIf->cSendRingFull   = 0;
+        pIf->cFramesRecv     = 0;
+        pIf->cbRecv          = 0;
+        pIf->cNsLatencyTotal = 0;
+        pIf->cNsLatencyMin   = UINT64_MAX;
+        pIf->cNsLatencyMax   = 0;
+        pIf->cLatencies      = 0;
+    }
+    ASMAtomicWriteBool(&g_fGo, false);
+    ASMAtomicWriteBool(&g_fStopSend, false);
+    ASMAtomicWriteBool(&g_fStopRecv, false);
+
+    /*
+     * Start the threads, let them run for the given time and collect them again.
+     */
+    int rc = VINF_SUCCESS;
+    uint32_t cThreads = 0;
+    for (; cThreads < g_cIfs && RT_SUCCESS(rc); cThreads++)
+    {
+        PTSTIF pIf = &g_aIfs[cThreads];
+        pIf->hThreadSend = NIL_RTTHREAD;
+        pIf->hThreadRecv = NIL_RTTHREAD;
+        rc = RTThreadCreateF(&pIf->hThreadRecv, tstIntNetBenchRecvThread, pIf, 0, RTTHREADTYPE_IO,
+                             RTTHREADFLAGS_WAITABLE, "Recv%u", cThreads);
+        if (RT_SUCCESS(rc))
+            rc = RTThreadCreateF(&pIf->hThreadSend, tstIntNetBenchSendThread, pIf, 0, RTTHREADTYPE_IO,
+                                 RTTHREADFLAGS_WAITABLE, "Send%u", cThreads);
+    }
+
+    uint64_t const tsStart = RTTimeNanoTS();
+    ASMAtomicWriteBool(&g_fGo, true);
+    if (RT_SUCCESS(rc))
+        RTThreadSleep(cSeconds * RT_MS_1SEC);
+    ASMAtomicWriteBool(&g_fStopSend, true);
+    uint64_t const cNsElapsed = RTTimeNanoTS() - tsStart;
+
+    for (uint32_t i = 0; i < cThreads; i++)
+        if (g_aIfs[i].hThreadSend != NIL_RTTHREAD)
+        {
+            int rcThread = VINF_SUCCESS;
+            RTThreadWait(g_aIfs[i].hThreadSend, RT_INDEFINITE_WAIT, &rcThread);
+            if (RT_FAILURE(rcThread) && RT_SUCCESS(rc))
+                rc = rcThread;
+        }
+
+    /* Give the receivers a moment to pick up the frames still in flight. */
+    RTThreadSleep(200);
+    ASMAtomicWriteBool(&g_fStopRecv, true);
+    for (uint32_t i = 0; i < cThreads; i++)
+        if (g_aIfs[i].hThreadRecv != NIL_RTTHREAD)
+        {
+            int rcThread = VINF_SUCCESS;
+            RTThreadWait(g_aIfs[i].hThreadRecv, RT_INDEFINITE_WAIT, &rcThread);
+            if (RT_FAILURE(rcThread) && RT_SUCCESS(rc))
+                rc = rcThread;
+        }
+    if (RT_FAILURE(rc))
+        return rc;
+
+    /*
+     * Sum up.  The trunk pattern has no receivers on our side, so rate it by what was sent.
+     */
+    uint64_t cFramesSent = 0, cbSent = 0, cSendRingFull = 0;
+    uint64_t cFramesRecv = 0, cbRecv = 0, cNsLatencyTotal = 0;
+    uint64_t cNsLatencyMin = UINT64_MAX, cNsLatencyMax = 0;
+    size_t   cSamples = 0;
+    for (uint32_t i = 0; i < g_cIfs; i++)
+    {
+        PTSTIF pIf = &g_aIfs[i];
+        cFramesSent     += pIf->cFramesSent;
+        cbSent          += pIf->cbSent;
+        cSendRingFull   += pIf->cSendRingFull;
+        cFramesRecv     += pIf->cFramesRecv;
+        cbRecv          += pIf->cbRecv;
+        cNsLatencyTotal += pIf->cNsLatencyTotal;
+        cNsLatencyMin    = RT_MIN(cNsLatencyMin, pIf->cNsLatencyMin);
+        cNsLatencyMax    = RT_MAX(cNsLatencyMax, pIf->cNsLatencyMax);
+        cSamples        += (size_t)RT_MIN(pIf->cLatencies, TST_LATENCY_SAMPLES);
+    }
+    bool const     fRecvSide = g_enmPattern != kTstPattern_Trunk;
+    uint64_t const cFrames   = fRecvSide ? cFramesRecv : cFramesSent;
+    uint64_t const cbFrames  = fRecvSide ? cbRecv      : cbSent;
+    uint64_t const uMilliMpps = cNsElapsed ? cFrames * 1000 * 1000 / cNsElapsed : 0;  /* frames/ns * 1e3 = Mpps * 1e3 */
+    uint64_t const uMilliGbps = cNsElapsed ? cbFrames * 8 * 1000 / cNsElapsed : 0;    /* bits/ns = Gbit/s */
+
+    /* Merge the latency samples of all interfaces for the percentiles. */
+    uint32_t cNsP50 = 0, cNsP99 = 0, cNsP999 = 0;
+    if (cSamples)
+    {
+        uint32_t *pacNs = (uint32_t *)RTMemAlloc(cSamples * sizeof(uint32_t));
+        if (pacNs)
+        {
+            size_t off = 0;
+            for (uint32_t i = 0; i < g_cIfs; i++)
+            {
+                size_t const cThis = (size_t)RT_MIN(g_aIfs[i].cLatencies, TST_LATENCY_SAMPLES);
+                memcpy(&pacNs[off], g_aIfs[i].pacNsLatencies, cThis * sizeof(uint32_t));
+                off += cThis;
+            }
+            RTSortShell(pacNs, cSamples, sizeof(uint32_t), tstIntNetBenchLatencyCmp, NULL);
+            cNsP50  = pacNs[(cSamples - 1) * 500 / 1000];
+            cNsP99  = pacNs[(cSamples - 1) * 990 / 1000];
+            cNsP999 = pacNs[(cSamples - 1) * 999 / 1000];
+            RTMemFree(pacNs);
+        }
+    }
+
+    char szMpps[32], szGbps[32];
+    RTStrmPrintf(pStrm,
+                 "%s  {\"pattern\": \"%s\", \"interfaces\": %u, \"frameSize\": %u, \"batch\": %u, "
+                 "\"elapsedNs\": %RU64, \"framesSent\": %RU64, \"framesReceived\": %RU64, \"sendRingFull\": %RU64, "
+                 "\"mpps\": %s, \"gbps\": %s",
+                 g_cJsonRecords++ ? ",\n" : "", s_apszPatterns[g_enmPattern], g_cIfs, g_cbFrame, g_cBatch,
+                 cNsElapsed, cFramesSent, cFramesRecv, cSendRingFull,
+                 tstIntNetBenchFmtMilli(szMpps, sizeof(szMpps), uMilliMpps),
+                 tstIntNetBenchFmtMilli(szGbps, sizeof(szGbps), uMilliGbps));
+    if (cFramesRecv)
+        RTStrmPrintf(pStrm,
+                     ", \"latencyNs\": {\"avg\": %RU64, \"min\": %RU64, \"p50\": %u, \"p99\": %u, \"p999\": %u, \"max\": %RU64}}",
+                     cNsLatencyTotal / cFramesRecv, cNsLatencyMin, cNsP50, cNsP99, cNsP999, cNsLatencyMax);
+    else
+        RTStrmPrintf(pStrm, ", \"latencyNs\": null}");
+    RTStrmFlush(pStrm);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Opens the interfaces and makes the switch learn their MAC addresses.
+ *
+ * @returns VBox status code.
+ * @param   pszNetwork      The network name.
+ * @param   enmTrunkType    The trunk type.
+ * @param   pszTrunk        The trunk name.
+ */
+static int tstIntNetBenchOpen(const char *pszNetwork, INTNETTRUNKTYPE enmTrunkType, const char *pszTrunk)
+{
+    int rc = VINF_SUCCESS;
+    for (uint32_t i = 0; i < g_cIfs && RT_SUCCESS(rc); i++)
+    {
+        PTSTIF pIf = &g_aIfs[i];
+        pIf->iIf = i;
+        /* Locally administered unicast: 02:00:00:42:xx:xx */
+        pIf->Mac.au8[0] = 0x02;
+        pIf->Mac.au8[1] = 0x00;
+        pIf->Mac.au8[2] = 0x00;
+        pIf->Mac.au8[3] = 0x42;
+        pIf->Mac.au8[4] = (uint8_t)(i >> 8);
+        pIf->Mac.au8[5] = (uint8_t)i;
+        pIf->pacNsLatencies = (uint32_t *)RTMemAllocZ(TST_LATENCY_SAMPLES * sizeof(uint32_t));
+        if (!pIf->pacNsLatencies)
+            return VERR_NO_MEMORY;
+
+        rc = IntNetR3IfCreateEx(&pIf->hIf, pszNetwork, enmTrunkType, pszTrunk, TST_CB_SEND, TST_CB_RECV, 0 /*fFlags*/);
+        if (RT_SUCCESS(rc))
+            rc = IntNetR3IfQueryBufferPtr(pIf->hIf, &pIf->pBuf);
+        if (RT_SUCCESS(rc))
+            rc = IntNetR3IfSetActive(pIf->hIf, true);
+        if (RT_FAILURE(rc))
+            RTMsgError("Failed to open interface #%u on '%s': %Rrc", i, pszNetwork, rc);
+    }
+
+    /* Announce every MAC address with a broadcast, the switch learns them from the source address. */
+    for (uint32_t i = 0; i < g_cIfs && RT_SUCCESS(rc); i++)
+    {
+        RTMAC Bcast;
+        memset(&Bcast, 0xff, sizeof(Bcast));
+        rc = tstIntNetBenchQueueFrame(&g_aIfs[i], &Bcast, TST_MIN_FRAME, 0);
+        if (RT_SUCCESS(rc))
+            rc = IntNetR3IfSend(g_aIfs[i].hIf);
+    }
+    return rc;
+}
+
+
+/**
+ * Closes all interfaces.
+ */
+static void tstIntNetBenchClose(void)
+{
+    for (uint32_t i = 0; i < g_cIfs; i++)
+    {
+        PTSTIF pIf = &g_aIfs[i];
+        if (pIf->hIf)
+        {
+            IntNetR3IfSetActive(pIf->hIf, false);
+            IntNetR3IfDestroy(pIf->hIf);
+            pIf->hIf = NULL;
+        }
+        RTMemFree(pIf->pacNsLatencies);
+        pIf->pacNsLatencies = NULL;
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    int rc = RTR3InitExe(argc, &argv, 0);
+    if (RT_FAILURE(rc))
+        return RTMsgInitFailure(rc);
+
+    /*
+     * Parse the arguments.
+     */
+    static const RTGETOPTDEF s_aOptions[] =
+    {
+        { "--interfaces",   'n', RTGETOPT_REQ_UINT32 },
+        { "--frame-size",   's', RTGETOPT_REQ_UINT32 },
+        { "--pattern",      'p', RTGETOPT_REQ_STRING },
+        { "--seconds",      't', RTGETOPT_REQ_UINT32 },
+        { "--batch",        'b', RTGETOPT_REQ_UINT32 },
+        { "--network",      'N', RTGETOPT_REQ_STRING },
+        { "--trunk",        'T', RTGETOPT_REQ_STRING },
+        { "--trunk-type",   'y', RTGETOPT_REQ_STRING },
+        { "--json",         'j', RTGETOPT_REQ_STRING },
+    };
+
+    uint32_t        acbFrames[TST_MAX_RUNS];
+    uint32_t        cFrameSizes = 0;
+    TSTPATTERN      aenmPatterns[TST_MAX_RUNS];
+    uint32_t        cPatterns   = 0;
+    uint32_t        cSeconds    = 3;
+    char            szNetwork[INTNET_MAX_NETWORK_NAME];
+    const char     *pszTrunk     = "";
+    INTNETTRUNKTYPE enmTrunkType = kIntNetTrunkType_WhateverNone;
+    const char     *pszJson      = NULL;
+    RTStrPrintf(szNetwork, sizeof(szNetwork), "tstIntNetBench-%u", RTProcSelf());
+
+    RTGETOPTUNION   ValueUnion;
+    RTGETOPTSTATE   GetState;
+    RTGetOptInit(&GetState, argc, argv, s_aOptions, RT_ELEMENTS(s_aOptions), 1, 0 /* fFlags */);
+    while ((rc = RTGetOpt(&GetState, &ValueUnion)))
+    {
+        switch (rc)
+        {
+            case 'n':
+                if (ValueUnion.u32 < 2 || ValueUnion.u32 > TST_MAX_IFS)
+                    return RTMsgErrorExit(RTEXITCODE_SYNTAX, "--interfaces must be between 2 and %u", TST_MAX_IFS);
+                g_cIfs = ValueUnion.u32;
+                break;
+
+            case 's':
+                if (ValueUnion.u32 < TST_MIN_FRAME || ValueUnion.u32 > TST_MAX_FRAME)
+                    return RTMsgErrorExit(RTEXITCODE_SYNTAX, "--frame-size must be between %u and %u", TST_MIN_FRAME, TST_MAX_FRAME);
+                if (cFrameSizes >= TST_MAX_RUNS)
+                    return RTMsgErrorExit(RTEXITCODE_SYNTAX, "Too many frame sizes");
+                acbFrames[cFrameSizes++] = ValueUnion.u32;
+                break;
+
+            case 'p':
+                if (cPatterns >= TST_MAX_RUNS)
+                    return RTMsgErrorExit(RTEXITCODE_SYNTAX, "Too many patterns");
+                if (!strcmp(ValueUnion.psz, "unicast"))
+                    aenmPatterns[cPatterns++] = kTstPattern_Unicast;
+                else if (!strcmp(ValueUnion.psz, "broadcast"))
+                    aenmPatterns[cPatterns++] = kTstPattern_Broadcast;
+                else if (!strcmp(ValueUnion.psz, "trunk"))
+                    aenmPatterns[cPatterns++] = kTstPattern_Trunk;
+                else
+                    return RTMsgErrorExit(RTEXITCODE_SYNTAX, "Unknown pattern '%s'", ValueUnion.psz);
+                break;
+
+            case 't':
+                cSeconds = RT_MAX(ValueUnion.u32, 1);
+                break;
+
+            case 'b':
+                g_cBatch = RT_MAX(ValueUnion.u32, 1);
+                break;
+
+            case 'N':
+                rc = RTStrCopy(szNetwork, sizeof(szNetwork), ValueUnion.psz);
+                if (RT_FAILURE(rc))
+                    return RTMsgErrorExit(RTEXITCODE_SYNTAX, "Network name too long");
+                break;
+
+            case 'T':
+                pszTrunk = ValueUnion.psz;
+                break;
+
+            case 'y':
+                if (!strcmp(ValueUnion.psz, "netflt"))
+                    enmTrunkType = kIntNetTrunkType_NetFlt;
+                else if (!strcmp(ValueUnion.psz, "netadp"))
+                    enmTrunkType = kIntNetTrunkType_NetAdp;
+                else
+                    return RTMsgErrorExit(RTEXITCODE_SYNTAX, "Unknown trunk type '%s'", ValueUnion.psz);
+                break;
+
+            case 'j':
+                pszJson = ValueUnion.psz;
+                break;
+
+            case 'h':
+                RTPrintf("Usage: %s [options]\n"
+                         "\n"
+                         "Pumps frames between interfaces on a private internal network and reports\n"
+                         "the switching throughput and latency as JSON.\n"
+                         "\n"
+                         "Options:\n"
+                         "  -n, --interfaces <2-%u>   Number of interfaces (default: 2).\n"
+                         "  -s, --frame-size <bytes>  Frame size, repeatable (default: 64 and 1514).\n"
+                         "  -p, --pattern <pattern>   unicast, broadcast or trunk, repeatable\n"
+                         "                            (default: unicast and broadcast).\n"
+                         "  -t, --seconds <secs>      Duration of each run (default: 3).\n"
+                         "  -b, --batch <frames>      Frames queued per send request (default: 8).\n"
+                         "  -N, --network <name>      Network name (default: tstIntNetBench-<pid>).\n"
+                         "  -T, --trunk <name>        Trunk interface, required by the trunk pattern.\n"
+                         "                            WARNING: frames go out on that interface!\n"
+                         "  -y, --trunk-type <type>   netflt or netadp.\n"
+                         "  -j, --json <file>         Write the results to a file instead of stdout.\n"
+                         "\n"
+                         "The latency is measured from queuing a frame to its receiver seeing it and\n"
+                         "thus includes the batching delay.\n",
+                         RTProcShortName(), TST_MAX_IFS);
+                return RTEXITCODE_SUCCESS;
+
+            case 'V':
+                RTPrintf("$Revision$\n");
+                return RTEXITCODE_SUCCESS;
+
+            default:
+                return RTGetOptPrintError(rc, &ValueUnion);
+        }
+    }
+
+    if (!cFrameSizes)
+    {
+        acbFrames[cFrameSizes++] = 64;
+        acbFrames[cFrameSizes++] = 1514;
+    }
+    if (!cPatterns)
+    {
+        aenmPatterns[cPatterns++] = kTstPattern_Unicast;
+        aenmPatterns[cPatterns++] = kTstPattern_Broadcast;
+    }
+    for (uint32_t i = 0; i < cPatterns; i++)
+        if (aenmPatterns[i] == kTstPattern_Trunk && (!*pszTrunk || enmTrunkType == kIntNetTrunkType_WhateverNone))
+            return RTMsgErrorExit(RTEXITCODE_SYNTAX, "The trunk pattern requires --trunk and --trunk-type");
+
+    PRTSTREAM pStrm = g_pStdOut;
+    if (pszJson)
+    {
+        rc = RTStrmOpen(pszJson, "w", &pStrm);
+        if (RT_FAILURE(rc))
+            return RTMsgErrorExit(RTEXITCODE_FAILURE, "Failed to open '%s': %Rrc", pszJson, rc);
+    }
+
+    /*
+     * Do the runs.
+     */
+    RTEXITCODE rcExit = RTEXITCODE_SUCCESS;
+    rc = tstIntNetBenchOpen(szNetwork, enmTrunkType, pszTrunk);
+    if (RT_SUCCESS(rc))
+    {
+        RTStrmPrintf(pStrm, "[\n");
+        for (uint32_t iPattern = 0; iPattern < cPatterns && RT_SUCCESS(rc); iPattern++)
+            for (uint32_t iSize = 0; iSize < cFrameSizes && RT_SUCCESS(rc); iSize++)
+            {
+                g_enmPattern = aenmPatterns[iPattern];
+                g_cbFrame    = acbFrames[iSize];
+                rc = tstIntNetBenchRun(pStrm, cSeconds);
+            }
+        RTStrmPrintf(pStrm, "\n]\n");
+    }
+    if (RT_FAILURE(rc))
+        rcExit = RTMsgErrorExit(RTEXITCODE_FAILURE, "Benchmark failed: %Rrc", rc);
+
+    tstIntNetBenchClose();
+    if (pStrm != g_pStdOut)
+        RTStrmClose(pStrm);
+    return rcExit;
+}
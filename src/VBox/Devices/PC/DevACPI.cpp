@@ -109,6 +109,8 @@ enum
 
 /* Maximum supported number of custom ACPI tables */
 #define MAX_CUST_TABLES 4
+/** Maximum number of virtual NUMA nodes we describe in SRAT/SLIT. */
+#define ACPI_MAX_NUMA_NODES 16
 
 /* Undef this to enable 24 bit PM timer (mostly for debugging purposes) */
 #define PM_TMR_32BIT
@@ -406,8 +408,11 @@ typedef struct ACPISTATE
     bool                fUseIommuAmd;
     /** If the IOMMU (Intel) device should be enabled */
     bool                fUseIommuIntel;
+    /** Number of virtual NUMA nodes to describe in the SRAT and SLIT tables,
+     *  0 if no NUMA topology should be presented to the guest. */
+    uint8_t             cNumaNodes;
     /** Padding. */
-    bool                afPadding0[3];
+    bool                afPadding0[2];
     /** Primary NIC PCI address. */
     uint32_t            u32NicPciAddress;
     /** HD Audio PCI address. */
@@ -936,6 +941,58 @@ typedef struct ACPITBLMCFGENTRY
 } ACPITBLMCFGENTRY;
 AssertCompileSize(ACPITBLMCFGENTRY, 16);
 
+/** System Resource Affinity Table (SRAT) header. */
+typedef struct ACPITBLSRAT
+{
+    ACPITBLHEADER aHeader;
+    uint32_t      u32Reserved1;                 /**< Must be 1 for backwards compatibility. */
+    uint64_t      u64Reserved2;
+} ACPITBLSRAT;
+AssertCompileSize(ACPITBLSRAT, 48);
+
+/** SRAT Processor Local APIC Affinity Structure. */
+typedef struct ACPITBLSRATLAPIC
+{
+    uint8_t       u8Type;                       /**< 0 */
+    uint8_t       u8Length;                     /**< 16 */
+    uint8_t       u8ProximityDomainLo;          /**< Bits [7:0] of the proximity domain. */
+    uint8_t       u8ApicId;                     /**< Must match the MADT. */
+    uint32_t      u32Flags;                     /**< Bit 0: enabled. */
+    uint8_t       u8LocalSapicEid;
+    uint8_t       au8ProximityDomainHi[3];      /**< Bits [31:8] of the proximity domain. */
+    uint32_t      u32ClockDomain;
+} ACPITBLSRATLAPIC;
+AssertCompileSize(ACPITBLSRATLAPIC, 16);
+
+/** SRAT Memory Affinity Structure. */
+typedef struct ACPITBLSRATMEM
+{
+    uint8_t       u8Type;                       /**< 1 */
+    uint8_t       u8Length;                     /**< 40 */
+    uint32_t      u32ProximityDomain;
+    uint16_t      u16Reserved1;
+    uint64_t      u64BaseAddress;
+    uint64_t      u64Length;
+    uint32_t      u32Reserved2;
+    uint32_t      u32Flags;                     /**< Bit 0: enabled, bit 1: hot pluggable, bit 2: non-volatile. */
+    uint64_t      u64Reserved3;
+} ACPITBLSRATMEM;
+AssertCompileSize(ACPITBLSRATMEM, 40);
+
+#define SRAT_AFFINITY_ENABLED   0x1             /**< SRAT entry is enabled. */
+
+/** System Locality Information Table (SLIT), followed by the
+ *  cLocalities * cLocalities distance matrix. */
+typedef struct ACPITBLSLIT
+{
+    ACPITBLHEADER aHeader;
+    uint64_t      u64Localities;
+} ACPITBLSLIT;
+AssertCompileSize(ACPITBLSLIT, 44);
+
+#define SLIT_DISTANCE_LOCAL     10              /**< Relative distance to the local node. */
+#define SLIT_DISTANCE_REMOTE    20              /**< Relative distance to a remote node. */
+
 #define PCAT_COMPAT   0x1                       /**< system has also a dual-8259 setup */
 
 /** Custom Description Table */
@@ -3668,6 +3725,130 @@ static void acpiR3SetupMcfg(PPDMDEVINS pDevIns, PACPISTATE pThis, RTGCPHYS32 GCP
     acpiR3PhysCopy(pDevIns, GCPhysDst, (const uint8_t *)&tbl, sizeof(tbl));
 }
 
+/**
+ * Calculates the size of the SRAT for the current configuration.
+ *
+ * Each node gets an equal share of guest RAM, where the share of one node may
+ * straddle the PCI hole below 4GB and thus need two memory affinity entries.
+ *
+ * @returns Size in bytes.
+ * @param   pThis       The ACPI shared instance data.
+ */
+static size_t acpiR3SratSize(PACPISTATE pThis)
+{
+    return sizeof(ACPITBLSRAT)
+         + pThis->cCpus * sizeof(ACPITBLSRATLAPIC)
+         + (pThis->cNumaNodes + 1) * sizeof(ACPITBLSRATMEM);
+}
+
+
+/**
+ * Used by acpiR3PlantTables to plant the System Resource Affinity Table (SRAT)
+ * describing the virtual NUMA topology.
+ *
+ * The vCPUs are distributed over the nodes in contiguous blocks and RAM is
+ * split evenly, so node N gets the Nth share of the guest's memory.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The ACPI shared instance data.
+ * @param   GCPhysDst   Where to plant it.
+ */
+static void acpiR3SetupSrat(PPDMDEVINS pDevIns, PACPISTATE pThis, RTGCPHYS32 GCPhysDst)
+{
+    size_t const   cbMax   = acpiR3SratSize(pThis);
+    uint8_t       *pbTable = (uint8_t *)RTMemAllocZ(cbMax);
+    AssertReturnVoid(pbTable);
+
+    ACPITBLSRAT *pSrat = (ACPITBLSRAT *)pbTable;
+    pSrat->u32Reserved1 = RT_H2LE_U32(1);
+    size_t off = sizeof(*pSrat);
+
+    uint32_t const cNodes = pThis->cNumaNodes;
+    for (uint16_t i = 0; i < pThis->cCpus; i++)
+    {
+        ACPITBLSRATLAPIC *pLApic = (ACPITBLSRATLAPIC *)&pbTable[off];
+        pLApic->u8Type              = 0;
+        pLApic->u8Length            = sizeof(*pLApic);
+        pLApic->u8ProximityDomainLo = (uint8_t)((uint32_t)i * cNodes / pThis->cCpus);
+        pLApic->u8ApicId            = (uint8_t)i; /* Must match acpiR3SetupMadt. */
+        pLApic->u32Flags            = RT_H2LE_U32(SRAT_AFFINITY_ENABLED);
+        off += sizeof(*pLApic);
+    }
+
+    /* Split RAM into equal 2MB aligned shares and map them onto the guest
+       physical layout, i.e. below 4GB first and the rest from 4GB and up. */
+    uint64_t const cbBelow4GB = pThis->cbRamLow;
+    uint64_t const cbTotal    = cbBelow4GB + PDMDevHlpMMPhysGetRamSizeAbove4GB(pDevIns);
+    uint64_t       offRam     = 0;
+    for (uint32_t iNode = 0; iNode < cNodes; iNode++)
+    {
+        uint64_t const offEnd = iNode + 1 < cNodes ? RT_MIN(RT_ALIGN_64(cbTotal / cNodes * (iNode + 1), _2M), cbTotal) : cbTotal;
+        while (offRam < offEnd)
+        {
+            uint64_t GCPhysFirst, cb;
+            if (offRam < cbBelow4GB)
+            {
+                GCPhysFirst = offRam;
+                cb          = RT_MIN(offEnd, cbBelow4GB) - offRam;
+            }
+            else
+            {
+                GCPhysFirst = _4G + (offRam - cbBelow4GB);
+                cb          = offEnd - offRam;
+            }
+            AssertBreak(off + sizeof(ACPITBLSRATMEM) <= cbMax);
+
+            ACPITBLSRATMEM *pMem = (ACPITBLSRATMEM *)&pbTable[off];
+            pMem->u8Type             = 1;
+            pMem->u8Length           = sizeof(*pMem);
+            pMem->u32ProximityDomain = RT_H2LE_U32(iNode);
+            pMem->u64BaseAddress     = RT_H2LE_U64(GCPhysFirst);
+            pMem->u64Length          = RT_H2LE_U64(cb);
+            pMem->u32Flags           = RT_H2LE_U32(SRAT_AFFINITY_ENABLED);
+            off    += sizeof(*pMem);
+            offRam += cb;
+        }
+    }
+
+    acpiR3PrepareHeader(pThis, &pSrat->aHeader, "SRAT", (uint32_t)off, 3);
+    pSrat->aHeader.u8Checksum = acpiR3Checksum(pbTable, off);
+    acpiR3PhysCopy(pDevIns, GCPhysDst, pbTable, off);
+
+    RTMemFree(pbTable);
+}
+
+
+/**
+ * Used by acpiR3PlantTables to plant the System Locality Information Table
+ * (SLIT) giving the relative distances between the virtual NUMA nodes.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The ACPI shared instance data.
+ * @param   GCPhysDst   Where to plant it.
+ */
+static void acpiR3SetupSlit(PPDMDEVINS pDevIns, PACPISTATE pThis, RTGCPHYS32 GCPhysDst)
+{
+    struct
+    {
+        ACPITBLSLIT hdr;
+        uint8_t     abDistances[ACPI_MAX_NUMA_NODES * ACPI_MAX_NUMA_NODES];
+    }              tbl;
+    uint32_t const cNodes = pThis->cNumaNodes;
+    uint32_t const cbTbl  = sizeof(tbl.hdr) + cNodes * cNodes;
+
+    RT_ZERO(tbl);
+
+    acpiR3PrepareHeader(pThis, &tbl.hdr.aHeader, "SLIT", cbTbl, 1);
+    tbl.hdr.u64Localities = RT_H2LE_U64(cNodes);
+    for (uint32_t iFrom = 0; iFrom < cNodes; iFrom++)
+        for (uint32_t iTo = 0; iTo < cNodes; iTo++)
+            tbl.abDistances[iFrom * cNodes + iTo] = iFrom == iTo ? SLIT_DISTANCE_LOCAL : SLIT_DISTANCE_REMOTE;
+
+    tbl.hdr.aHeader.u8Checksum = acpiR3Checksum(&tbl, cbTbl);
+
+    acpiR3PhysCopy(pDevIns, GCPhysDst, (const uint8_t *)&tbl, cbTbl);
+}
+
 /**
  * Used by acpiR3PlantTables and acpiConstruct.
  *
@@ -3747,23 +3928,25 @@ static int acpiR3PlantTables(PPDMDEVINS pDevIns, PACPISTATE pThis, PACPISTATER3
     RTGCPHYS32 GCPhysApic = 0;
     RTGCPHYS32 GCPhysSsdt = 0;
     RTGCPHYS32 GCPhysMcfg = 0;
+    RTGCPHYS32 GCPhysSrat = 0;
+    RTGCPHYS32 GCPhysSlit = 0;
     RTGCPHYS32 aGCPhysCust[MAX_CUST_TABLES] = {0};
     uint32_t   addend = 0;
 #if defined(VBOX_WITH_IOMMU_AMD) || defined(VBOX_WITH_IOMMU_INTEL)
 # ifdef VBOX_WITH_TPM
+    RTGCPHYS32 aGCPhysRsdt[12 + MAX_CUST_TABLES];
+    RTGCPHYS32 aGCPhysXsdt[12 + MAX_CUST_TABLES];
+# else
     RTGCPHYS32 aGCPhysRsdt[10 + MAX_CUST_TABLES];
     RTGCPHYS32 aGCPhysXsdt[10 + MAX_CUST_TABLES];
-# else
-    RTGCPHYS32 aGCPhysRsdt[8 + MAX_CUST_TABLES];
-    RTGCPHYS32 aGCPhysXsdt[8 + MAX_CUST_TABLES];
 # endif
 #else
 # ifdef VBOX_WITH_TPM
+    RTGCPHYS32 aGCPhysRsdt[11 + MAX_CUST_TABLES];
+    RTGCPHYS32 aGCPhysXsdt[11 + MAX_CUST_TABLES];
+# else
     RTGCPHYS32 aGCPhysRsdt[9 + MAX_CUST_TABLES];
     RTGCPHYS32 aGCPhysXsdt[9 + MAX_CUST_TABLES];
-# else
-    RTGCPHYS32 aGCPhysRsdt[7 + MAX_CUST_TABLES];
-    RTGCPHYS32 aGCPhysXsdt[7 + MAX_CUST_TABLES];
 # endif
 #endif
     uint32_t   cAddr;
@@ -3778,6 +3961,8 @@ static int acpiR3PlantTables(PPDMDEVINS pDevIns, PACPISTATE pThis, PACPISTATER3
 #endif
     uint32_t   iSsdt  = 0;
     uint32_t   iMcfg  = 0;
+    uint32_t   iSrat  = 0;
+    uint32_t   iSlit  = 0;
     uint32_t   iCust  = 0;
     size_t     cbRsdt = sizeof(ACPITBLHEADER);
     size_t     cbXsdt = sizeof(ACPITBLHEADER);
@@ -3810,6 +3995,12 @@ static int acpiR3PlantTables(PPDMDEVINS pDevIns, PACPISTATE pThis, PACPISTATER3
     if (pThis->fUseMcfg)
         iMcfg = cAddr++;        /* MCFG */
 
+    if (pThis->cNumaNodes)
+    {
+        iSrat = cAddr++;        /* SRAT */
+        iSlit = cAddr++;        /* SLIT */
+    }
+
     if (pThis->cCustTbls > 0)
     {
         iCust = cAddr;          /* CUST */
@@ -3923,6 +4114,14 @@ static int acpiR3PlantTables(PPDMDEVINS pDevIns, PACPISTATE pThis, PACPISTATER3
         GCPhysCur = RT_ALIGN_32(GCPhysCur + sizeof(ACPITBLMCFG) + sizeof(ACPITBLMCFGENTRY), 16);
     }
 
+    if (pThis->cNumaNodes)
+    {
+        GCPhysSrat = GCPhysCur;
+        GCPhysCur = RT_ALIGN_32(GCPhysCur + (uint32_t)acpiR3SratSize(pThis), 16);
+        GCPhysSlit = GCPhysCur;
+        GCPhysCur = RT_ALIGN_32(GCPhysCur + sizeof(ACPITBLSLIT) + pThis->cNumaNodes * pThis->cNumaNodes, 16);
+    }
+
     for (uint8_t i = 0; i < pThis->cCustTbls; i++)
     {
         aGCPhysCust[i] = GCPhysCur;
@@ -3963,6 +4162,8 @@ static int acpiR3PlantTables(PPDMDEVINS pDevIns, PACPISTATE pThis, PACPISTATER3
         Log((" HPET 0x%08X", GCPhysHpet + addend));
     if (pThis->fUseMcfg)
         Log((" MCFG 0x%08X", GCPhysMcfg + addend));
+    if (pThis->cNumaNodes)
+        Log((" SRAT 0x%08X SLIT 0x%08X", GCPhysSrat + addend, GCPhysSlit + addend));
     for (uint8_t i = 0; i < pThis->cCustTbls; i++)
         Log((" CUST(%d) 0x%08X", i, aGCPhysCust[i] + addend));
     Log((" SSDT 0x%08X", GCPhysSsdt + addend));
@@ -4024,6 +4225,16 @@ static int acpiR3PlantTables(PPDMDEVINS pDevIns, PACPISTATE pThis, PACPISTATER3
         aGCPhysRsdt[iMcfg] = GCPhysMcfg + addend;
         aGCPhysXsdt[iMcfg] = GCPhysMcfg + addend;
     }
+    if (pThis->cNumaNodes)
+    {
+        acpiR3SetupSrat(pDevIns, pThis, GCPhysSrat + addend);
+        aGCPhysRsdt[iSrat] = GCPhysSrat + addend;
+        aGCPhysXsdt[iSrat] = GCPhysSrat + addend;
+
+        acpiR3SetupSlit(pDevIns, pThis, GCPhysSlit + addend);
+        aGCPhysRsdt[iSlit] = GCPhysSlit + addend;
+        aGCPhysXsdt[iSlit] = GCPhysSlit + addend;
+    }
     for (uint8_t i = 0; i < pThis->cCustTbls; i++)
     {
         AssertBreak(i < MAX_CUST_TABLES);
@@ -4339,6 +4550,7 @@ static DECLCALLBACK(int) acpiR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
                                   "IOAPIC"
                                   "|NumCPUs"
                                   "|HpetEnabled"
+                                  "|NumaNodes"
                                   "|McfgEnabled"
                                   "|McfgBase"
                                   "|McfgLength"
@@ -4399,6 +4611,19 @@ static DECLCALLBACK(int) acpiR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
     if (RT_FAILURE(rc))
         return PDMDEV_SET_ERROR(pDevIns, rc, N_("Configuration error: Querying \"NumCPUs\" as integer failed"));
 
+    /* query the number of virtual NUMA nodes to describe (SRAT/SLIT) */
+    rc = pHlp->pfnCFGMQueryU8Def(pCfg, "NumaNodes", &pThis->cNumaNodes, 0);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("Configuration error: Failed to read \"NumaNodes\""));
+    if (pThis->cNumaNodes > RT_MIN(pThis->cCpus, ACPI_MAX_NUMA_NODES))
+        return PDMDevHlpVMSetError(pDevIns, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                                   N_("Configuration error: \"NumaNodes\"=%u exceeds the vCPU count (%u) or the maximum of %u"),
+                                   pThis->cNumaNodes, pThis->cCpus, ACPI_MAX_NUMA_NODES);
+    if (pThis->cNumaNodes == 1)
+        pThis->cNumaNodes = 0; /* A single node is the same as no NUMA topology. */
+    if (pThis->cNumaNodes)
+        LogRel(("ACPI: Presenting %u virtual NUMA nodes to the guest\n", pThis->cNumaNodes));
+
     /* query whether we are supposed to present an FDC controller */
     rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "FdcEnabled", &pThis->fUseFdc, true);
     if (RT_FAILURE(rc))
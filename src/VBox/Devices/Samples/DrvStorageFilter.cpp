@@ -345,6 +345,13 @@ static DECLCALLBACK(int) drvStorageFltIMedia_IoReqDiscard(PPDMIMEDIAEX pInterfac
     return pThis->pIMediaExBelow->pfnIoReqDiscard(pThis->pIMediaExBelow, hIoReq, cRangesMax);
 }
 
+/** @interface_method_impl{PDMIMEDIAEX,pfnIoReqWriteZeroes} */
+static DECLCALLBACK(int) drvStorageFltIMedia_IoReqWriteZeroes(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq, uint64_t off, size_t cbZero)
+{
+    PDRVSTORAGEFILTER pThis = RT_FROM_MEMBER(pInterface, DRVSTORAGEFILTER, IMediaEx);
+    return pThis->pIMediaExBelow->pfnIoReqWriteZeroes(pThis->pIMediaExBelow, hIoReq, off, cbZero);
+}
+
 /** @interface_method_impl{PDMIMEDIAEX,pfnIoReqSendScsiCmd} */
 static DECLCALLBACK(int) drvStorageFltIMedia_IoReqSendScsiCmd(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq,
                                                               uint32_t uLun, const uint8_t *pbCdb, size_t cbCdb,
@@ -476,6 +483,7 @@ static DECLCALLBACK(int) drvStorageFlt_Construct(PPDMDRVINS pDrvIns, PCFGMNODE p
     pThis->IMediaEx.pfnIoReqWrite               = drvStorageFltIMedia_IoReqWrite;
     pThis->IMediaEx.pfnIoReqFlush               = drvStorageFltIMedia_IoReqFlush;
     pThis->IMediaEx.pfnIoReqDiscard             = drvStorageFltIMedia_IoReqDiscard;
+    pThis->IMediaEx.pfnIoReqWriteZeroes         = drvStorageFltIMedia_IoReqWriteZeroes;
     pThis->IMediaEx.pfnIoReqSendScsiCmd         = drvStorageFltIMedia_IoReqSendScsiCmd;
     pThis->IMediaEx.pfnIoReqGetActiveCount      = drvStorageFltIMedia_IoReqGetActiveCount;
     pThis->IMediaEx.pfnIoReqGetSuspendedCount   = drvStorageFltIMedia_IoReqGetSuspendedCount;
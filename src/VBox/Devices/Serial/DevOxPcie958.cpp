@@ -526,7 +526,7 @@ static DECLCALLBACK(int) ox958R3Construct(PPDMDEVINS pDevIns, int iInstance, PCF
     /*
      * Validate and read configuration.
      */
-    PDMDEV_VALIDATE_CONFIG_RETURN(pDevIns, "MsiXSupported|UartCount", "");
+    PDMDEV_VALIDATE_CONFIG_RETURN(pDevIns, "MsiXSupported|UartCount|FastConsole", "");
 
     rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "MsiXSupported", &fMsiXSupported, true);
     if (RT_FAILURE(rc))
@@ -536,6 +536,11 @@ static DECLCALLBACK(int) ox958R3Construct(PPDMDEVINS pDevIns, int iInstance, PCF
     if (RT_FAILURE(rc))
         return PDMDEV_SET_ERROR(pDevIns, rc, N_("OXPCIe958 configuration error: failed to read \"UartCount\" as unsigned 32bit integer"));
 
+    bool fFastConsole = false;
+    rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "FastConsole", &fFastConsole, false);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("OXPCIe958 configuration error: failed to read \"FastConsole\" as boolean"));
+
     if (!pThis->cUarts || pThis->cUarts > OX958_UARTS_MAX)
         return PDMDevHlpVMSetError(pDevIns, rc, RT_SRC_POS,
                                    N_("OXPCIe958 configuration error: \"UartCount\" has invalid value %u (must be in range [1 .. %u]"),
@@ -612,7 +617,8 @@ static DECLCALLBACK(int) ox958R3Construct(PPDMDEVINS pDevIns, int iInstance, PCF
     {
         POX958UART   pUart   = &pThis->aUarts[i];
         POX958UARTCC pUartCC = &pThisCC->aUarts[i];
-        rc = uartR3Init(pDevIns, &pUart->UartCore, &pUartCC->UartCore, UARTTYPE_16550A, i, 0, ox958IrqReq);
+        rc = uartR3Init(pDevIns, &pUart->UartCore, &pUartCC->UartCore, UARTTYPE_16550A, i,
+                        fFastConsole ? UART_CORE_FAST_CONSOLE : 0, ox958IrqReq);
         if (RT_FAILURE(rc))
             return PDMDevHlpVMSetError(pDevIns, rc, RT_SRC_POS,
                                        N_("OXPCIe958 configuration error: failed to initialize UART %u"), i);
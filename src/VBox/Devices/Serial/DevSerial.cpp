@@ -358,13 +358,22 @@ static DECLCALLBACK(int) serialR3Construct(PPDMDEVINS pDevIns, int iInstance, PC
     /*
      * Validate and read the configuration.
      */
-    PDMDEV_VALIDATE_CONFIG_RETURN(pDevIns, "IRQ|IOAddress|YieldOnLSRRead|UartType", "");
+    PDMDEV_VALIDATE_CONFIG_RETURN(pDevIns, "IRQ|IOAddress|YieldOnLSRRead|UartType|FastConsole", "");
 
     bool fYieldOnLSRRead = false;
     rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "YieldOnLSRRead", &fYieldOnLSRRead, false);
     if (RT_FAILURE(rc))
         return PDMDEV_SET_ERROR(pDevIns, rc, N_("Configuration error: Failed to get the \"YieldOnLSRRead\" value"));
 
+    /*
+     * The fast console mode is meant for logging guest output to a file, pipe or socket,
+     * the guest doesn't have to wait for the data to be written out before sending more.
+     */
+    bool fFastConsole = false;
+    rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "FastConsole", &fFastConsole, false);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("Configuration error: Failed to get the \"FastConsole\" value"));
+
     uint8_t uIrq = 0;
     rc = pHlp->pfnCFGMQueryU8(pCfg, "IRQ", &uIrq);
     if (rc == VERR_CFGM_VALUE_NOT_FOUND)
@@ -436,7 +445,8 @@ static DECLCALLBACK(int) serialR3Construct(PPDMDEVINS pDevIns, int iInstance, PC
      * Init the UART core structure.
      */
     rc = uartR3Init(pDevIns, &pThis->UartCore, &pThisCC->UartCore, enmUartType, 0,
-                    fYieldOnLSRRead ? UART_CORE_YIELD_ON_LSR_READ : 0, serialIrqReq);
+                      (fYieldOnLSRRead ? UART_CORE_YIELD_ON_LSR_READ : 0)
+                    | (fFastConsole    ? UART_CORE_FAST_CONSOLE      : 0), serialIrqReq);
     AssertRCReturn(rc, rc);
 
     serialR3Reset(pDevIns);
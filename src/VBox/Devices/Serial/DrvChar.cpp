@@ -77,8 +77,8 @@ typedef struct DRVCHAR
     /** I/O thread. */
     PPDMTHREAD                  pThrdIo;
 
-    /** Small send buffer. */
-    uint8_t                     abTxBuf[16];
+    /** Send buffer, large enough to drain a deep UART FIFO with a single write. */
+    uint8_t                     abTxBuf[256];
     /** Amount of data in the buffer. */
     size_t                      cbTxUsed;
 
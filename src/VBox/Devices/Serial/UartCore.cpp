@@ -414,6 +414,31 @@ DECLINLINE(uint8_t) uartFifoGet(PUARTFIFO pFifo)
     return bRet;
 }
 
+
+/**
+ * Returns the amount of free bytes in the given FIFO.
+ *
+ * @returns The amount of bytes free in the given FIFO.
+ * @param   pFifo               The FIFO.
+ */
+DECLINLINE(size_t) uartFifoFreeGet(PUARTFIFO pFifo)
+{
+    return pFifo->cbMax - pFifo->cbUsed;
+}
+
+
+/**
+ * Returns the transmit FIFO depth as seen by the guest, i.e. the number of bytes
+ * the guest may write after seeing THRE set.
+ *
+ * @returns Guest visible transmit FIFO depth.
+ * @param   pThis               The shared serial port instance data.
+ */
+DECLINLINE(size_t) uartXmitFifoDepthGet(PUARTCORE pThis)
+{
+    return pThis->uRegFcr & UART_REG_FCR_64BYTE_FIFO_EN ? 64 : 16;
+}
+
 #ifdef IN_RING3
 
 /**
@@ -430,18 +455,6 @@ DECLINLINE(void) uartFifoClear(PUARTFIFO pFifo)
 }
 
 
-/**
- * Returns the amount of free bytes in the given FIFO.
- *
- * @returns The amount of bytes free in the given FIFO.
- * @param   pFifo               The FIFO.
- */
-DECLINLINE(size_t) uartFifoFreeGet(PUARTFIFO pFifo)
-{
-    return pFifo->cbMax - pFifo->cbUsed;
-}
-
-
 /**
  * Tries to copy the requested amount of data from the given FIFO into the provided buffer.
  *
@@ -719,6 +732,20 @@ static void uartR3DataFetch(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORECC pTh
 }
 
 
+/**
+ * Updates whether the fast console mode is active.
+ *
+ * @param   pThis               The shared serial port instance data.
+ * @param   pThisCC             The serial port instance data for the current context.
+ */
+static void uartR3FastTxUpdate(PUARTCORE pThis, PUARTCORECC pThisCC)
+{
+    pThis->fFastTx =    (pThis->fFlags & UART_CORE_FAST_CONSOLE)
+                     && pThisCC->pDrvSerial
+                     && !(pThis->uRegMcr & UART_REG_MCR_LOOP);
+}
+
+
 /**
  * Reset the transmit/receive related bits to the standard values
  * (after a detach/attach/reset event).
@@ -729,6 +756,7 @@ static void uartR3DataFetch(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORECC pTh
  */
 static void uartR3XferReset(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORECC pThisCC)
 {
+    uartR3FastTxUpdate(pThis, pThisCC);
     PDMDevHlpTimerStop(pDevIns, pThis->hTimerRcvFifoTimeout);
     PDMDevHlpTimerStop(pDevIns, pThis->hTimerTxUnconnected);
     pThis->uRegLsr = UART_REG_LSR_THRE | UART_REG_LSR_TEMT;
@@ -775,7 +803,9 @@ static void uartR3TxQueueCopyFrom(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORE
     if (pThis->uRegFcr & UART_REG_FCR_FIFO_EN)
     {
         *pcbRead = uartFifoCopyTo(&pThis->FifoXmit, pvBuf, cbRead);
-        if (!pThis->FifoXmit.cbUsed)
+        if (   !pThis->FifoXmit.cbUsed
+            || (   pThis->fFastTx
+                && uartFifoFreeGet(&pThis->FifoXmit) >= uartXmitFifoDepthGet(pThis)))
         {
             UART_REG_SET(pThis->uRegLsr, UART_REG_LSR_THRE);
             pThis->fThreEmptyPending = true;
@@ -822,7 +852,33 @@ static VBOXSTRICTRC uartXmit(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORECC pT
     bool fNotifyDrv = false;
 #endif
 
-    if (pThis->uRegFcr & UART_REG_FCR_FIFO_EN)
+    if (   pThis->fFastTx
+        && (pThis->uRegFcr & UART_REG_FCR_FIFO_EN))
+    {
+        /*
+         * Fast console mode, the bytes are collected in the deep transmit FIFO and THRE stays
+         * set as long as there is room for another guest visible FIFO worth of data. So guests
+         * polling LSR before each byte don't have to wait for the driver below to drain the FIFO
+         * and everything can be handled without going to ring-3.
+         */
+        bool const fWasEmpty = !uartFifoUsedGet(&pThis->FifoXmit);
+        uartFifoPut(&pThis->FifoXmit, true /*fOvrWr*/, bVal);
+        UART_REG_CLR(pThis->uRegLsr, UART_REG_LSR_TEMT);
+        if (uartFifoFreeGet(&pThis->FifoXmit) < uartXmitFifoDepthGet(pThis))
+            UART_REG_CLR(pThis->uRegLsr, UART_REG_LSR_THRE);
+        pThis->fThreEmptyPending = false;
+        uartIrqUpdate(pDevIns, pThis, pThisCC);
+        if (fWasEmpty)
+        {
+#ifdef IN_RING3
+            fNotifyDrv = true;
+#else
+            int rc2 = PDMDevHlpTaskTrigger(pDevIns, pThis->hTaskTxNotify);
+            AssertRC(rc2);
+#endif
+        }
+    }
+    else if (pThis->uRegFcr & UART_REG_FCR_FIFO_EN)
     {
 #ifndef IN_RING3
         RT_NOREF(pDevIns, pThisCC);
@@ -1026,6 +1082,10 @@ DECLINLINE(VBOXSTRICTRC) uartRegFcrWrite(PPDMDEVINS pDevIns, PUARTCORE pThis, PU
                 pThis->FifoXmit.cbMax = 16;
             }
 
+            /* The fast console mode always uses the deep transmit FIFO, see uartXmit(). */
+            if (pThis->fFlags & UART_CORE_FAST_CONSOLE)
+                pThis->FifoXmit.cbMax = UART_FIFO_LENGTH_MAX;
+
             if (uVal & UART_REG_FCR_FIFO_EN)
             {
                 uint8_t idxItl = UART_REG_FCR_RCV_LVL_IRQ_GET(uVal);
@@ -1117,6 +1177,7 @@ DECLINLINE(VBOXSTRICTRC) uartRegMcrWrite(PPDMDEVINS pDevIns, PUARTCORE pThis, PU
             pThisCC->pDrvSerial->pfnChgModemLines(pThisCC->pDrvSerial, false /*fRts*/, false /*fDtr*/);
 
         pThis->uRegMcr = uVal;
+        uartR3FastTxUpdate(pThis, pThisCC);
         if (uVal & UART_REG_MCR_LOOP)
         {
             uint8_t uRegMsrSts = 0;
@@ -1583,6 +1644,24 @@ static DECLCALLBACK(void) uartR3TxUnconnectedTimer(PPDMDEVINS pDevIns, TMTIMERHA
 }
 
 
+/**
+ * @callback_method_impl{FNPDMTASKDEV,
+ *      Notifies the driver below about new transmit data queued in ring-0 in the
+ *      fast console mode.}
+ */
+static DECLCALLBACK(void) uartR3TxNotifyTask(PPDMDEVINS pDevIns, void *pvUser)
+{
+    PUARTCORER3          pThisCC    = (PUARTCORECC)pvUser;
+    PPDMISERIALCONNECTOR pDrvSerial = pThisCC->pDrvSerial;
+    if (pDrvSerial)
+    {
+        int rc = pDrvSerial->pfnDataAvailWrNotify(pDrvSerial);
+        if (RT_FAILURE(rc))
+            LogRelMax(10, ("Serial#%d: Failed to send data with %Rrc\n", pDevIns->iInstance, rc));
+    }
+}
+
+
 /* -=-=-=-=-=-=-=-=- PDMISERIALPORT on LUN#0 -=-=-=-=-=-=-=-=- */
 
 
@@ -1633,12 +1712,15 @@ static DECLCALLBACK(int) uartR3DataSentNotify(PPDMISERIALPORT pInterface)
     PUARTCORE   pThis   = pThisCC->pShared;
     PPDMDEVINS  pDevIns = pThisCC->pDevIns;
 
-    /* Set the transmitter empty bit because everything was sent. */
+    /* Set the transmitter empty bit because everything was sent (unless the guest queued more meanwhile). */
     int const rcLock = PDMDevHlpCritSectEnter(pDevIns, &pThis->CritSect, VERR_IGNORED);
     AssertRCReturn(rcLock, rcLock);
 
-    UART_REG_SET(pThis->uRegLsr, UART_REG_LSR_TEMT);
-    uartIrqUpdate(pDevIns, pThis, pThisCC);
+    if (!uartFifoUsedGet(&pThis->FifoXmit))
+    {
+        UART_REG_SET(pThis->uRegLsr, UART_REG_LSR_TEMT);
+        uartIrqUpdate(pDevIns, pThis, pThisCC);
+    }
 
     PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
     return VINF_SUCCESS;
@@ -1881,6 +1963,14 @@ DECLHIDDEN(int) uartR3LoadDone(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORECC
 {
     RT_NOREF(pSSM);
 
+    /* The transmit FIFO content isn't saved and the fast console mode might have been toggled. */
+    if (pThis->fFlags & UART_CORE_FAST_CONSOLE)
+    {
+        uartFifoClear(&pThis->FifoXmit);
+        pThis->FifoXmit.cbMax = UART_FIFO_LENGTH_MAX;
+    }
+    uartR3FastTxUpdate(pThis, pThisCC);
+
     uartR3ParamsUpdate(pDevIns, pThis, pThisCC);
     uartIrqUpdate(pDevIns, pThis, pThisCC);
 
@@ -1931,7 +2021,7 @@ DECLHIDDEN(void) uartR3Reset(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORECC pT
     pThis->fThreEmptyPending = true;
 
     /* Standard FIFO size for 15550A. */
-    pThis->FifoXmit.cbMax = 16;
+    pThis->FifoXmit.cbMax = pThis->fFlags & UART_CORE_FAST_CONSOLE ? UART_FIFO_LENGTH_MAX : 16;
     pThis->FifoRecv.cbMax = 16;
     pThis->FifoRecv.cbItl = 1;
 
@@ -2042,6 +2132,7 @@ DECLHIDDEN(int) uartR3Init(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORECC pThi
     pThis->iLUN                                     = iLUN;
     pThis->enmType                                  = enmType;
     pThis->fFlags                                   = fFlags;
+    pThis->hTaskTxNotify                            = NIL_PDMTASKHANDLE;
 
     pThisCC->iLUN                                   = iLUN;
     pThisCC->pDevIns                                = pDevIns;
@@ -2107,6 +2198,17 @@ DECLHIDDEN(int) uartR3Init(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORECC pThi
                               &pThis->hTimerTxUnconnected);
     AssertRCReturn(rc, rc);
 
+    /*
+     * Create the task for kicking the driver below from ring-0 in the fast console mode.
+     */
+    if (fFlags & UART_CORE_FAST_CONSOLE)
+    {
+        rc = PDMDevHlpTaskCreate(pDevIns, PDMTASK_F_RZ, "UART-TxNotify", uartR3TxNotifyTask, pThisCC,
+                                 &pThis->hTaskTxNotify);
+        AssertRCReturn(rc, rc);
+        LogRel(("Serial#%d: fast console mode enabled for LUN#%u\n", pDevIns->iInstance, iLUN));
+    }
+
     uartR3Reset(pDevIns, pThis, pThisCC);
     return VINF_SUCCESS;
 }
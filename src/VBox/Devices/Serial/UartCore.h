@@ -167,6 +167,9 @@ typedef struct UARTCORE
     TMTIMERHANDLE                   hTimerRcvFifoTimeout;
     /** Timer handle for the send loop if no driver is connected/loopback mode is active. */
     TMTIMERHANDLE                   hTimerTxUnconnected;
+    /** Task handle for notifying the driver below about new transmit data from ring-0
+     * (only created for the fast console mode). */
+    PDMTASKHANDLE                   hTaskTxNotify;
 
     /** Flag whether a character timeout interrupt is pending
      * (no symbols were inserted or removed from the receive FIFO
@@ -177,8 +180,11 @@ typedef struct UARTCORE
      * IIR register was read. This gets reset when IIR is read so the guest will get this
      * interrupt ID only once. */
     bool                            fThreEmptyPending;
+    /** Flag whether the fast console mode is currently active, i.e. UART_CORE_FAST_CONSOLE
+     * is configured, a driver is attached and loopback mode is disabled. */
+    bool                            fFastTx;
     /** Explicit alignment. */
-    bool                            afAlignment1[2];
+    bool                            afAlignment1[1];
     /** The transmit FIFO. */
     UARTFIFO                        FifoXmit;
     /** The receive FIFO. */
@@ -262,6 +268,9 @@ typedef CTX_SUFF(PUARTCORE) PUARTCORECC;
 
 /** Flag whether to yield the CPU on an LSR read. */
 #define UART_CORE_YIELD_ON_LSR_READ      RT_BIT_32(0)
+/** Fast console mode: the transmitter is not paced by the attached driver, bytes are
+ * collected in a deep transmit FIFO and THRE stays set while there is room for it. */
+#define UART_CORE_FAST_CONSOLE           RT_BIT_32(1)
 
 DECLHIDDEN(VBOXSTRICTRC) uartRegWrite(PPDMDEVINS pDevIns, PUARTCORE pThis, PUARTCORECC pThisCC,
                                       uint32_t uReg, uint32_t u32, size_t cb);
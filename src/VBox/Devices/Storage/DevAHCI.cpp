@@ -349,8 +349,11 @@ typedef struct AHCIPORT
     volatile bool                   fRedo;
     /** Flag whether the worker thread is sleeping. */
     volatile bool                   fWrkThreadSleeping;
-
-    bool                            afAlignment1[2];
+    /** Flag whether the worker thread is in a command processing pass and
+     * SDB FIS generation is deferred to the end of it. */
+    volatile bool                   fSdbBatch;
+    /** Flag whether queued tasks completed and an SDB FIS is due. */
+    volatile bool                   fSdbPending;
 
     /** Number of total sectors. */
     uint64_t                        cTotalSectors;
@@ -1999,6 +2002,7 @@ static void ahciR3PortSwReset(PAHCIPORT pAhciPort, PAHCIPORTR3 pAhciPortR3)
     pAhciPort->u32TasksFinished = 0;
     pAhciPort->u32QueuedTasksFinished = 0;
     pAhciPort->u32CurrentCommandSlot = 0;
+    pAhciPort->fSdbPending = false;
 
     if (pAhciPort->fPresent)
     {
@@ -3181,6 +3185,28 @@ static void ahciSendSDBFis(PPDMDEVINS pDevIns, PAHCI pThis, PAHCIPORT pAhciPort,
     }
 }
 
+/**
+ * Sends a SDB FIS for finished queued tasks, or defers it to the end of the
+ * current command processing pass of the worker thread so that all tasks
+ * completing during the pass are reported with a single FIS and interrupt.
+ *
+ * @param   pDevIns         The device instance.
+ * @param   pThis           The shared AHCI state.
+ * @param   pAhciPort       The port for which the SDB Fis is send, shared bits.
+ * @param   pAhciPortR3     The port for which the SDB Fis is send, ring-3 bits.
+ */
+static void ahciR3SendSDBFisBatched(PPDMDEVINS pDevIns, PAHCI pThis, PAHCIPORT pAhciPort, PAHCIPORTR3 pAhciPortR3)
+{
+    /*
+     * The finished task bits are set already, so whoever resets the pending flag
+     * reports them. The worker thread checks the flag after leaving the pass.
+     */
+    ASMAtomicWriteBool(&pAhciPort->fSdbPending, true);
+    if (   !ASMAtomicReadBool(&pAhciPort->fSdbBatch)
+        && ASMAtomicXchgBool(&pAhciPort->fSdbPending, false))
+        ahciSendSDBFis(pDevIns, pThis, pAhciPort, pAhciPortR3, 0, true);
+}
+
 static uint32_t ahciGetNSectors(uint8_t *pCmdFis, bool fLBA48)
 {
     /* 0 means either 256 (LBA28) or 65536 (LBA48) sectors. */
@@ -3739,9 +3765,11 @@ static bool ahciR3TransferComplete(PPDMDEVINS pDevIns, PAHCI pThis, PAHCICC pThi
             /*
              * Always raise an interrupt after task completion; delaying
              * this (interrupt coalescing) increases latency and has a significant
-             * impact on performance (see @bugref{5071})
+             * impact on performance (see @bugref{5071}). Tasks completing while
+             * the worker thread processes new commands are only reported once
+             * at the end of the pass, which doesn't add any delay.
              */
-            ahciSendSDBFis(pDevIns, pThis, pAhciPort, pAhciPortR3, 0, true);
+            ahciR3SendSDBFisBatched(pDevIns, pThis, pAhciPort, pAhciPortR3);
         }
         else
             ahciSendD2HFis(pDevIns, pThis, pAhciPort, uTag, &cmdFis[0], true);
@@ -4562,6 +4590,9 @@ static DECLCALLBACK(int) ahciAsyncIOLoop(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
             continue;
         }
 
+        /* Process all newly set command slots in one pass, reporting completions once at the end. */
+        ASMAtomicWriteBool(&pAhciPort->fSdbBatch, true);
+
         idx = ASMBitFirstSetU32(u32Tasks);
         while (   idx
                && !pAhciPort->fPortReset)
@@ -4620,6 +4651,10 @@ static DECLCALLBACK(int) ahciAsyncIOLoop(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
             idx = ASMBitFirstSetU32(u32Tasks);
         } /* while tasks available */
 
+        ASMAtomicWriteBool(&pAhciPort->fSdbBatch, false);
+        if (ASMAtomicXchgBool(&pAhciPort->fSdbPending, false))
+            ahciSendSDBFis(pDevIns, pThis, pAhciPort, pAhciPortR3, 0, true);
+
         /* Check whether a port reset was active. */
         if (   ASMAtomicReadBool(&pAhciPort->fPortReset)
             && (pAhciPort->regSCTL & AHCI_PORT_SCTL_DET) == AHCI_PORT_SCTL_DET_NINIT)
@@ -5977,6 +6012,7 @@ static DECLCALLBACK(int) ahciR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
         pAhciPortR3->IMediaExPort.pfnIoReqCopyFromBuf        = ahciR3IoReqCopyFromBuf;
         pAhciPortR3->IMediaExPort.pfnIoReqCopyToBuf          = ahciR3IoReqCopyToBuf;
         pAhciPortR3->IMediaExPort.pfnIoReqQueryBuf           = ahciR3IoReqQueryBuf;
+        pAhciPortR3->IMediaExPort.pfnIoReqQuerySgBuf         = NULL;
         pAhciPortR3->IMediaExPort.pfnIoReqQueryDiscardRanges = ahciR3IoReqQueryDiscardRanges;
         pAhciPortR3->IMediaExPort.pfnIoReqStateChanged       = ahciR3IoReqStateChanged;
         pAhciPortR3->IMediaExPort.pfnMediumEjected           = ahciR3MediumEjected;
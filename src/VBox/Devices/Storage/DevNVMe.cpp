@@ -61,7 +61,13 @@
 *   Defined Constants And Macros                                                                                                 *
 *********************************************************************************************************************************/
 /** The current saved state version. */
-#define NVME_SAVED_STATE_VERSION          2
+#define NVME_SAVED_STATE_VERSION          5
+/** The saved state version before the write zeroes command was introduced. */
+#define NVME_SAVED_STATE_VERSION_PRE_WRITE_ZEROES 4
+/** The saved state version before interrupt coalescing was introduced. */
+#define NVME_SAVED_STATE_VERSION_PRE_INTR_COAL 3
+/** The saved state version before the doorbell buffer config feature was introduced. */
+#define NVME_SAVED_STATE_VERSION_PRE_DBBUF 2
 /** The saved state version before the controller memory buffer feature was introduced. */
 #define NVME_SAVED_STATE_VERSION_PRE_CMB  1
 
@@ -107,6 +113,16 @@
 #define NVME_CTRL_MEM_BUF_SIZE_DEF        (5 * _1M)
 /** Default controller memory buffer granularity. */
 #define NVME_CTRL_MEM_BUF_GRANULARITY_DEF "4KB"
+/** Default number of microseconds to poll the shadow doorbells before going to sleep. */
+#define NVME_DBBUF_POLL_US_DEF            0
+/** Maximum number of microseconds to poll the shadow doorbells before going to sleep. */
+#define NVME_DBBUF_POLL_US_MAX            1000
+/** Default maximum interrupt delay in microseconds for adaptive host side coalescing (0 = disabled). */
+#define NVME_INTR_COAL_ADAPTIVE_US_DEF    0
+/** Maximum interrupt delay in microseconds for adaptive host side coalescing. */
+#define NVME_INTR_COAL_ADAPTIVE_US_MAX    1000
+/** Maximum number of completions adaptive host side coalescing holds back per interrupt. */
+#define NVME_INTR_COAL_ADAPTIVE_EVTS_MAX  32
 /** @} */
 
 /** @name PCI device related constants.
@@ -627,6 +643,16 @@ typedef NVMECMDADM *PNVMECMDADM;
 #define NVME_CMD_ADM_OPC_FW_IMG_DWNLD                  0x11
 /** Opcode: Namespace attachment. */
 #define NVME_CMD_ADM_OPC_NS_ATTACHMENT                 0x15
+/** Opcode: Doorbell buffer config. */
+#define NVME_CMD_ADM_OPC_DBBUF_CFG                     0x7c
+
+/** Optional admin command support (OACS): Doorbell buffer config. */
+#define NVME_CMD_ADM_OACS_DBBUF_CFG                    RT_BIT(8)
+/** Offset of the submission queue tail entry in the shadow doorbell and EventIdx buffers
+ * (mirrors the doorbell register layout with a stride of 0). */
+#define NVME_DBBUF_OFF_SQ(a_iQueueId)                  ((uint32_t)(a_iQueueId) * 2 * sizeof(uint32_t))
+/** Offset of the completion queue head entry in the shadow doorbell and EventIdx buffers. */
+#define NVME_DBBUF_OFF_CQ(a_iQueueId)                  (NVME_DBBUF_OFF_SQ(a_iQueueId) + sizeof(uint32_t))
 
 /** Create I/O completion queue, physically contiguous bit. */
 #define NVME_CMD_ADM_CREATE_IO_CQ_PC                   RT_BIT(0)
@@ -1009,6 +1035,14 @@ typedef NVMECMDNVM *PNVMECMDNVM;
 #define NVME_CMD_NVM_WRITE                              0x01
 /** Opcode: Read */
 #define NVME_CMD_NVM_READ                               0x02
+/** Opcode: Write Zeroes */
+#define NVME_CMD_NVM_WRITE_ZEROES                       0x08
+/** @} */
+
+/** @name Optional NVM command support flags (NVMEIDENTIFYCTRL::u16OptNvmCmdSupported).
+ * @{ */
+/** Write Zeroes command supported. */
+#define NVME_ONCS_WRITE_ZEROES                          RT_BIT(3)
 /** @} */
 
 /**
@@ -1236,6 +1270,22 @@ typedef NVMECQENT *PNVMECQENT;
 #define NVME_FEAT_ID_HOST_MEMORY_BUFFER                0x0d
 /** @} */
 
+/** @name Feature specific defines.
+ * @{ */
+/** Interrupt coalescing: Aggregation threshold (0's based number of completion queue entries). */
+#define NVME_FEAT_INTR_COAL_THR_GET(a_u32)             ((uint8_t)((a_u32) & 0xff))
+/** Interrupt coalescing: Aggregation time in 100 microsecond units. */
+#define NVME_FEAT_INTR_COAL_TIME_GET(a_u32)            ((uint8_t)(((a_u32) >> 8) & 0xff))
+/** Interrupt coalescing: Makes the feature value from the threshold and time. */
+#define NVME_FEAT_INTR_COAL_MAKE(a_uThr, a_uTime)      ((uint32_t)(a_uThr) | ((uint32_t)(a_uTime) << 8))
+/** Interrupt coalescing: Unit of the aggregation time in microseconds. */
+#define NVME_FEAT_INTR_COAL_TIME_UNIT_US               100
+/** Interrupt vector configuration: Interrupt vector. */
+#define NVME_FEAT_INTR_VEC_CFG_IV_GET(a_u32)           ((uint16_t)((a_u32) & 0xffff))
+/** Interrupt vector configuration: Coalescing disable. */
+#define NVME_FEAT_INTR_VEC_CFG_CD                      RT_BIT_32(16)
+/** @} */
+
 /** @name Feature Identifiers - NVM command set.
  * @{ */
 /** Software progress marker. */
@@ -1468,6 +1518,9 @@ typedef struct NVMEWRKTHRD
     RTLISTANCHOR                    ListSubmQueuesAssgnd;
     /** Request queue for assigning and unassigning submission queues. */
     R3PTRTYPE(RTREQQUEUE)           hReqQueue;
+    /** Guest mapping cache for fetching submission queue entries, NULL if not
+     * available.  Only accessed by the worker thread. */
+    R3PTRTYPE(PPDMPHYSMAPCACHE)     pPhysMapCache;
 } NVMEWRKTHRD;
 /** Pointer to a NVMe worker thread structure. */
 typedef NVMEWRKTHRD *PNVMEWRKTHRD;
@@ -1501,6 +1554,8 @@ typedef struct NVMENAMESPACE
     PDMIMEDIAEXPORT                 IPortEx;
     /** The status LED state for this namespace. */
     PDMLED                          Led;
+    /** Flag whether the attached driver supports write zeroes requests natively. */
+    bool                            fMediaWriteZeroes;
 
     /** Pointer to the NVMe device instance. */
     PPDMDEVINS                      pDevIns;
@@ -1619,8 +1674,11 @@ typedef struct NVMEQUEUESUBM
     SUPSEMEVENT                     hEvtProcess;
     /** Number of requests still active submitted from this queue. */
     volatile uint32_t               cReqsActive;
+    /** Flag whether the worker thread was notified about new entries already and
+     * hasn't picked them up yet, used to coalesce doorbell writes into a single wakeup. */
+    volatile bool                   fNotified;
     /** Alignment. */
-    uint32_t                        u32Alignment0;
+    bool                            afAlignment0[3];
 } NVMEQUEUESUBM;
 /** Pointer to the shared state of a submission queue. */
 typedef NVMEQUEUESUBM *PNVMEQUEUESUBM;
@@ -1684,14 +1742,27 @@ typedef struct NVMEINTRVEC
     volatile int32_t                cEvtsWaiting;
     /** Flag whether the interrupt vector is currently masked out. */
     volatile bool                   fIntrDisabled;
+    /** Flag whether the guest disabled interrupt coalescing for this vector. */
+    bool                            fCoalescingDisabled;
+    /** Flag whether the coalescing timer is armed. */
+    bool                            fCoalescingTimerArmed;
+    /** Alignment */
+    bool                            afAlignemnt0[1];
+    /** Number of events posted since the interrupt was signalled last. */
+    uint32_t                        cEvtsCoalesced;
     /** Alignment */
-    bool                            afAlignemnt0[3];
+    uint32_t                        u32Alignment1;
+    /** Timer signalling held back interrupts once the aggregation time elapsed. */
+    TMTIMERHANDLE                   hTimerCoalescing;
     /** PDM critical section protecting the interrupt vector. */
     PDMCRITSECT                     CritSectIntrVec;
 } NVMEINTRVEC;
 /** Pointer to a NVMe interrupt vector state. */
 typedef NVMEINTRVEC *PNVMEINTRVEC;
 
+/** Maximum number of guest pages an I/O request can have mapped for zero-copy access. */
+#define NVME_IOREQ_MAPPED_PAGES_MAX         32
+
 /**
  * NVMe I/O Request.
  */
@@ -1713,8 +1784,16 @@ typedef struct NVMEIOREQ
     uint32_t                        cbPrp;
     /** Flag when the buffer is mapped. */
     bool                            fMapped;
+    /** Flag whether this is a write zeroes request emulated with a zero filled write. */
+    bool                            fWriteZeroes;
+    /** Flag whether this is a read request (the guest buffer is written to). */
+    bool                            fRead;
     /** Page lock when the buffer is mapped. */
     PGMPAGEMAPLOCK                  PgLck;
+    /** Number of guest pages mapped through nvmeR3IoReqQuerySgBuf. */
+    uint32_t                        cPgLcksSg;
+    /** Page locks of the guest pages mapped through nvmeR3IoReqQuerySgBuf. */
+    PGMPAGEMAPLOCK                  aPgLcksSg[NVME_IOREQ_MAPPED_PAGES_MAX];
 } NVMEIOREQ;
 
 /**
@@ -1847,6 +1926,15 @@ typedef struct NVME
     uint32_t                        u32Alignment1;
     /** Interrupt vectors states. */
     NVMEINTRVEC                     aIntrVecs[NVME_INTR_VEC_MAX];
+    /** Interrupt coalescing aggregation threshold set by the guest (0's based). */
+    uint8_t                         uIntrCoalThr;
+    /** Interrupt coalescing aggregation time set by the guest in 100us units, 0 if disabled. */
+    uint8_t                         uIntrCoalTime;
+    /** Alignment. */
+    uint8_t                         abAlignment5[2];
+    /** Maximum number of microseconds adaptive host side coalescing holds back an
+     * interrupt, 0 if disabled.  Configured through CFGM. */
+    uint32_t                        cUsIntrCoalAdaptive;
     /** @} */
 
     /** @name Controller configuration (CC) register bits.
@@ -1897,6 +1985,21 @@ typedef struct NVME
 #endif
     /** @} */
 
+    /** @name Doorbell buffer config (shadow doorbell) related state.
+     * @{ */
+    /** Guest physical address of the shadow doorbell buffer, NIL_RTGCPHYS if not configured. */
+    RTGCPHYS                        GCPhysDbBufShadow;
+    /** Guest physical address of the EventIdx buffer, NIL_RTGCPHYS if not configured. */
+    RTGCPHYS                        GCPhysDbBufEvtIdx;
+    /** Number of microseconds a worker keeps polling the shadow doorbells before going to sleep,
+     * configured through CFGM. */
+    uint32_t                        cUsDbBufPoll;
+    /** Flag whether the I/O queues use the shadow doorbells. */
+    volatile bool                   fDbBufEnabled;
+    /** Alignment. */
+    bool                            afAlignment4[3];
+    /** @} */
+
     /** PCI Region \#0: MMIO */
     IOMMMIOHANDLE                   hMmio;
     /** PCI Region \#2: MMIO */
@@ -1908,6 +2011,34 @@ typedef struct NVME
     /** @name Statiscs related members.
      * @{ */
     NVMEPHYSTYPESTAT                aStatMemXfer[NVME_CMBSZ_SUPP_BIT_IDX_MAX+1];
+    /** Submission queue doorbell writes handled in R0/RC. */
+    STAMCOUNTER                     StatDoorbellSqRZ;
+    /** Submission queue doorbell writes handled in R3. */
+    STAMCOUNTER                     StatDoorbellSqR3;
+    /** Completion queue doorbell writes handled in R0/RC. */
+    STAMCOUNTER                     StatDoorbellCqRZ;
+    /** Completion queue doorbell writes handled in R3. */
+    STAMCOUNTER                     StatDoorbellCqR3;
+    /** Doorbell writes which had to be deferred to R3. */
+    STAMCOUNTER                     StatDoorbellToR3;
+    /** Number of worker thread wakeups caused by doorbell writes. */
+    STAMCOUNTER                     StatWrkThrdWakeups;
+    /** Number of doorbell writes coalesced with an already pending wakeup. */
+    STAMCOUNTER                     StatWrkThrdWakeupsCoalesced;
+    /** Submission queue tail updates picked up from the shadow doorbell buffer. */
+    STAMCOUNTER                     StatDbBufSqTail;
+    /** Shadow doorbell polls which found new commands. */
+    STAMCOUNTER                     StatDbBufPollHits;
+    /** Shadow doorbell polls which timed out. */
+    STAMCOUNTER                     StatDbBufPollTimeouts;
+    /** Number of interrupts signalled for completions. */
+    STAMCOUNTER                     StatIntrSignalled;
+    /** Number of completions whose interrupt was held back. */
+    STAMCOUNTER                     StatIntrDeferred;
+    /** Number of held back interrupts signalled by the coalescing timer. */
+    STAMCOUNTER                     StatIntrCoalescingTimeouts;
+    /** Completions per signalled interrupt. */
+    STAMPROFILE                     StatIntrCompletionsPerIntr;
     /** @} */
 #endif
 
@@ -2296,6 +2427,29 @@ static void nvmeIntrUpdate(PPDMDEVINS pDevIns, uint32_t u32IntrVec, bool fSet)
     }
 }
 
+/**
+ * Updates the state of several interrupt vectors at once.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   bmIntrVecs  Bitmap of the interrupt vectors to update.
+ * @param   fSet        Flag whether to set the interrupts or clear them.
+ */
+static void nvmeIntrUpdateMulti(PPDMDEVINS pDevIns, uint32_t bmIntrVecs, bool fSet)
+{
+    AssertCompile(NVME_INTR_VEC_MAX == 32);
+    if (!bmIntrVecs)
+        return;
+
+    if (RT_IS_POWER_OF_TWO(bmIntrVecs))
+        nvmeIntrUpdate(pDevIns, ASMBitFirstSetU32(bmIntrVecs) - 1, fSet);
+    else
+    {
+        Log4(("%s interrupts on vectors %#RX32\n", fSet ? "Setting" : "Clearing", bmIntrVecs));
+        PDMDevHlpPCISetIrqMulti(pDevIns, NULL /* pPciDev */, &bmIntrVecs, NVME_INTR_VEC_MAX,
+                                fSet ? PDM_IRQ_LEVEL_HIGH : PDM_IRQ_LEVEL_LOW);
+    }
+}
+
 /**
  * Locks the interrupt vector state.
  *
@@ -2326,6 +2480,57 @@ DECLINLINE(void) nvmeIntrVecUnlock(PPDMDEVINS pDevIns, PNVME pThis, uint32_t u32
 
 
 #ifdef IN_RING3
+/**
+ * Signals the interrupt of the given vector for all events posted so far.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The NVMe controller shared instance data.
+ * @param   u32IntrVec  The interrupt vector, locked.
+ */
+static void nvmeR3IntrVecSignal(PPDMDEVINS pDevIns, PNVME pThis, uint32_t u32IntrVec)
+{
+    PNVMEINTRVEC pIntr = &pThis->aIntrVecs[u32IntrVec];
+
+    STAM_COUNTER_INC(&pThis->StatIntrSignalled);
+    STAM_PROFILE_ADD_PERIOD(&pThis->StatIntrCompletionsPerIntr, pIntr->cEvtsCoalesced);
+    pIntr->cEvtsCoalesced = 0;
+    nvmeIntrUpdate(pDevIns, u32IntrVec, true);
+}
+
+/**
+ * Decides how long the interrupt of the given vector may be held back to
+ * coalesce it with further completions.
+ *
+ * The guest configured aggregation threshold and time take precedence, the
+ * adaptive host side mode only holds back interrupts while more completions
+ * for the submission queue are on their way.
+ *
+ * @returns Number of microseconds the interrupt may be held back at most,
+ *          0 if it has to be signalled right away.
+ * @param   pThis       The NVMe controller shared instance data.
+ * @param   pIntr       The interrupt vector state, locked.
+ * @param   fMore       Flag whether more completions are expected shortly.
+ */
+static uint32_t nvmeR3IntrVecCoalescingDelay(PNVME pThis, PNVMEINTRVEC pIntr, bool fMore)
+{
+    if (pIntr->fCoalescingDisabled)
+        return 0;
+
+    if (pThis->uIntrCoalTime)
+    {
+        if (pIntr->cEvtsCoalesced > pThis->uIntrCoalThr) /* 0's based. */
+            return 0;
+        return pThis->uIntrCoalTime * NVME_FEAT_INTR_COAL_TIME_UNIT_US;
+    }
+
+    if (   pThis->cUsIntrCoalAdaptive
+        && fMore
+        && pIntr->cEvtsCoalesced < NVME_INTR_COAL_ADAPTIVE_EVTS_MAX)
+        return pThis->cUsIntrCoalAdaptive;
+
+    return 0;
+}
+
 /**
  * Posts the given number of events and updates the interrupt state of the given
  * interrupt vector.
@@ -2334,8 +2539,12 @@ DECLINLINE(void) nvmeIntrVecUnlock(PPDMDEVINS pDevIns, PNVME pThis, uint32_t u32
  * @param   pThis       The NVMe controller shared instance data.
  * @param   u32IntrVec  The interrupt vector.
  * @param   cEvts       Number of events.
+ * @param   fCoalesce   Flag whether the interrupt may be coalesced, false for
+ *                      admin completion queue entries.
+ * @param   fMore       Flag whether more completions are expected shortly.
  */
-static void nvmeIntrVecPostEvents(PPDMDEVINS pDevIns, PNVME pThis, uint32_t u32IntrVec, int32_t cEvts)
+static void nvmeIntrVecPostEvents(PPDMDEVINS pDevIns, PNVME pThis, uint32_t u32IntrVec, int32_t cEvts,
+                                  bool fCoalesce, bool fMore)
 {
     PNVMEINTRVEC pIntr = &pThis->aIntrVecs[u32IntrVec];
 
@@ -2349,7 +2558,51 @@ static void nvmeIntrVecPostEvents(PPDMDEVINS pDevIns, PNVME pThis, uint32_t u32I
 
     if (   cEvtsOld + cEvts > 0
         && !pIntr->fIntrDisabled)
-        nvmeIntrUpdate(pDevIns, u32IntrVec, true);
+    {
+        pIntr->cEvtsCoalesced += cEvts;
+
+        uint32_t const cUsDelay = fCoalesce ? nvmeR3IntrVecCoalescingDelay(pThis, pIntr, fMore) : 0;
+        if (!cUsDelay)
+            nvmeR3IntrVecSignal(pDevIns, pThis, u32IntrVec);
+        else
+        {
+            STAM_COUNTER_INC(&pThis->StatIntrDeferred);
+            if (!pIntr->fCoalescingTimerArmed)
+            {
+                pIntr->fCoalescingTimerArmed = true;
+                PDMDevHlpTimerSetMicro(pDevIns, pIntr->hTimerCoalescing, cUsDelay);
+            }
+        }
+    }
+
+    nvmeIntrVecUnlock(pDevIns, pThis, u32IntrVec);
+}
+
+/**
+ * @callback_method_impl{FNTMTIMERDEV, Signals held back interrupts once the
+ *                      aggregation time elapsed.}
+ */
+static DECLCALLBACK(void) nvmeR3IntrCoalescingTimer(PPDMDEVINS pDevIns, TMTIMERHANDLE hTimer, void *pvUser)
+{
+    PNVME          pThis      = PDMDEVINS_2_DATA(pDevIns, PNVME);
+    uint32_t const u32IntrVec = (uint32_t)(uintptr_t)pvUser;
+    AssertReturnVoid(u32IntrVec < RT_ELEMENTS(pThis->aIntrVecs));
+    PNVMEINTRVEC   pIntr      = &pThis->aIntrVecs[u32IntrVec];
+    RT_NOREF(hTimer);
+
+    int const rcLock = nvmeIntrVecLock(pDevIns, pThis, u32IntrVec, VERR_IGNORED);
+    PDM_CRITSECT_RELEASE_ASSERT_RC_DEV(pDevIns, &pIntr->CritSectIntrVec, rcLock);
+
+    pIntr->fCoalescingTimerArmed = false;
+    if (   pIntr->cEvtsCoalesced
+        && ASMAtomicReadS32(&pIntr->cEvtsWaiting) > 0
+        && !pIntr->fIntrDisabled)
+    {
+        STAM_COUNTER_INC(&pThis->StatIntrCoalescingTimeouts);
+        nvmeR3IntrVecSignal(pDevIns, pThis, u32IntrVec);
+    }
+    else
+        pIntr->cEvtsCoalesced = 0;
 
     nvmeIntrVecUnlock(pDevIns, pThis, u32IntrVec);
 }
@@ -2373,9 +2626,13 @@ static void nvmeIntrVecCompleteEvents(PPDMDEVINS pDevIns, PNVME pThis, uint32_t
     LogFlowFunc(("Completed %d events (%d waiting on interrupter to complete)\n",
                   cEvts, cEvtsOld - cEvts));
 
-    if (   cEvtsOld - cEvts <= 0
-        && !pIntr->fIntrDisabled)
-        nvmeIntrUpdate(pDevIns, u32IntrVec, false);
+    if (cEvtsOld - cEvts <= 0)
+    {
+        /* The guest caught up with everything, nothing left to signal for a held back interrupt. */
+        pIntr->cEvtsCoalesced = 0;
+        if (!pIntr->fIntrDisabled)
+            nvmeIntrUpdate(pDevIns, u32IntrVec, false);
+    }
 }
 
 /**
@@ -2458,13 +2715,15 @@ static VBOXSTRICTRC HcIntrMaskSet_w(PPDMDEVINS pDevIns, PNVME pThis, uint32_t iR
     if (!nvmeIsMSIEnabled(pDevIns->apPciDevs[0]))
         u32Mask |= 0x1;
 
+    uint32_t bmIntrVecs = 0;
     for (uint32_t idxIntrVec = 0; idxIntrVec < NVME_INTR_VEC_MAX; idxIntrVec++)
     {
         if (   u32Mask & RT_BIT_32(idxIntrVec)
             && !ASMAtomicXchgBool(&pThis->aIntrVecs[idxIntrVec].fIntrDisabled, true)
             && ASMAtomicReadS32(&pThis->aIntrVecs[idxIntrVec].cEvtsWaiting) > 0)
-            nvmeIntrUpdate(pDevIns, idxIntrVec, false /* fSet */);
+            bmIntrVecs |= RT_BIT_32(idxIntrVec);
     }
+    nvmeIntrUpdateMulti(pDevIns, bmIntrVecs, false /* fSet */);
     ASMAtomicOrU32(&pThis->u32IntrMask, u32Mask);
     return VINF_SUCCESS;
 }
@@ -2491,14 +2750,16 @@ static VBOXSTRICTRC HcIntrMaskClr_w(PPDMDEVINS pDevIns, PNVME pThis, uint32_t iR
     if (!nvmeIsMSIEnabled(pDevIns->apPciDevs[0]))
         u32Mask |= 0x1;
 
+    uint32_t bmIntrVecs = 0;
     for (uint32_t idxIntrVec = 0; idxIntrVec < NVME_INTR_VEC_MAX; idxIntrVec++)
     {
         /* Set the interrupt if the vector was unmasked and has an interrupt pending. */
         if (   u32Mask & RT_BIT_32(idxIntrVec)
             && ASMAtomicXchgBool(&pThis->aIntrVecs[idxIntrVec].fIntrDisabled, false)
             && ASMAtomicReadS32(&pThis->aIntrVecs[idxIntrVec].cEvtsWaiting) > 0)
-            nvmeIntrUpdate(pDevIns, idxIntrVec, true /* fSet */);
+            bmIntrVecs |= RT_BIT_32(idxIntrVec);
     }
+    nvmeIntrUpdateMulti(pDevIns, bmIntrVecs, true /* fSet */);
     ASMAtomicAndU32(&pThis->u32IntrMask, ~u32Mask);
     return VINF_SUCCESS;
 }
@@ -2813,6 +3074,23 @@ static VBOXSTRICTRC HcCtrlMemBufSize_r(PPDMDEVINS pDevIns, PNVME pThis, uint32_t
     return VINF_SUCCESS;
 }
 
+/**
+ * Returns whether the given queue uses the shadow doorbell buffers.
+ *
+ * The admin queues always use the doorbell registers, as do queues whose
+ * entries don't fit into the single page buffers.
+ *
+ * @returns true if the shadow doorbell buffers are used, false otherwise.
+ * @param   pThis       The NVMe controller shared instance data.
+ * @param   iQueueId    The queue ID.
+ */
+DECLINLINE(bool) nvmeDbBufIsActive(PNVME pThis, uint32_t iQueueId)
+{
+    return    iQueueId != NVME_ADM_QUEUE_ID
+           && ASMAtomicReadBool(&pThis->fDbBufEnabled)
+           && NVME_DBBUF_OFF_CQ(iQueueId) + sizeof(uint32_t) <= pThis->cbPage;
+}
+
 /**
  * Write to a submission queue doorbell register.
  *
@@ -2833,17 +3111,35 @@ static VBOXSTRICTRC nvmeQueueSubmWrite(PPDMDEVINS pDevIns, PNVME pThis, uint32_t
 
         if (RT_LIKELY(ASMAtomicUoReadU32((volatile uint32_t *)&pQueue->Hdr.enmState) == NVMEQUEUESTATE_ALLOCATED))
         {
+            bool const fDbBuf = nvmeDbBufIsActive(pThis, iQueueId);
             if (RT_LIKELY(   u32Tail < pQueue->Hdr.cEntries
-                          && u32Tail != pQueue->Hdr.idxTail))
+                          && (fDbBuf || u32Tail != pQueue->Hdr.idxTail)))
             {
-                ASMAtomicWriteU32(&pQueue->Hdr.idxTail, u32Tail);
-                int rc = PDMDevHlpSUPSemEventSignal(pDevIns, pQueue->hEvtProcess);
-                if (RT_FAILURE(rc))
-                    nvmeStateSetFatalError(pThis);
+                STAM_COUNTER_INC(&pThis->CTX_SUFF_Z(StatDoorbellSq));
+
+                /* With shadow doorbells the worker owns the tail and takes it from the shadow buffer. */
+                if (!fDbBuf)
+                    ASMAtomicWriteU32(&pQueue->Hdr.idxTail, u32Tail);
+
+                /*
+                 * Only wake up the worker if it wasn't notified already, it will pick up
+                 * the new tail along with the previous one.  The worker clears the flag
+                 * before walking the queue so a tail update racing with it can't get lost.
+                 */
+                if (!ASMAtomicXchgBool(&pQueue->fNotified, true))
+                {
+                    STAM_COUNTER_INC(&pThis->StatWrkThrdWakeups);
+                    int rc = PDMDevHlpSUPSemEventSignal(pDevIns, pQueue->hEvtProcess);
+                    if (RT_FAILURE(rc))
+                        nvmeStateSetFatalError(pThis);
+                }
+                else
+                    STAM_COUNTER_INC(&pThis->StatWrkThrdWakeupsCoalesced);
             }
             else
             {
 #ifndef IN_RING3
+                STAM_COUNTER_INC(&pThis->StatDoorbellToR3);
                 return VINF_IOM_R3_MMIO_WRITE;
 #else
                 /* Notify the guest about the invalid write. */
@@ -2855,6 +3151,7 @@ static VBOXSTRICTRC nvmeQueueSubmWrite(PPDMDEVINS pDevIns, PNVME pThis, uint32_t
         else if (iQueueId == NVME_ADM_QUEUE_ID)
         {
 #ifndef IN_RING3
+            STAM_COUNTER_INC(&pThis->StatDoorbellToR3);
             return VINF_IOM_R3_MMIO_WRITE;
 #else
             /* Notify the guest about the invalid write. */
@@ -2896,7 +3193,10 @@ static VBOXSTRICTRC nvmeQueueCompWrite(PPDMDEVINS pDevIns, PNVME pThis, uint32_t
              * happen frequently (any checked OS will not overload the queues).
              */
             if (RT_UNLIKELY(pQueue->cWaiters))
+            {
+                STAM_COUNTER_INC(&pThis->StatDoorbellToR3);
                 return VINF_IOM_R3_MMIO_WRITE;
+            }
 #endif
 
             /* Lock the interrupt vector if the queue can generate interrupts. */
@@ -2904,9 +3204,14 @@ static VBOXSTRICTRC nvmeQueueCompWrite(PPDMDEVINS pDevIns, PNVME pThis, uint32_t
             {
                 int rc = nvmeIntrVecLock(pDevIns, pThis, pQueue->u32IntrVec, VINF_IOM_R3_MMIO_WRITE);
                 if (rc != VINF_SUCCESS)
+                {
+                    STAM_COUNTER_INC(&pThis->StatDoorbellToR3);
                     return rc;
+                }
             }
 
+            STAM_COUNTER_INC(&pThis->CTX_SUFF_Z(StatDoorbellCq));
+
             if (RT_LIKELY(   u32Head < pQueue->Hdr.cEntries
                           && u32Head != pQueue->Hdr.idxHead))
             {
@@ -2928,6 +3233,14 @@ static VBOXSTRICTRC nvmeQueueCompWrite(PPDMDEVINS pDevIns, PNVME pThis, uint32_t
                 {
                     uint32_t cCqEntriesCompleted = nvmeQueueConsumerSet(&pQueue->Hdr, u32Head);
 
+                    /*
+                     * Move the EventIdx along with the head so the guest keeps ringing the doorbell
+                     * for every head update, the interrupt accounting depends on it.
+                     */
+                    if (nvmeDbBufIsActive(pThis, iQueueId))
+                        PDMDevHlpPCIPhysWrite(pDevIns, pThis->GCPhysDbBufEvtIdx + NVME_DBBUF_OFF_CQ(iQueueId),
+                                              &u32Head, sizeof(u32Head));
+
                     if (pQueue->fIntrEnabled)
                         nvmeIntrVecCompleteEvents(pDevIns, pThis, pQueue->u32IntrVec, cCqEntriesCompleted);
                     else
@@ -3003,6 +3316,7 @@ static VBOXSTRICTRC nvmeQueueCompWrite(PPDMDEVINS pDevIns, PNVME pThis, uint32_t
         else
         {
 #ifndef IN_RING3
+            STAM_COUNTER_INC(&pThis->StatDoorbellToR3);
             return VINF_IOM_R3_MMIO_WRITE;
 #else
             /* Notify the guest about the invalid write. */
@@ -3371,6 +3685,9 @@ static void nvmeR3CmdHdrDump(PNVMEWRKTHRD pWrkThrd, PNVMECMDHDR pHdr, bool fCmdA
             case NVME_CMD_ADM_OPC_NS_ATTACHMENT:
                 pszCmd = "Namespace Attachment";
                 break;
+            case NVME_CMD_ADM_OPC_DBBUF_CFG:
+                pszCmd = "Doorbell Buffer Config";
+                break;
             default:
                 pszCmd = "<Invalid Command Opcode>";
         }
@@ -3388,6 +3705,9 @@ static void nvmeR3CmdHdrDump(PNVMEWRKTHRD pWrkThrd, PNVMECMDHDR pHdr, bool fCmdA
             case NVME_CMD_NVM_READ:
                 pszCmd = "Read";
                 break;
+            case NVME_CMD_NVM_WRITE_ZEROES:
+                pszCmd = "Write Zeroes";
+                break;
             default:
                 pszCmd = "<Invalid/Unsupported Command Opcode>";
         }
@@ -3499,6 +3819,33 @@ static int nvmeR3PhysRead(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC,
     return PDMDevHlpPCIPhysRead(pDevIns, GCPhysAddr, pv, cb);
 }
 
+/**
+ * Reads from the given guest physical address thru the worker mapping cache,
+ * fetching the data from the controller memory buffer if enabled.
+ *
+ * @returns VBox status code.
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The NVMe controller shared instance data.
+ * @param   pThisCC     The NVMe controller ring-3 instance data.
+ * @param   pWrkThrd    The worker thread doing the read.
+ * @param   GCPhysAddr  The guest physical address to read from.
+ * @param   pv          Where to store the data.
+ * @param   cb          How many bytes to read.
+ * @param   u32Type     The type of memory read (CQ, SQ, Lists, Data).
+ */
+static int nvmeR3WrkThrdPhysRead(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC, PNVMEWRKTHRD pWrkThrd,
+                                 RTGCPHYS GCPhysAddr, void *pv, size_t cb, uint32_t u32Type)
+{
+    if (   pWrkThrd->pPhysMapCache
+        && (   pThis->cbCtrlMemBuf == 0
+            || pThis->GCPhysCtrlMemBuf == NIL_RTGCPHYS))
+    {
+        STAM_COUNTER_ADD(&pThis->aStatMemXfer[u32Type].StatReadGuestMem, cb);
+        return PDMDevHlpPhysMapCacheRead(pDevIns, pWrkThrd->pPhysMapCache, GCPhysAddr, pv, cb);
+    }
+    return nvmeR3PhysRead(pDevIns, pThis, pThisCC, GCPhysAddr, pv, cb, u32Type);
+}
+
 /**
  * Writes data to the given guest physical address, taking the controller memory
  * buffer into account.
@@ -3582,7 +3929,9 @@ static int nvmeR3CompQueueEntryPost(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pTh
     int rc = nvmeR3PhysWrite(pDevIns, pThis, pThisCC, GCPhysCe, &Ce, sizeof(Ce), NVME_CMBSZ_CQS_BIT_IDX);
     if (   RT_SUCCESS(rc)
         && pQueueComp->fIntrEnabled)
-        nvmeIntrVecPostEvents(pDevIns, pThis, pQueueComp->u32IntrVec, 1);
+        nvmeIntrVecPostEvents(pDevIns, pThis, pQueueComp->u32IntrVec, 1,
+                              pQueueComp->Hdr.u16Id != NVME_ADM_QUEUE_ID /* fCoalesce */,
+                              ASMAtomicReadU32(&pQueueSubm->cReqsActive) > 0 /* fMore */);
 
     return rc;
 }
@@ -4182,6 +4531,20 @@ static NVMEQUEUESUBMPRIO nvmeR3CmdAdminSqCreatePrio2Enum(uint8_t uPrio)
     return enmPrio;
 }
 
+/**
+ * Initializes an entry in the shadow doorbell and EventIdx buffers.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The NVMe controller shared instance data.
+ * @param   offEntry    Offset of the entry in the buffers.
+ * @param   u32Val      The value to initialize the entries with.
+ */
+static void nvmeR3DbBufInitEntry(PPDMDEVINS pDevIns, PNVME pThis, uint32_t offEntry, uint32_t u32Val)
+{
+    PDMDevHlpPCIPhysWrite(pDevIns, pThis->GCPhysDbBufShadow + offEntry, &u32Val, sizeof(u32Val));
+    PDMDevHlpPCIPhysWrite(pDevIns, pThis->GCPhysDbBufEvtIdx + offEntry, &u32Val, sizeof(u32Val));
+}
+
 /**
  * Processes a "Create I/O submission queue" command.
  *
@@ -4252,6 +4615,9 @@ static int nvmeR3CmdAdminProcessSqCreate(PPDMDEVINS pDevIns, PNVME pThis, PNVMEC
     pIoQueueSubm->enmPriority          = enmPrio;
     pIoQueueSubm->cReqsActive          = 0;
 
+    if (nvmeDbBufIsActive(pThis, u16SqId))
+        nvmeR3DbBufInitEntry(pDevIns, pThis, NVME_DBBUF_OFF_SQ(u16SqId), 0);
+
     ASMAtomicWriteU32((volatile uint32_t *)&pIoQueueSubm->Hdr.enmState, NVMEQUEUESTATE_ALLOCATED);
     int rc = nvmeR3SubmQueueAssignToWorker(pDevIns, pThis, pThisCC, pIoQueueSubm, &pThisCC->aQueuesSubm[u16SqId]);
     if (RT_FAILURE(rc))
@@ -4433,6 +4799,9 @@ static int nvmeR3CmdAdminProcessCqCreate(PPDMDEVINS pDevIns, PNVME pThis, PNVMEC
     pIoQueueComp->fOverloaded          = false;
     RTListInit(&pIoQueueCompR3->LstCompletionsWaiting);
 
+    if (nvmeDbBufIsActive(pThis, u16CqId))
+        nvmeR3DbBufInitEntry(pDevIns, pThis, NVME_DBBUF_OFF_CQ(u16CqId), 0);
+
     ASMAtomicWriteU32((volatile uint32_t *)&pIoQueueComp->Hdr.enmState, NVMEQUEUESTATE_ALLOCATED);
 
     return nvmeR3CmdCompleteWithSuccess(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm->u.Field.Hdr.u16Cid,
@@ -4513,7 +4882,7 @@ static bool nvmeR3IdentifyCtrl(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC,
     IdCtrl.u32Rtd3ResumeLat      = 1; /* Must be non-zero for 1.2 compliant devices. */
     IdCtrl.u32Rtd3EntryLat       = 1; /* Must be non-zero for 1.2 compliant devices. */
     IdCtrl.u32OptAsyncEvtsSupported = 0; /* Optional Asynchronous Events not supported */
-    IdCtrl.u16OptAdmCmdSupported    = 0; /* Optional admin commands not supported */
+    IdCtrl.u16OptAdmCmdSupported    = NVME_CMD_ADM_OACS_DBBUF_CFG; /* Only the doorbell buffer config command is supported */
     IdCtrl.u8AbrtCmdLimit           = 4; /* Recommendation from the spec but in theory unlimited for our implementation */
     IdCtrl.u8AsyncEvtReqLimit       = RT_MIN(pThisCC->cAsyncEvtReqsMax - 1, 0xff); /* Zero based limit. */
     IdCtrl.u8FwUpdates              = (1 << 1) | RT_BIT(1); /* Only one firmware slot supported, slot 0 is readonly => no firmware upgrade possible */
@@ -4535,7 +4904,7 @@ static bool nvmeR3IdentifyCtrl(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC,
     IdCtrl.u8SubmQueueEntSz             = (6 << 4) | 6; /* Maximum and preferred size, in 2^n (64 bytes) */
     IdCtrl.u8CompQueueEntSz             = (4 << 4) | 4; /* Maximum and preferred size, in 2^n (16 bytes) */
     IdCtrl.u32Namespaces                = pThis->cNamespaces;
-    IdCtrl.u16OptNvmCmdSupported        = 0; /* No optional NVM command set supported */
+    IdCtrl.u16OptNvmCmdSupported        = NVME_ONCS_WRITE_ZEROES; /* Emulated with a zero filled write if the driver can't do it. */
     IdCtrl.u16FusedOpSupported          = 0; /* Fused operations are not supported */
     IdCtrl.u8NvmFmtAttr                 = 0; /* No special NVM format options supported */
     IdCtrl.u8VolWriteCache              = 0; /* No volatile write cache present. */
@@ -4800,6 +5169,64 @@ static int nvmeR3CmdAdminProcessAbort(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC p
     return rc;
 }
 
+/**
+ * Processes a "Doorbell Buffer Config" command.
+ *
+ * @returns VBox status code.
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The NVMe controller shared instance data.
+ * @param   pThisCC     The NVMe controller ring-3 instance data.
+ * @param   pQueueSubm  The submission queue responsible for this command.
+ * @param   pCmdAdm     The admin command to process.
+ */
+static int nvmeR3CmdAdminProcessDbBufCfg(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC,
+                                         PNVMEQUEUESUBM pQueueSubm, PNVMECMDADM pCmdAdm)
+{
+    NVMEPRP const PrpShadow = pCmdAdm->u.Field.Prp1;
+    NVMEPRP const PrpEvtIdx = pCmdAdm->u.Field.Prp2;
+
+    /* Both buffers are a single memory page and must be page aligned. */
+    if (   !PrpShadow
+        || !PrpEvtIdx
+        || !NVME_PRP_IS_PAGE_ALIGNED(PrpShadow, pThis->uMpsSet)
+        || !NVME_PRP_IS_PAGE_ALIGNED(PrpEvtIdx, pThis->uMpsSet))
+        return nvmeR3CmdCompleteWithStatus(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm->u.Field.Hdr.u16Cid,
+                                           NVME_CQ_ENTRY_SCT_CMD_GENERIC, NVME_CQ_ENTRY_SC_GEN_INV_CMD_FIELD,
+                                           0, false /* fMore */, true /* fDnr */);
+
+    ASMAtomicWriteBool(&pThis->fDbBufEnabled, false);
+    pThis->GCPhysDbBufShadow = NVME_PRP_TO_GCPHYS(PrpShadow, pThis->uMpsSet);
+    pThis->GCPhysDbBufEvtIdx = NVME_PRP_TO_GCPHYS(PrpEvtIdx, pThis->uMpsSet);
+
+    /*
+     * Stop taking submission queue tails from the doorbell registers before seeding
+     * the buffers with the current state of the existing I/O queues.
+     */
+    ASMAtomicWriteBool(&pThis->fDbBufEnabled, true);
+
+    for (uint32_t i = 1; i < pThis->cQueuesSubmMax; i++)
+    {
+        PNVMEQUEUESUBM pIoQueueSubm = &pThis->aQueuesSubm[i];
+        if (   ASMAtomicReadU32((volatile uint32_t *)&pIoQueueSubm->Hdr.enmState) == NVMEQUEUESTATE_ALLOCATED
+            && nvmeDbBufIsActive(pThis, i))
+            nvmeR3DbBufInitEntry(pDevIns, pThis, NVME_DBBUF_OFF_SQ(i), ASMAtomicReadU32(&pIoQueueSubm->Hdr.idxTail));
+    }
+
+    for (uint32_t i = 1; i < pThis->cQueuesCompMax; i++)
+    {
+        PNVMEQUEUECOMP pIoQueueComp = &pThis->aQueuesComp[i];
+        if (   ASMAtomicReadU32((volatile uint32_t *)&pIoQueueComp->Hdr.enmState) == NVMEQUEUESTATE_ALLOCATED
+            && nvmeDbBufIsActive(pThis, i))
+            nvmeR3DbBufInitEntry(pDevIns, pThis, NVME_DBBUF_OFF_CQ(i), ASMAtomicReadU32(&pIoQueueComp->Hdr.idxHead));
+    }
+
+    LogRel(("NVMe#%u: Shadow doorbells enabled (shadow=%RGp eventidx=%RGp)\n", pDevIns->iInstance,
+            pThis->GCPhysDbBufShadow, pThis->GCPhysDbBufEvtIdx));
+
+    return nvmeR3CmdCompleteWithSuccess(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm->u.Field.Hdr.u16Cid,
+                                        0 /* Command specific */);
+}
+
 /**
  * Processes a "Set Features" command.
  *
@@ -4835,6 +5262,25 @@ static int nvmeR3CmdAdminProcessSetFeatures(PPDMDEVINS pDevIns, PNVME pThis, PNV
             /* Nothing to do as the we don't generate any events which can be configured here. */
             rc = nvmeR3CmdCompleteWithSuccess(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm->u.Field.Hdr.u16Cid, 0);
             break;
+        case NVME_FEAT_ID_INTERRUPT_COALESCING:
+            /* Takes effect with the next completion, already held back interrupts are signalled by the timer. */
+            pThis->uIntrCoalThr  = NVME_FEAT_INTR_COAL_THR_GET(pCmdAdm->u.au32[11]);
+            pThis->uIntrCoalTime = NVME_FEAT_INTR_COAL_TIME_GET(pCmdAdm->u.au32[11]);
+            LogRel(("NVMe#%u: Interrupt coalescing set to threshold=%u time=%uus\n", pDevIns->iInstance,
+                    pThis->uIntrCoalThr + 1, pThis->uIntrCoalTime * NVME_FEAT_INTR_COAL_TIME_UNIT_US));
+            rc = nvmeR3CmdCompleteWithSuccess(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm->u.Field.Hdr.u16Cid, 0);
+            break;
+        case NVME_FEAT_ID_INTERRUPT_VEC_CFG:
+        {
+            uint16_t const uIntrVec = NVME_FEAT_INTR_VEC_CFG_IV_GET(pCmdAdm->u.au32[11]);
+            if (uIntrVec >= RT_ELEMENTS(pThis->aIntrVecs))
+                return nvmeR3CmdCompleteWithStatus(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm->u.Field.Hdr.u16Cid,
+                                                   NVME_CQ_ENTRY_SCT_CMD_GENERIC, NVME_CQ_ENTRY_SC_GEN_INV_CMD_FIELD,
+                                                   0, false /* fMore */, true /* fDnr */);
+            pThis->aIntrVecs[uIntrVec].fCoalescingDisabled = RT_BOOL(pCmdAdm->u.au32[11] & NVME_FEAT_INTR_VEC_CFG_CD);
+            rc = nvmeR3CmdCompleteWithSuccess(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm->u.Field.Hdr.u16Cid, 0);
+            break;
+        }
         default: /* All other features are not changeable at the moment. */
             rc = nvmeR3CmdCompleteWithStatus(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm->u.Field.Hdr.u16Cid,
                                              NVME_CQ_ENTRY_SCT_CMD_SPECIFIC, NVME_CQ_ENTRY_SC_CMD_FEAT_NOT_CHANGEABLE,
@@ -4868,13 +5314,13 @@ static int nvmeR3CmdAdminProcessGetFeatures(PPDMDEVINS pDevIns, PNVME pThis, PNV
             case NVME_FEAT_ID_POWER_MGMT:
             case NVME_FEAT_ID_TEMP_THRESHOLD:
             case NVME_FEAT_ID_ERROR_RECOVERY:
-            case NVME_FEAT_ID_INTERRUPT_COALESCING:
-            case NVME_FEAT_ID_INTERRUPT_VEC_CFG:
             case NVME_FEAT_ID_WRITE_ATOMICITY_NORMAL:
             case NVME_FEAT_ID_ASYNC_EVT_CFG:
                 u32CmdSpecific = 0; /* Feature is not changeable, saveable and applies to complete controller. */
                 break;
             case NVME_FEAT_ID_NUMBER_OF_QUEUES:
+            case NVME_FEAT_ID_INTERRUPT_COALESCING:
+            case NVME_FEAT_ID_INTERRUPT_VEC_CFG:
                 u32CmdSpecific = RT_BIT(2); /* Feature is changeable. */
                 break;
             default:
@@ -4899,9 +5345,20 @@ static int nvmeR3CmdAdminProcessGetFeatures(PPDMDEVINS pDevIns, PNVME pThis, PNV
                 u32CmdSpecific = ((uint32_t)pThis->cQueuesCompMax << 16) | pThis->cQueuesSubmMax;
                 break;
             case NVME_FEAT_ID_INTERRUPT_COALESCING:
+                u32CmdSpecific = NVME_FEAT_INTR_COAL_MAKE(pThis->uIntrCoalThr, pThis->uIntrCoalTime);
                 break;
             case NVME_FEAT_ID_INTERRUPT_VEC_CFG:
+            {
+                uint16_t const uIntrVec = NVME_FEAT_INTR_VEC_CFG_IV_GET(pCmdAdm->u.au32[11]);
+                if (uIntrVec >= RT_ELEMENTS(pThis->aIntrVecs))
+                    return nvmeR3CmdCompleteWithStatus(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm->u.Field.Hdr.u16Cid,
+                                                       NVME_CQ_ENTRY_SCT_CMD_GENERIC, NVME_CQ_ENTRY_SC_GEN_INV_CMD_FIELD,
+                                                       0, false /* fMore */, true /* fDnr */);
+                u32CmdSpecific = uIntrVec;
+                if (pThis->aIntrVecs[uIntrVec].fCoalescingDisabled)
+                    u32CmdSpecific |= NVME_FEAT_INTR_VEC_CFG_CD;
                 break;
+            }
             case NVME_FEAT_ID_WRITE_ATOMICITY_NORMAL:
                 break;
             case NVME_FEAT_ID_ASYNC_EVT_CFG:
@@ -5001,6 +5458,9 @@ static int nvmeR3CmdAdminProcess(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisC
         case NVME_CMD_ADM_OPC_ASYNC_EVT_REQ:
             rc = nvmeR3CmdAdminProcessAsyncEvtReq(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm);
             break;
+        case NVME_CMD_ADM_OPC_DBBUF_CFG:
+            rc = nvmeR3CmdAdminProcessDbBufCfg(pDevIns, pThis, pThisCC, pQueueSubm, pCmdAdm);
+            break;
         case NVME_CMD_ADM_OPC_NS_MGMT:
         case NVME_CMD_ADM_OPC_FW_COMMIT:
         case NVME_CMD_ADM_OPC_FW_IMG_DWNLD:
@@ -5048,6 +5508,9 @@ static PNVMEIOREQ nvmeR3IoReqAlloc(PNVMENAMESPACE pNamespace,
         pIoReq->Prp2          = Prp2;
         pIoReq->cbPrp         = cbPrp;
         pIoReq->fMapped       = false;
+        pIoReq->fWriteZeroes  = false;
+        pIoReq->fRead         = false;
+        pIoReq->cPgLcksSg     = 0;
     }
     else
         LogFlowFunc(("Failed to allocate I/O request with %Rrc\n", rc));
@@ -5093,6 +5556,8 @@ static void nvmeR3IoReqComplete(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC
 
     if (pIoReq->fMapped)
         PDMDevHlpPhysReleasePageMappingLock(pDevIns, &pIoReq->PgLck);
+    if (pIoReq->cPgLcksSg)
+        PDMDevHlpPhysBulkReleasePageMappingLocks(pDevIns, pIoReq->cPgLcksSg, &pIoReq->aPgLcksSg[0]);
 
     nvmeR3IoReqFree(pNamespace, pIoReq);
 
@@ -5153,9 +5618,23 @@ static void nvmeR3IoReqSubmit(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC,
     else if (enmType == PDMMEDIAEXIOREQTYPE_READ)
     {
         pNamespace->Led.Asserted.s.fReading = pNamespace->Led.Actual.s.fReading = 1;
+        pIoReq->fRead = true;
         rc = pNamespace->pDrvMediaEx->pfnIoReqRead(pNamespace->pDrvMediaEx, pIoReq->hIoReq,
                                                    offStart, cbReq);
     }
+    else if (enmType == PDMMEDIAEXIOREQTYPE_WRITE_ZEROES)
+    {
+        pNamespace->Led.Asserted.s.fWriting = pNamespace->Led.Actual.s.fWriting = 1;
+        if (pNamespace->fMediaWriteZeroes)
+            rc = pNamespace->pDrvMediaEx->pfnIoReqWriteZeroes(pNamespace->pDrvMediaEx, pIoReq->hIoReq,
+                                                              offStart, cbReq);
+        else
+        {
+            pIoReq->fWriteZeroes = true;
+            rc = pNamespace->pDrvMediaEx->pfnIoReqWrite(pNamespace->pDrvMediaEx, pIoReq->hIoReq,
+                                                        offStart, cbReq);
+        }
+    }
     else
     {
         pNamespace->Led.Asserted.s.fWriting = pNamespace->Led.Actual.s.fWriting = 1;
@@ -5224,6 +5703,12 @@ static int nvmeR3CmdNvmProcess(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC,
             cbReq = pNamespace->cbBlock * (pCmdNvm->u.Field.u.ReadWrite.u16Blocks + 1);
             u64OffsetStart = pNamespace->cbBlock * pCmdNvm->u.Field.u.ReadWrite.u64LbaStart;
             break;
+        case NVME_CMD_NVM_WRITE_ZEROES:
+            /* Same LBA range layout as read/write but without a data pointer. */
+            enmType = PDMMEDIAEXIOREQTYPE_WRITE_ZEROES;
+            cbReq = pNamespace->cbBlock * (pCmdNvm->u.Field.u.ReadWrite.u16Blocks + 1);
+            u64OffsetStart = pNamespace->cbBlock * pCmdNvm->u.Field.u.ReadWrite.u64LbaStart;
+            break;
         default:
             LogRel(("NVMe#%u: Guest queued invalid command %#x\n", pDevIns->iInstance,
                     pCmdNvm->u.Field.Hdr.u8Opc));
@@ -5245,6 +5730,144 @@ static int nvmeR3CmdNvmProcess(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC,
     return rc;
 }
 
+/**
+ * Reads an entry from the shadow doorbell buffer on behalf of a worker thread.
+ *
+ * @returns The value read.
+ * @param   pDevIns     The device instance.
+ * @param   pWrkThrd    The worker thread doing the read.
+ * @param   GCPhys      The guest physical address of the entry.
+ */
+static uint32_t nvmeR3WrkThrdDbBufRead(PPDMDEVINS pDevIns, PNVMEWRKTHRD pWrkThrd, RTGCPHYS GCPhys)
+{
+    uint32_t u32 = 0;
+    if (pWrkThrd->pPhysMapCache)
+        PDMDevHlpPhysMapCacheRead(pDevIns, pWrkThrd->pPhysMapCache, GCPhys, &u32, sizeof(u32));
+    else
+        PDMDevHlpPCIPhysRead(pDevIns, GCPhys, &u32, sizeof(u32));
+    return u32;
+}
+
+/**
+ * Writes an entry to the EventIdx buffer on behalf of a worker thread.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pWrkThrd    The worker thread doing the write.
+ * @param   GCPhys      The guest physical address of the entry.
+ * @param   u32         The value to write.
+ */
+static void nvmeR3WrkThrdDbBufWrite(PPDMDEVINS pDevIns, PNVMEWRKTHRD pWrkThrd, RTGCPHYS GCPhys, uint32_t u32)
+{
+    if (pWrkThrd->pPhysMapCache)
+        PDMDevHlpPhysMapCacheWrite(pDevIns, pWrkThrd->pPhysMapCache, GCPhys, &u32, sizeof(u32));
+    else
+        PDMDevHlpPCIPhysWrite(pDevIns, GCPhys, &u32, sizeof(u32));
+}
+
+/**
+ * Takes the submission queue tail from the shadow doorbell buffer.
+ *
+ * @returns true if the tail moved, false otherwise.
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The NVMe controller shared instance data.
+ * @param   pWrkThrd    The worker thread owning the queue.
+ * @param   pQueue      The I/O submission queue.
+ */
+static bool nvmeR3WrkThrdDbBufSqSync(PPDMDEVINS pDevIns, PNVME pThis, PNVMEWRKTHRD pWrkThrd, PNVMEQUEUESUBM pQueue)
+{
+    uint32_t const u32Tail = nvmeR3WrkThrdDbBufRead(pDevIns, pWrkThrd,
+                                                    pThis->GCPhysDbBufShadow + NVME_DBBUF_OFF_SQ(pQueue->Hdr.u16Id));
+    if (u32Tail == pQueue->Hdr.idxTail)
+        return false;
+
+    if (RT_UNLIKELY(u32Tail >= pQueue->Hdr.cEntries))
+    {
+        LogRelMax(10, ("NVMe#%uWrk#%u: Invalid shadow doorbell value %u for submission queue %u with %u entries\n",
+                       pDevIns->iInstance, pWrkThrd->uId, u32Tail, pQueue->Hdr.u16Id, pQueue->Hdr.cEntries));
+        return false;
+    }
+
+    STAM_COUNTER_INC(&pThis->StatDbBufSqTail);
+    ASMAtomicWriteU32(&pQueue->Hdr.idxTail, u32Tail);
+    return true;
+}
+
+/**
+ * Publishes the current submission queue tail in the EventIdx buffer, making the
+ * guest ring the doorbell register for the next tail update, and checks for a
+ * tail update racing it.
+ *
+ * @returns true if the guest moved the tail meanwhile, false otherwise.
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The NVMe controller shared instance data.
+ * @param   pWrkThrd    The worker thread owning the queue.
+ * @param   pQueue      The I/O submission queue.
+ */
+static bool nvmeR3WrkThrdDbBufSqArm(PPDMDEVINS pDevIns, PNVME pThis, PNVMEWRKTHRD pWrkThrd, PNVMEQUEUESUBM pQueue)
+{
+    nvmeR3WrkThrdDbBufWrite(pDevIns, pWrkThrd, pThis->GCPhysDbBufEvtIdx + NVME_DBBUF_OFF_SQ(pQueue->Hdr.u16Id),
+                            ASMAtomicReadU32(&pQueue->Hdr.idxTail));
+    /* Pairs with the barrier between the shadow doorbell update and the EventIdx check in the guest. */
+    ASMMemoryFence();
+    return nvmeR3WrkThrdDbBufSqSync(pDevIns, pThis, pWrkThrd, pQueue);
+}
+
+/**
+ * Polls the shadow doorbells of the submission queues assigned to the given
+ * worker for the configured amount of time, arming the EventIdx entries if
+ * nothing turned up.
+ *
+ * The EventIdx entries are left alone while polling so the guest doesn't ring
+ * the doorbell registers.
+ *
+ * @returns true if new commands are pending, false if the worker can go to sleep.
+ * @param   pDevIns     The device instance.
+ * @param   pThis       The NVMe controller shared instance data.
+ * @param   pThisCC     The NVMe controller ring-3 instance data.
+ * @param   pWrkThrd    The worker thread.
+ * @param   pThread     The PDM thread of the worker.
+ */
+static bool nvmeR3WrkThrdDbBufPoll(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC, PNVMEWRKTHRD pWrkThrd,
+                                   PPDMTHREAD pThread)
+{
+    uint64_t const nsDeadline = RTTimeNanoTS() + (uint64_t)pThis->cUsDbBufPoll * RT_NS_1US;
+    PNVMEQUEUESUBMR3 pSubmQueueR3;
+
+    do
+    {
+        RTListForEach(&pWrkThrd->ListSubmQueuesAssgnd, pSubmQueueR3, NVMEQUEUESUBMR3, NdLstWrkThrdAssgnd)
+        {
+            PNVMEQUEUESUBM pSubmQueue = &pThis->aQueuesSubm[pSubmQueueR3 - &pThisCC->aQueuesSubm[0]];
+
+            /* Doorbell register writes (admin queue) end the polling as well. */
+            if (   ASMAtomicReadBool(&pSubmQueue->fNotified)
+                || (   nvmeDbBufIsActive(pThis, pSubmQueue->Hdr.u16Id)
+                    && nvmeR3WrkThrdDbBufSqSync(pDevIns, pThis, pWrkThrd, pSubmQueue)))
+            {
+                STAM_COUNTER_INC(&pThis->StatDbBufPollHits);
+                return true;
+            }
+        }
+
+        ASMNopPause();
+    } while (   RTTimeNanoTS() < nsDeadline
+             && pThread->enmState == PDMTHREADSTATE_RUNNING
+             && pThis->enmState == NVMESTATE_READY);
+
+    STAM_COUNTER_INC(&pThis->StatDbBufPollTimeouts);
+
+    bool fPending = false;
+    RTListForEach(&pWrkThrd->ListSubmQueuesAssgnd, pSubmQueueR3, NVMEQUEUESUBMR3, NdLstWrkThrdAssgnd)
+    {
+        PNVMEQUEUESUBM pSubmQueue = &pThis->aQueuesSubm[pSubmQueueR3 - &pThisCC->aQueuesSubm[0]];
+        if (   nvmeDbBufIsActive(pThis, pSubmQueue->Hdr.u16Id)
+            && nvmeR3WrkThrdDbBufSqArm(pDevIns, pThis, pWrkThrd, pSubmQueue))
+            fPending = true;
+    }
+
+    return fPending;
+}
+
 /**
  * The NVMe asynchronous worker thread.
  *
@@ -5295,18 +5918,30 @@ static DECLCALLBACK(int) nvmeR3WorkerLoop(PPDMDEVINS pDevIns, PPDMTHREAD pThread
         rc = RTReqQueueProcess(pWrkThrd->hReqQueue, 0);
         Assert(rc == VERR_TIMEOUT || RT_SUCCESS(rc));
 
-        /* Don't process anything if the controller is not ready. */
+        /* Don't process anything if the controller is not ready, and don't keep
+           the queue memory mapped either as the guest is free to reuse it. */
         if (pThis->enmState != NVMESTATE_READY)
+        {
+            if (pWrkThrd->pPhysMapCache)
+                PDMDevHlpPhysMapCacheFlush(pDevIns, pWrkThrd->pPhysMapCache);
             continue;
+        }
 
         /* Walk all assigned submission queues and check for new work. */
+        bool fDbBufPoll    = false;
+        bool fDbBufPending = false;
         PNVMEQUEUESUBMR3 pSubmQueueR3;
         RTListForEach(&pWrkThrd->ListSubmQueuesAssgnd, pSubmQueueR3, NVMEQUEUESUBMR3, NdLstWrkThrdAssgnd)
         {
             uintptr_t idxSubmQueue = pSubmQueueR3 - &pThisCC->aQueuesSubm[0];
             Assert(idxSubmQueue < RT_ELEMENTS(pThis->aQueuesSubm));
             PNVMEQUEUESUBM pSubmQueue = &pThis->aQueuesSubm[idxSubmQueue];
+            bool const fDbBuf = nvmeDbBufIsActive(pThis, pSubmQueue->Hdr.u16Id);
 
+            /* Re-arm the doorbell notification before looking at the tail, see nvmeQueueSubmWrite(). */
+            ASMAtomicXchgBool(&pSubmQueue->fNotified, false);
+            if (fDbBuf)
+                nvmeR3WrkThrdDbBufSqSync(pDevIns, pThis, pWrkThrd, pSubmQueue);
             RTGCPHYS GCPhysCmd = nvmeQueueConsumerGetNextEntryAddress(&pSubmQueue->Hdr);
 
             while (   GCPhysCmd != NVME_QUEUE_IS_EMPTY_RTGCPHYS
@@ -5327,7 +5962,8 @@ static DECLCALLBACK(int) nvmeR3WorkerLoop(PPDMDEVINS pDevIns, PPDMTHREAD pThread
                 if (pSubmQueue->Hdr.u16Id == NVME_ADM_QUEUE_ID)
                 {
                     NVMECMDADM CmdAdm;
-                    nvmeR3PhysRead(pDevIns, pThis, pThisCC, GCPhysCmd, &CmdAdm, sizeof(CmdAdm), NVME_CMBSZ_SQS_BIT_IDX);
+                    nvmeR3WrkThrdPhysRead(pDevIns, pThis, pThisCC, pWrkThrd, GCPhysCmd, &CmdAdm, sizeof(CmdAdm),
+                                          NVME_CMBSZ_SQS_BIT_IDX);
 
                     u16Cid = CmdAdm.u.Field.Hdr.u16Cid;
                     rc = nvmeR3CmdAdminProcess(pDevIns, pThis, pThisCC, pWrkThrd, pSubmQueue, &CmdAdm);
@@ -5335,7 +5971,8 @@ static DECLCALLBACK(int) nvmeR3WorkerLoop(PPDMDEVINS pDevIns, PPDMTHREAD pThread
                 else
                 {
                     NVMECMDNVM CmdNvm;
-                    nvmeR3PhysRead(pDevIns, pThis, pThisCC, GCPhysCmd, &CmdNvm, sizeof(CmdNvm), NVME_CMBSZ_SQS_BIT_IDX);
+                    nvmeR3WrkThrdPhysRead(pDevIns, pThis, pThisCC, pWrkThrd, GCPhysCmd, &CmdNvm, sizeof(CmdNvm),
+                                          NVME_CMBSZ_SQS_BIT_IDX);
 
                     u16Cid = CmdNvm.u.Field.Hdr.u16Cid;
                     rc = nvmeR3CmdNvmProcess(pDevIns, pThis, pThisCC, pWrkThrd, pSubmQueue, &CmdNvm);
@@ -5357,9 +5994,29 @@ static DECLCALLBACK(int) nvmeR3WorkerLoop(PPDMDEVINS pDevIns, PPDMTHREAD pThread
 
             /** @todo Destroy if the submission queue is deallocating and we processed all requests. */
 
+            /*
+             * With shadow doorbells the guest only rings the doorbell register once the tail passes
+             * the EventIdx, so either poll for a while or publish the tail before going to sleep.
+             */
+            if (fDbBuf && RT_SUCCESS(rc))
+            {
+                if (pThis->cUsDbBufPoll)
+                    fDbBufPoll = true;
+                else if (nvmeR3WrkThrdDbBufSqArm(pDevIns, pThis, pWrkThrd, pSubmQueue))
+                    fDbBufPending = true;
+            }
+
             if (RT_UNLIKELY(pThis->enmState != NVMESTATE_READY))
                 break;
         }
+
+        if (   fDbBufPoll
+            && pThis->enmState == NVMESTATE_READY)
+            fDbBufPending = nvmeR3WrkThrdDbBufPoll(pDevIns, pThis, pThisCC, pWrkThrd, pThread);
+
+        /* Go around again without sleeping if the guest queued commands without ringing the doorbell. */
+        if (fDbBufPending)
+            PDMDevHlpSUPSemEventSignal(pDevIns, pWrkThrd->hEvtProcess);
     }
 
     ASMAtomicDecU32(&pThis->cActivities);
@@ -5417,6 +6074,7 @@ static void nvmeR3WrkThrdDestroy(PPDMDEVINS pDevIns, PNVMECC pThisCC, PNVMEWRKTH
     AssertRC(rc); AssertRC(rcThread);
 
     RTReqQueueDestroy(pWrkThrd->hReqQueue);
+    PDMDevHlpPhysMapCacheDestroy(pDevIns, pWrkThrd->pPhysMapCache);
     PDMDevHlpMMHeapFree(pDevIns, pWrkThrd);
 }
 
@@ -5491,6 +6149,7 @@ static int nvmeR3WrkThrdAssignSubmQueue(PPDMDEVINS pDevIns, PNVMEWRKTHRD pWrkThr
 
     pQueueR3->pWrkThrdR3 = pWrkThrd;
     pQueue->hEvtProcess  = pWrkThrd->hEvtProcess;
+    ASMAtomicWriteBool(&pQueue->fNotified, false);
 
     int rc = RTReqQueueCallEx(pWrkThrd->hReqQueue, NULL /*phReq*/, 0 /*cMillies*/, RTREQFLAGS_VOID | RTREQFLAGS_NO_WAIT,
                               (PFNRT)nvmeR3WrkThrdAssignWorker, 2, pWrkThrd, pQueueR3);
@@ -5575,6 +6234,14 @@ static int nvmeR3WrkThrdCreate(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC,
                     pThisCC->cWrkThrdsCur++;
                     RTCritSectLeave(&pThisCC->CritSectWrkThrds);
 
+                    /* The mapping cache is an optimization, so failing to create it is not fatal. */
+                    RTStrPrintf(szThrdId, sizeof(szThrdId), "Wrk%u", pWrkThrd->uId);
+                    rc = PDMDevHlpPhysMapCacheCreate(pDevIns, NULL /*pPciDev*/, 0 /*cEntries*/, szThrdId,
+                                                     &pWrkThrd->pPhysMapCache);
+                    if (RT_FAILURE(rc))
+                        LogRel(("NVMe#%u: Failed to create the mapping cache for worker %u: %Rrc\n",
+                                pDevIns->iInstance, pWrkThrd->uId, rc));
+
                     /*
                      * Resume the thread immediately if the VM is running so it can start
                      * processing requests.
@@ -5648,6 +6315,20 @@ static int nvmeR3SubmQueueAssignToWorker(PPDMDEVINS pDevIns, PNVME pThis, PNVMEC
 {
     PNVMEWRKTHRD pWrkThrd = NULL;
 
+    /*
+     * Keep all I/O submission queues feeding the same completion queue on one worker,
+     * so queue pairs map to a worker each and the completions stay on one thread.
+     */
+    for (uint32_t i = 1; i < pThis->cQueuesSubmMax; i++)
+    {
+        PNVMEQUEUESUBM pQueueOther = &pThis->aQueuesSubm[i];
+        if (   pQueueOther != pQueue
+            && pThisCC->aQueuesSubm[i].pWrkThrdR3
+            && pQueueOther->u16CompletionQueueId == pQueue->u16CompletionQueueId
+            && ASMAtomicReadU32((volatile uint32_t *)&pQueueOther->Hdr.enmState) == NVMEQUEUESTATE_ALLOCATED)
+            return nvmeR3WrkThrdAssignSubmQueue(pDevIns, pThisCC->aQueuesSubm[i].pWrkThrdR3, pQueue, pQueueR3);
+    }
+
     if (pThisCC->cWrkThrdsCur < pThis->cWrkThrdsMax)
     {
         /* Try to create a new worker. */
@@ -5696,6 +6377,13 @@ static DECLCALLBACK(int) nvmeR3IoReqCopyToBuf(PPDMIMEDIAEXPORT pInterface, PDMME
     PNVME           pThis   = PDMDEVINS_2_DATA(pDevIns, PNVME);
     PNVMECC         pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PNVMECC);
     PNVMEIOREQ      pIoReq  = (PNVMEIOREQ)pvIoReqAlloc;
+
+    if (pIoReq->fWriteZeroes)
+    {
+        RTSgBufSet(pSgBuf, 0, cbCopy);
+        return VINF_SUCCESS;
+    }
+
     bool fPrpValid = nvmeR3CopySgBufFromPrps(pDevIns, pThis, pThisCC, pIoReq->Prp1, pIoReq->Prp2, pIoReq->cbPrp,
                                              pSgBuf, cbCopy, offSrc, true /* fListsAllowed */);
     return fPrpValid ? VINF_SUCCESS : VERR_PDM_MEDIAEX_IOBUF_UNDERRUN;
@@ -5717,9 +6405,10 @@ static DECLCALLBACK(int) nvmeR3IoReqQueryBuf(PPDMIMEDIAEXPORT pInterface, PDMMED
 
     /*
      * The first PRP should start on a page boundary and cover the whole buffer
-     * (maximum single page).
+     * (maximum single page). Emulated write zeroes requests have no guest buffer.
      */
-    if (   cbPrp >= pIoReq->cbPrp
+    if (   !pIoReq->fWriteZeroes
+        && cbPrp >= pIoReq->cbPrp
         && NVME_PRP_IS_PAGE_ALIGNED(pIoReq->Prp1, pThis->uMpsSet))
     {
         RTGCPHYS GCPhysBase = NVME_PRP_GET_PAGE_ADDR(pIoReq->Prp1, pThis->uMpsSet);
@@ -5738,6 +6427,96 @@ static DECLCALLBACK(int) nvmeR3IoReqQueryBuf(PPDMIMEDIAEXPORT pInterface, PDMMED
     return rc;
 }
 
+/**
+ * @interface_method_impl{PDMIMEDIAEXPORT,pfnIoReqQuerySgBuf}
+ */
+static DECLCALLBACK(int) nvmeR3IoReqQuerySgBuf(PPDMIMEDIAEXPORT pInterface, PDMMEDIAEXIOREQ hIoReq,
+                                               void *pvIoReqAlloc, PRTSGSEG paSegs, unsigned *pcSegs)
+{
+    RT_NOREF(hIoReq);
+    PNVMENAMESPACE  pNvmeNs = RT_FROM_MEMBER(pInterface, NVMENAMESPACE, IPortEx);
+    PPDMDEVINS      pDevIns = pNvmeNs->pDevIns;
+    PNVME           pThis   = PDMDEVINS_2_DATA(pDevIns, PNVME);
+    PNVMECC         pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PNVMECC);
+    PNVMEIOREQ      pIoReq  = (PNVMEIOREQ)pvIoReqAlloc;
+    uint32_t const  cbPage  = RT_BIT_32(pThis->uMpsSet);
+    uint32_t const  cPages  = RT_ALIGN_32(pIoReq->cbPrp, cbPage) / cbPage;
+
+    /*
+     * Only page aligned buffers made up of whole guest pages are mapped, everything
+     * else (emulated write zeroes requests, unaligned PRPs, huge transfers, pages in
+     * the controller memory buffer or MMIO) goes through the copy path.
+     */
+    if (   pIoReq->fWriteZeroes
+        || pIoReq->fMapped
+        || pIoReq->cPgLcksSg
+        || cbPage != PDMDevHlpPhysGetPageSize(pDevIns)
+        || !cPages
+        || cPages > NVME_IOREQ_MAPPED_PAGES_MAX
+        || !NVME_PRP_IS_PAGE_ALIGNED(pIoReq->Prp1, pThis->uMpsSet))
+        return VERR_NOT_SUPPORTED;
+
+    RTGCPHYS aGCPhysPages[NVME_IOREQ_MAPPED_PAGES_MAX];
+    aGCPhysPages[0] = NVME_PRP_GET_PAGE_ADDR(pIoReq->Prp1, pThis->uMpsSet);
+    if (cPages == 2)
+        aGCPhysPages[1] = pIoReq->Prp2;
+    else if (cPages > 2)
+    {
+        /* The PRP list must not cross a page boundary, so there is no list chaining to deal with. */
+        uint32_t const cbList = (cPages - 1) * sizeof(NVMEPRP);
+        if (   (pIoReq->Prp2 & 0x7)
+            || NVME_PRP_GET_SIZE(pIoReq->Prp2, pThis->uMpsSet) < cbList)
+            return VERR_NOT_SUPPORTED;
+
+        NVMEPRP aPrps[NVME_IOREQ_MAPPED_PAGES_MAX - 1];
+        int rc = nvmeR3PhysRead(pDevIns, pThis, pThisCC, NVME_PRP_TO_GCPHYS(pIoReq->Prp2, pThis->uMpsSet),
+                                &aPrps[0], cbList, NVME_CMBSZ_LISTS_BIT_IDX);
+        if (RT_FAILURE(rc))
+            return VERR_NOT_SUPPORTED;
+        for (uint32_t i = 1; i < cPages; i++)
+            aGCPhysPages[i] = aPrps[i - 1];
+    }
+
+    for (uint32_t i = 1; i < cPages; i++)
+        if (!NVME_PRP_IS_PAGE_ALIGNED(aGCPhysPages[i], pThis->uMpsSet))
+            return VERR_NOT_SUPPORTED;
+
+    void *apvPages[NVME_IOREQ_MAPPED_PAGES_MAX];
+    int rc;
+    if (pIoReq->fRead)
+        rc = PDMDevHlpPCIPhysBulkGCPhys2CCPtr(pDevIns, NULL /* pPciDev */, cPages, &aGCPhysPages[0], 0 /* fFlags */,
+                                              &apvPages[0], &pIoReq->aPgLcksSg[0]);
+    else
+        rc = PDMDevHlpPCIPhysBulkGCPhys2CCPtrReadOnly(pDevIns, NULL /* pPciDev */, cPages, &aGCPhysPages[0], 0 /* fFlags */,
+                                                      (void const **)&apvPages[0], &pIoReq->aPgLcksSg[0]);
+    if (RT_FAILURE(rc))
+        return VERR_NOT_SUPPORTED;
+    pIoReq->cPgLcksSg = cPages; /* Released on completion. */
+
+    /* Build the segment list, merging pages which happen to be adjacent in host memory. */
+    unsigned cSegs  = 0;
+    uint32_t cbLeft = pIoReq->cbPrp;
+    for (uint32_t i = 0; i < cPages; i++)
+    {
+        uint32_t const cbThis = RT_MIN(cbLeft, cbPage);
+        if (   cSegs
+            && (uint8_t *)paSegs[cSegs - 1].pvSeg + paSegs[cSegs - 1].cbSeg == (uint8_t *)apvPages[i])
+            paSegs[cSegs - 1].cbSeg += cbThis;
+        else if (cSegs < *pcSegs)
+        {
+            paSegs[cSegs].pvSeg = apvPages[i];
+            paSegs[cSegs].cbSeg = cbThis;
+            cSegs++;
+        }
+        else
+            return VERR_NOT_SUPPORTED;
+        cbLeft -= cbThis;
+    }
+
+    *pcSegs = cSegs;
+    return VINF_SUCCESS;
+}
+
 /**
  * @interface_method_impl{PDMIMEDIAEXPORT,pfnIoReqCompleteNotify}
  */
@@ -5886,6 +6665,11 @@ static int nvmeR3NamespaceConfigure(PPDMDEVINS pDevIns, PNVMENAMESPACE pNvmeNs,
         pNvmeNs->cBlocks = pNvmeNs->pDrvMedia->pfnGetSize(pNvmeNs->pDrvMedia) / RT_MAX(pNvmeNs->cbBlock, 1);
     }
 
+    uint32_t fFeatures = 0;
+    rc = pNvmeNs->pDrvMediaEx->pfnQueryFeatures(pNvmeNs->pDrvMediaEx, &fFeatures);
+    pNvmeNs->fMediaWriteZeroes = RT_SUCCESS(rc) && (fFeatures & PDMIMEDIAEX_FEATURE_F_WRITE_ZEROES);
+    rc = VINF_SUCCESS;
+
     LogRel(("NVMe#%uNs%u: disk, total number of blocks %Ld\n", pDevIns->iInstance, pNvmeNs->u32Id,  pNvmeNs->cBlocks));
 #if 0 /** @todo */
     if (pNvmeNs->pDrvMedia->pfnDiscard)
@@ -5911,6 +6695,11 @@ static void nvmeR3CtrlReset(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC)
 
     pThisCC->cAsyncEvtReqsCur = 0;
 
+    /* The doorbell buffer config doesn't survive a controller reset. */
+    ASMAtomicWriteBool(&pThis->fDbBufEnabled, false);
+    pThis->GCPhysDbBufShadow = NIL_RTGCPHYS;
+    pThis->GCPhysDbBufEvtIdx = NIL_RTGCPHYS;
+
     /*
      * Initialize the interrupt vector states.
      */
@@ -5918,7 +6707,11 @@ static void nvmeR3CtrlReset(PPDMDEVINS pDevIns, PNVME pThis, PNVMECC pThisCC)
     {
         pThis->aIntrVecs[i].cEvtsWaiting = 0;
         pThis->aIntrVecs[i].fIntrDisabled = false;
+        pThis->aIntrVecs[i].fCoalescingDisabled = false;
+        pThis->aIntrVecs[i].cEvtsCoalesced = 0;
     }
+    pThis->uIntrCoalThr  = 0;
+    pThis->uIntrCoalTime = 0;
 
     /*
      * Init queue states, except for the admin queues which are treated differently.
@@ -6113,6 +6906,35 @@ static void nvmeR3StatsRegister(PPDMDEVINS pDevIns, PNVME pThis)
     nvmeR3StatsPhysRegister(pDevIns, &pThis->aStatMemXfer[NVME_CMBSZ_LISTS_BIT_IDX], "LISTS", "Memory transfered for PRP or SGL lists");
     nvmeR3StatsPhysRegister(pDevIns, &pThis->aStatMemXfer[NVME_CMBSZ_RDS_BIT_IDX],   "RDS",   "Memory transfered for data reads");
     nvmeR3StatsPhysRegister(pDevIns, &pThis->aStatMemXfer[NVME_CMBSZ_WDS_BIT_IDX],   "WDS",   "Memory transfered for data writes");
+
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDoorbellSqRZ,  STAMTYPE_COUNTER, "Doorbell/SqRZ",  STAMUNIT_OCCURENCES,
+                          "Submission queue doorbell writes handled in R0/RC");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDoorbellSqR3,  STAMTYPE_COUNTER, "Doorbell/SqR3",  STAMUNIT_OCCURENCES,
+                          "Submission queue doorbell writes handled in R3");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDoorbellCqRZ,  STAMTYPE_COUNTER, "Doorbell/CqRZ",  STAMUNIT_OCCURENCES,
+                          "Completion queue doorbell writes handled in R0/RC");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDoorbellCqR3,  STAMTYPE_COUNTER, "Doorbell/CqR3",  STAMUNIT_OCCURENCES,
+                          "Completion queue doorbell writes handled in R3");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDoorbellToR3,  STAMTYPE_COUNTER, "Doorbell/ToR3",  STAMUNIT_OCCURENCES,
+                          "Doorbell writes deferred from R0/RC to R3");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWrkThrdWakeups, STAMTYPE_COUNTER, "Doorbell/Wakeups", STAMUNIT_OCCURENCES,
+                          "Worker thread wakeups caused by submission queue doorbell writes");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWrkThrdWakeupsCoalesced, STAMTYPE_COUNTER, "Doorbell/WakeupsCoalesced", STAMUNIT_OCCURENCES,
+                          "Submission queue doorbell writes coalesced with a pending worker thread wakeup");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDbBufSqTail, STAMTYPE_COUNTER, "Doorbell/ShadowSq", STAMUNIT_OCCURENCES,
+                          "Submission queue tail updates picked up from the shadow doorbell buffer");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDbBufPollHits, STAMTYPE_COUNTER, "Doorbell/ShadowPollHits", STAMUNIT_OCCURENCES,
+                          "Shadow doorbell polls which found new commands");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDbBufPollTimeouts, STAMTYPE_COUNTER, "Doorbell/ShadowPollTimeouts", STAMUNIT_OCCURENCES,
+                          "Shadow doorbell polls which timed out and armed the EventIdx entries");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntrSignalled, STAMTYPE_COUNTER, "Intr/Signalled", STAMUNIT_OCCURENCES,
+                          "Interrupts signalled for completions");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntrDeferred, STAMTYPE_COUNTER, "Intr/Deferred", STAMUNIT_OCCURENCES,
+                          "Completions whose interrupt was held back for coalescing");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntrCoalescingTimeouts, STAMTYPE_COUNTER, "Intr/CoalescingTimeouts", STAMUNIT_OCCURENCES,
+                          "Held back interrupts signalled once the aggregation time elapsed");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntrCompletionsPerIntr, STAMTYPE_PROFILE, "Intr/CompletionsPerIntr", STAMUNIT_OCCURENCES,
+                          "Completions per signalled interrupt");
 }
 
 #endif /* VBOX_WITH_STATISTICS */
@@ -6416,6 +7238,19 @@ static DECLCALLBACK(int) nvmeR3SaveExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
     for (unsigned i = 0; i < pThisCC->cAsyncEvtReqsCur; i++)
         pHlp->pfnSSMPutU16(pSSM, pThisCC->paAsyncEvtReqCids[i]);
 
+    pHlp->pfnSSMPutBool(pSSM,   pThis->fDbBufEnabled);
+    pHlp->pfnSSMPutGCPhys(pSSM, pThis->GCPhysDbBufShadow);
+    pHlp->pfnSSMPutGCPhys(pSSM, pThis->GCPhysDbBufEvtIdx);
+
+    pHlp->pfnSSMPutU8(pSSM, pThis->uIntrCoalThr);
+    pHlp->pfnSSMPutU8(pSSM, pThis->uIntrCoalTime);
+    for (unsigned i = 0; i < RT_ELEMENTS(pThis->aIntrVecs); i++)
+    {
+        pHlp->pfnSSMPutBool(pSSM, pThis->aIntrVecs[i].fCoalescingDisabled);
+        pHlp->pfnSSMPutU32(pSSM,  pThis->aIntrVecs[i].cEvtsCoalesced);
+        PDMDevHlpTimerSave(pDevIns, pThis->aIntrVecs[i].hTimerCoalescing, pSSM);
+    }
+
     /* Save namespace states. */
     for (unsigned i = 0; i < pThis->cNamespaces; i++)
     {
@@ -6443,6 +7278,7 @@ static DECLCALLBACK(int) nvmeR3SaveExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
                     pHlp->pfnSSMPutU64(pSSM, pNvmeIoReq->Prp1);
                     pHlp->pfnSSMPutU64(pSSM, pNvmeIoReq->Prp2);
                     pHlp->pfnSSMPutU32(pSSM, pNvmeIoReq->cbPrp);
+                    pHlp->pfnSSMPutBool(pSSM, pNvmeIoReq->fWriteZeroes);
 
                     rc = pNamespace->pDrvMediaEx->pfnIoReqSuspendedSave(pNamespace->pDrvMediaEx, pSSM, pNvmeIoReq->hIoReq);
                     if (RT_FAILURE(rc))
@@ -6711,6 +7547,30 @@ static DECLCALLBACK(int) nvmeR3LoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uin
         for (unsigned i = 0; i < pThisCC->cAsyncEvtReqsCur; i++)
             pHlp->pfnSSMGetU16(pSSM, &pThisCC->paAsyncEvtReqCids[i]);
 
+        if (uVersion > NVME_SAVED_STATE_VERSION_PRE_DBBUF)
+        {
+            pHlp->pfnSSMGetBoolV(pSSM, &pThis->fDbBufEnabled);
+            pHlp->pfnSSMGetGCPhys(pSSM, &pThis->GCPhysDbBufShadow);
+            rc = pHlp->pfnSSMGetGCPhys(pSSM, &pThis->GCPhysDbBufEvtIdx);
+            AssertRCReturn(rc, rc);
+        }
+
+        if (uVersion > NVME_SAVED_STATE_VERSION_PRE_INTR_COAL)
+        {
+            pHlp->pfnSSMGetU8(pSSM, &pThis->uIntrCoalThr);
+            pHlp->pfnSSMGetU8(pSSM, &pThis->uIntrCoalTime);
+            for (unsigned i = 0; i < RT_ELEMENTS(pThis->aIntrVecs); i++)
+            {
+                PNVMEINTRVEC pIntr = &pThis->aIntrVecs[i];
+
+                pHlp->pfnSSMGetBool(pSSM, &pIntr->fCoalescingDisabled);
+                pHlp->pfnSSMGetU32(pSSM,  &pIntr->cEvtsCoalesced);
+                rc = PDMDevHlpTimerLoad(pDevIns, pIntr->hTimerCoalescing, pSSM);
+                AssertRCReturn(rc, rc);
+                pIntr->fCoalescingTimerArmed = PDMDevHlpTimerIsActive(pDevIns, pIntr->hTimerCoalescing);
+            }
+        }
+
         /* Load namespace states. */
         for (unsigned i = 0; i < pThis->cNamespaces; i++)
         {
@@ -6731,6 +7591,7 @@ static DECLCALLBACK(int) nvmeR3LoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uin
                     uint16_t u16Cid, u16QueueSubmId;
                     NVMEPRP  Prp1, Prp2;
                     uint32_t cbPrp;
+                    bool     fWriteZeroes = false;
                     PNVMEQUEUESUBM pQueueSubm = NULL;
 
                     /* Restore data first. */
@@ -6740,6 +7601,11 @@ static DECLCALLBACK(int) nvmeR3LoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uin
                     pHlp->pfnSSMGetU64(pSSM, &Prp2);
                     rc = pHlp->pfnSSMGetU32(pSSM, &cbPrp);
                     AssertRCReturn(rc, rc);
+                    if (uVersion > NVME_SAVED_STATE_VERSION_PRE_WRITE_ZEROES)
+                    {
+                        rc = pHlp->pfnSSMGetBool(pSSM, &fWriteZeroes);
+                        AssertRCReturn(rc, rc);
+                    }
 
                     if (   u16QueueSubmId >= pThis->cQueuesSubmMax
                         || u16QueueSubmId != pThis->aQueuesSubm[u16QueueSubmId].Hdr.u16Id)
@@ -6754,6 +7620,7 @@ static DECLCALLBACK(int) nvmeR3LoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uin
                                                          Prp1, Prp2, cbPrp);
                     if (RT_LIKELY(pIoReq))
                     {
+                        pIoReq->fWriteZeroes = fWriteZeroes;
                         rc = pNamespace->pDrvMediaEx->pfnIoReqSuspendedLoad(pNamespace->pDrvMediaEx, pSSM, pIoReq->hIoReq);
                         if (RT_FAILURE(rc))
                             return pHlp->pfnSSMSetCfgError(pSSM, RT_SRC_POS,
@@ -7131,7 +7998,9 @@ static DECLCALLBACK(int) nvmeR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
                                   "CtrlMemBufLists|"
                                   "CtrlMemBufCqs|"
                                   "CtrlMemBufSqs|"
-                                  "MsiXSupported",
+                                  "MsiXSupported|"
+                                  "ShadowDoorbellPollUs|"
+                                  "IntrCoalescingAdaptiveUs",
                                   "");
 
     rc = pHlp->pfnCFGMQueryU16Def(pCfg, "QueuesSubmissionMax", &cQueuesSubmMax, NVME_QUEUES_SUBMISSION_MAX_DEF);
@@ -7218,6 +8087,24 @@ static DECLCALLBACK(int) nvmeR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
         return PDMDEV_SET_ERROR(pDevIns, rc,
                                 N_("NVMe configuration error: failed to read \"MsiXSupported\" as boolean"));
 
+    rc = pHlp->pfnCFGMQueryU32Def(pCfg, "ShadowDoorbellPollUs", &pThis->cUsDbBufPoll, NVME_DBBUF_POLL_US_DEF);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc,
+                                N_("NVMe configuration error: failed to read \"ShadowDoorbellPollUs\" as integer"));
+    if (pThis->cUsDbBufPoll > NVME_DBBUF_POLL_US_MAX)
+        return PDMDevHlpVMSetError(pDevIns, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                                   N_("NVMe configuration error: \"ShadowDoorbellPollUs\"=%u is out of range (0..%u)"),
+                                   pThis->cUsDbBufPoll, NVME_DBBUF_POLL_US_MAX);
+
+    rc = pHlp->pfnCFGMQueryU32Def(pCfg, "IntrCoalescingAdaptiveUs", &pThis->cUsIntrCoalAdaptive, NVME_INTR_COAL_ADAPTIVE_US_DEF);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc,
+                                N_("NVMe configuration error: failed to read \"IntrCoalescingAdaptiveUs\" as integer"));
+    if (pThis->cUsIntrCoalAdaptive > NVME_INTR_COAL_ADAPTIVE_US_MAX)
+        return PDMDevHlpVMSetError(pDevIns, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                                   N_("NVMe configuration error: \"IntrCoalescingAdaptiveUs\"=%u is out of range (0..%u)"),
+                                   pThis->cUsIntrCoalAdaptive, NVME_INTR_COAL_ADAPTIVE_US_MAX);
+
     /*
      * Parse the controller memory buffer related config.
      */
@@ -7299,6 +8186,8 @@ static DECLCALLBACK(int) nvmeR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
     pThis->cCompQueuesWaitersMax = cCompQueuesWaitersMax;
     pThis->u32CtrlMemBufSz       = u32CtrlMemBufSz;
     pThis->GCPhysCtrlMemBuf      = NIL_RTGCPHYS;
+    pThis->GCPhysDbBufShadow     = NIL_RTGCPHYS;
+    pThis->GCPhysDbBufEvtIdx     = NIL_RTGCPHYS;
     pThisCC->pDevIns             = pDevIns;
 
     RTListInit(&pThisCC->LstWrkThrds);
@@ -7365,6 +8254,13 @@ static DECLCALLBACK(int) nvmeR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
         if (RT_FAILURE(rc))
             return PDMDevHlpVMSetError(pDevIns, rc, RT_SRC_POS,
                                        N_("NVMe: Failed to create critical section for interrupter %u"), i);
+
+        rc = PDMDevHlpTimerCreate(pDevIns, TMCLOCK_VIRTUAL, nvmeR3IntrCoalescingTimer, (void *)(uintptr_t)i,
+                                  TMTIMER_FLAGS_NO_CRIT_SECT | TMTIMER_FLAGS_NO_RING0, "NVMe Intr Coalescing",
+                                  &pThis->aIntrVecs[i].hTimerCoalescing);
+        if (RT_FAILURE(rc))
+            return PDMDevHlpVMSetError(pDevIns, rc, RT_SRC_POS,
+                                       N_("NVMe: Failed to create the coalescing timer for interrupter %u"), i);
     }
 
     /* Region #0: MMIO */
@@ -7493,6 +8389,7 @@ static DECLCALLBACK(int) nvmeR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
         pNvmeNs->IPortEx.pfnIoReqCopyFromBuf    = nvmeR3IoReqCopyFromBuf;
         pNvmeNs->IPortEx.pfnIoReqCopyToBuf      = nvmeR3IoReqCopyToBuf;
         pNvmeNs->IPortEx.pfnIoReqQueryBuf       = nvmeR3IoReqQueryBuf;
+        pNvmeNs->IPortEx.pfnIoReqQuerySgBuf     = nvmeR3IoReqQuerySgBuf;
         pNvmeNs->IPortEx.pfnIoReqStateChanged   = nvmeR3IoReqStateChanged;
 
         /*
@@ -0,0 +1,1949 @@
+/* $Id$ */
+/** @file
+ * VBox storage devices - Virtio block device.
+ *
+ * Log-levels used:
+ *    - Level 1:   The most important (but usually rare) things to note
+ *    - Level 2:   Request logging
+ *    - Level 3:   Vector and I/O transfer summary
+ *    - Level 6:   Device <-> Guest Driver negotation, traffic, notifications and state handling
+ */
+
+/*
+ * Copyright (C) 2006-2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#define LOG_GROUP LOG_GROUP_DEV_VIRTIO
+
+#include <VBox/vmm/pdmdev.h>
+#include <VBox/vmm/pdmstorageifs.h>
+#include <VBox/vmm/pdmcritsect.h>
+#include <VBox/AssertGuest.h>
+#include <VBox/msi.h>
+#include <VBox/log.h>
+#include <iprt/errcore.h>
+#include <iprt/assert.h>
+#include <iprt/string.h>
+#include <VBox/sup.h>
+#include "../build/VBoxDD.h"
+#ifdef IN_RING3
+# include <iprt/alloc.h>
+# include <iprt/semaphore.h>
+# include <iprt/sg.h>
+# include <iprt/param.h>
+# include <iprt/uuid.h>
+#endif
+#include "../VirtIO/VirtioCore.h"
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** The current saved state version. */
+#define VIRTIOBLK_SAVED_STATE_VERSION               UINT32_C(1)
+
+/** @name VirtIO 1.1 block device feature bits (See VirtIO 1.1 specification, Section 5.2.3)
+ * @{  */
+#define VIRTIO_BLK_F_SIZE_MAX                       RT_BIT_64(1)    /**< Max size of any single segment in size_max      */
+#define VIRTIO_BLK_F_SEG_MAX                        RT_BIT_64(2)    /**< Max number of segments in a request in seg_max  */
+#define VIRTIO_BLK_F_GEOMETRY                       RT_BIT_64(4)    /**< Disk-style geometry specified in geometry       */
+#define VIRTIO_BLK_F_RO                             RT_BIT_64(5)    /**< Device is read-only                             */
+#define VIRTIO_BLK_F_BLK_SIZE                       RT_BIT_64(6)    /**< Block size of disk is in blk_size               */
+#define VIRTIO_BLK_F_FLUSH                          RT_BIT_64(9)    /**< Cache flush command support                     */
+#define VIRTIO_BLK_F_TOPOLOGY                       RT_BIT_64(10)   /**< Device exports topology information             */
+#define VIRTIO_BLK_F_CONFIG_WCE                     RT_BIT_64(11)   /**< Device can toggle writeback/writethrough        */
+#define VIRTIO_BLK_F_MQ                             RT_BIT_64(12)   /**< Device supports multiqueue                      */
+#define VIRTIO_BLK_F_DISCARD                        RT_BIT_64(13)   /**< Device can support discard command              */
+#define VIRTIO_BLK_F_WRITE_ZEROES                   RT_BIT_64(14)   /**< Device can support write zeroes command         */
+/** @} */
+
+#define VIRTIOBLK_HOST_FEATURES_OFFERED \
+    (VIRTIO_BLK_F_SEG_MAX | VIRTIO_BLK_F_BLK_SIZE | VIRTIO_BLK_F_FLUSH | VIRTIO_BLK_F_MQ | VIRTIO_BLK_F_WRITE_ZEROES)
+
+/** @name VirtIO 1.1 block device request types (See VirtIO 1.1 specification, Section 5.2.6)
+ * @{  */
+#define VIRTIO_BLK_T_IN                             0
+#define VIRTIO_BLK_T_OUT                            1
+#define VIRTIO_BLK_T_FLUSH                          4
+#define VIRTIO_BLK_T_GET_ID                         8
+#define VIRTIO_BLK_T_DISCARD                        11
+#define VIRTIO_BLK_T_WRITE_ZEROES                   13
+/** @} */
+
+/** @name VirtIO 1.1 block device request status values
+ * @{  */
+#define VIRTIO_BLK_S_OK                             0
+#define VIRTIO_BLK_S_IOERR                          1
+#define VIRTIO_BLK_S_UNSUPP                         2
+/** @} */
+
+/** Flag in VIRTIOBLK_DISCARD_WZ_T::fFlags allowing the device to unmap on write zeroes. */
+#define VIRTIO_BLK_WRITE_ZEROES_FLAG_UNMAP          RT_BIT_32(0)
+
+/** Sector size used by the virtio-blk protocol, independent of blk_size. */
+#define VIRTIOBLK_SECTOR_SHIFT                      9
+#define VIRTIOBLK_SECTOR_SIZE                       RT_BIT_32(VIRTIOBLK_SECTOR_SHIFT)
+
+#define VIRTIOBLK_REQ_VIRTQ_CNT_DEF                 4           /**< Default number of request queues                */
+#define VIRTIOBLK_REQ_VIRTQ_CNT_MAX                 16          /**< Must not exceed VIRTQ_MAX_COUNT                 */
+#define VIRTIOBLK_MAX_SEG_COUNT                     126         /**< Leaves room for the header and status descs     */
+#define VIRTIOBLK_MAX_DISCARD_SECTORS               UINT32_C(0x400000) /**< 2GiB per discard segment             */
+#define VIRTIOBLK_MAX_DISCARD_SEG                   32          /**< Max segments in a discard request               */
+#define VIRTIOBLK_MAX_WRITE_ZEROES_SECTORS          UINT32_C(0x4000)   /**< 8MiB, backed by a zero filled write  */
+#define VIRTIOBLK_MAX_WRITE_ZEROES_SEG              1           /**< Max segments in a write zeroes request          */
+#define VIRTIOBLK_ID_BYTES                          20          /**< Length of the GET_ID serial number string       */
+
+#define PCI_DEVICE_ID_VIRTIOBLK_HOST                0x1042      /**< Informs guest driver of type of VirtIO device   */
+#define PCI_CLASS_BASE_MASS_STORAGE                 0x01        /**< PCI Mass Storage device class                   */
+#define PCI_CLASS_SUB_SCSI_STORAGE_CONTROLLER       0x00        /**< What other virtio-blk implementations report    */
+#define PCI_CLASS_PROG_UNSPECIFIED                  0x00        /**< Programming interface. N/A.                     */
+
+AssertCompile(VIRTIOBLK_REQ_VIRTQ_CNT_MAX <= VIRTQ_MAX_COUNT);
+
+#define VIRTQNAME(uVirtqNbr) (pThis->aszVirtqNames[uVirtqNbr])  /**< Macro to get queue name from its index          */
+
+#define IS_VIRTQ_EMPTY(pDevIns, pVirtio, uVirtqNbr) \
+            (virtioCoreVirtqAvailBufCount(pDevIns, pVirtio, uVirtqNbr) == 0)
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * VirtIO block device device-specific configuration (see VirtIO 1.1, section 5.2.4)
+ * VBox VirtIO core issues callback to this VirtIO device-specific implementation to handle
+ * MMIO accesses to device-specific configuration parameters.
+ */
+#pragma pack(1)
+typedef struct virtio_blk_config
+{
+    uint64_t uCapacity;                                         /**< capacity         Size in 512 byte sectors       */
+    uint32_t uSizeMax;                                          /**< size_max         Max size of a segment          */
+    uint32_t uSegMax;                                           /**< seg_max          Max \# of segs in a request    */
+    uint16_t uCylinders;                                        /**< geometry.cylinders                              */
+    uint8_t  uHeads;                                            /**< geometry.heads                                  */
+    uint8_t  uSectors;                                          /**< geometry.sectors                                */
+    uint32_t uBlkSize;                                          /**< blk_size         Optimal block size             */
+    uint8_t  uPhysBlkExp;                                       /**< topology.physical_block_exp                     */
+    uint8_t  uAlignmentOffset;                                  /**< topology.alignment_offset                       */
+    uint16_t uMinIoSize;                                        /**< topology.min_io_size                            */
+    uint32_t uOptIoSize;                                        /**< topology.opt_io_size                            */
+    uint8_t  uWriteback;                                        /**< writeback        Cache mode (CONFIG_WCE)        */
+    uint8_t  uUnused0;                                          /**< unused0                                         */
+    uint16_t uNumQueues;                                        /**< num_queues       \# of req q's exposed by dev   */
+    uint32_t uMaxDiscardSectors;                                /**< max_discard_sectors                             */
+    uint32_t uMaxDiscardSeg;                                    /**< max_discard_seg                                 */
+    uint32_t uDiscardSectorAlignment;                           /**< discard_sector_alignment                        */
+    uint32_t uMaxWriteZeroesSectors;                            /**< max_write_zeroes_sectors                        */
+    uint32_t uMaxWriteZeroesSeg;                                /**< max_write_zeroes_seg                            */
+    uint8_t  uWriteZeroesMayUnmap;                              /**< write_zeroes_may_unmap                          */
+    uint8_t  abUnused1[3];                                      /**< unused1                                         */
+} VIRTIOBLK_CONFIG_T, *PVIRTIOBLK_CONFIG_T;
+#pragma pack()
+AssertCompileSize(VIRTIOBLK_CONFIG_T, 60);
+
+/**
+ * Device operation: requestq, device-readable request header.
+ */
+typedef struct VIRTIOBLK_REQ_HDR_T
+{
+    uint32_t uType;                                             /**< type                                             */
+    uint32_t uReserved;                                         /**< reserved (ioprio for legacy drivers)             */
+    uint64_t uSector;                                           /**< sector                                           */
+} VIRTIOBLK_REQ_HDR_T;
+AssertCompileSize(VIRTIOBLK_REQ_HDR_T, 16);
+
+/**
+ * Device operation: requestq, discard and write zeroes segment.
+ */
+typedef struct VIRTIOBLK_DISCARD_WZ_T
+{
+    uint64_t uSector;                                           /**< sector                                           */
+    uint32_t cSectors;                                          /**< num_sectors                                      */
+    uint32_t fFlags;                                            /**< flags                                            */
+} VIRTIOBLK_DISCARD_WZ_T;
+AssertCompileSize(VIRTIOBLK_DISCARD_WZ_T, 16);
+
+/**
+ * Worker thread context, shared state.
+ */
+typedef struct VIRTIOBLKWORKER
+{
+    SUPSEMEVENT                     hEvtProcess;                /**< handle of associated sleep/wake-up semaphore      */
+    bool volatile                   fSleeping;                  /**< Flags whether worker thread is sleeping or not    */
+    bool volatile                   fNotified;                  /**< Flags whether worker thread notified              */
+} VIRTIOBLKWORKER;
+/** Pointer to a VirtIO block worker. */
+typedef VIRTIOBLKWORKER *PVIRTIOBLKWORKER;
+
+/**
+ * Worker thread context, ring-3 state.
+ */
+typedef struct VIRTIOBLKWORKERR3
+{
+    R3PTRTYPE(PPDMTHREAD)           pThread;                    /**< pointer to worker thread's handle                 */
+    RTCRITSECT                      CritSectVirtq;              /**< Protecting the virtq against concurrent thread access. */
+    uint16_t                        auRedoDescs[VIRTQ_SIZE];    /**< List of previously suspended reqs to re-submit    */
+    uint16_t                        cRedoDescs;                 /**< Number of redo desc chain head desc idxes in list */
+} VIRTIOBLKWORKERR3;
+/** Pointer to a VirtIO block worker. */
+typedef VIRTIOBLKWORKERR3 *PVIRTIOBLKWORKERR3;
+
+/**
+ * VirtIO block device state, shared edition.
+ *
+ * @extends     VIRTIOCORE
+ */
+typedef struct VIRTIOBLK
+{
+    /** The core virtio state.   */
+    VIRTIOCORE                      Virtio;
+
+    /** VirtIO block device runtime configuration parameters */
+    VIRTIOBLK_CONFIG_T              virtioBlkConfig;
+
+    /** Number of request queues (and worker threads) exposed to the guest. */
+    uint16_t                        cVirtqs;
+
+    /** Set if the medium is read-only. */
+    bool                            fReadOnly;
+    /** Set if the attached driver supports discarding. */
+    bool                            fDiscard;
+    /** Set if the attached driver supports write zeroes requests natively. */
+    bool                            fMediaWriteZeroes;
+
+    /** Per virtq worker-thread contexts */
+    VIRTIOBLKWORKER                 aWorkers[VIRTIOBLK_REQ_VIRTQ_CNT_MAX];
+
+    /** Instance name */
+    char                            szInstance[16];
+
+    /** Device-specific spec-based VirtIO VIRTQNAMEs */
+    char                            aszVirtqNames[VIRTIOBLK_REQ_VIRTQ_CNT_MAX][VIRTIO_MAX_VIRTQ_NAME_SIZE];
+
+    /** Track which VirtIO queues we've attached to */
+    bool                            afVirtqAttached[VIRTIOBLK_REQ_VIRTQ_CNT_MAX];
+
+    /** Serial number returned for VIRTIO_BLK_T_GET_ID (not necessarily terminated). */
+    char                            szSerialNumber[VIRTIOBLK_ID_BYTES + 1];
+
+    /** Explicit alignment padding. */
+    bool                            afPadding0[3];
+
+    /** Total number of requests active */
+    volatile uint32_t               cActiveReqs;
+
+    /** True if the guest/driver and VirtIO framework are in the ready state */
+    uint32_t                        fVirtioReady;
+
+    /** True if VIRTIO_BLK_F_MQ was negotiated */
+    uint32_t                        fHasMq;
+
+    /** True if VIRTIO_BLK_F_DISCARD was negotiated */
+    uint32_t                        fHasDiscard;
+
+    /** True if VIRTIO_BLK_F_WRITE_ZEROES was negotiated */
+    uint32_t                        fHasWriteZeroes;
+
+    /** True if in the process of resetting */
+    uint32_t                        fResetting;
+
+} VIRTIOBLK;
+/** Pointer to the shared state of the VirtIO block device. */
+typedef VIRTIOBLK *PVIRTIOBLK;
+
+
+/**
+ * VirtIO block device state, ring-3 edition.
+ *
+ * @extends     VIRTIOCORER3
+ */
+typedef struct VIRTIOBLKR3
+{
+    /** The core virtio ring-3 state. */
+    VIRTIOCORER3                    Virtio;
+
+    /** Per virtq worker-thread contexts */
+    VIRTIOBLKWORKERR3               aWorkers[VIRTIOBLK_REQ_VIRTQ_CNT_MAX];
+
+    /** Pointer to the device instance.
+     * @note Only used in interface callbacks. */
+    PPDMDEVINSR3                    pDevIns;
+
+    /** Device base interface. */
+    PDMIBASE                        IBase;
+
+    /** Media port interface. */
+    PDMIMEDIAPORT                   IMediaPort;
+
+    /** Extended media port interface. */
+    PDMIMEDIAEXPORT                 IMediaExPort;
+
+    /** Status LUN: LEDs port interface. */
+    PDMILEDPORTS                    ILeds;
+
+    /** The status LED state for this device. */
+    PDMLED                          Led;
+
+    /** Pointer to attached driver's base interface. */
+    R3PTRTYPE(PPDMIBASE)            pDrvBase;
+
+    /** Pointer to the attached driver's media interface. */
+    R3PTRTYPE(PPDMIMEDIA)           pDrvMedia;
+
+    /** Pointer to the attached driver's extended media interface. */
+    R3PTRTYPE(PPDMIMEDIAEX)         pDrvMediaEx;
+
+    /** IMediaExPort: Media ejection notification */
+    R3PTRTYPE(PPDMIMEDIANOTIFY)     pMediaNotify;
+
+    /** True if in the process of quiescing I/O */
+    uint32_t                        fQuiescing;
+
+    /** For which purpose we're quiescing. */
+    VIRTIOVMSTATECHANGED            enmQuiescingFor;
+
+} VIRTIOBLKR3;
+/** Pointer to the ring-3 state of the VirtIO block device. */
+typedef VIRTIOBLKR3 *PVIRTIOBLKR3;
+
+
+/**
+ * VirtIO block device state, ring-0 edition.
+ */
+typedef struct VIRTIOBLKR0
+{
+    /** The core virtio ring-0 state. */
+    VIRTIOCORER0                    Virtio;
+} VIRTIOBLKR0;
+/** Pointer to the ring-0 state of the VirtIO block device. */
+typedef VIRTIOBLKR0 *PVIRTIOBLKR0;
+
+
+/**
+ * VirtIO block device state, raw-mode edition.
+ */
+typedef struct VIRTIOBLKRC
+{
+    /** The core virtio raw-mode state. */
+    VIRTIOCORERC                    Virtio;
+} VIRTIOBLKRC;
+/** Pointer to the raw-mode state of the VirtIO block device. */
+typedef VIRTIOBLKRC *PVIRTIOBLKRC;
+
+
+/** @typedef VIRTIOBLKCC
+ * The instance data for the current context. */
+typedef CTX_SUFF(VIRTIOBLK) VIRTIOBLKCC;
+/** @typedef PVIRTIOBLKCC
+ * Pointer to the instance data for the current context. */
+typedef CTX_SUFF(PVIRTIOBLK) PVIRTIOBLKCC;
+
+
+/**
+ * Request structure for IMediaEx (Associated Interfaces implemented by DrvVD)
+ */
+typedef struct VIRTIOBLKREQ
+{
+    PDMMEDIAEXIOREQ                hIoReq;                      /**< Handle of I/O request                             */
+    uint16_t                       uVirtqNbr;                   /**< Index of queue this request arrived on            */
+    uint32_t                       uType;                       /**< VIRTIO_BLK_T_XXX                                  */
+    PVIRTQBUF                      pVirtqBuf;                   /**< Prepared desc chain pulled from virtq avail ring  */
+    size_t                         cbData;                      /**< Size of the data transfer                         */
+    uint32_t                       cRanges;                     /**< Number of discard ranges in paRanges              */
+    PRTRANGE                       paRanges;                    /**< Discard ranges (VIRTIO_BLK_T_DISCARD only)        */
+} VIRTIOBLKREQ;
+typedef VIRTIOBLKREQ *PVIRTIOBLKREQ;
+
+
+/**
+ * callback_method_impl{VIRTIOCORER0,pfnVirtqNotified}
+ */
+static DECLCALLBACK(void) virtioBlkNotified(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtqNbr)
+{
+    RT_NOREF(pVirtio);
+    PVIRTIOBLK pThis = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+
+    if (uVirtqNbr < pThis->cVirtqs)
+    {
+        PVIRTIOBLKWORKER pWorker = &pThis->aWorkers[uVirtqNbr];
+        Log6Func(("%s has available data\n", VIRTQNAME(uVirtqNbr)));
+        /* Wake queue's worker thread up if sleeping */
+        if (!ASMAtomicXchgBool(&pWorker->fNotified, true))
+        {
+            if (ASMAtomicReadBool(&pWorker->fSleeping))
+            {
+                Log6Func(("waking %s worker.\n", VIRTQNAME(uVirtqNbr)));
+                int rc = PDMDevHlpSUPSemEventSignal(pDevIns, pWorker->hEvtProcess);
+                AssertRC(rc);
+            }
+        }
+    }
+    else
+        LogFunc(("Unexpected queue idx (ignoring): %d\n", uVirtqNbr));
+}
+
+
+#ifdef IN_RING3 /* spans most of the file, at the moment. */
+
+
+DECLINLINE(void) virtioBlkSetVirtqNames(PVIRTIOBLK pThis)
+{
+    for (uint16_t uVirtqNbr = 0; uVirtqNbr < VIRTIOBLK_REQ_VIRTQ_CNT_MAX; uVirtqNbr++)
+        RTStrPrintf(pThis->aszVirtqNames[uVirtqNbr], VIRTIO_MAX_VIRTQ_NAME_SIZE, "requestq<%d>", uVirtqNbr);
+}
+
+#ifdef LOG_ENABLED
+DECLINLINE(const char *) virtioBlkGetReqTypeText(uint32_t uType)
+{
+    switch (uType)
+    {
+        case VIRTIO_BLK_T_IN:                           return "IN";
+        case VIRTIO_BLK_T_OUT:                          return "OUT";
+        case VIRTIO_BLK_T_FLUSH:                        return "FLUSH";
+        case VIRTIO_BLK_T_GET_ID:                       return "GET_ID";
+        case VIRTIO_BLK_T_DISCARD:                      return "DISCARD";
+        case VIRTIO_BLK_T_WRITE_ZEROES:                 return "WRITE_ZEROES";
+        default:                                        return "<unknown>";
+    }
+}
+#endif /* LOG_ENABLED */
+
+
+/**
+ * Completes a descriptor chain, writing the status byte to the last byte of the
+ * device-writable part and putting the chain on the used ring.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       VirtIO block shared instance data.
+ * @param   pThisCC     VirtIO block ring-3 instance data.
+ * @param   uVirtqNbr   Virtq index.
+ * @param   pVirtqBuf   The descriptor chain to complete.
+ * @param   cbWritten   Number of data bytes written to the guest buffer ahead of the status byte.
+ * @param   bStatus     The VIRTIO_BLK_S_XXX status.
+ */
+static void virtioBlkR3ReqComplete(PPDMDEVINS pDevIns, PVIRTIOBLK pThis, PVIRTIOBLKCC pThisCC, uint16_t uVirtqNbr,
+                                   PVIRTQBUF pVirtqBuf, size_t cbWritten, uint8_t bStatus)
+{
+    Log2Func(("%s: status=%u cbWritten=%zu\n", VIRTQNAME(uVirtqNbr), bStatus, cbWritten));
+    AssertReturnVoid(pVirtqBuf->cbPhysReturn >= 1);
+
+    if (pThis->fResetting)
+        bStatus = VIRTIO_BLK_S_IOERR;
+
+    PVIRTIOSGBUF pSgPhysReturn = pVirtqBuf->pSgPhysReturn;
+
+    RTCritSectEnter(&pThisCC->aWorkers[uVirtqNbr].CritSectVirtq);
+    virtioCoreGCPhysChainReset(pSgPhysReturn);
+    virtioCoreGCPhysChainAdvance(pSgPhysReturn, pVirtqBuf->cbPhysReturn - 1);
+    virtioCoreR3VirtqUsedBufPut(pDevIns, &pThis->Virtio, uVirtqNbr, sizeof(bStatus), &bStatus, pVirtqBuf,
+                                cbWritten + sizeof(bStatus), true /* fFence */);
+    virtioCoreVirtqUsedRingSync(pDevIns, &pThis->Virtio, uVirtqNbr);
+    RTCritSectLeave(&pThisCC->aWorkers[uVirtqNbr].CritSectVirtq);
+}
+
+/**
+ * Releases one reference from the given controller instances active request counter.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       VirtIO block shared instance data.
+ * @param   pThisCC     VirtIO block ring-3 instance data.
+ */
+DECLINLINE(void) virtioBlkR3Release(PPDMDEVINS pDevIns, PVIRTIOBLK pThis, PVIRTIOBLKCC pThisCC)
+{
+    Assert(pThis->cActiveReqs);
+
+    if (!ASMAtomicDecU32(&pThis->cActiveReqs) && pThisCC->fQuiescing)
+        PDMDevHlpAsyncNotificationCompleted(pDevIns);
+}
+
+/**
+ * Retains one reference for the given controller instances active request counter.
+ *
+ * @param   pThis       VirtIO block shared instance data.
+ */
+DECLINLINE(void) virtioBlkR3Retain(PVIRTIOBLK pThis)
+{
+    ASMAtomicIncU32(&pThis->cActiveReqs);
+}
+
+/** Internal worker. */
+static void virtioBlkR3FreeReq(PVIRTIOBLK pThis, PVIRTIOBLKCC pThisCC, PVIRTIOBLKREQ pReq)
+{
+    RTMemFree(pReq->paRanges);
+    pReq->paRanges = NULL;
+    virtioCoreR3VirtqBufRelease(&pThis->Virtio, pReq->pVirtqBuf);
+    pReq->pVirtqBuf = NULL;
+    pThisCC->pDrvMediaEx->pfnIoReqFree(pThisCC->pDrvMediaEx, pReq->hIoReq);
+}
+
+/**
+ * Completes a request that went to the driver below, frees it and drops the
+ * active request reference.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pThis       VirtIO block shared instance data.
+ * @param   pThisCC     VirtIO block ring-3 instance data.
+ * @param   pReq        The request.
+ * @param   rcReq       The request status.
+ */
+static void virtioBlkR3ReqFinish(PPDMDEVINS pDevIns, PVIRTIOBLK pThis, PVIRTIOBLKCC pThisCC, PVIRTIOBLKREQ pReq, int rcReq)
+{
+    if (pReq->uType == VIRTIO_BLK_T_IN)
+        pThisCC->Led.Actual.s.fReading = 0;
+    else if (pReq->uType != VIRTIO_BLK_T_FLUSH)
+        pThisCC->Led.Actual.s.fWriting = 0;
+
+    if (RT_FAILURE(rcReq))
+        LogRelMax(10, ("%s: %s request failed: %Rrc\n",
+                       pThis->szInstance, pReq->uType == VIRTIO_BLK_T_IN ? "Read" : "Write", rcReq));
+
+    size_t const cbWritten = RT_SUCCESS(rcReq) && pReq->uType == VIRTIO_BLK_T_IN ? pReq->cbData : 0;
+    virtioBlkR3ReqComplete(pDevIns, pThis, pThisCC, pReq->uVirtqNbr, pReq->pVirtqBuf, cbWritten,
+                           RT_SUCCESS(rcReq) ? VIRTIO_BLK_S_OK : VIRTIO_BLK_S_IOERR);
+    virtioBlkR3FreeReq(pThis, pThisCC, pReq);
+    virtioBlkR3Release(pDevIns, pThis, pThisCC);
+}
+
+/**
+ * @interface_method_impl{PDMIMEDIAEXPORT,pfnIoReqCompleteNotify}
+ */
+static DECLCALLBACK(int) virtioBlkR3IoReqFinish(PPDMIMEDIAEXPORT pInterface, PDMMEDIAEXIOREQ hIoReq,
+                                                void *pvIoReqAlloc, int rcReq)
+{
+    PVIRTIOBLKCC    pThisCC = RT_FROM_MEMBER(pInterface, VIRTIOBLKCC, IMediaExPort);
+    PPDMDEVINS      pDevIns = pThisCC->pDevIns;
+    PVIRTIOBLK      pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    RT_NOREF(hIoReq);
+
+    virtioBlkR3ReqFinish(pDevIns, pThis, pThisCC, (PVIRTIOBLKREQ)pvIoReqAlloc, rcReq);
+    return VINF_SUCCESS;
+}
+
+/**
+ * @interface_method_impl{PDMIMEDIAEXPORT,pfnIoReqCopyFromBuf}
+ *
+ * Copy virtual memory from the media driver to guest physical memory.
+ */
+static DECLCALLBACK(int) virtioBlkR3IoReqCopyFromBuf(PPDMIMEDIAEXPORT pInterface, PDMMEDIAEXIOREQ hIoReq,
+                                                     void *pvIoReqAlloc, uint32_t offDst, PRTSGBUF pSgBuf, size_t cbCopy)
+{
+    PVIRTIOBLKCC    pThisCC = RT_FROM_MEMBER(pInterface, VIRTIOBLKCC, IMediaExPort);
+    PPDMDEVINS      pDevIns = pThisCC->pDevIns;
+    PVIRTIOBLKREQ   pReq    = (PVIRTIOBLKREQ)pvIoReqAlloc;
+    RT_NOREF(hIoReq);
+
+    AssertReturn(pReq->pVirtqBuf, VERR_INVALID_PARAMETER);
+    AssertReturn(offDst <= pReq->cbData && cbCopy <= pReq->cbData - offDst, VERR_BUFFER_OVERFLOW);
+
+    /* The data area starts at the beginning of the device-writable part, the status byte follows it. */
+    PVIRTIOSGBUF pSgPhysReturn = pReq->pVirtqBuf->pSgPhysReturn;
+    virtioCoreGCPhysChainReset(pSgPhysReturn);
+    virtioCoreGCPhysChainAdvance(pSgPhysReturn, offDst);
+
+    size_t cbRemain = cbCopy;
+    while (cbRemain)
+    {
+        size_t cbCopied = RT_MIN(pSgBuf->cbSegLeft, pSgPhysReturn->cbSegLeft);
+        cbCopied = RT_MIN(cbCopied, cbRemain);
+        AssertBreak(cbCopied > 0);
+        PDMDevHlpPCIPhysWriteUser(pDevIns, pSgPhysReturn->GCPhysCur, pSgBuf->pvSegCur, cbCopied);
+        RTSgBufAdvance(pSgBuf, cbCopied);
+        virtioCoreGCPhysChainAdvance(pSgPhysReturn, cbCopied);
+        cbRemain -= cbCopied;
+    }
+
+    Log3Func((".... Copied %zu bytes at offset %u into %zu byte guest buffer\n", cbCopy, offDst, pReq->cbData));
+    return VINF_SUCCESS;
+}
+
+/**
+ * @interface_method_impl{PDMIMEDIAEXPORT,pfnIoReqCopyToBuf}
+ *
+ * Copy guest physical memory to media driver virtual memory.
+ */
+static DECLCALLBACK(int) virtioBlkR3IoReqCopyToBuf(PPDMIMEDIAEXPORT pInterface, PDMMEDIAEXIOREQ hIoReq,
+                                                   void *pvIoReqAlloc, uint32_t offSrc, PRTSGBUF pSgBuf, size_t cbCopy)
+{
+    PVIRTIOBLKCC    pThisCC = RT_FROM_MEMBER(pInterface, VIRTIOBLKCC, IMediaExPort);
+    PPDMDEVINS      pDevIns = pThisCC->pDevIns;
+    PVIRTIOBLKREQ   pReq    = (PVIRTIOBLKREQ)pvIoReqAlloc;
+    RT_NOREF(hIoReq);
+
+    AssertReturn(pReq->pVirtqBuf, VERR_INVALID_PARAMETER);
+    AssertReturn(offSrc <= pReq->cbData && cbCopy <= pReq->cbData - offSrc, VERR_BUFFER_OVERFLOW);
+
+    /* Without driver support write zeroes is backed by an ordinary write of a zero filled buffer. */
+    if (pReq->uType == VIRTIO_BLK_T_WRITE_ZEROES)
+    {
+        RTSgBufSet(pSgBuf, 0, cbCopy);
+        return VINF_SUCCESS;
+    }
+
+    PVIRTIOSGBUF pSgPhysSend = pReq->pVirtqBuf->pSgPhysSend;
+    virtioCoreGCPhysChainReset(pSgPhysSend);
+    virtioCoreGCPhysChainAdvance(pSgPhysSend, sizeof(VIRTIOBLK_REQ_HDR_T) + offSrc);
+
+    size_t cbRemain = cbCopy;
+    while (cbRemain)
+    {
+        size_t cbCopied = RT_MIN(pSgBuf->cbSegLeft, pSgPhysSend->cbSegLeft);
+        cbCopied = RT_MIN(cbCopied, cbRemain);
+        AssertBreak(cbCopied > 0);
+        PDMDevHlpPCIPhysReadUser(pDevIns, pSgPhysSend->GCPhysCur, pSgBuf->pvSegCur, cbCopied);
+        RTSgBufAdvance(pSgBuf, cbCopied);
+        virtioCoreGCPhysChainAdvance(pSgPhysSend, cbCopied);
+        cbRemain -= cbCopied;
+    }
+
+    Log3Func((".... Copied %zu bytes at offset %u from %zu byte guest buffer\n", cbCopy, offSrc, pReq->cbData));
+    return VINF_SUCCESS;
+}
+
+/**
+ * @interface_method_impl{PDMIMEDIAEXPORT,pfnIoReqQueryDiscardRanges}
+ */
+static DECLCALLBACK(int) virtioBlkR3IoReqQueryDiscardRanges(PPDMIMEDIAEXPORT pInterface, PDMMEDIAEXIOREQ hIoReq,
+                                                            void *pvIoReqAlloc, uint32_t idxRangeStart,
+                                                            uint32_t cRanges, PRTRANGE paRanges,
+                                                            uint32_t *pcRanges)
+{
+    PVIRTIOBLKREQ pReq = (PVIRTIOBLKREQ)pvIoReqAlloc;
+    RT_NOREF(pInterface, hIoReq);
+
+    uint32_t cRangesCopy = 0;
+    if (idxRangeStart < pReq->cRanges)
+    {
+        cRangesCopy = RT_MIN(cRanges, pReq->cRanges - idxRangeStart);
+        memcpy(paRanges, &pReq->paRanges[idxRangeStart], cRangesCopy * sizeof(RTRANGE));
+    }
+    *pcRanges = cRangesCopy;
+    return VINF_SUCCESS;
+}
+
+/**
+ * Reads the discard / write zeroes segments following the request header.
+ *
+ * @returns VBox status code.
+ * @param   pDevIns     The device instance.
+ * @param   pThis       VirtIO block shared instance data.
+ * @param   pVirtqBuf   The descriptor chain, positioned after the header.
+ * @param   cSegsMax    Maximum number of segments allowed.
+ * @param   cSectorsMax Maximum number of sectors per segment.
+ * @param   paSegs      Where to store the segments (cSegsMax entries).
+ * @param   pcSegs      Where to return the number of segments read.
+ */
+static int virtioBlkR3ReadSegments(PPDMDEVINS pDevIns, PVIRTIOBLK pThis, PVIRTQBUF pVirtqBuf, uint32_t cSegsMax,
+                                   uint32_t cSectorsMax, VIRTIOBLK_DISCARD_WZ_T *paSegs, uint32_t *pcSegs)
+{
+    size_t const cbSegs = pVirtqBuf->cbPhysSend - sizeof(VIRTIOBLK_REQ_HDR_T);
+    uint32_t const cSegs = (uint32_t)(cbSegs / sizeof(VIRTIOBLK_DISCARD_WZ_T));
+    ASSERT_GUEST_LOGREL_MSG_RETURN(   cSegs > 0
+                                   && cSegs <= cSegsMax
+                                   && cbSegs == cSegs * sizeof(VIRTIOBLK_DISCARD_WZ_T),
+                                   ("cbSegs=%#zx cSegsMax=%u\n", cbSegs, cSegsMax), VERR_OUT_OF_RANGE);
+
+    uint8_t *pb = (uint8_t *)paSegs;
+    for (size_t off = 0; off < cbSegs; )
+    {
+        size_t cbSeg = cbSegs - off;
+        RTGCPHYS GCPhys = virtioCoreGCPhysChainGetNextSeg(pVirtqBuf->pSgPhysSend, &cbSeg);
+        PDMDevHlpPCIPhysReadMeta(pDevIns, GCPhys, &pb[off], cbSeg);
+        off += cbSeg;
+    }
+
+    uint64_t const cSectorsDisk = pThis->virtioBlkConfig.uCapacity;
+    for (uint32_t i = 0; i < cSegs; i++)
+        ASSERT_GUEST_LOGREL_MSG_RETURN(   paSegs[i].cSectors <= cSectorsMax
+                                       && paSegs[i].uSector <= cSectorsDisk
+                                       && paSegs[i].cSectors <= cSectorsDisk - paSegs[i].uSector,
+                                       ("uSector=%RU64 cSectors=%RU32\n", paSegs[i].uSector, paSegs[i].cSectors),
+                                       VERR_OUT_OF_RANGE);
+    *pcSegs = cSegs;
+    return VINF_SUCCESS;
+}
+
+/**
+ * Handles request queues for/on a worker thread.
+ *
+ * @returns VBox status code (logged by caller).
+ */
+static int virtioBlkR3ReqSubmit(PPDMDEVINS pDevIns, PVIRTIOBLK pThis, PVIRTIOBLKCC pThisCC,
+                                uint16_t uVirtqNbr, PVIRTQBUF pVirtqBuf)
+{
+    /*
+     * The last device-writable byte is the status, there must be room for it.
+     */
+    ASSERT_GUEST_LOGREL_MSG_RETURN(pVirtqBuf->cbPhysReturn >= 1 && pVirtqBuf->cbPhysSend >= sizeof(VIRTIOBLK_REQ_HDR_T),
+                                   ("cbPhysSend=%#x cbPhysReturn=%#x\n", pVirtqBuf->cbPhysSend, pVirtqBuf->cbPhysReturn),
+                                   VERR_INVALID_PARAMETER);
+
+    /*
+     * Extract the request header from guest physical memory.
+     */
+    VIRTIOBLK_REQ_HDR_T ReqHdr;
+    uint8_t *pbHdr = (uint8_t *)&ReqHdr;
+    for (size_t offReq = 0; offReq < sizeof(ReqHdr); )
+    {
+        size_t cbSeg = sizeof(ReqHdr) - offReq;
+        RTGCPHYS GCPhys = virtioCoreGCPhysChainGetNextSeg(pVirtqBuf->pSgPhysSend, &cbSeg);
+        PDMDevHlpPCIPhysReadMeta(pDevIns, GCPhys, &pbHdr[offReq], cbSeg);
+        offReq += cbSeg;
+    }
+
+    Log2Func(("[%s] %s sector=%RU64 cbSend=%u cbReturn=%u\n", VIRTQNAME(uVirtqNbr),
+              virtioBlkGetReqTypeText(ReqHdr.uType), ReqHdr.uSector, pVirtqBuf->cbPhysSend, pVirtqBuf->cbPhysReturn));
+
+    if (RT_LIKELY(!pThis->fResetting && pThisCC->pDrvMediaEx))
+    { /* likely */ }
+    else
+    {
+        virtioBlkR3ReqComplete(pDevIns, pThis, pThisCC, uVirtqNbr, pVirtqBuf, 0 /*cbWritten*/, VIRTIO_BLK_S_IOERR);
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Validate the request and figure out the transfer size.
+     */
+    uint64_t const cSectorsDisk = pThis->virtioBlkConfig.uCapacity;
+    size_t         cbData       = 0;
+    uint32_t       cRanges      = 0;
+    PRTRANGE       paRanges     = NULL;
+    uint8_t        bStatus      = VIRTIO_BLK_S_OK;
+    switch (ReqHdr.uType)
+    {
+        case VIRTIO_BLK_T_IN:
+        case VIRTIO_BLK_T_OUT:
+        {
+            cbData = ReqHdr.uType == VIRTIO_BLK_T_IN
+                   ? pVirtqBuf->cbPhysReturn - 1
+                   : pVirtqBuf->cbPhysSend - sizeof(VIRTIOBLK_REQ_HDR_T);
+            if (   !cbData
+                || (cbData & (VIRTIOBLK_SECTOR_SIZE - 1))
+                || ReqHdr.uSector > cSectorsDisk
+                || (cbData >> VIRTIOBLK_SECTOR_SHIFT) > cSectorsDisk - ReqHdr.uSector)
+                bStatus = VIRTIO_BLK_S_IOERR;
+            else if (ReqHdr.uType == VIRTIO_BLK_T_OUT && pThis->fReadOnly)
+                bStatus = VIRTIO_BLK_S_IOERR;
+            break;
+        }
+        case VIRTIO_BLK_T_FLUSH:
+            break;
+        case VIRTIO_BLK_T_GET_ID:
+        {
+            /* Answered right here, no need to bother the driver below. */
+            size_t const cbId = RT_MIN(pVirtqBuf->cbPhysReturn - 1, (uint32_t)VIRTIOBLK_ID_BYTES);
+            virtioCoreGCPhysChainReset(pVirtqBuf->pSgPhysReturn);
+            for (size_t off = 0; off < cbId; )
+            {
+                size_t cbSeg = cbId - off;
+                RTGCPHYS GCPhys = virtioCoreGCPhysChainGetNextSeg(pVirtqBuf->pSgPhysReturn, &cbSeg);
+                PDMDevHlpPCIPhysWriteMeta(pDevIns, GCPhys, &pThis->szSerialNumber[off], cbSeg);
+                off += cbSeg;
+            }
+            virtioBlkR3ReqComplete(pDevIns, pThis, pThisCC, uVirtqNbr, pVirtqBuf, cbId, VIRTIO_BLK_S_OK);
+            return VINF_SUCCESS;
+        }
+        case VIRTIO_BLK_T_DISCARD:
+        {
+            if (!pThis->fHasDiscard || pThis->fReadOnly)
+            {
+                bStatus = VIRTIO_BLK_S_UNSUPP;
+                break;
+            }
+            VIRTIOBLK_DISCARD_WZ_T aSegs[VIRTIOBLK_MAX_DISCARD_SEG];
+            int rc = virtioBlkR3ReadSegments(pDevIns, pThis, pVirtqBuf, RT_ELEMENTS(aSegs), VIRTIOBLK_MAX_DISCARD_SECTORS,
+                                             &aSegs[0], &cRanges);
+            if (RT_FAILURE(rc))
+            {
+                bStatus = VIRTIO_BLK_S_IOERR;
+                break;
+            }
+            paRanges = (PRTRANGE)RTMemAlloc(cRanges * sizeof(RTRANGE));
+            if (!paRanges)
+            {
+                bStatus = VIRTIO_BLK_S_IOERR;
+                break;
+            }
+            for (uint32_t i = 0; i < cRanges; i++)
+            {
+                paRanges[i].offStart = aSegs[i].uSector << VIRTIOBLK_SECTOR_SHIFT;
+                paRanges[i].cbRange  = (size_t)aSegs[i].cSectors << VIRTIOBLK_SECTOR_SHIFT;
+            }
+            break;
+        }
+        case VIRTIO_BLK_T_WRITE_ZEROES:
+        {
+            if (!pThis->fHasWriteZeroes || pThis->fReadOnly)
+            {
+                bStatus = VIRTIO_BLK_S_UNSUPP;
+                break;
+            }
+            VIRTIOBLK_DISCARD_WZ_T aSegs[VIRTIOBLK_MAX_WRITE_ZEROES_SEG];
+            uint32_t cSegs = 0;
+            int rc = virtioBlkR3ReadSegments(pDevIns, pThis, pVirtqBuf, RT_ELEMENTS(aSegs), VIRTIOBLK_MAX_WRITE_ZEROES_SECTORS,
+                                             &aSegs[0], &cSegs);
+            if (RT_FAILURE(rc) || !aSegs[0].cSectors)
+            {
+                bStatus = VIRTIO_BLK_S_IOERR;
+                break;
+            }
+            /* The unmap flag is only a permission, zeroing the blocks is always correct. */
+            ReqHdr.uSector = aSegs[0].uSector;
+            cbData         = (size_t)aSegs[0].cSectors << VIRTIOBLK_SECTOR_SHIFT;
+            break;
+        }
+        default:
+            LogFunc(("Unsupported request type %#x on %s\n", ReqHdr.uType, VIRTQNAME(uVirtqNbr)));
+            bStatus = VIRTIO_BLK_S_UNSUPP;
+            break;
+    }
+
+    if (bStatus != VIRTIO_BLK_S_OK)
+    {
+        Assert(!paRanges);
+        virtioBlkR3ReqComplete(pDevIns, pThis, pThisCC, uVirtqNbr, pVirtqBuf, 0 /*cbWritten*/, bStatus);
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Have underlying driver allocate a req of size set during initialization of this device.
+     */
+    virtioBlkR3Retain(pThis);
+
+    PDMMEDIAEXIOREQ     hIoReq    = NULL;
+    PVIRTIOBLKREQ       pReq      = NULL;
+    PPDMIMEDIAEX        pIMediaEx = pThisCC->pDrvMediaEx;
+
+    int rc = pIMediaEx->pfnIoReqAlloc(pIMediaEx, &hIoReq, (void **)&pReq, 0 /* uIoReqId */,
+                                      PDMIMEDIAEX_F_SUSPEND_ON_RECOVERABLE_ERR);
+    if (RT_FAILURE(rc))
+    {
+        RTMemFree(paRanges);
+        virtioBlkR3ReqComplete(pDevIns, pThis, pThisCC, uVirtqNbr, pVirtqBuf, 0 /*cbWritten*/, VIRTIO_BLK_S_IOERR);
+        virtioBlkR3Release(pDevIns, pThis, pThisCC);
+        return rc;
+    }
+
+    pReq->hIoReq      = hIoReq;
+    pReq->uVirtqNbr   = uVirtqNbr;
+    pReq->uType       = ReqHdr.uType;
+    pReq->cbData      = cbData;
+    pReq->cRanges     = cRanges;
+    pReq->paRanges    = paRanges;
+    pReq->pVirtqBuf   = pVirtqBuf;
+    virtioCoreR3VirtqBufRetain(pVirtqBuf); /* (For pReq->pVirtqBuf. Released by virtioBlkR3FreeReq.) */
+
+    uint64_t const offDisk = ReqHdr.uSector << VIRTIOBLK_SECTOR_SHIFT;
+    switch (ReqHdr.uType)
+    {
+        case VIRTIO_BLK_T_IN:
+            pThisCC->Led.Asserted.s.fReading = pThisCC->Led.Actual.s.fReading = 1;
+            rc = pIMediaEx->pfnIoReqRead(pIMediaEx, hIoReq, offDisk, cbData);
+            break;
+        case VIRTIO_BLK_T_OUT:
+            pThisCC->Led.Asserted.s.fWriting = pThisCC->Led.Actual.s.fWriting = 1;
+            rc = pIMediaEx->pfnIoReqWrite(pIMediaEx, hIoReq, offDisk, cbData);
+            break;
+        case VIRTIO_BLK_T_WRITE_ZEROES:
+            pThisCC->Led.Asserted.s.fWriting = pThisCC->Led.Actual.s.fWriting = 1;
+            if (pThis->fMediaWriteZeroes)
+                rc = pIMediaEx->pfnIoReqWriteZeroes(pIMediaEx, hIoReq, offDisk, cbData);
+            else
+                rc = pIMediaEx->pfnIoReqWrite(pIMediaEx, hIoReq, offDisk, cbData);
+            break;
+        case VIRTIO_BLK_T_FLUSH:
+            rc = pIMediaEx->pfnIoReqFlush(pIMediaEx, hIoReq);
+            break;
+        case VIRTIO_BLK_T_DISCARD:
+            pThisCC->Led.Asserted.s.fWriting = pThisCC->Led.Actual.s.fWriting = 1;
+            rc = pIMediaEx->pfnIoReqDiscard(pIMediaEx, hIoReq, cRanges);
+            break;
+        default:
+            AssertFailedStmt(rc = VERR_INTERNAL_ERROR_3);
+            break;
+    }
+
+    /*
+     * Anything but in-progress means there will be no completion callback for this request.
+     */
+    if (rc != VINF_PDM_MEDIAEX_IOREQ_IN_PROGRESS)
+        virtioBlkR3ReqFinish(pDevIns, pThis, pThisCC, pReq, rc);
+    return VINF_SUCCESS;
+}
+
+/**
+ * @callback_method_impl{FNPDMTHREADWAKEUPDEV}
+ */
+static DECLCALLBACK(int) virtioBlkR3WorkerWakeUp(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    PVIRTIOBLK pThis = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    return PDMDevHlpSUPSemEventSignal(pDevIns, pThis->aWorkers[(uintptr_t)pThread->pvUser].hEvtProcess);
+}
+
+/**
+ * @callback_method_impl{FNPDMTHREADDEV}
+ */
+static DECLCALLBACK(int) virtioBlkR3WorkerThread(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    uint16_t const      uVirtqNbr  = (uint16_t)(uintptr_t)pThread->pvUser;
+    PVIRTIOBLK          pThis     = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    PVIRTIOBLKCC        pThisCC   = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+    PVIRTIOBLKWORKER    pWorker   = &pThis->aWorkers[uVirtqNbr];
+    PVIRTIOBLKWORKERR3  pWorkerR3 = &pThisCC->aWorkers[uVirtqNbr];
+
+    if (pThread->enmState == PDMTHREADSTATE_INITIALIZING)
+        return VINF_SUCCESS;
+
+    Log6Func(("[Re]starting %s worker\n", VIRTQNAME(uVirtqNbr)));
+    while (pThread->enmState == PDMTHREADSTATE_RUNNING)
+    {
+        if (    !pWorkerR3->cRedoDescs
+             && IS_VIRTQ_EMPTY(pDevIns, &pThis->Virtio, uVirtqNbr))
+        {
+            /* Atomic interlocks avoid missing alarm while going to sleep & notifier waking the awoken */
+            ASMAtomicWriteBool(&pWorker->fSleeping, true);
+            bool fNotificationSent = ASMAtomicXchgBool(&pWorker->fNotified, false);
+            if (!fNotificationSent)
+            {
+                Log6Func(("%s worker sleeping...\n", VIRTQNAME(uVirtqNbr)));
+                Assert(ASMAtomicReadBool(&pWorker->fSleeping));
+                int rc = PDMDevHlpSUPSemEventWaitNoResume(pDevIns, pWorker->hEvtProcess, RT_INDEFINITE_WAIT);
+                AssertLogRelMsgReturn(RT_SUCCESS(rc) || rc == VERR_INTERRUPTED, ("%Rrc\n", rc), rc);
+                if (RT_UNLIKELY(pThread->enmState != PDMTHREADSTATE_RUNNING))
+                {
+                    Log6Func(("%s worker thread not running, exiting\n", VIRTQNAME(uVirtqNbr)));
+                    return VINF_SUCCESS;
+                }
+                if (rc == VERR_INTERRUPTED)
+                {
+                    Log6Func(("%s worker interrupted ... continuing\n", VIRTQNAME(uVirtqNbr)));
+                    continue;
+                }
+                Log6Func(("%s worker woken\n", VIRTQNAME(uVirtqNbr)));
+                ASMAtomicWriteBool(&pWorker->fNotified, false);
+            }
+            ASMAtomicWriteBool(&pWorker->fSleeping, false);
+        }
+        if (!virtioCoreIsVirtqEnabled(&pThis->Virtio, uVirtqNbr))
+        {
+            LogFunc(("%s queue not enabled, worker aborting...\n", VIRTQNAME(uVirtqNbr)));
+            break;
+        }
+
+        if (!pThis->afVirtqAttached[uVirtqNbr])
+        {
+            LogFunc(("%s queue not attached, worker aborting...\n", VIRTQNAME(uVirtqNbr)));
+            break;
+        }
+        if (!pThisCC->fQuiescing)
+        {
+            /* Process any reqs that were suspended saved to the redo queue in save exec. */
+            for (int i = 0; i < pWorkerR3->cRedoDescs; i++)
+            {
+                PVIRTQBUF pVirtqBuf = virtioCoreR3VirtqBufAlloc();
+                if (!pVirtqBuf)
+                {
+                    LogRel(("Failed to allocate memory for VIRTQBUF\n"));
+                    break;  /* No point in trying to allocate memory for other descriptor chains */
+                }
+                int rc = virtioCoreR3VirtqAvailBufGet(pDevIns, &pThis->Virtio, uVirtqNbr,
+                                                      pWorkerR3->auRedoDescs[i], pVirtqBuf);
+                if (RT_FAILURE(rc))
+                    LogRel(("Error fetching desc chain to redo, %Rrc", rc));
+
+                rc = virtioBlkR3ReqSubmit(pDevIns, pThis, pThisCC, uVirtqNbr, pVirtqBuf);
+                if (RT_FAILURE(rc))
+                    LogRel(("Error submitting req packet, resetting %Rrc", rc));
+
+                virtioCoreR3VirtqBufRelease(&pThis->Virtio, pVirtqBuf);
+            }
+            pWorkerR3->cRedoDescs = 0;
+
+            Log6Func(("fetching next descriptor chain from %s\n", VIRTQNAME(uVirtqNbr)));
+            PVIRTQBUF pVirtqBuf = virtioCoreR3VirtqBufAlloc();
+            if (!pVirtqBuf)
+                LogRel(("Failed to allocate memory for VIRTQBUF\n"));
+            else
+            {
+                int rc = virtioCoreR3VirtqAvailBufGet(pDevIns, &pThis->Virtio, uVirtqNbr, pVirtqBuf, true);
+                if (rc == VERR_NOT_AVAILABLE)
+                {
+                    Log6Func(("Nothing found in %s\n", VIRTQNAME(uVirtqNbr)));
+                    virtioCoreR3VirtqBufRelease(&pThis->Virtio, pVirtqBuf);
+                    continue;
+                }
+
+                AssertRC(rc);
+                rc = virtioBlkR3ReqSubmit(pDevIns, pThis, pThisCC, uVirtqNbr, pVirtqBuf);
+                if (RT_FAILURE(rc))
+                    LogRel(("Error submitting req packet, resetting %Rrc", rc));
+
+                virtioCoreR3VirtqBufRelease(&pThis->Virtio, pVirtqBuf);
+            }
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+/**
+ * @callback_method_impl{VIRTIOCORER3,pfnStatusChanged}
+ */
+static DECLCALLBACK(void) virtioBlkR3StatusChanged(PVIRTIOCORE pVirtio, PVIRTIOCORECC pVirtioCC, uint32_t fVirtioReady)
+{
+    PVIRTIOBLK      pThis     = RT_FROM_MEMBER(pVirtio, VIRTIOBLK, Virtio);
+    PVIRTIOBLKCC    pThisCC   = RT_FROM_MEMBER(pVirtioCC, VIRTIOBLKCC, Virtio);
+
+    pThis->fVirtioReady = fVirtioReady;
+
+    if (fVirtioReady)
+    {
+        LogFunc(("VirtIO ready\n-----------------------------------------------------------------------------------------\n"));
+        uint64_t fFeatures     = virtioCoreGetNegotiatedFeatures(&pThis->Virtio);
+        pThis->fHasMq          = RT_BOOL(fFeatures & VIRTIO_BLK_F_MQ);
+        pThis->fHasDiscard     = RT_BOOL(fFeatures & VIRTIO_BLK_F_DISCARD);
+        pThis->fHasWriteZeroes = RT_BOOL(fFeatures & VIRTIO_BLK_F_WRITE_ZEROES);
+        pThis->fResetting      = false;
+        pThisCC->fQuiescing    = false;
+
+        for (unsigned i = 0; i < pThis->cVirtqs; i++)
+            pThis->afVirtqAttached[i] = true;
+    }
+    else
+    {
+        LogFunc(("VirtIO is resetting\n"));
+        for (unsigned i = 0; i < pThis->cVirtqs; i++)
+            pThis->afVirtqAttached[i] = false;
+    }
+}
+
+
+/*********************************************************************************************************************************
+*   LEDs                                                                                                                         *
+*********************************************************************************************************************************/
+
+/**
+ * @interface_method_impl{PDMILEDPORTS,pfnQueryStatusLed}
+ */
+static DECLCALLBACK(int) virtioBlkR3QueryStatusLed(PPDMILEDPORTS pInterface, unsigned iLUN, PPDMLED *ppLed)
+{
+    PVIRTIOBLKCC pThisCC = RT_FROM_MEMBER(pInterface, VIRTIOBLKCC, ILeds);
+    if (iLUN == 0)
+    {
+        *ppLed = &pThisCC->Led;
+        Assert((*ppLed)->u32Magic == PDMLED_MAGIC);
+        return VINF_SUCCESS;
+    }
+    return VERR_PDM_LUN_NOT_FOUND;
+}
+
+
+/*********************************************************************************************************************************
+*   PDMIMEDIAPORT                                                                                                                *
+*********************************************************************************************************************************/
+
+/**
+ * @interface_method_impl{PDMIMEDIAPORT,pfnQueryDeviceLocation}
+ */
+static DECLCALLBACK(int) virtioBlkR3QueryDeviceLocation(PPDMIMEDIAPORT pInterface, const char **ppcszController,
+                                                        uint32_t *piInstance, uint32_t *piLUN)
+{
+    PVIRTIOBLKCC pThisCC = RT_FROM_MEMBER(pInterface, VIRTIOBLKCC, IMediaPort);
+    PPDMDEVINS   pDevIns = pThisCC->pDevIns;
+
+    AssertPtrReturn(ppcszController, VERR_INVALID_POINTER);
+    AssertPtrReturn(piInstance, VERR_INVALID_POINTER);
+    AssertPtrReturn(piLUN, VERR_INVALID_POINTER);
+
+    *ppcszController = pDevIns->pReg->szName;
+    *piInstance = pDevIns->iInstance;
+    *piLUN = 0;
+
+    return VINF_SUCCESS;
+}
+
+
+/*********************************************************************************************************************************
+*   Virtio config.                                                                                                               *
+*********************************************************************************************************************************/
+
+/**
+ * Worker for virtioBlkR3DevCapWrite and virtioBlkR3DevCapRead.
+ */
+static int virtioBlkR3CfgAccessed(PVIRTIOBLK pThis, uint32_t uOffsetOfAccess, void *pv, uint32_t cb, bool fWrite)
+{
+    AssertReturn(pv && cb <= sizeof(uint32_t), fWrite ? VINF_SUCCESS : VINF_IOM_MMIO_UNUSED_00);
+
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uCapacity,               VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uCapacity,               VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uSizeMax,                VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uSizeMax,                VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uSegMax,                 VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uSegMax,                 VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uCylinders,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uCylinders,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uHeads,                  VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uHeads,                  VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uSectors,                VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uSectors,                VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uBlkSize,                VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uBlkSize,                VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uPhysBlkExp,             VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uPhysBlkExp,             VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uAlignmentOffset,        VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uAlignmentOffset,        VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uMinIoSize,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uMinIoSize,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uOptIoSize,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uOptIoSize,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uWriteback,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uWriteback,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uNumQueues,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uNumQueues,              VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uMaxDiscardSectors,      VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uMaxDiscardSectors,      VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uMaxDiscardSeg,          VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uMaxDiscardSeg,          VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uDiscardSectorAlignment, VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uDiscardSectorAlignment, VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uMaxWriteZeroesSectors,  VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uMaxWriteZeroesSectors,  VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uMaxWriteZeroesSeg,      VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uMaxWriteZeroesSeg,      VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(    uWriteZeroesMayUnmap,    VIRTIOBLK_CONFIG_T, uOffsetOfAccess))
+        VIRTIO_DEV_CONFIG_ACCESS_READONLY( uWriteZeroesMayUnmap,    VIRTIOBLK_CONFIG_T, uOffsetOfAccess, &pThis->virtioBlkConfig);
+    else
+    {
+        LogFunc(("Bad access by guest to virtio_blk_config: off=%u (%#x), cb=%u\n", uOffsetOfAccess, uOffsetOfAccess, cb));
+        return fWrite ? VINF_SUCCESS : VINF_IOM_MMIO_UNUSED_00;
+    }
+    return VINF_SUCCESS;
+}
+
+/**
+ * @callback_method_impl{VIRTIOCORER3,pfnDevCapRead}
+ */
+static DECLCALLBACK(int) virtioBlkR3DevCapRead(PPDMDEVINS pDevIns, uint32_t uOffset, void *pv, uint32_t cb)
+{
+    return virtioBlkR3CfgAccessed(PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK), uOffset, pv, cb, false /*fRead*/);
+}
+
+/**
+ * @callback_method_impl{VIRTIOCORER3,pfnDevCapWrite}
+ */
+static DECLCALLBACK(int) virtioBlkR3DevCapWrite(PPDMDEVINS pDevIns, uint32_t uOffset, const void *pv, uint32_t cb)
+{
+    return virtioBlkR3CfgAccessed(PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK), uOffset, (void *)pv, cb, true /*fWrite*/);
+}
+
+
+/*********************************************************************************************************************************
+*   IBase                                                                                                                        *
+*********************************************************************************************************************************/
+
+/**
+ * @interface_method_impl{PDMIBASE,pfnQueryInterface}
+ */
+static DECLCALLBACK(void *) virtioBlkR3QueryInterface(PPDMIBASE pInterface, const char *pszIID)
+{
+    PVIRTIOBLKCC pThisCC = RT_FROM_MEMBER(pInterface, VIRTIOBLKCC, IBase);
+
+    PDMIBASE_RETURN_INTERFACE(pszIID, PDMIBASE,         &pThisCC->IBase);
+    PDMIBASE_RETURN_INTERFACE(pszIID, PDMIMEDIAPORT,    &pThisCC->IMediaPort);
+    PDMIBASE_RETURN_INTERFACE(pszIID, PDMIMEDIAEXPORT,  &pThisCC->IMediaExPort);
+    PDMIBASE_RETURN_INTERFACE(pszIID, PDMILEDPORTS,     &pThisCC->ILeds);
+
+    return NULL;
+}
+
+
+/*********************************************************************************************************************************
+*   Misc                                                                                                                         *
+*********************************************************************************************************************************/
+
+/**
+ * @callback_method_impl{FNDBGFHANDLERDEV, virtio-blk debugger info callback.}
+ */
+static DECLCALLBACK(void) virtioBlkR3Info(PPDMDEVINS pDevIns, PCDBGFINFOHLP pHlp, const char *pszArgs)
+{
+    PVIRTIOBLK pThis = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    RT_NOREF(pszArgs);
+
+    pHlp->pfnPrintf(pHlp, "%s#%d: %RU16 request queues, serial '%s'\n",
+                    pDevIns->pReg->szName, pDevIns->iInstance, pThis->cVirtqs, pThis->szSerialNumber);
+
+    pHlp->pfnPrintf(pHlp, "Config: uCapacity=%RU64 uSegMax=%RU32 uBlkSize=%RU32 uNumQueues=%RU16\n",
+                    pThis->virtioBlkConfig.uCapacity, pThis->virtioBlkConfig.uSegMax,
+                    pThis->virtioBlkConfig.uBlkSize, pThis->virtioBlkConfig.uNumQueues);
+    pHlp->pfnPrintf(pHlp, "        uMaxDiscardSectors=%RU32 uMaxDiscardSeg=%RU32 uMaxWriteZeroesSectors=%RU32\n",
+                    pThis->virtioBlkConfig.uMaxDiscardSectors, pThis->virtioBlkConfig.uMaxDiscardSeg,
+                    pThis->virtioBlkConfig.uMaxWriteZeroesSectors);
+
+    pHlp->pfnPrintf(pHlp, "Negotiated: %s%s%s%s\n",
+                    pThis->fHasMq          ? "MQ "           : "",
+                    pThis->fHasDiscard     ? "DISCARD "      : "",
+                    pThis->fHasWriteZeroes ? "WRITE_ZEROES " : "",
+                    pThis->fReadOnly       ? "RO "           : "");
+
+    pHlp->pfnPrintf(pHlp, "Active requests: %RU32\n", ASMAtomicReadU32(&pThis->cActiveReqs));
+
+    if (pThis->fVirtioReady)
+        pHlp->pfnPrintf(pHlp, "Device is ready\n");
+    else
+        pHlp->pfnPrintf(pHlp, "Device is not ready!\n");
+
+    if (pThis->fResetting)
+        pHlp->pfnPrintf(pHlp, "Device is resetting!\n");
+}
+
+
+/*********************************************************************************************************************************
+*   Saved state                                                                                                                  *
+*********************************************************************************************************************************/
+
+/**
+ * @callback_method_impl{FNSSMDEVLOADEXEC}
+ */
+static DECLCALLBACK(int) virtioBlkR3LoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uint32_t uVersion, uint32_t uPass)
+{
+    PVIRTIOBLK      pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    PVIRTIOBLKCC    pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+    PCPDMDEVHLPR3   pHlp    = pDevIns->pHlpR3;
+
+    AssertReturn(uPass == SSM_PASS_FINAL, VERR_SSM_UNEXPECTED_PASS);
+    AssertLogRelMsgReturn(uVersion == VIRTIOBLK_SAVED_STATE_VERSION,
+                          ("uVersion=%u\n", uVersion), VERR_SSM_UNSUPPORTED_DATA_UNIT_VERSION);
+
+    uint16_t cVirtqs;
+    int rc = pHlp->pfnSSMGetU16(pSSM, &cVirtqs);
+    AssertRCReturn(rc, rc);
+    AssertReturn(cVirtqs == pThis->cVirtqs,
+                 pHlp->pfnSSMSetLoadError(pSSM, VERR_SSM_LOAD_CONFIG_MISMATCH, RT_SRC_POS,
+                                          N_("request queue count has changed: %u saved, %u configured now"),
+                                          cVirtqs, pThis->cVirtqs));
+
+    virtioBlkSetVirtqNames(pThis);
+    for (uint16_t uVirtqNbr = 0; uVirtqNbr < pThis->cVirtqs; uVirtqNbr++)
+        pHlp->pfnSSMGetBool(pSSM, &pThis->afVirtqAttached[uVirtqNbr]);
+
+    pHlp->pfnSSMGetU32(pSSM,  &pThis->fVirtioReady);
+    pHlp->pfnSSMGetU32(pSSM,  &pThis->fHasMq);
+    pHlp->pfnSSMGetU32(pSSM,  &pThis->fHasDiscard);
+    pHlp->pfnSSMGetU32(pSSM,  &pThis->fHasWriteZeroes);
+    pHlp->pfnSSMGetU32(pSSM,  &pThis->fResetting);
+
+    for (uint16_t uVirtqNbr = 0; uVirtqNbr < pThis->cVirtqs; uVirtqNbr++)
+        pThisCC->aWorkers[uVirtqNbr].cRedoDescs = 0;
+
+    /* Place all suspended requests in the request queue. */
+    uint16_t cReqsRedo;
+    rc = pHlp->pfnSSMGetU16(pSSM, &cReqsRedo);
+    AssertRCReturn(rc, rc);
+    AssertReturn(cReqsRedo < VIRTQ_SIZE,
+                 pHlp->pfnSSMSetLoadError(pSSM, VERR_SSM_DATA_UNIT_FORMAT_CHANGED, RT_SRC_POS,
+                                          N_("Bad count of I/O transactions to re-do in saved state (%#x, max %#x - 1)"),
+                                          cReqsRedo, VIRTQ_SIZE));
+
+    for (int i = 0; i < cReqsRedo; i++)
+    {
+        uint16_t uVirtqNbr;
+        rc = pHlp->pfnSSMGetU16(pSSM, &uVirtqNbr);
+        AssertRCReturn(rc, rc);
+        AssertReturn(uVirtqNbr < pThis->cVirtqs,
+                     pHlp->pfnSSMSetLoadError(pSSM, VERR_SSM_DATA_UNIT_FORMAT_CHANGED, RT_SRC_POS,
+                                              N_("Bad queue index for re-do in saved state (%#x, max %#x)"),
+                                              uVirtqNbr, pThis->cVirtqs - 1));
+
+        uint16_t idxHead;
+        rc = pHlp->pfnSSMGetU16(pSSM, &idxHead);
+        AssertRCReturn(rc, rc);
+        AssertReturn(idxHead < VIRTQ_SIZE,
+                     pHlp->pfnSSMSetLoadError(pSSM, VERR_SSM_DATA_UNIT_FORMAT_CHANGED, RT_SRC_POS,
+                                              N_("Bad queue element index for re-do in saved state (%#x, max %#x)"),
+                                              idxHead, VIRTQ_SIZE - 1));
+
+        PVIRTIOBLKWORKERR3 pWorkerR3 = &pThisCC->aWorkers[uVirtqNbr];
+        pWorkerR3->auRedoDescs[pWorkerR3->cRedoDescs++] = idxHead;
+        pWorkerR3->cRedoDescs %= VIRTQ_SIZE;
+    }
+
+    /*
+     * Call the virtio core to let it load its state.
+     */
+    rc = virtioCoreR3ModernDeviceLoadExec(&pThis->Virtio, pDevIns->pHlpR3, pSSM,
+                                          uVersion, VIRTIOBLK_SAVED_STATE_VERSION, pThis->cVirtqs);
+
+    /*
+     * Nudge request queue workers
+     */
+    for (uint16_t uVirtqNbr = 0; uVirtqNbr < pThis->cVirtqs; uVirtqNbr++)
+    {
+        if (pThis->afVirtqAttached[uVirtqNbr])
+        {
+            LogFunc(("Waking %s worker.\n", VIRTQNAME(uVirtqNbr)));
+            int rc2 = PDMDevHlpSUPSemEventSignal(pDevIns, pThis->aWorkers[uVirtqNbr].hEvtProcess);
+            AssertRCReturn(rc2, rc2);
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * @callback_method_impl{FNSSMDEVSAVEEXEC}
+ */
+static DECLCALLBACK(int) virtioBlkR3SaveExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
+{
+    PVIRTIOBLK      pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    PVIRTIOBLKCC    pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+    PCPDMDEVHLPR3   pHlp    = pDevIns->pHlpR3;
+
+    pHlp->pfnSSMPutU16(pSSM, pThis->cVirtqs);
+    for (uint16_t uVirtqNbr = 0; uVirtqNbr < pThis->cVirtqs; uVirtqNbr++)
+        pHlp->pfnSSMPutBool(pSSM, pThis->afVirtqAttached[uVirtqNbr]);
+
+    pHlp->pfnSSMPutU32(pSSM,  pThis->fVirtioReady);
+    pHlp->pfnSSMPutU32(pSSM,  pThis->fHasMq);
+    pHlp->pfnSSMPutU32(pSSM,  pThis->fHasDiscard);
+    pHlp->pfnSSMPutU32(pSSM,  pThis->fHasWriteZeroes);
+    pHlp->pfnSSMPutU32(pSSM,  pThis->fResetting);
+
+    AssertMsg(!pThis->cActiveReqs, ("There are still outstanding requests on this device\n"));
+
+    /* Query all suspended requests and store them in the request queue. */
+    uint32_t cReqsRedo = pThisCC->pDrvMediaEx ? pThisCC->pDrvMediaEx->pfnIoReqGetSuspendedCount(pThisCC->pDrvMediaEx) : 0;
+    pHlp->pfnSSMPutU16(pSSM, (uint16_t)cReqsRedo);
+    if (cReqsRedo)
+    {
+        PDMMEDIAEXIOREQ hIoReq;
+        PVIRTIOBLKREQ   pReq;
+        int rc = pThisCC->pDrvMediaEx->pfnIoReqQuerySuspendedStart(pThisCC->pDrvMediaEx, &hIoReq, (void **)&pReq);
+        AssertRCReturn(rc, rc);
+
+        for (;;)
+        {
+            pHlp->pfnSSMPutU16(pSSM, pReq->uVirtqNbr);
+            pHlp->pfnSSMPutU16(pSSM, pReq->pVirtqBuf->uHeadIdx);
+            if (!--cReqsRedo)
+                break;
+
+            rc = pThisCC->pDrvMediaEx->pfnIoReqQuerySuspendedNext(pThisCC->pDrvMediaEx, hIoReq, &hIoReq, (void **)&pReq);
+            AssertRCReturn(rc, rc);
+        }
+    }
+
+    /*
+     * Call the virtio core to let it save its state.
+     */
+    return virtioCoreR3SaveExec(&pThis->Virtio, pDevIns->pHlpR3, pSSM, VIRTIOBLK_SAVED_STATE_VERSION, pThis->cVirtqs);
+}
+
+
+/*********************************************************************************************************************************
+*   Device interface.                                                                                                            *
+*********************************************************************************************************************************/
+
+/**
+ * Attaches the media driver of LUN\#0 and queries its interfaces.
+ *
+ * @returns VBox status code.
+ * @param   pDevIns     The device instance.
+ * @param   pThisCC     VirtIO block ring-3 instance data.
+ */
+static int virtioBlkR3AttachLun(PPDMDEVINS pDevIns, PVIRTIOBLKCC pThisCC)
+{
+    int rc = PDMDevHlpDriverAttach(pDevIns, 0, &pThisCC->IBase, &pThisCC->pDrvBase, "LUN#0");
+    if (RT_SUCCESS(rc))
+    {
+        pThisCC->pDrvMedia = PDMIBASE_QUERY_INTERFACE(pThisCC->pDrvBase, PDMIMEDIA);
+        AssertMsgReturn(RT_VALID_PTR(pThisCC->pDrvMedia),
+                        ("virtio-blk configuration error: LUN#0 missing basic media interface!\n"),
+                        VERR_PDM_MISSING_INTERFACE);
+
+        /* Get the extended media interface. */
+        pThisCC->pDrvMediaEx = PDMIBASE_QUERY_INTERFACE(pThisCC->pDrvBase, PDMIMEDIAEX);
+        AssertMsgReturn(RT_VALID_PTR(pThisCC->pDrvMediaEx),
+                        ("virtio-blk configuration error: LUN#0 missing extended media interface!\n"),
+                        VERR_PDM_MISSING_INTERFACE);
+
+        rc = pThisCC->pDrvMediaEx->pfnIoReqAllocSizeSet(pThisCC->pDrvMediaEx, sizeof(VIRTIOBLKREQ));
+        AssertMsgRCReturn(rc, ("virtio-blk configuration error: LUN#0: Failed to set I/O request size!\n"), rc);
+    }
+
+    if (RT_FAILURE(rc))
+    {
+        pThisCC->pDrvBase    = NULL;
+        pThisCC->pDrvMedia   = NULL;
+        pThisCC->pDrvMediaEx = NULL;
+    }
+    return rc;
+}
+
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnDetach}
+ *
+ * The medium has been unplugged.  The VM is suspended at this point.
+ */
+static DECLCALLBACK(void) virtioBlkR3Detach(PPDMDEVINS pDevIns, unsigned iLUN, uint32_t fFlags)
+{
+    PVIRTIOBLKCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+    AssertReturnVoid(iLUN == 0);
+
+    AssertMsg(fFlags & PDM_TACH_FLAGS_NOT_HOT_PLUG,
+              ("virtio-blk: Device does not support hotplugging\n"));
+    RT_NOREF(fFlags);
+
+    pThisCC->pDrvBase    = NULL;
+    pThisCC->pDrvMedia   = NULL;
+    pThisCC->pDrvMediaEx = NULL;
+}
+
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnAttach}
+ */
+static DECLCALLBACK(int) virtioBlkR3Attach(PPDMDEVINS pDevIns, unsigned iLUN, uint32_t fFlags)
+{
+    PVIRTIOBLKCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+    AssertReturn(iLUN == 0, VERR_PDM_LUN_NOT_FOUND);
+    AssertMsgReturn(fFlags & PDM_TACH_FLAGS_NOT_HOT_PLUG,
+                    ("virtio-blk: Device does not support hotplugging\n"),
+                    VERR_INVALID_PARAMETER);
+    AssertRelease(!pThisCC->pDrvBase);
+
+    return virtioBlkR3AttachLun(pDevIns, pThisCC);
+}
+
+/**
+ * @callback_method_impl{FNPDMDEVASYNCNOTIFY}
+ */
+static DECLCALLBACK(bool) virtioBlkR3DeviceQuiesced(PPDMDEVINS pDevIns)
+{
+    PVIRTIOBLK      pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    PVIRTIOBLKCC    pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+
+    if (ASMAtomicReadU32(&pThis->cActiveReqs))
+        return false;
+
+    LogFunc(("Device I/O activity quiesced: %s\n",
+        virtioCoreGetStateChangeText(pThisCC->enmQuiescingFor)));
+
+    virtioCoreR3VmStateChanged(&pThis->Virtio, pThisCC->enmQuiescingFor);
+
+    pThis->fResetting = false;
+    pThisCC->fQuiescing = false;
+
+    return true;
+}
+
+/**
+ * Worker for virtioBlkR3Reset() and virtioBlkR3SuspendOrPowerOff().
+ */
+static void virtioBlkR3QuiesceDevice(PPDMDEVINS pDevIns, VIRTIOVMSTATECHANGED enmQuiscingFor)
+{
+    PVIRTIOBLK      pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    PVIRTIOBLKCC    pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+
+    /* Prevent worker threads from removing/processing elements from virtq's */
+    pThisCC->fQuiescing = true;
+    pThisCC->enmQuiescingFor = enmQuiscingFor;
+
+    PDMDevHlpSetAsyncNotification(pDevIns, virtioBlkR3DeviceQuiesced);
+
+    /* If already quiesced invoke async callback.  */
+    if (!ASMAtomicReadU32(&pThis->cActiveReqs))
+        PDMDevHlpAsyncNotificationCompleted(pDevIns);
+}
+
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnReset}
+ */
+static DECLCALLBACK(void) virtioBlkR3Reset(PPDMDEVINS pDevIns)
+{
+    LogFunc(("\n"));
+    PVIRTIOBLK pThis = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    pThis->fResetting = true;
+    virtioBlkR3QuiesceDevice(pDevIns, kvirtIoVmStateChangedReset);
+}
+
+/**
+ * Worker for virtioBlkR3Suspend() and virtioBlkR3PowerOff().
+ */
+static void virtioBlkR3SuspendOrPowerOff(PPDMDEVINS pDevIns, VIRTIOVMSTATECHANGED enmType)
+{
+    LogFunc(("\n"));
+
+    PVIRTIOBLKCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+
+    /* VM is halted, thus no new I/O being dumped into queues by the guest.
+     * Tell the driver below to suspend its requests, we get a state change
+     * callback for each of them. */
+    if (pThisCC->pDrvMediaEx)
+        pThisCC->pDrvMediaEx->pfnNotifySuspend(pThisCC->pDrvMediaEx);
+
+    virtioBlkR3QuiesceDevice(pDevIns, enmType);
+}
+
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnPowerOff}
+ */
+static DECLCALLBACK(void) virtioBlkR3PowerOff(PPDMDEVINS pDevIns)
+{
+    LogFunc(("\n"));
+    virtioBlkR3SuspendOrPowerOff(pDevIns, kvirtIoVmStateChangedPowerOff);
+}
+
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnSuspend}
+ */
+static DECLCALLBACK(void) virtioBlkR3Suspend(PPDMDEVINS pDevIns)
+{
+    LogFunc(("\n"));
+    virtioBlkR3SuspendOrPowerOff(pDevIns, kvirtIoVmStateChangedSuspend);
+}
+
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnResume}
+ */
+static DECLCALLBACK(void) virtioBlkR3Resume(PPDMDEVINS pDevIns)
+{
+    PVIRTIOBLK      pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    PVIRTIOBLKCC    pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+    LogFunc(("\n"));
+
+    pThisCC->fQuiescing = false;
+
+    /* Wake worker threads flagged to skip pulling queue entries during quiesce
+     * to ensure they re-check their queues. */
+    for (uint16_t uVirtqNbr = 0; uVirtqNbr < pThis->cVirtqs; uVirtqNbr++)
+    {
+        if (   virtioCoreIsVirtqEnabled(&pThis->Virtio, uVirtqNbr)
+            && ASMAtomicReadBool(&pThis->aWorkers[uVirtqNbr].fSleeping))
+        {
+            Log6Func(("waking %s worker.\n", VIRTQNAME(uVirtqNbr)));
+            int rc = PDMDevHlpSUPSemEventSignal(pDevIns, pThis->aWorkers[uVirtqNbr].hEvtProcess);
+            AssertRC(rc);
+        }
+    }
+    /* Ensure guest is working the queues too. */
+    virtioCoreR3VmStateChanged(&pThis->Virtio, kvirtIoVmStateChangedResume);
+}
+
+/**
+ * @interface_method_impl{PDMIMEDIAEXPORT,pfnMediumEjected}
+ */
+static DECLCALLBACK(void) virtioBlkR3MediumEjected(PPDMIMEDIAEXPORT pInterface)
+{
+    PVIRTIOBLKCC pThisCC = RT_FROM_MEMBER(pInterface, VIRTIOBLKCC, IMediaExPort);
+    PPDMDEVINS   pDevIns = pThisCC->pDevIns;
+
+    if (pThisCC->pMediaNotify)
+    {
+        int rc = PDMDevHlpVMReqCallNoWait(pDevIns, VMCPUID_ANY,
+                                          (PFNRT)pThisCC->pMediaNotify->pfnEjected, 2,
+                                          pThisCC->pMediaNotify, 0 /*iLUN*/);
+        AssertRC(rc);
+    }
+}
+
+/**
+ * @interface_method_impl{PDMIMEDIAEXPORT,pfnIoReqStateChanged}
+ */
+static DECLCALLBACK(void) virtioBlkR3IoReqStateChanged(PPDMIMEDIAEXPORT pInterface, PDMMEDIAEXIOREQ hIoReq,
+                                                       void *pvIoReqAlloc, PDMMEDIAEXIOREQSTATE enmState)
+{
+    PVIRTIOBLKCC    pThisCC = RT_FROM_MEMBER(pInterface, VIRTIOBLKCC, IMediaExPort);
+    PPDMDEVINS      pDevIns = pThisCC->pDevIns;
+    PVIRTIOBLK      pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    RT_NOREF(hIoReq, pvIoReqAlloc);
+
+    switch (enmState)
+    {
+        case PDMMEDIAEXIOREQSTATE_SUSPENDED:
+            /* Stop considering this request active */
+            virtioBlkR3Release(pDevIns, pThis, pThisCC);
+            break;
+        case PDMMEDIAEXIOREQSTATE_ACTIVE:
+            virtioBlkR3Retain(pThis);
+            break;
+        default:
+            AssertMsgFailed(("Invalid request state given %u\n", enmState));
+    }
+}
+
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnDestruct}
+ */
+static DECLCALLBACK(int) virtioBlkR3Destruct(PPDMDEVINS pDevIns)
+{
+    PDMDEV_CHECK_VERSIONS_RETURN_QUIET(pDevIns);
+    PVIRTIOBLK   pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    PVIRTIOBLKCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+
+    pThisCC->pMediaNotify = NULL;
+
+    for (unsigned uVirtqNbr = 0; uVirtqNbr < VIRTIOBLK_REQ_VIRTQ_CNT_MAX; uVirtqNbr++)
+    {
+        PVIRTIOBLKWORKER pWorker = &pThis->aWorkers[uVirtqNbr];
+        if (pWorker->hEvtProcess != NIL_SUPSEMEVENT)
+        {
+            PDMDevHlpSUPSemEventClose(pDevIns, pWorker->hEvtProcess);
+            pWorker->hEvtProcess = NIL_SUPSEMEVENT;
+        }
+
+        if (pThisCC->aWorkers[uVirtqNbr].pThread)
+        {
+            /* Destroy the thread. */
+            int rcThread;
+            int rc = PDMDevHlpThreadDestroy(pDevIns, pThisCC->aWorkers[uVirtqNbr].pThread, &rcThread);
+            if (RT_FAILURE(rc) || RT_FAILURE(rcThread))
+                AssertMsgFailed(("%s Failed to destroythread rc=%Rrc rcThread=%Rrc\n",
+                                 __FUNCTION__, rc, rcThread));
+            pThisCC->aWorkers[uVirtqNbr].pThread = NULL;
+        }
+
+        if (RTCritSectIsInitialized(&pThisCC->aWorkers[uVirtqNbr].CritSectVirtq))
+            RTCritSectDelete(&pThisCC->aWorkers[uVirtqNbr].CritSectVirtq);
+    }
+
+    virtioCoreR3Term(pDevIns, &pThis->Virtio, &pThisCC->Virtio);
+    return VINF_SUCCESS;
+}
+
+/**
+ * @interface_method_impl{PDMDEVREGR3,pfnConstruct}
+ */
+static DECLCALLBACK(int) virtioBlkR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGMNODE pCfg)
+{
+    PDMDEV_CHECK_VERSIONS_RETURN(pDevIns);
+    PVIRTIOBLK    pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    PVIRTIOBLKCC  pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+    PCPDMDEVHLPR3 pHlp    = pDevIns->pHlpR3;
+
+    /*
+     * Quick initialization of the state data, making sure that the destructor always works.
+     */
+    pThisCC->pDevIns = pDevIns;
+    for (unsigned uVirtqNbr = 0; uVirtqNbr < VIRTIOBLK_REQ_VIRTQ_CNT_MAX; uVirtqNbr++)
+        pThis->aWorkers[uVirtqNbr].hEvtProcess = NIL_SUPSEMEVENT;
+
+    LogFunc(("PDM device instance: %d\n", iInstance));
+    RTStrPrintf(pThis->szInstance, sizeof(pThis->szInstance), "VIRTIOBLK%d", iInstance);
+
+    pThisCC->IBase.pfnQueryInterface                 = virtioBlkR3QueryInterface;
+    pThisCC->ILeds.pfnQueryStatusLed                 = virtioBlkR3QueryStatusLed;
+    pThisCC->Led.u32Magic                            = PDMLED_MAGIC;
+
+    /* IMediaPort and IMediaExPort interfaces provide callbacks for VD media and downstream driver access */
+    pThisCC->IMediaPort.pfnQueryDeviceLocation       = virtioBlkR3QueryDeviceLocation;
+    pThisCC->IMediaPort.pfnQueryScsiInqStrings       = NULL;
+    pThisCC->IMediaExPort.pfnIoReqCompleteNotify     = virtioBlkR3IoReqFinish;
+    pThisCC->IMediaExPort.pfnIoReqCopyFromBuf        = virtioBlkR3IoReqCopyFromBuf;
+    pThisCC->IMediaExPort.pfnIoReqCopyToBuf          = virtioBlkR3IoReqCopyToBuf;
+    pThisCC->IMediaExPort.pfnIoReqQueryBuf           = NULL;
+    pThisCC->IMediaExPort.pfnIoReqQuerySgBuf         = NULL;
+    pThisCC->IMediaExPort.pfnIoReqQueryDiscardRanges = virtioBlkR3IoReqQueryDiscardRanges;
+    pThisCC->IMediaExPort.pfnIoReqStateChanged       = virtioBlkR3IoReqStateChanged;
+    pThisCC->IMediaExPort.pfnMediumEjected           = virtioBlkR3MediumEjected;
+
+    /*
+     * Validate and read configuration.
+     */
+    PDMDEV_VALIDATE_CONFIG_RETURN(pDevIns, "NumQueues"
+                                           "|SerialNumber"
+                                           "|MmioBase"
+                                           "|Irq", "");
+
+    uint32_t cVirtqs = 0;
+    int rc = pHlp->pfnCFGMQueryU32Def(pCfg, "NumQueues", &cVirtqs, VIRTIOBLK_REQ_VIRTQ_CNT_DEF);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("virtio-blk configuration error: failed to read NumQueues as integer"));
+    if (cVirtqs < 1 || cVirtqs > VIRTIOBLK_REQ_VIRTQ_CNT_MAX)
+        return PDMDevHlpVMSetError(pDevIns, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                                   N_("virtio-blk configuration error: NumQueues=%u is out of range (1..%u)"),
+                                   cVirtqs, VIRTIOBLK_REQ_VIRTQ_CNT_MAX);
+    pThis->cVirtqs = (uint16_t)cVirtqs;
+
+    /*
+     * Attach the medium, we need its size and capabilities for the config space.
+     */
+    rc = virtioBlkR3AttachLun(pDevIns, pThisCC);
+    if (rc == VERR_PDM_NO_ATTACHED_DRIVER)
+    {
+        Log(("virtio-blk: no driver attached to LUN#0\n"));
+        rc = VINF_SUCCESS;
+    }
+    else if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("virtio-blk: Failed to attach LUN#0"));
+
+    uint64_t fFeatures = VIRTIOBLK_HOST_FEATURES_OFFERED;
+    uint32_t cbSector  = VIRTIOBLK_SECTOR_SIZE;
+    uint64_t cbDisk    = 0;
+    RTUUID   Uuid;
+    RTUuidClear(&Uuid);
+    if (pThisCC->pDrvMedia)
+    {
+        cbDisk   = pThisCC->pDrvMedia->pfnGetSize(pThisCC->pDrvMedia);
+        cbSector = RT_MAX(pThisCC->pDrvMedia->pfnGetSectorSize(pThisCC->pDrvMedia), VIRTIOBLK_SECTOR_SIZE);
+        pThis->fReadOnly = pThisCC->pDrvMedia->pfnIsReadOnly(pThisCC->pDrvMedia);
+
+        uint32_t fMediaExFeatures = 0;
+        rc = pThisCC->pDrvMediaEx->pfnQueryFeatures(pThisCC->pDrvMediaEx, &fMediaExFeatures);
+        pThis->fDiscard          = RT_SUCCESS(rc) && (fMediaExFeatures & PDMIMEDIAEX_FEATURE_F_DISCARD);
+        pThis->fMediaWriteZeroes = RT_SUCCESS(rc) && (fMediaExFeatures & PDMIMEDIAEX_FEATURE_F_WRITE_ZEROES);
+
+        rc = pThisCC->pDrvMedia->pfnGetUuid(pThisCC->pDrvMedia, &Uuid);
+        if (RT_FAILURE(rc))
+            RTUuidClear(&Uuid);
+    }
+    if (pThis->fReadOnly)
+        fFeatures |= VIRTIO_BLK_F_RO;
+    if (pThis->fDiscard)
+        fFeatures |= VIRTIO_BLK_F_DISCARD;
+
+    char szSerial[VIRTIOBLK_ID_BYTES + 1];
+    if (RTUuidIsNull(&Uuid))
+        RTStrPrintf(szSerial, sizeof(szSerial), "VB%x-1a2b3c4d", iInstance);
+    else
+        RTStrPrintf(szSerial, sizeof(szSerial), "VB%08x-%08x", Uuid.au32[0], Uuid.au32[3]);
+    rc = pHlp->pfnCFGMQueryStringDef(pCfg, "SerialNumber", pThis->szSerialNumber, sizeof(pThis->szSerialNumber), szSerial);
+    if (rc == VERR_CFGM_NOT_ENOUGH_SPACE)
+        return PDMDEV_SET_ERROR(pDevIns, VERR_INVALID_PARAMETER,
+                                N_("virtio-blk configuration error: \"SerialNumber\" is longer than 20 bytes"));
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("virtio-blk configuration error: failed to read \"SerialNumber\" as string"));
+
+    LogRel(("%s: Queues=%u Size=%RU64 SectorSize=%u ReadOnly=%RTbool Discard=%RTbool R0Enabled=%RTbool RCEnabled=%RTbool\n",
+            pThis->szInstance, pThis->cVirtqs, cbDisk, cbSector, pThis->fReadOnly, pThis->fDiscard,
+            pDevIns->fR0Enabled, pDevIns->fRCEnabled));
+
+    /*
+     * Do core virtio initialization.
+     */
+
+    /* Configure virtio_blk_config that transacts via VirtIO implementation's Dev. Specific Cap callbacks */
+    pThis->virtioBlkConfig.uCapacity              = cbDisk >> VIRTIOBLK_SECTOR_SHIFT;
+    pThis->virtioBlkConfig.uSegMax                = VIRTIOBLK_MAX_SEG_COUNT;
+    pThis->virtioBlkConfig.uBlkSize               = cbSector;
+    pThis->virtioBlkConfig.uNumQueues             = pThis->cVirtqs;
+    pThis->virtioBlkConfig.uMaxDiscardSectors     = VIRTIOBLK_MAX_DISCARD_SECTORS;
+    pThis->virtioBlkConfig.uMaxDiscardSeg         = VIRTIOBLK_MAX_DISCARD_SEG;
+    pThis->virtioBlkConfig.uDiscardSectorAlignment = cbSector >> VIRTIOBLK_SECTOR_SHIFT;
+    pThis->virtioBlkConfig.uMaxWriteZeroesSectors = VIRTIOBLK_MAX_WRITE_ZEROES_SECTORS;
+    pThis->virtioBlkConfig.uMaxWriteZeroesSeg     = VIRTIOBLK_MAX_WRITE_ZEROES_SEG;
+    pThis->virtioBlkConfig.uWriteZeroesMayUnmap   = 0;
+
+    /* Initialize the generic Virtio core: */
+    pThisCC->Virtio.pfnVirtqNotified        = virtioBlkNotified;
+    pThisCC->Virtio.pfnStatusChanged        = virtioBlkR3StatusChanged;
+    pThisCC->Virtio.pfnDevCapRead           = virtioBlkR3DevCapRead;
+    pThisCC->Virtio.pfnDevCapWrite          = virtioBlkR3DevCapWrite;
+
+    VIRTIOPCIPARAMS VirtioPciParams;
+    VirtioPciParams.uDeviceId               = PCI_DEVICE_ID_VIRTIOBLK_HOST;
+    VirtioPciParams.uClassBase              = PCI_CLASS_BASE_MASS_STORAGE;
+    VirtioPciParams.uClassSub               = PCI_CLASS_SUB_SCSI_STORAGE_CONTROLLER;
+    VirtioPciParams.uClassProg              = PCI_CLASS_PROG_UNSPECIFIED;
+    VirtioPciParams.uSubsystemId            = PCI_DEVICE_ID_VIRTIOBLK_HOST;  /* VirtIO 1.0 spec allows PCI Device ID here */
+    VirtioPciParams.uInterruptLine          = 0x00;
+    VirtioPciParams.uInterruptPin           = 0x01;
+    VirtioPciParams.uDeviceType             = VIRTIO_DEVICE_TYPE_BLOCK;
+
+    rc = virtioCoreR3Init(pDevIns, &pThis->Virtio, &pThisCC->Virtio, &VirtioPciParams, pThis->szInstance,
+                          fFeatures, 0 /*fOfferLegacy*/,
+                          &pThis->virtioBlkConfig /*pvDevSpecificCap*/, sizeof(pThis->virtioBlkConfig));
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("virtio-blk: failed to initialize VirtIO"));
+
+    /*
+     * Initialize queues, each request queue gets its own worker thread.
+     */
+    virtioBlkSetVirtqNames(pThis);
+
+    for (uint16_t uVirtqNbr = 0; uVirtqNbr < pThis->cVirtqs; uVirtqNbr++)
+    {
+        rc = virtioCoreR3VirtqAttach(&pThis->Virtio, uVirtqNbr, VIRTQNAME(uVirtqNbr));
+        if (RT_FAILURE(rc))
+            continue;
+
+        rc = RTCritSectInit(&pThisCC->aWorkers[uVirtqNbr].CritSectVirtq);
+        if (RT_FAILURE(rc))
+            return PDMDevHlpVMSetError(pDevIns, rc, RT_SRC_POS,
+                                       N_("DevVirtioBlk: Failed to create worker critical section"));
+
+        rc = PDMDevHlpSUPSemEventCreate(pDevIns, &pThis->aWorkers[uVirtqNbr].hEvtProcess);
+        if (RT_FAILURE(rc))
+            return PDMDevHlpVMSetError(pDevIns, rc, RT_SRC_POS,
+                                       N_("DevVirtioBlk: Failed to create SUP event semaphore"));
+
+        rc = PDMDevHlpThreadCreate(pDevIns, &pThisCC->aWorkers[uVirtqNbr].pThread,
+                                   (void *)(uintptr_t)uVirtqNbr, virtioBlkR3WorkerThread,
+                                   virtioBlkR3WorkerWakeUp, 0, RTTHREADTYPE_IO, VIRTQNAME(uVirtqNbr));
+        if (rc != VINF_SUCCESS)
+        {
+            LogRel(("Error creating thread for Virtual Virtq %s: %Rrc\n", VIRTQNAME(uVirtqNbr), rc));
+            return rc;
+        }
+
+        pThis->afVirtqAttached[uVirtqNbr] = true;
+    }
+
+    /*
+     * Status driver (optional).
+     */
+    PPDMIBASE pUpBase = NULL;
+    rc = PDMDevHlpDriverAttach(pDevIns, PDM_STATUS_LUN, &pThisCC->IBase, &pUpBase, "Status Port");
+    if (RT_FAILURE(rc) && rc != VERR_PDM_NO_ATTACHED_DRIVER)
+        return PDMDEV_SET_ERROR(pDevIns, rc, N_("Failed to attach the status LUN"));
+    if (RT_SUCCESS(rc) && pUpBase)
+        pThisCC->pMediaNotify = PDMIBASE_QUERY_INTERFACE(pUpBase, PDMIMEDIANOTIFY);
+
+    /*
+     * Register saved state.
+     */
+    rc = PDMDevHlpSSMRegister(pDevIns, VIRTIOBLK_SAVED_STATE_VERSION, sizeof(*pThis),
+                              virtioBlkR3SaveExec, virtioBlkR3LoadExec);
+    AssertRCReturn(rc, rc);
+
+    /*
+     * Register the debugger info callback (ignore errors).
+     */
+    char szTmp[128];
+    RTStrPrintf(szTmp, sizeof(szTmp), "virtioblk%u", pDevIns->iInstance);
+    PDMDevHlpDBGFInfoRegister(pDevIns, szTmp, "virtio-blk info", virtioBlkR3Info);
+
+    return VINF_SUCCESS;
+}
+
+#else  /* !IN_RING3 */
+
+/**
+ * @callback_method_impl{PDMDEVREGR0,pfnConstruct}
+ */
+static DECLCALLBACK(int) virtioBlkRZConstruct(PPDMDEVINS pDevIns)
+{
+    PDMDEV_CHECK_VERSIONS_RETURN(pDevIns);
+
+    PVIRTIOBLK   pThis   = PDMDEVINS_2_DATA(pDevIns, PVIRTIOBLK);
+    PVIRTIOBLKCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOBLKCC);
+
+    pThisCC->Virtio.pfnVirtqNotified = virtioBlkNotified;
+    return virtioCoreRZInit(pDevIns, &pThis->Virtio);
+}
+
+#endif /* !IN_RING3 */
+
+
+/**
+ * The device registration structure.
+ */
+const PDMDEVREG g_DeviceVirtioBlk =
+{
+    /* .u32Version = */             PDM_DEVREG_VERSION,
+    /* .uReserved0 = */             0,
+    /* .szName = */                 "virtio-blk",
+    /* .fFlags = */                 PDM_DEVREG_FLAGS_DEFAULT_BITS | PDM_DEVREG_FLAGS_RZ | PDM_DEVREG_FLAGS_NEW_STYLE
+                                    | PDM_DEVREG_FLAGS_FIRST_SUSPEND_NOTIFICATION
+                                    | PDM_DEVREG_FLAGS_FIRST_POWEROFF_NOTIFICATION,
+    /* .fClass = */                 PDM_DEVREG_CLASS_STORAGE,
+    /* .cMaxInstances = */          ~0U,
+    /* .uSharedVersion = */         42,
+    /* .cbInstanceShared = */       sizeof(VIRTIOBLK),
+    /* .cbInstanceCC = */           sizeof(VIRTIOBLKCC),
+    /* .cbInstanceRC = */           sizeof(VIRTIOBLKRC),
+    /* .cMaxPciDevices = */         1,
+    /* .cMaxMsixVectors = */        VBOX_MSIX_MAX_ENTRIES,
+    /* .pszDescription = */         "Virtio Block Device.\n",
+#if defined(IN_RING3)
+    /* .pszRCMod = */               "VBoxDDRC.rc",
+    /* .pszR0Mod = */               "VBoxDDR0.r0",
+    /* .pfnConstruct = */           virtioBlkR3Construct,
+    /* .pfnDestruct = */            virtioBlkR3Destruct,
+    /* .pfnRelocate = */            NULL,
+    /* .pfnMemSetup = */            NULL,
+    /* .pfnPowerOn = */             NULL,
+    /* .pfnReset = */               virtioBlkR3Reset,
+    /* .pfnSuspend = */             virtioBlkR3Suspend,
+    /* .pfnResume = */              virtioBlkR3Resume,
+    /* .pfnAttach = */              virtioBlkR3Attach,
+    /* .pfnDetach = */              virtioBlkR3Detach,
+    /* .pfnQueryInterface = */      NULL,
+    /* .pfnInitComplete = */        NULL,
+    /* .pfnPowerOff = */            virtioBlkR3PowerOff,
+    /* .pfnSoftReset = */           NULL,
+    /* .pfnReserved0 = */           NULL,
+    /* .pfnReserved1 = */           NULL,
+    /* .pfnReserved2 = */           NULL,
+    /* .pfnReserved3 = */           NULL,
+    /* .pfnReserved4 = */           NULL,
+    /* .pfnReserved5 = */           NULL,
+    /* .pfnReserved6 = */           NULL,
+    /* .pfnReserved7 = */           NULL,
+#elif defined(IN_RING0)
+    /* .pfnEarlyConstruct = */      NULL,
+    /* .pfnConstruct = */           virtioBlkRZConstruct,
+    /* .pfnDestruct = */            NULL,
+    /* .pfnFinalDestruct = */       NULL,
+    /* .pfnRequest = */             NULL,
+    /* .pfnReserved0 = */           NULL,
+    /* .pfnReserved1 = */           NULL,
+    /* .pfnReserved2 = */           NULL,
+    /* .pfnReserved3 = */           NULL,
+    /* .pfnReserved4 = */           NULL,
+    /* .pfnReserved5 = */           NULL,
+    /* .pfnReserved6 = */           NULL,
+    /* .pfnReserved7 = */           NULL,
+#elif defined(IN_RC)
+    /* .pfnConstruct = */           virtioBlkRZConstruct,
+    /* .pfnReserved0 = */           NULL,
+    /* .pfnReserved1 = */           NULL,
+    /* .pfnReserved2 = */           NULL,
+    /* .pfnReserved3 = */           NULL,
+    /* .pfnReserved4 = */           NULL,
+    /* .pfnReserved5 = */           NULL,
+    /* .pfnReserved6 = */           NULL,
+    /* .pfnReserved7 = */           NULL,
+#else
+# error "Not in IN_RING3, IN_RING0 or IN_RC!"
+#endif
+    /* .u32VersionEnd = */          PDM_DEVREG_VERSION
+};
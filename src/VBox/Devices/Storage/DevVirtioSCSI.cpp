@@ -112,6 +112,9 @@
 #define VIRTIOSCSI_PI_BYTES_IN                      1           /**< Value TBD (see section 5.6.6.1)                 */
 #define VIRTIOSCSI_PI_BYTES_OUT                     1           /**< Value TBD (see section 5.6.6.1)                 */
 #define VIRTIOSCSI_DATA_OUT                         512         /**< Value TBD (see section 5.6.6.1)                 */
+#define VIRTIOSCSI_SENSE_SLOTS                      128         /**< Preallocated sense buffers per request queue    */
+#define VIRTIOSCSI_USED_BATCH_MAX                   32          /**< Max used ring entries held back in a batch      */
+AssertCompile(!(VIRTIOSCSI_SENSE_SLOTS % 64));
 
 /**
  * VirtIO SCSI Host Device device-specific queue indicies.
@@ -370,6 +373,10 @@ typedef struct VIRTIOSCSIWORKERR3
     RTCRITSECT                      CritSectVirtq;              /**< Protecting the virtq against concurrent thread access. */
     uint16_t                        auRedoDescs[VIRTQ_SIZE];    /**< List of previously suspended reqs to re-submit    */
     uint16_t                        cRedoDescs;                 /**< Number of redo desc chain head desc idxes in list */
+    uint32_t                        cBatchRefs;                 /**< Open completion batches (CritSectVirtq)           */
+    uint32_t                        cUsedPending;               /**< Used entries put but not synced (CritSectVirtq)   */
+    uint8_t                        *pbSenseSlots;               /**< Request queues: preallocated sense buffers        */
+    uint64_t volatile               bmSenseSlots[VIRTIOSCSI_SENSE_SLOTS / 64]; /**< Sense buffers in use (set bit)     */
 } VIRTIOSCSIWORKERR3;
 /** Pointer to a VirtIO SCSI worker. */
 typedef VIRTIOSCSIWORKERR3 *PVIRTIOSCSIWORKERR3;
@@ -720,6 +727,9 @@ static uint8_t virtioScsiEstimateCdbLen(uint8_t uCmd, uint8_t cbMax)
 /**
  * Wrapper around virtioCoreR3VirtqUsedBufPut() and virtioCoreVirtqUsedRingSync() doing some device locking.
  *
+ * While a completion batch is open on the queue (see virtioScsiR3VirtqBatchBegin) the used ring index update
+ * and the guest notification are held back until the batch ends or VIRTIOSCSI_USED_BATCH_MAX entries piled up.
+ *
  * @param   pDevIns         The PDM device instance.
  * @param   pVirtio         Pointer to the shared virtio core structure.
  * @param   uVirtqNbr       The virtq number.
@@ -732,12 +742,102 @@ static uint8_t virtioScsiEstimateCdbLen(uint8_t uCmd, uint8_t cbMax)
 DECLINLINE(void) virtioScsiR3VirtqUsedBufPutAndSync(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtqNbr, PRTSGBUF pSgVirtReturn,
                                                     PVIRTQBUF pVirtqBuf)
 {
-    PVIRTIOSCSICC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOSCSICC);
+    PVIRTIOSCSICC       pThisCC   = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOSCSICC);
+    PVIRTIOSCSIWORKERR3 pWorkerR3 = &pThisCC->aWorkers[uVirtqNbr];
 
-    RTCritSectEnter(&pThisCC->aWorkers[uVirtqNbr].CritSectVirtq);
+    RTCritSectEnter(&pWorkerR3->CritSectVirtq);
     virtioCoreR3VirtqUsedBufPut(pThisCC->pDevIns, pVirtio, uVirtqNbr, pSgVirtReturn, pVirtqBuf, true /* fFence */);
-    virtioCoreVirtqUsedRingSync(pThisCC->pDevIns, pVirtio, uVirtqNbr);
-    RTCritSectLeave(&pThisCC->aWorkers[uVirtqNbr].CritSectVirtq);
+    if (   !pWorkerR3->cBatchRefs
+        || ++pWorkerR3->cUsedPending >= VIRTIOSCSI_USED_BATCH_MAX)
+    {
+        virtioCoreVirtqUsedRingSync(pThisCC->pDevIns, pVirtio, uVirtqNbr);
+        pWorkerR3->cUsedPending = 0;
+    }
+    RTCritSectLeave(&pWorkerR3->CritSectVirtq);
+}
+
+/**
+ * Opens a completion batch on a request queue, deferring used ring updates.
+ *
+ * @param   pThisCC         VirtIO SCSI ring-3 instance data.
+ * @param   uVirtqNbr       The virtq number.
+ */
+DECLINLINE(void) virtioScsiR3VirtqBatchBegin(PVIRTIOSCSICC pThisCC, uint16_t uVirtqNbr)
+{
+    PVIRTIOSCSIWORKERR3 pWorkerR3 = &pThisCC->aWorkers[uVirtqNbr];
+    RTCritSectEnter(&pWorkerR3->CritSectVirtq);
+    pWorkerR3->cBatchRefs++;
+    RTCritSectLeave(&pWorkerR3->CritSectVirtq);
+}
+
+/**
+ * Closes a completion batch, publishing everything completed during it with
+ * a single used ring index update and guest notification.
+ *
+ * @param   pDevIns         The PDM device instance.
+ * @param   pThis           VirtIO SCSI shared instance data.
+ * @param   pThisCC         VirtIO SCSI ring-3 instance data.
+ * @param   uVirtqNbr       The virtq number.
+ */
+static void virtioScsiR3VirtqBatchEnd(PPDMDEVINS pDevIns, PVIRTIOSCSI pThis, PVIRTIOSCSICC pThisCC, uint16_t uVirtqNbr)
+{
+    PVIRTIOSCSIWORKERR3 pWorkerR3 = &pThisCC->aWorkers[uVirtqNbr];
+    RTCritSectEnter(&pWorkerR3->CritSectVirtq);
+    Assert(pWorkerR3->cBatchRefs > 0);
+    if (   !--pWorkerR3->cBatchRefs
+        && pWorkerR3->cUsedPending)
+    {
+        if (pThis->fVirtioReady)
+            virtioCoreVirtqUsedRingSync(pDevIns, &pThis->Virtio, uVirtqNbr);
+        pWorkerR3->cUsedPending = 0;
+    }
+    RTCritSectLeave(&pWorkerR3->CritSectVirtq);
+}
+
+/**
+ * Gets a zeroed sense buffer for a request.
+ *
+ * Buffers of the default size come from the per request queue slots, which are
+ * only allocated by the queue's worker thread and can be freed from any thread
+ * without taking a lock.  Anything else falls back on the heap.
+ *
+ * @returns Pointer to the sense buffer, NULL if out of memory.
+ * @param   pWorkerR3       The request queue worker.
+ * @param   cbSense         The sense buffer size.
+ */
+static uint8_t *virtioScsiR3SenseAlloc(PVIRTIOSCSIWORKERR3 pWorkerR3, uint32_t cbSense)
+{
+    if (   pWorkerR3->pbSenseSlots
+        && cbSense <= VIRTIOSCSI_SENSE_SIZE_DEFAULT)
+    {
+        int32_t iSlot = ASMBitFirstClear(&pWorkerR3->bmSenseSlots[0], VIRTIOSCSI_SENSE_SLOTS);
+        if (iSlot >= 0)
+        {
+            /* We're the only one setting bits, so the slot can't have been taken meanwhile. */
+            bool fTaken = ASMAtomicBitTestAndSet(&pWorkerR3->bmSenseSlots[0], iSlot);
+            Assert(!fTaken); RT_NOREF(fTaken);
+            uint8_t *pbSense = &pWorkerR3->pbSenseSlots[(uint32_t)iSlot * VIRTIOSCSI_SENSE_SIZE_DEFAULT];
+            memset(pbSense, 0, cbSense);
+            return pbSense;
+        }
+    }
+    return (uint8_t *)RTMemAllocZ(cbSense);
+}
+
+/**
+ * Frees a sense buffer allocated by virtioScsiR3SenseAlloc().
+ *
+ * @param   pWorkerR3       The request queue worker the buffer was allocated from.
+ * @param   pbSense         The sense buffer, NULL is ignored.
+ */
+static void virtioScsiR3SenseFree(PVIRTIOSCSIWORKERR3 pWorkerR3, uint8_t *pbSense)
+{
+    uintptr_t const offSlot = (uintptr_t)pbSense - (uintptr_t)pWorkerR3->pbSenseSlots;
+    if (   pWorkerR3->pbSenseSlots
+        && offSlot < VIRTIOSCSI_SENSE_SLOTS * VIRTIOSCSI_SENSE_SIZE_DEFAULT)
+        ASMAtomicBitClear(&pWorkerR3->bmSenseSlots[0], (int32_t)(offSlot / VIRTIOSCSI_SENSE_SIZE_DEFAULT));
+    else
+        RTMemFree(pbSense);
 }
 
 
@@ -852,8 +952,9 @@ DECLINLINE(void) virtioScsiR3Retain(PVIRTIOSCSI pThis)
 /** Internal worker. */
 static void virtioScsiR3FreeReq(PVIRTIOSCSITARGET pTarget, PVIRTIOSCSIREQ pReq)
 {
-    PVIRTIOSCSI pThis = PDMDEVINS_2_DATA(pTarget->pDevIns, PVIRTIOSCSI);
-    RTMemFree(pReq->pbSense);
+    PVIRTIOSCSI   pThis   = PDMDEVINS_2_DATA(pTarget->pDevIns, PVIRTIOSCSI);
+    PVIRTIOSCSICC pThisCC = PDMDEVINS_2_DATA_CC(pTarget->pDevIns, PVIRTIOSCSICC);
+    virtioScsiR3SenseFree(&pThisCC->aWorkers[pReq->uVirtqNbr], pReq->pbSense);
     pReq->pbSense = NULL;
     virtioCoreR3VirtqBufRelease(&pThis->Virtio, pReq->pVirtqBuf);
     pReq->pVirtqBuf = NULL;
@@ -1351,7 +1452,7 @@ static int virtioScsiR3ReqSubmit(PPDMDEVINS pDevIns, PVIRTIOSCSI pThis, PVIRTIOS
     pReq->uDataOutOff = offDataOut;
 
     pReq->cbSenseAlloc = cbSenseCfg;
-    pReq->pbSense      = (uint8_t *)RTMemAllocZ(pReq->cbSenseAlloc);
+    pReq->pbSense      = virtioScsiR3SenseAlloc(&pThisCC->aWorkers[uVirtqNbr], pReq->cbSenseAlloc);
     AssertMsgReturnStmt(pReq->pbSense, ("Out of memory allocating sense buffer"),
                         virtioScsiR3FreeReq(pTarget, pReq);, VERR_NO_MEMORY);
 
@@ -1597,6 +1698,7 @@ static DECLCALLBACK(int) virtioScsiR3WorkerThread(PPDMDEVINS pDevIns, PPDMTHREAD
     PVIRTIOSCSICC       pThisCC   = PDMDEVINS_2_DATA_CC(pDevIns, PVIRTIOSCSICC);
     PVIRTIOSCSIWORKER   pWorker   = &pThis->aWorkers[uVirtqNbr];
     PVIRTIOSCSIWORKERR3 pWorkerR3 = &pThisCC->aWorkers[uVirtqNbr];
+    bool                fBatch    = false;
 
     if (pThread->enmState == PDMTHREADSTATE_INITIALIZING)
         return VINF_SUCCESS;
@@ -1607,6 +1709,13 @@ static DECLCALLBACK(int) virtioScsiR3WorkerThread(PPDMDEVINS pDevIns, PPDMTHREAD
         if (    !pWorkerR3->cRedoDescs
              && IS_VIRTQ_EMPTY(pDevIns, &pThis->Virtio, uVirtqNbr))
         {
+            /* Drained the queue, publish what completed meanwhile before going to sleep. */
+            if (fBatch)
+            {
+                virtioScsiR3VirtqBatchEnd(pDevIns, pThis, pThisCC, uVirtqNbr);
+                fBatch = false;
+            }
+
             /* Atomic interlocks avoid missing alarm while going to sleep & notifier waking the awoken */
             ASMAtomicWriteBool(&pWorker->fSleeping, true);
             bool fNotificationSent = ASMAtomicXchgBool(&pWorker->fNotified, false);
@@ -1644,6 +1753,13 @@ static DECLCALLBACK(int) virtioScsiR3WorkerThread(PPDMDEVINS pDevIns, PPDMTHREAD
         }
         if (!pThisCC->fQuiescing)
         {
+            /* Completions of request queues are batched while draining the avail ring. */
+            if (!fBatch && IS_REQ_VIRTQ(uVirtqNbr))
+            {
+                virtioScsiR3VirtqBatchBegin(pThisCC, uVirtqNbr);
+                fBatch = true;
+            }
+
             /* Process any reqs that were suspended saved to the redo queue in save exec. */
             for (int i = 0; i < pWorkerR3->cRedoDescs; i++)
             {
@@ -1693,7 +1809,14 @@ static DECLCALLBACK(int) virtioScsiR3WorkerThread(PPDMDEVINS pDevIns, PPDMTHREAD
                 virtioCoreR3VirtqBufRelease(&pThis->Virtio, pVirtqBuf);
             }
         }
+        else if (fBatch)
+        {
+            virtioScsiR3VirtqBatchEnd(pDevIns, pThis, pThisCC, uVirtqNbr);
+            fBatch = false;
+        }
     }
+    if (fBatch)
+        virtioScsiR3VirtqBatchEnd(pDevIns, pThis, pThisCC, uVirtqNbr);
     return VINF_SUCCESS;
 }
 
@@ -2495,6 +2618,9 @@ static DECLCALLBACK(int) virtioScsiR3Destruct(PPDMDEVINS pDevIns)
 
         if (RTCritSectIsInitialized(&pThisCC->aWorkers[uVirtqNbr].CritSectVirtq))
             RTCritSectDelete(&pThisCC->aWorkers[uVirtqNbr].CritSectVirtq);
+
+        RTMemFree(pThisCC->aWorkers[uVirtqNbr].pbSenseSlots);
+        pThisCC->aWorkers[uVirtqNbr].pbSenseSlots = NULL;
     }
 
     virtioCoreR3Term(pDevIns, &pThis->Virtio, &pThisCC->Virtio);
@@ -2596,6 +2722,13 @@ static DECLCALLBACK(int) virtioScsiR3Construct(PPDMDEVINS pDevIns, int iInstance
         rc = virtioCoreR3VirtqAttach(&pThis->Virtio, uVirtqNbr, VIRTQNAME(uVirtqNbr));
         if (RT_FAILURE(rc))
             continue;
+        if (IS_REQ_VIRTQ(uVirtqNbr))
+        {
+            pThisCC->aWorkers[uVirtqNbr].pbSenseSlots = (uint8_t *)RTMemAllocZ(  VIRTIOSCSI_SENSE_SLOTS
+                                                                               * VIRTIOSCSI_SENSE_SIZE_DEFAULT);
+            if (!pThisCC->aWorkers[uVirtqNbr].pbSenseSlots)
+                return PDMDEV_SET_ERROR(pDevIns, VERR_NO_MEMORY, N_("DevVirtioSCSI: Failed to allocate sense buffers"));
+        }
         if (uVirtqNbr == CONTROLQ_IDX || IS_REQ_VIRTQ(uVirtqNbr))
         {
             rc = PDMDevHlpThreadCreate(pDevIns, &pThisCC->aWorkers[uVirtqNbr].pThread,
@@ -2650,6 +2783,7 @@ static DECLCALLBACK(int) virtioScsiR3Construct(PPDMDEVINS pDevIns, int iInstance
         pTarget->IMediaExPort.pfnIoReqStateChanged       = virtioScsiR3IoReqStateChanged;
         pTarget->IMediaExPort.pfnMediumEjected           = virtioScsiR3MediumEjected;
         pTarget->IMediaExPort.pfnIoReqQueryBuf           = NULL; /* When used avoids copyFromBuf CopyToBuf*/
+        pTarget->IMediaExPort.pfnIoReqQuerySgBuf         = NULL;
         pTarget->IMediaExPort.pfnIoReqQueryDiscardRanges = NULL;
 
         pTarget->IBase.pfnQueryInterface                 = virtioScsiR3TargetQueryInterface;
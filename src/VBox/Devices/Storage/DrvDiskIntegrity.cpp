@@ -1336,7 +1336,11 @@ static DECLCALLBACK(void) drvdiskintIoReqStateChanged(PPDMIMEDIAEXPORT pInterfac
 static DECLCALLBACK(int) drvdiskintQueryFeatures(PPDMIMEDIAEX pInterface, uint32_t *pfFeatures)
 {
     PDRVDISKINTEGRITY pThis = RT_FROM_MEMBER(pInterface, DRVDISKINTEGRITY, IMediaEx);
-    return pThis->pDrvMediaEx->pfnQueryFeatures(pThis->pDrvMediaEx, pfFeatures);
+    int rc = pThis->pDrvMediaEx->pfnQueryFeatures(pThis->pDrvMediaEx, pfFeatures);
+    /* Write zeroes requests carry no data and would bypass the integrity records. */
+    if (RT_SUCCESS(rc))
+        *pfFeatures &= ~PDMIMEDIAEX_FEATURE_F_WRITE_ZEROES;
+    return rc;
 }
 
 /**
@@ -1620,6 +1624,15 @@ static DECLCALLBACK(int) drvdiskintIoReqDiscard(PPDMIMEDIAEX pInterface, PDMMEDI
     return pThis->pDrvMediaEx->pfnIoReqDiscard(pThis->pDrvMediaEx, hIoReq, cRangesMax);
 }
 
+/**
+ * @interface_method_impl{PDMIMEDIAEX,pfnIoReqWriteZeroes}
+ */
+static DECLCALLBACK(int) drvdiskintIoReqWriteZeroes(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq, uint64_t off, size_t cbZero)
+{
+    RT_NOREF4(pInterface, hIoReq, off, cbZero);
+    return VERR_NOT_SUPPORTED;
+}
+
 /**
  * @interface_method_impl{PDMIMEDIAEX,pfnIoReqGetActiveCount}
  */
@@ -1938,6 +1951,7 @@ static DECLCALLBACK(int) drvdiskintConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg,
     pThis->IMediaEx.pfnIoReqWrite               = drvdiskintIoReqWrite;
     pThis->IMediaEx.pfnIoReqFlush               = drvdiskintIoReqFlush;
     pThis->IMediaEx.pfnIoReqDiscard             = drvdiskintIoReqDiscard;
+    pThis->IMediaEx.pfnIoReqWriteZeroes         = drvdiskintIoReqWriteZeroes;
     pThis->IMediaEx.pfnIoReqGetActiveCount      = drvdiskintIoReqGetActiveCount;
     pThis->IMediaEx.pfnIoReqGetSuspendedCount   = drvdiskintIoReqGetSuspendedCount;
     pThis->IMediaEx.pfnIoReqQuerySuspendedStart = drvdiskintIoReqQuerySuspendedStart;
@@ -750,6 +750,13 @@ static DECLCALLBACK(int) drvHostBaseIoReqDiscard(PPDMIMEDIAEX pInterface, PDMMED
     return VERR_NOT_SUPPORTED;
 }
 
+/** @interface_method_impl{PDMIMEDIAEX,pfnIoReqWriteZeroes} */
+static DECLCALLBACK(int) drvHostBaseIoReqWriteZeroes(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq, uint64_t off, size_t cbZero)
+{
+    RT_NOREF4(pInterface, hIoReq, off, cbZero);
+    return VERR_NOT_SUPPORTED;
+}
+
 /** @interface_method_impl{PDMIMEDIAEX,pfnIoReqGetActiveCount} */
 static DECLCALLBACK(uint32_t) drvHostBaseIoReqGetActiveCount(PPDMIMEDIAEX pInterface)
 {
@@ -1326,6 +1333,7 @@ DECLHIDDEN(int) DRVHostBaseInit(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, const char *
     pThis->IMediaEx.pfnIoReqWrite               = drvHostBaseIoReqWrite;
     pThis->IMediaEx.pfnIoReqFlush               = drvHostBaseIoReqFlush;
     pThis->IMediaEx.pfnIoReqDiscard             = drvHostBaseIoReqDiscard;
+    pThis->IMediaEx.pfnIoReqWriteZeroes         = drvHostBaseIoReqWriteZeroes;
     pThis->IMediaEx.pfnIoReqGetActiveCount      = drvHostBaseIoReqGetActiveCount;
     pThis->IMediaEx.pfnIoReqGetSuspendedCount   = drvHostBaseIoReqGetSuspendedCount;
     pThis->IMediaEx.pfnIoReqQuerySuspendedStart = drvHostBaseIoReqQuerySuspendedStart;
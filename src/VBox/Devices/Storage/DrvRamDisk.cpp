@@ -143,6 +143,12 @@ typedef struct PDMMEDIAEXIOREQINT
             /** Number of ranges to discard. */
             unsigned                      cRanges;
         } Discard;
+        /** Write zeroes specific data. */
+        struct
+        {
+            /** The range to zero. */
+            RTRANGE                       Range;
+        } WriteZeroes;
     };
     /** Allocator specific memory - variable size. */
     uint8_t                       abAlloc[1];
@@ -877,6 +883,9 @@ static int drvramdiskMediaExIoReqCompleteWorker(PDRVRAMDISK pThis, PPDMMEDIAEXIO
             case PDMMEDIAEXIOREQTYPE_DISCARD:
                 pcszReq = "Discard";
                 break;
+            case PDMMEDIAEXIOREQTYPE_WRITE_ZEROES:
+                pcszReq = "WriteZeroes";
+                break;
             default:
                 pcszReq = "<Invalid>";
         }
@@ -1200,13 +1209,29 @@ static DECLCALLBACK(int) drvramdiskIoReqDiscardWorker(PDRVRAMDISK pThis, PPDMMED
     return VINF_SUCCESS;
 }
 
+/**
+ * Worker for a write zeroes request.
+ *
+ * Unallocated ranges read as zeroes, so the range is simply discarded.
+ *
+ * @returns VBox status code.
+ * @param   pThis     RAM disk container instance data.
+ * @param   pIoReq    The write zeroes request.
+ */
+static DECLCALLBACK(int) drvramdiskIoReqWriteZeroesWorker(PDRVRAMDISK pThis, PPDMMEDIAEXIOREQINT pIoReq)
+{
+    int rc = drvramdiskDiscardRecords(pThis, &pIoReq->WriteZeroes.Range, 1);
+    drvramdiskMediaExIoReqComplete(pThis, pIoReq, rc);
+    return VINF_SUCCESS;
+}
+
 /**
  * @interface_method_impl{PDMIMEDIAEX,pfnQueryFeatures}
  */
 static DECLCALLBACK(int) drvramdiskQueryFeatures(PPDMIMEDIAEX pInterface, uint32_t *pfFeatures)
 {
     RT_NOREF1(pInterface);
-    *pfFeatures = PDMIMEDIAEX_FEATURE_F_ASYNC | PDMIMEDIAEX_FEATURE_F_DISCARD;
+    *pfFeatures = PDMIMEDIAEX_FEATURE_F_ASYNC | PDMIMEDIAEX_FEATURE_F_DISCARD | PDMIMEDIAEX_FEATURE_F_WRITE_ZEROES;
     return VINF_SUCCESS;
 }
 
@@ -1540,6 +1565,43 @@ static DECLCALLBACK(int) drvramdiskIoReqDiscard(PPDMIMEDIAEX pInterface, PDMMEDI
     return rc;
 }
 
+/**
+ * @interface_method_impl{PDMIMEDIAEX,pfnIoReqWriteZeroes}
+ */
+static DECLCALLBACK(int) drvramdiskIoReqWriteZeroes(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq, uint64_t off, size_t cbZero)
+{
+    PDRVRAMDISK pThis = RT_FROM_MEMBER(pInterface, DRVRAMDISK, IMediaEx);
+    PPDMMEDIAEXIOREQINT pIoReq = hIoReq;
+    VDIOREQSTATE enmState = (VDIOREQSTATE)ASMAtomicReadU32((volatile uint32_t *)&pIoReq->enmState);
+
+    if (RT_UNLIKELY(enmState == VDIOREQSTATE_CANCELED))
+        return VERR_PDM_MEDIAEX_IOREQ_CANCELED;
+
+    if (RT_UNLIKELY(enmState != VDIOREQSTATE_ALLOCATED))
+        return VERR_PDM_MEDIAEX_IOREQ_INVALID_STATE;
+
+    pIoReq->enmType                    = PDMMEDIAEXIOREQTYPE_WRITE_ZEROES;
+    pIoReq->tsSubmit                   = RTTimeMilliTS();
+    pIoReq->WriteZeroes.Range.offStart = off;
+    pIoReq->WriteZeroes.Range.cbRange  = cbZero;
+
+    bool fXchg = ASMAtomicCmpXchgU32((volatile uint32_t *)&pIoReq->enmState, VDIOREQSTATE_ACTIVE, VDIOREQSTATE_ALLOCATED);
+    if (RT_UNLIKELY(!fXchg))
+    {
+        /* Must have been canceled inbetween. */
+        Assert(pIoReq->enmState == VDIOREQSTATE_CANCELED);
+        return VERR_PDM_MEDIAEX_IOREQ_CANCELED;
+    }
+
+    ASMAtomicIncU32(&pThis->cIoReqsActive);
+
+    int rc = RTReqQueueCallEx(pThis->hReqQ, NULL, 0, RTREQFLAGS_NO_WAIT, (PFNRT)drvramdiskIoReqWriteZeroesWorker, 2, pThis, pIoReq);
+    if (rc == VINF_SUCCESS)
+        rc = VINF_PDM_MEDIAEX_IOREQ_IN_PROGRESS;
+
+    return rc;
+}
+
 /**
  * @interface_method_impl{PDMIMEDIAEX,pfnIoReqGetActiveCount}
  */
@@ -1786,6 +1848,7 @@ static DECLCALLBACK(int) drvramdiskConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg,
     pThis->IMediaEx.pfnIoReqWrite               = drvramdiskIoReqWrite;
     pThis->IMediaEx.pfnIoReqFlush               = drvramdiskIoReqFlush;
     pThis->IMediaEx.pfnIoReqDiscard             = drvramdiskIoReqDiscard;
+    pThis->IMediaEx.pfnIoReqWriteZeroes         = drvramdiskIoReqWriteZeroes;
     pThis->IMediaEx.pfnIoReqGetActiveCount      = drvramdiskIoReqGetActiveCount;
     pThis->IMediaEx.pfnIoReqGetSuspendedCount   = drvramdiskIoReqGetSuspendedCount;
     pThis->IMediaEx.pfnIoReqQuerySuspendedStart = drvramdiskIoReqQuerySuspendedStart;
@@ -41,6 +41,7 @@
 #include <iprt/asm.h>
 #include <iprt/assert.h>
 #include <iprt/mem.h>
+#include <iprt/memcache.h>
 #include <iprt/req.h>
 #include <iprt/semaphore.h>
 #include <iprt/string.h>
@@ -153,6 +154,8 @@ typedef struct DRVSCSI
 
     /** Size of the I/O request to allocate. */
     size_t                  cbIoReqAlloc;
+    /** Cache of I/O requests, keeps the heap lock off the submission path. */
+    RTMEMCACHE              hIoReqCache;
     /** Size of a VSCSI I/O request. */
     size_t                  cbVScsiIoReqAlloc;
     /** Queue to defer unmounting to EMT. */
@@ -383,6 +386,26 @@ static DECLCALLBACK(int) drvscsiReqTransferEnqueue(VSCSILUN hVScsiLun, void *pvS
                         pThis->pDrvIns->iInstance, rc));
             break;
         }
+        case VSCSIIOREQTXDIR_WRITE_ZEROES:
+        {
+            uint64_t  uOffset    = 0;
+            size_t    cbTransfer = 0;
+            size_t    cbSeg      = 0;
+            PCRTSGSEG paSeg      = NULL;
+            unsigned  cSeg       = 0;
+
+            rc = VSCSIIoReqParamsGet(hVScsiIoReq, &uOffset, &cbTransfer,
+                                     &cSeg, &cbSeg, &paSeg);
+            AssertRC(rc);
+
+            pThis->pLed->Asserted.s.fWriting = pThis->pLed->Actual.s.fWriting = 1;
+            rc = pThis->pDrvMediaEx->pfnIoReqWriteZeroes(pThis->pDrvMediaEx, hIoReq, uOffset, cbTransfer);
+            if (   RT_FAILURE(rc)
+                && pThis->cErrors++ < MAX_LOG_REL_ERRORS)
+                LogRel(("SCSI#%u: Write zeroes at offset %llu (%zu bytes) returned rc=%Rrc\n",
+                        pThis->pDrvIns->iInstance, uOffset, cbTransfer, rc));
+            break;
+        }
         case VSCSIIOREQTXDIR_READ:
         case VSCSIIOREQTXDIR_WRITE:
         {
@@ -426,7 +449,8 @@ static DECLCALLBACK(int) drvscsiReqTransferEnqueue(VSCSILUN hVScsiLun, void *pvS
     {
         if (enmTxDir == VSCSIIOREQTXDIR_READ)
             pThis->pLed->Actual.s.fReading = 0;
-        else if (enmTxDir == VSCSIIOREQTXDIR_WRITE)
+        else if (   enmTxDir == VSCSIIOREQTXDIR_WRITE
+                 || enmTxDir == VSCSIIOREQTXDIR_WRITE_ZEROES)
             pThis->pLed->Actual.s.fWriting = 0;
         else
             AssertMsg(enmTxDir == VSCSIIOREQTXDIR_FLUSH, ("Invalid transfer direction %u\n", enmTxDir));
@@ -440,7 +464,8 @@ static DECLCALLBACK(int) drvscsiReqTransferEnqueue(VSCSILUN hVScsiLun, void *pvS
     {
         if (enmTxDir == VSCSIIOREQTXDIR_READ)
             pThis->pLed->Actual.s.fReading = 0;
-        else if (enmTxDir == VSCSIIOREQTXDIR_WRITE)
+        else if (   enmTxDir == VSCSIIOREQTXDIR_WRITE
+                 || enmTxDir == VSCSIIOREQTXDIR_WRITE_ZEROES)
             pThis->pLed->Actual.s.fWriting = 0;
         else
             AssertMsg(enmTxDir == VSCSIIOREQTXDIR_FLUSH, ("Invalid transfer direction %u\n", enmTxDir));
@@ -468,6 +493,8 @@ static DECLCALLBACK(int) drvscsiGetFeatureFlags(VSCSILUN hVScsiLun, void *pvScsi
     int rc = pThis->pDrvMediaEx->pfnQueryFeatures(pThis->pDrvMediaEx, &fFeatures);
     if (RT_SUCCESS(rc) && (fFeatures & PDMIMEDIAEX_FEATURE_F_DISCARD))
         *pfFeatures |= VSCSI_LUN_FEATURE_UNMAP;
+    if (RT_SUCCESS(rc) && (fFeatures & PDMIMEDIAEX_FEATURE_F_WRITE_ZEROES))
+        *pfFeatures |= VSCSI_LUN_FEATURE_WRITE_ZEROES;
 
     if (   pThis->pDrvMedia
         && pThis->pDrvMedia->pfnIsNonRotational(pThis->pDrvMedia))
@@ -514,7 +541,8 @@ static DECLCALLBACK(int) drvscsiIoReqCompleteNotify(PPDMIMEDIAEXPORT pInterface,
     if (enmTxDir == VSCSIIOREQTXDIR_READ)
         pThis->pLed->Actual.s.fReading = 0;
     else if (   enmTxDir == VSCSIIOREQTXDIR_WRITE
-             || enmTxDir == VSCSIIOREQTXDIR_UNMAP)
+             || enmTxDir == VSCSIIOREQTXDIR_UNMAP
+             || enmTxDir == VSCSIIOREQTXDIR_WRITE_ZEROES)
         pThis->pLed->Actual.s.fWriting = 0;
     else
         AssertMsg(enmTxDir == VSCSIIOREQTXDIR_FLUSH, ("Invalid transfer direction %u\n", enmTxDir));
@@ -532,6 +560,9 @@ static DECLCALLBACK(int) drvscsiIoReqCompleteNotify(PPDMIMEDIAEXPORT pInterface,
             else if (enmTxDir == VSCSIIOREQTXDIR_UNMAP)
                 LogRel(("SCSI#%u: Unmap returned rc=%Rrc\n",
                         pThis->pDrvIns->iInstance, rcReq));
+            else if (enmTxDir == VSCSIIOREQTXDIR_WRITE_ZEROES)
+                LogRel(("SCSI#%u: Write zeroes returned rc=%Rrc\n",
+                        pThis->pDrvIns->iInstance, rcReq));
             else
             {
                 uint64_t  uOffset    = 0;
@@ -816,8 +847,12 @@ static DECLCALLBACK(int) drvscsiIoReqAllocSizeSet(PPDMIMEDIAEX pInterface, size_
 {
     PDRVSCSI pThis = RT_FROM_MEMBER(pInterface, DRVSCSI, IMediaEx);
 
+    if (RT_UNLIKELY(pThis->hIoReqCache != NIL_RTMEMCACHE))
+        return VERR_INVALID_STATE;
+
     pThis->cbIoReqAlloc = RT_UOFFSETOF_DYN(DRVSCSIREQ, abAlloc[cbIoReqAlloc]);
-    return VINF_SUCCESS;
+    return RTMemCacheCreate(&pThis->hIoReqCache, pThis->cbIoReqAlloc, 0, UINT32_MAX,
+                            NULL, NULL, NULL, 0);
 }
 
 /** @interface_method_impl{PDMIMEDIAEX,pfnIoReqAlloc} */
@@ -828,9 +863,12 @@ static DECLCALLBACK(int) drvscsiIoReqAlloc(PPDMIMEDIAEX pInterface, PPDMMEDIAEXI
 
     int rc = VINF_SUCCESS;
     PDRVSCSI pThis = RT_FROM_MEMBER(pInterface, DRVSCSI, IMediaEx);
-    PDRVSCSIREQ pReq = (PDRVSCSIREQ)RTMemAllocZ(pThis->cbIoReqAlloc);
+    AssertReturn(pThis->hIoReqCache != NIL_RTMEMCACHE, VERR_INVALID_STATE);
+
+    PDRVSCSIREQ pReq = (PDRVSCSIREQ)RTMemCacheAlloc(pThis->hIoReqCache);
     if (RT_LIKELY(pReq))
     {
+        memset(pReq, 0, pThis->cbIoReqAlloc);
         *phIoReq = (PDMMEDIAEXIOREQ)pReq;
         *ppvIoReqAlloc = &pReq->abAlloc[0];
     }
@@ -843,10 +881,10 @@ static DECLCALLBACK(int) drvscsiIoReqAlloc(PPDMIMEDIAEX pInterface, PPDMMEDIAEXI
 /** @interface_method_impl{PDMIMEDIAEX,pfnIoReqFree} */
 static DECLCALLBACK(int) drvscsiIoReqFree(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq)
 {
-    RT_NOREF1(pInterface);
+    PDRVSCSI pThis = RT_FROM_MEMBER(pInterface, DRVSCSI, IMediaEx);
     PDRVSCSIREQ pReq = (PDRVSCSIREQ)hIoReq;
 
-    RTMemFree(pReq);
+    RTMemCacheFree(pThis->hIoReqCache, pReq);
     return VINF_SUCCESS;
 }
 
@@ -915,6 +953,13 @@ static DECLCALLBACK(int) drvscsiIoReqDiscard(PPDMIMEDIAEX pInterface, PDMMEDIAEX
     return VERR_NOT_SUPPORTED;
 }
 
+/** @interface_method_impl{PDMIMEDIAEX,pfnIoReqWriteZeroes} */
+static DECLCALLBACK(int) drvscsiIoReqWriteZeroes(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq, uint64_t off, size_t cbZero)
+{
+    RT_NOREF4(pInterface, hIoReq, off, cbZero);
+    return VERR_NOT_SUPPORTED;
+}
+
 /** @interface_method_impl{PDMIMEDIAEX,pfnIoReqSendScsiCmd} */
 static DECLCALLBACK(int) drvscsiIoReqSendScsiCmd(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq,
                                                  uint32_t uLun, const uint8_t *pbCdb, size_t cbCdb,
@@ -1333,6 +1378,12 @@ static DECLCALLBACK(void) drvscsiDestruct(PPDMDRVINS pDrvIns)
         pThis->hVScsiDevice = NULL;
         pThis->hVScsiLun    = NULL;
     }
+
+    if (pThis->hIoReqCache != NIL_RTMEMCACHE)
+    {
+        RTMemCacheDestroy(pThis->hIoReqCache);
+        pThis->hIoReqCache = NIL_RTMEMCACHE;
+    }
 }
 
 /**
@@ -1351,6 +1402,7 @@ static DECLCALLBACK(int) drvscsiConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, ui
      * Initialize the instance data.
      */
     pThis->pDrvIns                              = pDrvIns;
+    pThis->hIoReqCache                          = NIL_RTMEMCACHE;
 
     pDrvIns->IBase.pfnQueryInterface            = drvscsiQueryInterface;
 
@@ -1389,6 +1441,7 @@ static DECLCALLBACK(int) drvscsiConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, ui
     pThis->IMediaEx.pfnIoReqWrite               = drvscsiIoReqWrite;
     pThis->IMediaEx.pfnIoReqFlush               = drvscsiIoReqFlush;
     pThis->IMediaEx.pfnIoReqDiscard             = drvscsiIoReqDiscard;
+    pThis->IMediaEx.pfnIoReqWriteZeroes         = drvscsiIoReqWriteZeroes;
     pThis->IMediaEx.pfnIoReqSendScsiCmd         = drvscsiIoReqSendScsiCmd;
     pThis->IMediaEx.pfnIoReqGetActiveCount      = drvscsiIoReqGetActiveCount;
     pThis->IMediaEx.pfnIoReqGetSuspendedCount   = drvscsiIoReqGetSuspendedCount;
@@ -1404,6 +1457,7 @@ static DECLCALLBACK(int) drvscsiConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, ui
     pThis->IPortEx.pfnIoReqCopyFromBuf          = drvscsiIoReqCopyFromBuf;
     pThis->IPortEx.pfnIoReqCopyToBuf            = drvscsiIoReqCopyToBuf;
     pThis->IPortEx.pfnIoReqQueryBuf             = NULL;
+    pThis->IPortEx.pfnIoReqQuerySgBuf           = NULL;
     pThis->IPortEx.pfnIoReqQueryDiscardRanges   = drvscsiIoReqQueryDiscardRanges;
     pThis->IPortEx.pfnIoReqStateChanged         = drvscsiIoReqStateChanged;
 
@@ -105,6 +105,11 @@ extern bool DevINIPConfigured(void);
 #define DRVVD_IOREQ_SAVED_STATE_VERSION UINT32_C(1)
 /** Maximum number of request errors in the release log before muting. */
 #define DRVVD_MAX_LOG_REL_ERRORS        100
+/** Maximum number of segments of a direct guest buffer. */
+#define DRVVD_DIRECT_SEGS_MAX           16
+/** Required alignment of the segments of a direct guest buffer, so they can
+ * be passed to host I/O bypassing the host cache. */
+#define DRVVD_DIRECT_SEG_ALIGN          512
 
 /** Forward declaration for the dis kcontainer. */
 typedef struct VBOXDISK *PVBOXDISK;
@@ -197,6 +202,9 @@ typedef struct PDMMEDIAEXIOREQINT
     uint32_t                      fFlags;
     /** Timestamp when the request was submitted. */
     uint64_t                      tsSubmit;
+    /** RTTimeNanoTS() when a read, write or flush request was submitted, for the
+     * latency histograms. */
+    uint64_t                      nsSubmit;
     /** Type dependent data. */
     union
     {
@@ -216,14 +224,17 @@ typedef struct PDMMEDIAEXIOREQINT
             /** Flag whether the pointer is a direct buffer or
              *  was allocated by us. */
             bool                          fDirectBuf;
+            /** Flag whether the request was issued through the coalescing stage
+             * on its own and accounts for one of VBOXDISK::cCoalesceIoInFlight. */
+            bool                          fCoalesced;
             /** Buffer management data based on the fDirectBuf flag. */
             union
             {
                 /** Direct buffer. */
                 struct
                 {
-                    /** Segment for the data buffer. */
-                    RTSGSEG               Seg;
+                    /** Segments of the mapped guest buffer. */
+                    RTSGSEG               aSegs[DRVVD_DIRECT_SEGS_MAX];
                     /** S/G buffer structure. */
                     RTSGBUF               SgBuf;
                 } Direct;
@@ -239,6 +250,14 @@ typedef struct PDMMEDIAEXIOREQINT
             /** Number of ranges to discard. */
             unsigned                      cRanges;
         } Discard;
+        /** Write zeroes specific data. */
+        struct
+        {
+            /** Start offset of the range to zero. */
+            uint64_t                      offStart;
+            /** Size of the range to zero. */
+            size_t                        cbZero;
+        } WriteZeroes;
     };
     /** Allocator specific memory - variable size. */
     uint8_t                       abAlloc[1];
@@ -246,6 +265,32 @@ typedef struct PDMMEDIAEXIOREQINT
 /** Pointer to a VD I/O request. */
 typedef PDMMEDIAEXIOREQINT *PPDMMEDIAEXIOREQINT;
 
+/** Maximum number of requests coalesced into a single I/O. */
+#define DRVVD_COALESCE_REQS_MAX     32
+
+/**
+ * A single I/O made up of several adjacent read or write requests.
+ */
+typedef struct DRVVDIOCOALESCED
+{
+    /** The request type (read or write). */
+    PDMMEDIAEXIOREQTYPE           enmType;
+    /** Number of requests coalesced. */
+    uint32_t                      cIoReqs;
+    /** Start offset of the I/O. */
+    uint64_t                      offStart;
+    /** Size of the I/O. */
+    size_t                        cbIo;
+    /** S/G buffer spanning the buffers of all requests. */
+    RTSGBUF                       SgBuf;
+    /** The coalesced requests, sorted by offset. */
+    PPDMMEDIAEXIOREQINT           apIoReqs[DRVVD_COALESCE_REQS_MAX];
+    /** The segments of the S/G buffer - variable size. */
+    RTSGSEG                       aSegs[1];
+} DRVVDIOCOALESCED;
+/** Pointer to a coalesced I/O. */
+typedef DRVVDIOCOALESCED *PDRVVDIOCOALESCED;
+
 /**
  * Structure for holding a list of allocated requests.
  */
@@ -310,6 +355,8 @@ typedef struct VBOXDISK
 
     /** Flag whether opened disk supports async I/O operations. */
     bool                     fAsyncIOSupported;
+    /** Flag whether a filter transforming the written data was set up. */
+    bool                     fWriteFilters;
     /** Pointer to the list of data we need to keep per image. */
     PVBOXIMAGE               pImages;
     /** Flag whether the media should allow concurrent open for writing. */
@@ -324,6 +371,8 @@ typedef struct VBOXDISK
     unsigned                 uMergeSource;
     /** Target image index for merging. */
     unsigned                 uMergeTarget;
+    /** Maximum number of bytes per second the merge copies, 0 for no limit. */
+    uint64_t                 cbMergeRate;
 
     /** Flag whether boot acceleration is enabled. */
     bool                     fBootAccelEnabled;
@@ -422,6 +471,8 @@ typedef struct VBOXDISK
     RTMEMCACHE               hIoReqCache;
     /** I/O buffer manager. */
     IOBUFMGR                 hIoBufMgr;
+    /** The I/O buffer manager statistics, NULL if not registered. */
+    PIOBUFMGRSTATS           pIoBufStats;
     /** Active request counter. */
     volatile uint32_t        cIoReqsActive;
     /** Bins for allocated requests. */
@@ -442,6 +493,24 @@ typedef struct VBOXDISK
     RTCRITSECT               CritSectIoReqRedo;
     /** Number of errors logged so far. */
     unsigned                 cErrors;
+    /** Flag whether adjacent read/write requests are coalesced under load. */
+    bool                     fCoalesce;
+    /** Flag whether a thread is dispatching the coalescing list, protected by
+     * CritSectCoalesce. */
+    bool                     fCoalesceDispatching;
+    /** Number of I/Os in flight issued through the coalescing stage, protected
+     * by CritSectCoalesce. */
+    uint32_t                 cCoalesceIoInFlight;
+    /** Number of I/Os in flight before requests get queued for coalescing. */
+    uint32_t                 cCoalesceQueueDepth;
+    /** Maximum size of a coalesced I/O in bytes. */
+    uint32_t                 cbCoalesceMax;
+    /** Offset following the last coalesced I/O dispatched, the elevator position. */
+    uint64_t                 offCoalesceHead;
+    /** List of requests waiting to be coalesced sorted by offset - VDIOREQ::NdLstWait. */
+    RTLISTANCHOR             LstIoReqCoalesce;
+    /** Critical section protecting the coalescing state. */
+    RTCRITSECT               CritSectCoalesce;
     /** @} */
 
     /** @name Statistics.
@@ -469,8 +538,24 @@ typedef struct VBOXDISK
     STAMCOUNTER              StatReqsRead;
     /** Release statistics: Number of discard requests. */
     STAMCOUNTER              StatReqsDiscard;
+    /** Release statistics: Number of write zeroes requests. */
+    STAMCOUNTER              StatReqsWriteZeroes;
     /** Release statistics: Number of I/O requests processed per second. */
     STAMCOUNTER              StatReqsPerSec;
+    /** Release statistics: Read request latency. */
+    STAMHISTOGRAM            StatLatencyRead;
+    /** Release statistics: Write request latency. */
+    STAMHISTOGRAM            StatLatencyWrite;
+    /** Release statistics: Flush request latency. */
+    STAMHISTOGRAM            StatLatencyFlush;
+    /** Number of requests which were coalesced with others. */
+    STAMCOUNTER              StatReqsCoalesced;
+    /** Number of coalesced I/Os issued. */
+    STAMCOUNTER              StatIoCoalesced;
+    /** Read-ahead statistics, updated by VD. */
+    VDREADAHEADSTATS         ReadAheadStats;
+    /** Flag whether read-ahead is enabled and its statistics are registered. */
+    bool                     fReadAhead;
     /** @} */
 } VBOXDISK;
 
@@ -484,6 +569,7 @@ static void drvvdPowerOffOrDestructOrUnmount(PPDMDRVINS pDrvIns);
 DECLINLINE(void) drvvdMediaExIoReqBufFree(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq);
 static int drvvdMediaExIoReqCompleteWorker(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq, int rcReq, bool fUpNotify);
 static int drvvdMediaExIoReqReadWriteProcess(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq, bool fUpNotify);
+static void drvvdMediaExIoReqCoalesceIoDone(PVBOXDISK pThis);
 
 /**
  * Internal: allocate new image descriptor and put it in the list
@@ -1679,6 +1765,20 @@ static DECLCALLBACK(int) drvvdFlush(PPDMIMEDIA pInterface)
     return rc;
 }
 
+/**
+ * @callback_method_impl{FNVDSTREAMCOMPLETE}
+ */
+static DECLCALLBACK(void) drvvdStreamComplete(void *pvUser, int rcReq)
+{
+    PVBOXDISK pThis = (PVBOXDISK)pvUser;
+
+    if (RT_SUCCESS(rcReq))
+        LogRel(("VD#%u: Background streaming completed, the parent images are no longer used\n",
+                pThis->pDrvIns->iInstance));
+    else if (rcReq != VERR_CANCELLED)
+        LogRel(("VD#%u: Background streaming failed with %Rrc\n", pThis->pDrvIns->iInstance, rcReq));
+}
+
 /** @interface_method_impl{PDMIMEDIA,pfnMerge} */
 static DECLCALLBACK(int) drvvdMerge(PPDMIMEDIA pInterface,
                                     PFNSIMPLEPROGRESS pfnProgress,
@@ -1714,6 +1814,12 @@ static DECLCALLBACK(int) drvvdMerge(PPDMIMEDIA pInterface,
                              pvUser, sizeof(VDINTERFACEPROGRESS), &pVDIfsOperation);
         AssertRC(rc2);
         pThis->fMergePending = false;
+        if (pThis->cbMergeRate)
+        {
+            LogRel(("VD#%u: Merging with at most %RU64 bytes/s\n", pThis->pDrvIns->iInstance, pThis->cbMergeRate));
+            rc2 = VDSetMergeRate(pThis->pDisk, pThis->cbMergeRate);
+            AssertRC(rc2);
+        }
         rc = VDMerge(pThis->pDisk, pThis->uMergeSource,
                      pThis->uMergeTarget, pVDIfsOperation);
     }
@@ -2520,6 +2626,9 @@ static void drvvdMediaExIoReqRetire(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq,
             case PDMMEDIAEXIOREQTYPE_DISCARD:
                 pcszReq = "Discard";
                 break;
+            case PDMMEDIAEXIOREQTYPE_WRITE_ZEROES:
+                pcszReq = "WriteZeroes";
+                break;
             default:
                 pcszReq = "<Invalid>";
         }
@@ -2541,6 +2650,10 @@ static void drvvdMediaExIoReqRetire(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq,
                 else if (pIoReq->enmType == PDMMEDIAEXIOREQTYPE_DISCARD)
                     LogRel(("VD#%u: Aborted discard returned rc=%Rrc\n",
                             pThis->pDrvIns->iInstance, rcReq));
+                else if (pIoReq->enmType == PDMMEDIAEXIOREQTYPE_WRITE_ZEROES)
+                    LogRel(("VD#%u: Aborted write zeroes (%zu bytes at %llu) returned rc=%Rrc\n",
+                            pThis->pDrvIns->iInstance, pIoReq->WriteZeroes.cbZero,
+                            pIoReq->WriteZeroes.offStart, rcReq));
                 else
                     LogRel(("VD#%u: Aborted %s (%u bytes left) returned rc=%Rrc\n",
                             pThis->pDrvIns->iInstance,
@@ -2557,6 +2670,10 @@ static void drvvdMediaExIoReqRetire(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq,
                 else if (pIoReq->enmType == PDMMEDIAEXIOREQTYPE_DISCARD)
                     LogRel(("VD#%u: Discard returned rc=%Rrc\n",
                             pThis->pDrvIns->iInstance, rcReq));
+                else if (pIoReq->enmType == PDMMEDIAEXIOREQTYPE_WRITE_ZEROES)
+                    LogRel(("VD#%u: Write zeroes (%zu bytes at %llu) returned rc=%Rrc\n",
+                            pThis->pDrvIns->iInstance, pIoReq->WriteZeroes.cbZero,
+                            pIoReq->WriteZeroes.offStart, rcReq));
                 else
                     LogRel(("VD#%u: %s (%u bytes left) returned rc=%Rrc\n",
                             pThis->pDrvIns->iInstance,
@@ -2573,13 +2690,22 @@ static void drvvdMediaExIoReqRetire(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq,
     {
         STAM_REL_COUNTER_INC(&pThis->StatReqsSucceeded);
 
+        /* Requests complete on whatever thread the backend uses, so the histograms must be updated atomically. */
         switch (pIoReq->enmType)
         {
             case PDMMEDIAEXIOREQTYPE_READ:
                 STAM_REL_COUNTER_ADD(&pThis->StatBytesRead, pIoReq->ReadWrite.cbReq);
+                STAM_REL_HISTOGRAM_ADD_PERIOD_ATOMIC(&pThis->StatLatencyRead, RTTimeNanoTS() - pIoReq->nsSubmit);
                 break;
             case PDMMEDIAEXIOREQTYPE_WRITE:
                 STAM_REL_COUNTER_ADD(&pThis->StatBytesWritten, pIoReq->ReadWrite.cbReq);
+                STAM_REL_HISTOGRAM_ADD_PERIOD_ATOMIC(&pThis->StatLatencyWrite, RTTimeNanoTS() - pIoReq->nsSubmit);
+                break;
+            case PDMMEDIAEXIOREQTYPE_FLUSH:
+                STAM_REL_HISTOGRAM_ADD_PERIOD_ATOMIC(&pThis->StatLatencyFlush, RTTimeNanoTS() - pIoReq->nsSubmit);
+                break;
+            case PDMMEDIAEXIOREQTYPE_WRITE_ZEROES:
+                STAM_REL_HISTOGRAM_ADD_PERIOD_ATOMIC(&pThis->StatLatencyWrite, RTTimeNanoTS() - pIoReq->nsSubmit);
                 break;
             default:
                 break;
@@ -2610,6 +2736,16 @@ static int drvvdMediaExIoReqCompleteWorker(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT
     LogFlowFunc(("pThis=%#p pIoReq=%#p rcReq=%Rrc fUpNotify=%RTbool\n",
                  pThis, pIoReq, rcReq, fUpNotify));
 
+    /* The request can be gone after retiring it, so check for a coalescing stage I/O now. */
+    bool fCoalesced = false;
+    if (   (   pIoReq->enmType == PDMMEDIAEXIOREQTYPE_READ
+            || pIoReq->enmType == PDMMEDIAEXIOREQTYPE_WRITE)
+        && pIoReq->ReadWrite.fCoalesced)
+    {
+        pIoReq->ReadWrite.fCoalesced = false;
+        fCoalesced = true;
+    }
+
     /*
      * For a read we need to sync the memory before continuing to process
      * the request further.
@@ -2670,11 +2806,60 @@ static int drvvdMediaExIoReqCompleteWorker(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT
             drvvdMediaExIoReqReadWriteProcess(pThis, pIoReq, fUpNotify);
     }
 
+    if (fCoalesced)
+        drvvdMediaExIoReqCoalesceIoDone(pThis);
+
     LogFlowFunc(("returns %Rrc\n", rcReq));
     return rcReq;
 }
 
 
+/**
+ * Returns whether the guest buffer of the given request may be used directly
+ * for the I/O instead of bouncing the data through an I/O buffer.
+ *
+ * Filters (including encryption) transform the data in place and would trash
+ * guest memory, so this is only done for disks without any.
+ *
+ * @returns Flag whether the direct buffer can be queried.
+ * @param   pThis     VBox disk container instance data.
+ * @param   pIoReq    The I/O request.
+ * @param   cb        Size of the buffer.
+ */
+DECLINLINE(bool) drvvdMediaExIoReqDirectBufIsEligible(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq, size_t cb)
+{
+    return    !pThis->CfgCrypto.pCfgNode
+           && !pThis->fWriteFilters
+           && cb == pIoReq->ReadWrite.cbReq
+           && !(cb & (DRVVD_DIRECT_SEG_ALIGN - 1))
+           && (   pThis->pDrvMediaExPort->pfnIoReqQuerySgBuf
+               || pThis->pDrvMediaExPort->pfnIoReqQueryBuf);
+}
+
+/**
+ * Checks that the direct guest buffer returned by the device covers the whole
+ * request and is suitably aligned for uncached host I/O.
+ *
+ * @returns Flag whether the buffer is usable.
+ * @param   paSegs    The segments of the guest buffer.
+ * @param   cSegs     Number of segments.
+ * @param   cb        Size of the request.
+ */
+static bool drvvdMediaExIoReqDirectBufIsValid(PCRTSGSEG paSegs, unsigned cSegs, size_t cb)
+{
+    size_t cbTotal = 0;
+    for (unsigned i = 0; i < cSegs; i++)
+    {
+        if (   ((uintptr_t)paSegs[i].pvSeg & (DRVVD_DIRECT_SEG_ALIGN - 1))
+            || (paSegs[i].cbSeg & (DRVVD_DIRECT_SEG_ALIGN - 1))
+            || !paSegs[i].cbSeg)
+            return false;
+        cbTotal += paSegs[i].cbSeg;
+    }
+
+    return cSegs > 0 && cbTotal == cb;
+}
+
 /**
  * Allocates a memory buffer suitable for I/O for the given request.
  *
@@ -2690,34 +2875,38 @@ DECLINLINE(int) drvvdMediaExIoReqBufAlloc(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT p
     int rc = VERR_NOT_SUPPORTED;
     LogFlowFunc(("pThis=%#p pIoReq=%#p cb=%zu\n", pThis, pIoReq, cb));
 
-/** @todo This does not work at all with encryption enabled because the encryption plugin
- *         encrypts the data in place trashing guest memory and causing data corruption later on!
- *
- * DO NOT ENABLE UNLESS YOU WANT YOUR DATA SHREDDED!!!
- */
-#if 0
-    if (   cb == _4K
-        && pThis->pDrvMediaExPort->pfnIoReqQueryBuf)
+    if (drvvdMediaExIoReqDirectBufIsEligible(pThis, pIoReq, cb))
     {
-        /* Try to get a direct pointer to the buffer first. */
-        void *pvBuf = NULL;
-        size_t cbBuf = 0;
+        /*
+         * Try to get the guest buffer mapped to avoid copying the data, the bounce
+         * buffer is only used if the device can't map the complete buffer.
+         */
+        PRTSGSEG paSegs = &pIoReq->ReadWrite.Direct.aSegs[0];
+        unsigned cSegs  = RT_ELEMENTS(pIoReq->ReadWrite.Direct.aSegs);
 
         STAM_COUNTER_INC(&pThis->StatQueryBufAttempts);
-        rc = pThis->pDrvMediaExPort->pfnIoReqQueryBuf(pThis->pDrvMediaExPort, pIoReq, &pIoReq->abAlloc[0],
-                                                      &pvBuf, &cbBuf);
-        if (RT_SUCCESS(rc))
+        if (pThis->pDrvMediaExPort->pfnIoReqQuerySgBuf)
+            rc = pThis->pDrvMediaExPort->pfnIoReqQuerySgBuf(pThis->pDrvMediaExPort, pIoReq, &pIoReq->abAlloc[0],
+                                                            paSegs, &cSegs);
+        else
+        {
+            cSegs = 1;
+            rc = pThis->pDrvMediaExPort->pfnIoReqQueryBuf(pThis->pDrvMediaExPort, pIoReq, &pIoReq->abAlloc[0],
+                                                          &paSegs[0].pvSeg, &paSegs[0].cbSeg);
+        }
+
+        if (   RT_SUCCESS(rc)
+            && drvvdMediaExIoReqDirectBufIsValid(paSegs, cSegs, cb))
         {
             STAM_COUNTER_INC(&pThis->StatQueryBufSuccess);
-            pIoReq->ReadWrite.cbIoBuf           = cbBuf;
-            pIoReq->ReadWrite.fDirectBuf        = true;
-            pIoReq->ReadWrite.Direct.Seg.pvSeg  = pvBuf;
-            pIoReq->ReadWrite.Direct.Seg.cbSeg  = cbBuf;
-            RTSgBufInit(&pIoReq->ReadWrite.Direct.SgBuf, &pIoReq->ReadWrite.Direct.Seg, 1);
-            pIoReq->ReadWrite.pSgBuf = &pIoReq->ReadWrite.Direct.SgBuf;
+            pIoReq->ReadWrite.cbIoBuf    = cb;
+            pIoReq->ReadWrite.fDirectBuf = true;
+            RTSgBufInit(&pIoReq->ReadWrite.Direct.SgBuf, paSegs, cSegs);
+            pIoReq->ReadWrite.pSgBuf     = &pIoReq->ReadWrite.Direct.SgBuf;
         }
+        else
+            rc = VERR_NOT_SUPPORTED; /* Fall back to the bounce buffer, the device releases any mappings on completion. */
     }
-#endif
 
     if (RT_FAILURE(rc))
     {
@@ -2951,6 +3140,304 @@ static int drvvdMediaExIoReqDiscardWrapper(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT
     return rc;
 }
 
+/**
+ * Wrapper around the write zeroes method.
+ *
+ * @returns VBox status code.
+ * @param   pThis     VBox disk container instance data.
+ * @param   pIoReq    The write zeroes request to process.
+ */
+static int drvvdMediaExIoReqWriteZeroesWrapper(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq)
+{
+    int rc = VINF_SUCCESS;
+
+    LogFlowFunc(("pThis=%#p pIoReq=%#p\n", pThis, pIoReq));
+
+    if (   pThis->fAsyncIOSupported
+        && !(pIoReq->fFlags & PDMIMEDIAEX_F_SYNC))
+        rc = VDAsyncWriteZeroes(pThis->pDisk, pIoReq->WriteZeroes.offStart, pIoReq->WriteZeroes.cbZero,
+                                drvvdMediaExIoReqComplete, pThis, pIoReq);
+    else
+    {
+        rc = VDWriteZeroes(pThis->pDisk, pIoReq->WriteZeroes.offStart, pIoReq->WriteZeroes.cbZero);
+        if (RT_SUCCESS(rc))
+            rc = VINF_VD_ASYNC_IO_FINISHED;
+    }
+
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+/**
+ * Checks whether the given read/write request can go through the coalescing stage.
+ *
+ * Only requests going to the asynchronous I/O path without a block cache which
+ * are transferred in a single chunk qualify.
+ *
+ * @returns Flag whether the request can be coalesced.
+ * @param   pThis     VBox disk container instance data.
+ * @param   pIoReq    The I/O request to check.
+ */
+DECLINLINE(bool) drvvdMediaExIoReqCoalesceIsEligible(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq)
+{
+    return    pThis->fCoalesce
+           && pThis->fAsyncIOSupported
+           && !pThis->pBlkCache
+           && !(pIoReq->fFlags & PDMIMEDIAEX_F_SYNC)
+           && pIoReq->ReadWrite.cbReqLeft == pIoReq->ReadWrite.cbReq
+           && pIoReq->ReadWrite.cbIoBuf >= pIoReq->ReadWrite.cbReq
+           && pIoReq->ReadWrite.cbReq <= pThis->cbCoalesceMax;
+}
+
+/**
+ * Submits a read/write request to the coalescing stage.
+ *
+ * As long as there are less than the configured number of I/Os in flight the
+ * request is passed through so an idle disk doesn't see any additional latency.
+ * Otherwise it is put onto the list of waiting requests sorted by offset, where
+ * it gets picked up by whoever completes the next I/O.
+ *
+ * @returns Flag whether the request was queued, false if the caller has to issue it.
+ * @param   pThis     VBox disk container instance data.
+ * @param   pIoReq    The I/O request to submit.
+ */
+static bool drvvdMediaExIoReqCoalesceSubmit(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq)
+{
+    bool fQueued = false;
+
+    RTCritSectEnter(&pThis->CritSectCoalesce);
+    if (   RTListIsEmpty(&pThis->LstIoReqCoalesce)
+        && pThis->cCoalesceIoInFlight < pThis->cCoalesceQueueDepth)
+    {
+        pThis->cCoalesceIoInFlight++;
+        pIoReq->ReadWrite.fCoalesced = true;
+    }
+    else
+    {
+        /* Search from the end, the guest is most likely submitting sequentially. */
+        PPDMMEDIAEXIOREQINT pIt;
+        bool fInserted = false;
+        RTListForEachReverse(&pThis->LstIoReqCoalesce, pIt, PDMMEDIAEXIOREQINT, NdLstWait)
+        {
+            if (pIt->ReadWrite.offStart <= pIoReq->ReadWrite.offStart)
+            {
+                RTListNodeInsertAfter(&pIt->NdLstWait, &pIoReq->NdLstWait);
+                fInserted = true;
+                break;
+            }
+        }
+        if (!fInserted)
+            RTListPrepend(&pThis->LstIoReqCoalesce, &pIoReq->NdLstWait);
+        fQueued = true;
+    }
+    RTCritSectLeave(&pThis->CritSectCoalesce);
+
+    return fQueued;
+}
+
+/**
+ * Takes the next request(s) from the coalescing list, caller must own the
+ * coalescing critical section.
+ *
+ * The list is served like a one way elevator starting at the first request at
+ * or after the end of the previous I/O, wrapping around to the lowest offset.
+ * Adjacent requests of the same type following it are merged into one I/O.
+ *
+ * @returns Pointer to the coalesced I/O or NULL if only a single request was taken,
+ *          returned in @a ppIoReq then.
+ * @param   pThis     VBox disk container instance data.
+ * @param   ppIoReq   Where to store the request if it was not coalesced with others.
+ */
+static PDRVVDIOCOALESCED drvvdMediaExIoReqCoalesceGather(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT *ppIoReq)
+{
+    PPDMMEDIAEXIOREQINT pFirst = NULL;
+    PPDMMEDIAEXIOREQINT pIt;
+    RTListForEach(&pThis->LstIoReqCoalesce, pIt, PDMMEDIAEXIOREQINT, NdLstWait)
+    {
+        if (pIt->ReadWrite.offStart >= pThis->offCoalesceHead)
+        {
+            pFirst = pIt;
+            break;
+        }
+    }
+    if (!pFirst)
+        pFirst = RTListGetFirst(&pThis->LstIoReqCoalesce, PDMMEDIAEXIOREQINT, NdLstWait);
+    AssertPtr(pFirst);
+
+    uint32_t cIoReqs = 1;
+    size_t   cbIo    = pFirst->ReadWrite.cbReq;
+    unsigned cSegs   = pFirst->ReadWrite.pSgBuf->cSegs;
+    PPDMMEDIAEXIOREQINT pLast = pFirst;
+    while (cIoReqs < DRVVD_COALESCE_REQS_MAX)
+    {
+        PPDMMEDIAEXIOREQINT pNext = RTListGetNext(&pThis->LstIoReqCoalesce, pLast, PDMMEDIAEXIOREQINT, NdLstWait);
+        if (   !pNext
+            || pNext->enmType != pFirst->enmType
+            || pNext->ReadWrite.offStart != pFirst->ReadWrite.offStart + cbIo
+            || cbIo + pNext->ReadWrite.cbReq > pThis->cbCoalesceMax)
+            break;
+
+        cbIo  += pNext->ReadWrite.cbReq;
+        cSegs += pNext->ReadWrite.pSgBuf->cSegs;
+        cIoReqs++;
+        pLast = pNext;
+    }
+
+    PDRVVDIOCOALESCED pIo = NULL;
+    if (cIoReqs > 1)
+        pIo = (PDRVVDIOCOALESCED)RTMemAlloc(RT_UOFFSETOF_DYN(DRVVDIOCOALESCED, aSegs[cSegs]));
+    if (!pIo)
+    {
+        /* Nothing to merge or out of memory, pass the first request on alone. */
+        RTListNodeRemove(&pFirst->NdLstWait);
+        pThis->offCoalesceHead = pFirst->ReadWrite.offStart + pFirst->ReadWrite.cbReq;
+        *ppIoReq = pFirst;
+        return NULL;
+    }
+
+    pIo->enmType  = pFirst->enmType;
+    pIo->cIoReqs  = cIoReqs;
+    pIo->offStart = pFirst->ReadWrite.offStart;
+    pIo->cbIo     = cbIo;
+
+    unsigned iSeg = 0;
+    pIt = pFirst;
+    for (uint32_t i = 0; i < cIoReqs; i++)
+    {
+        PPDMMEDIAEXIOREQINT pNext = RTListGetNext(&pThis->LstIoReqCoalesce, pIt, PDMMEDIAEXIOREQINT, NdLstWait);
+        RTListNodeRemove(&pIt->NdLstWait);
+        pIo->apIoReqs[i] = pIt;
+
+        /* The I/O buffer might be larger than the request, only take what is needed. */
+        PCRTSGBUF pSgBuf = pIt->ReadWrite.pSgBuf;
+        size_t cbLeft = pIt->ReadWrite.cbReq;
+        for (unsigned iSegReq = 0; iSegReq < pSgBuf->cSegs && cbLeft; iSegReq++)
+        {
+            pIo->aSegs[iSeg].pvSeg = pSgBuf->paSegs[iSegReq].pvSeg;
+            pIo->aSegs[iSeg].cbSeg = RT_MIN(cbLeft, pSgBuf->paSegs[iSegReq].cbSeg);
+            cbLeft -= pIo->aSegs[iSeg].cbSeg;
+            iSeg++;
+        }
+        Assert(!cbLeft);
+        pIt = pNext;
+    }
+    RTSgBufInit(&pIo->SgBuf, &pIo->aSegs[0], iSeg);
+
+    pThis->offCoalesceHead = pIo->offStart + cbIo;
+    STAM_REL_COUNTER_INC(&pThis->StatIoCoalesced);
+    STAM_REL_COUNTER_ADD(&pThis->StatReqsCoalesced, cIoReqs);
+    return pIo;
+}
+
+/**
+ * @copydoc FNVDASYNCTRANSFERCOMPLETE
+ */
+static DECLCALLBACK(void) drvvdMediaExIoReqCoalescedComplete(void *pvUser1, void *pvUser2, int rcReq)
+{
+    PVBOXDISK pThis = (PVBOXDISK)pvUser1;
+    PDRVVDIOCOALESCED pIo = (PDRVVDIOCOALESCED)pvUser2;
+
+    /* Split the completion up again, a failure fails all requests. */
+    for (uint32_t i = 0; i < pIo->cIoReqs; i++)
+        drvvdMediaExIoReqCompleteWorker(pThis, pIo->apIoReqs[i], rcReq, true /* fUpNotify */);
+
+    RTMemFree(pIo);
+    drvvdMediaExIoReqCoalesceIoDone(pThis);
+}
+
+/**
+ * Issues the I/O for a single request taken from the coalescing list.
+ *
+ * @param   pThis     VBox disk container instance data.
+ * @param   pIoReq    The I/O request to issue.
+ */
+static void drvvdMediaExIoReqCoalesceIssueSingle(PVBOXDISK pThis, PPDMMEDIAEXIOREQINT pIoReq)
+{
+    int rc;
+
+    pIoReq->ReadWrite.fCoalesced = true;
+    if (pIoReq->enmType == PDMMEDIAEXIOREQTYPE_READ)
+        rc = VDAsyncRead(pThis->pDisk, pIoReq->ReadWrite.offStart, pIoReq->ReadWrite.cbReq, pIoReq->ReadWrite.pSgBuf,
+                         drvvdMediaExIoReqComplete, pThis, pIoReq);
+    else
+        rc = VDAsyncWrite(pThis->pDisk, pIoReq->ReadWrite.offStart, pIoReq->ReadWrite.cbReq, pIoReq->ReadWrite.pSgBuf,
+                          drvvdMediaExIoReqComplete, pThis, pIoReq);
+    if (rc != VERR_VD_ASYNC_IO_IN_PROGRESS)
+    {
+        if (rc == VINF_VD_ASYNC_IO_FINISHED)
+            rc = VINF_SUCCESS;
+        drvvdMediaExIoReqCompleteWorker(pThis, pIoReq, rc, true /* fUpNotify */);
+    }
+}
+
+/**
+ * Issues a coalesced I/O.
+ *
+ * @param   pThis     VBox disk container instance data.
+ * @param   pIo       The coalesced I/O to issue.
+ */
+static void drvvdMediaExIoReqCoalesceIssue(PVBOXDISK pThis, PDRVVDIOCOALESCED pIo)
+{
+    int rc;
+
+    LogFlowFunc(("pThis=%#p pIo=%#p offStart=%llu cbIo=%zu cIoReqs=%u\n",
+                 pThis, pIo, pIo->offStart, pIo->cbIo, pIo->cIoReqs));
+
+    if (pIo->enmType == PDMMEDIAEXIOREQTYPE_READ)
+        rc = VDAsyncRead(pThis->pDisk, pIo->offStart, pIo->cbIo, &pIo->SgBuf,
+                         drvvdMediaExIoReqCoalescedComplete, pThis, pIo);
+    else
+        rc = VDAsyncWrite(pThis->pDisk, pIo->offStart, pIo->cbIo, &pIo->SgBuf,
+                          drvvdMediaExIoReqCoalescedComplete, pThis, pIo);
+    if (rc != VERR_VD_ASYNC_IO_IN_PROGRESS)
+    {
+        if (rc == VINF_VD_ASYNC_IO_FINISHED)
+            rc = VINF_SUCCESS;
+        drvvdMediaExIoReqCoalescedComplete(pThis, pIo, rc);
+    }
+}
+
+/**
+ * Accounts for a completed I/O of the coalescing stage and dispatches waiting
+ * requests if nobody else does already.
+ *
+ * The dispatching thread keeps going until the list is empty or the queue depth
+ * is reached again. I/Os completing synchronously while dispatching just drop
+ * the in flight counter, so there is no recursion.
+ *
+ * @param   pThis     VBox disk container instance data.
+ */
+static void drvvdMediaExIoReqCoalesceIoDone(PVBOXDISK pThis)
+{
+    RTCritSectEnter(&pThis->CritSectCoalesce);
+    Assert(pThis->cCoalesceIoInFlight > 0);
+    pThis->cCoalesceIoInFlight--;
+
+    if (   !pThis->fCoalesceDispatching
+        && !RTListIsEmpty(&pThis->LstIoReqCoalesce))
+    {
+        pThis->fCoalesceDispatching = true;
+        while (   !RTListIsEmpty(&pThis->LstIoReqCoalesce)
+               && pThis->cCoalesceIoInFlight < pThis->cCoalesceQueueDepth)
+        {
+            PPDMMEDIAEXIOREQINT pIoReq = NULL;
+            PDRVVDIOCOALESCED pIo = drvvdMediaExIoReqCoalesceGather(pThis, &pIoReq);
+            pThis->cCoalesceIoInFlight++;
+            RTCritSectLeave(&pThis->CritSectCoalesce);
+
+            if (pIo)
+                drvvdMediaExIoReqCoalesceIssue(pThis, pIo);
+            else
+                drvvdMediaExIoReqCoalesceIssueSingle(pThis, pIoReq);
+
+            RTCritSectEnter(&pThis->CritSectCoalesce);
+        }
+        pThis->fCoalesceDispatching = false;
+    }
+
+    RTCritSectLeave(&pThis->CritSectCoalesce);
+}
+
 /**
  * Processes a read/write request.
  *
@@ -2969,6 +3456,21 @@ static int drvvdMediaExIoReqReadWriteProcess(PVBOXDISK pThis, PPDMMEDIAEXIOREQIN
 
     rc = drvvdKeyCheckPrereqs(pThis, false /* fSetError */);
 
+    bool fIoBufSynced = false;
+    if (   rc == VINF_SUCCESS
+        && drvvdMediaExIoReqCoalesceIsEligible(pThis, pIoReq))
+    {
+        /* The data must be in our buffer before the request can be issued from another thread. */
+        if (pIoReq->enmType == PDMMEDIAEXIOREQTYPE_WRITE)
+        {
+            rc = drvvdMediaExIoReqBufSync(pThis, pIoReq, true /* fToIoBuf */);
+            fIoBufSynced = true;
+        }
+        if (   RT_SUCCESS(rc)
+            && drvvdMediaExIoReqCoalesceSubmit(pThis, pIoReq))
+            rc = VINF_PDM_MEDIAEX_IOREQ_IN_PROGRESS;
+    }
+
     while (   pIoReq->ReadWrite.cbReqLeft
            && rc == VINF_SUCCESS)
     {
@@ -2981,7 +3483,9 @@ static int drvvdMediaExIoReqReadWriteProcess(PVBOXDISK pThis, PPDMMEDIAEXIOREQIN
         else
         {
             /* Sync memory buffer from the request initiator. */
-            rc = drvvdMediaExIoReqBufSync(pThis, pIoReq, true /* fToIoBuf */);
+            if (!fIoBufSynced)
+                rc = drvvdMediaExIoReqBufSync(pThis, pIoReq, true /* fToIoBuf */);
+            fIoBufSynced = false;
             if (RT_SUCCESS(rc))
                 rc = drvvdMediaExIoReqWriteWrapper(pThis, pIoReq, cbReqIo, &cbReqIo);
         }
@@ -3299,6 +3803,11 @@ static DECLCALLBACK(int) drvvdQueryFeatures(PPDMIMEDIAEX pInterface, uint32_t *p
         fFeatures |= PDMIMEDIAEX_FEATURE_F_ASYNC;
     if (pThis->IMedia.pfnDiscard)
         fFeatures |= PDMIMEDIAEX_FEATURE_F_DISCARD;
+    /* The zeroes are written from a shared buffer which can't go through the block cache or any filter. */
+    if (   !pThis->pBlkCache
+        && !pThis->fWriteFilters
+        && !pThis->CfgCrypto.pCfgNode)
+        fFeatures |= PDMIMEDIAEX_FEATURE_F_WRITE_ZEROES;
 
     *pfFeatures = fFeatures;
 
@@ -3338,7 +3847,7 @@ static DECLCALLBACK(int) drvvdIoReqAllocSizeSet(PPDMIMEDIAEX pInterface, size_t
         return VERR_INVALID_STATE;
 
     return RTMemCacheCreate(&pThis->hIoReqCache, sizeof(PDMMEDIAEXIOREQINT) + cbIoReqAlloc, 0, UINT32_MAX,
-                            NULL, NULL, NULL, 0);
+                            NULL, NULL, NULL, RTMEMCACHE_F_MAGAZINES);
 }
 
 /**
@@ -3534,9 +4043,11 @@ static DECLCALLBACK(int) drvvdIoReqRead(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ
 
     pIoReq->enmType             = PDMMEDIAEXIOREQTYPE_READ;
     pIoReq->tsSubmit            = RTTimeMilliTS();
+    pIoReq->nsSubmit            = RTTimeNanoTS();
     pIoReq->ReadWrite.offStart  = off;
     pIoReq->ReadWrite.cbReq     = cbRead;
     pIoReq->ReadWrite.cbReqLeft = cbRead;
+    pIoReq->ReadWrite.fCoalesced = false;
     /* Allocate a suitable I/O buffer for this request. */
     int rc = drvvdMediaExIoReqBufAlloc(pThis, pIoReq, cbRead);
     if (rc == VINF_SUCCESS)
@@ -3576,9 +4087,11 @@ static DECLCALLBACK(int) drvvdIoReqWrite(PPDMIMEDIAEX pInterface, PDMMEDIAEXIORE
 
     pIoReq->enmType             = PDMMEDIAEXIOREQTYPE_WRITE;
     pIoReq->tsSubmit            = RTTimeMilliTS();
+    pIoReq->nsSubmit            = RTTimeNanoTS();
     pIoReq->ReadWrite.offStart  = off;
     pIoReq->ReadWrite.cbReq     = cbWrite;
     pIoReq->ReadWrite.cbReqLeft = cbWrite;
+    pIoReq->ReadWrite.fCoalesced = false;
     /* Allocate a suitable I/O buffer for this request. */
     int rc = drvvdMediaExIoReqBufAlloc(pThis, pIoReq, cbWrite);
     if (rc == VINF_SUCCESS)
@@ -3618,6 +4131,7 @@ static DECLCALLBACK(int) drvvdIoReqFlush(PPDMIMEDIAEX pInterface, PDMMEDIAEXIORE
 
     pIoReq->enmType  = PDMMEDIAEXIOREQTYPE_FLUSH;
     pIoReq->tsSubmit = RTTimeMilliTS();
+    pIoReq->nsSubmit = RTTimeNanoTS();
     bool fXchg = ASMAtomicCmpXchgU32((volatile uint32_t *)&pIoReq->enmState, VDIOREQSTATE_ACTIVE, VDIOREQSTATE_ALLOCATED);
     if (RT_UNLIKELY(!fXchg))
     {
@@ -3691,6 +4205,55 @@ static DECLCALLBACK(int) drvvdIoReqDiscard(PPDMIMEDIAEX pInterface, PDMMEDIAEXIO
     return rc;
 }
 
+/**
+ * @interface_method_impl{PDMIMEDIAEX,pfnIoReqWriteZeroes}
+ */
+static DECLCALLBACK(int) drvvdIoReqWriteZeroes(PPDMIMEDIAEX pInterface, PDMMEDIAEXIOREQ hIoReq, uint64_t off, size_t cbZero)
+{
+    PVBOXDISK pThis = RT_FROM_MEMBER(pInterface, VBOXDISK, IMediaEx);
+    PPDMMEDIAEXIOREQINT pIoReq = hIoReq;
+    VDIOREQSTATE enmState = (VDIOREQSTATE)ASMAtomicReadU32((volatile uint32_t *)&pIoReq->enmState);
+
+    if (RT_UNLIKELY(enmState == VDIOREQSTATE_CANCELED))
+        return VERR_PDM_MEDIAEX_IOREQ_CANCELED;
+
+    if (RT_UNLIKELY(enmState != VDIOREQSTATE_ALLOCATED))
+        return VERR_PDM_MEDIAEX_IOREQ_INVALID_STATE;
+
+    if (RT_UNLIKELY(   pThis->pBlkCache
+                    || pThis->fWriteFilters
+                    || pThis->CfgCrypto.pCfgNode))
+        return VERR_NOT_SUPPORTED;
+
+    STAM_REL_COUNTER_INC(&pThis->StatReqsSubmitted);
+    STAM_REL_COUNTER_INC(&pThis->StatReqsWriteZeroes);
+
+    pIoReq->enmType              = PDMMEDIAEXIOREQTYPE_WRITE_ZEROES;
+    pIoReq->tsSubmit             = RTTimeMilliTS();
+    pIoReq->nsSubmit             = RTTimeNanoTS();
+    pIoReq->WriteZeroes.offStart = off;
+    pIoReq->WriteZeroes.cbZero   = cbZero;
+    bool fXchg = ASMAtomicCmpXchgU32((volatile uint32_t *)&pIoReq->enmState, VDIOREQSTATE_ACTIVE, VDIOREQSTATE_ALLOCATED);
+    if (RT_UNLIKELY(!fXchg))
+    {
+        /* Must have been canceled inbetween. */
+        Assert(pIoReq->enmState == VDIOREQSTATE_CANCELED);
+        return VERR_PDM_MEDIAEX_IOREQ_CANCELED;
+    }
+
+    ASMAtomicIncU32(&pThis->cIoReqsActive);
+    int rc = drvvdMediaExIoReqWriteZeroesWrapper(pThis, pIoReq);
+    if (rc == VERR_VD_ASYNC_IO_IN_PROGRESS)
+        rc = VINF_PDM_MEDIAEX_IOREQ_IN_PROGRESS;
+    else if (rc == VINF_VD_ASYNC_IO_FINISHED)
+        rc = VINF_SUCCESS;
+
+    if (rc != VINF_PDM_MEDIAEX_IOREQ_IN_PROGRESS)
+        rc = drvvdMediaExIoReqCompleteWorker(pThis, pIoReq, rc, false /* fUpNotify */);
+
+    return rc;
+}
+
 /**
  * @interface_method_impl{PDMIMEDIAEX,pfnIoReqSendScsiCmd}
  */
@@ -3857,6 +4420,11 @@ static DECLCALLBACK(int) drvvdIoReqSuspendedSave(PPDMIMEDIAEX pInterface, PSSMHA
             pHlp->pfnSSMPutU64(pSSM, pIoReq->Discard.paRanges[i].cbRange);
         }
     }
+    else if (pIoReq->enmType == PDMMEDIAEXIOREQTYPE_WRITE_ZEROES)
+    {
+        pHlp->pfnSSMPutU64(pSSM, pIoReq->WriteZeroes.offStart);
+        pHlp->pfnSSMPutU64(pSSM, pIoReq->WriteZeroes.cbZero);
+    }
 
     return pHlp->pfnSSMPutU32(pSSM, UINT32_MAX); /* sanity/terminator */
 }
@@ -3886,7 +4454,8 @@ static DECLCALLBACK(int) drvvdIoReqSuspendedLoad(PPDMIMEDIAEX pInterface, PSSMHA
         AssertReturn(   u32 == PDMMEDIAEXIOREQTYPE_WRITE
                      || u32 == PDMMEDIAEXIOREQTYPE_READ
                      || u32 == PDMMEDIAEXIOREQTYPE_DISCARD
-                     || u32 == PDMMEDIAEXIOREQTYPE_FLUSH,
+                     || u32 == PDMMEDIAEXIOREQTYPE_FLUSH
+                     || u32 == PDMMEDIAEXIOREQTYPE_WRITE_ZEROES,
                      VERR_SSM_DATA_UNIT_FORMAT_CHANGED);
         pIoReq->enmType = (PDMMEDIAEXIOREQTYPE)u32;
 
@@ -3945,6 +4514,12 @@ static DECLCALLBACK(int) drvvdIoReqSuspendedLoad(PPDMIMEDIAEX pInterface, PSSMHA
                     rc = VERR_NO_MEMORY;
             }
         }
+        else if (pIoReq->enmType == PDMMEDIAEXIOREQTYPE_WRITE_ZEROES)
+        {
+            pHlp->pfnSSMGetU64(pSSM, &pIoReq->WriteZeroes.offStart);
+            rc = pHlp->pfnSSMGetU64(pSSM, &u64);
+            pIoReq->WriteZeroes.cbZero = (size_t)u64;
+        }
 
         if (RT_SUCCESS(rc))
             rc = pHlp->pfnSSMGetU32(pSSM, &u32); /* sanity/terminator */
@@ -4038,6 +4613,8 @@ static int drvvdSetupFilters(PVBOXDISK pThis, PCFGMNODE pCfg)
             AssertRC(rc);
 
             rc = VDFilterAdd(pThis->pDisk, pszFilterName, VD_FILTER_FLAGS_DEFAULT, pVDIfsFilter);
+            if (RT_SUCCESS(rc))
+                pThis->fWriteFilters = true;
 
             PDMDrvHlpMMHeapFree(pThis->pDrvIns, pszFilterName);
         }
@@ -4183,10 +4760,58 @@ static int drvvdStatsRegister(PVBOXDISK pThis)
                            "Number of read I/O requests submitted.",        "%s/ReqsRead", szPrefix);
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatReqsDiscard,        STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
                            "Number of discard I/O requests submitted.",     "%s/ReqsDiscard", szPrefix);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatReqsWriteZeroes,    STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                           "Number of write zeroes I/O requests submitted.", "%s/ReqsWriteZeroes", szPrefix);
 
     PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatReqsPerSec,         STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
                            "Number of processed I/O requests per second.",  "%s/ReqsPerSec", szPrefix);
 
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatLatencyRead,        STAMTYPE_HISTOGRAM, STAMVISIBILITY_USED, STAMUNIT_NS_PER_CALL,
+                           "Latency of the read requests.",                 "%s/LatencyRead", szPrefix);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatLatencyWrite,       STAMTYPE_HISTOGRAM, STAMVISIBILITY_USED, STAMUNIT_NS_PER_CALL,
+                           "Latency of the write requests.",                "%s/LatencyWrite", szPrefix);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatLatencyFlush,       STAMTYPE_HISTOGRAM, STAMVISIBILITY_USED, STAMUNIT_NS_PER_CALL,
+                           "Latency of the flush requests.",                "%s/LatencyFlush", szPrefix);
+
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatReqsCoalesced,      STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                           "Number of requests coalesced with adjacent ones.", "%s/ReqsCoalesced", szPrefix);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->StatIoCoalesced,        STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                           "Number of coalesced I/Os issued.",              "%s/IoCoalesced", szPrefix);
+
+    if (pThis->hIoBufMgr != NIL_IOBUFMGR)
+    {
+        PIOBUFMGRSTATS pIoBufStats = IOBUFMgrGetStats(pThis->hIoBufMgr);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pIoBufStats->StatAllocs,          STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                               "Number of I/O buffer allocations.",             "%s/IoBufAllocs", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pIoBufStats->StatAllocFailures,   STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                               "Number of I/O buffer allocations failing for lack of memory.", "%s/IoBufAllocFailures", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pIoBufStats->StatAllocPartial,    STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                               "Number of I/O buffer allocations smaller than requested.", "%s/IoBufAllocPartial", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pIoBufStats->StatAllocOtherPool,  STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                               "Number of I/O buffer allocations served by another CPU's pool.", "%s/IoBufAllocOtherPool", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pIoBufStats->StatAllocSuspended,  STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                               "Number of times a fragmented I/O buffer pool held back allocations.", "%s/IoBufAllocSuspended", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pIoBufStats->StatPoolsLargePages, STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                               "Number of I/O buffer pools backed by large pages.", "%s/IoBufPoolsLargePages", szPrefix);
+        pThis->pIoBufStats = pIoBufStats;
+    }
+
+    if (pThis->fReadAhead)
+    {
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->ReadAheadStats.cPrefetches,  STAMTYPE_U64, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                               "Number of read-ahead prefetches issued.",       "%s/ReadAheadPrefetches", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->ReadAheadStats.cbPrefetched, STAMTYPE_U64, STAMVISIBILITY_USED, STAMUNIT_BYTES,
+                               "Amount of data prefetched.",                    "%s/ReadAheadBytesPrefetched", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->ReadAheadStats.cHits,        STAMTYPE_U64, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                               "Number of reads served from prefetched data.",  "%s/ReadAheadHits", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->ReadAheadStats.cMisses,      STAMTYPE_U64, STAMVISIBILITY_USED, STAMUNIT_COUNT,
+                               "Number of sequential reads not (fully) served from prefetched data.", "%s/ReadAheadMisses", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->ReadAheadStats.cbHit,        STAMTYPE_U64, STAMVISIBILITY_USED, STAMUNIT_BYTES,
+                               "Amount of data served from prefetched data.",   "%s/ReadAheadBytesHit", szPrefix);
+        PDMDrvHlpSTAMRegisterF(pDrvIns, &pThis->ReadAheadStats.cbWasted,     STAMTYPE_U64, STAMVISIBILITY_USED, STAMUNIT_BYTES,
+                               "Amount of prefetched data dropped unused.",     "%s/ReadAheadBytesWasted", szPrefix);
+    }
+
     return VINF_SUCCESS;
 }
 
@@ -4211,7 +4836,23 @@ static void drvvdStatsDeregister(PVBOXDISK pThis)
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReqsWrite);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReqsRead);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReqsDiscard);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReqsWriteZeroes);
     PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReqsPerSec);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatLatencyRead);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatLatencyWrite);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatLatencyFlush);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatReqsCoalesced);
+    PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->StatIoCoalesced);
+
+    if (pThis->fReadAhead)
+    {
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->ReadAheadStats.cPrefetches);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->ReadAheadStats.cbPrefetched);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->ReadAheadStats.cHits);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->ReadAheadStats.cMisses);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->ReadAheadStats.cbHit);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->ReadAheadStats.cbWasted);
+    }
 }
 
 
@@ -4402,13 +5043,22 @@ static DECLCALLBACK(void) drvvdResume(PPDMDRVINS pDrvIns)
                     else if (rc == VINF_VD_ASYNC_IO_FINISHED)
                         rc = VINF_SUCCESS;
                 }
+                else if (pIoReq->enmType == PDMMEDIAEXIOREQTYPE_WRITE_ZEROES)
+                {
+                    rc = drvvdMediaExIoReqWriteZeroesWrapper(pThis, pIoReq);
+                    if (rc == VERR_VD_ASYNC_IO_IN_PROGRESS)
+                        rc = VINF_PDM_MEDIAEX_IOREQ_IN_PROGRESS;
+                    else if (rc == VINF_VD_ASYNC_IO_FINISHED)
+                        rc = VINF_SUCCESS;
+                }
                 else
                     AssertMsgFailed(("Invalid request type %u\n", pIoReq->enmType));
 
                 /* The read write process will call the completion callback on its own. */
                 if (   rc != VINF_PDM_MEDIAEX_IOREQ_IN_PROGRESS
                     && (   pIoReq->enmType == PDMMEDIAEXIOREQTYPE_DISCARD
-                        || pIoReq->enmType == PDMMEDIAEXIOREQTYPE_FLUSH))
+                        || pIoReq->enmType == PDMMEDIAEXIOREQTYPE_FLUSH
+                        || pIoReq->enmType == PDMMEDIAEXIOREQTYPE_WRITE_ZEROES))
                 {
                     Assert(   (   pIoReq->enmType != PDMMEDIAEXIOREQTYPE_WRITE
                                && pIoReq->enmType != PDMMEDIAEXIOREQTYPE_READ)
@@ -4532,12 +5182,25 @@ static DECLCALLBACK(void) drvvdDestruct(PPDMDRVINS pDrvIns)
         HBDMgrDestroy(pThis->hHbdMgr);
     if (pThis->hIoReqCache != NIL_RTMEMCACHE)
         RTMemCacheDestroy(pThis->hIoReqCache);
+    if (pThis->pIoBufStats)
+    {
+        /* The statistics live in the I/O buffer manager, so they must go before it. */
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pIoBufStats->StatAllocs);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pIoBufStats->StatAllocFailures);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pIoBufStats->StatAllocPartial);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pIoBufStats->StatAllocOtherPool);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pIoBufStats->StatAllocSuspended);
+        PDMDrvHlpSTAMDeregister(pDrvIns, &pThis->pIoBufStats->StatPoolsLargePages);
+        pThis->pIoBufStats = NULL;
+    }
     if (pThis->hIoBufMgr != NIL_IOBUFMGR)
         IOBUFMgrDestroy(pThis->hIoBufMgr);
     if (RTCritSectIsInitialized(&pThis->CritSectIoReqsIoBufWait))
         RTCritSectDelete(&pThis->CritSectIoReqsIoBufWait);
     if (RTCritSectIsInitialized(&pThis->CritSectIoReqRedo))
         RTCritSectDelete(&pThis->CritSectIoReqRedo);
+    if (RTCritSectIsInitialized(&pThis->CritSectCoalesce))
+        RTCritSectDelete(&pThis->CritSectCoalesce);
     for (unsigned i = 0; i < RT_ELEMENTS(pThis->aIoReqAllocBins); i++)
         if (pThis->aIoReqAllocBins[i].hMtxLstIoReqAlloc != NIL_RTSEMFASTMUTEX)
             RTSemFastMutexDestroy(pThis->aIoReqAllocBins[i].hMtxLstIoReqAlloc);
@@ -4570,6 +5233,8 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
     char *pszFormat = NULL;      /* The format backed to use for this image. */
     char *pszCachePath = NULL;   /* The path to the cache image. */
     char *pszCacheFormat = NULL; /* The format backend to use for the cache image. */
+    char *pszCacheMode = NULL;   /* How the cache image is used for writes. */
+    uint64_t cbCache = 0;        /* Size of the cache image to create if it doesn't exist. */
     bool fReadOnly = false;      /* True if the media is read-only. */
     bool fMaybeReadOnly = false; /* True if the media may or may not be read-only. */
     bool fHonorZeroWrites = false; /* True if zero blocks should be written. */
@@ -4582,6 +5247,7 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
     pThis->fTempReadOnly                = false;
     pThis->pDisk                        = NULL;
     pThis->fAsyncIOSupported            = false;
+    pThis->fWriteFilters                = false;
     pThis->fShareable                   = false;
     pThis->fMergePending                = false;
     pThis->MergeCompleteMutex           = NIL_RTSEMFASTMUTEX;
@@ -4593,9 +5259,14 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
     pThis->pIfSecKey                    = NULL;
     pThis->hIoReqCache                  = NIL_RTMEMCACHE;
     pThis->hIoBufMgr                    = NIL_IOBUFMGR;
+    pThis->pIoBufStats                  = NULL;
     pThis->pRegionList                  = NULL;
     pThis->fSuspending                  = false;
     pThis->fRedo                        = false;
+    pThis->fCoalesce                    = false;
+    pThis->fCoalesceDispatching         = false;
+    pThis->cCoalesceIoInFlight          = 0;
+    pThis->offCoalesceHead              = 0;
 
     for (unsigned i = 0; i < RT_ELEMENTS(pThis->aIoReqAllocBins); i++)
         pThis->aIoReqAllocBins[i].hMtxLstIoReqAlloc = NIL_RTSEMFASTMUTEX;
@@ -4645,6 +5316,7 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
     pThis->IMediaEx.pfnIoReqWrite               = drvvdIoReqWrite;
     pThis->IMediaEx.pfnIoReqFlush               = drvvdIoReqFlush;
     pThis->IMediaEx.pfnIoReqDiscard             = drvvdIoReqDiscard;
+    pThis->IMediaEx.pfnIoReqWriteZeroes         = drvvdIoReqWriteZeroes;
     pThis->IMediaEx.pfnIoReqSendScsiCmd         = drvvdIoReqSendScsiCmd;
     pThis->IMediaEx.pfnIoReqGetActiveCount      = drvvdIoReqGetActiveCount;
     pThis->IMediaEx.pfnIoReqGetSuspendedCount   = drvvdIoReqGetSuspendedCount;
@@ -4695,11 +5367,15 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
         if (RT_SUCCESS(rc))
             rc = RTCritSectInit(&pThis->CritSectIoReqRedo);
 
+        if (RT_SUCCESS(rc))
+            rc = RTCritSectInit(&pThis->CritSectCoalesce);
+
         if (RT_FAILURE(rc))
             return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Creating Mutex failed"));
 
         RTListInit(&pThis->LstIoReqIoBufWait);
         RTListInit(&pThis->LstIoReqRedo);
+        RTListInit(&pThis->LstIoReqCoalesce);
     }
 
     /* Before we access any VD API load all given plugins. */
@@ -4721,6 +5397,12 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
     unsigned    iLevel = 0;
     PCFGMNODE   pCurNode = pCfg;
     uint32_t    cbIoBufMax = 0;
+    uint32_t    cIoBufPools = 1;
+    bool        fIoBufLargePages = false;
+    uint64_t    cbSharedReadCache = 0;
+    uint32_t    cbReadAhead = 0;
+    bool        fBackgroundStream = false;
+    uint64_t    cbBackgroundStreamRate = 0;
 
     for (;;)
     {
@@ -4734,11 +5416,13 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
                                                  "Format\0Path\0"
                                                  "ReadOnly\0MaybeReadOnly\0TempReadOnly\0Shareable\0HonorZeroWrites\0"
                                                  "HostIPStack\0UseNewIo\0BootAcceleration\0BootAccelerationBuffer\0"
-                                                 "SetupMerge\0MergeSource\0MergeTarget\0BwGroup\0Type\0BlockCache\0"
-                                                 "CachePath\0CacheFormat\0Discard\0InformAboutZeroBlocks\0"
+                                                 "SetupMerge\0MergeSource\0MergeTarget\0MergeRate\0BwGroup\0Type\0BlockCache\0"
+                                                 "CachePath\0CacheFormat\0CacheMode\0CacheSize\0Discard\0InformAboutZeroBlocks\0"
                                                  "SkipConsistencyChecks\0"
                                                  "Locked\0BIOSVisible\0Cylinders\0Heads\0Sectors\0Mountable\0"
-                                                 "EmptyDrive\0IoBufMax\0NonRotationalMedium\0"
+                                                 "EmptyDrive\0IoBufMax\0IoBufPools\0IoBufLargePages\0NonRotationalMedium\0SharedReadCacheSize\0"
+                                                 "ReadAheadSize\0BackgroundStream\0BackgroundStreamRate\0"
+                                                 "CoalesceRequests\0CoalesceQueueDepth\0CoalesceMaxSize\0"
 #if defined(VBOX_PERIODIC_FLUSH) || defined(VBOX_IGNORE_FLUSH)
                                                  "FlushInterval\0IgnoreFlush\0IgnoreFlushAsync\0"
 #endif /* !(VBOX_PERIODIC_FLUSH || VBOX_IGNORE_FLUSH) */
@@ -4828,6 +5512,13 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
                                       N_("DrvVD: Configuration error: Querying \"SetupMerge\" as boolean failed"));
                 break;
             }
+            rc = pHlp->pfnCFGMQueryU64Def(pCurNode, "MergeRate", &pThis->cbMergeRate, 0);
+            if (RT_FAILURE(rc))
+            {
+                rc = PDMDRV_SET_ERROR(pDrvIns, rc,
+                                      N_("DrvVD: Configuration error: Querying \"MergeRate\" as integer failed"));
+                break;
+            }
             if (fReadOnly && pThis->fMergePending)
             {
                 rc = PDMDRV_SET_ERROR(pDrvIns, VERR_PDM_DRIVER_INVALID_PROPERTIES,
@@ -4855,6 +5546,40 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
                                       N_("DrvVD: Configuration error: Querying \"BlockCache\" as boolean failed"));
                 break;
             }
+            rc = pHlp->pfnCFGMQueryU64Def(pCurNode, "SharedReadCacheSize", &cbSharedReadCache, 0);
+            if (RT_FAILURE(rc))
+            {
+                rc = PDMDRV_SET_ERROR(pDrvIns, rc,
+                                      N_("DrvVD: Configuration error: Querying \"SharedReadCacheSize\" as integer failed"));
+                break;
+            }
+            rc = pHlp->pfnCFGMQueryU32Def(pCurNode, "ReadAheadSize", &cbReadAhead, 0);
+            if (RT_FAILURE(rc))
+            {
+                rc = PDMDRV_SET_ERROR(pDrvIns, rc,
+                                      N_("DrvVD: Configuration error: Querying \"ReadAheadSize\" as integer failed"));
+                break;
+            }
+            if (cbReadAhead && (cbReadAhead < _64K || cbReadAhead > _16M))
+            {
+                rc = PDMDrvHlpVMSetError(pDrvIns, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                                         N_("DrvVD: Configuration error: \"ReadAheadSize\" must be between 64KiB and 16MiB"));
+                break;
+            }
+            rc = pHlp->pfnCFGMQueryBoolDef(pCurNode, "BackgroundStream", &fBackgroundStream, false);
+            if (RT_FAILURE(rc))
+            {
+                rc = PDMDRV_SET_ERROR(pDrvIns, rc,
+                                      N_("DrvVD: Configuration error: Querying \"BackgroundStream\" as boolean failed"));
+                break;
+            }
+            rc = pHlp->pfnCFGMQueryU64Def(pCurNode, "BackgroundStreamRate", &cbBackgroundStreamRate, 0);
+            if (RT_FAILURE(rc))
+            {
+                rc = PDMDRV_SET_ERROR(pDrvIns, rc,
+                                      N_("DrvVD: Configuration error: Querying \"BackgroundStreamRate\" as integer failed"));
+                break;
+            }
             rc = pHlp->pfnCFGMQueryStringAlloc(pCurNode, "BwGroup", &pThis->pszBwGroup);
             if (RT_FAILURE(rc) && rc != VERR_CFGM_VALUE_NOT_FOUND)
             {
@@ -4924,6 +5649,29 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
                                           N_("DrvVD: Configuration error: Querying \"CacheFormat\" as string failed"));
                     break;
                 }
+
+                rc = pHlp->pfnCFGMQueryStringAllocDef(pCurNode, "CacheMode", &pszCacheMode, "writethrough");
+                if (RT_FAILURE(rc))
+                {
+                    rc = PDMDRV_SET_ERROR(pDrvIns, rc,
+                                          N_("DrvVD: Configuration error: Querying \"CacheMode\" as string failed"));
+                    break;
+                }
+                if (   RTStrICmp(pszCacheMode, "writethrough")
+                    && RTStrICmp(pszCacheMode, "writeback"))
+                {
+                    rc = PDMDrvHlpVMSetError(pDrvIns, VERR_PDM_DRVINS_UNKNOWN_CFG_VALUES, RT_SRC_POS,
+                                             N_("DrvVD: Configuration error: Unknown cache mode \"%s\""), pszCacheMode);
+                    break;
+                }
+
+                rc = pHlp->pfnCFGMQueryU64Def(pCurNode, "CacheSize", &cbCache, 0);
+                if (RT_FAILURE(rc))
+                {
+                    rc = PDMDRV_SET_ERROR(pDrvIns, rc,
+                                          N_("DrvVD: Configuration error: Querying \"CacheSize\" as integer failed"));
+                    break;
+                }
             }
 
             /* Mountable */
@@ -5012,10 +5760,40 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
             if (RT_FAILURE(rc))
                 return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Failed to query \"IoBufMax\" from the config"));
 
+            rc = pHlp->pfnCFGMQueryU32Def(pCfg, "IoBufPools", &cIoBufPools, 1);
+            if (RT_FAILURE(rc))
+                return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Failed to query \"IoBufPools\" from the config"));
+            if (!cIoBufPools || cIoBufPools > IOBUFMGR_POOLS_MAX)
+                return PDMDrvHlpVMSetError(pDrvIns, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                                           N_("DrvVD configuration error: \"IoBufPools\" must be between 1 and %u"),
+                                           IOBUFMGR_POOLS_MAX);
+
+            rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "IoBufLargePages", &fIoBufLargePages, false);
+            if (RT_FAILURE(rc))
+                return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Failed to query \"IoBufLargePages\" from the config"));
+
             rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "NonRotationalMedium", &pThis->fNonRotational, false);
             if (RT_FAILURE(rc))
                 return PDMDRV_SET_ERROR(pDrvIns, rc,
                                         N_("DrvVD configuration error: Querying \"NonRotationalMedium\" as boolean failed"));
+
+            rc = pHlp->pfnCFGMQueryBoolDef(pCfg, "CoalesceRequests", &pThis->fCoalesce, true);
+            if (RT_FAILURE(rc))
+                return PDMDRV_SET_ERROR(pDrvIns, rc,
+                                        N_("DrvVD configuration error: Querying \"CoalesceRequests\" as boolean failed"));
+
+            rc = pHlp->pfnCFGMQueryU32Def(pCfg, "CoalesceQueueDepth", &pThis->cCoalesceQueueDepth, 8);
+            if (RT_FAILURE(rc))
+                return PDMDRV_SET_ERROR(pDrvIns, rc,
+                                        N_("DrvVD configuration error: Querying \"CoalesceQueueDepth\" as integer failed"));
+            if (!pThis->cCoalesceQueueDepth)
+                return PDMDrvHlpVMSetError(pDrvIns, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                                           N_("DrvVD configuration error: \"CoalesceQueueDepth\" must not be 0"));
+
+            rc = pHlp->pfnCFGMQueryU32Def(pCfg, "CoalesceMaxSize", &pThis->cbCoalesceMax, _512K);
+            if (RT_FAILURE(rc))
+                return PDMDRV_SET_ERROR(pDrvIns, rc,
+                                        N_("DrvVD configuration error: Querying \"CoalesceMaxSize\" as integer failed"));
         }
 
         PCFGMNODE pParent = pHlp->pfnCFGMGetChild(pCurNode, "Parent");
@@ -5026,7 +5804,15 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
     }
 
     if (pThis->pDrvMediaExPort)
-        rc = IOBUFMgrCreate(&pThis->hIoBufMgr, cbIoBufMax, pThis->CfgCrypto.pCfgNode ? IOBUFMGR_F_REQUIRE_NOT_PAGABLE : IOBUFMGR_F_DEFAULT);
+    {
+        /* Sensitive data must not end up in swap, large pages aren't supported for this. */
+        uint32_t fIoBufFlags = IOBUFMGR_F_DEFAULT;
+        if (pThis->CfgCrypto.pCfgNode)
+            fIoBufFlags |= IOBUFMGR_F_REQUIRE_NOT_PAGABLE;
+        else if (fIoBufLargePages)
+            fIoBufFlags |= IOBUFMGR_F_LARGE_PAGES;
+        rc = IOBUFMgrCreateEx(&pThis->hIoBufMgr, cbIoBufMax, cIoBufPools, fIoBufFlags);
+    }
 
     if (   !fEmptyDrive
         && RT_SUCCESS(rc))
@@ -5078,6 +5864,19 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
             {
                 rc = VDCreate(pThis->pVDIfsDisk, drvvdGetVDFromMediaType(pThis->enmType), &pThis->pDisk);
                 /* Error message is already set correctly. */
+                if (RT_SUCCESS(rc) && cbSharedReadCache)
+                    rc = VDSetSharedReadCache(pThis->pDisk, cbSharedReadCache);
+                if (RT_SUCCESS(rc) && cbReadAhead)
+                {
+                    rc = VDSetReadAhead(pThis->pDisk, cbReadAhead, &pThis->ReadAheadStats);
+                    if (RT_SUCCESS(rc))
+                        pThis->fReadAhead = true;
+                    else if (rc == VERR_NOT_SUPPORTED)
+                    {
+                        LogRel(("VD#%u: Read-ahead is not available for disks set up for merging\n", pDrvIns->iInstance));
+                        rc = VINF_SUCCESS;
+                    }
+                }
             }
         }
 
@@ -5382,15 +6181,43 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
                 AssertRC(rc);
             }
 
-            rc = VDCacheOpen(pThis->pDisk, pszCacheFormat, pszCachePath, VD_OPEN_FLAGS_NORMAL, pThis->pVDIfsCache);
+            /* With a size given the cache image is created when missing or stale. */
+            if (   cbCache
+                && !RTFileExists(pszCachePath))
+                rc = VERR_FILE_NOT_FOUND;
+            else
+                rc = VDCacheOpen(pThis->pDisk, pszCacheFormat, pszCachePath, VD_OPEN_FLAGS_NORMAL, pThis->pVDIfsCache);
+            if (   cbCache
+                && (   rc == VERR_FILE_NOT_FOUND
+                    || rc == VERR_VD_CACHE_NOT_UP_TO_DATE))
+            {
+                if (rc == VERR_VD_CACHE_NOT_UP_TO_DATE)
+                {
+                    LogRel(("VD#%u: Cache image '%s' is out of date, recreating it\n", pThis->pDrvIns->iInstance, pszCachePath));
+                    RTFileDelete(pszCachePath);
+                }
+                rc = VDCreateCache(pThis->pDisk, pszCacheFormat, pszCachePath, cbCache, VD_IMAGE_FLAGS_NONE,
+                                   NULL /* pszComment */, NULL /* pUuid */, VD_OPEN_FLAGS_NORMAL,
+                                   pThis->pVDIfsCache, NULL /* pVDIfsOperation */);
+            }
             if (RT_FAILURE(rc))
                 rc = PDMDRV_SET_ERROR(pDrvIns, rc, N_("DrvVD: Could not open cache image"));
+
+            if (   RT_SUCCESS(rc)
+                && !RTStrICmp(pszCacheMode, "writeback"))
+            {
+                rc = VDCacheSetMode(pThis->pDisk, VDCACHEMODE_WRITE_BACK);
+                if (RT_FAILURE(rc))
+                    rc = PDMDRV_SET_ERROR(pDrvIns, rc, N_("DrvVD: Could not switch the cache image to write-back mode"));
+            }
         }
 
         if (RT_VALID_PTR(pszCachePath))
             PDMDrvHlpMMHeapFree(pDrvIns, pszCachePath);
         if (RT_VALID_PTR(pszCacheFormat))
             PDMDrvHlpMMHeapFree(pDrvIns, pszCacheFormat);
+        if (RT_VALID_PTR(pszCacheMode))
+            PDMDrvHlpMMHeapFree(pDrvIns, pszCacheMode);
 
         if (   RT_SUCCESS(rc)
             && pThis->fMergePending
@@ -5401,6 +6228,24 @@ static DECLCALLBACK(int) drvvdConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint
                                   N_("DrvVD: Configuration error: Inconsistent image merge data"));
         }
 
+        /* Flatten the image chain in the background, not fatal if it can't be started. */
+        if (   RT_SUCCESS(rc)
+            && fBackgroundStream)
+        {
+            if (fReadOnly || pThis->fMergePending)
+                LogRel(("VD#%u: Background streaming is not available for read-only disks or disks set up for merging\n",
+                        pDrvIns->iInstance));
+            else
+            {
+                int rc2 = VDStreamStart(pThis->pDisk, cbBackgroundStreamRate, drvvdStreamComplete, pThis);
+                if (RT_SUCCESS(rc2))
+                    LogRel(("VD#%u: Streaming the parent images into the last image in the background (%RU64 bytes/s max)\n",
+                            pDrvIns->iInstance, cbBackgroundStreamRate));
+                else
+                    LogRel(("VD#%u: Failed to start background streaming: %Rrc\n", pDrvIns->iInstance, rc2));
+            }
+        }
+
         /* Create the block cache if enabled. */
         if (   fUseBlockCache
             && !pThis->fShareable
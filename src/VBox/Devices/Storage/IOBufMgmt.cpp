@@ -32,10 +32,21 @@
 #include <iprt/critsect.h>
 #include <iprt/mem.h>
 #include <iprt/memsafer.h>
+#include <iprt/mp.h>
 #include <iprt/sg.h>
 #include <iprt/string.h>
 #include <iprt/asm.h>
 
+#ifdef RT_OS_LINUX
+# include <sys/mman.h>
+# ifndef MAP_HUGETLB
+#  define MAP_HUGETLB   0x40000
+# endif
+# ifndef MADV_HUGEPAGE
+#  define MADV_HUGEPAGE 14
+# endif
+#endif
+
 /** Set to verify the allocations for distinct memory areas. */
 //#define IOBUFMGR_VERIFY_ALLOCATIONS 1
 
@@ -46,6 +57,8 @@
 
 /** Pointer to the internal I/O buffer manager data. */
 typedef struct IOBUFMGRINT *PIOBUFMGRINT;
+/** Pointer to a I/O buffer manager sub-pool. */
+typedef struct IOBUFMGRPOOL *PIOBUFMGRPOOL;
 
 /**
  * Internal I/O buffer descriptor data.
@@ -53,13 +66,17 @@ typedef struct IOBUFMGRINT *PIOBUFMGRINT;
 typedef struct IOBUFDESCINT
 {
     /** Data segments. */
-    RTSGSEG      aSegs[10];
+    RTSGSEG       aSegs[10];
     /** Data segments used for the current allocation. */
-    unsigned     cSegsUsed;
-    /** Pointer to I/O buffer manager. */
-    PIOBUFMGRINT pIoBufMgr;
+    unsigned      cSegsUsed;
+    /** Pointer to the I/O buffer manager sub-pool the memory was allocated from. */
+    PIOBUFMGRPOOL pPool;
 } IOBUFDESCINT;
 
+/* Must be included after IOBUFDESCINT was defined. */
+#define IOBUFDESCINT_DECLARED
+#include "IOBufMgmt.h"
+
 /**
  * A
  */
@@ -73,42 +90,59 @@ typedef struct IOBUFMGRBIN
 typedef IOBUFMGRBIN *PIOBUFMGRBIN;
 
 /**
- * Internal I/O buffer manager data.
+ * I/O buffer manager sub-pool.
  */
-typedef struct IOBUFMGRINT
+typedef struct IOBUFMGRPOOL
 {
     /** Critical section protecting the allocation path. */
     RTCRITSECT          CritSectAlloc;
-    /** Flags the manager was created with. */
-    uint32_t            fFlags;
-    /** Maximum size of I/O memory to allocate. */
+    /** Pointer to the owning I/O buffer manager. */
+    PIOBUFMGRINT        pIoBufMgr;
+    /** Size of I/O memory in this pool. */
     size_t              cbMax;
     /** Amount of free memory. */
     size_t              cbFree;
-    /** The order of smallest bin. */
-    uint32_t            u32OrderMin;
-    /** The order of largest bin. */
-    uint32_t            u32OrderMax;
     /** Pointer to the base memory of the allocation. */
     void               *pvMem;
+    /** Size of the memory allocation (might be larger than cbMax). */
+    size_t              cbMem;
     /** Number of bins for free objects. */
     uint32_t            cBins;
     /** Flag whether allocation is on hold waiting for everything to be free
      * to be able to defragment the memory. */
     bool                fAllocSuspended;
+    /** Flag whether the memory was mapped directly (Linux only). */
+    bool                fMapped;
     /** Array of bins. */
     PIOBUFMGRBIN        paBins;
+    /** Array of pointer entries for the various bins. */
+    void              **papvObj;
 #ifdef IOBUFMGR_VERIFY_ALLOCATIONS
     /** Pointer to the object state (allocated/free) bitmap. */
     void                *pbmObjState;
 #endif
-    /** Array of pointer entries for the various bins - variable in size. */
-    void               *apvObj[1];
-} IOBUFMGRINT;
+} IOBUFMGRPOOL;
 
-/* Must be included after IOBUFDESCINT was defined. */
-#define IOBUFDESCINT_DECLARED
-#include "IOBufMgmt.h"
+/**
+ * Internal I/O buffer manager data.
+ */
+typedef struct IOBUFMGRINT
+{
+    /** Flags the manager was created with. */
+    uint32_t            fFlags;
+    /** Number of sub-pools. */
+    uint32_t            cPools;
+    /** Maximum size of I/O memory to allocate. */
+    size_t              cbMax;
+    /** The order of smallest bin. */
+    uint32_t            u32OrderMin;
+    /** The order of largest bin. */
+    uint32_t            u32OrderMax;
+    /** Statistics. */
+    IOBUFMGRSTATS       Stats;
+    /** The sub-pools - variable in size. */
+    IOBUFMGRPOOL        aPools[1];
+} IOBUFMGRINT;
 
 /**
  * Gets the number of bins required between the given minimum and maximum size
@@ -173,57 +207,62 @@ DECLINLINE(void *) iobufMgrBinObjRemove(PIOBUFMGRBIN pBin)
 }
 
 /**
- * Resets the bins to factory default (memory resigin in the largest bin).
+ * Resets the bins to factory default (memory resigin in the largest bin, the
+ * remainder is spread over the smaller bins).
  *
- * @param   pThis       The I/O buffer manager instance.
+ * @param   pPool       The I/O buffer manager sub-pool.
  */
-static void iobufMgrResetBins(PIOBUFMGRINT pThis)
+static void iobufMgrResetBins(PIOBUFMGRPOOL pPool)
 {
     /* Init the bins. */
-    size_t   cbMax = pThis->cbMax;
-    size_t   iObj  = 0;
-    uint32_t cbBin = IOBUFMGR_BIN_SIZE_MIN;
-    for (unsigned i = 0; i < pThis->cBins; i++)
+    size_t   cbMax    = pPool->cbMax;
+    size_t   iObj     = 0;
+    uint32_t cbBin    = IOBUFMGR_BIN_SIZE_MIN;
+    unsigned iBinLast = 0;
+    for (unsigned i = 0; i < pPool->cBins; i++)
     {
-        PIOBUFMGRBIN pBin = &pThis->paBins[i];
+        PIOBUFMGRBIN pBin = &pPool->paBins[i];
         pBin->iFree = 0;
-        pBin->papvFree = &pThis->apvObj[iObj];
+        pBin->papvFree = &pPool->papvObj[iObj];
         iObj += cbMax / cbBin;
+        iBinLast = i;
 
-        /* Init the biggest possible bin with the free objects. */
-        if (   (cbBin << 1) > cbMax
-            || i == pThis->cBins - 1)
-        {
-            uint8_t *pbMem = (uint8_t *)pThis->pvMem;
-            while (cbMax)
-            {
-                iobufMgrBinObjAdd(pBin, pbMem);
-                cbMax -= cbBin;
-                pbMem += cbBin;
-
-                if (cbMax < cbBin) /** @todo Populate smaller bins and don't waste memory. */
-                    break;
-            }
-
-            /* Limit the number of available bins. */
-            pThis->cBins = i + 1;
+        if ((cbBin << 1) > cbMax)
             break;
-        }
 
         cbBin <<= 1;
     }
+
+    /* Limit the number of available bins. */
+    pPool->cBins = iBinLast + 1;
+
+    /* Populate the biggest possible bin with the free objects and put what is left into the smaller ones. */
+    uint8_t *pbMem  = (uint8_t *)pPool->pvMem;
+    size_t   cbLeft = cbMax;
+    for (int i = (int)iBinLast; i >= 0; i--)
+    {
+        size_t const cbObj = RT_BIT_Z(i + pPool->pIoBufMgr->u32OrderMin);
+        while (cbLeft >= cbObj)
+        {
+            iobufMgrBinObjAdd(&pPool->paBins[i], pbMem);
+            cbLeft -= cbObj;
+            pbMem  += cbObj;
+        }
+    }
+    Assert(!cbLeft);
 }
 
 /**
  * Allocate one segment from the manager.
  *
  * @returns Number of bytes allocated, 0 if there is no free memory.
- * @param   pThis       The I/O buffer manager instance.
+ * @param   pPool       The I/O buffer manager sub-pool.
  * @param   pSeg        The segment to fill in on success.
  * @param   cb          Maximum number of bytes to allocate.
  */
-static size_t iobufMgrAllocSegment(PIOBUFMGRINT pThis, PRTSGSEG pSeg, size_t cb)
+static size_t iobufMgrAllocSegment(PIOBUFMGRPOOL pPool, PRTSGSEG pSeg, size_t cb)
 {
+    PIOBUFMGRINT pThis = pPool->pIoBufMgr;
     size_t cbAlloc = 0;
 
     /* Round to the next power of two and get the bin to try first. */
@@ -231,27 +270,27 @@ static size_t iobufMgrAllocSegment(PIOBUFMGRINT pThis, PRTSGSEG pSeg, size_t cb)
     if (cb & (RT_BIT_32(u32Order) - 1))
         u32Order++;
 
-    u32Order = RT_CLAMP(u32Order, pThis->u32OrderMin, pThis->u32OrderMax);
+    u32Order = RT_CLAMP(u32Order, pThis->u32OrderMin, pThis->u32OrderMin + pPool->cBins - 1);
     unsigned iBin = u32Order - pThis->u32OrderMin;
 
     /*
      * Check whether the bin can satisfy the request. If not try the next bigger
      * bin and so on. If there is nothing to find try the smaller bins.
      */
-    Assert(iBin < pThis->cBins);
+    Assert(iBin < pPool->cBins);
 
-    PIOBUFMGRBIN pBin = &pThis->paBins[iBin];
+    PIOBUFMGRBIN pBin = &pPool->paBins[iBin];
     /* Reset the bins if there is nothing in the current one but all the memory is marked as free. */
-    if (   pThis->cbFree == pThis->cbMax
+    if (   pPool->cbFree == pPool->cbMax
         && pBin->iFree == 0)
-        iobufMgrResetBins(pThis);
+        iobufMgrResetBins(pPool);
 
     if (pBin->iFree == 0)
     {
         unsigned iBinCur = iBin;
-        PIOBUFMGRBIN pBinCur = &pThis->paBins[iBinCur];
+        PIOBUFMGRBIN pBinCur = &pPool->paBins[iBinCur];
 
-        while (iBinCur < pThis->cBins)
+        while (iBinCur < pPool->cBins)
         {
             if (pBinCur->iFree != 0)
             {
@@ -262,7 +301,7 @@ static size_t iobufMgrAllocSegment(PIOBUFMGRINT pThis, PRTSGSEG pSeg, size_t cb)
                 while (iBinCur > iBin)
                 {
                     iBinCur--;
-                    pBinCur = &pThis->paBins[iBinCur];
+                    pBinCur = &pPool->paBins[iBinCur];
                     iobufMgrBinObjAdd(pBinCur, pbMem + RT_BIT_Z(iBinCur + pThis->u32OrderMin));
                 }
 
@@ -284,12 +323,14 @@ static size_t iobufMgrAllocSegment(PIOBUFMGRINT pThis, PRTSGSEG pSeg, size_t cb)
         && iBin > 0)
     {
 #if 1
-        pThis->fAllocSuspended = true;
+        if (!pPool->fAllocSuspended)
+            STAM_REL_COUNTER_INC(&pThis->Stats.StatAllocSuspended);
+        pPool->fAllocSuspended = true;
 #else
         do
         {
             iBin--;
-            pBin = &pThis->paBins[iBin];
+            pBin = &pPool->paBins[iBin];
 
             if (pBin->iFree != 0)
             {
@@ -311,17 +352,17 @@ static size_t iobufMgrAllocSegment(PIOBUFMGRINT pThis, PRTSGSEG pSeg, size_t cb)
         cbAlloc = pSeg->cbSeg;
         AssertPtr(pSeg->pvSeg);
 
-        pThis->cbFree -= cbAlloc;
+        pPool->cbFree -= cbAlloc;
 
 #ifdef IOBUFMGR_VERIFY_ALLOCATIONS
         /* Mark the objects as allocated. */
-        uint32_t iBinStart = ((uintptr_t)pSeg->pvSeg - (uintptr_t)pThis->pvMem) / IOBUFMGR_BIN_SIZE_MIN;
-        Assert(   !(((uintptr_t)pSeg->pvSeg - (uintptr_t)pThis->pvMem) % IOBUFMGR_BIN_SIZE_MIN)
+        uint32_t iBinStart = ((uintptr_t)pSeg->pvSeg - (uintptr_t)pPool->pvMem) / IOBUFMGR_BIN_SIZE_MIN;
+        Assert(   !(((uintptr_t)pSeg->pvSeg - (uintptr_t)pPool->pvMem) % IOBUFMGR_BIN_SIZE_MIN)
                && !(pSeg->cbSeg % IOBUFMGR_BIN_SIZE_MIN));
         uint32_t iBinEnd = iBinStart + (pSeg->cbSeg / IOBUFMGR_BIN_SIZE_MIN);
         while (iBinStart < iBinEnd)
         {
-            bool fState = ASMBitTestAndSet(pThis->pbmObjState, iBinStart);
+            bool fState = ASMBitTestAndSet(pPool->pbmObjState, iBinStart);
             //LogFlowFunc(("iBinStart=%u fState=%RTbool -> true\n", iBinStart, fState));
             AssertMsg(!fState, ("Trying to allocate an already allocated object\n"));
             iBinStart++;
@@ -332,117 +373,182 @@ static size_t iobufMgrAllocSegment(PIOBUFMGRINT pThis, PRTSGSEG pSeg, size_t cb)
     return cbAlloc;
 }
 
-DECLHIDDEN(int) IOBUFMgrCreate(PIOBUFMGR phIoBufMgr, size_t cbMax, uint32_t fFlags)
+/**
+ * Allocates the memory backing the given sub-pool.
+ *
+ * On Linux hosts the memory is mapped directly so it isn't touched before it is
+ * used for the first time (the kernel hands out zeroed pages), which places it on
+ * the NUMA node of the first thread using it.
+ *
+ * @returns VBox status code.
+ * @param   pThis       The I/O buffer manager instance.
+ * @param   pPool       The sub-pool to allocate the memory for.
+ */
+static int iobufMgrPoolMemAlloc(PIOBUFMGRINT pThis, PIOBUFMGRPOOL pPool)
 {
-    int rc = VINF_SUCCESS;
+    pPool->cbMem = pPool->cbMax;
 
-    AssertPtrReturn(phIoBufMgr, VERR_INVALID_POINTER);
-    AssertReturn(cbMax, VERR_NOT_IMPLEMENTED);
+    if (pThis->fFlags & IOBUFMGR_F_REQUIRE_NOT_PAGABLE)
+        return RTMemSaferAllocZEx(&pPool->pvMem, pPool->cbMem, RTMEMSAFER_F_REQUIRE_NOT_PAGABLE);
 
-    /* Allocate the basic structure in one go. */
-    unsigned cBins = iobufMgrGetBinCount(IOBUFMGR_BIN_SIZE_MIN, IOBUFMGR_BIN_SIZE_MAX);
-    uint32_t cObjs = iobufMgrGetObjCount(cbMax, cBins, IOBUFMGR_BIN_SIZE_MIN);
-    PIOBUFMGRINT pThis = (PIOBUFMGRINT)RTMemAllocZ(RT_UOFFSETOF_DYN(IOBUFMGRINT, apvObj[cObjs]) + cBins * sizeof(IOBUFMGRBIN));
-    if (RT_LIKELY(pThis))
+#ifdef RT_OS_LINUX
+    if (pThis->fFlags & IOBUFMGR_F_LARGE_PAGES)
     {
-        pThis->fFlags          = fFlags;
-        pThis->cbMax           = cbMax;
-        pThis->cbFree          = cbMax;
-        pThis->cBins           = cBins;
-        pThis->fAllocSuspended = false;
-        pThis->u32OrderMin     = ASMBitLastSetU32(IOBUFMGR_BIN_SIZE_MIN) - 1;
-        pThis->u32OrderMax     = ASMBitLastSetU32(IOBUFMGR_BIN_SIZE_MAX) - 1;
-        pThis->paBins = (PIOBUFMGRBIN)((uint8_t *)pThis + RT_UOFFSETOF_DYN(IOBUFMGRINT, apvObj[cObjs]));
-
-#ifdef IOBUFMGR_VERIFY_ALLOCATIONS
-        pThis->pbmObjState = RTMemAllocZ((cbMax / IOBUFMGR_BIN_SIZE_MIN / 8) + 1);
-        if (!pThis->pbmObjState)
-            rc = VERR_NO_MEMORY;
-#endif
-
-        if (RT_SUCCESS(rc))
-            rc = RTCritSectInit(&pThis->CritSectAlloc);
-        if (RT_SUCCESS(rc))
+        /* Try hugetlbfs pages first, then transparent huge pages on a 2MB aligned mapping. */
+        size_t const cbMap = RT_ALIGN_Z(pPool->cbMax, _2M);
+        void *pv = mmap(NULL, cbMap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (pv != MAP_FAILED)
         {
-            if (pThis->fFlags & IOBUFMGR_F_REQUIRE_NOT_PAGABLE)
-                rc = RTMemSaferAllocZEx(&pThis->pvMem, RT_ALIGN_Z(pThis->cbMax, _4K),
-                                        RTMEMSAFER_F_REQUIRE_NOT_PAGABLE);
-            else
-                pThis->pvMem = RTMemPageAllocZ(RT_ALIGN_Z(pThis->cbMax, _4K));
-
-            if (   RT_LIKELY(pThis->pvMem)
-                && RT_SUCCESS(rc))
-            {
-                iobufMgrResetBins(pThis);
-
-                *phIoBufMgr = pThis;
-                return VINF_SUCCESS;
-            }
-            else
-                rc = VERR_NO_MEMORY;
-
-            RTCritSectDelete(&pThis->CritSectAlloc);
+            STAM_REL_COUNTER_INC(&pThis->Stats.StatPoolsLargePages);
+            pPool->pvMem   = pv;
+            pPool->cbMem   = cbMap;
+            pPool->fMapped = true;
+            return VINF_SUCCESS;
         }
 
-        RTMemFree(pThis);
+        pv = mmap(NULL, cbMap + _2M, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pv != MAP_FAILED)
+        {
+            uint8_t *pbAligned = (uint8_t *)RT_ALIGN_P(pv, _2M);
+            size_t const cbHead = (uintptr_t)pbAligned - (uintptr_t)pv;
+            if (cbHead)
+                munmap(pv, cbHead);
+            if (_2M - cbHead)
+                munmap(pbAligned + cbMap, _2M - cbHead);
+            madvise(pbAligned, cbMap, MADV_HUGEPAGE); /* Best effort. */
+
+            pPool->pvMem   = pbAligned;
+            pPool->cbMem   = cbMap;
+            pPool->fMapped = true;
+            return VINF_SUCCESS;
+        }
     }
     else
-        rc = VERR_NO_MEMORY;
+    {
+        void *pv = mmap(NULL, pPool->cbMem, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pv != MAP_FAILED)
+        {
+            pPool->pvMem   = pv;
+            pPool->fMapped = true;
+            return VINF_SUCCESS;
+        }
+    }
+#endif
 
-    return rc;
+    pPool->pvMem = RTMemPageAllocZ(pPool->cbMem);
+    return pPool->pvMem ? VINF_SUCCESS : VERR_NO_MEMORY;
 }
 
-DECLHIDDEN(int) IOBUFMgrDestroy(IOBUFMGR hIoBufMgr)
+/**
+ * Frees the memory backing the given sub-pool.
+ *
+ * @param   pThis       The I/O buffer manager instance.
+ * @param   pPool       The sub-pool to free the memory for.
+ */
+static void iobufMgrPoolMemFree(PIOBUFMGRINT pThis, PIOBUFMGRPOOL pPool)
 {
-    PIOBUFMGRINT pThis = hIoBufMgr;
+    if (!pPool->pvMem)
+        return;
+
+    if (pThis->fFlags & IOBUFMGR_F_REQUIRE_NOT_PAGABLE)
+        RTMemSaferFree(pPool->pvMem, pPool->cbMem);
+#ifdef RT_OS_LINUX
+    else if (pPool->fMapped)
+        munmap(pPool->pvMem, pPool->cbMem);
+#endif
+    else
+        RTMemPageFree(pPool->pvMem, pPool->cbMem);
+    pPool->pvMem = NULL;
+}
 
-    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+/**
+ * Destroys the given sub-pool, freeing all resources.
+ *
+ * @param   pThis       The I/O buffer manager instance.
+ * @param   pPool       The sub-pool to destroy.
+ */
+static void iobufMgrPoolDestroy(PIOBUFMGRINT pThis, PIOBUFMGRPOOL pPool)
+{
+    iobufMgrPoolMemFree(pThis, pPool);
 
-    int rc = RTCritSectEnter(&pThis->CritSectAlloc);
-    if (RT_SUCCESS(rc))
+#ifdef IOBUFMGR_VERIFY_ALLOCATIONS
+    if (pPool->pbmObjState)
     {
-        if (pThis->cbFree == pThis->cbMax)
-        {
-            if (pThis->fFlags & IOBUFMGR_F_REQUIRE_NOT_PAGABLE)
-                RTMemSaferFree(pThis->pvMem, RT_ALIGN_Z(pThis->cbMax, _4K));
-            else
-                RTMemPageFree(pThis->pvMem, RT_ALIGN_Z(pThis->cbMax, _4K));
+        RTMemFree(pPool->pbmObjState);
+        pPool->pbmObjState = NULL;
+    }
+#endif
+
+    if (RTCritSectIsInitialized(&pPool->CritSectAlloc))
+        RTCritSectDelete(&pPool->CritSectAlloc);
+    if (pPool->paBins)
+    {
+        RTMemFree(pPool->paBins);
+        pPool->paBins  = NULL;
+        pPool->papvObj = NULL;
+    }
+}
+
+/**
+ * Initializes the given sub-pool.
+ *
+ * @returns VBox status code.
+ * @param   pThis       The I/O buffer manager instance.
+ * @param   pPool       The sub-pool to initialize.
+ * @param   cbPool      Size of the I/O memory in the pool.
+ */
+static int iobufMgrPoolInit(PIOBUFMGRINT pThis, PIOBUFMGRPOOL pPool, size_t cbPool)
+{
+    unsigned cBins = iobufMgrGetBinCount(IOBUFMGR_BIN_SIZE_MIN, IOBUFMGR_BIN_SIZE_MAX);
+    uint32_t cObjs = iobufMgrGetObjCount(cbPool, cBins, IOBUFMGR_BIN_SIZE_MIN);
+
+    pPool->pIoBufMgr       = pThis;
+    pPool->cbMax           = cbPool;
+    pPool->cbFree          = cbPool;
+    pPool->cBins           = cBins;
+    pPool->fAllocSuspended = false;
+    pPool->fMapped         = false;
+
+    /* Allocate the bins and the object array in one go. */
+    pPool->paBins = (PIOBUFMGRBIN)RTMemAllocZ(cBins * sizeof(IOBUFMGRBIN) + cObjs * sizeof(void *));
+    if (RT_UNLIKELY(!pPool->paBins))
+        return VERR_NO_MEMORY;
+    pPool->papvObj = (void **)&pPool->paBins[cBins];
 
 #ifdef IOBUFMGR_VERIFY_ALLOCATIONS
-            AssertPtr(pThis->pbmObjState);
-            RTMemFree(pThis->pbmObjState);
-            pThis->pbmObjState = NULL;
+    pPool->pbmObjState = RTMemAllocZ((cbPool / IOBUFMGR_BIN_SIZE_MIN / 8) + 1);
+    if (!pPool->pbmObjState)
+        return VERR_NO_MEMORY;
 #endif
 
-            RTCritSectLeave(&pThis->CritSectAlloc);
-            RTCritSectDelete(&pThis->CritSectAlloc);
-            RTMemFree(pThis);
-        }
-        else
-        {
-            rc = VERR_INVALID_STATE;
-            RTCritSectLeave(&pThis->CritSectAlloc);
-        }
+    int rc = RTCritSectInit(&pPool->CritSectAlloc);
+    if (RT_SUCCESS(rc))
+    {
+        rc = iobufMgrPoolMemAlloc(pThis, pPool);
+        if (RT_SUCCESS(rc))
+            iobufMgrResetBins(pPool);
     }
 
     return rc;
 }
 
-DECLHIDDEN(int) IOBUFMgrAllocBuf(IOBUFMGR hIoBufMgr, PIOBUFDESC pIoBufDesc, size_t cbIoBuf, size_t *pcbIoBufAllocated)
+/**
+ * Allocates a I/O buffer from the given sub-pool.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NO_MEMORY if there is no free memory in the pool.
+ * @param   pPool              The I/O buffer manager sub-pool.
+ * @param   pIoBufDesc         The I/O buffer descriptor to initialize on success.
+ * @param   cbIoBuf            How much to allocate.
+ * @param   pcbIoBufAllocated  Where to store amount of memory the manager was able to allocate.
+ */
+static int iobufMgrPoolAllocBuf(PIOBUFMGRPOOL pPool, PIOBUFDESC pIoBufDesc, size_t cbIoBuf, size_t *pcbIoBufAllocated)
 {
-    PIOBUFMGRINT pThis = hIoBufMgr;
-
-    LogFlowFunc(("pThis=%#p pIoBufDesc=%#p cbIoBuf=%zu pcbIoBufAllocated=%#p\n",
-                 pThis, pIoBufDesc, cbIoBuf, pcbIoBufAllocated));
-
-    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
-    AssertReturn(cbIoBuf > 0, VERR_INVALID_PARAMETER);
-
-    if (   !pThis->cbFree
-        || pThis->fAllocSuspended)
+    if (   !pPool->cbFree
+        || pPool->fAllocSuspended)
         return VERR_NO_MEMORY;
 
-    int rc = RTCritSectEnter(&pThis->CritSectAlloc);
+    int rc = RTCritSectEnter(&pPool->CritSectAlloc);
     if (RT_SUCCESS(rc))
     {
         unsigned iSeg = 0;
@@ -453,7 +559,7 @@ DECLHIDDEN(int) IOBUFMgrAllocBuf(IOBUFMGR hIoBufMgr, PIOBUFDESC pIoBufDesc, size
         while (   iSeg < RT_ELEMENTS(pIoBufDesc->Int.aSegs)
                && cbLeft)
         {
-            size_t cbAlloc = iobufMgrAllocSegment(pThis, pSeg, cbLeft);
+            size_t cbAlloc = iobufMgrAllocSegment(pPool, pSeg, cbLeft);
             if (!cbAlloc)
                 break;
 
@@ -469,26 +575,141 @@ DECLHIDDEN(int) IOBUFMgrAllocBuf(IOBUFMGR hIoBufMgr, PIOBUFDESC pIoBufDesc, size
             rc = VERR_NO_MEMORY;
 
         pIoBufDesc->Int.cSegsUsed = iSeg;
-        pIoBufDesc->Int.pIoBufMgr = pThis;
+        pIoBufDesc->Int.pPool     = pPool;
         *pcbIoBufAllocated = cbIoBufAlloc;
         Assert(   (RT_SUCCESS(rc) && *pcbIoBufAllocated > 0)
                || RT_FAILURE(rc));
 
-        RTCritSectLeave(&pThis->CritSectAlloc);
+        RTCritSectLeave(&pPool->CritSectAlloc);
+    }
+
+    return rc;
+}
+
+DECLHIDDEN(int) IOBUFMgrCreate(PIOBUFMGR phIoBufMgr, size_t cbMax, uint32_t fFlags)
+{
+    return IOBUFMgrCreateEx(phIoBufMgr, cbMax, 1 /* cPools */, fFlags);
+}
+
+DECLHIDDEN(int) IOBUFMgrCreateEx(PIOBUFMGR phIoBufMgr, size_t cbMax, uint32_t cPools, uint32_t fFlags)
+{
+    int rc = VINF_SUCCESS;
+
+    AssertPtrReturn(phIoBufMgr, VERR_INVALID_POINTER);
+    AssertReturn(cbMax, VERR_NOT_IMPLEMENTED);
+    AssertReturn(cPools > 0 && cPools <= IOBUFMGR_POOLS_MAX, VERR_INVALID_PARAMETER);
+
+    /* Every pool should be able to hold at least one object of the largest bin size. */
+    cbMax  = RT_ALIGN_Z(cbMax, IOBUFMGR_BIN_SIZE_MIN);
+    cPools = (uint32_t)RT_MAX(RT_MIN(cPools, cbMax / IOBUFMGR_BIN_SIZE_MAX), 1);
+
+    PIOBUFMGRINT pThis = (PIOBUFMGRINT)RTMemAllocZ(RT_UOFFSETOF_DYN(IOBUFMGRINT, aPools[cPools]));
+    if (RT_LIKELY(pThis))
+    {
+        pThis->fFlags          = fFlags;
+        pThis->cPools          = cPools;
+        pThis->cbMax           = cbMax;
+        pThis->u32OrderMin     = ASMBitLastSetU32(IOBUFMGR_BIN_SIZE_MIN) - 1;
+        pThis->u32OrderMax     = ASMBitLastSetU32(IOBUFMGR_BIN_SIZE_MAX) - 1;
+
+        /* The last pool gets the remainder. */
+        size_t const cbPool = (cbMax / cPools) & ~(size_t)(IOBUFMGR_BIN_SIZE_MIN - 1);
+        for (uint32_t i = 0; i < cPools && RT_SUCCESS(rc); i++)
+            rc = iobufMgrPoolInit(pThis, &pThis->aPools[i], i < cPools - 1 ? cbPool : cbMax - (cPools - 1) * cbPool);
+
+        if (RT_SUCCESS(rc))
+        {
+            if (   cPools > 1
+                || (fFlags & IOBUFMGR_F_LARGE_PAGES))
+                LogRel(("IOBufMgr: %zu bytes in %u pool(s), %llu backed by hugetlbfs pages\n",
+                        cbMax, cPools, pThis->Stats.StatPoolsLargePages.c));
+            *phIoBufMgr = pThis;
+            return VINF_SUCCESS;
+        }
+
+        for (uint32_t i = 0; i < cPools; i++)
+            iobufMgrPoolDestroy(pThis, &pThis->aPools[i]);
+        RTMemFree(pThis);
+    }
+    else
+        rc = VERR_NO_MEMORY;
+
+    return rc;
+}
+
+DECLHIDDEN(int) IOBUFMgrDestroy(IOBUFMGR hIoBufMgr)
+{
+    PIOBUFMGRINT pThis = hIoBufMgr;
+
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+
+    for (uint32_t i = 0; i < pThis->cPools; i++)
+    {
+        PIOBUFMGRPOOL pPool = &pThis->aPools[i];
+        int rc = RTCritSectEnter(&pPool->CritSectAlloc);
+        AssertRCReturn(rc, rc);
+        bool const fBusy = pPool->cbFree != pPool->cbMax;
+        RTCritSectLeave(&pPool->CritSectAlloc);
+        if (fBusy)
+            return VERR_INVALID_STATE;
+    }
+
+    for (uint32_t i = 0; i < pThis->cPools; i++)
+        iobufMgrPoolDestroy(pThis, &pThis->aPools[i]);
+    RTMemFree(pThis);
+
+    return VINF_SUCCESS;
+}
+
+DECLHIDDEN(int) IOBUFMgrAllocBuf(IOBUFMGR hIoBufMgr, PIOBUFDESC pIoBufDesc, size_t cbIoBuf, size_t *pcbIoBufAllocated)
+{
+    PIOBUFMGRINT pThis = hIoBufMgr;
+
+    LogFlowFunc(("pThis=%#p pIoBufDesc=%#p cbIoBuf=%zu pcbIoBufAllocated=%#p\n",
+                 pThis, pIoBufDesc, cbIoBuf, pcbIoBufAllocated));
+
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertReturn(cbIoBuf > 0, VERR_INVALID_PARAMETER);
+
+    /*
+     * Start with the pool of the CPU we're running on and try the others if it is
+     * exhausted, only giving up if there is nothing free anywhere.
+     */
+    uint32_t const idxPoolFirst = pThis->cPools > 1 ? (uint32_t)RTMpCurSetIndex() % pThis->cPools : 0;
+    int rc = VERR_NO_MEMORY;
+    for (uint32_t i = 0; i < pThis->cPools; i++)
+    {
+        rc = iobufMgrPoolAllocBuf(&pThis->aPools[(idxPoolFirst + i) % pThis->cPools], pIoBufDesc, cbIoBuf,
+                                  pcbIoBufAllocated);
+        if (rc != VERR_NO_MEMORY)
+        {
+            if (i)
+                STAM_REL_COUNTER_INC(&pThis->Stats.StatAllocOtherPool);
+            break;
+        }
+    }
+
+    if (RT_SUCCESS(rc))
+    {
+        STAM_REL_COUNTER_INC(&pThis->Stats.StatAllocs);
+        if (*pcbIoBufAllocated < cbIoBuf)
+            STAM_REL_COUNTER_INC(&pThis->Stats.StatAllocPartial);
     }
+    else
+        STAM_REL_COUNTER_INC(&pThis->Stats.StatAllocFailures);
 
     return rc;
 }
 
 DECLHIDDEN(void) IOBUFMgrFreeBuf(PIOBUFDESC pIoBufDesc)
 {
-    PIOBUFMGRINT pThis = pIoBufDesc->Int.pIoBufMgr;
+    PIOBUFMGRPOOL pPool = pIoBufDesc->Int.pPool;
 
     LogFlowFunc(("pIoBufDesc=%#p{.cSegsUsed=%u}\n", pIoBufDesc, pIoBufDesc->Int.cSegsUsed));
 
-    AssertPtr(pThis);
+    AssertPtr(pPool);
 
-    int rc = RTCritSectEnter(&pThis->CritSectAlloc);
+    int rc = RTCritSectEnter(&pPool->CritSectAlloc);
     AssertRC(rc);
 
     if (RT_SUCCESS(rc))
@@ -498,22 +719,22 @@ DECLHIDDEN(void) IOBUFMgrFreeBuf(PIOBUFDESC pIoBufDesc)
             PRTSGSEG pSeg = &pIoBufDesc->Int.aSegs[i];
 
             uint32_t u32Order = ASMBitLastSetU32((uint32_t)pSeg->cbSeg) - 1;
-            unsigned iBin = u32Order - pThis->u32OrderMin;
+            unsigned iBin = u32Order - pPool->pIoBufMgr->u32OrderMin;
 
-            Assert(iBin < pThis->cBins);
-            PIOBUFMGRBIN pBin = &pThis->paBins[iBin];
+            Assert(iBin < pPool->cBins);
+            PIOBUFMGRBIN pBin = &pPool->paBins[iBin];
             iobufMgrBinObjAdd(pBin, pSeg->pvSeg);
-            pThis->cbFree += pSeg->cbSeg;
+            pPool->cbFree += pSeg->cbSeg;
 
 #ifdef IOBUFMGR_VERIFY_ALLOCATIONS
             /* Mark the objects as free. */
-            uint32_t iBinStart = ((uintptr_t)pSeg->pvSeg - (uintptr_t)pThis->pvMem) / IOBUFMGR_BIN_SIZE_MIN;
-            Assert(   !(((uintptr_t)pSeg->pvSeg - (uintptr_t)pThis->pvMem) % IOBUFMGR_BIN_SIZE_MIN)
+            uint32_t iBinStart = ((uintptr_t)pSeg->pvSeg - (uintptr_t)pPool->pvMem) / IOBUFMGR_BIN_SIZE_MIN;
+            Assert(   !(((uintptr_t)pSeg->pvSeg - (uintptr_t)pPool->pvMem) % IOBUFMGR_BIN_SIZE_MIN)
                    && !(pSeg->cbSeg % IOBUFMGR_BIN_SIZE_MIN));
             uint32_t iBinEnd = iBinStart + (pSeg->cbSeg / IOBUFMGR_BIN_SIZE_MIN);
             while (iBinStart < iBinEnd)
             {
-                bool fState = ASMBitTestAndClear(pThis->pbmObjState, iBinStart);
+                bool fState = ASMBitTestAndClear(pPool->pbmObjState, iBinStart);
                 //LogFlowFunc(("iBinStart=%u fState=%RTbool -> false\n", iBinStart, fState));
                 AssertMsg(fState, ("Trying to free a non allocated object\n"));
                 iBinStart++;
@@ -525,14 +746,14 @@ DECLHIDDEN(void) IOBUFMgrFreeBuf(PIOBUFDESC pIoBufDesc)
 #endif
         }
 
-        if (   pThis->cbFree == pThis->cbMax
-            && pThis->fAllocSuspended)
+        if (   pPool->cbFree == pPool->cbMax
+            && pPool->fAllocSuspended)
         {
-            iobufMgrResetBins(pThis);
-            pThis->fAllocSuspended = false;
+            iobufMgrResetBins(pPool);
+            pPool->fAllocSuspended = false;
         }
 
-        RTCritSectLeave(&pThis->CritSectAlloc);
+        RTCritSectLeave(&pPool->CritSectAlloc);
     }
 
     pIoBufDesc->Int.cSegsUsed = 0;
@@ -541,3 +762,10 @@ DECLHIDDEN(void) IOBUFMgrFreeBuf(PIOBUFDESC pIoBufDesc)
 #endif
 }
 
+DECLHIDDEN(PIOBUFMGRSTATS) IOBUFMgrGetStats(IOBUFMGR hIoBufMgr)
+{
+    PIOBUFMGRINT pThis = hIoBufMgr;
+    AssertPtrReturn(pThis, NULL);
+    return &pThis->Stats;
+}
+
@@ -32,6 +32,7 @@
 #endif
 
 #include <VBox/cdefs.h>
+#include <VBox/vmm/stam.h>
 #include <iprt/sg.h>
 
 RT_C_DECLS_BEGIN
@@ -50,6 +51,34 @@ typedef IOBUFMGR *PIOBUFMGR;
 /** I/O buffer memory needs to be non pageable (for example because it contains sensitive data
  * which shouldn't end up in swap unencrypted). */
 #define IOBUFMGR_F_REQUIRE_NOT_PAGABLE RT_BIT(0)
+/** Try to back the I/O buffer memory with 2MB host pages (ignored together with
+ * IOBUFMGR_F_REQUIRE_NOT_PAGABLE and on hosts without support). */
+#define IOBUFMGR_F_LARGE_PAGES         RT_BIT(1)
+
+/** Maximum number of sub-pools an I/O buffer manager can be split into. */
+#define IOBUFMGR_POOLS_MAX             16
+
+/**
+ * I/O buffer manager statistics.
+ */
+typedef struct IOBUFMGRSTATS
+{
+    /** Number of successful allocations. */
+    STAMCOUNTER      StatAllocs;
+    /** Number of allocations which failed because there was no free memory. */
+    STAMCOUNTER      StatAllocFailures;
+    /** Number of allocations which got less memory than requested. */
+    STAMCOUNTER      StatAllocPartial;
+    /** Number of allocations served from another sub-pool than the one of the calling CPU. */
+    STAMCOUNTER      StatAllocOtherPool;
+    /** Number of times a sub-pool was too fragmented and allocations had to be held
+     * back until all of its memory was freed again. */
+    STAMCOUNTER      StatAllocSuspended;
+    /** Number of sub-pools backed by large pages. */
+    STAMCOUNTER      StatPoolsLargePages;
+} IOBUFMGRSTATS;
+/** Pointer to I/O buffer manager statistics. */
+typedef IOBUFMGRSTATS *PIOBUFMGRSTATS;
 
 /**
  * I/O buffer descriptor.
@@ -82,6 +111,24 @@ typedef IOBUFDESC *PIOBUFDESC;
  */
 DECLHIDDEN(int) IOBUFMgrCreate(PIOBUFMGR phIoBufMgr, size_t cbMax, uint32_t fFlags);
 
+/**
+ * Creates I/O buffer manager, extended version.
+ *
+ * The memory is split into the given number of sub-pools with their own locks and
+ * allocations are served from the pool belonging to the host CPU the caller runs on,
+ * falling back on the other pools if it is exhausted.  On Linux hosts the pool memory
+ * is not touched before it is used first, so with the default first touch policy it
+ * ends up on the NUMA node of the worker threads using it.
+ *
+ * @returns VBox status code.
+ * @param   phIoBufMgr    Where to store the handle to the I/O buffer manager on success.
+ * @param   cbMax         The maximum amount of I/O memory to allow, see IOBUFMgrCreate().
+ * @param   cPools        Number of sub-pools to split the memory into, 1 to IOBUFMGR_POOLS_MAX.
+ *                        Reduced if there would be less than the largest bin size per pool.
+ * @param   fFlags        Combination of IOBUFMGR_F_*
+ */
+DECLHIDDEN(int) IOBUFMgrCreateEx(PIOBUFMGR phIoBufMgr, size_t cbMax, uint32_t cPools, uint32_t fFlags);
+
 /**
  * Destroys the given I/O buffer manager.
  *
@@ -114,6 +161,14 @@ DECLHIDDEN(int) IOBUFMgrAllocBuf(IOBUFMGR hIoBufMgr, PIOBUFDESC pIoBufDesc, size
  */
 DECLHIDDEN(void) IOBUFMgrFreeBuf(PIOBUFDESC pIoBufDesc);
 
+/**
+ * Returns the statistics of the given I/O buffer manager for registration with STAM.
+ *
+ * @returns Pointer to the statistics, valid until the manager is destroyed.
+ * @param   hIoBufMgr          The I/O buffer manager.
+ */
+DECLHIDDEN(PIOBUFMGRSTATS) IOBUFMgrGetStats(IOBUFMGR hIoBufMgr);
+
 RT_C_DECLS_END
 
 #endif /* !VBOX_INCLUDED_SRC_Storage_IOBufMgmt_h */
@@ -171,6 +171,8 @@ typedef struct VSCSIIOREQINT
             unsigned       cSeg;
             /** Segment array. */
             PCRTSGSEG      paSeg;
+            /** Memory allocated for the transfer which is freed on completion, optional. */
+            void          *pvAlloc;
         } Io;
         /** Unmap request. */
         struct
@@ -490,6 +492,32 @@ int vscsiIoReqTransferEnqueueEx(PVSCSILUNINT pVScsiLun, PVSCSIREQINT pVScsiReq,
                                 VSCSIIOREQTXDIR enmTxDir, uint64_t uOffset,
                                 PCRTSGSEG paSegs, unsigned cSegs, size_t cbTransfer);
 
+/**
+ * Enqueue a new write request writing the same data block repeatedly.
+ *
+ * @returns VBox status code.
+ * @param   pVScsiLun   The LUN instance which issued the request.
+ * @param   pVScsiReq   The virtual SCSI request associated with the transfer.
+ * @param   uOffset     Start offset of the transfer.
+ * @param   cbTransfer  Number of bytes to write.
+ * @param   pvBlock     The data block to write, copied.
+ * @param   cbBlock     Size of the data block.
+ */
+int vscsiIoReqWriteSameEnqueue(PVSCSILUNINT pVScsiLun, PVSCSIREQINT pVScsiReq, uint64_t uOffset,
+                               size_t cbTransfer, const void *pvBlock, size_t cbBlock);
+
+/**
+ * Enqueue a new write zeroes request.
+ *
+ * @returns VBox status code.
+ * @param   pVScsiLun   The LUN instance which issued the request.
+ * @param   pVScsiReq   The virtual SCSI request associated with the request.
+ * @param   uOffset     Start offset of the range to zero.
+ * @param   cbZero      Number of bytes to zero.
+ */
+int vscsiIoReqWriteZeroesEnqueue(PVSCSILUNINT pVScsiLun, PVSCSIREQINT pVScsiReq, uint64_t uOffset,
+                                 size_t cbZero);
+
 /**
  * Enqueue a new unmap request.
  *
@@ -32,9 +32,13 @@
 #include <iprt/assert.h>
 #include <iprt/mem.h>
 #include <iprt/asm.h>
+#include <iprt/string.h>
 
 #include "VSCSIInternal.h"
 
+/** Size of the buffer holding the replicated data block for WRITE SAME. */
+#define VSCSI_WRITE_SAME_CHUNK_SIZE _64K
+
 int vscsiIoReqInit(PVSCSILUNINT pVScsiLun)
 {
     return vscsiLunReqAllocSizeSet(pVScsiLun, sizeof(VSCSIIOREQINT));
@@ -86,6 +90,7 @@ int vscsiIoReqTransferEnqueue(PVSCSILUNINT pVScsiLun, PVSCSIREQINT pVScsiReq,
         pVScsiIoReq->u.Io.cbTransfer = cbTransfer;
         pVScsiIoReq->u.Io.paSeg      = pVScsiReq->SgBuf.paSegs;
         pVScsiIoReq->u.Io.cSeg       = pVScsiReq->SgBuf.cSegs;
+        pVScsiIoReq->u.Io.pvAlloc    = NULL;
 
         ASMAtomicIncU32(&pVScsiLun->IoReq.cReqOutstanding);
 
@@ -121,6 +126,108 @@ int vscsiIoReqTransferEnqueueEx(PVSCSILUNINT pVScsiLun, PVSCSIREQINT pVScsiReq,
         pVScsiIoReq->u.Io.cbTransfer = cbTransfer;
         pVScsiIoReq->u.Io.paSeg      = paSegs;
         pVScsiIoReq->u.Io.cSeg       = cSegs;
+        pVScsiIoReq->u.Io.pvAlloc    = NULL;
+
+        ASMAtomicIncU32(&pVScsiLun->IoReq.cReqOutstanding);
+
+        rc = vscsiLunReqTransferEnqueue(pVScsiLun, pVScsiIoReq);
+        if (RT_FAILURE(rc))
+        {
+            ASMAtomicDecU32(&pVScsiLun->IoReq.cReqOutstanding);
+            vscsiLunReqFree(pVScsiLun, pVScsiIoReq);
+        }
+    }
+
+    return rc;
+}
+
+
+int vscsiIoReqWriteSameEnqueue(PVSCSILUNINT pVScsiLun, PVSCSIREQINT pVScsiReq, uint64_t uOffset,
+                               size_t cbTransfer, const void *pvBlock, size_t cbBlock)
+{
+    int rc = VINF_SUCCESS;
+    PVSCSIIOREQINT pVScsiIoReq = NULL;
+
+    LogFlowFunc(("pVScsiLun=%#p pVScsiReq=%#p uOffset=%llu cbTransfer=%zu cbBlock=%zu\n",
+                 pVScsiLun, pVScsiReq, uOffset, cbTransfer, cbBlock));
+
+    AssertReturn(cbBlock && !(cbTransfer % cbBlock), VERR_INVALID_PARAMETER);
+
+    /*
+     * Fill a chunk with copies of the block and describe the whole transfer with
+     * segments all pointing to that chunk, so the memory needed stays small.
+     */
+    size_t   cbChunk = RT_MIN(cbTransfer, (VSCSI_WRITE_SAME_CHUNK_SIZE / cbBlock) * cbBlock);
+    cbChunk          = RT_MAX(cbChunk, cbBlock);
+    size_t   cSegs   = (cbTransfer + cbChunk - 1) / cbChunk;
+    AssertReturn(cSegs <= UINT32_MAX, VERR_INVALID_PARAMETER);
+
+    PRTSGSEG paSegs = (PRTSGSEG)RTMemAlloc(cSegs * sizeof(RTSGSEG) + cbChunk);
+    if (RT_UNLIKELY(!paSegs))
+        return VERR_NO_MEMORY;
+
+    uint8_t *pbChunk = (uint8_t *)&paSegs[cSegs];
+    for (size_t off = 0; off < cbChunk; off += cbBlock)
+        memcpy(pbChunk + off, pvBlock, cbBlock);
+
+    size_t cbLeft = cbTransfer;
+    for (size_t i = 0; i < cSegs; i++)
+    {
+        paSegs[i].pvSeg = pbChunk;
+        paSegs[i].cbSeg = RT_MIN(cbLeft, cbChunk);
+        cbLeft -= paSegs[i].cbSeg;
+    }
+
+    rc = vscsiLunReqAlloc(pVScsiLun, (uintptr_t)pVScsiReq, &pVScsiIoReq);
+    if (RT_SUCCESS(rc))
+    {
+        pVScsiIoReq->pVScsiReq       = pVScsiReq;
+        pVScsiIoReq->pVScsiLun       = pVScsiLun;
+        pVScsiIoReq->enmTxDir        = VSCSIIOREQTXDIR_WRITE;
+        pVScsiIoReq->u.Io.uOffset    = uOffset;
+        pVScsiIoReq->u.Io.cbTransfer = cbTransfer;
+        pVScsiIoReq->u.Io.paSeg      = paSegs;
+        pVScsiIoReq->u.Io.cSeg       = (unsigned)cSegs;
+        pVScsiIoReq->u.Io.pvAlloc    = paSegs;
+
+        ASMAtomicIncU32(&pVScsiLun->IoReq.cReqOutstanding);
+
+        rc = vscsiLunReqTransferEnqueue(pVScsiLun, pVScsiIoReq);
+        if (RT_FAILURE(rc))
+        {
+            ASMAtomicDecU32(&pVScsiLun->IoReq.cReqOutstanding);
+            vscsiLunReqFree(pVScsiLun, pVScsiIoReq);
+        }
+    }
+
+    if (RT_FAILURE(rc))
+        RTMemFree(paSegs);
+
+    return rc;
+}
+
+
+int vscsiIoReqWriteZeroesEnqueue(PVSCSILUNINT pVScsiLun, PVSCSIREQINT pVScsiReq, uint64_t uOffset,
+                                 size_t cbZero)
+{
+    int rc = VINF_SUCCESS;
+    PVSCSIIOREQINT pVScsiIoReq = NULL;
+
+    LogFlowFunc(("pVScsiLun=%#p pVScsiReq=%#p uOffset=%llu cbZero=%zu\n",
+                 pVScsiLun, pVScsiReq, uOffset, cbZero));
+
+    rc = vscsiLunReqAlloc(pVScsiLun, (uintptr_t)pVScsiReq, &pVScsiIoReq);
+    if (RT_SUCCESS(rc))
+    {
+        pVScsiIoReq->pVScsiReq       = pVScsiReq;
+        pVScsiIoReq->pVScsiLun       = pVScsiLun;
+        pVScsiIoReq->enmTxDir        = VSCSIIOREQTXDIR_WRITE_ZEROES;
+        pVScsiIoReq->u.Io.uOffset    = uOffset;
+        pVScsiIoReq->u.Io.cbTransfer = cbZero;
+        pVScsiIoReq->u.Io.paSeg      = NULL;
+        pVScsiIoReq->u.Io.cSeg       = 0;
+        pVScsiIoReq->u.Io.cbSeg      = 0;
+        pVScsiIoReq->u.Io.pvAlloc    = NULL;
 
         ASMAtomicIncU32(&pVScsiLun->IoReq.cReqOutstanding);
 
@@ -210,6 +317,10 @@ VBOXDDU_DECL(int) VSCSIIoReqCompleted(VSCSIIOREQ hVScsiIoReq, int rcIoReq, bool
 
     if (pVScsiIoReq->enmTxDir == VSCSIIOREQTXDIR_UNMAP)
         RTMemFree(pVScsiIoReq->u.Unmap.paRanges);
+    else if (   (   pVScsiIoReq->enmTxDir == VSCSIIOREQTXDIR_READ
+                 || pVScsiIoReq->enmTxDir == VSCSIIOREQTXDIR_WRITE)
+             && pVScsiIoReq->u.Io.pvAlloc)
+        RTMemFree(pVScsiIoReq->u.Io.pvAlloc);
 
     /* Free the I/O request */
     vscsiLunReqFree(pVScsiLun, pVScsiIoReq);
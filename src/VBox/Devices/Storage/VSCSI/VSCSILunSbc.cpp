@@ -36,6 +36,7 @@
 #include <VBox/vscsi.h>
 #include <iprt/cdefs.h>
 #include <iprt/asm.h>
+#include <iprt/asm-mem.h>
 #include <iprt/assert.h>
 #include <iprt/mem.h>
 #include <iprt/string.h>
@@ -44,6 +45,8 @@
 
 /** Maximum of amount of LBAs to unmap with one command. */
 #define VSCSI_UNMAP_LBAS_MAX(a_cbSector) ((10*_1M) / a_cbSector)
+/** Maximum of amount of LBAs to write with one WRITE SAME command. */
+#define VSCSI_WRITE_SAME_LBAS_MAX(a_cbSector) ((256*_1M) / a_cbSector)
 
 /**
  * SBC LUN instance
@@ -109,6 +112,7 @@ static DECLCALLBACK(int) vscsiLunSbcInit(PVSCSILUNINT pVScsiLun)
                 pBlkPage->u5PeripheralDeviceType       = SCSI_INQUIRY_DATA_PERIPHERAL_DEVICE_TYPE_DIRECT_ACCESS;
                 pBlkPage->u3PeripheralQualifier        = SCSI_INQUIRY_DATA_PERIPHERAL_QUALIFIER_CONNECTED;
                 pBlkPage->u16PageLength                = RT_H2BE_U16(0x3c);
+                pBlkPage->fWSNZ                        = 1;
                 pBlkPage->u8MaxCmpWriteLength          = 0;
                 pBlkPage->u16OptTrfLengthGran          = 0;
                 pBlkPage->u32MaxTrfLength              = 0;
@@ -118,6 +122,7 @@ static DECLCALLBACK(int) vscsiLunSbcInit(PVSCSILUNINT pVScsiLun)
                 pBlkPage->u32MaxUnmapBlkDescCount      = UINT32_C(0xffffffff);
                 pBlkPage->u32OptUnmapGranularity       = 0;
                 pBlkPage->u32UnmapGranularityAlignment = 0;
+                pBlkPage->u64MaxWriteSameLength        = RT_H2BE_U64(VSCSI_WRITE_SAME_LBAS_MAX(pVScsiLunSbc->cbSector));
                 cVpdPages++;
         }
 
@@ -131,6 +136,7 @@ static DECLCALLBACK(int) vscsiLunSbcInit(PVSCSILUNINT pVScsiLun)
                 pBlkProvPage->u3PeripheralQualifier  = SCSI_INQUIRY_DATA_PERIPHERAL_QUALIFIER_CONNECTED;
                 pBlkProvPage->u16PageLength          = RT_H2BE_U16(0x4);
                 pBlkProvPage->u8ThresholdExponent    = 1;
+                pBlkProvPage->fLBPWS                 = true;
                 pBlkProvPage->fLBPU                  = true;
                 cVpdPages++;
             }
@@ -197,6 +203,187 @@ static DECLCALLBACK(int) vscsiLunSbcDestroy(PVSCSILUNINT pVScsiLun)
     return VINF_SUCCESS;
 }
 
+/**
+ * Processes the UNMAP command, turning all block descriptors into a single
+ * discard request.
+ *
+ * @returns VBox status code.
+ * @param   pVScsiLunSbc    The SBC LUN instance.
+ * @param   pVScsiReq       The request to process.
+ */
+static int vscsiLunSbcUnmap(PVSCSILUNSBC pVScsiLunSbc, PVSCSIREQINT pVScsiReq)
+{
+    PVSCSILUNINT pVScsiLun = &pVScsiLunSbc->Core;
+    int rc = VINF_SUCCESS;
+    int rcReq = SCSI_STATUS_OK;
+    uint8_t abHdr[8];
+    size_t cbList = scsiBE2H_U16(&pVScsiReq->pbCDB[7]);
+
+    /* Copy the header. */
+    vscsiReqSetXferDir(pVScsiReq, VSCSIXFERDIR_I2T);
+    vscsiReqSetXferSize(pVScsiReq, cbList);
+    size_t cbCopied = RTSgBufCopyToBuf(&pVScsiReq->SgBuf, &abHdr[0], sizeof(abHdr));
+
+    /* Using the anchor bit is not supported. */
+    if (   !(pVScsiReq->pbCDB[1] & 0x01)
+        && cbCopied == sizeof(abHdr)
+        && cbList >= 8)
+    {
+        uint32_t cBlkDesc = RT_MIN(scsiBE2H_U16(&abHdr[2]), cbList - 8) / 16;
+        if (cBlkDesc)
+        {
+            /* Fetch all block descriptors at once and convert them in place. */
+            size_t const cbBlkDescs = cBlkDesc * 16;
+            uint8_t *pbBlkDescs = (uint8_t *)RTMemAlloc(RT_MAX(cbBlkDescs, cBlkDesc * sizeof(RTRANGE)));
+            if (pbBlkDescs)
+            {
+                PRTRANGE paRanges = (PRTRANGE)pbBlkDescs;
+                unsigned cRanges  = 0;
+                AssertCompile(sizeof(RTRANGE) <= 16);
+
+                cbCopied = RTSgBufCopyToBuf(&pVScsiReq->SgBuf, pbBlkDescs, cbBlkDescs);
+                if (RT_LIKELY(cbCopied == cbBlkDescs))
+                {
+                    for (unsigned i = 0; i < cBlkDesc; i++)
+                    {
+                        uint64_t const uLba    = scsiBE2H_U64(&pbBlkDescs[i * 16]);
+                        uint32_t const cBlocks = scsiBE2H_U32(&pbBlkDescs[i * 16 + 8]);
+
+                        if (RT_UNLIKELY(   uLba > pVScsiLunSbc->cSectors
+                                        || cBlocks > pVScsiLunSbc->cSectors - uLba))
+                        {
+                            rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST,
+                                                             SCSI_ASC_LOGICAL_BLOCK_OOR, 0x00);
+                            break;
+                        }
+
+                        /* Descriptors without blocks are valid, merge adjacent ones. */
+                        if (!cBlocks)
+                            continue;
+                        if (   cRanges
+                            && paRanges[cRanges - 1].offStart + paRanges[cRanges - 1].cbRange == uLba * 512)
+                            paRanges[cRanges - 1].cbRange += (size_t)cBlocks * 512;
+                        else
+                        {
+                            /* Never overwrites descriptors not converted yet as a range is not larger. */
+                            paRanges[cRanges].offStart = uLba * 512;
+                            paRanges[cRanges].cbRange  = (size_t)cBlocks * 512;
+                            cRanges++;
+                        }
+                    }
+                }
+                else
+                    rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST,
+                                                     SCSI_ASC_INV_FIELD_IN_CMD_PACKET, 0x00);
+
+                if (rcReq == SCSI_STATUS_OK && cRanges)
+                {
+                    rc = vscsiIoReqUnmapEnqueue(pVScsiLun, pVScsiReq, paRanges, cRanges);
+                    if (RT_FAILURE(rc))
+                        RTMemFree(paRanges);
+                    return rc;
+                }
+
+                RTMemFree(pbBlkDescs);
+                if (rcReq == SCSI_STATUS_OK)
+                    rcReq = vscsiLunReqSenseOkSet(pVScsiLun, pVScsiReq);
+            }
+            else /* Out of memory. */
+                rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_HARDWARE_ERROR, SCSI_ASC_SYSTEM_RESOURCE_FAILURE,
+                                                 SCSI_ASCQ_SYSTEM_BUFFER_FULL);
+        }
+        else /* No block descriptors is not an error condition. */
+            rcReq = vscsiLunReqSenseOkSet(pVScsiLun, pVScsiReq);
+    }
+    else /* Invalid CDB. */
+        rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INV_FIELD_IN_CMD_PACKET, 0x00);
+
+    vscsiDeviceReqComplete(pVScsiLun->pVScsiDevice, pVScsiReq, rcReq, false, VINF_SUCCESS);
+    return rc;
+}
+
+/**
+ * Processes the WRITE SAME (10) and (16) commands.
+ *
+ * A zeroed block with the UNMAP bit set becomes a discard request, anything else
+ * a single write request with all blocks referencing a small replicated buffer
+ * instead of a guest sized one. Zeroes written this way are detected by the
+ * disk image backends which don't allocate any blocks for them.
+ *
+ * @returns VBox status code.
+ * @param   pVScsiLunSbc    The SBC LUN instance.
+ * @param   pVScsiReq       The request to process.
+ * @param   uLbaStart       The first LBA to write.
+ * @param   cBlocks         Number of blocks to write.
+ * @param   fUnmap          Flag whether the UNMAP bit is set.
+ * @param   fNoDataOut      Flag whether there is no data out buffer and zeroes are written (NDOB).
+ */
+static int vscsiLunSbcWriteSame(PVSCSILUNSBC pVScsiLunSbc, PVSCSIREQINT pVScsiReq, uint64_t uLbaStart,
+                                uint32_t cBlocks, bool fUnmap, bool fNoDataOut)
+{
+    PVSCSILUNINT pVScsiLun = &pVScsiLunSbc->Core;
+    int rc = VINF_SUCCESS;
+    int rcReq;
+    uint8_t abBlock[512];
+
+    vscsiReqSetXferDir(pVScsiReq, fNoDataOut ? VSCSIXFERDIR_NONE : VSCSIXFERDIR_I2T);
+    vscsiReqSetXferSize(pVScsiReq, fNoDataOut ? 0 : sizeof(abBlock));
+
+    LogFlow(("%s: uLbaStart=%llu cBlocks=%u fUnmap=%RTbool fNoDataOut=%RTbool\n",
+             __FUNCTION__, uLbaStart, cBlocks, fUnmap, fNoDataOut));
+
+    /* PBDATA and LBDATA are not supported. */
+    if (pVScsiReq->pbCDB[1] & 0x06)
+        rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INV_FIELD_IN_CMD_PACKET, 0x00);
+    else if (   !cBlocks
+             || cBlocks > VSCSI_WRITE_SAME_LBAS_MAX(512))
+        rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INV_FIELD_IN_CMD_PACKET, 0x00);
+    else if (RT_UNLIKELY(   uLbaStart > pVScsiLunSbc->cSectors
+                         || cBlocks > pVScsiLunSbc->cSectors - uLbaStart))
+        rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_LOGICAL_BLOCK_OOR, 0x00);
+    else if (pVScsiLun->fFeatures & VSCSI_LUN_FEATURE_READONLY)
+        rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_DATA_PROTECT, SCSI_ASC_WRITE_PROTECTED, 0x00);
+    else
+    {
+        if (fNoDataOut)
+            RT_ZERO(abBlock);
+        if (   fNoDataOut
+            || RTSgBufCopyToBuf(&pVScsiReq->SgBuf, &abBlock[0], sizeof(abBlock)) == sizeof(abBlock))
+        {
+            bool const fZero = ASMMemIsZero(&abBlock[0], sizeof(abBlock));
+            if (   fZero
+                && fUnmap
+                && (pVScsiLun->fFeatures & VSCSI_LUN_FEATURE_UNMAP))
+            {
+                PRTRANGE pRange = (PRTRANGE)RTMemAlloc(sizeof(*pRange));
+                if (pRange)
+                {
+                    pRange->offStart = uLbaStart * 512;
+                    pRange->cbRange  = (size_t)cBlocks * 512;
+                    rc = vscsiIoReqUnmapEnqueue(pVScsiLun, pVScsiReq, pRange, 1);
+                    if (RT_FAILURE(rc))
+                        RTMemFree(pRange);
+                    return rc;
+                }
+            }
+            else if (   fZero
+                     && (pVScsiLun->fFeatures & VSCSI_LUN_FEATURE_WRITE_ZEROES))
+                return vscsiIoReqWriteZeroesEnqueue(pVScsiLun, pVScsiReq, uLbaStart * 512, (size_t)cBlocks * 512);
+            else
+                return vscsiIoReqWriteSameEnqueue(pVScsiLun, pVScsiReq, uLbaStart * 512, (size_t)cBlocks * 512,
+                                                  &abBlock[0], sizeof(abBlock));
+
+            rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_HARDWARE_ERROR, SCSI_ASC_SYSTEM_RESOURCE_FAILURE,
+                                             SCSI_ASCQ_SYSTEM_BUFFER_FULL);
+        }
+        else
+            rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INV_FIELD_IN_CMD_PACKET, 0x00);
+    }
+
+    vscsiDeviceReqComplete(pVScsiLun->pVScsiDevice, pVScsiReq, rcReq, false, VINF_SUCCESS);
+    return rc;
+}
+
 static DECLCALLBACK(int) vscsiLunSbcReqProcess(PVSCSILUNINT pVScsiLun, PVSCSIREQINT pVScsiReq)
 {
     PVSCSILUNSBC pVScsiLunSbc = (PVSCSILUNSBC)pVScsiLun;
@@ -530,64 +717,23 @@ static DECLCALLBACK(int) vscsiLunSbcReqProcess(PVSCSILUNINT pVScsiLun, PVSCSIREQ
         case SCSI_UNMAP:
         {
             if (pVScsiLun->fFeatures & VSCSI_LUN_FEATURE_UNMAP)
-            {
-                uint8_t abHdr[8];
-                size_t cbCopied;
-                size_t cbList = scsiBE2H_U16(&pVScsiReq->pbCDB[7]);
-
-                /* Copy the header. */
-                vscsiReqSetXferDir(pVScsiReq, VSCSIXFERDIR_I2T);
-                vscsiReqSetXferSize(pVScsiReq, cbList);
-                cbCopied = RTSgBufCopyToBuf(&pVScsiReq->SgBuf, &abHdr[0], sizeof(abHdr));
-
-                /* Using the anchor bit is not supported. */
-                if (   !(pVScsiReq->pbCDB[1] & 0x01)
-                    && cbCopied == sizeof(abHdr)
-                    && cbList >= 8)
-                {
-                    uint32_t    cBlkDesc = scsiBE2H_U16(&abHdr[2]) / 16;
-
-                    if (cBlkDesc)
-                    {
-                        PRTRANGE paRanges = (PRTRANGE)RTMemAllocZ(cBlkDesc * sizeof(RTRANGE));
-                        if (paRanges)
-                        {
-                            for (unsigned i = 0; i < cBlkDesc; i++)
-                            {
-                                uint8_t abBlkDesc[16];
-
-                                cbCopied = RTSgBufCopyToBuf(&pVScsiReq->SgBuf, &abBlkDesc[0], sizeof(abBlkDesc));
-                                if (RT_UNLIKELY(cbCopied != sizeof(abBlkDesc)))
-                                {
-                                    rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INV_FIELD_IN_CMD_PACKET, 0x00);
-                                    break;
-                                }
-
-                                paRanges[i].offStart = scsiBE2H_U64(&abBlkDesc[0]) * 512;
-                                paRanges[i].cbRange = (size_t)scsiBE2H_U32(&abBlkDesc[8]) * 512;
-                            }
-
-                            if (rcReq == SCSI_STATUS_OK)
-                                rc = vscsiIoReqUnmapEnqueue(pVScsiLun, pVScsiReq, paRanges, cBlkDesc);
-                            if (   rcReq != SCSI_STATUS_OK
-                                || RT_FAILURE(rc))
-                                RTMemFree(paRanges);
-                        }
-                        else /* Out of memory. */
-                            rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_HARDWARE_ERROR, SCSI_ASC_SYSTEM_RESOURCE_FAILURE,
-                                                             SCSI_ASCQ_SYSTEM_BUFFER_FULL);
-                    }
-                    else /* No block descriptors is not an error condition. */
-                        rcReq = vscsiLunReqSenseOkSet(pVScsiLun, pVScsiReq);
-                }
-                else /* Invalid CDB. */
-                    rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INV_FIELD_IN_CMD_PACKET, 0x00);
-            }
-            else
-                rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_ILLEGAL_OPCODE, 0x00);
+                return vscsiLunSbcUnmap(pVScsiLunSbc, pVScsiReq);
 
+            rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_ILLEGAL_OPCODE, 0x00);
             break;
         }
+        case SCSI_WRITE_SAME_10:
+        {
+            return vscsiLunSbcWriteSame(pVScsiLunSbc, pVScsiReq, scsiBE2H_U32(&pVScsiReq->pbCDB[2]),
+                                        scsiBE2H_U16(&pVScsiReq->pbCDB[7]), RT_BOOL(pVScsiReq->pbCDB[1] & 0x08),
+                                        false /*fNoDataOut*/);
+        }
+        case SCSI_WRITE_SAME_16:
+        {
+            return vscsiLunSbcWriteSame(pVScsiLunSbc, pVScsiReq, scsiBE2H_U64(&pVScsiReq->pbCDB[2]),
+                                        scsiBE2H_U32(&pVScsiReq->pbCDB[10]), RT_BOOL(pVScsiReq->pbCDB[1] & 0x08),
+                                        RT_BOOL(pVScsiReq->pbCDB[1] & 0x01));
+        }
         default:
             //AssertMsgFailed(("Command %#x [%s] not implemented\n", pRequest->pbCDB[0], SCSICmdText(pRequest->pbCDB[0])));
             rcReq = vscsiLunReqSenseErrorSet(pVScsiLun, pVScsiReq, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_ILLEGAL_OPCODE, 0x00);
@@ -638,7 +784,7 @@ static DECLCALLBACK(int) vscsiLunSbcReqProcess(PVSCSILUNINT pVScsiLun, PVSCSIREQ
         vscsiReqSetXferSize(pVScsiReq, 0);
         rc = vscsiIoReqFlushEnqueue(pVScsiLun, pVScsiReq);
     }
-    else if (pVScsiReq->pbCDB[0] !=  SCSI_UNMAP) /* Request completed */
+    else /* Request completed */
         vscsiDeviceReqComplete(pVScsiLun->pVScsiDevice, pVScsiReq, rcReq, false, VINF_SUCCESS);
 
     return rc;
@@ -689,7 +835,8 @@ static uint8_t s_acbCdbOpc[] =
     VSCSI_LUN_CDB_SZ_INVALID,        /**< 0x3d        Invalid */
     VSCSI_LUN_CDB_SZ_INVALID_X2,     /**< 0x3e - 0x3f Invalid */
 
-    VSCSI_LUN_CDB_SZ_INVALID_X2,     /**< 0x40 - 0x41 Invalid */
+    VSCSI_LUN_CDB_SZ_INVALID,        /**< 0x40        Invalid */
+    9,                               /**< 0x41        WRITE SAME (10) */
     9,                               /**< 0x42        UNMAP */
     VSCSI_LUN_CDB_SZ_INVALID,        /**< 0x43        Invalid */
     VSCSI_LUN_CDB_SZ_INVALID_X8,     /**< 0x44 - 0x4b Invalid */
@@ -708,7 +855,10 @@ static uint8_t s_acbCdbOpc[] =
     VSCSI_LUN_CDB_SZ_INVALID,        /**< 0x8b        Invalid */
     VSCSI_LUN_CDB_SZ_INVALID_X4,     /**< 0x8c - 0x8f Invalid */
 
-    VSCSI_LUN_CDB_SZ_INVALID_X8,     /**< 0x90 - 0x97 Invalid */
+    VSCSI_LUN_CDB_SZ_INVALID_X2,     /**< 0x90 - 0x91 Invalid */
+    VSCSI_LUN_CDB_SZ_INVALID,        /**< 0x92        Invalid */
+    14,                              /**< 0x93        WRITE SAME (16) */
+    VSCSI_LUN_CDB_SZ_INVALID_X4,     /**< 0x94 - 0x97 Invalid */
     VSCSI_LUN_CDB_SZ_INVALID_X4,     /**< 0x98 - 0x9b Invalid */
     VSCSI_LUN_CDB_SZ_INVALID_X2,     /**< 0x9c - 0x9d Invalid */
     2,                               /**< 0x9e        SERVICE ACTION IN (16) (at least 2). */
@@ -138,8 +138,10 @@ typedef struct VSCSIVPDPAGEBLOCKLIMITS
     unsigned u8PageCode             : 8;
     /** Page size (Big endian) */
     unsigned u16PageLength          : 16;
+    /** Write same non zero (a number of logical blocks of zero is invalid for WRITE SAME). */
+    unsigned fWSNZ                  : 1;
     /** Reserved. */
-    uint8_t  u8Reserved;
+    unsigned u7Reserved             : 7;
     /** Maximum compare and write length. */
     uint8_t  u8MaxCmpWriteLength;
     /** Optimal transfer length granularity. */
@@ -158,8 +160,10 @@ typedef struct VSCSIVPDPAGEBLOCKLIMITS
     uint32_t u32OptUnmapGranularity;
     /** UNMAP granularity alignment. */
     uint32_t u32UnmapGranularityAlignment;
+    /** Maximum WRITE SAME length. */
+    uint64_t u64MaxWriteSameLength;
     /** Reserved. */
-    uint8_t  abReserved[28];
+    uint8_t  abReserved[20];
 } VSCSIVPDPAGEBLOCKLIMITS;
 #pragma pack()
 AssertCompileSize(VSCSIVPDPAGEBLOCKLIMITS, VSCSI_VPD_BLOCK_LIMITS_SIZE);
@@ -292,6 +292,7 @@
 #ifdef IN_RING3
 # include <iprt/uuid.h>
 # include <iprt/critsect.h>
+# include <iprt/mem.h>
 #endif
 #include <VBox/vusb.h>
 #ifdef VBOX_IN_EXTPACK_R3
@@ -345,6 +346,14 @@
 #define XHCI_MAX_NUM_TRBS   1024
 /** @} */
 
+/** Number of transfer TRBs the TRB walker reads from guest memory in one go.
+ * The prefetch never crosses a guest page boundary. */
+#define XHCI_TRB_PREFETCH   16
+
+/** Bulk OUT TDs at least this big are handed to VUSB as mapped guest memory
+ * instead of being copied into the URB buffer. */
+#define XHCI_GUEST_SG_MIN_SIZE      _4K
+
 /** Implementation TD size limit. Prevents EDTLA wrap-around. */
 #define XHCI_MAX_TD_SIZE            (16 * _1M - 1)
 
@@ -586,6 +595,8 @@ AssertCompile(XHCI_RTREG_OFFSET > XHCI_XECP_OFFSET + XHCI_EXT_CAP_SIZE);
 #define XHCI_IMOD_IMODC_MASK    0xFFFF0000  /**< RW */
 #define XHCI_IMOD_IMODC_SHIFT   16
 #define XHCI_IMOD_IMODI_MASK    0x0000FFFF  /**< RW */
+/** IMODI/IMODC count in units of 250 ns. */
+#define XHCI_IMOD_UNIT_NS       250
 /** @} */
 
 
@@ -1475,6 +1486,25 @@ AssertCompile(sizeof(XHCI_DEV_CTX) == 32 * sizeof(XHCI_SLOT_CTX));
 typedef struct XHCI *PXHCI;
 
 #ifndef VBOX_DEVICE_STRUCT_TESTCASE
+/**
+ * Guest memory backing the data of a bulk OUT URB (VUSBURB::paGuestSegs).
+ */
+typedef struct XHCIURBSG
+{
+    /** Number of segments used. */
+    uint32_t        cSegs;
+    /** Number of segments allocated. */
+    uint32_t        cSegsMax;
+    /** Number of page mapping locks held. */
+    uint32_t        cLocks;
+    /** The page mapping locks, cSegsMax entries. */
+    PPGMPAGEMAPLOCK paLocks;
+    /** The segments. */
+    RTSGSEG         aSegs[RT_FLEXIBLE_ARRAY];
+} XHCIURBSG;
+/** Pointer to the guest memory backing an URB. */
+typedef XHCIURBSG *PXHCIURBSG;
+
 /**
  * The xHCI controller data associated with each URB.
  */
@@ -1484,6 +1514,8 @@ typedef struct VUSBURBHCIINT
     uint8_t         uSlotID;
     /** Number of Tds in the array. */
     uint32_t        cTRB;
+    /** Mapped guest memory holding the data of a bulk OUT URB, NULL if the data was copied. */
+    PXHCIURBSG      pSg;
 } VUSBURBHCIINT;
 #endif
 
@@ -1568,6 +1600,8 @@ typedef struct sXHCIINTRPTR
     uint64_t                erdp;
     /* Interrupter lock. */
     PDMCRITSECT             lock;
+    /** Interrupt moderation timer, counts IMODC down to zero. */
+    TMTIMERHANDLE           hModTimer;
     /* Internal xHCI non-register state. */
     /** Internal Event Ring enqueue pointer. */
     uint64_t                erep;
@@ -1713,6 +1747,8 @@ typedef struct XHCI
     STAMCOUNTER                     StatIntrsSet;
     /** Interrupts not raised because they were disabled. */
     STAMCOUNTER                     StatIntrsNotSet;
+    /** Interrupts held back by interrupt moderation. */
+    STAMCOUNTER                     StatIntrsModerated;
     /** A pending interrupt was cleared. */
     STAMCOUNTER                     StatIntrsCleared;
     /** Number of TRBs that formed a single control URB. */
@@ -1727,6 +1763,8 @@ typedef struct XHCI
     STAMCOUNTER                     StatUrbSizeData;
     /** Size of an isochronous URB in bytes. */
     STAMCOUNTER                     StatUrbSizeIsoc;
+    /** Bulk OUT URBs handed to VUSB as mapped guest memory. */
+    STAMCOUNTER                     StatUrbsGuestSg;
 
 #ifdef VBOX_WITH_STATISTICS
     /** @name Register access counters.
@@ -1777,6 +1815,12 @@ typedef struct XHCI
     STAMCOUNTER                     StatWrUsbCmd;
     STAMCOUNTER                     StatWrUsbSts;
     STAMCOUNTER                     StatWrUnknown;
+
+    STAMCOUNTER                     StatDoorBellRZ;
+    STAMCOUNTER                     StatDoorBellR3;
+    STAMCOUNTER                     StatWrToR3;
+    STAMCOUNTER                     StatWorkerWakeups;
+    STAMCOUNTER                     StatWorkerWakeupsCoalesced;
     /** @} */
 #endif
 } XHCI;
@@ -2168,9 +2212,12 @@ static void xhciKickWorker(PPDMDEVINS pDevIns, PXHCI pThis, XHCI_JOB enmJob, uin
     if (!ASMAtomicXchgBool(&pThis->fNotificationSent, true))
     {
         LogFlowFunc(("Signal event semaphore\n"));
+        STAM_COUNTER_INC(&pThis->StatWorkerWakeups);
         int rc = PDMDevHlpSUPSemEventSignal(pDevIns, pThis->hEvtProcess);
         AssertRC(rc);
     }
+    else
+        STAM_COUNTER_INC(&pThis->StatWorkerWakeupsCoalesced);
 }
 
 /**
@@ -2241,9 +2288,28 @@ static void xhciSetIntr(PPDMDEVINS pDevIns, PXHCI pThis, PXHCIINTRPTR ip)
         /* If MSI/MSI-X is in use, the IP bit is immediately cleared again. */
         if (xhciIsMSIEnabled(pDevIns->apPciDevs[0]))
             ASMAtomicAndU32(&ip->iman, ~XHCI_IMAN_IP);
+
+        /* Load IMODC from IMODI and start counting down (4.17.2). Events
+         * posted until the counter expires are delivered in one interrupt.
+         */
+        uint32_t const imodi = ip->imod & XHCI_IMOD_IMODI_MASK;
+        if (imodi)
+        {
+            ASMAtomicWriteU32(&ip->imod, (imodi << XHCI_IMOD_IMODC_SHIFT) | imodi);
+            int rc = PDMDevHlpTimerSetNano(pDevIns, ip->hModTimer, (uint64_t)imodi * XHCI_IMOD_UNIT_NS);
+            AssertRC(rc);
+        }
     }
 }
 
+/**
+ * Returns the interrupter's current Interrupt Moderation Counter (IMODC).
+ */
+DECLINLINE(uint16_t) xhciGetIntrModCounter(PXHCIINTRPTR ip)
+{
+    return (uint16_t)((ip->imod & XHCI_IMOD_IMODC_MASK) >> XHCI_IMOD_IMODC_SHIFT);
+}
+
 #ifdef IN_RING3
 
 /**
@@ -2256,7 +2322,7 @@ static void xhciSetIntr(PPDMDEVINS pDevIns, PXHCI pThis, PXHCIINTRPTR ip)
  */
 static void xhciR3SetIntrPending(PPDMDEVINS pDevIns, PXHCI pThis, PXHCIINTRPTR ip)
 {
-    uint16_t        imodc = (ip->imod >> XHCI_IMOD_IMODC_SHIFT) & XHCI_IMOD_IMODC_MASK;
+    uint16_t        imodc = xhciGetIntrModCounter(ip);
 
     Assert(pThis && ip);
     LogFlowFunc(("old IPE: %u, IMODC: %u, EREP: %RGp, EHB: %u\n", ip->ipe, imodc, (RTGCPHYS)ip->erep, !!(ip->erdp & XHCI_ERDP_EHB)));
@@ -2275,6 +2341,8 @@ static void xhciR3SetIntrPending(PPDMDEVINS pDevIns, PXHCI pThis, PXHCIINTRPTR i
             ip->ipe = true;
             if (!(ip->erdp & XHCI_ERDP_EHB) && (imodc == 0))
                 xhciSetIntr(pDevIns, pThis, ip);
+            else if (imodc != 0)
+                STAM_COUNTER_INC(&pThis->StatIntrsModerated);  /* Delivered by xhciR3IntrModTimer. */
         }
     }
 }
@@ -2547,6 +2615,56 @@ typedef DECLCALLBACKPTR(bool, PFNTRBWALKCB,(PPDMDEVINS pDevIns, PXHCI pThis, con
                                             RTGCPHYS GCPhysXfrTRB, void *pvContext));
 
 
+/**
+ * Transfer TRBs prefetched from guest memory by the TRB walker.
+ */
+typedef struct XHCI_TRB_CACHE
+{
+    /** Guest physical address of the first cached TRB. */
+    RTGCPHYS        GCPhysFirst;
+    /** Number of valid TRBs in aTrbs. */
+    uint32_t        cTrbs;
+    /** The cached TRBs. */
+    XHCI_XFER_TRB   aTrbs[XHCI_TRB_PREFETCH];
+} XHCI_TRB_CACHE;
+
+
+/**
+ * Fetch a transfer TRB, reading ahead up to XHCI_TRB_PREFETCH TRBs (but not
+ * past the end of the guest page) when the TRB isn't cached yet.
+ *
+ * A cached TRB whose cycle bit doesn't match the DCS is re-read, since the
+ * guest may have produced it after the prefetch.
+ *
+ * @param   pDevIns         The device instance.
+ * @param   pCache          The walker's TRB cache.
+ * @param   GCPhysXfrTRB    Physical address of the TRB.
+ * @param   dcs             The expected cycle state.
+ * @param   pXferTRB        Where to return the TRB.
+ */
+static void xhciR3FetchXferTrb(PPDMDEVINS pDevIns, XHCI_TRB_CACHE *pCache, RTGCPHYS GCPhysXfrTRB, bool dcs,
+                               XHCI_XFER_TRB *pXferTRB)
+{
+    RTGCPHYS const offCache = GCPhysXfrTRB - pCache->GCPhysFirst;
+    if (   GCPhysXfrTRB >= pCache->GCPhysFirst
+        && offCache < pCache->cTrbs * sizeof(XHCI_XFER_TRB)
+        && !(offCache & (sizeof(XHCI_XFER_TRB) - 1)))
+    {
+        XHCI_XFER_TRB *pCached = &pCache->aTrbs[offCache / sizeof(XHCI_XFER_TRB)];
+        if ((bool)pCached->gen.cycle != dcs)
+            PDMDevHlpPCIPhysReadMeta(pDevIns, GCPhysXfrTRB, pCached, sizeof(*pCached));
+        *pXferTRB = *pCached;
+        return;
+    }
+
+    uint32_t const cbToPageEnd = GUEST_PAGE_SIZE - (uint32_t)(GCPhysXfrTRB & GUEST_PAGE_OFFSET_MASK);
+    pCache->cTrbs       = RT_MAX(RT_MIN(cbToPageEnd / sizeof(XHCI_XFER_TRB), RT_ELEMENTS(pCache->aTrbs)), 1);
+    pCache->GCPhysFirst = GCPhysXfrTRB;
+    PDMDevHlpPCIPhysReadMeta(pDevIns, GCPhysXfrTRB, &pCache->aTrbs[0], pCache->cTrbs * sizeof(XHCI_XFER_TRB));
+    *pXferTRB = pCache->aTrbs[0];
+}
+
+
 /**
  * Walk a chain of TRBs which comprise a single TD.
  *
@@ -2572,10 +2690,13 @@ static int xhciR3WalkXferTrbChain(PPDMDEVINS pDevIns, PXHCI pThis, uint64_t uTRP
     bool            dcs;
     int             rc = VINF_SUCCESS;
     unsigned        cTrbs = 0;
+    XHCI_TRB_CACHE  TrbCache;
 
     AssertPtr(pvContext);
     AssertPtr(pTREP);
     Assert(uTRP);
+    TrbCache.GCPhysFirst = NIL_RTGCPHYS;
+    TrbCache.cTrbs       = 0;
 
     /* Find the transfer TRB address and the DCS. */
     GCPhysXfrTRB = uTRP & XHCI_TRDP_ADDR_MASK;
@@ -2583,8 +2704,8 @@ static int xhciR3WalkXferTrbChain(PPDMDEVINS pDevIns, PXHCI pThis, uint64_t uTRP
     LogFlowFunc(("Walking Transfer Ring, TREP:%RGp DCS=%u\n", GCPhysXfrTRB, dcs));
 
     do {
-        /* Fetch the transfer TRB. */
-        PDMDevHlpPCIPhysReadMeta(pDevIns, GCPhysXfrTRB, &XferTRB, sizeof(XferTRB));
+        /* Fetch the transfer TRB, prefetching the ones following it. */
+        xhciR3FetchXferTrb(pDevIns, &TrbCache, GCPhysXfrTRB, dcs, &XferTRB);
 
         if ((bool)XferTRB.gen.cycle == dcs)
         {
@@ -2663,6 +2784,8 @@ typedef struct {
     PVUSBURB    pUrb;
     uint32_t    uXferPos;
     unsigned    cTRB;
+    /** Where to collect mapped guest memory instead of copying, optional. */
+    PXHCIURBSG  pSg;
 } XHCI_CTX_XFER_SUBMIT;
 
 
@@ -2733,6 +2856,105 @@ xhciR3WalkDataTRBsProbe(PPDMDEVINS pDevIns, PXHCI pThis, const XHCI_XFER_TRB *pX
 }
 
 
+/**
+ * Appends a segment to the guest memory list of an URB, merging it with the
+ * previous one if they are adjacent.
+ *
+ * @param   pSg         The guest memory list.
+ * @param   pv          Start of the data.
+ * @param   cb          Size of the data.
+ */
+static void xhciR3UrbSgAppend(PXHCIURBSG pSg, const void *pv, size_t cb)
+{
+    if (   pSg->cSegs
+        && (uint8_t *)pSg->aSegs[pSg->cSegs - 1].pvSeg + pSg->aSegs[pSg->cSegs - 1].cbSeg == (uint8_t *)pv)
+        pSg->aSegs[pSg->cSegs - 1].cbSeg += cb;
+    else
+    {
+        AssertReturnVoid(pSg->cSegs < pSg->cSegsMax);
+        pSg->aSegs[pSg->cSegs].pvSeg = (void *)pv;
+        pSg->aSegs[pSg->cSegs].cbSeg = cb;
+        pSg->cSegs++;
+    }
+}
+
+
+/**
+ * Maps the guest memory of a data TRB page by page and appends it to the guest
+ * memory list of the URB being submitted.
+ *
+ * Memory which can't be mapped (MMIO and such) is copied into the URB buffer.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pCtx        The submit context, uXferPos is the URB offset of the data.
+ * @param   GCPhys      Guest physical address of the data.
+ * @param   cb          Size of the data.
+ */
+static void xhciR3UrbSgAddGuestData(PPDMDEVINS pDevIns, XHCI_CTX_XFER_SUBMIT *pCtx, RTGCPHYS GCPhys, uint32_t cb)
+{
+    PXHCIURBSG pSg     = pCtx->pSg;
+    uint32_t   offData = pCtx->uXferPos;
+
+    while (cb)
+    {
+        uint32_t const cbPage = RT_MIN(cb, GUEST_PAGE_SIZE - (uint32_t)(GCPhys & GUEST_PAGE_OFFSET_MASK));
+        void const    *pv     = NULL;
+        int rc = PDMDevHlpPCIPhysGCPhys2CCPtrReadOnly(pDevIns, NULL /* pPciDev */, GCPhys, 0 /* fFlags */, &pv,
+                                                      &pSg->paLocks[pSg->cLocks]);
+        if (RT_SUCCESS(rc))
+            pSg->cLocks++;
+        else
+        {
+            PDMDevHlpPCIPhysReadUser(pDevIns, GCPhys, pCtx->pUrb->pbData + offData, cbPage);
+            pv = pCtx->pUrb->pbData + offData;
+        }
+        xhciR3UrbSgAppend(pSg, pv, cbPage);
+
+        GCPhys  += cbPage;
+        offData += cbPage;
+        cb      -= cbPage;
+    }
+}
+
+
+/**
+ * Allocates the guest memory list for a bulk OUT URB.
+ *
+ * @returns Pointer to the list, NULL if out of memory.
+ * @param   cbData      Size of the TD.
+ * @param   cTRB        Number of TRBs in the TD.
+ */
+static PXHCIURBSG xhciR3UrbSgAlloc(uint32_t cbData, uint32_t cTRB)
+{
+    /* Every TRB can start and end in the middle of a page. */
+    uint32_t const cSegsMax = (cbData >> GUEST_PAGE_SHIFT) + 2 * cTRB + 1;
+    size_t   const cbSegs   = RT_UOFFSETOF_DYN(XHCIURBSG, aSegs[cSegsMax]);
+    PXHCIURBSG pSg = (PXHCIURBSG)RTMemAlloc(RT_ALIGN_Z(cbSegs, 8) + cSegsMax * sizeof(PGMPAGEMAPLOCK));
+    if (pSg)
+    {
+        pSg->cSegs    = 0;
+        pSg->cSegsMax = cSegsMax;
+        pSg->cLocks   = 0;
+        pSg->paLocks  = (PPGMPAGEMAPLOCK)((uint8_t *)pSg + RT_ALIGN_Z(cbSegs, 8));
+    }
+    return pSg;
+}
+
+
+/**
+ * Releases the guest memory list of an URB.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pSg         The guest memory list.
+ */
+static void xhciR3UrbSgFree(PPDMDEVINS pDevIns, PXHCIURBSG pSg)
+{
+    for (uint32_t i = 0; i < pSg->cLocks; i++)
+        PDMDevHlpPhysReleasePageMappingLock(pDevIns, &pSg->paLocks[i]);
+    RTMemFree(pSg);
+}
+
+
 /**
  * @callback_method_impl{PFNTRBWALKCB,
  *      Copy data from a TD (TRB chain) into the corresponding TD. OUT direction only.}
@@ -2773,6 +2995,13 @@ xhciR3WalkDataTRBsSubmit(PPDMDEVINS pDevIns, PXHCI pThis, const XHCI_XFER_TRB *p
                     Assert(uXferLen >= 1 && uXferLen <= 8);
                     Log2(("Copying %u bytes to URB offset %u (immediate data)\n", uXferLen, pCtx->uXferPos));
                     memcpy(pCtx->pUrb->pbData + pCtx->uXferPos, pXferTRB, uXferLen);
+                    if (pCtx->pSg)
+                        xhciR3UrbSgAppend(pCtx->pSg, pCtx->pUrb->pbData + pCtx->uXferPos, uXferLen);
+                }
+                else if (pCtx->pSg)
+                {
+                    Log2(("Mapping %u bytes at URB offset %u (from %RGp)\n", uXferLen, pCtx->uXferPos, pXferTRB->norm.data_ptr));
+                    xhciR3UrbSgAddGuestData(pDevIns, pCtx, pXferTRB->norm.data_ptr, uXferLen);
                 }
                 else
                 {
@@ -3044,6 +3273,15 @@ static DECLCALLBACK(void) xhciR3RhXferCompletion(PVUSBIROOTHUBPORT pInterface, P
     uint8_t         cc       = XHCI_TCC_SUCCESS;
     uint8_t         uEpDCI;
 
+    /* The device is done with the guest memory the data was sent from. */
+    if (pUrb->pHci->pSg)
+    {
+        xhciR3UrbSgFree(pDevIns, pUrb->pHci->pSg);
+        pUrb->pHci->pSg   = NULL;
+        pUrb->cGuestSegs  = 0;
+        pUrb->paGuestSegs = NULL;
+    }
+
     /* Check for URBs completed synchronously as part of xHCI command execution.
      * The URB will have zero cTRB as it's not associated with a TD.
      */
@@ -3413,16 +3651,30 @@ static int xhciR3QueueDataTD(PPDMDEVINS pDevIns, PXHCI pThis, PXHCICC pThisCC, P
     /// @todo Cross check that the EP type corresponds to direction. Probably
     //should check when configuring device?
     pUrb->pHci->uSlotID  = uSlotID;
+    pUrb->pHci->pSg      = NULL;
 
-    /* For OUT transfers, copy the TD data into the URB. */
+    /* For OUT transfers, copy the TD data into the URB. Big bulk transfers are described
+     * by mapped guest memory instead, so devices which can deal with that avoid the copy.
+     */
     if (pUrb->enmDir == VUSBDIRECTION_OUT)
     {
         ctxSubmit.pUrb     = pUrb;
         ctxSubmit.uXferPos = 0;
         ctxSubmit.cTRB     = 0;
+        ctxSubmit.pSg      =    enmType == VUSBXFERTYPE_BULK
+                             && ctxProbe.uXferLen >= XHCI_GUEST_SG_MIN_SIZE
+                           ? xhciR3UrbSgAlloc(ctxProbe.uXferLen, ctxProbe.cTRB) : NULL;
         xhciR3WalkXferTrbChain(pDevIns, pThis, pEpCtx->trep, xhciR3WalkDataTRBsSubmit, &ctxSubmit, &uTREP);
         Assert(ctxProbe.cTRB == ctxSubmit.cTRB);
         ctxProbe.cTRB = ctxSubmit.cTRB;
+
+        if (ctxSubmit.pSg)
+        {
+            pUrb->pHci->pSg   = ctxSubmit.pSg;
+            pUrb->cGuestSegs  = ctxSubmit.pSg->cSegs;
+            pUrb->paGuestSegs = &ctxSubmit.pSg->aSegs[0];
+            STAM_COUNTER_INC(&pThis->StatUrbsGuestSg);
+        }
     }
 
     /* If only completing a fragment, remember the TRB count and increase
@@ -3446,12 +3698,16 @@ static int xhciR3QueueDataTD(PPDMDEVINS pDevIns, PXHCI pThis, PXHCICC pThisCC, P
     STAM_COUNTER_ADD(&pThis->StatUrbSizeData, pUrb->cbData);
     Log(("%s: xhciR3QueueDataTD: Addr=%u, EndPt=%u, enmDir=%u cbData=%u\n",
          pUrb->pszDesc, pUrb->DstAddress, pUrb->EndPt, pUrb->enmDir, pUrb->cbData));
+    PXHCIURBSG pSg = pUrb->pHci->pSg; /* The URB is freed without completion if submitting fails. */
     RTCritSectLeave(&pThisCC->CritSectThrd);
     rc = VUSBIRhSubmitUrb(pRh->pIRhConn, pUrb, &pRh->Led);
     RTCritSectEnter(&pThisCC->CritSectThrd);
     if (RT_SUCCESS(rc))
         return VINF_SUCCESS;
 
+    if (pSg)
+        xhciR3UrbSgFree(pDevIns, pSg);
+
     /* Failure cleanup. Can happen if we're still resetting the device or out of resources,
      * or the user just ripped out the device.
      */
@@ -3560,6 +3816,7 @@ static int xhciR3QueueIsochTD(PPDMDEVINS pDevIns, PXHCI pThis, PXHCICC pThisCC,
         pUrb->enmStatus      = VUSBSTATUS_OK;
         pUrb->cIsocPkts      = cIsoPackets;
         pUrb->pHci->uSlotID  = uSlotID;
+        pUrb->pHci->pSg      = NULL;
         pUrb->pHci->cTRB     = ctxProbe.cTRB;
 
         /* If TRB says so or if there are multiple packets per interval, don't even
@@ -3742,6 +3999,7 @@ static int xhciR3QueueControlTD(PPDMDEVINS pDevIns, PXHCI pThis, PXHCICC pThisCC
     pUrb->fShortNotOk    = false;       /* We detect short packets ourselves. */
     pUrb->enmStatus      = VUSBSTATUS_OK;
     pUrb->pHci->uSlotID  = uSlotID;
+    pUrb->pHci->pSg      = NULL;
 
     /* For OUT/SETUP transfers, copy the TD data into the URB. */
     if (pUrb->enmDir == VUSBDIRECTION_OUT || pUrb->enmDir == VUSBDIRECTION_SETUP)
@@ -4048,6 +4306,7 @@ static bool xhciR3IssueSetAddress(PXHCICC pThisCC, uint8_t uSlotID, uint8_t uDev
     pUrb->fShortNotOk     = true;
     pUrb->enmStatus       = VUSBSTATUS_OK;
     pUrb->pHci->uSlotID   = uSlotID;
+    pUrb->pHci->pSg       = NULL;
     pUrb->pHci->cTRB      = 0;
 
     /* Build the request. */
@@ -4081,6 +4340,7 @@ static bool xhciR3IssueSetAddress(PXHCICC pThisCC, uint8_t uSlotID, uint8_t uDev
     pUrb->fShortNotOk     = true;
     pUrb->enmStatus       = VUSBSTATUS_OK;
     pUrb->pHci->uSlotID   = uSlotID;
+    pUrb->pHci->pSg       = NULL;
     pUrb->pHci->cTRB      = 0;
 
     /* Submit the setup URB. */
@@ -6610,12 +6870,17 @@ static VBOXSTRICTRC HcIntrMod_r(PPDMDEVINS pDevIns, PXHCI pThis, PXHCIINTRPTR ip
  */
 static VBOXSTRICTRC HcIntrMod_w(PPDMDEVINS pDevIns, PXHCI pThis, PXHCIINTRPTR ip, uint32_t val)
 {
-    RT_NOREF(pDevIns, pThis);
     STAM_COUNTER_INC(&pThis->StatWrIntrMod);
 
-    /// @todo Does writing a zero to IMODC/IMODI potentially trigger
-    /// an interrupt?
     ip->imod = val;
+
+    /* The guest may load IMODC directly. Count it down from the written
+     * value; the timer delivers any interrupt held back in the meantime,
+     * which also covers writing zero to a running counter.
+     */
+    int rc = PDMDevHlpTimerSetNano(pDevIns, ip->hModTimer,
+                                   RT_MAX(xhciGetIntrModCounter(ip), 1) * (uint64_t)XHCI_IMOD_UNIT_NS);
+    AssertRC(rc);
     return VINF_SUCCESS;
 }
 
@@ -6823,6 +7088,12 @@ static VBOXSTRICTRC HcEvtRingDeqPtrLo_w(PPDMDEVINS pDevIns, PXHCI pThis, PXHCIIN
             Log2(("Event Ring not empty, ERDP not advanced, not re-triggering interrupt!\n"));
             ip->ipe = false;
         }
+        else if (xhciGetIntrModCounter(ip) != 0)
+        {
+            /* The moderation timer will re-trigger the interrupt when IMODC expires. */
+            Log2(("Event Ring not empty, interrupt deferred until IMODC expires\n"));
+            STAM_COUNTER_INC(&pThis->StatIntrsModerated);
+        }
         else
         {
             Log2(("Event Ring not empty, re-triggering interrupt\n"));
@@ -7192,6 +7463,8 @@ static DECLCALLBACK(VBOXSTRICTRC) xhciMmioWrite(PPDMDEVINS pDevIns, void *pvUser
         iReg = (offReg - XHCI_DOORBELL_OFFSET) >> 2;
         if ((pThis->cmd & XHCI_CMD_RS) && iReg < XHCI_NDS)
         {
+            /* Doorbells never need ring-3, they just flag work and kick the worker thread. */
+            STAM_COUNTER_INC(&pThis->CTX_SUFF_Z(StatDoorBell));
             if (iReg == 0)
             {
                 /* DB0 aka Command Ring. */
@@ -7294,6 +7567,10 @@ static DECLCALLBACK(VBOXSTRICTRC) xhciMmioWrite(PPDMDEVINS pDevIns, void *pvUser
         Log(("xHCI: Trying to write unimplemented or R/O register at offset %04X!\n", offReg));
         rcStrict = VINF_SUCCESS;
     }
+#ifndef IN_RING3
+    if (rcStrict == VINF_IOM_R3_MMIO_WRITE)
+        STAM_COUNTER_INC(&pThis->StatWrToR3);
+#endif
 
     return rcStrict;
 }
@@ -7301,6 +7578,28 @@ static DECLCALLBACK(VBOXSTRICTRC) xhciMmioWrite(PPDMDEVINS pDevIns, void *pvUser
 
 #ifdef IN_RING3
 
+/**
+ * @callback_method_impl{FNTMTIMERDEV,
+ *      Interrupt moderation (IMODC) timer for an interrupter. See 4.17.2.}
+ */
+static DECLCALLBACK(void) xhciR3IntrModTimer(PPDMDEVINS pDevIns, TMTIMERHANDLE hTimer, void *pvUser)
+{
+    PXHCI           pThis = PDMDEVINS_2_DATA(pDevIns, PXHCI);
+    PXHCIINTRPTR    ip    = (PXHCIINTRPTR)pvUser;
+    RT_NOREF(hTimer);
+    LogFlow(("xhciR3IntrModTimer: interrupter %u\n", ip->index));
+
+    int const rcLock = PDMDevHlpCritSectEnter(pDevIns, &ip->lock, VERR_IGNORED);
+    PDM_CRITSECT_RELEASE_ASSERT_RC_DEV(pDevIns, &ip->lock, rcLock);
+
+    /* IMODC reached zero: deliver whatever accumulated while it was counting. */
+    ASMAtomicAndU32(&ip->imod, ~XHCI_IMOD_IMODC_MASK);
+    if (ip->ipe && !(ip->erdp & XHCI_ERDP_EHB))
+        xhciSetIntr(pDevIns, pThis, ip);
+
+    PDMDevHlpCritSectLeave(pDevIns, &ip->lock);
+}
+
 /**
  * @callback_method_impl{FNTMTIMERDEV,
  *      Provides periodic MFINDEX wrap events. See 4.14.2.}
@@ -7492,6 +7791,8 @@ static DECLCALLBACK(int) xhciR3LoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uin
             pHlp->pfnSSMGetU16(pSSM, &pThis->aInterrupters[iIntr].trb_count);
             pHlp->pfnSSMGetBool(pSSM, &pThis->aInterrupters[iIntr].evtr_pcs);
             pHlp->pfnSSMGetBool(pSSM, &pThis->aInterrupters[iIntr].ipe);
+            /* The moderation timer isn't saved; let any running IMODC expire right away. */
+            pThis->aInterrupters[iIntr].imod &= ~XHCI_IMOD_IMODC_MASK;
         }
         else
         {
@@ -8155,6 +8456,17 @@ static DECLCALLBACK(int) xhciR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
                               TMTIMER_FLAGS_NO_CRIT_SECT | TMTIMER_FLAGS_RING0, "xHCI MFINDEX Wrap", &pThis->hWrapTimer);
     AssertRCReturn(rc, rc);
 
+    /*
+     * Create the interrupt moderation timers.
+     */
+    for (unsigned i = 0; i < RT_ELEMENTS(pThis->aInterrupters); ++i)
+    {
+        rc = PDMDevHlpTimerCreate(pDevIns, TMCLOCK_VIRTUAL, xhciR3IntrModTimer, &pThis->aInterrupters[i],
+                                  TMTIMER_FLAGS_NO_CRIT_SECT | TMTIMER_FLAGS_RING0, "xHCI IMOD",
+                                  &pThis->aInterrupters[i].hModTimer);
+        AssertRCReturn(rc, rc);
+    }
+
     /*
      * Set up the worker thread.
      */
@@ -8184,6 +8496,7 @@ static DECLCALLBACK(int) xhciR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntrsPending,  STAMTYPE_COUNTER, "IntrsPending",  STAMUNIT_OCCURENCES, "Requests to set the IP bit.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntrsSet,      STAMTYPE_COUNTER, "IntrsSet",      STAMUNIT_OCCURENCES, "Actual interrupts delivered.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntrsNotSet,   STAMTYPE_COUNTER, "IntrsNotSet",   STAMUNIT_OCCURENCES, "Interrupts not delivered/disabled.");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntrsModerated, STAMTYPE_COUNTER, "IntrsModerated", STAMUNIT_OCCURENCES, "Interrupts deferred by interrupt moderation (IMOD).");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatIntrsCleared,  STAMTYPE_COUNTER, "IntrsCleared",  STAMUNIT_OCCURENCES, "Interrupts cleared by guest.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatTRBsPerCtlUrb, STAMTYPE_COUNTER, "UrbTrbsCtl",    STAMUNIT_COUNT,      "TRBs per one control URB.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatTRBsPerDtaUrb, STAMTYPE_COUNTER, "UrbTrbsDta",    STAMUNIT_COUNT,      "TRBs per one data (bulk/intr) URB.");
@@ -8191,6 +8504,7 @@ static DECLCALLBACK(int) xhciR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatUrbSizeCtrl,   STAMTYPE_COUNTER, "UrbSizeCtl",    STAMUNIT_COUNT,      "Size of a control URB in bytes.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatUrbSizeData,   STAMTYPE_COUNTER, "UrbSizeDta",    STAMUNIT_COUNT,      "Size of a data (bulk/intr) URB in bytes.");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatUrbSizeIsoc,   STAMTYPE_COUNTER, "UrbSizeIso",    STAMUNIT_COUNT,      "Size of an isochronous URB in bytes.");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatUrbsGuestSg,   STAMTYPE_COUNTER, "UrbsGuestSg",   STAMUNIT_COUNT,      "Bulk OUT URBs submitted as mapped guest memory.");
 
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatRdCaps,              STAMTYPE_COUNTER, "Regs/RdCaps",            STAMUNIT_COUNT, "");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatRdCmdRingCtlHi,      STAMTYPE_COUNTER, "Regs/RdCmdRingCtlHi",    STAMUNIT_COUNT, "");
@@ -8226,6 +8540,11 @@ static DECLCALLBACK(int) xhciR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFG
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWrDevNotifyCtrl,     STAMTYPE_COUNTER, "Regs/WrDevNotifyCtrl",   STAMUNIT_COUNT, "");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWrDoorBell0,         STAMTYPE_COUNTER, "Regs/WrDoorBell0",       STAMUNIT_COUNT, "");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWrDoorBellN,         STAMTYPE_COUNTER, "Regs/WrDoorBellN",       STAMUNIT_COUNT, "");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDoorBellRZ,          STAMTYPE_COUNTER, "Regs/DoorBellRZ",        STAMUNIT_COUNT, "Doorbell writes handled in R0/RC");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatDoorBellR3,          STAMTYPE_COUNTER, "Regs/DoorBellR3",        STAMUNIT_COUNT, "Doorbell writes handled in R3");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWrToR3,              STAMTYPE_COUNTER, "Regs/WrToR3",            STAMUNIT_COUNT, "Register writes deferred from R0/RC to R3");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWorkerWakeups,       STAMTYPE_COUNTER, "WorkerWakeups",          STAMUNIT_COUNT, "Worker thread wakeups");
+    PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWorkerWakeupsCoalesced, STAMTYPE_COUNTER, "WorkerWakeupsCoalesced", STAMUNIT_COUNT, "Worker thread kicks coalesced with a pending wakeup");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWrEvtRingDeqPtrHi,   STAMTYPE_COUNTER, "Regs/WrEvtRingDeqPtrHi", STAMUNIT_COUNT, "");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWrEvtRingDeqPtrLo,   STAMTYPE_COUNTER, "Regs/WrEvtRingDeqPtrLo", STAMUNIT_COUNT, "");
     PDMDevHlpSTAMRegister(pDevIns, &pThis->StatWrEvtRsTblBaseHi,    STAMTYPE_COUNTER, "Regs/WrEvtRsTblBaseHi",  STAMUNIT_COUNT, "");
@@ -342,6 +342,77 @@ static const char *vusbGetSpeedString(VUSBSPEED enmSpeed)
 }
 
 
+#ifdef VBOX_WITH_STATISTICS
+/**
+ * Registers a single URB latency histogram.
+ *
+ * @param   pThis       The roothub.
+ * @param   pLatency    The latency histogram to register.
+ * @param   pszDesc     The description.
+ * @param   pszPrefix   The sample name prefix.
+ */
+static void vusbHubLatencyRegister(PVUSBROOTHUB pThis, PVUSBURBLATENCY pLatency, const char *pszDesc, const char *pszPrefix)
+{
+    static const char * const s_apszBuckets[VUSB_URB_LATENCY_BUCKETS] =
+    { "Lt16us", "Lt64us", "Lt256us", "Lt1ms", "Lt4ms", "Lt16ms", "Lt64ms", "Ge64ms" };
+
+    PDMDrvHlpSTAMRegisterF(pThis->pDrvIns, &pLatency->Prof, STAMTYPE_PROFILE, STAMVISIBILITY_USED, STAMUNIT_NS_PER_CALL,
+                           pszDesc, "%s", pszPrefix);
+    for (unsigned i = 0; i < RT_ELEMENTS(pLatency->aBuckets); i++)
+        PDMDrvHlpSTAMRegisterF(pThis->pDrvIns, &pLatency->aBuckets[i], STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                               "URBs in this latency bucket.", "%s/%s", pszPrefix, s_apszBuckets[i]);
+}
+
+
+/**
+ * Registers the per endpoint URB latency statistics of a device being attached.
+ *
+ * The samples are only visible once used, so the endpoints the device doesn't
+ * have don't clutter the statistics.
+ *
+ * @param   pThis       The roothub.
+ * @param   pDev        The device.
+ * @thread  EMT
+ */
+static void vusbHubLatencyStatsRegister(PVUSBROOTHUB pThis, PVUSBDEV pDev)
+{
+    RT_ZERO(pDev->aStatLatency);
+
+    for (unsigned iEp = 0; iEp < RT_ELEMENTS(pDev->aStatLatency); iEp++)
+        for (unsigned iDir = 0; iDir < RT_ELEMENTS(pDev->aStatLatency[0]); iDir++)
+        {
+            PVUSBEPLATENCYSTATS pStats = &pDev->aStatLatency[iEp][iDir];
+            char szPrefix[80];
+            RTStrPrintf(szPrefix, sizeof(szPrefix), "/VUSB/%d/Latency/Port%d/Ep%u%s", pThis->pDrvIns->iInstance,
+                        pDev->i16Port, iEp, iDir ? "In" : "Out");
+            size_t const cchPrefix = strlen(szPrefix);
+
+            RTStrCopy(&szPrefix[cchPrefix], sizeof(szPrefix) - cchPrefix, "/Queue");
+            vusbHubLatencyRegister(pThis, &pStats->Queue,      "Guest submit until handed to the device.", szPrefix);
+            RTStrCopy(&szPrefix[cchPrefix], sizeof(szPrefix) - cchPrefix, "/Host");
+            vusbHubLatencyRegister(pThis, &pStats->Host,       "Handed to the device until reaped.", szPrefix);
+            RTStrCopy(&szPrefix[cchPrefix], sizeof(szPrefix) - cchPrefix, "/Completion");
+            vusbHubLatencyRegister(pThis, &pStats->Completion, "Reaped until completed to the guest.", szPrefix);
+        }
+}
+
+
+/**
+ * Deregisters the per endpoint URB latency statistics of a device.
+ *
+ * @param   pThis       The roothub.
+ * @param   iPort       The port the device was attached to.
+ * @thread  EMT
+ */
+static void vusbHubLatencyStatsDeregister(PVUSBROOTHUB pThis, int iPort)
+{
+    char szPrefix[64];
+    RTStrPrintf(szPrefix, sizeof(szPrefix), "/VUSB/%d/Latency/Port%d/", pThis->pDrvIns->iInstance, iPort);
+    PDMDrvHlpSTAMDeregisterByPrefix(pThis->pDrvIns, szPrefix);
+}
+#endif /* VBOX_WITH_STATISTICS */
+
+
 /**
  * Attaches a device to a specific hub.
  *
@@ -382,6 +453,10 @@ static int vusbHubAttach(PVUSBROOTHUB pThis, PVUSBDEV pDev)
          * Call the HCI attach routine and let it have its say before the device is
          * linked into the device list of this hub.
          */
+#ifdef VBOX_WITH_STATISTICS
+        vusbHubLatencyStatsRegister(pThis, pDev);
+#endif
+
         VUSBSPEED enmSpeed = pDev->IDevice.pfnGetSpeed(&pDev->IDevice);
         rc = pThis->pIRhPort->pfnAttach(pThis->pIRhPort, iPort, enmSpeed);
         if (RT_SUCCESS(rc))
@@ -397,6 +472,9 @@ static int vusbHubAttach(PVUSBROOTHUB pThis, PVUSBDEV pDev)
         pThis->apDevByPort[iPort] = NULL;
         RTCritSectLeave(&pThis->CritSectDevices);
 
+#ifdef VBOX_WITH_STATISTICS
+        vusbHubLatencyStatsDeregister(pThis, iPort);
+#endif
         vusbDevDetach(pDev);
     }
 
@@ -454,6 +532,10 @@ static int vusbHubDetach(PVUSBROOTHUB pThis, PVUSBDEV pDev)
     /* Cancel all in-flight URBs from this device. */
     vusbDevCancelAllUrbs(pDev, true);
 
+#ifdef VBOX_WITH_STATISTICS
+    vusbHubLatencyStatsDeregister(pThis, (int)uPort);
+#endif
+
     /* Free resources. */
     vusbDevDetach(pDev);
     return VINF_SUCCESS;
@@ -476,6 +558,7 @@ static DECLCALLBACK(int) vusbPDMHubAttachDevice(PPDMDRVINS pDrvIns, PPDMUSBINS p
     int rc = vusbDevInit(pDev, pUsbIns, pszCaptureFilename);
     if (RT_SUCCESS(rc))
     {
+        pDev->UrbPool.pStats = &pThis->UrbPoolStats;
         pUsbIns->pvVUsbDev2 = pDev;
         rc = vusbHubAttach(pThis, pDev);
         if (RT_SUCCESS(rc))
@@ -938,6 +1021,22 @@ static DECLCALLBACK(int) vusbRhSubmitUrb(PVUSBIROOTHUBCONNECTOR pInterface, PVUS
     }
 #endif
 
+    /*
+     * Bulk OUT data may be described by mapped guest memory instead of the URB buffer.
+     * Copy it over unless the device can send it from there directly. Sniffers record
+     * the URB buffer, so they need the copy too.
+     */
+    if (pUrb->cGuestSegs)
+    {
+        PVUSBDEV pDev = pUrb->pVUsb->pDev;
+        if (   !pDev
+            || !pDev->pUsbIns
+            || !(pDev->pUsbIns->pReg->fFlags & PDM_USBREG_GUEST_SG_URBS)
+            || pDev->hSniffer != VUSBSNIFFER_NIL
+            || pRh->hSniffer != VUSBSNIFFER_NIL)
+            VUSBUrbGuestSegsToData(pUrb);
+    }
+
     /* If there is a sniffer on the roothub record the URB there. */
     if (pRh->hSniffer != VUSBSNIFFER_NIL)
     {
@@ -1716,7 +1815,7 @@ static DECLCALLBACK(int) vusbRhConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     pThis->fHcVersions = pThis->pIRhPort->pfnGetUSBVersions(pThis->pIRhPort);
     Log(("vusbRhConstruct: fHcVersions=%u\n", pThis->fHcVersions));
 
-    rc = vusbUrbPoolInit(&pThis->UrbPool);
+    rc = vusbUrbPoolInit(&pThis->UrbPool, &pThis->UrbPoolStats);
     if (RT_FAILURE(rc))
         return rc;
 
@@ -1881,6 +1980,12 @@ static DECLCALLBACK(int) vusbRhConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
 #endif
     PDMDrvHlpSTAMRegisterF(pDrvIns, (void *)&pThis->UrbPool.cUrbsInPool, STAMTYPE_U32, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT, "The number of URBs in the pool.",
                            "/VUSB/%d/cUrbsInPool",             pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, (void *)&pThis->UrbPoolStats.cHitsLockFree, STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES, "URB buffers taken from the lock-free cache.",
+                           "/VUSB/%d/UrbPool/HitsLockFree",    pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, (void *)&pThis->UrbPoolStats.cHits,         STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES, "URB buffers taken from the free lists.",
+                           "/VUSB/%d/UrbPool/Hits",            pDrvIns->iInstance);
+    PDMDrvHlpSTAMRegisterF(pDrvIns, (void *)&pThis->UrbPoolStats.cMisses,       STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES, "URB buffers which had to be allocated.",
+                           "/VUSB/%d/UrbPool/Misses",          pDrvIns->iInstance);
 
     return VINF_SUCCESS;
 }
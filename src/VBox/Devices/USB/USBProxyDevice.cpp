@@ -733,6 +733,8 @@ static DECLCALLBACK(int) usbProxyDevUrbQueue(PPDMUSBINS pUsbIns, PVUSBURB pUrb)
 {
     int rc = VINF_SUCCESS;
     PUSBPROXYDEV pProxyDev = PDMINS_2_DATA(pUsbIns, PUSBPROXYDEV);
+    if (pUrb->cGuestSegs && !pProxyDev->fGuestSgUrbs)
+        VUSBUrbGuestSegsToData(pUrb);
     rc = pProxyDev->pOps->pfnUrbQueue(pProxyDev, pUrb);
     if (RT_FAILURE(rc))
         return pProxyDev->fDetached
@@ -1272,7 +1274,7 @@ const PDMUSBREG g_UsbDevProxy =
     /* pszDescription */
     "USB Proxy Device.",
     /* fFlags */
-    0,
+    PDM_USBREG_GUEST_SG_URBS,
     /* cMaxInstances */
     ~0U,
     /* cbInstance */
@@ -233,6 +233,9 @@ typedef struct USBPROXYDEV
     /** Whether the device has been detached.
      * This is hack for making PDMUSBREG::pfnUsbQueue return the right status code. */
     bool                fDetached;
+    /** Whether the backend sends bulk OUT data straight from VUSBURB::paGuestSegs.
+     * Set by the backend in pfnOpen, the data is copied into VUSBURB::pbData otherwise. */
+    bool                fGuestSgUrbs;
     /** Backend specific data, the size is stored in pOps::cbBackend. */
     void               *pvInstanceDataR3;
 
@@ -1824,7 +1824,7 @@ int vusbDevInit(PVUSBDEV pDev, PPDMUSBINS pUsbIns, const char *pszCaptureFilenam
     AssertRCReturn(rc, rc);
 
     /* Create the URB pool. */
-    rc = vusbUrbPoolInit(&pDev->UrbPool);
+    rc = vusbUrbPoolInit(&pDev->UrbPool, NULL /*pStats - set when attached to a hub*/);
     AssertRCReturn(rc, rc);
 
     /* Setup request queue executing synchronous tasks on the I/O thread. */
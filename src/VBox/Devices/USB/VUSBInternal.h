@@ -111,8 +111,10 @@ typedef struct VUSBURBVUSBINT
      * @param   pUrb    The URB.
      */
     DECLCALLBACKMEMBER(void, pfnFree,(PVUSBURB pUrb));
-    /** Submit timestamp. (logging only) */
+    /** Submit timestamp. (logging and statistics only) */
     uint64_t        u64SubmitTS;
+    /** Timestamp when the URB was handed to the device. (statistics only) */
+    uint64_t        u64QueueTS;
 } VUSBURBVUSBINT;
 
 /**
@@ -203,25 +205,86 @@ typedef VUSBINTERFACESTATE *PVUSBINTERFACESTATE;
 typedef const VUSBINTERFACESTATE *PCVUSBINTERFACESTATE;
 
 
+/** Number of power of two size classes (1KB thru 64KB) cached lock-free by the URB pool. */
+#define VUSBURBPOOL_SIZE_CLASSES    7
+/** Number of lock-free cache slots per size class. */
+#define VUSBURBPOOL_CACHE_SLOTS     4
+
+/**
+ * VUSB URB pool statistics, shared by all the pools of a root hub.
+ */
+typedef struct VUSBURBPOOLSTATS
+{
+    /** URB buffers taken from the lock-free cache. */
+    uint64_t volatile       cHitsLockFree;
+    /** URB buffers taken from the free lists. */
+    uint64_t volatile       cHits;
+    /** URB buffers which had to be allocated. */
+    uint64_t volatile       cMisses;
+} VUSBURBPOOLSTATS;
+/** Pointer to VUSB URB pool statistics. */
+typedef VUSBURBPOOLSTATS *PVUSBURBPOOLSTATS;
+
 /**
  * VUSB URB pool.
+ *
+ * Free URB buffers of the common sizes are parked in a small lock-free cache
+ * per size class first, the free lists protected by the critical section
+ * take the rest.
  */
 typedef struct VUSBURBPOOL
 {
-    /** Critical section protecting the pool. */
+    /** Critical section protecting the free lists. */
     RTCRITSECT              CritSectPool;
     /** Chain of free URBs by type. (Singly linked) */
     RTLISTANCHOR            aLstFreeUrbs[VUSBXFERTYPE_ELEMENTS];
+    /** Lock-free cache of free URB buffers by size class (VUSBURBHDR pointers). */
+    void * volatile         aapvCache[VUSBURBPOOL_SIZE_CLASSES][VUSBURBPOOL_CACHE_SLOTS];
+    /** Where to count hits and misses, optional. */
+    PVUSBURBPOOLSTATS       pStats;
     /** The number of URBs in the pool. */
     volatile uint32_t       cUrbsInPool;
+#if HC_ARCH_BITS == 64
     /** Align the size to a 8 byte boundary. */
     uint32_t                Alignment0;
+#endif
 } VUSBURBPOOL;
 /** Pointer to a VUSB URB pool. */
 typedef VUSBURBPOOL *PVUSBURBPOOL;
 
 AssertCompileSizeAlignment(VUSBURBPOOL, 8);
 
+/** Number of buckets in an URB latency histogram. */
+#define VUSB_URB_LATENCY_BUCKETS    8
+
+/**
+ * URB latency histogram for one stage of the URB life cycle.
+ */
+typedef struct VUSBURBLATENCY
+{
+    /** Average, minimum and maximum latency in nanoseconds. */
+    STAMPROFILE         Prof;
+    /** Power of four buckets: <16us, <64us, <256us, <1ms, <4ms, <16ms, <64ms and the rest. */
+    STAMCOUNTER         aBuckets[VUSB_URB_LATENCY_BUCKETS];
+} VUSBURBLATENCY;
+/** Pointer to an URB latency histogram. */
+typedef VUSBURBLATENCY *PVUSBURBLATENCY;
+
+/**
+ * Per endpoint and direction URB latency statistics.
+ */
+typedef struct VUSBEPLATENCYSTATS
+{
+    /** Guest submit until the URB was handed to the device (HCI and VUSB). */
+    VUSBURBLATENCY      Queue;
+    /** Handed to the device until reaped (proxy backend and host). */
+    VUSBURBLATENCY      Host;
+    /** Reaped until completed towards the guest (VUSB and HCI). */
+    VUSBURBLATENCY      Completion;
+} VUSBEPLATENCYSTATS;
+/** Pointer to per endpoint URB latency statistics. */
+typedef VUSBEPLATENCYSTATS *PVUSBEPLATENCYSTATS;
+
 /**
  * A Virtual USB device (core).
  *
@@ -295,6 +358,10 @@ typedef struct VUSBDEV
 #endif
     /** The pool of free URBs for faster allocation. */
     VUSBURBPOOL         UrbPool;
+#ifdef VBOX_WITH_STATISTICS
+    /** URB latency statistics, indexed by endpoint and direction (0 = out/setup, 1 = in). */
+    VUSBEPLATENCYSTATS  aStatLatency[VUSB_PIPE_MAX][2];
+#endif
 } VUSBDEV;
 AssertCompileSizeAlignment(VUSBDEV, 8);
 
@@ -385,6 +452,8 @@ typedef struct VUSBROOTHUB
     char                        *pszName;
     /** URB pool for URBs from the roothub. */
     VUSBURBPOOL                 UrbPool;
+    /** URB pool statistics for the roothub and all attached devices. */
+    VUSBURBPOOLSTATS            UrbPoolStats;
 
 #if HC_ARCH_BITS == 32
     uint32_t                   Alignment0;
@@ -520,8 +589,9 @@ bool vusbDevIsDescriptorInCache(PVUSBDEV pDev, PCVUSBSETUP pSetup);
  *
  * @returns VBox status code.
  * @param   pUrbPool    The URB pool to initialize.
+ * @param   pStats      Where to count pool hits and misses, optional.
  */
-DECLHIDDEN(int) vusbUrbPoolInit(PVUSBURBPOOL pUrbPool);
+DECLHIDDEN(int) vusbUrbPoolInit(PVUSBURBPOOL pUrbPool, PVUSBURBPOOLSTATS pStats);
 
 /**
  * Destroy a given URB pool freeing all ressources.
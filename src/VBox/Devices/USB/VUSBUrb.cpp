@@ -450,6 +450,10 @@ int vusbUrbQueueAsyncRh(PVUSBURB pUrb)
         return VERR_OBJECT_DESTROYED;
     }
 
+#ifdef VBOX_WITH_STATISTICS
+    pUrb->pVUsb->u64QueueTS = RTTimeNanoTS();
+#endif
+
     RTCritSectEnter(&pDev->CritSectAsyncUrbs);
     int rc = pDev->pUsbIns->pReg->pfnUrbQueue(pDev->pUsbIns, pUrb);
     if (RT_FAILURE(rc))
@@ -807,6 +811,7 @@ static void vusbMsgDoTransfer(PVUSBURB pUrb, PVUSBSETUP pSetup, PVUSBCTRLEXTRA p
     pExtra->Urb.enmDir  = (pSetup->bmRequestType & VUSB_DIR_TO_HOST) ? VUSBDIRECTION_IN : VUSBDIRECTION_OUT;
     pExtra->Urb.cbData  = pSetup->wLength + sizeof(*pSetup);
     pExtra->Urb.pVUsb->pCtrlUrb = pUrb;
+    pExtra->Urb.pVUsb->u64SubmitTS = pUrb->pVUsb->u64SubmitTS;
     int rc = vusbUrbQueueAsyncRh(&pExtra->Urb);
     if (RT_FAILURE(rc))
     {
@@ -1151,7 +1156,7 @@ int vusbUrbSubmit(PVUSBURB pUrb)
         return VERR_VUSB_DEVICE_IS_RESETTING;
     }
 
-#ifdef LOG_ENABLED
+#if defined(LOG_ENABLED) || defined(VBOX_WITH_STATISTICS)
     /* stamp it */
     pUrb->pVUsb->u64SubmitTS = RTTimeNanoTS();
 #endif
@@ -1354,6 +1359,25 @@ void vusbUrbDoReapAsyncDev(PVUSBDEV pDev, RTMSINTERVAL cMillies)
     }
 }
 
+#ifdef VBOX_WITH_STATISTICS
+/**
+ * Adds a sample to the given URB latency histogram.
+ *
+ * @param   pLatency    The latency histogram.
+ * @param   cNsElapsed  The latency in nanoseconds.
+ */
+DECLINLINE(void) vusbUrbLatencyAdd(PVUSBURBLATENCY pLatency, uint64_t cNsElapsed)
+{
+    STAM_PROFILE_ADD_PERIOD(&pLatency->Prof, cNsElapsed);
+
+    /* Power of four buckets starting with everything below 16us. */
+    uint64_t const cUsElapsed = cNsElapsed / RT_NS_1US;
+    unsigned iBucket = cUsElapsed >= 16 ? (ASMBitLastSetU64(cUsElapsed) - 1) / 2 - 1 : 0;
+    iBucket = RT_MIN(iBucket, VUSB_URB_LATENCY_BUCKETS - 1);
+    STAM_COUNTER_INC(&pLatency->aBuckets[iBucket]);
+}
+#endif
+
 /**
  * Completes the URB.
  */
@@ -1365,7 +1389,32 @@ static void vusbUrbCompletion(PVUSBURB pUrb)
     if (pUrb->enmState == VUSBURBSTATE_REAPED)
         vusbUrbUnlink(pUrb);
 
+#ifdef VBOX_WITH_STATISTICS
+    /*
+     * Account the time spent before handing the URB to the device and
+     * the time the device (proxy backend and host) took to complete it.
+     * The URB might be freed by the completion, so everything needed is
+     * fetched up front.
+     */
+    AssertCompile(RT_ELEMENTS(pUrb->pVUsb->pDev->aStatLatency) == VUSB_PIPE_MAX);
+    PVUSBEPLATENCYSTATS pStats = &pUrb->pVUsb->pDev->aStatLatency[pUrb->EndPt & (VUSB_PIPE_MAX - 1)]
+                                                                 [pUrb->enmDir == VUSBDIRECTION_IN ? 1 : 0];
+    uint64_t const tsReaped = RTTimeNanoTS();
+    uint64_t const tsSubmit = pUrb->pVUsb->u64SubmitTS;
+    uint64_t const tsQueue  = pUrb->pVUsb->u64QueueTS;
+    if (tsQueue)
+    {
+        if (tsSubmit && tsSubmit <= tsQueue)
+            vusbUrbLatencyAdd(&pStats->Queue, tsQueue - tsSubmit);
+        vusbUrbLatencyAdd(&pStats->Host, tsReaped - tsQueue);
+    }
+#endif
+
     vusbUrbCompletionRh(pUrb);
+
+#ifdef VBOX_WITH_STATISTICS
+    vusbUrbLatencyAdd(&pStats->Completion, RTTimeNanoTS() - tsReaped);
+#endif
 }
 
 /**
@@ -31,6 +31,7 @@
 *********************************************************************************************************************************/
 #define LOG_GROUP LOG_GROUP_DRV_VUSB
 #include <VBox/log.h>
+#include <iprt/asm.h>
 #include <iprt/errcore.h>
 #include <iprt/mem.h>
 #include <iprt/critsect.h>
@@ -90,15 +91,57 @@ typedef VUSBURBHDR *PVUSBURBHDR;
 AssertCompileSizeAlignment(VUSBURBHDR, 8);
 
 
+/**
+ * Returns the lock-free cache size class for the given buffer size.
+ *
+ * @returns Size class index, VUSBURBPOOL_SIZE_CLASSES if the size is too big
+ *          to be cached.
+ * @param   cb          The buffer size.
+ */
+DECLINLINE(unsigned) vusbUrbPoolSizeClass(size_t cb)
+{
+    unsigned iClass = 0;
+    while (iClass < VUSBURBPOOL_SIZE_CLASSES && cb > ((size_t)_1K << iClass))
+        iClass++;
+    return iClass;
+}
+
+
+/**
+ * Counts a pool hit or miss if the pool has statistics attached.
+ */
+DECLINLINE(void) vusbUrbPoolCount(PVUSBURBPOOL pUrbPool, size_t offCounter)
+{
+    if (pUrbPool->pStats)
+        ASMAtomicIncU64((uint64_t volatile *)((uint8_t *)pUrbPool->pStats + offCounter));
+}
+
 
-DECLHIDDEN(int) vusbUrbPoolInit(PVUSBURBPOOL pUrbPool)
+/**
+ * Frees an URB buffer for good.
+ */
+static void vusbUrbPoolFreeHdr(PVUSBURBPOOL pUrbPool, PVUSBURBHDR pHdr)
+{
+    ASMAtomicDecU32(&pUrbPool->cUrbsInPool);
+    pHdr->cbAllocated  = 0;
+    pHdr->enmHdrState = VUSBHDRSTATE_INVALID;
+    RTMemFree(pHdr);
+}
+
+
+
+DECLHIDDEN(int) vusbUrbPoolInit(PVUSBURBPOOL pUrbPool, PVUSBURBPOOLSTATS pStats)
 {
     int rc = RTCritSectInit(&pUrbPool->CritSectPool);
     if (RT_SUCCESS(rc))
     {
         pUrbPool->cUrbsInPool = 0;
+        pUrbPool->pStats      = pStats;
         for (unsigned i = 0; i < RT_ELEMENTS(pUrbPool->aLstFreeUrbs); i++)
             RTListInit(&pUrbPool->aLstFreeUrbs[i]);
+        for (unsigned iClass = 0; iClass < RT_ELEMENTS(pUrbPool->aapvCache); iClass++)
+            for (unsigned iSlot = 0; iSlot < RT_ELEMENTS(pUrbPool->aapvCache[iClass]); iSlot++)
+                pUrbPool->aapvCache[iClass][iSlot] = NULL;
     }
 
     return rc;
@@ -114,12 +157,16 @@ DECLHIDDEN(void) vusbUrbPoolDestroy(PVUSBURBPOOL pUrbPool)
         RTListForEachSafe(&pUrbPool->aLstFreeUrbs[i], pHdr, pHdrNext, VUSBURBHDR, NdFree)
         {
             RTListNodeRemove(&pHdr->NdFree);
-
-            pHdr->cbAllocated  = 0;
-            pHdr->enmHdrState = VUSBHDRSTATE_INVALID;
-            RTMemFree(pHdr);
+            vusbUrbPoolFreeHdr(pUrbPool, pHdr);
         }
     }
+    for (unsigned iClass = 0; iClass < RT_ELEMENTS(pUrbPool->aapvCache); iClass++)
+        for (unsigned iSlot = 0; iSlot < RT_ELEMENTS(pUrbPool->aapvCache[iClass]); iSlot++)
+        {
+            PVUSBURBHDR pHdr = (PVUSBURBHDR)ASMAtomicXchgPtr(&pUrbPool->aapvCache[iClass][iSlot], NULL);
+            if (pHdr)
+                vusbUrbPoolFreeHdr(pUrbPool, pHdr);
+        }
     RTCritSectLeave(&pUrbPool->CritSectPool);
     RTCritSectDelete(&pUrbPool->CritSectPool);
 }
@@ -163,60 +210,86 @@ DECLHIDDEN(PVUSBURB) vusbUrbPoolAlloc(PVUSBURBPOOL pUrbPool, VUSBXFERTYPE enmTyp
         AssertLogRelFailedReturn(NULL);
 
 
-    /* Now look for an appropriately sized buffer in the pool. */
-    RTCritSectEnter(&pUrbPool->CritSectPool);
-    PVUSBURBHDR pHdr = NULL;
-    PVUSBURBHDR pIt, pItNext;
-    RTListForEachSafe(&pUrbPool->aLstFreeUrbs[enmType], pIt, pItNext, VUSBURBHDR, NdFree)
+    /* Try the lock-free cache for the size class first. */
+    PVUSBURBHDR    pHdr   = NULL;
+    unsigned const iClass = vusbUrbPoolSizeClass(cbData);
+    if (iClass < RT_ELEMENTS(pUrbPool->aapvCache))
     {
-        if (pIt->cbAllocated >= cbData)
+        for (unsigned iSlot = 0; iSlot < RT_ELEMENTS(pUrbPool->aapvCache[iClass]); iSlot++)
         {
-            RTListNodeRemove(&pIt->NdFree);
-            Assert(pIt->enmHdrState == VUSBHDRSTATE_FREE);
-            /*
-             * If the allocation is far too big we increase the age counter too
-             * so we don't waste memory for a lot of small transfers
-             */
-            if (pIt->cbAllocated >= 2 * cbData)
-                pIt->cAge++;
-            else
-                pIt->cAge = 0;
-            pIt->enmHdrState = VUSBHDRSTATE_USED;
-            pHdr = pIt;
-            break;
+            if (!ASMAtomicUoReadPtr(&pUrbPool->aapvCache[iClass][iSlot]))
+                continue;
+            pHdr = (PVUSBURBHDR)ASMAtomicXchgPtr(&pUrbPool->aapvCache[iClass][iSlot], NULL);
+            if (pHdr)
+            {
+                Assert(pHdr->enmHdrState == VUSBHDRSTATE_FREE);
+                pHdr->enmHdrState = VUSBHDRSTATE_USED;
+                pHdr->cAge        = 0;
+                vusbUrbPoolCount(pUrbPool, RT_UOFFSETOF(VUSBURBPOOLSTATS, cHitsLockFree));
+                break;
+            }
         }
-        else
+    }
+
+    /* Then look for an appropriately sized buffer in the free lists. */
+    if (!pHdr)
+    {
+        RTCritSectEnter(&pUrbPool->CritSectPool);
+        PVUSBURBHDR pIt, pItNext;
+        RTListForEachSafe(&pUrbPool->aLstFreeUrbs[enmType], pIt, pItNext, VUSBURBHDR, NdFree)
         {
-            /* Increase age and free if it reached a threshold. */
-            pIt->cAge++;
-            if (pIt->cAge == VUSBURB_AGE_MAX)
+            if (pIt->cbAllocated >= cbData)
             {
                 RTListNodeRemove(&pIt->NdFree);
-                ASMAtomicDecU32(&pUrbPool->cUrbsInPool);
-                pIt->cbAllocated  = 0;
-                pIt->enmHdrState = VUSBHDRSTATE_INVALID;
-                RTMemFree(pIt);
+                Assert(pIt->enmHdrState == VUSBHDRSTATE_FREE);
+                /*
+                 * If the allocation is far too big we increase the age counter too
+                 * so we don't waste memory for a lot of small transfers
+                 */
+                if (pIt->cbAllocated >= 2 * cbData)
+                    pIt->cAge++;
+                else
+                    pIt->cAge = 0;
+                pIt->enmHdrState = VUSBHDRSTATE_USED;
+                pHdr = pIt;
+                break;
+            }
+            else
+            {
+                /* Increase age and free if it reached a threshold. */
+                pIt->cAge++;
+                if (pIt->cAge == VUSBURB_AGE_MAX)
+                {
+                    RTListNodeRemove(&pIt->NdFree);
+                    vusbUrbPoolFreeHdr(pUrbPool, pIt);
+                }
             }
         }
+        RTCritSectLeave(&pUrbPool->CritSectPool);
+        if (pHdr)
+            vusbUrbPoolCount(pUrbPool, RT_UOFFSETOF(VUSBURBPOOLSTATS, cHits));
     }
 
     if (!pHdr)
     {
-        /* Nothing in the pool, allocate a new buffer. */
-        size_t cbDataAllocated = cbData <= _4K  ? RT_ALIGN_32(cbData, _1K)
-                               : cbData <= _32K ? RT_ALIGN_32(cbData, _4K)
-                                                : RT_ALIGN_32(cbData, 16*_1K);
+        /* Nothing in the pool, allocate a new buffer.  Sizes the lock-free
+         * cache handles are rounded up to the size class so they can go back
+         * there when freed. */
+        size_t cbDataAllocated = iClass < RT_ELEMENTS(pUrbPool->aapvCache) ? (size_t)_1K << iClass
+                               : RT_ALIGN_Z(cbData, 16*_1K);
 
         pHdr = (PVUSBURBHDR)RTMemAllocZ(RT_UOFFSETOF_DYN(VUSBURBHDR, abHdrData[cbDataAllocated]));
         if (RT_UNLIKELY(!pHdr))
         {
-            RTCritSectLeave(&pUrbPool->CritSectPool);
+            RTMemFree(pUrb);
             AssertLogRelFailedReturn(NULL);
         }
 
         pHdr->cbAllocated = cbDataAllocated;
         pHdr->cAge        = 0;
+        pHdr->enmHdrState = VUSBHDRSTATE_USED;
         ASMAtomicIncU32(&pUrbPool->cUrbsInPool);
+        vusbUrbPoolCount(pUrbPool, RT_UOFFSETOF(VUSBURBPOOLSTATS, cMisses));
     }
     else
     {
@@ -228,7 +301,6 @@ DECLHIDDEN(PVUSBURB) vusbUrbPoolAlloc(PVUSBURBPOOL pUrbPool, VUSBXFERTYPE enmTyp
             memset(&pHdr->abHdrData[pHdr->cbData], 0, cbData - pHdr->cbData);
         }
     }
-    RTCritSectLeave(&pUrbPool->CritSectPool);
 
     Assert(pHdr->cbAllocated >= cbData);
 
@@ -245,6 +317,7 @@ DECLHIDDEN(PVUSBURB) vusbUrbPoolAlloc(PVUSBURBPOOL pUrbPool, VUSBXFERTYPE enmTyp
     pUrb->pVUsb->pfnFree         = NULL;
     pUrb->pVUsb->pCtrlUrb        = NULL;
     pUrb->pVUsb->u64SubmitTS     = 0;
+    pUrb->pVUsb->u64QueueTS      = 0;
     pUrb->Dev.pvPrivate          = NULL;
     pUrb->Dev.pNext              = NULL;
     pUrb->EndPt                  = UINT8_MAX;
@@ -254,6 +327,8 @@ DECLHIDDEN(PVUSBURB) vusbUrbPoolAlloc(PVUSBURBPOOL pUrbPool, VUSBXFERTYPE enmTyp
     pUrb->enmStatus              = VUSBSTATUS_INVALID;
     pUrb->cbData                 = (uint32_t)cbData;
     pUrb->pbData                 = pHdr->abHdrData;
+    pUrb->cGuestSegs             = 0;
+    pUrb->paGuestSegs            = NULL;
     /* Any of cbHci, cbHciTd, and cTds can be zero. We have to be careful. */
     pUrb->pHci                   = cbHci ? (PVUSBURBHCI)(pUrb->pVUsb + 1) : NULL;
     pUrb->paTds                  = (cbHciTd && cTds) ? (PVUSBURBHCITD)((uint8_t *)(pUrb->pVUsb + 1) + cbHci) : NULL;
@@ -273,22 +348,29 @@ DECLHIDDEN(void) vusbUrbPoolFree(PVUSBURBPOOL pUrbPool, PVUSBURB pUrb)
 
     /* Buffers which aged too much because they are too big are freed. */
     if (pHdr->cAge == VUSBURB_AGE_MAX)
-    {
-        ASMAtomicDecU32(&pUrbPool->cUrbsInPool);
-        pHdr->cbAllocated  = 0;
-        pHdr->enmHdrState = VUSBHDRSTATE_INVALID;
-        RTMemFree(pHdr);
-    }
+        vusbUrbPoolFreeHdr(pUrbPool, pHdr);
     else
     {
-        /* Put it into the list of free buffers. */
-        VUSBXFERTYPE enmType = pUrb->enmType;
-        AssertReturnVoid((size_t)enmType < RT_ELEMENTS(pUrbPool->aLstFreeUrbs));
-        RTCritSectEnter(&pUrbPool->CritSectPool);
-        pHdr->cbData = pUrb->cbData;
+        pHdr->cbData      = pUrb->cbData;
         pHdr->enmHdrState = VUSBHDRSTATE_FREE;
-        RTListAppend(&pUrbPool->aLstFreeUrbs[enmType], &pHdr->NdFree);
-        RTCritSectLeave(&pUrbPool->CritSectPool);
+
+        /* Park buffers of exactly a size class size in the lock-free cache if there is room. */
+        bool           fCached = false;
+        unsigned const iClass  = vusbUrbPoolSizeClass(pHdr->cbAllocated);
+        if (   iClass < RT_ELEMENTS(pUrbPool->aapvCache)
+            && pHdr->cbAllocated == ((size_t)_1K << iClass))
+            for (unsigned iSlot = 0; iSlot < RT_ELEMENTS(pUrbPool->aapvCache[iClass]) && !fCached; iSlot++)
+                fCached = ASMAtomicCmpXchgPtr(&pUrbPool->aapvCache[iClass][iSlot], pHdr, NULL);
+
+        if (!fCached)
+        {
+            /* Put it into the list of free buffers. */
+            VUSBXFERTYPE enmType = pUrb->enmType;
+            AssertReturnVoid((size_t)enmType < RT_ELEMENTS(pUrbPool->aLstFreeUrbs));
+            RTCritSectEnter(&pUrbPool->CritSectPool);
+            RTListAppend(&pUrbPool->aLstFreeUrbs[enmType], &pHdr->NdFree);
+            RTCritSectLeave(&pUrbPool->CritSectPool);
+        }
     }
 
     /* Free the control section of the URB. */
@@ -57,6 +57,9 @@
 # include <linux/compiler.h>
 #endif
 #include <linux/usbdevice_fs.h>
+#ifndef USBDEVFS_URB_BULK_CONTINUATION
+# define USBDEVFS_URB_BULK_CONTINUATION 0x04 /* Linux 2.6.32+ */
+#endif
 
 #ifndef RDESKTOP
 # include <VBox/vmm/pdm.h>
@@ -1120,8 +1123,12 @@ static PUSBPROXYURBLNX usbProxyLinuxSplitURBFragment(PUSBPROXYDEV pProxyDev, PUS
  *
  * NB: For ShortOK reads things get a little tricky - we don't
  * know how much data is going to arrive and not all the
- * fragment URBs might be filled. We can only safely set up one
- * URB at a time -> worse performance but correct behaviour.
+ * fragment URBs might be filled. For bulk endpoints we queue all
+ * fragments at once and let usbfs cancel the rest of the chain when
+ * one comes up short: every fragment but the last has SHORT_NOT_OK
+ * set and every fragment but the first is marked as a BULK_CONTINUATION.
+ * For interrupt endpoints we can only safely set up one URB at a time
+ * -> worse performance but correct behaviour.
  *
  * @returns VBox status code.
  * @param   pProxyDev   The proxy device.
@@ -1176,7 +1183,7 @@ static int usbProxyLinuxUrbQueueSplit(PUSBPROXYDEV pProxyDev, PUSBPROXYURBLNX pU
 
     int rc = VINF_SUCCESS;
     bool fUnplugged = false;
-    if (pUrb->enmDir == VUSBDIRECTION_IN && !pUrb->fShortNotOk)
+    if (pUrb->enmDir == VUSBDIRECTION_IN && !pUrb->fShortNotOk && pUrb->enmType != VUSBXFERTYPE_BULK)
     {
         /* Subsequent fragments will be queued only after the previous fragment is reaped
          * and only if necessary.
@@ -1197,6 +1204,18 @@ static int usbProxyLinuxUrbQueueSplit(PUSBPROXYDEV pProxyDev, PUSBPROXYURBLNX pU
         }
         Assert(pCur->cbSplitRemaining == 0);
 
+        /* Chain ShortOK bulk reads so a short fragment terminates the transfer (see above). */
+        if (pUrb->enmDir == VUSBDIRECTION_IN && !pUrb->fShortNotOk)
+        {
+            for (pCur = pUrbLnx; pCur; pCur = pCur->pSplitNext)
+            {
+                if (pCur->pSplitNext)
+                    pCur->KUrb.flags |= USBDEVFS_URB_SHORT_NOT_OK;
+                if (pCur != pUrbLnx)
+                    pCur->KUrb.flags |= USBDEVFS_URB_BULK_CONTINUATION;
+            }
+        }
+
         /* Submit the blocks. */
         pCur = pUrbLnx;
         for (i = 0; i < cKUrbs; i++, pCur = pCur->pSplitNext)
@@ -1517,7 +1536,6 @@ static DECLCALLBACK(PVUSBURB) usbProxyLinuxUrbReap(PUSBPROXYDEV pProxyDev, RTMSI
             if (pUrbLnx->cbSplitRemaining && (pKUrb->actual_length == pKUrb->buffer_length) && !pUrbLnx->pSplitNext)
             {
                 bool fUnplugged = false;
-                bool fSucceeded;
 
                 Assert(pUrbLnx->pSplitHead);
                 Assert((pKUrb->endpoint & 0x80) && !(pKUrb->flags & USBDEVFS_URB_SHORT_NOT_OK));
@@ -1528,10 +1546,10 @@ static DECLCALLBACK(PVUSBURB) usbProxyLinuxUrbReap(PUSBPROXYDEV pProxyDev, RTMSI
                     return NULL;
                 }
                 PVUSBURB pUrb = (PVUSBURB)pUrbLnx->KUrb.usercontext;
-                fSucceeded = usbProxyLinuxSubmitURB(pProxyDev, pNew, pUrb, &fUnplugged);
+                int rc = usbProxyLinuxSubmitURB(pProxyDev, pNew, pUrb, &fUnplugged);
                 if (fUnplugged)
                     usbProxLinuxUrbUnplugged(pProxyDev);
-                if (!fSucceeded)
+                if (RT_FAILURE(rc))
                     return NULL;
                 continue;   /* try reaping another URB */
             }
@@ -1567,6 +1585,14 @@ static DECLCALLBACK(PVUSBURB) usbProxyLinuxUrbReap(PUSBPROXYDEV pProxyDev, RTMSI
             {
                 if (pCur->KUrb.actual_length)
                     pbEnd = (uint8_t *)pCur->KUrb.buffer + pCur->KUrb.actual_length;
+
+                /* A short fragment in a chained ShortOK read ends the transfer;
+                   usbfs has cancelled the continuation fragments following it. */
+                if (   pCur->KUrb.status == -EREMOTEIO
+                    && pCur->pSplitNext
+                    && (pCur->pSplitNext->KUrb.flags & USBDEVFS_URB_BULK_CONTINUATION))
+                    break;
+
                 if (pUrb->enmStatus == VUSBSTATUS_OK)
                     pUrb->enmStatus = vusbProxyLinuxUrbGetStatus(pCur);
             }
@@ -366,6 +366,10 @@ typedef struct USBPROXYURBUSBIP
     VUSBSTATUS         enmStatus;
     /** Pointer to the VUSB URB. */
     PVUSBURB           pVUsbUrb;
+    /** The submit request, kept here until the batch it is part of was sent. */
+    UsbIpReqSubmit     ReqSubmit;
+    /** Isochronous packet descriptors sent along with the submit request. */
+    UsbIpIsocPktDesc   aIsocPktsDesc[8];
 } USBPROXYURBUSBIP;
 /** Pointer to a USB/IP URB. */
 typedef USBPROXYURBUSBIP *PUSBPROXYURBUSBIP;
@@ -453,6 +457,13 @@ typedef struct USBPROXYDEVUSBIP
 /** Waking reason for the USB I/P reaper: External wakeup. */
 #define USBIP_REAPER_WAKEUP_REASON_EXTERNAL 'E'
 
+/** Maximum number of segments used for a single submit request (isochronous transfer). */
+#define USBIP_URB_SEGS_MAX     3
+/** Maximum number of submit requests coalesced into a single socket write. */
+#define USBIP_SUBMIT_BATCH_MAX 16
+/** Maximum number of segments for a single socket write. */
+#define USBIP_SUBMIT_BATCH_SEGS_MAX 64
+
 /**
  * Converts a request/reply header from network to host endianness.
  *
@@ -907,6 +918,7 @@ static void usbProxyUsbIpRecvStateAdvance(PUSBPROXYDEVUSBIP pProxyDevUsbIp, USBP
  * Handles reception of a USB/IP PDU.
  *
  * @returns VBox status code.
+ * @retval VINF_TRY_AGAIN if there was no data to read from the socket.
  * @param  pProxyDevUsbIp    The USB/IP proxy device data.
  * @param  ppUrbUsbIp        Where to store the pointer to the USB/IP URB which completed.
  *                           Will be NULL if the received PDU is not complete and we have
@@ -922,7 +934,9 @@ static int usbProxyUsbIpRecvPdu(PUSBPROXYDEVUSBIP pProxyDevUsbIp, PUSBPROXYURBUS
 
     /* Read any available data first. */
     rc = RTTcpReadNB(pProxyDevUsbIp->hSocket, pProxyDevUsbIp->pbRecv, pProxyDevUsbIp->cbLeft, &cbRead);
-    if (RT_SUCCESS(rc))
+    if (RT_SUCCESS(rc) && !cbRead)
+        rc = VINF_TRY_AGAIN;
+    else if (RT_SUCCESS(rc))
     {
         pProxyDevUsbIp->cbRecv += cbRead;
         pProxyDevUsbIp->cbLeft -= cbRead;
@@ -1126,82 +1140,87 @@ static int usbProxyUsbIpRecvPdu(PUSBPROXYDEVUSBIP pProxyDevUsbIp, PUSBPROXYURBUS
 }
 
 /**
- * Worker for queueing an URB on the main I/O thread.
+ * Worker for preparing the submit request of an URB on the main I/O thread.
+ *
+ * The request header and isochronous packet descriptors are kept in the USB/IP URB
+ * so the segments stay valid until the whole batch was written to the socket.
  *
  * @returns VBox status code.
  * @param   pProxyDevUsbIp    The USB/IP proxy device data.
  * @param   pUrbUsbIp         The USB/IP URB to queue.
+ * @param   paSegs            Where to store the segments to send, must hold at least
+ *                            USBIP_URB_SEGS_MAX entries or one more than the number of
+ *                            guest memory segments of the URB.
+ * @param   pcSegs            Where to store the number of segments used.
  */
-static int usbProxyUsbIpUrbQueueWorker(PUSBPROXYDEVUSBIP pProxyDevUsbIp, PUSBPROXYURBUSBIP pUrbUsbIp)
+static int usbProxyUsbIpUrbQueuePrepare(PUSBPROXYDEVUSBIP pProxyDevUsbIp, PUSBPROXYURBUSBIP pUrbUsbIp,
+                                        PRTSGSEG paSegs, unsigned *pcSegs)
 {
     PVUSBURB pUrb = pUrbUsbIp->pVUsbUrb;
+    PUsbIpReqSubmit pReqSubmit = &pUrbUsbIp->ReqSubmit;
 
     pUrbUsbIp->u32SeqNumUrb = usbProxyUsbIpSeqNumGet(pProxyDevUsbIp);
     pUrbUsbIp->enmType      = pUrb->enmType;
     pUrbUsbIp->enmStatus    = pUrb->enmStatus;
     pUrbUsbIp->enmDir       = pUrb->enmDir;
 
-    UsbIpReqSubmit ReqSubmit;
-
-    RT_ZERO(ReqSubmit);
-    ReqSubmit.Hdr.u32ReqRet           = USBIP_CMD_SUBMIT;
-    ReqSubmit.Hdr.u32SeqNum           = pUrbUsbIp->u32SeqNumUrb;
-    ReqSubmit.Hdr.u32DevId            = pProxyDevUsbIp->u32DevId;
-    ReqSubmit.Hdr.u32Endpoint         = pUrb->EndPt;
-    ReqSubmit.Hdr.u32Direction        = pUrb->enmDir == VUSBDIRECTION_IN ? USBIP_DIR_IN : USBIP_DIR_OUT;
-    ReqSubmit.u32XferFlags            = 0;
+    RT_ZERO(*pReqSubmit);
+    pReqSubmit->Hdr.u32ReqRet           = USBIP_CMD_SUBMIT;
+    pReqSubmit->Hdr.u32SeqNum           = pUrbUsbIp->u32SeqNumUrb;
+    pReqSubmit->Hdr.u32DevId            = pProxyDevUsbIp->u32DevId;
+    pReqSubmit->Hdr.u32Endpoint         = pUrb->EndPt;
+    pReqSubmit->Hdr.u32Direction        = pUrb->enmDir == VUSBDIRECTION_IN ? USBIP_DIR_IN : USBIP_DIR_OUT;
+    pReqSubmit->u32XferFlags            = 0;
     if (pUrb->enmDir == VUSBDIRECTION_IN && pUrb->fShortNotOk)
-        ReqSubmit.u32XferFlags |= USBIP_XFER_FLAGS_SHORT_NOT_OK;
+        pReqSubmit->u32XferFlags |= USBIP_XFER_FLAGS_SHORT_NOT_OK;
 
-    ReqSubmit.u32TransferBufferLength = pUrb->cbData;
-    ReqSubmit.u32StartFrame           = 0;
-    ReqSubmit.u32NumIsocPkts          = 0;
-    ReqSubmit.u32Interval             = 0;
+    pReqSubmit->u32TransferBufferLength = pUrb->cbData;
+    pReqSubmit->u32StartFrame           = 0;
+    pReqSubmit->u32NumIsocPkts          = 0;
+    pReqSubmit->u32Interval             = 0;
 
-    RTSGSEG          aSegReq[3]; /* Maximum number of segments used for a Isochronous transfer. */
-    UsbIpIsocPktDesc aIsocPktsDesc[8];
     unsigned cSegsUsed = 1;
-    aSegReq[0].pvSeg = &ReqSubmit;
-    aSegReq[0].cbSeg = sizeof(ReqSubmit);
+    paSegs[0].pvSeg = pReqSubmit;
+    paSegs[0].cbSeg = sizeof(*pReqSubmit);
 
     switch (pUrb->enmType)
     {
         case VUSBXFERTYPE_MSG:
-            memcpy(&ReqSubmit.Setup, pUrb->pbData, sizeof(ReqSubmit.Setup));
-            ReqSubmit.u32TransferBufferLength -= sizeof(VUSBSETUP);
+            memcpy(&pReqSubmit->Setup, pUrb->pbData, sizeof(pReqSubmit->Setup));
+            pReqSubmit->u32TransferBufferLength -= sizeof(VUSBSETUP);
             if (pUrb->enmDir == VUSBDIRECTION_OUT)
             {
-                aSegReq[cSegsUsed].cbSeg = pUrb->cbData - sizeof(VUSBSETUP);
-                aSegReq[cSegsUsed].pvSeg = pUrb->pbData + sizeof(VUSBSETUP);
-                if (aSegReq[cSegsUsed].cbSeg)
+                paSegs[cSegsUsed].cbSeg = pUrb->cbData - sizeof(VUSBSETUP);
+                paSegs[cSegsUsed].pvSeg = pUrb->pbData + sizeof(VUSBSETUP);
+                if (paSegs[cSegsUsed].cbSeg)
                     cSegsUsed++;
             }
             LogFlowFunc(("Message (Control) URB\n"));
             break;
         case VUSBXFERTYPE_ISOC:
             LogFlowFunc(("Isochronous URB\n"));
-            ReqSubmit.u32XferFlags |= USBIP_XFER_FLAGS_ISO_ASAP;
-            ReqSubmit.u32NumIsocPkts = pUrb->cIsocPkts;
+            pReqSubmit->u32XferFlags |= USBIP_XFER_FLAGS_ISO_ASAP;
+            pReqSubmit->u32NumIsocPkts = pUrb->cIsocPkts;
             if (pUrb->enmDir == VUSBDIRECTION_OUT)
             {
-                aSegReq[cSegsUsed].cbSeg = pUrb->cbData;
-                aSegReq[cSegsUsed].pvSeg = pUrb->pbData;
+                paSegs[cSegsUsed].cbSeg = pUrb->cbData;
+                paSegs[cSegsUsed].pvSeg = pUrb->pbData;
                 cSegsUsed++;
             }
 
             for (unsigned i = 0; i < pUrb->cIsocPkts; i++)
             {
-                aIsocPktsDesc[i].u32Offset       = pUrb->aIsocPkts[i].off;
-                aIsocPktsDesc[i].u32Length       = pUrb->aIsocPkts[i].cb;
-                aIsocPktsDesc[i].u32ActualLength = 0; /** @todo */
-                aIsocPktsDesc[i].i32Status       = pUrb->aIsocPkts[i].enmStatus;
-                usbProxyUsbIpIsocPktDescH2N(&aIsocPktsDesc[i]);
+                pUrbUsbIp->aIsocPktsDesc[i].u32Offset       = pUrb->aIsocPkts[i].off;
+                pUrbUsbIp->aIsocPktsDesc[i].u32Length       = pUrb->aIsocPkts[i].cb;
+                pUrbUsbIp->aIsocPktsDesc[i].u32ActualLength = 0; /** @todo */
+                pUrbUsbIp->aIsocPktsDesc[i].i32Status       = pUrb->aIsocPkts[i].enmStatus;
+                usbProxyUsbIpIsocPktDescH2N(&pUrbUsbIp->aIsocPktsDesc[i]);
             }
 
             if (pUrb->cIsocPkts)
             {
-                aSegReq[cSegsUsed].cbSeg = pUrb->cIsocPkts * sizeof(UsbIpIsocPktDesc);
-                aSegReq[cSegsUsed].pvSeg = &aIsocPktsDesc[0];
+                paSegs[cSegsUsed].cbSeg = pUrb->cIsocPkts * sizeof(UsbIpIsocPktDesc);
+                paSegs[cSegsUsed].pvSeg = &pUrbUsbIp->aIsocPktsDesc[0];
                 cSegsUsed++;
             }
 
@@ -1211,36 +1230,72 @@ static int usbProxyUsbIpUrbQueueWorker(PUSBPROXYDEVUSBIP pProxyDevUsbIp, PUSBPRO
             LogFlowFunc(("Bulk URB\n"));
             if (pUrb->enmDir == VUSBDIRECTION_OUT)
             {
-                aSegReq[cSegsUsed].cbSeg = pUrb->cbData;
-                aSegReq[cSegsUsed].pvSeg = pUrb->pbData;
-                cSegsUsed++;
+                if (pUrb->cGuestSegs)
+                {
+                    /* Send straight from guest memory. */
+                    for (uint32_t i = 0; i < pUrb->cGuestSegs; i++)
+                        paSegs[cSegsUsed++] = pUrb->paGuestSegs[i];
+                }
+                else
+                {
+                    paSegs[cSegsUsed].cbSeg = pUrb->cbData;
+                    paSegs[cSegsUsed].pvSeg = pUrb->pbData;
+                    cSegsUsed++;
+                }
             }
             break;
         default:
             return VERR_INVALID_PARAMETER; /** @todo better status code. */
     }
 
-    usbProxyUsbIpReqSubmitH2N(&ReqSubmit);
+    usbProxyUsbIpReqSubmitH2N(pReqSubmit);
 
-    Assert(cSegsUsed <= RT_ELEMENTS(aSegReq));
+    Assert(cSegsUsed <= RT_MAX(USBIP_URB_SEGS_MAX, pUrb->cGuestSegs + 1));
+    *pcSegs = cSegsUsed;
+    return VINF_SUCCESS;
+}
 
-    /* Send the command. */
+/**
+ * Sends a batch of prepared submit requests with a single write and moves the URBs
+ * to the in flight list, or completes them with an error if sending failed.
+ *
+ * @param   pProxyDevUsbIp    The USB/IP proxy device data.
+ * @param   paSegs            The segments of all requests in the batch.
+ * @param   cSegs             Number of segments.
+ * @param   papUrbUsbIp       The URBs in the batch.
+ * @param   cUrbs             Number of URBs in the batch.
+ */
+static void usbProxyUsbIpUrbsSubmitBatch(PUSBPROXYDEVUSBIP pProxyDevUsbIp, PRTSGSEG paSegs, unsigned cSegs,
+                                         PUSBPROXYURBUSBIP *papUrbUsbIp, unsigned cUrbs)
+{
     RTSGBUF SgBufReq;
-    RTSgBufInit(&SgBufReq, &aSegReq[0], cSegsUsed);
+    RTSgBufInit(&SgBufReq, paSegs, cSegs);
 
     int rc = RTTcpSgWrite(pProxyDevUsbIp->hSocket, &SgBufReq);
-    if (RT_SUCCESS(rc))
+
+    int rc2 = RTSemFastMutexRequest(pProxyDevUsbIp->hMtxLists);
+    AssertRC(rc2);
+    for (unsigned i = 0; i < cUrbs; i++)
     {
-        /* Link the URB into the list of in flight URBs. */
-        usbProxyUsbIpLinkUrb(pProxyDevUsbIp, &pProxyDevUsbIp->ListUrbsInFlight, pUrbUsbIp);
+        if (RT_SUCCESS(rc))
+            RTListAppend(&pProxyDevUsbIp->ListUrbsInFlight, &papUrbUsbIp[i]->NodeList);
+        else
+        {
+            /* Complete URB with an error and place into landed list. */
+            papUrbUsbIp[i]->pVUsbUrb->enmStatus = VUSBSTATUS_DNR;
+            RTListAppend(&pProxyDevUsbIp->ListUrbsLanded, &papUrbUsbIp[i]->NodeList);
+        }
     }
-
-    return rc;
+    RTSemFastMutexRelease(pProxyDevUsbIp->hMtxLists);
 }
 
 /**
  * Queues all pending URBs from the list.
  *
+ * The submit requests are not waited for, so any number of URBs can be in flight for the device
+ * and the replies are matched by sequence number when received. Up to USBIP_SUBMIT_BATCH_MAX
+ * requests are coalesced into a single socket write to avoid one TCP segment per URB.
+ *
  * @returns VBox status code.
  * @param   pProxyDevUsbIp    The USB/IP proxy device data.
  */
@@ -1253,13 +1308,42 @@ static int usbProxyUsbIpUrbsQueuePending(PUSBPROXYDEVUSBIP pProxyDevUsbIp)
     RTListMove(&ListUrbsPending, &pProxyDevUsbIp->ListUrbsToQueue);
     RTSemFastMutexRelease(pProxyDevUsbIp->hMtxLists);
 
+    RTSGSEG           aSegs[USBIP_SUBMIT_BATCH_SEGS_MAX];
+    PUSBPROXYURBUSBIP apUrbUsbIp[USBIP_SUBMIT_BATCH_MAX];
+    unsigned          cSegs = 0;
+    unsigned          cUrbs = 0;
+
     PUSBPROXYURBUSBIP pIter;
     PUSBPROXYURBUSBIP pIterNext;
     RTListForEachSafe(&ListUrbsPending, pIter, pIterNext, USBPROXYURBUSBIP, NodeList)
     {
         RTListNodeRemove(&pIter->NodeList);
-        rc = usbProxyUsbIpUrbQueueWorker(pProxyDevUsbIp, pIter);
-        if (RT_FAILURE(rc))
+
+        /* Make sure the segments of the URB fit, falling back to the URB buffer for very fragmented guest memory. */
+        PVUSBURB pUrb = pIter->pVUsbUrb;
+        if (pUrb->cGuestSegs + 1 > RT_ELEMENTS(aSegs))
+            VUSBUrbGuestSegsToData(pUrb);
+        if (cSegs + RT_MAX(USBIP_URB_SEGS_MAX, pUrb->cGuestSegs + 1) > RT_ELEMENTS(aSegs))
+        {
+            usbProxyUsbIpUrbsSubmitBatch(pProxyDevUsbIp, &aSegs[0], cSegs, &apUrbUsbIp[0], cUrbs);
+            cSegs = 0;
+            cUrbs = 0;
+        }
+
+        unsigned cSegsUrb = 0;
+        rc = usbProxyUsbIpUrbQueuePrepare(pProxyDevUsbIp, pIter, &aSegs[cSegs], &cSegsUrb);
+        if (RT_SUCCESS(rc))
+        {
+            apUrbUsbIp[cUrbs++] = pIter;
+            cSegs += cSegsUrb;
+            if (cUrbs == RT_ELEMENTS(apUrbUsbIp))
+            {
+                usbProxyUsbIpUrbsSubmitBatch(pProxyDevUsbIp, &aSegs[0], cSegs, &apUrbUsbIp[0], cUrbs);
+                cSegs = 0;
+                cUrbs = 0;
+            }
+        }
+        else
         {
             /* Complete URB with an error and place into landed list. */
             pIter->pVUsbUrb->enmStatus = VUSBSTATUS_DNR;
@@ -1267,6 +1351,9 @@ static int usbProxyUsbIpUrbsQueuePending(PUSBPROXYDEVUSBIP pProxyDevUsbIp)
         }
     }
 
+    if (cUrbs)
+        usbProxyUsbIpUrbsSubmitBatch(pProxyDevUsbIp, &aSegs[0], cSegs, &apUrbUsbIp[0], cUrbs);
+
     return VINF_SUCCESS;
 }
 
@@ -1343,19 +1430,33 @@ static PUSBPROXYURBUSBIP usbProxyUsbIpPollWorker(PUSBPROXYDEVUSBIP pProxyDevUsbI
 
             if (uIdReady == USBIP_POLL_ID_SOCKET)
             {
-                rc = usbProxyUsbIpRecvPdu(pProxyDevUsbIp, &pUrbUsbIp);
-                if (   RT_SUCCESS(rc)
-                    && pUrbUsbIp)
+                /*
+                 * Drain everything the socket has to offer instead of going through the poll
+                 * for every piece of a reply, with many URBs in flight several replies usually
+                 * arrive back to back. Additional completed URBs are parked in the landed list.
+                 */
+                do
                 {
-                    /* Link the URB into the landed list if a specifc reply is requested and the URB doesn't match. */
-                    if (   u32SeqNumRet != 0
-                        && pUrbUsbIp->u32SeqNumUrb != u32SeqNumRet)
+                    PUSBPROXYURBUSBIP pUrbUsbIpRecv = NULL;
+                    rc = usbProxyUsbIpRecvPdu(pProxyDevUsbIp, &pUrbUsbIpRecv);
+                    if (   RT_SUCCESS(rc)
+                        && pUrbUsbIpRecv)
                     {
-                        usbProxyUsbIpUnlinkUrb(pProxyDevUsbIp, pUrbUsbIp);
-                        usbProxyUsbIpLinkUrb(pProxyDevUsbIp, &pProxyDevUsbIp->ListUrbsLanded, pUrbUsbIp);
-                        pUrbUsbIp = NULL;
+                        /* Link the URB into the landed list if a specifc reply is requested and the URB doesn't match. */
+                        if (   !pUrbUsbIp
+                            && (   u32SeqNumRet == 0
+                                || pUrbUsbIpRecv->u32SeqNumUrb == u32SeqNumRet))
+                            pUrbUsbIp = pUrbUsbIpRecv;
+                        else
+                        {
+                            usbProxyUsbIpUnlinkUrb(pProxyDevUsbIp, pUrbUsbIpRecv);
+                            usbProxyUsbIpLinkUrb(pProxyDevUsbIp, &pProxyDevUsbIp->ListUrbsLanded, pUrbUsbIpRecv);
+                        }
                     }
-                }
+                } while (rc == VINF_SUCCESS);
+
+                if (rc == VINF_TRY_AGAIN)
+                    rc = VINF_SUCCESS;
             }
             else
             {
@@ -1460,6 +1561,7 @@ static DECLCALLBACK(int) usbProxyUsbIpOpen(PUSBPROXYDEV pProxyDev, const char *p
     RTListInit(&pDevUsbIp->ListUrbsInFlight);
     RTListInit(&pDevUsbIp->ListUrbsLanded);
     RTListInit(&pDevUsbIp->ListUrbsToQueue);
+    pProxyDev->fGuestSgUrbs  = true; /* Bulk OUT data is written to the socket straight from guest memory. */
     pDevUsbIp->hSocket       = NIL_RTSOCKET;
     pDevUsbIp->hPollSet      = NIL_RTPOLLSET;
     pDevUsbIp->hPipeW        = NIL_RTPIPE;
@@ -1745,6 +1847,27 @@ static DECLCALLBACK(int) usbProxyUsbIpUrbCancel(PUSBPROXYDEV pProxyDev, PVUSBURB
     PUSBPROXYURBUSBIP pUrbUsbIp = (PUSBPROXYURBUSBIP)pUrb->Dev.pvPrivate;
     UsbIpReqUnlink ReqUnlink;
 
+    /*
+     * An URB which wasn't sent yet is completed right here, the remote never
+     * heard of it and it must not touch the guest memory segments anymore.
+     */
+    int rc = RTSemFastMutexRequest(pProxyDevUsbIp->hMtxLists);
+    AssertRC(rc);
+    PUSBPROXYURBUSBIP pIt;
+    RTListForEach(&pProxyDevUsbIp->ListUrbsToQueue, pIt, USBPROXYURBUSBIP, NodeList)
+    {
+        if (pIt == pUrbUsbIp)
+        {
+            RTListNodeRemove(&pUrbUsbIp->NodeList);
+            pUrbUsbIp->fCancelled = true;
+            pUrbUsbIp->enmStatus  = VUSBSTATUS_CRC;
+            RTListAppend(&pProxyDevUsbIp->ListUrbsLanded, &pUrbUsbIp->NodeList);
+            RTSemFastMutexRelease(pProxyDevUsbIp->hMtxLists);
+            return VINF_SUCCESS;
+        }
+    }
+    RTSemFastMutexRelease(pProxyDevUsbIp->hMtxLists);
+
     RT_ZERO(ReqUnlink);
 
     uint32_t u32SeqNum = usbProxyUsbIpSeqNumGet(pProxyDevUsbIp);
@@ -1756,7 +1879,7 @@ static DECLCALLBACK(int) usbProxyUsbIpUrbCancel(PUSBPROXYDEV pProxyDev, PVUSBURB
     ReqUnlink.u32SeqNum               = pUrbUsbIp->u32SeqNumUrb;
 
     usbProxyUsbIpReqUnlinkH2N(&ReqUnlink);
-    int rc = RTTcpWrite(pProxyDevUsbIp->hSocket, &ReqUnlink, sizeof(ReqUnlink));
+    rc = RTTcpWrite(pProxyDevUsbIp->hSocket, &ReqUnlink, sizeof(ReqUnlink));
     if (RT_SUCCESS(rc))
     {
         pUrbUsbIp->u32SeqNumUrbUnlink = u32SeqNum;
@@ -2403,6 +2403,128 @@ static int vmmdevReqHandler_ReportGuestStats(PVMMDEVCC pThisCC, VMMDevRequestHea
 }
 
 
+/**
+ * Handles VMMDevReq_SetStatisticsPage.
+ *
+ * @returns VBox status code that the guest should see.
+ * @param   pDevIns         The device instance.
+ * @param   pThis           The VMMDev shared instance data.
+ * @param   pReqHdr         The header of the request to handle.
+ */
+static int vmmdevReqHandler_SetStatisticsPage(PPDMDEVINS pDevIns, PVMMDEV pThis, VMMDevRequestHeader *pReqHdr)
+{
+    VMMDevReqStatisticsPage *pReq = (VMMDevReqStatisticsPage *)pReqHdr;
+    AssertMsgReturn(pReq->header.size == sizeof(*pReq), ("%u\n", pReq->header.size), VERR_INVALID_PARAMETER);
+
+    RTGCPHYS const GCPhysPage = pReq->GCPhysPage;
+    if (GCPhysPage == NIL_RTGCPHYS)
+    {
+        LogRel(("VMMDev: Guest statistics page unregistered\n"));
+        pThis->GCPhysStatsPage = NIL_RTGCPHYS;
+        PDMDevHlpTimerStop(pDevIns, pThis->hStatsPageTimer);
+        return VINF_SUCCESS;
+    }
+    AssertMsgReturn(!(GCPhysPage & VMMDEV_PAGE_OFFSET_MASK), ("%RGp\n", GCPhysPage), VERR_INVALID_PARAMETER);
+
+    LogRel(("VMMDev: Guest statistics page registered at %RGp\n", GCPhysPage));
+    pThis->GCPhysStatsPage = GCPhysPage;
+    pThis->uStatsPageSeq   = 0;
+    return PDMDevHlpTimerSetMillies(pDevIns, pThis->hStatsPageTimer, RT_MS_1SEC);
+}
+
+
+/**
+ * @callback_method_impl{FNTMTIMERDEV, Samples the guest statistics page.}
+ *
+ * The guest updates the page in place, so this only costs host CPU time and
+ * no VM exits regardless of the number of CPUs in the guest.
+ */
+static DECLCALLBACK(void) vmmdevStatsPageTimer(PPDMDEVINS pDevIns, TMTIMERHANDLE hTimer, void *pvUser)
+{
+    PVMMDEV   pThis   = PDMDEVINS_2_DATA(pDevIns, PVMMDEV);
+    PVMMDEVCC pThisCC = PDMDEVINS_2_DATA_CC(pDevIns, PVMMDEVCC);
+    Assert(hTimer == pThis->hStatsPageTimer); RT_NOREF(pvUser);
+
+    RTGCPHYS const GCPhysPage = pThis->GCPhysStatsPage;
+    if (GCPhysPage == NIL_RTGCPHYS)
+        return;
+
+    /*
+     * Take a consistent snapshot: the sequence number must be even and must
+     * not change while we copy the page, otherwise retry on the next tick.
+     */
+    VMMDevStatsPage Page;
+    uint32_t        uSeqBefore = 1;
+    uint32_t        uSeqAfter  = 0;
+    PDMDevHlpPhysRead(pDevIns, GCPhysPage + RT_UOFFSETOF(VMMDevStatsPage, u32Seq), &uSeqBefore, sizeof(uSeqBefore));
+    PDMDevHlpPhysRead(pDevIns, GCPhysPage, &Page, sizeof(Page));
+    PDMDevHlpPhysRead(pDevIns, GCPhysPage + RT_UOFFSETOF(VMMDevStatsPage, u32Seq), &uSeqAfter, sizeof(uSeqAfter));
+    if (   (uSeqBefore & 1)
+        || uSeqBefore != uSeqAfter
+        || Page.u32Seq != uSeqBefore)
+        STAM_REL_COUNTER_INC(&pThis->StatStatsPageTorn);
+    else if (   Page.u32Magic   == VMMDEV_STATS_PAGE_MAGIC
+             && Page.u32Version == VMMDEV_STATS_PAGE_VERSION
+             && uSeqAfter != pThis->uStatsPageSeq
+             && pThisCC->pDrv)
+    {
+        pThis->uStatsPageSeq = uSeqAfter;
+        STAM_REL_COUNTER_INC(&pThis->StatStatsPageSamples);
+
+        /*
+         * Feed it to the connector the same way as the per CPU
+         * VMMDevReq_ReportGuestStats requests would.
+         */
+        uint32_t const fMemCaps = Page.u32StatCaps & ~(  VBOX_GUEST_STAT_CPU_LOAD_IDLE | VBOX_GUEST_STAT_CPU_LOAD_KERNEL
+                                                       | VBOX_GUEST_STAT_CPU_LOAD_USER | VBOX_GUEST_STAT_RUN_QUEUE
+                                                       | VBOX_GUEST_STAT_MEM_PRESSURE);
+        uint32_t const fCpuCaps = Page.u32StatCaps & (  VBOX_GUEST_STAT_CPU_LOAD_IDLE | VBOX_GUEST_STAT_CPU_LOAD_KERNEL
+                                                      | VBOX_GUEST_STAT_CPU_LOAD_USER);
+        uint32_t const cCpus    = RT_MIN(Page.cCpus, VMMDEV_STATS_PAGE_MAX_CPUS);
+        for (uint32_t idCpu = 0; idCpu < RT_MAX(cCpus, 1); idCpu++)
+        {
+            VBoxGuestStatistics Stats;
+            RT_ZERO(Stats);
+            Stats.u32CpuId = idCpu;
+            if (idCpu < cCpus)
+            {
+                Stats.u32StatCaps       = fCpuCaps;
+                Stats.u32CpuLoad_Idle   = RT_MIN(Page.aCpus[idCpu].u32CpuLoad_Idle, 100);
+                Stats.u32CpuLoad_Kernel = RT_MIN(Page.aCpus[idCpu].u32CpuLoad_Kernel, 100);
+                Stats.u32CpuLoad_User   = RT_MIN(Page.aCpus[idCpu].u32CpuLoad_User, 100);
+            }
+            if (idCpu == 0)
+            {
+                Stats.u32StatCaps         |= fMemCaps;
+                Stats.u32Threads           = Page.u32Threads;
+                Stats.u32Processes         = Page.u32Processes;
+                Stats.u32Handles           = Page.u32Handles;
+                Stats.u32MemoryLoad        = Page.u32MemoryLoad;
+                Stats.u32PageSize          = Page.u32PageSize;
+                Stats.u32PhysMemTotal      = Page.u32PhysMemTotal;
+                Stats.u32PhysMemAvail      = Page.u32PhysMemAvail;
+                Stats.u32PhysMemBalloon    = Page.u32PhysMemBalloon;
+                Stats.u32MemCommitTotal    = Page.u32MemCommitTotal;
+                Stats.u32MemKernelTotal    = Page.u32MemKernelTotal;
+                Stats.u32MemKernelPaged    = Page.u32MemKernelPaged;
+                Stats.u32MemKernelNonPaged = Page.u32MemKernelNonPaged;
+                Stats.u32MemSystemCache    = Page.u32MemSystemCache;
+                Stats.u32PageFileSize      = Page.u32PageFileSize;
+            }
+            if (Stats.u32StatCaps)
+                pThisCC->pDrv->pfnReportStatistics(pThisCC->pDrv, &Stats);
+        }
+
+        if (Page.u32StatCaps & VBOX_GUEST_STAT_RUN_QUEUE)
+            pThis->StatStatsPageRunQueue = Page.cRunnable;
+        if (Page.u32StatCaps & VBOX_GUEST_STAT_MEM_PRESSURE)
+            pThis->StatStatsPageMemPressure = RT_MIN(Page.uMemPressure, 10000);
+    }
+
+    PDMDevHlpTimerSetMillies(pDevIns, hTimer, RT_MS_1SEC);
+}
+
+
 /**
  * Handles VMMDevReq_QueryCredentials.
  *
@@ -3132,6 +3254,10 @@ static VBOXSTRICTRC vmmdevReqDispatcher(PPDMDEVINS pDevIns, PVMMDEV pThis, PVMMD
             pReqHdr->rc = vmmdevReqHandler_GetHostGraphicsCapability(pThisCC, pReqHdr);
             break;
 
+        case VMMDevReq_SetStatisticsPage:
+            pReqHdr->rc = vmmdevReqHandler_SetStatisticsPage(pDevIns, pThis, pReqHdr);
+            break;
+
         default:
         {
             pReqHdr->rc = VERR_NOT_IMPLEMENTED;
@@ -4343,6 +4469,10 @@ static DECLCALLBACK(int) vmmdevSaveExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
     pHlp->pfnSSMPutStructEx(pSSM, &pThis->displayChangeData, sizeof(pThis->displayChangeData), 0,
                             g_aSSMDISPLAYCHANGEDATAStateFields, NULL);
 
+    /* Statistics page: */
+    pHlp->pfnSSMPutGCPhys(pSSM, pThis->GCPhysStatsPage);
+    PDMDevHlpTimerSave(pDevIns, pThis->hStatsPageTimer, pSSM);
+
     PDMDevHlpCritSectLeave(pDevIns, &pThis->CritSect);
     return VINF_SUCCESS;
 }
@@ -4502,6 +4632,14 @@ static DECLCALLBACK(int) vmmdevLoadExec(PPDMDEVINS pDevIns, PSSMHANDLE pSSM, uin
                                 g_aSSMDISPLAYCHANGEDATAStateFields, NULL);
     }
 
+    if (uVersion >= VMMDEV_SAVED_STATE_VERSION_STATS_PAGE)
+    {
+        pHlp->pfnSSMGetGCPhys(pSSM, &pThis->GCPhysStatsPage);
+        rc = PDMDevHlpTimerLoad(pDevIns, pThis->hStatsPageTimer, pSSM);
+        AssertRCReturn(rc, rc);
+        pThis->uStatsPageSeq = 0;
+    }
+
     /*
      * On a resume, we send the capabilities changed message so
      * that listeners can sync their state again
@@ -4678,6 +4816,13 @@ static DECLCALLBACK(void) vmmdevReset(PPDMDEVINS pDevIns)
     /* disabled statistics updating */
     pThis->cSecsLastStatInterval = 0;
 
+    /* forget the statistics page, the guest has to register it again. */
+    if (pThis->GCPhysStatsPage != NIL_RTGCPHYS)
+    {
+        pThis->GCPhysStatsPage = NIL_RTGCPHYS;
+        PDMDevHlpTimerStop(pDevIns, pThis->hStatsPageTimer);
+    }
+
 #ifdef VBOX_WITH_HGCM
     /* Clear the "HGCM event enabled" flag so the event can be automatically reenabled.  */
     pThisCC->u32HGCMEnabled = 0;
@@ -4814,6 +4959,8 @@ static DECLCALLBACK(int) vmmdevConstruct(PPDMDEVINS pDevIns, int iInstance, PCFG
     pThisCC->pDevIns = pDevIns;
 
     pThis->hFlatlinedTimer      = NIL_TMTIMERHANDLE;
+    pThis->hStatsPageTimer      = NIL_TMTIMERHANDLE;
+    pThis->GCPhysStatsPage      = NIL_RTGCPHYS;
     pThis->hIoPortBackdoorLog   = NIL_IOMIOPORTHANDLE;
     pThis->hIoPortAltTimesync   = NIL_IOMIOPORTHANDLE;
     pThis->hIoPortReq           = NIL_IOMIOPORTHANDLE;
@@ -5272,6 +5419,13 @@ static DECLCALLBACK(int) vmmdevConstruct(PPDMDEVINS pDevIns, int iInstance, PCFG
                               TMTIMER_FLAGS_NO_CRIT_SECT | TMTIMER_FLAGS_RING0, "Heartbeat flatlined", &pThis->hFlatlinedTimer);
     AssertRCReturn(rc, rc);
 
+    /*
+     * Create the statistics page sampling timer.
+     */
+    rc = PDMDevHlpTimerCreate(pDevIns, TMCLOCK_VIRTUAL, vmmdevStatsPageTimer, NULL,
+                              TMTIMER_FLAGS_NO_RING0, "Guest statistics page", &pThis->hStatsPageTimer);
+    AssertRCReturn(rc, rc);
+
 #ifdef VBOX_WITH_HGCM
     rc = vmmdevR3HgcmInit(pThisCC);
     AssertRCReturn(rc, rc);
@@ -5299,6 +5453,14 @@ static DECLCALLBACK(int) vmmdevConstruct(PPDMDEVINS pDevIns, int iInstance, PCFG
                            "Fast IRQ acknowledgments handled in ring-0 or raw-mode.", "FastIrqAckRZ");
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatSlowIrqAck,          STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
                            "Slow IRQ acknowledgments (old style).",         "SlowIrqAck");
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatStatsPageSamples,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                           "Guest statistics page samples passed on.",      "StatsPage/Samples");
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatStatsPageTorn,       STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                           "Guest statistics page samples skipped because the guest was updating it.", "StatsPage/Torn");
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatStatsPageRunQueue,   STAMTYPE_U32, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                           "Guest run queue length (runnable threads).",    "StatsPage/RunQueue");
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatStatsPageMemPressure, STAMTYPE_U32, STAMVISIBILITY_ALWAYS, STAMUNIT_PP10K,
+                           "Guest memory pressure (time stalled on memory).", "StatsPage/MemPressure");
     PDMDevHlpSTAMRegisterF(pDevIns, &pThisCC->StatReqBufAllocs,      STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
                            "Times a larger request buffer was required.",   "LargeReqBufAllocs");
 #ifdef VBOX_WITH_HGCM
@@ -2706,7 +2706,7 @@ int vmmdevR3HgcmInit(PVMMDEVCC pThisCC)
     int rc = RTCritSectInit(&pThisCC->critsectHGCMCmdList);
     AssertLogRelRCReturn(rc, rc);
 
-    rc = RTMemCacheCreate(&pThisCC->hHgcmCmdCache, sizeof(VBOXHGCMCMDCACHED), 64, _1M, NULL, NULL, NULL, 0);
+    rc = RTMemCacheCreate(&pThisCC->hHgcmCmdCache, sizeof(VBOXHGCMCMDCACHED), 64, _1M, NULL, NULL, NULL, RTMEMCACHE_F_MAGAZINES);
     AssertLogRelRCReturn(rc, rc);
 
     pThisCC->u32HGCMEnabled = 0;
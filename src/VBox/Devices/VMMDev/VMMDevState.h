@@ -301,6 +301,26 @@ typedef struct VMMDEV
     TMTIMERHANDLE       hFlatlinedTimer;
     /** @} */
 
+    /** @name Guest statistics page
+     * @{ */
+    /** Guest physical address of the statistics page, NIL_RTGCPHYS if none. */
+    RTGCPHYS            GCPhysStatsPage;
+    /** Timer sampling the statistics page once a second. */
+    TMTIMERHANDLE       hStatsPageTimer;
+    /** The page update sequence number of the last sample passed on. */
+    uint32_t            uStatsPageSeq;
+    /** Alignment padding. */
+    uint32_t            u32Alignment7;
+    /** Last sampled run queue length. */
+    uint32_t            StatStatsPageRunQueue;
+    /** Last sampled memory pressure. */
+    uint32_t            StatStatsPageMemPressure;
+    /** Samples passed on to the connector. */
+    STAMCOUNTER         StatStatsPageSamples;
+    /** Samples skipped because the guest was updating the page. */
+    STAMCOUNTER         StatStatsPageTorn;
+    /** @} */
+
     /** @name Testing
      * @{ */
     /** Set if testing is enabled. */
@@ -576,7 +596,9 @@ void VMMDevCtlSetGuestFilterMask(PPDMDEVINS pDevIns, PVMMDEV pThis, PVMMDEVCC pT
 
 
 /** The saved state version. */
-#define VMMDEV_SAVED_STATE_VERSION                              VMMDEV_SAVED_STATE_VERSION_MMIO_ACCESS
+#define VMMDEV_SAVED_STATE_VERSION                              VMMDEV_SAVED_STATE_VERSION_STATS_PAGE
+/** Added the guest statistics page. */
+#define VMMDEV_SAVED_STATE_VERSION_STATS_PAGE                   21
 /** Added support to optionally use MMIO instead of PIO for passing requests to the host (mainly for ARM). */
 #define VMMDEV_SAVED_STATE_VERSION_MMIO_ACCESS                  20
 /** The saved state version with VMMDev mouse buttons state and wheel movement data. */
@@ -462,6 +462,14 @@ static int hwcCaptureStart(PDRVHOSTWEBCAM pThis)
                                                  pu8Data, cbData, (uint32_t)cWidth, (uint32_t) cHeight, false);
         if (RT_SUCCESS(rc))
         {
+#ifdef AVFTEST
+            FILE *f = fopen("avftest.jpg", "wb");
+            if (f)
+            {
+                fwrite(pu8Encoded, 1, cbEncoded, f);
+                fclose(f);
+            }
+#endif
             if (mpThis && mpThis->pIWebcamUp)
             {
                 VRDEVIDEOINPAYLOADHDR hdr;
@@ -470,22 +478,16 @@ static int hwcCaptureStart(PDRVHOSTWEBCAM pThis)
                 hdr.u32PresentationTime = 0;
                 hdr.u32SourceTimeClock  = 0;
                 hdr.u16Reserved         = 0;
-                mpThis->pIWebcamUp->pfnFrame(mpThis->pIWebcamUp,
-                                             1,
-                                             &hdr,
-                                             sizeof(hdr),
-                                             pu8Encoded,
-                                             cbEncoded);
+                /* The encoded frame is handed over to the device to avoid another copy. */
+                mpThis->pIWebcamUp->pfnFrameOwned(mpThis->pIWebcamUp,
+                                                  1,
+                                                  &hdr,
+                                                  sizeof(hdr),
+                                                  pu8Encoded,
+                                                  cbEncoded);
             }
-#ifdef AVFTEST
-            FILE *f = fopen("avftest.jpg", "wb");
-            if (f)
-            {
-                fwrite(pu8Encoded, 1, cbEncoded, f);
-                fclose(f);
-            }
-#endif
-            RTMemFree(pu8Encoded);
+            else
+                RTMemFree(pu8Encoded);
         }
     }
 
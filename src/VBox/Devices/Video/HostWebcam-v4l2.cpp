@@ -469,15 +469,25 @@ static void hwcSample(PDRVHOSTWEBCAM pThis, void *pvData, uint32_t cbData)
             hdr.u32PresentationTime = 0;
             hdr.u32SourceTimeClock  = 0;
             hdr.u16Reserved         = 0;
-            pThis->pIWebcamUp->pfnFrame(pThis->pIWebcamUp,
-                                        1,
-                                        &hdr,
-                                        sizeof(hdr),
-                                        pvFrame,
-                                        cbFrame);
             if (pvFrame != pvData)
             {
-                RTMemFree(pvFrame);
+                /* The encoded frame is handed over to the device to avoid another copy. */
+                pThis->pIWebcamUp->pfnFrameOwned(pThis->pIWebcamUp,
+                                                 1,
+                                                 &hdr,
+                                                 sizeof(hdr),
+                                                 pvFrame,
+                                                 cbFrame);
+            }
+            else
+            {
+                /* MJPG passthrough, the capture buffer goes back to the driver. */
+                pThis->pIWebcamUp->pfnFrame(pThis->pIWebcamUp,
+                                            1,
+                                            &hdr,
+                                            sizeof(hdr),
+                                            pvFrame,
+                                            cbFrame);
             }
         }
     }
@@ -692,15 +692,25 @@ class SampleGrabberCallback: public ISampleGrabberCB
                         hdr.u32PresentationTime = 0;
                         hdr.u32SourceTimeClock  = 0;
                         hdr.u16Reserved         = 0;
-                        mpThis->pIWebcamUp->pfnFrame(mpThis->pIWebcamUp,
-                                                     1,
-                                                     &hdr,
-                                                     sizeof(hdr),
-                                                     pvFrame,
-                                                     cbFrame);
                         if (pvFrame != pData)
                         {
-                            RTMemFree(pvFrame);
+                            /* The encoded frame is handed over to the device to avoid another copy. */
+                            mpThis->pIWebcamUp->pfnFrameOwned(mpThis->pIWebcamUp,
+                                                              1,
+                                                              &hdr,
+                                                              sizeof(hdr),
+                                                              pvFrame,
+                                                              cbFrame);
+                        }
+                        else
+                        {
+                            /* MJPG passthrough, the sample buffer belongs to DirectShow. */
+                            mpThis->pIWebcamUp->pfnFrame(mpThis->pIWebcamUp,
+                                                         1,
+                                                         &hdr,
+                                                         sizeof(hdr),
+                                                         pvFrame,
+                                                         cbFrame);
                         }
                     }
                 }
@@ -1349,10 +1349,16 @@ static void usbWebcamFrameRelease(USBWEBCAM *pThis,
     }
 }
 
+/*
+ * @param ppu8Owned If not NULL, points to a heap buffer with the frame data which
+ *                  is adopted by the new frame instead of being copied. Set to NULL
+ *                  when the frame took ownership.
+ */
 static int usbWebcamFrameCreate(USBWEBCAM *pThis,
                                 USBWEBCAMPENDINGFRAME **ppFrame,
                                 const uint8_t *pu8Data,
-                                uint32_t cbData)
+                                uint32_t cbData,
+                                uint8_t **ppu8Owned)
 {
     int rc = VINF_SUCCESS;
 
@@ -1367,7 +1373,13 @@ static int usbWebcamFrameCreate(USBWEBCAM *pThis,
 
         if (cbData > 0)
         {
-            pFrame->pu8Data = (uint8_t *)RTMemDup(pu8Data, cbData);
+            if (ppu8Owned && *ppu8Owned == pu8Data)
+            {
+                pFrame->pu8Data = *ppu8Owned;
+                *ppu8Owned = NULL;
+            }
+            else
+                pFrame->pu8Data = (uint8_t *)RTMemDup(pu8Data, cbData);
 
             if (pFrame->pu8Data)
             {
@@ -1411,18 +1423,19 @@ static void usbWebcamFrameQueueAdd(USBWEBCAM *pThis,
 static int usbWebcamFrameUpdate(USBWEBCAM *pThis,
                                 const uint8_t *pu8Data,
                                 uint32_t cbData,
-                                const VRDEVIDEOINPAYLOADHDR *pHdr)
+                                const VRDEVIDEOINPAYLOADHDR *pHdr,
+                                uint8_t **ppu8Owned)
 {
     /* Prepare a frame which will be sent to the guest. */
     USBWEBCAMPENDINGFRAME *pFrame = NULL;
-    int rc = usbWebcamFrameCreate(pThis, &pFrame, pu8Data, cbData);
+    int rc = usbWebcamFrameCreate(pThis, &pFrame, pu8Data, cbData, ppu8Owned);
 
     if (RT_SUCCESS(rc))
     {
         pFrame->hdr = *pHdr;
 
         int rc2 = usbWebcamFramePrepare(pThis, pFrame);
-        if (RT_FAILURE(rc2))
+        if (RT_FAILURE(rc2) && pFrame->pu8Data != pu8Data)
         {
             /* Restore the frame content. */
             memcpy(pFrame->pu8Data, pu8Data, pFrame->cbData);
@@ -1530,7 +1543,7 @@ static uint8_t usbWebcamStreamSetup(USBWEBCAM *pThis)
             hdr.u32SourceTimeClock  = 0;
             hdr.u16Reserved         = 0;
 
-            usbWebcamFrameUpdate(pThis, pu8StandaloneFrame, cbStandaloneFrame, &hdr);
+            usbWebcamFrameUpdate(pThis, pu8StandaloneFrame, cbStandaloneFrame, &hdr, NULL /* ppu8Owned */);
 
             usbWebcamJPGFree(pu8StandaloneFrame);
         }
@@ -2742,7 +2755,7 @@ static int usbWebcamControl(USBWEBCAM *pThis, bool fResponse, void *pvUser,
 }
 
 static int usbWebcamFrame(USBWEBCAM *pThis, const VRDEVIDEOINPAYLOADHDR *pHdr, uint32_t cbHdr,
-                          const void *pvFrame, uint32_t cbFrame)
+                          const void *pvFrame, uint32_t cbFrame, uint8_t **ppu8Owned)
 {
     RT_NOREF1(cbHdr);
     int rc = VINF_SUCCESS;
@@ -2757,7 +2770,7 @@ static int usbWebcamFrame(USBWEBCAM *pThis, const VRDEVIDEOINPAYLOADHDR *pHdr, u
 
     if (pThis->enmStreamStatus == UW_STREAM_STATUS_ON)
     {
-        rc = usbWebcamFrameUpdate(pThis, (const uint8_t *)pvFrame, cbFrame, pHdr);
+        rc = usbWebcamFrameUpdate(pThis, (const uint8_t *)pvFrame, cbFrame, pHdr, ppu8Owned);
         if (RT_SUCCESS(rc))
         {
             /* Put the frame into queue to be delivered to the guest. */
@@ -3128,12 +3141,11 @@ static DECLCALLBACK(void) usbWebcamUpControl(PPDMIWEBCAMDEV pInterface, bool fRe
 }
 
 
-static DECLCALLBACK(void) usbWebcamUpFrame(PPDMIWEBCAMDEV pInterface, uint64_t idDevice,
-                                           struct VRDEVIDEOINPAYLOADHDR const *pHeader,
-                                           uint32_t cbHeader, const void *pvFrame, uint32_t cbFrame)
+static void usbWebcamUpFrameWorker(PUSBWEBCAM pThis, uint64_t idDevice,
+                                   struct VRDEVIDEOINPAYLOADHDR const *pHeader,
+                                   uint32_t cbHeader, const void *pvFrame, uint32_t cbFrame,
+                                   uint8_t **ppu8Owned)
 {
-    PUSBWEBCAM pThis = RT_FROM_MEMBER(pInterface, USBWEBCAM, IWebcamDev);
-
     UWLOG(("idDevice %llu(%llu), cbFrame %d, hdr:\n%.*Rhxd\n",
            idDevice, pThis->webcam.idDevice, cbFrame, RT_MIN(cbHeader, 32), pHeader));
 
@@ -3168,7 +3180,7 @@ static DECLCALLBACK(void) usbWebcamUpFrame(PPDMIWEBCAMDEV pInterface, uint64_t i
             if (   cbHeader >= sizeof(VRDEVIDEOINPAYLOADHDR)
                 && cbHeader >= pHeader->u8HeaderLength)
             {
-                rc = usbWebcamFrame(pThis, pHeader, cbHeader, pvFrame, cbFrame);
+                rc = usbWebcamFrame(pThis, pHeader, cbHeader, pvFrame, cbFrame, ppu8Owned);
                 if (RT_FAILURE(rc))
                     UWLOG(("Frame dropped %Rrc\n", rc));
             }
@@ -3195,6 +3207,28 @@ static DECLCALLBACK(void) usbWebcamUpFrame(PPDMIWEBCAMDEV pInterface, uint64_t i
 }
 
 
+static DECLCALLBACK(void) usbWebcamUpFrame(PPDMIWEBCAMDEV pInterface, uint64_t idDevice,
+                                           struct VRDEVIDEOINPAYLOADHDR const *pHeader,
+                                           uint32_t cbHeader, const void *pvFrame, uint32_t cbFrame)
+{
+    PUSBWEBCAM pThis = RT_FROM_MEMBER(pInterface, USBWEBCAM, IWebcamDev);
+    usbWebcamUpFrameWorker(pThis, idDevice, pHeader, cbHeader, pvFrame, cbFrame, NULL /* ppu8Owned */);
+}
+
+
+static DECLCALLBACK(void) usbWebcamUpFrameOwned(PPDMIWEBCAMDEV pInterface, uint64_t idDevice,
+                                                struct VRDEVIDEOINPAYLOADHDR const *pHeader,
+                                                uint32_t cbHeader, void *pvFrame, uint32_t cbFrame)
+{
+    PUSBWEBCAM pThis = RT_FROM_MEMBER(pInterface, USBWEBCAM, IWebcamDev);
+
+    /* The queued frame keeps the buffer, if it was not queued then it is freed here. */
+    uint8_t *pu8Owned = (uint8_t *)pvFrame;
+    usbWebcamUpFrameWorker(pThis, idDevice, pHeader, cbHeader, pvFrame, cbFrame, &pu8Owned);
+    RTMemFree(pu8Owned);
+}
+
+
 /**
  * @callback_method_impl{PFNPDMTHREADUSB}
  */
@@ -3666,10 +3700,11 @@ static DECLCALLBACK(int) usbWebcamConstruct(PPDMUSBINS pUsbIns, int iInstance, P
 
     pThis->IBase.pfnQueryInterface = usbWebcamQueryInterface;
 
-    pThis->IWebcamDev.pfnAttached = usbWebcamUpAttached;
-    pThis->IWebcamDev.pfnDetached = usbWebcamUpDetached;
-    pThis->IWebcamDev.pfnControl  = usbWebcamUpControl;
-    pThis->IWebcamDev.pfnFrame    = usbWebcamUpFrame;
+    pThis->IWebcamDev.pfnAttached   = usbWebcamUpAttached;
+    pThis->IWebcamDev.pfnDetached   = usbWebcamUpDetached;
+    pThis->IWebcamDev.pfnControl    = usbWebcamUpControl;
+    pThis->IWebcamDev.pfnFrame      = usbWebcamUpFrame;
+    pThis->IWebcamDev.pfnFrameOwned = usbWebcamUpFrameOwned;
 
     urbQueueInit(&pThis->urbQueues.BulkIn);
     urbQueueInit(&pThis->urbQueues.IntrIn);
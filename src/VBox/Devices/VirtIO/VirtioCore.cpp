@@ -48,6 +48,7 @@
 #include "VirtioCore.h"
 
 #ifdef VIRTIO_REL_INFO_DUMP
+#include <iprt/sort.h>
 #include <iprt/trace.h>
 #endif /* VIRTIO_REL_INFO_DUMP */
 
@@ -104,6 +105,26 @@
 #define VIRTQ_AVAIL_F_NO_INTERRUPT                      1        /**< Drv to Dev: Don't notify when buf eaten   */
 /** @} */
 
+/** @name Packed virtq related flags and position encoding (VirtIO 1.1, 2.7)
+ * @{ */
+#define VIRTQ_DESC_F_AVAIL                              RT_BIT(7)   /**< Avail wrap counter as seen by driver   */
+#define VIRTQ_DESC_F_USED                               RT_BIT(15)  /**< Used wrap counter as seen by device    */
+
+#define VIRTQ_PACKED_EVENT_F_ENABLE                     0        /**< Event suppression: notify always          */
+#define VIRTQ_PACKED_EVENT_F_DISABLE                    1        /**< Event suppression: don't notify           */
+#define VIRTQ_PACKED_EVENT_F_DESC                       2        /**< Event suppression: notify at off_wrap     */
+
+/** The shadow indices of a packed virtq hold the ring slot in the low 15 bits and the
+ *  wrap counter in the top bit, the same encoding used for off_wrap by the spec. */
+#define VIRTQ_PACKED_WRAP                               UINT16_C(0x8000)
+#define VIRTQ_PACKED_IDX_MASK                           UINT16_C(0x7fff)
+/** @} */
+
+/** Maximum number of descriptors fetched at once when walking a descriptor chain. */
+#define VIRTQ_DESC_PREFETCH_MAX                         16
+
+#define IS_VIRTQ_PACKED(a_pVirtio)          RT_BOOL((a_pVirtio)->uDriverFeatures & VIRTIO_F_RING_PACKED)
+
 /**
  * virtq-related structs
  * (struct names follow VirtIO 1.0 spec, field names use VBox styled naming, w/respective spec'd name in comments)
@@ -140,6 +161,21 @@ typedef struct virt_used
     //uint16_t  uAvailEventIdx;                                  /**< avail_event if (VIRTQ_USED_F_EVENT_IDX)   */
 } VIRTQ_USED_T, *PVIRTQ_USED_T;
 
+typedef struct virtq_packed_desc
+{
+    uint64_t  GCPhysBuf;                                         /**< addr       GC Phys. address of buffer     */
+    uint32_t  cb;                                                /**< len        Buffer length / bytes used     */
+    uint16_t  uBufId;                                            /**< id         Buffer ID                      */
+    uint16_t  fFlags;                                            /**< flags      Buffer and wrap flags          */
+} VIRTQ_PACKED_DESC_T, *PVIRTQ_PACKED_DESC_T;
+AssertCompileSize(VIRTQ_PACKED_DESC_T, sizeof(VIRTQ_DESC_T));
+
+typedef struct virtq_packed_event
+{
+    uint16_t  uOffWrap;                                          /**< off_wrap   Desc position to notify at     */
+    uint16_t  fFlags;                                            /**< flags      VIRTQ_PACKED_EVENT_F_XXX       */
+} VIRTQ_PACKED_EVENT_T;
+
 DECLHIDDEN(const char *) virtioCoreGetStateChangeText(VIRTIOVMSTATECHANGED enmState)
 {
     switch (enmState)
@@ -173,12 +209,62 @@ DECLINLINE(uint16_t) virtioCoreR3CountPendingBufs(uint16_t uRingIdx, uint16_t uS
 /** @name Internal queue operations
  * @{ */
 
+#ifdef IN_RING3
 /**
- * Accessor for virtq descriptor
+ * Reads from a virtq ring thru the queue's guest mapping cache.
+ *
+ * The cache is not serialized, so this falls back on the regular physical
+ * read when another thread is using it, as well as for legacy and MMIO
+ * transports.
  */
-#ifdef IN_RING3
-DECLINLINE(void) virtioReadDesc(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq,
-                                uint32_t idxDesc, PVIRTQ_DESC_T pDesc)
+static void virtioR3VirtqRingRead(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq,
+                                  RTGCPHYS GCPhys, void *pvBuf, size_t cbRead)
+{
+    PPDMPHYSMAPCACHE pCache = pVirtq->pPhysMapCacheR3;
+    if (   pCache
+        && !virtioCoreIsLegacyMode(pVirtio)
+        && !pVirtio->uIrqMmio
+        && ASMAtomicCmpXchgBool(&pVirtq->fPhysMapCacheBusy, true, false))
+    {
+        PDMDevHlpPhysMapCacheRead(pDevIns, pCache, GCPhys, pvBuf, cbRead);
+        ASMAtomicWriteBool(&pVirtq->fPhysMapCacheBusy, false);
+    }
+    else
+        virtioCoreGCPhysRead(pVirtio, pDevIns, GCPhys, pvBuf, cbRead);
+}
+
+/**
+ * Window of descriptors fetched from the descriptor table in one go while
+ * walking a chain, see virtioR3ReadDescPrefetch().
+ */
+typedef struct VIRTQDESCWINDOW
+{
+    /** Table index of the first descriptor in the window. */
+    uint16_t        idxFirst;
+    /** Number of valid descriptors in the window, 0 if empty. */
+    uint16_t        cDescs;
+    /** The descriptors, raw (split and packed layouts have the same size). */
+    VIRTQ_DESC_T    aDescs[VIRTQ_DESC_PREFETCH_MAX];
+} VIRTQDESCWINDOW;
+/** Pointer to a descriptor window. */
+typedef VIRTQDESCWINDOW *PVIRTQDESCWINDOW;
+
+/**
+ * Accessor for virtq descriptors while walking a chain.
+ *
+ * Chains are mostly laid out in consecutive table entries (always for packed
+ * virtqs), so a miss fetches up to VIRTQ_DESC_PREFETCH_MAX entries at once
+ * (not wrapping around the end of the table) instead of reading the guest
+ * memory once per descriptor.  Prefetched entries beyond the chain are never
+ * looked at, so it doesn't matter if the guest is still updating them.
+ *
+ * @param   pWnd        The descriptor window, cDescs initialized to zero.
+ * @param   idxDesc     The descriptor table index.
+ * @param   pDesc       Where to return the descriptor.  Reinterpreted as
+ *                      VIRTQ_PACKED_DESC_T by the packed virtq callers.
+ */
+DECLINLINE(void) virtioR3ReadDescPrefetch(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq,
+                                          PVIRTQDESCWINDOW pWnd, uint32_t idxDesc, PVIRTQ_DESC_T pDesc)
 {
     /*
      * Shut up assertion for legacy virtio-net driver in FreeBSD up to 12.3 (see virtioCoreR3VirtqUsedBufPut()
@@ -190,9 +276,18 @@ DECLINLINE(void) virtioReadDesc(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQU
               ("Called with guest driver not ready\n"));
     uint16_t const cVirtqItems = RT_MAX(pVirtq->uQueueSize, 1); /* Make sure to avoid div-by-zero. */
 
-    virtioCoreGCPhysRead(pVirtio, pDevIns,
-                         pVirtq->GCPhysVirtqDesc + sizeof(VIRTQ_DESC_T) * (idxDesc % cVirtqItems),
-                         pDesc, sizeof(VIRTQ_DESC_T));
+    idxDesc %= cVirtqItems;
+    if (   idxDesc <  pWnd->idxFirst
+        || idxDesc >= (uint32_t)pWnd->idxFirst + pWnd->cDescs)
+    {
+        uint16_t const cDescs = (uint16_t)RT_MIN(VIRTQ_DESC_PREFETCH_MAX, cVirtqItems - idxDesc);
+        virtioR3VirtqRingRead(pDevIns, pVirtio, pVirtq,
+                              pVirtq->GCPhysVirtqDesc + sizeof(VIRTQ_DESC_T) * idxDesc,
+                              &pWnd->aDescs[0], sizeof(VIRTQ_DESC_T) * cDescs);
+        pWnd->idxFirst = (uint16_t)idxDesc;
+        pWnd->cDescs   = cDescs;
+    }
+    *pDesc = pWnd->aDescs[idxDesc - pWnd->idxFirst];
 }
 #endif
 
@@ -206,9 +301,9 @@ DECLINLINE(uint16_t) virtioReadAvailDescIdx(PPDMDEVINS pDevIns, PVIRTIOCORE pVir
 
     AssertMsg(pVirtio->fLegacyDriver || IS_DRIVER_OK(pVirtio), ("Called with guest driver not ready\n"));
     uint16_t const cVirtqItems = RT_MAX(pVirtq->uQueueSize, 1); /* Make sure to avoid div-by-zero. */
-    virtioCoreGCPhysRead(pVirtio, pDevIns,
-                         pVirtq->GCPhysVirtqAvail + RT_UOFFSETOF_DYN(VIRTQ_AVAIL_T, auRing[availIdx % cVirtqItems]),
-                         &uDescIdx, sizeof(uDescIdx));
+    virtioR3VirtqRingRead(pDevIns, pVirtio, pVirtq,
+                          pVirtq->GCPhysVirtqAvail + RT_UOFFSETOF_DYN(VIRTQ_AVAIL_T, auRing[availIdx % cVirtqItems]),
+                          &uDescIdx, sizeof(uDescIdx));
     return uDescIdx;
 }
 
@@ -315,9 +410,134 @@ DECLINLINE(void) virtioWriteUsedAvailEvent(PPDMDEVINS pDevIns, PVIRTIOCORE pVirt
 #endif
 /** @} */
 
+/** @name Accessors for packed virtq descriptor ring and event suppression areas
+ * @{
+ */
+
+/**
+ * Advances a packed virtq position by @a cSlots descriptors, toggling the wrap counter
+ * when going past the end of the ring.
+ */
+DECLINLINE(uint16_t) virtioPackedPosAdvance(PVIRTQUEUE pVirtq, uint16_t uPos, uint16_t cSlots)
+{
+    uint16_t const cVirtqItems = RT_MAX(pVirtq->uQueueSize, 1); /* Make sure to avoid div-by-zero. */
+    uint32_t       uIdx        = (uint32_t)(uPos & VIRTQ_PACKED_IDX_MASK) + cSlots;
+    uint16_t       fWrap       = uPos & VIRTQ_PACKED_WRAP;
+    while (uIdx >= cVirtqItems)
+    {
+        uIdx  -= cVirtqItems;
+        fWrap ^= VIRTQ_PACKED_WRAP;
+    }
+    return (uint16_t)uIdx | fWrap;
+}
+
+DECLINLINE(RTGCPHYS) virtioPackedDescAddr(PVIRTQUEUE pVirtq, uint16_t uPos)
+{
+    uint16_t const cVirtqItems = RT_MAX(pVirtq->uQueueSize, 1); /* Make sure to avoid div-by-zero. */
+    return pVirtq->GCPhysVirtqDesc + sizeof(VIRTQ_PACKED_DESC_T) * ((uPos & VIRTQ_PACKED_IDX_MASK) % cVirtqItems);
+}
+
+DECLINLINE(uint16_t) virtioReadPackedDescFlags(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq, uint16_t uPos)
+{
+    uint16_t fFlags = 0;
+    AssertMsg(IS_DRIVER_OK(pVirtio), ("Called with guest driver not ready\n"));
+    virtioCoreGCPhysRead(pVirtio, pDevIns, virtioPackedDescAddr(pVirtq, uPos) + RT_UOFFSETOF(VIRTQ_PACKED_DESC_T, fFlags),
+                         &fFlags, sizeof(fFlags));
+    return fFlags;
+}
+
+/**
+ * A packed descriptor is available when its AVAIL flag matches the wrap counter
+ * of the position it is read at and its USED flag doesn't (VirtIO 1.1, 2.7.1).
+ */
+DECLINLINE(bool) virtioPackedDescIsAvail(uint16_t fFlags, uint16_t uPos)
+{
+    bool const fWrap = RT_BOOL(uPos & VIRTQ_PACKED_WRAP);
+    return RT_BOOL(fFlags & VIRTQ_DESC_F_AVAIL) == fWrap
+        && RT_BOOL(fFlags & VIRTQ_DESC_F_USED)  != fWrap;
+}
+
+/**
+ * Returns the number of descriptors of the chain made available at @a uPos, 0 if none.
+ *
+ * Only the head is checked, the driver makes it available after the rest of the chain.
+ */
+DECLINLINE(uint16_t) virtioPackedChainLen(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq, uint16_t uPos)
+{
+    uint16_t fFlags = virtioReadPackedDescFlags(pDevIns, pVirtio, pVirtq, uPos);
+    if (!virtioPackedDescIsAvail(fFlags, uPos))
+        return 0;
+
+    uint16_t cDescs = 1;
+    while (   (fFlags & VIRTQ_DESC_F_NEXT)
+           && cDescs < pVirtq->uQueueSize)
+    {
+        uPos   = virtioPackedPosAdvance(pVirtq, uPos, 1);
+        fFlags = virtioReadPackedDescFlags(pDevIns, pVirtio, pVirtq, uPos);
+        cDescs++;
+    }
+    return cDescs;
+}
+
+#ifdef IN_RING3
+/** Writes the ID and length of a used descriptor, the flags handing it back follow separately. */
+DECLINLINE(void) virtioWritePackedUsedDesc(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq,
+                                           uint16_t uPos, uint16_t uBufId, uint32_t cbUsed)
+{
+    VIRTQ_PACKED_DESC_T desc;
+    desc.cb     = cbUsed;
+    desc.uBufId = uBufId;
+    AssertMsg(IS_DRIVER_OK(pVirtio), ("Called with guest driver not ready\n"));
+    virtioCoreGCPhysWrite(pVirtio, pDevIns, virtioPackedDescAddr(pVirtq, uPos) + RT_UOFFSETOF(VIRTQ_PACKED_DESC_T, cb),
+                          &desc.cb, RT_UOFFSETOF(VIRTQ_PACKED_DESC_T, fFlags) - RT_UOFFSETOF(VIRTQ_PACKED_DESC_T, cb));
+}
+
+DECLINLINE(void) virtioWritePackedDescFlags(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq,
+                                            uint16_t uPos, uint16_t fFlags)
+{
+    AssertMsg(IS_DRIVER_OK(pVirtio), ("Called with guest driver not ready\n"));
+    ASMMemoryFence(); /* ID and length must be visible before the flags hand the descriptor back. */
+    virtioCoreGCPhysWrite(pVirtio, pDevIns, virtioPackedDescAddr(pVirtq, uPos) + RT_UOFFSETOF(VIRTQ_PACKED_DESC_T, fFlags),
+                          &fFlags, sizeof(fFlags));
+}
+
+/** The driver event suppression structure lives where the avail ring would be. */
+DECLINLINE(void) virtioReadPackedDriverEvent(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq,
+                                             VIRTQ_PACKED_EVENT_T *pEvent)
+{
+    AssertMsg(IS_DRIVER_OK(pVirtio), ("Called with guest driver not ready\n"));
+    virtioCoreGCPhysRead(pVirtio, pDevIns, pVirtq->GCPhysVirtqAvail, pEvent, sizeof(*pEvent));
+}
+
+/** The device event suppression structure lives where the used ring would be. */
+DECLINLINE(void) virtioWritePackedDeviceEventFlags(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq, uint16_t fFlags)
+{
+    AssertMsg(IS_DRIVER_OK(pVirtio), ("Called with guest driver not ready\n"));
+    virtioCoreGCPhysWrite(pVirtio, pDevIns, pVirtq->GCPhysVirtqUsed + RT_UOFFSETOF(VIRTQ_PACKED_EVENT_T, fFlags),
+                          &fFlags, sizeof(fFlags));
+}
+#endif
+/** @} */
+
 
 DECLINLINE(uint16_t) virtioCoreVirtqAvailCnt(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq)
 {
+    if (IS_VIRTQ_PACKED(pVirtio))
+    {
+        /* There is no avail index to compare with, so count the chains the driver has made available. */
+        uint16_t cChains = 0;
+        uint16_t uPos    = pVirtq->uAvailIdxShadow;
+        for (uint32_t cSlots = 0; cSlots < pVirtq->uQueueSize; cChains++)
+        {
+            uint16_t const cDescs = virtioPackedChainLen(pDevIns, pVirtio, pVirtq, uPos);
+            if (!cDescs)
+                break;
+            cSlots += cDescs;
+            uPos    = virtioPackedPosAdvance(pVirtq, uPos, cDescs);
+        }
+        return cChains;
+    }
+
     uint16_t uIdxActual = virtioReadAvailRingIdx(pDevIns, pVirtio, pVirtq);
     uint16_t uIdxShadow = pVirtq->uAvailIdxShadow;
     uint16_t uIdxDelta;
@@ -596,6 +816,18 @@ DECLHIDDEN(int) virtioCoreR3VirtqAttach(PVIRTIOCORE pVirtio, uint16_t uVirtq, co
     pVirtq->fUsedRingEvent = false;
     pVirtq->fAttached = true;
     RTStrCopy(pVirtq->szName, sizeof(pVirtq->szName), pcszName);
+
+    /* Map cache for the descriptor table and avail ring (PCI transport only, optional). */
+    PPDMDEVINS pDevIns = pVirtio->pDevInsR3;
+    if (   !pVirtq->pPhysMapCacheR3
+        && !pVirtio->uIrqMmio)
+    {
+        char szName[16];
+        RTStrPrintf(szName, sizeof(szName), "Virtq%u", uVirtq);
+        int rc = PDMDevHlpPhysMapCacheCreate(pDevIns, NULL /*pPciDev*/, 16 /*cEntries*/, szName, &pVirtq->pPhysMapCacheR3);
+        if (RT_FAILURE(rc))
+            LogRel(("%s: Failed to create the map cache for %s: %Rrc\n", pVirtio->szInstance, pcszName, rc));
+    }
     return VINF_SUCCESS;
 }
 
@@ -675,43 +907,140 @@ static const char *virtioCoreEventText[] = {
     "sync  used"
 };
 
+/*
+ * Each virtqueue traces into its own buffer, so the worker threads of a multi-queue device
+ * don't contend on a shared trace buffer index.  The buffers are merged by timestamp when dumped.
+ */
+#define VIRTIO_CORE_TRACE_BUF_ENTRIES   64
+#define VIRTIO_CORE_TRACE_BUF_ENTRY_SIZE 128
+
 static void virtioCoreTraceEvent(PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq, const uint8_t event, uint16_t ringIdx, uint16_t descIdx)
 {
+    RT_NOREF(pVirtio);
+    if (pVirtq->hTraceBuf == NIL_RTTRACEBUF)
+        return;
     if (pVirtq->uQueueSize)
     {
         if (event == VIRTIO_CORE_EVENT_AVAIL_NEXT || event == VIRTIO_CORE_EVENT_USED_SYNC)
-            RTTraceBufAddMsgF(pVirtio->hTraceBuf, "%s: %s[%u]\n", pVirtq->szName, virtioCoreEventText[event], ringIdx % pVirtq->uQueueSize);
+            RTTraceBufAddMsgF(pVirtq->hTraceBuf, "%s: %s[%u]\n", pVirtq->szName, virtioCoreEventText[event], ringIdx % pVirtq->uQueueSize);
         else
-            RTTraceBufAddMsgF(pVirtio->hTraceBuf, "%s: %s[%u]=%u\n", pVirtq->szName, virtioCoreEventText[event], ringIdx % pVirtq->uQueueSize, descIdx);
+            RTTraceBufAddMsgF(pVirtq->hTraceBuf, "%s: %s[%u]=%u\n", pVirtq->szName, virtioCoreEventText[event], ringIdx % pVirtq->uQueueSize, descIdx);
     }
     else
     {
         if (event == VIRTIO_CORE_EVENT_AVAIL_NEXT || event == VIRTIO_CORE_EVENT_USED_SYNC)
-            RTTraceBufAddMsgF(pVirtio->hTraceBuf, "%s: %s[%u]\n", pVirtq->szName, virtioCoreEventText[event], ringIdx);
+            RTTraceBufAddMsgF(pVirtq->hTraceBuf, "%s: %s[%u]\n", pVirtq->szName, virtioCoreEventText[event], ringIdx);
         else
-            RTTraceBufAddMsgF(pVirtio->hTraceBuf, "%s: %s[%u]=%u\n", pVirtq->szName, virtioCoreEventText[event], ringIdx, descIdx);
+            RTTraceBufAddMsgF(pVirtq->hTraceBuf, "%s: %s[%u]=%u\n", pVirtq->szName, virtioCoreEventText[event], ringIdx, descIdx);
     }
 }
 
-static DECLCALLBACK(int) dumpOneEntryToRelLog(RTTRACEBUF hTraceBuf, uint32_t iEntry, uint64_t NanoTS, RTCPUID idCpu, const char *pszMsg, void *pvUser)
+/** One trace entry collected for the merged dump. */
+typedef struct VIRTIOTRACEDUMPENTRY
+{
+    uint64_t    NanoTS;
+    RTCPUID     idCpu;
+    char        szMsg[VIRTIO_CORE_TRACE_BUF_ENTRY_SIZE];
+} VIRTIOTRACEDUMPENTRY;
+
+/** Collection state for the merged dump. */
+typedef struct VIRTIOTRACEDUMP
+{
+    VIRTIOTRACEDUMPENTRY   *paEntries;
+    size_t                  cEntries;
+    size_t                  cMaxEntries;
+} VIRTIOTRACEDUMP;
+
+static DECLCALLBACK(int) collectOneTraceEntry(RTTRACEBUF hTraceBuf, uint32_t iEntry, uint64_t NanoTS, RTCPUID idCpu, const char *pszMsg, void *pvUser)
 {
-    RT_NOREF(hTraceBuf, pvUser);
-    LogRel(("%03u / %llu / %02u / %s", iEntry, NanoTS, idCpu, pszMsg));
+    RT_NOREF(hTraceBuf, iEntry);
+    VIRTIOTRACEDUMP *pDump = (VIRTIOTRACEDUMP *)pvUser;
+    if (pDump->cEntries >= pDump->cMaxEntries)
+        return VERR_BUFFER_OVERFLOW;
+    VIRTIOTRACEDUMPENTRY *pEntry = &pDump->paEntries[pDump->cEntries++];
+    pEntry->NanoTS = NanoTS;
+    pEntry->idCpu  = idCpu;
+    RTStrCopy(pEntry->szMsg, sizeof(pEntry->szMsg), pszMsg);
     return VINF_SUCCESS;
 }
 
-static inline void virtioCoreDumpTraceBufToRelLog(RTTRACEBUF hTraceBuf)
+static DECLCALLBACK(int) compareTraceEntries(void const *pvElement1, void const *pvElement2, void *pvUser)
 {
-    RTTraceBufEnumEntries(hTraceBuf, dumpOneEntryToRelLog, NULL);
+    RT_NOREF(pvUser);
+    uint64_t const NanoTS1 = ((VIRTIOTRACEDUMPENTRY const *)pvElement1)->NanoTS;
+    uint64_t const NanoTS2 = ((VIRTIOTRACEDUMPENTRY const *)pvElement2)->NanoTS;
+    return NanoTS1 < NanoTS2 ? -1 : NanoTS1 > NanoTS2 ? 1 : 0;
+}
+
+/**
+ * Dumps the trace buffers of all virtqueues to the release log, merged into one
+ * timeline by the entry timestamps.
+ */
+static void virtioCoreDumpTraceBufToRelLog(PVIRTIOCORE pVirtio)
+{
+    VIRTIOTRACEDUMP Dump;
+    Dump.cEntries    = 0;
+    Dump.cMaxEntries = RT_ELEMENTS(pVirtio->aVirtqueues) * VIRTIO_CORE_TRACE_BUF_ENTRIES;
+    Dump.paEntries   = (VIRTIOTRACEDUMPENTRY *)RTMemAlloc(Dump.cMaxEntries * sizeof(Dump.paEntries[0]));
+    if (!Dump.paEntries)
+        return;
+
+    for (uint32_t uVirtq = 0; uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues); uVirtq++)
+        if (pVirtio->aVirtqueues[uVirtq].hTraceBuf != NIL_RTTRACEBUF)
+            RTTraceBufEnumEntries(pVirtio->aVirtqueues[uVirtq].hTraceBuf, collectOneTraceEntry, &Dump);
+
+    RTSortShell(Dump.paEntries, Dump.cEntries, sizeof(Dump.paEntries[0]), compareTraceEntries, NULL);
+    for (size_t i = 0; i < Dump.cEntries; i++)
+        LogRel(("%03zu / %llu / %02u / %s", i, Dump.paEntries[i].NanoTS, Dump.paEntries[i].idCpu, Dump.paEntries[i].szMsg));
+
+    RTMemFree(Dump.paEntries);
 }
 #endif /* VIRTIO_REL_INFO_DUMP */
 
+/**
+ * Displays the state of a packed virtq, which has neither avail nor used rings to dump.
+ */
+static void virtioCoreR3VirtqPackedInfo(PPDMDEVINS pDevIns, PCDBGFINFOHLP pHlp, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq)
+{
+    VIRTQ_PACKED_EVENT_T DrvEvent;
+    VIRTQ_PACKED_EVENT_T DevEvent;
+    virtioReadPackedDriverEvent(pDevIns, pVirtio, pVirtq, &DrvEvent);
+    virtioCoreGCPhysRead(pVirtio, pDevIns, pVirtq->GCPhysVirtqUsed, &DevEvent, sizeof(DevEvent));
+
+    pHlp->pfnPrintf(pHlp, "       queue enabled: ........... %s\n", pVirtq->uEnable ? "true" : "false");
+    pHlp->pfnPrintf(pHlp, "       size: .................... %d (packed)\n", pVirtq->uQueueSize);
+    pHlp->pfnPrintf(pHlp, "       notify offset: ........... %d\n", pVirtq->uNotifyOffset);
+    if (pVirtio->fMsiSupport)
+        pHlp->pfnPrintf(pHlp, "       MSIX vector: ....... %4.4x\n", pVirtq->uMsixVector);
+    pHlp->pfnPrintf(pHlp, "\n");
+    pHlp->pfnPrintf(pHlp, "       avail (%d chains):\n", virtioCoreVirtqAvailCnt(pDevIns, pVirtio, pVirtq));
+    pHlp->pfnPrintf(pHlp, "          shadow: ............... %d wrap=%d\n", pVirtq->uAvailIdxShadow & VIRTQ_PACKED_IDX_MASK,
+                    RT_BOOL(pVirtq->uAvailIdxShadow & VIRTQ_PACKED_WRAP));
+    pHlp->pfnPrintf(pHlp, "          driver event: ......... flags=%d off=%d wrap=%d\n", DrvEvent.fFlags,
+                    DrvEvent.uOffWrap & VIRTQ_PACKED_IDX_MASK, RT_BOOL(DrvEvent.uOffWrap & VIRTQ_PACKED_WRAP));
+    pHlp->pfnPrintf(pHlp, "\n");
+    pHlp->pfnPrintf(pHlp, "       used:\n");
+    pHlp->pfnPrintf(pHlp, "          published: ............ %d wrap=%d\n", pVirtq->uUsedIdxSynced & VIRTQ_PACKED_IDX_MASK,
+                    RT_BOOL(pVirtq->uUsedIdxSynced & VIRTQ_PACKED_WRAP));
+    pHlp->pfnPrintf(pHlp, "          shadow: ............... %d wrap=%d\n", pVirtq->uUsedIdxShadow & VIRTQ_PACKED_IDX_MASK,
+                    RT_BOOL(pVirtq->uUsedIdxShadow & VIRTQ_PACKED_WRAP));
+    pHlp->pfnPrintf(pHlp, "          in-order pending: ..... %d\n", pVirtq->cUsedInOrderPending);
+    pHlp->pfnPrintf(pHlp, "          device event: ......... flags=%d\n", DevEvent.fFlags);
+    pHlp->pfnPrintf(pHlp, "\n");
+}
+
 /** API Fuunction: See header file */
 DECLHIDDEN(void) virtioCoreR3VirtqInfo(PPDMDEVINS pDevIns, PCDBGFINFOHLP pHlp, PVIRTIOCORE pVirtio, const char *pszArgs, int uVirtq)
 {
     RT_NOREF(pszArgs);
     PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
 
+    if (IS_VIRTQ_PACKED(pVirtio))
+    {
+        virtioCoreR3VirtqPackedInfo(pDevIns, pHlp, pVirtio, pVirtq);
+        return;
+    }
+
     /** @todo add ability to dump physical contents described by any descriptor (using existing VirtIO core API function) */
 //  bool fDump      = pszArgs && (*pszArgs == 'd' || *pszArgs == 'D'); /* "dump" (avail phys descriptor)"
 
@@ -928,7 +1257,10 @@ DECLHIDDEN(void) virtioCoreVirtqEnableNotify(PVIRTIOCORE pVirtio, uint16_t uVirt
     Assert(uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues));
     PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
 
-    if (IS_DRIVER_OK(pVirtio))
+    if (IS_DRIVER_OK(pVirtio) && IS_VIRTQ_PACKED(pVirtio))
+        virtioWritePackedDeviceEventFlags(pVirtio->pDevInsR3, pVirtio, pVirtq,
+                                          fEnable ? VIRTQ_PACKED_EVENT_F_ENABLE : VIRTQ_PACKED_EVENT_F_DISABLE);
+    else if (IS_DRIVER_OK(pVirtio))
     {
         uint16_t fFlags = virtioReadUsedRingFlags(pVirtio->pDevInsR3, pVirtio, pVirtq);
 
@@ -971,11 +1303,23 @@ DECLHIDDEN(int) virtioCoreR3VirtqAvailBufNext(PVIRTIOCORE pVirtio, uint16_t uVir
         AssertMsgReturn((pVirtio->fDeviceStatus & VIRTIO_STATUS_DRIVER_OK) && pVirtq->uEnable,
             ("Guest driver not in ready state.\n"), VERR_INVALID_STATE);
 
-    if (IS_VIRTQ_EMPTY(pVirtio->pDevInsR3, pVirtio, pVirtq))
-        return VERR_NOT_AVAILABLE;
+    if (IS_VIRTQ_PACKED(pVirtio))
+    {
+        uint16_t const cDescs = virtioPackedChainLen(pVirtio->pDevInsR3, pVirtio, pVirtq, pVirtq->uAvailIdxShadow);
+        if (!cDescs)
+            return VERR_NOT_AVAILABLE;
 
-    Log6Func(("%s avail shadow idx: %u\n", pVirtq->szName, pVirtq->uAvailIdxShadow));
-    pVirtq->uAvailIdxShadow++;
+        Log6Func(("%s avail shadow pos: %#x (%u descs)\n", pVirtq->szName, pVirtq->uAvailIdxShadow, cDescs));
+        pVirtq->uAvailIdxShadow = virtioPackedPosAdvance(pVirtq, pVirtq->uAvailIdxShadow, cDescs);
+    }
+    else
+    {
+        if (IS_VIRTQ_EMPTY(pVirtio->pDevInsR3, pVirtio, pVirtq))
+            return VERR_NOT_AVAILABLE;
+
+        Log6Func(("%s avail shadow idx: %u\n", pVirtq->szName, pVirtq->uAvailIdxShadow));
+        pVirtq->uAvailIdxShadow++;
+    }
 #ifdef VIRTIO_REL_INFO_DUMP
     virtioCoreTraceEvent(pVirtio, pVirtq, VIRTIO_CORE_EVENT_AVAIL_NEXT, pVirtq->uAvailIdxShadow, 0);
 #endif /* VIRTIO_REL_INFO_DUMP */
@@ -1026,6 +1370,11 @@ static void dbgVirtioDump(PPDMDEVINS pDevIns)
 void virtioCorePutAllAvailBufsToUsedRing(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtq)
 {
     PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
+    if (IS_VIRTQ_PACKED(pVirtio))
+    {
+        LogRel(("[%s] %s is a packed virtq, nothing to copy.\n", pVirtio->szInstance, pVirtq->szName));
+        return;
+    }
     uint16_t uStartAvailIdx = pVirtq->uAvailIdxShadow;
     uint16_t uStartUsedIdx  = pVirtq->uUsedIdxShadow;
 
@@ -1062,6 +1411,7 @@ DECLHIDDEN(int) virtioCoreR3VirtqAvailBufGet(PPDMDEVINS pDevIns, PVIRTIOCORE pVi
             ("Guest driver not in ready state.\n"), VERR_INVALID_STATE);
 
     uint16_t uDescIdx = uHeadIdx;
+    bool const fPacked = IS_VIRTQ_PACKED(pVirtio);
 
     Log6Func(("%s DESC CHAIN: (head idx = %u)\n", pVirtio->aVirtqueues[uVirtq].szName, uHeadIdx));
 
@@ -1071,12 +1421,17 @@ DECLHIDDEN(int) virtioCoreR3VirtqAvailBufGet(PPDMDEVINS pDevIns, PVIRTIOCORE pVi
     pVirtqBuf->u32Magic  = VIRTQBUF_MAGIC;
     pVirtqBuf->cRefs     = 1;
     pVirtqBuf->uHeadIdx  = uHeadIdx;
+    pVirtqBuf->uBufId    = uHeadIdx;
+    pVirtqBuf->cDescs    = 0;
     pVirtqBuf->uVirtq    = uVirtq;
 
     /*
      * Gather segments.
      */
-    VIRTQ_DESC_T desc;
+    VIRTQ_DESC_T    desc;
+    VIRTQDESCWINDOW DescWnd;
+    DescWnd.idxFirst = 0;
+    DescWnd.cDescs   = 0;
 
     uint32_t cbIn     = 0;
     uint32_t cbOut    = 0;
@@ -1104,7 +1459,7 @@ DECLHIDDEN(int) virtioCoreR3VirtqAvailBufGet(PPDMDEVINS pDevIns, PVIRTIOCORE pVi
                 LogRel(("Too many linked descriptors; check if the guest arranges descriptors in a loop "
                         "(cSegsIn=%u cSegsOut=%u uQueueSize=%u uDescIdx=%u uHeadIdx=%u uAvailIdxShadow=%u queue=%s).\n",
                         cSegsIn, cSegsOut, pVirtq->uQueueSize, uDescIdx, pVirtqBuf->uHeadIdx, pVirtq->uAvailIdxShadow, pVirtq->szName));
-                virtioCoreDumpTraceBufToRelLog(pVirtio->hTraceBuf);
+                virtioCoreDumpTraceBufToRelLog(pVirtio);
                 dbgVirtioDump(pDevIns);
             }
             /* Disable the queue to prevent its operation until it is re-initialized. */
@@ -1142,7 +1497,21 @@ DECLHIDDEN(int) virtioCoreR3VirtqAvailBufGet(PPDMDEVINS pDevIns, PVIRTIOCORE pVi
         }
         RT_UNTRUSTED_VALIDATED_FENCE();
 
-        virtioReadDesc(pDevIns, pVirtio, pVirtq, uDescIdx, &desc);
+        if (fPacked)
+        {
+            /* Packed chains occupy consecutive slots, the buffer ID is taken from the last one (VirtIO 1.1, 2.7.6). */
+            VIRTQ_PACKED_DESC_T PackedDesc;
+            virtioR3ReadDescPrefetch(pDevIns, pVirtio, pVirtq, &DescWnd, uDescIdx & VIRTQ_PACKED_IDX_MASK,
+                                     (PVIRTQ_DESC_T)&PackedDesc);
+            desc.GCPhysBuf    = PackedDesc.GCPhysBuf;
+            desc.cb           = PackedDesc.cb;
+            desc.fFlags       = PackedDesc.fFlags;
+            desc.uDescIdxNext = (uint16_t)((uDescIdx + 1) % RT_MAX(pVirtq->uQueueSize, 1));
+            pVirtqBuf->uBufId = PackedDesc.uBufId;
+        }
+        else
+            virtioR3ReadDescPrefetch(pDevIns, pVirtio, pVirtq, &DescWnd, uDescIdx, &desc);
+        pVirtqBuf->cDescs++;
 
         if (desc.fFlags & VIRTQ_DESC_F_WRITE)
         {
@@ -1207,6 +1576,22 @@ DECLHIDDEN(int) virtioCoreR3VirtqAvailBufGet(PPDMDEVINS pDevIns, PVIRTIOCORE pVi
     Assert(uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues));
     PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
 
+    if (IS_VIRTQ_PACKED(pVirtio))
+    {
+        uint16_t const uPos = pVirtq->uAvailIdxShadow;
+        if (!virtioPackedDescIsAvail(virtioReadPackedDescFlags(pDevIns, pVirtio, pVirtq, uPos), uPos))
+            return VERR_NOT_AVAILABLE;
+        ASMReadFence(); /* Don't read the chain before seeing its head available. */
+
+#ifdef VIRTIO_REL_INFO_DUMP
+        virtioCoreTraceEvent(pVirtio, pVirtq, fRemove ? VIRTIO_CORE_EVENT_AVAIL_GET : VIRTIO_CORE_EVENT_AVAIL_PEEK, uPos, uPos & VIRTQ_PACKED_IDX_MASK);
+#endif /* VIRTIO_REL_INFO_DUMP */
+        int rc = virtioCoreR3VirtqAvailBufGet(pDevIns, pVirtio, uVirtq, uPos & VIRTQ_PACKED_IDX_MASK, pVirtqBuf);
+        if (RT_SUCCESS(rc) && fRemove)
+            pVirtq->uAvailIdxShadow = virtioPackedPosAdvance(pVirtq, uPos, pVirtqBuf->cDescs);
+        return rc;
+    }
+
     if (IS_VIRTQ_EMPTY(pDevIns, pVirtio, pVirtq))
         return VERR_NOT_AVAILABLE;
 
@@ -1224,6 +1609,123 @@ DECLHIDDEN(int) virtioCoreR3VirtqAvailBufGet(PPDMDEVINS pDevIns, PVIRTIOCORE pVi
     return virtioCoreR3VirtqAvailBufGet(pDevIns, pVirtio, uVirtq, uHeadIdx, pVirtqBuf);
 }
 
+/**
+ * Writes a used element at the used shadow position and advances it by @a cSlots, i.e. by
+ * one buffer for split virtqs and by the number of descriptors covered for packed ones.
+ *
+ * The flags of the first packed descriptor after the last publish are held back until
+ * virtioCoreR3VirtqUsedBufPublish() or virtioCoreVirtqUsedRingSync(), so the guest sees
+ * the whole batch at once and callers may still patch the buffers in between (e.g. the
+ * virtio-net num_buffers field).
+ */
+static void virtioR3VirtqUsedElemWrite(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq,
+                                       uint16_t uBufId, uint32_t cbUsed, uint16_t cSlots)
+{
+    uint16_t const uPos = pVirtq->uUsedIdxShadow;
+    if (!IS_VIRTQ_PACKED(pVirtio))
+    {
+        virtioWriteUsedElem(pDevIns, pVirtio, pVirtq, uPos, uBufId, cbUsed);
+        pVirtq->uUsedIdxShadow = uPos + cSlots;
+        return;
+    }
+
+    uint16_t fFlags = uPos & VIRTQ_PACKED_WRAP ? VIRTQ_DESC_F_AVAIL | VIRTQ_DESC_F_USED : 0;
+    if (cbUsed)
+        fFlags |= VIRTQ_DESC_F_WRITE;
+    virtioWritePackedUsedDesc(pDevIns, pVirtio, pVirtq, uPos, uBufId, cbUsed);
+    if (uPos == pVirtq->uUsedIdxSynced)
+        pVirtq->fUsedFlagsPending = fFlags;
+    else
+        virtioWritePackedDescFlags(pDevIns, pVirtio, pVirtq, uPos, fFlags);
+    pVirtq->uUsedIdxShadow = virtioPackedPosAdvance(pVirtq, uPos, cSlots);
+}
+
+/**
+ * Writes the single used element standing in for a run of in-order buffers returned
+ * without data, see virtioR3VirtqUsedBufEnqueue().
+ */
+static void virtioR3VirtqUsedInOrderFlush(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq)
+{
+    uint16_t const cSlots = pVirtq->cUsedInOrderPending;
+    if (cSlots)
+    {
+        pVirtq->cUsedInOrderPending = 0;
+        virtioR3VirtqUsedElemWrite(pDevIns, pVirtio, pVirtq, pVirtq->uUsedInOrderBufId, 0 /*cbUsed*/, cSlots);
+    }
+}
+
+/**
+ * Places a used buffer in the used ring without publishing it to the guest.
+ *
+ * With VIRTIO_F_IN_ORDER negotiated a run of buffers returned without data (e.g. transmitted
+ * frames) is described by one used element carrying the ID of the last buffer, the guest
+ * infers the rest from the ring position (VirtIO 1.1, 2.6.9 and 2.7.9).  Buffers with data
+ * are always written individually since the guest needs their lengths.
+ */
+static void virtioR3VirtqUsedBufEnqueue(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq,
+                                        PVIRTQBUF pVirtqBuf, uint32_t cbUsed)
+{
+    uint16_t const cSlots = IS_VIRTQ_PACKED(pVirtio) ? pVirtqBuf->cDescs : 1;
+    if (pVirtio->uDriverFeatures & VIRTIO_F_IN_ORDER)
+    {
+        if (!cbUsed)
+        {
+            pVirtq->uUsedInOrderBufId    = (uint16_t)pVirtqBuf->uBufId;
+            pVirtq->cUsedInOrderPending += cSlots;
+            return;
+        }
+        virtioR3VirtqUsedInOrderFlush(pDevIns, pVirtio, pVirtq);
+    }
+    virtioR3VirtqUsedElemWrite(pDevIns, pVirtio, pVirtq, (uint16_t)pVirtqBuf->uBufId, cbUsed, cSlots);
+}
+
+/**
+ * Hands the packed used descriptors written since the last publish over to the guest
+ * by writing the flags held back for the first of them.
+ */
+static void virtioR3VirtqPackedUsedPublish(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq)
+{
+    if (pVirtq->uUsedIdxSynced != pVirtq->uUsedIdxShadow)
+    {
+        virtioWritePackedDescFlags(pDevIns, pVirtio, pVirtq, pVirtq->uUsedIdxSynced, pVirtq->fUsedFlagsPending);
+        pVirtq->uUsedIdxSynced = pVirtq->uUsedIdxShadow;
+    }
+}
+
+/**
+ * Publishes the pending packed used descriptors and decides from the driver event
+ * suppression structure whether the guest wants to be interrupted for the descriptors
+ * published since the last check.
+ */
+static void virtioR3VirtqPackedUsedSync(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTQUEUE pVirtq)
+{
+    virtioR3VirtqPackedUsedPublish(pDevIns, pVirtio, pVirtq);
+
+    uint16_t const uOld = pVirtq->uUsedIdxNotified;
+    uint16_t const uNew = pVirtq->uUsedIdxShadow;
+    if (uOld == uNew)
+        return;
+    pVirtq->uUsedIdxNotified = uNew;
+
+    ASMMemoryFence(); /* The flags must be visible before reading the driver's event settings. */
+    VIRTQ_PACKED_EVENT_T Event;
+    virtioReadPackedDriverEvent(pDevIns, pVirtio, pVirtq, &Event);
+    if (Event.fFlags == VIRTQ_PACKED_EVENT_F_ENABLE)
+        pVirtq->fUsedRingEvent = true;
+    else if (Event.fFlags == VIRTQ_PACKED_EVENT_F_DESC)
+    {
+        /* Same test as for used_event, with the positions made relative to the lap of uNew (VirtIO 1.1, 2.7.10). */
+        int32_t const cVirtqItems = pVirtq->uQueueSize;
+        int32_t const iNew        = uNew & VIRTQ_PACKED_IDX_MASK;
+        int32_t const iOld        = (uOld & VIRTQ_PACKED_IDX_MASK)
+                                  - ((uOld ^ uNew) & VIRTQ_PACKED_WRAP ? cVirtqItems : 0);
+        int32_t const iEvent      = (Event.uOffWrap & VIRTQ_PACKED_IDX_MASK)
+                                  - ((Event.uOffWrap ^ uNew) & VIRTQ_PACKED_WRAP ? cVirtqItems : 0);
+        if (iEvent >= iOld && iEvent < iNew)
+            pVirtq->fUsedRingEvent = true;
+    }
+}
+
 /** API function: See Header file  */
 DECLHIDDEN(int) virtioCoreR3VirtqUsedBufPut(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtq, PRTSGBUF pSgVirtReturn,
                                             PVIRTQBUF pVirtqBuf, bool fFence)
@@ -1281,7 +1783,7 @@ DECLHIDDEN(int) virtioCoreR3VirtqUsedBufPut(PPDMDEVINS pDevIns, PVIRTIOCORE pVir
     }
 
     /* Flag if write-ahead crosses threshold where guest driver indicated it wants event notification */
-    if (pVirtio->uDriverFeatures & VIRTIO_F_EVENT_IDX)
+    if ((pVirtio->uDriverFeatures & (VIRTIO_F_EVENT_IDX | VIRTIO_F_RING_PACKED)) == VIRTIO_F_EVENT_IDX)
         if (pVirtq->uUsedIdxShadow == virtioReadAvailUsedEvent(pDevIns, pVirtio, pVirtq))
             pVirtq->fUsedRingEvent = true;
 
@@ -1295,7 +1797,7 @@ DECLHIDDEN(int) virtioCoreR3VirtqUsedBufPut(PPDMDEVINS pDevIns, PVIRTIOCORE pVir
 #ifdef VIRTIO_REL_INFO_DUMP
     virtioCoreTraceEvent(pVirtio, pVirtq, VIRTIO_CORE_EVENT_USED_PUT, pVirtq->uUsedIdxShadow, pVirtqBuf->uHeadIdx);
 #endif /* VIRTIO_REL_INFO_DUMP */
-    virtioWriteUsedElem(pDevIns, pVirtio, pVirtq, pVirtq->uUsedIdxShadow++, pVirtqBuf->uHeadIdx, (uint32_t)cbTotal);
+    virtioR3VirtqUsedBufEnqueue(pDevIns, pVirtio, pVirtq, pVirtqBuf, (uint32_t)cbTotal);
 
 #ifdef LOG_ENABLED
     if (   LogIs6Enabled()
@@ -1309,12 +1811,15 @@ DECLHIDDEN(int) virtioCoreR3VirtqUsedBufPut(PPDMDEVINS pDevIns, PVIRTIOCORE pVir
                 virtioCoreGCPhysChainCalcLengthLeft(pVirtqBuf->pSgPhysReturn)) - (cbTotal - cbRemain)),
                 virtioCoreGCPhysChainCalcLengthLeft(pVirtqBuf->pSgPhysReturn) ));
 
-        uint16_t uPending = virtioCoreR3CountPendingBufs(
-                                virtioReadUsedRingIdx(pDevIns, pVirtio, pVirtq),
-                                pVirtq->uUsedIdxShadow, pVirtq->uQueueSize);
+        if (!IS_VIRTQ_PACKED(pVirtio))
+        {
+            uint16_t uPending = virtioCoreR3CountPendingBufs(
+                                    virtioReadUsedRingIdx(pDevIns, pVirtio, pVirtq),
+                                    pVirtq->uUsedIdxShadow, pVirtq->uQueueSize);
 
-        LogFunc(("    %u used buf%s not synced in %s\n", uPending, uPending == 1 ? "" : "s ",
-                    VIRTQNAME(pVirtio, uVirtq)));
+            LogFunc(("    %u used buf%s not synced in %s\n", uPending, uPending == 1 ? "" : "s ",
+                        VIRTQNAME(pVirtio, uVirtq)));
+        }
     }
 #endif
     return VINF_SUCCESS;
@@ -1365,7 +1870,7 @@ DECLHIDDEN(int) virtioCoreR3VirtqUsedBufPut(PPDMDEVINS pDevIns, PVIRTIOCORE pVir
             Assert(!(cbCopy >> 32));
         }
         /* Flag if write-ahead crosses threshold where guest driver indicated it wants event notification */
-        if (pVirtio->uDriverFeatures & VIRTIO_F_EVENT_IDX)
+        if ((pVirtio->uDriverFeatures & (VIRTIO_F_EVENT_IDX | VIRTIO_F_RING_PACKED)) == VIRTIO_F_EVENT_IDX)
             if (pVirtq->uUsedIdxShadow == virtioReadAvailUsedEvent(pDevIns, pVirtio, pVirtq))
                 pVirtq->fUsedRingEvent = true;
         /*
@@ -1378,10 +1883,10 @@ DECLHIDDEN(int) virtioCoreR3VirtqUsedBufPut(PPDMDEVINS pDevIns, PVIRTIOCORE pVir
 #ifdef VIRTIO_REL_INFO_DUMP
         virtioCoreTraceEvent(pVirtio, pVirtq, VIRTIO_CORE_EVENT_USED_PUT, pVirtq->uUsedIdxShadow, pVirtqBuf->uHeadIdx);
 #endif /* VIRTIO_REL_INFO_DUMP */
-        virtioWriteUsedElem(pDevIns, pVirtio, pVirtq, pVirtq->uUsedIdxShadow++, pVirtqBuf->uHeadIdx, (uint32_t)cbEnqueue);
+        virtioR3VirtqUsedBufEnqueue(pDevIns, pVirtio, pVirtq, pVirtqBuf, (uint32_t)cbEnqueue);
 
 #ifdef LOG_ENABLED
-        if (LogIs6Enabled())
+        if (LogIs6Enabled() && !IS_VIRTQ_PACKED(pVirtio))
         {
             uint16_t uPending = virtioCoreR3CountPendingBufs(
                                     virtioReadUsedRingIdx(pDevIns, pVirtio, pVirtq),
@@ -1397,6 +1902,21 @@ DECLHIDDEN(int) virtioCoreR3VirtqUsedBufPut(PPDMDEVINS pDevIns, PVIRTIOCORE pVir
 }
 
 
+/** API function: See Header file  */
+DECLHIDDEN(void) virtioCoreR3VirtqUsedBufPublish(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtq)
+{
+    AssertReturnVoid(uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues));
+    PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
+
+    /* Split virtqs publish everything with the used idx update in virtioCoreVirtqUsedRingSync(). */
+    if (IS_VIRTQ_PACKED(pVirtio))
+    {
+        if (pVirtio->uDriverFeatures & VIRTIO_F_IN_ORDER)
+            virtioR3VirtqUsedInOrderFlush(pDevIns, pVirtio, pVirtq);
+        virtioR3VirtqPackedUsedPublish(pDevIns, pVirtio, pVirtq);
+    }
+}
+
 #endif /* IN_RING3 */
 
 /** API function: See Header file  */
@@ -1414,16 +1934,79 @@ DECLHIDDEN(int) virtioCoreVirtqUsedRingSync(PPDMDEVINS pDevIns, PVIRTIOCORE pVir
 
 #ifdef IN_RING3
     // I believe virtioCoreVirtqUsedRingSync is only called from ring 3 in virtio-net
+    if (pVirtio->uDriverFeatures & VIRTIO_F_IN_ORDER)
+        virtioR3VirtqUsedInOrderFlush(pDevIns, pVirtio, pVirtq);
 #ifdef VIRTIO_REL_INFO_DUMP
     virtioCoreTraceEvent(pVirtio, pVirtq, VIRTIO_CORE_EVENT_USED_SYNC, pVirtq->uUsedIdxShadow, 0);
 #endif /* VIRTIO_REL_INFO_DUMP */
+    if (IS_VIRTQ_PACKED(pVirtio))
+    {
+        virtioR3VirtqPackedUsedSync(pDevIns, pVirtio, pVirtq);
+        virtioCoreNotifyGuestDriver(pDevIns, pVirtio, uVirtq);
+        return VINF_SUCCESS;
+    }
+    uint16_t const uUsedIdxOld = virtioReadUsedRingIdx(pDevIns, pVirtio, pVirtq);
+#else
+    AssertReturn(!IS_VIRTQ_PACKED(pVirtio), VERR_NOT_SUPPORTED);
 #endif /* IN_RING3 */
     virtioWriteUsedRingIdx(pDevIns, pVirtio, pVirtq, pVirtq->uUsedIdxShadow);
+#ifdef IN_RING3
+    /*
+     * Callers may publish a whole burst of used buffers with one sync, during which the guest
+     * may have moved used_event.  So re-evaluate the notification threshold against the range
+     * published here, the same way the guest does for avail_event (VirtIO 1.1, 2.6.7.2).
+     * The fence orders the used idx update before reading used_event.
+     */
+    if (pVirtio->uDriverFeatures & VIRTIO_F_EVENT_IDX)
+    {
+        ASMMemoryFence();
+        uint16_t const uUsedEvent = virtioReadAvailUsedEvent(pDevIns, pVirtio, pVirtq);
+        if (   (uint16_t)(pVirtq->uUsedIdxShadow - uUsedEvent - 1)
+            <  (uint16_t)(pVirtq->uUsedIdxShadow - uUsedIdxOld))
+            pVirtq->fUsedRingEvent = true;
+    }
+#endif /* IN_RING3 */
     virtioCoreNotifyGuestDriver(pDevIns, pVirtio, uVirtq);
 
     return VINF_SUCCESS;
 }
 
+#ifdef IN_RING3
+
+/** API function: See Header file  */
+DECLHIDDEN(void) virtioCoreR3VirtqRaiseInterrupt(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtq)
+{
+    AssertReturnVoid(uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues));
+    PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
+
+    if (!IS_DRIVER_OK(pVirtio))
+    {
+        LogFunc(("Guest driver not in ready state.\n"));
+        return;
+    }
+    virtioNudgeGuest(pDevIns, pVirtio, VIRTIO_ISR_VIRTQ_INTERRUPT, pVirtq->uMsixVector);
+}
+
+/** API function: See Header file  */
+DECLHIDDEN(void) virtioCoreR3VirtqSyncShadowIdx(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtq, uint16_t uAvailIdx)
+{
+    AssertReturnVoid(uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues));
+    PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
+
+    pVirtq->uAvailIdxShadow = uAvailIdx;
+    /* A packed virtq has no used index in guest memory, everything consumed has been used by now. */
+    if (IS_VIRTQ_PACKED(pVirtio))
+        pVirtq->uUsedIdxShadow = uAvailIdx;
+    else
+        pVirtq->uUsedIdxShadow = virtioReadUsedRingIdx(pDevIns, pVirtio, pVirtq);
+    pVirtq->uUsedIdxSynced      = pVirtq->uUsedIdxShadow;
+    pVirtq->uUsedIdxNotified    = pVirtq->uUsedIdxShadow;
+    pVirtq->cUsedInOrderPending = 0;
+    Log6Func(("%s: avail shadow %u, used shadow %u\n", pVirtq->szName, pVirtq->uAvailIdxShadow, pVirtq->uUsedIdxShadow));
+}
+
+#endif /* IN_RING3 */
+
 /**
  * This is called from the MMIO callback code when the guest does an MMIO access to the
  * mapped queue notification capability area corresponding to a particular queue, to notify
@@ -1454,7 +2037,9 @@ static void virtioCoreVirtqNotified(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uin
     Log6Func(("%s: (desc chains: %u)\n", *pVirtq->szName ? pVirtq->szName : "?UNAMED QUEUE?",
         virtioCoreVirtqAvailCnt(pDevIns, pVirtio, pVirtq)));
 
-    /* Inform client */
+    STAM_COUNTER_INC(&pVirtio->CTX_SUFF_Z(StatNotify));
+
+    /* Inform client (all contexts, the client is expected to do no more than waking up its worker) */
     pVirtioCC->pfnVirtqNotified(pDevIns, pVirtio, uVirtq);
     RT_NOREF2(pVirtio, pVirtq);
 }
@@ -1481,7 +2066,18 @@ static void virtioCoreNotifyGuestDriver(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio,
         return;
     }
 
-    if (pVirtio->uDriverFeatures & VIRTIO_F_EVENT_IDX)
+    if (IS_VIRTQ_PACKED(pVirtio))
+    {
+        /* The driver event suppression structure was evaluated by virtioCoreVirtqUsedRingSync(). */
+        if (pVirtq->fUsedRingEvent)
+        {
+            virtioNudgeGuest(pDevIns, pVirtio, VIRTIO_ISR_VIRTQ_INTERRUPT, pVirtq->uMsixVector);
+            pVirtq->fUsedRingEvent = false;
+            return;
+        }
+        Log6Func(("...skip interrupt %s, suppressed by packed virtq driver event\n", pVirtq->szName));
+    }
+    else if (pVirtio->uDriverFeatures & VIRTIO_F_EVENT_IDX)
     {
         if (pVirtq->fUsedRingEvent)
         {
@@ -1568,12 +2164,24 @@ static void virtioResetVirtq(PVIRTIOCORE pVirtio, uint16_t uVirtq)
     Assert(uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues));
     PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
 
+    /* Drop the ring mappings, unless a worker is busy with them (it'll get stale
+       entries only if the guest actually frees or remaps the memory). */
+    if (   pVirtq->pPhysMapCacheR3
+        && ASMAtomicCmpXchgBool(&pVirtq->fPhysMapCacheBusy, true, false))
+    {
+        PDMDevHlpPhysMapCacheFlush(pVirtio->pDevInsR3, pVirtq->pPhysMapCacheR3);
+        ASMAtomicWriteBool(&pVirtq->fPhysMapCacheBusy, false);
+    }
+
     pVirtq->uQueueSize       = VIRTQ_SIZE;
     pVirtq->uEnable          = false;
     pVirtq->uNotifyOffset    = uVirtq;
     pVirtq->fUsedRingEvent   = false;
     pVirtq->uAvailIdxShadow  = 0;
     pVirtq->uUsedIdxShadow   = 0;
+    pVirtq->uUsedIdxSynced   = 0;
+    pVirtq->uUsedIdxNotified = 0;
+    pVirtq->cUsedInOrderPending = 0;
     pVirtq->uMsixVector      = uVirtq + 2;
 
     if (!pVirtio->fMsiSupport) /* VirtIO 1.0, 4.1.4.3 and 4.1.5.1.2 */
@@ -1651,6 +2259,17 @@ DECLINLINE(void) virtioR3DoFeaturesCompleteOnceOnly(PVIRTIOCORE pVirtio, PVIRTIO
             else
                 AssertMsgFailed(("Guest didn't accept VIRTIO_F_VERSION_1, but fLegacyOffered flag not set.\n"));
         }
+        /* Packed virtqs start out with both wrap counters set (VirtIO 1.1, 2.7.1). */
+        for (unsigned uVirtq = 0; uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues); uVirtq++)
+        {
+            PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
+            uint16_t const uPos = IS_VIRTQ_PACKED(pVirtio) ? VIRTQ_PACKED_WRAP : 0;
+            pVirtq->uAvailIdxShadow     = uPos;
+            pVirtq->uUsedIdxShadow      = uPos;
+            pVirtq->uUsedIdxSynced      = uPos;
+            pVirtq->uUsedIdxNotified    = uPos;
+            pVirtq->cUsedInOrderPending = 0;
+        }
         if (pVirtioCC->pfnFeatureNegotiationComplete)
             pVirtioCC->pfnFeatureNegotiationComplete(pVirtio, pVirtio->uDriverFeatures, pVirtio->fLegacyDriver);
         pVirtio->fDriverFeaturesWritten |= DRIVER_FEATURES_COMPLETE_HANDLED;
@@ -2098,6 +2717,7 @@ static DECLCALLBACK(VBOXSTRICTRC) virtioLegacyIOPortOut(PPDMDEVINS pDevIns, void
         {
 #ifdef IN_RING0
             Log6(("%-23s: RING0 => RING3 (demote)\n", __FUNCTION__));
+            STAM_COUNTER_INC(&pVirtio->StatWriteToR3);
             return VINF_IOM_R3_IOPORT_WRITE;
 #endif
 #ifdef IN_RING3
@@ -2132,6 +2752,7 @@ static DECLCALLBACK(VBOXSTRICTRC) virtioLegacyIOPortOut(PPDMDEVINS pDevIns, void
 #ifdef IN_RING0
             Log6(("%-23s: RING0 => RING3 (demote)\n", __FUNCTION__));
             STAM_PROFILE_ADV_STOP(&pVirtio->CTX_SUFF(StatWrite), a);
+            STAM_COUNTER_INC(&pVirtio->StatWriteToR3);
             return VINF_IOM_R3_IOPORT_WRITE;
 #endif
         }
@@ -2179,25 +2800,22 @@ static DECLCALLBACK(VBOXSTRICTRC) virtioLegacyIOPortOut(PPDMDEVINS pDevIns, void
     else
     if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(uQueueNotify, VIRTIO_LEGACY_PCI_COMMON_CFG_T, offPort))
     {
-#ifdef IN_RING3
+        /* Handled in all contexts like the modern notify capability, the client callback only kicks a worker. */
         ASSERT_GUEST_MSG(cb == 2, ("cb=%u\n", cb));
-        pVirtio->uQueueNotify =  u32 & 0xFFFF;
-        if (uVirtq < VIRTQ_MAX_COUNT)
+        uint16_t const uQueueNotify = u32 & 0xFFFF;
+        pVirtio->uQueueNotify = uQueueNotify;
+        if (uQueueNotify < VIRTQ_MAX_COUNT)
         {
             RT_UNTRUSTED_VALIDATED_FENCE();
 
             /* Need to check that queue is configured. Legacy spec didn't have a queue enabled flag */
-            if (pVirtio->aVirtqueues[pVirtio->uQueueNotify].GCPhysVirtqDesc)
-                    virtioCoreVirtqNotified(pDevIns, pVirtio, pVirtio->uQueueNotify, pVirtio->uQueueNotify /* uNotifyIdx */);
+            if (pVirtio->aVirtqueues[uQueueNotify].GCPhysVirtqDesc)
+                    virtioCoreVirtqNotified(pDevIns, pVirtio, uQueueNotify, uQueueNotify /* uNotifyIdx */);
             else
-                Log(("The queue (#%d) being notified has not been initialized.\n", pVirtio->uQueueNotify));
+                Log(("The queue (#%d) being notified has not been initialized.\n", uQueueNotify));
         }
         else
-            Log(("Invalid queue number (%d)\n", pVirtio->uQueueNotify));
-#else
-        STAM_PROFILE_ADV_STOP(&pVirtio->CTX_SUFF(StatWrite), a);
-        return VINF_IOM_R3_IOPORT_WRITE;
-#endif
+            Log(("Invalid queue number (%d)\n", uQueueNotify));
     }
     else
     if (VIRTIO_DEV_CONFIG_MATCH_MEMBER(fIsrStatus, VIRTIO_LEGACY_PCI_COMMON_CFG_T, offPort))
@@ -2216,6 +2834,7 @@ static DECLCALLBACK(VBOXSTRICTRC) virtioLegacyIOPortOut(PPDMDEVINS pDevIns, void
         return pVirtioCC->pfnDevCapWrite(pDevIns, offPort - sizeof(VIRTIO_LEGACY_PCI_COMMON_CFG_T), pv, cb);
 #else
         STAM_PROFILE_ADV_STOP(&pVirtio->CTX_SUFF(StatWrite), a);
+        STAM_COUNTER_INC(&pVirtio->StatWriteToR3);
         return VINF_IOM_R3_IOPORT_WRITE;
 #endif
     }
@@ -2377,6 +2996,10 @@ static DECLCALLBACK(VBOXSTRICTRC) virtioMmioWrite(PPDMDEVINS pDevIns, void *pvUs
                                      "virtioMmioRead: Bad MMIO access to capabilities, offset=%RTiop cb=%08x\n", off, cb);
     }
 
+#ifndef IN_RING3
+    if (rcStrict == VINF_IOM_R3_MMIO_WRITE)
+        STAM_COUNTER_INC(&pVirtio->StatWriteToR3);
+#endif
     STAM_PROFILE_ADV_STOP(&pVirtio->CTX_SUFF(StatWrite), a);
     return rcStrict;
 }
@@ -2490,6 +3113,7 @@ static DECLCALLBACK(VBOXSTRICTRC) virtioMmioTransportWrite(PPDMDEVINS pDevIns, v
 #else
         STAM_PROFILE_ADV_STOP(&pVirtio->CTX_SUFF(StatWrite), a);
         Log6(("%-23s: RING0 => RING3 (demote)\n", __FUNCTION__));
+        STAM_COUNTER_INC(&pVirtio->StatWriteToR3);
         return VINF_IOM_R3_MMIO_WRITE;
 #endif
     }
@@ -2519,7 +3143,10 @@ static DECLCALLBACK(VBOXSTRICTRC) virtioMmioTransportWrite(PPDMDEVINS pDevIns, v
                     if (     (pVirtio->fDriverFeaturesWritten & DRIVER_FEATURES_0_AND_1_WRITTEN) == DRIVER_FEATURES_0_AND_1_WRITTEN
                         && !(pVirtio->fDriverFeaturesWritten & DRIVER_FEATURES_COMPLETE_HANDLED))
 #ifdef IN_RING0
+                    {
+                        STAM_COUNTER_INC(&pVirtio->StatWriteToR3);
                         return VINF_IOM_R3_MMIO_WRITE;
+                    }
 #endif
 #ifdef IN_RING3
                         virtioR3DoFeaturesCompleteOnceOnly(pVirtio, pVirtioCC);
@@ -2532,7 +3159,10 @@ static DECLCALLBACK(VBOXSTRICTRC) virtioMmioTransportWrite(PPDMDEVINS pDevIns, v
                     if (     (pVirtio->fDriverFeaturesWritten & DRIVER_FEATURES_0_AND_1_WRITTEN) == DRIVER_FEATURES_0_AND_1_WRITTEN
                         && !(pVirtio->fDriverFeaturesWritten & DRIVER_FEATURES_COMPLETE_HANDLED))
 #ifdef IN_RING0
+                    {
+                        STAM_COUNTER_INC(&pVirtio->StatWriteToR3);
                         return VINF_IOM_R3_MMIO_WRITE;
+                    }
 #endif
 #ifdef IN_RING3
                         virtioR3DoFeaturesCompleteOnceOnly(pVirtio, pVirtioCC);
@@ -2649,6 +3279,10 @@ static DECLCALLBACK(VBOXSTRICTRC) virtioMmioTransportWrite(PPDMDEVINS pDevIns, v
                                   "virtioMmioTransportWrite: Bad MMIO access to capabilities, offset=%RTiop cb=%08x\n", off, cb);
     }
 
+#ifndef IN_RING3
+    if (rc == VINF_IOM_R3_MMIO_WRITE)
+        STAM_COUNTER_INC(&pVirtio->StatWriteToR3);
+#endif
     STAM_PROFILE_ADV_STOP(&pVirtio->CTX_SUFF(StatWrite), a);
     return rc;
 }
@@ -2908,6 +3542,9 @@ DECLHIDDEN(int) virtioCoreR3ModernDeviceLoadExec(PVIRTIOCORE pVirtio, PCPDMDEVHL
         AssertRCReturn(rc, rc);
         rc = pHlp->pfnSSMGetMem( pSSM, pVirtq->szName,  sizeof(pVirtq->szName));
         AssertRCReturn(rc, rc);
+        pVirtq->uUsedIdxSynced      = pVirtq->uUsedIdxShadow;
+        pVirtq->uUsedIdxNotified    = pVirtq->uUsedIdxShadow;
+        pVirtq->cUsedInOrderPending = 0;
     }
     return VINF_SUCCESS;
 }
@@ -3009,8 +3646,11 @@ DECLHIDDEN(void) virtioCoreR3VmStateChanged(PVIRTIOCORE pVirtio, VIRTIOVMSTATECH
 DECLHIDDEN(void) virtioCoreR3Term(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTIOCORECC pVirtioCC)
 {
 #ifdef VIRTIO_REL_INFO_DUMP
-    RTTraceBufRelease(pVirtio->hTraceBuf);
-    pVirtio->hTraceBuf = NIL_RTTRACEBUF;
+    for (uint32_t uVirtq = 0; uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues); uVirtq++)
+    {
+        RTTraceBufRelease(pVirtio->aVirtqueues[uVirtq].hTraceBuf);
+        pVirtio->aVirtqueues[uVirtq].hTraceBuf = NIL_RTTRACEBUF;
+    }
 #endif /* VIRTIO_REL_INFO_DUMP */
     if (pVirtioCC->pbPrevDevSpecificCfg)
     {
@@ -3022,6 +3662,19 @@ DECLHIDDEN(void) virtioCoreR3Term(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRT
 }
 
 
+/**
+ * @callback_method_impl{FNIOMMMIODOORBELL,
+ *      Queue notification signalled by the hypervisor (ioeventfd).}
+ */
+static DECLCALLBACK(void) virtioR3VirtqDoorbell(PPDMDEVINS pDevIns, void *pvUser)
+{
+    PVIRTIOCORE const pVirtio = PDMINS_2_DATA(pDevIns, PVIRTIOCORE);
+    uint16_t const    uVirtq  = (uint16_t)(uintptr_t)pvUser;
+    /* The doorbell is registered with a data match on the queue number. */
+    virtioCoreVirtqNotified(pDevIns, pVirtio, uVirtq, uVirtq /* uNotifyIdx */);
+}
+
+
 /**
  * Setup the Virtio device as a PCI device.
  *
@@ -3241,6 +3894,24 @@ static int virtioR3PciTransportInit(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVI
                                         pVirtioCC->szMmioName,
                                         &pVirtio->hMmioPciCap);
     AssertLogRelRCReturn(rc, PDMDEV_SET_ERROR(pDevIns, rc, N_("virtio: cannot register PCI Capabilities address space")));
+
+    /*
+     * Let the hypervisor handle the queue notifications if it can (KVM ioeventfd),
+     * saving the EMT a trip to ring-3 and the MMIO write callback for each kick.
+     * Writes not matching the queue number still go thru virtioMmioWrite.
+     */
+    for (uint16_t uVirtq = 0; uVirtq < VIRTQ_MAX_COUNT; uVirtq++)
+    {
+        rc = PDMDevHlpMmioDoorbellRegister(pDevIns, pVirtio->hMmioPciCap,
+                                           pVirtio->LocNotifyCap.offMmio + uVirtq * VIRTIO_NOTIFY_OFFSET_MULTIPLIER,
+                                           sizeof(uint16_t), IOMMMIO_DOORBELL_F_DATAMATCH, uVirtq,
+                                           virtioR3VirtqDoorbell, (void *)(uintptr_t)uVirtq);
+        if (RT_FAILURE(rc))
+        {
+            AssertLogRelMsg(rc == VERR_NOT_SUPPORTED, ("%Rrc\n", rc));
+            break;
+        }
+    }
     return VINF_SUCCESS;
 }
 
@@ -3366,16 +4037,24 @@ DECLHIDDEN(int) virtioCoreR3Init(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, PVIRTI
     PDMDevHlpSTAMRegister(pDevIns, &pVirtio->StatWriteR3,   STAMTYPE_PROFILE, "IO/WriteR3",         STAMUNIT_TICKS_PER_CALL, "Profiling IO writes in R3");
     PDMDevHlpSTAMRegister(pDevIns, &pVirtio->StatWriteR0,   STAMTYPE_PROFILE, "IO/WriteR0",         STAMUNIT_TICKS_PER_CALL, "Profiling IO writes in R0");
     PDMDevHlpSTAMRegister(pDevIns, &pVirtio->StatWriteRC,   STAMTYPE_PROFILE, "IO/WriteRC",         STAMUNIT_TICKS_PER_CALL, "Profiling IO writes in RC");
+    PDMDevHlpSTAMRegister(pDevIns, &pVirtio->StatNotifyRZ,  STAMTYPE_COUNTER, "IO/NotifyRZ",        STAMUNIT_OCCURENCES,     "Virtq notifications handled in R0/RC");
+    PDMDevHlpSTAMRegister(pDevIns, &pVirtio->StatNotifyR3,  STAMTYPE_COUNTER, "IO/NotifyR3",        STAMUNIT_OCCURENCES,     "Virtq notifications handled in R3");
+    PDMDevHlpSTAMRegister(pDevIns, &pVirtio->StatWriteToR3, STAMTYPE_COUNTER, "IO/WriteToR3",       STAMUNIT_OCCURENCES,     "IO writes deferred from R0/RC to R3");
 # endif /* VBOX_WITH_STATISTICS */
 
 #ifdef VIRTIO_REL_INFO_DUMP
     pVirtio->fRecovering = false;
     pVirtio->fTestRecovery = false;
-    size_t cbBlock = VIRTIO_CORE_TRACE_BUF_SIZE;
-    rc = RTTraceBufCarve(&pVirtio->hTraceBuf, 0 /*cEntries*/, 0 /*cbEntry*/, 0 /*fFlags*/, pVirtio->aTraceBuf, &cbBlock);
-    AssertRC(rc);
-    if (RT_FAILURE(rc))
-        LogRel(("virtioCore: Failed to initialize trace buffer (rc=%d)\n", rc));
+    for (uint32_t uVirtq = 0; uVirtq < RT_ELEMENTS(pVirtio->aVirtqueues); uVirtq++)
+    {
+        PVIRTQUEUE pVirtq = &pVirtio->aVirtqueues[uVirtq];
+        rc = RTTraceBufCreate(&pVirtq->hTraceBuf, VIRTIO_CORE_TRACE_BUF_ENTRIES, VIRTIO_CORE_TRACE_BUF_ENTRY_SIZE, 0 /*fFlags*/);
+        if (RT_FAILURE(rc))
+        {
+            LogRel(("virtioCore: Failed to initialize trace buffer for queue %u (rc=%d)\n", uVirtq, rc));
+            pVirtq->hTraceBuf = NIL_RTTRACEBUF;
+        }
+    }
 #endif /* VIRTIO_REL_INFO_DUMP */
     return VINF_SUCCESS;
 }
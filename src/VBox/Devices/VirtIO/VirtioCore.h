@@ -183,9 +183,10 @@ typedef struct VIRTQBUF
 {
     uint32_t            u32Magic;                                /**< Magic value, VIRTQBUF_MAGIC.             */
     uint16_t            uVirtq;                                  /**< VirtIO index of associated virtq         */
-    uint16_t            pad;
+    uint16_t            cDescs;                                  /**< Number of descriptors in chain           */
     uint32_t volatile   cRefs;                                   /**< Reference counter.                       */
     uint32_t            uHeadIdx;                                /**< Head idx of associated desc chain        */
+    uint32_t            uBufId;                                  /**< Buffer ID returned in used ring          */
     size_t              cbPhysSend;                              /**< Total size of src buffer                 */
     PVIRTIOSGBUF        pSgPhysSend;                             /**< Phys S/G buf for data from guest         */
     size_t              cbPhysReturn;                            /**< Total size of dst buffer                 */
@@ -230,8 +231,8 @@ typedef struct VIRTIOPCIPARAMS
 #define VIRTIO_F_BAD_FEATURE                RT_BIT_64(30)        /**< QEMU kludge.  UNUSED as of >= VirtIO 1.0  */
 #define VIRTIO_F_VERSION_1                  RT_BIT_64(32)        /**< Required feature bit for 1.0 devices      */
 #define VIRTIO_F_ACCESS_PLATFORM            RT_BIT_64(33)        /**< Funky guest mem access   (VirtIO 1.1 NYI) */
-#define VIRTIO_F_RING_PACKED                RT_BIT_64(34)        /**< Packed Queue Layout      (VirtIO 1.1 NYI) */
-#define VIRTIO_F_IN_ORDER                   RT_BIT_64(35)        /**< Honor guest buf order    (VirtIO 1.1 NYI) */
+#define VIRTIO_F_RING_PACKED                RT_BIT_64(34)        /**< Packed Queue Layout                       */
+#define VIRTIO_F_IN_ORDER                   RT_BIT_64(35)        /**< Honor guest buf order (device opts in)    */
 #define VIRTIO_F_ORDER_PLATFORM             RT_BIT_64(36)        /**< Host mem access honored  (VirtIO 1.1 NYI) */
 #define VIRTIO_F_SR_IOV                     RT_BIT_64(37)        /**< Dev Single Root I/O virt (VirtIO 1.1 NYI) */
 #define VIRTIO_F_NOTIFICAITON_DATA          RT_BIT_64(38)        /**< Driver passes extra data (VirtIO 1.1 NYI) */
@@ -247,9 +248,11 @@ static const VIRTIO_FEATURES_LIST s_aCoreFeatures[] =
     { VIRTIO_F_VERSION_1,               "   VERSION_1            Guest driver supports VirtIO specification V1.0+ (e.g. \"modern\")\n" },
     { VIRTIO_F_RING_EVENT_IDX,          "   RING_EVENT_IDX       Enables use_event and avail_event fields described in 2.4.7, 2.4.8\n" },
     { VIRTIO_F_RING_INDIRECT_DESC,      "   RING_INDIRECT_DESC   Driver can use descriptors with VIRTQ_DESC_F_INDIRECT flag set\n" },
+    { VIRTIO_F_RING_PACKED,             "   RING_PACKED          Packed virtqueue layout described in 2.7\n" },
+    { VIRTIO_F_IN_ORDER,                "   IN_ORDER             Device uses buffers in the order made available\n" },
 };
 
-#define VIRTIO_DEV_INDEPENDENT_FEATURES_OFFERED ( 0 )            /**< TBD: Add VIRTIO_F_INDIRECT_DESC           */
+#define VIRTIO_DEV_INDEPENDENT_FEATURES_OFFERED ( VIRTIO_F_RING_PACKED ) /**< TBD: Add VIRTIO_F_INDIRECT_DESC       */
 #define VIRTIO_DEV_INDEPENDENT_LEGACY_FEATURES_OFFERED ( 0 )     /**< Only offered to legacy drivers            */
 
 #define VIRTIO_ISR_VIRTQ_INTERRUPT           RT_BIT_32(0)        /**< Virtq interrupt bit of ISR register       */
@@ -429,10 +432,20 @@ typedef struct VIRTQUEUE
     uint16_t                    uQueueSize;                       /**< (MMIO) Size of queue           HOST/GUEST */
     uint16_t                    uAvailIdxShadow;                  /**< Consumer's position in avail ring         */
     uint16_t                    uUsedIdxShadow;                   /**< Consumer's position in used ring          */
+    uint16_t                    uUsedIdxSynced;                   /**< Packed: 1st unpublished used position     */
+    uint16_t                    uUsedIdxNotified;                 /**< Packed: used position at last notify check*/
+    uint16_t                    fUsedFlagsPending;                /**< Packed: flags held for uUsedIdxSynced     */
+    uint16_t                    cUsedInOrderPending;              /**< In-order: used slots not written yet      */
+    uint16_t                    uUsedInOrderBufId;                /**< In-order: buffer ID ending pending run    */
     uint16_t                    uVirtq;                           /**< Index of this queue                       */
     char                        szName[32];                       /**< Dev-specific name of queue                */
     bool                        fUsedRingEvent;                   /**< Flags if used idx to notify guest reached */
     bool                        fAttached;                        /**< Flags if dev-specific client attached     */
+    bool volatile               fPhysMapCacheBusy;                /**< Set while a thread uses pPhysMapCacheR3   */
+    R3PTRTYPE(PPDMPHYSMAPCACHE) pPhysMapCacheR3;                  /**< Ring mapping cache, NULL if none          */
+#ifdef VIRTIO_REL_INFO_DUMP
+    R3PTRTYPE(RTTRACEBUF)       hTraceBuf;                        /**< Per-queue event trace, merged when dumped */
+#endif /* VIRTIO_REL_INFO_DUMP */
 } VIRTQUEUE, *PVIRTQUEUE;
 
 /**
@@ -466,9 +479,6 @@ typedef struct VIRTIOCORE
 #ifdef VIRTIO_REL_INFO_DUMP
     bool                        fRecovering;
     bool                        fTestRecovery;
-#define VIRTIO_CORE_TRACE_BUF_SIZE (256 /* header */ + 256 * 256 /* buffer*/)
-    RTTRACEBUF                  hTraceBuf;
-    uint8_t                     aTraceBuf[VIRTIO_CORE_TRACE_BUF_SIZE];
 #endif /* VIRTIO_REL_INFO_DUMP */
 
     /** @name The locations of the capability structures in PCI config space and the BAR.
@@ -496,6 +506,9 @@ typedef struct VIRTIOCORE
     STAMPROFILEADV              StatWriteR3;                       /** I/O port and MMIO R3 Write profiling      */
     STAMPROFILEADV              StatWriteR0;                       /** I/O port and MMIO R3 Write profiling      */
     STAMPROFILEADV              StatWriteRC;                       /** I/O port and MMIO R3 Write profiling      */
+    STAMCOUNTER                 StatNotifyRZ;                      /** Virtq notifications handled in R0/RC      */
+    STAMCOUNTER                 StatNotifyR3;                      /** Virtq notifications handled in R3         */
+    STAMCOUNTER                 StatWriteToR3;                     /** I/O port and MMIO writes deferred to R3   */
 #endif
     /** @} */
 
@@ -865,6 +878,7 @@ DECLHIDDEN(int) virtioCoreR3VirtqAvailBufGet(PPDMDEVINS pDevIns, PVIRTIOCORE pVi
  * @param   pDevIns     The device instance.
  * @param   pVirtio     Pointer to the shared virtio state.
  * @param   uVirtqNbr   Virtq number
+ * @param   uHeadIdx    Head descriptor index (for packed virtqs, the ring slot of the head)
  * @param   pVirtqBuf   Pointer to descriptor chain that contains the
  *                      pre-processed transaction information pulled from the virtq.
  * @param   fRemove     flags whether to remove desc chain from queue (false = peek)
@@ -1215,6 +1229,9 @@ DECLINLINE(void) virtioCoreR3VirtqBufDrain(PVIRTIOCORE pVirtio, PVIRTQBUF pVirtq
  * there is data in the queue. If enabled by guest, IRQ or MSI-X signalling will notify guest
  * proactively, otherwise guest detects updates by polling. (see VirtIO 1.0, Section 2.4 "Virtqueues").
  *
+ * Devices should put a whole burst of buffers before syncing, the guest is signalled at most once
+ * per sync and with VIRTIO_F_EVENT_IDX only if the published range crossed the guest's used_event.
+ *
  * @param   pDevIns     The device instance.
  * @param   pVirtio     Pointer to the shared virtio state.
  * @param   uVirtqNbr   Virtq number
@@ -1225,6 +1242,46 @@ DECLINLINE(void) virtioCoreR3VirtqBufDrain(PVIRTIOCORE pVirtio, PVIRTQBUF pVirtq
  */
 DECLHIDDEN(int) virtioCoreVirtqUsedRingSync(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtqNbr);
 
+/**
+ * Makes the buffers put on a packed virtq's used ring since the last call (or sync) visible
+ * to the guest, without evaluating notifications.  No-op for split virtqs.
+ *
+ * Packed used descriptors become visible one by one, so a device modifying a used buffer
+ * after putting it (the virtio-net num_buffers field) must publish each such unit before
+ * putting the next one, the guest may otherwise consume the buffer too early.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pVirtio     Pointer to the shared virtio state.
+ * @param   uVirtqNbr   Virtq number
+ */
+DECLHIDDEN(void) virtioCoreR3VirtqUsedBufPublish(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtqNbr);
+
+/**
+ * Unconditionally signals the guest (MSI-X vector of the virtq or INT#) that
+ * the used ring of the specified virtq was updated.
+ *
+ * For devices which had the ring processing taken over by an external entity
+ * (e.g. the host kernel) that already honours the guest's interrupt suppression
+ * preferences before signalling the device.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pVirtio     Pointer to the shared virtio state.
+ * @param   uVirtqNbr   Virtq number
+ */
+DECLHIDDEN(void) virtioCoreR3VirtqRaiseInterrupt(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtqNbr);
+
+/**
+ * Resynchronizes the shadow ring indexes of a virtq after an external entity
+ * (e.g. the host kernel) processed the rings.
+ *
+ * @param   pDevIns     The device instance.
+ * @param   pVirtio     Pointer to the shared virtio state.
+ * @param   uVirtqNbr   Virtq number
+ * @param   uAvailIdx   The next avail ring index the external entity would have
+ *                      processed.  The used ring index is read from the guest.
+ */
+DECLHIDDEN(void) virtioCoreR3VirtqSyncShadowIdx(PPDMDEVINS pDevIns, PVIRTIOCORE pVirtio, uint16_t uVirtqNbr, uint16_t uAvailIdx);
+
 /**
  * Allocates a descriptor chain object with the reference count of one. Copying the reference
  * to this object requires a call to virtioCoreR3VirtqBufRetain. All references must be later
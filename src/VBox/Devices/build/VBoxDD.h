@@ -101,6 +101,9 @@ extern const PDMDEVREG g_DeviceNVMe;
 #ifdef VBOX_WITH_VIRTIO_SCSI
 extern const PDMDEVREG g_DeviceVirtioSCSI;
 #endif
+#ifdef VBOX_WITH_VIRTIO_BLK
+extern const PDMDEVREG g_DeviceVirtioBlk;
+#endif
 #ifdef VBOX_WITH_EFI
 extern const PDMDEVREG g_DeviceEFI;
 #endif
@@ -170,6 +173,9 @@ extern const PDMDRVREG g_DrvHostALSAAudio;
 #ifdef VBOX_WITH_AUDIO_PULSE
 extern const PDMDRVREG g_DrvHostPulseAudio;
 #endif
+#ifdef VBOX_WITH_AUDIO_PIPEWIRE
+extern const PDMDRVREG g_DrvHostPipeWireAudio;
+#endif
 extern const PDMDRVREG g_DrvACPI;
 extern const PDMDRVREG g_DrvAcpiCpu;
 extern const PDMDRVREG g_DrvVUSBRootHub;
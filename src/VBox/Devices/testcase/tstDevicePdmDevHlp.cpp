@@ -34,6 +34,7 @@
 #include <VBox/version.h>
 #include <VBox/vmm/pdmpci.h>
 
+#include <iprt/asm.h>
 #include <iprt/assert.h>
 #include <iprt/mem.h>
 #include <iprt/rand.h>
@@ -4028,6 +4029,15 @@ static DECLCALLBACK(void) pdmR3DevHlp_PCISetIrqNoWait(PPDMDEVINS pDevIns, PPDMPC
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR3,pfnPCISetIrqMulti} */
+static DECLCALLBACK(void) pdmR3DevHlp_PCISetIrqMulti(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs,
+                                                     uint32_t cIrqs, int iLevel)
+{
+    for (int32_t iIrq = ASMBitFirstSet(pbmIrqs, cIrqs); iIrq >= 0; iIrq = ASMBitNextSet(pbmIrqs, cIrqs, (uint32_t)iIrq))
+        pdmR3DevHlp_PCISetIrq(pDevIns, pPciDev, iIrq, iLevel);
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR3,pfnISASetIrq} */
 static DECLCALLBACK(void) pdmR3DevHlp_ISASetIrq(PPDMDEVINS pDevIns, int iIrq, int iLevel)
 {
@@ -4161,6 +4171,15 @@ static DECLCALLBACK(void) pdmR3DevHlp_QueueInsert(PPDMDEVINS pDevIns, PDMQUEUEHA
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR3,pfnQueueFree} */
+static DECLCALLBACK(int) pdmR3DevHlp_QueueFree(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem)
+{
+    RT_NOREF(pDevIns, hQueue, pItem);
+    AssertFailed();
+    return VERR_NOT_IMPLEMENTED;
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR3,pfnQueueFlushIfNecessary} */
 static DECLCALLBACK(bool) pdmR3DevHlp_QueueFlushIfNecessary(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue)
 {
@@ -6048,6 +6067,7 @@ const PDMDEVHLPR3 g_tstDevPdmDevHlpR3 =
     pdmR3DevHlp_PCIPhysBulkGCPhys2CCPtrReadOnly,
     pdmR3DevHlp_PCISetIrq,
     pdmR3DevHlp_PCISetIrqNoWait,
+    pdmR3DevHlp_PCISetIrqMulti,
     pdmR3DevHlp_ISASetIrq,
     pdmR3DevHlp_ISASetIrqNoWait,
     pdmR3DevHlp_DriverAttach,
@@ -6056,6 +6076,7 @@ const PDMDEVHLPR3 g_tstDevPdmDevHlpR3 =
     pdmR3DevHlp_QueueCreate,
     pdmR3DevHlp_QueueAlloc,
     pdmR3DevHlp_QueueInsert,
+    pdmR3DevHlp_QueueFree,
     pdmR3DevHlp_QueueFlushIfNecessary,
     pdmR3DevHlp_TaskCreate,
     pdmR3DevHlp_TaskTrigger,
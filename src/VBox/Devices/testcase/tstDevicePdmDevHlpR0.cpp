@@ -240,6 +240,20 @@ static DECLCALLBACK(void) pdmR0DevHlp_PCISetIrq(PPDMDEVINS pDevIns, PPDMPCIDEV p
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR0,pfnPCISetIrqMulti} */
+static DECLCALLBACK(void) pdmR0DevHlp_PCISetIrqMulti(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs,
+                                                     uint32_t cIrqs, int iLevel)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    LogFlow(("pdmR0DevHlp_PCISetIrqMulti: caller=%p/%d: pPciDev=%p pbmIrqs=%p cIrqs=%u iLevel=%d\n",
+             pDevIns, pDevIns->iInstance, pPciDev, pbmIrqs, cIrqs, iLevel));
+
+    AssertFailed();
+
+    LogFlow(("pdmR0DevHlp_PCISetIrqMulti: caller=%p/%d: returns void\n", pDevIns, pDevIns->iInstance));
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR0,pfnISASetIrq} */
 static DECLCALLBACK(void) pdmR0DevHlp_ISASetIrq(PPDMDEVINS pDevIns, int iIrq, int iLevel)
 {
@@ -575,6 +589,15 @@ static DECLCALLBACK(void) pdmR0DevHlp_QueueInsert(PPDMDEVINS pDevIns, PDMQUEUEHA
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR0,pfnQueueFree} */
+static DECLCALLBACK(int) pdmR0DevHlp_QueueFree(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem)
+{
+    RT_NOREF(pDevIns, hQueue, pItem);
+    AssertFailed();
+    return VERR_NOT_IMPLEMENTED;
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR0,pfnQueueFlushIfNecessary} */
 static DECLCALLBACK(bool) pdmR0DevHlp_QueueFlushIfNecessary(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue)
 {
@@ -1424,6 +1447,7 @@ const PDMDEVHLPR0 g_tstDevPdmDevHlpR0 =
     pdmR0DevHlp_PCIPhysRead,
     pdmR0DevHlp_PCIPhysWrite,
     pdmR0DevHlp_PCISetIrq,
+    pdmR0DevHlp_PCISetIrqMulti,
     pdmR0DevHlp_ISASetIrq,
     pdmR0DevHlp_PhysRead,
     pdmR0DevHlp_PhysWrite,
@@ -1457,6 +1481,7 @@ const PDMDEVHLPR0 g_tstDevPdmDevHlpR0 =
     pdmR0DevHlp_TMTimeVirtGetNano,
     pdmR0DevHlp_QueueAlloc,
     pdmR0DevHlp_QueueInsert,
+    pdmR0DevHlp_QueueFree,
     pdmR0DevHlp_QueueFlushIfNecessary,
     pdmR0DevHlp_TaskTrigger,
     pdmR0DevHlp_SUPSemEventSignal,
@@ -52,6 +52,8 @@ enum GETOPTDEF_BALLOONCTRL
 {
     GETOPTDEF_BALLOONCTRL_BALLOONINC = 2000,
     GETOPTDEF_BALLOONCTRL_BALLOONDEC,
+    GETOPTDEF_BALLOONCTRL_HOSTPRESSURELOW,
+    GETOPTDEF_BALLOONCTRL_HOSTPRESSUREHIGH,
     GETOPTDEF_BALLOONCTRL_BALLOONLOWERLIMIT,
     GETOPTDEF_BALLOONCTRL_BALLOONMAX,
     GETOPTDEF_BALLOONCTRL_BALLOONSAFETY,
@@ -65,6 +67,8 @@ enum GETOPTDEF_BALLOONCTRL
 static const RTGETOPTDEF g_aBalloonOpts[] = {
     { "--balloon-dec",            GETOPTDEF_BALLOONCTRL_BALLOONDEC,        RTGETOPT_REQ_UINT32 },
     { "--balloon-groups",         GETOPTDEF_BALLOONCTRL_GROUPS,            RTGETOPT_REQ_STRING },
+    { "--balloon-host-high",      GETOPTDEF_BALLOONCTRL_HOSTPRESSUREHIGH,  RTGETOPT_REQ_UINT32 },
+    { "--balloon-host-low",       GETOPTDEF_BALLOONCTRL_HOSTPRESSURELOW,   RTGETOPT_REQ_UINT32 },
     { "--balloon-inc",            GETOPTDEF_BALLOONCTRL_BALLOONINC,        RTGETOPT_REQ_UINT32 },
     { "--balloon-interval",       GETOPTDEF_BALLOONCTRL_TIMEOUTMS,         RTGETOPT_REQ_UINT32 },
     { "--balloon-lower-limit",    GETOPTDEF_BALLOONCTRL_BALLOONLOWERLIMIT, RTGETOPT_REQ_UINT32 },
@@ -94,6 +98,17 @@ static uint32_t g_cMbMemoryBalloonDecrement  = 128;
 static uint32_t g_cMbMemoryBalloonMax        = 0;
 static uint32_t g_cMbMemoryBalloonLowerLimit = 128;
 static uint32_t g_cbMemoryBalloonSafety     = 1024;
+/** Command line: Host available memory (in MB) below which the host is considered
+ *  to be under memory pressure and balloons get inflated automatically.
+ *  Default is 0, which disables the host pressure policy. */
+static uint32_t g_cMbHostPressureLow        = 0;
+/** Command line: Host available memory (in MB) above which the host pressure
+ *  condition is considered relieved again and balloons get deflated towards their
+ *  minimum.  Must be above g_cMbHostPressureLow to provide some hysteresis;
+ *  0 means twice the low watermark. */
+static uint32_t g_cMbHostPressureHigh       = 0;
+/** Whether the host currently is under memory pressure (see balloonHostPressureUpdate()). */
+static bool     g_fHostUnderPressure        = false;
 
 
 /*********************************************************************************************************************************
@@ -297,6 +312,110 @@ static uint32_t balloonGetRequestedSize(PVBOXWATCHDOG_MACHINE pMachine)
     return cMbBalloonReq;
 }
 
+/**
+ * Determines the minimum balloon size the host pressure policy keeps the
+ * specified machine at.
+ *
+ * @return  Minimum ballooning size (in MB), 0 if no minimum set.
+ * @param   pMachine                Machine to determine minimum ballooning size for.
+ */
+static uint32_t balloonGetMinSize(PVBOXWATCHDOG_MACHINE pMachine)
+{
+    /*
+     * The minimum balloning size can be set
+     * - via per-VM extra-data ("VBoxInternal2/Watchdog/BalloonCtrl/BalloonSizeMin")
+     * - via global extra-data ("VBoxInternal2/Watchdog/BalloonCtrl/BalloonSizeMin")
+     *
+     * Precedence from top to bottom.
+     */
+    uint32_t cMbBalloonMin = 0;
+    cfgGetValueU32(g_pVirtualBox, pMachine->machine,
+                   "VBoxInternal2/Watchdog/BalloonCtrl/BalloonSizeMin",
+                   "VBoxInternal2/Watchdog/BalloonCtrl/BalloonSizeMin",
+                   &cMbBalloonMin, 0 /* Default */);
+    return cMbBalloonMin;
+}
+
+/**
+ * Re-evaluates whether the host is under memory pressure.
+ *
+ * The pressure condition is entered when the available host memory drops below
+ * the low watermark and only left again once it climbs above the high
+ * watermark, so that balloons don't oscillate around a single threshold.
+ */
+static void balloonHostPressureUpdate(void)
+{
+    if (!g_cMbHostPressureLow)
+    {
+        g_fHostUnderPressure = false;
+        return;
+    }
+
+    uint64_t cbHostRamAvail = 0;
+    int vrc = RTSystemQueryAvailableRam(&cbHostRamAvail);
+    if (RT_FAILURE(vrc))
+    {
+        serviceLogVerbose(("Error querying available host memory, rc=%Rrc\n", vrc));
+        return; /* Keep the current state. */
+    }
+
+    uint64_t const cMbHostRamAvail = cbHostRamAvail / _1M;
+    uint32_t const cMbHigh         = g_cMbHostPressureHigh > g_cMbHostPressureLow
+                                   ? g_cMbHostPressureHigh : g_cMbHostPressureLow * 2;
+    if (   !g_fHostUnderPressure
+        && cMbHostRamAvail < g_cMbHostPressureLow)
+    {
+        serviceLog("Host is under memory pressure (%RU64MB available, low watermark %RU32MB), inflating balloons ...\n",
+                   cMbHostRamAvail, g_cMbHostPressureLow);
+        g_fHostUnderPressure = true;
+    }
+    else if (   g_fHostUnderPressure
+             && cMbHostRamAvail > cMbHigh)
+    {
+        serviceLog("Host memory pressure relieved (%RU64MB available, high watermark %RU32MB), deflating balloons ...\n",
+                   cMbHostRamAvail, cMbHigh);
+        g_fHostUnderPressure = false;
+    }
+}
+
+/**
+ * Determines the balloon size the host pressure policy aims for.
+ *
+ * With the policy enabled the explicitly requested (or global maximum) size
+ * acts as upper bound the balloon is inflated towards while the host is under
+ * pressure; otherwise the balloon is deflated towards the per-VM minimum.
+ * How fast this happens and how much free memory is left to the guest is
+ * governed by balloonGetDelta() as usual.
+ *
+ * @return  Balloon size (in MB) to aim for.
+ * @param   pMachine                Machine to determine the target for.
+ * @param   cMbGuestMemFree         The guest's current free memory (MB).
+ * @param   cMbBalloonCur           The balloon's current size (MB).
+ * @param   cMbBalloonReq           The explicitly requested balloon size (MB), 0 if none.
+ * @param   cMbBalloonMax           The maximum ballooning size (MB), 0 if none.
+ */
+static uint32_t balloonGetPolicySize(PVBOXWATCHDOG_MACHINE pMachine, uint32_t cMbGuestMemFree,
+                                     uint32_t cMbBalloonCur, uint32_t cMbBalloonReq, uint32_t cMbBalloonMax)
+{
+    uint32_t const cMbBalloonMin = balloonGetMinSize(pMachine);
+    uint32_t       cMbTarget;
+    if (g_fHostUnderPressure)
+    {
+        cMbTarget = cMbBalloonReq ? cMbBalloonReq : cMbBalloonMax;
+        if (!cMbTarget) /* No upper bound configured, take what the guest can spare. */
+            cMbTarget = cMbBalloonCur + cMbGuestMemFree;
+    }
+    else
+        cMbTarget = cMbBalloonMin;
+
+    if (cMbTarget < cMbBalloonMin)
+        cMbTarget = cMbBalloonMin;
+
+    serviceLogVerbose(("[%ls] Host pressure policy (%s): Minimum=%RU32MB, Target=%RU32MB\n", pMachine->strName.raw(),
+                       g_fHostUnderPressure ? "under pressure" : "relaxed", cMbBalloonMin, cMbTarget));
+    return cMbTarget;
+}
+
 /**
  * Determines whether ballooning for the specified machine is enabled or not.
  * This can be specified on a per-VM basis or as a globally set value for all VMs.
@@ -475,8 +594,13 @@ static int balloonMachineUpdate(PVBOXWATCHDOG_MACHINE pMachine)
                            pMachine->strName.raw(), cMbBalloonReq, cMbBalloonMax);
         }
 
+        /* Let the host pressure policy pick the target size if enabled. */
+        uint32_t cMbBalloonNew = cMbBalloonReq;
+        if (g_cMbHostPressureLow)
+            cMbBalloonNew = balloonGetPolicySize(pMachine, cMbGuestMemFree, cMbBalloonCur, cMbBalloonReq, cMbBalloonMax);
+
         /* Calculate current balloon delta. */
-        int32_t cMbBalloonDelta = balloonGetDelta(pMachine, cMbGuestMemFree, cMbBalloonCur, cMbBalloonReq, cMbBalloonMax);
+        int32_t cMbBalloonDelta = balloonGetDelta(pMachine, cMbGuestMemFree, cMbBalloonCur, cMbBalloonNew, cMbBalloonMax);
 #ifdef DEBUG
         serviceLogVerbose(("[%ls] cMbBalloonDelta=%RI32\n", pMachine->strName.raw(), cMbBalloonDelta));
 #endif
@@ -592,6 +716,14 @@ static DECLCALLBACK(int) VBoxModBallooningOption(int argc, char *argv[], int *pi
                 g_cMbMemoryBalloonIncrement = ValueUnion.u32;
                 break;
 
+            case GETOPTDEF_BALLOONCTRL_HOSTPRESSUREHIGH:
+                g_cMbHostPressureHigh = ValueUnion.u32;
+                break;
+
+            case GETOPTDEF_BALLOONCTRL_HOSTPRESSURELOW:
+                g_cMbHostPressureLow = ValueUnion.u32;
+                break;
+
             case GETOPTDEF_BALLOONCTRL_GROUPS:
                 /** @todo Add ballooning groups cmd line arg. */
                 break;
@@ -652,6 +784,25 @@ static DECLCALLBACK(int) VBoxModBallooningInit(void)
                        "VBoxInternal2/Watchdog/BalloonCtrl/BalloonLowerLimitMB", NULL /* Per-machine */,
                        &g_cMbMemoryBalloonLowerLimit, 128);
 
+    if (!g_cMbHostPressureLow)
+        cfgGetValueU32(g_pVirtualBox, NULL /* Machine */,
+                       "VBoxInternal2/Watchdog/BalloonCtrl/HostPressureLowMB", NULL /* Per-machine */,
+                       &g_cMbHostPressureLow, 0 /* Disabled */);
+
+    if (!g_cMbHostPressureHigh)
+        cfgGetValueU32(g_pVirtualBox, NULL /* Machine */,
+                       "VBoxInternal2/Watchdog/BalloonCtrl/HostPressureHighMB", NULL /* Per-machine */,
+                       &g_cMbHostPressureHigh, 0 /* Twice the low watermark */);
+
+    if (   g_cMbHostPressureLow
+        && g_cMbHostPressureHigh
+        && g_cMbHostPressureHigh <= g_cMbHostPressureLow)
+    {
+        serviceLog("Warning: Host pressure high watermark (%RU32MB) must be above the low watermark (%RU32MB), using %RU32MB\n",
+                   g_cMbHostPressureHigh, g_cMbHostPressureLow, g_cMbHostPressureLow * 2);
+        g_cMbHostPressureHigh = g_cMbHostPressureLow * 2;
+    }
+
     return VINF_SUCCESS;
 }
 
@@ -669,6 +820,8 @@ static DECLCALLBACK(int) VBoxModBallooningMain(void)
 
     int rc = VINF_SUCCESS;
 
+    balloonHostPressureUpdate();
+
     /** @todo Provide API for enumerating/working w/ machines inside a module! */
     mapVMIter it = g_mapVM.begin();
     while (it != g_mapVM.end())
@@ -759,6 +912,7 @@ VBOXMODULE g_ModBallooning =
     0 /* Not used */,
     /* pszUsage. */
     "           [--balloon-dec=<MB>] [--balloon-groups=<string>]\n"
+    "           [--balloon-host-high=<MB>] [--balloon-host-low=<MB>]\n"
     "           [--balloon-inc=<MB>] [--balloon-interval=<ms>]\n"
     "           [--balloon-lower-limit=<MB>] [--balloon-max=<MB>]\n"
     "           [--balloon-safety-margin=<MB]\n",
@@ -767,6 +921,14 @@ VBOXMODULE g_ModBallooning =
     "      Sets the ballooning decrement in MB (128 MB).\n"
     "  --balloon-groups=<string>\n"
     "      Sets the VM groups for ballooning (all).\n"
+    "  --balloon-host-high=<MB>\n"
+    "      Sets the available host memory in MB above which balloons\n"
+    "      are deflated again after host memory pressure (2x low).\n"
+    "  --balloon-host-low=<MB>\n"
+    "      Sets the available host memory in MB below which balloons\n"
+    "      are inflated automatically (0 MB, disabled).\n"
+    "      Set \"VBoxInternal2/Watchdog/BalloonCtrl/BalloonSizeMin\" for a\n"
+    "      per-VM minimum ballooning size.\n"
     "  --balloon-inc=<MB>\n"
     "      Sets the ballooning increment in MB (256 MB).\n"
     "  --balloon-interval=<ms>\n"
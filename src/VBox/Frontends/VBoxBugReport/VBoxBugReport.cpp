@@ -533,7 +533,7 @@ BugReportTarGzip::BugReportTarGzip(const char *pszFileName)
     handleRtError(RTVfsIoStrmOpenNormal(pszFileName, RTFILE_O_WRITE | RTFILE_O_CREATE | RTFILE_O_DENY_WRITE,
                                         hVfsOut.getPtr()),
                   "Failed to create output file '%s'", pszFileName);
-    handleRtError(RTZipGzipCompressIoStream(hVfsOut.get(), 0, 6, m_hVfsGzip.getPtr()),
+    handleRtError(RTZipGzipCompressIoStream(hVfsOut.get(), RTZIPGZIPCOMP_F_PARALLEL, 6, m_hVfsGzip.getPtr()),
                   "Failed to create compressed stream for '%s'", pszFileName);
 
     int rc = RTZipTarFsStreamToIoStream(m_hVfsGzip.get(), RTZIPTARFORMAT_DEFAULT, RTZIPTAR_C_SPARSE, &m_hTarFss);
@@ -1234,6 +1234,8 @@ const char *ShClGuestMsgToStr(uint32_t uMsg)
         RT_CASE_RET_STR(VBOX_SHCL_GUEST_FN_OBJ_WRITE);
         RT_CASE_RET_STR(VBOX_SHCL_GUEST_FN_ERROR);
         RT_CASE_RET_STR(VBOX_SHCL_GUEST_FN_NEGOTIATE_CHUNK_SIZE);
+        RT_CASE_RET_STR(VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK);
+        RT_CASE_RET_STR(VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK);
     }
     return "Unknown";
 }
@@ -430,6 +430,8 @@ static SUPFUNC g_aFunctions[] =
     SUPEXP_STK_BACKF(   3,  RTMpOnOthers),
     SUPEXP_STK_BACKF(   4,  RTMpOnSpecific),
     SUPEXP_STK_BACK(    1,  RTMpPokeCpu),
+    SUPEXP_STK_BACK(    1,  RTMpPostIpiCpu),
+    SUPEXP_STK_BACK(    0,  RTMpPostIpiGetVector),
     SUPEXP_STK_OKAY(    4,  RTNetIPv4AddDataChecksum),
     SUPEXP_STK_OKAY(    2,  RTNetIPv4AddTCPChecksum),
     SUPEXP_STK_OKAY(    2,  RTNetIPv4AddUDPChecksum),
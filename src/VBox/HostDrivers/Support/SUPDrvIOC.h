@@ -232,7 +232,7 @@ typedef SUPREQHDR *PSUPREQHDR;
  * @todo Pending work on next major version change:
  *          - nothing
  */
-#define SUPDRV_IOC_VERSION                              0x00340002
+#define SUPDRV_IOC_VERSION                              0x00340003
 
 /** SUP_IOCTL_COOKIE. */
 typedef struct SUPCOOKIE
@@ -214,7 +214,7 @@ int DragAndDropService::init(VBOXHGCMSVCFNTABLE *pTable) RT_NOEXCEPT
     modeSet(VBOX_DRAG_AND_DROP_MODE_OFF);
 
     /* Set host features. */
-    m_fHostFeatures0 = VBOX_DND_HF_NONE;
+    m_fHostFeatures0 = VBOX_DND_HF_0_LARGE_CHUNKS;
 
     int rc = VINF_SUCCESS;
 
@@ -70,6 +70,8 @@
 #include <VBox/AssertGuest.h>
 
 #include <list>
+#include <map>
+#include <vector>
 
 
 namespace guestProp {
@@ -162,17 +164,55 @@ struct GuestCall
     VBOXHGCMSVCPARM *mParms;
     /** The default return value, used for passing warnings */
     int mRc;
+    /** The literal prefixes of the patterns the call is waiting on, i.e. the
+     * keys under which it is filed in the waiter index.  An empty prefix
+     * means that any property name may match. */
+    std::vector<RTCString> mPrefixes;
+    /** Notification sequence number the call was last considered for, used to
+     * visit each waiter only once per notification. */
+    uint64_t mNotifySeq;
 
     /** The standard constructor */
-    GuestCall(void) : u32ClientId(0), mFunction(0), mParmsCnt(0) {}
+    GuestCall(void) : u32ClientId(0), mFunction(0), mParmsCnt(0), mNotifySeq(0) {}
     /** The normal constructor */
     GuestCall(uint32_t aClientId, VBOXHGCMCALLHANDLE aHandle, uint32_t aFunction,
               uint32_t aParmsCnt, VBOXHGCMSVCPARM aParms[], int aRc)
               : u32ClientId(aClientId), mHandle(aHandle), mFunction(aFunction),
-                mParmsCnt(aParmsCnt), mParms(aParms), mRc(aRc) {}
+                mParmsCnt(aParmsCnt), mParms(aParms), mRc(aRc), mNotifySeq(0) {}
+
+    /**
+     * Fills mPrefixes with the literal part of each '|' separated pattern in
+     * @a pszPatterns, that is everything up to the first wildcard.
+     * @throws  std::bad_alloc
+     */
+    void setPrefixes(const char *pszPatterns)
+    {
+        mPrefixes.clear();
+        if (*pszPatterns == '\0') /* match all */
+        {
+            mPrefixes.push_back(RTCString());
+            return;
+        }
+        for (;;)
+        {
+            size_t const cchPattern = strcspn(pszPatterns, "|");
+            size_t const cchPrefix  = RT_MIN(strcspn(pszPatterns, "*?"), cchPattern);
+            RTCString strPrefix(pszPatterns, cchPrefix);
+            bool fDup = false;
+            for (size_t i = 0; i < mPrefixes.size() && !fDup; i++)
+                fDup = mPrefixes[i] == strPrefix;
+            if (!fDup)
+                mPrefixes.push_back(strPrefix);
+            if (pszPatterns[cchPattern] == '\0')
+                break;
+            pszPatterns += cchPattern + 1;
+        }
+    }
 };
 /** The guest call list type */
 typedef std::list <GuestCall> CallList;
+/** Index of the waiting guest calls by the literal prefix of their patterns. */
+typedef std::multimap <RTCString, CallList::iterator> CallIndex;
 
 /**
  * Class containing the shared information service functionality.
@@ -195,6 +235,11 @@ private:
     PropertyList mGuestNotifications;
     /** The list of outstanding guest notification calls */
     CallList mGuestWaiters;
+    /** mGuestWaiters indexed by pattern prefix, so that a change only has to
+     * look at the waiters which can possibly be interested in it. */
+    CallIndex mGuestWaiterIndex;
+    /** Sequence number of the last notification, see GuestCall::mNotifySeq. */
+    uint64_t mNotifySeq;
     /** @todo we should have classes for thread and request handler thread */
     /** Callback function supplied by the host for notification of updates
      * to properties */
@@ -326,6 +371,7 @@ public:
         , mfGlobalFlags(GUEST_PROP_F_NILFLAG)
         , mhProperties(NULL)
         , mcProperties(0)
+        , mNotifySeq(0)
         , mpfnHostCallback(NULL)
         , mpvHostData(NULL)
         , mPrevTimestamp(0)
@@ -430,6 +476,7 @@ private:
     int setPropertyBlock(uint32_t cParms, VBOXHGCMSVCPARM paParms[]);
     int getProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[]);
     int setProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[], bool isGuest);
+    int setProperties(uint32_t cParms, VBOXHGCMSVCPARM paParms[]);
     int setPropertyInternal(const char *pcszName, const char *pcszValue, uint32_t fFlags, uint64_t nsTimestamp,
                             bool fIsGuest = false);
     int delProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[], bool isGuest);
@@ -437,6 +484,9 @@ private:
     int getNotification(uint32_t u32ClientId, VBOXHGCMCALLHANDLE callHandle, uint32_t cParms, VBOXHGCMSVCPARM paParms[]);
     int getOldNotificationInternal(const char *pszPattern, uint64_t nsTimestamp, Property *pProp);
     int getNotificationWriteOut(uint32_t cParms, VBOXHGCMSVCPARM paParms[], Property const &prop, bool fWasDeleted);
+    int addWaiter(uint32_t u32ClientId, VBOXHGCMCALLHANDLE callHandle, uint32_t cParms, VBOXHGCMSVCPARM paParms[],
+                  const char *pszPatterns, int rcDefault);
+    CallList::iterator removeWaiter(CallList::iterator itWaiter);
     int doNotifications(const char *pszProperty, uint64_t nsTimestamp);
     int notifyHost(const char *pszName, const char *pszValue, uint64_t nsTimestamp, const char *pszFlags);
 
@@ -719,6 +769,103 @@ int Service::setProperty(uint32_t cParms, VBOXHGCMSVCPARM paParms[], bool isGues
     return rc;
 }
 
+/**
+ * Set several properties in the property registry on behalf of the guest,
+ * checking the validity of the arguments passed.
+ *
+ * All entries are validated before the first one is applied.  They are then
+ * applied in order with increasing timestamps, so guests waiting for
+ * notifications see them exactly as if they had been set one at a time.
+ *
+ * @returns iprt status value
+ * @param   cParms  the number of HGCM parameters supplied
+ * @param   paParms the array of HGCM parameters
+ * @thread  HGCM
+ */
+int Service::setProperties(uint32_t cParms, VBOXHGCMSVCPARM paParms[])
+{
+    const char *pchBuf = NULL;
+    uint32_t    cbBuf  = 0;
+
+    LogFlowThisFunc(("\n"));
+
+    /*
+     * Check the user-supplied parameters.
+     */
+    if (   cParms != 1  /* Hardcoded value as the next lines depend on it. */
+        || RT_FAILURE(HGCMSvcGetBuf(&paParms[0], (void **)&pchBuf, &cbBuf))
+        || cbBuf == 0
+        || pchBuf[cbBuf - 1] != '\0')
+    {
+        LogFlowThisFunc(("rc=VERR_INVALID_PARAMETER\n"));
+        return VERR_INVALID_PARAMETER;
+    }
+
+    /*
+     * Validate all the triplets up front.  The buffer is terminated, so the
+     * string lengths cannot run past its end, but a triplet may be cut short.
+     */
+    int      rc     = VINF_SUCCESS;
+    uint32_t cProps = 0;
+    uint32_t off    = 0;
+    while (off < cbBuf && pchBuf[off] != '\0')
+    {
+        const char *apsz[3];
+        uint32_t    acb[3];
+        for (unsigned i = 0; i < RT_ELEMENTS(apsz); i++)
+        {
+            if (off >= cbBuf)
+            {
+                rc = VERR_INVALID_PARAMETER;
+                break;
+            }
+            apsz[i] = &pchBuf[off];
+            acb[i]  = (uint32_t)strlen(apsz[i]) + 1;
+            off    += acb[i];
+        }
+        uint32_t fFlags;
+        if (RT_SUCCESS(rc))
+            rc = GuestPropValidateName(apsz[0], acb[0]);
+        if (RT_SUCCESS(rc))
+            rc = GuestPropValidateValue(apsz[1], acb[1]);
+        if (RT_SUCCESS(rc))
+            rc = GuestPropValidateFlags(apsz[2], &fFlags);
+        if (RT_SUCCESS(rc) && ++cProps > GUEST_PROP_MAX_PROPS)
+            rc = VERR_TOO_MUCH_DATA;
+        if (RT_FAILURE(rc))
+        {
+            LogFlowThisFunc(("triplet #%u: rc=%Rrc\n", cProps, rc));
+            return rc;
+        }
+    }
+    if (off >= cbBuf) /* missing the terminating empty name */
+    {
+        LogFlowThisFunc(("rc=VERR_INVALID_PARAMETER (unterminated)\n"));
+        return VERR_INVALID_PARAMETER;
+    }
+
+    /*
+     * Apply them, stopping at the first one we are not allowed to set.
+     */
+    const char *psz = pchBuf;
+    for (uint32_t i = 0; i < cProps && RT_SUCCESS(rc); i++)
+    {
+        const char *pszName  = psz;
+        const char *pszValue = RTStrEnd(pszName, RTSTR_MAX) + 1;
+        const char *pszFlags = RTStrEnd(pszValue, RTSTR_MAX) + 1;
+        psz = RTStrEnd(pszFlags, RTSTR_MAX) + 1;
+
+        uint32_t fFlags = GUEST_PROP_F_NILFLAG;
+        rc = GuestPropValidateFlags(pszFlags, &fFlags);
+        AssertRC(rc);
+        if (RT_SUCCESS(rc))
+            rc = setPropertyInternal(pszName, pszValue, fFlags, getCurrentTimestamp(), true /*fIsGuest*/);
+    }
+
+    LogFlowThisFunc(("cProps=%u, rc=%Rrc\n", cProps, rc));
+    return rc;
+}
+
 /**
  * Internal property setter.
  *
@@ -1164,13 +1311,13 @@ int Service::getNotification(uint32_t u32ClientId, VBOXHGCMCALLHANDLE callHandle
                         {
                             /* Complete the old request. */
                             mpHelpers->pfnCallComplete(it->mHandle, VERR_INTERRUPTED);
-                            it = mGuestWaiters.erase(it);
+                            it = removeWaiter(it);
                         }
                         else if (mpHelpers->pfnIsCallCancelled(it->mHandle))
                         {
                             /* Cleanup cancelled request. */
                             mpHelpers->pfnCallComplete(it->mHandle, VERR_INTERRUPTED);
-                            it = mGuestWaiters.erase(it);
+                            it = removeWaiter(it);
                         }
                         else
                         {
@@ -1184,18 +1331,7 @@ int Service::getNotification(uint32_t u32ClientId, VBOXHGCMCALLHANDLE callHandle
                 }
 
                 if (cPendingWaits < GUEST_PROP_MAX_GUEST_CONCURRENT_WAITS)
-                {
-                    try
-                    {
-                        mGuestWaiters.push_back(GuestCall(u32ClientId, callHandle, GUEST_PROP_FN_GET_NOTIFICATION,
-                                                          cParms, paParms, rc));
-                        rc = VINF_HGCM_ASYNC_EXECUTE;
-                    }
-                    catch (std::bad_alloc &)
-                    {
-                        rc = VERR_NO_MEMORY;
-                    }
-                }
+                    rc = addWaiter(u32ClientId, callHandle, cParms, paParms, pszPatterns, rc);
                 else
                 {
                     LogFunc(("Too many pending waits already!\n"));
@@ -1219,6 +1355,70 @@ int Service::getNotification(uint32_t u32ClientId, VBOXHGCMCALLHANDLE callHandle
 }
 
 
+/**
+ * Queues a GET_NOTIFICATION call and files it in the waiter index.
+ *
+ * @returns VINF_HGCM_ASYNC_EXECUTE on success, VERR_NO_MEMORY on failure.
+ * @param   u32ClientId the client ID
+ * @param   callHandle  handle
+ * @param   cParms      the number of HGCM parameters supplied
+ * @param   paParms     the array of HGCM parameters
+ * @param   pszPatterns the patterns the call waits on (paParms[0])
+ * @param   rcDefault   the status to complete the call with, used for passing
+ *                      warnings
+ * @thread  HGCM
+ * @throws  nothing
+ */
+int Service::addWaiter(uint32_t u32ClientId, VBOXHGCMCALLHANDLE callHandle, uint32_t cParms, VBOXHGCMSVCPARM paParms[],
+                       const char *pszPatterns, int rcDefault)
+{
+    CallList::iterator itWaiter = mGuestWaiters.end();
+    try
+    {
+        itWaiter = mGuestWaiters.insert(mGuestWaiters.end(),
+                                        GuestCall(u32ClientId, callHandle, GUEST_PROP_FN_GET_NOTIFICATION,
+                                                  cParms, paParms, rcDefault));
+        itWaiter->setPrefixes(pszPatterns);
+        for (size_t i = 0; i < itWaiter->mPrefixes.size(); i++)
+            mGuestWaiterIndex.insert(CallIndex::value_type(itWaiter->mPrefixes[i], itWaiter));
+    }
+    catch (std::bad_alloc &)
+    {
+        if (itWaiter != mGuestWaiters.end())
+            removeWaiter(itWaiter);
+        return VERR_NO_MEMORY;
+    }
+    return VINF_HGCM_ASYNC_EXECUTE;
+}
+
+/**
+ * Removes a waiting call from the list and the index.  The caller is
+ * responsible for completing the call.
+ *
+ * @returns Iterator to the list entry following the removed one.
+ * @param   itWaiter    The waiter to remove.
+ * @thread  HGCM
+ * @throws  nothing
+ */
+CallList::iterator Service::removeWaiter(CallList::iterator itWaiter)
+{
+    for (size_t i = 0; i < itWaiter->mPrefixes.size(); i++)
+    {
+        CallIndex::iterator itIdx = mGuestWaiterIndex.lower_bound(itWaiter->mPrefixes[i]);
+        while (itIdx != mGuestWaiterIndex.end() && itIdx->first == itWaiter->mPrefixes[i])
+        {
+            if (itIdx->second == itWaiter)
+            {
+                mGuestWaiterIndex.erase(itIdx);
+                break;
+            }
+            ++itIdx;
+        }
+    }
+    return mGuestWaiters.erase(itWaiter);
+}
+
+
 /**
  * Notify the service owner and the guest that a property has been
  * added/deleted/changed
@@ -1261,32 +1461,57 @@ int Service::doNotifications(const char *pszProperty, uint64_t nsTimestamp)
         prop.mFlags = pProp->mFlags;
     }
 
-    /* Release guest waiters if applicable and add the event
-     * to the queue for guest notifications */
-    CallList::iterator it = mGuestWaiters.begin();
-    while (it != mGuestWaiters.end())
+    /*
+     * Release guest waiters if applicable and add the event to the queue for
+     * guest notifications.  Only waiters filed under a prefix of the property
+     * name can match, so look up each of those and check the candidates
+     * against their full patterns.  Completing a waiter drops all its index
+     * entries, so restart the lookup afterwards; waiters already looked at
+     * are skipped by their sequence number.
+     */
+    if (!mGuestWaiters.empty())
     {
-        const char *pszPatterns = NULL;
-        uint32_t    cchPatterns;
-        int rc2;
-
-        rc2 = HGCMSvcGetCStr(&it->mParms[0], &pszPatterns, &cchPatterns);
-        if (RT_FAILURE(rc2))
-        {
-            LogRel(("doNotifications: failed to get match pattern for guest property notification request, rc=%Rrc\n", rc2));
-            mpHelpers->pfnCallComplete(it->mHandle, VERR_INVALID_PARAMETER);
-            it = mGuestWaiters.erase(it);
-        }
-        else if (prop.Matches(pszPatterns))
+        uint64_t const uSeq = ++mNotifySeq;
+        size_t const cchProperty = strlen(pszProperty);
+        for (size_t cchPrefix = 0; cchPrefix <= cchProperty; cchPrefix++)
         {
-            rc2 = getNotificationWriteOut(it->mParmsCnt, it->mParms, prop, !pProp);
-            if (RT_SUCCESS(rc2))
-                rc2 = it->mRc;
-            mpHelpers->pfnCallComplete(it->mHandle, rc2);
-            it = mGuestWaiters.erase(it);
+            RTCString strPrefix;
+            int rc2 = strPrefix.assignNoThrow(pszProperty, cchPrefix);
+            AssertRCBreakStmt(rc2, rc = rc2);
+            CallIndex::iterator itIdx = mGuestWaiterIndex.lower_bound(strPrefix);
+            while (itIdx != mGuestWaiterIndex.end() && itIdx->first == strPrefix)
+            {
+                CallList::iterator it = itIdx->second;
+                if (it->mNotifySeq == uSeq) /* already checked */
+                {
+                    ++itIdx;
+                    continue;
+                }
+                it->mNotifySeq = uSeq;
+
+                const char *pszPatterns = NULL;
+                uint32_t    cchPatterns;
+                rc2 = HGCMSvcGetCStr(&it->mParms[0], &pszPatterns, &cchPatterns);
+                if (RT_FAILURE(rc2))
+                {
+                    LogRel(("doNotifications: failed to get match pattern for guest property notification request, rc=%Rrc\n", rc2));
+                    mpHelpers->pfnCallComplete(it->mHandle, VERR_INVALID_PARAMETER);
+                    removeWaiter(it);
+                    itIdx = mGuestWaiterIndex.lower_bound(strPrefix);
+                }
+                else if (prop.Matches(pszPatterns))
+                {
+                    rc2 = getNotificationWriteOut(it->mParmsCnt, it->mParms, prop, !pProp);
+                    if (RT_SUCCESS(rc2))
+                        rc2 = it->mRc;
+                    mpHelpers->pfnCallComplete(it->mHandle, rc2);
+                    removeWaiter(it);
+                    itIdx = mGuestWaiterIndex.lower_bound(strPrefix);
+                }
+                else
+                    ++itIdx;
+            }
         }
-        else
-            ++it;
     }
 
     try
@@ -1433,6 +1658,12 @@ void Service::call(VBOXHGCMCALLHANDLE callHandle, uint32_t u32ClientID,
             rc = setProperty(cParms, paParms, true);
             break;
 
+        /* The guest wishes to set several properties at once */
+        case GUEST_PROP_FN_SET_PROPS:
+            LogFlowFunc(("SET_PROPS\n"));
+            rc = setProperties(cParms, paParms);
+            break;
+
         /* The guest wishes to remove a configuration value */
         case GUEST_PROP_FN_DEL_PROP:
             LogFlowFunc(("DEL_PROP\n"));
@@ -1595,7 +1826,7 @@ int Service::hostCall (uint32_t eFunction, uint32_t cParms, VBOXHGCMSVCPARM paPa
         {
             LogFlowFunc(("Completing call %u (%p)...\n", rCurCall.mFunction, rCurCall.mHandle));
             pThis->mpHelpers->pfnCallComplete(rCurCall.mHandle, VERR_INTERRUPTED);
-            It = pThis->mGuestWaiters.erase(It);
+            It = pThis->removeWaiter(It);
         }
     }
 
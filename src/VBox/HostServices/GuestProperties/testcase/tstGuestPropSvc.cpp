@@ -1190,7 +1190,90 @@ static void test6(void)
     RTTESTI_CHECK_RC_OK(svcTable.pfnUnload(svcTable.pvService));
 }
 
+/**
+ * Queue a GET_NOTIFICATION call which is expected to block.
+ */
+static void doWaitNotification(VBOXHGCMSVCFNTABLE *pTable, char *pszPatterns, VBOXHGCMSVCPARM *paParms,
+                               char *pchBuf, uint32_t cbBuf, VBOXHGCMCALLHANDLE_TYPEDEF *pCallHandle)
+{
+    HGCMSvcSetStr(&paParms[0], pszPatterns);
+    HGCMSvcSetU64(&paParms[1], 0);
+    HGCMSvcSetPv(&paParms[2], pchBuf, cbBuf);
+    HGCMSvcSetU32(&paParms[3], 0);
+    pCallHandle->rc = VINF_HGCM_ASYNC_EXECUTE;
+    pTable->pfnCall(pTable->pvService, pCallHandle, 0, NULL, GUEST_PROP_FN_GET_NOTIFICATION, 4, paParms, 0);
+    if (pCallHandle->rc != VINF_HGCM_ASYNC_EXECUTE)
+        RTTestIFailed("GET_NOTIFICATION for '%s' did not block: rc=%Rrc", pszPatterns, pCallHandle->rc);
+}
+
+static void test7(void)
+{
+    RTTestISub("SET_PROPS and notification filtering");
+
+    VBOXHGCMSVCFNTABLE  svcTable;
+    VBOXHGCMSVCHELPERS  svcHelpers;
+    initTable(&svcTable, &svcHelpers);
+    RTTESTI_CHECK_RC_OK_RETV(VBoxHGCMSvcLoad(&svcTable));
 
+    /* Two waiters whose patterns only match one of the properties set below
+     * and one which none of them match. */
+    static char s_szPatterns1[] = "/Other/*|/Bulk/B*";
+    static char s_szPatterns2[] = "/Bulk/?";
+    static char s_szPatterns3[] = "/Other/*|Bulk*";
+    VBOXHGCMSVCPARM             aParms1[4], aParms2[4], aParms3[4];
+    char                        achBuf1[256], achBuf2[256], achBuf3[256];
+    VBOXHGCMCALLHANDLE_TYPEDEF  hCall1, hCall2, hCall3;
+    doWaitNotification(&svcTable, s_szPatterns1, aParms1, achBuf1, sizeof(achBuf1), &hCall1);
+    doWaitNotification(&svcTable, s_szPatterns2, aParms2, achBuf2, sizeof(achBuf2), &hCall2);
+    doWaitNotification(&svcTable, s_szPatterns3, aParms3, achBuf3, sizeof(achBuf3), &hCall3);
+
+    /* Malformed blocks must be rejected without touching anything. */
+    static char s_achNoTerm[]   = "/Bulk/A\0one\0";
+    static char s_achBadFlags[] = "/Bulk/A\0one\0\0/Bulk/B\0two\0bogus\0";
+    VBOXHGCMCALLHANDLE_TYPEDEF callHandle = { VINF_SUCCESS };
+    VBOXHGCMSVCPARM aParms[4];
+    HGCMSvcSetPv(&aParms[0], s_achNoTerm, sizeof(s_achNoTerm) - 1);
+    svcTable.pfnCall(svcTable.pvService, &callHandle, 0, NULL, GUEST_PROP_FN_SET_PROPS, 1, aParms, 0);
+    RTTESTI_CHECK_RC(callHandle.rc, VERR_INVALID_PARAMETER);
+    HGCMSvcSetPv(&aParms[0], s_achBadFlags, sizeof(s_achBadFlags));
+    svcTable.pfnCall(svcTable.pvService, &callHandle, 0, NULL, GUEST_PROP_FN_SET_PROPS, 1, aParms, 0);
+    RTTESTI_CHECK_RC(callHandle.rc, VERR_PARSE_ERROR);
+    RTTESTI_CHECK_RC(hCall1.rc, VINF_HGCM_ASYNC_EXECUTE);
+    RTTESTI_CHECK_RC(hCall2.rc, VINF_HGCM_ASYNC_EXECUTE);
+
+    /* Set two properties in one go. */
+    static char s_achProps[] = "/Bulk/A\0one\0\0/Bulk/Bee\0two\0TRANSIENT\0";
+    HGCMSvcSetPv(&aParms[0], s_achProps, sizeof(s_achProps));
+    svcTable.pfnCall(svcTable.pvService, &callHandle, 0, NULL, GUEST_PROP_FN_SET_PROPS, 1, aParms, 0);
+    RTTESTI_CHECK_RC(callHandle.rc, VINF_SUCCESS);
+
+    static char const s_achNotify1[] = "/Bulk/Bee\0two\0TRANSIENT\0";
+    static char const s_achNotify2[] = "/Bulk/A\0one\0\0";
+    RTTESTI_CHECK_RC(hCall1.rc, VINF_SUCCESS);
+    RTTESTI_CHECK(memcmp(achBuf1, s_achNotify1, sizeof(s_achNotify1) - 1) == 0);
+    RTTESTI_CHECK_RC(hCall2.rc, VINF_SUCCESS);
+    RTTESTI_CHECK(memcmp(achBuf2, s_achNotify2, sizeof(s_achNotify2) - 1) == 0);
+    RTTESTI_CHECK_RC(hCall3.rc, VINF_HGCM_ASYNC_EXECUTE);
+
+    /* Both properties must be there. */
+    static const char * const s_apszNames[] = { "/Bulk/A", "/Bulk/Bee" };
+    for (unsigned i = 0; i < RT_ELEMENTS(s_apszNames); i++)
+    {
+        char szName[GUEST_PROP_MAX_NAME_LEN];
+        char szBuffer[GUEST_PROP_MAX_VALUE_LEN + GUEST_PROP_MAX_FLAGS_LEN];
+        RTStrCopy(szName, sizeof(szName), s_apszNames[i]);
+        HGCMSvcSetStr(&aParms[0], szName);
+        HGCMSvcSetPv(&aParms[1], szBuffer, sizeof(szBuffer));
+        RTTESTI_CHECK_RC(svcTable.pfnHostCall(svcTable.pvService, GUEST_PROP_FN_HOST_GET_PROP, 4, aParms), VINF_SUCCESS);
+    }
+
+    /* Disconnecting must complete the remaining waiter. */
+    RTTESTI_CHECK_RC(svcTable.pfnDisconnect(svcTable.pvService, 0, NULL), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(hCall3.rc, VERR_INTERRUPTED);
+
+    /* Done. */
+    RTTESTI_CHECK_RC_OK(svcTable.pfnUnload(svcTable.pvService));
+}
 
 
 int main()
@@ -1206,6 +1289,7 @@ int main()
     test4();
     test5();
     test6();
+    test7();
 
     return RTTestSummaryAndDestroy(g_hTest);
 }
@@ -675,6 +675,58 @@ int vboxHostChannelSend(VBOXHOSTCHCLIENT *pClient,
     return rc;
 }
 
+int vboxHostChannelSendBatch(VBOXHOSTCHCLIENT *pClient,
+                             uint32_t u32Handle,
+                             const void *pvData,
+                             uint32_t cbData,
+                             uint32_t *pcRecords)
+{
+    HOSTCHLOG(("HostChannel: SendBatch: (%d) handle %d, %d bytes\n", pClient->u32ClientID, u32Handle, cbData));
+
+    *pcRecords = 0;
+
+    /* Validate all records first, so the provider gets either all or none of them. */
+    const uint8_t *pu8Data = (const uint8_t *)pvData;
+    uint32_t cRecords = 0;
+    uint32_t off = 0;
+    while (off < cbData)
+    {
+        if (cbData - off < sizeof(VBOXHOSTCHANNELRECORD))
+            return VERR_INVALID_PARAMETER;
+        const VBOXHOSTCHANNELRECORD *pRecord = (const VBOXHOSTCHANNELRECORD *)&pu8Data[off];
+        if (pRecord->cbData > cbData - off - sizeof(VBOXHOSTCHANNELRECORD))
+            return VERR_INVALID_PARAMETER;
+        off += RT_MIN(VBOX_HOST_CHANNEL_RECORD_SIZE(pRecord->cbData), cbData - off);
+        cRecords++;
+    }
+
+    int rc = VINF_SUCCESS;
+
+    VBOXHOSTCHINSTANCE *pInstance = vhcInstanceFind(pClient, u32Handle);
+
+    if (pInstance)
+    {
+        if (pInstance->pProvider)
+        {
+            for (off = 0; off < cbData; )
+            {
+                const VBOXHOSTCHANNELRECORD *pRecord = (const VBOXHOSTCHANNELRECORD *)&pu8Data[off];
+                pInstance->pProvider->iface.HostChannelSend(pInstance->pvChannel, &pRecord[1], pRecord->cbData);
+                off += RT_MIN(VBOX_HOST_CHANNEL_RECORD_SIZE(pRecord->cbData), cbData - off);
+            }
+            *pcRecords = cRecords;
+        }
+
+        vhcInstanceRelease(pInstance);
+    }
+    else
+    {
+        rc = VERR_NOT_SUPPORTED;
+    }
+
+    return rc;
+}
+
 int vboxHostChannelRecv(VBOXHOSTCHCLIENT *pClient,
                         uint32_t u32Handle,
                         void *pvData,
@@ -906,6 +958,29 @@ static DECLCALLBACK(void) HostChannelCallbackEvent(void *pvCallbacks, void *pvCh
     }
     else
     {
+        /* A RECV event only carries the amount of data available, so if the guest has not
+         * fetched the previous one for this channel yet, just update it.  This way a burst
+         * of data wakes up the guest once instead of once per chunk.
+         */
+        if (u32Id == VBOX_HOST_CHANNEL_EVENT_RECV)
+        {
+            VBOXHOSTCHANNELEVENT *pIterEvent;
+            RTListForEach(&pClient->listEvents, pIterEvent, VBOXHOSTCHANNELEVENT, NodeEvent)
+            {
+                if (   pIterEvent->u32ChannelHandle == u32ChannelHandle
+                    && pIterEvent->u32Id == u32Id
+                    && pIterEvent->cbEvent == cbEvent)
+                {
+                    if (cbEvent)
+                        memcpy(pIterEvent->pvEvent, pvEvent, cbEvent);
+
+                    vboxHostChannelUnlock();
+                    vhcInstanceRelease(pInstance);
+                    return;
+                }
+            }
+        }
+
         /* Put it to the queue. */
         VBOXHOSTCHANNELEVENT *pEvent = (VBOXHOSTCHANNELEVENT *)RTMemAlloc(sizeof(VBOXHOSTCHANNELEVENT) + cbEvent);
 
@@ -95,6 +95,11 @@ int vboxHostChannelSend(VBOXHOSTCHCLIENT *pClient,
                         uint32_t u32Handle,
                         const void *pvData,
                         uint32_t cbData);
+int vboxHostChannelSendBatch(VBOXHOSTCHCLIENT *pClient,
+                             uint32_t u32Handle,
+                             const void *pvData,
+                             uint32_t cbData,
+                             uint32_t *pcRecords);
 int vboxHostChannelRecv(VBOXHOSTCHCLIENT *pClient,
                         uint32_t u32Handle,
                         void *pvData,
@@ -332,6 +332,44 @@ static DECLCALLBACK(void) svcCall(void *pvService,
             }
         } break;
 
+        case VBOX_HOST_CHANNEL_FN_SEND_BATCH:
+        {
+            LogRel2(("svcCall: VBOX_HOST_CHANNEL_FN_SEND_BATCH\n"));
+
+            if (cParms != 3)
+            {
+                rc = VERR_INVALID_PARAMETER;
+            }
+            else if (   paParms[0].type != VBOX_HGCM_SVC_PARM_32BIT   /* handle */
+                     || paParms[1].type != VBOX_HGCM_SVC_PARM_PTR     /* data */
+                     || paParms[2].type != VBOX_HGCM_SVC_PARM_32BIT   /* cRecords */
+                    )
+            {
+                rc = VERR_INVALID_PARAMETER;
+            }
+            else
+            {
+                uint32_t u32Handle;
+                void *pvData;
+                uint32_t cbData;
+
+                rc = VBoxHGCMParmUInt32Get(&paParms[0], &u32Handle);
+
+                if (RT_SUCCESS(rc))
+                {
+                    rc = VBoxHGCMParmPtrGet(&paParms[1], &pvData, &cbData);
+
+                    if (RT_SUCCESS(rc))
+                    {
+                        uint32_t cRecords = 0;
+                        rc = vboxHostChannelSendBatch(pClient, u32Handle, pvData, cbData, &cRecords);
+                        if (RT_SUCCESS(rc))
+                            VBoxHGCMParmUInt32Set(&paParms[2], cRecords);
+                    }
+                }
+            }
+        } break;
+
         case VBOX_HOST_CHANNEL_FN_RECV:
         {
             LogRel2(("svcCall: VBOX_HOST_CHANNEL_FN_RECV\n"));
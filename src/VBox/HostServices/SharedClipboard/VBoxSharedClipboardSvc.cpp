@@ -222,6 +222,7 @@
 #include <VBox/VMMDev.h>
 #include <VBox/vmm/ssm.h>
 
+#include <iprt/asm.h>
 #include <iprt/mem.h>
 #include <iprt/string.h>
 #include <iprt/assert.h>
@@ -296,6 +297,7 @@ ClipboardClientQueue g_listClientsDeferred;
 /** Host feature mask (VBOX_SHCL_HF_0_XXX) for VBOX_SHCL_GUEST_FN_REPORT_FEATURES
  * and VBOX_SHCL_GUEST_FN_QUERY_FEATURES. */
 static uint64_t const g_fHostFeatures0 = VBOX_SHCL_HF_0_CONTEXT_ID
+                                       | VBOX_SHCL_HF_0_DATA_CHUNKS
 #ifdef VBOX_WITH_SHARED_CLIPBOARD_TRANSFERS
                                        | VBOX_SHCL_HF_0_TRANSFERS
 #endif
@@ -309,6 +311,8 @@ static void shClSvcClientReset(PSHCLCLIENT pClient);
 static void shClSvcClientDestroy(PSHCLCLIENT pClient);
 
 static void shClSvcClientMsgQueueReset(PSHCLCLIENT pClient);
+static void shClSvcClientChunksReadReset(PSHCLCLIENT pClient);
+static void shClSvcClientChunksWriteReset(PSHCLCLIENT pClient);
 static int  shClSvcClientMsgAddAndWakeupClient(PSHCLCLIENT pClient, PSHCLCLIENTMSG pMsg);
 
 static int  shClSvcClientStateInit(PSHCLCLIENTSTATE pState, uint32_t uClientID);
@@ -603,6 +607,8 @@ int ShClSvcClientInit(PSHCLCLIENT pClient, uint32_t uClientID)
     RTListInit(&pClient->Legacy.lstCID);
     pClient->Legacy.cCID = 0;
 
+    RT_ZERO(pClient->Chunks);
+
     LogFlowFunc(("[Client %RU32]\n", pClient->State.uClientID));
 
     int rc = RTCritSectInit(&pClient->CritSect);
@@ -666,6 +672,9 @@ static void shClSvcClientDestroy(PSHCLCLIENT pClient)
     ShClEventSourceDestroy(&pClient->EventSrc);
     shClSvcClientStateDestroy(&pClient->State);
 
+    shClSvcClientChunksReadReset(pClient);
+    shClSvcClientChunksWriteReset(pClient);
+
     ShClSvcClientUnlock(pClient);
 
     PSHCLCLIENTLEGACYCID pCidIter, pCidIterNext;
@@ -724,9 +733,41 @@ static void shClSvcClientReset(PSHCLCLIENT pClient)
 
     shclSvcClientStateReset(&pClient->State);
 
+    shClSvcClientChunksReadReset(pClient);
+    shClSvcClientChunksWriteReset(pClient);
+
     RTCritSectLeave(&pClient->CritSect);
 }
 
+/**
+ * Drops the host clipboard data copy of a chunked guest read, if any.
+ *
+ * @param   pClient             Client to drop the data for.
+ */
+static void shClSvcClientChunksReadReset(PSHCLCLIENT pClient)
+{
+    RTMemFree(pClient->Chunks.pvRead);
+    pClient->Chunks.pvRead      = NULL;
+    pClient->Chunks.cbRead      = 0;
+    pClient->Chunks.offRead     = 0;
+    pClient->Chunks.uReadFormat = VBOX_SHCL_FMT_NONE;
+}
+
+/**
+ * Drops the guest clipboard data collected by a chunked guest write, if any.
+ *
+ * @param   pClient             Client to drop the data for.
+ */
+static void shClSvcClientChunksWriteReset(PSHCLCLIENT pClient)
+{
+    RTMemFree(pClient->Chunks.pvWrite);
+    pClient->Chunks.pvWrite        = NULL;
+    pClient->Chunks.cbWrite        = 0;
+    pClient->Chunks.cbWriteAlloc   = 0;
+    pClient->Chunks.uWriteFormat   = VBOX_SHCL_FMT_NONE;
+    pClient->Chunks.idWriteContext = 0;
+}
+
 static int shClSvcClientNegogiateChunkSize(PSHCLCLIENT pClient, VBOXHGCMCALLHANDLE hCall,
                                            uint32_t cParms, VBOXHGCMSVCPARM paParms[])
 {
@@ -1601,6 +1642,9 @@ int ShClSvcReportFormats(PSHCLCLIENT pClient, SHCLFORMATS fFormats)
 
     fFormats = shClSvcHandleFormats(true /* fHostToGuest */, pClient, fFormats);
 
+    /* Whatever the guest is reading in chunks is stale now. */
+    ASMAtomicIncU32(&pClient->Chunks.idHostFormatsGen);
+
     int rc;
 
     /*
@@ -1745,6 +1789,79 @@ static int shClSvcClientMsgReportFormats(PSHCLCLIENT pClient, uint32_t cParms, V
     return rc;
 }
 
+/**
+ * Reads host clipboard data on behalf of a guest, asking the service extension
+ * first (if any) and the backend second.
+ *
+ * @returns VBox status code.
+ * @param   pClient             Client that wants to read host clipboard data.
+ * @param   pCmdCtx             Client command context.
+ * @param   uFormat             Clipboard format to read.
+ * @param   pvData              Where to put the data.
+ * @param   cbData              Size of the buffer at @a pvData.
+ * @param   pcbActual           Where to return the size of the data, which may
+ *                              be larger than @a cbData.
+ *
+ * @note    Caller must own g_CritSect.
+ */
+static int shClSvcReadHostData(PSHCLCLIENT pClient, PSHCLCLIENTCMDCTX pCmdCtx, SHCLFORMAT uFormat,
+                               void *pvData, uint32_t cbData, uint32_t *pcbActual)
+{
+    Assert(RTCritSectIsOwner(&g_CritSect));
+    uint32_t cbActual = 0;
+    int rc;
+
+    /* If there is a service extension active, try reading data from it first. */
+    if (g_ExtState.pfnExtension)
+    {
+        SHCLEXTPARMS parms;
+        RT_ZERO(parms);
+
+        parms.u.ReadWriteData.uFormat = uFormat;
+        parms.u.ReadWriteData.pvData  = pvData;
+        parms.u.ReadWriteData.cbData  = cbData;
+
+        g_ExtState.fReadingData = true;
+
+        /* Read clipboard data from the extension. */
+        rc = g_ExtState.pfnExtension(g_ExtState.pvExtension, VBOX_CLIPBOARD_EXT_FN_DATA_READ, &parms, sizeof(parms));
+
+        LogRel2(("Shared Clipboard: Read extension clipboard data (fDelayedAnnouncement=%RTbool, fDelayedFormats=%#x, max %RU32 bytes), got %RU32 bytes: rc=%Rrc\n",
+                 g_ExtState.fDelayedAnnouncement, g_ExtState.fDelayedFormats, cbData, parms.u.ReadWriteData.cbData, rc));
+
+        /* Did the extension send the clipboard formats yet?
+         * Otherwise, do this now. */
+        if (g_ExtState.fDelayedAnnouncement)
+        {
+            int rc2 = ShClSvcReportFormats(pClient, g_ExtState.fDelayedFormats);
+            AssertRC(rc2);
+
+            g_ExtState.fDelayedAnnouncement = false;
+            g_ExtState.fDelayedFormats = 0;
+        }
+
+        g_ExtState.fReadingData = false;
+
+        if (RT_SUCCESS(rc))
+            cbActual = parms.u.ReadWriteData.cbData;
+    }
+    else
+        rc = VERR_NOT_SUPPORTED;
+
+    /* Try reading from the backend if the extension above didn't handle the read. */
+    if (rc == VERR_NOT_SUPPORTED)
+    {
+        rc = ShClBackendReadData(&g_ShClBackend, pClient, pCmdCtx, uFormat, pvData, cbData, &cbActual);
+        if (RT_SUCCESS(rc))
+            LogRel2(("Shared Clipboard: Read host clipboard data (max %RU32 bytes), got %RU32 bytes\n", cbData, cbActual));
+        else
+            LogRel(("Shared Clipboard: Reading host clipboard data failed with %Rrc\n", rc));
+    }
+
+    *pcbActual = cbActual;
+    return rc;
+}
+
 /**
  * Implements VBOX_SHCL_GUEST_FN_DATA_READ.
  *
@@ -1849,7 +1966,46 @@ static int shClSvcClientMsgDataRead(PSHCLCLIENT pClient, uint32_t cParms, VBOXHG
     int rc = RTCritSectEnter(&g_CritSect);
     AssertRCReturn(rc, rc);
 
-    /* If there is a service extension active, try reading data from it first. */
+    rc = shClSvcReadHostData(pClient, &cmdCtx, uFormat, pvData, cbData, &cbActual);
+
+    if (RT_SUCCESS(rc))
+    {
+        /* Return the actual size required to fullfil the request. */
+        if (cParms != VBOX_SHCL_CPARMS_DATA_READ_61B)
+            HGCMSvcSetU32(&paParms[2], cbActual);
+        else
+            HGCMSvcSetU32(&paParms[3], cbActual);
+
+        /* If the data to return exceeds the buffer the guest supplies, tell it (and let it try again). */
+        if (cbActual >= cbData)
+            rc = VINF_BUFFER_OVERFLOW;
+    }
+
+    RTCritSectLeave(&g_CritSect);
+
+    LogFlowFuncLeaveRC(rc);
+    return rc;
+}
+
+/**
+ * Hands complete guest clipboard data to the service extension (if any) or
+ * the backend and completes the host side request waiting for it.
+ *
+ * @returns VBox status code.
+ * @param   pClient             Client the data comes from.
+ * @param   pCmdCtx             Client command context (with the request's context ID).
+ * @param   uFormat             Clipboard format of the data.
+ * @param   pvData              The data.  Can be NULL if @a cbData is zero.
+ * @param   cbData              Size of the data.
+ *
+ * @note    Caller must own g_CritSect.
+ */
+static int shClSvcWriteGuestData(PSHCLCLIENT pClient, PSHCLCLIENTCMDCTX pCmdCtx, SHCLFORMAT uFormat,
+                                 void *pvData, uint32_t cbData)
+{
+    Assert(RTCritSectIsOwner(&g_CritSect));
+    int rc;
+
     if (g_ExtState.pfnExtension)
     {
         SHCLEXTPARMS parms;
@@ -1859,59 +2015,25 @@ static int shClSvcClientMsgDataRead(PSHCLCLIENT pClient, uint32_t cParms, VBOXHG
         parms.u.ReadWriteData.pvData  = pvData;
         parms.u.ReadWriteData.cbData  = cbData;
 
-        g_ExtState.fReadingData = true;
-
-        /* Read clipboard data from the extension. */
-        rc = g_ExtState.pfnExtension(g_ExtState.pvExtension, VBOX_CLIPBOARD_EXT_FN_DATA_READ, &parms, sizeof(parms));
-
-        LogRel2(("Shared Clipboard: Read extension clipboard data (fDelayedAnnouncement=%RTbool, fDelayedFormats=%#x, max %RU32 bytes), got %RU32 bytes: rc=%Rrc\n",
-                 g_ExtState.fDelayedAnnouncement, g_ExtState.fDelayedFormats, cbData, parms.u.ReadWriteData.cbData, rc));
-
-        /* Did the extension send the clipboard formats yet?
-         * Otherwise, do this now. */
-        if (g_ExtState.fDelayedAnnouncement)
-        {
-            int rc2 = ShClSvcReportFormats(pClient, g_ExtState.fDelayedFormats);
-            AssertRC(rc2);
-
-            g_ExtState.fDelayedAnnouncement = false;
-            g_ExtState.fDelayedFormats = 0;
-        }
-
-        g_ExtState.fReadingData = false;
-
-        if (RT_SUCCESS(rc))
-            cbActual = parms.u.ReadWriteData.cbData;
+        rc = g_ExtState.pfnExtension(g_ExtState.pvExtension, VBOX_CLIPBOARD_EXT_FN_DATA_WRITE, &parms, sizeof(parms));
     }
     else
         rc = VERR_NOT_SUPPORTED;
 
-    /* Try reading from the backend if the extension above didn't handle the read. */
+    /* Let the backend implementation know if the extension above didn't handle the write. */
     if (rc == VERR_NOT_SUPPORTED)
     {
-        rc = ShClBackendReadData(&g_ShClBackend, pClient, &cmdCtx, uFormat, pvData, cbData, &cbActual);
-        if (RT_SUCCESS(rc))
-            LogRel2(("Shared Clipboard: Read host clipboard data (max %RU32 bytes), got %RU32 bytes\n", cbData, cbActual));
-        else
-            LogRel(("Shared Clipboard: Reading host clipboard data failed with %Rrc\n", rc));
-    }
-
-    if (RT_SUCCESS(rc))
-    {
-        /* Return the actual size required to fullfil the request. */
-        if (cParms != VBOX_SHCL_CPARMS_DATA_READ_61B)
-            HGCMSvcSetU32(&paParms[2], cbActual);
-        else
-            HGCMSvcSetU32(&paParms[3], cbActual);
+        rc = ShClBackendWriteData(&g_ShClBackend, pClient, pCmdCtx, uFormat, pvData, cbData);
+        if (RT_FAILURE(rc))
+            LogRel(("Shared Clipboard: Writing guest clipboard data to the host failed with %Rrc\n", rc));
 
-        /* If the data to return exceeds the buffer the guest supplies, tell it (and let it try again). */
-        if (cbActual >= cbData)
-            rc = VINF_BUFFER_OVERFLOW;
+        int rc2; /* Don't return internals back to the guest. */
+        rc2 = ShClSvcGuestDataSignal(pClient, pCmdCtx, uFormat, pvData, cbData); /* To complete pending events, if any. */
+        if (RT_FAILURE(rc2))
+            LogRel(("Shared Clipboard: Signalling host about guest clipboard data failed with %Rrc\n", rc2));
+        AssertRC(rc2);
     }
 
-    RTCritSectLeave(&g_CritSect);
-
-    LogFlowFuncLeaveRC(rc);
     return rc;
 }
 
@@ -2051,32 +2173,278 @@ static int shClSvcClientMsgDataWrite(PSHCLCLIENT pClient, uint32_t cParms, VBOXH
     int rc = RTCritSectEnter(&g_CritSect);
     AssertRCReturn(rc, rc);
 
-    if (g_ExtState.pfnExtension)
+    rc = shClSvcWriteGuestData(pClient, &cmdCtx, uFormat, pvData, cbData);
+
+    RTCritSectLeave(&g_CritSect);
+
+    LogFlowFuncLeaveRC(rc);
+    return rc;
+}
+
+/**
+ * Implements VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK.
+ *
+ * Called when the guest wants to read host clipboard data in chunks.  The
+ * host clipboard is only read when the guest asks for offset zero; if the
+ * data fits into the guest's buffer it goes there directly, otherwise a copy
+ * is kept here and handed out chunk by chunk.
+ *
+ * @returns VBox status code.
+ * @param   pClient             Client that wants to read host clipboard data.
+ * @param   cParms              Number of HGCM parameters supplied in \a paParms.
+ * @param   paParms             Array of HGCM parameters.
+ */
+static int shClSvcClientMsgDataReadChunk(PSHCLCLIENT pClient, uint32_t cParms, VBOXHGCMSVCPARM paParms[])
+{
+    LogFlowFuncEnter();
+
+    uint32_t uMode = ShClSvcGetMode();
+    if (   uMode == VBOX_SHCL_MODE_BIDIRECTIONAL
+        || uMode == VBOX_SHCL_MODE_HOST_TO_GUEST)
+    { /* likely */ }
+    else
+        return VERR_ACCESS_DENIED;
+
+    /*
+     * Digest parameters.
+     */
+    ASSERT_GUEST_RETURN(cParms == VBOX_SHCL_CPARMS_DATA_READ_CHUNK, VERR_WRONG_PARAMETER_COUNT);
+    ASSERT_GUEST_RETURN(paParms[0].type == VBOX_HGCM_SVC_PARM_32BIT, VERR_WRONG_PARAMETER_TYPE); /* Format */
+    ASSERT_GUEST_RETURN(paParms[1].type == VBOX_HGCM_SVC_PARM_64BIT, VERR_WRONG_PARAMETER_TYPE); /* Offset */
+    ASSERT_GUEST_RETURN(paParms[2].type == VBOX_HGCM_SVC_PARM_PTR,   VERR_WRONG_PARAMETER_TYPE); /* Data buffer */
+    ASSERT_GUEST_RETURN(paParms[3].type == VBOX_HGCM_SVC_PARM_32BIT, VERR_WRONG_PARAMETER_TYPE); /* cbRead */
+    ASSERT_GUEST_RETURN(paParms[4].type == VBOX_HGCM_SVC_PARM_32BIT, VERR_WRONG_PARAMETER_TYPE); /* cbTotal */
+
+    SHCLFORMAT const uFormat = paParms[0].u.uint32;
+    uint64_t const   offRead = paParms[1].u.uint64;
+    void * const     pvData  = paParms[2].u.pointer.addr;
+    uint32_t const   cbData  = paParms[2].u.pointer.size;
+    ASSERT_GUEST_RETURN(cbData > 0, VERR_INVALID_PARAMETER);
+
+    SHCLCLIENTCMDCTX cmdCtx;
+    RT_ZERO(cmdCtx);
+
+    uint32_t cbChunk = 0;
+    uint32_t cbTotal = 0;
+
+    int rc = RTCritSectEnter(&g_CritSect);
+    AssertRCReturn(rc, rc);
+
+    if (offRead == 0)
     {
-        SHCLEXTPARMS parms;
-        RT_ZERO(parms);
+        /*
+         * Start of a new read: fetch the host clipboard data.  Try the guest
+         * buffer first, as most clipboard content is small.  The size can
+         * change between the probe and the real read, so allow a few rounds.
+         */
+        shClSvcClientChunksReadReset(pClient);
 
-        parms.u.ReadWriteData.uFormat = uFormat;
-        parms.u.ReadWriteData.pvData  = pvData;
-        parms.u.ReadWriteData.cbData  = cbData;
+        rc = shClSvcReadHostData(pClient, &cmdCtx, uFormat, pvData, cbData, &cbTotal);
+        if (RT_SUCCESS(rc) && cbTotal > cbData)
+        {
+            for (unsigned iTry = 0;; iTry++)
+            {
+                if (cbTotal > VBOX_SHCL_MAX_DATA_SIZE)
+                {
+                    LogRel(("Shared Clipboard: Host clipboard data too big (%RU32 bytes)\n", cbTotal));
+                    rc = VERR_TOO_MUCH_DATA;
+                    break;
+                }
+                void *pvNew = RTMemRealloc(pClient->Chunks.pvRead, cbTotal);
+                if (!pvNew)
+                {
+                    rc = VERR_NO_MEMORY;
+                    break;
+                }
+                pClient->Chunks.pvRead = pvNew;
+                pClient->Chunks.cbRead = cbTotal;
 
-        rc = g_ExtState.pfnExtension(g_ExtState.pvExtension, VBOX_CLIPBOARD_EXT_FN_DATA_WRITE, &parms, sizeof(parms));
+                rc = shClSvcReadHostData(pClient, &cmdCtx, uFormat, pvNew, pClient->Chunks.cbRead, &cbTotal);
+                if (RT_FAILURE(rc) || cbTotal <= pClient->Chunks.cbRead)
+                    break;
+                if (iTry >= 2)
+                {
+                    rc = VERR_BUFFER_OVERFLOW;
+                    break;
+                }
+            }
+
+            if (RT_SUCCESS(rc))
+            {
+                pClient->Chunks.cbRead      = cbTotal;
+                pClient->Chunks.uReadFormat = uFormat;
+                pClient->Chunks.idReadGen   = ASMAtomicReadU32(&pClient->Chunks.idHostFormatsGen);
+                cbChunk = RT_MIN(cbData, cbTotal);
+                memcpy(pvData, pClient->Chunks.pvRead, cbChunk);
+                pClient->Chunks.offRead = cbChunk;
+            }
+            else
+                shClSvcClientChunksReadReset(pClient);
+        }
+        else if (RT_SUCCESS(rc))
+            cbChunk = cbTotal; /* Everything went straight into the guest buffer. */
+    }
+    else if (   !pClient->Chunks.pvRead
+             || pClient->Chunks.uReadFormat != uFormat
+             || pClient->Chunks.offRead != offRead)
+    {
+        LogRel2(("Shared Clipboard: Chunked read of format %#x at offset %RU64 out of order\n", uFormat, offRead));
+        rc = VERR_WRONG_ORDER;
+    }
+    else if (pClient->Chunks.idReadGen != ASMAtomicReadU32(&pClient->Chunks.idHostFormatsGen))
+    {
+        LogRel2(("Shared Clipboard: Host clipboard changed during chunked read, restarting\n"));
+        shClSvcClientChunksReadReset(pClient);
+        rc = VERR_INVALID_STATE;
     }
     else
-        rc = VERR_NOT_SUPPORTED;
+    {
+        /*
+         * Continue the read from our copy.
+         */
+        cbTotal = pClient->Chunks.cbRead;
+        cbChunk = RT_MIN(cbData, cbTotal - pClient->Chunks.offRead);
+        memcpy(pvData, (uint8_t *)pClient->Chunks.pvRead + pClient->Chunks.offRead, cbChunk);
+        pClient->Chunks.offRead += cbChunk;
+    }
 
-    /* Let the backend implementation know if the extension above didn't handle the write. */
-    if (rc == VERR_NOT_SUPPORTED)
+    /* Release our copy as soon as the guest has got all of it. */
+    if (   RT_SUCCESS(rc)
+        && pClient->Chunks.pvRead
+        && pClient->Chunks.offRead >= pClient->Chunks.cbRead)
+        shClSvcClientChunksReadReset(pClient);
+
+    RTCritSectLeave(&g_CritSect);
+
+    if (RT_SUCCESS(rc))
     {
-        rc = ShClBackendWriteData(&g_ShClBackend, pClient, &cmdCtx, uFormat, pvData, cbData);
-        if (RT_FAILURE(rc))
-            LogRel(("Shared Clipboard: Writing guest clipboard data to the host failed with %Rrc\n", rc));
+        HGCMSvcSetU32(&paParms[3], cbChunk);
+        HGCMSvcSetU32(&paParms[4], cbTotal);
+        LogRel2(("Shared Clipboard: Guest read %RU32 bytes at offset %RU64 of %RU32 bytes host clipboard data (format %#x)\n",
+                 cbChunk, offRead, cbTotal, uFormat));
+    }
 
-        int rc2; /* Don't return internals back to the guest. */
-        rc2 = ShClSvcGuestDataSignal(pClient, &cmdCtx, uFormat, pvData, cbData); /* To complete pending events, if any. */
-        if (RT_FAILURE(rc2))
-            LogRel(("Shared Clipboard: Signalling host about guest clipboard data failed with %Rrc\n", rc2));
-        AssertRC(rc2);
+    LogFlowFuncLeaveRC(rc);
+    return rc;
+}
+
+/**
+ * Implements VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK.
+ *
+ * Called when the guest writes clipboard data to the host in chunks.  The
+ * chunks are collected until the last one arrives and then handed on like a
+ * VBOX_SHCL_GUEST_FN_DATA_WRITE.  Data sent as a single (last) chunk is passed
+ * on directly without copying.
+ *
+ * @returns VBox status code.
+ * @param   pClient             Client that writes guest clipboard data.
+ * @param   cParms              Number of HGCM parameters supplied in \a paParms.
+ * @param   paParms             Array of HGCM parameters.
+ */
+static int shClSvcClientMsgDataWriteChunk(PSHCLCLIENT pClient, uint32_t cParms, VBOXHGCMSVCPARM paParms[])
+{
+    LogFlowFuncEnter();
+
+    uint32_t uMode = ShClSvcGetMode();
+    if (   uMode == VBOX_SHCL_MODE_BIDIRECTIONAL
+        || uMode == VBOX_SHCL_MODE_GUEST_TO_HOST)
+    { /* likely */ }
+    else
+        return VERR_ACCESS_DENIED;
+
+    /*
+     * Digest parameters.
+     */
+    ASSERT_GUEST_RETURN(cParms == VBOX_SHCL_CPARMS_DATA_WRITE_CHUNK, VERR_WRONG_PARAMETER_COUNT);
+    ASSERT_GUEST_RETURN(paParms[0].type == VBOX_HGCM_SVC_PARM_64BIT, VERR_WRONG_PARAMETER_TYPE); /* Context ID */
+    ASSERT_GUEST_RETURN(paParms[1].type == VBOX_HGCM_SVC_PARM_32BIT, VERR_WRONG_PARAMETER_TYPE); /* Format */
+    ASSERT_GUEST_RETURN(paParms[2].type == VBOX_HGCM_SVC_PARM_64BIT, VERR_WRONG_PARAMETER_TYPE); /* Offset */
+    ASSERT_GUEST_RETURN(paParms[3].type == VBOX_HGCM_SVC_PARM_32BIT, VERR_WRONG_PARAMETER_TYPE); /* Flags */
+    ASSERT_GUEST_RETURN(paParms[4].type == VBOX_HGCM_SVC_PARM_PTR,   VERR_WRONG_PARAMETER_TYPE); /* Data buffer */
+
+    SHCLCLIENTCMDCTX cmdCtx;
+    RT_ZERO(cmdCtx);
+    cmdCtx.uContextID = paParms[0].u.uint64;
+    SHCLFORMAT const uFormat  = paParms[1].u.uint32;
+    uint64_t const   offChunk = paParms[2].u.uint64;
+    uint32_t const   fFlags   = paParms[3].u.uint32;
+    void * const     pvData   = paParms[4].u.pointer.addr;
+    uint32_t const   cbData   = paParms[4].u.pointer.size;
+    ASSERT_GUEST_RETURN(!(fFlags & ~VBOX_SHCL_DATA_CHUNK_F_VALID_MASK), VERR_INVALID_FLAGS);
+
+    uint64_t const idCtxExpected = VBOX_SHCL_CONTEXTID_MAKE(pClient->State.uSessionID, pClient->EventSrc.uID,
+                                                            VBOX_SHCL_CONTEXTID_GET_EVENT(cmdCtx.uContextID));
+    ASSERT_GUEST_MSG_RETURN(cmdCtx.uContextID == idCtxExpected,
+                            ("Wrong context ID: %#RX64, expected %#RX64\n", cmdCtx.uContextID, idCtxExpected),
+                            VERR_INVALID_CONTEXT);
+
+    int rc = RTCritSectEnter(&g_CritSect);
+    AssertRCReturn(rc, rc);
+
+    if (offChunk == 0)
+        shClSvcClientChunksWriteReset(pClient);
+    else if (   pClient->Chunks.idWriteContext != cmdCtx.uContextID
+             || pClient->Chunks.uWriteFormat   != uFormat
+             || pClient->Chunks.cbWrite        != offChunk)
+    {
+        LogRel2(("Shared Clipboard: Chunked write of format %#x at offset %RU64 out of order\n", uFormat, offChunk));
+        rc = VERR_WRONG_ORDER;
+    }
+
+    bool fHandedOn = false;
+    if (RT_SUCCESS(rc))
+    {
+        if (offChunk == 0 && (fFlags & VBOX_SHCL_DATA_CHUNK_F_LAST))
+        {
+            rc = shClSvcWriteGuestData(pClient, &cmdCtx, uFormat, pvData, cbData);
+            fHandedOn = true;
+        }
+        else if ((uint64_t)pClient->Chunks.cbWrite + cbData > VBOX_SHCL_MAX_DATA_SIZE)
+        {
+            LogRel(("Shared Clipboard: Guest clipboard data too big (more than %RU32 bytes)\n", pClient->Chunks.cbWrite + cbData));
+            rc = VERR_TOO_MUCH_DATA;
+        }
+        else
+        {
+            /* Grow the buffer geometrically to keep the number of reallocations down. */
+            uint32_t const cbNeeded = pClient->Chunks.cbWrite + cbData;
+            if (cbNeeded > pClient->Chunks.cbWriteAlloc)
+            {
+                uint32_t const cbAlloc = RT_MIN(RT_MAX(cbNeeded, pClient->Chunks.cbWriteAlloc * 2), VBOX_SHCL_MAX_DATA_SIZE);
+                void *pvNew = RTMemRealloc(pClient->Chunks.pvWrite, cbAlloc);
+                if (pvNew)
+                {
+                    pClient->Chunks.pvWrite      = pvNew;
+                    pClient->Chunks.cbWriteAlloc = cbAlloc;
+                }
+                else
+                    rc = VERR_NO_MEMORY;
+            }
+            if (RT_SUCCESS(rc))
+            {
+                if (cbData)
+                    memcpy((uint8_t *)pClient->Chunks.pvWrite + pClient->Chunks.cbWrite, pvData, cbData);
+                pClient->Chunks.cbWrite       += cbData;
+                pClient->Chunks.uWriteFormat   = uFormat;
+                pClient->Chunks.idWriteContext = cmdCtx.uContextID;
+
+                if (fFlags & VBOX_SHCL_DATA_CHUNK_F_LAST)
+                {
+                    LogRel2(("Shared Clipboard: Guest wrote %RU32 bytes clipboard data in format %#x to host in chunks\n",
+                             pClient->Chunks.cbWrite, uFormat));
+                    rc = shClSvcWriteGuestData(pClient, &cmdCtx, uFormat, pClient->Chunks.pvWrite, pClient->Chunks.cbWrite);
+                    fHandedOn = true;
+                    shClSvcClientChunksWriteReset(pClient);
+                }
+            }
+        }
+
+        /* Don't leave the host side waiting for data which will never come. */
+        if (RT_FAILURE(rc) && !fHandedOn)
+        {
+            shClSvcClientChunksWriteReset(pClient);
+            ShClSvcGuestDataSignal(pClient, &cmdCtx, uFormat, NULL, 0);
+        }
     }
 
     RTCritSectLeave(&g_CritSect);
@@ -2323,6 +2691,14 @@ static DECLCALLBACK(void) svcCall(void *,
             rc = shClSvcClientMsgDataWrite(pClient, cParms, paParms);
             break;
 
+        case VBOX_SHCL_GUEST_FN_DATA_READ_CHUNK:
+            rc = shClSvcClientMsgDataReadChunk(pClient, cParms, paParms);
+            break;
+
+        case VBOX_SHCL_GUEST_FN_DATA_WRITE_CHUNK:
+            rc = shClSvcClientMsgDataWriteChunk(pClient, cParms, paParms);
+            break;
+
         case VBOX_SHCL_GUEST_FN_ERROR:
         {
             int rcGuest;
@@ -53,6 +53,9 @@
 #define SHFL_SAVED_STATE_VERSION_PRE_ERROR_STYLE        4
 #define SHFL_SAVED_STATE_VERSION                        5
 
+/** Number of HGCM worker threads for SHFL_FN_READ and SHFL_FN_WRITE. */
+#define SHFL_WORKER_THREADS                             4
+
 
 /*********************************************************************************************************************************
 *   Global Variables                                                                                                             *
@@ -1662,6 +1665,20 @@ static DECLCALLBACK(void) svcCall(void *, VBOXHGCMCALLHANDLE callHandle, uint32_
     LogFlow(("\n"));        /* Add a new line to differentiate between calls more easily. */
 }
 
+/**
+ * @interface_method_impl{VBOXHGCMSVCFNTABLE,pfnIsParallelCall}
+ *
+ * Reads and writes only look up the handle (lock free) and do positional I/O
+ * on the host file, so they can run on the HGCM worker threads.  Closing a
+ * handle and everything else stays on the service thread, which HGCM never
+ * runs concurrently with the workers.
+ */
+static DECLCALLBACK(bool) svcIsParallelCall(void *, uint32_t u32Function)
+{
+    return u32Function == SHFL_FN_READ
+        || u32Function == SHFL_FN_WRITE;
+}
+
 /*
  * We differentiate between a function handler for the guest (svcCall) and one
  * for the host. The guest is not allowed to add or remove mappings for obvious
@@ -1893,6 +1910,11 @@ extern "C" DECLCALLBACK(DECLEXPORT(int)) VBoxHGCMSvcLoad(VBOXHGCMSVCFNTABLE *pta
             ptable->pfnNotify     = NULL;
             ptable->pvService     = NULL;
 
+            /* Let reads and writes run in parallel, a long read should not hold up the rest. */
+            ptable->cWorkerThreads    = SHFL_WORKER_THREADS;
+            ptable->fWorkerFlags      = 0;
+            ptable->pfnIsParallelCall = svcIsParallelCall;
+
             /* Init handle table */
             rc = vbsfInitHandleTable();
             AssertRC(rc);
@@ -36,11 +36,13 @@
 
 #include "mappings.h"
 #include "vbsfpath.h"
+#include <iprt/asm.h>
 #include <iprt/alloc.h>
 #include <iprt/assert.h>
 #include <iprt/list.h>
 #include <iprt/path.h>
 #include <iprt/string.h>
+#include <iprt/time.h>
 #include <VBox/AssertGuest.h>
 
 #ifdef UNITTEST
@@ -48,6 +50,45 @@
 #endif
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** How long a cached host path lookup stays valid, in milliseconds.
+ * There is no portable way of getting notified about changes made to the host
+ * directory behind our back, so this must stay short. */
+#define VBSF_ATTR_CACHE_TTL_MS          1000
+/** Max number of cached host path lookups per mapping before the cache is
+ * flushed. */
+#define VBSF_ATTR_CACHE_MAX_ENTRIES     4096
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * Cached result of a host path lookup (MAPPING::AttrCache entry).
+ */
+typedef struct VBSFATTRCACHEENTRY
+{
+    /** String space core, the key is szPath. */
+    RTSTRSPACECORE  Core;
+    /** RTTimeMilliTS value when the entry expires. */
+    uint64_t        msExpire;
+    /** MAPPING::uAttrCacheGen value when the entry was filled. */
+    uint32_t        uGen;
+    /** The RTPATH_F_XXX flags the lookup was made with. */
+    uint32_t        fFlags;
+    /** The RTPathQueryInfoEx status. */
+    int             rc;
+    /** The object info, only valid if rc is a success status. */
+    RTFSOBJINFO     ObjInfo;
+    /** The host path. */
+    char            szPath[RT_FLEXIBLE_ARRAY];
+} VBSFATTRCACHEENTRY;
+/** Pointer to a cached host path lookup. */
+typedef VBSFATTRCACHEENTRY *PVBSFATTRCACHEENTRY;
+
+
 /*********************************************************************************************************************************
 *   Global Variables                                                                                                             *
 *********************************************************************************************************************************/
@@ -91,6 +132,7 @@ static RTLISTANCHOR g_MappingsChangeWaiters;
  * We use this to limit the number of waiting calls the clients can make.  */
 static uint32_t     g_cMappingChangeWaiters = 0;
 static void vbsfMappingsWakeupAllWaiters(void);
+static void vbsfMappingsAttrCacheFlush(MAPPING *pFolderMapping);
 
 
 void vbsfMappingInit(void)
@@ -398,6 +440,9 @@ int vbsfMappingsAdd(const char *pszFolderName, PSHFLSTRING pMapName, bool fWrita
             g_FolderMapping[i].fPlaceholder    = fPlaceholder;
             g_FolderMapping[i].fLoadedRootId   = false;
             g_FolderMapping[i].enmSymlinkPolicy = enmSymlinkPolicy;
+            g_FolderMapping[i].AttrCache       = NULL;
+            g_FolderMapping[i].cAttrCacheEntries = 0;
+            g_FolderMapping[i].uAttrCacheGen   = 0;
 
             /* Check if the host file system is case sensitive */
             RTFSPROPERTIES prop;
@@ -456,6 +501,7 @@ int vbsfMappingsRemove(PSHFLSTRING pMapName)
                              g_FolderMapping[i].pszFolderName, g_FolderMapping[i].fPlaceholder ? " (again)" : ""));
                     g_FolderMapping[i].fMissing = true;
                     g_FolderMapping[i].fPlaceholder = true;
+                    vbsfMappingsAttrCacheFlush(&g_FolderMapping[i]);
                     vbsfMappingsWakeupAllWaiters();
                     rc = VINF_PERMISSION_DENIED;
                 }
@@ -466,6 +512,7 @@ int vbsfMappingsRemove(PSHFLSTRING pMapName)
                     Log(("vbsfMappingsRemove: mapping %ls removed\n", pMapName->String.utf16));
                     bool fSame = g_FolderMapping[i].pMapName == pMapName;
 
+                    vbsfMappingsAttrCacheFlush(&g_FolderMapping[i]);
                     RTStrFree(g_FolderMapping[i].pszFolderName);
                     RTMemFree(g_FolderMapping[i].pMapName);
                     RTMemFree(g_FolderMapping[i].pAutoMountPoint);
@@ -524,6 +571,112 @@ bool vbsfIsHostMappingCaseSensitive(SHFLROOT root)
     return pFolderMapping->fHostCaseSensitive;
 }
 
+/**
+ * @callback_method_impl{FNRTSTRSPACECALLBACK, Frees a VBSFATTRCACHEENTRY.}
+ */
+static DECLCALLBACK(int) vbsfMappingsAttrCacheFreeEntry(PRTSTRSPACECORE pStr, void *pvUser)
+{
+    RT_NOREF(pvUser);
+    RTMemFree(RT_FROM_MEMBER(pStr, VBSFATTRCACHEENTRY, Core));
+    return VINF_SUCCESS;
+}
+
+/**
+ * Drops all cached host path lookups of a mapping.
+ */
+static void vbsfMappingsAttrCacheFlush(MAPPING *pFolderMapping)
+{
+    RTStrSpaceDestroy(&pFolderMapping->AttrCache, vbsfMappingsAttrCacheFreeEntry, NULL);
+    pFolderMapping->cAttrCacheEntries = 0;
+    pFolderMapping->uAttrCacheGen++;
+}
+
+/**
+ * Queries information about a host path inside a mapping, using the lookup
+ * cache of the mapping.
+ *
+ * Successful lookups as well as file and path not found results are cached
+ * for VBSF_ATTR_CACHE_TTL_MS, or until vbsfMappingsAttrCacheInvalidate is
+ * called for the mapping.  Other failures are not cached.
+ *
+ * @returns The RTPathQueryInfoEx status code.
+ * @param   root        The root handle of the mapping @a pszPath is in.
+ * @param   pszPath     The full host path.
+ * @param   fFlags      RTPATH_F_ON_LINK or RTPATH_F_FOLLOW_LINK.
+ * @param   pObjInfo    Where to return the information.
+ */
+int vbsfMappingsAttrCacheQuery(SHFLROOT root, const char *pszPath, uint32_t fFlags, PRTFSOBJINFO pObjInfo)
+{
+    MAPPING *pFolderMapping = vbsfMappingGetByRoot(root);
+    if (!pFolderMapping)
+        return RTPathQueryInfoEx(pszPath, pObjInfo, RTFSOBJATTRADD_NOTHING, fFlags);
+
+    uint64_t const      msNow  = RTTimeMilliTS();
+    PVBSFATTRCACHEENTRY pEntry = (PVBSFATTRCACHEENTRY)RTStrSpaceGet(&pFolderMapping->AttrCache, pszPath);
+    if (   pEntry
+        && pEntry->uGen   == pFolderMapping->uAttrCacheGen
+        && pEntry->fFlags == fFlags
+        && pEntry->msExpire > msNow)
+    {
+        *pObjInfo = pEntry->ObjInfo;
+        return pEntry->rc;
+    }
+
+    int rc = RTPathQueryInfoEx(pszPath, pObjInfo, RTFSOBJATTRADD_NOTHING, fFlags);
+    if (   RT_SUCCESS(rc)
+        || rc == VERR_FILE_NOT_FOUND
+        || rc == VERR_PATH_NOT_FOUND)
+    {
+        if (!pEntry)
+        {
+            if (pFolderMapping->cAttrCacheEntries >= VBSF_ATTR_CACHE_MAX_ENTRIES)
+                vbsfMappingsAttrCacheFlush(pFolderMapping);
+
+            size_t const cchPath = strlen(pszPath);
+            pEntry = (PVBSFATTRCACHEENTRY)RTMemAlloc(RT_UOFFSETOF_DYN(VBSFATTRCACHEENTRY, szPath[cchPath + 1]));
+            if (pEntry)
+            {
+                memcpy(pEntry->szPath, pszPath, cchPath + 1);
+                pEntry->Core.pszString = pEntry->szPath;
+                pEntry->Core.cchString = cchPath;
+                if (RTStrSpaceInsert(&pFolderMapping->AttrCache, &pEntry->Core))
+                    pFolderMapping->cAttrCacheEntries++;
+                else
+                {
+                    RTMemFree(pEntry);
+                    pEntry = NULL;
+                }
+            }
+        }
+        if (pEntry)
+        {
+            pEntry->msExpire = msNow + VBSF_ATTR_CACHE_TTL_MS;
+            pEntry->uGen     = pFolderMapping->uAttrCacheGen;
+            pEntry->fFlags   = fFlags;
+            pEntry->rc       = rc;
+            if (RT_SUCCESS(rc))
+                pEntry->ObjInfo = *pObjInfo;
+            else
+                RT_ZERO(pEntry->ObjInfo);
+        }
+    }
+    return rc;
+}
+
+/**
+ * Invalidates all cached host path lookups of a mapping.
+ *
+ * Must be called whenever the guest changes anything in the mapping.
+ *
+ * @param   root        The root handle of the mapping.
+ */
+void vbsfMappingsAttrCacheInvalidate(SHFLROOT root)
+{
+    MAPPING *pFolderMapping = vbsfMappingGetByRoot(root);
+    if (pFolderMapping)
+        ASMAtomicIncU32(&pFolderMapping->uAttrCacheGen); /* writes may run on several HGCM workers */
+}
+
 #ifdef UNITTEST
 /** Unit test the SHFL_FN_QUERY_MAPPINGS API.  Located here as a form of API
  * documentation (or should it better be inline in include/VBox/shflsvc.h?) */
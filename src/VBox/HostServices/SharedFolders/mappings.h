@@ -52,6 +52,9 @@ typedef struct
                                              still has. fMissing is always true for this mapping. */
     bool        fLoadedRootId;          /**< Set if vbsfMappingLoaded has found this mapping already. */
     SymlinkPolicy_T enmSymlinkPolicy;   /**< Symbolic link creation policy within the guest. */
+    RTSTRSPACE  AttrCache;              /**< Cached host path lookups, see vbsfMappingsAttrCacheQuery. */
+    uint32_t    cAttrCacheEntries;      /**< Number of entries in AttrCache. */
+    uint32_t    uAttrCacheGen;          /**< Incremented to invalidate all entries in AttrCache. */
 } MAPPING;
 /** Pointer to a MAPPING structure. */
 typedef MAPPING *PMAPPING;
@@ -86,6 +89,9 @@ int vbsfMappingsQueryHostRootEx(SHFLROOT hRoot, const char **ppszRoot, uint32_t
 bool vbsfIsGuestMappingCaseSensitive(SHFLROOT root);
 bool vbsfIsHostMappingCaseSensitive(SHFLROOT root);
 
+int  vbsfMappingsAttrCacheQuery(SHFLROOT root, const char *pszPath, uint32_t fFlags, PRTFSOBJINFO pObjInfo);
+void vbsfMappingsAttrCacheInvalidate(SHFLROOT root);
+
 void vbsfMappingLoadingStart(void);
 int  vbsfMappingLoaded(MAPPING const *pLoadedMapping, SHFLROOT root);
 void vbsfMappingLoadingDone(void);
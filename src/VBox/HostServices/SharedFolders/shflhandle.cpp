@@ -36,18 +36,39 @@
 #include <iprt/critsect.h>
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Makes a handle value from a table index and a slot generation. */
+#define SHFLHANDLE_MAKE(a_idx, a_uGen)  (((SHFLHANDLE)(a_uGen) << 32) | (a_idx))
+/** Gets the table index part of a handle value. */
+#define SHFLHANDLE_IDX(a_hHandle)       ((uint32_t)(a_hHandle))
+/** Gets the slot generation part of a handle value. */
+#define SHFLHANDLE_GEN(a_hHandle)       ((uint32_t)((a_hHandle) >> 32))
+/** End of the free slot list. */
+#define SHFLHANDLE_IDX_NIL              UINT32_MAX
+
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
 /**
  * Very basic and primitive handle management. Should be sufficient for our needs.
- * Handle allocation can be rather slow, but at least lookup is fast.
+ *
+ * The handle value carries the slot generation in the upper 32 bits, so a
+ * handle which has been closed is rejected even after its slot got reused.
+ * Free slots are kept on a FIFO list, which makes allocation O(1) and delays
+ * slot reuse.  Lookups do not take the lock.
  */
 typedef struct
 {
     uint32_t         uFlags;
+    /** The slot generation, incremented every time the slot is freed. */
+    uint32_t         uGen;
     uintptr_t        pvUserData;
     PSHFLCLIENTDATA  pClient;
+    /** The next free slot index while on the free list, SHFLHANDLE_IDX_NIL if last. */
+    uint32_t         idxNextFree;
 } SHFLINTHANDLE, *PSHFLINTHANDLE;
 
 
@@ -55,7 +76,10 @@ typedef struct
 *   Global Variables                                                                                                             *
 *********************************************************************************************************************************/
 static SHFLINTHANDLE *g_pHandles = NULL;
-static int32_t        gLastHandleIndex = 0;
+/** Head of the free slot list (oldest free slot), protected by gLock. */
+static uint32_t       g_idxFreeHead = SHFLHANDLE_IDX_NIL;
+/** Tail of the free slot list (most recently freed slot), protected by gLock. */
+static uint32_t       g_idxFreeTail = SHFLHANDLE_IDX_NIL;
 static RTCRITSECT     gLock;
 
 
@@ -70,7 +94,11 @@ int vbsfInitHandleTable()
 
     /* Never return handle 0 */
     g_pHandles[0].uFlags = SHFL_HF_TYPE_DONTUSE;
-    gLastHandleIndex     = 1;
+
+    for (uint32_t idx = 1; idx < SHFLHANDLE_MAX; idx++)
+        g_pHandles[idx].idxNextFree = idx + 1 < SHFLHANDLE_MAX ? idx + 1 : SHFLHANDLE_IDX_NIL;
+    g_idxFreeHead = 1;
+    g_idxFreeTail = SHFLHANDLE_MAX - 1;
 
     return RTCritSectInit(&gLock);
 }
@@ -81,6 +109,8 @@ int vbsfFreeHandleTable()
         RTMemFree(g_pHandles);
 
     g_pHandles = NULL;
+    g_idxFreeHead = SHFLHANDLE_IDX_NIL;
+    g_idxFreeTail = SHFLHANDLE_IDX_NIL;
 
     if (RTCritSectIsInitialized(&gLock))
         RTCritSectDelete(&gLock);
@@ -91,82 +121,91 @@ int vbsfFreeHandleTable()
 SHFLHANDLE  vbsfAllocHandle(PSHFLCLIENTDATA pClient, uint32_t uType,
                             uintptr_t pvUserData)
 {
-    SHFLHANDLE handle;
-
     Assert((uType & SHFL_HF_TYPE_MASK) != 0 && pvUserData);
 
     RTCritSectEnter(&gLock);
 
-    /* Find next free handle */
-    if (gLastHandleIndex >= SHFLHANDLE_MAX-1)
-        gLastHandleIndex = 1;
-
-    /* Nice linear search */
-    for(handle=gLastHandleIndex;handle<SHFLHANDLE_MAX;handle++)
+    uint32_t const idx = g_idxFreeHead;
+    if (idx == SHFLHANDLE_IDX_NIL)
     {
-        if (g_pHandles[handle].pvUserData == 0)
-        {
-            gLastHandleIndex = handle;
-            break;
-        }
+        /* Out of handles */
+        RTCritSectLeave(&gLock);
+        AssertFailed();
+        return SHFL_HANDLE_NIL;
     }
 
-    if (handle == SHFLHANDLE_MAX)
-    {
-        /* Try once more from the start */
-        for(handle=1;handle<SHFLHANDLE_MAX;handle++)
-        {
-            if (g_pHandles[handle].pvUserData == 0)
-            {
-                gLastHandleIndex = handle;
-                break;
-            }
-        }
-        if (handle == SHFLHANDLE_MAX)
-        {
-            /* Out of handles */
-            RTCritSectLeave(&gLock);
-            AssertFailed();
-            return SHFL_HANDLE_NIL;
-        }
-    }
-    g_pHandles[handle].uFlags     = (uType & SHFL_HF_TYPE_MASK) | SHFL_HF_VALID;
-    g_pHandles[handle].pvUserData = pvUserData;
-    g_pHandles[handle].pClient    = pClient;
+    PSHFLINTHANDLE pIntHandle = &g_pHandles[idx];
+    g_idxFreeHead = pIntHandle->idxNextFree;
+    if (g_idxFreeHead == SHFLHANDLE_IDX_NIL)
+        g_idxFreeTail = SHFLHANDLE_IDX_NIL;
+
+    pIntHandle->idxNextFree = SHFLHANDLE_IDX_NIL;
+    pIntHandle->pvUserData  = pvUserData;
+    pIntHandle->pClient     = pClient;
+    pIntHandle->uFlags      = (uType & SHFL_HF_TYPE_MASK) | SHFL_HF_VALID;
 
-    gLastHandleIndex++;
+    SHFLHANDLE const handle = SHFLHANDLE_MAKE(idx, pIntHandle->uGen);
 
     RTCritSectLeave(&gLock);
 
     return handle;
 }
 
+/**
+ * Looks up the table entry of a valid handle owned by the given client.
+ *
+ * This does not take the lock, a client cannot free its handles while using
+ * them for another request.
+ */
+DECLINLINE(PSHFLINTHANDLE) vbsfLookupHandle(PSHFLCLIENTDATA pClient, SHFLHANDLE handle)
+{
+    uint32_t const idx = SHFLHANDLE_IDX(handle);
+    if (RT_LIKELY(idx < SHFLHANDLE_MAX))
+    {
+        PSHFLINTHANDLE pIntHandle = &g_pHandles[idx];
+        if (RT_LIKELY(   (pIntHandle->uFlags & SHFL_HF_VALID)
+                      && pIntHandle->uGen    == SHFLHANDLE_GEN(handle)
+                      && pIntHandle->pClient == pClient))
+            return pIntHandle;
+    }
+    return NULL;
+}
+
 static int vbsfFreeHandle(PSHFLCLIENTDATA pClient, SHFLHANDLE handle)
 {
-    if (   handle < SHFLHANDLE_MAX
-        && (g_pHandles[handle].uFlags & SHFL_HF_VALID)
-        && g_pHandles[handle].pClient == pClient)
+    RTCritSectEnter(&gLock);
+
+    PSHFLINTHANDLE pIntHandle = vbsfLookupHandle(pClient, handle);
+    if (pIntHandle)
     {
-        g_pHandles[handle].uFlags     = 0;
-        g_pHandles[handle].pvUserData = 0;
-        g_pHandles[handle].pClient    = 0;
-        return VINF_SUCCESS;
+        pIntHandle->uFlags      = 0;
+        pIntHandle->pvUserData  = 0;
+        pIntHandle->pClient     = 0;
+        pIntHandle->uGen++;
+
+        /* Append to the free list so the slot is reused as late as possible. */
+        uint32_t const idx = SHFLHANDLE_IDX(handle);
+        pIntHandle->idxNextFree = SHFLHANDLE_IDX_NIL;
+        if (g_idxFreeTail != SHFLHANDLE_IDX_NIL)
+            g_pHandles[g_idxFreeTail].idxNextFree = idx;
+        else
+            g_idxFreeHead = idx;
+        g_idxFreeTail = idx;
     }
-    return VERR_INVALID_HANDLE;
+
+    RTCritSectLeave(&gLock);
+    return pIntHandle ? VINF_SUCCESS : VERR_INVALID_HANDLE;
 }
 
 static uintptr_t vbsfQueryHandle(PSHFLCLIENTDATA pClient, SHFLHANDLE handle,
                                  uint32_t uType)
 {
-    if (   handle < SHFLHANDLE_MAX
-        && (g_pHandles[handle].uFlags & SHFL_HF_VALID)
-        && g_pHandles[handle].pClient == pClient)
-    {
-        Assert((uType & SHFL_HF_TYPE_MASK) != 0);
+    Assert((uType & SHFL_HF_TYPE_MASK) != 0);
 
-        if (g_pHandles[handle].uFlags & uType)
-            return g_pHandles[handle].pvUserData;
-    }
+    PSHFLINTHANDLE pIntHandle = vbsfLookupHandle(pClient, handle);
+    if (   pIntHandle
+        && (pIntHandle->uFlags & uType))
+        return pIntHandle->pvUserData;
     return 0;
 }
 
@@ -184,14 +223,26 @@ SHFLFILEHANDLE *vbsfQueryDirHandle(PSHFLCLIENTDATA pClient, SHFLHANDLE handle)
 
 uint32_t vbsfQueryHandleType(PSHFLCLIENTDATA pClient, SHFLHANDLE handle)
 {
-    if (   handle < SHFLHANDLE_MAX
-        && (g_pHandles[handle].uFlags & SHFL_HF_VALID)
-        && g_pHandles[handle].pClient == pClient)
-        return g_pHandles[handle].uFlags & SHFL_HF_TYPE_MASK;
+    PSHFLINTHANDLE pIntHandle = vbsfLookupHandle(pClient, handle);
+    if (pIntHandle)
+        return pIntHandle->uFlags & SHFL_HF_TYPE_MASK;
 
     return 0;
 }
 
+/**
+ * Gets the handle in the given table slot if it is valid and owned by the
+ * client, SHFL_HANDLE_NIL otherwise.  For enumerating all client handles.
+ */
+SHFLHANDLE vbsfQueryHandleAt(PSHFLCLIENTDATA pClient, uint32_t idx)
+{
+    if (   idx < SHFLHANDLE_MAX
+        && (g_pHandles[idx].uFlags & SHFL_HF_VALID)
+        && g_pHandles[idx].pClient == pClient)
+        return SHFLHANDLE_MAKE(idx, g_pHandles[idx].uGen);
+    return SHFL_HANDLE_NIL;
+}
+
 SHFLHANDLE vbsfAllocDirHandle(PSHFLCLIENTDATA pClient)
 {
     SHFLFILEHANDLE *pHandle = (SHFLFILEHANDLE *)RTMemAllocZ (sizeof (SHFLFILEHANDLE));
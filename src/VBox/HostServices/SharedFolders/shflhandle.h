@@ -87,5 +87,6 @@ SHFLFILEHANDLE *vbsfQueryFileHandle(PSHFLCLIENTDATA pClient,
 SHFLFILEHANDLE *vbsfQueryDirHandle(PSHFLCLIENTDATA pClient, SHFLHANDLE handle);
 uint32_t        vbsfQueryHandleType(PSHFLCLIENTDATA pClient,
                                     SHFLHANDLE handle);
+SHFLHANDLE      vbsfQueryHandleAt(PSHFLCLIENTDATA pClient, uint32_t idx);
 
 #endif /* !VBOX_INCLUDED_SRC_SharedFolders_shflhandle_h */
@@ -556,9 +556,12 @@ extern int testRTFsQuerySizes(const char *pszFsPath, PRTFOFF pcbTotal, RTFOFF *p
     return 0;
 }
 
+static uint32_t g_testRTPathQueryInfoEx_cCalls = 0;
+
 extern int testRTPathQueryInfoEx(const char *pszPath, PRTFSOBJINFO pObjInfo, RTFSOBJATTRADD enmAdditionalAttribs, uint32_t fFlags)
 {
     RT_NOREF2(enmAdditionalAttribs, fFlags);
+    g_testRTPathQueryInfoEx_cCalls++;
  /* RTPrintf("%s: pszPath=%s, enmAdditionalAttribs=0x%x, fFlags=0x%x\n",
              __PRETTY_FUNCTION__, pszPath, (unsigned) enmAdditionalAttribs,
              (unsigned) fFlags); */
@@ -905,6 +908,20 @@ static int createSymlink(VBOXHGCMSVCFNTABLE *psvcTable, SHFLROOT Root,
     return callHandle.rc;
 }
 
+static int closeFile(VBOXHGCMSVCFNTABLE *psvcTable, SHFLROOT Root,
+                     SHFLHANDLE hFile)
+{
+    VBOXHGCMSVCPARM aParms[SHFL_CPARMS_CLOSE];
+    VBOXHGCMCALLHANDLE_TYPEDEF callHandle = { VINF_SUCCESS };
+
+    HGCMSvcSetU32(&aParms[0], Root);
+    HGCMSvcSetU64(&aParms[1], (uint64_t) hFile);
+    psvcTable->pfnCall(psvcTable->pvService, &callHandle, 0,
+                       psvcTable->pvService, SHFL_FN_CLOSE,
+                       RT_ELEMENTS(aParms), aParms, 0);
+    return callHandle.rc;
+}
+
 static int readFile(VBOXHGCMSVCFNTABLE *psvcTable, SHFLROOT Root,
                     SHFLHANDLE hFile, uint64_t offSeek, uint32_t cbRead,
                     uint32_t *pcbRead, void *pvBuf, uint32_t cbBuf)
@@ -1135,6 +1152,46 @@ void testCreateDirSimple(RTTEST hTest)
     RTTEST_CHECK_MSG(hTest, g_testRTDirClose_hDir == hDir, (hTest, "hDir=%p\n", g_testRTDirClose_hDir));
 }
 
+void testCreateLookupCached(RTTEST hTest)
+{
+    VBOXHGCMSVCFNTABLE  svcTable;
+    VBOXHGCMSVCHELPERS  svcHelpers;
+    SHFLROOT Root;
+    const RTFILE hFile = (RTFILE) 0x10000;
+    SHFLCREATERESULT Result;
+    int rc;
+
+    RTTestSub(hTest, "Lookup cached");
+    Root = initWithWritableMapping(hTest, &svcTable, &svcHelpers,
+                                   "/test/mapping", "testname");
+    rc = createFile(&svcTable, Root, "/test/file", SHFL_CF_LOOKUP, NULL, &Result);
+    RTTEST_CHECK_RC_OK(hTest, rc);
+    RTTEST_CHECK_MSG(hTest, Result == SHFL_FILE_EXISTS, (hTest, "Result=%d\n", (int) Result));
+    uint32_t const cCalls = g_testRTPathQueryInfoEx_cCalls;
+    /* The second lookup must be answered from the cache. */
+    rc = createFile(&svcTable, Root, "/test/file", SHFL_CF_LOOKUP, NULL, &Result);
+    RTTEST_CHECK_RC_OK(hTest, rc);
+    RTTEST_CHECK_MSG(hTest, Result == SHFL_FILE_EXISTS, (hTest, "Result=%d\n", (int) Result));
+    RTTEST_CHECK_MSG(hTest, g_testRTPathQueryInfoEx_cCalls == cCalls,
+                     (hTest, "cCalls=%u, expected %u\n", g_testRTPathQueryInfoEx_cCalls, cCalls));
+    /* Creating a file must invalidate the cache. */
+    g_testRTFileOpen_hFile = hFile;
+    rc = createFile(&svcTable, Root, "/test/file2", SHFL_CF_ACCESS_READ, NULL, &Result);
+    RTTEST_CHECK_RC_OK(hTest, rc);
+    RTTEST_CHECK_MSG(hTest, Result == SHFL_FILE_CREATED, (hTest, "Result=%d\n", (int) Result));
+    uint32_t const cCallsCreate = g_testRTPathQueryInfoEx_cCalls;
+    rc = createFile(&svcTable, Root, "/test/file", SHFL_CF_LOOKUP, NULL, &Result);
+    RTTEST_CHECK_RC_OK(hTest, rc);
+    RTTEST_CHECK_MSG(hTest, g_testRTPathQueryInfoEx_cCalls == cCallsCreate + 1,
+                     (hTest, "cCalls=%u, expected %u\n", g_testRTPathQueryInfoEx_cCalls, cCallsCreate + 1));
+    unmapAndRemoveMapping(hTest, &svcTable, Root, "testname");
+    rc = svcTable.pfnDisconnect(NULL, 0, svcTable.pvService);
+    AssertReleaseRC(rc);
+    rc = svcTable.pfnUnload(NULL);
+    AssertReleaseRC(rc);
+    RTTestGuardedFree(hTest, svcTable.pvService);
+}
+
 void testCopyFileReadWrite(RTTEST hTest)
 {
     VBOXHGCMSVCFNTABLE  svcTable;
@@ -1328,6 +1385,43 @@ void testReadFileSimple(RTTEST hTest)
     RTTestGuardedFree(hTest, svcTable.pvService);
 }
 
+void testReadStaleHandle(RTTEST hTest)
+{
+    VBOXHGCMSVCFNTABLE  svcTable;
+    VBOXHGCMSVCHELPERS  svcHelpers;
+    SHFLROOT Root;
+    const RTFILE hFile = (RTFILE) 0x10000;
+    SHFLHANDLE hStale;
+    SHFLHANDLE Handle;
+    char achBuf[16];
+    uint32_t cbRead;
+    int rc;
+
+    RTTestSub(hTest, "Read with stale handle");
+    Root = initWithWritableMapping(hTest, &svcTable, &svcHelpers,
+                                   "/test/mapping", "testname");
+    g_testRTFileOpen_hFile = hFile;
+    rc = createFile(&svcTable, Root, "/test/file", SHFL_CF_ACCESS_READ,
+                    &hStale, NULL);
+    RTTEST_CHECK_RC_OK(hTest, rc);
+    rc = closeFile(&svcTable, Root, hStale);
+    RTTEST_CHECK_RC_OK(hTest, rc);
+    /* A closed handle must not refer to a file opened later on. */
+    rc = createFile(&svcTable, Root, "/test/file", SHFL_CF_ACCESS_READ,
+                    &Handle, NULL);
+    RTTEST_CHECK_RC_OK(hTest, rc);
+    RTTEST_CHECK_MSG(hTest, Handle != hStale,
+                     (hTest, "Handle=%#RX64 hStale=%#RX64\n", Handle, hStale));
+    rc = readFile(&svcTable, Root, hStale, 0, sizeof(achBuf), &cbRead, achBuf, (uint32_t)sizeof(achBuf));
+    RTTEST_CHECK_RC(hTest, rc, VERR_INVALID_HANDLE);
+    unmapAndRemoveMapping(hTest, &svcTable, Root, "testname");
+    rc = svcTable.pfnDisconnect(NULL, 0, svcTable.pvService);
+    AssertReleaseRC(rc);
+    rc = svcTable.pfnUnload(NULL);
+    AssertReleaseRC(rc);
+    RTTestGuardedFree(hTest, svcTable.pvService);
+}
+
 void testWriteFileSimple(RTTEST hTest)
 {
     VBOXHGCMSVCFNTABLE  svcTable;
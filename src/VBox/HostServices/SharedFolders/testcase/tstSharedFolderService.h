@@ -68,6 +68,7 @@ void testCreate(RTTEST hTest);
 void testCreateFileSimple(RTTEST hTest);
 void testCreateFileSimpleCaseInsensitive(RTTEST hTest);
 void testCreateDirSimple(RTTEST hTest);
+void testCreateLookupCached(RTTEST hTest);
 void testCreateBadParameters(RTTEST hTest);
 
 void testClose(RTTEST hTest);
@@ -78,6 +79,7 @@ void testRead(RTTEST hTest);
 /* Sub-tests for testRead(). */
 void testReadBadParameters(RTTEST hTest);
 void testReadFileSimple(RTTEST hTest);
+void testReadStaleHandle(RTTEST hTest);
 
 void testWrite(RTTEST hTest);
 /* Sub-tests for testWrite(). */
@@ -324,6 +324,9 @@ static int vbsfCheckHandleAccess(SHFLCLIENTDATA *pClient, SHFLROOT root,
         { /* likely */ }
         else
             return VERR_WRITE_PROTECT;
+
+        /* The object is about to change, so cached lookups may go stale. */
+        vbsfMappingsAttrCacheInvalidate(root);
     }
 
     return VINF_SUCCESS;
@@ -962,20 +965,23 @@ static int vbsfCloseFile(SHFLFILEHANDLE *pHandle)
 /**
  * Look up file or folder information by host path.
  *
+ * The result comes from the lookup cache of the mapping when possible.
+ *
  * @returns iprt status code (currently VINF_SUCCESS)
  * @param   pClient    client data
+ * @param   root       The root handle of the mapping the path is in.
  * @param   pszPath    The path of the file to be looked up
  * @param   pParms     Output:
  *                      - @a Result: Status of the operation (success or error)
  *                      - @a Info:   On success, information returned about the
  *                                   file
  */
-static int vbsfLookupFile(SHFLCLIENTDATA *pClient, char *pszPath, SHFLCREATEPARMS *pParms)
+static int vbsfLookupFile(SHFLCLIENTDATA *pClient, SHFLROOT root, char *pszPath, SHFLCREATEPARMS *pParms)
 {
     RTFSOBJINFO info;
     int rc;
 
-    rc = RTPathQueryInfoEx(pszPath, &info, RTFSOBJATTRADD_NOTHING, SHFL_RT_LINK(pClient));
+    rc = vbsfMappingsAttrCacheQuery(root, pszPath, SHFL_RT_LINK(pClient), &info);
     LogFlow(("SHFL_CF_LOOKUP\n"));
     /* Client just wants to know if the object exists. */
     switch (rc)
@@ -1019,6 +1025,8 @@ void testCreate(RTTEST hTest)
     /* Simple opening of an existing directory. */
     /** @todo How do wildcards in the path name work? */
     testCreateDirSimple(hTest);
+    /* Repeated lookups are served from the host side cache. */
+    testCreateLookupCached(hTest);
     /* If the number or types of parameters are wrong the API should fail. */
     testCreateBadParameters(hTest);
     /* Add tests as required... */
@@ -1078,7 +1086,7 @@ int vbsfCreate(SHFLCLIENTDATA *pClient, SHFLROOT root, SHFLSTRING *pPath, uint32
 
         if (BIT_FLAG(pParms->CreateFlags, SHFL_CF_LOOKUP))
         {
-            rc = vbsfLookupFile(pClient, pszFullPath, pParms);
+            rc = vbsfLookupFile(pClient, root, pszFullPath, pParms);
         }
         else
         {
@@ -1146,6 +1154,10 @@ int vbsfCreate(SHFLCLIENTDATA *pClient, SHFLROOT root, SHFLSTRING *pPath, uint32
                 {
                     rc = vbsfOpenFile(pClient, root, pszFullPath, pParms);
                 }
+
+                if (   pParms->Result == SHFL_FILE_CREATED
+                    || pParms->Result == SHFL_FILE_REPLACED)
+                    vbsfMappingsAttrCacheInvalidate(root);
             }
             else
             {
@@ -1280,6 +1292,8 @@ void testRead(RTTEST hTest)
     testReadBadParameters(hTest);
     /* Basic reading from a file. */
     testReadFileSimple(hTest);
+    /* Reading through a handle which has been closed. */
+    testReadStaleHandle(hTest);
     /* Add tests as required... */
 }
 #endif
@@ -2430,6 +2444,8 @@ int vbsfRemove(SHFLCLIENTDATA *pClient, SHFLROOT root, PCSHFLSTRING pPath, uint3
             rc = vbsfMappingsQueryWritable(pClient, root, &fWritable);
             if (RT_SUCCESS(rc) && fWritable)
             {
+                vbsfMappingsAttrCacheInvalidate(root);
+
                 /*
                  * Do the removal/deletion according to the type flags.
                  */
@@ -2581,6 +2597,8 @@ int vbsfRename(SHFLCLIENTDATA *pClient, SHFLROOT root, SHFLSTRING *pSrc, SHFLSTR
 
         if (RT_SUCCESS(rc))
         {
+            vbsfMappingsAttrCacheInvalidate(root);
+
             if ((flags & (SHFL_RENAME_FILE | SHFL_RENAME_DIR)) == (SHFL_RENAME_FILE | SHFL_RENAME_DIR))
             {
                 rc = RTPathRename(pszFullPathSrc, pszFullPathDest,
@@ -2663,7 +2681,10 @@ int vbsfCopyFile(SHFLCLIENTDATA *pClient, SHFLROOT idRootSrc, PCSHFLSTRING pStrP
              * Do the job.
              */
             if (RT_SUCCESS(rc))
+            {
+                vbsfMappingsAttrCacheInvalidate(idRootDst);
                 rc = RTFileCopy(pszPathSrc, pszPathDst);
+            }
 
             vbsfFreeFullPath(pszPathDst);
         }
@@ -2713,6 +2734,8 @@ int vbsfSymlink(SHFLCLIENTDATA *pClient, SHFLROOT root, SHFLSTRING *pSymlinkPath
     if (RT_FAILURE(rc) || !fWritable)
         return VERR_WRITE_PROTECT;
 
+    vbsfMappingsAttrCacheInvalidate(root);
+
     rc = vbsfBuildFullPath(pClient, root, pSymlinkPath, pSymlinkPath->u16Size + SHFLSTRING_HEADER_SIZE, &pszFullSymlinkPath,
                            NULL);
     if (RT_FAILURE(rc))
@@ -2764,7 +2787,7 @@ int vbsfDisconnect(SHFLCLIENTDATA *pClient)
     for (int i = 0; i < SHFLHANDLE_MAX; ++i)
     {
         SHFLFILEHANDLE *pHandle = NULL;
-        SHFLHANDLE Handle = (SHFLHANDLE)i;
+        SHFLHANDLE Handle = vbsfQueryHandleAt(pClient, (uint32_t)i);
 
         uint32_t type = vbsfQueryHandleType(pClient, Handle);
         switch (type & (SHFL_HF_TYPE_DIR | SHFL_HF_TYPE_FILE))
@@ -2785,7 +2808,7 @@ int vbsfDisconnect(SHFLCLIENTDATA *pClient)
 
         if (pHandle)
         {
-            LogFunc(("Opened handle 0x%08x\n", i));
+            LogFunc(("Opened handle %#RX64\n", Handle));
             vbsfClose(pClient, pHandle->root, Handle);
         }
     }
@@ -78,6 +78,7 @@
 #include <iprt/critsect.h>
 #include <iprt/asm.h>
 #include <iprt/mem.h>
+#include <iprt/mp.h>
 #include <iprt/string.h>
 #include <iprt/initterm.h>
 #include <iprt/stream.h>
@@ -91,6 +92,7 @@
 
 #include "fuse.h"
 #include "vboximgCrypto.h"
+#include "vboximgDiskPool.h"
 #include "vboximgMedia.h"
 #include "SelfSizingTable.h"
 #include "vboximgOpts.h"
@@ -157,6 +159,7 @@ static struct fuse_opt vboximgOptDefs[] = {
     OPTION("--image %s",         pszImageUuidOrPath,   0),
     OPTION("-i %s",              pszImageUuidOrPath,   0),
     OPTION("--rw",               fRW,                  1),
+    OPTION("--readers %u",       cReaders,             0),
     OPTION("--root",             fAllowRoot,           1),
     OPTION("--vm %s",            pszVm,                0),
     OPTION("-l",                 fList,                1),
@@ -245,6 +248,10 @@ briefUsage()
         "\n"
         "  [ --rw ]                           Make image writeable (default = readonly)\n"
         "\n"
+        "  [ --readers <count> ]              Number of disk containers serving reads\n"
+        "                                     in parallel on readonly mounts\n"
+        "                                     (default = online CPUs, at most 8)\n"
+        "\n"
         "  [ --root ]                         Same as -o allow_root.\n"
         "\n"
         "  [ { -v | --verbose } ]             Log extra information.\n"
@@ -1188,22 +1195,41 @@ static int vboxImgMntImageSetup(struct fuse_args *args)
 /* ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ */
 /* **************** END IFDEF'D (STUBBED-OUT) CODE ***************** */
 
-    int vrc = RTCritSectInit(&g_vdioLock);
-    if (RT_SUCCESS(vrc))
+    /*
+     * Readonly mounts serve the FUSE worker threads from a pool of independently
+     * opened containers, each used by one thread at a time.  A single container
+     * (always the case for --rw) is shared and needs the VD I/O lock.
+     */
+    uint32_t cReaders = 1;
+    if (   !g_vboximgOpts.fRW
+        && !g_vboximgOpts.fList)
     {
-        g_VDIfThreadSync.pfnStartRead   = vboximgThreadStartRead;
-        g_VDIfThreadSync.pfnFinishRead  = vboximgThreadFinishRead;
-        g_VDIfThreadSync.pfnStartWrite  = vboximgThreadStartWrite;
-        g_VDIfThreadSync.pfnFinishWrite = vboximgThreadFinishWrite;
-        vrc = VDInterfaceAdd(&g_VDIfThreadSync.Core, "vboximg_ThreadSync", VDINTERFACETYPE_THREADSYNC,
-                             &g_vdioLock, sizeof(VDINTERFACETHREADSYNC), &g_pVdIfs);
-        if (RT_FAILURE(vrc))
-            return RTMsgErrorExitFailure("ERROR: Failed to create thread synchronization interface "
+        cReaders = g_vboximgOpts.cReaders;
+        if (!cReaders)
+            cReaders = RT_MIN(RTMpGetOnlineCount(), 8);
+        cReaders = RT_MIN(RT_MAX(cReaders, 1), VBOXIMG_DISKPOOL_MAX_MEMBERS);
+    }
+
+    int vrc = VINF_SUCCESS;
+    if (cReaders == 1)
+    {
+        vrc = RTCritSectInit(&g_vdioLock);
+        if (RT_SUCCESS(vrc))
+        {
+            g_VDIfThreadSync.pfnStartRead   = vboximgThreadStartRead;
+            g_VDIfThreadSync.pfnFinishRead  = vboximgThreadFinishRead;
+            g_VDIfThreadSync.pfnStartWrite  = vboximgThreadStartWrite;
+            g_VDIfThreadSync.pfnFinishWrite = vboximgThreadFinishWrite;
+            vrc = VDInterfaceAdd(&g_VDIfThreadSync.Core, "vboximg_ThreadSync", VDINTERFACETYPE_THREADSYNC,
+                                 &g_vdioLock, sizeof(VDINTERFACETHREADSYNC), &g_pVdIfs);
+            if (RT_FAILURE(vrc))
+                return RTMsgErrorExitFailure("ERROR: Failed to create thread synchronization interface "
+                                             "for virtual disk I/O, rc=%Rrc\n", vrc);
+        }
+        else
+            return RTMsgErrorExitFailure("ERROR: Failed to create critsects "
                                          "for virtual disk I/O, rc=%Rrc\n", vrc);
     }
-    else
-        return RTMsgErrorExitFailure("ERROR: Failed to create critsects "
-                                     "for virtual disk I/O, rc=%Rrc\n", vrc);
 
    /*
      * Create HDD container to open base image and differencing images into
@@ -1218,43 +1244,60 @@ static int vboxImgMntImageSetup(struct fuse_args *args)
     if (VERBOSE)
         RTPrintf("\nCreating container for base image of format %s\n", pszFormat);
 
-    PVDISK pVDisk = NULL;
-    vrc = VDCreate(g_pVdIfs, enmType, &pVDisk);
-    if (RT_FAILURE(vrc))
-        return RTMsgErrorExitFailure("ERROR: Couldn't create virtual disk container\n");
+    RTVFSFILE ahVfsFiles[VBOXIMG_DISKPOOL_MAX_MEMBERS];
+    for (uint32_t iReader = 0; iReader < cReaders; iReader++)
+    {
+        PVDISK pVDisk = NULL;
+        vrc = VDCreate(g_pVdIfs, enmType, &pVDisk);
+        if (RT_FAILURE(vrc))
+            return RTMsgErrorExitFailure("ERROR: Couldn't create virtual disk container\n");
 
-    /* Open all virtual disk media from leaf snapshot (if any) to base image*/
+        /* Open all virtual disk media from leaf snapshot (if any) to base image*/
 
-    if (VERBOSE)
-        RTPrintf("\nOpening medium chain\n");
+        if (VERBOSE && iReader == 0)
+            RTPrintf("\nOpening medium chain\n");
 
-    IMAGELIST *pCurMedium = listHeadLockList.prev;  /* point to base image */
-    while (pCurMedium != &listHeadLockList)
-    {
-        if (VERBOSE)
-            RTPrintf("  Open: %s\n", CSTR(pCurMedium->pImagePath));
+        IMAGELIST *pCurMedium = listHeadLockList.prev;  /* point to base image */
+        while (pCurMedium != &listHeadLockList)
+        {
+            if (VERBOSE && iReader == 0)
+                RTPrintf("  Open: %s\n", CSTR(pCurMedium->pImagePath));
 
-        vrc = VDOpen(pVDisk,
-                     pszFormat,
-                     CSTR(pCurMedium->pImagePath),
-                     pCurMedium->fWriteable ? 0 : VD_OPEN_FLAGS_READONLY,
-                     g_pVdIfs);
+            vrc = VDOpen(pVDisk,
+                         pszFormat,
+                         CSTR(pCurMedium->pImagePath),
+                         pCurMedium->fWriteable ? 0 : VD_OPEN_FLAGS_READONLY,
+                         g_pVdIfs);
 
-        if (RT_FAILURE(vrc))
-            return RTMsgErrorExitFailure("Could not open the medium storage unit '%s' %Rrc",
-                                         CSTR(pCurMedium->pImagePath), vrc);
+            if (RT_FAILURE(vrc))
+                return RTMsgErrorExitFailure("Could not open the medium storage unit '%s' %Rrc",
+                                             CSTR(pCurMedium->pImagePath), vrc);
+
+            pCurMedium = pCurMedium->prev;
+        }
+
+        if (iReader == 0)
+            g_cbSector = VDGetSectorSize(pVDisk, VD_LAST_IMAGE);
 
-        pCurMedium = pCurMedium->prev;
+        /* Create the VFS file to use for the disk image access. */
+        vrc = VDCreateVfsFileFromDisk(pVDisk, VD_VFSFILE_DESTROY_ON_RELEASE, &ahVfsFiles[iReader]);
+        if (RT_FAILURE(vrc))
+            return RTMsgErrorExitFailure("Error creating VFS file wrapper for disk image\n");
     }
 
     RTStrFree(pszFormat);
 
-    /* Create the VFS file to use for the disk image access. */
-    vrc = VDCreateVfsFileFromDisk(pVDisk, VD_VFSFILE_DESTROY_ON_RELEASE, &g_hVfsFileDisk);
-    if (RT_FAILURE(vrc))
-        return RTMsgErrorExitFailure("Error creating VFS file wrapper for disk image\n");
+    if (cReaders == 1)
+        g_hVfsFileDisk = ahVfsFiles[0];
+    else
+    {
+        if (VERBOSE)
+            RTPrintf("\nServing reads from %u disk containers\n", cReaders);
 
-    g_cbSector = VDGetSectorSize(pVDisk, VD_LAST_IMAGE);
+        vrc = vboxImgDiskPoolCreate(ahVfsFiles, cReaders, &g_hVfsFileDisk);
+        if (RT_FAILURE(vrc))
+            return RTMsgErrorExitFailure("Error creating the disk container pool, rc=%Rrc\n", vrc);
+    }
 
     vrc = vboxImgMntVolumesSetup();
     if (RT_FAILURE(vrc))
@@ -1367,6 +1410,19 @@ int main(int argc, char **argv)
     if (g_vboximgOpts.fAllowRoot)
         fuse_opt_add_arg(&args, "-oallow_root");
 
+#ifdef RT_OS_LINUX
+    /*
+     * libfuse runs the request loop multi-threaded (unless -s is given), so let the
+     * kernel hand us large requests.  On readonly mounts the page cache may also be
+     * kept across opens, which makes the kernel read-ahead effective for repeated
+     * scans.  libfuse already defaults max_read and max_readahead to the maximum.
+     */
+    if (g_vboximgOpts.fRW)
+        fuse_opt_add_arg(&args, "-obig_writes");
+    else
+        fuse_opt_add_arg(&args, "-okernel_cache");
+#endif
+
     if (   !g_vboximgOpts.pszImageUuidOrPath
         || !RTVfsChainIsSpec(g_vboximgOpts.pszImageUuidOrPath))
         return vboxImgMntImageSetup(&args);
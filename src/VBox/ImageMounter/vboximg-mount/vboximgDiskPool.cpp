@@ -0,0 +1,386 @@
+/* $Id$ */
+/** @file
+ * vboximgDiskPool.cpp - Pool of read-only disk containers for parallel reads.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#define LOG_GROUP LOG_GROUP_DEFAULT /** @todo log group */
+#include <VBox/log.h>
+#include <iprt/asm.h>
+#include <iprt/assert.h>
+#include <iprt/critsect.h>
+#include <iprt/err.h>
+#include <iprt/file.h>
+#include <iprt/mem.h>
+#include <iprt/sg.h>
+#include <iprt/vfslowlevel.h>
+
+#include "vboximgDiskPool.h"
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * A disk container in the pool.
+ */
+typedef struct VBOXIMGDISKPOOLMEMBER
+{
+    /** Serializes access to the container. */
+    RTCRITSECT          CritSect;
+    /** The VFS file of the container. */
+    RTVFSFILE           hVfsFile;
+} VBOXIMGDISKPOOLMEMBER;
+/** Pointer to a pool member. */
+typedef VBOXIMGDISKPOOLMEMBER *PVBOXIMGDISKPOOLMEMBER;
+
+/**
+ * The pool VFS file instance data.
+ */
+typedef struct VBOXIMGDISKPOOL
+{
+    /** Current position. */
+    uint64_t                offCurPos;
+    /** Size of the disk. */
+    uint64_t                cbDisk;
+    /** Round robin hint for the member to try first. */
+    uint32_t volatile       iNext;
+    /** Number of members. */
+    uint32_t                cMembers;
+    /** The members. */
+    VBOXIMGDISKPOOLMEMBER   aMembers[VBOXIMG_DISKPOOL_MAX_MEMBERS];
+} VBOXIMGDISKPOOL;
+/** Pointer to the pool VFS file instance data. */
+typedef VBOXIMGDISKPOOL *PVBOXIMGDISKPOOL;
+
+
+/**
+ * Grabs an idle member, waiting for the round robin candidate if all are busy.
+ *
+ * @returns The member, owning its critical section.
+ * @param   pThis           The pool.
+ */
+static PVBOXIMGDISKPOOLMEMBER vboxImgDiskPoolAcquire(PVBOXIMGDISKPOOL pThis)
+{
+    uint32_t const iFirst = ASMAtomicIncU32(&pThis->iNext) % pThis->cMembers;
+    for (uint32_t i = 0; i < pThis->cMembers; i++)
+    {
+        PVBOXIMGDISKPOOLMEMBER pMember = &pThis->aMembers[(iFirst + i) % pThis->cMembers];
+        if (RT_SUCCESS(RTCritSectTryEnter(&pMember->CritSect)))
+            return pMember;
+    }
+
+    PVBOXIMGDISKPOOLMEMBER pMember = &pThis->aMembers[iFirst];
+    int rc = RTCritSectEnter(&pMember->CritSect);
+    AssertRC(rc);
+    return pMember;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSOBJOPS,pfnClose}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_Close(void *pvThis)
+{
+    PVBOXIMGDISKPOOL pThis = (PVBOXIMGDISKPOOL)pvThis;
+
+    for (uint32_t i = 0; i < pThis->cMembers; i++)
+    {
+        RTVfsFileRelease(pThis->aMembers[i].hVfsFile);
+        pThis->aMembers[i].hVfsFile = NIL_RTVFSFILE;
+        RTCritSectDelete(&pThis->aMembers[i].CritSect);
+    }
+    pThis->cMembers = 0;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSOBJOPS,pfnQueryInfo}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_QueryInfo(void *pvThis, PRTFSOBJINFO pObjInfo, RTFSOBJATTRADD enmAddAttr)
+{
+    PVBOXIMGDISKPOOL pThis = (PVBOXIMGDISKPOOL)pvThis;
+
+    PVBOXIMGDISKPOOLMEMBER pMember = vboxImgDiskPoolAcquire(pThis);
+    int rc = RTVfsFileQueryInfo(pMember->hVfsFile, pObjInfo, enmAddAttr);
+    RTCritSectLeave(&pMember->CritSect);
+    if (RT_SUCCESS(rc))
+        pObjInfo->Attr.fMode &= ~(RTFS_UNIX_IWUSR | RTFS_UNIX_IWGRP | RTFS_UNIX_IWOTH);
+    return rc;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSIOSTREAMOPS,pfnRead}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_Read(void *pvThis, RTFOFF off, PRTSGBUF pSgBuf, bool fBlocking, size_t *pcbRead)
+{
+    PVBOXIMGDISKPOOL const pThis = (PVBOXIMGDISKPOOL)pvThis;
+
+    Assert(pSgBuf->cSegs == 1);
+    NOREF(fBlocking);
+
+    uint64_t offUnsigned = off < 0 ? pThis->offCurPos : (uint64_t)off;
+    size_t       cbSeg = 0;
+    void * const pvSeg = RTSgBufGetCurrentSegment(pSgBuf, ~(size_t)0, &cbSeg);
+
+    /* The member files do the range checking, they all have the same size. */
+    size_t cbRead = 0;
+    PVBOXIMGDISKPOOLMEMBER pMember = vboxImgDiskPoolAcquire(pThis);
+    int rc = RTVfsFileReadAt(pMember->hVfsFile, offUnsigned, pvSeg, cbSeg, pcbRead ? &cbRead : NULL);
+    RTCritSectLeave(&pMember->CritSect);
+    if (RT_SUCCESS(rc))
+    {
+        if (!pcbRead)
+            cbRead = cbSeg;
+        RTSgBufAdvance(pSgBuf, cbRead);
+        offUnsigned += cbRead;
+    }
+
+    pThis->offCurPos = offUnsigned;
+    if (pcbRead)
+        *pcbRead = cbRead;
+    return rc;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSIOSTREAMOPS,pfnWrite}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_Write(void *pvThis, RTFOFF off, PRTSGBUF pSgBuf, bool fBlocking, size_t *pcbWritten)
+{
+    RT_NOREF(pvThis, off, pSgBuf, fBlocking, pcbWritten);
+    return VERR_WRITE_PROTECT;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSIOSTREAMOPS,pfnFlush}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_Flush(void *pvThis)
+{
+    RT_NOREF(pvThis);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSIOSTREAMOPS,pfnTell}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_Tell(void *pvThis, PRTFOFF poffActual)
+{
+    PVBOXIMGDISKPOOL pThis = (PVBOXIMGDISKPOOL)pvThis;
+    *poffActual = pThis->offCurPos;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSOBJSETOPS,pfnSetMode}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_SetMode(void *pvThis, RTFMODE fMode, RTFMODE fMask)
+{
+    RT_NOREF(pvThis, fMode, fMask);
+    return VERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSOBJSETOPS,pfnSetTimes}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_SetTimes(void *pvThis, PCRTTIMESPEC pAccessTime, PCRTTIMESPEC pModificationTime,
+                                                  PCRTTIMESPEC pChangeTime, PCRTTIMESPEC pBirthTime)
+{
+    RT_NOREF(pvThis, pAccessTime, pModificationTime, pChangeTime, pBirthTime);
+    return VERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSOBJSETOPS,pfnSetOwner}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_SetOwner(void *pvThis, RTUID uid, RTGID gid)
+{
+    RT_NOREF(pvThis, uid, gid);
+    return VERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSFILEOPS,pfnSeek}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_Seek(void *pvThis, RTFOFF offSeek, unsigned uMethod, PRTFOFF poffActual)
+{
+    PVBOXIMGDISKPOOL pThis = (PVBOXIMGDISKPOOL)pvThis;
+
+    uint64_t offWrt;
+    switch (uMethod)
+    {
+        case RTFILE_SEEK_BEGIN:
+            offWrt = 0;
+            break;
+        case RTFILE_SEEK_CURRENT:
+            offWrt = pThis->offCurPos;
+            break;
+        case RTFILE_SEEK_END:
+            offWrt = pThis->cbDisk;
+            break;
+        default:
+            return VERR_INTERNAL_ERROR_5;
+    }
+
+    uint64_t offNew;
+    if (offSeek == 0)
+        offNew = offWrt;
+    else if (offSeek > 0)
+    {
+        offNew = offWrt + offSeek;
+        if (   offNew < offWrt
+            || offNew > RTFOFF_MAX)
+            offNew = RTFOFF_MAX;
+    }
+    else if ((uint64_t)-offSeek < offWrt)
+        offNew = offWrt + offSeek;
+    else
+        offNew = 0;
+
+    pThis->offCurPos = offNew;
+    *poffActual = offNew;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{RTVFSFILEOPS,pfnQuerySize}
+ */
+static DECLCALLBACK(int) vboxImgDiskPool_QuerySize(void *pvThis, uint64_t *pcbFile)
+{
+    PVBOXIMGDISKPOOL pThis = (PVBOXIMGDISKPOOL)pvThis;
+    *pcbFile = pThis->cbDisk;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Disk pool file operations.
+ */
+static const RTVFSFILEOPS g_vboxImgDiskPoolFileOps =
+{
+    { /* Stream */
+        { /* Obj */
+            RTVFSOBJOPS_VERSION,
+            RTVFSOBJTYPE_FILE,
+            "VBoxImgDiskPool",
+            vboxImgDiskPool_Close,
+            vboxImgDiskPool_QueryInfo,
+            NULL,
+            RTVFSOBJOPS_VERSION
+        },
+        RTVFSIOSTREAMOPS_VERSION,
+        RTVFSIOSTREAMOPS_FEAT_NO_SG,
+        vboxImgDiskPool_Read,
+        vboxImgDiskPool_Write,
+        vboxImgDiskPool_Flush,
+        NULL /*PollOne*/,
+        vboxImgDiskPool_Tell,
+        NULL /*Skip*/,
+        NULL /*ZeroFill*/,
+        RTVFSIOSTREAMOPS_VERSION,
+    },
+    RTVFSFILEOPS_VERSION,
+    0,
+    { /* ObjSet */
+        RTVFSOBJSETOPS_VERSION,
+        RT_UOFFSETOF(RTVFSFILEOPS, ObjSet) - RT_UOFFSETOF(RTVFSFILEOPS, Stream.Obj),
+        vboxImgDiskPool_SetMode,
+        vboxImgDiskPool_SetTimes,
+        vboxImgDiskPool_SetOwner,
+        RTVFSOBJSETOPS_VERSION
+    },
+    vboxImgDiskPool_Seek,
+    vboxImgDiskPool_QuerySize,
+    NULL /*SetSize*/,
+    NULL /*QueryMaxSize*/,
+    RTVFSFILEOPS_VERSION
+};
+
+
+int vboxImgDiskPoolCreate(PRTVFSFILE pahVfsFiles, uint32_t cVfsFiles, PRTVFSFILE phVfsFile)
+{
+    AssertPtrReturn(phVfsFile, VERR_INVALID_POINTER);
+
+    int rc = VINF_SUCCESS;
+    if (   cVfsFiles == 0
+        || cVfsFiles > VBOXIMG_DISKPOOL_MAX_MEMBERS)
+        rc = VERR_INVALID_PARAMETER;
+
+    uint64_t cbDisk = 0;
+    if (RT_SUCCESS(rc))
+        rc = RTVfsFileQuerySize(pahVfsFiles[0], &cbDisk);
+
+    RTVFSFILE        hVfsFile = NIL_RTVFSFILE;
+    PVBOXIMGDISKPOOL pThis    = NULL;
+    if (RT_SUCCESS(rc))
+        rc = RTVfsNewFile(&g_vboxImgDiskPoolFileOps, sizeof(*pThis), RTFILE_O_OPEN | RTFILE_O_READ | RTFILE_O_DENY_NONE,
+                          NIL_RTVFS, NIL_RTVFSLOCK, &hVfsFile, (void **)&pThis);
+    if (RT_SUCCESS(rc))
+    {
+        pThis->offCurPos = 0;
+        pThis->cbDisk    = cbDisk;
+        pThis->iNext     = 0;
+        pThis->cMembers  = 0;
+        for (uint32_t i = 0; i < cVfsFiles && RT_SUCCESS(rc); i++)
+        {
+            rc = RTCritSectInit(&pThis->aMembers[i].CritSect);
+            if (RT_SUCCESS(rc))
+            {
+                pThis->aMembers[i].hVfsFile = pahVfsFiles[i];
+                pahVfsFiles[i] = NIL_RTVFSFILE;
+                pThis->cMembers++;
+            }
+        }
+
+        if (RT_SUCCESS(rc))
+        {
+            LogRel(("vboximg-mount: Serving reads from %u disk containers\n", cVfsFiles));
+            *phVfsFile = hVfsFile;
+            return VINF_SUCCESS;
+        }
+
+        RTVfsFileRelease(hVfsFile);
+    }
+
+    /* Drop whatever references weren't handed to the pool. */
+    for (uint32_t i = 0; i < cVfsFiles; i++)
+    {
+        RTVfsFileRelease(pahVfsFiles[i]);
+        pahVfsFiles[i] = NIL_RTVFSFILE;
+    }
+    return rc;
+}
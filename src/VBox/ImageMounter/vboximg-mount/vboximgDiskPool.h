@@ -0,0 +1,55 @@
+/* $Id$ */
+/** @file
+ * vboximgDiskPool.h - Pool of read-only disk containers for parallel reads.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+#ifndef VBOX_INCLUDED_SRC_vboximg_mount_vboximgDiskPool_h
+#define VBOX_INCLUDED_SRC_vboximg_mount_vboximgDiskPool_h
+#ifndef RT_WITHOUT_PRAGMA_ONCE
+# pragma once
+#endif
+
+#include <iprt/vfs.h>
+
+/** Maximum number of disk containers in a pool. */
+#define VBOXIMG_DISKPOOL_MAX_MEMBERS    64
+
+/**
+ * Creates a read-only VFS file distributing reads over several disk containers.
+ *
+ * Each container is only used by one thread at a time, so concurrent FUSE
+ * requests are served in parallel without the VD I/O lock.
+ *
+ * @returns VBox status code.
+ * @param   pahVfsFiles     Array of VFS files for independently opened containers
+ *                          of the same medium chain.  The references are consumed,
+ *                          also on failure.
+ * @param   cVfsFiles       Number of entries in @a pahVfsFiles, at most
+ *                          VBOXIMG_DISKPOOL_MAX_MEMBERS.
+ * @param   phVfsFile       Where to return the handle to the pool VFS file.
+ */
+int vboxImgDiskPoolCreate(PRTVFSFILE pahVfsFiles, uint32_t cVfsFiles, PRTVFSFILE phVfsFile);
+
+#endif /* !VBOX_INCLUDED_SRC_vboximg_mount_vboximgDiskPool_h */
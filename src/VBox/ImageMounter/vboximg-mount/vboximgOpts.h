@@ -46,6 +46,7 @@ typedef struct vboximgOpts {
      uint32_t      fWide;                   /** Flag to use wide-format list mode */
      uint32_t      fBriefUsage;             /** Flag to display only FS-specific program usage options */
      uint32_t      fVerbose;                /** Add more info to lists and operations */
+     uint32_t      cReaders;                /** Number of disk containers serving reads on read-only mounts, 0 = auto */
 } VBOXIMGOPTS;
 
 
@@ -888,6 +888,13 @@ private:
     HRESULT i_doMediumChange(IMediumAttachment *aMediumAttachment, bool fForce, PUVM pUVM, PCVMMR3VTABLE pVMM);
     HRESULT i_doCPURemove(ULONG aCpu, PUVM pUVM, PCVMMR3VTABLE pVMM);
     HRESULT i_doCPUAdd(ULONG aCpu, PUVM pUVM, PCVMMR3VTABLE pVMM);
+    void i_cpuAutoScaleStart(IMachine *pMachine);
+    void i_cpuAutoScaleStop();
+    void i_cpuAutoScaleSample();
+    static DECLCALLBACK(int) i_cpuAutoScaleThread(RTTHREAD hThreadSelf, void *pvUser);
+    static DECLCALLBACK(int) i_cpuAutoScaleStatsCallback(const char *pszName, STAMTYPE enmType, void *pvSample,
+                                                         STAMUNIT enmUnit, const char *pszUnit, STAMVISIBILITY enmVisibility,
+                                                         const char *pszDesc, void *pvUser);
 
     HRESULT i_doNetworkAdapterChange(PUVM pUVM, PCVMMR3VTABLE pVMM, const char *pszDevice, unsigned uInstance,
                                      unsigned uLun, INetworkAdapter *aNetworkAdapter);
@@ -1018,6 +1025,9 @@ private:
     HRESULT                     i_teleporterSrc(TeleporterStateSrc *pState);
     HRESULT                     i_teleporterSrcReadACK(TeleporterStateSrc *pState, const char *pszWhich, const char *pszNAckMsg = NULL);
     HRESULT                     i_teleporterSrcSubmitCommand(TeleporterStateSrc *pState, const char *pszCommand, bool fWaitForAck = true);
+    HRESULT                     i_teleporterSrcConnectExtra(TeleporterStateSrc *pState, const char *pszCommand, uint32_t cSockets,
+                                                            PRTSOCKET pahSockets);
+    HRESULT                     i_teleporterSrcServePostCopy(TeleporterStateSrc *pState);
     HRESULT                     i_teleporterTrg(PUVM pUVM, PCVMMR3VTABLE pVMM, IMachine *pMachine, Utf8Str *pErrorMsg,
                                                 bool fStartPaused, Progress *pProgress, bool *pfPowerOffOnFailure);
     static DECLCALLBACK(int)    i_teleporterTrgServeConnection(RTSOCKET Sock, void *pvUser);
@@ -1116,6 +1126,39 @@ private:
         ISnapshot *pISnapshot;
     } *mpVmm2UserMethods;
 
+    /** Load driven CPU hot-plugging state, see Console::i_cpuAutoScaleStart().
+     * Only the thread touches the counters, the online bitmap is also updated
+     * by i_onCPUChange() and therefore accessed atomically. */
+    struct CPUAUTOSCALE
+    {
+        /** The policy thread, NIL_RTTHREAD if not enabled. */
+        RTTHREAD            hThread;
+        /** Event the thread sleeps on between samples. */
+        RTSEMEVENT          hEvent;
+        /** Set to tell the thread to quit. */
+        bool volatile       fShutdown;
+        /** Number of CPUs configured for the VM. */
+        uint32_t            cCpus;
+        /** Minimum and maximum number of CPUs to keep online. */
+        uint32_t            cCpusMin;
+        uint32_t            cCpusMax;
+        /** Average busy percentage at or above which a CPU is added. */
+        uint32_t            uPctAdd;
+        /** Average busy percentage at or below which a CPU is removed. */
+        uint32_t            uPctRemove;
+        /** Consecutive seconds the add / remove condition must hold. */
+        uint32_t            cSecsAdd;
+        uint32_t            cSecsRemove;
+        /** Seconds to leave the configuration alone after a change. */
+        uint32_t            cSecsCooldown;
+        /** Current consecutive add / remove / cooldown counts. */
+        uint32_t            cAbove;
+        uint32_t            cBelow;
+        uint32_t            cCooldown;
+        /** Bitmap of the CPUs currently attached to the VM. */
+        uint32_t volatile   bmOnline[RT_ALIGN_32(VMM_MAX_CPU_COUNT, 32) / 32];
+    } mCpuAutoScale;
+
     /** The current network attachment type in the VM.
      * This doesn't have to match the network attachment type maintained in the
      * NetworkAdapter. This is needed to change the network attachment
@@ -50,11 +50,41 @@
 
 #include "SchemaDefs.h"
 
+#include <unordered_map>
+
 // ConsoleVRDPServer
 ///////////////////////////////////////////////////////////////////////////////
 
 class EmWebcam;
 
+/** Width and height of a tile of the VRDE update cache in pixels. */
+#define VRDP_TILE_SIZE 64
+/** Maximum number of pending update rectangles per screen, further ones are merged. */
+#define VRDP_TILE_MAX_RECTS 16
+
+/**
+ * Per screen cache of the tile hashes of the image last forwarded to the VRDE
+ * server with a bitmap update, see ConsoleVRDPServer::SendUpdateBitmap.
+ */
+typedef struct VRDPTILECACHE
+{
+    /** Screen width and height the tiles were computed for, 0 if the cache is empty. */
+    uint32_t  cxScreen;
+    uint32_t  cyScreen;
+    /** Number of tile columns and rows. */
+    uint32_t  cTilesX;
+    uint32_t  cTilesY;
+    /** Hash of each tile, 0 if unknown. */
+    uint64_t *pau64Hash;
+    /** Per tile state during a flush, VRDP_TILE_STATE_*. */
+    uint8_t  *pau8State;
+    /** Which tile a hash was last seen at, for detecting moved and repeated content. */
+    std::unordered_map<uint64_t, uint32_t> mapHashToTile;
+    /** Update rectangles reported since the last flush. */
+    uint32_t  cRects;
+    RTRECT    aRects[VRDP_TILE_MAX_RECTS];
+} VRDPTILECACHE;
+
 typedef struct _VRDPInputSynch
 {
     int cGuestNumLockAdaptions;
@@ -143,9 +173,9 @@ public:
     /*
      * Forwarders to VRDP server library.
      */
-    void SendUpdate (unsigned uScreenId, void *pvUpdate, uint32_t cbUpdate) const;
+    void SendUpdate (unsigned uScreenId, void *pvUpdate, uint32_t cbUpdate);
     void SendResize (void);
-    void SendUpdateBitmap (unsigned uScreenId, uint32_t x, uint32_t y, uint32_t w, uint32_t h) const;
+    void SendUpdateBitmap (unsigned uScreenId, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
 
     void SendAudioSamples (void const *pvSamples, uint32_t cSamples, VRDEAUDIOFORMAT format) const;
     void SendAudioVolume (uint16_t left, uint16_t right) const;
@@ -219,6 +249,14 @@ private:
 
     ComPtr<IDisplaySourceBitmap> maSourceBitmaps[SchemaDefs::MaxGuestMonitors];
 
+    /** Tile hash caches of the screens, protected by mTileCacheLock. */
+    VRDPTILECACHE maTileCaches[SchemaDefs::MaxGuestMonitors];
+    RTCRITSECT mTileCacheLock;
+
+    void tileCacheReset(VRDPTILECACHE *pCache);
+    void tileCacheFlush(unsigned uScreenId);
+    void sendUpdateBitmapRect(unsigned uScreenId, int32_t x, int32_t y, uint32_t w, uint32_t h) const;
+
     ComPtr<IEventListener> mConsoleListener;
 
     VRDPInputSynch m_InputSynch;
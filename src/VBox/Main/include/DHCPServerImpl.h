@@ -32,6 +32,7 @@
 #endif
 
 #include "DHCPServerWrap.h"
+#include <iprt/net.h>
 #include <map>
 
 namespace settings
@@ -114,6 +115,8 @@ private:
      * @{  */
     HRESULT i_doSaveSettings();
     HRESULT i_calcLeasesConfigAndLogFilenames(const com::Utf8Str &aNetwork) RT_NOEXCEPT;
+    HRESULT i_findLeaseInJournal(RTMAC const &rMacAddress, com::Utf8Str &aAddress, com::Utf8Str &aState,
+                                 int64_t *psecIssued, uint32_t *pcSecsToLive, bool *pfFound);
     HRESULT i_writeDhcpdConfig(const char *pszFilename, uint32_t uMACAddressVersion) RT_NOEXCEPT;
 
     HRESULT i_vmNameToIdAndValidateSlot(const com::Utf8Str &aVmName, ULONG a_uSlot, com::Guid &idMachine);
@@ -99,6 +99,14 @@ typedef struct _DISPLAYFBINFO
     /** Description of the currently plugged monitor with preferred mode,
      * a.k.a the last mode hint sent. */
     struct VMMDevDisplayDef monitorDesc;
+
+    /** Update rectangles reported by the device since the last flush,
+     * see Display::i_handleDisplayDamage.  Protected by Display::mDamageLock. */
+    struct
+    {
+        uint32_t cRects;
+        RTRECT   aRects[16];
+    } damage;
 } DISPLAYFBINFO;
 
 /* The legacy VBVA (VideoAccel) data.
@@ -159,6 +167,8 @@ public:
                               uint32_t cbLine, uint32_t w, uint32_t h, uint16_t flags,
                               int32_t xOrigin, int32_t yOrigin, bool fVGAResize);
     void i_handleDisplayUpdate(unsigned uScreenId, int x, int y, int w, int h);
+    void i_handleDisplayDamage(unsigned uScreenId, int x, int y, int w, int h);
+    void i_flushDisplayDamage(bool fForce);
     void i_handleUpdateVMMDevSupportsGraphics(bool fSupportsGraphics);
     void i_handleUpdateGuestVBVACapabilities(uint32_t fNewCapabilities);
     void i_handleUpdateVBVAInputMapping(int32_t xOrigin, int32_t yOrigin, uint32_t cx, uint32_t cy);
@@ -373,6 +383,9 @@ private:
     uint32_t    mfHostCursorCapabilities;
 
     bool mfSourceBitmapEnabled;
+    /** Framebuffers with FramebufferCapabilities_UpdateImage share the source
+     * bitmap memory and only get damage rectangles via NotifyUpdate. */
+    bool mfSharedSourceBitmap;
     bool volatile fVGAResizing;
 
     /** Are we in seamless mode?  Not saved, as we exit seamless on saving. */
@@ -405,6 +418,13 @@ private:
     /** Serializes access to mVideoAccelLegacy and mfVideoAccelVRDP, etc between VRDP and Display. */
     RTCRITSECT           mVideoAccelLock;
 
+    /** Protects DISPLAYFBINFO::damage and mnsDamageLastFlush. */
+    RTCRITSECT           mDamageLock;
+    /** Minimum interval between damage flushes in nanoseconds, 0 to flush on every refresh. */
+    uint64_t             mnsDamageInterval;
+    /** When the damage was last flushed (RTTimeNanoTS). */
+    uint64_t             mnsDamageLastFlush;
+
 #ifdef VBOX_WITH_RECORDING
     /** Struct which holds information and state about (video) recording. */
     struct Recording
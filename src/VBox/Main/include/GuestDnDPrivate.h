@@ -843,6 +843,12 @@ public:
     void setFormats(const GuestDnDMIMEList &lstFormats) { m_lstFormats = lstFormats; }
     GuestDnDMIMEList formats(void) const { return m_lstFormats; }
 
+    /** Returns the chunk size to use for transfers with the current guest. */
+    uint32_t getChunkSize(void) const
+    {
+        return m_fGuestFeatures0 & VBOX_DND_GF_0_LARGE_CHUNKS ? DND_MAX_CHUNK_SIZE : DND_DEFAULT_CHUNK_SIZE;
+    }
+
     void reset(void);
 
     /** @name Callback handling.
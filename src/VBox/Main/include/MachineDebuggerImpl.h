@@ -171,6 +171,12 @@ private:
     ComObjPtr<Progress>     m_Progress;
     /** Filename to dump the report to. */
     com::Utf8Str            m_strFilename;
+    /** Whether to write the report in the folded stack format for flame graphs. */
+    bool                    m_fSampleFolded;
+    /** Whether sampling continues until the progress object is cancelled. */
+    bool                    m_fSampleContinuous;
+    /** Timestamp (RTTimeMilliTS) of the last folded stack snapshot written. */
+    uint64_t                m_msSampleSnapshotLast;
     /** @} */
 };
 
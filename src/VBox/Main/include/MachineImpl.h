@@ -378,7 +378,8 @@ public:
     HRESULT initFromSettings(VirtualBox *aParent,
                              const Utf8Str &strConfigFile,
                              const Guid *aId,
-                             const com::Utf8Str &strPassword);
+                             const com::Utf8Str &strPassword,
+                             settings::MachineConfigFile *pPreparsedConfig = NULL);
 
     // initializer for machine config in memory (OVF import)
     HRESULT init(VirtualBox *aParent,
@@ -397,7 +398,7 @@ protected:
     HRESULT initImpl(VirtualBox *aParent,
                      const Utf8Str &strConfigFile);
     HRESULT initDataAndChildObjects();
-    HRESULT i_registeredInit();
+    HRESULT i_registeredInit(settings::MachineConfigFile *pPreparsedConfig = NULL);
     HRESULT i_tryCreateMachineConfigFile(bool fForceOverwrite);
     void uninitDataAndChildObjects();
 
@@ -47,6 +47,11 @@ enum VBoxFolder_t
     VBox_SnapshotFolder
 };
 
+/** Default number of media MachineMoveVM::moveAllDisks() moves in parallel. */
+#define MOVEVM_PARALLEL_MEDIA_DEFAULT   4
+/** Upper limit for the VBoxInternal2/MoveVMParallelMedia setting. */
+#define MOVEVM_PARALLEL_MEDIA_MAX       16
+
 typedef struct
 {
     bool                    fSnapshot;
@@ -136,6 +141,7 @@ private:
     HRESULT deleteFiles(const RTCList<Utf8Str> &listOfFiles);
     void updatePathsToStateFiles(const Utf8Str &sourcePath, const Utf8Str &targetPath);
     void updatePathsToNVRAMFiles(const Utf8Str &sourcePath, const Utf8Str &targetPath);
+    uint32_t queryMaxParallelMoves() const;
     HRESULT moveAllDisks(const std::map<Utf8Str, MEDIUMTASKMOVE> &listOfDisks, const Utf8Str &strTargetFolder = Utf8Str::Empty);
     HRESULT restoreAllDisks(const std::map<Utf8Str, MEDIUMTASKMOVE> &listOfDisks);
     HRESULT isMediumTypeSupportedForMoving(const ComPtr<IMedium> &pMedium);
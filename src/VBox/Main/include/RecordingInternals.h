@@ -118,8 +118,11 @@ typedef RECORDINGPOS *PRECORDINGPOS;
 #define RECORDINGVIDEOFRAME_F_VISIBLE    RT_BIT(0)
 /** Use blitting with alpha blending. */
 #define RECORDINGVIDEOFRAME_F_BLIT_ALPHA RT_BIT(1)
+/** Pixel data buffer is owned by a RECORDINGVIDEOFRAMEPOOL and must be
+ *  handed back to it instead of being freed. */
+#define RECORDINGVIDEOFRAME_F_POOLED     RT_BIT(2)
 /** Validation mask. */
-#define RECORDINGVIDEOFRAME_F_VALID_MASK 0x3
+#define RECORDINGVIDEOFRAME_F_VALID_MASK 0x7
 
 /**
  * Structure for keeping a single recording video frame.
@@ -141,6 +144,39 @@ typedef struct RECORDINGVIDEOFRAME
 /** Pointer to a video recording frame. */
 typedef RECORDINGVIDEOFRAME *PRECORDINGVIDEOFRAME;
 
+/** Number of pixel buffers a video frame pool holds.
+ *  This also is the maximum number of video frames which can be queued for encoding per stream. */
+#define RECORDINGVIDEOFRAMEPOOL_MAX_BUFFERS 8
+
+/**
+ * Structure for keeping a single pixel buffer of a video frame pool.
+ */
+typedef struct RECORDINGVIDEOFRAMEPOOLBUF
+{
+    /** Pixel data buffer. NULL if not allocated yet. */
+    uint8_t *pau8Buf;
+    /** Allocated size (in bytes) of \a pau8Buf. */
+    size_t   cbBuf;
+    /** Whether the buffer currently is handed out. */
+    bool     fInUse;
+} RECORDINGVIDEOFRAMEPOOLBUF;
+
+/**
+ * Structure for keeping a fixed-size pool of video frame pixel buffers.
+ *
+ * Buffers grow on demand and are kept around afterwards, so that queuing
+ * frame updates does not hit the heap once the pool is warmed up.
+ *
+ * @note    Not serialized; the owner has to take care of locking.
+ */
+typedef struct RECORDINGVIDEOFRAMEPOOL
+{
+    /** The pool's pixel buffers. */
+    RECORDINGVIDEOFRAMEPOOLBUF aBufs[RECORDINGVIDEOFRAMEPOOL_MAX_BUFFERS];
+} RECORDINGVIDEOFRAMEPOOL;
+/** Pointer to a video frame pool. */
+typedef RECORDINGVIDEOFRAMEPOOL *PRECORDINGVIDEOFRAMEPOOL;
+
 /**
  * Enumeration for supported scaling methods.
  */
@@ -354,6 +390,13 @@ typedef struct RECORDINGCODECVPX
      *  The more time the encoder is allowed to spend encoding, the better the encoded
      *  result, in exchange for higher CPU usage and time spent encoding. */
     unsigned int        uEncoderDeadline;
+    /** Number of encoder threads to use.
+     *  0 means to derive it from the host's online CPU count. */
+    uint32_t            cEncoderThreads;
+    /** Encoder speed vs. quality trade-off (VP8E_SET_CPUUSED, -16 to 16).
+     *  Higher absolute values encode faster at the cost of quality.
+     *  INT32_MAX if not set, in which case a value matching the encoder deadline is chosen. */
+    int32_t             iEncoderCpuUsed;
     /** Front buffer which is going to be encoded.
      *  Matches Main's framebuffer pixel format for faster / easier conversion.
      *  Not necessarily the same size as the encoder buffer. In such a case a scaling / cropping
@@ -538,6 +581,11 @@ int RecordingVideoBlitRaw(uint8_t *pu8Dst, size_t cbDst, uint32_t uDstX, uint32_
 int RecordingVideoFrameBlitRaw(PRECORDINGVIDEOFRAME pDstFrame, uint32_t uDstX, uint32_t uDstY, const uint8_t *pu8Src, size_t cbSrc, uint32_t uSrcX, uint32_t uSrcY, uint32_t uSrcWidth, uint32_t uSrcHeight, uint32_t uSrcBytesPerLine, uint8_t uSrcBPP, RECORDINGPIXELFMT enmFmt);
 int RecordingVideoFrameBlitFrame(PRECORDINGVIDEOFRAME pDstFrame, uint32_t uDstX, uint32_t uDstY, PRECORDINGVIDEOFRAME pSrcFrame, uint32_t uSrcX, uint32_t uSrcY, uint32_t uSrcWidth, uint32_t uSrcHeight);
 
+void RecordingVideoFramePoolInit(PRECORDINGVIDEOFRAMEPOOL pPool);
+void RecordingVideoFramePoolDestroy(PRECORDINGVIDEOFRAMEPOOL pPool);
+uint8_t *RecordingVideoFramePoolAcquire(PRECORDINGVIDEOFRAMEPOOL pPool, size_t cbBuf);
+void RecordingVideoFramePoolRelease(PRECORDINGVIDEOFRAMEPOOL pPool, uint8_t *pau8Buf);
+
 #ifdef VBOX_WITH_AUDIO_RECORDING
 void RecordingAudioFrameFree(PRECORDINGAUDIOFRAME pFrame);
 #endif
@@ -41,6 +41,7 @@
 #include <iprt/critsect.h>
 #include <iprt/req.h>
 #include <iprt/semaphore.h>
+#include <iprt/thread.h>
 
 #ifdef LOG_GROUP
 # undef LOG_GROUP
@@ -228,7 +229,9 @@ public:
     int Init(RecordingContext *pCtx, uint32_t uScreen, const ComPtr<IRecordingScreenSettings> &ScreenSettings, PRECORDINGCODEC pCodecAudio);
     int Uninit(void);
 
-    int ThreadMain(int rcWait, uint64_t msTimestamp, RecordingBlockMap &commonBlocks);
+    int ThreadMain(int rcWait, uint64_t msTimestamp);
+    int ProcessCommon(RecordingBlockMap &commonBlocks);
+    int Notify(void);
     int SendAudioFrame(const void *pvData, size_t cbData, uint64_t msTimestamp);
     int SendCursorPos(uint8_t idCursor, PRECORDINGPOS pPos, uint64_t msTimestamp);
     int SendCursorShape(uint8_t idCursor, PRECORDINGVIDEOFRAME pShape, uint64_t msTimestamp);
@@ -253,6 +256,13 @@ public:
 
     static DECLCALLBACK(int) codecWriteDataCallback(PRECORDINGCODEC pCodec, const void *pvData, size_t cbData, uint64_t msAbsPTS, uint32_t uFlags, void *pvUser);
 
+protected:
+
+    static DECLCALLBACK(int) threadMain(RTTHREAD hThreadSelf, void *pvUser);
+
+    int threadStart(void);
+    int threadStop(void);
+
 protected:
 
     int open(const ComPtr<IRecordingScreenSettings> &ScreenSettings);
@@ -270,7 +280,7 @@ protected:
     int iterateInternal(uint64_t msTimestamp);
 
     int addFrame(PRECORDINGFRAME pFrame, uint64_t msTimestamp);
-    int process(RecordingBlockSet &streamBlocks, RecordingBlockMap &commonBlocks);
+    int process(RecordingBlockSet &streamBlocks);
     int codecWriteToWebM(PRECORDINGCODEC pCodec, const void *pvData, size_t cbData, uint64_t msAbsPTS, uint32_t uFlags);
 
     void lock(void);
@@ -325,6 +335,12 @@ protected:
     RTCRITSECT          m_CritSect;
     /** Timestamp (in ms) of when recording has been started. */
     uint64_t            m_tsStartMs;
+    /** The stream's encoding thread. */
+    RTTHREAD            m_hThread;
+    /** Event semaphore for waking up the encoding thread. */
+    RTSEMEVENT          m_hEvtThread;
+    /** Shutdown indicator for the encoding thread. */
+    bool volatile       m_fThreadShutdown;
 #ifdef VBOX_WITH_AUDIO_RECORDING
     /** Pointer to audio codec instance data to use.
      *
@@ -344,6 +360,7 @@ protected:
         STAMCOUNTER     cVideoFramesToEncode;
         STAMCOUNTER     cVideoFramesEncoded;
         STAMCOUNTER     cVideoFramesHousekeeping;
+        STAMCOUNTER     cVideoFramesDropped;
 # ifdef VBOX_WITH_AUDIO_RECORDING
         STAMCOUNTER     cAudioFramesAdded;
         /* Note: STAM values for frames to encode / encoded / housekeeping
@@ -369,6 +386,14 @@ protected:
         /** Current surface screen info being used.
          *  Can be changed by a SendScreenChange() call. */
         RECORDINGSURFACEINFO ScreenInfo;
+        /** Pool of pixel buffers for queued video frames.
+         *  Its size also limits how many video frames can be pending for encoding. */
+        RECORDINGVIDEOFRAMEPOOL Pool;
+        /** Whether frame updates have been dropped because the encoder could not keep up. */
+        bool                 fDropped;
+        /** Bounding box (absolute, in pixel) of the dropped frame updates.
+         *  Only valid if \a fDropped is set. */
+        RTRECT               RectDropped;
     } m_Video;
     /** Cached (const) settings from IRecordingScreen. Same naming (minus notation).
      *  Kept around for speed reasons during runtime. */
@@ -62,7 +62,6 @@
 #define LOG_GROUP LOG_GROUP_MAIN_EVENT
 #include <list>
 #include <map>
-#include <deque>
 
 #include "EventImpl.h"
 #include "AutoCaller.h"
@@ -611,7 +610,22 @@ public:
 
 typedef EventMapList EventMap[NumEvents];
 typedef std::map<IEvent *, int32_t> PendingEventsMap;
-typedef std::deque<ComPtr<IEvent> > PassiveQueue;
+
+/** An event queued for a passive listener. */
+struct PassiveQueueEntry
+{
+    ComPtr<IEvent>  mEvent;
+    /** Key of the state the event reports, empty if it can't be superseded
+     * (see getSupersedeKey()).  Computed once when queuing the event. */
+    Utf8Str         mSupersedeKey;
+};
+typedef std::list<PassiveQueueEntry> PassiveQueue;
+/** The latest queued event for each supersede key. */
+typedef std::map<Utf8Str, PassiveQueue::iterator> SupersedeMap;
+
+/** Number of queued events for a passive listener from which on events
+ * superseded by a newer one are dropped, see ListenerRecord::enqueue(). */
+#define PASSIVE_QUEUE_COALESCE_THRESHOLD 64
 
 class ListenerRecord
 {
@@ -624,9 +638,12 @@ private:
     int32_t volatile              mQEventBusyCnt;
     RTCRITSECT                    mcsQLock;
     PassiveQueue                  mQueue;
+    SupersedeMap                  mSupersedeMap;
     int32_t volatile              mRefCnt;
     uint64_t                      mLastRead;
 
+    void popFront(IEvent **aEvent);
+
 public:
     ListenerRecord(IEventListener *aListener,
                    com::SafeArray<VBoxEventType_T> &aInterested,
@@ -820,8 +837,7 @@ ListenerRecord::~ListenerRecord()
             if (mQueue.empty())
                 break;
 
-            mQueue.front().queryInterfaceTo(aEvent.asOutParam());
-            mQueue.pop_front();
+            popFront(aEvent.asOutParam());
 
             BOOL fWaitable = FALSE;
             aEvent->COMGETTER(Waitable)(&fWaitable);
@@ -866,6 +882,74 @@ HRESULT ListenerRecord::process(IEvent *aEvent,
 }
 
 
+/**
+ * Returns the key identifying the state an event reports (event type, machine
+ * and guest property), or an empty string if the event can't be superseded by
+ * a later one.
+ *
+ * Only non-waitable state change notifications qualify, for those the latest
+ * event carries all a listener needs to know.
+ */
+static Utf8Str getSupersedeKey(IEvent *aEvent)
+{
+    Utf8Str strKey;
+
+    BOOL fWaitable = TRUE;
+    HRESULT hrc = aEvent->COMGETTER(Waitable)(&fWaitable);
+    if (FAILED(hrc) || fWaitable)
+        return strKey;
+
+    VBoxEventType_T enmType = VBoxEventType_Invalid;
+    hrc = aEvent->COMGETTER(Type)(&enmType);
+    if (FAILED(hrc))
+        return strKey;
+
+    switch (enmType)
+    {
+        case VBoxEventType_OnMachineStateChanged:
+        case VBoxEventType_OnSessionStateChanged:
+        {
+            ComPtr<IMachineEvent> pMachineEvent = aEvent;
+            Bstr bstrId;
+            if (pMachineEvent && SUCCEEDED(pMachineEvent->COMGETTER(MachineId)(bstrId.asOutParam())))
+                strKey.printf("%d/%ls", enmType, bstrId.raw());
+            break;
+        }
+        case VBoxEventType_OnGuestPropertyChanged:
+        {
+            ComPtr<IGuestPropertyChangedEvent> pPropEvent = aEvent;
+            Bstr bstrId, bstrName;
+            if (   pPropEvent
+                && SUCCEEDED(pPropEvent->COMGETTER(MachineId)(bstrId.asOutParam()))
+                && SUCCEEDED(pPropEvent->COMGETTER(Name)(bstrName.asOutParam())))
+                strKey.printf("%d/%ls/%ls", enmType, bstrId.raw(), bstrName.raw());
+            break;
+        }
+        default:
+            break;
+    }
+
+    return strKey;
+}
+
+/**
+ * Removes the first queued event, returning it in @a aEvent.
+ *
+ * Caller must hold the queue lock and make sure the queue isn't empty.
+ */
+void ListenerRecord::popFront(IEvent **aEvent)
+{
+    PassiveQueueEntry &rEntry = mQueue.front();
+    if (rEntry.mSupersedeKey.isNotEmpty())
+    {
+        SupersedeMap::iterator itKey = mSupersedeMap.find(rEntry.mSupersedeKey);
+        if (itKey != mSupersedeMap.end() && itKey->second == mQueue.begin())
+            mSupersedeMap.erase(itKey);
+    }
+    rEntry.mEvent.queryInterfaceTo(aEvent);
+    mQueue.pop_front();
+}
+
 HRESULT ListenerRecord::enqueue(IEvent *aEvent)
 {
     AssertMsg(!mActive, ("must be passive\n"));
@@ -886,13 +970,32 @@ HRESULT ListenerRecord::enqueue(IEvent *aEvent)
 
 
     RTSEMEVENT hEvt = mQEvent;
-    if (queueSize != 0 && mQueue.back() == aEvent)
+    if (queueSize != 0 && mQueue.back().mEvent == aEvent)
         /* if same event is being pushed multiple times - it's reusable event and
            we don't really need multiple instances of it in the queue */
         hEvt = NIL_RTSEMEVENT;
     else if (hEvt != NIL_RTSEMEVENT) /* don't bother queuing after shutdown */
     {
-        mQueue.push_back(aEvent);
+        PassiveQueueEntry Entry;
+        Entry.mEvent        = aEvent;
+        Entry.mSupersedeKey = getSupersedeKey(aEvent);
+        mQueue.push_back(Entry);
+
+        /* Once the listener falls behind, drop the older event reporting the same
+           state, so it gets the latest state instead of being unregistered for an
+           oversized queue. */
+        if (Entry.mSupersedeKey.isNotEmpty())
+        {
+            PassiveQueue::iterator itNew = --mQueue.end();
+            std::pair<SupersedeMap::iterator, bool> Ins = mSupersedeMap.insert(SupersedeMap::value_type(Entry.mSupersedeKey,
+                                                                                                          itNew));
+            if (!Ins.second)
+            {
+                if (queueSize >= PASSIVE_QUEUE_COALESCE_THRESHOLD)
+                    mQueue.erase(Ins.first->second);
+                Ins.first->second = itNew;
+            }
+        }
         ASMAtomicIncS32(&mQEventBusyCnt);
     }
 
@@ -949,10 +1052,7 @@ HRESULT ListenerRecord::dequeue(IEvent **aEvent,
     if (mQueue.empty())
         *aEvent = NULL;
     else
-    {
-        mQueue.front().queryInterfaceTo(aEvent);
-        mQueue.pop_front();
-    }
+        popFront(aEvent);
 
     ::RTCritSectLeave(&mcsQLock);
     return S_OK;
@@ -1206,7 +1306,7 @@ HRESULT EventSource::fireEvent(const ComPtr<IEvent> &aEvent,
                  ++it)
             {
                 RecordHolder<ListenerRecord> record(*it);
-                if (record.obj()->mQueue.size() != 0 && record.obj()->mQueue.back() == aEvent)
+                if (record.obj()->mQueue.size() != 0 && record.obj()->mQueue.back().mEvent == aEvent)
                     m->mEvMap[(int)evType - FirstEvent].remove(record.obj());
             }
 
@@ -240,7 +240,8 @@ void RecordingUtilsConvBGRA32ToYUVI420Ex(uint8_t *paDst, uint32_t uDstX, uint32_
     Assert(uDstY + uSrcHeight <= uDstHeight);
     Assert(uSrcBPP % 8 == 0);
 
-    RT_NOREF(uSrcHeight, uDstHeight);
+    if (!uSrcWidth || !uSrcHeight)
+        return;
 
 #define CALC_Y(r, g, b) \
     (66 * r + 129 * g + 25 * b) >> 8
@@ -249,36 +250,87 @@ void RecordingUtilsConvBGRA32ToYUVI420Ex(uint8_t *paDst, uint32_t uDstX, uint32_
 #define CALC_V(r, g, b) \
     ((112 * r + -94 * g + -18 * b) >> 8) + 128
 
-    uint32_t uDstXCur = uDstX;
+    unsigned const cbSrcPixel = uSrcBPP / 8;
+    size_t   const cbYPlane   = (size_t)uDstWidth * uDstHeight;
+    uint32_t const cxUV       = uDstWidth  / 2;
+    uint32_t const cyUV       = uDstHeight / 2;
 
-    const unsigned uSrcBytesPerPixel = uSrcBPP / 8;
-
-    size_t offSrc = (uSrcY * uSrcStride) + (uSrcX * uSrcBytesPerPixel);
-
-    for (size_t y = 0; y < uSrcHeight; y++)
+    /*
+     * Luma: one sample per pixel.
+     * Keep the inner loop free of any index math so that the compiler can vectorize it.
+     */
+    const uint8_t *pbSrcLine = paSrc + (size_t)uSrcY * uSrcStride + (size_t)uSrcX * cbSrcPixel;
+    uint8_t       *pbDstY    = paDst + (size_t)uDstY * uDstWidth + uDstX;
+    for (uint32_t y = 0; y < uSrcHeight; y++)
     {
-        for (size_t x = 0; x < uSrcWidth; x++)
+        if (cbSrcPixel == 4) /* The common BGRA32 case. */
+        {
+            for (uint32_t x = 0; x < uSrcWidth; x++)
+            {
+                int const b = pbSrcLine[x * 4];
+                int const g = pbSrcLine[x * 4 + 1];
+                int const r = pbSrcLine[x * 4 + 2];
+                pbDstY[x] = (uint8_t)(CALC_Y(r, g, b));
+            }
+        }
+        else
         {
-            size_t const offBGR = offSrc + (x * uSrcBytesPerPixel);
+            const uint8_t *pbSrc = pbSrcLine;
+            for (uint32_t x = 0; x < uSrcWidth; x++, pbSrc += cbSrcPixel)
+            {
+                int const b = pbSrc[0];
+                int const g = pbSrc[1];
+                int const r = pbSrc[2];
+                pbDstY[x] = (uint8_t)(CALC_Y(r, g, b));
+            }
+        }
 
-            uint8_t const b = paSrc[offBGR];
-            uint8_t const g = paSrc[offBGR + 1];
-            uint8_t const r = paSrc[offBGR + 2];
+        pbSrcLine += uSrcStride;
+        pbDstY    += uDstWidth;
+    }
 
-            size_t const offY  = uDstY * uDstWidth + uDstXCur;
-            size_t const offUV = (uDstY / 2) * (uDstWidth / 2) + (uDstXCur / 2) + uDstWidth * uDstHeight;
+    /*
+     * Chroma: one sample per 2x2 pixel block, averaged over the block's pixels which
+     * are part of the updated area. Computing this once per block instead of once per
+     * pixel cuts the chroma work by four.
+     */
+    uint8_t *pbDstU = paDst + cbYPlane;
+    uint8_t *pbDstV = pbDstU + cbYPlane / 4;
 
-            paDst[offY]                               = CALC_Y(r, g, b);
-            paDst[offUV]                              = CALC_U(r, g, b);
-            paDst[offUV + uDstWidth * uDstHeight / 4] = CALC_V(r, g, b);
+    uint32_t const yDstEnd = uDstY + uSrcHeight; /* Exclusive. */
+    uint32_t const xDstEnd = uDstX + uSrcWidth;  /* Ditto. */
+    for (uint32_t yUV = uDstY / 2; yUV <= (yDstEnd - 1) / 2 && yUV < cyUV; yUV++)
+    {
+        uint32_t const yBlk0 = RT_MAX(yUV * 2, uDstY);
+        uint32_t const yBlk1 = RT_MIN(yUV * 2 + 2, yDstEnd);
 
-            uDstXCur++;
-        }
+        for (uint32_t xUV = uDstX / 2; xUV <= (xDstEnd - 1) / 2 && xUV < cxUV; xUV++)
+        {
+            uint32_t const xBlk0 = RT_MAX(xUV * 2, uDstX);
+            uint32_t const xBlk1 = RT_MIN(xUV * 2 + 2, xDstEnd);
 
-        offSrc += uSrcStride;
+            int r = 0, g = 0, b = 0, c = 0;
+            for (uint32_t yBlk = yBlk0; yBlk < yBlk1; yBlk++)
+            {
+                const uint8_t *pbSrc = paSrc + (size_t)(uSrcY + yBlk - uDstY) * uSrcStride
+                                             + (size_t)(uSrcX + xBlk0 - uDstX) * cbSrcPixel;
+                for (uint32_t xBlk = xBlk0; xBlk < xBlk1; xBlk++, pbSrc += cbSrcPixel)
+                {
+                    b += pbSrc[0];
+                    g += pbSrc[1];
+                    r += pbSrc[2];
+                    c++;
+                }
+            }
 
-        uDstXCur = uDstX;
-        uDstY++;
+            r /= c;
+            g /= c;
+            b /= c;
+
+            size_t const offUV = (size_t)yUV * cxUV + xUV;
+            pbDstU[offUV] = (uint8_t)(CALC_U(r, g, b));
+            pbDstV[offUV] = (uint8_t)(CALC_V(r, g, b));
+        }
     }
 
 #undef CALC_Y
@@ -461,6 +461,9 @@ Console::Console()
 {
     RT_ZERO(maLedSets);
     RT_ZERO(maLedTypes);
+    RT_ZERO(mCpuAutoScale);
+    mCpuAutoScale.hThread = NIL_RTTHREAD;
+    mCpuAutoScale.hEvent  = NIL_RTSEMEVENT;
 }
 
 Console::~Console()
@@ -2709,6 +2712,269 @@ HRESULT Console::i_doCPUAdd(ULONG aCpu, PUVM pUVM, PCVMMR3VTABLE pVMM)
     return hrc;
 }
 
+/**
+ * Starts the load driven CPU hot-plugging policy thread if configured.
+ *
+ * The policy is enabled by setting the VBoxInternal2/CpuAutoScale extra data
+ * item to 1 and requires CPU hot-plugging to be enabled for the VM.  The
+ * remaining knobs are optional:
+ *      - VBoxInternal2/CpuAutoScaleMin, default 1.
+ *      - VBoxInternal2/CpuAutoScaleMax, default the CPU count.
+ *      - VBoxInternal2/CpuAutoScaleAddPct, default 80.
+ *      - VBoxInternal2/CpuAutoScaleRemovePct, default 30.
+ *      - VBoxInternal2/CpuAutoScaleAddSecs, default 3.
+ *      - VBoxInternal2/CpuAutoScaleRemoveSecs, default 30.
+ *      - VBoxInternal2/CpuAutoScaleCooldownSecs, default 10.
+ *
+ * @param   pMachine    The machine.
+ *
+ * @note    Must be called without holding the console lock.
+ */
+void Console::i_cpuAutoScaleStart(IMachine *pMachine)
+{
+    AssertReturnVoid(mCpuAutoScale.hThread == NIL_RTTHREAD);
+
+    Bstr bstr;
+    HRESULT hrc = pMachine->GetExtraData(Bstr("VBoxInternal2/CpuAutoScale").raw(), bstr.asOutParam());
+    if (FAILED(hrc) || Utf8Str(bstr).toUInt32() == 0)
+        return;
+
+    BOOL fCpuHotPlug = FALSE;
+    pMachine->COMGETTER(CPUHotPlugEnabled)(&fCpuHotPlug);
+    ULONG cCpus = 1;
+    pMachine->COMGETTER(CPUCount)(&cCpus);
+    if (!fCpuHotPlug || cCpus < 2)
+    {
+        LogRel(("CpuAutoScale: Ignored, requires CPU hot-plugging and more than one CPU\n"));
+        return;
+    }
+
+    struct { const char *pszName; uint32_t *puValue; uint32_t uDefault; } const s_aKnobs[] =
+    {
+        { "VBoxInternal2/CpuAutoScaleMin",          &mCpuAutoScale.cCpusMin,      1     },
+        { "VBoxInternal2/CpuAutoScaleMax",          &mCpuAutoScale.cCpusMax,      cCpus },
+        { "VBoxInternal2/CpuAutoScaleAddPct",       &mCpuAutoScale.uPctAdd,       80    },
+        { "VBoxInternal2/CpuAutoScaleRemovePct",    &mCpuAutoScale.uPctRemove,    30    },
+        { "VBoxInternal2/CpuAutoScaleAddSecs",      &mCpuAutoScale.cSecsAdd,      3     },
+        { "VBoxInternal2/CpuAutoScaleRemoveSecs",   &mCpuAutoScale.cSecsRemove,   30    },
+        { "VBoxInternal2/CpuAutoScaleCooldownSecs", &mCpuAutoScale.cSecsCooldown, 10    },
+    };
+    for (size_t i = 0; i < RT_ELEMENTS(s_aKnobs); i++)
+    {
+        *s_aKnobs[i].puValue = s_aKnobs[i].uDefault;
+        hrc = pMachine->GetExtraData(Bstr(s_aKnobs[i].pszName).raw(), bstr.asOutParam());
+        if (SUCCEEDED(hrc) && bstr.isNotEmpty())
+            *s_aKnobs[i].puValue = Utf8Str(bstr).toUInt32();
+    }
+
+    mCpuAutoScale.cCpus       = RT_MIN(cCpus, VMM_MAX_CPU_COUNT);
+    mCpuAutoScale.cCpusMax    = RT_MIN(RT_MAX(mCpuAutoScale.cCpusMax, 1), mCpuAutoScale.cCpus);
+    mCpuAutoScale.cCpusMin    = RT_MIN(RT_MAX(mCpuAutoScale.cCpusMin, 1), mCpuAutoScale.cCpusMax);
+    mCpuAutoScale.uPctAdd     = RT_MIN(RT_MAX(mCpuAutoScale.uPctAdd, 1), 100);
+    mCpuAutoScale.uPctRemove  = RT_MIN(mCpuAutoScale.uPctRemove, mCpuAutoScale.uPctAdd - 1);
+    mCpuAutoScale.cSecsAdd    = RT_MAX(mCpuAutoScale.cSecsAdd, 1);
+    mCpuAutoScale.cSecsRemove = RT_MAX(mCpuAutoScale.cSecsRemove, 1);
+    mCpuAutoScale.cAbove      = 0;
+    mCpuAutoScale.cBelow      = 0;
+    mCpuAutoScale.cCooldown   = mCpuAutoScale.cSecsCooldown;
+    mCpuAutoScale.fShutdown   = false;
+
+    for (uint32_t idCpu = 0; idCpu < mCpuAutoScale.cCpus; idCpu++)
+    {
+        BOOL fAttached = FALSE;
+        hrc = pMachine->GetCPUStatus(idCpu, &fAttached);
+        if (SUCCEEDED(hrc) && fAttached)
+            ASMAtomicBitSet(&mCpuAutoScale.bmOnline[0], (int32_t)idCpu);
+        else
+            ASMAtomicBitClear(&mCpuAutoScale.bmOnline[0], (int32_t)idCpu);
+    }
+
+    int vrc = RTSemEventCreate(&mCpuAutoScale.hEvent);
+    AssertLogRelRCReturnVoid(vrc);
+    vrc = RTThreadCreate(&mCpuAutoScale.hThread, Console::i_cpuAutoScaleThread, this, 0 /*cbStack*/,
+                         RTTHREADTYPE_DEFAULT, RTTHREADFLAGS_WAITABLE, "CpuAutoScale");
+    if (RT_FAILURE(vrc))
+    {
+        LogRel(("CpuAutoScale: Failed to create thread: %Rrc\n", vrc));
+        mCpuAutoScale.hThread = NIL_RTTHREAD;
+        RTSemEventDestroy(mCpuAutoScale.hEvent);
+        mCpuAutoScale.hEvent = NIL_RTSEMEVENT;
+        return;
+    }
+
+    LogRel(("CpuAutoScale: Enabled, %u..%u CPUs, add at %u%% for %us, remove at %u%% for %us, cooldown %us\n",
+            mCpuAutoScale.cCpusMin, mCpuAutoScale.cCpusMax, mCpuAutoScale.uPctAdd, mCpuAutoScale.cSecsAdd,
+            mCpuAutoScale.uPctRemove, mCpuAutoScale.cSecsRemove, mCpuAutoScale.cSecsCooldown));
+}
+
+/**
+ * Stops the CPU hot-plugging policy thread, waiting for it to terminate.
+ *
+ * @note    Must be called without holding the console lock as the thread may
+ *          be in the middle of a hot-plug operation which needs it.
+ */
+void Console::i_cpuAutoScaleStop()
+{
+    RTTHREAD hThread = mCpuAutoScale.hThread;
+    if (hThread == NIL_RTTHREAD)
+        return;
+
+    ASMAtomicWriteBool(&mCpuAutoScale.fShutdown, true);
+    RTSemEventSignal(mCpuAutoScale.hEvent);
+    int vrc = RTThreadWait(hThread, RT_MS_1MIN, NULL);
+    AssertLogRelRC(vrc);
+
+    mCpuAutoScale.hThread = NIL_RTTHREAD;
+    RTSemEventDestroy(mCpuAutoScale.hEvent);
+    mCpuAutoScale.hEvent = NIL_RTSEMEVENT;
+}
+
+/**
+ * The CPU hot-plugging policy thread, takes a sample once a second.
+ */
+/*static*/ DECLCALLBACK(int) Console::i_cpuAutoScaleThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    RT_NOREF(hThreadSelf);
+    Console *pThis = (Console *)pvUser;
+
+    VirtualBoxBase::initializeComForThread();
+    while (!ASMAtomicReadBool(&pThis->mCpuAutoScale.fShutdown))
+    {
+        RTSemEventWait(pThis->mCpuAutoScale.hEvent, RT_MS_1SEC);
+        if (ASMAtomicReadBool(&pThis->mCpuAutoScale.fShutdown))
+            break;
+        pThis->i_cpuAutoScaleSample();
+    }
+    VirtualBoxBase::uninitializeComForThread();
+    return VINF_SUCCESS;
+}
+
+/**
+ * STAM enumeration callback picking up the guest statistics page samples of
+ * the VMMDev.
+ *
+ * @returns 0 (continue enumeration).
+ * @param   pvUser      Pointer to two uint32_t: sample count and run queue length.
+ */
+/*static*/ DECLCALLBACK(int)
+Console::i_cpuAutoScaleStatsCallback(const char *pszName, STAMTYPE enmType, void *pvSample, STAMUNIT enmUnit,
+                                     const char *pszUnit, STAMVISIBILITY enmVisibility, const char *pszDesc, void *pvUser)
+{
+    RT_NOREF(enmUnit, pszUnit, enmVisibility, pszDesc);
+    uint32_t *pau32 = (uint32_t *)pvUser;
+    if (enmType == STAMTYPE_COUNTER && RTStrSimplePatternMatch("*/Samples", pszName))
+        pau32[0] = (uint32_t)RT_MIN(((PSTAMCOUNTER)pvSample)->c, UINT32_MAX);
+    else if (enmType == STAMTYPE_U32 && RTStrSimplePatternMatch("*/RunQueue", pszName))
+        pau32[1] = *(uint32_t *)pvSample;
+    return 0;
+}
+
+/**
+ * Takes one load sample and hot-plugs or unplugs a CPU when the load has
+ * stayed above or below the thresholds long enough.
+ *
+ * The load is the host side executing percentage of the online CPUs over the
+ * last second, refined by the guest run queue length from the VMMDev
+ * statistics page if the guest additions provide one.  A CPU is only removed
+ * if the remaining ones would stay below the add threshold, so the two
+ * decisions cannot chase each other.
+ *
+ * @note    Called on the policy thread without any locks held.
+ */
+void Console::i_cpuAutoScaleSample()
+{
+    SafeVMPtrQuiet ptrVM(this);
+    if (!ptrVM.isOk())
+        return;
+
+    MachineState_T enmMachineState;
+    {
+        AutoReadLock alock(this COMMA_LOCKVAL_SRC_POS);
+        enmMachineState = mMachineState;
+    }
+    if (enmMachineState != MachineState_Running)
+    {
+        mCpuAutoScale.cAbove = 0;
+        mCpuAutoScale.cBelow = 0;
+        return;
+    }
+
+    /*
+     * Gather the load of the online CPUs.
+     */
+    uint32_t cOnline         = 0;
+    uint32_t uPctSum         = 0;
+    VMCPUID  idHighestOnline = 0;
+    VMCPUID  idLowestOffline = NIL_VMCPUID;
+    for (VMCPUID idCpu = 0; idCpu < mCpuAutoScale.cCpus; idCpu++)
+    {
+        if (ASMBitTest(&mCpuAutoScale.bmOnline[0], (int32_t)idCpu))
+        {
+            uint8_t cPctExecuting = 0;
+            int vrc = ptrVM.vtable()->pfnTMR3GetCpuLoadPercents(ptrVM.rawUVM(), idCpu, NULL /*pcMsInterval*/,
+                                                                 &cPctExecuting, NULL /*pcPctHalted*/, NULL /*pcPctOther*/);
+            if (RT_SUCCESS(vrc))
+                uPctSum += cPctExecuting;
+            cOnline++;
+            idHighestOnline = idCpu;
+        }
+        else if (idLowestOffline == NIL_VMCPUID)
+            idLowestOffline = idCpu;
+    }
+    if (!cOnline)
+        return;
+
+    uint32_t au32Stats[2] = { 0, 0 };
+    ptrVM.vtable()->pfnSTAMR3Enum(ptrVM.rawUVM(), "/Devices/VMMDev0/StatsPage/*", i_cpuAutoScaleStatsCallback, au32Stats);
+    bool const     fHaveRunQueue = au32Stats[0] != 0;
+    uint32_t const cRunnable     = au32Stats[1];
+    ptrVM.release();
+
+    /*
+     * Decide.
+     */
+    uint32_t const uPctAvg   = uPctSum / cOnline;
+    bool const     fWantMore =    uPctAvg >= mCpuAutoScale.uPctAdd
+                               || (fHaveRunQueue && cRunnable > cOnline);
+    bool const     fWantLess =    cOnline > 1
+                               && uPctAvg <= mCpuAutoScale.uPctRemove
+                               && uPctSum / (cOnline - 1) < mCpuAutoScale.uPctAdd
+                               && (!fHaveRunQueue || cRunnable + 1 < cOnline);
+    mCpuAutoScale.cAbove = fWantMore ? mCpuAutoScale.cAbove + 1 : 0;
+    mCpuAutoScale.cBelow = fWantLess ? mCpuAutoScale.cBelow + 1 : 0;
+    if (mCpuAutoScale.cCooldown > 0)
+    {
+        mCpuAutoScale.cCooldown--;
+        return;
+    }
+
+    HRESULT hrc = S_OK;
+    if (   mCpuAutoScale.cAbove >= mCpuAutoScale.cSecsAdd
+        && cOnline < mCpuAutoScale.cCpusMax
+        && idLowestOffline != NIL_VMCPUID)
+    {
+        LogRel(("CpuAutoScale: Adding CPU %u (online %u, load %u%%, run queue %u%s)\n",
+                idLowestOffline, cOnline, uPctAvg, cRunnable, fHaveRunQueue ? "" : " n/a"));
+        hrc = mMachine->HotPlugCPU(idLowestOffline);
+    }
+    else if (   mCpuAutoScale.cBelow >= mCpuAutoScale.cSecsRemove
+             && cOnline > mCpuAutoScale.cCpusMin
+             && idHighestOnline != 0)
+    {
+        LogRel(("CpuAutoScale: Removing CPU %u (online %u, load %u%%, run queue %u%s)\n",
+                idHighestOnline, cOnline, uPctAvg, cRunnable, fHaveRunQueue ? "" : " n/a"));
+        hrc = mMachine->HotUnplugCPU(idHighestOnline);
+    }
+    else
+        return;
+
+    if (FAILED(hrc))
+        LogRel(("CpuAutoScale: Hot-plug operation failed: %Rhrc\n", hrc));
+    mCpuAutoScale.cAbove    = 0;
+    mCpuAutoScale.cBelow    = 0;
+    mCpuAutoScale.cCooldown = mCpuAutoScale.cSecsCooldown;
+}
+
 HRESULT Console::pause()
 {
     LogFlowThisFuncEnter();
@@ -5801,7 +6067,17 @@ HRESULT Console::i_onCPUChange(ULONG aCPU, BOOL aRemove)
 
     /* notify console callbacks on success */
     if (SUCCEEDED(hrc))
+    {
+        /* Keep the auto-scaler's view current, the change may have come from elsewhere. */
+        if (aCPU < VMM_MAX_CPU_COUNT)
+        {
+            if (aRemove)
+                ASMAtomicBitClear(&mCpuAutoScale.bmOnline[0], (int32_t)aCPU);
+            else
+                ASMAtomicBitSet(&mCpuAutoScale.bmOnline[0], (int32_t)aCPU);
+        }
         ::FireCPUChangedEvent(mEventSource, aCPU, aRemove);
+    }
 
     LogFlowThisFunc(("Leaving hrc=%#x\n", hrc));
     return hrc;
@@ -8459,6 +8735,30 @@ HRESULT Console::i_consoleInitReleaseLog(const ComPtr<IMachine> aMachine)
     else
 #endif
     {
+        /*
+         * Optionally move the file writes off the logging threads (EMTs and
+         * I/O workers) onto a writer thread.  The logger lives until the
+         * process terminates, so the async output instance is only destroyed
+         * when the logger could not be created.
+         */
+        RTLOGASYNCOUTPUT hLogAsync   = NIL_RTLOGASYNCOUTPUT;
+        int              vrcLogAsync = VERR_NOT_FOUND;
+        Bstr bstrLogAsync;
+        HRESULT hrc2 = aMachine->GetExtraData(Bstr("VBoxInternal2/ReleaseLogAsync").raw(), bstrLogAsync.asOutParam());
+        if (SUCCEEDED(hrc2) && bstrLogAsync == "1")
+        {
+            Bstr bstrLogRateLimit;
+            aMachine->GetExtraData(Bstr("VBoxInternal2/ReleaseLogAsyncRateLimit").raw(), bstrLogRateLimit.asOutParam());
+            uint32_t const cbMaxPerSec = bstrLogRateLimit.isNotEmpty() ? Utf8Str(bstrLogRateLimit).toUInt32() : 0;
+
+            vrcLogAsync = RTLogAsyncOutputCreate(&hLogAsync, pLogOutputIf, pvLogOutputUser, 0 /*cbBuffer*/, cbMaxPerSec);
+            if (RT_SUCCESS(vrcLogAsync))
+            {
+                pLogOutputIf    = RTLogAsyncOutputGetIf();
+                pvLogOutputUser = hLogAsync;
+            }
+        }
+
         RTERRINFOSTATIC ErrInfo;
          vrc = com::VBoxLogRelCreateEx("VM", logFile.c_str(),
                                        RTLOGFLAGS_PREFIX_TIME_PROG | RTLOGFLAGS_RESTRICT_GROUPS,
@@ -8470,7 +8770,14 @@ HRESULT Console::i_consoleInitReleaseLog(const ComPtr<IMachine> aMachine)
                                        pLogOutputIf, pvLogOutputUser,
                                        RTErrInfoInitStatic(&ErrInfo));
         if (RT_FAILURE(vrc))
+        {
+            RTLogAsyncOutputDestroy(hLogAsync);
             hrc = setErrorBoth(E_FAIL, vrc, tr("Failed to open release log (%s, %Rrc)"), ErrInfo.Core.pszMsg, vrc);
+        }
+        else if (RT_SUCCESS(vrcLogAsync))
+            LogRel(("Console: Release log is written asynchronously\n"));
+        else if (vrcLogAsync != VERR_NOT_FOUND)
+            LogRel(("Console: Failed to set up asynchronous release logging (%Rrc), writing synchronously\n", vrcLogAsync));
     }
 
     /* If we've made any directory changes, flush the directory to increase
@@ -9100,6 +9407,14 @@ HRESULT Console::i_powerDown(IProgress *aProgress /*= NULL*/)
         alock.acquire();
     }
 
+    /* Stop the CPU auto-scaler before it can start any further hot-plug operation. */
+    if (mCpuAutoScale.hThread != NIL_RTTHREAD)
+    {
+        alock.release();
+        i_cpuAutoScaleStop();
+        alock.acquire();
+    }
+
     /* advance percent count */
     if (pProgressControl)
         pProgressControl->SetCurrentOperationProgress(99 * (++step) / StepCount);
@@ -10630,6 +10945,20 @@ HRESULT Console::i_attachToTapInterface(INetworkAdapter *networkAdapter)
             Utf8Str str(tapDeviceName);
             RTStrCopy(IfReq.ifr_name, sizeof(IfReq.ifr_name), str.c_str()); /** @todo bitch about names which are too long... */
             IfReq.ifr_flags = IFF_TAP | IFF_NO_PI;
+            /* Handing a virtio-net device over to vhost-net needs the virtio-net header
+               (DrvTAP then also passes segmentation offload frames thru as they are).
+               Only do it when asked to, it changes the frame format on the device. */
+            NetworkAdapterType_T enmAdapterType = NetworkAdapterType_Null;
+            networkAdapter->COMGETTER(AdapterType)(&enmAdapterType);
+            if (enmAdapterType == NetworkAdapterType_Virtio)
+            {
+                Bstr bstrVHostNet;
+                mMachine->GetExtraData(BstrFmt("VBoxInternal/Devices/virtio-net/%u/Config/VHostNet", slot).raw(),
+                                       bstrVHostNet.asOutParam());
+                Utf8Str const strVHostNet(bstrVHostNet);
+                if (strVHostNet.isNotEmpty() && strVHostNet != "0")
+                    IfReq.ifr_flags |= IFF_VNET_HDR;
+            }
             vrc = ioctl(RTFileToNative(maTapFD[slot]), TUNSETIFF, &IfReq);
             if (vrc != 0)
             {
@@ -11618,6 +11947,9 @@ void Console::i_powerUpThreadTask(VMPowerUpTask *pTask)
                 alock.release();
                 pVMM->pfnVMR3AtErrorDeregister(pConsole->mpUVM, Console::i_genericVMSetErrorCallback, &pTask->mErrorMsg);
                 /** @todo register another VMSetError callback? */
+
+                /* Start the load driven CPU hot-plugging policy if configured. */
+                pConsole->i_cpuAutoScaleStart(pMachine);
                 alock.acquire();
             }
         }
@@ -69,7 +69,9 @@
 #include <iprt/buildconfig.h>
 #include <iprt/ctype.h>
 #include <iprt/dir.h>
+#include <iprt/env.h>
 #include <iprt/file.h>
+#include <iprt/ldr.h>
 #include <iprt/param.h>
 #include <iprt/path.h>
 #include <iprt/string.h>
@@ -643,7 +645,8 @@ void Console::i_configAudioDriver(IVirtualBox *pVirtualBox, IMachine *pMachine,
 
 #if defined(RT_OS_WINDOWS) || defined(RT_OS_LINUX)
     if (   strcmp(pszDrvName, "HostAudioWas") == 0
-        || strcmp(pszDrvName, "PulseAudio") == 0)
+        || strcmp(pszDrvName, "PulseAudio") == 0
+        || strcmp(pszDrvName, "PipeWireAudio") == 0)
     {
         Bstr bstrTmp;
         HRESULT hrc = pMachine->COMGETTER(Name)(bstrTmp.asOutParam());                          H();
@@ -1797,6 +1800,15 @@ int Console::i_configMedium(PCFGMNODE pLunL0,
                 if (fSetupMerge)
                 {
                     InsertConfigInteger(pCfg, "SetupMerge", 1);
+
+                    /* Optional rate limit (bytes per second) for online merges, so that
+                     * snapshot deletion doesn't starve the guest of disk bandwidth. */
+                    Bstr bstrMergeRate;
+                    hrc = mMachine->GetExtraData(Bstr("VBoxInternal2/OnlineMergeRate").raw(), bstrMergeRate.asOutParam()); H();
+                    uint64_t const cbMergeRate = Utf8Str(bstrMergeRate).toUInt64();
+                    if (cbMergeRate)
+                        InsertConfigInteger(pCfg, "MergeRate", cbMergeRate);
+
                     if (uImage == uMergeSource)
                         InsertConfigInteger(pCfg, "MergeSource", 1);
                     else if (uImage == uMergeTarget)
@@ -1812,6 +1824,48 @@ int Console::i_configMedium(PCFGMNODE pLunL0,
                 if (fNonRotational)
                     InsertConfigInteger(pCfg, "NonRotationalMedium", 1);
 
+                /*
+                 * Cache image on fast local storage, configured with properties of the
+                 * base medium so it survives taking snapshots. Only harddisks are
+                 * written often enough to benefit.
+                 */
+                if (enmType == DeviceType_HardDisk)
+                {
+                    ComPtr<IMedium> ptrBase;
+                    hrc = ptrMedium->COMGETTER(Base)(ptrBase.asOutParam());                H();
+
+                    Bstr bstrCachePath;
+                    hrc = ptrBase->GetProperty(Bstr("Special/Cache/Path").raw(), bstrCachePath.asOutParam());
+                    if (SUCCEEDED(hrc) && bstrCachePath.isNotEmpty())
+                    {
+                        InsertConfigString(pCfg, "CachePath", bstrCachePath);
+
+                        Bstr bstrCacheValue;
+                        hrc = ptrBase->GetProperty(Bstr("Special/Cache/Format").raw(), bstrCacheValue.asOutParam());
+                        if (SUCCEEDED(hrc) && bstrCacheValue.isNotEmpty())
+                            InsertConfigString(pCfg, "CacheFormat", bstrCacheValue);
+                        else
+                            InsertConfigString(pCfg, "CacheFormat", "VCI");
+
+                        hrc = ptrBase->GetProperty(Bstr("Special/Cache/Mode").raw(), bstrCacheValue.asOutParam());
+                        if (SUCCEEDED(hrc) && bstrCacheValue.isNotEmpty())
+                            InsertConfigString(pCfg, "CacheMode", bstrCacheValue);
+
+                        hrc = ptrBase->GetProperty(Bstr("Special/Cache/Size").raw(), bstrCacheValue.asOutParam());
+                        if (SUCCEEDED(hrc) && bstrCacheValue.isNotEmpty())
+                        {
+                            uint64_t cbCache = 0;
+                            int vrc2 = RTStrToUInt64Full(Utf8Str(bstrCacheValue).c_str(), 0, &cbCache);
+                            if (vrc2 == VINF_SUCCESS)
+                                InsertConfigInteger(pCfg, "CacheSize", cbCache);
+                            else
+                                LogRel(("Console: Ignoring invalid medium property Special/Cache/Size '%ls'\n",
+                                        bstrCacheValue.raw()));
+                        }
+                    }
+                    hrc = S_OK;
+                }
+
                 /* Pass all custom parameters. */
                 bool fHostIP = true;
                 bool fEncrypted = false;
@@ -3517,6 +3571,32 @@ int Console::i_configPdm(ComPtr<IMachine> pMachine, PCVMMR3VTABLE pVMM, PUVM pUV
         LONG64 cMaxBytesPerSec = 0;
         hrc = bwGroups[i]->COMGETTER(MaxBytesPerSec)(&cMaxBytesPerSec);                 H();
 
+        /*
+         * Optional QoS tweaks not covered by the API yet, from the machine extra data:
+         *      VBoxInternal2/BwGroups/<name>/Parent      - Name of the parent group, the group's traffic is
+         *                                                  limited by the parent (and its parents) as well.
+         *      VBoxInternal2/BwGroups/<name>/Burst       - Burst allowance in bytes.
+         *      VBoxInternal2/BwGroups/<name>/MaxIops     - Requests per second limit (disk groups).
+         *      VBoxInternal2/BwGroups/<name>/IopsBurst   - Burst allowance in requests (disk groups).
+         *      VBoxInternal2/BwGroups/<name>/MaxPackets  - Packets per second limit (network groups).
+         */
+        Utf8Str const strBwGroupKey = Utf8StrFmt("VBoxInternal2/BwGroups/%ls/", strName.raw());
+        Bstr bstrParent;
+        hrc = pMachine->GetExtraData(Bstr(Utf8StrFmt("%sParent", strBwGroupKey.c_str())).raw(), bstrParent.asOutParam()); H();
+        static const char * const s_apszNumKeys[] = { "Burst", "MaxIops", "IopsBurst", "MaxPackets" };
+        uint64_t au64Values[RT_ELEMENTS(s_apszNumKeys)] = { 0, 0, 0, 0 };
+        for (size_t iKey = 0; iKey < RT_ELEMENTS(s_apszNumKeys); iKey++)
+        {
+            Bstr bstrValue;
+            hrc = pMachine->GetExtraData(Bstr(Utf8StrFmt("%s%s", strBwGroupKey.c_str(), s_apszNumKeys[iKey])).raw(),
+                                         bstrValue.asOutParam());                                H();
+            if (   bstrValue.isNotEmpty()
+                && RTStrToUInt64Full(Utf8Str(bstrValue).c_str(), 0, &au64Values[iKey]) != VINF_SUCCESS)
+                return pVMM->pfnVMR3SetError(pUVM, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                                             N_("Invalid value '%ls' for '%s%s'"),
+                                             bstrValue.raw(), strBwGroupKey.c_str(), s_apszNumKeys[iKey]);
+        }
+
         if (enmType == BandwidthGroupType_Disk)
         {
             PCFGMNODE pBwGroup;
@@ -3524,6 +3604,14 @@ int Console::i_configPdm(ComPtr<IMachine> pMachine, PCVMMR3VTABLE pVMM, PUVM pUV
             InsertConfigInteger(pBwGroup, "Max", cMaxBytesPerSec);
             InsertConfigInteger(pBwGroup, "Start", cMaxBytesPerSec);
             InsertConfigInteger(pBwGroup, "Step", 0);
+            if (bstrParent.isNotEmpty())
+                InsertConfigString(pBwGroup, "Parent", bstrParent);
+            if (au64Values[0])
+                InsertConfigInteger(pBwGroup, "Burst", au64Values[0]);
+            if (au64Values[1])
+                InsertConfigInteger(pBwGroup, "MaxIops", au64Values[1]);
+            if (au64Values[2])
+                InsertConfigInteger(pBwGroup, "IopsBurst", au64Values[2]);
         }
 #ifdef VBOX_WITH_NETSHAPER
         else if (enmType == BandwidthGroupType_Network)
@@ -3532,10 +3620,39 @@ int Console::i_configPdm(ComPtr<IMachine> pMachine, PCVMMR3VTABLE pVMM, PUVM pUV
             PCFGMNODE pBwGroup;
             InsertConfigNode(pNetworkBwGroups, Utf8Str(strName).c_str(), &pBwGroup);
             InsertConfigInteger(pBwGroup, "Max", cMaxBytesPerSec);
+            if (bstrParent.isNotEmpty())
+                InsertConfigString(pBwGroup, "Parent", bstrParent);
+            if (au64Values[0])
+                InsertConfigInteger(pBwGroup, "Burst", RT_MIN(au64Values[0], UINT32_MAX));
+            if (au64Values[3])
+                InsertConfigInteger(pBwGroup, "MaxPackets", au64Values[3]);
         }
 #endif /* VBOX_WITH_NETSHAPER */
     }
 
+    /*
+     * I/O thread placement.  The worker threads of all devices go to the host
+     * CPUs given by the machine extra data, keeping them off the vCPU cores:
+     *      VBoxInternal2/IoThreads/Affinity  - Host CPU list, e.g. "8-11".
+     *      VBoxInternal2/IoThreads/Spread    - Bind each thread to a single CPU of the list.
+     */
+    Bstr bstrIoThreadAffinity;
+    hrc = pMachine->GetExtraData(Bstr("VBoxInternal2/IoThreads/Affinity").raw(), bstrIoThreadAffinity.asOutParam()); H();
+    if (bstrIoThreadAffinity.isNotEmpty())
+    {
+        PCFGMNODE pIoThreads;
+        InsertConfigNode(pPDM, "IoThreads", &pIoThreads);
+        PCFGMNODE pIoThreadGroup;
+        InsertConfigNode(pIoThreads, "Default", &pIoThreadGroup);
+        InsertConfigString(pIoThreadGroup, "Affinity", bstrIoThreadAffinity);
+
+        Bstr bstrIoThreadSpread;
+        hrc = pMachine->GetExtraData(Bstr("VBoxInternal2/IoThreads/Spread").raw(), bstrIoThreadSpread.asOutParam()); H();
+        Utf8Str const strIoThreadSpread(bstrIoThreadSpread);
+        if (strIoThreadSpread.equalsIgnoreCase("true") || strIoThreadSpread.equalsIgnoreCase("1"))
+            InsertConfigInteger(pIoThreadGroup, "Spread", 1);
+    }
+
     /** @todo r=aeichner Looks like this setting is completely unused in VMM/PDM. */
     BOOL fAllowTracingToAccessVM;
     hrc = pMachine->COMGETTER(AllowTracingToAccessVM)(&fAllowTracingToAccessVM);        H();
@@ -3809,8 +3926,39 @@ int Console::i_configAudioCtrl(ComPtr<IVirtualBox> pVBox, ComPtr<IMachine> pMach
 #endif
 #ifdef VBOX_WITH_AUDIO_PULSE
                 case AudioDriverType_Pulse:
+# ifdef VBOX_WITH_AUDIO_PIPEWIRE
+                {
+                    /* Talk to PipeWire natively rather than through its PulseAudio compatibility
+                       layer if the server is running and the client library is around.
+
+                       Set extradata value "VBoxInternal2/Audio/LinuxDrv" "pulse" to not use PipeWire. */
+                    GetExtraDataBoth(pVBox, pMachine, "VBoxInternal2/Audio/LinuxDrv", &strTmp); H();
+                    if (   strTmp.isEmpty()
+                        || strTmp.equalsIgnoreCase("pipewire"))
+                    {
+                        char        szPath[RTPATH_MAX];
+                        const char *pszRuntimeDir = RTEnvGet("PIPEWIRE_RUNTIME_DIR");
+                        if (!pszRuntimeDir)
+                            pszRuntimeDir = RTEnvGet("XDG_RUNTIME_DIR");
+                        RTLDRMOD    hLdrMod = NIL_RTLDRMOD;
+                        if (   pszRuntimeDir
+                            && RT_SUCCESS(RTPathJoin(szPath, sizeof(szPath), pszRuntimeDir, "pipewire-0"))
+                            && RTPathExists(szPath)
+                            && RT_SUCCESS(RTLdrLoadSystem("libpipewire-0.3.so.0", true /*fNoUnload*/, &hLdrMod)))
+                        {
+                            RTLdrClose(hLdrMod);
+                            LogRel(("Audio: Using native PipeWire backend instead of PulseAudio\n"));
+                            pszAudioDriver = "PipeWireAudio";
+                            break;
+                        }
+                    }
                     pszAudioDriver = "PulseAudio";
                     break;
+                }
+# else
+                    pszAudioDriver = "PulseAudio";
+                    break;
+# endif
 #endif
 #ifdef RT_OS_DARWIN
                 case AudioDriverType_CoreAudio:
@@ -42,6 +42,7 @@
 
 #include <iprt/asm.h>
 #include <iprt/err.h>
+#include <iprt/mem.h>
 #include <iprt/rand.h>
 #include <iprt/socket.h>
 #include <iprt/tcp.h>
@@ -51,11 +52,23 @@
 #include <VBox/vmm/ssm.h>
 #include <VBox/vmm/vmmr3vtable.h>
 #include <VBox/err.h>
+#include <VBox/param.h>
 #include <VBox/version.h>
 #include <VBox/com/string.h>
 #include "VBox/com/ErrorInfo.h"
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** The max number of parallel TCP connections the SSM stream can be striped
+ * across. */
+#define TELEPORTER_MAX_STREAMS      16
+/** The max number of pages the source serves per post-copy request.
+ * Matches what PGMR3PhysPostCopyRead accepts. */
+#define TELEPORTER_POST_COPY_MAX_PAGES  64
+
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
@@ -82,6 +95,13 @@ public:
     bool volatile       mfStopReading;
     bool volatile       mfEndOfStream;
     bool volatile       mfIOError;
+    /** The number of TCP connections the stream is striped across, 1 if only
+     *  mhSocket is used. */
+    uint32_t            mcStreams;
+    /** The stream the next block goes thru / comes from. */
+    uint32_t            miStream;
+    /** The sockets of the additional streams, index 0 is unused (mhSocket). */
+    RTSOCKET            mahStreams[TELEPORTER_MAX_STREAMS];
     /** @} */
 
     TeleporterState(Console *pConsole, PUVM pUVM, PCVMMR3VTABLE pVMM, Progress *pProgress, bool fIsSource)
@@ -96,7 +116,11 @@ public:
         , mfStopReading(false)
         , mfEndOfStream(false)
         , mfIOError(false)
+        , mcStreams(1)
+        , miStream(0)
     {
+        for (unsigned i = 0; i < RT_ELEMENTS(mahStreams); i++)
+            mahStreams[i] = NIL_RTSOCKET;
         pVMM->pfnVMR3RetainUVM(mpUVM);
     }
 
@@ -121,6 +145,10 @@ public:
     MachineState_T      menmOldMachineState;
     bool                mfSuspendedByUs;
     bool                mfUnlockedMedia;
+    /** Whether to do post-copy teleportation. */
+    bool                mfPostCopy;
+    /** The connection the target fetches RAM pages over in post-copy mode. */
+    RTSOCKET            mhPostCopySocket;
 
     TeleporterStateSrc(Console *pConsole, PUVM pUVM, PCVMMR3VTABLE pVMM, Progress *pProgress, MachineState_T enmOldMachineState)
         : TeleporterState(pConsole, pUVM, pVMM, pProgress, true /*fIsSource*/)
@@ -129,6 +157,8 @@ public:
         , menmOldMachineState(enmOldMachineState)
         , mfSuspendedByUs(false)
         , mfUnlockedMedia(false)
+        , mfPostCopy(false)
+        , mhPostCopySocket(NIL_RTSOCKET)
     {
     }
 };
@@ -143,8 +173,12 @@ public:
     IMachine                   *mpMachine;
     IInternalMachineControl    *mpControl;
     PRTTCPSERVER                mhServer;
+    Utf8Str                     mstrAddress;
     PRTTIMERLR                  mphTimerLR;
     bool                        mfLockedMedia;
+    /** Set while a post-copy fetcher is registered but not yet handed to PGM
+     *  by a successful load. */
+    bool                        mfPostCopy;
     int                         mRc;
     Utf8Str                     mErrorText;
 
@@ -157,6 +191,7 @@ public:
         , mhServer(NULL)
         , mphTimerLR(phTimerLR)
         , mfLockedMedia(false)
+        , mfPostCopy(false)
         , mRc(VINF_SUCCESS)
         , mErrorText()
     {
@@ -165,6 +200,31 @@ public:
 };
 
 
+/**
+ * Post-copy page fetcher state on the target, owned by PGM once registered.
+ */
+class TeleporterPostCopy
+{
+public:
+    /** The connection to the source. */
+    RTSOCKET            hSocket;
+    /** Sticky failure status. */
+    int                 rc;
+    /** Statistics: number of requests. */
+    uint64_t            cRequests;
+    /** Statistics: number of pages fetched. */
+    uint64_t            cPagesFetched;
+
+    TeleporterPostCopy(RTSOCKET a_hSocket)
+        : hSocket(a_hSocket)
+        , rc(VINF_SUCCESS)
+        , cRequests(0)
+        , cPagesFetched(0)
+    {
+    }
+};
+
+
 /**
  * TCP stream header.
  *
@@ -185,6 +245,66 @@ typedef struct TELEPORTERTCPHDR
 /** The max block size. */
 #define TELEPORTERTCPHDR_MAX_SIZE    UINT32_C(0x00fffff8)
 
+/*
+ * Multiple streams.
+ *
+ * When the source asks for it with the "streams=N" command, the target opens
+ * a second listener on a random port and replies with "port=P;cookie=C" after
+ * the command ACK.  The source then makes N-1 more connections to it, sends
+ * the cookie on each and waits for a second ACK.  From then on the blocks of
+ * the SSM stream (TELEPORTERTCPHDR + data) are dealt out round robin across
+ * mhSocket and the additional connections, starting with mhSocket.  Since
+ * both sides follow the same order and TCP keeps each connection in order, no
+ * sequence numbers are needed.  The commands, ACKs and NACKs only ever travel
+ * over mhSocket.
+ */
+
+/**
+ * Post-copy page request, sent by the target.
+ *
+ * The source replies with a TELEPORTERPOSTCOPYREPLY followed by the page
+ * content if successful.  A zero cPages request ends the post-copy phase.
+ */
+typedef struct TELEPORTERPOSTCOPYREQ
+{
+    /** Magic value (TELEPORTERPOSTCOPYREQ_MAGIC). */
+    uint32_t    u32Magic;
+    /** The number of pages, 0 when done. */
+    uint32_t    cPages;
+    /** The guest physical address of the first page. */
+    uint64_t    GCPhys;
+} TELEPORTERPOSTCOPYREQ;
+/** Magic value for TELEPORTERPOSTCOPYREQ::u32Magic and
+ * TELEPORTERPOSTCOPYREPLY::u32Magic. (Hermeto Pascoal) */
+#define TELEPORTERPOSTCOPYREQ_MAGIC  UINT32_C(0x19360622)
+
+/**
+ * Post-copy page reply header, sent by the source.
+ */
+typedef struct TELEPORTERPOSTCOPYREPLY
+{
+    /** Magic value (TELEPORTERPOSTCOPYREQ_MAGIC). */
+    uint32_t    u32Magic;
+    /** The status code.  Page data only follows on success. */
+    int32_t     rc;
+} TELEPORTERPOSTCOPYREPLY;
+
+/*
+ * Post-copy.
+ *
+ * When the source asks for it with the "post-copy" command, the target sets
+ * up one additional connection the same way as for "streams=N".  The final
+ * live pass then leaves the dirty RAM pages out of the saved state, and once
+ * the target has been handed the VM it fetches them over this connection as
+ * the guest touches them, while a background prefetcher in PGM pulls in the
+ * rest.  The source stays suspended serving the requests until the target
+ * sends a zero cPages request, then powers off as usual.
+ *
+ * A target which can't do post-copy (PGM can't trap the guest accesses with
+ * NEM) answers the command with NACK=VERR_NOT_SUPPORTED and carries on, the
+ * source then falls back on a plain live teleportation.
+ */
+
 
 /*********************************************************************************************************************************
 *   Global Variables                                                                                                             *
@@ -192,6 +312,52 @@ typedef struct TELEPORTERTCPHDR
 static const char g_szWelcome[] = "VirtualBox-Teleporter-1.0\n";
 
 
+/**
+ * Gets the socket of the stream the next block goes thru.
+ *
+ * @returns Socket handle.
+ * @param   pState      The teleporter state structure.
+ */
+DECLINLINE(RTSOCKET) teleporterTcpCurSocket(TeleporterState *pState)
+{
+    return pState->miStream == 0 ? pState->mhSocket : pState->mahStreams[pState->miStream];
+}
+
+
+/**
+ * Moves on to the next stream after a block has been completely written or
+ * read.
+ *
+ * @param   pState      The teleporter state structure.
+ */
+DECLINLINE(void) teleporterTcpNextStream(TeleporterState *pState)
+{
+    if (++pState->miStream >= pState->mcStreams)
+        pState->miStream = 0;
+}
+
+
+/**
+ * Closes the additional stream connections, if any.
+ *
+ * @param   pState      The teleporter state structure.
+ */
+static void teleporterTcpCloseStreams(TeleporterState *pState)
+{
+    for (uint32_t i = 1; i < RT_ELEMENTS(pState->mahStreams); i++)
+        if (pState->mahStreams[i] != NIL_RTSOCKET)
+        {
+            if (pState->mfIsSource)
+                RTTcpClientClose(pState->mahStreams[i]);
+            else
+                RTTcpServerDisconnectClient2(pState->mahStreams[i]);
+            pState->mahStreams[i] = NIL_RTSOCKET;
+        }
+    pState->mcStreams = 1;
+    pState->miStream  = 0;
+}
+
+
 /**
  * Reads a string from the socket.
  *
@@ -320,6 +486,147 @@ HRESULT Console::i_teleporterSrcSubmitCommand(TeleporterStateSrc *pState, const
 }
 
 
+/**
+ * Submits a command that makes the target accept additional connections and
+ * makes them, see "streams=N" and "post-copy".
+ *
+ * @returns S_OK on success, S_FALSE if the target declined the command with
+ *          NACK=VERR_NOT_SUPPORTED, E_FAIL+setError() on failure.
+ *
+ * @param   pState              The teleporter source state.
+ * @param   pszCommand          The command.
+ * @param   cSockets            The number of connections to make.
+ * @param   pahSockets          Where to return the connections.  The caller
+ *                              cleans them up, also on failure.
+ *
+ * @remarks the setError laziness forces this to be a Console member.
+ */
+HRESULT Console::i_teleporterSrcConnectExtra(TeleporterStateSrc *pState, const char *pszCommand, uint32_t cSockets,
+                                             PRTSOCKET pahSockets)
+{
+    HRESULT hrc = i_teleporterSrcSubmitCommand(pState, pszCommand, false /*fWaitForAck*/);
+    if (FAILED(hrc))
+        return hrc;
+
+    /* ACK or NACK=<rc> */
+    char szLine[128];
+    int vrc = teleporterTcpReadLine(pState, szLine, sizeof(szLine));
+    if (RT_FAILURE(vrc))
+        return setErrorBoth(E_FAIL, vrc, tr("Failed reading ACK(%s): %Rrc"), pszCommand, vrc);
+    if (strcmp(szLine, "ACK"))
+    {
+        int32_t vrc2 = VERR_GENERAL_FAILURE;
+        if (   !strncmp(szLine, RT_STR_TUPLE("NACK="))
+            && RTStrToInt32Full(&szLine[sizeof("NACK=") - 1], 10, &vrc2) == VINF_SUCCESS
+            && vrc2 == VERR_NOT_SUPPORTED)
+        {
+            LogRel(("Teleporter: The target declined '%s'\n", pszCommand));
+            return S_FALSE;
+        }
+        LogRel(("Teleporter: %s: '%s'\n", pszCommand, szLine));
+        return setError(E_FAIL, tr("NACK(%s) - '%s'"), pszCommand, szLine);
+    }
+
+    /* port=<port>;cookie=<cookie> */
+    vrc = teleporterTcpReadLine(pState, szLine, sizeof(szLine));
+    if (RT_FAILURE(vrc))
+        return setErrorBoth(E_FAIL, vrc, tr("Failed reading the port for '%s': %Rrc"), pszCommand, vrc);
+    char    *pszCookie = strchr(szLine, ';');
+    uint32_t uPort     = 0;
+    if (   strncmp(szLine, RT_STR_TUPLE("port="))
+        || !pszCookie
+        || strncmp(pszCookie + 1, RT_STR_TUPLE("cookie="))
+        || strlen(pszCookie + 1 + sizeof("cookie=") - 1) != 16)
+        return setError(E_FAIL, tr("Unexpected port reply '%s'"), szLine);
+    *pszCookie = '\0';
+    pszCookie += 1 + sizeof("cookie=") - 1;
+    vrc = RTStrToUInt32Full(&szLine[sizeof("port=") - 1], 10, &uPort);
+    if (vrc != VINF_SUCCESS || !uPort || uPort > 65535)
+        return setError(E_FAIL, tr("Unexpected port '%s'"), &szLine[sizeof("port=") - 1]);
+
+    /*
+     * Connect and identify the connections using the cookie.
+     */
+    for (uint32_t iSocket = 0; iSocket < cSockets; iSocket++)
+    {
+        RTSOCKET hSocket;
+        vrc = RTTcpClientConnect(pState->mstrHostname.c_str(), uPort, &hSocket);
+        if (RT_FAILURE(vrc))
+            return setErrorBoth(E_FAIL, vrc, tr("Failed to make connection #%u to port %u on '%s': %Rrc"),
+                                iSocket, uPort, pState->mstrHostname.c_str(), vrc);
+        pahSockets[iSocket] = hSocket;
+
+        vrc = RTTcpSetSendCoalescing(hSocket, false /*fEnable*/);
+        AssertRC(vrc);
+        vrc = RTTcpSgWriteL(hSocket, 2, pszCookie, (size_t)16, "\n", sizeof("\n") - 1);
+        if (RT_FAILURE(vrc))
+            return setErrorBoth(E_FAIL, vrc, tr("Failed to identify connection #%u: %Rrc"), iSocket, vrc);
+    }
+
+    return i_teleporterSrcReadACK(pState, pszCommand);
+}
+
+
+/**
+ * Serves the post-copy page requests of the target until it's done.
+ *
+ * @returns S_OK on success, E_FAIL+setError() on failure.
+ *
+ * @param   pState              The teleporter source state.
+ *
+ * @remarks the setError laziness forces this to be a Console member.
+ */
+HRESULT Console::i_teleporterSrcServePostCopy(TeleporterStateSrc *pState)
+{
+    size_t const cbBuf = TELEPORTER_POST_COPY_MAX_PAGES * GUEST_PAGE_SIZE;
+    void        *pvBuf = RTMemPageAlloc(cbBuf);
+    if (!pvBuf)
+        return E_OUTOFMEMORY;
+
+    uint64_t cRequests = 0;
+    uint64_t cPages    = 0;
+    int      vrc;
+    for (;;)
+    {
+        TELEPORTERPOSTCOPYREQ Req;
+        vrc = RTTcpRead(pState->mhPostCopySocket, &Req, sizeof(Req), NULL);
+        if (RT_FAILURE(vrc))
+            break;
+        if (Req.u32Magic != TELEPORTERPOSTCOPYREQ_MAGIC)
+        {
+            vrc = VERR_INVALID_MAGIC;
+            break;
+        }
+        if (!Req.cPages)
+            break;
+
+        TELEPORTERPOSTCOPYREPLY Reply;
+        Reply.u32Magic = TELEPORTERPOSTCOPYREQ_MAGIC;
+        if (Req.cPages <= TELEPORTER_POST_COPY_MAX_PAGES)
+            Reply.rc = pState->mpVMM->pfnPGMR3PhysPostCopyRead(pState->mpUVM, Req.GCPhys, pvBuf, Req.cPages);
+        else
+            Reply.rc = VERR_OUT_OF_RANGE;
+        if (RT_SUCCESS(Reply.rc))
+            vrc = RTTcpSgWriteL(pState->mhPostCopySocket, 2, &Reply, sizeof(Reply), pvBuf, (size_t)Req.cPages * GUEST_PAGE_SIZE);
+        else
+        {
+            LogRel(("Teleporter: Post-copy: failed to read %u pages at %RX64: %Rrc\n", Req.cPages, Req.GCPhys, Reply.rc));
+            vrc = RTTcpWrite(pState->mhPostCopySocket, &Reply, sizeof(Reply));
+        }
+        if (RT_FAILURE(vrc))
+            break;
+        cRequests++;
+        cPages += Req.cPages;
+    }
+    RTMemPageFree(pvBuf, cbBuf);
+
+    LogRel(("Teleporter: Post-copy: served %RU64 pages on %RU64 requests (%Rrc)\n", cPages, cRequests, vrc));
+    if (RT_FAILURE(vrc))
+        return setErrorBoth(E_FAIL, vrc, tr("Post-copy connection failed: %Rrc"), vrc);
+    return S_OK;
+}
+
+
 /**
  * @copydoc SSMSTRMOPS::pfnWrite
  */
@@ -337,13 +644,14 @@ static DECLCALLBACK(int) teleporterTcpOpWrite(void *pvUser, uint64_t offStream,
         TELEPORTERTCPHDR Hdr;
         Hdr.u32Magic = TELEPORTERTCPHDR_MAGIC;
         Hdr.cb       = RT_MIN((uint32_t)cbToWrite, TELEPORTERTCPHDR_MAX_SIZE);
-        int vrc = RTTcpSgWriteL(pState->mhSocket, 2, &Hdr, sizeof(Hdr), pvBuf, (size_t)Hdr.cb);
+        int vrc = RTTcpSgWriteL(teleporterTcpCurSocket(pState), 2, &Hdr, sizeof(Hdr), pvBuf, (size_t)Hdr.cb);
         if (RT_FAILURE(vrc))
         {
-            LogRel(("Teleporter/TCP: Write error: %Rrc (cb=%#x)\n", vrc, Hdr.cb));
+            LogRel(("Teleporter/TCP: Write error: %Rrc (cb=%#x, stream #%u)\n", vrc, Hdr.cb, pState->miStream));
             return vrc;
         }
         pState->moffStream += Hdr.cb;
+        teleporterTcpNextStream(pState);
         if (Hdr.cb == cbToWrite)
             return VINF_SUCCESS;
 
@@ -370,7 +678,7 @@ static int teleporterTcpReadSelect(TeleporterState *pState)
     int vrc;
     do
     {
-        vrc = RTTcpSelectOne(pState->mhSocket, 1000);
+        vrc = RTTcpSelectOne(teleporterTcpCurSocket(pState), 1000);
         if (RT_FAILURE(vrc) && vrc != VERR_TIMEOUT)
         {
             pState->mfIOError = true;
@@ -420,7 +728,7 @@ static DECLCALLBACK(int) teleporterTcpOpRead(void *pvUser, uint64_t offStream, v
             if (RT_FAILURE(vrc))
                 return vrc;
             TELEPORTERTCPHDR Hdr;
-            vrc = RTTcpRead(pState->mhSocket, &Hdr, sizeof(Hdr), NULL);
+            vrc = RTTcpRead(teleporterTcpCurSocket(pState), &Hdr, sizeof(Hdr), NULL);
             if (RT_FAILURE(vrc))
             {
                 pState->mfIOError = true;
@@ -458,11 +766,11 @@ static DECLCALLBACK(int) teleporterTcpOpRead(void *pvUser, uint64_t offStream, v
         if (RT_FAILURE(vrc))
             return vrc;
         uint32_t cb = (uint32_t)RT_MIN(pState->mcbReadBlock, cbToRead);
-        vrc = RTTcpRead(pState->mhSocket, pvBuf, cb, pcbRead);
+        vrc = RTTcpRead(teleporterTcpCurSocket(pState), pvBuf, cb, pcbRead);
         if (RT_FAILURE(vrc))
         {
             pState->mfIOError = true;
-            LogRel(("Teleporter/TCP: Data read error: %Rrc (cb=%#x)\n", vrc, cb));
+            LogRel(("Teleporter/TCP: Data read error: %Rrc (cb=%#x, stream #%u)\n", vrc, cb, pState->miStream));
             return vrc;
         }
         if (pcbRead)
@@ -470,10 +778,14 @@ static DECLCALLBACK(int) teleporterTcpOpRead(void *pvUser, uint64_t offStream, v
             cb = (uint32_t)*pcbRead;
             pState->moffStream   += cb;
             pState->mcbReadBlock -= cb;
+            if (!pState->mcbReadBlock)
+                teleporterTcpNextStream(pState);
             return VINF_SUCCESS;
         }
         pState->moffStream   += cb;
         pState->mcbReadBlock -= cb;
+        if (!pState->mcbReadBlock)
+            teleporterTcpNextStream(pState);
         if (cbToRead == cb)
             return VINF_SUCCESS;
 
@@ -554,7 +866,7 @@ static DECLCALLBACK(int) teleporterTcpOpClose(void *pvUser, bool fCancelled)
         TELEPORTERTCPHDR EofHdr;
         EofHdr.u32Magic = TELEPORTERTCPHDR_MAGIC;
         EofHdr.cb       = fCancelled ? UINT32_MAX : 0;
-        int vrc = RTTcpWrite(pState->mhSocket, &EofHdr, sizeof(EofHdr));
+        int vrc = RTTcpWrite(teleporterTcpCurSocket(pState), &EofHdr, sizeof(EofHdr));
         if (RT_FAILURE(vrc))
         {
             LogRel(("Teleporter/TCP: EOF Header write error: %Rrc\n", vrc));
@@ -693,6 +1005,42 @@ HRESULT Console::i_teleporterSrc(TeleporterStateSrc *pState)
     if (FAILED(hrc))
         return hrc;
 
+    /* Additional connections for striping the state. */
+    if (pState->mcStreams > 1)
+    {
+        uint32_t const cStreams = pState->mcStreams;
+        pState->mcStreams = 1;
+        RTStrPrintf(szLine, sizeof(szLine), "streams=%u", cStreams);
+        hrc = i_teleporterSrcConnectExtra(pState, szLine, cStreams - 1, &pState->mahStreams[1]);
+        if (FAILED(hrc))
+            return hrc;
+        if (hrc != S_FALSE)
+        {
+            pState->mcStreams = cStreams;
+            LogRel(("Teleporter: Striping the state across %u connections\n", cStreams));
+        }
+    }
+
+    /* The connection for fetching pages in post-copy mode. */
+    if (pState->mfPostCopy)
+    {
+        hrc = i_teleporterSrcConnectExtra(pState, "post-copy", 1, &pState->mhPostCopySocket);
+        if (FAILED(hrc))
+            return hrc;
+        if (hrc == S_FALSE)
+        {
+            LogRel(("Teleporter: The target can't do post-copy, doing a plain live teleportation\n"));
+            pState->mfPostCopy = false;
+        }
+        else
+        {
+            vrc = pState->mpVMM->pfnPGMR3PhysPostCopyEnable(pState->mpUVM, true);
+            if (RT_FAILURE(vrc))
+                return setErrorBoth(E_FAIL, vrc, "PGMR3PhysPostCopyEnable -> %Rrc", vrc);
+            LogRel(("Teleporter: Post-copy mode\n"));
+        }
+    }
+
     /*
      * Start loading the state.
      *
@@ -714,6 +1062,8 @@ HRESULT Console::i_teleporterSrc(TeleporterStateSrc *pState)
     RTSocketRelease(pState->mhSocket);
     if (RT_FAILURE(vrc))
     {
+        if (pState->mfPostCopy)
+            pState->mpVMM->pfnPGMR3PhysPostCopyEnable(pState->mpUVM, false);
         if (   vrc == VERR_SSM_CANCELLED
             && RT_SUCCESS(RTTcpSelectOne(pState->mhSocket, 1)))
         {
@@ -763,6 +1113,19 @@ HRESULT Console::i_teleporterSrc(TeleporterStateSrc *pState)
     if (FAILED(hrc))
         return hrc;
 
+    /*
+     * In post-copy mode we keep the VM around until the target has fetched
+     * all the RAM it left behind.  There is no going back from here, if the
+     * target dies meanwhile so does the VM.
+     */
+    if (pState->mfPostCopy)
+    {
+        hrc = i_teleporterSrcServePostCopy(pState);
+        if (FAILED(hrc))
+            LogRel(("Teleporter: Post-copy failed, the target VM is likely lost\n"));
+        hrc = S_OK; /* Past the point of no return. */
+    }
+
     /*
      * teleporterSrcThreadWrapper will do the automatic power off because it
      * has to release the AutoVMCaller.
@@ -795,6 +1158,12 @@ Console::i_teleporterSrcThreadWrapper(RTTHREAD hThreadSelf, void *pvUser)
         hrc = pState->mptrConsole->i_teleporterSrc(pState);
 
     /* Close the connection ASAP on so that the other side can complete. */
+    teleporterTcpCloseStreams(pState);
+    if (pState->mhPostCopySocket != NIL_RTSOCKET)
+    {
+        RTTcpClientClose(pState->mhPostCopySocket);
+        pState->mhPostCopySocket = NIL_RTSOCKET;
+    }
     if (pState->mhSocket != NIL_RTSOCKET)
     {
         RTTcpClientClose(pState->mhSocket);
@@ -1006,6 +1375,24 @@ HRESULT Console::teleport(const com::Utf8Str &aHostname, ULONG aTcpport, const c
     pState->muPort          = aTcpport;
     pState->mcMsMaxDowntime = aMaxDowntime;
 
+    /* The number of TCP connections to stripe the state across.  Only works
+       with a target that knows the "streams" command, so this is opt-in. */
+    Bstr bstrStreams;
+    hrc = mMachine->GetExtraData(Bstr("VBoxInternal2/TeleporterStreams").raw(), bstrStreams.asOutParam());
+    if (SUCCEEDED(hrc) && bstrStreams.isNotEmpty())
+    {
+        uint32_t cStreams = Utf8Str(bstrStreams).toUInt32();
+        pState->mcStreams = RT_MIN(RT_MAX(cStreams, 1), TELEPORTER_MAX_STREAMS);
+    }
+
+    /* Post-copy mode, also opt-in as the target must know the "post-copy"
+       command.  Leaves the VM at the mercy of the target after hand-over. */
+    Bstr bstrPostCopy;
+    hrc = mMachine->GetExtraData(Bstr("VBoxInternal2/TeleporterPostCopy").raw(), bstrPostCopy.asOutParam());
+    if (SUCCEEDED(hrc) && bstrPostCopy.isNotEmpty())
+        pState->mfPostCopy = Utf8Str(bstrPostCopy).toUInt32() != 0;
+    hrc = S_OK;
+
     void *pvUser = static_cast<void *>(static_cast<TeleporterState *>(pState));
     ptrProgress->i_setCancelCallback(teleporterProgressCancelCallback, pvUser);
 
@@ -1129,6 +1516,7 @@ HRESULT Console::i_teleporterTrg(PUVM pUVM, PCVMMR3VTABLE pVMM, IMachine *pMachi
             TeleporterStateTrg theState(this, pUVM, pVMM, pProgress, pMachine, mControl, &hTimerLR, fStartPaused);
             theState.mstrPassword      = strPassword;
             theState.mhServer          = hServer;
+            theState.mstrAddress       = strAddress;
 
             void *pvUser = static_cast<void *>(static_cast<TeleporterState *>(&theState));
             if (pProgress->i_setCancelCallback(teleporterProgressCancelCallback, pvUser))
@@ -1266,6 +1654,224 @@ static int teleporterTcpWriteNACK(TeleporterStateTrg *pState, int32_t rc2, const
 }
 
 
+/**
+ * Accepts additional connections from the source for the "streams=N" and
+ * "post-copy" commands.
+ *
+ * @returns VBox status code, the ACK or NACK has been sent.  On failure all
+ *          the entries in @a pahSockets are NIL_RTSOCKET.
+ * @param   pState          The teleporter state.
+ * @param   cSockets        The number of connections to accept.
+ * @param   pahSockets      Where to return the connections.
+ */
+static int teleporterTrgAcceptConnections(TeleporterStateTrg *pState, uint32_t cSockets, PRTSOCKET pahSockets)
+{
+    /*
+     * Create a listener on a random port for the additional connections.
+     */
+    const char  *pszAddress = pState->mstrAddress.isEmpty() ? NULL : pState->mstrAddress.c_str();
+    PRTTCPSERVER hServer    = NULL;
+    uint32_t     uPort      = 0;
+    int          vrc        = VERR_NET_ADDRESS_IN_USE;
+    for (unsigned cTries = 0; cTries < 64 && vrc == VERR_NET_ADDRESS_IN_USE; cTries++)
+    {
+        uPort = RTRandU32Ex(49152, 65534);
+        vrc = RTTcpServerCreateEx(pszAddress, uPort, &hServer);
+    }
+    if (RT_FAILURE(vrc))
+    {
+        LogRel(("Teleporter: Failed to create the listener for additional connections: %Rrc\n", vrc));
+        teleporterTcpWriteNACK(pState, vrc);
+        return vrc;
+    }
+
+    uint64_t const uCookie = RTRandU64();
+    char           szCookie[16 + 2];
+    RTStrPrintf(szCookie, sizeof(szCookie), "%016RX64\n", uCookie);
+
+    vrc = teleporterTcpWriteACK(pState);
+    if (RT_SUCCESS(vrc))
+    {
+        char         szMsg[64];
+        size_t const cch = RTStrPrintf(szMsg, sizeof(szMsg), "port=%u;cookie=%.16s\n", uPort, szCookie);
+        vrc = RTTcpWrite(pState->mhSocket, szMsg, cch);
+    }
+    if (RT_SUCCESS(vrc))
+    {
+        /*
+         * Accept the connections, with a timeout so we don't wait forever
+         * on a source that gave up.
+         */
+        RTTIMERLR hTimerLR = NIL_RTTIMERLR;
+        vrc = RTTimerLRCreateEx(&hTimerLR, 0 /*ns*/, RTTIMER_FLAGS_CPU_ANY, teleporterDstTimeout, hServer);
+        if (RT_SUCCESS(vrc))
+            vrc = RTTimerLRStart(hTimerLR, 30 * UINT64_C(1000000000) /*ns*/);
+
+        uint32_t iSocket = 0;
+        while (RT_SUCCESS(vrc) && iSocket < cSockets)
+        {
+            RTSOCKET hSocket;
+            vrc = RTTcpServerListen2(hServer, &hSocket);
+            if (RT_FAILURE(vrc))
+                break;
+
+            char achCookie[sizeof(szCookie) - 1];
+            int vrc2 = RTTcpSelectOne(hSocket, RT_MS_5SEC);
+            if (RT_SUCCESS(vrc2))
+                vrc2 = RTTcpRead(hSocket, achCookie, sizeof(achCookie), NULL);
+            if (RT_SUCCESS(vrc2) && !memcmp(achCookie, szCookie, sizeof(achCookie)))
+                pahSockets[iSocket++] = hSocket;
+            else
+            {
+                LogRel(("Teleporter: Rejected additional connection (%Rrc)\n", vrc2));
+                RTTcpServerDisconnectClient2(hSocket);
+            }
+        }
+
+        if (hTimerLR != NIL_RTTIMERLR)
+            RTTimerLRDestroy(hTimerLR);
+    }
+    RTTcpServerDestroy(hServer);
+
+    if (RT_SUCCESS(vrc))
+    {
+        vrc = teleporterTcpWriteACK(pState);
+        if (RT_SUCCESS(vrc))
+            return VINF_SUCCESS;
+    }
+    else
+    {
+        LogRel(("Teleporter: Failed to accept the additional connections: %Rrc\n", vrc));
+        teleporterTcpWriteNACK(pState, vrc);
+    }
+    for (uint32_t i = 0; i < cSockets; i++)
+        if (pahSockets[i] != NIL_RTSOCKET)
+        {
+            RTTcpServerDisconnectClient2(pahSockets[i]);
+            pahSockets[i] = NIL_RTSOCKET;
+        }
+    return vrc;
+}
+
+
+/**
+ * Handles the "streams=N" command, accepting the additional connections the
+ * stream will be striped across.
+ *
+ * @returns VBox status code, the ACK or NACK has been sent.
+ * @param   pState          The teleporter state.
+ * @param   cStreams        The total number of streams, including mhSocket.
+ */
+static int teleporterTrgAcceptStreams(TeleporterStateTrg *pState, uint32_t cStreams)
+{
+    int vrc = teleporterTrgAcceptConnections(pState, cStreams - 1, &pState->mahStreams[1]);
+    if (RT_SUCCESS(vrc))
+    {
+        pState->mcStreams = cStreams;
+        pState->miStream  = 0;
+        LogRel(("Teleporter: Receiving the state over %u connections\n", cStreams));
+    }
+    return vrc;
+}
+
+
+/**
+ * @callback_method_impl{FNPGMPOSTCOPYFETCH,
+ *      Fetches pages from the source over the post-copy connection.}
+ *
+ * @note PGM serializes the calls (its lock is held), so no locking here.
+ */
+static DECLCALLBACK(int) teleporterTrgPostCopyFetch(void *pvUser, RTGCPHYS GCPhys, void *pvBuf, uint32_t cPages)
+{
+    TeleporterPostCopy *pPostCopy = (TeleporterPostCopy *)pvUser;
+
+    TELEPORTERPOSTCOPYREQ Req;
+    Req.u32Magic = TELEPORTERPOSTCOPYREQ_MAGIC;
+    Req.cPages   = cPages;
+    Req.GCPhys   = GCPhys;
+    if (!cPages)
+    {
+        /* Done, tell the source and clean up. */
+        Req.GCPhys = 0;
+        if (pPostCopy->hSocket != NIL_RTSOCKET)
+        {
+            if (RT_SUCCESS(pPostCopy->rc))
+                RTTcpWrite(pPostCopy->hSocket, &Req, sizeof(Req));
+            RTTcpServerDisconnectClient2(pPostCopy->hSocket);
+        }
+        LogRel(("Teleporter: Post-copy done, fetched %RU64 pages on %RU64 requests (%Rrc)\n",
+                pPostCopy->cPagesFetched, pPostCopy->cRequests, pPostCopy->rc));
+        delete pPostCopy;
+        return VINF_SUCCESS;
+    }
+
+    /* A failure is sticky, the stream is out of sync. */
+    int vrc = pPostCopy->rc;
+    if (RT_SUCCESS(vrc))
+        vrc = RTTcpWrite(pPostCopy->hSocket, &Req, sizeof(Req));
+    TELEPORTERPOSTCOPYREPLY Reply;
+    if (RT_SUCCESS(vrc))
+        vrc = RTTcpRead(pPostCopy->hSocket, &Reply, sizeof(Reply), NULL);
+    if (RT_SUCCESS(vrc))
+    {
+        if (Reply.u32Magic != TELEPORTERPOSTCOPYREQ_MAGIC)
+            vrc = VERR_INVALID_MAGIC;
+        else if (RT_FAILURE(Reply.rc))
+            return Reply.rc; /* No page data follows, so we're still in sync. */
+        else
+            vrc = RTTcpRead(pPostCopy->hSocket, pvBuf, (size_t)cPages * GUEST_PAGE_SIZE, NULL);
+    }
+    if (RT_SUCCESS(vrc))
+    {
+        pPostCopy->cRequests++;
+        pPostCopy->cPagesFetched += cPages;
+    }
+    else if (RT_SUCCESS(pPostCopy->rc))
+    {
+        LogRel(("Teleporter: Post-copy: fetching %u pages at %RGp failed: %Rrc\n", cPages, GCPhys, vrc));
+        pPostCopy->rc = vrc;
+    }
+    return vrc;
+}
+
+
+/**
+ * Handles the "post-copy" command, accepting the connection the target
+ * fetches the remaining RAM pages over and registering the fetcher with PGM.
+ *
+ * If PGM can't do post-copy with the current execution engine, the command is
+ * declined with NACK=VERR_NOT_SUPPORTED and the teleportation continues
+ * without it.
+ *
+ * @returns VBox status code, the ACK or NACK has been sent.
+ * @param   pState          The teleporter state.
+ */
+static int teleporterTrgPostCopy(TeleporterStateTrg *pState)
+{
+    /*
+     * Register the fetcher first so we can decline before any connection is
+     * made if PGM can't do post-copy here.  The fetcher copes with not having
+     * a connection yet, in case it gets dropped again.
+     */
+    TeleporterPostCopy *pPostCopy = new TeleporterPostCopy(NIL_RTSOCKET);
+    int vrc = pState->mpVMM->pfnPGMR3PhysPostCopySetFetcher(pState->mpUVM, teleporterTrgPostCopyFetch, pPostCopy);
+    if (RT_FAILURE(vrc))
+    {
+        LogRel(("Teleporter: PGMR3PhysPostCopySetFetcher -> %Rrc, declining post-copy\n", vrc));
+        delete pPostCopy;
+        teleporterTcpWriteNACK(pState, vrc);
+        return vrc == VERR_NOT_SUPPORTED ? VINF_SUCCESS : vrc;
+    }
+    pState->mfPostCopy = true; /* The fetcher is dropped in the cleanup if we fail from here on. */
+
+    vrc = teleporterTrgAcceptConnections(pState, 1, &pPostCopy->hSocket);
+    if (RT_FAILURE(vrc))
+        return vrc;
+    LogRel(("Teleporter: Post-copy mode, fetching the remaining RAM on demand once running\n"));
+    return VINF_SUCCESS;
+}
+
+
 /**
  * @copydoc FNRTTCPSERVE
  *
@@ -1374,6 +1980,7 @@ Console::i_teleporterTrgServeConnection(RTSOCKET hSocket, void *pvUser)
             AssertRC(vrc2);
             RTSocketRetain(pState->mhSocket); /* For concurrent access by I/O thread and EMT. */
             pState->moffStream = 0;
+            pState->miStream   = 0;
 
             void *pvUser2 = static_cast<void *>(static_cast<TeleporterState *>(pState));
             vrc = pState->mpVMM->pfnVMR3LoadFromStream(pState->mpUVM,
@@ -1391,6 +1998,7 @@ Console::i_teleporterTrgServeConnection(RTSOCKET hSocket, void *pvUser)
                 teleporterTcpWriteNACK(pState, vrc, pState->mErrorText.c_str());
                 break;
             }
+            pState->mfPostCopy = false; /* PGM owns the fetcher now. */
 
             /* The EOS might not have been read, make sure it is. */
             pState->mfStopReading = false;
@@ -1405,6 +2013,32 @@ Console::i_teleporterTrgServeConnection(RTSOCKET hSocket, void *pvUser)
 
             vrc = teleporterTcpWriteACK(pState);
         }
+        else if (!strncmp(szCmd, RT_STR_TUPLE("streams=")))
+        {
+            uint32_t cStreams = 0;
+            vrc = RTStrToUInt32Full(&szCmd[sizeof("streams=") - 1], 10, &cStreams);
+            if (   vrc == VINF_SUCCESS
+                && cStreams >= 1
+                && cStreams <= TELEPORTER_MAX_STREAMS
+                && pState->mcStreams == 1)
+                vrc = teleporterTrgAcceptStreams(pState, cStreams);
+            else
+            {
+                LogRel(("Teleporter: Invalid streams command '%s'\n", szCmd));
+                vrc = VERR_INVALID_PARAMETER;
+                teleporterTcpWriteNACK(pState, vrc);
+            }
+        }
+        else if (!strcmp(szCmd, "post-copy"))
+        {
+            if (!pState->mfPostCopy)
+                vrc = teleporterTrgPostCopy(pState);
+            else
+            {
+                vrc = VERR_WRONG_ORDER;
+                teleporterTcpWriteNACK(pState, vrc);
+            }
+        }
         else if (!strcmp(szCmd, "cancel"))
         {
             /* Don't ACK this. */
@@ -1474,6 +2108,13 @@ Console::i_teleporterTrgServeConnection(RTSOCKET hSocket, void *pvUser)
         vrc = VERR_WRONG_ORDER;
     if (RT_FAILURE(vrc))
         teleporterTrgUnlockMedia(pState);
+    if (pState->mfPostCopy)
+    {
+        /* Didn't get as far as loading, drop the fetcher. */
+        pState->mpVMM->pfnPGMR3PhysPostCopySetFetcher(pState->mpUVM, NULL, NULL);
+        pState->mfPostCopy = false;
+    }
+    teleporterTcpCloseStreams(pState);
 
     pState->mRc = vrc;
     pState->mhSocket = NIL_RTSOCKET;
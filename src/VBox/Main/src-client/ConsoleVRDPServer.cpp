@@ -58,6 +58,8 @@
 #include <iprt/path.h>
 #include <iprt/cpp/utils.h>
 
+#include <vector>
+
 #include <VBox/err.h>
 #include <VBox/RemoteDesktop/VRDEOrders.h>
 #include <VBox/com/listeners.h>
@@ -1427,6 +1429,20 @@ ConsoleVRDPServer::ConsoleVRDPServer(Console *console)
     vrc = RTCritSectInit(&mTSMFLock);
     AssertRC(vrc);
 
+    for (unsigned i = 0; i < RT_ELEMENTS(maTileCaches); i++)
+    {
+        maTileCaches[i].cxScreen  = 0;
+        maTileCaches[i].cyScreen  = 0;
+        maTileCaches[i].cTilesX   = 0;
+        maTileCaches[i].cTilesY   = 0;
+        maTileCaches[i].pau64Hash = NULL;
+        maTileCaches[i].pau8State = NULL;
+        maTileCaches[i].cRects    = 0;
+    }
+
+    vrc = RTCritSectInit(&mTileCacheLock);
+    AssertRC(vrc);
+
     mEmWebcam = new EmWebcam(this);
     AssertPtr(mEmWebcam);
 }
@@ -1466,6 +1482,15 @@ ConsoleVRDPServer::~ConsoleVRDPServer()
         RTCritSectDelete(&mTSMFLock);
         RT_ZERO(mTSMFLock);
     }
+
+    for (i = 0; i < RT_ELEMENTS(maTileCaches); i++)
+        tileCacheReset(&maTileCaches[i]);
+
+    if (RTCritSectIsInitialized(&mTileCacheLock))
+    {
+        RTCritSectDelete(&mTileCacheLock);
+        RT_ZERO(mTileCacheLock);
+    }
 }
 
 int ConsoleVRDPServer::Launch(void)
@@ -3724,10 +3749,327 @@ void ConsoleVRDPServer::usbBackendRemoveFromList(RemoteUSBBackend *pRemoteUSBBac
 }
 
 
-void ConsoleVRDPServer::SendUpdate(unsigned uScreenId, void *pvUpdate, uint32_t cbUpdate) const
+/**
+ * Computes the hash of a tile of a 32bpp bitmap.
+ *
+ * @returns The hash, never 0 which marks unknown tiles.
+ */
+static uint64_t vrdpTileHash(const uint8_t *pu8Bitmap, uint32_t cbLine, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+    uint64_t u64Hash = UINT64_C(0xcbf29ce484222325) ^ ((uint64_t)w << 32) ^ h;
+    for (uint32_t iRow = 0; iRow < h; iRow++)
+    {
+        const uint32_t *pu32 = (const uint32_t *)(pu8Bitmap + (y + iRow) * cbLine + x * 4);
+        for (uint32_t iCol = 0; iCol < w; iCol++)
+        {
+            u64Hash = (u64Hash ^ pu32[iCol]) * UINT64_C(0x100000001b3);
+            u64Hash ^= u64Hash >> 29;
+        }
+    }
+    return u64Hash ? u64Hash : 1;
+}
+
+/** @name Tile states during ConsoleVRDPServer::tileCacheFlush.
+ * @{ */
+#define VRDP_TILE_STATE_CLEAN     0 /**< Not reported. */
+#define VRDP_TILE_STATE_DIRTY     1 /**< Reported, not processed yet. */
+#define VRDP_TILE_STATE_UNCHANGED 2 /**< Reported, but has the same content as forwarded before. */
+#define VRDP_TILE_STATE_MOVED     3 /**< Content found in another tile, sent as a screen blit. */
+#define VRDP_TILE_STATE_CHANGED   4 /**< Sent as a bitmap update. */
+/** @} */
+
+void ConsoleVRDPServer::tileCacheReset(VRDPTILECACHE *pCache)
 {
+    RTMemFree(pCache->pau64Hash);
+    pCache->pau64Hash = NULL;
+    RTMemFree(pCache->pau8State);
+    pCache->pau8State = NULL;
+    pCache->mapHashToTile.clear();
+    pCache->cxScreen = 0;
+    pCache->cyScreen = 0;
+    pCache->cTilesX = 0;
+    pCache->cTilesY = 0;
+}
+
+void ConsoleVRDPServer::sendUpdateBitmapRect(unsigned uScreenId, int32_t x, int32_t y, uint32_t w, uint32_t h) const
+{
+    VRDEORDERHDR update;
+    update.x = (int16_t)x;
+    update.y = (int16_t)y;
+    update.w = (uint16_t)w;
+    update.h = (uint16_t)h;
     if (mpEntryPoints && mhServer)
     {
+        mpEntryPoints->VRDEUpdate(mhServer, uScreenId, &update, sizeof(update));
+    }
+}
+
+/**
+ * Forwards the bitmap updates collected for a screen to the VRDE server.
+ *
+ * The reported rectangles are expanded to tiles.  Tiles with the same content as
+ * forwarded before are dropped, tiles whose content is found at another tile which
+ * the client already has are sent as a screen blit, and the remaining tiles are
+ * merged into as few rectangles as possible.
+ */
+void ConsoleVRDPServer::tileCacheFlush(unsigned uScreenId)
+{
+    AssertReturnVoid(uScreenId < RT_ELEMENTS(maTileCaches));
+    VRDPTILECACHE *pCache = &maTileCaches[uScreenId];
+
+    RTCritSectEnter(&mTileCacheLock);
+
+    if (pCache->cRects == 0)
+    {
+        RTCritSectLeave(&mTileCacheLock);
+        return;
+    }
+
+    /* The source bitmap the VRDE server reads the screen from. */
+    BYTE *pu8Address = NULL;
+    ULONG cx = 0;
+    ULONG cy = 0;
+    ULONG cBitsPerPixel = 0;
+    ULONG cbLine = 0;
+    BitmapFormat_T bitmapFormat = BitmapFormat_Opaque;
+
+    ComPtr<IDisplaySourceBitmap> pSourceBitmap = maSourceBitmaps[uScreenId];
+    HRESULT hrc = E_FAIL;
+    if (!pSourceBitmap.isNull() && ASMAtomicReadS32(&mcClients) > 0)
+        hrc = pSourceBitmap->QueryBitmapInfo(&pu8Address, &cx, &cy, &cBitsPerPixel, &cbLine, &bitmapFormat);
+    if (   FAILED(hrc)
+        || !pu8Address
+        || cBitsPerPixel != 32
+        || cx > INT16_MAX
+        || cy > INT16_MAX)
+    {
+        /* Nothing to compare with, forward as is. */
+        for (uint32_t i = 0; i < pCache->cRects; i++)
+            sendUpdateBitmapRect(uScreenId, pCache->aRects[i].xLeft, pCache->aRects[i].yTop,
+                                 pCache->aRects[i].xRight - pCache->aRects[i].xLeft,
+                                 pCache->aRects[i].yBottom - pCache->aRects[i].yTop);
+        pCache->cRects = 0;
+        tileCacheReset(pCache);
+        RTCritSectLeave(&mTileCacheLock);
+        return;
+    }
+
+    if (pCache->cxScreen != cx || pCache->cyScreen != cy)
+    {
+        tileCacheReset(pCache);
+        uint32_t const cTilesX = (cx + VRDP_TILE_SIZE - 1) / VRDP_TILE_SIZE;
+        uint32_t const cTilesY = (cy + VRDP_TILE_SIZE - 1) / VRDP_TILE_SIZE;
+        pCache->pau64Hash = (uint64_t *)RTMemAllocZ(cTilesX * cTilesY * sizeof(uint64_t));
+        pCache->pau8State = (uint8_t *)RTMemAllocZ(cTilesX * cTilesY);
+        if (pCache->pau64Hash && pCache->pau8State)
+        {
+            pCache->cxScreen = cx;
+            pCache->cyScreen = cy;
+            pCache->cTilesX = cTilesX;
+            pCache->cTilesY = cTilesY;
+        }
+        else
+        {
+            tileCacheReset(pCache);
+            for (uint32_t i = 0; i < pCache->cRects; i++)
+                sendUpdateBitmapRect(uScreenId, pCache->aRects[i].xLeft, pCache->aRects[i].yTop,
+                                     pCache->aRects[i].xRight - pCache->aRects[i].xLeft,
+                                     pCache->aRects[i].yBottom - pCache->aRects[i].yTop);
+            pCache->cRects = 0;
+            RTCritSectLeave(&mTileCacheLock);
+            return;
+        }
+    }
+
+    /* Mark the reported tiles. */
+    uint32_t iTileRowFirst = pCache->cTilesY;
+    uint32_t iTileRowLast  = 0;
+    for (uint32_t i = 0; i < pCache->cRects; i++)
+    {
+        RTRECT const *pRect = &pCache->aRects[i];
+        int32_t const xLeft   = RT_MAX(pRect->xLeft, 0);
+        int32_t const yTop    = RT_MAX(pRect->yTop, 0);
+        int32_t const xRight  = RT_MIN(pRect->xRight, (int32_t)cx);
+        int32_t const yBottom = RT_MIN(pRect->yBottom, (int32_t)cy);
+        if (xLeft >= xRight || yTop >= yBottom)
+            continue;
+
+        uint32_t const iRowLast = (uint32_t)(yBottom - 1) / VRDP_TILE_SIZE;
+        uint32_t const iColLast = (uint32_t)(xRight - 1) / VRDP_TILE_SIZE;
+        for (uint32_t iRow = (uint32_t)yTop / VRDP_TILE_SIZE; iRow <= iRowLast; iRow++)
+            for (uint32_t iCol = (uint32_t)xLeft / VRDP_TILE_SIZE; iCol <= iColLast; iCol++)
+                pCache->pau8State[iRow * pCache->cTilesX + iCol] = VRDP_TILE_STATE_DIRTY;
+        iTileRowFirst = RT_MIN(iTileRowFirst, (uint32_t)yTop / VRDP_TILE_SIZE);
+        iTileRowLast  = RT_MAX(iTileRowLast, iRowLast);
+    }
+    pCache->cRects = 0;
+
+    /* Compare the reported tiles with the cache, looking for moved content. */
+    std::vector<uint8_t> vecOrders;
+    RTRECT rectOrders = { INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN };
+    for (uint32_t iRow = iTileRowFirst; iRow <= iTileRowLast && iRow < pCache->cTilesY; iRow++)
+    {
+        for (uint32_t iCol = 0; iCol < pCache->cTilesX; iCol++)
+        {
+            uint32_t const iTile = iRow * pCache->cTilesX + iCol;
+            if (pCache->pau8State[iTile] != VRDP_TILE_STATE_DIRTY)
+                continue;
+
+            uint32_t const x = iCol * VRDP_TILE_SIZE;
+            uint32_t const y = iRow * VRDP_TILE_SIZE;
+            uint32_t const w = RT_MIN((uint32_t)VRDP_TILE_SIZE, cx - x);
+            uint32_t const h = RT_MIN((uint32_t)VRDP_TILE_SIZE, cy - y);
+            uint64_t const u64Hash = vrdpTileHash(pu8Address, cbLine, x, y, w, h);
+            uint64_t const u64HashOld = pCache->pau64Hash[iTile];
+            if (u64Hash == u64HashOld)
+            {
+                pCache->pau8State[iTile] = VRDP_TILE_STATE_UNCHANGED;
+                continue;
+            }
+
+            /* Can the client copy the content from another full tile it already has?  The
+             * blits are sent before the bitmap updates, so the source must not have been
+             * sent a different content in this flush. */
+            pCache->pau8State[iTile] = VRDP_TILE_STATE_CHANGED;
+            if (w == VRDP_TILE_SIZE && h == VRDP_TILE_SIZE)
+            {
+                std::unordered_map<uint64_t, uint32_t>::const_iterator it = pCache->mapHashToTile.find(u64Hash);
+                if (it != pCache->mapHashToTile.end())
+                {
+                    uint32_t const iTileSrc = it->second;
+                    uint32_t const xSrc = (iTileSrc % pCache->cTilesX) * VRDP_TILE_SIZE;
+                    uint32_t const ySrc = (iTileSrc / pCache->cTilesX) * VRDP_TILE_SIZE;
+                    uint8_t const  uStateSrc = pCache->pau8State[iTileSrc];
+                    if (   iTileSrc != iTile
+                        && pCache->pau64Hash[iTileSrc] == u64Hash
+                        && xSrc + VRDP_TILE_SIZE <= cx
+                        && ySrc + VRDP_TILE_SIZE <= cy
+                        && (   uStateSrc == VRDP_TILE_STATE_UNCHANGED
+                            || (   (   uStateSrc == VRDP_TILE_STATE_CLEAN
+                                    || uStateSrc == VRDP_TILE_STATE_DIRTY)
+                                && vrdpTileHash(pu8Address, cbLine, xSrc, ySrc, VRDP_TILE_SIZE, VRDP_TILE_SIZE) == u64Hash)))
+                    {
+                        VRDEORDERCODE code;
+                        code.u32Code = VRDE_ORDER_SCREENBLT;
+                        VRDEORDERSCREENBLT blt;
+                        blt.x    = (int16_t)x;
+                        blt.y    = (int16_t)y;
+                        blt.w    = VRDP_TILE_SIZE;
+                        blt.h    = VRDP_TILE_SIZE;
+                        blt.xSrc = (int16_t)xSrc;
+                        blt.ySrc = (int16_t)ySrc;
+                        blt.rop  = 0xCC; /* SRCCOPY */
+                        vecOrders.insert(vecOrders.end(), (const uint8_t *)&code, (const uint8_t *)&code + sizeof(code));
+                        vecOrders.insert(vecOrders.end(), (const uint8_t *)&blt, (const uint8_t *)&blt + sizeof(blt));
+
+                        rectOrders.xLeft   = RT_MIN(rectOrders.xLeft,   (int32_t)x);
+                        rectOrders.yTop    = RT_MIN(rectOrders.yTop,    (int32_t)y);
+                        rectOrders.xRight  = RT_MAX(rectOrders.xRight,  (int32_t)(x + VRDP_TILE_SIZE));
+                        rectOrders.yBottom = RT_MAX(rectOrders.yBottom, (int32_t)(y + VRDP_TILE_SIZE));
+
+                        pCache->pau8State[iTile] = VRDP_TILE_STATE_MOVED;
+                    }
+                }
+            }
+
+            std::unordered_map<uint64_t, uint32_t>::iterator itOld = pCache->mapHashToTile.find(u64HashOld);
+            if (itOld != pCache->mapHashToTile.end() && itOld->second == iTile)
+                pCache->mapHashToTile.erase(itOld);
+            pCache->mapHashToTile[u64Hash] = iTile;
+            pCache->pau64Hash[iTile] = u64Hash;
+        }
+    }
+
+    if (!vecOrders.empty() && mpEntryPoints && mhServer)
+    {
+        std::vector<uint8_t> vecUpdate(sizeof(VRDEORDERHDR) + vecOrders.size());
+        VRDEORDERHDR *pHdr = (VRDEORDERHDR *)&vecUpdate[0];
+        pHdr->x = (int16_t)rectOrders.xLeft;
+        pHdr->y = (int16_t)rectOrders.yTop;
+        pHdr->w = (uint16_t)(rectOrders.xRight - rectOrders.xLeft);
+        pHdr->h = (uint16_t)(rectOrders.yBottom - rectOrders.yTop);
+        memcpy(&vecUpdate[sizeof(VRDEORDERHDR)], &vecOrders[0], vecOrders.size());
+        mpEntryPoints->VRDEUpdate(mhServer, uScreenId, &vecUpdate[0], (uint32_t)vecUpdate.size());
+    }
+
+    /* Send the changed tiles as horizontal runs, merging runs with the same extent in
+     * consecutive tile rows into one rectangle. */
+    RTRECT rectPending = { 0, 0, 0, 0 };
+    for (uint32_t iRow = iTileRowFirst; iRow <= iTileRowLast && iRow < pCache->cTilesY; iRow++)
+    {
+        uint32_t iCol = 0;
+        while (iCol < pCache->cTilesX)
+        {
+            uint8_t *pu8State = &pCache->pau8State[iRow * pCache->cTilesX];
+            if (pu8State[iCol] != VRDP_TILE_STATE_CHANGED)
+            {
+                pu8State[iCol] = VRDP_TILE_STATE_CLEAN;
+                iCol++;
+                continue;
+            }
+
+            uint32_t iColEnd = iCol;
+            while (iColEnd < pCache->cTilesX && pu8State[iColEnd] == VRDP_TILE_STATE_CHANGED)
+                pu8State[iColEnd++] = VRDP_TILE_STATE_CLEAN;
+
+            RTRECT rectRun;
+            rectRun.xLeft   = (int32_t)(iCol * VRDP_TILE_SIZE);
+            rectRun.yTop    = (int32_t)(iRow * VRDP_TILE_SIZE);
+            rectRun.xRight  = (int32_t)RT_MIN(iColEnd * VRDP_TILE_SIZE, cx);
+            rectRun.yBottom = (int32_t)RT_MIN((iRow + 1) * VRDP_TILE_SIZE, cy);
+            if (   rectPending.xRight > rectPending.xLeft
+                && rectPending.xLeft   == rectRun.xLeft
+                && rectPending.xRight  == rectRun.xRight
+                && rectPending.yBottom == rectRun.yTop)
+                rectPending.yBottom = rectRun.yBottom;
+            else
+            {
+                if (rectPending.xRight > rectPending.xLeft)
+                    sendUpdateBitmapRect(uScreenId, rectPending.xLeft, rectPending.yTop,
+                                         rectPending.xRight - rectPending.xLeft, rectPending.yBottom - rectPending.yTop);
+                rectPending = rectRun;
+            }
+            iCol = iColEnd;
+        }
+    }
+    if (rectPending.xRight > rectPending.xLeft)
+        sendUpdateBitmapRect(uScreenId, rectPending.xLeft, rectPending.yTop,
+                             rectPending.xRight - rectPending.xLeft, rectPending.yBottom - rectPending.yTop);
+
+    RTCritSectLeave(&mTileCacheLock);
+}
+
+void ConsoleVRDPServer::SendUpdate(unsigned uScreenId, void *pvUpdate, uint32_t cbUpdate)
+{
+    if (mpEntryPoints && mhServer)
+    {
+        /* Bitmap updates collected for the screen go first, the end of an update
+         * sequence (pvUpdate == NULL) is where they are batched up to. */
+        if (uScreenId < RT_ELEMENTS(maTileCaches))
+        {
+            tileCacheFlush(uScreenId);
+
+            /* The orders change the screen behind the back of the tile cache. */
+            if (pvUpdate && cbUpdate >= sizeof(VRDEORDERHDR))
+            {
+                VRDEORDERHDR const *pHdr = (VRDEORDERHDR const *)pvUpdate;
+                VRDPTILECACHE *pCache = &maTileCaches[uScreenId];
+
+                RTCritSectEnter(&mTileCacheLock);
+                if (pCache->pau64Hash && pHdr->w && pHdr->h)
+                {
+                    int32_t const xLeft   = RT_MAX((int32_t)pHdr->x, 0);
+                    int32_t const yTop    = RT_MAX((int32_t)pHdr->y, 0);
+                    int32_t const xRight  = RT_MIN((int32_t)pHdr->x + pHdr->w, (int32_t)pCache->cxScreen);
+                    int32_t const yBottom = RT_MIN((int32_t)pHdr->y + pHdr->h, (int32_t)pCache->cyScreen);
+                    for (int32_t iRow = yTop / VRDP_TILE_SIZE; iRow * VRDP_TILE_SIZE < yBottom; iRow++)
+                        for (int32_t iCol = xLeft / VRDP_TILE_SIZE; iCol * VRDP_TILE_SIZE < xRight; iCol++)
+                            pCache->pau64Hash[iRow * pCache->cTilesX + iCol] = 0;
+                }
+                RTCritSectLeave(&mTileCacheLock);
+            }
+        }
+
         mpEntryPoints->VRDEUpdate(mhServer, uScreenId, pvUpdate, cbUpdate);
     }
 }
@@ -3736,23 +4078,58 @@ void ConsoleVRDPServer::SendResize(void)
 {
     if (mpEntryPoints && mhServer)
     {
+        /* The screens are going to be redrawn from scratch. */
+        RTCritSectEnter(&mTileCacheLock);
+        for (unsigned i = 0; i < RT_ELEMENTS(maTileCaches); i++)
+        {
+            maTileCaches[i].cRects = 0;
+            tileCacheReset(&maTileCaches[i]);
+        }
+        RTCritSectLeave(&mTileCacheLock);
+
         ++mcInResize;
         mpEntryPoints->VRDEResize(mhServer);
         --mcInResize;
     }
 }
 
-void ConsoleVRDPServer::SendUpdateBitmap(unsigned uScreenId, uint32_t x, uint32_t y, uint32_t w, uint32_t h) const
+/**
+ * Reports an updated rectangle of a screen.
+ *
+ * The update is forwarded at the end of the current update sequence, see
+ * tileCacheFlush.
+ */
+void ConsoleVRDPServer::SendUpdateBitmap(unsigned uScreenId, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
 {
-    VRDEORDERHDR update;
-    update.x = (uint16_t)x;
-    update.y = (uint16_t)y;
-    update.w = (uint16_t)w;
-    update.h = (uint16_t)h;
-    if (mpEntryPoints && mhServer)
+    if (!mpEntryPoints || !mhServer || !w || !h)
+        return;
+
+    if (uScreenId >= RT_ELEMENTS(maTileCaches))
     {
-        mpEntryPoints->VRDEUpdate(mhServer, uScreenId, &update, sizeof(update));
+        sendUpdateBitmapRect(uScreenId, (int32_t)x, (int32_t)y, w, h);
+        return;
+    }
+
+    VRDPTILECACHE *pCache = &maTileCaches[uScreenId];
+    RTRECT rect;
+    rect.xLeft   = (int32_t)x;
+    rect.yTop    = (int32_t)y;
+    rect.xRight  = (int32_t)(x + w);
+    rect.yBottom = (int32_t)(y + h);
+
+    RTCritSectEnter(&mTileCacheLock);
+    if (pCache->cRects < RT_ELEMENTS(pCache->aRects))
+        pCache->aRects[pCache->cRects++] = rect;
+    else
+    {
+        /* Merge into the last rectangle, the tiles narrow it down again. */
+        RTRECT *pLast = &pCache->aRects[pCache->cRects - 1];
+        pLast->xLeft   = RT_MIN(pLast->xLeft,   rect.xLeft);
+        pLast->yTop    = RT_MIN(pLast->yTop,    rect.yTop);
+        pLast->xRight  = RT_MAX(pLast->xRight,  rect.xRight);
+        pLast->yBottom = RT_MAX(pLast->yBottom, rect.yBottom);
     }
+    RTCritSectLeave(&mTileCacheLock);
 }
 
 void ConsoleVRDPServer::SendAudioSamples(void const *pvSamples, uint32_t cSamples, VRDEAUDIOFORMAT format) const
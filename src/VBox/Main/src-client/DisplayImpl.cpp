@@ -110,6 +110,11 @@ HRESULT Display::FinalConstruct()
     vrc = RTCritSectInit(&mVideoAccelLock);
     AssertRC(vrc);
 
+    vrc = RTCritSectInit(&mDamageLock);
+    AssertRC(vrc);
+    mnsDamageInterval  = 0;
+    mnsDamageLastFlush = 0;
+
 #ifdef VBOX_WITH_HGSMI
     mu32UpdateVBVAFlags = 0;
     mfVMMDevSupportsGraphics = false;
@@ -133,6 +138,12 @@ void Display::FinalRelease()
         RT_ZERO(mVideoAccelLock);
     }
 
+    if (RTCritSectIsInitialized(&mDamageLock))
+    {
+        RTCritSectDelete(&mDamageLock);
+        RT_ZERO(mDamageLock);
+    }
+
     BaseFinalRelease();
 }
 
@@ -474,6 +485,7 @@ HRESULT Display::init(Console *aParent)
     unconst(mParent) = aParent;
 
     mfSourceBitmapEnabled = true;
+    mfSharedSourceBitmap = false;
     fVGAResizing = false;
 
     ComPtr<IGraphicsAdapter> pGraphicsAdapter;
@@ -525,6 +537,8 @@ HRESULT Display::init(Console *aParent)
         maFramebuffers[ul].fVBVAForceResize = false;
         maFramebuffers[ul].pVBVAHostFlags = NULL;
 #endif /* VBOX_WITH_HGSMI */
+
+        maFramebuffers[ul].damage.cRects = 0;
     }
 
     {
@@ -953,7 +967,23 @@ void Display::i_handleDisplayUpdate(unsigned uScreenId, int x, int y, int w, int
                     i_checkCoordBounds(&x, &y, &w, &h, ulWidth, ulHeight);
 
                     if (   w != 0
-                        && h != 0)
+                        && h != 0
+                        && mfSharedSourceBitmap)
+                    {
+                        /* The framebuffer reads the pixels straight from the shared
+                         * source bitmap, so only tell it what has changed. */
+                        pFramebuffer->NotifyUpdate(x, y, w, h);
+
+#ifdef VBOX_WITH_RECORDING
+                        unsigned const uBytesPerPixel = ulBitsPerPixel / 8;
+                        i_recordingScreenUpdate(uScreenId,
+                                                pbAddress + ulBytesPerLine * y + x * uBytesPerPixel,
+                                                ulBytesPerLine * h,
+                                                x, y, w, h, ulBytesPerLine);
+#endif
+                    }
+                    else if (   w != 0
+                             && h != 0)
                     {
                         unsigned const uBytesPerPixel = ulBitsPerPixel / 8;
 
@@ -997,6 +1027,130 @@ void Display::i_handleDisplayUpdate(unsigned uScreenId, int x, int y, int w, int
     }
 }
 
+static uint64_t displayRectArea(PCRTRECT pRect)
+{
+    return (uint64_t)(pRect->xRight - pRect->xLeft) * (uint64_t)(pRect->yBottom - pRect->yTop);
+}
+
+static void displayRectUnion(PRTRECT pDst, PCRTRECT pRect1, PCRTRECT pRect2)
+{
+    pDst->xLeft   = RT_MIN(pRect1->xLeft,   pRect2->xLeft);
+    pDst->yTop    = RT_MIN(pRect1->yTop,    pRect2->yTop);
+    pDst->xRight  = RT_MAX(pRect1->xRight,  pRect2->xRight);
+    pDst->yBottom = RT_MAX(pRect1->yBottom, pRect2->yBottom);
+}
+
+/**
+ * Adds a rectangle to the damage of a screen.
+ *
+ * Rectangles are merged whenever their bounding box is not larger than the two
+ * of them together, i.e. when they overlap or are adjacent and aligned.  When
+ * the array is full, the rectangle goes into the one it enlarges the least.
+ */
+static void displayDamageAdd(DISPLAYFBINFO *pFBInfo, RTRECT const *pRect)
+{
+    RTRECT   Rect = *pRect;
+    uint32_t i    = 0;
+    while (i < pFBInfo->damage.cRects)
+    {
+        RTRECT Union;
+        displayRectUnion(&Union, &pFBInfo->damage.aRects[i], &Rect);
+        if (displayRectArea(&Union) <= displayRectArea(&pFBInfo->damage.aRects[i]) + displayRectArea(&Rect))
+        {
+            /* Take the old rectangle out and start over with the union, which may now touch others. */
+            Rect = Union;
+            pFBInfo->damage.aRects[i] = pFBInfo->damage.aRects[--pFBInfo->damage.cRects];
+            i = 0;
+        }
+        else
+            i++;
+    }
+
+    if (pFBInfo->damage.cRects < RT_ELEMENTS(pFBInfo->damage.aRects))
+        pFBInfo->damage.aRects[pFBInfo->damage.cRects++] = Rect;
+    else
+    {
+        uint32_t iBest       = 0;
+        uint64_t cGrowthBest = UINT64_MAX;
+        for (i = 0; i < pFBInfo->damage.cRects; i++)
+        {
+            RTRECT Union;
+            displayRectUnion(&Union, &pFBInfo->damage.aRects[i], &Rect);
+            uint64_t const cGrowth = displayRectArea(&Union) - displayRectArea(&pFBInfo->damage.aRects[i]);
+            if (cGrowth < cGrowthBest)
+            {
+                cGrowthBest = cGrowth;
+                iBest       = i;
+            }
+        }
+        displayRectUnion(&pFBInfo->damage.aRects[iBest], &pFBInfo->damage.aRects[iBest], &Rect);
+    }
+}
+
+/**
+ * Records an update rectangle reported by the graphics device.
+ *
+ * Guests updating many small rectangles (scrolling terminals, blinking cursors)
+ * would otherwise cause a framebuffer, VRDE and recording notification each.
+ * The rectangles are merged per screen and forwarded by i_flushDisplayDamage
+ * from the refresh callback.
+ */
+void Display::i_handleDisplayDamage(unsigned uScreenId, int x, int y, int w, int h)
+{
+    AssertReturnVoid(uScreenId < mcMonitors);
+    if (w <= 0 || h <= 0)
+        return;
+
+    RTRECT Rect;
+    Rect.xLeft   = x;
+    Rect.yTop    = y;
+    Rect.xRight  = x + w;
+    Rect.yBottom = y + h;
+
+    RTCritSectEnter(&mDamageLock);
+    displayDamageAdd(&maFramebuffers[uScreenId], &Rect);
+    RTCritSectLeave(&mDamageLock);
+}
+
+/**
+ * Forwards the damage collected by i_handleDisplayDamage.
+ *
+ * @param   fForce      Flush even if the configured maximum update rate says
+ *                      it is too early.
+ */
+void Display::i_flushDisplayDamage(bool fForce)
+{
+    RTCritSectEnter(&mDamageLock);
+    uint64_t const nsNow = RTTimeNanoTS();
+    if (   !fForce
+        && mnsDamageInterval
+        && nsNow - mnsDamageLastFlush < mnsDamageInterval)
+    {
+        RTCritSectLeave(&mDamageLock);
+        return;
+    }
+    mnsDamageLastFlush = nsNow;
+    RTCritSectLeave(&mDamageLock);
+
+    for (unsigned uScreenId = 0; uScreenId < mcMonitors; uScreenId++)
+    {
+        DISPLAYFBINFO *pFBInfo = &maFramebuffers[uScreenId];
+        RTRECT   aRects[RT_ELEMENTS(pFBInfo->damage.aRects)];
+        uint32_t cRects;
+
+        /* Do not hold the lock while calling the consumers. */
+        RTCritSectEnter(&mDamageLock);
+        cRects = pFBInfo->damage.cRects;
+        memcpy(aRects, pFBInfo->damage.aRects, cRects * sizeof(aRects[0]));
+        pFBInfo->damage.cRects = 0;
+        RTCritSectLeave(&mDamageLock);
+
+        for (uint32_t i = 0; i < cRects; i++)
+            i_handleDisplayUpdate(uScreenId, aRects[i].xLeft, aRects[i].yTop,
+                                  aRects[i].xRight - aRects[i].xLeft, aRects[i].yBottom - aRects[i].yTop);
+    }
+}
+
 void Display::i_updateGuestGraphicsFacility(void)
 {
     Guest* pGuest = mParent->i_getGuest();
@@ -3105,7 +3259,7 @@ DECLCALLBACK(void) Display::i_displayUpdateCallback(PPDMIDISPLAYCONNECTOR pInter
      * pfnUpdateDisplayAll in the VGA device.
      */
 
-    pDrv->pDisplay->i_handleDisplayUpdate(VBOX_VIDEO_PRIMARY_SCREEN, x, y, cx, cy);
+    pDrv->pDisplay->i_handleDisplayDamage(VBOX_VIDEO_PRIMARY_SCREEN, x, y, cx, cy);
 }
 
 /**
@@ -3132,6 +3286,9 @@ DECLCALLBACK(void) Display::i_displayUpdateCallback(PPDMIDISPLAYCONNECTOR pInter
             pDrv->pUpPort->pfnUpdateDisplay(pDrv->pUpPort);
         }
 
+        /* Forward the collected update rectangles before completing the sequence. */
+        pDisplay->i_flushDisplayDamage(false /*fForce*/);
+
         /* Inform the VRDP server that the current display update sequence is
          * completed. At this moment the framebuffer memory contains a definite
          * image, that is synchronized with the orders already sent to VRDP client.
@@ -3359,11 +3516,17 @@ DECLCALLBACK(void) Display::i_displayVBVAUpdateBegin(PPDMIDISPLAYCONNECTOR pInte
     PDRVMAINDISPLAY pDrv = PDMIDISPLAYCONNECTOR_2_MAINDISPLAY(pInterface);
     Display *pThis = pDrv->pDisplay;
 
-    if (ASMAtomicReadU32(&pThis->mu32UpdateVBVAFlags) > 0)
+    /* The device may flush several screens in parallel, so claim the pending
+     * update with a compare-and-exchange rather than a plain decrement. */
+    uint32_t cUpdates = ASMAtomicReadU32(&pThis->mu32UpdateVBVAFlags);
+    while (cUpdates > 0)
     {
-        vbvaSetMemoryFlagsAllHGSMI(pThis->mfu32SupportedOrders, pThis->mfVideoAccelVRDP, pThis->maFramebuffers,
-                                   pThis->mcMonitors);
-        ASMAtomicDecU32(&pThis->mu32UpdateVBVAFlags);
+        if (ASMAtomicCmpXchgExU32(&pThis->mu32UpdateVBVAFlags, cUpdates - 1, cUpdates, &cUpdates))
+        {
+            vbvaSetMemoryFlagsAllHGSMI(pThis->mfu32SupportedOrders, pThis->mfVideoAccelVRDP, pThis->maFramebuffers,
+                                       pThis->mcMonitors);
+            break;
+        }
     }
 }
 
@@ -3476,7 +3639,7 @@ DECLCALLBACK(void) Display::i_displayVBVAUpdateEnd(PPDMIDISPLAYCONNECTOR pInterf
      *                                y - pThis->maFramebuffers[uScreenId].yOrigin,
      *                                cx, cy);
      */
-    pThis->i_handleDisplayUpdate(uScreenId, x - pFBInfo->xOrigin, y - pFBInfo->yOrigin, cx, cy);
+    pThis->i_handleDisplayDamage(uScreenId, x - pFBInfo->xOrigin, y - pFBInfo->yOrigin, cx, cy);
 }
 
 #ifdef DEBUG_sunlover
@@ -3783,14 +3946,14 @@ DECLCALLBACK(void) Display::i_drvDestruct(PPDMDRVINS pDrvIns)
 DECLCALLBACK(int) Display::i_drvConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uint32_t fFlags)
 {
     PDMDRV_CHECK_VERSIONS_RETURN(pDrvIns);
-    RT_NOREF(fFlags, pCfg);
+    RT_NOREF(fFlags);
     PDRVMAINDISPLAY pThis = PDMINS_2_DATA(pDrvIns, PDRVMAINDISPLAY);
     LogRelFlowFunc(("iInstance=%d\n", pDrvIns->iInstance));
 
     /*
      * Validate configuration.
      */
-    PDMDRV_VALIDATE_CONFIG_RETURN(pDrvIns, "", "");
+    PDMDRV_VALIDATE_CONFIG_RETURN(pDrvIns, "MaxUpdateRate|SharedSourceBitmap", "");
     AssertMsgReturn(PDMDrvHlpNoAttach(pDrvIns) == VERR_PDM_NO_ATTACHED_DRIVER,
                     ("Configuration error: Not possible to attach anything to this driver!\n"),
                     VERR_PDM_DRVINS_NO_ATTACH);
@@ -3844,6 +4007,29 @@ DECLCALLBACK(int) Display::i_drvConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, ui
     pThis->pDisplay = static_cast<Display *>(pIDisplay);
     pThis->pDisplay->mpDrv = pThis;
 
+    /*
+     * Maximum rate (Hz) at which collected update rectangles are forwarded to the
+     * framebuffers, VRDE and recording.  0 means on every refresh.
+     */
+    uint32_t uMaxUpdateRate = 0;
+    int vrc = pDrvIns->pHlpR3->pfnCFGMQueryU32Def(pCfg, "MaxUpdateRate", &uMaxUpdateRate, 0);
+    AssertLogRelRCReturn(vrc, vrc);
+    pThis->pDisplay->mnsDamageInterval = uMaxUpdateRate ? RT_NS_1SEC / uMaxUpdateRate : 0;
+    if (uMaxUpdateRate)
+        LogRel(("Display: Limiting framebuffer updates to %u per second\n", uMaxUpdateRate));
+
+    /*
+     * Whether framebuffers using FramebufferCapabilities_UpdateImage read the guest
+     * screen directly from the source bitmap (VRAM for VBVA and VMSVGA screens) and
+     * only receive the damaged rectangles, instead of a copy of every update.
+     */
+    bool fSharedSourceBitmap = false;
+    vrc = pDrvIns->pHlpR3->pfnCFGMQueryBoolDef(pCfg, "SharedSourceBitmap", &fSharedSourceBitmap, false);
+    AssertLogRelRCReturn(vrc, vrc);
+    pThis->pDisplay->mfSharedSourceBitmap = fSharedSourceBitmap;
+    if (fSharedSourceBitmap)
+        LogRel(("Display: Framebuffers share the source bitmap, sending damage notifications only\n"));
+
     /* Disable VRAM to a buffer copy initially. */
     pThis->pUpPort->pfnSetRenderVRAM(pThis->pUpPort, false);
     pThis->IConnector.cBits = 32; /* DevVGA does nothing otherwise. */
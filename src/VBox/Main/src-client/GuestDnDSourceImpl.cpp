@@ -135,13 +135,10 @@ GuestDnDSource::~GuestDnDSource(void) { }
 HRESULT GuestDnDSource::FinalConstruct(void)
 {
     /*
-     * Set the maximum block size this source can handle to 64K. This always has
-     * been hardcoded until now.
-     *
-     * Note: Never ever rely on information from the guest; the host dictates what and
-     *       how to do something, so try to negogiate a sensible value here later.
+     * Start with the block size every guest uses; a larger one gets accepted
+     * per transfer if the guest reported VBOX_DND_GF_0_LARGE_CHUNKS.
      */
-    mData.mcbBlockSize = DND_DEFAULT_CHUNK_SIZE; /** @todo Make this configurable. */
+    mData.mcbBlockSize = DND_DEFAULT_CHUNK_SIZE;
 
     LogFlowThisFunc(("\n"));
     return BaseFinalConstruct();
@@ -1067,6 +1064,9 @@ int GuestDnDSource::i_receiveData(GuestDnDRecvCtx *pCtx, RTMSINTERVAL msTimeout)
     AssertMsgReturn(pCtx->strFmtReq.isNotEmpty(),
                     ("Requested format from host is empty when it shouldn't\n"), VERR_INVALID_PARAMETER);
 
+    /* Guests which can handle large chunks also send them. */
+    mData.mcbBlockSize = m_pState->getChunkSize();
+
     /*
      * Do we need to receive a different format than initially requested?
      *
@@ -127,11 +127,9 @@ GuestDnDTarget::~GuestDnDTarget(void) { }
 
 HRESULT GuestDnDTarget::FinalConstruct(void)
 {
-    /* Set the maximum block size our guests can handle to 64K. This always has
-     * been hardcoded until now. */
-    /* Note: Never ever rely on information from the guest; the host dictates what and
-     *       how to do something, so try to negogiate a sensible value here later. */
-    mData.mcbBlockSize = DND_DEFAULT_CHUNK_SIZE; /** @todo Make this configurable. */
+    /* Start with the block size every guest can handle; a larger one gets
+     * picked per transfer if the guest reported VBOX_DND_GF_0_LARGE_CHUNKS. */
+    mData.mcbBlockSize = DND_DEFAULT_CHUNK_SIZE;
 
     LogFlowThisFunc(("\n"));
     return BaseFinalConstruct();
@@ -894,6 +892,10 @@ int GuestDnDTarget::i_sendData(GuestDnDSendCtx *pCtx, RTMSINTERVAL msTimeout)
     /* Clear all remaining outgoing messages. */
     m_DataBase.lstMsgOut.clear();
 
+    /* Use large chunks if the guest told us it can handle them. */
+    mData.mcbBlockSize = m_pState->getChunkSize();
+    LogRel2(("DnD: Using a chunk size of %RU32 bytes\n", mData.mcbBlockSize));
+
     /**
      * Do we need to build up a file tree?
      * Note: The decision whether we need to build up a file tree and sending
@@ -52,6 +52,7 @@
 #include <iprt/dir.h>
 #include <iprt/path.h>
 #include <iprt/fsvfs.h>
+#include <iprt/mem.h>
 
 
 /*********************************************************************************************************************************
@@ -73,6 +74,12 @@
  *  existent on the .ISO. */
 #define ISOFILE_FLAG_OPTIONAL            RT_BIT(8)
 
+/** Chunk size (in bytes) for copying files from / to the guest. */
+#define GSTCTL_COPY_CHUNK_SIZE_DEFAULT   _64K
+/** Max chunk size (in bytes) for copying files from / to guests which report
+ *  VBOX_GUESTCTRL_GF_0_FILE_BIG_CHUNKS. */
+#define GSTCTL_COPY_CHUNK_SIZE_MAX       _4M
+
 
 // session task classes
 /////////////////////////////////////////////////////////////////////////////
@@ -377,6 +384,22 @@ int GuestSessionTask::directoryCreateOnHost(const com::Utf8Str &strPath, uint32_
     return vrc;
 }
 
+/**
+ * Returns the chunk size to use for copying a file from / to the guest.
+ *
+ * Every chunk is a guest round trip, so use big chunks if the guest can
+ * handle them, but not (much) bigger than the file itself.
+ *
+ * @returns Chunk size (in bytes).
+ * @param   cbSize              Size (in bytes) to copy.
+ */
+uint32_t GuestSessionTask::fileCopyChunkSize(uint64_t cbSize)
+{
+    if (!(mSession->i_getParent()->i_getGuestControlFeatures0() & VBOX_GUESTCTRL_GF_0_FILE_BIG_CHUNKS))
+        return GSTCTL_COPY_CHUNK_SIZE_DEFAULT;
+    return (uint32_t)RT_ALIGN_64(RT_MIN(cbSize, GSTCTL_COPY_CHUNK_SIZE_MAX), GSTCTL_COPY_CHUNK_SIZE_DEFAULT);
+}
+
 /**
  * Main function for copying a file from guest to the host.
  *
@@ -417,12 +440,21 @@ int GuestSessionTask::fileCopyFromGuestInner(const Utf8Str &strSrcFile, ComObjPt
         }
     }
 
-    BYTE byBuf[_64K]; /** @todo Can we do better here? */
+    uint32_t const cbBuf = fileCopyChunkSize(cbSize);
+    BYTE          *pbBuf = (BYTE *)RTMemTmpAlloc(cbBuf);
+    if (!pbBuf)
+    {
+        setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                            Utf8StrFmt(tr("Allocating %RU32 bytes for copying guest file \"%s\" failed"),
+                                       cbBuf, strSrcFile.c_str()));
+        return VERR_NO_TMP_MEMORY;
+    }
+
     while (cbToRead)
     {
         uint32_t cbRead;
-        uint64_t const cbChunk = RT_MIN(cbToRead, sizeof(byBuf));
-        vrc = srcFile->i_readData((uint32_t)cbChunk, GSTCTL_DEFAULT_TIMEOUT_MS, byBuf, sizeof(byBuf), &cbRead);
+        uint64_t const cbChunk = RT_MIN(cbToRead, cbBuf);
+        vrc = srcFile->i_readData((uint32_t)cbChunk, GSTCTL_DEFAULT_TIMEOUT_MS, pbBuf, cbBuf, &cbRead);
         if (RT_FAILURE(vrc))
         {
             setProgressErrorMsg(VBOX_E_IPRT_ERROR,
@@ -431,7 +463,7 @@ int GuestSessionTask::fileCopyFromGuestInner(const Utf8Str &strSrcFile, ComObjPt
             break;
         }
 
-        vrc = RTFileWrite(*phDstFile, byBuf, cbRead, NULL /* No partial writes */);
+        vrc = RTFileWrite(*phDstFile, pbBuf, cbRead, NULL /* No partial writes */);
         if (RT_FAILURE(vrc))
         {
             setProgressErrorMsg(VBOX_E_IPRT_ERROR,
@@ -458,6 +490,8 @@ int GuestSessionTask::fileCopyFromGuestInner(const Utf8Str &strSrcFile, ComObjPt
             break;
     }
 
+    RTMemTmpFree(pbBuf);
+
     if (   SUCCEEDED(mProgress->COMGETTER(Canceled(&fCanceled)))
         && fCanceled)
         return VINF_SUCCESS;
@@ -750,12 +784,21 @@ int GuestSessionTask::fileCopyToGuestInner(const Utf8Str &strSrcFile, RTVFSFILE
         }
     }
 
-    BYTE byBuf[_64K];
+    uint32_t const cbBuf = fileCopyChunkSize(cbSize);
+    BYTE          *pbBuf = (BYTE *)RTMemTmpAlloc(cbBuf);
+    if (!pbBuf)
+    {
+        setProgressErrorMsg(VBOX_E_IPRT_ERROR,
+                            Utf8StrFmt(tr("Allocating %RU32 bytes for copying host file \"%s\" failed"),
+                                       cbBuf, strSrcFile.c_str()));
+        return VERR_NO_TMP_MEMORY;
+    }
+
     while (cbToRead)
     {
         size_t cbRead;
-        const uint32_t cbChunk = RT_MIN(cbToRead, sizeof(byBuf));
-        vrc = RTVfsFileRead(hVfsFile, byBuf, cbChunk, &cbRead);
+        const uint32_t cbChunk = (uint32_t)RT_MIN(cbToRead, cbBuf);
+        vrc = RTVfsFileRead(hVfsFile, pbBuf, cbChunk, &cbRead);
         if (RT_FAILURE(vrc))
         {
             setProgressErrorMsg(VBOX_E_IPRT_ERROR,
@@ -764,7 +807,7 @@ int GuestSessionTask::fileCopyToGuestInner(const Utf8Str &strSrcFile, RTVFSFILE
             break;
         }
 
-        vrc = fileDst->i_writeData(GSTCTL_DEFAULT_TIMEOUT_MS, byBuf, (uint32_t)cbRead, NULL /* No partial writes */);
+        vrc = fileDst->i_writeData(GSTCTL_DEFAULT_TIMEOUT_MS, pbBuf, (uint32_t)cbRead, NULL /* No partial writes */);
         if (RT_FAILURE(vrc))
         {
             setProgressErrorMsg(VBOX_E_IPRT_ERROR,
@@ -791,6 +834,8 @@ int GuestSessionTask::fileCopyToGuestInner(const Utf8Str &strSrcFile, RTVFSFILE
             break;
     }
 
+    RTMemTmpFree(pbBuf);
+
     if (RT_FAILURE(vrc))
         return vrc;
 
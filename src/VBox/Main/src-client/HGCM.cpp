@@ -86,6 +86,15 @@ struct _HGCMSVCEXTHANDLEDATA
 
 class HGCMClient;
 
+/** A guest call worker thread of a service (VBOXHGCMSVCFNTABLE::cWorkerThreads). */
+typedef struct HGCMSVCWORKER
+{
+    /** The worker thread. */
+    HGCMThread         *pThread;
+    /** Number of calls queued on or being processed by the worker. */
+    uint32_t volatile   cBusy;
+} HGCMSVCWORKER;
+
 /** Internal helper service object. HGCM code would use it to
  *  hold information about services and communicate with services.
  *  The HGCMService is an (in future) abstract class that implements
@@ -105,6 +114,17 @@ class HGCMService
 
         HGCMThread *m_pThread;
         friend DECLCALLBACK(void) hgcmServiceThread(HGCMThread *pThread, void *pvUser);
+        friend DECLCALLBACK(void) hgcmServiceWorkerThread(HGCMThread *pThread, void *pvUser);
+
+        /** Worker threads for guest calls the service allows to run in parallel,
+         * NULL if the service doesn't want any. */
+        HGCMSVCWORKER *m_paWorkers;
+        /** Number of entries in m_paWorkers. */
+        uint32_t m_cWorkers;
+        /** Held shared by the workers while calling pfnCall and exclusively by
+         * the service thread while processing a message (only when there are
+         * workers). */
+        RTSEMRW m_hSemWorkers;
 
         uint32_t volatile m_u32RefCnt;
 
@@ -142,11 +162,15 @@ class HGCMService
         STAMPROFILE m_StatHandleMsg;
         STAMCOUNTER m_StatTooManyClients;
         STAMCOUNTER m_StatTooManyCalls;
+        STAMCOUNTER m_StatWorkerCalls;
         /** @} */
 
         int loadServiceDLL(void);
         void unloadServiceDLL(void);
 
+        int workersCreate(void);
+        void workersDestroy(void);
+
         /*
          * Main HGCM thread methods.
          */
@@ -325,6 +349,9 @@ int HGCMService::sm_cServices = 0;
 HGCMService::HGCMService()
     :
     m_pThread    (NULL),
+    m_paWorkers  (NULL),
+    m_cWorkers   (0),
+    m_hSemWorkers(NIL_RTSEMRW),
     m_u32RefCnt  (0),
     m_pSvcNext   (NULL),
     m_pSvcPrev   (NULL),
@@ -514,6 +541,10 @@ class HGCMMsgSvcUnload: public HGCMMsgCore
 {
 };
 
+class HGCMMsgSvcQuit: public HGCMMsgCore
+{
+};
+
 class HGCMMsgSvcConnect: public HGCMMsgCore
 {
     public:
@@ -551,6 +582,7 @@ class HGCMMsgCall: public HGCMMsgHeader
     public:
         HGCMMsgCall()
             : pcCounter(NULL)
+            , pcWorkerBusy(NULL)
             , u32ClientId(0)
             , u32Function(0)
             , cParms(0)
@@ -560,6 +592,7 @@ class HGCMMsgCall: public HGCMMsgHeader
 
         HGCMMsgCall(HGCMThread *pThread)
             : pcCounter(NULL)
+            , pcWorkerBusy(NULL)
             , u32ClientId(0)
             , u32Function(0)
             , cParms(0)
@@ -578,6 +611,9 @@ class HGCMMsgCall: public HGCMMsgHeader
         /** Points to HGCMClient::cPendingCalls if it needs to be decremented. */
         uint32_t volatile *pcCounter;
 
+        /** Points to HGCMSVCWORKER::cBusy if the call was dispatched to a worker. */
+        uint32_t volatile *pcWorkerBusy;
+
         /* client identifier */
         uint32_t u32ClientId;
 
@@ -661,6 +697,7 @@ static HGCMMsgCore *hgcmMessageAllocSvc(uint32_t u32MsgId)
     {
         case SVC_MSG_LOAD:        return new HGCMMsgSvcLoad();
         case SVC_MSG_UNLOAD:      return new HGCMMsgSvcUnload();
+        case SVC_MSG_QUIT:        return new HGCMMsgSvcQuit();
         case SVC_MSG_CONNECT:     return new HGCMMsgSvcConnect();
         case SVC_MSG_DISCONNECT:  return new HGCMMsgSvcDisconnect();
         case SVC_MSG_HOSTCALL:    return new HGCMMsgHostCallSvc();
@@ -705,17 +742,34 @@ DECLCALLBACK(void) hgcmServiceThread(HGCMThread *pThread, void *pvUser)
         /* Cache required information to avoid unnecessary pMsgCore access. */
         uint32_t u32MsgId = pMsgCore->MsgId();
 
+        /* Keep the workers out of the service while it is being entered from
+           this thread.  Not for unloading, that waits for the workers to quit. */
+        bool const fExclusive = pSvc->m_cWorkers > 0 && u32MsgId != SVC_MSG_UNLOAD;
+        if (fExclusive)
+            RTSemRWRequestWrite(pSvc->m_hSemWorkers, RT_INDEFINITE_WAIT);
+
         switch (u32MsgId)
         {
             case SVC_MSG_LOAD:
             {
                 LogFlowFunc(("SVC_MSG_LOAD\n"));
                 vrc = pSvc->loadServiceDLL();
+                if (RT_SUCCESS(vrc))
+                {
+                    vrc = pSvc->workersCreate();
+                    if (RT_FAILURE(vrc))
+                    {
+                        pSvc->m_fntable.pfnUnload(pSvc->m_fntable.pvService);
+                        pSvc->unloadServiceDLL();
+                    }
+                }
             } break;
 
             case SVC_MSG_UNLOAD:
             {
                 LogFlowFunc(("SVC_MSG_UNLOAD\n"));
+                pSvc->workersDestroy();
+
                 if (pSvc->m_fntable.pfnUnload)
                 {
                     pSvc->m_fntable.pfnUnload(pSvc->m_fntable.pvService);
@@ -954,6 +1008,9 @@ DECLCALLBACK(void) hgcmServiceThread(HGCMThread *pThread, void *pvUser)
             } break;
         }
 
+        if (fExclusive)
+            RTSemRWReleaseWrite(pSvc->m_hSemWorkers);
+
         if (u32MsgId != SVC_MSG_GUESTCALL)
         {
             /* For SVC_MSG_GUESTCALL the service calls the completion helper.
@@ -965,6 +1022,168 @@ DECLCALLBACK(void) hgcmServiceThread(HGCMThread *pThread, void *pvUser)
     }
 }
 
+/*
+ * A worker thread of a service.  Only processes the guest calls which the
+ * service allows to run in parallel (VBOXHGCMSVCFNTABLE::pfnIsParallelCall).
+ */
+DECLCALLBACK(void) hgcmServiceWorkerThread(HGCMThread *pThread, void *pvUser)
+{
+    HGCMService *pSvc = (HGCMService *)pvUser;
+    AssertRelease(pSvc != NULL);
+
+    for (;;)
+    {
+        HGCMMsgCore *pMsgCore;
+        int vrc = hgcmMsgGet(pThread, &pMsgCore);
+
+        if (RT_FAILURE(vrc))
+        {
+            /* The error means some serious unrecoverable problem in the hgcmMsg/hgcmThread layer. */
+            AssertMsgFailed(("%Rrc\n", vrc));
+            break;
+        }
+
+        if (pMsgCore->MsgId() == SVC_MSG_GUESTCALL)
+        {
+            HGCMMsgCall *pMsg = (HGCMMsgCall *)pMsgCore;
+
+            LogFlowFunc(("SVC_MSG_GUESTCALL u32ClientId = %d, u32Function = %d, cParms = %d, paParms = %p\n",
+                         pMsg->u32ClientId, pMsg->u32Function, pMsg->cParms, pMsg->paParms));
+
+            /* The message may be completed and freed by the time pfnCall returns. */
+            uint32_t volatile *pcWorkerBusy = pMsg->pcWorkerBusy;
+
+            HGCMClient *pClient = HGCMClient::ReferenceByHandleForGuest(pMsg->u32ClientId);
+
+            if (pClient)
+            {
+                RTSemRWRequestRead(pSvc->m_hSemWorkers, RT_INDEFINITE_WAIT);
+                pSvc->m_fntable.pfnCall(pSvc->m_fntable.pvService, (VBOXHGCMCALLHANDLE)pMsg, pMsg->u32ClientId,
+                                        HGCM_CLIENT_DATA(pSvc, pClient), pMsg->u32Function,
+                                        pMsg->cParms, pMsg->paParms, pMsg->tsArrival);
+                RTSemRWReleaseRead(pSvc->m_hSemWorkers);
+
+                hgcmObjDereference(pClient);
+            }
+            else
+                hgcmMsgComplete(pMsgCore, VERR_HGCM_INVALID_CLIENT_ID);
+
+            if (pcWorkerBusy)
+                ASMAtomicDecU32(pcWorkerBusy);
+        }
+        else
+        {
+            AssertMsg(pMsgCore->MsgId() == SVC_MSG_QUIT, ("%#x\n", pMsgCore->MsgId()));
+            LogFlowFunc(("SVC_MSG_QUIT\n"));
+            hgcmMsgComplete(pMsgCore, VINF_SUCCESS);
+            break;
+        }
+    }
+}
+
+/**
+ * Creates the guest call worker threads the service asked for, if any.
+ *
+ * Called on the service thread after the service has been loaded.
+ *
+ * @returns VBox status code.
+ */
+int HGCMService::workersCreate(void)
+{
+    uint32_t const cWorkers = m_fntable.cWorkerThreads;
+    if (!cWorkers)
+        return VINF_SUCCESS;
+
+    AssertLogRelMsgReturn(   cWorkers <= VBOX_HGCM_SVC_MAX_WORKER_THREADS
+                          && !(m_fntable.fWorkerFlags & ~VBOX_HGCM_SVC_WORKER_F_VALID_MASK)
+                          && m_fntable.pfnIsParallelCall != NULL,
+                          ("%s: cWorkerThreads=%u fWorkerFlags=%#x pfnIsParallelCall=%p\n", m_pszSvcName,
+                           cWorkers, m_fntable.fWorkerFlags, m_fntable.pfnIsParallelCall),
+                          VERR_INVALID_PARAMETER);
+
+    int vrc = RTSemRWCreate(&m_hSemWorkers);
+    if (RT_FAILURE(vrc))
+        return vrc;
+
+    m_paWorkers = (HGCMSVCWORKER *)RTMemAllocZ(sizeof(m_paWorkers[0]) * cWorkers);
+    if (m_paWorkers)
+    {
+        /* Same naming scheme as the service thread, limited to 15 chars by RT. */
+        const char *pszName = m_pszSvcName;
+        if (!strncmp(pszName, RT_STR_TUPLE("VBoxShared")))
+            pszName += 8;
+        else if (!strncmp(pszName, RT_STR_TUPLE("VBox")))
+            pszName += 4;
+
+        for (uint32_t i = 0; i < cWorkers; i++)
+        {
+            char szThreadName[16];
+            RTStrPrintf(szThreadName, sizeof(szThreadName), "%.11sW%u", pszName, i);
+
+            char *pszStatsSubDir = RTStrAPrintf2("%s/Worker%u", m_pszSvcName, i);
+            if (!pszStatsSubDir)
+            {
+                vrc = VERR_NO_STR_MEMORY;
+                break;
+            }
+
+            vrc = hgcmThreadCreate(&m_paWorkers[i].pThread, szThreadName, hgcmServiceWorkerThread, this,
+                                   pszStatsSubDir, m_pUVM, m_pVMM);
+            RTStrFree(pszStatsSubDir);
+            if (RT_FAILURE(vrc))
+                break;
+            m_cWorkers = i + 1;
+        }
+
+        if (RT_SUCCESS(vrc))
+        {
+            LogRel2(("HGCMService::workersCreate: %u worker threads for %s, fWorkerFlags=%#x\n",
+                     m_cWorkers, m_pszSvcName, m_fntable.fWorkerFlags));
+            return VINF_SUCCESS;
+        }
+        LogRel(("HGCM: Failed to create worker thread #%u for %s: %Rrc\n", m_cWorkers, m_pszSvcName, vrc));
+    }
+    else
+        vrc = VERR_NO_MEMORY;
+
+    workersDestroy();
+    return vrc;
+}
+
+/**
+ * Terminates the guest call worker threads.
+ *
+ * Calls already queued on a worker are processed before it quits.  Called on
+ * the service thread before the service is unloaded.
+ */
+void HGCMService::workersDestroy(void)
+{
+    uint32_t const cWorkers = m_cWorkers;
+    ASMAtomicWriteU32(&m_cWorkers, 0);
+
+    for (uint32_t i = 0; i < cWorkers; i++)
+    {
+        HGCMMsgCore *pMsg;
+        int vrc = hgcmMsgAlloc(m_paWorkers[i].pThread, &pMsg, SVC_MSG_QUIT, hgcmMessageAllocSvc);
+        if (RT_SUCCESS(vrc))
+            vrc = hgcmMsgSend(pMsg);
+        if (RT_SUCCESS(vrc))
+            hgcmThreadWait(m_paWorkers[i].pThread);
+        else
+            AssertLogRelMsgFailed(("%s: Failed to stop worker #%u: %Rrc\n", m_pszSvcName, i, vrc)); /* leaks the thread */
+        m_paWorkers[i].pThread = NULL;
+    }
+
+    RTMemFree(m_paWorkers);
+    m_paWorkers = NULL;
+
+    if (m_hSemWorkers != NIL_RTSEMRW)
+    {
+        RTSemRWDestroy(m_hSemWorkers);
+        m_hSemWorkers = NIL_RTSEMRW;
+    }
+}
+
 /**
  * @interface_method_impl{VBOXHGCMSVCHELPERS,pfnCallComplete}
  */
@@ -1230,6 +1449,8 @@ void HGCMService::registerStatistics(const char *pszServiceName, PUVM pUVM, PCVM
                               "Message handling", "/HGCM/%s/Msg", pszServiceName);
     pVMM->pfnSTAMR3RegisterFU(pUVM, &m_StatTooManyCalls, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
                               "Too many calls (per client)", "/HGCM/%s/TooManyCalls", pszServiceName);
+    pVMM->pfnSTAMR3RegisterFU(pUVM, &m_StatWorkerCalls, STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                              "Guest calls dispatched to worker threads", "/HGCM/%s/WorkerCalls", pszServiceName);
     pVMM->pfnSTAMR3RegisterFU(pUVM, &m_StatTooManyClients, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
                               "Too many clients", "/HGCM/%s/TooManyClients", pszServiceName);
     pVMM->pfnSTAMR3RegisterFU(pUVM, &m_cClients, STAMTYPE_U32, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
@@ -2049,8 +2270,28 @@ int HGCMService::GuestCall(PPDMIHGCMPORT pHGCMPort, PVBOXHGCMCMD pCmd, uint32_t
 {
     LogFlow(("MAIN::HGCMService::GuestCall\n"));
 
+    /* Calls the service allows to run in parallel go to one of the workers:
+       the one for the client if calls must be kept in order, otherwise the
+       least busy one. */
+    HGCMThread    *pThread = m_pThread;
+    HGCMSVCWORKER *pWorker = NULL;
+    if (   m_cWorkers > 0
+        && m_fntable.pfnIsParallelCall(m_fntable.pvService, u32Function))
+    {
+        if (m_fntable.fWorkerFlags & VBOX_HGCM_SVC_WORKER_F_PER_CLIENT_ORDER)
+            pWorker = &m_paWorkers[u32ClientId % m_cWorkers];
+        else
+        {
+            pWorker = &m_paWorkers[0];
+            for (uint32_t i = 1; i < m_cWorkers && pWorker->cBusy > 0; i++)
+                if (m_paWorkers[i].cBusy < pWorker->cBusy)
+                    pWorker = &m_paWorkers[i];
+        }
+        pThread = pWorker->pThread;
+    }
+
     int vrc;
-    HGCMMsgCall *pMsg = new(std::nothrow) HGCMMsgCall(m_pThread);
+    HGCMMsgCall *pMsg = new(std::nothrow) HGCMMsgCall(pThread);
     if (pMsg)
     {
         pMsg->Reference(); /** @todo starts out with zero references. */
@@ -2070,6 +2311,12 @@ int HGCMService::GuestCall(PPDMIHGCMPORT pHGCMPort, PVBOXHGCMCMD pCmd, uint32_t
             pMsg->cParms      = cParms;
             pMsg->paParms     = paParms;
             pMsg->tsArrival   = tsArrival;
+            if (pWorker)
+            {
+                pMsg->pcWorkerBusy = &pWorker->cBusy;
+                ASMAtomicIncU32(&pWorker->cBusy);
+                STAM_REL_COUNTER_INC(&m_StatWorkerCalls);
+            }
 
             vrc = hgcmMsgPost(pMsg, hgcmMsgCallCompletionCallback);
 
@@ -2077,6 +2324,8 @@ int HGCMService::GuestCall(PPDMIHGCMPORT pHGCMPort, PVBOXHGCMCMD pCmd, uint32_t
             { /* Reference donated on success. */ }
             else
             {
+                if (pWorker)
+                    ASMAtomicDecU32(&pWorker->cBusy);
                 ASMAtomicDecU32(&pClient->cPendingCalls);
                 pMsg->pcCounter = NULL;
                 Log(("MAIN::HGCMService::GuestCall: hgcmMsgPost failed: %Rrc\n", vrc));
@@ -47,6 +47,12 @@
 #include <VBox/vmm/hm.h>
 #include <VBox/err.h>
 #include <iprt/cpp/utils.h>
+#include <iprt/time.h>
+
+
+/** Interval in milliseconds at which the folded stacks are rewritten while
+ * taking a continuous guest sample. */
+#define MACHINEDEBUGGER_SAMPLE_SNAPSHOT_INTERVAL_MS     RT_MS_1MIN
 
 
 // constructor / destructor
@@ -59,6 +65,9 @@ MachineDebugger::MachineDebugger()
     , mVirtualTimeRateQueued(UINT32_MAX)
     , mFlushMode(false)
     , m_hSampleReport(NULL)
+    , m_fSampleFolded(false)
+    , m_fSampleContinuous(false)
+    , m_msSampleSnapshotLast(0)
 {
 }
 
@@ -107,6 +116,9 @@ HRESULT MachineDebugger::init(Console *aParent)
     mFlushMode = false;
 
     m_hSampleReport = NULL;
+    m_fSampleFolded = false;
+    m_fSampleContinuous = false;
+    m_msSampleSnapshotLast = 0;
 
     /* Confirm a successful initialization */
     autoInitSpan.setSucceeded();
@@ -140,12 +152,34 @@ void MachineDebugger::uninit()
 
     int vrc = pThis->m_Progress->i_iprtProgressCallback(uPercentage, static_cast<Progress *>(pThis->m_Progress));
     if (   RT_SUCCESS(vrc)
-        && uPercentage == 100)
+        && uPercentage == 0
+        && pThis->m_fSampleContinuous)
+    {
+        /* Periodically refresh the folded stacks so the profile can be looked at while sampling continues. */
+        uint64_t const msNow = RTTimeMilliTS();
+        if (msNow - pThis->m_msSampleSnapshotLast >= MACHINEDEBUGGER_SAMPLE_SNAPSHOT_INTERVAL_MS)
+        {
+            PCVMMR3VTABLE const pVMM = pThis->mParent->i_getVMMVTable();
+            AssertPtrReturn(pVMM, VERR_INTERNAL_ERROR_3);
+
+            int vrc2 = pVMM->pfnDBGFR3SampleReportDumpFoldedToFile(pThis->m_hSampleReport, pThis->m_strFilename.c_str());
+            if (RT_FAILURE(vrc2))
+                LogRelMax(10, ("MachineDebugger: Writing the guest sample snapshot to '%s' failed with %Rrc\n",
+                               pThis->m_strFilename.c_str(), vrc2));
+            pThis->m_msSampleSnapshotLast = msNow;
+        }
+    }
+    else if (   uPercentage == 100
+             && (   RT_SUCCESS(vrc)
+                 || (vrc == VERR_CANCELLED && pThis->m_fSampleContinuous))) /* Cancelling is how continuous sampling is stopped. */
     {
         PCVMMR3VTABLE const pVMM = pThis->mParent->i_getVMMVTable();
         AssertPtrReturn(pVMM, VERR_INTERNAL_ERROR_3);
 
-        vrc = pVMM->pfnDBGFR3SampleReportDumpToFile(pThis->m_hSampleReport, pThis->m_strFilename.c_str());
+        if (pThis->m_fSampleFolded)
+            vrc = pVMM->pfnDBGFR3SampleReportDumpFoldedToFile(pThis->m_hSampleReport, pThis->m_strFilename.c_str());
+        else
+            vrc = pVMM->pfnDBGFR3SampleReportDumpToFile(pThis->m_hSampleReport, pThis->m_strFilename.c_str());
         pVMM->pfnDBGFR3SampleReportRelease(pThis->m_hSampleReport);
         pThis->m_hSampleReport = NULL;
         if (RT_SUCCESS(vrc))
@@ -1453,7 +1487,16 @@ HRESULT MachineDebugger::takeGuestSample(const com::Utf8Str &aFilename, ULONG aU
     {
         if (!m_hSampleReport)
         {
-            m_strFilename = aFilename;
+            /*
+             * A non-positive sample time samples until the progress object gets cancelled,
+             * writing the folded stacks periodically.  The folded stack format used by the
+             * flame graph tools can also be requested for a fixed sample time by using the
+             * .folded file extension.
+             */
+            m_strFilename          = aFilename;
+            m_fSampleContinuous    = aUsSampleTime <= 0;
+            m_fSampleFolded        = m_fSampleContinuous || aFilename.endsWithI(".folded");
+            m_msSampleSnapshotLast = RTTimeMilliTS();
 
             int vrc = ptrVM.vtable()->pfnDBGFR3SampleReportCreate(ptrVM.rawUVM(), aUsInterval,
                                                                   DBGF_SAMPLE_REPORT_F_STACK_REVERSE, &m_hSampleReport);
@@ -1467,7 +1510,9 @@ HRESULT MachineDebugger::takeGuestSample(const com::Utf8Str &aFilename, ULONG aU
                                            TRUE /* aCancelable */);
                     if (SUCCEEDED(hrc))
                     {
-                        vrc = ptrVM.vtable()->pfnDBGFR3SampleReportStart(m_hSampleReport, aUsSampleTime, i_dbgfProgressCallback,
+                        vrc = ptrVM.vtable()->pfnDBGFR3SampleReportStart(m_hSampleReport,
+                                                                         m_fSampleContinuous ? UINT32_MAX : (uint64_t)aUsSampleTime,
+                                                                         i_dbgfProgressCallback,
                                                                          static_cast<MachineDebugger*>(this));
                         if (RT_SUCCESS(vrc))
                             hrc = m_Progress.queryInterfaceTo(pProgress.asOutParam());
@@ -72,6 +72,7 @@
 #include <math.h>
 
 #include <iprt/formats/bmp.h>
+#include <iprt/mp.h>
 
 
 /*********************************************************************************************************************************
@@ -153,8 +154,13 @@ static DECLCALLBACK(int) recordingCodecVPXInit(PRECORDINGCODEC pCodec)
     /* ms per frame. */
     pVPX->Cfg.g_timebase.num = pCodec->Parms.msFrame;
     pVPX->Cfg.g_timebase.den = 1000;
-    /* Disable multithreading. */
-    pVPX->Cfg.g_threads      = 0;
+    /* Spread the encoding work over multiple threads. Screen content at typical recording
+     * resolutions doesn't scale beyond a few threads, so cap the automatic value. */
+    if (!pVPX->cEncoderThreads)
+        pVPX->cEncoderThreads = RT_MIN(RT_MAX(RTMpGetOnlineCount() / 2, 1), 4);
+    pVPX->Cfg.g_threads      = pVPX->cEncoderThreads;
+    /* We encode in real time, so don't let the encoder buffer up frames for look-ahead. */
+    pVPX->Cfg.g_lag_in_frames = 0;
 
     /* Initialize codec. */
     rcv = vpx_codec_enc_init(&pVPX->Ctx, pCodecIface, &pVPX->Cfg, 0 /* Flags */);
@@ -164,6 +170,29 @@ static DECLCALLBACK(int) recordingCodecVPXInit(PRECORDINGCODEC pCodec)
         return VERR_RECORDING_CODEC_INIT_FAILED;
     }
 
+    /* Pick an encoder speed matching the deadline if not explicitly configured.
+     * The libvpx default (0) is way too slow for real time encoding of screen content. */
+    if (pVPX->iEncoderCpuUsed == INT32_MAX)
+        pVPX->iEncoderCpuUsed = pVPX->uEncoderDeadline == VPX_DL_REALTIME ? 8 : 0;
+    if (pVPX->iEncoderCpuUsed)
+    {
+        rcv = vpx_codec_control(&pVPX->Ctx, VP8E_SET_CPUUSED, (int)pVPX->iEncoderCpuUsed);
+        if (rcv != VPX_CODEC_OK)
+            LogRel(("Recording: Failed to set VPX encoder speed to %RI32: %s\n",
+                    pVPX->iEncoderCpuUsed, vpx_codec_err_to_string(rcv)));
+    }
+
+    /* Guest desktops are mostly static: let the encoder skip unchanged macroblocks and
+     * use its screen content tools instead of doing full motion search on every frame. */
+    rcv = vpx_codec_control(&pVPX->Ctx, VP8E_SET_STATIC_THRESHOLD, 1U);
+    if (rcv == VPX_CODEC_OK)
+        rcv = vpx_codec_control(&pVPX->Ctx, VP8E_SET_SCREEN_CONTENT_MODE, 1U);
+    if (rcv != VPX_CODEC_OK)
+        LogRel2(("Recording: Unable to enable VPX screen content tuning: %s\n", vpx_codec_err_to_string(rcv)));
+
+    LogRel2(("Recording: VPX encoder uses %RU32 thread(s), speed %RI32, deadline %u\n",
+             pVPX->cEncoderThreads, pVPX->iEncoderCpuUsed, pVPX->uEncoderDeadline));
+
     if (!vpx_img_alloc(&pVPX->RawImage, VPX_IMG_FMT_I420,
                        pCodec->Parms.u.Video.uWidth, pCodec->Parms.u.Video.uHeight, 1))
     {
@@ -250,6 +279,17 @@ static DECLCALLBACK(int) recordingCodecVPXParseOptions(PRECORDINGCODEC pCodec, c
             else
                 pVPX->uEncoderDeadline = value.toUInt32();
         }
+        else if (key.compare("vc_threads", com::Utf8Str::CaseInsensitive) == 0)
+        {
+            /* 0 or "auto" lets us decide. */
+            pCodec->Video.VPX.cEncoderThreads = value.compare("auto", com::Utf8Str::CaseInsensitive) == 0
+                                              ? 0 : RT_MIN(value.toUInt32(), 64);
+        }
+        else if (key.compare("vc_cpuused", com::Utf8Str::CaseInsensitive) == 0)
+        {
+            int32_t const iCpuUsed = value.toInt32();
+            pCodec->Video.VPX.iEncoderCpuUsed = RT_MAX(RT_MIN(iCpuUsed, 16), -16);
+        }
         else
             LogRel2(("Recording: Unknown option '%s' (value '%s'), skipping\n", key.c_str(), value.c_str()));
     } /* while */
@@ -1054,6 +1094,9 @@ int recordingCodecCreateVideo(PRECORDINGCODEC pCodec, RecordingVideoCodec_T enmV
             pCodec->Ops.pfnEncode       = recordingCodecVPXEncode;
             pCodec->Ops.pfnScreenChange = recordingCodecVPXScreenChange;
 
+            pCodec->Video.VPX.cEncoderThreads = 0;         /* Automatic. */
+            pCodec->Video.VPX.iEncoderCpuUsed = INT32_MAX; /* Depends on the deadline. */
+
             vrc = VINF_SUCCESS;
             break;
         }
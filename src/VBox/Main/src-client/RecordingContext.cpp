@@ -2,12 +2,13 @@
 /** @file
  * Recording context code.
  *
- * This code employs a separate encoding thread per recording context
- * to keep time spent in EMT as short as possible. Each configured VM display
- * is represented by an own recording stream, which in turn has its own rendering
- * queue. Common recording data across all recording streams is kept in a
- * separate queue in the recording context to minimize data duplication and
- * multiplexing overhead in EMT.
+ * This code keeps time spent in EMT as short as possible by doing all the
+ * encoding work on separate threads. Each configured VM display is represented
+ * by an own recording stream, which in turn has its own rendering queue and
+ * encoding thread. Common recording data across all recording streams is kept
+ * in a separate queue in the recording context and is encoded + multiplexed by
+ * the recording context's thread, to minimize data duplication and multiplexing
+ * overhead in EMT.
  */
 
 /*
@@ -581,7 +582,9 @@ int RecordingContext::SetError(int rc, const com::Utf8Str &strText)
 }
 
 /**
- * Worker thread for all streams of a recording context.
+ * Worker thread for the common data of all streams of a recording context.
+ *
+ * The video data of each stream is encoded by the stream's own thread.
  */
 DECLCALLBACK(int) RecordingContextImpl::threadMain(RTTHREAD hThreadSelf, void *pvUser)
 {
@@ -619,16 +622,13 @@ DECLCALLBACK(int) RecordingContextImpl::threadMain(RTTHREAD hThreadSelf, void *p
 
         STAM_PROFILE_START(&pThis->m_STAM.profileDataStreams, streams);
 
-        /** @todo r=andy This is inefficient -- as we already wake up this thread
-         *               for every screen from Main, we here go again (on every wake up) through
-         *               all screens.  */
         RecordingStreams::iterator itStream = pThis->m_vecStreams.begin();
         while (itStream != pThis->m_vecStreams.end())
         {
             RecordingStream *pStream = (*itStream);
 
             /* Hand-in common encoded blocks. */
-            vrc = pStream->ThreadMain(vrcWait, msTimestamp, pThis->m_mapBlocksEncoded);
+            vrc = pStream->ProcessCommon(pThis->m_mapBlocksEncoded);
             if (RT_FAILURE(vrc))
             {
                 LogRel(("Recording: Processing stream #%RU16 failed (%Rrc)\n", pStream->GetID(), vrc));
@@ -1741,7 +1741,7 @@ int RecordingContext::SendVideoFrame(uint32_t uScreen, uint32_t uWidth, uint32_t
 
     int vrc = pStream->SendVideoFrame(&Frame, msTimestamp);
     if (vrc == VINF_SUCCESS) /* Might be VINF_RECORDING_THROTTLED or VINF_RECORDING_LIMIT_REACHED. */
-        m->threadNotify();
+        pStream->Notify();
 
 #if 0
     RecordingUtilsDbgDumpImageData(pauFramebuffer + offFrame, cbFramebuffer,
@@ -1786,7 +1786,7 @@ int RecordingContext::SendCursorPositionChange(uint32_t uScreen, int32_t x, int3
 
         vrc = pStream->SendCursorPos(0 /* idCursor */, &m->m_Cursor.m_Shape.Pos, msTimestamp);
         if (vrc == VINF_SUCCESS) /* Might be VINF_RECORDING_THROTTLED or VINF_RECORDING_LIMIT_REACHED. */
-            m->threadNotify();
+            pStream->Notify();
     }
 
     return vrc;
@@ -1833,6 +1833,8 @@ int RecordingContext::SendCursorShapeChange(bool fVisible, bool fAlpha, uint32_t
         m->updateInternal();
 
         int vrc2 = pStream->SendCursorShape(0 /* idCursor */, &m->m_Cursor.m_Shape, msTimestamp);
+        if (vrc2 == VINF_SUCCESS) /* Might be VINF_RECORDING_THROTTLED or VINF_RECORDING_LIMIT_REACHED. */
+            pStream->Notify();
         if (RT_SUCCESS(vrc))
             vrc = vrc2;
 
@@ -1845,9 +1847,6 @@ int RecordingContext::SendCursorShapeChange(bool fVisible, bool fAlpha, uint32_t
 
     m->unlock();
 
-    if (vrc == VINF_SUCCESS) /* Might be VINF_RECORDING_THROTTLED or VINF_RECORDING_LIMIT_REACHED. */
-        m->threadNotify();
-
     return vrc;
 }
 
@@ -1891,7 +1890,7 @@ int RecordingContext::SendScreenChange(uint32_t uScreen, uint32_t uWidth, uint32
 
     int const vrc = pStream->SendScreenChange(&Info, msTimestamp);
     if (vrc == VINF_SUCCESS) /* Might be VINF_RECORDING_THROTTLED or VINF_RECORDING_LIMIT_REACHED. */
-        m->threadNotify();
+        pStream->Notify();
 
     return vrc;
 }
@@ -184,7 +184,8 @@ void RecordingVideoFrameDestroy(PRECORDINGVIDEOFRAME pFrame)
     if (pFrame->pau8Buf)
     {
         Assert(pFrame->cbBuf);
-        RTMemFree(pFrame->pau8Buf);
+        if (!(pFrame->fFlags & RECORDINGVIDEOFRAME_F_POOLED)) /* Pooled buffers are owned (and freed) by the pool. */
+            RTMemFree(pFrame->pau8Buf);
         pFrame->pau8Buf = NULL;
         pFrame->cbBuf  = 0;
     }
@@ -459,6 +460,98 @@ int RecordingVideoFrameBlitFrame(PRECORDINGVIDEOFRAME pDstFrame, uint32_t uDstX,
                                  pSrcFrame->Info.uBytesPerLine, pSrcFrame->Info.uBPP, pSrcFrame->Info.enmPixelFmt);
 }
 
+/**
+ * Initializes a video frame pool.
+ *
+ * @param   pPool               Video frame pool to initialize.
+ */
+void RecordingVideoFramePoolInit(PRECORDINGVIDEOFRAMEPOOL pPool)
+{
+    RT_BZERO(pPool, sizeof(RECORDINGVIDEOFRAMEPOOL));
+}
+
+/**
+ * Destroys a video frame pool, freeing all of its buffers.
+ *
+ * @param   pPool               Video frame pool to destroy.
+ *
+ * @note    Buffers still handed out are freed as well, so all frames using
+ *          pooled buffers must not be touched anymore afterwards.
+ */
+void RecordingVideoFramePoolDestroy(PRECORDINGVIDEOFRAMEPOOL pPool)
+{
+    for (size_t i = 0; i < RT_ELEMENTS(pPool->aBufs); i++)
+    {
+        RTMemFree(pPool->aBufs[i].pau8Buf);
+        pPool->aBufs[i].pau8Buf = NULL;
+        pPool->aBufs[i].cbBuf   = 0;
+        pPool->aBufs[i].fInUse  = false;
+    }
+}
+
+/**
+ * Hands out a pixel buffer of a video frame pool.
+ *
+ * @returns Pointer to pixel buffer of at least \a cbBuf bytes, or NULL if all
+ *          buffers are in use or on allocation failure.
+ * @param   pPool               Video frame pool to acquire buffer from.
+ * @param   cbBuf               Size (in bytes) the buffer needs to have.
+ */
+uint8_t *RecordingVideoFramePoolAcquire(PRECORDINGVIDEOFRAMEPOOL pPool, size_t cbBuf)
+{
+    AssertReturn(cbBuf, NULL);
+
+    /* Prefer a free buffer which already is big enough, otherwise grow the first free one. */
+    PRECORDINGVIDEOFRAMEPOOLBUF pBuf = NULL;
+    for (size_t i = 0; i < RT_ELEMENTS(pPool->aBufs); i++)
+    {
+        if (pPool->aBufs[i].fInUse)
+            continue;
+        if (pPool->aBufs[i].cbBuf >= cbBuf)
+        {
+            pBuf = &pPool->aBufs[i];
+            break;
+        }
+        if (!pBuf)
+            pBuf = &pPool->aBufs[i];
+    }
+
+    if (!pBuf)
+        return NULL;
+
+    if (pBuf->cbBuf < cbBuf)
+    {
+        uint8_t *pau8New = (uint8_t *)RTMemRealloc(pBuf->pau8Buf, cbBuf);
+        AssertPtrReturn(pau8New, NULL);
+        pBuf->pau8Buf = pau8New;
+        pBuf->cbBuf   = cbBuf;
+    }
+
+    pBuf->fInUse = true;
+    return pBuf->pau8Buf;
+}
+
+/**
+ * Hands back a pixel buffer to a video frame pool.
+ *
+ * @param   pPool               Video frame pool to release buffer to.
+ * @param   pau8Buf             Buffer to release. Must have been returned by RecordingVideoFramePoolAcquire().
+ */
+void RecordingVideoFramePoolRelease(PRECORDINGVIDEOFRAMEPOOL pPool, uint8_t *pau8Buf)
+{
+    for (size_t i = 0; i < RT_ELEMENTS(pPool->aBufs); i++)
+    {
+        if (pPool->aBufs[i].pau8Buf == pau8Buf)
+        {
+            Assert(pPool->aBufs[i].fInUse);
+            pPool->aBufs[i].fInUse = false;
+            return;
+        }
+    }
+
+    AssertMsgFailed(("Buffer %p does not belong to pool %p\n", pau8Buf, pPool));
+}
+
 #ifdef VBOX_WITH_AUDIO_RECORDING
 /**
  * Destroys a recording audio frame.
@@ -292,11 +292,10 @@ bool RecordingStream::NeedsUpdate(uint64_t msTimestamp) const
  *
  * @returns VBox status code.
  * @param   streamBlockSet      Block set of stream to process.
- * @param   commonBlockSet      Block set of common blocks to process for this stream.
  *
- * @note    Runs in recording thread.
+ * @note    Runs in the stream's encoding thread.
  */
-int RecordingStream::process(RecordingBlockSet &streamBlockSet, RecordingBlockMap &commonBlockSet)
+int RecordingStream::process(RecordingBlockSet &streamBlockSet)
 {
     LogFlowFuncEnter();
 
@@ -370,6 +369,15 @@ int RecordingStream::process(RecordingBlockSet &streamBlockSet, RecordingBlockMa
 
             lock();
 
+            /* The pixel data has been consumed by the encoder, so hand the buffer back to the pool right away. */
+            if (   pFrame->enmType == RECORDINGFRAME_TYPE_VIDEO
+                && (pFrame->u.Video.fFlags & RECORDINGVIDEOFRAME_F_POOLED))
+            {
+                RecordingVideoFramePoolRelease(&m_Video.Pool, pFrame->u.Video.pau8Buf);
+                pFrame->u.Video.pau8Buf = NULL;
+                pFrame->u.Video.cbBuf   = 0;
+            }
+
             /* Release the block from the block list so that the housekeeping can handle it later. */
             (*itBlockInList)->Release();
 
@@ -388,6 +396,34 @@ int RecordingStream::process(RecordingBlockSet &streamBlockSet, RecordingBlockMa
 
     STAM_PROFILE_STOP(&m_STAM.profileFnProcessVideo, video);
 
+    STAM_PROFILE_STOP(&m_STAM.profileFnProcessTotal, total);
+
+    unlock();
+
+    LogFlowFuncLeaveRC(vrc);
+    return vrc;
+}
+
+/**
+ * Multiplexes common (encoded) data, e.g. audio, to a recording stream.
+ *
+ * @returns VBox status code.
+ * @param   commonBlockSet      Block set of common blocks to process for this stream.
+ *
+ * @note    Runs in the recording context's thread.
+ */
+int RecordingStream::ProcessCommon(RecordingBlockMap &commonBlockSet)
+{
+    lock();
+
+    if (!m_SettingsCache.fEnabled)
+    {
+        unlock();
+        return VINF_SUCCESS;
+    }
+
+    int vrc = VINF_SUCCESS;
+
     STAM_PROFILE_START(&m_STAM.profileFnProcessAudio, audio);
 
 #ifdef VBOX_WITH_AUDIO_RECORDING
@@ -443,8 +479,6 @@ int RecordingStream::process(RecordingBlockSet &streamBlockSet, RecordingBlockMa
 
     STAM_PROFILE_STOP(&m_STAM.profileFnProcessAudio, audio);
 
-    STAM_PROFILE_STOP(&m_STAM.profileFnProcessTotal, total);
-
     unlock();
 
     LogFlowFuncLeaveRC(vrc);
@@ -559,11 +593,10 @@ DECLCALLBACK(int) RecordingBlockWorkerHousekeeping::Worker(uint64_t msTimeout, b
  *                              Can be used for figuring out if the encoder has to perform some
  *                              worked based on that result.
  * @param   msTimestamp         Timestamp to use for PTS calculation (absolute).
- * @param   commonBlocks        Common blocks multiplexed to all recording streams.
  *
- * @note    Runs in encoding thread.
+ * @note    Runs in the stream's encoding thread.
  */
-int RecordingStream::ThreadMain(int rcWait, uint64_t msTimestamp, RecordingBlockMap &commonBlocks)
+int RecordingStream::ThreadMain(int rcWait, uint64_t msTimestamp)
 {
     Log3Func(("uScreenID=%RU16, msTimestamp=%RU64, rcWait=%Rrc\n", m_uScreenID, msTimestamp, rcWait));
 
@@ -577,7 +610,7 @@ int RecordingStream::ThreadMain(int rcWait, uint64_t msTimestamp, RecordingBlock
         return recordingCodecEncodeCurrent(&m_CodecVideo, msTimestamp);
     }
 
-    int vrc = process(m_BlockSet, commonBlocks);
+    int vrc = process(m_BlockSet);
 
     /*
      * Housekeeping.
@@ -590,6 +623,97 @@ int RecordingStream::ThreadMain(int rcWait, uint64_t msTimestamp, RecordingBlock
     return vrc;
 }
 
+/**
+ * Wakes up the stream's encoding thread.
+ *
+ * @returns VBox status code.
+ */
+int RecordingStream::Notify(void)
+{
+    if (m_hEvtThread == NIL_RTSEMEVENT)
+        return VINF_SUCCESS;
+    return RTSemEventSignal(m_hEvtThread);
+}
+
+/**
+ * Encoding thread of a recording stream.
+ *
+ * Each stream encodes on its own thread, so that multiple screens don't have
+ * to share (and wait on) a single encoder thread.
+ */
+/* static */
+DECLCALLBACK(int) RecordingStream::threadMain(RTTHREAD hThreadSelf, void *pvUser)
+{
+    RecordingStream *pThis = (RecordingStream *)pvUser;
+    AssertPtr(pThis);
+
+    /* Signal that we're up and rockin'. */
+    RTThreadUserSignal(hThreadSelf);
+
+    LogRel2(("Recording: Thread for stream #%RU16 started\n", pThis->m_uScreenID));
+
+    for (;;)
+    {
+        int const vrcWait = RTSemEventWait(pThis->m_hEvtThread, RT_MS_1SEC);
+
+        if (ASMAtomicReadBool(&pThis->m_fThreadShutdown))
+            break;
+
+        int const vrc = pThis->ThreadMain(vrcWait, pThis->m_pCtx->GetCurrentPTS());
+        if (RT_FAILURE(vrc))
+            LogRel(("Recording: Processing stream #%RU16 failed (%Rrc)\n", pThis->m_uScreenID, vrc));
+
+        /* Keep going in case of errors. */
+    }
+
+    LogRel2(("Recording: Thread for stream #%RU16 ended\n", pThis->m_uScreenID));
+    return VINF_SUCCESS;
+}
+
+/**
+ * Creates and starts the stream's encoding thread.
+ *
+ * @returns VBox status code.
+ */
+int RecordingStream::threadStart(void)
+{
+    AssertReturn(m_hThread == NIL_RTTHREAD, VERR_WRONG_ORDER);
+
+    ASMAtomicWriteBool(&m_fThreadShutdown, false);
+
+    int vrc = RTThreadCreateF(&m_hThread, RecordingStream::threadMain, (void *)this, 0,
+                              RTTHREADTYPE_MAIN_WORKER, RTTHREADFLAGS_WAITABLE, "Record%RU16", m_uScreenID);
+    if (RT_SUCCESS(vrc)) /* Wait for the thread to start. */
+        vrc = RTThreadUserWait(m_hThread, RT_MS_30SEC /* 30s timeout */);
+
+    return vrc;
+}
+
+/**
+ * Tells the stream's encoding thread to shut down and waits for it.
+ *
+ * @returns VBox status code.
+ *
+ * @note    Caller must not hold the stream's lock.
+ */
+int RecordingStream::threadStop(void)
+{
+    if (m_hThread == NIL_RTTHREAD)
+        return VINF_SUCCESS;
+
+    ASMAtomicWriteBool(&m_fThreadShutdown, true);
+
+    int vrc = RTSemEventSignal(m_hEvtThread);
+    if (RT_SUCCESS(vrc))
+        vrc = RTThreadWait(m_hThread, RT_MS_30SEC /* 30s timeout */, NULL);
+    if (RT_SUCCESS(vrc))
+        m_hThread = NIL_RTTHREAD;
+    else
+        LogRel(("Recording: Failed to stop thread of stream #%RU16 (%Rrc)\n", m_uScreenID, vrc));
+
+    return vrc;
+}
+
 /**
  * Adds a recording frame to be fed to the encoder.
  *
@@ -796,10 +920,17 @@ int RecordingStream::SendCursorShape(uint8_t idCursor, PRECORDINGVIDEOFRAME pSha
 /**
  * Sends a raw (e.g. not yet encoded) video frame to the recording stream.
  *
+ * The pixel data is copied into a buffer of the stream's frame pool. If all pool buffers
+ * are queued for encoding (the encoder can't keep up), the update is dropped and its area
+ * is re-read from the framebuffer together with the next update which gets through.
+ *
  * @returns VBox status code.
  * @retval  VINF_RECORDING_LIMIT_REACHED if the stream's recording limit has been reached.
- * @retval  VINF_RECORDING_THROTTLED if the frame is too early for the current FPS setting.
+ * @retval  VINF_RECORDING_THROTTLED if the frame is too early for the current FPS setting
+ *          or had to be dropped because the encoder is busy.
  * @param   pVideoFrame         Video frame to send.
+ *                              The pixel data must point into the screen's framebuffer, using
+ *                              the framebuffer's stride, as dropped areas are read back from there.
  * @param   msTimestamp         Timestamp (PTS, in ms).
  *
  * @note    Keep it as simple as possible, as this function might run on EMT.
@@ -811,24 +942,87 @@ int RecordingStream::SendVideoFrame(PRECORDINGVIDEOFRAME pVideoFrame, uint64_t m
     if (vrc != VINF_SUCCESS) /* Can return VINF_RECORDING_LIMIT_REACHED. */
         return vrc;
 
+    AssertReturn(pVideoFrame->Info.uBPP && pVideoFrame->Info.uBPP % 8 == 0, VERR_INVALID_PARAMETER);
+
+    uint32_t const cbPixel       = pVideoFrame->Info.uBPP / 8;
+    uint32_t const uBytesPerLine = pVideoFrame->Info.uBytesPerLine;
+
+    RTRECT Rect;
+    Rect.xLeft   = (int32_t)pVideoFrame->Pos.x;
+    Rect.yTop    = (int32_t)pVideoFrame->Pos.y;
+    Rect.xRight  = Rect.xLeft + (int32_t)pVideoFrame->Info.uWidth;
+    Rect.yBottom = Rect.yTop  + (int32_t)pVideoFrame->Info.uHeight;
+
+    const uint8_t *pu8Src = pVideoFrame->pau8Buf;
+
+    lock();
+
+    /* Pick up areas of dropped updates again, if the framebuffer layout still is the same. */
+    if (m_Video.fDropped)
+    {
+        if (   uBytesPerLine == m_Video.ScreenInfo.uBytesPerLine
+            && m_Video.RectDropped.xRight  <= (int32_t)m_Video.ScreenInfo.uWidth
+            && m_Video.RectDropped.yBottom <= (int32_t)m_Video.ScreenInfo.uHeight)
+        {
+            const uint8_t *pu8Base = pu8Src - (size_t)Rect.yTop * uBytesPerLine - (size_t)Rect.xLeft * cbPixel;
+
+            Rect.xLeft   = RT_MIN(Rect.xLeft,   m_Video.RectDropped.xLeft);
+            Rect.yTop    = RT_MIN(Rect.yTop,    m_Video.RectDropped.yTop);
+            Rect.xRight  = RT_MAX(Rect.xRight,  m_Video.RectDropped.xRight);
+            Rect.yBottom = RT_MAX(Rect.yBottom, m_Video.RectDropped.yBottom);
+
+            pu8Src = pu8Base + (size_t)Rect.yTop * uBytesPerLine + (size_t)Rect.xLeft * cbPixel;
+        }
+
+        m_Video.fDropped = false;
+    }
+
+    uint32_t const uWidth            = (uint32_t)(Rect.xRight - Rect.xLeft);
+    uint32_t const uHeight           = (uint32_t)(Rect.yBottom - Rect.yTop);
+    size_t   const cbDstBytesPerLine = (size_t)uWidth * cbPixel;
+    size_t   const cbBuf             = cbDstBytesPerLine * uHeight;
+
+    uint8_t *pau8Buf = RecordingVideoFramePoolAcquire(&m_Video.Pool, cbBuf);
+    if (!pau8Buf)
+    {
+        /* The encoder can't keep up -- drop this update instead of queuing up more and more frames. */
+        m_Video.RectDropped = Rect;
+        m_Video.fDropped    = true;
+
+        STAM_COUNTER_INC(&m_STAM.cVideoFramesDropped);
+
+        unlock();
+        return VINF_RECORDING_THROTTLED;
+    }
+
+    unlock();
+
     PRECORDINGFRAME pFrame = (PRECORDINGFRAME)RTMemAlloc(sizeof(RECORDINGFRAME));
-    AssertPtrReturn(pFrame, VERR_NO_MEMORY);
+    if (!pFrame)
+    {
+        lock();
+        RecordingVideoFramePoolRelease(&m_Video.Pool, pau8Buf);
+        unlock();
+        return VERR_NO_MEMORY;
+    }
 
-    pFrame->u.Video = *pVideoFrame;
+    pFrame->u.Video                    = *pVideoFrame;
+    pFrame->u.Video.Info.uWidth        = uWidth;
+    pFrame->u.Video.Info.uHeight       = uHeight;
+    pFrame->u.Video.Info.uBytesPerLine = (uint32_t)cbDstBytesPerLine;
+    pFrame->u.Video.Pos.x              = (uint32_t)Rect.xLeft;
+    pFrame->u.Video.Pos.y              = (uint32_t)Rect.yTop;
+    pFrame->u.Video.pau8Buf            = pau8Buf;
+    pFrame->u.Video.cbBuf              = cbBuf;
+    pFrame->u.Video.fFlags            |= RECORDINGVIDEOFRAME_F_POOLED;
 
     /* Make a deep copy of the pixel data. */
-    pFrame->u.Video.pau8Buf = (uint8_t *)RTMemAlloc(pVideoFrame->cbBuf);
-    AssertPtrReturnStmt(pFrame->u.Video.pau8Buf, RTMemFree(pFrame), VERR_NO_MEMORY);
-    size_t       offDst            = 0;
-    size_t       offSrc            = 0;
-    size_t const cbDstBytesPerLine = pVideoFrame->Info.uWidth * (pVideoFrame->Info.uBPP / 8);
-    for (uint32_t h = 0; h < pFrame->u.Video.Info.uHeight; h++)
+    for (uint32_t h = 0; h < uHeight; h++)
     {
-        memcpy(pFrame->u.Video.pau8Buf + offDst, pVideoFrame->pau8Buf + offSrc, cbDstBytesPerLine);
-        offDst += cbDstBytesPerLine;
-        offSrc += pVideoFrame->Info.uBytesPerLine;
+        memcpy(pau8Buf, pu8Src, cbDstBytesPerLine);
+        pau8Buf += cbDstBytesPerLine;
+        pu8Src  += uBytesPerLine;
     }
-    pFrame->u.Video.Info.uBytesPerLine = (uint32_t)cbDstBytesPerLine;
 
     pFrame->enmType     = RECORDINGFRAME_TYPE_VIDEO;
     pFrame->msTimestamp = msTimestamp;
@@ -836,15 +1030,14 @@ int RecordingStream::SendVideoFrame(PRECORDINGVIDEOFRAME pVideoFrame, uint64_t m
     lock();
 
     vrc = addFrame(pFrame, msTimestamp);
-
-    unlock();
-
-    if (RT_FAILURE(vrc))
+    if (vrc != VINF_SUCCESS) /* Not queued (e.g. VWRN_RECORDING_ENCODING_SKIPPED)? Hand back the buffer. */
     {
-        RecordingVideoFrameDestroy(&pFrame->u.Video);
+        RecordingVideoFramePoolRelease(&m_Video.Pool, pFrame->u.Video.pau8Buf);
         RecordingFrameFree(pFrame);
     }
 
+    unlock();
+
     LogFlowFuncLeaveRC(vrc);
     return vrc;
 }
@@ -882,6 +1075,7 @@ int RecordingStream::SendScreenChange(PRECORDINGSURFACEINFO pInfo, uint64_t msTi
     }
 
     m_Video.ScreenInfo = *pInfo;
+    m_Video.fDropped   = false; /* The whole screen gets updated after a screen change anyway. */
 
     LogRel(("Recording: Screen size of stream #%RU32 changed to %RU32x%RU32 (%RU8 BPP)\n",
             m_uScreenID, m_Video.ScreenInfo.uWidth, m_Video.ScreenInfo.uHeight, m_Video.ScreenInfo.uBPP));
@@ -921,6 +1115,10 @@ int RecordingStream::Start(void)
 
     unlock();
 
+    vrc = threadStart();
+    if (RT_FAILURE(vrc))
+        LogRel(("Recording: Failed to start thread of stream #%RU32 (%Rrc)\n", m_uScreenID, vrc));
+
     return vrc;
 }
 
@@ -945,6 +1143,8 @@ int RecordingStream::Stop(void)
 
     unlock();
 
+    vrc = threadStop();
+
     return vrc;
 }
 
@@ -990,6 +1190,9 @@ int RecordingStream::initInternal(RecordingContext *pCtx, uint32_t uScreen,
     m_uTrackVideo    = UINT8_MAX;
     m_tsStartMs      = 0;
     m_uScreenID      = uScreen;
+    m_hThread        = NIL_RTTHREAD;
+    m_hEvtThread     = NIL_RTSEMEVENT;
+    m_fThreadShutdown = false;
 #ifdef VBOX_WITH_AUDIO_RECORDING
     m_pCodecAudio    = pCodecAudio;
 #else
@@ -998,6 +1201,9 @@ int RecordingStream::initInternal(RecordingContext *pCtx, uint32_t uScreen,
     m_Settings = ScreenSettings;
 
     RT_ZERO(m_Video.ScreenInfo);
+    RecordingVideoFramePoolInit(&m_Video.Pool);
+    m_Video.fDropped = false;
+    RT_ZERO(m_Video.RectDropped);
 
     /*
      * Populate cached settings.
@@ -1020,6 +1226,10 @@ int RecordingStream::initInternal(RecordingContext *pCtx, uint32_t uScreen,
     if (RT_FAILURE(vrc))
         return vrc;
 
+    vrc = RTSemEventCreate(&m_hEvtThread);
+    if (RT_FAILURE(vrc))
+        return vrc;
+
     this->File.m_pWEBM = NULL;
     this->File.m_hFile = NIL_RTFILE;
 
@@ -1168,6 +1378,9 @@ int RecordingStream::initInternal(RecordingContext *pCtx, uint32_t uScreen,
          ptrVM.vtable()->pfnSTAMR3RegisterFU(ptrVM.rawUVM(), &m_STAM.cVideoFramesHousekeeping,
                                              STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
                                              "Current video frames in housekeeping queue.", "/Main/Recording/Stream%RU32/VideoFramesHousekeeping", uScreen);
+         ptrVM.vtable()->pfnSTAMR3RegisterFU(ptrVM.rawUVM(), &m_STAM.cVideoFramesDropped,
+                                             STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                                             "Video frames dropped because the encoder was busy.", "/Main/Recording/Stream%RU32/VideoFramesDropped", uScreen);
 
          ptrVM.vtable()->pfnSTAMR3RegisterFU(ptrVM.rawUVM(), &m_STAM.profileFnProcessTotal,
                                              STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_CALL,
@@ -1319,11 +1532,22 @@ int RecordingStream::uninitInternal(void)
     if (m_enmState == RECORDINGSTREAMSTATE_UNINITIALIZED)
         return VINF_SUCCESS;
 
+    /* The encoding thread might still run if the stream was stopped by reaching its limit. */
+    int vrc = threadStop();
+    if (RT_FAILURE(vrc))
+        return vrc;
+
     lock();
 
-    int vrc = close();
+    vrc = close();
     if (RT_FAILURE(vrc))
+    {
+        unlock();
         return vrc;
+    }
+
+    /* Must come after close(), as that gets rid of all frames still referencing pooled buffers. */
+    RecordingVideoFramePoolDestroy(&m_Video.Pool);
 
 #ifdef VBOX_WITH_AUDIO_RECORDING
     m_pCodecAudio = NULL;
@@ -1340,6 +1564,9 @@ int RecordingStream::uninitInternal(void)
 
         RTCritSectDelete(&m_CritSect);
 
+        RTSemEventDestroy(m_hEvtThread);
+        m_hEvtThread = NIL_RTSEMEVENT;
+
 #ifdef VBOX_WITH_STATISTICS
         Console::SafeVMPtrQuiet ptrVM(m_pCtx->GetConsole());
         if (ptrVM.isOk())
@@ -1349,6 +1576,7 @@ int RecordingStream::uninitInternal(void)
             ptrVM.vtable()->pfnSTAMR3DeregisterF(ptrVM.rawUVM(), "/Main/Recording/Stream%RU32/VideoFramesEncoded", m_uScreenID);
 
             ptrVM.vtable()->pfnSTAMR3DeregisterF(ptrVM.rawUVM(), "/Main/Recording/Stream%RU32/VideoFramesHousekeeping", m_uScreenID);
+            ptrVM.vtable()->pfnSTAMR3DeregisterF(ptrVM.rawUVM(), "/Main/Recording/Stream%RU32/VideoFramesDropped", m_uScreenID);
 
             ptrVM.vtable()->pfnSTAMR3DeregisterF(ptrVM.rawUVM(), "/Main/Recording/Stream%RU32/ProfileFnProcessVideo", m_uScreenID);
 # ifdef VBOX_WITH_AUDIO_RECORDING
@@ -1424,8 +1652,15 @@ DECLCALLBACK(int) RecordingStream::codecWriteDataCallback(PRECORDINGCODEC pCodec
     RecordingStream *pThis = (RecordingStream *)pvUser;
     AssertPtr(pThis);
 
+    /* Serialize with the recording context's thread multiplexing (audio) data into the same file. */
+    pThis->lock();
+
     /** @todo For now this is hardcoded to always write to a WebM file. Add other stuff later. */
-    return pThis->codecWriteToWebM(pCodec, pvData, cbData, msAbsPTS, uFlags);
+    int const vrc = pThis->codecWriteToWebM(pCodec, pvData, cbData, msAbsPTS, uFlags);
+
+    pThis->unlock();
+
+    return vrc;
 }
 
 /**
@@ -34,10 +34,13 @@
 #include "LoggingNew.h"
 
 #include <iprt/asm.h>
+#include <iprt/crc.h>
 #include <iprt/err.h>
 #include <iprt/file.h>
 #include <iprt/net.h>
 #include <iprt/path.h>
+#include <iprt/stream.h>
+#include <iprt/string.h>
 #include <iprt/cpp/path.h>
 #include <iprt/cpp/utils.h>
 #include <iprt/cpp/xml.h>
@@ -1047,6 +1050,9 @@ HRESULT DHCPServer::findLeaseByMAC(const com::Utf8Str &aMac, LONG aType,
         /*
          * Look for that mac address.
          */
+        bool     fFound      = false;
+        int64_t  secIssued   = 0;
+        uint32_t cSecsToLive = 0;
         xml::ElementNode *pElmRoot = doc.getRootElement();
         if (pElmRoot && pElmRoot->nameEquals("Leases"))
         {
@@ -1064,15 +1070,11 @@ HRESULT DHCPServer::findLeaseByMAC(const com::Utf8Str &aMac, LONG aType,
                         /*
                          * Found it!
                          */
-                        xml::ElementNode const *pElmTime    = pElmLease->findChildElement("Time");
-                        int64_t                 secIssued   = 0;
-                        uint32_t                cSecsToLive = 0;
+                        xml::ElementNode const *pElmTime = pElmLease->findChildElement("Time");
                         if (pElmTime)
                         {
                             pElmTime->getAttributeValue("issued", &secIssued);
                             pElmTime->getAttributeValue("expiration", &cSecsToLive);
-                            *aIssued = secIssued;
-                            *aExpire = secIssued + cSecsToLive;
                         }
                         try
                         {
@@ -1083,17 +1085,33 @@ HRESULT DHCPServer::findLeaseByMAC(const com::Utf8Str &aMac, LONG aType,
                         {
                             return E_OUTOFMEMORY;
                         }
-
-                        /* Check if the lease has expired in the mean time. */
-                        HRESULT hrc = S_OK;
-                        RTTIMESPEC Now;
-                        if (   (aState.equals("acked") || aState.equals("offered") || aState.isEmpty())
-                            && secIssued + cSecsToLive < RTTimeSpecGetSeconds(RTTimeNow(&Now)))
-                            hrc = RT_SUCCESS(aState.assignNoThrow("expired")) ? S_OK : E_OUTOFMEMORY;
-                        return hrc;
+                        fFound = true;
+                        break;
                     }
                 }
         }
+
+        /*
+         * The DHCP server appends changes to a journal and only folds them
+         * into the lease file every now and then, so the last journal record
+         * for the mac address (if any) is the current state.
+         */
+        HRESULT hrc = i_findLeaseInJournal(MacAddress, aAddress, aState, &secIssued, &cSecsToLive, &fFound);
+        if (FAILED(hrc))
+            return hrc;
+
+        if (fFound)
+        {
+            *aIssued = secIssued;
+            *aExpire = secIssued + cSecsToLive;
+
+            /* Check if the lease has expired in the mean time. */
+            RTTIMESPEC Now;
+            if (   (aState.equals("acked") || aState.equals("offered") || aState.isEmpty())
+                && secIssued + cSecsToLive < RTTimeSpecGetSeconds(RTTimeNow(&Now)))
+                hrc = RT_SUCCESS(aState.assignNoThrow("expired")) ? S_OK : E_OUTOFMEMORY;
+            return hrc;
+        }
         break;
     }
 
@@ -1101,6 +1119,88 @@ HRESULT DHCPServer::findLeaseByMAC(const com::Utf8Str &aMac, LONG aType,
 }
 
 
+/**
+ * Looks up the last record for @a rMacAddress in the DHCP server lease journal.
+ *
+ * @returns COM status code, S_OK also if not found or if there is no journal.
+ * @param   rMacAddress     The MAC address to look for.
+ * @param   aAddress        Where to return the address if found.
+ * @param   aState          Where to return the lease state if found.
+ * @param   psecIssued      Where to return the issue time if found.
+ * @param   pcSecsToLive    Where to return the lease time if found.
+ * @param   pfFound         Set to true if found, left alone if not.
+ * @note    The journal format is defined by Binding::toJournal() in
+ *          NetworkServices/Dhcpd/Db.cpp and is checked the same way as
+ *          Db::i_checkJournalRecord() does it, keep in sync.
+ */
+HRESULT DHCPServer::i_findLeaseInJournal(RTMAC const &rMacAddress, com::Utf8Str &aAddress, com::Utf8Str &aState,
+                                         int64_t *psecIssued, uint32_t *pcSecsToLive, bool *pfFound)
+{
+    com::Utf8Str strJournal;
+    int vrc = strJournal.printfNoThrow("%s-journal", m->strLeasesFilename.c_str());
+    if (RT_FAILURE(vrc))
+        return E_OUTOFMEMORY;
+
+    PRTSTREAM pStrm;
+    vrc = RTStrmOpen(strJournal.c_str(), "r", &pStrm);
+    if (RT_FAILURE(vrc))
+        return S_OK;
+
+    char szLine[1024];
+    while (RT_SUCCESS(vrc = RTStrmGetLine(pStrm, szLine, sizeof(szLine))))
+    {
+        /* "lease <address> <state> <issued> <expiration> <mac> [<client-id>] *<crc>"
+           The DHCP server ignores everything from the first torn record on, so do we. */
+        char *psz = RTStrStrip(szLine);
+        if (*psz == '\0' || *psz == '#')
+            continue;
+        char    *pszCrc = strrchr(psz, ' ');
+        uint32_t uCrc;
+        if (   !pszCrc
+            || pszCrc[1] != '*'
+            || RTStrToUInt32Full(&pszCrc[2], 16, &uCrc) != VINF_SUCCESS
+            || uCrc != RTCrc32(psz, (size_t)(pszCrc - psz)))
+            break;
+        *pszCrc = '\0';
+
+        char    *apszFields[6];
+        unsigned cFields = 0;
+        while (*psz != '\0' && cFields < RT_ELEMENTS(apszFields))
+        {
+            apszFields[cFields++] = psz;
+            char *pszEnd = strchr(psz, ' ');
+            if (!pszEnd)
+                break;
+            *pszEnd = '\0';
+            psz = RTStrStripL(pszEnd + 1);
+        }
+
+        RTMAC    CurMacAddress;
+        int64_t  secIssued;
+        uint32_t cSecsToLive;
+        if (   cFields == RT_ELEMENTS(apszFields)
+            && strcmp(apszFields[0], "lease") == 0
+            && RT_SUCCESS(RTNetStrToMacAddr(apszFields[5], &CurMacAddress))
+            && memcmp(&CurMacAddress, &rMacAddress, sizeof(rMacAddress)) == 0
+            && RTStrToInt64Full(apszFields[3], 10, &secIssued) == VINF_SUCCESS
+            && RTStrToUInt32Full(apszFields[4], 10, &cSecsToLive) == VINF_SUCCESS)
+        {
+            if (   RT_FAILURE(aAddress.assignNoThrow(apszFields[1]))
+                || RT_FAILURE(aState.assignNoThrow(apszFields[2])))
+            {
+                RTStrmClose(pStrm);
+                return E_OUTOFMEMORY;
+            }
+            *psecIssued   = secIssued;
+            *pcSecsToLive = cSecsToLive;
+            *pfFound      = true;
+        }
+    }
+    RTStrmClose(pStrm);
+    return S_OK;
+}
+
+
 HRESULT DHCPServer::getConfig(DHCPConfigScope_T aScope, const com::Utf8Str &aName, ULONG aSlot, BOOL aMayAdd,
                               ComPtr<IDHCPConfig> &aConfig)
 {
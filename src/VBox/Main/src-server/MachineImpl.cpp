@@ -573,17 +573,29 @@ HRESULT Machine::init(VirtualBox *aParent,
  *                      be relative to the VirtualBox config directory).
  *  @param aId          UUID of the machine or NULL (see above).
  *  @param strPassword  Password for decrypting the config
+ *  @param pPreparsedConfig  The machine settings already parsed from
+ *                      strConfigFile by VirtualBox::initMachines(), or NULL.
+ *                      Only valid together with aId.  Ownership is always
+ *                      taken, even on failure.
  *
  *  @return  Success indicator. if not S_OK, the machine object is invalid
  */
 HRESULT Machine::initFromSettings(VirtualBox *aParent,
                                   const Utf8Str &strConfigFile,
                                   const Guid *aId,
-                                  const com::Utf8Str &strPassword)
+                                  const com::Utf8Str &strPassword,
+                                  settings::MachineConfigFile *pPreparsedConfig /* = NULL */)
 {
     LogFlowThisFuncEnter();
     LogFlowThisFunc(("(Init_Registered) aConfigFile='%s\n", strConfigFile.c_str()));
 
+    Assert(!pPreparsedConfig || (aId && strPassword.isEmpty()));
+    if (pPreparsedConfig && (!aId || strPassword.isNotEmpty()))
+    {
+        delete pPreparsedConfig;
+        pPreparsedConfig = NULL;
+    }
+
     PCVBOXCRYPTOIF pCryptoIf = NULL;
 #ifndef VBOX_WITH_FULL_VM_ENCRYPTION
     if (strPassword.isNotEmpty())
@@ -600,18 +612,26 @@ HRESULT Machine::initFromSettings(VirtualBox *aParent,
 
     /* Enclose the state transition NotReady->InInit->Ready */
     AutoInitSpan autoInitSpan(this);
-    AssertReturn(autoInitSpan.isOk(), E_FAIL);
+    if (!autoInitSpan.isOk())
+    {
+        delete pPreparsedConfig;
+        AssertFailedReturn(E_FAIL);
+    }
 
     HRESULT hrc = initImpl(aParent, strConfigFile);
-    if (FAILED(hrc)) return hrc;
+    if (FAILED(hrc))
+    {
+        delete pPreparsedConfig;
+        return hrc;
+    }
 
     if (aId)
     {
         // loading a registered VM:
         unconst(mData->mUuid) = *aId;
         mData->mRegistered = TRUE;
-        // now load the settings from XML:
-        hrc = i_registeredInit();
+        // now load the settings from XML (unless already done):
+        hrc = i_registeredInit(pPreparsedConfig);
             // this calls initDataAndChildObjects() and loadSettings()
     }
     else
@@ -915,17 +935,25 @@ HRESULT Machine::i_tryCreateMachineConfigFile(bool fForceOverwrite)
  *  startup the whole VirtualBox server in case if the settings file of some
  *  registered VM is invalid or inaccessible.
  *
+ *  @param pPreparsedConfig  The settings file already parsed without any
+ *                      cryptographic interface, or NULL to parse it here.
+ *                      Ownership is always taken.
+ *
  *  @note Must be always called from this object's write lock
  *        (unless called from #init() that doesn't need any locking).
  *  @note Locks the mUSBController method for writing.
  *  @note Subclasses must not call this method.
  */
-HRESULT Machine::i_registeredInit()
+HRESULT Machine::i_registeredInit(settings::MachineConfigFile *pPreparsedConfig /* = NULL */)
 {
-    AssertReturn(!i_isSessionMachine(), E_FAIL);
-    AssertReturn(!i_isSnapshotMachine(), E_FAIL);
-    AssertReturn(mData->mUuid.isValid(), E_FAIL);
-    AssertReturn(!mData->mAccessible, E_FAIL);
+    if (   i_isSessionMachine()
+        || i_isSnapshotMachine()
+        || !mData->mUuid.isValid()
+        || mData->mAccessible)
+    {
+        delete pPreparsedConfig;
+        AssertFailedReturn(E_FAIL);
+    }
 
     HRESULT hrc = initDataAndChildObjects();
     if (SUCCEEDED(hrc))
@@ -963,9 +991,17 @@ HRESULT Machine::i_registeredInit()
         {
             try
             {
-                // load and parse machine XML; this will throw on XML or logic errors
-                mData->pMachineConfigFile = new settings::MachineConfigFile(&mData->m_strConfigFileFull,
-                                                                            pCryptoIf, pszPassword);
+                if (pPreparsedConfig && !pCryptoIf)
+                {
+                    mData->pMachineConfigFile = pPreparsedConfig;
+                    pPreparsedConfig = NULL;
+                }
+                else
+                {
+                    // load and parse machine XML; this will throw on XML or logic errors
+                    mData->pMachineConfigFile = new settings::MachineConfigFile(&mData->m_strConfigFileFull,
+                                                                                pCryptoIf, pszPassword);
+                }
 
                 if (mData->mUuid != mData->pMachineConfigFile->uuid)
                     throw setError(E_FAIL,
@@ -1012,6 +1048,9 @@ HRESULT Machine::i_registeredInit()
 #endif
     }
 
+    /* Not consumed above (failure or encrypted machine). */
+    delete pPreparsedConfig;
+
     if (SUCCEEDED(hrc))
     {
         /* Set mAccessible to TRUE only if we successfully locked and loaded
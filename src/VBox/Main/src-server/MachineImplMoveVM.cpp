@@ -40,6 +40,8 @@
 #include "VirtualBoxImpl.h"
 #include "LoggingNew.h"
 
+#include <set>
+
 typedef std::multimap<Utf8Str, Utf8Str> list_t;
 typedef std::multimap<Utf8Str, Utf8Str>::const_iterator cit_t;
 typedef std::multimap<Utf8Str, Utf8Str>::iterator it_t;
@@ -1121,6 +1123,34 @@ void MachineMoveVM::i_MoveVMThreadTask(MachineMoveVM *task)
     LogFlowFuncLeave();
 }
 
+/**
+ * Returns how many media moveAllDisks() may move at the same time.
+ *
+ * Can be tuned with the VBoxInternal2/MoveVMParallelMedia global extra data
+ * item, setting it to 1 restores strictly sequential moving.
+ *
+ * @note Must not be called with the machine lock held.
+ */
+uint32_t MachineMoveVM::queryMaxParallelMoves() const
+{
+    uint32_t cMax = MOVEVM_PARALLEL_MEDIA_DEFAULT;
+
+    Bstr bstrValue;
+    HRESULT hrc = m_pMachine->i_getVirtualBox()->GetExtraData(Bstr("VBoxInternal2/MoveVMParallelMedia").raw(),
+                                                              bstrValue.asOutParam());
+    if (SUCCEEDED(hrc) && bstrValue.isNotEmpty())
+    {
+        uint32_t cValue = 0;
+        int vrc = RTStrToUInt32Full(Utf8Str(bstrValue).c_str(), 10, &cValue);
+        if (vrc == VINF_SUCCESS && cValue > 0)
+            cMax = RT_MIN(cValue, MOVEVM_PARALLEL_MEDIA_MAX);
+        else
+            LogRel(("MoveVM: Ignoring invalid VBoxInternal2/MoveVMParallelMedia value '%ls'\n", bstrValue.raw()));
+    }
+
+    return cMax;
+}
+
 HRESULT MachineMoveVM::moveAllDisks(const std::map<Utf8Str, MEDIUMTASKMOVE> &listOfDisks,
                                     const Utf8Str &strTargetFolder)
 {
@@ -1128,6 +1158,22 @@ HRESULT MachineMoveVM::moveAllDisks(const std::map<Utf8Str, MEDIUMTASKMOVE> &lis
     ComObjPtr<Machine> &machine = m_pMachine;
     Utf8Str strLocation;
 
+    /* A medium move is mostly I/O bound, so when media from different chains
+     * are involved (e.g. several base disks) their moves are started together
+     * and then waited for in order.  IMedium::MoveTo() write-locks the whole
+     * chain of the medium, so media sharing a base are still moved one after
+     * another, in the original order. */
+    uint32_t const cMaxParallel = queryMaxParallelMoves();
+
+    /** A medium move which has been started. */
+    struct MoveOp
+    {
+        ComPtr<IProgress>   pProgress;
+        Bstr                bstrSrcName;
+        Utf8Str             strTargetImageName;
+        ULONG               uWeight;
+    };
+
     AutoWriteLock  machineLock(machine COMMA_LOCKVAL_SRC_POS);
 
     try
@@ -1135,75 +1181,125 @@ HRESULT MachineMoveVM::moveAllDisks(const std::map<Utf8Str, MEDIUMTASKMOVE> &lis
         std::map<Utf8Str, MEDIUMTASKMOVE>::const_iterator itMedium = listOfDisks.begin();
         while (itMedium != listOfDisks.end())
         {
-            const MEDIUMTASKMOVE &mt = itMedium->second;
-            ComPtr<IMedium> pMedium = mt.pMedium;
-            Utf8Str strTargetImageName;
-            Bstr bstrLocation;
-            Bstr bstrSrcName;
+            std::vector<MoveOp> vecOps;
+            std::set<Guid>      setBases;
+            HRESULT             hrcStart = S_OK;
 
-            hrc = pMedium->COMGETTER(Name)(bstrSrcName.asOutParam());
-            if (FAILED(hrc)) throw hrc;
-
-            if (strTargetFolder.isNotEmpty())
+            /*
+             * Start as many moves as permitted, stopping at the first medium
+             * whose chain already has a move in flight.  Failures don't throw
+             * here so that moves already started get waited for below.
+             */
+            while (   itMedium != listOfDisks.end()
+                   && vecOps.size() < cMaxParallel)
             {
-                strTargetImageName = strTargetFolder;
-                hrc = pMedium->COMGETTER(Location)(bstrLocation.asOutParam());
-                if (FAILED(hrc)) throw hrc;
-                strLocation = bstrLocation;
+                const MEDIUMTASKMOVE &mt = itMedium->second;
+                ComPtr<IMedium> pMedium = mt.pMedium;
+                Utf8Str strTargetImageName;
+                Bstr bstrLocation;
+                Bstr bstrSrcName;
+
+                ComPtr<IMedium> pBase;
+                hrc = pMedium->COMGETTER(Base)(pBase.asOutParam());
+                if (FAILED(hrc)) { hrcStart = hrc; break; }
+                Bstr bstrBaseId;
+                hrc = pBase->COMGETTER(Id)(bstrBaseId.asOutParam());
+                if (FAILED(hrc)) { hrcStart = hrc; break; }
+                Guid const uuidBase(bstrBaseId);
+                if (setBases.find(uuidBase) != setBases.end())
+                    break;
+
+                hrc = pMedium->COMGETTER(Name)(bstrSrcName.asOutParam());
+                if (FAILED(hrc)) { hrcStart = hrc; break; }
+
+                if (strTargetFolder.isNotEmpty())
+                {
+                    strTargetImageName = strTargetFolder;
+                    hrc = pMedium->COMGETTER(Location)(bstrLocation.asOutParam());
+                    if (FAILED(hrc)) { hrcStart = hrc; break; }
+                    strLocation = bstrLocation;
+
+                    if (mt.fSnapshot == true)
+                        strLocation.stripFilename().stripPath().append(RTPATH_DELIMITER).append(Utf8Str(bstrSrcName));
+                    else
+                        strLocation.stripPath();
 
-                if (mt.fSnapshot == true)
-                    strLocation.stripFilename().stripPath().append(RTPATH_DELIMITER).append(Utf8Str(bstrSrcName));
+                    strTargetImageName.append(RTPATH_DELIMITER).append(strLocation);
+                }
                 else
-                    strLocation.stripPath();
+                    strTargetImageName = mt.strBaseName;//Should contain full path to the image
 
-                strTargetImageName.append(RTPATH_DELIMITER).append(strLocation);
-                hrc = m_pProgress->SetNextOperation(BstrFmt(tr("Moving medium '%ls' ..."), bstrSrcName.raw()).raw(), mt.uWeight);
-                if (FAILED(hrc)) throw hrc;
-            }
-            else
-            {
-                strTargetImageName = mt.strBaseName;//Should contain full path to the image
-                hrc = m_pProgress->SetNextOperation(BstrFmt(tr("Moving medium '%ls' back..."), bstrSrcName.raw()).raw(), mt.uWeight);
-                if (FAILED(hrc)) throw hrc;
-            }
+                /* consistency: use \ if appropriate on the platform */
+                RTPathChangeToDosSlashes(strTargetImageName.mutableRaw(), false);
+
+                bstrLocation = strTargetImageName.c_str();
 
+                MediumType_T mediumType;//immutable, shared, passthrough
+                hrc = pMedium->COMGETTER(Type)(&mediumType);
+                if (FAILED(hrc)) { hrcStart = hrc; break; }
 
+                DeviceType_T deviceType;//floppy, hard, DVD
+                hrc = pMedium->COMGETTER(DeviceType)(&deviceType);
+                if (FAILED(hrc)) { hrcStart = hrc; break; }
 
-            /* consistency: use \ if appropriate on the platform */
-            RTPathChangeToDosSlashes(strTargetImageName.mutableRaw(), false);
+                /* Drop lock early because IMedium::MoveTo needs to get the VirtualBox one. */
+                machineLock.release();
 
-            bstrLocation = strTargetImageName.c_str();
+                MoveOp op;
+                hrcStart = pMedium->MoveTo(bstrLocation.raw(), op.pProgress.asOutParam());
 
-            MediumType_T mediumType;//immutable, shared, passthrough
-            hrc = pMedium->COMGETTER(Type)(&mediumType);
-            if (FAILED(hrc)) throw hrc;
+                /*acquire the lock back*/
+                machineLock.acquire();
 
-            DeviceType_T deviceType;//floppy, hard, DVD
-            hrc = pMedium->COMGETTER(DeviceType)(&deviceType);
-            if (FAILED(hrc)) throw hrc;
+                /* In case of failure the progress would be in the invalid state or not
+                 * initialized at all, so only wait for the ones started successfully. */
+                if (FAILED(hrcStart))
+                    break;
 
-            /* Drop lock early because IMedium::MoveTo needs to get the VirtualBox one. */
-            machineLock.release();
+                op.bstrSrcName        = bstrSrcName;
+                op.strTargetImageName = strTargetImageName;
+                op.uWeight            = mt.uWeight;
+                vecOps.push_back(op);
+                setBases.insert(uuidBase);
 
-            ComPtr<IProgress> moveDiskProgress;
-            hrc = pMedium->MoveTo(bstrLocation.raw(), moveDiskProgress.asOutParam());
-            if (SUCCEEDED(hrc))
-            {
-                /* In case of failure moveDiskProgress would be in the invalid state or not initialized at all
-                 * Call i_waitForOtherProgressCompletion only in success
-                 */
-                /* Wait until the other process has finished. */
-                hrc = m_pProgress->WaitForOtherProgressCompletion(moveDiskProgress, 0 /* indefinite wait */);
+                ++itMedium;
             }
 
-            /*acquire the lock back*/
+            /*
+             * Wait for the started moves in order, each one being an operation
+             * of our progress object.  Always wait for all of them, even on
+             * failure, so that nothing is left running behind our back.
+             */
+            machineLock.release();
+            HRESULT hrcWait = S_OK;
+            for (size_t i = 0; i < vecOps.size(); ++i)
+            {
+                const MoveOp &op = vecOps[i];
+                if (SUCCEEDED(hrcWait))
+                {
+                    if (strTargetFolder.isNotEmpty())
+                        hrcWait = m_pProgress->SetNextOperation(BstrFmt(tr("Moving medium '%ls' ..."),
+                                                                        op.bstrSrcName.raw()).raw(), op.uWeight);
+                    else
+                        hrcWait = m_pProgress->SetNextOperation(BstrFmt(tr("Moving medium '%ls' back..."),
+                                                                        op.bstrSrcName.raw()).raw(), op.uWeight);
+                }
+                if (SUCCEEDED(hrcWait))
+                {
+                    /* Wait until the other process has finished. */
+                    hrcWait = m_pProgress->WaitForOtherProgressCompletion(op.pProgress, 0 /* indefinite wait */);
+                    if (SUCCEEDED(hrcWait))
+                        Log2(("Moving %s has been finished\n", op.strTargetImageName.c_str()));
+                    else
+                        strLocation = op.strTargetImageName;
+                }
+                else
+                    op.pProgress->WaitForCompletion(-1 /* indefinite wait */);
+            }
             machineLock.acquire();
 
-            if (FAILED(hrc)) throw hrc;
-
-            Log2(("Moving %s has been finished\n", strTargetImageName.c_str()));
-
-            ++itMedium;
+            if (FAILED(hrcWait)) throw hrcWait;
+            if (FAILED(hrcStart)) throw hrcStart;
         }
 
         machineLock.release();
@@ -33,6 +33,7 @@
 #include <iprt/dir.h>
 #include <iprt/env.h>
 #include <iprt/file.h>
+#include <iprt/mp.h>
 #include <iprt/path.h>
 #include <iprt/process.h>
 #include <iprt/rand.h>
@@ -244,6 +245,7 @@ typedef ObjectsList<CloudNetwork> CloudNetworksOList;
 
 typedef std::map<Guid, ComPtr<IProgress> > ProgressMap;
 typedef std::map<Guid, ComObjPtr<Medium> > HardDiskMap;
+typedef std::map<Guid, ComObjPtr<Machine> > MachineMap;
 
 /**
  *  Main VirtualBox data structure.
@@ -338,6 +340,9 @@ struct VirtualBox::Data
     // in AutoLock.h; e.g. LOCKCLASS_LISTOFMACHINES before LOCKCLASS_MACHINEOBJECT).
     RWLockHandle                        lockMachines;
     MachinesOList                       allMachines;
+    // additional map of the registered machines sorted by UUID for quick
+    // lookup; it is protected by the same lock as the machine list above
+    MachineMap                          mapMachines;
 
     RWLockHandle                        lockGuestOSTypes;
     GuestOSTypesOList                   allGuestOSTypes;
@@ -904,36 +909,173 @@ HRESULT VirtualBox::init()
     return S_OK;
 }
 
+/** Minimum number of registered machines before the settings files get
+ * parsed in parallel. */
+#define VBOX_PREPARSE_MACHINES_MIN          8
+/** Maximum number of threads used for parsing machine settings files. */
+#define VBOX_PREPARSE_MACHINES_MAX_THREADS  8
+
+/**
+ * Shared state of the threads parsing the settings files of the registered
+ * machines ahead of VirtualBox::initMachines() registering them.
+ */
+struct MachinePreparseState
+{
+    /** The full paths of the machine settings files (read only). */
+    std::vector<Utf8Str>                        vecConfigFiles;
+    /** The parsed settings, NULL if parsing failed (one writer per entry). */
+    std::vector<settings::MachineConfigFile *>  vecConfigs;
+    /** Index of the next entry to parse. */
+    uint32_t volatile                           idxNext;
+};
+
+/**
+ * Thread function parsing machine settings files until none are left.
+ *
+ * Parsing is self-contained (no VirtualBox objects or locks are touched), so
+ * any failure simply leaves the entry NULL and the regular code path in
+ * Machine::i_registeredInit() re-parses the file and reports the error.
+ */
+static DECLCALLBACK(int) vboxPreparseMachinesThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    RT_NOREF(hThreadSelf);
+    MachinePreparseState *pState = (MachinePreparseState *)pvUser;
+
+    uint32_t const cEntries = (uint32_t)pState->vecConfigFiles.size();
+    for (;;)
+    {
+        uint32_t const idx = ASMAtomicIncU32(&pState->idxNext) - 1;
+        if (idx >= cEntries)
+            break;
+        if (pState->vecConfigFiles[idx].isEmpty())
+            continue;
+
+        try
+        {
+            settings::MachineConfigFile *pConfig = new settings::MachineConfigFile(&pState->vecConfigFiles[idx],
+                                                                                   NULL /*pCryptoIf*/,
+                                                                                   NULL /*pszPassword*/);
+            /* Encrypted configs are left to the regular path which knows about keys. */
+            if (pConfig->strKeyId.isEmpty())
+                pState->vecConfigs[idx] = pConfig;
+            else
+                delete pConfig;
+        }
+        catch (...)
+        {
+            /* Reported when the machine gets initialized. */
+        }
+    }
+
+    return VINF_SUCCESS;
+}
+
 HRESULT VirtualBox::initMachines()
 {
-    for (settings::MachinesRegistry::const_iterator it = m->pMainConfigFile->llMachines.begin();
-         it != m->pMainConfigFile->llMachines.end();
-         ++it)
+    settings::MachinesRegistry &llMachines = m->pMainConfigFile->llMachines;
+
+    /*
+     * With many registered machines most of the startup time goes into
+     * reading and parsing their settings files one after the other.  Do
+     * that part on a few worker threads first; creating and registering the
+     * Machine objects below stays sequential and keeps the registry order.
+     */
+    MachinePreparseState Preparse;
+    Preparse.idxNext = 0;
+    size_t const cMachines = llMachines.size();
+    if (cMachines >= VBOX_PREPARSE_MACHINES_MIN)
+    {
+        try
+        {
+            Preparse.vecConfigFiles.resize(cMachines);
+            Preparse.vecConfigs.resize(cMachines, NULL);
+        }
+        catch (std::bad_alloc &)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        size_t idx = 0;
+        for (settings::MachinesRegistry::const_iterator it = llMachines.begin(); it != llMachines.end(); ++it, ++idx)
+            if (it->strSettingsFile.isNotEmpty() && !it->uuid.isZero())
+            {
+                int vrc = i_calculateFullPath(it->strSettingsFile, Preparse.vecConfigFiles[idx]);
+                if (RT_FAILURE(vrc))
+                    Preparse.vecConfigFiles[idx].setNull();
+            }
+
+        uint32_t cThreads = RT_MIN(RTMpGetOnlineCount(), VBOX_PREPARSE_MACHINES_MAX_THREADS);
+        cThreads = RT_MIN(cThreads, (uint32_t)cMachines);
+        RTTHREAD ahThreads[VBOX_PREPARSE_MACHINES_MAX_THREADS];
+        uint32_t cStarted = 0;
+        for (uint32_t i = 0; i < cThreads; i++)
+        {
+            int vrc = RTThreadCreateF(&ahThreads[cStarted], vboxPreparseMachinesThread, &Preparse, 0 /*cbStack*/,
+                                      RTTHREADTYPE_DEFAULT, RTTHREADFLAGS_WAITABLE, "VMPreparse%u", i);
+            if (RT_SUCCESS(vrc))
+                cStarted++;
+            else
+                LogRel(("Failed to create machine settings parser thread: %Rrc\n", vrc));
+        }
+
+        /* Help out; this also covers the case where no thread could be created. */
+        vboxPreparseMachinesThread(NIL_RTTHREAD, &Preparse);
+
+        for (uint32_t i = 0; i < cStarted; i++)
+        {
+            int vrc = RTThreadWait(ahThreads[i], RT_INDEFINITE_WAIT, NULL);
+            AssertRC(vrc);
+        }
+    }
+
+    HRESULT hrcRet = S_OK;
+    size_t idx = 0;
+    for (settings::MachinesRegistry::const_iterator it = llMachines.begin();
+         it != llMachines.end();
+         ++it, ++idx)
     {
-        HRESULT hrc = S_OK;
         const settings::MachineRegistryEntry &xmlMachine = *it;
         Guid uuid = xmlMachine.uuid;
 
+        /* Hand over the pre-parsed settings (if any), initFromSettings() takes ownership. */
+        settings::MachineConfigFile *pConfig = NULL;
+        if (idx < Preparse.vecConfigs.size())
+        {
+            pConfig = Preparse.vecConfigs[idx];
+            Preparse.vecConfigs[idx] = NULL;
+        }
+
         /* Check if machine record has valid parameters. */
         if (xmlMachine.strSettingsFile.isEmpty() || uuid.isZero())
         {
             LogRel(("Skipped invalid machine record.\n"));
+            Assert(!pConfig);
             continue;
         }
 
+        if (FAILED(hrcRet))
+        {
+            /* Failed earlier, just free what's left over. */
+            delete pConfig;
+            continue;
+        }
+
+        HRESULT hrc;
         ComObjPtr<Machine> pMachine;
         com::Utf8Str strPassword;
         if (SUCCEEDED(hrc = pMachine.createObject()))
         {
-            hrc = pMachine->initFromSettings(this, xmlMachine.strSettingsFile, &uuid, strPassword);
+            hrc = pMachine->initFromSettings(this, xmlMachine.strSettingsFile, &uuid, strPassword, pConfig);
             if (SUCCEEDED(hrc))
                 hrc = i_registerMachine(pMachine);
             if (FAILED(hrc))
-                return hrc;
+                hrcRet = hrc;
         }
+        else
+            delete pConfig;
     }
 
-    return S_OK;
+    return hrcRet;
 }
 
 /**
@@ -1058,6 +1200,10 @@ void VirtualBox::uninit()
     /* tell all our child objects we've been uninitialized */
 
     LogFlowThisFunc(("Uninitializing machines (%d)...\n", m->allMachines.size()));
+    {
+        AutoWriteLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
+        m->mapMachines.clear();
+    }
     if (m->pHost)
     {
         /* It is necessary to hold the VirtualBox and Host locks here because
@@ -4134,26 +4280,24 @@ HRESULT VirtualBox::i_findMachine(const Guid &aId,
     {
         AutoReadLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
 
-        for (MachinesOList::iterator it = m->allMachines.begin();
-             it != m->allMachines.end();
-             ++it)
+        MachineMap::const_iterator it = m->mapMachines.find(aId);
+        if (it != m->mapMachines.end())
         {
-            ComObjPtr<Machine> pMachine = *it;
+            const ComObjPtr<Machine> &pMachine = it->second;
 
+            bool fFound = true;
             if (!fPermitInaccessible)
             {
                 // skip inaccessible machines
                 AutoCaller machCaller(pMachine);
-                if (FAILED(machCaller.hrc()))
-                    continue;
+                fFound = SUCCEEDED(machCaller.hrc());
             }
 
-            if (pMachine->i_getId() == aId)
+            if (fFound)
             {
                 hrc = S_OK;
                 if (aMachine)
                     *aMachine = pMachine;
-                break;
             }
         }
     }
@@ -5445,7 +5589,11 @@ HRESULT VirtualBox::i_registerMachine(Machine *aMachine)
     }
 
     /* add to the collection of registered machines */
-    m->allMachines.addChild(aMachine);
+    {
+        AutoWriteLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
+        m->allMachines.getList().push_back(aMachine);
+        m->mapMachines[aMachine->i_getId()] = aMachine;
+    }
 
     if (getObjectState().getState() != ObjectState::InInit)
         hrc = i_saveSettings();
@@ -5789,7 +5937,13 @@ HRESULT VirtualBox::i_unregisterMachine(Machine *pMachine,
 {
     // remove from the collection of registered machines
     AutoWriteLock alock(this COMMA_LOCKVAL_SRC_POS);
-    m->allMachines.removeChild(pMachine);
+    {
+        AutoWriteLock al(m->allMachines.getLockHandle() COMMA_LOCKVAL_SRC_POS);
+        m->allMachines.getList().remove(pMachine);
+        MachineMap::iterator it = m->mapMachines.find(id);
+        if (it != m->mapMachines.end() && it->second == pMachine)
+            m->mapMachines.erase(it);
+    }
     // save the global registry
     HRESULT hrc = i_saveSettings();
     alock.release();
@@ -35,6 +35,7 @@
 #include <iprt/cdefs.h>
 #include <iprt/ctype.h>
 #include <iprt/err.h>
+#include <iprt/file.h>
 #include <iprt/param.h>
 #include <iprt/path.h>
 #include <iprt/string.h>
@@ -285,43 +286,72 @@ int CollectorLinux::getProcessMemoryUsage(RTPROCESS process, ULONG *used)
 
 int CollectorLinux::getRawProcessStats(RTPROCESS process, uint64_t *cpuUser, uint64_t *cpuKernel, ULONG *memPagesUsed)
 {
-    int vrc = VINF_SUCCESS;
-    char *pszName;
-    pid_t pid2;
-    char c;
-    int iTmp;
-    long long unsigned int u64Tmp;
-    unsigned uTmp;
-    unsigned long ulTmp;
-    signed long ilTmp;
-    ULONG u32user, u32kernel;
-    char buf[80]; /** @todo this should be tied to max allowed proc name. */
-
-    RTStrAPrintf(&pszName, "/proc/%d/stat", process);
-    FILE *f = fopen(pszName, "r");
-    RTStrFree(pszName);
+    /*
+     * This gets called for every VM process on every collector tick, so
+     * read /proc/<pid>/stat with a single read into a stack buffer instead
+     * of going through stdio and a 24 conversion fscanf.
+     */
+    char szPath[64];
+    RTStrPrintf(szPath, sizeof(szPath), "/proc/%d/stat", process);
+
+    RTFILE hFile;
+    int vrc = RTFileOpen(&hFile, szPath, RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_NONE);
+    if (RT_FAILURE(vrc))
+        return VERR_ACCESS_DENIED;
 
-    if (f)
+    char   szBuf[1024];
+    size_t cbRead = 0;
+    vrc = RTFileRead(hFile, szBuf, sizeof(szBuf) - 1, &cbRead);
+    RTFileClose(hFile);
+    if (RT_FAILURE(vrc) || !cbRead)
+        return VERR_FILE_IO_ERROR;
+    szBuf[cbRead] = '\0';
+
+    /* The command name in parentheses may contain anything, so start
+       parsing after the last ')'; the next field is the state (3rd). */
+    const char *psz = strrchr(szBuf, ')');
+    if (!psz)
+        return VERR_FILE_IO_ERROR;
+    psz++;
+
+    /* Fields (1-based as in proc(5)): 14 = utime, 15 = stime, 24 = rss. */
+    uint64_t u64User = 0, u64Kernel = 0, u64Rss = 0;
+    unsigned iField  = 3;
+    for (;;)
     {
-        if (fscanf(f, "%d %79s %c %d %d %d %d %d %u %lu %lu %lu %lu %u %u "
-                      "%ld %ld %ld %ld %ld %ld %llu %lu %u",
-                   &pid2, buf, &c, &iTmp, &iTmp, &iTmp, &iTmp, &iTmp, &uTmp,
-                   &ulTmp, &ulTmp, &ulTmp, &ulTmp, &u32user, &u32kernel,
-                   &ilTmp, &ilTmp, &ilTmp, &ilTmp, &ilTmp, &ilTmp, &u64Tmp,
-                   &ulTmp, memPagesUsed) == 24)
+        psz = RTStrStripL(psz);
+        if (!*psz)
+            break;
+        if (iField == 14 || iField == 15 || iField == 24)
         {
-            Assert((pid_t)process == pid2);
-            *cpuUser   = u32user;
-            *cpuKernel = u32kernel;
+            char *pszNext = NULL;
+            uint64_t u64 = 0;
+            vrc = RTStrToUInt64Ex(psz, &pszNext, 10, &u64);
+            if (RT_FAILURE(vrc) || vrc == VWRN_NUMBER_TOO_BIG)
+                return VERR_FILE_IO_ERROR;
+            if (iField == 14)
+                u64User = u64;
+            else if (iField == 15)
+                u64Kernel = u64;
+            else
+            {
+                u64Rss = u64;
+                break;
+            }
+            psz = pszNext;
         }
         else
-            vrc = VERR_FILE_IO_ERROR;
-        fclose(f);
+            while (*psz && !RT_C_IS_SPACE(*psz))
+                psz++;
+        iField++;
     }
-    else
-        vrc = VERR_ACCESS_DENIED;
+    if (iField != 24)
+        return VERR_FILE_IO_ERROR;
 
-    return vrc;
+    *cpuUser      = u64User;
+    *cpuKernel    = u64Kernel;
+    *memPagesUsed = (ULONG)u64Rss;
+    return VINF_SUCCESS;
 }
 
 int CollectorLinux::getRawHostNetworkLoad(const char *pszFile, uint64_t *rx, uint64_t *tx)
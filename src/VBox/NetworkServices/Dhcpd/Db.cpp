@@ -30,7 +30,10 @@
 *   Header Files                                                                                                                 *
 *********************************************************************************************************************************/
 #include "DhcpdInternal.h"
+#include <iprt/crc.h>
 #include <iprt/errcore.h>
+#include <iprt/file.h>
+#include <iprt/time.h>
 
 #include "Db.h"
 
@@ -159,6 +162,7 @@ Binding &Binding::setState(const char *pszStateName) RT_NOEXCEPT
         AssertMsgFailed(("%d\n", m_state));
         m_state = Binding::RELEASED;
     }
+    m_fDirty = true;
 
     return *this;
 }
@@ -236,6 +240,40 @@ void Binding::toXML(xml::ElementNode *pElmParent) const
 }
 
 
+/**
+ * Appends the binding to the lease journal.
+ *
+ * The record is a single line: "lease <address> <state> <issued> <expiration>
+ * <mac> [<client-id>] *<crc>", with the issue time in seconds since the unix
+ * epoch, the lease time in seconds and the optional client ID in hex.  The
+ * CRC-32 of the text before " *" lets readers tell a torn record at the end
+ * of the journal from a complete one, see Db::i_checkJournalRecord.
+ *
+ * @returns IPRT status code of the stream.
+ * @param   pStrm       The journal stream.
+ * @note    DHCPServerImpl.cpp contains a reader, keep it in sync.
+ */
+int Binding::toJournal(PRTSTREAM pStrm) const RT_NOEXCEPT
+{
+    char szId[1 + 255 * 2 + 1];
+    szId[0] = '\0';
+    if (m_id.id().present() && !m_id.id().value().empty())
+    {
+        szId[0] = ' ';
+        int rc = RTStrPrintHexBytes(&szId[1], sizeof(szId) - 1,
+                                    &m_id.id().value().front(), m_id.id().value().size(), 0);
+        if (RT_FAILURE(rc))
+            szId[0] = '\0';
+    }
+
+    char   szRecord[sizeof(szId) + 96];
+    size_t cchRecord = RTStrPrintf(szRecord, sizeof(szRecord), "lease %RTnaipv4 %s %RI64 %RU32 %RTmac%s", m_addr.u,
+                                   stateName(), m_issued.getAbsSeconds(), m_secLease, &m_id.mac(), szId);
+    RTStrmPrintf(pStrm, "%s *%08RX32\n", szRecord, RTCrc32(szRecord, cchRecord));
+    return RTStrmError(pStrm);
+}
+
+
 /**
  * Deserializes the binding from the XML lease database.
  *
@@ -356,6 +394,9 @@ Binding *Binding::fromXML(const xml::ElementNode *pElmLease)
 
 Db::Db()
     : m_pConfig(NULL)
+    , m_pJournal(NULL)
+    , m_cJournalRecords(0)
+    , m_msLastCompaction(0)
 {
 }
 
@@ -363,6 +404,11 @@ Db::Db()
 Db::~Db()
 {
     /** @todo free bindings */
+    if (m_pJournal)
+    {
+        RTStrmClose(m_pJournal);
+        m_pJournal = NULL;
+    }
 }
 
 
@@ -436,7 +482,7 @@ int Db::i_enterFixedAddressAssignment(RTNETADDRIPV4 const &a_rAddress, RTMAC con
             delete pBinding;
         return VERR_NO_MEMORY;
     }
-    return VINF_SUCCESS;
+    return i_indexBinding(pBinding);
 }
 
 
@@ -476,8 +522,10 @@ Binding *Db::i_createBinding(const ClientId &id)
         {
             if (pBinding)
                 delete pBinding;
-            /** @todo free address (no pool method for that)  */
+            m_pool.release(addr);
+            return NULL;
         }
+        i_indexBinding(pBinding);
     }
     return pBinding;
 }
@@ -507,10 +555,86 @@ Binding *Db::i_createBinding(RTNETADDRIPV4 addr, const ClientId &id)
 
     Binding *b = new Binding(addr, id);
     m_bindings.push_front(b);
+    i_indexBinding(b);
     return b;
 }
 
 
+/**
+ * Looks up the binding of the given client.
+ *
+ * Fixed assignments are checked first (they're few and at the head of the
+ * list), the dynamic bindings are found via the client ID index.
+ *
+ * @returns Pointer to the binding, NULL if not found.
+ * @param   id          The client ID.
+ */
+Binding *Db::i_findBinding(const ClientId &id) RT_NOEXCEPT
+{
+    for (bindings_t::iterator it = m_bindings.begin(); it != m_bindings.end() && (*it)->isFixed(); ++it)
+        if ((*it)->m_id == id)
+            return *it;
+
+    idindex_t::const_iterator itId = m_idIndex.find(id);
+    return itId != m_idIndex.end() ? itId->second : NULL;
+}
+
+
+/**
+ * Looks up the binding for the given address.
+ *
+ * @returns Pointer to the binding, NULL if not found.
+ * @param   addr        The IPv4 address.
+ */
+Binding *Db::i_findBinding(RTNETADDRIPV4 addr) RT_NOEXCEPT
+{
+    addrindex_t::const_iterator itAddr = m_addrIndex.find(RT_N2H_U32(addr.u));
+    return itAddr != m_addrIndex.end() ? itAddr->second : NULL;
+}
+
+
+/**
+ * Reassigns a dynamic binding to the given client, keeping the client ID index
+ * up to date.
+ *
+ * @param   pBinding    The binding.
+ * @param   id          The new client.
+ * @throws  std::bad_alloc
+ */
+void Db::i_giveBindingTo(Binding *pBinding, const ClientId &id)
+{
+    Assert(!pBinding->isFixed());
+    idindex_t::iterator itId = m_idIndex.find(pBinding->m_id);
+    if (itId != m_idIndex.end() && itId->second == pBinding)
+        m_idIndex.erase(itId);
+    pBinding->giveTo(id);
+    m_idIndex[id] = pBinding;
+}
+
+
+/**
+ * Enters a binding into the address index and, unless it's a fixed
+ * assignment, the client ID index.
+ *
+ * @returns IPRT status code.
+ * @param   pBinding    The binding.
+ */
+int Db::i_indexBinding(Binding *pBinding) RT_NOEXCEPT
+{
+    try
+    {
+        m_addrIndex[RT_N2H_U32(pBinding->m_addr.u)] = pBinding;
+        if (!pBinding->isFixed())
+            m_idIndex[pBinding->m_id] = pBinding;
+    }
+    catch (std::bad_alloc &)
+    {
+        return VERR_NO_MEMORY;
+    }
+    return VINF_SUCCESS;
+}
+
+
 /**
  * Internal worker that allocates an IPv4 address for the given client, taking
  * the preferred address (@a addr) into account when possible and if non-zero.
@@ -526,44 +650,55 @@ Binding *Db::i_allocateAddress(const ClientId &id, RTNETADDRIPV4 addr)
 
     /*
      * Allocate existing address if client has one.  Ignore requested
-     * address in that case.  While here, look for free addresses and
-     * addresses that can be reused.
+     * address in that case.
+     *
+     * If the client's MAC address is configured with a fixed address, give
+     * its preconfigured binding.  Fixed bindings are always at the head of
+     * the m_bindings list, so we won't be confused by any old leases of the
+     * client.  Other clients we've already seen are found via the index.
      */
-    Binding        *addrBinding  = NULL;
-    Binding        *freeBinding  = NULL;
-    Binding        *reuseBinding = NULL;
-    const Timestamp now          = Timestamp::now();
-    for (bindings_t::iterator it = m_bindings.begin(); it != m_bindings.end(); ++it)
+    const Timestamp now = Timestamp::now();
+    for (bindings_t::iterator it = m_bindings.begin(); it != m_bindings.end() && (*it)->isFixed(); ++it)
     {
         Binding *b = *it;
-        b->expire(now);
-
-        /*
-         * We've already seen this client, give it its old binding.
-         *
-         * If the client's MAC address is configured with a fixed
-         * address, give its preconfigured binding.  Fixed bindings
-         * are always at the head of the m_bindings list, so we
-         * won't be confused by any old leases of the client.
-         */
         if (b->m_id == id)
         {
             LogRel(("> ... found existing binding %R[binding]\n", b));
             return b;
         }
-        if (b->isFixed() && b->id().mac() == id.mac())
+        if (b->id().mac() == id.mac())
         {
             b->idUpdate(id);
             LogRel(("> ... found fixed binding %R[binding]\n", b));
             return b;
         }
+    }
 
-        if (addr.u != 0 && b->m_addr.u == addr.u)
-        {
-            Assert(addrBinding == NULL);
-            addrBinding = b;
-            LogRel(("> .... noted existing binding %R[binding]\n", addrBinding));
-        }
+    idindex_t::const_iterator itId = m_idIndex.find(id);
+    if (itId != m_idIndex.end())
+    {
+        Binding *b = itId->second;
+        b->expire(now);
+        LogRel(("> ... found existing binding %R[binding]\n", b));
+        return b;
+    }
+
+    /*
+     * A new client.  Look for free addresses and addresses that can be
+     * reused.
+     */
+    Binding *addrBinding  = addr.u != 0 ? i_findBinding(addr) : NULL;
+    Binding *freeBinding  = NULL;
+    Binding *reuseBinding = NULL;
+    if (addrBinding)
+    {
+        addrBinding->expire(now);
+        LogRel(("> .... noted existing binding %R[binding]\n", addrBinding));
+    }
+    for (bindings_t::iterator it = m_bindings.begin(); it != m_bindings.end(); ++it)
+    {
+        Binding *b = *it;
+        b->expire(now);
 
         /* if we haven't found a free binding yet, keep looking */
         if (freeBinding == NULL)
@@ -615,7 +750,7 @@ Binding *Db::i_allocateAddress(const ClientId &id, RTNETADDRIPV4 addr)
         if (addrBinding->m_state <= Binding::EXPIRED) /* not in use */
         {
             LogRel(("> .... reusing %s binding for this address\n", addrBinding->stateName()));
-            addrBinding->giveTo(id);
+            i_giveBindingTo(addrBinding, id);
             return addrBinding;
         }
         LogRel(("> .... cannot reuse %s binding for this address\n", addrBinding->stateName()));
@@ -645,7 +780,7 @@ Binding *Db::i_allocateAddress(const ClientId &id, RTNETADDRIPV4 addr)
         }
     }
 
-    idBinding->giveTo(id);
+    i_giveBindingTo(idBinding, id);
     LogRel(("> .... allocated %R[binding]\n", idBinding));
 
     return idBinding;
@@ -768,23 +903,20 @@ int Db::i_addBinding(Binding *pNewBinding) RT_NOEXCEPT
         return VERR_OUT_OF_RANGE;
     }
 
-    for (bindings_t::iterator it = m_bindings.begin(); it != m_bindings.end(); ++it)
+    Binding *b = i_findBinding(pNewBinding->m_addr);
+    if (b)
     {
-        Binding *b = *it;
-
-        if (pNewBinding->m_addr.u == b->m_addr.u)
-        {
-            LogRel(("> ADD: %R[binding]\n", pNewBinding));
-            LogRel(("> .... duplicate ip: %R[binding]\n", b));
-            return VERR_DUPLICATE;
-        }
+        LogRel(("> ADD: %R[binding]\n", pNewBinding));
+        LogRel(("> .... duplicate ip: %R[binding]\n", b));
+        return VERR_DUPLICATE;
+    }
 
-        if (pNewBinding->m_id == b->m_id)
-        {
-            LogRel(("> ADD: %R[binding]\n", pNewBinding));
-            LogRel(("> .... duplicate id: %R[binding]\n", b));
-            return VERR_DUPLICATE;
-        }
+    b = i_findBinding(pNewBinding->m_id);
+    if (b)
+    {
+        LogRel(("> ADD: %R[binding]\n", pNewBinding));
+        LogRel(("> .... duplicate id: %R[binding]\n", b));
+        return VERR_DUPLICATE;
     }
 
     /*
@@ -799,9 +931,10 @@ int Db::i_addBinding(Binding *pNewBinding) RT_NOEXCEPT
     }
     catch (std::bad_alloc &)
     {
+        m_pool.release(pNewBinding->m_addr);
         return VERR_NO_MEMORY;
     }
-    return VINF_SUCCESS;
+    return i_indexBinding(pNewBinding);
 }
 
 
@@ -819,27 +952,23 @@ void Db::cancelOffer(const DhcpClientMessage &req) RT_NOEXCEPT
     const RTNETADDRIPV4 addr = reqAddr.value();
     const ClientId     &id(req.clientId());
 
-    for (bindings_t::iterator it = m_bindings.begin(); it != m_bindings.end(); ++it)
+    Binding *b = i_findBinding(id);
+    if (b && b->addr().u == addr.u)
     {
-        Binding *b = *it;
-
-        if (b->addr().u == addr.u && b->id() == id)
+        if (b->state() == Binding::OFFERED)
         {
-            if (b->state() == Binding::OFFERED)
+            LogRel2(("Db::cancelOffer: cancelling %R[binding]\n", b));
+            if (!b->isFixed())
             {
-                LogRel2(("Db::cancelOffer: cancelling %R[binding]\n", b));
-                if (!b->isFixed())
-                {
-                    b->setLeaseTime(0);
-                    b->setState(Binding::RELEASED);
-                }
-                else
-                    b->setState(Binding::ACKED);
+                b->setLeaseTime(0);
+                b->setState(Binding::RELEASED);
             }
             else
-                LogRel2(("Db::cancelOffer: not offered state: %R[binding]\n", b));
-            return;
+                b->setState(Binding::ACKED);
         }
+        else
+            LogRel2(("Db::cancelOffer: not offered state: %R[binding]\n", b));
+        return;
     }
     LogRel2(("Db::cancelOffer: not found (%RTnaipv4, %R[id])\n", addr.u, &id));
 }
@@ -857,21 +986,17 @@ bool Db::releaseBinding(const DhcpClientMessage &req) RT_NOEXCEPT
     const RTNETADDRIPV4 addr = req.ciaddr();
     const ClientId     &id(req.clientId());
 
-    for (bindings_t::iterator it = m_bindings.begin(); it != m_bindings.end(); ++it)
+    Binding *b = i_findBinding(id);
+    if (b && b->addr().u == addr.u)
     {
-        Binding *b = *it;
-
-        if (b->addr().u == addr.u && b->id() == id)
+        LogRel2(("Db::releaseBinding: releasing %R[binding]\n", b));
+        if (!b->isFixed())
         {
-            LogRel2(("Db::releaseBinding: releasing %R[binding]\n", b));
-            if (!b->isFixed())
-            {
-                b->setState(Binding::RELEASED);
-                return true;
-            }
-            b->setState(Binding::ACKED);
-            return false;
+            b->setState(Binding::RELEASED);
+            return true;
         }
+        b->setState(Binding::ACKED);
+        return false;
     }
 
     LogRel2(("Db::releaseBinding: not found (%RTnaipv4, %R[id])\n", addr.u, &id));
@@ -880,7 +1005,139 @@ bool Db::releaseBinding(const DhcpClientMessage &req) RT_NOEXCEPT
 
 
 /**
- * Called by DHCPD to write out the lease database to @a strFilename.
+ * Returns the name of the lease journal belonging to @a strFilename.
+ *
+ * @throws  std::bad_alloc
+ */
+/*static*/ RTCString Db::i_journalFilename(const RTCString &strFilename)
+{
+    return strFilename + "-journal";
+}
+
+
+/**
+ * Clears the dirty indicator of all bindings after they've been written out.
+ */
+void Db::i_clearDirty() RT_NOEXCEPT
+{
+    for (bindings_t::iterator it = m_bindings.begin(); it != m_bindings.end(); ++it)
+        (*it)->m_fDirty = false;
+}
+
+
+/**
+ * Called by DHCPD to save the changes made to the lease database.
+ *
+ * The changed bindings are appended to the lease journal instead of rewriting
+ * the whole lease file.  The journal is compacted into the lease file when it
+ * has grown larger than the database itself, or when the lease file is more
+ * than s_cMsCompactInterval old, so it doesn't lag far behind for Main which
+ * reads it.  If the journal cannot be written, the whole lease file is
+ * written every time like in the old days.
+ *
+ * @returns IPRT status code.
+ * @param   strFilename         The lease file.
+ */
+int Db::saveLeases(const RTCString &strFilename) RT_NOEXCEPT
+{
+    if (!m_pJournal)
+    {
+        int rc;
+        try
+        {
+            rc = RTStrmOpen(i_journalFilename(strFilename).c_str(), "a", &m_pJournal);
+        }
+        catch (std::bad_alloc &)
+        {
+            rc = VERR_NO_MEMORY;
+        }
+        if (RT_FAILURE(rc))
+        {
+            LogRel(("Failed to open the lease journal for '%s': %Rrc\n", strFilename.c_str(), rc));
+            m_pJournal = NULL;
+            return i_compactLeases(strFilename);
+        }
+    }
+
+    /*
+     * Append the changed bindings.
+     */
+    uint32_t cRecords = 0;
+    for (bindings_t::iterator it = m_bindings.begin(); it != m_bindings.end(); ++it)
+    {
+        Binding *b = *it;
+        if (b->m_fDirty && !b->isFixed())
+        {
+            b->toJournal(m_pJournal);
+            b->m_fDirty = false;
+            cRecords++;
+        }
+    }
+    if (!cRecords)
+        return VINF_SUCCESS;
+    m_cJournalRecords += cRecords;
+
+    int rc = RTStrmFlush(m_pJournal);
+    if (RT_SUCCESS(rc))
+        rc = RTStrmError(m_pJournal);
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("Writing the lease journal for '%s' failed: %Rrc\n", strFilename.c_str(), rc));
+        RTStrmClose(m_pJournal);
+        m_pJournal = NULL;
+        return i_compactLeases(strFilename);
+    }
+
+    /*
+     * Compact the journal when it has grown too large or the lease file is too old.
+     */
+    if (   (size_t)m_cJournalRecords > RT_MAX((size_t)s_cMinJournalRecords, m_bindings.size())
+        || RTTimeMilliTS() - m_msLastCompaction >= s_cMsCompactInterval)
+        return i_compactLeases(strFilename);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Writes the whole database to the lease file and truncates the journal.
+ *
+ * @returns IPRT status code.
+ * @param   strFilename         The lease file.
+ */
+int Db::i_compactLeases(const RTCString &strFilename) RT_NOEXCEPT
+{
+    int rc = writeLeases(strFilename);
+    if (RT_FAILURE(rc))
+        return rc;
+    i_clearDirty();
+    m_msLastCompaction = RTTimeMilliTS();
+
+    /* Everything is in the lease file now, so start over with an empty journal. */
+    if (m_pJournal)
+    {
+        RTStrmClose(m_pJournal);
+        m_pJournal = NULL;
+        try
+        {
+            rc = RTStrmOpen(i_journalFilename(strFilename).c_str(), "w", &m_pJournal);
+        }
+        catch (std::bad_alloc &)
+        {
+            rc = VERR_NO_MEMORY;
+        }
+        if (RT_FAILURE(rc))
+        {
+            LogRel(("Failed to truncate the lease journal for '%s': %Rrc\n", strFilename.c_str(), rc));
+            m_pJournal = NULL;
+        }
+    }
+    m_cJournalRecords = 0;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Writes out the whole lease database to @a strFilename.
  *
  * @returns IPRT status code.
  * @param   strFilename         The file to write it to.
@@ -952,6 +1209,8 @@ int Db::writeLeases(const RTCString &strFilename) const RT_NOEXCEPT
 /**
  * Called by DHCPD to load the lease database to @a strFilename.
  *
+ * Loads the lease file and then applies the lease journal on top of it.
+ *
  * @note Does not clear the database state before doing the load.
  *
  * @returns IPRT status code.
@@ -959,6 +1218,28 @@ int Db::writeLeases(const RTCString &strFilename) const RT_NOEXCEPT
  * @throws  nothing
  */
 int Db::loadLeases(const RTCString &strFilename) RT_NOEXCEPT
+{
+    int rc = i_loadLeaseFile(strFilename);
+    if (rc == VERR_NO_MEMORY)
+        return rc;
+
+    int rc2 = i_replayJournal(strFilename);
+    if (rc2 == VERR_NO_MEMORY)
+        return rc2;
+
+    /* Everything loaded is already on disk. */
+    i_clearDirty();
+    return rc;
+}
+
+
+/**
+ * Internal worker for loadLeases() that loads the XML lease file.
+ *
+ * @returns IPRT status code.
+ * @param   strFilename         The file to load it from.
+ */
+int Db::i_loadLeaseFile(const RTCString &strFilename) RT_NOEXCEPT
 {
     LogRel(("loading leases from %s\n", strFilename.c_str()));
 
@@ -1058,3 +1339,256 @@ int Db::i_loadLease(const xml::ElementNode *pElmLease) RT_NOEXCEPT
     LogRel(("> LOAD: failed to load lease!\n"));
     return VERR_PARSE_ERROR;
 }
+
+
+/**
+ * Internal worker for loadLeases() that applies the lease journal.
+ *
+ * Replaying stops at the first record with a missing or wrong checksum,
+ * which normally is a record torn by a crash while it was being appended.
+ * The journal is truncated after the last good record, so the records
+ * appended from now on don't end up behind the bad one where replaying
+ * would never reach them.
+ *
+ * @returns IPRT status code.
+ * @param   strFilename         The lease file the journal belongs to.
+ */
+int Db::i_replayJournal(const RTCString &strFilename) RT_NOEXCEPT
+{
+    PRTSTREAM pStrm = NULL;
+    int rc;
+    try
+    {
+        rc = RTStrmOpen(i_journalFilename(strFilename).c_str(), "r", &pStrm);
+    }
+    catch (std::bad_alloc &)
+    {
+        return VERR_NO_MEMORY;
+    }
+    if (RT_FAILURE(rc))
+    {
+        if (rc != VERR_FILE_NOT_FOUND)
+            LogRel(("Failed to open the lease journal for '%s': %Rrc\n", strFilename.c_str(), rc));
+        return rc == VERR_FILE_NOT_FOUND ? VINF_SUCCESS : rc;
+    }
+
+    LogRel(("replaying lease journal for %s\n", strFilename.c_str()));
+    uint32_t cRecords = 0;
+    uint32_t cIgnored = 0;
+    RTFOFF   offGood  = 0;
+    bool     fBad     = false;
+    char     szLine[1024];
+    for (;;)
+    {
+        rc = RTStrmGetLine(pStrm, szLine, sizeof(szLine));
+        if (rc == VERR_EOF)
+        {
+            rc = VINF_SUCCESS;
+            break;
+        }
+        if (RT_FAILURE(rc) && rc != VERR_BUFFER_OVERFLOW)
+            break;
+
+        /* Stop at the first record that isn't complete. */
+        char *pszLine = RTStrStrip(szLine);
+        int   rc2     = rc;
+        if (RT_SUCCESS(rc2) && *pszLine != '\0' && *pszLine != '#')
+            rc2 = i_checkJournalRecord(pszLine);
+        if (RT_FAILURE(rc2))
+        {
+            LogRel(("> JOURNAL: bad record at offset %RTfoff: %Rrc\n", offGood, rc2));
+            rc   = VINF_SUCCESS;
+            fBad = true;
+            break;
+        }
+
+        /* A complete record which doesn't apply, say because the address range
+           was changed in the meantime, is skipped like a bad lease in the XML. */
+        if (*pszLine != '\0' && *pszLine != '#')
+        {
+            rc2 = i_replayJournalRecord(pszLine);
+            if (RT_SUCCESS(rc2))
+                cRecords++;
+            else if (rc2 == VERR_NO_MEMORY)
+            {
+                rc = rc2;
+                break;
+            }
+            else
+                cIgnored++;
+        }
+        offGood = RTStrmTell(pStrm);
+    }
+    RTStrmClose(pStrm);
+
+    /*
+     * Drop the bad record and whatever follows it.
+     */
+    if (fBad && offGood >= 0)
+    {
+        RTFILE hFile;
+        int rc2;
+        try
+        {
+            rc2 = RTFileOpen(&hFile, i_journalFilename(strFilename).c_str(),
+                             RTFILE_O_WRITE | RTFILE_O_OPEN | RTFILE_O_DENY_NONE);
+        }
+        catch (std::bad_alloc &)
+        {
+            rc2 = VERR_NO_MEMORY;
+        }
+        if (RT_SUCCESS(rc2))
+        {
+            rc2 = RTFileSetSize(hFile, (uint64_t)offGood);
+            RTFileClose(hFile);
+        }
+        if (RT_FAILURE(rc2))
+            LogRel(("> JOURNAL: failed to truncate the lease journal at %RTfoff: %Rrc\n", offGood, rc2));
+    }
+
+    m_cJournalRecords = cRecords + cIgnored;
+    LogRel(("> JOURNAL: %u records applied, %u ignored%s: %Rrc\n",
+            cRecords, cIgnored, fBad ? ", stopped at a torn one" : "", rc));
+    return rc;
+}
+
+
+/**
+ * Checks the CRC-32 of a lease journal record and strips it off.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_PARSE_ERROR if the record has no checksum.
+ * @retval  VERR_MISMATCH if the checksum doesn't match.
+ * @param   pszLine             The record, stripped of surrounding white
+ *                              space.  The checksum is cut off on success.
+ * @note    DHCPServerImpl.cpp does the same check, keep it in sync.
+ */
+/*static*/ int Db::i_checkJournalRecord(char *pszLine) RT_NOEXCEPT
+{
+    char *pszCrc = strrchr(pszLine, ' ');
+    if (!pszCrc || pszCrc[1] != '*')
+        return VERR_PARSE_ERROR;
+
+    uint32_t uCrc;
+    int rc = RTStrToUInt32Full(&pszCrc[2], 16, &uCrc);
+    if (rc != VINF_SUCCESS)
+        return VERR_PARSE_ERROR;
+    if (uCrc != RTCrc32(pszLine, (size_t)(pszCrc - pszLine)))
+        return VERR_MISMATCH;
+
+    *pszCrc = '\0';
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Applies one lease journal record (see Binding::toJournal).
+ *
+ * @returns IPRT status code.
+ * @param   pszLine             The record, will be modified.
+ */
+int Db::i_replayJournalRecord(char *pszLine) RT_NOEXCEPT
+{
+    /*
+     * Split it up into fields.
+     */
+    char    *apszFields[7];
+    unsigned cFields = 0;
+    char    *psz     = pszLine;
+    while (*psz != '\0' && cFields < RT_ELEMENTS(apszFields))
+    {
+        apszFields[cFields++] = psz;
+        char *pszEnd = strchr(psz, ' ');
+        if (!pszEnd)
+            break;
+        *pszEnd = '\0';
+        psz = RTStrStripL(pszEnd + 1);
+    }
+    if (cFields < 6 || strcmp(apszFields[0], "lease") != 0)
+        return VERR_PARSE_ERROR;
+
+    /*
+     * Parse them.
+     */
+    RTNETADDRIPV4 addr;
+    int rc = RTNetStrToIPv4Addr(apszFields[1], &addr);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    static const char * const s_apszStates[] = { "free", "released", "expired", "offered", "acked" };
+    const char *pszState = apszFields[2];
+    unsigned    iState   = 0;
+    while (iState < RT_ELEMENTS(s_apszStates) && strcmp(pszState, s_apszStates[iState]) != 0)
+        iState++;
+    if (iState >= RT_ELEMENTS(s_apszStates))
+        return VERR_PARSE_ERROR;
+
+    int64_t secIssued;
+    rc = RTStrToInt64Full(apszFields[3], 10, &secIssued);
+    if (rc != VINF_SUCCESS)
+        return VERR_PARSE_ERROR;
+
+    uint32_t cSecToLive;
+    rc = RTStrToUInt32Full(apszFields[4], 10, &cSecToLive);
+    if (rc != VINF_SUCCESS)
+        return VERR_PARSE_ERROR;
+
+    RTMAC mac;
+    rc = RTNetStrToMacAddr(apszFields[5], &mac);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    try
+    {
+        ClientId id(mac, OptClientId());
+        if (cFields > 6)
+        {
+            uint8_t abBytes[255];
+            size_t  cbActual;
+            rc = RTStrConvertHexBytesEx(apszFields[6], abBytes, sizeof(abBytes), 0, NULL, &cbActual);
+            if (RT_FAILURE(rc))
+                return rc;
+            id = ClientId(mac, OptClientId(std::vector<uint8_t>(&abBytes[0], &abBytes[cbActual])));
+        }
+
+        /*
+         * Update the existing binding for the address or add a new one.
+         */
+        Binding *b = i_findBinding(addr);
+        if (b)
+        {
+            if (b->isFixed())
+                return VINF_SUCCESS;
+            i_giveBindingTo(b, id);
+        }
+        else
+        {
+            if (!addressBelongs(addr))
+                DHCP_LOG_RET(VERR_OUT_OF_RANGE, ("> JOURNAL: out of range address %RTnaipv4 ignored\n", addr.u));
+            if (!m_pool.allocate(addr))
+                return VERR_DUPLICATE;
+            b = new Binding(addr, id);
+            try
+            {
+                m_bindings.push_back(b);
+            }
+            catch (std::bad_alloc &)
+            {
+                delete b;
+                m_pool.release(addr);
+                throw;
+            }
+            rc = i_indexBinding(b);
+            if (RT_FAILURE(rc))
+                return rc;
+        }
+        b->m_issued   = Timestamp::absSeconds(secIssued);
+        b->m_secLease = cSecToLive;
+        b->setState(pszState);
+    }
+    catch (std::bad_alloc &)
+    {
+        return VERR_NO_MEMORY;
+    }
+    return VINF_SUCCESS;
+}
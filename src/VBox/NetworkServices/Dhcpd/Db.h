@@ -36,8 +36,10 @@
 
 #include <iprt/cpp/ministring.h>
 #include <iprt/cpp/xml.h>
+#include <iprt/stream.h>
 
 #include <list>
+#include <map>
 
 #include "Timestamp.h"
 #include "ClientId.h"
@@ -66,17 +68,20 @@ private:
     uint32_t            m_secLease;
     /** Set if this is a fixed assignment. */
     bool                m_fFixed;
+    /** Set if the binding changed since it was last written to the lease
+     * journal or database (see Db::saveLeases). */
+    bool                m_fDirty;
 
 public:
     Binding();
     Binding(const Binding &);
 
     explicit Binding(RTNETADDRIPV4 a_Addr)
-        : m_addr(a_Addr), m_state(FREE), m_issued(), m_secLease(0), m_fFixed(false)
+        : m_addr(a_Addr), m_state(FREE), m_issued(), m_secLease(0), m_fFixed(false), m_fDirty(true)
     {}
 
     Binding(RTNETADDRIPV4 a_Addr, const ClientId &a_id)
-        : m_addr(a_Addr), m_state(FREE), m_id(a_id), m_issued(), m_secLease(0), m_fFixed(false)
+        : m_addr(a_Addr), m_state(FREE), m_id(a_id), m_issued(), m_secLease(0), m_fFixed(false), m_fDirty(true)
     {}
 
     Binding(RTNETADDRIPV4 a_Addr, const RTMAC &a_MACAddress, bool a_fFixed)
@@ -86,6 +91,7 @@ public:
         , m_issued(Timestamp::now())
         , m_secLease(UINT32_MAX - 1)
         , m_fFixed(a_fFixed)
+        , m_fDirty(true)
     {}
 
 
@@ -105,6 +111,7 @@ public:
     Binding        &setState(State stateParam) RT_NOEXCEPT
     {
         m_state = stateParam;
+        m_fDirty = true;
         return *this;
     }
 
@@ -116,23 +123,20 @@ public:
     {
         m_issued = Timestamp::now();
         m_secLease = secLease;
+        m_fDirty = true;
         return *this;
     }
 
-    /** Reassigns the binding to the given client.   */
+    /** Reassigns the binding to the given client.
+     * @note Use Db::i_giveBindingTo() so the client ID index stays in sync. */
     Binding &giveTo(const ClientId &a_id) RT_NOEXCEPT
     {
         m_id = a_id;
         m_state = FREE;
+        m_fDirty = true;
         return *this;
     }
 
-    void free()
-    {
-        m_id = ClientId();
-        m_state = FREE;
-    }
-
     bool expire(Timestamp tsDeadline) RT_NOEXCEPT;
     bool expire() RT_NOEXCEPT
     {
@@ -143,6 +147,7 @@ public:
      * @{ */
     static Binding *fromXML(const xml::ElementNode *pElmLease);
     void            toXML(xml::ElementNode *pElmParent) const;
+    int             toJournal(PRTSTREAM pStrm) const RT_NOEXCEPT;
     /** @} */
 
     /** @name String formatting of %R[binding].
@@ -165,12 +170,21 @@ private:
  * residing in Dhcpd::m_db.  It covers one single range of IPv4 addresses, which
  * currently unbound addressed are managed by m_pool.  The allocated addresses
  * are kept in the m_bindings list.  Once an address has been allocated, it will
- * stay in the m_bindings list even after released or expired.
+ * stay in the m_bindings list even after released or expired.  The bindings are
+ * indexed by address (m_addrIndex) and, for the dynamic ones, by client ID
+ * (m_idIndex), so looking up a known client doesn't involve walking the list.
+ *
+ * On disk the database consists of the XML lease file and an append-only
+ * journal next to it (the lease file name with a "-journal" suffix).  Changed
+ * bindings are appended to the journal as one text line each, and every now
+ * and then the journal is compacted into the XML file (see saveLeases()).
  */
 class Db
 {
 private:
     typedef std::list<Binding *> bindings_t;
+    typedef std::map<IPV4HADDR, Binding *> addrindex_t;
+    typedef std::map<ClientId, Binding *> idindex_t;
 
     /** Configuration (set at init).
      * @note Currently not used.  */
@@ -179,9 +193,20 @@ private:
      * @note Since fixed assignments are added during initialization, they will
      *       always be first.  The allocateBinding() code depends on this.  */
     bindings_t      m_bindings;
+    /** All bindings indexed by (host order) address. */
+    addrindex_t     m_addrIndex;
+    /** The dynamic (non-fixed) bindings indexed by client ID. */
+    idindex_t       m_idIndex;
     /** Address allocation pool. */
     IPv4Pool        m_pool;
 
+    /** The open lease journal, NULL if not open (yet). */
+    PRTSTREAM       m_pJournal;
+    /** Number of records in the lease journal. */
+    uint32_t        m_cJournalRecords;
+    /** RTTimeMilliTS() of the last compaction of the journal into the XML file. */
+    uint64_t        m_msLastCompaction;
+
 public:
     Db();
     ~Db();
@@ -202,17 +227,37 @@ public:
      * @{ */
     int      loadLeases(const RTCString &strFilename) RT_NOEXCEPT;
 private:
+    int      i_loadLeaseFile(const RTCString &strFilename) RT_NOEXCEPT;
     int      i_loadLease(const xml::ElementNode *pElmLease) RT_NOEXCEPT;
+    int      i_replayJournal(const RTCString &strFilename) RT_NOEXCEPT;
+    int      i_replayJournalRecord(char *pszLine) RT_NOEXCEPT;
+    static int i_checkJournalRecord(char *pszLine) RT_NOEXCEPT;
 public:
+    int      saveLeases(const RTCString &strFilename) RT_NOEXCEPT;
     int      writeLeases(const RTCString &strFilename) const RT_NOEXCEPT;
+private:
+    int      i_compactLeases(const RTCString &strFilename) RT_NOEXCEPT;
+    void     i_clearDirty() RT_NOEXCEPT;
+    static RTCString i_journalFilename(const RTCString &strFilename);
     /** @} */
 
+    /** Compact when the journal has more records than this or the number of
+     * bindings, whichever is larger. */
+    static const uint32_t s_cMinJournalRecords  = 256;
+    /** Compact pending journal records when the XML file is older than this
+     * (milliseconds), so readers of it (Main) don't lag too much behind. */
+    static const uint32_t s_cMsCompactInterval  = 10000;
+
 private:
     int      i_enterFixedAddressAssignment(RTNETADDRIPV4 const &a_rAddress, RTMAC const &a_rMACAddress) RT_NOEXCEPT;
     Binding *i_createBinding(const ClientId &id = ClientId());
     Binding *i_createBinding(RTNETADDRIPV4 addr, const ClientId &id = ClientId());
 
     Binding *i_allocateAddress(const ClientId &id, RTNETADDRIPV4 addr);
+    Binding *i_findBinding(const ClientId &id) RT_NOEXCEPT;
+    Binding *i_findBinding(RTNETADDRIPV4 addr) RT_NOEXCEPT;
+    void     i_giveBindingTo(Binding *pBinding, const ClientId &id);
+    int      i_indexBinding(Binding *pBinding) RT_NOEXCEPT;
 
     /* add binding e.g. from the leases file */
     int      i_addBinding(Binding *pNewBinding) RT_NOEXCEPT;
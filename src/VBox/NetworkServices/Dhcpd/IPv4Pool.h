@@ -34,7 +34,7 @@
 #include <iprt/asm.h>
 #include <iprt/stdint.h>
 #include <iprt/net.h>
-#include <set>
+#include <vector>
 
 
 /** Host order IPv4 address. */
@@ -110,28 +110,36 @@ inline bool operator<(const IPv4Range &l, const IPv4Range &r)  RT_NOEXCEPT
  * IPv4 address pool.
  *
  * This manages a single range of IPv4 addresses (m_range).   Unallocated
- * addresses are tracked as a set of sub-ranges in the m_pool set.
- *
+ * addresses are tracked in the m_bmFree bitmap, one bit per address in the
+ * range, so that allocating and releasing an address doesn't involve any
+ * searching through or re-inserting of sub-ranges.
  */
 class IPv4Pool
 {
-    typedef std::set<IPv4Range> set_t;
-    typedef set_t::iterator it_t;
-
     /** The IPv4 range of this pool. */
-    IPv4Range   m_range;
-    /** Pool of available IPv4 ranges. */
-    set_t       m_pool;
+    IPv4Range               m_range;
+    /** Bitmap of available addresses, bit N set means m_range.FirstAddr + N is
+     * available.  Padded to a multiple of 32 bits with clear bits. */
+    std::vector<uint32_t>   m_bmFree;
+    /** Number of bits in m_bmFree (multiple of 32). */
+    uint32_t                m_cBits;
+    /** Search hint: all addresses below this bit index are allocated. */
+    uint32_t                m_iFirstFree;
 
 public:
+    /** Upper limit on the size of the pool range (keeps the bitmap reasonable). */
+    static const uint32_t s_cMaxAddrs = UINT32_C(0x04000000);
+
     IPv4Pool()
+        : m_cBits(0), m_iFirstFree(0)
     {}
 
     int init(const IPv4Range &aRange) RT_NOEXCEPT;
     int init(RTNETADDRIPV4 aFirstAddr, RTNETADDRIPV4 aLastAddr) RT_NOEXCEPT;
 
-    RTNETADDRIPV4 allocate();
-    bool          allocate(RTNETADDRIPV4);
+    RTNETADDRIPV4 allocate() RT_NOEXCEPT;
+    bool          allocate(RTNETADDRIPV4) RT_NOEXCEPT;
+    void          release(RTNETADDRIPV4) RT_NOEXCEPT;
 
     /**
      * Checks if the pool range includes @a a_Addr (allocation status not considered).
@@ -140,15 +148,6 @@ public:
     {
         return m_range.contains(a_Addr);
     }
-
-private:
-    int i_insert(const IPv4Range &range) RT_NOEXCEPT;
-#if 0
-    int i_insert(IPV4HADDR a_Single) RT_NOEXCEPT                          { return i_insert(IPv4Range(a_Single)); }
-#endif
-    int i_insert(IPV4HADDR a_First, IPV4HADDR a_Last) RT_NOEXCEPT         { return i_insert(IPv4Range(a_First, a_Last)); }
-    int i_insert(RTNETADDRIPV4 a_Single) RT_NOEXCEPT                      { return i_insert(IPv4Range(a_Single)); }
-    int i_insert(RTNETADDRIPV4 a_First, RTNETADDRIPV4 a_Last) RT_NOEXCEPT { return i_insert(IPv4Range(a_First, a_Last)); }
 };
 
 #endif /* !VBOX_INCLUDED_SRC_Dhcpd_IPv4Pool_h */
@@ -37,6 +37,7 @@
 #include "IntNetSwitchInternal.h"
 
 #include <VBox/err.h>
+#include <VBox/intnetinline.h>
 #include <VBox/vmm/vmm.h>
 #include <iprt/asm.h>
 #include <iprt/critsect.h>
@@ -54,6 +55,10 @@
 /*********************************************************************************************************************************
 *   Defined Constants And Macros                                                                                                 *
 *********************************************************************************************************************************/
+/** Maximum number of passes over a client send ring per send doorbell.
+ * Clients keep committing frames while the switch is busy with the previous
+ * burst, picking these up here saves them ringing the doorbell again. */
+#define INTNETR3_SEND_MAX_PASSES            8
 
 
 /*********************************************************************************************************************************
@@ -122,6 +127,10 @@ typedef struct SUPDRVSESSION
     xpc_connection_t                hXpcCon;
     /** The intnet interface handle to wait on. */
     INTNETIFHANDLE                  hIfWait;
+    /** The interface the shared buffer below belongs to. */
+    INTNETIFHANDLE                  hIfBuf;
+    /** The shared send/receive buffer handed to the client, NULL if none. */
+    PINTNETBUF                      pBuf;
     /** Flag whether a receive wait was initiated. */
     bool volatile                   fRecvWait;
     /** Flag whether there is something to receive. */
@@ -483,6 +492,11 @@ static void intnetR3RequestProcess(xpc_connection_t hCon, xpc_object_t hObj, PSU
             {
                 if (cbReq == sizeof(INTNETIFCLOSEREQ))
                 {
+                    if (ReqReply.IfCloseReq.hIf == pSession->hIfBuf)
+                    {
+                        pSession->pBuf   = NULL;
+                        pSession->hIfBuf = INTNET_HANDLE_INVALID;
+                    }
                     rc = IntNetR0IfCloseReq(pSession, &ReqReply.IfCloseReq);
                     cbReply = sizeof(INTNETIFCLOSEREQ);
                 }
@@ -504,6 +518,9 @@ static void intnetR3RequestProcess(xpc_connection_t hCon, xpc_object_t hObj, PSU
                         {
                             xpc_dictionary_set_value(hObjReply, "buf-ptr", hObjShMem);
                             xpc_release(hObjShMem);
+
+                            pSession->hIfBuf = ReqReply.IfGetBufferPtrsReq.hIf;
+                            pSession->pBuf   = ReqReply.IfGetBufferPtrsReq.pRing3Buf;
                         }
                         else
                             rc = VERR_NO_MEMORY;
@@ -555,7 +572,20 @@ static void intnetR3RequestProcess(xpc_connection_t hCon, xpc_object_t hObj, PSU
             {
                 if (cbReq == sizeof(INTNETIFSENDREQ))
                 {
-                    rc = IntNetR0IfSendReq(pSession, &ReqReply.IfSendReq);
+                    /*
+                     * The request is just a doorbell, the frames are in the shared
+                     * send ring.  Keep draining it in bursts while the client keeps
+                     * adding frames, the client only rings again once it sees our
+                     * reply and the ring still isn't empty.
+                     */
+                    PINTNETBUF pBuf = ReqReply.IfSendReq.hIf == pSession->hIfBuf ? pSession->pBuf : NULL;
+                    unsigned   cPasses = 0;
+                    do
+                        rc = IntNetR0IfSendReq(pSession, &ReqReply.IfSendReq);
+                    while (   RT_SUCCESS(rc)
+                           && pBuf
+                           && IntNetRingHasMoreToRead(&pBuf->Send)
+                           && ++cPasses < INTNETR3_SEND_MAX_PASSES);
                     cbReply = sizeof(INTNETIFSENDREQ);
                 }
                 else
@@ -643,6 +673,7 @@ static DECLCALLBACK(void) xpcConnHandler(xpc_connection_t hXpcCon)
     {
         pSession->pDevExt = &g_DevExt;
         pSession->hXpcCon = hXpcCon;
+        pSession->hIfBuf  = INTNET_HANDLE_INVALID;
 
         xpc_connection_set_context(hXpcCon, pSession);
         xpc_connection_resume(hXpcCon);
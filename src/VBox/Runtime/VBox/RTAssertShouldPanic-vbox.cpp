@@ -41,6 +41,7 @@
 #include <iprt/assert.h>
 #include <iprt/env.h>
 #include <iprt/errcore.h>
+#include <iprt/log.h>
 #include <iprt/string.h>
 
 /** @def VBOX_RTASSERT_WITH_GDB
@@ -202,6 +203,14 @@ static bool rtAssertShouldPanicWorker(void)
 
 RTDECL(bool) RTAssertShouldPanic(void)
 {
+#if defined(IN_RING3) && !defined(IN_GUEST)
+    /*
+     * Get the assertion and whatever preceeded it out of any asynchronous
+     * log buffers before we possibly panic or wait for a debugger.
+     */
+    RTLogAsyncOutputFlushAll();
+#endif
+
     /*
      * Check if panicing is excluded by the RTAssert settings first.
      */
@@ -46,11 +46,23 @@
 #include <iprt/critsect.h>
 #include <iprt/err.h>
 #include <iprt/mem.h>
+#include <iprt/mp.h>
+#include <iprt/string.h>
 #include <iprt/system.h>
+#include <iprt/thread.h>
 
 #include "internal/magics.h"
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** The number of objects a magazine can hold (RTMEMCACHE_F_MAGAZINES). */
+#define RTMEMCACHE_MAG_ROUNDS       14
+/** The max number of magazine slots. */
+#define RTMEMCACHE_MAG_SLOTS_MAX    64
+
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
@@ -109,6 +121,60 @@ typedef struct RTMEMCACHEPAGE
 AssertCompileMemberOffset(RTMEMCACHEPAGE, cFree, 64);
 
 
+/**
+ * A magazine of free objects (RTMEMCACHE_F_MAGAZINES).
+ *
+ * The objects in a magazine are still marked as allocated in the page bitmaps
+ * and keep their constructed state.
+ */
+typedef struct RTMEMCACHEMAG
+{
+    /** Pointer to the next magazine in the depot list. */
+    struct RTMEMCACHEMAG       *pNext;
+    /** The number of objects in the magazine. */
+    uint32_t                    cRounds;
+    /** The objects. */
+    void                       *apvObjs[RTMEMCACHE_MAG_ROUNDS];
+} RTMEMCACHEMAG;
+/** Pointer to a magazine. */
+typedef RTMEMCACHEMAG *PRTMEMCACHEMAG;
+
+
+/**
+ * A magazine slot.
+ *
+ * Threads are hashed onto slots, which are owned thru a simple try-lock.  A
+ * thread finding its slot busy just goes to the page level instead of waiting.
+ */
+typedef struct RTMEMCACHESLOT
+{
+    /** Set while a thread is using the slot. */
+    bool volatile               fBusy;
+    /** The magazine objects are taken from and returned to. */
+    PRTMEMCACHEMAG              pLoaded;
+    /** The previous magazine, either full or empty. */
+    PRTMEMCACHEMAG              pPrev;
+    /** Allocations served by the slot. */
+    uint64_t                    cAllocHits;
+    /** Allocations the slot couldn't serve. */
+    uint64_t                    cAllocMisses;
+    /** Frees absorbed by the slot. */
+    uint64_t                    cFreeHits;
+    /** Frees the slot couldn't absorb. */
+    uint64_t                    cFreeMisses;
+} RTMEMCACHESLOT;
+/** Pointer to a magazine slot. */
+typedef RTMEMCACHESLOT *PRTMEMCACHESLOT;
+
+/** Magazine slot padded to a cache line. (ASSUMES CL = 64) */
+typedef union RTMEMCACHESLOTPADDED
+{
+    RTMEMCACHESLOT              s;
+    uint8_t                     abPadding[64];
+} RTMEMCACHESLOTPADDED;
+AssertCompileSize(RTMEMCACHESLOTPADDED, 64);
+
+
 /**
  * Memory object cache instance.
  */
@@ -156,6 +222,31 @@ typedef struct RTMEMCACHEINT
      *       cache.  Also, it totally doesn't work when the objects are too
      *       small. */
     PRTMEMCACHEFREEOBJ volatile pFreeTop;
+
+    /** @name Magazine layer (RTMEMCACHE_F_MAGAZINES).
+     * The depot members are protected by CritSect.
+     * @{ */
+    /** Whether the magazine layer is enabled. */
+    bool                        fMagazines;
+    /** Mask for hashing threads onto the slots (power of two minus one). */
+    uint32_t                    fSlotMask;
+    /** The magazine slots (page allocation). */
+    RTMEMCACHESLOTPADDED       *paSlots;
+    /** Size of the paSlots allocation. */
+    size_t                      cbSlots;
+    /** Depot list of full magazines. */
+    PRTMEMCACHEMAG              pDepotFull;
+    /** Depot list of empty magazines. */
+    PRTMEMCACHEMAG              pDepotEmpty;
+    /** Number of magazines on the full list. */
+    uint32_t                    cDepotFull;
+    /** Number of magazines on the empty list. */
+    uint32_t                    cDepotEmpty;
+    /** Number of times a thread found its slot busy. */
+    uint64_t volatile           cMagContention;
+    /** Number of times the magazines were drained back to the pages. */
+    uint64_t volatile           cReclaims;
+    /** @} */
 } RTMEMCACHEINT;
 
 
@@ -163,6 +254,7 @@ typedef struct RTMEMCACHEINT
 *   Internal Functions                                                                                                           *
 *********************************************************************************************************************************/
 static void rtMemCacheFreeList(RTMEMCACHEINT *pThis, PRTMEMCACHEFREEOBJ pHead);
+static void rtMemCacheFreeOne(RTMEMCACHEINT *pThis, void *pvObj);
 
 
 RTDECL(int) RTMemCacheCreate(PRTMEMCACHE phMemCache, size_t cbObject, size_t cbAlignment, uint32_t cMaxObjects,
@@ -177,7 +269,7 @@ RTDECL(int) RTMemCacheCreate(PRTMEMCACHE phMemCache, size_t cbObject, size_t cbA
 
     size_t const cbPage = RTSystemGetPageSize();
     AssertReturn(cbObject <= cbPage / 8, VERR_INVALID_PARAMETER);
-    AssertReturn(!fFlags, VERR_INVALID_PARAMETER);
+    AssertReturn(!(fFlags & ~RTMEMCACHE_F_VALID_MASK), VERR_INVALID_FLAGS);
 
     if (cbAlignment == 0)
     {
@@ -226,7 +318,8 @@ RTDECL(int) RTMemCacheCreate(PRTMEMCACHE phMemCache, size_t cbObject, size_t cbA
     pThis->cMax             = cMaxObjects;
     pThis->fUseFreeList     = cbObject >= sizeof(RTMEMCACHEFREEOBJ)
                            && !pfnCtor
-                           && !pfnDtor;
+                           && !pfnDtor
+                           && !(fFlags & RTMEMCACHE_F_MAGAZINES);
     pThis->pPageHead        = NULL;
     pThis->ppPageNext       = &pThis->pPageHead;
     pThis->pfnCtor          = pfnCtor;
@@ -236,6 +329,35 @@ RTDECL(int) RTMemCacheCreate(PRTMEMCACHE phMemCache, size_t cbObject, size_t cbA
     pThis->cFree            = 0;
     pThis->pPageHint        = NULL;
     pThis->pFreeTop         = NULL;
+    pThis->fMagazines       = false;
+    pThis->fSlotMask        = 0;
+    pThis->paSlots          = NULL;
+    pThis->cbSlots          = 0;
+    pThis->pDepotFull       = NULL;
+    pThis->pDepotEmpty      = NULL;
+    pThis->cDepotFull       = 0;
+    pThis->cDepotEmpty      = 0;
+    pThis->cMagContention   = 0;
+    pThis->cReclaims        = 0;
+
+    if (fFlags & RTMEMCACHE_F_MAGAZINES)
+    {
+        /* Two slots per CPU to keep hash collisions between threads down. */
+        uint32_t const cCpus  = RT_MAX(RTMpGetCount(), 1);
+        uint32_t       cSlots = 2;
+        while (cSlots < cCpus * 2 && cSlots < RTMEMCACHE_MAG_SLOTS_MAX)
+            cSlots *= 2;
+        pThis->cbSlots = RT_ALIGN_Z(cSlots * sizeof(RTMEMCACHESLOTPADDED), cbPage);
+        pThis->paSlots = (RTMEMCACHESLOTPADDED *)RTMemPageAllocZ(pThis->cbSlots);
+        if (!pThis->paSlots)
+        {
+            RTCritSectDelete(&pThis->CritSect);
+            RTMemFree(pThis);
+            return VERR_NO_MEMORY;
+        }
+        pThis->fSlotMask  = cSlots - 1;
+        pThis->fMagazines = true;
+    }
 
     *phMemCache = pThis;
     return VINF_SUCCESS;
@@ -263,6 +385,29 @@ RTDECL(int) RTMemCacheDestroy(RTMEMCACHE hMemCache)
     AssertReturn(ASMAtomicCmpXchgU32(&pThis->u32Magic, RTMEMCACHE_MAGIC_DEAD, RTMEMCACHE_MAGIC), VERR_INVALID_HANDLE);
     RTCritSectDelete(&pThis->CritSect);
 
+    /* The magazines only hold objects that are still allocated in the pages,
+       so they can just be freed, the page loop below takes care of the dtor. */
+    if (pThis->paSlots)
+    {
+        for (uint32_t iSlot = 0; iSlot <= pThis->fSlotMask; iSlot++)
+        {
+            RTMemFree(pThis->paSlots[iSlot].s.pLoaded);
+            RTMemFree(pThis->paSlots[iSlot].s.pPrev);
+        }
+        RTMemPageFree(pThis->paSlots, pThis->cbSlots);
+        pThis->paSlots = NULL;
+    }
+    PRTMEMCACHEMAG apDepot[2] = { pThis->pDepotFull, pThis->pDepotEmpty };
+    for (unsigned i = 0; i < RT_ELEMENTS(apDepot); i++)
+        while (apDepot[i])
+        {
+            PRTMEMCACHEMAG pMag = apDepot[i];
+            apDepot[i] = pMag->pNext;
+            RTMemFree(pMag);
+        }
+    pThis->pDepotFull  = NULL;
+    pThis->pDepotEmpty = NULL;
+
     while (pThis->pPageHead)
     {
         PRTMEMCACHEPAGE pPage = pThis->pPageHead;
@@ -372,12 +517,230 @@ DECL_FORCE_INLINE(int32_t) rtMemCacheGrabObj(PRTMEMCACHEPAGE pPage)
 }
 
 
+/**
+ * Locks the magazine slot of the calling thread.
+ *
+ * @returns Pointer to the locked slot, NULL if busy.
+ * @param   pThis               The memory cache instance.
+ */
+DECL_FORCE_INLINE(PRTMEMCACHESLOT) rtMemCacheMagLockSlot(RTMEMCACHEINT *pThis)
+{
+    uint64_t const  uHash = (uint64_t)RTThreadNativeSelf() * UINT64_C(0x9e3779b97f4a7c15);
+    PRTMEMCACHESLOT pSlot = &pThis->paSlots[(uint32_t)(uHash >> 32) & pThis->fSlotMask].s;
+    if (ASMAtomicCmpXchgBool(&pSlot->fBusy, true, false))
+        return pSlot;
+    ASMAtomicIncU64(&pThis->cMagContention);
+    return NULL;
+}
+
+
+/**
+ * Tries to allocate an object from the magazine layer.
+ *
+ * @returns Pointer to the object, NULL if the page level has to be used.
+ * @param   pThis               The memory cache instance.
+ */
+static void *rtMemCacheMagAlloc(RTMEMCACHEINT *pThis)
+{
+    PRTMEMCACHESLOT pSlot = rtMemCacheMagLockSlot(pThis);
+    if (!pSlot)
+        return NULL;
+
+    PRTMEMCACHEMAG pMag = pSlot->pLoaded;
+    if (!pMag || !pMag->cRounds)
+    {
+        if (pSlot->pPrev && pSlot->pPrev->cRounds)
+        {
+            pSlot->pLoaded = pSlot->pPrev;
+            pSlot->pPrev   = pMag;
+            pMag = pSlot->pLoaded;
+        }
+        else
+        {
+            /* Trade the empty magazine for a full one from the depot. */
+            RTCritSectEnter(&pThis->CritSect);
+            PRTMEMCACHEMAG pFull = pThis->pDepotFull;
+            if (pFull)
+            {
+                pThis->pDepotFull = pFull->pNext;
+                pThis->cDepotFull--;
+                pFull->pNext = NULL;
+                if (pMag)
+                {
+                    pMag->pNext = pThis->pDepotEmpty;
+                    pThis->pDepotEmpty = pMag;
+                    pThis->cDepotEmpty++;
+                }
+                pSlot->pLoaded = pFull;
+            }
+            RTCritSectLeave(&pThis->CritSect);
+            pMag = pFull;
+        }
+    }
+
+    void *pvObj = NULL;
+    if (pMag && pMag->cRounds)
+    {
+        pvObj = pMag->apvObjs[--pMag->cRounds];
+        pSlot->cAllocHits++;
+    }
+    else
+        pSlot->cAllocMisses++;
+
+    ASMAtomicWriteBool(&pSlot->fBusy, false);
+    return pvObj;
+}
+
+
+/**
+ * Tries to put a freed object into the magazine layer.
+ *
+ * @returns true if absorbed, false if it has to be freed at the page level.
+ * @param   pThis               The memory cache instance.
+ * @param   pvObj               The object.
+ */
+static bool rtMemCacheMagFree(RTMEMCACHEINT *pThis, void *pvObj)
+{
+    PRTMEMCACHESLOT pSlot = rtMemCacheMagLockSlot(pThis);
+    if (!pSlot)
+        return false;
+
+    PRTMEMCACHEMAG pMag = pSlot->pLoaded;
+    if (!pMag || pMag->cRounds >= RTMEMCACHE_MAG_ROUNDS)
+    {
+        if (pSlot->pPrev && pSlot->pPrev->cRounds < RTMEMCACHE_MAG_ROUNDS)
+        {
+            pSlot->pLoaded = pSlot->pPrev;
+            pSlot->pPrev   = pMag;
+            pMag = pSlot->pLoaded;
+        }
+        else
+        {
+            /* Retire the previous (full) magazine to the depot and load an empty one. */
+            RTCritSectEnter(&pThis->CritSect);
+            PRTMEMCACHEMAG pEmpty = pThis->pDepotEmpty;
+            if (pEmpty)
+            {
+                pThis->pDepotEmpty = pEmpty->pNext;
+                pThis->cDepotEmpty--;
+            }
+            else
+                pEmpty = (PRTMEMCACHEMAG)RTMemAlloc(sizeof(*pEmpty));
+            if (pEmpty)
+            {
+                pEmpty->pNext   = NULL;
+                pEmpty->cRounds = 0;
+                if (pSlot->pPrev)
+                {
+                    pSlot->pPrev->pNext = pThis->pDepotFull;
+                    pThis->pDepotFull = pSlot->pPrev;
+                    pThis->cDepotFull++;
+                }
+                pSlot->pPrev   = pMag;
+                pSlot->pLoaded = pEmpty;
+            }
+            RTCritSectLeave(&pThis->CritSect);
+            pMag = pEmpty;
+        }
+    }
+
+    bool fAbsorbed = false;
+    if (pMag)
+    {
+        pMag->apvObjs[pMag->cRounds++] = pvObj;
+        pSlot->cFreeHits++;
+        fAbsorbed = true;
+    }
+    else
+        pSlot->cFreeMisses++;
+
+    ASMAtomicWriteBool(&pSlot->fBusy, false);
+    return fAbsorbed;
+}
+
+
+/**
+ * Empties a magazine, freeing the objects at the page level.
+ *
+ * @returns Number of objects freed.
+ * @param   pThis               The memory cache instance.
+ * @param   pMag                The magazine, NULL is fine.
+ */
+static uint32_t rtMemCacheMagEmpty(RTMEMCACHEINT *pThis, PRTMEMCACHEMAG pMag)
+{
+    uint32_t cFreed = 0;
+    if (pMag)
+    {
+        cFreed = pMag->cRounds;
+        while (pMag->cRounds > 0)
+            rtMemCacheFreeOne(pThis, pMag->apvObjs[--pMag->cRounds]);
+    }
+    return cFreed;
+}
+
+
+/**
+ * Drains the depot and all idle slots back to the page level.
+ *
+ * This is used when the cache has hit its size limit so that objects parked in
+ * magazines of other threads aren't lost to the allocator.
+ *
+ * @returns true if any objects were freed, false if not.
+ * @param   pThis               The memory cache instance.
+ */
+static bool rtMemCacheMagReclaim(RTMEMCACHEINT *pThis)
+{
+    ASMAtomicIncU64(&pThis->cReclaims);
+    uint32_t cFreed = 0;
+
+    RTCritSectEnter(&pThis->CritSect);
+    while (pThis->pDepotFull)
+    {
+        PRTMEMCACHEMAG pMag = pThis->pDepotFull;
+        pThis->pDepotFull = pMag->pNext;
+        pThis->cDepotFull--;
+        cFreed += rtMemCacheMagEmpty(pThis, pMag);
+        pMag->pNext = pThis->pDepotEmpty;
+        pThis->pDepotEmpty = pMag;
+        pThis->cDepotEmpty++;
+    }
+    RTCritSectLeave(&pThis->CritSect);
+
+    /* Not holding CritSect here, the allocation path takes it while owning a slot. */
+    for (uint32_t iSlot = 0; iSlot <= pThis->fSlotMask; iSlot++)
+    {
+        PRTMEMCACHESLOT pSlot = &pThis->paSlots[iSlot].s;
+        if (ASMAtomicCmpXchgBool(&pSlot->fBusy, true, false))
+        {
+            cFreed += rtMemCacheMagEmpty(pThis, pSlot->pLoaded);
+            cFreed += rtMemCacheMagEmpty(pThis, pSlot->pPrev);
+            ASMAtomicWriteBool(&pSlot->fBusy, false);
+        }
+    }
+
+    return cFreed > 0;
+}
+
+
 RTDECL(int) RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj)
 {
     RTMEMCACHEINT *pThis = hMemCache;
     AssertPtrReturn(pThis, VERR_INVALID_PARAMETER);
     AssertReturn(pThis->u32Magic == RTMEMCACHE_MAGIC, VERR_INVALID_PARAMETER);
 
+    /*
+     * Try the magazine layer first.
+     */
+    if (pThis->fMagazines)
+    {
+        void *pvObj = rtMemCacheMagAlloc(pThis);
+        if (pvObj)
+        {
+            *ppvObj = pvObj;
+            return VINF_SUCCESS;
+        }
+    }
+
     /*
      * Try grab a free object from the stack.
      */
@@ -412,6 +775,8 @@ RTDECL(int) RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj)
             || (uint32_t)(cTotal + -cNewFree) <= cTotal)
         {
             ASMAtomicIncS32(&pThis->cFree);
+            if (pThis->fMagazines && rtMemCacheMagReclaim(pThis))
+                return RTMemCacheAllocEx(hMemCache, ppvObj);
             return VERR_MEM_CACHE_MAX_SIZE;
         }
 
@@ -484,7 +849,7 @@ RTDECL(int) RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj)
         if (RT_FAILURE(rc))
         {
             ASMAtomicBitClear(pPage->pbmCtor, iObj);
-            RTMemCacheFree(pThis, pvObj);
+            rtMemCacheFreeOne(pThis, pvObj); /* not into a magazine, it isn't constructed */
             return rc;
         }
     }
@@ -568,6 +933,9 @@ RTDECL(void) RTMemCacheFree(RTMEMCACHE hMemCache, void *pvObj)
     AssertPtr(pvObj);
     Assert(RT_ALIGN_P(pvObj, pThis->cbAlignment) == pvObj);
 
+    if (pThis->fMagazines && rtMemCacheMagFree(pThis, pvObj))
+        return;
+
     if (!pThis->fUseFreeList)
         rtMemCacheFreeOne(pThis, pvObj);
     else
@@ -595,3 +963,37 @@ RTDECL(void) RTMemCacheFree(RTMEMCACHE hMemCache, void *pvObj)
     }
 }
 
+
+RTDECL(int) RTMemCacheQueryStats(RTMEMCACHE hMemCache, PRTMEMCACHESTATS pStats)
+{
+    RTMEMCACHEINT *pThis = hMemCache;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertReturn(pThis->u32Magic == RTMEMCACHE_MAGIC, VERR_INVALID_HANDLE);
+    AssertPtrReturn(pStats, VERR_INVALID_POINTER);
+
+    RT_ZERO(*pStats);
+    pStats->cbObject = pThis->cbObject;
+    pStats->cTotal   = ASMAtomicUoReadU32(&pThis->cTotal);
+    pStats->cFree    = ASMAtomicUoReadS32(&pThis->cFree);
+    if (pThis->fMagazines)
+    {
+        RTCritSectEnter(&pThis->CritSect);
+        pStats->cDepotFull  = pThis->cDepotFull;
+        pStats->cDepotEmpty = pThis->cDepotEmpty;
+        RTCritSectLeave(&pThis->CritSect);
+
+        /* Unserialized, the counters are only updated by the slot owner. */
+        for (uint32_t iSlot = 0; iSlot <= pThis->fSlotMask; iSlot++)
+        {
+            PRTMEMCACHESLOT pSlot = &pThis->paSlots[iSlot].s;
+            pStats->cMagAllocHits   += pSlot->cAllocHits;
+            pStats->cMagAllocMisses += pSlot->cAllocMisses;
+            pStats->cMagFreeHits    += pSlot->cFreeHits;
+            pStats->cMagFreeMisses  += pSlot->cFreeMisses;
+        }
+        pStats->cMagContention = ASMAtomicUoReadU64(&pThis->cMagContention);
+        pStats->cReclaims      = ASMAtomicUoReadU64(&pThis->cReclaims);
+    }
+    return VINF_SUCCESS;
+}
+
@@ -54,6 +54,21 @@
 #include <iprt/asm.h>
 #include <iprt/string.h>
 
+/** @def RTSHA256_WITH_SHANI
+ * Process blocks using the SHA extensions when the CPU supports them (ring-3
+ * only as the kernel contexts would have to save the SIMD state first). */
+#if defined(IN_RING3) && defined(RT_ARCH_AMD64)
+# include <iprt/asm-amd64-x86.h>
+# include <iprt/x86.h>
+# include <immintrin.h>
+# define RTSHA256_WITH_SHANI
+# if defined(__GNUC__)
+#  define RTSHA256_TARGET_SHANI     __attribute__((__target__("sha,sse4.1,ssse3")))
+# else
+#  define RTSHA256_TARGET_SHANI
+# endif
+#endif
+
 
 /** Our private context structure. */
 typedef struct RTSHA256ALTPRIVATECTX
@@ -103,6 +118,11 @@ static uint32_t const g_auKs[] =
 };
 #endif /* !RTSHA256_UNROLLED */
 
+#ifdef RTSHA256_WITH_SHANI
+/** Whether the host CPU has the SHA extensions, -1 if not determined yet. */
+static int volatile g_iSha256ShaNiSupported = -1;
+#endif
+
 
 
 RTDECL(void) RTSha256Init(PRTSHA256CONTEXT pCtx)
@@ -468,6 +488,202 @@ static void rtSha256BlockProcess(PRTSHA256CONTEXT pCtx)
 }
 
 
+#ifdef RTSHA256_WITH_SHANI
+
+/**
+ * Checks whether the host CPU has the SHA extensions.
+ *
+ * @returns true if supported, false if not.
+ */
+DECLINLINE(bool) rtSha256IsShaNiSupported(void)
+{
+    int iSupported = g_iSha256ShaNiSupported;
+    if (RT_LIKELY(iSupported >= 0))
+        return iSupported != 0;
+
+    iSupported = 0;
+    uint32_t uEax, uEbx, uEcx, uEdx;
+    ASMCpuId(0, &uEax, &uEbx, &uEcx, &uEdx);
+    if (uEax >= 7)
+    {
+        uint32_t const fEcx1 = ASMCpuId_ECX(1);
+        ASMCpuId_Idx_ECX(7, 0, &uEax, &uEbx, &uEcx, &uEdx);
+        iSupported =    (uEbx  & X86_CPUID_STEXT_FEATURE_EBX_SHA)
+                     && (fEcx1 & X86_CPUID_FEATURE_ECX_SSE4_1)
+                     && (fEcx1 & X86_CPUID_FEATURE_ECX_SSSE3);
+    }
+    g_iSha256ShaNiSupported = iSupported;
+    return iSupported != 0;
+}
+
+
+/**
+ * Processes whole blocks straight from the input using the SHA extensions.
+ *
+ * Unlike rtSha256BlockProcess() this works on the raw big endian input and
+ * doesn't need the W array.
+ *
+ * @param   pCtx                The SHA-256 context.
+ * @param   pbBlocks            The blocks, no alignment requirements.
+ * @param   cBlocks             Number of blocks to process.
+ */
+static RTSHA256_TARGET_SHANI void rtSha256BlocksProcessShaNi(PRTSHA256CONTEXT pCtx, uint8_t const *pbBlocks, size_t cBlocks)
+{
+    __m128i const uBSwapMask = _mm_set_epi64x(INT64_C(0x0c0d0e0f08090a0b), INT64_C(0x0405060700010203));
+
+    /* The instructions want the state as ABEF and CDGH. */
+    __m128i uTmp    = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *)&pCtx->AltPrivate.auH[0]), 0xb1); /* CDAB */
+    __m128i uState1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *)&pCtx->AltPrivate.auH[4]), 0x1b); /* EFGH */
+    __m128i uState0 = _mm_alignr_epi8(uTmp, uState1, 8);      /* ABEF */
+    uState1         = _mm_blend_epi16(uState1, uTmp, 0xf0);   /* CDGH */
+
+    while (cBlocks-- > 0)
+    {
+        __m128i const uState0Save = uState0;
+        __m128i const uState1Save = uState1;
+        __m128i uMsg, uMsg0, uMsg1, uMsg2, uMsg3;
+
+        /* Rounds 0-3. */
+        uMsg0 = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const *)(pbBlocks + 0)), uBSwapMask);
+        uMsg = _mm_add_epi32(uMsg0, _mm_set_epi64x((int64_t)UINT64_C(0xe9b5dba5b5c0fbcf), (int64_t)UINT64_C(0x71374491428a2f98)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+
+        /* Rounds 4-7. */
+        uMsg1 = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const *)(pbBlocks + 16)), uBSwapMask);
+        uMsg = _mm_add_epi32(uMsg1, _mm_set_epi64x((int64_t)UINT64_C(0xab1c5ed5923f82a4), (int64_t)UINT64_C(0x59f111f13956c25b)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg0 = _mm_sha256msg1_epu32(uMsg0, uMsg1);
+
+        /* Rounds 8-11. */
+        uMsg2 = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const *)(pbBlocks + 32)), uBSwapMask);
+        uMsg = _mm_add_epi32(uMsg2, _mm_set_epi64x((int64_t)UINT64_C(0x550c7dc3243185be), (int64_t)UINT64_C(0x12835b01d807aa98)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg1 = _mm_sha256msg1_epu32(uMsg1, uMsg2);
+
+        /* Rounds 12-15. */
+        uMsg3 = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const *)(pbBlocks + 48)), uBSwapMask);
+        uMsg = _mm_add_epi32(uMsg3, _mm_set_epi64x((int64_t)UINT64_C(0xc19bf1749bdc06a7), (int64_t)UINT64_C(0x80deb1fe72be5d74)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg0 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg0, _mm_alignr_epi8(uMsg3, uMsg2, 4)), uMsg3);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg2 = _mm_sha256msg1_epu32(uMsg2, uMsg3);
+
+        /* Rounds 16-19. */
+        uMsg = _mm_add_epi32(uMsg0, _mm_set_epi64x((int64_t)UINT64_C(0x240ca1cc0fc19dc6), (int64_t)UINT64_C(0xefbe4786e49b69c1)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg1 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg1, _mm_alignr_epi8(uMsg0, uMsg3, 4)), uMsg0);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg3 = _mm_sha256msg1_epu32(uMsg3, uMsg0);
+
+        /* Rounds 20-23. */
+        uMsg = _mm_add_epi32(uMsg1, _mm_set_epi64x((int64_t)UINT64_C(0x76f988da5cb0a9dc), (int64_t)UINT64_C(0x4a7484aa2de92c6f)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg2 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg2, _mm_alignr_epi8(uMsg1, uMsg0, 4)), uMsg1);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg0 = _mm_sha256msg1_epu32(uMsg0, uMsg1);
+
+        /* Rounds 24-27. */
+        uMsg = _mm_add_epi32(uMsg2, _mm_set_epi64x((int64_t)UINT64_C(0xbf597fc7b00327c8), (int64_t)UINT64_C(0xa831c66d983e5152)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg3 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg3, _mm_alignr_epi8(uMsg2, uMsg1, 4)), uMsg2);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg1 = _mm_sha256msg1_epu32(uMsg1, uMsg2);
+
+        /* Rounds 28-31. */
+        uMsg = _mm_add_epi32(uMsg3, _mm_set_epi64x((int64_t)UINT64_C(0x1429296706ca6351), (int64_t)UINT64_C(0xd5a79147c6e00bf3)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg0 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg0, _mm_alignr_epi8(uMsg3, uMsg2, 4)), uMsg3);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg2 = _mm_sha256msg1_epu32(uMsg2, uMsg3);
+
+        /* Rounds 32-35. */
+        uMsg = _mm_add_epi32(uMsg0, _mm_set_epi64x((int64_t)UINT64_C(0x53380d134d2c6dfc), (int64_t)UINT64_C(0x2e1b213827b70a85)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg1 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg1, _mm_alignr_epi8(uMsg0, uMsg3, 4)), uMsg0);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg3 = _mm_sha256msg1_epu32(uMsg3, uMsg0);
+
+        /* Rounds 36-39. */
+        uMsg = _mm_add_epi32(uMsg1, _mm_set_epi64x((int64_t)UINT64_C(0x92722c8581c2c92e), (int64_t)UINT64_C(0x766a0abb650a7354)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg2 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg2, _mm_alignr_epi8(uMsg1, uMsg0, 4)), uMsg1);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg0 = _mm_sha256msg1_epu32(uMsg0, uMsg1);
+
+        /* Rounds 40-43. */
+        uMsg = _mm_add_epi32(uMsg2, _mm_set_epi64x((int64_t)UINT64_C(0xc76c51a3c24b8b70), (int64_t)UINT64_C(0xa81a664ba2bfe8a1)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg3 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg3, _mm_alignr_epi8(uMsg2, uMsg1, 4)), uMsg2);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg1 = _mm_sha256msg1_epu32(uMsg1, uMsg2);
+
+        /* Rounds 44-47. */
+        uMsg = _mm_add_epi32(uMsg3, _mm_set_epi64x((int64_t)UINT64_C(0x106aa070f40e3585), (int64_t)UINT64_C(0xd6990624d192e819)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg0 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg0, _mm_alignr_epi8(uMsg3, uMsg2, 4)), uMsg3);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg2 = _mm_sha256msg1_epu32(uMsg2, uMsg3);
+
+        /* Rounds 48-51. */
+        uMsg = _mm_add_epi32(uMsg0, _mm_set_epi64x((int64_t)UINT64_C(0x34b0bcb52748774c), (int64_t)UINT64_C(0x1e376c0819a4c116)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg1 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg1, _mm_alignr_epi8(uMsg0, uMsg3, 4)), uMsg0);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uMsg3 = _mm_sha256msg1_epu32(uMsg3, uMsg0);
+
+        /* Rounds 52-55. */
+        uMsg = _mm_add_epi32(uMsg1, _mm_set_epi64x((int64_t)UINT64_C(0x682e6ff35b9cca4f), (int64_t)UINT64_C(0x4ed8aa4a391c0cb3)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg2 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg2, _mm_alignr_epi8(uMsg1, uMsg0, 4)), uMsg1);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+
+        /* Rounds 56-59. */
+        uMsg = _mm_add_epi32(uMsg2, _mm_set_epi64x((int64_t)UINT64_C(0x8cc7020884c87814), (int64_t)UINT64_C(0x78a5636f748f82ee)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uMsg3 = _mm_sha256msg2_epu32(_mm_add_epi32(uMsg3, _mm_alignr_epi8(uMsg2, uMsg1, 4)), uMsg2);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+
+        /* Rounds 60-63. */
+        uMsg = _mm_add_epi32(uMsg3, _mm_set_epi64x((int64_t)UINT64_C(0xc67178f2bef9a3f7), (int64_t)UINT64_C(0xa4506ceb90befffa)));
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg);
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, _mm_shuffle_epi32(uMsg, 0x0e));
+        uState0 = _mm_add_epi32(uState0, uState0Save);
+        uState1 = _mm_add_epi32(uState1, uState1Save);
+        pbBlocks += RTSHA256_BLOCK_SIZE;
+    }
+
+    /* Back to ABCD and EFGH. */
+    uTmp    = _mm_shuffle_epi32(uState0, 0x1b);              /* FEBA */
+    uState1 = _mm_shuffle_epi32(uState1, 0xb1);              /* DCHG */
+    _mm_storeu_si128((__m128i *)&pCtx->AltPrivate.auH[0], _mm_blend_epi16(uTmp, uState1, 0xf0)); /* DCBA */
+    _mm_storeu_si128((__m128i *)&pCtx->AltPrivate.auH[4], _mm_alignr_epi8(uState1, uTmp, 8));    /* HGFE */
+}
+
+#endif /* RTSHA256_WITH_SHANI */
+
+
+/**
+ * Processes the block buffered in the first part of the W array.
+ *
+ * @param   pCtx                The SHA-256 context.
+ */
+DECLINLINE(void) rtSha256BlockProcessBuffered(PRTSHA256CONTEXT pCtx)
+{
+#ifdef RTSHA256_WITH_SHANI
+    if (rtSha256IsShaNiSupported())
+    {
+        rtSha256BlocksProcessShaNi(pCtx, (uint8_t const *)&pCtx->AltPrivate.auW[0], 1);
+        return;
+    }
+#endif
+    rtSha256BlockInitBuffered(pCtx);
+    rtSha256BlockProcess(pCtx);
+}
+
+
 RTDECL(void) RTSha256Update(PRTSHA256CONTEXT pCtx, const void *pvBuf, size_t cbBuf)
 {
     Assert(pCtx->AltPrivate.cbMessage < UINT64_MAX / 8);
@@ -487,8 +703,7 @@ RTDECL(void) RTSha256Update(PRTSHA256CONTEXT pCtx, const void *pvBuf, size_t cbB
             pbBuf += cbMissing;
             cbBuf -= cbMissing;
 
-            rtSha256BlockInitBuffered(pCtx);
-            rtSha256BlockProcess(pCtx);
+            rtSha256BlockProcessBuffered(pCtx);
         }
         else
         {
@@ -498,6 +713,22 @@ RTDECL(void) RTSha256Update(PRTSHA256CONTEXT pCtx, const void *pvBuf, size_t cbB
         }
     }
 
+#ifdef RTSHA256_WITH_SHANI
+    if (   cbBuf >= RTSHA256_BLOCK_SIZE
+        && rtSha256IsShaNiSupported())
+    {
+        /*
+         * Process all full blocks in one go, alignment doesn't matter.
+         */
+        size_t const cBlocks = cbBuf / RTSHA256_BLOCK_SIZE;
+        rtSha256BlocksProcessShaNi(pCtx, pbBuf, cBlocks);
+
+        pCtx->AltPrivate.cbMessage += cBlocks * RTSHA256_BLOCK_SIZE;
+        pbBuf += cBlocks * RTSHA256_BLOCK_SIZE;
+        cbBuf -= cBlocks * RTSHA256_BLOCK_SIZE;
+    }
+    else
+#endif
     if (!((uintptr_t)pbBuf & (sizeof(void *) - 1)))
     {
         /*
@@ -521,8 +752,7 @@ RTDECL(void) RTSha256Update(PRTSHA256CONTEXT pCtx, const void *pvBuf, size_t cbB
         while (cbBuf >= RTSHA256_BLOCK_SIZE)
         {
             memcpy((uint8_t *)&pCtx->AltPrivate.auW[0], pbBuf, RTSHA256_BLOCK_SIZE);
-            rtSha256BlockInitBuffered(pCtx);
-            rtSha256BlockProcess(pCtx);
+            rtSha256BlockProcessBuffered(pCtx);
 
             pCtx->AltPrivate.cbMessage += RTSHA256_BLOCK_SIZE;
             pbBuf += RTSHA256_BLOCK_SIZE;
@@ -576,8 +806,7 @@ static void rtSha256FinalInternal(PRTSHA256CONTEXT pCtx)
     /*
      * Process the last buffered block constructed/completed above.
      */
-    rtSha256BlockInitBuffered(pCtx);
-    rtSha256BlockProcess(pCtx);
+    rtSha256BlockProcessBuffered(pCtx);
 
     /*
      * Convert the byte order of the hash words and we're done.
@@ -88,6 +88,36 @@ __FBSDID("$FreeBSD: src/sys/libkern/crc32.c,v 1.2 2003/06/11 05:23:04 obrien Exp
 # include "internal/iprt.h"
 #endif
 
+/** @def RTCRC32_WITH_PCLMUL
+ * PCLMULQDQ folding, used when the CPU supports it (ring-3 only as the kernel
+ * contexts would have to save the SIMD state first). */
+/** @def RTCRC32_WITH_ARMV8_CRC
+ * The ARMv8 CRC32 instructions, used when the CPU supports them. */
+#if defined(IN_RING3) && defined(RT_ARCH_AMD64)
+# include <iprt/asm-amd64-x86.h>
+# include <iprt/x86.h>
+# include <immintrin.h>
+# define RTCRC32_WITH_PCLMUL
+# if defined(__GNUC__)
+#  define RTCRC32_TARGET_PCLMUL     __attribute__((__target__("pclmul,sse4.1")))
+# else
+#  define RTCRC32_TARGET_PCLMUL
+# endif
+#elif defined(IN_RING3) && defined(RT_ARCH_ARM64) && (defined(RT_OS_LINUX) || defined(RT_OS_DARWIN))
+# include <arm_acle.h>
+# ifdef RT_OS_LINUX
+#  include <sys/auxv.h>
+# endif
+# define RTCRC32_WITH_ARMV8_CRC
+# if defined(__clang__)
+#  define RTCRC32_TARGET_CRC        __attribute__((__target__("crc")))
+# elif defined(__GNUC__)
+#  define RTCRC32_TARGET_CRC        __attribute__((__target__("+crc")))
+# else
+#  define RTCRC32_TARGET_CRC
+# endif
+#endif
+
 #if 0
 uint32_t crc32_tab[] = {
 #else
@@ -160,13 +190,195 @@ crc32(const void *buf, size_t size)
 
 
 
-RTDECL(uint32_t) RTCrc32(const void *pv, size_t cb)
+#if defined(RTCRC32_WITH_PCLMUL) || defined(RTCRC32_WITH_ARMV8_CRC)
+/** Whether the host CPU has the instructions for the accelerated code path,
+ * -1 if not determined yet. */
+static int volatile g_iCrc32HwSupported = -1;
+
+
+/**
+ * Checks whether the host CPU supports the accelerated code path.
+ *
+ * @returns true if supported, false if not.
+ */
+DECLINLINE(bool) rtCrc32IsHwSupported(void)
 {
-    const uint8_t  *pu8 = (const uint8_t *)pv;
-    uint32_t        uCRC32 = ~0U;
+    int iSupported = g_iCrc32HwSupported;
+    if (RT_LIKELY(iSupported >= 0))
+        return iSupported != 0;
+
+# ifdef RTCRC32_WITH_PCLMUL
+    uint32_t const fEcx = ASMCpuId_ECX(1);
+    iSupported =    (fEcx & X86_CPUID_FEATURE_ECX_PCLMUL)
+                 && (fEcx & X86_CPUID_FEATURE_ECX_SSE4_1);
+# elif defined(RT_OS_LINUX)
+    iSupported = RT_BOOL(getauxval(AT_HWCAP) & RT_BIT_64(7) /*HWCAP_CRC32*/);
+# else
+    iSupported = 1; /* Mandatory on all Apple ARM CPUs. */
+# endif
+    g_iCrc32HwSupported = iSupported;
+    return iSupported != 0;
+}
+#endif
+
+
+#ifdef RTCRC32_WITH_PCLMUL
+/**
+ * Folds the CRC of the given buffer using carry-less multiplication, see
+ * Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+ * Instruction".
+ *
+ * @returns Updated CRC32 value.
+ * @param   uCRC32      The current CRC32 value.
+ * @param   pb          The data.
+ * @param   cb          Number of bytes, at least 64 and a multiple of 16.
+ */
+static RTCRC32_TARGET_PCLMUL uint32_t rtCrc32ProcessPclmul(uint32_t uCRC32, uint8_t const *pb, size_t cb)
+{
+    /* x^(4*128+32) mod P, x^(4*128-32) mod P, x^(128+32) mod P, x^(128-32) mod P, x^64 mod P, P and mu (bit reflected). */
+    __m128i const uK1K2 = _mm_set_epi64x(INT64_C(0x01c6e41596), INT64_C(0x0154442bd4));
+    __m128i const uK3K4 = _mm_set_epi64x(INT64_C(0x00ccaa009e), INT64_C(0x01751997d0));
+    __m128i const uK5K0 = _mm_set_epi64x(INT64_C(0),            INT64_C(0x0163cd6124));
+    __m128i const uPoly = _mm_set_epi64x(INT64_C(0x01f7011641), INT64_C(0x01db710641));
+    Assert(cb >= 64 && !(cb & 15));
+
+    __m128i uX1 = _mm_loadu_si128((__m128i const *)(pb + 0x00));
+    __m128i uX2 = _mm_loadu_si128((__m128i const *)(pb + 0x10));
+    __m128i uX3 = _mm_loadu_si128((__m128i const *)(pb + 0x20));
+    __m128i uX4 = _mm_loadu_si128((__m128i const *)(pb + 0x30));
+    uX1 = _mm_xor_si128(uX1, _mm_cvtsi32_si128((int)uCRC32));
+    pb += 64;
+    cb -= 64;
+
+    /* Fold four 128-bit lanes in parallel. */
+    while (cb >= 64)
+    {
+        __m128i const uX5 = _mm_clmulepi64_si128(uX1, uK1K2, 0x00);
+        __m128i const uX6 = _mm_clmulepi64_si128(uX2, uK1K2, 0x00);
+        __m128i const uX7 = _mm_clmulepi64_si128(uX3, uK1K2, 0x00);
+        __m128i const uX8 = _mm_clmulepi64_si128(uX4, uK1K2, 0x00);
+
+        uX1 = _mm_clmulepi64_si128(uX1, uK1K2, 0x11);
+        uX2 = _mm_clmulepi64_si128(uX2, uK1K2, 0x11);
+        uX3 = _mm_clmulepi64_si128(uX3, uK1K2, 0x11);
+        uX4 = _mm_clmulepi64_si128(uX4, uK1K2, 0x11);
+
+        uX1 = _mm_xor_si128(_mm_xor_si128(uX1, uX5), _mm_loadu_si128((__m128i const *)(pb + 0x00)));
+        uX2 = _mm_xor_si128(_mm_xor_si128(uX2, uX6), _mm_loadu_si128((__m128i const *)(pb + 0x10)));
+        uX3 = _mm_xor_si128(_mm_xor_si128(uX3, uX7), _mm_loadu_si128((__m128i const *)(pb + 0x20)));
+        uX4 = _mm_xor_si128(_mm_xor_si128(uX4, uX8), _mm_loadu_si128((__m128i const *)(pb + 0x30)));
+
+        pb += 64;
+        cb -= 64;
+    }
+
+    /* Fold the four lanes into one. */
+    __m128i uX5 = _mm_clmulepi64_si128(uX1, uK3K4, 0x00);
+    uX1 = _mm_clmulepi64_si128(uX1, uK3K4, 0x11);
+    uX1 = _mm_xor_si128(_mm_xor_si128(uX1, uX2), uX5);
+
+    uX5 = _mm_clmulepi64_si128(uX1, uK3K4, 0x00);
+    uX1 = _mm_clmulepi64_si128(uX1, uK3K4, 0x11);
+    uX1 = _mm_xor_si128(_mm_xor_si128(uX1, uX3), uX5);
+
+    uX5 = _mm_clmulepi64_si128(uX1, uK3K4, 0x00);
+    uX1 = _mm_clmulepi64_si128(uX1, uK3K4, 0x11);
+    uX1 = _mm_xor_si128(_mm_xor_si128(uX1, uX4), uX5);
+
+    /* Remaining 16 byte blocks. */
+    while (cb >= 16)
+    {
+        uX5 = _mm_clmulepi64_si128(uX1, uK3K4, 0x00);
+        uX1 = _mm_clmulepi64_si128(uX1, uK3K4, 0x11);
+        uX1 = _mm_xor_si128(_mm_xor_si128(uX1, _mm_loadu_si128((__m128i const *)pb)), uX5);
+        pb += 16;
+        cb -= 16;
+    }
+
+    /* Fold 128 bits down to 64. */
+    __m128i const uMask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    uX2 = _mm_clmulepi64_si128(uX1, uK3K4, 0x10);
+    uX1 = _mm_xor_si128(_mm_srli_si128(uX1, 8), uX2);
+
+    uX2 = _mm_srli_si128(uX1, 4);
+    uX1 = _mm_and_si128(uX1, uMask32);
+    uX1 = _mm_clmulepi64_si128(uX1, uK5K0, 0x00);
+    uX1 = _mm_xor_si128(uX1, uX2);
+
+    /* Barrett reduction to 32 bits. */
+    uX2 = _mm_and_si128(uX1, uMask32);
+    uX2 = _mm_clmulepi64_si128(uX2, uPoly, 0x10);
+    uX2 = _mm_and_si128(uX2, uMask32);
+    uX2 = _mm_clmulepi64_si128(uX2, uPoly, 0x00);
+    uX1 = _mm_xor_si128(uX1, uX2);
+
+    return (uint32_t)_mm_extract_epi32(uX1, 1);
+}
+#endif /* RTCRC32_WITH_PCLMUL */
+
+
+#ifdef RTCRC32_WITH_ARMV8_CRC
+/**
+ * Processes the given buffer using the ARMv8 CRC32 instructions.
+ *
+ * @returns Updated CRC32 value.
+ * @param   uCRC32      The current CRC32 value.
+ * @param   pb          The data.
+ * @param   cb          Number of bytes.
+ */
+static RTCRC32_TARGET_CRC uint32_t rtCrc32ProcessArmv8(uint32_t uCRC32, uint8_t const *pb, size_t cb)
+{
+    while (cb && ((uintptr_t)pb & 7))
+    {
+        uCRC32 = __crc32b(uCRC32, *pb++);
+        cb--;
+    }
+    while (cb >= 8)
+    {
+        uCRC32 = __crc32d(uCRC32, *(uint64_t const *)pb);
+        pb += 8;
+        cb -= 8;
+    }
+    while (cb--)
+        uCRC32 = __crc32b(uCRC32, *pb++);
+    return uCRC32;
+}
+#endif /* RTCRC32_WITH_ARMV8_CRC */
+
+
+/**
+ * Processes the given buffer, picking the fastest code path for the host.
+ *
+ * @returns Updated CRC32 value.
+ * @param   uCRC32      The current CRC32 value.
+ * @param   pv          The data.
+ * @param   cb          Number of bytes.
+ */
+DECLINLINE(uint32_t) rtCrc32ProcessInternal(uint32_t uCRC32, const void *pv, size_t cb)
+{
+    const uint8_t *pu8 = (const uint8_t *)pv;
+#ifdef RTCRC32_WITH_PCLMUL
+    if (   cb >= 64
+        && rtCrc32IsHwSupported())
+    {
+        size_t const cbFold = cb & ~(size_t)15;
+        uCRC32 = rtCrc32ProcessPclmul(uCRC32, pu8, cbFold);
+        pu8 += cbFold;
+        cb  -= cbFold;
+    }
+#elif defined(RTCRC32_WITH_ARMV8_CRC)
+    if (rtCrc32IsHwSupported())
+        return rtCrc32ProcessArmv8(uCRC32, pu8, cb);
+#endif
     while (cb--)
         uCRC32 = g_au32CRC32[(uCRC32 ^ *pu8++) & 0xff] ^ (uCRC32 >> 8);
-    return uCRC32 ^ ~0U;
+    return uCRC32;
+}
+
+
+RTDECL(uint32_t) RTCrc32(const void *pv, size_t cb)
+{
+    return rtCrc32ProcessInternal(~0U, pv, cb) ^ ~0U;
 }
 RT_EXPORT_SYMBOL(RTCrc32);
 
@@ -180,10 +392,7 @@ RT_EXPORT_SYMBOL(RTCrc32Start);
 
 RTDECL(uint32_t) RTCrc32Process(uint32_t uCRC32, const void *pv, size_t cb)
 {
-    const uint8_t  *pu8 = (const uint8_t *)pv;
-    while (cb--)
-        uCRC32 = g_au32CRC32[(uCRC32 ^ *pu8++) & 0xff] ^ (uCRC32 >> 8);
-    return uCRC32;
+    return rtCrc32ProcessInternal(uCRC32, pv, cb);
 }
 RT_EXPORT_SYMBOL(RTCrc32Process);
 
@@ -37,6 +37,36 @@
 #include <iprt/crc.h>
 #include "internal/iprt.h"
 
+/** @def RTCRC32C_WITH_SSE42
+ * The SSE4.2 CRC32 instruction (which implements the Castagnoli polynomial),
+ * used when the CPU supports it. Ring-3 only. */
+/** @def RTCRC32C_WITH_ARMV8_CRC
+ * The ARMv8 CRC32C instructions, used when the CPU supports them. */
+#if defined(IN_RING3) && defined(RT_ARCH_AMD64)
+# include <iprt/asm-amd64-x86.h>
+# include <iprt/x86.h>
+# include <nmmintrin.h>
+# define RTCRC32C_WITH_SSE42
+# if defined(__GNUC__)
+#  define RTCRC32C_TARGET_SSE42     __attribute__((__target__("sse4.2")))
+# else
+#  define RTCRC32C_TARGET_SSE42
+# endif
+#elif defined(IN_RING3) && defined(RT_ARCH_ARM64) && (defined(RT_OS_LINUX) || defined(RT_OS_DARWIN))
+# include <arm_acle.h>
+# ifdef RT_OS_LINUX
+#  include <sys/auxv.h>
+# endif
+# define RTCRC32C_WITH_ARMV8_CRC
+# if defined(__clang__)
+#  define RTCRC32C_TARGET_CRC       __attribute__((__target__("crc")))
+# elif defined(__GNUC__)
+#  define RTCRC32C_TARGET_CRC       __attribute__((__target__("+crc")))
+# else
+#  define RTCRC32C_TARGET_CRC
+# endif
+#endif
+
 /**
  * Generated using the pycrc tool using model crc-32c.
  */
@@ -100,6 +130,118 @@ DECLINLINE(uint32_t) rtCrc32CProcessWithTable(const uint32_t *pau32Crc32,
 }
 
 
+#if defined(RTCRC32C_WITH_SSE42) || defined(RTCRC32C_WITH_ARMV8_CRC)
+/** Whether the host CPU has the CRC32C instructions, -1 if not determined yet. */
+static int volatile g_iCrc32CHwSupported = -1;
+
+
+/**
+ * Checks whether the host CPU has the CRC32C instructions.
+ *
+ * @returns true if supported, false if not.
+ */
+DECLINLINE(bool) rtCrc32CIsHwSupported(void)
+{
+    int iSupported = g_iCrc32CHwSupported;
+    if (RT_LIKELY(iSupported >= 0))
+        return iSupported != 0;
+
+# ifdef RTCRC32C_WITH_SSE42
+    iSupported = RT_BOOL(ASMCpuId_ECX(1) & X86_CPUID_FEATURE_ECX_SSE4_2);
+# elif defined(RT_OS_LINUX)
+    iSupported = RT_BOOL(getauxval(AT_HWCAP) & RT_BIT_64(7) /*HWCAP_CRC32*/);
+# else
+    iSupported = 1; /* Mandatory on all Apple ARM CPUs. */
+# endif
+    g_iCrc32CHwSupported = iSupported;
+    return iSupported != 0;
+}
+#endif
+
+
+#ifdef RTCRC32C_WITH_SSE42
+/**
+ * Processes the given buffer using the SSE4.2 CRC32 instruction.
+ *
+ * @returns Updated CRC32C value.
+ * @param   uCrc32      The current CRC32C value.
+ * @param   pb          The data.
+ * @param   cb          Number of bytes.
+ */
+static RTCRC32C_TARGET_SSE42 uint32_t rtCrc32CProcessSse42(uint32_t uCrc32, uint8_t const *pb, size_t cb)
+{
+    while (cb && ((uintptr_t)pb & 7))
+    {
+        uCrc32 = _mm_crc32_u8(uCrc32, *pb++);
+        cb--;
+    }
+
+    uint64_t uCrc64 = uCrc32;
+    while (cb >= 8)
+    {
+        uCrc64 = _mm_crc32_u64(uCrc64, *(uint64_t const *)pb);
+        pb += 8;
+        cb -= 8;
+    }
+    uCrc32 = (uint32_t)uCrc64;
+
+    while (cb--)
+        uCrc32 = _mm_crc32_u8(uCrc32, *pb++);
+    return uCrc32;
+}
+#endif /* RTCRC32C_WITH_SSE42 */
+
+
+#ifdef RTCRC32C_WITH_ARMV8_CRC
+/**
+ * Processes the given buffer using the ARMv8 CRC32C instructions.
+ *
+ * @returns Updated CRC32C value.
+ * @param   uCrc32      The current CRC32C value.
+ * @param   pb          The data.
+ * @param   cb          Number of bytes.
+ */
+static RTCRC32C_TARGET_CRC uint32_t rtCrc32CProcessArmv8(uint32_t uCrc32, uint8_t const *pb, size_t cb)
+{
+    while (cb && ((uintptr_t)pb & 7))
+    {
+        uCrc32 = __crc32cb(uCrc32, *pb++);
+        cb--;
+    }
+    while (cb >= 8)
+    {
+        uCrc32 = __crc32cd(uCrc32, *(uint64_t const *)pb);
+        pb += 8;
+        cb -= 8;
+    }
+    while (cb--)
+        uCrc32 = __crc32cb(uCrc32, *pb++);
+    return uCrc32;
+}
+#endif /* RTCRC32C_WITH_ARMV8_CRC */
+
+
+/**
+ * Processes the given buffer, picking the fastest code path for the host.
+ *
+ * @returns Updated CRC32C value.
+ * @param   uCrc32      The current CRC32C value.
+ * @param   pv          The data.
+ * @param   cb          Number of bytes.
+ */
+DECLINLINE(uint32_t) rtCrc32CProcessInternal(uint32_t uCrc32, const void *pv, size_t cb)
+{
+#ifdef RTCRC32C_WITH_SSE42
+    if (rtCrc32CIsHwSupported())
+        return rtCrc32CProcessSse42(uCrc32, (uint8_t const *)pv, cb);
+#elif defined(RTCRC32C_WITH_ARMV8_CRC)
+    if (rtCrc32CIsHwSupported())
+        return rtCrc32CProcessArmv8(uCrc32, (uint8_t const *)pv, cb);
+#endif
+    return rtCrc32CProcessWithTable(g_au32Crc32C, uCrc32, pv, cb);
+}
+
+
 RTDECL(uint32_t) RTCrc32CStart(void)
 {
     return ~0U;
@@ -118,7 +260,7 @@ RTDECL(uint32_t) RTCrc32C(const void *pv, size_t cb)
 {
     uint32_t uCrc32C = RTCrc32CStart();
 
-    uCrc32C = rtCrc32CProcessWithTable(g_au32Crc32C, uCrc32C, pv, cb);
+    uCrc32C = rtCrc32CProcessInternal(uCrc32C, pv, cb);
     return RTCrc32CFinish(uCrc32C);
 }
 RT_EXPORT_SYMBOL(RTCrc32C);
@@ -126,7 +268,7 @@ RT_EXPORT_SYMBOL(RTCrc32C);
 
 RTDECL(uint32_t) RTCrc32CProcess(uint32_t uCrc32C, const void *pv, size_t cb)
 {
-    return rtCrc32CProcessWithTable(g_au32Crc32C, uCrc32C, pv, cb);;
+    return rtCrc32CProcessInternal(uCrc32C, pv, cb);
 }
 RT_EXPORT_SYMBOL(RTCrc32CProcess);
 
@@ -330,6 +330,10 @@ RT_DECL_DATA_CONST(RTIOQUEUEPROVVTABLE const) g_RTIoQueueAioFileProv =
     rtIoQueueAioFileProv_HandleRegister,
     /** pfnHandleDeregister */
     rtIoQueueAioFileProv_HandleDeregister,
+    /** pfnBufferRegister */
+    NULL,
+    /** pfnBufferDeregister */
+    NULL,
     /** pfnReqPrepare */
     rtIoQueueAioFileProv_ReqPrepare,
     /** pfnReqPrepareSg */
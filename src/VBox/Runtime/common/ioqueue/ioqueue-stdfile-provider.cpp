@@ -532,6 +532,10 @@ RT_DECL_DATA_CONST(RTIOQUEUEPROVVTABLE const) g_RTIoQueueStdFileProv =
     rtIoQueueStdFileProv_HandleRegister,
     /** pfnHandleDeregister */
     rtIoQueueStdFileProv_HandleDeregister,
+    /** pfnBufferRegister */
+    NULL,
+    /** pfnBufferDeregister */
+    NULL,
     /** pfnReqPrepare */
     rtIoQueueStdFileProv_ReqPrepare,
     /** pfnReqPrepareSg */
@@ -97,6 +97,7 @@ static PCRTIOQUEUEPROVVTABLE g_apIoQueueProviders[] =
 {
 #if defined(RT_OS_LINUX)
     &g_RTIoQueueLnxIoURingProv,
+    &g_RTIoQueueLnxIoURingSocketProv,
 #endif
 #ifndef RT_OS_OS2
     &g_RTIoQueueAioFileProv,
@@ -143,7 +144,7 @@ RTDECL(int) RTIoQueueCreate(PRTIOQUEUE phIoQueue, PCRTIOQUEUEPROVVTABLE pProvVTa
 {
     AssertPtrReturn(phIoQueue, VERR_INVALID_POINTER);
     AssertPtrReturn(pProvVTable, VERR_INVALID_POINTER);
-    AssertReturn(!fFlags, VERR_INVALID_PARAMETER);
+    AssertReturn(!(fFlags & ~RTIOQUEUE_F_VALID_MASK), VERR_INVALID_PARAMETER);
     AssertReturn(cSqEntries > 0, VERR_INVALID_PARAMETER);
     AssertReturn(cCqEntries > 0, VERR_INVALID_PARAMETER);
 
@@ -206,6 +207,35 @@ RTDECL(int) RTIoQueueHandleDeregister(RTIOQUEUE hIoQueue, PCRTHANDLE pHandle)
 }
 
 
+RTDECL(int) RTIoQueueBufferRegister(RTIOQUEUE hIoQueue, void *pvBuf, size_t cbBuf)
+{
+    PRTIOQUEUEINT pThis = hIoQueue;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertPtrReturn(pvBuf, VERR_INVALID_POINTER);
+    AssertReturn(cbBuf > 0, VERR_INVALID_PARAMETER);
+    AssertReturn(   ASMAtomicReadU32(&pThis->cReqsCommitted) == 0
+                 && ASMAtomicReadU32(&pThis->cReqsPrepared) == 0, VERR_IOQUEUE_BUSY);
+
+    if (!pThis->pVTbl->pfnBufferRegister)
+        return VINF_SUCCESS;
+    return pThis->pVTbl->pfnBufferRegister(pThis->hIoQueueProv, pvBuf, cbBuf);
+}
+
+
+RTDECL(int) RTIoQueueBufferDeregister(RTIOQUEUE hIoQueue, void *pvBuf)
+{
+    PRTIOQUEUEINT pThis = hIoQueue;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertPtrReturn(pvBuf, VERR_INVALID_POINTER);
+    AssertReturn(   ASMAtomicReadU32(&pThis->cReqsCommitted) == 0
+                 && ASMAtomicReadU32(&pThis->cReqsPrepared) == 0, VERR_IOQUEUE_BUSY);
+
+    if (!pThis->pVTbl->pfnBufferDeregister)
+        return VINF_SUCCESS;
+    return pThis->pVTbl->pfnBufferDeregister(pThis->hIoQueueProv, pvBuf);
+}
+
+
 RTDECL(int) RTIoQueueRequestPrepare(RTIOQUEUE hIoQueue, PCRTHANDLE pHandle, RTIOQUEUEOP enmOp,
                                     uint64_t off, void *pvBuf, size_t cbBuf, uint32_t fReqFlags,
                                     void *pvUser)
@@ -132,12 +132,16 @@ typedef struct RTJSONTOKEN
         {
             /** Pointer to the start of the string. */
             char            *pszStr;
+            /** Length of the decoded string. */
+            size_t          cchStr;
         } String;
         /** Json5 identifier. */
         struct
         {
             /** Pointer to the start of the object key. */
             char            *pszKey;
+            /** Length of the decoded object key. */
+            size_t          cchKey;
         } ObjectKey;
         /** Number. */
         struct
@@ -197,6 +201,13 @@ typedef struct RTJSONTOKENIZER
     PRTERRINFO              pErrInfo;
     /** Flags passed when the tokenizer was created (combination of RTJSON_PARSE_F_XXX). */
     uint32_t                fFlags;
+    /** Flag whether strings and object keys are decoded into pszStrBuf instead of
+     * being allocated individually (the event parser doesn't keep them). */
+    bool                    fReuseStrBuf;
+    /** The reusable string decoding buffer, NULL if not allocated yet. */
+    char                   *pszStrBuf;
+    /** Size of the string decoding buffer. */
+    size_t                  cbStrBuf;
 } RTJSONTOKENIZER;
 /** Pointer to a JSON tokenizer. */
 typedef RTJSONTOKENIZER *PRTJSONTOKENIZER;
@@ -282,11 +293,28 @@ typedef struct RTJSONREADERARGS
 /** Pointer to a readers argument. */
 typedef RTJSONREADERARGS *PRTJSONREADERARGS;
 
+/**
+ * State of the event parser (RTJsonParseEventsFromXxx).
+ */
+typedef struct RTJSONEVTPARSER
+{
+    /** The tokenizer. */
+    PRTJSONTOKENIZER        pTokenizer;
+    /** The event callback. */
+    PFNRTJSONEVENT          pfnEvent;
+    /** User argument for the event callback. */
+    void                   *pvUser;
+} RTJSONEVTPARSER;
+/** Pointer to the event parser state. */
+typedef RTJSONEVTPARSER *PRTJSONEVTPARSER;
+
 
 /*********************************************************************************************************************************
 *   Internal Functions                                                                                                           *
 *********************************************************************************************************************************/
 static int rtJsonParseValue(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pToken, PRTJSONVALINT *ppJsonVal);
+static int rtJsonParseEvtArray(PRTJSONEVTPARSER pThis, uint32_t cDepth);
+static int rtJsonParseEvtObject(PRTJSONEVTPARSER pThis, uint32_t cDepth);
 
 
 /**
@@ -770,6 +798,68 @@ static int rtJsonTokenizerGetNumber(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pT
     return rc;
 }
 
+/**
+ * Returns a buffer for decoding a string or object key into.
+ *
+ * @returns Pointer to the buffer, NULL if out of memory.
+ * @param   pTokenizer    The tokenizer state.
+ * @param   pcchStrMax    Where to return the size of the buffer.
+ */
+static char *rtJsonTokenizerStrBufAlloc(PRTJSONTOKENIZER pTokenizer, size_t *pcchStrMax)
+{
+    if (!pTokenizer->fReuseStrBuf)
+    {
+        *pcchStrMax = 64;
+        return RTStrAlloc(64);
+    }
+
+    if (!pTokenizer->pszStrBuf)
+    {
+        pTokenizer->pszStrBuf = RTStrAlloc(256);
+        if (!pTokenizer->pszStrBuf)
+            return NULL;
+        pTokenizer->cbStrBuf = 256;
+    }
+    *pcchStrMax = pTokenizer->cbStrBuf;
+    return pTokenizer->pszStrBuf;
+}
+
+/**
+ * Enlarges a buffer returned by rtJsonTokenizerStrBufAlloc().
+ *
+ * @returns IPRT status code, the buffer is left unchanged on failure.
+ * @param   pTokenizer    The tokenizer state.
+ * @param   ppszDecoded   Pointer to the buffer pointer, updated on success.
+ * @param   pcchStrMax    Pointer to the buffer size, updated on success.
+ */
+static int rtJsonTokenizerStrBufGrow(PRTJSONTOKENIZER pTokenizer, char **ppszDecoded, size_t *pcchStrMax)
+{
+    size_t const cchStrMaxNew = *pcchStrMax < _4K ? *pcchStrMax * 2 : *pcchStrMax + _4K;
+    int rc = RTStrRealloc(ppszDecoded, cchStrMaxNew);
+    if (RT_SUCCESS(rc))
+    {
+        *pcchStrMax = cchStrMaxNew;
+        if (pTokenizer->fReuseStrBuf)
+        {
+            pTokenizer->pszStrBuf = *ppszDecoded;
+            pTokenizer->cbStrBuf  = cchStrMaxNew;
+        }
+    }
+    return rc;
+}
+
+/**
+ * Frees a buffer returned by rtJsonTokenizerStrBufAlloc() on failure.
+ *
+ * @param   pTokenizer    The tokenizer state.
+ * @param   pszDecoded    The buffer.
+ */
+DECLINLINE(void) rtJsonTokenizerStrBufFree(PRTJSONTOKENIZER pTokenizer, char *pszDecoded)
+{
+    if (!pTokenizer->fReuseStrBuf)
+        RTStrFree(pszDecoded);
+}
+
 /**
  * Parses a string constant.
  *
@@ -779,8 +869,8 @@ static int rtJsonTokenizerGetNumber(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pT
  */
 static int rtJsonTokenizerGetString(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pToken)
 {
-    size_t cchStrMax = 64;
-    char *pszDecoded = (char *)RTStrAlloc(cchStrMax);
+    size_t cchStrMax = 0;
+    char *pszDecoded = rtJsonTokenizerStrBufAlloc(pTokenizer, &cchStrMax);
     AssertReturn(pszDecoded, VERR_NO_STR_MEMORY);
 
     char const chEnd = rtJsonTokenizerGetCh(pTokenizer);
@@ -938,7 +1028,7 @@ static int rtJsonTokenizerGetString(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pT
                             }
                         }
                     }
-                    RTStrFree(pszDecoded);
+                    rtJsonTokenizerStrBufFree(pTokenizer, pszDecoded);
                     if (rc == VERR_JSON_INVALID_UTF16_ESCAPE_SEQUENCE)
                         rc = RTErrInfoSetF(pTokenizer->pErrInfo, rc, "Invalid \\u escape sequence (line %zu col %zu)",
                                            pTokenizer->Pos.iLine, pTokenizer->Pos.iChStart);
@@ -952,7 +1042,7 @@ static int rtJsonTokenizerGetString(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pT
                 }
 
                 default:
-                    RTStrFree(pszDecoded);
+                    rtJsonTokenizerStrBufFree(pTokenizer, pszDecoded);
                     return RTErrInfoSetF(pTokenizer->pErrInfo, VERR_JSON_MALFORMED, "bad escape sequence (line %zu col %zu)",
                                          pTokenizer->Pos.iLine, pTokenizer->Pos.iChStart);
             }
@@ -964,13 +1054,10 @@ static int rtJsonTokenizerGetString(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pT
         else
         {
             /* Increase string space. */
-            size_t cchStrMaxNew =  cchStrMax < _4K ? cchStrMax * 2 : cchStrMax + _4K;
-            int rc = RTStrRealloc(&pszDecoded, cchStrMaxNew);
-            if (RT_SUCCESS(rc))
-                cchStrMax = cchStrMaxNew;
-            else
+            int rc = rtJsonTokenizerStrBufGrow(pTokenizer, &pszDecoded, &cchStrMax);
+            if (RT_FAILURE(rc))
             {
-                RTStrFree(pszDecoded);
+                rtJsonTokenizerStrBufFree(pTokenizer, pszDecoded);
                 return rc;
             }
         }
@@ -982,9 +1069,11 @@ static int rtJsonTokenizerGetString(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pT
 
     Assert(cchStr < cchStrMax);
     pszDecoded[cchStr] = '\0';
-    if (cchStrMax - cchStr >= cchStrMax / 2)
+    if (   !pTokenizer->fReuseStrBuf
+        && cchStrMax - cchStr >= cchStrMax / 2)
         RTStrRealloc(&pszDecoded, cchStr + 1);
     pToken->Class.String.pszStr = pszDecoded;
+    pToken->Class.String.cchStr = cchStr;
 
     pToken->Pos.iChEnd = pTokenizer->Pos.iChEnd;
     return VINF_SUCCESS;
@@ -1000,8 +1089,8 @@ static int rtJsonTokenizerGetString(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pT
  */
 static int rtJsonTokenizerGetJson5ObjectKey(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN pToken)
 {
-    size_t cchStrMax = 64;
-    char *pszDecoded = (char *)RTStrAlloc(cchStrMax);
+    size_t cchStrMax = 0;
+    char *pszDecoded = rtJsonTokenizerStrBufAlloc(pTokenizer, &cchStrMax);
     AssertReturn(pszDecoded, VERR_NO_STR_MEMORY);
 
     pToken->enmClass = RTJSONTOKENCLASS_OBJECT_KEY;
@@ -1123,7 +1212,7 @@ static int rtJsonTokenizerGetJson5ObjectKey(PRTJSONTOKENIZER pTokenizer, PRTJSON
                             }
                         }
                     }
-                    RTStrFree(pszDecoded);
+                    rtJsonTokenizerStrBufFree(pTokenizer, pszDecoded);
                     if (rc == VERR_JSON_INVALID_UTF16_ESCAPE_SEQUENCE)
                         rc = RTErrInfoSetF(pTokenizer->pErrInfo, rc, "Invalid \\u escape sequence (line %zu col %zu)",
                                            pTokenizer->Pos.iLine, pTokenizer->Pos.iChStart);
@@ -1137,7 +1226,7 @@ static int rtJsonTokenizerGetJson5ObjectKey(PRTJSONTOKENIZER pTokenizer, PRTJSON
                 }
 
                 default:
-                    RTStrFree(pszDecoded);
+                    rtJsonTokenizerStrBufFree(pTokenizer, pszDecoded);
                     return RTErrInfoSetF(pTokenizer->pErrInfo, VERR_JSON_MALFORMED, "bad escape sequence (line %zu col %zu)",
                                          pTokenizer->Pos.iLine, pTokenizer->Pos.iChStart);
             }
@@ -1149,13 +1238,10 @@ static int rtJsonTokenizerGetJson5ObjectKey(PRTJSONTOKENIZER pTokenizer, PRTJSON
         else
         {
             /* Increase string space. */
-            size_t cchStrMaxNew =  cchStrMax < _4K ? cchStrMax * 2 : cchStrMax + _4K;
-            int rc = RTStrRealloc(&pszDecoded, cchStrMaxNew);
-            if (RT_SUCCESS(rc))
-                cchStrMax = cchStrMaxNew;
-            else
+            int rc = rtJsonTokenizerStrBufGrow(pTokenizer, &pszDecoded, &cchStrMax);
+            if (RT_FAILURE(rc))
             {
-                RTStrFree(pszDecoded);
+                rtJsonTokenizerStrBufFree(pTokenizer, pszDecoded);
                 return rc;
             }
         }
@@ -1164,9 +1250,11 @@ static int rtJsonTokenizerGetJson5ObjectKey(PRTJSONTOKENIZER pTokenizer, PRTJSON
 
     Assert(cchStr < cchStrMax);
     pszDecoded[cchStr] = '\0';
-    if (cchStrMax - cchStr >= cchStrMax / 2)
+    if (   !pTokenizer->fReuseStrBuf
+        && cchStrMax - cchStr >= cchStrMax / 2)
         RTStrRealloc(&pszDecoded, cchStr + 1);
     pToken->Class.ObjectKey.pszKey = pszDecoded;
+    pToken->Class.ObjectKey.cchKey = cchStr;
 
     pToken->Pos.iChEnd = pTokenizer->Pos.iChEnd;
     return VINF_SUCCESS;
@@ -1208,6 +1296,7 @@ static int rtJsonTokenizerGetObjectKey(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKEN
         {
             pToken->enmClass = RTJSONTOKENCLASS_OBJECT_KEY;
             pToken->Class.ObjectKey.pszKey = pToken->Class.String.pszStr;
+            pToken->Class.ObjectKey.cchKey = pToken->Class.String.cchStr;
         }
     }
     else if (   pTokenizer->fFlags & RTJSON_PARSE_F_JSON5
@@ -1313,10 +1402,12 @@ static int rtJsonTokenizerReadNextToken(PRTJSONTOKENIZER pTokenizer, PRTJSONTOKE
  * @param   fFlags          Combination of RTJSON_PARSE_F_XXX.
  * @param   pfnRead         Read callback for the input stream.
  * @param   pvUser          Opaque user data to pass to the callback.
+ * @param   fReuseStrBuf    Flag whether to decode strings into a single reused
+ *                          buffer instead of allocating each of them.
  * @param   pErrInfo        Where to return extended error info.
  */
 static int rtJsonTokenizerInit(PRTJSONTOKENIZER pTokenizer, uint32_t fFlags, PFNRTJSONTOKENIZERREAD pfnRead, void *pvUser,
-                               PRTERRINFO pErrInfo)
+                               bool fReuseStrBuf, PRTERRINFO pErrInfo)
 {
     pTokenizer->pfnRead      = pfnRead;
     pTokenizer->pvUser       = pvUser;
@@ -1330,6 +1421,9 @@ static int rtJsonTokenizerInit(PRTJSONTOKENIZER pTokenizer, uint32_t fFlags, PFN
     pTokenizer->rcTok        = VINF_SUCCESS;
     pTokenizer->pErrInfo     = pErrInfo;
     pTokenizer->fFlags       = fFlags;
+    pTokenizer->fReuseStrBuf = fReuseStrBuf;
+    pTokenizer->pszStrBuf    = NULL;
+    pTokenizer->cbStrBuf     = 0;
 
     RT_ZERO(pTokenizer->achBuf);
 
@@ -1362,7 +1456,12 @@ static void rtJsonTokenizerTokenCleanup(PRTJSONTOKEN pToken)
  */
 static void rtJsonTokenizerDestroy(PRTJSONTOKENIZER pTokenizer)
 {
-    if (pTokenizer->pTokenCurr)
+    if (pTokenizer->fReuseStrBuf)
+    {
+        RTStrFree(pTokenizer->pszStrBuf);
+        pTokenizer->pszStrBuf = NULL;
+    }
+    else if (pTokenizer->pTokenCurr)
         rtJsonTokenizerTokenCleanup(pTokenizer->pTokenCurr);
 }
 
@@ -1785,36 +1884,229 @@ static int rtJsonParse(PRTJSONTOKENIZER pTokenizer, PRTJSONVALINT *ppJsonVal)
 }
 
 /**
- * Read callback for RTJsonParseFromBuf().
+ * Parses a single JSON value reporting it through the event callback.
+ *
+ * @returns IPRT status code, VINF_SUCCESS if parsing should continue.
+ * @param   pThis           The event parser state.
+ * @param   pToken          The token to parse.
+ * @param   cDepth          The nesting depth of the value.
  */
-static DECLCALLBACK(int) rtJsonTokenizerParseFromBuf(void *pvUser, size_t offInput,
-                                                     void *pvBuf, size_t cbBuf,
-                                                     size_t *pcbRead)
+static int rtJsonParseEvtValue(PRTJSONEVTPARSER pThis, PRTJSONTOKEN pToken, uint32_t cDepth)
 {
-    PRTJSONREADERARGS pArgs = (PRTJSONREADERARGS)pvUser;
-    size_t cbLeft = offInput < pArgs->cbData ? pArgs->cbData - offInput : 0;
+    PRTJSONTOKENIZER pTokenizer = pThis->pTokenizer;
+    RTJSONEVTDATA    Data;
+    int              rc;
 
-    if (cbLeft)
-        memcpy(pvBuf, &pArgs->u.pbBuf[offInput], RT_MIN(cbLeft, cbBuf));
+    Data.cDepth = cDepth;
+    switch (pToken->enmClass)
+    {
+        case RTJSONTOKENCLASS_BEGIN_ARRAY:
+            rtJsonTokenizerConsume(pTokenizer);
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_BEGIN_ARRAY, &Data);
+            if (rc == VINF_SUCCESS)
+                rc = rtJsonParseEvtArray(pThis, cDepth);
+            break;
+        case RTJSONTOKENCLASS_BEGIN_OBJECT:
+            rtJsonTokenizerConsume(pTokenizer);
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_BEGIN_OBJECT, &Data);
+            if (rc == VINF_SUCCESS)
+                rc = rtJsonParseEvtObject(pThis, cDepth);
+            break;
+        case RTJSONTOKENCLASS_STRING:
+            Data.u.Str.psz = pToken->Class.String.pszStr;
+            Data.u.Str.cch = pToken->Class.String.cchStr;
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_STRING, &Data);
+            rtJsonTokenizerConsume(pTokenizer);
+            break;
+        case RTJSONTOKENCLASS_INTEGER:
+            Data.u.i64Num = pToken->Class.Integer.i64Num;
+            rtJsonTokenizerConsume(pTokenizer);
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_INTEGER, &Data);
+            break;
+        case RTJSONTOKENCLASS_NUMBER:
+            Data.u.rdNum = pToken->Class.rdNum;
+            rtJsonTokenizerConsume(pTokenizer);
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_NUMBER, &Data);
+            break;
+        case RTJSONTOKENCLASS_NULL:
+            rtJsonTokenizerConsume(pTokenizer);
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_NULL, &Data);
+            break;
+        case RTJSONTOKENCLASS_FALSE:
+            rtJsonTokenizerConsume(pTokenizer);
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_FALSE, &Data);
+            break;
+        case RTJSONTOKENCLASS_TRUE:
+            rtJsonTokenizerConsume(pTokenizer);
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_TRUE, &Data);
+            break;
+        default:
+        {
+            /* Everything else is an error, let the tree parser produce the error message (it doesn't allocate anything for these). */
+            PRTJSONVALINT pVal = NULL;
+            rc = rtJsonParseValue(pTokenizer, pToken, &pVal);
+            AssertStmt(RT_FAILURE(rc), rc = VERR_JSON_MALFORMED; RTJsonValueRelease(pVal));
+            break;
+        }
+    }
 
-    *pcbRead = RT_MIN(cbLeft, cbBuf);
+    return rc;
+}
 
-    return VINF_SUCCESS;
+/**
+ * Parses a JSON array reporting the items through the event callback.
+ *
+ * @returns IPRT status code, VINF_SUCCESS if parsing should continue.
+ * @param   pThis           The event parser state.
+ * @param   cDepth          The nesting depth of the array.
+ */
+static int rtJsonParseEvtArray(PRTJSONEVTPARSER pThis, uint32_t cDepth)
+{
+    PRTJSONTOKENIZER pTokenizer = pThis->pTokenizer;
+    PRTJSONTOKEN pToken = NULL;
+
+    int rc = rtJsonTokenizerGetToken(pTokenizer, false /*fObjectKey*/, &pToken);
+    while (   rc == VINF_SUCCESS
+           && pToken->enmClass != RTJSONTOKENCLASS_END_ARRAY
+           && pToken->enmClass != RTJSONTOKENCLASS_EOS)
+    {
+        rc = rtJsonParseEvtValue(pThis, pToken, cDepth + 1);
+        if (rc != VINF_SUCCESS)
+            break;
+
+        /* Skip value separator and continue with next token. */
+        bool fSkippedSep = rtJsonTokenizerConsumeIfMatched(pTokenizer, RTJSONTOKENCLASS_VALUE_SEPARATOR);
+        rc = rtJsonTokenizerGetToken(pTokenizer, false /*fObjectKey*/, &pToken);
+
+        if (   RT_SUCCESS(rc)
+            && !fSkippedSep
+            && pToken->enmClass != RTJSONTOKENCLASS_END_ARRAY)
+            rc = RTErrInfoSetF(pTokenizer->pErrInfo, VERR_JSON_MALFORMED, "expected end of array (#1) (line %zu col %zu)",
+                               pTokenizer->Pos.iLine, pTokenizer->Pos.iChStart);
+    }
+
+    if (rc == VINF_SUCCESS)
+    {
+        if (pToken->enmClass == RTJSONTOKENCLASS_END_ARRAY)
+        {
+            rtJsonTokenizerConsume(pTokenizer);
+
+            RTJSONEVTDATA Data;
+            Data.cDepth = cDepth;
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_END_ARRAY, &Data);
+        }
+        else
+            rc = RTErrInfoSetF(pTokenizer->pErrInfo, VERR_JSON_MALFORMED, "expected end of array (#2) (line %zu col %zu)",
+                               pTokenizer->Pos.iLine, pTokenizer->Pos.iChStart);
+    }
+
+    return rc;
+}
+
+/**
+ * Parses a JSON object reporting the members through the event callback.
+ *
+ * @returns IPRT status code, VINF_SUCCESS if parsing should continue.
+ * @param   pThis           The event parser state.
+ * @param   cDepth          The nesting depth of the object.
+ */
+static int rtJsonParseEvtObject(PRTJSONEVTPARSER pThis, uint32_t cDepth)
+{
+    PRTJSONTOKENIZER pTokenizer = pThis->pTokenizer;
+    PRTJSONTOKEN pToken = NULL;
+    RTJSONEVTDATA Data;
+    Data.cDepth = cDepth + 1;
+
+    int rc = rtJsonTokenizerGetToken(pTokenizer, true /*fObjectKey*/, &pToken);
+    while (   rc == VINF_SUCCESS
+           && pToken->enmClass == RTJSONTOKENCLASS_OBJECT_KEY)
+    {
+        /* The key lives in the tokenizer string buffer, so report it before reading the next token. */
+        Data.u.Str.psz = pToken->Class.ObjectKey.pszKey;
+        Data.u.Str.cch = pToken->Class.ObjectKey.cchKey;
+        rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_KEY, &Data);
+        rtJsonTokenizerConsume(pTokenizer);
+        if (rc != VINF_SUCCESS)
+            break;
+
+        if (!rtJsonTokenizerConsumeIfMatched(pTokenizer, RTJSONTOKENCLASS_NAME_SEPARATOR))
+        {
+            rc = RTErrInfoSetF(pTokenizer->pErrInfo, VERR_JSON_MALFORMED, "expected name separator (line %zu col %zu)",
+                               pTokenizer->Pos.iLine, pTokenizer->Pos.iChStart);
+            break;
+        }
+
+        rc = rtJsonTokenizerGetToken(pTokenizer, false /*fObjectKey*/, &pToken);
+        if (rc == VINF_SUCCESS)
+            rc = rtJsonParseEvtValue(pThis, pToken, cDepth + 1);
+        if (rc != VINF_SUCCESS)
+            break;
+
+        /* Skip value separator and continue with next token. */
+        bool fSkippedSep = rtJsonTokenizerConsumeIfMatched(pTokenizer, RTJSONTOKENCLASS_VALUE_SEPARATOR);
+        rc = rtJsonTokenizerGetToken(pTokenizer, true /*fObjectKey*/, &pToken);
+
+        if (   RT_SUCCESS(rc)
+            && !fSkippedSep
+            && pToken->enmClass != RTJSONTOKENCLASS_END_OBJECT)
+            rc = RTErrInfoSetF(pTokenizer->pErrInfo, VERR_JSON_MALFORMED, "expected end of object (#1) (line %zu col %zu)",
+                               pTokenizer->Pos.iLine, pTokenizer->Pos.iChStart);
+    }
+
+    if (rc == VINF_SUCCESS)
+    {
+        if (pToken->enmClass == RTJSONTOKENCLASS_END_OBJECT)
+        {
+            rtJsonTokenizerConsume(pTokenizer);
+
+            Data.cDepth = cDepth;
+            rc = pThis->pfnEvent(pThis->pvUser, RTJSONEVT_END_OBJECT, &Data);
+        }
+        else
+            rc = RTErrInfoSetF(pTokenizer->pErrInfo, VERR_JSON_MALFORMED, "expected end of object (#2) (line %zu col %zu)",
+                               pTokenizer->Pos.iLine, pTokenizer->Pos.iChStart);
+    }
+
+    return rc;
+}
+
+/**
+ * Entry point to parse a JSON document reporting events.
+ *
+ * @returns IPRT status code.
+ * @param   pTokenizer      The tokenizer state, initialized with fReuseStrBuf set.
+ * @param   pfnEvent        The event callback.
+ * @param   pvUser          User argument for the callback.
+ */
+static int rtJsonParseEvents(PRTJSONTOKENIZER pTokenizer, PFNRTJSONEVENT pfnEvent, void *pvUser)
+{
+    Assert(pTokenizer->fReuseStrBuf);
+
+    RTJSONEVTPARSER This;
+    This.pTokenizer = pTokenizer;
+    This.pfnEvent   = pfnEvent;
+    This.pvUser     = pvUser;
+
+    PRTJSONTOKEN pToken = NULL;
+    int rc = rtJsonTokenizerGetToken(pTokenizer, false /*fObjectKey*/, &pToken);
+    if (RT_SUCCESS(rc))
+        rc = rtJsonParseEvtValue(&This, pToken, 0 /*cDepth*/);
+
+    return rc;
 }
 
 /**
- * Read callback for RTJsonParseFromString().
+ * Read callback for RTJsonParseFromBuf() and RTJsonParseFromString().
  */
-static DECLCALLBACK(int) rtJsonTokenizerParseFromString(void *pvUser, size_t offInput,
-                                                        void *pvBuf, size_t cbBuf,
-                                                        size_t *pcbRead)
+static DECLCALLBACK(int) rtJsonTokenizerParseFromBuf(void *pvUser, size_t offInput,
+                                                     void *pvBuf, size_t cbBuf,
+                                                     size_t *pcbRead)
 {
-    const char *pszStr = (const char *)pvUser;
-    size_t cchStr = strlen(pszStr) + 1; /* Include zero terminator. */
-    size_t cbLeft = offInput < cchStr ? cchStr - offInput : 0;
+    PRTJSONREADERARGS pArgs = (PRTJSONREADERARGS)pvUser;
+    size_t cbLeft = offInput < pArgs->cbData ? pArgs->cbData - offInput : 0;
 
     if (cbLeft)
-        memcpy(pvBuf, &pszStr[offInput], RT_MIN(cbLeft, cbBuf));
+        memcpy(pvBuf, &pArgs->u.pbBuf[offInput], RT_MIN(cbLeft, cbBuf));
 
     *pcbRead = RT_MIN(cbLeft, cbBuf);
 
@@ -1871,7 +2163,7 @@ RTDECL(int) RTJsonParseFromBuf(PRTJSONVAL phJsonVal, uint32_t fFlags, const uint
     Args.cbData  = cbBuf;
     Args.u.pbBuf = pbBuf;
 
-    int rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromBuf, &Args, pErrInfo);
+    int rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromBuf, &Args, false /*fReuseStrBuf*/, pErrInfo);
     if (RT_SUCCESS(rc))
     {
         rc = rtJsonParse(&Tokenizer, phJsonVal);
@@ -1887,12 +2179,12 @@ RTDECL(int) RTJsonParseFromString(PRTJSONVAL phJsonVal, uint32_t fFlags, const c
     AssertReturn(!(fFlags & ~RTJSON_PARSE_F_VALID), VERR_INVALID_PARAMETER);
     AssertPtrReturn(pszStr, VERR_INVALID_POINTER);
 
-    /** @todo r=bird: The rtJsonTokenizerParseFromString function does
-     *        strlen() on the whole pszStr for each read.  For larger strings (
-     *        longer than sizeof(Tokenizer.achBuf)) it would be good to join
-     *        forces with RTJsonParseFromBuf. */
     RTJSONTOKENIZER Tokenizer;
-    int rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromString, (void *)pszStr, pErrInfo);
+    RTJSONREADERARGS Args;
+    Args.cbData  = strlen(pszStr) + 1; /* Include zero terminator. */
+    Args.u.pbBuf = (const uint8_t *)pszStr;
+
+    int rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromBuf, &Args, false /*fReuseStrBuf*/, pErrInfo);
     if (RT_SUCCESS(rc))
     {
         rc = rtJsonParse(&Tokenizer, phJsonVal);
@@ -1917,7 +2209,7 @@ RTDECL(int) RTJsonParseFromFile(PRTJSONVAL phJsonVal, uint32_t fFlags, const cha
     {
         RTJSONTOKENIZER Tokenizer;
 
-        rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromFile, &Args, pErrInfo);
+        rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromFile, &Args, false /*fReuseStrBuf*/, pErrInfo);
         if (RT_SUCCESS(rc))
         {
             rc = rtJsonParse(&Tokenizer, phJsonVal);
@@ -1941,7 +2233,7 @@ RTDECL(int) RTJsonParseFromVfsFile(PRTJSONVAL phJsonVal, uint32_t fFlags, RTVFSF
 
     Args.cbData   = 0;
     Args.u.hVfsFile = hVfsFile;
-    rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromVfsFile, &Args, pErrInfo);
+    rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromVfsFile, &Args, false /*fReuseStrBuf*/, pErrInfo);
     if (RT_SUCCESS(rc))
     {
         rc = rtJsonParse(&Tokenizer, phJsonVal);
@@ -1951,6 +2243,54 @@ RTDECL(int) RTJsonParseFromVfsFile(PRTJSONVAL phJsonVal, uint32_t fFlags, RTVFSF
     return rc;
 }
 
+RTDECL(int) RTJsonParseEventsFromBuf(uint32_t fFlags, const uint8_t *pbBuf, size_t cbBuf,
+                                     PFNRTJSONEVENT pfnEvent, void *pvUser, PRTERRINFO pErrInfo)
+{
+    AssertReturn(!(fFlags & ~RTJSON_PARSE_F_VALID), VERR_INVALID_PARAMETER);
+    AssertPtrReturn(pbBuf, VERR_INVALID_POINTER);
+    AssertReturn(cbBuf > 0, VERR_INVALID_PARAMETER);
+    AssertPtrReturn(pfnEvent, VERR_INVALID_POINTER);
+
+    RTJSONTOKENIZER Tokenizer;
+    RTJSONREADERARGS Args;
+    Args.cbData  = cbBuf;
+    Args.u.pbBuf = pbBuf;
+
+    int rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromBuf, &Args, true /*fReuseStrBuf*/, pErrInfo);
+    if (RT_SUCCESS(rc))
+        rc = rtJsonParseEvents(&Tokenizer, pfnEvent, pvUser);
+    rtJsonTokenizerDestroy(&Tokenizer);
+
+    return rc;
+}
+
+RTDECL(int) RTJsonParseEventsFromString(uint32_t fFlags, const char *pszStr,
+                                        PFNRTJSONEVENT pfnEvent, void *pvUser, PRTERRINFO pErrInfo)
+{
+    AssertPtrReturn(pszStr, VERR_INVALID_POINTER);
+    return RTJsonParseEventsFromBuf(fFlags, (const uint8_t *)pszStr, strlen(pszStr) + 1, pfnEvent, pvUser, pErrInfo);
+}
+
+RTDECL(int) RTJsonParseEventsFromVfsFile(uint32_t fFlags, RTVFSFILE hVfsFile,
+                                         PFNRTJSONEVENT pfnEvent, void *pvUser, PRTERRINFO pErrInfo)
+{
+    AssertReturn(!(fFlags & ~RTJSON_PARSE_F_VALID), VERR_INVALID_PARAMETER);
+    AssertReturn(hVfsFile != NIL_RTVFSFILE, VERR_INVALID_POINTER);
+    AssertPtrReturn(pfnEvent, VERR_INVALID_POINTER);
+
+    RTJSONTOKENIZER Tokenizer;
+    RTJSONREADERARGS Args;
+    Args.cbData     = 0;
+    Args.u.hVfsFile = hVfsFile;
+
+    int rc = rtJsonTokenizerInit(&Tokenizer, fFlags, rtJsonTokenizerParseFromVfsFile, &Args, true /*fReuseStrBuf*/, pErrInfo);
+    if (RT_SUCCESS(rc))
+        rc = rtJsonParseEvents(&Tokenizer, pfnEvent, pvUser);
+    rtJsonTokenizerDestroy(&Tokenizer);
+
+    return rc;
+}
+
 RTDECL(uint32_t) RTJsonValueRetain(RTJSONVAL hJsonVal)
 {
     PRTJSONVALINT pThis = hJsonVal;
@@ -43,11 +43,15 @@
 
 #include <iprt/assert.h>
 #include <iprt/asm.h>
+#include <iprt/cpuset.h>
 #include <iprt/critsect.h>
 #include <iprt/err.h>
 #include <iprt/list.h>
 #include <iprt/log.h>
 #include <iprt/mem.h>
+#include <iprt/mp.h>
+#include <iprt/once.h>
+#include <iprt/spinlock.h>
 #include <iprt/string.h>
 #include <iprt/time.h>
 #include <iprt/semaphore.h>
@@ -66,6 +70,10 @@
 #define RTREQPOOL_PUSH_BACK_MAX_MS      RT_MS_1MIN
 /** The max number of free requests to keep around. */
 #define RTREQPOOL_MAX_FREE_REQUESTS     (RTREQPOOL_MAX_THREADS * 2U)
+/** The size of the per worker request deque (work stealing mode). */
+#define RTREQPOOL_DEQUE_SIZE            64
+/** The max number of CPU affinity groups. */
+#define RTREQPOOL_MAX_AFFINITY_GROUPS   64
 
 
 /*********************************************************************************************************************************
@@ -107,6 +115,27 @@ typedef struct RTREQPOOLTHREAD
     /** Pointer to the request thread pool instance the thread is associated
      *  with. */
     struct RTREQPOOLINT    *pPool;
+
+    /** @name Work stealing (RTREQPOOLCFGVAR_WORK_STEALING).
+     * Requests submitted by the worker thread itself go into its own deque.  The
+     * owner takes the newest entry, thieves (holding the pool critical section)
+     * take the oldest one.
+     * @{ */
+    /** Spinlock protecting the deque. */
+    RTSPINLOCK              hDequeLock;
+    /** Index of the oldest request in apDeque. */
+    uint32_t                iDequeHead;
+    /** Number of requests in apDeque.  Read without the lock as a hint. */
+    uint32_t volatile       cDequeReqs;
+    /** The affinity group, UINT32_MAX if none. */
+    uint32_t                iAffinityGroup;
+    /** Number of requests this thread submitted to its own deque. */
+    uint64_t                cReqSubmittedLocal;
+    /** The CPUs of the affinity group. */
+    RTCPUSET                AffinitySet;
+    /** The request deque (ring buffer). */
+    PRTREQINT               apDeque[RTREQPOOL_DEQUE_SIZE];
+    /** @} */
 } RTREQPOOLTHREAD;
 /** Pointer to a worker thread. */
 typedef RTREQPOOLTHREAD *PRTREQPOOLTHREAD;
@@ -149,6 +178,14 @@ typedef struct RTREQPOOLINT
     uint32_t                cMsMinPushBack;
     /** The max number of free requests in the recycle LIFO. */
     uint32_t                cMaxFreeRequests;
+    /** Whether requests submitted by worker threads go to their own deque. */
+    bool volatile           fWorkStealing;
+    /** Set once work stealing has been enabled, so idle threads keep looking
+     * in the deques after it has been disabled again. */
+    bool                    fDequesActive;
+    /** The number of CPU affinity groups to spread new worker threads over,
+     * zero if no affinity is set. */
+    uint32_t                cAffinityGroups;
     /** @}  */
 
     /** Signaled by terminating worker threads. */
@@ -198,6 +235,11 @@ typedef struct RTREQPOOLINT
     uint64_t                cReqSubmitted;
     /** The number of cancelled. */
     uint64_t                cReqCancelled;
+    /** The number of requests taken from the deque of another worker. */
+    uint64_t                cReqStolen;
+    /** The number of requests submitted to a worker deque by threads that have
+     * since terminated. */
+    uint64_t                cReqSubmittedLocal;
 
     /** Head of the request recycling LIFO. */
     PRTREQINT               pFreeRequests;
@@ -211,6 +253,26 @@ typedef struct RTREQPOOLINT
 } RTREQPOOLINT;
 
 
+/*********************************************************************************************************************************
+*   Global Variables                                                                                                             *
+*********************************************************************************************************************************/
+/** TLS slot pointing to the RTREQPOOLTHREAD of the calling worker thread, used
+ * for locality in work stealing mode.  Allocated on first use. */
+static RTTLS    g_iReqPoolWorkerTls     = NIL_RTTLS;
+/** Serializes the g_iReqPoolWorkerTls allocation. */
+static RTONCE   g_ReqPoolWorkerTlsOnce  = RTONCE_INITIALIZER;
+
+
+/**
+ * @callback_method_impl{FNRTONCE, Allocates g_iReqPoolWorkerTls.}
+ */
+static DECLCALLBACK(int32_t) rtReqPoolInitWorkerTls(void *pvUser)
+{
+    RT_NOREF(pvUser);
+    return RTTlsAllocEx(&g_iReqPoolWorkerTls, NULL);
+}
+
+
 /**
  * Used by exiting thread and the pool destruction code to cancel unexpected
  * requests.
@@ -254,6 +316,141 @@ static void rtReqPoolRecalcPushBack(PRTREQPOOLINT pPool)
 }
 
 
+/**
+ * Calculates the CPU set of an affinity group.
+ *
+ * The online CPUs are split into @a cGroups contiguous ranges of roughly the
+ * same size.
+ *
+ * @param   iGroup              The group.
+ * @param   cGroups             The number of groups.
+ * @param   pSet                Where to return the set.  Empty if there are
+ *                              more groups than online CPUs.
+ */
+static void rtReqPoolCalcAffinitySet(uint32_t iGroup, uint32_t cGroups, PRTCPUSET pSet)
+{
+    RTCPUSET OnlineSet;
+    RTMpGetOnlineSet(&OnlineSet);
+    uint32_t const cOnline = (uint32_t)RTCpuSetCount(&OnlineSet);
+
+    RTCpuSetEmpty(pSet);
+    uint32_t iOnline = 0;
+    for (int iCpu = 0; iCpu < RTCPUSET_MAX_CPUS; iCpu++)
+        if (RTCpuSetIsMemberByIndex(&OnlineSet, iCpu))
+        {
+            if (iOnline * cGroups / cOnline == iGroup)
+                RTCpuSetAddByIndex(pSet, iCpu);
+            iOnline++;
+        }
+}
+
+
+/**
+ * Takes the most recently queued request from the deque of the calling worker.
+ *
+ * @returns The request, NULL if the deque is empty.
+ * @param   pThread             The calling worker thread.
+ */
+static PRTREQINT rtReqPoolDequePopOwn(PRTREQPOOLTHREAD pThread)
+{
+    PRTREQINT pReq = NULL;
+    if (ASMAtomicUoReadU32(&pThread->cDequeReqs) > 0)
+    {
+        RTSpinlockAcquire(pThread->hDequeLock);
+        uint32_t const cReqs = pThread->cDequeReqs;
+        if (cReqs > 0)
+        {
+            pReq = pThread->apDeque[(pThread->iDequeHead + cReqs - 1) % RTREQPOOL_DEQUE_SIZE];
+            ASMAtomicWriteU32(&pThread->cDequeReqs, cReqs - 1);
+        }
+        RTSpinlockRelease(pThread->hDequeLock);
+    }
+    return pReq;
+}
+
+
+/**
+ * Takes the oldest request from the deque of a worker.
+ *
+ * @returns The request, NULL if the deque is empty.
+ * @param   pVictim             The worker thread to steal from.
+ */
+static PRTREQINT rtReqPoolDequeTakeOldest(PRTREQPOOLTHREAD pVictim)
+{
+    PRTREQINT pReq = NULL;
+    RTSpinlockAcquire(pVictim->hDequeLock);
+    uint32_t const cReqs = pVictim->cDequeReqs;
+    if (cReqs > 0)
+    {
+        pReq = pVictim->apDeque[pVictim->iDequeHead];
+        pVictim->iDequeHead = (pVictim->iDequeHead + 1) % RTREQPOOL_DEQUE_SIZE;
+        ASMAtomicWriteU32(&pVictim->cDequeReqs, cReqs - 1);
+    }
+    RTSpinlockRelease(pVictim->hDequeLock);
+    return pReq;
+}
+
+
+/**
+ * Steals a request from the deque of another worker, preferring workers in the
+ * same affinity group.
+ *
+ * @returns The request, NULL if nothing to steal.
+ * @param   pPool               The pool.
+ * @param   pThief              The calling worker thread.
+ * @remarks Caller owns the critical section.
+ */
+static PRTREQINT rtReqPoolDequeSteal(PRTREQPOOLINT pPool, PRTREQPOOLTHREAD pThief)
+{
+    for (unsigned iPass = 0; iPass < 2; iPass++)
+    {
+        PRTREQPOOLTHREAD pVictim;
+        RTListForEach(&pPool->WorkerThreads, pVictim, RTREQPOOLTHREAD, ListNode)
+        {
+            if (   pVictim != pThief
+                && ASMAtomicUoReadU32(&pVictim->cDequeReqs) > 0
+                && (pVictim->iAffinityGroup == pThief->iAffinityGroup) == (iPass == 0))
+            {
+                PRTREQINT pReq = rtReqPoolDequeTakeOldest(pVictim);
+                if (pReq)
+                {
+                    pPool->cReqStolen++;
+                    return pReq;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * Removes a specific request from the deque of a worker.
+ *
+ * @returns true if found and removed, false if not.
+ * @param   pThread             The worker thread.
+ * @param   pReq                The request.
+ */
+static bool rtReqPoolDequeRemove(PRTREQPOOLTHREAD pThread, PRTREQINT pReq)
+{
+    bool fFound = false;
+    RTSpinlockAcquire(pThread->hDequeLock);
+    uint32_t const cReqs = pThread->cDequeReqs;
+    for (uint32_t i = 0; i < cReqs; i++)
+        if (pThread->apDeque[(pThread->iDequeHead + i) % RTREQPOOL_DEQUE_SIZE] == pReq)
+        {
+            for (; i + 1 < cReqs; i++)
+                pThread->apDeque[(pThread->iDequeHead + i) % RTREQPOOL_DEQUE_SIZE]
+                    = pThread->apDeque[(pThread->iDequeHead + i + 1) % RTREQPOOL_DEQUE_SIZE];
+            ASMAtomicWriteU32(&pThread->cDequeReqs, cReqs - 1);
+            fFound = true;
+            break;
+        }
+    RTSpinlockRelease(pThread->hDequeLock);
+    return fFound;
+}
+
+
 
 /**
  * Performs thread exit.
@@ -292,6 +489,12 @@ static int rtReqPoolThreadExit(PRTREQPOOLINT pPool, PRTREQPOOLTHREAD pThread, bo
         rtReqPoolCancelReq(pReq);
     }
 
+    /* Nobody can steal from us any more, so cancel whatever is left in the
+       deque (only happens when the pool is being destroyed). */
+    while ((pReq = rtReqPoolDequeTakeOldest(pThread)) != NULL)
+        rtReqPoolCancelReq(pReq);
+    pPool->cReqSubmittedLocal += pThread->cReqSubmittedLocal;
+
     /* If we're the last thread terminating, ping the destruction thread before
        we leave the critical section. */
     if (   RTListIsEmpty(&pPool->WorkerThreads)
@@ -300,6 +503,9 @@ static int rtReqPoolThreadExit(PRTREQPOOLINT pPool, PRTREQPOOLTHREAD pThread, bo
 
     RTCritSectLeave(&pPool->CritSect);
 
+    if (g_iReqPoolWorkerTls != NIL_RTTLS)
+        RTTlsSet(g_iReqPoolWorkerTls, NULL);
+    RTSpinlockDestroy(pThread->hDequeLock);
     RTMemFree(pThread);
     return VINF_SUCCESS;
 }
@@ -354,9 +560,21 @@ static DECLCALLBACK(int) rtReqPoolThreadProc(RTTHREAD hThreadSelf, void *pvArg)
     PRTREQPOOLTHREAD    pThread = (PRTREQPOOLTHREAD)pvArg;
     PRTREQPOOLINT       pPool   = pThread->pPool;
 
+    /*
+     * Move into our affinity group, if any.  Not all hosts support this.
+     */
+    if (   pThread->iAffinityGroup != UINT32_MAX
+        && RTCpuSetCount(&pThread->AffinitySet) > 0)
+    {
+        int rc = RTThreadSetAffinity(&pThread->AffinitySet);
+        LogFlow(("rtReqPoolThreadProc: RTThreadSetAffinity(group %u) -> %Rrc\n", pThread->iAffinityGroup, rc));
+        RT_NOREF(rc);
+    }
+
     /*
      * The work loop.
      */
+    bool     fTlsSet                   = false;
     uint64_t cReqPrevProcessedIdle     = UINT64_MAX;
     uint64_t cReqPrevProcessedStat     = 0;
     uint64_t cNsPrevTotalReqProcessing = 0;
@@ -367,6 +585,10 @@ static DECLCALLBACK(int) rtReqPoolThreadProc(RTTHREAD hThreadSelf, void *pvArg)
          * Process pending work.
          */
 
+        /* Work stealing: Let the submit code find us. */
+        if (!fTlsSet && pPool->fWorkStealing && g_iReqPoolWorkerTls != NIL_RTTLS)
+            fTlsSet = RT_SUCCESS(RTTlsSet(g_iReqPoolWorkerTls, pThread));
+
         /* Check if anything is scheduled directly to us. */
         PRTREQINT pReq = ASMAtomicXchgPtrT(&pThread->pTodoReq, NULL, PRTREQINT);
         if (pReq)
@@ -376,6 +598,14 @@ static DECLCALLBACK(int) rtReqPoolThreadProc(RTTHREAD hThreadSelf, void *pvArg)
             continue;
         }
 
+        /* Anything we queued ourselves in work stealing mode? */
+        pReq = rtReqPoolDequePopOwn(pThread);
+        if (pReq)
+        {
+            rtReqPoolThreadProcessRequest(pPool, pThread, pReq);
+            continue;
+        }
+
         ASMAtomicIncU32(&pPool->cIdleThreads);
         RTCritSectEnter(&pPool->CritSect);
 
@@ -426,6 +656,26 @@ static DECLCALLBACK(int) rtReqPoolThreadProc(RTTHREAD hThreadSelf, void *pvArg)
             continue;
         }
 
+        /* Anything to steal from the other workers? */
+        if (pPool->fDequesActive)
+        {
+            pReq = rtReqPoolDequeSteal(pPool, pThread);
+            if (pReq)
+            {
+                if (!RTListIsEmpty(&pThread->IdleNode))
+                {
+                    RTListNodeRemove(&pThread->IdleNode);
+                    RTListInit(&pThread->IdleNode);
+                    ASMAtomicDecU32(&pPool->cIdleThreads);
+                }
+                ASMAtomicDecU32(&pPool->cIdleThreads);
+                RTCritSectLeave(&pPool->CritSect);
+
+                rtReqPoolThreadProcessRequest(pPool, pThread, pReq);
+                continue;
+            }
+        }
+
         /*
          * Nothing to do, go idle.
          */
@@ -472,6 +722,13 @@ static void rtReqPoolCreateNewWorker(RTREQPOOL pPool)
     if (!pThread)
         return;
 
+    int rc = RTSpinlockCreate(&pThread->hDequeLock, RTSPINLOCK_FLAGS_INTERRUPT_UNSAFE, "RTReqPoolDeque");
+    if (RT_FAILURE(rc))
+    {
+        RTMemFree(pThread);
+        return;
+    }
+
     pThread->uBirthNanoTs = RTTimeNanoTS();
     pThread->pPool        = pPool;
     pThread->idLastCpu    = NIL_RTCPUID;
@@ -481,14 +738,22 @@ static void rtReqPoolCreateNewWorker(RTREQPOOL pPool)
     pPool->cCurThreads++;
     pPool->cThreadsCreated++;
 
-    int rc = RTThreadCreateF(&pThread->hThread, rtReqPoolThreadProc, pThread, 0 /*default stack size*/,
-                             pPool->enmThreadType, pPool->fThreadFlags, "%s%02u", pPool->szName, pPool->cThreadsCreated);
+    pThread->iAffinityGroup = UINT32_MAX;
+    if (pPool->cAffinityGroups)
+    {
+        pThread->iAffinityGroup = (pPool->cThreadsCreated - 1) % pPool->cAffinityGroups;
+        rtReqPoolCalcAffinitySet(pThread->iAffinityGroup, pPool->cAffinityGroups, &pThread->AffinitySet);
+    }
+
+    rc = RTThreadCreateF(&pThread->hThread, rtReqPoolThreadProc, pThread, 0 /*default stack size*/,
+                         pPool->enmThreadType, pPool->fThreadFlags, "%s%02u", pPool->szName, pPool->cThreadsCreated);
     if (RT_SUCCESS(rc))
         pPool->uLastThreadCreateNanoTs = pThread->uBirthNanoTs;
     else
     {
         pPool->cCurThreads--;
         RTListNodeRemove(&pThread->ListNode);
+        RTSpinlockDestroy(pThread->hDequeLock);
         RTMemFree(pThread);
     }
 }
@@ -544,8 +809,70 @@ static int rtReqPoolPushBack(PRTREQPOOLINT pPool, PRTREQINT pReq)
 
 
 
+/**
+ * Work stealing mode: Queues a request submitted by one of the pool's own
+ * worker threads on that thread's deque.
+ *
+ * @returns true if queued, false if the caller isn't a worker of this pool or
+ *          the deque is full.
+ * @param   pPool               The pool.
+ * @param   pReq                The request.
+ */
+static bool rtReqPoolSubmitLocal(PRTREQPOOLINT pPool, PRTREQINT pReq)
+{
+    if (g_iReqPoolWorkerTls == NIL_RTTLS)
+        return false;
+    PRTREQPOOLTHREAD pThread = (PRTREQPOOLTHREAD)RTTlsGet(g_iReqPoolWorkerTls);
+    if (!pThread || pThread->pPool != pPool)
+        return false;
+
+    RTSpinlockAcquire(pThread->hDequeLock);
+    uint32_t const cReqs = pThread->cDequeReqs;
+    if (cReqs >= RTREQPOOL_DEQUE_SIZE)
+    {
+        RTSpinlockRelease(pThread->hDequeLock);
+        return false;
+    }
+    pThread->apDeque[(pThread->iDequeHead + cReqs) % RTREQPOOL_DEQUE_SIZE] = pReq;
+    ASMAtomicWriteU32(&pThread->cDequeReqs, cReqs + 1);
+    RTSpinlockRelease(pThread->hDequeLock);
+    pThread->cReqSubmittedLocal++;
+
+    /*
+     * Make sure somebody else can pick it up in case we end up waiting on it:
+     * Kick an idle thread into stealing, or add a worker while below the limit.
+     * When every worker is busy we don't touch the pool lock at all.
+     */
+    if (   ASMAtomicUoReadU32(&pPool->cIdleThreads) > 0
+        || pPool->cCurThreads < pPool->cMaxThreads)
+    {
+        RTCritSectEnter(&pPool->CritSect);
+        PRTREQPOOLTHREAD pIdleThread = RTListGetFirst(&pPool->IdleThreads, RTREQPOOLTHREAD, IdleNode);
+        if (pIdleThread)
+        {
+            RTListNodeRemove(&pIdleThread->IdleNode);
+            RTListInit(&pIdleThread->IdleNode);
+            ASMAtomicDecU32(&pPool->cIdleThreads);
+            RTThreadUserSignal(pIdleThread->hThread);
+        }
+        else if (   pPool->cIdleThreads == 0
+                 && pPool->cCurThreads < pPool->cMaxThreads)
+            rtReqPoolCreateNewWorker(pPool);
+        RTCritSectLeave(&pPool->CritSect);
+    }
+    return true;
+}
+
+
 DECLHIDDEN(void) rtReqPoolSubmit(PRTREQPOOLINT pPool, PRTREQINT pReq)
 {
+    /*
+     * Work stealing: Requests from our own workers stay with the submitter.
+     */
+    if (   pPool->fWorkStealing
+        && rtReqPoolSubmitLocal(pPool, pReq))
+        return;
+
     RTCritSectEnter(&pPool->CritSect);
 
     pPool->cReqSubmitted++;
@@ -659,6 +986,23 @@ DECLHIDDEN(void) rtReqPoolCancel(PRTREQPOOLINT pPool, PRTREQINT pReq)
             break;
         }
 
+    /*
+     * Check the worker deques if it wasn't in the pending list.
+     */
+    if (!pCur && pPool->fDequesActive)
+    {
+        PRTREQPOOLTHREAD pThread;
+        RTListForEach(&pPool->WorkerThreads, pThread, RTREQPOOLTHREAD, ListNode)
+        {
+            if (   ASMAtomicUoReadU32(&pThread->cDequeReqs) > 0
+                && rtReqPoolDequeRemove(pThread, pReq))
+            {
+                rtReqProcessOne(pReq);
+                break;
+            }
+        }
+    }
+
     RTCritSectLeave(&pPool->CritSect);
     return;
 }
@@ -744,6 +1088,9 @@ RTDECL(int) RTReqPoolCreate(uint32_t cMaxThreads, RTMSINTERVAL cMsMinIdle,
     pPool->cMsMaxPushBack       = cMsMaxPushBack;
     pPool->cMsMinPushBack       = cMsMinPushBack;
     pPool->cMaxFreeRequests     = cMaxThreads * 2;
+    pPool->fWorkStealing        = false;
+    pPool->fDequesActive        = false;
+    pPool->cAffinityGroups      = 0;
     pPool->hThreadTermEvt       = NIL_RTSEMEVENTMULTI;
     pPool->fDestructing         = false;
     pPool->cMsCurPushBack       = 0;
@@ -763,6 +1110,8 @@ RTDECL(int) RTReqPoolCreate(uint32_t cMaxThreads, RTMSINTERVAL cMsMinIdle,
     pPool->cCurActiveRequests   = 0;
     pPool->cReqSubmitted        = 0;
     pPool->cReqCancelled        = 0;
+    pPool->cReqStolen           = 0;
+    pPool->cReqSubmittedLocal   = 0;
     pPool->pFreeRequests        = NULL;
     pPool->cCurFreeRequests     = 0;
 
@@ -923,6 +1272,23 @@ RTDECL(int) RTReqPoolSetCfgVar(RTREQPOOL hPool, RTREQPOOLCFGVAR enmVar, uint64_t
             }
             break;
 
+        case RTREQPOOLCFGVAR_WORK_STEALING:
+            AssertMsgBreakStmt(uValue <= 1, ("%llu\n",  uValue), rc = VERR_OUT_OF_RANGE);
+            if (uValue)
+            {
+                rc = RTOnce(&g_ReqPoolWorkerTlsOnce, rtReqPoolInitWorkerTls, NULL);
+                if (RT_FAILURE(rc))
+                    break;
+                pPool->fDequesActive = true;
+            }
+            ASMAtomicWriteBool(&pPool->fWorkStealing, uValue != 0);
+            break;
+
+        case RTREQPOOLCFGVAR_AFFINITY_GROUPS:
+            AssertMsgBreakStmt(uValue <= RTREQPOOL_MAX_AFFINITY_GROUPS, ("%llu\n",  uValue), rc = VERR_OUT_OF_RANGE);
+            pPool->cAffinityGroups = (uint32_t)uValue;
+            break;
+
         default:
             AssertFailed();
             rc = VERR_IPE_NOT_REACHED_DEFAULT_CASE;
@@ -998,6 +1364,14 @@ RTDECL(uint64_t) RTReqPoolGetCfgVar(RTREQPOOL hPool, RTREQPOOLCFGVAR enmVar)
             u64 = pPool->cMaxFreeRequests;
             break;
 
+        case RTREQPOOLCFGVAR_WORK_STEALING:
+            u64 = pPool->fWorkStealing;
+            break;
+
+        case RTREQPOOLCFGVAR_AFFINITY_GROUPS:
+            u64 = pPool->cAffinityGroups;
+            break;
+
         default:
             AssertFailed();
             u64 = UINT64_MAX;
@@ -1035,6 +1409,17 @@ RTDECL(uint64_t) RTReqPoolGetStat(RTREQPOOL hPool, RTREQPOOLSTAT enmStat)
         case RTREQPOOLSTAT_NS_TOTAL_REQ_QUEUED:         u64 = pPool->cNsTotalReqQueued; break;
         case RTREQPOOLSTAT_NS_AVERAGE_REQ_PROCESSING:   u64 = pPool->cNsTotalReqProcessing / RT_MAX(pPool->cReqProcessed, 1); break;
         case RTREQPOOLSTAT_NS_AVERAGE_REQ_QUEUED:       u64 = pPool->cNsTotalReqQueued / RT_MAX(pPool->cReqProcessed, 1); break;
+        case RTREQPOOLSTAT_REQUESTS_STOLEN:             u64 = pPool->cReqStolen; break;
+        case RTREQPOOLSTAT_REQUESTS_SUBMITTED_LOCAL:
+        {
+            u64 = pPool->cReqSubmittedLocal;
+            PRTREQPOOLTHREAD pThread;
+            RTListForEach(&pPool->WorkerThreads, pThread, RTREQPOOLTHREAD, ListNode)
+            {
+                u64 += pThread->cReqSubmittedLocal;
+            }
+            break;
+        }
         default:
             AssertFailed();
             u64 = UINT64_MAX;
@@ -0,0 +1,737 @@
+/* $Id$ */
+/** @file
+ * IPRT - B+Tree, uint64_t key ranges.
+ */
+
+/*
+ * Copyright (C) 2006-2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#include <iprt/btree.h>
+#include "internal/iprt.h"
+
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/string.h>
+#include "internal/magics.h"
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Maximum number of keys in a node. */
+#define RTBTREEU64_ORDER        32
+/** Minimum number of keys in a non-root node before it is rebalanced. */
+#define RTBTREEU64_MIN_KEYS     (RTBTREEU64_ORDER / 2)
+
+/** Validates a tree handle and returns @a rcRet if not valid. */
+#define RTBTREEU64_VALID_RETURN_RC(pThis, rcRet) \
+    do { \
+        AssertPtrReturn((pThis), (rcRet)); \
+        AssertReturn((pThis)->u32Magic == RTBTREEU64_MAGIC, (rcRet)); \
+    } while (0)
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/** Pointer to a B+tree node. */
+typedef struct RTBTREEU64NODE *PRTBTREEU64NODE;
+
+/**
+ * A B+tree node.
+ *
+ * Internal nodes hold separator keys, child i has keys less than auKeys[i] and
+ * child i + 1 keys greater or equal.  Leaves hold the ranges and are linked in
+ * key order.
+ */
+typedef struct RTBTREEU64NODE
+{
+    /** Number of keys in use. */
+    uint32_t                cKeys;
+    /** Set if this is a leaf. */
+    bool                    fLeaf;
+    /** The keys, range starts in leaves and separators in internal nodes.
+     * Kept apart from the payload so searching touches as few cache lines as
+     * possible. */
+    uint64_t                auKeys[RTBTREEU64_ORDER];
+    /** Node type specific data. */
+    union
+    {
+        struct
+        {
+            /** The last keys of the ranges (inclusive). */
+            uint64_t        auKeysLast[RTBTREEU64_ORDER];
+            /** The values. */
+            void           *apvValues[RTBTREEU64_ORDER];
+            /** The previous leaf in key order. */
+            PRTBTREEU64NODE pPrev;
+            /** The next leaf in key order. */
+            PRTBTREEU64NODE pNext;
+        } Leaf;
+        struct
+        {
+            /** The children, cKeys + 1 of them. */
+            PRTBTREEU64NODE apChildren[RTBTREEU64_ORDER + 1];
+        } Internal;
+    } u;
+} RTBTREEU64NODE;
+
+/**
+ * B+tree instance.
+ */
+typedef struct RTBTREEU64INT
+{
+    /** Magic value (RTBTREEU64_MAGIC). */
+    uint32_t                u32Magic;
+    /** Number of levels, 0 if empty. */
+    uint32_t                cDepth;
+    /** Number of ranges. */
+    uint32_t                cEntries;
+    /** Number of nodes on the free list. */
+    uint32_t                cFree;
+    /** The root node, NULL if empty. */
+    PRTBTREEU64NODE         pRoot;
+    /** The leftmost leaf. */
+    PRTBTREEU64NODE         pFirst;
+    /** The rightmost leaf. */
+    PRTBTREEU64NODE         pLast;
+    /** Spare nodes, linked thru u.Internal.apChildren[0].  Insertion makes sure
+     * there are enough of these up front, so splitting can't fail halfway. */
+    PRTBTREEU64NODE         pFree;
+} RTBTREEU64INT;
+/** Pointer to a B+tree instance. */
+typedef RTBTREEU64INT *PRTBTREEU64INT;
+
+
+/**
+ * Finds the first key in the node which is greater than the given one.
+ *
+ * @returns Index of the key, cKeys if none.
+ * @param   pNode           The node.
+ * @param   uKey            The key.
+ */
+static uint32_t rtBTreeU64UpperBound(PRTBTREEU64NODE pNode, uint64_t uKey)
+{
+    uint32_t iStart = 0;
+    uint32_t iEnd   = pNode->cKeys;
+    while (iStart < iEnd)
+    {
+        uint32_t const i = iStart + (iEnd - iStart) / 2;
+        if (pNode->auKeys[i] <= uKey)
+            iStart = i + 1;
+        else
+            iEnd = i;
+    }
+    return iStart;
+}
+
+
+/**
+ * Gets a node from the free list.
+ */
+DECLINLINE(PRTBTREEU64NODE) rtBTreeU64NodeAlloc(PRTBTREEU64INT pThis, bool fLeaf)
+{
+    PRTBTREEU64NODE pNode = pThis->pFree;
+    Assert(pNode);
+    pThis->pFree = pNode->u.Internal.apChildren[0];
+    pThis->cFree--;
+    pNode->cKeys = 0;
+    pNode->fLeaf = fLeaf;
+    return pNode;
+}
+
+
+/**
+ * Returns a node to the free list, or frees it if the list is long enough.
+ */
+static void rtBTreeU64NodeFree(PRTBTREEU64INT pThis, PRTBTREEU64NODE pNode)
+{
+    if (pThis->cFree <= pThis->cDepth + 1)
+    {
+        pNode->u.Internal.apChildren[0] = pThis->pFree;
+        pThis->pFree = pNode;
+        pThis->cFree++;
+    }
+    else
+        RTMemFree(pNode);
+}
+
+
+/**
+ * Makes sure the free list has enough nodes for an insertion.
+ */
+static int rtBTreeU64EnsureFree(PRTBTREEU64INT pThis)
+{
+    while (pThis->cFree < pThis->cDepth + 1)
+    {
+        PRTBTREEU64NODE pNode = (PRTBTREEU64NODE)RTMemAlloc(sizeof(*pNode));
+        if (!pNode)
+            return VERR_NO_MEMORY;
+        pNode->u.Internal.apChildren[0] = pThis->pFree;
+        pThis->pFree = pNode;
+        pThis->cFree++;
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Looks up the leaf entry with the largest first key less or equal to the
+ * given key.
+ *
+ * @returns true if found, false if all keys are larger.
+ * @param   pThis           The tree, not empty.
+ * @param   uKey            The key.
+ * @param   ppLeaf          Where to return the leaf.  If not found, the first leaf.
+ * @param   piEntry         Where to return the entry index.
+ */
+static bool rtBTreeU64LookupLE(PRTBTREEU64INT pThis, uint64_t uKey, PRTBTREEU64NODE *ppLeaf, uint32_t *piEntry)
+{
+    PRTBTREEU64NODE pNode = pThis->pRoot;
+    while (!pNode->fLeaf)
+        pNode = pNode->u.Internal.apChildren[rtBTreeU64UpperBound(pNode, uKey)];
+
+    uint32_t i = rtBTreeU64UpperBound(pNode, uKey);
+    if (i == 0)
+    {
+        /* The separator may be stale after removals, so the predecessor can be in the previous leaf. */
+        if (!pNode->u.Leaf.pPrev)
+        {
+            *ppLeaf  = pNode;
+            *piEntry = 0;
+            return false;
+        }
+        pNode = pNode->u.Leaf.pPrev;
+        i = pNode->cKeys;
+    }
+    *ppLeaf  = pNode;
+    *piEntry = i - 1;
+    return true;
+}
+
+
+/**
+ * Looks up the leaf entry following the one returned by rtBTreeU64LookupLE.
+ *
+ * @returns true if found, false if at the end.
+ */
+static bool rtBTreeU64NextEntry(bool fFound, PRTBTREEU64NODE *ppLeaf, uint32_t *piEntry)
+{
+    if (!fFound)
+        return true; /* rtBTreeU64LookupLE returned the first entry already. */
+    if (*piEntry + 1 < (*ppLeaf)->cKeys)
+    {
+        *piEntry += 1;
+        return true;
+    }
+    if (!(*ppLeaf)->u.Leaf.pNext)
+        return false;
+    *ppLeaf  = (*ppLeaf)->u.Leaf.pNext;
+    *piEntry = 0;
+    return true;
+}
+
+
+RTDECL(int) RTBTreeU64Create(PRTBTREEU64 phTree)
+{
+    AssertPtrReturn(phTree, VERR_INVALID_POINTER);
+
+    PRTBTREEU64INT pThis = (PRTBTREEU64INT)RTMemAllocZ(sizeof(*pThis));
+    if (!pThis)
+        return VERR_NO_MEMORY;
+    pThis->u32Magic = RTBTREEU64_MAGIC;
+    *phTree = pThis;
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTBTreeU64Create);
+
+
+/**
+ * Frees a subtree.
+ */
+static void rtBTreeU64DestroyNode(PRTBTREEU64NODE pNode)
+{
+    if (!pNode->fLeaf)
+        for (uint32_t i = 0; i <= pNode->cKeys; i++)
+            rtBTreeU64DestroyNode(pNode->u.Internal.apChildren[i]);
+    RTMemFree(pNode);
+}
+
+
+RTDECL(int) RTBTreeU64Destroy(RTBTREEU64 hTree, PFNRTBTREEU64CALLBACK pfnCallback, void *pvUser)
+{
+    PRTBTREEU64INT pThis = hTree;
+    if (pThis == NIL_RTBTREEU64)
+        return VINF_SUCCESS;
+    RTBTREEU64_VALID_RETURN_RC(pThis, VERR_INVALID_HANDLE);
+    AssertPtrNullReturn(pfnCallback, VERR_INVALID_POINTER);
+
+    if (pfnCallback)
+        for (PRTBTREEU64NODE pLeaf = pThis->pFirst; pLeaf; pLeaf = pLeaf->u.Leaf.pNext)
+            for (uint32_t i = 0; i < pLeaf->cKeys; i++)
+                pfnCallback(pLeaf->auKeys[i], pLeaf->u.Leaf.auKeysLast[i], pLeaf->u.Leaf.apvValues[i], pvUser);
+
+    if (pThis->pRoot)
+        rtBTreeU64DestroyNode(pThis->pRoot);
+    while (pThis->pFree)
+    {
+        PRTBTREEU64NODE pNode = pThis->pFree;
+        pThis->pFree = pNode->u.Internal.apChildren[0];
+        RTMemFree(pNode);
+    }
+
+    pThis->u32Magic = RTBTREEU64_MAGIC_DEAD;
+    RTMemFree(pThis);
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTBTreeU64Destroy);
+
+
+/**
+ * Recursive worker for RTBTreeU64Insert.
+ *
+ * @param   pThis           The tree.
+ * @param   pNode           The subtree to insert into.
+ * @param   uKey            The first key of the range.
+ * @param   uKeyLast        The last key of the range.
+ * @param   pvValue         The value.
+ * @param   puSplitKey      Where to return the separator key if @a pNode was split.
+ * @returns The new right sibling if @a pNode was split, otherwise NULL.
+ */
+static PRTBTREEU64NODE rtBTreeU64InsertWorker(PRTBTREEU64INT pThis, PRTBTREEU64NODE pNode, uint64_t uKey, uint64_t uKeyLast,
+                                              void *pvValue, uint64_t *puSplitKey)
+{
+    uint32_t i = rtBTreeU64UpperBound(pNode, uKey);
+    if (pNode->fLeaf)
+    {
+        PRTBTREEU64NODE pRight = NULL;
+        if (pNode->cKeys == RTBTREEU64_ORDER)
+        {
+            /* Split the full leaf in half and link the new one in after it. */
+            pRight = rtBTreeU64NodeAlloc(pThis, true /*fLeaf*/);
+            uint32_t const cLeft = RTBTREEU64_ORDER / 2;
+            pRight->cKeys = RTBTREEU64_ORDER - cLeft;
+            memcpy(&pRight->auKeys[0],               &pNode->auKeys[cLeft],               pRight->cKeys * sizeof(uint64_t));
+            memcpy(&pRight->u.Leaf.auKeysLast[0],    &pNode->u.Leaf.auKeysLast[cLeft],    pRight->cKeys * sizeof(uint64_t));
+            memcpy(&pRight->u.Leaf.apvValues[0],     &pNode->u.Leaf.apvValues[cLeft],     pRight->cKeys * sizeof(void *));
+            pNode->cKeys = cLeft;
+
+            pRight->u.Leaf.pPrev = pNode;
+            pRight->u.Leaf.pNext = pNode->u.Leaf.pNext;
+            if (pNode->u.Leaf.pNext)
+                pNode->u.Leaf.pNext->u.Leaf.pPrev = pRight;
+            else
+                pThis->pLast = pRight;
+            pNode->u.Leaf.pNext = pRight;
+
+            if (i > cLeft)
+            {
+                pNode = pRight;
+                i    -= cLeft;
+            }
+        }
+
+        uint32_t const cMove = pNode->cKeys - i;
+        memmove(&pNode->auKeys[i + 1],            &pNode->auKeys[i],            cMove * sizeof(uint64_t));
+        memmove(&pNode->u.Leaf.auKeysLast[i + 1], &pNode->u.Leaf.auKeysLast[i], cMove * sizeof(uint64_t));
+        memmove(&pNode->u.Leaf.apvValues[i + 1],  &pNode->u.Leaf.apvValues[i],  cMove * sizeof(void *));
+        pNode->auKeys[i]            = uKey;
+        pNode->u.Leaf.auKeysLast[i] = uKeyLast;
+        pNode->u.Leaf.apvValues[i]  = pvValue;
+        pNode->cKeys++;
+
+        if (pRight)
+            *puSplitKey = pRight->auKeys[0];
+        return pRight;
+    }
+
+    uint64_t        uChildSplitKey = 0;
+    PRTBTREEU64NODE pChildSplit    = rtBTreeU64InsertWorker(pThis, pNode->u.Internal.apChildren[i], uKey, uKeyLast,
+                                                            pvValue, &uChildSplitKey);
+    if (!pChildSplit)
+        return NULL;
+
+    /* Add the separator and new child at i, splitting this node first if it is full. */
+    PRTBTREEU64NODE pRight = NULL;
+    if (pNode->cKeys == RTBTREEU64_ORDER)
+    {
+        uint64_t        auKeys[RTBTREEU64_ORDER + 1];
+        PRTBTREEU64NODE apChildren[RTBTREEU64_ORDER + 2];
+        memcpy(&auKeys[0], &pNode->auKeys[0], i * sizeof(uint64_t));
+        auKeys[i] = uChildSplitKey;
+        memcpy(&auKeys[i + 1], &pNode->auKeys[i], (RTBTREEU64_ORDER - i) * sizeof(uint64_t));
+        memcpy(&apChildren[0], &pNode->u.Internal.apChildren[0], (i + 1) * sizeof(PRTBTREEU64NODE));
+        apChildren[i + 1] = pChildSplit;
+        memcpy(&apChildren[i + 2], &pNode->u.Internal.apChildren[i + 1], (RTBTREEU64_ORDER - i) * sizeof(PRTBTREEU64NODE));
+
+        uint32_t const cLeft = (RTBTREEU64_ORDER + 1) / 2;
+        pRight = rtBTreeU64NodeAlloc(pThis, false /*fLeaf*/);
+        pRight->cKeys = RTBTREEU64_ORDER - cLeft;
+        memcpy(&pRight->auKeys[0], &auKeys[cLeft + 1], pRight->cKeys * sizeof(uint64_t));
+        memcpy(&pRight->u.Internal.apChildren[0], &apChildren[cLeft + 1], (pRight->cKeys + 1) * sizeof(PRTBTREEU64NODE));
+        pNode->cKeys = cLeft;
+        memcpy(&pNode->auKeys[0], &auKeys[0], cLeft * sizeof(uint64_t));
+        memcpy(&pNode->u.Internal.apChildren[0], &apChildren[0], (cLeft + 1) * sizeof(PRTBTREEU64NODE));
+        *puSplitKey = auKeys[cLeft];
+    }
+    else
+    {
+        uint32_t const cMove = pNode->cKeys - i;
+        memmove(&pNode->auKeys[i + 1], &pNode->auKeys[i], cMove * sizeof(uint64_t));
+        memmove(&pNode->u.Internal.apChildren[i + 2], &pNode->u.Internal.apChildren[i + 1], cMove * sizeof(PRTBTREEU64NODE));
+        pNode->auKeys[i] = uChildSplitKey;
+        pNode->u.Internal.apChildren[i + 1] = pChildSplit;
+        pNode->cKeys++;
+    }
+    return pRight;
+}
+
+
+RTDECL(int) RTBTreeU64Insert(RTBTREEU64 hTree, uint64_t uKey, uint64_t uKeyLast, void *pvValue)
+{
+    PRTBTREEU64INT pThis = hTree;
+    RTBTREEU64_VALID_RETURN_RC(pThis, VERR_INVALID_HANDLE);
+    AssertReturn(uKey <= uKeyLast, VERR_INVALID_PARAMETER);
+
+    int rc = rtBTreeU64EnsureFree(pThis);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    if (!pThis->pRoot)
+    {
+        PRTBTREEU64NODE pLeaf = rtBTreeU64NodeAlloc(pThis, true /*fLeaf*/);
+        pLeaf->cKeys                = 1;
+        pLeaf->auKeys[0]            = uKey;
+        pLeaf->u.Leaf.auKeysLast[0] = uKeyLast;
+        pLeaf->u.Leaf.apvValues[0]  = pvValue;
+        pLeaf->u.Leaf.pPrev         = NULL;
+        pLeaf->u.Leaf.pNext         = NULL;
+        pThis->pRoot    = pLeaf;
+        pThis->pFirst   = pLeaf;
+        pThis->pLast    = pLeaf;
+        pThis->cDepth   = 1;
+        pThis->cEntries = 1;
+        return VINF_SUCCESS;
+    }
+
+    /* Check that the range doesn't overlap with its neighbours. */
+    PRTBTREEU64NODE pLeaf;
+    uint32_t        iEntry;
+    bool const fFound = rtBTreeU64LookupLE(pThis, uKey, &pLeaf, &iEntry);
+    if (fFound && pLeaf->u.Leaf.auKeysLast[iEntry] >= uKey)
+        return VERR_ALREADY_EXISTS;
+    if (   rtBTreeU64NextEntry(fFound, &pLeaf, &iEntry)
+        && pLeaf->auKeys[iEntry] <= uKeyLast)
+        return VERR_ALREADY_EXISTS;
+
+    uint64_t        uSplitKey = 0;
+    PRTBTREEU64NODE pSplit    = rtBTreeU64InsertWorker(pThis, pThis->pRoot, uKey, uKeyLast, pvValue, &uSplitKey);
+    if (pSplit)
+    {
+        PRTBTREEU64NODE pRoot = rtBTreeU64NodeAlloc(pThis, false /*fLeaf*/);
+        pRoot->cKeys                    = 1;
+        pRoot->auKeys[0]                = uSplitKey;
+        pRoot->u.Internal.apChildren[0] = pThis->pRoot;
+        pRoot->u.Internal.apChildren[1] = pSplit;
+        pThis->pRoot = pRoot;
+        pThis->cDepth++;
+    }
+    pThis->cEntries++;
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTBTreeU64Insert);
+
+
+/**
+ * Brings child @a i of @a pParent back to the minimum key count, either by
+ * borrowing from a sibling or by merging with one.
+ */
+static void rtBTreeU64Rebalance(PRTBTREEU64INT pThis, PRTBTREEU64NODE pParent, uint32_t i)
+{
+    PRTBTREEU64NODE pChild = pParent->u.Internal.apChildren[i];
+    PRTBTREEU64NODE pLeft  = i > 0              ? pParent->u.Internal.apChildren[i - 1] : NULL;
+    PRTBTREEU64NODE pRight = i < pParent->cKeys ? pParent->u.Internal.apChildren[i + 1] : NULL;
+
+    if (pLeft && pLeft->cKeys > RTBTREEU64_MIN_KEYS)
+    {
+        /* Move the last entry of the left sibling to the front of the child. */
+        uint32_t const cMove = pChild->cKeys;
+        memmove(&pChild->auKeys[1], &pChild->auKeys[0], cMove * sizeof(uint64_t));
+        if (pChild->fLeaf)
+        {
+            uint32_t const iLast = pLeft->cKeys - 1;
+            memmove(&pChild->u.Leaf.auKeysLast[1], &pChild->u.Leaf.auKeysLast[0], cMove * sizeof(uint64_t));
+            memmove(&pChild->u.Leaf.apvValues[1],  &pChild->u.Leaf.apvValues[0],  cMove * sizeof(void *));
+            pChild->auKeys[0]            = pLeft->auKeys[iLast];
+            pChild->u.Leaf.auKeysLast[0] = pLeft->u.Leaf.auKeysLast[iLast];
+            pChild->u.Leaf.apvValues[0]  = pLeft->u.Leaf.apvValues[iLast];
+            pParent->auKeys[i - 1]       = pChild->auKeys[0];
+        }
+        else
+        {
+            memmove(&pChild->u.Internal.apChildren[1], &pChild->u.Internal.apChildren[0], (cMove + 1) * sizeof(PRTBTREEU64NODE));
+            pChild->auKeys[0]                = pParent->auKeys[i - 1];
+            pChild->u.Internal.apChildren[0] = pLeft->u.Internal.apChildren[pLeft->cKeys];
+            pParent->auKeys[i - 1]           = pLeft->auKeys[pLeft->cKeys - 1];
+        }
+        pLeft->cKeys--;
+        pChild->cKeys++;
+    }
+    else if (pRight && pRight->cKeys > RTBTREEU64_MIN_KEYS)
+    {
+        /* Move the first entry of the right sibling to the end of the child. */
+        uint32_t const cMove = pRight->cKeys - 1;
+        if (pChild->fLeaf)
+        {
+            pChild->auKeys[pChild->cKeys]            = pRight->auKeys[0];
+            pChild->u.Leaf.auKeysLast[pChild->cKeys] = pRight->u.Leaf.auKeysLast[0];
+            pChild->u.Leaf.apvValues[pChild->cKeys]  = pRight->u.Leaf.apvValues[0];
+            memmove(&pRight->auKeys[0],            &pRight->auKeys[1],            cMove * sizeof(uint64_t));
+            memmove(&pRight->u.Leaf.auKeysLast[0], &pRight->u.Leaf.auKeysLast[1], cMove * sizeof(uint64_t));
+            memmove(&pRight->u.Leaf.apvValues[0],  &pRight->u.Leaf.apvValues[1],  cMove * sizeof(void *));
+            pParent->auKeys[i] = pRight->auKeys[0];
+        }
+        else
+        {
+            pChild->auKeys[pChild->cKeys]                    = pParent->auKeys[i];
+            pChild->u.Internal.apChildren[pChild->cKeys + 1] = pRight->u.Internal.apChildren[0];
+            pParent->auKeys[i] = pRight->auKeys[0];
+            memmove(&pRight->auKeys[0], &pRight->auKeys[1], cMove * sizeof(uint64_t));
+            memmove(&pRight->u.Internal.apChildren[0], &pRight->u.Internal.apChildren[1], (cMove + 1) * sizeof(PRTBTREEU64NODE));
+        }
+        pRight->cKeys--;
+        pChild->cKeys++;
+    }
+    else
+    {
+        /* Merge with a sibling, the right node of the pair goes away. */
+        uint32_t const j = pLeft ? i - 1 : i;
+        pLeft  = pParent->u.Internal.apChildren[j];
+        pRight = pParent->u.Internal.apChildren[j + 1];
+        if (pLeft->fLeaf)
+        {
+            Assert(pLeft->cKeys + pRight->cKeys <= RTBTREEU64_ORDER);
+            memcpy(&pLeft->auKeys[pLeft->cKeys],            &pRight->auKeys[0],            pRight->cKeys * sizeof(uint64_t));
+            memcpy(&pLeft->u.Leaf.auKeysLast[pLeft->cKeys], &pRight->u.Leaf.auKeysLast[0], pRight->cKeys * sizeof(uint64_t));
+            memcpy(&pLeft->u.Leaf.apvValues[pLeft->cKeys],  &pRight->u.Leaf.apvValues[0],  pRight->cKeys * sizeof(void *));
+            pLeft->cKeys += pRight->cKeys;
+            pLeft->u.Leaf.pNext = pRight->u.Leaf.pNext;
+            if (pRight->u.Leaf.pNext)
+                pRight->u.Leaf.pNext->u.Leaf.pPrev = pLeft;
+            else
+                pThis->pLast = pLeft;
+        }
+        else
+        {
+            Assert(pLeft->cKeys + 1 + pRight->cKeys <= RTBTREEU64_ORDER);
+            pLeft->auKeys[pLeft->cKeys] = pParent->auKeys[j];
+            memcpy(&pLeft->auKeys[pLeft->cKeys + 1], &pRight->auKeys[0], pRight->cKeys * sizeof(uint64_t));
+            memcpy(&pLeft->u.Internal.apChildren[pLeft->cKeys + 1], &pRight->u.Internal.apChildren[0],
+                   (pRight->cKeys + 1) * sizeof(PRTBTREEU64NODE));
+            pLeft->cKeys += 1 + pRight->cKeys;
+        }
+
+        uint32_t const cMove = pParent->cKeys - j - 1;
+        memmove(&pParent->auKeys[j], &pParent->auKeys[j + 1], cMove * sizeof(uint64_t));
+        memmove(&pParent->u.Internal.apChildren[j + 1], &pParent->u.Internal.apChildren[j + 2], cMove * sizeof(PRTBTREEU64NODE));
+        pParent->cKeys--;
+        rtBTreeU64NodeFree(pThis, pRight);
+    }
+}
+
+
+/**
+ * Recursive worker for RTBTreeU64Remove.
+ */
+static void *rtBTreeU64RemoveWorker(PRTBTREEU64INT pThis, PRTBTREEU64NODE pNode, uint64_t uKey)
+{
+    uint32_t i = rtBTreeU64UpperBound(pNode, uKey);
+    if (pNode->fLeaf)
+    {
+        if (i == 0 || pNode->auKeys[i - 1] != uKey)
+            return NULL;
+        i--;
+        void *pvValue = pNode->u.Leaf.apvValues[i];
+        uint32_t const cMove = pNode->cKeys - i - 1;
+        memmove(&pNode->auKeys[i],            &pNode->auKeys[i + 1],            cMove * sizeof(uint64_t));
+        memmove(&pNode->u.Leaf.auKeysLast[i], &pNode->u.Leaf.auKeysLast[i + 1], cMove * sizeof(uint64_t));
+        memmove(&pNode->u.Leaf.apvValues[i],  &pNode->u.Leaf.apvValues[i + 1],  cMove * sizeof(void *));
+        pNode->cKeys--;
+        return pvValue;
+    }
+
+    void *pvValue = rtBTreeU64RemoveWorker(pThis, pNode->u.Internal.apChildren[i], uKey);
+    if (pvValue && pNode->u.Internal.apChildren[i]->cKeys < RTBTREEU64_MIN_KEYS)
+        rtBTreeU64Rebalance(pThis, pNode, i);
+    return pvValue;
+}
+
+
+RTDECL(void *) RTBTreeU64Remove(RTBTREEU64 hTree, uint64_t uKey)
+{
+    PRTBTREEU64INT pThis = hTree;
+    RTBTREEU64_VALID_RETURN_RC(pThis, NULL);
+    if (!pThis->pRoot)
+        return NULL;
+
+    void *pvValue = rtBTreeU64RemoveWorker(pThis, pThis->pRoot, uKey);
+    if (pvValue)
+    {
+        pThis->cEntries--;
+        PRTBTREEU64NODE pRoot = pThis->pRoot;
+        if (pRoot->cKeys == 0)
+        {
+            if (pRoot->fLeaf)
+            {
+                pThis->pRoot  = NULL;
+                pThis->pFirst = NULL;
+                pThis->pLast  = NULL;
+            }
+            else
+                pThis->pRoot = pRoot->u.Internal.apChildren[0];
+            pThis->cDepth--;
+            rtBTreeU64NodeFree(pThis, pRoot);
+        }
+    }
+    return pvValue;
+}
+RT_EXPORT_SYMBOL(RTBTreeU64Remove);
+
+
+RTDECL(void *) RTBTreeU64Get(RTBTREEU64 hTree, uint64_t uKey)
+{
+    PRTBTREEU64INT pThis = hTree;
+    RTBTREEU64_VALID_RETURN_RC(pThis, NULL);
+    if (!pThis->pRoot)
+        return NULL;
+
+    PRTBTREEU64NODE pLeaf;
+    uint32_t        iEntry;
+    if (   rtBTreeU64LookupLE(pThis, uKey, &pLeaf, &iEntry)
+        && pLeaf->auKeys[iEntry] == uKey)
+        return pLeaf->u.Leaf.apvValues[iEntry];
+    return NULL;
+}
+RT_EXPORT_SYMBOL(RTBTreeU64Get);
+
+
+RTDECL(void *) RTBTreeU64RangeGet(RTBTREEU64 hTree, uint64_t uKey, uint64_t *puKey, uint64_t *puKeyLast)
+{
+    PRTBTREEU64INT pThis = hTree;
+    RTBTREEU64_VALID_RETURN_RC(pThis, NULL);
+    if (!pThis->pRoot)
+        return NULL;
+
+    PRTBTREEU64NODE pLeaf;
+    uint32_t        iEntry;
+    if (   rtBTreeU64LookupLE(pThis, uKey, &pLeaf, &iEntry)
+        && pLeaf->u.Leaf.auKeysLast[iEntry] >= uKey)
+    {
+        if (puKey)
+            *puKey = pLeaf->auKeys[iEntry];
+        if (puKeyLast)
+            *puKeyLast = pLeaf->u.Leaf.auKeysLast[iEntry];
+        return pLeaf->u.Leaf.apvValues[iEntry];
+    }
+    return NULL;
+}
+RT_EXPORT_SYMBOL(RTBTreeU64RangeGet);
+
+
+RTDECL(void *) RTBTreeU64GetBestFit(RTBTREEU64 hTree, uint64_t uKey, bool fAbove, uint64_t *puKey, uint64_t *puKeyLast)
+{
+    PRTBTREEU64INT pThis = hTree;
+    RTBTREEU64_VALID_RETURN_RC(pThis, NULL);
+    if (!pThis->pRoot)
+        return NULL;
+
+    PRTBTREEU64NODE pLeaf;
+    uint32_t        iEntry;
+    bool fFound = rtBTreeU64LookupLE(pThis, uKey, &pLeaf, &iEntry);
+    if (   fAbove
+        && (!fFound || pLeaf->auKeys[iEntry] != uKey))
+        fFound = rtBTreeU64NextEntry(fFound, &pLeaf, &iEntry);
+    if (!fFound)
+        return NULL;
+
+    if (puKey)
+        *puKey = pLeaf->auKeys[iEntry];
+    if (puKeyLast)
+        *puKeyLast = pLeaf->u.Leaf.auKeysLast[iEntry];
+    return pLeaf->u.Leaf.apvValues[iEntry];
+}
+RT_EXPORT_SYMBOL(RTBTreeU64GetBestFit);
+
+
+RTDECL(int) RTBTreeU64DoWithAll(RTBTREEU64 hTree, bool fFromLeft, PFNRTBTREEU64CALLBACK pfnCallback, void *pvUser)
+{
+    PRTBTREEU64INT pThis = hTree;
+    RTBTREEU64_VALID_RETURN_RC(pThis, VERR_INVALID_HANDLE);
+    AssertPtrReturn(pfnCallback, VERR_INVALID_POINTER);
+
+    if (fFromLeft)
+    {
+        for (PRTBTREEU64NODE pLeaf = pThis->pFirst; pLeaf; pLeaf = pLeaf->u.Leaf.pNext)
+            for (uint32_t i = 0; i < pLeaf->cKeys; i++)
+            {
+                int rc = pfnCallback(pLeaf->auKeys[i], pLeaf->u.Leaf.auKeysLast[i], pLeaf->u.Leaf.apvValues[i], pvUser);
+                if (rc != VINF_SUCCESS)
+                    return rc;
+            }
+    }
+    else
+    {
+        for (PRTBTREEU64NODE pLeaf = pThis->pLast; pLeaf; pLeaf = pLeaf->u.Leaf.pPrev)
+            for (uint32_t i = pLeaf->cKeys; i-- > 0;)
+            {
+                int rc = pfnCallback(pLeaf->auKeys[i], pLeaf->u.Leaf.auKeysLast[i], pLeaf->u.Leaf.apvValues[i], pvUser);
+                if (rc != VINF_SUCCESS)
+                    return rc;
+            }
+    }
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTBTreeU64DoWithAll);
+
+
+RTDECL(uint32_t) RTBTreeU64GetCount(RTBTREEU64 hTree)
+{
+    PRTBTREEU64INT pThis = hTree;
+    RTBTREEU64_VALID_RETURN_RC(pThis, 0);
+    return pThis->cEntries;
+}
+RT_EXPORT_SYMBOL(RTBTreeU64GetCount);
+
@@ -0,0 +1,378 @@
+/* $Id$ */
+/** @file
+ * IPRT - Radix Tree.
+ */
+
+/*
+ * Copyright (C) 2006-2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#include <iprt/radixtree.h>
+#include "internal/iprt.h"
+
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include <iprt/mem.h>
+#include "internal/magics.h"
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Number of index bits resolved by each level. */
+#define RTRADIXTREE_LEVEL_SHIFT     6
+/** Number of slots in a node. */
+#define RTRADIXTREE_SLOTS           RT_BIT_32(RTRADIXTREE_LEVEL_SHIFT)
+/** Mask for the slot index within a level. */
+#define RTRADIXTREE_SLOT_MASK       (RTRADIXTREE_SLOTS - 1)
+/** Number of levels needed for the full 64-bit index space. */
+#define RTRADIXTREE_MAX_LEVELS      ((64 + RTRADIXTREE_LEVEL_SHIFT - 1) / RTRADIXTREE_LEVEL_SHIFT)
+
+/** Validates a tree handle and returns @a rcRet if not valid. */
+#define RTRADIXTREE_VALID_RETURN_RC(pThis, rcRet) \
+    do { \
+        AssertPtrReturn((pThis), (rcRet)); \
+        AssertReturn((pThis)->u32Magic == RTRADIXTREE_MAGIC, (rcRet)); \
+    } while (0)
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * A radix tree node.
+ */
+typedef struct RTRADIXTREENODE
+{
+    /** Number of slots in use. */
+    uint32_t                cUsed;
+    /** The slots, child nodes on the upper levels and values on the bottom one. */
+    void                   *apvSlots[RTRADIXTREE_SLOTS];
+} RTRADIXTREENODE;
+/** Pointer to a radix tree node. */
+typedef RTRADIXTREENODE *PRTRADIXTREENODE;
+
+/**
+ * Radix tree instance.
+ */
+typedef struct RTRADIXTREEINT
+{
+    /** Magic value (RTRADIXTREE_MAGIC). */
+    uint32_t                u32Magic;
+    /** Number of levels, 0 if empty. */
+    uint32_t                cLevels;
+    /** Number of values. */
+    uint64_t                cEntries;
+    /** The root node, NULL if empty. */
+    PRTRADIXTREENODE        pRoot;
+} RTRADIXTREEINT;
+/** Pointer to a radix tree instance. */
+typedef RTRADIXTREEINT *PRTRADIXTREEINT;
+
+
+/**
+ * Gets the largest index a tree with the given number of levels can hold.
+ */
+DECLINLINE(uint64_t) rtRadixTreeMaxIndex(uint32_t cLevels)
+{
+    return cLevels * RTRADIXTREE_LEVEL_SHIFT >= 64 ? UINT64_MAX : RT_BIT_64(cLevels * RTRADIXTREE_LEVEL_SHIFT) - 1;
+}
+
+
+/**
+ * Gets the slot index of @a uIndex on the given level.
+ */
+DECLINLINE(uint32_t) rtRadixTreeSlot(uint64_t uIndex, uint32_t iLevel)
+{
+    return (uint32_t)(uIndex >> (iLevel * RTRADIXTREE_LEVEL_SHIFT)) & RTRADIXTREE_SLOT_MASK;
+}
+
+
+/**
+ * Frees the empty nodes along a lookup path, bottom up.
+ *
+ * @param   pThis           The tree.
+ * @param   papNodes        The nodes of the path indexed by level.
+ * @param   paiSlots        The slot taken in each node.
+ * @param   iLevelFirst     The lowest level with a valid array entry.
+ */
+static void rtRadixTreePrunePath(PRTRADIXTREEINT pThis, PRTRADIXTREENODE *papNodes, uint32_t const *paiSlots, uint32_t iLevelFirst)
+{
+    uint32_t const iRoot = pThis->cLevels - 1;
+    for (uint32_t iLevel = iLevelFirst; iLevel < iRoot && papNodes[iLevel]->cUsed == 0; iLevel++)
+    {
+        RTMemFree(papNodes[iLevel]);
+        PRTRADIXTREENODE pParent = papNodes[iLevel + 1];
+        pParent->apvSlots[paiSlots[iLevel + 1]] = NULL;
+        pParent->cUsed--;
+    }
+
+    /* Drop the root when empty and collapse levels which only hold the low indexes. */
+    if (pThis->pRoot->cUsed == 0)
+    {
+        RTMemFree(pThis->pRoot);
+        pThis->pRoot   = NULL;
+        pThis->cLevels = 0;
+    }
+    else
+        while (   pThis->cLevels > 1
+               && pThis->pRoot->cUsed == 1
+               && pThis->pRoot->apvSlots[0])
+        {
+            PRTRADIXTREENODE pOldRoot = pThis->pRoot;
+            pThis->pRoot = (PRTRADIXTREENODE)pOldRoot->apvSlots[0];
+            pThis->cLevels--;
+            RTMemFree(pOldRoot);
+        }
+}
+
+
+RTDECL(int) RTRadixTreeCreate(PRTRADIXTREE phTree)
+{
+    AssertPtrReturn(phTree, VERR_INVALID_POINTER);
+
+    PRTRADIXTREEINT pThis = (PRTRADIXTREEINT)RTMemAllocZ(sizeof(*pThis));
+    if (!pThis)
+        return VERR_NO_MEMORY;
+    pThis->u32Magic = RTRADIXTREE_MAGIC;
+    *phTree = pThis;
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTRadixTreeCreate);
+
+
+/**
+ * Frees a subtree, calling the callback for each value.
+ */
+static void rtRadixTreeDestroyNode(PRTRADIXTREENODE pNode, uint32_t iLevel, uint64_t uBase,
+                                   PFNRTRADIXTREECALLBACK pfnCallback, void *pvUser)
+{
+    for (uint32_t iSlot = 0; iSlot < RTRADIXTREE_SLOTS; iSlot++)
+    {
+        void *pv = pNode->apvSlots[iSlot];
+        if (pv)
+        {
+            uint64_t const uIndex = uBase | ((uint64_t)iSlot << (iLevel * RTRADIXTREE_LEVEL_SHIFT));
+            if (iLevel > 0)
+                rtRadixTreeDestroyNode((PRTRADIXTREENODE)pv, iLevel - 1, uIndex, pfnCallback, pvUser);
+            else if (pfnCallback)
+                pfnCallback(uIndex, pv, pvUser);
+        }
+    }
+    RTMemFree(pNode);
+}
+
+
+RTDECL(int) RTRadixTreeDestroy(RTRADIXTREE hTree, PFNRTRADIXTREECALLBACK pfnCallback, void *pvUser)
+{
+    PRTRADIXTREEINT pThis = hTree;
+    if (pThis == NIL_RTRADIXTREE)
+        return VINF_SUCCESS;
+    RTRADIXTREE_VALID_RETURN_RC(pThis, VERR_INVALID_HANDLE);
+    AssertPtrNullReturn(pfnCallback, VERR_INVALID_POINTER);
+
+    if (pThis->pRoot)
+        rtRadixTreeDestroyNode(pThis->pRoot, pThis->cLevels - 1, 0, pfnCallback, pvUser);
+
+    pThis->u32Magic = RTRADIXTREE_MAGIC_DEAD;
+    RTMemFree(pThis);
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTRadixTreeDestroy);
+
+
+RTDECL(int) RTRadixTreeInsert(RTRADIXTREE hTree, uint64_t uIndex, void *pvValue)
+{
+    PRTRADIXTREEINT pThis = hTree;
+    RTRADIXTREE_VALID_RETURN_RC(pThis, VERR_INVALID_HANDLE);
+    AssertReturn(pvValue, VERR_INVALID_PARAMETER);
+
+    /* Grow the tree upwards until the index fits. */
+    if (!pThis->pRoot)
+    {
+        pThis->pRoot = (PRTRADIXTREENODE)RTMemAllocZ(sizeof(RTRADIXTREENODE));
+        if (!pThis->pRoot)
+            return VERR_NO_MEMORY;
+        pThis->cLevels = 1;
+    }
+    while (uIndex > rtRadixTreeMaxIndex(pThis->cLevels))
+    {
+        PRTRADIXTREENODE pRoot = (PRTRADIXTREENODE)RTMemAllocZ(sizeof(RTRADIXTREENODE));
+        if (!pRoot)
+            return VERR_NO_MEMORY;
+        pRoot->apvSlots[0] = pThis->pRoot;
+        pRoot->cUsed       = 1;
+        pThis->pRoot = pRoot;
+        pThis->cLevels++;
+    }
+
+    /* Walk down, allocating the missing nodes. */
+    PRTRADIXTREENODE apNodes[RTRADIXTREE_MAX_LEVELS];
+    uint32_t         aiSlots[RTRADIXTREE_MAX_LEVELS];
+    PRTRADIXTREENODE pNode = pThis->pRoot;
+    uint32_t         iLevel = pThis->cLevels - 1;
+    for (;;)
+    {
+        uint32_t const iSlot = rtRadixTreeSlot(uIndex, iLevel);
+        apNodes[iLevel] = pNode;
+        aiSlots[iLevel] = iSlot;
+        if (iLevel == 0)
+            break;
+
+        PRTRADIXTREENODE pChild = (PRTRADIXTREENODE)pNode->apvSlots[iSlot];
+        if (!pChild)
+        {
+            pChild = (PRTRADIXTREENODE)RTMemAllocZ(sizeof(RTRADIXTREENODE));
+            if (!pChild)
+            {
+                rtRadixTreePrunePath(pThis, apNodes, aiSlots, iLevel);
+                return VERR_NO_MEMORY;
+            }
+            pNode->apvSlots[iSlot] = pChild;
+            pNode->cUsed++;
+        }
+        pNode = pChild;
+        iLevel--;
+    }
+
+    if (pNode->apvSlots[aiSlots[0]])
+        return VERR_ALREADY_EXISTS;
+    pNode->apvSlots[aiSlots[0]] = pvValue;
+    pNode->cUsed++;
+    pThis->cEntries++;
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTRadixTreeInsert);
+
+
+RTDECL(void *) RTRadixTreeRemove(RTRADIXTREE hTree, uint64_t uIndex)
+{
+    PRTRADIXTREEINT pThis = hTree;
+    RTRADIXTREE_VALID_RETURN_RC(pThis, NULL);
+    if (   !pThis->pRoot
+        || uIndex > rtRadixTreeMaxIndex(pThis->cLevels))
+        return NULL;
+
+    PRTRADIXTREENODE apNodes[RTRADIXTREE_MAX_LEVELS];
+    uint32_t         aiSlots[RTRADIXTREE_MAX_LEVELS];
+    PRTRADIXTREENODE pNode = pThis->pRoot;
+    for (uint32_t iLevel = pThis->cLevels - 1; ; iLevel--)
+    {
+        uint32_t const iSlot = rtRadixTreeSlot(uIndex, iLevel);
+        apNodes[iLevel] = pNode;
+        aiSlots[iLevel] = iSlot;
+        if (iLevel == 0)
+            break;
+        pNode = (PRTRADIXTREENODE)pNode->apvSlots[iSlot];
+        if (!pNode)
+            return NULL;
+    }
+
+    void *pvValue = pNode->apvSlots[aiSlots[0]];
+    if (pvValue)
+    {
+        pNode->apvSlots[aiSlots[0]] = NULL;
+        pNode->cUsed--;
+        pThis->cEntries--;
+        rtRadixTreePrunePath(pThis, apNodes, aiSlots, 0 /*iLevelFirst*/);
+    }
+    return pvValue;
+}
+RT_EXPORT_SYMBOL(RTRadixTreeRemove);
+
+
+RTDECL(void *) RTRadixTreeLookup(RTRADIXTREE hTree, uint64_t uIndex)
+{
+    PRTRADIXTREEINT pThis = hTree;
+    RTRADIXTREE_VALID_RETURN_RC(pThis, NULL);
+    if (   !pThis->pRoot
+        || uIndex > rtRadixTreeMaxIndex(pThis->cLevels))
+        return NULL;
+
+    PRTRADIXTREENODE pNode = pThis->pRoot;
+    for (uint32_t iLevel = pThis->cLevels - 1; iLevel > 0; iLevel--)
+    {
+        pNode = (PRTRADIXTREENODE)pNode->apvSlots[rtRadixTreeSlot(uIndex, iLevel)];
+        if (!pNode)
+            return NULL;
+    }
+    return pNode->apvSlots[uIndex & RTRADIXTREE_SLOT_MASK];
+}
+RT_EXPORT_SYMBOL(RTRadixTreeLookup);
+
+
+/**
+ * Recursive worker for RTRadixTreeDoWithAll.
+ */
+static int rtRadixTreeDoWithAllNode(PRTRADIXTREENODE pNode, uint32_t iLevel, uint64_t uBase,
+                                    PFNRTRADIXTREECALLBACK pfnCallback, void *pvUser)
+{
+    for (uint32_t iSlot = 0; iSlot < RTRADIXTREE_SLOTS; iSlot++)
+    {
+        void *pv = pNode->apvSlots[iSlot];
+        if (pv)
+        {
+            uint64_t const uIndex = uBase | ((uint64_t)iSlot << (iLevel * RTRADIXTREE_LEVEL_SHIFT));
+            int rc = iLevel > 0
+                   ? rtRadixTreeDoWithAllNode((PRTRADIXTREENODE)pv, iLevel - 1, uIndex, pfnCallback, pvUser)
+                   : pfnCallback(uIndex, pv, pvUser);
+            if (rc != VINF_SUCCESS)
+                return rc;
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+
+RTDECL(int) RTRadixTreeDoWithAll(RTRADIXTREE hTree, PFNRTRADIXTREECALLBACK pfnCallback, void *pvUser)
+{
+    PRTRADIXTREEINT pThis = hTree;
+    RTRADIXTREE_VALID_RETURN_RC(pThis, VERR_INVALID_HANDLE);
+    AssertPtrReturn(pfnCallback, VERR_INVALID_POINTER);
+
+    if (!pThis->pRoot)
+        return VINF_SUCCESS;
+    return rtRadixTreeDoWithAllNode(pThis->pRoot, pThis->cLevels - 1, 0, pfnCallback, pvUser);
+}
+RT_EXPORT_SYMBOL(RTRadixTreeDoWithAll);
+
+
+RTDECL(uint64_t) RTRadixTreeGetCount(RTRADIXTREE hTree)
+{
+    PRTRADIXTREEINT pThis = hTree;
+    RTRADIXTREE_VALID_RETURN_RC(pThis, 0);
+    return pThis->cEntries;
+}
+RT_EXPORT_SYMBOL(RTRadixTreeGetCount);
+
@@ -195,7 +195,7 @@ static RTEXITCODE gzipCompressFile(PRTVFSIOSTREAM phVfsSrc, PCRTGZIPCMDOPTS pOpt
      * Attach the compressor to the output stream.
      */
     RTVFSIOSTREAM hVfsGzip;
-    int rc = RTZipGzipCompressIoStream(*phVfsDst, 0 /*fFlags*/, pOpts->uLevel, &hVfsGzip);
+    int rc = RTZipGzipCompressIoStream(*phVfsDst, RTZIPGZIPCOMP_F_PARALLEL, pOpts->uLevel, &hVfsGzip);
     if (RT_FAILURE(rc))
         return RTMsgErrorExit(RTEXITCODE_FAILURE, "RTZipGzipCompressIoStream failed: %Rrc", rc);
 
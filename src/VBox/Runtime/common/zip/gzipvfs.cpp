@@ -45,7 +45,10 @@
 #include <iprt/ctype.h>
 #include <iprt/file.h>
 #include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/mp.h>
 #include <iprt/poll.h>
+#include <iprt/req.h>
 #include <iprt/string.h>
 #include <iprt/vfslowlevel.h>
 
@@ -68,6 +71,21 @@ PFNRT g_apfnRTZlibDeps[] =
 #endif /* RT_OS_OS2 || RT_OS_SOLARIS || RT_OS_WINDOWS */
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** The amount of input compressed by one worker in parallel mode. */
+#define RTZIPGZIP_PAR_BLOCK_SIZE            _128K
+/** The amount of preceeding input used as dictionary for a block, the
+ * deflate window size. */
+#define RTZIPGZIP_PAR_DICT_SIZE             _32K
+/** Max number of worker threads in parallel mode. */
+#define RTZIPGZIP_PAR_THREADS_MAX           8
+/** Number of blocks queued per worker thread, keeping the workers busy while
+ * the oldest block is being written. */
+#define RTZIPGZIP_PAR_SLOTS_PER_THREAD      2
+
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
@@ -145,6 +163,60 @@ typedef RTZIPGZIPHDR const *PCRTZIPGZIPHDR;
 /** @}  */
 
 
+/**
+ * A block queued for parallel compression.
+ */
+typedef struct RTZIPGZIPPARSLOT
+{
+    /** The request compressing this block, NIL_RTREQ if the slot is free. */
+    PRTREQ              hReq;
+    /** Set if this is the final block of the stream. */
+    bool                fFinal;
+    /** The size of the dictionary, i.e. the bytes preceeding the block data. */
+    uint32_t            cbDict;
+    /** The amount of data in the block. */
+    uint32_t            cbData;
+    /** The CRC-32 of the block data (set by the worker). */
+    uint32_t            uCrc;
+    /** The amount of compressed data (set by the worker). */
+    size_t              cbOut;
+    /** The size of the output buffer. */
+    size_t              cbOutMax;
+    /** The output buffer. */
+    uint8_t            *pbOut;
+    /** The input buffer: RTZIPGZIP_PAR_DICT_SIZE bytes of dictionary space
+     * followed by RTZIPGZIP_PAR_BLOCK_SIZE bytes of block data. */
+    uint8_t            *pbIn;
+    /** Raw deflate stream, reset for each block. */
+    z_stream            Zlib;
+} RTZIPGZIPPARSLOT;
+/** Pointer to a queued block. */
+typedef RTZIPGZIPPARSLOT *PRTZIPGZIPPARSLOT;
+
+/**
+ * Parallel compression state.
+ */
+typedef struct RTZIPGZIPPAR
+{
+    /** The worker pool doing the compression. */
+    RTREQPOOL           hReqPool;
+    /** Set when the gzip header has been written. */
+    bool                fHdrWritten;
+    /** The CRC-32 of all the data written so far. */
+    uint32_t            uCrc;
+    /** Number of slots. */
+    uint32_t            cSlots;
+    /** Index of the oldest pending slot. */
+    uint32_t            idxHead;
+    /** Number of pending slots.  The slot following them is being filled. */
+    uint32_t            cPending;
+    /** The slots (variable size). */
+    RTZIPGZIPPARSLOT    aSlots[1];
+} RTZIPGZIPPAR;
+/** Pointer to parallel compression state. */
+typedef RTZIPGZIPPAR *PRTZIPGZIPPAR;
+
+
 /**
  * The internal data of a GZIP I/O stream.
  */
@@ -174,6 +246,9 @@ typedef struct RTZIPGZIPSTREAM
     char               *pszComment;
     /** The gzip header. */
     RTZIPGZIPHDR        Hdr;
+    /** Parallel compression state, NULL when compressing on the calling
+     * thread (compressor only). */
+    PRTZIPGZIPPAR       pPar;
 } RTZIPGZIPSTREAM;
 /** Pointer to a the internal data of a GZIP I/O stream. */
 typedef RTZIPGZIPSTREAM *PRTZIPGZIPSTREAM;
@@ -183,6 +258,8 @@ typedef RTZIPGZIPSTREAM *PRTZIPGZIPSTREAM;
 *   Internal Functions                                                                                                           *
 *********************************************************************************************************************************/
 static int rtZipGzip_FlushIt(PRTZIPGZIPSTREAM pThis, uint8_t fFlushType);
+static int rtZipGzipPar_FlushIt(PRTZIPGZIPSTREAM pThis, bool fFinal);
+static void rtZipGzipPar_Destroy(PRTZIPGZIPSTREAM pThis);
 
 
 /**
@@ -246,6 +323,14 @@ static DECLCALLBACK(int) rtZipGzip_Close(void *pvThis)
         if (rc != Z_OK)
             rc = rtZipGzipConvertErrFromZlib(pThis, rc);
     }
+    else if (pThis->pPar)
+    {
+        /* Compress and write the final block and the trailer. */
+        rc = VINF_SUCCESS;
+        if (!pThis->fFatalError)
+            rc = rtZipGzipPar_FlushIt(pThis, true /*fFinal*/);
+        rtZipGzipPar_Destroy(pThis);
+    }
     else
     {
         /* Flush the compression stream before terminating it. */
@@ -517,6 +602,308 @@ static int rtZipGzip_CompressIt(PRTZIPGZIPSTREAM pThis, bool fBlocking)
 }
 
 
+/**
+ * Worker compressing a queued block into a raw deflate fragment.
+ *
+ * All but the final block are terminated by a sync flush, so they end on a
+ * byte boundary and can simply be concatenated.
+ *
+ * @returns IPRT status code.
+ * @param   pSlot           The block to compress.
+ */
+static DECLCALLBACK(int) rtZipGzipPar_Worker(PRTZIPGZIPPARSLOT pSlot)
+{
+    uint8_t *pbData = &pSlot->pbIn[RTZIPGZIP_PAR_DICT_SIZE];
+    pSlot->uCrc  = crc32(0, pbData, pSlot->cbData);
+    pSlot->cbOut = 0;
+
+    int rcZlib = deflateReset(&pSlot->Zlib);
+    if (rcZlib == Z_OK && pSlot->cbDict)
+        rcZlib = deflateSetDictionary(&pSlot->Zlib, pbData - pSlot->cbDict, pSlot->cbDict);
+    if (rcZlib == Z_OK)
+    {
+        pSlot->Zlib.next_in   = pbData;
+        pSlot->Zlib.avail_in  = pSlot->cbData;
+        pSlot->Zlib.next_out  = pSlot->pbOut;
+        pSlot->Zlib.avail_out = (uInt)pSlot->cbOutMax;
+        rcZlib = deflate(&pSlot->Zlib, pSlot->fFinal ? Z_FINISH : Z_SYNC_FLUSH);
+        pSlot->cbOut = pSlot->cbOutMax - pSlot->Zlib.avail_out;
+
+        /* The output buffer is sized using deflateBound, so one call must do it. */
+        if (pSlot->fFinal)
+        {
+            if (rcZlib == Z_STREAM_END)
+                return VINF_SUCCESS;
+        }
+        else if (rcZlib == Z_OK && pSlot->Zlib.avail_in == 0 && pSlot->Zlib.avail_out > 0)
+            return VINF_SUCCESS;
+    }
+    return rcZlib == Z_MEM_ERROR ? VERR_ZIP_NO_MEMORY : VERR_ZIP_ERROR;
+}
+
+
+/**
+ * Waits for the oldest queued block to be compressed and writes it out,
+ * preceeded by the gzip header if this is the first one.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The gzip I/O stream instance data.
+ */
+static int rtZipGzipPar_Commit(PRTZIPGZIPSTREAM pThis)
+{
+    PRTZIPGZIPPAR pPar = pThis->pPar;
+    Assert(pPar->cPending);
+    PRTZIPGZIPPARSLOT pSlot = &pPar->aSlots[pPar->idxHead];
+
+    int rc = RTReqWait(pSlot->hReq, RT_INDEFINITE_WAIT);
+    if (RT_SUCCESS(rc))
+        rc = RTReqGetStatus(pSlot->hReq);
+    RTReqRelease(pSlot->hReq);
+    pSlot->hReq = NIL_RTREQ;
+    pPar->idxHead = (pPar->idxHead + 1) % pPar->cSlots;
+    pPar->cPending--;
+
+    /* Don't write anything after a gap in the output. */
+    if (RT_SUCCESS(rc) && pThis->fFatalError)
+        rc = VERR_ZIP_ERROR;
+
+    if (RT_SUCCESS(rc) && !pPar->fHdrWritten)
+    {
+        rc = RTVfsIoStrmWrite(pThis->hVfsIos, &pThis->Hdr, sizeof(pThis->Hdr), true /*fBlocking*/, NULL);
+        pPar->fHdrWritten = RT_SUCCESS(rc);
+    }
+    if (RT_SUCCESS(rc))
+    {
+        rc = RTVfsIoStrmWrite(pThis->hVfsIos, pSlot->pbOut, pSlot->cbOut, true /*fBlocking*/, NULL);
+        pPar->uCrc = (uint32_t)crc32_combine(pPar->uCrc, pSlot->uCrc, pSlot->cbData);
+    }
+    if (RT_FAILURE(rc))
+        pThis->fFatalError = true;
+    return rc;
+}
+
+
+/**
+ * Queues the block currently being filled for compression and sets up the
+ * next one, writing the oldest queued block first if the queue is full.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The gzip I/O stream instance data.
+ * @param   fFinal          Set if this is the last block of the stream.
+ */
+static int rtZipGzipPar_Submit(PRTZIPGZIPSTREAM pThis, bool fFinal)
+{
+    PRTZIPGZIPPAR     pPar  = pThis->pPar;
+    PRTZIPGZIPPARSLOT pSlot = &pPar->aSlots[(pPar->idxHead + pPar->cPending) % pPar->cSlots];
+    Assert(pSlot->hReq == NIL_RTREQ);
+    pSlot->fFinal = fFinal;
+
+    int rc = RTReqPoolCallEx(pPar->hReqPool, 0 /*cMillies*/, &pSlot->hReq, RTREQFLAGS_IPRT_STATUS,
+                             (PFNRT)rtZipGzipPar_Worker, 1, pSlot);
+    if (rc != VERR_TIMEOUT && RT_FAILURE(rc))
+    {
+        pSlot->hReq = NIL_RTREQ;
+        pThis->fFatalError = true;
+        return rc;
+    }
+    pPar->cPending++;
+
+    rc = VINF_SUCCESS;
+    if (pPar->cPending == pPar->cSlots)
+        rc = rtZipGzipPar_Commit(pThis);
+
+    /* Prime the next block with the tail of the input so far.  The worker
+       only reads the submitted slot, so sharing it here is fine. */
+    if (!fFinal)
+    {
+        PRTZIPGZIPPARSLOT pNext  = &pPar->aSlots[(pPar->idxHead + pPar->cPending) % pPar->cSlots];
+        uint32_t const    cbDict = RT_MIN(pSlot->cbDict + pSlot->cbData, RTZIPGZIP_PAR_DICT_SIZE);
+        Assert(pNext != pSlot && pNext->hReq == NIL_RTREQ);
+        memcpy(&pNext->pbIn[RTZIPGZIP_PAR_DICT_SIZE - cbDict],
+               &pSlot->pbIn[RTZIPGZIP_PAR_DICT_SIZE + pSlot->cbData - cbDict], cbDict);
+        pNext->cbDict = cbDict;
+        pNext->cbData = 0;
+    }
+    return rc;
+}
+
+
+/**
+ * Parallel mode version of rtZipGzip_CompressIt, buffering the input and
+ * queuing each full block for compression.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The gzip I/O stream instance data.
+ * @param   pbSrc           The input.
+ * @param   cbSrc           The amount of input.
+ * @param   pcbWritten      Where to return how much input was consumed.
+ */
+static int rtZipGzipPar_CompressIt(PRTZIPGZIPSTREAM pThis, uint8_t const *pbSrc, size_t cbSrc, size_t *pcbWritten)
+{
+    PRTZIPGZIPPAR pPar = pThis->pPar;
+    *pcbWritten = 0;
+    if (pThis->fFatalError)
+        return VERR_ZIP_ERROR;
+
+    while (cbSrc > 0)
+    {
+        PRTZIPGZIPPARSLOT pSlot  = &pPar->aSlots[(pPar->idxHead + pPar->cPending) % pPar->cSlots];
+        size_t const      cbThis = RT_MIN(cbSrc, RTZIPGZIP_PAR_BLOCK_SIZE - pSlot->cbData);
+        memcpy(&pSlot->pbIn[RTZIPGZIP_PAR_DICT_SIZE + pSlot->cbData], pbSrc, cbThis);
+        pSlot->cbData += (uint32_t)cbThis;
+        pbSrc         += cbThis;
+        cbSrc         -= cbThis;
+        *pcbWritten   += cbThis;
+
+        if (pSlot->cbData == RTZIPGZIP_PAR_BLOCK_SIZE)
+        {
+            int rc = rtZipGzipPar_Submit(pThis, false /*fFinal*/);
+            if (RT_FAILURE(rc))
+                return rc;
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Parallel mode version of rtZipGzip_FlushIt, compressing the partially filled
+ * block and writing out all the queued ones.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The gzip I/O stream instance data.
+ * @param   fFinal          Set when closing the stream, this ends the deflate
+ *                          stream and writes the gzip trailer.
+ */
+static int rtZipGzipPar_FlushIt(PRTZIPGZIPSTREAM pThis, bool fFinal)
+{
+    PRTZIPGZIPPAR     pPar  = pThis->pPar;
+    PRTZIPGZIPPARSLOT pSlot = &pPar->aSlots[(pPar->idxHead + pPar->cPending) % pPar->cSlots];
+
+    int rc = VINF_SUCCESS;
+    if (pSlot->cbData > 0 || fFinal)
+        rc = rtZipGzipPar_Submit(pThis, fFinal);
+
+    /* Keep going after a failure so no request is left behind. */
+    while (pPar->cPending)
+    {
+        int rc2 = rtZipGzipPar_Commit(pThis);
+        if (RT_SUCCESS(rc))
+            rc = rc2;
+    }
+
+    if (RT_SUCCESS(rc) && fFinal)
+    {
+        uint32_t const au32Trailer[2] = { RT_H2LE_U32(pPar->uCrc), RT_H2LE_U32((uint32_t)pThis->offStream) };
+        rc = RTVfsIoStrmWrite(pThis->hVfsIos, &au32Trailer[0], sizeof(au32Trailer), true /*fBlocking*/, NULL);
+        if (RT_FAILURE(rc))
+            pThis->fFatalError = true;
+    }
+    return rc;
+}
+
+
+/**
+ * Destroys the parallel compression state, discarding all blocks which were
+ * not written yet.
+ *
+ * @param   pThis           The gzip I/O stream instance data.
+ */
+static void rtZipGzipPar_Destroy(PRTZIPGZIPSTREAM pThis)
+{
+    PRTZIPGZIPPAR pPar = pThis->pPar;
+    if (!pPar)
+        return;
+
+    while (pPar->cPending)
+    {
+        PRTZIPGZIPPARSLOT pSlot = &pPar->aSlots[pPar->idxHead];
+        RTReqWait(pSlot->hReq, RT_INDEFINITE_WAIT);
+        RTReqRelease(pSlot->hReq);
+        pSlot->hReq = NIL_RTREQ;
+        pPar->idxHead = (pPar->idxHead + 1) % pPar->cSlots;
+        pPar->cPending--;
+    }
+    for (uint32_t i = 0; i < pPar->cSlots; i++)
+    {
+        if (pPar->aSlots[i].Zlib.state)
+            deflateEnd(&pPar->aSlots[i].Zlib);
+        RTMemFree(pPar->aSlots[i].pbIn);
+        RTMemFree(pPar->aSlots[i].pbOut);
+    }
+    RTReqPoolRelease(pPar->hReqPool);
+    RTMemFree(pPar);
+    pThis->pPar = NULL;
+}
+
+
+/**
+ * Sets up parallel compression.
+ *
+ * Failing to do so is not fatal, the stream is compressed on the calling
+ * thread then.
+ *
+ * @param   pThis           The gzip I/O stream instance data.
+ * @param   uLevel          The compression level.
+ */
+static void rtZipGzipPar_Create(PRTZIPGZIPSTREAM pThis, uint8_t uLevel)
+{
+    uint32_t const cThreads = RT_MIN(RTMpGetOnlineCount(), RTZIPGZIP_PAR_THREADS_MAX);
+    if (cThreads < 2)
+        return;
+
+    uint32_t const cSlots = cThreads * RTZIPGZIP_PAR_SLOTS_PER_THREAD;
+    PRTZIPGZIPPAR  pPar   = (PRTZIPGZIPPAR)RTMemAllocZ(RT_UOFFSETOF_DYN(RTZIPGZIPPAR, aSlots[cSlots]));
+    if (!pPar)
+        return;
+    pPar->cSlots = cSlots;
+    pThis->pPar  = pPar;
+
+    int rc = RTReqPoolCreate(cThreads, RT_MS_1SEC, cThreads, 0 /*cMsMaxPushBack*/, "GzipPar", &pPar->hReqPool);
+    for (uint32_t i = 0; i < cSlots && RT_SUCCESS(rc); i++)
+    {
+        PRTZIPGZIPPARSLOT pSlot = &pPar->aSlots[i];
+        pSlot->hReq = NIL_RTREQ;
+        int rcZlib = deflateInit2(&pSlot->Zlib,
+                                  uLevel,
+                                  Z_DEFLATED,
+                                  -15 /* Windows Size, raw deflate */,
+                                  8 /* Default memory level, we've got lots of these */,
+                                  Z_DEFAULT_STRATEGY);
+        if (rcZlib == Z_OK)
+        {
+            /* Leave room for the empty stored block of the sync flush. */
+            pSlot->cbOutMax = deflateBound(&pSlot->Zlib, RTZIPGZIP_PAR_BLOCK_SIZE) + 16;
+            pSlot->pbOut    = (uint8_t *)RTMemAlloc(pSlot->cbOutMax);
+            pSlot->pbIn     = (uint8_t *)RTMemAlloc(RTZIPGZIP_PAR_DICT_SIZE + RTZIPGZIP_PAR_BLOCK_SIZE);
+            if (!pSlot->pbOut || !pSlot->pbIn)
+                rc = VERR_NO_MEMORY;
+        }
+        else
+            rc = rcZlib == Z_MEM_ERROR ? VERR_ZIP_NO_MEMORY : VERR_ZIP_ERROR;
+    }
+    if (RT_FAILURE(rc))
+    {
+        rtZipGzipPar_Destroy(pThis);
+        return;
+    }
+
+    /* We write the header ourselves, zlib only does the raw deflate bits. */
+    pThis->Hdr.bId1               = RTZIPGZIPHDR_ID1;
+    pThis->Hdr.bId2               = RTZIPGZIPHDR_ID2;
+    pThis->Hdr.bCompressionMethod = RTZIPGZIPHDR_CM_DEFLATE;
+    pThis->Hdr.fFlags             = 0;
+    pThis->Hdr.u32ModTime         = 0;
+    pThis->Hdr.bXtraFlags         = uLevel == 9 ? RTZIPGZIPHDR_XFL_DEFLATE_MAX
+                                  : uLevel == 1 ? RTZIPGZIPHDR_XFL_DEFLATE_FASTEST : 0;
+#ifdef RT_OS_WINDOWS
+    pThis->Hdr.bOS                = RTZIPGZIPHDR_OS_NTFS;
+#else
+    pThis->Hdr.bOS                = RTZIPGZIPHDR_OS_UNIX;
+#endif
+}
+
+
 /**
  * @interface_method_impl{RTVFSIOSTREAMOPS,pfnWrite}
  */
@@ -537,7 +924,9 @@ static DECLCALLBACK(int) rtZipGzip_Write(void *pvThis, RTFOFF off, PRTSGBUF pSgB
     size_t          cbWritten = 0;
     uint8_t const  *pbSrc     = (uint8_t const *)pSgBuf->paSegs[0].pvSeg;
     size_t          cbLeft    = pSgBuf->paSegs[0].cbSeg;
-    if (cbLeft > 0)
+    if (pThis->pPar)
+        rc = rtZipGzipPar_CompressIt(pThis, pbSrc, cbLeft, &cbWritten);
+    else if (cbLeft > 0)
         for (;;)
         {
             size_t cbThis = cbLeft < ~(uInt)0 ? cbLeft : ~(uInt)0 / 2;
@@ -616,7 +1005,7 @@ static DECLCALLBACK(int) rtZipGzip_Flush(void *pvThis)
     PRTZIPGZIPSTREAM pThis = (PRTZIPGZIPSTREAM)pvThis;
     if (!pThis->fDecompress)
     {
-        int rc = rtZipGzip_FlushIt(pThis, Z_SYNC_FLUSH);
+        int rc = pThis->pPar ? rtZipGzipPar_FlushIt(pThis, false /*fFinal*/) : rtZipGzip_FlushIt(pThis, Z_SYNC_FLUSH);
         if (RT_FAILURE(rc))
             return rc;
     }
@@ -649,7 +1038,7 @@ static DECLCALLBACK(int) rtZipGzip_PollOne(void *pvThis, uint32_t fEvents, RTMSI
     else
     {
         fEvents &= ~RTPOLL_EVT_READ;
-        if (pThis->Zlib.avail_out > 0)
+        if (pThis->Zlib.avail_out > 0 || pThis->pPar)
             fRetEvents = RTPOLL_EVT_WRITE;
     }
 
@@ -795,7 +1184,7 @@ RTDECL(int) RTZipGzipDecompressIoStream(RTVFSIOSTREAM hVfsIosIn, uint32_t fFlags
 RTDECL(int) RTZipGzipCompressIoStream(RTVFSIOSTREAM hVfsIosDst, uint32_t fFlags, uint8_t uLevel, PRTVFSIOSTREAM phVfsIosZip)
 {
     AssertPtrReturn(hVfsIosDst, VERR_INVALID_HANDLE);
-    AssertReturn(!fFlags, VERR_INVALID_PARAMETER);
+    AssertReturn(!(fFlags & ~RTZIPGZIPCOMP_F_PARALLEL), VERR_INVALID_PARAMETER);
     AssertPtrReturn(phVfsIosZip, VERR_INVALID_POINTER);
     AssertReturn(uLevel > 0 && uLevel <= 9, VERR_INVALID_PARAMETER);
 
@@ -814,10 +1203,21 @@ RTDECL(int) RTZipGzipCompressIoStream(RTVFSIOSTREAM hVfsIosDst, uint32_t fFlags,
         pThis->hVfsIos      = hVfsIosDst;
         pThis->offStream    = 0;
         pThis->fDecompress  = false;
+        pThis->pPar         = NULL;
         pThis->SgSeg.pvSeg  = &pThis->abBuffer[0];
         pThis->SgSeg.cbSeg  = sizeof(pThis->abBuffer);
         RTSgBufInit(&pThis->SgBuf, &pThis->SgSeg, 1);
 
+        if (fFlags & RTZIPGZIPCOMP_F_PARALLEL)
+        {
+            rtZipGzipPar_Create(pThis, uLevel);
+            if (pThis->pPar)
+            {
+                *phVfsIosZip = hVfsIos;
+                return VINF_SUCCESS;
+            }
+        }
+
         RT_ZERO(pThis->Zlib);
         pThis->Zlib.opaque    = pThis;
         pThis->Zlib.next_out  = &pThis->abBuffer[0];
@@ -606,7 +606,7 @@ static RTEXITCODE rtZipTarCmdOpenOutputArchive(PRTZIPTARCMDOPS pOpts, PRTVFSFSST
 
         /* gunzip */
         case 'z':
-            rc = RTZipGzipCompressIoStream(hVfsIos, 0 /*fFlags*/, pOpts->bZipLevel == 0 ? 6 : RT_MIN(pOpts->bZipLevel, 9),
+            rc = RTZipGzipCompressIoStream(hVfsIos, RTZIPGZIPCOMP_F_PARALLEL, pOpts->bZipLevel == 0 ? 6 : RT_MIN(pOpts->bZipLevel, 9),
                                            &hVfsIosComp);
             if (RT_FAILURE(rc))
                 RTMsgError("Failed to open gzip decompressor: %Rrc", rc);
@@ -45,6 +45,9 @@
 # define RTZIP_USE_LZF 1
 #endif
 #define RTZIP_LZF_BLOCK_BY_BLOCK
+#if !defined(IN_GUEST) && !defined(IPRT_NO_CRT)
+# define RTZIP_USE_LZ4 1
+#endif
 //#define RTZIP_USE_LZJB 1
 //#define RTZIP_USE_LZO 1
 
@@ -1372,6 +1375,270 @@ static DECLCALLBACK(int) rtZipLZFDecompInit(PRTZIPDECOMP pZip)
 #endif /* RTZIP_USE_LZF */
 
 
+#ifdef RTZIP_USE_LZ4
+
+/** Number of bits in the LZ4 match finder hash. */
+# define RTZIPLZ4_HASH_BITS         12
+/** Minimum match length the LZ4 format can encode. */
+# define RTZIPLZ4_MIN_MATCH         4
+/** The last match must start at least this many bytes before the end. */
+# define RTZIPLZ4_MF_LIMIT          12
+/** The last this many bytes are always literals. */
+# define RTZIPLZ4_LAST_LITERALS     5
+/** Maximum distance of a match. */
+# define RTZIPLZ4_MAX_DISTANCE      UINT16_MAX
+
+/**
+ * Reads an unaligned 32-bit value.
+ */
+DECLINLINE(uint32_t) rtZipLz4Read32(const uint8_t *pb)
+{
+    uint32_t u32;
+    memcpy(&u32, pb, sizeof(u32));
+    return u32;
+}
+
+
+/**
+ * Hashes the next four input bytes for the match finder.
+ */
+DECLINLINE(uint32_t) rtZipLz4Hash(uint32_t u32)
+{
+    return (u32 * UINT32_C(2654435761)) >> (32 - RTZIPLZ4_HASH_BITS);
+}
+
+
+/**
+ * Encodes a length above the 4-bit token field as a 255 byte run.
+ */
+DECLINLINE(uint8_t *) rtZipLz4PutLength(uint8_t *pbDst, size_t cb)
+{
+    while (cb >= 255)
+    {
+        *pbDst++ = 255;
+        cb -= 255;
+    }
+    *pbDst++ = (uint8_t)cb;
+    return pbDst;
+}
+
+
+/**
+ * Emits one LZ4 sequence.
+ *
+ * @returns Pointer to the byte following the sequence, NULL on buffer overflow.
+ * @param   pbDst       Where to write.
+ * @param   pbDstEnd    End of the destination buffer.
+ * @param   pbLiterals  The literals preceeding the match.
+ * @param   cbLiterals  Number of literals.
+ * @param   offMatch    The match distance, 0 for the literals only final sequence.
+ * @param   cbMatch     The match length less RTZIPLZ4_MIN_MATCH.
+ */
+static uint8_t *rtZipLz4PutSequence(uint8_t *pbDst, uint8_t *pbDstEnd, const uint8_t *pbLiterals, size_t cbLiterals,
+                                    uint32_t offMatch, size_t cbMatch)
+{
+    size_t const cbNeeded = 1 + cbLiterals / 255 + 1 + cbLiterals + (offMatch ? 2 + cbMatch / 255 + 1 : 0);
+    if (RT_UNLIKELY((size_t)(pbDstEnd - pbDst) < cbNeeded))
+        return NULL;
+
+    uint8_t *pbToken = pbDst++;
+    if (cbLiterals >= 15)
+    {
+        *pbToken = 15 << 4;
+        pbDst = rtZipLz4PutLength(pbDst, cbLiterals - 15);
+    }
+    else
+        *pbToken = (uint8_t)(cbLiterals << 4);
+    memcpy(pbDst, pbLiterals, cbLiterals);
+    pbDst += cbLiterals;
+
+    if (offMatch)
+    {
+        *pbDst++ = (uint8_t)offMatch;
+        *pbDst++ = (uint8_t)(offMatch >> 8);
+        if (cbMatch >= 15)
+        {
+            *pbToken |= 15;
+            pbDst = rtZipLz4PutLength(pbDst, cbMatch - 15);
+        }
+        else
+            *pbToken |= (uint8_t)cbMatch;
+    }
+    return pbDst;
+}
+
+
+/**
+ * Compresses a block into the LZ4 block format.
+ *
+ * This is a greedy single probe match finder along the lines of the reference
+ * LZ4_compress_fast(), trading ratio for speed.
+ *
+ * @returns iprt status code.
+ * @param   pbSrc           The data to compress.
+ * @param   cbSrc           Number of bytes to compress.
+ * @param   pbDst           Where to store the compressed data.
+ * @param   cbDst           Size of the destination buffer.
+ * @param   pcbDstActual    Where to return the compressed size.
+ */
+static int rtZipLz4CompressBlock(const uint8_t *pbSrc, size_t cbSrc, uint8_t *pbDst, size_t cbDst, size_t *pcbDstActual)
+{
+    uint8_t        *pbOut    = pbDst;
+    uint8_t * const pbOutEnd = pbDst + cbDst;
+    const uint8_t  *pbAnchor = pbSrc;
+
+    if (cbSrc > RTZIPLZ4_MF_LIMIT)
+    {
+        uint32_t aoffHash[RT_BIT_32(RTZIPLZ4_HASH_BITS)];
+        RT_ZERO(aoffHash);
+
+        const uint8_t * const pbMatchLimit = pbSrc + cbSrc - RTZIPLZ4_MF_LIMIT;
+        const uint8_t * const pbMatchEnd   = pbSrc + cbSrc - RTZIPLZ4_LAST_LITERALS;
+        const uint8_t        *pbCur        = pbSrc + 1;
+        uint32_t              cMisses      = 0;
+
+        while (pbCur < pbMatchLimit)
+        {
+            uint32_t const  u32Cur = rtZipLz4Read32(pbCur);
+            uint32_t const  idx    = rtZipLz4Hash(u32Cur);
+            const uint8_t  *pbRef  = pbSrc + aoffHash[idx];
+            aoffHash[idx] = (uint32_t)(pbCur - pbSrc);
+
+            if (   pbRef >= pbCur
+                || pbCur - pbRef > RTZIPLZ4_MAX_DISTANCE
+                || rtZipLz4Read32(pbRef) != u32Cur)
+            {
+                /* Skip faster through incompressible data. */
+                pbCur += 1 + (cMisses++ >> 6);
+                continue;
+            }
+            cMisses = 0;
+
+            /* Extend the match backwards over pending literals and then forwards. */
+            while (   pbCur > pbAnchor
+                   && pbRef > pbSrc
+                   && pbCur[-1] == pbRef[-1])
+            {
+                pbCur--;
+                pbRef--;
+            }
+            const uint8_t *pbCurEnd = pbCur + RTZIPLZ4_MIN_MATCH;
+            const uint8_t *pbRefEnd = pbRef + RTZIPLZ4_MIN_MATCH;
+            while (pbCurEnd < pbMatchEnd && *pbCurEnd == *pbRefEnd)
+            {
+                pbCurEnd++;
+                pbRefEnd++;
+            }
+
+            pbOut = rtZipLz4PutSequence(pbOut, pbOutEnd, pbAnchor, (size_t)(pbCur - pbAnchor), (uint32_t)(pbCur - pbRef),
+                                        (size_t)(pbCurEnd - pbCur) - RTZIPLZ4_MIN_MATCH);
+            if (RT_UNLIKELY(!pbOut))
+                return VERR_BUFFER_OVERFLOW;
+
+            pbCur = pbAnchor = pbCurEnd;
+            if (pbCur - 2 > pbSrc && pbCur < pbMatchLimit)
+                aoffHash[rtZipLz4Hash(rtZipLz4Read32(pbCur - 2))] = (uint32_t)(pbCur - 2 - pbSrc);
+        }
+    }
+
+    pbOut = rtZipLz4PutSequence(pbOut, pbOutEnd, pbAnchor, (size_t)(pbSrc + cbSrc - pbAnchor), 0 /*offMatch*/, 0);
+    if (RT_UNLIKELY(!pbOut))
+        return VERR_BUFFER_OVERFLOW;
+    *pcbDstActual = (size_t)(pbOut - pbDst);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Reads a length continuation run.
+ *
+ * @returns false if the input ends before the run does.
+ */
+DECLINLINE(bool) rtZipLz4GetLength(const uint8_t **ppbSrc, const uint8_t *pbSrcEnd, size_t *pcb)
+{
+    const uint8_t *pbSrc = *ppbSrc;
+    uint8_t b;
+    do
+    {
+        if (RT_UNLIKELY(pbSrc >= pbSrcEnd))
+            return false;
+        b = *pbSrc++;
+        *pcb += b;
+    } while (b == 255);
+    *ppbSrc = pbSrc;
+    return true;
+}
+
+
+/**
+ * Decompresses a LZ4 format block.
+ *
+ * @returns iprt status code.
+ * @param   pbSrc           The compressed data.
+ * @param   cbSrc           Size of the compressed data.
+ * @param   pbDst           Where to store the decompressed data.
+ * @param   cbDst           Size of the destination buffer.
+ * @param   pcbDstActual    Where to return the decompressed size.
+ */
+static int rtZipLz4DecompressBlock(const uint8_t *pbSrc, size_t cbSrc, uint8_t *pbDst, size_t cbDst, size_t *pcbDstActual)
+{
+    const uint8_t * const pbSrcEnd = pbSrc + cbSrc;
+    uint8_t              *pbOut    = pbDst;
+    uint8_t * const       pbOutEnd = pbDst + cbDst;
+
+    for (;;)
+    {
+        if (RT_UNLIKELY(pbSrc >= pbSrcEnd))
+            return VERR_ZIP_CORRUPTED;
+        uint8_t const bToken = *pbSrc++;
+
+        size_t cbLiterals = bToken >> 4;
+        if (cbLiterals == 15 && !rtZipLz4GetLength(&pbSrc, pbSrcEnd, &cbLiterals))
+            return VERR_ZIP_CORRUPTED;
+        if (RT_UNLIKELY(cbLiterals > (size_t)(pbSrcEnd - pbSrc)))
+            return VERR_ZIP_CORRUPTED;
+        if (RT_UNLIKELY(cbLiterals > (size_t)(pbOutEnd - pbOut)))
+            return VERR_BUFFER_OVERFLOW;
+        memcpy(pbOut, pbSrc, cbLiterals);
+        pbOut += cbLiterals;
+        pbSrc += cbLiterals;
+
+        /* The final sequence has no match part. */
+        if (pbSrc == pbSrcEnd)
+            break;
+
+        if (RT_UNLIKELY(pbSrcEnd - pbSrc < 2))
+            return VERR_ZIP_CORRUPTED;
+        size_t const offMatch = pbSrc[0] | ((size_t)pbSrc[1] << 8);
+        pbSrc += 2;
+        if (RT_UNLIKELY(!offMatch || offMatch > (size_t)(pbOut - pbDst)))
+            return VERR_ZIP_CORRUPTED;
+
+        size_t cbMatch = bToken & 15;
+        if (cbMatch == 15 && !rtZipLz4GetLength(&pbSrc, pbSrcEnd, &cbMatch))
+            return VERR_ZIP_CORRUPTED;
+        cbMatch += RTZIPLZ4_MIN_MATCH;
+        if (RT_UNLIKELY(cbMatch > (size_t)(pbOutEnd - pbOut)))
+            return VERR_BUFFER_OVERFLOW;
+
+        const uint8_t *pbRef = pbOut - offMatch;
+        if (offMatch >= cbMatch)
+        {
+            memcpy(pbOut, pbRef, cbMatch);
+            pbOut += cbMatch;
+        }
+        else
+            while (cbMatch-- > 0) /* Overlapping, i.e. a repeating pattern. */
+                *pbOut++ = *pbRef++;
+    }
+
+    *pcbDstActual = (size_t)(pbOut - pbDst);
+    return VINF_SUCCESS;
+}
+
+#endif /* RTZIP_USE_LZ4 */
+
+
 /**
  * Create a compressor instance.
  *
@@ -1460,6 +1727,7 @@ RTDECL(int)     RTZipCompCreate(PRTZIPCOMP *ppZip, void *pvUser, PFNRTZIPOUT pfn
 
         case RTZIPTYPE_LZJB:
         case RTZIPTYPE_LZO:
+        case RTZIPTYPE_LZ4:
             break;
 
         default:
@@ -1659,6 +1927,10 @@ static int rtzipDecompInit(PRTZIPDECOMP pZip)
 #endif
             break;
 
+        case RTZIPTYPE_LZ4:
+            AssertMsgFailed(("LZ4 streaming support is not implemented!\n"));
+            break;
+
         default:
             AssertMsgFailed(("Invalid compression type %d (%#x)!\n", pZip->enmType, pZip->enmType));
             rc = VERR_INVALID_MAGIC;
@@ -1838,6 +2110,63 @@ RTDECL(int) RTZipBlockCompress(RTZIPTYPE enmType, RTZIPLEVEL enmLevel, uint32_t
         }
 
         case RTZIPTYPE_ZLIB:
+        case RTZIPTYPE_ZLIB_NO_HEADER:
+        {
+#ifdef RTZIP_USE_ZLIB
+            AssertReturn(cbSrc == (uInt)cbSrc, VERR_TOO_MUCH_DATA);
+            AssertReturn(cbDst == (uInt)cbDst, VERR_OUT_OF_RANGE);
+
+            int iLevel = Z_DEFAULT_COMPRESSION;
+            switch (enmLevel)
+            {
+                case RTZIPLEVEL_STORE:      iLevel = 0; break;
+                case RTZIPLEVEL_FAST:       iLevel = 1; break;
+                case RTZIPLEVEL_DEFAULT:    iLevel = Z_DEFAULT_COMPRESSION; break;
+                case RTZIPLEVEL_MAX:        iLevel = 9; break;
+            }
+
+            z_stream ZStrm;
+            RT_ZERO(ZStrm);
+            ZStrm.next_in   = (Bytef *)pvSrc;
+            ZStrm.avail_in  = (uInt)cbSrc;
+            ZStrm.next_out  = (Bytef *)pvDst;
+            ZStrm.avail_out = (uInt)cbDst;
+
+            int rc = deflateInit2(&ZStrm, iLevel, Z_DEFLATED, enmType == RTZIPTYPE_ZLIB ? Z_DEF_WBITS : -Z_DEF_WBITS,
+                                  8 /*memLevel*/, Z_DEFAULT_STRATEGY);
+            if (RT_UNLIKELY(rc != Z_OK))
+                return zipErrConvertFromZlib(rc, true /*fCompressing*/);
+            rc = deflate(&ZStrm, Z_FINISH);
+            if (rc != Z_STREAM_END)
+            {
+                deflateEnd(&ZStrm);
+                if (rc == Z_OK || rc == Z_BUF_ERROR)
+                    return VERR_BUFFER_OVERFLOW;
+                return zipErrConvertFromZlib(rc, true /*fCompressing*/);
+            }
+            rc = deflateEnd(&ZStrm);
+            if (rc != Z_OK)
+                return zipErrConvertFromZlib(rc, true /*fCompressing*/);
+
+            *pcbDstActual = ZStrm.total_out;
+            break;
+#else
+            return VERR_NOT_SUPPORTED;
+#endif
+        }
+
+        case RTZIPTYPE_LZ4:
+        {
+#ifdef RTZIP_USE_LZ4
+            int rc = rtZipLz4CompressBlock((const uint8_t *)pvSrc, cbSrc, (uint8_t *)pvDst, cbDst, pcbDstActual);
+            if (RT_FAILURE(rc))
+                return rc;
+            break;
+#else
+            return VERR_NOT_SUPPORTED;
+#endif
+        }
+
         case RTZIPTYPE_BZLIB:
             return VERR_NOT_SUPPORTED;
 
@@ -2003,6 +2332,23 @@ RTDECL(int) RTZipBlockDecompress(RTZIPTYPE enmType, uint32_t fFlags,
 #endif
         }
 
+        case RTZIPTYPE_LZ4:
+        {
+#ifdef RTZIP_USE_LZ4
+            size_t cbDstActual = 0;
+            int rc = rtZipLz4DecompressBlock((const uint8_t *)pvSrc, cbSrc, (uint8_t *)pvDst, cbDst, &cbDstActual);
+            if (RT_FAILURE(rc))
+                return rc;
+            if (pcbDstActual)
+                *pcbDstActual = cbDstActual;
+            if (pcbSrcActual)
+                *pcbSrcActual = cbSrc;
+            break;
+#else
+            return VERR_NOT_SUPPORTED;
+#endif
+        }
+
         case RTZIPTYPE_BZLIB:
             return VERR_NOT_SUPPORTED;
 
@@ -91,12 +91,22 @@ RTDECL(int) RTFileCopyByHandlesEx(RTFILE hFileSrc, RTFILE hFileDst, PFNRTPROGRES
     {
         /*
          * Prepare the destination file.
+         *
+         * An empty destination is simply extended, so it reads as zeros and we
+         * can leave holes in the source out.  Preallocating it would defeat
+         * both that and any block sharing copy_file_range & friends can do.
          */
+        uint32_t fCopyFlags = 0;
         uint64_t cbDst;
         rc = RTFileQuerySize(hFileDst, &cbDst);
-        if (RT_SUCCESS(rc) && cbDst > cbSrc)
+        if (RT_SUCCESS(rc) && cbDst == 0)
+        {
+            rc = RTFileSetSize(hFileDst, cbSrc);
+            fCopyFlags = RTFILECOPYPARTEX_F_SKIP_HOLES;
+        }
+        else if (RT_SUCCESS(rc) && cbDst > cbSrc)
             rc = RTFileSetSize(hFileDst, cbSrc);
-        if (RT_SUCCESS(rc) && cbDst < cbSrc)
+        else if (RT_SUCCESS(rc) && cbDst < cbSrc)
         {
             rc = RTFileSetAllocationSize(hFileDst, cbSrc, RTFILE_ALLOC_SIZE_F_DEFAULT);
             if (rc == VERR_NOT_SUPPORTED)
@@ -117,7 +127,7 @@ RTDECL(int) RTFileCopyByHandlesEx(RTFILE hFileSrc, RTFILE hFileDst, PFNRTPROGRES
                  * Copy a block.
                  */
                 uint64_t cbCopied = 0;
-                rc = RTFileCopyPartEx(hFileSrc, off, hFileDst, off, cbChunk, 0 /*fFlags*/, &BufState, &cbCopied);
+                rc = RTFileCopyPartEx(hFileSrc, off, hFileDst, off, cbChunk, fCopyFlags, &BufState, &cbCopied);
                 if (RT_FAILURE(rc))
                     break;
                 if (cbCopied == 0)
@@ -42,6 +42,7 @@
 #include "internal/iprt.h"
 
 #include <iprt/alloca.h>
+#include <iprt/asm-mem.h>
 #include <iprt/assert.h>
 #include <iprt/err.h>
 #include <iprt/mem.h>
@@ -116,7 +117,7 @@ static int rtFileCopyPartExFallback(RTFILE hFileSrc, RTFOFF offSrc, RTFILE hFile
         *pcbCopied = 0;
     AssertReturn(offSrc >= 0, VERR_NEGATIVE_SEEK);
     AssertReturn(offDst >= 0, VERR_NEGATIVE_SEEK);
-    AssertReturn(!fFlags, VERR_INVALID_FLAGS);
+    AssertReturn(!(fFlags & ~RTFILECOPYPARTEX_F_VALID_MASK), VERR_INVALID_FLAGS);
     AssertReturn(pBufState->uMagic == RTFILECOPYPARTBUFSTATE_MAGIC, VERR_INVALID_FLAGS);
 
     /*
@@ -151,9 +152,13 @@ static int rtFileCopyPartExFallback(RTFILE hFileSrc, RTFOFF offSrc, RTFILE hFile
             break;
         }
 
-        rc = RTFileWriteAt(hFileDst, offDst + cbCopied, pBufState->pbBuf, cbActual, NULL);
-        if (RT_FAILURE(rc))
-            break;
+        if (   !(fFlags & RTFILECOPYPARTEX_F_SKIP_HOLES)
+            || !ASMMemIsZero(pBufState->pbBuf, cbActual))
+        {
+            rc = RTFileWriteAt(hFileDst, offDst + cbCopied, pBufState->pbBuf, cbActual, NULL);
+            if (RT_FAILURE(rc))
+                break;
+        }
 
         cbCopied += cbActual;
     } while (cbCopied < cbToCopy);
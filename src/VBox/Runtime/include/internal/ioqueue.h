@@ -54,6 +54,8 @@ extern RTDATADECL(RTIOQUEUEPROVVTABLE const) g_RTIoQueueAioFileProv;
 /** The file I/O queue provider using the recently added io_uring interface when
  * available on the host. */
 extern RTDATADECL(RTIOQUEUEPROVVTABLE const) g_RTIoQueueLnxIoURingProv;
+/** The socket I/O queue provider using the io_uring interface when available on the host. */
+extern RTDATADECL(RTIOQUEUEPROVVTABLE const) g_RTIoQueueLnxIoURingSocketProv;
 #endif
 
 RT_C_DECLS_END
@@ -47,6 +47,10 @@
 #define RTAIOMGR_MAGIC                  UINT32_C(0x18990223)
 /** Magic number for RTAIOMGRINTFILE::u32Magic. (Ephraim Kishon) */
 #define RTAIOMGRFILE_MAGIC              UINT32_C(0x19240823)
+/** Magic number for RTBTREEU64INT::u32Magic. (Rudolf Bayer) */
+#define RTBTREEU64_MAGIC                UINT32_C(0x19390507)
+/** Magic number for RTBTREEU64INT::u32Magic after destruction. */
+#define RTBTREEU64_MAGIC_DEAD           (~RTBTREEU64_MAGIC)
 /** Magic number for RTCRCIPHERINT::u32Magic. (Michael Wolff) */
 #define RTCRCIPHERINT_MAGIC             UINT32_C(0x19530827)
 /** Magic value for RTCRKEYINT::u32Magic. (Ronald Linn Rivest) */
@@ -151,6 +155,10 @@
 #define RTLOCKVALRECNEST_MAGIC          UINT32_C(0x19071123)
 /** The magic value for RTLOCKVALRECNEST::u32Magic after deletion. */
 #define RTLOCKVALRECNEST_MAGIC_DEAD     UINT32_C(0x19980427)
+/** The magic value for RTLOGASYNCOUTPUTINT::u32Magic. (Edith Irene Soedergran) */
+#define RTLOGASYNCOUTPUT_MAGIC          UINT32_C(0x18920404)
+/** The magic value for RTLOGASYNCOUTPUTINT::u32Magic after destruction. */
+#define RTLOGASYNCOUTPUT_MAGIC_DEAD     UINT32_C(0x19230624)
 /** Magic number for RTMEMCACHEINT::u32Magic. (Joseph Weizenbaum) */
 #define RTMEMCACHE_MAGIC                UINT32_C(0x19230108)
 /** Dead magic number for RTMEMCACHEINT::u32Magic. */
@@ -169,6 +177,10 @@
 #define RTPOLLSET_MAGIC                 UINT32_C(0x19670307)
 /** RTR0MEMOBJ::u32Magic. (Masakazu Katsura) */
 #define RTR0MEMOBJ_MAGIC                UINT32_C(0x19611210)
+/** Magic number for RTRADIXTREEINT::u32Magic. (Edward Fredkin) */
+#define RTRADIXTREE_MAGIC               UINT32_C(0x19341002)
+/** Magic number for RTRADIXTREEINT::u32Magic after destruction. */
+#define RTRADIXTREE_MAGIC_DEAD          (~RTRADIXTREE_MAGIC)
 /** RTRANDINT::u32Magic. (Alan Moore) */
 #define RTRANDINT_MAGIC                 UINT32_C(0x19531118)
 /** The value of RTREQ::u32Magic. */
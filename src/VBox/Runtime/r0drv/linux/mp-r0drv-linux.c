@@ -47,6 +47,10 @@
 #include <iprt/asm.h>
 #include <iprt/thread.h>
 #include "r0drv/mp-r0drv.h"
+#if defined(RT_ARCH_AMD64) && RTLNX_VER_MIN(3,10,0)
+# include <asm/apic.h>          /* RTMpPostIpiCpu */
+# include <asm/irq_vectors.h>   /* POSTED_INTR_VECTOR */
+#endif
 
 
 /*********************************************************************************************************************************
@@ -632,6 +636,51 @@ RTDECL(int) RTMpPokeCpu(RTCPUID idCpu)
 RT_EXPORT_SYMBOL(RTMpPokeCpu);
 
 
+RTDECL(uint8_t) RTMpPostIpiGetVector(void)
+{
+#if defined(RT_ARCH_AMD64) && defined(CONFIG_SMP) && defined(POSTED_INTR_VECTOR) && RTLNX_VER_MIN(3,10,0)
+    /* The kernel reserves this vector for KVM; when it arrives outside VMX
+       non-root mode the handler only acknowledges it, which suits us fine. */
+    return POSTED_INTR_VECTOR;
+#else
+    return 0;
+#endif
+}
+RT_EXPORT_SYMBOL(RTMpPostIpiGetVector);
+
+
+RTDECL(int) RTMpPostIpiCpu(RTCPUID idCpu)
+{
+#if defined(RT_ARCH_AMD64) && defined(CONFIG_SMP) && defined(POSTED_INTR_VECTOR) && RTLNX_VER_MIN(3,10,0)
+    IPRT_LINUX_SAVE_EFL_AC();
+    int rc;
+    if (RTMpIsCpuPossible(idCpu))
+    {
+        if (RTMpIsCpuOnline(idCpu))
+        {
+# if RTLNX_VER_MIN(6,6,0)
+            __apic_send_IPI_mask(cpumask_of(idCpu), POSTED_INTR_VECTOR); /* same as KVM */
+# else
+            apic->send_IPI_mask(cpumask_of(idCpu), POSTED_INTR_VECTOR);
+# endif
+            rc = VINF_SUCCESS;
+        }
+        else
+            rc = VERR_CPU_OFFLINE;
+    }
+    else
+        rc = VERR_CPU_NOT_FOUND;
+    IPRT_LINUX_RESTORE_EFL_AC();
+    return rc;
+
+#else
+    RT_NOREF(idCpu);
+    return VERR_NOT_SUPPORTED;
+#endif
+}
+RT_EXPORT_SYMBOL(RTMpPostIpiCpu);
+
+
 RTDECL(bool) RTMpOnAllIsConcurrentSafe(void)
 {
     return true;
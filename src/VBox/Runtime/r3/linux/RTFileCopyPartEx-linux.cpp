@@ -47,6 +47,7 @@
 
 #include <errno.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <sys/syscall.h>
 
 #ifndef __NR_copy_file_range
@@ -138,7 +139,7 @@ RTDECL(int) RTFileCopyPartEx(RTFILE hFileSrc, RTFOFF offSrc, RTFILE hFileDst, RT
         return rtFileCopyPartExFallback(hFileSrc, offSrc, hFileDst, offDst, cbToCopy, fFlags, pBufState, pcbCopied);
     AssertReturn(offSrc >= 0, VERR_NEGATIVE_SEEK);
     AssertReturn(offDst >= 0, VERR_NEGATIVE_SEEK);
-    AssertReturn(!fFlags, VERR_INVALID_FLAGS);
+    AssertReturn(!(fFlags & ~RTFILECOPYPARTEX_F_VALID_MASK), VERR_INVALID_FLAGS);
 
     /*
      * If nothing to copy, return right away.
@@ -149,14 +150,59 @@ RTDECL(int) RTFileCopyPartEx(RTFILE hFileSrc, RTFOFF offSrc, RTFILE hFileDst, RT
     /*
      * Do the copying.
      */
-    uint64_t cbCopied = 0;
-    int      rc       = VINF_SUCCESS;
+    int const fdSrc        = (int)RTFileToNative(hFileSrc);
+    uint64_t  cbCopied     = 0;
+    bool      fCopiedSome  = false; /* Whether copy_file_range has moved any data yet. */
+    int       rc           = VINF_SUCCESS;
     do
     {
         size_t  cbThisCopy = (size_t)RT_MIN(cbToCopy - cbCopied, _1G);
-        loff_t  offThisDst = offSrc + cbCopied;
-        loff_t  offThisSrc = offDst + cbCopied;
-        ssize_t cbActual   = MyCopyFileRangeSysCall((int)RTFileToNative(hFileSrc), &offThisSrc,
+
+        /*
+         * Skip holes in the source if the caller said the destination reads as
+         * zeros there.  Filesystems without SEEK_DATA support fail with EINVAL,
+         * in which case we just copy everything.
+         */
+        if (fFlags & RTFILECOPYPARTEX_F_SKIP_HOLES)
+        {
+            loff_t const offCur  = offSrc + cbCopied;
+            loff_t const offData = lseek(fdSrc, offCur, SEEK_DATA);
+            if (offData < 0)
+            {
+                if (errno != ENXIO)
+                    fFlags &= ~RTFILECOPYPARTEX_F_SKIP_HOLES;
+                else
+                {
+                    /* Only a hole (or nothing) left up to the end of the file. */
+                    struct stat St;
+                    if (fstat(fdSrc, &St) != 0)
+                    {
+                        rc = RTErrConvertFromErrno(errno);
+                        break;
+                    }
+                    if (St.st_size > offCur)
+                        cbCopied += RT_MIN(cbToCopy - cbCopied, (uint64_t)(St.st_size - offCur));
+                    else if (!pcbCopied)
+                        rc = VERR_EOF;
+                    break;
+                }
+            }
+            else if (offData > offCur)
+            {
+                cbCopied += RT_MIN(cbToCopy - cbCopied, (uint64_t)(offData - offCur));
+                continue;
+            }
+            else
+            {
+                loff_t const offHole = lseek(fdSrc, offCur, SEEK_HOLE);
+                if (offHole > offCur)
+                    cbThisCopy = (size_t)RT_MIN((uint64_t)cbThisCopy, (uint64_t)(offHole - offCur));
+            }
+        }
+
+        loff_t  offThisSrc = offSrc + cbCopied;
+        loff_t  offThisDst = offDst + cbCopied;
+        ssize_t cbActual   = MyCopyFileRangeSysCall(fdSrc, &offThisSrc,
                                                     (int)RTFileToNative(hFileDst), &offThisDst,
                                                     cbThisCopy, 0);
         if (cbActual < 0)
@@ -165,7 +211,7 @@ RTDECL(int) RTFileCopyPartEx(RTFILE hFileSrc, RTFOFF offSrc, RTFILE hFileDst, RT
             Assert(rc != 0);
             rc = rc != 0 ? RTErrConvertFromErrno(rc) : VERR_READ_ERROR;
             /* eCryptfs returns EINVAL for copy_file_range(2) */
-            if ((rc != VERR_NOT_SAME_DEVICE && rc != VERR_INVALID_PARAMETER) || cbCopied != 0)
+            if ((rc != VERR_NOT_SAME_DEVICE && rc != VERR_INVALID_PARAMETER) || fCopiedSome)
                 break;
 
             /* Fall back to generic implementation if the syscall refuses to handle the case. */
@@ -184,7 +230,8 @@ RTDECL(int) RTFileCopyPartEx(RTFILE hFileSrc, RTFOFF offSrc, RTFILE hFileDst, RT
             break;
         }
 
-        cbCopied += cbActual;
+        cbCopied   += cbActual;
+        fCopiedSome = true;
     } while (cbCopied < cbToCopy);
 
     if (pcbCopied)
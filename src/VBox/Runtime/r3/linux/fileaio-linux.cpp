@@ -50,6 +50,22 @@
  * compensated if the user of this API implements caching itself. The next
  * limitation is that data buffers must be aligned at a 512 byte boundary or the
  * request will fail.
+ *
+ * Kernels supporting io_uring (5.1+) get a different backend chosen when the
+ * context is created. The requests are queued on the submission ring and the
+ * whole batch given to RTFileAioCtxSubmit() is handed to the kernel with a single
+ * io_uring_enter() call, completions are harvested straight from the shared
+ * completion ring without any syscall. An eventfd registered with the ring is
+ * used for blocking in RTFileAioCtxWait() and kicking the waiter in
+ * RTFileAioCtxWakeup(). io_uring doesn't have the O_DIRECT restriction, buffered
+ * files are processed asynchronously as well. If the ring can't be set up the
+ * context falls back to the io_* syscalls.
+ *
+ * Neither fixed files nor fixed buffers are registered with the ring. The API has
+ * no way to disassociate a file from a context, so a registered file would be kept
+ * open by the ring after RTFileClose() and a recycled descriptor number would map
+ * to the stale slot. The buffers are owned by the caller and change with every
+ * request.
  */
 /** @todo r=bird: What's this about "must be opened with O_DIRECT"? An
  *        explanation would be nice, esp. seeing what Linus is quoted saying
@@ -63,14 +79,20 @@
 #include <iprt/asm.h>
 #include <iprt/mem.h>
 #include <iprt/assert.h>
+#include <iprt/critsect.h>
 #include <iprt/string.h>
 #include <iprt/err.h>
 #include <iprt/log.h>
 #include <iprt/thread.h>
+#include <iprt/time.h>
 #include "internal/fileaio.h"
 
 #include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
 #include <sys/syscall.h>
+#include <sys/uio.h>
 #include <errno.h>
 
 #include <iprt/file.h>
@@ -177,6 +199,198 @@ typedef struct LNXKAIOIOEVENT
 } LNXKAIOIOEVENT, *PLNXKAIOIOEVENT;
 
 
+/** @name The subset of the io_uring kernel interface used here.
+ * See ioqueue-iouringfile-provider.cpp for the complete set of definitions.
+ * @{ */
+#ifdef __NR_io_uring_setup
+# define LNX_IOURING_SYSCALL_SETUP      __NR_io_uring_setup
+#else
+# define LNX_IOURING_SYSCALL_SETUP      425
+#endif
+#ifdef __NR_io_uring_enter
+# define LNX_IOURING_SYSCALL_ENTER      __NR_io_uring_enter
+#else
+# define LNX_IOURING_SYSCALL_ENTER      426
+#endif
+#ifdef __NR_io_uring_register
+# define LNX_IOURING_SYSCALL_REGISTER   __NR_io_uring_register
+#else
+# define LNX_IOURING_SYSCALL_REGISTER   427
+#endif
+
+/** preadv() like request. */
+#define LNX_IOURING_OPC_READV           1
+/** pwritev() like request. */
+#define LNX_IOURING_OPC_WRITEV          2
+/** fsync() like request. */
+#define LNX_IOURING_OPC_FSYNC           3
+
+/** Used to map the submission queue. */
+#define LNX_IOURING_MMAP_OFF_SQ         UINT64_C(0)
+/** Used to map the completion queue. */
+#define LNX_IOURING_MMAP_OFF_CQ         UINT64_C(0x8000000)
+/** Used to map the submission queue entries array. */
+#define LNX_IOURING_MMAP_OFF_SQES       UINT64_C(0x10000000)
+
+/** Register an eventfd associated with the I/O ring. */
+#define LNX_IOURING_REGISTER_OPC_EVENTFD_REGISTER   4
+/** Unregisters an eventfd registered previously. */
+#define LNX_IOURING_REGISTER_OPC_EVENTFD_UNREGISTER 5
+/** @} */
+
+/**
+ * Linux io_uring completion event.
+ */
+typedef struct LNXIOURINGCQE
+{
+    /** Opaque user data associated with the completed request. */
+    uint64_t                    u64User;
+    /** The status code of the request. */
+    int32_t                     rcLnx;
+    /** Some flags which are not used as of now. */
+    uint32_t                    fFlags;
+} LNXIOURINGCQE;
+AssertCompileSize(LNXIOURINGCQE, 16);
+
+/**
+ * Linux io_uring submission queue entry.
+ */
+typedef struct LNXIOURINGSQE
+{
+    /** The opcode for the request. */
+    uint8_t                     u8Opc;
+    /** Common flags for the request. */
+    uint8_t                     u8Flags;
+    /** Assigned I/O priority. */
+    uint16_t                    u16IoPrio;
+    /** The file descriptor the request is for. */
+    int32_t                     i32Fd;
+    /** The start offset into the file for the request. */
+    uint64_t                    u64OffStart;
+    /** Buffer pointer or Pointer to io vector array depending on opcode. */
+    uint64_t                    u64AddrBufIoVec;
+    /** Size of the buffer in bytes or number of io vectors. */
+    uint32_t                    u32BufIoVecSz;
+    /** Opcode dependent flags. */
+    uint32_t                    fOpc;
+    /** Opaque user data associated with the request and returned durign completion. */
+    uint64_t                    u64User;
+    /** Padding to align the structure to 64 bytes. */
+    uint64_t                    au64Padding[3];
+} LNXIOURINGSQE;
+AssertCompileSize(LNXIOURINGSQE, 64);
+/** Pointer to a Linux io_uring submission queue entry. */
+typedef LNXIOURINGSQE *PLNXIOURINGSQE;
+
+/**
+ * Linux io_uring SQ ring offsets returned by io_uring_setup().
+ */
+typedef struct LNXIOURINGSQ
+{
+    uint32_t                    u32OffHead;
+    uint32_t                    u32OffTail;
+    uint32_t                    u32OffRingMask;
+    uint32_t                    u32OffRingEntries;
+    uint32_t                    u32OffFlags;
+    uint32_t                    u32OffDroppedReqs;
+    uint32_t                    u32OffArray;
+    uint32_t                    u32Rsvd0;
+    uint64_t                    u64Rsvd1;
+} LNXIOURINGSQ;
+AssertCompileSize(LNXIOURINGSQ, 40);
+
+/**
+ * Linux io_uring CQ ring offsets returned by io_uring_setup().
+ */
+typedef struct LNXIOURINGCQ
+{
+    uint32_t                    u32OffHead;
+    uint32_t                    u32OffTail;
+    uint32_t                    u32OffRingMask;
+    uint32_t                    u32OffRingEntries;
+    uint32_t                    u32OffOverflowCnt;
+    uint32_t                    u32OffCqes;
+    uint64_t                    au64Rsvd0[2];
+} LNXIOURINGCQ;
+AssertCompileSize(LNXIOURINGCQ, 40);
+
+/**
+ * Linux io_uring parameters passed to io_uring_setup().
+ */
+typedef struct LNXIOURINGPARAMS
+{
+    /** Number of SQ entries requested, must be power of 2. */
+    uint32_t                    u32SqEntriesCnt;
+    /** Number of CQ entries requested, must be power of 2. */
+    uint32_t                    u32CqEntriesCnt;
+    /** Flags for the ring. */
+    uint32_t                    u32Flags;
+    /** Affinity of the kernel side SQ polling thread if enabled. */
+    uint32_t                    u32SqPollCpu;
+    /** Milliseconds after the kernel side SQ polling thread goes to sleep. */
+    uint32_t                    u32SqPollIdleMs;
+    /** Reserved. */
+    uint32_t                    au32Rsvd0[5];
+    /** Offsets returned for the submission queue. */
+    LNXIOURINGSQ                SqOffsets;
+    /** Offsets returned for the completion queue. */
+    LNXIOURINGCQ                CqOffsets;
+} LNXIOURINGPARAMS;
+
+
+/**
+ * io_uring state of a context.
+ *
+ * @note The ring pointers point to memory shared with the kernel, hence the
+ *       volatile keyword.
+ */
+typedef struct RTFILEAIOCTXIOURING
+{
+    /** The io_uring file descriptor. */
+    int                         iFdIoCtx;
+    /** The eventfd file descriptor registered with the ring. */
+    int                         iFdEvt;
+    /** Serializes submitters, the SQ ring has a single producer. */
+    RTCRITSECT                  CritSectSubmit;
+    /** Pointer to the SQ head counter. */
+    volatile uint32_t          *pidxSqHead;
+    /** Pointer to the SQ tail counter. */
+    volatile uint32_t          *pidxSqTail;
+    /** Pointer to the indirection array used for indexing the real SQ entries. */
+    volatile uint32_t          *paidxSqes;
+    /** Mask to apply for the SQ counters to get to the index. */
+    uint32_t                    fSqRingMask;
+    /** Number of entries in the SQ ring. */
+    uint32_t                    cSqEntries;
+    /** Pointer to the CQ head counter. */
+    volatile uint32_t          *pidxCqHead;
+    /** Pointer to the CQ tail counter. */
+    volatile uint32_t          *pidxCqTail;
+    /** Pointer to the completion entry ring. */
+    volatile LNXIOURINGCQE     *paCqes;
+    /** Mask to apply for the CQ counters to get to the index. */
+    uint32_t                    fCqRingMask;
+    /** Number of entries in the CQ ring. */
+    uint32_t                    cCqEntries;
+    /** Pointer to the mapped SQ entries. */
+    PLNXIOURINGSQE              paSqes;
+    /** Pointer returned by mmap() for the SQ ring, used for unmapping. */
+    void                       *pvMMapSqRing;
+    /** Pointer returned by mmap() for the CQ ring, used for unmapping. */
+    void                       *pvMMapCqRing;
+    /** Pointer returned by mmap() for the SQ entries array, used for unmapping. */
+    void                       *pvMMapSqes;
+    /** Size of the mapped SQ ring. */
+    size_t                      cbMMapSqRing;
+    /** Size of the mapped CQ ring. */
+    size_t                      cbMMapCqRing;
+    /** Size of the mapped SQ entries array. */
+    size_t                      cbMMapSqes;
+} RTFILEAIOCTXIOURING;
+/** Pointer to the io_uring state of a context. */
+typedef RTFILEAIOCTXIOURING *PRTFILEAIOCTXIOURING;
+
+
 /**
  * Async I/O completion context state.
  */
@@ -194,10 +408,14 @@ typedef struct RTFILEAIOCTXINTERNAL
     volatile bool       fWokenUp;
     /** Flag whether the thread is currently waiting in the syscall. */
     volatile bool       fWaiting;
+    /** Flag whether the context uses io_uring instead of the io_* syscalls. */
+    bool                fIoUring;
     /** Flags given during creation. */
     uint32_t            fFlags;
     /** Magic value (RTFILEAIOCTX_MAGIC). */
     uint32_t            u32Magic;
+    /** The io_uring state, only valid if fIoUring is set. */
+    RTFILEAIOCTXIOURING IoUring;
 } RTFILEAIOCTXINTERNAL;
 /** Pointer to an internal context structure. */
 typedef RTFILEAIOCTXINTERNAL *PRTFILEAIOCTXINTERNAL;
@@ -220,6 +438,8 @@ typedef struct RTFILEAIOREQINTERNAL
     size_t                cbTransfered;
     /** Completion context we are assigned to. */
     PRTFILEAIOCTXINTERNAL pCtxInt;
+    /** The I/O vector the io_uring READV/WRITEV requests point to. */
+    struct iovec          IoVec;
     /** Magic value  (RTFILEAIOREQ_MAGIC). */
     uint32_t              u32Magic;
 } RTFILEAIOREQINTERNAL;
@@ -303,6 +523,340 @@ DECLINLINE(int) rtFileAsyncIoLinuxGetEvents(LNXKAIOCONTEXT AioContext, long cReq
     return rc;
 }
 
+/**
+ * Submits requests queued on the io_uring SQ ring.
+ * @returns Number of requests consumed by the kernel, IPRT error code (negative).
+ */
+DECLINLINE(int) rtFileAsyncIoLinuxIoUringEnter(int iFdIoCtx, uint32_t cToSubmit)
+{
+    int rc = syscall(LNX_IOURING_SYSCALL_ENTER, iFdIoCtx, cToSubmit, 0 /*cMinComplete*/, 0 /*fFlags*/, NULL, 0);
+    if (RT_UNLIKELY(rc == -1))
+        return RTErrConvertFromErrno(errno);
+
+    return rc;
+}
+
+/**
+ * mmap() wrapper for mapping parts of the io_uring.
+ */
+DECLINLINE(int) rtFileAsyncIoLinuxIoUringMmap(int iFdIoCtx, off_t offMmap, size_t cbMmap, void **ppv)
+{
+    void *pv = mmap(0, cbMmap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, iFdIoCtx, offMmap);
+    if (pv != MAP_FAILED)
+    {
+        *ppv = pv;
+        return VINF_SUCCESS;
+    }
+
+    return RTErrConvertFromErrno(errno);
+}
+
+/**
+ * Tries to set up an io_uring for the given context.
+ *
+ * @returns IPRT status code, the caller falls back to the io_* syscalls on failure.
+ * @param   pCtxInt     The context to set up the ring for.
+ * @param   cAioReqsMax Maximum number of requests the ring must be able to handle.
+ */
+static int rtFileAioCtxLinuxIoUringCreate(PRTFILEAIOCTXINTERNAL pCtxInt, uint32_t cAioReqsMax)
+{
+    PRTFILEAIOCTXIOURING pIoUring = &pCtxInt->IoUring;
+    LNXIOURINGPARAMS Params;
+    RT_ZERO(Params);
+
+    /* The kernel rounds the entry count up to the next power of two. */
+    int iFdIoCtx = syscall(LNX_IOURING_SYSCALL_SETUP, cAioReqsMax, &Params);
+    if (iFdIoCtx == -1)
+        return RTErrConvertFromErrno(errno);
+
+    pIoUring->iFdIoCtx     = iFdIoCtx;
+    pIoUring->cbMMapSqRing = Params.SqOffsets.u32OffArray + Params.u32SqEntriesCnt * sizeof(uint32_t);
+    pIoUring->cbMMapCqRing = Params.CqOffsets.u32OffCqes + Params.u32CqEntriesCnt * sizeof(LNXIOURINGCQE);
+    pIoUring->cbMMapSqes   = Params.u32SqEntriesCnt * sizeof(LNXIOURINGSQE);
+
+    int rc = VINF_SUCCESS;
+    pIoUring->iFdEvt = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (pIoUring->iFdEvt != -1)
+    {
+        if (!syscall(LNX_IOURING_SYSCALL_REGISTER, iFdIoCtx, LNX_IOURING_REGISTER_OPC_EVENTFD_REGISTER, &pIoUring->iFdEvt, 1))
+        {
+            rc = rtFileAsyncIoLinuxIoUringMmap(iFdIoCtx, LNX_IOURING_MMAP_OFF_SQ, pIoUring->cbMMapSqRing, &pIoUring->pvMMapSqRing);
+            if (RT_SUCCESS(rc))
+            {
+                rc = rtFileAsyncIoLinuxIoUringMmap(iFdIoCtx, LNX_IOURING_MMAP_OFF_CQ, pIoUring->cbMMapCqRing, &pIoUring->pvMMapCqRing);
+                if (RT_SUCCESS(rc))
+                {
+                    rc = rtFileAsyncIoLinuxIoUringMmap(iFdIoCtx, LNX_IOURING_MMAP_OFF_SQES, pIoUring->cbMMapSqes, &pIoUring->pvMMapSqes);
+                    if (RT_SUCCESS(rc))
+                    {
+                        rc = RTCritSectInit(&pIoUring->CritSectSubmit);
+                        if (RT_SUCCESS(rc))
+                        {
+                            uint8_t *pbTmp = (uint8_t *)pIoUring->pvMMapSqRing;
+                            pIoUring->pidxSqHead  = (uint32_t *)(pbTmp + Params.SqOffsets.u32OffHead);
+                            pIoUring->pidxSqTail  = (uint32_t *)(pbTmp + Params.SqOffsets.u32OffTail);
+                            pIoUring->fSqRingMask = *(uint32_t *)(pbTmp + Params.SqOffsets.u32OffRingMask);
+                            pIoUring->cSqEntries  = *(uint32_t *)(pbTmp + Params.SqOffsets.u32OffRingEntries);
+                            pIoUring->paidxSqes   = (uint32_t *)(pbTmp + Params.SqOffsets.u32OffArray);
+                            pIoUring->paSqes      = (PLNXIOURINGSQE)pIoUring->pvMMapSqes;
+
+                            pbTmp = (uint8_t *)pIoUring->pvMMapCqRing;
+                            pIoUring->pidxCqHead  = (uint32_t *)(pbTmp + Params.CqOffsets.u32OffHead);
+                            pIoUring->pidxCqTail  = (uint32_t *)(pbTmp + Params.CqOffsets.u32OffTail);
+                            pIoUring->fCqRingMask = *(uint32_t *)(pbTmp + Params.CqOffsets.u32OffRingMask);
+                            pIoUring->cCqEntries  = *(uint32_t *)(pbTmp + Params.CqOffsets.u32OffRingEntries);
+                            pIoUring->paCqes      = (LNXIOURINGCQE *)(pbTmp + Params.CqOffsets.u32OffCqes);
+                            return VINF_SUCCESS;
+                        }
+
+                        munmap(pIoUring->pvMMapSqes, pIoUring->cbMMapSqes);
+                    }
+
+                    munmap(pIoUring->pvMMapCqRing, pIoUring->cbMMapCqRing);
+                }
+
+                munmap(pIoUring->pvMMapSqRing, pIoUring->cbMMapSqRing);
+            }
+        }
+        else
+            rc = RTErrConvertFromErrno(errno);
+
+        close(pIoUring->iFdEvt);
+    }
+    else
+        rc = RTErrConvertFromErrno(errno);
+
+    close(iFdIoCtx);
+    RT_ZERO(*pIoUring);
+    return rc;
+}
+
+/**
+ * Destroys the io_uring of the given context.
+ */
+static void rtFileAioCtxLinuxIoUringDestroy(PRTFILEAIOCTXINTERNAL pCtxInt)
+{
+    PRTFILEAIOCTXIOURING pIoUring = &pCtxInt->IoUring;
+
+    int rcLnx = munmap(pIoUring->pvMMapSqRing, pIoUring->cbMMapSqRing); Assert(!rcLnx);
+    rcLnx = munmap(pIoUring->pvMMapCqRing, pIoUring->cbMMapCqRing); Assert(!rcLnx);
+    rcLnx = munmap(pIoUring->pvMMapSqes, pIoUring->cbMMapSqes); Assert(!rcLnx);
+    rcLnx = syscall(LNX_IOURING_SYSCALL_REGISTER, pIoUring->iFdIoCtx, LNX_IOURING_REGISTER_OPC_EVENTFD_UNREGISTER, NULL, 0);
+    Assert(!rcLnx); RT_NOREF(rcLnx);
+    close(pIoUring->iFdEvt);
+    close(pIoUring->iFdIoCtx);
+    RTCritSectDelete(&pIoUring->CritSectSubmit);
+}
+
+/**
+ * Submits the given requests through the io_uring of the context, see RTFileAioCtxSubmit().
+ *
+ * All requests which fit into the rings are queued and handed to the kernel with a
+ * single syscall. Requests left over are reverted to the prepared state and
+ * VERR_FILE_AIO_INSUFFICIENT_RESSOURCES is returned.
+ */
+static int rtFileAioCtxLinuxIoUringSubmit(PRTFILEAIOCTXINTERNAL pCtxInt, PRTFILEAIOREQ pahReqs, size_t cReqs)
+{
+    PRTFILEAIOCTXIOURING pIoUring = &pCtxInt->IoUring;
+
+    RTCritSectEnter(&pIoUring->CritSectSubmit);
+
+    /*
+     * Only queue what fits into the SQ ring and what can't overflow the CQ ring
+     * when everything in flight completes at once.
+     */
+    uint32_t const idxSqHead = ASMAtomicReadU32(pIoUring->pidxSqHead);
+    uint32_t const idxSqTail = *pIoUring->pidxSqTail;
+    uint32_t const cSqFree   = pIoUring->cSqEntries - (idxSqTail - idxSqHead);
+    int32_t  const cInFlight = ASMAtomicReadS32(&pCtxInt->cRequests);
+    uint32_t const cCqFree   = cInFlight < (int32_t)pIoUring->cCqEntries ? pIoUring->cCqEntries - (uint32_t)cInFlight : 0;
+    uint32_t const cQueue    = (uint32_t)RT_MIN(cReqs, RT_MIN(cSqFree, cCqFree));
+
+    uint32_t idxTail = idxSqTail;
+    for (uint32_t i = 0; i < cQueue; i++)
+    {
+        PRTFILEAIOREQINTERNAL pReqInt = pahReqs[i];
+        uint32_t const idx = idxTail & pIoUring->fSqRingMask;
+        PLNXIOURINGSQE pSqe = &pIoUring->paSqes[idx];
+
+        RT_ZERO(*pSqe);
+        pSqe->i32Fd   = (int32_t)pReqInt->AioCB.uFileDesc;
+        pSqe->u64User = (uint64_t)(uintptr_t)pReqInt;
+        if (pReqInt->AioCB.u16IoOpCode == LNXKAIO_IOCB_CMD_FSYNC)
+            pSqe->u8Opc = LNX_IOURING_OPC_FSYNC;
+        else
+        {
+            pReqInt->IoVec.iov_base = pReqInt->AioCB.pvBuf;
+            pReqInt->IoVec.iov_len  = pReqInt->AioCB.cbTransfer;
+            pSqe->u8Opc           =   pReqInt->AioCB.u16IoOpCode == LNXKAIO_IOCB_CMD_READ
+                                    ? LNX_IOURING_OPC_READV : LNX_IOURING_OPC_WRITEV;
+            pSqe->u64OffStart     = (uint64_t)pReqInt->AioCB.off;
+            pSqe->u64AddrBufIoVec = (uint64_t)(uintptr_t)&pReqInt->IoVec;
+            pSqe->u32BufIoVecSz   = 1;
+        }
+
+        pIoUring->paidxSqes[idx] = idx;
+        idxTail++;
+    }
+
+    int rc = VINF_SUCCESS;
+    uint32_t cSubmitted = 0;
+    if (cQueue)
+    {
+        ASMWriteFence();
+        ASMAtomicWriteU32(pIoUring->pidxSqTail, idxTail);
+        ASMMemoryFence();
+
+        /* Everything goes in with one syscall, retry if the kernel stopped early. */
+        while (cSubmitted < cQueue)
+        {
+            rc = rtFileAsyncIoLinuxIoUringEnter(pIoUring->iFdIoCtx, cQueue - cSubmitted);
+            if (rc <= 0)
+                break;
+            cSubmitted += (uint32_t)rc;
+            rc = VINF_SUCCESS;
+        }
+
+        if (cSubmitted < cQueue)
+        {
+            /*
+             * Take back whatever the kernel didn't consume, nobody else touches
+             * the SQ ring outside of io_uring_enter().
+             */
+            ASMAtomicWriteU32(pIoUring->pidxSqTail, idxSqTail + cSubmitted);
+            if (rc == VERR_TRY_AGAIN || rc == VERR_RESOURCE_BUSY || rc == VINF_SUCCESS)
+                rc = VERR_FILE_AIO_INSUFFICIENT_RESSOURCES;
+        }
+        ASMAtomicAddS32(&pCtxInt->cRequests, (int32_t)cSubmitted);
+    }
+
+    RTCritSectLeave(&pIoUring->CritSectSubmit);
+
+    if (cSubmitted < cReqs)
+    {
+        /* Revert everything not submitted, failing the first one as the io_* path does for hard errors. */
+        for (size_t i = cSubmitted; i < cReqs; i++)
+        {
+            PRTFILEAIOREQINTERNAL pReqInt = pahReqs[i];
+            pReqInt->pCtxInt = NULL;
+            RTFILEAIOREQ_SET_STATE(pReqInt, PREPARED);
+        }
+
+        if (RT_SUCCESS(rc) || rc == VERR_FILE_AIO_INSUFFICIENT_RESSOURCES)
+            rc = VERR_FILE_AIO_INSUFFICIENT_RESSOURCES;
+        else
+        {
+            PRTFILEAIOREQINTERNAL pReqInt = pahReqs[cSubmitted];
+            RTFILEAIOREQ_SET_STATE(pReqInt, COMPLETED);
+            pReqInt->Rc = rc;
+            pReqInt->cbTransfered = 0;
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * Harvests completed requests from the io_uring CQ ring.
+ *
+ * @returns Number of requests harvested.
+ * @param   pCtxInt     The context.
+ * @param   pahReqs     Where to store the completed requests.
+ * @param   cReqs       Maximum number of requests to harvest.
+ */
+static uint32_t rtFileAioCtxLinuxIoUringHarvest(PRTFILEAIOCTXINTERNAL pCtxInt, PRTFILEAIOREQ pahReqs, size_t cReqs)
+{
+    PRTFILEAIOCTXIOURING pIoUring = &pCtxInt->IoUring;
+    uint32_t idxCqHead = *pIoUring->pidxCqHead;
+    uint32_t const idxCqTail = ASMAtomicReadU32(pIoUring->pidxCqTail);
+    ASMReadFence();
+
+    uint32_t cDone = 0;
+    while (   idxCqHead != idxCqTail
+           && cDone < cReqs)
+    {
+        volatile LNXIOURINGCQE *pCqe = &pIoUring->paCqes[idxCqHead & pIoUring->fCqRingMask];
+        PRTFILEAIOREQINTERNAL pReqInt = (PRTFILEAIOREQINTERNAL)(uintptr_t)pCqe->u64User;
+        AssertPtr(pReqInt);
+        Assert(pReqInt->u32Magic == RTFILEAIOREQ_MAGIC);
+
+        int32_t const rcLnx = pCqe->rcLnx;
+        if (RT_UNLIKELY(rcLnx < 0))
+            pReqInt->Rc = RTErrConvertFromErrno(-rcLnx);
+        else
+        {
+            pReqInt->Rc = VINF_SUCCESS;
+            pReqInt->cbTransfered = (size_t)rcLnx;
+        }
+
+        RTFILEAIOREQ_SET_STATE(pReqInt, COMPLETED);
+        pahReqs[cDone++] = (RTFILEAIOREQ)pReqInt;
+        idxCqHead++;
+    }
+
+    ASMWriteFence();
+    ASMAtomicWriteU32(pIoUring->pidxCqHead, idxCqHead);
+    return cDone;
+}
+
+/**
+ * Waits for completed requests on the io_uring of the context, see RTFileAioCtxWait().
+ */
+static int rtFileAioCtxLinuxIoUringWait(PRTFILEAIOCTXINTERNAL pCtxInt, size_t cMinReqs, RTMSINTERVAL cMillies,
+                                        PRTFILEAIOREQ pahReqs, size_t cReqs, uint32_t *pcReqs)
+{
+    PRTFILEAIOCTXIOURING pIoUring = &pCtxInt->IoUring;
+    uint64_t const msStart = cMillies != RT_INDEFINITE_WAIT ? RTTimeMilliTS() : 0;
+
+    /*
+     * Harvest whatever is there and block on the eventfd for more. The kernel
+     * signals the eventfd for every completion posted, so a completion arriving
+     * between harvesting and poll() makes poll() return immediately.
+     */
+    int rc = VINF_SUCCESS;
+    uint32_t cRequestsCompleted = 0;
+    for (;;)
+    {
+        cRequestsCompleted += rtFileAioCtxLinuxIoUringHarvest(pCtxInt, &pahReqs[cRequestsCompleted],
+                                                             cReqs - cRequestsCompleted);
+        if (   cRequestsCompleted >= cMinReqs
+            || pCtxInt->fWokenUp)
+            break;
+
+        int cMsWait = -1;
+        if (cMillies != RT_INDEFINITE_WAIT)
+        {
+            uint64_t const cMsElapsed = RTTimeMilliTS() - msStart;
+            if (cMsElapsed >= cMillies)
+            {
+                rc = VERR_TIMEOUT;
+                break;
+            }
+            cMsWait = (int)RT_MIN(cMillies - cMsElapsed, (uint64_t)INT32_MAX);
+        }
+
+        struct pollfd PollFd;
+        PollFd.fd      = pIoUring->iFdEvt;
+        PollFd.events  = POLLIN;
+        PollFd.revents = 0;
+        int rcLnx = poll(&PollFd, 1, cMsWait);
+        if (rcLnx > 0)
+        {
+            uint64_t uCnt = 0;
+            ssize_t cbRead = read(pIoUring->iFdEvt, &uCnt, sizeof(uCnt)); RT_NOREF(cbRead);
+        }
+        else if (rcLnx == -1 && errno != EINTR)
+        {
+            rc = RTErrConvertFromErrno(errno);
+            break;
+        }
+    }
+
+    *pcReqs = cRequestsCompleted;
+    ASMAtomicSubS32(&pCtxInt->cRequests, (int32_t)cRequestsCompleted);
+    return rc;
+}
+
 RTR3DECL(int) RTFileAioGetLimits(PRTFILEAIOLIMITS pAioLimits)
 {
     int rc = VINF_SUCCESS;
@@ -452,6 +1006,13 @@ RTDECL(int) RTFileAioReqCancel(RTFILEAIOREQ hReq)
     RTFILEAIOREQ_VALID_RETURN(pReqInt);
     RTFILEAIOREQ_STATE_RETURN_RC(pReqInt, SUBMITTED, VERR_FILE_AIO_NOT_SUBMITTED);
 
+    /*
+     * A request submitted through io_uring always posts a completion event,
+     * so it has to be reaped through RTFileAioCtxWait() like any other.
+     */
+    if (pReqInt->pCtxInt && pReqInt->pCtxInt->fIoUring)
+        return VERR_FILE_AIO_IN_PROGRESS;
+
     LNXKAIOIOEVENT AioEvent;
     int rc = rtFileAsyncIoLinuxCancel(pReqInt->AioContext, &pReqInt->AioCB, &AioEvent);
     if (RT_SUCCESS(rc))
@@ -504,8 +1065,15 @@ RTDECL(int) RTFileAioCtxCreate(PRTFILEAIOCTX phAioCtx, uint32_t cAioReqsMax,
     if (RT_UNLIKELY(!pCtxInt))
         return VERR_NO_MEMORY;
 
-    /* Init the event handle. */
-    int rc = rtFileAsyncIoLinuxCreate(cAioReqsMax, &pCtxInt->AioContext);
+    /* Prefer io_uring, falling back to the io_* syscalls on kernels without it. */
+    int rc = rtFileAioCtxLinuxIoUringCreate(pCtxInt, cAioReqsMax);
+    if (RT_SUCCESS(rc))
+        pCtxInt->fIoUring = true;
+    else
+    {
+        LogFlow(("RTFileAioCtxCreate: io_uring setup failed with %Rrc, using the io_* syscalls\n", rc));
+        rc = rtFileAsyncIoLinuxCreate(cAioReqsMax, &pCtxInt->AioContext);
+    }
     if (RT_SUCCESS(rc))
     {
         pCtxInt->fWokenUp     = false;
@@ -536,9 +1104,14 @@ RTDECL(int) RTFileAioCtxDestroy(RTFILEAIOCTX hAioCtx)
         return VERR_FILE_AIO_BUSY;
 
     /* The native bit first, then mark it as dead and free it. */
-    int rc = rtFileAsyncIoLinuxDestroy(pCtxInt->AioContext);
-    if (RT_FAILURE(rc))
-        return rc;
+    if (pCtxInt->fIoUring)
+        rtFileAioCtxLinuxIoUringDestroy(pCtxInt);
+    else
+    {
+        int rc = rtFileAsyncIoLinuxDestroy(pCtxInt->AioContext);
+        if (RT_FAILURE(rc))
+            return rc;
+    }
     ASMAtomicUoWriteU32(&pCtxInt->u32Magic, RTFILEAIOCTX_MAGIC_DEAD);
     RTMemFree(pCtxInt);
 
@@ -605,6 +1178,9 @@ RTDECL(int) RTFileAioCtxSubmit(RTFILEAIOCTX hAioCtx, PRTFILEAIOREQ pahReqs, size
         RTFILEAIOREQ_SET_STATE(pReqInt, SUBMITTED);
     }
 
+    if (pCtxInt->fIoUring)
+        return rtFileAioCtxLinuxIoUringSubmit(pCtxInt, pahReqs, cReqs);
+
     do
     {
         /*
@@ -682,6 +1258,22 @@ RTDECL(int) RTFileAioCtxWait(RTFILEAIOCTX hAioCtx, size_t cMinReqs, RTMSINTERVAL
         && !(pCtxInt->fFlags & RTFILEAIOCTX_FLAGS_WAIT_WITHOUT_PENDING_REQUESTS))
         return VERR_FILE_AIO_NO_REQUEST;
 
+    if (pCtxInt->fIoUring)
+    {
+        if (!cMinReqs)
+            cMinReqs = 1;
+
+        Assert(pCtxInt->hThreadWait == NIL_RTTHREAD);
+        ASMAtomicWriteHandle(&pCtxInt->hThreadWait, RTThreadSelf());
+        int rc = rtFileAioCtxLinuxIoUringWait(pCtxInt, cMinReqs, cMillies, pahReqs, cReqs, pcReqs);
+        ASMAtomicWriteHandle(&pCtxInt->hThreadWait, NIL_RTTHREAD);
+
+        if (   ASMAtomicXchgBool(&pCtxInt->fWokenUp, false)
+            && RT_SUCCESS(rc))
+            rc = VERR_INTERRUPTED;
+        return rc;
+    }
+
     /*
      * Convert the timeout if specified.
      */
@@ -811,6 +1403,19 @@ RTDECL(int) RTFileAioCtxWakeup(RTFILEAIOCTX hAioCtx)
 
     bool fWokenUp    = ASMAtomicXchgBool(&pCtxInt->fWokenUp, true);
 
+    /* The io_uring waiter blocks on the eventfd, a stale count just causes a spurious harvest. */
+    if (pCtxInt->fIoUring)
+    {
+        if (!fWokenUp)
+        {
+            const uint64_t uValAdd = 1;
+            ssize_t rcLnx = write(pCtxInt->IoUring.iFdEvt, &uValAdd, sizeof(uValAdd));
+            if (rcLnx == -1 && errno != EAGAIN)
+                return RTErrConvertFromErrno(errno);
+        }
+        return VINF_SUCCESS;
+    }
+
     /*
      * Read the thread handle before the status flag.
      * If we read the handle after the flag we might
@@ -75,12 +75,14 @@
 #include <iprt/file.h>
 #include <iprt/log.h>
 #include <iprt/mem.h>
+#include <iprt/socket.h>
 #include <iprt/string.h>
 
 #include <errno.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/uio.h>
 
@@ -100,6 +102,13 @@
 /** eventfd2() syscall not associated with io_uring but used for kicking waiters. */
 #define LNX_SYSCALL_EVENTFD2          290
 
+/** Number of slots in the fixed file table registered with the ring. */
+#define LNX_IOURING_FIXED_FILES_MAX   64
+/** Maximum number of buffers which can be registered with the ring. */
+#define LNX_IOURING_FIXED_BUFS_MAX    16
+/** Milliseconds the kernel side SQ polling thread keeps spinning before going to sleep. */
+#define LNX_IOURING_SQPOLL_IDLE_MS    50
+
 
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
@@ -262,6 +271,21 @@ typedef LNXIOURINGPARAMS *PLNXIOURINGPARAMS;
 typedef const LNXIOURINGPARAMS *PCLNXIOURINGPARAMS;
 
 
+/**
+ * Linux io_uring fixed file table update passed to io_uring_register().
+ */
+typedef struct LNXIOURINGFILESUPDATE
+{
+    /** The first slot in the fixed file table to update. */
+    uint32_t                    u32OffStart;
+    /** Reserved. */
+    uint32_t                    u32Rsvd0;
+    /** Pointer to the array of file descriptors, -1 clears a slot. */
+    uint64_t                    u64AddrFds;
+} LNXIOURINGFILESUPDATE;
+AssertCompileSize(LNXIOURINGFILESUPDATE, 16);
+
+
 /** @name LNXIOURINGSQE::u8Opc defined opcodes.
  * @{ */
 /** Opcode to profile the interface, does nothing. */
@@ -359,6 +383,8 @@ typedef const LNXIOURINGPARAMS *PCLNXIOURINGPARAMS;
 #define LNX_IOURING_REGISTER_OPC_EVENTFD_REGISTER   4
 /** Unregisters an eventfd registered previously. */
 #define LNX_IOURING_REGISTER_OPC_EVENTFD_UNREGISTER 5
+/** Updates slots of the fixed set of files registered previously. */
+#define LNX_IOURING_REGISTER_OPC_FILES_UPDATE       6
 /** @} */
 
 
@@ -427,6 +453,8 @@ typedef struct RTIOQUEUEPROVINT
     PLNXIOURINGSQE              paSqes;
     /** Pointer to the iovec structure used for non S/G requests. */
     struct iovec                *paIoVecs;
+    /** Pointer to the msghdr structures used for socket requests, one per SQ entry. */
+    struct msghdr               *paMsgHdrs;
     /** Pointer returned by mmap() for the SQ ring, used for unmapping. */
     void                        *pvMMapSqRing;
     /** Pointer returned by mmap() for the CQ ring, used for unmapping. */
@@ -441,6 +469,16 @@ typedef struct RTIOQUEUEPROVINT
     size_t                      cbMMapSqes;
     /** Flag whether the waiter was woken up externally. */
     volatile bool               fExtIntr;
+    /** Flag whether the kernel polls the submission queue (SQPOLL). */
+    bool                        fSqPoll;
+    /** Flag whether the fixed file table could be registered with the ring. */
+    bool                        fFixedFiles;
+    /** The fixed file table, -1 marks a free slot. */
+    int32_t                     aiFdFixed[LNX_IOURING_FIXED_FILES_MAX];
+    /** Number of buffers registered with the ring. */
+    uint32_t                    cFixedBufs;
+    /** The buffers registered with the ring, the index is the fixed buffer index. */
+    struct iovec                aFixedBufs[LNX_IOURING_FIXED_BUFS_MAX];
 } RTIOQUEUEPROVINT;
 /** Pointer to the internal I/O queue provider instance data. */
 typedef RTIOQUEUEPROVINT *PRTIOQUEUEPROVINT;
@@ -646,7 +684,7 @@ static DECLCALLBACK(bool) rtIoQueueLnxIoURingFileProv_IsSupported(void)
 static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_QueueInit(RTIOQUEUEPROV hIoQueueProv, uint32_t fFlags,
                                                                uint32_t cSqEntries, uint32_t cCqEntries)
 {
-    RT_NOREF(fFlags, cCqEntries);
+    RT_NOREF(cCqEntries);
 
     PRTIOQUEUEPROVINT pThis = hIoQueueProv;
     LNXIOURINGPARAMS Params;
@@ -654,8 +692,33 @@ static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_QueueInit(RTIOQUEUEPROV hIo
 
     pThis->cSqesToCommit = 0;
     pThis->fExtIntr      = false;
+    pThis->fSqPoll       = false;
+    pThis->fFixedFiles   = false;
+    pThis->cFixedBufs    = 0;
+    for (unsigned i = 0; i < RT_ELEMENTS(pThis->aiFdFixed); i++)
+        pThis->aiFdFixed[i] = -1;
+
+    int rc = VERR_NOT_SUPPORTED;
+    if (fFlags & RTIOQUEUE_F_SQPOLL)
+    {
+        /*
+         * Needs CAP_SYS_NICE on older kernels, so fall back to the normal
+         * ring if the kernel refuses.
+         */
+        Params.u32Flags        = LNX_IOURING_SETUP_F_SQPOLL;
+        Params.u32SqPollIdleMs = LNX_IOURING_SQPOLL_IDLE_MS;
+        rc = rtIoQueueLnxIoURingSetup(cSqEntries, &Params, &pThis->iFdIoCtx);
+        if (RT_SUCCESS(rc))
+            pThis->fSqPoll = true;
+        else
+        {
+            LogRel(("IoQueue/IoURing: Creating a SQPOLL ring failed with %Rrc, falling back to normal mode\n", rc));
+            RT_ZERO(Params);
+        }
+    }
 
-    int rc = rtIoQueueLnxIoURingSetup(cSqEntries, &Params, &pThis->iFdIoCtx);
+    if (!pThis->fSqPoll)
+        rc = rtIoQueueLnxIoURingSetup(cSqEntries, &Params, &pThis->iFdIoCtx);
     if (RT_SUCCESS(rc))
     {
         /* Map the rings into userspace. */
@@ -663,8 +726,9 @@ static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_QueueInit(RTIOQUEUEPROV hIo
         pThis->cbMMapCqRing = Params.CqOffsets.u32OffCqes + Params.u32CqEntriesCnt * sizeof(LNXIOURINGCQE);
         pThis->cbMMapSqes   = Params.u32SqEntriesCnt * sizeof(LNXIOURINGSQE);
 
-        pThis->paIoVecs = (struct iovec *)RTMemAllocZ(Params.u32SqEntriesCnt * sizeof(struct iovec));
-        if (RT_LIKELY(pThis->paIoVecs))
+        pThis->paIoVecs  = (struct iovec *)RTMemAllocZ(Params.u32SqEntriesCnt * sizeof(struct iovec));
+        pThis->paMsgHdrs = (struct msghdr *)RTMemAllocZ(Params.u32SqEntriesCnt * sizeof(struct msghdr));
+        if (RT_LIKELY(pThis->paIoVecs && pThis->paMsgHdrs))
         {
             rc = rtIoQueueLnxEventfd2(0 /*uValInit*/, 0 /*fFlags*/, &pThis->iFdEvt);
             if (RT_SUCCESS(rc))
@@ -700,6 +764,15 @@ static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_QueueInit(RTIOQUEUEPROV hIo
                                 pThis->Cq.fRingMask = *(uint32_t *)(pbTmp + Params.CqOffsets.u32OffRingMask);
                                 pThis->Cq.cEntries  = *(uint32_t *)(pbTmp + Params.CqOffsets.u32OffRingEntries);
                                 pThis->Cq.paCqes    = (PLNXIOURINGCQE)(pbTmp + Params.CqOffsets.u32OffCqes);
+
+                                /*
+                                 * Register an empty fixed file table which gets populated when handles
+                                 * are registered, saves the kernel the file lookup for every request.
+                                 * Not having it is no reason to fail.
+                                 */
+                                int rc2 = rtIoQueueLnxIoURingRegister(pThis->iFdIoCtx, LNX_IOURING_REGISTER_OPC_FILES_REGISTER,
+                                                                      &pThis->aiFdFixed[0], RT_ELEMENTS(pThis->aiFdFixed));
+                                pThis->fFixedFiles = RT_SUCCESS(rc2);
                                 return VINF_SUCCESS;
                             }
 
@@ -709,15 +782,18 @@ static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_QueueInit(RTIOQUEUEPROV hIo
                         munmap(pThis->pvMMapSqRing, pThis->cbMMapSqRing);
                     }
 
-                    rc = rtIoQueueLnxIoURingRegister(pThis->iFdIoCtx, LNX_IOURING_REGISTER_OPC_EVENTFD_UNREGISTER, NULL, 0);
-                    AssertRC(rc);
+                    int rc2 = rtIoQueueLnxIoURingRegister(pThis->iFdIoCtx, LNX_IOURING_REGISTER_OPC_EVENTFD_UNREGISTER, NULL, 0);
+                    AssertRC(rc2);
                 }
 
                 close(pThis->iFdEvt);
             }
-
-            RTMemFree(pThis->paIoVecs);
         }
+        else
+            rc = VERR_NO_MEMORY;
+
+        RTMemFree(pThis->paIoVecs);
+        RTMemFree(pThis->paMsgHdrs);
 
         int rcLnx = close(pThis->iFdIoCtx); Assert(!rcLnx); RT_NOREF(rcLnx);
     }
@@ -738,19 +814,189 @@ static DECLCALLBACK(void) rtIoQueueLnxIoURingFileProv_QueueDestroy(RTIOQUEUEPROV
     int rc = rtIoQueueLnxIoURingRegister(pThis->iFdIoCtx, LNX_IOURING_REGISTER_OPC_EVENTFD_UNREGISTER, NULL, 0);
     AssertRC(rc);
 
+    if (pThis->fFixedFiles)
+    {
+        rc = rtIoQueueLnxIoURingRegister(pThis->iFdIoCtx, LNX_IOURING_REGISTER_OPC_FILES_UNREGISTER, NULL, 0);
+        AssertRC(rc);
+    }
+
+    if (pThis->cFixedBufs)
+    {
+        rc = rtIoQueueLnxIoURingRegister(pThis->iFdIoCtx, LNX_IOURING_REGISTER_OPC_BUFFERS_UNREGISTER, NULL, 0);
+        AssertRC(rc);
+    }
+
     close(pThis->iFdEvt);
     close(pThis->iFdIoCtx);
     RTMemFree(pThis->paIoVecs);
+    RTMemFree(pThis->paMsgHdrs);
 
     RT_ZERO(pThis);
 }
 
 
+/**
+ * Updates the given slot of the fixed file table.
+ *
+ * @returns IPRT status code.
+ * @param   pThis               The provider instance.
+ * @param   idxSlot             The slot to update.
+ * @param   iFd                 The file descriptor to set, -1 to clear the slot.
+ */
+static int rtIoQueueLnxIoURingFileProvFixedFileUpdate(PRTIOQUEUEPROVINT pThis, uint32_t idxSlot, int32_t iFd)
+{
+    LNXIOURINGFILESUPDATE Upd;
+    RT_ZERO(Upd);
+    Upd.u32OffStart = idxSlot;
+    Upd.u64AddrFds  = (uint64_t)(uintptr_t)&iFd;
+    return rtIoQueueLnxIoURingRegister(pThis->iFdIoCtx, LNX_IOURING_REGISTER_OPC_FILES_UPDATE, &Upd, 1 /*cArgs*/);
+}
+
+
+/**
+ * Returns the fixed file table slot for the given file descriptor.
+ *
+ * @returns Slot index or UINT32_MAX if the descriptor is not in the table.
+ * @param   pThis               The provider instance.
+ * @param   iFd                 The file descriptor to look for.
+ */
+DECLINLINE(uint32_t) rtIoQueueLnxIoURingFileProvFixedFileLookup(PRTIOQUEUEPROVINT pThis, int32_t iFd)
+{
+    for (uint32_t i = 0; i < RT_ELEMENTS(pThis->aiFdFixed); i++)
+        if (pThis->aiFdFixed[i] == iFd)
+            return i;
+    return UINT32_MAX;
+}
+
+
+/**
+ * Returns the native file descriptor of the given file or socket handle.
+ *
+ * @returns File descriptor.
+ * @param   pHandle             The handle.
+ */
+DECLINLINE(int32_t) rtIoQueueLnxIoURingFileProvHandleToFd(PCRTHANDLE pHandle)
+{
+    if (pHandle->enmType == RTHANDLETYPE_SOCKET)
+        return (int32_t)RTSocketToNative(pHandle->u.hSocket);
+    return (int32_t)RTFileToNative(pHandle->u.hFile);
+}
+
+
+/**
+ * Replaces the set of buffers registered with the ring with the current content
+ * of RTIOQUEUEPROVINT::aFixedBufs.
+ *
+ * @returns IPRT status code.
+ * @param   pThis               The provider instance.
+ * @param   cFixedBufsOld       Number of buffers currently registered with the ring.
+ */
+static int rtIoQueueLnxIoURingFileProvFixedBufsSync(PRTIOQUEUEPROVINT pThis, uint32_t cFixedBufsOld)
+{
+    /* The kernel can only replace the whole set at once without the update opcodes of newer kernels. */
+    if (cFixedBufsOld)
+    {
+        int rc = rtIoQueueLnxIoURingRegister(pThis->iFdIoCtx, LNX_IOURING_REGISTER_OPC_BUFFERS_UNREGISTER, NULL, 0);
+        AssertRCReturn(rc, rc);
+    }
+
+    if (!pThis->cFixedBufs)
+        return VINF_SUCCESS;
+    return rtIoQueueLnxIoURingRegister(pThis->iFdIoCtx, LNX_IOURING_REGISTER_OPC_BUFFERS_REGISTER,
+                                       &pThis->aFixedBufs[0], pThis->cFixedBufs);
+}
+
+
+/** @interface_method_impl{RTIOQUEUEPROVVTABLE,pfnBufferRegister} */
+static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_BufferRegister(RTIOQUEUEPROV hIoQueueProv, void *pvBuf, size_t cbBuf)
+{
+    PRTIOQUEUEPROVINT pThis = hIoQueueProv;
+
+    if (pThis->cFixedBufs == RT_ELEMENTS(pThis->aFixedBufs))
+        return VERR_OUT_OF_RESOURCES;
+
+    uint32_t const cFixedBufsOld = pThis->cFixedBufs;
+    pThis->aFixedBufs[pThis->cFixedBufs].iov_base = pvBuf;
+    pThis->aFixedBufs[pThis->cFixedBufs].iov_len  = cbBuf;
+    pThis->cFixedBufs++;
+
+    int rc = rtIoQueueLnxIoURingFileProvFixedBufsSync(pThis, cFixedBufsOld);
+    if (RT_FAILURE(rc))
+    {
+        /* Usually RLIMIT_MEMLOCK being too low, restore the previous set. */
+        LogRel(("IoQueue/IoURing: Registering buffer %p LB %#zx failed with %Rrc\n", pvBuf, cbBuf, rc));
+        pThis->cFixedBufs--;
+        int rc2 = rtIoQueueLnxIoURingFileProvFixedBufsSync(pThis, 0 /*cFixedBufsOld*/);
+        AssertRC(rc2);
+    }
+
+    return rc;
+}
+
+
+/** @interface_method_impl{RTIOQUEUEPROVVTABLE,pfnBufferDeregister} */
+static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_BufferDeregister(RTIOQUEUEPROV hIoQueueProv, void *pvBuf)
+{
+    PRTIOQUEUEPROVINT pThis = hIoQueueProv;
+
+    for (uint32_t i = 0; i < pThis->cFixedBufs; i++)
+        if (pThis->aFixedBufs[i].iov_base == pvBuf)
+        {
+            uint32_t const cFixedBufsOld = pThis->cFixedBufs;
+            if (i < pThis->cFixedBufs - 1)
+                memmove(&pThis->aFixedBufs[i], &pThis->aFixedBufs[i + 1],
+                        (pThis->cFixedBufs - i - 1) * sizeof(pThis->aFixedBufs[0]));
+            pThis->cFixedBufs--;
+            return rtIoQueueLnxIoURingFileProvFixedBufsSync(pThis, cFixedBufsOld);
+        }
+
+    return VERR_NOT_FOUND;
+}
+
+
+/**
+ * Returns the index of the registered buffer completely containing the given range.
+ *
+ * @returns Fixed buffer index or UINT32_MAX if the range isn't covered by a registered buffer.
+ * @param   pThis               The provider instance.
+ * @param   pvBuf               Start of the range.
+ * @param   cbBuf               Size of the range in bytes.
+ */
+DECLINLINE(uint32_t) rtIoQueueLnxIoURingFileProvFixedBufLookup(PRTIOQUEUEPROVINT pThis, void *pvBuf, size_t cbBuf)
+{
+    uintptr_t const uBuf = (uintptr_t)pvBuf;
+    for (uint32_t i = 0; i < pThis->cFixedBufs; i++)
+    {
+        uintptr_t const uFixed = (uintptr_t)pThis->aFixedBufs[i].iov_base;
+        if (   uBuf >= uFixed
+            && uBuf - uFixed + cbBuf <= pThis->aFixedBufs[i].iov_len)
+            return i;
+    }
+    return UINT32_MAX;
+}
+
+
 /** @interface_method_impl{RTIOQUEUEPROVVTABLE,pfnHandleRegister} */
 static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_HandleRegister(RTIOQUEUEPROV hIoQueueProv, PCRTHANDLE pHandle)
 {
-    RT_NOREF(hIoQueueProv, pHandle);
-    /** @todo Add support for fixed file sets later. */
+    PRTIOQUEUEPROVINT pThis = hIoQueueProv;
+
+    /*
+     * A full table or a failing update just means the handle is used
+     * by its plain descriptor, so this can't fail.
+     */
+    if (pThis->fFixedFiles)
+    {
+        uint32_t idxSlot = rtIoQueueLnxIoURingFileProvFixedFileLookup(pThis, -1);
+        if (idxSlot != UINT32_MAX)
+        {
+            int32_t iFd = rtIoQueueLnxIoURingFileProvHandleToFd(pHandle);
+            int rc = rtIoQueueLnxIoURingFileProvFixedFileUpdate(pThis, idxSlot, iFd);
+            if (RT_SUCCESS(rc))
+                pThis->aiFdFixed[idxSlot] = iFd;
+        }
+    }
+
     return VINF_SUCCESS;
 }
 
@@ -758,8 +1004,20 @@ static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_HandleRegister(RTIOQUEUEPRO
 /** @interface_method_impl{RTIOQUEUEPROVVTABLE,pfnHandleDeregister} */
 static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_HandleDeregister(RTIOQUEUEPROV hIoQueueProv, PCRTHANDLE pHandle)
 {
-    RT_NOREF(hIoQueueProv, pHandle);
-    /** @todo Add support for fixed file sets later. */
+    PRTIOQUEUEPROVINT pThis = hIoQueueProv;
+
+    if (pThis->fFixedFiles)
+    {
+        int32_t iFd = rtIoQueueLnxIoURingFileProvHandleToFd(pHandle);
+        uint32_t idxSlot = rtIoQueueLnxIoURingFileProvFixedFileLookup(pThis, iFd);
+        if (idxSlot != UINT32_MAX)
+        {
+            int rc = rtIoQueueLnxIoURingFileProvFixedFileUpdate(pThis, idxSlot, -1);
+            AssertRC(rc);
+            pThis->aiFdFixed[idxSlot] = -1;
+        }
+    }
+
     return VINF_SUCCESS;
 }
 
@@ -779,31 +1037,74 @@ static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_ReqPrepare(RTIOQUEUEPROV hI
     pIoVec->iov_base = pvBuf;
     pIoVec->iov_len  = cbBuf;
 
-    pSqe->u8Flags         = 0;
+    int32_t iFd = rtIoQueueLnxIoURingFileProvHandleToFd(pHandle);
+    uint32_t idxSlot = pThis->fFixedFiles ? rtIoQueueLnxIoURingFileProvFixedFileLookup(pThis, iFd) : UINT32_MAX;
+
+    pSqe->u8Flags         = idxSlot != UINT32_MAX ? LNX_IOURING_SQE_F_FIXED_FILE : 0;
     pSqe->u16IoPrio       = 0;
-    pSqe->i32Fd           = (int32_t)RTFileToNative(pHandle->u.hFile);
+    pSqe->i32Fd           = idxSlot != UINT32_MAX ? (int32_t)idxSlot : iFd;
     pSqe->u64OffStart     = off;
     pSqe->u64AddrBufIoVec = (uint64_t)(uintptr_t)pIoVec;
     pSqe->u32BufIoVecSz   = 1;
     pSqe->u64User         = (uint64_t)(uintptr_t)pvUser;
+    pSqe->uReq.au64Padding[0] = 0;
 
-    switch (enmOp)
+    if (pHandle->enmType == RTHANDLETYPE_SOCKET)
+    {
+        /* Sockets have no offset and no sync, reads and writes map to recvmsg()/sendmsg(). */
+        struct msghdr *pMsgHdr = &pThis->paMsgHdrs[idx];
+        RT_ZERO(*pMsgHdr);
+        pMsgHdr->msg_iov    = pIoVec;
+        pMsgHdr->msg_iovlen = 1;
+
+        pSqe->u64OffStart     = 0;
+        pSqe->u64AddrBufIoVec = (uint64_t)(uintptr_t)pMsgHdr;
+        switch (enmOp)
+        {
+            case RTIOQUEUEOP_READ:
+                pSqe->u8Opc            = LNX_IOURING_OPC_RECVMSG;
+                pSqe->uOpc.u32MsgFlags = 0;
+                break;
+            case RTIOQUEUEOP_WRITE:
+                pSqe->u8Opc            = LNX_IOURING_OPC_SENDMSG;
+                pSqe->uOpc.u32MsgFlags = MSG_NOSIGNAL;
+                break;
+            default:
+                AssertMsgFailedReturn(("Invalid I/O queue operation for a socket: %d\n", enmOp),
+                                      VERR_INVALID_PARAMETER);
+        }
+    }
+    else
     {
-        case RTIOQUEUEOP_READ:
-            pSqe->u8Opc               = LNX_IOURING_OPC_READV;
-            pSqe->uOpc.u32KrnlRwFlags = 0;
-            break;
-        case RTIOQUEUEOP_WRITE:
-            pSqe->u8Opc               = LNX_IOURING_OPC_WRITEV;
-            pSqe->uOpc.u32KrnlRwFlags = 0;
-            break;
-        case RTIOQUEUEOP_SYNC:
-            pSqe->u8Opc              = LNX_IOURING_OPC_FSYNC;
-            pSqe->uOpc.u32FsyncFlags = 0;
-            break;
-        default:
-            AssertMsgFailedReturn(("Invalid I/O queue operation: %d\n", enmOp),
-                                  VERR_INVALID_PARAMETER);
+        /* Buffers within a registered one skip the page lookup in the kernel. */
+        uint32_t const idxBuf =   enmOp != RTIOQUEUEOP_SYNC
+                                ? rtIoQueueLnxIoURingFileProvFixedBufLookup(pThis, pvBuf, cbBuf)
+                                : UINT32_MAX;
+        if (idxBuf != UINT32_MAX)
+        {
+            pSqe->u64AddrBufIoVec     = (uint64_t)(uintptr_t)pvBuf;
+            pSqe->u32BufIoVecSz       = (uint32_t)cbBuf;
+            pSqe->uReq.u16FixedBufIdx = (uint16_t)idxBuf;
+        }
+
+        switch (enmOp)
+        {
+            case RTIOQUEUEOP_READ:
+                pSqe->u8Opc               = idxBuf != UINT32_MAX ? LNX_IOURING_OPC_READ_FIXED : LNX_IOURING_OPC_READV;
+                pSqe->uOpc.u32KrnlRwFlags = 0;
+                break;
+            case RTIOQUEUEOP_WRITE:
+                pSqe->u8Opc               = idxBuf != UINT32_MAX ? LNX_IOURING_OPC_WRITE_FIXED : LNX_IOURING_OPC_WRITEV;
+                pSqe->uOpc.u32KrnlRwFlags = 0;
+                break;
+            case RTIOQUEUEOP_SYNC:
+                pSqe->u8Opc              = LNX_IOURING_OPC_FSYNC;
+                pSqe->uOpc.u32FsyncFlags = 0;
+                break;
+            default:
+                AssertMsgFailedReturn(("Invalid I/O queue operation: %d\n", enmOp),
+                                      VERR_INVALID_PARAMETER);
+        }
     }
 
     pThis->Sq.paidxSqes[idx] = idx;
@@ -820,9 +1121,17 @@ static DECLCALLBACK(int) rtIoQueueLnxIoURingFileProv_Commit(RTIOQUEUEPROV hIoQue
 
     ASMWriteFence();
     ASMAtomicWriteU32(pThis->Sq.pidxTail, pThis->idxSqTail);
-    ASMWriteFence();
+    ASMMemoryFence();
 
-    int rc = rtIoQueueLnxIoURingEnter(pThis->iFdIoCtx, pThis->cSqesToCommit, 0, 0 /*fFlags*/);
+    /*
+     * With the kernel polling the submission queue the syscall is only required
+     * to wake up the polling thread after it went to sleep.
+     */
+    int rc = VINF_SUCCESS;
+    if (!pThis->fSqPoll)
+        rc = rtIoQueueLnxIoURingEnter(pThis->iFdIoCtx, pThis->cSqesToCommit, 0, 0 /*fFlags*/);
+    else if (ASMAtomicReadU32(pThis->Sq.pfFlags) & LNX_IOURING_SQ_RING_F_NEED_WAKEUP)
+        rc = rtIoQueueLnxIoURingEnter(pThis->iFdIoCtx, pThis->cSqesToCommit, 0, LNX_IOURING_ENTER_F_SQ_WAKEUP);
     if (RT_SUCCESS(rc))
     {
         *pcReqsCommitted = pThis->cSqesToCommit;
@@ -924,6 +1233,55 @@ RT_DECL_DATA_CONST(RTIOQUEUEPROVVTABLE const) g_RTIoQueueLnxIoURingProv =
     rtIoQueueLnxIoURingFileProv_HandleRegister,
     /** pfnHandleDeregister */
     rtIoQueueLnxIoURingFileProv_HandleDeregister,
+    /** pfnBufferRegister */
+    rtIoQueueLnxIoURingFileProv_BufferRegister,
+    /** pfnBufferDeregister */
+    rtIoQueueLnxIoURingFileProv_BufferDeregister,
+    /** pfnReqPrepare */
+    rtIoQueueLnxIoURingFileProv_ReqPrepare,
+    /** pfnReqPrepareSg */
+    NULL,
+    /** pfnCommit */
+    rtIoQueueLnxIoURingFileProv_Commit,
+    /** pfnEvtWait */
+    rtIoQueueLnxIoURingFileProv_EvtWait,
+    /** pfnEvtWaitWakeup */
+    rtIoQueueLnxIoURingFileProv_EvtWaitWakeup,
+    /** uEndMarker */
+    RTIOQUEUEPROVVTABLE_VERSION
+};
+
+
+/**
+ * Async socket I/O queue provider virtual method table, shares the implementation
+ * with the file provider.
+ */
+RT_DECL_DATA_CONST(RTIOQUEUEPROVVTABLE const) g_RTIoQueueLnxIoURingSocketProv =
+{
+    /** uVersion */
+    RTIOQUEUEPROVVTABLE_VERSION,
+    /** pszId */
+    "LnxIoURingSocket",
+    /** cbIoQueueProv */
+    sizeof(RTIOQUEUEPROVINT),
+    /** enmHnd */
+    RTHANDLETYPE_SOCKET,
+    /** fFlags */
+    0,
+    /** pfnIsSupported */
+    rtIoQueueLnxIoURingFileProv_IsSupported,
+    /** pfnQueueInit  */
+    rtIoQueueLnxIoURingFileProv_QueueInit,
+    /** pfnQueueDestroy */
+    rtIoQueueLnxIoURingFileProv_QueueDestroy,
+    /** pfnHandleRegister */
+    rtIoQueueLnxIoURingFileProv_HandleRegister,
+    /** pfnHandleDeregister */
+    rtIoQueueLnxIoURingFileProv_HandleDeregister,
+    /** pfnBufferRegister */
+    NULL,
+    /** pfnBufferDeregister */
+    NULL,
     /** pfnReqPrepare */
     rtIoQueueLnxIoURingFileProv_ReqPrepare,
     /** pfnReqPrepareSg */
@@ -0,0 +1,991 @@
+/* $Id$ */
+/** @file
+ * IPRT - Read-Write Semaphore, Linux (2.6.x+).
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#include <iprt/semaphore.h>
+#include "internal/iprt.h"
+
+#include <iprt/asm.h>
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include <iprt/lockvalidator.h>
+#include <iprt/mem.h>
+#include <iprt/thread.h>
+#include <iprt/time.h>
+#include "internal/magics.h"
+#include "internal/strict.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#if 0 /* With 2.6.17 futex.h has become C++ unfriendly. */
+# include <linux/futex.h>
+#else
+# define FUTEX_WAIT             0
+# define FUTEX_WAKE             1
+# define FUTEX_PRIVATE_FLAG     128
+#endif
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+AssertCompileSize(pthread_t, sizeof(void *));
+#define ATOMIC_GET_PTHREAD_T(ppvVar, pThread) do { *(pThread) = (pthread_t)ASMAtomicReadPtr((void * volatile *)ppvVar); } while (0)
+#define ATOMIC_SET_PTHREAD_T(ppvVar, pThread) ASMAtomicWritePtr((void * volatile *)ppvVar, (void *)pThread)
+
+/** @name RTSEMRWINTERNAL::u32State bits.
+ * @{ */
+/** The number of readers owning the semaphore. */
+#define RTSEMRW_LNX_RD_MASK         UINT32_C(0x000fffff)
+/** The number of writers waiting for the semaphore. */
+#define RTSEMRW_LNX_WRW_MASK        UINT32_C(0x3ff00000)
+/** One waiting writer. */
+#define RTSEMRW_LNX_WRW_ONE         UINT32_C(0x00100000)
+/** One or more readers are sleeping on RTSEMRWINTERNAL::u32ReadSeq. */
+#define RTSEMRW_LNX_RD_WAITERS      UINT32_C(0x40000000)
+/** Owned by a writer. */
+#define RTSEMRW_LNX_WR_LOCKED       UINT32_C(0x80000000)
+/** @} */
+
+/** The minimum number of spins before going to sleep (multi-CPU only). */
+#define RTSEMRW_LNX_SPIN_MIN        UINT32_C(16)
+/** The maximum number of spins before going to sleep. */
+#define RTSEMRW_LNX_SPIN_MAX        UINT32_C(256)
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * Linux internal representation of a read-write semaphore.
+ *
+ * The semaphore prefers writers: a reader does not get in while a writer is
+ * waiting.  The exception are threads already owning read access to some
+ * RTSemRW, as read recursion (or a reader waiting on a second semaphore the
+ * writer is about to take) would otherwise deadlock.
+ */
+struct RTSEMRWINTERNAL
+{
+    /** The usual magic. (RTSEMRW_MAGIC) */
+    uint32_t            u32Magic;
+    /** Whether to spin a little before going to sleep. */
+    bool                fSpin;
+    /** The lock state, see RTSEMRW_LNX_XXX. */
+    uint32_t volatile   u32State;
+    /** Futex the readers sleep on, incremented before waking them. */
+    uint32_t volatile   u32ReadSeq;
+    /** Futex the writers sleep on, incremented before waking one of them. */
+    uint32_t volatile   u32WriteSeq;
+    /** The running average of spins it took to get the semaphore. */
+    uint32_t volatile   cSpinAvg;
+    /** Number of write recursions. */
+    uint32_t            cWrites;
+    /** Number of read recursions by the writer. */
+    uint32_t            cWriterReads;
+    /** The write owner of the lock. */
+    volatile pthread_t  Writer;
+#ifdef RTSEMRW_STRICT
+    /** The validator record for the writer. */
+    RTLOCKVALRECEXCL    ValidatorWrite;
+    /** The validator record for the readers. */
+    RTLOCKVALRECSHRD    ValidatorRead;
+#endif
+};
+
+
+/*********************************************************************************************************************************
+*   Global Variables                                                                                                             *
+*********************************************************************************************************************************/
+/** The number of read locks the calling thread owns, on any semaphore.
+ * Only used for deciding whether a reader may overtake waiting writers. */
+static __thread uint32_t g_cRTSemRWLnxReadsHeld = 0;
+
+
+
+/**
+ * Wrapper for the futex syscall.
+ */
+static long sys_futex(uint32_t volatile *uaddr, int op, int val, struct timespec *utime, int32_t *uaddr2, int val3)
+{
+    errno = 0;
+    long rc = syscall(__NR_futex, uaddr, op, val, utime, uaddr2, val3);
+    if (rc < 0)
+    {
+        Assert(rc == -1);
+        rc = -errno;
+    }
+    return rc;
+}
+
+
+/**
+ * Wakes up all sleeping readers.
+ */
+static void rtSemRWLnxWakeReaders(struct RTSEMRWINTERNAL *pThis)
+{
+    ASMAtomicIncU32(&pThis->u32ReadSeq);
+    sys_futex(&pThis->u32ReadSeq, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX, NULL, NULL, 0);
+}
+
+
+/**
+ * Wakes up one sleeping writer.
+ */
+static void rtSemRWLnxWakeWriter(struct RTSEMRWINTERNAL *pThis)
+{
+    ASMAtomicIncU32(&pThis->u32WriteSeq);
+    sys_futex(&pThis->u32WriteSeq, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, NULL, NULL, 0);
+}
+
+
+/**
+ * Gets the number of times to spin before going to sleep.
+ */
+DECLINLINE(uint32_t) rtSemRWLnxSpinMax(struct RTSEMRWINTERNAL *pThis)
+{
+    if (!pThis->fSpin)
+        return 0;
+    return RT_MIN(ASMAtomicUoReadU32(&pThis->cSpinAvg) * 2 + RTSEMRW_LNX_SPIN_MIN, RTSEMRW_LNX_SPIN_MAX);
+}
+
+
+/**
+ * Updates the spin average after the semaphore was acquired in the slow path.
+ */
+DECLINLINE(void) rtSemRWLnxSpinUpdate(struct RTSEMRWINTERNAL *pThis, uint32_t cSpins)
+{
+    if (pThis->fSpin)
+    {
+        int32_t const iAvg = (int32_t)ASMAtomicUoReadU32(&pThis->cSpinAvg);
+        ASMAtomicUoWriteU32(&pThis->cSpinAvg, (uint32_t)(iAvg + ((int32_t)cSpins - iAvg) / 8));
+    }
+}
+
+
+/**
+ * Calculates the relative timeout for the next futex wait.
+ *
+ * @returns false if the timeout has expired, true if we should wait.
+ * @param   pTs         Where to return the relative timeout.
+ * @param   u64End      The RTTimeSystemNanoTS deadline.
+ */
+DECLINLINE(bool) rtSemRWLnxCalcTimeout(struct timespec *pTs, uint64_t u64End)
+{
+    int64_t i64Diff = u64End - RTTimeSystemNanoTS();
+    if (i64Diff < 1000)
+        return false;
+    pTs->tv_sec  = (uint64_t)i64Diff / UINT32_C(1000000000);
+    pTs->tv_nsec = (uint64_t)i64Diff % UINT32_C(1000000000);
+    return true;
+}
+
+
+#undef RTSemRWCreate
+RTDECL(int) RTSemRWCreate(PRTSEMRW phRWSem)
+{
+    return RTSemRWCreateEx(phRWSem, 0 /*fFlags*/, NIL_RTLOCKVALCLASS, RTLOCKVAL_SUB_CLASS_NONE, "RTSemRW");
+}
+
+
+RTDECL(int) RTSemRWCreateEx(PRTSEMRW phRWSem, uint32_t fFlags,
+                            RTLOCKVALCLASS hClass, uint32_t uSubClass, const char *pszNameFmt, ...)
+{
+    AssertReturn(!(fFlags & ~RTSEMRW_FLAGS_NO_LOCK_VAL), VERR_INVALID_PARAMETER);
+
+    /*
+     * Allocate handle.
+     */
+    struct RTSEMRWINTERNAL *pThis = (struct RTSEMRWINTERNAL *)RTMemAlloc(sizeof(struct RTSEMRWINTERNAL));
+    if (!pThis)
+        return VERR_NO_MEMORY;
+
+    pThis->u32Magic     = RTSEMRW_MAGIC;
+    pThis->fSpin        = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+    pThis->u32State     = 0;
+    pThis->u32ReadSeq   = 0;
+    pThis->u32WriteSeq  = 0;
+    pThis->cSpinAvg     = 0;
+    pThis->cWrites      = 0;
+    pThis->cWriterReads = 0;
+    pThis->Writer       = (pthread_t)-1;
+#ifdef RTSEMRW_STRICT
+    bool const fLVEnabled = !(fFlags & RTSEMRW_FLAGS_NO_LOCK_VAL);
+    if (!pszNameFmt)
+    {
+        static uint32_t volatile s_iSemRWAnon = 0;
+        uint32_t i = ASMAtomicIncU32(&s_iSemRWAnon) - 1;
+        RTLockValidatorRecExclInit(&pThis->ValidatorWrite, hClass, uSubClass, pThis,
+                                   fLVEnabled, "RTSemRW-%u", i);
+        RTLockValidatorRecSharedInit(&pThis->ValidatorRead, hClass, uSubClass, pThis,
+                                     false /*fSignaller*/, fLVEnabled, "RTSemRW-%u", i);
+    }
+    else
+    {
+        va_list va;
+        va_start(va, pszNameFmt);
+        RTLockValidatorRecExclInitV(&pThis->ValidatorWrite, hClass, uSubClass, pThis,
+                                    fLVEnabled, pszNameFmt, va);
+        va_end(va);
+        va_start(va, pszNameFmt);
+        RTLockValidatorRecSharedInitV(&pThis->ValidatorRead, hClass, uSubClass, pThis,
+                                      false /*fSignaller*/, fLVEnabled, pszNameFmt, va);
+        va_end(va);
+    }
+    RTLockValidatorRecMakeSiblings(&pThis->ValidatorWrite.Core, &pThis->ValidatorRead.Core);
+#else
+    RT_NOREF_PV(hClass); RT_NOREF_PV(uSubClass); RT_NOREF_PV(pszNameFmt);
+#endif
+    *phRWSem = pThis;
+    return VINF_SUCCESS;
+}
+
+
+RTDECL(int) RTSemRWDestroy(RTSEMRW hRWSem)
+{
+    /*
+     * Validate input, nil handle is fine.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    if (pThis == NIL_RTSEMRW)
+        return VINF_SUCCESS;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertMsgReturn(pThis->u32Magic == RTSEMRW_MAGIC,
+                    ("pThis=%p u32Magic=%#x\n", pThis, pThis->u32Magic),
+                    VERR_INVALID_HANDLE);
+    Assert(pThis->Writer == (pthread_t)-1);
+    Assert(!(pThis->u32State & (RTSEMRW_LNX_RD_MASK | RTSEMRW_LNX_WR_LOCKED)));
+    Assert(!pThis->cWrites);
+    Assert(!pThis->cWriterReads);
+
+    /*
+     * Invalidate the semaphore and wake up anyone waiting on it.
+     */
+    AssertReturn(ASMAtomicCmpXchgU32(&pThis->u32Magic, ~RTSEMRW_MAGIC, RTSEMRW_MAGIC), VERR_INVALID_HANDLE);
+    if (ASMAtomicReadU32(&pThis->u32State) & (RTSEMRW_LNX_WRW_MASK | RTSEMRW_LNX_RD_WAITERS))
+    {
+        ASMAtomicIncU32(&pThis->u32WriteSeq);
+        sys_futex(&pThis->u32WriteSeq, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX, NULL, NULL, 0);
+        rtSemRWLnxWakeReaders(pThis);
+        usleep(1000);
+    }
+#ifdef RTSEMRW_STRICT
+    RTLockValidatorRecSharedDelete(&pThis->ValidatorRead);
+    RTLockValidatorRecExclDelete(&pThis->ValidatorWrite);
+#endif
+    RTMemFree(pThis);
+    return VINF_SUCCESS;
+}
+
+
+RTDECL(uint32_t) RTSemRWSetSubClass(RTSEMRW hRWSem, uint32_t uSubClass)
+{
+#ifdef RTSEMRW_STRICT
+    /*
+     * Validate handle.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, RTLOCKVAL_SUB_CLASS_INVALID);
+    AssertReturn(pThis->u32Magic == RTSEMRW_MAGIC, RTLOCKVAL_SUB_CLASS_INVALID);
+
+    RTLockValidatorRecSharedSetSubClass(&pThis->ValidatorRead, uSubClass);
+    return RTLockValidatorRecExclSetSubClass(&pThis->ValidatorWrite, uSubClass);
+#else
+    RT_NOREF_PV(hRWSem); RT_NOREF_PV(uSubClass);
+    return RTLOCKVAL_SUB_CLASS_INVALID;
+#endif
+}
+
+
+/**
+ * Slow path of rtSemRWRequestRead, spins and/or sleeps until the semaphore
+ * can be entered.
+ */
+static int rtSemRWLnxRequestReadSlow(struct RTSEMRWINTERNAL *pThis, uint32_t fBlockMask, RTMSINTERVAL cMillies,
+                                     bool fAutoResume, PCRTLOCKVALSRCPOS pSrcPos, RTTHREAD hThreadSelf)
+{
+    struct timespec  ts;
+    struct timespec *pTimeout = NULL;
+    uint64_t         u64End   = 0; /* shut up gcc */
+    if (cMillies != RT_INDEFINITE_WAIT)
+    {
+        u64End   = RTTimeSystemNanoTS() + cMillies * UINT64_C(1000000);
+        pTimeout = &ts;
+    }
+
+    uint32_t const cSpinMax = rtSemRWLnxSpinMax(pThis);
+    uint32_t       cSpins   = 0;
+    for (;;)
+    {
+        uint32_t const uSeq = ASMAtomicReadU32(&pThis->u32ReadSeq);
+        uint32_t const uOld = ASMAtomicReadU32(&pThis->u32State);
+        if (!(uOld & fBlockMask))
+        {
+            Assert((uOld & RTSEMRW_LNX_RD_MASK) != RTSEMRW_LNX_RD_MASK);
+            if (ASMAtomicCmpXchgU32(&pThis->u32State, uOld + 1, uOld))
+            {
+                rtSemRWLnxSpinUpdate(pThis, cSpins);
+                return VINF_SUCCESS;
+            }
+            continue;
+        }
+        if (!cMillies)
+            return VERR_TIMEOUT;
+        if (cSpins < cSpinMax)
+        {
+            cSpins++;
+            ASMNopPause();
+            continue;
+        }
+
+        /*
+         * Tell the writer we're going to sleep.  The sequence number makes
+         * sure we don't miss a wakeup between here and the futex call.
+         */
+        if (   !(uOld & RTSEMRW_LNX_RD_WAITERS)
+            && !ASMAtomicCmpXchgU32(&pThis->u32State, uOld | RTSEMRW_LNX_RD_WAITERS, uOld))
+            continue;
+        if (pTimeout && !rtSemRWLnxCalcTimeout(pTimeout, u64End))
+            return VERR_TIMEOUT;
+
+#ifdef RTSEMRW_STRICT
+        int rc9 = RTLockValidatorRecSharedCheckBlocking(&pThis->ValidatorRead, hThreadSelf, pSrcPos, true,
+                                                        cMillies, RTTHREADSTATE_RW_READ, true);
+        if (RT_FAILURE(rc9))
+            return rc9;
+#else
+        if (hThreadSelf == NIL_RTTHREAD)
+            hThreadSelf = RTThreadSelf();
+        RTThreadBlocking(hThreadSelf, RTTHREADSTATE_RW_READ, true);
+        RT_NOREF_PV(pSrcPos);
+#endif
+        long rc = sys_futex(&pThis->u32ReadSeq, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, (int)uSeq, pTimeout, NULL, 0);
+        RTThreadUnblocked(hThreadSelf, RTTHREADSTATE_RW_READ);
+        if (RT_UNLIKELY(pThis->u32Magic != RTSEMRW_MAGIC))
+            return VERR_SEM_DESTROYED;
+
+        if (rc == -ETIMEDOUT)
+            return VERR_TIMEOUT;
+        if (rc == -EINTR)
+        {
+            if (!fAutoResume)
+                return VERR_INTERRUPTED;
+        }
+        else
+            AssertMsg(rc == 0 || rc == -EWOULDBLOCK, ("rc=%ld\n", rc));
+    }
+}
+
+
+DECL_FORCE_INLINE(int) rtSemRWRequestRead(RTSEMRW hRWSem, RTMSINTERVAL cMillies, bool fAutoResume, PCRTLOCKVALSRCPOS pSrcPos)
+{
+    /*
+     * Validate input.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertMsgReturn(pThis->u32Magic == RTSEMRW_MAGIC,
+                    ("pThis=%p u32Magic=%#x\n", pThis, pThis->u32Magic),
+                    VERR_INVALID_HANDLE);
+
+    /*
+     * Check if it's the writer (implement write+read recursion).
+     */
+    pthread_t Self = pthread_self();
+    pthread_t Writer;
+    ATOMIC_GET_PTHREAD_T(&pThis->Writer, &Writer);
+    if (Writer == Self)
+    {
+#ifdef RTSEMRW_STRICT
+        int rc9 = RTLockValidatorRecExclRecursionMixed(&pThis->ValidatorWrite, &pThis->ValidatorRead.Core, pSrcPos);
+        if (RT_FAILURE(rc9))
+            return rc9;
+#endif
+        Assert(pThis->cWriterReads < INT32_MAX);
+        pThis->cWriterReads++;
+        return VINF_SUCCESS;
+    }
+
+    RTTHREAD hThreadSelf = NIL_RTTHREAD;
+#ifdef RTSEMRW_STRICT
+    if (cMillies > 0)
+    {
+        hThreadSelf = RTThreadSelfAutoAdopt();
+        int rc9 = RTLockValidatorRecSharedCheckOrder(&pThis->ValidatorRead, hThreadSelf, pSrcPos, cMillies);
+        if (RT_FAILURE(rc9))
+            return rc9;
+    }
+#endif
+
+    /*
+     * Try lock it, optimizing for the uncontended case with a single atomic
+     * add.  Waiting writers are only ignored when we already own some read
+     * lock, see RTSEMRWINTERNAL.
+     */
+    uint32_t const fBlockMask = g_cRTSemRWLnxReadsHeld == 0
+                              ? RTSEMRW_LNX_WR_LOCKED | RTSEMRW_LNX_WRW_MASK : RTSEMRW_LNX_WR_LOCKED;
+    uint32_t const uOld = ASMAtomicAddU32(&pThis->u32State, 1);
+    Assert((uOld & RTSEMRW_LNX_RD_MASK) != RTSEMRW_LNX_RD_MASK);
+    if (RT_UNLIKELY(uOld & fBlockMask))
+    {
+        /* Back out again and wake up a writer if it saw our increment and went to sleep. */
+        uint32_t const uNew = ASMAtomicSubU32(&pThis->u32State, 1) - 1;
+        if (   !(uNew & (RTSEMRW_LNX_RD_MASK | RTSEMRW_LNX_WR_LOCKED))
+            && (uNew & RTSEMRW_LNX_WRW_MASK))
+            rtSemRWLnxWakeWriter(pThis);
+
+        int rc = rtSemRWLnxRequestReadSlow(pThis, fBlockMask, cMillies, fAutoResume, pSrcPos, hThreadSelf);
+        if (RT_FAILURE(rc))
+            return rc;
+    }
+
+    g_cRTSemRWLnxReadsHeld++;
+#ifdef RTSEMRW_STRICT
+    RTLockValidatorRecSharedAddOwner(&pThis->ValidatorRead, hThreadSelf, pSrcPos);
+#endif
+    return VINF_SUCCESS;
+}
+
+
+#undef RTSemRWRequestRead
+RTDECL(int) RTSemRWRequestRead(RTSEMRW hRWSem, RTMSINTERVAL cMillies)
+{
+#ifndef RTSEMRW_STRICT
+    return rtSemRWRequestRead(hRWSem, cMillies, true, NULL);
+#else
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
+    return rtSemRWRequestRead(hRWSem, cMillies, true, &SrcPos);
+#endif
+}
+
+
+RTDECL(int) RTSemRWRequestReadDebug(RTSEMRW hRWSem, RTMSINTERVAL cMillies, RTHCUINTPTR uId, RT_SRC_POS_DECL)
+{
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
+    return rtSemRWRequestRead(hRWSem, cMillies, true, &SrcPos);
+}
+
+
+#undef RTSemRWRequestReadNoResume
+RTDECL(int) RTSemRWRequestReadNoResume(RTSEMRW hRWSem, RTMSINTERVAL cMillies)
+{
+#ifndef RTSEMRW_STRICT
+    return rtSemRWRequestRead(hRWSem, cMillies, false, NULL);
+#else
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
+    return rtSemRWRequestRead(hRWSem, cMillies, false, &SrcPos);
+#endif
+}
+
+
+RTDECL(int) RTSemRWRequestReadNoResumeDebug(RTSEMRW hRWSem, RTMSINTERVAL cMillies, RTHCUINTPTR uId, RT_SRC_POS_DECL)
+{
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
+    return rtSemRWRequestRead(hRWSem, cMillies, false, &SrcPos);
+}
+
+
+RTDECL(int) RTSemRWReleaseRead(RTSEMRW hRWSem)
+{
+    /*
+     * Validate input.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertMsgReturn(pThis->u32Magic == RTSEMRW_MAGIC,
+                    ("pThis=%p u32Magic=%#x\n", pThis, pThis->u32Magic),
+                    VERR_INVALID_HANDLE);
+
+    /*
+     * Check if it's the writer.
+     */
+    pthread_t Self = pthread_self();
+    pthread_t Writer;
+    ATOMIC_GET_PTHREAD_T(&pThis->Writer, &Writer);
+    if (Writer == Self)
+    {
+        AssertMsgReturn(pThis->cWriterReads > 0, ("pThis=%p\n", pThis), VERR_NOT_OWNER);
+#ifdef RTSEMRW_STRICT
+        int rc9 = RTLockValidatorRecExclUnwindMixed(&pThis->ValidatorWrite, &pThis->ValidatorRead.Core);
+        if (RT_FAILURE(rc9))
+            return rc9;
+#endif
+        pThis->cWriterReads--;
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Try unlock it.
+     */
+#ifdef RTSEMRW_STRICT
+    int rc9 = RTLockValidatorRecSharedCheckAndRelease(&pThis->ValidatorRead, RTThreadSelf());
+    if (RT_FAILURE(rc9))
+        return rc9;
+#endif
+    if (RT_UNLIKELY(!(ASMAtomicReadU32(&pThis->u32State) & RTSEMRW_LNX_RD_MASK)))
+    {
+        AssertMsgFailed(("Not owner of %p\n", pThis));
+        return VERR_NOT_OWNER;
+    }
+
+    uint32_t const uNew = ASMAtomicSubU32(&pThis->u32State, 1) - 1;
+    if (g_cRTSemRWLnxReadsHeld > 0) /* Released by a different thread than the one taking it? */
+        g_cRTSemRWLnxReadsHeld--;
+
+    /* The last reader out wakes up a waiting writer. */
+    if (   !(uNew & RTSEMRW_LNX_RD_MASK)
+        && (uNew & RTSEMRW_LNX_WRW_MASK))
+        rtSemRWLnxWakeWriter(pThis);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Undoes the waiting writer registration of a writer giving up, passing on
+ * wakeups it may have consumed.
+ */
+static void rtSemRWLnxWriteGiveUp(struct RTSEMRWINTERNAL *pThis)
+{
+    uint32_t uOld;
+    uint32_t uNew;
+    bool     fWakeReaders;
+    do
+    {
+        uOld = ASMAtomicReadU32(&pThis->u32State);
+        Assert(uOld & RTSEMRW_LNX_WRW_MASK);
+        uNew = uOld - RTSEMRW_LNX_WRW_ONE;
+        fWakeReaders = !(uNew & RTSEMRW_LNX_WRW_MASK) && (uNew & RTSEMRW_LNX_RD_WAITERS);
+        if (fWakeReaders)
+            uNew &= ~RTSEMRW_LNX_RD_WAITERS;
+    } while (!ASMAtomicCmpXchgU32(&pThis->u32State, uNew, uOld));
+
+    if (fWakeReaders)
+        rtSemRWLnxWakeReaders(pThis);
+    else if (   (uNew & RTSEMRW_LNX_WRW_MASK)
+             && !(uNew & (RTSEMRW_LNX_RD_MASK | RTSEMRW_LNX_WR_LOCKED)))
+        rtSemRWLnxWakeWriter(pThis);
+}
+
+
+/**
+ * Slow path of rtSemRWRequestWrite, spins and/or sleeps until the semaphore
+ * can be entered.
+ */
+static int rtSemRWLnxRequestWriteSlow(struct RTSEMRWINTERNAL *pThis, RTMSINTERVAL cMillies, bool fAutoResume,
+                                      PCRTLOCKVALSRCPOS pSrcPos, RTTHREAD hThreadSelf)
+{
+    /*
+     * Polling doesn't register as a waiting writer.
+     */
+    if (!cMillies)
+    {
+        for (;;)
+        {
+            uint32_t const uOld = ASMAtomicReadU32(&pThis->u32State);
+            if (uOld & (RTSEMRW_LNX_RD_MASK | RTSEMRW_LNX_WR_LOCKED))
+                return VERR_TIMEOUT;
+            if (ASMAtomicCmpXchgU32(&pThis->u32State, uOld | RTSEMRW_LNX_WR_LOCKED, uOld))
+                return VINF_SUCCESS;
+        }
+    }
+
+    struct timespec  ts;
+    struct timespec *pTimeout = NULL;
+    uint64_t         u64End   = 0; /* shut up gcc */
+    if (cMillies != RT_INDEFINITE_WAIT)
+    {
+        u64End   = RTTimeSystemNanoTS() + cMillies * UINT64_C(1000000);
+        pTimeout = &ts;
+    }
+
+    /*
+     * Register as waiting writer, this keeps new readers out.
+     */
+    uint32_t uOld = ASMAtomicAddU32(&pThis->u32State, RTSEMRW_LNX_WRW_ONE);
+    AssertMsg((uOld & RTSEMRW_LNX_WRW_MASK) != RTSEMRW_LNX_WRW_MASK, ("%#x\n", uOld));
+
+    int            rc;
+    uint32_t const cSpinMax = rtSemRWLnxSpinMax(pThis);
+    uint32_t       cSpins   = 0;
+    for (;;)
+    {
+        uint32_t const uSeq = ASMAtomicReadU32(&pThis->u32WriteSeq);
+        uOld = ASMAtomicReadU32(&pThis->u32State);
+        if (!(uOld & (RTSEMRW_LNX_RD_MASK | RTSEMRW_LNX_WR_LOCKED)))
+        {
+            if (ASMAtomicCmpXchgU32(&pThis->u32State, (uOld - RTSEMRW_LNX_WRW_ONE) | RTSEMRW_LNX_WR_LOCKED, uOld))
+            {
+                rtSemRWLnxSpinUpdate(pThis, cSpins);
+                return VINF_SUCCESS;
+            }
+            continue;
+        }
+        if (cSpins < cSpinMax)
+        {
+            cSpins++;
+            ASMNopPause();
+            continue;
+        }
+
+        if (pTimeout && !rtSemRWLnxCalcTimeout(pTimeout, u64End))
+        {
+            rc = VERR_TIMEOUT;
+            break;
+        }
+
+#ifdef RTSEMRW_STRICT
+        int rc9 = RTLockValidatorRecExclCheckBlocking(&pThis->ValidatorWrite, hThreadSelf, pSrcPos, true,
+                                                      cMillies, RTTHREADSTATE_RW_WRITE, true);
+        if (RT_FAILURE(rc9))
+        {
+            rc = rc9;
+            break;
+        }
+#else
+        if (hThreadSelf == NIL_RTTHREAD)
+            hThreadSelf = RTThreadSelf();
+        RTThreadBlocking(hThreadSelf, RTTHREADSTATE_RW_WRITE, true);
+        RT_NOREF_PV(pSrcPos);
+#endif
+        long rcFutex = sys_futex(&pThis->u32WriteSeq, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, (int)uSeq, pTimeout, NULL, 0);
+        RTThreadUnblocked(hThreadSelf, RTTHREADSTATE_RW_WRITE);
+        if (RT_UNLIKELY(pThis->u32Magic != RTSEMRW_MAGIC))
+            return VERR_SEM_DESTROYED;
+
+        if (rcFutex == -ETIMEDOUT)
+        {
+            rc = VERR_TIMEOUT;
+            break;
+        }
+        if (rcFutex == -EINTR)
+        {
+            if (!fAutoResume)
+            {
+                rc = VERR_INTERRUPTED;
+                break;
+            }
+        }
+        else
+            AssertMsg(rcFutex == 0 || rcFutex == -EWOULDBLOCK, ("rc=%ld\n", rcFutex));
+    }
+
+    rtSemRWLnxWriteGiveUp(pThis);
+    return rc;
+}
+
+
+DECL_FORCE_INLINE(int) rtSemRWRequestWrite(RTSEMRW hRWSem, RTMSINTERVAL cMillies, bool fAutoResume, PCRTLOCKVALSRCPOS pSrcPos)
+{
+    /*
+     * Validate input.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertMsgReturn(pThis->u32Magic == RTSEMRW_MAGIC,
+                    ("pThis=%p u32Magic=%#x\n", pThis, pThis->u32Magic),
+                    VERR_INVALID_HANDLE);
+
+    /*
+     * Recursion?
+     */
+    pthread_t Self = pthread_self();
+    pthread_t Writer;
+    ATOMIC_GET_PTHREAD_T(&pThis->Writer, &Writer);
+    if (Writer == Self)
+    {
+#ifdef RTSEMRW_STRICT
+        int rc9 = RTLockValidatorRecExclRecursion(&pThis->ValidatorWrite, pSrcPos);
+        if (RT_FAILURE(rc9))
+            return rc9;
+#endif
+        Assert(pThis->cWrites < INT32_MAX);
+        pThis->cWrites++;
+        return VINF_SUCCESS;
+    }
+
+    RTTHREAD hThreadSelf = NIL_RTTHREAD;
+#ifdef RTSEMRW_STRICT
+    if (cMillies)
+    {
+        hThreadSelf = RTThreadSelfAutoAdopt();
+        int rc9 = RTLockValidatorRecExclCheckOrder(&pThis->ValidatorWrite, hThreadSelf, pSrcPos, cMillies);
+        if (RT_FAILURE(rc9))
+            return rc9;
+    }
+#endif
+
+    /*
+     * Try lock it, optimizing for the uncontended case.
+     */
+    if (RT_UNLIKELY(!ASMAtomicCmpXchgU32(&pThis->u32State, RTSEMRW_LNX_WR_LOCKED, 0)))
+    {
+        int rc = rtSemRWLnxRequestWriteSlow(pThis, cMillies, fAutoResume, pSrcPos, hThreadSelf);
+        if (RT_FAILURE(rc))
+            return rc;
+    }
+
+    ATOMIC_SET_PTHREAD_T(&pThis->Writer, Self);
+    pThis->cWrites = 1;
+#ifdef RTSEMRW_STRICT
+    RTLockValidatorRecExclSetOwner(&pThis->ValidatorWrite, hThreadSelf, pSrcPos, true);
+#endif
+    return VINF_SUCCESS;
+}
+
+
+#undef RTSemRWRequestWrite
+RTDECL(int) RTSemRWRequestWrite(RTSEMRW hRWSem, RTMSINTERVAL cMillies)
+{
+#ifndef RTSEMRW_STRICT
+    return rtSemRWRequestWrite(hRWSem, cMillies, true, NULL);
+#else
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
+    return rtSemRWRequestWrite(hRWSem, cMillies, true, &SrcPos);
+#endif
+}
+
+
+RTDECL(int) RTSemRWRequestWriteDebug(RTSEMRW hRWSem, RTMSINTERVAL cMillies, RTHCUINTPTR uId, RT_SRC_POS_DECL)
+{
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
+    return rtSemRWRequestWrite(hRWSem, cMillies, true, &SrcPos);
+}
+
+
+#undef RTSemRWRequestWriteNoResume
+RTDECL(int) RTSemRWRequestWriteNoResume(RTSEMRW hRWSem, RTMSINTERVAL cMillies)
+{
+#ifndef RTSEMRW_STRICT
+    return rtSemRWRequestWrite(hRWSem, cMillies, false, NULL);
+#else
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
+    return rtSemRWRequestWrite(hRWSem, cMillies, false, &SrcPos);
+#endif
+}
+
+
+RTDECL(int) RTSemRWRequestWriteNoResumeDebug(RTSEMRW hRWSem, RTMSINTERVAL cMillies, RTHCUINTPTR uId, RT_SRC_POS_DECL)
+{
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
+    return rtSemRWRequestWrite(hRWSem, cMillies, false, &SrcPos);
+}
+
+
+RTDECL(int) RTSemRWReleaseWrite(RTSEMRW hRWSem)
+{
+    /*
+     * Validate input.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertMsgReturn(pThis->u32Magic == RTSEMRW_MAGIC,
+                    ("pThis=%p u32Magic=%#x\n", pThis, pThis->u32Magic),
+                    VERR_INVALID_HANDLE);
+
+    /*
+     * Verify ownership and implement recursion.
+     */
+    pthread_t Self = pthread_self();
+    pthread_t Writer;
+    ATOMIC_GET_PTHREAD_T(&pThis->Writer, &Writer);
+    AssertMsgReturn(Writer == Self, ("pThis=%p\n", pThis), VERR_NOT_OWNER);
+    AssertReturn(pThis->cWriterReads == 0 || pThis->cWrites > 1, VERR_WRONG_ORDER);
+
+    if (pThis->cWrites > 1)
+    {
+#ifdef RTSEMRW_STRICT
+        int rc9 = RTLockValidatorRecExclUnwind(&pThis->ValidatorWrite);
+        if (RT_FAILURE(rc9))
+            return rc9;
+#endif
+        pThis->cWrites--;
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Unlock it.
+     */
+#ifdef RTSEMRW_STRICT
+    int rc9 = RTLockValidatorRecExclReleaseOwner(&pThis->ValidatorWrite, true);
+    if (RT_FAILURE(rc9))
+        return rc9;
+#endif
+
+    pThis->cWrites--;
+    ATOMIC_SET_PTHREAD_T(&pThis->Writer, (pthread_t)-1);
+
+    uint32_t uOld;
+    uint32_t uNew;
+    do
+    {
+        uOld = ASMAtomicReadU32(&pThis->u32State);
+        Assert(uOld & RTSEMRW_LNX_WR_LOCKED);
+        uNew = uOld & ~RTSEMRW_LNX_WR_LOCKED;
+        if (!(uNew & RTSEMRW_LNX_WRW_MASK))
+            uNew &= ~RTSEMRW_LNX_RD_WAITERS;
+    } while (!ASMAtomicCmpXchgU32(&pThis->u32State, uNew, uOld));
+
+    /* Hand it to the next writer if there is one, otherwise let the readers in. */
+    if (uNew & RTSEMRW_LNX_WRW_MASK)
+        rtSemRWLnxWakeWriter(pThis);
+    else if (uOld & RTSEMRW_LNX_RD_WAITERS)
+        rtSemRWLnxWakeReaders(pThis);
+    return VINF_SUCCESS;
+}
+
+
+RTDECL(bool) RTSemRWIsWriteOwner(RTSEMRW hRWSem)
+{
+    /*
+     * Validate input.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, false);
+    AssertMsgReturn(pThis->u32Magic == RTSEMRW_MAGIC,
+                    ("pThis=%p u32Magic=%#x\n", pThis, pThis->u32Magic),
+                    false);
+
+    /*
+     * Check ownership.
+     */
+    pthread_t Self = pthread_self();
+    pthread_t Writer;
+    ATOMIC_GET_PTHREAD_T(&pThis->Writer, &Writer);
+    return Writer == Self;
+}
+
+
+RTDECL(bool)  RTSemRWIsReadOwner(RTSEMRW hRWSem, bool fWannaHear)
+{
+    /*
+     * Validate handle.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, false);
+    AssertReturn(pThis->u32Magic == RTSEMRW_MAGIC, false);
+
+    /*
+     * Check write ownership.  The writer is also a valid reader.
+     */
+    pthread_t Self = pthread_self();
+    pthread_t Writer;
+    ATOMIC_GET_PTHREAD_T(&pThis->Writer, &Writer);
+    if (Writer == Self)
+        return true;
+    if (Writer != (pthread_t)-1)
+        return false;
+
+    /*
+     * If there are no readers, we cannot be one of them, can we?
+     */
+    if (!(ASMAtomicReadU32(&pThis->u32State) & RTSEMRW_LNX_RD_MASK))
+        return false;
+
+#ifdef RTSEMRW_STRICT
+    /*
+     * Ask the lock validator.
+     */
+    NOREF(fWannaHear);
+    return RTLockValidatorRecSharedIsOwner(&pThis->ValidatorRead, NIL_RTTHREAD);
+#else
+    /*
+     * If we don't own any read lock at all we cannot own this one, otherwise
+     * tell the caller what he want to hear.
+     */
+    return g_cRTSemRWLnxReadsHeld > 0 && fWannaHear;
+#endif
+}
+RT_EXPORT_SYMBOL(RTSemRWIsReadOwner);
+
+
+RTDECL(uint32_t) RTSemRWGetWriteRecursion(RTSEMRW hRWSem)
+{
+    /*
+     * Validate input.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, 0);
+    AssertMsgReturn(pThis->u32Magic == RTSEMRW_MAGIC,
+                    ("pThis=%p u32Magic=%#x\n", pThis, pThis->u32Magic),
+                    0);
+
+    /*
+     * Return the requested data.
+     */
+    return pThis->cWrites;
+}
+
+
+RTDECL(uint32_t) RTSemRWGetWriterReadRecursion(RTSEMRW hRWSem)
+{
+    /*
+     * Validate input.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, 0);
+    AssertMsgReturn(pThis->u32Magic == RTSEMRW_MAGIC,
+                    ("pThis=%p u32Magic=%#x\n", pThis, pThis->u32Magic),
+                    0);
+
+    /*
+     * Return the requested data.
+     */
+    return pThis->cWriterReads;
+}
+
+
+RTDECL(uint32_t) RTSemRWGetReadCount(RTSEMRW hRWSem)
+{
+    /*
+     * Validate input.
+     */
+    struct RTSEMRWINTERNAL *pThis = hRWSem;
+    AssertPtrReturn(pThis, 0);
+    AssertMsgReturn(pThis->u32Magic == RTSEMRW_MAGIC,
+                    ("pThis=%p u32Magic=%#x\n", pThis, pThis->u32Magic),
+                    0);
+
+    /*
+     * Return the requested data.
+     */
+    return ASMAtomicReadU32(&pThis->u32State) & RTSEMRW_LNX_RD_MASK;
+}
@@ -0,0 +1,674 @@
+/* $Id$ */
+/** @file
+ * IPRT - Asynchronous Log File Output.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#include <iprt/log.h>
+#include "internal/iprt.h"
+
+#include <iprt/asm.h>
+#include <iprt/assert.h>
+#include <iprt/critsect.h>
+#include <iprt/err.h>
+#include <iprt/file.h>
+#include <iprt/mem.h>
+#include <iprt/semaphore.h>
+#include <iprt/string.h>
+#include <iprt/thread.h>
+#include <iprt/time.h>
+
+#include "internal/magics.h"
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Max number of instances RTLogAsyncOutputFlushAll knows about. */
+#define RTLOGASYNC_MAX_INSTANCES    8
+/** Smallest ring buffer we'll use. */
+#define RTLOGASYNC_MIN_BUFFER_SIZE  _16K
+/** Largest ring buffer we'll use. */
+#define RTLOGASYNC_MAX_BUFFER_SIZE  _64M
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * Asynchronous log output instance.
+ *
+ * The ring buffer is lock free between the producer (the logging thread) and
+ * the consumer (the writer thread or a synchronous flusher).  Producers are
+ * serialized by CritSectProduce, which is practically uncontended since the
+ * logger already serializes output under its own lock.  Consumers are
+ * serialized by CritSectWrite, which is also what orders the synchronous
+ * fallback write after the buffered output.
+ */
+typedef struct RTLOGASYNCOUTPUTINT
+{
+    /** Magic value (RTLOGASYNCOUTPUT_MAGIC). */
+    uint32_t            u32Magic;
+    /** Index into g_apInstances. */
+    uint32_t            iSlot;
+    /** Set when the writer thread should terminate. */
+    bool volatile       fShutdown;
+    /** Set while the writer thread is about to wait or waiting for work. */
+    bool volatile       fWriterWaiting;
+    /** The output interface doing the file I/O. */
+    PCRTLOGOUTPUTIF     pLowerIf;
+    /** The user argument for pLowerIf. */
+    void               *pvLowerUser;
+    /** The file handle when using the built-in RTFile output. */
+    RTFILE              hFile;
+    /** Status of the last failed write, VINF_SUCCESS if none. */
+    int32_t volatile    rcLastWrite;
+
+    /** Serializes producers. */
+    RTCRITSECT          CritSectProduce;
+    /** Serializes consumers, held while writing to the lower interface. */
+    RTCRITSECT          CritSectWrite;
+    /** Event the writer thread waits on. */
+    RTSEMEVENT          hEvtWriter;
+    /** The writer thread. */
+    RTTHREAD            hThread;
+
+    /** The ring buffer. */
+    uint8_t            *pbRing;
+    /** The ring buffer size (power of two). */
+    size_t              cbRing;
+    /** Free running producer offset. */
+    uint64_t volatile   offProduce;
+    /** Free running consumer offset. */
+    uint64_t volatile   offConsume;
+
+    /** Rate limit in bytes per second, 0 if unlimited. */
+    uint32_t            cbMaxPerSec;
+    /** Bytes accepted in the current rate limit window (producer lock). */
+    uint32_t            cbInWindow;
+    /** Start of the current rate limit window (producer lock). */
+    uint64_t            msWindowStart;
+    /** Total number of bytes dropped due to the rate limit. */
+    uint64_t volatile   cbDropped;
+    /** The cbDropped value last noted in the log (consumer lock). */
+    uint64_t            cbDroppedNoted;
+    /** Number of times the producer had to write synchronously. */
+    uint64_t volatile   cSyncWrites;
+} RTLOGASYNCOUTPUTINT;
+/** Pointer to an asynchronous log output instance. */
+typedef RTLOGASYNCOUTPUTINT *PRTLOGASYNCOUTPUTINT;
+
+
+/*********************************************************************************************************************************
+*   Global Variables                                                                                                             *
+*********************************************************************************************************************************/
+/** The live instances, for RTLogAsyncOutputFlushAll. */
+static PRTLOGASYNCOUTPUTINT volatile g_apInstances[RTLOGASYNC_MAX_INSTANCES];
+
+
+/*********************************************************************************************************************************
+*   Built-in RTFile Output                                                                                                       *
+*********************************************************************************************************************************/
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnDirCtxOpen} */
+static DECLCALLBACK(int) rtLogAsyncFileDirCtxOpen(PCRTLOGOUTPUTIF pIf, void *pvUser, const char *pszFilename, void **ppvDirCtx)
+{
+    RT_NOREF(pIf, pvUser, pszFilename);
+    *ppvDirCtx = NULL;
+    return VINF_SUCCESS;
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnDirCtxClose} */
+static DECLCALLBACK(int) rtLogAsyncFileDirCtxClose(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx)
+{
+    RT_NOREF(pIf, pvUser, pvDirCtx);
+    return VINF_SUCCESS;
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnDelete} */
+static DECLCALLBACK(int) rtLogAsyncFileDelete(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx, const char *pszFilename)
+{
+    RT_NOREF(pIf, pvUser, pvDirCtx);
+    return RTFileDelete(pszFilename);
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnRename} */
+static DECLCALLBACK(int) rtLogAsyncFileRename(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx,
+                                              const char *pszFilenameOld, const char *pszFilenameNew, uint32_t fFlags)
+{
+    RT_NOREF(pIf, pvUser, pvDirCtx);
+    return RTFileRename(pszFilenameOld, pszFilenameNew, fFlags);
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnOpen} */
+static DECLCALLBACK(int) rtLogAsyncFileOpen(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx, const char *pszFilename, uint32_t fFlags)
+{
+    RT_NOREF(pIf, pvDirCtx);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    return RTFileOpen(&pThis->hFile, pszFilename, fFlags);
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnClose} */
+static DECLCALLBACK(int) rtLogAsyncFileClose(PCRTLOGOUTPUTIF pIf, void *pvUser)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    int rc = RTFileClose(pThis->hFile);
+    pThis->hFile = NIL_RTFILE;
+    return rc;
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnQuerySize} */
+static DECLCALLBACK(int) rtLogAsyncFileQuerySize(PCRTLOGOUTPUTIF pIf, void *pvUser, uint64_t *pcbSize)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    return RTFileQuerySize(pThis->hFile, pcbSize);
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnWrite} */
+static DECLCALLBACK(int) rtLogAsyncFileWrite(PCRTLOGOUTPUTIF pIf, void *pvUser, const void *pvBuf,
+                                             size_t cbWrite, size_t *pcbWritten)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    return RTFileWrite(pThis->hFile, pvBuf, cbWrite, pcbWritten);
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnFlush} */
+static DECLCALLBACK(int) rtLogAsyncFileFlush(PCRTLOGOUTPUTIF pIf, void *pvUser)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    return RTFileFlush(pThis->hFile);
+}
+
+
+/** The built-in RTFile output, used when no lower interface is given. */
+static RTLOGOUTPUTIF const g_rtLogAsyncFileIf =
+{
+    rtLogAsyncFileDirCtxOpen,
+    rtLogAsyncFileDirCtxClose,
+    rtLogAsyncFileDelete,
+    rtLogAsyncFileRename,
+    rtLogAsyncFileOpen,
+    rtLogAsyncFileClose,
+    rtLogAsyncFileQuerySize,
+    rtLogAsyncFileWrite,
+    rtLogAsyncFileFlush
+};
+
+
+/*********************************************************************************************************************************
+*   Ring Buffer                                                                                                                  *
+*********************************************************************************************************************************/
+
+/**
+ * Writes a chunk to the lower interface, remembering failures.
+ *
+ * @param   pThis       The instance.
+ * @param   pvBuf       What to write.
+ * @param   cbBuf       How much to write.
+ */
+static void rtLogAsyncWriteLower(PRTLOGASYNCOUTPUTINT pThis, const void *pvBuf, size_t cbBuf)
+{
+    int rc = pThis->pLowerIf->pfnWrite(pThis->pLowerIf, pThis->pvLowerUser, pvBuf, cbBuf, NULL);
+    if (RT_FAILURE(rc))
+        ASMAtomicWriteS32(&pThis->rcLastWrite, rc);
+}
+
+
+/**
+ * Writes everything in the ring buffer to the lower interface.
+ *
+ * @param   pThis       The instance.  Caller owns CritSectWrite.
+ */
+static void rtLogAsyncDrainLocked(PRTLOGASYNCOUTPUTINT pThis)
+{
+    Assert(RTCritSectIsOwner(&pThis->CritSectWrite));
+
+    uint64_t offConsume = ASMAtomicUoReadU64(&pThis->offConsume);
+    for (;;)
+    {
+        uint64_t const offProduce = ASMAtomicReadU64(&pThis->offProduce);
+        if (offProduce == offConsume)
+            break;
+
+        /* Up to the end of the buffer; a wrapped remainder is done in the next round. */
+        size_t const offRing = (size_t)offConsume & (pThis->cbRing - 1);
+        size_t const cbChunk = (size_t)RT_MIN(offProduce - offConsume, pThis->cbRing - offRing);
+        rtLogAsyncWriteLower(pThis, &pThis->pbRing[offRing], cbChunk);
+
+        offConsume += cbChunk;
+        ASMAtomicWriteU64(&pThis->offConsume, offConsume);
+    }
+
+    /* Note any output dropped by the rate limit since the last time. */
+    uint64_t const cbDropped = ASMAtomicReadU64(&pThis->cbDropped);
+    if (cbDropped != pThis->cbDroppedNoted)
+    {
+        char   szMsg[128];
+        size_t cchMsg = RTStrPrintf(szMsg, sizeof(szMsg), "\n!! Log rate limit: %RU64 bytes dropped (%RU64 total) !!\n",
+                                    cbDropped - pThis->cbDroppedNoted, cbDropped);
+        pThis->cbDroppedNoted = cbDropped;
+        rtLogAsyncWriteLower(pThis, szMsg, cchMsg);
+    }
+}
+
+
+/**
+ * Synchronously writes all pending output and optionally flushes the file.
+ *
+ * @returns IPRT status code.
+ * @param   pThis       The instance.
+ * @param   fFlush      Whether to flush the lower interface too.
+ */
+static int rtLogAsyncDrain(PRTLOGASYNCOUTPUTINT pThis, bool fFlush)
+{
+    /* A lower interface logging from inside its write callback must not recurse. */
+    if (RTCritSectIsOwner(&pThis->CritSectWrite))
+        return VINF_SUCCESS;
+
+    int rc = RTCritSectEnter(&pThis->CritSectWrite);
+    AssertRCReturn(rc, rc);
+    rtLogAsyncDrainLocked(pThis);
+    if (fFlush)
+        rc = pThis->pLowerIf->pfnFlush(pThis->pLowerIf, pThis->pvLowerUser);
+    RTCritSectLeave(&pThis->CritSectWrite);
+    return rc;
+}
+
+
+/**
+ * @callback_method_impl{FNRTTHREAD, The writer thread.}
+ */
+static DECLCALLBACK(int) rtLogAsyncWriterThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    RT_NOREF(hThreadSelf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+
+    while (!ASMAtomicReadBool(&pThis->fShutdown))
+    {
+        rtLogAsyncDrain(pThis, false /*fFlush*/);
+
+        /* Announce that we're going to sleep, then recheck so a producer
+           publishing concurrently either sees the flag or we see its data. */
+        ASMAtomicWriteBool(&pThis->fWriterWaiting, true);
+        if (   ASMAtomicReadU64(&pThis->offProduce) == ASMAtomicReadU64(&pThis->offConsume)
+            && !ASMAtomicReadBool(&pThis->fShutdown))
+            RTSemEventWait(pThis->hEvtWriter, RT_INDEFINITE_WAIT);
+        ASMAtomicWriteBool(&pThis->fWriterWaiting, false);
+    }
+
+    rtLogAsyncDrain(pThis, false /*fFlush*/);
+    return VINF_SUCCESS;
+}
+
+
+/*********************************************************************************************************************************
+*   Asynchronous Output Interface                                                                                                *
+*********************************************************************************************************************************/
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnDirCtxOpen} */
+static DECLCALLBACK(int) rtLogAsyncDirCtxOpen(PCRTLOGOUTPUTIF pIf, void *pvUser, const char *pszFilename, void **ppvDirCtx)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    return pThis->pLowerIf->pfnDirCtxOpen(pThis->pLowerIf, pThis->pvLowerUser, pszFilename, ppvDirCtx);
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnDirCtxClose} */
+static DECLCALLBACK(int) rtLogAsyncDirCtxClose(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    return pThis->pLowerIf->pfnDirCtxClose(pThis->pLowerIf, pThis->pvLowerUser, pvDirCtx);
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnDelete} */
+static DECLCALLBACK(int) rtLogAsyncDelete(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx, const char *pszFilename)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    return pThis->pLowerIf->pfnDelete(pThis->pLowerIf, pThis->pvLowerUser, pvDirCtx, pszFilename);
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnRename} */
+static DECLCALLBACK(int) rtLogAsyncRename(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx,
+                                          const char *pszFilenameOld, const char *pszFilenameNew, uint32_t fFlags)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    return pThis->pLowerIf->pfnRename(pThis->pLowerIf, pThis->pvLowerUser, pvDirCtx, pszFilenameOld, pszFilenameNew, fFlags);
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnOpen} */
+static DECLCALLBACK(int) rtLogAsyncOpen(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx, const char *pszFilename, uint32_t fFlags)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+
+    /* Output for the previous file (history rotation) must not end up in the new one. */
+    rtLogAsyncDrain(pThis, false /*fFlush*/);
+    RTCritSectEnter(&pThis->CritSectWrite);
+    int rc = pThis->pLowerIf->pfnOpen(pThis->pLowerIf, pThis->pvLowerUser, pvDirCtx, pszFilename, fFlags);
+    RTCritSectLeave(&pThis->CritSectWrite);
+    return rc;
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnClose} */
+static DECLCALLBACK(int) rtLogAsyncClose(PCRTLOGOUTPUTIF pIf, void *pvUser)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+
+    RTCritSectEnter(&pThis->CritSectWrite);
+    rtLogAsyncDrainLocked(pThis);
+    int rc = pThis->pLowerIf->pfnClose(pThis->pLowerIf, pThis->pvLowerUser);
+    RTCritSectLeave(&pThis->CritSectWrite);
+    return rc;
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnQuerySize} */
+static DECLCALLBACK(int) rtLogAsyncQuerySize(PCRTLOGOUTPUTIF pIf, void *pvUser, uint64_t *pcbSize)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+
+    /* Don't wait for the writer, just account for what it hasn't written yet. */
+    uint64_t const cbPending = ASMAtomicReadU64(&pThis->offProduce) - ASMAtomicReadU64(&pThis->offConsume);
+    int rc = pThis->pLowerIf->pfnQuerySize(pThis->pLowerIf, pThis->pvLowerUser, pcbSize);
+    if (RT_SUCCESS(rc))
+        *pcbSize += cbPending;
+    return rc;
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnWrite} */
+static DECLCALLBACK(int) rtLogAsyncWrite(PCRTLOGOUTPUTIF pIf, void *pvUser, const void *pvBuf,
+                                         size_t cbWrite, size_t *pcbWritten)
+{
+    RT_NOREF(pIf);
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)pvUser;
+    if (pcbWritten)
+        *pcbWritten = cbWrite;
+    if (!cbWrite)
+        return VINF_SUCCESS;
+
+    /* Output produced by the lower interface while writing can't go anywhere. */
+    if (RTCritSectIsOwner(&pThis->CritSectWrite))
+        return VINF_SUCCESS;
+
+    int rc = RTCritSectEnter(&pThis->CritSectProduce);
+    AssertRCReturn(rc, rc);
+
+    /*
+     * Rate limiting.
+     */
+    if (pThis->cbMaxPerSec)
+    {
+        uint64_t const msNow = RTTimeMilliTS();
+        if (msNow - pThis->msWindowStart >= RT_MS_1SEC)
+        {
+            pThis->msWindowStart = msNow;
+            pThis->cbInWindow    = 0;
+        }
+        if (pThis->cbInWindow + cbWrite > pThis->cbMaxPerSec)
+        {
+            ASMAtomicAddU64(&pThis->cbDropped, cbWrite);
+            RTCritSectLeave(&pThis->CritSectProduce);
+            return VINF_SUCCESS;
+        }
+        pThis->cbInWindow += (uint32_t)cbWrite;
+    }
+
+    /*
+     * Copy it into the ring buffer if there is room.  Otherwise write
+     * synchronously after what's already buffered to keep the ordering.
+     */
+    uint64_t const offProduce = ASMAtomicUoReadU64(&pThis->offProduce);
+    uint64_t const cbUsed     = offProduce - ASMAtomicReadU64(&pThis->offConsume);
+    if (cbWrite <= pThis->cbRing - cbUsed)
+    {
+        size_t const offRing = (size_t)offProduce & (pThis->cbRing - 1);
+        size_t const cbFirst = RT_MIN(cbWrite, pThis->cbRing - offRing);
+        memcpy(&pThis->pbRing[offRing], pvBuf, cbFirst);
+        if (cbFirst < cbWrite)
+            memcpy(pThis->pbRing, (uint8_t const *)pvBuf + cbFirst, cbWrite - cbFirst);
+        ASMAtomicWriteU64(&pThis->offProduce, offProduce + cbWrite);
+
+        if (ASMAtomicReadBool(&pThis->fWriterWaiting))
+            RTSemEventSignal(pThis->hEvtWriter);
+    }
+    else
+    {
+        ASMAtomicIncU64(&pThis->cSyncWrites);
+        RTCritSectEnter(&pThis->CritSectWrite);
+        rtLogAsyncDrainLocked(pThis);
+        rtLogAsyncWriteLower(pThis, pvBuf, cbWrite);
+        RTCritSectLeave(&pThis->CritSectWrite);
+    }
+
+    RTCritSectLeave(&pThis->CritSectProduce);
+    return VINF_SUCCESS;
+}
+
+
+/** @interface_method_impl{RTLOGOUTPUTIF,pfnFlush} */
+static DECLCALLBACK(int) rtLogAsyncFlush(PCRTLOGOUTPUTIF pIf, void *pvUser)
+{
+    RT_NOREF(pIf);
+    return rtLogAsyncDrain((PRTLOGASYNCOUTPUTINT)pvUser, true /*fFlush*/);
+}
+
+
+/** The asynchronous output interface. */
+static RTLOGOUTPUTIF const g_rtLogAsyncOutputIf =
+{
+    rtLogAsyncDirCtxOpen,
+    rtLogAsyncDirCtxClose,
+    rtLogAsyncDelete,
+    rtLogAsyncRename,
+    rtLogAsyncOpen,
+    rtLogAsyncClose,
+    rtLogAsyncQuerySize,
+    rtLogAsyncWrite,
+    rtLogAsyncFlush
+};
+
+
+/*********************************************************************************************************************************
+*   Public API                                                                                                                   *
+*********************************************************************************************************************************/
+
+RTDECL(int) RTLogAsyncOutputCreate(PRTLOGASYNCOUTPUT phAsync, PCRTLOGOUTPUTIF pLowerIf, void *pvLowerUser,
+                                   size_t cbBuffer, uint32_t cbMaxPerSec)
+{
+    AssertPtrReturn(phAsync, VERR_INVALID_POINTER);
+    *phAsync = NIL_RTLOGASYNCOUTPUT;
+    AssertPtrNullReturn(pLowerIf, VERR_INVALID_POINTER);
+    AssertReturn(cbBuffer <= RTLOGASYNC_MAX_BUFFER_SIZE, VERR_OUT_OF_RANGE);
+
+    if (!cbBuffer)
+        cbBuffer = RTLOGASYNCOUTPUT_DEFAULT_BUFFER_SIZE;
+    size_t cbRing = RTLOGASYNC_MIN_BUFFER_SIZE;
+    while (cbRing < cbBuffer)
+        cbRing <<= 1;
+
+    PRTLOGASYNCOUTPUTINT pThis = (PRTLOGASYNCOUTPUTINT)RTMemAllocZ(sizeof(*pThis));
+    if (!pThis)
+        return VERR_NO_MEMORY;
+    pThis->u32Magic    = RTLOGASYNCOUTPUT_MAGIC;
+    pThis->iSlot       = UINT32_MAX;
+    pThis->pLowerIf    = pLowerIf ? pLowerIf : &g_rtLogAsyncFileIf;
+    pThis->pvLowerUser = pLowerIf ? pvLowerUser : pThis;
+    pThis->hFile       = NIL_RTFILE;
+    pThis->cbRing      = cbRing;
+    pThis->cbMaxPerSec = cbMaxPerSec;
+    pThis->hEvtWriter  = NIL_RTSEMEVENT;
+    pThis->hThread     = NIL_RTTHREAD;
+
+    int rc = VERR_NO_MEMORY;
+    pThis->pbRing = (uint8_t *)RTMemPageAlloc(cbRing);
+    if (pThis->pbRing)
+    {
+        /* No lock validation, these are taken from inside the logger. */
+        rc = RTCritSectInitEx(&pThis->CritSectProduce, RTCRITSECT_FLAGS_NO_LOCK_VAL, NIL_RTLOCKVALCLASS,
+                              RTLOCKVAL_SUB_CLASS_NONE, NULL);
+        if (RT_SUCCESS(rc))
+        {
+            rc = RTCritSectInitEx(&pThis->CritSectWrite, RTCRITSECT_FLAGS_NO_LOCK_VAL, NIL_RTLOCKVALCLASS,
+                                  RTLOCKVAL_SUB_CLASS_NONE, NULL);
+            if (RT_SUCCESS(rc))
+            {
+                rc = RTSemEventCreateEx(&pThis->hEvtWriter, RTSEMEVENT_FLAGS_NO_LOCK_VAL, NIL_RTLOCKVALCLASS, NULL);
+                if (RT_SUCCESS(rc))
+                {
+                    rc = RTThreadCreate(&pThis->hThread, rtLogAsyncWriterThread, pThis, 0 /*cbStack*/,
+                                        RTTHREADTYPE_IO, RTTHREADFLAGS_WAITABLE, "LogWriter");
+                    if (RT_SUCCESS(rc))
+                    {
+                        for (uint32_t i = 0; i < RT_ELEMENTS(g_apInstances); i++)
+                            if (ASMAtomicCmpXchgPtr(&g_apInstances[i], pThis, NULL))
+                            {
+                                pThis->iSlot = i;
+                                break;
+                            }
+                        *phAsync = pThis;
+                        return VINF_SUCCESS;
+                    }
+                    RTSemEventDestroy(pThis->hEvtWriter);
+                }
+                RTCritSectDelete(&pThis->CritSectWrite);
+            }
+            RTCritSectDelete(&pThis->CritSectProduce);
+        }
+        RTMemPageFree(pThis->pbRing, cbRing);
+    }
+    RTMemFree(pThis);
+    return rc;
+}
+RT_EXPORT_SYMBOL(RTLogAsyncOutputCreate);
+
+
+RTDECL(int) RTLogAsyncOutputDestroy(RTLOGASYNCOUTPUT hAsync)
+{
+    PRTLOGASYNCOUTPUTINT pThis = hAsync;
+    if (pThis == NIL_RTLOGASYNCOUTPUT)
+        return VINF_SUCCESS;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertReturn(pThis->u32Magic == RTLOGASYNCOUTPUT_MAGIC, VERR_INVALID_HANDLE);
+
+    if (pThis->iSlot < RT_ELEMENTS(g_apInstances))
+        ASMAtomicCmpXchgPtr(&g_apInstances[pThis->iSlot], NULL, pThis);
+
+    ASMAtomicWriteBool(&pThis->fShutdown, true);
+    RTSemEventSignal(pThis->hEvtWriter);
+    int rc = RTThreadWait(pThis->hThread, RT_MS_30SEC, NULL);
+    AssertRCReturn(rc, rc);
+
+    /* Catch anything written after the thread's final drain. */
+    rtLogAsyncDrain(pThis, false /*fFlush*/);
+    if (pThis->hFile != NIL_RTFILE)
+    {
+        RTFileClose(pThis->hFile);
+        pThis->hFile = NIL_RTFILE;
+    }
+
+    ASMAtomicWriteU32(&pThis->u32Magic, RTLOGASYNCOUTPUT_MAGIC_DEAD);
+    RTSemEventDestroy(pThis->hEvtWriter);
+    RTCritSectDelete(&pThis->CritSectWrite);
+    RTCritSectDelete(&pThis->CritSectProduce);
+    RTMemPageFree(pThis->pbRing, pThis->cbRing);
+    RTMemFree(pThis);
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTLogAsyncOutputDestroy);
+
+
+RTDECL(PCRTLOGOUTPUTIF) RTLogAsyncOutputGetIf(void)
+{
+    return &g_rtLogAsyncOutputIf;
+}
+RT_EXPORT_SYMBOL(RTLogAsyncOutputGetIf);
+
+
+RTDECL(int) RTLogAsyncOutputFlush(RTLOGASYNCOUTPUT hAsync)
+{
+    PRTLOGASYNCOUTPUTINT pThis = hAsync;
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertReturn(pThis->u32Magic == RTLOGASYNCOUTPUT_MAGIC, VERR_INVALID_HANDLE);
+    return rtLogAsyncDrain(pThis, true /*fFlush*/);
+}
+RT_EXPORT_SYMBOL(RTLogAsyncOutputFlush);
+
+
+RTDECL(void) RTLogAsyncOutputFlushAll(void)
+{
+    for (uint32_t i = 0; i < RT_ELEMENTS(g_apInstances); i++)
+    {
+        PRTLOGASYNCOUTPUTINT pThis = ASMAtomicReadPtrT(&g_apInstances[i], PRTLOGASYNCOUTPUTINT);
+        if (pThis && pThis->u32Magic == RTLOGASYNCOUTPUT_MAGIC)
+            rtLogAsyncDrain(pThis, true /*fFlush*/);
+    }
+}
+RT_EXPORT_SYMBOL(RTLogAsyncOutputFlushAll);
+
+
+RTDECL(uint64_t) RTLogAsyncOutputGetDropped(RTLOGASYNCOUTPUT hAsync)
+{
+    PRTLOGASYNCOUTPUTINT pThis = hAsync;
+    AssertPtrReturn(pThis, 0);
+    AssertReturn(pThis->u32Magic == RTLOGASYNCOUTPUT_MAGIC, 0);
+    return ASMAtomicReadU64(&pThis->cbDropped);
+}
+RT_EXPORT_SYMBOL(RTLogAsyncOutputGetDropped);
+
@@ -98,6 +98,44 @@
 AssertCompileMembersSameSizeAndOffset(struct iovec, iov_base, RTSGSEG, pvSeg);
 AssertCompileMembersSameSizeAndOffset(struct iovec, iov_len,  RTSGSEG, cbSeg);
 
+/** Number of iovec entries gathered on the stack for each preadv / pwritev
+ * call when the S/G buffer can't be passed on directly. */
+# define RTFILESG_MAX_STACK_IOVS    64
+
+
+/**
+ * Gathers the next chunk of @a pSgBuf into @a paIovs without advancing it.
+ *
+ * @returns Number of iovec entries used.
+ * @param   pSgBuf      The S/G buffer.
+ * @param   cbMax       Max number of bytes to gather.
+ * @param   paIovs      The iovec array to fill in, RTFILESG_MAX_STACK_IOVS entries.
+ * @param   pcbGathered Where to return the number of bytes gathered.
+ */
+static unsigned rtFileSgGatherIovs(PCRTSGBUF pSgBuf, size_t cbMax, struct iovec *paIovs, size_t *pcbGathered)
+{
+    RTSGBUF SgBufTmp;
+    RTSgBufClone(&SgBufTmp, pSgBuf);
+
+    size_t   cbGathered = 0;
+    unsigned cIovs      = 0;
+    while (cIovs < RTFILESG_MAX_STACK_IOVS && cbGathered < cbMax)
+    {
+        size_t cbSeg = 0;
+        void  *pvSeg = RTSgBufGetCurrentSegment(&SgBufTmp, cbMax - cbGathered, &cbSeg);
+        if (!cbSeg)
+            break;
+        paIovs[cIovs].iov_base = pvSeg;
+        paIovs[cIovs].iov_len  = cbSeg;
+        cIovs++;
+        cbGathered += cbSeg;
+        RTSgBufAdvance(&SgBufTmp, cbSeg);
+    }
+
+    *pcbGathered = cbGathered;
+    return cIovs;
+}
+
 
 RTDECL(int)  RTFileSgReadAt(RTFILE hFile, RTFOFF off, PRTSGBUF pSgBuf, size_t cbToRead, size_t *pcbRead)
 {
@@ -164,32 +202,42 @@ RTDECL(int)  RTFileSgReadAt(RTFILE hFile, RTFOFF off, PRTSGBUF pSgBuf, size_t cb
         }
 
     /*
-     * Unaligned start or not reading the whole buffer.  For reasons of
-     * simplicity, we work the input segment by segment like the generic code.
+     * Unaligned start or not reading the whole buffer.  Gather the segments
+     * into a stack iovec array, so large lists of small segments (like guest
+     * page lists) still take one syscall per RTFILESG_MAX_STACK_IOVS segments
+     * rather than one per segment.
      */
     int rc = VINF_SUCCESS;
     while (cbToRead > 0)
     {
-        size_t cbSeg;
-        void  *pvSeg = RTSgBufGetCurrentSegment(pSgBuf, cbToRead, &cbSeg);
-        size_t cbThisRead = cbSeg;
-        rc = RTFileReadAt(hFile, off, pvSeg, cbSeg, pcbRead ? &cbThisRead : NULL);
-        if (RT_SUCCESS(rc))
-        {
-            RTSgBufAdvance(pSgBuf, cbThisRead);
-            cbTotalRead += cbThisRead;
-        }
-        else
-            break;
-        if ((size_t)cbThisRead < cbSeg)
+        struct iovec aIovs[RTFILESG_MAX_STACK_IOVS];
+        size_t       cbThisRead = 0;
+        unsigned     cIovs      = rtFileSgGatherIovs(pSgBuf, cbToRead, aIovs, &cbThisRead);
+        AssertBreakStmt(cIovs > 0, rc = VERR_INTERNAL_ERROR_2);
+
+        ssize_t cbActual = preadv(RTFileToNative(hFile), aIovs, cIovs, off);
+        if (cbActual < 0)
         {
-            AssertStmt(pcbRead, rc = VERR_INTERNAL_ERROR_2);
+            if (cbTotalRead == 0 || !pcbRead)
+                rc = RTErrConvertFromErrno(errno);
             break;
         }
+        AssertStmt((size_t)cbActual <= cbThisRead, cbActual = cbThisRead);
 
-        Assert(cbSeg == cbThisRead);
-        cbToRead -= cbSeg;
-        off      += cbSeg;
+        RTSgBufAdvance(pSgBuf, cbActual);
+        cbTotalRead += cbActual;
+        cbToRead    -= cbActual;
+        off         += cbActual;
+        if ((size_t)cbActual < cbThisRead)
+        {
+            if (pcbRead)
+                break;
+            if (cbActual == 0)
+            {
+                rc = VERR_EOF;
+                break;
+            }
+        }
     }
     if (pcbRead)
         *pcbRead = cbTotalRead;
@@ -262,32 +310,40 @@ RTDECL(int)  RTFileSgWriteAt(RTFILE hFile, RTFOFF off, PRTSGBUF pSgBuf, size_t c
         }
 
     /*
-     * Unaligned start or not writing the whole buffer.  For reasons of
-     * simplicity, we work the input segment by segment like the generic code.
+     * Unaligned start or not writing the whole buffer.  Gather the segments
+     * into a stack iovec array like RTFileSgReadAt does.
      */
     int rc = VINF_SUCCESS;
     while (cbToWrite > 0)
     {
-        size_t cbSeg;
-        void  *pvSeg = RTSgBufGetCurrentSegment(pSgBuf, cbToWrite, &cbSeg);
-        size_t cbThisWritten = cbSeg;
-        rc = RTFileWriteAt(hFile, off, pvSeg, cbSeg, pcbWritten ? &cbThisWritten : NULL);
-        if (RT_SUCCESS(rc))
-        {
-            RTSgBufAdvance(pSgBuf, cbThisWritten);
-            cbTotalWritten += cbThisWritten;
-        }
-        else
-            break;
-        if ((size_t)cbThisWritten < cbSeg)
+        struct iovec aIovs[RTFILESG_MAX_STACK_IOVS];
+        size_t       cbThisWrite = 0;
+        unsigned     cIovs       = rtFileSgGatherIovs(pSgBuf, cbToWrite, aIovs, &cbThisWrite);
+        AssertBreakStmt(cIovs > 0, rc = VERR_INTERNAL_ERROR_2);
+
+        ssize_t cbActual = pwritev(RTFileToNative(hFile), aIovs, cIovs, off);
+        if (cbActual < 0)
         {
-            AssertStmt(pcbWritten, rc = VERR_INTERNAL_ERROR_2);
+            if (cbTotalWritten == 0 || !pcbWritten)
+                rc = RTErrConvertFromErrno(errno);
             break;
         }
+        AssertStmt((size_t)cbActual <= cbThisWrite, cbActual = cbThisWrite);
 
-        Assert(cbSeg == cbThisWritten);
-        cbToWrite -= cbSeg;
-        off       += cbSeg;
+        RTSgBufAdvance(pSgBuf, cbActual);
+        cbTotalWritten += cbActual;
+        cbToWrite      -= cbActual;
+        off            += cbActual;
+        if ((size_t)cbActual < cbThisWrite)
+        {
+            if (pcbWritten)
+                break;
+            if (cbActual == 0)
+            {
+                rc = VERR_TRY_AGAIN;
+                break;
+            }
+        }
     }
     if (pcbWritten)
         *pcbWritten = cbTotalWritten;
@@ -639,6 +639,31 @@ RTR3DECL(int)  RTUdpWrite(PRTUDPSERVER pServer, const void *pvBuffer, size_t cbB
 }
 
 
+RTR3DECL(int) RTUdpServerQuerySocket(PRTUDPSERVER pServer, PRTSOCKET phSocket)
+{
+    /*
+     * Validate input and retain the instance.
+     */
+    AssertPtrReturn(phSocket, VERR_INVALID_POINTER);
+    *phSocket = NIL_RTSOCKET;
+    AssertPtrReturn(pServer, VERR_INVALID_HANDLE);
+    AssertReturn(pServer->u32Magic == RTUDPSERVER_MAGIC, VERR_INVALID_HANDLE);
+    AssertReturn(RTMemPoolRetain(pServer) != UINT32_MAX, VERR_INVALID_HANDLE);
+
+    int rc = VINF_SUCCESS;
+    RTSOCKET hSocket;
+    ASMAtomicReadHandle(&pServer->hSocket, &hSocket);
+    if (   hSocket != NIL_RTSOCKET
+        && RTSocketRetain(hSocket) != UINT32_MAX)
+        *phSocket = hSocket;
+    else
+        rc = VERR_INVALID_HANDLE;
+
+    RTMemPoolRelease(RTMEMPOOL_DEFAULT, pServer);
+    return rc;
+}
+
+
 RTR3DECL(int) RTUdpCreateClientSocket(const char *pszAddress, uint32_t uPort, PRTNETADDR pLocalAddr, PRTSOCKET pSock)
 {
     /*
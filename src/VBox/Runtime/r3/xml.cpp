@@ -2196,13 +2196,25 @@ private:
 void XmlFileParser::read(const RTCString &strFilename,
                          Document &doc)
 {
-    GlobalLock lock;
-//     global.setExternalEntityLoader(ExternalEntityLoader);
-
     m->strXmlFilename = strFilename;
     const char *pcszFilename = strFilename.c_str();
 
-    ReadContext context(pcszFilename);
+    /* Read the whole file before taking the global lock, so that parsers
+       running on other threads aren't held up by our file I/O. */
+    void  *pvFile = NULL;
+    size_t cbFile = 0;
+    int vrc = RTFileReadAllEx(pcszFilename, 0, RTFOFF_MAX, RTFILE_RDALL_O_DENY_NONE, &pvFile, &cbFile);
+    if (RT_FAILURE(vrc))
+        throw EIPRTFailure(vrc, "Runtime error opening '%s' for reading", pcszFilename);
+    if (cbFile > (size_t)INT32_MAX)
+    {
+        RTFileReadAllFree(pvFile, cbFile);
+        throw EIPRTFailure(VERR_FILE_TOO_BIG, "Runtime error reading from file '%s'", pcszFilename);
+    }
+
+    GlobalLock lock;
+//     global.setExternalEntityLoader(ExternalEntityLoader);
+
     doc.m->reset();
     const int options = XML_PARSE_NOBLANKS /* remove blank nodes */
                       | XML_PARSE_NONET    /* forbit any network access */
@@ -2211,13 +2223,14 @@ void XmlFileParser::read(const RTCString &strFilename,
                                               to 256 (bad for snapshots!) */
 #endif
                 ;
-    if (!(doc.m->plibDocument = xmlCtxtReadIO(m_ctxt,
-                                              ReadCallback,
-                                              CloseCallback,
-                                              &context,
-                                              pcszFilename,
-                                              NULL,       // encoding = auto
-                                              options)))
+    doc.m->plibDocument = xmlCtxtReadMemory(m_ctxt,
+                                            (const char *)pvFile,
+                                            (int)cbFile,
+                                            pcszFilename,
+                                            NULL,       // encoding = auto
+                                            options);
+    RTFileReadAllFree(pvFile, cbFile);
+    if (!doc.m->plibDocument)
         throw XmlError((xmlErrorPtr)xmlCtxtGetLastError(m_ctxt));
 
     doc.refreshInternals();
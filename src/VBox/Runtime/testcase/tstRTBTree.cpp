@@ -0,0 +1,256 @@
+/* $Id$ */
+/** @file
+ * IPRT Testcase - B+Tree.
+ */
+
+/*
+ * Copyright (C) 2006-2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#include <iprt/btree.h>
+
+#include <iprt/err.h>
+#include <iprt/rand.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Number of key slots used by the random test, slot i covers keys i*4 thru i*4+3. */
+#define TST_SLOTS       8192
+
+
+/*********************************************************************************************************************************
+*   Global Variables                                                                                                             *
+*********************************************************************************************************************************/
+/** The length - 1 of the range in each slot, UINT8_MAX if not in the tree. */
+static uint8_t g_abShadow[TST_SLOTS];
+
+
+/** Value for the range in slot @a iSlot. */
+#define TST_VALUE(iSlot)    ((void *)(uintptr_t)((iSlot) + 1))
+
+
+typedef struct TSTENUM
+{
+    uint64_t    uPrevKey;
+    uint32_t    cCalls;
+    bool        fFromLeft;
+} TSTENUM;
+
+static DECLCALLBACK(int) tstEnumCallback(uint64_t uKey, uint64_t uKeyLast, void *pvValue, void *pvUser)
+{
+    TSTENUM *pState = (TSTENUM *)pvUser;
+    uint32_t const iSlot = (uint32_t)(uKey / 4);
+    RTTESTI_CHECK_RET(iSlot < TST_SLOTS && uKey % 4 == 0, VERR_INTERNAL_ERROR);
+    RTTESTI_CHECK_RET(g_abShadow[iSlot] != UINT8_MAX, VERR_INTERNAL_ERROR);
+    RTTESTI_CHECK_RET(uKeyLast == uKey + g_abShadow[iSlot], VERR_INTERNAL_ERROR);
+    RTTESTI_CHECK_RET(pvValue == TST_VALUE(iSlot), VERR_INTERNAL_ERROR);
+    if (pState->cCalls)
+        RTTESTI_CHECK_RET(pState->fFromLeft ? uKey > pState->uPrevKey : uKey < pState->uPrevKey, VERR_INTERNAL_ERROR);
+    pState->uPrevKey = uKey;
+    pState->cCalls++;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Checks the whole tree against the shadow array.
+ */
+static void tstCheckAll(RTTEST hTest, RTBTREEU64 hTree, uint32_t cExpected)
+{
+    RTTEST_CHECK(hTest, RTBTreeU64GetCount(hTree) == cExpected);
+
+    TSTENUM State = { 0, 0, true };
+    RTTEST_CHECK_RC(hTest, RTBTreeU64DoWithAll(hTree, true /*fFromLeft*/, tstEnumCallback, &State), VINF_SUCCESS);
+    RTTEST_CHECK(hTest, State.cCalls == cExpected);
+    State.cCalls    = 0;
+    State.fFromLeft = false;
+    RTTEST_CHECK_RC(hTest, RTBTreeU64DoWithAll(hTree, false /*fFromLeft*/, tstEnumCallback, &State), VINF_SUCCESS);
+    RTTEST_CHECK(hTest, State.cCalls == cExpected);
+
+    int32_t iPrev = -1;
+    for (uint32_t iSlot = 0; iSlot < TST_SLOTS; iSlot++)
+    {
+        uint64_t const uKey = iSlot * 4;
+        for (uint32_t off = 0; off < 4; off++)
+        {
+            bool const  fIn = g_abShadow[iSlot] != UINT8_MAX && off <= g_abShadow[iSlot];
+            uint64_t    uFirst = 0, uLast = 0;
+            void       *pv = RTBTreeU64RangeGet(hTree, uKey + off, &uFirst, &uLast);
+            if (fIn)
+                RTTEST_CHECK(hTest, pv == TST_VALUE(iSlot) && uFirst == uKey && uLast == uKey + g_abShadow[iSlot]);
+            else
+                RTTEST_CHECK(hTest, pv == NULL);
+        }
+
+        RTTEST_CHECK(hTest, RTBTreeU64Get(hTree, uKey) == (g_abShadow[iSlot] != UINT8_MAX ? TST_VALUE(iSlot) : NULL));
+        if (g_abShadow[iSlot] != UINT8_MAX)
+            iPrev = (int32_t)iSlot;
+
+        /* Best fit below must return the closest slot at or before this one. */
+        void *pv = RTBTreeU64GetBestFit(hTree, uKey + 1, false /*fAbove*/, NULL, NULL);
+        RTTEST_CHECK(hTest, pv == (iPrev >= 0 ? TST_VALUE(iPrev) : NULL));
+        if (RTTestErrorCount(hTest) > 0)
+            return;
+    }
+
+    /* Best fit above, walking backwards. */
+    int32_t iNext = -1;
+    for (uint32_t iSlot = TST_SLOTS; iSlot-- > 0;)
+    {
+        if (g_abShadow[iSlot] != UINT8_MAX)
+            iNext = (int32_t)iSlot;
+        void *pv = RTBTreeU64GetBestFit(hTree, iSlot * 4, true /*fAbove*/, NULL, NULL);
+        RTTEST_CHECK_RETV(hTest, pv == (iNext >= 0 ? TST_VALUE(iNext) : NULL));
+    }
+}
+
+
+static void tstBasic(RTTEST hTest)
+{
+    RTTestSub(hTest, "Basics");
+
+    RTBTREEU64 hTree = NIL_RTBTREEU64;
+    RTTEST_CHECK_RC_OK_RETV(hTest, RTBTreeU64Create(&hTree));
+    RTTEST_CHECK(hTest, RTBTreeU64Get(hTree, 0) == NULL);
+    RTTEST_CHECK(hTest, RTBTreeU64RangeGet(hTree, 0, NULL, NULL) == NULL);
+    RTTEST_CHECK(hTest, RTBTreeU64GetBestFit(hTree, 0, true /*fAbove*/, NULL, NULL) == NULL);
+    RTTEST_CHECK(hTest, RTBTreeU64Remove(hTree, 0) == NULL);
+
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Insert(hTree, 0x1000, 0x1fff, TST_VALUE(1)), VINF_SUCCESS);
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Insert(hTree, 0x3000, 0x3fff, TST_VALUE(3)), VINF_SUCCESS);
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Insert(hTree, 0x1800, 0x1800, TST_VALUE(9)), VERR_ALREADY_EXISTS);
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Insert(hTree, 0x0000, 0x1000, TST_VALUE(9)), VERR_ALREADY_EXISTS);
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Insert(hTree, 0x2000, 0x3000, TST_VALUE(9)), VERR_ALREADY_EXISTS);
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Insert(hTree, 0x0000, 0xffff, TST_VALUE(9)), VERR_ALREADY_EXISTS);
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Insert(hTree, 0x2000, 0x2fff, TST_VALUE(2)), VINF_SUCCESS);
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Insert(hTree, UINT64_MAX, UINT64_MAX, TST_VALUE(4)), VINF_SUCCESS);
+
+    RTTEST_CHECK(hTest, RTBTreeU64GetCount(hTree) == 4);
+    RTTEST_CHECK(hTest, RTBTreeU64RangeGet(hTree, 0x2abc, NULL, NULL) == TST_VALUE(2));
+    RTTEST_CHECK(hTest, RTBTreeU64RangeGet(hTree, 0x4000, NULL, NULL) == NULL);
+    RTTEST_CHECK(hTest, RTBTreeU64GetBestFit(hTree, 0x4000, false /*fAbove*/, NULL, NULL) == TST_VALUE(3));
+    RTTEST_CHECK(hTest, RTBTreeU64GetBestFit(hTree, 0x4000, true /*fAbove*/, NULL, NULL) == TST_VALUE(4));
+    RTTEST_CHECK(hTest, RTBTreeU64GetBestFit(hTree, 0x0fff, false /*fAbove*/, NULL, NULL) == NULL);
+    RTTEST_CHECK(hTest, RTBTreeU64Remove(hTree, 0x2001) == NULL);
+    RTTEST_CHECK(hTest, RTBTreeU64Remove(hTree, 0x2000) == TST_VALUE(2));
+    RTTEST_CHECK(hTest, RTBTreeU64GetCount(hTree) == 3);
+
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Destroy(hTree, NULL, NULL), VINF_SUCCESS);
+}
+
+
+static void tstRandom(RTTEST hTest)
+{
+    RTTestSub(hTest, "Random insert/remove");
+
+    RTBTREEU64 hTree = NIL_RTBTREEU64;
+    RTTEST_CHECK_RC_OK_RETV(hTest, RTBTreeU64Create(&hTree));
+    memset(g_abShadow, UINT8_MAX, sizeof(g_abShadow));
+    uint32_t cEntries = 0;
+
+    /* Sequential fill, then random churn biased first towards inserting and then towards removing. */
+    for (uint32_t iSlot = 0; iSlot < TST_SLOTS; iSlot += 2)
+    {
+        g_abShadow[iSlot] = (uint8_t)(iSlot % 4);
+        RTTEST_CHECK_RC_RETV(hTest, RTBTreeU64Insert(hTree, iSlot * 4, iSlot * 4 + g_abShadow[iSlot], TST_VALUE(iSlot)),
+                             VINF_SUCCESS);
+        cEntries++;
+    }
+    tstCheckAll(hTest, hTree, cEntries);
+
+    for (uint32_t iRound = 0; iRound < 4 && !RTTestErrorCount(hTest); iRound++)
+    {
+        uint32_t const uInsertPct = iRound & 1 ? 20 : 80;
+        for (uint32_t i = 0; i < TST_SLOTS * 4; i++)
+        {
+            uint32_t const iSlot = RTRandU32Ex(0, TST_SLOTS - 1);
+            if (RTRandU32Ex(0, 99) < uInsertPct)
+            {
+                uint8_t const bLen = (uint8_t)RTRandU32Ex(0, 3);
+                int rc = RTBTreeU64Insert(hTree, iSlot * 4, iSlot * 4 + bLen, TST_VALUE(iSlot));
+                if (g_abShadow[iSlot] == UINT8_MAX)
+                {
+                    RTTEST_CHECK_RC_RETV(hTest, rc, VINF_SUCCESS);
+                    g_abShadow[iSlot] = bLen;
+                    cEntries++;
+                }
+                else
+                    RTTEST_CHECK_RC_RETV(hTest, rc, VERR_ALREADY_EXISTS);
+            }
+            else
+            {
+                void *pv = RTBTreeU64Remove(hTree, iSlot * 4);
+                RTTEST_CHECK_RETV(hTest, pv == (g_abShadow[iSlot] != UINT8_MAX ? TST_VALUE(iSlot) : NULL));
+                if (pv)
+                {
+                    g_abShadow[iSlot] = UINT8_MAX;
+                    cEntries--;
+                }
+            }
+        }
+        tstCheckAll(hTest, hTree, cEntries);
+    }
+
+    /* Empty it completely. */
+    for (uint32_t iSlot = 0; iSlot < TST_SLOTS; iSlot++)
+        if (g_abShadow[iSlot] != UINT8_MAX)
+        {
+            RTTEST_CHECK(hTest, RTBTreeU64Remove(hTree, iSlot * 4) == TST_VALUE(iSlot));
+            g_abShadow[iSlot] = UINT8_MAX;
+            cEntries--;
+        }
+    tstCheckAll(hTest, hTree, 0);
+
+    RTTEST_CHECK_RC(hTest, RTBTreeU64Destroy(hTree, NULL, NULL), VINF_SUCCESS);
+}
+
+
+int main()
+{
+    RTTEST hTest;
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstRTBTree", &hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(hTest);
+
+    tstBasic(hTest);
+    tstRandom(hTest);
+
+    return RTTestSummaryAndDestroy(hTest);
+}
+
@@ -39,6 +39,7 @@
 *   Header Files                                                                                                                 *
 *********************************************************************************************************************************/
 #include <iprt/crypto/digest.h>
+#include <iprt/crc.h>
 #include <iprt/md2.h>
 #include <iprt/md4.h>
 #include <iprt/md5.h>
@@ -48,6 +49,7 @@
 #include <iprt/err.h>
 #include <iprt/test.h>
 #include <iprt/thread.h>
+#include <iprt/time.h>
 #include <iprt/string.h>
 
 
@@ -2058,6 +2060,110 @@ static void testSha3_512(void)
 }
 
 
+/**
+ * Bit-by-bit reference implementation of the reflected CRC32 variants.
+ */
+static uint32_t crcRefReflected32(uint32_t uPoly, uint8_t const *pb, size_t cb)
+{
+    uint32_t uCrc = ~UINT32_C(0);
+    while (cb-- > 0)
+    {
+        uCrc ^= *pb++;
+        for (unsigned iBit = 0; iBit < 8; iBit++)
+            uCrc = (uCrc >> 1) ^ (uPoly & (UINT32_C(0) - (uCrc & 1)));
+    }
+    return ~uCrc;
+}
+
+
+/**
+ * Checks the CRC32 and CRC32C code against the reference implementation with
+ * lengths and alignments hitting the table and the accelerated code paths.
+ */
+static void testCrc32(void)
+{
+    RTTestISub("CRC32 and CRC32C");
+
+    static uint8_t s_abBuf[_64K + 64];
+    for (size_t i = 0; i < sizeof(s_abBuf); i++)
+        s_abBuf[i] = (uint8_t)(i * 7 + (i >> 8) * 13);
+
+    /* Well known check values. */
+    RTTESTI_CHECK(RTCrc32("123456789", 9)  == UINT32_C(0xcbf43926));
+    RTTESTI_CHECK(RTCrc32C("123456789", 9) == UINT32_C(0xe3069283));
+
+    static size_t const s_acbTests[] = { 0, 1, 7, 8, 15, 16, 63, 64, 65, 127, 128, 129, 255, 1000, 4096, 4097, _64K };
+    for (unsigned off = 0; off < 16; off++)
+        for (unsigned i = 0; i < RT_ELEMENTS(s_acbTests); i++)
+        {
+            size_t const   cb = s_acbTests[i];
+            uint8_t const *pb = &s_abBuf[off];
+
+            uint32_t const uCrc32Ref = crcRefReflected32(UINT32_C(0xedb88320), pb, cb);
+            uint32_t const uCrc32    = RTCrc32(pb, cb);
+            if (uCrc32 != uCrc32Ref)
+                RTTestIFailed("RTCrc32 off=%u cb=%zu: %#RX32, expected %#RX32", off, cb, uCrc32, uCrc32Ref);
+
+            /* Split into two chunks so the accelerated path gets an odd start value and length. */
+            uint32_t uCrc = RTCrc32Start();
+            uCrc = RTCrc32Process(uCrc, pb, cb / 3);
+            uCrc = RTCrc32Process(uCrc, pb + cb / 3, cb - cb / 3);
+            if (RTCrc32Finish(uCrc) != uCrc32Ref)
+                RTTestIFailed("RTCrc32Process off=%u cb=%zu: %#RX32, expected %#RX32", off, cb, RTCrc32Finish(uCrc), uCrc32Ref);
+
+            uint32_t const uCrc32CRef = crcRefReflected32(UINT32_C(0x82f63b78), pb, cb);
+            uint32_t const uCrc32C    = RTCrc32C(pb, cb);
+            if (uCrc32C != uCrc32CRef)
+                RTTestIFailed("RTCrc32C off=%u cb=%zu: %#RX32, expected %#RX32", off, cb, uCrc32C, uCrc32CRef);
+        }
+}
+
+
+/**
+ * Throughput benchmarks for the checksums on hot paths.
+ */
+static void testBenchmark(void)
+{
+    RTTestISub("Throughput");
+
+    size_t const cbBuf   = _1M;
+    unsigned const cIter = 32;
+    uint8_t *pbBuf = (uint8_t *)RTTestGuardedAllocTail(NIL_RTTEST, cbBuf);
+    RTTESTI_CHECK_RETV(pbBuf);
+    for (size_t i = 0; i < cbBuf; i++)
+        pbBuf[i] = (uint8_t)(i * 13);
+
+    uint32_t volatile uSink = 0;
+    uint64_t nsStart = RTTimeNanoTS();
+    for (unsigned i = 0; i < cIter; i++)
+        uSink += RTCrc32(pbBuf, cbBuf);
+    uint64_t cNsElapsed = RT_MAX(RTTimeNanoTS() - nsStart, 1);
+    RTTestIValue("RTCrc32", (uint64_t)cbBuf * cIter * RT_NS_1SEC / cNsElapsed, RTTESTUNIT_BYTES_PER_SEC);
+
+    nsStart = RTTimeNanoTS();
+    for (unsigned i = 0; i < cIter; i++)
+        uSink += RTCrc32C(pbBuf, cbBuf);
+    cNsElapsed = RT_MAX(RTTimeNanoTS() - nsStart, 1);
+    RTTestIValue("RTCrc32C", (uint64_t)cbBuf * cIter * RT_NS_1SEC / cNsElapsed, RTTESTUNIT_BYTES_PER_SEC);
+
+    nsStart = RTTimeNanoTS();
+    for (unsigned i = 0; i < cIter; i++)
+        uSink += (uint32_t)RTCrc64(pbBuf, cbBuf);
+    cNsElapsed = RT_MAX(RTTimeNanoTS() - nsStart, 1);
+    RTTestIValue("RTCrc64", (uint64_t)cbBuf * cIter * RT_NS_1SEC / cNsElapsed, RTTESTUNIT_BYTES_PER_SEC);
+
+    uint8_t abHash[RTSHA256_HASH_SIZE];
+    nsStart = RTTimeNanoTS();
+    for (unsigned i = 0; i < cIter; i++)
+        RTSha256(pbBuf, cbBuf, abHash);
+    cNsElapsed = RT_MAX(RTTimeNanoTS() - nsStart, 1);
+    RTTestIValue("RTSha256", (uint64_t)cbBuf * cIter * RT_NS_1SEC / cNsElapsed, RTTESTUNIT_BYTES_PER_SEC);
+
+    RT_NOREF(uSink);
+    RTTestGuardedFree(NIL_RTTEST, pbBuf);
+}
+
+
 static unsigned checkArgs(int cArgs, char **papszArgs, const char *pszName, const char *pszFamily)
 {
     if (cArgs <= 1)
@@ -2111,6 +2217,8 @@ int main(int argc, char **argv)
     DO("SHA3-256", "SHA3", testSha3_256());
     DO("SHA3-384", "SHA3", testSha3_384());
     DO("SHA3-512", "SHA3", testSha3_512());
+    DO("CRC32",    "CRC",  testCrc32());
+    DO("BENCH",    "BENCH", testBenchmark());
 
     return RTTestSummaryAndDestroy(hTest);
 }
@@ -404,6 +404,109 @@ static void tstCorrectness(RTTEST hTest)
         RTTestFailed(hTest, "RTJsonParseFromString() returned success but no value\n");
 }
 
+/**
+ * Event parser callback state.
+ */
+typedef struct TSTJSONEVTS
+{
+    /** The events so far in textual form. */
+    char        szEvents[1024];
+    /** Current offset into szEvents. */
+    size_t      offEvents;
+    /** Maximum depth seen. */
+    uint32_t    cMaxDepth;
+    /** Number of events to report before returning VINF_CALLBACK_RETURN, UINT32_MAX for all. */
+    uint32_t    cEventsLeft;
+} TSTJSONEVTS;
+
+static DECLCALLBACK(int) tstEventsCallback(void *pvUser, RTJSONEVT enmEvt, PCRTJSONEVTDATA pData)
+{
+    TSTJSONEVTS *pThis = (TSTJSONEVTS *)pvUser;
+    char *pszDst = &pThis->szEvents[pThis->offEvents];
+    size_t const cbDst = sizeof(pThis->szEvents) - pThis->offEvents;
+    switch (enmEvt)
+    {
+        case RTJSONEVT_BEGIN_OBJECT: pThis->offEvents += RTStrPrintf(pszDst, cbDst, "{"); break;
+        case RTJSONEVT_END_OBJECT:   pThis->offEvents += RTStrPrintf(pszDst, cbDst, "}"); break;
+        case RTJSONEVT_BEGIN_ARRAY:  pThis->offEvents += RTStrPrintf(pszDst, cbDst, "["); break;
+        case RTJSONEVT_END_ARRAY:    pThis->offEvents += RTStrPrintf(pszDst, cbDst, "]"); break;
+        case RTJSONEVT_KEY:
+            RTTESTI_CHECK(strlen(pData->u.Str.psz) == pData->u.Str.cch);
+            pThis->offEvents += RTStrPrintf(pszDst, cbDst, "%s:", pData->u.Str.psz);
+            break;
+        case RTJSONEVT_STRING:
+            RTTESTI_CHECK(strlen(pData->u.Str.psz) == pData->u.Str.cch);
+            if (pData->u.Str.cch > 32)
+                pThis->offEvents += RTStrPrintf(pszDst, cbDst, "'#%zu'", pData->u.Str.cch);
+            else
+                pThis->offEvents += RTStrPrintf(pszDst, cbDst, "'%s'", pData->u.Str.psz);
+            break;
+        case RTJSONEVT_INTEGER:      pThis->offEvents += RTStrPrintf(pszDst, cbDst, "%RI64", pData->u.i64Num); break;
+        case RTJSONEVT_NUMBER:       pThis->offEvents += RTStrPrintf(pszDst, cbDst, "%d", (int)(pData->u.rdNum * 100)); break;
+        case RTJSONEVT_NULL:         pThis->offEvents += RTStrPrintf(pszDst, cbDst, "null"); break;
+        case RTJSONEVT_TRUE:         pThis->offEvents += RTStrPrintf(pszDst, cbDst, "true"); break;
+        case RTJSONEVT_FALSE:        pThis->offEvents += RTStrPrintf(pszDst, cbDst, "false"); break;
+        default:
+            RTTestIFailed("Invalid event %d", enmEvt);
+            return VERR_INTERNAL_ERROR;
+    }
+    pThis->cMaxDepth = RT_MAX(pThis->cMaxDepth, pData->cDepth);
+    if (pThis->cEventsLeft != UINT32_MAX && --pThis->cEventsLeft == 0)
+        return VINF_CALLBACK_RETURN;
+    return VINF_SUCCESS;
+}
+
+/**
+ * Tests the event based parser.
+ */
+static void tstEvents(RTTEST hTest)
+{
+    RTTestSub(hTest, "Events");
+
+    TSTJSONEVTS Evts;
+    RT_ZERO(Evts);
+    Evts.cEventsLeft = UINT32_MAX;
+    RTTEST_CHECK_RC(hTest, RTJsonParseEventsFromString(0 /*fFlags*/, g_szJson, tstEventsCallback, &Evts, NULL), VINF_SUCCESS);
+    RTTEST_CHECK_MSG(hTest, strcmp(Evts.szEvents,
+                                   "{integer:100number:2222string:'test'array:[12345'6']"
+                                   "subobject:{false:falsetrue:truenull:null}}") == 0,
+                     (hTest, "got '%s'\n", Evts.szEvents));
+    RTTEST_CHECK(hTest, Evts.cMaxDepth == 2);
+
+    /* Stopping early. */
+    RT_ZERO(Evts);
+    Evts.cEventsLeft = 3;
+    RTTEST_CHECK_RC(hTest, RTJsonParseEventsFromString(0 /*fFlags*/, g_szJson, tstEventsCallback, &Evts, NULL),
+                    VINF_CALLBACK_RETURN);
+    RTTEST_CHECK(hTest, strcmp(Evts.szEvents, "{integer:100") == 0);
+
+    /* Strings larger than the initial decoding buffer. */
+    static char s_szLong[2048];
+    memset(s_szLong, 'x', sizeof(s_szLong) - 1);
+    s_szLong[0] = '[';
+    s_szLong[1] = '\"';
+    s_szLong[sizeof(s_szLong) - 4] = '\"';
+    s_szLong[sizeof(s_szLong) - 3] = ':';
+    s_szLong[sizeof(s_szLong) - 2] = ']';
+    RT_ZERO(Evts);
+    Evts.cEventsLeft = UINT32_MAX;
+    RTTEST_CHECK_RC(hTest, RTJsonParseEventsFromString(0 /*fFlags*/, s_szLong, tstEventsCallback, &Evts, NULL),
+                    VERR_JSON_MALFORMED);
+    s_szLong[sizeof(s_szLong) - 3] = ' ';
+    RT_ZERO(Evts);
+    Evts.cEventsLeft = UINT32_MAX;
+    RTTEST_CHECK_RC(hTest, RTJsonParseEventsFromString(0 /*fFlags*/, s_szLong, tstEventsCallback, &Evts, NULL), VINF_SUCCESS);
+    RTTEST_CHECK_MSG(hTest, strcmp(Evts.szEvents, "['#2042']") == 0, (hTest, "got '%s'\n", Evts.szEvents));
+
+    /* Malformed input. */
+    RT_ZERO(Evts);
+    Evts.cEventsLeft = UINT32_MAX;
+    RTTEST_CHECK_RC(hTest, RTJsonParseEventsFromString(0 /*fFlags*/, "{\"a\": [1, 2}", tstEventsCallback, &Evts, NULL),
+                    VERR_JSON_MALFORMED);
+    RTTEST_CHECK_RC(hTest, RTJsonParseEventsFromString(0 /*fFlags*/, "{\"a\" 1}", tstEventsCallback, &Evts, NULL),
+                    VERR_JSON_MALFORMED);
+}
+
 int main(int argc, char **argv)
 {
     RTTEST hTest;
@@ -415,6 +518,7 @@ int main(int argc, char **argv)
     tstBasic(hTest);
     tstBasic5(hTest);
     tstCorrectness(hTest);
+    tstEvents(hTest);
     for (int i = 1; i < argc; i++)
     {
         RTTestSubF(hTest, "file %Rbn", argv[i]);
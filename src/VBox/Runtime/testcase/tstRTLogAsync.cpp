@@ -0,0 +1,255 @@
+/* $Id$ */
+/** @file
+ * IPRT Testcase - Asynchronous Log Output.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#include <iprt/log.h>
+
+#include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/rand.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+#include <iprt/thread.h>
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/** Memory backed lower output. */
+typedef struct TSTLOWER
+{
+    uint8_t    *pbBuf;
+    size_t      cbBuf;
+    size_t      offBuf;
+    uint32_t    cWrites;
+    uint32_t    cFlushes;
+    bool        fSlow;
+} TSTLOWER;
+
+
+static DECLCALLBACK(int) tstLowerDirCtxOpen(PCRTLOGOUTPUTIF pIf, void *pvUser, const char *pszFilename, void **ppvDirCtx)
+{
+    RT_NOREF(pIf, pvUser, pszFilename);
+    *ppvDirCtx = NULL;
+    return VINF_SUCCESS;
+}
+
+
+static DECLCALLBACK(int) tstLowerDirCtxClose(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx)
+{
+    RT_NOREF(pIf, pvUser, pvDirCtx);
+    return VINF_SUCCESS;
+}
+
+
+static DECLCALLBACK(int) tstLowerDelete(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx, const char *pszFilename)
+{
+    RT_NOREF(pIf, pvUser, pvDirCtx, pszFilename);
+    return VINF_SUCCESS;
+}
+
+
+static DECLCALLBACK(int) tstLowerRename(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx,
+                                        const char *pszFilenameOld, const char *pszFilenameNew, uint32_t fFlags)
+{
+    RT_NOREF(pIf, pvUser, pvDirCtx, pszFilenameOld, pszFilenameNew, fFlags);
+    return VINF_SUCCESS;
+}
+
+
+static DECLCALLBACK(int) tstLowerOpen(PCRTLOGOUTPUTIF pIf, void *pvUser, void *pvDirCtx, const char *pszFilename, uint32_t fFlags)
+{
+    RT_NOREF(pIf, pvDirCtx, pszFilename, fFlags);
+    ((TSTLOWER *)pvUser)->offBuf = 0;
+    return VINF_SUCCESS;
+}
+
+
+static DECLCALLBACK(int) tstLowerClose(PCRTLOGOUTPUTIF pIf, void *pvUser)
+{
+    RT_NOREF(pIf, pvUser);
+    return VINF_SUCCESS;
+}
+
+
+static DECLCALLBACK(int) tstLowerQuerySize(PCRTLOGOUTPUTIF pIf, void *pvUser, uint64_t *pcbSize)
+{
+    RT_NOREF(pIf);
+    *pcbSize = ((TSTLOWER *)pvUser)->offBuf;
+    return VINF_SUCCESS;
+}
+
+
+static DECLCALLBACK(int) tstLowerWrite(PCRTLOGOUTPUTIF pIf, void *pvUser, const void *pvBuf, size_t cbWrite, size_t *pcbWritten)
+{
+    RT_NOREF(pIf);
+    TSTLOWER *pLower = (TSTLOWER *)pvUser;
+    if (pLower->fSlow && (pLower->cWrites & 7) == 0)
+        RTThreadSleep(1);
+    pLower->cWrites++;
+    if (cbWrite > pLower->cbBuf - pLower->offBuf)
+        return VERR_DISK_FULL;
+    memcpy(&pLower->pbBuf[pLower->offBuf], pvBuf, cbWrite);
+    pLower->offBuf += cbWrite;
+    if (pcbWritten)
+        *pcbWritten = cbWrite;
+    return VINF_SUCCESS;
+}
+
+
+static DECLCALLBACK(int) tstLowerFlush(PCRTLOGOUTPUTIF pIf, void *pvUser)
+{
+    RT_NOREF(pIf);
+    ((TSTLOWER *)pvUser)->cFlushes++;
+    return VINF_SUCCESS;
+}
+
+
+static RTLOGOUTPUTIF const g_TstLowerIf =
+{
+    tstLowerDirCtxOpen,
+    tstLowerDirCtxClose,
+    tstLowerDelete,
+    tstLowerRename,
+    tstLowerOpen,
+    tstLowerClose,
+    tstLowerQuerySize,
+    tstLowerWrite,
+    tstLowerFlush
+};
+
+
+static void tstOrdering(RTTEST hTest)
+{
+    RTTestSub(hTest, "Ordering");
+
+    TSTLOWER Lower;
+    RT_ZERO(Lower);
+    Lower.cbBuf = _8M;
+    Lower.pbBuf = (uint8_t *)RTMemAlloc(Lower.cbBuf);
+    uint8_t *pbSrc = (uint8_t *)RTMemAlloc(_4M);
+    RTTEST_CHECK_RETV(hTest, Lower.pbBuf && pbSrc);
+    Lower.fSlow = true;
+    for (size_t off = 0; off < _4M; off++)
+        pbSrc[off] = (uint8_t)(off % 251);
+
+    RTLOGASYNCOUTPUT hAsync = NIL_RTLOGASYNCOUTPUT;
+    RTTEST_CHECK_RC_RETV(hTest, RTLogAsyncOutputCreate(&hAsync, &g_TstLowerIf, &Lower, _16K, 0 /*cbMaxPerSec*/), VINF_SUCCESS);
+    PCRTLOGOUTPUTIF pIf = RTLogAsyncOutputGetIf();
+    RTTEST_CHECK_RC(hTest, pIf->pfnOpen(pIf, hAsync, NULL, "dummy.log", 0), VINF_SUCCESS);
+
+    /* Mostly small writes with the odd one exceeding the ring buffer. */
+    size_t off = 0;
+    while (off < _4M)
+    {
+        size_t cbThis = RTRandU32Ex(0, 31) == 0 ? RTRandU32Ex(1, _64K) : RTRandU32Ex(1, 200);
+        cbThis = RT_MIN(cbThis, _4M - off);
+        size_t cbWritten = 0;
+        RTTEST_CHECK_RC_BREAK(hTest, pIf->pfnWrite(pIf, hAsync, &pbSrc[off], cbThis, &cbWritten), VINF_SUCCESS);
+        RTTEST_CHECK(hTest, cbWritten == cbThis);
+        off += cbThis;
+    }
+
+    RTTEST_CHECK_RC(hTest, pIf->pfnFlush(pIf, hAsync), VINF_SUCCESS);
+    RTTEST_CHECK(hTest, Lower.cFlushes >= 1);
+    RTTEST_CHECK_MSG(hTest, Lower.offBuf == _4M, (hTest, "offBuf=%#zx\n", Lower.offBuf));
+    RTTEST_CHECK(hTest, Lower.offBuf != _4M || memcmp(Lower.pbBuf, pbSrc, _4M) == 0);
+    RTTEST_CHECK(hTest, RTLogAsyncOutputGetDropped(hAsync) == 0);
+
+    /* Whatever is buffered when closing must reach the file first. */
+    RTTEST_CHECK_RC(hTest, pIf->pfnWrite(pIf, hAsync, RT_STR_TUPLE("last words\n"), NULL), VINF_SUCCESS);
+    RTTEST_CHECK_RC(hTest, pIf->pfnClose(pIf, hAsync), VINF_SUCCESS);
+    RTTEST_CHECK(hTest, Lower.offBuf == _4M + sizeof("last words\n") - 1);
+
+    RTTEST_CHECK_RC(hTest, RTLogAsyncOutputDestroy(hAsync), VINF_SUCCESS);
+    RTMemFree(pbSrc);
+    RTMemFree(Lower.pbBuf);
+}
+
+
+static void tstRateLimit(RTTEST hTest)
+{
+    RTTestSub(hTest, "Rate limit");
+
+    TSTLOWER Lower;
+    RT_ZERO(Lower);
+    Lower.cbBuf = _64K;
+    Lower.pbBuf = (uint8_t *)RTMemAllocZ(Lower.cbBuf);
+    RTTEST_CHECK_RETV(hTest, Lower.pbBuf);
+
+    RTLOGASYNCOUTPUT hAsync = NIL_RTLOGASYNCOUTPUT;
+    RTTEST_CHECK_RC_RETV(hTest, RTLogAsyncOutputCreate(&hAsync, &g_TstLowerIf, &Lower, 0 /*cbBuffer*/, 1000), VINF_SUCCESS);
+    PCRTLOGOUTPUTIF pIf = RTLogAsyncOutputGetIf();
+
+    char szLine[100];
+    memset(szLine, 'x', sizeof(szLine) - 1);
+    szLine[sizeof(szLine) - 1] = '\n';
+    for (unsigned i = 0; i < 50; i++)
+        RTTEST_CHECK_RC(hTest, pIf->pfnWrite(pIf, hAsync, szLine, sizeof(szLine), NULL), VINF_SUCCESS);
+
+    /* Unless the test machine is very slow, only the first 10 lines fit into the one second window. */
+    uint64_t const cbDropped = RTLogAsyncOutputGetDropped(hAsync);
+    RTTEST_CHECK_MSG(hTest, cbDropped >= 30 * sizeof(szLine), (hTest, "cbDropped=%RU64\n", cbDropped));
+
+    /* The emergency flush writes everything including a note about the drop. */
+    RTLogAsyncOutputFlushAll();
+    RTTEST_CHECK(hTest, Lower.cFlushes == 1);
+    RTTEST_CHECK(hTest, Lower.offBuf > 50 * sizeof(szLine) - cbDropped);
+    RTTEST_CHECK(hTest, RTStrSimplePatternMatch("*Log rate limit*", (const char *)Lower.pbBuf));
+
+    RTTEST_CHECK_RC(hTest, RTLogAsyncOutputDestroy(hAsync), VINF_SUCCESS);
+    RTTEST_CHECK_RC(hTest, RTLogAsyncOutputDestroy(NIL_RTLOGASYNCOUTPUT), VINF_SUCCESS);
+    RTMemFree(Lower.pbBuf);
+}
+
+
+int main()
+{
+    RTTEST hTest;
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstRTLogAsync", &hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(hTest);
+
+    tstOrdering(hTest);
+    tstRateLimit(hTest);
+
+    return RTTestSummaryAndDestroy(hTest);
+}
+
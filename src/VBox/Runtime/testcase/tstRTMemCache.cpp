@@ -213,6 +213,78 @@ static void tst2(void)
 }
 
 
+/** Thread for tst4 that allocates everything from the cache. */
+static DECLCALLBACK(int) tst4Thread(RTTHREAD hThreadSelf, void *pvArg)
+{
+    void   **papv     = (void **)pvArg;
+    uint32_t cObjects = RTSystemGetPageSize() * 2 / 256;
+    RT_NOREF_PV(hThreadSelf);
+
+    for (uint32_t i = 0; i < cObjects; i++)
+    {
+        papv[i] = NULL;
+        RTTEST_CHECK_RC(g_hTest, RTMemCacheAllocEx(g_hMemCache, &papv[i]), VINF_SUCCESS);
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Test the magazine layer.
+ */
+static void tst4(void)
+{
+    RTTestISub("Magazines");
+
+    bool            fFail       = false;
+    uint32_t const  cObjectsMax = _64K * 2 / 256;
+    uint32_t const  cObjects    = RTSystemGetPageSize() * 2 / 256;
+    AssertRelease(cObjectsMax >= cObjects);
+    RTTESTI_CHECK_RC_RETV(RTMemCacheCreate(&g_hMemCache, 256, 32 /*cbAlignment*/, cObjects, tst2Ctor, tst2Dtor, &fFail,
+                                           RTMEMCACHE_F_MAGAZINES), VINF_SUCCESS);
+
+    /* Objects must keep their constructed state while parked in a magazine. */
+    void *apv[cObjectsMax];
+    for (uint32_t iLoop = 0; iLoop < 2; iLoop++)
+    {
+        for (uint32_t i = 0; i < cObjects; i++)
+        {
+            apv[i] = NULL;
+            RTTESTI_CHECK_RC_RETV(RTMemCacheAllocEx(g_hMemCache, &apv[i]), VINF_SUCCESS);
+            if (iLoop == 0)
+                RTTESTI_CHECK(!strcmp((char *)apv[i], "ctor was called\n"));
+            else
+                RTTESTI_CHECK(!strcmp((char *)apv[i], "ctor was called\nused\n"));
+            strcat((char *)apv[i], "used\n");
+        }
+
+        void *pv;
+        RTTESTI_CHECK_RETV((pv = RTMemCacheAlloc(g_hMemCache)) == NULL);
+
+        for (uint32_t i = 0; i < cObjects; i++)
+            RTMemCacheFree(g_hMemCache, apv[i]);
+    }
+
+    RTMEMCACHESTATS Stats;
+    RTTESTI_CHECK_RC_RETV(RTMemCacheQueryStats(g_hMemCache, &Stats), VINF_SUCCESS);
+    RTTESTI_CHECK(Stats.cbObject == 256);
+    RTTESTI_CHECK(Stats.cTotal == cObjects);
+    RTTESTI_CHECK(Stats.cMagAllocHits > 0);
+    RTTESTI_CHECK(Stats.cMagFreeHits > 0);
+
+    /* Everything is parked in this thread's magazines and the depot, another
+       thread must still be able to get all the objects out of the cache. */
+    RTTHREAD hThread;
+    RTTESTI_CHECK_RC_OK_RETV(RTThreadCreate(&hThread, tst4Thread, &apv[0], 0, RTTHREADTYPE_DEFAULT,
+                                            RTTHREADFLAGS_WAITABLE, "tst4"));
+    RTTESTI_CHECK_RC_OK(RTThreadWait(hThread, 60*1000, NULL));
+    for (uint32_t i = 0; i < cObjects; i++)
+        RTMemCacheFree(g_hMemCache, apv[i]);
+
+    RTTESTI_CHECK_RC(RTMemCacheDestroy(g_hMemCache), VINF_SUCCESS);
+}
+
+
 /**
  * Thread that allocates
  * @returns
@@ -276,14 +348,16 @@ static DECLCALLBACK(int) tst3Thread(RTTHREAD hThreadSelf, void *pvArg)
 static void tst3(uint32_t cThreads, uint32_t cbObject, int iMethod, uint32_t cSecs)
 {
     RTTestISubF("Benchmark - %u threads, %u bytes, %u secs, %s", cThreads, cbObject, cSecs,
-                iMethod == 0 ? "RTMemCache"
+                  iMethod == 0 ? "RTMemCache"
+                : iMethod == 2 ? "RTMemCache/Mag"
                 : "RTMemAlloc");
 
     /*
      * Create a cache with unlimited space, a start semaphore and line up
      * the threads.
      */
-    RTTESTI_CHECK_RC_RETV(RTMemCacheCreate(&g_hMemCache, cbObject, 0 /*cbAlignment*/, UINT32_MAX, NULL, NULL, NULL, 0 /*fFlags*/), VINF_SUCCESS);
+    RTTESTI_CHECK_RC_RETV(RTMemCacheCreate(&g_hMemCache, cbObject, 0 /*cbAlignment*/, UINT32_MAX, NULL, NULL, NULL,
+                                           iMethod == 2 ? RTMEMCACHE_F_MAGAZINES : 0), VINF_SUCCESS);
 
     RTSEMEVENTMULTI hEvt;
     RTTESTI_CHECK_RC_OK_RETV(RTSemEventMultiCreate(&hEvt));
@@ -296,7 +370,7 @@ static void tst3(uint32_t cThreads, uint32_t cbObject, int iMethod, uint32_t cSe
     {
         aThreads[i].hThread     = NIL_RTTHREAD;
         aThreads[i].cIterations = 0;
-        aThreads[i].fUseCache   = iMethod == 0;
+        aThreads[i].fUseCache   = iMethod != 1;
         aThreads[i].cbObject    = cbObject;
         aThreads[i].hEvt        = hEvt;
         RTTESTI_CHECK_RC_OK_RETV(RTThreadCreateF(&aThreads[i].hThread, tst3Thread, &aThreads[i], 0,
@@ -335,6 +409,7 @@ static void tst3(uint32_t cThreads, uint32_t cbObject, int iMethod, uint32_t cSe
 static void tst3AllMethods(uint32_t cThreads, uint32_t cbObject, uint32_t cSecs)
 {
     tst3(cThreads, cbObject, 0, cSecs);
+    tst3(cThreads, cbObject, 2, cSecs);
     tst3(cThreads, cbObject, 1, cSecs);
 }
 
@@ -352,6 +427,7 @@ int main(int argc, char **argv)
 
     tst1();
     tst2();
+    tst4();
     if (RTTestIErrorCount() == 0)
     {
         uint32_t cSecs = argc == 1 ? 5 : 2;
@@ -0,0 +1,184 @@
+/* $Id$ */
+/** @file
+ * IPRT Testcase - Radix Tree.
+ */
+
+/*
+ * Copyright (C) 2006-2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL), a copy of it is provided in the "COPYING.CDDL" file included
+ * in the VirtualBox distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only OR CDDL-1.0
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#include <iprt/radixtree.h>
+
+#include <iprt/err.h>
+#include <iprt/rand.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Number of indexes used by the random test. */
+#define TST_INDEXES     16384
+
+/** Value stored for index @a uIndex. */
+#define TST_VALUE(uIndex)   ((void *)(uintptr_t)((uIndex) * 2 + 1))
+
+
+/*********************************************************************************************************************************
+*   Global Variables                                                                                                             *
+*********************************************************************************************************************************/
+/** Which indexes (times the stride) are present in the tree. */
+static bool g_afShadow[TST_INDEXES];
+
+
+typedef struct TSTENUM
+{
+    uint64_t    uStride;
+    uint64_t    uPrev;
+    uint64_t    cCalls;
+} TSTENUM;
+
+static DECLCALLBACK(int) tstEnumCallback(uint64_t uIndex, void *pvValue, void *pvUser)
+{
+    TSTENUM *pState = (TSTENUM *)pvUser;
+    RTTESTI_CHECK_RET(uIndex % pState->uStride == 0, VERR_INTERNAL_ERROR);
+    RTTESTI_CHECK_RET(uIndex / pState->uStride < TST_INDEXES, VERR_INTERNAL_ERROR);
+    RTTESTI_CHECK_RET(g_afShadow[uIndex / pState->uStride], VERR_INTERNAL_ERROR);
+    RTTESTI_CHECK_RET(pvValue == TST_VALUE(uIndex / pState->uStride), VERR_INTERNAL_ERROR);
+    RTTESTI_CHECK_RET(!pState->cCalls || uIndex > pState->uPrev, VERR_INTERNAL_ERROR);
+    pState->uPrev = uIndex;
+    pState->cCalls++;
+    return VINF_SUCCESS;
+}
+
+
+static void tstBasic(RTTEST hTest)
+{
+    RTTestSub(hTest, "Basics");
+
+    RTRADIXTREE hTree = NIL_RTRADIXTREE;
+    RTTEST_CHECK_RC_OK_RETV(hTest, RTRadixTreeCreate(&hTree));
+    RTTEST_CHECK(hTest, RTRadixTreeLookup(hTree, 0) == NULL);
+    RTTEST_CHECK(hTest, RTRadixTreeRemove(hTree, 0) == NULL);
+
+    static uint64_t const s_auIndexes[] = { 0, 1, 63, 64, 4095, 4096, UINT32_MAX, RT_BIT_64(40) + 5, UINT64_MAX - 1, UINT64_MAX };
+    for (unsigned i = 0; i < RT_ELEMENTS(s_auIndexes); i++)
+    {
+        RTTEST_CHECK_RC(hTest, RTRadixTreeInsert(hTree, s_auIndexes[i], TST_VALUE(i)), VINF_SUCCESS);
+        RTTEST_CHECK_RC(hTest, RTRadixTreeInsert(hTree, s_auIndexes[i], TST_VALUE(i)), VERR_ALREADY_EXISTS);
+    }
+    RTTEST_CHECK(hTest, RTRadixTreeGetCount(hTree) == RT_ELEMENTS(s_auIndexes));
+    for (unsigned i = 0; i < RT_ELEMENTS(s_auIndexes); i++)
+        RTTEST_CHECK(hTest, RTRadixTreeLookup(hTree, s_auIndexes[i]) == TST_VALUE(i));
+    RTTEST_CHECK(hTest, RTRadixTreeLookup(hTree, 2) == NULL);
+    RTTEST_CHECK(hTest, RTRadixTreeLookup(hTree, RT_BIT_64(40)) == NULL);
+
+    /* Removing the large ones in reverse order collapses the tree again. */
+    for (unsigned i = RT_ELEMENTS(s_auIndexes); i-- > 0;)
+    {
+        RTTEST_CHECK(hTest, RTRadixTreeRemove(hTree, s_auIndexes[i]) == TST_VALUE(i));
+        RTTEST_CHECK(hTest, RTRadixTreeRemove(hTree, s_auIndexes[i]) == NULL);
+        for (unsigned j = 0; j < i; j++)
+            RTTEST_CHECK(hTest, RTRadixTreeLookup(hTree, s_auIndexes[j]) == TST_VALUE(j));
+    }
+    RTTEST_CHECK(hTest, RTRadixTreeGetCount(hTree) == 0);
+
+    RTTEST_CHECK_RC(hTest, RTRadixTreeDestroy(hTree, NULL, NULL), VINF_SUCCESS);
+}
+
+
+static void tstRandom(RTTEST hTest, uint64_t uStride)
+{
+    RTTestSubF(hTest, "Random insert/remove, stride %#RX64", uStride);
+
+    RTRADIXTREE hTree = NIL_RTRADIXTREE;
+    RTTEST_CHECK_RC_OK_RETV(hTest, RTRadixTreeCreate(&hTree));
+    RT_ZERO(g_afShadow);
+    uint64_t cEntries = 0;
+
+    for (uint32_t iRound = 0; iRound < 4; iRound++)
+    {
+        uint32_t const uInsertPct = iRound & 1 ? 20 : 80;
+        for (uint32_t i = 0; i < TST_INDEXES * 2; i++)
+        {
+            uint32_t const idx    = RTRandU32Ex(0, TST_INDEXES - 1);
+            uint64_t const uIndex = idx * uStride;
+            if (RTRandU32Ex(0, 99) < uInsertPct)
+            {
+                int rc = RTRadixTreeInsert(hTree, uIndex, TST_VALUE(idx));
+                RTTEST_CHECK_RC_RETV(hTest, rc, g_afShadow[idx] ? VERR_ALREADY_EXISTS : VINF_SUCCESS);
+                if (!g_afShadow[idx])
+                    cEntries++;
+                g_afShadow[idx] = true;
+            }
+            else
+            {
+                void *pv = RTRadixTreeRemove(hTree, uIndex);
+                RTTEST_CHECK_RETV(hTest, pv == (g_afShadow[idx] ? TST_VALUE(idx) : NULL));
+                if (g_afShadow[idx])
+                    cEntries--;
+                g_afShadow[idx] = false;
+            }
+        }
+
+        RTTEST_CHECK(hTest, RTRadixTreeGetCount(hTree) == cEntries);
+        for (uint32_t idx = 0; idx < TST_INDEXES; idx++)
+            RTTEST_CHECK_RETV(hTest, RTRadixTreeLookup(hTree, idx * uStride) == (g_afShadow[idx] ? TST_VALUE(idx) : NULL));
+
+        TSTENUM State = { uStride, 0, 0 };
+        RTTEST_CHECK_RC(hTest, RTRadixTreeDoWithAll(hTree, tstEnumCallback, &State), VINF_SUCCESS);
+        RTTEST_CHECK(hTest, State.cCalls == cEntries);
+    }
+
+    RTTEST_CHECK_RC(hTest, RTRadixTreeDestroy(hTree, NULL, NULL), VINF_SUCCESS);
+}
+
+
+int main()
+{
+    RTTEST hTest;
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstRTRadixTree", &hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(hTest);
+
+    tstBasic(hTest);
+    tstRandom(hTest, 1);
+    tstRandom(hTest, 37);
+    tstRandom(hTest, UINT64_C(0x10000000001));
+
+    return RTTestSummaryAndDestroy(hTest);
+}
+
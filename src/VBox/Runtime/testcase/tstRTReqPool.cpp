@@ -40,6 +40,7 @@
 *********************************************************************************************************************************/
 #include <iprt/req.h>
 
+#include <iprt/asm.h>
 #include <iprt/err.h>
 #include <iprt/test.h>
 #include <iprt/thread.h>
@@ -51,6 +52,10 @@
 *   Global Variables                                                                                                             *
 *********************************************************************************************************************************/
 static RTTEST g_hTest = NIL_RTTEST;
+/** The pool used by test3. */
+static RTREQPOOL g_hPoolTest3 = NIL_RTREQPOOL;
+/** Number of leaf requests completed in test3. */
+static uint32_t volatile g_cTest3Leaves = 0;
 
 
 static DECLCALLBACK(int) NopCallback(void)
@@ -142,6 +147,49 @@ static void test2(void)
 }
 
 
+static DECLCALLBACK(int) Test3LeafCallback(void)
+{
+    ASMAtomicIncU32(&g_cTest3Leaves);
+    return VINF_SUCCESS;
+}
+
+
+static DECLCALLBACK(int) Test3FanOutCallback(uint32_t cLeaves)
+{
+    for (uint32_t i = 0; i < cLeaves; i++)
+        RTTESTI_CHECK_RC_RET(RTReqPoolCallNoWait(g_hPoolTest3, (PFNRT)Test3LeafCallback, 0), VINF_SUCCESS, VERR_INTERNAL_ERROR);
+    return VINF_SUCCESS;
+}
+
+
+static void test3(void)
+{
+    RTTestISub("Work stealing");
+
+    RTTESTI_CHECK_RC_RETV(RTReqPoolCreate(8, RT_MS_1SEC, 0, 0, "test3", &g_hPoolTest3), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(RTReqPoolSetCfgVar(g_hPoolTest3, RTREQPOOLCFGVAR_WORK_STEALING, 1), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(RTReqPoolSetCfgVar(g_hPoolTest3, RTREQPOOLCFGVAR_AFFINITY_GROUPS, 2), VINF_SUCCESS);
+    RTTESTI_CHECK(RTReqPoolGetCfgVar(g_hPoolTest3, RTREQPOOLCFGVAR_WORK_STEALING) == 1);
+    RTTESTI_CHECK(RTReqPoolGetCfgVar(g_hPoolTest3, RTREQPOOLCFGVAR_AFFINITY_GROUPS) == 2);
+
+    /* Fan out more leaves than fit into one deque so both paths get used. */
+    uint32_t const cLeaves = 200;
+    ASMAtomicWriteU32(&g_cTest3Leaves, 0);
+    RTTESTI_CHECK_RC(RTReqPoolCallWait(g_hPoolTest3, (PFNRT)Test3FanOutCallback, 1, cLeaves), VINF_SUCCESS);
+    uint64_t const msStart = RTTimeMilliTS();
+    while (   ASMAtomicReadU32(&g_cTest3Leaves) < cLeaves
+           && RTTimeMilliTS() - msStart < RT_MS_30SEC)
+        RTThreadSleep(1);
+    RTTESTI_CHECK(ASMAtomicReadU32(&g_cTest3Leaves) == cLeaves);
+
+    RTTESTI_CHECK(RTReqPoolGetStat(g_hPoolTest3, RTREQPOOLSTAT_REQUESTS_SUBMITTED_LOCAL) > 0);
+    RTTestIValue("stolen", RTReqPoolGetStat(g_hPoolTest3, RTREQPOOLSTAT_REQUESTS_STOLEN), RTTESTUNIT_OCCURRENCES);
+
+    RTTESTI_CHECK(RTReqPoolRelease(g_hPoolTest3) == 0);
+    g_hPoolTest3 = NIL_RTREQPOOL;
+}
+
+
 int main()
 {
     RTEXITCODE rcExit = RTTestInitAndCreate("tstRTReqPool", &g_hTest);
@@ -153,6 +201,7 @@ int main()
     if (RTTestIErrorCount() == 0)
     {
         test2();
+        test3();
     }
     return RTTestSummaryAndDestroy(g_hTest);
 }
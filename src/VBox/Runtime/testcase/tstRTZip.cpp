@@ -47,8 +47,10 @@
 #include <iprt/mem.h>
 #include <iprt/message.h>
 #include <iprt/param.h>
+#include <iprt/rand.h>
 #include <iprt/string.h>
 #include <iprt/test.h>
+#include <iprt/vfs.h>
 
 
 static void testFile(const char *pszFilename)
@@ -71,6 +73,134 @@ static void testFile(const char *pszFilename)
 }
 
 
+static void testGzipRoundTrip(uint8_t const *pbSrc, size_t cbSrc, uint32_t fFlags)
+{
+    /* Compress into a memory file, in odd sized chunks and with a flush in the middle. */
+    RTVFSFILE hVfsFile;
+    RTTESTI_CHECK_RC_RETV(RTVfsMemFileCreate(NIL_RTVFSIOSTREAM, cbSrc, &hVfsFile), VINF_SUCCESS);
+    RTVFSIOSTREAM hVfsIosFile = RTVfsFileToIoStream(hVfsFile);
+
+    RTVFSIOSTREAM hVfsIosGzip = NIL_RTVFSIOSTREAM;
+    RTTESTI_CHECK_RC(RTZipGzipCompressIoStream(hVfsIosFile, fFlags, 6, &hVfsIosGzip), VINF_SUCCESS);
+    if (hVfsIosGzip != NIL_RTVFSIOSTREAM)
+    {
+        size_t off = 0;
+        while (off < cbSrc)
+        {
+            size_t const cbThis = RT_MIN(cbSrc - off, RTRandU32Ex(1, _256K));
+            RTTESTI_CHECK_RC_BREAK(RTVfsIoStrmWrite(hVfsIosGzip, &pbSrc[off], cbThis, true /*fBlocking*/, NULL), VINF_SUCCESS);
+            if (off < cbSrc / 2 && off + cbThis >= cbSrc / 2)
+                RTTESTI_CHECK_RC(RTVfsIoStrmFlush(hVfsIosGzip), VINF_SUCCESS);
+            off += cbThis;
+        }
+        RTTESTI_CHECK(RTVfsIoStrmRelease(hVfsIosGzip) == 0);
+
+        /* Decompress and compare. */
+        RTTESTI_CHECK_RC(RTVfsFileSeek(hVfsFile, 0, RTFILE_SEEK_BEGIN, NULL), VINF_SUCCESS);
+        RTVFSIOSTREAM hVfsIosGunzip = NIL_RTVFSIOSTREAM;
+        RTTESTI_CHECK_RC(RTZipGzipDecompressIoStream(hVfsIosFile, 0 /*fFlags*/, &hVfsIosGunzip), VINF_SUCCESS);
+        if (hVfsIosGunzip != NIL_RTVFSIOSTREAM)
+        {
+            void  *pvDst = NULL;
+            size_t cbDst = 0;
+            RTTESTI_CHECK_RC(RTVfsIoStrmReadAll(hVfsIosGunzip, &pvDst, &cbDst), VINF_SUCCESS);
+            RTTESTI_CHECK_MSG(cbDst == cbSrc, ("cbDst=%zu cbSrc=%zu\n", cbDst, cbSrc));
+            RTTESTI_CHECK(cbDst != cbSrc || memcmp(pvDst, pbSrc, cbSrc) == 0);
+            RTVfsIoStrmReadAllFree(pvDst, cbDst);
+            RTVfsIoStrmRelease(hVfsIosGunzip);
+        }
+    }
+    RTVfsIoStrmRelease(hVfsIosFile);
+    RTVfsFileRelease(hVfsFile);
+}
+
+
+static void testGzip(void)
+{
+    RTTestISub("gzip");
+
+    /* Mix of random and repetitive data so both stored and compressed blocks show up. */
+    size_t const cbSrc = _4M + 1234;
+    uint8_t *pbSrc = (uint8_t *)RTMemAlloc(cbSrc);
+    RTTESTI_CHECK_RETV(pbSrc);
+    for (size_t off = 0; off < cbSrc; off += _64K)
+    {
+        size_t const cbThis = RT_MIN(cbSrc - off, _64K);
+        if ((off / _64K) % 3)
+            for (size_t i = 0; i < cbThis; i++)
+                pbSrc[off + i] = (uint8_t)("The quick brown fox jumps over the lazy dog. "[(off + i) % 45]);
+        else
+            RTRandBytes(&pbSrc[off], cbThis);
+    }
+
+    testGzipRoundTrip(pbSrc, cbSrc, 0);
+    testGzipRoundTrip(pbSrc, cbSrc, RTZIPGZIPCOMP_F_PARALLEL);
+    testGzipRoundTrip(pbSrc, 0, RTZIPGZIPCOMP_F_PARALLEL);
+    testGzipRoundTrip(pbSrc, 1, RTZIPGZIPCOMP_F_PARALLEL);
+
+    RTMemFree(pbSrc);
+}
+
+
+static void testLz4(void)
+{
+    RTTestISub("LZ4 blocks");
+
+    size_t const cbMax = _1M;
+    uint8_t *pbSrc   = (uint8_t *)RTMemAlloc(cbMax);
+    uint8_t *pbCompr = (uint8_t *)RTMemAlloc(cbMax * 2);
+    uint8_t *pbDst   = (uint8_t *)RTMemAlloc(cbMax);
+    RTTESTI_CHECK_RETV(pbSrc && pbCompr && pbDst);
+
+    static size_t const s_acbSrc[] = { 0, 1, 12, 13, 100, _4K, _64K + 17, cbMax };
+    for (unsigned iKind = 0; iKind < 3; iKind++)
+        for (unsigned i = 0; i < RT_ELEMENTS(s_acbSrc); i++)
+        {
+            size_t const cbSrc = s_acbSrc[i];
+            if (iKind == 0)
+                RTRandBytes(pbSrc, cbSrc);
+            else if (iKind == 1)
+                memset(pbSrc, 0, cbSrc);
+            else
+                for (size_t off = 0; off < cbSrc; off++)
+                    pbSrc[off] = (uint8_t)("The quick brown fox jumps over the lazy dog. "[off % 45] ^ (RTRandU32Ex(0, 15) == 0));
+
+            size_t cbCompr = 0;
+            RTTESTI_CHECK_RC_BREAK(RTZipBlockCompress(RTZIPTYPE_LZ4, RTZIPLEVEL_DEFAULT, 0, pbSrc, cbSrc,
+                                                      pbCompr, cbMax * 2, &cbCompr), VINF_SUCCESS);
+            size_t cbSrcActual = 0;
+            size_t cbDst = 0;
+            RTTESTI_CHECK_RC(RTZipBlockDecompress(RTZIPTYPE_LZ4, 0, pbCompr, cbCompr, &cbSrcActual,
+                                                  pbDst, cbMax, &cbDst), VINF_SUCCESS);
+            RTTESTI_CHECK_MSG(cbDst == cbSrc, ("cbDst=%zu cbSrc=%zu\n", cbDst, cbSrc));
+            RTTESTI_CHECK(cbDst != cbSrc || memcmp(pbSrc, pbDst, cbSrc) == 0);
+            RTTESTI_CHECK(cbSrcActual == cbCompr);
+            if (iKind == 1 && cbSrc >= _4K)
+                RTTESTI_CHECK_MSG(cbCompr < cbSrc / 64, ("cbCompr=%zu cbSrc=%zu\n", cbCompr, cbSrc));
+
+            /* Too small buffers must be detected. */
+            if (cbCompr > 1)
+                RTTESTI_CHECK_RC(RTZipBlockCompress(RTZIPTYPE_LZ4, RTZIPLEVEL_DEFAULT, 0, pbSrc, cbSrc,
+                                                    pbCompr, cbCompr - 1, &cbDst), VERR_BUFFER_OVERFLOW);
+            if (cbSrc > 0)
+                RTTESTI_CHECK_RC(RTZipBlockDecompress(RTZIPTYPE_LZ4, 0, pbCompr, cbCompr, NULL,
+                                                      pbDst, cbSrc - 1, NULL), VERR_BUFFER_OVERFLOW);
+        }
+
+    /* Garbage must not crash or write outside the buffer. */
+    for (unsigned i = 0; i < 4096; i++)
+    {
+        size_t const cbGarbage = RTRandU32Ex(1, 256);
+        RTRandBytes(pbCompr, cbGarbage);
+        RTZipBlockDecompress(RTZIPTYPE_LZ4, 0, pbCompr, cbGarbage, NULL, pbDst, _4K, NULL);
+    }
+
+    RTMemFree(pbSrc);
+    RTMemFree(pbCompr);
+    RTMemFree(pbDst);
+}
+
+
 int main(int argc, char **argv)
 {
     RTTEST hTest;
@@ -86,7 +216,8 @@ int main(int argc, char **argv)
     }
     else
     {
-        /** @todo testcase */
+        testGzip();
+        testLz4();
     }
 
     /*
@@ -119,9 +119,18 @@ typedef enum SCSIDEVTYPE
 /** Mask to extract the CmdQue bit out of the seventh byte of the INQUIRY response. */
 #define SCSI_INQUIRY_CMDQUE_MASK 0x02
 
-/** Maximum PDU payload size we can handle in one piece. Greater or equal than
- * s_iscsiConfigDefaultWriteSplit. */
-#define ISCSI_DATA_LENGTH_MAX _256K
+/** Maximum PDU payload size we can handle in one piece, offered as our
+ * MaxRecvDataSegmentLength and FirstBurstLength. */
+#define ISCSI_DATA_LENGTH_MAX _1M
+
+/** Maximum amount of data in a Data-In or solicited Data-Out sequence,
+ * offered as MaxBurstLength. */
+#define ISCSI_BURST_LENGTH_MAX _4M
+
+/** Maximum amount of data transferred by a single SCSI command when going through
+ * the I/O thread (data is split into several Data-In/Data-Out PDUs as required).
+ * Greater or equal than s_iscsiConfigDefaultWriteSplit. */
+#define ISCSI_XFER_LENGTH_MAX _4M
 
 /** Maximum PDU size we can handle in one piece. */
 #define ISCSI_RECV_PDU_BUFFER_SIZE (ISCSI_DATA_LENGTH_MAX + ISCSI_BHS_SIZE)
@@ -433,6 +442,8 @@ typedef struct ISCSICMD
     struct ISCSICMD      *pNext;
     /** Assigned ITT. */
     uint32_t              Itt;
+    /** Assigned CmdSN, Data-Out PDUs for this command must not overtake it. */
+    uint32_t              CmdSN;
     /** Completion callback. */
     PFNISCSICMDCOMPLETED  pfnComplete;
     /** Opaque user data. */
@@ -543,6 +554,15 @@ typedef struct ISCSIIMAGE
     uint32_t            cbSendDataLength;
     /** Negotiated maximum data length when receiving from target. */
     uint32_t            cbRecvDataLength;
+    /** Negotiated maximum amount of unsolicited data (immediate data and
+     * unsolicited Data-Out PDUs) for a single command. */
+    uint32_t            cbFirstBurstLength;
+    /** Negotiated maximum amount of data in a Data-In or solicited Data-Out sequence. */
+    uint32_t            cbMaxBurstLength;
+    /** Flag whether data may be sent along with the SCSI command PDU. */
+    bool                fImmediateData;
+    /** Flag whether the target requires a R2T before sending any Data-Out PDU. */
+    bool                fInitialR2T;
 
     /** Current state of the connection/session. */
     ISCSISTATE          state;
@@ -650,8 +670,8 @@ static const char *s_iscsiConfigDefaultLUN = "0";
 /** Default timeout, 10 seconds. */
 static const char *s_iscsiConfigDefaultTimeout = "10000";
 
-/** Default write split value, less or equal to ISCSI_DATA_LENGTH_MAX. */
-static const char *s_iscsiConfigDefaultWriteSplit = "262144";
+/** Default write split value, less or equal to ISCSI_XFER_LENGTH_MAX. */
+static const char *s_iscsiConfigDefaultWriteSplit = "4194304";
 
 /** Default host IP stack. */
 static const char *s_iscsiConfigDefaultHostIPStack = "1";
@@ -1306,10 +1326,16 @@ static int iscsiLogin(PISCSIIMAGE pImage)
     uint32_t aResBHS[12];
     char *pszNext;
     bool fParameterNeg = true;
-    pImage->cbRecvDataLength = ISCSI_DATA_LENGTH_MAX;
-    pImage->cbSendDataLength = RT_MIN(ISCSI_DATA_LENGTH_MAX, pImage->cbWriteSplit);
+    pImage->cbRecvDataLength   = ISCSI_DATA_LENGTH_MAX;
+    pImage->cbSendDataLength   = ISCSI_DATA_LENGTH_MAX;
+    pImage->cbFirstBurstLength = RT_MIN(ISCSI_DATA_LENGTH_MAX, pImage->cbWriteSplit);
+    pImage->cbMaxBurstLength   = ISCSI_BURST_LENGTH_MAX;
+    pImage->fImmediateData     = true;
+    pImage->fInitialR2T        = false;
     char szMaxDataLength[16];
     RTStrPrintf(szMaxDataLength, sizeof(szMaxDataLength), "%u", ISCSI_DATA_LENGTH_MAX);
+    char szMaxBurstLength[16];
+    RTStrPrintf(szMaxBurstLength, sizeof(szMaxBurstLength), "%u", ISCSI_BURST_LENGTH_MAX);
     ISCSIPARAMETER aParameterNeg[] =
     {
         { "HeaderDigest", "None", 0 },
@@ -1318,7 +1344,7 @@ static int iscsiLogin(PISCSIIMAGE pImage)
         { "InitialR2T", "No", 0 },
         { "ImmediateData", "Yes", 0 },
         { "MaxRecvDataSegmentLength", szMaxDataLength, 0 },
-        { "MaxBurstLength", szMaxDataLength, 0 },
+        { "MaxBurstLength", szMaxBurstLength, 0 },
         { "FirstBurstLength", szMaxDataLength, 0 },
         { "DefaultTime2Wait", "0", 0 },
         { "DefaultTime2Retain", "60", 0 },
@@ -1717,7 +1743,12 @@ static int iscsiLogin(PISCSIIMAGE pImage)
         pImage->state = ISCSISTATE_FREE;
     }
     else if (rc == VINF_SUCCESS)
+    {
         pImage->state = ISCSISTATE_NORMAL;
+        LogRel(("iSCSI: negotiated MaxRecvDataSegmentLength=%u (target) %u (initiator), FirstBurstLength=%u, MaxBurstLength=%u, ImmediateData=%RTbool, InitialR2T=%RTbool\n",
+                pImage->cbSendDataLength, pImage->cbRecvDataLength, pImage->cbFirstBurstLength,
+                pImage->cbMaxBurstLength, pImage->fImmediateData, pImage->fInitialR2T));
+    }
 
     return rc;
 }
@@ -2751,8 +2782,161 @@ static int iscsiValidatePDU(PISCSIRES paRes, uint32_t cnRes)
 }
 
 
+/**
+ * Adds the data of the given range of the initiator to target buffer of a request
+ * to the S/G segments of a PDU without copying, including the padding.
+ *
+ * @returns Number of bytes the added segments describe.
+ * @param   pImage      The iSCSI connection state to be used.
+ * @param   pIScsiPDU   The PDU to add the segments to, must have enough room.
+ * @param   pScsiReq    The SCSI request.
+ * @param   offData     Start offset in the initiator to target buffer.
+ * @param   cbData      Number of bytes to add.
+ */
+static size_t iscsiPDUTxAddDataSegs(PISCSIIMAGE pImage, PISCSIPDUTX pIScsiPDU, PSCSIREQ pScsiReq,
+                                    size_t offData, size_t cbData)
+{
+    RTSGBUF SgBuf;
+    RTSgBufInit(&SgBuf, pScsiReq->paI2TSegs, pScsiReq->cI2TSegs);
+    RTSgBufAdvance(&SgBuf, offData);
+
+    unsigned cSegs = pScsiReq->cI2TSegs;
+    size_t cbSegs = RTSgBufSegArrayCreate(&SgBuf, &pIScsiPDU->aISCSIReq[pIScsiPDU->cISCSIReq], &cSegs, cbData);
+    Assert(cbSegs == cbData);
+    pIScsiPDU->cISCSIReq += cSegs;
+
+    /* The data segment as a whole is padded to a 4 byte boundary. */
+    if (cbSegs & 3)
+    {
+        pIScsiPDU->aISCSIReq[pIScsiPDU->cISCSIReq].pvSeg = &pImage->aPadding[0];
+        pIScsiPDU->aISCSIReq[pIScsiPDU->cISCSIReq].cbSeg = 4 - (cbSegs & 3);
+        cbSegs += 4 - (cbSegs & 3);
+        pIScsiPDU->cISCSIReq++;
+    }
+
+    return cbSegs;
+}
+
+/**
+ * Links a chain of PDUs to the transmit list.
+ *
+ * @param   pImage      The iSCSI connection state to be used.
+ * @param   pHead       Head of the PDU chain.
+ * @param   pTail       Tail of the PDU chain.
+ * @param   fFront      Flag whether to insert the chain at the front of the list.
+ */
+static void iscsiPDUTxAddChain(PISCSIIMAGE pImage, PISCSIPDUTX pHead, PISCSIPDUTX pTail, bool fFront)
+{
+    if (!fFront)
+    {
+        if (!pImage->pIScsiPDUTxHead)
+            pImage->pIScsiPDUTxHead = pHead;
+        else
+            pImage->pIScsiPDUTxTail->pNext = pHead;
+        pImage->pIScsiPDUTxTail = pTail;
+    }
+    else
+    {
+        pTail->pNext = pImage->pIScsiPDUTxHead;
+        pImage->pIScsiPDUTxHead = pHead;
+        if (!pImage->pIScsiPDUTxTail)
+            pImage->pIScsiPDUTxTail = pTail;
+    }
+}
+
+/**
+ * Prepares the Data-Out PDUs for a Data-Out sequence of the given command and
+ * adds them to the transmit list.
+ *
+ * The sequence is split into PDUs no larger than the MaxRecvDataSegmentLength of
+ * the target, the data is sent directly from the S/G list of the request.
+ *
+ * @returns VBox status code.
+ * @param   pImage      The iSCSI connection state to be used.
+ * @param   pIScsiCmd   The iSCSI command the data belongs to.
+ * @param   Ttt         The target transfer tag (network byte order), ISCSI_TASK_TAG_RSVD
+ *                      for unsolicited data.
+ * @param   offData     Start offset of the sequence in the initiator to target buffer.
+ * @param   cbData      Size of the sequence in bytes.
+ * @param   fFront      Flag whether to send the sequence before any other queued PDUs.
+ *                      Solicited data must not wait for commands blocked by the CmdSN window.
+ */
+static int iscsiPDUTxDataOutPrepare(PISCSIIMAGE pImage, PISCSICMD pIScsiCmd, uint32_t Ttt,
+                                    size_t offData, size_t cbData, bool fFront)
+{
+    PSCSIREQ pScsiReq = pIScsiCmd->CmdType.ScsiReq.pScsiReq;
+    PISCSIPDUTX pHead = NULL;
+    PISCSIPDUTX pTail = NULL;
+    uint32_t DataSN = 0;
+    size_t cbPduMax = RT_MAX(pImage->cbSendDataLength, 512);
+
+    LogFlowFunc(("pImage=%#p pIScsiCmd=%#p Ttt=%#x offData=%zu cbData=%zu fFront=%RTbool\n",
+                 pImage, pIScsiCmd, Ttt, offData, cbData, fFront));
+
+    while (cbData)
+    {
+        size_t cbPdu = RT_MIN(cbData, cbPduMax);
+        /* Additional segments for the BHS and the padding. */
+        uint32_t cSegs = pScsiReq->cI2TSegs + 2;
+        PISCSIPDUTX pIScsiPDU = (PISCSIPDUTX)RTMemAllocZ(RT_UOFFSETOF_DYN(ISCSIPDUTX, aISCSIReq[cSegs]));
+        if (!pIScsiPDU)
+        {
+            while (pHead)
+            {
+                PISCSIPDUTX pFree = pHead;
+                pHead = pHead->pNext;
+                RTMemFree(pFree);
+            }
+            return VERR_NO_MEMORY;
+        }
+
+        uint32_t *paReqBHS = pIScsiPDU->aBHS;
+        paReqBHS[0]  = RT_H2N_U32((cbPdu == cbData ? ISCSI_FINAL_BIT : 0) | ISCSIOP_SCSI_DATA_OUT);
+        paReqBHS[1]  = RT_H2N_U32((uint32_t)cbPdu & 0xffffff); /* TotalAHSLength=0 */
+        paReqBHS[2]  = RT_H2N_U32(pImage->LUN >> 32);
+        paReqBHS[3]  = RT_H2N_U32(pImage->LUN & 0xffffffff);
+        paReqBHS[4]  = pIScsiCmd->Itt;
+        paReqBHS[5]  = Ttt;
+        paReqBHS[6]  = 0;            /* reserved */
+        paReqBHS[7]  = RT_H2N_U32(pImage->ExpStatSN);
+        paReqBHS[8]  = 0;            /* reserved */
+        paReqBHS[9]  = RT_H2N_U32(DataSN);
+        paReqBHS[10] = RT_H2N_U32((uint32_t)offData);
+        paReqBHS[11] = 0;            /* reserved */
+
+        /* Not subject to the CmdSN window but must not overtake the command. */
+        pIScsiPDU->CmdSN = pIScsiCmd->CmdSN;
+        pIScsiPDU->aISCSIReq[0].cbSeg = sizeof(pIScsiPDU->aBHS);
+        pIScsiPDU->aISCSIReq[0].pvSeg = pIScsiPDU->aBHS;
+        pIScsiPDU->cISCSIReq = 1;
+        pIScsiPDU->cbSgLeft  = sizeof(pIScsiPDU->aBHS)
+                             + iscsiPDUTxAddDataSegs(pImage, pIScsiPDU, pScsiReq, offData, cbPdu);
+        Assert(pIScsiPDU->cISCSIReq <= cSegs);
+        RTSgBufInit(&pIScsiPDU->SgBuf, pIScsiPDU->aISCSIReq, pIScsiPDU->cISCSIReq);
+
+        if (pTail)
+            pTail->pNext = pIScsiPDU;
+        else
+            pHead = pIScsiPDU;
+        pTail = pIScsiPDU;
+
+        offData += cbPdu;
+        cbData  -= cbPdu;
+        DataSN++;
+    }
+
+    if (pHead)
+        iscsiPDUTxAddChain(pImage, pHead, pTail, fFront);
+
+    return VINF_SUCCESS;
+}
+
 /**
  * Prepares a PDU to transfer for the given command and adds it to the list.
+ *
+ * Data to the target is sent as immediate data in the command PDU and in unsolicited
+ * Data-Out PDUs up to the negotiated first burst length, the remainder is sent when
+ * the target requests it with R2T PDUs (see iscsiRecvPDUUpdateRequest()).
  */
 static int iscsiPDUTxPrepare(PISCSIIMAGE pImage, PISCSICMD pIScsiCmd)
 {
@@ -2760,6 +2944,8 @@ static int iscsiPDUTxPrepare(PISCSIIMAGE pImage, PISCSICMD pIScsiCmd)
     uint32_t *paReqBHS;
     size_t cbData = 0;
     size_t cbSegs = 0;
+    size_t cbImmediate = 0;
+    size_t cbUnsolicited = 0;
     PSCSIREQ pScsiReq;
     PISCSIPDUTX pIScsiPDU = NULL;
 
@@ -2773,11 +2959,18 @@ static int iscsiPDUTxPrepare(PISCSIIMAGE pImage, PISCSICMD pIScsiCmd)
     if (pScsiReq->cT2ISegs)
         RTSgBufInit(&pScsiReq->SgBufT2I, pScsiReq->paT2ISegs, pScsiReq->cT2ISegs);
 
-    /*
-     * Allocate twice as much entries as required for padding (worst case).
-     * The additional segment is for the BHS.
-     */
-    uint32_t cI2TSegs = 2 * (pScsiReq->cI2TSegs + 1);
+    if (pScsiReq->cbI2TData)
+    {
+        size_t cbFirstBurst = RT_MIN(pScsiReq->cbI2TData, pImage->cbFirstBurstLength);
+
+        if (pImage->fImmediateData)
+            cbImmediate = RT_MIN(cbFirstBurst, pImage->cbSendDataLength);
+        if (!pImage->fInitialR2T)
+            cbUnsolicited = cbFirstBurst - cbImmediate;
+    }
+
+    /* Additional segments for the BHS and the padding. */
+    uint32_t cI2TSegs = pScsiReq->cI2TSegs + 2;
     pIScsiPDU = (PISCSIPDUTX)RTMemAllocZ(RT_UOFFSETOF_DYN(ISCSIPDUTX, aISCSIReq[cI2TSegs]));
     if (!pIScsiPDU)
         return VERR_NO_MEMORY;
@@ -2791,10 +2984,10 @@ static int iscsiPDUTxPrepare(PISCSIIMAGE pImage, PISCSICMD pIScsiCmd)
 
     paReqBHS = pIScsiPDU->aBHS;
 
-    /* Setup the BHS. */
-    paReqBHS[0] = RT_H2N_U32(  ISCSI_FINAL_BIT | ISCSI_TASK_ATTR_SIMPLE | ISCSIOP_SCSI_CMD
-                             | (pScsiReq->enmXfer << 21)); /* I=0,F=1,Attr=Simple */
-    paReqBHS[1] = RT_H2N_U32(0x00000000 | ((uint32_t)pScsiReq->cbI2TData & 0xffffff)); /* TotalAHSLength=0 */
+    /* Setup the BHS, the final bit tells the target whether unsolicited Data-Out PDUs follow. */
+    paReqBHS[0] = RT_H2N_U32(  (cbUnsolicited ? 0 : ISCSI_FINAL_BIT) | ISCSI_TASK_ATTR_SIMPLE | ISCSIOP_SCSI_CMD
+                             | (pScsiReq->enmXfer << 21)); /* I=0,Attr=Simple */
+    paReqBHS[1] = RT_H2N_U32(0x00000000 | ((uint32_t)cbImmediate & 0xffffff)); /* TotalAHSLength=0 */
     paReqBHS[2] = RT_H2N_U32(pImage->LUN >> 32);
     paReqBHS[3] = RT_H2N_U32(pImage->LUN & 0xffffffff);
     paReqBHS[4] = pIScsiCmd->Itt;
@@ -2804,47 +2997,34 @@ static int iscsiPDUTxPrepare(PISCSIIMAGE pImage, PISCSICMD pIScsiCmd)
     memcpy(paReqBHS + 8, pScsiReq->abCDB, pScsiReq->cbCDB);
 
     pIScsiPDU->CmdSN = pImage->CmdSN;
+    pIScsiCmd->CmdSN = pImage->CmdSN;
     pImage->CmdSN++;
 
     /* Setup the S/G buffers. */
-    uint32_t cnISCSIReq = 0;
-    pIScsiPDU->aISCSIReq[cnISCSIReq].cbSeg = sizeof(pIScsiPDU->aBHS);
-    pIScsiPDU->aISCSIReq[cnISCSIReq].pvSeg = pIScsiPDU->aBHS;
-    cnISCSIReq++;
+    pIScsiPDU->aISCSIReq[0].cbSeg = sizeof(pIScsiPDU->aBHS);
+    pIScsiPDU->aISCSIReq[0].pvSeg = pIScsiPDU->aBHS;
+    pIScsiPDU->cISCSIReq = 1;
     cbSegs = sizeof(pIScsiPDU->aBHS);
     /* Padding is not necessary for the BHS. */
 
-    if (pScsiReq->cbI2TData)
-    {
-        for (unsigned cSeg = 0; cSeg < pScsiReq->cI2TSegs; cSeg++)
-        {
-            Assert(cnISCSIReq < cI2TSegs);
-            pIScsiPDU->aISCSIReq[cnISCSIReq].cbSeg = pScsiReq->paI2TSegs[cSeg].cbSeg;
-            pIScsiPDU->aISCSIReq[cnISCSIReq].pvSeg = pScsiReq->paI2TSegs[cSeg].pvSeg;
-            cbSegs += pScsiReq->paI2TSegs[cSeg].cbSeg;
-            cnISCSIReq++;
-
-            /* Add padding if necessary. */
-            if (pScsiReq->paI2TSegs[cSeg].cbSeg & 3)
-            {
-                Assert(cnISCSIReq < cI2TSegs);
-                pIScsiPDU->aISCSIReq[cnISCSIReq].pvSeg = &pImage->aPadding[0];
-                pIScsiPDU->aISCSIReq[cnISCSIReq].cbSeg = 4 - (pScsiReq->paI2TSegs[cSeg].cbSeg & 3);
-                cbSegs += pIScsiPDU->aISCSIReq[cnISCSIReq].cbSeg;
-                cnISCSIReq++;
-            }
-        }
-    }
+    if (cbImmediate)
+        cbSegs += iscsiPDUTxAddDataSegs(pImage, pIScsiPDU, pScsiReq, 0 /*offData*/, cbImmediate);
+    Assert(pIScsiPDU->cISCSIReq <= cI2TSegs);
 
-    pIScsiPDU->cISCSIReq = cnISCSIReq;
     pIScsiPDU->cbSgLeft  = cbSegs;
-    RTSgBufInit(&pIScsiPDU->SgBuf, pIScsiPDU->aISCSIReq, cnISCSIReq);
+    RTSgBufInit(&pIScsiPDU->SgBuf, pIScsiPDU->aISCSIReq, pIScsiPDU->cISCSIReq);
 
     /* Link the PDU to the list. */
     iscsiPDUTxAdd(pImage, pIScsiPDU, false /* fFront */);
 
+    /* The unsolicited Data-Out PDUs follow the command directly. */
+    if (cbUnsolicited)
+        rc = iscsiPDUTxDataOutPrepare(pImage, pIScsiCmd, ISCSI_TASK_TAG_RSVD,
+                                      cbImmediate, cbUnsolicited, false /* fFront */);
+
     /* Start transfer of a PDU if there is no one active at the moment. */
-    if (!pImage->pIScsiPDUTxCur)
+    if (   RT_SUCCESS(rc)
+        && !pImage->pIScsiPDUTxCur)
         rc = iscsiSendPDUAsync(pImage);
 
     return rc;
@@ -2954,6 +3134,26 @@ static int iscsiRecvPDUUpdateRequest(PISCSIIMAGE pImage, PISCSIRES paRes, uint32
                 }
             }
         }
+        else if (cmd == ISCSIOP_R2T)
+        {
+            /* The target is ready to receive the given range of the data, the TTT is echoed back. */
+            uint32_t offBuffer = RT_N2H_U32(paResBHS[10]);
+            uint32_t cbDesired = RT_N2H_U32(paResBHS[11]);
+
+            if (   pScsiReq->enmXfer != SCSIXFER_TO_TARGET
+                || !cbDesired
+                || offBuffer >= pScsiReq->cbI2TData
+                || cbDesired > pScsiReq->cbI2TData - offBuffer)
+                rc = VERR_PARSE_ERROR;
+            else
+            {
+                /* The caller kicks off the transmission. */
+                rc = iscsiPDUTxDataOutPrepare(pImage, pIScsiCmd, paResBHS[5], offBuffer, cbDesired,
+                                              true /* fFront */);
+                if (RT_FAILURE(rc))
+                    return rc; /* Not a malformed PDU, the connection needs to be reset. */
+            }
+        }
         else
             rc = VERR_PARSE_ERROR;
     }
@@ -3178,6 +3378,8 @@ static int iscsiUpdateParameters(PISCSIIMAGE pImage, const uint8_t *pbBuf, size_
     const char *pcszMaxRecvDataSegmentLength = NULL;
     const char *pcszMaxBurstLength = NULL;
     const char *pcszFirstBurstLength = NULL;
+    const char *pcszImmediateData = NULL;
+    const char *pcszInitialR2T = NULL;
     rc = iscsiTextGetKeyValue(pbBuf, cbBuf, "MaxRecvDataSegmentLength", &pcszMaxRecvDataSegmentLength);
     if (rc == VERR_INVALID_NAME)
         rc = VINF_SUCCESS;
@@ -3189,6 +3391,16 @@ static int iscsiUpdateParameters(PISCSIIMAGE pImage, const uint8_t *pbBuf, size_
     if (RT_FAILURE(rc))
         return VERR_PARSE_ERROR;
     rc = iscsiTextGetKeyValue(pbBuf, cbBuf, "FirstBurstLength", &pcszFirstBurstLength);
+    if (rc == VERR_INVALID_NAME)
+        rc = VINF_SUCCESS;
+    if (RT_FAILURE(rc))
+        return VERR_PARSE_ERROR;
+    rc = iscsiTextGetKeyValue(pbBuf, cbBuf, "ImmediateData", &pcszImmediateData);
+    if (rc == VERR_INVALID_NAME)
+        rc = VINF_SUCCESS;
+    if (RT_FAILURE(rc))
+        return VERR_PARSE_ERROR;
+    rc = iscsiTextGetKeyValue(pbBuf, cbBuf, "InitialR2T", &pcszInitialR2T);
     if (rc == VERR_INVALID_NAME)
         rc = VINF_SUCCESS;
     if (RT_FAILURE(rc))
@@ -3202,18 +3414,25 @@ static int iscsiUpdateParameters(PISCSIIMAGE pImage, const uint8_t *pbBuf, size_
     }
     if (pcszMaxBurstLength)
     {
-        uint32_t cb = pImage->cbSendDataLength;
+        uint32_t cb = pImage->cbMaxBurstLength;
         rc = RTStrToUInt32Full(pcszMaxBurstLength, 0, &cb);
         AssertRC(rc);
-        pImage->cbSendDataLength = RT_MIN(pImage->cbSendDataLength, cb);
+        pImage->cbMaxBurstLength = RT_MIN(pImage->cbMaxBurstLength, cb);
     }
     if (pcszFirstBurstLength)
     {
-        uint32_t cb = pImage->cbSendDataLength;
+        uint32_t cb = pImage->cbFirstBurstLength;
         rc = RTStrToUInt32Full(pcszFirstBurstLength, 0, &cb);
         AssertRC(rc);
-        pImage->cbSendDataLength = RT_MIN(pImage->cbSendDataLength, cb);
+        pImage->cbFirstBurstLength = RT_MIN(pImage->cbFirstBurstLength, cb);
     }
+    /* The result of both is the boolean AND respectively OR of the offers. */
+    if (pcszImmediateData)
+        pImage->fImmediateData = pImage->fImmediateData && !strcmp(pcszImmediateData, "Yes");
+    if (pcszInitialR2T)
+        pImage->fInitialR2T = pImage->fInitialR2T || !strcmp(pcszInitialR2T, "Yes");
+    /* The first burst can't be larger than any burst. */
+    pImage->cbFirstBurstLength = RT_MIN(pImage->cbFirstBurstLength, pImage->cbMaxBurstLength);
     return VINF_SUCCESS;
 }
 
@@ -4886,9 +5105,13 @@ static DECLCALLBACK(int) iscsiRead(void *pBackendData, uint64_t uOffset, size_t
         return VERR_INVALID_PARAMETER;
 
     /*
-     * Clip read size to a value which is supported by the target.
+     * Clip read size to a value which is supported by the target. The I/O thread
+     * handles data split across several Data-In PDUs, the synchronous path doesn't.
      */
-    cbToRead = RT_MIN(cbToRead, pImage->cbRecvDataLength);
+    if (pImage->fExtendedSelectSupported)
+        cbToRead = RT_MIN(cbToRead, ISCSI_XFER_LENGTH_MAX);
+    else
+        cbToRead = RT_MIN(cbToRead, pImage->cbRecvDataLength);
 
     unsigned cT2ISegs = 0;
     size_t   cbSegs = 0;
@@ -5013,9 +5236,14 @@ static DECLCALLBACK(int) iscsiWrite(void *pBackendData, uint64_t uOffset, size_t
         return VERR_INVALID_PARAMETER;
 
     /*
-     * Clip read size to a value which is supported by the target.
+     * Clip write size to a value which is supported by the target. The I/O thread
+     * sends anything beyond the first burst in Data-Out PDUs as requested by the target,
+     * the synchronous path is limited to immediate data.
      */
-    cbToWrite = RT_MIN(cbToWrite, pImage->cbSendDataLength);
+    if (pImage->fExtendedSelectSupported)
+        cbToWrite = RT_MIN(cbToWrite, RT_MIN(pImage->cbWriteSplit, ISCSI_XFER_LENGTH_MAX));
+    else
+        cbToWrite = RT_MIN(cbToWrite, RT_MIN(pImage->cbSendDataLength, pImage->cbFirstBurstLength));
 
     unsigned cI2TSegs = 0;
     size_t   cbSegs = 0;
@@ -204,8 +204,15 @@ typedef struct QCOWL2CACHEENTRY
     uint64_t               *paL2Tbl;
 } QCOWL2CACHEENTRY, *PQCOWL2CACHEENTRY;
 
-/** Maximum amount of memory the cache is allowed to use. */
-#define QCOW_L2_CACHE_MEMORY_MAX (2*_1M)
+/** Amount of memory the cache starts with. */
+#define QCOW_L2_CACHE_MEMORY_MIN (2*_1M)
+/** Default upper limit of memory the cache is allowed to grow to,
+ * can be changed with the "L2CacheSize" configuration key. */
+#define QCOW_L2_CACHE_MEMORY_MAX_DEF (32*_1M)
+/** Number of lookups the miss rate is sampled over before deciding whether to grow the cache. */
+#define QCOW_L2_CACHE_SAMPLE_LOOKUPS 256
+/** The cache grows if more than 1/2^QCOW_L2_CACHE_GROW_MISS_SHIFT of the sampled lookups missed. */
+#define QCOW_L2_CACHE_GROW_MISS_SHIFT 3
 
 /** QCOW default cluster size for image version 2. */
 #define QCOW2_CLUSTER_SIZE_DEFAULT (64*_1K)
@@ -283,6 +290,20 @@ typedef struct QCOWIMAGE
     uint32_t            cL2TableEntries;
     /** Memory occupied by the L2 table cache. */
     size_t              cbL2Cache;
+    /** Current amount of memory the L2 table cache may use before entries are evicted. */
+    size_t              cbL2CacheMax;
+    /** Upper limit the L2 table cache may grow to. */
+    size_t              cbL2CacheLimit;
+    /** Number of L2 table lookups served from the cache. */
+    uint64_t            cL2CacheHits;
+    /** Number of L2 table lookups which had to read the table from the image. */
+    uint64_t            cL2CacheMisses;
+    /** Number of L2 tables evicted from the cache. */
+    uint64_t            cL2CacheEvictions;
+    /** Number of lookups in the current sampling window. */
+    uint32_t            cL2CacheSampleLookups;
+    /** Number of misses in the current sampling window. */
+    uint32_t            cL2CacheSampleMisses;
     /** The sorted L2 entry list used for searching. */
     RTLISTNODE          ListSearch;
     /** The LRU L2 entry list used for eviction. */
@@ -312,6 +333,14 @@ typedef struct QCOWIMAGE
     void                *pvCompCluster;
     /** Buffer to hold the uncompressed data. */
     void                *pvCluster;
+    /** Image offset of the compressed cluster currently held in pvCluster,
+     * UINT64_MAX if none. */
+    uint64_t            offClusterInflated;
+    /** Bounce buffer for reading cluster aligned chunks of compressed data. */
+    void                *pvCompChunk;
+    /** End of the image when it was opened, compressed data is never written
+     * so it can't be stored beyond this offset. */
+    uint64_t            offCompDataEnd;
 
     /** Pointer to the L2 table we are currently allocating
      * (can be only one at a time). */
@@ -536,13 +565,88 @@ static void qcowTableConvertFromHostEndianess(uint64_t *paTblImg, uint64_t const
  */
 static int qcowL2TblCacheCreate(PQCOWIMAGE pImage)
 {
-    pImage->cbL2Cache = 0;
+    pImage->cbL2Cache             = 0;
+    pImage->cbL2CacheMax          = QCOW_L2_CACHE_MEMORY_MIN;
+    pImage->cbL2CacheLimit        = QCOW_L2_CACHE_MEMORY_MAX_DEF;
+    pImage->cL2CacheHits          = 0;
+    pImage->cL2CacheMisses        = 0;
+    pImage->cL2CacheEvictions     = 0;
+    pImage->cL2CacheSampleLookups = 0;
+    pImage->cL2CacheSampleMisses  = 0;
     RTListInit(&pImage->ListSearch);
     RTListInit(&pImage->ListLru);
 
     return VINF_SUCCESS;
 }
 
+/**
+ * Sets the upper limit the L2 table cache may grow to once the image geometry is known.
+ *
+ * The limit is taken from the "L2CacheSize" configuration key if present,
+ * otherwise it is the memory required to cache all L2 tables of the image
+ * capped at QCOW_L2_CACHE_MEMORY_MAX_DEF.
+ *
+ * @returns VBox status code.
+ * @param   pImage    The image instance data.
+ */
+static int qcowL2TblCacheSetLimit(PQCOWIMAGE pImage)
+{
+    uint64_t cbLimit = RT_MIN((uint64_t)pImage->cL1TableEntries * pImage->cbL2Table,
+                              QCOW_L2_CACHE_MEMORY_MAX_DEF);
+    int rc = VINF_SUCCESS;
+
+    PVDINTERFACECONFIG pImgCfg = VDIfConfigGet(pImage->pVDIfsImage);
+    if (pImgCfg)
+    {
+        rc = VDCFGQueryU64Def(pImgCfg, "L2CacheSize", &cbLimit, cbLimit);
+        if (RT_FAILURE(rc))
+            rc = vdIfError(pImage->pIfError, rc, RT_SRC_POS,
+                           N_("QCow: Getting L2CacheSize for '%s' failed (%Rrc)"), pImage->pszFilename, rc);
+    }
+
+    if (RT_SUCCESS(rc))
+    {
+        /* Always allow at least a single table, the cache can't work otherwise. */
+        pImage->cbL2CacheLimit = (size_t)RT_MAX(cbLimit, pImage->cbL2Table);
+        pImage->cbL2CacheMax   = RT_MIN(pImage->cbL2CacheMax, pImage->cbL2CacheLimit);
+    }
+
+    return rc;
+}
+
+/**
+ * Records the outcome of a L2 table cache lookup and grows the cache if the
+ * miss rate of the last sampling window was too high.
+ *
+ * @param   pImage    The image instance data.
+ * @param   fHit      Flag whether the lookup was served from the cache.
+ */
+static void qcowL2TblCacheRecordLookup(PQCOWIMAGE pImage, bool fHit)
+{
+    if (fHit)
+        pImage->cL2CacheHits++;
+    else
+    {
+        pImage->cL2CacheMisses++;
+        pImage->cL2CacheSampleMisses++;
+    }
+
+    if (++pImage->cL2CacheSampleLookups == QCOW_L2_CACHE_SAMPLE_LOOKUPS)
+    {
+        if (   pImage->cL2CacheSampleMisses > (QCOW_L2_CACHE_SAMPLE_LOOKUPS >> QCOW_L2_CACHE_GROW_MISS_SHIFT)
+            && pImage->cbL2CacheMax < pImage->cbL2CacheLimit
+            && pImage->cbL2Cache + pImage->cbL2Table > pImage->cbL2CacheMax)
+        {
+            /* The working set doesn't fit, double the cache (the tables are allocated on demand). */
+            pImage->cbL2CacheMax = RT_MIN(pImage->cbL2CacheMax * 2, pImage->cbL2CacheLimit);
+            LogFlowFunc(("Growing L2 table cache of '%s' to %zu bytes\n", pImage->pszFilename, pImage->cbL2CacheMax));
+        }
+
+        pImage->cL2CacheSampleLookups = 0;
+        pImage->cL2CacheSampleMisses  = 0;
+    }
+}
+
 /**
  * Destroys the L2 table cache.
  *
@@ -561,7 +665,16 @@ static void qcowL2TblCacheDestroy(PQCOWIMAGE pImage)
         RTMemFree(pL2Entry);
     }
 
+    if (pImage->cL2CacheHits + pImage->cL2CacheMisses)
+        LogRel(("QCow: L2 table cache of '%s': %llu hits, %llu misses (%u%% hit rate), %llu evictions, %zu of %zu bytes used\n",
+                pImage->pszFilename, pImage->cL2CacheHits, pImage->cL2CacheMisses,
+                (unsigned)(pImage->cL2CacheHits * 100 / (pImage->cL2CacheHits + pImage->cL2CacheMisses)),
+                pImage->cL2CacheEvictions, pImage->cbL2Cache, pImage->cbL2CacheMax));
+
     pImage->cbL2Cache       = 0;
+    pImage->cL2CacheHits    = 0;
+    pImage->cL2CacheMisses  = 0;
+    pImage->cL2CacheEvictions = 0;
     RTListInit(&pImage->ListSearch);
     RTListInit(&pImage->ListLru);
 }
@@ -622,7 +735,8 @@ static PQCOWL2CACHEENTRY qcowL2TblCacheEntryAlloc(PQCOWIMAGE pImage)
 {
     PQCOWL2CACHEENTRY pL2Entry = NULL;
 
-    if (pImage->cbL2Cache + pImage->cbL2Table <= QCOW_L2_CACHE_MEMORY_MAX)
+    if (   pImage->cbL2Cache + pImage->cbL2Table <= pImage->cbL2CacheMax
+        || RTListIsEmpty(&pImage->ListLru))
     {
         /* Add a new entry. */
         pL2Entry = (PQCOWL2CACHEENTRY)RTMemAllocZ(sizeof(QCOWL2CACHEENTRY));
@@ -658,6 +772,7 @@ static PQCOWL2CACHEENTRY qcowL2TblCacheEntryAlloc(PQCOWIMAGE pImage)
             RTListNodeRemove(&pL2Entry->NodeLru);
             pL2Entry->offL2Tbl = 0;
             pL2Entry->cRefs    = 1;
+            pImage->cL2CacheEvictions++;
         }
         else
             pL2Entry = NULL;
@@ -741,6 +856,7 @@ static int qcowL2TblCacheFetch(PQCOWIMAGE pImage, PVDIOCTX pIoCtx, uint64_t offL
 
     /* Try to fetch the L2 table from the cache first. */
     PQCOWL2CACHEENTRY pL2Entry = qcowL2TblCacheRetain(pImage, offL2Tbl);
+    qcowL2TblCacheRecordLookup(pImage, pL2Entry != NULL);
     if (!pL2Entry)
     {
         pL2Entry = qcowL2TblCacheEntryAlloc(pImage);
@@ -1087,6 +1203,13 @@ static int qcowFreeImage(PQCOWIMAGE pImage, bool fDelete)
         {
             RTMemFree(pImage->pvCluster);
             pImage->pvCluster = NULL;
+            pImage->offClusterInflated = UINT64_MAX;
+        }
+
+        if (pImage->pvCompChunk)
+        {
+            RTMemFree(pImage->pvCompChunk);
+            pImage->pvCompChunk = NULL;
         }
 
         qcowL2TblCacheDestroy(pImage);
@@ -1170,7 +1293,8 @@ static int qcowHdrValidate(PQCOWIMAGE pImage, PQCowHeader pHdr, uint64_t cbFile)
  */
 static int qcowOpenImage(PQCOWIMAGE pImage, unsigned uOpenFlags)
 {
-    pImage->uOpenFlags = uOpenFlags;
+    pImage->uOpenFlags         = uOpenFlags;
+    pImage->offClusterInflated = UINT64_MAX;
 
     pImage->pIfError = VDIfErrorGet(pImage->pVDIfsDisk);
     pImage->pIfIo = VDIfIoIntGet(pImage->pVDIfsImage);
@@ -1198,6 +1322,7 @@ static int qcowOpenImage(PQCOWIMAGE pImage, unsigned uOpenFlags)
                     && qcowHdrConvertToHostEndianess(&Header))
                 {
                     pImage->offNextCluster = RT_ALIGN_64(cbFile, 512); /* Align image to sector boundary. */
+                    pImage->offCompDataEnd = cbFile;
                     Assert(pImage->offNextCluster >= cbFile);
 
                     rc = qcowHdrValidate(pImage, &Header, cbFile);
@@ -1337,7 +1462,11 @@ static int qcowOpenImage(PQCOWIMAGE pImage, unsigned uOpenFlags)
                     if (RT_SUCCESS(rc))
                     {
                         qcowTableMasksInit(pImage);
+                        rc = qcowL2TblCacheSetLimit(pImage);
+                    }
 
+                    if (RT_SUCCESS(rc))
+                    {
                         /* Allocate L1 table. */
                         pImage->paL1Table = (uint64_t *)RTMemAllocZ(pImage->cbL1Table);
                         if (pImage->paL1Table)
@@ -1413,6 +1542,7 @@ static int qcowCreateImage(PQCOWIMAGE pImage, uint64_t cbSize,
         {
             pImage->uOpenFlags   = uOpenFlags & ~VD_OPEN_FLAGS_READONLY;
             pImage->uImageFlags  = uImageFlags;
+            pImage->offClusterInflated = UINT64_MAX;
             pImage->PCHSGeometry = *pPCHSGeometry;
             pImage->LCHSGeometry = *pLCHSGeometry;
             pImage->pIfError = VDIfErrorGet(pImage->pVDIfsDisk);
@@ -1439,10 +1569,14 @@ static int qcowCreateImage(PQCOWIMAGE pImage, uint64_t cbSize,
                 pImage->offBackingFilename = 0;
                 pImage->offNextCluster     = RT_ALIGN_64(QCOW_V1_HDR_SIZE + pImage->cbL1Table, pImage->cbCluster);
                 qcowTableMasksInit(pImage);
+                rc = qcowL2TblCacheSetLimit(pImage);
 
                 /* Init L1 table. */
-                pImage->paL1Table = (uint64_t *)RTMemAllocZ(pImage->cbL1Table);
-                if (RT_LIKELY(pImage->paL1Table))
+                if (RT_SUCCESS(rc))
+                    pImage->paL1Table = (uint64_t *)RTMemAllocZ(pImage->cbL1Table);
+                if (RT_FAILURE(rc))
+                { /* Error already set. */ }
+                else if (RT_LIKELY(pImage->paL1Table))
                 {
                     if (RT_SUCCESS(rc))
                         vdIfProgress(pIfProgress, uPercentStart + uPercentSpan * 98 / 100);
@@ -1643,6 +1777,15 @@ static DECLCALLBACK(int) qcowAsyncClusterAllocUpdate(void *pBackendData, PVDIOCT
  * Reads a compressed cluster, inflates it and copies the amount of data requested
  * into the given I/O context.
  *
+ * The compressed data is read as metadata in cluster aligned chunks. Compressed
+ * clusters are packed without alignment so neighbouring ones share chunks, which
+ * keeps the metadata transfers of concurrent requests from overlapping and lets
+ * them share a single read. For asynchronous I/O contexts the function returns
+ * VERR_VD_NOT_ENOUGH_METADATA until all chunks arrived and is called again by the
+ * VD layer once they did, so other requests are not blocked while waiting. The
+ * last inflated cluster is kept to serve further reads from the same cluster
+ * without reading and inflating it again.
+ *
  * @returns VBox status code.
  * @param   pImage              The image instance data.
  * @param   pIoCtx              The I/O context.
@@ -1657,7 +1800,13 @@ static int qcowReadCompressedCluster(PQCOWIMAGE pImage, PVDIOCTX pIoCtx,
 {
     int rc = VINF_SUCCESS;
 
-    AssertReturn(!(pImage->uOpenFlags & VD_OPEN_FLAGS_ASYNC_IO), VERR_NOT_SUPPORTED); /* Only synchronous I/O supported so far. */
+    if (pImage->offClusterInflated == offFile)
+    {
+        vdIfIoIntIoCtxCopyTo(pImage->pIfIo, pIoCtx,
+                             (uint8_t *)pImage->pvCluster + offCluster,
+                             cbToRead);
+        return VINF_SUCCESS;
+    }
 
     if (cbCompressedCluster > pImage->cbCompCluster)
     {
@@ -1671,36 +1820,79 @@ static int qcowReadCompressedCluster(PQCOWIMAGE pImage, PVDIOCTX pIoCtx,
             rc = VERR_NO_MEMORY;
     }
 
-    if (RT_SUCCESS(rc))
+    if (   RT_SUCCESS(rc)
+        && !pImage->pvCompChunk)
     {
-        rc = vdIfIoIntFileReadMeta(pImage->pIfIo, pImage->pStorage,
-                                   offFile, pImage->pvCompCluster,
-                                   cbCompressedCluster, NULL,
-                                   NULL, NULL, NULL);
-        if (RT_SUCCESS(rc))
+        pImage->pvCompChunk = RTMemAlloc(pImage->cbCluster);
+        if (!pImage->pvCompChunk)
+            rc = VERR_NO_MEMORY;
+    }
+
+    if (   RT_SUCCESS(rc)
+        && !pImage->pvCluster)
+    {
+        pImage->pvCluster = RTMemAllocZ(pImage->cbCluster);
+        if (!pImage->pvCluster)
+            rc = VERR_NO_MEMORY;
+    }
+
+    /*
+     * Read all chunks covering the compressed data, the last compressed cluster
+     * might end before the descriptor says so the chunks are clipped at the end
+     * the image had when it was opened (which also keeps the chunk sizes stable
+     * while the image grows). All reads are issued before waiting for any of them.
+     */
+    size_t   cbComp   = 0;
+    uint64_t offChunk = offFile & ~(uint64_t)(pImage->cbCluster - 1);
+    while (   RT_SUCCESS(rc)
+           && offChunk < offFile + cbCompressedCluster
+           && offChunk < pImage->offCompDataEnd)
+    {
+        size_t      cbChunk   = (size_t)RT_MIN(pImage->cbCluster, pImage->offCompDataEnd - offChunk);
+        PVDMETAXFER pMetaXfer = NULL;
+        int rc2 = vdIfIoIntFileReadMeta(pImage->pIfIo, pImage->pStorage,
+                                        offChunk, pImage->pvCompChunk, cbChunk,
+                                        pIoCtx, &pMetaXfer, NULL, NULL);
+        if (RT_SUCCESS(rc2))
         {
-            if (!pImage->pvCluster)
+            if (pMetaXfer)
+                vdIfIoIntMetaXferRelease(pImage->pIfIo, pMetaXfer);
+
+            uint64_t offStart = RT_MAX(offChunk, offFile);
+            uint64_t offEnd   = RT_MIN(offChunk + cbChunk, offFile + cbCompressedCluster);
+            if (offEnd > offStart)
             {
-                pImage->pvCluster = RTMemAllocZ(pImage->cbCluster);
-                if (!pImage->pvCluster)
-                    rc = VERR_NO_MEMORY;
+                memcpy((uint8_t *)pImage->pvCompCluster + (offStart - offFile),
+                       (uint8_t *)pImage->pvCompChunk + (offStart - offChunk),
+                       (size_t)(offEnd - offStart));
+                cbComp = (size_t)(offEnd - offFile);
             }
+        }
+        else if (rc2 == VERR_VD_NOT_ENOUGH_METADATA)
+            rc = VINF_TRY_AGAIN; /* Continue issuing reads for the remaining chunks. */
+        else
+            rc = rc2;
 
-            if (RT_SUCCESS(rc))
-            {
-                size_t cbDecomp = 0;
+        offChunk += pImage->cbCluster;
+    }
 
-                rc = RTZipBlockDecompress(RTZIPTYPE_ZLIB_NO_HEADER, 0 /*fFlags*/,
-                                          pImage->pvCompCluster, cbCompressedCluster, NULL,
-                                          pImage->pvCluster, pImage->cbCluster, &cbDecomp);
-                if (RT_SUCCESS(rc))
-                {
-                    Assert(cbDecomp == pImage->cbCluster);
-                    vdIfIoIntIoCtxCopyTo(pImage->pIfIo, pIoCtx,
-                                         (uint8_t *)pImage->pvCluster + offCluster,
-                                         cbToRead);
-                }
-            }
+    if (rc == VINF_TRY_AGAIN)
+        rc = VERR_VD_NOT_ENOUGH_METADATA;
+    else if (RT_SUCCESS(rc))
+    {
+        size_t cbDecomp = 0;
+
+        pImage->offClusterInflated = UINT64_MAX;
+        rc = RTZipBlockDecompress(RTZIPTYPE_ZLIB_NO_HEADER, 0 /*fFlags*/,
+                                  pImage->pvCompCluster, cbComp, NULL,
+                                  pImage->pvCluster, pImage->cbCluster, &cbDecomp);
+        if (RT_SUCCESS(rc))
+        {
+            Assert(cbDecomp == pImage->cbCluster);
+            pImage->offClusterInflated = offFile;
+            vdIfIoIntIoCtxCopyTo(pImage->pIfIo, pIoCtx,
+                                 (uint8_t *)pImage->pvCluster + offCluster,
+                                 cbToRead);
         }
     }
 
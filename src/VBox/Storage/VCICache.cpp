@@ -26,6 +26,30 @@
  */
 
 
+/** @page pg_vd_vci     VCI - VirtualBox Cache Image
+ *
+ * A cache image keeps copies of virtual disk data on fast local storage. It is
+ * used as a read cache for data coming from the image chain and optionally as
+ * a write-back tier absorbing guest writes, which the VD layer writes back to
+ * the image in the background.
+ *
+ * The data area is divided into cache lines of VCI_LINE_SIZE bytes which are
+ * organized as a set associative cache with VCI_WAYS lines per set. Each line
+ * tracks which sectors hold valid data and which of these are dirty, i.e. not
+ * yet written back to the image.
+ *
+ * The line table exists twice in the image. One copy is the checkpoint the
+ * state is based on, changes after it are appended to a metadata log which is
+ * replayed when the image is opened. A log commit first flushes the data, then
+ * appends the log pages and flushes again, so every committed line state only
+ * refers to data which made it to the medium. When the log is full the
+ * complete table is written to the inactive copy which then becomes the new
+ * checkpoint. A line dropped from the cache is not reused before its removal
+ * was committed, so a crash can never associate stale data with another
+ * location of the disk.
+ */
+
+
 /*********************************************************************************************************************************
 *   Header Files                                                                                                                 *
 *********************************************************************************************************************************/
@@ -37,6 +61,8 @@
 #include <iprt/assert.h>
 #include <iprt/asm-mem.h>
 #include <iprt/asm.h>
+#include <iprt/crc.h>
+#include <iprt/critsect.h>
 #include <iprt/mem.h>
 #include <iprt/file.h>
 
@@ -59,6 +85,16 @@
 /** Convert byte offset/size to block number/size. */
 #define VCI_BYTE2BLOCK(u)          ((u) >> 9)
 
+/** Size of a cache line in bytes. */
+#define VCI_LINE_SIZE              _32K
+/** Number of sectors in a cache line, one bit each in the line bitmaps. */
+#define VCI_LINE_SECTORS           (VCI_LINE_SIZE / VCI_BLOCK_SIZE)
+AssertCompile(VCI_LINE_SECTORS == 64);
+/** Number of lines in a set. */
+#define VCI_WAYS                   8
+/** Alignment of the metadata areas and the data area in the image. */
+#define VCI_AREA_ALIGNMENT         _64K
+
 /**
  * The VCI header - at the beginning of the file.
  *
@@ -78,26 +114,42 @@ typedef struct VciHdr
     uint8_t     fUncleanShutdown;
     /** Cache type. */
     uint32_t    u32CacheType;
-    /** Offset of the B+-Tree root in the image in blocks. */
-    uint64_t    offTreeRoot;
-    /** Offset of the block allocation bitmap in blocks. */
-    uint64_t    offBlkMap;
-    /** Size of the block allocation bitmap in blocks. */
-    uint32_t    cBlkMap;
+    /** Size of a cache line in bytes. */
+    uint32_t    cbLine;
+    /** Number of lines in a set. */
+    uint32_t    cWays;
+    /** Number of cache lines. */
+    uint32_t    cLines;
+    /** Offsets of the two line table copies in blocks. */
+    uint64_t    aoffLineTbl[2];
+    /** The line table copy the metadata log applies to. */
+    uint8_t     idxLineTbl;
+    /** Offset of the metadata log in blocks. */
+    uint64_t    offLog;
+    /** Size of the metadata log in blocks. */
+    uint32_t    cLogBlocks;
+    /** Sequence number of the first log page belonging to the active line table. */
+    uint64_t    u64LogSeqBase;
+    /** Offset of the data area in blocks. */
+    uint64_t    offData;
     /** UUID of the image. */
     RTUUID      uuidImage;
     /** Modification UUID for the cache. */
     RTUUID      uuidModification;
+    /** CRC32 of the header with this field set to 0. */
+    uint32_t    u32Crc;
     /** Reserved for future use. */
-    uint8_t     abReserved[951];
+    uint8_t     abReserved[910];
 } VciHdr, *PVciHdr;
 #pragma pack()
 AssertCompileSize(VciHdr, 2 * VCI_BLOCK_SIZE);
+/* Everything the header update relies on must be within the first sector. */
+AssertCompile(RT_UOFFSETOF(VciHdr, abReserved) <= VCI_BLOCK_SIZE);
 
 /** VCI signature to identify a valid image. */
 #define VCI_HDR_SIGNATURE          UINT32_C(0x00494356) /* \0ICV */
 /** Current version we support. */
-#define VCI_HDR_VERSION            UINT32_C(0x00000001)
+#define VCI_HDR_VERSION            UINT32_C(0x00000002)
 
 /** Value for an unclean cache shutdown. */
 #define VCI_HDR_UNCLEAN_SHUTDOWN   UINT8_C(0x01)
@@ -110,108 +162,84 @@ AssertCompileSize(VciHdr, 2 * VCI_BLOCK_SIZE);
 #define VCI_HDR_CACHE_TYPE_FIXED   UINT32_C(0x00000002)
 
 /**
- * On disk representation of an extent describing a range of cached data.
+ * On disk representation of a cache line in the line table.
  *
  * All entries a stored in little endian order.
  */
 #pragma pack(1)
-typedef struct VciCacheExtent
+typedef struct VciLineEnt
 {
-    /** Block address of the previous extent in the LRU list. */
-    uint64_t    u64ExtentPrev;
-    /** Block address of the next extent in the LRU list. */
-    uint64_t    u64ExtentNext;
-    /** Flags (for compression, encryption etc.) - currently unused and should be always 0. */
-    uint8_t     u8Flags;
-    /** Reserved */
-    uint8_t     u8Reserved;
-    /** First block of cached data the extent represents. */
-    uint64_t    u64BlockOffset;
-    /** Number of blocks the extent represents. */
-    uint32_t    u32Blocks;
-    /** First block in the image where the data is stored. */
-    uint64_t    u64BlockAddr;
-} VciCacheExtent, *PVciCacheExtent;
+    /** Line number of the virtual disk plus one, 0 if the line is free. */
+    uint64_t    u64Tag;
+    /** Bitmap of sectors holding valid data. */
+    uint64_t    u64BmValid;
+    /** Bitmap of sectors holding data not written back to the image yet. */
+    uint64_t    u64BmDirty;
+    /** Reserved, must be 0. */
+    uint64_t    u64Reserved;
+} VciLineEnt, *PVciLineEnt;
 #pragma pack()
-AssertCompileSize(VciCacheExtent, 38);
+AssertCompileSize(VciLineEnt, 32);
 
-/**
- * On disk representation of an internal node.
- *
- * All entries a stored in little endian order.
- */
-#pragma pack(1)
-typedef struct VciTreeNodeInternal
-{
-    /** First block of cached data the internal node represents. */
-    uint64_t    u64BlockOffset;
-    /** Number of blocks the internal node represents. */
-    uint32_t    u32Blocks;
-    /** Block address in the image where the next node in the tree is stored. */
-    uint64_t    u64ChildAddr;
-} VciTreeNodeInternal, *PVciTreeNodeInternal;
-#pragma pack()
-AssertCompileSize(VciTreeNodeInternal, 20);
+/** Size of a metadata log page. */
+#define VCI_LOG_PAGE_SIZE          _4K
 
 /**
- * On-disk representation of a node in the B+-Tree.
+ * On disk representation of a metadata log entry.
  *
  * All entries a stored in little endian order.
  */
 #pragma pack(1)
-typedef struct VciTreeNode
+typedef struct VciLogEnt
 {
-    /** Type of the node (root, internal, leaf). */
-    uint8_t     u8Type;
-    /** Data in the node. */
-    uint8_t     au8Data[4095];
-} VciTreeNode, *PVciTreeNode;
+    /** Index of the line in the line table. */
+    uint32_t    u32Line;
+    /** Reserved, must be 0. */
+    uint32_t    u32Reserved;
+    /** New tag of the line. */
+    uint64_t    u64Tag;
+    /** New valid bitmap of the line. */
+    uint64_t    u64BmValid;
+    /** New dirty bitmap of the line. */
+    uint64_t    u64BmDirty;
+} VciLogEnt, *PVciLogEnt;
 #pragma pack()
-AssertCompileSize(VciTreeNode, 8 * VCI_BLOCK_SIZE);
-
-/** Node type: Internal node containing links to other nodes (VciTreeNodeInternal). */
-#define VCI_TREE_NODE_TYPE_INTERNAL UINT8_C(0x01)
-/** Node type: Leaf of the tree (VciCacheExtent). */
-#define VCI_TREE_NODE_TYPE_LEAF     UINT8_C(0x02)
-
-/** Number of cache extents described by one node. */
-#define VCI_TREE_EXTENTS_PER_NODE        ((sizeof(VciTreeNode)-1) / sizeof(VciCacheExtent))
-/** Number of internal nodes managed by one tree node. */
-#define VCI_TREE_INTERNAL_NODES_PER_NODE ((sizeof(VciTreeNode)-1) / sizeof(VciTreeNodeInternal))
+AssertCompileSize(VciLogEnt, 32);
 
 /**
- * VCI block bitmap header.
+ * On disk representation of a metadata log page.
  *
  * All entries a stored in little endian order.
  */
 #pragma pack(1)
-typedef struct VciBlkMap
+typedef struct VciLogPage
 {
-    /** Magic of the block bitmap. */
-    uint32_t     u32Magic;
-    /** Version of the block bitmap. */
-    uint32_t     u32Version;
-    /** Number of blocks this block map manages. */
-    uint64_t     cBlocks;
-    /** Number of free blocks. */
-    uint64_t     cBlocksFree;
-    /** Number of blocks allocated for metadata. */
-    uint64_t     cBlocksAllocMeta;
-    /** Number of blocks allocated for actual cached data. */
-    uint64_t     cBlocksAllocData;
-    /** Reserved for future use. */
-    uint8_t      au8Reserved[472];
-} VciBlkMap, *PVciBlkMap;
+    /** Magic identifying a log page. */
+    uint32_t    u32Magic;
+    /** CRC32 of the page with this field set to 0. */
+    uint32_t    u32Crc;
+    /** Sequence number of the page. */
+    uint64_t    u64Seq;
+    /** Number of valid entries. */
+    uint32_t    cEntries;
+    /** Reserved, must be 0. */
+    uint32_t    u32Reserved;
+    /** The entries. */
+    VciLogEnt   aEntries[(VCI_LOG_PAGE_SIZE - 24) / sizeof(VciLogEnt)];
+    /** Padding to the page size. */
+    uint8_t     abPadding[(VCI_LOG_PAGE_SIZE - 24) % sizeof(VciLogEnt)];
+} VciLogPage, *PVciLogPage;
 #pragma pack()
-AssertCompileSize(VciBlkMap, VCI_BLOCK_SIZE);
-
-/** The magic which identifies a block map. */
-#define VCI_BLKMAP_MAGIC   UINT32_C(0x4b4c4256) /* KLBV */
-/** Current version. */
-#define VCI_BLKMAP_VERSION UINT32_C(0x00000001)
+AssertCompileSize(VciLogPage, VCI_LOG_PAGE_SIZE);
 
-/** Block bitmap entry */
-typedef uint8_t VciBlkMapEnt;
+/** The magic which identifies a log page. */
+#define VCI_LOG_PAGE_MAGIC         UINT32_C(0x4c494356) /* VCIL */
+/** Number of entries in a log page. */
+#define VCI_LOG_ENTRIES_PER_PAGE   RT_ELEMENTS(((VciLogPage *)0)->aEntries)
+/** Minimum number of log pages. */
+#define VCI_LOG_PAGES_MIN          256
+/** Number of log pages written with one I/O request. */
+#define VCI_LOG_PAGES_PER_WRITE    16
 
 
 /*********************************************************************************************************************************
@@ -219,128 +247,32 @@ typedef uint8_t VciBlkMapEnt;
 *********************************************************************************************************************************/
 
 /**
- * Block range descriptor.
+ * A cache line - in memory structure.
  */
-typedef struct VCIBLKRANGEDESC
+typedef struct VCILINE
 {
-    /** Previous entry in the list. */
-    struct VCIBLKRANGEDESC    *pPrev;
-    /** Next entry in the list. */
-    struct VCIBLKRANGEDESC    *pNext;
-    /** Start address of the range. */
-    uint64_t                   offAddrStart;
-    /** Number of blocks in the range. */
-    uint64_t                   cBlocks;
-    /** Flag whether the range is free or allocated. */
-    bool                       fFree;
-} VCIBLKRANGEDESC, *PVCIBLKRANGEDESC;
-
-/**
- * Block map for the cache image - in memory structure.
- */
-typedef struct VCIBLKMAP
-{
-    /** Number of blocks the map manages. */
-    uint64_t     cBlocks;
-    /** Number of blocks allocated for metadata. */
-    uint64_t     cBlocksAllocMeta;
-    /** Number of blocks allocated for actual cached data. */
-    uint64_t     cBlocksAllocData;
-    /** Number of free blocks. */
-    uint64_t     cBlocksFree;
-
-    /** Pointer to the head of the block range list. */
-    PVCIBLKRANGEDESC pRangesHead;
-    /** Pointer to the tail of the block range list. */
-    PVCIBLKRANGEDESC pRangesTail;
-
-} VCIBLKMAP;
-/** Pointer to a block map. */
-typedef VCIBLKMAP *PVCIBLKMAP;
-
-/**
- * B+-Tree node header.
- */
-typedef struct VCITREENODE
-{
-    /** Type of the node (VCI_TREE_NODE_TYPE_*). */
-    uint8_t             u8Type;
-    /** Block address where the node is stored. */
-    uint64_t            u64BlockAddr;
-    /** Pointer to the parent. */
-    struct VCITREENODE *pParent;
-} VCITREENODE, *PVCITREENODE;
-
-/**
- * B+-Tree node pointer.
- */
-typedef struct VCITREENODEPTR
-{
-    /** Flag whether the node is in memory or still on the disk. */
-    bool         fInMemory;
-    /** Type dependent data. */
-    union
-    {
-        /** Pointer to a in memory node. */
-        PVCITREENODE pNode;
-        /** Start block address of the node. */
-        uint64_t     offAddrBlockNode;
-    } u;
-} VCITREENODEPTR, *PVCITREENODEPTR;
-
-/**
- * Internal node.
- */
-typedef struct VCINODEINTERNAL
-{
-    /** First block of cached data the internal node represents. */
-    uint64_t       u64BlockOffset;
-    /** Number of blocks the internal node represents. */
-    uint32_t       u32Blocks;
-    /** Pointer to the child node. */
-    VCITREENODEPTR PtrChild;
-} VCINODEINTERNAL, *PVCINODEINTERNAL;
-
-/**
- * A in memory internal B+-tree node.
- */
-typedef struct VCITREENODEINT
-{
-    /** Node core. */
-    VCITREENODE     Core;
-    /** Number of used nodes. */
-    unsigned        cUsedNodes;
-    /** Array of internal nodes. */
-    VCINODEINTERNAL aIntNodes[VCI_TREE_INTERNAL_NODES_PER_NODE];
-} VCITREENODEINT, *PVCITREENODEINT;
-
-/**
- * A in memory cache extent.
- */
-typedef struct VCICACHEEXTENT
-{
-    /** First block of cached data the extent represents. */
-    uint64_t    u64BlockOffset;
-    /** Number of blocks the extent represents. */
-    uint32_t    u32Blocks;
-    /** First block in the image where the data is stored. */
-    uint64_t    u64BlockAddr;
-} VCICACHEEXTENT, *PVCICACHEEXTENT;
-
-/**
- * A in memory leaf B+-tree node.
- */
-typedef struct VCITREENODELEAF
-{
-    /** Node core. */
-    VCITREENODE             Core;
-    /** Next leaf node in the list. */
-    struct VCITREENODELEAF *pNext;
-    /** Number of used nodes. */
-    unsigned                cUsedNodes;
-    /** The extents in the node. */
-    VCICACHEEXTENT          aExtents[VCI_TREE_EXTENTS_PER_NODE];
-} VCITREENODELEAF, *PVCITREENODELEAF;
+    /** Line number of the virtual disk plus one, 0 if the line is free. */
+    uint64_t    uTag;
+    /** Bitmap of sectors holding valid data. */
+    uint64_t    bmValid;
+    /** Bitmap of sectors holding data not written back to the image yet. */
+    uint64_t    bmDirty;
+    /** Generation, incremented whenever dirty data is modified. */
+    uint32_t    uGen;
+    /** Tick of the last access for replacing lines in a set. */
+    uint32_t    uLastUse;
+    /** Number of reads accessing the data without holding the lock. */
+    uint16_t    cPins;
+    /** Flags, combination of VCILINE_F_*. */
+    uint16_t    fFlags;
+} VCILINE;
+/** Pointer to a cache line. */
+typedef VCILINE *PVCILINE;
+
+/** The line was changed since the last commit and is on the modified list. */
+#define VCILINE_F_MODIFIED         RT_BIT(0)
+/** The line was dropped and can't be reused before the next commit. */
+#define VCILINE_F_PENDING_FREE     RT_BIT(1)
 
 /**
  * VCI image data structure.
@@ -368,23 +300,66 @@ typedef struct VCICACHE
     /** Total size of the image. */
     uint64_t          cbSize;
 
-    /** Offset of the B+-Tree in the image in bytes. */
-    uint64_t          offTreeRoot;
-    /** Pointer to the root node of the B+-Tree. */
-    PVCITREENODE      pRoot;
-    /** Offset to the block allocation bitmap in bytes. */
-    uint64_t          offBlksBitmap;
-    /** Block map. */
-    PVCIBLKMAP        pBlkMap;
+    /** Critical section protecting the metadata, the VD layer accesses the cache
+     * from the I/O path and from its write back thread. */
+    RTCRITSECT        CritSect;
+    /** The header as read from the image, host endianess. */
+    VciHdr            Hdr;
+    /** Flag whether the header needs to be written on the next commit. */
+    bool              fHdrDirty;
+
+    /** Number of cache lines. */
+    uint32_t          cLines;
+    /** Number of sets. */
+    uint32_t          cSets;
+    /** Offset of the data area in bytes. */
+    uint64_t          offData;
+    /** The cache lines. */
+    PVCILINE          paLines;
+    /** Bitmap of lines containing dirty data. */
+    uint64_t         *pbmLinesDirty;
+    /** Per set value of uSeqUncached when the set was last written around the cache. */
+    uint64_t         *pauSetSeqUncached;
+    /** Sequence counter incremented for every write which didn't update the cache. */
+    uint64_t          uSeqUncached;
+    /** Tick counter for the line replacement. */
+    uint32_t          uTick;
+    /** Number of dirty sectors. */
+    uint64_t          cSectorsDirty;
+
+    /** Indexes of the lines changed since the last commit. */
+    uint32_t         *paidxModified;
+    /** Number of entries in paidxModified. */
+    uint32_t          cModified;
+
+    /** Offsets of the two line table copies in bytes. */
+    uint64_t          aoffLineTbl[2];
+    /** Size of one line table copy in bytes. */
+    uint64_t          cbLineTbl;
+    /** Offset of the metadata log in bytes. */
+    uint64_t          offLog;
+    /** Number of pages in the metadata log. */
+    uint32_t          cLogPages;
+    /** Sequence number of the next log page to write. */
+    uint64_t          uLogSeqNext;
+    /** Buffer for the metadata log and line table I/O. */
+    uint8_t          *pbMetaBuf;
+    /** Bounce buffer for data written under the lock, one line big. */
+    uint8_t          *pbBounce;
+
+    /** Statistics: read hits in bytes. */
+    uint64_t          cbHits;
+    /** Statistics: read misses in bytes. */
+    uint64_t          cbMisses;
+    /** Statistics: number of commits. */
+    uint64_t          cCommits;
+    /** Statistics: number of checkpoints. */
+    uint64_t          cCheckpoints;
 } VCICACHE, *PVCICACHE;
 
-/** No block free in bitmap error code. */
-#define VERR_VCI_NO_BLOCKS_FREE (-65536)
-
-/** Flags for the block map allocator. */
-#define VCIBLKMAP_ALLOC_DATA 0
-#define VCIBLKMAP_ALLOC_META RT_BIT(0)
-#define VCIBLKMAP_ALLOC_MASK 0x1
+/** Size of the metadata buffer. */
+#define VCI_META_BUF_SIZE          (VCI_LOG_PAGES_PER_WRITE * VCI_LOG_PAGE_SIZE)
+AssertCompile(VCI_META_BUF_SIZE % sizeof(VciLineEnt) == 0);
 
 
 /*********************************************************************************************************************************
@@ -420,799 +395,674 @@ static int vciFlushImage(PVCICACHE pCache)
 }
 
 /**
- * Internal. Free all allocated space for representing an image except pCache,
- * and optionally delete the image from disk.
+ * Converts the header to little endian, computes the checksum and writes it
+ * to the image.
+ *
+ * @returns VBox status code.
+ * @param   pIfIo           The I/O interface.
+ * @param   pStorage        The storage handle.
+ * @param   pHdr            The header in host endianess.
  */
-static int vciFreeImage(PVCICACHE pCache, bool fDelete)
+static int vciHdrWrite(PVDINTERFACEIOINT pIfIo, PVDIOSTORAGE pStorage, PVciHdr pHdr)
 {
-    int rc = VINF_SUCCESS;
-
-    /* Freeing a never allocated image (e.g. because the open failed) is
-     * not signalled as an error. After all nothing bad happens. */
-    if (pCache)
-    {
-        if (pCache->pStorage)
-        {
-            /* No point updating the file that is deleted anyway. */
-            if (!fDelete)
-                vciFlushImage(pCache);
-
-            vdIfIoIntFileClose(pCache->pIfIo, pCache->pStorage);
-            pCache->pStorage = NULL;
-        }
-
-        if (fDelete && pCache->pszFilename)
-            vdIfIoIntFileDelete(pCache->pIfIo, pCache->pszFilename);
-    }
+    VciHdr Hdr;
 
-    LogFlowFunc(("returns %Rrc\n", rc));
-    return rc;
+    memset(&Hdr, 0, sizeof(Hdr));
+    Hdr.u32Signature     = RT_H2LE_U32(pHdr->u32Signature);
+    Hdr.u32Version       = RT_H2LE_U32(pHdr->u32Version);
+    Hdr.cBlocksCache     = RT_H2LE_U64(pHdr->cBlocksCache);
+    Hdr.fUncleanShutdown = pHdr->fUncleanShutdown;
+    Hdr.u32CacheType     = RT_H2LE_U32(pHdr->u32CacheType);
+    Hdr.cbLine           = RT_H2LE_U32(pHdr->cbLine);
+    Hdr.cWays            = RT_H2LE_U32(pHdr->cWays);
+    Hdr.cLines           = RT_H2LE_U32(pHdr->cLines);
+    Hdr.aoffLineTbl[0]   = RT_H2LE_U64(pHdr->aoffLineTbl[0]);
+    Hdr.aoffLineTbl[1]   = RT_H2LE_U64(pHdr->aoffLineTbl[1]);
+    Hdr.idxLineTbl       = pHdr->idxLineTbl;
+    Hdr.offLog           = RT_H2LE_U64(pHdr->offLog);
+    Hdr.cLogBlocks       = RT_H2LE_U32(pHdr->cLogBlocks);
+    Hdr.u64LogSeqBase    = RT_H2LE_U64(pHdr->u64LogSeqBase);
+    Hdr.offData          = RT_H2LE_U64(pHdr->offData);
+    Hdr.uuidImage        = pHdr->uuidImage;
+    Hdr.uuidModification = pHdr->uuidModification;
+    Hdr.u32Crc           = RT_H2LE_U32(RTCrc32(&Hdr, sizeof(Hdr)));
+
+    return vdIfIoIntFileWriteSync(pIfIo, pStorage, 0, &Hdr, sizeof(Hdr));
 }
 
 /**
- * Creates a new block map which can manage the given number of blocks.
- *
- * The size of the bitmap is aligned to the VCI block size.
+ * Reads and validates the header from the image.
  *
  * @returns VBox status code.
- * @param   cBlocks      The number of blocks the bitmap can manage.
- * @param   ppBlkMap     Where to store the pointer to the block bitmap.
- * @param   pcBlkMap     Where to store the size of the block bitmap in blocks
- *                       needed on the disk.
+ * @retval  VERR_VD_GEN_INVALID_HEADER if this is not a valid cache image.
+ * @param   pIfIo           The I/O interface.
+ * @param   pStorage        The storage handle.
+ * @param   pHdr            Where to store the header in host endianess.
  */
-static int vciBlkMapCreate(uint64_t cBlocks, PVCIBLKMAP *ppBlkMap, uint32_t *pcBlkMap)
+static int vciHdrRead(PVDINTERFACEIOINT pIfIo, PVDIOSTORAGE pStorage, PVciHdr pHdr)
 {
-    int rc = VINF_SUCCESS;
-    uint32_t cbBlkMap = RT_ALIGN_Z(cBlocks / sizeof(VciBlkMapEnt) / 8, VCI_BLOCK_SIZE);
-    PVCIBLKMAP pBlkMap = (PVCIBLKMAP)RTMemAllocZ(sizeof(VCIBLKMAP));
-    PVCIBLKRANGEDESC pFree   = (PVCIBLKRANGEDESC)RTMemAllocZ(sizeof(VCIBLKRANGEDESC));
-
-    LogFlowFunc(("cBlocks=%u ppBlkMap=%#p pcBlkMap=%#p\n", cBlocks, ppBlkMap, pcBlkMap));
-
-    if (pBlkMap && pFree)
-    {
-        pBlkMap->cBlocks          = cBlocks;
-        pBlkMap->cBlocksAllocMeta = 0;
-        pBlkMap->cBlocksAllocData = 0;
-        pBlkMap->cBlocksFree      = cBlocks;
-
-        pFree->pPrev = NULL;
-        pFree->pNext = NULL;
-        pFree->offAddrStart = 0;
-        pFree->cBlocks      = cBlocks;
-        pFree->fFree        = true;
-
-        pBlkMap->pRangesHead = pFree;
-        pBlkMap->pRangesTail = pFree;
-
-        Assert(!((cbBlkMap + sizeof(VciBlkMap)) % VCI_BLOCK_SIZE));
-        *ppBlkMap = pBlkMap;
-        *pcBlkMap = VCI_BYTE2BLOCK(cbBlkMap + sizeof(VciBlkMap));
-    }
-    else
-    {
-        if (pBlkMap)
-            RTMemFree(pBlkMap);
-        if (pFree)
-            RTMemFree(pFree);
-
-        rc = VERR_NO_MEMORY;
-    }
+    uint64_t cbFile = 0;
+    int rc = vdIfIoIntFileGetSize(pIfIo, pStorage, &cbFile);
+    if (RT_FAILURE(rc) || cbFile < sizeof(VciHdr))
+        return VERR_VD_GEN_INVALID_HEADER;
 
-    LogFlowFunc(("returns rc=%Rrc cBlkMap=%u\n", rc, *pcBlkMap));
-    return rc;
+    rc = vdIfIoIntFileReadSync(pIfIo, pStorage, 0, pHdr, sizeof(*pHdr));
+    if (RT_FAILURE(rc))
+        return VERR_VD_GEN_INVALID_HEADER;
+
+    uint32_t const u32Crc = RT_LE2H_U32(pHdr->u32Crc);
+    pHdr->u32Crc = 0;
+    if (   RT_LE2H_U32(pHdr->u32Signature) != VCI_HDR_SIGNATURE
+        || RT_LE2H_U32(pHdr->u32Version) != VCI_HDR_VERSION
+        || RTCrc32(pHdr, sizeof(*pHdr)) != u32Crc)
+        return VERR_VD_GEN_INVALID_HEADER;
+
+    pHdr->u32Signature   = RT_LE2H_U32(pHdr->u32Signature);
+    pHdr->u32Version     = RT_LE2H_U32(pHdr->u32Version);
+    pHdr->cBlocksCache   = RT_LE2H_U64(pHdr->cBlocksCache);
+    pHdr->u32CacheType   = RT_LE2H_U32(pHdr->u32CacheType);
+    pHdr->cbLine         = RT_LE2H_U32(pHdr->cbLine);
+    pHdr->cWays          = RT_LE2H_U32(pHdr->cWays);
+    pHdr->cLines         = RT_LE2H_U32(pHdr->cLines);
+    pHdr->aoffLineTbl[0] = RT_LE2H_U64(pHdr->aoffLineTbl[0]);
+    pHdr->aoffLineTbl[1] = RT_LE2H_U64(pHdr->aoffLineTbl[1]);
+    pHdr->offLog         = RT_LE2H_U64(pHdr->offLog);
+    pHdr->cLogBlocks     = RT_LE2H_U32(pHdr->cLogBlocks);
+    pHdr->u64LogSeqBase  = RT_LE2H_U64(pHdr->u64LogSeqBase);
+    pHdr->offData        = RT_LE2H_U64(pHdr->offData);
+
+    /* Sanity check the layout. */
+    uint64_t const cbLineTbl = RT_ALIGN_64((uint64_t)pHdr->cLines * sizeof(VciLineEnt), VCI_AREA_ALIGNMENT);
+    if (   pHdr->cbLine != VCI_LINE_SIZE
+        || pHdr->cWays != VCI_WAYS
+        || !pHdr->cLines
+        || pHdr->cLines % VCI_WAYS
+        || pHdr->idxLineTbl > 1
+        || VCI_BLOCK2BYTE(pHdr->aoffLineTbl[0]) < sizeof(VciHdr)
+        || VCI_BLOCK2BYTE(pHdr->aoffLineTbl[1]) < VCI_BLOCK2BYTE(pHdr->aoffLineTbl[0]) + cbLineTbl
+        || VCI_BLOCK2BYTE(pHdr->offLog) < VCI_BLOCK2BYTE(pHdr->aoffLineTbl[1]) + cbLineTbl
+        || VCI_BLOCK2BYTE(pHdr->cLogBlocks) < VCI_LOG_PAGE_SIZE
+        || VCI_BLOCK2BYTE(pHdr->offData) < VCI_BLOCK2BYTE(pHdr->offLog) + VCI_BLOCK2BYTE(pHdr->cLogBlocks)
+        || VCI_BLOCK2BYTE(pHdr->offData) + (uint64_t)pHdr->cLines * VCI_LINE_SIZE > VCI_BLOCK2BYTE(pHdr->cBlocksCache))
+        return VERR_VD_GEN_INVALID_HEADER;
+
+    return VINF_SUCCESS;
 }
 
-#if 0 /** @todo unsued vciBlkMapDestroy */
 /**
- * Frees a block map.
+ * Computes the layout of a new cache image of the given size.
  *
- * @param   pBlkMap         The block bitmap to destroy.
+ * @returns VBox status code.
+ * @retval  VERR_VD_INVALID_SIZE if the size is too small.
+ * @param   cbSize          Maximum size of the cache image.
+ * @param   pHdr            The header to fill in.
  */
-static void vciBlkMapDestroy(PVCIBLKMAP pBlkMap)
+static int vciLayoutCompute(uint64_t cbSize, PVciHdr pHdr)
 {
-    LogFlowFunc(("pBlkMap=%#p\n", pBlkMap));
-
-    PVCIBLKRANGEDESC pRangeCur = pBlkMap->pRangesHead;
-
-    while (pRangeCur)
+    uint64_t const cbLineMeta = 2 * sizeof(VciLineEnt) + VCI_LOG_PAGE_SIZE / VCI_LOG_ENTRIES_PER_PAGE;
+    uint64_t const cbFixed    = 4 * VCI_AREA_ALIGNMENT + VCI_LOG_PAGES_MIN * VCI_LOG_PAGE_SIZE;
+    if (cbSize < cbFixed + VCI_WAYS * (VCI_LINE_SIZE + cbLineMeta))
+        return VERR_VD_INVALID_SIZE;
+
+    uint64_t cLines = (cbSize - cbFixed) / (VCI_LINE_SIZE + cbLineMeta);
+    cLines = RT_MIN(cLines, UINT32_MAX) & ~(uint64_t)(VCI_WAYS - 1);
+    for (;;)
     {
-        PVCIBLKRANGEDESC pTmp = pRangeCur;
-
-        RTMemFree(pTmp);
+        uint64_t const cbLineTbl = RT_ALIGN_64(cLines * sizeof(VciLineEnt), VCI_AREA_ALIGNMENT);
+        uint64_t const cLogPages = RT_MAX(VCI_LOG_PAGES_MIN, cLines / VCI_LOG_ENTRIES_PER_PAGE);
+        uint64_t const cbLog     = RT_ALIGN_64(cLogPages * VCI_LOG_PAGE_SIZE, VCI_AREA_ALIGNMENT);
+        uint64_t const offTbl0   = VCI_AREA_ALIGNMENT;
+        uint64_t const offTbl1   = offTbl0 + cbLineTbl;
+        uint64_t const offLog    = offTbl1 + cbLineTbl;
+        uint64_t const offData   = offLog + cbLog;
+
+        if (offData + cLines * VCI_LINE_SIZE <= cbSize)
+        {
+            pHdr->u32Signature   = VCI_HDR_SIGNATURE;
+            pHdr->u32Version     = VCI_HDR_VERSION;
+            pHdr->cBlocksCache   = VCI_BYTE2BLOCK(offData + cLines * VCI_LINE_SIZE);
+            pHdr->cbLine         = VCI_LINE_SIZE;
+            pHdr->cWays          = VCI_WAYS;
+            pHdr->cLines         = (uint32_t)cLines;
+            pHdr->aoffLineTbl[0] = VCI_BYTE2BLOCK(offTbl0);
+            pHdr->aoffLineTbl[1] = VCI_BYTE2BLOCK(offTbl1);
+            pHdr->idxLineTbl     = 0;
+            pHdr->offLog         = VCI_BYTE2BLOCK(offLog);
+            pHdr->cLogBlocks     = (uint32_t)VCI_BYTE2BLOCK(cbLog);
+            pHdr->u64LogSeqBase  = 1;
+            pHdr->offData        = VCI_BYTE2BLOCK(offData);
+            return VINF_SUCCESS;
+        }
 
-        pRangeCur = pRangeCur->pNext;
+        if (cLines <= VCI_WAYS)
+            return VERR_VD_INVALID_SIZE;
+        cLines -= VCI_WAYS;
     }
-
-    RTMemFree(pBlkMap);
-
-    LogFlowFunc(("returns\n"));
 }
-#endif
 
 /**
- * Loads the block map from the specified medium and creates all necessary
- * in memory structures to manage used and free blocks.
- *
- * @returns VBox status code.
- * @param   pStorage        Storage handle to read the block bitmap from.
- * @param   offBlkMap       Start of the block bitmap in blocks.
- * @param   cBlkMap         Size of the block bitmap on the disk in blocks.
- * @param   ppBlkMap        Where to store the block bitmap on success.
+ * Returns the set index for the given line of the virtual disk.
  */
-static int vciBlkMapLoad(PVCICACHE pStorage, uint64_t offBlkMap, uint32_t cBlkMap, PVCIBLKMAP *ppBlkMap)
+DECLINLINE(uint32_t) vciLineToSet(PVCICACHE pCache, uint64_t uLine)
 {
-    int rc = VINF_SUCCESS;
-    VciBlkMap BlkMap;
-
-    LogFlowFunc(("pStorage=%#p offBlkMap=%llu cBlkMap=%u ppBlkMap=%#p\n",
-                 pStorage, offBlkMap, cBlkMap, ppBlkMap));
+    return (uint32_t)(uLine % pCache->cSets);
+}
 
-    if (cBlkMap >= VCI_BYTE2BLOCK(sizeof(VciBlkMap)))
+/**
+ * Adds the given line to the list of lines to commit.
+ */
+DECLINLINE(void) vciLineModified(PVCICACHE pCache, uint32_t idxLine)
+{
+    PVCILINE pLine = &pCache->paLines[idxLine];
+    if (!(pLine->fFlags & VCILINE_F_MODIFIED))
     {
-        cBlkMap -= VCI_BYTE2BLOCK(sizeof(VciBlkMap));
-
-        rc = vdIfIoIntFileReadSync(pStorage->pIfIo, pStorage->pStorage, offBlkMap,
-                                   &BlkMap, VCI_BYTE2BLOCK(sizeof(VciBlkMap)));
-        if (RT_SUCCESS(rc))
-        {
-            offBlkMap += VCI_BYTE2BLOCK(sizeof(VciBlkMap));
-
-            BlkMap.u32Magic         = RT_LE2H_U32(BlkMap.u32Magic);
-            BlkMap.u32Version       = RT_LE2H_U32(BlkMap.u32Version);
-            BlkMap.cBlocks          = RT_LE2H_U32(BlkMap.cBlocks);
-            BlkMap.cBlocksFree      = RT_LE2H_U32(BlkMap.cBlocksFree);
-            BlkMap.cBlocksAllocMeta = RT_LE2H_U32(BlkMap.cBlocksAllocMeta);
-            BlkMap.cBlocksAllocData = RT_LE2H_U32(BlkMap.cBlocksAllocData);
-
-            if (   BlkMap.u32Magic == VCI_BLKMAP_MAGIC
-                && BlkMap.u32Version == VCI_BLKMAP_VERSION
-                && BlkMap.cBlocks == BlkMap.cBlocksFree + BlkMap.cBlocksAllocMeta + BlkMap.cBlocksAllocData
-                && VCI_BYTE2BLOCK(BlkMap.cBlocks / 8) == cBlkMap)
-            {
-                PVCIBLKMAP pBlkMap = (PVCIBLKMAP)RTMemAllocZ(sizeof(VCIBLKMAP));
-                if (pBlkMap)
-                {
-                    pBlkMap->cBlocks          = BlkMap.cBlocks;
-                    pBlkMap->cBlocksFree      = BlkMap.cBlocksFree;
-                    pBlkMap->cBlocksAllocMeta = BlkMap.cBlocksAllocMeta;
-                    pBlkMap->cBlocksAllocData = BlkMap.cBlocksAllocData;
-
-                    /* Load the bitmap and construct the range list. */
-                    PVCIBLKRANGEDESC pRangeCur = (PVCIBLKRANGEDESC)RTMemAllocZ(sizeof(VCIBLKRANGEDESC));
-
-                    if (pRangeCur)
-                    {
-                        uint8_t abBitmapBuffer[16 * _1K];
-                        uint32_t cBlocksRead = 0;
-                        uint64_t cBlocksLeft = VCI_BYTE2BLOCK(pBlkMap->cBlocks / 8);
-
-                        cBlocksRead = RT_MIN(VCI_BYTE2BLOCK(sizeof(abBitmapBuffer)), cBlocksLeft);
-                        rc = vdIfIoIntFileReadSync(pStorage->pIfIo, pStorage->pStorage,
-                                                   offBlkMap, abBitmapBuffer,
-                                                   cBlocksRead);
-
-                        if (RT_SUCCESS(rc))
-                        {
-                            pRangeCur->fFree        = !(abBitmapBuffer[0] & 0x01);
-                            pRangeCur->offAddrStart = 0;
-                            pRangeCur->cBlocks      = 0;
-                            pRangeCur->pNext        = NULL;
-                            pRangeCur->pPrev        = NULL;
-                            pBlkMap->pRangesHead = pRangeCur;
-                            pBlkMap->pRangesTail = pRangeCur;
-                        }
-                        else
-                            RTMemFree(pRangeCur);
-
-                        while (   RT_SUCCESS(rc)
-                               && cBlocksLeft)
-                        {
-                            int iBit = 0;
-                            uint32_t cBits = VCI_BLOCK2BYTE(cBlocksRead) * 8;
-                            uint32_t iBitPrev = 0xffffffff;
-
-                            while (cBits)
-                            {
-                                if (pRangeCur->fFree)
-                                {
-                                    /* Check for the first set bit. */
-                                    iBit = ASMBitNextSet(abBitmapBuffer, cBits, iBitPrev);
-                                }
-                                else
-                                {
-                                    /* Check for the first free bit. */
-                                    iBit = ASMBitNextClear(abBitmapBuffer, cBits, iBitPrev);
-                                }
-
-                                if (iBit == -1)
-                                {
-                                    /* No change. */
-                                    pRangeCur->cBlocks += cBits;
-                                    cBits = 0;
-                                }
-                                else
-                                {
-                                    Assert((uint32_t)iBit < cBits);
-                                    pRangeCur->cBlocks += iBit;
-
-                                    /* Create a new range descriptor. */
-                                    PVCIBLKRANGEDESC pRangeNew = (PVCIBLKRANGEDESC)RTMemAllocZ(sizeof(VCIBLKRANGEDESC));
-                                    if (!pRangeNew)
-                                    {
-                                        rc = VERR_NO_MEMORY;
-                                        break;
-                                    }
-
-                                    pRangeNew->fFree = !pRangeCur->fFree;
-                                    pRangeNew->offAddrStart = pRangeCur->offAddrStart + pRangeCur->cBlocks;
-                                    pRangeNew->cBlocks = 0;
-                                    pRangeNew->pPrev = pRangeCur;
-                                    pRangeCur->pNext = pRangeNew;
-                                    pBlkMap->pRangesTail = pRangeNew;
-                                    pRangeCur = pRangeNew;
-                                    cBits -= iBit;
-                                    iBitPrev = iBit;
-                                }
-                            }
-
-                            cBlocksLeft -= cBlocksRead;
-                            offBlkMap   += cBlocksRead;
-
-                            if (   RT_SUCCESS(rc)
-                                && cBlocksLeft)
-                            {
-                                /* Read next chunk. */
-                                cBlocksRead = RT_MIN(VCI_BYTE2BLOCK(sizeof(abBitmapBuffer)), cBlocksLeft);
-                                rc = vdIfIoIntFileReadSync(pStorage->pIfIo, pStorage->pStorage,
-                                                           offBlkMap, abBitmapBuffer, cBlocksRead);
-                            }
-                        }
-                    }
-                    else
-                        rc = VERR_NO_MEMORY;
+        Assert(pCache->cModified < pCache->cLines);
+        pLine->fFlags |= VCILINE_F_MODIFIED;
+        pCache->paidxModified[pCache->cModified++] = idxLine;
+    }
+}
 
-                    if (RT_SUCCESS(rc))
-                    {
-                        *ppBlkMap = pBlkMap;
-                        LogFlowFunc(("return success\n"));
-                        return VINF_SUCCESS;
-                    }
+/**
+ * Returns the number of bits set in the given bitmap.
+ */
+DECLINLINE(uint32_t) vciBitCount64(uint64_t u64)
+{
+    u64 = u64 - ((u64 >> 1) & UINT64_C(0x5555555555555555));
+    u64 = (u64 & UINT64_C(0x3333333333333333)) + ((u64 >> 2) & UINT64_C(0x3333333333333333));
+    u64 = (u64 + (u64 >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+    return (uint32_t)((u64 * UINT64_C(0x0101010101010101)) >> 56);
+}
 
-                    RTMemFree(pBlkMap);
-                }
-                else
-                    rc = VERR_NO_MEMORY;
-            }
-            else
-                rc = VERR_VD_GEN_INVALID_HEADER;
-        }
-        else
-            rc = VERR_VD_GEN_INVALID_HEADER;
-    }
+/**
+ * Updates the dirty accounting after the dirty bitmap of a line changed.
+ */
+DECLINLINE(void) vciLineDirtyUpdate(PVCICACHE pCache, uint32_t idxLine, uint64_t bmDirtyOld)
+{
+    PVCILINE pLine = &pCache->paLines[idxLine];
+    pCache->cSectorsDirty -= vciBitCount64(bmDirtyOld);
+    pCache->cSectorsDirty += vciBitCount64(pLine->bmDirty);
+    if (pLine->bmDirty)
+        ASMBitSet(pCache->pbmLinesDirty, (int32_t)idxLine);
     else
-        rc = VERR_VD_GEN_INVALID_HEADER;
+        ASMBitClear(pCache->pbmLinesDirty, (int32_t)idxLine);
+}
 
-    LogFlowFunc(("returns rc=%Rrc\n", rc));
-    return rc;
+/**
+ * Returns the bitmap of sectors covered by the given sector range of a line.
+ */
+DECLINLINE(uint64_t) vciSectorMask(uint32_t iSector, uint32_t cSectors)
+{
+    Assert(iSector + cSectors <= VCI_LINE_SECTORS && cSectors);
+    return   (cSectors == VCI_LINE_SECTORS ? UINT64_MAX : (RT_BIT_64(cSectors) - 1))
+           << iSector;
+}
+
+/**
+ * Returns the number of consecutive sectors starting at the given one which
+ * have the given state in the bitmap.
+ */
+DECLINLINE(uint32_t) vciSectorRun(uint64_t bm, uint32_t iSector, uint32_t cSectorsMax, bool fSet)
+{
+    uint32_t cSectors = 0;
+    while (   cSectors < cSectorsMax
+           && RT_BOOL(bm & RT_BIT_64(iSector + cSectors)) == fSet)
+        cSectors++;
+    return cSectors;
 }
 
 /**
- * Saves the block map in the cache image. All necessary on disk structures
- * are written.
+ * Looks up the line caching the given line of the virtual disk.
  *
- * @returns VBox status code.
- * @param   pBlkMap         The block bitmap to save.
- * @param   pStorage        Where the block bitmap should be written to.
- * @param   offBlkMap       Start of the block bitmap in blocks.
- * @param   cBlkMap         Size of the block bitmap on the disk in blocks.
+ * @returns Index of the line or UINT32_MAX if not cached.
+ * @param   pCache          The cache image instance.
+ * @param   uLine           Line number of the virtual disk.
  */
-static int vciBlkMapSave(PVCIBLKMAP pBlkMap, PVCICACHE pStorage, uint64_t offBlkMap, uint32_t cBlkMap)
+static uint32_t vciLineLookup(PVCICACHE pCache, uint64_t uLine)
 {
-    int rc = VINF_SUCCESS;
-    VciBlkMap BlkMap;
+    uint32_t const idxFirst = vciLineToSet(pCache, uLine) * VCI_WAYS;
+    for (uint32_t idxLine = idxFirst; idxLine < idxFirst + VCI_WAYS; idxLine++)
+        if (pCache->paLines[idxLine].uTag == uLine + 1)
+            return idxLine;
+    return UINT32_MAX;
+}
 
-    LogFlowFunc(("pBlkMap=%#p pStorage=%#p offBlkMap=%llu cBlkMap=%u\n",
-                 pBlkMap, pStorage, offBlkMap, cBlkMap));
+/**
+ * Allocates a line for the given line of the virtual disk.
+ *
+ * If the set is full the least recently used clean line is dropped, but it
+ * can't be reused before the next commit, so the allocation fails for now.
+ *
+ * @returns Index of the line or UINT32_MAX if there is no free line.
+ * @param   pCache          The cache image instance.
+ * @param   uLine           Line number of the virtual disk.
+ */
+static uint32_t vciLineAlloc(PVCICACHE pCache, uint64_t uLine)
+{
+    uint32_t const idxFirst = vciLineToSet(pCache, uLine) * VCI_WAYS;
+    uint32_t idxVictim = UINT32_MAX;
 
-    /* Make sure the number of blocks allocated for us match our expectations. */
-    if (VCI_BYTE2BLOCK(pBlkMap->cBlocks / 8) + VCI_BYTE2BLOCK(sizeof(VciBlkMap)) == cBlkMap)
+    for (uint32_t idxLine = idxFirst; idxLine < idxFirst + VCI_WAYS; idxLine++)
     {
-        /* Setup the header */
-        memset(&BlkMap, 0, sizeof(VciBlkMap));
-
-        BlkMap.u32Magic         = RT_H2LE_U32(VCI_BLKMAP_MAGIC);
-        BlkMap.u32Version       = RT_H2LE_U32(VCI_BLKMAP_VERSION);
-        BlkMap.cBlocks          = RT_H2LE_U32(pBlkMap->cBlocks);
-        BlkMap.cBlocksFree      = RT_H2LE_U32(pBlkMap->cBlocksFree);
-        BlkMap.cBlocksAllocMeta = RT_H2LE_U32(pBlkMap->cBlocksAllocMeta);
-        BlkMap.cBlocksAllocData = RT_H2LE_U32(pBlkMap->cBlocksAllocData);
-
-        rc = vdIfIoIntFileWriteSync(pStorage->pIfIo, pStorage->pStorage, offBlkMap,
-                                    &BlkMap, VCI_BYTE2BLOCK(sizeof(VciBlkMap)));
-        if (RT_SUCCESS(rc))
+        PVCILINE pLine = &pCache->paLines[idxLine];
+        if (   !pLine->uTag
+            && !(pLine->fFlags & VCILINE_F_PENDING_FREE))
         {
-            uint8_t abBitmapBuffer[16*_1K];
-            unsigned iBit = 0;
-            PVCIBLKRANGEDESC pCur = pBlkMap->pRangesHead;
-
-            offBlkMap += VCI_BYTE2BLOCK(sizeof(VciBlkMap));
-
-            /* Write the descriptor ranges. */
-            while (pCur)
-            {
-                uint64_t cBlocks = pCur->cBlocks;
-
-                while (cBlocks)
-                {
-                    uint64_t cBlocksMax = RT_MIN(cBlocks, sizeof(abBitmapBuffer) * 8 - iBit);
-
-                    if (pCur->fFree)
-                        ASMBitClearRange(abBitmapBuffer, iBit, iBit + cBlocksMax);
-                    else
-                        ASMBitSetRange(abBitmapBuffer, iBit, iBit + cBlocksMax);
-
-                    iBit    += cBlocksMax;
-                    cBlocks -= cBlocksMax;
-
-                    if (iBit == sizeof(abBitmapBuffer) * 8)
-                    {
-                        /* Buffer is full, write to file and reset. */
-                        rc = vdIfIoIntFileWriteSync(pStorage->pIfIo, pStorage->pStorage,
-                                                    offBlkMap, abBitmapBuffer,
-                                                    VCI_BYTE2BLOCK(sizeof(abBitmapBuffer)));
-                        if (RT_FAILURE(rc))
-                            break;
-
-                        offBlkMap += VCI_BYTE2BLOCK(sizeof(abBitmapBuffer));
-                        iBit = 0;
-                    }
-                }
-
-                pCur = pCur->pNext;
-            }
+            pLine->uTag     = uLine + 1;
+            pLine->bmValid  = 0;
+            pLine->bmDirty  = 0;
+            pLine->uLastUse = pCache->uTick++;
+            vciLineModified(pCache, idxLine);
+            return idxLine;
+        }
 
-            Assert(iBit % 8 == 0);
+        if (   pLine->uTag
+            && !pLine->bmDirty
+            && !pLine->cPins
+            && (   idxVictim == UINT32_MAX
+                || (int32_t)(pCache->paLines[idxVictim].uLastUse - pLine->uLastUse) > 0))
+            idxVictim = idxLine;
+    }
 
-            if (RT_SUCCESS(rc) && iBit)
-                rc = vdIfIoIntFileWriteSync(pStorage->pIfIo, pStorage->pStorage,
-                                            offBlkMap, abBitmapBuffer, VCI_BYTE2BLOCK(iBit / 8));
-        }
+    if (idxVictim != UINT32_MAX)
+    {
+        PVCILINE pLine = &pCache->paLines[idxVictim];
+        pLine->uTag    = 0;
+        pLine->bmValid = 0;
+        pLine->fFlags |= VCILINE_F_PENDING_FREE;
+        vciLineModified(pCache, idxVictim);
     }
-    else
-        rc = VERR_INTERNAL_ERROR; /** @todo Better error code. */
 
-    LogFlowFunc(("returns rc=%Rrc\n", rc));
-    return rc;
+    return UINT32_MAX;
 }
 
-#if 0 /* unused */
 /**
- * Finds the range block describing the given block address.
- *
- * @returns Pointer to the block range descriptor or NULL if none could be found.
- * @param   pBlkMap         The block bitmap to search on.
- * @param   offBlockAddr    The block address to search for.
+ * Records a write to the given line of the virtual disk which didn't go
+ * through the cache, so data read from the image before isn't filled in.
  */
-static PVCIBLKRANGEDESC vciBlkMapFindByBlock(PVCIBLKMAP pBlkMap, uint64_t offBlockAddr)
+DECLINLINE(void) vciSetWrittenAround(PVCICACHE pCache, uint64_t uLine)
 {
-    PVCIBLKRANGEDESC pBlk = pBlkMap->pRangesHead;
-
-    while (   pBlk
-           && pBlk->offAddrStart < offBlockAddr)
-        pBlk = pBlk->pNext;
+    pCache->pauSetSeqUncached[vciLineToSet(pCache, uLine)] = ++pCache->uSeqUncached;
+}
 
-    return pBlk;
+/**
+ * Writes data to the given sectors of a line.
+ *
+ * @returns VBox status code.
+ * @param   pCache          The cache image instance.
+ * @param   idxLine         The line index.
+ * @param   iSector         First sector in the line.
+ * @param   pvBuf           The data.
+ * @param   cSectors        Number of sectors to write.
+ */
+DECLINLINE(int) vciLineWriteData(PVCICACHE pCache, uint32_t idxLine, uint32_t iSector,
+                                 const void *pvBuf, uint32_t cSectors)
+{
+    uint64_t const off = pCache->offData + (uint64_t)idxLine * VCI_LINE_SIZE + VCI_BLOCK2BYTE(iSector);
+    return vdIfIoIntFileWriteSync(pCache->pIfIo, pCache->pStorage, off, pvBuf, VCI_BLOCK2BYTE(cSectors));
 }
-#endif
 
 /**
- * Allocates the given number of blocks in the bitmap and returns the start block address.
+ * Writes the whole line table to the inactive copy and makes it the active one.
+ * The caller has to flush the data before and has to write the header.
  *
  * @returns VBox status code.
- * @param   pBlkMap          The block bitmap to allocate the blocks from.
- * @param   cBlocks          How many blocks to allocate.
- * @param   fFlags           Allocation flags, comgination of VCIBLKMAP_ALLOC_*.
- * @param   poffBlockAddr    Where to store the start address of the allocated region.
+ * @param   pCache          The cache image instance.
  */
-static int vciBlkMapAllocate(PVCIBLKMAP pBlkMap, uint32_t cBlocks, uint32_t fFlags,
-                             uint64_t *poffBlockAddr)
+static int vciCheckpoint(PVCICACHE pCache)
 {
-    PVCIBLKRANGEDESC pBestFit = NULL;
-    PVCIBLKRANGEDESC pCur = NULL;
+    uint8_t const idxLineTbl = pCache->Hdr.idxLineTbl ^ 1;
+    uint32_t const cEntriesPerBuf = VCI_META_BUF_SIZE / sizeof(VciLineEnt);
     int rc = VINF_SUCCESS;
 
-    LogFlowFunc(("pBlkMap=%#p cBlocks=%u poffBlockAddr=%#p\n",
-                 pBlkMap, cBlocks, poffBlockAddr));
-
-    pCur = pBlkMap->pRangesHead;
-
-    while (pCur)
-    {
-        if (   pCur->fFree
-            && pCur->cBlocks >= cBlocks)
-        {
-            if (   !pBestFit
-                || pCur->cBlocks < pBestFit->cBlocks)
-            {
-                pBestFit = pCur;
-                /* Stop searching if the size is matching exactly. */
-                if (pBestFit->cBlocks == cBlocks)
-                    break;
-            }
-        }
-        pCur = pCur->pNext;
-    }
-
-    Assert(!pBestFit || pBestFit->fFree);
-
-    if (pBestFit)
+    for (uint32_t idxLine = 0; idxLine < pCache->cLines && RT_SUCCESS(rc); idxLine += cEntriesPerBuf)
     {
-        pBestFit->fFree = false;
+        uint32_t const cEntries = RT_MIN(cEntriesPerBuf, pCache->cLines - idxLine);
+        PVciLineEnt paEnt = (PVciLineEnt)pCache->pbMetaBuf;
 
-        if (pBestFit->cBlocks > cBlocks)
+        for (uint32_t i = 0; i < cEntries; i++)
         {
-            /* Create a new free block. */
-            PVCIBLKRANGEDESC pFree = (PVCIBLKRANGEDESC)RTMemAllocZ(sizeof(VCIBLKRANGEDESC));
-
-            if (pFree)
-            {
-                pFree->fFree = true;
-                pFree->cBlocks = pBestFit->cBlocks - cBlocks;
-                pBestFit->cBlocks -= pFree->cBlocks;
-                pFree->offAddrStart = pBestFit->offAddrStart + cBlocks;
-
-                /* Link into the list. */
-                pFree->pNext = pBestFit->pNext;
-                pBestFit->pNext = pFree;
-                pFree->pPrev    = pBestFit;
-                if (!pFree->pNext)
-                    pBlkMap->pRangesTail = pFree;
-
-                *poffBlockAddr = pBestFit->offAddrStart;
-            }
-            else
-            {
-                rc = VERR_NO_MEMORY;
-                pBestFit->fFree = true;
-            }
+            PVCILINE pLine = &pCache->paLines[idxLine + i];
+            paEnt[i].u64Tag      = RT_H2LE_U64(pLine->uTag);
+            paEnt[i].u64BmValid  = RT_H2LE_U64(pLine->bmValid);
+            paEnt[i].u64BmDirty  = RT_H2LE_U64(pLine->bmDirty);
+            paEnt[i].u64Reserved = 0;
         }
+
+        rc = vdIfIoIntFileWriteSync(pCache->pIfIo, pCache->pStorage,
+                                    pCache->aoffLineTbl[idxLineTbl] + (uint64_t)idxLine * sizeof(VciLineEnt),
+                                    paEnt, cEntries * sizeof(VciLineEnt));
     }
-    else
-        rc = VERR_VCI_NO_BLOCKS_FREE;
 
+    if (RT_SUCCESS(rc))
+        rc = vciFlushImage(pCache);
     if (RT_SUCCESS(rc))
     {
-        if ((fFlags & VCIBLKMAP_ALLOC_MASK) == VCIBLKMAP_ALLOC_DATA)
-            pBlkMap->cBlocksAllocMeta += cBlocks;
-        else
-            pBlkMap->cBlocksAllocData += cBlocks;
-
-        pBlkMap->cBlocksFree -= cBlocks;
+        /* The log is empty for the new table. */
+        pCache->Hdr.idxLineTbl    = idxLineTbl;
+        pCache->Hdr.u64LogSeqBase = pCache->uLogSeqNext;
+        pCache->fHdrDirty = true;
+        pCache->cCheckpoints++;
     }
 
-    LogFlowFunc(("returns rc=%Rrc offBlockAddr=%llu\n", rc, *poffBlockAddr));
     return rc;
 }
 
-#if 0 /* unused */
 /**
- * Try to extend the space of an already allocated block.
+ * Appends the modified lines to the metadata log.
  *
  * @returns VBox status code.
- * @param   pBlkMap          The block bitmap to allocate the blocks from.
- * @param   cBlocksNew       How many blocks the extended block should have.
- * @param   offBlockAddrOld  The start address of the block to reallocate.
- * @param   poffBlockAddr    Where to store the start address of the allocated region.
+ * @param   pCache          The cache image instance.
  */
-static int vciBlkMapRealloc(PVCIBLKMAP pBlkMap, uint32_t cBlocksNew, uint64_t offBlockAddrOld,
-                            uint64_t *poffBlockAddr)
+static int vciLogAppend(PVCICACHE pCache)
 {
+    uint32_t idxModified = 0;
     int rc = VINF_SUCCESS;
 
-    LogFlowFunc(("pBlkMap=%#p cBlocksNew=%u offBlockAddrOld=%llu poffBlockAddr=%#p\n",
-                 pBlkMap, cBlocksNew, offBlockAddrOld, poffBlockAddr));
+    while (   idxModified < pCache->cModified
+           && RT_SUCCESS(rc))
+    {
+        uint64_t const idxPageFirst = pCache->uLogSeqNext - pCache->Hdr.u64LogSeqBase;
+        unsigned cPages = 0;
+
+        while (   idxModified < pCache->cModified
+               && cPages < VCI_LOG_PAGES_PER_WRITE)
+        {
+            PVciLogPage pPage = (PVciLogPage)pCache->pbMetaBuf + cPages;
+            uint32_t cEntries = 0;
+
+            memset(pPage, 0, sizeof(*pPage));
+            while (   idxModified < pCache->cModified
+                   && cEntries < VCI_LOG_ENTRIES_PER_PAGE)
+            {
+                uint32_t const idxLine = pCache->paidxModified[idxModified++];
+                PVCILINE pLine = &pCache->paLines[idxLine];
+                pPage->aEntries[cEntries].u32Line    = RT_H2LE_U32(idxLine);
+                pPage->aEntries[cEntries].u64Tag     = RT_H2LE_U64(pLine->uTag);
+                pPage->aEntries[cEntries].u64BmValid = RT_H2LE_U64(pLine->bmValid);
+                pPage->aEntries[cEntries].u64BmDirty = RT_H2LE_U64(pLine->bmDirty);
+                cEntries++;
+            }
+
+            pPage->u32Magic = RT_H2LE_U32(VCI_LOG_PAGE_MAGIC);
+            pPage->u64Seq   = RT_H2LE_U64(pCache->uLogSeqNext + cPages);
+            pPage->cEntries = RT_H2LE_U32(cEntries);
+            pPage->u32Crc   = RT_H2LE_U32(RTCrc32(pPage, sizeof(*pPage)));
+            cPages++;
+        }
 
-    AssertMsgFailed(("Implement\n"));
-    RT_NOREF4(pBlkMap, cBlocksNew, offBlockAddrOld, poffBlockAddr);
+        rc = vdIfIoIntFileWriteSync(pCache->pIfIo, pCache->pStorage,
+                                    pCache->offLog + idxPageFirst * VCI_LOG_PAGE_SIZE,
+                                    pCache->pbMetaBuf, cPages * VCI_LOG_PAGE_SIZE);
+        if (RT_SUCCESS(rc))
+            pCache->uLogSeqNext += cPages;
+    }
 
-    LogFlowFunc(("returns rc=%Rrc offBlockAddr=%llu\n", rc, *poffBlockAddr));
     return rc;
 }
-#endif /* unused */
 
-#if 0 /* unused */
 /**
- * Frees a range of blocks.
+ * Commits all metadata changes, making them persistent.
  *
- * @param   pBlkMap          The block bitmap.
- * @param   offBlockAddr     Address of the first block to free.
- * @param   cBlocks          How many blocks to free.
- * @param   fFlags           Allocation flags, comgination of VCIBLKMAP_ALLOC_*.
+ * @returns VBox status code.
+ * @param   pCache          The cache image instance.
  */
-static void vciBlkMapFree(PVCIBLKMAP pBlkMap, uint64_t offBlockAddr, uint32_t cBlocks,
-                          uint32_t fFlags)
+static int vciCommit(PVCICACHE pCache)
 {
-    PVCIBLKRANGEDESC pBlk;
+    Assert(RTCritSectIsOwner(&pCache->CritSect));
 
-    LogFlowFunc(("pBlkMap=%#p offBlockAddr=%llu cBlocks=%u\n",
-                 pBlkMap, offBlockAddr, cBlocks));
+    if (   !pCache->cModified
+        && !pCache->fHdrDirty)
+        return VINF_SUCCESS;
 
-    while (cBlocks)
+    /* The data the new line states refer to must be on the medium first. */
+    int rc = vciFlushImage(pCache);
+    if (RT_SUCCESS(rc) && pCache->cModified)
     {
-        pBlk = vciBlkMapFindByBlock(pBlkMap, offBlockAddr);
-        AssertPtr(pBlk);
-
-        /* Easy case, the whole block is freed. */
-        if (   pBlk->offAddrStart == offBlockAddr
-            && pBlk->cBlocks <= cBlocks)
-        {
-            pBlk->fFree = true;
-            cBlocks      -= pBlk->cBlocks;
-            offBlockAddr += pBlk->cBlocks;
-
-            /* Check if it is possible to merge free blocks. */
-            if (   pBlk->pPrev
-                && pBlk->pPrev->fFree)
-            {
-                PVCIBLKRANGEDESC pBlkPrev = pBlk->pPrev;
-
-                Assert(pBlkPrev->offAddrStart + pBlkPrev->cBlocks == pBlk->offAddrStart);
-                pBlkPrev->cBlocks += pBlk->cBlocks;
-                pBlkPrev->pNext = pBlk->pNext;
-                if (pBlk->pNext)
-                    pBlk->pNext->pPrev = pBlkPrev;
-                else
-                    pBlkMap->pRangesTail = pBlkPrev;
-
-                RTMemFree(pBlk);
-                pBlk = pBlkPrev;
-            }
-
-            /* Now the one to the right. */
-            if (   pBlk->pNext
-                && pBlk->pNext->fFree)
-            {
-                PVCIBLKRANGEDESC pBlkNext = pBlk->pNext;
-
-                Assert(pBlk->offAddrStart + pBlk->cBlocks == pBlkNext->offAddrStart);
-                pBlk->cBlocks += pBlkNext->cBlocks;
-                pBlk->pNext = pBlkNext->pNext;
-                if (pBlkNext->pNext)
-                    pBlkNext->pNext->pPrev = pBlk;
-                else
-                    pBlkMap->pRangesTail = pBlk;
-
-                RTMemFree(pBlkNext);
-            }
-        }
+        uint64_t const cPagesNeeded = (pCache->cModified + VCI_LOG_ENTRIES_PER_PAGE - 1) / VCI_LOG_ENTRIES_PER_PAGE;
+        if (pCache->uLogSeqNext - pCache->Hdr.u64LogSeqBase + cPagesNeeded <= pCache->cLogPages)
+            rc = vciLogAppend(pCache);
         else
-        {
-            /* The block is intersecting. */
-            AssertMsgFailed(("TODO\n"));
-        }
+            rc = vciCheckpoint(pCache);
+    }
+    if (RT_SUCCESS(rc) && pCache->fHdrDirty)
+        rc = vciHdrWrite(pCache->pIfIo, pCache->pStorage, &pCache->Hdr);
+    if (RT_SUCCESS(rc))
+        rc = vciFlushImage(pCache);
+    if (RT_SUCCESS(rc))
+    {
+        for (uint32_t i = 0; i < pCache->cModified; i++)
+            pCache->paLines[pCache->paidxModified[i]].fFlags &= ~(VCILINE_F_MODIFIED | VCILINE_F_PENDING_FREE);
+        pCache->cModified = 0;
+        pCache->fHdrDirty = false;
+        pCache->cCommits++;
     }
-
-    if ((fFlags & VCIBLKMAP_ALLOC_MASK) == VCIBLKMAP_ALLOC_DATA)
-        pBlkMap->cBlocksAllocMeta -= cBlocks;
     else
-        pBlkMap->cBlocksAllocData -= cBlocks;
-
-    pBlkMap->cBlocksFree += cBlocks;
+        LogRel(("VCI: Committing the metadata of '%s' failed with %Rrc\n", pCache->pszFilename, rc));
 
-    LogFlowFunc(("returns\n"));
+    return rc;
 }
-#endif /* unused */
 
 /**
- * Converts a tree node from the image to the in memory structure.
+ * Loads the active line table and replays the metadata log.
  *
- * @returns Pointer to the in memory tree node.
- * @param   offBlockAddrNode    Block address of the node.
- * @param   pNodeImage          Pointer to the image representation of the node.
+ * @returns VBox status code.
+ * @param   pCache          The cache image instance.
  */
-static PVCITREENODE vciTreeNodeImage2Host(uint64_t offBlockAddrNode, PVciTreeNode pNodeImage)
+static int vciMetadataLoad(PVCICACHE pCache)
 {
-    PVCITREENODE pNode = NULL;
+    uint32_t const cEntriesPerBuf = VCI_META_BUF_SIZE / sizeof(VciLineEnt);
+    int rc = VINF_SUCCESS;
 
-    if (pNodeImage->u8Type == VCI_TREE_NODE_TYPE_LEAF)
+    for (uint32_t idxLine = 0; idxLine < pCache->cLines && RT_SUCCESS(rc); idxLine += cEntriesPerBuf)
     {
-        PVCITREENODELEAF pLeaf = (PVCITREENODELEAF)RTMemAllocZ(sizeof(VCITREENODELEAF));
+        uint32_t const cEntries = RT_MIN(cEntriesPerBuf, pCache->cLines - idxLine);
+        PVciLineEnt paEnt = (PVciLineEnt)pCache->pbMetaBuf;
 
-        if (pLeaf)
+        rc = vdIfIoIntFileReadSync(pCache->pIfIo, pCache->pStorage,
+                                   pCache->aoffLineTbl[pCache->Hdr.idxLineTbl] + (uint64_t)idxLine * sizeof(VciLineEnt),
+                                   paEnt, cEntries * sizeof(VciLineEnt));
+        for (uint32_t i = 0; i < cEntries && RT_SUCCESS(rc); i++)
         {
-            PVciCacheExtent pExtent = (PVciCacheExtent)&pNodeImage->au8Data[0];
+            PVCILINE pLine = &pCache->paLines[idxLine + i];
+            pLine->uTag    = RT_LE2H_U64(paEnt[i].u64Tag);
+            pLine->bmValid = RT_LE2H_U64(paEnt[i].u64BmValid);
+            pLine->bmDirty = RT_LE2H_U64(paEnt[i].u64BmDirty);
+        }
+    }
+
+    /* Replay the log, it ends with the first page not continuing the sequence. */
+    uint32_t cPagesReplayed = 0;
+    pCache->uLogSeqNext = pCache->Hdr.u64LogSeqBase;
+    while (   RT_SUCCESS(rc)
+           && cPagesReplayed < pCache->cLogPages)
+    {
+        PVciLogPage pPage = (PVciLogPage)pCache->pbMetaBuf;
+        rc = vdIfIoIntFileReadSync(pCache->pIfIo, pCache->pStorage,
+                                   pCache->offLog + (uint64_t)cPagesReplayed * VCI_LOG_PAGE_SIZE,
+                                   pPage, sizeof(*pPage));
+        if (RT_FAILURE(rc))
+            break;
 
-            pLeaf->Core.u8Type = VCI_TREE_NODE_TYPE_LEAF;
+        uint32_t const u32Crc = RT_LE2H_U32(pPage->u32Crc);
+        pPage->u32Crc = 0;
+        if (   RT_LE2H_U32(pPage->u32Magic) != VCI_LOG_PAGE_MAGIC
+            || RT_LE2H_U64(pPage->u64Seq) != pCache->uLogSeqNext
+            || RT_LE2H_U32(pPage->cEntries) > VCI_LOG_ENTRIES_PER_PAGE
+            || RTCrc32(pPage, sizeof(*pPage)) != u32Crc)
+            break;
 
-            for (unsigned idx = 0; idx < RT_ELEMENTS(pLeaf->aExtents); idx++)
+        uint32_t const cEntries = RT_LE2H_U32(pPage->cEntries);
+        for (uint32_t i = 0; i < cEntries; i++)
+        {
+            uint32_t const idxLine = RT_LE2H_U32(pPage->aEntries[i].u32Line);
+            if (idxLine >= pCache->cLines)
             {
-                pLeaf->aExtents[idx].u64BlockOffset = RT_LE2H_U64(pExtent->u64BlockOffset);
-                pLeaf->aExtents[idx].u32Blocks      = RT_LE2H_U32(pExtent->u32Blocks);
-                pLeaf->aExtents[idx].u64BlockAddr   = RT_LE2H_U64(pExtent->u64BlockAddr);
-                pExtent++;
-
-                if (   pLeaf->aExtents[idx].u32Blocks
-                    && pLeaf->aExtents[idx].u64BlockAddr)
-                    pLeaf->cUsedNodes++;
+                rc = VERR_VD_IMAGE_CORRUPTED;
+                break;
             }
 
-            pNode = &pLeaf->Core;
+            PVCILINE pLine = &pCache->paLines[idxLine];
+            pLine->uTag    = RT_LE2H_U64(pPage->aEntries[i].u64Tag);
+            pLine->bmValid = RT_LE2H_U64(pPage->aEntries[i].u64BmValid);
+            pLine->bmDirty = RT_LE2H_U64(pPage->aEntries[i].u64BmDirty);
         }
-    }
-    else if (pNodeImage->u8Type == VCI_TREE_NODE_TYPE_INTERNAL)
-    {
-        PVCITREENODEINT pInt = (PVCITREENODEINT)RTMemAllocZ(sizeof(VCITREENODEINT));
 
-        if (pInt)
-        {
-            PVciTreeNodeInternal pIntImage = (PVciTreeNodeInternal)&pNodeImage->au8Data[0];
-
-            pInt->Core.u8Type = VCI_TREE_NODE_TYPE_INTERNAL;
+        cPagesReplayed++;
+        pCache->uLogSeqNext++;
+    }
 
-            for (unsigned idx = 0; idx < RT_ELEMENTS(pInt->aIntNodes); idx++)
-            {
-                pInt->aIntNodes[idx].u64BlockOffset              = RT_LE2H_U64(pIntImage->u64BlockOffset);
-                pInt->aIntNodes[idx].u32Blocks                   = RT_LE2H_U32(pIntImage->u32Blocks);
-                pInt->aIntNodes[idx].PtrChild.fInMemory          = false;
-                pInt->aIntNodes[idx].PtrChild.u.offAddrBlockNode = RT_LE2H_U64(pIntImage->u64ChildAddr);
-                pIntImage++;
-
-                if (   pInt->aIntNodes[idx].u32Blocks
-                    && pInt->aIntNodes[idx].PtrChild.u.offAddrBlockNode)
-                    pInt->cUsedNodes++;
-            }
+    if (RT_FAILURE(rc))
+        return rc;
 
-            pNode = &pInt->Core;
+    /* Set up the runtime state. */
+    pCache->cSectorsDirty = 0;
+    for (uint32_t idxLine = 0; idxLine < pCache->cLines; idxLine++)
+    {
+        PVCILINE pLine = &pCache->paLines[idxLine];
+        if (!pLine->uTag)
+        {
+            pLine->bmValid = 0;
+            pLine->bmDirty = 0;
         }
+        pLine->bmDirty &= pLine->bmValid;
+        vciLineDirtyUpdate(pCache, idxLine, 0);
     }
-    else
-        AssertMsgFailed(("Invalid node type %d\n", pNodeImage->u8Type));
 
-    if (pNode)
-        pNode->u64BlockAddr = offBlockAddrNode;
+    if (cPagesReplayed || pCache->Hdr.fUncleanShutdown)
+        LogRel(("VCI: '%s' was not closed cleanly, replayed %u metadata log pages, %RU64 bytes dirty\n",
+                pCache->pszFilename, cPagesReplayed, VCI_BLOCK2BYTE(pCache->cSectorsDirty)));
 
-    return pNode;
+    return VINF_SUCCESS;
 }
 
 /**
- * Looks up the cache extent for the given virtual block address.
- *
- * @returns Pointer to the cache extent or NULL if none could be found.
- * @param   pCache         The cache image instance.
- * @param   offBlockOffset The block offset to search for.
- * @param   ppNextBestFit  Where to store the pointer to the next best fit
- *                         cache extent above offBlockOffset if existing. - Optional
- *                         This is always filled if possible even if the function returns NULL.
+ * Internal. Free all allocated space for representing an image except pCache,
+ * and optionally delete the image from disk.
  */
-static PVCICACHEEXTENT vciCacheExtentLookup(PVCICACHE pCache, uint64_t offBlockOffset,
-                                            PVCICACHEEXTENT *ppNextBestFit)
+static int vciFreeImage(PVCICACHE pCache, bool fDelete)
 {
     int rc = VINF_SUCCESS;
-    PVCICACHEEXTENT pExtent = NULL;
-    PVCITREENODE pNodeCur = pCache->pRoot;
 
-    while (   RT_SUCCESS(rc)
-           && pNodeCur
-           && pNodeCur->u8Type != VCI_TREE_NODE_TYPE_LEAF)
+    /* Freeing a never allocated image (e.g. because the open failed) is
+     * not signalled as an error. After all nothing bad happens. */
+    if (pCache)
     {
-        PVCITREENODEINT pNodeInt = (PVCITREENODEINT)pNodeCur;
-
-        Assert(pNodeCur->u8Type == VCI_TREE_NODE_TYPE_INTERNAL);
-
-        /* Search for the correct internal node. */
-        unsigned idxMin = 0;
-        unsigned idxMax = pNodeInt->cUsedNodes;
-        unsigned idxCur = pNodeInt->cUsedNodes / 2;
-
-        while (idxMin < idxMax)
+        if (pCache->pStorage)
         {
-            PVCINODEINTERNAL pInt = &pNodeInt->aIntNodes[idxCur];
-
-            /* Determine the search direction. */
-            if (offBlockOffset < pInt->u64BlockOffset)
-            {
-                /* Search left from the current extent. */
-                idxMax = idxCur;
-            }
-            else if (offBlockOffset >= pInt->u64BlockOffset + pInt->u32Blocks)
-            {
-                /* Search right from the current extent. */
-                idxMin = idxCur;
-            }
-            else
+            /* No point updating the file that is deleted anyway. */
+            if (   !fDelete
+                && pCache->paLines
+                && !(pCache->uOpenFlags & VD_OPEN_FLAGS_READONLY))
             {
-                /* The block lies in the node, stop searching. */
-                if (pInt->PtrChild.fInMemory)
-                    pNodeCur = pInt->PtrChild.u.pNode;
-                else
+                RTCritSectEnter(&pCache->CritSect);
+                rc = vciCommit(pCache);
+                if (RT_SUCCESS(rc))
                 {
-                    PVCITREENODE pNodeNew;
-                    VciTreeNode NodeTree;
-
-                    /* Read from disk and add to the tree. */
-                    rc = vdIfIoIntFileReadSync(pCache->pIfIo, pCache->pStorage,
-                                               VCI_BLOCK2BYTE(pInt->PtrChild.u.offAddrBlockNode),
-                                               &NodeTree, sizeof(NodeTree));
-                    AssertRC(rc);
-
-                    pNodeNew = vciTreeNodeImage2Host(pInt->PtrChild.u.offAddrBlockNode, &NodeTree);
-                    if (pNodeNew)
-                    {
-                        /* Link to the parent. */
-                        pInt->PtrChild.fInMemory = true;
-                        pInt->PtrChild.u.pNode = pNodeNew;
-                        pNodeNew->pParent = pNodeCur;
-                        pNodeCur = pNodeNew;
-                    }
-                    else
-                        rc = VERR_NO_MEMORY;
+                    pCache->Hdr.fUncleanShutdown = VCI_HDR_CLEAN_SHUTDOWN;
+                    rc = vciHdrWrite(pCache->pIfIo, pCache->pStorage, &pCache->Hdr);
                 }
-                break;
+                RTCritSectLeave(&pCache->CritSect);
+                vciFlushImage(pCache);
+
+                LogRel(("VCI: '%s' closed, %RU64 bytes dirty, %RU64 bytes read hits, %RU64 bytes read misses, %RU64 commits, %RU64 checkpoints\n",
+                        pCache->pszFilename, VCI_BLOCK2BYTE(pCache->cSectorsDirty), pCache->cbHits, pCache->cbMisses,
+                        pCache->cCommits, pCache->cCheckpoints));
             }
 
-            idxCur = idxMin + (idxMax - idxMin) / 2;
+            vdIfIoIntFileClose(pCache->pIfIo, pCache->pStorage);
+            pCache->pStorage = NULL;
         }
-    }
 
-    if (   RT_SUCCESS(rc)
-        && pNodeCur)
-    {
-        PVCITREENODELEAF pLeaf = (PVCITREENODELEAF)pNodeCur;
-        Assert(pNodeCur->u8Type == VCI_TREE_NODE_TYPE_LEAF);
-
-        /* Search the range. */
-        unsigned idxMin = 0;
-        unsigned idxMax = pLeaf->cUsedNodes;
-        unsigned idxCur = pLeaf->cUsedNodes / 2;
+        if (fDelete && pCache->pszFilename)
+            vdIfIoIntFileDelete(pCache->pIfIo, pCache->pszFilename);
 
-        while (idxMin < idxMax)
+        if (pCache->paLines)
         {
-            PVCICACHEEXTENT pExtentCur = &pLeaf->aExtents[idxCur];
-
-            /* Determine the search direction. */
-            if (offBlockOffset < pExtentCur->u64BlockOffset)
-            {
-                /* Search left from the current extent. */
-                idxMax = idxCur;
-            }
-            else if (offBlockOffset >= pExtentCur->u64BlockOffset + pExtentCur->u32Blocks)
-            {
-                /* Search right from the current extent. */
-                idxMin = idxCur;
-            }
-            else
-            {
-                /* We found the extent, stop searching. */
-                pExtent = pExtentCur;
-                break;
-            }
-
-            idxCur = idxMin + (idxMax - idxMin) / 2;
+            RTMemFree(pCache->paLines);
+            pCache->paLines = NULL;
         }
-
-        /* Get the next best fit extent if it exists. */
-        if (ppNextBestFit)
+        if (pCache->pbmLinesDirty)
         {
-            if (idxCur < pLeaf->cUsedNodes - 1)
-                *ppNextBestFit = &pLeaf->aExtents[idxCur + 1];
-            else
-            {
-                /*
-                 * Go up the tree and find the best extent
-                 * in the leftmost tree of the child subtree to the right.
-                 */
-                PVCITREENODEINT pInt = (PVCITREENODEINT)pLeaf->Core.pParent;
+            RTMemFree(pCache->pbmLinesDirty);
+            pCache->pbmLinesDirty = NULL;
+        }
+        if (pCache->pauSetSeqUncached)
+        {
+            RTMemFree(pCache->pauSetSeqUncached);
+            pCache->pauSetSeqUncached = NULL;
+        }
+        if (pCache->paidxModified)
+        {
+            RTMemFree(pCache->paidxModified);
+            pCache->paidxModified = NULL;
+        }
+        if (pCache->pbMetaBuf)
+        {
+            RTMemPageFree(pCache->pbMetaBuf, VCI_META_BUF_SIZE);
+            pCache->pbMetaBuf = NULL;
+        }
+        if (pCache->pbBounce)
+        {
+            RTMemPageFree(pCache->pbBounce, VCI_LINE_SIZE);
+            pCache->pbBounce = NULL;
+        }
+        if (RTCritSectIsInitialized(&pCache->CritSect))
+            RTCritSectDelete(&pCache->CritSect);
+    }
+
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
 
-                while (pInt)
-                {
+/**
+ * Internal: Sets up the in memory state from the header and loads the metadata.
+ */
+static int vciLoadImage(PVCICACHE pCache)
+{
+    int rc = RTCritSectInit(&pCache->CritSect);
+    if (RT_FAILURE(rc))
+        return rc;
 
-                }
-            }
-        }
+    pCache->cLines         = pCache->Hdr.cLines;
+    pCache->cSets          = pCache->Hdr.cLines / VCI_WAYS;
+    pCache->aoffLineTbl[0] = VCI_BLOCK2BYTE(pCache->Hdr.aoffLineTbl[0]);
+    pCache->aoffLineTbl[1] = VCI_BLOCK2BYTE(pCache->Hdr.aoffLineTbl[1]);
+    pCache->cbLineTbl      = RT_ALIGN_64((uint64_t)pCache->cLines * sizeof(VciLineEnt), VCI_AREA_ALIGNMENT);
+    pCache->offLog         = VCI_BLOCK2BYTE(pCache->Hdr.offLog);
+    pCache->cLogPages      = (uint32_t)(VCI_BLOCK2BYTE(pCache->Hdr.cLogBlocks) / VCI_LOG_PAGE_SIZE);
+    pCache->offData        = VCI_BLOCK2BYTE(pCache->Hdr.offData);
+    pCache->cModified      = 0;
+    pCache->fHdrDirty      = false;
+    pCache->cbSize         = VCI_BLOCK2BYTE(pCache->Hdr.cBlocksCache);
+    pCache->uImageFlags    =   pCache->Hdr.u32CacheType == VCI_HDR_CACHE_TYPE_FIXED
+                             ? VD_IMAGE_FLAGS_FIXED : VD_IMAGE_FLAGS_NONE;
+
+    pCache->paLines           = (PVCILINE)RTMemAllocZ(pCache->cLines * sizeof(VCILINE));
+    pCache->pbmLinesDirty     = (uint64_t *)RTMemAllocZ(RT_ALIGN_32(pCache->cLines, 64) / 8);
+    pCache->pauSetSeqUncached = (uint64_t *)RTMemAllocZ(pCache->cSets * sizeof(uint64_t));
+    pCache->paidxModified     = (uint32_t *)RTMemAlloc(pCache->cLines * sizeof(uint32_t));
+    pCache->pbMetaBuf         = (uint8_t *)RTMemPageAlloc(VCI_META_BUF_SIZE);
+    pCache->pbBounce          = (uint8_t *)RTMemPageAlloc(VCI_LINE_SIZE);
+    if (   !pCache->paLines
+        || !pCache->pbmLinesDirty
+        || !pCache->pauSetSeqUncached
+        || !pCache->paidxModified
+        || !pCache->pbMetaBuf
+        || !pCache->pbBounce)
+        return VERR_NO_MEMORY;
+
+    rc = vciMetadataLoad(pCache);
+    if (   RT_SUCCESS(rc)
+        && !(pCache->uOpenFlags & VD_OPEN_FLAGS_READONLY))
+    {
+        /* Mark the image as in use until it is closed cleanly. */
+        pCache->Hdr.fUncleanShutdown = VCI_HDR_UNCLEAN_SHUTDOWN;
+        rc = vciHdrWrite(pCache->pIfIo, pCache->pStorage, &pCache->Hdr);
+        if (RT_SUCCESS(rc))
+            rc = vciFlushImage(pCache);
     }
 
-    return pExtent;
+    return rc;
 }
 
 /**
@@ -1220,8 +1070,6 @@ static PVCICACHEEXTENT vciCacheExtentLookup(PVCICACHE pCache, uint64_t offBlockO
  */
 static int vciOpenImage(PVCICACHE pCache, unsigned uOpenFlags)
 {
-    VciHdr Hdr;
-    uint64_t cbFile;
     int rc;
 
     pCache->uOpenFlags = uOpenFlags;
@@ -1244,55 +1092,9 @@ static int vciOpenImage(PVCICACHE pCache, unsigned uOpenFlags)
         goto out;
     }
 
-    rc = vdIfIoIntFileGetSize(pCache->pIfIo, pCache->pStorage, &cbFile);
-    if (RT_FAILURE(rc) || cbFile < sizeof(VciHdr))
-    {
-        rc = VERR_VD_GEN_INVALID_HEADER;
-        goto out;
-    }
-
-    rc = vdIfIoIntFileReadSync(pCache->pIfIo, pCache->pStorage, 0, &Hdr,
-                               VCI_BYTE2BLOCK(sizeof(Hdr)));
-    if (RT_FAILURE(rc))
-    {
-        rc = VERR_VD_GEN_INVALID_HEADER;
-        goto out;
-    }
-
-    Hdr.u32Signature = RT_LE2H_U32(Hdr.u32Signature);
-    Hdr.u32Version   = RT_LE2H_U32(Hdr.u32Version);
-    Hdr.cBlocksCache = RT_LE2H_U64(Hdr.cBlocksCache);
-    Hdr.u32CacheType = RT_LE2H_U32(Hdr.u32CacheType);
-    Hdr.offTreeRoot  = RT_LE2H_U64(Hdr.offTreeRoot);
-    Hdr.offBlkMap    = RT_LE2H_U64(Hdr.offBlkMap);
-    Hdr.cBlkMap      = RT_LE2H_U32(Hdr.cBlkMap);
-
-    if (   Hdr.u32Signature == VCI_HDR_SIGNATURE
-        && Hdr.u32Version == VCI_HDR_VERSION)
-    {
-        pCache->offTreeRoot   = Hdr.offTreeRoot;
-        pCache->offBlksBitmap = Hdr.offBlkMap;
-
-        /* Load the block map. */
-        rc = vciBlkMapLoad(pCache, pCache->offBlksBitmap, Hdr.cBlkMap, &pCache->pBlkMap);
-        if (RT_SUCCESS(rc))
-        {
-            /* Load the first tree node. */
-            VciTreeNode RootNode;
-
-            rc = vdIfIoIntFileReadSync(pCache->pIfIo, pCache->pStorage,
-                                       pCache->offTreeRoot, &RootNode,
-                                       VCI_BYTE2BLOCK(sizeof(VciTreeNode)));
-            if (RT_SUCCESS(rc))
-            {
-                pCache->pRoot = vciTreeNodeImage2Host(pCache->offTreeRoot, &RootNode);
-                if (!pCache->pRoot)
-                    rc = VERR_NO_MEMORY;
-            }
-        }
-    }
-    else
-        rc = VERR_VD_GEN_INVALID_HEADER;
+    rc = vciHdrRead(pCache->pIfIo, pCache->pStorage, &pCache->Hdr);
+    if (RT_SUCCESS(rc))
+        rc = vciLoadImage(pCache);
 
 out:
     if (RT_FAILURE(rc))
@@ -1305,15 +1107,11 @@ out:
  */
 static int vciCreateImage(PVCICACHE pCache, uint64_t cbSize,
                           unsigned uImageFlags, const char *pszComment,
-                          unsigned uOpenFlags, PFNVDPROGRESS pfnProgress,
-                          void *pvUser, unsigned uPercentStart,
-                          unsigned uPercentSpan)
+                          unsigned uOpenFlags, PVDINTERFACEPROGRESS pIfProgress,
+                          unsigned uPercentStart, unsigned uPercentSpan)
 {
     RT_NOREF1(pszComment);
-    VciHdr Hdr;
-    VciTreeNode NodeRoot;
     int rc;
-    uint64_t cBlocks = cbSize / VCI_BLOCK_SIZE; /* Size of the cache in blocks. */
 
     pCache->uImageFlags = uImageFlags;
     pCache->uOpenFlags = uOpenFlags & ~VD_OPEN_FLAGS_READONLY;
@@ -1330,133 +1128,71 @@ static int vciCreateImage(PVCICACHE pCache, uint64_t cbSize,
 
     do
     {
-        /* Create image file. */
-        rc = vdIfIoIntFileOpen(pCache->pIfIo, pCache->pszFilename,
-                               VDOpenFlagsToFileOpenFlags(uOpenFlags & ~VD_OPEN_FLAGS_READONLY,
-                                                          true /* fCreate */),
-                               &pCache->pStorage);
-        if (RT_FAILURE(rc))
-        {
-            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot create image '%s'"), pCache->pszFilename);
-            break;
-        }
-
-        /* Allocate block bitmap. */
-        uint32_t cBlkMap = 0;
-        rc = vciBlkMapCreate(cBlocks, &pCache->pBlkMap, &cBlkMap);
-        if (RT_FAILURE(rc))
-        {
-            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot create block bitmap '%s'"), pCache->pszFilename);
-            break;
-        }
-
-        /*
-         * Allocate space for the header in the block bitmap.
-         * Because the block map is empty the header has to start at block 0
-         */
-        uint64_t offHdr = 0;
-        rc = vciBlkMapAllocate(pCache->pBlkMap, VCI_BYTE2BLOCK(sizeof(VciHdr)), VCIBLKMAP_ALLOC_META, &offHdr);
+        /* Compute the layout first, no point in creating the file if the size doesn't fit. */
+        memset(&pCache->Hdr, 0, sizeof(pCache->Hdr));
+        rc = vciLayoutCompute(cbSize, &pCache->Hdr);
         if (RT_FAILURE(rc))
         {
-            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot allocate space for header in block bitmap '%s'"), pCache->pszFilename);
+            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cache size %RU64 of '%s' is too small"), cbSize, pCache->pszFilename);
             break;
         }
 
-        Assert(offHdr == 0);
+        pCache->Hdr.fUncleanShutdown = VCI_HDR_CLEAN_SHUTDOWN;
+        pCache->Hdr.u32CacheType     = uImageFlags & VD_IMAGE_FLAGS_FIXED
+                                     ? VCI_HDR_CACHE_TYPE_FIXED
+                                     : VCI_HDR_CACHE_TYPE_DYNAMIC;
 
-        /*
-         * Allocate space for the block map itself.
-         */
-        uint64_t offBlkMap = 0;
-        rc = vciBlkMapAllocate(pCache->pBlkMap, cBlkMap, VCIBLKMAP_ALLOC_META, &offBlkMap);
+        /* Create image file. */
+        rc = vdIfIoIntFileOpen(pCache->pIfIo, pCache->pszFilename,
+                               VDOpenFlagsToFileOpenFlags(uOpenFlags & ~VD_OPEN_FLAGS_READONLY,
+                                                          true /* fCreate */),
+                               &pCache->pStorage);
         if (RT_FAILURE(rc))
         {
-            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot allocate space for block map in block map '%s'"), pCache->pszFilename);
+            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot create image '%s'"), pCache->pszFilename);
             break;
         }
 
         /*
-         * Allocate space for the tree root node.
+         * The line tables and the log must read as zero, which is the case for a
+         * freshly sized file. Fixed caches get all the space allocated upfront.
          */
-        uint64_t offTreeRoot = 0;
-        rc = vciBlkMapAllocate(pCache->pBlkMap, VCI_BYTE2BLOCK(sizeof(VciTreeNode)), VCIBLKMAP_ALLOC_META, &offTreeRoot);
+        uint64_t const cbFile = VCI_BLOCK2BYTE(pCache->Hdr.cBlocksCache);
+        if (uImageFlags & VD_IMAGE_FLAGS_FIXED)
+            rc = vdIfIoIntFileSetAllocationSize(pCache->pIfIo, pCache->pStorage, cbFile, 0 /* fFlags */,
+                                                pIfProgress, uPercentStart, uPercentSpan);
+        else
+            rc = vdIfIoIntFileSetSize(pCache->pIfIo, pCache->pStorage, cbFile);
         if (RT_FAILURE(rc))
         {
-            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot allocate space for block map in block map '%s'"), pCache->pszFilename);
-            break;
-        }
-
-        /*
-         * Allocate the in memory root node.
-         */
-        pCache->pRoot = (PVCITREENODE)RTMemAllocZ(sizeof(VCITREENODELEAF));
-        if (!pCache->pRoot)
-        {
-            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot allocate B+-Tree root pointer '%s'"), pCache->pszFilename);
+            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: setting image size of '%s' failed"), pCache->pszFilename);
             break;
         }
 
-        pCache->pRoot->u8Type = VCI_TREE_NODE_TYPE_LEAF;
-        /* Rest remains 0 as the tree is still empty. */
-
-        /*
-         * Now that we are here we have all the basic structures and know where to place them in the image.
-         * It's time to write it now.
-         */
-
-        /* Setup the header. */
-        memset(&Hdr, 0, sizeof(VciHdr));
-        Hdr.u32Signature     = RT_H2LE_U32(VCI_HDR_SIGNATURE);
-        Hdr.u32Version       = RT_H2LE_U32(VCI_HDR_VERSION);
-        Hdr.cBlocksCache     = RT_H2LE_U64(cBlocks);
-        Hdr.fUncleanShutdown = VCI_HDR_UNCLEAN_SHUTDOWN;
-        Hdr.u32CacheType     = uImageFlags & VD_IMAGE_FLAGS_FIXED
-                               ? RT_H2LE_U32(VCI_HDR_CACHE_TYPE_FIXED)
-                               : RT_H2LE_U32(VCI_HDR_CACHE_TYPE_DYNAMIC);
-        Hdr.offTreeRoot      = RT_H2LE_U64(offTreeRoot);
-        Hdr.offBlkMap        = RT_H2LE_U64(offBlkMap);
-        Hdr.cBlkMap          = RT_H2LE_U32(cBlkMap);
-
-        rc = vdIfIoIntFileWriteSync(pCache->pIfIo, pCache->pStorage, offHdr, &Hdr,
-                                    VCI_BYTE2BLOCK(sizeof(VciHdr)));
+        rc = vciHdrWrite(pCache->pIfIo, pCache->pStorage, &pCache->Hdr);
         if (RT_FAILURE(rc))
         {
             rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot write header '%s'"), pCache->pszFilename);
             break;
         }
 
-        rc = vciBlkMapSave(pCache->pBlkMap, pCache, offBlkMap, cBlkMap);
-        if (RT_FAILURE(rc))
-        {
-            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot write block map '%s'"), pCache->pszFilename);
-            break;
-        }
-
-        /* Setup the root tree. */
-        memset(&NodeRoot, 0, sizeof(VciTreeNode));
-        NodeRoot.u8Type = VCI_TREE_NODE_TYPE_LEAF;
-
-        rc = vdIfIoIntFileWriteSync(pCache->pIfIo, pCache->pStorage, offTreeRoot,
-                                    &NodeRoot, VCI_BYTE2BLOCK(sizeof(VciTreeNode)));
+        rc = vciFlushImage(pCache);
         if (RT_FAILURE(rc))
         {
-            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot write root node '%s'"), pCache->pszFilename);
+            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot flush '%s'"), pCache->pszFilename);
             break;
         }
 
-        rc = vciFlushImage(pCache);
+        rc = vciLoadImage(pCache);
         if (RT_FAILURE(rc))
         {
-            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot flush '%s'"), pCache->pszFilename);
+            rc = vdIfError(pCache->pIfError, rc, RT_SRC_POS, N_("VCI: cannot set up cache state for '%s'"), pCache->pszFilename);
             break;
         }
-
-        pCache->cbSize = cbSize;
-
     } while (0);
 
-    if (RT_SUCCESS(rc) && pfnProgress)
-        pfnProgress(pvUser, uPercentStart + uPercentSpan);
+    if (RT_SUCCESS(rc))
+        vdIfProgress(pIfProgress, uPercentStart + uPercentSpan);
 
     if (RT_FAILURE(rc))
         vciFreeImage(pCache, rc != VERR_ALREADY_EXISTS);
@@ -1470,7 +1206,6 @@ static DECLCALLBACK(int) vciProbe(const char *pszFilename, PVDINTERFACE pVDIfsDi
     RT_NOREF1(pVDIfsDisk);
     VciHdr Hdr;
     PVDIOSTORAGE pStorage = NULL;
-    uint64_t cbFile;
     int rc = VINF_SUCCESS;
 
     LogFlowFunc(("pszFilename=\"%s\"\n", pszFilename));
@@ -1482,40 +1217,11 @@ static DECLCALLBACK(int) vciProbe(const char *pszFilename, PVDINTERFACE pVDIfsDi
                            VDOpenFlagsToFileOpenFlags(VD_OPEN_FLAGS_READONLY,
                                                       false /* fCreate */),
                            &pStorage);
-    if (RT_FAILURE(rc))
-        goto out;
-
-    rc = vdIfIoIntFileGetSize(pIfIo, pStorage, &cbFile);
-    if (RT_FAILURE(rc) || cbFile < sizeof(VciHdr))
-    {
-        rc = VERR_VD_GEN_INVALID_HEADER;
-        goto out;
-    }
-
-    rc = vdIfIoIntFileReadSync(pIfIo, pStorage, 0, &Hdr, sizeof(Hdr));
-    if (RT_FAILURE(rc))
+    if (RT_SUCCESS(rc))
     {
-        rc = VERR_VD_GEN_INVALID_HEADER;
-        goto out;
-    }
-
-    Hdr.u32Signature = RT_LE2H_U32(Hdr.u32Signature);
-    Hdr.u32Version   = RT_LE2H_U32(Hdr.u32Version);
-    Hdr.cBlocksCache = RT_LE2H_U64(Hdr.cBlocksCache);
-    Hdr.u32CacheType = RT_LE2H_U32(Hdr.u32CacheType);
-    Hdr.offTreeRoot  = RT_LE2H_U64(Hdr.offTreeRoot);
-    Hdr.offBlkMap    = RT_LE2H_U64(Hdr.offBlkMap);
-    Hdr.cBlkMap      = RT_LE2H_U32(Hdr.cBlkMap);
-
-    if (   Hdr.u32Signature == VCI_HDR_SIGNATURE
-        && Hdr.u32Version == VCI_HDR_VERSION)
-        rc = VINF_SUCCESS;
-    else
-        rc = VERR_VD_GEN_INVALID_HEADER;
-
-out:
-    if (pStorage)
+        rc = vciHdrRead(pIfIo, pStorage, &Hdr);
         vdIfIoIntFileClose(pIfIo, pStorage);
+    }
 
     LogFlowFunc(("returns %Rrc\n", rc));
     return rc;
@@ -1582,14 +1288,7 @@ static DECLCALLBACK(int) vciCreate(const char *pszFilename, uint64_t cbSize,
     int rc;
     PVCICACHE pCache;
 
-    PFNVDPROGRESS pfnProgress = NULL;
-    void *pvUser = NULL;
     PVDINTERFACEPROGRESS pIfProgress = VDIfProgressGet(pVDIfsOperation);
-    if (pIfProgress)
-    {
-        pfnProgress = pIfProgress->pfnProgress;
-        pvUser = pIfProgress->Core.pvUser;
-    }
 
     /* Check open flags. All valid flags are supported. */
     if (uOpenFlags & ~VD_OPEN_FLAGS_MASK)
@@ -1618,7 +1317,7 @@ static DECLCALLBACK(int) vciCreate(const char *pszFilename, uint64_t cbSize,
     pCache->pVDIfsImage = pVDIfsImage;
 
     rc = vciCreateImage(pCache, cbSize, uImageFlags, pszComment, uOpenFlags,
-                        pfnProgress, pvUser, uPercentStart, uPercentSpan);
+                        pIfProgress, uPercentStart, uPercentSpan);
     if (RT_SUCCESS(rc))
     {
         /* So far the image is opened in read/write mode. Make sure the
@@ -1665,33 +1364,60 @@ static DECLCALLBACK(int) vciRead(void *pBackendData, uint64_t uOffset, size_t cb
                  pBackendData, uOffset, cbToRead, pIoCtx, pcbActuallyRead));
     PVCICACHE pCache = (PVCICACHE)pBackendData;
     int rc = VINF_SUCCESS;
-    PVCICACHEEXTENT pExtent;
-    uint64_t cBlocksToRead = VCI_BYTE2BLOCK(cbToRead);
-    uint64_t offBlockAddr  = VCI_BYTE2BLOCK(uOffset);
 
     AssertPtr(pCache);
     Assert(uOffset % 512 == 0);
     Assert(cbToRead % 512 == 0);
 
-    pExtent = vciCacheExtentLookup(pCache, offBlockAddr, NULL);
-    if (pExtent)
-    {
-        uint64_t offRead = offBlockAddr - pExtent->u64BlockOffset;
-        cBlocksToRead = RT_MIN(cBlocksToRead, pExtent->u32Blocks - offRead);
+    uint64_t const uLine    = uOffset / VCI_LINE_SIZE;
+    uint32_t const iSector  = (uint32_t)VCI_BYTE2BLOCK(uOffset % VCI_LINE_SIZE);
+    uint32_t       cSectors = (uint32_t)RT_MIN(VCI_BYTE2BLOCK(cbToRead), VCI_LINE_SECTORS - iSector);
 
-        rc = vdIfIoIntFileReadUser(pCache->pIfIo, pCache->pStorage,
-                                   pExtent->u64BlockAddr + offRead,
-                                   pIoCtx, cBlocksToRead);
+    RTCritSectEnter(&pCache->CritSect);
+    uint32_t const idxLine = vciLineLookup(pCache, uLine);
+    PVCILINE pLine = idxLine != UINT32_MAX ? &pCache->paLines[idxLine] : NULL;
+    if (   !pLine
+        || !(pLine->bmValid & RT_BIT_64(iSector)))
+    {
+        /* Tell the caller how much is missing, everything after might be cached. */
+        if (pLine)
+            cSectors = vciSectorRun(pLine->bmValid, iSector, cSectors, false /* fSet */);
+        pCache->cbMisses += VCI_BLOCK2BYTE(cSectors);
+        RTCritSectLeave(&pCache->CritSect);
+
+        *pcbActuallyRead = VCI_BLOCK2BYTE(cSectors);
+        LogFlowFunc(("returns VERR_VD_BLOCK_FREE\n"));
+        return VERR_VD_BLOCK_FREE;
     }
-    else
+
+    /* The line can't be dropped while we read the data without the lock. */
+    cSectors = vciSectorRun(pLine->bmValid, iSector, cSectors, true /* fSet */);
+    pLine->cPins++;
+    pLine->uLastUse = pCache->uTick++;
+    pCache->cbHits += VCI_BLOCK2BYTE(cSectors);
+    RTCritSectLeave(&pCache->CritSect);
+
+    size_t const cbRead = VCI_BLOCK2BYTE(cSectors);
+    void *pvBuf = RTMemTmpAlloc(cbRead);
+    if (pvBuf)
     {
-        /** @todo Best fit to check whether we have cached data later and set
-         * pcbActuallyRead accordingly. */
-        rc = VERR_VD_BLOCK_FREE;
+        rc = vdIfIoIntFileReadSync(pCache->pIfIo, pCache->pStorage,
+                                   pCache->offData + (uint64_t)idxLine * VCI_LINE_SIZE + VCI_BLOCK2BYTE(iSector),
+                                   pvBuf, cbRead);
+        if (RT_SUCCESS(rc))
+            vdIfIoIntIoCtxCopyTo(pCache->pIfIo, pIoCtx, pvBuf, cbRead);
+        RTMemTmpFree(pvBuf);
     }
+    else
+        rc = VERR_NO_MEMORY;
+
+    RTCritSectEnter(&pCache->CritSect);
+    Assert(pLine->cPins > 0);
+    pLine->cPins--;
+    RTCritSectLeave(&pCache->CritSect);
 
     if (pcbActuallyRead)
-        *pcbActuallyRead = VCI_BLOCK2BYTE(cBlocksToRead);
+        *pcbActuallyRead = cbRead;
 
     LogFlowFunc(("returns %Rrc\n", rc));
     return rc;
@@ -1701,23 +1427,55 @@ static DECLCALLBACK(int) vciRead(void *pBackendData, uint64_t uOffset, size_t cb
 static DECLCALLBACK(int) vciWrite(void *pBackendData, uint64_t uOffset, size_t cbToWrite,
                                   PVDIOCTX pIoCtx, size_t *pcbWriteProcess)
 {
-    RT_NOREF5(pBackendData, uOffset, cbToWrite, pIoCtx, pcbWriteProcess);
     LogFlowFunc(("pBackendData=%#p uOffset=%llu cbToWrite=%zu pIoCtx=%#p pcbWriteProcess=%#p\n",
                  pBackendData, uOffset, cbToWrite, pIoCtx, pcbWriteProcess));
     PVCICACHE pCache = (PVCICACHE)pBackendData;
     int rc = VINF_SUCCESS;
-    uint64_t cBlocksToWrite = VCI_BYTE2BLOCK(cbToWrite);
-    //uint64_t offBlockAddr  = VCI_BYTE2BLOCK(uOffset);
 
-    AssertPtr(pCache); NOREF(pCache);
+    AssertPtr(pCache);
     Assert(uOffset % 512 == 0);
     Assert(cbToWrite % 512 == 0);
-    while (cBlocksToWrite)
-    {
 
-    }
+    if (pCache->uOpenFlags & VD_OPEN_FLAGS_READONLY)
+        return VERR_VD_IMAGE_READ_ONLY;
 
-    *pcbWriteProcess = cbToWrite; /** @todo Implement. */
+    uint64_t const uLine    = uOffset / VCI_LINE_SIZE;
+    uint32_t const iSector  = (uint32_t)VCI_BYTE2BLOCK(uOffset % VCI_LINE_SIZE);
+    uint32_t const cSectors = (uint32_t)RT_MIN(VCI_BYTE2BLOCK(cbToWrite), VCI_LINE_SECTORS - iSector);
+
+    RTCritSectEnter(&pCache->CritSect);
+    uint32_t idxLine = vciLineLookup(pCache, uLine);
+    if (idxLine == UINT32_MAX)
+        idxLine = vciLineAlloc(pCache, uLine);
+    if (idxLine != UINT32_MAX)
+    {
+        /* Data goes to the medium before the metadata is updated. */
+        size_t const cbWrite = VCI_BLOCK2BYTE(cSectors);
+        vdIfIoIntIoCtxCopyFrom(pCache->pIfIo, pIoCtx, pCache->pbBounce, cbWrite);
+        rc = vciLineWriteData(pCache, idxLine, iSector, pCache->pbBounce, cSectors);
+        if (RT_SUCCESS(rc))
+        {
+            PVCILINE pLine = &pCache->paLines[idxLine];
+            uint64_t const bmDirtyOld = pLine->bmDirty;
+            uint64_t const fMask = vciSectorMask(iSector, cSectors);
+
+            pLine->bmValid |= fMask;
+            pLine->bmDirty |= fMask;
+            pLine->uGen++;
+            pLine->uLastUse = pCache->uTick++;
+            vciLineModified(pCache, idxLine);
+            vciLineDirtyUpdate(pCache, idxLine, bmDirtyOld);
+        }
+        *pcbWriteProcess = cbWrite;
+    }
+    else
+    {
+        /* No room, the data goes to the image. */
+        vciSetWrittenAround(pCache, uLine);
+        *pcbWriteProcess = VCI_BLOCK2BYTE(cSectors);
+        rc = VERR_VD_BLOCK_FREE;
+    }
+    RTCritSectLeave(&pCache->CritSect);
 
     LogFlowFunc(("returns %Rrc\n", rc));
     return rc;
@@ -1729,12 +1487,265 @@ static DECLCALLBACK(int) vciFlush(void *pBackendData, PVDIOCTX pIoCtx)
     RT_NOREF1(pIoCtx);
     LogFlowFunc(("pBackendData=%#p\n", pBackendData));
     PVCICACHE pCache = (PVCICACHE)pBackendData;
+    int rc = VINF_SUCCESS;
+
+    if (!(pCache->uOpenFlags & VD_OPEN_FLAGS_READONLY))
+    {
+        RTCritSectEnter(&pCache->CritSect);
+        rc = vciCommit(pCache);
+        RTCritSectLeave(&pCache->CritSect);
+    }
+
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+/** @copydoc VDCACHEBACKEND::pfnFill */
+static DECLCALLBACK(int) vciFill(void *pBackendData, uint64_t uOffset, const void *pvBuf,
+                                 size_t cbFill, uint32_t fFill, uint64_t uToken)
+{
+    LogFlowFunc(("pBackendData=%#p uOffset=%llu pvBuf=%#p cbFill=%zu fFill=%#x uToken=%llu\n",
+                 pBackendData, uOffset, pvBuf, cbFill, fFill, uToken));
+    PVCICACHE pCache = (PVCICACHE)pBackendData;
+    const uint8_t *pbBuf = (const uint8_t *)pvBuf;
+    int rc = VINF_SUCCESS;
+
+    AssertPtr(pCache);
+    AssertReturn(!(uOffset % 512) && !(cbFill % 512), VERR_INVALID_PARAMETER);
+    AssertReturn(!(fFill & ~VD_CACHE_FILL_F_VALID_MASK), VERR_INVALID_FLAGS);
+
+    if (pCache->uOpenFlags & VD_OPEN_FLAGS_READONLY)
+        return VERR_VD_IMAGE_READ_ONLY;
+
+    RTCritSectEnter(&pCache->CritSect);
+    while (   cbFill
+           && RT_SUCCESS(rc))
+    {
+        uint64_t const uLine    = uOffset / VCI_LINE_SIZE;
+        uint32_t const iSector  = (uint32_t)VCI_BYTE2BLOCK(uOffset % VCI_LINE_SIZE);
+        uint32_t const cSectors = (uint32_t)RT_MIN(VCI_BYTE2BLOCK(cbFill), VCI_LINE_SECTORS - iSector);
+
+        uint32_t idxLine = vciLineLookup(pCache, uLine);
+        if (fFill & VD_CACHE_FILL_F_OVERWRITE)
+        {
+            /* Update what is cached, the image has the data anyway. */
+            if (idxLine != UINT32_MAX)
+            {
+                rc = vciLineWriteData(pCache, idxLine, iSector, pbBuf, cSectors);
+                if (RT_SUCCESS(rc))
+                {
+                    PVCILINE pLine = &pCache->paLines[idxLine];
+                    uint64_t const fMask = vciSectorMask(iSector, cSectors);
+
+                    /* Dirty sectors stay dirty so a concurrent write back doesn't
+                     * mark them clean with the old data. */
+                    if (pLine->bmDirty & fMask)
+                        pLine->uGen++;
+                    if ((pLine->bmValid & fMask) != fMask)
+                    {
+                        pLine->bmValid |= fMask;
+                        vciLineModified(pCache, idxLine);
+                    }
+                }
+            }
+            else
+                vciSetWrittenAround(pCache, uLine);
+        }
+        else if (pCache->pauSetSeqUncached[vciLineToSet(pCache, uLine)] <= uToken)
+        {
+            /* Only fill what isn't cached, it might be newer than the data read from the image. */
+            if (idxLine == UINT32_MAX)
+                idxLine = vciLineAlloc(pCache, uLine);
+            if (idxLine != UINT32_MAX)
+            {
+                PVCILINE pLine = &pCache->paLines[idxLine];
+                uint32_t iSectorCur = iSector;
+                while (   iSectorCur < iSector + cSectors
+                       && RT_SUCCESS(rc))
+                {
+                    uint32_t const cRunMax = iSector + cSectors - iSectorCur;
+                    uint32_t cRun = vciSectorRun(pLine->bmValid, iSectorCur, cRunMax, true /* fSet */);
+                    if (!cRun)
+                    {
+                        cRun = vciSectorRun(pLine->bmValid, iSectorCur, cRunMax, false /* fSet */);
+                        rc = vciLineWriteData(pCache, idxLine, iSectorCur,
+                                              pbBuf + VCI_BLOCK2BYTE(iSectorCur - iSector), cRun);
+                        if (RT_SUCCESS(rc))
+                        {
+                            pLine->bmValid |= vciSectorMask(iSectorCur, cRun);
+                            vciLineModified(pCache, idxLine);
+                        }
+                    }
+                    iSectorCur += cRun;
+                }
+                pLine->uLastUse = pCache->uTick++;
+            }
+        }
+
+        uOffset += VCI_BLOCK2BYTE(cSectors);
+        pbBuf   += VCI_BLOCK2BYTE(cSectors);
+        cbFill  -= VCI_BLOCK2BYTE(cSectors);
+    }
+    RTCritSectLeave(&pCache->CritSect);
 
-    int rc = vciFlushImage(pCache);
     LogFlowFunc(("returns %Rrc\n", rc));
     return rc;
 }
 
+/** @copydoc VDCACHEBACKEND::pfnQueryFillToken */
+static DECLCALLBACK(uint64_t) vciQueryFillToken(void *pBackendData)
+{
+    PVCICACHE pCache = (PVCICACHE)pBackendData;
+    AssertPtr(pCache);
+
+    RTCritSectEnter(&pCache->CritSect);
+    uint64_t const uToken = pCache->uSeqUncached;
+    RTCritSectLeave(&pCache->CritSect);
+    return uToken;
+}
+
+/** @copydoc VDCACHEBACKEND::pfnQueryDirty */
+static DECLCALLBACK(int) vciQueryDirty(void *pBackendData, uint64_t *puCursor, uint64_t *puOffset,
+                                       void *pvBuf, size_t cbBuf, size_t *pcbDirty, uint32_t *puGen)
+{
+    PVCICACHE pCache = (PVCICACHE)pBackendData;
+    int rc = VERR_NOT_FOUND;
+
+    AssertPtr(pCache);
+    AssertReturn(cbBuf >= VCI_LINE_SIZE, VERR_BUFFER_OVERFLOW);
+
+    /* The cursor is the line index and the sector to continue at. */
+    uint64_t uCursor = *puCursor;
+    RTCritSectEnter(&pCache->CritSect);
+    while (uCursor < (uint64_t)pCache->cLines * VCI_LINE_SECTORS)
+    {
+        uint32_t idxLine = (uint32_t)(uCursor / VCI_LINE_SECTORS);
+        uint32_t iSector = (uint32_t)(uCursor % VCI_LINE_SECTORS);
+
+        if (!ASMBitTest(pCache->pbmLinesDirty, (int32_t)idxLine))
+        {
+            int32_t iNext = ASMBitNextSet(pCache->pbmLinesDirty, RT_ALIGN_32(pCache->cLines, 64), idxLine);
+            if (iNext < 0)
+                break;
+            idxLine = (uint32_t)iNext;
+            iSector = 0;
+        }
+
+        PVCILINE pLine = &pCache->paLines[idxLine];
+        uint64_t const bmDirty = pLine->bmDirty & ~(iSector ? RT_BIT_64(iSector) - 1 : 0);
+        if (!bmDirty)
+        {
+            uCursor = (uint64_t)(idxLine + 1) * VCI_LINE_SECTORS;
+            continue;
+        }
+
+        iSector = ASMBitFirstSetU64(bmDirty) - 1;
+        uint32_t const cSectors = vciSectorRun(pLine->bmDirty, iSector, VCI_LINE_SECTORS - iSector, true /* fSet */);
+
+        rc = vdIfIoIntFileReadSync(pCache->pIfIo, pCache->pStorage,
+                                   pCache->offData + (uint64_t)idxLine * VCI_LINE_SIZE + VCI_BLOCK2BYTE(iSector),
+                                   pvBuf, VCI_BLOCK2BYTE(cSectors));
+        if (RT_SUCCESS(rc))
+        {
+            *puOffset = (pLine->uTag - 1) * VCI_LINE_SIZE + VCI_BLOCK2BYTE(iSector);
+            *pcbDirty = VCI_BLOCK2BYTE(cSectors);
+            *puGen    = pLine->uGen;
+        }
+        uCursor = (uint64_t)idxLine * VCI_LINE_SECTORS + iSector + cSectors;
+        break;
+    }
+    RTCritSectLeave(&pCache->CritSect);
+
+    *puCursor = uCursor;
+    return rc;
+}
+
+/** @copydoc VDCACHEBACKEND::pfnMarkClean */
+static DECLCALLBACK(int) vciMarkClean(void *pBackendData, uint64_t uOffset, size_t cbClean, uint32_t uGen)
+{
+    PVCICACHE pCache = (PVCICACHE)pBackendData;
+    AssertPtr(pCache);
+
+    uint64_t const uLine    = uOffset / VCI_LINE_SIZE;
+    uint32_t const iSector  = (uint32_t)VCI_BYTE2BLOCK(uOffset % VCI_LINE_SIZE);
+    AssertReturn(VCI_BYTE2BLOCK(cbClean) + iSector <= VCI_LINE_SECTORS && cbClean, VERR_INVALID_PARAMETER);
+    uint32_t const cSectors = (uint32_t)VCI_BYTE2BLOCK(cbClean);
+
+    RTCritSectEnter(&pCache->CritSect);
+    uint32_t const idxLine = vciLineLookup(pCache, uLine);
+    if (idxLine != UINT32_MAX)
+    {
+        PVCILINE pLine = &pCache->paLines[idxLine];
+        if (pLine->uGen == uGen)
+        {
+            uint64_t const bmDirtyOld = pLine->bmDirty;
+            pLine->bmDirty &= ~vciSectorMask(iSector, cSectors);
+            if (pLine->bmDirty != bmDirtyOld)
+            {
+                vciLineModified(pCache, idxLine);
+                vciLineDirtyUpdate(pCache, idxLine, bmDirtyOld);
+            }
+        }
+    }
+    RTCritSectLeave(&pCache->CritSect);
+
+    return VINF_SUCCESS;
+}
+
+/** @copydoc VDCACHEBACKEND::pfnGetDirtySize */
+static DECLCALLBACK(uint64_t) vciGetDirtySize(void *pBackendData)
+{
+    PVCICACHE pCache = (PVCICACHE)pBackendData;
+    AssertPtr(pCache);
+
+    RTCritSectEnter(&pCache->CritSect);
+    uint64_t const cbDirty = VCI_BLOCK2BYTE(pCache->cSectorsDirty);
+    RTCritSectLeave(&pCache->CritSect);
+    return cbDirty;
+}
+
+/** @copydoc VDCACHEBACKEND::pfnInvalidate */
+static DECLCALLBACK(int) vciInvalidate(void *pBackendData, uint64_t uOffset, size_t cbInvalidate)
+{
+    LogFlowFunc(("pBackendData=%#p uOffset=%llu cbInvalidate=%zu\n", pBackendData, uOffset, cbInvalidate));
+    PVCICACHE pCache = (PVCICACHE)pBackendData;
+    AssertPtr(pCache);
+
+    /* Only whole sectors can be tracked, partial ones are dropped completely. */
+    uint64_t offEnd = RT_ALIGN_64(uOffset + cbInvalidate, VCI_BLOCK_SIZE);
+    uOffset &= ~(uint64_t)(VCI_BLOCK_SIZE - 1);
+
+    RTCritSectEnter(&pCache->CritSect);
+    while (uOffset < offEnd)
+    {
+        uint64_t const uLine    = uOffset / VCI_LINE_SIZE;
+        uint32_t const iSector  = (uint32_t)VCI_BYTE2BLOCK(uOffset % VCI_LINE_SIZE);
+        uint32_t const cSectors = (uint32_t)RT_MIN(VCI_BYTE2BLOCK(offEnd - uOffset), VCI_LINE_SECTORS - iSector);
+
+        uint32_t const idxLine = vciLineLookup(pCache, uLine);
+        if (idxLine != UINT32_MAX)
+        {
+            PVCILINE pLine = &pCache->paLines[idxLine];
+            uint64_t const fMask = vciSectorMask(iSector, cSectors);
+            if (pLine->bmValid & fMask)
+            {
+                uint64_t const bmDirtyOld = pLine->bmDirty;
+                pLine->bmValid &= ~fMask;
+                pLine->bmDirty &= ~fMask;
+                pLine->uGen++;
+                vciLineModified(pCache, idxLine);
+                vciLineDirtyUpdate(pCache, idxLine, bmDirtyOld);
+            }
+        }
+        vciSetWrittenAround(pCache, uLine);
+
+        uOffset += VCI_BLOCK2BYTE(cSectors);
+    }
+    RTCritSectLeave(&pCache->CritSect);
+
+    return VINF_SUCCESS;
+}
+
 /** @copydoc VDCACHEBACKEND::pfnGetVersion */
 static DECLCALLBACK(unsigned) vciGetVersion(void *pBackendData)
 {
@@ -1744,7 +1755,7 @@ static DECLCALLBACK(unsigned) vciGetVersion(void *pBackendData)
     AssertPtr(pCache);
 
     if (pCache)
-        return 1;
+        return VCI_HDR_VERSION;
     else
         return 0;
 }
@@ -1942,7 +1953,6 @@ static DECLCALLBACK(int) vciSetUuid(void *pBackendData, PCRTUUID pUuid)
 /** @copydoc VDCACHEBACKEND::pfnGetModificationUuid */
 static DECLCALLBACK(int) vciGetModificationUuid(void *pBackendData, PRTUUID pUuid)
 {
-    RT_NOREF1(pUuid);
     LogFlowFunc(("pBackendData=%#p pUuid=%#p\n", pBackendData, pUuid));
     PVCICACHE pCache = (PVCICACHE)pBackendData;
     int rc;
@@ -1950,7 +1960,12 @@ static DECLCALLBACK(int) vciGetModificationUuid(void *pBackendData, PRTUUID pUui
     AssertPtr(pCache);
 
     if (pCache)
-        rc = VERR_NOT_SUPPORTED;
+    {
+        RTCritSectEnter(&pCache->CritSect);
+        *pUuid = pCache->Hdr.uuidModification;
+        RTCritSectLeave(&pCache->CritSect);
+        rc = VINF_SUCCESS;
+    }
     else
         rc = VERR_VD_NOT_OPENED;
 
@@ -1961,7 +1976,6 @@ static DECLCALLBACK(int) vciGetModificationUuid(void *pBackendData, PRTUUID pUui
 /** @copydoc VDCACHEBACKEND::pfnSetModificationUuid */
 static DECLCALLBACK(int) vciSetModificationUuid(void *pBackendData, PCRTUUID pUuid)
 {
-    RT_NOREF1(pUuid);
     LogFlowFunc(("pBackendData=%#p Uuid=%RTuuid\n", pBackendData, pUuid));
     PVCICACHE pCache = (PVCICACHE)pBackendData;
     int rc;
@@ -1971,7 +1985,14 @@ static DECLCALLBACK(int) vciSetModificationUuid(void *pBackendData, PCRTUUID pUu
     if (pCache)
     {
         if (!(pCache->uOpenFlags & VD_OPEN_FLAGS_READONLY))
-            rc = VERR_NOT_SUPPORTED;
+        {
+            /* Persisted with the next commit. */
+            RTCritSectEnter(&pCache->CritSect);
+            pCache->Hdr.uuidModification = *pUuid;
+            pCache->fHdrDirty = true;
+            RTCritSectLeave(&pCache->CritSect);
+            rc = VINF_SUCCESS;
+        }
         else
             rc = VERR_VD_IMAGE_READ_ONLY;
     }
@@ -1985,7 +2006,20 @@ static DECLCALLBACK(int) vciSetModificationUuid(void *pBackendData, PCRTUUID pUu
 /** @copydoc VDCACHEBACKEND::pfnDump */
 static DECLCALLBACK(void) vciDump(void *pBackendData)
 {
-    NOREF(pBackendData);
+    PVCICACHE pCache = (PVCICACHE)pBackendData;
+
+    AssertPtr(pCache);
+    if (!pCache)
+        return;
+
+    vdIfErrorMessage(pCache->pIfError, "Header: Version=%#x cLines=%u cbLine=%u cWays=%u Type=%#x Unclean=%u\n",
+                     pCache->Hdr.u32Version, pCache->cLines, pCache->Hdr.cbLine, pCache->Hdr.cWays,
+                     pCache->Hdr.u32CacheType, pCache->Hdr.fUncleanShutdown);
+    vdIfErrorMessage(pCache->pIfError, "Header: LineTbl=%u LogSeqBase=%llu LogSeqNext=%llu cLogPages=%u offData=%llu\n",
+                     pCache->Hdr.idxLineTbl, pCache->Hdr.u64LogSeqBase, pCache->uLogSeqNext,
+                     pCache->cLogPages, pCache->offData);
+    vdIfErrorMessage(pCache->pIfError, "State: cbDirty=%llu cModified=%u cbHits=%llu cbMisses=%llu\n",
+                     VCI_BLOCK2BYTE(pCache->cSectorsDirty), pCache->cModified, pCache->cbHits, pCache->cbMisses);
 }
 
 
@@ -2047,7 +2081,18 @@ const VDCACHEBACKEND g_VciCacheBackend =
     NULL,
     /* pfnComposeName */
     NULL,
+    /* pfnFill */
+    vciFill,
+    /* pfnQueryFillToken */
+    vciQueryFillToken,
+    /* pfnQueryDirty */
+    vciQueryDirty,
+    /* pfnMarkClean */
+    vciMarkClean,
+    /* pfnGetDirtySize */
+    vciGetDirtySize,
+    /* pfnInvalidate */
+    vciInvalidate,
     /* u32VersionEnd */
     VD_CACHEBACKEND_VERSION
 };
-
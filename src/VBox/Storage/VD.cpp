@@ -41,16 +41,21 @@
 #include <iprt/file.h>
 #include <iprt/string.h>
 #include <iprt/asm.h>
+#include <iprt/crc.h>
 #include <iprt/param.h>
 #include <iprt/path.h>
 #include <iprt/sg.h>
 #include <iprt/semaphore.h>
+#include <iprt/time.h>
 #include <iprt/vector.h>
 
 #include "VDInternal.h"
 
 /** Buffer size used for merging images. */
 #define VD_MERGE_BUFFER_SIZE    (16 * _1M)
+/** Chunk size used for merging images with a rate limit, keeping the time
+ * the disk lock is held short. */
+#define VD_MERGE_CHUNK_SIZE_LIMITED  _1M
 
 /** Maximum number of segments in one I/O task. */
 #define VD_IO_TASK_SEGMENTS_MAX 64
@@ -58,6 +63,19 @@
 /** Threshold after not recently used blocks are removed from the list. */
 #define VD_DISCARD_REMOVE_THRESHOLD (10 * _1M) /** @todo experiment */
 
+/** Size of the buffer for transfers between the cache and the image. */
+#define VD_CACHE_IO_BUFFER_SIZE     _64K
+/** Maximum size of a range queued for promotion into the cache. */
+#define VD_CACHE_PROMOTE_RANGE_MAX  _1M
+/** Number of ranges written back before the image is flushed and the ranges are marked clean. */
+#define VD_CACHE_WRITEBACK_BATCH    64
+/** Amount of dirty data the background thread writes back in one go. */
+#define VD_CACHE_WRITEBACK_CHUNK    (4 * _1M)
+/** Interval of the cache background thread in milliseconds when idle. */
+#define VD_CACHE_THREAD_INTERVAL_MS 1000
+/** Size of the shared zero buffer write zeroes requests are sourced from. */
+#define VD_WRITE_ZEROES_CHUNK_SIZE  _64K
+
 /**
  * VD async I/O interface storage descriptor.
  */
@@ -271,6 +289,17 @@ typedef struct VDIOCTX
  * multiple times.
  */
 #define VDIOCTX_FLAGS_WRITE_FILTER_APPLIED   RT_BIT_32(6)
+/** The write goes to the image directly even if the cache is in write-back
+ * mode, used for writing back dirty data from the cache. */
+#define VDIOCTX_FLAGS_CACHE_BYPASS           RT_BIT_32(7)
+/** The read is subject to the sequential stream detection and may be served
+ * from the read-ahead buffers, cleared once this was done. */
+#define VDIOCTX_FLAGS_READ_AHEAD             RT_BIT_32(8)
+/** The read is a prefetch of the read-ahead logic. */
+#define VDIOCTX_FLAGS_PREFETCH               RT_BIT_32(9)
+/** The write copies parent data for the background stream operation and fails
+ * with VERR_TRY_AGAIN if the range was written since it was probed. */
+#define VDIOCTX_FLAGS_STREAM                 RT_BIT_32(10)
 
 /** NIL I/O context pointer value. */
 #define NIL_VDIOCTX ((PVDIOCTX)0)
@@ -338,6 +367,12 @@ typedef struct VDIOSTORAGE
     PAVLRFOFFTREE                pTreeMetaXfers;
     /** Storage handle */
     void                        *pStorage;
+    /** CRC64 of the location, part of the shared read cache name. */
+    uint64_t                     uLocationCrc;
+    /** The shared read cache, opened on the first read if enabled for the image. */
+    PVDSHAREDCACHE volatile      pSharedCache;
+    /** Flag whether opening the shared read cache failed. */
+    bool volatile                fSharedCacheFailed;
 } VDIOSTORAGE;
 
 /**
@@ -387,9 +422,17 @@ typedef struct VDMETAXFER
 /** Forward declaration of the async discard helper. */
 static DECLCALLBACK(int) vdDiscardHelperAsync(PVDIOCTX pIoCtx);
 static DECLCALLBACK(int) vdWriteHelperAsync(PVDIOCTX pIoCtx);
+static DECLCALLBACK(int) vdFlushHelperAsync(PVDIOCTX pIoCtx);
 static void vdDiskProcessBlockedIoCtx(PVDISK pDisk);
 static int vdDiskUnlock(PVDISK pDisk, PVDIOCTX pIoCtxRc);
 static DECLCALLBACK(void) vdIoCtxSyncComplete(void *pvUser1, void *pvUser2, int rcReq);
+static DECLCALLBACK(int) vdReadHelperAsync(PVDIOCTX pIoCtx);
+static void vdReadAheadInvalidate(PVDISK pDisk, uint64_t uOffset, uint64_t cbRange);
+static void vdReadAheadQuiesce(PVDISK pDisk);
+static void vdStreamStop(PVDISK pDisk);
+
+/** Shared zero buffer used as the data source for write zeroes requests, never written to. */
+RT_ALIGNAS_VAR(_4K) static uint8_t g_abVdZeroes[VD_WRITE_ZEROES_CHUNK_SIZE];
 
 /**
  * internal: issue error message.
@@ -449,11 +492,191 @@ DECLINLINE(int) vdThreadFinishWrite(PVDISK pDisk)
     return rc;
 }
 
+/**
+ * internal: destroys the block ownership index of the disk, if any.
+ *
+ * Must be called whenever the image chain changes, the index is rebuilt
+ * lazily by the next read.
+ */
+static void vdOwnerIdxDestroy(PVDISK pDisk)
+{
+    PVDOWNERIDX pOwnerIdx = pDisk->pOwnerIdx;
+    if (pOwnerIdx)
+    {
+        pDisk->pOwnerIdx = NULL;
+        for (uint32_t i = 0; i < pOwnerIdx->cChunks; i++)
+            if (pOwnerIdx->papbChunks[i])
+                RTMemFree(pOwnerIdx->papbChunks[i]);
+        RTMemFree(pOwnerIdx->papbChunks);
+        RTMemFree(pOwnerIdx);
+    }
+}
+
+/**
+ * internal: returns the block ownership index for a read, creating it if required.
+ *
+ * @returns Pointer to the index or NULL if the read can't make use of it.
+ * @param   pDisk       The disk.
+ * @param   pIoCtx      The read I/O context.
+ * @param   pImageCur   The image the read starts at.
+ */
+static PVDOWNERIDX vdOwnerIdxGetForRead(PVDISK pDisk, PVDIOCTX pIoCtx, PVDIMAGE pImageCur)
+{
+    /* Only plain reads through the whole chain can use the index. */
+    if (   pDisk->cImages < 2
+        || pDisk->cImages > VD_OWNERIDX_IMAGES_MAX
+        || pImageCur != pDisk->pLast
+        || pIoCtx->Req.Io.pImageStart != pDisk->pLast
+        || pIoCtx->Req.Io.pImageParentOverride
+        || pIoCtx->Req.Io.cImagesRead != 0)
+        return NULL;
+
+    PVDOWNERIDX pOwnerIdx = pDisk->pOwnerIdx;
+    if (RT_LIKELY(pOwnerIdx))
+        return pOwnerIdx;
+
+    uint64_t cGranules = RT_ALIGN_64(pDisk->cbSize, VD_OWNERIDX_GRANULE_SIZE) >> VD_OWNERIDX_GRANULE_SHIFT;
+    uint64_t cChunks   = RT_ALIGN_64(cGranules, VD_OWNERIDX_CHUNK_GRANULES) >> VD_OWNERIDX_CHUNK_SHIFT;
+    if (!cChunks || cChunks > UINT32_MAX)
+        return NULL;
+
+    pOwnerIdx = (PVDOWNERIDX)RTMemAllocZ(sizeof(VDOWNERIDX));
+    if (!pOwnerIdx)
+        return NULL;
+    pOwnerIdx->papbChunks = (uint8_t **)RTMemAllocZ((size_t)cChunks * sizeof(uint8_t *));
+    if (!pOwnerIdx->papbChunks)
+    {
+        RTMemFree(pOwnerIdx);
+        return NULL;
+    }
+
+    pOwnerIdx->cImages = pDisk->cImages;
+    pOwnerIdx->cChunks = (uint32_t)cChunks;
+    unsigned i = 0;
+    for (PVDIMAGE pImage = pDisk->pBase; pImage; pImage = pImage->pNext)
+        pOwnerIdx->apImages[i++] = pImage;
+    Assert(i == pDisk->cImages);
+
+    LogFlowFunc(("Created block ownership index for %u images, %u chunks\n",
+                 pOwnerIdx->cImages, pOwnerIdx->cChunks));
+    pDisk->pOwnerIdx = pOwnerIdx;
+    return pOwnerIdx;
+}
+
+/**
+ * internal: looks up the owner of the given range in the ownership index.
+ *
+ * @returns Owner entry of the first granule, VD_OWNERIDX_UNKNOWN if the owner
+ *          isn't known or the range isn't granule aligned.
+ * @param   pOwnerIdx   The ownership index.
+ * @param   uOffset     Start offset of the range.
+ * @param   pcbRange    On input the size of the range, on output the size of
+ *                      the leading part with the same owner.
+ */
+static uint8_t vdOwnerIdxLookup(PVDOWNERIDX pOwnerIdx, uint64_t uOffset, size_t *pcbRange)
+{
+    size_t cbRange = *pcbRange;
+    if (   (uOffset & (VD_OWNERIDX_GRANULE_SIZE - 1))
+        || cbRange < VD_OWNERIDX_GRANULE_SIZE)
+        return VD_OWNERIDX_UNKNOWN;
+
+    uint64_t idxGranule = uOffset >> VD_OWNERIDX_GRANULE_SHIFT;
+    uint64_t cGranules  = cbRange >> VD_OWNERIDX_GRANULE_SHIFT;
+    uint64_t idxChunk   = idxGranule >> VD_OWNERIDX_CHUNK_SHIFT;
+    if (   idxChunk >= pOwnerIdx->cChunks
+        || !pOwnerIdx->papbChunks[idxChunk])
+        return VD_OWNERIDX_UNKNOWN;
+
+    uint8_t const *pbChunk = pOwnerIdx->papbChunks[idxChunk];
+    uint32_t idxInChunk    = (uint32_t)(idxGranule & (VD_OWNERIDX_CHUNK_GRANULES - 1));
+    uint8_t const idOwner  = pbChunk[idxInChunk];
+    if (idOwner == VD_OWNERIDX_UNKNOWN)
+        return VD_OWNERIDX_UNKNOWN;
+
+    /* Collect the run of granules with the same owner, staying inside the chunk. */
+    uint64_t cRun = 1;
+    while (   cRun < cGranules
+           && idxInChunk + cRun < VD_OWNERIDX_CHUNK_GRANULES
+           && pbChunk[idxInChunk + cRun] == idOwner)
+        cRun++;
+
+    *pcbRange = (size_t)(cRun << VD_OWNERIDX_GRANULE_SHIFT);
+    return idOwner;
+}
+
+/**
+ * internal: sets the owner of all granules touched by the given range.
+ *
+ * @param   pOwnerIdx   The ownership index.
+ * @param   uOffset     Start offset of the range.
+ * @param   cbRange     Size of the range.
+ * @param   idOwner     The owner to set for granules fully covered by the range.
+ * @param   fPartial    Flag whether partially covered granules are to be set
+ *                      to unknown unless already owned by @a idOwner.
+ */
+static void vdOwnerIdxSet(PVDOWNERIDX pOwnerIdx, uint64_t uOffset, size_t cbRange,
+                          uint8_t idOwner, bool fPartial)
+{
+    uint64_t const uEnd      = uOffset + cbRange;
+    uint64_t       idxFirst  = uOffset >> VD_OWNERIDX_GRANULE_SHIFT;
+    uint64_t const idxEnd    = RT_ALIGN_64(uEnd, VD_OWNERIDX_GRANULE_SIZE) >> VD_OWNERIDX_GRANULE_SHIFT;
+    uint64_t const idxFullFirst = RT_ALIGN_64(uOffset, VD_OWNERIDX_GRANULE_SIZE) >> VD_OWNERIDX_GRANULE_SHIFT;
+    uint64_t const idxFullEnd   = uEnd >> VD_OWNERIDX_GRANULE_SHIFT;
+
+    for (uint64_t idxGranule = idxFirst; idxGranule < idxEnd; idxGranule++)
+    {
+        bool const fFull   = idxGranule >= idxFullFirst && idxGranule < idxFullEnd;
+        uint64_t idxChunk  = idxGranule >> VD_OWNERIDX_CHUNK_SHIFT;
+        if (idxChunk >= pOwnerIdx->cChunks)
+            break;
+
+        uint8_t *pbChunk = pOwnerIdx->papbChunks[idxChunk];
+        if (!pbChunk)
+        {
+            /* Nothing to invalidate in a chunk which doesn't exist yet. */
+            if (!fFull || idOwner == VD_OWNERIDX_UNKNOWN)
+                continue;
+            pbChunk = (uint8_t *)RTMemAllocZ(VD_OWNERIDX_CHUNK_GRANULES);
+            if (!pbChunk)
+                continue;
+            pOwnerIdx->papbChunks[idxChunk] = pbChunk;
+        }
+
+        uint8_t *pbEntry = &pbChunk[idxGranule & (VD_OWNERIDX_CHUNK_GRANULES - 1)];
+        if (fFull)
+            *pbEntry = idOwner;
+        else if (fPartial && *pbEntry != idOwner)
+            *pbEntry = VD_OWNERIDX_UNKNOWN;
+    }
+}
+
+/**
+ * internal: updates the ownership index for a write to the given image.
+ *
+ * @param   pDisk       The disk.
+ * @param   pImage      The image written to.
+ * @param   uOffset     Start offset of the write.
+ * @param   cbWrite     Size of the write.
+ */
+static void vdOwnerIdxWrite(PVDISK pDisk, PVDIMAGE pImage, uint64_t uOffset, size_t cbWrite)
+{
+    PVDOWNERIDX pOwnerIdx = pDisk->pOwnerIdx;
+    if (RT_LIKELY(!pOwnerIdx))
+        return;
+
+    if (pImage == pDisk->pLast)
+        vdOwnerIdxSet(pOwnerIdx, uOffset, cbWrite, (uint8_t)pOwnerIdx->cImages, true /*fPartial*/);
+    else /* Writes below the top image (merges, relays) make the range unknown. */
+        vdOwnerIdxSet(pOwnerIdx, uOffset, cbWrite, VD_OWNERIDX_UNKNOWN, true /*fPartial*/);
+}
+
 /**
  * internal: add image structure to the end of images list.
  */
 static void vdAddImageToList(PVDISK pDisk, PVDIMAGE pImage)
 {
+    vdStreamStop(pDisk);
+
     pImage->pPrev = NULL;
     pImage->pNext = NULL;
 
@@ -472,6 +695,8 @@ static void vdAddImageToList(PVDISK pDisk, PVDIMAGE pImage)
     }
 
     pDisk->cImages++;
+    vdOwnerIdxDestroy(pDisk);
+    vdReadAheadQuiesce(pDisk);
 }
 
 /**
@@ -480,6 +705,7 @@ static void vdAddImageToList(PVDISK pDisk, PVDIMAGE pImage)
 static void vdRemoveImageFromList(PVDISK pDisk, PVDIMAGE pImage)
 {
     Assert(pDisk->cImages > 0);
+    vdStreamStop(pDisk);
 
     if (pImage->pPrev)
         pImage->pPrev->pNext = pImage->pNext;
@@ -495,6 +721,8 @@ static void vdRemoveImageFromList(PVDISK pDisk, PVDIMAGE pImage)
     pImage->pNext = NULL;
 
     pDisk->cImages--;
+    vdOwnerIdxDestroy(pDisk);
+    vdReadAheadQuiesce(pDisk);
 }
 
 /**
@@ -702,8 +930,10 @@ static int vdFilterChainApplyRead(PVDISK pDisk, uint64_t uOffset, size_t cbRead,
 
 DECLINLINE(void) vdIoCtxRootComplete(PVDISK pDisk, PVDIOCTX pIoCtx)
 {
+    /* Prefetched data is kept unfiltered, the filters are applied when it is handed out. */
     if (   RT_SUCCESS(pIoCtx->rcReq)
-        && pIoCtx->enmTxDir == VDIOCTXTXDIR_READ)
+        && pIoCtx->enmTxDir == VDIOCTXTXDIR_READ
+        && !(pIoCtx->fFlags & VDIOCTX_FLAGS_PREFETCH))
         pIoCtx->rcReq = vdFilterChainApplyRead(pDisk, pIoCtx->Req.Io.uOffsetXferOrig,
                                                pIoCtx->Req.Io.cbXferOrig, pIoCtx);
 
@@ -830,6 +1060,83 @@ static int vdCacheWriteHelper(PVDCACHE pCache, uint64_t uOffset, size_t cbWrite,
     return rc;
 }
 
+/**
+ * Internal: Queues a range which missed the cache on a read to be added to the
+ * cache by the background thread.
+ *
+ * @param   pCache     The cache.
+ * @param   uOffset    Start offset of the range.
+ * @param   cbRange    Size of the range in bytes.
+ */
+static void vdCachePromoteQueue(PVDCACHE pCache, uint64_t uOffset, size_t cbRange)
+{
+    if (pCache->hThread == NIL_RTTHREAD)
+        return;
+
+    RTSemFastMutexRequest(pCache->hMtxPromote);
+    uint32_t const idxPrev = (pCache->idxPromoteHead + VD_CACHE_PROMOTE_QUEUE_SIZE - 1) % VD_CACHE_PROMOTE_QUEUE_SIZE;
+    uint32_t const idxNext = (pCache->idxPromoteHead + 1) % VD_CACHE_PROMOTE_QUEUE_SIZE;
+    if (   pCache->idxPromoteHead != pCache->idxPromoteTail
+        && pCache->aPromote[idxPrev].uOffset + pCache->aPromote[idxPrev].cbRange == uOffset
+        && pCache->aPromote[idxPrev].cbRange + cbRange <= VD_CACHE_PROMOTE_RANGE_MAX)
+        pCache->aPromote[idxPrev].cbRange += cbRange; /* Sequential read, extend the previous range. */
+    else if (idxNext != pCache->idxPromoteTail)
+    {
+        pCache->aPromote[pCache->idxPromoteHead].uOffset = uOffset;
+        pCache->aPromote[pCache->idxPromoteHead].cbRange = cbRange;
+        pCache->idxPromoteHead = idxNext;
+    }
+    /* else: The background thread can't keep up, drop the range. */
+    RTSemFastMutexRelease(pCache->hMtxPromote);
+
+    if (!ASMAtomicXchgBool(&pCache->fWorkPending, true))
+        RTSemEventSignal(pCache->hEvtThread);
+}
+
+/**
+ * Internal: Updates the data already in the cache with the data of a write
+ * going to the image.
+ *
+ * @param   pCache     The cache.
+ * @param   pIoCtx     The I/O context of the write, the S/G buffer is left untouched.
+ * @param   uOffset    Start offset of the write.
+ * @param   cbWrite    Size of the write in bytes.
+ */
+static void vdCacheWriteThroughUpdate(PVDCACHE pCache, PVDIOCTX pIoCtx, uint64_t uOffset, size_t cbWrite)
+{
+    size_t const cbBuf = RT_MIN(cbWrite, VD_CACHE_IO_BUFFER_SIZE);
+    void *pvBuf = RTMemTmpAlloc(cbBuf);
+    int rc = pvBuf ? VINF_SUCCESS : VERR_NO_MEMORY;
+    RTSGBUF SgBuf;
+
+    RTSgBufClone(&SgBuf, &pIoCtx->Req.Io.SgBuf);
+    while (   cbWrite
+           && RT_SUCCESS(rc))
+    {
+        size_t const cbThisWrite = RT_MIN(cbWrite, cbBuf);
+
+        RTSgBufCopyToBuf(&SgBuf, pvBuf, cbThisWrite);
+        rc = pCache->Backend->pfnFill(pCache->pBackendData, uOffset, pvBuf, cbThisWrite,
+                                      VD_CACHE_FILL_F_OVERWRITE, 0 /* uToken */);
+        if (RT_SUCCESS(rc))
+        {
+            uOffset += cbThisWrite;
+            cbWrite -= cbThisWrite;
+        }
+    }
+
+    /* Don't leave stale data in the cache. */
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("VD: Updating the cache failed with %Rrc, dropping %zu bytes at %llu from the cache\n",
+                rc, cbWrite, uOffset));
+        pCache->Backend->pfnInvalidate(pCache->pBackendData, uOffset, cbWrite);
+    }
+
+    if (pvBuf)
+        RTMemTmpFree(pvBuf);
+}
+
 /**
  * Creates a new empty discard state.
  *
@@ -1383,6 +1690,16 @@ static int vdIoCtxProcessLocked(PVDIOCTX pIoCtx)
     else
         rc = VINF_VD_ASYNC_IO_FINISHED;
 
+    /* Drop prefetched data the completed write or discard might have made stale. */
+    if (   rc == VINF_VD_ASYNC_IO_FINISHED
+        && pIoCtx->pDisk->pReadAhead)
+    {
+        if (pIoCtx->enmTxDir == VDIOCTXTXDIR_WRITE)
+            vdReadAheadInvalidate(pIoCtx->pDisk, pIoCtx->Req.Io.uOffsetXferOrig, pIoCtx->Req.Io.cbXferOrig);
+        else if (pIoCtx->enmTxDir == VDIOCTXTXDIR_DISCARD)
+            vdReadAheadInvalidate(pIoCtx->pDisk, 0, UINT64_MAX);
+    }
+
     LogFlowFunc(("pIoCtx=%#p rc=%Rrc cDataTransfersPending=%u cMetaTransfersPending=%u fComplete=%RTbool\n",
                  pIoCtx, rc, pIoCtx->cDataTransfersPending, pIoCtx->cMetaTransfersPending,
                  pIoCtx->fComplete));
@@ -1690,6 +2007,343 @@ static int vdDiskReadHelper(PVDISK pDisk, PVDIMAGE pImage, PVDIMAGE pImageParent
     return rc;
 }
 
+/**
+ * Internal: Reads a given amount of data from the whole image chain of the disk
+ * using and maintaining the block ownership index.
+ **/
+static int vdDiskReadOwnerIdxHelper(PVDISK pDisk, PVDOWNERIDX pOwnerIdx, uint64_t uOffset,
+                                    size_t cbRead, PVDIOCTX pIoCtx, size_t *pcbThisRead)
+{
+    int rc = VINF_SUCCESS;
+    size_t cbThisRead = cbRead;
+    uint8_t idOwner = vdOwnerIdxLookup(pOwnerIdx, uOffset, &cbThisRead);
+
+    AssertPtr(pcbThisRead);
+
+    if (idOwner == VD_OWNERIDX_FREE)
+    {
+        *pcbThisRead = cbThisRead;
+        return VERR_VD_BLOCK_FREE;
+    }
+
+    if (idOwner != VD_OWNERIDX_UNKNOWN)
+    {
+        PVDIMAGE pImage = pOwnerIdx->apImages[idOwner - 1];
+        rc = pImage->Backend->pfnRead(pImage->pBackendData, uOffset, cbThisRead,
+                                      pIoCtx, &cbThisRead);
+        if (rc != VERR_VD_BLOCK_FREE)
+        {
+            *pcbThisRead = cbThisRead;
+            return rc;
+        }
+
+        /* The entry is stale (the block was discarded for example), walk the chain. */
+    }
+
+    uint8_t idImage = (uint8_t)pOwnerIdx->cImages;
+    for (PVDIMAGE pImage = pDisk->pLast; pImage; pImage = pImage->pPrev, idImage--)
+    {
+        rc = pImage->Backend->pfnRead(pImage->pBackendData, uOffset, cbThisRead,
+                                      pIoCtx, &cbThisRead);
+        if (rc != VERR_VD_BLOCK_FREE)
+            break;
+    }
+
+    if (   RT_SUCCESS(rc)
+        || rc == VERR_VD_ASYNC_IO_IN_PROGRESS)
+        vdOwnerIdxSet(pOwnerIdx, uOffset, cbThisRead, idImage, false /*fPartial*/);
+    else if (rc == VERR_VD_BLOCK_FREE)
+        vdOwnerIdxSet(pOwnerIdx, uOffset, cbThisRead, VD_OWNERIDX_FREE, false /*fPartial*/);
+
+    *pcbThisRead = cbThisRead;
+    return rc;
+}
+
+/**
+ * Internal: Drops the data of a read-ahead buffer, adapting the window size.
+ *
+ * @param   pReadAhead  The read-ahead state.
+ * @param   pBuf        The buffer to drop the data of.
+ */
+static void vdReadAheadBufDrop(PVDREADAHEAD pReadAhead, PVDREADAHEADBUF pBuf)
+{
+    Assert(pBuf->enmState == VDREADAHEADBUFSTATE_VALID);
+
+    if (pBuf->cbConsumed < pBuf->cbData)
+    {
+        /* Prefetched too much, shrink the window. */
+        pReadAhead->pStats->cbWasted += pBuf->cbData - pBuf->cbConsumed;
+        pReadAhead->cbWindow = RT_MAX(pReadAhead->cbWindow / 2, VD_READ_AHEAD_WINDOW_MIN);
+    }
+    else /* Everything was used, prefetch more next time. */
+        pReadAhead->cbWindow = RT_MIN(pReadAhead->cbWindow * 2, pReadAhead->cbWindowMax);
+
+    pBuf->enmState = VDREADAHEADBUFSTATE_FREE;
+}
+
+/**
+ * Internal: Returns the read-ahead buffer containing the given offset.
+ *
+ * @returns Pointer to the buffer or NULL if not found.
+ * @param   pReadAhead  The read-ahead state.
+ * @param   uOffset     The offset to look for.
+ * @param   fValidOnly  Flag whether to consider only buffers with valid data
+ *                      or prefetches in progress as well.
+ */
+static PVDREADAHEADBUF vdReadAheadBufFind(PVDREADAHEAD pReadAhead, uint64_t uOffset, bool fValidOnly)
+{
+    for (unsigned i = 0; i < RT_ELEMENTS(pReadAhead->aBufs); i++)
+    {
+        PVDREADAHEADBUF pBuf = &pReadAhead->aBufs[i];
+        if (   (   pBuf->enmState == VDREADAHEADBUFSTATE_VALID
+                || (   !fValidOnly
+                    && pBuf->enmState == VDREADAHEADBUFSTATE_READING
+                    && !pBuf->fStale))
+            && uOffset >= pBuf->uOffset
+            && uOffset - pBuf->uOffset < pBuf->cbData)
+            return pBuf;
+    }
+
+    return NULL;
+}
+
+/**
+ * Internal: Drops all prefetched data overlapping the given range.
+ *
+ * @param   pDisk       The disk.
+ * @param   uOffset     Start offset of the range.
+ * @param   cbRange     Size of the range.
+ */
+static void vdReadAheadInvalidate(PVDISK pDisk, uint64_t uOffset, uint64_t cbRange)
+{
+    PVDREADAHEAD pReadAhead = pDisk->pReadAhead;
+
+    VD_IS_LOCKED(pDisk);
+
+    for (unsigned i = 0; i < RT_ELEMENTS(pReadAhead->aBufs); i++)
+    {
+        PVDREADAHEADBUF pBuf = &pReadAhead->aBufs[i];
+        if (   pBuf->enmState != VDREADAHEADBUFSTATE_FREE
+            && (  pBuf->uOffset >= uOffset
+                ? pBuf->uOffset - uOffset < cbRange
+                : uOffset - pBuf->uOffset < pBuf->cbData))
+        {
+            if (pBuf->enmState == VDREADAHEADBUFSTATE_READING)
+                pBuf->fStale = true;
+            else
+                vdReadAheadBufDrop(pReadAhead, pBuf);
+        }
+    }
+}
+
+/**
+ * Internal: Drops all prefetched data and waits for prefetches in progress to
+ * complete, used before the image chain changes.
+ *
+ * @param   pDisk       The disk, must not be locked by the caller.
+ */
+static void vdReadAheadQuiesce(PVDISK pDisk)
+{
+    PVDREADAHEAD pReadAhead = pDisk->pReadAhead;
+    if (!pReadAhead)
+        return;
+
+    while (!ASMAtomicCmpXchgBool(&pDisk->fLocked, true, false))
+        RTThreadSleep(1);
+    vdReadAheadInvalidate(pDisk, 0, UINT64_MAX);
+    pReadAhead->uOffsetNext = UINT64_MAX;
+    pReadAhead->cSeqReads   = 0;
+    vdDiskUnlock(pDisk, NULL);
+
+    while (ASMAtomicReadU32(&pReadAhead->cPrefetchesPending))
+        RTThreadSleep(1);
+}
+
+/**
+ * Internal: Destroys the read-ahead state of the given disk.
+ *
+ * @param   pDisk       The disk.
+ */
+static void vdReadAheadDestroy(PVDISK pDisk)
+{
+    PVDREADAHEAD pReadAhead = pDisk->pReadAhead;
+    if (pReadAhead)
+    {
+        vdReadAheadQuiesce(pDisk);
+        pDisk->pReadAhead = NULL;
+        for (unsigned i = 0; i < RT_ELEMENTS(pReadAhead->aBufs); i++)
+            if (pReadAhead->aBufs[i].pvBuf)
+                RTMemFree(pReadAhead->aBufs[i].pvBuf);
+        RTMemFree(pReadAhead);
+    }
+}
+
+/**
+ * Internal: Prefetch completion callback.
+ */
+static DECLCALLBACK(void) vdReadAheadPrefetchComplete(void *pvUser1, void *pvUser2, int rcReq)
+{
+    PVDREADAHEAD    pReadAhead = (PVDREADAHEAD)pvUser1;
+    PVDREADAHEADBUF pBuf       = (PVDREADAHEADBUF)pvUser2;
+
+    Assert(pBuf->enmState == VDREADAHEADBUFSTATE_READING);
+    if (   RT_SUCCESS(rcReq)
+        && !pBuf->fStale)
+        pBuf->enmState = VDREADAHEADBUFSTATE_VALID;
+    else
+    {
+        LogFlowFunc(("Dropping prefetch at %llu (%zu bytes) rcReq=%Rrc fStale=%RTbool\n",
+                     pBuf->uOffset, pBuf->cbData, rcReq, pBuf->fStale));
+        pReadAhead->pStats->cbWasted += pBuf->cbData;
+        pBuf->enmState = VDREADAHEADBUFSTATE_FREE;
+    }
+
+    ASMAtomicDecU32(&pReadAhead->cPrefetchesPending);
+}
+
+/**
+ * Internal: Starts a prefetch of the given range into the given buffer.
+ *
+ * The prefetch I/O context is queued and started when the disk lock is released.
+ *
+ * @param   pDisk       The disk.
+ * @param   pReadAhead  The read-ahead state.
+ * @param   pBuf        The free buffer to prefetch into.
+ * @param   uOffset     Start offset of the prefetch.
+ * @param   cbPrefetch  Number of bytes to prefetch.
+ */
+static void vdReadAheadPrefetch(PVDISK pDisk, PVDREADAHEAD pReadAhead, PVDREADAHEADBUF pBuf,
+                                uint64_t uOffset, size_t cbPrefetch)
+{
+    Assert(pBuf->enmState == VDREADAHEADBUFSTATE_FREE);
+
+    if (!pBuf->pvBuf)
+    {
+        pBuf->pvBuf = RTMemAlloc(pReadAhead->cbWindowMax);
+        if (!pBuf->pvBuf)
+            return;
+    }
+
+    RTSGBUF SgBuf;
+    pBuf->Seg.pvSeg = pBuf->pvBuf;
+    pBuf->Seg.cbSeg = cbPrefetch;
+    RTSgBufInit(&SgBuf, &pBuf->Seg, 1);
+
+    PVDIOCTX pIoCtx = vdIoCtxRootAlloc(pDisk, VDIOCTXTXDIR_READ, uOffset, cbPrefetch,
+                                       pDisk->pLast, &SgBuf, vdReadAheadPrefetchComplete,
+                                       pReadAhead, pBuf, NULL, vdReadHelperAsync,
+                                       VDIOCTX_FLAGS_ZERO_FREE_BLOCKS | VDIOCTX_FLAGS_PREFETCH);
+    if (!pIoCtx)
+        return;
+
+    LogFlowFunc(("Prefetching %zu bytes at %llu\n", cbPrefetch, uOffset));
+    pBuf->enmState   = VDREADAHEADBUFSTATE_READING;
+    pBuf->fStale     = false;
+    pBuf->uOffset    = uOffset;
+    pBuf->cbData     = cbPrefetch;
+    pBuf->cbConsumed = 0;
+    pReadAhead->pStats->cPrefetches++;
+    pReadAhead->pStats->cbPrefetched += cbPrefetch;
+    ASMAtomicIncU32(&pReadAhead->cPrefetchesPending);
+
+    /* We hold the disk lock, so this only queues the context. */
+    int rc = vdIoCtxProcessTryLockDefer(pIoCtx);
+    Assert(rc == VERR_VD_ASYNC_IO_IN_PROGRESS); RT_NOREF(rc);
+}
+
+/**
+ * Internal: Runs the sequential stream detection for the given read, serves
+ * what it can from prefetched data and starts prefetching ahead of the stream.
+ *
+ * The I/O context is advanced past the data served from the read-ahead buffers.
+ *
+ * @param   pDisk       The disk.
+ * @param   pIoCtx      The read I/O context.
+ */
+static void vdReadAheadProcessRead(PVDISK pDisk, PVDIOCTX pIoCtx)
+{
+    PVDREADAHEAD pReadAhead = pDisk->pReadAhead;
+    uint64_t uOffset        = pIoCtx->Req.Io.uOffset;
+    size_t   cbRead         = pIoCtx->Req.Io.cbTransfer;
+    uint64_t const uOffsetEnd = uOffset + cbRead;
+    size_t   cbServed       = 0;
+
+    /* Reads hitting prefetched data continue the stream even if they arrive out of order. */
+    bool const fSequential =    uOffset == pReadAhead->uOffsetNext
+                             || vdReadAheadBufFind(pReadAhead, uOffset, false /*fValidOnly*/) != NULL;
+    if (fSequential)
+        pReadAhead->cSeqReads++;
+    else
+        pReadAhead->cSeqReads = 0;
+    pReadAhead->uOffsetNext = uOffsetEnd;
+
+    /* Serve as much as possible from the prefetched data. */
+    PVDREADAHEADBUF pBuf;
+    while (   cbRead
+           && (pBuf = vdReadAheadBufFind(pReadAhead, uOffset, true /*fValidOnly*/)) != NULL)
+    {
+        size_t const offBuf = (size_t)(uOffset - pBuf->uOffset);
+        size_t const cbThisRead = RT_MIN(cbRead, pBuf->cbData - offBuf);
+
+        vdIoCtxCopyTo(pIoCtx, (uint8_t *)pBuf->pvBuf + offBuf, cbThisRead);
+        ASMAtomicSubU32(&pIoCtx->Req.Io.cbTransferLeft, (uint32_t)cbThisRead);
+        uOffset  += cbThisRead;
+        cbRead   -= cbThisRead;
+        cbServed += cbThisRead;
+        pBuf->cbConsumed += cbThisRead;
+
+        /* Free the buffer for the next prefetch once the stream went past its end. */
+        if (offBuf + cbThisRead == pBuf->cbData)
+            vdReadAheadBufDrop(pReadAhead, pBuf);
+    }
+
+    pIoCtx->Req.Io.uOffset    = uOffset;
+    pIoCtx->Req.Io.cbTransfer = cbRead;
+
+    if (cbServed)
+    {
+        pReadAhead->pStats->cbHit += cbServed;
+        if (!cbRead)
+            pReadAhead->pStats->cHits++;
+        else
+            pReadAhead->pStats->cMisses++;
+    }
+    else if (pReadAhead->cSeqReads >= VD_READ_AHEAD_SEQ_READS_MIN)
+        pReadAhead->pStats->cMisses++;
+
+    if (pReadAhead->cSeqReads < VD_READ_AHEAD_SEQ_READS_MIN)
+        return;
+
+    /* Skip what is prefetched already and don't get more than a window ahead of the stream. */
+    uint64_t uOffsetPrefetch = uOffsetEnd;
+    while ((pBuf = vdReadAheadBufFind(pReadAhead, uOffsetPrefetch, false /*fValidOnly*/)) != NULL)
+        uOffsetPrefetch = pBuf->uOffset + pBuf->cbData;
+
+    if (   uOffsetPrefetch >= pDisk->cbSize
+        || uOffsetPrefetch - uOffsetEnd >= pReadAhead->cbWindow)
+        return;
+
+    /* Use a free buffer or recycle one the stream doesn't need anymore. */
+    PVDREADAHEADBUF pBufPrefetch = NULL;
+    for (unsigned i = 0; i < RT_ELEMENTS(pReadAhead->aBufs) && !pBufPrefetch; i++)
+    {
+        pBuf = &pReadAhead->aBufs[i];
+        if (pBuf->enmState == VDREADAHEADBUFSTATE_FREE)
+            pBufPrefetch = pBuf;
+        else if (   pBuf->enmState == VDREADAHEADBUFSTATE_VALID
+                 && (   pBuf->uOffset + pBuf->cbData <= uOffsetEnd
+                     || pBuf->uOffset > uOffsetPrefetch))
+        {
+            vdReadAheadBufDrop(pReadAhead, pBuf);
+            pBufPrefetch = pBuf;
+        }
+    }
+
+    if (pBufPrefetch)
+        vdReadAheadPrefetch(pDisk, pReadAhead, pBufPrefetch, uOffsetPrefetch,
+                            (size_t)RT_MIN(pReadAhead->cbWindow, pDisk->cbSize - uOffsetPrefetch));
+}
+
 /**
  * internal: read the specified amount of data in whatever blocks the backend
  * will give us - async version.
@@ -1703,6 +2357,7 @@ static DECLCALLBACK(int) vdReadHelperAsync(PVDIOCTX pIoCtx)
     PVDIMAGE pCurrImage           = pIoCtx->Req.Io.pImageCur;
     PVDIMAGE pImageParentOverride = pIoCtx->Req.Io.pImageParentOverride;
     unsigned cImagesRead          = pIoCtx->Req.Io.cImagesRead;
+    PVDOWNERIDX pOwnerIdx         = vdOwnerIdxGetForRead(pDisk, pIoCtx, pCurrImage);
     size_t cbThisRead;
 
     /*
@@ -1721,6 +2376,19 @@ static DECLCALLBACK(int) vdReadHelperAsync(PVDIOCTX pIoCtx)
         return VERR_VD_ASYNC_IO_IN_PROGRESS;
     }
 
+    if (pIoCtx->fFlags & VDIOCTX_FLAGS_READ_AHEAD)
+    {
+        pIoCtx->fFlags &= ~VDIOCTX_FLAGS_READ_AHEAD;
+        if (pDisk->pReadAhead)
+        {
+            vdReadAheadProcessRead(pDisk, pIoCtx);
+            if (!pIoCtx->Req.Io.cbTransfer)
+                return VINF_SUCCESS; /* Everything was prefetched already. */
+            uOffset  = pIoCtx->Req.Io.uOffset;
+            cbToRead = pIoCtx->Req.Io.cbTransfer;
+        }
+    }
+
     /* Loop until all reads started or we have a backend which needs to read metadata. */
     do
     {
@@ -1736,18 +2404,23 @@ static DECLCALLBACK(int) vdReadHelperAsync(PVDIOCTX pIoCtx)
                                    pIoCtx, &cbThisRead);
             if (rc == VERR_VD_BLOCK_FREE)
             {
-                rc = vdDiskReadHelper(pDisk, pCurrImage, NULL, uOffset, cbThisRead,
-                                      pIoCtx, &cbThisRead);
+                if (pOwnerIdx)
+                    rc = vdDiskReadOwnerIdxHelper(pDisk, pOwnerIdx, uOffset, cbThisRead,
+                                                  pIoCtx, &cbThisRead);
+                else
+                    rc = vdDiskReadHelper(pDisk, pCurrImage, NULL, uOffset, cbThisRead,
+                                          pIoCtx, &cbThisRead);
 
-                /* If the read was successful, write the data back into the cache. */
-                if (   RT_SUCCESS(rc)
+                /* If the read was successful, add the data to the cache in the background. */
+                if (   (   RT_SUCCESS(rc)
+                        || rc == VERR_VD_ASYNC_IO_IN_PROGRESS)
                     && pIoCtx->fFlags & VDIOCTX_FLAGS_READ_UPDATE_CACHE)
-                {
-                    rc = vdCacheWriteHelper(pDisk->pCache, uOffset, cbThisRead,
-                                            pIoCtx, NULL);
-                }
+                    vdCachePromoteQueue(pDisk->pCache, uOffset, cbThisRead);
             }
         }
+        else if (pOwnerIdx)
+            rc = vdDiskReadOwnerIdxHelper(pDisk, pOwnerIdx, uOffset, cbThisRead,
+                                          pIoCtx, &cbThisRead);
         else
         {
             /*
@@ -2049,112 +2722,725 @@ static int vdWriteHelper(PVDISK pDisk, PVDIMAGE pImage, uint64_t uOffset,
 }
 
 /**
- * Internal: Copies the content of one disk to another one applying optimizations
- * to speed up the copy process if possible.
+ * Internal: Flushes the last image and the cache synchronously.
+ *
+ * @returns VBox status code.
+ * @param   pDisk      The disk to flush.
  */
-static int vdCopyHelper(PVDISK pDiskFrom, PVDIMAGE pImageFrom, PVDISK pDiskTo, PVDIMAGE pImageTo,
-                        uint64_t cbSize, unsigned cImagesFromRead, unsigned cImagesToRead,
-                        bool fSuppressRedundantIo, PVDINTERFACEPROGRESS pIfProgress,
-                        PVDINTERFACEPROGRESS pDstIfProgress)
+static int vdFlushHelper(PVDISK pDisk)
 {
-    int rc = VINF_SUCCESS;
-    int rc2;
-    uint64_t uOffset = 0;
-    uint64_t cbRemaining = cbSize;
-    void *pvBuf = NULL;
-    bool fLockReadFrom = false;
-    bool fLockWriteTo = false;
-    bool fBlockwiseCopy = false;
-    unsigned uProgressOld = 0;
-
-    LogFlowFunc(("pDiskFrom=%#p pImageFrom=%#p pDiskTo=%#p pImageTo=%#p cbSize=%llu cImagesFromRead=%u cImagesToRead=%u fSuppressRedundantIo=%RTbool pIfProgress=%#p pDstIfProgress=%#p\n",
-                 pDiskFrom, pImageFrom, pDiskTo, pImageTo, cbSize, cImagesFromRead, cImagesToRead, fSuppressRedundantIo, pDstIfProgress, pDstIfProgress));
-
-    if (   (fSuppressRedundantIo || (cImagesFromRead > 0))
-        && RTListIsEmpty(&pDiskFrom->ListFilterChainRead))
-        fBlockwiseCopy = true;
+    VDIOCTX IoCtx;
+    RTSEMEVENT hEventComplete = NIL_RTSEMEVENT;
 
-    /* Allocate tmp buffer. */
-    pvBuf = RTMemTmpAlloc(VD_MERGE_BUFFER_SIZE);
-    if (!pvBuf)
+    int rc = RTSemEventCreate(&hEventComplete);
+    if (RT_FAILURE(rc))
         return rc;
 
-    do
+    vdIoCtxInit(&IoCtx, pDisk, VDIOCTXTXDIR_FLUSH, 0, 0, pDisk->pLast, NULL,
+                NULL, vdFlushHelperAsync, VDIOCTX_FLAGS_SYNC | VDIOCTX_FLAGS_DONT_FREE);
+
+    IoCtx.Type.Root.pfnComplete = vdIoCtxSyncComplete;
+    IoCtx.Type.Root.pvUser1     = pDisk;
+    IoCtx.Type.Root.pvUser2     = hEventComplete;
+    rc = vdIoCtxProcessSync(&IoCtx, hEventComplete);
+
+    RTSemEventDestroy(hEventComplete);
+    return rc;
+}
+
+/**
+ * Internal: Writes dirty data from a write-back cache to the last image.
+ *
+ * The caller must hold the write lock of the disk.
+ *
+ * @returns VBox status code.
+ * @param   pDisk      The disk.
+ * @param   cbMax      Amount of data to write back before returning,
+ *                     0 to write back everything.
+ */
+static int vdCacheWriteBack(PVDISK pDisk, uint64_t cbMax)
+{
+    PVDCACHE pCache = pDisk->pCache;
+    int rc = VINF_SUCCESS;
+
+    if (   !pCache
+        || !pCache->Backend->pfnQueryDirty
+        || !pCache->Backend->pfnGetDirtySize(pCache->pBackendData))
+        return VINF_SUCCESS;
+
+    struct
     {
-        size_t cbThisRead = RT_MIN(VD_MERGE_BUFFER_SIZE, cbRemaining);
+        uint64_t    uOffset;
+        size_t      cbRange;
+        uint32_t    uGen;
+    } aRanges[VD_CACHE_WRITEBACK_BATCH];
+    uint64_t uCursor = 0;
+    uint64_t cbDone  = 0;
+    unsigned cPasses = 0;
+    bool     fDone   = false;
 
-        /* Note that we don't attempt to synchronize cross-disk accesses.
-         * It wouldn't be very difficult to do, just the lock order would
-         * need to be defined somehow to prevent deadlocks. Postpone such
-         * magic as there is no use case for this. */
+    void *pvBuf = RTMemTmpAlloc(VD_CACHE_IO_BUFFER_SIZE);
+    if (!pvBuf)
+        return VERR_NO_MEMORY;
 
-        rc2 = vdThreadStartRead(pDiskFrom);
+    while (   !fDone
+           && RT_SUCCESS(rc))
+    {
+        unsigned cRanges = 0;
+
+        while (cRanges < RT_ELEMENTS(aRanges))
+        {
+            rc = pCache->Backend->pfnQueryDirty(pCache->pBackendData, &uCursor, &aRanges[cRanges].uOffset,
+                                                pvBuf, VD_CACHE_IO_BUFFER_SIZE, &aRanges[cRanges].cbRange,
+                                                &aRanges[cRanges].uGen);
+            if (rc == VERR_NOT_FOUND)
+            {
+                /* Data written behind the cursor needs another pass when writing back everything. */
+                rc = VINF_SUCCESS;
+                uCursor = 0;
+                if (   cbMax
+                    || ++cPasses >= 3
+                    || !pCache->Backend->pfnGetDirtySize(pCache->pBackendData))
+                    fDone = true;
+                break;
+            }
+            if (RT_FAILURE(rc))
+                break;
+
+            rc = vdWriteHelper(pDisk, pDisk->pLast, aRanges[cRanges].uOffset, pvBuf, aRanges[cRanges].cbRange,
+                               VDIOCTX_FLAGS_CACHE_BYPASS | VDIOCTX_FLAGS_DONT_SET_MODIFIED_FLAG);
+            if (RT_FAILURE(rc))
+                break;
+
+            cbDone += aRanges[cRanges].cbRange;
+            cRanges++;
+            if (   cbMax
+                && cbDone >= cbMax)
+            {
+                fDone = true;
+                break;
+            }
+        }
+
+        /* The ranges are clean only after the data reached the medium. */
+        if (   cRanges
+            && RT_SUCCESS(rc))
+        {
+            rc = vdFlushHelper(pDisk);
+            for (unsigned i = 0; i < cRanges && RT_SUCCESS(rc); i++)
+                pCache->Backend->pfnMarkClean(pCache->pBackendData, aRanges[i].uOffset,
+                                              aRanges[i].cbRange, aRanges[i].uGen);
+        }
+    }
+
+    RTMemTmpFree(pvBuf);
+
+    if (RT_FAILURE(rc))
+        LogRel(("VD: Writing back dirty data from the cache '%s' failed with %Rrc\n", pCache->pszFilename, rc));
+    return rc;
+}
+
+/**
+ * Internal: Adds the ranges queued after read misses to the cache.
+ *
+ * The caller must hold the write lock of the disk.
+ *
+ * @param   pDisk      The disk.
+ * @param   pCache     The cache.
+ */
+static void vdCachePromoteProcess(PVDISK pDisk, PVDCACHE pCache)
+{
+    void *pvBuf = NULL;
+
+    for (;;)
+    {
+        VDCACHEPROMOTE Promote;
+        bool fEmpty;
+
+        RTSemFastMutexRequest(pCache->hMtxPromote);
+        fEmpty = pCache->idxPromoteHead == pCache->idxPromoteTail;
+        if (!fEmpty)
+        {
+            Promote = pCache->aPromote[pCache->idxPromoteTail];
+            pCache->idxPromoteTail = (pCache->idxPromoteTail + 1) % VD_CACHE_PROMOTE_QUEUE_SIZE;
+        }
+        RTSemFastMutexRelease(pCache->hMtxPromote);
+        if (fEmpty)
+            break;
+
+        if (!pvBuf)
+        {
+            pvBuf = RTMemTmpAlloc(VD_CACHE_IO_BUFFER_SIZE);
+            if (!pvBuf)
+                break;
+        }
+
+        while (Promote.cbRange)
+        {
+            size_t const cbThisRead = RT_MIN(Promote.cbRange, VD_CACHE_IO_BUFFER_SIZE);
+
+            /* Writes from here on make the data read below stale, the cache drops it then. */
+            uint64_t const uToken = pCache->Backend->pfnQueryFillToken(pCache->pBackendData);
+            int rc = vdReadHelperEx(pDisk, pDisk->pLast, NULL, Promote.uOffset, pvBuf, cbThisRead,
+                                    true /* fZeroFreeBlocks */, false /* fUpdateCache */, 0);
+            if (RT_SUCCESS(rc))
+                rc = pCache->Backend->pfnFill(pCache->pBackendData, Promote.uOffset, pvBuf, cbThisRead,
+                                              VD_CACHE_FILL_F_DEFAULT, uToken);
+            if (RT_FAILURE(rc))
+                break;
+
+            Promote.uOffset += cbThisRead;
+            Promote.cbRange -= cbThisRead;
+        }
+    }
+
+    if (pvBuf)
+        RTMemTmpFree(pvBuf);
+}
+
+/**
+ * Cache background thread, fills the cache after read misses, writes back
+ * dirty data and commits the cache metadata periodically.
+ */
+static DECLCALLBACK(int) vdCacheThread(RTTHREAD hThread, void *pvUser)
+{
+    RT_NOREF(hThread);
+    PVDCACHE pCache = (PVDCACHE)pvUser;
+    PVDISK pDisk = pCache->VDIo.pDisk;
+    RTMSINTERVAL cMsWait = VD_CACHE_THREAD_INTERVAL_MS;
+
+    while (!ASMAtomicReadBool(&pCache->fShutdown))
+    {
+        RTSemEventWait(pCache->hEvtThread, cMsWait);
+        if (ASMAtomicReadBool(&pCache->fShutdown))
+            break;
+        ASMAtomicWriteBool(&pCache->fWorkPending, false);
+
+        int rc2 = vdThreadStartWrite(pDisk);
         AssertRC(rc2);
-        fLockReadFrom = true;
 
-        if (fBlockwiseCopy)
+        vdCachePromoteProcess(pDisk, pCache);
+
+        /* Write back in chunks to leave room for guest I/O, keep going while there is dirty data. */
+        cMsWait = VD_CACHE_THREAD_INTERVAL_MS;
+        if (   pCache->enmMode == VDCACHEMODE_WRITE_BACK
+            && pDisk->pLast)
         {
-            RTSGSEG SegmentBuf;
-            RTSGBUF SgBuf;
-            VDIOCTX IoCtx;
+            int rc = vdCacheWriteBack(pDisk, VD_CACHE_WRITEBACK_CHUNK);
+            if (   RT_SUCCESS(rc)
+                && pCache->Backend->pfnGetDirtySize(pCache->pBackendData))
+                cMsWait = 10;
+        }
 
-            SegmentBuf.pvSeg = pvBuf;
-            SegmentBuf.cbSeg = VD_MERGE_BUFFER_SIZE;
-            RTSgBufInit(&SgBuf, &SegmentBuf, 1);
-            vdIoCtxInit(&IoCtx, pDiskFrom, VDIOCTXTXDIR_READ, 0, 0, NULL,
-                        &SgBuf, NULL, NULL, VDIOCTX_FLAGS_SYNC);
+        pCache->Backend->pfnFlush(pCache->pBackendData, NULL);
 
-            /* Read the source data. */
-            rc = pImageFrom->Backend->pfnRead(pImageFrom->pBackendData,
-                                              uOffset, cbThisRead, &IoCtx,
-                                              &cbThisRead);
+        rc2 = vdThreadFinishWrite(pDisk);
+        AssertRC(rc2);
+    }
 
-            if (   rc == VERR_VD_BLOCK_FREE
-                && cImagesFromRead != 1)
+    return VINF_SUCCESS;
+}
+
+/**
+ * Internal: Starts the background thread of a writable cache.
+ *
+ * @returns VBox status code.
+ * @param   pCache     The cache.
+ */
+static int vdCacheThreadStart(PVDCACHE pCache)
+{
+    pCache->hThread     = NIL_RTTHREAD;
+    pCache->hEvtThread  = NIL_RTSEMEVENT;
+    pCache->hMtxPromote = NIL_RTSEMFASTMUTEX;
+    pCache->enmMode     = VDCACHEMODE_WRITE_THROUGH;
+
+    /* Read-only caches and backends without fill support are used as they are. */
+    if (   !pCache->Backend->pfnFill
+        || !pCache->Backend->pfnQueryFillToken
+        || !pCache->Backend->pfnInvalidate
+        || (pCache->Backend->pfnGetOpenFlags(pCache->pBackendData) & VD_OPEN_FLAGS_READONLY))
+        return VINF_SUCCESS;
+
+    /* Dirty data left behind by a write-back cache must be written back in any case. */
+    if (   pCache->Backend->pfnGetDirtySize
+        && pCache->Backend->pfnGetDirtySize(pCache->pBackendData))
+    {
+        LogRel(("VD: Cache '%s' contains %llu bytes of dirty data, starting in write-back mode\n",
+                pCache->pszFilename, pCache->Backend->pfnGetDirtySize(pCache->pBackendData)));
+        pCache->enmMode = VDCACHEMODE_WRITE_BACK;
+    }
+
+    pCache->fShutdown      = false;
+    pCache->fWorkPending   = false;
+    pCache->idxPromoteHead = 0;
+    pCache->idxPromoteTail = 0;
+
+    int rc = RTSemEventCreate(&pCache->hEvtThread);
+    if (RT_SUCCESS(rc))
+        rc = RTSemFastMutexCreate(&pCache->hMtxPromote);
+    if (RT_SUCCESS(rc))
+        rc = RTThreadCreate(&pCache->hThread, vdCacheThread, pCache, 0, RTTHREADTYPE_IO,
+                            RTTHREADFLAGS_WAITABLE, "VDCache");
+    if (RT_FAILURE(rc))
+    {
+        pCache->hThread = NIL_RTTHREAD;
+        if (pCache->hMtxPromote != NIL_RTSEMFASTMUTEX)
+            RTSemFastMutexDestroy(pCache->hMtxPromote);
+        if (pCache->hEvtThread != NIL_RTSEMEVENT)
+            RTSemEventDestroy(pCache->hEvtThread);
+        pCache->hMtxPromote = NIL_RTSEMFASTMUTEX;
+        pCache->hEvtThread  = NIL_RTSEMEVENT;
+    }
+
+    return rc;
+}
+
+/**
+ * Internal: Stops the background thread of the cache if running.
+ *
+ * Must not be called with the write lock of the disk held because the thread
+ * might wait for it.
+ *
+ * @param   pCache     The cache.
+ */
+static void vdCacheThreadStop(PVDCACHE pCache)
+{
+    if (pCache->hThread == NIL_RTTHREAD)
+        return;
+
+    ASMAtomicWriteBool(&pCache->fShutdown, true);
+    RTSemEventSignal(pCache->hEvtThread);
+    int rc = RTThreadWait(pCache->hThread, RT_INDEFINITE_WAIT, NULL);
+    AssertRC(rc);
+
+    RTSemFastMutexDestroy(pCache->hMtxPromote);
+    RTSemEventDestroy(pCache->hEvtThread);
+    pCache->hThread     = NIL_RTTHREAD;
+    pCache->hMtxPromote = NIL_RTSEMFASTMUTEX;
+    pCache->hEvtThread  = NIL_RTSEMEVENT;
+}
+
+/**
+ * Internal: Reads a chunk of the source disk for copying, taking the read lock.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_VD_BLOCK_FREE if the range is not allocated in any of the images
+ *          considered and can be skipped (only when copying blockwise).
+ * @param   pDiskFrom           The source disk.
+ * @param   pImageFrom          The source image to start reading from.
+ * @param   uOffset             The offset to read from.
+ * @param   pvBuf               Where to store the data.
+ * @param   cbBuf               Size of the buffer.
+ * @param   pcbThisRead         On input the number of bytes to read, on output the
+ *                              number of bytes actually processed.
+ * @param   cImagesFromRead     Number of images in the chain to consider when
+ *                              copying blockwise, 0 for the whole chain.
+ * @param   fBlockwiseCopy      Whether to read from the backends directly walking
+ *                              the chain to detect unallocated ranges.
+ */
+static int vdCopyReadChunk(PVDISK pDiskFrom, PVDIMAGE pImageFrom, uint64_t uOffset,
+                           void *pvBuf, size_t cbBuf, size_t *pcbThisRead,
+                           unsigned cImagesFromRead, bool fBlockwiseCopy)
+{
+    int rc;
+    size_t cbThisRead = *pcbThisRead;
+
+    /* Note that we don't attempt to synchronize cross-disk accesses.
+     * It wouldn't be very difficult to do, just the lock order would
+     * need to be defined somehow to prevent deadlocks. Postpone such
+     * magic as there is no use case for this. */
+    int rc2 = vdThreadStartRead(pDiskFrom);
+    AssertRC(rc2);
+
+    if (fBlockwiseCopy)
+    {
+        RTSGSEG SegmentBuf;
+        RTSGBUF SgBuf;
+        VDIOCTX IoCtx;
+
+        SegmentBuf.pvSeg = pvBuf;
+        SegmentBuf.cbSeg = cbBuf;
+        RTSgBufInit(&SgBuf, &SegmentBuf, 1);
+        vdIoCtxInit(&IoCtx, pDiskFrom, VDIOCTXTXDIR_READ, 0, 0, NULL,
+                    &SgBuf, NULL, NULL, VDIOCTX_FLAGS_SYNC);
+
+        /* Read the source data. */
+        rc = pImageFrom->Backend->pfnRead(pImageFrom->pBackendData,
+                                          uOffset, cbThisRead, &IoCtx,
+                                          &cbThisRead);
+
+        if (   rc == VERR_VD_BLOCK_FREE
+            && cImagesFromRead != 1)
+        {
+            unsigned cImagesToProcess = cImagesFromRead;
+
+            for (PVDIMAGE pCurrImage = pImageFrom->pPrev;
+                 pCurrImage != NULL && rc == VERR_VD_BLOCK_FREE;
+                 pCurrImage = pCurrImage->pPrev)
             {
-                unsigned cImagesToProcess = cImagesFromRead;
+                rc = pCurrImage->Backend->pfnRead(pCurrImage->pBackendData,
+                                                       uOffset, cbThisRead,
+                                                       &IoCtx, &cbThisRead);
+                if (cImagesToProcess == 1)
+                    break;
+                else if (cImagesToProcess > 0)
+                    cImagesToProcess--;
+            }
+        }
+    }
+    else
+        rc = vdReadHelper(pDiskFrom, pImageFrom, uOffset, pvBuf, cbThisRead,
+                          false /* fUpdateCache */);
 
-                for (PVDIMAGE pCurrImage = pImageFrom->pPrev;
-                     pCurrImage != NULL && rc == VERR_VD_BLOCK_FREE;
-                     pCurrImage = pCurrImage->pPrev)
+    rc2 = vdThreadFinishRead(pDiskFrom);
+    AssertRC(rc2);
+
+    *pcbThisRead = cbThisRead;
+    return rc;
+}
+
+/**
+ * Internal: Writes a chunk to the destination disk for copying, taking the write lock.
+ *
+ * @returns VBox status code.
+ * @param   pDiskTo             The destination disk.
+ * @param   pImageTo            The destination image.
+ * @param   uOffset             The offset to write to.
+ * @param   pvBuf               The data to write.
+ * @param   cbWrite             Number of bytes to write.
+ * @param   cImagesToRead       Number of images to consider for collapsed I/O.
+ */
+static int vdCopyWriteChunk(PVDISK pDiskTo, PVDIMAGE pImageTo, uint64_t uOffset,
+                            const void *pvBuf, size_t cbWrite, unsigned cImagesToRead)
+{
+    int rc2 = vdThreadStartWrite(pDiskTo);
+    AssertRC(rc2);
+
+    int rc = vdWriteHelperEx(pDiskTo, pImageTo, NULL, uOffset, pvBuf,
+                             cbWrite, VDIOCTX_FLAGS_DONT_SET_MODIFIED_FLAG /* fFlags */,
+                             cImagesToRead);
+
+    rc2 = vdThreadFinishWrite(pDiskTo);
+    AssertRC(rc2);
+    return rc;
+}
+
+/**
+ * Internal: Reports the copy progress if it changed.
+ *
+ * @returns VBox status code returned by the progress callbacks.
+ * @param   pIfProgress         The source progress interface, optional.
+ * @param   pDstIfProgress      The destination progress interface, optional.
+ * @param   uOffset             How much was copied so far.
+ * @param   cbSize              The overall size to copy.
+ * @param   puProgressOld       Where the last reported percentage is stored.
+ */
+static int vdCopyProgress(PVDINTERFACEPROGRESS pIfProgress, PVDINTERFACEPROGRESS pDstIfProgress,
+                          uint64_t uOffset, uint64_t cbSize, unsigned *puProgressOld)
+{
+    int rc = VINF_SUCCESS;
+    unsigned uProgressNew = uOffset * 99 / cbSize;
+    if (uProgressNew != *puProgressOld)
+    {
+        *puProgressOld = uProgressNew;
+
+        if (pIfProgress && pIfProgress->pfnProgress)
+            rc = pIfProgress->pfnProgress(pIfProgress->Core.pvUser, uProgressNew);
+        if (   RT_SUCCESS(rc)
+            && pDstIfProgress && pDstIfProgress->pfnProgress)
+            rc = pDstIfProgress->pfnProgress(pDstIfProgress->Core.pvUser, uProgressNew);
+    }
+
+    return rc;
+}
+
+/**
+ * Internal: The reader thread of a pipelined copy.
+ *
+ * Reads the source sequentially into the ring of chunk buffers, detecting
+ * unallocated and all zero chunks which don't need to be written.
+ */
+static DECLCALLBACK(int) vdCopyPipelineReader(RTTHREAD hThread, void *pvUser)
+{
+    PVDCOPYPIPELINE pPipeline = (PVDCOPYPIPELINE)pvUser;
+    uint64_t uOffset = 0;
+
+    RT_NOREF(hThread);
+
+    while (   uOffset < pPipeline->cbSize
+           && !ASMAtomicReadBool(&pPipeline->fCancel))
+    {
+        /* Wait for a free buffer. */
+        if (  ASMAtomicReadU32(&pPipeline->cProduced) - ASMAtomicReadU32(&pPipeline->cConsumed)
+            >= pPipeline->cChunks)
+        {
+            RTSemEventWait(pPipeline->hEvtConsumed, RT_INDEFINITE_WAIT);
+            continue;
+        }
+
+        PVDCOPYCHUNK pChunk = &pPipeline->paChunks[pPipeline->cProduced % pPipeline->cChunks];
+        size_t cbThisRead = (size_t)RT_MIN(VD_COPY_CHUNK_SIZE, pPipeline->cbSize - uOffset);
+        int rc = vdCopyReadChunk(pPipeline->pDiskFrom, pPipeline->pImageFrom, uOffset,
+                                 pChunk->pvBuf, VD_COPY_CHUNK_SIZE, &cbThisRead,
+                                 pPipeline->cImagesFromRead, pPipeline->fBlockwiseCopy);
+        pChunk->uOffset = uOffset;
+        pChunk->cbChunk = cbThisRead;
+        pChunk->fSkip   = false;
+        if (rc == VERR_VD_BLOCK_FREE)
+        {
+            pChunk->fSkip = true;
+            rc = VINF_SUCCESS;
+        }
+        else if (   RT_SUCCESS(rc)
+                 && pPipeline->fSkipZeroes)
+            pChunk->fSkip = ASMMemIsZero(pChunk->pvBuf, cbThisRead);
+        pChunk->rc = rc;
+
+        ASMAtomicIncU32(&pPipeline->cProduced);
+        RTSemEventSignal(pPipeline->hEvtProduced);
+
+        if (RT_FAILURE(rc))
+            break;
+
+        uOffset += cbThisRead;
+    }
+
+    ASMAtomicWriteBool(&pPipeline->fReaderDone, true);
+    RTSemEventSignal(pPipeline->hEvtProduced);
+    return VINF_SUCCESS;
+}
+
+/**
+ * Internal: Sets up the reader thread and the chunk buffers for a pipelined copy.
+ *
+ * @returns VBox status code.
+ * @param   pPipeline           The pipeline state to initialize, the source
+ *                              related members must be set already.
+ * @param   cChunks             Number of chunk buffers.
+ */
+static int vdCopyPipelineCreate(PVDCOPYPIPELINE pPipeline, uint32_t cChunks)
+{
+    pPipeline->cChunks      = 0;
+    pPipeline->cProduced    = 0;
+    pPipeline->cConsumed    = 0;
+    pPipeline->fCancel      = false;
+    pPipeline->fReaderDone  = false;
+    pPipeline->hThread      = NIL_RTTHREAD;
+    pPipeline->hEvtProduced = NIL_RTSEMEVENT;
+    pPipeline->hEvtConsumed = NIL_RTSEMEVENT;
+    pPipeline->paChunks     = (PVDCOPYCHUNK)RTMemAllocZ(cChunks * sizeof(VDCOPYCHUNK));
+    if (!pPipeline->paChunks)
+        return VERR_NO_MEMORY;
+
+    int rc = VINF_SUCCESS;
+    for (uint32_t i = 0; i < cChunks && RT_SUCCESS(rc); i++)
+    {
+        pPipeline->paChunks[i].pvBuf = RTMemTmpAlloc(VD_COPY_CHUNK_SIZE);
+        if (pPipeline->paChunks[i].pvBuf)
+            pPipeline->cChunks++;
+        else
+            rc = VERR_NO_MEMORY;
+    }
+
+    if (RT_SUCCESS(rc))
+        rc = RTSemEventCreate(&pPipeline->hEvtProduced);
+    if (RT_SUCCESS(rc))
+        rc = RTSemEventCreate(&pPipeline->hEvtConsumed);
+    if (RT_SUCCESS(rc))
+        rc = RTThreadCreate(&pPipeline->hThread, vdCopyPipelineReader, pPipeline, 0,
+                            RTTHREADTYPE_IO, RTTHREADFLAGS_WAITABLE, "VDCopyRd");
+    return rc;
+}
+
+/**
+ * Internal: Stops the reader thread of a pipelined copy and frees all resources.
+ *
+ * @param   pPipeline           The pipeline state.
+ */
+static void vdCopyPipelineDestroy(PVDCOPYPIPELINE pPipeline)
+{
+    if (pPipeline->hThread != NIL_RTTHREAD)
+    {
+        ASMAtomicWriteBool(&pPipeline->fCancel, true);
+        RTSemEventSignal(pPipeline->hEvtConsumed);
+        int rc = RTThreadWait(pPipeline->hThread, RT_INDEFINITE_WAIT, NULL);
+        AssertRC(rc);
+        pPipeline->hThread = NIL_RTTHREAD;
+    }
+
+    if (pPipeline->hEvtProduced != NIL_RTSEMEVENT)
+        RTSemEventDestroy(pPipeline->hEvtProduced);
+    if (pPipeline->hEvtConsumed != NIL_RTSEMEVENT)
+        RTSemEventDestroy(pPipeline->hEvtConsumed);
+    pPipeline->hEvtProduced = NIL_RTSEMEVENT;
+    pPipeline->hEvtConsumed = NIL_RTSEMEVENT;
+
+    if (pPipeline->paChunks)
+    {
+        for (uint32_t i = 0; i < pPipeline->cChunks; i++)
+            RTMemTmpFree(pPipeline->paChunks[i].pvBuf);
+        RTMemFree(pPipeline->paChunks);
+        pPipeline->paChunks = NULL;
+    }
+}
+
+/**
+ * Internal: Pipelined copy, the source is read ahead on a separate thread
+ * while the calling thread writes the chunks to the destination in order.
+ *
+ * @returns VBox status code.
+ * @param   pPipeline           The pipeline state, the reader is running already.
+ * @param   pDiskTo             The destination disk.
+ * @param   pImageTo            The destination image.
+ * @param   cImagesToRead       Number of images to consider for collapsed I/O.
+ * @param   pIfProgress         The source progress interface, optional.
+ * @param   pDstIfProgress      The destination progress interface, optional.
+ */
+static int vdCopyPipelineRun(PVDCOPYPIPELINE pPipeline, PVDISK pDiskTo, PVDIMAGE pImageTo,
+                             unsigned cImagesToRead, PVDINTERFACEPROGRESS pIfProgress,
+                             PVDINTERFACEPROGRESS pDstIfProgress)
+{
+    int rc = VINF_SUCCESS;
+    uint64_t uOffset = 0;
+    unsigned uProgressOld = 0;
+
+    while (uOffset < pPipeline->cbSize)
+    {
+        if (ASMAtomicReadU32(&pPipeline->cProduced) == pPipeline->cConsumed)
+        {
+            if (ASMAtomicReadBool(&pPipeline->fReaderDone))
+            {
+                /* Check again, the reader might have produced a chunk right before finishing. */
+                if (ASMAtomicReadU32(&pPipeline->cProduced) == pPipeline->cConsumed)
                 {
-                    rc = pCurrImage->Backend->pfnRead(pCurrImage->pBackendData,
-                                                           uOffset, cbThisRead,
-                                                           &IoCtx, &cbThisRead);
-                    if (cImagesToProcess == 1)
-                        break;
-                    else if (cImagesToProcess > 0)
-                        cImagesToProcess--;
+                    AssertFailed();
+                    rc = VERR_INTERNAL_ERROR;
+                    break;
                 }
             }
+            else
+            {
+                RTSemEventWait(pPipeline->hEvtProduced, RT_INDEFINITE_WAIT);
+                continue;
+            }
         }
-        else
-            rc = vdReadHelper(pDiskFrom, pImageFrom, uOffset, pvBuf, cbThisRead,
-                              false /* fUpdateCache */);
 
-        if (RT_FAILURE(rc) && rc != VERR_VD_BLOCK_FREE)
+        PVDCOPYCHUNK pChunk = &pPipeline->paChunks[pPipeline->cConsumed % pPipeline->cChunks];
+        rc = pChunk->rc;
+        if (RT_FAILURE(rc))
             break;
 
-        rc2 = vdThreadFinishRead(pDiskFrom);
-        AssertRC(rc2);
-        fLockReadFrom = false;
+        Assert(pChunk->uOffset == uOffset);
+        if (!pChunk->fSkip)
+        {
+            rc = vdCopyWriteChunk(pDiskTo, pImageTo, pChunk->uOffset, pChunk->pvBuf,
+                                  pChunk->cbChunk, pPipeline->fBlockwiseCopy ? cImagesToRead : 0);
+            if (RT_FAILURE(rc))
+                break;
+        }
 
-        if (rc != VERR_VD_BLOCK_FREE)
+        uOffset += pChunk->cbChunk;
+        ASMAtomicIncU32(&pPipeline->cConsumed);
+        RTSemEventSignal(pPipeline->hEvtConsumed);
+
+        rc = vdCopyProgress(pIfProgress, pDstIfProgress, uOffset, pPipeline->cbSize, &uProgressOld);
+        if (RT_FAILURE(rc))
+            break;
+    }
+
+    return rc;
+}
+
+/**
+ * Internal: Copies the content of one disk to another one applying optimizations
+ * to speed up the copy process if possible.
+ *
+ * Unless disabled with a pipeline depth of 1 the source is read on a separate
+ * thread ahead of the destination writes.
+ */
+static int vdCopyHelper(PVDISK pDiskFrom, PVDIMAGE pImageFrom, PVDISK pDiskTo, PVDIMAGE pImageTo,
+                        uint64_t cbSize, unsigned cImagesFromRead, unsigned cImagesToRead,
+                        bool fSuppressRedundantIo, uint32_t cPipelineDepth,
+                        PVDINTERFACEPROGRESS pIfProgress, PVDINTERFACEPROGRESS pDstIfProgress)
+{
+    int rc = VINF_SUCCESS;
+    uint64_t uOffset = 0;
+    uint64_t cbRemaining = cbSize;
+    void *pvBuf = NULL;
+    bool fBlockwiseCopy = false;
+    bool fSkipZeroes = false;
+    unsigned uProgressOld = 0;
+
+    LogFlowFunc(("pDiskFrom=%#p pImageFrom=%#p pDiskTo=%#p pImageTo=%#p cbSize=%llu cImagesFromRead=%u cImagesToRead=%u fSuppressRedundantIo=%RTbool cPipelineDepth=%u pIfProgress=%#p pDstIfProgress=%#p\n",
+                 pDiskFrom, pImageFrom, pDiskTo, pImageTo, cbSize, cImagesFromRead, cImagesToRead, fSuppressRedundantIo, cPipelineDepth, pDstIfProgress, pDstIfProgress));
+
+    /*
+     * When copying into a freshly created image everything not written reads
+     * as zero, so unallocated ranges of the source (as reported by the backends)
+     * and all zero chunks don't need to be written.  Not possible for fixed
+     * images written sequentially (e.g. raw to a pipe) as the gaps would be missing.
+     */
+    if (!fSuppressRedundantIo)
+    {
+        unsigned uImageFlagsTo = pImageTo->Backend->pfnGetImageFlags(pImageTo->pBackendData);
+        unsigned uOpenFlagsTo  = pImageTo->Backend->pfnGetOpenFlags(pImageTo->pBackendData);
+        if (   !(uImageFlagsTo & VD_IMAGE_FLAGS_FIXED)
+            || !(uOpenFlagsTo & VD_OPEN_FLAGS_SEQUENTIAL))
+            fSkipZeroes = true;
+    }
+
+    if (   (fSuppressRedundantIo || (cImagesFromRead > 0) || (fSkipZeroes && !pDiskFrom->pCache))
+        && RTListIsEmpty(&pDiskFrom->ListFilterChainRead))
+        fBlockwiseCopy = true;
+
+    if (   cPipelineDepth > 1
+        && pDiskFrom != pDiskTo)
+    {
+        VDCOPYPIPELINE Pipeline;
+        Pipeline.pDiskFrom       = pDiskFrom;
+        Pipeline.pImageFrom      = pImageFrom;
+        Pipeline.cImagesFromRead = cImagesFromRead;
+        Pipeline.fBlockwiseCopy  = fBlockwiseCopy;
+        Pipeline.fSkipZeroes     = fSkipZeroes;
+        Pipeline.cbSize          = cbSize;
+
+        int rc2 = vdCopyPipelineCreate(&Pipeline, RT_MIN(cPipelineDepth, VD_COPY_PIPELINE_DEPTH_MAX));
+        if (RT_SUCCESS(rc2))
         {
-            rc2 = vdThreadStartWrite(pDiskTo);
-            AssertRC(rc2);
-            fLockWriteTo = true;
+            rc = vdCopyPipelineRun(&Pipeline, pDiskTo, pImageTo, cImagesToRead,
+                                   pIfProgress, pDstIfProgress);
+            vdCopyPipelineDestroy(&Pipeline);
+            LogFlowFunc(("returns rc=%Rrc\n", rc));
+            return rc;
+        }
+
+        /* Fall back to the serial copy if the pipeline couldn't be set up. */
+        LogRel(("VD: Setting up the copy pipeline failed with %Rrc, copying serially\n", rc2));
+        vdCopyPipelineDestroy(&Pipeline);
+    }
+
+    /* Allocate tmp buffer. */
+    pvBuf = RTMemTmpAlloc(VD_MERGE_BUFFER_SIZE);
+    if (!pvBuf)
+        return VERR_NO_MEMORY;
 
+    do
+    {
+        size_t cbThisRead = RT_MIN(VD_MERGE_BUFFER_SIZE, cbRemaining);
+
+        rc = vdCopyReadChunk(pDiskFrom, pImageFrom, uOffset, pvBuf, VD_MERGE_BUFFER_SIZE,
+                             &cbThisRead, cImagesFromRead, fBlockwiseCopy);
+        if (RT_FAILURE(rc) && rc != VERR_VD_BLOCK_FREE)
+            break;
+
+        if (   rc != VERR_VD_BLOCK_FREE
+            && !(fSkipZeroes && ASMMemIsZero(pvBuf, cbThisRead)))
+        {
             /* Only do collapsed I/O if we are copying the data blockwise. */
-            rc = vdWriteHelperEx(pDiskTo, pImageTo, NULL, uOffset, pvBuf,
-                                 cbThisRead, VDIOCTX_FLAGS_DONT_SET_MODIFIED_FLAG /* fFlags */,
-                                 fBlockwiseCopy ? cImagesToRead : 0);
+            rc = vdCopyWriteChunk(pDiskTo, pImageTo, uOffset, pvBuf, cbThisRead,
+                                  fBlockwiseCopy ? cImagesToRead : 0);
             if (RT_FAILURE(rc))
                 break;
-
-            rc2 = vdThreadFinishWrite(pDiskTo);
-            AssertRC(rc2);
-            fLockWriteTo = false;
         }
         else /* Don't propagate the error to the outside */
             rc = VINF_SUCCESS;
@@ -2162,43 +3448,372 @@ static int vdCopyHelper(PVDISK pDiskFrom, PVDIMAGE pImageFrom, PVDISK pDiskTo, P
         uOffset += cbThisRead;
         cbRemaining -= cbThisRead;
 
-        unsigned uProgressNew = uOffset * 99 / cbSize;
-        if (uProgressNew != uProgressOld)
-        {
-            uProgressOld = uProgressNew;
+        rc = vdCopyProgress(pIfProgress, pDstIfProgress, uOffset, cbSize, &uProgressOld);
+        if (RT_FAILURE(rc))
+            break;
+    } while (uOffset < cbSize);
+
+    RTMemTmpFree(pvBuf);
+
+    LogFlowFunc(("returns rc=%Rrc\n", rc));
+    return rc;
+}
+
+/**
+ * Internal: Marks the active chunk of the stream operation as dirty if the given
+ * write or discard overlaps it, or fails the write of the stream itself if the
+ * chunk was touched since it was probed.
+ *
+ * Called with the disk lock held.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_TRY_AGAIN if the stream write must not be carried out.
+ * @param   pDisk       The disk.
+ * @param   pIoCtx      The write or discard I/O context.
+ * @param   uOffset     Start offset of the access.
+ * @param   cbRange     Size of the access, UINT64_MAX for discards.
+ */
+static int vdStreamCheckWrite(PVDISK pDisk, PVDIOCTX pIoCtx, uint64_t uOffset, uint64_t cbRange)
+{
+    PVDSTREAM pStream = pDisk->pStream;
+
+    VD_IS_LOCKED(pDisk);
+
+    if (pIoCtx->fFlags & VDIOCTX_FLAGS_STREAM)
+        return ASMAtomicReadBool(&pStream->fActiveDirty) ? VERR_TRY_AGAIN : VINF_SUCCESS;
+
+    uint64_t const uOffsetActive = ASMAtomicReadU64(&pStream->uOffsetActive);
+    uint64_t const cbActive      = ASMAtomicReadU64(&pStream->cbActive);
+    if (   cbActive
+        && (  uOffset >= uOffsetActive
+            ? uOffset - uOffsetActive < cbActive
+            : uOffsetActive - uOffset < cbRange))
+        ASMAtomicWriteBool(&pStream->fActiveDirty, true);
+
+    return VINF_SUCCESS;
+}
+
+/**
+ * Internal: I/O context transfer function finding the ranges of the active
+ * chunk which are not allocated in the target image of the stream operation.
+ *
+ * The data of allocated ranges is read into the scratch buffer of the context
+ * and discarded.
+ */
+static DECLCALLBACK(int) vdStreamProbeAsync(PVDIOCTX pIoCtx)
+{
+    PVDISK    pDisk    = pIoCtx->pDisk;
+    PVDSTREAM pStream  = pDisk->pStream;
+    PVDIMAGE  pImage   = pStream->pImageTarget;
+    uint64_t  uOffset  = pIoCtx->Req.Io.uOffset;
+    size_t    cbToRead = pIoCtx->Req.Io.cbTransfer;
+    int       rc       = VINF_SUCCESS;
+
+    VD_IS_LOCKED(pDisk);
+
+    /* Don't look at blocks while a write is allocating them, the thread retries later. */
+    if (   pDisk->pIoCtxLockOwner != NIL_VDIOCTX
+        && uOffset < pDisk->uOffsetEndLocked
+        && pDisk->uOffsetStartLocked < uOffset + cbToRead)
+        return VERR_TRY_AGAIN;
+
+    while (cbToRead)
+    {
+        size_t cbThisRead = cbToRead;
+
+        rc = pImage->Backend->pfnRead(pImage->pBackendData, uOffset, cbThisRead,
+                                      pIoCtx, &cbThisRead);
+        if (rc == VERR_VD_BLOCK_FREE)
+        {
+            PRTRANGE pRange = pStream->cRanges ? &pStream->aRanges[pStream->cRanges - 1] : NULL;
+            if (   pRange
+                && pRange->offStart + pRange->cbRange == uOffset)
+                pRange->cbRange += cbThisRead;
+            else if (pStream->cRanges < RT_ELEMENTS(pStream->aRanges))
+            {
+                pRange = &pStream->aRanges[pStream->cRanges++];
+                pRange->offStart = uOffset;
+                pRange->cbRange  = cbThisRead;
+            }
+            else
+            {
+                /* Out of ranges, the rest of the chunk is handled by the next one. */
+                ASMAtomicWriteU64(&pStream->cbActive, uOffset - pStream->uOffsetActive);
+                cbToRead = 0;
+                rc = VINF_SUCCESS;
+                break;
+            }
+
+            RTSgBufAdvance(&pIoCtx->Req.Io.SgBuf, cbThisRead);
+            ASMAtomicSubU32(&pIoCtx->Req.Io.cbTransferLeft, (uint32_t)cbThisRead);
+            rc = VINF_SUCCESS;
+        }
+        else if (rc == VERR_VD_ASYNC_IO_IN_PROGRESS)
+            rc = VINF_SUCCESS;
+        else if (RT_FAILURE(rc))
+            break;
+
+        uOffset  += cbThisRead;
+        cbToRead -= cbThisRead;
+    }
+
+    /* Save the state for continuing after the metadata was read. */
+    pIoCtx->Req.Io.uOffset    = uOffset;
+    pIoCtx->Req.Io.cbTransfer = cbToRead;
+    return rc;
+}
+
+/**
+ * Internal: Finds the ranges of a chunk which are not allocated in the target image.
+ *
+ * @returns VBox status code.
+ * @param   pDisk       The disk.
+ * @param   pStream     The stream state.
+ * @param   pvBuf       Scratch buffer, VD_STREAM_CHUNK_SIZE bytes.
+ * @param   uOffset     Start of the chunk.
+ * @param   cbChunk     Size of the chunk.
+ */
+static int vdStreamProbe(PVDISK pDisk, PVDSTREAM pStream, void *pvBuf, uint64_t uOffset, size_t cbChunk)
+{
+    RTSGSEG Segment;
+    RTSGBUF SgBuf;
+    VDIOCTX IoCtx;
+    RTSEMEVENT hEventComplete = NIL_RTSEMEVENT;
+
+    int rc = RTSemEventCreate(&hEventComplete);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    pStream->cRanges = 0;
+    ASMAtomicWriteBool(&pStream->fActiveDirty, false);
+    ASMAtomicWriteU64(&pStream->uOffsetActive, uOffset);
+    ASMAtomicWriteU64(&pStream->cbActive, cbChunk);
+
+    Segment.pvSeg = pvBuf;
+    Segment.cbSeg = cbChunk;
+    RTSgBufInit(&SgBuf, &Segment, 1);
+    vdIoCtxInit(&IoCtx, pDisk, VDIOCTXTXDIR_READ, uOffset, cbChunk, pStream->pImageTarget, &SgBuf,
+                NULL, vdStreamProbeAsync, VDIOCTX_FLAGS_SYNC | VDIOCTX_FLAGS_DONT_FREE);
+    IoCtx.Type.Root.pfnComplete = vdIoCtxSyncComplete;
+    IoCtx.Type.Root.pvUser1     = pDisk;
+    IoCtx.Type.Root.pvUser2     = hEventComplete;
+    rc = vdIoCtxProcessSync(&IoCtx, hEventComplete);
+    RTSemEventDestroy(hEventComplete);
+    return rc;
+}
+
+/**
+ * Internal: Copies the parent data of one chunk into the target image.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_TRY_AGAIN if the chunk raced with guest I/O and must be retried.
+ * @param   pDisk       The disk.
+ * @param   pStream     The stream state.
+ * @param   pvBuf       Buffer, VD_STREAM_CHUNK_SIZE bytes.
+ * @param   uOffset     Start of the chunk.
+ * @param   pcbChunk    On input the size of the chunk, on output the amount processed.
+ */
+static int vdStreamChunk(PVDISK pDisk, PVDSTREAM pStream, void *pvBuf, uint64_t uOffset, size_t *pcbChunk)
+{
+    PVDIMAGE pImage = pStream->pImageTarget;
+
+    int rc = vdStreamProbe(pDisk, pStream, pvBuf, uOffset, *pcbChunk);
+    if (RT_SUCCESS(rc))
+    {
+        *pcbChunk = (size_t)ASMAtomicReadU64(&pStream->cbActive);
+
+        for (uint32_t i = 0; i < pStream->cRanges && RT_SUCCESS(rc); i++)
+        {
+            PCRTRANGE pRange = &pStream->aRanges[i];
+
+            /* Bypass the cache as it might have newer data. */
+            rc = vdReadHelperEx(pDisk, pImage, pImage->pPrev, pRange->offStart, pvBuf, pRange->cbRange,
+                                true /* fZeroFreeBlocks */, false /* fUpdateCache */, 0);
+            if (   RT_SUCCESS(rc)
+                && !ASMMemIsZero(pvBuf, pRange->cbRange))
+                rc = vdWriteHelper(pDisk, pImage, pRange->offStart, pvBuf, pRange->cbRange,
+                                   VDIOCTX_FLAGS_STREAM | VDIOCTX_FLAGS_CACHE_BYPASS);
+        }
+    }
+
+    ASMAtomicWriteU64(&pStream->cbActive, 0);
+    return rc;
+}
+
+/**
+ * Internal: Removes the parent images from the chain once everything was copied
+ * into the target image.
+ *
+ * @returns VBox status code.
+ * @param   pDisk       The disk.
+ * @param   pStream     The stream state.
+ */
+static int vdStreamDropParents(PVDISK pDisk, PVDSTREAM pStream)
+{
+    PVDIMAGE pImage = pStream->pImageTarget;
+
+    /* The copied data must be on the medium before the parent goes away. */
+    int rc = vdFlushHelper(pDisk);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    /* No I/O context must be processed while the chain is changed. */
+    while (!ASMAtomicCmpXchgBool(&pDisk->fLocked, true, false))
+        RTThreadSleep(1);
+
+    RTUUID Uuid;
+    RTUuidClear(&Uuid);
+    rc = pImage->Backend->pfnSetParentUuid(pImage->pBackendData, &Uuid);
+    if (RT_SUCCESS(rc))
+    {
+        pImage->Backend->pfnSetParentModificationUuid(pImage->pBackendData, &Uuid);
+
+        /* I/O started before might still walk the parents, so they are kept
+         * open until the container is closed. */
+        PVDIMAGE pParent = pImage->pPrev;
+        while (pParent)
+        {
+            PVDIMAGE pPrev = pParent->pPrev;
+            pParent->pRetiredNext = pDisk->pImagesRetired;
+            pDisk->pImagesRetired = pParent;
+            pDisk->cImages--;
+            pParent = pPrev;
+        }
+
+        pImage->pPrev = NULL;
+        pDisk->pBase  = pImage;
+        vdOwnerIdxDestroy(pDisk);
+        if (pDisk->pReadAhead)
+            vdReadAheadInvalidate(pDisk, 0, UINT64_MAX);
+    }
+
+    vdDiskUnlock(pDisk, NULL);
+
+    if (RT_SUCCESS(rc))
+        rc = vdFlushHelper(pDisk);
+    return rc;
+}
+
+/**
+ * Internal: The background thread of the stream operation.
+ */
+static DECLCALLBACK(int) vdStreamThread(RTTHREAD hThread, void *pvUser)
+{
+    PVDISK    pDisk   = (PVDISK)pvUser;
+    PVDSTREAM pStream = pDisk->pStream;
+    uint64_t  uOffset = 0;
+    uint64_t  cbCopied = 0;
+    uint64_t  tsStart = RTTimeMilliTS();
+    int       rc = VINF_SUCCESS;
+
+    RT_NOREF(hThread);
+
+    void *pvBuf = RTMemTmpAlloc(VD_STREAM_CHUNK_SIZE);
+    if (!pvBuf)
+        rc = VERR_NO_MEMORY;
+
+    while (   RT_SUCCESS(rc)
+           && uOffset < pStream->cbDisk)
+    {
+        if (ASMAtomicReadBool(&pStream->fCancel))
+        {
+            rc = VERR_CANCELLED;
+            break;
+        }
+
+        size_t cbChunk = (size_t)RT_MIN(VD_STREAM_CHUNK_SIZE, pStream->cbDisk - uOffset);
+        rc = vdStreamChunk(pDisk, pStream, pvBuf, uOffset, &cbChunk);
+        if (rc == VERR_TRY_AGAIN)
+        {
+            /* Raced with guest I/O, give it some room and retry. */
+            RTSemEventWait(pStream->hEvtCancel, VD_STREAM_RETRY_INTERVAL_MS);
+            rc = VINF_SUCCESS;
+            continue;
+        }
+        if (RT_FAILURE(rc))
+            break;
+
+        uOffset  += cbChunk;
+        cbCopied += cbChunk;
+        ASMAtomicWriteU64(&pStream->cbDone, uOffset);
+
+        /* Rate limit. */
+        if (pStream->cbPerSecMax)
+        {
+            uint64_t const cMsTarget  = cbCopied * RT_MS_1SEC / pStream->cbPerSecMax;
+            uint64_t const cMsElapsed = RTTimeMilliTS() - tsStart;
+            if (cMsTarget > cMsElapsed)
+                RTSemEventWait(pStream->hEvtCancel, (RTMSINTERVAL)RT_MIN(cMsTarget - cMsElapsed, RT_MS_1SEC));
+        }
+    }
+
+    if (pvBuf)
+        RTMemTmpFree(pvBuf);
+
+    if (   RT_SUCCESS(rc)
+        && !ASMAtomicReadBool(&pStream->fCancel))
+        rc = vdStreamDropParents(pDisk, pStream);
+    else if (RT_SUCCESS(rc))
+        rc = VERR_CANCELLED;
+
+    if (RT_FAILURE(rc) && rc != VERR_CANCELLED)
+        LogRel(("VD: Streaming the parent images into '%s' failed with %Rrc\n",
+                pStream->pImageTarget->pszFilename, rc));
+
+    pStream->rcStream = rc;
+    ASMAtomicWriteBool(&pStream->fDone, true);
+    if (pStream->pfnComplete)
+        pStream->pfnComplete(pStream->pvUser, rc);
+    return VINF_SUCCESS;
+}
+
+/**
+ * Internal: Stops the stream operation and frees its state.
+ *
+ * Must not be called with the disk lock held, the thread might wait for it.
+ * Does nothing when called from the completion callback of the stream.
+ *
+ * @param   pDisk       The disk.
+ */
+static void vdStreamStop(PVDISK pDisk)
+{
+    PVDSTREAM pStream = pDisk->pStream;
+    if (   !pStream
+        || RTThreadSelf() == pStream->hThread)
+        return;
+
+    ASMAtomicWriteBool(&pStream->fCancel, true);
+    RTSemEventSignal(pStream->hEvtCancel);
+    int rc = RTThreadWait(pStream->hThread, RT_INDEFINITE_WAIT, NULL);
+    AssertRC(rc);
 
-            if (pIfProgress && pIfProgress->pfnProgress)
-            {
-                rc = pIfProgress->pfnProgress(pIfProgress->Core.pvUser,
-                                              uProgressOld);
-                if (RT_FAILURE(rc))
-                    break;
-            }
-            if (pDstIfProgress && pDstIfProgress->pfnProgress)
-            {
-                rc = pDstIfProgress->pfnProgress(pDstIfProgress->Core.pvUser,
-                                                 uProgressOld);
-                if (RT_FAILURE(rc))
-                    break;
-            }
-        }
-    } while (uOffset < cbSize);
+    pDisk->pStream = NULL;
+    RTSemEventDestroy(pStream->hEvtCancel);
+    RTMemFree(pStream);
+}
 
-    RTMemFree(pvBuf);
+/**
+ * Internal: Closes the images removed from the chain by the stream operation.
+ *
+ * @returns VBox status code.
+ * @param   pDisk       The disk.
+ */
+static int vdStreamCloseRetired(PVDISK pDisk)
+{
+    int rc = VINF_SUCCESS;
 
-    if (fLockReadFrom)
+    while (pDisk->pImagesRetired)
     {
-        rc2 = vdThreadFinishRead(pDiskFrom);
-        AssertRC(rc2);
-    }
+        PVDIMAGE pImage = pDisk->pImagesRetired;
+        pDisk->pImagesRetired = pImage->pRetiredNext;
 
-    if (fLockWriteTo)
-    {
-        rc2 = vdThreadFinishWrite(pDiskTo);
-        AssertRC(rc2);
+        int rc2 = pImage->Backend->pfnClose(pImage->pBackendData, false);
+        if (RT_FAILURE(rc2) && RT_SUCCESS(rc))
+            rc = rc2;
+        RTStrFree(pImage->pszFilename);
+        RTMemFree(pImage);
     }
 
-    LogFlowFunc(("returns rc=%Rrc\n", rc));
     return rc;
 }
 
@@ -2645,6 +4260,13 @@ static DECLCALLBACK(int) vdWriteHelperAsync(PVDIOCTX pIoCtx)
     size_t cbThisWrite;
     size_t cbPreRead, cbPostRead;
 
+    if (pDisk->pStream)
+    {
+        rc = vdStreamCheckWrite(pDisk, pIoCtx, uOffset, cbWrite);
+        if (RT_FAILURE(rc))
+            return rc;
+    }
+
     /* Apply write filter chain here if it was not done already. */
     if (!(pIoCtx->fFlags & VDIOCTX_FLAGS_WRITE_FILTER_APPLIED))
     {
@@ -2652,6 +4274,14 @@ static DECLCALLBACK(int) vdWriteHelperAsync(PVDIOCTX pIoCtx)
         if (RT_FAILURE(rc))
             return rc;
         pIoCtx->fFlags |= VDIOCTX_FLAGS_WRITE_FILTER_APPLIED;
+
+        /* Keep the data already in a write-through cache up to date. */
+        if (   pDisk->pCache
+            && pDisk->pCache->enmMode != VDCACHEMODE_WRITE_BACK
+            && pDisk->pCache->Backend->pfnFill
+            && pImage == pDisk->pLast
+            && !pIoCtx->Req.Io.pImageParentOverride)
+            vdCacheWriteThroughUpdate(pDisk->pCache, pIoCtx, uOffset, cbWrite);
     }
 
     if (!(pIoCtx->fFlags & VDIOCTX_FLAGS_DONT_SET_MODIFIED_FLAG))
@@ -2665,6 +4295,8 @@ static DECLCALLBACK(int) vdWriteHelperAsync(PVDIOCTX pIoCtx)
     if (RT_FAILURE(rc))
         return rc;
 
+    vdOwnerIdxWrite(pDisk, pImage, uOffset, cbWrite);
+
     /* Loop until all written. */
     do
     {
@@ -2690,6 +4322,25 @@ static DECLCALLBACK(int) vdWriteHelperAsync(PVDIOCTX pIoCtx)
             break;
         }
 
+        /* A write-back cache absorbs the write if it has room, it goes to the image later. */
+        if (   pDisk->pCache
+            && pDisk->pCache->enmMode == VDCACHEMODE_WRITE_BACK
+            && pImage == pDisk->pLast
+            && !pIoCtx->Req.Io.pImageParentOverride
+            && !(pIoCtx->fFlags & VDIOCTX_FLAGS_CACHE_BYPASS))
+        {
+            rc = vdCacheWriteHelper(pDisk->pCache, uOffset, cbThisWrite, pIoCtx, &cbThisWrite);
+            if (RT_SUCCESS(rc))
+            {
+                cbWrite -= cbThisWrite;
+                uOffset += cbThisWrite;
+                continue;
+            }
+            else if (rc != VERR_VD_BLOCK_FREE)
+                break;
+            /* No room in the cache, write the range to the image. */
+        }
+
         fWrite =   (pImage->uOpenFlags & VD_OPEN_FLAGS_HONOR_SAME)
                  ? 0 : VD_WRITE_NO_ALLOC;
         rc = pImage->Backend->pfnWrite(pImage->pBackendData, uOffset, cbThisWrite,
@@ -3088,6 +4739,10 @@ static DECLCALLBACK(int) vdDiscardHelperAsync(PVDIOCTX pIoCtx)
         return VINF_SUCCESS;
     }
 
+    /* Deallocating blocks changes what the stream operation found, let it probe again. */
+    if (pDisk->pStream)
+        vdStreamCheckWrite(pDisk, pIoCtx, 0, UINT64_MAX);
+
     if (pDisk->pIoCtxLockOwner != pIoCtx)
         rc = vdIoCtxLockDisk(pDisk, pIoCtx);
 
@@ -3116,6 +4771,11 @@ static DECLCALLBACK(int) vdDiscardHelperAsync(PVDIOCTX pIoCtx)
             LogFlowFunc(("New range descriptor loaded (%u) offStart=%llu cbDiscard=%zu\n",
                          pIoCtx->Req.Discard.idxRange, offStart, cbDiscardLeft));
             pIoCtx->Req.Discard.idxRange++;
+
+            /* The cache must not return the discarded data anymore. */
+            if (   pDisk->pCache
+                && pDisk->pCache->Backend->pfnInvalidate)
+                pDisk->pCache->Backend->pfnInvalidate(pDisk->pCache->pBackendData, offStart, cbDiscardLeft);
         }
 
         /* Look for a matching block in the AVL tree first. */
@@ -3799,6 +5459,7 @@ static DECLCALLBACK(int) vdIOIntOpen(void *pvUser, const char *pszLocation,
         if (RT_SUCCESS(rc))
         {
             pIoStorage->pVDIo = pVDIo;
+            pIoStorage->uLocationCrc = RTCrc64(pszLocation, strlen(pszLocation));
             *ppIoStorage = pIoStorage;
             return VINF_SUCCESS;
         }
@@ -3826,6 +5487,8 @@ static DECLCALLBACK(int) vdIOIntClose(void *pvUser, PVDIOSTORAGE pIoStorage)
 
     /* We free everything here, even if closing the file failed for some reason. */
     rc = pVDIo->pInterfaceIo->pfnClose(pVDIo->pInterfaceIo->Core.pvUser, pIoStorage->pStorage);
+    if (pIoStorage->pSharedCache)
+        vdSharedCacheClose(pIoStorage->pSharedCache);
     RTAvlrFileOffsetDestroy(pIoStorage->pTreeMetaXfers, vdIOIntTreeMetaXferDestroy, NULL);
     RTMemFree(pIoStorage->pTreeMetaXfers);
     RTMemFree(pIoStorage);
@@ -3938,6 +5601,100 @@ static DECLCALLBACK(int) vdIOIntSetAllocationSize(void *pvUser, PVDIOSTORAGE pIo
     return rc;
 }
 
+/**
+ * Shared read cache fill record for an asynchronous read.
+ */
+typedef struct VDSHAREDCACHEFILL
+{
+    /** The shared cache to fill. */
+    PVDSHAREDCACHE      pSharedCache;
+    /** The cache generation before the read was issued. */
+    uint32_t            uGeneration;
+    /** Number of segments. */
+    unsigned            cSegs;
+    /** File offset of the read. */
+    uint64_t            off;
+    /** Number of bytes read. */
+    size_t              cb;
+    /** The segments the data is read into. */
+    RTSGSEG             aSegs[1];
+} VDSHAREDCACHEFILL;
+/** Pointer to a shared read cache fill record. */
+typedef VDSHAREDCACHEFILL *PVDSHAREDCACHEFILL;
+
+/**
+ * Returns the shared read cache of the given storage, opening it on first use.
+ *
+ * @returns Shared read cache or NULL if not enabled or not available.
+ * @param   pIoStorage      The storage handle.
+ */
+static PVDSHAREDCACHE vdIoStorageSharedCacheGet(PVDIOSTORAGE pIoStorage)
+{
+    PVDIO pVDIo = pIoStorage->pVDIo;
+    uint64_t const cbSharedCache = ASMAtomicReadU64(&pVDIo->cbSharedCache);
+    if (!cbSharedCache)
+        return NULL;
+
+    PVDSHAREDCACHE pSharedCache = ASMAtomicReadPtrT(&pIoStorage->pSharedCache, PVDSHAREDCACHE);
+    if (pSharedCache || pIoStorage->fSharedCacheFailed)
+        return pSharedCache;
+
+    /* The name identifies the file content: UUID, modification UUID and location. */
+    uint64_t uKey = RTCrc64Start();
+    uKey = RTCrc64Process(uKey, &pVDIo->SharedCacheUuidModification, sizeof(RTUUID));
+    uKey = RTCrc64Process(uKey, &pIoStorage->uLocationCrc, sizeof(pIoStorage->uLocationCrc));
+    uKey = RTCrc64Finish(uKey);
+
+    char szName[64];
+    RTStrPrintf(szName, sizeof(szName), "VBoxVDSC-%RTuuid-%016RX64", &pVDIo->SharedCacheUuid, uKey);
+    int rc = vdSharedCacheOpen(szName, cbSharedCache, &pSharedCache);
+    if (RT_FAILURE(rc))
+    {
+        ASMAtomicWriteBool(&pIoStorage->fSharedCacheFailed, true);
+        return NULL;
+    }
+
+    /* Somebody might have raced us with a synchronous read. */
+    if (!ASMAtomicCmpXchgPtr(&pIoStorage->pSharedCache, pSharedCache, NULL))
+    {
+        vdSharedCacheClose(pSharedCache);
+        pSharedCache = ASMAtomicReadPtrT(&pIoStorage->pSharedCache, PVDSHAREDCACHE);
+    }
+
+    return pSharedCache;
+}
+
+/**
+ * Disables the shared read cache for the image of the given storage before
+ * it gets modified and invalidates the cached data for all processes.
+ *
+ * @param   pIoStorage      The storage handle.
+ */
+DECLINLINE(void) vdIoStorageSharedCacheDisable(PVDIOSTORAGE pIoStorage)
+{
+    PVDSHAREDCACHE pSharedCache = ASMAtomicReadPtrT(&pIoStorage->pSharedCache, PVDSHAREDCACHE);
+    if (RT_UNLIKELY(pSharedCache))
+    {
+        ASMAtomicWriteU64(&pIoStorage->pVDIo->cbSharedCache, 0);
+        vdSharedCacheInvalidate(pSharedCache);
+    }
+}
+
+/**
+ * I/O completion callback putting the data of an asynchronous read into the
+ * shared read cache.
+ */
+static DECLCALLBACK(int) vdIOIntReadUserSharedCacheFill(void *pBackendData, PVDIOCTX pIoCtx, void *pvUser, int rcReq)
+{
+    RT_NOREF(pBackendData, pIoCtx);
+    PVDSHAREDCACHEFILL pFill = (PVDSHAREDCACHEFILL)pvUser;
+
+    if (RT_SUCCESS(rcReq))
+        vdSharedCacheFill(pFill->pSharedCache, pFill->uGeneration, pFill->off, &pFill->aSegs[0], pFill->cSegs, pFill->cb);
+    RTMemFree(pFill);
+    return VINF_SUCCESS;
+}
+
 static DECLCALLBACK(int) vdIOIntReadUser(void *pvUser, PVDIOSTORAGE pIoStorage, uint64_t uOffset,
                                          PVDIOCTX pIoCtx, size_t cbRead)
 {
@@ -3954,6 +5711,20 @@ static DECLCALLBACK(int) vdIOIntReadUser(void *pvUser, PVDIOSTORAGE pIoStorage,
 
     Assert(cbRead > 0);
 
+    /* Try the shared read cache first. */
+    PVDSHAREDCACHE pSharedCache = vdIoStorageSharedCacheGet(pIoStorage);
+    uint32_t       uSharedCacheGen = 0;
+    if (pSharedCache)
+    {
+        if (vdSharedCacheRead(pSharedCache, uOffset, &pIoCtx->Req.Io.SgBuf, cbRead))
+        {
+            Assert(cbRead == (uint32_t)cbRead);
+            ASMAtomicSubU32(&pIoCtx->Req.Io.cbTransferLeft, (uint32_t)cbRead);
+            return VINF_SUCCESS;
+        }
+        uSharedCacheGen = vdSharedCacheGetGeneration(pSharedCache);
+    }
+
     if (   (pIoCtx->fFlags & VDIOCTX_FLAGS_SYNC)
         || !pVDIo->pInterfaceIo->pfnReadAsync)
     {
@@ -3976,6 +5747,8 @@ static DECLCALLBACK(int) vdIOIntReadUser(void *pvUser, PVDIOSTORAGE pIoStorage,
         {
             Assert(cbRead == (uint32_t)cbRead);
             ASMAtomicSubU32(&pIoCtx->Req.Io.cbTransferLeft, (uint32_t)cbRead);
+            if (pSharedCache)
+                vdSharedCacheFill(pSharedCache, uSharedCacheGen, uOffset, &Seg, 1, cbRead);
         }
     }
     else
@@ -3999,11 +5772,32 @@ static DECLCALLBACK(int) vdIOIntReadUser(void *pvUser, PVDIOSTORAGE pIoStorage,
                               ("Segment %u is invalid\n", i));
 #endif
 
+            /* Remember where the data goes if it can be put into the shared read cache. */
+            PVDSHAREDCACHEFILL pFill = NULL;
+            if (   pSharedCache
+                && vdSharedCacheCanFill(pSharedCache, uOffset, cbTaskRead))
+            {
+                pFill = (PVDSHAREDCACHEFILL)RTMemAlloc(RT_UOFFSETOF_DYN(VDSHAREDCACHEFILL, aSegs[cSegments]));
+                if (pFill)
+                {
+                    pFill->pSharedCache = pSharedCache;
+                    pFill->uGeneration  = uSharedCacheGen;
+                    pFill->cSegs        = cSegments;
+                    pFill->off          = uOffset;
+                    pFill->cb           = cbTaskRead;
+                    memcpy(&pFill->aSegs[0], &aSeg[0], cSegments * sizeof(RTSGSEG));
+                }
+            }
+
             Assert(cbTaskRead == (uint32_t)cbTaskRead);
-            PVDIOTASK pIoTask = vdIoTaskUserAlloc(pIoStorage, NULL, NULL, pIoCtx, (uint32_t)cbTaskRead);
+            PVDIOTASK pIoTask = vdIoTaskUserAlloc(pIoStorage, pFill ? vdIOIntReadUserSharedCacheFill : NULL, pFill,
+                                                  pIoCtx, (uint32_t)cbTaskRead);
 
             if (!pIoTask)
+            {
+                RTMemFree(pFill);
                 return VERR_NO_MEMORY;
+            }
 
             ASMAtomicIncU32(&pIoCtx->cDataTransfersPending);
 
@@ -4019,11 +5813,14 @@ static DECLCALLBACK(int) vdIOIntReadUser(void *pvUser, PVDIOSTORAGE pIoStorage,
                 ASMAtomicSubU32(&pIoCtx->Req.Io.cbTransferLeft, (uint32_t)cbTaskRead);
                 ASMAtomicDecU32(&pIoCtx->cDataTransfersPending);
                 vdIoTaskFree(pDisk, pIoTask);
+                if (pFill)
+                    vdIOIntReadUserSharedCacheFill(NULL, pIoCtx, pFill, VINF_SUCCESS);
             }
             else if (rc != VERR_VD_ASYNC_IO_IN_PROGRESS)
             {
                 ASMAtomicDecU32(&pIoCtx->cDataTransfersPending);
                 vdIoTaskFree(pDisk, pIoTask);
+                RTMemFree(pFill);
                 break;
             }
 
@@ -4053,6 +5850,8 @@ static DECLCALLBACK(int) vdIOIntWriteUser(void *pvUser, PVDIOSTORAGE pIoStorage,
 
     Assert(cbWrite > 0);
 
+    vdIoStorageSharedCacheDisable(pIoStorage);
+
     if (   (pIoCtx->fFlags & VDIOCTX_FLAGS_SYNC)
         || !pVDIo->pInterfaceIo->pfnWriteAsync)
     {
@@ -4281,6 +6080,8 @@ static DECLCALLBACK(int) vdIOIntWriteMeta(void *pvUser, PVDIOSTORAGE pIoStorage,
                     ("A synchronous metadata write is requested but the parameters are wrong\n"),
                     VERR_INVALID_POINTER);
 
+    vdIoStorageSharedCacheDisable(pIoStorage);
+
     /** @todo Enable check for sync I/O later. */
     if (   pIoCtx
         && !(pIoCtx->fFlags & VDIOCTX_FLAGS_SYNC))
@@ -4496,7 +6297,7 @@ static DECLCALLBACK(int) vdIOIntFlush(void *pvUser, PVDIOSTORAGE pIoStorage, PVD
         if (!pMetaXfer)
             return VERR_NO_MEMORY;
 
-        pIoTask = vdIoTaskMetaAlloc(pIoStorage, pfnComplete, pvUser, pMetaXfer);
+        pIoTask = vdIoTaskMetaAlloc(pIoStorage, pfnComplete, pvCompleteUser, pMetaXfer);
         if (!pIoTask)
         {
             RTMemFree(pMetaXfer);
@@ -5272,6 +7073,7 @@ VBOXDDU_DECL(int) VDDestroy(PVDISK pDisk)
         Assert(!pDisk->fLocked);
 
         rc = VDCloseAll(pDisk);
+        vdReadAheadDestroy(pDisk);
         int rc2 = VDFilterRemoveAll(pDisk);
         if (RT_SUCCESS(rc))
             rc = rc2;
@@ -5717,6 +7519,25 @@ VBOXDDU_DECL(int) VDOpen(PVDISK pDisk, const char *pszBackend,
 
         if (RT_SUCCESS(rc))
         {
+            /*
+             * Read-only images can use the host-wide shared read cache if enabled,
+             * provided they have a UUID to tell them apart.
+             */
+            if (   pDisk->cbSharedReadCache
+                && (uOpenFlags & VD_OPEN_FLAGS_READONLY)
+                && !(uOpenFlags & VD_OPEN_FLAGS_INFO))
+            {
+                rc2 = pImage->Backend->pfnGetUuid(pImage->pBackendData, &pImage->VDIo.SharedCacheUuid);
+                if (RT_SUCCESS(rc2) && !RTUuidIsNull(&pImage->VDIo.SharedCacheUuid))
+                {
+                    rc2 = pImage->Backend->pfnGetModificationUuid(pImage->pBackendData,
+                                                                  &pImage->VDIo.SharedCacheUuidModification);
+                    if (RT_FAILURE(rc2))
+                        RTUuidClear(&pImage->VDIo.SharedCacheUuidModification);
+                    pImage->VDIo.cbSharedCache = pDisk->cbSharedReadCache;
+                }
+            }
+
             /* Image successfully opened, make it the last image. */
             vdAddImageToList(pDisk, pImage);
             if (!(uOpenFlags & VD_OPEN_FLAGS_READONLY))
@@ -5873,7 +7694,21 @@ VBOXDDU_DECL(int) VDCacheOpen(PVDISK pDisk, const char *pszBackend,
             if (RT_SUCCESS(rc))
             {
                 if (RTUuidCompare(&UuidImage, &UuidCache))
-                    rc = VERR_VD_CACHE_NOT_UP_TO_DATE;
+                {
+                    /*
+                     * Dirty data in a write-back cache is newer than the image, dropping
+                     * the cache would lose it. The UUIDs differ if the host crashed between
+                     * updating the image and the cache.
+                     */
+                    uint64_t cbDirty =   pCache->Backend->pfnGetDirtySize
+                                       ? pCache->Backend->pfnGetDirtySize(pCache->pBackendData)
+                                       : 0;
+                    if (cbDirty)
+                        LogRel(("VD: Cache '%s' is out of sync with the image but holds %llu bytes of dirty data, keeping it\n",
+                                pszFilename, cbDirty));
+                    else
+                        rc = VERR_VD_CACHE_NOT_UP_TO_DATE;
+                }
             }
         }
 
@@ -5888,7 +7723,11 @@ VBOXDDU_DECL(int) VDCacheOpen(PVDISK pDisk, const char *pszBackend,
         {
             /* Cache successfully opened, make it the current one. */
             if (!pDisk->pCache)
-                pDisk->pCache = pCache;
+            {
+                rc = vdCacheThreadStart(pCache);
+                if (RT_SUCCESS(rc))
+                    pDisk->pCache = pCache;
+            }
             else
                 rc = VERR_VD_CACHE_ALREADY_EXISTS;
         }
@@ -6355,6 +8194,10 @@ VBOXDDU_DECL(int) VDCreateDiff(PVDISK pDisk, const char *pszBackend,
         AssertRC(rc2);
         fLockWrite = true;
         rc = vdDiscardStateDestroy(pDisk);
+        if (RT_FAILURE(rc))
+            break;
+        /* Dirty data in the cache belongs to the image which becomes the parent. */
+        rc = vdCacheWriteBack(pDisk, 0 /* cbMax */);
         if (RT_FAILURE(rc))
             break;
         rc2 = vdThreadFinishWrite(pDisk);
@@ -6709,6 +8552,9 @@ VBOXDDU_DECL(int) VDCreateCache(PVDISK pDisk, const char *pszBackend,
                 rc = VINF_SUCCESS;
         }
 
+        if (RT_SUCCESS(rc))
+            rc = vdCacheThreadStart(pCache);
+
         if (RT_SUCCESS(rc))
         {
             /* Cache successfully created. */
@@ -6752,12 +8598,32 @@ VBOXDDU_DECL(int) VDCreateCache(PVDISK pDisk, const char *pszBackend,
 }
 
 
+/**
+ * Sleeps as long as needed to keep the merge within the configured rate.
+ *
+ * @param   cbPerSecMax     Maximum number of bytes copied per second, 0 for no limit.
+ * @param   tsStart         Millisecond timestamp the merge started at.
+ * @param   cbCopied        Number of bytes copied so far.
+ */
+static void vdMergeThrottle(uint64_t cbPerSecMax, uint64_t tsStart, uint64_t cbCopied)
+{
+    if (!cbPerSecMax)
+        return;
+
+    uint64_t const cMsTarget  = cbCopied * RT_MS_1SEC / cbPerSecMax;
+    uint64_t const cMsElapsed = RTTimeMilliTS() - tsStart;
+    if (cMsTarget > cMsElapsed)
+        RTThreadSleep((RTMSINTERVAL)RT_MIN(cMsTarget - cMsElapsed, RT_MS_1SEC));
+}
+
+
 VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
                           unsigned nImageTo, PVDINTERFACE pVDIfsOperation)
 {
     int rc = VINF_SUCCESS;
     int rc2;
     bool fLockWrite = false, fLockRead = false;
+    bool fCacheWriteBack = false;
     void *pvBuf = NULL;
 
     LogFlowFunc(("pDisk=%#p nImageFrom=%u nImageTo=%u pVDIfsOperation=%#p\n",
@@ -6776,6 +8642,9 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
         rc2 = vdThreadStartWrite(pDisk);
         AssertRC(rc2);
         fLockWrite = true;
+        vdOwnerIdxDestroy(pDisk);
+        vdStreamStop(pDisk);
+        vdReadAheadQuiesce(pDisk);
         PVDIMAGE pImageFrom = vdGetImageByNumber(pDisk, nImageFrom);
         PVDIMAGE pImageTo = vdGetImageByNumber(pDisk, nImageTo);
         if (!pImageFrom || !pImageTo)
@@ -6785,6 +8654,18 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
         }
         AssertBreakStmt(pImageFrom != pImageTo, rc = VERR_INVALID_PARAMETER);
 
+        /* The merge works on the images directly, so dirty data has to be in the
+         * image and no new dirty data must be created while the merge runs. */
+        if (   pDisk->pCache
+            && pDisk->pCache->enmMode == VDCACHEMODE_WRITE_BACK)
+        {
+            pDisk->pCache->enmMode = VDCACHEMODE_WRITE_THROUGH;
+            fCacheWriteBack = true;
+            rc = vdCacheWriteBack(pDisk, 0 /* cbMax */);
+            if (RT_FAILURE(rc))
+                break;
+        }
+
         /* Make sure destination image is writable. */
         unsigned uOpenFlags = pImageTo->Backend->pfnGetOpenFlags(pImageTo->pBackendData);
         if (uOpenFlags & VD_OPEN_FLAGS_READONLY)
@@ -6802,10 +8683,17 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
 
         /* Get size of destination image. */
         uint64_t cbSize = vdImageGetSize(pImageTo);
+        uint64_t const cbPerSecMax = pDisk->cbMergePerSecMax;
         rc2 = vdThreadFinishWrite(pDisk);
         AssertRC(rc2);
         fLockWrite = false;
 
+        /* With a rate limit work on smaller chunks, so that guest I/O doesn't
+         * wait on the disk lock for the whole time a big chunk is copied. */
+        size_t const cbChunk = cbPerSecMax ? VD_MERGE_CHUNK_SIZE_LIMITED : VD_MERGE_BUFFER_SIZE;
+        uint64_t const tsStart = RTTimeMilliTS();
+        uint64_t cbCopied = 0;
+
         /* Allocate tmp buffer. */
         pvBuf = RTMemTmpAlloc(VD_MERGE_BUFFER_SIZE);
         if (!pvBuf)
@@ -6826,7 +8714,7 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
 
             do
             {
-                size_t cbThisRead = RT_MIN(VD_MERGE_BUFFER_SIZE, cbRemaining);
+                size_t cbThisRead = RT_MIN(cbChunk, cbRemaining);
                 RTSGSEG SegmentBuf;
                 RTSGBUF SgBuf;
                 VDIOCTX IoCtx;
@@ -6881,6 +8769,7 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
                                              VDIOCTX_FLAGS_READ_UPDATE_CACHE, 0);
                         if (RT_FAILURE(rc))
                             break;
+                        cbCopied += cbThisRead;
                     }
                     else
                         rc = VINF_SUCCESS;
@@ -6894,6 +8783,7 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
 
                 uOffset += cbThisRead;
                 cbRemaining -= cbThisRead;
+                vdMergeThrottle(cbPerSecMax, tsStart, cbCopied);
 
                 if (pIfProgress && pIfProgress->pfnProgress)
                 {
@@ -6967,7 +8857,7 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
             uint64_t cbRemaining = cbSize;
             do
             {
-                size_t cbThisRead = RT_MIN(VD_MERGE_BUFFER_SIZE, cbRemaining);
+                size_t cbThisRead = RT_MIN(cbChunk, cbRemaining);
                 RTSGSEG SegmentBuf;
                 RTSGBUF SgBuf;
                 VDIOCTX IoCtx;
@@ -7017,6 +8907,7 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
                                        cbThisRead, VDIOCTX_FLAGS_READ_UPDATE_CACHE);
                     if (RT_FAILURE(rc))
                         break;
+                    cbCopied += cbThisRead;
                 }
                 else
                     rc = VINF_SUCCESS;
@@ -7027,6 +8918,7 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
 
                 uOffset += cbThisRead;
                 cbRemaining -= cbThisRead;
+                vdMergeThrottle(cbPerSecMax, tsStart, cbCopied);
 
                 unsigned uProgressNew = uOffset * 99 / cbSize;
                 if (uProgressNew != uProgressOld)
@@ -7170,6 +9062,9 @@ VBOXDDU_DECL(int) VDMerge(PVDISK pDisk, unsigned nImageFrom,
         }
     } while (0);
 
+    if (fCacheWriteBack && pDisk->pCache)
+        pDisk->pCache->enmMode = VDCACHEMODE_WRITE_BACK;
+
     if (RT_UNLIKELY(fLockWrite))
     {
         rc2 = vdThreadFinishWrite(pDisk);
@@ -7416,10 +9311,20 @@ VBOXDDU_DECL(int) VDCopyEx(PVDISK pDiskFrom, unsigned nImageFrom, PVDISK pDiskTo
         else
             cImagesToReadBack = pDiskTo->cImages - nImageToSame - 1;
 
+        /* Number of chunks in flight when copying, 1 disables the pipeline. */
+        uint32_t cPipelineDepth = VD_COPY_PIPELINE_DEPTH_DEF;
+        PVDINTERFACECONFIG pIfCfg = VDIfConfigGet(pVDIfsOperation);
+        if (pIfCfg)
+        {
+            rc = VDCFGQueryU32Def(pIfCfg, "CopyPipelineDepth", &cPipelineDepth, VD_COPY_PIPELINE_DEPTH_DEF);
+            if (RT_FAILURE(rc))
+                break;
+        }
+
         /* Copy the data. */
         rc = vdCopyHelper(pDiskFrom, pImageFrom, pDiskTo, pImageTo, cbSize,
                           cImagesFromReadBack, cImagesToReadBack,
-                          fSuppressRedundantIo, pIfProgress, pDstIfProgress);
+                          fSuppressRedundantIo, cPipelineDepth, pIfProgress, pDstIfProgress);
 
         if (RT_SUCCESS(rc))
         {
@@ -7569,6 +9474,9 @@ VBOXDDU_DECL(int) VDCompact(PVDISK pDisk, unsigned nImage,
         rc2 = vdThreadStartWrite(pDisk);
         AssertRC(rc2);
         fLockWrite = true;
+        vdOwnerIdxDestroy(pDisk);
+        vdStreamStop(pDisk);
+        vdReadAheadQuiesce(pDisk);
 
         rc = pImage->Backend->pfnCompact(pImage->pBackendData,
                                          0, 99,
@@ -7699,6 +9607,9 @@ VBOXDDU_DECL(int) VDResize(PVDISK pDisk, uint64_t cbSize,
         /* Mark the image size as uninitialized so it gets recalculated the next time. */
         if (RT_SUCCESS(rc))
             pImage->cbImage = VD_IMAGE_SIZE_UNINITIALIZED;
+        vdOwnerIdxDestroy(pDisk);
+        vdStreamStop(pDisk);
+        vdReadAheadQuiesce(pDisk);
     } while (0);
 
     if (RT_UNLIKELY(fLockWrite))
@@ -7759,6 +9670,7 @@ VBOXDDU_DECL(int) VDPrepareWithFilters(PVDISK pDisk, PVDINTERFACE pVDIfsOperatio
         rc2 = vdThreadStartWrite(pDisk);
         AssertRC(rc2);
         fLockWrite = true;
+        vdReadAheadQuiesce(pDisk);
 
         /*
          * Open all images in the chain in read write mode first to avoid running
@@ -7943,6 +9855,22 @@ VBOXDDU_DECL(int) VDClose(PVDISK pDisk, bool fDelete)
         if (RT_FAILURE(rc))
             break;
 
+        /*
+         * Dirty data in the cache belongs to the image being closed. The cached data
+         * doesn't match the disk content after the image is gone, so drop it all.
+         */
+        if (pDisk->pCache)
+        {
+            if (!fDelete)
+            {
+                rc = vdCacheWriteBack(pDisk, 0 /* cbMax */);
+                if (RT_FAILURE(rc))
+                    break;
+            }
+            if (pDisk->pCache->Backend->pfnInvalidate)
+                pDisk->pCache->Backend->pfnInvalidate(pDisk->pCache->pBackendData, 0, pDisk->cbSize);
+        }
+
         unsigned uOpenFlags = pImage->Backend->pfnGetOpenFlags(pImage->pBackendData);
         /* Remove image from list of opened images. */
         vdRemoveImageFromList(pDisk, pImage);
@@ -8029,12 +9957,27 @@ VBOXDDU_DECL(int) VDCacheClose(PVDISK pDisk, bool fDelete)
         AssertPtrBreakStmt(pDisk, rc = VERR_INVALID_PARAMETER);
         AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
 
+        /* The background thread might wait for the lock. */
+        if (pDisk->pCache)
+            vdCacheThreadStop(pDisk->pCache);
+
         rc2 = vdThreadStartWrite(pDisk);
         AssertRC(rc2);
         fLockWrite = true;
 
         AssertPtrBreakStmt(pDisk->pCache, rc = VERR_VD_CACHE_NOT_FOUND);
 
+        /* The image is incomplete as long as the cache holds dirty data. */
+        if (pDisk->pLast)
+        {
+            rc = vdCacheWriteBack(pDisk, 0 /* cbMax */);
+            if (RT_FAILURE(rc))
+            {
+                vdCacheThreadStart(pDisk->pCache);
+                break;
+            }
+        }
+
         pCache = pDisk->pCache;
         pDisk->pCache = NULL;
 
@@ -8054,6 +9997,66 @@ VBOXDDU_DECL(int) VDCacheClose(PVDISK pDisk, bool fDelete)
     return rc;
 }
 
+VBOXDDU_DECL(int) VDCacheSetMode(PVDISK pDisk, VDCACHEMODE enmMode)
+{
+    int rc = VINF_SUCCESS;
+    int rc2;
+
+    LogFlowFunc(("pDisk=%#p enmMode=%d\n", pDisk, enmMode));
+    /* sanity check */
+    AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
+    AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
+    AssertReturn(   enmMode == VDCACHEMODE_WRITE_THROUGH
+                 || enmMode == VDCACHEMODE_WRITE_BACK, VERR_INVALID_PARAMETER);
+
+    rc2 = vdThreadStartWrite(pDisk);
+    AssertRC(rc2);
+
+    do
+    {
+        PVDCACHE pCache = pDisk->pCache;
+        AssertPtrBreakStmt(pCache, rc = VERR_VD_NOT_OPENED);
+
+        if (enmMode == pCache->enmMode)
+            break;
+
+        if (enmMode == VDCACHEMODE_WRITE_BACK)
+        {
+            if (   !pCache->Backend->pfnQueryDirty
+                || !pCache->Backend->pfnMarkClean
+                || !pCache->Backend->pfnGetDirtySize)
+            {
+                rc = VERR_NOT_SUPPORTED;
+                break;
+            }
+            /* Only writable caches have the thread writing back dirty data. */
+            if (pCache->hThread == NIL_RTTHREAD)
+            {
+                rc = VERR_VD_IMAGE_READ_ONLY;
+                break;
+            }
+
+            pCache->enmMode = enmMode;
+        }
+        else
+        {
+            /* Writes go to the image from now on, everything still dirty must get there too. */
+            pCache->enmMode = enmMode;
+            if (pDisk->pLast)
+                rc = vdCacheWriteBack(pDisk, 0 /* cbMax */);
+        }
+
+        LogRel(("VD: Cache '%s' switched to %s mode\n", pCache->pszFilename,
+                enmMode == VDCACHEMODE_WRITE_BACK ? "write-back" : "write-through"));
+    } while (0);
+
+    rc2 = vdThreadFinishWrite(pDisk);
+    AssertRC(rc2);
+
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
 VBOXDDU_DECL(int) VDFilterRemove(PVDISK pDisk, uint32_t fFlags)
 {
     int rc = VINF_SUCCESS;
@@ -8116,13 +10119,29 @@ VBOXDDU_DECL(int) VDCloseAll(PVDISK pDisk)
     AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
     AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
 
+    /* The background thread of the cache might wait for the lock. */
+    if (pDisk->pCache)
+        vdCacheThreadStop(pDisk->pCache);
+    vdStreamStop(pDisk);
+
     /* Lock the entire operation. */
     int rc2 = vdThreadStartWrite(pDisk);
     AssertRC(rc2);
 
+    vdReadAheadQuiesce(pDisk);
+
     PVDCACHE pCache = pDisk->pCache;
     if (pCache)
     {
+        /* Whatever can't be written back stays in the cache and is written back when it is used again. */
+        if (pDisk->pLast)
+        {
+            rc2 = vdCacheWriteBack(pDisk, 0 /* cbMax */);
+            if (RT_FAILURE(rc2) && RT_SUCCESS(rc))
+                rc = rc2;
+        }
+
+        pDisk->pCache = NULL;
         rc2 = pCache->Backend->pfnClose(pCache->pBackendData, false);
         if (RT_FAILURE(rc2) && RT_SUCCESS(rc))
             rc = rc2;
@@ -8149,6 +10168,10 @@ VBOXDDU_DECL(int) VDCloseAll(PVDISK pDisk)
     }
     Assert(!RT_VALID_PTR(pDisk->pLast));
 
+    rc2 = vdStreamCloseRetired(pDisk);
+    if (RT_FAILURE(rc2) && RT_SUCCESS(rc))
+        rc = rc2;
+
     rc2 = vdThreadFinishWrite(pDisk);
     AssertRC(rc2);
 
@@ -8265,7 +10288,62 @@ VBOXDDU_DECL(int) VDWrite(PVDISK pDisk, uint64_t uOffset, const void *pvBuf,
     AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
 
     /* Check arguments. */
-    AssertPtrReturn(pvBuf, VERR_INVALID_POINTER);
+    AssertPtrReturn(pvBuf, VERR_INVALID_POINTER);
+    AssertReturn(cbWrite > 0, VERR_INVALID_PARAMETER);
+
+    do
+    {
+        rc2 = vdThreadStartWrite(pDisk);
+        AssertRC(rc2);
+
+        AssertMsgBreakStmt(   uOffset < pDisk->cbSize
+                           && cbWrite <= pDisk->cbSize - uOffset,
+                           ("uOffset=%llu cbWrite=%zu pDisk->cbSize=%llu\n",
+                            uOffset, cbWrite, pDisk->cbSize),
+                           rc = VERR_INVALID_PARAMETER);
+
+        PVDIMAGE pImage = pDisk->pLast;
+        AssertPtrBreakStmt(pImage, rc = VERR_VD_NOT_OPENED);
+
+        vdSetModifiedFlag(pDisk);
+        rc = vdWriteHelper(pDisk, pImage, uOffset, pvBuf, cbWrite,
+                           VDIOCTX_FLAGS_READ_UPDATE_CACHE);
+        if (RT_FAILURE(rc))
+            break;
+
+        /* If there is a merge (in the direction towards a parent) running
+         * concurrently then we have to also "relay" the write to this parent,
+         * as the merge position might be already past the position where
+         * this write is going. The "context" of the write can come from the
+         * natural chain, since merging either already did or will take care
+         * of the "other" content which is might be needed to fill the block
+         * to a full allocation size. The cache doesn't need to be touched
+         * as this write is covered by the previous one. */
+        if (RT_UNLIKELY(pDisk->pImageRelay))
+            rc = vdWriteHelper(pDisk, pDisk->pImageRelay, uOffset,
+                               pvBuf, cbWrite, VDIOCTX_FLAGS_DEFAULT);
+    } while (0);
+
+    rc2 = vdThreadFinishWrite(pDisk);
+    AssertRC(rc2);
+
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+
+VBOXDDU_DECL(int) VDWriteZeroes(PVDISK pDisk, uint64_t uOffset, size_t cbWrite)
+{
+    int rc = VINF_SUCCESS;
+    int rc2;
+
+    LogFlowFunc(("pDisk=%#p uOffset=%llu cbWrite=%zu\n",
+                 pDisk, uOffset, cbWrite));
+    /* sanity check */
+    AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
+    AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
+
+    /* Check arguments. */
     AssertReturn(cbWrite > 0, VERR_INVALID_PARAMETER);
 
     do
@@ -8281,24 +10359,36 @@ VBOXDDU_DECL(int) VDWrite(PVDISK pDisk, uint64_t uOffset, const void *pvBuf,
 
         PVDIMAGE pImage = pDisk->pLast;
         AssertPtrBreakStmt(pImage, rc = VERR_VD_NOT_OPENED);
+        if (!RTListIsEmpty(&pDisk->ListFilterChainWrite))
+        {
+            rc = VERR_NOT_SUPPORTED;
+            break;
+        }
 
         vdSetModifiedFlag(pDisk);
-        rc = vdWriteHelper(pDisk, pImage, uOffset, pvBuf, cbWrite,
-                           VDIOCTX_FLAGS_READ_UPDATE_CACHE);
-        if (RT_FAILURE(rc))
-            break;
 
-        /* If there is a merge (in the direction towards a parent) running
-         * concurrently then we have to also "relay" the write to this parent,
-         * as the merge position might be already past the position where
-         * this write is going. The "context" of the write can come from the
-         * natural chain, since merging either already did or will take care
-         * of the "other" content which is might be needed to fill the block
-         * to a full allocation size. The cache doesn't need to be touched
-         * as this write is covered by the previous one. */
-        if (RT_UNLIKELY(pDisk->pImageRelay))
-            rc = vdWriteHelper(pDisk, pDisk->pImageRelay, uOffset,
-                               pvBuf, cbWrite, VDIOCTX_FLAGS_DEFAULT);
+        /* Write the range in chunks sourced from the shared zero buffer, see VDAsyncWriteZeroes(). */
+        while (cbWrite)
+        {
+            size_t const cbThisWrite = RT_MIN(cbWrite, VD_WRITE_ZEROES_CHUNK_SIZE);
+
+            rc = vdWriteHelper(pDisk, pImage, uOffset, &g_abVdZeroes[0], cbThisWrite,
+                               VDIOCTX_FLAGS_READ_UPDATE_CACHE);
+            if (RT_FAILURE(rc))
+                break;
+
+            /* Relay to a parent being merged into, see VDWrite(). */
+            if (RT_UNLIKELY(pDisk->pImageRelay))
+            {
+                rc = vdWriteHelper(pDisk, pDisk->pImageRelay, uOffset,
+                                   &g_abVdZeroes[0], cbThisWrite, VDIOCTX_FLAGS_DEFAULT);
+                if (RT_FAILURE(rc))
+                    break;
+            }
+
+            uOffset += cbThisWrite;
+            cbWrite -= cbThisWrite;
+        }
     } while (0);
 
     rc2 = vdThreadFinishWrite(pDisk);
@@ -8954,6 +11044,10 @@ VBOXDDU_DECL(int) VDSetOpenFlags(PVDISK pDisk, unsigned nImage,
     int rc2 = vdThreadStartWrite(pDisk);
     AssertRC(rc2);
 
+    /* No prefetches while the image is reopened. */
+    vdStreamStop(pDisk);
+    vdReadAheadQuiesce(pDisk);
+
     /* Destroy any discard state because the image might be changed to readonly mode. */
     int rc = vdDiscardStateDestroy(pDisk);
     if (RT_SUCCESS(rc))
@@ -8962,6 +11056,10 @@ VBOXDDU_DECL(int) VDSetOpenFlags(PVDISK pDisk, unsigned nImage,
         AssertPtr(pImage);
         if (pImage)
         {
+            /* The shared read cache is only for images which can't change. */
+            if (!(uOpenFlags & VD_OPEN_FLAGS_READONLY))
+                ASMAtomicWriteU64(&pImage->VDIo.cbSharedCache, 0);
+
             rc = pImage->Backend->pfnSetOpenFlags(pImage->pBackendData,
                                                   uOpenFlags & ~(VD_OPEN_FLAGS_HONOR_SAME | VD_OPEN_FLAGS_IGNORE_FLUSH
                                                                  | VD_OPEN_FLAGS_INFORM_ABOUT_ZERO_BLOCKS));
@@ -8981,6 +11079,224 @@ VBOXDDU_DECL(int) VDSetOpenFlags(PVDISK pDisk, unsigned nImage,
 }
 
 
+VBOXDDU_DECL(int) VDSetSharedReadCache(PVDISK pDisk, uint64_t cbCache)
+{
+    LogFlowFunc(("pDisk=%#p cbCache=%RU64\n", pDisk, cbCache));
+    /* sanity check */
+    AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
+    AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
+
+    int rc2 = vdThreadStartWrite(pDisk);
+    AssertRC(rc2);
+
+    pDisk->cbSharedReadCache = cbCache;
+
+    rc2 = vdThreadFinishWrite(pDisk);
+    AssertRC(rc2);
+
+    LogFlowFunc(("returns VINF_SUCCESS\n"));
+    return VINF_SUCCESS;
+}
+
+
+VBOXDDU_DECL(int) VDSetMergeRate(PVDISK pDisk, uint64_t cbPerSecMax)
+{
+    LogFlowFunc(("pDisk=%#p cbPerSecMax=%llu\n", pDisk, cbPerSecMax));
+    /* sanity check */
+    AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
+    AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
+
+    int rc2 = vdThreadStartWrite(pDisk);
+    AssertRC(rc2);
+    pDisk->cbMergePerSecMax = cbPerSecMax;
+    rc2 = vdThreadFinishWrite(pDisk);
+    AssertRC(rc2);
+
+    LogFlowFunc(("returns %Rrc\n", VINF_SUCCESS));
+    return VINF_SUCCESS;
+}
+
+
+VBOXDDU_DECL(int) VDSetReadAhead(PVDISK pDisk, size_t cbWindowMax, PVDREADAHEADSTATS pStats)
+{
+    LogFlowFunc(("pDisk=%#p cbWindowMax=%zu pStats=%#p\n", pDisk, cbWindowMax, pStats));
+    /* sanity check */
+    AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
+    AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
+
+    /* Check arguments. */
+    AssertPtrNullReturn(pStats, VERR_INVALID_POINTER);
+    AssertMsgReturn(!cbWindowMax || (cbWindowMax >= VD_READ_AHEAD_WINDOW_MIN && cbWindowMax <= VD_READ_AHEAD_WINDOW_MAX),
+                    ("cbWindowMax=%zu\n", cbWindowMax), VERR_INVALID_PARAMETER);
+
+    /* Prefetches complete without the thread synchronization callbacks knowing about them. */
+    if (cbWindowMax && pDisk->pInterfaceThreadSync)
+        return VERR_NOT_SUPPORTED;
+
+    int rc = VINF_SUCCESS;
+    int rc2 = vdThreadStartWrite(pDisk);
+    AssertRC(rc2);
+
+    vdReadAheadDestroy(pDisk);
+    if (cbWindowMax)
+    {
+        PVDREADAHEAD pReadAhead = (PVDREADAHEAD)RTMemAllocZ(sizeof(VDREADAHEAD));
+        if (pReadAhead)
+        {
+            pReadAhead->cbWindowMax = cbWindowMax;
+            pReadAhead->cbWindow    = VD_READ_AHEAD_WINDOW_MIN;
+            pReadAhead->uOffsetNext = UINT64_MAX;
+            pReadAhead->pStats      = pStats ? pStats : &pReadAhead->Stats;
+            pDisk->pReadAhead = pReadAhead;
+        }
+        else
+            rc = VERR_NO_MEMORY;
+    }
+
+    rc2 = vdThreadFinishWrite(pDisk);
+    AssertRC(rc2);
+
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+VBOXDDU_DECL(int) VDStreamStart(PVDISK pDisk, uint64_t cbPerSecMax,
+                                PFNVDSTREAMCOMPLETE pfnComplete, void *pvUser)
+{
+    LogFlowFunc(("pDisk=%#p cbPerSecMax=%llu pfnComplete=%#p pvUser=%#p\n",
+                 pDisk, cbPerSecMax, pfnComplete, pvUser));
+    /* sanity check */
+    AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
+    AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
+
+    /* Check arguments. */
+    AssertPtrNullReturn(pfnComplete, VERR_INVALID_POINTER);
+
+    int rc = VINF_SUCCESS;
+    int rc2 = vdThreadStartWrite(pDisk);
+    AssertRC(rc2);
+
+    do
+    {
+        if (   pDisk->pStream
+            && !ASMAtomicReadBool(&pDisk->pStream->fDone))
+        {
+            rc = VERR_RESOURCE_BUSY;
+            break;
+        }
+
+        PVDIMAGE pImage = pDisk->pLast;
+        if (!pImage || !pImage->pPrev)
+        {
+            rc = VERR_VD_INVALID_STATE;
+            break;
+        }
+        if (pImage->Backend->pfnGetOpenFlags(pImage->pBackendData) & VD_OPEN_FLAGS_READONLY)
+        {
+            rc = VERR_VD_IMAGE_READ_ONLY;
+            break;
+        }
+
+        /* Clean up after a previous run. */
+        vdStreamStop(pDisk);
+
+        PVDSTREAM pStream = (PVDSTREAM)RTMemAllocZ(sizeof(VDSTREAM));
+        if (!pStream)
+        {
+            rc = VERR_NO_MEMORY;
+            break;
+        }
+
+        pStream->pImageTarget = pImage;
+        pStream->cbDisk       = vdImageGetSize(pImage);
+        pStream->cbPerSecMax  = cbPerSecMax;
+        pStream->pfnComplete  = pfnComplete;
+        pStream->pvUser       = pvUser;
+        pStream->hThread      = NIL_RTTHREAD;
+        pStream->rcStream     = VINF_SUCCESS;
+        rc = RTSemEventCreate(&pStream->hEvtCancel);
+        if (RT_FAILURE(rc))
+        {
+            RTMemFree(pStream);
+            break;
+        }
+
+        pDisk->pStream = pStream;
+        rc = RTThreadCreate(&pStream->hThread, vdStreamThread, pDisk, 0, RTTHREADTYPE_IO,
+                            RTTHREADFLAGS_WAITABLE, "VDStream");
+        if (RT_FAILURE(rc))
+        {
+            pDisk->pStream = NULL;
+            RTSemEventDestroy(pStream->hEvtCancel);
+            RTMemFree(pStream);
+        }
+    } while (0);
+
+    rc2 = vdThreadFinishWrite(pDisk);
+    AssertRC(rc2);
+
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+
+VBOXDDU_DECL(int) VDStreamCancel(PVDISK pDisk)
+{
+    LogFlowFunc(("pDisk=%#p\n", pDisk));
+    /* sanity check */
+    AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
+    AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
+
+    int rc2 = vdThreadStartWrite(pDisk);
+    AssertRC(rc2);
+
+    vdStreamStop(pDisk);
+
+    rc2 = vdThreadFinishWrite(pDisk);
+    AssertRC(rc2);
+
+    LogFlowFunc(("returns %Rrc\n", VINF_SUCCESS));
+    return VINF_SUCCESS;
+}
+
+
+VBOXDDU_DECL(int) VDStreamQueryProgress(PVDISK pDisk, uint64_t *pcbDone, uint64_t *pcbTotal,
+                                        bool *pfRunning)
+{
+    LogFlowFunc(("pDisk=%#p pcbDone=%#p pcbTotal=%#p pfRunning=%#p\n", pDisk, pcbDone, pcbTotal, pfRunning));
+    /* sanity check */
+    AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
+    AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
+
+    /* Check arguments. */
+    AssertPtrReturn(pcbDone, VERR_INVALID_POINTER);
+    AssertPtrReturn(pcbTotal, VERR_INVALID_POINTER);
+    AssertPtrNullReturn(pfRunning, VERR_INVALID_POINTER);
+
+    int rc = VINF_SUCCESS;
+    int rc2 = vdThreadStartRead(pDisk);
+    AssertRC(rc2);
+
+    PVDSTREAM pStream = pDisk->pStream;
+    if (pStream)
+    {
+        *pcbDone  = ASMAtomicReadU64(&pStream->cbDone);
+        *pcbTotal = pStream->cbDisk;
+        if (pfRunning)
+            *pfRunning = !ASMAtomicReadBool(&pStream->fDone);
+    }
+    else
+        rc = VERR_NOT_FOUND;
+
+    rc2 = vdThreadFinishRead(pDisk);
+    AssertRC(rc2);
+
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+
+
 VBOXDDU_DECL(int) VDGetFilename(PVDISK pDisk, unsigned nImage,
                                 char *pszFilename, unsigned cbFilename)
 {
@@ -9397,7 +11713,7 @@ VBOXDDU_DECL(int) VDAsyncRead(PVDISK pDisk, uint64_t uOffset, size_t cbRead,
                                   cbRead, pDisk->pLast, pSgBuf,
                                   pfnComplete, pvUser1, pvUser2,
                                   NULL, vdReadHelperAsync,
-                                  VDIOCTX_FLAGS_ZERO_FREE_BLOCKS);
+                                  VDIOCTX_FLAGS_ZERO_FREE_BLOCKS | VDIOCTX_FLAGS_READ_UPDATE_CACHE | VDIOCTX_FLAGS_READ_AHEAD);
         if (!pIoCtx)
         {
             rc = VERR_NO_MEMORY;
@@ -9493,6 +11809,101 @@ VBOXDDU_DECL(int) VDAsyncWrite(PVDISK pDisk, uint64_t uOffset, size_t cbWrite,
 }
 
 
+VBOXDDU_DECL(int) VDAsyncWriteZeroes(PVDISK pDisk, uint64_t uOffset, size_t cbWrite,
+                                     PFNVDASYNCTRANSFERCOMPLETE pfnComplete,
+                                     void *pvUser1, void *pvUser2)
+{
+    int rc;
+    int rc2;
+    PVDIOCTX pIoCtx = NULL;
+
+    LogFlowFunc(("pDisk=%#p uOffset=%llu cbWrite=%zu pvUser1=%#p pvUser2=%#p\n",
+                 pDisk, uOffset, cbWrite, pvUser1, pvUser2));
+    /* sanity check */
+    AssertPtrReturn(pDisk, VERR_INVALID_POINTER);
+    AssertMsg(pDisk->u32Signature == VDISK_SIGNATURE, ("u32Signature=%08x\n", pDisk->u32Signature));
+
+    /* Check arguments. */
+    AssertReturn(cbWrite > 0, VERR_INVALID_PARAMETER);
+
+    /*
+     * The request is turned into a regular write where all segments point to
+     * the shared zero buffer. The segment array is freed together with the
+     * I/O context. Backends detect the all zero data and leave unallocated
+     * blocks alone instead of allocating and writing them.
+     */
+    unsigned const cSegs = (unsigned)((cbWrite + VD_WRITE_ZEROES_CHUNK_SIZE - 1) / VD_WRITE_ZEROES_CHUNK_SIZE);
+    PRTSGSEG paSegs = (PRTSGSEG)RTMemAlloc(cSegs * sizeof(RTSGSEG));
+    if (RT_UNLIKELY(!paSegs))
+        return VERR_NO_MEMORY;
+
+    size_t cbLeft = cbWrite;
+    for (unsigned i = 0; i < cSegs; i++)
+    {
+        paSegs[i].pvSeg = &g_abVdZeroes[0];
+        paSegs[i].cbSeg = RT_MIN(cbLeft, VD_WRITE_ZEROES_CHUNK_SIZE);
+        cbLeft -= paSegs[i].cbSeg;
+    }
+
+    RTSGBUF SgBuf;
+    RTSgBufInit(&SgBuf, paSegs, cSegs);
+
+    do
+    {
+        rc2 = vdThreadStartWrite(pDisk);
+        AssertRC(rc2);
+
+        AssertMsgBreakStmt(   uOffset < pDisk->cbSize
+                           && cbWrite <= pDisk->cbSize - uOffset,
+                           ("uOffset=%llu cbWrite=%zu pDisk->cbSize=%llu\n",
+                            uOffset, cbWrite, pDisk->cbSize),
+                           rc = VERR_INVALID_PARAMETER);
+        AssertPtrBreakStmt(pDisk->pLast, rc = VERR_VD_NOT_OPENED);
+        /* Write filters transform the data in place and can't work on the shared buffer. */
+        if (!RTListIsEmpty(&pDisk->ListFilterChainWrite))
+        {
+            rc = VERR_NOT_SUPPORTED;
+            break;
+        }
+
+        pIoCtx = vdIoCtxRootAlloc(pDisk, VDIOCTXTXDIR_WRITE, uOffset,
+                                  cbWrite, pDisk->pLast, &SgBuf,
+                                  pfnComplete, pvUser1, pvUser2,
+                                  paSegs, vdWriteHelperAsync,
+                                  VDIOCTX_FLAGS_DEFAULT);
+        if (!pIoCtx)
+        {
+            rc = VERR_NO_MEMORY;
+            break;
+        }
+        paSegs = NULL; /* Owned by the I/O context now. */
+
+        rc = vdIoCtxProcessTryLockDefer(pIoCtx);
+        if (rc == VINF_VD_ASYNC_IO_FINISHED)
+        {
+            if (ASMAtomicCmpXchgBool(&pIoCtx->fComplete, true, false))
+                vdIoCtxFree(pDisk, pIoCtx);
+            else
+                rc = VERR_VD_ASYNC_IO_IN_PROGRESS; /* Let the other handler complete the request. */
+        }
+        else if (rc != VERR_VD_ASYNC_IO_IN_PROGRESS) /* Another error */
+            vdIoCtxFree(pDisk, pIoCtx);
+    } while (0);
+
+    if (rc != VERR_VD_ASYNC_IO_IN_PROGRESS)
+    {
+        rc2 = vdThreadFinishWrite(pDisk);
+        AssertRC(rc2);
+    }
+
+    if (paSegs)
+        RTMemFree(paSegs);
+
+    LogFlowFunc(("returns %Rrc\n", rc));
+    return rc;
+}
+
+
 VBOXDDU_DECL(int) VDAsyncFlush(PVDISK pDisk, PFNVDASYNCTRANSFERCOMPLETE pfnComplete,
                                void *pvUser1, void *pvUser2)
 {
@@ -37,6 +37,11 @@
 #include <iprt/assert.h>
 #include <iprt/mem.h>
 #include <iprt/memsafer.h>
+#include <iprt/mp.h>
+#include <iprt/semaphore.h>
+#include <iprt/thread.h>
+#include <iprt/time.h>
+#include <iprt/asm.h>
 #include <iprt/crypto/cipher.h>
 #include <iprt/crypto/misc.h>
 
@@ -44,6 +49,23 @@
 #include "VDBackends.h"
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Default number of bytes worked on per batch (see the "BatchSize" config key). */
+#define VDFILTERCRYPT_BATCH_SIZE_DEF        _128K
+/** Maximum number of bytes worked on per batch. */
+#define VDFILTERCRYPT_BATCH_SIZE_MAX        _4M
+/** Maximum number of I/O context segments gathered for one batch. */
+#define VDFILTERCRYPT_BATCH_SEGS_MAX        32
+/** Maximum number of crypto worker threads. */
+#define VDFILTERCRYPT_WORKERS_MAX           8
+/** Default maximum number of crypto worker threads (capped by the number of CPUs - 1). */
+#define VDFILTERCRYPT_WORKERS_DEF           4
+/** Minimum number of bytes per worker before a batch is split up. */
+#define VDFILTERCRYPT_WORKER_CHUNK_MIN      _32K
+
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
@@ -79,6 +101,38 @@ typedef struct VDFILTERCRYPTALGOMAPPING
 /** Pointer to the algorithm mapping entry. */
 typedef VDFILTERCRYPTALGOMAPPING *PVDFILTERCRYPTALGOMAPPING;
 
+/** Pointer to a crypto filter instance. */
+typedef struct VDFILTERCRYPT *PVDFILTERCRYPT;
+
+/**
+ * Crypto worker thread state.
+ */
+typedef struct VDFILTERCRYPTWORKER
+{
+    /** The owning filter instance. */
+    PVDFILTERCRYPT             pFilter;
+    /** The worker thread handle. */
+    RTTHREAD                   hThread;
+    /** Event the worker waits on for new work. */
+    RTSEMEVENT                 hEvtWork;
+    /** Input data of the current job. */
+    const uint8_t             *pbIn;
+    /** Where to store the output of the current job. */
+    uint8_t                   *pbOut;
+    /** Number of bytes to process, multiple of cbDataUnit. */
+    size_t                     cb;
+    /** Size of one data unit in bytes. */
+    size_t                     cbDataUnit;
+    /** The data unit number of the first unit (used for the IV). */
+    uint64_t                   uSect;
+    /** Flag whether to encrypt or decrypt. */
+    bool                       fEncrypt;
+    /** Status code of the job. */
+    int                        rc;
+} VDFILTERCRYPTWORKER;
+/** Pointer to a crypto worker thread state. */
+typedef VDFILTERCRYPTWORKER *PVDFILTERCRYPTWORKER;
+
 /**
  * Crypto filter instance data.
  */
@@ -112,11 +166,35 @@ typedef struct VDFILTERCRYPT
     size_t                     cbKey;
     /** Size of the raw data buffer. */
     size_t                     cbRawData;
-    /** Temporary storage for one data unit. */
+    /** Temporary storage for one batch of input and output data. */
     uint8_t                   *pbRawData;
+    /** Maximum number of bytes to work on per batch. */
+    size_t                     cbBatch;
+
+    /** Number of crypto worker threads to use, 0 if disabled. */
+    uint32_t                   cWorkersMax;
+    /** Number of crypto worker threads started. */
+    uint32_t                   cWorkers;
+    /** Number of workers still busy with the current batch. */
+    volatile uint32_t          cWorkersBusy;
+    /** Flag whether the workers should terminate. */
+    volatile bool              fWorkersShutdown;
+    /** Flag whether starting the workers failed (don't retry). */
+    bool                       fWorkersFailed;
+    /** Event signalled by the last worker finishing its part of a batch. */
+    RTSEMEVENT                 hEvtWorkersDone;
+    /** The worker thread states. */
+    VDFILTERCRYPTWORKER        aWorkers[VDFILTERCRYPT_WORKERS_MAX];
+
+    /** Statistics: Number of requests processed. */
+    uint64_t                   cStatRequests;
+    /** Statistics: Number of bytes processed. */
+    uint64_t                   cbStatProcessed;
+    /** Statistics: Nanoseconds spent in the cipher code. */
+    uint64_t                   cNsStatCipher;
+    /** Statistics: Number of batches split across the worker threads. */
+    uint64_t                   cStatBatchesParallel;
 } VDFILTERCRYPT;
-/** Pointer to a crypto filter instance. */
-typedef VDFILTERCRYPT *PVDFILTERCRYPT;
 
 
 /*********************************************************************************************************************************
@@ -130,6 +208,8 @@ static const VDCONFIGINFO s_cryptConfigInfo[] =
     { "KeyId",                NULL,                                      VDCFGVALUETYPE_STRING,  0 },
     { "CreateKeyStore",       NULL,                                      VDCFGVALUETYPE_INTEGER, 0 },
     { "KeyStore",             NULL,                                      VDCFGVALUETYPE_STRING,  0 },
+    { "BatchSize",            "131072",                                  VDCFGVALUETYPE_INTEGER, VD_CFGKEY_EXPERT },
+    { "Workers",              NULL,                                      VDCFGVALUETYPE_INTEGER, VD_CFGKEY_EXPERT },
     { NULL,                   NULL,                                      VDCFGVALUETYPE_INTEGER, 0 }
 };
 
@@ -194,6 +274,62 @@ static int cryptAlgorithmQueryFromConfig(PVDFILTERCRYPT pFilter)
     return rc;
 }
 
+/**
+ * Queries the batching and worker thread settings from the config.
+ *
+ * @returns VBox status code.
+ * @param   pFilter    The filter instance.
+ */
+static int cryptPerfQueryFromConfig(PVDFILTERCRYPT pFilter)
+{
+    uint32_t cbBatch = 0;
+    int rc = VDCFGQueryU32Def(pFilter->pIfConfig, "BatchSize", &cbBatch, VDFILTERCRYPT_BATCH_SIZE_DEF);
+    if (RT_FAILURE(rc))
+        return vdIfError(pFilter->pIfError, rc, RT_SRC_POS, N_("Crypt: Failed to query \"BatchSize\" from config"));
+    if (!cbBatch || cbBatch > VDFILTERCRYPT_BATCH_SIZE_MAX)
+        return vdIfError(pFilter->pIfError, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                         N_("Crypt: \"BatchSize\" %u is out of range (1..%u)"), cbBatch, VDFILTERCRYPT_BATCH_SIZE_MAX);
+    pFilter->cbBatch = cbBatch;
+
+    uint32_t const cCpus = RTMpGetOnlineCount();
+    uint32_t cWorkers = 0;
+    rc = VDCFGQueryU32Def(pFilter->pIfConfig, "Workers", &cWorkers,
+                          RT_MIN(cCpus > 1 ? cCpus - 1 : 0, VDFILTERCRYPT_WORKERS_DEF));
+    if (RT_FAILURE(rc))
+        return vdIfError(pFilter->pIfError, rc, RT_SRC_POS, N_("Crypt: Failed to query \"Workers\" from config"));
+    pFilter->cWorkersMax = RT_MIN(cWorkers, VDFILTERCRYPT_WORKERS_MAX);
+
+    return VINF_SUCCESS;
+}
+
+/**
+ * Stops all crypto worker threads.
+ *
+ * @param   pFilter    The filter instance.
+ */
+static void cryptFilterWorkersTerm(PVDFILTERCRYPT pFilter)
+{
+    ASMAtomicWriteBool(&pFilter->fWorkersShutdown, true);
+    for (uint32_t i = 0; i < pFilter->cWorkers; i++)
+    {
+        PVDFILTERCRYPTWORKER pWorker = &pFilter->aWorkers[i];
+
+        RTSemEventSignal(pWorker->hEvtWork);
+        int rc = RTThreadWait(pWorker->hThread, RT_INDEFINITE_WAIT, NULL);
+        AssertRC(rc);
+        RTSemEventDestroy(pWorker->hEvtWork);
+        pWorker->hEvtWork = NIL_RTSEMEVENT;
+        pWorker->hThread  = NIL_RTTHREAD;
+    }
+    pFilter->cWorkers = 0;
+
+    if (pFilter->hEvtWorkersDone != NIL_RTSEMEVENT)
+    {
+        RTSemEventDestroy(pFilter->hEvtWorkersDone);
+        pFilter->hEvtWorkersDone = NIL_RTSEMEVENT;
+    }
+}
+
 /**
  * Frees the filter instance.
  *
@@ -203,6 +339,8 @@ static void cryptFree(PVDFILTERCRYPT pFilter)
 {
     if (pFilter)
     {
+        cryptFilterWorkersTerm(pFilter);
+
         if (pFilter->pbKey)
         {
             if (pFilter->pszKeyId)
@@ -246,13 +384,13 @@ static void cryptFree(PVDFILTERCRYPT pFilter)
  *
  * @returns VBox status code.
  * @param   pFilter    The filter instance.
- * @param   cbDataUnit Size of one data unit in bytes.
+ * @param   cbBuf      Required size of the buffer in bytes.
  */
-static int cryptFilterEnsureTemporaryDataBufferSize(PVDFILTERCRYPT pFilter, size_t cbDataUnit)
+static int cryptFilterEnsureTemporaryDataBufferSize(PVDFILTERCRYPT pFilter, size_t cbBuf)
 {
     int rc = VINF_SUCCESS;
 
-    if (pFilter->cbRawData < cbDataUnit)
+    if (pFilter->cbRawData < cbBuf)
     {
         if (pFilter->pbRawData)
         {
@@ -261,9 +399,9 @@ static int cryptFilterEnsureTemporaryDataBufferSize(PVDFILTERCRYPT pFilter, size
             RTMemSaferFree(pFilter->pbRawData, pFilter->cbRawData);
         }
 
-        pFilter->pbRawData = (uint8_t *)RTMemSaferAllocZ(cbDataUnit);
+        pFilter->pbRawData = (uint8_t *)RTMemSaferAllocZ(cbBuf);
         if (pFilter->pbRawData)
-            pFilter->cbRawData = cbDataUnit;
+            pFilter->cbRawData = cbBuf;
         else
         {
             pFilter->cbRawData = 0;
@@ -363,6 +501,182 @@ static int cryptFilterXtsEncryptWorker(PVDFILTERCRYPT pFilter,
     return vdIfError(pFilter->pIfError, VERR_INVALID_STATE, RT_SRC_POS, N_("Crypt: Encryption error %Rrc"), rc);
 }
 
+/**
+ * Encrypts or decrypts a contiguous range of data units.
+ *
+ * @returns VBox status code.
+ * @param   pFilter    The filter instance data.
+ * @param   pbIn       The input data.
+ * @param   pbOut      Where to store the output, must not overlap with @a pbIn.
+ * @param   cb         Number of bytes to process, multiple of @a cbDataUnit.
+ * @param   cbDataUnit Size of one data unit in bytes.
+ * @param   uSect      Number of the first data unit, used for the IV.
+ * @param   fEncrypt   true if the data should be encrypted, false for decryption.
+ *
+ * @note    Called from the worker threads as well.
+ */
+static int cryptFilterXtsProcess(PVDFILTERCRYPT pFilter, const uint8_t *pbIn, uint8_t *pbOut, size_t cb,
+                                 size_t cbDataUnit, uint64_t uSect, bool fEncrypt)
+{
+    int rc = VINF_SUCCESS;
+
+    while (cb && RT_SUCCESS(rc))
+    {
+        uint8_t abIv[16];
+
+        /* Create the plain IV. */
+        RT_BZERO(abIv, sizeof(abIv));
+        for (unsigned i = 0; i < sizeof(uint64_t); i++)
+            abIv[i] = (uint8_t)((uSect >> (i * 8)) & 0xff);
+
+        if (fEncrypt)
+            rc = cryptFilterXtsEncryptWorker(pFilter, pbIn, pbOut, cbDataUnit, &abIv[0], cbDataUnit);
+        else
+            rc = cryptFilterXtsDecryptWorker(pFilter, pbIn, pbOut, cbDataUnit, &abIv[0], cbDataUnit);
+
+        pbIn  += cbDataUnit;
+        pbOut += cbDataUnit;
+        cb    -= cbDataUnit;
+        uSect++;
+    }
+
+    return rc;
+}
+
+/**
+ * Crypto worker thread.
+ *
+ * @returns VBox status code.
+ * @param   hThread    The thread handle.
+ * @param   pvUser     The worker state.
+ */
+static DECLCALLBACK(int) cryptFilterWorkerThread(RTTHREAD hThread, void *pvUser)
+{
+    PVDFILTERCRYPTWORKER pWorker = (PVDFILTERCRYPTWORKER)pvUser;
+    PVDFILTERCRYPT pFilter = pWorker->pFilter;
+    RT_NOREF(hThread);
+
+    for (;;)
+    {
+        int rc = RTSemEventWait(pWorker->hEvtWork, RT_INDEFINITE_WAIT);
+        AssertRCBreak(rc);
+
+        if (ASMAtomicReadBool(&pFilter->fWorkersShutdown))
+            break;
+
+        pWorker->rc = cryptFilterXtsProcess(pFilter, pWorker->pbIn, pWorker->pbOut, pWorker->cb,
+                                            pWorker->cbDataUnit, pWorker->uSect, pWorker->fEncrypt);
+        if (!ASMAtomicDecU32(&pFilter->cWorkersBusy))
+            RTSemEventSignal(pFilter->hEvtWorkersDone);
+    }
+
+    return VINF_SUCCESS;
+}
+
+/**
+ * Starts the crypto worker threads.
+ *
+ * @returns VBox status code.
+ * @param   pFilter    The filter instance data.
+ */
+static int cryptFilterWorkersStart(PVDFILTERCRYPT pFilter)
+{
+    int rc = RTSemEventCreate(&pFilter->hEvtWorkersDone);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    for (uint32_t i = 0; i < pFilter->cWorkersMax && RT_SUCCESS(rc); i++)
+    {
+        PVDFILTERCRYPTWORKER pWorker = &pFilter->aWorkers[i];
+
+        pWorker->pFilter = pFilter;
+        rc = RTSemEventCreate(&pWorker->hEvtWork);
+        if (RT_SUCCESS(rc))
+        {
+            rc = RTThreadCreateF(&pWorker->hThread, cryptFilterWorkerThread, pWorker, 0 /*cbStack*/,
+                                 RTTHREADTYPE_IO, RTTHREADFLAGS_WAITABLE, "VDCrypt%u", i);
+            if (RT_SUCCESS(rc))
+                pFilter->cWorkers++;
+            else
+            {
+                RTSemEventDestroy(pWorker->hEvtWork);
+                pWorker->hEvtWork = NIL_RTSEMEVENT;
+            }
+        }
+    }
+
+    if (RT_FAILURE(rc))
+        cryptFilterWorkersTerm(pFilter);
+    return rc;
+}
+
+/**
+ * Encrypts or decrypts a contiguous range of data units, splitting the work
+ * between the calling thread and the crypto worker threads.
+ *
+ * @returns VBox status code.
+ * @param   pFilter    The filter instance data.
+ * @param   pbIn       The input data.
+ * @param   pbOut      Where to store the output, must not overlap with @a pbIn.
+ * @param   cb         Number of bytes to process, multiple of @a cbDataUnit.
+ * @param   cbDataUnit Size of one data unit in bytes.
+ * @param   uSect      Number of the first data unit, used for the IV.
+ * @param   fEncrypt   true if the data should be encrypted, false for decryption.
+ */
+static int cryptFilterXtsProcessParallel(PVDFILTERCRYPT pFilter, const uint8_t *pbIn, uint8_t *pbOut, size_t cb,
+                                         size_t cbDataUnit, uint64_t uSect, bool fEncrypt)
+{
+    if (   !pFilter->cWorkers
+        && !pFilter->fWorkersFailed)
+    {
+        int rc = cryptFilterWorkersStart(pFilter);
+        if (RT_FAILURE(rc))
+        {
+            LogRel(("Crypt: Failed to start the crypto worker threads, continuing single threaded: %Rrc\n", rc));
+            pFilter->fWorkersFailed = true;
+        }
+    }
+
+    /* The caller takes a share as well. */
+    uint32_t cParts = (uint32_t)RT_MIN(cb / VDFILTERCRYPT_WORKER_CHUNK_MIN, pFilter->cWorkers + 1);
+    if (cParts < 2)
+        return cryptFilterXtsProcess(pFilter, pbIn, pbOut, cb, cbDataUnit, uSect, fEncrypt);
+
+    size_t const cbPart = RT_MAX(cb / cParts / cbDataUnit, 1) * cbDataUnit;
+    uint32_t const cJobs = cParts - 1;
+
+    pFilter->cStatBatchesParallel++;
+    ASMAtomicWriteU32(&pFilter->cWorkersBusy, cJobs);
+    for (uint32_t i = 0; i < cJobs; i++)
+    {
+        PVDFILTERCRYPTWORKER pWorker = &pFilter->aWorkers[i];
+
+        pWorker->pbIn       = pbIn;
+        pWorker->pbOut      = pbOut;
+        pWorker->cb         = cbPart;
+        pWorker->cbDataUnit = cbDataUnit;
+        pWorker->uSect      = uSect;
+        pWorker->fEncrypt   = fEncrypt;
+        pWorker->rc         = VINF_SUCCESS;
+        RTSemEventSignal(pWorker->hEvtWork);
+
+        pbIn  += cbPart;
+        pbOut += cbPart;
+        cb    -= cbPart;
+        uSect += cbPart / cbDataUnit;
+    }
+
+    int rc = cryptFilterXtsProcess(pFilter, pbIn, pbOut, cb, cbDataUnit, uSect, fEncrypt);
+
+    while (ASMAtomicReadU32(&pFilter->cWorkersBusy))
+        RTSemEventWait(pFilter->hEvtWorkersDone, RT_INDEFINITE_WAIT);
+
+    for (uint32_t i = 0; i < cJobs && RT_SUCCESS(rc); i++)
+        rc = pFilter->aWorkers[i].rc;
+
+    return rc;
+}
+
 /**
  * Main encryption/decryption worker for the AES-XTS cipher variants.
  *
@@ -382,11 +696,12 @@ static int cryptFilterEncDecXts(PVDFILTERCRYPT pFilter,
 {
     int rc = VINF_SUCCESS;
     uint64_t uSect = uOffset / cbDataUnit;
+    size_t const cbBatch = RT_MAX(RT_ALIGN_Z(pFilter->cbBatch, cbDataUnit), cbDataUnit);
 
     /*
-     * Ensure sufficient temporary size buffer.
+     * Ensure sufficient temporary size buffer (input and output halves).
      */
-    rc = cryptFilterEnsureTemporaryDataBufferSize(pFilter, cbDataUnit);
+    rc = cryptFilterEnsureTemporaryDataBufferSize(pFilter, 2 * cbBatch);
     if (RT_FAILURE(rc))
         return rc;
 
@@ -413,39 +728,67 @@ static int cryptFilterEncDecXts(PVDFILTERCRYPT pFilter,
     }
 
     /*
-     * Work the data.
+     * Work the data in batches: gather as many data units as fit into the temporary
+     * buffer, run the cipher over the contiguous input into the second half of the
+     * buffer (split across the worker threads if large enough) and scatter the result
+     * back into the I/O context.  This keeps the input untouched until the whole batch
+     * is done and amortizes the S/G handling over many data units.
      */
-    while (cb)
+    pFilter->cStatRequests++;
+    while (cb && RT_SUCCESS(rc))
     {
-        uint8_t abIv[16];
-        unsigned cSegments = 1;
-        RTSGSEG Segment;
-        uint8_t *pbData;
+        RTSGSEG  aSegs[VDFILTERCRYPT_BATCH_SEGS_MAX];
+        unsigned cSegs = RT_ELEMENTS(aSegs);
+        size_t   cbThis = RT_MIN(cb, cbBatch);
 
-        /** @todo r=bird: it appears to me like we're working directly on the input buffer when encrypting.
-         * This is rather problematic if the input isn't writable.  FormatFAT runs/ran into this when
-         * writing zero sectors.
-         */
-        size_t const cbData = vdIfIoIntIoCtxSegArrayCreate(pFilter->pIfIo, pIoCtx, &Segment, &cSegments, cbDataUnit);
-        Assert(cbData == cbDataUnit && cSegments == 1 && Segment.cbSeg == cbData); RT_NOREF(cbData);
+        /* Shrink the batch until the segment array is large enough, going down to a single data unit. */
+        for (;;)
+        {
+            unsigned cSegsNeeded = 0;
+            vdIfIoIntIoCtxSegArrayCreate(pFilter->pIfIo, pIoCtx, NULL, &cSegsNeeded, cbThis);
+            if (   cSegsNeeded <= RT_ELEMENTS(aSegs)
+                || cbThis == cbDataUnit)
+                break;
+            cbThis = RT_MAX(RT_ALIGN_Z(cbThis / 2, cbDataUnit), cbDataUnit);
+        }
 
-        memcpy(pFilter->pbRawData, Segment.pvSeg, cbDataUnit);
-        pbData = (uint8_t *)Segment.pvSeg;
+        size_t const cbData = vdIfIoIntIoCtxSegArrayCreate(pFilter->pIfIo, pIoCtx, &aSegs[0], &cSegs, cbThis);
+        Assert(cbData == cbThis); RT_NOREF(cbData);
 
-        /* Create the plain IV. */
-        RT_BZERO(abIv, sizeof(abIv));
-        for (unsigned i = 0; i < sizeof(uint64_t); i++)
-            abIv[i] = (uint8_t)((uSect >> (i * 8)) & 0xff);
+        uint8_t *pbIn  = pFilter->pbRawData;
+        uint8_t *pbOut = pFilter->pbRawData + cbBatch;
+        size_t   offBuf = 0;
+        for (unsigned iSeg = 0; iSeg < cSegs; iSeg++)
+        {
+            memcpy(pbIn + offBuf, aSegs[iSeg].pvSeg, aSegs[iSeg].cbSeg);
+            offBuf += aSegs[iSeg].cbSeg;
+        }
 
-        if (fEncrypt)
-            rc = cryptFilterXtsEncryptWorker(pFilter, pFilter->pbRawData,
-                                             pbData, cbDataUnit, &abIv[0], cbDataUnit);
+        uint64_t const nsStart = RTTimeNanoTS();
+        if (   pFilter->cWorkersMax
+            && cbThis >= 2 * VDFILTERCRYPT_WORKER_CHUNK_MIN)
+            rc = cryptFilterXtsProcessParallel(pFilter, pbIn, pbOut, cbThis, cbDataUnit, uSect, fEncrypt);
         else
-            rc = cryptFilterXtsDecryptWorker(pFilter, pFilter->pbRawData,
-                                             pbData, cbDataUnit, &abIv[0], cbDataUnit);
+            rc = cryptFilterXtsProcess(pFilter, pbIn, pbOut, cbThis, cbDataUnit, uSect, fEncrypt);
+        pFilter->cNsStatCipher   += RTTimeNanoTS() - nsStart;
+        pFilter->cbStatProcessed += cbThis;
 
-        cb -= cbDataUnit;
-        uSect++;
+        /** @todo r=bird: it appears to me like we're working directly on the input buffer when encrypting.
+         * This is rather problematic if the input isn't writable.  FormatFAT runs/ran into this when
+         * writing zero sectors.
+         */
+        if (RT_SUCCESS(rc))
+        {
+            offBuf = 0;
+            for (unsigned iSeg = 0; iSeg < cSegs; iSeg++)
+            {
+                memcpy(aSegs[iSeg].pvSeg, pbOut + offBuf, aSegs[iSeg].cbSeg);
+                offBuf += aSegs[iSeg].cbSeg;
+            }
+        }
+
+        cb    -= cbThis;
+        uSect += cbThis / cbDataUnit;
     }
 
     return rc;
@@ -610,6 +953,12 @@ static DECLCALLBACK(int) cryptCreate(PVDINTERFACE pVDIfsDisk, uint32_t fFlags,
     pFilter->pVDIfsFilter = pVDIfsFilter;
     pFilter->enmAlgorithmCipher = VDFILTERCRYPTALGO_INVALID;
     pFilter->hCipher = NIL_RTCRCIPHER;
+    pFilter->hEvtWorkersDone = NIL_RTSEMEVENT;
+    for (unsigned i = 0; i < RT_ELEMENTS(pFilter->aWorkers); i++)
+    {
+        pFilter->aWorkers[i].hThread  = NIL_RTTHREAD;
+        pFilter->aWorkers[i].hEvtWork = NIL_RTSEMEVENT;
+    }
 
     pFilter->pIfError  = VDIfErrorGet(pFilter->pVDIfsDisk);
     pFilter->pIfIo     = VDIfIoIntGet(pFilter->pVDIfsFilter);
@@ -625,7 +974,9 @@ static DECLCALLBACK(int) cryptCreate(PVDINTERFACE pVDIfsDisk, uint32_t fFlags,
                               "Algorithm\0"
                               "KeyId\0"
                               "CreateKeyStore\0"
-                              "KeyStore\0"))
+                              "KeyStore\0"
+                              "BatchSize\0"
+                              "Workers\0"))
         {
             /*
              * The logic is a bit complicated because there are various ways to supply the DEK.
@@ -697,6 +1048,9 @@ static DECLCALLBACK(int) cryptCreate(PVDINTERFACE pVDIfsDisk, uint32_t fFlags,
                         rc = vdIfError(pFilter->pIfError, rc, RT_SRC_POS, N_("Crypt: Failed to query \"CreateKeyStore\" from config"));
                 }
 
+                if (RT_SUCCESS(rc))
+                    rc = cryptPerfQueryFromConfig(pFilter);
+
                 if (RT_SUCCESS(rc))
                 {
                     *ppvBackendData = pFilter;
@@ -724,6 +1078,13 @@ static DECLCALLBACK(int) cryptDestroy(void *pvBackendData)
 {
     PVDFILTERCRYPT pFilter = (PVDFILTERCRYPT)pvBackendData;
 
+    if (pFilter->cbStatProcessed)
+        LogRel(("Crypt: %llu requests, %llu bytes, %llu ns in cipher (%llu ns/KiB, %llu MB/s), %llu batches on %u workers\n",
+                pFilter->cStatRequests, pFilter->cbStatProcessed, pFilter->cNsStatCipher,
+                pFilter->cNsStatCipher * _1K / pFilter->cbStatProcessed,
+                pFilter->cNsStatCipher ? pFilter->cbStatProcessed * RT_NS_1SEC / pFilter->cNsStatCipher / _1M : 0,
+                pFilter->cStatBatchesParallel, pFilter->cWorkers));
+
     cryptFree(pFilter);
     return VINF_SUCCESS;
 }
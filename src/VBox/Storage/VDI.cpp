@@ -40,6 +40,7 @@
 #include <iprt/uuid.h>
 #include <iprt/string.h>
 #include <iprt/asm.h>
+#include <iprt/asm-mem.h>
 
 #include "VDBackends.h"
 
@@ -1366,11 +1367,11 @@ static void *vdiAllocationBitmapCreate(void *pvData, size_t cbData)
 
     while (uSectorCur < cSectors)
     {
-        int idxSet = ASMBitFirstSet((uint8_t *)pvData + uSectorCur * 512, (uint32_t)cbData * 8);
+        uint8_t const *pbSet = (uint8_t const *)ASMMemFirstNonZero((uint8_t *)pvData + uSectorCur * 512, cbData);
 
-        if (idxSet != -1)
+        if (pbSet)
         {
-            unsigned idxSectorAlloc = idxSet / 8 / 512;
+            unsigned idxSectorAlloc = (unsigned)((pbSet - ((uint8_t *)pvData + uSectorCur * 512)) / 512);
             ASMBitSet(pbmAllocationBitmap, uSectorCur + idxSectorAlloc);
 
             uSectorCur += idxSectorAlloc + 1;
@@ -2422,7 +2423,7 @@ static DECLCALLBACK(int) vdiCompact(void *pBackendData, unsigned uPercentStart,
                 if (RT_FAILURE(rc))
                     break;
 
-                if (ASMBitFirstSet((volatile void *)pvTmp, (uint32_t)cbBlock * 8) == -1)
+                if (ASMMemIsZero(pvTmp, cbBlock))
                 {
                     pImage->paBlocks[i] = VDI_IMAGE_BLOCK_ZERO;
                     rc = vdiUpdateBlockInfo(pImage, i);
@@ -2875,8 +2876,7 @@ static DECLCALLBACK(int) vdiDiscard(void *pBackendData, PVDIOCTX pIoCtx,
                 memset(pbBlockData + offDiscard , 0, cbDiscard);
 
                 Assert(!(cbDiscard % 4));
-                Assert(getImageBlockSize(&pImage->Header) * 8 <= UINT32_MAX);
-                if (ASMBitFirstSet((volatile void *)pbBlockData, getImageBlockSize(&pImage->Header) * 8) == -1)
+                if (ASMMemIsZero(pbBlockData, getImageBlockSize(&pImage->Header)))
                     rc = vdiDiscardBlockAsync(pImage, pIoCtx, uBlock, pvBlock);
                 else
                 {
@@ -40,6 +40,8 @@
 #include <iprt/avl.h>
 #include <iprt/list.h>
 #include <iprt/memcache.h>
+#include <iprt/semaphore.h>
+#include <iprt/thread.h>
 
 #if 0 /* bird: this is nonsense */
 /** Disable dynamic backends on non x86 architectures. This feature
@@ -54,6 +56,9 @@
  * pointer contains a valid instance in debug builds. */
 #define VDISK_SIGNATURE 0x6f0e2a7d
 
+/** Pointer to a host-wide shared read cache instance. */
+typedef struct VDSHAREDCACHE *PVDSHAREDCACHE;
+
 /**
  * Structure containing everything I/O related
  * for the image and cache descriptors.
@@ -75,6 +80,13 @@ typedef struct VDIO
     PVDISK              pDisk;
     /** Flag whether to ignore flush requests. */
     bool                fIgnoreFlush;
+    /** Size of the shared read cache for each file of the image, 0 if disabled.
+     * Only set for images opened read-only, cleared on the first write. */
+    uint64_t volatile   cbSharedCache;
+    /** The image UUID for naming the shared read cache segments. */
+    RTUUID              SharedCacheUuid;
+    /** The image modification UUID for naming the shared read cache segments. */
+    RTUUID              SharedCacheUuidModification;
 } VDIO, *PVDIO;
 
 /** Forward declaration of an I/O task */
@@ -100,6 +112,9 @@ typedef struct VDIMAGE
     /** Image open flags (only those handled generically in this code and which
      * the backends will never ever see). */
     unsigned            uOpenFlags;
+    /** Link in the list of images removed from the chain while I/O might
+     * still use them (VDISK::pImagesRetired). */
+    struct VDIMAGE     *pRetiredNext;
 
     /** Function pointers for the various backend methods. */
     PCVDIMAGEBACKEND    Backend;
@@ -112,6 +127,20 @@ typedef struct VDIMAGE
 /** The special uninitialized size value for he image. */
 #define VD_IMAGE_SIZE_UNINITIALIZED UINT64_C(0)
 
+/** Number of entries in the queue of ranges to promote into the cache. */
+#define VD_CACHE_PROMOTE_QUEUE_SIZE 64
+
+/**
+ * Range missed in the cache by a read which should be added to the cache.
+ */
+typedef struct VDCACHEPROMOTE
+{
+    /** Start offset of the range. */
+    uint64_t            uOffset;
+    /** Size of the range in bytes. */
+    size_t              cbRange;
+} VDCACHEPROMOTE;
+
 /**
  * Virtual disk cache image descriptor.
  */
@@ -126,6 +155,9 @@ typedef struct VDCACHE
     /** Image open flags (only those handled generically in this code and which
      * the backends will never ever see). */
     unsigned            uOpenFlags;
+    /** Link in the list of images removed from the chain while I/O might
+     * still use them (VDISK::pImagesRetired). */
+    struct VDIMAGE     *pRetiredNext;
 
     /** Function pointers for the various backend methods. */
     PCVDCACHEBACKEND    Backend;
@@ -134,6 +166,26 @@ typedef struct VDCACHE
     PVDINTERFACE        pVDIfsCache;
     /** I/O related things. */
     VDIO                VDIo;
+
+    /** How the cache is used for writes. */
+    VDCACHEMODE         enmMode;
+    /** Background thread filling the cache after read misses, writing back
+     * dirty data and committing the cache metadata periodically. */
+    RTTHREAD            hThread;
+    /** Event semaphore to wake up the background thread. */
+    RTSEMEVENT          hEvtThread;
+    /** Flag whether the background thread should terminate. */
+    volatile bool       fShutdown;
+    /** Flag whether the I/O path queued new work for the background thread. */
+    volatile bool       fWorkPending;
+    /** Mutex protecting the promotion queue. */
+    RTSEMFASTMUTEX      hMtxPromote;
+    /** Index of the next free promotion queue entry. */
+    uint32_t            idxPromoteHead;
+    /** Index of the oldest queued promotion queue entry. */
+    uint32_t            idxPromoteTail;
+    /** Ranges to promote into the cache. */
+    VDCACHEPROMOTE      aPromote[VD_CACHE_PROMOTE_QUEUE_SIZE];
 } VDCACHE, *PVDCACHE;
 
 /**
@@ -168,6 +220,232 @@ typedef struct VDDISCARDSTATE
     RTLISTNODE          ListLru;
 } VDDISCARDSTATE, *PVDDISCARDSTATE;
 
+/** Shift for the granule size tracked by the block ownership index (4KiB). */
+#define VD_OWNERIDX_GRANULE_SHIFT       12
+/** Granule size tracked by the block ownership index. */
+#define VD_OWNERIDX_GRANULE_SIZE        RT_BIT_32(VD_OWNERIDX_GRANULE_SHIFT)
+/** Shift for the number of granules per lazily allocated chunk (64K granules, 256MiB). */
+#define VD_OWNERIDX_CHUNK_SHIFT         16
+/** Number of granules per chunk. */
+#define VD_OWNERIDX_CHUNK_GRANULES      RT_BIT_32(VD_OWNERIDX_CHUNK_SHIFT)
+/** Owner entry: unknown, the chain must be walked. */
+#define VD_OWNERIDX_UNKNOWN             UINT8_C(0)
+/** Owner entry: no image in the chain contains data for the granule. */
+#define VD_OWNERIDX_FREE                UINT8_MAX
+/** Maximum number of images in a chain the ownership index can describe. */
+#define VD_OWNERIDX_IMAGES_MAX          (VD_OWNERIDX_FREE - 1)
+
+/**
+ * Block ownership index for differencing image chains.
+ *
+ * Records for every granule which image in the chain (1-based, counting from
+ * the base) satisfied the last full chain read or write, so reads can go
+ * straight to the owning image instead of asking every image above it first.
+ * Entries are filled in lazily, updated by writes and the whole index is
+ * dropped whenever the chain topology changes.
+ */
+typedef struct VDOWNERIDX
+{
+    /** Number of images in the chain when the index was created. */
+    unsigned            cImages;
+    /** Number of chunks in the chunk array. */
+    uint32_t            cChunks;
+    /** Lazily allocated chunks of per granule owner entries, NULL if unknown. */
+    uint8_t           **papbChunks;
+    /** The images in the chain, indexed by owner entry - 1. */
+    PVDIMAGE            apImages[VD_OWNERIDX_IMAGES_MAX];
+} VDOWNERIDX, *PVDOWNERIDX;
+
+/** Number of prefetch buffers used by the read-ahead, one is filled while the other is consumed. */
+#define VD_READ_AHEAD_BUFFERS           2
+/** Minimum (and initial) size of the read-ahead window. */
+#define VD_READ_AHEAD_WINDOW_MIN        _64K
+/** Maximum size of the read-ahead window which can be configured. */
+#define VD_READ_AHEAD_WINDOW_MAX        _16M
+/** Number of sequential reads in a row before read-ahead kicks in. */
+#define VD_READ_AHEAD_SEQ_READS_MIN     2
+
+/**
+ * Read-ahead prefetch buffer state.
+ */
+typedef enum VDREADAHEADBUFSTATE
+{
+    /** The buffer is unused. */
+    VDREADAHEADBUFSTATE_FREE = 0,
+    /** A prefetch into the buffer is in progress. */
+    VDREADAHEADBUFSTATE_READING,
+    /** The buffer contains valid data. */
+    VDREADAHEADBUFSTATE_VALID,
+    /** 32bit hack. */
+    VDREADAHEADBUFSTATE_32BIT_HACK = 0x7fffffff
+} VDREADAHEADBUFSTATE;
+
+/**
+ * Read-ahead prefetch buffer.
+ */
+typedef struct VDREADAHEADBUF
+{
+    /** The buffer state. */
+    VDREADAHEADBUFSTATE enmState;
+    /** Flag whether the data of the prefetch in progress is stale already
+     * because the range was written to, discarded on completion. */
+    bool                fStale;
+    /** Start offset of the data in the buffer. */
+    uint64_t            uOffset;
+    /** Size of the data in the buffer. */
+    size_t              cbData;
+    /** Number of bytes handed out to reads so far. */
+    size_t              cbConsumed;
+    /** The buffer memory (VDREADAHEAD::cbWindowMax bytes), allocated on first use. */
+    void               *pvBuf;
+    /** The segment for the prefetch I/O context. */
+    RTSGSEG             Seg;
+} VDREADAHEADBUF;
+/** Pointer to a read-ahead prefetch buffer. */
+typedef VDREADAHEADBUF *PVDREADAHEADBUF;
+
+/**
+ * Read-ahead state for sequential read streams.
+ *
+ * All members except cPrefetchesPending are protected by the disk lock
+ * (VDISK::fLocked).
+ */
+typedef struct VDREADAHEAD
+{
+    /** Maximum size of the prefetch window. */
+    size_t              cbWindowMax;
+    /** Current size of the prefetch window. */
+    size_t              cbWindow;
+    /** End of the last read, where the next read of a sequential stream starts. */
+    uint64_t            uOffsetNext;
+    /** Number of sequential reads in a row. */
+    uint32_t            cSeqReads;
+    /** Number of prefetches in progress. */
+    volatile uint32_t   cPrefetchesPending;
+    /** Where to account the statistics. */
+    PVDREADAHEADSTATS   pStats;
+    /** Internal statistics if the user didn't provide storage. */
+    VDREADAHEADSTATS    Stats;
+    /** The prefetch buffers. */
+    VDREADAHEADBUF      aBufs[VD_READ_AHEAD_BUFFERS];
+} VDREADAHEAD;
+/** Pointer to the read-ahead state. */
+typedef VDREADAHEAD *PVDREADAHEAD;
+
+/** Size of one chunk of a pipelined copy. */
+#define VD_COPY_CHUNK_SIZE              (4 * _1M)
+/** Default number of chunks in flight for a pipelined copy. */
+#define VD_COPY_PIPELINE_DEPTH_DEF      4
+/** Maximum number of chunks in flight for a pipelined copy. */
+#define VD_COPY_PIPELINE_DEPTH_MAX      64
+
+/**
+ * A chunk of a pipelined copy.
+ */
+typedef struct VDCOPYCHUNK
+{
+    /** The chunk buffer (VD_COPY_CHUNK_SIZE bytes). */
+    void               *pvBuf;
+    /** Offset of the data in the disk. */
+    uint64_t            uOffset;
+    /** Amount of valid data in the buffer. */
+    size_t              cbChunk;
+    /** Status code of the read. */
+    int                 rc;
+    /** Whether the chunk is unallocated or zero and doesn't need to be written. */
+    bool                fSkip;
+} VDCOPYCHUNK;
+/** Pointer to a chunk of a pipelined copy. */
+typedef VDCOPYCHUNK *PVDCOPYCHUNK;
+
+/**
+ * Pipelined copy state, the chunks form a ring filled by the reader thread
+ * and drained in order by the writing thread.
+ */
+typedef struct VDCOPYPIPELINE
+{
+    /** The source disk. */
+    PVDISK              pDiskFrom;
+    /** The source image. */
+    PVDIMAGE            pImageFrom;
+    /** Number of source images to consider, 0 for the whole chain. */
+    unsigned            cImagesFromRead;
+    /** Whether the source is read blockwise from the backends. */
+    bool                fBlockwiseCopy;
+    /** Whether all zero chunks are skipped. */
+    bool                fSkipZeroes;
+    /** Set by the writer to stop the reader. */
+    volatile bool       fCancel;
+    /** Set by the reader when it is done. */
+    volatile bool       fReaderDone;
+    /** Number of bytes to copy. */
+    uint64_t            cbSize;
+    /** Number of chunks in the ring. */
+    uint32_t            cChunks;
+    /** Number of chunks read so far. */
+    volatile uint32_t   cProduced;
+    /** Number of chunks written so far. */
+    volatile uint32_t   cConsumed;
+    /** The chunks. */
+    PVDCOPYCHUNK        paChunks;
+    /** The reader thread. */
+    RTTHREAD            hThread;
+    /** Signalled by the reader when a chunk was read. */
+    RTSEMEVENT          hEvtProduced;
+    /** Signalled by the writer when a chunk was written. */
+    RTSEMEVENT          hEvtConsumed;
+} VDCOPYPIPELINE;
+/** Pointer to the pipelined copy state. */
+typedef VDCOPYPIPELINE *PVDCOPYPIPELINE;
+
+/** Size of the chunks the background stream operation works on. */
+#define VD_STREAM_CHUNK_SIZE            _1M
+/** Maximum number of unallocated ranges tracked for one chunk. */
+#define VD_STREAM_RANGES_MAX            64
+/** Time to wait before retrying a chunk which raced with guest I/O, in milliseconds. */
+#define VD_STREAM_RETRY_INTERVAL_MS     10
+
+/**
+ * Background stream (chain flattening) state, see VDStreamStart().
+ */
+typedef struct VDSTREAM
+{
+    /** The image the parent data is copied into, the last image when started. */
+    PVDIMAGE            pImageTarget;
+    /** Size of the disk. */
+    uint64_t            cbDisk;
+    /** Maximum number of bytes to copy per second, 0 for no limit. */
+    uint64_t            cbPerSecMax;
+    /** Completion callback. */
+    PFNVDSTREAMCOMPLETE pfnComplete;
+    /** Opaque user data for the completion callback. */
+    void               *pvUser;
+    /** The background thread. */
+    RTTHREAD            hThread;
+    /** Event to wake up the thread when it should stop. */
+    RTSEMEVENT          hEvtCancel;
+    /** Set to stop the thread. */
+    volatile bool       fCancel;
+    /** Set by the thread when it is done. */
+    volatile bool       fDone;
+    /** Set when a write or discard touched the active range (protected by the disk lock). */
+    volatile bool       fActiveDirty;
+    /** Offset of the chunk currently worked on. */
+    volatile uint64_t   uOffsetActive;
+    /** Size of the chunk currently worked on, 0 if none. */
+    volatile uint64_t   cbActive;
+    /** Number of bytes processed so far. */
+    volatile uint64_t   cbDone;
+    /** Status code of the operation. */
+    int                 rcStream;
+    /** Number of ranges in aRanges. */
+    uint32_t            cRanges;
+    /** Ranges of the active chunk which are not allocated in the target image. */
+    RTRANGE             aRanges[VD_STREAM_RANGES_MAX];
+} VDSTREAM;
+/** Pointer to the background stream state. */
+typedef VDSTREAM *PVDSTREAM;
+
 /**
  * VD filter instance.
  */
@@ -264,8 +542,21 @@ struct VDISK
 
     /** Pointer to the L2 disk cache if any. */
     PVDCACHE               pCache;
+    /** Size of the host-wide shared read cache for read-only images opened
+     * afterwards, 0 if disabled. */
+    uint64_t               cbSharedReadCache;
     /** Pointer to the discard state if any. */
     PVDDISCARDSTATE        pDiscard;
+    /** Block ownership index for differencing chains, NULL if not built. */
+    PVDOWNERIDX            pOwnerIdx;
+    /** Read-ahead state, NULL if disabled. */
+    PVDREADAHEAD           pReadAhead;
+    /** Background stream state, NULL if never started. */
+    PVDSTREAM              pStream;
+    /** Maximum number of bytes per second VDMerge() copies, 0 for no limit. */
+    uint64_t               cbMergePerSecMax;
+    /** Images removed from the chain by the stream operation, closed with the container. */
+    PVDIMAGE               pImagesRetired;
 
     /** Read filter chain - PVDFILTER. */
     RTLISTANCHOR           ListFilterChainRead;
@@ -292,6 +583,15 @@ DECLHIDDEN(uint32_t) vdGetFilterBackendCount(void);
 DECLHIDDEN(int)      vdQueryFilterBackend(uint32_t idx, PCVDFILTERBACKEND *ppBackend);
 DECLHIDDEN(int)      vdFindFilterBackend(const char *pszFilter, PCVDFILTERBACKEND *ppBackend);
 
+DECLHIDDEN(int)      vdSharedCacheOpen(const char *pszName, uint64_t cbCache, PVDSHAREDCACHE *ppCache);
+DECLHIDDEN(void)     vdSharedCacheClose(PVDSHAREDCACHE pCache);
+DECLHIDDEN(uint32_t) vdSharedCacheGetGeneration(PVDSHAREDCACHE pCache);
+DECLHIDDEN(void)     vdSharedCacheInvalidate(PVDSHAREDCACHE pCache);
+DECLHIDDEN(bool)     vdSharedCacheCanFill(PVDSHAREDCACHE pCache, uint64_t off, size_t cb);
+DECLHIDDEN(bool)     vdSharedCacheRead(PVDSHAREDCACHE pCache, uint64_t off, PRTSGBUF pSgBuf, size_t cb);
+DECLHIDDEN(void)     vdSharedCacheFill(PVDSHAREDCACHE pCache, uint32_t uGeneration, uint64_t off,
+                                       PCRTSGSEG paSegs, unsigned cSegs, size_t cb);
+
 DECLHIDDEN(int)      vdIoIterQueryStartNext(VDIOITER hVdIoIter, uint64_t *pu64Start);
 DECLHIDDEN(int)      vdIoIterQuerySegSizeByStart(VDIOITER hVdIoIter, uint64_t u64Start, size_t *pcRegSize);
 DECLHIDDEN(int)      vdIoIterAdvance(VDIOITER hVdIoIter, uint64_t cBlocksOrBytes);
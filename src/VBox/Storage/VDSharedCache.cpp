@@ -0,0 +1,435 @@
+/* $Id$ */
+/** @file
+ * VD - Host-wide shared read cache for read-only images.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+/** @page pg_vd_shared_cache    VD - Shared Read Cache
+ *
+ * Linked clones of the same base image each read the same base blocks from
+ * the host.  The shared read cache keeps file data of read-only images in a
+ * named shared memory segment which every VM process on the host opening the
+ * same image file (same UUID, modification UUID and location) maps.
+ *
+ * The segment consists of a header, a direct mapped slot table and the block
+ * data.  Each slot caches one aligned block of the file and is protected by a
+ * sequence counter: it is odd while a writer fills the slot, readers copy the
+ * data out and retry the counter afterwards to detect a concurrent update.
+ * There is no lock shared between processes, a slot left odd by a process
+ * which died while filling it is just lost.
+ *
+ * Any write to the file bumps the generation in the header which invalidates
+ * all slots at once.  The segment disappears when the process which created
+ * it closes it, processes still having it mapped keep using their mapping.
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#define LOG_GROUP LOG_GROUP_VD
+#include <VBox/err.h>
+#include <VBox/log.h>
+
+#include <iprt/asm.h>
+#include <iprt/assert.h>
+#include <iprt/mem.h>
+#include <iprt/sg.h>
+#include <iprt/shmem.h>
+#include <iprt/string.h>
+#include <iprt/thread.h>
+#include <iprt/time.h>
+
+#include "VDInternal.h"
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Magic of an initialized shared cache segment (Alan Turing). */
+#define VDSHCACHE_MAGIC                 UINT32_C(0x19120623)
+/** Version of the shared memory layout. */
+#define VDSHCACHE_VERSION               UINT32_C(1)
+/** Size of a cached block, reads are cached if they cover complete aligned blocks. */
+#define VDSHCACHE_BLOCK_SIZE            _4K
+/** Minimum number of slots. */
+#define VDSHCACHE_SLOTS_MIN             _1K
+/** Maximum number of slots (16GiB of data). */
+#define VDSHCACHE_SLOTS_MAX             _4M
+/** How long to wait for another process to initialize the segment, in milliseconds. */
+#define VDSHCACHE_INIT_WAIT_MS          1000
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * Shared cache segment header.
+ */
+typedef struct VDSHCACHEHDR
+{
+    /** Magic (VDSHCACHE_MAGIC), set last by the creator. */
+    uint32_t volatile   u32Magic;
+    /** Layout version (VDSHCACHE_VERSION). */
+    uint32_t            u32Version;
+    /** Size of a block in bytes. */
+    uint32_t            cbBlock;
+    /** Number of slots, power of two. */
+    uint32_t            cSlots;
+    /** Offset of the data area from the start of the segment. */
+    uint64_t            offData;
+    /** The current generation, slots with a different one are stale.  Never 0. */
+    uint32_t volatile   u32Generation;
+    /** Padding. */
+    uint32_t            u32Reserved;
+} VDSHCACHEHDR;
+/** Pointer to a shared cache segment header. */
+typedef VDSHCACHEHDR *PVDSHCACHEHDR;
+
+/**
+ * Shared cache slot.
+ */
+typedef struct VDSHCACHESLOT
+{
+    /** Sequence counter, odd while the slot is updated. */
+    uint32_t volatile   u32Seq;
+    /** The generation the slot was filled in. */
+    uint32_t volatile   u32Generation;
+    /** File offset of the cached block. */
+    uint64_t volatile   offBlock;
+} VDSHCACHESLOT;
+AssertCompileSize(VDSHCACHESLOT, 16);
+/** Pointer to a shared cache slot. */
+typedef VDSHCACHESLOT *PVDSHCACHESLOT;
+
+/**
+ * Process local shared cache instance.
+ */
+typedef struct VDSHAREDCACHE
+{
+    /** The shared memory handle. */
+    RTSHMEM             hShMem;
+    /** The mapped segment. */
+    PVDSHCACHEHDR       pHdr;
+    /** The slot table. */
+    PVDSHCACHESLOT      paSlots;
+    /** The data area. */
+    uint8_t            *pbData;
+    /** Block size (copy of the header value). */
+    uint32_t            cbBlock;
+    /** Slot index mask (copy of the header value). */
+    uint32_t            fSlotMask;
+    /** Number of reads served from the cache. */
+    uint64_t volatile   cHits;
+    /** Number of reads not served from the cache. */
+    uint64_t volatile   cMisses;
+    /** Number of blocks put into the cache. */
+    uint64_t volatile   cFills;
+    /** Name of the segment for logging. */
+    char                szName[1];
+} VDSHAREDCACHE;
+
+
+/**
+ * Returns the slot for the given block.
+ */
+DECLINLINE(uint32_t) vdSharedCacheSlotIdx(PVDSHAREDCACHE pCache, uint64_t offBlock)
+{
+    uint64_t uBlock = offBlock / pCache->cbBlock;
+    /* Fibonacci hashing to spread sequential blocks of different regions. */
+    return (uint32_t)((uBlock * UINT64_C(0x9e3779b97f4a7c15)) >> 32) & pCache->fSlotMask;
+}
+
+
+/**
+ * Opens or creates the shared cache segment with the given name.
+ *
+ * @returns VBox status code.
+ * @param   pszName     The host-wide name of the segment.
+ * @param   cbCache     Size of the data area when creating the segment,
+ *                      an existing segment keeps the size of its creator.
+ * @param   ppCache     Where to store the cache instance on success.
+ */
+DECLHIDDEN(int) vdSharedCacheOpen(const char *pszName, uint64_t cbCache, PVDSHAREDCACHE *ppCache)
+{
+    AssertPtrReturn(pszName, VERR_INVALID_POINTER);
+    AssertPtrReturn(ppCache, VERR_INVALID_POINTER);
+
+    size_t const cchName = strlen(pszName);
+    PVDSHAREDCACHE pCache = (PVDSHAREDCACHE)RTMemAllocZ(RT_UOFFSETOF_DYN(VDSHAREDCACHE, szName[cchName + 1]));
+    if (!pCache)
+        return VERR_NO_MEMORY;
+    memcpy(pCache->szName, pszName, cchName + 1);
+
+    /* The slot count is the largest power of two the size allows for. */
+    uint64_t cSlots = RT_MAX(cbCache / VDSHCACHE_BLOCK_SIZE, VDSHCACHE_SLOTS_MIN);
+    cSlots = RT_MIN(cSlots, VDSHCACHE_SLOTS_MAX);
+    while (cSlots & (cSlots - 1))
+        cSlots &= cSlots - 1;
+    uint64_t const offData = RT_ALIGN_64(sizeof(VDSHCACHEHDR) + cSlots * sizeof(VDSHCACHESLOT), _64K);
+    uint64_t const cbSeg   = offData + cSlots * VDSHCACHE_BLOCK_SIZE;
+
+    bool fCreated = true;
+    int rc = RTShMemOpen(&pCache->hShMem, pszName, RTSHMEM_O_F_CREATE_EXCL | RTSHMEM_O_F_READWRITE,
+                         (size_t)cbSeg, 1 /*cMappingsHint*/);
+    if (rc == VERR_ALREADY_EXISTS)
+    {
+        fCreated = false;
+        rc = RTShMemOpen(&pCache->hShMem, pszName, RTSHMEM_O_F_READWRITE, 0 /*cbMax*/, 1 /*cMappingsHint*/);
+    }
+    if (RT_SUCCESS(rc))
+    {
+        /* The creator might not have sized the segment yet. */
+        uint64_t const msStart   = RTTimeMilliTS();
+        size_t         cbMapping = 0;
+        for (;;)
+        {
+            rc = RTShMemQuerySize(pCache->hShMem, &cbMapping);
+            if (   RT_FAILURE(rc)
+                || cbMapping >= sizeof(VDSHCACHEHDR)
+                || RTTimeMilliTS() - msStart >= VDSHCACHE_INIT_WAIT_MS)
+                break;
+            RTThreadSleep(1);
+        }
+        if (RT_SUCCESS(rc) && cbMapping < sizeof(VDSHCACHEHDR))
+            rc = VERR_INVALID_STATE;
+        if (RT_SUCCESS(rc))
+        {
+            void *pv = NULL;
+            rc = RTShMemMapRegion(pCache->hShMem, 0, cbMapping, RTSHMEM_MAP_F_READ | RTSHMEM_MAP_F_WRITE, &pv);
+            if (RT_SUCCESS(rc))
+            {
+                PVDSHCACHEHDR pHdr = (PVDSHCACHEHDR)pv;
+                if (fCreated)
+                {
+                    /* The segment is zero filled, all slots are free and tagged with generation 0. */
+                    pHdr->u32Version    = VDSHCACHE_VERSION;
+                    pHdr->cbBlock       = VDSHCACHE_BLOCK_SIZE;
+                    pHdr->cSlots        = (uint32_t)cSlots;
+                    pHdr->offData       = offData;
+                    pHdr->u32Generation = 1;
+                    ASMAtomicWriteU32(&pHdr->u32Magic, VDSHCACHE_MAGIC);
+                }
+                else
+                {
+                    while (   ASMAtomicReadU32(&pHdr->u32Magic) != VDSHCACHE_MAGIC
+                           && RTTimeMilliTS() - msStart < VDSHCACHE_INIT_WAIT_MS)
+                        RTThreadSleep(1);
+
+                    if (   ASMAtomicReadU32(&pHdr->u32Magic) != VDSHCACHE_MAGIC
+                        || pHdr->u32Version != VDSHCACHE_VERSION
+                        || pHdr->cbBlock != VDSHCACHE_BLOCK_SIZE
+                        || !pHdr->cSlots
+                        || (pHdr->cSlots & (pHdr->cSlots - 1))
+                        || pHdr->offData < sizeof(VDSHCACHEHDR) + (uint64_t)pHdr->cSlots * sizeof(VDSHCACHESLOT)
+                        || pHdr->offData + (uint64_t)pHdr->cSlots * pHdr->cbBlock > cbMapping)
+                        rc = VERR_VERSION_MISMATCH;
+                }
+
+                if (RT_SUCCESS(rc))
+                {
+                    pCache->pHdr      = pHdr;
+                    pCache->paSlots   = (PVDSHCACHESLOT)(pHdr + 1);
+                    pCache->pbData    = (uint8_t *)pHdr + pHdr->offData;
+                    pCache->cbBlock   = pHdr->cbBlock;
+                    pCache->fSlotMask = pHdr->cSlots - 1;
+
+                    LogRel(("VD: %s shared read cache '%s' (%u slots of %u bytes)\n",
+                            fCreated ? "Created" : "Attached to", pszName, pHdr->cSlots, pHdr->cbBlock));
+                    *ppCache = pCache;
+                    return VINF_SUCCESS;
+                }
+
+                RTShMemUnmapRegion(pCache->hShMem, pv);
+            }
+        }
+        RTShMemClose(pCache->hShMem);
+    }
+
+    LogRel(("VD: Failed to open shared read cache '%s': %Rrc\n", pszName, rc));
+    RTMemFree(pCache);
+    return rc;
+}
+
+
+/**
+ * Closes the given shared cache instance.
+ *
+ * @param   pCache      The shared cache instance.
+ */
+DECLHIDDEN(void) vdSharedCacheClose(PVDSHAREDCACHE pCache)
+{
+    AssertPtrReturnVoid(pCache);
+
+    LogRel(("VD: Shared read cache '%s': %RU64 hits, %RU64 misses, %RU64 blocks filled\n",
+            pCache->szName, pCache->cHits, pCache->cMisses, pCache->cFills));
+
+    int rc = RTShMemUnmapRegion(pCache->hShMem, pCache->pHdr);
+    AssertRC(rc);
+    rc = RTShMemClose(pCache->hShMem);
+    AssertRC(rc);
+    RTMemFree(pCache);
+}
+
+
+/**
+ * Returns the current generation of the cache, to be passed to
+ * vdSharedCacheFill() for data read from the file afterwards.
+ *
+ * @returns Current generation.
+ * @param   pCache      The shared cache instance.
+ */
+DECLHIDDEN(uint32_t) vdSharedCacheGetGeneration(PVDSHAREDCACHE pCache)
+{
+    return ASMAtomicReadU32(&pCache->pHdr->u32Generation);
+}
+
+
+/**
+ * Invalidates the whole cache, called before the file is modified.
+ *
+ * @param   pCache      The shared cache instance.
+ */
+DECLHIDDEN(void) vdSharedCacheInvalidate(PVDSHAREDCACHE pCache)
+{
+    if (ASMAtomicIncU32(&pCache->pHdr->u32Generation) == 0)
+        ASMAtomicIncU32(&pCache->pHdr->u32Generation); /* Generation 0 marks never filled slots. */
+}
+
+
+/**
+ * Returns whether the given range covers at least one complete block.
+ *
+ * @returns true if data read for the range can be put into the cache.
+ * @param   pCache      The shared cache instance.
+ * @param   off         File offset of the range.
+ * @param   cb          Size of the range.
+ */
+DECLHIDDEN(bool) vdSharedCacheCanFill(PVDSHAREDCACHE pCache, uint64_t off, size_t cb)
+{
+    return RT_ALIGN_64(off, pCache->cbBlock) + pCache->cbBlock <= off + cb;
+}
+
+
+/**
+ * Tries to read the given range from the cache.
+ *
+ * @returns true if the whole range was copied from the cache, false if it must
+ *          be read from the file.
+ * @param   pCache      The shared cache instance.
+ * @param   off         File offset to read from.
+ * @param   pSgBuf      The S/G buffer to copy the data to, advanced on success only.
+ * @param   cb          Number of bytes to read.
+ */
+DECLHIDDEN(bool) vdSharedCacheRead(PVDSHAREDCACHE pCache, uint64_t off, PRTSGBUF pSgBuf, size_t cb)
+{
+    uint32_t const cbBlock = pCache->cbBlock;
+    if (   (off & (cbBlock - 1))
+        || (cb & (cbBlock - 1))
+        || !cb)
+    {
+        ASMAtomicIncU64(&pCache->cMisses);
+        return false;
+    }
+
+    uint32_t const uGeneration = ASMAtomicReadU32(&pCache->pHdr->u32Generation);
+    RTSGBUF SgBuf;
+    RTSgBufClone(&SgBuf, pSgBuf);
+
+    for (uint64_t offBlock = off; offBlock < off + cb; offBlock += cbBlock)
+    {
+        uint32_t const       idxSlot = vdSharedCacheSlotIdx(pCache, offBlock);
+        PVDSHCACHESLOT const pSlot   = &pCache->paSlots[idxSlot];
+
+        uint32_t const u32Seq = ASMAtomicReadU32(&pSlot->u32Seq);
+        if (   (u32Seq & 1)
+            || ASMAtomicReadU64(&pSlot->offBlock) != offBlock
+            || ASMAtomicReadU32(&pSlot->u32Generation) != uGeneration)
+        {
+            ASMAtomicIncU64(&pCache->cMisses);
+            return false;
+        }
+
+        size_t cbCopied = RTSgBufCopyFromBuf(&SgBuf, &pCache->pbData[(size_t)idxSlot * cbBlock], cbBlock);
+        Assert(cbCopied == cbBlock); RT_NOREF(cbCopied);
+
+        /* Somebody refilled the slot while we were copying, the data might be torn. */
+        if (ASMAtomicReadU32(&pSlot->u32Seq) != u32Seq)
+        {
+            ASMAtomicIncU64(&pCache->cMisses);
+            return false;
+        }
+    }
+
+    RTSgBufAdvance(pSgBuf, cb);
+    ASMAtomicIncU64(&pCache->cHits);
+    return true;
+}
+
+
+/**
+ * Puts the complete blocks of data just read from the file into the cache.
+ *
+ * @param   pCache      The shared cache instance.
+ * @param   uGeneration The generation returned by vdSharedCacheGetGeneration()
+ *                      before the data was read from the file.
+ * @param   off         File offset the data was read from.
+ * @param   paSegs      The segments holding the data.
+ * @param   cSegs       Number of segments.
+ * @param   cb          Number of bytes read.
+ */
+DECLHIDDEN(void) vdSharedCacheFill(PVDSHAREDCACHE pCache, uint32_t uGeneration, uint64_t off,
+                                   PCRTSGSEG paSegs, unsigned cSegs, size_t cb)
+{
+    uint32_t const cbBlock = pCache->cbBlock;
+    uint64_t const offEnd  = off + cb;
+    uint64_t       offBlock = RT_ALIGN_64(off, cbBlock);
+
+    RTSGBUF SgBuf;
+    RTSgBufInit(&SgBuf, paSegs, cSegs);
+    RTSgBufAdvance(&SgBuf, (size_t)(offBlock - off));
+
+    for (; offBlock + cbBlock <= offEnd; offBlock += cbBlock)
+    {
+        uint32_t const       idxSlot = vdSharedCacheSlotIdx(pCache, offBlock);
+        PVDSHCACHESLOT const pSlot   = &pCache->paSlots[idxSlot];
+
+        /* Skip the block if somebody else is updating the slot. */
+        uint32_t const u32Seq = ASMAtomicReadU32(&pSlot->u32Seq);
+        if (   (u32Seq & 1)
+            || !ASMAtomicCmpXchgU32(&pSlot->u32Seq, u32Seq + 1, u32Seq))
+        {
+            RTSgBufAdvance(&SgBuf, cbBlock);
+            continue;
+        }
+
+        ASMAtomicWriteU64(&pSlot->offBlock, offBlock);
+        ASMAtomicWriteU32(&pSlot->u32Generation, uGeneration);
+        size_t cbCopied = RTSgBufCopyToBuf(&SgBuf, &pCache->pbData[(size_t)idxSlot * cbBlock], cbBlock);
+        Assert(cbCopied == cbBlock); RT_NOREF(cbCopied);
+        ASMAtomicWriteU32(&pSlot->u32Seq, u32Seq + 2);
+
+        ASMAtomicIncU64(&pCache->cFills);
+    }
+}
@@ -36,6 +36,7 @@
 #include <VBox/log.h>
 #include <VBox/version.h>
 #include <iprt/asm.h>
+#include <iprt/asm-mem.h>
 #include <iprt/assert.h>
 #include <iprt/mem.h>
 #include <iprt/uuid.h>
@@ -2449,7 +2450,7 @@ static DECLCALLBACK(int) vhdCompact(void *pBackendData, unsigned uPercentStart,
                 if (RT_FAILURE(rc))
                     break;
 
-                if (ASMBitFirstSet((volatile void *)pvBuf, (uint32_t)pImage->cbDataBlock * 8) == -1)
+                if (ASMMemIsZero(pvBuf, pImage->cbDataBlock))
                 {
                     paBat[i] = UINT32_MAX;
                     paBlocks[idxBlock] = ~0U;
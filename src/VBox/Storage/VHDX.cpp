@@ -271,6 +271,8 @@ typedef VhdxLogDataSector *PVhdxLogDataSector;
 
 /** Signature of a VHDX log data sector ("data"). */
 #define VHDX_LOG_DATA_SECTOR_SIGNATURE UINT32_C(0x61746164)
+/** Size of a log sector, entries are made of multiple sectors. */
+#define VHDX_LOG_SECTOR_SIZE           _4K
 
 /**
  * VHDX BAT entry.
@@ -290,6 +292,8 @@ typedef VhdxBatEntry *PVhdxBatEntry;
 #define VHDX_BAT_ENTRY_GET_FILE_OFFSET_MB(bat) (((bat) & UINT64_C(0xfffffffffff00000)) >> 20)
 /** Get a byte offset from the BAT entry. */
 #define VHDX_BAT_ENTRY_GET_FILE_OFFSET(bat) (VHDX_BAT_ENTRY_GET_FILE_OFFSET_MB(bat) * (uint64_t)_1M)
+/** Create a BAT entry from the given state and byte offset (must be 1MB aligned). */
+#define VHDX_BAT_ENTRY_CREATE(state, off) (((off) & UINT64_C(0xfffffffffff00000)) | (state))
 
 /** Block not present and the data is undefined. */
 #define VHDX_BAT_ENTRY_PAYLOAD_BLOCK_NOT_PRESENT       (0)
@@ -556,14 +560,77 @@ typedef struct VHDXIMAGE
     /** Logical geometry of this image. */
     VDGEOMETRY          LCHSGeometry;
 
-    /** The BAT. */
+    /** The BAT (rounded up to the sector size to keep the tail of the last
+     * sector around for log entries). */
     PVhdxBatEntry       paBat;
+    /** Number of BAT entries including the sector bitmap entries. */
+    uint32_t            cBatEntries;
     /** Chunk ratio. */
     uint32_t            uChunkRatio;
+    /** Start offset of the BAT region in the file. */
+    uint64_t            offBat;
+    /** File offset where the next payload block is allocated. */
+    uint64_t            offFileNext;
+
+    /** The current header (host endianess). */
+    VhdxHeader          Hdr;
+    /** Offset of the current header in the file. */
+    uint64_t            offHdrCurrent;
+    /** Offset of the next log entry relative to the start of the log. */
+    uint32_t            offLogNext;
+    /** Sequence number of the next log entry. */
+    uint64_t            uLogSeqNext;
+    /** Flag whether the log GUID was set in the header for this session
+     * and must be cleared when the image is closed. */
+    bool                fLogActive;
+
     /** The static region list. */
     VDREGIONLIST        RegionList;
 } VHDXIMAGE, *PVHDXIMAGE;
 
+/** Size of a BAT sector which gets updated through the log. */
+#define VHDX_BAT_SECTOR_SIZE            VHDX_LOG_SECTOR_SIZE
+/** Number of BAT entries in a BAT sector. */
+#define VHDX_BAT_SECTOR_ENTRIES         (VHDX_BAT_SECTOR_SIZE / sizeof(VhdxBatEntry))
+/** Size of a log entry updating a single BAT sector (header and one data sector). */
+#define VHDX_LOG_ENTRY_BAT_UPDATE_SIZE  (2 * VHDX_LOG_SECTOR_SIZE)
+
+/**
+ * State of an asynchronous block allocation.
+ */
+typedef enum VHDXBLOCKALLOCSTATE
+{
+    /** Invalid. */
+    VHDXBLOCKALLOCSTATE_INVALID = 0,
+    /** The user data is written to the new block. */
+    VHDXBLOCKALLOCSTATE_USER_ALLOC,
+    /** The log entry for the BAT update is written. */
+    VHDXBLOCKALLOCSTATE_LOG_WRITE,
+    /** The log is flushed. */
+    VHDXBLOCKALLOCSTATE_LOG_FLUSH,
+    /** 32bit hack. */
+    VHDXBLOCKALLOCSTATE_32BIT_HACK = 0x7fffffff
+} VHDXBLOCKALLOCSTATE;
+
+/**
+ * Asynchronous block allocation tracking structure.
+ */
+typedef struct VHDXBLOCKALLOC
+{
+    /** Current state of the allocation. */
+    VHDXBLOCKALLOCSTATE enmAllocState;
+    /** Index of the BAT entry being updated. */
+    uint32_t            idxBat;
+    /** The old BAT entry for rolling back on failure. */
+    uint64_t            u64BatEntryOld;
+    /** File offset of the new block. */
+    uint64_t            offBlock;
+    /** Number of bytes written to the new block. */
+    size_t              cbWrite;
+} VHDXBLOCKALLOC;
+/** Pointer to an asynchronous block allocation tracking structure. */
+typedef VHDXBLOCKALLOC *PVHDXBLOCKALLOC;
+
 /**
  * Endianess conversion direction.
  */
@@ -612,6 +679,7 @@ static const VHDXMETADATAITEMPROPS s_aVhdxMetadataItemProps[] =
 /*********************************************************************************************************************************
 *   Internal Functions                                                                                                           *
 *********************************************************************************************************************************/
+static int vhdxHeaderUpdate(PVHDXIMAGE pImage);
 
 /**
  * Converts the file identifier between file and host endianness.
@@ -718,8 +786,6 @@ DECLINLINE(void) vhdxConvRegionTblEntryEndianess(VHDXECONV enmConv, PVhdxRegionT
     pRegTblEntConv->u32Flags      = SET_ENDIAN_U32(pRegTblEnt->u32Flags);
 }
 
-#if 0 /* unused */
-
 /**
  * Converts a VHDX log entry header between file and host endianness.
  *
@@ -741,6 +807,7 @@ DECLINLINE(void) vhdxConvLogEntryHdrEndianess(VHDXECONV enmConv, PVhdxLogEntryHd
     pLogEntryHdrConv->u32Reserved          = SET_ENDIAN_U32(pLogEntryHdr->u32Reserved);
     vhdxConvUuidEndianess(enmConv, &pLogEntryHdrConv->UuidLog, &pLogEntryHdr->UuidLog);
     pLogEntryHdrConv->u64FlushedFileOffset = SET_ENDIAN_U64(pLogEntryHdr->u64FlushedFileOffset);
+    pLogEntryHdrConv->u64LastFileOffset    = SET_ENDIAN_U64(pLogEntryHdr->u64LastFileOffset);
 }
 
 /**
@@ -800,8 +867,6 @@ DECLINLINE(void) vhdxConvLogDataSectorEndianess(VHDXECONV enmConv, PVhdxLogDataS
     pLogDataSectorConv->u32SequenceLow   = SET_ENDIAN_U32(pLogDataSector->u32SequenceLow);
 }
 
-#endif /* unused */
-
 /**
  * Converts a BAT between file and host endianess.
  *
@@ -991,7 +1056,18 @@ static int vhdxFreeImage(PVHDXIMAGE pImage, bool fDelete)
     {
         if (pImage->pStorage)
         {
-            rc = vdIfIoIntFileClose(pImage->pIfIo, pImage->pStorage);
+            /* All log entries were applied, mark the log as empty before closing. */
+            if (   pImage->fLogActive
+                && !fDelete)
+            {
+                RTUuidClear(&pImage->Hdr.UuidLog);
+                rc = vhdxHeaderUpdate(pImage);
+            }
+            pImage->fLogActive = false;
+
+            int rc2 = vdIfIoIntFileClose(pImage->pIfIo, pImage->pStorage);
+            if (RT_SUCCESS(rc))
+                rc = rc2;
             pImage->pStorage = NULL;
         }
 
@@ -1016,27 +1092,23 @@ static int vhdxFreeImage(PVHDXIMAGE pImage, bool fDelete)
  * @returns VBox status code.
  * @param   pImage    Image instance data.
  * @param   pHdr      The header to load.
+ * @param   offHdr    Offset of the header in the file.
  */
-static int vhdxLoadHeader(PVHDXIMAGE pImage, PVhdxHeader pHdr)
+static int vhdxLoadHeader(PVHDXIMAGE pImage, PVhdxHeader pHdr, uint64_t offHdr)
 {
     int rc = VINF_SUCCESS;
 
-    LogFlowFunc(("pImage=%#p pHdr=%#p\n", pImage, pHdr));
+    LogFlowFunc(("pImage=%#p pHdr=%#p offHdr=%llu\n", pImage, pHdr, offHdr));
 
     /*
-     * Most fields in the header are not required because the backend implements
-     * readonly access only so far.
-     * We just have to check that the log is empty, we have to refuse to load the
-     * image otherwsie because replaying the log is not implemented.
+     * The header is kept around for updating it when the image is opened for writing.
+     * A non empty log is dealt with after the header was loaded, see vhdxLogReplay().
      */
     if (pHdr->u16Version == VHDX_HEADER_VHDX_VERSION)
     {
-        /* Check that the log UUID is zero. */
         pImage->uVersion = pHdr->u16Version;
-        if (!RTUuidIsNull(&pHdr->UuidLog))
-            rc = vdIfError(pImage->pIfError, VERR_NOT_SUPPORTED, RT_SRC_POS,
-                           "VHDX: Image \'%s\' has a non empty log which is not supported",
-                           pImage->pszFilename);
+        pImage->offHdrCurrent = offHdr;
+        memcpy(&pImage->Hdr, pHdr, sizeof(pImage->Hdr));
     }
     else
         rc = vdIfError(pImage->pIfError, VERR_NOT_SUPPORTED, RT_SRC_POS,
@@ -1112,7 +1184,8 @@ static int vhdxFindAndLoadCurrentHeader(PVHDXIMAGE pImage)
         if (fHdr1Valid != fHdr2Valid)
         {
             /* Only one header is valid - use it. */
-            rc = vhdxLoadHeader(pImage, fHdr1Valid ? pHdr1 : pHdr2);
+            rc = vhdxLoadHeader(pImage, fHdr1Valid ? pHdr1 : pHdr2,
+                                fHdr1Valid ? VHDX_HEADER1_OFFSET : VHDX_HEADER2_OFFSET);
         }
         else if (!fHdr1Valid && !fHdr2Valid)
         {
@@ -1124,9 +1197,9 @@ static int vhdxFindAndLoadCurrentHeader(PVHDXIMAGE pImage)
         {
             /* Both headers are valid. Use the sequence number to find the current one. */
             if (pHdr1->u64SequenceNumber > pHdr2->u64SequenceNumber)
-                rc = vhdxLoadHeader(pImage, pHdr1);
+                rc = vhdxLoadHeader(pImage, pHdr1, VHDX_HEADER1_OFFSET);
             else
-                rc = vhdxLoadHeader(pImage, pHdr2);
+                rc = vhdxLoadHeader(pImage, pHdr2, VHDX_HEADER2_OFFSET);
         }
     }
     else
@@ -1142,6 +1215,344 @@ static int vhdxFindAndLoadCurrentHeader(PVHDXIMAGE pImage)
     return rc;
 }
 
+/**
+ * Writes the in memory header with an incremented sequence number to the
+ * non current header location, making it the current one.
+ *
+ * @returns VBox status code.
+ * @param   pImage    Image instance data.
+ */
+static int vhdxHeaderUpdate(PVHDXIMAGE pImage)
+{
+    int rc = VINF_SUCCESS;
+    uint64_t offHdr =   pImage->offHdrCurrent == VHDX_HEADER1_OFFSET
+                      ? VHDX_HEADER2_OFFSET
+                      : VHDX_HEADER1_OFFSET;
+
+    LogFlowFunc(("pImage=%#p offHdr=%llu\n", pImage, offHdr));
+
+    PVhdxHeader pHdr = (PVhdxHeader)RTMemTmpAllocZ(sizeof(VhdxHeader));
+    if (pHdr)
+    {
+        memcpy(pHdr, &pImage->Hdr, sizeof(*pHdr));
+        pHdr->u64SequenceNumber++;
+        pHdr->u32Checksum = 0;
+        vhdxConvHeaderEndianess(VHDXECONV_H2F, pHdr, pHdr);
+        pHdr->u32Checksum = RT_H2LE_U32(RTCrc32C(pHdr, sizeof(VhdxHeader)));
+
+        /* The header must not be current before everything it refers to is on the disk. */
+        rc = vdIfIoIntFileFlushSync(pImage->pIfIo, pImage->pStorage);
+        if (RT_SUCCESS(rc))
+            rc = vdIfIoIntFileWriteSync(pImage->pIfIo, pImage->pStorage, offHdr, pHdr, sizeof(*pHdr));
+        if (RT_SUCCESS(rc))
+            rc = vdIfIoIntFileFlushSync(pImage->pIfIo, pImage->pStorage);
+        if (RT_SUCCESS(rc))
+        {
+            pImage->Hdr.u64SequenceNumber++;
+            pImage->offHdrCurrent = offHdr;
+        }
+        else
+            rc = vdIfError(pImage->pIfError, rc, RT_SRC_POS,
+                           "VHDX: Updating the header of image \'%s\' failed",
+                           pImage->pszFilename);
+
+        RTMemTmpFree(pHdr);
+    }
+    else
+        rc = VERR_NO_MEMORY;
+
+    LogFlowFunc(("returns rc=%Rrc\n", rc));
+    return rc;
+}
+
+/**
+ * Checks whether the given log entry is valid and belongs to the current log.
+ *
+ * @returns true if the log entry is valid, false otherwise.
+ * @param   pImage    Image instance data.
+ * @param   pbLog     The complete log.
+ * @param   cbLog     Size of the log in bytes.
+ * @param   offEntry  Offset of the entry to check from the start of the log.
+ * @param   pHdr      Where to store the log entry header converted to host endianess.
+ */
+static bool vhdxLogEntryIsValid(PVHDXIMAGE pImage, uint8_t *pbLog, uint32_t cbLog,
+                                uint32_t offEntry, PVhdxLogEntryHdr pHdr)
+{
+    if (cbLog - offEntry < VHDX_LOG_SECTOR_SIZE)
+        return false;
+
+    PVhdxLogEntryHdr pHdrFile = (PVhdxLogEntryHdr)(pbLog + offEntry);
+    vhdxConvLogEntryHdrEndianess(VHDXECONV_F2H, pHdr, pHdrFile);
+
+    if (   pHdr->u32Signature != VHDX_LOG_ENTRY_HEADER_SIGNATURE
+        || pHdr->u32EntryLength < VHDX_LOG_SECTOR_SIZE
+        || pHdr->u32EntryLength % VHDX_LOG_SECTOR_SIZE
+        || pHdr->u32EntryLength > cbLog - offEntry
+        || pHdr->u32Tail % VHDX_LOG_SECTOR_SIZE
+        || pHdr->u32Tail >= cbLog
+        || !pHdr->u64SequenceNumber
+        || RTUuidCompare(&pHdr->UuidLog, &pImage->Hdr.UuidLog))
+        return false;
+
+    /* The descriptors come right after the header, the data sectors follow the descriptor sectors. */
+    uint32_t cbDescs = RT_ALIGN_32(sizeof(VhdxLogEntryHdr) + pHdr->u32DescriptorCount * sizeof(VhdxLogDataDesc),
+                                   VHDX_LOG_SECTOR_SIZE);
+    if (   pHdr->u32DescriptorCount > pHdr->u32EntryLength / sizeof(VhdxLogDataDesc)
+        || cbDescs > pHdr->u32EntryLength)
+        return false;
+
+    /* Verify the checksum over the whole entry. */
+    uint32_t u32ChkSumSaved = pHdrFile->u32Checksum;
+    pHdrFile->u32Checksum = 0;
+    uint32_t u32ChkSum = RTCrc32C(pHdrFile, pHdr->u32EntryLength);
+    pHdrFile->u32Checksum = u32ChkSumSaved;
+    if (u32ChkSum != pHdr->u32Checksum)
+        return false;
+
+    uint32_t offDataSector = offEntry + cbDescs;
+    for (uint32_t i = 0; i < pHdr->u32DescriptorCount; i++)
+    {
+        const uint8_t *pbDesc = pbLog + offEntry + sizeof(VhdxLogEntryHdr) + i * sizeof(VhdxLogDataDesc);
+        uint32_t u32Signature = RT_LE2H_U32(*(const uint32_t *)pbDesc);
+
+        if (u32Signature == VHDX_LOG_DATA_DESC_SIGNATURE)
+        {
+            VhdxLogDataDesc DataDesc;
+            memcpy(&DataDesc, pbDesc, sizeof(DataDesc));
+            vhdxConvLogDataDescEndianess(VHDXECONV_F2H, &DataDesc, &DataDesc);
+            if (   DataDesc.u64SequenceNumber != pHdr->u64SequenceNumber
+                || DataDesc.u64FileOffset % VHDX_LOG_SECTOR_SIZE
+                || offDataSector + VHDX_LOG_SECTOR_SIZE > offEntry + pHdr->u32EntryLength)
+                return false;
+
+            VhdxLogDataSector DataSector;
+            memcpy(&DataSector, pbLog + offDataSector, sizeof(DataSector));
+            vhdxConvLogDataSectorEndianess(VHDXECONV_F2H, &DataSector, &DataSector);
+            if (   DataSector.u32DataSignature != VHDX_LOG_DATA_SECTOR_SIGNATURE
+                || DataSector.u32SequenceHigh != RT_HI_U32(pHdr->u64SequenceNumber)
+                || DataSector.u32SequenceLow != RT_LO_U32(pHdr->u64SequenceNumber))
+                return false;
+
+            offDataSector += VHDX_LOG_SECTOR_SIZE;
+        }
+        else if (u32Signature == VHDX_LOG_ZERO_DESC_SIGNATURE)
+        {
+            VhdxLogZeroDesc ZeroDesc;
+            memcpy(&ZeroDesc, pbDesc, sizeof(ZeroDesc));
+            vhdxConvLogZeroDescEndianess(VHDXECONV_F2H, &ZeroDesc, &ZeroDesc);
+            if (   ZeroDesc.u64SequenceNumber != pHdr->u64SequenceNumber
+                || ZeroDesc.u64FileOffset % VHDX_LOG_SECTOR_SIZE
+                || ZeroDesc.u64ZeroLength % VHDX_LOG_SECTOR_SIZE)
+                return false;
+        }
+        else
+            return false;
+    }
+
+    return offDataSector == offEntry + pHdr->u32EntryLength;
+}
+
+/**
+ * Applies the given log entry to the image file.
+ *
+ * @returns VBox status code.
+ * @param   pImage    Image instance data.
+ * @param   pbEntry   The log entry, validated with vhdxLogEntryIsValid() already.
+ * @param   pHdr      The log entry header in host endianess.
+ */
+static int vhdxLogEntryApply(PVHDXIMAGE pImage, const uint8_t *pbEntry, const VhdxLogEntryHdr *pHdr)
+{
+    int rc = VINF_SUCCESS;
+    uint8_t *pbSector = (uint8_t *)RTMemTmpAllocZ(VHDX_LOG_SECTOR_SIZE);
+    if (!pbSector)
+        return VERR_NO_MEMORY;
+
+    const uint8_t *pbDataSector = pbEntry + RT_ALIGN_32(sizeof(VhdxLogEntryHdr) + pHdr->u32DescriptorCount * sizeof(VhdxLogDataDesc),
+                                                        VHDX_LOG_SECTOR_SIZE);
+    for (uint32_t i = 0; i < pHdr->u32DescriptorCount && RT_SUCCESS(rc); i++)
+    {
+        const uint8_t *pbDesc = pbEntry + sizeof(VhdxLogEntryHdr) + i * sizeof(VhdxLogDataDesc);
+
+        if (RT_LE2H_U32(*(const uint32_t *)pbDesc) == VHDX_LOG_DATA_DESC_SIGNATURE)
+        {
+            /*
+             * The leading and trailing bytes of the sector were moved to the descriptor,
+             * they are kept in file endianess.
+             */
+            const VhdxLogDataDesc *pDataDesc = (const VhdxLogDataDesc *)pbDesc;
+            const VhdxLogDataSector *pDataSector = (const VhdxLogDataSector *)pbDataSector;
+
+            memcpy(pbSector, &pDataDesc->u64LeadingBytes, sizeof(pDataDesc->u64LeadingBytes));
+            memcpy(pbSector + sizeof(pDataDesc->u64LeadingBytes), &pDataSector->u8Data[0], sizeof(pDataSector->u8Data));
+            memcpy(pbSector + VHDX_LOG_SECTOR_SIZE - sizeof(pDataDesc->u32TrailingBytes),
+                   &pDataDesc->u32TrailingBytes, sizeof(pDataDesc->u32TrailingBytes));
+            rc = vdIfIoIntFileWriteSync(pImage->pIfIo, pImage->pStorage, RT_LE2H_U64(pDataDesc->u64FileOffset),
+                                        pbSector, VHDX_LOG_SECTOR_SIZE);
+            pbDataSector += VHDX_LOG_SECTOR_SIZE;
+        }
+        else
+        {
+            VhdxLogZeroDesc ZeroDesc;
+            memcpy(&ZeroDesc, pbDesc, sizeof(ZeroDesc));
+            vhdxConvLogZeroDescEndianess(VHDXECONV_F2H, &ZeroDesc, &ZeroDesc);
+
+            uint64_t offZero = ZeroDesc.u64FileOffset;
+            uint64_t cbZero  = ZeroDesc.u64ZeroLength;
+            memset(pbSector, 0, VHDX_LOG_SECTOR_SIZE);
+            while (   cbZero
+                   && RT_SUCCESS(rc))
+            {
+                rc = vdIfIoIntFileWriteSync(pImage->pIfIo, pImage->pStorage, offZero,
+                                            pbSector, VHDX_LOG_SECTOR_SIZE);
+                offZero += VHDX_LOG_SECTOR_SIZE;
+                cbZero  -= VHDX_LOG_SECTOR_SIZE;
+            }
+        }
+    }
+
+    RTMemTmpFree(pbSector);
+    return rc;
+}
+
+/**
+ * Replays the log if the header refers to one.
+ *
+ * The active sequence is the sequence of valid entries with consecutive sequence
+ * numbers which has the highest sequence number of all sequences and contains the
+ * entry its last entry refers to as the tail. All entries from the tail up to the
+ * last one are applied in order.
+ *
+ * @returns VBox status code.
+ * @param   pImage    Image instance data.
+ */
+static int vhdxLogReplay(PVHDXIMAGE pImage)
+{
+    int rc = VINF_SUCCESS;
+    uint32_t cbLog = pImage->Hdr.u32LogLength;
+
+    LogFlowFunc(("pImage=%#p\n", pImage));
+
+    if (RTUuidIsNull(&pImage->Hdr.UuidLog))
+        return VINF_SUCCESS;
+
+    if (   pImage->Hdr.u16LogVersion != VHDX_HEADER_LOG_VERSION
+        || !cbLog
+        || cbLog % _1M
+        || pImage->Hdr.u64LogOffset % _1M)
+        return vdIfError(pImage->pIfError, VERR_VD_GEN_INVALID_HEADER, RT_SRC_POS,
+                         "VHDX: Image \'%s\' has an invalid log", pImage->pszFilename);
+
+    uint8_t *pbLog = (uint8_t *)RTMemAlloc(cbLog);
+    if (!pbLog)
+        return vdIfError(pImage->pIfError, VERR_NO_MEMORY, RT_SRC_POS,
+                         "VHDX: Out of memory allocating memory for the log of image \'%s\'",
+                         pImage->pszFilename);
+
+    rc = vdIfIoIntFileReadSync(pImage->pIfIo, pImage->pStorage, pImage->Hdr.u64LogOffset, pbLog, cbLog);
+    if (RT_SUCCESS(rc))
+    {
+        VhdxLogEntryHdr HdrHead;
+        uint32_t offTail = UINT32_MAX;
+        RT_ZERO(HdrHead);
+
+        for (uint32_t offStart = 0; offStart < cbLog; offStart += VHDX_LOG_SECTOR_SIZE)
+        {
+            VhdxLogEntryHdr Hdr;
+            if (!vhdxLogEntryIsValid(pImage, pbLog, cbLog, offStart, &Hdr))
+                continue;
+
+            /*
+             * Walk the sequence starting here to its end. It is only a candidate if the
+             * last entry refers to the start as the tail, any other sequence containing
+             * the tail is found when starting at the tail.
+             */
+            VhdxLogEntryHdr HdrCur = Hdr;
+            uint32_t offCur = offStart;
+            for (;;)
+            {
+                uint32_t offNext = (offCur + HdrCur.u32EntryLength) % cbLog;
+                if (offNext == offStart)
+                    break;
+
+                VhdxLogEntryHdr HdrNext;
+                if (   !vhdxLogEntryIsValid(pImage, pbLog, cbLog, offNext, &HdrNext)
+                    || HdrNext.u64SequenceNumber != HdrCur.u64SequenceNumber + 1)
+                    break;
+
+                HdrCur = HdrNext;
+                offCur = offNext;
+            }
+
+            bool fTailFound = HdrCur.u32Tail == offStart;
+            if (   fTailFound
+                && HdrCur.u64SequenceNumber > HdrHead.u64SequenceNumber)
+            {
+                HdrHead = HdrCur;
+                offTail = HdrCur.u32Tail;
+            }
+        }
+
+        if (offTail != UINT32_MAX)
+        {
+            if (!(pImage->uOpenFlags & VD_OPEN_FLAGS_READONLY))
+            {
+                /* Apply all entries from the tail up to the head. */
+                uint32_t offEntry = offTail;
+                for (;;)
+                {
+                    VhdxLogEntryHdr Hdr;
+                    bool fValid = vhdxLogEntryIsValid(pImage, pbLog, cbLog, offEntry, &Hdr);
+                    AssertBreakStmt(fValid, rc = VERR_INTERNAL_ERROR_3);
+
+                    rc = vhdxLogEntryApply(pImage, pbLog + offEntry, &Hdr);
+                    if (   RT_FAILURE(rc)
+                        || Hdr.u64SequenceNumber == HdrHead.u64SequenceNumber)
+                        break;
+                    offEntry = (offEntry + Hdr.u32EntryLength) % cbLog;
+                }
+
+                /* Make sure the file is as large as the log says. */
+                uint64_t cbFile = 0;
+                if (RT_SUCCESS(rc))
+                    rc = vdIfIoIntFileGetSize(pImage->pIfIo, pImage->pStorage, &cbFile);
+                if (   RT_SUCCESS(rc)
+                    && cbFile < HdrHead.u64LastFileOffset)
+                    rc = vdIfIoIntFileSetSize(pImage->pIfIo, pImage->pStorage, HdrHead.u64LastFileOffset);
+                if (RT_SUCCESS(rc))
+                    rc = vdIfIoIntFileFlushSync(pImage->pIfIo, pImage->pStorage);
+                if (RT_FAILURE(rc))
+                    rc = vdIfError(pImage->pIfError, rc, RT_SRC_POS,
+                                   "VHDX: Replaying the log of image \'%s\' failed",
+                                   pImage->pszFilename);
+                else
+                    LogRel(("VHDX: Replayed the log of image '%s' up to sequence number %llu\n",
+                            pImage->pszFilename, HdrHead.u64SequenceNumber));
+            }
+            else
+                rc = vdIfError(pImage->pIfError, VERR_NOT_SUPPORTED, RT_SRC_POS,
+                               "VHDX: Image \'%s\' has a non empty log which can only be replayed when opened for writing",
+                               pImage->pszFilename);
+        }
+    }
+    else
+        rc = vdIfError(pImage->pIfError, rc, RT_SRC_POS,
+                       "VHDX: Reading the log of image \'%s\' failed",
+                       pImage->pszFilename);
+
+    RTMemFree(pbLog);
+
+    /* The log is empty now, clear the GUID so nobody attempts to replay it again. */
+    if (   RT_SUCCESS(rc)
+        && !(pImage->uOpenFlags & VD_OPEN_FLAGS_READONLY))
+    {
+        RTUuidClear(&pImage->Hdr.UuidLog);
+        rc = vhdxHeaderUpdate(pImage);
+    }
+
+    LogFlowFunc(("returns rc=%Rrc\n", rc));
+    return rc;
+}
+
 /**
  * Loads the BAT region.
  *
@@ -1179,16 +1590,19 @@ static int vhdxLoadBatRegion(PVHDXIMAGE pImage, uint64_t offRegion,
         /*
          * Load the complete BAT region first, convert to host endianess and process
          * it afterwards. The SB entries can be removed because they are not needed yet.
+         * The BAT is loaded up to the end of the last sector because BAT updates are
+         * logged and written in whole sectors.
          */
-        paBatEntries = (PVhdxBatEntry)RTMemAlloc(cbBatEntries);
+        uint32_t cbBatLoad = RT_MIN(RT_ALIGN_32(cbBatEntries, VHDX_BAT_SECTOR_SIZE), (uint32_t)cbRegion);
+        paBatEntries = (PVhdxBatEntry)RTMemAllocZ(RT_ALIGN_32(cbBatEntries, VHDX_BAT_SECTOR_SIZE));
         if (paBatEntries)
         {
             rc = vdIfIoIntFileReadSync(pImage->pIfIo, pImage->pStorage, offRegion,
-                                       paBatEntries, cbBatEntries);
+                                       paBatEntries, cbBatLoad);
             if (RT_SUCCESS(rc))
             {
                 vhdxConvBatTableEndianess(VHDXECONV_F2H, paBatEntries, paBatEntries,
-                                          cBatEntries);
+                                          cbBatLoad / sizeof(VhdxBatEntry));
 
                 /* Go through the table and validate it. */
                 for (unsigned i = 0; i < cBatEntries; i++)
@@ -1198,8 +1612,8 @@ static int vhdxLoadBatRegion(PVHDXIMAGE pImage, uint64_t offRegion,
                     {
 /**
  * Disabled the verification because there are images out there with the sector bitmap
- * marked as present. The entry is never accessed and the image is readonly anyway,
- * so no harm done.
+ * marked as present. The entry is never accessed and only written back unchanged
+ * with the rest of the BAT sector, so no harm done.
  */
 #if 0
                         /* Sector bitmap block. */
@@ -1230,7 +1644,9 @@ static int vhdxLoadBatRegion(PVHDXIMAGE pImage, uint64_t offRegion,
                 if (RT_SUCCESS(rc))
                 {
                     pImage->paBat       = paBatEntries;
+                    pImage->cBatEntries = cBatEntries;
                     pImage->uChunkRatio = uChunkRatio;
+                    pImage->offBat      = offRegion;
                 }
             }
             else
@@ -1678,6 +2094,56 @@ static int vhdxLoadRegionTable(PVHDXIMAGE pImage)
     return rc;
 }
 
+/**
+ * Prepares an image opened for writing, updating the write GUIDs and activating
+ * the log for the BAT updates.
+ *
+ * @returns VBox status code.
+ * @param   pImage    Image instance data.
+ */
+static int vhdxPrepareForWrite(PVHDXIMAGE pImage)
+{
+    uint64_t cbFile = 0;
+    int rc = VINF_SUCCESS;
+
+    LogFlowFunc(("pImage=%#p\n", pImage));
+
+    rc = vdIfIoIntFileGetSize(pImage->pIfIo, pImage->pStorage, &cbFile);
+    if (RT_FAILURE(rc))
+        rc = vdIfError(pImage->pIfError, rc, RT_SRC_POS,
+                       "VHDX: Getting the size of image \'%s\' failed", pImage->pszFilename);
+    else if (   pImage->Hdr.u16LogVersion != VHDX_HEADER_LOG_VERSION
+        || pImage->Hdr.u32LogLength < VHDX_LOG_ENTRY_BAT_UPDATE_SIZE
+        || pImage->Hdr.u32LogLength % _1M
+        || pImage->Hdr.u64LogOffset % _1M)
+        rc = vdIfError(pImage->pIfError, VERR_VD_GEN_INVALID_HEADER, RT_SRC_POS,
+                       "VHDX: Image \'%s\' has an invalid log", pImage->pszFilename);
+    else if (pImage->cbBlock % _1M)
+        rc = vdIfError(pImage->pIfError, VERR_VD_GEN_INVALID_HEADER, RT_SRC_POS,
+                       "VHDX: Block size of image \'%s\' is not a multiple of 1MB", pImage->pszFilename);
+    else
+    {
+        /*
+         * The write GUIDs change whenever the image is opened for writing, the log GUID
+         * is new for every session so stale entries from earlier sessions never match.
+         */
+        RTUuidCreate(&pImage->Hdr.UuidFileWrite);
+        RTUuidCreate(&pImage->Hdr.UuidDataWrite);
+        RTUuidCreate(&pImage->Hdr.UuidLog);
+        rc = vhdxHeaderUpdate(pImage);
+        if (RT_SUCCESS(rc))
+        {
+            pImage->fLogActive  = true;
+            pImage->offLogNext  = 0;
+            pImage->uLogSeqNext = 1;
+            pImage->offFileNext = RT_ALIGN_64(cbFile, _1M);
+        }
+    }
+
+    LogFlowFunc(("returns rc=%Rrc\n", rc));
+    return rc;
+}
+
 /**
  * Internal: Open an image, constructing all necessary data structures.
  */
@@ -1694,10 +2160,6 @@ static int vhdxOpenImage(PVHDXIMAGE pImage, unsigned uOpenFlags)
     pImage->pIfIo = VDIfIoIntGet(pImage->pVDIfsImage);
     AssertPtrReturn(pImage->pIfIo, VERR_INVALID_PARAMETER);
 
-    /* Refuse write access, it is not implemented so far. */
-    if (!(uOpenFlags & VD_OPEN_FLAGS_READONLY))
-        return VERR_NOT_SUPPORTED;
-
     /*
      * Open the image.
      */
@@ -1726,9 +2188,17 @@ static int vhdxOpenImage(PVHDXIMAGE pImage, unsigned uOpenFlags)
                 else
                     rc = vhdxFindAndLoadCurrentHeader(pImage);
 
+                /* The log can modify anything else, so it must be replayed first. */
+                if (RT_SUCCESS(rc))
+                    rc = vhdxLogReplay(pImage);
+
                 /* Load the region table. */
                 if (RT_SUCCESS(rc))
                     rc = vhdxLoadRegionTable(pImage);
+
+                if (   RT_SUCCESS(rc)
+                    && !(uOpenFlags & VD_OPEN_FLAGS_READONLY))
+                    rc = vhdxPrepareForWrite(pImage);
             }
         }
         else
@@ -1756,6 +2226,189 @@ static int vhdxOpenImage(PVHDXIMAGE pImage, unsigned uOpenFlags)
     return rc;
 }
 
+/**
+ * Writes the given BAT sector from the in memory BAT to the image.
+ *
+ * @returns VBox status code.
+ * @param   pImage       Image instance data.
+ * @param   pIoCtx       The I/O context the update belongs to.
+ * @param   idxBatSector The BAT sector to write.
+ */
+static int vhdxBatSectorWrite(PVHDXIMAGE pImage, PVDIOCTX pIoCtx, uint32_t idxBatSector)
+{
+    PVhdxBatEntry paBatSector = (PVhdxBatEntry)RTMemTmpAlloc(VHDX_BAT_SECTOR_SIZE);
+    if (!paBatSector)
+        return VERR_NO_MEMORY;
+
+    vhdxConvBatTableEndianess(VHDXECONV_H2F, paBatSector, &pImage->paBat[idxBatSector * VHDX_BAT_SECTOR_ENTRIES],
+                              VHDX_BAT_SECTOR_ENTRIES);
+    int rc = vdIfIoIntFileWriteMeta(pImage->pIfIo, pImage->pStorage,
+                                    pImage->offBat + (uint64_t)idxBatSector * VHDX_BAT_SECTOR_SIZE,
+                                    paBatSector, VHDX_BAT_SECTOR_SIZE, pIoCtx, NULL, NULL);
+    RTMemTmpFree(paBatSector);
+    return rc;
+}
+
+/**
+ * Writes a log entry containing the BAT sector of the block being allocated.
+ *
+ * @returns VBox status code.
+ * @param   pImage       Image instance data.
+ * @param   pIoCtx       The I/O context the update belongs to.
+ * @param   pBlockAlloc  The block allocation.
+ * @param   pfnComplete  Completion callback.
+ */
+static int vhdxLogBatSectorWrite(PVHDXIMAGE pImage, PVDIOCTX pIoCtx, PVHDXBLOCKALLOC pBlockAlloc,
+                                 PFNVDXFERCOMPLETED pfnComplete)
+{
+    uint8_t *pbEntry = (uint8_t *)RTMemTmpAllocZ(VHDX_LOG_ENTRY_BAT_UPDATE_SIZE);
+    if (!pbEntry)
+        return VERR_NO_MEMORY;
+
+    uint32_t idxBatSector = pBlockAlloc->idxBat / VHDX_BAT_SECTOR_ENTRIES;
+    uint64_t uSeqNo       = pImage->uLogSeqNext++;
+    uint32_t offEntry     = pImage->offLogNext;
+
+    /* Each entry is a complete sequence of its own, the log is used as a ring. */
+    pImage->offLogNext = (offEntry + VHDX_LOG_ENTRY_BAT_UPDATE_SIZE) % pImage->Hdr.u32LogLength;
+
+    /*
+     * Put the sector into the data sector first, the payload of the data sector is at the
+     * same offset as in the sector, only the leading and trailing bytes are replaced.
+     */
+    uint8_t *pbSector = pbEntry + VHDX_LOG_SECTOR_SIZE;
+    vhdxConvBatTableEndianess(VHDXECONV_H2F, (PVhdxBatEntry)pbSector, &pImage->paBat[idxBatSector * VHDX_BAT_SECTOR_ENTRIES],
+                              VHDX_BAT_SECTOR_ENTRIES);
+
+    VhdxLogDataDesc DataDesc;
+    DataDesc.u32DataSignature  = VHDX_LOG_DATA_DESC_SIGNATURE;
+    DataDesc.u32TrailingBytes  = RT_LE2H_U32(*(uint32_t *)(pbSector + VHDX_LOG_SECTOR_SIZE - sizeof(uint32_t)));
+    DataDesc.u64LeadingBytes   = RT_LE2H_U64(*(uint64_t *)pbSector);
+    DataDesc.u64FileOffset     = pImage->offBat + (uint64_t)idxBatSector * VHDX_BAT_SECTOR_SIZE;
+    DataDesc.u64SequenceNumber = uSeqNo;
+    vhdxConvLogDataDescEndianess(VHDXECONV_H2F, &DataDesc, &DataDesc);
+
+    VhdxLogDataSector *pDataSector = (VhdxLogDataSector *)pbSector;
+    pDataSector->u32DataSignature = VHDX_LOG_DATA_SECTOR_SIGNATURE;
+    pDataSector->u32SequenceHigh  = RT_HI_U32(uSeqNo);
+    pDataSector->u32SequenceLow   = RT_LO_U32(uSeqNo);
+    vhdxConvLogDataSectorEndianess(VHDXECONV_H2F, pDataSector, pDataSector);
+
+    VhdxLogEntryHdr Hdr;
+    RT_ZERO(Hdr);
+    Hdr.u32Signature         = VHDX_LOG_ENTRY_HEADER_SIGNATURE;
+    Hdr.u32EntryLength       = VHDX_LOG_ENTRY_BAT_UPDATE_SIZE;
+    Hdr.u32Tail              = offEntry;
+    Hdr.u64SequenceNumber    = uSeqNo;
+    Hdr.u32DescriptorCount   = 1;
+    Hdr.UuidLog              = pImage->Hdr.UuidLog;
+    Hdr.u64FlushedFileOffset = pBlockAlloc->offBlock + pBlockAlloc->cbWrite;
+    Hdr.u64LastFileOffset    = pImage->offFileNext;
+    vhdxConvLogEntryHdrEndianess(VHDXECONV_H2F, &Hdr, &Hdr);
+
+    memcpy(pbEntry, &Hdr, sizeof(Hdr));
+    memcpy(pbEntry + sizeof(Hdr), &DataDesc, sizeof(DataDesc));
+    ((PVhdxLogEntryHdr)pbEntry)->u32Checksum = RT_H2LE_U32(RTCrc32C(pbEntry, VHDX_LOG_ENTRY_BAT_UPDATE_SIZE));
+
+    int rc = vdIfIoIntFileWriteMeta(pImage->pIfIo, pImage->pStorage, pImage->Hdr.u64LogOffset + offEntry,
+                                    pbEntry, VHDX_LOG_ENTRY_BAT_UPDATE_SIZE, pIoCtx,
+                                    pfnComplete, pBlockAlloc);
+    RTMemTmpFree(pbEntry);
+    return rc;
+}
+
+/**
+ * Rolls back a failed block allocation.
+ *
+ * @returns The status code of the failed operation.
+ * @param   pImage       Image instance data.
+ * @param   pBlockAlloc  The block allocation to roll back, freed.
+ * @param   rcReq        Status code of the failed operation.
+ */
+static int vhdxBlockAllocRollback(PVHDXIMAGE pImage, PVHDXBLOCKALLOC pBlockAlloc, int rcReq)
+{
+    /* The block is leaked in the file, it is not referenced by the BAT on the disk. */
+    if (pBlockAlloc->enmAllocState != VHDXBLOCKALLOCSTATE_USER_ALLOC)
+        pImage->paBat[pBlockAlloc->idxBat].u64BatEntry = pBlockAlloc->u64BatEntryOld;
+    RTMemFree(pBlockAlloc);
+    return rcReq;
+}
+
+/**
+ * Async block allocation state machine, advances to the next state after the
+ * previous I/O completed.
+ *
+ * The BAT update goes through the log: the user data is written to the new block
+ * first, the log entry with the updated BAT sector is written and flushed and only
+ * then the BAT sector is written in place.
+ *
+ * @returns VBox status code.
+ * @param   pBackendData Image instance data.
+ * @param   pIoCtx       The I/O context the allocation belongs to.
+ * @param   pvUser       The block allocation.
+ * @param   rcReq        Status code of the completed request.
+ */
+static DECLCALLBACK(int) vhdxBlockAllocUpdate(void *pBackendData, PVDIOCTX pIoCtx, void *pvUser, int rcReq)
+{
+    PVHDXIMAGE pImage = (PVHDXIMAGE)pBackendData;
+    PVHDXBLOCKALLOC pBlockAlloc = (PVHDXBLOCKALLOC)pvUser;
+    int rc = VINF_SUCCESS;
+
+    if (RT_FAILURE(rcReq))
+        return vhdxBlockAllocRollback(pImage, pBlockAlloc, rcReq);
+
+    switch (pBlockAlloc->enmAllocState)
+    {
+        case VHDXBLOCKALLOCSTATE_USER_ALLOC:
+        {
+            /* The data is in place, reads can go to the new block from now on. */
+            pImage->paBat[pBlockAlloc->idxBat].u64BatEntry = VHDX_BAT_ENTRY_CREATE(VHDX_BAT_ENTRY_PAYLOAD_BLOCK_FULLY_PRESENT,
+                                                                                   pBlockAlloc->offBlock);
+            pBlockAlloc->enmAllocState = VHDXBLOCKALLOCSTATE_LOG_WRITE;
+            rc = vhdxLogBatSectorWrite(pImage, pIoCtx, pBlockAlloc, vhdxBlockAllocUpdate);
+            if (rc == VERR_VD_ASYNC_IO_IN_PROGRESS)
+                break;
+            else if (RT_FAILURE(rc))
+            {
+                rc = vhdxBlockAllocRollback(pImage, pBlockAlloc, rc);
+                break;
+            }
+        }
+        RT_FALL_THRU();
+        case VHDXBLOCKALLOCSTATE_LOG_WRITE:
+        {
+            pBlockAlloc->enmAllocState = VHDXBLOCKALLOCSTATE_LOG_FLUSH;
+            rc = vdIfIoIntFileFlush(pImage->pIfIo, pImage->pStorage, pIoCtx,
+                                    vhdxBlockAllocUpdate, pBlockAlloc);
+            if (rc == VERR_VD_ASYNC_IO_IN_PROGRESS)
+                break;
+            else if (RT_FAILURE(rc))
+            {
+                rc = vhdxBlockAllocRollback(pImage, pBlockAlloc, rc);
+                break;
+            }
+        }
+        RT_FALL_THRU();
+        case VHDXBLOCKALLOCSTATE_LOG_FLUSH:
+        {
+            /*
+             * The log entry is durable, write the BAT sector in place. Completion is not
+             * tracked because concurrent updates of the same sector are merged by the
+             * metadata write handling, a crash before it is on the disk is covered by the log.
+             */
+            uint32_t idxBatSector = pBlockAlloc->idxBat / VHDX_BAT_SECTOR_ENTRIES;
+            RTMemFree(pBlockAlloc);
+            rc = vhdxBatSectorWrite(pImage, pIoCtx, idxBatSector);
+            break;
+        }
+        default:
+            AssertMsgFailed(("Invalid async block allocation state %d\n",
+                             pBlockAlloc->enmAllocState));
+    }
+
+    return rc;
+}
+
 
 /** @copydoc VDIMAGEBACKEND::pfnProbe */
 static DECLCALLBACK(int) vhdxProbe(const char *pszFilename, PVDINTERFACE pVDIfsDisk,
@@ -1994,11 +2647,10 @@ static DECLCALLBACK(int) vhdxWrite(void *pBackendData, uint64_t uOffset,  size_t
                                    PVDIOCTX pIoCtx, size_t *pcbWriteProcess, size_t *pcbPreRead,
                                    size_t *pcbPostRead, unsigned fWrite)
 {
-    RT_NOREF5(pIoCtx, pcbWriteProcess, pcbPreRead, pcbPostRead, fWrite);
     LogFlowFunc(("pBackendData=%#p uOffset=%llu pIoCtx=%#p cbToWrite=%zu pcbWriteProcess=%#p pcbPreRead=%#p pcbPostRead=%#p\n",
                  pBackendData, uOffset, pIoCtx, cbToWrite, pcbWriteProcess, pcbPreRead, pcbPostRead));
     PVHDXIMAGE pImage = (PVHDXIMAGE)pBackendData;
-    int rc;
+    int rc = VINF_SUCCESS;
 
     AssertPtr(pImage);
     Assert(uOffset % 512 == 0);
@@ -2010,7 +2662,95 @@ static DECLCALLBACK(int) vhdxWrite(void *pBackendData, uint64_t uOffset,  size_t
              || cbToWrite == 0)
         rc = VERR_INVALID_PARAMETER;
     else
-        rc = VERR_NOT_SUPPORTED;
+    {
+        uint32_t idxBat = (uint32_t)(uOffset / pImage->cbBlock); Assert(idxBat == uOffset / pImage->cbBlock);
+        uint32_t offWrite = uOffset % pImage->cbBlock;
+        uint64_t uBatEntry;
+
+        idxBat += idxBat / pImage->uChunkRatio; /* Add interleaving sector bitmap entries. */
+        uBatEntry = pImage->paBat[idxBat].u64BatEntry;
+
+        cbToWrite = RT_MIN(cbToWrite, pImage->cbBlock - offWrite);
+
+        /* The last block might be only partially covered by the disk. */
+        size_t cbBlockDisk = (size_t)RT_MIN((uint64_t)pImage->cbBlock, pImage->cbSize - (uOffset - offWrite));
+
+        switch (VHDX_BAT_ENTRY_GET_STATE(uBatEntry))
+        {
+            case VHDX_BAT_ENTRY_PAYLOAD_BLOCK_NOT_PRESENT:
+            case VHDX_BAT_ENTRY_PAYLOAD_BLOCK_UNDEFINED:
+            case VHDX_BAT_ENTRY_PAYLOAD_BLOCK_ZERO:
+            case VHDX_BAT_ENTRY_PAYLOAD_BLOCK_UNMAPPED:
+            {
+                /* Unallocated blocks read as zero, writing zeroes to them changes nothing. */
+                if (   !(pImage->uOpenFlags & VD_OPEN_FLAGS_HONOR_ZEROES)
+                    && vdIfIoIntIoCtxIsZero(pImage->pIfIo, pIoCtx, cbToWrite, true))
+                {
+                    *pcbPreRead  = 0;
+                    *pcbPostRead = 0;
+                    break;
+                }
+
+                if (   cbToWrite == cbBlockDisk
+                    && !(fWrite & VD_WRITE_NO_ALLOC))
+                {
+                    /* Full block write to an unallocated block, append a new block to the image. */
+                    Assert(!offWrite);
+                    PVHDXBLOCKALLOC pBlockAlloc = (PVHDXBLOCKALLOC)RTMemAllocZ(sizeof(VHDXBLOCKALLOC));
+                    if (!pBlockAlloc)
+                    {
+                        rc = VERR_NO_MEMORY;
+                        break;
+                    }
+
+                    pBlockAlloc->enmAllocState  = VHDXBLOCKALLOCSTATE_USER_ALLOC;
+                    pBlockAlloc->idxBat         = idxBat;
+                    pBlockAlloc->u64BatEntryOld = uBatEntry;
+                    pBlockAlloc->offBlock       = pImage->offFileNext;
+                    pBlockAlloc->cbWrite        = cbToWrite;
+                    pImage->offFileNext        += pImage->cbBlock;
+
+                    *pcbPreRead  = 0;
+                    *pcbPostRead = 0;
+
+                    rc = vdIfIoIntFileWriteUser(pImage->pIfIo, pImage->pStorage,
+                                                pBlockAlloc->offBlock, pIoCtx, cbToWrite,
+                                                vhdxBlockAllocUpdate, pBlockAlloc);
+                    if (rc == VERR_VD_ASYNC_IO_IN_PROGRESS)
+                        break;
+                    else if (RT_FAILURE(rc))
+                    {
+                        RTMemFree(pBlockAlloc);
+                        break;
+                    }
+
+                    rc = vhdxBlockAllocUpdate(pImage, pIoCtx, pBlockAlloc, rc);
+                }
+                else
+                {
+                    /* Partial write to an unallocated block, let the upper layer read the rest. */
+                    *pcbPreRead  = offWrite;
+                    *pcbPostRead = cbBlockDisk - cbToWrite - offWrite;
+                    rc = VERR_VD_BLOCK_FREE;
+                }
+                break;
+            }
+            case VHDX_BAT_ENTRY_PAYLOAD_BLOCK_FULLY_PRESENT:
+            {
+                uint64_t offFile = VHDX_BAT_ENTRY_GET_FILE_OFFSET(uBatEntry) + offWrite;
+                rc = vdIfIoIntFileWriteUser(pImage->pIfIo, pImage->pStorage, offFile,
+                                            pIoCtx, cbToWrite, NULL, NULL);
+                break;
+            }
+            case VHDX_BAT_ENTRY_PAYLOAD_BLOCK_PARTIALLY_PRESENT:
+            default:
+                rc = VERR_INVALID_PARAMETER;
+                break;
+        }
+
+        if (pcbWriteProcess)
+            *pcbWriteProcess = cbToWrite;
+    }
 
     LogFlowFunc(("returns %Rrc\n", rc));
     return rc;
@@ -2019,7 +2759,6 @@ static DECLCALLBACK(int) vhdxWrite(void *pBackendData, uint64_t uOffset,  size_t
 /** @copydoc VDIMAGEBACKEND::pfnFlush */
 static DECLCALLBACK(int) vhdxFlush(void *pBackendData, PVDIOCTX pIoCtx)
 {
-    RT_NOREF1(pIoCtx);
     LogFlowFunc(("pBackendData=%#p pIoCtx=%#p\n", pBackendData, pIoCtx));
     PVHDXIMAGE pImage = (PVHDXIMAGE)pBackendData;
     int rc;
@@ -2027,7 +2766,7 @@ static DECLCALLBACK(int) vhdxFlush(void *pBackendData, PVDIOCTX pIoCtx)
     if (pImage->uOpenFlags & VD_OPEN_FLAGS_READONLY)
         rc = VERR_VD_IMAGE_READ_ONLY;
     else
-        rc = VERR_NOT_SUPPORTED;
+        rc = vdIfIoIntFileFlush(pImage->pIfIo, pImage->pStorage, pIoCtx, NULL, NULL);
 
     LogFlowFunc(("returns %Rrc\n", rc));
     return rc;
@@ -2238,7 +2977,9 @@ static DECLCALLBACK(int) vhdxSetOpenFlags(void *pBackendData, unsigned uOpenFlag
     int rc = VINF_SUCCESS;
 
     /* Image must be opened and the new flags must be valid. */
-    if (!pImage || (uOpenFlags & ~(VD_OPEN_FLAGS_READONLY | VD_OPEN_FLAGS_INFO | VD_OPEN_FLAGS_SKIP_CONSISTENCY_CHECKS)))
+    if (!pImage || (uOpenFlags & ~(  VD_OPEN_FLAGS_READONLY | VD_OPEN_FLAGS_INFO
+                                   | VD_OPEN_FLAGS_ASYNC_IO | VD_OPEN_FLAGS_SEQUENTIAL
+                                   | VD_OPEN_FLAGS_SKIP_CONSISTENCY_CHECKS)))
         rc = VERR_INVALID_PARAMETER;
     else
     {
@@ -2305,7 +3046,7 @@ const VDIMAGEBACKEND g_VhdxBackend =
     /* pszBackendName */
     "VHDX",
     /* uBackendCaps */
-    VD_CAP_FILE | VD_CAP_VFS,
+    VD_CAP_FILE | VD_CAP_ASYNC | VD_CAP_VFS,
     /* paFileExtensions */
     s_aVhdxFileExtensions,
     /* paConfigInfo */
@@ -57,11 +57,33 @@
 # define VISO_MAX_FILE_SIZE     _8M
 #endif
 
+/** Size of a read cache chunk, must be a power of two. */
+#define VISO_READ_CACHE_CHUNK_SIZE  _64K
+/** Number of chunks in the read cache. */
+#define VISO_READ_CACHE_CHUNKS      16
+
 
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
 
+/**
+ * A read cache chunk.
+ */
+typedef struct VISOREADCACHECHUNK
+{
+    /** Image offset of the chunk, UINT64_MAX if unused. */
+    uint64_t            offChunk;
+    /** Number of valid bytes (less than the chunk size at the end of the image). */
+    size_t              cbValid;
+    /** Value of VISOIMAGE::uReadCacheUse at the last access, for LRU eviction. */
+    uint64_t            uLastUse;
+    /** The chunk data. */
+    uint8_t            *pbData;
+} VISOREADCACHECHUNK;
+/** Pointer to a read cache chunk. */
+typedef VISOREADCACHECHUNK *PVISOREADCACHECHUNK;
+
 /**
  * VBox ISO maker image instance.
  */
@@ -88,6 +110,11 @@ typedef struct VISOIMAGE
     /** Error interface. */
     PVDINTERFACEERROR   pIfError;
 
+    /** The read cache chunks, allocated on the first read. */
+    PVISOREADCACHECHUNK paReadCache;
+    /** Access counter for the read cache LRU. */
+    uint64_t            uReadCacheUse;
+
     /** Internal region list (variable size). */
     VDREGIONLIST        RegionList;
 } VISOIMAGE;
@@ -661,6 +688,83 @@ static int deleteReferences(PVISOIMAGE pThis)
     return vrc;
 }
 
+/**
+ * Frees the read cache.
+ *
+ * @param   pThis       The VISO image instance.
+ */
+static void visoReadCacheDestroy(PVISOIMAGE pThis)
+{
+    if (pThis->paReadCache)
+    {
+        RTMemPageFree(pThis->paReadCache[0].pbData, VISO_READ_CACHE_CHUNKS * VISO_READ_CACHE_CHUNK_SIZE);
+        RTMemFree(pThis->paReadCache);
+        pThis->paReadCache = NULL;
+    }
+}
+
+/**
+ * Returns the read cache chunk containing the given offset, filling it from the
+ * ISO maker on a miss.
+ *
+ * Directory records, path tables and small files are read over and over again
+ * by guests in small pieces, each of them requiring a lookup in the ISO maker
+ * and a read from the host file system otherwise.
+ *
+ * @returns IPRT status code.
+ * @param   pThis       The VISO image instance.
+ * @param   off         The image offset.
+ * @param   ppChunk     Where to return the chunk on success.
+ */
+static int visoReadCacheGetChunk(PVISOIMAGE pThis, uint64_t off, PVISOREADCACHECHUNK *ppChunk)
+{
+    if (!pThis->paReadCache)
+    {
+        PVISOREADCACHECHUNK paReadCache = (PVISOREADCACHECHUNK)RTMemAllocZ(VISO_READ_CACHE_CHUNKS * sizeof(paReadCache[0]));
+        if (!paReadCache)
+            return VERR_NO_MEMORY;
+        uint8_t *pbData = (uint8_t *)RTMemPageAlloc(VISO_READ_CACHE_CHUNKS * VISO_READ_CACHE_CHUNK_SIZE);
+        if (!pbData)
+        {
+            RTMemFree(paReadCache);
+            return VERR_NO_MEMORY;
+        }
+        for (unsigned i = 0; i < VISO_READ_CACHE_CHUNKS; i++)
+        {
+            paReadCache[i].offChunk = UINT64_MAX;
+            paReadCache[i].pbData   = pbData + i * VISO_READ_CACHE_CHUNK_SIZE;
+        }
+        pThis->paReadCache = paReadCache;
+    }
+
+    uint64_t const      offChunk = off & ~(uint64_t)(VISO_READ_CACHE_CHUNK_SIZE - 1);
+    PVISOREADCACHECHUNK pLru     = &pThis->paReadCache[0];
+    for (unsigned i = 0; i < VISO_READ_CACHE_CHUNKS; i++)
+    {
+        PVISOREADCACHECHUNK pChunk = &pThis->paReadCache[i];
+        if (pChunk->offChunk == offChunk)
+        {
+            pChunk->uLastUse = ++pThis->uReadCacheUse;
+            *ppChunk = pChunk;
+            return VINF_SUCCESS;
+        }
+        if (pChunk->uLastUse < pLru->uLastUse)
+            pLru = pChunk;
+    }
+
+    size_t const cbChunk = (size_t)RT_MIN(VISO_READ_CACHE_CHUNK_SIZE, pThis->cbImage - offChunk);
+    pLru->offChunk = UINT64_MAX;
+    int rc = RTVfsFileReadAt(pThis->hIsoFile, offChunk, pLru->pbData, cbChunk, NULL);
+    if (RT_SUCCESS(rc))
+    {
+        pLru->offChunk = offChunk;
+        pLru->cbValid  = cbChunk;
+        pLru->uLastUse = ++pThis->uReadCacheUse;
+        *ppChunk = pLru;
+    }
+    return rc;
+}
+
 /**
  * @interface_method_impl{VDIMAGEBACKEND,pfnClose}
  */
@@ -697,6 +801,7 @@ static DECLCALLBACK(int) visoClose(void *pBackendData, bool fDelete)
             pThis->hIsoFile = NIL_RTVFSFILE;
         }
 
+        visoReadCacheDestroy(pThis);
         RTMemFree(pThis);
     }
 
@@ -730,16 +835,35 @@ static DECLCALLBACK(int) visoRead(void *pBackendData, uint64_t uOffset, size_t c
      */
     int    rc = VINF_SUCCESS;
     size_t cbActuallyRead = 0;
+    bool const fCached = cbToRead < VISO_READ_CACHE_CHUNK_SIZE; /* Large reads (streaming file content) bypass the cache. */
     while (cbToRead > 0)
     {
+        /* Don't cross chunk boundaries when going thru the cache. */
+        size_t cbThisRead = cbToRead;
+        if (fCached)
+            cbThisRead = RT_MIN(cbThisRead, VISO_READ_CACHE_CHUNK_SIZE - (size_t)(off & (VISO_READ_CACHE_CHUNK_SIZE - 1)));
+
         RTSGSEG     Seg;
         unsigned    cSegs = 1;
-        size_t      cbThisRead = vdIfIoIntIoCtxSegArrayCreate(pThis->pIfIo, pIoCtx, &Seg, &cSegs, cbToRead);
+        cbThisRead = vdIfIoIntIoCtxSegArrayCreate(pThis->pIfIo, pIoCtx, &Seg, &cSegs, cbThisRead);
         AssertBreakStmt(cbThisRead != 0, rc = VERR_INTERNAL_ERROR_2);
         Assert(cbThisRead == Seg.cbSeg);
 
-        rc = RTVfsFileReadAt(pThis->hIsoFile, off, Seg.pvSeg, cbThisRead, NULL);
-        AssertRCBreak(rc);
+        if (!fCached)
+        {
+            rc = RTVfsFileReadAt(pThis->hIsoFile, off, Seg.pvSeg, cbThisRead, NULL);
+            AssertRCBreak(rc);
+        }
+        else
+        {
+            PVISOREADCACHECHUNK pChunk = NULL;
+            rc = visoReadCacheGetChunk(pThis, off, &pChunk);
+            AssertRCBreak(rc);
+
+            size_t const offInChunk = (size_t)(off - pChunk->offChunk);
+            Assert(offInChunk + cbThisRead <= pChunk->cbValid);
+            memcpy(Seg.pvSeg, &pChunk->pbData[offInChunk], cbThisRead);
+        }
 
         /* advance. */
         cbActuallyRead += cbThisRead;
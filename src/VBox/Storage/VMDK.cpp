@@ -43,6 +43,8 @@
 #include <iprt/uuid.h>
 #include <iprt/path.h>
 #include <iprt/rand.h>
+#include <iprt/mp.h>
+#include <iprt/req.h>
 #include <iprt/sg.h>
 #include <iprt/sort.h>
 #include <iprt/string.h>
@@ -365,6 +367,9 @@ typedef struct VMDKEXTENT
     void        *pvCompGrain;
     /** Decompressed grain buffer for streamOptimized extents. */
     void        *pvGrain;
+    /** Queue of grains being compressed in parallel, only for newly created
+     * streamOptimized extents. NULL if grains are compressed synchronously. */
+    struct VMDKDEFLATEQUEUE *pDeflateQueue;
     /** Reference to the image in which this extent is used. Do not use this
      * on a regular basis to avoid passing pImage references to functions
      * explicitly. */
@@ -531,6 +536,50 @@ typedef struct VMDKCOMPRESSIO
 } VMDKCOMPRESSIO;
 
 
+/** Maximum number of worker threads compressing grains of one streamOptimized
+ * extent in parallel. */
+#define VMDK_DEFLATE_QUEUE_THREADS_MAX  8
+/** Number of grains queued per compression worker thread, keeping the workers
+ * busy while the oldest grain is being written. */
+#define VMDK_DEFLATE_QUEUE_SLOTS_PER_THREAD 2
+
+/** A grain queued for compression. */
+typedef struct VMDKDEFLATESLOT
+{
+    /** The request compressing this grain, NIL_RTREQ if the slot is free. */
+    PRTREQ      hReq;
+    /** Uncompressed grain data. */
+    void        *pvGrain;
+    /** Compressed grain buffer, with marker. */
+    void        *pvCompGrain;
+    /** Start sector of the grain. */
+    uint64_t    uLBA;
+    /** Grain number. */
+    uint32_t    uGrain;
+    /** Size of the compressed data including marker and padding. */
+    uint32_t    cbMarkerData;
+} VMDKDEFLATESLOT;
+/** Pointer to a queued grain. */
+typedef VMDKDEFLATESLOT *PVMDKDEFLATESLOT;
+
+/** Queue of grains compressed in parallel and written in order. */
+typedef struct VMDKDEFLATEQUEUE
+{
+    /** The worker pool doing the compression. */
+    RTREQPOOL       hReqPool;
+    /** Number of slots. */
+    uint32_t        cSlots;
+    /** Index of the oldest pending slot. */
+    uint32_t        idxHead;
+    /** Number of pending slots. */
+    uint32_t        cPending;
+    /** The slots (variable size). */
+    VMDKDEFLATESLOT aSlots[1];
+} VMDKDEFLATEQUEUE;
+/** Pointer to a grain compression queue. */
+typedef VMDKDEFLATEQUEUE *PVMDKDEFLATEQUEUE;
+
+
 /** Tracks async grain allocation. */
 typedef struct VMDKGRAINALLOCASYNC
 {
@@ -925,22 +974,22 @@ static DECLCALLBACK(int) vmdkFileDeflateHelper(void *pvUser, const void *pvBuf,
 }
 
 /**
- * Internal: deflate the uncompressed data and write to a file,
- * distinguishing between async and normal operation
+ * Internal: deflate the uncompressed data into the given compressed grain
+ * buffer and set up the grain marker. Does not touch any extent state, so
+ * it is safe to call from the compression worker threads.
  */
-DECLINLINE(int) vmdkFileDeflateSync(PVMDKIMAGE pImage, PVMDKEXTENT pExtent,
-                                    uint64_t uOffset, const void *pvBuf,
-                                    size_t cbToWrite, uint64_t uLBA,
-                                    uint32_t *pcbMarkerData)
+static int vmdkDeflateGrain(void *pvCompGrain, size_t cbCompGrain,
+                            const void *pvBuf, size_t cbToWrite,
+                            uint64_t uLBA, uint32_t *pcbMarkerData)
 {
     int rc;
     PRTZIPCOMP pZip = NULL;
     VMDKCOMPRESSIO DeflateState;
 
-    DeflateState.pImage = pImage;
+    DeflateState.pImage = NULL;
     DeflateState.iOffset = -1;
-    DeflateState.cbCompGrain = pExtent->cbCompGrain;
-    DeflateState.pvCompGrain = pExtent->pvCompGrain;
+    DeflateState.cbCompGrain = cbCompGrain;
+    DeflateState.pvCompGrain = pvCompGrain;
 
     rc = RTZipCompCreate(&pZip, &DeflateState, vmdkFileDeflateHelper,
                          RTZIPTYPE_ZLIB, RTZIPLEVEL_DEFAULT);
@@ -960,27 +1009,226 @@ DECLINLINE(int) vmdkFileDeflateSync(PVMDKIMAGE pImage, PVMDKEXTENT pExtent,
         if (uSize % 512)
         {
             uint32_t uSizeAlign = RT_ALIGN(uSize, 512);
-            memset((uint8_t *)pExtent->pvCompGrain + uSize, '\0',
+            memset((uint8_t *)pvCompGrain + uSize, '\0',
                    uSizeAlign - uSize);
             uSize = uSizeAlign;
         }
 
-        if (pcbMarkerData)
-            *pcbMarkerData = uSize;
+        *pcbMarkerData = uSize;
 
         /* Compressed grain marker. Data follows immediately. */
-        VMDKMARKER *pMarker = (VMDKMARKER *)pExtent->pvCompGrain;
+        VMDKMARKER *pMarker = (VMDKMARKER *)pvCompGrain;
         pMarker->uSector = RT_H2LE_U64(uLBA);
         pMarker->cbSize = RT_H2LE_U32(  DeflateState.iOffset
                                       - RT_UOFFSETOF(VMDKMARKER, uType));
+    }
+    return rc;
+}
+
+/**
+ * Internal: deflate the uncompressed data and write to a file,
+ * distinguishing between async and normal operation
+ */
+DECLINLINE(int) vmdkFileDeflateSync(PVMDKIMAGE pImage, PVMDKEXTENT pExtent,
+                                    uint64_t uOffset, const void *pvBuf,
+                                    size_t cbToWrite, uint64_t uLBA,
+                                    uint32_t *pcbMarkerData)
+{
+    uint32_t cbMarkerData = 0;
+    int rc = vmdkDeflateGrain(pExtent->pvCompGrain, pExtent->cbCompGrain,
+                              pvBuf, cbToWrite, uLBA, &cbMarkerData);
+    if (RT_SUCCESS(rc))
+    {
+        rc = vdIfIoIntFileWriteSync(pImage->pIfIo, pExtent->pFile->pStorage,
+                                    uOffset, pExtent->pvCompGrain, cbMarkerData);
+        if (RT_SUCCESS(rc) && pcbMarkerData)
+            *pcbMarkerData = cbMarkerData;
+    }
+    return rc;
+}
+
+/**
+ * Internal: worker compressing a queued grain.
+ */
+static DECLCALLBACK(int) vmdkDeflateQueueWorker(PVMDKDEFLATESLOT pSlot, size_t cbGrain, size_t cbCompGrain)
+{
+    return vmdkDeflateGrain(pSlot->pvCompGrain, cbCompGrain, pSlot->pvGrain,
+                            cbGrain, pSlot->uLBA, &pSlot->cbMarkerData);
+}
+
+/**
+ * Internal: waits for the oldest queued grain to be compressed and writes it
+ * at the current append position, updating the grain table cache.
+ */
+static int vmdkDeflateQueueCommit(PVMDKIMAGE pImage, PVMDKEXTENT pExtent)
+{
+    PVMDKDEFLATEQUEUE pQueue = pExtent->pDeflateQueue;
+    Assert(pQueue->cPending);
+    PVMDKDEFLATESLOT pSlot = &pQueue->aSlots[pQueue->idxHead];
+
+    int rc = RTReqWait(pSlot->hReq, RT_INDEFINITE_WAIT);
+    if (RT_SUCCESS(rc))
+        rc = RTReqGetStatus(pSlot->hReq);
+    RTReqRelease(pSlot->hReq);
+    pSlot->hReq = NIL_RTREQ;
+    pQueue->idxHead = (pQueue->idxHead + 1) % pQueue->cSlots;
+    pQueue->cPending--;
+
+    if (RT_SUCCESS(rc))
+    {
+        uint64_t uFileOffset = pExtent->uAppendPosition;
+        if (!uFileOffset)
+            return VERR_INTERNAL_ERROR;
+        /* Align to sector, as the previous write could have been any size. */
+        uFileOffset = RT_ALIGN_64(uFileOffset, 512);
+
+        uint32_t uCacheLine = pSlot->uGrain % pExtent->cGTEntries / VMDK_GT_CACHELINE_SIZE;
+        uint32_t uCacheEntry = pSlot->uGrain % VMDK_GT_CACHELINE_SIZE;
+        pImage->pGTCache->aGTCache[uCacheLine].aGTData[uCacheEntry] = VMDK_BYTE2SECTOR(uFileOffset);
+
         rc = vdIfIoIntFileWriteSync(pImage->pIfIo, pExtent->pFile->pStorage,
-                                    uOffset, pMarker, uSize);
+                                    uFileOffset, pSlot->pvCompGrain, pSlot->cbMarkerData);
+        if (RT_SUCCESS(rc))
+            pExtent->uAppendPosition += pSlot->cbMarkerData;
+    }
+    if (RT_FAILURE(rc))
+    {
+        AssertRC(rc);
+        rc = vdIfError(pImage->pIfError, rc, RT_SRC_POS, N_("VMDK: cannot write compressed data block in '%s'"), pExtent->pszFullname);
+    }
+    return rc;
+}
+
+/**
+ * Internal: writes all queued grains in order. Keeps going after a failure
+ * so that no compression request is left behind, returns the first error.
+ */
+static int vmdkDeflateQueueDrain(PVMDKIMAGE pImage, PVMDKEXTENT pExtent)
+{
+    int rc = VINF_SUCCESS;
+    PVMDKDEFLATEQUEUE pQueue = pExtent->pDeflateQueue;
+    while (pQueue && pQueue->cPending)
+    {
+        int rc2 = vmdkDeflateQueueCommit(pImage, pExtent);
+        if (RT_SUCCESS(rc))
+            rc = rc2;
+    }
+    return rc;
+}
+
+/**
+ * Internal: queues a grain for compression, writing the oldest queued grain
+ * first if the queue is full.
+ */
+static int vmdkDeflateQueueSubmit(PVMDKIMAGE pImage, PVMDKEXTENT pExtent,
+                                  PVDIOCTX pIoCtx, size_t cbWrite,
+                                  uint64_t uLBA, uint32_t uGrain)
+{
+    PVMDKDEFLATEQUEUE pQueue = pExtent->pDeflateQueue;
+    int rc = VINF_SUCCESS;
+
+    if (pQueue->cPending == pQueue->cSlots)
+    {
+        rc = vmdkDeflateQueueCommit(pImage, pExtent);
         if (RT_FAILURE(rc))
             return rc;
     }
+
+    /* The I/O context buffer is only valid until we return, so always copy. */
+    size_t const cbGrain = VMDK_SECTOR2BYTE(pExtent->cSectorsPerGrain);
+    PVMDKDEFLATESLOT pSlot = &pQueue->aSlots[(pQueue->idxHead + pQueue->cPending) % pQueue->cSlots];
+    vdIfIoIntIoCtxCopyFrom(pImage->pIfIo, pIoCtx, pSlot->pvGrain, cbWrite);
+    if (cbWrite != cbGrain)
+        memset((char *)pSlot->pvGrain + cbWrite, '\0', cbGrain - cbWrite);
+    pSlot->uLBA = uLBA;
+    pSlot->uGrain = uGrain;
+    pSlot->cbMarkerData = 0;
+
+    rc = RTReqPoolCallEx(pQueue->hReqPool, 0 /*cMillies*/, &pSlot->hReq, RTREQFLAGS_IPRT_STATUS,
+                         (PFNRT)vmdkDeflateQueueWorker, 3, pSlot, cbGrain, pExtent->cbCompGrain);
+    if (rc == VERR_TIMEOUT || RT_SUCCESS(rc))
+    {
+        pQueue->cPending++;
+        rc = VINF_SUCCESS;
+    }
+    else
+    {
+        pSlot->hReq = NIL_RTREQ;
+        rc = vdIfError(pImage->pIfError, rc, RT_SRC_POS, N_("VMDK: cannot queue compression of data block in '%s'"), pExtent->pszFullname);
+    }
     return rc;
 }
 
+/**
+ * Internal: sets up parallel grain compression for a newly created
+ * streamOptimized extent. Failing to do so is not fatal, the grains are
+ * compressed synchronously then.
+ */
+static void vmdkDeflateQueueCreate(PVMDKEXTENT pExtent)
+{
+    uint32_t cThreads = RT_MIN(RTMpGetOnlineCount(), VMDK_DEFLATE_QUEUE_THREADS_MAX);
+    if (cThreads < 2)
+        return;
+
+    uint32_t const cSlots = cThreads * VMDK_DEFLATE_QUEUE_SLOTS_PER_THREAD;
+    PVMDKDEFLATEQUEUE pQueue = (PVMDKDEFLATEQUEUE)RTMemAllocZ(RT_UOFFSETOF_DYN(VMDKDEFLATEQUEUE, aSlots[cSlots]));
+    if (!pQueue)
+        return;
+    pQueue->cSlots = cSlots;
+
+    int rc = RTReqPoolCreate(cThreads, RT_MS_1SEC, cThreads, 0 /*cMsMaxPushBack*/, "VMDKZip", &pQueue->hReqPool);
+    for (uint32_t i = 0; i < cSlots && RT_SUCCESS(rc); i++)
+    {
+        pQueue->aSlots[i].hReq = NIL_RTREQ;
+        pQueue->aSlots[i].pvGrain = RTMemAlloc(VMDK_SECTOR2BYTE(pExtent->cSectorsPerGrain));
+        pQueue->aSlots[i].pvCompGrain = RTMemAlloc(pExtent->cbCompGrain);
+        if (!pQueue->aSlots[i].pvGrain || !pQueue->aSlots[i].pvCompGrain)
+            rc = VERR_NO_MEMORY;
+    }
+    if (RT_SUCCESS(rc))
+        pExtent->pDeflateQueue = pQueue;
+    else
+    {
+        for (uint32_t i = 0; i < cSlots; i++)
+        {
+            RTMemFree(pQueue->aSlots[i].pvGrain);
+            RTMemFree(pQueue->aSlots[i].pvCompGrain);
+        }
+        RTReqPoolRelease(pQueue->hReqPool);
+        RTMemFree(pQueue);
+        LogRel(("VMDK: Compressing grains synchronously, failed to set up parallel compression (%Rrc)\n", rc));
+    }
+}
+
+/**
+ * Internal: destroys the grain compression queue, discarding all grains
+ * which were not written yet.
+ */
+static void vmdkDeflateQueueDestroy(PVMDKEXTENT pExtent)
+{
+    PVMDKDEFLATEQUEUE pQueue = pExtent->pDeflateQueue;
+    if (!pQueue)
+        return;
+
+    while (pQueue->cPending)
+    {
+        PVMDKDEFLATESLOT pSlot = &pQueue->aSlots[pQueue->idxHead];
+        RTReqWait(pSlot->hReq, RT_INDEFINITE_WAIT);
+        RTReqRelease(pSlot->hReq);
+        pSlot->hReq = NIL_RTREQ;
+        pQueue->idxHead = (pQueue->idxHead + 1) % pQueue->cSlots;
+        pQueue->cPending--;
+    }
+    for (uint32_t i = 0; i < pQueue->cSlots; i++)
+    {
+        RTMemFree(pQueue->aSlots[i].pvGrain);
+        RTMemFree(pQueue->aSlots[i].pvCompGrain);
+    }
+    RTReqPoolRelease(pQueue->hReqPool);
+    RTMemFree(pQueue);
+    pExtent->pDeflateQueue = NULL;
+}
+
 
 /**
  * Internal: check if all files are closed, prevent leaking resources.
@@ -1459,6 +1707,8 @@ static int vmdkCreateGrainDirectory(PVMDKIMAGE pImage, PVMDKEXTENT pExtent,
         rc = vmdkAllocStreamBuffers(pImage, pExtent);
         if (RT_SUCCESS(rc))
         {
+            if (pImage->uImageFlags & VD_VMDK_IMAGE_FLAGS_STREAM_OPTIMIZED)
+                vmdkDeflateQueueCreate(pExtent);
             rc = vmdkAllocGrainDirectory(pImage, pExtent);
             if (   RT_SUCCESS(rc)
                 && fPreAlloc)
@@ -3035,6 +3285,7 @@ static int vmdkWriteMetaSparseExtent(PVMDKIMAGE pImage, PVMDKEXTENT pExtent,
  */
 static void vmdkFreeStreamBuffers(PVMDKEXTENT pExtent)
 {
+    vmdkDeflateQueueDestroy(pExtent);
     if (pExtent->pvCompGrain)
     {
         RTMemFree(pExtent->pvCompGrain);
@@ -6137,6 +6388,8 @@ static int vmdkFreeImage(PVMDKIMAGE pImage, bool fDelete, bool fFlush)
                 && pImage->pExtents[0].uAppendPosition)
             {
                 PVMDKEXTENT pExtent = &pImage->pExtents[0];
+                rc = vmdkDeflateQueueDrain(pImage, pExtent);
+                AssertRC(rc);
                 uint32_t uLastGDEntry = pExtent->uLastGrainAccess / pExtent->cGTEntries;
                 rc = vmdkStreamFlushGT(pImage, pExtent, uLastGDEntry);
                 AssertRC(rc);
@@ -6260,6 +6513,9 @@ static int vmdkFlushImage(PVMDKIMAGE pImage, PVDIOCTX pIoCtx)
         for (unsigned i = 0; i < pImage->cExtents; i++)
         {
             pExtent = &pImage->pExtents[i];
+            rc = vmdkDeflateQueueDrain(pImage, pExtent);
+            if (RT_FAILURE(rc))
+                break;
             if (pExtent->pFile != NULL && pExtent->fMetaDirty)
             {
                 switch (pExtent->enmType)
@@ -6474,6 +6730,10 @@ static int vmdkStreamAllocGrain(PVMDKIMAGE pImage, PVMDKEXTENT pExtent,
 
     if (uGDEntry != uLastGDEntry)
     {
+        /* The grain table can only be written once all its grains are. */
+        rc = vmdkDeflateQueueDrain(pImage, pExtent);
+        if (RT_FAILURE(rc))
+            return rc;
         rc = vmdkStreamFlushGT(pImage, pExtent, uLastGDEntry);
         if (RT_FAILURE(rc))
             return rc;
@@ -6486,6 +6746,27 @@ static int vmdkStreamAllocGrain(PVMDKIMAGE pImage, PVMDKEXTENT pExtent,
         }
     }
 
+    PVMDKDEFLATEQUEUE pQueue = pExtent->pDeflateQueue;
+    if (pQueue)
+    {
+        /* Paranoia check as below, the grain must not have been written
+         * already, which for queued grains means it is not the last one. */
+        if (   pExtent->enmType != VMDKETYPE_HOSTED_SPARSE
+            || !pImage->pGTCache
+            || pExtent->cGTEntries > VMDK_GT_CACHE_SIZE * VMDK_GT_CACHELINE_SIZE
+            || pImage->pGTCache->aGTCache[uCacheLine].aGTData[uCacheEntry]
+            || (   pQueue->cPending
+                && pQueue->aSlots[(pQueue->idxHead + pQueue->cPending - 1) % pQueue->cSlots].uGrain == uGrain))
+            return VERR_INTERNAL_ERROR;
+        if (!pExtent->uAppendPosition)
+            return VERR_INTERNAL_ERROR;
+
+        rc = vmdkDeflateQueueSubmit(pImage, pExtent, pIoCtx, cbWrite, uSector, uGrain);
+        if (RT_SUCCESS(rc))
+            pExtent->uLastGrainAccess = uGrain;
+        return rc;
+    }
+
     uint64_t uFileOffset;
     uFileOffset = pExtent->uAppendPosition;
     if (!uFileOffset)
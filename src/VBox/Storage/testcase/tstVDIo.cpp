@@ -45,6 +45,9 @@
 #include <iprt/test.h>
 #include <iprt/system.h>
 #include <iprt/tracelog.h>
+#include <iprt/path.h>
+#include <iprt/sort.h>
+#include <iprt/time.h>
 
 #include "VDMemDisk.h"
 #include "VDIoBackend.h"
@@ -117,6 +120,20 @@ typedef struct VDDISK
     VDGEOMETRY     LogicalGeom;
     /** Global test data. */
     PVDTESTGLOB    pTestGlob;
+    /** Backend of the last image created or opened, for reporting. */
+    char          *pszBackend;
+    /** Config interface for the crypt filter. */
+    VDINTERFACECONFIG VDIfCfgCrypt;
+    /** Crypto interface for the crypt filter. */
+    VDINTERFACECRYPTO VDIfCrypto;
+    /** Interface list for the crypt filter, NULL if no filter was added. */
+    PVDINTERFACE   pIfsCrypt;
+    /** The crypt filter algorithm. */
+    char          *pszCryptAlgorithm;
+    /** Size of the crypt filter key. */
+    size_t         cbCryptKey;
+    /** The random crypt filter key. */
+    uint8_t        abCryptKey[64];
 } VDDISK, *PVDDISK;
 
 /**
@@ -191,6 +208,10 @@ typedef struct TSTVDIOREQ
     RTSGBUF          SgBuf;
     /** Flag whether the request is outstanding or not. */
     volatile bool    fOutstanding;
+    /** Timestamp the request was submitted at. */
+    uint64_t         tsStart;
+    /** The I/O test the request belongs to. */
+    struct VDIOTEST  *pIoTest;
     /** Buffer to use for reads. */
     void             *pvBufRead;
     /** Contiguous buffer pointer backing the segments. */
@@ -226,6 +247,12 @@ typedef struct VDIOTEST
     PVDIORND    pIoRnd;
     /** Pointer to the data pattern to use. */
     PVDPATTERN  pPattern;
+    /** Latency of each completed request in nanoseconds. */
+    uint64_t   *pacNsLatency;
+    /** Number of entries in the latency array. */
+    uint32_t    cLatenciesMax;
+    /** Number of latencies recorded. */
+    volatile uint32_t cLatencies;
     /** Data dependent on the I/O mode (sequential or random). */
     union
     {
@@ -244,6 +271,14 @@ typedef struct VDIOTEST
     } u;
 } VDIOTEST, *PVDIOTEST;
 
+
+/** Stream to write the JSON records of the I/O tests to, NULL if not requested. */
+static PRTSTREAM    g_pStrmJson     = NULL;
+/** Number of JSON records written so far. */
+static uint32_t     g_cJsonRecords  = 0;
+/** Name of the test currently executing, for the JSON records. */
+static const char  *g_pszJsonTest   = NULL;
+
 static DECLCALLBACK(int) vdScriptHandlerCreate(PVDSCRIPTARG paScriptArgs, void *pvUser);
 static DECLCALLBACK(int) vdScriptHandlerOpen(PVDSCRIPTARG paScriptArgs, void *pvUser);
 static DECLCALLBACK(int) vdScriptHandlerIo(PVDSCRIPTARG paScriptArgs, void *pvUser);
@@ -272,6 +307,7 @@ static DECLCALLBACK(int) vdScriptHandlerResize(PVDSCRIPTARG paScriptArgs, void *
 static DECLCALLBACK(int) vdScriptHandlerSetFileBackend(PVDSCRIPTARG paScriptArgs, void *pvUser);
 static DECLCALLBACK(int) vdScriptHandlerLoadPlugin(PVDSCRIPTARG paScriptArgs, void *pvUser);
 static DECLCALLBACK(int) vdScriptHandlerIoLogReplay(PVDSCRIPTARG paScriptArgs, void *pvUser);
+static DECLCALLBACK(int) vdScriptHandlerCryptFilterAdd(PVDSCRIPTARG paScriptArgs, void *pvUser);
 
 /* create action */
 const VDSCRIPTTYPE g_aArgCreate[] =
@@ -486,6 +522,13 @@ const VDSCRIPTTYPE g_aArgLoadPlugin[] =
     VDSCRIPTTYPE_STRING /* plugin name */
 };
 
+/* Add the crypt filter with a random key. */
+const VDSCRIPTTYPE g_aArgCryptFilterAdd[] =
+{
+    VDSCRIPTTYPE_STRING, /* disk */
+    VDSCRIPTTYPE_STRING  /* algorithm */
+};
+
 const VDSCRIPTCALLBACK g_aScriptActions[] =
 {
     /* pcszFnName                  enmTypeReturn      paArgDesc                          cArgDescs                                      pfnHandler */
@@ -516,7 +559,8 @@ const VDSCRIPTCALLBACK g_aScriptActions[] =
     {"resetstatistics",            VDSCRIPTTYPE_VOID, g_aArgResetStatistics,             RT_ELEMENTS(g_aArgResetStatistics),            vdScriptHandlerResetStatistics},
     {"resize",                     VDSCRIPTTYPE_VOID, g_aArgResize,                      RT_ELEMENTS(g_aArgResize),                     vdScriptHandlerResize},
     {"setfilebackend",             VDSCRIPTTYPE_VOID, g_aArgSetFileBackend,              RT_ELEMENTS(g_aArgSetFileBackend),             vdScriptHandlerSetFileBackend},
-    {"loadplugin",                 VDSCRIPTTYPE_VOID, g_aArgLoadPlugin,                  RT_ELEMENTS(g_aArgLoadPlugin),                 vdScriptHandlerLoadPlugin}
+    {"loadplugin",                 VDSCRIPTTYPE_VOID, g_aArgLoadPlugin,                  RT_ELEMENTS(g_aArgLoadPlugin),                 vdScriptHandlerLoadPlugin},
+    {"cryptfilteradd",             VDSCRIPTTYPE_VOID, g_aArgCryptFilterAdd,              RT_ELEMENTS(g_aArgCryptFilterAdd),             vdScriptHandlerCryptFilterAdd}
 };
 
 const unsigned g_cScriptActions = RT_ELEMENTS(g_aScriptActions);
@@ -552,10 +596,13 @@ static int tstVDIoTestInit(PVDIOTEST pIoTest, PVDTESTGLOB pGlob, bool fRandomAcc
 static bool tstVDIoTestRunning(PVDIOTEST pIoTest);
 static void tstVDIoTestDestroy(PVDIOTEST pIoTest);
 static bool tstVDIoTestReqOutstanding(PTSTVDIOREQ pIoReq);
+static void tstVDIoTestReqRecordLatency(PTSTVDIOREQ pIoReq);
 static int  tstVDIoTestReqInit(PVDIOTEST pIoTest, PTSTVDIOREQ pIoReq, void *pvUser);
 static DECLCALLBACK(void) tstVDIoTestReqComplete(void *pvUser1, void *pvUser2, int rcReq);
 
 static PVDDISK tstVDIoGetDiskByName(PVDTESTGLOB pGlob, const char *pcszDisk);
+static int tstVDIoDiskSetBackend(PVDDISK pDisk, const char *pcszBackend);
+static void tstVDIoDiskFree(PVDDISK pDisk);
 static PVDPATTERN tstVDIoGetPatternByName(PVDTESTGLOB pGlob, const char *pcszName);
 static PVDPATTERN tstVDIoPatternCreate(const char *pcszName, size_t cbPattern);
 static int tstVDIoPatternGetBuffer(PVDPATTERN pPattern, void **ppv, size_t cb);
@@ -628,6 +675,8 @@ static DECLCALLBACK(int) vdScriptHandlerCreate(PVDSCRIPTARG paScriptArgs, void *
             else
                 rc = VDCreateDiff(pDisk->pVD, pcszBackend, pcszImage, fImageFlags, NULL, NULL, NULL,
                                   fOpenFlags, pGlob->pInterfacesImages, NULL);
+            if (RT_SUCCESS(rc))
+                rc = tstVDIoDiskSetBackend(pDisk, pcszBackend);
         }
         else
             rc = VERR_NOT_FOUND;
@@ -673,6 +722,8 @@ static DECLCALLBACK(int) vdScriptHandlerOpen(PVDSCRIPTARG paScriptArgs, void *pv
                 fOpenFlags |= VD_OPEN_FLAGS_HONOR_SAME;
 
             rc = VDOpen(pDisk->pVD, pcszBackend, pcszImage, fOpenFlags, pGlob->pInterfacesImages);
+            if (RT_SUCCESS(rc))
+                rc = tstVDIoDiskSetBackend(pDisk, pcszBackend);
         }
         else
             rc = VERR_NOT_FOUND;
@@ -715,6 +766,76 @@ static uint64_t tstVDIoGetSpeedKBs(uint64_t cbIo, uint64_t tsNano)
     return uSpeedKBs;
 }
 
+/**
+ * @callback_method_impl{FNRTSORTCMP, Sorts latency samples ascending.}
+ */
+static DECLCALLBACK(int) tstVDIoLatencyCmp(void const *pvElement1, void const *pvElement2, void *pvUser)
+{
+    RT_NOREF(pvUser);
+    uint64_t const cNs1 = *(uint64_t const *)pvElement1;
+    uint64_t const cNs2 = *(uint64_t const *)pvElement2;
+    return cNs1 < cNs2 ? -1 : cNs1 > cNs2 ? 1 : 0;
+}
+
+/**
+ * Returns the given latency percentile (nearest rank) from sorted samples.
+ *
+ * @returns Latency in nanoseconds.
+ * @param   pacNsSorted   The sorted latency samples.
+ * @param   cSamples      Number of samples, must not be 0.
+ * @param   uPerMille     The percentile in per mille (500 for p50, 999 for p99.9).
+ */
+static uint64_t tstVDIoLatencyPercentile(uint64_t const *pacNsSorted, uint32_t cSamples, uint32_t uPerMille)
+{
+    uint64_t idx = ((uint64_t)cSamples * uPerMille + 999) / 1000;
+    return pacNsSorted[idx ? idx - 1 : 0];
+}
+
+/**
+ * Reports IOPS and latency percentiles of a finished I/O test, both as test
+ * values and as a JSON record if requested on the command line.
+ *
+ * @param   pGlob         Global test state.
+ * @param   pDisk         The disk the test ran against.
+ * @param   pIoTest       The finished I/O test.
+ * @param   fAsync        Whether the async I/O path was used.
+ * @param   cQueueDepth   Maximum number of outstanding requests.
+ * @param   cbIo          Number of bytes transferred.
+ * @param   cNsElapsed    Time the test took in nanoseconds.
+ * @param   cKBsSpeed     Throughput in KB/s.
+ */
+static void tstVDIoTestReport(PVDTESTGLOB pGlob, PVDDISK pDisk, PVDIOTEST pIoTest, bool fAsync, unsigned cQueueDepth,
+                              uint64_t cbIo, uint64_t cNsElapsed, uint64_t cKBsSpeed)
+{
+    uint32_t const cSamples = RT_MIN(pIoTest->cLatencies, pIoTest->cLatenciesMax);
+    if (!cSamples)
+        return;
+
+    uint64_t const cIops = cNsElapsed ? (uint64_t)cSamples * RT_NS_1SEC / cNsElapsed : 0;
+    RTSortShell(pIoTest->pacNsLatency, cSamples, sizeof(uint64_t), tstVDIoLatencyCmp, NULL);
+    uint64_t const cNsP50  = tstVDIoLatencyPercentile(pIoTest->pacNsLatency, cSamples, 500);
+    uint64_t const cNsP99  = tstVDIoLatencyPercentile(pIoTest->pacNsLatency, cSamples, 990);
+    uint64_t const cNsP999 = tstVDIoLatencyPercentile(pIoTest->pacNsLatency, cSamples, 999);
+
+    RTTestValue(pGlob->hTest, "IOPS", cIops, RTTESTUNIT_OCCURRENCES_PER_SEC);
+    RTTestValue(pGlob->hTest, "Latency p50", cNsP50, RTTESTUNIT_NS);
+    RTTestValue(pGlob->hTest, "Latency p99", cNsP99, RTTESTUNIT_NS);
+    RTTestValue(pGlob->hTest, "Latency p99.9", cNsP999, RTTESTUNIT_NS);
+
+    if (g_pStrmJson)
+        RTStrmPrintf(g_pStrmJson,
+                     "%s  { \"test\": %RMjs, \"backend\": %RMjs, \"crypt\": %RTbool, \"mode\": \"%s\", \"async\": %RTbool,\n"
+                     "    \"blockSize\": %zu, \"queueDepth\": %u, \"writePercent\": %u, \"bytes\": %RU64, \"requests\": %RU32,\n"
+                     "    \"elapsedNs\": %RU64, \"iops\": %RU64, \"throughputKBs\": %RU64,\n"
+                     "    \"latencyNs\": { \"min\": %RU64, \"p50\": %RU64, \"p99\": %RU64, \"p999\": %RU64, \"max\": %RU64 } }",
+                     g_cJsonRecords++ ? ",\n" : "", g_pszJsonTest ? g_pszJsonTest : "",
+                     pDisk->pszBackend ? pDisk->pszBackend : "",
+                     pDisk->pszCryptAlgorithm != NULL, pIoTest->fRandomAccess ? "rnd" : "seq", fAsync,
+                     pIoTest->cbBlkIo, cQueueDepth, pIoTest->uWriteChance, cbIo, cSamples,
+                     cNsElapsed, cIops, cKBsSpeed,
+                     pIoTest->pacNsLatency[0], cNsP50, cNsP99, cNsP999, pIoTest->pacNsLatency[cSamples - 1]);
+}
+
 static DECLCALLBACK(int) vdScriptHandlerIo(PVDSCRIPTARG paScriptArgs, void *pvUser)
 {
     int rc = VINF_SUCCESS;
@@ -823,6 +944,7 @@ static DECLCALLBACK(int) vdScriptHandlerIo(PVDSCRIPTARG paScriptArgs, void *pvUs
 
                             if (RT_SUCCESS(rc))
                             {
+                                paIoReq[idx].tsStart = RTTimeNanoTS();
                                 if (!fAsync)
                                 {
                                     switch (paIoReq[idx].enmTxDir)
@@ -867,6 +989,8 @@ static DECLCALLBACK(int) vdScriptHandlerIo(PVDSCRIPTARG paScriptArgs, void *pvUs
                                             AssertMsgFailed(("Invalid\n"));
                                     }
 
+                                    if (RT_SUCCESS(rc))
+                                        tstVDIoTestReqRecordLatency(&paIoReq[idx]);
                                     ASMAtomicXchgBool(&paIoReq[idx].fOutstanding, false);
                                     if (RT_SUCCESS(rc))
                                         idx++;
@@ -944,6 +1068,7 @@ static DECLCALLBACK(int) vdScriptHandlerIo(PVDSCRIPTARG paScriptArgs, void *pvUs
                                                 AssertMsgFailed(("Invalid\n"));
                                         }
 
+                                        tstVDIoTestReqRecordLatency(&paIoReq[idx]);
                                         ASMAtomicXchgBool(&paIoReq[idx].fOutstanding, false);
                                         if (rc != VERR_INVALID_STATE)
                                             rc = VINF_SUCCESS;
@@ -993,6 +1118,7 @@ static DECLCALLBACK(int) vdScriptHandlerIo(PVDSCRIPTARG paScriptArgs, void *pvUs
                 NanoTS = RTTimeNanoTS() - NanoTS;
                 uint64_t SpeedKBs = tstVDIoGetSpeedKBs(cbIo, NanoTS);
                 RTTestValue(pGlob->hTest, "Throughput", SpeedKBs, RTTESTUNIT_KILOBYTES_PER_SEC);
+                tstVDIoTestReport(pGlob, pDisk, &IoTest, fAsync, cMaxTasksOutstanding, cbIo, NanoTS, SpeedKBs);
 
                 for (unsigned i = 0; i < cMaxTasksOutstanding; i++)
                 {
@@ -1857,14 +1983,7 @@ static DECLCALLBACK(int) vdScriptHandlerDestroyDisk(PVDSCRIPTARG paScriptArgs, v
     if (pDisk)
     {
         RTListNodeRemove(&pDisk->ListNode);
-        VDDestroy(pDisk->pVD);
-        if (pDisk->pMemDiskVerify)
-        {
-            VDMemDiskDestroy(pDisk->pMemDiskVerify);
-            RTCritSectDelete(&pDisk->CritSectVerify);
-        }
-        RTStrFree(pDisk->pszName);
-        RTMemFree(pDisk);
+        tstVDIoDiskFree(pDisk);
     }
     else
         rc = VERR_NOT_FOUND;
@@ -2083,6 +2202,153 @@ static DECLCALLBACK(int) vdScriptHandlerLoadPlugin(PVDSCRIPTARG paScriptArgs, vo
     return VDPluginLoadFromFilename(pcszPlugin);
 }
 
+/**
+ * @interface_method_impl{VDINTERFACECONFIG,pfnAreKeysValid, Crypt filter config.}
+ */
+static DECLCALLBACK(bool) tstVDIoCryptCfgAreKeysValid(void *pvUser, const char *pszzValid)
+{
+    RT_NOREF(pvUser, pszzValid);
+    return true;
+}
+
+/**
+ * Returns the value of the given crypt filter config key.
+ */
+static const char *tstVDIoCryptCfgGetValue(PVDDISK pDisk, const char *pszName)
+{
+    if (!RTStrCmp(pszName, "Algorithm"))
+        return pDisk->pszCryptAlgorithm;
+    if (!RTStrCmp(pszName, "KeyId"))
+        return "tstVDIo";
+    return NULL;
+}
+
+/**
+ * @interface_method_impl{VDINTERFACECONFIG,pfnQuerySize, Crypt filter config.}
+ */
+static DECLCALLBACK(int) tstVDIoCryptCfgQuerySize(void *pvUser, const char *pszName, size_t *pcbValue)
+{
+    const char *pszValue = tstVDIoCryptCfgGetValue((PVDDISK)pvUser, pszName);
+    if (!pszValue)
+        return VERR_CFGM_VALUE_NOT_FOUND;
+
+    *pcbValue = strlen(pszValue) + 1;
+    return VINF_SUCCESS;
+}
+
+/**
+ * @interface_method_impl{VDINTERFACECONFIG,pfnQuery, Crypt filter config.}
+ */
+static DECLCALLBACK(int) tstVDIoCryptCfgQuery(void *pvUser, const char *pszName, char *pszValue, size_t cchValue)
+{
+    const char *pszSrc = tstVDIoCryptCfgGetValue((PVDDISK)pvUser, pszName);
+    if (!pszSrc)
+        return VERR_CFGM_VALUE_NOT_FOUND;
+
+    int rc = RTStrCopy(pszValue, cchValue, pszSrc);
+    return RT_SUCCESS(rc) ? VINF_SUCCESS : VERR_CFGM_NOT_ENOUGH_SPACE;
+}
+
+/**
+ * @interface_method_impl{VDINTERFACECRYPTO,pfnKeyRetain}
+ */
+static DECLCALLBACK(int) tstVDIoCryptKeyRetain(void *pvUser, const char *pszId, const uint8_t **ppbKey, size_t *pcbKey)
+{
+    RT_NOREF(pszId);
+    PVDDISK pDisk = (PVDDISK)pvUser;
+
+    *ppbKey = &pDisk->abCryptKey[0];
+    *pcbKey = pDisk->cbCryptKey;
+    return VINF_SUCCESS;
+}
+
+/**
+ * @interface_method_impl{VDINTERFACECRYPTO,pfnKeyRelease}
+ */
+static DECLCALLBACK(int) tstVDIoCryptKeyRelease(void *pvUser, const char *pszId)
+{
+    RT_NOREF(pvUser, pszId);
+    return VINF_SUCCESS;
+}
+
+/**
+ * @interface_method_impl{VDINTERFACECRYPTO,pfnKeyStorePasswordRetain}
+ */
+static DECLCALLBACK(int) tstVDIoCryptKeyStorePasswordRetain(void *pvUser, const char *pszId, const char **ppszPassword)
+{
+    RT_NOREF(pvUser, pszId, ppszPassword);
+    return VERR_NOT_SUPPORTED;
+}
+
+/**
+ * @interface_method_impl{VDINTERFACECRYPTO,pfnKeyStorePasswordRelease}
+ */
+static DECLCALLBACK(int) tstVDIoCryptKeyStorePasswordRelease(void *pvUser, const char *pszId)
+{
+    RT_NOREF(pvUser, pszId);
+    return VERR_NOT_SUPPORTED;
+}
+
+static DECLCALLBACK(int) vdScriptHandlerCryptFilterAdd(PVDSCRIPTARG paScriptArgs, void *pvUser)
+{
+    PVDTESTGLOB pGlob = (PVDTESTGLOB)pvUser;
+    const char *pcszDisk = paScriptArgs[0].psz;
+    const char *pcszAlgorithm = paScriptArgs[1].psz;
+
+    PVDDISK pDisk = tstVDIoGetDiskByName(pGlob, pcszDisk);
+    if (!pDisk)
+        return VERR_NOT_FOUND;
+    if (pDisk->pIfsCrypt)
+        return VERR_ALREADY_EXISTS;
+
+    /* The key is supplied directly through pfnKeyRetain, so only its size is needed here. */
+    size_t cbKey;
+    if (!RTStrCmp(pcszAlgorithm, "AES-XTS256-PLAIN64"))
+        cbKey = 64;
+    else if (!RTStrCmp(pcszAlgorithm, "AES-XTS128-PLAIN64"))
+        cbKey = 32;
+    else if (!RTStrCmp(pcszAlgorithm, "XOR"))
+        cbKey = 16;
+    else
+    {
+        RTPrintf("Invalid crypt algorithm '%s'\n", pcszAlgorithm);
+        return VERR_INVALID_PARAMETER;
+    }
+
+    pDisk->pszCryptAlgorithm = RTStrDup(pcszAlgorithm);
+    if (!pDisk->pszCryptAlgorithm)
+        return VERR_NO_MEMORY;
+    pDisk->cbCryptKey = cbKey;
+    RTRandBytes(&pDisk->abCryptKey[0], cbKey);
+
+    pDisk->VDIfCfgCrypt.pfnAreKeysValid = tstVDIoCryptCfgAreKeysValid;
+    pDisk->VDIfCfgCrypt.pfnQuerySize    = tstVDIoCryptCfgQuerySize;
+    pDisk->VDIfCfgCrypt.pfnQuery        = tstVDIoCryptCfgQuery;
+    pDisk->VDIfCfgCrypt.pfnQueryBytes   = NULL;
+    int rc = VDInterfaceAdd(&pDisk->VDIfCfgCrypt.Core, "tstVDIo_CryptConfig", VDINTERFACETYPE_CONFIG,
+                            pDisk, sizeof(VDINTERFACECONFIG), &pDisk->pIfsCrypt);
+    AssertRC(rc);
+
+    pDisk->VDIfCrypto.pfnKeyRetain                = tstVDIoCryptKeyRetain;
+    pDisk->VDIfCrypto.pfnKeyRelease               = tstVDIoCryptKeyRelease;
+    pDisk->VDIfCrypto.pfnKeyStorePasswordRetain   = tstVDIoCryptKeyStorePasswordRetain;
+    pDisk->VDIfCrypto.pfnKeyStorePasswordRelease  = tstVDIoCryptKeyStorePasswordRelease;
+    rc = VDInterfaceAdd(&pDisk->VDIfCrypto.Core, "tstVDIo_Crypto", VDINTERFACETYPE_CRYPTO,
+                        pDisk, sizeof(VDINTERFACECRYPTO), &pDisk->pIfsCrypt);
+    AssertRC(rc);
+
+    rc = VDFilterAdd(pDisk->pVD, "CRYPT", VD_FILTER_FLAGS_DEFAULT, pDisk->pIfsCrypt);
+    if (RT_FAILURE(rc))
+    {
+        RTPrintf("Adding the crypt filter failed rc=%Rrc\n", rc);
+        RTStrFree(pDisk->pszCryptAlgorithm);
+        pDisk->pszCryptAlgorithm = NULL;
+        pDisk->pIfsCrypt = NULL;
+    }
+
+    return rc;
+}
+
 static DECLCALLBACK(int) tstVDIoFileOpen(void *pvUser, const char *pszLocation,
                                          uint32_t fOpen,
                                          PFNVDCOMPLETED pfnCompleted,
@@ -2436,6 +2702,15 @@ static int tstVDIoTestInit(PVDIOTEST pIoTest, PVDTESTGLOB pGlob, bool fRandomAcc
     pIoTest->pIoRnd        = pGlob->pIoRnd;
     pIoTest->pPattern      = pPattern;
 
+    /* One latency sample per request. */
+    if (!cbBlkSize)
+        return VERR_INVALID_PARAMETER;
+    uint64_t cReqs = cbIo / cbBlkSize + (cbIo % cbBlkSize ? 1 : 0);
+    pIoTest->cLatenciesMax = (uint32_t)RT_MIN(cReqs, _64M);
+    pIoTest->pacNsLatency  = (uint64_t *)RTMemAlloc(pIoTest->cLatenciesMax * sizeof(uint64_t));
+    if (!pIoTest->pacNsLatency)
+        return VERR_NO_MEMORY;
+
     if (fRandomAcc)
     {
         uint64_t cbRange = pIoTest->offEnd < pIoTest->offStart
@@ -2449,7 +2724,11 @@ static int tstVDIoTestInit(PVDIOTEST pIoTest, PVDTESTGLOB pGlob, bool fRandomAcc
                                                                 ? 1
                                                                 : 0));
         if (!pIoTest->u.Rnd.pbMapAccessed)
+        {
+            RTMemFree(pIoTest->pacNsLatency);
+            pIoTest->pacNsLatency = NULL;
             rc = VERR_NO_MEMORY;
+        }
     }
     else
         pIoTest->u.offNext = pIoTest->offEnd < pIoTest->offStart ? pIoTest->offStart - cbBlkSize : offStart;
@@ -2461,6 +2740,7 @@ static void tstVDIoTestDestroy(PVDIOTEST pIoTest)
 {
     if (pIoTest->fRandomAccess)
         RTMemFree(pIoTest->u.Rnd.pbMapAccessed);
+    RTMemFree(pIoTest->pacNsLatency);
 }
 
 static bool tstVDIoTestRunning(PVDIOTEST pIoTest)
@@ -2605,6 +2885,7 @@ static int tstVDIoTestReqInit(PVDIOTEST pIoTest, PTSTVDIOREQ pIoReq, void *pvUse
                 }
             }
             pIoReq->pvUser = pvUser;
+            pIoReq->pIoTest = pIoTest;
             pIoReq->fOutstanding = true;
         }
     }
@@ -2614,6 +2895,20 @@ static int tstVDIoTestReqInit(PVDIOTEST pIoTest, PTSTVDIOREQ pIoReq, void *pvUse
     return rc;
 }
 
+/**
+ * Records the latency of the given request which just completed.
+ *
+ * @param pIoReq    The completed request.
+ */
+static void tstVDIoTestReqRecordLatency(PTSTVDIOREQ pIoReq)
+{
+    PVDIOTEST pIoTest = pIoReq->pIoTest;
+    uint64_t const cNsLatency = RTTimeNanoTS() - pIoReq->tsStart;
+    uint32_t const idx = ASMAtomicIncU32(&pIoTest->cLatencies) - 1;
+    if (idx < pIoTest->cLatenciesMax)
+        pIoTest->pacNsLatency[idx] = cNsLatency;
+}
+
 static DECLCALLBACK(void) tstVDIoTestReqComplete(void *pvUser1, void *pvUser2, int rcReq)
 {
     RT_NOREF1(rcReq);
@@ -2665,6 +2960,7 @@ static DECLCALLBACK(void) tstVDIoTestReqComplete(void *pvUser1, void *pvUser2, i
         }
     }
 
+    tstVDIoTestReqRecordLatency(pIoReq);
     ASMAtomicXchgBool(&pIoReq->fOutstanding, false);
     RTSemEventSignal(hEventSem);
     return;
@@ -2698,6 +2994,44 @@ static PVDDISK tstVDIoGetDiskByName(PVDTESTGLOB pGlob, const char *pcszDisk)
     return fFound ? pIt : NULL;
 }
 
+/**
+ * Remembers the backend of the last image created or opened for the disk.
+ *
+ * @returns VBox status code.
+ * @param pDisk        The disk.
+ * @param pcszBackend  The backend name.
+ */
+static int tstVDIoDiskSetBackend(PVDDISK pDisk, const char *pcszBackend)
+{
+    char *pszBackend = RTStrDup(pcszBackend);
+    if (!pszBackend)
+        return VERR_NO_MEMORY;
+
+    RTStrFree(pDisk->pszBackend);
+    pDisk->pszBackend = pszBackend;
+    return VINF_SUCCESS;
+}
+
+/**
+ * Destroys the given disk which must not be on the disk list anymore.
+ *
+ * @param pDisk    The disk to destroy.
+ */
+static void tstVDIoDiskFree(PVDDISK pDisk)
+{
+    VDDestroy(pDisk->pVD);
+    if (pDisk->pMemDiskVerify)
+    {
+        VDMemDiskDestroy(pDisk->pMemDiskVerify);
+        RTCritSectDelete(&pDisk->CritSectVerify);
+    }
+    RTMemWipeThoroughly(pDisk->abCryptKey, sizeof(pDisk->abCryptKey), 3);
+    RTStrFree(pDisk->pszCryptAlgorithm);
+    RTStrFree(pDisk->pszBackend);
+    RTStrFree(pDisk->pszName);
+    RTMemFree(pDisk);
+}
+
 /**
  * Returns the I/O pattern handle by name of NULL if not found.
  *
@@ -2872,14 +3206,7 @@ static void tstVDIoScriptExec(const char *pszName, const char *pszScript)
             {
                 RTPrintf("Cleanup: Leftover disk \"%s\", deleting...\n", pDiskIt->pszName);
                 RTListNodeRemove(&pDiskIt->ListNode);
-                VDDestroy(pDiskIt->pVD);
-                if (pDiskIt->pMemDiskVerify)
-                {
-                    VDMemDiskDestroy(pDiskIt->pMemDiskVerify);
-                    RTCritSectDelete(&pDiskIt->CritSectVerify);
-                }
-                RTStrFree(pDiskIt->pszName);
-                RTMemFree(pDiskIt);
+                tstVDIoDiskFree(pDiskIt);
             }
 
             PVDFILE pFileIt, pFileItNext;
@@ -2966,19 +3293,193 @@ static void tstVDIoRunBuiltinTests(void)
 #endif
 }
 
+
+/**
+ * Benchmark workload parameters.
+ */
+typedef struct TSTVDIOBENCH
+{
+    /** Directory to create the images in. */
+    const char *pszDir;
+    /** Comma separated list of backends to benchmark. */
+    const char *pszBackends;
+    /** Access mode, "seq" or "rnd". */
+    const char *pszMode;
+    /** Block size. */
+    uint64_t    cbBlock;
+    /** Number of outstanding requests, async I/O is used if more than one. */
+    uint32_t    cQueueDepth;
+    /** Chance in percent for a request to be a write. */
+    uint32_t    uWritePercent;
+    /** Size of the disk to create. */
+    uint64_t    cbDisk;
+} TSTVDIOBENCH;
+/** Pointer to benchmark workload parameters. */
+typedef TSTVDIOBENCH *PTSTVDIOBENCH;
+
+/**
+ * Runs the benchmark workload against one entry of the backend list.
+ *
+ * @param   pBench      The workload parameters.
+ * @param   pszEntry    The backend list entry, "<backend>[+CRYPT][@<existing image>]".
+ */
+static void tstVDIoBenchRunOne(PTSTVDIOBENCH pBench, const char *pszEntry)
+{
+    char szBackend[64];
+    const char *pszImage = strchr(pszEntry, '@');
+    size_t cchBackend = pszImage ? (size_t)(pszImage - pszEntry) : strlen(pszEntry);
+    if (pszImage)
+        pszImage++;
+    if (!cchBackend || cchBackend >= sizeof(szBackend))
+    {
+        RTStrmPrintf(g_pStdErr, "tstVDIo: Invalid benchmark backend '%s'\n", pszEntry);
+        return;
+    }
+    memcpy(szBackend, pszEntry, cchBackend);
+    szBackend[cchBackend] = '\0';
+
+    bool fCrypt = false;
+    char *pszPlus = strchr(szBackend, '+');
+    if (pszPlus)
+    {
+        if (RTStrICmp(pszPlus + 1, "CRYPT"))
+        {
+            RTStrmPrintf(g_pStdErr, "tstVDIo: Invalid benchmark backend '%s'\n", pszEntry);
+            return;
+        }
+        *pszPlus = '\0';
+        fCrypt = true;
+    }
+
+    /* Existing images are used as given, new ones are created and preconditioned first. */
+    char szImage[RTPATH_MAX];
+    int rc;
+    if (pszImage)
+        rc = RTStrCopy(szImage, sizeof(szImage), pszImage);
+    else
+    {
+        char szName[96];
+        RTStrPrintf(szName, sizeof(szName), "tstVDIoBench.%s", szBackend);
+        rc = RTPathJoin(szImage, sizeof(szImage), pBench->pszDir, szName);
+    }
+    /* The script tokenizer doesn't know about escapes. */
+    if (RT_FAILURE(rc) || strchr(szImage, '"') || strchr(szBackend, '"'))
+    {
+        RTStrmPrintf(g_pStdErr, "tstVDIo: Invalid benchmark image path for '%s'\n", pszEntry);
+        return;
+    }
+
+    char *pszSetup = NULL;
+    if (pszImage)
+        rc = RTStrAPrintf(&pszSetup,
+                          "    open(\"bench\", \"%s\", \"%s\", false, %RTbool, true, false, false, false);\n",
+                          szImage, szBackend, pBench->uWritePercent == 0);
+    else
+        rc = RTStrAPrintf(&pszSetup,
+                          "    create(\"bench\", \"base\", \"%s\", \"dynamic\", \"%s\", %RU64, false, false);\n",
+                          szImage, szBackend, pBench->cbDisk);
+    if (rc < 0)
+        return;
+
+    char *pszScript = NULL;
+    rc = RTStrAPrintf(&pszScript,
+                      "void main()\n"
+                      "{\n"
+                      "    iorngcreate(10M, \"manual\", 1234567890);\n"
+                      "    setfilebackend(\"file\");\n"
+                      "    createdisk(\"bench\", false);\n"
+                      "%s"
+                      "%s"
+                      "%s"
+                      "    io(\"bench\", %RTbool, %u, \"%s\", %RU64, 0, 0, %RU64, %u, \"none\");\n"
+                      "    close(\"bench\", \"single\", %RTbool);\n"
+                      "    destroydisk(\"bench\");\n"
+                      "    iorngdestroy();\n"
+                      "}\n",
+                      pszSetup,
+                      fCrypt ? "    cryptfilteradd(\"bench\", \"AES-XTS256-PLAIN64\");\n" : "",
+                      pszImage ? "" : "    io(\"bench\", true, 32, \"seq\", 1M, 0, 0, 0, 100, \"none\");\n",
+                      pBench->cQueueDepth > 1, pBench->cQueueDepth, pBench->pszMode, pBench->cbBlock,
+                      pszImage ? 0 : pBench->cbDisk, pBench->uWritePercent, pszImage == NULL);
+    RTStrFree(pszSetup);
+    if (rc < 0)
+        return;
+
+    g_pszJsonTest = pszEntry;
+    tstVDIoScriptExec(pszEntry, pszScript);
+    g_pszJsonTest = NULL;
+    RTStrFree(pszScript);
+}
+
+/**
+ * Runs the benchmark workload against all configured backends.
+ *
+ * @param   pBench      The workload parameters.
+ */
+static void tstVDIoBenchRun(PTSTVDIOBENCH pBench)
+{
+    if (   !pBench->cbBlock
+        || !pBench->cQueueDepth
+        || pBench->uWritePercent > 100
+        || pBench->cbDisk < pBench->cbBlock
+        || (   strcmp(pBench->pszMode, "seq")
+            && strcmp(pBench->pszMode, "rnd")))
+    {
+        RTStrmPrintf(g_pStdErr, "tstVDIo: Invalid benchmark parameters\n");
+        return;
+    }
+
+    char *pszBackends = RTStrDup(pBench->pszBackends);
+    if (!pszBackends)
+        return;
+
+    char *pszNext = pszBackends;
+    while (pszNext)
+    {
+        char *pszEntry = pszNext;
+        pszNext = strchr(pszEntry, ',');
+        if (pszNext)
+            *pszNext++ = '\0';
+        pszEntry = RTStrStrip(pszEntry);
+        if (*pszEntry)
+            tstVDIoBenchRunOne(pBench, pszEntry);
+    }
+
+    RTStrFree(pszBackends);
+}
+
 /**
  * Shows help message.
  */
 static void printUsage(void)
 {
     RTPrintf("Usage:\n"
-             "--script <filename>    Script to execute\n");
+             "--script <filename>           Script to execute\n"
+             "--json <filename>             Write the results of all io actions as JSON records to the file\n"
+             "--benchmark                   Run the benchmark workload against every backend\n"
+             "  --bench-dir <dir>           Directory to create the images in (default: .)\n"
+             "  --bench-backends <list>     Comma separated list of <backend>[+CRYPT][@<existing image>]\n"
+             "                              (default: VDI,VMDK,VHD,QCOW,RAW,VDI+CRYPT)\n"
+             "  --bench-mode <seq|rnd>      Access pattern (default: rnd)\n"
+             "  --bench-block-size <bytes>  Block size (default: 4096)\n"
+             "  --bench-queue-depth <n>     Outstanding requests, async I/O if more than 1 (default: 32)\n"
+             "  --bench-writes <percent>    Chance for a request to be a write (default: 0)\n"
+             "  --bench-size <bytes>        Size of the created images (default: 1G)\n");
 }
 
 static const RTGETOPTDEF g_aOptions[] =
 {
-    { "--script",   's', RTGETOPT_REQ_STRING },
-    { "--help",     'h', RTGETOPT_REQ_NOTHING }
+    { "--script",               's', RTGETOPT_REQ_STRING },
+    { "--json",                 'j', RTGETOPT_REQ_STRING },
+    { "--benchmark",            'b', RTGETOPT_REQ_NOTHING },
+    { "--bench-dir",            'd', RTGETOPT_REQ_STRING },
+    { "--bench-backends",       'f', RTGETOPT_REQ_STRING },
+    { "--bench-mode",           'm', RTGETOPT_REQ_STRING },
+    { "--bench-block-size",     'B', RTGETOPT_REQ_UINT64 },
+    { "--bench-queue-depth",    'q', RTGETOPT_REQ_UINT32 },
+    { "--bench-writes",         'w', RTGETOPT_REQ_UINT32 },
+    { "--bench-size",           'S', RTGETOPT_REQ_UINT64 },
+    { "--help",                 'h', RTGETOPT_REQ_NOTHING }
 };
 
 int main(int argc, char *argv[])
@@ -2988,6 +3489,16 @@ int main(int argc, char *argv[])
     RTGETOPTUNION ValueUnion;
     RTGETOPTSTATE GetState;
     char c;
+    bool fBenchmark = false;
+    TSTVDIOBENCH Bench;
+
+    Bench.pszDir        = ".";
+    Bench.pszBackends   = "VDI,VMDK,VHD,QCOW,RAW,VDI+CRYPT";
+    Bench.pszMode       = "rnd";
+    Bench.cbBlock       = _4K;
+    Bench.cQueueDepth   = 32;
+    Bench.uWritePercent = 0;
+    Bench.cbDisk        = _1G;
 
     rc = VDInit();
     if (RT_FAILURE(rc))
@@ -3010,6 +3521,45 @@ int main(int argc, char *argv[])
             case 's':
                 tstVDIoScriptRun(ValueUnion.psz);
                 break;
+            case 'j':
+                if (g_pStrmJson)
+                    RTStrmClose(g_pStrmJson);
+                rc = RTStrmOpen(ValueUnion.psz, "w", &g_pStrmJson);
+                if (RT_SUCCESS(rc))
+                {
+                    g_cJsonRecords = 0;
+                    RTStrmPrintf(g_pStrmJson, "[\n");
+                }
+                else
+                {
+                    RTStrmPrintf(g_pStdErr, "tstVDIo: Opening '%s' failed: %Rrc\n", ValueUnion.psz, rc);
+                    g_pStrmJson = NULL;
+                }
+                break;
+            case 'b':
+                fBenchmark = true;
+                break;
+            case 'd':
+                Bench.pszDir = ValueUnion.psz;
+                break;
+            case 'f':
+                Bench.pszBackends = ValueUnion.psz;
+                break;
+            case 'm':
+                Bench.pszMode = ValueUnion.psz;
+                break;
+            case 'B':
+                Bench.cbBlock = ValueUnion.u64;
+                break;
+            case 'q':
+                Bench.cQueueDepth = ValueUnion.u32;
+                break;
+            case 'w':
+                Bench.uWritePercent = ValueUnion.u32;
+                break;
+            case 'S':
+                Bench.cbDisk = ValueUnion.u64;
+                break;
             case 'h':
                 printUsage();
                 break;
@@ -3018,6 +3568,17 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* Run after parsing so the workload options can be given in any order. */
+    if (RT_SUCCESS(rc) && fBenchmark)
+        tstVDIoBenchRun(&Bench);
+
+    if (g_pStrmJson)
+    {
+        RTStrmPrintf(g_pStrmJson, "\n]\n");
+        RTStrmClose(g_pStrmJson);
+        g_pStrmJson = NULL;
+    }
+
     rc = VDShutdown();
     if (RT_FAILURE(rc))
         RTPrintf("tstVDIo: unloading backends failed! rc=%Rrc\n", rc);
@@ -78,6 +78,7 @@ static void printUsage(PRTSTREAM pStrm)
                  "                [--srcformat VDI|VMDK|VHD|RAW|..]\n"
                  "                [--dstformat VDI|VMDK|VHD|RAW|..]\n"
                  "                [--variant Standard,Fixed,Split2G,Stream,ESX]\n"
+                 "                [--pipeline-depth <number>]\n"
                  "\n"
                  "   info         --filename <filename>\n"
                  "\n"
@@ -1039,6 +1040,48 @@ static DECLCALLBACK(int) convFileOutFlush(void *pvUser, void *pStorage)
     return VINF_SUCCESS;
 }
 
+static DECLCALLBACK(bool) vdIfCfgConvertAreKeysValid(void *pvUser, const char *pszzValid)
+{
+    RT_NOREF(pvUser);
+
+    /* The only key we provide is CopyPipelineDepth. */
+    for (const char *psz = pszzValid; psz && *psz; psz = strchr(psz, '\0') + 1)
+        if (!RTStrCmp(psz, "CopyPipelineDepth"))
+            return true;
+    return false;
+}
+
+static DECLCALLBACK(int) vdIfCfgConvertQuerySize(void *pvUser, const char *pszName, size_t *pcbValue)
+{
+    AssertPtrReturn(pcbValue, VERR_INVALID_POINTER);
+
+    AssertPtrReturn(pvUser, VERR_GENERAL_FAILURE);
+
+    if (RTStrCmp(pszName, "CopyPipelineDepth"))
+        return VERR_CFGM_VALUE_NOT_FOUND;
+
+    *pcbValue = strlen((const char *)pvUser) + 1 /* include terminator */;
+
+    return VINF_SUCCESS;
+}
+
+static DECLCALLBACK(int) vdIfCfgConvertQuery(void *pvUser, const char *pszName, char *pszValue, size_t cchValue)
+{
+    AssertPtrReturn(pszValue, VERR_INVALID_POINTER);
+
+    AssertPtrReturn(pvUser, VERR_GENERAL_FAILURE);
+
+    if (RTStrCmp(pszName, "CopyPipelineDepth"))
+        return VERR_CFGM_VALUE_NOT_FOUND;
+
+    if (strlen((const char *)pvUser) >= cchValue)
+        return VERR_CFGM_NOT_ENOUGH_SPACE;
+
+    memcpy(pszValue, pvUser, strlen((const char *)pvUser) + 1);
+
+    return VINF_SUCCESS;
+}
+
 static int handleConvert(HandlerArg *a)
 {
     const char *pszSrcFilename = NULL;
@@ -1050,6 +1093,7 @@ static int handleConvert(HandlerArg *a)
     VDTYPE enmSrcType = VDTYPE_HDD;
     const char *pszDstFormat = NULL;
     const char *pszVariant = NULL;
+    const char *pszPipelineDepth = NULL;
     PVDISK pSrcDisk = NULL;
     PVDISK pDstDisk = NULL;
     unsigned uImageFlags = VD_IMAGE_FLAGS_NONE;
@@ -1057,6 +1101,8 @@ static int handleConvert(HandlerArg *a)
     PVDINTERFACE pIfsImageOutput = NULL;
     VDINTERFACEIO IfsInputIO;
     VDINTERFACEIO IfsOutputIO;
+    PVDINTERFACE pVDIfsOperation = NULL;
+    VDINTERFACECONFIG vdIfCfg;
     int rc = VINF_SUCCESS;
 
     /* Parse the command line. */
@@ -1069,7 +1115,8 @@ static int handleConvert(HandlerArg *a)
         { "--srcformat", 's', RTGETOPT_REQ_STRING },
         { "--dstformat", 'd', RTGETOPT_REQ_STRING },
         { "--variant", 'v', RTGETOPT_REQ_STRING },
-        { "--create-sparse", 'c', RTGETOPT_REQ_NOTHING }
+        { "--create-sparse", 'c', RTGETOPT_REQ_NOTHING },
+        { "--pipeline-depth", 'D', RTGETOPT_REQ_STRING }
     };
     int ch;
     RTGETOPTUNION ValueUnion;
@@ -1103,6 +1150,9 @@ static int handleConvert(HandlerArg *a)
             case 'c':   // --create-sparse
                 fCreateSparse = true;
                 break;
+            case 'D':   // --pipeline-depth
+                pszPipelineDepth = ValueUnion.psz;
+                break;
 
             default:
                 ch = RTGetOptPrintError(ch, &ValueUnion);
@@ -1263,10 +1313,20 @@ static int handleConvert(HandlerArg *a)
         uint64_t cbSize = VDGetSize(pSrcDisk, VD_LAST_IMAGE);
         RTStrmPrintf(g_pStdErr, "Converting image \"%s\" with size %RU64 bytes (%RU64MB)...\n", pszSrcFilename, cbSize, (cbSize + _1M - 1) / _1M);
 
+        /* Setup the config interface if required. */
+        if (pszPipelineDepth)
+        {
+            vdIfCfg.pfnAreKeysValid = vdIfCfgConvertAreKeysValid;
+            vdIfCfg.pfnQuerySize    = vdIfCfgConvertQuerySize;
+            vdIfCfg.pfnQuery        = vdIfCfgConvertQuery;
+            VDInterfaceAdd(&vdIfCfg.Core, "Config", VDINTERFACETYPE_CONFIG, (void *)pszPipelineDepth,
+                           sizeof(vdIfCfg), &pVDIfsOperation);
+        }
+
         /* Create the output image */
         rc = VDCopy(pSrcDisk, VD_LAST_IMAGE, pDstDisk, pszDstFormat,
                     pszDstFilename, false, 0, uImageFlags, NULL,
-                    VD_OPEN_FLAGS_NORMAL | VD_OPEN_FLAGS_SEQUENTIAL, NULL,
+                    VD_OPEN_FLAGS_NORMAL | VD_OPEN_FLAGS_SEQUENTIAL, pVDIfsOperation,
                     pIfsImageOutput, NULL);
         if (RT_FAILURE(rc))
         {
@@ -34,6 +34,7 @@
 #include <VBox/types.h>
 #include <VBox/err.h>
 #include <VBox/vmm/dbgf.h>
+#include <VBox/vmm/vmm.h>
 #if defined(IN_RING3)
 # include <VBox/vmm/uvm.h>
 # include <VBox/vmm/vm.h>
@@ -43,6 +44,8 @@
 # error "Invalid environment"
 #endif
 
+#include <iprt/time.h>
+
 
 /*********************************************************************************************************************************
 *   Internal Functions                                                                                                           *
@@ -129,6 +132,8 @@ static int dbgfTracerEvtPostEx(PVMCC pVM, PDBGFTRACERINSCC pThisCC, DBGFTRACEREV
     pEvtHdr->hEvtSrc     = hEvtSrc;
     pEvtHdr->enmEvt      = enmTraceEvt;
     pEvtHdr->fFlags      = DBGF_TRACER_EVT_HDR_F_DEFAULT;
+    pEvtHdr->u64TsNano   = RTTimeNanoTS();
+    pEvtHdr->idCpu       = VMMGetCpuId(pVM);
     ASMAtomicWriteU64(&pEvtHdr->idEvt, idEvt);
 
     int rc = VINF_SUCCESS;
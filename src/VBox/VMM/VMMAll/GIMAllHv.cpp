@@ -599,6 +599,21 @@ VMM_INT_DECL(VBOXSTRICTRC) gimHvReadMsr(PVMCPUCC pVCpu, uint32_t idMsr, PCCPUMMS
             *puValue = gimHvGetTimeRefCount(pVCpu);
             return VINF_SUCCESS;
 
+        case MSR_GIM_HV_VP_RUNTIME:
+        {
+            if (pHv->uBaseFeat & GIM_HV_BASE_FEAT_VP_RUNTIME_MSR)
+            {
+#ifndef IN_RING3
+                return VINF_CPUM_R3_MSR_READ;
+#else
+                /* The time the VP actually ran, in 100ns units. */
+                *puValue = TMR3CpuGetRunTime(pVM, pVCpu) / 100;
+                return VINF_SUCCESS;
+#endif
+            }
+            break;
+        }
+
         case MSR_GIM_HV_VP_INDEX:
             *puValue = pVCpu->idCpu;
             return VINF_SUCCESS;
@@ -1172,7 +1187,8 @@ VMM_INT_DECL(VBOXSTRICTRC) gimHvWriteMsr(PVMCPUCC pVCpu, uint32_t idMsr, PCCPUMM
                     Log(("GIM%u: HyperV: Set STIMER_CONFIG%u=%#RX64\n", pVCpu->idCpu, idxStimer, uRawValue));
 
                     /* Process the MSR bits. */
-                    if (   !MSR_GIM_HV_STIMER_GET_SINTX(uRawValue)   /* Writing SINTx as 0 causes the timer to be disabled. */
+                    if (   (   !MSR_GIM_HV_STIMER_GET_SINTX(uRawValue)   /* Writing SINTx as 0 causes the timer to be disabled, */
+                            && !MSR_GIM_HV_STIMER_IS_DIRECT_MODE(uRawValue)) /* unless it's in direct mode (SINTx unused). */
                         || !MSR_GIM_HV_STIMER_IS_ENABLED(uRawValue))
                     {
                         pHvStimer->uStimerConfigMsr &= ~MSR_GIM_HV_STIMER_ENABLE;
@@ -1347,6 +1363,7 @@ VMM_INT_DECL(VBOXSTRICTRC) gimHvWriteMsr(PVMCPUCC pVCpu, uint32_t idMsr, PCCPUMM
         case MSR_GIM_HV_CRASH_P4:  pHv->uCrashP4Msr = uRawValue;  return VINF_SUCCESS;
 
         case MSR_GIM_HV_TIME_REF_COUNT:     /* Read-only MSRs. */
+        case MSR_GIM_HV_VP_RUNTIME:
         case MSR_GIM_HV_VP_INDEX:
         case MSR_GIM_HV_TSC_FREQ:
         case MSR_GIM_HV_APIC_FREQ:
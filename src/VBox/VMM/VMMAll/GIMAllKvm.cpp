@@ -202,6 +202,14 @@ VMM_INT_DECL(VBOXSTRICTRC) gimKvmReadMsr(PVMCPUCC pVCpu, uint32_t idMsr, PCCPUMM
             *puValue = pKvmCpu->u64SystemTimeMsr;
             return VINF_SUCCESS;
 
+        case MSR_GIM_KVM_STEAL_TIME:
+            if (pKvm->uBaseFeat & GIM_KVM_BASE_FEAT_STEAL_TIME)
+            {
+                *puValue = pKvmCpu->u64StealTimeMsr;
+                return VINF_SUCCESS;
+            }
+            break;
+
         case MSR_GIM_KVM_WALL_CLOCK:
         case MSR_GIM_KVM_WALL_CLOCK_OLD:
             *puValue = pKvm->u64WallClockMsr;
@@ -259,6 +267,31 @@ VMM_INT_DECL(VBOXSTRICTRC) gimKvmWriteMsr(PVMCPUCC pVCpu, uint32_t idMsr, PCCPUM
 #endif /* IN_RING3 */
         }
 
+        case MSR_GIM_KVM_STEAL_TIME:
+        {
+#ifndef IN_RING3
+            RT_NOREF2(pVCpu, uRawValue);
+            return VINF_CPUM_R3_MSR_WRITE;
+#else
+            PVMCC      pVM = pVCpu->CTX_SUFF(pVM);
+            PGIMKVMCPU pKvmCpu = &pVCpu->gim.s.u.KvmCpu;
+            if (   !(pVM->gim.s.u.Kvm.uBaseFeat & GIM_KVM_BASE_FEAT_STEAL_TIME)
+                || (uRawValue & MSR_GIM_KVM_STEAL_TIME_RSVD_MASK))
+                return VERR_CPUM_RAISE_GP_0;
+
+            if (MSR_GIM_KVM_STEAL_TIME_IS_ENABLED(uRawValue))
+            {
+                /* Like the system-time struct., a bad address doesn't #GP(0) (neither does KVM). */
+                int rc = gimR3KvmEnableStealTime(pVM, pVCpu, uRawValue);
+                if (RT_FAILURE(rc))
+                    pKvmCpu->u64StealTimeMsr = 0;
+            }
+            else
+                pKvmCpu->u64StealTimeMsr = uRawValue;
+            return VINF_SUCCESS;
+#endif /* IN_RING3 */
+        }
+
         case MSR_GIM_KVM_WALL_CLOCK:
         case MSR_GIM_KVM_WALL_CLOCK_OLD:
         {
@@ -78,6 +78,31 @@ extern "C" void  __deregister_frame(const void *pvFde);
 extern "C" void  __register_frame_info(void *pvBegin, void *pvObj); /* found no header for these two */
 extern "C" void *__deregister_frame_info(void *pvBegin);           /* (returns pvObj from __register_frame_info call) */
 # endif
+# if defined(RT_OS_LINUX) && defined(IN_RING3)
+#  include <errno.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <time.h>
+#  include <sys/uio.h>
+#  include <iprt/critsect.h>
+#  include <iprt/once.h>
+#  define IEMEXECMEM_WITH_DUAL_MAPPING
+#  define IEMEXECMEM_WITH_HOST_PERF
+#  ifndef MFD_CLOEXEC
+#   define MFD_CLOEXEC          0x0001U
+#  endif
+#  ifndef MFD_HUGETLB
+#   define MFD_HUGETLB          0x0004U
+#  endif
+#  ifndef MFD_HUGE_2MB
+#   define MFD_HUGE_2MB         (21U << 26)
+#  endif
+#  ifndef MADV_HUGEPAGE
+#   define MADV_HUGEPAGE        14
+#  endif
+# endif
 #endif
 
 #include "IEMN8veRecompiler.h"
@@ -95,6 +120,16 @@ extern "C" void *__deregister_frame_info(void *pvBegin);           /* (returns p
 #define IEMEXECMEM_ALT_SUB_WITH_ALLOC_HEADER
 /** Use alternative pruning. */
 #define IEMEXECMEM_ALT_SUB_WITH_ALT_PRUNING
+#ifdef IEMEXECMEM_ALT_SUB_WITH_ALLOC_HEADER
+/** Cache freed small blocks in per-size free lists for O(1) reuse. */
+# define IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+#endif
+/** Number of size classes (in allocation units) with free lists; class N holds
+ *  blocks of exactly N units, class 0 is unused. */
+#define IEMEXECMEM_FREE_LIST_CLASSES            33
+/** Max fraction (as a shift count) of the total memory that may sit in the
+ *  free lists before blocks are returned to the bitmap instead. */
+#define IEMEXECMEM_FREE_LIST_MAX_SHIFT          3
 
 
 #if defined(IN_RING3) && !defined(RT_OS_WINDOWS)
@@ -235,6 +270,13 @@ typedef struct IEMEXECMEMCHUNK
     /** Allocation handle. */
     RTR0MEMOBJ              hMemObj;
 #endif
+#ifdef IEMEXECMEM_WITH_DUAL_MAPPING
+    /** Set if pvChunkRw and pvChunkRx are separate mappings of a memfd
+     * (IEMEXECMEM_F_DUAL_MAPPING), clear if allocated by RTMemPageAllocEx. */
+    bool                    fDualMapped;
+    /** Set if the chunk is backed by 2 MiB hugetlbfs pages. */
+    bool                    fLargePages;
+#endif
 } IEMEXECMEMCHUNK;
 /** Pointer to a memory chunk. */
 typedef IEMEXECMEMCHUNK *PIEMEXECMEMCHUNK;
@@ -258,6 +300,10 @@ typedef struct IEMEXECMEMALLOCATOR
     uint32_t                idxChunkHint;
     /** Statistics: Current number of allocations. */
     uint32_t                cAllocations;
+    /** IEMEXECMEM_F_XXX as given to iemExecMemAllocatorInit. */
+    uint32_t                fFlags;
+    /** Statistics: Number of chunks backed by large pages. */
+    uint32_t                cLargePageChunks;
 
     /** The total amount of memory available. */
     uint64_t                cbTotal;
@@ -283,6 +329,24 @@ typedef struct IEMEXECMEMALLOCATOR
     /** Number of times we fruitlessly scanned a chunk for free space. */
     uint64_t                cFruitlessChunkScans;
 
+#ifdef IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+    /** Free list heads, indexed by block size in allocation units.  The blocks
+     * in these are still marked as allocated in the bitmap and pointed to
+     * using the RW view.  */
+    struct IEMEXECMEMFREEBLK *apFreeLists[IEMEXECMEM_FREE_LIST_CLASSES];
+    /** Number of bytes sitting in the free lists. */
+    uint64_t                cbFreeListed;
+    /** Number of allocations satisfied from a free list. */
+    STAMCOUNTER             StatFreeListHits;
+    /** Number of allocations of a free list size that had to scan the bitmap. */
+    STAMCOUNTER             StatFreeListMisses;
+    /** Number of times the free lists were flushed back into the bitmap. */
+    STAMCOUNTER             StatFreeListFlushes;
+#endif
+    /** Number of times the bitmap scan failed even though the total free space
+     * would've been enough, i.e. a fragmentation indicator. */
+    STAMCOUNTER             StatFragmentedFailures;
+
 #ifdef IEMEXECMEM_ALT_SUB_WITH_ALT_PRUNING
     /** The next chunk to prune in. */
     uint32_t                idxChunkPrune;
@@ -350,8 +414,82 @@ typedef  IEMEXECMEMALLOCHDR *PIEMEXECMEMALLOCHDR;
 # define IEMEXECMEMALLOCHDR_MAGIC       UINT32_C(0x4d657845)
 #endif
 
+#ifdef IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+/**
+ * A freed block sitting in one of the IEMEXECMEMALLOCATOR::apFreeLists.
+ *
+ * This overlays the allocation header, using a different magic so the pruning
+ * code will skip it.
+ */
+typedef struct IEMEXECMEMFREEBLK
+{
+    /** Magic value / eyecatcher (IEMEXECMEMFREEBLK_MAGIC). */
+    uint32_t                    uMagic;
+    /** The allocation chunk. */
+    uint32_t                    idxChunk;
+    /** The next block in the list (RW view). */
+    struct IEMEXECMEMFREEBLK   *pNext;
+} IEMEXECMEMFREEBLK;
+AssertCompile(sizeof(IEMEXECMEMFREEBLK) == sizeof(IEMEXECMEMALLOCHDR));
+/** Pointer to a free-listed block. */
+typedef IEMEXECMEMFREEBLK *PIEMEXECMEMFREEBLK;
+/** Magic value for IEMEXECMEMFREEBLK ('FreM'). */
+# define IEMEXECMEMFREEBLK_MAGIC        UINT32_C(0x4d657246)
+#endif
+
 
 static int iemExecMemAllocatorGrow(PVMCPUCC pVCpu, PIEMEXECMEMALLOCATOR pExecMemAllocator);
+static int iemExecMemAllocatorGrowCommon(PVMCPUCC pVCpu, PIEMEXECMEMALLOCATOR pExecMemAllocator, uint32_t idxChunk);
+
+
+#ifdef IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+/**
+ * Returns all the blocks in the free lists to the allocation bitmap.
+ *
+ * This is done when the bitmap scan comes up empty and after pruning, so that
+ * adjacent free blocks can coalesce into larger runs again.
+ *
+ * @returns true if anything was flushed, false if the lists were all empty.
+ * @param   pExecMemAllocator   The allocator.
+ */
+static bool iemExecMemAllocatorFlushFreeLists(PIEMEXECMEMALLOCATOR pExecMemAllocator)
+{
+    if (!pExecMemAllocator->cbFreeListed)
+        return false;
+    STAM_REL_COUNTER_INC(&pExecMemAllocator->StatFreeListFlushes);
+
+    for (uint32_t cUnits = 1; cUnits < RT_ELEMENTS(pExecMemAllocator->apFreeLists); cUnits++)
+    {
+        PIEMEXECMEMFREEBLK pBlk = pExecMemAllocator->apFreeLists[cUnits];
+        pExecMemAllocator->apFreeLists[cUnits] = NULL;
+        while (pBlk)
+        {
+            Assert(pBlk->uMagic == IEMEXECMEMFREEBLK_MAGIC);
+            PIEMEXECMEMFREEBLK const pNext    = pBlk->pNext;
+            uint32_t const           idxChunk = pBlk->idxChunk;
+            Assert(idxChunk < pExecMemAllocator->cChunks);
+            PIEMEXECMEMCHUNK const   pChunk   = &pExecMemAllocator->aChunks[idxChunk];
+            uint32_t const           idxFirst = (uint32_t)((uintptr_t)pBlk - (uintptr_t)pChunk->pvChunkRw)
+                                             >> IEMEXECMEM_ALT_SUB_ALLOC_UNIT_SHIFT;
+
+            pBlk->uMagic   = 0;
+            pBlk->idxChunk = 0;
+            pBlk->pNext    = NULL;
+
+            ASMBitClearRange(&pExecMemAllocator->pbmAlloc[pExecMemAllocator->cBitmapElementsPerChunk * idxChunk],
+                             idxFirst, idxFirst + cUnits);
+            pChunk->cFreeUnits += cUnits;
+            if (idxFirst < pChunk->idxFreeHint)
+                pChunk->idxFreeHint = idxFirst;
+            pExecMemAllocator->cbFree += cUnits << IEMEXECMEM_ALT_SUB_ALLOC_UNIT_SHIFT;
+
+            pBlk = pNext;
+        }
+    }
+    pExecMemAllocator->cbFreeListed = 0;
+    return true;
+}
+#endif /* IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS */
 
 
 #ifdef IEMEXECMEM_ALT_SUB_WITH_ALT_PRUNING
@@ -484,6 +622,12 @@ static void iemExecMemAllocatorPrune(PVMCPU pVCpu, PIEMEXECMEMALLOCATOR pExecMem
     pExecMemAllocator->offChunkPrune = offChunk;
     pExecMemAllocator->idxChunkPrune = idxChunk;
 
+#ifdef IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+    /* The freed TBs' memory went into the free lists, return it to the bitmap
+       so the pruned range becomes one contiguous free run. */
+    iemExecMemAllocatorFlushFreeLists(pExecMemAllocator);
+#endif
+
     /* Set the hint to the start of the pruned region. */
     pExecMemAllocator->idxChunkHint  = idxChunk;
     pExecMemAllocator->aChunks[idxChunk].idxFreeHint = offPruneStart / IEMEXECMEM_ALT_SUB_ALLOC_UNIT_SIZE;
@@ -921,6 +1065,49 @@ DECL_FORCE_INLINE(uint32_t) iemExecMemAllocBytesToUnits(uint32_t cbReq)
 }
 
 
+#ifdef IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+/**
+ * Takes a block of exactly @a cReqUnits off the corresponding free list.
+ *
+ * @returns Pointer to the readable/writeable memory, NULL if the list is empty.
+ */
+DECL_FORCE_INLINE(PIEMNATIVEINSTR)
+iemExecMemAllocatorAllocFromFreeList(PIEMEXECMEMALLOCATOR pExecMemAllocator, uint32_t cReqUnits, PIEMTB pTb,
+                                     PIEMNATIVEINSTR *ppaExec, PCIEMNATIVEPERCHUNKCTX *ppChunkCtx)
+{
+    Assert(cReqUnits < RT_ELEMENTS(pExecMemAllocator->apFreeLists));
+    PIEMEXECMEMFREEBLK const pBlk = pExecMemAllocator->apFreeLists[cReqUnits];
+    if (pBlk)
+    {
+        Assert(pBlk->uMagic == IEMEXECMEMFREEBLK_MAGIC);
+        pExecMemAllocator->apFreeLists[cReqUnits] = pBlk->pNext;
+
+        uint32_t const         idxChunk = pBlk->idxChunk;
+        PIEMEXECMEMCHUNK const pChunk   = &pExecMemAllocator->aChunks[idxChunk];
+        uint32_t const         cbBlock  = cReqUnits << IEMEXECMEM_ALT_SUB_ALLOC_UNIT_SHIFT;
+        pExecMemAllocator->cbFreeListed -= cbBlock;
+        pExecMemAllocator->cbAllocated  += cbBlock;
+        pExecMemAllocator->cAllocations += 1;
+        STAM_REL_COUNTER_INC(&pExecMemAllocator->StatFreeListHits);
+
+        PIEMEXECMEMALLOCHDR const pHdr = (PIEMEXECMEMALLOCHDR)pBlk;
+        pHdr->uMagic   = IEMEXECMEMALLOCHDR_MAGIC;
+        pHdr->idxChunk = idxChunk;
+        pHdr->pTb      = pTb;
+
+        if (ppaExec)
+            *ppaExec = (PIEMNATIVEINSTR)(  (uintptr_t)pChunk->pvChunkRx + ((uintptr_t)pHdr - (uintptr_t)pChunk->pvChunkRw)
+                                         + sizeof(*pHdr));
+        if (ppChunkCtx)
+            *ppChunkCtx = pChunk->pCtx;
+        return (PIEMNATIVEINSTR)(pHdr + 1);
+    }
+    STAM_REL_COUNTER_INC(&pExecMemAllocator->StatFreeListMisses);
+    return NULL;
+}
+#endif /* IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS */
+
+
 DECL_FORCE_INLINE(PIEMNATIVEINSTR)
 iemExecMemAllocatorAllocUnitsInChunkInner(PIEMEXECMEMALLOCATOR pExecMemAllocator, uint32_t idxChunk, uint32_t cReqUnits,
                                           PIEMTB pTb, PIEMNATIVEINSTR *ppaExec, PCIEMNATIVEPERCHUNKCTX *ppChunkCtx)
@@ -983,6 +1170,25 @@ DECLHIDDEN(PIEMNATIVEINSTR) iemExecMemAllocatorAlloc(PVMCPU pVCpu, uint32_t cbRe
 
     uint32_t const cReqUnits = iemExecMemAllocBytesToUnits(cbReq);
     STAM_COUNTER_INC(&pExecMemAllocator->aStatSizes[cReqUnits < RT_ELEMENTS(pExecMemAllocator->aStatSizes) ? cReqUnits : 0]);
+
+#ifdef IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+    /*
+     * Recycle a block of the exact same size if we've got one handy.
+     */
+    if (cReqUnits < RT_ELEMENTS(pExecMemAllocator->apFreeLists))
+    {
+        PIEMNATIVEINSTR const pRet = iemExecMemAllocatorAllocFromFreeList(pExecMemAllocator, cReqUnits, pTb, ppaExec, ppChunkCtx);
+        if (pRet)
+        {
+            STAM_PROFILE_STOP(&pExecMemAllocator->StatAlloc, a);
+# ifdef VBOX_WITH_STATISTICS
+            pExecMemAllocator->cbUnusable += (cReqUnits << IEMEXECMEM_ALT_SUB_ALLOC_UNIT_SHIFT) - cbReq;
+# endif
+            return pRet;
+        }
+    }
+#endif
+
     for (unsigned iIteration = 0;; iIteration++)
     {
         if (   cbReq * 2 <= pExecMemAllocator->cbFree
@@ -1033,6 +1239,20 @@ DECLHIDDEN(PIEMNATIVEINSTR) iemExecMemAllocatorAlloc(PVMCPU pVCpu, uint32_t cbRe
                 cMinFreePass = cReqUnits * 2;
             }
         }
+        if (pExecMemAllocator->cbFree >= (cReqUnits << IEMEXECMEM_ALT_SUB_ALLOC_UNIT_SHIFT))
+            STAM_REL_COUNTER_INC(&pExecMemAllocator->StatFragmentedFailures);
+
+#ifdef IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+        /*
+         * Give the free-listed blocks back to the bitmap and retry before
+         * growing or pruning.  This does not count as an iteration.
+         */
+        if (iemExecMemAllocatorFlushFreeLists(pExecMemAllocator))
+        {
+            iIteration--;
+            continue;
+        }
+#endif
 
         /*
          * Can we grow it with another chunk?
@@ -1257,6 +1477,30 @@ DECLHIDDEN(void) iemExecMemAllocatorFree(PVMCPU pVCpu, void *pv, size_t cb) RT_N
             AssertReturnVoid(ASMBitTest(pbmAlloc, idxFirst));
             for (uint32_t i = 1; i < cReqUnits; i++)
                 AssertReturnVoid(ASMBitTest(pbmAlloc, idxFirst + i));
+
+#ifdef IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+            /* Small blocks go onto the free list for their size, leaving the
+               bitmap alone, as long as the lists don't hog too much memory. */
+            if (   cReqUnits < RT_ELEMENTS(pExecMemAllocator->apFreeLists)
+                &&   pExecMemAllocator->cbFreeListed + cb
+                  <= pExecMemAllocator->cbTotal >> IEMEXECMEM_FREE_LIST_MAX_SHIFT)
+            {
+                PIEMEXECMEMFREEBLK const pBlk = (PIEMEXECMEMFREEBLK)((uintptr_t)pExecMemAllocator->aChunks[idxChunk].pvChunkRw
+                                                                     + offChunk);
+                pBlk->uMagic   = IEMEXECMEMFREEBLK_MAGIC;
+                pBlk->idxChunk = idxChunk;
+                pBlk->pNext    = pExecMemAllocator->apFreeLists[cReqUnits];
+                pExecMemAllocator->apFreeLists[cReqUnits] = pBlk;
+
+                pExecMemAllocator->cbFreeListed += cb;
+                pExecMemAllocator->cbAllocated  -= cb;
+                pExecMemAllocator->cAllocations -= 1;
+# ifdef VBOX_WITH_STATISTICS
+                pExecMemAllocator->cbUnusable   -= (cReqUnits << IEMEXECMEM_ALT_SUB_ALLOC_UNIT_SHIFT) - cbOrig;
+# endif
+                return;
+            }
+#endif
             ASMBitClearRange(pbmAlloc, idxFirst, idxFirst + cReqUnits);
 
             /* Invalidate the header using the writeable memory view. */
@@ -1317,6 +1561,202 @@ DECLHIDDEN(PCIEMNATIVEPERCHUNKCTX) iemExecMemGetTbChunkCtx(PVMCPU pVCpu, PCIEMTB
     return NULL;
 }
 
+#ifdef IEMEXECMEM_WITH_HOST_PERF
+/*********************************************************************************************************************************
+*   Host 'perf' Support                                                                                                          *
+*********************************************************************************************************************************/
+
+/** jitdump: File header (see tools/perf/Documentation/jitdump-specification.txt). */
+typedef struct IEMPERFJITDUMPHDR
+{
+    uint32_t    uMagic;         /**< IEMPERFJITDUMPHDR_MAGIC */
+    uint32_t    uVersion;       /**< 1 */
+    uint32_t    cbHdr;          /**< sizeof(IEMPERFJITDUMPHDR) */
+    uint32_t    uElfMach;       /**< EM_XXX of the host. */
+    uint32_t    uPad1;
+    uint32_t    uPid;
+    uint64_t    uTimestamp;
+    uint64_t    fFlags;
+} IEMPERFJITDUMPHDR;
+AssertCompileSize(IEMPERFJITDUMPHDR, 40);
+/** jitdump: Magic value for IEMPERFJITDUMPHDR::uMagic ('JiTD'). */
+# define IEMPERFJITDUMPHDR_MAGIC        UINT32_C(0x4a695444)
+
+/** jitdump: JIT_CODE_LOAD record, followed by the zero terminated name and
+ * the code bytes. */
+typedef struct IEMPERFJITDUMPCODELOAD
+{
+    uint32_t    idRecord;       /**< IEMPERFJITDUMP_CODE_LOAD */
+    uint32_t    cbTotal;        /**< Record size including name and code. */
+    uint64_t    uTimestamp;
+    uint32_t    uPid;
+    uint32_t    uTid;
+    uint64_t    uVma;
+    uint64_t    uCodeAddr;
+    uint64_t    cbCode;
+    uint64_t    idxCode;
+} IEMPERFJITDUMPCODELOAD;
+AssertCompileSize(IEMPERFJITDUMPCODELOAD, 56);
+/** jitdump: JIT_CODE_LOAD record ID. */
+# define IEMPERFJITDUMP_CODE_LOAD       UINT32_C(0)
+
+/** Init once for the perf writer state. */
+static RTONCE           g_IemPerfOnce   = RTONCE_INITIALIZER;
+/** Serializes writing to the perf files. */
+static RTCRITSECT       g_IemPerfLock;
+/** The /tmp/perf-<pid>.map file descriptor, -1 if not open. */
+static int              g_fdIemPerfMap  = -1;
+/** The /tmp/jit-<pid>.dump file descriptor, -1 if not open. */
+static int              g_fdIemJitDump  = -1;
+/** The jitdump code index (sequence number). */
+static uint64_t         g_idxIemJitDumpCode = 0;
+
+
+/** Gets the CLOCK_MONOTONIC timestamp perf expects (perf record -k mono). */
+static uint64_t iemPerfTimestamp(void)
+{
+    struct timespec Ts;
+    clock_gettime(CLOCK_MONOTONIC, &Ts);
+    return (uint64_t)Ts.tv_sec * RT_NS_1SEC_64 + (uint64_t)Ts.tv_nsec;
+}
+
+
+/**
+ * @callback_method_impl{FNRTONCE}
+ *
+ * Opens the files.  @a pvUser is the IEMEXECMEM_F_XXX mask of the first EMT
+ * to get here; since it is all per process, the first VM config wins.
+ *
+ * The file names are predictable and /tmp is shared, so the files must be
+ * new: an existing file or a symbolic link planted there makes us give up.
+ */
+static DECLCALLBACK(int32_t) iemPerfInitOnce(void *pvUser)
+{
+    uint32_t const fFlags = (uint32_t)(uintptr_t)pvUser;
+    int rc = RTCritSectInit(&g_IemPerfLock);
+    AssertRCReturn(rc, rc);
+
+    pid_t const uPid = getpid();
+    char        szPath[64];
+    if (fFlags & IEMEXECMEM_F_PERF_MAP)
+    {
+        RTStrPrintf(szPath, sizeof(szPath), "/tmp/perf-%d.map", (int)uPid);
+        g_fdIemPerfMap = open(szPath, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_APPEND | O_CLOEXEC, 0644);
+        if (g_fdIemPerfMap < 0)
+            LogRel(("IEM: Failed to create '%s': errno=%d\n", szPath, errno));
+        else
+            LogRel(("IEM: Writing recompiled code symbols to '%s'\n", szPath));
+    }
+
+    if (fFlags & IEMEXECMEM_F_PERF_JITDUMP)
+    {
+        RTStrPrintf(szPath, sizeof(szPath), "/tmp/jit-%d.dump", (int)uPid);
+        g_fdIemJitDump = open(szPath, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+        if (g_fdIemJitDump >= 0)
+        {
+            IEMPERFJITDUMPHDR Hdr;
+            RT_ZERO(Hdr);
+            Hdr.uMagic     = IEMPERFJITDUMPHDR_MAGIC;
+            Hdr.uVersion   = 1;
+            Hdr.cbHdr      = sizeof(Hdr);
+# if   defined(RT_ARCH_AMD64)
+            Hdr.uElfMach   = 62  /* EM_X86_64 */;
+# elif defined(RT_ARCH_ARM64)
+            Hdr.uElfMach   = 183 /* EM_AARCH64 */;
+# endif
+            Hdr.uPid       = (uint32_t)uPid;
+            Hdr.uTimestamp = iemPerfTimestamp();
+            /* perf record finds the file by this executable mapping of it. */
+            void *pvMarker = MAP_FAILED;
+            if (write(g_fdIemJitDump, &Hdr, sizeof(Hdr)) == (ssize_t)sizeof(Hdr))
+                pvMarker = mmap(NULL, (size_t)sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, g_fdIemJitDump, 0);
+            if (pvMarker == MAP_FAILED)
+            {
+                LogRel(("IEM: Failed to initialize '%s': errno=%d\n", szPath, errno));
+                close(g_fdIemJitDump);
+                g_fdIemJitDump = -1;
+            }
+            else
+                LogRel(("IEM: Writing recompiled code to '%s'\n", szPath));
+            /* The marker mapping is intentionally left in place for the process lifetime. */
+        }
+        else
+            LogRel(("IEM: Failed to create '%s': errno=%d\n", szPath, errno));
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Tells host 'perf' about a newly recompiled TB.
+ *
+ * The symbol is named after the guest PC and TB flags, so 'perf top' or
+ * 'perf report' on the VM process shows which guest code is hot in the
+ * recompiler.  Entries are never removed; perf uses the most recent mapping
+ * for an address, which is good enough since the memory gets reused by other
+ * TBs that will be announced in turn.
+ *
+ * @param   pVCpu   The cross context virtual CPU structure of the calling EMT.
+ * @param   pTb     The native TB, fully converted.
+ */
+DECLHIDDEN(void) iemExecMemAllocatorAnnounceTb(PVMCPUCC pVCpu, PCIEMTB pTb) RT_NOEXCEPT
+{
+    uint8_t const fFlags = IRECM(pVCpu).fExecMemFlags;
+    if (RT_LIKELY(!(fFlags & (IEMEXECMEM_F_PERF_MAP | IEMEXECMEM_F_PERF_JITDUMP))))
+        return;
+    Assert((pTb->fFlags & IEMTB_F_TYPE_MASK) == IEMTB_F_TYPE_NATIVE);
+    int rc = RTOnce(&g_IemPerfOnce, iemPerfInitOnce, (void *)(uintptr_t)fFlags);
+    if (RT_FAILURE(rc))
+        return;
+
+# ifdef IEMNATIVE_WITH_TB_DEBUG_INFO
+    RTGCPTR const    FlatPc = pTb->pDbgInfo ? pTb->pDbgInfo->FlatPc : NIL_RTGCPTR;
+# else
+    RTGCPTR const    FlatPc = pTb->FlatPc;
+# endif
+    uintptr_t const  uCode  = (uintptr_t)pTb->Native.paInstructions;
+    size_t const     cbCode = pTb->Native.cInstructions * sizeof(IEMNATIVEINSTR);
+    char             szName[80];
+    size_t const     cchName = RTStrPrintf(szName, sizeof(szName), "iem-tb:%RGv/%RGp/%#RX32",
+                                           FlatPc, pTb->GCPhysPc, pTb->fFlags & ~IEMTB_F_TYPE_MASK);
+
+    RTCritSectEnter(&g_IemPerfLock);
+
+    if (g_fdIemPerfMap >= 0)
+    {
+        char   szLine[128];
+        size_t cchLine = RTStrPrintf(szLine, sizeof(szLine), "%RX64 %zx %s\n", (uint64_t)uCode, cbCode, szName);
+        if (write(g_fdIemPerfMap, szLine, cchLine) != (ssize_t)cchLine)
+        { /* ignore */ }
+    }
+
+    if (g_fdIemJitDump >= 0)
+    {
+        IEMPERFJITDUMPCODELOAD Rec;
+        Rec.idRecord   = IEMPERFJITDUMP_CODE_LOAD;
+        Rec.cbTotal    = (uint32_t)(sizeof(Rec) + cchName + 1 + cbCode);
+        Rec.uTimestamp = iemPerfTimestamp();
+        Rec.uPid       = (uint32_t)getpid();
+        Rec.uTid       = (uint32_t)syscall(__NR_gettid);
+        Rec.uVma       = uCode;
+        Rec.uCodeAddr  = uCode;
+        Rec.cbCode     = cbCode;
+        Rec.idxCode    = g_idxIemJitDumpCode++;
+        struct iovec aSegs[3] =
+        {
+            { &Rec,                               sizeof(Rec) },
+            { szName,                             cchName + 1 },
+            { (void *)pTb->Native.paInstructions, cbCode      },
+        };
+        if (writev(g_fdIemJitDump, aSegs, RT_ELEMENTS(aSegs)) != (ssize_t)Rec.cbTotal)
+        { /* ignore */ }
+    }
+
+    RTCritSectLeave(&g_IemPerfLock);
+}
+
+#endif /* IEMEXECMEM_WITH_HOST_PERF */
+
 
 #ifdef IN_RING3
 # ifdef RT_OS_WINDOWS
@@ -2003,6 +2443,130 @@ iemExecMemAllocatorInitAndRegisterUnwindInfoForChunk(PVMCPUCC pVCpu, PIEMEXECMEM
 #endif /* IN_RING3 */
 
 
+#ifdef IEMEXECMEM_WITH_DUAL_MAPPING
+
+/**
+ * Maps @a cb bytes of @a fdMem at a 2 MiB aligned address.
+ *
+ * The alignment is required for the kernel to be able to use large pages for
+ * the mapping, regular mmap only guarantees host page alignment.
+ *
+ * @returns Pointer to the mapping on success, NULL on failure.
+ * @param   fdMem       The memory file descriptor.
+ * @param   cb          The size to map (multiple of 2 MiB).
+ * @param   fProt       The PROT_XXX flags for the mapping.
+ */
+static void *iemExecMemAllocatorMapAligned(int fdMem, size_t cb, int fProt)
+{
+    /* Reserve an over-sized range so we can pick an aligned address within it. */
+    size_t const cbReserve = cb + _2M;
+    uint8_t *pbReserve = (uint8_t *)mmap(NULL, cbReserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (pbReserve == (uint8_t *)MAP_FAILED)
+        return NULL;
+
+    uint8_t * const pbAligned = (uint8_t *)RT_ALIGN_PT(pbReserve, _2M, uint8_t *);
+    void *pv = mmap(pbAligned, cb, fProt, MAP_SHARED | MAP_FIXED, fdMem, 0);
+    if (pv == MAP_FAILED)
+    {
+        munmap(pbReserve, cbReserve);
+        return NULL;
+    }
+    Assert(pv == pbAligned);
+
+    /* Release the unused head and tail of the reservation. */
+    if (pbAligned != pbReserve)
+        munmap(pbReserve, (size_t)(pbAligned - pbReserve));
+    size_t const cbTail = (size_t)(pbReserve + cbReserve - (pbAligned + cb));
+    if (cbTail)
+        munmap(pbAligned + cb, cbTail);
+    return pv;
+}
+
+
+/**
+ * Allocates a chunk as two views (RW + RX) of the same anonymous memory file.
+ *
+ * This way the emitter never needs to touch page protections and there are no
+ * writable+executable mappings around.  With IEMEXECMEM_F_LARGE_PAGES we first
+ * try hugetlbfs backing and then fall back on asking for transparent huge pages.
+ *
+ * @returns VBox status code.
+ * @param   pExecMemAllocator   The allocator.
+ * @param   pChunk              The chunk to initialize the mapping members of.
+ */
+static int iemExecMemAllocatorAllocDualMappedChunk(PIEMEXECMEMALLOCATOR pExecMemAllocator, PIEMEXECMEMCHUNK pChunk)
+{
+    size_t const cbChunk     = pExecMemAllocator->cbChunk;
+    bool         fLargePages = RT_BOOL(pExecMemAllocator->fFlags & IEMEXECMEM_F_LARGE_PAGES);
+    for (;;)
+    {
+        int fdMem = (int)syscall(__NR_memfd_create, "vbox-iem-exec", MFD_CLOEXEC | (fLargePages ? MFD_HUGETLB | MFD_HUGE_2MB : 0));
+        if (fdMem < 0)
+        {
+            if (fLargePages)
+            {
+                fLargePages = false;
+                continue;
+            }
+            LogRel(("IEM: memfd_create failed: errno=%d\n", errno));
+            return VERR_NO_EXEC_MEMORY;
+        }
+
+        if (ftruncate(fdMem, (off_t)cbChunk) == 0)
+        {
+            void * const pvRw = iemExecMemAllocatorMapAligned(fdMem, cbChunk, PROT_READ | PROT_WRITE);
+            if (pvRw)
+            {
+                void * const pvRx = iemExecMemAllocatorMapAligned(fdMem, cbChunk, PROT_READ | PROT_EXEC);
+                if (pvRx)
+                {
+                    /* The mappings keep the memory alive. */
+                    close(fdMem);
+                    if (!fLargePages)
+                    {
+                        /* Best effort, only works if shmem THP is set to 'advise' or better. */
+                        madvise(pvRw, cbChunk, MADV_HUGEPAGE);
+                        madvise(pvRx, cbChunk, MADV_HUGEPAGE);
+                    }
+                    pChunk->pvChunkRw   = pvRw;
+                    pChunk->pvChunkRx   = pvRx;
+                    pChunk->fDualMapped = true;
+                    pChunk->fLargePages = fLargePages;
+                    return VINF_SUCCESS;
+                }
+                munmap(pvRw, cbChunk);
+            }
+        }
+        int const iErr = errno;
+        close(fdMem);
+
+        /* hugetlbfs pages are a limited resource, so retry w/o them. */
+        if (!fLargePages)
+        {
+            LogRel(("IEM: Failed to create dual mapped exec memory chunk (%#zx bytes): errno=%d\n", cbChunk, iErr));
+            return VERR_NO_EXEC_MEMORY;
+        }
+        fLargePages = false;
+    }
+}
+
+
+/**
+ * Frees a chunk allocated by iemExecMemAllocatorAllocDualMappedChunk.
+ */
+static void iemExecMemAllocatorFreeDualMappedChunk(PIEMEXECMEMALLOCATOR pExecMemAllocator, PIEMEXECMEMCHUNK pChunk)
+{
+    munmap(pChunk->pvChunkRx, pExecMemAllocator->cbChunk);
+    munmap(pChunk->pvChunkRw, pExecMemAllocator->cbChunk);
+    pChunk->pvChunkRw   = NULL;
+    pChunk->pvChunkRx   = NULL;
+    pChunk->fDualMapped = false;
+    pChunk->fLargePages = false;
+}
+
+#endif /* IEMEXECMEM_WITH_DUAL_MAPPING */
+
+
 /**
  * Adds another chunk to the executable memory allocator.
  *
@@ -2015,6 +2579,25 @@ static int iemExecMemAllocatorGrow(PVMCPUCC pVCpu, PIEMEXECMEMALLOCATOR pExecMem
     uint32_t const idxChunk = pExecMemAllocator->cChunks;
     AssertLogRelReturn(idxChunk < pExecMemAllocator->cMaxChunks, VERR_OUT_OF_RESOURCES);
 
+#ifdef IEMEXECMEM_WITH_DUAL_MAPPING
+    /*
+     * W^X dual mapping, optionally with large pages.
+     */
+    if (pExecMemAllocator->fFlags & IEMEXECMEM_F_DUAL_MAPPING)
+    {
+        int rc = iemExecMemAllocatorAllocDualMappedChunk(pExecMemAllocator, &pExecMemAllocator->aChunks[idxChunk]);
+        if (RT_SUCCESS(rc))
+        {
+            if (pExecMemAllocator->aChunks[idxChunk].fLargePages)
+                pExecMemAllocator->cLargePageChunks++;
+            return iemExecMemAllocatorGrowCommon(pVCpu, pExecMemAllocator, idxChunk);
+        }
+        /* Probably a kernel w/o memfd support. Fall back on regular RWX chunks for good. */
+        LogRel(("IEM: Dual mapped executable memory not available (%Rrc), using regular allocations\n", rc));
+        pExecMemAllocator->fFlags &= ~(uint32_t)(IEMEXECMEM_F_DUAL_MAPPING | IEMEXECMEM_F_LARGE_PAGES);
+    }
+#endif
+
     /* Allocate a chunk. */
 #ifdef RT_OS_DARWIN
     void *pvChunk = RTMemPageAllocEx(pExecMemAllocator->cbChunk, 0);
@@ -2061,18 +2644,32 @@ static int iemExecMemAllocatorGrow(PVMCPUCC pVCpu, PIEMEXECMEMALLOCATOR pExecMem
 
     void *pvChunkRx = (void *)AddrRemapped;
 #else
-    int   rc        = VINF_SUCCESS;
     void *pvChunkRx = pvChunk;
 #endif
 
+    pExecMemAllocator->aChunks[idxChunk].pvChunkRw    = pvChunk;
+    pExecMemAllocator->aChunks[idxChunk].pvChunkRx    = pvChunkRx;
+    return iemExecMemAllocatorGrowCommon(pVCpu, pExecMemAllocator, idxChunk);
+}
+
+
+/**
+ * Worker for iemExecMemAllocatorGrow that adds the chunk once its memory has
+ * been allocated and the pvChunkRw and pvChunkRx members set.
+ *
+ * On failure, the chunk memory is freed again.
+ */
+static int iemExecMemAllocatorGrowCommon(PVMCPUCC pVCpu, PIEMEXECMEMALLOCATOR pExecMemAllocator, uint32_t idxChunk)
+{
+    void * const pvChunk   = pExecMemAllocator->aChunks[idxChunk].pvChunkRw;
+    void * const pvChunkRx = pExecMemAllocator->aChunks[idxChunk].pvChunkRx;
+
     /*
      * Add the chunk.
      *
      * This must be done before the unwind init so windows can allocate
      * memory from the chunk when using the alternative sub-allocator.
      */
-    pExecMemAllocator->aChunks[idxChunk].pvChunkRw    = pvChunk;
-    pExecMemAllocator->aChunks[idxChunk].pvChunkRx    = pvChunkRx;
 #ifdef IN_RING3
     pExecMemAllocator->aChunks[idxChunk].pvUnwindInfo = NULL;
 #endif
@@ -2088,7 +2685,7 @@ static int iemExecMemAllocatorGrow(PVMCPUCC pVCpu, PIEMEXECMEMALLOCATOR pExecMem
     pExecMemAllocator->cbFree      += pExecMemAllocator->cbChunk;
 
     /* If there is a chunk context init callback call it. */
-    rc = iemNativeRecompileAttachExecMemChunkCtx(pVCpu, idxChunk, &pExecMemAllocator->aChunks[idxChunk].pCtx);
+    int rc = iemNativeRecompileAttachExecMemChunkCtx(pVCpu, idxChunk, &pExecMemAllocator->aChunks[idxChunk].pCtx);
 #ifdef IN_RING3
     /*
      * Initialize the unwind information (this cannot really fail atm).
@@ -2107,14 +2704,25 @@ static int iemExecMemAllocatorGrow(PVMCPUCC pVCpu, PIEMEXECMEMALLOCATOR pExecMem
         pExecMemAllocator->cChunks  = idxChunk;
         memset(&pExecMemAllocator->pbmAlloc[pExecMemAllocator->cBitmapElementsPerChunk * idxChunk],
                0xff, sizeof(pExecMemAllocator->pbmAlloc[0]) * pExecMemAllocator->cBitmapElementsPerChunk);
-        pExecMemAllocator->aChunks[idxChunk].pvChunkRw  = NULL;
         pExecMemAllocator->aChunks[idxChunk].cFreeUnits = 0;
 
-# ifdef RT_OS_DARWIN
-        krc = mach_vm_deallocate(mach_task_self(), (mach_vm_address_t)pExecMemAllocator->aChunks[idxChunk].pvChunkRx,
-                                 pExecMemAllocator->cbChunk);
-        Assert(krc == KERN_SUCCESS);
-# endif
+#ifdef IEMEXECMEM_WITH_DUAL_MAPPING
+        if (pExecMemAllocator->aChunks[idxChunk].fDualMapped)
+        {
+            if (pExecMemAllocator->aChunks[idxChunk].fLargePages)
+                pExecMemAllocator->cLargePageChunks--;
+            iemExecMemAllocatorFreeDualMappedChunk(pExecMemAllocator, &pExecMemAllocator->aChunks[idxChunk]);
+            return rc;
+        }
+#endif
+        pExecMemAllocator->aChunks[idxChunk].pvChunkRw  = NULL;
+
+#ifdef RT_OS_DARWIN
+        kern_return_t krc = mach_vm_deallocate(mach_task_self(), (mach_vm_address_t)pvChunkRx, pExecMemAllocator->cbChunk);
+        Assert(krc == KERN_SUCCESS); RT_NOREF(krc);
+#else
+        RT_NOREF(pvChunkRx);
+#endif
 
         RTMemPageFree(pvChunk, pExecMemAllocator->cbChunk);
         return rc;
@@ -2169,6 +2777,13 @@ int iemExecMemAllocatorInit(PVMCPU pVCpu, uint64_t cbMax, uint64_t cbInitial, ui
                 cbChunk = RT_BIT_32(ASMBitLastSetU32(cbChunk));
         }
     }
+#ifdef IEMEXECMEM_WITH_DUAL_MAPPING
+    uint32_t const fFlags = IRECM(pVCpu).fExecMemFlags;
+    if ((fFlags & IEMEXECMEM_F_LARGE_PAGES) && cbChunk < _2M)
+        cbChunk = _2M; /* Must be able to hold at least one large page. */
+#else
+    uint32_t const fFlags = 0;
+#endif
 #if   defined(RT_OS_AMD64)
     Assert(cbChunk <= _2G);
 #elif defined(RT_OS_ARM64)
@@ -2204,6 +2819,8 @@ int iemExecMemAllocatorInit(PVMCPU pVCpu, uint64_t cbMax, uint64_t cbInitial, ui
     pExecMemAllocator->cChunks      = 0;
     pExecMemAllocator->idxChunkHint = 0;
     pExecMemAllocator->cAllocations = 0;
+    pExecMemAllocator->fFlags       = fFlags;
+    pExecMemAllocator->cLargePageChunks = 0;
     pExecMemAllocator->cbTotal      = 0;
     pExecMemAllocator->cbFree       = 0;
     pExecMemAllocator->cbAllocated  = 0;
@@ -2226,6 +2843,10 @@ int iemExecMemAllocatorInit(PVMCPU pVCpu, uint64_t cbMax, uint64_t cbInitial, ui
         pExecMemAllocator->aChunks[i].hMemObj      = NIL_RTR0MEMOBJ;
 #else
         pExecMemAllocator->aChunks[i].pvUnwindInfo = NULL;
+#endif
+#ifdef IEMEXECMEM_WITH_DUAL_MAPPING
+        pExecMemAllocator->aChunks[i].fDualMapped  = false;
+        pExecMemAllocator->aChunks[i].fLargePages  = false;
 #endif
     }
     IRECM(pVCpu).pExecMemAllocatorR3 = pExecMemAllocator;
@@ -2253,6 +2874,8 @@ int iemExecMemAllocatorInit(PVMCPU pVCpu, uint64_t cbMax, uint64_t cbInitial, ui
                      "Maximum number of chunks",                "/IEM/CPU%u/re/ExecMem/cMaxChunks", pVCpu->idCpu);
     STAMR3RegisterFU(pUVM, &pExecMemAllocator->cbChunk,         STAMTYPE_U32, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,
                      "Allocation chunk size",                   "/IEM/CPU%u/re/ExecMem/cbChunk", pVCpu->idCpu);
+    STAMR3RegisterFU(pUVM, &pExecMemAllocator->cLargePageChunks, STAMTYPE_U32, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                     "Chunks backed by 2 MiB hugetlbfs pages",  "/IEM/CPU%u/re/ExecMem/cLargePageChunks", pVCpu->idCpu);
     STAMR3RegisterFU(pUVM, &pExecMemAllocator->cbAllocated,     STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,
                      "Number of bytes current allocated",       "/IEM/CPU%u/re/ExecMem/cbAllocated", pVCpu->idCpu);
     STAMR3RegisterFU(pUVM, &pExecMemAllocator->cbFree,          STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,
@@ -2279,6 +2902,19 @@ int iemExecMemAllocatorInit(PVMCPU pVCpu, uint64_t cbMax, uint64_t cbInitial, ui
 #endif
     STAMR3RegisterFU(pUVM, &pExecMemAllocator->cFruitlessChunkScans, STAMTYPE_U64_RESET, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
                      "Chunks fruitlessly scanned for free space", "/IEM/CPU%u/re/ExecMem/FruitlessChunkScans", pVCpu->idCpu);
+    STAMR3RegisterFU(pUVM, &pExecMemAllocator->StatFragmentedFailures, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                     "Bitmap scan failures despite enough free memory (fragmentation)",
+                     "/IEM/CPU%u/re/ExecMem/FragmentedFailures", pVCpu->idCpu);
+#ifdef IEMEXECMEM_ALT_SUB_WITH_FREE_LISTS
+    STAMR3RegisterFU(pUVM, &pExecMemAllocator->cbFreeListed,    STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,
+                     "Number of bytes sitting in the free lists", "/IEM/CPU%u/re/ExecMem/FreeLists/cbCached", pVCpu->idCpu);
+    STAMR3RegisterFU(pUVM, &pExecMemAllocator->StatFreeListHits, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                     "Allocations satisfied by a free list",    "/IEM/CPU%u/re/ExecMem/FreeLists/Hits", pVCpu->idCpu);
+    STAMR3RegisterFU(pUVM, &pExecMemAllocator->StatFreeListMisses, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                     "Free list sized allocations that had to scan the bitmap", "/IEM/CPU%u/re/ExecMem/FreeLists/Misses", pVCpu->idCpu);
+    STAMR3RegisterFU(pUVM, &pExecMemAllocator->StatFreeListFlushes, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                     "Times the free lists were returned to the bitmap", "/IEM/CPU%u/re/ExecMem/FreeLists/Flushes", pVCpu->idCpu);
+#endif
 
     return VINF_SUCCESS;
 }
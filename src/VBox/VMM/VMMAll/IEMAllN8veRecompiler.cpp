@@ -10095,6 +10095,115 @@ DECLHIDDEN(int) iemNativeRecompileAttachExecMemChunkCtx(PVMCPU pVCpu, uint32_t i
 }
 
 
+#ifdef IEMNATIVE_WITH_LIVENESS_ANALYSIS
+/**
+ * Does the liveness analysis for the calls in @a pTb.
+ *
+ * This is done backwards, filling in pReNative->paLivenessEntries with one
+ * entry per call, where entry N describes what's needed after call N.
+ *
+ * @returns true on success, false if we failed to allocate memory for the
+ *          liveness entries.
+ * @param   pReNative   The native recompiler state.
+ * @param   pTb         The threaded TB to analyse.
+ */
+static bool iemNativeLivenessAnalyze(PIEMRECOMPILERSTATE pReNative, PCIEMTB pTb) RT_NOEXCEPT
+{
+    uint32_t idxCall = pTb->Thrd.cCalls;
+    if (idxCall <= pReNative->cLivenessEntriesAlloc)
+    { /* likely */ }
+    else
+    {
+        uint32_t cAlloc = RT_MAX(pReNative->cLivenessEntriesAlloc, _4K);
+        while (idxCall > cAlloc)
+            cAlloc *= 2;
+        void *pvNew = RTMemRealloc(pReNative->paLivenessEntries, sizeof(pReNative->paLivenessEntries[0]) * cAlloc);
+        AssertReturn(pvNew, false);
+        pReNative->paLivenessEntries     = (PIEMLIVENESSENTRY)pvNew;
+        pReNative->cLivenessEntriesAlloc = cAlloc;
+    }
+    AssertReturn(idxCall > 0, false);
+    PIEMLIVENESSENTRY const paLivenessEntries = pReNative->paLivenessEntries;
+
+    /* The initial (final) entry. */
+    idxCall--;
+    IEM_LIVENESS_RAW_INIT_AS_UNUSED(&paLivenessEntries[idxCall]);
+
+    /* Loop backwards thru the calls and fill in the other entries. */
+    PCIEMTHRDEDCALLENTRY pCallEntry = &pTb->Thrd.paCalls[idxCall];
+    while (idxCall > 0)
+    {
+        PFNIEMNATIVELIVENESSFUNC const pfnLiveness = g_apfnIemNativeLivenessFunctions[pCallEntry->enmFunction];
+        Assert(pfnLiveness);
+        pfnLiveness(pCallEntry, &paLivenessEntries[idxCall], &paLivenessEntries[idxCall - 1]);
+        pCallEntry--;
+        idxCall--;
+    }
+    return true;
+}
+
+
+# ifdef VBOX_VMM_TARGET_X86
+/**
+ * Marks the calls in a threaded TB whose EFLAGS status bit output is dead.
+ *
+ * This is used by the threaded recompiler, which doesn't otherwise get any
+ * liveness information, to set IEMTHREADEDCALLENTRY_F_EFL_DEAD on the calls
+ * producing status flags that are overwritten before anyone looks at them.
+ * Only calls with a twin in g_apfnIemThreadedFunctionsNoEfl are marked, and
+ * iemTbExec will invoke the twin instead of the regular function for these.
+ *
+ * @returns Number of calls marked.
+ * @param   pVCpu   The cross context virtual CPU structure of the calling
+ *                  thread.
+ * @param   pTb     The threaded TB to annotate.
+ */
+DECLHIDDEN(uint32_t) iemNativeLivenessMarkDeadEFlagsCalls(PVMCPUCC pVCpu, PIEMTB pTb) RT_NOEXCEPT
+{
+    /*
+     * We borrow the liveness entry array of the native recompiler state,
+     * allocating the state if this is the first time thru here.
+     */
+    PIEMRECOMPILERSTATE pReNative = IRECM(pVCpu).pNativeRecompilerStateR3;
+    if (RT_LIKELY(pReNative))
+    { /* likely */ }
+    else
+    {
+        pReNative = iemNativeInit(pVCpu, pTb);
+        AssertReturn(pReNative, 0);
+        IRECM(pVCpu).pNativeRecompilerStateR3 = pReNative; /* save it */
+    }
+
+    if (!iemNativeLivenessAnalyze(pReNative, pTb))
+        return 0;
+
+    /*
+     * Entry N holds the state after call N, so we can look at each call
+     * independently.  Any exception or helper call after the instruction
+     * counts as a use of the flags, so this is conservative.  It is also
+     * fine for memory operand variants, as the twins commit EFLAGS at the
+     * same point as the regular functions, i.e. after the memory access.
+     */
+    PCIEMLIVENESSENTRY const  paLivenessEntries = pReNative->paLivenessEntries;
+    PIEMTHRDEDCALLENTRY const paCalls           = pTb->Thrd.paCalls;
+    uint32_t const            cCalls            = pTb->Thrd.cCalls;
+    uint32_t                  cMarked           = 0;
+    for (uint32_t idxCall = 0; idxCall < cCalls; idxCall++)
+    {
+        paCalls[idxCall].fFlags &= ~IEMTHREADEDCALLENTRY_F_EFL_DEAD;
+        if (   g_apfnIemThreadedFunctionsNoEfl[paCalls[idxCall].enmFunction] != NULL
+            && IEMLIVENESS_STATE_ARE_STATUS_EFL_TO_BE_CLOBBERED(&paLivenessEntries[idxCall]))
+        {
+            paCalls[idxCall].fFlags |= IEMTHREADEDCALLENTRY_F_EFL_DEAD;
+            cMarked++;
+        }
+    }
+    return cMarked;
+}
+# endif /* VBOX_VMM_TARGET_X86 */
+#endif /* IEMNATIVE_WITH_LIVENESS_ANALYSIS */
+
+
 /**
  * Recompiles the given threaded TB into a native one.
  *
@@ -10130,38 +10239,7 @@ l_profile_again:
     /*
      * First do liveness analysis.  This is done backwards.
      */
-    {
-        uint32_t idxCall = pTb->Thrd.cCalls;
-        if (idxCall <= pReNative->cLivenessEntriesAlloc)
-        { /* likely */ }
-        else
-        {
-            uint32_t cAlloc = RT_MAX(pReNative->cLivenessEntriesAlloc, _4K);
-            while (idxCall > cAlloc)
-                cAlloc *= 2;
-            void *pvNew = RTMemRealloc(pReNative->paLivenessEntries, sizeof(pReNative->paLivenessEntries[0]) * cAlloc);
-            AssertReturn(pvNew, pTb);
-            pReNative->paLivenessEntries     = (PIEMLIVENESSENTRY)pvNew;
-            pReNative->cLivenessEntriesAlloc = cAlloc;
-        }
-        AssertReturn(idxCall > 0, pTb);
-        PIEMLIVENESSENTRY const paLivenessEntries = pReNative->paLivenessEntries;
-
-        /* The initial (final) entry. */
-        idxCall--;
-        IEM_LIVENESS_RAW_INIT_AS_UNUSED(&paLivenessEntries[idxCall]);
-
-        /* Loop backwards thru the calls and fill in the other entries. */
-        PCIEMTHRDEDCALLENTRY pCallEntry = &pTb->Thrd.paCalls[idxCall];
-        while (idxCall > 0)
-        {
-            PFNIEMNATIVELIVENESSFUNC const pfnLiveness = g_apfnIemNativeLivenessFunctions[pCallEntry->enmFunction];
-            Assert(pfnLiveness);
-            pfnLiveness(pCallEntry, &paLivenessEntries[idxCall], &paLivenessEntries[idxCall - 1]);
-            pCallEntry--;
-            idxCall--;
-        }
-    }
+    AssertReturn(iemNativeLivenessAnalyze(pReNative, pTb), pTb);
 #endif
 
     /*
@@ -10517,6 +10595,14 @@ l_profile_again:
     pTbAllocator->cNativeTbs   += 1;
     Assert(pTbAllocator->cNativeTbs <= pTbAllocator->cTotalTbs);
 
+    /* Let the other EMTs know this block is worth recompiling right away. */
+    iemTbHintsPublish(pVCpu, pTb);
+
+#if defined(RT_OS_LINUX) && defined(IN_RING3)
+    /* Tell host 'perf' about it if configured. */
+    iemExecMemAllocatorAnnounceTb(pVCpu, pTb);
+#endif
+
 #ifdef LOG_ENABLED
     /*
      * Disassemble to the log if enabled.
@@ -665,6 +665,12 @@ class ThreadedFunctionVariation(object):
         'IEM_CIMPL_F_CALLS_AIMPL_WITH_XSTATE':      False,
     };
 
+    ## Status flag producing helpers that have flag-less equivalents in
+    ## IEMAllThrdFuncs-x86.cpp, used for the _NoEfl twins (see getStmtsForNoEflTwin).
+    kdAImplNoEflFns = dict(('iemAImpl_%s_u%u' % (sIns, cBits), 'iemAImpl_%s_u%u_noefl' % (sIns, cBits))
+                           for sIns in ('add', 'adc', 'sub', 'sbb', 'or', 'xor', 'and', 'cmp', 'test')
+                           for cBits in (8, 16, 32, 64));
+
     def __init__(self, oThreadedFunction, sVariation = ksVariation_Default):
         self.oParent        = oThreadedFunction # type: ThreadedFunction
         ##< ksVariation_Xxxx.
@@ -736,6 +742,66 @@ class ThreadedFunctionVariation(object):
         """
         return self.sVariation in ThreadedFunctionVariation.kdVariationsWithEflagsCheckingAndClearing;
 
+    def getNoEflTwinFunctionName(self):
+        return self.getThreadedFunctionName() + '_NoEfl';
+
+    @staticmethod
+    def getNoEflFn(sFn):
+        """ Looks up the flag-less equivalent of helper sFn, returning None if there isn't any. """
+        oMatch = re.match(r'^RT_CONCAT3\(\s*iemAImpl_\s*,\s*(\w+)\s*,\s*_(u\d+)\s*\)$', sFn);
+        if oMatch:
+            sFn = 'iemAImpl_%s_%s' % (oMatch.group(1), oMatch.group(2),);
+        return ThreadedFunctionVariation.kdAImplNoEflFns.get(sFn);
+
+    @staticmethod
+    def findNoEflTwinCalls(aoStmts, aoCalls):
+        """
+        Helper for getStmtsForNoEflTwin that collects the helper calls to replace.
+        Returns False if the statements disqualifies the block.
+        """
+        for oStmt in aoStmts:
+            if oStmt.sName.startswith('IEM_MC_CALL_'):
+                if (   oStmt.sName != 'IEM_MC_CALL_AIMPL_3'
+                    or not isinstance(oStmt, iai.McStmtCall)
+                    or not ThreadedFunctionVariation.getNoEflFn(oStmt.sFn)):
+                    return False;
+                aoCalls.append(oStmt);
+            elif (   oStmt.isCppStmt()
+                  or oStmt.sName.startswith('IEM_MC_IF_EFL_')
+                  or oStmt.sName.startswith('IEM_MC_REF_EFLAGS')
+                  or oStmt.sName.find('CIMPL') >= 0):
+                return False;
+            if isinstance(oStmt, iai.McStmtCond):
+                if not ThreadedFunctionVariation.findNoEflTwinCalls(oStmt.aoIfBranch, aoCalls):
+                    return False;
+                if not ThreadedFunctionVariation.findNoEflTwinCalls(oStmt.aoElseBranch, aoCalls):
+                    return False;
+        return True;
+
+    def getStmtsForNoEflTwin(self):
+        """
+        Produces the statements for the _NoEfl twin of the threaded function, or
+        None if it shouldn't have one.
+
+        The twin is the same code with the status flag producing helper calls
+        replaced by flag-less ones, which the threaded recompiler uses when the
+        liveness analysis says all the status flags will be overwritten before
+        anyone looks at them.  We only do this for blocks where all the helper
+        calls have flag-less equivalents and which don't otherwise look at EFLAGS
+        after fetching them for the call.
+        """
+        aoCalls = [];
+        if not self.findNoEflTwinCalls(self.aoStmtsForThreadedFunction, aoCalls) or not aoCalls:
+            return None;
+
+        aoStmts = copy.deepcopy(self.aoStmtsForThreadedFunction);
+        aoCalls = [];
+        self.findNoEflTwinCalls(aoStmts, aoCalls);
+        for oCall in aoCalls:
+            oCall.sFn = self.getNoEflFn(oCall.sFn);
+            oCall.asParams[oCall.idxFn] = oCall.sFn;
+        return aoStmts;
+
     #
     # Analysis and code morphing.
     #
@@ -3083,6 +3149,7 @@ class IEMThreadedGenerator(object):
         asLines += [
             'extern const PFNIEMTHREADEDFUNC g_apfnIemThreadedFunctions[kIemThreadedFunc_End];',
             'extern uint8_t const            g_acIemThreadedFunctionUsedArgs[kIemThreadedFunc_End];',
+            'extern const PFNIEMTHREADEDFUNC g_apfnIemThreadedFunctionsNoEfl[kIemThreadedFunc_End];',
             '#if defined(IN_RING3) || defined(LOG_ENABLED)',
             'extern const char * const       g_apszIemThreadedFunctions[kIemThreadedFunc_End];',
             '#endif',
@@ -3171,6 +3238,7 @@ class IEMThreadedGenerator(object):
         #
         # Emit the function definitions.
         #
+        dNoEflTwins = {};
         for sVariation in ThreadedFunctionVariation.kasVariationsEmitOrder:
             sVarName = ThreadedFunctionVariation.kdVariationNames[sVariation];
             oOut.write(  '\n'
@@ -3210,6 +3278,23 @@ class IEMThreadedGenerator(object):
 
                     oOut.write('}\n');
 
+                    # The twin w/o status flag calculations, if applicable.
+                    aoStmtsNoEfl = oVariation.getStmtsForNoEflTwin();
+                    if aoStmtsNoEfl:
+                        dNoEflTwins[oVariation.iEnumValue] = oVariation.getNoEflTwinFunctionName();
+                        oOut.write(  '\n'
+                                   + '\n'
+                                   + '/**\n'
+                                   + ' * #%u w/o status flag calculations.\n' % (oVariation.iEnumValue,)
+                                   + ' */\n'
+                                   + 'static IEM_DECL_IEMTHREADEDFUNC_DEF(' + oVariation.getNoEflTwinFunctionName() + ')\n'
+                                   + '{\n');
+                        self.generateFunctionParameterUnpacking(oVariation, oOut, self.kasThreadedParamNames);
+                        if oVariation.cMinParams < g_kcThreadedParams:
+                            oOut.write('    RT_NOREF(' + ', '.join(self.kasThreadedParamNames[oVariation.cMinParams:]) + ');\n');
+                        oOut.write(iai.McStmt.renderCodeForList(aoStmtsNoEfl, cchIndent = 4));
+                        oOut.write('}\n');
+
 
         #
         # Generate the output tables in parallel.
@@ -3246,7 +3331,16 @@ class IEMThreadedGenerator(object):
             '{',
             '    NULL,',
         ];
-        aasTables = (asFuncTable, asArgCntTab, asNameTable, asStatTable,);
+        asNoEflTable = [
+            '/**',
+            ' * Function pointer table for the twins w/o status flag calculations, NULL',
+            ' * if the function hasn\'t got one.',
+            ' */',
+            'PFNIEMTHREADEDFUNC const g_apfnIemThreadedFunctionsNoEfl[kIemThreadedFunc_End] =',
+            '{',
+            '    /*Invalid*/ NULL,',
+        ];
+        aasTables = (asFuncTable, asArgCntTab, asNameTable, asStatTable, asNoEflTable,);
 
         for asTable in aasTables:
             asTable.extend((
@@ -3260,6 +3354,7 @@ class IEMThreadedGenerator(object):
             asArgCntTab.append('    %d, /*BltIn_%s*/' % (cArgs, sFuncNm,));
             asNameTable.append('    "BltIn_%s",' % (sFuncNm,));
             asStatTable.append('    "BltIn/%s",' % (sFuncNm,));
+            asNoEflTable.append('    NULL, /*BltIn_%s*/' % (sFuncNm,));
 
         iThreadedFunction = 1 + len(self.katBltIns);
         for sVariation in ThreadedFunctionVariation.kasVariationsEmitOrder:
@@ -3280,6 +3375,7 @@ class IEMThreadedGenerator(object):
                     asNameTable.append('    /*%4u*/ "%s",' % (iThreadedFunction, sName,));
                     asArgCntTab.append('    /*%4u*/ %d, /*%s*/' % (iThreadedFunction, oVariation.cMinParams, sName,));
                     asStatTable.append('    "%s",' % (oVariation.getThreadedFunctionStatisticsName(),));
+                    asNoEflTable.append('    /*%4u*/ %s,' % (iThreadedFunction, dNoEflTwins.get(iThreadedFunction, 'NULL'),));
 
         for asTable in aasTables:
             asTable.append('};');
@@ -3294,6 +3390,10 @@ class IEMThreadedGenerator(object):
                    + '\n'
                    + '\n');
         oOut.write('\n'.join(asArgCntTab));
+        oOut.write(  '\n'
+                   + '\n'
+                   + '\n');
+        oOut.write('\n'.join(asNoEflTable));
         oOut.write(  '\n'
                    + '\n'
                    + '#if defined(IN_RING3) || defined(LOG_ENABLED)\n');
@@ -68,6 +68,7 @@
 #include <VBox/disopcode-x86-amd64.h>
 #include <iprt/asm-math.h>
 #include <iprt/assert.h>
+#include <iprt/crc.h>
 #include <iprt/mem.h>
 #include <iprt/string.h>
 #include <iprt/sort.h>
@@ -730,6 +731,204 @@ static PIEMTB iemTbCacheLookup(PVMCPUCC pVCpu, PIEMTBCACHE pTbCache,
 }
 
 
+#ifdef VBOX_WITH_IEM_NATIVE_RECOMPILER
+
+/*********************************************************************************************************************************
+*   Translation Block Warm-Start Profile.                                                                                        *
+*********************************************************************************************************************************/
+
+/**
+ * @callback_method_impl{FNRTSORTCMP, Orders IEMTBPROFILEENTRY by the TB key.}
+ *
+ * The opcode CRC is not part of the key, so a binary search using this callback
+ * will find the entry for a given TB regardless of the guest having modified
+ * the code since the profile was written.
+ */
+DECLCALLBACK(int) iemTbProfileCompare(void const *pvElement1, void const *pvElement2, void *pvUser)
+{
+    PCIEMTBPROFILEENTRY const pEntry1 = (PCIEMTBPROFILEENTRY)pvElement1;
+    PCIEMTBPROFILEENTRY const pEntry2 = (PCIEMTBPROFILEENTRY)pvElement2;
+    RT_NOREF(pvUser);
+    if (pEntry1->GCPhysPc != pEntry2->GCPhysPc)
+        return pEntry1->GCPhysPc < pEntry2->GCPhysPc ? -1 : 1;
+    if (pEntry1->fFlags != pEntry2->fFlags)
+        return pEntry1->fFlags < pEntry2->fFlags ? -1 : 1;
+    if (pEntry1->fAttr != pEntry2->fAttr)
+        return pEntry1->fAttr < pEntry2->fAttr ? -1 : 1;
+    return 0;
+}
+
+
+/**
+ * Initializes a warm-start profile entry from the given TB.
+ *
+ * @param   pEntry  The entry to initialize.
+ * @param   pTb     The translation block.
+ */
+DECLHIDDEN(void) iemTbProfileEntryInit(PIEMTBPROFILEENTRY pEntry, PCIEMTB pTb) RT_NOEXCEPT
+{
+    pEntry->GCPhysPc     = pTb->GCPhysPc;
+    pEntry->fFlags       = pTb->fFlags & IEMTB_F_KEY_MASK;
+    pEntry->uOpcodeCrc32 = RTCrc32(pTb->pabOpcodes, pTb->cbOpcodes);
+    pEntry->cbOpcodes    = pTb->cbOpcodes;
+    pEntry->fAttr        = pTb->x86.fAttr;
+    pEntry->uReserved    = 0;
+}
+
+
+/**
+ * Checks a freshly compiled threaded TB against the warm-start profile.
+ *
+ * If the TB was natively recompiled in a previous run and the opcode bytes are
+ * unchanged, the usage count is advanced so that the next lookup triggers
+ * native recompilation.
+ *
+ * @param   pVCpu       The cross context virtual CPU structure of the calling
+ *                      thread.
+ * @param   pTbProfile  The warm-start profile.
+ * @param   pTb         The new threaded translation block.
+ */
+static void iemTbProfileApply(PVMCPUCC pVCpu, PCIEMTBPROFILE pTbProfile, PIEMTB pTb)
+{
+    uint32_t const uRecompileAt = IRECM(pVCpu).uTbNativeRecompileAtUsedCount;
+    if (uRecompileAt > 1)
+    {
+        IEMTBPROFILEENTRY Key;
+        Key.GCPhysPc = pTb->GCPhysPc;
+        Key.fFlags   = pTb->fFlags & IEMTB_F_KEY_MASK;
+        Key.fAttr    = pTb->x86.fAttr;
+
+        uint32_t iStart = 0;
+        uint32_t iEnd   = pTbProfile->cEntries;
+        while (iStart < iEnd)
+        {
+            uint32_t const            i      = iStart + (iEnd - iStart) / 2;
+            PCIEMTBPROFILEENTRY const pEntry = &pTbProfile->aEntries[i];
+            int const                 iDiff  = iemTbProfileCompare(&Key, pEntry, NULL);
+            if (iDiff < 0)
+                iEnd = i;
+            else if (iDiff > 0)
+                iStart = i + 1;
+            else
+            {
+                if (   pEntry->cbOpcodes    == pTb->cbOpcodes
+                    && pEntry->uOpcodeCrc32 == RTCrc32(pTb->pabOpcodes, pTb->cbOpcodes))
+                {
+                    STAM_REL_COUNTER_INC(&pVCpu->iem.s.StatTbProfileHits);
+                    if (pTb->cUsed < uRecompileAt - 1)
+                        pTb->cUsed = uRecompileAt - 1;
+                    Log12(("TB profile hit: %p %RGp LB %#x fl=%#x\n", pTb, pTb->GCPhysPc, pTb->cbOpcodes, pTb->fFlags));
+                }
+                else
+                    STAM_REL_COUNTER_INC(&pVCpu->iem.s.StatTbProfileStale);
+                return;
+            }
+        }
+    }
+}
+
+
+
+/*********************************************************************************************************************************
+*   VM-wide Hot Translation Block Hints.                                                                                         *
+*********************************************************************************************************************************/
+
+/**
+ * Calculates the IEMTBHINTS key for a TB.
+ *
+ * The low half is a CRC-32 of the TB key and opcode bytes, the high half is
+ * the physical PC mixed with the key flags.  The result is never zero.
+ */
+DECLINLINE(uint64_t) iemTbHintsCalcKey(PCIEMTB pTb)
+{
+    uint32_t const fFlags = pTb->fFlags & IEMTB_F_KEY_MASK;
+    uint16_t const fAttr  = pTb->x86.fAttr;
+    uint32_t       uCrc   = RTCrc32Start();
+    uCrc = RTCrc32Process(uCrc, &pTb->GCPhysPc, sizeof(pTb->GCPhysPc));
+    uCrc = RTCrc32Process(uCrc, &fFlags, sizeof(fFlags));
+    uCrc = RTCrc32Process(uCrc, &fAttr, sizeof(fAttr));
+    uCrc = RTCrc32Process(uCrc, pTb->pabOpcodes, pTb->cbOpcodes);
+    uint64_t const uKey = RT_MAKE_U64(RTCrc32Finish(uCrc), (uint32_t)pTb->GCPhysPc ^ fFlags);
+    return uKey ? uKey : 1;
+}
+
+
+/**
+ * Gets the first IEMTBHINTS::au64Keys index to probe for @a uKey.
+ */
+DECL_FORCE_INLINE(uint32_t) iemTbHintsKeyToIdx(PCIEMTBHINTS pHints, uint64_t uKey)
+{
+    return ((uint32_t)uKey ^ (uint32_t)(uKey >> 32)) & pHints->uHashMask;
+}
+
+
+/**
+ * Publishes a freshly recompiled native TB in the VM-wide hint table.
+ *
+ * @param   pVCpu   The cross context virtual CPU structure of the calling
+ *                  thread.
+ * @param   pTb     The native translation block.
+ * @thread  EMT(pVCpu)
+ */
+DECLHIDDEN(void) iemTbHintsPublish(PVMCPUCC pVCpu, PCIEMTB pTb) RT_NOEXCEPT
+{
+    PIEMTBHINTS const pHints = IRECM(pVCpu).pTbCacheR3->pHints;
+    if (!pHints)
+        return;
+    Assert(pHints->uMagic == IEMTBHINTS_MAGIC);
+
+    uint64_t const uKey = iemTbHintsCalcKey(pTb);
+    uint32_t       idx  = iemTbHintsKeyToIdx(pHints, uKey);
+    for (uint32_t cProbes = 0; cProbes < IEMTBHINTS_MAX_PROBES; cProbes++, idx = (idx + 1) & pHints->uHashMask)
+    {
+        uint64_t const uOld = ASMAtomicUoReadU64(&pHints->au64Keys[idx]);
+        if (uOld == uKey)
+            return;
+        if (uOld == 0 && ASMAtomicCmpXchgU64(&pHints->au64Keys[idx], uKey, 0))
+            return;
+        if (ASMAtomicUoReadU64(&pHints->au64Keys[idx]) == uKey) /* lost the race to an identical insert */
+            return;
+    }
+    /* Table full around this slot; ignore it, the hints are just hints. */
+}
+
+
+/**
+ * Checks if another EMT has already natively recompiled the given TB and
+ * advances its usage counter if so.
+ *
+ * @param   pVCpu       The cross context virtual CPU structure of the calling
+ *                      thread.
+ * @param   pTbCache    The TB cache of the calling EMT.
+ * @param   pHints      The VM-wide hint table.
+ * @param   pTb         The new threaded translation block.
+ */
+static void iemTbHintsApply(PVMCPUCC pVCpu, PIEMTBCACHE pTbCache, PCIEMTBHINTS pHints, PIEMTB pTb)
+{
+    uint32_t const uRecompileAt = IRECM(pVCpu).uTbNativeRecompileAtUsedCount;
+    if (uRecompileAt > 1 && pTb->cUsed < uRecompileAt - 1)
+    {
+        uint64_t const uKey = iemTbHintsCalcKey(pTb);
+        uint32_t       idx  = iemTbHintsKeyToIdx(pHints, uKey);
+        for (uint32_t cProbes = 0; cProbes < IEMTBHINTS_MAX_PROBES; cProbes++, idx = (idx + 1) & pHints->uHashMask)
+        {
+            uint64_t const uCur = ASMAtomicUoReadU64(&pHints->au64Keys[idx]);
+            if (uCur == uKey)
+            {
+                STAM_REL_COUNTER_INC(&pTbCache->cHintHits);
+                pTb->cUsed = uRecompileAt - 1;
+                Log12(("TB hint hit: %p %RGp LB %#x fl=%#x\n", pTb, pTb->GCPhysPc, pTb->cbOpcodes, pTb->fFlags));
+                return;
+            }
+            if (!uCur)
+                return;
+        }
+    }
+}
+
+#endif /* VBOX_WITH_IEM_NATIVE_RECOMPILER */
+
+
 /*********************************************************************************************************************************
 *   Translation Block Allocator.
 *********************************************************************************************************************************/
@@ -1850,6 +2049,20 @@ static void iemThreadedTbAdd(PVMCPUCC pVCpu, PIEMTBCACHE pTbCache, PIEMTB pTb)
 {
     iemTbCacheAdd(pVCpu, pTbCache, pTb);
 
+#ifdef VBOX_WITH_IEM_NATIVE_RECOMPILER
+    PCIEMTBPROFILE const pTbProfile = pVCpu->iem.s.pTbProfileR3;
+    if (!pTbProfile)
+    { /* likely */ }
+    else
+        iemTbProfileApply(pVCpu, pTbProfile, pTb);
+
+    PCIEMTBHINTS const pHints = pTbCache->pHints;
+    if (!pHints)
+    { /* likely */ }
+    else
+        iemTbHintsApply(pVCpu, pTbCache, pHints, pTb);
+#endif
+
     STAM_REL_PROFILE_ADD_PERIOD(&pVCpu->iem.s.StatTbInstr,         pTb->cInstructions);
     STAM_REL_PROFILE_ADD_PERIOD(&pVCpu->iem.s.StatTbLookupEntries, pTb->cTbLookupEntries);
     STAM_REL_PROFILE_ADD_PERIOD(&pVCpu->iem.s.StatTbThreadedCalls, pTb->Thrd.cCalls);
@@ -2978,6 +3191,16 @@ iemThreadedCompile(PVMCC pVM, PVMCPUCC pVCpu, RTGCPHYS GCPhysPc, uint32_t fExtra
         pTb->cTbLookupEntries -= 1;
     }
 
+#if defined(VBOX_WITH_IEM_NATIVE_RECOMPILER) && defined(IEMNATIVE_WITH_LIVENESS_ANALYSIS) && defined(VBOX_VMM_TARGET_X86)
+    /*
+     * Run the liveness analysis over the calls and mark the ones producing
+     * EFLAGS status bits that will be overwritten before being used, so
+     * iemTbExec can use the variants skipping the flag calculations.
+     */
+    uint32_t const cEflDeadCalls = iemNativeLivenessMarkDeadEFlagsCalls(pVCpu, pTb);
+    STAM_REL_COUNTER_ADD(&IRECM(pVCpu).pTbCacheR3->cThrdEflDeadCalls, cEflDeadCalls);
+#endif
+
     /*
      * Duplicate the TB into a completed one and link it.
      */
@@ -3553,6 +3776,40 @@ DECL_FORCE_INLINE(PIEMTB *) iemTbGetTbLookupEntryWithRip(PCIEMTB pTb, uint8_t uT
 }
 
 
+/**
+ * Records a TB-to-TB transition in the chain profile.
+ *
+ * @param   pChainProf  The chain profile of the calling EMT.
+ * @param   pTb         The TB about to be executed.
+ */
+static void iemTbChainProfRecord(PIEMTBCHAINPROF pChainProf, PCIEMTB pTb)
+{
+    PCIEMTB const pPrevTb = pChainProf->pPrevTb;
+    pChainProf->pPrevTb = pTb;
+    if (pPrevTb)
+    {
+        STAM_REL_COUNTER_INC(&pChainProf->StatTransitions);
+        uintptr_t const uHash = ((uintptr_t)pPrevTb >> 6) * 31 + ((uintptr_t)pTb >> 6);
+        PIEMTBCHAINEDGE const pEdge = &pChainProf->aEdges[uHash & (IEMTBCHAINPROF_EDGES - 1)];
+        if (pEdge->pFrom == pPrevTb && pEdge->pTo == pTb && pEdge->GCPhysTo == pTb->GCPhysPc)
+        {
+            if (++pEdge->cTransitions == IEMTBCHAINPROF_HOT_COUNT)
+                STAM_REL_COUNTER_INC(&pChainProf->StatHotEdges);
+        }
+        else
+        {
+            if (pEdge->cTransitions)
+                STAM_REL_COUNTER_INC(&pChainProf->StatEvictions);
+            pEdge->pFrom        = pPrevTb;
+            pEdge->pTo          = pTb;
+            pEdge->GCPhysFrom   = pPrevTb->GCPhysPc;
+            pEdge->GCPhysTo     = pTb->GCPhysPc;
+            pEdge->cTransitions = 1;
+        }
+    }
+}
+
+
 /**
  * Executes a translation block.
  *
@@ -3672,10 +3929,22 @@ static IEM_DECL_MSC_GUARD_IGNORE VBOXSTRICTRC iemTbExec(PVMCPUCC pVCpu, PIEMTB p
             AssertCompile(RT_ELEMENTS(pVCpu->iem.s.acThreadedFuncStats) >= kIemThreadedFunc_End);
             pVCpu->iem.s.acThreadedFuncStats[pCallEntry->enmFunction] += 1;
 #endif
-            VBOXSTRICTRC const rcStrict = g_apfnIemThreadedFunctions[pCallEntry->enmFunction](pVCpu,
-                                                                                              pCallEntry->auParams[0],
-                                                                                              pCallEntry->auParams[1],
-                                                                                              pCallEntry->auParams[2]);
+#ifdef VBOX_VMM_TARGET_X86
+            /* Use the variant w/o status flag calculations if they're dead. */
+            PFNIEMTHREADEDFUNC pfnFunction = g_apfnIemThreadedFunctions[pCallEntry->enmFunction];
+            if (!(pCallEntry->fFlags & IEMTHREADEDCALLENTRY_F_EFL_DEAD))
+            { /* likely */ }
+            else
+            {
+                pfnFunction = g_apfnIemThreadedFunctionsNoEfl[pCallEntry->enmFunction];
+                Assert(pfnFunction);
+                STAM_COUNTER_INC(&IRECM(pVCpu).pTbCacheR3->cThrdEflDeadCallsExecuted);
+            }
+#else
+            PFNIEMTHREADEDFUNC const pfnFunction = g_apfnIemThreadedFunctions[pCallEntry->enmFunction];
+#endif
+            VBOXSTRICTRC const rcStrict = pfnFunction(pVCpu, pCallEntry->auParams[0], pCallEntry->auParams[1],
+                                                      pCallEntry->auParams[2]);
             if (RT_LIKELY(   rcStrict == VINF_SUCCESS
                           && ICORE(pVCpu).rcPassUp == VINF_SUCCESS /** @todo this isn't great. */))
                 pCallEntry++;
@@ -3866,6 +4135,8 @@ VMM_INT_DECL(VBOXSTRICTRC) IEMExecRecompiler(PVMCC pVM, PVMCPUCC pVCpu, bool fWa
      * having to call setjmp for each block we're executing.
      */
     PIEMTBCACHE const pTbCache = IRECM(pVCpu).pTbCacheR3;
+    if (pTbCache->pChainProf)
+        pTbCache->pChainProf->pPrevTb = NULL; /* don't chain across run loop invocations */
     for (;;)
     {
         VBOXSTRICTRC rcStrict;
@@ -3880,7 +4151,13 @@ VMM_INT_DECL(VBOXSTRICTRC) IEMExecRecompiler(PVMCC pVM, PVMCPUCC pVCpu, bool fWa
                     uint32_t const fExtraFlags = iemGetTbFlagsForCurrentPc(pVCpu);
                     PIEMTB const   pTb         = iemTbCacheLookup(pVCpu, pTbCache, GCPhysPc, fExtraFlags);
                     if (pTb)
+                    {
+                        if (!pTbCache->pChainProf)
+                        { /* likely */ }
+                        else
+                            iemTbChainProfRecord(pTbCache->pChainProf, pTb);
                         rcStrict = iemTbExec(pVCpu, pTb);
+                    }
                     else
                         rcStrict = iemThreadedCompile(pVM, pVCpu, GCPhysPc, fExtraFlags);
                 }
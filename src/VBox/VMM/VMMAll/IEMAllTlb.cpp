@@ -76,6 +76,9 @@ DECL_FORCE_INLINE(void) iemTlbInvalidateOne(IEMTLB *pTlb)
         unsigned i = RT_ELEMENTS(pTlb->aEntries) / 2;
         while (i-- > 0)
             pTlb->aEntries[i * 2].uTag = 0;
+# ifdef IEMTLB_WITH_L2_LARGE_PAGES
+        iemTlbL2InvalidateAll(pTlb);
+# endif
     }
 
 # ifdef VBOX_VMM_TARGET_X86
@@ -101,6 +104,9 @@ DECL_FORCE_INLINE(void) iemTlbInvalidateOne(IEMTLB *pTlb)
             unsigned i = RT_ELEMENTS(pTlb->aEntries) / 2;
             while (i-- > 0)
                 pTlb->aEntries[i * 2 + 1].uTag = 0;
+#  ifdef IEMTLB_WITH_L2_LARGE_PAGES
+            iemTlbL2InvalidateAll(pTlb);
+#  endif
         }
 
         pTlb->cTlbGlobalLargePageCurLoads    = 0;
@@ -188,6 +194,14 @@ VMM_INT_DECL(void) IEMTlbInvalidatePage(PVMCPUCC pVCpu, RTGCPTR GCPtr)
     IEMTLBTRACE_INVLPG(pVCpu, GCPtr);
 #if defined(IEM_WITH_CODE_TLB_IN_CUR_CTX) || defined(IEM_WITH_DATA_TLB_IN_CUR_CTX)
     Log10(("IEMTlbInvalidatePage: GCPtr=%RGv\n", GCPtr));
+# ifdef IEMTLB_WITH_L2_LARGE_PAGES
+#  ifdef IEM_WITH_CODE_TLB_IN_CUR_CTX
+    iemTlbL2InvalidatePage(&ITLBS_R3(pVCpu).Code, GCPtr);
+#  endif
+#  ifdef IEM_WITH_DATA_TLB_IN_CUR_CTX
+    iemTlbL2InvalidatePage(&ITLBS_R3(pVCpu).Data, GCPtr);
+#  endif
+# endif
     GCPtr = IEMTLB_CALC_TAG_NO_REV(pVCpu, GCPtr);
     Assert(!(GCPtr >> (48 - X86_PAGE_SHIFT)));
     uintptr_t const idx = IEMTLB_TAG_TO_INDEX(GCPtr);
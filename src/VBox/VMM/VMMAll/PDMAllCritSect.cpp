@@ -47,11 +47,9 @@
 #if defined(IN_RING3) || defined(IN_RING0)
 # include <iprt/semaphore.h>
 #endif
-#ifdef IN_RING0
-# include <iprt/time.h>
-#endif
 #if defined(IN_RING3) || defined(IN_RING0)
 # include <iprt/thread.h>
+# include <iprt/time.h>
 #endif
 
 
@@ -149,6 +147,12 @@ DECL_FORCE_INLINE(int) pdmCritSectEnterFirst(PPDMCRITSECT pCritSect, RTNATIVETHR
     else
 # endif
         Log12Func(("%p\n", pCritSect));
+# ifdef IN_RING3
+    if (RT_LIKELY(!pCritSect->s.pProfR3))
+    { /* likely */ }
+    else
+        pdmR3CritSectProfEntered(pCritSect->s.pProfR3, pSrcPos);
+# endif
 
     STAM_PROFILE_ADV_START(&pCritSect->s.StatLocked, l);
     return VINF_SUCCESS;
@@ -197,6 +201,9 @@ static int pdmR3R0CritSectEnterContended(PVMCC pVM, PVMCPU pVCpu, PPDMCRITSECT p
         return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos);
 # ifdef IN_RING3
     STAM_REL_COUNTER_INC(&pCritSect->s.StatContentionR3);
+    PPDMCRITSECTPROF const  pProf          = pCritSect->s.pProfR3;
+    uint64_t const          nsWaitStart    = pProf ? RTTimeNanoTS() : 0;
+    uint64_t const          uOwnerCaller   = pProf ? pProf->uOwnerCaller : 0;
 # else
     STAM_REL_COUNTER_INC(&pCritSect->s.StatContentionRZLock);
 # endif
@@ -279,6 +286,12 @@ static int pdmR3R0CritSectEnterContended(PVMCC pVM, PVMCPU pVCpu, PPDMCRITSECT p
         if (rc == VINF_SUCCESS)
         {
             STAM_REL_PROFILE_STOP(&pCritSect->s.CTX_MID_Z(StatContention,Wait), a);
+# ifdef IN_RING3
+            if (RT_LIKELY(!pProf))
+            { /* likely */ }
+            else
+                pdmR3CritSectProfWaited(pProf, &pProf->WaitHist, pSrcPos, uOwnerCaller, nsWaitStart);
+# endif
             return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos);
         }
 
@@ -608,11 +621,15 @@ DECL_FORCE_INLINE(int) pdmCritSectEnter(PVMCC pVM, PPDMCRITSECT pCritSect, int r
  */
 VMMDECL(DECL_CHECK_RETURN_NOT_R3(int)) PDMCritSectEnter(PVMCC pVM, PPDMCRITSECT pCritSect, int rcBusy)
 {
-#ifndef PDMCRITSECT_STRICT
-    return pdmCritSectEnter(pVM, pCritSect, rcBusy, NULL);
-#else
+#ifdef PDMCRITSECT_STRICT
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
     return pdmCritSectEnter(pVM, pCritSect, rcBusy, &SrcPos);
+#elif defined(IN_RING3)
+    /* The contention profile wants to know who is calling. */
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
+    return pdmCritSectEnter(pVM, pCritSect, rcBusy, pCritSect->s.pProfR3 ? &SrcPos : NULL);
+#else
+    return pdmCritSectEnter(pVM, pCritSect, rcBusy, NULL);
 #endif
 }
 
@@ -642,6 +659,9 @@ PDMCritSectEnterDebug(PVMCC pVM, PPDMCRITSECT pCritSect, int rcBusy, RTHCUINTPTR
 #ifdef PDMCRITSECT_STRICT
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
     return pdmCritSectEnter(pVM, pCritSect, rcBusy, &SrcPos);
+#elif defined(IN_RING3)
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
+    return pdmCritSectEnter(pVM, pCritSect, rcBusy, pCritSect->s.pProfR3 ? &SrcPos : NULL);
 #else
     NOREF(uId); RT_SRC_POS_NOREF();
     return pdmCritSectEnter(pVM, pCritSect, rcBusy, NULL);
@@ -729,11 +749,14 @@ static int pdmCritSectTryEnter(PVMCC pVM, PPDMCRITSECT pCritSect, PCRTLOCKVALSRC
  */
 VMMDECL(DECL_CHECK_RETURN(int)) PDMCritSectTryEnter(PVMCC pVM, PPDMCRITSECT pCritSect)
 {
-#ifndef PDMCRITSECT_STRICT
-    return pdmCritSectTryEnter(pVM, pCritSect, NULL);
-#else
+#ifdef PDMCRITSECT_STRICT
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
     return pdmCritSectTryEnter(pVM, pCritSect, &SrcPos);
+#elif defined(IN_RING3)
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
+    return pdmCritSectTryEnter(pVM, pCritSect, pCritSect->s.pProfR3 ? &SrcPos : NULL);
+#else
+    return pdmCritSectTryEnter(pVM, pCritSect, NULL);
 #endif
 }
 
@@ -760,6 +783,9 @@ PDMCritSectTryEnterDebug(PVMCC pVM, PPDMCRITSECT pCritSect, RTHCUINTPTR uId, RT_
 #ifdef PDMCRITSECT_STRICT
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
     return pdmCritSectTryEnter(pVM, pCritSect, &SrcPos);
+#elif defined(IN_RING3)
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
+    return pdmCritSectTryEnter(pVM, pCritSect, pCritSect->s.pProfR3 ? &SrcPos : NULL);
 #else
     NOREF(uId); RT_SRC_POS_NOREF();
     return pdmCritSectTryEnter(pVM, pCritSect, NULL);
@@ -864,6 +890,11 @@ VMMDECL(int) PDMCritSectLeave(PVMCC pVM, PPDMCRITSECT pCritSect)
 # endif
     Assert(!pCritSect->s.Core.pValidatorRec || pCritSect->s.Core.pValidatorRec->hThread == NIL_RTTHREAD);
 
+    if (RT_LIKELY(!pCritSect->s.pProfR3))
+    { /* likely */ }
+    else
+        pdmR3CritSectProfLeaving(pCritSect->s.pProfR3);
+
 # ifdef PDMCRITSECT_WITH_LESS_ATOMIC_STUFF
     //pCritSect->s.Core.cNestings = 0; /* not really needed */
     pCritSect->s.Core.NativeThreadOwner = NIL_RTNATIVETHREAD;
@@ -47,8 +47,6 @@
 #if defined(IN_RING3) || defined(IN_RING0)
 # include <iprt/semaphore.h>
 # include <iprt/thread.h>
-#endif
-#ifdef IN_RING0
 # include <iprt/time.h>
 #endif
 #ifdef RT_ARCH_AMD64
@@ -399,7 +397,11 @@ static int pdmCritSectRwEnterSharedContended(PVMCC pVM, PVMCPUCC pVCpu, PPDMCRIT
 {
     PSUPDRVSESSION const    pSession          = pVM->pSession;
     SUPSEMEVENTMULTI const  hEventMulti       = (SUPSEMEVENTMULTI)pThis->s.Core.hEvtRead;
-# ifdef IN_RING0
+# ifdef IN_RING3
+    PPDMCRITSECTPROF const  pProf             = pThis->s.pProfR3;
+    uint64_t const          nsWaitStart       = pProf ? RTTimeNanoTS() : 0;
+    uint64_t const          uOwnerCaller      = pProf ? pProf->uOwnerCaller : 0;
+# else  /* IN_RING0 */
     uint64_t const          tsStart           = RTTimeNanoTS();
     uint64_t const          cNsMaxTotalDef    = RT_NS_5MIN;
     uint64_t                cNsMaxTotal       = cNsMaxTotalDef;
@@ -536,6 +538,12 @@ static int pdmCritSectRwEnterSharedContended(PVMCC pVM, PVMCPUCC pVCpu, PPDMCRIT
             /*
              * Decrement the wait count and maybe reset the semaphore (if we're last).
              */
+# ifdef IN_RING3
+            if (RT_LIKELY(!pProf))
+            { /* likely */ }
+            else
+                pdmR3CritSectProfWaited(pProf, &pProf->WaitSharedHist, pSrcPos, uOwnerCaller, nsWaitStart);
+# endif
             return pdmCritSectRwEnterSharedGotItAfterWaiting(pVM, pThis, u64State, pSrcPos, fNoVal, hThreadSelf);
         }
 
@@ -764,11 +772,14 @@ static int pdmCritSectRwEnterShared(PVMCC pVM, PPDMCRITSECTRW pThis, int rcBusy,
  */
 VMMDECL(int) PDMCritSectRwEnterShared(PVMCC pVM, PPDMCRITSECTRW pThis, int rcBusy)
 {
-#if !defined(PDMCRITSECTRW_STRICT) || !defined(IN_RING3)
-    return pdmCritSectRwEnterShared(pVM, pThis, rcBusy, false /*fTryOnly*/, NULL,    false /*fNoVal*/);
-#else
+#if defined(PDMCRITSECTRW_STRICT) && defined(IN_RING3)
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
     return pdmCritSectRwEnterShared(pVM, pThis, rcBusy, false /*fTryOnly*/, &SrcPos, false /*fNoVal*/);
+#elif defined(IN_RING3)
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
+    return pdmCritSectRwEnterShared(pVM, pThis, rcBusy, false /*fTryOnly*/, pThis->s.pProfR3 ? &SrcPos : NULL, false /*fNoVal*/);
+#else
+    return pdmCritSectRwEnterShared(pVM, pThis, rcBusy, false /*fTryOnly*/, NULL,    false /*fNoVal*/);
 #endif
 }
 
@@ -797,11 +808,14 @@ VMMDECL(int) PDMCritSectRwEnterShared(PVMCC pVM, PPDMCRITSECTRW pThis, int rcBus
 VMMDECL(int) PDMCritSectRwEnterSharedDebug(PVMCC pVM, PPDMCRITSECTRW pThis, int rcBusy, RTHCUINTPTR uId, RT_SRC_POS_DECL)
 {
     NOREF(uId); NOREF(pszFile); NOREF(iLine); NOREF(pszFunction);
-#if !defined(PDMCRITSECTRW_STRICT) || !defined(IN_RING3)
-    return pdmCritSectRwEnterShared(pVM, pThis, rcBusy, false /*fTryOnly*/, NULL,    false /*fNoVal*/);
-#else
+#if defined(PDMCRITSECTRW_STRICT) && defined(IN_RING3)
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
     return pdmCritSectRwEnterShared(pVM, pThis, rcBusy, false /*fTryOnly*/, &SrcPos, false /*fNoVal*/);
+#elif defined(IN_RING3)
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
+    return pdmCritSectRwEnterShared(pVM, pThis, rcBusy, false /*fTryOnly*/, pThis->s.pProfR3 ? &SrcPos : NULL, false /*fNoVal*/);
+#else
+    return pdmCritSectRwEnterShared(pVM, pThis, rcBusy, false /*fTryOnly*/, NULL,    false /*fNoVal*/);
 #endif
 }
 
@@ -1142,6 +1156,12 @@ DECL_FORCE_INLINE(int) pdmCritSectRwEnterExclFirst(PPDMCRITSECTRW pThis, PCRTLOC
 #endif
     STAM_REL_COUNTER_INC(&pThis->s.CTX_MID_Z(Stat,EnterExcl));
     STAM_PROFILE_ADV_START(&pThis->s.StatWriteLocked, swl);
+#ifdef IN_RING3
+    if (RT_LIKELY(!pThis->s.pProfR3))
+    { /* likely */ }
+    else
+        pdmR3CritSectProfEntered(pThis->s.pProfR3, pSrcPos);
+#endif
     return VINF_SUCCESS;
 }
 
@@ -1158,7 +1178,11 @@ static int pdmR3R0CritSectRwEnterExclContended(PVMCC pVM, PVMCPUCC pVCpu, PPDMCR
 
     PSUPDRVSESSION const    pSession          = pVM->pSession;
     SUPSEMEVENT const       hEvent            = (SUPSEMEVENT)pThis->s.Core.hEvtWrite;
-# ifdef IN_RING0
+# ifdef IN_RING3
+    PPDMCRITSECTPROF const  pProf             = pThis->s.pProfR3;
+    uint64_t const          nsWaitStart       = pProf ? RTTimeNanoTS() : 0;
+    uint64_t const          uOwnerCaller      = pProf ? pProf->uOwnerCaller : 0;
+# else  /* IN_RING0 */
     uint64_t const          tsStart           = RTTimeNanoTS();
     uint64_t const          cNsMaxTotalDef    = RT_NS_5MIN;
     uint64_t                cNsMaxTotal       = cNsMaxTotalDef;
@@ -1294,7 +1318,15 @@ static int pdmR3R0CritSectRwEnterExclContended(PVMCC pVM, PVMCPUCC pVCpu, PPDMCR
             bool fDone;
             ASMAtomicCmpXchgHandle(&pThis->s.Core.u.s.hNativeWriter, hNativeSelf, NIL_RTNATIVETHREAD, fDone);
             if (fDone)
+            {
+# ifdef IN_RING3
+                if (RT_LIKELY(!pProf))
+                { /* likely */ }
+                else
+                    pdmR3CritSectProfWaited(pProf, &pProf->WaitHist, pSrcPos, uOwnerCaller, nsWaitStart);
+# endif
                 return pdmCritSectRwEnterExclFirst(pThis, pSrcPos, fNoVal, hThreadSelf);
+            }
         }
         AssertMsg(iLoop < 1000, ("%u\n", iLoop)); /* may loop a few times here... */
     }
@@ -1550,11 +1582,14 @@ static int pdmCritSectRwEnterExcl(PVMCC pVM, PPDMCRITSECTRW pThis, int rcBusy, b
  */
 VMMDECL(int) PDMCritSectRwEnterExcl(PVMCC pVM, PPDMCRITSECTRW pThis, int rcBusy)
 {
-#if !defined(PDMCRITSECTRW_STRICT) || !defined(IN_RING3)
-    return pdmCritSectRwEnterExcl(pVM, pThis, rcBusy, false /*fTryAgain*/, NULL,    false /*fNoVal*/);
-#else
+#if defined(PDMCRITSECTRW_STRICT) && defined(IN_RING3)
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
     return pdmCritSectRwEnterExcl(pVM, pThis, rcBusy, false /*fTryAgain*/, &SrcPos, false /*fNoVal*/);
+#elif defined(IN_RING3)
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
+    return pdmCritSectRwEnterExcl(pVM, pThis, rcBusy, false /*fTryAgain*/, pThis->s.pProfR3 ? &SrcPos : NULL, false /*fNoVal*/);
+#else
+    return pdmCritSectRwEnterExcl(pVM, pThis, rcBusy, false /*fTryAgain*/, NULL,    false /*fNoVal*/);
 #endif
 }
 
@@ -1584,11 +1619,14 @@ VMMDECL(int) PDMCritSectRwEnterExcl(PVMCC pVM, PPDMCRITSECTRW pThis, int rcBusy)
 VMMDECL(int) PDMCritSectRwEnterExclDebug(PVMCC pVM, PPDMCRITSECTRW pThis, int rcBusy, RTHCUINTPTR uId, RT_SRC_POS_DECL)
 {
     NOREF(uId); NOREF(pszFile); NOREF(iLine); NOREF(pszFunction);
-#if !defined(PDMCRITSECTRW_STRICT) || !defined(IN_RING3)
-    return pdmCritSectRwEnterExcl(pVM, pThis, rcBusy, false /*fTryAgain*/, NULL,    false /*fNoVal*/);
-#else
+#if defined(PDMCRITSECTRW_STRICT) && defined(IN_RING3)
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
     return pdmCritSectRwEnterExcl(pVM, pThis, rcBusy, false /*fTryAgain*/, &SrcPos, false /*fNoVal*/);
+#elif defined(IN_RING3)
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
+    return pdmCritSectRwEnterExcl(pVM, pThis, rcBusy, false /*fTryAgain*/, pThis->s.pProfR3 ? &SrcPos : NULL, false /*fNoVal*/);
+#else
+    return pdmCritSectRwEnterExcl(pVM, pThis, rcBusy, false /*fTryAgain*/, NULL,    false /*fNoVal*/);
 #endif
 }
 
@@ -1611,11 +1649,14 @@ VMMDECL(int) PDMCritSectRwEnterExclDebug(PVMCC pVM, PPDMCRITSECTRW pThis, int rc
  */
 VMMDECL(int) PDMCritSectRwTryEnterExcl(PVMCC pVM, PPDMCRITSECTRW pThis)
 {
-#if !defined(PDMCRITSECTRW_STRICT) || !defined(IN_RING3)
-    return pdmCritSectRwEnterExcl(pVM, pThis, VERR_SEM_BUSY, true /*fTryAgain*/, NULL,    false /*fNoVal*/);
-#else
+#if defined(PDMCRITSECTRW_STRICT) && defined(IN_RING3)
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
     return pdmCritSectRwEnterExcl(pVM, pThis, VERR_SEM_BUSY, true /*fTryAgain*/, &SrcPos, false /*fNoVal*/);
+#elif defined(IN_RING3)
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
+    return pdmCritSectRwEnterExcl(pVM, pThis, VERR_SEM_BUSY, true /*fTryAgain*/, pThis->s.pProfR3 ? &SrcPos : NULL, false /*fNoVal*/);
+#else
+    return pdmCritSectRwEnterExcl(pVM, pThis, VERR_SEM_BUSY, true /*fTryAgain*/, NULL,    false /*fNoVal*/);
 #endif
 }
 
@@ -1641,11 +1682,14 @@ VMMDECL(int) PDMCritSectRwTryEnterExcl(PVMCC pVM, PPDMCRITSECTRW pThis)
 VMMDECL(int) PDMCritSectRwTryEnterExclDebug(PVMCC pVM, PPDMCRITSECTRW pThis, RTHCUINTPTR uId, RT_SRC_POS_DECL)
 {
     NOREF(uId); NOREF(pszFile); NOREF(iLine); NOREF(pszFunction);
-#if !defined(PDMCRITSECTRW_STRICT) || !defined(IN_RING3)
-    return pdmCritSectRwEnterExcl(pVM, pThis, VERR_SEM_BUSY, true /*fTryAgain*/, NULL,    false /*fNoVal*/);
-#else
+#if defined(PDMCRITSECTRW_STRICT) && defined(IN_RING3)
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
     return pdmCritSectRwEnterExcl(pVM, pThis, VERR_SEM_BUSY, true /*fTryAgain*/, &SrcPos, false /*fNoVal*/);
+#elif defined(IN_RING3)
+    RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
+    return pdmCritSectRwEnterExcl(pVM, pThis, VERR_SEM_BUSY, true /*fTryAgain*/, pThis->s.pProfR3 ? &SrcPos : NULL, false /*fNoVal*/);
+#else
+    return pdmCritSectRwEnterExcl(pVM, pThis, VERR_SEM_BUSY, true /*fTryAgain*/, NULL,    false /*fNoVal*/);
 #endif
 }
 
@@ -1742,6 +1786,12 @@ static int pdmCritSectRwLeaveExclWorker(PVMCC pVM, PPDMCRITSECTRW pThis, bool fN
             return rc9;
     }
 #endif
+#ifdef IN_RING3
+    if (RT_LIKELY(!pThis->s.pProfR3))
+    { /* likely */ }
+    else
+        pdmR3CritSectProfLeaving(pThis->s.pProfR3);
+#endif
 
 
 #ifdef RTASM_HAVE_CMP_WRITE_U128
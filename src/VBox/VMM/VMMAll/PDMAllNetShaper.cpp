@@ -39,9 +39,53 @@
 #include <iprt/asm-math.h>
 
 
+/**
+ * Re-fills the buckets of a bandwidth group.
+ *
+ * @returns Number of bytes available in the bucket.
+ * @param   pGroup          The group, caller owns the lock.
+ * @param   nsNow           The current RTTimeSystemNanoTS value.
+ * @param   pcMilliPkts     Where to return the number of milli-packets
+ *                          available in the packet bucket.
+ */
+DECLINLINE(uint32_t) pdmNsBwGroupRefill(PPDMNSBWGROUP pGroup, uint64_t nsNow, uint32_t *pcMilliPkts)
+{
+    /*
+     * Note! We limit the cTokensAdded calculation to 1 second, since it's really
+     *       pointless to calculate much beyond PDM_NETSHAPER_MAX_LATENCY (100ms)
+     *       let alone 1 sec.  This makes it possible to use ASMMultU64ByU32DivByU32
+     *       as the cNsDelta is less than 30 bits wide now, which means we don't get
+     *       into overflow issues when multiplying two 64-bit values.  The bucket
+     *       sizes are capped at one second worth of tokens for the same reason.
+     */
+    uint64_t const cNsDelta64   = nsNow - pGroup->tsUpdatedLast;
+    uint32_t const cNsDelta     = cNsDelta64 < RT_NS_1SEC ? (uint32_t)cNsDelta64 : RT_NS_1SEC;
+
+    uint64_t const cTokensAdded = ASMMultU64ByU32DivByU32(pGroup->cbPerSecMax, cNsDelta, RT_NS_1SEC);
+    uint32_t const cTokens      = (uint32_t)RT_MIN(pGroup->cbBucket, cTokensAdded + pGroup->cbTokensLast);
+
+    uint32_t const cPktsPerSec  = pGroup->cPacketsPerSecMax;
+    if (cPktsPerSec)
+    {
+        uint64_t const cMilliPktsAdded = ASMMultU64ByU32DivByU32((uint64_t)cPktsPerSec * 1000, cNsDelta, RT_NS_1SEC);
+        *pcMilliPkts = (uint32_t)RT_MIN(pGroup->cMilliPktBucket, cMilliPktsAdded + pGroup->cMilliPktTokensLast);
+    }
+    else
+        *pcMilliPkts = UINT32_MAX;
+
+    Log3(("pdmNsBwGroupRefill/%s: cTokens=%#x cTokensAdded=%#RX64 cMilliPkts=%#x\n",
+          pGroup->szName, cTokens, cTokensAdded, *pcMilliPkts));
+    return cTokens;
+}
+
+
 /**
  * Obtain bandwidth in a bandwidth group.
  *
+ * The transfer must be granted by the group the filter is attached to and by
+ * all its ancestors.  Each group with a limit grants it when it has enough
+ * byte tokens and, if it limits the packet rate, a packet token.
+ *
  * @returns True if bandwidth was allocated, false if not.
  * @param   pVM             The cross context VM structure.
  * @param   pFilter         Pointer to the filter that allocates bandwidth.
@@ -58,82 +102,107 @@ VMM_INT_DECL(bool) PDMNetShaperAllocateBandwidth(PVMCC pVM, PPDMNSFILTER pFilter
     uint32_t iGroup = ASMAtomicUoReadU32(&pFilter->iGroup);
     if (iGroup != 0)
     {
-        if (iGroup <= RT_MIN(pVM->pdm.s.cNsGroups, RT_ELEMENTS(pVM->pdm.s.aNsGroups)))
+        /*
+         * Lock the group and its ancestors, leaf first.  The hierarchy has been
+         * checked to be free of loops and not deeper than PDM_NETSHAPER_MAX_DEPTH
+         * when the groups were configured, and it never changes afterwards.
+         */
+        uint32_t const cGroups = RT_MIN(pVM->pdm.s.cNsGroups, RT_ELEMENTS(pVM->pdm.s.aNsGroups));
+        PPDMNSBWGROUP  apChain[PDM_NETSHAPER_MAX_DEPTH];
+        uint32_t       cChain = 0;
+        while (iGroup != 0)
         {
+            AssertMsgBreak(iGroup <= cGroups && cChain < RT_ELEMENTS(apChain), ("Invalid iGroup=%d\n", iGroup));
             PPDMNSBWGROUP pGroup = &pVM->pdm.s.aNsGroups[iGroup - 1];
             int rc = PDMCritSectEnter(pVM, &pGroup->Lock, VINF_TRY_AGAIN);
-            if (rc == VINF_SUCCESS)
+            if (rc != VINF_SUCCESS)
+            {
+                if (rc == VINF_TRY_AGAIN) /* (accounted for by the critsect stats) */
+                    Log2(("pdmNsAllocateBandwidth/%s: allowed - lock contention\n", pGroup->szName));
+                else
+                    PDM_CRITSECT_RELEASE_ASSERT_RC(pVM, &pGroup->Lock, rc);
+                break;
+            }
+            apChain[cChain++] = pGroup;
+            iGroup = pGroup->iParent;
+        }
+
+        if (iGroup == 0)
+        {
+            /*
+             * Re-fill the buckets and check that every limiting group can grant
+             * the transfer.  Groups without any limit are just accounted.
+             */
+            uint64_t const nsNow = RTTimeSystemNanoTS();
+            uint32_t       acbTokens[PDM_NETSHAPER_MAX_DEPTH];
+            uint32_t       acMilliPkts[PDM_NETSHAPER_MAX_DEPTH];
+            for (uint32_t i = 0; i < cChain; i++)
             {
-                uint64_t const cbPerSecMax = pGroup->cbPerSecMax;
-                if (cbPerSecMax > 0)
+                PPDMNSBWGROUP const pGroup = apChain[i];
+                if (   pGroup->cbPerSecMax == 0
+                    && pGroup->cPacketsPerSecMax == 0)
+                    continue;
+
+                acbTokens[i] = pdmNsBwGroupRefill(pGroup, nsNow, &acMilliPkts[i]);
+                if (   (pGroup->cbPerSecMax > 0 && cbTransfer > acbTokens[i])
+                    || acMilliPkts[i] < 1000)
                 {
-                    /*
-                     * Re-fill the bucket first
-                     *
-                     * Note! We limit the cTokensAdded calculation to 1 second, since it's really
-                     *       pointless to calculate much beyond PDM_NETSHAPER_MAX_LATENCY (100ms)
-                     *       let alone 1 sec.  This makes it possible to use ASMMultU64ByU32DivByU32
-                     *       as the cNsDelta is less than 30 bits wide now, which means we don't get
-                     *       into overflow issues when multiplying two 64-bit values.
-                     */
-                    uint64_t const nsNow        = RTTimeSystemNanoTS();
-                    uint64_t const cNsDelta     = nsNow - pGroup->tsUpdatedLast;
-                    uint64_t const cTokensAdded = cNsDelta < RT_NS_1SEC
-                                                ? ASMMultU64ByU32DivByU32(cbPerSecMax, (uint32_t)cNsDelta, RT_NS_1SEC)
-                                                : cbPerSecMax;
-                    uint32_t const cbBucket     = pGroup->cbBucket;
-                    uint32_t const cbTokensLast = pGroup->cbTokensLast;
-                    uint32_t const cTokens      = (uint32_t)RT_MIN(cbBucket, cTokensAdded + cbTokensLast);
-
-                    /*
-                     * Allowed?
-                     */
-                    if (cbTransfer <= cTokens)
-                    {
-                        pGroup->cbTokensLast  = cTokens - (uint32_t)cbTransfer;
-                        pGroup->tsUpdatedLast = nsNow;
-                        Log2(("pdmNsAllocateBandwidth/%s: allowed - cbTransfer=%#zx cTokens=%#x cTokensAdded=%#x\n",
-                              pGroup->szName, cbTransfer, cTokens, cTokensAdded));
-                    }
-                    else
+                    Log2(("pdmNsAllocateBandwidth/%s: refused - cbTransfer=%#zx cTokens=%#x cMilliPkts=%#x\n",
+                          pGroup->szName, cbTransfer, acbTokens[i], acMilliPkts[i]));
+                    ASMAtomicIncU64(&pGroup->cTotalChokings);
+                    fAllowed = false;
+                    break;
+                }
+            }
+
+            if (fAllowed)
+            {
+                for (uint32_t i = 0; i < cChain; i++)
+                {
+                    PPDMNSBWGROUP const pGroup = apChain[i];
+                    if (   pGroup->cbPerSecMax != 0
+                        || pGroup->cPacketsPerSecMax != 0)
                     {
-                        /*
-                         * No, we're choked.  Arm the unchoke timer for the next period.
-                         * Just do this on a simple PDM_NETSHAPER_MAX_LATENCY clock granularity.
-                         * ASSUMES the timer uses millisecond resolution clock.
-                         */
-                        ASMAtomicWriteBool(&pFilter->fChoked, true);
-                        if (ASMAtomicCmpXchgBool(&pVM->pdm.s.fNsUnchokeTimerArmed, true, false))
-                        {
-                            Assert(TMTimerGetFreq(pVM, pVM->pdm.s.hNsUnchokeTimer) == RT_MS_1SEC);
-                            uint64_t const msNow    = TMTimerGet(pVM, pVM->pdm.s.hNsUnchokeTimer);
-                            uint64_t const msExpire = (msNow / PDM_NETSHAPER_MAX_LATENCY + 1) * PDM_NETSHAPER_MAX_LATENCY;
-                            rc = TMTimerSet(pVM, pVM->pdm.s.hNsUnchokeTimer, msExpire);
-                            AssertRC(rc);
-
-                            Log2(("pdmNsAllocateBandwidth/%s: refused - cbTransfer=%#zx cTokens=%#x cTokensAdded=%#x cMsExpire=%u\n",
-                                  pGroup->szName, cbTransfer, cTokens, cTokensAdded, msExpire - msNow));
-                        }
+                        if (pGroup->cbPerSecMax > 0)
+                            pGroup->cbTokensLast    = acbTokens[i] - (uint32_t)cbTransfer;
                         else
-                            Log2(("pdmNsAllocateBandwidth/%s: refused - cbTransfer=%#zx cTokens=%#x cTokensAdded=%#x\n",
-                                  pGroup->szName, cbTransfer, cTokens, cTokensAdded));
-                        ASMAtomicIncU64(&pGroup->cTotalChokings);
-                        fAllowed = false;
+                            pGroup->cbTokensLast    = pGroup->cbBucket;
+                        if (pGroup->cPacketsPerSecMax > 0)
+                            pGroup->cMilliPktTokensLast = acMilliPkts[i] - 1000;
+                        pGroup->tsUpdatedLast = nsNow;
                     }
+                    pGroup->cbTotalTransferred += cbTransfer;
+                    pGroup->cTotalPackets++;
                 }
-                else
-                    Log2(("pdmNsAllocateBandwidth/%s: disabled\n", pGroup->szName));
-
-                rc = PDMCritSectLeave(pVM, &pGroup->Lock);
-                AssertRCSuccess(rc);
+                Log2(("pdmNsAllocateBandwidth/%s: allowed - cbTransfer=%#zx cGroups=%u\n",
+                      apChain[0]->szName, cbTransfer, cChain));
             }
-            else if (rc == VINF_TRY_AGAIN) /* (accounted for by the critsect stats) */
-                Log2(("pdmNsAllocateBandwidth/%s: allowed - lock contention\n", pGroup->szName));
             else
-                PDM_CRITSECT_RELEASE_ASSERT_RC(pVM, &pGroup->Lock, rc);
+            {
+                /*
+                 * We're choked.  Arm the unchoke timer for the next period.
+                 * Just do this on a simple PDM_NETSHAPER_MAX_LATENCY clock granularity.
+                 * ASSUMES the timer uses millisecond resolution clock.
+                 */
+                if (!ASMAtomicXchgBool(&pFilter->fChoked, true))
+                    ASMAtomicWriteU64(&pFilter->nsChoked, nsNow);
+                if (ASMAtomicCmpXchgBool(&pVM->pdm.s.fNsUnchokeTimerArmed, true, false))
+                {
+                    Assert(TMTimerGetFreq(pVM, pVM->pdm.s.hNsUnchokeTimer) == RT_MS_1SEC);
+                    uint64_t const msNow    = TMTimerGet(pVM, pVM->pdm.s.hNsUnchokeTimer);
+                    uint64_t const msExpire = (msNow / PDM_NETSHAPER_MAX_LATENCY + 1) * PDM_NETSHAPER_MAX_LATENCY;
+                    int rc = TMTimerSet(pVM, pVM->pdm.s.hNsUnchokeTimer, msExpire);
+                    AssertRC(rc);
+                    Log2(("pdmNsAllocateBandwidth: armed unchoke timer - cMsExpire=%u\n", msExpire - msNow));
+                }
+            }
+        }
+
+        while (cChain-- > 0)
+        {
+            int rc = PDMCritSectLeave(pVM, &apChain[cChain]->Lock);
+            AssertRCSuccess(rc);
         }
-        else
-            AssertMsgFailed(("Invalid iGroup=%d\n", iGroup));
     }
     return fAllowed;
 }
@@ -41,6 +41,7 @@
 #include <iprt/asm.h>
 #include <iprt/assert.h>
 #include <iprt/string.h>
+#include <iprt/time.h>
 
 
 /*********************************************************************************************************************************
@@ -74,11 +75,13 @@
     uint32_t const cbItem   = (a_pVM)->pdmr0.s.aQueues[(a_hQueue)].cbItem; \
     uint32_t const cItems   = (a_pVM)->pdmr0.s.aQueues[(a_hQueue)].cItems; \
     uint32_t const offItems = (a_pVM)->pdmr0.s.aQueues[(a_hQueue)].offItems; \
+    uint32_t const fFlags   = (a_pVM)->pdmr0.s.aQueues[(a_hQueue)].fFlags; \
     \
     /* paranoia^2: */ \
     AssertReturn(pQueue->cbItem == cbItem, pQueue->rcOkay = VERR_INTERNAL_ERROR_3); \
     AssertReturn(pQueue->cItems == cItems, pQueue->rcOkay = VERR_INTERNAL_ERROR_3); \
     AssertReturn(pQueue->offItems == offItems, pQueue->rcOkay = VERR_INTERNAL_ERROR_3); \
+    AssertReturn(pQueue->fFlags == fFlags, pQueue->rcOkay = VERR_INTERNAL_ERROR_3); \
     \
     PDMQUEUE_HANDLE_TO_VARS_RETURN_COMMON(PDMQUEUE_MAX_ITEM_SIZE, PDMQUEUE_MAX_TOTAL_SIZE_R0)
 
@@ -103,6 +106,7 @@
     uint32_t const cbItem   = pQueue->cbItem; \
     uint32_t const cItems   = pQueue->cItems; \
     uint32_t const offItems = pQueue->offItems; \
+    uint32_t const fFlags   = pQueue->fFlags; \
     \
     PDMQUEUE_HANDLE_TO_VARS_RETURN_COMMON(PDMQUEUE_MAX_ITEM_SIZE, PDMQUEUE_MAX_TOTAL_SIZE_R3)
 
@@ -112,17 +116,17 @@
 /**
  * Commmon function for initializing the shared queue structure.
  */
-void pdmQueueInit(PPDMQUEUE pQueue, uint32_t cbBitmap, uint32_t cbItem, uint32_t cItems,
+void pdmQueueInit(PPDMQUEUE pQueue, uint32_t cbBitmap, uint32_t cbItem, uint32_t cItems, uint32_t fFlags,
                   const char *pszName, PDMQUEUETYPE enmType, RTR3PTR pfnCallback, RTR3PTR pvOwner)
 {
-    Assert(cbBitmap * 8 >= cItems);
+    Assert(cbBitmap == PDMQUEUE_CALC_BITMAP_SIZE(cItems, fFlags));
 
     pQueue->u32Magic            = PDMQUEUE_MAGIC;
     pQueue->cbItem              = cbItem;
     pQueue->cItems              = cItems;
     pQueue->offItems            = RT_UOFFSETOF(PDMQUEUE, bmAlloc) + cbBitmap;
     pQueue->rcOkay              = VINF_SUCCESS;
-    pQueue->u32Padding          = 0;
+    pQueue->fFlags              = fFlags;
     pQueue->hTimer              = NIL_TMTIMERHANDLE;
     pQueue->cMilliesInterval    = 0;
     pQueue->enmType             = enmType;
@@ -130,16 +134,79 @@ void pdmQueueInit(PPDMQUEUE pQueue, uint32_t cbBitmap, uint32_t cbItem, uint32_t
     pQueue->u.Gen.pvOwner       = pvOwner;
     RTStrCopy(pQueue->szName, sizeof(pQueue->szName), pszName);
     pQueue->iPending            = UINT32_MAX;
+    pQueue->hConsumerTask       = NIL_PDMTASKHANDLE;
+    pQueue->StatRingLatency.Core.cTicksMin = UINT64_MAX;
+    pQueue->uRingProducer       = 0;
+    pQueue->uRingConsumer       = 0;
     RT_BZERO(pQueue->bmAlloc, cbBitmap);
-    ASMBitSetRange(pQueue->bmAlloc, 0, cItems);
 
     uint8_t *pbItem = (uint8_t *)&pQueue->bmAlloc[0] + cbBitmap;
-    while (cItems-- > 0)
+    if (!(fFlags & PDMQUEUE_F_RING))
     {
-        ((PPDMQUEUEITEMCORE)pbItem)->u64View = UINT64_C(0xfeedfeedfeedfeed);
+        ASMBitSetRange(pQueue->bmAlloc, 0, cItems);
+        while (cItems-- > 0)
+        {
+            ((PPDMQUEUEITEMCORE)pbItem)->u64View = UINT64_C(0xfeedfeedfeedfeed);
+
+            /* next */
+            pbItem += cbItem;
+        }
+    }
+    else
+    {
+        /* The sequence number of a free slot is the position it will be allocated at. */
+        for (uint32_t i = 0; i < cItems; i++)
+        {
+            ((PPDMQUEUEITEMCORE)pbItem)->u64View = i;
+
+            /* next */
+            pbItem += cbItem;
+        }
+    }
+}
 
-        /* next */
-        pbItem += cbItem;
+
+/**
+ * Allocates a slot in a PDMQUEUE_F_RING queue.
+ *
+ * @returns VBox status code.
+ * @param   pQueue      The queue.
+ * @param   pbItems     Where the items area starts.
+ * @param   cbItem      The item size.
+ * @param   cItems      The number of items.
+ * @param   ppNew       Where to return the item pointer on success.
+ */
+static int pdmQueueRingAlloc(PPDMQUEUE pQueue, uint8_t *pbItems, uint32_t cbItem, uint32_t cItems, PPDMQUEUEITEMCORE *ppNew)
+{
+    uint32_t cFullScans = 0;
+    uint64_t uPos       = ASMAtomicUoReadU64(&pQueue->uRingProducer);
+    for (;;)
+    {
+        PPDMQUEUEITEMCORE const pSlot = (PPDMQUEUEITEMCORE)&pbItems[(uint32_t)(uPos % cItems) * cbItem];
+        uint64_t const          uSeq  = ASMAtomicReadU64(&pSlot->u64View);
+        if (uSeq == uPos)
+        {
+            /* The slot is free, try claim it by advancing the producer position. */
+            if (ASMAtomicCmpXchgExU64(&pQueue->uRingProducer, uPos + 1, uPos, &uPos))
+            {
+                *ppNew = pSlot;
+                return VINF_SUCCESS;
+            }
+        }
+        else if ((int64_t)(uSeq - uPos) < 0)
+        {
+            /* The consumer hasn't got to this slot yet, so the ring is full. */
+            if (++cFullScans >= 16)
+            {
+                STAM_REL_COUNTER_INC(&pQueue->StatAllocFailures);
+                return VERR_OUT_OF_RESOURCES;
+            }
+            ASMNopPause();
+            uPos = ASMAtomicUoReadU64(&pQueue->uRingProducer);
+        }
+        else
+            /* Another producer got the slot, reload the position. */
+            uPos = ASMAtomicUoReadU64(&pQueue->uRingProducer);
     }
 }
 
@@ -165,6 +232,9 @@ VMMDECL(int) PDMQueueAllocEx(PVMCC pVM, PDMQUEUEHANDLE hQueue, void *pvOwner, PP
     *ppNew = NULL;
     PDMQUEUE_HANDLE_TO_VARS_RETURN(pVM, hQueue, pvOwner);
 
+    if (fFlags & PDMQUEUE_F_RING)
+        return pdmQueueRingAlloc(pQueue, (uint8_t *)pQueue + offItems, cbItem, cItems, ppNew);
+
     /*
      * Do the allocation.
      */
@@ -263,21 +333,38 @@ VMMDECL(int) PDMQueueInsert(PVMCC pVM, PDMQUEUEHANDLE hQueue, void *pvOwner, PPD
     AssertReturn(iInsert < cItems, VERR_INVALID_PARAMETER);
     AssertReturn(iInsert * cbItem == offInsert, VERR_INVALID_PARAMETER);
 
-    AssertReturn(ASMBitTest(pQueue->bmAlloc, iInsert) == false, VERR_INVALID_PARAMETER);
+    if (!(fFlags & PDMQUEUE_F_RING))
+    {
+        AssertReturn(ASMBitTest(pQueue->bmAlloc, iInsert) == false, VERR_INVALID_PARAMETER);
 
-    /*
-     * Append the item to the pending list.
-     */
-    for (;;)
+        /*
+         * Append the item to the pending list.
+         */
+        for (;;)
+        {
+            uint32_t const iOldPending = ASMAtomicUoReadU32(&pQueue->iPending);
+            pInsert->iNext = iOldPending;
+            if (ASMAtomicCmpXchgU32(&pQueue->iPending, iInsert, iOldPending))
+                break;
+            ASMNopPause();
+        }
+    }
+    else
     {
-        uint32_t const iOldPending = ASMAtomicUoReadU32(&pQueue->iPending);
-        pInsert->iNext = iOldPending;
-        if (ASMAtomicCmpXchgU32(&pQueue->iPending, iInsert, iOldPending))
-            break;
-        ASMNopPause();
+        /*
+         * Publish the slot to the consumer by bumping its sequence number.  The
+         * slot is ours, so the sequence number is still the allocation position.
+         */
+        uint64_t const uSeq = ASMAtomicUoReadU64(&pInsert->u64View);
+        AssertReturn(uSeq % cItems == iInsert, VERR_INVALID_PARAMETER);
+        AssertReturn(uSeq < ASMAtomicUoReadU64(&pQueue->uRingProducer), VERR_INVALID_PARAMETER);
+        ((uint64_t volatile *)&pQueue->bmAlloc[0])[iInsert] = RTTimeNanoTS();
+        ASMAtomicWriteU64(&pInsert->u64View, uSeq + 1);
     }
 
-    if (pQueue->hTimer == NIL_TMTIMERHANDLE)
+    if (pQueue->hConsumerTask != NIL_PDMTASKHANDLE)
+        PDMTaskTriggerInternal(pVM, pQueue->hConsumerTask);
+    else if (pQueue->hTimer == NIL_TMTIMERHANDLE)
         pdmQueueSetFF(pVM);
     STAM_REL_COUNTER_INC(&pQueue->StatInsert);
     STAM_STATS({ ASMAtomicIncU32(&pQueue->cStatPending); });
@@ -286,6 +373,62 @@ VMMDECL(int) PDMQueueInsert(PVMCC pVM, PDMQUEUEHANDLE hQueue, void *pvOwner, PPD
 }
 
 
+/**
+ * Frees an item allocated by PDMQueueAlloc that will not be inserted.
+ *
+ * This is for error paths between PDMQueueAlloc and PDMQueueInsert.  Slots of
+ * PDMQUEUE_F_RING queues are claimed in order, so an item that is neither
+ * inserted nor freed stops the consumer at its slot for good.  A freed ring
+ * slot is therefore published like an inserted one, marked so the consumer
+ * skips it.  Once passed to this function the item must not be touched.
+ *
+ * @returns VBox status code.
+ * @param   pVM         Pointer to the cross context VM structure w/ ring-0.
+ * @param   hQueue      The queue handle.
+ * @param   pvOwner     The queue owner.
+ * @param   pItem       The item to free.
+ * @thread  Any thread.
+ */
+VMMDECL(int) PDMQueueFree(PVMCC pVM, PDMQUEUEHANDLE hQueue, void *pvOwner, PPDMQUEUEITEMCORE pItem)
+{
+    /*
+     * Validate and translate input.
+     */
+    PDMQUEUE_HANDLE_TO_VARS_RETURN(pVM, hQueue, pvOwner);
+
+    uint8_t * const pbItems = (uint8_t *)pQueue + offItems;
+    uintptr_t const offItem = (uintptr_t)pItem - (uintptr_t)pbItems;
+    uintptr_t const iItem   = offItem / cbItem;
+    AssertReturn(iItem < cItems, VERR_INVALID_PARAMETER);
+    AssertReturn(iItem * cbItem == offItem, VERR_INVALID_PARAMETER);
+
+    if (!(fFlags & PDMQUEUE_F_RING))
+    {
+        /* Back into the allocation bitmap. */
+        AssertReturn(ASMBitTest(pQueue->bmAlloc, iItem) == false, VERR_INVALID_PARAMETER);
+        pItem->u64View = UINT64_C(0xfeedfeedfeedfeed);
+        ASMAtomicBitSet(pQueue->bmAlloc, (int32_t)iItem);
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Publish a tombstone.  Items inserted after this one may already be
+     * waiting behind it, so get the queue flushed like an insert does.
+     */
+    uint64_t const uSeq = ASMAtomicUoReadU64(&pItem->u64View);
+    AssertReturn(uSeq % cItems == iItem, VERR_INVALID_PARAMETER);
+    AssertReturn(uSeq < ASMAtomicUoReadU64(&pQueue->uRingProducer), VERR_INVALID_PARAMETER);
+    ((uint64_t volatile *)&pQueue->bmAlloc[0])[iItem] = PDMQUEUE_RING_TS_FREED;
+    ASMAtomicWriteU64(&pItem->u64View, uSeq + 1);
+
+    if (pQueue->hConsumerTask != NIL_PDMTASKHANDLE)
+        PDMTaskTriggerInternal(pVM, pQueue->hConsumerTask);
+    else if (pQueue->hTimer == NIL_TMTIMERHANDLE)
+        pdmQueueSetFF(pVM);
+    return VINF_SUCCESS;
+}
+
+
 /**
  * Schedule the queue for flushing (processing) if necessary.
  *
@@ -303,14 +446,26 @@ VMMDECL(int) PDMQueueFlushIfNecessary(PVMCC pVM, PDMQUEUEHANDLE hQueue, void *pv
      * Validate input.
      */
     PDMQUEUE_HANDLE_TO_VARS_RETURN(pVM, hQueue, pvOwner);
-    RT_NOREF(offItems);
 
     /*
      * Check and maybe flush.
      */
-    if (ASMAtomicUoReadU32(&pQueue->iPending) != UINT32_MAX)
+    bool fPending;
+    if (!(fFlags & PDMQUEUE_F_RING))
+        fPending = ASMAtomicUoReadU32(&pQueue->iPending) != UINT32_MAX;
+    else
     {
-        pdmQueueSetFF(pVM);
+        /* The slot at the consumer position is ready when its sequence number is one past the position. */
+        uint64_t const          uPos  = ASMAtomicUoReadU64(&pQueue->uRingConsumer);
+        PPDMQUEUEITEMCORE const pSlot = (PPDMQUEUEITEMCORE)((uint8_t *)pQueue + offItems + (uint32_t)(uPos % cItems) * cbItem);
+        fPending = ASMAtomicUoReadU64(&pSlot->u64View) == uPos + 1;
+    }
+    if (fPending)
+    {
+        if (pQueue->hConsumerTask != NIL_PDMTASKHANDLE)
+            PDMTaskTriggerInternal(pVM, pQueue->hConsumerTask);
+        else
+            pdmQueueSetFF(pVM);
         return VINF_SUCCESS;
     }
     return VINF_NO_CHANGE;
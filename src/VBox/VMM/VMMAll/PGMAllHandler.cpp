@@ -643,7 +643,7 @@ int pgmHandlerPhysicalExDeregister(PVMCC pVM, PPGMPHYSHANDLER pPhysHandler)
             pgmHandlerPhysicalResetRamFlags(pVM, pPhysHandler);
             if (VM_IS_NEM_ENABLED(pVM))
                 pgmHandlerPhysicalDeregisterNotifyNEM(pVM, pPhysHandler);
-            pVM->pgm.s.idxLastPhysHandler = 0;
+            RT_ZERO(pVM->pgm.s.aidxPhysHandlerCache);
 
             pPhysHandler->Key     = NIL_RTGCPHYS;
             pPhysHandler->KeyLast = NIL_RTGCPHYS;
@@ -733,7 +733,7 @@ VMMDECL(int)  PGMHandlerPhysicalDeregister(PVMCC pVM, RTGCPHYS GCPhys)
         pgmHandlerPhysicalResetRamFlags(pVM, pRemoved);
         if (VM_IS_NEM_ENABLED(pVM))
             pgmHandlerPhysicalDeregisterNotifyNEM(pVM, pRemoved);
-        pVM->pgm.s.idxLastPhysHandler = 0;
+        RT_ZERO(pVM->pgm.s.aidxPhysHandlerCache);
 
         pRemoved->Key = NIL_RTGCPHYS;
         rc = pVM->VMCC_CTX(pgm).s.PhysHandlerAllocator.freeNode(pRemoved);
@@ -2000,6 +2000,7 @@ void pgmPhysInvalidatePageMapTLB(PVMCC pVM, bool fInRendezvous)
 {
     PGM_LOCK_VOID(pVM);
     STAM_COUNTER_INC(&pVM->pgm.s.Stats.StatPageMapTlbFlushes);
+    ASMAtomicIncU32(&pVM->pgm.s.uPhysMapGen);
 
     /* Clear the R3 & R0 TLBs completely. */
     for (unsigned i = 0; i < RT_ELEMENTS(pVM->pgm.s.PhysTlbR0.aEntries); i++)
@@ -2051,6 +2052,7 @@ void pgmPhysInvalidatePageMapTLBEntry(PVMCC pVM, RTGCPHYS GCPhys)
     PGM_LOCK_ASSERT_OWNER(pVM);
 
     STAM_COUNTER_INC(&pVM->pgm.s.Stats.StatPageMapTlbFlushEntry);
+    ASMAtomicIncU32(&pVM->pgm.s.uPhysMapGen);
 
     unsigned const idx = PGM_PAGER3MAPTLB_IDX(GCPhys);
 
@@ -2212,6 +2214,17 @@ int pgmPhysAllocPage(PVMCC pVM, PPGMPAGE pPage, RTGCPHYS GCPhys)
             rc = pgmPhysAllocLargePage(pVM, GCPhys);
             if (rc == VINF_SUCCESS)
                 return rc;
+            if (rc != VERR_PGM_INVALID_LARGE_PAGE_RANGE)
+            {
+                /* The host couldn't give us a large page; make the fallback visible. */
+                STAM_REL_COUNTER_INC(&pVM->pgm.s.StatLargePageFallback);
+                if (!pVM->pgm.s.fLargePageFallbackLogged)
+                {
+                    pVM->pgm.s.fLargePageFallbackLogged = true;
+                    LogRel(("PGM: Falling back on small pages at %RGp (rc=%Rrc); see /PGM/LargePage/Fallback for further occurrences.\n",
+                            GCPhysBase, rc));
+                }
+            }
         }
         /* Mark the base as type page table, so we don't check over and over again. */
         PGM_PAGE_SET_PDE_TYPE(pVM, pBasePage, PGM_PAGE_PDE_TYPE_PT);
@@ -2276,6 +2289,7 @@ int pgmPhysAllocPage(PVMCC pVM, PPGMPAGE pPage, RTGCPHYS GCPhys)
         Log(("PGM: Replaced shared page %#x at %RGp with %#x / %RHp\n", PGM_PAGE_GET_PAGEID(pPage),
              GCPhys, pVM->pgm.s.aHandyPages[iHandyPage].idPage, HCPhys));
         STAM_COUNTER_INC(&pVM->pgm.s.Stats.CTX_MID_Z(Stat,PageReplaceShared));
+        STAM_REL_COUNTER_INC(&pVM->pgm.s.StatSharedPageBroken);
         pVM->pgm.s.cSharedPages--;
 
         /* Grab the address of the page so we can make a copy later on. (safe) */
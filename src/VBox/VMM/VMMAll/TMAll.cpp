@@ -350,6 +350,46 @@ VMM_INT_DECL(void) TMNotifyEndOfHalt(PVMCPUCC pVCpu)
 }
 
 
+/**
+ * Notification that the EMT spent some time blocking in a ring-0 halt.
+ *
+ * Ring-0 halts are not bracketed by TMNotifyStartOfHalt/TMNotifyEndOfHalt, so
+ * this is how the steal time accounting learns that the VCPU wasn't runnable.
+ *
+ * @param   pVCpu       The cross context virtual CPU structure.
+ * @param   cNsHalted   The number of nanoseconds spent blocking.
+ * @thread  EMT(pVCpu)
+ */
+VMM_INT_DECL(void) TMNotifyRing0Halt(PVMCPUCC pVCpu, uint64_t cNsHalted)
+{
+#ifndef VBOX_WITHOUT_NS_ACCOUNTING
+    pVCpu->tm.s.cNsHaltedRing0 += cNsHalted;
+#else
+    RT_NOREF(pVCpu, cNsHalted);
+#endif
+}
+
+
+/**
+ * Gets the steal time of the given virtual CPU, i.e. the time it was runnable
+ * but not scheduled by the host.
+ *
+ * This is the value as of the last TMR3CpuUpdateStealTime call.
+ *
+ * @returns Steal time in nanoseconds.
+ * @param   pVCpu       The cross context virtual CPU structure.
+ */
+VMM_INT_DECL(uint64_t) TMCpuGetStealTime(PVMCPUCC pVCpu)
+{
+#ifndef VBOX_WITHOUT_NS_ACCOUNTING
+    return ASMAtomicUoReadU64(&pVCpu->tm.s.cNsSteal);
+#else
+    RT_NOREF(pVCpu);
+    return 0;
+#endif
+}
+
+
 /**
  * Raise the timer force action flag and notify the dedicated timer EMT.
  *
@@ -373,6 +413,30 @@ DECLINLINE(void) tmScheduleNotify(PVMCC pVM)
 }
 
 
+#ifdef IN_RING3
+/**
+ * Notifies the halted timer EMT that a queue got a new, earlier head.
+ *
+ * Used in tickless mode (TM::fTickless) where the timer EMT sleeps until the
+ * deadline of the next expiring timer without any host timer ticking, so it
+ * needs to recalculate the deadline whenever another thread shortens it.
+ *
+ * @param   pVM         The cross context VM structure.
+ */
+static void tmTicklessNotifyNewHead(PVMCC pVM)
+{
+    VMCPUID const idCpu = pVM->tm.s.idTimerCpu;
+    AssertReturnVoid(idCpu < pVM->cCpus);
+    if (VMMGetCpuId(pVM) != idCpu)
+    {
+        PVMCPUCC pVCpuDst = VMCC_GET_CPU(pVM, idCpu);
+        STAM_COUNTER_INC(&pVM->tm.s.StatTicklessWakeups);
+        VMR3NotifyCpuFFU(pVCpuDst->pUVCpu, VMNOTIFYFF_FLAGS_DONE_REM); /* Only wakes it up if halted. */
+    }
+}
+#endif
+
+
 /**
  * Schedule the queue which was changed.
  */
@@ -472,6 +536,10 @@ DECLINLINE(bool) tmTimerTryWithLink(PTMTIMERQUEUECC pQueueCC, PTMTIMERQUEUE pQue
 /**
  * Links a timer into the active list of a timer queue.
  *
+ * The list is kept sorted by expire time.  Inserting at either end is O(1),
+ * otherwise we walk from whichever end is closer to @a u64Expire (judged by
+ * the expire times of the head and tail timers).
+ *
  * @param   pVM             The cross context VM structure.
  * @param   pQueueCC        The current context queue (same as @a pQueue for
  *                          ring-3).
@@ -487,44 +555,84 @@ DECL_FORCE_INLINE(void) tmTimerQueueLinkActive(PVMCC pVM, PTMTIMERQUEUECC pQueue
     Assert(pTimer->idxNext == UINT32_MAX);
     Assert(pTimer->idxPrev == UINT32_MAX);
     Assert(pTimer->enmState == TMTIMERSTATE_ACTIVE || pQueue->enmClock != TMCLOCK_VIRTUAL_SYNC); /* (active is not a stable state) */
-    RT_NOREF(pVM);
+    STAM_PROFILE_START(&pVM->tm.s.StatLinkActive, a);
+    pQueue->cActive++;
 
-    PTMTIMER pCur = tmTimerQueueGetHead(pQueueCC, pQueue);
-    if (pCur)
+    PTMTIMER const pHead = tmTimerQueueGetHead(pQueueCC, pQueue);
+    PTMTIMER const pTail = tmTimerQueueGetTail(pQueueCC, pQueue);
+    if (!pHead)
+    {
+        Assert(!pTail);
+        tmTimerQueueSetHead(pQueueCC, pQueue, pTimer);
+        tmTimerQueueSetTail(pQueueCC, pQueue, pTimer);
+        ASMAtomicWriteU64(&pQueue->u64Expire, u64Expire);
+        DBGFTRACE_U64_TAG2(pVM, u64Expire, "tmTimerQueueLinkActive empty", pTimer->szName);
+#ifdef IN_RING3
+        if (pVM->tm.s.fTickless)
+            tmTicklessNotifyNewHead(pVM);
+#endif
+    }
+    else if (pTail->u64Expire <= u64Expire)
+    {
+        /* Append (same expire times are kept in FIFO order). */
+        Assert(pTail->idxNext == UINT32_MAX);
+        tmTimerSetNext(pQueueCC, pTail, pTimer);
+        tmTimerSetPrev(pQueueCC, pTimer, pTail);
+        tmTimerQueueSetTail(pQueueCC, pQueue, pTimer);
+        DBGFTRACE_U64_TAG2(pVM, u64Expire, "tmTimerQueueLinkActive tail", pTimer->szName);
+    }
+    else if (pHead->u64Expire > u64Expire)
+    {
+        /* New head. */
+        tmTimerSetNext(pQueueCC, pTimer, pHead);
+        tmTimerSetPrev(pQueueCC, pHead, pTimer);
+        tmTimerQueueSetHead(pQueueCC, pQueue, pTimer);
+        ASMAtomicWriteU64(&pQueue->u64Expire, u64Expire);
+        DBGFTRACE_U64_TAG2(pVM, u64Expire, "tmTimerQueueLinkActive head", pTimer->szName);
+#ifdef IN_RING3
+        if (pVM->tm.s.fTickless)
+            tmTicklessNotifyNewHead(pVM);
+#endif
+    }
+    else
     {
-        for (;; pCur = tmTimerGetNext(pQueueCC, pCur))
+        /*
+         * Somewhere in the middle: head <= u64Expire < tail.  Find the first
+         * timer that expires after us and insert in front of it.
+         */
+        PTMTIMER pCur;
+        uint32_t cSteps = 0;
+        if (u64Expire - pHead->u64Expire <= pTail->u64Expire - u64Expire)
         {
-            if (pCur->u64Expire > u64Expire)
+            pCur = tmTimerGetNext(pQueueCC, pHead);
+            while (pCur->u64Expire <= u64Expire)
             {
-                const PTMTIMER pPrev = tmTimerGetPrev(pQueueCC, pCur);
-                tmTimerSetNext(pQueueCC, pTimer, pCur);
-                tmTimerSetPrev(pQueueCC, pTimer, pPrev);
-                if (pPrev)
-                    tmTimerSetNext(pQueueCC, pPrev, pTimer);
-                else
-                {
-                    tmTimerQueueSetHead(pQueueCC, pQueue, pTimer);
-                    ASMAtomicWriteU64(&pQueue->u64Expire, u64Expire);
-                    DBGFTRACE_U64_TAG2(pVM, u64Expire, "tmTimerQueueLinkActive head", pTimer->szName);
-                }
-                tmTimerSetPrev(pQueueCC, pCur, pTimer);
-                return;
+                pCur = tmTimerGetNext(pQueueCC, pCur);
+                cSteps++;
             }
-            if (pCur->idxNext == UINT32_MAX)
+        }
+        else
+        {
+            PTMTIMER pPrev = tmTimerGetPrev(pQueueCC, pTail);
+            pCur = pTail;
+            while (pPrev->u64Expire > u64Expire)
             {
-                tmTimerSetNext(pQueueCC, pCur, pTimer);
-                tmTimerSetPrev(pQueueCC, pTimer, pCur);
-                DBGFTRACE_U64_TAG2(pVM, u64Expire, "tmTimerQueueLinkActive tail", pTimer->szName);
-                return;
+                pCur  = pPrev;
+                pPrev = tmTimerGetPrev(pQueueCC, pPrev);
+                cSteps++;
             }
         }
+        STAM_COUNTER_ADD(&pVM->tm.s.aStatLinkActiveSteps[pQueue->enmClock], cSteps);
+        RT_NOREF(cSteps);
+
+        PTMTIMER const pPrev = tmTimerGetPrev(pQueueCC, pCur);
+        Assert(pPrev);
+        tmTimerSetNext(pQueueCC, pTimer, pCur);
+        tmTimerSetPrev(pQueueCC, pTimer, pPrev);
+        tmTimerSetNext(pQueueCC, pPrev, pTimer);
+        tmTimerSetPrev(pQueueCC, pCur, pTimer);
     }
-    else
-    {
-        tmTimerQueueSetHead(pQueueCC, pQueue, pTimer);
-        ASMAtomicWriteU64(&pQueue->u64Expire, u64Expire);
-        DBGFTRACE_U64_TAG2(pVM, u64Expire, "tmTimerQueueLinkActive empty", pTimer->szName);
-    }
+    STAM_PROFILE_STOP(&pVM->tm.s.StatLinkActive, a);
 }
 
 
@@ -263,6 +263,8 @@ static FNVMXEXITHANDLER            vmxHCExitMonitor;
 static FNVMXEXITHANDLER            vmxHCExitPause;
 static FNVMXEXITHANDLERNSRC        vmxHCExitTprBelowThreshold;
 static FNVMXEXITHANDLER            vmxHCExitApicAccess;
+static FNVMXEXITHANDLER            vmxHCExitVirtEoi;
+static FNVMXEXITHANDLER            vmxHCExitApicWrite;
 static FNVMXEXITHANDLER            vmxHCExitEptViolation;
 static FNVMXEXITHANDLER            vmxHCExitEptMisconfig;
 static FNVMXEXITHANDLER            vmxHCExitRdtscp;
@@ -652,7 +654,7 @@ static const struct CLANG11NOTHROWWEIRDNESS { PFNVMXEXITHANDLER pfn; } g_aVMExit
     /* 42  UNDEFINED                        */  { vmxHCExitErrUnexpected },
     /* 43  VMX_EXIT_TPR_BELOW_THRESHOLD     */  { vmxHCExitTprBelowThreshold },
     /* 44  VMX_EXIT_APIC_ACCESS             */  { vmxHCExitApicAccess },
-    /* 45  VMX_EXIT_VIRTUALIZED_EOI         */  { vmxHCExitErrUnexpected },
+    /* 45  VMX_EXIT_VIRTUALIZED_EOI         */  { vmxHCExitVirtEoi },
     /* 46  VMX_EXIT_GDTR_IDTR_ACCESS        */  { vmxHCExitErrUnexpected },
     /* 47  VMX_EXIT_LDTR_TR_ACCESS          */  { vmxHCExitErrUnexpected },
     /* 48  VMX_EXIT_EPT_VIOLATION           */  { vmxHCExitEptViolation },
@@ -671,7 +673,7 @@ static const struct CLANG11NOTHROWWEIRDNESS { PFNVMXEXITHANDLER pfn; } g_aVMExit
 #endif
     /* 54  VMX_EXIT_WBINVD                  */  { vmxHCExitWbinvd },
     /* 55  VMX_EXIT_XSETBV                  */  { vmxHCExitXsetbv },
-    /* 56  VMX_EXIT_APIC_WRITE              */  { vmxHCExitErrUnexpected },
+    /* 56  VMX_EXIT_APIC_WRITE              */  { vmxHCExitApicWrite },
     /* 57  VMX_EXIT_RDRAND                  */  { vmxHCExitErrUnexpected },
     /* 58  VMX_EXIT_INVPCID                 */  { vmxHCExitInvpcid },
     /* 59  VMX_EXIT_VMFUNC                  */  { vmxHCExitErrUnexpected },
@@ -1642,8 +1644,15 @@ static int vmxHCExportGuestEntryExitCtls(PVMCPUCC pVCpu, PCVMXTRANSIENT pVmxTran
                 fVal |= VMX_EXIT_CTLS_SAVE_PREEMPT_TIMER;
             }
 
-            /* Don't acknowledge external interrupts on VM-exit. We want to let the host do that. */
-            Assert(!(fVal & VMX_EXIT_CTLS_ACK_EXT_INT));
+            /* Don't acknowledge external interrupts on VM-exit, we want to let the host do that.
+               Except with posted-interrupt processing which requires it, see hmR0VmxDispatchHostIntr(). */
+            if (pVmcsInfo->u32PinCtls & VMX_PIN_CTLS_POSTED_INT)
+            {
+                Assert(g_HmMsrs.u.vmx.ExitCtls.n.allowed1 & VMX_EXIT_CTLS_ACK_EXT_INT);
+                fVal |= VMX_EXIT_CTLS_ACK_EXT_INT;
+            }
+            else
+                Assert(!(fVal & VMX_EXIT_CTLS_ACK_EXT_INT));
 
             /** @todo VMX_EXIT_CTLS_LOAD_PERF_MSR,
              *        VMX_EXIT_CTLS_SAVE_PAT_MSR,
@@ -5955,6 +5964,8 @@ DECLINLINE(VBOXSTRICTRC) vmxHCHandleExit(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTrans
         case VMX_EXIT_RDTSC:                   VMEXIT_CALL_RET(0, vmxHCExitRdtsc(pVCpu, pVmxTransient));
         case VMX_EXIT_RDTSCP:                  VMEXIT_CALL_RET(0, vmxHCExitRdtscp(pVCpu, pVmxTransient));
         case VMX_EXIT_APIC_ACCESS:             VMEXIT_CALL_RET(0, vmxHCExitApicAccess(pVCpu, pVmxTransient));
+        case VMX_EXIT_VIRTUALIZED_EOI:         VMEXIT_CALL_RET(0, vmxHCExitVirtEoi(pVCpu, pVmxTransient));
+        case VMX_EXIT_APIC_WRITE:              VMEXIT_CALL_RET(0, vmxHCExitApicWrite(pVCpu, pVmxTransient));
         case VMX_EXIT_XCPT_OR_NMI:             VMEXIT_CALL_RET(0, vmxHCExitXcptOrNmi(pVCpu, pVmxTransient));
         case VMX_EXIT_MOV_CRX:                 VMEXIT_CALL_RET(0, vmxHCExitMovCRx(pVCpu, pVmxTransient));
         case VMX_EXIT_EXT_INT:                 VMEXIT_CALL_RET(0, vmxHCExitExtInt(pVCpu, pVmxTransient));
@@ -6019,10 +6030,8 @@ DECLINLINE(VBOXSTRICTRC) vmxHCHandleExit(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTrans
         case VMX_EXIT_ERR_MSR_LOAD:
         case VMX_EXIT_ERR_MACHINE_CHECK:
         case VMX_EXIT_PML_FULL:
-        case VMX_EXIT_VIRTUALIZED_EOI:
         case VMX_EXIT_GDTR_IDTR_ACCESS:
         case VMX_EXIT_LDTR_TR_ACCESS:
-        case VMX_EXIT_APIC_WRITE:
         case VMX_EXIT_RDRAND:
         case VMX_EXIT_RSM:
         case VMX_EXIT_VMFUNC:
@@ -7754,8 +7763,7 @@ HMVMX_EXIT_DECL vmxHCExitXcptOrNmi(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTransient)
     Assert(VMX_EXIT_INT_INFO_IS_VALID(pVmxTransient->uExitIntInfo));
 
     PCVMXVMCSINFO pVmcsInfo = pVmxTransient->pVmcsInfo;
-    Assert(   !(pVmcsInfo->u32ExitCtls & VMX_EXIT_CTLS_ACK_EXT_INT)
-           && uExitIntType != VMX_EXIT_INT_INFO_TYPE_EXT_INT);
+    Assert(uExitIntType != VMX_EXIT_INT_INFO_TYPE_EXT_INT); /* Even with VMX_EXIT_CTLS_ACK_EXT_INT, these are VMX_EXIT_EXT_INT. */
     NOREF(pVmcsInfo);
 
     VBOXSTRICTRC rcStrict;
@@ -8434,10 +8442,7 @@ HMVMX_EXIT_NSRC_DECL vmxHCExitErrUnexpected(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTr
      *    See Intel spec. 27.1 "Architectural State Before A VM Exit".
      *
      * VMX_EXIT_PML_FULL:
-     * VMX_EXIT_VIRTUALIZED_EOI:
-     * VMX_EXIT_APIC_WRITE:
-     *    We do not currently support any of these features and thus they are all unexpected
-     *    VM-exits.
+     *    We do not currently support this feature and thus it is an unexpected VM-exit.
      *
      * VMX_EXIT_GDTR_IDTR_ACCESS:
      * VMX_EXIT_LDTR_TR_ACCESS:
@@ -9339,6 +9344,58 @@ HMVMX_EXIT_DECL vmxHCExitApicAccess(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTransient)
 }
 
 
+/**
+ * VM-exit handler for virtualized EOI (VMX_EXIT_VIRTUALIZED_EOI). Conditional
+ * VM-exit.
+ *
+ * With virtual-interrupt delivery we get these for EOIs of the vectors in the
+ * EOI-exit bitmap, i.e. level-triggered interrupts.  The CPU has already done
+ * the EOI virtualization, we complete it in the APIC.
+ */
+HMVMX_EXIT_DECL vmxHCExitVirtEoi(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTransient)
+{
+    HMVMX_VALIDATE_EXIT_HANDLER_PARAMS(pVCpu, pVmxTransient);
+#ifndef IN_NEM_DARWIN
+    Assert(pVmxTransient->pVmcsInfo->u32ProcCtls2 & VMX_PROC_CTLS2_VIRT_INT_DELIVERY);
+
+    vmxHCReadToTransient<HMVMX_READ_EXIT_QUALIFICATION>(pVCpu, pVmxTransient);
+    uint8_t const uVector = (uint8_t)pVmxTransient->uExitQual;    /* Bits 7:0 is the vector. */
+    Log4Func(("uVector=%#x\n", uVector));
+    return PDMR0ApicSetEoiVirtualized(pVCpu, uVector);
+#else
+    HMVMX_UNEXPECTED_EXIT_RET(pVCpu, pVmxTransient->uExitReason);
+#endif
+}
+
+
+/**
+ * VM-exit handler for APIC-write emulation (VMX_EXIT_APIC_WRITE). Conditional
+ * VM-exit.
+ *
+ * With virtual-interrupt delivery but no APIC-register virtualization, the only
+ * write we get this trap-like VM-exit for is the ICR low dword.  The CPU has
+ * already stored it in the virtual-APIC page (our APIC page), we send the IPI.
+ */
+HMVMX_EXIT_DECL vmxHCExitApicWrite(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTransient)
+{
+    HMVMX_VALIDATE_EXIT_HANDLER_PARAMS(pVCpu, pVmxTransient);
+#ifndef IN_NEM_DARWIN
+    Assert(pVmxTransient->pVmcsInfo->u32ProcCtls2 & VMX_PROC_CTLS2_VIRT_INT_DELIVERY);
+
+    vmxHCReadToTransient<HMVMX_READ_EXIT_QUALIFICATION>(pVCpu, pVmxTransient);
+    uint16_t const offApic = (uint16_t)(pVmxTransient->uExitQual & 0xfff);      /* Bits 11:0 is the page offset. */
+    if (offApic == XAPIC_OFF_ICR_LO)
+    {
+        VBOXSTRICTRC rcStrict = PDMApicSetIcrLoVirtualized(pVCpu);
+        Log4Func(("ICR_LO rcStrict=%Rrc\n", VBOXSTRICTRC_VAL(rcStrict)));
+        return rcStrict;
+    }
+    AssertMsgFailed(("offApic=%#x\n", offApic));
+#endif
+    HMVMX_UNEXPECTED_EXIT_RET(pVCpu, pVmxTransient->uExitReason);
+}
+
+
 /**
  * VM-exit handler for debug-register accesses (VMX_EXIT_MOV_DRX). Conditional
  * VM-exit.
@@ -66,6 +66,7 @@
 #include <VBox/vmm/vmcc.h>
 #include <VBox/vmm/vmcpuset.h>
 #include <VBox/vmm/pdmapi.h>        /* PDMR3HasLoadedState */
+#include <iprt/asm.h>
 
 
 /*********************************************************************************************************************************
@@ -673,22 +674,17 @@ static uint16_t gicReDistGetHighestPriorityPendingIntr(PCVMCPUCC pVCpu, uint32_t
                 bmIntr &= ~pGicCpu->bmIntrGroup[i];
 
             /* Among the collected interrupts, pick the one with the highest, non-idle priority. */
-            uint16_t idxIntrInElement = 0;
             while (bmIntr)
             {
-                if (bmIntr & RT_BIT_32(0))
+                uint16_t const cIntrsPerElement = sizeof(bmIntr) * 8;
+                uint16_t const idxPending       = i * cIntrsPerElement + ASMBitFirstSetU32(bmIntr) - 1;
+                bmIntr &= bmIntr - 1;
+                Assert(idxPending < RT_ELEMENTS(pGicCpu->abIntrPriority));
+                if (pGicCpu->abIntrPriority[idxPending] < bPriority)
                 {
-                    uint16_t const cIntrsPerElement = sizeof(bmIntr) * 8;
-                    uint16_t const idxPending       = i * cIntrsPerElement + idxIntrInElement;
-                    Assert(idxPending < RT_ELEMENTS(pGicCpu->abIntrPriority));
-                    if (pGicCpu->abIntrPriority[idxPending] < bPriority)
-                    {
-                        idxHighest = idxPending;
-                        bPriority  = pGicCpu->abIntrPriority[idxPending];
-                    }
+                    idxHighest = idxPending;
+                    bPriority  = pGicCpu->abIntrPriority[idxPending];
                 }
-                bmIntr >>= 1;
-                ++idxIntrInElement;
             }
         }
         if (idxHighest != UINT16_MAX)
@@ -714,27 +710,22 @@ static uint16_t gicReDistGetHighestPriorityPendingIntr(PCVMCPUCC pVCpu, uint32_t
             uint16_t idxHighest = UINT16_MAX;
             for (uint16_t i = 0; i < RT_ELEMENTS(pGicCpu->LpiPending.au64); i++)
             {
-                uint64_t bmLpiPending    = pGicCpu->LpiPending.au64[i];
-                uint16_t idxLpiInElement = 0;
+                uint64_t bmLpiPending = pGicCpu->LpiPending.au64[i];
                 while (bmLpiPending)
                 {
-                    if (bmLpiPending & RT_BIT_64(0))
+                    /* We don't support dual security states, hence priority is -not- shifted */
+                    uint16_t const cIntrsPerElement = sizeof(bmLpiPending) * 8;
+                    uint16_t const idxLpi           = i * cIntrsPerElement + ASMBitFirstSetU64(bmLpiPending) - 1;
+                    bmLpiPending &= bmLpiPending - 1;
+                    Assert(idxLpi < RT_ELEMENTS(pGicDev->abLpiConfig));
+                    uint8_t const  bLpiPriority    = pGicDev->abLpiConfig[idxLpi] & GIC_BF_LPI_CTE_PRIORITY_MASK;
+                    bool const     fLpiEnabled     = pGicDev->abLpiConfig[idxLpi] & GIC_BF_LPI_CTE_ENABLE_MASK;
+                    if (   fLpiEnabled
+                        && bLpiPriority < bPriority)
                     {
-                        /* We don't support dual security states, hence priority is -not- shifted */
-                        uint16_t const cIntrsPerElement = sizeof(bmLpiPending) * 8;
-                        uint16_t const idxLpi           = i * cIntrsPerElement + idxLpiInElement;
-                        Assert(idxLpi < RT_ELEMENTS(pGicDev->abLpiConfig));
-                        uint8_t const  bLpiPriority    = pGicDev->abLpiConfig[idxLpi] & GIC_BF_LPI_CTE_PRIORITY_MASK;
-                        bool const     fLpiEnabled     = pGicDev->abLpiConfig[idxLpi] & GIC_BF_LPI_CTE_ENABLE_MASK;
-                        if (   fLpiEnabled
-                            && bLpiPriority < bPriority)
-                        {
-                            bPriority  = bLpiPriority;
-                            idxHighest = idxLpi;
-                        }
+                        bPriority  = bLpiPriority;
+                        idxHighest = idxLpi;
                     }
-                    bmLpiPending >>= 1;
-                    ++idxLpiInElement;
                 }
             }
             if (idxHighest != UINT16_MAX)
@@ -801,23 +792,18 @@ static uint16_t gicDistGetHighestPriorityPendingIntr(PCGICDEV pGicDev, PCVMCPUCC
             bmIntr &= ~pGicDev->IntrGroup.au64[i];
 
         /* Among the collected interrupts, pick the highest priority pending interrupt that can be routed to the target VCPU. */
-        uint16_t idxIntrInElement = 0;
         while (bmIntr)
         {
-            if (bmIntr & RT_BIT_64(0))
+            uint16_t const cIntrsPerElement = sizeof(bmIntr) * 8;
+            uint16_t const idxPending       = i * cIntrsPerElement + ASMBitFirstSetU64(bmIntr) - 1;
+            bmIntr &= bmIntr - 1;
+            Assert(idxPending < RT_ELEMENTS(pGicDev->abIntrPriority));
+            if (   pGicDev->abIntrPriority[idxPending] < bPriority
+                && pGicDev->au32IntrRouting[idxPending] == pVCpu->idCpu)
             {
-                uint16_t const cIntrsPerElement = sizeof(bmIntr) * 8;
-                uint16_t const idxPending       = i * cIntrsPerElement + idxIntrInElement;
-                Assert(idxPending < RT_ELEMENTS(pGicDev->abIntrPriority));
-                if (   pGicDev->abIntrPriority[idxPending] < bPriority
-                    && pGicDev->au32IntrRouting[idxPending] == pVCpu->idCpu)
-                {
-                    idxIntr   = idxPending;
-                    bPriority = pGicDev->abIntrPriority[idxPending];
-                }
+                idxIntr   = idxPending;
+                bPriority = pGicDev->abIntrPriority[idxPending];
             }
-            bmIntr >>= 1;
-            ++idxIntrInElement;
         }
     }
     if (idxIntr != UINT16_MAX)
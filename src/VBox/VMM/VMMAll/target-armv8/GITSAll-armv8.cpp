@@ -32,6 +32,7 @@
 #define LOG_GROUP LOG_GROUP_DEV_GIC
 #include "GICInternal.h"
 #include <VBox/vmm/vm.h>        /* pVM->cCpus */
+#include <iprt/asm.h>
 
 
 /*********************************************************************************************************************************
@@ -560,6 +561,22 @@ DECLHIDDEN(void) gitsMmioWriteTranslate(PGITSDEV pGitsDev, uint16_t offReg, uint
 }
 
 
+/**
+ * Gets the LPI map cache set for a device ID and event ID combination.
+ *
+ * @returns The index of the set.
+ * @param   uDevId      The device ID.
+ * @param   uEventId    The event ID.
+ */
+DECL_FORCE_INLINE(uint32_t) gitsLpiCacheGetSet(uint16_t uDevId, uint16_t uEventId)
+{
+    /* Event IDs of a device are typically allocated sequentially, spread them across
+       sets and mix in the device ID so multiple devices don't collide on the same sets. */
+    uint32_t const uHash = uEventId ^ (uDevId * UINT32_C(0x9e3779b1) >> 16);
+    return uHash & (GITS_LPI_MAP_CACHE_SETS - 1);
+}
+
+
 /**
  * Looks up an device ID and event ID combination from the LPI map cache.
  *
@@ -577,26 +594,29 @@ static bool gitstLpiCacheLookup(PGITSDEV pGitsDev, uint16_t uDevId, uint16_t uEv
     AssertCompile(RT_ELEMENTS(pLpiMap->uIcId)  == GITS_LPI_MAP_CACHE_COUNT);
     AssertCompile(RT_ELEMENTS(pLpiMap->uIntId) == GITS_LPI_MAP_CACHE_COUNT);
     AssertCompile(RT_ELEMENTS(pLpiMap->idCpu) == GITS_LPI_MAP_CACHE_COUNT);
+    AssertCompile(sizeof(pLpiMap->bmValid[0]) * 8 >= GITS_LPI_MAP_CACHE_WAYS);
 
     /*
      * Lookup the entry in the cache that matches the device ID and event ID combo.
      * If multiple entries with the same device ID and event IDs map to the same
-     * physical INTID, the behavior is implementation defined. We always return the
-     * last added entry.
+     * physical INTID, the behavior is implementation defined. We only ever keep one
+     * entry for a combination since adding one replaces any existing entry.
      *
      * See ARM GIC spec. 5.2.10 "Restrictions for INTID mapping rules".
      */
     uint32_t const uDevIdEventId = RT_MAKE_U32(uDevId, uEventId);
-    uint8_t const  cEntries      = pGitsDev->cLpiMap;
-    Assert(cEntries < RT_ELEMENTS(pLpiMap->uDevIdEventId));
-    for (uint8_t i = 0; i < cEntries; i++)
+    uint32_t const iSet          = gitsLpiCacheGetSet(uDevId, uEventId);
+    uint32_t       bmValid       = pLpiMap->bmValid[iSet];
+    while (bmValid)
     {
-        if (pLpiMap->uDevIdEventId[i].u == uDevIdEventId)
+        uint32_t const idxEntry = iSet * GITS_LPI_MAP_CACHE_WAYS + ASMBitFirstSetU32(bmValid) - 1;
+        bmValid &= bmValid - 1;
+        if (pLpiMap->uDevIdEventId[idxEntry].u == uDevIdEventId)
         {
-            pLpiMapEntry->uDevIdEventId = pLpiMap->uDevIdEventId[i];
-            pLpiMapEntry->uIntId        = pLpiMap->uIntId[i];
-            pLpiMapEntry->uIcId         = pLpiMap->uIcId[i];
-            pLpiMapEntry->idCpu         = pLpiMap->idCpu[i];
+            pLpiMapEntry->uDevIdEventId = pLpiMap->uDevIdEventId[idxEntry];
+            pLpiMapEntry->uIntId        = pLpiMap->uIntId[idxEntry];
+            pLpiMapEntry->uIcId         = pLpiMap->uIcId[idxEntry];
+            pLpiMapEntry->idCpu         = pLpiMap->idCpu[idxEntry];
             STAM_COUNTER_INC(&pGitsDev->StatLpiCacheHit);
             return true;
         }
@@ -610,72 +630,100 @@ static bool gitstLpiCacheLookup(PGITSDEV pGitsDev, uint16_t uDevId, uint16_t uEv
 }
 
 
+/**
+ * Invalidates the LPI map cache entry at the given index.
+ *
+ * @param   pGitsDev    The GIC ITS state.
+ * @param   idxEntry    The index of the entry, must be valid.
+ */
+DECL_FORCE_INLINE(void) gitsLpiCacheInvalidateEntry(PGITSDEV pGitsDev, uint32_t idxEntry)
+{
+    PGITSLPIMAP    pLpiMap = &pGitsDev->LpiMap;
+    uint32_t const iSet    = idxEntry / GITS_LPI_MAP_CACHE_WAYS;
+    uint32_t const iWay    = idxEntry % GITS_LPI_MAP_CACHE_WAYS;
+    Assert(pLpiMap->bmValid[iSet] & RT_BIT_32(iWay));
+    Assert(pGitsDev->cLpiMap > 0);
+    pLpiMap->bmValid[iSet] &= ~RT_BIT_32(iWay);
+    pLpiMap->idCpu[idxEntry] = NIL_VMCPUID;
+    --pGitsDev->cLpiMap;
+}
+
+
 /**
  * Adds an entry to the LPI map cache.
  *
+ * An existing entry for the same device ID/event ID combination is replaced,
+ * otherwise a free way in the set is used or, if the set is full, the ways are
+ * evicted in round-robin order.
+ *
  * @param   pGitsDev        The GIC ITS state.
  * @param   pLpiMapEntry    The LPI map entry to add.
  * @remarks The caller must ensure the fields in the entry are valid.
  */
 static void gitsLpiCacheAdd(PGITSDEV pGitsDev, PGITSLPIMAPENTRY pLpiMapEntry)
 {
-    PGITSLPIMAP     pLpiMap  = &pGitsDev->LpiMap;
-    uint32_t const cCapacity = RT_ELEMENTS(pLpiMap->uDevIdEventId);
-
-    uint8_t const idxMap = pGitsDev->idxLpiMap;
-    Assert(idxMap < cCapacity);
-    pLpiMap->uDevIdEventId[idxMap].u = pLpiMapEntry->uDevIdEventId.u;
-    pLpiMap->uIcId[idxMap]           = pLpiMapEntry->uIcId;
-    pLpiMap->uIntId[idxMap]          = pLpiMapEntry->uIntId;
-    pLpiMap->idCpu[idxMap]           = pLpiMapEntry->idCpu;
-
-    pGitsDev->idxLpiMap = (pGitsDev->idxLpiMap + 1) % cCapacity;
-    if (pGitsDev->cLpiMap < cCapacity)
-        ++pGitsDev->cLpiMap;
+    PGITSLPIMAP    pLpiMap       = &pGitsDev->LpiMap;
+    uint32_t const uDevIdEventId = pLpiMapEntry->uDevIdEventId.u;
+    uint32_t const iSet          = gitsLpiCacheGetSet(pLpiMapEntry->uDevIdEventId.s.Lo, pLpiMapEntry->uDevIdEventId.s.Hi);
+    uint32_t const bmValid       = pLpiMap->bmValid[iSet];
+
+    /* Pick the way to use: an existing entry for the same key, a free way or the next victim. */
+    uint32_t iWay = UINT32_MAX;
+    for (uint32_t i = 0; i < GITS_LPI_MAP_CACHE_WAYS; i++)
+        if (   (bmValid & RT_BIT_32(i))
+            && pLpiMap->uDevIdEventId[iSet * GITS_LPI_MAP_CACHE_WAYS + i].u == uDevIdEventId)
+        {
+            iWay = i;
+            break;
+        }
+    if (iWay == UINT32_MAX)
+    {
+        uint32_t const bmFree = ~bmValid & (RT_BIT_32(GITS_LPI_MAP_CACHE_WAYS) - 1);
+        if (bmFree)
+        {
+            iWay = ASMBitFirstSetU32(bmFree) - 1;
+            ++pGitsDev->cLpiMap;
+        }
+        else
+        {
+            iWay = pLpiMap->idxVictim[iSet];
+            pLpiMap->idxVictim[iSet] = (iWay + 1) % GITS_LPI_MAP_CACHE_WAYS;
+            STAM_COUNTER_INC(&pGitsDev->StatLpiCacheEvict);
+        }
+    }
+    Assert(iWay < GITS_LPI_MAP_CACHE_WAYS);
+
+    uint32_t const idxEntry = iSet * GITS_LPI_MAP_CACHE_WAYS + iWay;
+    pLpiMap->uDevIdEventId[idxEntry].u = uDevIdEventId;
+    pLpiMap->uIcId[idxEntry]           = pLpiMapEntry->uIcId;
+    pLpiMap->uIntId[idxEntry]          = pLpiMapEntry->uIntId;
+    pLpiMap->idCpu[idxEntry]           = pLpiMapEntry->idCpu;
+    pLpiMap->bmValid[iSet]            |= RT_BIT_32(iWay);
+    Assert(pGitsDev->cLpiMap <= GITS_LPI_MAP_CACHE_COUNT);
     STAM_COUNTER_INC(&pGitsDev->StatLpiCacheAdd);
 }
 
 
 /**
- * Invalidates an entry that matches the device ID/event ID combination.
+ * Invalidates the entry that matches the device ID/event ID combination.
  *
  * @param   pGitsDev    The GIC ITS state.
  * @param   uDevId      The device ID.
  * @param   uEventId    The event ID.
- * @remarks This does not invalidate multiple entries that may match the device
- *          ID/event ID combination because our lookup always only returns the
- *          first matching entry.
  */
 static void gitsLpiCacheInvalidateOne(PGITSDEV pGitsDev, uint16_t uDevId, uint16_t uEventId)
 {
-    uint64_t const uDevIdEventId = RT_MAKE_U32(uDevId, uEventId);
-    uint8_t const  cEntries      = pGitsDev->cLpiMap;
     PGITSLPIMAP    pLpiMap       = &pGitsDev->LpiMap;
-    for (uint8_t i = 0; i < cEntries; i++)
+    uint32_t const uDevIdEventId = RT_MAKE_U32(uDevId, uEventId);
+    uint32_t const iSet          = gitsLpiCacheGetSet(uDevId, uEventId);
+    uint32_t       bmValid       = pLpiMap->bmValid[iSet];
+    while (bmValid)
     {
-        if (pLpiMap->uDevIdEventId[i].u == uDevIdEventId)
+        uint32_t const idxEntry = iSet * GITS_LPI_MAP_CACHE_WAYS + ASMBitFirstSetU32(bmValid) - 1;
+        bmValid &= bmValid - 1;
+        if (pLpiMap->uDevIdEventId[idxEntry].u == uDevIdEventId)
         {
-            uint8_t const idxLast = pGitsDev->idxLpiMap;
-            if (idxLast == cEntries)
-            {
-                /* The cache is not full, swap the last entry with this one. */
-                pLpiMap->uDevIdEventId[i].u = pLpiMap->uDevIdEventId[idxLast].u;
-                pLpiMap->uIntId[i]          = pLpiMap->uIntId[idxLast];
-                pLpiMap->uIcId[i]           = pLpiMap->uIcId[idxLast];
-                pLpiMap->idCpu[i]           = pLpiMap->idCpu[idxLast];
-                --pGitsDev->idxLpiMap;
-            }
-            else
-            {
-                /* The cache is full, clear the current entry and mark it as the next-free index. */
-                Assert(idxLast < cEntries);
-                pLpiMap->uDevIdEventId[i].u = 0;
-                pLpiMap->uIntId[i]          = 0;
-                pLpiMap->uIcId[i]           = 0;
-                pLpiMap->idCpu[i]           = NIL_VMCPUID;
-                pGitsDev->idxLpiMap = i;
-            }
-            --pGitsDev->cLpiMap;
+            gitsLpiCacheInvalidateEntry(pGitsDev, idxEntry);
             break;
         }
     }
@@ -683,6 +731,55 @@ static void gitsLpiCacheInvalidateOne(PGITSDEV pGitsDev, uint16_t uDevId, uint16
 }
 
 
+/**
+ * Invalidates all entries in the LPI map cache that belong to a device.
+ *
+ * @param   pGitsDev    The GIC ITS state.
+ * @param   uDevId      The device ID.
+ */
+static void gitsLpiCacheInvalidateDevice(PGITSDEV pGitsDev, uint16_t uDevId)
+{
+    PGITSLPIMAP pLpiMap = &pGitsDev->LpiMap;
+    for (uint32_t iSet = 0; iSet < GITS_LPI_MAP_CACHE_SETS && pGitsDev->cLpiMap; iSet++)
+    {
+        uint32_t bmValid = pLpiMap->bmValid[iSet];
+        while (bmValid)
+        {
+            uint32_t const idxEntry = iSet * GITS_LPI_MAP_CACHE_WAYS + ASMBitFirstSetU32(bmValid) - 1;
+            bmValid &= bmValid - 1;
+            if (pLpiMap->uDevIdEventId[idxEntry].s.Lo == uDevId)
+                gitsLpiCacheInvalidateEntry(pGitsDev, idxEntry);
+        }
+    }
+    STAM_COUNTER_INC(&pGitsDev->StatLpiCacheInvDev);
+}
+
+
+/**
+ * Invalidates all entries in the LPI map cache that target an interrupt
+ * collection.
+ *
+ * @param   pGitsDev    The GIC ITS state.
+ * @param   uIcId       The interrupt collection ID.
+ */
+static void gitsLpiCacheInvalidateCollection(PGITSDEV pGitsDev, uint16_t uIcId)
+{
+    PGITSLPIMAP pLpiMap = &pGitsDev->LpiMap;
+    for (uint32_t iSet = 0; iSet < GITS_LPI_MAP_CACHE_SETS && pGitsDev->cLpiMap; iSet++)
+    {
+        uint32_t bmValid = pLpiMap->bmValid[iSet];
+        while (bmValid)
+        {
+            uint32_t const idxEntry = iSet * GITS_LPI_MAP_CACHE_WAYS + ASMBitFirstSetU32(bmValid) - 1;
+            bmValid &= bmValid - 1;
+            if (pLpiMap->uIcId[idxEntry] == uIcId)
+                gitsLpiCacheInvalidateEntry(pGitsDev, idxEntry);
+        }
+    }
+    STAM_COUNTER_INC(&pGitsDev->StatLpiCacheInvCollection);
+}
+
+
 /**
  * Invalidates all entries in the LPI map cache.
  *
@@ -691,15 +788,16 @@ static void gitsLpiCacheInvalidateOne(PGITSDEV pGitsDev, uint16_t uDevId, uint16
 DECLHIDDEN(void) gitsLpiCacheInvalidateAll(PGITSDEV pGitsDev)
 {
     PGITSLPIMAP pLpiMap = &pGitsDev->LpiMap;
-    for (uint8_t i = 0; i < RT_ELEMENTS(pGitsDev->LpiMap.uDevIdEventId); i++)
+    for (uint32_t i = 0; i < RT_ELEMENTS(pLpiMap->uDevIdEventId); i++)
     {
         pLpiMap->uDevIdEventId[i].u = 0;
         pLpiMap->uIntId[i]          = 0;
         pLpiMap->uIcId[i]           = 0;
         pLpiMap->idCpu[i]           = NIL_VMCPUID;
     }
-    pGitsDev->idxLpiMap = 0;
-    pGitsDev->cLpiMap   = 0;
+    RT_ZERO(pLpiMap->bmValid);
+    RT_ZERO(pLpiMap->idxVictim);
+    pGitsDev->cLpiMap = 0;
     STAM_COUNTER_INC(&pGitsDev->StatLpiCacheInvAll);
 }
 
@@ -1010,16 +1108,19 @@ DECL_HIDDEN_CALLBACK(void) gitsR3DbgInfo(PCGITSDEV pGitsDev, PCDBGFINFOHLP pHlp)
     /* LPI cache. */
     {
         PCGITSLPIMAP   pLpiMap  = &pGitsDev->LpiMap;
-        uint8_t const  cEntries = pGitsDev->cLpiMap;
-        pHlp->pfnPrintf(pHlp, "  LPI cache (capacity=%u entries=%u)\n", RT_ELEMENTS(pLpiMap->uDevIdEventId), cEntries);
-        for (uint8_t i = 0; i < cEntries; i++)
+        uint16_t const cEntries = pGitsDev->cLpiMap;
+        pHlp->pfnPrintf(pHlp, "  LPI cache (capacity=%u sets=%u ways=%u entries=%u)\n", RT_ELEMENTS(pLpiMap->uDevIdEventId),
+                        GITS_LPI_MAP_CACHE_SETS, GITS_LPI_MAP_CACHE_WAYS, cEntries);
+        for (uint32_t i = 0; i < RT_ELEMENTS(pLpiMap->uDevIdEventId); i++)
         {
+            if (!(pLpiMap->bmValid[i / GITS_LPI_MAP_CACHE_WAYS] & RT_BIT_32(i % GITS_LPI_MAP_CACHE_WAYS)))
+                continue;
             uint16_t const uDevId   = pLpiMap->uDevIdEventId[i].s.Lo;
             uint16_t const uEventId = pLpiMap->uDevIdEventId[i].s.Hi;
             uint16_t const uIcId    = pLpiMap->uIcId[i];
             uint16_t const uIntId   = pLpiMap->uIntId[i];
             VMCPUID const  idCpu    = pLpiMap->idCpu[i];
-            pHlp->pfnPrintf(pHlp, "    [%2u] = (devid=%#RX16 eventid=%#RX16 intid=%RU16 icid=%RU16 vcpu=%RU32)\n",
+            pHlp->pfnPrintf(pHlp, "    [%3u] = (devid=%#RX16 eventid=%#RX16 intid=%RU16 icid=%RU16 vcpu=%RU32)\n",
                                   i, uDevId, uEventId, uIntId, uIcId, idCpu);
         }
     }
@@ -1072,7 +1173,11 @@ static void gitsR3CmdMapIntr(PPDMDEVINS pDevIns, PGITSDEV pGitsDev, uint32_t uDe
                             Log4Func(("uDte=%#RX64 uIte=%#RX64 uIcId=%RU16 uIntId=%RU16\n", uDte, uIte, uIcId, uIntId));
                             rc = gitsIteWrite(pDevIns, uDte, uEventId, uIte);
                             if (RT_SUCCESS(rc))
+                            {
+                                /* Any cached translation for this device ID/event ID combination is now stale. */
+                                gitsLpiCacheInvalidateOne(pGitsDev, uDevId, uEventId);
                                 return;
+                            }
                             GITS_CMD_QUEUE_SET_ERR(Ite_Wr_Failed);
                         }
                         else
@@ -1275,6 +1380,8 @@ DECLHIDDEN(int) gitsR3CmdQueueProcess(PCVMCC pVM, PPDMDEVINS pDevIns, PGITSDEV p
                                 else
                                     idCpu = NIL_VMCPUID;
                                 pGitsDev->aCtes[uIcId] = idCpu;
+                                /* Cached translations hold the target CPU of the collection, drop them. */
+                                gitsLpiCacheInvalidateCollection(pGitsDev, uIcId);
                                 GIC_CRIT_SECT_LEAVE(pDevIns);
                             }
                             else
@@ -1307,6 +1414,8 @@ DECLHIDDEN(int) gitsR3CmdQueueProcess(PCVMCC pVM, PPDMDEVINS pDevIns, PGITSDEV p
 
                                         GIC_CRIT_SECT_ENTER(pDevIns);
                                         rc = gitsDteWrite(pDevIns, pGitsDev, uDevId, uDte);
+                                        /* The device may have been remapped to a different ITT. */
+                                        gitsLpiCacheInvalidateDevice(pGitsDev, uDevId);
                                         GIC_CRIT_SECT_LEAVE(pDevIns);
                                         AssertRC(rc);
                                     }
@@ -1319,12 +1428,7 @@ DECLHIDDEN(int) gitsR3CmdQueueProcess(PCVMCC pVM, PPDMDEVINS pDevIns, PGITSDEV p
                                     uint64_t const uDte = 0;
                                     GIC_CRIT_SECT_ENTER(pDevIns);
                                     rc = gitsDteWrite(pDevIns, pGitsDev, uDevId, uDte);
-                                    /*
-                                     * Well-behaving guests don't typically keep modifying the device ID mapping,
-                                     * so we simply invalidate the whole cache here. If the need arises, perform
-                                     * selective invalidation of the cache.
-                                     */
-                                    gitsLpiCacheInvalidateAll(pGitsDev);
+                                    gitsLpiCacheInvalidateDevice(pGitsDev, uDevId);
                                     GIC_CRIT_SECT_LEAVE(pDevIns);
                                     AssertRC(rc);
                                 }
@@ -1368,10 +1472,14 @@ DECLHIDDEN(int) gitsR3CmdQueueProcess(PCVMCC pVM, PPDMDEVINS pDevIns, PGITSDEV p
 
                         case GITS_CMD_ID_INV:
                         {
-                            /* Reading the table is likely to take the same time as reading just one entry. */
+                            /*
+                             * Reading the table is likely to take the same time as reading just one entry.
+                             * INV only affects the LPI configuration (priority, enable) which isn't part of
+                             * the cached translations, so the LPI map cache remains valid. Guests issue this
+                             * for every LPI mask/unmask, so flushing the cache here would defeat it.
+                             */
                             GIC_CRIT_SECT_ENTER(pDevIns);
                             gicDistReadLpiConfigTableFromMem(pDevIns);
-                            gitsLpiCacheInvalidateAll(pGitsDev);
                             GIC_CRIT_SECT_LEAVE(pDevIns);
                             STAM_COUNTER_INC(&pGitsDev->StatCmdInv);
                             break;
@@ -1391,9 +1499,9 @@ DECLHIDDEN(int) gitsR3CmdQueueProcess(PCVMCC pVM, PPDMDEVINS pDevIns, PGITSDEV p
                             {
                                 if (pGitsDev->aCtes[uIcId] < pVM->cCpus)
                                 {
+                                    /* Like INV, this doesn't affect cached translations. */
                                     GIC_CRIT_SECT_ENTER(pDevIns);
                                     gicDistReadLpiConfigTableFromMem(pDevIns);
-                                    gitsLpiCacheInvalidateAll(pGitsDev);
                                     GIC_CRIT_SECT_LEAVE(pDevIns);
                                 }
                                 else
@@ -1495,8 +1603,8 @@ DECLHIDDEN(void) gitsLpiTrigger(PVMCC pVM, PPDMDEVINS pDevIns, PGITSDEV pGitsDev
      * avoids conditional(s) and is something that should never happen with well-behaved guests.
      * See ARM GIC spec. 12.19.12 "GITS_TRANSLATER, ITS Translation Register".
      */
-    uDevId   &= ~(uint32_t)(UINT32_C(1) << GITS_DEV_ID_BITS);
-    uEventId &= ~(uint32_t)(UINT32_C(1) << GITS_EVENT_ID_BITS);
+    uDevId   &= RT_BIT_32(GITS_DEV_ID_BITS) - 1;
+    uEventId &= RT_BIT_32(GITS_EVENT_ID_BITS) - 1;
 
     /* Lookup the LPI from the cache first. */
     {
@@ -39,6 +39,7 @@
 #include <VBox/vmm/vmcpuset.h>
 #ifdef IN_RING0
 # include <VBox/vmm/gvmm.h>
+# include <iprt/mp.h>
 #endif
 
 
@@ -152,12 +153,15 @@ DECLINLINE(bool) apicTestVectorInPib(volatile void *pvPib, uint8_t uVector)
 /**
  * Atomically sets the PIB notification bit.
  *
+ * This is bit 0, the outstanding-notification (ON) bit of the VT-x
+ * posted-interrupt descriptor, so the CPU clears it when it processes the PIB.
+ *
  * @returns non-zero if the bit was already set, 0 otherwise.
  * @param   pApicPib        Pointer to the PIB.
  */
 DECLINLINE(uint32_t) apicSetNotificationBitInPib(PAPICPIB pApicPib)
 {
-    return ASMAtomicXchgU32(&pApicPib->fOutstandingNotification, RT_BIT_32(31));
+    return ASMAtomicXchgU32(&pApicPib->fOutstandingNotification, RT_BIT_32(0));
 }
 
 
@@ -2594,6 +2598,40 @@ void apicClearInterruptFF(PVMCPUCC pVCpu, PDMAPICIRQ enmType)
 }
 
 
+/**
+ * Notifies the EMT of a newly posted edge-triggered interrupt when
+ * posted-interrupt processing is enabled.
+ *
+ * If the EMT is executing guest code we send the posted-interrupt notification
+ * vector to the host CPU it is running on, and the CPU merges the PIB into the
+ * virtual-APIC page without a VM-exit.  Otherwise, or if the IPI cannot be
+ * sent, this falls back to the update-pending force-flag.
+ *
+ * @param   pVCpu           The cross context virtual CPU structure.
+ * @thread  Any.
+ */
+static void apicNotifyPostedIntr(PVMCPUCC pVCpu)
+{
+#ifdef IN_RING0
+    /* Set the FF before looking at the EMT state, so an EMT about to enter the
+       guest merges the PIB itself (HM checks the FF with interrupts disabled). */
+    VMCPU_FF_SET(pVCpu, VMCPU_FF_UPDATE_APIC);
+    if (VMMGetCpuId(pVCpu->CTX_SUFF(pVM)) != pVCpu->idCpu)
+    {
+        RTCPUID const idHostCpu = pVCpu->idHostCpu;
+        if (   idHostCpu != NIL_RTCPUID
+            && VMCPU_GET_STATE(pVCpu) == VMCPUSTATE_STARTED_EXEC
+            && RT_SUCCESS(RTMpPostIpiCpu(idHostCpu)))
+        {
+            STAM_COUNTER_INC(&VMCPU_TO_APICCPU(pVCpu)->StatPostIntrNotify);
+            return;
+        }
+    }
+#endif
+    apicSetInterruptFF(pVCpu, PDMAPICIRQ_UPDATE_PENDING);
+}
+
+
 /**
  * Posts an interrupt to a target APIC.
  *
@@ -2651,13 +2689,16 @@ DECLCALLBACK(bool) apicPostInterrupt(PVMCPUCC pVCpu, uint8_t uVector, XAPICTRIGG
                   VMMGetCpuId(pVM), pVCpu->idCpu, uVector, enmTriggerMode == XAPICTRIGGERMODE_EDGE ? "edge" : "lvl"));
             if (enmTriggerMode == XAPICTRIGGERMODE_EDGE)
             {
-                if (pApic->fPostedIntrsEnabled)
-                { /** @todo posted-interrupt call to hardware */ }
-                else
+                apicSetVectorInPib(pApicCpu->CTX_SUFF(pvApicPib), uVector);
+                uint32_t const fAlreadySet = apicSetNotificationBitInPib((PAPICPIB)pApicCpu->CTX_SUFF(pvApicPib));
+                if (!fAlreadySet)
                 {
-                    apicSetVectorInPib(pApicCpu->CTX_SUFF(pvApicPib), uVector);
-                    uint32_t const fAlreadySet = apicSetNotificationBitInPib((PAPICPIB)pApicCpu->CTX_SUFF(pvApicPib));
-                    if (!fAlreadySet)
+                    if (pApic->fPostedIntrsEnabled)
+                    {
+                        Log2(("APIC: apicPostInterrupt: Notifying posted edge-triggered intr. uVector=%#x\n", uVector));
+                        apicNotifyPostedIntr(pVCpu);
+                    }
+                    else
                     {
                         Log2(("APIC: apicPostInterrupt: Setting UPDATE_APIC FF for edge-triggered intr. uVector=%#x\n", uVector));
                         apicSetInterruptFF(pVCpu, PDMAPICIRQ_UPDATE_PENDING);
@@ -2901,7 +2942,10 @@ static DECLCALLBACK(void) apicUpdatePendingInterrupts(PVMCPUCC pVCpu)
     STAM_PROFILE_STOP(&pApicCpu->StatUpdatePendingIntrs, a);
     Log3(("APIC%u: apicUpdatePendingInterrupts: fHasPendingIntrs=%RTbool\n", pVCpu->idCpu, fHasPendingIntrs));
 
-    if (   fHasPendingIntrs
+    /* With posted-interrupt processing the CPU may already have merged the PIB
+       into the IRR behind our back, so always check it then. */
+    if (   (   fHasPendingIntrs
+            || VM_TO_APIC(pVCpu->CTX_SUFF(pVM))->fPostedIntrsEnabled)
         && !VMCPU_FF_IS_SET(pVCpu, VMCPU_FF_INTERRUPT_APIC))
         apicSignalNextPendingIntr(pVCpu);
 }
@@ -2926,9 +2970,55 @@ static DECLCALLBACK(int) apicR0VBoxGetApicPageForCpu(PCVMCPUCC pVCpu, PRTHCPHYS
         *pR3Ptr  = pApicCpu->pvApicPageR3;
     return VINF_SUCCESS;
 }
+
+
+/**
+ * @interface_method_impl{PDMAPICBACKENDR0,pfnGetPibForCpu}
+ */
+static DECLCALLBACK(int) apicR0VBoxGetPibForCpu(PCVMCPUCC pVCpu, PRTHCPHYS pHCPhys)
+{
+    AssertReturn(pVCpu,   VERR_INVALID_PARAMETER);
+    AssertReturn(pHCPhys, VERR_INVALID_PARAMETER);
+
+    PCAPICCPU pApicCpu = VMCPU_TO_APICCPU(pVCpu);
+    AssertReturn(pApicCpu->HCPhysApicPib != NIL_RTHCPHYS, VERR_WRONG_ORDER);
+    *pHCPhys = pApicCpu->HCPhysApicPib;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{PDMAPICBACKENDR0,pfnSetEoiVirtualized}
+ */
+static DECLCALLBACK(VBOXSTRICTRC) apicR0VBoxSetEoiVirtualized(PVMCPUCC pVCpu, uint8_t uVector)
+{
+    VMCPU_ASSERT_EMT(pVCpu);
+
+    /*
+     * The CPU has already taken the vector out of the ISR.  Put it back so
+     * apicSetEoi finds it as the highest in-service vector and does the
+     * level-triggered bits (I/O APIC EOI broadcast, TMR, remote IRR).
+     */
+    PXAPICPAGE pXApicPage = VMCPU_TO_XAPICPAGE(pVCpu);
+    apicSetVectorInReg(&pXApicPage->isr, uVector);
+    return apicSetEoi(pVCpu, 0 /* uEoi */, false /* fForceX2ApicBehaviour */);
+}
 #endif /* IN_RING0 */
 
 
+/**
+ * @interface_method_impl{PDMAPICBACKEND,pfnSetIcrLoVirtualized}
+ */
+static DECLCALLBACK(VBOXSTRICTRC) apicSetIcrLoVirtualized(PVMCPUCC pVCpu, int rcRZ)
+{
+    VMCPU_ASSERT_EMT(pVCpu);
+
+    /* The CPU has already stored the value in the APIC page, send the IPI. */
+    PCXAPICPAGE pXApicPage = VMCPU_TO_CXAPICPAGE(pVCpu);
+    return apicSetIcrLo(pVCpu, pXApicPage->icr_lo.all.u32IcrLo, rcRZ, true /* fUpdateStat */);
+}
+
+
 /**
  * @interface_method_impl{PDMAPICBACKEND,pfnImportState}
  */
@@ -3083,5 +3173,10 @@ const PDMAPICBACKEND g_ApicBackend =
 #endif
     /* .pfnImportState = */             apicImportState,
     /* .pfnExportState = */             apicExportState,
+    /* .pfnSetIcrLoVirtualized = */     apicSetIcrLoVirtualized,
+#ifdef IN_RING0
+    /* .pfnGetPibForCpu = */            apicR0VBoxGetPibForCpu,
+    /* .pfnSetEoiVirtualized = */       apicR0VBoxSetEoiVirtualized,
+#endif
 };
 
@@ -13168,7 +13168,7 @@ FNIEMOP_DEF(iemOp_psubusb_Pq_Qq)
 FNIEMOP_DEF(iemOp_psubusb_Vx_Wx)
 {
     IEMOP_MNEMONIC2(RM, PSUBUSB, psubusb, Vx, Wx, DISOPTYPE_HARMLESS | DISOPTYPE_X86_SSE, IEMOPHINT_IGNORES_OP_SIZES);
-    return FNIEMOP_CALL_1(iemOpCommonSse2Opt_FullFull_To_Full, iemAImpl_psubusb_u128);
+    SSE2_OPT_BODY_FullFull_To_Full(psubusb, iemAImpl_psubusb_u128, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64);
 }
 
 
@@ -13187,7 +13187,7 @@ FNIEMOP_DEF(iemOp_psubusw_Pq_Qq)
 FNIEMOP_DEF(iemOp_psubusw_Vx_Wx)
 {
     IEMOP_MNEMONIC2(RM, PSUBUSW, psubusw, Vx, Wx, DISOPTYPE_HARMLESS | DISOPTYPE_X86_SSE, IEMOPHINT_IGNORES_OP_SIZES);
-    return FNIEMOP_CALL_1(iemOpCommonSse2Opt_FullFull_To_Full, iemAImpl_psubusw_u128);
+    SSE2_OPT_BODY_FullFull_To_Full(psubusw, iemAImpl_psubusw_u128, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64);
 }
 
 
@@ -13558,7 +13558,7 @@ FNIEMOP_DEF(iemOp_psubsb_Pq_Qq)
 FNIEMOP_DEF(iemOp_psubsb_Vx_Wx)
 {
     IEMOP_MNEMONIC2(RM, PSUBSB, psubsb, Vx, Wx, DISOPTYPE_HARMLESS | DISOPTYPE_X86_SSE, IEMOPHINT_IGNORES_OP_SIZES);
-    return FNIEMOP_CALL_1(iemOpCommonSse2Opt_FullFull_To_Full, iemAImpl_psubsb_u128);
+    SSE2_OPT_BODY_FullFull_To_Full(psubsb, iemAImpl_psubsb_u128, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64);
 }
 
 
@@ -13577,7 +13577,7 @@ FNIEMOP_DEF(iemOp_psubsw_Pq_Qq)
 FNIEMOP_DEF(iemOp_psubsw_Vx_Wx)
 {
     IEMOP_MNEMONIC2(RM, PSUBSW, psubsw, Vx, Wx, DISOPTYPE_HARMLESS | DISOPTYPE_X86_SSE, IEMOPHINT_IGNORES_OP_SIZES);
-    return FNIEMOP_CALL_1(iemOpCommonSse2Opt_FullFull_To_Full, iemAImpl_psubsw_u128);
+    SSE2_OPT_BODY_FullFull_To_Full(psubsw, iemAImpl_psubsw_u128, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64);
 }
 
 
@@ -13636,7 +13636,7 @@ FNIEMOP_DEF(iemOp_paddsb_Pq_Qq)
 FNIEMOP_DEF(iemOp_paddsb_Vx_Wx)
 {
     IEMOP_MNEMONIC2(RM, PADDSB, paddsb, Vx, Wx, DISOPTYPE_HARMLESS | DISOPTYPE_X86_SSE, IEMOPHINT_IGNORES_OP_SIZES);
-    return FNIEMOP_CALL_1(iemOpCommonSse2Opt_FullFull_To_Full, iemAImpl_paddsb_u128);
+    SSE2_OPT_BODY_FullFull_To_Full(paddsb, iemAImpl_paddsb_u128, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64);
 }
 
 
@@ -13655,7 +13655,7 @@ FNIEMOP_DEF(iemOp_paddsw_Pq_Qq)
 FNIEMOP_DEF(iemOp_paddsw_Vx_Wx)
 {
     IEMOP_MNEMONIC2(RM, PADDSW, paddsw, Vx, Wx, DISOPTYPE_HARMLESS | DISOPTYPE_X86_SSE, IEMOPHINT_IGNORES_OP_SIZES);
-    return FNIEMOP_CALL_1(iemOpCommonSse2Opt_FullFull_To_Full, iemAImpl_paddsw_u128);
+    SSE2_OPT_BODY_FullFull_To_Full(paddsw, iemAImpl_paddsw_u128, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64, RT_ARCH_VAL_AMD64 | RT_ARCH_VAL_ARM64);
 }
 
 
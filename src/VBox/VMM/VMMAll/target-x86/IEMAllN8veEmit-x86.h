@@ -2735,6 +2735,24 @@ IEMNATIVE_NATIVE_EMIT_ARITH_OP_U128(psubq, kArmv8VecInstrArithOp_Sub, kArmv8VecI
 IEMNATIVE_NATIVE_EMIT_ARITH_OP_U128(paddusb, kArmv8VecInstrArithOp_UnsignSat_Add, kArmv8VecInstrArithSz_8,  0xdc);
 IEMNATIVE_NATIVE_EMIT_ARITH_OP_U128(paddusw, kArmv8VecInstrArithOp_UnsignSat_Add, kArmv8VecInstrArithSz_16, 0xdd);
 
+/*
+ * PSUBUSx.
+ */
+IEMNATIVE_NATIVE_EMIT_ARITH_OP_U128(psubusb, kArmv8VecInstrArithOp_UnsignSat_Sub, kArmv8VecInstrArithSz_8,  0xd8);
+IEMNATIVE_NATIVE_EMIT_ARITH_OP_U128(psubusw, kArmv8VecInstrArithOp_UnsignSat_Sub, kArmv8VecInstrArithSz_16, 0xd9);
+
+/*
+ * PADDSx.
+ */
+IEMNATIVE_NATIVE_EMIT_ARITH_OP_U128(paddsb, kArmv8VecInstrArithOp_SignSat_Add, kArmv8VecInstrArithSz_8,  0xec);
+IEMNATIVE_NATIVE_EMIT_ARITH_OP_U128(paddsw, kArmv8VecInstrArithOp_SignSat_Add, kArmv8VecInstrArithSz_16, 0xed);
+
+/*
+ * PSUBSx.
+ */
+IEMNATIVE_NATIVE_EMIT_ARITH_OP_U128(psubsb, kArmv8VecInstrArithOp_SignSat_Sub, kArmv8VecInstrArithSz_8,  0xe8);
+IEMNATIVE_NATIVE_EMIT_ARITH_OP_U128(psubsw, kArmv8VecInstrArithOp_SignSat_Sub, kArmv8VecInstrArithSz_16, 0xe9);
+
 /*
  * PMULLx.
  */
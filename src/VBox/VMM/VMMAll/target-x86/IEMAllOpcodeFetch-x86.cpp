@@ -370,7 +370,7 @@ void iemOpcodeFetchBytesJmp(PVMCPUCC pVCpu, size_t cbDst, void *pvDst) IEM_NOEXC
                ASSUMES these are set when the address is translated rather than on commit... */
             /** @todo testcase: check when A bits are actually set by the CPU for code.  */
             PGMPTWALKFAST WalkFast;
-            int rc = PGMGstQueryPageFast(pVCpu, GCPtrFirst,
+            int rc = iemTlbQueryPageFast(pVCpu, &ITLBS(pVCpu).Code, GCPtrFirst,
                                          IEM_GET_CPL(pVCpu) == 3 ? PGMQPAGE_F_EXECUTE | PGMQPAGE_F_USER_MODE : PGMQPAGE_F_EXECUTE,
                                          &WalkFast);
             if (RT_SUCCESS(rc))
@@ -1015,6 +1015,50 @@ static RTGCPTR iemOpHlpCalcRmEffAddrThreadedAddr64(PVMCPUCC pVCpu, uint8_t bRmEx
 }
 
 
+/*
+ * Flag-less binary operator helpers for the _NoEfl threaded function twins.
+ *
+ * These are used instead of the regular iemAImpl_xxx_uNN helpers when the
+ * liveness analysis has determined that the status flags produced by the
+ * instruction will be clobbered before being used (see
+ * iemNativeLivenessMarkDeadEFlagsCalls).  They return the input EFLAGS
+ * unchanged, so the following commit leaves the dead flags as they were.
+ */
+#define IEM_NOEFL_BIN_OP(a_Ins, a_cBits, a_Expr) \
+    DECL_FORCE_INLINE(uint32_t) RT_CONCAT4(iemAImpl_,a_Ins,_u,a_cBits##_noefl)(uint32_t fEFlags, \
+                                                                             RT_CONCAT3(uint,a_cBits,_t) *puDst, \
+                                                                             RT_CONCAT3(uint,a_cBits,_t) uSrc) \
+    { \
+        *puDst = (RT_CONCAT3(uint,a_cBits,_t))(a_Expr); \
+        return fEFlags; \
+    }
+#define IEM_NOEFL_BIN_RO_OP(a_Ins, a_cBits) \
+    DECL_FORCE_INLINE(uint32_t) RT_CONCAT4(iemAImpl_,a_Ins,_u,a_cBits##_noefl)(uint32_t fEFlags, \
+                                                                             RT_CONCAT3(uint,a_cBits,_t) const *puDst, \
+                                                                             RT_CONCAT3(uint,a_cBits,_t) uSrc) \
+    { \
+        RT_NOREF(puDst, uSrc); \
+        return fEFlags; \
+    }
+#define IEM_NOEFL_BIN_OPS(a_cBits) \
+    IEM_NOEFL_BIN_OP(add, a_cBits, *puDst + uSrc) \
+    IEM_NOEFL_BIN_OP(adc, a_cBits, *puDst + uSrc + (fEFlags & X86_EFL_CF)) \
+    IEM_NOEFL_BIN_OP(sub, a_cBits, *puDst - uSrc) \
+    IEM_NOEFL_BIN_OP(sbb, a_cBits, *puDst - uSrc - (fEFlags & X86_EFL_CF)) \
+    IEM_NOEFL_BIN_OP(or,  a_cBits, *puDst | uSrc) \
+    IEM_NOEFL_BIN_OP(xor, a_cBits, *puDst ^ uSrc) \
+    IEM_NOEFL_BIN_OP(and, a_cBits, *puDst & uSrc) \
+    IEM_NOEFL_BIN_RO_OP(cmp,  a_cBits) \
+    IEM_NOEFL_BIN_RO_OP(test, a_cBits)
+IEM_NOEFL_BIN_OPS(8)
+IEM_NOEFL_BIN_OPS(16)
+IEM_NOEFL_BIN_OPS(32)
+IEM_NOEFL_BIN_OPS(64)
+#undef IEM_NOEFL_BIN_OPS
+#undef IEM_NOEFL_BIN_RO_OP
+#undef IEM_NOEFL_BIN_OP
+
+
 /*
  * The threaded functions.
  */
@@ -69,6 +69,155 @@ DECL_FORCE_INLINE(void) iemTlbLoadedLargePage(PVMCPUCC pVCpu, IEMTLB *pTlb, RTGC
 }
 
 
+# ifdef IEMTLB_WITH_L2_LARGE_PAGES
+
+/** Calculates the second level TLB tag (sans revision) for @a a_GCPtr. */
+#  define IEMTLB_L2_CALC_TAG_NO_REV(a_GCPtr)    ( (((a_GCPtr) << 16) >> (IEMTLB_L2_GRANULE_SHIFT + 16)) )
+/** Converts a second level TLB tag to an aL2Entries index. */
+#  define IEMTLB_L2_TAG_TO_INDEX(a_uTag)        ( (uintptr_t)(a_uTag) & (IEMTLB_L2_ENTRY_COUNT - 1U) )
+
+/**
+ * Tries to resolve a main TLB miss using the second level large page TLB.
+ *
+ * This only succeeds if the page walk would have succeeded w/o raising any
+ * fault or having to set any accessed or dirty bits, so the caller can treat
+ * the result exactly like a successful PGMGstQueryPageFast call.
+ *
+ * @returns true and @a pWalkFast filled in on hit, false on miss.
+ * @param   pTlb        The TLB.
+ * @param   GCPtr       The address being translated.
+ * @param   fQPage      The PGMQPAGE_F_XXX flags for the access.
+ * @param   fNxe        Whether EFER.NXE is set.
+ * @param   pWalkFast   Where to return the synthesized walk result.
+ */
+DECL_FORCE_INLINE(bool) iemTlbL2Lookup(IEMTLB *pTlb, RTGCPTR GCPtr, uint32_t fQPage, bool fNxe, PPGMPTWALKFAST pWalkFast)
+{
+    uint64_t const            uTagNoRev = IEMTLB_L2_CALC_TAG_NO_REV(GCPtr);
+    IEMTLBL2ENTRY const * const pL2e    = &pTlb->aL2Entries[IEMTLB_L2_TAG_TO_INDEX(uTagNoRev)];
+    if (pL2e->uTag != (uTagNoRev | (pL2e->fGlobal ? pTlb->uTlbRevisionGlobal : pTlb->uTlbRevision)))
+        return false;
+
+    uint64_t const fEff = pL2e->fEffective;
+    if (   (fQPage & PGMQPAGE_F_USER_MODE)
+        && !(fEff & PGM_PTATTRS_US_MASK))
+        return false;
+    if (   (fQPage & PGMQPAGE_F_WRITE)
+        && (   !(fEff & PGM_PTATTRS_D_MASK)
+            || (   !(fEff & PGM_PTATTRS_W_MASK)
+                && (fQPage & (PGMQPAGE_F_CR0_WP0 | PGMQPAGE_F_USER_MODE)) != PGMQPAGE_F_CR0_WP0)))
+        return false;
+    if (   (fQPage & PGMQPAGE_F_EXECUTE)
+        && (fEff & PGM_PTATTRS_NX_MASK)
+        && fNxe)
+        return false;
+
+    pTlb->cTlbL2Hits++;
+    pWalkFast->GCPtr        = GCPtr;
+    pWalkFast->GCPhys       = pL2e->GCPhys | (GCPtr & (RT_BIT_64(IEMTLB_L2_GRANULE_SHIFT) - 1U));
+    pWalkFast->GCPhysNested = 0;
+    pWalkFast->fInfo        = pL2e->fInfo;
+    pWalkFast->fFailed      = PGM_WALKFAIL_SUCCESS;
+    pWalkFast->fEffective   = fEff;
+    return true;
+}
+
+
+/**
+ * Loads a second level large page TLB entry after a successful page walk.
+ *
+ * @param   pVCpu       The cross context virtual CPU structure of the calling EMT.
+ * @param   pTlb        The TLB.
+ * @param   pWalkFast   The walk result.
+ */
+DECL_FORCE_INLINE(void) iemTlbL2Load(PVMCPUCC pVCpu, IEMTLB *pTlb, PCPGMPTWALKFAST pWalkFast)
+{
+    /* Only large pages, and not when there is a second-level translation
+       involved (the nested paging tables may well use smaller pages). */
+    if ((pWalkFast->fInfo & (PGM_WALKINFO_BIG_PAGE | PGM_WALKINFO_IS_SLAT)) != PGM_WALKINFO_BIG_PAGE)
+        return;
+
+    bool const       fGlobal   = (pWalkFast->fEffective & PGM_PTATTRS_G_MASK) && IEM_GET_CPL(pVCpu) == 0;
+    uint64_t const   uTagNoRev = IEMTLB_L2_CALC_TAG_NO_REV(pWalkFast->GCPtr);
+    IEMTLBL2ENTRY * const pL2e = &pTlb->aL2Entries[IEMTLB_L2_TAG_TO_INDEX(uTagNoRev)];
+    pL2e->uTag       = uTagNoRev | (fGlobal ? pTlb->uTlbRevisionGlobal : pTlb->uTlbRevision);
+    pL2e->GCPhys     = pWalkFast->GCPhys & ~(RTGCPHYS)(RT_BIT_64(IEMTLB_L2_GRANULE_SHIFT) - 1U);
+    pL2e->fEffective = pWalkFast->fEffective;
+    pL2e->fInfo      = pWalkFast->fInfo;
+    pL2e->fGlobal    = fGlobal;
+    pTlb->cTlbL2Loads++;
+    if (pWalkFast->fInfo & PGM_WALKINFO_GIGANTIC_PAGE)
+        pTlb->cTlbL2CurGiganticLoads++;
+}
+
+
+/**
+ * Wipes the whole second level large page TLB.
+ */
+DECL_FORCE_INLINE(void) iemTlbL2InvalidateAll(IEMTLB *pTlb)
+{
+    for (unsigned i = 0; i < RT_ELEMENTS(pTlb->aL2Entries); i++)
+        pTlb->aL2Entries[i].uTag = 0;
+    pTlb->cTlbL2CurGiganticLoads = 0;
+}
+
+
+/**
+ * Invalidates the second level large page TLB entries covering @a GCPtr.
+ *
+ * A 4MB page covers two 2MB granules, so we always drop the buddy granule too.
+ * 1GB pages span too many entries to bother, so we wipe everything if any have
+ * been loaded.
+ */
+DECL_FORCE_INLINE(void) iemTlbL2InvalidatePage(IEMTLB *pTlb, RTGCPTR GCPtr)
+{
+    if (!pTlb->cTlbL2CurGiganticLoads)
+    {
+        uint64_t const uTagNoRev = IEMTLB_L2_CALC_TAG_NO_REV(GCPtr);
+        pTlb->aL2Entries[IEMTLB_L2_TAG_TO_INDEX(uTagNoRev)].uTag     = 0;
+        pTlb->aL2Entries[IEMTLB_L2_TAG_TO_INDEX(uTagNoRev ^ 1)].uTag = 0;
+    }
+    else
+        iemTlbL2InvalidateAll(pTlb);
+}
+
+# endif /* IEMTLB_WITH_L2_LARGE_PAGES */
+
+
+/**
+ * Wrapper around PGMGstQueryPageFast for TLB misses that consults and feeds
+ * the second level large page TLB.
+ *
+ * The second level TLB is bypassed while the A20 gate is disabled, as the
+ * entries hold the physical address of the whole granule and cannot apply
+ * the A20 mask to the offset bits.
+ *
+ * @returns VBox status code, see PGMGstQueryPageFast.
+ * @param   pVCpu       The cross context virtual CPU structure of the calling EMT.
+ * @param   pTlb        The TLB that missed.
+ * @param   GCPtr       The address to translate.
+ * @param   fQPage      The PGMQPAGE_F_XXX flags for the access.
+ * @param   pWalkFast   Where to return the walk result.
+ */
+DECL_FORCE_INLINE(int) iemTlbQueryPageFast(PVMCPUCC pVCpu, IEMTLB *pTlb, RTGCPTR GCPtr, uint32_t fQPage, PPGMPTWALKFAST pWalkFast)
+{
+# ifdef IEMTLB_WITH_L2_LARGE_PAGES
+    if (RT_LIKELY(PGMPhysIsA20Enabled(pVCpu)))
+    {
+        if (iemTlbL2Lookup(pTlb, GCPtr, fQPage, RT_BOOL(pVCpu->cpum.GstCtx.msrEFER & MSR_K6_EFER_NXE), pWalkFast))
+            return VINF_SUCCESS;
+        int const rc = PGMGstQueryPageFast(pVCpu, GCPtr, fQPage, pWalkFast);
+        if (RT_SUCCESS(rc))
+            iemTlbL2Load(pVCpu, pTlb, pWalkFast);
+        return rc;
+    }
+    return PGMGstQueryPageFast(pVCpu, GCPtr, fQPage, pWalkFast);
+# else
+    RT_NOREF(pTlb);
+    return PGMGstQueryPageFast(pVCpu, GCPtr, fQPage, pWalkFast);
+# endif
+}
+
+
 /** @todo graduate this to cdefs.h or asm-mem.h.   */
 # ifdef RT_ARCH_ARM64              /** @todo RT_CACHELINE_SIZE is wrong for M1 */
 #  undef RT_CACHELINE_SIZE
@@ -282,6 +282,22 @@ VMM_INT_DECL(int) PDMApicBusDeliver(PVMCC pVM, uint8_t uDest, uint8_t uDestMode,
 }
 
 
+/**
+ * Sends the IPI for an ICR low dword write the CPU has already stored into the
+ * APIC page (APIC-write VM-exit with virtual-interrupt delivery).
+ *
+ * @returns Strict VBox status code.
+ * @retval  VINF_EM_PENDING_R3_APIC_ICR_WRITE if the IPI (INIT / SIPI) must be
+ *          sent from ring-3, in which case call this function again there.
+ * @param   pVCpu           The cross context virtual CPU structure.
+ */
+VMM_INT_DECL(VBOXSTRICTRC) PDMApicSetIcrLoVirtualized(PVMCPUCC pVCpu)
+{
+    AssertReturn(PDMCPU_TO_APICBACKEND(pVCpu)->pfnSetIcrLoVirtualized, VERR_INVALID_POINTER);
+    return PDMCPU_TO_APICBACKEND(pVCpu)->pfnSetIcrLoVirtualized(pVCpu, VINF_EM_PENDING_R3_APIC_ICR_WRITE);
+}
+
+
 #ifdef IN_RING0
 /**
  * Gets the APIC page pointers for the specified VCPU.
@@ -297,6 +313,34 @@ VMM_INT_DECL(int) PDMR0ApicGetApicPageForCpu(PCVMCPUCC pVCpu, PRTHCPHYS pHCPhys,
     AssertReturn(PDMCPU_TO_APICBACKEND(pVCpu)->pfnGetApicPageForCpu, VERR_INVALID_POINTER);
     return PDMCPU_TO_APICBACKEND(pVCpu)->pfnGetApicPageForCpu(pVCpu, pHCPhys, pR0Ptr, pR3Ptr);
 }
+
+
+/**
+ * Gets the posted-interrupt descriptor for the specified VCPU.
+ *
+ * @returns VBox status code.
+ * @param   pVCpu           The cross context virtual CPU structure.
+ * @param   pHCPhys         Where to store the host-context physical address.
+ */
+VMM_INT_DECL(int) PDMR0ApicGetPibForCpu(PCVMCPUCC pVCpu, PRTHCPHYS pHCPhys)
+{
+    AssertReturn(PDMCPU_TO_APICBACKEND(pVCpu)->pfnGetPibForCpu, VERR_INVALID_POINTER);
+    return PDMCPU_TO_APICBACKEND(pVCpu)->pfnGetPibForCpu(pVCpu, pHCPhys);
+}
+
+
+/**
+ * Completes an EOI virtualized by the CPU (virtualized-EOI VM-exit).
+ *
+ * @returns Strict VBox status code.
+ * @param   pVCpu           The cross context virtual CPU structure.
+ * @param   uVector         The vector the CPU cleared from the ISR.
+ */
+VMM_INT_DECL(VBOXSTRICTRC) PDMR0ApicSetEoiVirtualized(PVMCPUCC pVCpu, uint8_t uVector)
+{
+    AssertReturn(PDMCPU_TO_APICBACKEND(pVCpu)->pfnSetEoiVirtualized, VERR_INVALID_POINTER);
+    return PDMCPU_TO_APICBACKEND(pVCpu)->pfnSetEoiVirtualized(pVCpu, uVector);
+}
 #endif /* IN_RING0 */
 
 
@@ -2138,6 +2138,35 @@ DECLINLINE(void) pgmPoolHashRemove(PPGMPOOL pPool, PPGMPOOLPAGE pPage)
 }
 
 
+/**
+ * Checks if the given page kind is a leaf page table, i.e. one that doesn't
+ * reference any other pool pages.
+ *
+ * @returns true if leaf, false if not.
+ * @param   enmKind     The page kind.
+ */
+DECLINLINE(bool) pgmPoolIsLeafKind(uint8_t enmKind)
+{
+    switch (enmKind)
+    {
+        case PGMPOOLKIND_32BIT_PT_FOR_PHYS:
+        case PGMPOOLKIND_32BIT_PT_FOR_32BIT_PT:
+        case PGMPOOLKIND_32BIT_PT_FOR_32BIT_4MB:
+        case PGMPOOLKIND_PAE_PT_FOR_PHYS:
+        case PGMPOOLKIND_PAE_PT_FOR_32BIT_PT:
+        case PGMPOOLKIND_PAE_PT_FOR_32BIT_4MB:
+        case PGMPOOLKIND_PAE_PT_FOR_PAE_PT:
+        case PGMPOOLKIND_PAE_PT_FOR_PAE_2MB:
+        case PGMPOOLKIND_EPT_PT_FOR_PHYS:
+        case PGMPOOLKIND_EPT_PT_FOR_EPT_PT:
+        case PGMPOOLKIND_EPT_PT_FOR_EPT_2MB:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
 /**
  * Frees up one cache page.
  *
@@ -2176,6 +2205,29 @@ static int pgmPoolCacheFreeOne(PPGMPOOL pPool, uint16_t iUser)
             }
         }
 */
+
+        /*
+         * Flushing a page directory or anything higher up takes all the tables
+         * below it along, which is what turns pool pressure into noticable
+         * latency spikes.  So, if the tail isn't a leaf page table, look a few
+         * entries further up the age list for one.  This keeps the policy close
+         * to LRU while sparing the upper levels that are likely to be reused.
+         */
+        if (   iToFree != NIL_PGMPOOL_IDX
+            && !pgmPoolIsLeafKind(pPool->aPages[iToFree].enmKind))
+        {
+            uint16_t i = pPool->aPages[iToFree].iAgePrev;
+            for (unsigned j = 0; j < PGMPOOL_CACHE_FREE_LEAF_SCAN && i != NIL_PGMPOOL_IDX; j++, i = pPool->aPages[i].iAgePrev)
+                if (   i != iUser
+                    && pgmPoolIsLeafKind(pPool->aPages[i].enmKind)
+                    && !pgmPoolIsPageLocked(&pPool->aPages[i]))
+                {
+                    STAM_COUNTER_INC(&pPool->StatCacheFreeUpOneLeaf);
+                    iToFree = i;
+                    break;
+                }
+        }
+
         Assert(iToFree != iUser);
         AssertReleaseMsg(iToFree != NIL_PGMPOOL_IDX,
                          ("iToFree=%#x (iAgeTail=%#x) iUser=%#x iLoop=%u - pPool=%p LB %#zx\n",
@@ -2201,6 +2253,8 @@ static int pgmPoolCacheFreeOne(PPGMPOOL pPool, uint16_t iUser)
     /*
      * Found a usable page, flush it and return.
      */
+    if (!pgmPoolIsLeafKind(pPage->enmKind))
+        STAM_COUNTER_INC(&pPool->StatCacheFreeUpOneNonLeaf);
     int rc = pgmPoolFlushPage(pPool, pPage);
     /* This flush was initiated by us and not the guest, so explicitly flush the TLB. */
     /** @todo find out why this is necessary; pgmPoolFlushPage should trigger a flush if one is really needed. */
@@ -5311,6 +5365,10 @@ int pgmPoolFlushPage(PPGMPOOL pPool, PPGMPOOLPAGE pPage, bool fFlush)
     Assert(pPage->iNext == NIL_PGMPOOL_IDX);
     pPage->iNext = pPool->iFreeHead;
     pPool->iFreeHead = pPage->idx;
+#ifdef VBOX_WITH_STATISTICS
+    Assert(pPool->acPagesPerKind[pPage->enmKind] > 0);
+    pPool->acPagesPerKind[pPage->enmKind]--;
+#endif
     pPage->enmKind = PGMPOOLKIND_FREE;
     pPage->enmAccess = PGMPOOLACCESS_DONTCARE;
     pPage->GCPhys = NIL_RTGCPHYS;
@@ -5488,6 +5546,9 @@ int pgmPoolAlloc(PVMCC pVM, RTGCPHYS GCPhys, PGMPOOLKIND enmKind, PGMPOOLACCESS
      * Initialize it.
      */
     pPool->cUsedPages++;                /* physical handler registration / pgmPoolTrackFlushGCPhysPTsSlow requirement. */
+#ifdef VBOX_WITH_STATISTICS
+    pPool->acPagesPerKind[enmKind]++;
+#endif
     pPage->enmKind = enmKind;
     pPage->enmAccess = enmAccess;
     pPage->GCPhys = GCPhys;
@@ -5518,6 +5579,9 @@ int pgmPoolAlloc(PVMCC pVM, RTGCPHYS GCPhys, PGMPOOLKIND enmKind, PGMPOOLACCESS
     if (RT_FAILURE(rc3))
     {
         pPool->cUsedPages--;
+#ifdef VBOX_WITH_STATISTICS
+        pPool->acPagesPerKind[enmKind]--;
+#endif
         pPage->enmKind      = PGMPOOLKIND_FREE;
         pPage->enmAccess    = PGMPOOLACCESS_DONTCARE;
         pPage->GCPhys       = NIL_RTGCPHYS;
@@ -5814,6 +5878,9 @@ void pgmR3PoolReset(PVM pVM)
     pPool->aPages[pPool->cCurPages - 1].iNext = NIL_PGMPOOL_IDX;
     pPool->iFreeHead = PGMPOOL_IDX_FIRST;
     pPool->cUsedPages = 0;
+#ifdef VBOX_WITH_STATISTICS
+    RT_ZERO(pPool->acPagesPerKind);
+#endif
 
     /*
      * Zap and reinitialize the user records.
@@ -166,6 +166,15 @@
  * Both the scheduler and allocator interface will to supply some NUMA info
  * and we'll need to have a way to calc access costs.
  *
+ *
+ * @section sec_gmm_zeroing     Background Zeroing
+ *
+ * Pages freed by a VM go back on the chunk free lists dirty and would have to
+ * be zeroed by PGM on the EMT when they are handed out again.  A low priority
+ * kernel thread walks the chunks with dirty free pages and zeroes them in
+ * small batches, releasing the giant mutex between batches, so that most
+ * pages handed out are already zeroed (GMMPAGEDESC::fZeroed).
+ *
  */
 
 
@@ -184,9 +193,7 @@
 #include <VBox/VMMDev.h>
 #include <iprt/asm.h>
 #include <iprt/avl.h>
-#ifdef VBOX_STRICT
-# include <iprt/crc.h>
-#endif
+#include <iprt/crc.h>
 #include <iprt/critsect.h>
 #include <iprt/list.h>
 #include <iprt/mem.h>
@@ -195,6 +202,7 @@
 #include <iprt/semaphore.h>
 #include <iprt/spinlock.h>
 #include <iprt/string.h>
+#include <iprt/thread.h>
 #include <iprt/time.h>
 
 /* This is 64-bit only code now. */
@@ -407,7 +415,9 @@ typedef struct GMMCHUNK
     uint16_t            cShared;
     /** The UID this chunk is associated with. */
     RTUID               uidOwner;
-    uint32_t            u32Padding;
+    /** The number of free pages that have not been zeroed yet.  (Giant mtx.) */
+    uint16_t            cFreeUnzeroed;
+    uint16_t            u16Padding;
     /** The pages.  (Giant mtx.) */
     GMMPAGE             aPages[GMM_CHUNK_NUM_PAGES];
 } GMMCHUNK;
@@ -501,6 +511,28 @@ typedef struct GMM
     /** Sharable modules (count of nodes in pGlobalSharedModuleTree). */
     uint32_t            cShareableModules;
 
+    /** Duplicate page scanner: Shared pages keyed by content hash (GMMSCANPAGENODE). */
+    PAVLU32NODECORE     pScanSharedTree;
+    /** Duplicate page scanner: Private pages seen earlier that may have twins,
+     * keyed by content hash (GMMSCANPAGENODE). */
+    PAVLU32NODECORE     pScanCandidateTree;
+    /** Number of nodes in pScanSharedTree. */
+    uint32_t            cScanSharedNodes;
+    /** Number of nodes in pScanCandidateTree. */
+    uint32_t            cScanCandidateNodes;
+
+    /** Background zeroing: The worker thread, NIL_RTTHREAD if not running. */
+    RTTHREAD            hZeroThread;
+    /** Background zeroing: The event semaphore the worker thread waits on. */
+    RTSEMEVENT          hZeroEvent;
+    /** Background zeroing: Set when the worker thread should terminate. */
+    bool volatile       fZeroThreadTerminate;
+    /** Background zeroing: The ID of the next chunk to look at.  (Giant mtx.) */
+    uint32_t            idZeroChunkNext;
+    /** Background zeroing: The number of free pages zeroed ahead of
+     * allocation.  (Giant mtx.) */
+    uint64_t            cPreZeroedPages;
+
     /** The chunk list.  For simplifying the cleanup process and avoid tree
      * traversal. */
     RTLISTANCHOR        ChunkList;
@@ -627,6 +659,40 @@ typedef struct GMMCHECKSHAREDMODULEINFO
 } GMMCHECKSHAREDMODULEINFO;
 
 
+/** The max number of pages a GMMR0ScanDuplicatePagesReq call may look at.
+ * All EMTs of the VM are stalled while scanning, so keep this moderate. */
+#define GMM_SCAN_MAX_PAGES_PER_CALL     _16K
+/** The max number of nodes in each of the duplicate page scanner trees. */
+#define GMM_SCAN_MAX_TREE_NODES         _256K
+/** Shared pages with this many references are not used as merge targets any
+ * more, a fresh shared page takes over. (GMMPAGE::Shared::cRefs is 16-bit.) */
+#define GMM_SCAN_MAX_SHARED_REFS        (UINT16_MAX - 256)
+
+/** The max number of pages the background zeroing thread zeroes while holding
+ * the giant mutex. */
+#define GMM_ZERO_BATCH_PAGES            64
+/** How long the background zeroing thread sleeps when there is nothing to do
+ * (milliseconds). */
+#define GMM_ZERO_IDLE_WAIT_MS           1000
+
+/**
+ * Duplicate page scanner hash tree node.
+ *
+ * The key is a content hash, so any hit must be verified with memcmp before
+ * acting on it.  The page IDs are not kept up to date when pages are freed,
+ * so they must also be validated on lookup.
+ */
+typedef struct GMMSCANPAGENODE
+{
+    /** The AVL node core, the key is the content hash. */
+    AVLU32NODECORE          Core;
+    /** The ID of the page that had this content when the node was updated. */
+    uint32_t                idPage;
+} GMMSCANPAGENODE;
+/** Pointer to a duplicate page scanner hash tree node. */
+typedef GMMSCANPAGENODE *PGMMSCANPAGENODE;
+
+
 /*********************************************************************************************************************************
 *   Global Variables                                                                                                             *
 *********************************************************************************************************************************/
@@ -719,11 +785,13 @@ DECLINLINE(void)            gmmR0SelectSetAndLinkChunk(PGMM pGMM, PGVM pGVM, PGM
 static uint32_t             gmmR0SanityCheck(PGMM pGMM, const char *pszFunction, unsigned uLineNo);
 #endif
 static bool                 gmmR0FreeChunk(PGMM pGMM, PGVM pGVM, PGMMCHUNK pChunk, bool fRelaxedSem);
+static DECLCALLBACK(int)    gmmR0ZeroThread(RTTHREAD hThreadSelf, void *pvGMM);
 DECLINLINE(void)            gmmR0FreePrivatePage(PGMM pGMM, PGVM pGVM, uint32_t idPage, PGMMPAGE pPage);
 DECLINLINE(void)            gmmR0FreeSharedPage(PGMM pGMM, PGVM pGVM, uint32_t idPage, PGMMPAGE pPage);
 static int                  gmmR0UnmapChunkLocked(PGMM pGMM, PGVM pGVM, PGMMCHUNK pChunk);
 #ifdef VBOX_WITH_PAGE_SHARING
 static void                 gmmR0SharedModuleCleanup(PGMM pGMM, PGVM pGVM);
+static void                 gmmR0ScanDestroyTree(PAVLU32NODECORE *ppTree, uint32_t *pcNodes);
 # ifdef VBOX_STRICT
 static uint32_t             gmmR0StrictPageChecksum(PGMM pGMM, PGVM pGVM, uint32_t idPage);
 # endif
@@ -817,6 +885,29 @@ VMMR0_INT_DECL(int) GMMR0Init(void)
             pGMM->idFreeGeneration = UINT64_MAX / 4 - 128;
 
             g_pGMM = pGMM;
+
+            /*
+             * Start the background zeroing thread.  Not fatal if this fails,
+             * the pages will just be zeroed on allocation as before.
+             */
+            pGMM->hZeroThread = NIL_RTTHREAD;
+            int rc2 = RTSemEventCreate(&pGMM->hZeroEvent);
+            if (RT_SUCCESS(rc2))
+            {
+                rc2 = RTThreadCreate(&pGMM->hZeroThread, gmmR0ZeroThread, pGMM, 0 /*cbStack*/,
+                                     RTTHREADTYPE_INFREQUENT_POLLER, RTTHREADFLAGS_WAITABLE, "GMMZero");
+                if (RT_FAILURE(rc2))
+                {
+                    pGMM->hZeroThread = NIL_RTTHREAD;
+                    RTSemEventDestroy(pGMM->hZeroEvent);
+                    pGMM->hZeroEvent = NIL_RTSEMEVENT;
+                }
+            }
+            else
+                pGMM->hZeroEvent = NIL_RTSEMEVENT;
+            if (RT_FAILURE(rc2))
+                SUPR0Printf("GMMR0Init: Warning! Failed to start the background zeroing thread: %d\n", rc2);
+
 #ifdef VBOX_WITH_LINEAR_HOST_PHYS_MEM
             LogFlow(("GMMInit: pGMM=%p fBoundMemoryMode=%RTbool fHasWorkingAllocPhysNC=%RTbool\n", pGMM, pGMM->fBoundMemoryMode, pGMM->fHasWorkingAllocPhysNC));
 #else
@@ -868,6 +959,21 @@ VMMR0_INT_DECL(void) GMMR0Term(void)
     /*
      * Undo what init did and free all the resources we've acquired.
      */
+    /* Stop the background zeroing thread first as it uses the giant mutex. */
+    if (pGMM->hZeroThread != NIL_RTTHREAD)
+    {
+        ASMAtomicWriteBool(&pGMM->fZeroThreadTerminate, true);
+        RTSemEventSignal(pGMM->hZeroEvent);
+        int rc = RTThreadWait(pGMM->hZeroThread, RT_MS_30SEC, NULL);
+        AssertRC(rc);
+        pGMM->hZeroThread = NIL_RTTHREAD;
+    }
+    if (pGMM->hZeroEvent != NIL_RTSEMEVENT)
+    {
+        RTSemEventDestroy(pGMM->hZeroEvent);
+        pGMM->hZeroEvent = NIL_RTSEMEVENT;
+    }
+
     /* Destroy the fundamentals. */
     g_pGMM = NULL;
     pGMM->u32Magic    = ~GMM_MAGIC;
@@ -882,6 +988,12 @@ VMMR0_INT_DECL(void) GMMR0Term(void)
     RTSpinlockDestroy(pGMM->hSpinLockChunkId);
     pGMM->hSpinLockChunkId = NIL_RTSPINLOCK;
 
+#ifdef VBOX_WITH_PAGE_SHARING
+    /* Free the duplicate page scanner trees. */
+    gmmR0ScanDestroyTree(&pGMM->pScanSharedTree, &pGMM->cScanSharedNodes);
+    gmmR0ScanDestroyTree(&pGMM->pScanCandidateTree, &pGMM->cScanCandidateNodes);
+#endif
+
     /* Free any chunks still hanging around. */
     RTAvlU32Destroy(&pGMM->pChunks, gmmR0TermDestroyChunk, pGMM);
 
@@ -1056,6 +1168,99 @@ static bool gmmR0MutexYield(PGMM pGMM, uint64_t *puLockNanoTS)
 }
 
 
+/**
+ * Zeroes a batch of dirty free pages, called by the background zeroing thread.
+ *
+ * Continues where the previous call left off and looks at each chunk at most
+ * once per call.
+ *
+ * @returns Number of pages zeroed.
+ * @param   pGMM        Pointer to the GMM instance data.
+ * @param   cMaxPages   The max number of pages to zero.
+ */
+static uint32_t gmmR0ZeroFreePages(PGMM pGMM, uint32_t cMaxPages)
+{
+    int rc = gmmR0MutexAcquire(pGMM);
+    if (RT_FAILURE(rc))
+        return 0;
+
+    uint32_t cZeroed     = 0;
+    uint32_t cChunksLeft = pGMM->cChunks;
+    while (cZeroed < cMaxPages && cChunksLeft-- > 0)
+    {
+        /* Chunks are only removed from the tree while owning the giant mutex,
+           so the chunk stays valid till we release it. */
+        RTSpinlockAcquire(pGMM->hSpinLockTree);
+        PGMMCHUNK pChunk = (PGMMCHUNK)RTAvlU32GetBestFit(&pGMM->pChunks, pGMM->idZeroChunkNext, true /*fAbove*/);
+        if (!pChunk)
+            pChunk = (PGMMCHUNK)RTAvlU32GetBestFit(&pGMM->pChunks, 0, true /*fAbove*/);
+        RTSpinlockRelease(pGMM->hSpinLockTree);
+        if (!pChunk)
+            break;
+        pGMM->idZeroChunkNext = pChunk->Core.Key + 1;
+
+        if (!pChunk->cFreeUnzeroed)
+            continue;
+
+        for (uint32_t iPage = pChunk->iFreeHead;
+             iPage < RT_ELEMENTS(pChunk->aPages) && pChunk->cFreeUnzeroed > 0;
+             iPage = pChunk->aPages[iPage].Free.iNext)
+        {
+            PGMMPAGE pPage = &pChunk->aPages[iPage];
+            Assert(GMM_PAGE_IS_FREE(pPage));
+            if (pPage->Free.fZeroed)
+                continue;
+            if (cZeroed >= cMaxPages)
+            {
+                /* Resume with this chunk the next time around. */
+                pGMM->idZeroChunkNext = pChunk->Core.Key;
+                break;
+            }
+
+#ifdef VBOX_WITH_LINEAR_HOST_PHYS_MEM
+            void *pvPage = NULL;
+            rc = SUPR0HCPhysToVirt(RTR0MemObjGetPagePhysAddr(pChunk->hMemObj, iPage), &pvPage);
+            AssertRCBreak(rc);
+#else
+            void *pvPage = &pChunk->pbMapping[iPage << GUEST_PAGE_SHIFT];
+#endif
+            RT_BZERO(pvPage, GUEST_PAGE_SIZE);
+            pPage->Free.fZeroed = true;
+            pChunk->cFreeUnzeroed--;
+            cZeroed++;
+        }
+    }
+
+    pGMM->cPreZeroedPages += cZeroed;
+    gmmR0MutexRelease(pGMM);
+    return cZeroed;
+}
+
+
+/**
+ * The background zeroing thread.
+ *
+ * @returns VINF_SUCCESS.
+ * @param   hThreadSelf The thread handle.
+ * @param   pvGMM       Pointer to the GMM instance data.
+ */
+static DECLCALLBACK(int) gmmR0ZeroThread(RTTHREAD hThreadSelf, void *pvGMM)
+{
+    PGMM pGMM = (PGMM)pvGMM;
+    RT_NOREF(hThreadSelf);
+
+    while (!ASMAtomicReadBool(&pGMM->fZeroThreadTerminate))
+    {
+        uint32_t const cZeroed = gmmR0ZeroFreePages(pGMM, GMM_ZERO_BATCH_PAGES);
+        if (cZeroed < GMM_ZERO_BATCH_PAGES)
+            RTSemEventWait(pGMM->hZeroEvent, GMM_ZERO_IDLE_WAIT_MS);
+        else
+            RTThreadYield();
+    }
+    return VINF_SUCCESS;
+}
+
+
 /**
  * Acquires a chunk lock.
  *
@@ -1449,6 +1654,7 @@ static bool gmmR0CleanupVMScanChunk(PGMM pGMM, PGVM pGVM, PGMMCHUNK pChunk)
                     pChunk->iFreeHead = iPage;
                     pChunk->cPrivate--;
                     pChunk->cFree++;
+                    pChunk->cFreeUnzeroed++;
                     pGVM->gmm.s.Stats.cPrivatePages--;
                     cFree++;
                 }
@@ -2109,6 +2315,11 @@ static void gmmR0AllocatePage(PGMMCHUNK pChunk, uint32_t hGVM, PGMMPAGEDESC pPag
           pPage->Common.u2State, pChunk->iFreeHead, pPage->Free.iNext));
 
     bool const fZeroed = pPage->Free.fZeroed;
+    if (!fZeroed)
+    {
+        Assert(pChunk->cFreeUnzeroed > 0);
+        pChunk->cFreeUnzeroed--;
+    }
 
     /* make the page private. */
     pPage->u = 0;
@@ -3660,6 +3871,10 @@ static void gmmR0FreePageWorker(PGMM pGMM, PGVM pGVM, PGMMCHUNK pChunk, uint32_t
     pPage->Free.iNext = pChunk->iFreeHead;
     pChunk->iFreeHead = pPage - &pChunk->aPages[0];
 
+    /* Wake up the background zeroing thread when the chunk turns dirty. */
+    if (pChunk->cFreeUnzeroed++ == 0 && pGMM->hZeroEvent != NIL_RTSEMEVENT)
+        RTSemEventSignal(pGMM->hZeroEvent);
+
     /*
      * Update statistics (the cShared/cPrivate stats are up to date already),
      * and relink the chunk if necessary.
@@ -5514,6 +5729,280 @@ VMMR0_INT_DECL(int) GMMR0CheckSharedModules(PGVM pGVM, VMCPUID idCpu)
 #endif
 }
 
+#ifdef VBOX_WITH_PAGE_SHARING
+
+/**
+ * RTAvlU32Destroy callback for the duplicate page scanner trees.
+ */
+static DECLCALLBACK(int) gmmR0ScanDestroyNode(PAVLU32NODECORE pNode, void *pvUser)
+{
+    RT_NOREF(pvUser);
+    RTMemFree(pNode);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Empties one of the duplicate page scanner trees.
+ *
+ * This only drops our knowledge about page content; the pages themselves are
+ * not affected in any way.
+ *
+ * @param   ppTree      The tree root.
+ * @param   pcNodes     The node counter for the tree.
+ */
+static void gmmR0ScanDestroyTree(PAVLU32NODECORE *ppTree, uint32_t *pcNodes)
+{
+    RTAvlU32Destroy(ppTree, gmmR0ScanDestroyNode, NULL);
+    *pcNodes = 0;
+}
+
+
+/**
+ * Gets the ring-0 address of a page for the duplicate page scanner.
+ *
+ * @returns Pointer to the page content, NULL if not available.
+ * @param   pGMM        The GMM instance data.
+ * @param   idPage      The page ID.
+ */
+DECLINLINE(uint8_t const *) gmmR0ScanGetPageR0Ptr(PGMM pGMM, uint32_t idPage)
+{
+# ifndef VBOX_WITH_LINEAR_HOST_PHYS_MEM
+    PGMMCHUNK pChunk = gmmR0GetChunk(pGMM, idPage >> GMM_CHUNKID_SHIFT);
+    if (pChunk && pChunk->pbMapping)
+        return &pChunk->pbMapping[(idPage & GMM_PAGEID_IDX_MASK) << GUEST_PAGE_SHIFT];
+# else
+    RT_NOREF(pGMM, idPage);
+# endif
+    return NULL;
+}
+
+
+/**
+ * Checks a page on behalf of the background duplicate page scanner.
+ *
+ * The scanner uses two global hash trees keyed by page content:
+ *  - Shared pages that can be used as merge targets.  When a private page has
+ *    the same content as one of these, the private page is freed and replaced
+ *    by the shared one.
+ *  - Private pages seen earlier.  When a private page has the same content as
+ *    a candidate seen before, the page is converted into a shared page and
+ *    becomes the merge target for the candidate and any later twins.  Pages
+ *    that keep changing rarely produce a match, so they are left alone.
+ *
+ * Zero pages don't wait for a twin, they are converted right away.
+ *
+ * Only the calling VM's page is ever converted, since its PGM has to make the
+ * page read-only.  Other VMs pick up the shared page when their scanner gets
+ * to their copy.
+ *
+ * @remarks ASSUMES the caller has acquired the GMM semaphore!!
+ *
+ * @returns VBox status code.
+ * @param   pGVM        Pointer to the GVM instance data.
+ * @param   pPageDesc   Page descriptor.  On successful return idPage is set
+ *                      to NIL_GMM_PAGEID if nothing changed.  Otherwise the
+ *                      page is now shared and idPage and HCPhys give the new
+ *                      backing page.
+ * @param   pfZero      Where to return whether the page is all zeros.
+ */
+VMMR0_INT_DECL(int) GMMR0ScanCheckPage(PGVM pGVM, PGMMSHAREDPAGEDESC pPageDesc, bool *pfZero)
+{
+    PGMM pGMM;
+    GMM_GET_VALID_INSTANCE(pGMM, VERR_GMM_INSTANCE);
+    pPageDesc->u32StrictChecksum = 0;
+    *pfZero = false;
+
+    uint32_t const idPage = pPageDesc->idPage;
+    PGMMPAGE       pPage  = gmmR0GetPage(pGMM, idPage);
+    AssertMsgReturn(pPage, ("idPage=%#x (GCPhys=%RGp HCPhys=%RHp)\n", idPage, pPageDesc->GCPhys, pPageDesc->HCPhys),
+                    VERR_PGM_PHYS_INVALID_PAGE_ID);
+    AssertMsgReturn(GMM_PAGE_IS_PRIVATE(pPage) && pPage->Private.hGVM == pGVM->hSelf,
+                    ("idPage=%#x u2State=%d\n", idPage, pPage->Common.u2State), VERR_GMM_NOT_PAGE_OWNER);
+
+    uint8_t const *pbPage = gmmR0ScanGetPageR0Ptr(pGMM, idPage);
+    if (!pbPage)
+    {
+        pPageDesc->idPage = NIL_GMM_PAGEID;
+        return VINF_SUCCESS;
+    }
+
+    bool const     fZero = ASMMemIsZero(pbPage, GUEST_PAGE_SIZE);
+    uint32_t const uHash = fZero ? 0 : RTCrc32(pbPage, GUEST_PAGE_SIZE);
+    *pfZero = fZero;
+
+    /*
+     * Is there a shared page with this content already?
+     */
+    PGMMSCANPAGENODE pNode = (PGMMSCANPAGENODE)RTAvlU32Get(&pGMM->pScanSharedTree, uHash);
+    if (pNode)
+    {
+        PGMMPAGE pSharedPage = gmmR0GetPage(pGMM, pNode->idPage);
+        if (pSharedPage && GMM_PAGE_IS_SHARED(pSharedPage))
+        {
+            uint8_t const *pbSharedPage = gmmR0ScanGetPageR0Ptr(pGMM, pNode->idPage);
+            if (   !pbSharedPage
+                || memcmp(pbSharedPage, pbPage, GUEST_PAGE_SIZE))
+            {
+                /* Hash collision, leave it. */
+                pPageDesc->idPage = NIL_GMM_PAGEID;
+                return VINF_SUCCESS;
+            }
+
+            if (pSharedPage->Shared.cRefs < GMM_SCAN_MAX_SHARED_REFS)
+            {
+# ifdef VBOX_STRICT
+                pPageDesc->u32StrictChecksum = RTCrc32(pbSharedPage, GUEST_PAGE_SIZE);
+# endif
+                /* Free the private page and use the shared one instead. */
+                GMMFREEPAGEDESC PageDesc;
+                PageDesc.idPage = idPage;
+                int rc = gmmR0FreePages(pGMM, pGVM, 1, &PageDesc, GMMACCOUNT_BASE);
+                AssertRCReturn(rc, rc);
+
+                gmmR0UseSharedPage(pGMM, pGVM, pSharedPage);
+
+                pPageDesc->HCPhys = (RTHCPHYS)pSharedPage->Shared.pfn << GUEST_PAGE_SHIFT;
+                pPageDesc->idPage = pNode->idPage;
+                return VINF_SUCCESS;
+            }
+            /* else: Out of references, let this page take over below. */
+        }
+
+        /* The shared page is gone or full, forget about it. */
+        RTAvlU32Remove(&pGMM->pScanSharedTree, uHash);
+        pGMM->cScanSharedNodes--;
+        RTMemFree(pNode);
+        pNode = NULL;
+        if (!fZero)
+        {
+            pPageDesc->idPage = NIL_GMM_PAGEID;
+            return VINF_SUCCESS;
+        }
+    }
+
+    /*
+     * Did we see a twin earlier?  Remember this page as a candidate if not.
+     */
+    bool             fConvert = fZero;
+    PGMMSCANPAGENODE pCand    = (PGMMSCANPAGENODE)RTAvlU32Get(&pGMM->pScanCandidateTree, uHash);
+    if (pCand)
+    {
+        if (!fConvert && pCand->idPage != idPage)
+        {
+            PGMMPAGE pCandPage = gmmR0GetPage(pGMM, pCand->idPage);
+            if (pCandPage && GMM_PAGE_IS_PRIVATE(pCandPage))
+            {
+                uint8_t const *pbCandPage = gmmR0ScanGetPageR0Ptr(pGMM, pCand->idPage);
+                fConvert = pbCandPage && !memcmp(pbCandPage, pbPage, GUEST_PAGE_SIZE);
+            }
+        }
+        if (fConvert)
+        {
+            RTAvlU32Remove(&pGMM->pScanCandidateTree, uHash);
+            pGMM->cScanCandidateNodes--;
+            RTMemFree(pCand);
+        }
+        else
+            pCand->idPage = idPage;
+    }
+    else if (!fConvert)
+    {
+        if (pGMM->cScanCandidateNodes >= GMM_SCAN_MAX_TREE_NODES)
+            gmmR0ScanDestroyTree(&pGMM->pScanCandidateTree, &pGMM->cScanCandidateNodes);
+        pCand = (PGMMSCANPAGENODE)RTMemAlloc(sizeof(*pCand));
+        if (pCand)
+        {
+            pCand->Core.Key = uHash;
+            pCand->idPage   = idPage;
+            if (RTAvlU32Insert(&pGMM->pScanCandidateTree, &pCand->Core))
+                pGMM->cScanCandidateNodes++;
+            else
+                RTMemFree(pCand);
+        }
+    }
+    if (!fConvert)
+    {
+        pPageDesc->idPage = NIL_GMM_PAGEID;
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Convert the page to a shared one and make it the merge target.
+     */
+    if (pGMM->cScanSharedNodes >= GMM_SCAN_MAX_TREE_NODES)
+        gmmR0ScanDestroyTree(&pGMM->pScanSharedTree, &pGMM->cScanSharedNodes);
+    pNode = (PGMMSCANPAGENODE)RTMemAlloc(sizeof(*pNode));
+    if (!pNode)
+    {
+        pPageDesc->idPage = NIL_GMM_PAGEID;
+        return VINF_SUCCESS;
+    }
+    pNode->Core.Key = uHash;
+    pNode->idPage   = idPage;
+    bool fRc = RTAvlU32Insert(&pGMM->pScanSharedTree, &pNode->Core);
+    Assert(fRc); RT_NOREF(fRc);
+    pGMM->cScanSharedNodes++;
+
+    gmmR0ConvertToSharedPage(pGMM, pGVM, pPageDesc->HCPhys, idPage, pPage, pPageDesc);
+    return VINF_SUCCESS;
+}
+
+#endif /* VBOX_WITH_PAGE_SHARING */
+
+/**
+ * Scans a slice of the VM's RAM for pages that can be merged with identical
+ * pages in this or other VMs, see GMMR0ScanCheckPage.
+ *
+ * @returns VBox status code.
+ * @param   pGVM        The global (ring-0) VM structure.
+ * @param   idCpu       The calling EMT number.
+ * @param   pReq        Pointer to the request packet.
+ * @thread  EMT(idCpu)
+ */
+VMMR0_INT_DECL(int) GMMR0ScanDuplicatePagesReq(PGVM pGVM, VMCPUID idCpu, PGMMSCANDUPLICATEPAGESREQ pReq)
+{
+#if defined(VBOX_WITH_PAGE_SHARING) && !defined(VBOX_WITH_LINEAR_HOST_PHYS_MEM)
+    /*
+     * Validate input and get the basics.
+     */
+    AssertPtrReturn(pReq, VERR_INVALID_POINTER);
+    AssertMsgReturn(pReq->Hdr.cbReq == sizeof(*pReq), ("%#x != %#x\n", pReq->Hdr.cbReq, sizeof(*pReq)), VERR_INVALID_PARAMETER);
+
+    PGMM pGMM;
+    GMM_GET_VALID_INSTANCE(pGMM, VERR_GMM_INSTANCE);
+    int rc = GVMMR0ValidateGVMandEMT(pGVM, idCpu);
+    if (RT_FAILURE(rc))
+        return rc;
+    if (pGMM->fBoundMemoryMode)
+        return VERR_NOT_SUPPORTED;
+
+    pReq->cMaxPages = RT_MIN(pReq->cMaxPages, GMM_SCAN_MAX_PAGES_PER_CALL);
+    pReq->cScanned  = 0;
+    pReq->cMerged   = 0;
+    pReq->cShared   = 0;
+    pReq->cZero     = 0;
+    pReq->fWrapped  = false;
+
+    /*
+     * Take the semaphore and let PGM walk the RAM ranges.
+     */
+    gmmR0MutexAcquire(pGMM);
+    if (GMM_CHECK_SANITY_UPON_ENTERING(pGMM))
+    {
+        rc = PGMR0SharedPageScan(pGVM, idCpu, pReq);
+        GMM_CHECK_SANITY_UPON_LEAVING(pGMM);
+    }
+    else
+        rc = VERR_GMM_IS_NOT_SANE;
+    gmmR0MutexRelease(pGMM);
+    return rc;
+#else
+    RT_NOREF(pGVM, idCpu, pReq);
+    return VERR_NOT_SUPPORTED;
+#endif
+}
+
 #ifdef VBOX_STRICT
 
 /**
@@ -5680,7 +6169,7 @@ VMMR0_INT_DECL(int) GMMR0QueryStatistics(PGMMSTATS pStats, PSUPDRVSESSION pSessi
     pStats->cFreedChunks                = pGMM->cFreedChunks;
     pStats->cShareableModules           = pGMM->cShareableModules;
     pStats->idFreeGeneration            = pGMM->idFreeGeneration;
-    RT_ZERO(pStats->au64Reserved);
+    pStats->cPreZeroedPages             = pGMM->cPreZeroedPages;
 
     /*
      * Copy out the VM statistics.
@@ -120,6 +120,12 @@
 #define GVMM_RTNATIVETHREAD_DESTROYED       (~(RTNATIVETHREAD)1)
 AssertCompile(GVMM_RTNATIVETHREAD_DESTROYED != NIL_RTNATIVETHREAD);
 
+/** The hard upper limit for the adaptive halt poll window (ns). */
+#define GVMM_HALT_POLL_MAX_NS               RT_NS_1MS
+/** The adaptive halt poll window to start out with when growing it from
+ * zero (ns).  Shrinking it below this value disables polling. */
+#define GVMM_HALT_POLL_GROW_START_NS        10000
+
 
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
@@ -1254,9 +1260,12 @@ static void gvmmR0InitPerVMData(PGVM pGVM, int16_t hSelf, VMTARGET enmTarget, VM
  * Does the VM initialization.
  *
  * @returns VBox status code.
- * @param   pGVM        The global (ring-0) VM structure.
+ * @param   pGVM            The global (ring-0) VM structure.
+ * @param   cNsHaltPollMax  The max adaptive halt poll window in nanoseconds
+ *                          (VMM::cNsHaltPollMax), zero to disable.  This
+ *                          comes from ring-3 and will be clamped.
  */
-VMMR0_INT_DECL(int) GVMMR0InitVM(PGVM pGVM)
+VMMR0_INT_DECL(int) GVMMR0InitVM(PGVM pGVM, uint32_t cNsHaltPollMax)
 {
     LogFlow(("GVMMR0InitVM: pGVM=%p\n", pGVM));
 
@@ -1272,7 +1281,9 @@ VMMR0_INT_DECL(int) GVMMR0InitVM(PGVM pGVM)
                 pGVM->aCpus[i].gvmm.s.HaltEventMulti = NIL_RTSEMEVENTMULTI;
                 break;
             }
+            pGVM->aCpus[i].gvmm.s.cNsHaltPoll = 0;
         }
+        pGVM->gvmm.s.cNsHaltPollMax = RT_MIN(cNsHaltPollMax, GVMM_HALT_POLL_MAX_NS);
     }
     else
         rc = VERR_WRONG_ORDER;
@@ -2546,6 +2557,75 @@ static DECLCALLBACK(void) gvmmR0EmtWakeUpTimerCallback(PRTTIMER pTimer, void *pv
 #endif /* GVMM_SCHED_WITH_HR_WAKE_UP_TIMER */
 
 
+/**
+ * Spins for a while waiting for a halted EMT to be woken up, before it commits
+ * to blocking on its semaphore.
+ *
+ * The caller must have published GVMMPERVCPU::u64HaltExpire, as that is what
+ * the wake-up code clears (before signalling the semaphore).
+ *
+ * @returns true if woken up or the halt expired while polling, false if the
+ *          EMT should block.
+ * @param   pGVCpu              The global (ring-0) CPU structure of the calling
+ *                              EMT.
+ * @param   u64NowGip           The GIP time the halt started.
+ * @param   u64ExpireGipTime    The time the halt expires expressed as GIP time.
+ * @param   cNsPoll             The poll window.
+ */
+static bool gvmmR0SchedHaltPoll(PGVMCPU pGVCpu, uint64_t u64NowGip, uint64_t u64ExpireGipTime, uint32_t cNsPoll)
+{
+    uint64_t const u64EndGip = RT_MIN(u64NowGip + cNsPoll, u64ExpireGipTime);
+    for (;;)
+    {
+        for (unsigned cSpins = 0; cSpins < 16; cSpins++)
+        {
+            if (!ASMAtomicUoReadU64(&pGVCpu->gvmm.s.u64HaltExpire))
+                return true;
+            ASMNopPause();
+        }
+
+        uint64_t const u64Now = RTTimeNanoTS();
+        if (u64Now >= u64EndGip)
+            return u64Now >= u64ExpireGipTime;
+
+        /* Don't hog the CPU if the host wants it for something else. */
+        if (RTThreadPreemptIsPending(NIL_RTTHREAD))
+            return false;
+    }
+}
+
+
+/**
+ * Adjusts the adaptive halt poll window after a halt that did block.
+ *
+ * This works along the lines of KVM's halt_poll_ns: If the EMT was woken up
+ * within the max poll window, a larger window would have avoided the blocking,
+ * so it is grown.  If the halt lasted longer than that, polling is a waste of
+ * CPU time and the window is shrunk.
+ *
+ * @param   pGVM        The global (ring-0) VM structure.
+ * @param   pGVCpu      The global (ring-0) CPU structure of the calling EMT.
+ * @param   cNsBlocked  How long the halt lasted (including any polling).
+ */
+DECLINLINE(void) gvmmR0SchedHaltPollAdjust(PGVM pGVM, PGVMCPU pGVCpu, uint64_t cNsBlocked)
+{
+    uint32_t const cNsPollMax = pGVM->gvmm.s.cNsHaltPollMax;
+    uint32_t       cNsPoll    = pGVCpu->gvmm.s.cNsHaltPoll;
+    if (cNsBlocked <= cNsPollMax)
+    {
+        if (cNsBlocked > cNsPoll)
+            cNsPoll = RT_MIN(cNsPoll ? cNsPoll * 2 : GVMM_HALT_POLL_GROW_START_NS, cNsPollMax);
+    }
+    else
+    {
+        cNsPoll /= 2;
+        if (cNsPoll < GVMM_HALT_POLL_GROW_START_NS)
+            cNsPoll = 0;
+    }
+    pGVCpu->gvmm.s.cNsHaltPoll = cNsPoll;
+}
+
+
 /**
  * Halt the EMT thread.
  *
@@ -2616,21 +2696,43 @@ VMMR0_INT_DECL(int) GVMMR0SchedHalt(PGVM pGVM, PGVMCPU pGVCpu, uint64_t u64Expir
             GVMMR0_USED_SHARED_UNLOCK(pGVMM);
         }
 
-#ifdef GVMM_SCHED_WITH_HR_WAKE_UP_TIMER
-        if (   pGVCpu->gvmm.s.hHrWakeUpTimer != NULL
-            && cNsInterval >= RT_MIN(RT_NS_1US, pGVMM->nsMinSleepWithHrTimer))
+        /*
+         * Adaptive halt polling: Spin a little first if recent halts have
+         * been short, since that avoids the host sleep/wake-up round trip.
+         */
+        uint32_t const cNsHaltPoll = pGVCpu->gvmm.s.cNsHaltPoll;
+        if (   cNsHaltPoll
+            && gvmmR0SchedHaltPoll(pGVCpu, u64NowGip, u64ExpireGipTime, cNsHaltPoll))
         {
-            STAM_REL_PROFILE_START(&pGVCpu->gvmm.s.Stats.Start, a);
-            RTTimerStart(pGVCpu->gvmm.s.hHrWakeUpTimer, cNsInterval);
-            pGVCpu->gvmm.s.fHrWakeUptimerArmed = true;
-            pGVCpu->gvmm.s.idHaltedOnCpu       = RTMpCpuId();
-            STAM_REL_PROFILE_STOP(&pGVCpu->gvmm.s.Stats.Start, a);
+            pGVCpu->gvmm.s.Stats.cHaltPollHits += 1;
+            rc = ASMAtomicUoReadU64(&pGVCpu->gvmm.s.u64HaltExpire) ? VERR_TIMEOUT : VINF_SUCCESS;
         }
+        else
+        {
+            if (cNsHaltPoll)
+                pGVCpu->gvmm.s.Stats.cHaltPollMisses += 1;
+
+#ifdef GVMM_SCHED_WITH_HR_WAKE_UP_TIMER
+            uint64_t const cNsElapsed = cNsHaltPoll ? RTTimeNanoTS() - u64NowGip : 0;
+            if (   pGVCpu->gvmm.s.hHrWakeUpTimer != NULL
+                && cNsInterval > cNsElapsed
+                && cNsInterval - cNsElapsed >= RT_MIN(RT_NS_1US, pGVMM->nsMinSleepWithHrTimer))
+            {
+                STAM_REL_PROFILE_START(&pGVCpu->gvmm.s.Stats.Start, a);
+                RTTimerStart(pGVCpu->gvmm.s.hHrWakeUpTimer, cNsInterval - cNsElapsed);
+                pGVCpu->gvmm.s.fHrWakeUptimerArmed = true;
+                pGVCpu->gvmm.s.idHaltedOnCpu       = RTMpCpuId();
+                STAM_REL_PROFILE_STOP(&pGVCpu->gvmm.s.Stats.Start, a);
+            }
 #endif
 
-        rc = RTSemEventMultiWaitEx(pGVCpu->gvmm.s.HaltEventMulti,
-                                   RTSEMWAIT_FLAGS_ABSOLUTE | RTSEMWAIT_FLAGS_NANOSECS | RTSEMWAIT_FLAGS_INTERRUPTIBLE,
-                                   u64NowGip > u64NowSys ? u64ExpireGipTime : u64NowSys + cNsInterval);
+            rc = RTSemEventMultiWaitEx(pGVCpu->gvmm.s.HaltEventMulti,
+                                       RTSEMWAIT_FLAGS_ABSOLUTE | RTSEMWAIT_FLAGS_NANOSECS | RTSEMWAIT_FLAGS_INTERRUPTIBLE,
+                                       u64NowGip > u64NowSys ? u64ExpireGipTime : u64NowSys + cNsInterval);
+
+            if (pGVM->gvmm.s.cNsHaltPollMax && rc != VERR_INTERRUPTED)
+                gvmmR0SchedHaltPollAdjust(pGVM, pGVCpu, RTTimeNanoTS() - u64NowGip);
+        }
 
         ASMAtomicWriteU64(&pGVCpu->gvmm.s.u64HaltExpire, 0);
         ASMAtomicDecU32(&pGVMM->cHaltedEMTs);
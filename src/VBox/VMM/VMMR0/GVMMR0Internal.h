@@ -56,6 +56,10 @@ typedef struct GVMMPERVCPU
     uint16_t            idxEmtHash;
     /** The ring-3 mapping of the VMCPU structure. */
     RTR0MEMOBJ          VMCpuMapObj;
+    /** The current adaptive halt poll window in nanoseconds, zero if not
+     * polling.  See gvmmR0SchedHaltPoll. */
+    uint32_t            cNsHaltPoll;
+    uint32_t            u32Padding;
     /** Statistics. */
     GVMMSTATSVMCPU      Stats;
 } GVMMPERVCPU;
@@ -118,7 +122,10 @@ typedef struct GVMMPERVM
     bool                fDoneVMMR0Init;
     /** Whether the per-VM ring-0 termination is being or has been performed. */
     bool                fDoneVMMR0Term;
-    bool                afPadding[6];
+    bool                afPadding[2];
+    /** The max halt poll window in nanoseconds, zero if halt polling is
+     * disabled.  Set by GVMMR0InitVM. */
+    uint32_t            cNsHaltPollMax;
 
     /** Worker thread registrations. */
     struct
@@ -271,6 +271,83 @@ static DECLCALLBACK(void) pdmR0DevHlp_PCISetIrq(PPDMDEVINS pDevIns, PPDMPCIDEV p
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR0,pfnPCISetIrqMulti} */
+static DECLCALLBACK(void) pdmR0DevHlp_PCISetIrqMulti(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs,
+                                                     uint32_t cIrqs, int iLevel)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    if (!pPciDev) /* NULL is an alias for the default PCI device. */
+        pPciDev = pDevIns->apPciDevs[0];
+    AssertReturnVoid(pPciDev);
+    LogFlow(("pdmR0DevHlp_PCISetIrqMulti: caller=%p/%d: pPciDev=%p:{%#x} cIrqs=%u iLevel=%d\n",
+             pDevIns, pDevIns->iInstance, pPciDev, pPciDev->uDevFn, cIrqs, iLevel));
+    PDMPCIDEV_ASSERT_VALID_AND_REGISTERED(pDevIns, pPciDev);
+    AssertPtrReturnVoid(pbmIrqs);
+    AssertReturnVoid(!(cIrqs & 31));
+
+    int32_t iIrq = ASMBitFirstSet(pbmIrqs, cIrqs);
+    if (iIrq < 0)
+        return;
+
+    PGVM         pGVM      = pDevIns->Internal.s.pGVM;
+    size_t const idxBus    = pPciDev->Int.s.idxPdmBus;
+    AssertReturnVoid(idxBus < RT_ELEMENTS(pGVM->pdmr0.s.aPciBuses));
+    PPDMPCIBUSR0 pPciBusR0 = &pGVM->pdmr0.s.aPciBuses[idxBus];
+
+    /* Take the PDM lock and calculate the tag once for all the IRQs. */
+    pdmLock(pGVM);
+
+    uint32_t uTagSrc;
+    if (iLevel & PDM_IRQ_LEVEL_HIGH)
+    {
+        pDevIns->Internal.s.pIntR3R0->uLastIrqTag = uTagSrc = pdmCalcIrqTag(pGVM, pDevIns->Internal.s.pInsR3R0->idTracing);
+        if (iLevel == PDM_IRQ_LEVEL_HIGH)
+            VBOXVMM_PDM_IRQ_HIGH(VMMGetCpu(pGVM), RT_LOWORD(uTagSrc), RT_HIWORD(uTagSrc));
+        else
+            VBOXVMM_PDM_IRQ_HILO(VMMGetCpu(pGVM), RT_LOWORD(uTagSrc), RT_HIWORD(uTagSrc));
+    }
+    else
+        uTagSrc = pDevIns->Internal.s.pIntR3R0->uLastIrqTag;
+
+    if (pPciBusR0->pDevInsR0)
+    {
+        do
+        {
+            pPciBusR0->pfnSetIrqR0(pPciBusR0->pDevInsR0, pPciDev, iIrq, iLevel, uTagSrc);
+            iIrq = ASMBitNextSet(pbmIrqs, cIrqs, (uint32_t)iIrq);
+        } while (iIrq >= 0);
+
+        pdmUnlock(pGVM);
+
+        if (iLevel == PDM_IRQ_LEVEL_LOW)
+            VBOXVMM_PDM_IRQ_LOW(VMMGetCpu(pGVM), RT_LOWORD(uTagSrc), RT_HIWORD(uTagSrc));
+    }
+    else
+    {
+        pdmUnlock(pGVM);
+
+        /* queue for ring-3 execution, one task per IRQ. */
+        do
+        {
+            PPDMDEVHLPTASK pTask = (PPDMDEVHLPTASK)PDMQueueAlloc(pGVM, pGVM->pdm.s.hDevHlpQueue, pGVM);
+            AssertReturnVoid(pTask);
+
+            pTask->enmOp = PDMDEVHLPTASKOP_PCI_SET_IRQ;
+            pTask->pDevInsR3 = PDMDEVINS_2_R3PTR(pDevIns);
+            pTask->u.PciSetIrq.iIrq = iIrq;
+            pTask->u.PciSetIrq.iLevel = iLevel;
+            pTask->u.PciSetIrq.uTagSrc = uTagSrc;
+            pTask->u.PciSetIrq.idxPciDev = pPciDev->Int.s.idxSubDev;
+
+            PDMQueueInsert(pGVM, pGVM->pdm.s.hDevHlpQueue, pGVM, &pTask->Core);
+            iIrq = ASMBitNextSet(pbmIrqs, cIrqs, (uint32_t)iIrq);
+        } while (iIrq >= 0);
+    }
+
+    LogFlow(("pdmR0DevHlp_PCISetIrqMulti: caller=%p/%d: returns void; uTagSrc=%#x\n", pDevIns, pDevIns->iInstance, uTagSrc));
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR0,pfnISASetIrq} */
 static DECLCALLBACK(void) pdmR0DevHlp_ISASetIrq(PPDMDEVINS pDevIns, int iIrq, int iLevel)
 {
@@ -606,6 +683,14 @@ static DECLCALLBACK(int) pdmR0DevHlp_QueueInsert(PPDMDEVINS pDevIns, PDMQUEUEHAN
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR0,pfnQueueFree} */
+static DECLCALLBACK(int) pdmR0DevHlp_QueueFree(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    return PDMQueueFree(pDevIns->Internal.s.pGVM, hQueue, pDevIns, pItem);
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR0,pfnQueueFlushIfNecessary} */
 static DECLCALLBACK(bool) pdmR0DevHlp_QueueFlushIfNecessary(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue)
 {
@@ -1424,6 +1509,7 @@ extern DECLEXPORT(const PDMDEVHLPR0) g_pdmR0DevHlp =
     pdmR0DevHlp_PCIPhysRead,
     pdmR0DevHlp_PCIPhysWrite,
     pdmR0DevHlp_PCISetIrq,
+    pdmR0DevHlp_PCISetIrqMulti,
     pdmR0DevHlp_ISASetIrq,
     pdmR0DevHlp_PhysRead,
     pdmR0DevHlp_PhysWrite,
@@ -1457,6 +1543,7 @@ extern DECLEXPORT(const PDMDEVHLPR0) g_pdmR0DevHlp =
     pdmR0DevHlp_TMTimeVirtGetNano,
     pdmR0DevHlp_QueueAlloc,
     pdmR0DevHlp_QueueInsert,
+    pdmR0DevHlp_QueueFree,
     pdmR0DevHlp_QueueFlushIfNecessary,
     pdmR0DevHlp_TaskTrigger,
     pdmR0DevHlp_SUPSemEventSignal,
@@ -1537,6 +1624,7 @@ extern DECLEXPORT(const PDMDEVHLPR0) g_pdmR0DevHlpTracing =
     pdmR0DevHlpTracing_PCIPhysRead,
     pdmR0DevHlpTracing_PCIPhysWrite,
     pdmR0DevHlpTracing_PCISetIrq,
+    pdmR0DevHlpTracing_PCISetIrqMulti,
     pdmR0DevHlpTracing_ISASetIrq,
     pdmR0DevHlp_PhysRead,
     pdmR0DevHlp_PhysWrite,
@@ -1570,6 +1658,7 @@ extern DECLEXPORT(const PDMDEVHLPR0) g_pdmR0DevHlpTracing =
     pdmR0DevHlp_TMTimeVirtGetNano,
     pdmR0DevHlp_QueueAlloc,
     pdmR0DevHlp_QueueInsert,
+    pdmR0DevHlp_QueueFree,
     pdmR0DevHlp_QueueFlushIfNecessary,
     pdmR0DevHlp_TaskTrigger,
     pdmR0DevHlp_SUPSemEventSignal,
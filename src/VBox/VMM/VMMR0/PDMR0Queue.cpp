@@ -72,6 +72,8 @@ VMMR0_INT_DECL(int) PDMR0QueueCreateReqHandler(PGVM pGVM, PPDMQUEUECREATEREQ pRe
     AssertReturn(pReq->cbItem >= sizeof(PDMQUEUEITEMCORE), VERR_INVALID_PARAMETER);
     pReq->cbItem = RT_ALIGN_32(pReq->cbItem, sizeof(uint64_t));
     AssertReturn((uint64_t)pReq->cbItem * pReq->cItems <= PDMQUEUE_MAX_TOTAL_SIZE_R0, VERR_OUT_OF_RANGE);
+    AssertReturn(!(pReq->fFlags & ~PDMQUEUE_F_VALID_MASK), VERR_INVALID_FLAGS);
+    uint32_t const fFlags = pReq->fFlags;
 
     void *pvOwnerR0;
     switch ((PDMQUEUETYPE)pReq->enmType)
@@ -111,7 +113,7 @@ VMMR0_INT_DECL(int) PDMR0QueueCreateReqHandler(PGVM pGVM, PPDMQUEUECREATEREQ pRe
     /*
      * Calculate the memory needed and allocate it.
      */
-    uint32_t const cbBitmap = RT_ALIGN_32(RT_ALIGN_32(pReq->cItems, 64 /*uint64_t*/) / 8, 64 /*cache line */);
+    uint32_t const cbBitmap = PDMQUEUE_CALC_BITMAP_SIZE(pReq->cItems, fFlags);
     uint32_t const cbQueue  = RT_UOFFSETOF(PDMQUEUE, bmAlloc)
                             + cbBitmap
                             + pReq->cbItem * pReq->cItems;
@@ -125,7 +127,7 @@ VMMR0_INT_DECL(int) PDMR0QueueCreateReqHandler(PGVM pGVM, PPDMQUEUECREATEREQ pRe
         /*
          * Initialize the queue.
          */
-        pdmQueueInit(pQueue, cbBitmap, pReq->cbItem, pReq->cItems, pReq->szName,
+        pdmQueueInit(pQueue, cbBitmap, pReq->cbItem, pReq->cItems, fFlags, pReq->szName,
                      (PDMQUEUETYPE)pReq->enmType, pReq->pfnCallback, pReq->pvOwner);
 
         /*
@@ -148,7 +150,8 @@ VMMR0_INT_DECL(int) PDMR0QueueCreateReqHandler(PGVM pGVM, PPDMQUEUECREATEREQ pRe
                 pGVM->pdmr0.s.aQueues[iQueue].pvOwner     = pvOwnerR0;
                 pGVM->pdmr0.s.aQueues[iQueue].cbItem      = pReq->cbItem;
                 pGVM->pdmr0.s.aQueues[iQueue].cItems      = pReq->cItems;
-                pGVM->pdmr0.s.aQueues[iQueue].u32Reserved = UINT32_C(0xf00dface);
+                pGVM->pdmr0.s.aQueues[iQueue].offItems    = RT_UOFFSETOF(PDMQUEUE, bmAlloc) + cbBitmap;
+                pGVM->pdmr0.s.aQueues[iQueue].fFlags      = fFlags;
 
                 pGVM->pdm.s.apRing0Queues[iQueue] = RTR0MemObjAddressR3(hMapObj);
 
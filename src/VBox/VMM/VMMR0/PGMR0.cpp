@@ -647,8 +647,8 @@ int pgmR0PhysAllocateLargePage(PGVM pGVM, VMCPUID idCpu, RTGCPHYS GCPhys)
             }
             else
             {
-                Log(("PGMR0PhysAllocateLargePage: Suspending large page allocations for %u sec after %'RU64 ns allocation time.\n",
-                     30 * pGVM->pgm.s.cLargePageLongAllocRepeats, cNsElapsed));
+                LogRelMax(32, ("PGMR0PhysAllocateLargePage: Suspending large page allocations for %u sec after %'RU64 ns allocation time.\n",
+                               30 * pGVM->pgm.s.cLargePageLongAllocRepeats, cNsElapsed));
                 pGVM->pgm.s.nsLargePageRetry = nsAllocEnd + RT_NS_30SEC * pGVM->pgm.s.cLargePageLongAllocRepeats;
             }
         }
@@ -46,6 +46,62 @@
 
 
 #ifdef VBOX_WITH_PAGE_SHARING
+/**
+ * Updates a PGM page after GMM made its backing a shared page.
+ *
+ * The page was either replaced by an existing shared version of it or
+ * converted into a read-only shared page, so all references to it must be
+ * cleared.
+ *
+ * The PGM lock shall be taken prior to calling this method.
+ *
+ * @param   pVM                 The cross context VM structure.
+ * @param   pVCpu               The cross context virtual CPU structure of the
+ *                              calling EMT.
+ * @param   pPage               The page.
+ * @param   pPageDesc           The page descriptor as returned by GMM.
+ * @param   pfFlushTLBs         Where to indicate that the TLBs needs flushing
+ *                              (not touched if not needed).
+ */
+static void pgmR0SharedPageUpdate(PVMCC pVM, PVMCPUCC pVCpu, PPGMPAGE pPage, GMMSHAREDPAGEDESC const *pPageDesc,
+                                  bool *pfFlushTLBs)
+{
+    Assert(PGM_PAGE_GET_STATE(pPage) == PGM_PAGE_STATE_ALLOCATED);
+    RT_NOREF(pVCpu);
+
+    bool fFlush = false;
+    int rc = pgmPoolTrackUpdateGCPhys(pVM, pPageDesc->GCPhys, pPage, true /* clear the entries */, &fFlush);
+    Assert(   rc == VINF_SUCCESS
+           || (   VMCPU_FF_IS_SET(pVCpu, VMCPU_FF_PGM_SYNC_CR3)
+               && (pVCpu->pgm.s.fSyncFlags & PGM_SYNC_CLEAR_PGM_POOL)));
+    if (rc == VINF_SUCCESS && fFlush)
+        *pfFlushTLBs = true;
+
+    if (pPageDesc->HCPhys != PGM_PAGE_GET_HCPHYS(pPage))
+    {
+        /* Update the physical address and page id now. */
+        PGM_PAGE_SET_HCPHYS(pVM, pPage, pPageDesc->HCPhys);
+        PGM_PAGE_SET_PAGEID(pVM, pPage, pPageDesc->idPage);
+
+        /* Invalidate page map TLB entry for this page too. */
+        pgmPhysInvalidatePageMapTLBEntry(pVM, pPageDesc->GCPhys);
+        IEMTlbInvalidateAllPhysicalAllCpus(pVM, NIL_VMCPUID, IEMTLBPHYSFLUSHREASON_SHARED);
+        pVM->pgm.s.cReusedSharedPages++;
+    }
+    /* else: nothing changed (== this page is now a shared
+       page), so no need to flush anything. */
+
+    pVM->pgm.s.cSharedPages++;
+    pVM->pgm.s.cPrivatePages--;
+    PGM_PAGE_SET_STATE(pVM, pPage, PGM_PAGE_STATE_SHARED);
+
+# ifdef VBOX_STRICT /* check sum hack */
+    pPage->s.u2Unused0 = pPageDesc->u32StrictChecksum        & 3;
+    //pPage->s.u2Unused1 = (pPageDesc->u32StrictChecksum >> 8) & 3;
+# endif
+}
+
+
 /**
  * Check a registered module for shared page changes.
  *
@@ -110,45 +166,10 @@ VMMR0DECL(int) PGMR0SharedModuleCheck(PVMCC pVM, PGVM pGVM, VMCPUID idCpu, PGMMS
                      */
                     if (PageDesc.idPage != NIL_GMM_PAGEID)
                     {
-                        Assert(PGM_PAGE_GET_STATE(pPage) == PGM_PAGE_STATE_ALLOCATED);
-
                         Log(("PGMR0SharedModuleCheck: shared page gst virt=%RGv phys=%RGp host %RHp->%RHp\n",
                              GCPtrPage, PageDesc.GCPhys, PGM_PAGE_GET_HCPHYS(pPage), PageDesc.HCPhys));
-
-                        /* Page was either replaced by an existing shared
-                           version of it or converted into a read-only shared
-                           page, so, clear all references. */
-                        bool fFlush = false;
-                        rc = pgmPoolTrackUpdateGCPhys(pVM, PageDesc.GCPhys, pPage, true /* clear the entries */, &fFlush);
-                        Assert(   rc == VINF_SUCCESS
-                               || (   VMCPU_FF_IS_SET(pVCpu, VMCPU_FF_PGM_SYNC_CR3)
-                                   && (pVCpu->pgm.s.fSyncFlags & PGM_SYNC_CLEAR_PGM_POOL)));
-                        if (rc == VINF_SUCCESS)
-                            fFlushTLBs |= fFlush;
+                        pgmR0SharedPageUpdate(pVM, pVCpu, pPage, &PageDesc, &fFlushTLBs);
                         fFlushRemTLBs = true;
-
-                        if (PageDesc.HCPhys != PGM_PAGE_GET_HCPHYS(pPage))
-                        {
-                            /* Update the physical address and page id now. */
-                            PGM_PAGE_SET_HCPHYS(pVM, pPage, PageDesc.HCPhys);
-                            PGM_PAGE_SET_PAGEID(pVM, pPage, PageDesc.idPage);
-
-                            /* Invalidate page map TLB entry for this page too. */
-                            pgmPhysInvalidatePageMapTLBEntry(pVM, PageDesc.GCPhys);
-                            IEMTlbInvalidateAllPhysicalAllCpus(pVM, NIL_VMCPUID, IEMTLBPHYSFLUSHREASON_SHARED);
-                            pVM->pgm.s.cReusedSharedPages++;
-                        }
-                        /* else: nothing changed (== this page is now a shared
-                           page), so no need to flush anything. */
-
-                        pVM->pgm.s.cSharedPages++;
-                        pVM->pgm.s.cPrivatePages--;
-                        PGM_PAGE_SET_STATE(pVM, pPage, PGM_PAGE_STATE_SHARED);
-
-# ifdef VBOX_STRICT /* check sum hack */
-                        pPage->s.u2Unused0 = PageDesc.u32StrictChecksum        & 3;
-                        //pPage->s.u2Unused1 = (PageDesc.u32StrictChecksum >> 8) & 3;
-# endif
                     }
                 }
             }
@@ -180,5 +201,122 @@ VMMR0DECL(int) PGMR0SharedModuleCheck(PVMCC pVM, PGVM pGVM, VMCPUID idCpu, PGMMS
 
     return rc;
 }
+
+/**
+ * Scans a slice of guest RAM for pages that can be merged with identical pages
+ * in this or other VMs (background duplicate page scanner).
+ *
+ * Called by GMMR0ScanDuplicatePagesReq with the GMM semaphore held.  The PGM
+ * lock shall be taken prior to calling this method and all the other EMTs
+ * must be stalled.
+ *
+ * @returns VBox status code.
+ * @param   pGVM                Pointer to the GVM instance data.
+ * @param   idCpu               The ID of the calling virtual CPU.
+ * @param   pReq                The request packet.  The cursor in idRamRange
+ *                              and iPage is updated and the statistics are
+ *                              filled in.
+ */
+VMMR0DECL(int) PGMR0SharedPageScan(PGVM pGVM, VMCPUID idCpu, PGMMSCANDUPLICATEPAGESREQ pReq)
+{
+    PVMCPUCC            pVCpu         = &pGVM->aCpus[idCpu];
+    int                 rc            = VINF_SUCCESS;
+    bool                fFlushTLBs    = false;
+    bool                fFlushRemTLBs = false;
+    GMMSHAREDPAGEDESC   PageDesc;
+
+    PGM_LOCK_ASSERT_OWNER(pGVM);     /* This cannot fail as we grab the lock in pgmR3PageScanRendezvous before calling into ring-0. */
+
+    uint32_t const idRamRangeMax = RT_MIN(pGVM->pgmr0.s.idRamRangeMax, RT_ELEMENTS(pGVM->pgmr0.s.apRamRanges) - 1U);
+    uint32_t       idRamRange    = pReq->idRamRange;
+    uint32_t       iPage         = pReq->iPage;
+    if (idRamRange > idRamRangeMax)
+    {
+        idRamRange = 0;
+        iPage      = 0;
+    }
+
+    uint32_t cLeft   = pReq->cMaxPages;
+    uint32_t cRanges = idRamRangeMax + 2; /* Guard against looping forever. */
+    while (cLeft > 0 && cRanges-- > 0)
+    {
+        PPGMRAMRANGE const pRam   = pGVM->pgmr0.s.apRamRanges[idRamRange];
+        uint32_t const     cPages = pRam ? RT_MIN(pRam->cb >> GUEST_PAGE_SHIFT, pGVM->pgmr0.s.acRamRangePages[idRamRange]) : 0;
+        while (iPage < cPages && cLeft > 0)
+        {
+            PPGMPAGE const pPage = &pRam->aPages[iPage];
+            cLeft--;
+            pReq->cScanned++;
+
+            if (    PGM_PAGE_GET_TYPE(pPage)        == PGMPAGETYPE_RAM
+                &&  PGM_PAGE_GET_STATE(pPage)       == PGM_PAGE_STATE_ALLOCATED
+                &&  PGM_PAGE_GET_READ_LOCKS(pPage)  == 0
+                &&  PGM_PAGE_GET_WRITE_LOCKS(pPage) == 0
+                &&  PGM_PAGE_GET_PDE_TYPE(pPage)    != PGM_PAGE_PDE_TYPE_PDE
+                &&  PGM_PAGE_GET_PDE_TYPE(pPage)    != PGM_PAGE_PDE_TYPE_PDE_DISABLED
+                && !PGM_PAGE_HAS_ANY_HANDLERS(pPage))
+            {
+                PageDesc.idPage = PGM_PAGE_GET_PAGEID(pPage);
+                PageDesc.HCPhys = PGM_PAGE_GET_HCPHYS(pPage);
+                PageDesc.GCPhys = pRam->GCPhys + ((RTGCPHYS)iPage << GUEST_PAGE_SHIFT);
+
+                bool fZero = false;
+                rc = GMMR0ScanCheckPage(pGVM, &PageDesc, &fZero);
+                if (RT_FAILURE(rc))
+                    break;
+
+                if (PageDesc.idPage != NIL_GMM_PAGEID)
+                {
+                    Log(("PGMR0SharedPageScan: shared page phys=%RGp host %RHp->%RHp%s\n", PageDesc.GCPhys,
+                         PGM_PAGE_GET_HCPHYS(pPage), PageDesc.HCPhys, fZero ? " (zero)" : ""));
+                    if (PageDesc.HCPhys != PGM_PAGE_GET_HCPHYS(pPage))
+                        pReq->cMerged++;
+                    else
+                    {
+                        /* Unlike the shared module code we don't know that the guest has the
+                           page mapped read-only, so drop any writable mappings of it. */
+                        pgmPhysInvalidatePageMapTLBEntry(pGVM, PageDesc.GCPhys);
+                        pReq->cShared++;
+                    }
+                    if (fZero)
+                        pReq->cZero++;
+                    pgmR0SharedPageUpdate(pGVM, pVCpu, pPage, &PageDesc, &fFlushTLBs);
+                    fFlushRemTLBs = true;
+                }
+            }
+            iPage++;
+        }
+        if (RT_FAILURE(rc))
+            break;
+
+        if (iPage >= cPages)
+        {
+            iPage = 0;
+            if (++idRamRange > idRamRangeMax)
+            {
+                idRamRange     = 0;
+                pReq->fWrapped = true;
+            }
+        }
+    }
+
+    pReq->idRamRange = idRamRange;
+    pReq->iPage      = iPage;
+
+    /*
+     * Do TLB flushing if necessary.
+     */
+    if (fFlushTLBs)
+        PGM_INVL_ALL_VCPU_TLBS(pGVM);
+
+    if (fFlushRemTLBs)
+    {
+        IEMTlbInvalidateAllPhysicalAllCpus(pGVM, NIL_VMCPUID, IEMTLBPHYSFLUSHREASON_SHARED);
+        for (VMCPUID idCurCpu = 0; idCurCpu < pGVM->cCpus; idCurCpu++)
+            CPUMSetChangedFlags(&pGVM->aCpus[idCurCpu], CPUM_CHANGED_GLOBAL_TLB_FLUSH);
+    }
+
+    return rc;
+}
 #endif /* VBOX_WITH_PAGE_SHARING */
 
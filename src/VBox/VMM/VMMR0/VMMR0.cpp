@@ -462,7 +462,7 @@ static int vmmR0InitVM(PGVM pGVM, uint32_t uSvnRev, uint32_t uBuildType)
     /*
      * Initialize the per VM data for GVMM and GMM.
      */
-    rc = GVMMR0InitVM(pGVM);
+    rc = GVMMR0InitVM(pGVM, pGVM->vmm.s.cNsHaltPollMax);
     if (RT_SUCCESS(rc))
     {
 #ifndef VBOX_WITH_MINIMAL_R0
@@ -923,6 +923,7 @@ static int vmmR0DoHalt(PGVM pGVM, PGVMCPU pGVCpu)
 
                             VMCPU_CMPXCHG_STATE(pGVCpu, VMCPUSTATE_STARTED, VMCPUSTATE_STARTED_HALTED);
                             STAM_REL_PROFILE_ADD_PERIOD(&pGVCpu->vmm.s.StatR0HaltBlock, cNsElapsedSchedHalt);
+                            TMNotifyRing0Halt(pGVCpu, cNsElapsedSchedHalt);
                             if (   rc == VINF_SUCCESS
                                 || rc == VERR_INTERRUPTED)
                             {
@@ -2146,6 +2147,15 @@ DECL_NO_INLINE(static, int) vmmR0EntryExWorker(PGVM pGVM, VMCPUID idCpu, VMMR0OP
             rc = GMMR0CheckSharedModules(pGVM, idCpu);
             break;
         }
+
+        case VMMR0_DO_GMM_SCAN_DUPLICATE_PAGES:
+            if (idCpu == NIL_VMCPUID)
+                return VERR_INVALID_CPU_ID;
+            if (u64Arg)
+                return VERR_INVALID_PARAMETER;
+            IF_NON_DEFAULT_VM_WITH_LIMITED_R0_RETURN_ERROR(g_GVM);
+            rc = GMMR0ScanDuplicatePagesReq(pGVM, idCpu, (PGMMSCANDUPLICATEPAGESREQ)pReqHdr);
+            break;
 # endif
 
 # if defined(VBOX_STRICT)
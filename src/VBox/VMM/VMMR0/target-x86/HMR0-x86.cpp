@@ -33,6 +33,7 @@
 #define VMCPU_INCL_CPUM_GST_CTX
 #include <VBox/vmm/hm.h>
 #include <VBox/vmm/pgm.h>
+#include <VBox/vmm/pdmapi.h>
 #include "HMInternal.h"
 #include <VBox/vmm/vmcc.h>
 #include <VBox/vmm/hm_svm.h>
@@ -45,6 +46,7 @@
 #include <iprt/cpuset.h>
 #include <iprt/mem.h>
 #include <iprt/memobj.h>
+#include <iprt/mp.h>
 #include <iprt/once.h>
 #include <iprt/param.h>
 #include <iprt/power.h>
@@ -1281,19 +1283,28 @@ VMMR0_INT_DECL(int) HMR0InitVM(PVMCC pVM)
         /* Use the VMCS controls for swapping the EFER MSR if supported. */
         pVM->hm.s.ForR3.vmx.fSupportsVmcsEfer = g_fHmVmxSupportsVmcsEfer;
 
-#if 0
-        /* Enable APIC register virtualization and virtual-interrupt delivery if supported. */
-        if (   (g_HmMsrs.u.vmx.ProcCtls2.n.allowed1 & VMX_PROC_CTLS2_APIC_REG_VIRT)
-            && (g_HmMsrs.u.vmx.ProcCtls2.n.allowed1 & VMX_PROC_CTLS2_VIRT_INTR_DELIVERY))
-            pVM->hm.s.fVirtApicRegs = true;
-
-        /* Enable posted-interrupt processing if supported. */
-        /** @todo Add and query IPRT API for host OS support for posted-interrupt IPI
-         *        here. */
-        if (   (g_HmMsrs.u.vmx.PinCtls.n.allowed1  & VMX_PIN_CTLS_POSTED_INT)
-            && (g_HmMsrs.u.vmx.ExitCtls.n.allowed1 & VMX_EXIT_CTLS_ACK_EXT_INT))
-            pVM->hm.s.fPostedIntrs = true;
-#endif
+        /* Use posted-interrupt processing with virtual-interrupt delivery if configured
+           and supported by both the CPU and the host OS.  The latter has to give us
+           a notification vector.  We dispatch the external interrupts acknowledged on
+           VM-exit using 'int N', which doesn't fly with FRED. */
+        /** @todo APIC-register virtualization (fVirtApicRegs). */
+        uint8_t const uPostedIntrNotifyVector = RTMpPostIpiGetVector();
+        if (   pVM->hm.s.vmx.fPostedIntrsCfg
+            && PDMHasApic(pVM)
+            && (g_HmMsrs.u.vmx.PinCtls.n.allowed1   & VMX_PIN_CTLS_POSTED_INT)
+            && (g_HmMsrs.u.vmx.ExitCtls.n.allowed1  & VMX_EXIT_CTLS_ACK_EXT_INT)
+            && (g_HmMsrs.u.vmx.ProcCtls.n.allowed1  & VMX_PROC_CTLS_USE_TPR_SHADOW)
+            && (g_HmMsrs.u.vmx.ProcCtls.n.allowed1  & VMX_PROC_CTLS_USE_SECONDARY_CTLS)
+            && (g_HmMsrs.u.vmx.ProcCtls2.n.allowed1 & VMX_PROC_CTLS2_VIRT_INT_DELIVERY)
+            && uPostedIntrNotifyVector != 0
+            && !(ASMGetCR4() & X86_CR4_FRED))
+        {
+            pVM->hmr0.s.vmx.fPostedIntrs            = true;
+            pVM->hmr0.s.vmx.uPostedIntrNotifyVector = uPostedIntrNotifyVector;
+        }
+        else
+            pVM->hmr0.s.vmx.fPostedIntrs = false;
+        pVM->hm.s.fPostedIntrs = pVM->hmr0.s.vmx.fPostedIntrs;
     }
     else if (pVM->hm.s.svm.fSupported)
     {
@@ -1635,6 +1646,9 @@ VMMR0_INT_DECL(int) HMR0RunGuestCode(PVMCC pVM, PVMCPUCC pVCpu)
         AssertReturn(!ASMAtomicReadBool(&g_fHmSuspended), VERR_HM_SUSPEND_PENDING);
     }
 #endif
+#ifdef VBOX_WITH_STATISTICS
+    pVCpu->hm.s.idxExitHistLast = UINT32_MAX;
+#endif
 
     VBOXSTRICTRC rcStrict = g_HmR0Ops.pfnRunGuestCode(pVCpu);
     return VBOXSTRICTRC_VAL(rcStrict);
@@ -509,6 +509,42 @@ BEGINPROC VMXDispatchHostNmi
 ENDPROC VMXDispatchHostNmi
 
 
+;;
+; Dispatches an external interrupt that was acknowledged on VM-exit to the host.
+;
+; With posted-interrupt processing the CPU acknowledges the interrupt
+; controller on VM-exit (VMX_EXIT_CTLS_ACK_EXT_INT), so we have to invoke the
+; host IDT handler ourselves.  There is no 'int reg', so this jumps into a
+; table of 8 byte 'int N; ret' stubs.
+;
+; @param    uVector     msc:cl, gcc:dil     The interrupt vector.
+;
+ALIGNCODE(16)
+BEGINPROC VMXDispatchHostIntr
+        SEH64_END_PROLOGUE
+ %ifdef ASM_CALL64_MSC
+        movzx   eax, cl
+ %else
+        movzx   eax, dil
+ %endif
+        lea     rdx, [.aStubs wrt rip]
+        lea     rax, [rdx + rax * 8]
+        IBT_NOTRACK
+        jmp     rax
+
+ALIGNCODE(8)
+.aStubs:
+ %assign uVector 0
+ %rep 256
+        db      0xf3, 0x0f, 0x1e, 0xfa  ; endbr64, always emitted to keep the stubs 8 bytes.
+        db      0xcd, uVector           ; int uVector
+        ret
+        int3
+  %assign uVector uVector + 1
+ %endrep
+ENDPROC VMXDispatchHostIntr
+
+
 ;;
 ; Common restore logic for success and error paths.  We duplicate this because we
 ; don't want to waste writing the VINF_SUCCESS return value to the stack in the
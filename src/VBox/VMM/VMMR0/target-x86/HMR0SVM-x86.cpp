@@ -84,6 +84,10 @@
         else \
             STAM_COUNTER_INC(&pVCpu->hm.s.aStatNestedExitReason[(u64ExitCode) & MASK_EXITREASON_STAT]); \
         } while (0)
+
+/** Maps an exit code to an HMCPU::aStatExitHistR0 index. */
+# define HMSVM_EXIT_HIST_IDX(u64ExitCode) \
+    ((u64ExitCode) == SVM_EXIT_NPF ? HM_EXIT_HIST_IDX_NPF : (uint32_t)(u64ExitCode) & MASK_EXITREASON_STAT)
 #else
 # define HMSVM_EXITCODE_STAM_COUNTER_INC(u64ExitCode)           do { } while (0)
 # define HMSVM_DEBUG_EXITCODE_STAM_COUNTER_INC(u64ExitCode)     do { } while (0)
@@ -4543,6 +4547,7 @@ static VBOXSTRICTRC hmR0SvmRunGuestCodeNormal(PVMCPUCC pVCpu, uint32_t *pcLoops)
         VBOXVMM_R0_HMSVM_VMEXIT(pVCpu, &pVCpu->cpum.GstCtx, SvmTransient.u64ExitCode, pVCpu->hmr0.s.svm.pVmcb);
         rc = hmR0SvmHandleExit(pVCpu, &SvmTransient);
         STAM_PROFILE_ADV_STOP(&pVCpu->hm.s.StatExitHandling, x);
+        HM_EXIT_HIST_R0_ADD(pVCpu, HMSVM_EXIT_HIST_IDX(SvmTransient.u64ExitCode));
         if (rc != VINF_SUCCESS)
             break;
         if (++(*pcLoops) >= cMaxResumeLoops)
@@ -6483,6 +6488,7 @@ static VBOXSTRICTRC hmR0SvmRunGuestCodeDebug(PVMCPUCC pVCpu, uint32_t *pcLoops)
         VBOXVMM_R0_HMSVM_VMEXIT(pVCpu, pCtx, SvmTransient.u64ExitCode, pVCpu->hmr0.s.svm.pVmcb);
         rc = hmR0SvmDebugHandleExit(pVCpu, &SvmTransient, &DbgState);
         STAM_PROFILE_ADV_STOP(&pVCpu->hm.s.StatExitHandling, x);
+        HM_EXIT_HIST_R0_ADD(pVCpu, HMSVM_EXIT_HIST_IDX(SvmTransient.u64ExitCode));
         if (rc != VINF_SUCCESS)
             break;
         if (++(*pcLoops) >= cMaxResumeLoops)
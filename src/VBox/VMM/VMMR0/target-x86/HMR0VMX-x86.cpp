@@ -2614,15 +2614,22 @@ static int hmR0VmxSetupVmcsPinCtls(PVMCPUCC pVCpu, PVMXVMCSINFO pVmcsInfo)
         fVal |= VMX_PIN_CTLS_PREEMPT_TIMER;
     }
 
-#if 0
-    /* Enable posted-interrupt processing. */
-    if (pVM->hm.s.fPostedIntrs)
+    /* Enable posted-interrupt processing. The posted-interrupt descriptor is the APIC's PIB. */
+    if (pVM->hmr0.s.vmx.fPostedIntrs)
     {
         Assert(g_HmMsrs.u.vmx.PinCtls.n.allowed1  & VMX_PIN_CTLS_POSTED_INT);
         Assert(g_HmMsrs.u.vmx.ExitCtls.n.allowed1 & VMX_EXIT_CTLS_ACK_EXT_INT);
+
+        RTHCPHYS HCPhysPib = NIL_RTHCPHYS;
+        int rc = PDMR0ApicGetPibForCpu(pVCpu, &HCPhysPib);
+        AssertRCReturn(rc, rc);
+        Assert(!(HCPhysPib & 0x3f));                         /* Must be 64-byte aligned. */
+
+        rc  = VMXWriteVmcs16(VMX_VMCS16_POSTED_INT_NOTIFY_VECTOR,   pVM->hmr0.s.vmx.uPostedIntrNotifyVector);
+        rc |= VMXWriteVmcs64(VMX_VMCS64_CTRL_POSTED_INTR_DESC_FULL, HCPhysPib);
+        AssertRC(rc);
         fVal |= VMX_PIN_CTLS_POSTED_INT;
     }
-#endif
 
     if ((fVal & fZap) != fVal)
     {
@@ -2689,6 +2696,25 @@ static int hmR0VmxSetupVmcsProcCtls2(PVMCPUCC pVCpu, PVMXVMCSINFO pVmcsInfo)
     }
 #endif
 
+    /* Enable virtual-interrupt delivery, required for posted-interrupt processing.
+       Without APIC-register virtualization, only ICR writes and EOIs of vectors in
+       the EOI-exit bitmap (i.e. level-triggered ones) cause VM-exits. */
+    if (pVM->hmr0.s.vmx.fPostedIntrs)
+    {
+        Assert(g_HmMsrs.u.vmx.ProcCtls2.n.allowed1 & VMX_PROC_CTLS2_VIRT_INT_DELIVERY);
+        Assert(pVmcsInfo->u32ProcCtls & VMX_PROC_CTLS_USE_TPR_SHADOW);
+        fVal |= VMX_PROC_CTLS2_VIRT_INT_DELIVERY;
+
+        int rc = VMXWriteVmcs16(VMX_VMCS16_GUEST_INTR_STATUS, 0);
+        for (unsigned i = 0; i < RT_ELEMENTS(pVCpu->hmr0.s.vmx.au64EoiExitBitmap); i++)
+        {
+            rc |= VMXWriteVmcs64(VMX_VMCS64_CTRL_EOI_BITMAP_0_FULL + i * 2, 0);
+            pVCpu->hmr0.s.vmx.au64EoiExitBitmap[i] = 0;
+        }
+        AssertRC(rc);
+        pVCpu->hmr0.s.vmx.u16GuestIntrStatus = 0;
+    }
+
     /* Virtualize-APIC accesses if supported by the CPU. The virtual-APIC page is
        where the TPR shadow resides. */
     /** @todo VIRT_X2APIC support, it's mutually exclusive with this. So must be
@@ -5579,7 +5605,7 @@ static int hmR0VmxMergeVmcsNested(PVMCPUCC pVCpu)
      */
 
     /* Pin-based VM-execution controls. */
-    uint32_t const u32PinCtls = pVmcsNstGst->u32PinCtls | pVmcsInfoGst->u32PinCtls;
+    uint32_t const u32PinCtls = pVmcsNstGst->u32PinCtls | (pVmcsInfoGst->u32PinCtls & ~VMX_PIN_CTLS_POSTED_INT);
 
     /* Processor-based VM-execution controls. */
     uint32_t       u32ProcCtls = (pVmcsNstGst->u32ProcCtls  & ~VMX_PROC_CTLS_USE_IO_BITMAPS)
@@ -6105,6 +6131,100 @@ static VBOXSTRICTRC hmR0VmxPreRunGuest(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTransie
 }
 
 
+/**
+ * Gets the highest vector set in a 256-bit APIC register.
+ *
+ * @returns The highest vector, 0 if none are set.
+ * @param   pReg    The 256-bit APIC register (IRR, ISR).
+ */
+DECLINLINE(uint8_t) hmR0VmxGetHighestApicVector(PCXAPIC256BITREG pReg)
+{
+    for (unsigned i = RT_ELEMENTS(pReg->u); i-- > 0; )
+    {
+        uint32_t const u32Reg = pReg->u[i].u32Reg;
+        if (u32Reg)
+            return (uint8_t)(i * 32 + ASMBitLastSetU32(u32Reg) - 1);
+    }
+    return 0;
+}
+
+
+/**
+ * Exports the virtual-interrupt delivery state (guest interrupt status and the
+ * EOI-exit bitmap) into the VMCS.
+ *
+ * Posted interrupts which arrived while we were not executing guest code are
+ * merged into the IRR here.  The virtual-APIC page is our APIC page, so the
+ * IRR, ISR and TMR are shared with the CPU; only RVI, SVI and the EOI-exit
+ * bitmap need to be derived from them.
+ *
+ * @param   pVCpu       The cross context virtual CPU structure.
+ * @param   pVmcsInfo   The VMCS info. object.
+ *
+ * @remarks Called with interrupts disabled, after VMCPUSTATE_STARTED_EXEC is set
+ *          so that interrupts posted from now on send the notification IPI.
+ */
+static void hmR0VmxExportVirtIntrState(PVMCPUCC pVCpu, PCVMXVMCSINFO pVmcsInfo)
+{
+    Assert(pVmcsInfo->u32ProcCtls2 & VMX_PROC_CTLS2_VIRT_INT_DELIVERY);
+    Assert(pVmcsInfo->pbVirtApic);
+
+    if (VMCPU_FF_TEST_AND_CLEAR(pVCpu, VMCPU_FF_UPDATE_APIC))
+        PDMApicUpdatePendingInterrupts(pVCpu);
+
+    PCXAPICPAGE const pXApicPage = (PCXAPICPAGE)pVmcsInfo->pbVirtApic;
+    uint8_t const  uRvi = hmR0VmxGetHighestApicVector(&pXApicPage->irr);
+    uint8_t const  uSvi = hmR0VmxGetHighestApicVector(&pXApicPage->isr);
+    uint16_t const u16GuestIntrStatus = RT_MAKE_U16(uRvi, uSvi);
+    if (u16GuestIntrStatus != pVCpu->hmr0.s.vmx.u16GuestIntrStatus)
+    {
+        int rc = VMXWriteVmcs16(VMX_VMCS16_GUEST_INTR_STATUS, u16GuestIntrStatus);
+        AssertRC(rc);
+        pVCpu->hmr0.s.vmx.u16GuestIntrStatus = u16GuestIntrStatus;
+    }
+
+    /* Level-triggered interrupts must cause EOI VM-exits so the APIC can broadcast the EOI. */
+    for (unsigned i = 0; i < RT_ELEMENTS(pVCpu->hmr0.s.vmx.au64EoiExitBitmap); i++)
+    {
+        uint64_t const u64Tmr = RT_MAKE_U64(pXApicPage->tmr.u[i * 2].u32Reg, pXApicPage->tmr.u[i * 2 + 1].u32Reg);
+        if (u64Tmr != pVCpu->hmr0.s.vmx.au64EoiExitBitmap[i])
+        {
+            int rc = VMXWriteVmcs64(VMX_VMCS64_CTRL_EOI_BITMAP_0_FULL + i * 2, u64Tmr);
+            AssertRC(rc);
+            pVCpu->hmr0.s.vmx.au64EoiExitBitmap[i] = u64Tmr;
+        }
+    }
+}
+
+
+/**
+ * Dispatches the host external interrupt which caused the VM-exit.
+ *
+ * With posted-interrupt processing the CPU acknowledges external interrupts on
+ * VM-exit (VMX_EXIT_CTLS_ACK_EXT_INT), so we must hand them to the host OS
+ * ourselves.  This has to be done on the CPU which took the interrupt, i.e.
+ * before re-enabling interrupts, as we may get rescheduled afterwards.
+ *
+ * @param   pVCpu       The cross context virtual CPU structure.
+ */
+static void hmR0VmxDispatchHostIntr(PVMCPUCC pVCpu)
+{
+    uint32_t uExitReason = 0;
+    int rc = VMXReadVmcs32(VMX_VMCS32_RO_EXIT_REASON, &uExitReason);
+    AssertRC(rc);
+    if (uExitReason == VMX_EXIT_EXT_INT)
+    {
+        uint32_t uExitIntInfo = 0;
+        rc = VMXReadVmcs32(VMX_VMCS32_RO_EXIT_INTERRUPTION_INFO, &uExitIntInfo);
+        AssertRC(rc);
+        AssertMsg(   VMX_EXIT_INT_INFO_IS_VALID(uExitIntInfo)
+                  && VMX_EXIT_INT_INFO_TYPE(uExitIntInfo) == VMX_EXIT_INT_INFO_TYPE_EXT_INT, ("%#RX32\n", uExitIntInfo));
+        VMXDispatchHostIntr(VMX_EXIT_INT_INFO_VECTOR(uExitIntInfo));
+    }
+    RT_NOREF(pVCpu);
+}
+
+
 /**
  * Final preparations before executing guest code using hardware-assisted VMX.
  *
@@ -6185,6 +6305,13 @@ static void hmR0VmxPreRunGuestCommitted(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTransi
     if (pVmcsInfo->pbVirtApic)
         pVmxTransient->u8GuestTpr = pVmcsInfo->pbVirtApic[XAPIC_OFF_TPR];
 
+    /*
+     * Merge interrupts posted while we weren't executing guest code and update
+     * the virtual-interrupt delivery state.
+     */
+    if (pVmcsInfo->u32ProcCtls2 & VMX_PROC_CTLS2_VIRT_INT_DELIVERY)
+        hmR0VmxExportVirtIntrState(pVCpu, pVmcsInfo);
+
     /*
      * Update the host MSRs values in the VM-exit MSR-load area.
      */
@@ -6310,6 +6437,9 @@ static void hmR0VmxPostRunGuest(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTransient, int
     hmR0VmxCheckHostEferMsr(pVmcsInfo);                                 /* Verify that the host EFER MSR wasn't modified. */
 #endif
     Assert(!ASMIntAreEnabled());
+    if (   (pVmcsInfo->u32ExitCtls & VMX_EXIT_CTLS_ACK_EXT_INT)
+        && rcVMRun == VINF_SUCCESS)
+        hmR0VmxDispatchHostIntr(pVCpu);                                 /* Must be done on this CPU, see function. */
     ASMSetFlags(pVmxTransient->fEFlags);                                /* Enable interrupts. */
     Assert(!VMMRZCallRing3IsEnabled(pVCpu));
 
@@ -6432,6 +6562,22 @@ static void hmR0VmxPostRunGuest(PVMCPUCC pVCpu, PVMXTRANSIENT pVmxTransient, int
                     AssertRC(rc);
                     ASMAtomicUoOrU64(&pVCpu->hm.s.fCtxChanged, HM_CHANGED_GUEST_APIC_TPR);
                 }
+
+                /*
+                 * Pick up the guest interrupt status, the CPU may have delivered interrupts
+                 * or virtualized EOIs.  A pending RVI is an interrupt the guest couldn't take
+                 * yet, make sure the APIC knows about it for halting and ring-3 trips.
+                 */
+                if (pVmcsInfo->u32ProcCtls2 & VMX_PROC_CTLS2_VIRT_INT_DELIVERY)
+                {
+                    uint16_t u16GuestIntrStatus = 0;
+                    rc = VMXReadVmcs16(VMX_VMCS16_GUEST_INTR_STATUS, &u16GuestIntrStatus);
+                    AssertRC(rc);
+                    pVCpu->hmr0.s.vmx.u16GuestIntrStatus = u16GuestIntrStatus;
+                    if (   RT_LO_U8(u16GuestIntrStatus)
+                        && !VMCPU_FF_IS_SET(pVCpu, VMCPU_FF_INTERRUPT_APIC))
+                        PDMApicUpdatePendingInterrupts(pVCpu);
+                }
             }
 
             Assert(VMMRZCallRing3IsEnabled(pVCpu));
@@ -6594,6 +6740,7 @@ static VBOXSTRICTRC hmR0VmxRunGuestCodeNormal(PVMCPUCC pVCpu, uint32_t *pcLoops)
         rcStrict = hmR0VmxHandleExit(pVCpu, &VmxTransient);
 #endif
         STAM_PROFILE_ADV_STOP(&pVCpu->hm.s.StatExitHandling, x);
+        HM_EXIT_HIST_R0_ADD(pVCpu, VmxTransient.uExitReason & MASK_EXITREASON_STAT);
         if (rcStrict == VINF_SUCCESS)
         {
             if (++(*pcLoops) <= cMaxResumeLoops)
@@ -6855,6 +7002,7 @@ static VBOXSTRICTRC hmR0VmxRunGuestCodeDebug(PVMCPUCC pVCpu, uint32_t *pcLoops)
          */
         rcStrict = vmxHCRunDebugHandleExit(pVCpu, &VmxTransient, &DbgState);
         STAM_PROFILE_ADV_STOP(&pVCpu->hm.s.StatExitHandling, x);
+        HM_EXIT_HIST_R0_ADD(pVCpu, VmxTransient.uExitReason & MASK_EXITREASON_STAT);
         if (rcStrict != VINF_SUCCESS)
             break;
         if (++(*pcLoops) > cMaxResumeLoops)
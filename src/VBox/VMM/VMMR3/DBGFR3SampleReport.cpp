@@ -28,7 +28,21 @@
 
 /** @page pg_dbgf_sample_report DBGFR3SampleReport - Sample Report Interface
  *
- * @todo
+ * The sample report collects guest call stacks on every VCPU at a fixed interval
+ * and aggregates them into one call tree per VCPU.  Sampling can be limited to
+ * a given amount of time or run until stopped, which allows a low rate continuous
+ * profiling mode.
+ *
+ * Besides the text report created when sampling stops, the call trees can be
+ * written in the folded stack format (one "frame;frame;...;frame count" line per
+ * unique stack) at any time, even while sampling is still in progress.  This is
+ * the input format of the flame graph tools.  Frames are symbolized using the
+ * global address space, which is populated by the guest OS digger detected when
+ * sampling starts.
+ *
+ * The call trees are protected by a critical section.  The EMTs only try to enter
+ * it and drop the sample if a dump is currently in progress, so writing a report
+ * never stalls the guest.
  */
 
 
@@ -45,6 +59,7 @@
 #include <VBox/log.h>
 
 #include <iprt/assert.h>
+#include <iprt/critsect.h>
 #include <iprt/semaphore.h>
 #include <iprt/list.h>
 #include <iprt/mem.h>
@@ -61,6 +76,8 @@
 
 /** Maximum stack frame depth. */
 #define DBGF_SAMPLE_REPORT_FRAME_DEPTH_MAX 64
+/** Maximum length of a single symbolized frame in the folded output. */
+#define DBGF_SAMPLE_REPORT_FOLDED_SYM_MAX  256
 
 
 /*********************************************************************************************************************************
@@ -147,6 +164,10 @@ typedef struct DBGFSAMPLEREPORTINT
     char                             *pszReport;
     /** Number of EMTs having a guest sample operation queued. */
     volatile uint32_t                cEmtsActive;
+    /** Number of samples dropped because the call trees were busy. */
+    volatile uint32_t                cSamplesDropped;
+    /** Critical section protecting the per VCPU call trees. */
+    RTCRITSECT                       CritSect;
     /** Array of per VCPU samples collected. */
     DBGFSAMPLEREPORTVCPU             aCpus[1];
 } DBGFSAMPLEREPORTINT;
@@ -283,6 +304,7 @@ static void dbgfR3SampleReportDestroy(PDBGFSAMPLEREPORTINT pThis)
 {
     for (uint32_t i = 0; i < pThis->pUVM->cCpus; i++)
         dbgfR3SampleReportFrameFree(&pThis->aCpus[i].FrameRoot);
+    RTCritSectDelete(&pThis->CritSect);
     MMR3HeapFree(pThis);
 }
 
@@ -403,6 +425,90 @@ static void dbgfR3SampleReportDumpFrame(PCDBGFINFOHLP pHlp, PUVM pUVM, PCDBGFSAM
 }
 
 
+/**
+ * Formats the symbol of the given frame for the folded stack output.
+ *
+ * @param   pUVM                    The usermode VM handle.
+ * @param   pFrame                  The frame to format.
+ * @param   pszBuf                  Where to store the formatted frame.
+ * @param   cbBuf                   Size of the buffer in bytes.
+ */
+static void dbgfR3SampleReportFoldedFormatFrame(PUVM pUVM, PCDBGFSAMPLEFRAME pFrame, char *pszBuf, size_t cbBuf)
+{
+    RTGCINTPTR offDisp;
+    RTDBGMOD hMod;
+    RTDBGSYMBOL SymPC;
+
+    int rc = VERR_NOT_FOUND;
+    if (DBGFR3AddrIsValid(pUVM, &pFrame->AddrFrame))
+        rc = DBGFR3AsSymbolByAddr(pUVM, DBGF_AS_GLOBAL, &pFrame->AddrFrame,
+                                  RTDBGSYMADDR_FLAGS_LESS_OR_EQUAL | RTDBGSYMADDR_FLAGS_SKIP_ABS_IN_DEFERRED,
+                                  &offDisp, &SymPC, &hMod);
+    if (RT_SUCCESS(rc))
+    {
+        /* No displacement, all samples inside a function should end up in the same flame graph box. */
+        if (hMod != NIL_RTDBGMOD)
+        {
+            RTStrPrintf(pszBuf, cbBuf, "%s!%s", RTDbgModName(hMod), SymPC.szName);
+            RTDbgModRelease(hMod);
+        }
+        else
+            RTStrCopy(pszBuf, cbBuf, SymPC.szName);
+    }
+    else
+        RTStrPrintf(pszBuf, cbBuf, "%RGv", pFrame->AddrFrame.FlatPtr);
+
+    /* The semicolon separates frames in the folded format and the last space the sample count. */
+    for (char *psz = pszBuf; *psz; psz++)
+        if (*psz == ';' || *psz == ' ')
+            *psz = '_';
+}
+
+
+/**
+ * Writes the folded stack lines for the given frame and all its descendants.
+ *
+ * @returns VBox status code.
+ * @param   pThis                   The sample report instance data.
+ * @param   pStrm                   The stream to write to.
+ * @param   idCpu                   The VCPU the call tree belongs to.
+ * @param   pFrame                  The frame to dump.
+ * @param   paszStack               The symbols of the frames leading to this one.
+ * @param   idxDepth                Depth of the frame in the call tree.
+ */
+static int dbgfR3SampleReportDumpFoldedFrame(PDBGFSAMPLEREPORTINT pThis, PRTSTREAM pStrm, VMCPUID idCpu,
+                                             PCDBGFSAMPLEFRAME pFrame,
+                                             char (*paszStack)[DBGF_SAMPLE_REPORT_FOLDED_SYM_MAX], uint32_t idxDepth)
+{
+    AssertReturn(idxDepth < DBGF_SAMPLE_REPORT_FRAME_DEPTH_MAX, VERR_INTERNAL_ERROR_3);
+    dbgfR3SampleReportFoldedFormatFrame(pThis->pUVM, pFrame, paszStack[idxDepth], sizeof(paszStack[idxDepth]));
+
+    /* The samples ending in this frame are the ones not accounted for by any descendant. */
+    uint64_t cSamplesSelf = pFrame->cSamples;
+    for (uint32_t i = 0; i < pFrame->cFramesValid; i++)
+        cSamplesSelf -= RT_MIN(pFrame->paFrames[i].cSamples, cSamplesSelf);
+
+    int rc = VINF_SUCCESS;
+    if (cSamplesSelf)
+    {
+        /* The folded format goes from the outermost caller to the innermost frame. */
+        RTStrmPrintf(pStrm, "vcpu%u", idCpu);
+        if (pThis->fFlags & DBGF_SAMPLE_REPORT_F_STACK_REVERSE)
+            for (uint32_t i = idxDepth + 1; i-- > 0;)
+                RTStrmPrintf(pStrm, ";%s", paszStack[i]);
+        else
+            for (uint32_t i = 0; i <= idxDepth; i++)
+                RTStrmPrintf(pStrm, ";%s", paszStack[i]);
+        rc = RTStrmPrintf(pStrm, " %RU64\n", cSamplesSelf) >= 0 ? VINF_SUCCESS : RTStrmError(pStrm);
+    }
+
+    for (uint32_t i = 0; i < pFrame->cFramesValid && RT_SUCCESS(rc); i++)
+        rc = dbgfR3SampleReportDumpFoldedFrame(pThis, pStrm, idCpu, &pFrame->paFrames[i], paszStack, idxDepth + 1);
+
+    return rc;
+}
+
+
 /**
  * Worker for dbgfR3SampleReportTakeSample(), doing the work in an EMT rendezvous point on
  * each VCPU.
@@ -414,8 +520,20 @@ static DECLCALLBACK(void) dbgfR3SampleReportSample(PDBGFSAMPLEREPORTINT pThis)
     PVM pVM = pThis->pUVM->pVM;
     PVMCPU pVCpu = VMMGetCpu(pVM);
 
+    /* Don't block the EMT if a report is being written, just drop the sample. */
     PCDBGFSTACKFRAME pFrameFirst;
-    int rc = DBGFR3StackWalkBegin(pThis->pUVM, pVCpu->idCpu, DBGFCODETYPE_GUEST, &pFrameFirst);
+    int rc = RTCritSectTryEnter(&pThis->CritSect);
+    if (RT_SUCCESS(rc))
+    {
+        rc = DBGFR3StackWalkBegin(pThis->pUVM, pVCpu->idCpu, DBGFCODETYPE_GUEST, &pFrameFirst);
+        if (RT_FAILURE(rc))
+        {
+            RTCritSectLeave(&pThis->CritSect);
+            LogRelMax(10, ("Sampling guest stack on VCPU %u failed with rc=%Rrc\n", pVCpu->idCpu, rc));
+        }
+    }
+    else
+        ASMAtomicIncU32(&pThis->cSamplesDropped);
     if (RT_SUCCESS(rc))
     {
         DBGFADDRESS aFrameAddresses[DBGF_SAMPLE_REPORT_FRAME_DEPTH_MAX];
@@ -460,9 +578,9 @@ static DECLCALLBACK(void) dbgfR3SampleReportSample(PDBGFSAMPLEREPORTINT pThis)
                 pFrame = pFrameNext;
             }
         }
+
+        RTCritSectLeave(&pThis->CritSect);
     }
-    else
-        LogRelMax(10, ("Sampling guest stack on VCPU %u failed with rc=%Rrc\n", pVCpu->idCpu, rc));
 
     /* Last EMT finishes the report when sampling was stopped. */
     uint32_t cEmtsActive = ASMAtomicDecU32(&pThis->cEmtsActive);
@@ -478,6 +596,7 @@ static DECLCALLBACK(void) dbgfR3SampleReportSample(PDBGFSAMPLEREPORTINT pThis)
         dbgfR3SampleReportInfoHlpInit(&Hlp);
 
         /* Some early dump code. */
+        RTCritSectEnter(&pThis->CritSect);
         for (uint32_t i = 0; i < pThis->pUVM->cCpus; i++)
         {
             PCDBGFSAMPLEREPORTVCPU pSampleVCpu = &pThis->aCpus[i];
@@ -485,6 +604,10 @@ static DECLCALLBACK(void) dbgfR3SampleReportSample(PDBGFSAMPLEREPORTINT pThis)
             pHlp->pfnPrintf(pHlp, "Sample report for vCPU %u:\n", i);
             dbgfR3SampleReportDumpFrame(pHlp, pThis->pUVM, &pSampleVCpu->FrameRoot, 0);
         }
+        RTCritSectLeave(&pThis->CritSect);
+
+        if (pThis->cSamplesDropped)
+            pHlp->pfnPrintf(pHlp, "%u sample(s) dropped while a report was being written\n", pThis->cSamplesDropped);
 
         /* Shameless copy from VMMGuruMeditation.cpp */
         static struct
@@ -552,28 +675,32 @@ static DECLCALLBACK(void) dbgfR3SampleReportTakeSample(PRTTIMER pTimer, void *pv
     PDBGFSAMPLEREPORTINT pThis = (PDBGFSAMPLEREPORTINT)pvUser;
 
     bool fLast = false;
+    bool fDone = false;
+    int rcProgress = VINF_SUCCESS;
     if (pThis->cSampleUsLeft != UINT32_MAX)
     {
-        int rc = VINF_SUCCESS;
         uint64_t const cUsSampled = iTick * pThis->cSampleIntervalUs; /** @todo Wrong if the timer resolution is different from what we've requested. */
 
         /* Update progress. */
         if (pThis->pfnProgress)
-            rc = pThis->pfnProgress(pThis->pvProgressUser, cUsSampled * 99 / pThis->cSampleUsLeft);
+            rcProgress = pThis->pfnProgress(pThis->pvProgressUser, cUsSampled * 99 / pThis->cSampleUsLeft);
+        fDone = cUsSampled >= pThis->cSampleUsLeft;
+    }
+    else if (pThis->pfnProgress) /* Sampling indefinitely, only poll for cancellation. */
+        rcProgress = pThis->pfnProgress(pThis->pvProgressUser, 0);
 
-        if (   cUsSampled >= pThis->cSampleUsLeft
-            || rc == VERR_DBGF_CANCELLED)
-        {
-            /*
-             * Let the EMTs do one last round in order to be able to destroy the timer (can't do this on the timer thread)
-             * and gather information from the devices.
-             */
-            ASMAtomicCmpXchgU32((volatile uint32_t *)&pThis->enmState, DBGFSAMPLEREPORTSTATE_STOPPING,
-                                DBGFSAMPLEREPORTSTATE_RUNNING);
-
-            rc = RTTimerStop(pTimer); AssertRC(rc); RT_NOREF(rc);
-            fLast = true;
-        }
+    if (   fDone
+        || rcProgress == VERR_DBGF_CANCELLED)
+    {
+        /*
+         * Let the EMTs do one last round in order to be able to destroy the timer (can't do this on the timer thread)
+         * and gather information from the devices.
+         */
+        ASMAtomicCmpXchgU32((volatile uint32_t *)&pThis->enmState, DBGFSAMPLEREPORTSTATE_STOPPING,
+                            DBGFSAMPLEREPORTSTATE_RUNNING);
+
+        int rc = RTTimerStop(pTimer); AssertRC(rc); RT_NOREF(rc);
+        fLast = true;
     }
 
     uint32_t const cEmtsOld = ASMAtomicAddU32(&pThis->cEmtsActive, pThis->pUVM->cCpus);
@@ -623,6 +750,7 @@ VMMR3DECL(int) DBGFR3SampleReportCreate(PUVM pUVM, uint32_t cSampleIntervalUs, u
         pThis->cSampleIntervalUs = cSampleIntervalUs;
         pThis->enmState          = DBGFSAMPLEREPORTSTATE_READY;
         pThis->cEmtsActive       = 0;
+        pThis->cSamplesDropped   = 0;
 
         for (uint32_t i = 0; i < pUVM->cCpus; i++)
         {
@@ -632,8 +760,14 @@ VMMR3DECL(int) DBGFR3SampleReportCreate(PUVM pUVM, uint32_t cSampleIntervalUs, u
             pThis->aCpus[i].FrameRoot.cFramesMax   = 0;
         }
 
-        *phSample = pThis;
-        return VINF_SUCCESS;
+        rc = RTCritSectInit(&pThis->CritSect);
+        if (RT_SUCCESS(rc))
+        {
+            *phSample = pThis;
+            return VINF_SUCCESS;
+        }
+
+        MMR3HeapFree(pThis);
     }
     else
         rc = VERR_NO_MEMORY;
@@ -791,3 +925,48 @@ VMMR3DECL(int) DBGFR3SampleReportDumpToFile(DBGFSAMPLEREPORT hSample, const char
     return rc;
 }
 
+
+/**
+ * Dumps the call stacks sampled so far to the given file in the folded stack format
+ * used by the flame graph tools.
+ *
+ * This can be called at any time, also while sampling is still in progress.
+ *
+ * @returns VBox status code.
+ * @param   hSample                 Sample report handle.
+ * @param   pszFilename             The filename to dump the stacks to.
+ */
+VMMR3DECL(int) DBGFR3SampleReportDumpFoldedToFile(DBGFSAMPLEREPORT hSample, const char *pszFilename)
+{
+    PDBGFSAMPLEREPORTINT pThis = hSample;
+
+    AssertPtrReturn(pThis, VERR_INVALID_HANDLE);
+    AssertPtrReturn(pszFilename, VERR_INVALID_POINTER);
+
+    char (*paszStack)[DBGF_SAMPLE_REPORT_FOLDED_SYM_MAX]
+        = (char (*)[DBGF_SAMPLE_REPORT_FOLDED_SYM_MAX])RTMemTmpAlloc(DBGF_SAMPLE_REPORT_FRAME_DEPTH_MAX
+                                                                     * DBGF_SAMPLE_REPORT_FOLDED_SYM_MAX);
+    if (!paszStack)
+        return VERR_NO_TMP_MEMORY;
+
+    PRTSTREAM pStrm;
+    int rc = RTStrmOpen(pszFilename, "w", &pStrm);
+    if (RT_SUCCESS(rc))
+    {
+        RTCritSectEnter(&pThis->CritSect);
+        for (VMCPUID idCpu = 0; idCpu < pThis->pUVM->cCpus && RT_SUCCESS(rc); idCpu++)
+        {
+            PCDBGFSAMPLEFRAME pFrameRoot = &pThis->aCpus[idCpu].FrameRoot;
+            for (uint32_t i = 0; i < pFrameRoot->cFramesValid && RT_SUCCESS(rc); i++)
+                rc = dbgfR3SampleReportDumpFoldedFrame(pThis, pStrm, idCpu, &pFrameRoot->paFrames[i], paszStack, 0 /*idxDepth*/);
+        }
+        RTCritSectLeave(&pThis->CritSect);
+
+        int rc2 = RTStrmClose(pStrm);
+        if (RT_SUCCESS(rc))
+            rc = rc2;
+    }
+
+    RTMemTmpFree(paszStack);
+    return rc;
+}
@@ -46,16 +46,60 @@
 #include <iprt/alloca.h>
 #include <iprt/asm.h>
 #include <iprt/assert.h>
+#include <iprt/dir.h>
+#include <iprt/file.h>
+#include <iprt/mem.h>
 #include <iprt/path.h>
 #include <iprt/semaphore.h>
+#include <iprt/stream.h>
 #include <iprt/string.h>
 #include <iprt/thread.h>
+#include <iprt/time.h>
 #include <iprt/tracelog.h>
 
 
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Size of the CTF stream write buffer. */
+#define DBGF_TRACER_CTF_BUF_SZ          _256K
+/** Write the CTF stream buffer out when the ring buffer is drained and it has
+ * at least this many bytes in it. */
+#define DBGF_TRACER_CTF_FLUSH_THRESHOLD _64K
+/** The CTF packet header magic. */
+#define DBGF_TRACER_CTF_MAGIC           UINT32_C(0xc1fc1fc1)
+/** The CTF event ID for the data continuation entries of string I/O port and
+ * guest memory accesses. */
+#define DBGF_TRACER_CTF_EVT_ID_DATA     UINT32_C(32)
+
+
 /*********************************************************************************************************************************
 *   Structures and Typedefs                                                                                                      *
 *********************************************************************************************************************************/
+/**
+ * The event header and context of a CTF stream event, followed by the raw
+ * DBGF_TRACER_EVT_PAYLOAD_SZ bytes of payload from the ring buffer.
+ */
+#pragma pack(1)
+typedef struct DBGFTRACERCTFEVTHDR
+{
+    /** The CTF event ID (DBGFTRACEREVT or DBGF_TRACER_CTF_EVT_ID_DATA). */
+    uint32_t                idEvtType;
+    /** RTTimeNanoTS() when the event was posted. */
+    uint64_t                u64TsNano;
+    /** The posting virtual CPU. */
+    uint32_t                idCpu;
+    /** The event source. */
+    uint64_t                hEvtSrc;
+    /** The event ID. */
+    uint64_t                idEvt;
+    /** The event ID this one links to. */
+    uint64_t                idEvtPrev;
+} DBGFTRACERCTFEVTHDR;
+#pragma pack()
+AssertCompileSize(DBGFTRACERCTFEVTHDR, 40);
+/** Pointer to a CTF stream event header. */
+typedef DBGFTRACERCTFEVTHDR *PDBGFTRACERCTFEVTHDR;
 
 
 
@@ -357,6 +401,90 @@ static const RTTRACELOGEVTDESC g_DevRwDataEvtDesc =
 };
 
 
+/** The CTF 1.8 metadata describing the stream written by
+ * dbgfR3TracerCtfEvtProcess.  The payloads mirror the DBGFTRACEREVTXXX
+ * ring buffer structures, padding included.
+ *
+ * Format arguments: byte order, VirtualBox version, clock offset seconds and
+ * nanoseconds. */
+static const char g_szDbgfTracerCtfMetadata[] =
+    "/* CTF 1.8 */\n"
+    "\n"
+    "typealias integer { size = 8;  align = 8; signed = false; } := uint8_t;\n"
+    "typealias integer { size = 16; align = 8; signed = false; } := uint16_t;\n"
+    "typealias integer { size = 32; align = 8; signed = false; } := uint32_t;\n"
+    "typealias integer { size = 64; align = 8; signed = false; } := uint64_t;\n"
+    "typealias integer { size = 32; align = 8; signed = true;  } := int32_t;\n"
+    "typealias integer { size = 16; align = 8; signed = false; base = 16; } := hex16_t;\n"
+    "typealias integer { size = 32; align = 8; signed = false; base = 16; } := hex32_t;\n"
+    "typealias integer { size = 64; align = 8; signed = false; base = 16; } := hex64_t;\n"
+    "\n"
+    "trace {\n"
+    "    major = 1;\n"
+    "    minor = 8;\n"
+    "    byte_order = %s;\n"
+    "    packet.header := struct { uint32_t magic; uint32_t stream_id; };\n"
+    "};\n"
+    "\n"
+    "env {\n"
+    "    domain = \"virtualbox-dbgf-tracer\";\n"
+    "    version = \"%s\";\n"
+    "};\n"
+    "\n"
+    "clock {\n"
+    "    name = monotonic;\n"
+    "    freq = 1000000000;\n"
+    "    offset_s = %RU64;\n"
+    "    offset = %RU64;\n"
+    "};\n"
+    "\n"
+    "typealias integer { size = 64; align = 8; signed = false; map = clock.monotonic.value; } := tsnano_t;\n"
+    "\n"
+    "stream {\n"
+    "    id = 0;\n"
+    "    event.header := struct { uint32_t id; tsnano_t timestamp; };\n"
+    "    event.context := struct { uint32_t cpu_id; uint64_t src; uint64_t evt_id; uint64_t evt_prev; };\n"
+    "};\n"
+    "\n"
+    "event { name = src_register;   id = 1;  stream_id = 0; fields := struct { uint8_t pad[32]; }; };\n"
+    "event { name = src_deregister; id = 2;  stream_id = 0; fields := struct { uint8_t pad[32]; }; };\n"
+    "event { name = mmio_create;    id = 3;  stream_id = 0;\n"
+    "        fields := struct { hex64_t region; uint64_t size; hex32_t iom_flags; uint32_t pci_region; uint64_t pad; }; };\n"
+    "event { name = mmio_map;       id = 4;  stream_id = 0;\n"
+    "        fields := struct { hex64_t region; hex64_t gcphys; uint64_t pad[2]; }; };\n"
+    "event { name = mmio_unmap;     id = 5;  stream_id = 0; fields := struct { hex64_t region; uint64_t pad[3]; }; };\n"
+    "event { name = mmio_read;      id = 6;  stream_id = 0;\n"
+    "        fields := struct { hex64_t region; hex64_t offset; uint64_t cb; hex64_t value; }; };\n"
+    "event { name = mmio_write;     id = 7;  stream_id = 0;\n"
+    "        fields := struct { hex64_t region; hex64_t offset; uint64_t cb; hex64_t value; }; };\n"
+    "event { name = mmio_fill;      id = 8;  stream_id = 0;\n"
+    "        fields := struct { hex64_t region; hex64_t offset; uint32_t cb_item; uint32_t items; hex32_t item; uint32_t pad; }; };\n"
+    "event { name = ioport_create;  id = 9;  stream_id = 0;\n"
+    "        fields := struct { hex64_t region; uint16_t ports; uint16_t pad0; hex32_t iom_flags; uint32_t pci_region;\n"
+    "                           uint32_t pad1[3]; }; };\n"
+    "event { name = ioport_map;     id = 10; stream_id = 0;\n"
+    "        fields := struct { hex64_t region; hex16_t base; uint16_t pad[11]; }; };\n"
+    "event { name = ioport_unmap;   id = 11; stream_id = 0; fields := struct { hex64_t region; uint64_t pad[3]; }; };\n"
+    "event { name = ioport_read;    id = 12; stream_id = 0;\n"
+    "        fields := struct { hex64_t region; hex16_t offset; uint8_t pad0[6]; uint64_t cb; hex32_t value; uint8_t pad1[4]; }; };\n"
+    "event { name = ioport_read_str; id = 13; stream_id = 0;\n"
+    "        fields := struct { hex64_t region; uint32_t cb_item; uint32_t transfers_req; uint32_t transfers_ret;\n"
+    "                           hex16_t offset; uint8_t data[10]; }; };\n"
+    "event { name = ioport_write;   id = 14; stream_id = 0;\n"
+    "        fields := struct { hex64_t region; hex16_t offset; uint8_t pad0[6]; uint64_t cb; hex32_t value; uint8_t pad1[4]; }; };\n"
+    "event { name = ioport_write_str; id = 15; stream_id = 0;\n"
+    "        fields := struct { hex64_t region; uint32_t cb_item; uint32_t transfers_req; uint32_t transfers_ret;\n"
+    "                           hex16_t offset; uint8_t data[10]; }; };\n"
+    "event { name = irq;            id = 16; stream_id = 0; fields := struct { int32_t irq; int32_t level; uint32_t pad[6]; }; };\n"
+    "event { name = ioapic_msi;     id = 17; stream_id = 0;\n"
+    "        fields := struct { hex64_t gcphys; hex32_t value; uint32_t pad[5]; }; };\n"
+    "event { name = gcphys_read;    id = 18; stream_id = 0;\n"
+    "        fields := struct { hex64_t gcphys; uint64_t cb; uint8_t data[16]; }; };\n"
+    "event { name = gcphys_write;   id = 19; stream_id = 0;\n"
+    "        fields := struct { hex64_t gcphys; uint64_t cb; uint8_t data[16]; }; };\n"
+    "event { name = data;           id = 32; stream_id = 0; fields := struct { uint8_t data[32]; }; };\n";
+
+
 /*********************************************************************************************************************************
 *   Internal Functions                                                                                                           *
 *********************************************************************************************************************************/
@@ -763,6 +891,139 @@ static int dbgfR3TracerEvtProcess(PDBGFTRACERINSR3 pThis, PDBGFTRACEREVTHDR pEvt
 }
 
 
+/**
+ * Flushes the CTF stream write buffer to the file.
+ *
+ * @returns VBox status code.
+ * @param   pThis                   The DBGF tracer instance.
+ */
+static int dbgfR3TracerCtfFlush(PDBGFTRACERINSR3 pThis)
+{
+    int rc = VINF_SUCCESS;
+    if (pThis->offCtfBuf)
+    {
+        rc = RTFileWrite(pThis->hFileCtf, pThis->pbCtfBuf, pThis->offCtfBuf, NULL /*pcbWritten*/);
+        pThis->offCtfBuf = 0;
+    }
+    return rc;
+}
+
+
+/**
+ * Appends the given event to the CTF stream.
+ *
+ * This is just a couple of copies, the payload is written as is and the
+ * metadata (see g_szDbgfTracerCtfMetadata) describes the ring buffer
+ * structures.
+ *
+ * @returns VBox status code.
+ * @param   pThis                   The DBGF tracer instance.
+ * @param   pEvtHdr                 The event to write.
+ */
+static int dbgfR3TracerCtfEvtProcess(PDBGFTRACERINSR3 pThis, PCDBGFTRACEREVTHDR pEvtHdr)
+{
+    if (pThis->offCtfBuf + sizeof(DBGFTRACERCTFEVTHDR) + DBGF_TRACER_EVT_PAYLOAD_SZ > DBGF_TRACER_CTF_BUF_SZ)
+    {
+        int rc = dbgfR3TracerCtfFlush(pThis);
+        if (RT_FAILURE(rc))
+            return rc;
+    }
+
+    /* The event IDs in the metadata are the DBGFTRACEREVT values. */
+    AssertCompile(DBGFTRACEREVT_MMIO_READ == 6 && DBGFTRACEREVT_IOPORT_READ == 12 && DBGFTRACEREVT_GCPHYS_WRITE == 19);
+    PDBGFTRACERCTFEVTHDR pCtfHdr = (PDBGFTRACERCTFEVTHDR)&pThis->pbCtfBuf[pThis->offCtfBuf];
+    pCtfHdr->idEvtType = (uint32_t)pEvtHdr->enmEvt;
+    pCtfHdr->u64TsNano = pEvtHdr->u64TsNano;
+    pCtfHdr->idCpu     = pEvtHdr->idCpu;
+    pCtfHdr->hEvtSrc   = pEvtHdr->hEvtSrc;
+    pCtfHdr->idEvt     = pEvtHdr->idEvt;
+    pCtfHdr->idEvtPrev = pEvtHdr->idEvtPrev;
+
+    uint8_t *pbPayload = (uint8_t *)(pCtfHdr + 1);
+    switch (pEvtHdr->enmEvt)
+    {
+        case DBGFTRACEREVT_SRC_REGISTER:
+        case DBGFTRACEREVT_SRC_DEREGISTER:
+            /* No payload. */
+            RT_BZERO(pbPayload, DBGF_TRACER_EVT_PAYLOAD_SZ);
+            break;
+
+        case DBGFTRACEREVT_IOPORT_READ_STR:
+        case DBGFTRACEREVT_IOPORT_WRITE_STR:
+        case DBGFTRACEREVT_GCPHYS_READ:
+        case DBGFTRACEREVT_GCPHYS_WRITE:
+            /* The continuation entries only carry data. */
+            if (pEvtHdr->idEvtPrev != DBGF_TRACER_EVT_HDR_ID_INVALID)
+                pCtfHdr->idEvtType = DBGF_TRACER_CTF_EVT_ID_DATA;
+            RT_FALL_THRU();
+        default:
+            memcpy(pbPayload, pEvtHdr + 1, DBGF_TRACER_EVT_PAYLOAD_SZ);
+            break;
+    }
+
+    pThis->offCtfBuf += sizeof(DBGFTRACERCTFEVTHDR) + DBGF_TRACER_EVT_PAYLOAD_SZ;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Creates the CTF trace directory with the metadata and stream files.
+ *
+ * @returns VBox status code.
+ * @param   pThis                   The DBGF tracer instance.
+ * @param   pszTraceDir             The trace directory to create.
+ */
+static int dbgfR3TracerCtfCreate(PDBGFTRACERINSR3 pThis, const char *pszTraceDir)
+{
+    int rc = RTDirCreateFullPath(pszTraceDir, 0755);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    char szPath[RTPATH_MAX];
+    rc = RTPathJoin(szPath, sizeof(szPath), pszTraceDir, "metadata");
+    AssertRCReturn(rc, rc);
+
+    /* The clock offset relates RTTimeNanoTS() to the unix epoch. */
+    RTTIMESPEC Now;
+    uint64_t const offClock = (uint64_t)RTTimeSpecGetNano(RTTimeNow(&Now)) - RTTimeNanoTS();
+
+    PRTSTREAM pStrm;
+    rc = RTStrmOpen(szPath, "w", &pStrm);
+    if (RT_FAILURE(rc))
+        return rc;
+    RTStrmPrintf(pStrm, g_szDbgfTracerCtfMetadata,
+#ifdef RT_BIG_ENDIAN
+                 "be",
+#else
+                 "le",
+#endif
+                 RTBldCfgVersion(), offClock / RT_NS_1SEC_64, offClock % RT_NS_1SEC_64);
+    rc = RTStrmClose(pStrm);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    rc = RTPathJoin(szPath, sizeof(szPath), pszTraceDir, "stream0");
+    AssertRCReturn(rc, rc);
+    rc = RTFileOpen(&pThis->hFileCtf, szPath, RTFILE_O_WRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_WRITE);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    pThis->pbCtfBuf = (uint8_t *)RTMemAlloc(DBGF_TRACER_CTF_BUF_SZ);
+    if (pThis->pbCtfBuf)
+    {
+        /* The packet header, the whole stream is one packet. */
+        uint32_t const au32PktHdr[2] = { DBGF_TRACER_CTF_MAGIC, 0 /*stream_id*/ };
+        memcpy(pThis->pbCtfBuf, &au32PktHdr[0], sizeof(au32PktHdr));
+        pThis->offCtfBuf = sizeof(au32PktHdr);
+        return VINF_SUCCESS;
+    }
+
+    RTFileClose(pThis->hFileCtf);
+    pThis->hFileCtf = NIL_RTFILE;
+    return VERR_NO_MEMORY;
+}
+
+
 /**
  * @callback_method_impl{FNRTTHREAD,
  *      DBGF Tracer flush thread}
@@ -808,7 +1069,9 @@ static DECLCALLBACK(int) dbgfR3TracerThreadFlush(RTTHREAD ThreadSelf, void *pvUs
             while (ASMAtomicReadU64(&pEvtHdr->idEvt) == DBGF_TRACER_EVT_HDR_ID_INVALID)
                 RTThreadYield();
 
-            int rc = dbgfR3TracerEvtProcess(pThis, pEvtHdr);
+            int rc = pThis->hFileCtf == NIL_RTFILE
+                   ? dbgfR3TracerEvtProcess(pThis, pEvtHdr)
+                   : dbgfR3TracerCtfEvtProcess(pThis, pEvtHdr);
             if (RT_FAILURE(rc))
                 LogRelMax(10, ("DBGF: Writing event failed with %Rrc, tracing log will be incomplete!\n", rc));
 
@@ -817,6 +1080,13 @@ static DECLCALLBACK(int) dbgfR3TracerThreadFlush(RTTHREAD ThreadSelf, void *pvUs
         }
 
         pThis->idEvtLast = idEvt;
+        if (   pThis->hFileCtf != NIL_RTFILE
+            && pThis->offCtfBuf >= DBGF_TRACER_CTF_FLUSH_THRESHOLD)
+        {
+            int rc = dbgfR3TracerCtfFlush(pThis);
+            if (RT_FAILURE(rc))
+                LogRelMax(10, ("DBGF: Writing the CTF stream failed with %Rrc, trace will be incomplete!\n", rc));
+        }
         ASMAtomicXchgBool(&pShared->fEvtsWaiting, false);
     }
 
@@ -861,24 +1131,40 @@ static int dbgfR3TracerTraceLogEvtDescRegister(PDBGFTRACERINSR3 pThis)
  *
  * @returns VBox status code.
  * @param   pThis                   The DBGF tracer instance.
- * @param   pszTraceFilePath        The path of the trace file to create.
+ * @param   pszTraceFilePath        The path of the trace file to create, the
+ *                                  directory for CTF traces.
+ * @param   fCtf                    Whether to write a CTF trace instead of a
+ *                                  trace log.
  */
-static int dbgfR3TracerInitR3(PDBGFTRACERINSR3 pThis, const char *pszTraceFilePath)
+static int dbgfR3TracerInitR3(PDBGFTRACERINSR3 pThis, const char *pszTraceFilePath, bool fCtf)
 {
     PVM pVM = pThis->pVMR3;
     PDBGFTRACERSHARED pShared = pThis->pSharedR3;
 
     pThis->fShutdown = false;
+    pThis->hTraceLog = NIL_RTTRACELOGWR;
+    pThis->hFileCtf  = NIL_RTFILE;
+    pThis->pbCtfBuf  = NULL;
+    pThis->offCtfBuf = 0;
 
     for (uint32_t i = 0; i < RT_ELEMENTS(pThis->aGstMemRwData); i++)
         pThis->aGstMemRwData[i].idEvtStart = DBGF_TRACER_EVT_HDR_ID_INVALID;
 
-    /* Try to create a file based trace log. */
-    int rc = RTTraceLogWrCreateFile(&pThis->hTraceLog, RTBldCfgVersion(), pszTraceFilePath);
-    AssertLogRelRCReturn(rc, rc);
+    int rc;
+    if (fCtf)
+    {
+        rc = dbgfR3TracerCtfCreate(pThis, pszTraceFilePath);
+        AssertLogRelMsgRCReturn(rc, ("DBGF: Creating the CTF trace '%s' failed: %Rrc\n", pszTraceFilePath, rc), rc);
+    }
+    else
+    {
+        /* Try to create a file based trace log. */
+        rc = RTTraceLogWrCreateFile(&pThis->hTraceLog, RTBldCfgVersion(), pszTraceFilePath);
+        AssertLogRelRCReturn(rc, rc);
 
-    rc = dbgfR3TracerTraceLogEvtDescRegister(pThis);
-    AssertLogRelRCReturn(rc, rc);
+        rc = dbgfR3TracerTraceLogEvtDescRegister(pThis);
+        AssertLogRelRCReturn(rc, rc);
+    }
 
     /*
      * Go through the whole ring buffer and initialize the event IDs of all entries
@@ -920,10 +1206,11 @@ static int dbgfR3TracerInitR3(PDBGFTRACERINSR3 pThis, const char *pszTraceFilePa
  * @param   pVM                     The cross context VM structure.
  * @param   fR0Enabled              Flag whether the tracer should have R0 support enabled.
  * @param   pszTraceFilePath        The path of the trace file to create.
+ * @param   fCtf                    Whether to write a CTF trace.
  * @param   cbRingBuf               Size of the ring buffer in bytes.
  * @param   ppDbgfTracerR3          Where to store the pointer to the tracer on success.
  */
-static int dbgfR3TracerCreate(PVM pVM, bool fR0Enabled, const char *pszTraceFilePath,
+static int dbgfR3TracerCreate(PVM pVM, bool fR0Enabled, const char *pszTraceFilePath, bool fCtf,
                               uint32_t cbRingBuf, PDBGFTRACERINSR3 *ppDbgfTracerR3)
 {
     PDBGFTRACERINSR3 pThis = NULL;
@@ -983,7 +1270,7 @@ static int dbgfR3TracerCreate(PVM pVM, bool fR0Enabled, const char *pszTraceFile
     }
 
     /* Initialize the rest of the R3 tracer instance and spin up the flush thread. */
-    int rc = dbgfR3TracerInitR3(pThis, pszTraceFilePath);
+    int rc = dbgfR3TracerInitR3(pThis, pszTraceFilePath, fCtf);
     if (RT_SUCCESS(rc))
     {
         *ppDbgfTracerR3 = pThis;
@@ -1025,13 +1312,35 @@ DECLHIDDEN(int) dbgfR3TracerInit(PVM pVM)
             rc = CFGMR3QueryU32Def(pDbgfNode, "TracerRingBufSz", &cbRingBuf, _4M);
         if (RT_SUCCESS(rc))
             rc = CFGMR3QueryStringAlloc(pDbgfNode, "TracerFilePath", &pszTraceFilePath);
+
+        /** @cfgm{/DBGF/TracerFormat, string, "TraceLog"}
+         * The format of the trace: "TraceLog" for an IPRT trace log file, or
+         * "CTF" for a Common Trace Format (1.8) trace.  For CTF, TracerFilePath
+         * is a directory which receives the metadata and stream files; the
+         * trace can be read with babeltrace2 or Trace Compass.  Writing a CTF
+         * trace costs next to nothing compared to the trace log, so it can be
+         * left enabled for much longer. */
+        bool fCtf = false;
+        if (RT_SUCCESS(rc))
+        {
+            char szFormat[32];
+            rc = CFGMR3QueryStringDef(pDbgfNode, "TracerFormat", szFormat, sizeof(szFormat), "TraceLog");
+            if (RT_SUCCESS(rc))
+            {
+                if (!RTStrICmp(szFormat, "CTF"))
+                    fCtf = true;
+                else if (RTStrICmp(szFormat, "TraceLog"))
+                    rc = VMSetError(pVM, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                                    N_("Configuration error: Unknown /DBGF/TracerFormat value '%s'"), szFormat);
+            }
+        }
         if (RT_SUCCESS(rc))
         {
             AssertLogRelMsgReturn(cbRingBuf && cbRingBuf == (size_t)cbRingBuf,
                                   ("Tracing ringbuffer size %#RX64 is invalid\n", cbRingBuf),
                                   VERR_INVALID_PARAMETER);
 
-            rc = dbgfR3TracerCreate(pVM, fR0Enabled, pszTraceFilePath, cbRingBuf, &pUVM->dbgf.s.pTracerR3);
+            rc = dbgfR3TracerCreate(pVM, fR0Enabled, pszTraceFilePath, fCtf, cbRingBuf, &pUVM->dbgf.s.pTracerR3);
         }
 
         if (pszTraceFilePath)
@@ -1066,9 +1375,23 @@ DECLHIDDEN(void) dbgfR3TracerTerm(PVM pVM)
         int rc = RTThreadWait(pThis->hThrdFlush, RT_MS_30SEC, NULL);
         AssertLogRelMsgRC(rc, ("DBGF: Waiting for the tracer flush thread to terminate failed with %Rrc\n", rc));
 
-        /* Close the trace log. */
-        rc = RTTraceLogWrDestroy(pThis->hTraceLog);
-        AssertLogRelMsgRC(rc, ("DBGF: Closing the trace log file failed with %Rrc\n", rc));
+        if (pThis->hFileCtf != NIL_RTFILE)
+        {
+            /* Write out what's left and close the CTF stream. */
+            rc = dbgfR3TracerCtfFlush(pThis);
+            AssertLogRelMsgRC(rc, ("DBGF: Writing the CTF stream failed with %Rrc\n", rc));
+            rc = RTFileClose(pThis->hFileCtf);
+            AssertLogRelMsgRC(rc, ("DBGF: Closing the CTF stream failed with %Rrc\n", rc));
+            pThis->hFileCtf = NIL_RTFILE;
+            RTMemFree(pThis->pbCtfBuf);
+            pThis->pbCtfBuf = NULL;
+        }
+        else
+        {
+            /* Close the trace log. */
+            rc = RTTraceLogWrDestroy(pThis->hTraceLog);
+            AssertLogRelMsgRC(rc, ("DBGF: Closing the trace log file failed with %Rrc\n", rc));
+        }
 
         SUPSemEventClose(pVM->pSession, pSharedR3->hSupSemEvtFlush);
         /* The instance memory is freed by MM or when the R0 component terminates. */
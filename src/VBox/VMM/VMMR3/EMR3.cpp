@@ -49,6 +49,7 @@
 #define VMCPU_INCL_CPUM_GST_CTX /* for CPUM_IMPORT_GUEST_STATE_RET & interrupt injection */
 #include <VBox/vmm/em.h>
 #include <VBox/vmm/vmm.h>
+#include <VBox/vmm/gim.h>
 #include <VBox/vmm/selm.h>
 #include <VBox/vmm/trpm.h>
 #include <VBox/vmm/iem.h>
@@ -2246,6 +2247,13 @@ VMMR3_INT_DECL(int) EMR3ExecuteVM(PVM pVM, PVMCPU pVCpu)
         STAM_REL_PROFILE_ADV_START(&pVCpu->em.s.StatTotal, x);
         for (;;)
         {
+            /*
+             * Sample the steal time now and then, passing it on to the guest
+             * if it has asked for it via a paravirt. interface.
+             */
+            if (TMR3CpuUpdateStealTime(pVM, pVCpu))
+                GIMR3UpdateStealTime(pVM, pVCpu);
+
             /*
              * Before we can schedule anything (we're here because
              * scheduling is required) we must service any pending
@@ -2679,7 +2687,15 @@ VMMR3_INT_DECL(int) EMR3ExecuteVM(PVM pVM, PVMCPU pVCpu)
                  * Application processor execution halted until SIPI.
                  */
                 case EMSTATE_WAIT_SIPI:
-                    /* no break */
+                    /* Hot-unplugged CPUs are parked without timer polling until plugged in again. */
+                    if (VMR3IsCpuParked(pVCpu))
+                    {
+                        STAM_REL_PROFILE_START(&pVCpu->em.s.StatHalted, y);
+                        rc = VMR3WaitParked(pVM, pVCpu);
+                        STAM_REL_PROFILE_STOP(&pVCpu->em.s.StatHalted, y);
+                        break;
+                    }
+                    RT_FALL_THRU();
                 /*
                  * hlt - execution halted until interrupt.
                  */
@@ -43,6 +43,7 @@
 #include <VBox/vmm/mm.h>
 #include <VBox/vmm/ssm.h>
 #include <VBox/vmm/pdmapi.h>
+#include <VBox/vmm/pdmapic.h>
 #include <VBox/vmm/pdmcritsect.h>
 #include <VBox/vmm/pdmqueue.h>
 #include <VBox/vmm/hm.h>
@@ -55,6 +56,7 @@
 #include "VMMTracing.h"
 
 #include <iprt/asm.h>
+#include <iprt/asm-amd64-x86.h>
 
 #include "EMInline.h"
 
@@ -441,6 +443,9 @@ int emR3HmExecute(PVM pVM, PVMCPU pVCpu, bool *pfFFDone)
             STAM_REL_PROFILE_ADV_STOP(&pVCpu->em.s.StatCapped, u);
             rc = VINF_SUCCESS;
         }
+#ifdef VBOX_WITH_STATISTICS
+        uint64_t const uTscBackInR3 = ASMReadTSC();
+#endif
 
 
         /*
@@ -458,6 +463,9 @@ int emR3HmExecute(PVM pVM, PVMCPU pVCpu, bool *pfFFDone)
             break;
 
         rc = emR3HmHandleRC(pVM, pVCpu, rc);
+#ifdef VBOX_WITH_STATISTICS
+        HMR3NoteExitCompletedInR3(pVCpu, uTscBackInR3);
+#endif
         if (rc != VINF_SUCCESS)
             break;
 
@@ -441,6 +441,32 @@ VMMR3_INT_DECL(void) GIMR3Reset(PVM pVM)
 }
 
 
+/**
+ * Notification that the steal time of a VCPU has changed.
+ *
+ * Providers with a guest-visible steal time interface pass it on here.  The
+ * Hyper-V VP runtime MSR is computed on demand and doesn't need this.
+ *
+ * @param   pVM     The cross context VM structure.
+ * @param   pVCpu   The cross context virtual CPU structure of the caller.
+ * @thread  EMT(pVCpu)
+ */
+VMMR3_INT_DECL(void) GIMR3UpdateStealTime(PVM pVM, PVMCPU pVCpu)
+{
+    switch (pVM->gim.s.enmProviderId)
+    {
+#if defined(VBOX_VMM_TARGET_X86)
+        case GIMPROVIDERID_KVM:
+            gimR3KvmUpdateStealTime(pVM, pVCpu);
+            break;
+#endif
+        default:
+            RT_NOREF(pVCpu);
+            break;
+    }
+}
+
+
 /**
  * Registers the GIM device with VMM.
  *
@@ -236,7 +236,8 @@ VMMR3_INT_DECL(int) gimR3HvInit(PVM pVM, PCFGMNODE pGimCfg)
         int rc2 = CFGMR3ValidateConfig(pCfgHv, "/HyperV/",
                                   "VendorID"
                                   "|VSInterface"
-                                  "|HypercallDebugInterface",
+                                  "|HypercallDebugInterface"
+                                  "|SyntheticTimers",
                                   "" /* pszValidNodes */, "GIM/HyperV" /* pszWho */, 0 /* uInstance */);
         if (RT_FAILURE(rc2))
             return rc2;
@@ -270,6 +271,14 @@ VMMR3_INT_DECL(int) gimR3HvInit(PVM pVM, PCFGMNODE pGimCfg)
     rc = CFGMR3QueryBoolDef(pCfgHv, "HypercallDebugInterface", &pHv->fDbgHypercallInterface, false);
     AssertLogRelRCReturn(rc, rc);
 
+    /** @cfgm{/GIM/HyperV/SyntheticTimers, bool, false}
+     * Whether to expose the synthetic timers to the guest. We don't implement the
+     * SynIC message page, so only direct mode timers (interrupt delivered via the
+     * vector in the timer config MSR) and SINT interrupts without messages work. */
+    bool fStimers;
+    rc = CFGMR3QueryBoolDef(pCfgHv, "SyntheticTimers", &fStimers, false);
+    AssertLogRelRCReturn(rc, rc);
+
     /*
      * Determine interface capabilities based on the version.
      */
@@ -277,7 +286,7 @@ VMMR3_INT_DECL(int) gimR3HvInit(PVM pVM, PCFGMNODE pGimCfg)
     {
         /* Basic features. */
         pHv->uBaseFeat = 0
-                     //| GIM_HV_BASE_FEAT_VP_RUNTIME_MSR
+                       | GIM_HV_BASE_FEAT_VP_RUNTIME_MSR
                        | GIM_HV_BASE_FEAT_PART_TIME_REF_COUNT_MSR
                      //| GIM_HV_BASE_FEAT_BASIC_SYNIC_MSRS          // Both required for synethetic timers
                      //| GIM_HV_BASE_FEAT_STIMER_MSRS               // Both required for synethetic timers
@@ -307,6 +316,15 @@ VMMR3_INT_DECL(int) gimR3HvInit(PVM pVM, PCFGMNODE pGimCfg)
                          | GIM_HV_HINT_X2APIC_MSRS
                          ;
 
+        /* Synthetic timers in direct mode. */
+        if (fStimers)
+        {
+            pHv->uBaseFeat |= GIM_HV_BASE_FEAT_BASIC_SYNIC_MSRS
+                           |  GIM_HV_BASE_FEAT_STIMER_MSRS;
+            pHv->uMiscFeat |= GIM_HV_MISC_FEAT_STIMER_DIRECT_MODE;
+            LogRel(("GIM: HyperV: Exposing synthetic timers (direct mode)\n"));
+        }
+
         /* Partition features. */
         pHv->uPartFlags |= GIM_HV_PART_FLAGS_EXTENDED_HYPERCALLS;
 
@@ -1113,7 +1131,13 @@ static DECLCALLBACK(void) gimR3HvTimerCallback(PVM pVM, TMTIMERHANDLE hTimer, vo
 
     uint64_t const uStimerConfig = pHvStimer->uStimerConfigMsr;
     uint16_t const idxSint       = MSR_GIM_HV_STIMER_GET_SINTX(uStimerConfig);
-    if (RT_LIKELY(idxSint < RT_ELEMENTS(pHvCpu->auSintMsrs)))
+    if (MSR_GIM_HV_STIMER_IS_DIRECT_MODE(uStimerConfig))
+    {
+        /* Direct mode: Interrupt the VCPU using the vector in the config MSR, no SynIC involved. */
+        uint8_t const uVector = MSR_GIM_HV_STIMER_GET_APIC_VECTOR(uStimerConfig);
+        PDMApicHvSendInterrupt(pVCpu, uVector, false /* fAutoEoi */, XAPICTRIGGERMODE_EDGE);
+    }
+    else if (RT_LIKELY(idxSint < RT_ELEMENTS(pHvCpu->auSintMsrs)))
     {
         uint64_t const uSint = pHvCpu->auSintMsrs[idxSint];
         if (!MSR_GIM_HV_SINT_IS_MASKED(uSint))
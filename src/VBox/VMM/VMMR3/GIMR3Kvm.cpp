@@ -57,7 +57,9 @@
 /**
  * GIM KVM saved-state version.
  */
-#define GIM_KVM_SAVED_STATE_VERSION         UINT32_C(1)
+#define GIM_KVM_SAVED_STATE_VERSION                     UINT32_C(2)
+/** Saved state version without the steal-time MSR. */
+#define GIM_KVM_SAVED_STATE_VERSION_PRE_STEAL_TIME      UINT32_C(1)
 
 /**
  * VBox internal struct. to passback to EMT rendezvous callback while enabling
@@ -245,7 +247,7 @@ VMMR3_INT_DECL(int) gimR3KvmInit(PVM pVM)
                         //|  GIM_KVM_BASE_FEAT_MMU_OP
                         | GIM_KVM_BASE_FEAT_CLOCK
                         //| GIM_KVM_BASE_FEAT_ASYNC_PF
-                        //| GIM_KVM_BASE_FEAT_STEAL_TIME
+                        | GIM_KVM_BASE_FEAT_STEAL_TIME
                         //| GIM_KVM_BASE_FEAT_PV_EOI
                         | GIM_KVM_BASE_FEAT_PV_UNHALT
                         ;
@@ -383,6 +385,11 @@ VMMR3_INT_DECL(void) gimR3KvmReset(PVM pVM)
         pKvmCpu->GCPhysSystemTime = 0;
         pKvmCpu->uTsc = 0;
         pKvmCpu->uVirtNanoTS = 0;
+        pKvmCpu->u64StealTimeMsr = 0;
+        pKvmCpu->GCPhysStealTime = 0;
+        pKvmCpu->u32StealTimeVersion = 0;
+        pKvmCpu->uStealTime = 0;
+        pKvmCpu->cNsStealLast = 0;
     }
 }
 
@@ -415,6 +422,10 @@ VMMR3_INT_DECL(int) gimR3KvmSave(PVM pVM, PSSMHANDLE pSSM)
         SSMR3PutGCPhys(pSSM, pKvmCpu->GCPhysSystemTime);
         SSMR3PutU32(pSSM, pKvmCpu->u32SystemTimeVersion);
         SSMR3PutU8(pSSM, pKvmCpu->fSystemTimeFlags);
+        SSMR3PutU64(pSSM, pKvmCpu->u64StealTimeMsr);
+        SSMR3PutGCPhys(pSSM, pKvmCpu->GCPhysStealTime);
+        SSMR3PutU32(pSSM, pKvmCpu->u32StealTimeVersion);
+        SSMR3PutU64(pSSM, pKvmCpu->uStealTime);
     }
 
     /*
@@ -440,7 +451,8 @@ VMMR3_INT_DECL(int) gimR3KvmLoad(PVM pVM, PSSMHANDLE pSSM)
     uint32_t uKvmSavedStatVersion;
     int rc = SSMR3GetU32(pSSM, &uKvmSavedStatVersion);
     AssertRCReturn(rc, rc);
-    if (uKvmSavedStatVersion != GIM_KVM_SAVED_STATE_VERSION)
+    if (   uKvmSavedStatVersion != GIM_KVM_SAVED_STATE_VERSION
+        && uKvmSavedStatVersion != GIM_KVM_SAVED_STATE_VERSION_PRE_STEAL_TIME)
         return SSMR3SetLoadError(pSSM, VERR_SSM_UNSUPPORTED_DATA_UNIT_VERSION, RT_SRC_POS,
                                  N_("Unsupported KVM saved-state version %u (expected %u)."),
                                  uKvmSavedStatVersion, GIM_KVM_SAVED_STATE_VERSION);
@@ -466,6 +478,17 @@ VMMR3_INT_DECL(int) gimR3KvmLoad(PVM pVM, PSSMHANDLE pSSM)
         SSMR3GetU32(pSSM, &pKvmCpu->u32SystemTimeVersion);
         rc = SSMR3GetU8(pSSM, &pKvmCpu->fSystemTimeFlags);
         AssertRCReturn(rc, rc);
+        if (uKvmSavedStatVersion > GIM_KVM_SAVED_STATE_VERSION_PRE_STEAL_TIME)
+        {
+            SSMR3GetU64(pSSM, &pKvmCpu->u64StealTimeMsr);
+            SSMR3GetGCPhys(pSSM, &pKvmCpu->GCPhysStealTime);
+            SSMR3GetU32(pSSM, &pKvmCpu->u32StealTimeVersion);
+            rc = SSMR3GetU64(pSSM, &pKvmCpu->uStealTime);
+            AssertRCReturn(rc, rc);
+        }
+
+        /* The TM steal time isn't saved, continue from wherever it is now. */
+        pKvmCpu->cNsStealLast = TMCpuGetStealTime(pVCpu);
 
         /* Enable the system-time struct. if necessary. */
         /** @todo update guest struct only if cTscTicksPerSecond doesn't match host
@@ -628,3 +651,111 @@ VMMR3_INT_DECL(int) gimR3KvmEnableSystemTime(PVMCC pVM, PVMCPUCC pVCpu, uint64_t
     return rc;
 }
 
+
+/**
+ * Writes the KVM VCPU steal-time structure to guest memory.
+ *
+ * The version field is odd while we're updating the steal time, so the guest
+ * (possibly reading it from another VCPU) retries instead of using a torn value.
+ *
+ * @returns VBox status code.
+ * @param   pVM     The cross context VM structure.
+ * @param   pVCpu   The cross context virtual CPU structure.
+ */
+static int gimR3KvmWriteStealTime(PVM pVM, PVMCPU pVCpu)
+{
+    PGIMKVMCPU     pKvmCpu         = &pVCpu->gim.s.u.KvmCpu;
+    RTGCPHYS const GCPhysStealTime = pKvmCpu->GCPhysStealTime;
+    Assert(!(pKvmCpu->u32StealTimeVersion & UINT32_C(1)));
+
+    uint32_t uVersion = pKvmCpu->u32StealTimeVersion + 1;
+    int rc = PGMPhysSimpleWriteGCPhys(pVM, GCPhysStealTime + RT_UOFFSETOF(GIMKVMSTEALTIME, u32Version),
+                                      &uVersion, sizeof(uVersion));
+    if (RT_SUCCESS(rc))
+    {
+        rc = PGMPhysSimpleWriteGCPhys(pVM, GCPhysStealTime + RT_UOFFSETOF(GIMKVMSTEALTIME, u64Steal),
+                                      &pKvmCpu->uStealTime, sizeof(pKvmCpu->uStealTime));
+        ++uVersion;
+        int rc2 = PGMPhysSimpleWriteGCPhys(pVM, GCPhysStealTime + RT_UOFFSETOF(GIMKVMSTEALTIME, u32Version),
+                                           &uVersion, sizeof(uVersion));
+        if (RT_SUCCESS(rc))
+            rc = rc2;
+        pKvmCpu->u32StealTimeVersion = uVersion;
+    }
+    return rc;
+}
+
+
+/**
+ * Enables the KVM steal-time structure.
+ *
+ * Like the system-time struct., this is per-VCPU and done without an EMT
+ * rendezvous.  We continue from whatever steal time is in the guest struct.,
+ * which is what KVM does as well.
+ *
+ * @returns VBox status code.
+ * @param   pVM             The cross context VM structure.
+ * @param   pVCpu           The cross context virtual CPU structure.
+ * @param   uMsrStealTime   The steal-time MSR value being written.
+ */
+VMMR3_INT_DECL(int) gimR3KvmEnableStealTime(PVM pVM, PVMCPU pVCpu, uint64_t uMsrStealTime)
+{
+    Assert(MSR_GIM_KVM_STEAL_TIME_IS_ENABLED(uMsrStealTime));
+    PGIMKVMCPU     pKvmCpu         = &pVCpu->gim.s.u.KvmCpu;
+    RTGCPHYS const GCPhysStealTime = MSR_GIM_KVM_STEAL_TIME_GUEST_GPA(uMsrStealTime);
+    if (!PGMPhysIsGCPhysNormal(pVM, GCPhysStealTime))
+    {
+        LogRel(("GIM: KVM: VCPU%3d: Invalid physical addr requested for mapping steal-time struct. GCPhysStealTime=%#RGp\n",
+                pVCpu->idCpu, GCPhysStealTime));
+        return VERR_GIM_OPERATION_FAILED;
+    }
+
+    GIMKVMSTEALTIME StealTime;
+    int rc = PGMPhysSimpleReadGCPhys(pVM, &StealTime, GCPhysStealTime, sizeof(StealTime));
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("GIM: KVM: VCPU%3d: Failed to read steal-time struct. at %#RGp. rc=%Rrc\n", pVCpu->idCpu, GCPhysStealTime, rc));
+        return rc;
+    }
+
+    pKvmCpu->u64StealTimeMsr     = uMsrStealTime;
+    pKvmCpu->GCPhysStealTime     = GCPhysStealTime;
+    pKvmCpu->u32StealTimeVersion = (StealTime.u32Version + 1) & ~UINT32_C(1);
+    pKvmCpu->uStealTime          = StealTime.u64Steal;
+    pKvmCpu->cNsStealLast        = TMCpuGetStealTime(pVCpu);
+
+    rc = gimR3KvmWriteStealTime(pVM, pVCpu);
+    if (RT_SUCCESS(rc))
+        LogRel(("GIM: KVM: VCPU%3d: Enabled steal-time struct. at %#RGp - uStealTime=%RU64 uVersion=%#RU32\n",
+                pVCpu->idCpu, GCPhysStealTime, pKvmCpu->uStealTime, pKvmCpu->u32StealTimeVersion));
+    else
+        LogRel(("GIM: KVM: VCPU%3d: Failed to write steal-time struct. at %#RGp. rc=%Rrc\n", pVCpu->idCpu, GCPhysStealTime, rc));
+    return rc;
+}
+
+
+/**
+ * Passes on the steal time TM has accumulated since the last update to the
+ * guest's steal-time structure, if enabled.
+ *
+ * @param   pVM     The cross context VM structure.
+ * @param   pVCpu   The cross context virtual CPU structure.
+ * @thread  EMT(pVCpu)
+ */
+VMMR3_INT_DECL(void) gimR3KvmUpdateStealTime(PVM pVM, PVMCPU pVCpu)
+{
+    PGIMKVMCPU pKvmCpu = &pVCpu->gim.s.u.KvmCpu;
+    if (!MSR_GIM_KVM_STEAL_TIME_IS_ENABLED(pKvmCpu->u64StealTimeMsr))
+        return;
+
+    uint64_t const cNsSteal = TMCpuGetStealTime(pVCpu);
+    if (cNsSteal > pKvmCpu->cNsStealLast)
+        pKvmCpu->uStealTime += cNsSteal - pKvmCpu->cNsStealLast;
+    pKvmCpu->cNsStealLast = cNsSteal;
+
+    int rc = gimR3KvmWriteStealTime(pVM, pVCpu);
+    if (RT_FAILURE(rc))
+        LogRelMax(8, ("GIM: KVM: VCPU%3d: Failed to update steal-time struct. at %#RGp. rc=%Rrc\n", pVCpu->idCpu,
+                      pKvmCpu->GCPhysStealTime, rc));
+}
+
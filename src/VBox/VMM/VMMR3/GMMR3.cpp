@@ -441,6 +441,17 @@ VMMR3_INT_DECL(int)  GMMR3CheckSharedModules(PVM pVM)
 }
 
 
+/**
+ * @see GMMR0ScanDuplicatePagesReq
+ */
+VMMR3_INT_DECL(int)  GMMR3ScanDuplicatePages(PVM pVM, PGMMSCANDUPLICATEPAGESREQ pReq)
+{
+    pReq->Hdr.u32Magic = SUPVMMR0REQHDR_MAGIC;
+    pReq->Hdr.cbReq    = sizeof(*pReq);
+    return VMMR3CallR0(pVM, VMMR0_DO_GMM_SCAN_DUPLICATE_PAGES, 0, &pReq->Hdr);
+}
+
+
 # if defined(VBOX_STRICT)
 /**
  * @see GMMR0FindDuplicatePage
@@ -45,9 +45,11 @@
 #endif
 
 #include <iprt/assert.h>
+#include <iprt/file.h>
 #include <iprt/getopt.h>
 #include <iprt/mem.h>
 #include <iprt/ldr.h>
+#include <iprt/sort.h>
 #include <iprt/string.h>
 
 #if defined(VBOX_WITH_IEM_RECOMPILER) && !defined(VBOX_VMM_TARGET_ARMV8)
@@ -71,6 +73,7 @@ static FNDBGFINFOARGVINT iemR3InfoTlbTrace;
 #if defined(VBOX_WITH_IEM_RECOMPILER) && !defined(VBOX_VMM_TARGET_ARMV8)
 static FNDBGFINFOARGVINT iemR3InfoTb;
 static FNDBGFINFOARGVINT iemR3InfoTbTop;
+static FNDBGFINFOARGVINT iemR3InfoTbChains;
 #endif
 #ifdef VBOX_WITH_DEBUGGER
 static void iemR3RegisterDebuggerCommands(void);
@@ -99,6 +102,156 @@ static const char *iemGetTargetCpuName(uint32_t enmTargetCpu)
 #endif
 
 
+#if defined(VBOX_WITH_IEM_NATIVE_RECOMPILER) && !defined(VBOX_VMM_TARGET_ARMV8)
+
+/**
+ * Loads the TB warm-start profile and hands it to all the EMTs.
+ *
+ * A missing file is not an error, neither is a file written by an
+ * incompatible VirtualBox version.  We just start cold in those cases.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pszFile     The profile file.
+ */
+static int iemR3TbProfileLoad(PVM pVM, const char *pszFile)
+{
+    void  *pvFile = NULL;
+    size_t cbFile = 0;
+    int rc = RTFileReadAllEx(pszFile, 0, _64M, RTFILE_RDALL_O_DENY_NONE, &pvFile, &cbFile);
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("IEM: No TB profile loaded from '%s': %Rrc\n", pszFile, rc));
+        return VINF_SUCCESS;
+    }
+
+    IEMTBPROFILEHDR const * const pHdr = (IEMTBPROFILEHDR const *)pvFile;
+    if (   cbFile < sizeof(*pHdr)
+        || pHdr->uMagic   != IEMTBPROFILEHDR_MAGIC
+        || pHdr->uVersion != IEMTBPROFILEHDR_VERSION
+        || pHdr->cbEntry  != sizeof(IEMTBPROFILEENTRY)
+        || pHdr->fKeyMask != IEMTB_F_KEY_MASK
+        || cbFile != sizeof(*pHdr) + (size_t)pHdr->cEntries * sizeof(IEMTBPROFILEENTRY))
+    {
+        LogRel(("IEM: Ignoring incompatible or corrupt TB profile '%s' (%zu bytes)\n", pszFile, cbFile));
+        RTFileReadAllFree(pvFile, cbFile);
+        return VINF_SUCCESS;
+    }
+
+    uint32_t const      cEntries   = pHdr->cEntries;
+    PIEMTBPROFILE const pTbProfile = (PIEMTBPROFILE)RTMemAlloc(RT_UOFFSETOF_DYN(IEMTBPROFILE, aEntries[cEntries]));
+    if (!pTbProfile)
+    {
+        RTFileReadAllFree(pvFile, cbFile);
+        return VERR_NO_MEMORY;
+    }
+    pTbProfile->cEntries = cEntries;
+    pTbProfile->uPadding = 0;
+    memcpy(pTbProfile->aEntries, pHdr + 1, cEntries * sizeof(IEMTBPROFILEENTRY));
+    RTFileReadAllFree(pvFile, cbFile);
+
+    /* We do the lookups using binary searching, so don't trust the file on the ordering. */
+    if (!RTSortIsSorted(pTbProfile->aEntries, cEntries, sizeof(pTbProfile->aEntries[0]), iemTbProfileCompare, NULL))
+        RTSortShell(pTbProfile->aEntries, cEntries, sizeof(pTbProfile->aEntries[0]), iemTbProfileCompare, NULL);
+
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+        pVM->apCpusR3[idCpu]->iem.s.pTbProfileR3 = pTbProfile;
+    LogRel(("IEM: Loaded %u TB profile entries from '%s'\n", cEntries, pszFile));
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Writes the TB warm-start profile, recording all the native TBs of all EMTs.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pszFile     The profile file.
+ * @note    Called during termination, so the EMTs are no longer running TBs.
+ */
+static void iemR3TbProfileSave(PVM pVM, const char *pszFile)
+{
+    /*
+     * Count the native TBs so we can size the buffer.
+     */
+    uint32_t cNativeTbs = 0;
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+    {
+        PIEMTBALLOCATOR const pTbAllocator = IRECM(pVM->apCpusR3[idCpu]).pTbAllocatorR3;
+        if (pTbAllocator)
+            cNativeTbs += pTbAllocator->cNativeTbs;
+    }
+
+    IEMTBPROFILEHDR * const pHdr = (IEMTBPROFILEHDR *)RTMemAllocZ(sizeof(*pHdr) + cNativeTbs * sizeof(IEMTBPROFILEENTRY));
+    AssertLogRelReturnVoid(pHdr);
+    PIEMTBPROFILEENTRY const paEntries = (PIEMTBPROFILEENTRY)(pHdr + 1);
+
+    /*
+     * Collect the entries.
+     */
+    uint32_t cEntries = 0;
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+    {
+        PIEMTBALLOCATOR const pTbAllocator = IRECM(pVM->apCpusR3[idCpu]).pTbAllocatorR3;
+        if (!pTbAllocator)
+            continue;
+        for (uint32_t idxChunk = 0; idxChunk < pTbAllocator->cAllocatedChunks; idxChunk++)
+        {
+            PCIEMTB const paTbs = pTbAllocator->aChunks[idxChunk].paTbs;
+            for (uint32_t idxTb = 0; idxTb < pTbAllocator->cTbsPerChunk && cEntries < cNativeTbs; idxTb++)
+                if ((paTbs[idxTb].fFlags & IEMTB_F_TYPE_MASK) == IEMTB_F_TYPE_NATIVE)
+                    iemTbProfileEntryInit(&paEntries[cEntries++], &paTbs[idxTb]);
+        }
+    }
+
+    /*
+     * Sort and drop duplicates (the same code is often hot on several EMTs).
+     */
+    RTSortShell(paEntries, cEntries, sizeof(paEntries[0]), iemTbProfileCompare, NULL);
+    uint32_t cUnique = 0;
+    for (uint32_t i = 0; i < cEntries; i++)
+        if (!cUnique || iemTbProfileCompare(&paEntries[cUnique - 1], &paEntries[i], NULL) != 0)
+            paEntries[cUnique++] = paEntries[i];
+
+    pHdr->uMagic   = IEMTBPROFILEHDR_MAGIC;
+    pHdr->uVersion = IEMTBPROFILEHDR_VERSION;
+    pHdr->cbEntry  = sizeof(IEMTBPROFILEENTRY);
+    pHdr->cEntries = cUnique;
+    pHdr->fKeyMask = IEMTB_F_KEY_MASK;
+
+    /*
+     * Write it.
+     */
+    RTFILE hFile = NIL_RTFILE;
+    int rc = RTFileOpen(&hFile, pszFile, RTFILE_O_WRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_WRITE);
+    if (RT_SUCCESS(rc))
+    {
+        rc = RTFileWrite(hFile, pHdr, sizeof(*pHdr) + cUnique * sizeof(IEMTBPROFILEENTRY), NULL);
+        int rc2 = RTFileClose(hFile);
+        if (RT_SUCCESS(rc))
+            rc = rc2;
+    }
+    if (RT_SUCCESS(rc))
+        LogRel(("IEM: Saved %u TB profile entries to '%s'\n", cUnique, pszFile));
+    else
+        LogRel(("IEM: Failed to save the TB profile to '%s': %Rrc\n", pszFile, rc));
+    RTMemFree(pHdr);
+}
+
+
+/**
+ * Frees the TB warm-start profile, if any.
+ */
+static void iemR3TbProfileFree(PVM pVM)
+{
+    PCIEMTBPROFILE const pTbProfile = pVM->apCpusR3[0]->iem.s.pTbProfileR3;
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+        pVM->apCpusR3[idCpu]->iem.s.pTbProfileR3 = NULL;
+    RTMemFree((void *)pTbProfile);
+}
+
+#endif /* VBOX_WITH_IEM_NATIVE_RECOMPILER && !VBOX_VMM_TARGET_ARMV8 */
+
+
 #if defined(RT_ARCH_ARM64) && defined(_MSC_VER)
 # pragma warning(disable:4883) /* profile build: IEMR3.cpp(114) : warning C4883: 'IEMR3Init': function size suppresses optimizations*/
 #endif
@@ -197,6 +350,22 @@ VMMR3_INT_DECL(int) IEMR3Init(PVM pVM)
     rc = CFGMR3QueryU32Def(pIem, "NativeRecompileAtUsedCount", &uTbNativeRecompileAtUsedCount, 16);
     AssertLogRelRCReturn(rc, rc);
 
+    /** @cfgm{/IEM/SharedTbHints, bool, true}
+     * Whether EMTs should tell each other about translation blocks they have
+     * natively recompiled, so the same code doesn't have to warm up separately
+     * on each vCPU.  Only relevant for SMP guests. */
+    bool fSharedTbHints = true;
+    rc = CFGMR3QueryBoolDef(pIem, "SharedTbHints", &fSharedTbHints, true);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/IEM/TbChainProfiling, bool, false}
+     * Whether to profile TB-to-TB transitions going thru the run loop, i.e.
+     * those not handled by direct linking.  The result can be inspected using
+     * 'info tbchains' and is input for superblock formation work. */
+    bool fTbChainProfiling = false;
+    rc = CFGMR3QueryBoolDef(pIem, "TbChainProfiling", &fTbChainProfiling, false);
+    AssertLogRelRCReturn(rc, rc);
+
     /** @cfgm{/IEM/HostICacheInvalidationViaHostAPI, bool, false}
      * Whether to use any available host OS API for flushing the instruction cache
      * after completing an translation block. */
@@ -214,6 +383,48 @@ VMMR3_INT_DECL(int) IEMR3Init(PVM pVM)
     if (fFlag)
         fHostICacheInvalidation |= IEMNATIVE_ICACHE_F_END_WITH_ISH;
 
+    /** @cfgm{/IEM/ExecMemDualMapping, bool, false}
+     * Whether to map each executable memory chunk twice, once read+write for
+     * emitting code and once read+execute for running it, instead of using a
+     * single RWX mapping.  Only supported on linux hosts (macOS always does this,
+     * other hosts ignore it). */
+    fFlag = false;
+    rc = CFGMR3QueryBoolDef(pIem, "ExecMemDualMapping", &fFlag, false);
+    AssertLogRelRCReturn(rc, rc);
+    uint8_t fExecMemFlags = fFlag ? IEMEXECMEM_F_DUAL_MAPPING : 0;
+
+    /** @cfgm{/IEM/ExecMemLargePages, bool, false}
+     * Whether to try back the executable memory chunks with 2 MiB host pages to
+     * reduce iTLB pressure when running a lot of recompiled code.  This implies
+     * ExecMemDualMapping and raises the minimum chunk size to 2 MiB.  It will
+     * fall back on transparent huge pages and then regular pages if there are no
+     * hugetlbfs pages available. */
+    fFlag = false;
+    rc = CFGMR3QueryBoolDef(pIem, "ExecMemLargePages", &fFlag, false);
+    AssertLogRelRCReturn(rc, rc);
+    if (fFlag)
+        fExecMemFlags |= IEMEXECMEM_F_LARGE_PAGES | IEMEXECMEM_F_DUAL_MAPPING;
+
+    /** @cfgm{/IEM/HostPerfMap, bool, false}
+     * Whether to append an entry to /tmp/perf-<pid>.map for each natively
+     * recompiled TB, so the host 'perf top' can name recompiled code after the
+     * guest PC.  Linux hosts only. */
+    fFlag = false;
+    rc = CFGMR3QueryBoolDef(pIem, "HostPerfMap", &fFlag, false);
+    AssertLogRelRCReturn(rc, rc);
+    if (fFlag)
+        fExecMemFlags |= IEMEXECMEM_F_PERF_MAP;
+
+    /** @cfgm{/IEM/HostPerfJitDump, bool, false}
+     * Whether to write a /tmp/jit-<pid>.dump file with the code of each natively
+     * recompiled TB, for use with 'perf record -k mono' and 'perf inject --jit'.
+     * Linux hosts only. */
+    fFlag = false;
+    rc = CFGMR3QueryBoolDef(pIem, "HostPerfJitDump", &fFlag, false);
+    AssertLogRelRCReturn(rc, rc);
+    if (fFlag)
+        fExecMemFlags |= IEMEXECMEM_F_PERF_JITDUMP;
+
 #endif /* VBOX_WITH_IEM_RECOMPILER*/
 
     /*
@@ -323,6 +534,7 @@ VMMR3_INT_DECL(int) IEMR3Init(PVM pVM)
         IRECM(pVCpu).uRegFpCtrl                    = IEMNATIVE_SIMD_FP_CTRL_REG_NOT_MODIFIED;
         IRECM(pVCpu).uTbNativeRecompileAtUsedCount = uTbNativeRecompileAtUsedCount;
         IRECM(pVCpu).fHostICacheInvalidation       = fHostICacheInvalidation;
+        IRECM(pVCpu).fExecMemFlags                 = fExecMemFlags;
 #endif
 
 #ifdef IEM_WITH_TLB_TRACE
@@ -348,6 +560,55 @@ VMMR3_INT_DECL(int) IEMR3Init(PVM pVM)
     rc = VMR3ReqCallWait(pVM, VMCPUID_ALL, (PFNRT)iemTbInit, 6,
                          pVM, cInitialTbs, cMaxTbs, cbInitialExec, cbMaxExec, cbChunkExec);
     AssertLogRelRCReturn(rc, rc);
+
+    if (fTbChainProfiling)
+        for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+        {
+            PIEMTBCHAINPROF const pChainProf = (PIEMTBCHAINPROF)RTMemAllocZ(sizeof(*pChainProf));
+            AssertLogRelReturn(pChainProf, VERR_NO_MEMORY);
+            IRECM(pVM->apCpusR3[idCpu]).pTbCacheR3->pChainProf = pChainProf;
+        }
+
+# ifdef VBOX_WITH_IEM_NATIVE_RECOMPILER
+    /*
+     * Allocate the VM-wide hot TB hint table for SMP guests.  It is sized
+     * after the per-EMT TB limit, rounded up to a power of two.
+     */
+    if (fSharedTbHints && pVM->cCpus > 1 && uTbNativeRecompileAtUsedCount > 1)
+    {
+        uint32_t cHintEntries = cMaxTbs;
+        if (!RT_IS_POWER_OF_TWO(cHintEntries))
+            cHintEntries = RT_BIT_32(ASMBitLastSetU32(cHintEntries));
+        size_t const      cbHints = RT_UOFFSETOF_DYN(IEMTBHINTS, au64Keys[cHintEntries]);
+        PIEMTBHINTS const pHints  = (PIEMTBHINTS)RTMemPageAllocZ(cbHints);
+        if (!pHints)
+            return VMSetError(pVM, VERR_NO_PAGE_MEMORY, RT_SRC_POS,
+                              "Failed to allocate %zu bytes for the shared TB hint table", cbHints);
+        pHints->uMagic    = IEMTBHINTS_MAGIC;
+        pHints->uHashMask = cHintEntries - 1;
+        for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+            IRECM(pVM->apCpusR3[idCpu]).pTbCacheR3->pHints = pHints;
+        LogRel(("IEM: Shared TB hint table with %u entries\n", cHintEntries));
+    }
+# else
+    RT_NOREF(fSharedTbHints);
+# endif
+
+# if defined(VBOX_WITH_IEM_NATIVE_RECOMPILER) && !defined(VBOX_VMM_TARGET_ARMV8)
+    /** @cfgm{/IEM/TbProfileFile, string, none}
+     * File for persisting which translation blocks were natively recompiled, so
+     * that subsequent runs of the same guest image can natively recompile them
+     * on second use instead of warming up all over again.  The file is loaded
+     * here and rewritten at VM termination.  Entries are validated against the
+     * opcode bytes when the block is compiled, so stale files are harmless. */
+    char *pszTbProfileFile = NULL;
+    rc = CFGMR3QueryStringAllocDef(pIem, "TbProfileFile", &pszTbProfileFile, NULL);
+    AssertLogRelRCReturn(rc, rc);
+    if (pszTbProfileFile && *pszTbProfileFile)
+        rc = iemR3TbProfileLoad(pVM, pszTbProfileFile);
+    MMR3HeapFree(pszTbProfileFile);
+    AssertLogRelRCReturn(rc, rc);
+# endif
 #endif
 
     /*
@@ -420,6 +681,14 @@ VMMR3_INT_DECL(int) IEMR3Init(PVM pVM)
                         "Code TLB page invlpg scanning for global large pages",     "/IEM/CPU%u/Tlb/Code/InvlPg/LargeGlobal", idCpu);
         STAMR3RegisterF(pVM, &ITLBS(pVCpu).Code.cTlbInvlPgLargeNonGlobal, STAMTYPE_U32_RESET, STAMVISIBILITY_ALWAYS, STAMUNIT_NONE,
                         "Code TLB page invlpg scanning for non-global large pages", "/IEM/CPU%u/Tlb/Code/InvlPg/LargeNonGlobal", idCpu);
+#ifdef IEMTLB_WITH_L2_LARGE_PAGES
+        STAMR3RegisterF(pVM, &ITLBS(pVCpu).Code.cTlbL2Hits, STAMTYPE_U32_RESET, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Code TLB misses resolved by the large page L2 TLB", "/IEM/CPU%u/Tlb/Code/L2/Hits", idCpu);
+        STAMR3RegisterF(pVM, &ITLBS(pVCpu).Code.cTlbL2Loads, STAMTYPE_U32_RESET, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Code TLB large page L2 TLB loads",            "/IEM/CPU%u/Tlb/Code/L2/Loads", idCpu);
+        STAMR3RegisterF(pVM, &ITLBS(pVCpu).Code.cTlbL2CurGiganticLoads, STAMTYPE_U32, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Code TLB large page L2 TLB 1GB page loads since wipe", "/IEM/CPU%u/Tlb/Code/L2/CurGiganticLoads", idCpu);
+#endif
 
         STAMR3RegisterF(pVM, &ITLBS(pVCpu).Code.cTlbCoreMisses,      STAMTYPE_U64_RESET, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
                         "Code TLB misses",                              "/IEM/CPU%u/Tlb/Code/Misses", idCpu);
@@ -515,6 +784,14 @@ VMMR3_INT_DECL(int) IEMR3Init(PVM pVM)
                         "Data TLB page invlpg scanning for global large pages",     "/IEM/CPU%u/Tlb/Data/InvlPg/LargeGlobal", idCpu);
         STAMR3RegisterF(pVM, &ITLBS(pVCpu).Data.cTlbInvlPgLargeNonGlobal, STAMTYPE_U32_RESET, STAMVISIBILITY_ALWAYS, STAMUNIT_NONE,
                         "Data TLB page invlpg scanning for non-global large pages", "/IEM/CPU%u/Tlb/Data/InvlPg/LargeNonGlobal", idCpu);
+#ifdef IEMTLB_WITH_L2_LARGE_PAGES
+        STAMR3RegisterF(pVM, &ITLBS(pVCpu).Data.cTlbL2Hits, STAMTYPE_U32_RESET, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Data TLB misses resolved by the large page L2 TLB", "/IEM/CPU%u/Tlb/Data/L2/Hits", idCpu);
+        STAMR3RegisterF(pVM, &ITLBS(pVCpu).Data.cTlbL2Loads, STAMTYPE_U32_RESET, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Data TLB large page L2 TLB loads",            "/IEM/CPU%u/Tlb/Data/L2/Loads", idCpu);
+        STAMR3RegisterF(pVM, &ITLBS(pVCpu).Data.cTlbL2CurGiganticLoads, STAMTYPE_U32, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Data TLB large page L2 TLB 1GB page loads since wipe", "/IEM/CPU%u/Tlb/Data/L2/CurGiganticLoads", idCpu);
+#endif
 
         STAMR3RegisterF(pVM, &ITLBS(pVCpu).Data.cTlbCoreMisses,      STAMTYPE_U64_RESET, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
                         "Data TLB core misses (iemMemMap, direct iemMemMapJmp (not safe path))",
@@ -681,7 +958,22 @@ VMMR3_INT_DECL(int) IEMR3Init(PVM pVM)
                         "Translation block lookup misses",              "/IEM/CPU%u/re/cTbLookupMisses", idCpu);
         STAMR3RegisterF(pVM, (void *)&pTbCache->cCollisions,            STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
                         "Translation block hash table collisions",      "/IEM/CPU%u/re/cTbCollisions", idCpu);
+        if (pTbCache->pChainProf)
+        {
+            STAMR3RegisterF(pVM, (void *)&pTbCache->pChainProf->StatTransitions, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                            "TB-to-TB transitions thru the run loop",       "/IEM/CPU%u/re/TbChains/Transitions", idCpu);
+            STAMR3RegisterF(pVM, (void *)&pTbCache->pChainProf->StatHotEdges, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                            "TB-to-TB transitions that became hot",         "/IEM/CPU%u/re/TbChains/HotEdges", idCpu);
+            STAMR3RegisterF(pVM, (void *)&pTbCache->pChainProf->StatEvictions, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                            "TB-to-TB transition profile entry evictions",  "/IEM/CPU%u/re/TbChains/Evictions", idCpu);
+        }
+        STAMR3RegisterF(pVM, (void *)&pTbCache->cHintHits,              STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                        "New TBs fast-tracked because another EMT already recompiled them", "/IEM/CPU%u/re/cTbSharedHintHits", idCpu);
+        STAMR3RegisterF(pVM, (void *)&pTbCache->cThrdEflDeadCalls,      STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_CALLS,
+                        "Calls in new threaded TBs marked for the variant w/o status flag calculations", "/IEM/CPU%u/re/ThrdEflDeadCalls", idCpu);
 # ifdef VBOX_WITH_STATISTICS
+        STAMR3RegisterF(pVM, (void *)&pTbCache->cThrdEflDeadCallsExecuted, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_CALLS,
+                        "Threaded calls executed w/o status flag calculations", "/IEM/CPU%u/re/ThrdEflDeadCallsExecuted", idCpu);
         STAMR3RegisterF(pVM, (void *)&pTbCache->StatPrune,              STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL,
                         "Time spent shortening collision lists",        "/IEM/CPU%u/re/TbPruningCollisions", idCpu);
 # endif
@@ -725,6 +1017,12 @@ VMMR3_INT_DECL(int) IEMR3Init(PVM pVM)
         STAMR3RegisterF(pVM, (void *)&pVCpu->iem.s.StatNativeFullyRecompiledTbs, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
                         "Number of threaded calls that could not be recompiler to native code",
                         "/IEM/CPU%u/re/NativeFullyRecompiledTbs", idCpu);
+        STAMR3RegisterF(pVM, (void *)&pVCpu->iem.s.StatTbProfileHits, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Threaded TBs fast-tracked for native recompilation by the TB profile",
+                        "/IEM/CPU%u/re/TbProfileHits", idCpu);
+        STAMR3RegisterF(pVM, (void *)&pVCpu->iem.s.StatTbProfileStale, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Threaded TBs matching a TB profile entry but with modified opcodes",
+                        "/IEM/CPU%u/re/TbProfileStale", idCpu);
 
         STAMR3RegisterF(pVM, (void *)&pVCpu->iem.s.StatTbNativeCode, STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES_PER_TB,
                         "Size of native code per TB",                   "/IEM/CPU%u/re/NativeCodeSizePerTb", idCpu);
@@ -1093,6 +1391,8 @@ VMMR3_INT_DECL(int) IEMR3Init(PVM pVM)
     DBGFR3InfoRegisterInternalArgv(pVM, "tb",    "IEM translation block", iemR3InfoTb, DBGFINFO_FLAGS_RUN_ON_EMT);
     DBGFR3InfoRegisterInternalArgv(pVM, "tbtop", "IEM translation blocks most used or most recently used",
                                    iemR3InfoTbTop, DBGFINFO_FLAGS_RUN_ON_EMT);
+    DBGFR3InfoRegisterInternalArgv(pVM, "tbchains", "IEM TB-to-TB transitions thru the run loop (needs /IEM/TbChainProfiling)",
+                                   iemR3InfoTbChains, DBGFINFO_FLAGS_RUN_ON_EMT);
 #endif
 #ifdef VBOX_WITH_DEBUGGER
     iemR3RegisterDebuggerCommands();
@@ -1212,6 +1512,36 @@ VMMR3_INT_DECL(int) IEMR3Term(PVM pVM)
 #if defined(VBOX_WITH_IEM_NATIVE_RECOMPILER) && defined(VBOX_WITH_SAVE_THREADED_TBS_FOR_PROFILING)
     for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
         iemThreadedSaveTbForProfilingCleanup(pVM->apCpusR3[idCpu]);
+#endif
+#if defined(VBOX_WITH_IEM_NATIVE_RECOMPILER) && !defined(VBOX_VMM_TARGET_ARMV8)
+    char *pszTbProfileFile = NULL;
+    int rc = CFGMR3QueryStringAllocDef(CFGMR3GetChild(CFGMR3GetRoot(pVM), "IEM"), "TbProfileFile", &pszTbProfileFile, NULL);
+    if (RT_SUCCESS(rc) && pszTbProfileFile && *pszTbProfileFile)
+        iemR3TbProfileSave(pVM, pszTbProfileFile);
+    MMR3HeapFree(pszTbProfileFile);
+    iemR3TbProfileFree(pVM);
+#endif
+#if defined(VBOX_WITH_IEM_RECOMPILER) && !defined(VBOX_VMM_TARGET_ARMV8)
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+    {
+        PIEMTBCACHE const pTbCache = IRECM(pVM->apCpusR3[idCpu]).pTbCacheR3;
+        if (pTbCache && pTbCache->pChainProf)
+        {
+            RTMemFree(pTbCache->pChainProf);
+            pTbCache->pChainProf = NULL;
+        }
+    }
+#endif
+#ifdef VBOX_WITH_IEM_NATIVE_RECOMPILER
+    PIEMTBHINTS const pHints = pVM->cCpus && IRECM(pVM->apCpusR3[0]).pTbCacheR3
+                             ? IRECM(pVM->apCpusR3[0]).pTbCacheR3->pHints : NULL;
+    if (pHints)
+    {
+        for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+            if (IRECM(pVM->apCpusR3[idCpu]).pTbCacheR3)
+                IRECM(pVM->apCpusR3[idCpu]).pTbCacheR3->pHints = NULL;
+        RTMemPageFree(pHints, RT_UOFFSETOF_DYN(IEMTBHINTS, au64Keys[pHints->uHashMask + 1]));
+    }
 #endif
     return VINF_SUCCESS;
 }
@@ -2552,6 +2882,123 @@ static DECLCALLBACK(void) iemR3InfoTbTop(PVM pVM, PCDBGFINFOHLP pHlp, int cArgs,
     }
 }
 
+
+
+/** @callback_method_impl{FNRTSORTCMP, Orders IEMTBCHAINEDGE by descending transition count.} */
+static DECLCALLBACK(int) iemR3TbChainEdgeCmp(void const *pvElement1, void const *pvElement2, void *pvUser)
+{
+    IEMTBCHAINEDGE const * const pEdge1 = (IEMTBCHAINEDGE const *)pvElement1;
+    IEMTBCHAINEDGE const * const pEdge2 = (IEMTBCHAINEDGE const *)pvElement2;
+    RT_NOREF(pvUser);
+    if (pEdge1->cTransitions != pEdge2->cTransitions)
+        return pEdge1->cTransitions > pEdge2->cTransitions ? -1 : 1;
+    return 0;
+}
+
+
+/**
+ * @callback_method_impl{FNDBGFINFOARGVINT, tbchains}
+ */
+static DECLCALLBACK(void) iemR3InfoTbChains(PVM pVM, PCDBGFINFOHLP pHlp, int cArgs, char **papszArgs)
+{
+    /*
+     * Parse arguments.
+     */
+    static RTGETOPTDEF const s_aOptions[] =
+    {
+        { "--cpu",                  'c', RTGETOPT_REQ_UINT32   },
+        { "--vcpu",                 'c', RTGETOPT_REQ_UINT32   },
+        { "--count",                'n', RTGETOPT_REQ_UINT32   },
+    };
+
+    RTGETOPTSTATE State;
+    int rc = RTGetOptInit(&State, cArgs, papszArgs, s_aOptions, RT_ELEMENTS(s_aOptions), 0 /*iFirst*/, 0 /*fFlags*/);
+    AssertRCReturnVoid(rc);
+
+    PVMCPU const    pVCpuThis    = VMMGetCpu(pVM);
+    PVMCPU          pVCpu        = pVCpuThis ? pVCpuThis : VMMGetCpuById(pVM, 0);
+    uint32_t const  cTopDefault  = 32;
+    uint32_t        cTop         = cTopDefault;
+
+    RTGETOPTUNION ValueUnion;
+    while ((rc = RTGetOpt(&State, &ValueUnion)) != 0)
+    {
+        switch (rc)
+        {
+            case 'c':
+                if (ValueUnion.u32 >= pVM->cCpus)
+                    pHlp->pfnPrintf(pHlp, "error: Invalid CPU ID: %u\n", ValueUnion.u32);
+                else if (!pVCpu || pVCpu->idCpu != ValueUnion.u32)
+                    pVCpu = VMMGetCpuById(pVM, ValueUnion.u32);
+                break;
+
+            case VINF_GETOPT_NOT_OPTION:
+                rc = RTStrToUInt32Full(ValueUnion.psz, 0, &cTop);
+                if (RT_FAILURE(rc))
+                {
+                    pHlp->pfnPrintf(pHlp, "error: failed to convert '%s' to a number: %Rrc\n", ValueUnion.psz, rc);
+                    return;
+                }
+                ValueUnion.u32 = cTop;
+                RT_FALL_THROUGH();
+            case 'n':
+                cTop = ValueUnion.u32 ? RT_MIN(ValueUnion.u32, IEMTBCHAINPROF_EDGES) : cTopDefault;
+                break;
+
+            case 'h':
+                pHlp->pfnPrintf(pHlp,
+                                "Usage: info tbchains [options]\n"
+                                "\n"
+                                "Options:\n"
+                                "  -c<n>, --cpu=<n>, --vcpu=<n>\n"
+                                "    Selects the CPU which TBs we're looking at. Default: Caller / 0\n"
+                                "  -n<num>, --count=<num>\n"
+                                "    The number of transitions to display. Default: %u\n"
+                                "    This is also what non-option arguments will be taken as.\n"
+                                , cTopDefault);
+                return;
+
+            default:
+                pHlp->pfnGetOptError(pHlp, rc, &ValueUnion, &State);
+                return;
+        }
+    }
+
+    /* Currently, only do work on the same EMT. */
+    if (pVCpu != pVCpuThis)
+    {
+        pHlp->pfnPrintf(pHlp, "TODO: Cross EMT calling not supported yet: targeting %u, caller on %d\n",
+                        pVCpu->idCpu, pVCpuThis ? (int)pVCpuThis->idCpu : -1);
+        return;
+    }
+
+    PCIEMTBCHAINPROF const pChainProf = IRECM(pVCpu).pTbCacheR3 ? IRECM(pVCpu).pTbCacheR3->pChainProf : NULL;
+    if (!pChainProf)
+    {
+        pHlp->pfnPrintf(pHlp, "TB chain profiling is not enabled (/IEM/TbChainProfiling).\n");
+        return;
+    }
+
+    /*
+     * Sort a copy of the edges and display the top ones.
+     */
+    PIEMTBCHAINEDGE const paEdges = (PIEMTBCHAINEDGE)RTMemDup(pChainProf->aEdges, sizeof(pChainProf->aEdges));
+    AssertReturnVoid(paEdges);
+    RTSortShell(paEdges, IEMTBCHAINPROF_EDGES, sizeof(paEdges[0]), iemR3TbChainEdgeCmp, NULL);
+
+    pHlp->pfnPrintf(pHlp, "Top %u TB-to-TB transitions for CPU #%u (%RU64 recorded, hot at %u):\n",
+                    cTop, pVCpu->idCpu, pChainProf->StatTransitions.c, IEMTBCHAINPROF_HOT_COUNT);
+    for (uint32_t idx = 0; idx < cTop && paEdges[idx].cTransitions > 0; idx++)
+    {
+        PCIEMTBCHAINEDGE const pEdge = &paEdges[idx];
+        bool const fStale =    pEdge->pFrom->GCPhysPc != pEdge->GCPhysFrom
+                            || pEdge->pTo->GCPhysPc   != pEdge->GCPhysTo;
+        pHlp->pfnPrintf(pHlp, "%4u: %RGp -> %RGp  %10u%s%s\n", idx, pEdge->GCPhysFrom, pEdge->GCPhysTo, pEdge->cTransitions,
+                        pEdge->cTransitions >= IEMTBCHAINPROF_HOT_COUNT ? " hot" : "", fStale ? " (stale)" : "");
+    }
+    RTMemFree(paEdges);
+}
+
 #endif /* VBOX_WITH_IEM_RECOMPILER && !VBOX_VMM_TARGET_ARMV8 */
 
 
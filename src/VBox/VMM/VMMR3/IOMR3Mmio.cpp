@@ -33,6 +33,7 @@
 #include <VBox/vmm/iom.h>
 #include <VBox/sup.h>
 #include <VBox/vmm/mm.h>
+#include <VBox/vmm/nem.h>
 #include <VBox/vmm/stam.h>
 #include <VBox/vmm/dbgf.h>
 #include <VBox/vmm/pdmapi.h>
@@ -364,6 +365,77 @@ VMMR3_INT_DECL(int)  IOMR3MmioCreate(PVM pVM, PPDMDEVINS pDevIns, RTGCPHYS cbReg
 }
 
 
+/**
+ * @callback_method_impl{FNNEMR3DOORBELL, Forwards to the device callback.}
+ */
+static DECLCALLBACK(void) iomR3MmioDoorbellNotify(PVM pVM, void *pvUser)
+{
+    PIOMMMIODOORBELL const pDoorbell = (PIOMMMIODOORBELL)pvUser;
+    RT_NOREF(pVM);
+    pDoorbell->pfnNotify(pDoorbell->pDevIns, pDoorbell->pvUser);
+}
+
+
+/**
+ * Hands a doorbell to NEM for the current mapping of its region.
+ *
+ * Failures are not fatal, the doorbell writes will just be regular MMIO writes.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pDoorbell   The doorbell.
+ * @param   GCPhys      The current mapping address of the region.
+ */
+static void iomR3MmioDoorbellArm(PVM pVM, PIOMMMIODOORBELL pDoorbell, RTGCPHYS GCPhys)
+{
+    Assert(pDoorbell->hNemDoorbell == NEM_DOORBELL_HANDLE_NIL);
+    AssertCompile(IOMMMIO_DOORBELL_F_DATAMATCH == NEM_DOORBELL_F_DATAMATCH);
+    int rc = NEMR3DoorbellRegister(pVM, pDoorbell->fFlags & IOMMMIO_DOORBELL_F_DATAMATCH, GCPhys + pDoorbell->off,
+                                   pDoorbell->cb, pDoorbell->uDataMatch, iomR3MmioDoorbellNotify, pDoorbell,
+                                   &pDoorbell->hNemDoorbell);
+    if (RT_FAILURE(rc) && rc != VERR_NOT_SUPPORTED)
+        LogRel(("IOM: Failed to register MMIO doorbell at %RGp LB %u (%s[#%u]): %Rrc\n", GCPhys + pDoorbell->off,
+                pDoorbell->cb, pDoorbell->pDevIns->pReg->szName, pDoorbell->pDevIns->iInstance, rc));
+}
+
+
+/**
+ * Takes a doorbell back from NEM, if it has it.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pDoorbell   The doorbell.
+ */
+static void iomR3MmioDoorbellDisarm(PVM pVM, PIOMMMIODOORBELL pDoorbell)
+{
+    if (pDoorbell->hNemDoorbell != NEM_DOORBELL_HANDLE_NIL)
+    {
+        int rc = NEMR3DoorbellDeregister(pVM, pDoorbell->hNemDoorbell);
+        AssertLogRelRC(rc);
+        pDoorbell->hNemDoorbell = NEM_DOORBELL_HANDLE_NIL;
+    }
+}
+
+
+/**
+ * Worker for IOMR3MmioMap and IOMR3MmioUnmap that arms or disarms the
+ * doorbells of a region.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   hRegion     The region being mapped or unmapped.
+ * @param   GCPhys      The new mapping address, NIL_RTGCPHYS when unmapping.
+ */
+static void iomR3MmioDoorbellsUpdate(PVM pVM, IOMMMIOHANDLE hRegion, RTGCPHYS GCPhys)
+{
+    for (PIOMMMIODOORBELL pDoorbell = pVM->iom.s.pMmioDoorbellsR3; pDoorbell; pDoorbell = pDoorbell->pNext)
+        if (pDoorbell->hRegion == hRegion)
+        {
+            if (GCPhys != NIL_RTGCPHYS)
+                iomR3MmioDoorbellArm(pVM, pDoorbell, GCPhys);
+            else
+                iomR3MmioDoorbellDisarm(pVM, pDoorbell);
+        }
+}
+
+
 /**
  * Worker for PDMDEVHLPR3::pfnMmioMap.
  */
@@ -483,6 +555,11 @@ VMMR3_INT_DECL(int)  IOMR3MmioMap(PVM pVM, PVMCPU pVCpu, PPDMDEVINS pDevIns, IOM
         pEntry->GCPhysLast  = GCPhysLast;
         pVM->iom.s.cMmioLookupEntries = cEntries + 1;
 
+        if (pVM->iom.s.pMmioDoorbellsR3)
+            iomR3MmioDoorbellsUpdate(pVM, hRegion, GCPhys);
+        if (pRegEntry->fFlags & IOMMMIO_FLAGS_COALESCE_WRITES)
+            pRegEntry->fCoalesced = RT_SUCCESS(NEMR3MmioCoalesceRegister(pVM, GCPhys, cbRegion));
+
 #ifdef VBOX_WITH_STATISTICS
         /* Don't register stats here when we're creating the VM as the
            statistics table may still be reallocated. */
@@ -578,6 +655,15 @@ VMMR3_INT_DECL(int) IOMR3MmioUnmap(PVM pVM, PVMCPU pVCpu, PPDMDEVINS pDevIns, IO
             {
                 Assert(pEntry->GCPhysFirst == GCPhys);
                 Assert(pEntry->GCPhysLast == GCPhysLast);
+                if (pVM->iom.s.pMmioDoorbellsR3)
+                    iomR3MmioDoorbellsUpdate(pVM, hRegion, NIL_RTGCPHYS);
+                if (pRegEntry->fCoalesced)
+                {
+                    /* Replays what is still buffered, so must be done before PGM forgets the range. */
+                    int rc2 = NEMR3MmioCoalesceDeregister(pVM, GCPhys, pRegEntry->cbRegion);
+                    AssertLogRelRC(rc2);
+                    pRegEntry->fCoalesced = false;
+                }
 #ifdef VBOX_WITH_STATISTICS
                 iomR3MmioDeregStats(pVM, pRegEntry, GCPhys);
 #endif
@@ -677,6 +763,137 @@ VMMR3_INT_DECL(RTGCPHYS) IOMR3MmioGetMappingAddress(PVM pVM, PPDMDEVINS pDevIns,
 }
 
 
+/**
+ * Registers a doorbell within a MMIO region.
+ *
+ * A doorbell is a write-only register whose written value carries no
+ * information the device needs (or a fixed one, see
+ * IOMMMIO_DOORBELL_F_DATAMATCH).  When the execution engine supports it (KVM
+ * ioeventfd), guest writes to it are signalled to @a pfnNotify without the EMT
+ * taking an MMIO exit to ring-3 and the regular write callback is bypassed.
+ * Otherwise nothing changes and the writes go to the write callback as usual,
+ * so the device must handle both.
+ *
+ * The registration is kept across mapping changes of the region.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NOT_SUPPORTED if the execution engine has no such facility.
+ * @param   pVM         The cross context VM structure.
+ * @param   pDevIns     The device which owns @a hRegion.
+ * @param   hRegion     The MMIO region handle.
+ * @param   off         The offset of the doorbell into the region.
+ * @param   cb          The access size of the doorbell: 1, 2, 4 or 8.
+ * @param   fFlags      IOMMMIO_DOORBELL_F_XXX.
+ * @param   uDataMatch  The value to match with IOMMMIO_DOORBELL_F_DATAMATCH.
+ * @param   pfnNotify   The notification callback.
+ * @param   pvUser      User argument for the callback.
+ * @thread  EMT(0)
+ */
+VMMR3_INT_DECL(int) IOMR3MmioDoorbellRegister(PVM pVM, PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off, uint32_t cb,
+                                              uint32_t fFlags, uint64_t uDataMatch, PFNIOMMMIODOORBELL pfnNotify, void *pvUser)
+{
+    /*
+     * Validate input.
+     */
+    VM_ASSERT_EMT0_RETURN(pVM, VERR_VM_THREAD_NOT_EMT);
+    AssertPtrReturn(pDevIns, VERR_INVALID_HANDLE);
+    AssertReturn(hRegion < RT_MIN(pVM->iom.s.cMmioRegs, pVM->iom.s.cMmioAlloc), VERR_IOM_INVALID_MMIO_HANDLE);
+    PIOMMMIOENTRYR3 const pRegEntry = &pVM->iom.s.paMmioRegs[hRegion];
+    AssertReturn(pRegEntry->pDevIns == pDevIns, VERR_IOM_INVALID_MMIO_HANDLE);
+    AssertReturn(cb == 1 || cb == 2 || cb == 4 || cb == 8, VERR_INVALID_PARAMETER);
+    AssertReturn(off < pRegEntry->cbRegion && pRegEntry->cbRegion - off >= cb, VERR_OUT_OF_RANGE);
+    AssertReturn(!(off & (cb - 1)), VERR_INVALID_PARAMETER);
+    AssertReturn(!(fFlags & ~IOMMMIO_DOORBELL_F_VALID_MASK), VERR_INVALID_FLAGS);
+    AssertPtrReturn(pfnNotify, VERR_INVALID_POINTER);
+
+    /* Don't bother keeping track of them when no one can make use of them. */
+    if (!VM_IS_NEM_ENABLED(pVM))
+        return VERR_NOT_SUPPORTED;
+
+    PIOMMMIODOORBELL pDoorbell = (PIOMMMIODOORBELL)MMR3HeapAllocZ(pVM, MM_TAG_IOM, sizeof(*pDoorbell));
+    AssertReturn(pDoorbell, VERR_NO_MEMORY);
+    pDoorbell->pDevIns      = pDevIns;
+    pDoorbell->hRegion      = hRegion;
+    pDoorbell->off          = off;
+    pDoorbell->cb           = cb;
+    pDoorbell->fFlags       = fFlags;
+    pDoorbell->uDataMatch   = uDataMatch;
+    pDoorbell->hNemDoorbell = NEM_DOORBELL_HANDLE_NIL;
+    pDoorbell->pfnNotify    = pfnNotify;
+    pDoorbell->pvUser       = pvUser;
+
+    IOM_LOCK_EXCL(pVM);
+    pDoorbell->pNext = pVM->iom.s.pMmioDoorbellsR3;
+    pVM->iom.s.pMmioDoorbellsR3 = pDoorbell;
+    if (pRegEntry->fMapped)
+        iomR3MmioDoorbellArm(pVM, pDoorbell, pRegEntry->GCPhysMapping);
+    IOM_UNLOCK_EXCL(pVM);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Deregisters a doorbell registered by IOMR3MmioDoorbellRegister.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pDevIns     The device which owns @a hRegion.
+ * @param   hRegion     The MMIO region handle.
+ * @param   off         The offset of the doorbell into the region.
+ */
+VMMR3_INT_DECL(int) IOMR3MmioDoorbellDeregister(PVM pVM, PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off)
+{
+    AssertPtrReturn(pDevIns, VERR_INVALID_HANDLE);
+
+    int rc = VERR_NOT_FOUND;
+    IOM_LOCK_EXCL(pVM);
+    PIOMMMIODOORBELL pPrev = NULL;
+    for (PIOMMMIODOORBELL pDoorbell = pVM->iom.s.pMmioDoorbellsR3; pDoorbell; pPrev = pDoorbell, pDoorbell = pDoorbell->pNext)
+        if (   pDoorbell->pDevIns == pDevIns
+            && pDoorbell->hRegion == hRegion
+            && pDoorbell->off     == off)
+        {
+            iomR3MmioDoorbellDisarm(pVM, pDoorbell);
+            if (pPrev)
+                pPrev->pNext = pDoorbell->pNext;
+            else
+                pVM->iom.s.pMmioDoorbellsR3 = pDoorbell->pNext;
+            MMR3HeapFree(pDoorbell);
+            rc = VINF_SUCCESS;
+            break;
+        }
+    IOM_UNLOCK_EXCL(pVM);
+    return rc;
+}
+
+
+/**
+ * Deregisters all the doorbells of a device, called by PDM before the device
+ * is destroyed.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pDevIns     The device instance.
+ */
+VMMR3_INT_DECL(void) IOMR3MmioDoorbellDestroyDevice(PVM pVM, PPDMDEVINS pDevIns)
+{
+    IOM_LOCK_EXCL(pVM);
+    PIOMMMIODOORBELL *ppNext = &pVM->iom.s.pMmioDoorbellsR3;
+    PIOMMMIODOORBELL  pDoorbell;
+    while ((pDoorbell = *ppNext) != NULL)
+    {
+        if (pDoorbell->pDevIns == pDevIns)
+        {
+            iomR3MmioDoorbellDisarm(pVM, pDoorbell);
+            *ppNext = pDoorbell->pNext;
+            MMR3HeapFree(pDoorbell);
+        }
+        else
+            ppNext = &pDoorbell->pNext;
+    }
+    IOM_UNLOCK_EXCL(pVM);
+}
+
+
 /**
  * Display all registered MMIO ranges.
  *
@@ -98,6 +98,10 @@ VMMR3_INT_DECL(int) NEMR3InitConfig(PVM pVM)
                                   "|LovelyMesaDrvWorkaround"
 #ifdef RT_OS_WINDOWS
                                   "|UseRing0Runloop"
+#elif defined(RT_OS_LINUX)
+                                  "|IoEventFd"
+                                  "|CoalescedMmio"
+                                  "|ExitHistograms"
 #elif defined(RT_OS_DARWIN)
                                   "|VmxPleGap"
                                   "|VmxPleWindow"
@@ -144,6 +148,28 @@ VMMR3_INT_DECL(int) NEMR3InitConfig(PVM pVM)
         pVCpu->nem.s.fTrapXcptGpForLovelyMesaDrv = f;
     }
 
+#ifdef RT_OS_LINUX
+    /** @cfgm{/NEM/IoEventFd, bool, false}
+     * Whether to let devices register doorbells (virtio queue notifications and
+     * the like) with KVM_IOEVENTFD, so the guest writes are signalled to a worker
+     * thread without exiting to ring-3 on the EMT. */
+    rc = CFGMR3QueryBoolDef(pCfgNem, "IoEventFd", &pVM->nem.s.fUseIoEventFd, false);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/NEM/CoalescedMmio, bool, true}
+     * Whether to let KVM buffer writes to MMIO regions created with
+     * IOMMMIO_FLAGS_COALESCE_WRITES (VGA legacy window and such) in the coalesced
+     * MMIO ring, so they can be replayed in batches instead of one exit each. */
+    rc = CFGMR3QueryBoolDef(pCfgNem, "CoalescedMmio", &pVM->nem.s.fUseCoalescedMmio, true);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/NEM/ExitHistograms, bool, false}
+     * Whether to sample per exit reason latency histograms of the ring-3 exit
+     * handling (/NEM/CPUn/Exit/Latency/). */
+    rc = CFGMR3QueryBoolDef(pCfgNem, "ExitHistograms", &pVM->nem.s.fExitHistograms, false);
+    AssertLogRelRCReturn(rc, rc);
+#endif
+
 #if defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)
     /** @cfgm{/NEM/IBPBOnVMExit, bool}
      * Costly paranoia setting. */
@@ -551,6 +577,168 @@ VMMR3_INT_DECL(void) NEMR3NotifyFF(PVM pVM, PVMCPU pVCpu, uint32_t fFlags)
 #endif
 }
 
+
+/**
+ * Registers a doorbell that the hypervisor can signal without exiting to
+ * ring-3 on the EMT.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NOT_SUPPORTED if the backend has no such facility or it is
+ *          disabled.  The caller shall just continue to rely on regular MMIO or
+ *          I/O port exits.
+ * @param   pVM             The cross context VM structure.
+ * @param   fFlags          NEM_DOORBELL_F_XXX.
+ * @param   GCPhysOrPort    The guest physical address or the I/O port
+ *                          (NEM_DOORBELL_F_PIO) of the doorbell.
+ * @param   cb              The access size: 1, 2, 4 or 8 bytes.
+ * @param   uDataMatch      The value to match if NEM_DOORBELL_F_DATAMATCH is
+ *                          given, otherwise ignored.
+ * @param   pfnNotify       The callback to invoke.
+ * @param   pvUser          User argument for the callback.
+ * @param   phDoorbell      Where to return the doorbell handle.
+ */
+VMMR3_INT_DECL(int) NEMR3DoorbellRegister(PVM pVM, uint32_t fFlags, RTGCPHYS GCPhysOrPort, uint32_t cb, uint64_t uDataMatch,
+                                          PFNNEMR3DOORBELL pfnNotify, void *pvUser, uint32_t *phDoorbell)
+{
+    AssertPtrReturn(phDoorbell, VERR_INVALID_POINTER);
+    *phDoorbell = NEM_DOORBELL_HANDLE_NIL;
+    AssertPtrReturn(pfnNotify, VERR_INVALID_POINTER);
+    AssertReturn(!(fFlags & ~NEM_DOORBELL_F_VALID_MASK), VERR_INVALID_FLAGS);
+    AssertReturn(cb == 1 || cb == 2 || cb == 4 || cb == 8, VERR_INVALID_PARAMETER);
+    AssertReturn(!(fFlags & NEM_DOORBELL_F_PIO) || GCPhysOrPort <= UINT16_MAX, VERR_OUT_OF_RANGE);
+#if defined(VBOX_WITH_NATIVE_NEM) && defined(RT_OS_LINUX)
+    if (VM_IS_NEM_ENABLED(pVM))
+        return nemR3NativeDoorbellRegister(pVM, fFlags, GCPhysOrPort, cb, uDataMatch, pfnNotify, pvUser, phDoorbell);
+#else
+    RT_NOREF(pVM, uDataMatch, pvUser);
+#endif
+    return VERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * Deregisters a doorbell registered by NEMR3DoorbellRegister.
+ *
+ * When this returns the callback is no longer executing and will not be called
+ * again.
+ *
+ * @returns VBox status code.
+ * @param   pVM             The cross context VM structure.
+ * @param   hDoorbell       The doorbell handle.  NIL is quietly ignored.
+ */
+VMMR3_INT_DECL(int) NEMR3DoorbellDeregister(PVM pVM, uint32_t hDoorbell)
+{
+    if (hDoorbell == NEM_DOORBELL_HANDLE_NIL)
+        return VINF_SUCCESS;
+#if defined(VBOX_WITH_NATIVE_NEM) && defined(RT_OS_LINUX)
+    if (VM_IS_NEM_ENABLED(pVM))
+        return nemR3NativeDoorbellDeregister(pVM, hDoorbell);
+#else
+    RT_NOREF(pVM);
+#endif
+    return VERR_INVALID_HANDLE;
+}
+
+
+/**
+ * Tells the backend that writes to the given MMIO range may be buffered and
+ * replayed later in batches, see IOMMMIO_FLAGS_COALESCE_WRITES.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NOT_SUPPORTED if the backend has no such facility or it is
+ *          disabled.
+ * @param   pVM             The cross context VM structure.
+ * @param   GCPhys          The start of the range.
+ * @param   cb              The size of the range.
+ */
+VMMR3_INT_DECL(int) NEMR3MmioCoalesceRegister(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb)
+{
+#if defined(VBOX_WITH_NATIVE_NEM) && defined(RT_OS_LINUX)
+    if (VM_IS_NEM_ENABLED(pVM))
+        return nemR3NativeMmioCoalesceRegister(pVM, GCPhys, cb);
+#else
+    RT_NOREF(pVM, GCPhys, cb);
+#endif
+    return VERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * Undoes a successful NEMR3MmioCoalesceRegister call.
+ *
+ * Any writes still buffered for the range are replayed before the backend
+ * stops buffering them.
+ *
+ * @returns VBox status code.
+ * @param   pVM             The cross context VM structure.
+ * @param   GCPhys          The start of the range.
+ * @param   cb              The size of the range.
+ * @thread  EMT
+ */
+VMMR3_INT_DECL(int) NEMR3MmioCoalesceDeregister(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb)
+{
+#if defined(VBOX_WITH_NATIVE_NEM) && defined(RT_OS_LINUX)
+    if (VM_IS_NEM_ENABLED(pVM))
+        return nemR3NativeMmioCoalesceDeregister(pVM, GCPhys, cb);
+#else
+    RT_NOREF(pVM, GCPhys, cb);
+#endif
+    return VERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * Enables or disables dirty page logging for a RAM range.
+ *
+ * This is used by the PGM live save code to get hold of the pages the guest
+ * has written to without write protecting each page.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NOT_SUPPORTED if the backend doesn't support it.
+ * @param   pVM             The cross context VM structure.
+ * @param   GCPhys          The start of the RAM range.
+ * @param   cb              The size of the RAM range.
+ * @param   pvR3            The ring-3 mapping of the RAM range.
+ * @param   uNemRange       The NEM internal range number.
+ * @param   fEnable         Whether to enable or disable the logging.
+ */
+VMMR3_INT_DECL(int) NEMR3PhysRamDirtyTracking(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb, void *pvR3, uint32_t uNemRange, bool fEnable)
+{
+#if defined(VBOX_WITH_NATIVE_NEM) && defined(RT_OS_LINUX)
+    if (VM_IS_NEM_ENABLED(pVM) && uNemRange != UINT32_MAX)
+        return nemR3NativePhysRamDirtyTracking(pVM, GCPhys, cb, pvR3, uNemRange, fEnable);
+#else
+    RT_NOREF(pVM, GCPhys, cb, pvR3, uNemRange, fEnable);
+#endif
+    return VERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * Queries and resets the dirty page bitmap of a RAM range that has dirty
+ * page logging enabled by NEMR3PhysRamDirtyTracking.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   GCPhys      The start of the RAM range.
+ * @param   cb          The size of the RAM range.
+ * @param   uNemRange   The NEM internal range number.
+ * @param   pvBitmap    The output bitmap.  Must be 8-byte aligned.
+ * @param   cbBitmap    The size of the bitmap.  Must be the size of the whole
+ *                      RAM range, rounded up to the nearest 8 bytes.
+ */
+VMMR3_INT_DECL(int) NEMR3PhysRamQueryAndResetDirtyBitmap(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb, uint32_t uNemRange,
+                                                         void *pvBitmap, size_t cbBitmap)
+{
+#if defined(VBOX_WITH_NATIVE_NEM) && defined(RT_OS_LINUX)
+    if (VM_IS_NEM_ENABLED(pVM))
+        return nemR3NativePhysRamQueryAndResetDirtyBitmap(pVM, GCPhys, cb, uNemRange, pvBitmap, cbBitmap);
+#else
+    RT_NOREF(pVM, GCPhys, cb, uNemRange, pvBitmap, cbBitmap);
+#endif
+    return VERR_NOT_SUPPORTED;
+}
+
 #ifndef VBOX_WITH_NATIVE_NEM
 
 VMMR3_INT_DECL(void) NEMR3NotifySetA20(PVMCPU pVCpu, bool fEnabled)
@@ -83,7 +83,7 @@ static int nemR3LnxInitCheckCapabilities(PVM pVM, PRTERRINFO pErrInfo)
         CAP_ENTRY__L(KVM_CAP_NOP_IO_DELAY),
         CAP_ENTRY__L(KVM_CAP_PV_MMU),
         CAP_ENTRY__L(KVM_CAP_MP_STATE),
-        CAP_ENTRY__L(KVM_CAP_COALESCED_MMIO),
+        CAP_ENTRY__S(KVM_CAP_COALESCED_MMIO, uCoalescedMmioPageOff),
         CAP_ENTRY__L(KVM_CAP_SYNC_MMU),
         CAP_ENTRY__U(17),
         CAP_ENTRY__L(KVM_CAP_IOMMU),
@@ -114,7 +114,7 @@ static int nemR3LnxInitCheckCapabilities(PVM pVM, PRTERRINFO pErrInfo)
 #ifdef __KVM_HAVE_PIT_STATE2
         CAP_ENTRY__L(KVM_CAP_PIT_STATE2),
 #endif
-        CAP_ENTRY__L(KVM_CAP_IOEVENTFD),
+        CAP_ENTRY__S(KVM_CAP_IOEVENTFD, fIoEventFd),
         CAP_ENTRY__L(KVM_CAP_SET_IDENTITY_MAP_ADDR),
 #ifdef __KVM_HAVE_XEN_HVM
         CAP_ENTRY__L(KVM_CAP_XEN_HVM),
@@ -440,6 +440,485 @@ static DECLCALLBACK(VBOXSTRICTRC) nemR3LnxFixThreadPoke(PVM pVM, PVMCPU pVCpu, v
 }
 
 
+/*********************************************************************************************************************************
+*   Doorbells (KVM_IOEVENTFD)                                                                                                    *
+*********************************************************************************************************************************/
+
+/** Maximum number of doorbells we support. */
+#define NEM_LNX_MAX_DOORBELLS       256
+/** The epoll data value used for the dispatcher wakeup eventfd. */
+#define NEM_LNX_DOORBELL_WAKEUP     UINT32_MAX
+
+/**
+ * A doorbell entry.
+ */
+typedef struct NEMLNXDOORBELL
+{
+    /** The eventfd, -1 if the entry is free. */
+    int32_t                     fdEvent;
+    /** NEM_DOORBELL_F_XXX. */
+    uint32_t                    fFlags;
+    /** The guest physical address or I/O port. */
+    RTGCPHYS                    GCPhysOrPort;
+    /** The data to match (NEM_DOORBELL_F_DATAMATCH). */
+    uint64_t                    uDataMatch;
+    /** The access size. */
+    uint32_t                    cb;
+    /** Set while the dispatcher is calling pfnNotify. */
+    bool volatile               fBusy;
+    /** The callback, NULL when the entry is being deregistered. */
+    PFNNEMR3DOORBELL            pfnNotify;
+    /** User argument for the callback. */
+    void                       *pvUser;
+} NEMLNXDOORBELL;
+/** Pointer to a doorbell entry. */
+typedef NEMLNXDOORBELL *PNEMLNXDOORBELL;
+
+/**
+ * The doorbell dispatcher state.
+ */
+typedef struct NEMLNXDOORBELLS
+{
+    /** The epoll file descriptor the dispatcher waits on. */
+    int32_t                     fdEpoll;
+    /** The eventfd used to wake up the dispatcher on termination. */
+    int32_t                     fdWakeup;
+    /** Set when the dispatcher should terminate. */
+    bool volatile               fShutdown;
+    /** The dispatcher thread. */
+    RTTHREAD                    hThread;
+    /** Protects the entries. */
+    RTCRITSECT                  CritSect;
+    /** Number of doorbell notifications dispatched. */
+    STAMCOUNTER                 StatNotifications;
+    /** Number of doorbells currently registered. */
+    uint32_t                    cRegistered;
+    /** The doorbell entries, indexed by handle. */
+    NEMLNXDOORBELL              aEntries[NEM_LNX_MAX_DOORBELLS];
+} NEMLNXDOORBELLS;
+/** Pointer to the doorbell dispatcher state. */
+typedef NEMLNXDOORBELLS *PNEMLNXDOORBELLS;
+
+
+/**
+ * Issues KVM_IOEVENTFD for the given doorbell entry.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pEntry      The doorbell entry.
+ * @param   fDeassign   Whether to deassign (true) or assign (false) it.
+ */
+static int nemR3LnxDoorbellIoctl(PVM pVM, PNEMLNXDOORBELL pEntry, bool fDeassign)
+{
+    struct kvm_ioeventfd IoEventFd;
+    RT_ZERO(IoEventFd);
+    IoEventFd.datamatch = pEntry->uDataMatch;
+    IoEventFd.addr      = pEntry->GCPhysOrPort;
+    IoEventFd.len       = pEntry->cb;
+    IoEventFd.fd        = pEntry->fdEvent;
+    IoEventFd.flags     = (pEntry->fFlags & NEM_DOORBELL_F_DATAMATCH ? KVM_IOEVENTFD_FLAG_DATAMATCH : 0)
+                        | (pEntry->fFlags & NEM_DOORBELL_F_PIO       ? KVM_IOEVENTFD_FLAG_PIO       : 0)
+                        | (fDeassign                                 ? KVM_IOEVENTFD_FLAG_DEASSIGN  : 0);
+    int rcLnx = ioctl(pVM->nem.s.fdVm, KVM_IOEVENTFD, &IoEventFd);
+    if (rcLnx == 0)
+        return VINF_SUCCESS;
+    LogRel(("NEM: KVM_IOEVENTFD(%s %RGp LB %u) failed: %d\n",
+            fDeassign ? "deassign" : "assign", pEntry->GCPhysOrPort, pEntry->cb, errno));
+    return RTErrConvertFromErrno(errno);
+}
+
+
+/**
+ * @callback_method_impl{FNRTTHREAD, The doorbell dispatcher.}
+ */
+static DECLCALLBACK(int) nemR3LnxDoorbellThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    PVM const              pVM        = (PVM)pvUser;
+    PNEMLNXDOORBELLS const pDoorbells = pVM->nem.s.pDoorbells;
+    RT_NOREF(hThreadSelf);
+
+    while (!ASMAtomicReadBool(&pDoorbells->fShutdown))
+    {
+        struct epoll_event aEvents[16];
+        int cEvents = epoll_wait(pDoorbells->fdEpoll, aEvents, RT_ELEMENTS(aEvents), -1 /*infinite*/);
+        if (cEvents < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            LogRel(("NEM: Doorbell dispatcher: epoll_wait failed: %d\n", errno));
+            return RTErrConvertFromErrno(errno);
+        }
+
+        for (int i = 0; i < cEvents; i++)
+        {
+            uint32_t const idx = aEvents[i].data.u32;
+            if (idx < RT_ELEMENTS(pDoorbells->aEntries))
+            {
+                PNEMLNXDOORBELL const pEntry = &pDoorbells->aEntries[idx];
+
+                RTCritSectEnter(&pDoorbells->CritSect);
+                PFNNEMR3DOORBELL const pfnNotify = pEntry->pfnNotify;
+                void * const           pvNotify  = pEntry->pvUser;
+                if (pfnNotify)
+                {
+                    /* Reset the counter; several writes collapse into one notification. */
+                    uint64_t cSignals = 0;
+                    ssize_t cbRead = read(pEntry->fdEvent, &cSignals, sizeof(cSignals));
+                    RT_NOREF(cbRead);
+                    ASMAtomicWriteBool(&pEntry->fBusy, true);
+                }
+                RTCritSectLeave(&pDoorbells->CritSect);
+
+                if (pfnNotify)
+                {
+                    STAM_REL_COUNTER_INC(&pDoorbells->StatNotifications);
+                    pfnNotify(pVM, pvNotify);
+                    ASMAtomicWriteBool(&pEntry->fBusy, false);
+                }
+            }
+            else
+                Assert(idx == NEM_LNX_DOORBELL_WAKEUP);
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Sets up the doorbell dispatcher.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ */
+static int nemR3LnxDoorbellsInit(PVM pVM)
+{
+    PNEMLNXDOORBELLS pDoorbells = (PNEMLNXDOORBELLS)RTMemAllocZ(sizeof(*pDoorbells));
+    AssertReturn(pDoorbells, VERR_NO_MEMORY);
+    pDoorbells->hThread  = NIL_RTTHREAD;
+    pDoorbells->fdWakeup = -1;
+    for (unsigned i = 0; i < RT_ELEMENTS(pDoorbells->aEntries); i++)
+        pDoorbells->aEntries[i].fdEvent = -1;
+
+    int rc;
+    pDoorbells->fdEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (pDoorbells->fdEpoll >= 0)
+    {
+        pDoorbells->fdWakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (pDoorbells->fdWakeup >= 0)
+        {
+            struct epoll_event Event;
+            RT_ZERO(Event);
+            Event.events   = EPOLLIN;
+            Event.data.u32 = NEM_LNX_DOORBELL_WAKEUP;
+            if (epoll_ctl(pDoorbells->fdEpoll, EPOLL_CTL_ADD, pDoorbells->fdWakeup, &Event) == 0)
+            {
+                rc = RTCritSectInit(&pDoorbells->CritSect);
+                if (RT_SUCCESS(rc))
+                {
+                    pVM->nem.s.pDoorbells = pDoorbells;
+                    rc = RTThreadCreate(&pDoorbells->hThread, nemR3LnxDoorbellThread, pVM, 0 /*cbStack*/,
+                                        RTTHREADTYPE_IO, RTTHREADFLAGS_WAITABLE, "NemDoorbell");
+                    if (RT_SUCCESS(rc))
+                    {
+                        STAMR3Register(pVM, &pDoorbells->StatNotifications, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS,
+                                       "/NEM/Doorbells/Notifications", STAMUNIT_OCCURENCES,
+                                       "Number of doorbell notifications dispatched (KVM_IOEVENTFD)");
+                        LogRel(("NEM: Using KVM_IOEVENTFD for device doorbells\n"));
+                        return VINF_SUCCESS;
+                    }
+                    pVM->nem.s.pDoorbells = NULL;
+                    RTCritSectDelete(&pDoorbells->CritSect);
+                }
+            }
+            else
+                rc = RTErrConvertFromErrno(errno);
+            close(pDoorbells->fdWakeup);
+        }
+        else
+            rc = RTErrConvertFromErrno(errno);
+        close(pDoorbells->fdEpoll);
+    }
+    else
+        rc = RTErrConvertFromErrno(errno);
+    RTMemFree(pDoorbells);
+    return rc;
+}
+
+
+/**
+ * Tears down the doorbell dispatcher and all remaining doorbells.
+ *
+ * @param   pVM         The cross context VM structure.
+ */
+static void nemR3LnxDoorbellsTerm(PVM pVM)
+{
+    PNEMLNXDOORBELLS const pDoorbells = pVM->nem.s.pDoorbells;
+    if (!pDoorbells)
+        return;
+
+    ASMAtomicWriteBool(&pDoorbells->fShutdown, true);
+    uint64_t const uOne = 1;
+    ssize_t cbWritten = write(pDoorbells->fdWakeup, &uOne, sizeof(uOne));
+    RT_NOREF(cbWritten);
+    int rc = RTThreadWait(pDoorbells->hThread, RT_MS_30SEC, NULL);
+    AssertLogRelRC(rc);
+
+    for (unsigned i = 0; i < RT_ELEMENTS(pDoorbells->aEntries); i++)
+        if (pDoorbells->aEntries[i].fdEvent >= 0)
+        {
+            nemR3LnxDoorbellIoctl(pVM, &pDoorbells->aEntries[i], true /*fDeassign*/);
+            close(pDoorbells->aEntries[i].fdEvent);
+            pDoorbells->aEntries[i].fdEvent = -1;
+        }
+
+    STAMR3DeregisterByAddr(pVM->pUVM, &pDoorbells->StatNotifications);
+    close(pDoorbells->fdWakeup);
+    close(pDoorbells->fdEpoll);
+    RTCritSectDelete(&pDoorbells->CritSect);
+    pVM->nem.s.pDoorbells = NULL;
+    RTMemFree(pDoorbells);
+}
+
+
+DECLHIDDEN(int) nemR3NativeDoorbellRegister(PVM pVM, uint32_t fFlags, RTGCPHYS GCPhysOrPort, uint32_t cb, uint64_t uDataMatch,
+                                            PFNNEMR3DOORBELL pfnNotify, void *pvUser, uint32_t *phDoorbell)
+{
+    PNEMLNXDOORBELLS const pDoorbells = pVM->nem.s.pDoorbells;
+    if (!pDoorbells)
+        return VERR_NOT_SUPPORTED;
+
+    int rc = RTCritSectEnter(&pDoorbells->CritSect);
+    AssertRCReturn(rc, rc);
+
+    /* Find a free entry. */
+    uint32_t idx = 0;
+    while (idx < RT_ELEMENTS(pDoorbells->aEntries) && pDoorbells->aEntries[idx].fdEvent >= 0)
+        idx++;
+    if (idx < RT_ELEMENTS(pDoorbells->aEntries))
+    {
+        PNEMLNXDOORBELL const pEntry = &pDoorbells->aEntries[idx];
+        pEntry->fdEvent = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (pEntry->fdEvent >= 0)
+        {
+            pEntry->fFlags       = fFlags;
+            pEntry->GCPhysOrPort = GCPhysOrPort;
+            pEntry->uDataMatch   = fFlags & NEM_DOORBELL_F_DATAMATCH ? uDataMatch : 0;
+            pEntry->cb           = cb;
+            pEntry->fBusy        = false;
+            pEntry->pfnNotify    = pfnNotify;
+            pEntry->pvUser       = pvUser;
+
+            struct epoll_event Event;
+            RT_ZERO(Event);
+            Event.events   = EPOLLIN;
+            Event.data.u32 = idx;
+            if (epoll_ctl(pDoorbells->fdEpoll, EPOLL_CTL_ADD, pEntry->fdEvent, &Event) == 0)
+            {
+                rc = nemR3LnxDoorbellIoctl(pVM, pEntry, false /*fDeassign*/);
+                if (RT_SUCCESS(rc))
+                {
+                    pDoorbells->cRegistered++;
+                    RTCritSectLeave(&pDoorbells->CritSect);
+                    *phDoorbell = idx;
+                    Log(("nemR3NativeDoorbellRegister: #%u %s %RGp LB %u fFlags=%#x uDataMatch=%#RX64\n", idx,
+                         fFlags & NEM_DOORBELL_F_PIO ? "port" : "mmio", GCPhysOrPort, cb, fFlags, uDataMatch));
+                    return VINF_SUCCESS;
+                }
+                epoll_ctl(pDoorbells->fdEpoll, EPOLL_CTL_DEL, pEntry->fdEvent, NULL);
+            }
+            else
+                rc = RTErrConvertFromErrno(errno);
+            close(pEntry->fdEvent);
+            pEntry->fdEvent   = -1;
+            pEntry->pfnNotify = NULL;
+        }
+        else
+            rc = RTErrConvertFromErrno(errno);
+    }
+    else
+        rc = VERR_OUT_OF_RESOURCES;
+    RTCritSectLeave(&pDoorbells->CritSect);
+    return rc;
+}
+
+
+DECLHIDDEN(int) nemR3NativeDoorbellDeregister(PVM pVM, uint32_t hDoorbell)
+{
+    PNEMLNXDOORBELLS const pDoorbells = pVM->nem.s.pDoorbells;
+    AssertReturn(pDoorbells, VERR_INVALID_HANDLE);
+    AssertReturn(hDoorbell < RT_ELEMENTS(pDoorbells->aEntries), VERR_INVALID_HANDLE);
+    PNEMLNXDOORBELL const pEntry = &pDoorbells->aEntries[hDoorbell];
+
+    int rc = RTCritSectEnter(&pDoorbells->CritSect);
+    AssertRCReturn(rc, rc);
+    if (pEntry->fdEvent < 0 || !pEntry->pfnNotify)
+    {
+        RTCritSectLeave(&pDoorbells->CritSect);
+        AssertFailedReturn(VERR_INVALID_HANDLE);
+    }
+
+    rc = nemR3LnxDoorbellIoctl(pVM, pEntry, true /*fDeassign*/);
+    epoll_ctl(pDoorbells->fdEpoll, EPOLL_CTL_DEL, pEntry->fdEvent, NULL);
+    pEntry->pfnNotify = NULL;
+    pEntry->pvUser    = NULL;
+    RTCritSectLeave(&pDoorbells->CritSect);
+
+    /* Wait for any callback in progress to complete before freeing the entry. */
+    if (RTThreadSelf() != pDoorbells->hThread)
+        while (ASMAtomicReadBool(&pEntry->fBusy))
+            RTThreadSleep(1);
+
+    RTCritSectEnter(&pDoorbells->CritSect);
+    close(pEntry->fdEvent);
+    pEntry->fdEvent = -1;
+    pDoorbells->cRegistered--;
+    RTCritSectLeave(&pDoorbells->CritSect);
+    return rc;
+}
+
+
+/*********************************************************************************************************************************
+*   Coalesced MMIO                                                                                                               *
+*********************************************************************************************************************************/
+
+/**
+ * Sets up the coalesced MMIO ring.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ */
+static int nemR3LnxCoalescedMmioInit(PVM pVM)
+{
+    /* KVM_CHECK_EXTENSION returns the page offset of the ring in the vCPU mapping. */
+    size_t const cbHostPage = RTSystemGetPageSize();
+    size_t const offRing    = (size_t)pVM->nem.s.uCoalescedMmioPageOff * cbHostPage;
+    AssertLogRelMsgReturn(offRing + cbHostPage <= pVM->nem.s.cbVCpuMmap,
+                          ("offRing=%#zx cbVCpuMmap=%#x\n", offRing, pVM->nem.s.cbVCpuMmap), VERR_NEM_IPE_0);
+
+    int rc = RTCritSectInit(&pVM->nem.s.CoalescedMmioCritSect);
+    AssertRCReturn(rc, rc);
+
+    pVM->nem.s.cCoalescedMmioRingEntries = (uint32_t)(  (cbHostPage - sizeof(struct kvm_coalesced_mmio_ring))
+                                                      / sizeof(struct kvm_coalesced_mmio));
+    pVM->nem.s.pCoalescedMmioRing = (struct kvm_coalesced_mmio_ring *)((uint8_t *)pVM->apCpusR3[0]->nem.s.pRun + offRing);
+
+    STAMR3Register(pVM, &pVM->nem.s.StatCoalescedMmioWrites, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS,
+                   "/NEM/CoalescedMmio/Writes", STAMUNIT_OCCURENCES, "Number of coalesced MMIO writes replayed");
+    STAMR3Register(pVM, &pVM->nem.s.StatCoalescedMmioDrains, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS,
+                   "/NEM/CoalescedMmio/Drains", STAMUNIT_OCCURENCES, "Number of times the coalesced MMIO ring was drained");
+    LogRel(("NEM: Using coalesced MMIO (%u ring entries)\n", pVM->nem.s.cCoalescedMmioRingEntries));
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Replays the writes in the coalesced MMIO ring, slow path.
+ *
+ * @param   pVM         The cross context VM structure.
+ */
+static DECL_NO_INLINE(void, nemR3LnxCoalescedMmioDrainSlow)(PVMCC pVM)
+{
+    struct kvm_coalesced_mmio_ring * const pRing    = pVM->nem.s.pCoalescedMmioRing;
+    uint32_t const                         cEntries = pVM->nem.s.cCoalescedMmioRingEntries;
+
+    RTCritSectEnter(&pVM->nem.s.CoalescedMmioCritSect);
+    uint32_t idxFirst = ASMAtomicReadU32(&pRing->first);
+    uint32_t idxLast  = ASMAtomicReadU32(&pRing->last);
+    if (idxFirst != idxLast)
+    {
+        STAM_REL_COUNTER_INC(&pVM->nem.s.StatCoalescedMmioDrains);
+        do
+        {
+            AssertBreak(idxFirst < cEntries);
+            struct kvm_coalesced_mmio const * const pEntry = &pRing->coalesced_mmio[idxFirst];
+            Assert(pEntry->len <= sizeof(pEntry->data));
+            Assert(!pEntry->pio);
+
+            VBOXSTRICTRC rcStrict = PGMPhysWrite(pVM, pEntry->phys_addr, pEntry->data, RT_MIN(pEntry->len, sizeof(pEntry->data)),
+                                                 PGMACCESSORIGIN_HM);
+            Log4(("CoalescedMmio: WRITE %#RX64 LB %u, %.*Rhxs -> rcStrict=%Rrc\n", (uint64_t)pEntry->phys_addr, pEntry->len,
+                  pEntry->len, pEntry->data, VBOXSTRICTRC_VAL(rcStrict)));
+            AssertMsg(RT_SUCCESS(rcStrict), ("%Rrc\n", VBOXSTRICTRC_VAL(rcStrict))); RT_NOREF(rcStrict);
+            STAM_REL_COUNTER_INC(&pVM->nem.s.StatCoalescedMmioWrites);
+
+            /* Release the entry to KVM. */
+            idxFirst = (idxFirst + 1) % cEntries;
+            ASMAtomicWriteU32(&pRing->first, idxFirst);
+            if (idxFirst == idxLast)
+                idxLast = ASMAtomicReadU32(&pRing->last);
+        } while (idxFirst != idxLast);
+    }
+    RTCritSectLeave(&pVM->nem.s.CoalescedMmioCritSect);
+}
+
+
+/**
+ * Replays the writes in the coalesced MMIO ring, if any.
+ *
+ * This must be called after every KVM_RUN before handling the exit, so the
+ * buffered writes are seen by the devices in order and before any read or
+ * other access triggered by the exit.
+ *
+ * @param   pVM         The cross context VM structure.
+ */
+DECLINLINE(void) nemR3LnxCoalescedMmioDrain(PVMCC pVM)
+{
+    struct kvm_coalesced_mmio_ring * const pRing = pVM->nem.s.pCoalescedMmioRing;
+    if (   pRing
+        && ASMAtomicUoReadU32(&pRing->first) != ASMAtomicUoReadU32(&pRing->last))
+        nemR3LnxCoalescedMmioDrainSlow(pVM);
+}
+
+
+DECLHIDDEN(int) nemR3NativeMmioCoalesceRegister(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb)
+{
+    if (!pVM->nem.s.pCoalescedMmioRing)
+        return VERR_NOT_SUPPORTED;
+    AssertReturn(cb > 0 && cb <= UINT32_MAX, VERR_OUT_OF_RANGE);
+
+    struct kvm_coalesced_mmio_zone Zone;
+    RT_ZERO(Zone);
+    Zone.addr = GCPhys;
+    Zone.size = (uint32_t)cb;
+    int rcLnx = ioctl(pVM->nem.s.fdVm, KVM_REGISTER_COALESCED_MMIO, &Zone);
+    if (rcLnx == 0)
+    {
+        ASMAtomicIncU32(&pVM->nem.s.cCoalescedMmioZones);
+        Log(("nemR3NativeMmioCoalesceRegister: %RGp LB %RGp\n", GCPhys, cb));
+        return VINF_SUCCESS;
+    }
+    LogRel(("NEM: KVM_REGISTER_COALESCED_MMIO(%RGp LB %RGp) failed: %d\n", GCPhys, cb, errno));
+    return RTErrConvertFromErrno(errno);
+}
+
+
+DECLHIDDEN(int) nemR3NativeMmioCoalesceDeregister(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb)
+{
+    AssertReturn(pVM->nem.s.pCoalescedMmioRing, VERR_NOT_SUPPORTED);
+    AssertReturn(cb > 0 && cb <= UINT32_MAX, VERR_OUT_OF_RANGE);
+
+    /* Replay what's buffered while the range is still mapped. */
+    nemR3LnxCoalescedMmioDrain(pVM);
+
+    struct kvm_coalesced_mmio_zone Zone;
+    RT_ZERO(Zone);
+    Zone.addr = GCPhys;
+    Zone.size = (uint32_t)cb;
+    int rcLnx = ioctl(pVM->nem.s.fdVm, KVM_UNREGISTER_COALESCED_MMIO, &Zone);
+    if (rcLnx == 0)
+    {
+        ASMAtomicDecU32(&pVM->nem.s.cCoalescedMmioZones);
+        Log(("nemR3NativeMmioCoalesceDeregister: %RGp LB %RGp\n", GCPhys, cb));
+
+        /* Writes that hit the ring while we were unregistering. */
+        nemR3LnxCoalescedMmioDrain(pVM);
+        return VINF_SUCCESS;
+    }
+    LogRel(("NEM: KVM_UNREGISTER_COALESCED_MMIO(%RGp LB %RGp) failed: %d\n", GCPhys, cb, errno));
+    return RTErrConvertFromErrno(errno);
+}
+
+
 DECLHIDDEN(int) nemR3NativeInit(PVM pVM, bool fFallback, bool fForced)
 {
     RT_NOREF(pVM, fFallback, fForced);
@@ -502,6 +981,32 @@ DECLHIDDEN(int) nemR3NativeInit(PVM pVM, bool fFallback, bool fForced)
                     Log(("NEM: Marked active!\n"));
                     PGMR3EnableNemMode(pVM);
 
+                    /*
+                     * The ioeventfd doorbell dispatcher, if enabled.  Failing
+                     * here is not fatal, devices will just use regular exits.
+                     */
+                    if (pVM->nem.s.fUseIoEventFd)
+                    {
+                        if (pVM->nem.s.fIoEventFd)
+                        {
+                            int rc2 = nemR3LnxDoorbellsInit(pVM);
+                            if (RT_FAILURE(rc2))
+                                LogRel(("NEM: Failed to set up the ioeventfd dispatcher: %Rrc\n", rc2));
+                        }
+                        else
+                            LogRel(("NEM: IoEventFd requested, but KVM_CAP_IOEVENTFD is not available\n"));
+                    }
+
+                    /*
+                     * The coalesced MMIO ring, if available and not disabled.
+                     */
+                    if (pVM->nem.s.fUseCoalescedMmio && pVM->nem.s.uCoalescedMmioPageOff > 0)
+                    {
+                        int rc2 = nemR3LnxCoalescedMmioInit(pVM);
+                        if (RT_FAILURE(rc2))
+                            LogRel(("NEM: Failed to set up coalesced MMIO: %Rrc\n", rc2));
+                    }
+
                     /*
                      * Register release statistics
                      */
@@ -534,6 +1039,20 @@ DECLHIDDEN(int) nemR3NativeInit(PVM pVM, bool fFallback, bool fForced)
                         STAMR3RegisterF(pVM, &pNemCpu->StatExitBusLock,         STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES, "KVM_EXIT_BUS_LOCK",          "/NEM/CPU%u/Exit/BusLock", idCpu);
                         STAMR3RegisterF(pVM, &pNemCpu->StatExitInternalErrorEmulation, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES, "KVM_EXIT_INTERNAL_ERROR/EMULATION", "/NEM/CPU%u/Exit/InternalErrorEmulation", idCpu);
                         STAMR3RegisterF(pVM, &pNemCpu->StatExitInternalErrorFatal,     STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES, "KVM_EXIT_INTERNAL_ERROR/*", "/NEM/CPU%u/Exit/InternalErrorFatal", idCpu);
+
+                        /* The exit latency histograms are opt-in. */
+                        if (pVM->nem.s.fExitHistograms)
+                        {
+                            pNemCpu->paStatExitHist = (PSTAMHISTOGRAM)RTMemAllocZ(sizeof(STAMHISTOGRAM) * NEM_LNX_EXIT_HIST_COUNT);
+                            if (pNemCpu->paStatExitHist)
+                                for (unsigned j = 0; j < NEM_LNX_EXIT_HIST_COUNT; j++)
+                                    STAMR3RegisterF(pVM, &pNemCpu->paStatExitHist[j], STAMTYPE_HISTOGRAM, STAMVISIBILITY_USED,
+                                                    STAMUNIT_TICKS_PER_CALL,
+                                                    j < NEM_LNX_EXIT_HIST_COUNT - 1 ? "KVM exit handling in ring-3" : "Other exit reasons",
+                                                    "/NEM/CPU%u/Exit/Latency/%02u", idCpu, j);
+                            else
+                                LogRel(("NEM: Failed to allocate exit histograms for CPU #%u\n", idCpu));
+                        }
                     }
 
                     /*
@@ -607,11 +1126,25 @@ DECLHIDDEN(int) nemR3NativeTerm(PVM pVM)
             munmap(pVCpu->nem.s.pRun, pVM->nem.s.cbVCpuMmap);
             pVCpu->nem.s.pRun = NULL;
         }
+        if (pVCpu->nem.s.paStatExitHist)
+        {
+            STAMR3DeregisterF(pVM->pUVM, "/NEM/CPU%u/Exit/Latency/*", idCpu);
+            RTMemFree(pVCpu->nem.s.paStatExitHist);
+            pVCpu->nem.s.paStatExitHist = NULL;
+        }
     }
 
     /*
      * Global data.
      */
+    nemR3LnxDoorbellsTerm(pVM);
+
+    if (pVM->nem.s.pCoalescedMmioRing)
+    {
+        pVM->nem.s.pCoalescedMmioRing = NULL;
+        RTCritSectDelete(&pVM->nem.s.CoalescedMmioCritSect);
+    }
+
     if (pVM->nem.s.fdVm != -1)
     {
         close(pVM->nem.s.fdVm);
@@ -858,6 +1391,52 @@ VMMR3_INT_DECL(int) NEMR3PhysMmio2QueryAndResetDirtyBitmap(PVM pVM, RTGCPHYS GCP
 }
 
 
+/**
+ * Worker for NEMR3PhysRamDirtyTracking.
+ *
+ * Flips KVM_MEM_LOG_DIRTY_PAGES on the memory slot backing the RAM range.
+ * KVM permits changing only the flags of an existing slot, so the other
+ * parameters must match what NEMR3NotifyPhysRamRegister used.
+ */
+DECLHIDDEN(int) nemR3NativePhysRamDirtyTracking(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb, void *pvR3, uint32_t uNemRange,
+                                                bool fEnable)
+{
+    AssertReturn(uNemRange > 0 && uNemRange < _32K, VERR_NEM_IPE_4);
+    AssertReturn(ASMBitTest(pVM->nem.s.bmSlotIds, uNemRange), VERR_NEM_IPE_4);
+    AssertPtrReturn(pvR3, VERR_INVALID_POINTER);
+
+    struct kvm_userspace_memory_region Region;
+    Region.slot             = uNemRange;
+    Region.flags            = fEnable ? KVM_MEM_LOG_DIRTY_PAGES : 0;
+    Region.guest_phys_addr  = GCPhys;
+    Region.memory_size      = cb;
+    Region.userspace_addr   = (uintptr_t)pvR3;
+
+    int rc = ioctl(pVM->nem.s.fdVm, KVM_SET_USER_MEMORY_REGION, &Region);
+    if (rc == 0)
+    {
+        Log5(("nemR3NativePhysRamDirtyTracking: %RGp LB %RGp idSlot=%#x fEnable=%d\n", GCPhys, cb, uNemRange, fEnable));
+        return VINF_SUCCESS;
+    }
+    LogRel(("nemR3NativePhysRamDirtyTracking: %RGp LB %RGp idSlot=%#x fEnable=%d failed: %u/%u\n",
+            GCPhys, cb, uNemRange, fEnable, rc, errno));
+    return VERR_NEM_MAP_PAGES_FAILED;
+}
+
+
+/**
+ * Worker for NEMR3PhysRamQueryAndResetDirtyBitmap.
+ *
+ * KVM treats RAM and MMIO2 slots the same way, so this just forwards to the
+ * MMIO2 variant.
+ */
+DECLHIDDEN(int) nemR3NativePhysRamQueryAndResetDirtyBitmap(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb, uint32_t uNemRange,
+                                                           void *pvBitmap, size_t cbBitmap)
+{
+    return NEMR3PhysMmio2QueryAndResetDirtyBitmap(pVM, GCPhys, cb, uNemRange, pvBitmap, cbBitmap);
+}
+
+
 VMMR3_INT_DECL(int)  NEMR3NotifyPhysRomRegisterEarly(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb, void *pvPages, uint32_t fFlags,
                                                      uint8_t *pu2State, uint32_t *puNemRange)
 {
@@ -369,6 +369,7 @@
 #include <VBox/vmm/pgm.h>
 #include <VBox/vmm/ssm.h>
 #include <VBox/vmm/hm.h>
+#include <VBox/vmm/iom.h>
 #include <VBox/vmm/vm.h>
 #include <VBox/vmm/uvm.h>
 #include <VBox/vmm/vmm.h>
@@ -521,6 +522,8 @@ VMMR3_INT_DECL(int) PDMR3Init(PVM pVM)
 #endif
     if (RT_SUCCESS(rc))
         rc = pdmR3BlkCacheInit(pVM);
+    if (RT_SUCCESS(rc))
+        rc = pdmR3IoThreadGroupsInit(pVM);
     if (RT_SUCCESS(rc))
         rc = pdmR3DrvInit(pVM);
     if (RT_SUCCESS(rc))
@@ -832,6 +835,9 @@ VMMR3_INT_DECL(int) PDMR3Term(PVM pVM)
     {
         pdmR3TermLuns(pVM, pDevIns->Internal.s.pLunsR3, pDevIns->pReg->szName, pDevIns->iInstance);
 
+        /* Stop doorbell notifications from NEM worker threads before destroying the device. */
+        IOMR3MmioDoorbellDestroyDevice(pVM, pDevIns);
+
         if (pDevIns->pReg->pfnDestruct)
         {
             LogFlow(("pdmR3DevTerm: Destroying - device '%s'/%d\n", pDevIns->pReg->szName, pDevIns->iInstance));
@@ -873,6 +879,7 @@ VMMR3_INT_DECL(int) PDMR3Term(PVM pVM)
         SSMR3DeregisterDevice(pVM, pDevIns, NULL, 0);
         pdmR3CritSectBothDeleteDevice(pVM, pDevIns);
         pdmR3ThreadDestroyDevice(pVM, pDevIns);
+        pdmR3PhysMapCacheDestroyDevice(pVM, pDevIns);
         PDMR3QueueDestroyDevice(pVM, pDevIns);
 #if 0
         PGMR3PhysMmio2Deregister(pVM, pDevIns, NIL_PGMMMIO2HANDLE);
@@ -891,6 +898,7 @@ VMMR3_INT_DECL(int) PDMR3Term(PVM pVM)
      * Destroy all threads.
      */
     pdmR3ThreadDestroyAll(pVM);
+    pdmR3IoThreadGroupsTerm(pVM);
 
     /*
      * Destroy the block cache.
@@ -39,6 +39,7 @@
 
 #include <VBox/log.h>
 #include <iprt/asm.h>
+#include <iprt/asm-math.h>
 #include <iprt/assert.h>
 #include <iprt/thread.h>
 #include <iprt/mem.h>
@@ -126,8 +127,16 @@ typedef struct PDMASYNCCOMPLETIONTEMPLATE
     volatile uint32_t                       cUsed;
 } PDMASYNCCOMPLETIONTEMPLATE;
 
+/** Maximum nesting depth of bandwidth managers (root included). */
+#define PDMAC_BWMGR_MAX_DEPTH                   8
+
 /**
  * Bandwidth control manager instance data
+ *
+ * Managers form a hierarchy (host, tenant, VM, device, ...) through pParent.
+ * A transfer is only started when the manager of the endpoint and all its
+ * ancestors grant it.  Each manager is a token bucket for bytes and,
+ * optionally, for requests; the bucket size determines the burst allowance.
  */
 typedef struct PDMACBWMGR
 {
@@ -137,19 +146,44 @@ typedef struct PDMACBWMGR
     PPDMASYNCCOMPLETIONEPCLASS                  pEpClass;
     /** Identifier of the manager. */
     char                                       *pszId;
-    /** Maximum number of bytes the endpoints are allowed to transfer (Max is 4GB/s currently) */
+    /** The parent manager, NULL if this is a root.
+     * Set up when the class is initialized and never changed afterwards. */
+    struct PDMACBWMGR                          *pParent;
+    /** Maximum number of bytes the endpoints are allowed to transfer per second,
+     * zero if not limited. */
     volatile uint64_t                           cbTransferPerSecMax;
     /** Number of bytes we start with */
     volatile uint64_t                           cbTransferPerSecStart;
     /** Step after each update */
     volatile uint64_t                           cbTransferPerSecStep;
-    /** Number of bytes we are allowed to transfer till the next update.
-     * Reset by the refresh timer. */
-    volatile uint64_t                           cbTransferAllowed;
-    /** Timestamp of the last update */
+    /** Byte bucket size, i.e. how much can be transferred in one burst after
+     * being idle.  Zero for one second worth at the current rate. */
+    volatile uint64_t                           cbBurst;
+    /** Number of bytes we may transfer right now.  This goes negative when a
+     * request larger than the bucket is let through on a full bucket. */
+    int64_t                                     cbTokens;
+    /** Maximum number of requests per second, zero if not limited. */
+    volatile uint64_t                           cReqsPerSecMax;
+    /** Request bucket size, zero for one second worth. */
+    volatile uint64_t                           cReqsBurst;
+    /** Number of milli-requests we may start right now. */
+    int64_t                                     cMilliReqTokens;
+    /** Timestamp of the last bucket update */
     volatile uint64_t                           tsUpdatedLast;
+    /** Timestamp of the last increase of cbTransferPerSecStart. */
+    uint64_t                                    tsStepLast;
     /** Reference counter - How many endpoints are associated with this manager. */
     volatile uint32_t                           cRefs;
+    uint32_t                                    u32Alignment;
+    /** Number of requests delayed by this manager. */
+    STAMCOUNTER                                 StatThrottled;
+    /** Number of bytes granted. */
+    STAMCOUNTER                                 StatBytes;
+    /** Number of requests granted. */
+    STAMCOUNTER                                 StatRequests;
+    /** Completion latency of the requests of all endpoints below this manager,
+     * including the time spent throttled. */
+    STAMPROFILE                                 StatLatency;
 } PDMACBWMGR;
 /** Pointer to a bandwidth control manager pointer. */
 typedef PPDMACBWMGR *PPPDMACBWMGR;
@@ -655,10 +689,12 @@ static void pdmacBwMgrUnlink(PPDMACBWMGR pBwMgr)
 
 /** Lazy coder. */
 static int pdmacAsyncCompletionBwMgrCreate(PPDMASYNCCOMPLETIONEPCLASS pEpClass, const char *pszBwMgr, uint64_t cbTransferPerSecMax,
-                                           uint64_t cbTransferPerSecStart, uint64_t cbTransferPerSecStep)
+                                           uint64_t cbTransferPerSecStart, uint64_t cbTransferPerSecStep, uint64_t cbBurst,
+                                           uint64_t cReqsPerSecMax, uint64_t cReqsBurst)
 {
-    LogFlowFunc(("pEpClass=%#p pszBwMgr=%#p{%s} cbTransferPerSecMax=%RU64 cbTransferPerSecStart=%RU64 cbTransferPerSecStep=%RU64\n",
-                 pEpClass, pszBwMgr, pszBwMgr, cbTransferPerSecMax, cbTransferPerSecStart, cbTransferPerSecStep));
+    LogFlowFunc(("pEpClass=%#p pszBwMgr=%#p{%s} cbTransferPerSecMax=%RU64 cbTransferPerSecStart=%RU64 cbTransferPerSecStep=%RU64 cbBurst=%RU64 cReqsPerSecMax=%RU64 cReqsBurst=%RU64\n",
+                 pEpClass, pszBwMgr, pszBwMgr, cbTransferPerSecMax, cbTransferPerSecStart, cbTransferPerSecStep, cbBurst,
+                 cReqsPerSecMax, cReqsBurst));
 
     AssertPtrReturn(pEpClass, VERR_INVALID_POINTER);
     AssertPtrReturn(pszBwMgr, VERR_INVALID_POINTER);
@@ -684,8 +720,30 @@ static int pdmacAsyncCompletionBwMgrCreate(PPDMASYNCCOMPLETIONEPCLASS pEpClass,
                 pBwMgr->cbTransferPerSecStart = cbTransferPerSecStart;
                 pBwMgr->cbTransferPerSecStep  = cbTransferPerSecStep;
 
-                pBwMgr->cbTransferAllowed     = pBwMgr->cbTransferPerSecStart;
+                pBwMgr->cbBurst               = cbBurst;
+                pBwMgr->cReqsPerSecMax        = cReqsPerSecMax;
+                pBwMgr->cReqsBurst            = cReqsBurst;
+
+                /* Start out with full buckets. */
+                pBwMgr->cbTokens              = (int64_t)RT_MIN(cbBurst ? cbBurst : cbTransferPerSecStart, (uint64_t)INT64_MAX);
+                pBwMgr->cMilliReqTokens       = (int64_t)RT_MIN((cReqsBurst ? cReqsBurst : cReqsPerSecMax), (uint64_t)_4G) * 1000;
                 pBwMgr->tsUpdatedLast         = RTTimeSystemNanoTS();
+                pBwMgr->tsStepLast            = pBwMgr->tsUpdatedLast;
+
+                PVM pVM = pEpClass->pVM;
+                const char *pszClass = pEpClass->pEndpointOps->pszName;
+                STAMR3RegisterF(pVM, &pBwMgr->StatThrottled, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                                "Number of times a request was delayed by this group",
+                                "/PDM/AsyncCompletion/%s/BwGroups/%s/Throttled", pszClass, pszBwMgr);
+                STAMR3RegisterF(pVM, &pBwMgr->StatBytes, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,
+                                "Number of bytes transferred",
+                                "/PDM/AsyncCompletion/%s/BwGroups/%s/Bytes", pszClass, pszBwMgr);
+                STAMR3RegisterF(pVM, &pBwMgr->StatRequests, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                                "Number of requests started",
+                                "/PDM/AsyncCompletion/%s/BwGroups/%s/Requests", pszClass, pszBwMgr);
+                STAMR3RegisterF(pVM, &pBwMgr->StatLatency, STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_CALL,
+                                "Request latency including the time spent throttled",
+                                "/PDM/AsyncCompletion/%s/BwGroups/%s/Latency", pszClass, pszBwMgr);
 
                 pdmacBwMgrLink(pBwMgr);
                 rc = VINF_SUCCESS;
@@ -705,6 +763,58 @@ static int pdmacAsyncCompletionBwMgrCreate(PPDMASYNCCOMPLETIONEPCLASS pEpClass,
 }
 
 
+/**
+ * Resolves the parents of the bandwidth managers of a class.
+ *
+ * @returns VBox status code.
+ * @param   pEpClass    The endpoint class.
+ * @param   pCfgBwGrp   The BwGroups configuration node of the class.
+ */
+static int pdmacBwMgrsLinkParents(PPDMASYNCCOMPLETIONEPCLASS pEpClass, PCFGMNODE pCfgBwGrp)
+{
+    int rc = VINF_SUCCESS;
+    for (PCFGMNODE pCur = CFGMR3GetFirstChild(pCfgBwGrp); pCur && RT_SUCCESS(rc); pCur = CFGMR3GetNextChild(pCur))
+    {
+        char *pszParent = NULL;
+        rc = CFGMR3QueryStringAllocDef(pCur, "Parent", &pszParent, NULL);
+        if (RT_SUCCESS(rc) && pszParent)
+        {
+            char szName[128];
+            rc = CFGMR3GetName(pCur, szName, sizeof(szName));
+            if (RT_SUCCESS(rc))
+            {
+                PPDMACBWMGR pBwMgr  = pdmacBwMgrFindById(pEpClass, szName);
+                PPDMACBWMGR pParent = pdmacBwMgrFindById(pEpClass, pszParent);
+                if (pBwMgr && pParent && pParent != pBwMgr)
+                {
+                    pBwMgr->pParent = pParent;
+                    LogRel(("AIOMgr: Bandwidth group '%s' is a child of '%s'\n", szName, pszParent));
+                }
+                else
+                    rc = VMR3SetError(pEpClass->pVM->pUVM, VERR_NOT_FOUND, RT_SRC_POS,
+                                      N_("Invalid parent '%s' for the bandwidth group '%s'"), pszParent, szName);
+            }
+            MMR3HeapFree(pszParent);
+        }
+    }
+
+    /* Make sure there are no loops and the hierarchy isn't too deep. */
+    for (PPDMACBWMGR pBwMgr = pEpClass->pBwMgrsHead; pBwMgr && RT_SUCCESS(rc); pBwMgr = pBwMgr->pNext)
+    {
+        unsigned cDepth = 1;
+        for (PPDMACBWMGR pCur = pBwMgr->pParent; pCur; pCur = pCur->pParent)
+            if (++cDepth > PDMAC_BWMGR_MAX_DEPTH)
+            {
+                rc = VMR3SetError(pEpClass->pVM->pUVM, VERR_TOO_MUCH_DATA, RT_SRC_POS,
+                                  N_("The bandwidth group '%s' is nested too deep or part of a loop (max depth %u)"),
+                                  pBwMgr->pszId, PDMAC_BWMGR_MAX_DEPTH);
+                break;
+            }
+    }
+    return rc;
+}
+
+
 /** Lazy coder. */
 DECLINLINE(void) pdmacBwMgrRetain(PPDMACBWMGR pBwMgr)
 {
@@ -720,9 +830,107 @@ DECLINLINE(void) pdmacBwMgrRelease(PPDMACBWMGR pBwMgr)
 }
 
 
+/**
+ * Adds the tokens accumulated over the given time to a bucket.
+ *
+ * @returns New token count, at most cMax.
+ * @param   cTokens     The current token count.
+ * @param   cPerSec     The refill rate in tokens per second.
+ * @param   cNsDelta    Nanoseconds since the last refill.
+ * @param   cMax        The bucket size.
+ */
+DECLINLINE(int64_t) pdmacBwTokensRefill(int64_t cTokens, uint64_t cPerSec, uint64_t cNsDelta, int64_t cMax)
+{
+    /* Anything beyond an hour fills any sane bucket, so cap it there to avoid overflows. */
+    uint64_t const cSecs   = RT_MIN(cNsDelta / RT_NS_1SEC, 3600);
+    uint64_t const cAdded  = cPerSec * cSecs + ASMMultU64ByU32DivByU32(cPerSec, (uint32_t)(cNsDelta % RT_NS_1SEC), RT_NS_1SEC);
+    if (cTokens >= cMax || cAdded >= (uint64_t)(cMax - cTokens))
+        return cMax;
+    return cTokens + (int64_t)cAdded;
+}
+
+
+/**
+ * Returns how many milliseconds it takes to accumulate the given number of
+ * tokens in a bucket.
+ */
+DECLINLINE(RTMSINTERVAL) pdmacBwTokensWait(int64_t cTokens, int64_t cNeeded, uint64_t cPerSec)
+{
+    if (!cPerSec)
+        return RT_MS_1SEC;
+    uint64_t const cMissing = (uint64_t)(cNeeded - cTokens);
+    uint64_t const cMs      = (cMissing * RT_MS_1SEC + cPerSec - 1) / cPerSec;
+    return (RTMSINTERVAL)RT_MIN(RT_MAX(cMs, 1), RT_MS_1SEC);
+}
+
+
+/**
+ * Refills the buckets of a bandwidth manager and checks whether it grants a
+ * request.
+ *
+ * @returns true if the request can go ahead as far as this manager is concerned.
+ * @param   pBwMgr          The bandwidth manager.
+ * @param   cbTransfer      The number of bytes to transfer.
+ * @param   tsNow           The current RTTimeSystemNanoTS value.
+ * @param   pmsWhenNext     Where to store the number of milliseconds until the
+ *                          request would be granted.  Only set if false is
+ *                          returned.
+ * @note    Caller owns PDMASYNCCOMPLETIONEPCLASS::CritSectBw.
+ */
+static bool pdmacBwMgrRefillAndCheck(PPDMACBWMGR pBwMgr, uint64_t cbTransfer, uint64_t tsNow, RTMSINTERVAL *pmsWhenNext)
+{
+    /* Ramp up the rate by the configured step once a second until reaching the maximum. */
+    if (   pBwMgr->cbTransferPerSecStart < pBwMgr->cbTransferPerSecMax
+        && tsNow - pBwMgr->tsStepLast >= RT_NS_1SEC)
+    {
+        pBwMgr->cbTransferPerSecStart = RT_MIN(pBwMgr->cbTransferPerSecMax, pBwMgr->cbTransferPerSecStart + pBwMgr->cbTransferPerSecStep);
+        pBwMgr->tsStepLast            = tsNow;
+        LogFlow(("AIOMgr: Increasing maximum bandwidth of '%s' to %RU64 bytes/sec\n", pBwMgr->pszId, pBwMgr->cbTransferPerSecStart));
+    }
+
+    uint64_t const cNsDelta = tsNow - pBwMgr->tsUpdatedLast;
+    pBwMgr->tsUpdatedLast = tsNow;
+
+    bool fAllowed = true;
+    if (pBwMgr->cbTransferPerSecMax)
+    {
+        uint64_t const cbPerSec = pBwMgr->cbTransferPerSecStart;
+        int64_t  const cbMax    = (int64_t)RT_MIN(RT_MAX(pBwMgr->cbBurst ? pBwMgr->cbBurst : cbPerSec, 1), (uint64_t)INT64_MAX);
+        pBwMgr->cbTokens = pdmacBwTokensRefill(pBwMgr->cbTokens, cbPerSec, cNsDelta, cbMax);
+
+        /* Requests larger than the bucket are let through once it is full. */
+        int64_t const cbNeeded = (int64_t)RT_MIN(cbTransfer, (uint64_t)cbMax);
+        if (pBwMgr->cbTokens < cbNeeded)
+        {
+            *pmsWhenNext = pdmacBwTokensWait(pBwMgr->cbTokens, cbNeeded, cbPerSec);
+            fAllowed = false;
+        }
+    }
+
+    uint64_t const cReqsPerSec = pBwMgr->cReqsPerSecMax;
+    if (cReqsPerSec)
+    {
+        int64_t const cMilliMax = (int64_t)RT_MIN(RT_MAX(pBwMgr->cReqsBurst ? pBwMgr->cReqsBurst : cReqsPerSec, 1), (uint64_t)_4G)
+                                * 1000;
+        pBwMgr->cMilliReqTokens = pdmacBwTokensRefill(pBwMgr->cMilliReqTokens, cReqsPerSec * 1000, cNsDelta, cMilliMax);
+        if (pBwMgr->cMilliReqTokens < 1000)
+        {
+            RTMSINTERVAL const msWait = pdmacBwTokensWait(pBwMgr->cMilliReqTokens, 1000, cReqsPerSec * 1000);
+            *pmsWhenNext = fAllowed ? msWait : RT_MAX(*pmsWhenNext, msWait);
+            fAllowed = false;
+        }
+    }
+
+    return fAllowed;
+}
+
+
 /**
  * Checks if the endpoint is allowed to transfer the given amount of bytes.
  *
+ * The request must be granted by the bandwidth manager of the endpoint and
+ * all its ancestors.  If it is, the tokens are taken from all of them.
+ *
  * @returns true if the endpoint is allowed to transfer the data.
  *          false otherwise
  * @param   pEndpoint                 The endpoint.
@@ -740,42 +948,31 @@ bool pdmacEpIsTransferAllowed(PPDMASYNCCOMPLETIONENDPOINT pEndpoint, uint64_t cb
 
     if (pBwMgr)
     {
-        uint64_t cbOld = ASMAtomicSubU64(&pBwMgr->cbTransferAllowed, cbTransfer);
-        if (RT_LIKELY(cbOld >= cbTransfer))
-            fAllowed = true;
-        else
-        {
-            fAllowed = false;
-
-            /* We are out of resources  Check if we can update again. */
-            uint64_t tsNow          = RTTimeSystemNanoTS();
-            uint64_t tsUpdatedLast  = ASMAtomicUoReadU64(&pBwMgr->tsUpdatedLast);
+        PPDMASYNCCOMPLETIONEPCLASS pEpClass = pEndpoint->pEpClass;
+        int rc = RTCritSectEnter(&pEpClass->CritSectBw); AssertRC(rc);
 
-            if (tsNow - tsUpdatedLast >= (1000*1000*1000))
+        uint64_t const tsNow = RTTimeSystemNanoTS();
+        for (PPDMACBWMGR pCur = pBwMgr; pCur; pCur = pCur->pParent)
+            if (!pdmacBwMgrRefillAndCheck(pCur, cbTransfer, tsNow, pmsWhenNext))
             {
-                if (ASMAtomicCmpXchgU64(&pBwMgr->tsUpdatedLast, tsNow, tsUpdatedLast))
-                {
-                    if (pBwMgr->cbTransferPerSecStart < pBwMgr->cbTransferPerSecMax)
-                    {
-                       pBwMgr->cbTransferPerSecStart = RT_MIN(pBwMgr->cbTransferPerSecMax, pBwMgr->cbTransferPerSecStart + pBwMgr->cbTransferPerSecStep);
-                       LogFlow(("AIOMgr: Increasing maximum bandwidth to %RU64 bytes/sec\n", pBwMgr->cbTransferPerSecStart));
-                    }
-
-                    /* Update */
-                    uint64_t cbTransferAllowedNew =   pBwMgr->cbTransferPerSecStart > cbTransfer
-                                                    ? pBwMgr->cbTransferPerSecStart - cbTransfer
-                                                    : 0;
-                    ASMAtomicWriteU64(&pBwMgr->cbTransferAllowed, cbTransferAllowedNew);
-                    fAllowed = true;
-                    LogFlow(("AIOMgr: Refreshed bandwidth\n"));
-                }
+                STAM_REL_COUNTER_INC(&pCur->StatThrottled);
+                LogFlow(("AIOMgr: Request of %RU64 bytes throttled by '%s' for %u ms\n", cbTransfer, pCur->pszId, *pmsWhenNext));
+                fAllowed = false;
+                break;
             }
-            else
+
+        if (fAllowed)
+            for (PPDMACBWMGR pCur = pBwMgr; pCur; pCur = pCur->pParent)
             {
-                ASMAtomicAddU64(&pBwMgr->cbTransferAllowed, cbTransfer);
-                *pmsWhenNext = ((1000*1000*1000) - (tsNow - tsUpdatedLast)) / (1000*1000);
+                if (pCur->cbTransferPerSecMax)
+                    pCur->cbTokens -= (int64_t)RT_MIN(cbTransfer, (uint64_t)INT64_MAX / 2);
+                if (pCur->cReqsPerSecMax)
+                    pCur->cMilliReqTokens -= 1000;
+                STAM_REL_COUNTER_ADD(&pCur->StatBytes, cbTransfer);
+                STAM_REL_COUNTER_INC(&pCur->StatRequests);
             }
-        }
+
+        rc = RTCritSectLeave(&pEpClass->CritSectBw); AssertRC(rc);
     }
 
     LogFlowFunc(("fAllowed=%RTbool\n", fAllowed));
@@ -856,13 +1053,15 @@ static int pdmR3AsyncCompletionEpClassInit(PVM pVM, PCPDMASYNCCOMPLETIONEPCLASSO
         pEndpointClass->pEndpointOps = pEpClassOps;
 
         rc = RTCritSectInit(&pEndpointClass->CritSect);
+        if (RT_SUCCESS(rc))
+            rc = RTCritSectInit(&pEndpointClass->CritSectBw);
         if (RT_SUCCESS(rc))
         {
             PCFGMNODE pCfgNodeClass = CFGMR3GetChild(pCfgHandle, pEpClassOps->pszName);
 
             /* Create task cache */
             rc = RTMemCacheCreate(&pEndpointClass->hMemCacheTasks, pEpClassOps->cbTask,
-                                  0, UINT32_MAX, NULL, NULL, NULL, 0);
+                                  0, UINT32_MAX, NULL, NULL, NULL, RTMEMCACHE_F_MAGAZINES);
             if (RT_SUCCESS(rc))
             {
                 /* Call the specific endpoint class initializer. */
@@ -888,14 +1087,21 @@ static int pdmR3AsyncCompletionEpClassInit(PVM pVM, PCPDMASYNCCOMPLETIONEPCLASSO
                                     {
                                         uint64_t cbStart;
                                         rc = CFGMR3QueryU64Def(pCur, "Start", &cbStart, cbMax);
+                                        uint64_t cbStep = 0;
                                         if (RT_SUCCESS(rc))
-                                        {
-                                            uint64_t cbStep;
                                             rc = CFGMR3QueryU64Def(pCur, "Step", &cbStep, 0);
-                                            if (RT_SUCCESS(rc))
-                                                rc = pdmacAsyncCompletionBwMgrCreate(pEndpointClass, pszBwGrpId,
-                                                                                     cbMax, cbStart, cbStep);
-                                        }
+                                        uint64_t cbBurst = 0;
+                                        if (RT_SUCCESS(rc))
+                                            rc = CFGMR3QueryU64Def(pCur, "Burst", &cbBurst, 0);
+                                        uint64_t cReqsMax = 0;
+                                        if (RT_SUCCESS(rc))
+                                            rc = CFGMR3QueryU64Def(pCur, "MaxIops", &cReqsMax, 0);
+                                        uint64_t cReqsBurst = 0;
+                                        if (RT_SUCCESS(rc))
+                                            rc = CFGMR3QueryU64Def(pCur, "IopsBurst", &cReqsBurst, 0);
+                                        if (RT_SUCCESS(rc))
+                                            rc = pdmacAsyncCompletionBwMgrCreate(pEndpointClass, pszBwGrpId, cbMax, cbStart,
+                                                                                 cbStep, cbBurst, cReqsMax, cReqsBurst);
                                     }
                                 }
                                 RTMemFree(pszBwGrpId);
@@ -905,6 +1111,10 @@ static int pdmR3AsyncCompletionEpClassInit(PVM pVM, PCPDMASYNCCOMPLETIONEPCLASSO
                             if (RT_FAILURE(rc))
                                 break;
                         }
+
+                        /* Link up the hierarchy now that all groups exist. */
+                        if (RT_SUCCESS(rc))
+                            rc = pdmacBwMgrsLinkParents(pEndpointClass, pCfgBwGrp);
                     }
                     if (RT_SUCCESS(rc))
                     {
@@ -925,8 +1135,10 @@ static int pdmR3AsyncCompletionEpClassInit(PVM pVM, PCPDMASYNCCOMPLETIONEPCLASSO
                 }
                 RTMemCacheDestroy(pEndpointClass->hMemCacheTasks);
             }
-            RTCritSectDelete(&pEndpointClass->CritSect);
+            RTCritSectDelete(&pEndpointClass->CritSectBw);
         }
+        if (RTCritSectIsInitialized(&pEndpointClass->CritSect))
+            RTCritSectDelete(&pEndpointClass->CritSect);
         MMR3HeapFree(pEndpointClass);
     }
 
@@ -957,6 +1169,8 @@ static void pdmR3AsyncCompletionEpClassTerminate(PPDMASYNCCOMPLETIONEPCLASS pEnd
     {
         PPDMACBWMGR pFree = pBwMgr;
         pBwMgr = pBwMgr->pNext;
+        STAMR3DeregisterF(pVM->pUVM, "/PDM/AsyncCompletion/%s/BwGroups/%s/*", pEndpointClass->pEndpointOps->pszName, pFree->pszId);
+        RTStrFree(pFree->pszId);
         MMR3HeapFree(pFree);
     }
 
@@ -964,6 +1178,7 @@ static void pdmR3AsyncCompletionEpClassTerminate(PPDMASYNCCOMPLETIONEPCLASS pEnd
     pEndpointClass->pEndpointOps->pfnTerminate(pEndpointClass);
 
     RTMemCacheDestroy(pEndpointClass->hMemCacheTasks);
+    RTCritSectDelete(&pEndpointClass->CritSectBw);
     RTCritSectDelete(&pEndpointClass->CritSect);
 
     /* Free the memory of the class finally and clear the entry in the class array. */
@@ -1306,6 +1521,13 @@ void pdmR3AsyncCompletionResume(PVM pVM)
                 LogRel(("AIOMgr:     Max:   %RU64 B/s\n", pBwMgr->cbTransferPerSecMax));
                 LogRel(("AIOMgr:     Start: %RU64 B/s\n", pBwMgr->cbTransferPerSecStart));
                 LogRel(("AIOMgr:     Step:  %RU64 B/s\n", pBwMgr->cbTransferPerSecStep));
+                if (pBwMgr->cbBurst)
+                    LogRel(("AIOMgr:     Burst: %RU64 B\n", pBwMgr->cbBurst));
+                if (pBwMgr->cReqsPerSecMax)
+                    LogRel(("AIOMgr:     IOPS:  %RU64 (burst %RU64)\n", pBwMgr->cReqsPerSecMax,
+                            pBwMgr->cReqsBurst ? pBwMgr->cReqsBurst : pBwMgr->cReqsPerSecMax));
+                if (pBwMgr->pParent)
+                    LogRel(("AIOMgr:     Parent: %s\n", pBwMgr->pParent->pszId));
                 LogRel(("AIOMgr:     Endpoints:\n"));
 
                 pEp = pEpClass->pEndpointsHead;
@@ -1381,6 +1603,9 @@ static void pdmR3AsyncCompletionPutTask(PPDMASYNCCOMPLETIONENDPOINT pEndpoint, P
     if (pEndpointClass->fGatherAdvancedStatistics)
         pdmR3AsyncCompletionStatisticsRecordCompletionTime(pEndpoint, cNsRun);
 
+    for (PPDMACBWMGR pBwMgr = ASMAtomicReadPtrT(&pEndpoint->pBwMgr, PPDMACBWMGR); pBwMgr; pBwMgr = pBwMgr->pParent)
+        STAM_REL_PROFILE_ADD_PERIOD(&pBwMgr->StatLatency, cNsRun);
+
     RTMemCacheFree(pEndpointClass->hMemCacheTasks, pTask);
 }
 
@@ -45,6 +45,7 @@
 #include <iprt/critsect.h>
 #include <iprt/env.h>
 #include <iprt/file.h>
+#include <iprt/ioqueue.h>
 #include <iprt/mem.h>
 #include <iprt/semaphore.h>
 #include <iprt/string.h>
@@ -209,6 +210,12 @@ static void pdmacFileAioMgrWakeup(PPDMACEPFILEMGR pAioMgr)
             int rc = RTSemEventSignal(pAioMgr->EventSem);
             AssertRC(rc);
         }
+        else if (ASMAtomicReadBool(&pAioMgr->fWaitingIoQueue))
+        {
+            /* The I/O queue manager waits for completions, kick it out. */
+            int rc = RTIoQueueEvtWaitWakeup(pAioMgr->hIoQueue);
+            AssertRC(rc);
+        }
     }
 }
 
@@ -465,25 +472,33 @@ int pdmacFileAioMgrCreate(PPDMASYNCCOMPLETIONEPCLASSFILE pEpClass, PPPDMACEPFILE
                 if (RT_SUCCESS(rc))
                 {
                     /* Init the rest of the manager. */
-                    if (pAioMgrNew->enmMgrType != PDMACEPFILEMGRTYPE_SIMPLE)
+                    PFNRTTHREAD pfnAioMgr = pdmacFileAioMgrFailsafe;
+                    const char *pszSuff   = "F";
+                    if (pAioMgrNew->enmMgrType == PDMACEPFILEMGRTYPE_ASYNC)
+                    {
                         rc = pdmacFileAioMgrNormalInit(pAioMgrNew);
+                        pfnAioMgr = pdmacFileAioMgrNormal;
+                        pszSuff   = "N";
+                    }
+                    else if (pAioMgrNew->enmMgrType == PDMACEPFILEMGRTYPE_IOQUEUE)
+                    {
+                        rc = pdmacFileAioMgrIoQueueInit(pAioMgrNew, pEpClass->fIoQueueSqPoll);
+                        pfnAioMgr = pdmacFileAioMgrIoQueue;
+                        pszSuff   = "Q";
+                    }
 
                     if (RT_SUCCESS(rc))
                     {
                         pAioMgrNew->enmState = PDMACEPFILEMGRSTATE_RUNNING;
 
                         rc = RTThreadCreateF(&pAioMgrNew->Thread,
-                                             pAioMgrNew->enmMgrType == PDMACEPFILEMGRTYPE_SIMPLE
-                                             ? pdmacFileAioMgrFailsafe
-                                             : pdmacFileAioMgrNormal,
+                                             pfnAioMgr,
                                              pAioMgrNew,
                                              0,
                                              RTTHREADTYPE_IO,
                                              0,
                                              "AioMgr%d-%s", pEpClass->cAioMgrs,
-                                             pAioMgrNew->enmMgrType == PDMACEPFILEMGRTYPE_SIMPLE
-                                             ? "F"
-                                             : "N");
+                                             pszSuff);
                         if (RT_SUCCESS(rc))
                         {
                             /* Link it into the list. */
@@ -500,7 +515,10 @@ int pdmacFileAioMgrCreate(PPDMASYNCCOMPLETIONEPCLASSFILE pEpClass, PPPDMACEPFILE
                             Log(("PDMAC: Successfully created new file AIO Mgr {%s}\n", RTThreadGetName(pAioMgrNew->Thread)));
                             return VINF_SUCCESS;
                         }
-                        pdmacFileAioMgrNormalDestroy(pAioMgrNew);
+                        if (pAioMgrNew->enmMgrType == PDMACEPFILEMGRTYPE_IOQUEUE)
+                            pdmacFileAioMgrIoQueueDestroy(pAioMgrNew);
+                        else
+                            pdmacFileAioMgrNormalDestroy(pAioMgrNew);
                     }
                     RTCritSectDelete(&pAioMgrNew->CritSectBlockingEvent);
                 }
@@ -550,8 +568,10 @@ static void pdmacFileAioMgrDestroy(PPDMASYNCCOMPLETIONEPCLASSFILE pEpClassFile,
     RTCritSectDelete(&pAioMgr->CritSectBlockingEvent);
     RTSemEventDestroy(pAioMgr->EventSem);
     RTSemEventDestroy(pAioMgr->EventSemBlock);
-    if (pAioMgr->enmMgrType != PDMACEPFILEMGRTYPE_SIMPLE)
+    if (pAioMgr->enmMgrType == PDMACEPFILEMGRTYPE_ASYNC)
         pdmacFileAioMgrNormalDestroy(pAioMgr);
+    else if (pAioMgr->enmMgrType == PDMACEPFILEMGRTYPE_IOQUEUE)
+        pdmacFileAioMgrIoQueueDestroy(pAioMgr);
 
     MMR3HeapFree(pAioMgr);
 }
@@ -564,6 +584,8 @@ static int pdmacFileMgrTypeFromName(const char *pszVal, PPDMACEPFILEMGRTYPE penm
         *penmMgrType = PDMACEPFILEMGRTYPE_SIMPLE;
     else if (!RTStrCmp(pszVal, "Async"))
         *penmMgrType = PDMACEPFILEMGRTYPE_ASYNC;
+    else if (!RTStrCmp(pszVal, "IoQueue"))
+        *penmMgrType = PDMACEPFILEMGRTYPE_IOQUEUE;
     else
         rc = VERR_CFGM_CONFIG_UNKNOWN_VALUE;
 
@@ -576,6 +598,8 @@ static const char *pdmacFileMgrTypeToName(PDMACEPFILEMGRTYPE enmMgrType)
         return "Simple";
     if (enmMgrType == PDMACEPFILEMGRTYPE_ASYNC)
         return "Async";
+    if (enmMgrType == PDMACEPFILEMGRTYPE_IOQUEUE)
+        return "IoQueue";
 
     return NULL;
 }
@@ -839,6 +863,19 @@ static DECLCALLBACK(int) pdmacFileInitialize(PPDMASYNCCOMPLETIONEPCLASS pClassGl
             if (RT_FAILURE(rc))
                 return rc;
 
+            if (pEpClassFile->enmMgrTypeOverride == PDMACEPFILEMGRTYPE_IOQUEUE)
+            {
+                /* Whether to let the host kernel poll for submitted requests, costs a host core while busy. */
+                rc = CFGMR3QueryBoolDef(pCfgNode, "IoQueueSqPoll", &pEpClassFile->fIoQueueSqPoll, false);
+                AssertLogRelRCReturn(rc, rc);
+
+                if (!RTIoQueueProviderGetBestForHndType(RTHANDLETYPE_FILE))
+                {
+                    LogRel(("AIOMgr: No I/O queue provider available for files, falling back to the async manager\n"));
+                    pEpClassFile->enmMgrTypeOverride = PDMACEPFILEMGRTYPE_ASYNC;
+                }
+            }
+
             LogRel(("AIOMgr: Default manager type is '%s'\n", pdmacFileMgrTypeToName(pEpClassFile->enmMgrTypeOverride)));
 
             /* Query default backend type */
@@ -945,6 +982,7 @@ static DECLCALLBACK(int) pdmacFileEpInitialize(PPDMASYNCCOMPLETIONENDPOINT pEndp
             fFileFlags |= RTFILE_O_DENY_WRITE;
     }
 
+    /* The I/O queue manager doesn't need this, it copes with buffered I/O (see RTFileOpen for the implications on Linux). */
     if (enmMgrType == PDMACEPFILEMGRTYPE_ASYNC)
         fFileFlags |= RTFILE_O_ASYNC_IO;
 
@@ -976,7 +1014,8 @@ static DECLCALLBACK(int) pdmacFileEpInitialize(PPDMASYNCCOMPLETIONENDPOINT pEndp
 
 #ifdef RT_OS_LINUX
                 fFileFlags &= ~RTFILE_O_ASYNC_IO;
-                enmMgrType   = PDMACEPFILEMGRTYPE_SIMPLE;
+                if (enmMgrType == PDMACEPFILEMGRTYPE_ASYNC)
+                    enmMgrType = PDMACEPFILEMGRTYPE_SIMPLE;
 #endif
             }
             RTFileClose(hFile);
@@ -1006,7 +1045,8 @@ static DECLCALLBACK(int) pdmacFileEpInitialize(PPDMASYNCCOMPLETIONENDPOINT pEndp
 
 #ifdef RT_OS_LINUX
         fFileFlags &= ~RTFILE_O_ASYNC_IO;
-        enmMgrType   = PDMACEPFILEMGRTYPE_SIMPLE;
+        if (enmMgrType == PDMACEPFILEMGRTYPE_ASYNC)
+            enmMgrType = PDMACEPFILEMGRTYPE_SIMPLE;
 #endif
 
         /* Open again. */
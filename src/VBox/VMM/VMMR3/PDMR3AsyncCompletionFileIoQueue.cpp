@@ -0,0 +1,669 @@
+/* $Id$ */
+/** @file
+ * PDM Async I/O - Transport data asynchronous in R3 using EMT.
+ * I/O queue based File I/O manager.
+ */
+
+/*
+ * Copyright (C) 2006-2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#define LOG_GROUP LOG_GROUP_PDM_ASYNC_COMPLETION
+#include <iprt/asm.h>
+#include <iprt/assert.h>
+#include <iprt/ioqueue.h>
+#include <iprt/mem.h>
+#include <iprt/string.h>
+#include <VBox/log.h>
+
+#include "PDMAsyncCompletionFileInternal.h"
+
+
+/*********************************************************************************************************************************
+*   Defined Constants And Macros                                                                                                 *
+*********************************************************************************************************************************/
+/** Number of submission queue entries, also the maximum number of requests in flight. */
+#define PDMACEPFILEMGR_IOQUEUE_REQS_MAX     256
+/** Number of completion events reaped at once. */
+#define PDMACEPFILEMGR_IOQUEUE_CEVTS_MAX    64
+
+
+
+/**
+ * Put a list of tasks in the pending request list of an endpoint.
+ */
+DECLINLINE(void) pdmacFileAioMgrIoQueueEpAddTaskList(PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint, PPDMACTASKFILE pTaskHead)
+{
+    /* Add the rest of the tasks to the pending list */
+    if (!pEndpoint->AioMgr.pReqsPendingHead)
+    {
+        Assert(!pEndpoint->AioMgr.pReqsPendingTail);
+        pEndpoint->AioMgr.pReqsPendingHead = pTaskHead;
+    }
+    else
+    {
+        Assert(pEndpoint->AioMgr.pReqsPendingTail);
+        pEndpoint->AioMgr.pReqsPendingTail->pNext = pTaskHead;
+    }
+
+    /* Update the tail. */
+    while (pTaskHead->pNext)
+        pTaskHead = pTaskHead->pNext;
+
+    pEndpoint->AioMgr.pReqsPendingTail = pTaskHead;
+    pTaskHead->pNext = NULL;
+}
+
+/**
+ * Initializes a file handle descriptor for the given endpoint.
+ */
+DECLINLINE(void) pdmacFileAioMgrIoQueueEpHandleInit(PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint, PRTHANDLE pHandle)
+{
+    pHandle->enmType = RTHANDLETYPE_FILE;
+    pHandle->u.hFile = pEndpoint->hFile;
+}
+
+/**
+ * Prepares a request for the given task, it gets submitted with the next commit.
+ */
+static int pdmacFileAioMgrIoQueueReqPrepare(PPDMACEPFILEMGR pAioMgr, PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint,
+                                            PPDMACTASKFILE pTask, RTIOQUEUEOP enmOp, RTFOFF off, void *pvBuf, size_t cbBuf)
+{
+    RTHANDLE Hnd;
+    pdmacFileAioMgrIoQueueEpHandleInit(pEndpoint, &Hnd);
+
+    int rc = RTIoQueueRequestPrepare(pAioMgr->hIoQueue, &Hnd, enmOp, off, pvBuf, cbBuf, 0 /*fReqFlags*/, pTask);
+    if (RT_SUCCESS(rc))
+    {
+        pAioMgr->cIoQueueReqsPrepared++;
+        pAioMgr->cRequestsActive++;
+        pEndpoint->AioMgr.cRequestsActive++;
+    }
+
+    return rc;
+}
+
+/**
+ * Commits all prepared requests with a single call to the host.
+ */
+static void pdmacFileAioMgrIoQueueCommit(PPDMACEPFILEMGR pAioMgr)
+{
+    if (pAioMgr->cIoQueueReqsPrepared)
+    {
+        int rc = RTIoQueueCommit(pAioMgr->hIoQueue);
+        AssertLogRelMsg(RT_SUCCESS(rc), ("AIOMgr: Committing %u requests failed with %Rrc\n", pAioMgr->cIoQueueReqsPrepared, rc));
+        RT_NOREF(rc);
+        pAioMgr->cIoQueueReqsPrepared = 0;
+    }
+}
+
+/**
+ * Frees the bounce buffer of the given task if there is one.
+ */
+DECLINLINE(void) pdmacFileAioMgrIoQueueTaskBounceBufferFree(PPDMACTASKFILE pTask)
+{
+    if (pTask->cbBounceBuffer)
+    {
+        RTMemPageFree(pTask->pvBounceBuffer, pTask->cbBounceBuffer);
+        pTask->pvBounceBuffer = NULL;
+        pTask->cbBounceBuffer = 0;
+    }
+}
+
+/**
+ * Completes the given task and returns it to the endpoint cache.
+ */
+static void pdmacFileAioMgrIoQueueTaskComplete(PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint, PPDMACTASKFILE pTask, int rc)
+{
+    pdmacFileAioMgrIoQueueTaskBounceBufferFree(pTask);
+
+    LogFlow(("Task=%#p completed with %Rrc\n", pTask, rc));
+    pTask->pfnCompleted(pTask, pTask->pvUser, rc);
+    pdmacFileTaskFree(pEndpoint, pTask);
+}
+
+/**
+ * Grows the file if the given write task goes beyond the current end.
+ */
+DECLINLINE(void) pdmacFileAioMgrIoQueueEpGrow(PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint, PPDMACTASKFILE pTask)
+{
+    if (RT_UNLIKELY((uint64_t)pTask->Off + pTask->DataSeg.cbSeg > pEndpoint->cbFile))
+    {
+        ASMAtomicWriteU64(&pEndpoint->cbFile, pTask->Off + pTask->DataSeg.cbSeg);
+        RTFileSetSize(pEndpoint->hFile, pTask->Off + pTask->DataSeg.cbSeg);
+    }
+}
+
+/**
+ * Prepares the remaining data transfer for the given read or write task.
+ */
+static int pdmacFileAioMgrIoQueueTaskPrepareXfer(PPDMACEPFILEMGR pAioMgr, PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint,
+                                                 PPDMACTASKFILE pTask)
+{
+    RTIOQUEUEOP enmOp = pTask->enmTransferType == PDMACTASKFILETRANSFER_READ ? RTIOQUEUEOP_READ : RTIOQUEUEOP_WRITE;
+
+    if (pTask->cbBounceBuffer)
+    {
+        RTFOFF offStart = pTask->Off - pTask->offBounceBuffer;
+        return pdmacFileAioMgrIoQueueReqPrepare(pAioMgr, pEndpoint, pTask, enmOp, offStart + pTask->cbTransfered,
+                                                (uint8_t *)pTask->pvBounceBuffer + pTask->cbTransfered,
+                                                pTask->cbBounceBuffer - pTask->cbTransfered);
+    }
+
+    return pdmacFileAioMgrIoQueueReqPrepare(pAioMgr, pEndpoint, pTask, enmOp, pTask->Off + pTask->cbTransfered,
+                                            (uint8_t *)pTask->DataSeg.pvSeg + pTask->cbTransfered,
+                                            pTask->DataSeg.cbSeg - pTask->cbTransfered);
+}
+
+/**
+ * Processes a single completion event.
+ */
+static void pdmacFileAioMgrIoQueueReqComplete(PPDMACEPFILEMGR pAioMgr, PCRTIOQUEUECEVT pCEvt)
+{
+    PPDMACTASKFILE pTask = (PPDMACTASKFILE)pCEvt->pvUser;
+    PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint = pTask->pEndpoint;
+    int rcReq = pCEvt->rcReq;
+
+    Assert(pAioMgr->cRequestsActive > 0);
+    Assert(pEndpoint->AioMgr.cRequestsActive > 0);
+    pAioMgr->cRequestsActive--;
+    pEndpoint->AioMgr.cRequestsActive--;
+
+    if (pTask->enmTransferType == PDMACTASKFILETRANSFER_FLUSH)
+    {
+        Assert(pEndpoint->pFlushReq == pTask);
+        pEndpoint->pFlushReq = NULL;
+        pdmacFileAioMgrIoQueueTaskComplete(pEndpoint, pTask, rcReq);
+        return;
+    }
+
+    if (RT_SUCCESS(rcReq))
+    {
+        size_t cbXfer = pTask->cbBounceBuffer ? pTask->cbBounceBuffer : pTask->DataSeg.cbSeg;
+
+        pTask->cbTransfered += pCEvt->cbXfered;
+        if (RT_UNLIKELY(pTask->cbTransfered < cbXfer))
+        {
+            /*
+             * Restart an incomplete transfer to get at the real cause (disk full, I/O error, ...),
+             * a transfer without any progress is at the end of the file and can't get any further.
+             */
+            if (pCEvt->cbXfered)
+            {
+                LogFlow(("Restarting incomplete transfer %#p (%zu bytes transferred)\n", pTask, pCEvt->cbXfered));
+                rcReq = pdmacFileAioMgrIoQueueTaskPrepareXfer(pAioMgr, pEndpoint, pTask);
+                if (RT_SUCCESS(rcReq))
+                    return;
+            }
+            else if (   pTask->enmTransferType == PDMACTASKFILETRANSFER_READ
+                     && pTask->cbBounceBuffer
+                     && pTask->cbTransfered >= pTask->offBounceBuffer + pTask->DataSeg.cbSeg)
+                rcReq = VINF_SUCCESS; /* The aligned tail of the bounce buffer is beyond the end of the file. */
+            else
+                rcReq = pTask->enmTransferType == PDMACTASKFILETRANSFER_READ ? VERR_EOF : VERR_WRITE_ERROR;
+        }
+
+        if (   RT_SUCCESS(rcReq)
+            && pTask->cbBounceBuffer
+            && pTask->enmTransferType == PDMACTASKFILETRANSFER_READ)
+            memcpy(pTask->DataSeg.pvSeg, (uint8_t *)pTask->pvBounceBuffer + pTask->offBounceBuffer, pTask->DataSeg.cbSeg);
+    }
+
+    pdmacFileAioMgrIoQueueTaskComplete(pEndpoint, pTask, rcReq);
+
+    /*
+     * A flush waits until everything issued before it completed so the host
+     * doesn't reorder it with the outstanding writes, issue it now.
+     */
+    if (   !pEndpoint->AioMgr.cRequestsActive
+        && pEndpoint->pFlushReq)
+    {
+        PPDMACTASKFILE pFlush = pEndpoint->pFlushReq;
+        int rc = pdmacFileAioMgrIoQueueReqPrepare(pAioMgr, pEndpoint, pFlush, RTIOQUEUEOP_SYNC, 0 /*off*/, NULL, 0);
+        if (RT_FAILURE(rc))
+        {
+            pEndpoint->pFlushReq = NULL;
+            pdmacFileAioMgrIoQueueTaskComplete(pEndpoint, pFlush, rc);
+        }
+    }
+}
+
+/**
+ * Commits all prepared requests, waits for at least one completion and processes
+ * all completion events available.
+ *
+ * @returns VBox status code.
+ * @param   pAioMgr     The I/O manager.
+ */
+static int pdmacFileAioMgrIoQueueReap(PPDMACEPFILEMGR pAioMgr)
+{
+    RTIOQUEUECEVT aCEvt[PDMACEPFILEMGR_IOQUEUE_CEVTS_MAX];
+    uint32_t      cCEvt = 0;
+
+    pdmacFileAioMgrIoQueueCommit(pAioMgr);
+
+    ASMAtomicWriteBool(&pAioMgr->fWaitingIoQueue, true);
+    int rc = VINF_SUCCESS;
+    if (!ASMAtomicReadBool(&pAioMgr->fWokenUp))
+        rc = RTIoQueueEvtWait(pAioMgr->hIoQueue, &aCEvt[0], RT_ELEMENTS(aCEvt), 1 /*cMinWait*/, &cCEvt, 0 /*fFlags*/);
+    ASMAtomicWriteBool(&pAioMgr->fWaitingIoQueue, false);
+    AssertMsg(RT_SUCCESS(rc) || rc == VERR_INTERRUPTED, ("Waiting for completions failed with %Rrc\n", rc));
+
+    for (uint32_t i = 0; i < cCEvt; i++)
+        pdmacFileAioMgrIoQueueReqComplete(pAioMgr, &aCEvt[i]);
+
+    return rc == VERR_INTERRUPTED ? VINF_SUCCESS : rc;
+}
+
+/**
+ * Waits until all requests of the given endpoint completed, including a pending flush.
+ *
+ * @param   pAioMgr     The I/O manager.
+ * @param   pEndpoint   The endpoint to wait for.
+ */
+static void pdmacFileAioMgrIoQueueEpDrain(PPDMACEPFILEMGR pAioMgr, PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint)
+{
+    while (   pEndpoint->AioMgr.cRequestsActive
+           || pEndpoint->pFlushReq)
+    {
+        /* Don't let a wakeup from a producer turn this into a busy loop. */
+        ASMAtomicWriteBool(&pAioMgr->fWokenUp, false);
+        int rc = pdmacFileAioMgrIoQueueReap(pAioMgr);
+        AssertRCBreak(rc);
+    }
+}
+
+/**
+ * Completes a write which isn't aligned to the sector size on a non buffered
+ * endpoint by doing a synchronous read-modify-write cycle.
+ *
+ * Waits for all outstanding requests of the endpoint first so nothing else
+ * touches the affected sectors in the meantime. Unaligned writes are rare so
+ * this doesn't warrant range locking like the normal manager does.
+ */
+static int pdmacFileAioMgrIoQueueTaskWriteUnaligned(PPDMACEPFILEMGR pAioMgr, PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint,
+                                                    PPDMACTASKFILE pTask, RTFOFF offStart, size_t cbToTransfer)
+{
+    pdmacFileAioMgrIoQueueEpDrain(pAioMgr, pEndpoint);
+
+    void *pvBuf = RTMemPageAllocZ(cbToTransfer);
+    if (RT_UNLIKELY(!pvBuf))
+        return VERR_NO_MEMORY;
+
+    size_t cbRead = 0;
+    int rc = RTFileReadAt(pEndpoint->hFile, offStart, pvBuf, cbToTransfer, &cbRead);
+    if (RT_SUCCESS(rc))
+    {
+        memcpy((uint8_t *)pvBuf + (pTask->Off - offStart), pTask->DataSeg.pvSeg, pTask->DataSeg.cbSeg);
+        pdmacFileAioMgrIoQueueEpGrow(pEndpoint, pTask);
+        rc = RTFileWriteAt(pEndpoint->hFile, offStart, pvBuf, cbToTransfer, NULL);
+    }
+
+    RTMemPageFree(pvBuf, cbToTransfer);
+    return rc;
+}
+
+/**
+ * Prepares a read or write task, sets up a bounce buffer if the endpoint
+ * doesn't use the host cache and the request doesn't meet the host alignment
+ * requirements.
+ *
+ * @returns VBox status code, the task is completed by the caller on failure.
+ */
+static int pdmacFileAioMgrIoQueueTaskPrepareReadWrite(PPDMACEPFILEMGR pAioMgr, PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint,
+                                                      PPDMACTASKFILE pTask)
+{
+    pTask->cbTransfered   = 0;
+    pTask->cbBounceBuffer = 0;
+    pTask->pvBounceBuffer = NULL;
+
+    if (pEndpoint->enmBackendType == PDMACFILEEPBACKEND_NON_BUFFERED)
+    {
+        PPDMASYNCCOMPLETIONEPCLASSFILE pEpClassFile = (PPDMASYNCCOMPLETIONEPCLASSFILE)pEndpoint->Core.pEpClass;
+        RTFOFF offStart     = pTask->Off & ~(RTFOFF)(512-1);
+        size_t cbToTransfer = RT_ALIGN_Z(pTask->DataSeg.cbSeg + (pTask->Off - offStart), 512);
+        bool   fAlignedReq  =    cbToTransfer == pTask->DataSeg.cbSeg
+                              && offStart == pTask->Off;
+
+        if (   !fAlignedReq
+            && pTask->enmTransferType == PDMACTASKFILETRANSFER_WRITE)
+        {
+            int rc = pdmacFileAioMgrIoQueueTaskWriteUnaligned(pAioMgr, pEndpoint, pTask, offStart, cbToTransfer);
+            pdmacFileAioMgrIoQueueTaskComplete(pEndpoint, pTask, rc);
+            return VINF_SUCCESS;
+        }
+
+        if (   !fAlignedReq
+            || (pEpClassFile->uBitmaskAlignment & (RTR3UINTPTR)pTask->DataSeg.pvSeg) != (RTR3UINTPTR)pTask->DataSeg.pvSeg)
+        {
+            LogFlow(("Using bounce buffer for task %#p cbToTransfer=%zd cbSeg=%zd offStart=%RTfoff off=%RTfoff\n",
+                     pTask, cbToTransfer, pTask->DataSeg.cbSeg, offStart, pTask->Off));
+
+            pTask->pvBounceBuffer = RTMemPageAlloc(cbToTransfer);
+            if (RT_UNLIKELY(!pTask->pvBounceBuffer))
+                return VERR_NO_MEMORY;
+
+            pTask->cbBounceBuffer  = cbToTransfer;
+            pTask->offBounceBuffer = (uint32_t)(pTask->Off - offStart);
+            if (pTask->enmTransferType == PDMACTASKFILETRANSFER_WRITE)
+                memcpy(pTask->pvBounceBuffer, pTask->DataSeg.pvSeg, pTask->DataSeg.cbSeg);
+        }
+    }
+
+    if (pTask->enmTransferType == PDMACTASKFILETRANSFER_WRITE)
+        pdmacFileAioMgrIoQueueEpGrow(pEndpoint, pTask);
+
+    return pdmacFileAioMgrIoQueueTaskPrepareXfer(pAioMgr, pEndpoint, pTask);
+}
+
+/**
+ * Processes a given task list for assigned to the given endpoint.
+ */
+static int pdmacFileAioMgrIoQueueProcessEndpointTaskList(PPDMACEPFILEMGR pAioMgr,
+                                                         PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint,
+                                                         PPDMACTASKFILE pTasks)
+{
+    while (pTasks)
+    {
+        RTMSINTERVAL msWhenNext;
+        PPDMACTASKFILE pCurr = pTasks;
+
+        /* Everything after a flush has to wait until it completed, as do requests not fitting into the queue. */
+        if (   pEndpoint->pFlushReq
+            || pAioMgr->cRequestsActive >= pAioMgr->cRequestsActiveMax)
+            break;
+
+        if (!pdmacEpIsTransferAllowed(&pEndpoint->Core, pCurr->DataSeg.cbSeg, &msWhenNext))
+        {
+            pAioMgr->msBwLimitExpired = RT_MIN(pAioMgr->msBwLimitExpired, msWhenNext);
+            break;
+        }
+
+        pTasks = pTasks->pNext;
+
+        int rc = VINF_SUCCESS;
+        switch (pCurr->enmTransferType)
+        {
+            case PDMACTASKFILETRANSFER_FLUSH:
+            {
+                pEndpoint->pFlushReq = pCurr;
+                if (!pEndpoint->AioMgr.cRequestsActive)
+                    rc = pdmacFileAioMgrIoQueueReqPrepare(pAioMgr, pEndpoint, pCurr, RTIOQUEUEOP_SYNC, 0 /*off*/, NULL, 0);
+                /* else: Issued when the last outstanding request completes. */
+                if (RT_FAILURE(rc))
+                    pEndpoint->pFlushReq = NULL;
+                break;
+            }
+            case PDMACTASKFILETRANSFER_READ:
+            case PDMACTASKFILETRANSFER_WRITE:
+            {
+                rc = pdmacFileAioMgrIoQueueTaskPrepareReadWrite(pAioMgr, pEndpoint, pCurr);
+                break;
+            }
+            default:
+                AssertMsgFailed(("Invalid transfer type %d\n", pCurr->enmTransferType));
+                rc = VERR_INVALID_PARAMETER;
+        }
+
+        pEndpoint->AioMgr.cReqsProcessed++;
+        if (RT_FAILURE(rc))
+            pdmacFileAioMgrIoQueueTaskComplete(pEndpoint, pCurr, rc);
+    }
+
+    if (pTasks)
+    {
+        /* Add the rest of the tasks to the pending list */
+        pdmacFileAioMgrIoQueueEpAddTaskList(pEndpoint, pTasks);
+    }
+
+    return VINF_SUCCESS;
+}
+
+static int pdmacFileAioMgrIoQueueProcessEndpoint(PPDMACEPFILEMGR pAioMgr,
+                                                 PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint)
+{
+    int rc = VINF_SUCCESS;
+    PPDMACTASKFILE pTasks = pEndpoint->AioMgr.pReqsPendingHead;
+
+    pEndpoint->AioMgr.pReqsPendingHead = NULL;
+    pEndpoint->AioMgr.pReqsPendingTail = NULL;
+
+    /* Process the request pending list first in case the endpoint was migrated or had to wait. */
+    if (pTasks)
+        rc = pdmacFileAioMgrIoQueueProcessEndpointTaskList(pAioMgr, pEndpoint, pTasks);
+
+    if (RT_SUCCESS(rc))
+    {
+        pTasks = pdmacFileEpGetNewTasks(pEndpoint);
+
+        if (pTasks)
+            rc = pdmacFileAioMgrIoQueueProcessEndpointTaskList(pAioMgr, pEndpoint, pTasks);
+    }
+
+    return rc;
+}
+
+/**
+ * Removes the given endpoint from the manager after all of its requests completed.
+ */
+static void pdmacFileAioMgrIoQueueEpRemove(PPDMACEPFILEMGR pAioMgr, PPDMASYNCCOMPLETIONENDPOINTFILE pEndpointRemove)
+{
+    pdmacFileAioMgrIoQueueEpDrain(pAioMgr, pEndpointRemove);
+
+    RTHANDLE Hnd;
+    pdmacFileAioMgrIoQueueEpHandleInit(pEndpointRemove, &Hnd);
+    int rc = RTIoQueueHandleDeregister(pAioMgr->hIoQueue, &Hnd);
+    AssertRC(rc);
+
+    PPDMASYNCCOMPLETIONENDPOINTFILE pPrev = pEndpointRemove->AioMgr.pEndpointPrev;
+    PPDMASYNCCOMPLETIONENDPOINTFILE pNext = pEndpointRemove->AioMgr.pEndpointNext;
+
+    if (pPrev)
+        pPrev->AioMgr.pEndpointNext = pNext;
+    else
+        pAioMgr->pEndpointsHead = pNext;
+
+    if (pNext)
+        pNext->AioMgr.pEndpointPrev = pPrev;
+
+    pAioMgr->cEndpoints--;
+}
+
+/**
+ * Initializes the I/O queue based part of the given manager.
+ *
+ * @returns VBox status code.
+ * @param   pAioMgr     The I/O manager.
+ * @param   fSqPoll     Flag whether the host kernel should poll for submitted requests.
+ */
+int pdmacFileAioMgrIoQueueInit(PPDMACEPFILEMGR pAioMgr, bool fSqPoll)
+{
+    PCRTIOQUEUEPROVVTABLE pIoQueueProv = RTIoQueueProviderGetBestForHndType(RTHANDLETYPE_FILE);
+    if (!pIoQueueProv)
+        return VERR_NOT_SUPPORTED;
+
+    pAioMgr->cRequestsActiveMax = PDMACEPFILEMGR_IOQUEUE_REQS_MAX;
+
+    int rc = RTIoQueueCreate(&pAioMgr->hIoQueue, pIoQueueProv, fSqPoll ? RTIOQUEUE_F_SQPOLL : 0,
+                             PDMACEPFILEMGR_IOQUEUE_REQS_MAX, PDMACEPFILEMGR_IOQUEUE_REQS_MAX);
+    if (RT_SUCCESS(rc))
+        LogRel(("AIOMgr: Created I/O queue using the '%s' provider (max %u requests%s)\n",
+                pIoQueueProv->pszId, PDMACEPFILEMGR_IOQUEUE_REQS_MAX, fSqPoll ? ", SQ polling requested" : ""));
+    else
+        LogRel(("AIOMgr: Creating I/O queue using the '%s' provider failed with %Rrc\n", pIoQueueProv->pszId, rc));
+
+    return rc;
+}
+
+/**
+ * Destroys the I/O queue based part of the given manager.
+ *
+ * @param   pAioMgr     The I/O manager.
+ */
+void pdmacFileAioMgrIoQueueDestroy(PPDMACEPFILEMGR pAioMgr)
+{
+    if (pAioMgr->hIoQueue != NIL_RTIOQUEUE)
+    {
+        int rc = RTIoQueueDestroy(pAioMgr->hIoQueue);
+        AssertRC(rc);
+        pAioMgr->hIoQueue = NIL_RTIOQUEUE;
+    }
+}
+
+/**
+ * I/O manager submitting all requests of an iteration through an I/O queue
+ * with a single commit (io_uring on Linux hosts).
+ */
+DECLCALLBACK(int) pdmacFileAioMgrIoQueue(RTTHREAD hThreadSelf, void *pvUser)
+{
+    int             rc      = VINF_SUCCESS;
+    PPDMACEPFILEMGR pAioMgr = (PPDMACEPFILEMGR)pvUser;
+    NOREF(hThreadSelf);
+
+    while (   (pAioMgr->enmState == PDMACEPFILEMGRSTATE_RUNNING)
+           || (pAioMgr->enmState == PDMACEPFILEMGRSTATE_SUSPENDING))
+    {
+        if (!pAioMgr->cRequestsActive)
+        {
+            /* Nothing in flight, sleep until new requests arrive. */
+            ASMAtomicWriteBool(&pAioMgr->fWaitingEventSem, true);
+            if (!ASMAtomicReadBool(&pAioMgr->fWokenUp))
+                rc = RTSemEventWait(pAioMgr->EventSem, pAioMgr->msBwLimitExpired);
+            ASMAtomicWriteBool(&pAioMgr->fWaitingEventSem, false);
+            Assert(RT_SUCCESS(rc) || rc == VERR_TIMEOUT);
+        }
+        else
+        {
+            rc = pdmacFileAioMgrIoQueueReap(pAioMgr);
+            AssertRC(rc);
+        }
+
+        LogFlow(("Got woken up\n"));
+        ASMAtomicWriteBool(&pAioMgr->fWokenUp, false);
+
+        /* Process endpoint events first. */
+        PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint = pAioMgr->pEndpointsHead;
+        pAioMgr->msBwLimitExpired = RT_INDEFINITE_WAIT;
+        while (pEndpoint)
+        {
+            rc = pdmacFileAioMgrIoQueueProcessEndpoint(pAioMgr, pEndpoint);
+            AssertRC(rc);
+            pEndpoint = pEndpoint->AioMgr.pEndpointNext;
+        }
+
+        /* Now check for an external blocking event. */
+        if (pAioMgr->fBlockingEventPending)
+        {
+            switch (pAioMgr->enmBlockingEvent)
+            {
+                case PDMACEPFILEAIOMGRBLOCKINGEVENT_ADD_ENDPOINT:
+                {
+                    PPDMASYNCCOMPLETIONENDPOINTFILE pEndpointNew = pAioMgr->BlockingEventData.AddEndpoint.pEndpoint;
+                    AssertMsg(RT_VALID_PTR(pEndpointNew), ("Adding endpoint event without a endpoint to add\n"));
+
+                    pEndpointNew->enmState = PDMASYNCCOMPLETIONENDPOINTFILESTATE_ACTIVE;
+
+                    RTHANDLE Hnd;
+                    pdmacFileAioMgrIoQueueEpHandleInit(pEndpointNew, &Hnd);
+                    rc = RTIoQueueHandleRegister(pAioMgr->hIoQueue, &Hnd);
+                    AssertRC(rc);
+
+                    pEndpointNew->AioMgr.pEndpointNext = pAioMgr->pEndpointsHead;
+                    pEndpointNew->AioMgr.pEndpointPrev = NULL;
+                    if (pAioMgr->pEndpointsHead)
+                        pAioMgr->pEndpointsHead->AioMgr.pEndpointPrev = pEndpointNew;
+                    pAioMgr->pEndpointsHead = pEndpointNew;
+
+                    pAioMgr->cEndpoints++;
+
+                    /*
+                     * Process the task list the first time. There might be pending requests
+                     * if the endpoint was migrated from another endpoint.
+                     */
+                    rc = pdmacFileAioMgrIoQueueProcessEndpoint(pAioMgr, pEndpointNew);
+                    AssertRC(rc);
+                    break;
+                }
+                case PDMACEPFILEAIOMGRBLOCKINGEVENT_REMOVE_ENDPOINT:
+                {
+                    PPDMASYNCCOMPLETIONENDPOINTFILE pEndpointRemove = pAioMgr->BlockingEventData.RemoveEndpoint.pEndpoint;
+                    AssertMsg(RT_VALID_PTR(pEndpointRemove), ("Removing endpoint event without a endpoint to remove\n"));
+
+                    pEndpointRemove->enmState = PDMASYNCCOMPLETIONENDPOINTFILESTATE_REMOVING;
+                    pdmacFileAioMgrIoQueueEpRemove(pAioMgr, pEndpointRemove);
+                    break;
+                }
+                case PDMACEPFILEAIOMGRBLOCKINGEVENT_CLOSE_ENDPOINT:
+                {
+                    PPDMASYNCCOMPLETIONENDPOINTFILE pEndpointClose = pAioMgr->BlockingEventData.CloseEndpoint.pEndpoint;
+                    AssertMsg(RT_VALID_PTR(pEndpointClose), ("Close endpoint event without a endpoint to Close\n"));
+
+                    /* Make sure all tasks finished, including the ones held back by a flush. */
+                    do
+                    {
+                        rc = pdmacFileAioMgrIoQueueProcessEndpoint(pAioMgr, pEndpointClose);
+                        AssertRC(rc);
+                        pdmacFileAioMgrIoQueueEpDrain(pAioMgr, pEndpointClose);
+                    } while (pEndpointClose->AioMgr.pReqsPendingHead);
+
+                    pEndpointClose->enmState = PDMASYNCCOMPLETIONENDPOINTFILESTATE_CLOSING;
+                    pdmacFileAioMgrIoQueueEpRemove(pAioMgr, pEndpointClose);
+                    break;
+                }
+                case PDMACEPFILEAIOMGRBLOCKINGEVENT_SHUTDOWN:
+                {
+                    ASMAtomicWriteBool(&pAioMgr->fWokenUp, false);
+                    while (pAioMgr->cRequestsActive)
+                    {
+                        rc = pdmacFileAioMgrIoQueueReap(pAioMgr);
+                        AssertRCBreak(rc);
+                    }
+                    pAioMgr->enmState = PDMACEPFILEMGRSTATE_SHUTDOWN;
+                    break;
+                }
+                case PDMACEPFILEAIOMGRBLOCKINGEVENT_SUSPEND:
+                    pAioMgr->enmState = PDMACEPFILEMGRSTATE_SUSPENDING;
+                    break;
+                case PDMACEPFILEAIOMGRBLOCKINGEVENT_RESUME:
+                    pAioMgr->enmState = PDMACEPFILEMGRSTATE_RUNNING;
+                    break;
+                default:
+                    AssertMsgFailed(("Invalid event type %d\n", pAioMgr->enmBlockingEvent));
+            }
+
+            ASMAtomicWriteBool(&pAioMgr->fBlockingEventPending, false);
+            pAioMgr->enmBlockingEvent = PDMACEPFILEAIOMGRBLOCKINGEVENT_INVALID;
+
+            /* Release the waiting thread. */
+            rc = RTSemEventSignal(pAioMgr->EventSemBlock);
+            AssertRC(rc);
+        }
+
+        /* Submit everything prepared during this iteration at once. */
+        pdmacFileAioMgrIoQueueCommit(pAioMgr);
+    }
+
+    return rc;
+}
@@ -145,8 +145,13 @@ static void pdmBlkCacheValidate(PPDMBLKCACHEGLOBAL pCache)
     AssertMsg(pCache->LruRecentlyUsedIn.cbCached + pCache->LruFrequentlyUsed.cbCached == pCache->cbCached,
               ("Amount of cached data doesn't match\n"));
 
-    AssertMsg(pCache->LruRecentlyUsedOut.cbCached <= pCache->cbRecentlyUsedOutMax,
-              ("Paged out list exceeds maximum\n"));
+    if (pCache->enmPolicy == PDMBLKCACHEPOLICY_2Q)
+        AssertMsg(pCache->LruRecentlyUsedOut.cbCached <= pCache->cbRecentlyUsedOutMax,
+                  ("Paged out list exceeds maximum\n"));
+    else
+        AssertMsg(   pCache->LruRecentlyUsedOut.cbCached <= pCache->cbMax
+                  && pCache->LruFrequentlyUsedOut.cbCached <= 2 * (uint64_t)pCache->cbMax,
+                  ("Ghost lists exceed maximum\n"));
 }
 #endif
 
@@ -166,16 +171,19 @@ DECLINLINE(void) pdmBlkCacheLockLeave(PPDMBLKCACHEGLOBAL pCache)
     RTCritSectLeave(&pCache->CritSect);
 }
 
-DECLINLINE(void) pdmBlkCacheSub(PPDMBLKCACHEGLOBAL pCache, uint32_t cbAmount)
+DECLINLINE(void) pdmBlkCacheSub(PPDMBLKCACHEGLOBAL pCache, PPDMBLKCACHE pBlkCache, uint32_t cbAmount)
 {
     PDMACFILECACHE_IS_CRITSECT_OWNER(pCache);
     pCache->cbCached -= cbAmount;
+    Assert(pBlkCache->cbCached >= cbAmount);
+    pBlkCache->cbCached -= cbAmount;
 }
 
-DECLINLINE(void) pdmBlkCacheAdd(PPDMBLKCACHEGLOBAL pCache, uint32_t cbAmount)
+DECLINLINE(void) pdmBlkCacheAdd(PPDMBLKCACHEGLOBAL pCache, PPDMBLKCACHE pBlkCache, uint32_t cbAmount)
 {
     PDMACFILECACHE_IS_CRITSECT_OWNER(pCache);
     pCache->cbCached += cbAmount;
+    pBlkCache->cbCached += cbAmount;
 }
 
 DECLINLINE(void) pdmBlkCacheListAdd(PPDMBLKLRULIST pList, uint32_t cbAmount)
@@ -334,12 +342,41 @@ static void pdmBlkCacheDestroyList(PPDMBLKLRULIST pList)
     }
 }
 
+/**
+ * Returns the maximum number of bytes the given ghost list may track.
+ *
+ * @returns Maximum size of the ghost list in bytes.
+ * @param   pCache          Pointer to the global cache data.
+ * @param   pGhostList      The ghost list.
+ */
+static uint64_t pdmBlkCacheGhostListGetMax(PPDMBLKCACHEGLOBAL pCache, PPDMBLKLRULIST pGhostList)
+{
+    if (pCache->enmPolicy == PDMBLKCACHEPOLICY_2Q)
+        return pCache->cbRecentlyUsedOutMax;
+
+    /*
+     * ARC keeps |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c,
+     * with c being the cache size.
+     */
+    uint64_t const cbT1 = pCache->LruRecentlyUsedIn.cbCached;
+    if (pGhostList == &pCache->LruRecentlyUsedOut)
+        return pCache->cbMax > cbT1 ? pCache->cbMax - cbT1 : 0;
+
+    uint64_t const cbUsed = cbT1 + pCache->LruFrequentlyUsed.cbCached + pCache->LruRecentlyUsedOut.cbCached;
+    return 2 * (uint64_t)pCache->cbMax > cbUsed ? 2 * (uint64_t)pCache->cbMax - cbUsed : 0;
+}
+
 /**
  * Tries to remove the given amount of bytes from a given list in the cache
  * moving the entries to one of the given ghosts lists
  *
  * @returns Amount of data which could be freed.
  * @param    pCache           Pointer to the global cache data.
+ * @param    pBlkCacheReq     The cache user the data is freed for.
+ * @param    fOwnOnly         Flag whether to evict only entries of
+ *                            pBlkCacheReq.  Otherwise entries of other users
+ *                            are skipped while these are at or below their
+ *                            minimum share.
  * @param    cbData           The amount of the data to free.
  * @param    pListSrc         The source list to evict data from.
  * @param    pGhostListDst    Where the ghost list removed entries should be
@@ -354,8 +391,8 @@ static void pdmBlkCacheDestroyList(PPDMBLKLRULIST pList)
  *          may be marked as non evictable if they are used for I/O at the
  *          moment.
  */
-static size_t pdmBlkCacheEvictPagesFrom(PPDMBLKCACHEGLOBAL pCache, size_t cbData,
-                                        PPDMBLKLRULIST pListSrc, PPDMBLKLRULIST pGhostListDst,
+static size_t pdmBlkCacheEvictPagesFrom(PPDMBLKCACHEGLOBAL pCache, PPDMBLKCACHE pBlkCacheReq, bool fOwnOnly,
+                                        size_t cbData, PPDMBLKLRULIST pListSrc, PPDMBLKLRULIST pGhostListDst,
                                         bool fReuseBuffer, uint8_t **ppbBuffer)
 {
     size_t cbEvicted = 0;
@@ -364,8 +401,10 @@ static size_t pdmBlkCacheEvictPagesFrom(PPDMBLKCACHEGLOBAL pCache, size_t cbData
 
     AssertMsg(cbData > 0, ("Evicting 0 bytes not possible\n"));
     AssertMsg(   !pGhostListDst
-              || (pGhostListDst == &pCache->LruRecentlyUsedOut),
-              ("Destination list must be NULL or the recently used but paged out list\n"));
+              || (pGhostListDst == &pCache->LruRecentlyUsedOut)
+              || (   pGhostListDst == &pCache->LruFrequentlyUsedOut
+                  && pCache->enmPolicy == PDMBLKCACHEPOLICY_ARC),
+              ("Destination list must be NULL or one of the paged out lists\n"));
 
     if (fReuseBuffer)
     {
@@ -382,6 +421,12 @@ static size_t pdmBlkCacheEvictPagesFrom(PPDMBLKCACHEGLOBAL pCache, size_t cbData
 
         pEntry = pEntry->pPrev;
 
+        /* Leave entries of other users alone if asked to or if they are within their minimum share. */
+        if (   pCurr->pBlkCache != pBlkCacheReq
+            && (   fOwnOnly
+                || pCurr->pBlkCache->cbCached <= pCurr->pBlkCache->cbMinShare))
+            continue;
+
         /* We can't evict pages which are currently in progress or dirty but not in progress */
         if (   !(pCurr->fFlags & PDMBLKCACHE_NOT_EVICTABLE)
             && (ASMAtomicReadU32(&pCurr->cRefs) == 0))
@@ -408,16 +453,17 @@ static size_t pdmBlkCacheEvictPagesFrom(PPDMBLKCACHEGLOBAL pCache, size_t cbData
                 cbEvicted += pCurr->cbData;
 
                 pdmBlkCacheEntryRemoveFromList(pCurr);
-                pdmBlkCacheSub(pCache, pCurr->cbData);
+                pdmBlkCacheSub(pCache, pBlkCache, pCurr->cbData);
 
                 if (pGhostListDst)
                 {
                     RTSemRWReleaseWrite(pBlkCache->SemRWEntries);
 
                     PPDMBLKCACHEENTRY pGhostEntFree = pGhostListDst->pTail;
+                    uint64_t const    cbGhostMax    = pdmBlkCacheGhostListGetMax(pCache, pGhostListDst);
 
                     /* We have to remove the last entries from the paged out list. */
-                    while (   pGhostListDst->cbCached + pCurr->cbData > pCache->cbRecentlyUsedOutMax
+                    while (   pGhostListDst->cbCached + pCurr->cbData > cbGhostMax
                            && pGhostEntFree)
                     {
                         PPDMBLKCACHEENTRY pFree = pGhostEntFree;
@@ -441,7 +487,7 @@ static size_t pdmBlkCacheEvictPagesFrom(PPDMBLKCACHEGLOBAL pCache, size_t cbData
                         RTSemRWReleaseWrite(pBlkCacheFree->SemRWEntries);
                     }
 
-                    if (pGhostListDst->cbCached + pCurr->cbData > pCache->cbRecentlyUsedOutMax)
+                    if (pGhostListDst->cbCached + pCurr->cbData > cbGhostMax)
                     {
                         /* Couldn't remove enough entries. Delete */
                         STAM_PROFILE_ADV_START(&pCache->StatTreeRemove, Cache);
@@ -479,49 +525,173 @@ static size_t pdmBlkCacheEvictPagesFrom(PPDMBLKCACHEGLOBAL pCache, size_t cbData
     return cbEvicted;
 }
 
-static bool pdmBlkCacheReclaim(PPDMBLKCACHEGLOBAL pCache, size_t cbData, bool fReuseBuffer, uint8_t **ppbBuffer)
+/**
+ * Evicts data from the first list and if that is not enough from the second one.
+ *
+ * @returns Amount of data which could be freed.
+ * @param    pCache           Pointer to the global cache data.
+ * @param    pBlkCacheReq     The cache user the data is freed for.
+ * @param    fOwnOnly         Flag whether to evict only entries of pBlkCacheReq.
+ * @param    cbData           The amount of the data to free.
+ * @param    pList1           The list to evict data from first.
+ * @param    pGhostList1      The ghost list for entries from pList1, optional.
+ * @param    pList2           The list to evict the rest from, optional.
+ * @param    pGhostList2      The ghost list for entries from pList2, optional.
+ * @param    fReuseBuffer     Flag whether a buffer should be reused if it has
+ *                            the same size
+ * @param    ppbBuffer        Where to store the address of the reusable buffer.
+ */
+static size_t pdmBlkCacheEvictPagesFrom2(PPDMBLKCACHEGLOBAL pCache, PPDMBLKCACHE pBlkCacheReq, bool fOwnOnly,
+                                         size_t cbData, PPDMBLKLRULIST pList1, PPDMBLKLRULIST pGhostList1,
+                                         PPDMBLKLRULIST pList2, PPDMBLKLRULIST pGhostList2,
+                                         bool fReuseBuffer, uint8_t **ppbBuffer)
 {
-    size_t cbRemoved = 0;
+    size_t cbRemoved = pdmBlkCacheEvictPagesFrom(pCache, pBlkCacheReq, fOwnOnly, cbData, pList1, pGhostList1,
+                                                 fReuseBuffer, ppbBuffer);
 
-    if ((pCache->cbCached + cbData) < pCache->cbMax)
-        return true;
-    else if ((pCache->LruRecentlyUsedIn.cbCached + cbData) > pCache->cbRecentlyUsedInMax)
+    /*
+     * If it was not possible to remove enough entries try the second list.
+     */
+    if (cbRemoved < cbData && pList2)
     {
-        /* Try to evict as many bytes as possible from A1in */
-        cbRemoved = pdmBlkCacheEvictPagesFrom(pCache, cbData, &pCache->LruRecentlyUsedIn,
-                                                 &pCache->LruRecentlyUsedOut, fReuseBuffer, ppbBuffer);
+        Assert(!fReuseBuffer || !*ppbBuffer); /* It is not possible that we got a buffer with the correct size but we didn't freed enough data. */
 
         /*
-         * If it was not possible to remove enough entries
-         * try the frequently accessed cache.
+         * If we removed something we can't pass the reuse buffer flag anymore because
+         * we don't need to evict that much data
          */
-        if (cbRemoved < cbData)
-        {
-            Assert(!fReuseBuffer || !*ppbBuffer); /* It is not possible that we got a buffer with the correct size but we didn't freed enough data. */
+        if (!cbRemoved)
+            cbRemoved += pdmBlkCacheEvictPagesFrom(pCache, pBlkCacheReq, fOwnOnly, cbData, pList2, pGhostList2,
+                                                   fReuseBuffer, ppbBuffer);
+        else
+            cbRemoved += pdmBlkCacheEvictPagesFrom(pCache, pBlkCacheReq, fOwnOnly, cbData - cbRemoved, pList2, pGhostList2,
+                                                   false, NULL);
+    }
 
-            /*
-             * If we removed something we can't pass the reuse buffer flag anymore because
-             * we don't need to evict that much data
-             */
-            if (!cbRemoved)
-                cbRemoved += pdmBlkCacheEvictPagesFrom(pCache, cbData, &pCache->LruFrequentlyUsed,
-                                                          NULL, fReuseBuffer, ppbBuffer);
-            else
-                cbRemoved += pdmBlkCacheEvictPagesFrom(pCache, cbData - cbRemoved, &pCache->LruFrequentlyUsed,
-                                                          NULL, false, NULL);
+    return cbRemoved;
+}
+
+/**
+ * Makes room for the given amount of data in the cache.
+ *
+ * @returns Flag whether enough data could be evicted.
+ * @param    pCache             Pointer to the global cache data.
+ * @param    pBlkCache          The cache user the data is needed for.
+ * @param    cbData             The amount of data needed.
+ * @param    fGhostHitFrequent  Flag whether the data is needed for an entry
+ *                              found in the frequently used ghost list (ARC).
+ * @param    fReuseBuffer       Flag whether a buffer should be reused if it has
+ *                              the same size
+ * @param    ppbBuffer          Where to store the address of the buffer if an
+ *                              entry with the same size was found and
+ *                              fReuseBuffer is true.
+ */
+static bool pdmBlkCacheReclaim(PPDMBLKCACHEGLOBAL pCache, PPDMBLKCACHE pBlkCache, size_t cbData,
+                               bool fGhostHitFrequent, bool fReuseBuffer, uint8_t **ppbBuffer)
+{
+    size_t cbRemoved = 0;
+    PPDMBLKLRULIST pGhostListFrequent =   pCache->enmPolicy == PDMBLKCACHEPOLICY_ARC
+                                        ? &pCache->LruFrequentlyUsedOut
+                                        : NULL;
+
+    if (fReuseBuffer)
+        *ppbBuffer = NULL;
+
+    /* Keep the user within its maximum share evicting its own entries first. */
+    if (pBlkCache->cbCached + cbData > pBlkCache->cbMaxShare)
+    {
+        size_t cbOver = pBlkCache->cbCached + cbData - pBlkCache->cbMaxShare;
+
+        cbRemoved = pdmBlkCacheEvictPagesFrom2(pCache, pBlkCache, true /*fOwnOnly*/, cbOver,
+                                               &pCache->LruRecentlyUsedIn, &pCache->LruRecentlyUsedOut,
+                                               &pCache->LruFrequentlyUsed, pGhostListFrequent,
+                                               fReuseBuffer, ppbBuffer);
+        STAM_REL_COUNTER_ADD(&pBlkCache->StatShareEvicted, cbRemoved);
+        if (cbRemoved < cbOver)
+        {
+            LogFlowFunc((": %s: removed %u bytes to stay within share, requested %u\n", pBlkCache->pszId, cbRemoved, cbOver));
+            return false;
         }
+
+        /* Freeing a buffer with the right size made room for the new data already. */
+        if (fReuseBuffer && *ppbBuffer)
+            return true;
+        cbRemoved = 0;
+    }
+
+    if ((pCache->cbCached + cbData) < pCache->cbMax)
+        return true;
+    else if (pCache->enmPolicy == PDMBLKCACHEPOLICY_ARC)
+    {
+        /*
+         * ARC replace: Evict from T1 if it exceeds its target size (or reached it
+         * and the data is needed for a B2 hit), from T2 otherwise.
+         */
+        uint32_t cbT1 = pCache->LruRecentlyUsedIn.cbCached;
+        if (   cbT1
+            && (   cbT1 > pCache->cbRecentlyUsedTarget
+                || (fGhostHitFrequent && cbT1 >= pCache->cbRecentlyUsedTarget)))
+            cbRemoved = pdmBlkCacheEvictPagesFrom2(pCache, pBlkCache, false /*fOwnOnly*/, cbData,
+                                                   &pCache->LruRecentlyUsedIn, &pCache->LruRecentlyUsedOut,
+                                                   &pCache->LruFrequentlyUsed, &pCache->LruFrequentlyUsedOut,
+                                                   fReuseBuffer, ppbBuffer);
+        else
+            cbRemoved = pdmBlkCacheEvictPagesFrom2(pCache, pBlkCache, false /*fOwnOnly*/, cbData,
+                                                   &pCache->LruFrequentlyUsed, &pCache->LruFrequentlyUsedOut,
+                                                   &pCache->LruRecentlyUsedIn, &pCache->LruRecentlyUsedOut,
+                                                   fReuseBuffer, ppbBuffer);
+    }
+    else if ((pCache->LruRecentlyUsedIn.cbCached + cbData) > pCache->cbRecentlyUsedInMax)
+    {
+        /* Try to evict as many bytes as possible from A1in, the rest from Am. */
+        cbRemoved = pdmBlkCacheEvictPagesFrom2(pCache, pBlkCache, false /*fOwnOnly*/, cbData,
+                                               &pCache->LruRecentlyUsedIn, &pCache->LruRecentlyUsedOut,
+                                               &pCache->LruFrequentlyUsed, NULL,
+                                               fReuseBuffer, ppbBuffer);
     }
     else
     {
         /* We have to remove entries from frequently access list. */
-        cbRemoved = pdmBlkCacheEvictPagesFrom(pCache, cbData, &pCache->LruFrequentlyUsed,
-                                                 NULL, fReuseBuffer, ppbBuffer);
+        cbRemoved = pdmBlkCacheEvictPagesFrom(pCache, pBlkCache, false /*fOwnOnly*/, cbData,
+                                              &pCache->LruFrequentlyUsed, NULL, fReuseBuffer, ppbBuffer);
     }
 
     LogFlowFunc((": removed %u bytes, requested %u\n", cbRemoved, cbData));
     return (cbRemoved >= cbData);
 }
 
+/**
+ * Adapts the ARC target size of the recently used list after a ghost list hit.
+ *
+ * @param    pCache             Pointer to the global cache data.
+ * @param    pGhostList         The ghost list the entry was found in.
+ * @param    cbData             Size of the entry.
+ */
+static void pdmBlkCacheArcAdapt(PPDMBLKCACHEGLOBAL pCache, PPDMBLKLRULIST pGhostList, uint32_t cbData)
+{
+    PDMACFILECACHE_IS_CRITSECT_OWNER(pCache);
+
+    if (pCache->enmPolicy != PDMBLKCACHEPOLICY_ARC)
+        return;
+
+    uint64_t const cbB1 = pCache->LruRecentlyUsedOut.cbCached;
+    uint64_t const cbB2 = pCache->LruFrequentlyUsedOut.cbCached;
+    if (pGhostList == &pCache->LruRecentlyUsedOut)
+    {
+        /* Recently used data was evicted too early, grow T1. */
+        uint64_t cbDelta = (cbB1 && cbB2 > cbB1 ? cbB2 / cbB1 : 1) * cbData;
+        pCache->cbRecentlyUsedTarget = (uint32_t)RT_MIN(pCache->cbRecentlyUsedTarget + cbDelta, pCache->cbMax);
+    }
+    else
+    {
+        /* Frequently used data was evicted too early, shrink T1. */
+        uint64_t cbDelta = (cbB2 && cbB1 > cbB2 ? cbB1 / cbB2 : 1) * cbData;
+        pCache->cbRecentlyUsedTarget = pCache->cbRecentlyUsedTarget > cbDelta
+                                     ? pCache->cbRecentlyUsedTarget - (uint32_t)cbDelta
+                                     : 0;
+    }
+}
+
 DECLINLINE(int) pdmBlkCacheEnqueue(PPDMBLKCACHE pBlkCache, uint64_t off, size_t cbXfer, PPDMBLKCACHEIOXFER pIoXfer)
 {
     int rc = VINF_SUCCESS;
@@ -1005,7 +1175,7 @@ static DECLCALLBACK(int) pdmR3BlkCacheLoadExec(PVM pVM, PSSMHANDLE pSSM, uint32_
             /* Add to the dirty list. */
             pdmBlkCacheAddDirtyEntry(pBlkCache, pEntry);
             pdmBlkCacheEntryAddToList(&pBlkCacheGlobal->LruRecentlyUsedIn, pEntry);
-            pdmBlkCacheAdd(pBlkCacheGlobal, cbEntry);
+            pdmBlkCacheAdd(pBlkCacheGlobal, pBlkCache, cbEntry);
             pdmBlkCacheEntryRelease(pEntry);
             cEntries--;
         }
@@ -1069,6 +1239,10 @@ int pdmR3BlkCacheInit(PVM pVM)
     pBlkCacheGlobal->LruFrequentlyUsed.pTail    = NULL;
     pBlkCacheGlobal->LruFrequentlyUsed.cbCached = 0;
 
+    pBlkCacheGlobal->LruFrequentlyUsedOut.pHead    = NULL;
+    pBlkCacheGlobal->LruFrequentlyUsedOut.pTail    = NULL;
+    pBlkCacheGlobal->LruFrequentlyUsedOut.cbCached = 0;
+
     do
     {
         rc = CFGMR3QueryU32Def(pCfgBlkCache, "CacheSize", &pBlkCacheGlobal->cbMax, 5 * _1M);
@@ -1085,6 +1259,44 @@ int pdmR3BlkCacheInit(PVM pVM)
         AssertLogRelRCBreak(rc);
         rc = CFGMR3QueryU32Def(pCfgBlkCache, "CacheCommitThreshold", &pBlkCacheGlobal->cbCommitDirtyThreshold, pBlkCacheGlobal->cbMax / 2);
         AssertLogRelRCBreak(rc);
+
+        /*
+         * The replacement policy, "2Q" (default) or "ARC".  ARC starts out with
+         * an empty target for the recently used list and adapts it to the
+         * ghost list hits.
+         */
+        char szPolicy[16];
+        rc = CFGMR3QueryStringDef(pCfgBlkCache, "Policy", szPolicy, sizeof(szPolicy), "2Q");
+        AssertLogRelRCBreak(rc);
+        if (!RTStrICmp(szPolicy, "2Q"))
+            pBlkCacheGlobal->enmPolicy = PDMBLKCACHEPOLICY_2Q;
+        else if (!RTStrICmp(szPolicy, "ARC"))
+            pBlkCacheGlobal->enmPolicy = PDMBLKCACHEPOLICY_ARC;
+        else
+        {
+            rc = VMSetError(pVM, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                            N_("Configuration error: Unknown block cache policy \"%s\" (expected 2Q or ARC)"), szPolicy);
+            break;
+        }
+        pBlkCacheGlobal->cbRecentlyUsedTarget = 0;
+
+        /* Sequential streams bypass the cache once they transferred this many bytes, 0 disables the detection. */
+        rc = CFGMR3QueryU32Def(pCfgBlkCache, "SeqThreshold", &pBlkCacheGlobal->cbSeqThreshold, 0);
+        AssertLogRelRCBreak(rc);
+
+        /* Default minimum and maximum share of the cache for each user in percent, overridable per user. */
+        rc = CFGMR3QueryU8Def(pCfgBlkCache, "UserMinShare", &pBlkCacheGlobal->uMinSharePct, 0);
+        AssertLogRelRCBreak(rc);
+        rc = CFGMR3QueryU8Def(pCfgBlkCache, "UserMaxShare", &pBlkCacheGlobal->uMaxSharePct, 100);
+        AssertLogRelRCBreak(rc);
+        if (   pBlkCacheGlobal->uMaxSharePct > 100
+            || pBlkCacheGlobal->uMinSharePct > pBlkCacheGlobal->uMaxSharePct)
+        {
+            rc = VMSetError(pVM, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                            N_("Configuration error: Invalid block cache user shares (UserMinShare=%u UserMaxShare=%u)"),
+                            pBlkCacheGlobal->uMinSharePct, pBlkCacheGlobal->uMaxSharePct);
+            break;
+        }
     } while (0);
 
     if (RT_SUCCESS(rc))
@@ -1114,6 +1326,16 @@ int pdmR3BlkCacheInit(PVM pVM)
                        "/PDM/BlkCache/cbCachedFru",
                        STAMUNIT_BYTES,
                        "Number of bytes cached in FRU ghost list");
+        STAMR3Register(pVM, &pBlkCacheGlobal->LruFrequentlyUsedOut.cbCached,
+                       STAMTYPE_U32, STAMVISIBILITY_USED,
+                       "/PDM/BlkCache/cbCachedFruOut",
+                       STAMUNIT_BYTES,
+                       "Number of bytes cached in the FRU ghost list (ARC)");
+        STAMR3Register(pVM, &pBlkCacheGlobal->cbRecentlyUsedTarget,
+                       STAMTYPE_U32, STAMVISIBILITY_USED,
+                       "/PDM/BlkCache/cbMruTarget",
+                       STAMUNIT_BYTES,
+                       "Adaptive target size of the MRU list (ARC)");
 
 #ifdef VBOX_WITH_STATISTICS
         STAMR3Register(pVM, &pBlkCacheGlobal->cHits,
@@ -1177,6 +1399,10 @@ int pdmR3BlkCacheInit(PVM pVM)
                 LogRel(("BlkCache: Cache successfully initialized. Cache size is %u bytes\n", pBlkCacheGlobal->cbMax));
                 LogRel(("BlkCache: Cache commit interval is %u ms\n", pBlkCacheGlobal->u32CommitTimeoutMs));
                 LogRel(("BlkCache: Cache commit threshold is %u bytes\n", pBlkCacheGlobal->cbCommitDirtyThreshold));
+                LogRel(("BlkCache: Replacement policy is %s, sequential bypass threshold is %u bytes\n",
+                        pBlkCacheGlobal->enmPolicy == PDMBLKCACHEPOLICY_ARC ? "ARC" : "2Q", pBlkCacheGlobal->cbSeqThreshold));
+                LogRel(("BlkCache: Default user share is %u%% to %u%%\n",
+                        pBlkCacheGlobal->uMinSharePct, pBlkCacheGlobal->uMaxSharePct));
                 pUVM->pdm.s.pBlkCacheGlobal = pBlkCacheGlobal;
                 return VINF_SUCCESS;
             }
@@ -1204,6 +1430,7 @@ void pdmR3BlkCacheTerm(PVM pVM)
         pdmBlkCacheDestroyList(&pBlkCacheGlobal->LruRecentlyUsedIn);
         pdmBlkCacheDestroyList(&pBlkCacheGlobal->LruRecentlyUsedOut);
         pdmBlkCacheDestroyList(&pBlkCacheGlobal->LruFrequentlyUsed);
+        pdmBlkCacheDestroyList(&pBlkCacheGlobal->LruFrequentlyUsedOut);
 
         pdmBlkCacheLockLeave(pBlkCacheGlobal);
 
@@ -1270,6 +1497,41 @@ static int pdmR3BlkCacheRetain(PVM pVM, PPPDMBLKCACHE ppBlkCache, const char *pc
                     pBlkCache->pTree  = (PAVLRU64TREE)RTMemAllocZ(sizeof(AVLRFOFFTREE));
                     if (pBlkCache->pTree)
                     {
+                        /* Determine the share of the cache, /PDM/BlkCache/Users/<id>/ overrides the defaults. */
+                        PCFGMNODE pCfgUser = CFGMR3GetChildF(CFGMR3GetRoot(pVM), "PDM/BlkCache/Users/%s", pcszId);
+                        uint8_t uMinSharePct = pBlkCacheGlobal->uMinSharePct;
+                        uint8_t uMaxSharePct = pBlkCacheGlobal->uMaxSharePct;
+                        CFGMR3QueryU8Def(pCfgUser, "MinShare", &uMinSharePct, uMinSharePct);
+                        CFGMR3QueryU8Def(pCfgUser, "MaxShare", &uMaxSharePct, uMaxSharePct);
+                        uMaxSharePct = RT_MIN(uMaxSharePct, 100);
+                        uMinSharePct = RT_MIN(uMinSharePct, uMaxSharePct);
+                        pBlkCache->cbMinShare = (uint32_t)((uint64_t)pBlkCacheGlobal->cbMax * uMinSharePct / 100);
+                        pBlkCache->cbMaxShare = (uint32_t)((uint64_t)pBlkCacheGlobal->cbMax * uMaxSharePct / 100);
+
+                        STAMR3RegisterF(pBlkCacheGlobal->pVM, &pBlkCache->cbCached,
+                                        STAMTYPE_U32, STAMVISIBILITY_ALWAYS,
+                                        STAMUNIT_BYTES, "Number of bytes cached for this user",
+                                        "/PDM/BlkCache/%s/Cache/cbCached", pBlkCache->pszId);
+                        STAMR3RegisterF(pBlkCacheGlobal->pVM, &pBlkCache->StatHits,
+                                        STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS,
+                                        STAMUNIT_COUNT, "Number of requests completely served from the cache",
+                                        "/PDM/BlkCache/%s/Cache/Hits", pBlkCache->pszId);
+                        STAMR3RegisterF(pBlkCacheGlobal->pVM, &pBlkCache->StatPartialHits,
+                                        STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS,
+                                        STAMUNIT_COUNT, "Number of requests partially served from the cache",
+                                        "/PDM/BlkCache/%s/Cache/PartialHits", pBlkCache->pszId);
+                        STAMR3RegisterF(pBlkCacheGlobal->pVM, &pBlkCache->StatMisses,
+                                        STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS,
+                                        STAMUNIT_COUNT, "Number of requests not served from the cache",
+                                        "/PDM/BlkCache/%s/Cache/Misses", pBlkCache->pszId);
+                        STAMR3RegisterF(pBlkCacheGlobal->pVM, &pBlkCache->StatSeqBypassed,
+                                        STAMTYPE_COUNTER, STAMVISIBILITY_USED,
+                                        STAMUNIT_BYTES, "Number of bytes of sequential streams bypassing the cache",
+                                        "/PDM/BlkCache/%s/Cache/SeqBypassed", pBlkCache->pszId);
+                        STAMR3RegisterF(pBlkCacheGlobal->pVM, &pBlkCache->StatShareEvicted,
+                                        STAMTYPE_COUNTER, STAMVISIBILITY_USED,
+                                        STAMUNIT_BYTES, "Number of bytes evicted to stay within the maximum share",
+                                        "/PDM/BlkCache/%s/Cache/ShareEvicted", pBlkCache->pszId);
 #ifdef VBOX_WITH_STATISTICS
                         STAMR3RegisterF(pBlkCacheGlobal->pVM, &pBlkCache->StatWriteDeferred,
                                         STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS,
@@ -1447,7 +1709,7 @@ static DECLCALLBACK(int) pdmBlkCacheEntryDestroy(PAVLRU64NODECORE pNode, void *p
     pdmBlkCacheEntryRemoveFromList(pEntry);
 
     if (fUpdateCache)
-        pdmBlkCacheSub(pCache, pEntry->cbData);
+        pdmBlkCacheSub(pCache, pEntry->pBlkCache, pEntry->cbData);
 
     RTMemPageFree(pEntry->pbData, pEntry->cbData);
     RTMemFree(pEntry);
@@ -1484,9 +1746,7 @@ VMMR3DECL(void) PDMR3BlkCacheRelease(PPDMBLKCACHE pBlkCache)
     pBlkCache->pTree = NULL;
     RTSemRWDestroy(pBlkCache->SemRWEntries);
 
-#ifdef VBOX_WITH_STATISTICS
-    STAMR3DeregisterF(pCache->pVM->pUVM, "/PDM/BlkCache/%s/Cache/DeferredWrites", pBlkCache->pszId);
-#endif
+    STAMR3DeregisterF(pCache->pVM->pUVM, "/PDM/BlkCache/%s/Cache/*", pBlkCache->pszId);
 
     RTStrFree(pBlkCache->pszId);
     RTMemFree(pBlkCache);
@@ -1622,6 +1882,77 @@ static void pdmBlkCacheGetCacheBestFitEntryByOffset(PPDMBLKCACHE pBlkCache, uint
     STAM_PROFILE_ADV_STOP(&pBlkCache->pCache->StatTreeGet, Cache);
 }
 
+/**
+ * Returns how much of a request not covered by the cache can be passed through
+ * without overlapping the next cache entry.
+ *
+ * @returns Number of bytes to pass through.
+ * @param   pBlkCache    The endpoint cache.
+ * @param   off          The start offset.
+ * @param   cb           The number of bytes left in the request.
+ */
+static size_t pdmBlkCacheMissClip(PPDMBLKCACHE pBlkCache, uint64_t off, size_t cb)
+{
+    PPDMBLKCACHEENTRY pEntryAbove;
+    pdmBlkCacheGetCacheBestFitEntryByOffset(pBlkCache, off, &pEntryAbove);
+
+    if (pEntryAbove)
+    {
+        if (off + cb > pEntryAbove->Core.Key)
+            cb = pEntryAbove->Core.Key - off;
+
+        pdmBlkCacheEntryRelease(pEntryAbove);
+    }
+
+    return cb;
+}
+
+/**
+ * Feeds a request into the sequential stream detection.
+ *
+ * @returns Flag whether the request continues a sequential stream which
+ *          exceeded the configured threshold and should bypass the cache
+ *          where it misses.
+ * @param   pBlkCache    The endpoint cache.
+ * @param   off          The start offset of the request.
+ * @param   cb           The size of the request.
+ */
+static bool pdmBlkCacheSeqStreamUpdate(PPDMBLKCACHE pBlkCache, uint64_t off, size_t cb)
+{
+    uint32_t const cbSeqThreshold = pBlkCache->pCache->cbSeqThreshold;
+    if (!cbSeqThreshold)
+        return false;
+
+    bool fBypass = false;
+    RTSpinlockAcquire(pBlkCache->LockList);
+
+    PPDMBLKCACHESEQSTREAM pStream = NULL;
+    for (unsigned i = 0; i < RT_ELEMENTS(pBlkCache->aSeqStreams); i++)
+        if (   pBlkCache->aSeqStreams[i].cbRun
+            && pBlkCache->aSeqStreams[i].offNext == off)
+        {
+            pStream = &pBlkCache->aSeqStreams[i];
+            break;
+        }
+
+    if (pStream)
+    {
+        fBypass = pStream->cbRun >= cbSeqThreshold;
+        pStream->cbRun += cb;
+    }
+    else
+    {
+        /* Start tracking a new stream replacing the oldest one. */
+        pStream = &pBlkCache->aSeqStreams[pBlkCache->idxSeqStreamNext];
+        pBlkCache->idxSeqStreamNext = (pBlkCache->idxSeqStreamNext + 1) % RT_ELEMENTS(pBlkCache->aSeqStreams);
+        pStream->cbRun = cb;
+    }
+    pStream->offNext = off + cb;
+
+    RTSpinlockRelease(pBlkCache->LockList);
+    return fBypass;
+}
+
 static void pdmBlkCacheInsertEntry(PPDMBLKCACHE pBlkCache, PPDMBLKCACHEENTRY pEntry)
 {
     STAM_PROFILE_ADV_START(&pBlkCache->pCache->StatTreeInsert, Cache);
@@ -1854,7 +2185,7 @@ static PPDMBLKCACHEENTRY pdmBlkCacheEntryCreate(PPDMBLKCACHE pBlkCache, uint64_t
 
     PPDMBLKCACHEENTRY pEntryNew = NULL;
     uint8_t          *pbBuffer  = NULL;
-    bool fEnough = pdmBlkCacheReclaim(pCache, cbEntry, true, &pbBuffer);
+    bool fEnough = pdmBlkCacheReclaim(pCache, pBlkCache, cbEntry, false /*fGhostHitFrequent*/, true, &pbBuffer);
     if (fEnough)
     {
         LogFlow(("Evicted enough bytes (%u requested). Creating new cache entry\n", cbEntry));
@@ -1863,7 +2194,7 @@ static PPDMBLKCACHEENTRY pdmBlkCacheEntryCreate(PPDMBLKCACHE pBlkCache, uint64_t
         if (RT_LIKELY(pEntryNew))
         {
             pdmBlkCacheEntryAddToList(&pCache->LruRecentlyUsedIn, pEntryNew);
-            pdmBlkCacheAdd(pCache, cbEntry);
+            pdmBlkCacheAdd(pCache, pBlkCache, cbEntry);
             pdmBlkCacheLockLeave(pCache);
 
             pdmBlkCacheInsertEntry(pBlkCache, pEntryNew);
@@ -1975,6 +2306,10 @@ VMMR3DECL(int) PDMR3BlkCacheRead(PPDMBLKCACHE pBlkCache, uint64_t off,
     /* Increment data transfer counter to keep the request valid while we access it. */
     ASMAtomicIncU32(&pReq->cXfersPending);
 
+#ifdef VBOX_WITH_IO_READ_CACHE
+    bool const fSeqBypass = pdmBlkCacheSeqStreamUpdate(pBlkCache, off, cbRead);
+#endif
+
     while (cbRead)
     {
         size_t cbToRead;
@@ -2011,9 +2346,15 @@ VMMR3DECL(int) PDMR3BlkCacheRead(PPDMBLKCACHE pBlkCache, uint64_t off,
             cbRead  -= cbToRead;
 
             if (!cbRead)
+            {
                 STAM_COUNTER_INC(&pCache->cHits);
+                STAM_REL_COUNTER_INC(&pBlkCache->StatHits);
+            }
             else
+            {
                 STAM_COUNTER_INC(&pCache->cPartialHits);
+                STAM_REL_COUNTER_INC(&pBlkCache->StatPartialHits);
+            }
 
             STAM_COUNTER_ADD(&pCache->StatRead, cbToRead);
 
@@ -2037,8 +2378,9 @@ VMMR3DECL(int) PDMR3BlkCacheRead(PPDMBLKCACHE pBlkCache, uint64_t off,
                     RTSgBufCopyFromBuf(&SgBuf, pEntry->pbData + offDiff, cbToRead);
                 }
 
-                /* Move this entry to the top position */
-                if (pEntry->pList == &pCache->LruFrequentlyUsed)
+                /* Move this entry to the top position, ARC promotes recently used entries on the second hit. */
+                if (   pEntry->pList == &pCache->LruFrequentlyUsed
+                    || pCache->enmPolicy == PDMBLKCACHEPOLICY_ARC)
                 {
                     pdmBlkCacheLockEnter(pCache);
                     pdmBlkCacheEntryAddToList(&pCache->LruFrequentlyUsed, pEntry);
@@ -2054,14 +2396,16 @@ VMMR3DECL(int) PDMR3BlkCacheRead(PPDMBLKCACHE pBlkCache, uint64_t off,
                 LogFlow(("Fetching data for ghost entry %#p from file\n", pEntry));
 
                 pdmBlkCacheLockEnter(pCache);
+                bool fGhostHitFrequent = pEntry->pList == &pCache->LruFrequentlyUsedOut;
+                pdmBlkCacheArcAdapt(pCache, pEntry->pList, pEntry->cbData);
                 pdmBlkCacheEntryRemoveFromList(pEntry); /* Remove it before we remove data, otherwise it may get freed when evicting data. */
-                bool fEnough = pdmBlkCacheReclaim(pCache, pEntry->cbData, true, &pbBuffer);
+                bool fEnough = pdmBlkCacheReclaim(pCache, pBlkCache, pEntry->cbData, fGhostHitFrequent, true, &pbBuffer);
 
                 /* Move the entry to Am and fetch it to the cache. */
                 if (fEnough)
                 {
                     pdmBlkCacheEntryAddToList(&pCache->LruFrequentlyUsed, pEntry);
-                    pdmBlkCacheAdd(pCache, pEntry->cbData);
+                    pdmBlkCacheAdd(pCache, pBlkCache, pEntry->cbData);
                     pdmBlkCacheLockLeave(pCache);
 
                     if (pbBuffer)
@@ -2098,58 +2442,68 @@ VMMR3DECL(int) PDMR3BlkCacheRead(PPDMBLKCACHE pBlkCache, uint64_t off,
         else
         {
 #ifdef VBOX_WITH_IO_READ_CACHE
-            /* No entry found for this offset. Create a new entry and fetch the data to the cache. */
-            PPDMBLKCACHEENTRY pEntryNew = pdmBlkCacheEntryCreate(pBlkCache,
-                                                                 off, cbRead,
-                                                                 &cbToRead);
+            if (!fSeqBypass)
+            {
+                /* No entry found for this offset. Create a new entry and fetch the data to the cache. */
+                PPDMBLKCACHEENTRY pEntryNew = pdmBlkCacheEntryCreate(pBlkCache,
+                                                                     off, cbRead,
+                                                                     &cbToRead);
 
-            cbRead -= cbToRead;
+                cbRead -= cbToRead;
 
-            if (pEntryNew)
-            {
-                if (!cbRead)
-                    STAM_COUNTER_INC(&pCache->cMisses);
+                if (pEntryNew)
+                {
+                    if (!cbRead)
+                    {
+                        STAM_COUNTER_INC(&pCache->cMisses);
+                        STAM_REL_COUNTER_INC(&pBlkCache->StatMisses);
+                    }
+                    else
+                    {
+                        STAM_COUNTER_INC(&pCache->cPartialHits);
+                        STAM_REL_COUNTER_INC(&pBlkCache->StatPartialHits);
+                    }
+
+                    pdmBlkCacheEntryWaitersAdd(pEntryNew, pReq,
+                                               &SgBuf,
+                                               off - pEntryNew->Core.Key,
+                                               cbToRead,
+                                               false /* fWrite */);
+                    pdmBlkCacheEntryReadFromMedium(pEntryNew);
+                    pdmBlkCacheEntryRelease(pEntryNew); /* it is protected by the I/O in progress flag now. */
+                }
                 else
-                    STAM_COUNTER_INC(&pCache->cPartialHits);
-
-                pdmBlkCacheEntryWaitersAdd(pEntryNew, pReq,
-                                           &SgBuf,
-                                           off - pEntryNew->Core.Key,
-                                           cbToRead,
-                                           false /* fWrite */);
-                pdmBlkCacheEntryReadFromMedium(pEntryNew);
-                pdmBlkCacheEntryRelease(pEntryNew); /* it is protected by the I/O in progress flag now. */
+                {
+                    /*
+                     * There is not enough free space in the cache.
+                     * Pass the request directly to the I/O manager.
+                     */
+                    LogFlow(("Couldn't evict %u bytes from the cache. Remaining request will be passed through\n", cbToRead));
+
+                    STAM_REL_COUNTER_INC(&pBlkCache->StatMisses);
+                    pdmBlkCacheRequestPassthrough(pBlkCache, pReq,
+                                                  &SgBuf, off, cbToRead,
+                                                  PDMBLKCACHEXFERDIR_READ);
+                }
             }
             else
             {
-                /*
-                 * There is not enough free space in the cache.
-                 * Pass the request directly to the I/O manager.
-                 */
-                LogFlow(("Couldn't evict %u bytes from the cache. Remaining request will be passed through\n", cbToRead));
+                /* Part of a sequential stream, don't pollute the cache with it. */
+                cbToRead = pdmBlkCacheMissClip(pBlkCache, off, cbRead);
+                cbRead  -= cbToRead;
 
+                STAM_REL_COUNTER_INC(&pBlkCache->StatMisses);
+                STAM_REL_COUNTER_ADD(&pBlkCache->StatSeqBypassed, cbToRead);
                 pdmBlkCacheRequestPassthrough(pBlkCache, pReq,
                                               &SgBuf, off, cbToRead,
                                               PDMBLKCACHEXFERDIR_READ);
             }
 #else
             /* Clip read size if necessary. */
-            PPDMBLKCACHEENTRY pEntryAbove;
-            pdmBlkCacheGetCacheBestFitEntryByOffset(pBlkCache, off, &pEntryAbove);
-
-            if (pEntryAbove)
-            {
-                if (off + cbRead > pEntryAbove->Core.Key)
-                    cbToRead = pEntryAbove->Core.Key - off;
-                else
-                    cbToRead = cbRead;
-
-                pdmBlkCacheEntryRelease(pEntryAbove);
-            }
-            else
-                cbToRead = cbRead;
+            cbToRead = pdmBlkCacheMissClip(pBlkCache, off, cbRead);
+            cbRead  -= cbToRead;
 
-            cbRead -= cbToRead;
+            STAM_REL_COUNTER_INC(&pBlkCache->StatMisses);
             pdmBlkCacheRequestPassthrough(pBlkCache, pReq,
                                           &SgBuf, off, cbToRead,
                                           PDMBLKCACHEXFERDIR_READ);
@@ -2195,6 +2549,8 @@ VMMR3DECL(int) PDMR3BlkCacheWrite(PPDMBLKCACHE pBlkCache, uint64_t off, PCRTSGBU
     /* Increment data transfer counter to keep the request valid while we access it. */
     ASMAtomicIncU32(&pReq->cXfersPending);
 
+    bool const fSeqBypass = pdmBlkCacheSeqStreamUpdate(pBlkCache, off, cbWrite);
+
     while (cbWrite)
     {
         size_t cbToWrite;
@@ -2212,9 +2568,15 @@ VMMR3DECL(int) PDMR3BlkCacheWrite(PPDMBLKCACHE pBlkCache, uint64_t off, PCRTSGBU
             cbWrite  -= cbToWrite;
 
             if (!cbWrite)
+            {
                 STAM_COUNTER_INC(&pCache->cHits);
+                STAM_REL_COUNTER_INC(&pBlkCache->StatHits);
+            }
             else
+            {
                 STAM_COUNTER_INC(&pCache->cPartialHits);
+                STAM_REL_COUNTER_INC(&pBlkCache->StatPartialHits);
+            }
 
             STAM_COUNTER_ADD(&pCache->StatWritten, cbToWrite);
 
@@ -2268,8 +2630,9 @@ VMMR3DECL(int) PDMR3BlkCacheWrite(PPDMBLKCACHE pBlkCache, uint64_t off, PCRTSGBU
                     }
                 } /* Dirty bit not set */
 
-                /* Move this entry to the top position */
-                if (pEntry->pList == &pCache->LruFrequentlyUsed)
+                /* Move this entry to the top position, ARC promotes recently used entries on the second hit. */
+                if (   pEntry->pList == &pCache->LruFrequentlyUsed
+                    || pCache->enmPolicy == PDMBLKCACHEPOLICY_ARC)
                 {
                     pdmBlkCacheLockEnter(pCache);
                     pdmBlkCacheEntryAddToList(&pCache->LruFrequentlyUsed, pEntry);
@@ -2283,14 +2646,16 @@ VMMR3DECL(int) PDMR3BlkCacheWrite(PPDMBLKCACHE pBlkCache, uint64_t off, PCRTSGBU
                 uint8_t *pbBuffer = NULL;
 
                 pdmBlkCacheLockEnter(pCache);
+                bool fGhostHitFrequent = pEntry->pList == &pCache->LruFrequentlyUsedOut;
+                pdmBlkCacheArcAdapt(pCache, pEntry->pList, pEntry->cbData);
                 pdmBlkCacheEntryRemoveFromList(pEntry); /* Remove it before we remove data, otherwise it may get freed when evicting data. */
-                bool fEnough = pdmBlkCacheReclaim(pCache, pEntry->cbData, true, &pbBuffer);
+                bool fEnough = pdmBlkCacheReclaim(pCache, pBlkCache, pEntry->cbData, fGhostHitFrequent, true, &pbBuffer);
 
                 if (fEnough)
                 {
                     /* Move the entry to Am and fetch it to the cache. */
                     pdmBlkCacheEntryAddToList(&pCache->LruFrequentlyUsed, pEntry);
-                    pdmBlkCacheAdd(pCache, pEntry->cbData);
+                    pdmBlkCacheAdd(pCache, pBlkCache, pEntry->cbData);
                     pdmBlkCacheLockLeave(pCache);
 
                     if (pbBuffer)
@@ -2329,13 +2694,19 @@ VMMR3DECL(int) PDMR3BlkCacheWrite(PPDMBLKCACHE pBlkCache, uint64_t off, PCRTSGBU
         {
             /*
              * No entry found. Try to create a new cache entry to store the data in and if that fails
-             * write directly to the file.
+             * write directly to the file.  Sequential streams go directly to the file as well.
              */
-            PPDMBLKCACHEENTRY pEntryNew = pdmBlkCacheEntryCreate(pBlkCache,
-                                                                 off, cbWrite,
-                                                                 &cbToWrite);
+            PPDMBLKCACHEENTRY pEntryNew = NULL;
+            if (!fSeqBypass)
+                pEntryNew = pdmBlkCacheEntryCreate(pBlkCache, off, cbWrite, &cbToWrite);
+            else
+            {
+                cbToWrite = pdmBlkCacheMissClip(pBlkCache, off, cbWrite);
+                STAM_REL_COUNTER_ADD(&pBlkCache->StatSeqBypassed, cbToWrite);
+            }
 
             cbWrite -= cbToWrite;
+            STAM_REL_COUNTER_INC(&pBlkCache->StatMisses);
 
             if (pEntryNew)
             {
@@ -2486,6 +2857,7 @@ VMMR3DECL(int) PDMR3BlkCacheDiscard(PPDMBLKCACHE pBlkCache, PCRTRANGE paRanges,
                         {
                             pdmBlkCacheLockEnter(pCache);
                             pdmBlkCacheEntryRemoveFromList(pEntry);
+                            pdmBlkCacheSub(pCache, pBlkCache, pEntry->cbData);
 
                             STAM_PROFILE_ADV_START(&pCache->StatTreeRemove, Cache);
                             RTAvlrU64Remove(pBlkCache->pTree, pEntry->Core.Key);
@@ -2531,6 +2903,7 @@ VMMR3DECL(int) PDMR3BlkCacheDiscard(PPDMBLKCACHE pBlkCache, PCRTRANGE paRanges,
                         {
                             pdmBlkCacheLockEnter(pCache);
                             pdmBlkCacheEntryRemoveFromList(pEntry);
+                            pdmBlkCacheSub(pCache, pBlkCache, pEntry->cbData);
 
                             RTSemRWRequestWrite(pBlkCache->SemRWEntries, RT_INDEFINITE_WAIT);
                             STAM_PROFILE_ADV_START(&pCache->StatTreeRemove, Cache);
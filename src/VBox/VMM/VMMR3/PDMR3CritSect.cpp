@@ -33,6 +33,7 @@
 #include "PDMInternal.h"
 #include <VBox/vmm/pdmcritsect.h>
 #include <VBox/vmm/pdmcritsectrw.h>
+#include <VBox/vmm/dbgf.h>
 #include <VBox/vmm/mm.h>
 #include <VBox/vmm/vm.h>
 #include <VBox/vmm/uvm.h>
@@ -44,8 +45,10 @@
 #include <iprt/assert.h>
 #include <iprt/getopt.h>
 #include <iprt/lockvalidator.h>
+#include <iprt/mem.h>
 #include <iprt/string.h>
 #include <iprt/thread.h>
+#include <iprt/time.h>
 
 
 /*********************************************************************************************************************************
@@ -53,6 +56,7 @@
 *********************************************************************************************************************************/
 static int pdmR3CritSectDeleteOne(PVM pVM, PUVM pUVM, PPDMCRITSECTINT pCritSect, PPDMCRITSECTINT pPrev, bool fFinal);
 static int pdmR3CritSectRwDeleteOne(PVM pVM, PUVM pUVM, PPDMCRITSECTRWINT pCritSect, PPDMCRITSECTRWINT pPrev, bool fFinal);
+static PPDMCRITSECTPROF pdmR3CritSectProfCreate(PVM pVM, const char *pszName, bool fReadWrite);
 static FNDBGFINFOARGVINT pdmR3CritSectInfo;
 static FNDBGFINFOARGVINT pdmR3CritSectRwInfo;
 
@@ -98,6 +102,38 @@ int pdmR3CritSectBothInitStatsAndInfo(PVM pVM)
     STAM_REL_REG(pVM, &pVM->pdm.s.StatCritSectRwSharedNonInterruptibleWaits, STAMTYPE_COUNTER, "/PDM/CritSectsRw/00-Shared-Non-interruptible-Waits-VINF_SUCCESS",
                  STAMUNIT_OCCURENCES, "Number of non-interruptible waits for rcBusy=VINF_SUCCESS in exclusive mode");
 
+    /*
+     * Contention profiling.
+     */
+    /** @cfgm{/PDM/CritSectProfiling, string, none}
+     * Name pattern (RTStrSimplePatternMultiMatch, '|' separated) of the critical
+     * sections to collect a contention profile for.  This records wait and hold
+     * time histograms and the contending call sites in ring-3.  The data is
+     * shown by the 'critsect' and 'critsectrw' info items and the histograms
+     * are registered as statistics.  Disabled by default as it adds a few
+     * timestamp reads to the ring-3 lock paths of the matching sections. */
+    PUVM pUVM = pVM->pUVM;
+    char *pszPattern = NULL;
+    int rc = CFGMR3QueryStringAllocDef(CFGMR3GetChild(CFGMR3GetRoot(pVM), "PDM"), "CritSectProfiling", &pszPattern, NULL);
+    AssertLogRelRCReturn(rc, rc);
+    if (pszPattern && *pszPattern)
+    {
+        LogRel(("PDM: Profiling critical sections matching '%s'\n", pszPattern));
+        RTCritSectEnter(&pUVM->pdm.s.ListCritSect);
+        pUVM->pdm.s.pszCritSectProfPattern = pszPattern;
+
+        /* Pick up the sections created before PDM got initialized. */
+        for (PPDMCRITSECTINT pCur = pUVM->pdm.s.pCritSects; pCur; pCur = pCur->pNext)
+            if (!pCur->pProfR3)
+                ASMAtomicWritePtr(&pCur->pProfR3, pdmR3CritSectProfCreate(pVM, pCur->pszName, false /*fReadWrite*/));
+        for (PPDMCRITSECTRWINT pCur = pUVM->pdm.s.pRwCritSects; pCur; pCur = pCur->pNext)
+            if (!pCur->pProfR3)
+                ASMAtomicWritePtr(&pCur->pProfR3, pdmR3CritSectProfCreate(pVM, pCur->pszName, true /*fReadWrite*/));
+        RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
+    }
+    else
+        MMR3HeapFree(pszPattern);
+
     /*
      * Info items.
      */
@@ -150,6 +186,143 @@ VMMR3_INT_DECL(int) PDMR3CritSectBothTerm(PVM pVM)
 }
 
 
+/**
+ * Creates the contention profile for a critical section if profiling is
+ * enabled for it.
+ *
+ * @returns Pointer to the profile, NULL if not profiled.
+ * @param   pVM             The cross context VM structure.
+ * @param   pszName         The critical section name.
+ * @param   fReadWrite      Set if it's a read/write critical section.
+ *
+ * @remarks Caller must have entered the ListCritSect.
+ */
+static PPDMCRITSECTPROF pdmR3CritSectProfCreate(PVM pVM, const char *pszName, bool fReadWrite)
+{
+    const char * const pszPattern = pVM->pUVM->pdm.s.pszCritSectProfPattern;
+    if (   !pszPattern
+        || !RTStrSimplePatternMultiMatch(pszPattern, RTSTR_MAX, pszName, RTSTR_MAX, NULL))
+        return NULL;
+
+    /* Not using the MM heap as the final PDMR3CritSectBothTerm call comes after MMR3Term. */
+    PPDMCRITSECTPROF pProf = (PPDMCRITSECTPROF)RTMemAllocZ(sizeof(*pProf));
+    AssertReturn(pProf, NULL);
+    pProf->WaitHist.Core.cTicksMin       = UINT64_MAX;
+    pProf->WaitSharedHist.Core.cTicksMin = UINT64_MAX;
+    pProf->HoldHist.Core.cTicksMin       = UINT64_MAX;
+
+    if (!fReadWrite)
+    {
+        STAMR3RegisterF(pVM, &pProf->WaitHist, STAMTYPE_HISTOGRAM, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_OCCURENCE,
+                        "Ring-3 time spent waiting for the section.", "/PDM/CritSects/%s/ProfWait", pszName);
+        STAMR3RegisterF(pVM, &pProf->HoldHist, STAMTYPE_HISTOGRAM, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_OCCURENCE,
+                        "Time the section was owned after entering it in ring-3.", "/PDM/CritSects/%s/ProfHold", pszName);
+    }
+    else
+    {
+        STAMR3RegisterF(pVM, &pProf->WaitHist, STAMTYPE_HISTOGRAM, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_OCCURENCE,
+                        "Ring-3 time spent waiting for exclusive access.", "/PDM/CritSectsRw/%s/ProfWaitExcl", pszName);
+        STAMR3RegisterF(pVM, &pProf->WaitSharedHist, STAMTYPE_HISTOGRAM, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_OCCURENCE,
+                        "Ring-3 time spent waiting for shared access.", "/PDM/CritSectsRw/%s/ProfWaitShared", pszName);
+        STAMR3RegisterF(pVM, &pProf->HoldHist, STAMTYPE_HISTOGRAM, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_OCCURENCE,
+                        "Time the section was exclusively owned after entering it in ring-3.",
+                        "/PDM/CritSectsRw/%s/ProfHoldExcl", pszName);
+    }
+    return pProf;
+}
+
+
+/**
+ * Looks up or adds a call site in a contention profile.
+ *
+ * @returns Pointer to the call site entry, NULL if unknown or the table is full.
+ * @param   pProf           The contention profile.
+ * @param   uCaller         The call site address.
+ */
+static PPDMCRITSECTPROFCALLER pdmR3CritSectProfLookupCaller(PPDMCRITSECTPROF pProf, uint64_t uCaller)
+{
+    if (uCaller)
+        for (unsigned i = 0; i < RT_ELEMENTS(pProf->aCallers); i++)
+        {
+            PPDMCRITSECTPROFCALLER const pCaller = &pProf->aCallers[i];
+            uint64_t const               uCur    = ASMAtomicUoReadU64(&pCaller->uCaller);
+            if (uCur == uCaller)
+                return pCaller;
+            if (   uCur == 0
+                && (   ASMAtomicCmpXchgU64(&pCaller->uCaller, uCaller, 0)
+                    || ASMAtomicUoReadU64(&pCaller->uCaller) == uCaller))
+                return pCaller;
+        }
+    return NULL;
+}
+
+
+/**
+ * Called by the owner of a profiled critical section after entering it in
+ * ring-3 (exclusively).
+ *
+ * @param   pProf           The contention profile.
+ * @param   pSrcPos         The source position of the enter call, NULL if not
+ *                          known.
+ */
+void pdmR3CritSectProfEntered(PPDMCRITSECTPROF pProf, PCRTLOCKVALSRCPOS pSrcPos)
+{
+    pProf->nsEntered = RTTimeNanoTS();
+    ASMAtomicWriteU64(&pProf->uOwnerCaller, pSrcPos ? pSrcPos->uId : 0);
+}
+
+
+/**
+ * Called by the owner of a profiled critical section before it's leaving it
+ * for real in ring-3.
+ *
+ * @param   pProf           The contention profile.
+ */
+void pdmR3CritSectProfLeaving(PPDMCRITSECTPROF pProf)
+{
+    /* Sections entered in ring-0 and left here by the queued leave processing have no timestamp. */
+    uint64_t const nsEntered = pProf->nsEntered;
+    if (nsEntered)
+    {
+        pProf->nsEntered = 0;
+        STAM_REL_HISTOGRAM_ADD_PERIOD(&pProf->HoldHist, RTTimeNanoTS() - nsEntered);
+    }
+    ASMAtomicWriteU64(&pProf->uOwnerCaller, 0);
+}
+
+
+/**
+ * Called by a ring-3 thread after it waited for a profiled critical section.
+ *
+ * @param   pProf           The contention profile.
+ * @param   pHist           The wait histogram to update.
+ * @param   pSrcPos         The source position of the enter call, NULL if not
+ *                          known.
+ * @param   uOwnerCaller    The call site of the owner when the wait started.
+ * @param   nsWaitStart     RTTimeNanoTS when the wait started.
+ */
+void pdmR3CritSectProfWaited(PPDMCRITSECTPROF pProf, PSTAMHISTOGRAM pHist, PCRTLOCKVALSRCPOS pSrcPos,
+                             uint64_t uOwnerCaller, uint64_t nsWaitStart)
+{
+    /* Several waiters can get here at the same time (shared access), so everything must be atomic. */
+    uint64_t const cNsWaited = RTTimeNanoTS() - nsWaitStart;
+    STAM_REL_HISTOGRAM_ADD_PERIOD_ATOMIC(pHist, cNsWaited);
+
+    PPDMCRITSECTPROFCALLER pCaller = pdmR3CritSectProfLookupCaller(pProf, pSrcPos ? pSrcPos->uId : 0);
+    if (pCaller)
+    {
+        ASMAtomicIncU64(&pCaller->cWaits);
+        ASMAtomicAddU64(&pCaller->cNsWaited, cNsWaited);
+    }
+    else
+        ASMAtomicIncU64(&pProf->cWaitsOther);
+
+    pCaller = pdmR3CritSectProfLookupCaller(pProf, uOwnerCaller);
+    if (pCaller)
+        ASMAtomicIncU64(&pCaller->cBlocked);
+}
+
+
 /**
  * Initializes a critical section and inserts it into the list.
  *
@@ -235,6 +408,7 @@ static int pdmR3CritSectInitOne(PVM pVM, PPDMCRITSECTINT pCritSect, void *pvKey,
                  */
                 PUVM pUVM = pVM->pUVM;
                 RTCritSectEnter(&pUVM->pdm.s.ListCritSect);
+                pCritSect->pProfR3 = pdmR3CritSectProfCreate(pVM, pszName, false /*fReadWrite*/);
                 pCritSect->pNext = pUVM->pdm.s.pCritSects;
                 pUVM->pdm.s.pCritSects = pCritSect;
                 RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
@@ -344,6 +518,7 @@ static int pdmR3CritSectRwInitOne(PVM pVM, PPDMCRITSECTRWINT pCritSect, void *pv
                      */
                     PUVM pUVM = pVM->pUVM;
                     RTCritSectEnter(&pUVM->pdm.s.ListCritSect);
+                    pCritSect->pProfR3 = pdmR3CritSectProfCreate(pVM, pszName, true /*fReadWrite*/);
                     pCritSect->pNext = pUVM->pdm.s.pRwCritSects;
                     pUVM->pdm.s.pRwCritSects = pCritSect;
                     RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
@@ -574,6 +749,8 @@ static int pdmR3CritSectDeleteOne(PVM pVM, PUVM pUVM, PPDMCRITSECTINT pCritSect,
     pCritSect->pvKey   = NULL;
     if (!fFinal)
         STAMR3DeregisterF(pVM->pUVM, "/PDM/CritSects/%s/*", pCritSect->pszName);
+    RTMemFree(pCritSect->pProfR3);
+    pCritSect->pProfR3 = NULL;
     RTStrFree((char *)pCritSect->pszName);
     pCritSect->pszName = NULL;
     return rc;
@@ -642,6 +819,8 @@ static int pdmR3CritSectRwDeleteOne(PVM pVM, PUVM pUVM, PPDMCRITSECTRWINT pCritS
     pCritSect->pvKey   = NULL;
     if (!fFinal)
         STAMR3DeregisterF(pVM->pUVM, "/PDM/CritSectsRw/%s/*", pCritSect->pszName);
+    RTMemFree(pCritSect->pProfR3);
+    pCritSect->pProfR3 = NULL;
     RTStrFree((char *)pCritSect->pszName);
     pCritSect->pszName = NULL;
 
@@ -1090,6 +1269,117 @@ VMMR3DECL(PPDMCRITSECT)             PDMR3CritSectGetNop(PVM pVM)
 }
 
 
+/**
+ * Gets an approximate percentile from a contention profile histogram.
+ *
+ * @returns The upper bound of the bucket the percentile falls into, capped by
+ *          the maximum.
+ * @param   pHist       The histogram.
+ * @param   uPermille   The percentile in permille.
+ */
+static uint64_t pdmR3CritSectProfPercentile(PCSTAMHISTOGRAM pHist, uint32_t uPermille)
+{
+    uint64_t const cPeriods = pHist->Core.cPeriods;
+    uint64_t       cSoFar   = 0;
+    for (unsigned i = 0; i + 1 < RT_ELEMENTS(pHist->acBuckets); i++)
+    {
+        cSoFar += pHist->acBuckets[i];
+        if (cSoFar * 1000 >= cPeriods * uPermille)
+            return RT_MIN(RT_BIT_64(i + STAM_HISTOGRAM_FIRST_SHIFT), pHist->Core.cTicksMax);
+    }
+    return pHist->Core.cTicksMax;
+}
+
+
+/**
+ * Displays one contention profile histogram.
+ */
+static void pdmR3CritSectProfInfoHist(PCDBGFINFOHLP pHlp, const char *pszWhat, PCSTAMHISTOGRAM pHist)
+{
+    uint64_t const cPeriods = pHist->Core.cPeriods;
+    if (cPeriods)
+        pHlp->pfnPrintf(pHlp, "  %-11s %'12RU64 times, avg %'RU64 ns, p50 %'RU64 ns, p99 %'RU64 ns, max %'RU64 ns, total %'RU64 ns\n",
+                        pszWhat, cPeriods, pHist->Core.cTicks / cPeriods, pdmR3CritSectProfPercentile(pHist, 500),
+                        pdmR3CritSectProfPercentile(pHist, 990), pHist->Core.cTicksMax, pHist->Core.cTicks);
+    else
+        pHlp->pfnPrintf(pHlp, "  %-11s            0 times\n", pszWhat);
+}
+
+
+/**
+ * Displays the contention profile of a critical section.
+ *
+ * The call sites are host ring-3 return addresses.  They are resolved using
+ * the global DBGF address space, so the images need to be loaded into it
+ * (e.g. by the debugger's 'loadimage' command) to get symbols.
+ */
+static void pdmR3CritSectProfInfo(PUVM pUVM, PCDBGFINFOHLP pHlp, PPDMCRITSECTPROF pProf, bool fReadWrite, unsigned cVerbosity)
+{
+    pdmR3CritSectProfInfoHist(pHlp, fReadWrite ? "wait-excl:" : "wait:", &pProf->WaitHist);
+    if (fReadWrite)
+        pdmR3CritSectProfInfoHist(pHlp, "wait-shared:", &pProf->WaitSharedHist);
+    pdmR3CritSectProfInfoHist(pHlp, fReadWrite ? "hold-excl:" : "hold:", &pProf->HoldHist);
+
+    /*
+     * Take a snapshot of the call sites and list them by the time spent
+     * waiting and by the number of waits they caused as owners.
+     */
+    PDMCRITSECTPROFCALLER aCallers[PDMCRITSECTPROF_MAX_CALLERS];
+    unsigned              cCallers = 0;
+    for (unsigned i = 0; i < RT_ELEMENTS(pProf->aCallers); i++)
+        if (pProf->aCallers[i].uCaller)
+            aCallers[cCallers++] = pProf->aCallers[i];
+    unsigned const cMaxShown = cVerbosity > 1 ? RT_ELEMENTS(aCallers) : 5;
+
+    for (unsigned iPass = 0; iPass < 2; iPass++)
+    {
+        /* Insertion sort, descending. */
+        for (unsigned i = 1; i < cCallers; i++)
+        {
+            PDMCRITSECTPROFCALLER const Tmp = aCallers[i];
+            uint64_t const uKey = iPass == 0 ? Tmp.cNsWaited : Tmp.cBlocked;
+            unsigned j = i;
+            for (; j > 0 && (iPass == 0 ? aCallers[j - 1].cNsWaited : aCallers[j - 1].cBlocked) < uKey; j--)
+                aCallers[j] = aCallers[j - 1];
+            aCallers[j] = Tmp;
+        }
+
+        if (iPass == 0)
+            pHlp->pfnPrintf(pHlp, "  top waiters (%'RU64 other waits):\n", pProf->cWaitsOther);
+        else
+            pHlp->pfnPrintf(pHlp, "  top blocking owners:\n");
+        for (unsigned i = 0; i < RT_MIN(cCallers, cMaxShown); i++)
+        {
+            PDMCRITSECTPROFCALLER const *pCaller = &aCallers[i];
+            if (iPass == 0 ? !pCaller->cWaits : !pCaller->cBlocked)
+                break;
+
+            char        szWhat[64];
+            if (iPass == 0)
+                RTStrPrintf(szWhat, sizeof(szWhat), "%'RU64 waits, %'RU64 ns", pCaller->cWaits, pCaller->cNsWaited);
+            else
+                RTStrPrintf(szWhat, sizeof(szWhat), "%'RU64 blocked", pCaller->cBlocked);
+
+            DBGFADDRESS Addr;
+            RTGCINTPTR  offDisp = 0;
+            RTDBGMOD    hMod    = NIL_RTDBGMOD;
+            RTDBGSYMBOL Sym;
+            int rc = DBGFR3AsSymbolByAddr(pUVM, DBGF_AS_GLOBAL, DBGFR3AddrFromFlat(pUVM, &Addr, pCaller->uCaller),
+                                          RTDBGSYMADDR_FLAGS_LESS_OR_EQUAL | RTDBGSYMADDR_FLAGS_SKIP_ABS_IN_DEFERRED,
+                                          &offDisp, &Sym, &hMod);
+            if (RT_SUCCESS(rc))
+            {
+                pHlp->pfnPrintf(pHlp, "    %RX64 %s!%s+%#RX64: %s\n", pCaller->uCaller,
+                                hMod != NIL_RTDBGMOD ? RTDbgModName(hMod) : "", Sym.szName, (uint64_t)offDisp, szWhat);
+                RTDbgModRelease(hMod);
+            }
+            else
+                pHlp->pfnPrintf(pHlp, "    %RX64: %s\n", pCaller->uCaller, szWhat);
+        }
+    }
+}
+
+
 /**
  * Display matching critical sections.
  */
@@ -1167,6 +1457,12 @@ static void pdmR3CritSectInfoWorker(PUVM pUVM, const char *pszPatterns, PCDBGFIN
                 pHlp->pfnPrintf(pHlp, "  cLockers=%d cNestings=%d hOwner=%p %s%s\n", cLockers, cNestings, hOwner,
                                 pszOwner ? pszOwner : "???", fFlags & PDMCRITSECT_FLAGS_PENDING_UNLOCK ? " pending-unlock" : "");
             }
+
+            /*
+             * The contention profile, if enabled.
+             */
+            if (pCritSect->pProfR3)
+                pdmR3CritSectProfInfo(pUVM, pHlp, pCritSect->pProfR3, false /*fReadWrite*/, cVerbosity);
         }
     RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
 }
@@ -1255,6 +1551,12 @@ static void pdmR3CritSectInfoRwWorker(PUVM pUVM, const char *pszPatterns, PCDBGF
                     pHlp->pfnPrintf(pHlp, "  cNestings=%u cReadNestings=%u hWriter=%p %s\n",
                                     cWriteRecursions, cWriterReads, hOwner, pszOwner ? pszOwner : "???");
             }
+
+            /*
+             * The contention profile, if enabled.
+             */
+            if (pCritSect->pProfR3)
+                pdmR3CritSectProfInfo(pUVM, pHlp, pCritSect->pProfR3, true /*fReadWrite*/, cVerbosity);
         }
     RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
 }
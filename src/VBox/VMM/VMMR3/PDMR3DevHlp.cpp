@@ -276,6 +276,106 @@ static DECLCALLBACK(RTGCPHYS) pdmR3DevHlp_MmioGetMappingAddress(PPDMDEVINS pDevI
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR3,pfnMmioDoorbellRegister} */
+static DECLCALLBACK(int) pdmR3DevHlp_MmioDoorbellRegister(PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off, uint32_t cb,
+                                                          uint32_t fFlags, uint64_t uDataMatch, PFNIOMMMIODOORBELL pfnNotify,
+                                                          void *pvUser)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    LogFlow(("pdmR3DevHlp_MmioDoorbellRegister: caller='%s'/%d: hRegion=%#x off=%RGp cb=%u fFlags=%#x uDataMatch=%#RX64 pfnNotify=%p pvUser=%p\n",
+             pDevIns->pReg->szName, pDevIns->iInstance, hRegion, off, cb, fFlags, uDataMatch, pfnNotify, pvUser));
+    PVM pVM = pDevIns->Internal.s.pVMR3;
+    VM_ASSERT_EMT0_RETURN(pVM, VERR_VM_THREAD_NOT_EMT);
+
+    int rc = IOMR3MmioDoorbellRegister(pVM, pDevIns, hRegion, off, cb, fFlags, uDataMatch, pfnNotify, pvUser);
+
+    LogFlow(("pdmR3DevHlp_MmioDoorbellRegister: caller='%s'/%d: returns %Rrc\n", pDevIns->pReg->szName, pDevIns->iInstance, rc));
+    return rc;
+}
+
+
+/** @interface_method_impl{PDMDEVHLPR3,pfnMmioDoorbellDeregister} */
+static DECLCALLBACK(int) pdmR3DevHlp_MmioDoorbellDeregister(PPDMDEVINS pDevIns, IOMMMIOHANDLE hRegion, RTGCPHYS off)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    LogFlow(("pdmR3DevHlp_MmioDoorbellDeregister: caller='%s'/%d: hRegion=%#x off=%RGp\n",
+             pDevIns->pReg->szName, pDevIns->iInstance, hRegion, off));
+    PVM pVM = pDevIns->Internal.s.pVMR3;
+    VM_ASSERT_EMT_RETURN(pVM, VERR_VM_THREAD_NOT_EMT);
+
+    int rc = IOMR3MmioDoorbellDeregister(pVM, pDevIns, hRegion, off);
+
+    LogFlow(("pdmR3DevHlp_MmioDoorbellDeregister: caller='%s'/%d: returns %Rrc\n", pDevIns->pReg->szName, pDevIns->iInstance, rc));
+    return rc;
+}
+
+
+/** @interface_method_impl{PDMDEVHLPR3,pfnPhysMapCacheCreate} */
+static DECLCALLBACK(int) pdmR3DevHlp_PhysMapCacheCreate(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t cEntries,
+                                                        const char *pszName, PPDMPHYSMAPCACHE *ppCache)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    LogFlow(("pdmR3DevHlp_PhysMapCacheCreate: caller='%s'/%d: pPciDev=%p cEntries=%u pszName=%s ppCache=%p\n",
+             pDevIns->pReg->szName, pDevIns->iInstance, pPciDev, cEntries, pszName, ppCache));
+    AssertPtrReturn(ppCache, VERR_INVALID_POINTER);
+
+    int rc = pdmR3PhysMapCacheCreate(pDevIns->Internal.s.pVMR3, pDevIns, pPciDev, cEntries, pszName, ppCache);
+
+    LogFlow(("pdmR3DevHlp_PhysMapCacheCreate: caller='%s'/%d: returns %Rrc *ppCache=%p\n",
+             pDevIns->pReg->szName, pDevIns->iInstance, rc, *ppCache));
+    return rc;
+}
+
+
+/** @interface_method_impl{PDMDEVHLPR3,pfnPhysMapCacheDestroy} */
+static DECLCALLBACK(int) pdmR3DevHlp_PhysMapCacheDestroy(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    LogFlow(("pdmR3DevHlp_PhysMapCacheDestroy: caller='%s'/%d: pCache=%p\n", pDevIns->pReg->szName, pDevIns->iInstance, pCache));
+
+    int rc = pdmR3PhysMapCacheDestroy(pDevIns->Internal.s.pVMR3, pDevIns, pCache);
+
+    LogFlow(("pdmR3DevHlp_PhysMapCacheDestroy: caller='%s'/%d: returns %Rrc\n", pDevIns->pReg->szName, pDevIns->iInstance, rc));
+    return rc;
+}
+
+
+/** @interface_method_impl{PDMDEVHLPR3,pfnPhysMapCacheFlush} */
+static DECLCALLBACK(void) pdmR3DevHlp_PhysMapCacheFlush(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    LogFlow(("pdmR3DevHlp_PhysMapCacheFlush: caller='%s'/%d: pCache=%p\n", pDevIns->pReg->szName, pDevIns->iInstance, pCache));
+    pdmR3PhysMapCacheFlush(pDevIns->Internal.s.pVMR3, pCache);
+}
+
+
+/** @interface_method_impl{PDMDEVHLPR3,pfnPhysMapCacheMap} */
+static DECLCALLBACK(int) pdmR3DevHlp_PhysMapCacheMap(PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache, RTGCPHYS GCPhys,
+                                                     bool fWrite, void **ppv)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    AssertPtrReturn(pCache, VERR_INVALID_POINTER);
+    AssertReturn(pCache->pDevIns == pDevIns, VERR_INVALID_PARAMETER);
+    return pdmR3PhysMapCacheMap(pDevIns->Internal.s.pVMR3, pCache, GCPhys, fWrite, ppv);
+}
+
+
+/** @interface_method_impl{PDMDEVHLPR3,pfnPhysQueryRamMappings} */
+static DECLCALLBACK(int) pdmR3DevHlp_PhysQueryRamMappings(PPDMDEVINS pDevIns, PPGMPHYSRAMMAPPING paMappings,
+                                                          uint32_t cMaxMappings, uint32_t *pcMappings)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    LogFlow(("pdmR3DevHlp_PhysQueryRamMappings: caller='%s'/%d: paMappings=%p cMaxMappings=%u pcMappings=%p\n",
+             pDevIns->pReg->szName, pDevIns->iInstance, paMappings, cMaxMappings, pcMappings));
+
+    int rc = PGMR3PhysQueryRamMappings(pDevIns->Internal.s.pVMR3, paMappings, cMaxMappings, pcMappings);
+
+    LogFlow(("pdmR3DevHlp_PhysQueryRamMappings: caller='%s'/%d: returns %Rrc *pcMappings=%u\n",
+             pDevIns->pReg->szName, pDevIns->iInstance, rc, *pcMappings));
+    return rc;
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR3,pfnMmio2Create} */
 static DECLCALLBACK(int) pdmR3DevHlp_Mmio2Create(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t iPciRegion, RTGCPHYS cbRegion,
                                                  uint32_t fFlags, const char *pszDesc, void **ppvMapping, PPGMMMIO2HANDLE phRegion)
@@ -2556,6 +2656,64 @@ static DECLCALLBACK(void) pdmR3DevHlp_PCISetIrqNoWait(PPDMDEVINS pDevIns, PPDMPC
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR3,pfnPCISetIrqMulti} */
+static DECLCALLBACK(void) pdmR3DevHlp_PCISetIrqMulti(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs,
+                                                     uint32_t cIrqs, int iLevel)
+{
+    PDMDEV_ASSERT_DEVINS(pDevIns);
+    if (!pPciDev) /* NULL is an alias for the default PCI device. */
+        pPciDev = pDevIns->apPciDevs[0];
+    AssertReturnVoid(pPciDev);
+    LogFlow(("pdmR3DevHlp_PCISetIrqMulti: caller='%s'/%d: pPciDev=%p:{%#x} cIrqs=%u iLevel=%d\n",
+             pDevIns->pReg->szName, pDevIns->iInstance, pPciDev, pPciDev->uDevFn, cIrqs, iLevel));
+    PDMPCIDEV_ASSERT_VALID_AND_REGISTERED(pDevIns, pPciDev);
+
+    /*
+     * Validate input.
+     */
+    AssertPtrReturnVoid(pbmIrqs);
+    AssertReturnVoid(!(cIrqs & 31));
+    Assert((uint32_t)iLevel <= PDM_IRQ_LEVEL_FLIP_FLOP);
+
+    int32_t iIrq = ASMBitFirstSet(pbmIrqs, cIrqs);
+    if (iIrq < 0)
+        return;
+
+    PVM             pVM    = pDevIns->Internal.s.pVMR3;
+    size_t const    idxBus = pPciDev->Int.s.idxPdmBus;
+    AssertReturnVoid(idxBus < RT_ELEMENTS(pVM->pdm.s.aPciBuses));
+    PPDMPCIBUS      pBus   = &pVM->pdm.s.aPciBuses[idxBus];
+
+    /*
+     * Take the PDM lock and calculate the tag once for all the IRQs.
+     */
+    pdmLock(pVM);
+    uint32_t uTagSrc;
+    if (iLevel & PDM_IRQ_LEVEL_HIGH)
+    {
+        pDevIns->Internal.s.uLastIrqTag = uTagSrc = pdmCalcIrqTag(pVM, pDevIns->idTracing);
+        if (iLevel == PDM_IRQ_LEVEL_HIGH)
+            VBOXVMM_PDM_IRQ_HIGH(VMMGetCpu(pVM), RT_LOWORD(uTagSrc), RT_HIWORD(uTagSrc));
+        else
+            VBOXVMM_PDM_IRQ_HILO(VMMGetCpu(pVM), RT_LOWORD(uTagSrc), RT_HIWORD(uTagSrc));
+    }
+    else
+        uTagSrc = pDevIns->Internal.s.uLastIrqTag;
+
+    do
+    {
+        pBus->pfnSetIrqR3(pBus->pDevInsR3, pPciDev, iIrq, iLevel, uTagSrc);
+        iIrq = ASMBitNextSet(pbmIrqs, cIrqs, (uint32_t)iIrq);
+    } while (iIrq >= 0);
+
+    if (iLevel == PDM_IRQ_LEVEL_LOW)
+        VBOXVMM_PDM_IRQ_LOW(VMMGetCpu(pVM), RT_LOWORD(uTagSrc), RT_HIWORD(uTagSrc));
+    pdmUnlock(pVM);
+
+    LogFlow(("pdmR3DevHlp_PCISetIrqMulti: caller='%s'/%d: returns void\n", pDevIns->pReg->szName, pDevIns->iInstance));
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR3,pfnISASetIrq} */
 static DECLCALLBACK(void) pdmR3DevHlp_ISASetIrq(PPDMDEVINS pDevIns, int iIrq, int iLevel)
 {
@@ -2839,6 +2997,13 @@ static DECLCALLBACK(int) pdmR3DevHlp_QueueInsert(PPDMDEVINS pDevIns, PDMQUEUEHAN
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR3,pfnQueueFree} */
+static DECLCALLBACK(int) pdmR3DevHlp_QueueFree(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem)
+{
+    return PDMQueueFree(pDevIns->Internal.s.pVMR3, hQueue, pDevIns, pItem);
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR3,pfnQueueFlushIfNecessary} */
 static DECLCALLBACK(bool) pdmR3DevHlp_QueueFlushIfNecessary(PPDMDEVINS pDevIns, PDMQUEUEHANDLE hQueue)
 {
@@ -5239,6 +5404,7 @@ const PDMDEVHLPR3 g_pdmR3DevHlpTrusted =
     pdmR3DevHlp_PCIPhysBulkGCPhys2CCPtrReadOnly,
     pdmR3DevHlp_PCISetIrq,
     pdmR3DevHlp_PCISetIrqNoWait,
+    pdmR3DevHlp_PCISetIrqMulti,
     pdmR3DevHlp_ISASetIrq,
     pdmR3DevHlp_ISASetIrqNoWait,
     pdmR3DevHlp_DriverAttach,
@@ -5247,6 +5413,7 @@ const PDMDEVHLPR3 g_pdmR3DevHlpTrusted =
     pdmR3DevHlp_QueueCreate,
     pdmR3DevHlp_QueueAlloc,
     pdmR3DevHlp_QueueInsert,
+    pdmR3DevHlp_QueueFree,
     pdmR3DevHlp_QueueFlushIfNecessary,
     pdmR3DevHlp_TaskCreate,
     pdmR3DevHlp_TaskTrigger,
@@ -5335,13 +5502,13 @@ const PDMDEVHLPR3 g_pdmR3DevHlpTrusted =
     pdmR3DevHlp_CpuGetGuestMicroarch,
     pdmR3DevHlp_CpuGetGuestAddrWidths,
     pdmR3DevHlp_CpuGetGuestScalableBusFrequency,
-    0,
-    0,
-    0,
-    0,
-    0,
-    0,
-    0,
+    pdmR3DevHlp_MmioDoorbellRegister,
+    pdmR3DevHlp_MmioDoorbellDeregister,
+    pdmR3DevHlp_PhysMapCacheCreate,
+    pdmR3DevHlp_PhysMapCacheDestroy,
+    pdmR3DevHlp_PhysMapCacheFlush,
+    pdmR3DevHlp_PhysMapCacheMap,
+    pdmR3DevHlp_PhysQueryRamMappings,
     0,
     0,
     0,
@@ -5642,6 +5809,7 @@ const PDMDEVHLPR3 g_pdmR3DevHlpTracing =
     pdmR3DevHlp_PCIPhysBulkGCPhys2CCPtrReadOnly,
     pdmR3DevHlpTracing_PCISetIrq,
     pdmR3DevHlpTracing_PCISetIrqNoWait,
+    pdmR3DevHlpTracing_PCISetIrqMulti,
     pdmR3DevHlpTracing_ISASetIrq,
     pdmR3DevHlpTracing_ISASetIrqNoWait,
     pdmR3DevHlp_DriverAttach,
@@ -5650,6 +5818,7 @@ const PDMDEVHLPR3 g_pdmR3DevHlpTracing =
     pdmR3DevHlp_QueueCreate,
     pdmR3DevHlp_QueueAlloc,
     pdmR3DevHlp_QueueInsert,
+    pdmR3DevHlp_QueueFree,
     pdmR3DevHlp_QueueFlushIfNecessary,
     pdmR3DevHlp_TaskCreate,
     pdmR3DevHlp_TaskTrigger,
@@ -5738,13 +5907,13 @@ const PDMDEVHLPR3 g_pdmR3DevHlpTracing =
     pdmR3DevHlp_CpuGetGuestMicroarch,
     pdmR3DevHlp_CpuGetGuestAddrWidths,
     pdmR3DevHlp_CpuGetGuestScalableBusFrequency,
-    0,
-    0,
-    0,
-    0,
-    0,
-    0,
-    0,
+    pdmR3DevHlp_MmioDoorbellRegister,
+    pdmR3DevHlp_MmioDoorbellDeregister,
+    pdmR3DevHlp_PhysMapCacheCreate,
+    pdmR3DevHlp_PhysMapCacheDestroy,
+    pdmR3DevHlp_PhysMapCacheFlush,
+    pdmR3DevHlp_PhysMapCacheMap,
+    pdmR3DevHlp_PhysQueryRamMappings,
     0,
     0,
     0,
@@ -6373,6 +6542,7 @@ const PDMDEVHLPR3 g_pdmR3DevHlpUnTrusted =
     pdmR3DevHlp_PCIPhysBulkGCPhys2CCPtrReadOnly,
     pdmR3DevHlp_PCISetIrq,
     pdmR3DevHlp_PCISetIrqNoWait,
+    pdmR3DevHlp_PCISetIrqMulti,
     pdmR3DevHlp_ISASetIrq,
     pdmR3DevHlp_ISASetIrqNoWait,
     pdmR3DevHlp_DriverAttach,
@@ -6381,6 +6551,7 @@ const PDMDEVHLPR3 g_pdmR3DevHlpUnTrusted =
     pdmR3DevHlp_QueueCreate,
     pdmR3DevHlp_QueueAlloc,
     pdmR3DevHlp_QueueInsert,
+    pdmR3DevHlp_QueueFree,
     pdmR3DevHlp_QueueFlushIfNecessary,
     pdmR3DevHlp_TaskCreate,
     pdmR3DevHlp_TaskTrigger,
@@ -6469,13 +6640,13 @@ const PDMDEVHLPR3 g_pdmR3DevHlpUnTrusted =
     pdmR3DevHlp_CpuGetGuestMicroarch,
     pdmR3DevHlp_CpuGetGuestAddrWidths,
     pdmR3DevHlp_CpuGetGuestScalableBusFrequency,
-    0,
-    0,
-    0,
-    0,
-    0,
-    0,
-    0,
+    pdmR3DevHlp_MmioDoorbellRegister,
+    pdmR3DevHlp_MmioDoorbellDeregister,
+    pdmR3DevHlp_PhysMapCacheCreate,
+    pdmR3DevHlp_PhysMapCacheDestroy,
+    pdmR3DevHlp_PhysMapCacheFlush,
+    pdmR3DevHlp_PhysMapCacheMap,
+    pdmR3DevHlp_PhysQueryRamMappings,
     0,
     0,
     0,
@@ -538,6 +538,17 @@ DECL_HIDDEN_CALLBACK(void) pdmR3DevHlpTracing_PCISetIrqNoWait(PPDMDEVINS pDevIns
 }
 
 
+/** @interface_method_impl{PDMDEVHLPR3,pfnPCISetIrqMulti} */
+DECL_HIDDEN_CALLBACK(void) pdmR3DevHlpTracing_PCISetIrqMulti(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs,
+                                                             uint32_t cIrqs, int iLevel)
+{
+    /* Trace each IRQ individually, batching isn't a concern when tracing. */
+    AssertReturnVoid(!(cIrqs & 31));
+    for (int32_t iIrq = ASMBitFirstSet(pbmIrqs, cIrqs); iIrq >= 0; iIrq = ASMBitNextSet(pbmIrqs, cIrqs, (uint32_t)iIrq))
+        pdmR3DevHlpTracing_PCISetIrq(pDevIns, pPciDev, iIrq, iLevel);
+}
+
+
 /** @interface_method_impl{PDMDEVHLPR3,pfnISASetIrq} */
 DECL_HIDDEN_CALLBACK(void) pdmR3DevHlpTracing_ISASetIrq(PPDMDEVINS pDevIns, int iIrq, int iLevel)
 {
@@ -61,6 +61,7 @@
 #include <iprt/semaphore.h>
 #include <iprt/string.h>
 #include <iprt/thread.h>
+#include <iprt/time.h>
 
 
 /*********************************************************************************************************************************
@@ -559,7 +560,15 @@ int pdmR3DevInit(PVM pVM)
         RTCritSectRwLeaveExcl(&pVM->pdm.s.CoreListCritSectRw);
 
         Log(("PDM: Constructing device '%s' instance %d...\n", pDevIns->pReg->szName, pDevIns->iInstance));
+        uint64_t const nsConstructStart = RTTimeNanoTS();
         rc = pDevIns->pReg->pfnConstruct(pDevIns, pDevIns->iInstance, pDevIns->pCfg);
+        pDevIns->Internal.s.cNsConstruct = RTTimeNanoTS() - nsConstructStart;
+        STAMR3RegisterF(pVM, &pDevIns->Internal.s.cNsConstruct, STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_NS,
+                        "Time spent in the ring-3 constructor.", "/PDM/Startup/Devices/%s#%u",
+                        pDevIns->pReg->szName, pDevIns->iInstance);
+        if (pDevIns->Internal.s.cNsConstruct >= PDM_CONSTRUCT_SLOW_NS)
+            LogRel(("PDM: Constructing device '%s'/%d took %RU64 ms\n", pDevIns->pReg->szName, pDevIns->iInstance,
+                    pDevIns->Internal.s.cNsConstruct / RT_NS_1MS));
         if (RT_FAILURE(rc))
         {
             LogRel(("PDM: Failed to construct '%s'/%d! %Rra\n", pDevIns->pReg->szName, pDevIns->iInstance, rc));
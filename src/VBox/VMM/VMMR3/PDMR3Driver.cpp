@@ -48,6 +48,7 @@
 #include <iprt/ctype.h>
 #include <iprt/mem.h>
 #include <iprt/thread.h>
+#include <iprt/time.h>
 #include <iprt/path.h>
 #include <iprt/string.h>
 
@@ -837,10 +838,19 @@ int pdmR3DrvInstantiate(PVM pVM, PCFGMNODE pNode, PPDMIBASE pBaseInterface, PPDM
                      * of the constructor engaging with PDM asynchronously via another thread.
                      */
                     RTCritSectRwLeaveExcl(&pVM->pdm.s.CoreListCritSectRw);
+                    uint64_t const nsConstructStart = RTTimeNanoTS();
                     rc = pDrv->pReg->pfnConstruct(pNew, pNew->pCfg, 0 /*fFlags*/);
+                    pNew->Internal.s.cNsConstruct = RTTimeNanoTS() - nsConstructStart;
                     RTCritSectRwEnterExcl(&pVM->pdm.s.CoreListCritSectRw);
+                    if (pNew->Internal.s.cNsConstruct >= PDM_CONSTRUCT_SLOW_NS)
+                        LogRel(("PDM: Constructing driver '%s'/%d took %RU64 ms\n", pDrv->pReg->szName, pNew->iInstance,
+                                pNew->Internal.s.cNsConstruct / RT_NS_1MS));
                     if (RT_SUCCESS(rc))
                     {
+                        STAMR3RegisterF(pVM, &pNew->Internal.s.cNsConstruct, STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_NS,
+                                        "Time spent in the constructor.", "/PDM/Startup/Drivers/%s#%u",
+                                        pDrv->pReg->szName, pNew->iInstance);
+
                         AssertPtr(pNew->IBase.pfnQueryInterface);
                         Assert(pNew->IBase.pfnQueryInterface(&pNew->IBase, PDMIBASE_IID) == &pNew->IBase);
 
@@ -1074,6 +1084,9 @@ void pdmR3DrvDestroyChain(PVM pVM, PPDMDRVINS pDrvIns, uint32_t fFlags)
         /*
          * Free all resources allocated by the driver.
          */
+        /* Startup timeline statistic (not registered if the constructor failed). */
+        STAMR3DeregisterByAddr(pVM->pUVM, &pCur->Internal.s.cNsConstruct);
+
         /* Queues. */
         int rc = PDMR3QueueDestroyDriver(pVM, pCur);
         AssertRC(rc);
@@ -1477,6 +1490,13 @@ static DECLCALLBACK(int) pdmR3DrvHlp_QueueInsert(PPDMDRVINS pDrvIns, PDMQUEUEHAN
 }
 
 
+/** @interface_method_impl{PDMDRVHLPR3,pfnQueueFree} */
+static DECLCALLBACK(int) pdmR3DrvHlp_QueueFree(PPDMDRVINS pDrvIns, PDMQUEUEHANDLE hQueue, PPDMQUEUEITEMCORE pItem)
+{
+    return PDMQueueFree(pDrvIns->Internal.s.pVMR3, hQueue, pDrvIns, pItem);
+}
+
+
 /** @interface_method_impl{PDMDRVHLPR3,pfnQueueFlushIfNecessary} */
 static DECLCALLBACK(bool) pdmR3DrvHlp_QueueFlushIfNecessary(PPDMDRVINS pDrvIns, PDMQUEUEHANDLE hQueue)
 {
@@ -2291,6 +2311,7 @@ const PDMDRVHLPR3 g_pdmR3DrvHlp =
     pdmR3DrvHlp_QueueCreate,
     pdmR3DrvHlp_QueueAlloc,
     pdmR3DrvHlp_QueueInsert,
+    pdmR3DrvHlp_QueueFree,
     pdmR3DrvHlp_QueueFlushIfNecessary,
     pdmR3DrvHlp_TMGetVirtualFreq,
     pdmR3DrvHlp_TMGetVirtualTime,
@@ -224,6 +224,7 @@ static void pdmR3NsUnchokeGroupFilters(PPDMNSBWGROUP pGroup)
         bool fChoked = ASMAtomicXchgBool(&pFilter->fChoked, false);
         if (fChoked)
         {
+            STAM_REL_PROFILE_ADD_PERIOD(&pGroup->StatChokeLatency, RTTimeSystemNanoTS() - ASMAtomicReadU64(&pFilter->nsChoked));
             PPDMINETWORKDOWN pIDrvNet = pFilter->pIDrvNetR3;
             if (pIDrvNet && pIDrvNet->pfnXmitPending != NULL)
             {
@@ -247,7 +248,12 @@ static void pdmR3NsUnchokeGroupFilters(PPDMNSBWGROUP pGroup)
  */
 static uint32_t pdmNsBwGroupSetLimit(PPDMNSBWGROUP pGroup, uint64_t cbPerSecMax)
 {
-    uint32_t const cbRet = RT_MAX(PDM_NETSHAPER_MIN_BUCKET_SIZE, cbPerSecMax * PDM_NETSHAPER_MAX_LATENCY / RT_MS_1SEC);
+    uint64_t cbBucket = RT_MAX(PDM_NETSHAPER_MIN_BUCKET_SIZE, cbPerSecMax * PDM_NETSHAPER_MAX_LATENCY / RT_MS_1SEC);
+    /* The configured burst may enlarge the bucket up to one second worth of
+       traffic, which is as far as the refill calculation goes. */
+    if (pGroup->cbBurst > cbBucket)
+        cbBucket = RT_MIN(pGroup->cbBurst, RT_MAX(cbPerSecMax, cbBucket));
+    uint32_t const cbRet = (uint32_t)RT_MIN(cbBucket, UINT32_MAX);
     pGroup->cbBucket     = cbRet;
     pGroup->cbPerSecMax  = cbPerSecMax;
     LogFlow(("pdmNsBwGroupSetLimit: New rate limit is %#RX64 bytes per second, adjusted bucket size to %#x bytes\n",
@@ -256,6 +262,25 @@ static uint32_t pdmNsBwGroupSetLimit(PPDMNSBWGROUP pGroup, uint64_t cbPerSecMax)
 }
 
 
+/**
+ * Worker for pdmR3NetShaperInit that sets the packet rate limit of a group.
+ *
+ * @returns New packet bucket size in milli-packets.
+ * @param   pGroup              The group to update.
+ * @param   cPacketsPerSecMax   The new max packets per second, zero for no limit.
+ */
+static uint32_t pdmNsBwGroupSetPacketLimit(PPDMNSBWGROUP pGroup, uint32_t cPacketsPerSecMax)
+{
+    /* Same latency based bucket as for bytes, but always room for at least one packet. */
+    uint32_t const cRet       = RT_MAX(1000, cPacketsPerSecMax * PDM_NETSHAPER_MAX_LATENCY);
+    pGroup->cMilliPktBucket   = cRet;
+    pGroup->cPacketsPerSecMax = cPacketsPerSecMax;
+    LogFlow(("pdmNsBwGroupSetPacketLimit: New rate limit is %u packets per second, adjusted bucket size to %#x milli-packets\n",
+             cPacketsPerSecMax, cRet));
+    return cRet;
+}
+
+
 /**
  * Adjusts the maximum rate for the bandwidth group.
  *
@@ -352,9 +377,10 @@ static DECLCALLBACK(int) pdmR3NsUnchokeThread(PVM pVM, PPDMTHREAD pThread)
         size_t const cGroups = RT_MIN(pVM->pdm.s.cNsGroups, RT_ELEMENTS(pVM->pdm.s.aNsGroups));
         for (size_t i = 0; i < cGroups; i++)
         {
+            /* Note! Check all groups with filters attached, as the filters
+                     may have been choked by a limit of an ancestor group. */
             PPDMNSBWGROUP const pGroup = &pVM->pdm.s.aNsGroups[i];
-            if (   pGroup->cRefs > 0
-                && pGroup->cbPerSecMax > 0)
+            if (pGroup->cRefs > 0)
                 pdmR3NsUnchokeGroupFilters(pGroup);
         }
 
@@ -472,6 +498,22 @@ int pdmR3NetShaperInit(PVM pVM)
                                                     N_("Failed to read 'Max' value for network shaper group '%s': %Rrc"),
                                                     szName, rc));
 
+            uint32_t cbBurst;
+            rc = CFGMR3QueryU32Def(pCur, "Burst", &cbBurst, 0);
+            AssertRCBreakStmt(rc, rc = VMR3SetError(pVM->pUVM, rc, RT_SRC_POS,
+                                                    N_("Failed to read 'Burst' value for network shaper group '%s': %Rrc"),
+                                                    szName, rc));
+
+            uint32_t cPacketsMax;
+            rc = CFGMR3QueryU32Def(pCur, "MaxPackets", &cPacketsMax, 0);
+            AssertRCBreakStmt(rc, rc = VMR3SetError(pVM->pUVM, rc, RT_SRC_POS,
+                                                    N_("Failed to read 'MaxPackets' value for network shaper group '%s': %Rrc"),
+                                                    szName, rc));
+            AssertBreakStmt(cPacketsMax <= _4M,
+                            rc = VMR3SetError(pVM->pUVM, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                                              N_("The 'MaxPackets' value for network shaper group '%s' is too large: %u, max %u"),
+                                              szName, cPacketsMax, _4M));
+
             /*
              * Initialize the group table entry.
              */
@@ -485,11 +527,15 @@ int pdmR3NetShaperInit(PVM pVM)
             RTListInit(&pVM->pdm.s.aNsGroups[iGroup].FilterList);
             pVM->pdm.s.aNsGroups[iGroup].cRefs          = 0;
             RTStrCopy(pVM->pdm.s.aNsGroups[iGroup].szName, sizeof(pVM->pdm.s.aNsGroups[iGroup].szName), szName);
+            pVM->pdm.s.aNsGroups[iGroup].iParent        = 0; /* Resolved below. */
+            pVM->pdm.s.aNsGroups[iGroup].cbBurst        = cbBurst;
             pVM->pdm.s.aNsGroups[iGroup].cbTokensLast   = pdmNsBwGroupSetLimit(&pVM->pdm.s.aNsGroups[iGroup], cbMax);
+            pVM->pdm.s.aNsGroups[iGroup].cMilliPktTokensLast = pdmNsBwGroupSetPacketLimit(&pVM->pdm.s.aNsGroups[iGroup],
+                                                                                          cPacketsMax);
             pVM->pdm.s.aNsGroups[iGroup].tsUpdatedLast  = RTTimeSystemNanoTS();
-            LogFlowFunc(("PDM NetShaper Group #%u: %s - cbPerSecMax=%#RU64 cbBucket=%#x\n",
+            LogFlowFunc(("PDM NetShaper Group #%u: %s - cbPerSecMax=%#RU64 cbBucket=%#x cPacketsPerSecMax=%u\n",
                          iGroup, pVM->pdm.s.aNsGroups[iGroup].szName, pVM->pdm.s.aNsGroups[iGroup].cbPerSecMax,
-                         pVM->pdm.s.aNsGroups[iGroup].cbBucket));
+                         pVM->pdm.s.aNsGroups[iGroup].cbBucket, cPacketsMax));
 
             /*
              * Register statistics.
@@ -506,9 +552,58 @@ int pdmR3NetShaperInit(PVM pVM)
                             STAMUNIT_NS, "", "/PDM/NetShaper/%u-%s/tsUpdatedLast", iGroup, szName);
             STAMR3RegisterF(pVM, (void *)&pVM->pdm.s.aNsGroups[iGroup].cTotalChokings,  STAMTYPE_U64_RESET, STAMVISIBILITY_ALWAYS,
                             STAMUNIT_OCCURENCES, "", "/PDM/NetShaper/%u-%s/TotalChokings", iGroup, szName);
+            STAMR3RegisterF(pVM, (void *)&pVM->pdm.s.aNsGroups[iGroup].cPacketsPerSecMax, STAMTYPE_U32, STAMVISIBILITY_ALWAYS,
+                            STAMUNIT_OCCURENCES, "", "/PDM/NetShaper/%u-%s/cPacketsPerSecMax", iGroup, szName);
+            STAMR3RegisterF(pVM, (void *)&pVM->pdm.s.aNsGroups[iGroup].cbTotalTransferred, STAMTYPE_U64_RESET, STAMVISIBILITY_ALWAYS,
+                            STAMUNIT_BYTES, "", "/PDM/NetShaper/%u-%s/TotalBytes", iGroup, szName);
+            STAMR3RegisterF(pVM, (void *)&pVM->pdm.s.aNsGroups[iGroup].cTotalPackets,   STAMTYPE_U64_RESET, STAMVISIBILITY_ALWAYS,
+                            STAMUNIT_OCCURENCES, "", "/PDM/NetShaper/%u-%s/TotalPackets", iGroup, szName);
+            STAMR3RegisterF(pVM, &pVM->pdm.s.aNsGroups[iGroup].StatChokeLatency,        STAMTYPE_PROFILE, STAMVISIBILITY_USED,
+                            STAMUNIT_NS_PER_OCCURENCE, "Time filters spent choked", "/PDM/NetShaper/%u-%s/ChokeLatency",
+                            iGroup, szName);
 
             pVM->pdm.s.cNsGroups = ++iGroup;
         }
+
+        /*
+         * Link up the hierarchy now that all groups are known.  A group limits
+         * the traffic of its own filters as well as that of all its descendants.
+         */
+        iGroup = 0;
+        for (PCFGMNODE pCur = CFGMR3GetFirstChild(pCfgBwGrp); pCur && RT_SUCCESS(rc); pCur = CFGMR3GetNextChild(pCur), iGroup++)
+        {
+            PPDMNSBWGROUP const pGroup = &pVM->pdm.s.aNsGroups[iGroup];
+            char szParent[PDM_NET_SHAPER_MAX_NAME_LEN + 1];
+            rc = CFGMR3QueryStringDef(pCur, "Parent", szParent, sizeof(szParent), "");
+            AssertRCBreakStmt(rc, rc = VMR3SetError(pVM->pUVM, rc, RT_SRC_POS,
+                                                    N_("Failed to read 'Parent' value for network shaper group '%s': %Rrc"),
+                                                    pGroup->szName, rc));
+            if (szParent[0] == '\0')
+                continue;
+
+            PPDMNSBWGROUP const pParent = pdmNsBwGroupFindByName(pVM, szParent);
+            AssertBreakStmt(pParent && pParent != pGroup,
+                            rc = VMR3SetError(pVM->pUVM, VERR_NOT_FOUND, RT_SRC_POS,
+                                              N_("Invalid parent '%s' for network shaper group '%s'"),
+                                              szParent, pGroup->szName));
+            pGroup->iParent = (uint32_t)(pParent - &pVM->pdm.s.aNsGroups[0]) + 1;
+        }
+
+        for (iGroup = 0; iGroup < pVM->pdm.s.cNsGroups && RT_SUCCESS(rc); iGroup++)
+        {
+            uint32_t cDepth = 1;
+            for (uint32_t iParent = pVM->pdm.s.aNsGroups[iGroup].iParent; iParent; iParent = pVM->pdm.s.aNsGroups[iParent - 1].iParent)
+                if (++cDepth > PDM_NETSHAPER_MAX_DEPTH)
+                {
+                    rc = VMR3SetError(pVM->pUVM, VERR_TOO_MUCH_DATA, RT_SRC_POS,
+                                      N_("Network shaper group '%s' is nested too deep or part of a loop (max depth %u)"),
+                                      pVM->pdm.s.aNsGroups[iGroup].szName, PDM_NETSHAPER_MAX_DEPTH);
+                    break;
+                }
+            if (pVM->pdm.s.aNsGroups[iGroup].iParent)
+                LogRel(("PDM: NetShaper group '%s' is a child of '%s'\n", pVM->pdm.s.aNsGroups[iGroup].szName,
+                        pVM->pdm.s.aNsGroups[pVM->pdm.s.aNsGroups[iGroup].iParent - 1].szName));
+        }
     }
     if (RT_SUCCESS(rc))
     {
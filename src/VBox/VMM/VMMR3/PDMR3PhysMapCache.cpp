@@ -0,0 +1,319 @@
+/* $Id$ */
+/** @file
+ * PDM - Pluggable Device Manager, Guest Physical Mapping Cache.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#define LOG_GROUP LOG_GROUP_PDM_DEVICE
+#include "PDMInternal.h"
+#include <VBox/vmm/pdm.h>
+#include <VBox/vmm/pdmphysmapcache.h>
+#include <VBox/vmm/pgm.h>
+#include <VBox/vmm/mm.h>
+#include <VBox/vmm/stam.h>
+#include <VBox/vmm/vm.h>
+#include <VBox/vmm/uvm.h>
+#include <VBox/err.h>
+
+#include <VBox/log.h>
+#include <iprt/asm.h>
+#include <iprt/assert.h>
+#include <iprt/critsect.h>
+#include <iprt/string.h>
+
+
+/**
+ * Releases the mapping of a cache entry, if any.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pEntry      The entry.
+ */
+DECLINLINE(void) pdmR3PhysMapCacheEntryRelease(PVM pVM, PPDMPHYSMAPCACHEENTRY pEntry)
+{
+    if (pEntry->GCPhysPage != NIL_RTGCPHYS)
+    {
+        PGMPhysReleasePageMappingLock(pVM, &pEntry->Lock);
+        pEntry->GCPhysPage = NIL_RTGCPHYS;
+        pEntry->pbPage     = NULL;
+    }
+}
+
+
+/**
+ * Creates a guest physical mapping cache for a device.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pDevIns     The device instance.
+ * @param   pPciDev     The PCI device to do the accesses on behalf of, NULL
+ *                      for the default one.
+ * @param   cEntries    The number of entries, 0 for the default.  Rounded up
+ *                      to a power of two.
+ * @param   pszName     The cache name, used for the statistics.  Must be
+ *                      unique for the device instance.
+ * @param   ppCache     Where to return the cache handle.
+ */
+int pdmR3PhysMapCacheCreate(PVM pVM, PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t cEntries, const char *pszName,
+                            PPDMPHYSMAPCACHE *ppCache)
+{
+    *ppCache = NULL;
+    if (!pPciDev) /* NULL is an alias for the default PCI device. */
+        pPciDev = pDevIns->apPciDevs[0];
+    AssertReturn(pPciDev, VERR_PDM_NOT_PCI_DEVICE);
+    AssertPtrReturn(pszName, VERR_INVALID_POINTER);
+    AssertReturn(cEntries <= PDMPHYSMAPCACHE_ENTRIES_MAX, VERR_OUT_OF_RANGE);
+    if (!cEntries)
+        cEntries = PDMPHYSMAPCACHE_ENTRIES_DEF;
+    if (!RT_IS_POWER_OF_TWO(cEntries))
+        cEntries = RT_BIT_32(ASMBitLastSetU32(cEntries));
+
+    PPDMPHYSMAPCACHE pCache = (PPDMPHYSMAPCACHE)MMR3HeapAllocZ(pVM, MM_TAG_PDM_DEVICE_USER,
+                                                               RT_UOFFSETOF_DYN(PDMPHYSMAPCACHE, aEntries[cEntries]));
+    if (!pCache)
+        return VERR_NO_MEMORY;
+
+    pCache->u32Magic = PDMPHYSMAPCACHE_MAGIC;
+    pCache->fIdxMask = cEntries - 1;
+    pCache->puGen    = PGMR3PhysGetMapGenerationPtr(pVM);
+    pCache->pDevIns  = pDevIns;
+    pCache->pPciDev  = pPciDev;
+    for (uint32_t i = 0; i < cEntries; i++)
+        pCache->aEntries[i].GCPhysPage = NIL_RTGCPHYS;
+
+    /*
+     * Statistics, using the same prefix as the device helpers.
+     */
+    char szPrefix[128];
+    if (pDevIns->pReg->cMaxInstances == 1)
+        RTStrPrintf(szPrefix, sizeof(szPrefix), "/Devices/%s/PhysMapCache/%s", pDevIns->pReg->szName, pszName);
+    else
+        RTStrPrintf(szPrefix, sizeof(szPrefix), "/Devices/%s#%u/PhysMapCache/%s",
+                    pDevIns->pReg->szName, pDevIns->iInstance, pszName);
+    STAMR3RegisterF(pVM, &pCache->StatHits,        STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                    "Accesses satisfied by a valid cache entry.",          "%s/Hits", szPrefix);
+    STAMR3RegisterF(pVM, &pCache->StatMisses,      STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                    "Accesses requiring the page to be mapped.",           "%s/Misses", szPrefix);
+    STAMR3RegisterF(pVM, &pCache->StatStale,       STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                    "Entries invalidated by the PGM mapping generation.",  "%s/Stale", szPrefix);
+    STAMR3RegisterF(pVM, &pCache->StatUncacheable, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                    "Accesses to pages which could not be mapped.",        "%s/Uncacheable", szPrefix);
+    STAMR3RegisterF(pVM, &pCache->StatFlushes,     STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                    "Explicit cache flushes.",                             "%s/Flushes", szPrefix);
+
+    /*
+     * Link it.
+     */
+    PUVM pUVM = pVM->pUVM;
+    RTCritSectEnter(&pUVM->pdm.s.ListCritSect);
+    pCache->pNext = pUVM->pdm.s.pPhysMapCaches;
+    pUVM->pdm.s.pPhysMapCaches = pCache;
+    RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
+
+    Log(("pdmR3PhysMapCacheCreate: %s/%u: created '%s' with %u entries\n",
+         pDevIns->pReg->szName, pDevIns->iInstance, pszName, cEntries));
+    *ppCache = pCache;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Releases all the mappings held by a cache.
+ *
+ * The caller must make sure nobody is using the cache concurrently.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pCache      The cache.
+ */
+void pdmR3PhysMapCacheFlush(PVM pVM, PPDMPHYSMAPCACHE pCache)
+{
+    AssertPtrReturnVoid(pCache);
+    AssertReturnVoid(pCache->u32Magic == PDMPHYSMAPCACHE_MAGIC);
+
+    STAM_COUNTER_INC(&pCache->StatFlushes);
+    for (uint32_t i = 0; i <= pCache->fIdxMask; i++)
+        pdmR3PhysMapCacheEntryRelease(pVM, &pCache->aEntries[i]);
+}
+
+
+/**
+ * Flushes and frees a cache.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pCache      The cache, must be unlinked already.
+ */
+static void pdmR3PhysMapCacheFree(PVM pVM, PPDMPHYSMAPCACHE pCache)
+{
+    for (uint32_t i = 0; i <= pCache->fIdxMask; i++)
+        pdmR3PhysMapCacheEntryRelease(pVM, &pCache->aEntries[i]);
+
+    PUVM pUVM = pVM->pUVM;
+    STAMR3DeregisterByAddr(pUVM, &pCache->StatHits);
+    STAMR3DeregisterByAddr(pUVM, &pCache->StatMisses);
+    STAMR3DeregisterByAddr(pUVM, &pCache->StatStale);
+    STAMR3DeregisterByAddr(pUVM, &pCache->StatUncacheable);
+    STAMR3DeregisterByAddr(pUVM, &pCache->StatFlushes);
+
+    pCache->u32Magic = ~PDMPHYSMAPCACHE_MAGIC;
+    pCache->pNext    = NULL;
+    MMR3HeapFree(pCache);
+}
+
+
+/**
+ * Destroys a guest physical mapping cache.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pDevIns     The device instance owning the cache.
+ * @param   pCache      The cache, NULL is quietly ignored.
+ */
+int pdmR3PhysMapCacheDestroy(PVM pVM, PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache)
+{
+    if (!pCache)
+        return VINF_SUCCESS;
+    AssertPtrReturn(pCache, VERR_INVALID_POINTER);
+    AssertReturn(pCache->u32Magic == PDMPHYSMAPCACHE_MAGIC, VERR_INVALID_MAGIC);
+    AssertReturn(pCache->pDevIns == pDevIns, VERR_INVALID_PARAMETER);
+
+    PUVM pUVM = pVM->pUVM;
+    RTCritSectEnter(&pUVM->pdm.s.ListCritSect);
+    PPDMPHYSMAPCACHE pPrev = NULL;
+    PPDMPHYSMAPCACHE pCur  = pUVM->pdm.s.pPhysMapCaches;
+    while (pCur && pCur != pCache)
+    {
+        pPrev = pCur;
+        pCur  = pCur->pNext;
+    }
+    if (pCur)
+    {
+        if (pPrev)
+            pPrev->pNext = pCur->pNext;
+        else
+            pUVM->pdm.s.pPhysMapCaches = pCur->pNext;
+    }
+    RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
+    AssertReturn(pCur, VERR_NOT_FOUND);
+
+    pdmR3PhysMapCacheFree(pVM, pCache);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Destroys all the guest physical mapping caches of a device.
+ *
+ * Called when the device is destroyed.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pDevIns     The device instance.
+ */
+void pdmR3PhysMapCacheDestroyDevice(PVM pVM, PPDMDEVINS pDevIns)
+{
+    PUVM pUVM = pVM->pUVM;
+    RTCritSectEnter(&pUVM->pdm.s.ListCritSect);
+    PPDMPHYSMAPCACHE pPrev = NULL;
+    PPDMPHYSMAPCACHE pCur  = pUVM->pdm.s.pPhysMapCaches;
+    while (pCur)
+    {
+        PPDMPHYSMAPCACHE pNext = pCur->pNext;
+        if (pCur->pDevIns == pDevIns)
+        {
+            if (pPrev)
+                pPrev->pNext = pNext;
+            else
+                pUVM->pdm.s.pPhysMapCaches = pNext;
+            pdmR3PhysMapCacheFree(pVM, pCur);
+        }
+        else
+            pPrev = pCur;
+        pCur = pNext;
+    }
+    RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
+}
+
+
+/**
+ * Maps a guest page into the cache, the slow path of PDMDevHlpPhysMapCacheMap.
+ *
+ * Any previous mapping in the entry slot is released first.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NOT_SUPPORTED if an IOMMU is present, as the translation may
+ *          change behind our back.
+ * @retval  VERR_PGM_PHYS_PAGE_RESERVED and friends if the page can't be mapped
+ *          (MMIO, etc).
+ * @param   pVM         The cross context VM structure.
+ * @param   pCache      The cache.
+ * @param   GCPhys      The guest physical address.
+ * @param   fWrite      Whether to map the page writable.
+ * @param   ppv         Where to return the pointer corresponding to @a GCPhys.
+ */
+int pdmR3PhysMapCacheMap(PVM pVM, PPDMPHYSMAPCACHE pCache, RTGCPHYS GCPhys, bool fWrite, void **ppv)
+{
+    AssertPtrReturn(pCache, VERR_INVALID_POINTER);
+    AssertReturn(pCache->u32Magic == PDMPHYSMAPCACHE_MAGIC, VERR_INVALID_MAGIC);
+    PPDMDEVINS const            pDevIns    = pCache->pDevIns;
+    RTGCPHYS const              GCPhysPage = GCPhys & ~(RTGCPHYS)GUEST_PAGE_OFFSET_MASK;
+    PPDMPHYSMAPCACHEENTRY const pEntry     = &pCache->aEntries[PDMPHYSMAPCACHE_IDX(pCache, GCPhys)];
+
+    /* Read the generation before mapping anything, so an invalidation racing
+       us makes the new entry stale rather than leaving a bad one behind. */
+    uint32_t const uGen = *pCache->puGen;
+    if (pEntry->GCPhysPage == GCPhysPage && pEntry->uGen != uGen)
+        STAM_COUNTER_INC(&pCache->StatStale);
+    else
+        STAM_COUNTER_INC(&pCache->StatMisses);
+    pdmR3PhysMapCacheEntryRelease(pVM, pEntry);
+
+    int rc;
+#if defined(VBOX_WITH_IOMMU_AMD) || defined(VBOX_WITH_IOMMU_INTEL)
+    if (pdmIommuIsPresent(pDevIns))
+        rc = VERR_NOT_SUPPORTED;
+    else
+#endif
+    if (fWrite)
+        rc = pDevIns->pHlpR3->pfnPCIPhysGCPhys2CCPtr(pDevIns, pCache->pPciDev, GCPhysPage, 0 /*fFlags*/,
+                                                      (void **)&pEntry->pbPage, &pEntry->Lock);
+    else
+        rc = pDevIns->pHlpR3->pfnPCIPhysGCPhys2CCPtrReadOnly(pDevIns, pCache->pPciDev, GCPhysPage, 0 /*fFlags*/,
+                                                              (void const **)&pEntry->pbPage, &pEntry->Lock);
+    if (RT_SUCCESS(rc))
+    {
+        pEntry->GCPhysPage = GCPhysPage;
+        pEntry->uGen       = uGen;
+        pEntry->fWritable  = fWrite;
+        *ppv = pEntry->pbPage + (GCPhys & GUEST_PAGE_OFFSET_MASK);
+        return VINF_SUCCESS;
+    }
+
+    STAM_COUNTER_INC(&pCache->StatUncacheable);
+    pEntry->pbPage = NULL;
+    *ppv = NULL;
+    return rc;
+}
+
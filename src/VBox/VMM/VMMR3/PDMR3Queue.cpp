@@ -41,7 +41,9 @@
 #include <iprt/asm.h>
 #include <iprt/assert.h>
 #include <iprt/mem.h>
+#include <iprt/string.h>
 #include <iprt/thread.h>
+#include <iprt/time.h>
 
 
 /*********************************************************************************************************************************
@@ -49,6 +51,48 @@
 *********************************************************************************************************************************/
 static int                  pdmR3QueueDestroyLocked(PVM pVM, PDMQUEUEHANDLE hQueue, void *pvOwner);
 static DECLCALLBACK(void)   pdmR3QueueTimer(PVM pVM, TMTIMERHANDLE hTimer, void *pvUser);
+static DECLCALLBACK(void)   pdmR3QueueConsumerTask(PVM pVM, void *pvUser);
+
+
+
+/**
+ * Checks if the queue name matches the pattern in the given /PDM config value.
+ *
+ * @returns true if it matches, false if not or the value is not present.
+ * @param   pVM         The cross context VM structure.
+ * @param   pszValue    The name of the pattern value under /PDM.
+ * @param   pszName     The queue name.
+ */
+static bool pdmR3QueueNameMatchesConfig(PVM pVM, const char *pszValue, const char *pszName)
+{
+    char *pszPattern = NULL;
+    int rc = CFGMR3QueryStringAllocDef(CFGMR3GetChild(CFGMR3GetRoot(pVM), "PDM"), pszValue, &pszPattern, NULL);
+    AssertLogRelRCReturn(rc, false);
+    bool const fMatch = pszPattern
+                     && *pszPattern
+                     && RTStrSimplePatternMultiMatch(pszPattern, RTSTR_MAX, pszName, RTSTR_MAX, NULL);
+    MMR3HeapFree(pszPattern);
+    return fMatch;
+}
+
+
+/**
+ * Checks whether a queue has items ready for flushing.
+ *
+ * @returns true if it has, false if not.
+ * @param   pQueue      The queue.
+ */
+DECLINLINE(bool) pdmR3QueueHasPending(PPDMQUEUE pQueue)
+{
+    if (!(pQueue->fFlags & PDMQUEUE_F_RING))
+        return ASMAtomicUoReadU32(&pQueue->iPending) != UINT32_MAX;
+
+    /* The slot at the consumer position is ready when its sequence number is one past the position. */
+    uint64_t const          uPos  = ASMAtomicUoReadU64(&pQueue->uRingConsumer);
+    PPDMQUEUEITEMCORE const pSlot = (PPDMQUEUEITEMCORE)((uint8_t *)pQueue + pQueue->offItems
+                                                        + (uint32_t)(uPos % pQueue->cItems) * pQueue->cbItem);
+    return ASMAtomicUoReadU64(&pSlot->u64View) == uPos + 1;
+}
 
 
 
@@ -98,6 +142,22 @@ static int pdmR3QueueCreateLocked(PVM pVM, size_t cbItem, uint32_t cItems, uint3
 #endif
         fRZEnabled = false;
 
+    /** @cfgm{/PDM/QueueRing, string, none}
+     * Name pattern (RTStrSimplePatternMultiMatch, '|' separated) of the queues
+     * to operate as lock-free multi-producer, single-consumer rings
+     * (PDMQUEUE_F_RING).  The items are then flushed in FIFO order and the
+     * queue depth and insert to flush latency are reported as statistics. */
+    uint32_t fFlags = 0;
+    if (pdmR3QueueNameMatchesConfig(pVM, "QueueRing", pszName))
+        fFlags |= PDMQUEUE_F_RING;
+    /** @cfgm{/PDM/QueueConsumerThread, string, none}
+     * Name pattern (RTStrSimplePatternMultiMatch, '|' separated) of the queues
+     * to flush on a PDM task thread instead of waking up an EMT with
+     * VM_FF_PDM_QUEUES.  Only use this for queues whose consumer callbacks do
+     * not need to run on an EMT.  Ignored for queues with a polling interval. */
+    if (!cMilliesInterval && pdmR3QueueNameMatchesConfig(pVM, "QueueConsumerThread", pszName))
+        fFlags |= PDMQUEUE_F_CONSUMER_THREAD;
+
     /* Unqiue name that fits within the szName field: */
     size_t cchName = strlen(pszName);
     AssertReturn(cchName > 0, VERR_INVALID_NAME);
@@ -124,6 +184,7 @@ static int pdmR3QueueCreateLocked(PVM pVM, size_t cbItem, uint32_t cItems, uint3
         Req.cItems       = cItems;
         Req.cbItem       = (uint32_t)cbItem;
         Req.enmType      = enmType;
+        Req.fFlags       = fFlags;
         Req.pvOwner      = pvOwner;
         Req.pfnCallback  = (RTR3PTR)uCallback;
         RTStrCopy(Req.szName, sizeof(Req.szName), pszName);
@@ -141,6 +202,7 @@ static int pdmR3QueueCreateLocked(PVM pVM, size_t cbItem, uint32_t cItems, uint3
         AssertReturn(pQueue->cbItem == cbItem, VERR_INTERNAL_ERROR_4);
         AssertReturn(pQueue->cItems == cItems, VERR_INTERNAL_ERROR_4);
         AssertReturn(pQueue->enmType == enmType, VERR_INTERNAL_ERROR_4);
+        AssertReturn(pQueue->fFlags == fFlags, VERR_INTERNAL_ERROR_4);
         AssertReturn(pQueue->u.Gen.pvOwner == pvOwner, VERR_INTERNAL_ERROR_4);
         AssertReturn(pQueue->u.Gen.pfnCallback == (RTR3PTR)uCallback, VERR_INTERNAL_ERROR_4);
     }
@@ -148,14 +210,14 @@ static int pdmR3QueueCreateLocked(PVM pVM, size_t cbItem, uint32_t cItems, uint3
 #endif
     {
         /* Do it here using the paged heap: */
-        uint32_t const cbBitmap = RT_ALIGN_32(RT_ALIGN_32(cItems, 64) / 8, 64); /* keep bitmap in it's own cacheline  */
+        uint32_t const cbBitmap = PDMQUEUE_CALC_BITMAP_SIZE(cItems, fFlags);
         uint32_t const cbQueue  = RT_OFFSETOF(PDMQUEUE, bmAlloc)
                                 + cbBitmap
                                 + (uint32_t)cbItem * cItems;
         pQueue = (PPDMQUEUE)RTMemPageAllocZ(cbQueue);
         if (!pQueue)
             return VERR_NO_PAGE_MEMORY;
-        pdmQueueInit(pQueue, cbBitmap, (uint32_t)cbItem, cItems, pszName, enmType, (RTR3PTR)uCallback, pvOwner);
+        pdmQueueInit(pQueue, cbBitmap, (uint32_t)cbItem, cItems, fFlags, pszName, enmType, (RTR3PTR)uCallback, pvOwner);
 
         uint32_t iQueue = pVM->pdm.s.cRing3Queues;
         if (iQueue >= pVM->pdm.s.cRing3QueuesAlloc)
@@ -209,6 +271,24 @@ static int pdmR3QueueCreateLocked(PVM pVM, size_t cbItem, uint32_t cItems, uint3
         }
     }
 
+    /*
+     * Create the consumer task?  Falls back on the force action flag if this
+     * fails (e.g. when not on EMT(0) or when out of ring-0 task slots).
+     */
+    if (fFlags & PDMQUEUE_F_CONSUMER_THREAD)
+    {
+        PDMTASKHANDLE hTask = NIL_PDMTASKHANDLE;
+        int rc = PDMR3TaskCreateInternal(pVM, fRZEnabled ? PDMTASK_F_RZ : 0, pQueue->szName,
+                                         pdmR3QueueConsumerTask, pQueue, &hTask);
+        if (RT_SUCCESS(rc))
+            ASMAtomicWriteU64(&pQueue->hConsumerTask, hTask);
+        else
+            LogRel(("PDM: Failed to create consumer task for queue '%s', using the EMTs instead: %Rrc\n", pQueue->szName, rc));
+    }
+    if (fFlags)
+        LogRel(("PDM: Queue '%s':%s%s\n", pQueue->szName, fFlags & PDMQUEUE_F_RING ? " ring" : "",
+                pQueue->hConsumerTask != NIL_PDMTASKHANDLE ? " consumer-thread" : ""));
+
     /*
      * Register the statistics.
      */
@@ -232,6 +312,13 @@ static int pdmR3QueueCreateLocked(PVM pVM, size_t cbItem, uint32_t cItems, uint3
     STAMR3RegisterF(pVM, (void *)&pQueue->cStatPending, STAMTYPE_U32,     STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
                     "Pending items.",                   "/PDM/Queue/%s/Pending",        pQueue->szName);
 #endif
+    if (fFlags & PDMQUEUE_F_RING)
+    {
+        STAMR3RegisterF(pVM, &pQueue->StatRingDepth,    STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                        "Items in the ring when flushing.", "/PDM/Queue/%s/RingDepth",  pQueue->szName);
+        STAMR3RegisterF(pVM, &pQueue->StatRingLatency,  STAMTYPE_HISTOGRAM, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_OCCURENCE,
+                        "Insert to flush latency.",     "/PDM/Queue/%s/RingLatency",    pQueue->szName);
+    }
 
     *phQueue = hQueue;
     return VINF_SUCCESS;
@@ -466,6 +553,13 @@ static int pdmR3QueueDestroyLocked(PVM pVM, PDMQUEUEHANDLE hQueue, void *pvOwner
         AssertReturn(pQueue->u32Magic == PDMQUEUE_MAGIC, VERR_INVALID_HANDLE);
         AssertReturn(pQueue->u.Gen.pvOwner == pvOwner, VERR_INVALID_HANDLE);
 
+        /* Get rid of the consumer task first, this waits for it if it's busy flushing the queue. */
+        if (pQueue->hConsumerTask != NIL_PDMTASKHANDLE)
+        {
+            PDMR3TaskDestroyInternal(pVM, pQueue->hConsumerTask);
+            pQueue->hConsumerTask = NIL_PDMTASKHANDLE;
+        }
+
         /* Enter the lock here to serialize with other EMTs traversing the handles. */
         pdmLock(pVM);
         pVM->pdm.s.papRing3Queues[hQueue] = NULL;
@@ -627,6 +721,97 @@ DECLINLINE(void) pdmR3QueueFreeItem(PPDMQUEUE pQueue, uint8_t *pbItems, uint32_t
 
 
 
+/**
+ * Feeds one item to the consumer callback of a queue.
+ *
+ * @returns The callback result, false if the item should be retried later.
+ * @param   pVM     The cross context VM structure.
+ * @param   pQueue  The queue.
+ * @param   pItem   The item.
+ */
+DECLINLINE(bool) pdmR3QueueConsumeOne(PVM pVM, PPDMQUEUE pQueue, PPDMQUEUEITEMCORE pItem)
+{
+    switch (pQueue->enmType)
+    {
+        case PDMQUEUETYPE_DEV:
+            return pQueue->u.Dev.pfnCallback(pQueue->u.Dev.pDevIns, pItem);
+        case PDMQUEUETYPE_DRV:
+            return pQueue->u.Drv.pfnCallback(pQueue->u.Drv.pDrvIns, pItem);
+        case PDMQUEUETYPE_INTERNAL:
+            return pQueue->u.Int.pfnCallback(pVM, pItem);
+        case PDMQUEUETYPE_EXTERNAL:
+            return pQueue->u.Ext.pfnCallback(pQueue->u.Ext.pvUser, pItem);
+        default:
+            AssertMsgFailedReturn(("Invalid queue type %d\n", pQueue->enmType), false);
+    }
+}
+
+
+/**
+ * Process pending items in one PDMQUEUE_F_RING queue.
+ *
+ * This takes a snapshot of the producer position and feeds the consumer
+ * everything up to it that has been inserted, in FIFO order, as one batch.
+ * Items inserted while the batch is being processed are left for the next
+ * flush.
+ *
+ * @returns VBox status code.
+ * @param   pVM     The cross context VM structure.
+ * @param   pQueue  The queue needing flushing.
+ */
+static int pdmR3QueueFlushRing(PVM pVM, PPDMQUEUE pQueue)
+{
+    STAM_PROFILE_START(&pQueue->StatFlushPrf,p);
+
+    uint32_t const          cbItem  = pQueue->cbItem;
+    uint32_t const          cItems  = pQueue->cItems;
+    uint8_t * const         pbItems = (uint8_t *)pQueue + pQueue->offItems;
+    uint64_t volatile * const pauTs = (uint64_t volatile *)&pQueue->bmAlloc[0];
+
+    uint64_t       uPos    = pQueue->uRingConsumer;
+    uint64_t const uEnd    = ASMAtomicReadU64(&pQueue->uRingProducer);
+    uint64_t const nsBatch = RTTimeNanoTS();
+    STAM_REL_PROFILE_ADD_PERIOD(&pQueue->StatRingDepth, uEnd - uPos);
+    Log2(("pdmR3QueueFlushRing: pQueue=%p enmType=%d uPos=%#RX64 uEnd=%#RX64\n", pQueue, pQueue->enmType, uPos, uEnd));
+
+    while (uPos != uEnd)
+    {
+        uint32_t const          iSlot = (uint32_t)(uPos % cItems);
+        PPDMQUEUEITEMCORE const pItem = (PPDMQUEUEITEMCORE)&pbItems[iSlot * cbItem];
+        uint64_t const          uSeq  = ASMAtomicReadU64(&pItem->u64View);
+        if (uSeq != uPos + 1)
+        {
+            /* Allocated but not yet inserted, the producer will flag us again once it is. */
+            AssertMsgBreakStmt(uSeq == uPos, ("%#RX64 vs %#RX64\n", uSeq, uPos), pQueue->rcOkay = VERR_INTERNAL_ERROR_5);
+            break;
+        }
+
+        uint64_t const nsInserted = pauTs[iSlot];
+        if (nsInserted != PDMQUEUE_RING_TS_FREED)
+        {
+            STAM_REL_HISTOGRAM_ADD_PERIOD(&pQueue->StatRingLatency, nsBatch > nsInserted ? nsBatch - nsInserted : 0);
+
+            if (!pdmR3QueueConsumeOne(pVM, pQueue, pItem))
+            {
+                STAM_REL_COUNTER_INC(&pQueue->StatFlushLeftovers);
+                break;
+            }
+            STAM_STATS({ ASMAtomicDecU32(&pQueue->cStatPending); });
+        }
+        /* else: Freed by PDMQueueFree, nothing to consume. */
+
+        /* Hand the slot back to the producers for the next lap. */
+        ASMAtomicWriteU64(&pItem->u64View, uPos + cItems);
+        uPos++;
+    }
+
+    ASMAtomicWriteU64(&pQueue->uRingConsumer, uPos);
+
+    STAM_PROFILE_STOP(&pQueue->StatFlushPrf,p);
+    return VINF_SUCCESS;
+}
+
+
 /**
  * Process pending items in one queue.
  *
@@ -636,6 +821,9 @@ DECLINLINE(void) pdmR3QueueFreeItem(PPDMQUEUE pQueue, uint8_t *pbItems, uint32_t
  */
 static int pdmR3QueueFlush(PVM pVM, PPDMQUEUE pQueue)
 {
+    if (pQueue->fFlags & PDMQUEUE_F_RING)
+        return pdmR3QueueFlushRing(pVM, pQueue);
+
     STAM_PROFILE_START(&pQueue->StatFlushPrf,p);
 
     uint32_t const  cbItem  = pQueue->cbItem;
@@ -815,8 +1003,9 @@ VMMR3DECL(void) PDMR3QueueFlushAll(PVM pVM)
         {
             PPDMQUEUE pQueue = pVM->pdm.s.apRing0Queues[i];
             if (   pQueue
-                && pQueue->iPending != UINT32_MAX
+                && pdmR3QueueHasPending(pQueue)
                 && pQueue->hTimer == NIL_TMTIMERHANDLE
+                && pQueue->hConsumerTask == NIL_PDMTASKHANDLE
                 && pQueue->rcOkay == VINF_SUCCESS)
                 pdmR3QueueFlush(pVM, pQueue);
         }
@@ -828,8 +1017,9 @@ VMMR3DECL(void) PDMR3QueueFlushAll(PVM pVM)
         {
             PPDMQUEUE pQueue = pVM->pdm.s.papRing3Queues[i];
             if (   pQueue
-                && pQueue->iPending != UINT32_MAX
+                && pdmR3QueueHasPending(pQueue)
                 && pQueue->hTimer == NIL_TMTIMERHANDLE
+                && pQueue->hConsumerTask == NIL_PDMTASKHANDLE
                 && pQueue->rcOkay == VINF_SUCCESS)
                 pdmR3QueueFlush(pVM, pQueue);
         }
@@ -854,7 +1044,7 @@ static DECLCALLBACK(void) pdmR3QueueTimer(PVM pVM, TMTIMERHANDLE hTimer, void *p
     PPDMQUEUE pQueue = (PPDMQUEUE)pvUser;
     Assert(hTimer == pQueue->hTimer);
 
-    if (pQueue->iPending != UINT32_MAX)
+    if (pdmR3QueueHasPending(pQueue))
         pdmR3QueueFlush(pVM, pQueue);
 
     int rc = TMTimerSetMillies(pVM, hTimer, pQueue->cMilliesInterval);
@@ -862,6 +1052,21 @@ static DECLCALLBACK(void) pdmR3QueueTimer(PVM pVM, TMTIMERHANDLE hTimer, void *p
 }
 
 
+/**
+ * @callback_method_impl{FNPDMTASKINT, Consumer thread flushing of one PDM queue.}
+ */
+static DECLCALLBACK(void) pdmR3QueueConsumerTask(PVM pVM, void *pvUser)
+{
+    PPDMQUEUE pQueue = (PPDMQUEUE)pvUser;
+    AssertReturnVoid(pQueue->u32Magic == PDMQUEUE_MAGIC);
+
+    /* The task is the only consumer of this queue, so no need to serialize with the EMTs here. */
+    if (   pQueue->rcOkay == VINF_SUCCESS
+        && pdmR3QueueHasPending(pQueue))
+        pdmR3QueueFlush(pVM, pQueue);
+}
+
+
 /**
  * Terminate the queues, freeing any resources still allocated.
  *
@@ -39,8 +39,10 @@
 
 #include <VBox/log.h>
 #include <iprt/asm.h>
+#include <iprt/cpuset.h>
 #include <iprt/semaphore.h>
 #include <iprt/assert.h>
+#include <iprt/string.h>
 #include <iprt/thread.h>
 
 
@@ -202,6 +204,65 @@ static int pdmR3ThreadInit(PVM pVM, PPPDMTHREAD ppThread, size_t cbStack, RTTHRE
 }
 
 
+/**
+ * Assigns a new device thread to the I/O thread group of the device instance.
+ *
+ * @param   pVM             The cross context VM structure.
+ * @param   pThread         The new thread (not yet started).
+ * @param   pInstanceNode   The device instance configuration node.
+ */
+static void pdmR3ThreadAssignIoThreadGroup(PVM pVM, PPDMTHREAD pThread, PCFGMNODE pInstanceNode)
+{
+    PPDMIOTHREADGROUP pGroup = pVM->pUVM->pdm.s.pIoThreadGroups;
+    if (!pGroup)
+        return;
+
+    /* The names were checked by pdmR3IoThreadGroupsInit, so no fuss here. */
+    char szName[64];
+    int rc = CFGMR3QueryStringDef(pInstanceNode, "IoThreads", szName, sizeof(szName), "Default");
+    AssertRCReturnVoid(rc);
+    while (pGroup && RTStrCmp(pGroup->szName, szName))
+        pGroup = pGroup->pNext;
+    if (pGroup)
+    {
+        pThread->Internal.s.pIoThreadGroup = pGroup;
+        pThread->Internal.s.iIoThread      = ASMAtomicIncU32(&pGroup->cThreads) - 1;
+    }
+}
+
+
+/**
+ * Binds the calling PDM thread to the host CPUs of its I/O thread group.
+ *
+ * @param   pThread     The PDM thread.
+ */
+static void pdmR3ThreadApplyIoThreadGroup(PPDMTHREAD pThread)
+{
+    PPDMIOTHREADGROUP const pGroup = pThread->Internal.s.pIoThreadGroup;
+    RTCPUSET                CpuSet = pGroup->CpuSet;
+    if (pGroup->fSpread)
+    {
+        /* Pick the n-th member of the set. */
+        uint32_t iNth = pThread->Internal.s.iIoThread % pGroup->cCpus;
+        RTCpuSetEmpty(&CpuSet);
+        for (int iCpu = 0; iCpu < RTCPUSET_MAX_CPUS; iCpu++)
+            if (RTCpuSetIsMemberByIndex(&pGroup->CpuSet, iCpu) && iNth-- == 0)
+            {
+                RTCpuSetAddByIndex(&CpuSet, iCpu);
+                break;
+            }
+    }
+
+    int rc = RTThreadSetAffinity(&CpuSet);
+    if (RT_SUCCESS(rc))
+        LogRel(("PDMThread: Thread '%s' runs in I/O thread group '%s' (#%u)\n",
+                RTThreadGetName(pThread->Thread), pGroup->szName, pThread->Internal.s.iIoThread));
+    else
+        LogRel(("PDMThread: Failed to set the affinity of thread '%s' for I/O thread group '%s': %Rrc\n",
+                RTThreadGetName(pThread->Thread), pGroup->szName, rc));
+}
+
+
 /**
  * Device Helper for creating a thread associated with a device.
  *
@@ -229,6 +290,7 @@ int pdmR3ThreadCreateDevice(PVM pVM, PPDMDEVINS pDevIns, PPPDMTHREAD ppThread, v
         pThread->u.Dev.pDevIns = pDevIns;
         pThread->u.Dev.pfnThread = pfnThread;
         pThread->u.Dev.pfnWakeUp = pfnWakeUp;
+        pdmR3ThreadAssignIoThreadGroup(pVM, pThread, pDevIns->Internal.s.pCfgHandle);
         rc = pdmR3ThreadInit(pVM, ppThread, cbStack, enmType, pszName);
     }
     return rc;
@@ -774,6 +836,9 @@ static DECLCALLBACK(int) pdmR3ThreadMain(RTTHREAD Thread, void *pvUser)
         && pUVM->pVmm2UserMethods->pfnNotifyPdmtInit)
         pUVM->pVmm2UserMethods->pfnNotifyPdmtInit(pUVM->pVmm2UserMethods, pUVM);
 
+    if (pThread->Internal.s.pIoThreadGroup)
+        pdmR3ThreadApplyIoThreadGroup(pThread);
+
     /*
      * The run loop.
      *
@@ -1105,3 +1170,102 @@ int pdmR3ThreadResumeAll(PVM pVM)
     return VINF_SUCCESS;
 }
 
+
+/**
+ * Sets up the I/O thread groups from the configuration.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ */
+int pdmR3IoThreadGroupsInit(PVM pVM)
+{
+    /** @cfgm{/PDM/IoThreads/, node}
+     * I/O thread groups.  The worker threads of the devices assigned to a group
+     * (see the IoThreads key of the device instance nodes) are bound to the
+     * host CPUs of the group, so they don't compete with the EMTs.  Devices
+     * without an IoThreads key go to the group named 'Default' if there is one.
+     *
+     * @cfgm{/PDM/IoThreads/\<name\>/Affinity, string}
+     * The host CPUs of the group as a list of CPU set indexes and ranges,
+     * e.g. "8-11,24".
+     *
+     * @cfgm{/PDM/IoThreads/\<name\>/Spread, boolean, false}
+     * Bind each thread to a single CPU of the group, round robin, rather than
+     * letting all of them float over the whole set.
+     */
+    PUVM      pUVM          = pVM->pUVM;
+    PCFGMNODE pCfgIoThreads = CFGMR3GetChild(CFGMR3GetChild(CFGMR3GetRoot(pVM), "PDM"), "IoThreads");
+    for (PCFGMNODE pCur = CFGMR3GetFirstChild(pCfgIoThreads); pCur; pCur = CFGMR3GetNextChild(pCur))
+    {
+        size_t const      cchName = CFGMR3GetNameLen(pCur);
+        PPDMIOTHREADGROUP pGroup;
+        int rc = MMR3HeapAllocZEx(pVM, MM_TAG_PDM_THREAD, RT_UOFFSETOF_DYN(PDMIOTHREADGROUP, szName[cchName + 1]),
+                                  (void **)&pGroup);
+        AssertRCReturn(rc, rc);
+        rc = CFGMR3GetName(pCur, pGroup->szName, cchName + 1);
+        AssertRC(rc);
+        pGroup->pNext = pUVM->pdm.s.pIoThreadGroups;
+        pUVM->pdm.s.pIoThreadGroups = pGroup;
+
+        char szList[256];
+        rc = CFGMR3QueryString(pCur, "Affinity", szList, sizeof(szList));
+        if (RT_SUCCESS(rc))
+            rc = VMR3ParseCpuList(szList, &pGroup->CpuSet);
+        if (RT_FAILURE(rc))
+            return VMSetError(pVM, rc, RT_SRC_POS,
+                              N_("Configuration error: Missing or invalid host CPU list for I/O thread group '%s'"),
+                              pGroup->szName);
+        pGroup->cCpus = (uint32_t)RTCpuSetCount(&pGroup->CpuSet);
+
+        rc = CFGMR3QueryBoolDef(pCur, "Spread", &pGroup->fSpread, false);
+        AssertLogRelRCReturn(rc, rc);
+
+        LogRel(("PDM: I/O thread group '%s': host CPUs %s%s\n", pGroup->szName, szList,
+                pGroup->fSpread ? " (one per thread)" : ""));
+    }
+
+    /*
+     * Check the group references of the device instances so typos don't go unnoticed.
+     */
+    PCFGMNODE pDevices = CFGMR3GetChild(CFGMR3GetRoot(pVM), "Devices");
+    for (PCFGMNODE pDev = CFGMR3GetFirstChild(pDevices); pDev; pDev = CFGMR3GetNextChild(pDev))
+        for (PCFGMNODE pInst = CFGMR3GetFirstChild(pDev); pInst; pInst = CFGMR3GetNextChild(pInst))
+        {
+            char szName[64];
+            int rc = CFGMR3QueryString(pInst, "IoThreads", szName, sizeof(szName));
+            if (rc == VERR_CFGM_VALUE_NOT_FOUND)
+                continue;
+            PPDMIOTHREADGROUP pGroup = pUVM->pdm.s.pIoThreadGroups;
+            while (RT_SUCCESS(rc) && pGroup && RTStrCmp(pGroup->szName, szName))
+                pGroup = pGroup->pNext;
+            if (RT_FAILURE(rc) || !pGroup)
+            {
+                char szDev[64];
+                CFGMR3GetName(pDev, szDev, sizeof(szDev));
+                return VMSetError(pVM, RT_FAILURE(rc) ? rc : VERR_NOT_FOUND, RT_SRC_POS,
+                                  N_("Configuration error: Device '%s' refers to an unknown I/O thread group"), szDev);
+            }
+        }
+
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Frees the I/O thread groups.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @remarks Must be called after all device threads have been destroyed.
+ */
+void pdmR3IoThreadGroupsTerm(PVM pVM)
+{
+    PUVM              pUVM   = pVM->pUVM;
+    PPDMIOTHREADGROUP pGroup = pUVM->pdm.s.pIoThreadGroups;
+    pUVM->pdm.s.pIoThreadGroups = NULL;
+    while (pGroup)
+    {
+        PPDMIOTHREADGROUP pNext = pGroup->pNext;
+        MMR3HeapFree(pGroup);
+        pGroup = pNext;
+    }
+}
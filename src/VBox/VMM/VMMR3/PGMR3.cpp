@@ -946,6 +946,23 @@ VMMR3DECL(int) PGMR3Init(PVM pVM)
     AssertLogRelRCReturn(rc, rc);
 #endif
 
+#ifndef VBOX_WITH_ONLY_PGM_NEM_MODE
+    /** @cfgm{/PGM/LargePagePrealloc, boolean, false}
+     * Whether to back guest RAM with large (2 MB) pages right after the
+     * execution engine has decided that large pages can be used.  2 MB regions
+     * that cannot be backed by a large page fall back to small pages on demand.
+     * Not applicable in NEM mode or together with /RamPreAlloc. */
+    rc = CFGMR3QueryBoolDef(pCfgPGM, "LargePagePrealloc", &pVM->pgm.s.fLargePagePrealloc, false);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/PGM/LargePageRequired, boolean, false}
+     * Whether large pages are required.  When set, VM creation fails if large
+     * pages are not available or if the /PGM/LargePagePrealloc pass cannot back
+     * all eligible RAM with large pages, instead of falling back to small pages. */
+    rc = CFGMR3QueryBoolDef(pCfgPGM, "LargePageRequired", &pVM->pgm.s.fLargePageRequired, false);
+    AssertLogRelRCReturn(rc, rc);
+#endif
+
     /** @cfgm{/PGM/ZeroRamPagesOnReset, boolean, true}
      * Whether to clear RAM pages on (hard) reset. */
     rc = CFGMR3QueryBoolDef(pCfgPGM, "ZeroRamPagesOnReset", &pVM->pgm.s.fZeroRamPagesOnReset, true);
@@ -1315,6 +1332,13 @@ static int pgmR3InitStats(PVM pVM)
     STAM_REL_REG(pVM, &pPGM->StatLargePageRecheck,               STAMTYPE_COUNTER, "/PGM/LargePage/Recheck",             STAMUNIT_OCCURENCES, "The number of times we've rechecked a disabled large page.");
 
     STAM_REL_REG(pVM, &pPGM->StatShModCheck,                     STAMTYPE_PROFILE, "/PGM/ShMod/Check",                   STAMUNIT_TICKS_PER_CALL, "Profiles the shared module checking.");
+    STAM_REL_REG(pVM, &pPGM->StatPageScan,                       STAMTYPE_PROFILE, "/PGM/PageScan",                      STAMUNIT_TICKS_PER_CALL, "Profiles the duplicate page scanner runs.");
+    STAM_REL_REG(pVM, &pPGM->StatPageScanScanned,                STAMTYPE_COUNTER, "/PGM/PageScan/Scanned",              STAMUNIT_PAGES,     "Pages looked at by the duplicate page scanner.");
+    STAM_REL_REG(pVM, &pPGM->StatPageScanMerged,                 STAMTYPE_COUNTER, "/PGM/PageScan/Merged",               STAMUNIT_PAGES,     "Pages replaced by an identical shared page.");
+    STAM_REL_REG(pVM, &pPGM->StatPageScanShared,                 STAMTYPE_COUNTER, "/PGM/PageScan/Shared",               STAMUNIT_PAGES,     "Pages converted into new shared pages.");
+    STAM_REL_REG(pVM, &pPGM->StatPageScanZero,                   STAMTYPE_COUNTER, "/PGM/PageScan/Zero",                 STAMUNIT_PAGES,     "Merged or converted pages that were all zeros.");
+    STAM_REL_REG(pVM, &pPGM->StatPageScanPasses,                 STAMTYPE_COUNTER, "/PGM/PageScan/Passes",               STAMUNIT_OCCURENCES, "Complete passes over guest RAM.");
+    STAM_REL_REG(pVM, &pPGM->StatSharedPageBroken,               STAMTYPE_COUNTER, "/PGM/PageScan/Broken",               STAMUNIT_PAGES,     "Shared pages replaced by a private copy on write (all shared pages, not only the scanner ones).");
     STAM_REL_REG(pVM, &pPGM->StatMmio2QueryAndResetDirtyBitmap,  STAMTYPE_PROFILE, "/PGM/Mmio2QueryAndResetDirtyBitmap", STAMUNIT_TICKS_PER_CALL, "Profiles calls to PGMR3PhysMmio2QueryAndResetDirtyBitmap (sans locking).");
 
     /* Live save */
@@ -1374,6 +1398,8 @@ static int pgmR3InitStats(PVM pVM)
     PGM_REG_COUNTER(&pPGM->StatLargePageOverflow,               "/PGM/LargePage/Overflow",            "The number of times allocating a large page took too long.");
     PGM_REG_COUNTER(&pPGM->StatLargePageTlbFlush,               "/PGM/LargePage/TlbFlush",            "The number of times a full VCPU TLB flush was required after a large allocation.");
     PGM_REG_COUNTER(&pPGM->StatLargePageZeroEvict,              "/PGM/LargePage/ZeroEvict",           "The number of zero page mappings we had to evict when allocating a large page.");
+    PGM_REG_COUNTER(&pPGM->StatLargePageFallback,               "/PGM/LargePage/Fallback",            "The number of 2 MB regions backed by small pages after a failed large page allocation.");
+    PGM_REG_COUNTER(&pPGM->StatLargePagePrealloc,               "/PGM/LargePage/Prealloc",            "The number of large pages allocated by the preallocation pass.");
 #endif
 #ifdef VBOX_WITH_STATISTICS
 # ifndef VBOX_WITH_ONLY_PGM_NEM_MODE
@@ -1861,6 +1887,8 @@ VMMR3DECL(int) PGMR3InitFinalize(PVM pVM)
     if (pVM->pgm.s.fRamPreAlloc)
         rc = pgmR3PhysRamPreAllocate(pVM);
 #endif
+    if (RT_SUCCESS(rc))
+        rc = pgmR3PhysLazyRestoreInit(pVM);
 
     //pgmLogState(pVM);
 #ifdef VBOX_VMM_TARGET_X86
@@ -1904,6 +1932,33 @@ VMMR3_INT_DECL(int) PGMR3InitCompleted(PVM pVM, VMINITCOMPLETED enmWhat)
             }
 #else
             AssertLogRelReturn(!pVM->pgm.s.fPciPassthrough, VERR_PGM_PCI_PASSTHRU_MISCONFIG);
+#endif
+#ifndef VBOX_WITH_ONLY_PGM_NEM_MODE
+            /*
+             * Large pages: HM has made up its mind by now, so check the
+             * requirement and do the requested pre-allocation.
+             */
+            if (pVM->pgm.s.fLargePageRequired && !PGMIsUsingLargePages(pVM))
+                return VMSetError(pVM, VERR_PGM_LARGE_PAGES_UNAVAILABLE, RT_SRC_POS,
+                                  N_("Large pages are required by the configuration (/PGM/LargePageRequired) "
+                                     "but cannot be used with the current execution engine or host"));
+            if (pVM->pgm.s.fLargePagePrealloc)
+            {
+                if (pVM->pgm.s.fRamPreAlloc)
+                    LogRel(("PGM: Large page pre-allocation ignored because RAM was pre-allocated with small pages.\n"));
+                else
+                {
+                    int rc = pgmR3PhysLargePagePreAllocate(pVM);
+                    if (RT_FAILURE(rc))
+                        return rc;
+                }
+            }
+#endif
+#ifdef VBOX_WITH_PAGE_SHARING
+            {
+                int rc = pgmR3PageScanInit(pVM);
+                AssertRCReturn(rc, rc);
+            }
 #endif
             break;
 
@@ -2065,6 +2120,11 @@ VMMR3_INT_DECL(void) PGMR3Reset(PVM pVM)
 
     PGM_LOCK_VOID(pVM);
 
+    /*
+     * Drop any lazy restore in progress, the RAM is about to be zeroed.
+     */
+    pgmR3PhysLazyRestoreTerm(pVM, false /*fTerm*/);
+
     /*
      * Exit the guest paging mode before the pgm pool gets reset.
      * Important to clean up the amd64 case.
@@ -2246,6 +2306,8 @@ VMMR3DECL(int) PGMR3Term(PVM pVM)
 {
     /* Must free shared pages here. */
     PGM_LOCK_VOID(pVM);
+    pgmR3PhysLazyRestoreTerm(pVM, true /*fTerm*/);
+    pgmR3TermSavedState(pVM);
     pgmR3PhysRamTerm(pVM);
     pgmR3PhysRomTerm(pVM);
     PGM_UNLOCK(pVM);
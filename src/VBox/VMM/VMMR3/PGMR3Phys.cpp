@@ -32,12 +32,15 @@
 #define LOG_GROUP LOG_GROUP_PGM_PHYS
 #define VBOX_WITHOUT_PAGING_BIT_FIELDS /* 64-bit bitfields are just asking for trouble. See @bugref{9841} and others. */
 #include <VBox/vmm/pgm.h>
+#include <VBox/vmm/cfgm.h>
 #include <VBox/vmm/iem.h>
 #include <VBox/vmm/iom.h>
 #include <VBox/vmm/mm.h>
 #include <VBox/vmm/nem.h>
 #include <VBox/vmm/stam.h>
 #include <VBox/vmm/pdmdev.h>
+#include <VBox/vmm/ssm.h>
+#include <VBox/vmm/tm.h>
 #include "PGMInternal.h"
 #include <VBox/vmm/vmcc.h>
 
@@ -53,9 +56,11 @@
 #ifdef VBOX_STRICT
 # include <iprt/crc.h>
 #endif
+#include <iprt/file.h>
 #include <iprt/thread.h>
 #include <iprt/string.h>
 #include <iprt/system.h>
+#include <iprt/time.h>
 
 
 /*********************************************************************************************************************************
@@ -1506,6 +1511,23 @@ VMMR3DECL(int) PGMR3PhysGetRange(PVM pVM, uint32_t iRange, PRTGCPHYS pGCPhysStar
 }
 
 
+/**
+ * Gets a pointer to the page mapping generation counter.
+ *
+ * The counter is incremented whenever a page mapping may have become invalid
+ * (page freed, replaced, ballooned, remapped, ...), so ring-3 users caching
+ * page mappings (and locks) can detect stale entries without taking the PGM
+ * lock.
+ *
+ * @returns Pointer to the counter, valid for the lifetime of the VM.
+ * @param   pVM             The cross context VM structure.
+ */
+VMMR3_INT_DECL(uint32_t volatile const *) PGMR3PhysGetMapGenerationPtr(PVM pVM)
+{
+    return &pVM->pgm.s.uPhysMapGen;
+}
+
+
 /**
  * Gets RAM ranges that are supposed to be zero'ed at boot.
  *
@@ -1572,6 +1594,73 @@ VMMR3_INT_DECL(int) PGMR3PhysGetRamBootZeroedRanges(PVM pVM, PPGMPHYSRANGES pRan
 }
 
 
+/**
+ * Gets the guest RAM ranges together with their ring-3 mappings.
+ *
+ * This is only possible in NEM mode, where each RAM range is backed by one
+ * contiguous ring-3 allocation which stays put for the lifetime of the VM.
+ * Otherwise guest pages are mapped on demand by chunk and there is no such
+ * mapping.  Adjacent ranges with adjacent mappings are combined, ad hoc
+ * ranges (ROM, MMIO, MMIO2) are not included.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NOT_SUPPORTED if not in NEM mode.
+ * @retval  VERR_BUFFER_OVERFLOW if there are more than @a cMaxMappings ranges,
+ *          @a pcMappings is set to the number required.
+ * @param   pVM             The cross context VM structure.
+ * @param   paMappings      Where to return the ranges, in ascending order.
+ * @param   cMaxMappings    The number of entries in @a paMappings.
+ * @param   pcMappings      Where to return the number of ranges.
+ */
+VMMR3_INT_DECL(int) PGMR3PhysQueryRamMappings(PVM pVM, PPGMPHYSRAMMAPPING paMappings, uint32_t cMaxMappings,
+                                              uint32_t *pcMappings)
+{
+    VM_ASSERT_VALID_EXT_RETURN(pVM, VERR_INVALID_VM_HANDLE);
+    AssertPtrReturn(paMappings, VERR_INVALID_POINTER);
+    AssertPtrReturn(pcMappings, VERR_INVALID_POINTER);
+    *pcMappings = 0;
+    if (!PGM_IS_IN_NEM_MODE(pVM))
+        return VERR_NOT_SUPPORTED;
+
+    int      rc     = VINF_SUCCESS;
+    uint32_t cFound = 0;
+    PGM_LOCK_VOID(pVM);
+
+    uint32_t const cLookupEntries = RT_MIN(pVM->pgm.s.RamRangeUnion.cLookupEntries, RT_ELEMENTS(pVM->pgm.s.aRamRangeLookup));
+    for (uint32_t idxLookup = 0; idxLookup < cLookupEntries; idxLookup++)
+    {
+        uint32_t const idRamRange = PGMRAMRANGELOOKUPENTRY_GET_ID(pVM->pgm.s.aRamRangeLookup[idxLookup]);
+        Assert(idRamRange < RT_ELEMENTS(pVM->pgm.s.apRamRanges));
+        PPGMRAMRANGE const pCur = pVM->pgm.s.apRamRanges[idRamRange];
+        AssertContinue(pCur);
+        if (PGM_RAM_RANGE_IS_AD_HOC(pCur) || !pCur->pbR3)
+            continue;
+
+        if (   cFound > 0
+            && cFound <= cMaxMappings
+            && paMappings[cFound - 1].GCPhys + paMappings[cFound - 1].cb == pCur->GCPhys
+            && (uintptr_t)paMappings[cFound - 1].pvR3 + paMappings[cFound - 1].cb == (uintptr_t)pCur->pbR3)
+            paMappings[cFound - 1].cb += pCur->cb;
+        else
+        {
+            if (cFound < cMaxMappings)
+            {
+                paMappings[cFound].GCPhys = pCur->GCPhys;
+                paMappings[cFound].cb     = pCur->cb;
+                paMappings[cFound].pvR3   = pCur->pbR3;
+            }
+            else
+                rc = VERR_BUFFER_OVERFLOW;
+            cFound++;
+        }
+    }
+
+    PGM_UNLOCK(pVM);
+    *pcMappings = cFound;
+    return rc;
+}
+
+
 /*********************************************************************************************************************************
 *   RAM                                                                                                                          *
 *********************************************************************************************************************************/
@@ -2189,6 +2278,97 @@ int pgmR3PhysRamPreAllocate(PVM pVM)
     Log(("pgmR3PhysRamPreAllocate: returns VINF_SUCCESS\n"));
     return VINF_SUCCESS;
 }
+
+
+/**
+ * Worker called by PGMR3InitCompleted if we're configured to back guest RAM
+ * with large pages up front.
+ *
+ * This has to wait until HM has decided whether large pages can be used.  Any
+ * 2 MB region that cannot be backed by a large page is left alone and will be
+ * backed by small pages on demand, unless large pages are required by the
+ * configuration, in which case we fail.
+ *
+ * @returns VBox status code.
+ * @param   pVM     The cross context VM structure.
+ */
+int pgmR3PhysLargePagePreAllocate(PVM pVM)
+{
+    Assert(pVM->pgm.s.fLargePagePrealloc);
+# ifdef PGM_WITH_LARGE_PAGES
+    if (!PGMIsUsingLargePages(pVM))
+    {
+        LogRel(("PGM: Large page pre-allocation ignored as large pages are not in use.\n"));
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Walk the RAM ranges and try back every naturally aligned 2 MB region
+     * that lies entirely within a range with a large page.
+     */
+    uint32_t cLargePages = 0;
+    uint32_t cFallbacks  = 0;
+    int      rc          = VINF_SUCCESS;
+    uint64_t NanoTS      = RTTimeNanoTS();
+    PGM_LOCK_VOID(pVM);
+    uint32_t const cLookupEntries = RT_MIN(pVM->pgm.s.RamRangeUnion.cLookupEntries, RT_ELEMENTS(pVM->pgm.s.aRamRangeLookup));
+    for (uint32_t idxLookup = 0; idxLookup < cLookupEntries && PGMIsUsingLargePages(pVM); idxLookup++)
+    {
+        uint32_t const idRamRange = PGMRAMRANGELOOKUPENTRY_GET_ID(pVM->pgm.s.aRamRangeLookup[idxLookup]);
+        AssertContinue(idRamRange < RT_ELEMENTS(pVM->pgm.s.apRamRanges));
+        PPGMRAMRANGE const pRam = pVM->pgm.s.apRamRanges[idRamRange];
+        AssertContinue(pRam);
+
+        for (RTGCPHYS GCPhys = RT_ALIGN_T(pRam->GCPhys, _2M, RTGCPHYS);
+             GCPhys >= pRam->GCPhys /* wrap */ && GCPhys + _2M - 1 <= pRam->GCPhysLast;
+             GCPhys += _2M)
+        {
+            PPGMPAGE const pPage = &pRam->aPages[(GCPhys - pRam->GCPhys) >> GUEST_PAGE_SHIFT];
+            if (   PGM_PAGE_GET_TYPE(pPage)     != PGMPAGETYPE_RAM
+                || PGM_PAGE_GET_STATE(pPage)    != PGM_PAGE_STATE_ZERO
+                || PGM_PAGE_GET_PDE_TYPE(pPage) != PGM_PAGE_PDE_TYPE_DONTCARE)
+                continue;
+
+            rc = pgmPhysAllocLargePage(pVM, GCPhys);
+            if (RT_SUCCESS(rc))
+            {
+                STAM_REL_COUNTER_INC(&pVM->pgm.s.StatLargePagePrealloc);
+                cLargePages++;
+                continue;
+            }
+            if (rc == VERR_PGM_INVALID_LARGE_PAGE_RANGE)
+            {
+                /* Not made up of plain RAM pages, so not eligible. */
+                rc = VINF_SUCCESS;
+                continue;
+            }
+
+            /* The host could not give us a large page (or we're in the hold off
+               period after a slow allocation), so stop trying. */
+            cFallbacks++;
+            STAM_REL_COUNTER_INC(&pVM->pgm.s.StatLargePageFallback);
+            LogRel(("PGM: Large page pre-allocation failed at %RGp (in %s) with rc=%Rrc\n", GCPhys, pRam->pszDesc, rc));
+            break;
+        }
+        if (cFallbacks)
+            break;
+    }
+    PGM_UNLOCK(pVM);
+    NanoTS = RTTimeNanoTS() - NanoTS;
+
+    LogRel(("PGM: Pre-allocated %u large pages (%u MB) in %llu ms%s\n", cLargePages, cLargePages * 2, NanoTS / RT_NS_1MS,
+            cFallbacks ? ", the rest of RAM will be backed by small pages" : ""));
+    if (cFallbacks && pVM->pgm.s.fLargePageRequired)
+        return VMSetError(pVM, VERR_PGM_LARGE_PAGES_UNAVAILABLE, RT_SRC_POS,
+                          N_("The host could not provide enough large pages for the guest RAM (%Rrc). "
+                             "Free up host memory or unset /PGM/LargePageRequired"), rc);
+    return VINF_SUCCESS;
+
+# else  /* !PGM_WITH_LARGE_PAGES */
+    LogRel(("PGM: Large page pre-allocation not supported by this build.\n"));
+    return pVM->pgm.s.fLargePageRequired ? VERR_PGM_LARGE_PAGES_UNAVAILABLE : VINF_SUCCESS;
+# endif /* !PGM_WITH_LARGE_PAGES */
+}
 #endif /* !VBOX_WITH_ONLY_PGM_NEM_MODE */
 
 
@@ -5741,6 +5921,859 @@ VMMR3DECL(int) PGMR3PhysWriteProtectRAM(PVM pVM)
 }
 
 
+/*********************************************************************************************************************************
+*   Lazy Saved State RAM Restore                                                                                                 *
+*********************************************************************************************************************************/
+
+/**
+ * Per RAM range lazy restore tracking.
+ */
+typedef struct PGMLAZYRESTORERANGE
+{
+    /** The start of the access handler covering the pending pages of the range,
+     *  NIL_RTGCPHYS if none is registered. */
+    RTGCPHYS                GCPhysHandler;
+    /** The number of pages still to be read from the side file. */
+    uint32_t                cPagesLeft;
+    /** The number of bits in the bitmap (pages in the range). */
+    uint32_t                cPages;
+    /** Bitmap of the pages still to be read, NULL if none were pending. */
+    uint64_t               *pbmPending;
+} PGMLAZYRESTORERANGE;
+/** Pointer to the per RAM range lazy restore tracking. */
+typedef PGMLAZYRESTORERANGE *PPGMLAZYRESTORERANGE;
+
+/**
+ * Lazy saved state RAM restore state.
+ *
+ * The PGM_STATE_REC_RAM_FILE records of a saved state have no payload, the
+ * page content sits in a side file at offset GCPhys instead.  We leave the
+ * pages protected by an all-access handler after loading and read each one
+ * when first touched, or when the background prefetcher gets to it.
+ *
+ * Post-copy teleportation uses the same records for the pages left dirty by
+ * the final pass, only the content is fetched from the source via pfnFetch.
+ */
+typedef struct PGMLAZYRESTORE
+{
+    /** The side file, NIL_RTFILE when fetching from a teleportation source. */
+    RTFILE                  hFile;
+    /** The post-copy page fetcher, NULL when reading from the side file. */
+    PFNPGMPOSTCOPYFETCH     pfnFetch;
+    /** The user argument of pfnFetch. */
+    void                   *pvFetchUser;
+    /** Whether to read the pages on demand (true) or right away (false). */
+    bool                    fLazy;
+    /** Set while the prefetcher is reading without owning the PGM lock. */
+    bool                    fPrefetching;
+    bool                    afPadding[2];
+    /** The total number of pages still to be read. */
+    uint32_t                cPagesLeft;
+    /** The total number of pages that were pending when the VM was resumed. */
+    uint32_t                cPagesArmed;
+    /** The prefetch cursor: RAM range ID. */
+    uint32_t                idPrefetchRange;
+    /** The prefetch cursor: next page index to look at. */
+    uint32_t                iPrefetchPage;
+    /** The number of entries in aRanges. */
+    uint32_t                cRanges;
+    /** The prefetch buffer (PGM_LAZY_RESTORE_PREFETCH_MAX_PAGES pages). */
+    uint8_t                *pbPrefetch;
+    /** The load timestamp, for the release log. */
+    uint64_t                nsArmed;
+    /** Per RAM range data, indexed by RAM range ID. */
+    PGMLAZYRESTORERANGE     aRanges[RT_FLEXIBLE_ARRAY];
+} PGMLAZYRESTORE;
+/** Pointer to the lazy saved state RAM restore state. */
+typedef PGMLAZYRESTORE *PPGMLAZYRESTORE;
+
+/** The max number of pages the prefetcher reads in one go. */
+#define PGM_LAZY_RESTORE_PREFETCH_MAX_PAGES     64
+
+
+/**
+ * Reads pending pages from wherever they are.
+ *
+ * @returns VBox status code.
+ * @param   pLazy       The lazy restore state.
+ * @param   GCPhys      The address of the first page.
+ * @param   pvDst       Where to put the content.
+ * @param   cPages      The number of pages.
+ */
+static int pgmR3PhysLazyRestoreRead(PPGMLAZYRESTORE pLazy, RTGCPHYS GCPhys, void *pvDst, uint32_t cPages)
+{
+    if (pLazy->pfnFetch)
+        return pLazy->pfnFetch(pLazy->pvFetchUser, GCPhys, pvDst, cPages);
+    return RTFileReadAt(pLazy->hFile, GCPhys, pvDst, (size_t)cPages << GUEST_PAGE_SHIFT, NULL);
+}
+
+
+/**
+ * Tells the post-copy fetcher registered for the next load, if any, that it
+ * won't be used and drops it.
+ *
+ * @param   pVM         The cross context VM structure.
+ */
+static void pgmR3PhysPostCopyReleaseFetcher(PVM pVM)
+{
+    PFNPGMPOSTCOPYFETCH const pfnFetch = pVM->pgm.s.pfnPostCopyFetchR3;
+    void * const              pvUser   = pVM->pgm.s.pvPostCopyUserR3;
+    pVM->pgm.s.pfnPostCopyFetchR3 = NULL;
+    pVM->pgm.s.pvPostCopyUserR3   = NIL_RTR3PTR;
+    if (pfnFetch)
+        pfnFetch(pvUser, NIL_RTGCPHYS, NULL, 0);
+}
+
+
+/**
+ * Frees the lazy restore state, deregistering any remaining access handlers.
+ *
+ * Pages still pending are left with whatever content they have.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pLazy       The lazy restore state.
+ */
+static void pgmR3PhysLazyRestoreDestroyLocked(PVM pVM, PPGMLAZYRESTORE pLazy)
+{
+    PGM_LOCK_ASSERT_OWNER(pVM);
+    Assert(pVM->pgm.s.pLazyRestoreR3 == pLazy);
+    pVM->pgm.s.pLazyRestoreR3 = NULL;
+
+    if (pVM->pgm.s.hLazyRestoreTimer != NIL_TMTIMERHANDLE)
+        TMTimerStop(pVM, pVM->pgm.s.hLazyRestoreTimer);
+
+    for (uint32_t idRange = 0; idRange < pLazy->cRanges; idRange++)
+    {
+        PPGMLAZYRESTORERANGE const pRange = &pLazy->aRanges[idRange];
+        if (pRange->GCPhysHandler != NIL_RTGCPHYS)
+        {
+            int rc = PGMHandlerPhysicalDeregister(pVM, pRange->GCPhysHandler);
+            AssertLogRelRC(rc);
+        }
+        RTMemFree(pRange->pbmPending);
+    }
+
+    if (pLazy->hFile != NIL_RTFILE)
+        RTFileClose(pLazy->hFile);
+    if (pLazy->pfnFetch)
+        pLazy->pfnFetch(pLazy->pvFetchUser, NIL_RTGCPHYS, NULL, 0);
+    RTMemPageFree(pLazy->pbPrefetch, PGM_LAZY_RESTORE_PREFETCH_MAX_PAGES * GUEST_PAGE_SIZE);
+    RTMemFree(pLazy);
+}
+
+
+/**
+ * Called when the last pending page has been read.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pLazy       The lazy restore state.
+ */
+static void pgmR3PhysLazyRestoreCompletedLocked(PVM pVM, PPGMLAZYRESTORE pLazy)
+{
+    Assert(!pLazy->cPagesLeft);
+    if (pLazy->fPrefetching)
+        return; /* The prefetcher cleans up when it gets the lock back. */
+    if (pLazy->cPagesArmed)
+        LogRel(("PGM: Lazy restore of %u pages completed after %RU64 ms\n",
+                pLazy->cPagesArmed, (RTTimeNanoTS() - pLazy->nsArmed) / RT_NS_1MS));
+    pgmR3PhysLazyRestoreDestroyLocked(pVM, pLazy);
+}
+
+
+/**
+ * Fills in one pending page and drops the access handler protection for it.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pLazy       The lazy restore state.
+ * @param   pRam        The RAM range.
+ * @param   iPage       The page index into the range.  The page must be pending.
+ * @param   pvSrc       The page content if already read, NULL to read it here.
+ *
+ * @note    May free @a pLazy when this is the last pending page.
+ */
+static int pgmR3PhysLazyRestoreFillPageLocked(PVM pVM, PPGMLAZYRESTORE pLazy, PPGMRAMRANGE pRam, uint32_t iPage,
+                                              void const *pvSrc)
+{
+    PGM_LOCK_ASSERT_OWNER(pVM);
+    PPGMLAZYRESTORERANGE const pRange = &pLazy->aRanges[pRam->idRange];
+    Assert(ASMBitTest(pRange->pbmPending, iPage));
+    RTGCPHYS const GCPhys = pRam->GCPhys + ((RTGCPHYS)iPage << GUEST_PAGE_SHIFT);
+
+    PGMPAGEMAPLOCK PgMpLck;
+    void          *pvDstPage;
+    int rc = pgmPhysGCPhys2CCPtrInternal(pVM, &pRam->aPages[iPage], GCPhys, &pvDstPage, &PgMpLck);
+    if (RT_SUCCESS(rc))
+    {
+        if (pvSrc)
+            memcpy(pvDstPage, pvSrc, GUEST_PAGE_SIZE);
+        else
+            rc = pgmR3PhysLazyRestoreRead(pLazy, GCPhys, pvDstPage, 1);
+        pgmPhysReleaseInternalPageMappingLock(pVM, &PgMpLck);
+    }
+
+    /* The page is done with even if we failed, there is no point in trying again. */
+    ASMBitClear(pRange->pbmPending, iPage);
+    pRange->cPagesLeft--;
+    pLazy->cPagesLeft--;
+    if (pRange->GCPhysHandler != NIL_RTGCPHYS)
+    {
+        int rc2;
+        if (pRange->cPagesLeft)
+            rc2 = PGMHandlerPhysicalPageTempOff(pVM, pRange->GCPhysHandler, GCPhys);
+        else
+        {
+            rc2 = PGMHandlerPhysicalDeregister(pVM, pRange->GCPhysHandler);
+            pRange->GCPhysHandler = NIL_RTGCPHYS;
+        }
+        AssertLogRelRC(rc2);
+    }
+
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("PGM: Failed to read page %RGp from the %s: %Rrc\n",
+                GCPhys, pLazy->pfnFetch ? "teleportation source" : "saved state RAM file", rc));
+        VMSetRuntimeError(pVM, VMSETRTERR_FLAGS_FATAL, "PGMLazyRestoreReadError",
+                          N_("Failed to read guest memory from the saved state RAM file or teleportation source (%Rrc)"), rc);
+    }
+
+    if (!pLazy->cPagesLeft)
+        pgmR3PhysLazyRestoreCompletedLocked(pVM, pLazy);
+    return rc;
+}
+
+
+/**
+ * @callback_method_impl{FNPGMPHYSHANDLER,
+ *      Reads a page which hasn't been restored yet from the side file.}
+ */
+static DECLCALLBACK(VBOXSTRICTRC)
+pgmR3PhysLazyRestoreHandler(PVM pVM, PVMCPU pVCpu, RTGCPHYS GCPhys, void *pvPhys, void *pvBuf, size_t cbBuf,
+                            PGMACCESSTYPE enmAccessType, PGMACCESSORIGIN enmOrigin, uint64_t uUser)
+{
+    RT_NOREF(pVCpu, pvPhys, pvBuf, cbBuf, enmAccessType, enmOrigin, uUser);
+
+    /*
+     * The pages were allocated while loading, so the mapping the caller passes
+     * us in pvPhys is the one we fill and the default action does the rest.
+     */
+    PGM_LOCK_VOID(pVM);
+    PPGMLAZYRESTORE const pLazy = pVM->pgm.s.pLazyRestoreR3;
+    if (pLazy)
+    {
+        PPGMRAMRANGE const pRam = pgmPhysGetRange(pVM, GCPhys);
+        if (pRam && pRam->idRange < pLazy->cRanges)
+        {
+            PPGMLAZYRESTORERANGE const pRange = &pLazy->aRanges[pRam->idRange];
+            uint32_t const             iPage  = (uint32_t)((GCPhys - pRam->GCPhys) >> GUEST_PAGE_SHIFT);
+            if (   pRange->pbmPending
+                && iPage < pRange->cPages
+                && ASMBitTest(pRange->pbmPending, iPage))
+                pgmR3PhysLazyRestoreFillPageLocked(pVM, pLazy, pRam, iPage, NULL /*pvSrc*/);
+        }
+    }
+    PGM_UNLOCK(pVM);
+    return VINF_PGM_HANDLER_DO_DEFAULT;
+}
+
+
+static int pgmR3PhysLazyRestorePrefetchLocked(PVM pVM, uint32_t cMaxPages);
+
+
+/**
+ * Checks whether guest accesses to pages pending a lazy restore can be trapped.
+ *
+ * Lazy restore relies on all-access physical handlers.  The NEM backends
+ * don't all honour these: the Linux one ignores handler registrations and page
+ * protection changes entirely.  So under NEM the guest would read pages which
+ * haven't been filled yet, and the prefetcher would overwrite pages the guest
+ * has already written.
+ *
+ * @returns true if lazy restore is safe, false if pages must be read eagerly.
+ * @param   pVM         The cross context VM structure.
+ */
+static bool pgmR3PhysLazyRestoreCanTrap(PVM pVM)
+{
+    return !VM_IS_NEM_ENABLED(pVM);
+}
+
+
+/**
+ * Handles a PGM_STATE_REC_RAM_FILE record while loading a saved state.
+ *
+ * The page is allocated right away, but only read now if lazy restoring is
+ * disabled.  Otherwise it's marked pending for pgmR3PhysLazyRestoreArm.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pSSM        The saved state handle.
+ * @param   pRam        The RAM range containing the page.
+ * @param   pPage       The page.
+ * @param   GCPhys      The page address.
+ */
+int pgmR3PhysLazyRestoreAddPage(PVM pVM, PSSMHANDLE pSSM, PPGMRAMRANGE pRam, PPGMPAGE pPage, RTGCPHYS GCPhys)
+{
+    PGM_LOCK_ASSERT_OWNER(pVM);
+    AssertLogRelMsgReturn(PGM_PAGE_GET_TYPE(pPage) == PGMPAGETYPE_RAM, ("GCPhys=%RGp %R[pgmpage]\n", GCPhys, pPage),
+                          VERR_PGM_LOAD_UNEXPECTED_PAGE_TYPE);
+
+    /*
+     * Hand the post-copy fetcher over to the lazy restore state on the first
+     * record when teleporting, otherwise open the side file.
+     */
+    PPGMLAZYRESTORE pLazy = pVM->pgm.s.pLazyRestoreR3;
+    if (!pLazy && pVM->pgm.s.pfnPostCopyFetchR3)
+    {
+        uint32_t const cRanges = RT_MIN(pVM->pgm.s.idRamRangeMax + 1, RT_ELEMENTS(pVM->pgm.s.apRamRanges));
+        pLazy = (PPGMLAZYRESTORE)RTMemAllocZ(RT_UOFFSETOF_DYN(PGMLAZYRESTORE, aRanges[cRanges]));
+        if (pLazy)
+            pLazy->pbPrefetch = (uint8_t *)RTMemPageAlloc(PGM_LAZY_RESTORE_PREFETCH_MAX_PAGES * GUEST_PAGE_SIZE);
+        if (!pLazy || !pLazy->pbPrefetch)
+        {
+            RTMemFree(pLazy);
+            return VERR_NO_MEMORY;
+        }
+        pLazy->hFile       = NIL_RTFILE;
+        pLazy->pfnFetch    = pVM->pgm.s.pfnPostCopyFetchR3;
+        pLazy->pvFetchUser = pVM->pgm.s.pvPostCopyUserR3;
+        pLazy->fLazy       = true; /* The source only serves pages once we're done loading. */
+        pLazy->cRanges     = cRanges;
+        for (uint32_t idRange = 0; idRange < cRanges; idRange++)
+            pLazy->aRanges[idRange].GCPhysHandler = NIL_RTGCPHYS;
+        pVM->pgm.s.pfnPostCopyFetchR3 = NULL;
+        pVM->pgm.s.pvPostCopyUserR3   = NIL_RTR3PTR;
+        pVM->pgm.s.pLazyRestoreR3     = pLazy;
+        LogRel(("PGM: Post-copy: fetching the remaining RAM from the teleportation source on demand\n"));
+    }
+    else if (!pLazy)
+    {
+        const char * const pszState = SSMR3HandleFilename(pSSM);
+        AssertLogRelMsgReturn(pszState, ("RAM side file records in a saved state stream\n"), VERR_SSM_DATA_UNIT_FORMAT_CHANGED);
+        char *pszFile = RTStrAPrintf2("%s" PGM_SAVED_STATE_RAM_FILE_SUFFIX, pszState);
+        AssertReturn(pszFile, VERR_NO_STR_MEMORY);
+
+        RTFILE hFile;
+        int rc = RTFileOpen(&hFile, pszFile, RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_WRITE);
+        if (RT_FAILURE(rc))
+        {
+            rc = SSMR3SetLoadError(pSSM, rc, RT_SRC_POS, N_("Failed to open the saved state RAM file '%s'"), pszFile);
+            RTStrFree(pszFile);
+            return rc;
+        }
+
+        uint32_t const cRanges = RT_MIN(pVM->pgm.s.idRamRangeMax + 1, RT_ELEMENTS(pVM->pgm.s.apRamRanges));
+        pLazy = (PPGMLAZYRESTORE)RTMemAllocZ(RT_UOFFSETOF_DYN(PGMLAZYRESTORE, aRanges[cRanges]));
+        if (pLazy)
+            pLazy->pbPrefetch = (uint8_t *)RTMemPageAlloc(PGM_LAZY_RESTORE_PREFETCH_MAX_PAGES * GUEST_PAGE_SIZE);
+        if (!pLazy || !pLazy->pbPrefetch)
+        {
+            RTMemFree(pLazy);
+            RTFileClose(hFile);
+            RTStrFree(pszFile);
+            return VERR_NO_MEMORY;
+        }
+        pLazy->hFile   = hFile;
+        pLazy->pfnFetch = NULL;
+        pLazy->fLazy   = pVM->pgm.s.fLazyRestore && pgmR3PhysLazyRestoreCanTrap(pVM);
+        if (pVM->pgm.s.fLazyRestore && !pLazy->fLazy)
+            LogRel(("PGM: Lazy restore not possible with the current execution engine, reading the RAM while loading\n"));
+        pLazy->cRanges = cRanges;
+        for (uint32_t idRange = 0; idRange < cRanges; idRange++)
+            pLazy->aRanges[idRange].GCPhysHandler = NIL_RTGCPHYS;
+        pVM->pgm.s.pLazyRestoreR3 = pLazy;
+
+        LogRel(("PGM: Restoring RAM from '%s'%s\n", pszFile, pLazy->fLazy ? " on demand" : ""));
+        RTStrFree(pszFile);
+    }
+
+    /*
+     * Make sure the page is backed by a private page so that the mapping the
+     * access handler gets passed later is the right one.
+     */
+    PGMPAGEMAPLOCK PgMpLck;
+    void          *pvDstPage;
+    int rc = pgmPhysGCPhys2CCPtrInternal(pVM, pPage, GCPhys, &pvDstPage, &PgMpLck);
+    AssertLogRelMsgRCReturn(rc, ("GCPhys=%RGp %R[pgmpage] rc=%Rrc\n", GCPhys, pPage, rc), rc);
+
+    uint32_t const iPage = (uint32_t)((GCPhys - pRam->GCPhys) >> GUEST_PAGE_SHIFT);
+    if (pLazy->fLazy && pRam->idRange < pLazy->cRanges)
+    {
+        PPGMLAZYRESTORERANGE const pRange = &pLazy->aRanges[pRam->idRange];
+        if (!pRange->pbmPending)
+        {
+            pRange->cPages     = (uint32_t)(pRam->cb >> GUEST_PAGE_SHIFT);
+            pRange->pbmPending = (uint64_t *)RTMemAllocZ(RT_ALIGN_32(pRange->cPages, 64) / 8);
+            if (!pRange->pbmPending)
+                rc = VERR_NO_MEMORY;
+        }
+        if (RT_SUCCESS(rc) && iPage < pRange->cPages && !ASMBitTestAndSet(pRange->pbmPending, iPage))
+        {
+            pRange->cPagesLeft++;
+            pLazy->cPagesLeft++;
+        }
+    }
+    else
+    {
+        rc = pgmR3PhysLazyRestoreRead(pLazy, GCPhys, pvDstPage, 1);
+        if (RT_FAILURE(rc))
+            rc = SSMR3SetLoadError(pSSM, rc, RT_SRC_POS, N_("Failed to read page %RGp from the saved state RAM file"), GCPhys);
+    }
+
+    pgmPhysReleaseInternalPageMappingLock(pVM, &PgMpLck);
+    return rc;
+}
+
+
+/**
+ * Protects the pages still pending after loading a state and starts the
+ * background prefetcher.
+ *
+ * Called when the saved state has been loaded.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ */
+int pgmR3PhysLazyRestoreArm(PVM pVM)
+{
+    PGM_LOCK_VOID(pVM);
+
+    /* A post-copy fetcher that didn't get any pages isn't needed any more. */
+    pgmR3PhysPostCopyReleaseFetcher(pVM);
+
+    PPGMLAZYRESTORE const pLazy = pVM->pgm.s.pLazyRestoreR3;
+    if (!pLazy)
+    {
+        PGM_UNLOCK(pVM);
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Without trappable accesses there's nothing to arm, read all the pending
+     * pages before the VM gets to run.  (PGMR3PhysPostCopySetFetcher refuses
+     * post-copy in this case, so this is just the side file.)
+     */
+    if (!pgmR3PhysLazyRestoreCanTrap(pVM))
+    {
+        LogRel(("PGM: Lazy restore: reading the remaining %u pages now\n", pLazy->cPagesLeft));
+        int rc = pgmR3PhysLazyRestorePrefetchLocked(pVM, UINT32_MAX);
+        if (pVM->pgm.s.pLazyRestoreR3)
+            pgmR3PhysLazyRestoreDestroyLocked(pVM, pVM->pgm.s.pLazyRestoreR3);
+        PGM_UNLOCK(pVM);
+        return rc;
+    }
+
+    /*
+     * Register one handler per RAM range, spanning from the first to the last
+     * pending page, and punch holes in it for the pages that are not pending.
+     * Should this fail because something else is monitoring the range, we
+     * just read the pages now.
+     */
+    int rc = VINF_SUCCESS;
+    for (uint32_t idRange = 0; idRange < pLazy->cRanges && pLazy->cPagesLeft && RT_SUCCESS(rc); idRange++)
+    {
+        PPGMLAZYRESTORERANGE const pRange = &pLazy->aRanges[idRange];
+        if (!pRange->cPagesLeft)
+            continue;
+        PPGMRAMRANGE const pRam = pVM->pgm.s.apRamRanges[idRange];
+        AssertLogRelBreakStmt(pRam && pRam->cb >> GUEST_PAGE_SHIFT == pRange->cPages, rc = VERR_PGM_PHYS_HANDLER_IPE);
+
+        uint32_t const iFirst = (uint32_t)ASMBitFirstSet(pRange->pbmPending, pRange->cPages);
+        uint32_t       iLast  = pRange->cPages - 1;
+        while (!ASMBitTest(pRange->pbmPending, iLast))
+            iLast--;
+        RTGCPHYS const GCPhysFirst = pRam->GCPhys + ((RTGCPHYS)iFirst << GUEST_PAGE_SHIFT);
+        rc = PGMHandlerPhysicalRegister(pVM, GCPhysFirst, pRam->GCPhys + ((RTGCPHYS)iLast << GUEST_PAGE_SHIFT) + GUEST_PAGE_OFFSET_MASK,
+                                        pVM->pgm.s.hLazyRestorePhysHandlerType, 0 /*uUser*/, pRam->pszDesc);
+        if (RT_SUCCESS(rc))
+        {
+            pRange->GCPhysHandler = GCPhysFirst;
+            for (uint32_t iPage = iFirst + 1; iPage < iLast && RT_SUCCESS(rc); iPage++)
+                if (!ASMBitTest(pRange->pbmPending, iPage))
+                    rc = PGMHandlerPhysicalPageTempOff(pVM, GCPhysFirst, pRam->GCPhys + ((RTGCPHYS)iPage << GUEST_PAGE_SHIFT));
+            AssertLogRelRC(rc);
+        }
+        else
+        {
+            LogRel(("PGM: Failed to register the lazy restore handler for %RGp-%RGp (%Rrc), reading %u pages now\n",
+                    pRam->GCPhys, pRam->GCPhysLast, rc, pRange->cPagesLeft));
+            rc = VINF_SUCCESS;
+            for (uint32_t iPage = iFirst; iPage <= iLast && RT_SUCCESS(rc); iPage++)
+                if (ASMBitTest(pRange->pbmPending, iPage))
+                    rc = pgmR3PhysLazyRestoreFillPageLocked(pVM, pLazy, pRam, iPage, NULL /*pvSrc*/);
+            if (!pVM->pgm.s.pLazyRestoreR3)
+                break; /* That was the last one. */
+        }
+    }
+
+    if (pVM->pgm.s.pLazyRestoreR3 == pLazy)
+    {
+        if (RT_SUCCESS(rc) && pLazy->cPagesLeft)
+        {
+            pLazy->cPagesArmed = pLazy->cPagesLeft;
+            pLazy->nsArmed     = RTTimeNanoTS();
+            LogRel(("PGM: Lazy restore: %u pages left to read on demand%s\n", pLazy->cPagesLeft,
+                    pVM->pgm.s.hLazyRestoreTimer != NIL_TMTIMERHANDLE ? " and in the background" : ""));
+            if (pVM->pgm.s.hLazyRestoreTimer != NIL_TMTIMERHANDLE)
+                TMTimerSetMillies(pVM, pVM->pgm.s.hLazyRestoreTimer, pVM->pgm.s.cMsLazyRestorePrefetchInterval);
+        }
+        else
+            pgmR3PhysLazyRestoreDestroyLocked(pVM, pLazy);
+    }
+    PGM_UNLOCK(pVM);
+    return rc;
+}
+
+
+/**
+ * Reads up to @a cMaxPages pending pages, starting at the prefetch cursor.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   cMaxPages   The max number of pages to read, UINT32_MAX for all.
+ */
+static int pgmR3PhysLazyRestorePrefetchLocked(PVM pVM, uint32_t cMaxPages)
+{
+    PGM_LOCK_ASSERT_OWNER(pVM);
+    PPGMLAZYRESTORE const pLazy = pVM->pgm.s.pLazyRestoreR3;
+    if (!pLazy)
+        return VINF_SUCCESS;
+    AssertReturn(!pLazy->fPrefetching, VERR_WRONG_ORDER);
+
+    int      rc        = VINF_SUCCESS;
+    uint32_t cWrapped  = 0;
+    while (cMaxPages > 0 && pLazy->cPagesLeft > 0 && RT_SUCCESS(rc))
+    {
+        /*
+         * Find the next run of pending pages.
+         */
+        if (pLazy->idPrefetchRange >= pLazy->cRanges)
+        {
+            AssertBreak(cWrapped++ < 2);
+            pLazy->idPrefetchRange = 0;
+            pLazy->iPrefetchPage   = 0;
+        }
+        PPGMLAZYRESTORERANGE const pRange = &pLazy->aRanges[pLazy->idPrefetchRange];
+        PPGMRAMRANGE const         pRam   = pVM->pgm.s.apRamRanges[pLazy->idPrefetchRange];
+        int32_t iFirst = -1;
+        if (pRange->cPagesLeft && pRam && pLazy->iPrefetchPage < pRange->cPages)
+            iFirst = pLazy->iPrefetchPage == 0
+                   ? ASMBitFirstSet(pRange->pbmPending, pRange->cPages)
+                   : ASMBitNextSet(pRange->pbmPending, pRange->cPages, pLazy->iPrefetchPage - 1);
+        if (iFirst < 0)
+        {
+            pLazy->idPrefetchRange++;
+            pLazy->iPrefetchPage = 0;
+            continue;
+        }
+
+        uint32_t const cMaxRun = RT_MIN(cMaxPages, PGM_LAZY_RESTORE_PREFETCH_MAX_PAGES);
+        uint32_t       cRun    = 1;
+        while (   cRun < cMaxRun
+               && (uint32_t)iFirst + cRun < pRange->cPages
+               && ASMBitTest(pRange->pbmPending, iFirst + cRun))
+            cRun++;
+        pLazy->iPrefetchPage = iFirst + cRun;
+        cMaxPages -= cRun;
+
+        /*
+         * Read them without holding up the EMTs, then fill in the ones that
+         * weren't touched meanwhile.
+         */
+        RTGCPHYS const GCPhysFirst = pRam->GCPhys + ((RTGCPHYS)iFirst << GUEST_PAGE_SHIFT);
+        uint32_t const idRange     = pRam->idRange;
+        pLazy->fPrefetching = true;
+        PGM_UNLOCK(pVM);
+        rc = pgmR3PhysLazyRestoreRead(pLazy, GCPhysFirst, pLazy->pbPrefetch, cRun);
+        PGM_LOCK_VOID(pVM);
+        pLazy->fPrefetching = false;
+
+        if (RT_SUCCESS(rc))
+        {
+            PPGMRAMRANGE const pRamNow = pVM->pgm.s.apRamRanges[idRange];
+            for (uint32_t i = 0; i < cRun && pLazy->cPagesLeft; i++)
+                if (   pRamNow == pRam
+                    && ASMBitTest(pRange->pbmPending, iFirst + i))
+                    pgmR3PhysLazyRestoreFillPageLocked(pVM, pLazy, pRam, iFirst + i, &pLazy->pbPrefetch[i << GUEST_PAGE_SHIFT]);
+        }
+        else
+        {
+            LogRel(("PGM: Failed to read %u pages at %RGp from the %s: %Rrc\n",
+                    cRun, GCPhysFirst, pLazy->pfnFetch ? "teleportation source" : "saved state RAM file", rc));
+            VMSetRuntimeError(pVM, VMSETRTERR_FLAGS_FATAL, "PGMLazyRestoreReadError",
+                              N_("Failed to read guest memory from the saved state RAM file or teleportation source (%Rrc)"), rc);
+        }
+
+        if (!pLazy->cPagesLeft)
+        {
+            pgmR3PhysLazyRestoreCompletedLocked(pVM, pLazy);
+            break;
+        }
+    }
+    return rc;
+}
+
+
+/**
+ * Runs the prefetcher once and re-arms its timer.
+ *
+ * @param   pVM         The cross context VM structure.
+ */
+static DECLCALLBACK(void) pgmR3PhysLazyRestorePrefetchHelper(PVM pVM)
+{
+    PGM_LOCK_VOID(pVM);
+    int rc = pgmR3PhysLazyRestorePrefetchLocked(pVM, pVM->pgm.s.cLazyRestorePrefetchPages);
+    if (RT_SUCCESS(rc) && pVM->pgm.s.pLazyRestoreR3)
+        TMTimerSetMillies(pVM, pVM->pgm.s.hLazyRestoreTimer, pVM->pgm.s.cMsLazyRestorePrefetchInterval);
+    PGM_UNLOCK(pVM);
+}
+
+
+/**
+ * @callback_method_impl{FNTMTIMERINT, Kicks off a lazy restore prefetcher run.}
+ */
+static DECLCALLBACK(void) pgmR3PhysLazyRestoreTimer(PVM pVM, TMTIMERHANDLE hTimer, void *pvUser)
+{
+    RT_NOREF(hTimer, pvUser);
+
+    /* Don't do file I/O in the timer callback, queue the work for EMT(0).  Sticking to
+       EMT(0), which is also where states get saved, means there is only ever one
+       prefetcher running.  The timer is re-armed when it's done. */
+    int rc = VMR3ReqCallNoWait(pVM, 0 /*idDstCpu*/, (PFNRT)pgmR3PhysLazyRestorePrefetchHelper, 1, pVM);
+    AssertLogRelRC(rc);
+}
+
+
+/**
+ * Reads the configuration and registers the access handler type and timer
+ * used for lazily restoring saved state RAM.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ */
+int pgmR3PhysLazyRestoreInit(PVM pVM)
+{
+    pVM->pgm.s.pLazyRestoreR3              = NULL;
+    pVM->pgm.s.pfnPostCopyFetchR3          = NULL;
+    pVM->pgm.s.pvPostCopyUserR3            = NIL_RTR3PTR;
+    pVM->pgm.s.pIncrSaveR3                 = NULL;
+    pVM->pgm.s.pIncrSavePendingR3          = NULL;
+    pVM->pgm.s.pIncrLoadR3                 = NULL;
+    pVM->pgm.s.pSaveBgWriterR3             = NULL;
+    pVM->pgm.s.hLazyRestorePhysHandlerType = NIL_PGMPHYSHANDLERTYPE;
+    pVM->pgm.s.hLazyRestoreTimer           = NIL_TMTIMERHANDLE;
+
+    PCFGMNODE const pCfgPgm = CFGMR3GetChild(CFGMR3GetRoot(pVM), "/PGM");
+
+    /** @cfgm{/PGM/SaveRamToSideFile, bool, false}
+     * Whether a non-live save should put the non-zero RAM pages in a page
+     * aligned, uncompressed side file next to the saved state (the state
+     * filename with ".ram" appended) instead of in the compressed saved state
+     * stream.  A state saved like this can be restored lazily, see
+     * /PGM/LazyRestore/Enabled.  Ignored when teleporting. */
+    int rc = CFGMR3QueryBoolDef(pCfgPgm, "SaveRamToSideFile", &pVM->pgm.s.fSaveRamToSideFile, false);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/PGM/IncrementalSave, bool, false}
+     * Whether a save with a RAM side file (see /PGM/SaveRamToSideFile) should
+     * only write the RAM pages that changed since the previous save of this VM
+     * process, referencing the side file of that save for the others.  Pages
+     * with an unchanged CRC-64 are compared with the earlier side file before
+     * being referenced.  All the side files in the chain must be kept for the
+     * state to be loadable. */
+    rc = CFGMR3QueryBoolDef(pCfgPgm, "IncrementalSave", &pVM->pgm.s.fIncrementalSave, false);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/PGM/IncrementalSaveMaxDepth, uint8_t, 2, 32, 8}
+     * The max number of side files an incremental save may reference,
+     * including its own.  Unchanged pages which would go deeper are written
+     * again, so the chain doesn't grow without bounds. */
+    rc = CFGMR3QueryU8Def(pCfgPgm, "IncrementalSaveMaxDepth", &pVM->pgm.s.cIncrementalSaveMaxDepth, 8);
+    AssertLogRelRCReturn(rc, rc);
+    if (   pVM->pgm.s.cIncrementalSaveMaxDepth < 2
+        || pVM->pgm.s.cIncrementalSaveMaxDepth > 32)
+        return VMSetError(pVM, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                          "Configuration error: /PGM/IncrementalSaveMaxDepth=%u is out of range (2..32)",
+                          pVM->pgm.s.cIncrementalSaveMaxDepth);
+
+    /** @cfgm{/PGM/LiveSaveRamBackground, bool, false}
+     * Whether the final pass of a live save to a file should copy the dirty
+     * RAM pages to memory and leave writing them to a side file (see
+     * /PGM/SaveRamToSideFile) to a background thread, so that the VM can be
+     * resumed without waiting for the I/O.  The side file is incomplete until
+     * the thread is done, which is waited for before the next save or load
+     * and when the VM is destroyed. */
+    rc = CFGMR3QueryBoolDef(pCfgPgm, "LiveSaveRamBackground", &pVM->pgm.s.fLiveSaveRamBackground, false);
+    AssertLogRelRCReturn(rc, rc);
+
+    PCFGMNODE const pCfg = CFGMR3GetChild(pCfgPgm, "LazyRestore");
+
+    /** @cfgm{/PGM/LazyRestore/Enabled, bool, true}
+     * Whether RAM pages kept in the saved state side file are read on demand
+     * after the VM has been resumed (true), or while loading the state (false). */
+    rc = CFGMR3QueryBoolDef(pCfg, "Enabled", &pVM->pgm.s.fLazyRestore, true);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/PGM/LazyRestore/PrefetchPages, uint32_t, 1024}
+     * The number of pending pages the background prefetcher reads per run, 0
+     * to only read pages when the guest or a device touches them. */
+    rc = CFGMR3QueryU32Def(pCfg, "PrefetchPages", &pVM->pgm.s.cLazyRestorePrefetchPages, 1024);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/PGM/LazyRestore/PrefetchIntervalMs, uint32_t, 10}
+     * The interval between background prefetcher runs in milliseconds. */
+    rc = CFGMR3QueryU32Def(pCfg, "PrefetchIntervalMs", &pVM->pgm.s.cMsLazyRestorePrefetchInterval, 10);
+    AssertLogRelRCReturn(rc, rc);
+    if (   pVM->pgm.s.cMsLazyRestorePrefetchInterval < 1
+        || pVM->pgm.s.cMsLazyRestorePrefetchInterval > RT_MS_1SEC)
+        return VMSetError(pVM, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                          "Configuration error: /PGM/LazyRestore/PrefetchIntervalMs=%u is out of range (1..1000)",
+                          pVM->pgm.s.cMsLazyRestorePrefetchInterval);
+
+    rc = PGMR3HandlerPhysicalTypeRegister(pVM, PGMPHYSHANDLERKIND_ALL, 0 /*fFlags*/, pgmR3PhysLazyRestoreHandler,
+                                          "Lazy saved state RAM", &pVM->pgm.s.hLazyRestorePhysHandlerType);
+    AssertLogRelRCReturn(rc, rc);
+
+    if (pVM->pgm.s.cLazyRestorePrefetchPages)
+    {
+        rc = TMR3TimerCreate(pVM, TMCLOCK_REAL, pgmR3PhysLazyRestoreTimer, NULL, TMTIMER_FLAGS_NO_RING0,
+                             "PGM lazy restore prefetcher", &pVM->pgm.s.hLazyRestoreTimer);
+        AssertLogRelRCReturn(rc, rc);
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Reads all the pages still pending, for code that accesses guest RAM without
+ * respecting access handlers (e.g. saving the state).
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ */
+int pgmR3PhysLazyRestoreFlush(PVM pVM)
+{
+    PGM_LOCK_VOID(pVM);
+    int rc = VINF_SUCCESS;
+    PPGMLAZYRESTORE const pLazy = pVM->pgm.s.pLazyRestoreR3;
+    if (pLazy)
+    {
+        LogRel(("PGM: Lazy restore: reading the remaining %u pages now\n", pLazy->cPagesLeft));
+        rc = pgmR3PhysLazyRestorePrefetchLocked(pVM, UINT32_MAX);
+        if (pVM->pgm.s.pLazyRestoreR3)
+            pgmR3PhysLazyRestoreDestroyLocked(pVM, pVM->pgm.s.pLazyRestoreR3);
+    }
+    PGM_UNLOCK(pVM);
+    return rc;
+}
+
+
+/**
+ * Abandons any lazy restore in progress, for reset, loading a new state and
+ * termination.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   fTerm       Set when terminating, clear for reset.  A post-copy
+ *                      fetcher registered for the next load only survives
+ *                      the latter (loading starts with a reset).
+ */
+void pgmR3PhysLazyRestoreTerm(PVM pVM, bool fTerm)
+{
+    PGM_LOCK_VOID(pVM);
+    PPGMLAZYRESTORE const pLazy = pVM->pgm.s.pLazyRestoreR3;
+    if (pLazy)
+    {
+        LogRel(("PGM: Lazy restore: abandoned with %u pages left\n", pLazy->cPagesLeft));
+        pgmR3PhysLazyRestoreDestroyLocked(pVM, pLazy);
+    }
+    if (fTerm)
+        pgmR3PhysPostCopyReleaseFetcher(pVM);
+    PGM_UNLOCK(pVM);
+}
+
+
+/**
+ * Makes the final pass of the next live save leave the dirty RAM pages for
+ * the target to fetch once it's running (post-copy teleportation).
+ *
+ * The caller must then keep the source VM suspended and serve the pages using
+ * PGMR3PhysPostCopyRead until the target is done with them.  The setting only
+ * applies to the next live save.
+ *
+ * @returns VBox status code.
+ * @param   pUVM        The user mode VM handle.
+ * @param   fEnable     Whether to enable or disable it.
+ */
+VMMR3DECL(int) PGMR3PhysPostCopyEnable(PUVM pUVM, bool fEnable)
+{
+    UVM_ASSERT_VALID_EXT_RETURN(pUVM, VERR_INVALID_VM_HANDLE);
+    PVM pVM = pUVM->pVM;
+    VM_ASSERT_VALID_EXT_RETURN(pVM, VERR_INVALID_VM_HANDLE);
+
+    PGM_LOCK_VOID(pVM);
+    pVM->pgm.s.fPostCopySave = fEnable;
+    PGM_UNLOCK(pVM);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Reads guest RAM pages for a post-copy teleportation target.
+ *
+ * @returns VBox status code.
+ * @param   pUVM        The user mode VM handle.
+ * @param   GCPhys      The address of the first page.
+ * @param   pvBuf       Where to put the page content.
+ * @param   cPages      The number of pages.
+ * @thread  Any thread, the VM should be suspended.
+ */
+VMMR3DECL(int) PGMR3PhysPostCopyRead(PUVM pUVM, RTGCPHYS GCPhys, void *pvBuf, uint32_t cPages)
+{
+    UVM_ASSERT_VALID_EXT_RETURN(pUVM, VERR_INVALID_VM_HANDLE);
+    PVM pVM = pUVM->pVM;
+    VM_ASSERT_VALID_EXT_RETURN(pVM, VERR_INVALID_VM_HANDLE);
+    AssertReturn(!(GCPhys & GUEST_PAGE_OFFSET_MASK), VERR_INVALID_PARAMETER);
+    AssertReturn(cPages > 0 && cPages <= PGM_LAZY_RESTORE_PREFETCH_MAX_PAGES, VERR_OUT_OF_RANGE);
+
+    return PGMR3PhysReadExternal(pVM, GCPhys, pvBuf, (size_t)cPages << GUEST_PAGE_SHIFT, PGMACCESSORIGIN_DEBUGGER);
+}
+
+
+/**
+ * Registers the post-copy page fetcher for the next state load.
+ *
+ * If the loaded state leaves pages for post-copy, they're fetched using
+ * @a pfnFetch when the target VM touches them and in the background once it's
+ * running.  In any case, @a pfnFetch gets called with cPages = 0 once it
+ * won't be used any more.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NOT_SUPPORTED if the execution engine can't trap the guest's
+ *          accesses to the pages left behind (NEM), @a pfnFetch is not
+ *          registered then.
+ * @param   pUVM        The user mode VM handle.
+ * @param   pfnFetch    The fetcher, NULL to drop the one registered (which is
+ *                      then called with cPages = 0).
+ * @param   pvUser      The user argument of @a pfnFetch.
+ */
+VMMR3DECL(int) PGMR3PhysPostCopySetFetcher(PUVM pUVM, PFNPGMPOSTCOPYFETCH pfnFetch, void *pvUser)
+{
+    UVM_ASSERT_VALID_EXT_RETURN(pUVM, VERR_INVALID_VM_HANDLE);
+    PVM pVM = pUVM->pVM;
+    VM_ASSERT_VALID_EXT_RETURN(pVM, VERR_INVALID_VM_HANDLE);
+
+    /* Post-copy depends on trapping the guest's accesses to the pages left behind. */
+    if (pfnFetch && !pgmR3PhysLazyRestoreCanTrap(pVM))
+        return VERR_NOT_SUPPORTED;
+
+    PGM_LOCK_VOID(pVM);
+    pgmR3PhysPostCopyReleaseFetcher(pVM);
+    pVM->pgm.s.pfnPostCopyFetchR3 = pfnFetch;
+    pVM->pgm.s.pvPostCopyUserR3   = pfnFetch ? pvUser : NIL_RTR3PTR;
+    PGM_UNLOCK(pVM);
+    return VINF_SUCCESS;
+}
+
+
 /*********************************************************************************************************************************
 *   Stats.                                                                                                                       *
 *********************************************************************************************************************************/
@@ -32,10 +32,12 @@
 #define LOG_GROUP LOG_GROUP_PGM
 #define VBOX_WITHOUT_PAGING_BIT_FIELDS /* 64-bit bitfields are just asking for trouble. See @bugref{9841} and others. */
 #include <VBox/vmm/pgm.h>
+#include <VBox/vmm/cfgm.h>
 #include <VBox/vmm/stam.h>
 #include <VBox/vmm/ssm.h>
 #include <VBox/vmm/pdmdrv.h>
 #include <VBox/vmm/pdmdev.h>
+#include <VBox/vmm/nem.h>
 #include "PGMInternal.h"
 #include <VBox/vmm/vmcc.h>
 #include "PGMInline.h"
@@ -46,7 +48,9 @@
 #include <iprt/asm.h>
 #include <iprt/assert.h>
 #include <iprt/crc.h>
+#include <iprt/file.h>
 #include <iprt/mem.h>
+#include <iprt/path.h>
 #include <iprt/sha.h>
 #include <iprt/string.h>
 #include <iprt/thread.h>
@@ -102,8 +106,19 @@
 #define PGM_STATE_REC_ROM_PROT          UINT8_C(0x07)
 /** Ballooned page. No data. */
 #define PGM_STATE_REC_RAM_BALLOONED     UINT8_C(0x08)
+/** Raw page kept in the RAM side file at offset GCPhys. No data.
+ * See PGM_SAVED_STATE_RAM_FILE_SUFFIX and /PGM/SaveRamToSideFile. */
+#define PGM_STATE_REC_RAM_FILE          UINT8_C(0x09)
+/** Raw page kept in the RAM side file of an earlier save at offset GCPhys.
+ * The 8-bit index into the side file chain (1 = parent) is the only data.
+ * See PGM_STATE_REC_RAM_FILE_CHAIN and /PGM/IncrementalSave. */
+#define PGM_STATE_REC_RAM_PARENT        UINT8_C(0x0a)
+/** The side file chain of an incremental save: The 8-bit number of earlier
+ * side files followed by their zero terminated paths, parent first.  Precedes
+ * the first PGM_STATE_REC_RAM_PARENT record. */
+#define PGM_STATE_REC_RAM_FILE_CHAIN    UINT8_C(0x0b)
 /** The last record type. */
-#define PGM_STATE_REC_LAST              PGM_STATE_REC_RAM_BALLOONED
+#define PGM_STATE_REC_LAST              PGM_STATE_REC_RAM_FILE_CHAIN
 /** End marker. */
 #define PGM_STATE_REC_END               UINT8_C(0xff)
 /** Flag indicating that the data is preceded by the page address.
@@ -113,11 +128,45 @@
 #define PGM_STATE_REC_FLAG_ADDR         UINT8_C(0x80)
 /** @} */
 
+/** The size of the staging buffer pgmR3SaveRamPages collects RAM records in
+ * before handing them to SSM in one go, so that SSM can compress the pages on
+ * its worker threads. */
+#define PGM_SAVE_RAM_BATCH_SIZE         _512K
+/** The max size of a RAM record in the staging buffer. */
+#define PGM_SAVE_RAM_BATCH_REC_MAX      (1 + sizeof(RTGCPHYS) + GUEST_PAGE_SIZE)
+/** The size of the buffer pgmR3SaveRamPages collects runs of pages going to
+ * the RAM side file in. */
+#define PGM_SAVE_RAM_FILE_RUN_SIZE      _256K
+/** The number of passes auto-converge waits between tightening the CPU
+ * execution cap, giving the previous step time to take effect. */
+#define PGM_LIVE_AUTO_CONVERGE_PASSES   4
+/** The CPU execution cap step auto-converge tightens by (percent). */
+#define PGM_LIVE_AUTO_CONVERGE_STEP     20
+/** The number of live passes to do before handing over in post-copy mode. */
+#define PGM_LIVE_POST_COPY_PASSES       8
+/** The max number of bytes the final live pass queues for the background side
+ * file writer, runs beyond that are written synchronously.
+ * See /PGM/LiveSaveRamBackground. */
+#define PGM_SAVE_BG_WRITER_MAX          (512 * _1M)
+
+/** The max number of side files in the chain of an incremental save.
+ * See /PGM/IncrementalSaveMaxDepth. */
+#define PGM_INCR_SAVE_MAX_FILES         32
+/** PGMINCRSAVERANGE::pau8File value for pages not in any side file. */
+#define PGM_INCR_SAVE_NOT_IN_FILE       UINT8_MAX
+
 /** The CRC-32 for a zero page. */
 #define PGM_STATE_CRC32_ZERO_PAGE       UINT32_C(0xc71c0011)
 /** The CRC-32 for a zero half page. */
 #define PGM_STATE_CRC32_ZERO_HALF_PAGE  UINT32_C(0xf1e8ba9e)
 
+#ifdef VBOX_WITH_NATIVE_NEM
+/** Checks if NEM dirty page logging is used for the given RAM range during
+ * live save. */
+# define PGM_LS_RAM_RANGE_USES_NEM_DIRTY_LOG(a_pVM, a_pRam) \
+    ((a_pVM)->pgm.s.LiveSave.fNemDirtyLog && (a_pRam)->uNemRange != UINT32_MAX && (a_pRam)->pbR3 != NULL)
+#endif
+
 
 
 /** @name Old Page types used in older saved states.
@@ -164,6 +213,113 @@ typedef struct
 } PGMOLD;
 
 
+/**
+ * Incremental save tracking for a RAM range.
+ */
+typedef struct PGMINCRSAVERANGE
+{
+    /** The address of the range, for detecting a different range reusing the ID. */
+    RTGCPHYS                GCPhys;
+    /** The number of pages, 0 if not tracked. */
+    uint32_t                cPages;
+    /** The CRC-64 of each page as saved. */
+    uint64_t               *pau64Crc;
+    /** The index of the side file in the chain holding each page,
+     *  PGM_INCR_SAVE_NOT_IN_FILE for zero and ballooned pages. */
+    uint8_t                *pau8File;
+} PGMINCRSAVERANGE;
+/** Pointer to the incremental save tracking of a RAM range. */
+typedef PGMINCRSAVERANGE *PPGMINCRSAVERANGE;
+
+/**
+ * Incremental save tracking, see /PGM/IncrementalSave.
+ *
+ * Describes what the side files of the last save and its ancestors hold, so
+ * the next save only needs to write pages with a different checksum.  A page
+ * with a matching checksum is compared with the copy in the earlier side file
+ * before it is referenced, so a CRC-64 collision costs a write and not the
+ * page content.
+ */
+typedef struct PGMINCRSAVE
+{
+    /** The number of side files in the chain. */
+    uint32_t                cFiles;
+    /** The side file paths, the one of the save itself first. */
+    char                   *apszFiles[PGM_INCR_SAVE_MAX_FILES];
+    /** The earlier side files opened for reading while saving, NIL_RTFILE
+     * otherwise.  The entry for the save itself is always NIL_RTFILE. */
+    RTFILE                  ahFiles[PGM_INCR_SAVE_MAX_FILES];
+    /** Statistics: Pages written to the side file of the save. */
+    uint32_t                cPagesWritten;
+    /** Statistics: Pages referencing an earlier side file. */
+    uint32_t                cPagesReferenced;
+    /** Statistics: Pages with a matching checksum but different content. */
+    uint32_t                cPagesMismatched;
+    /** Buffer for reading a page back from an earlier side file. */
+    uint8_t                 abPage[GUEST_PAGE_SIZE];
+    /** The number of entries in aRanges. */
+    uint32_t                cRanges;
+    /** Per RAM range tracking, indexed by RAM range ID. */
+    PGMINCRSAVERANGE        aRanges[RT_FLEXIBLE_ARRAY];
+} PGMINCRSAVE;
+/** Pointer to incremental save tracking. */
+typedef PGMINCRSAVE *PPGMINCRSAVE;
+
+/**
+ * The earlier side files of the incremental state being loaded.
+ */
+typedef struct PGMINCRLOAD
+{
+    /** The number of entries in ahFiles, including the unused first one. */
+    uint32_t                cFiles;
+    /** The side file handles, indexed by chain index.  The side file of the
+     *  state itself (index 0) is dealt with by the lazy restore code. */
+    RTFILE                  ahFiles[PGM_INCR_SAVE_MAX_FILES];
+} PGMINCRLOAD;
+/** Pointer to the earlier side files of an incremental state being loaded. */
+typedef PGMINCRLOAD *PPGMINCRLOAD;
+
+/**
+ * A run of RAM pages queued for the background side file writer.
+ */
+typedef struct PGMSAVEBGRUN
+{
+    /** The next run. */
+    struct PGMSAVEBGRUN    *pNext;
+    /** The guest physical address of the first page, i.e. the file offset. */
+    RTGCPHYS                GCPhys;
+    /** The number of bytes. */
+    size_t                  cb;
+    /** The page contents. */
+    RT_FLEXIBLE_ARRAY_EXTENSION
+    uint8_t                 abData[RT_FLEXIBLE_ARRAY];
+} PGMSAVEBGRUN;
+/** Pointer to a queued run of RAM pages. */
+typedef PGMSAVEBGRUN *PPGMSAVEBGRUN;
+
+/**
+ * Background side file writer for the final pass of a live save,
+ * see /PGM/LiveSaveRamBackground.
+ */
+typedef struct PGMSAVEBGWRITER
+{
+    /** The side file. */
+    RTFILE                  hFile;
+    /** The writer thread, NIL_RTTHREAD if not started. */
+    RTTHREAD                hThread;
+    /** The queued runs, in address order. */
+    PPGMSAVEBGRUN           pHead;
+    /** The last queued run. */
+    PPGMSAVEBGRUN           pTail;
+    /** The number of bytes queued. */
+    size_t                  cbQueued;
+    /** The status of the write out. */
+    int                     rc;
+} PGMSAVEBGWRITER;
+/** Pointer to a background side file writer. */
+typedef PGMSAVEBGWRITER *PPGMSAVEBGWRITER;
+
+
 /*********************************************************************************************************************************
 *   Global Variables                                                                                                             *
 *********************************************************************************************************************************/
@@ -1273,6 +1429,50 @@ static int pgmR3PrepRamPages(PVM pVM)
             }
         }
     } while (idRamRange <= RT_MIN(pVM->pgm.s.idRamRangeMax, RT_ELEMENTS(pVM->pgm.s.apRamRanges) - 1U));
+
+#ifdef VBOX_WITH_NATIVE_NEM
+    /*
+     * If NEM can log dirty pages for us, enable it for all the RAM ranges we
+     * track.  Not all NEM backends intercept guest writes to write monitored
+     * pages, so this is how pgmR3ScanRamPages gets to know about them.  Writes
+     * made thru PGM (devices, IEM) are still caught by the write monitoring.
+     *
+     * Note! pgmR3DoneRamPages disables it again, also on failure.
+     */
+    pVM->pgm.s.LiveSave.fNemDirtyLog = VM_IS_NEM_ENABLED(pVM);
+    if (pVM->pgm.s.LiveSave.fNemDirtyLog)
+    {
+        uint32_t cEnabled = 0;
+        uint32_t const idRamRangeMax = RT_MIN(pVM->pgm.s.idRamRangeMax, RT_ELEMENTS(pVM->pgm.s.apRamRanges) - 1U);
+        for (idRamRange = 0; idRamRange <= idRamRangeMax; idRamRange++)
+        {
+            PPGMRAMRANGE const pCur = pVM->pgm.s.apRamRanges[idRamRange];
+            if (   pCur
+                && pCur->paLSPages
+                && PGM_LS_RAM_RANGE_USES_NEM_DIRTY_LOG(pVM, pCur))
+            {
+                int rc = NEMR3PhysRamDirtyTracking(pVM, pCur->GCPhys, pCur->cb, pCur->pbR3, pCur->uNemRange, true /*fEnable*/);
+                if (RT_SUCCESS(rc))
+                    cEnabled++;
+                else if (rc == VERR_NOT_SUPPORTED && cEnabled == 0)
+                {
+                    pVM->pgm.s.LiveSave.fNemDirtyLog = false;
+                    break;
+                }
+                else
+                {
+                    PGM_UNLOCK(pVM);
+                    return rc;
+                }
+            }
+        }
+        if (cEnabled)
+            LogRel(("PGM: Using NEM dirty page logging for %u RAM range(s) during live save\n", cEnabled));
+        else
+            pVM->pgm.s.LiveSave.fNemDirtyLog = false;
+    }
+#endif
+
     PGM_UNLOCK(pVM);
 
     return VINF_SUCCESS;
@@ -1411,6 +1611,92 @@ static void pgmR3StateVerifyCrc32ForRamPage(PVM pVM, PPGMRAMRANGE pCur, PPGMLIVE
 
 #endif /* PGMLIVESAVERAMPAGE_WITH_CRC32 */
 
+#ifdef VBOX_WITH_NATIVE_NEM
+/**
+ * Fetches and resets the NEM dirty page bitmap of a RAM range.
+ *
+ * @returns Pointer to the bitmap on success.  NULL on failure, in which case
+ *          the caller must consider all write monitored pages dirty.
+ * @param   pVM         The cross context VM structure.
+ * @param   pRam        The RAM range.
+ * @param   ppbmBuf     Pointer to the bitmap buffer variable, reallocated as
+ *                      needed.  Caller frees it using RTMemFree.
+ * @param   pcbBuf      Pointer to the bitmap buffer size variable.
+ */
+static uint64_t const *pgmR3ScanRamPagesFetchNemDirtyBitmap(PVM pVM, PPGMRAMRANGE pRam, uint64_t **ppbmBuf, size_t *pcbBuf)
+{
+    size_t const cbBitmap = RT_ALIGN_Z((size_t)(pRam->cb >> GUEST_PAGE_SHIFT), 64) / 8;
+    if (*pcbBuf < cbBitmap)
+    {
+        RTMemFree(*ppbmBuf);
+        *ppbmBuf = (uint64_t *)RTMemAlloc(cbBitmap);
+        *pcbBuf  = *ppbmBuf ? cbBitmap : 0;
+        if (!*ppbmBuf)
+            return NULL;
+    }
+
+    int rc = NEMR3PhysRamQueryAndResetDirtyBitmap(pVM, pRam->GCPhys, pRam->cb, pRam->uNemRange, *ppbmBuf, cbBitmap);
+    if (RT_SUCCESS(rc))
+        return *ppbmBuf;
+    LogRel(("PGM: Failed to query the NEM dirty bitmap for %RGp LB %RGp: %Rrc\n", pRam->GCPhys, pRam->cb, rc));
+    return NULL;
+}
+
+
+#endif
+/**
+ * Scans a write monitored RAM page for modifications.
+ *
+ * A write monitored page is considered modified if it is write locked or if
+ * the NEM dirty page log says the guest wrote to it since the last scan.  A
+ * modified page is marked dirty so the next save pass sends it again, and it
+ * isn't considered ready until it has been quiet for one scan.
+ *
+ * @param   pVM                 The cross context VM structure.
+ * @param   pCur                The current RAM range.
+ * @param   paLSPages           The current array of live save page tracking
+ *                              structures.
+ * @param   iPage               The page index.
+ * @param   fNemDirty           Whether the NEM dirty page log has the page as
+ *                              written to (or the log is unavailable).
+ */
+void pgmR3ScanWriteMonitoredRamPage(PVM pVM, PPGMRAMRANGE pCur, PPGMLIVESAVERAMPAGE paLSPages, uint32_t iPage, bool fNemDirty)
+{
+    Assert(PGM_PAGE_GET_STATE(&pCur->aPages[iPage]) == PGM_PAGE_STATE_WRITE_MONITORED);
+    Assert(paLSPages[iPage].fWriteMonitored);
+    if (   PGM_PAGE_GET_WRITE_LOCKS(&pCur->aPages[iPage]) == 0
+        && !fNemDirty)
+    {
+#ifdef PGMLIVESAVERAMPAGE_WITH_CRC32
+        if (paLSPages[iPage].fWriteMonitoredJustNow)
+            pgmR3StateCalcCrc32ForRamPage(pVM, pCur, paLSPages, iPage);
+        else
+            pgmR3StateVerifyCrc32ForRamPage(pVM, pCur, paLSPages, iPage, "scan");
+#endif
+        paLSPages[iPage].fWriteMonitoredJustNow = 0;
+    }
+    else
+    {
+        paLSPages[iPage].fWriteMonitoredJustNow = 1;
+#ifdef PGMLIVESAVERAMPAGE_WITH_CRC32
+        paLSPages[iPage].u32Crc                 = UINT32_MAX; /* invalid */
+#endif
+        if (!paLSPages[iPage].fDirty)
+        {
+            pVM->pgm.s.LiveSave.Ram.cReadyPages--;
+            if (paLSPages[iPage].fZero)
+                pVM->pgm.s.LiveSave.Ram.cZeroPages--;
+            pVM->pgm.s.LiveSave.Ram.cDirtyPages++;
+            if (++paLSPages[iPage].cDirtied > PGMLIVSAVEPAGE_MAX_DIRTIED)
+                paLSPages[iPage].cDirtied = PGMLIVSAVEPAGE_MAX_DIRTIED;
+        }
+        paLSPages[iPage].fDirty                 = 1;
+        paLSPages[iPage].fZero                  = 0;
+        paLSPages[iPage].fShared                = 0;
+    }
+}
+
+
 /**
  * Scan for RAM page modifications and reprotect them.
  *
@@ -1425,6 +1711,14 @@ static void pgmR3ScanRamPages(PVM pVM, bool fFinalPass)
     RTGCPHYS GCPhysCur = 0;
     uint32_t idxLookup;
     uint32_t cLookupEntries;
+#ifdef VBOX_WITH_NATIVE_NEM
+    /* The NEM dirty bitmap is fetched once per range and kept across
+       restarts, otherwise the bits for the remainder of the range are lost. */
+    PPGMRAMRANGE    pNemDirtyRam     = NULL;
+    uint64_t const *pbmNemDirtyRam   = NULL;
+    uint64_t       *pbmNemDirtyBuf   = NULL;
+    size_t          cbNemDirtyBuf    = 0;
+#endif
     PGM_LOCK_VOID(pVM);
     do
     {
@@ -1446,6 +1740,23 @@ static void pgmR3ScanRamPages(PVM pVM, bool fFinalPass)
                 uint32_t         cPages    = pCur->cb >> GUEST_PAGE_SHIFT;
                 uint32_t         iPage     = GCPhysCur <= pCur->GCPhys ? 0 : (GCPhysCur - pCur->GCPhys) >> GUEST_PAGE_SHIFT;
                 GCPhysCur = 0;
+
+                /* Guest writes NEM has logged for us (NULL + fNemAllDirty=false if not applicable). */
+                uint64_t const  *pbmNemDirty  = NULL;
+                bool             fNemAllDirty = false;
+#ifdef VBOX_WITH_NATIVE_NEM
+                if (PGM_LS_RAM_RANGE_USES_NEM_DIRTY_LOG(pVM, pCur))
+                {
+                    if (pCur != pNemDirtyRam)
+                    {
+                        pNemDirtyRam   = pCur;
+                        pbmNemDirtyRam = pgmR3ScanRamPagesFetchNemDirtyBitmap(pVM, pCur, &pbmNemDirtyBuf, &cbNemDirtyBuf);
+                    }
+                    pbmNemDirty  = pbmNemDirtyRam;
+                    fNemAllDirty = pbmNemDirty == NULL;
+                }
+#endif
+
                 for (; iPage < cPages; iPage++)
                 {
                     /* Do yield first. */
@@ -1512,31 +1823,9 @@ static void pgmR3ScanRamPages(PVM pVM, bool fFinalPass)
                                 break;
 
                             case PGM_PAGE_STATE_WRITE_MONITORED:
-                                Assert(paLSPages[iPage].fWriteMonitored);
-                                if (PGM_PAGE_GET_WRITE_LOCKS(&pCur->aPages[iPage]) == 0)
-                                {
-#ifdef PGMLIVESAVERAMPAGE_WITH_CRC32
-                                    if (paLSPages[iPage].fWriteMonitoredJustNow)
-                                        pgmR3StateCalcCrc32ForRamPage(pVM, pCur, paLSPages, iPage);
-                                    else
-                                        pgmR3StateVerifyCrc32ForRamPage(pVM, pCur, paLSPages, iPage, "scan");
-#endif
-                                    paLSPages[iPage].fWriteMonitoredJustNow = 0;
-                                }
-                                else
-                                {
-                                    paLSPages[iPage].fWriteMonitoredJustNow = 1;
-#ifdef PGMLIVESAVERAMPAGE_WITH_CRC32
-                                    paLSPages[iPage].u32Crc                 = UINT32_MAX; /* invalid */
-#endif
-                                    if (!paLSPages[iPage].fDirty)
-                                    {
-                                        pVM->pgm.s.LiveSave.Ram.cReadyPages--;
-                                        pVM->pgm.s.LiveSave.Ram.cDirtyPages++;
-                                        if (++paLSPages[iPage].cDirtied > PGMLIVSAVEPAGE_MAX_DIRTIED)
-                                            paLSPages[iPage].cDirtied = PGMLIVSAVEPAGE_MAX_DIRTIED;
-                                    }
-                                }
+                                pgmR3ScanWriteMonitoredRamPage(pVM, pCur, paLSPages, iPage,
+                                                               pbmNemDirty ? ASMBitTest(pbmNemDirty, (int32_t)iPage)
+                                                                           : fNemAllDirty);
                                 break;
 
                             case PGM_PAGE_STATE_ZERO:
@@ -1628,6 +1917,534 @@ static void pgmR3ScanRamPages(PVM pVM, bool fFinalPass)
            skip the final range if one was umapped while we yielded the lock. */
     } while (idxLookup < cLookupEntries);
     PGM_UNLOCK(pVM);
+
+#ifdef VBOX_WITH_NATIVE_NEM
+    RTMemFree(pbmNemDirtyBuf);
+#endif
+}
+
+
+/**
+ * Closes the earlier side files opened by pgmR3IncrSaveBegin.
+ *
+ * @param   pIncr               The tracking.
+ */
+static void pgmR3IncrSaveCloseFiles(PPGMINCRSAVE pIncr)
+{
+    for (uint32_t i = 0; i < RT_ELEMENTS(pIncr->ahFiles); i++)
+        if (pIncr->ahFiles[i] != NIL_RTFILE)
+        {
+            RTFileClose(pIncr->ahFiles[i]);
+            pIncr->ahFiles[i] = NIL_RTFILE;
+        }
+}
+
+
+/**
+ * Frees incremental save tracking.
+ *
+ * @param   pIncr               The tracking to free, NULL is fine.
+ */
+static void pgmR3IncrSaveFree(PPGMINCRSAVE pIncr)
+{
+    if (pIncr)
+    {
+        pgmR3IncrSaveCloseFiles(pIncr);
+        for (uint32_t i = 0; i < pIncr->cFiles; i++)
+            RTStrFree(pIncr->apszFiles[i]);
+        for (uint32_t idRange = 0; idRange < pIncr->cRanges; idRange++)
+        {
+            RTMemFree(pIncr->aRanges[idRange].pau64Crc);
+            RTMemFree(pIncr->aRanges[idRange].pau8File);
+        }
+        RTMemFree(pIncr);
+    }
+}
+
+
+/**
+ * Sets up the tracking for an incremental save and writes the side file chain
+ * record if there are earlier side files to reference.
+ *
+ * The tracking is left in PGM::pIncrSavePendingR3 for pgmR3SaveDone.
+ *
+ * @returns VBox status code.
+ * @param   pVM                 The cross context VM structure.
+ * @param   pSSM                The SSM handle.
+ * @param   pszRamFile          The side file of this save.
+ */
+static int pgmR3IncrSaveBegin(PVM pVM, PSSMHANDLE pSSM, const char *pszRamFile)
+{
+    Assert(!pVM->pgm.s.pIncrSavePendingR3);
+    PGM_LOCK_ASSERT_OWNER(pVM);
+
+    uint32_t const cRanges = RT_MIN(pVM->pgm.s.idRamRangeMax + 1, RT_ELEMENTS(pVM->pgm.s.apRamRanges));
+    PPGMINCRSAVE   pIncr   = (PPGMINCRSAVE)RTMemAllocZ(RT_UOFFSETOF_DYN(PGMINCRSAVE, aRanges[cRanges]));
+    AssertReturn(pIncr, VERR_NO_MEMORY);
+    for (uint32_t i = 0; i < RT_ELEMENTS(pIncr->ahFiles); i++)
+        pIncr->ahFiles[i] = NIL_RTFILE;
+    pIncr->cRanges = cRanges;
+    for (uint32_t idRange = 0; idRange < cRanges; idRange++)
+    {
+        PPGMRAMRANGE const pRam = pVM->pgm.s.apRamRanges[idRange];
+        if (pRam && !PGM_RAM_RANGE_IS_AD_HOC(pRam))
+        {
+            uint32_t const cPages = (uint32_t)(pRam->cb >> GUEST_PAGE_SHIFT);
+            pIncr->aRanges[idRange].pau64Crc = (uint64_t *)RTMemAlloc(cPages * sizeof(uint64_t));
+            pIncr->aRanges[idRange].pau8File = (uint8_t *)RTMemAlloc(cPages);
+            if (!pIncr->aRanges[idRange].pau64Crc || !pIncr->aRanges[idRange].pau8File)
+            {
+                pgmR3IncrSaveFree(pIncr);
+                return VERR_NO_MEMORY;
+            }
+            memset(pIncr->aRanges[idRange].pau8File, PGM_INCR_SAVE_NOT_IN_FILE, cPages);
+            pIncr->aRanges[idRange].GCPhys = pRam->GCPhys;
+            pIncr->aRanges[idRange].cPages = cPages;
+        }
+    }
+
+    /*
+     * The chain: this save followed by as many of the files of the previous
+     * one as the depth limit permits.  Never reference a file we're about to
+     * overwrite, i.e. when saving to the same state file again.
+     */
+    PPGMINCRSAVE const pPrev = pVM->pgm.s.pIncrSaveR3;
+    pIncr->apszFiles[0] = RTStrDup(pszRamFile);
+    pIncr->cFiles       = 1;
+    if (pPrev)
+    {
+        bool fReuse = true;
+        for (uint32_t i = 0; i < pPrev->cFiles && fReuse; i++)
+            fReuse = RTPathCompare(pPrev->apszFiles[i], pszRamFile) != 0;
+        if (fReuse)
+        {
+            uint32_t const cFiles = RT_MIN(pPrev->cFiles + 1, pVM->pgm.s.cIncrementalSaveMaxDepth);
+            while (pIncr->cFiles < cFiles)
+            {
+                pIncr->apszFiles[pIncr->cFiles] = RTStrDup(pPrev->apszFiles[pIncr->cFiles - 1]);
+                pIncr->cFiles++;
+            }
+        }
+        else
+            LogRel(("PGM: Incremental save: '%s' is in the side file chain, doing a full save\n", pszRamFile));
+    }
+    for (uint32_t i = 0; i < pIncr->cFiles; i++)
+        if (!pIncr->apszFiles[i])
+        {
+            pgmR3IncrSaveFree(pIncr);
+            return VERR_NO_STR_MEMORY;
+        }
+
+    /*
+     * Open the earlier side files so pages can be compared with what they
+     * hold.  The chain ends before the first one that can't be opened, the
+     * pages it and older files hold are simply written again.
+     */
+    for (uint32_t i = 1; i < pIncr->cFiles; i++)
+    {
+        int rc2 = RTFileOpen(&pIncr->ahFiles[i], pIncr->apszFiles[i], RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_NONE);
+        if (RT_FAILURE(rc2))
+        {
+            LogRel(("PGM: Incremental save: failed to open '%s' (%Rrc), not referencing it\n", pIncr->apszFiles[i], rc2));
+            pIncr->ahFiles[i] = NIL_RTFILE;
+            while (pIncr->cFiles > i)
+                RTStrFree(pIncr->apszFiles[--pIncr->cFiles]);
+            break;
+        }
+    }
+
+    int rc = VINF_SUCCESS;
+    if (pIncr->cFiles > 1)
+    {
+        SSMR3PutU8(pSSM, PGM_STATE_REC_RAM_FILE_CHAIN);
+        rc = SSMR3PutU8(pSSM, (uint8_t)(pIncr->cFiles - 1));
+        for (uint32_t i = 1; i < pIncr->cFiles && RT_SUCCESS(rc); i++)
+            rc = SSMR3PutStrZ(pSSM, pIncr->apszFiles[i]);
+    }
+    if (RT_SUCCESS(rc))
+        pVM->pgm.s.pIncrSavePendingR3 = pIncr;
+    else
+        pgmR3IncrSaveFree(pIncr);
+    return rc;
+}
+
+
+/**
+ * Records the checksum of a non-zero page for an incremental save and checks
+ * whether an earlier side file has the same content.
+ *
+ * A checksum match is confirmed by reading the page back from the earlier
+ * side file and comparing it, since a CRC-64 match does not prove equality.
+ *
+ * @returns The chain index of the earlier side file holding the page, 0 if
+ *          the page must be written to the side file of this save.
+ * @param   pVM                 The cross context VM structure.
+ * @param   pIncr               The tracking of this save.
+ * @param   pRam                The RAM range.
+ * @param   iPage               The page index into the range.
+ * @param   pvPage              The page content.
+ */
+static uint8_t pgmR3IncrSaveCheckPage(PVM pVM, PPGMINCRSAVE pIncr, PPGMRAMRANGE pRam, uint32_t iPage, void const *pvPage)
+{
+    uint32_t const idRange = pRam->idRange;
+    if (   idRange >= pIncr->cRanges
+        || iPage >= pIncr->aRanges[idRange].cPages
+        || pIncr->aRanges[idRange].GCPhys != pRam->GCPhys)
+    {
+        pIncr->cPagesWritten++;
+        return 0;
+    }
+    PPGMINCRSAVERANGE const pRange = &pIncr->aRanges[idRange];
+    uint64_t const          u64Crc = RTCrc64(pvPage, GUEST_PAGE_SIZE);
+    pRange->pau64Crc[iPage] = u64Crc;
+    pRange->pau8File[iPage] = 0;
+
+    PPGMINCRSAVE const pPrev = pVM->pgm.s.pIncrSaveR3;
+    if (   pPrev
+        && pIncr->cFiles > 1
+        && idRange < pPrev->cRanges
+        && pPrev->aRanges[idRange].cPages == pRange->cPages
+        && pPrev->aRanges[idRange].GCPhys == pRange->GCPhys)
+    {
+        uint8_t const iFilePrev = pPrev->aRanges[idRange].pau8File[iPage];
+        if (   iFilePrev != PGM_INCR_SAVE_NOT_IN_FILE
+            && iFilePrev + 1U < pIncr->cFiles
+            && pPrev->aRanges[idRange].pau64Crc[iPage] == u64Crc)
+        {
+            RTGCPHYS const GCPhys = pRam->GCPhys + ((RTGCPHYS)iPage << GUEST_PAGE_SHIFT);
+            int rc = RTFileReadAt(pIncr->ahFiles[iFilePrev + 1], GCPhys, pIncr->abPage, GUEST_PAGE_SIZE, NULL);
+            if (   RT_SUCCESS(rc)
+                && !memcmp(pIncr->abPage, pvPage, GUEST_PAGE_SIZE))
+            {
+                pRange->pau8File[iPage] = iFilePrev + 1;
+                pIncr->cPagesReferenced++;
+                return iFilePrev + 1;
+            }
+            if (RT_SUCCESS(rc))
+                pIncr->cPagesMismatched++;
+            else
+                LogRelMax(16, ("PGM: Incremental save: failed to read %RGp from '%s': %Rrc\n",
+                               GCPhys, pIncr->apszFiles[iFilePrev + 1], rc));
+        }
+    }
+    pIncr->cPagesWritten++;
+    return 0;
+}
+
+
+/**
+ * Completes an incremental save, making the tracking the base for the next
+ * one if the save succeeded.
+ *
+ * @param   pVM                 The cross context VM structure.
+ * @param   pSSM                The SSM handle.
+ */
+static void pgmR3IncrSaveDone(PVM pVM, PSSMHANDLE pSSM)
+{
+    PPGMINCRSAVE const pIncr = pVM->pgm.s.pIncrSavePendingR3;
+    if (pIncr)
+    {
+        pVM->pgm.s.pIncrSavePendingR3 = NULL;
+        pgmR3IncrSaveCloseFiles(pIncr);
+        if (RT_SUCCESS(SSMR3HandleGetStatus(pSSM)))
+        {
+            LogRel(("PGM: Incremental save: wrote %u pages (%u checksum collisions), referenced %u pages in %u earlier side file(s)\n",
+                    pIncr->cPagesWritten, pIncr->cPagesMismatched, pIncr->cPagesReferenced, pIncr->cFiles - 1));
+            pgmR3IncrSaveFree(pVM->pgm.s.pIncrSaveR3);
+            pVM->pgm.s.pIncrSaveR3 = pIncr;
+        }
+        else
+            pgmR3IncrSaveFree(pIncr);
+    }
+}
+
+
+/**
+ * Closes the earlier side files of an incremental state load.
+ *
+ * @param   pVM                 The cross context VM structure.
+ */
+static void pgmR3IncrLoadTerm(PVM pVM)
+{
+    PPGMINCRLOAD const pIncrLoad = pVM->pgm.s.pIncrLoadR3;
+    if (pIncrLoad)
+    {
+        pVM->pgm.s.pIncrLoadR3 = NULL;
+        for (uint32_t i = 1; i < pIncrLoad->cFiles; i++)
+            if (pIncrLoad->ahFiles[i] != NIL_RTFILE)
+                RTFileClose(pIncrLoad->ahFiles[i]);
+        RTMemFree(pIncrLoad);
+    }
+}
+
+
+/**
+ * Loads a PGM_STATE_REC_RAM_FILE_CHAIN record, opening the earlier side files.
+ *
+ * A side file which isn't at the recorded path is looked for in the directory
+ * of the saved state, in case the VM has been moved.
+ *
+ * @returns VBox status code.
+ * @param   pVM                 The cross context VM structure.
+ * @param   pSSM                The SSM handle.
+ */
+static int pgmR3IncrLoadChain(PVM pVM, PSSMHANDLE pSSM)
+{
+    uint8_t cFiles = 0;
+    int rc = SSMR3GetU8(pSSM, &cFiles);
+    AssertRCReturn(rc, rc);
+    AssertLogRelMsgReturn(cFiles > 0 && cFiles < PGM_INCR_SAVE_MAX_FILES && !pVM->pgm.s.pIncrLoadR3,
+                          ("cFiles=%u\n", cFiles), VERR_SSM_DATA_UNIT_FORMAT_CHANGED);
+
+    PPGMINCRLOAD pIncrLoad = (PPGMINCRLOAD)RTMemAllocZ(sizeof(*pIncrLoad));
+    AssertReturn(pIncrLoad, VERR_NO_MEMORY);
+    for (uint32_t i = 0; i < RT_ELEMENTS(pIncrLoad->ahFiles); i++)
+        pIncrLoad->ahFiles[i] = NIL_RTFILE;
+    pIncrLoad->cFiles = 1;
+    pVM->pgm.s.pIncrLoadR3 = pIncrLoad; /* pgmR3LoadDone cleans up. */
+
+    const char * const pszState = SSMR3HandleFilename(pSSM);
+    char               szPath[RTPATH_MAX];
+    for (uint32_t i = 1; i <= cFiles; i++)
+    {
+        rc = SSMR3GetStrZ(pSSM, szPath, sizeof(szPath));
+        if (RT_FAILURE(rc))
+            return rc;
+
+        rc = RTFileOpen(&pIncrLoad->ahFiles[i], szPath, RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_WRITE);
+        if (   RT_FAILURE(rc)
+            && pszState)
+        {
+            char szAlt[RTPATH_MAX];
+            int rc2 = RTStrCopy(szAlt, sizeof(szAlt), pszState);
+            if (RT_SUCCESS(rc2))
+            {
+                RTPathStripFilename(szAlt);
+                rc2 = RTPathAppend(szAlt, sizeof(szAlt), RTPathFilename(szPath));
+            }
+            if (RT_SUCCESS(rc2))
+                rc2 = RTFileOpen(&pIncrLoad->ahFiles[i], szAlt, RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_WRITE);
+            if (RT_SUCCESS(rc2))
+                rc = rc2;
+        }
+        if (RT_FAILURE(rc))
+        {
+            pIncrLoad->ahFiles[i] = NIL_RTFILE;
+            return SSMR3SetLoadError(pSSM, rc, RT_SRC_POS,
+                                     N_("Failed to open the RAM side file '%s' of an earlier saved state"), szPath);
+        }
+        pIncrLoad->cFiles = i + 1;
+    }
+    LogRel(("PGM: Incremental state referencing %u earlier RAM side file(s)\n", cFiles));
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Frees the incremental save and load state.
+ *
+ * @param   pVM                 The cross context VM structure.
+ */
+void pgmR3TermSavedState(PVM pVM)
+{
+    pgmR3SaveBgWriterWait(pVM);
+    pgmR3IncrSaveFree(pVM->pgm.s.pIncrSavePendingR3);
+    pVM->pgm.s.pIncrSavePendingR3 = NULL;
+    pgmR3IncrSaveFree(pVM->pgm.s.pIncrSaveR3);
+    pVM->pgm.s.pIncrSaveR3 = NULL;
+    pgmR3IncrLoadTerm(pVM);
+}
+
+
+/**
+ * Writes out and frees the queued runs, then closes the side file.
+ *
+ * @returns VBox status code.
+ * @param   pWriter             The background writer.
+ */
+static int pgmR3SaveBgWriterFlush(PPGMSAVEBGWRITER pWriter)
+{
+    uint64_t const nsStart = RTTimeNanoTS();
+    size_t   const cbTotal = pWriter->cbQueued;
+    int rc = VINF_SUCCESS;
+    PPGMSAVEBGRUN pRun = pWriter->pHead;
+    while (pRun)
+    {
+        PPGMSAVEBGRUN pNext = pRun->pNext;
+        if (RT_SUCCESS(rc))
+            rc = RTFileWriteAt(pWriter->hFile, pRun->GCPhys, pRun->abData, pRun->cb, NULL);
+        RTMemFree(pRun);
+        pRun = pNext;
+    }
+    pWriter->pHead    = NULL;
+    pWriter->pTail    = NULL;
+    pWriter->cbQueued = 0;
+
+    if (RT_SUCCESS(rc))
+        rc = RTFileFlush(pWriter->hFile);
+    int rc2 = RTFileClose(pWriter->hFile);
+    pWriter->hFile = NIL_RTFILE;
+    if (RT_SUCCESS(rc))
+        rc = rc2;
+
+    if (RT_SUCCESS(rc))
+        LogRel(("PGM: Wrote %zu bytes of RAM pages to the side file in the background in %RU64 ms\n",
+                cbTotal, (RTTimeNanoTS() - nsStart) / RT_NS_1MS));
+    else
+        LogRel(("PGM: Writing the RAM pages to the side file in the background failed: %Rrc\n", rc));
+    return rc;
+}
+
+
+/**
+ * @callback_method_impl{FNRTTHREAD, Background side file writer}
+ */
+static DECLCALLBACK(int) pgmR3SaveBgWriterThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    PPGMSAVEBGWRITER pWriter = (PPGMSAVEBGWRITER)pvUser;
+    RT_NOREF(hThreadSelf);
+    pWriter->rc = pgmR3SaveBgWriterFlush(pWriter);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Creates the side file and background writer for the final pass of a live
+ * save when so configured.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pSSM        The SSM handle.
+ * @param   ppWriter    Where to return the writer, NULL if the pages should go
+ *                      into the saved state as usual.
+ */
+static int pgmR3SaveBgWriterCreate(PVM pVM, PSSMHANDLE pSSM, PPGMSAVEBGWRITER *ppWriter)
+{
+    *ppWriter = NULL;
+    const char * const pszState = SSMR3HandleFilename(pSSM);
+    if (   !pVM->pgm.s.fLiveSaveRamBackground
+        || pVM->pgm.s.fPostCopySave
+        || !pszState)
+        return VINF_SUCCESS;
+
+    PPGMSAVEBGWRITER pWriter = (PPGMSAVEBGWRITER)RTMemAllocZ(sizeof(*pWriter));
+    AssertReturn(pWriter, VERR_NO_MEMORY);
+    pWriter->hThread = NIL_RTTHREAD;
+
+    char *pszFile = RTStrAPrintf2("%s" PGM_SAVED_STATE_RAM_FILE_SUFFIX, pszState);
+    AssertReturnStmt(pszFile, RTMemFree(pWriter), VERR_NO_STR_MEMORY);
+    int rc = RTFileOpen(&pWriter->hFile, pszFile, RTFILE_O_WRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_WRITE);
+    if (RT_SUCCESS(rc))
+    {
+        LogRel(("PGM: Saving the dirty RAM pages of the final live pass to '%s' in the background\n", pszFile));
+        *ppWriter = pWriter;
+    }
+    else
+    {
+        LogRel(("PGM: Failed to create the RAM side file '%s': %Rrc\n", pszFile, rc));
+        RTMemFree(pWriter);
+    }
+    RTStrFree(pszFile);
+    return rc;
+}
+
+
+/**
+ * Writes a run of pages to the RAM side file, or queues it for the
+ * background writer if there is one and it has room left.
+ *
+ * @returns VBox status code.
+ * @param   hRamFile            The RAM side file.
+ * @param   pWriter             The background writer, NULL if none.
+ * @param   GCPhys              The address of the first page.
+ * @param   pbRun               The page contents.
+ * @param   cbRun               The size of the run.
+ */
+static int pgmR3SaveRamFileRun(RTFILE hRamFile, PPGMSAVEBGWRITER pWriter, RTGCPHYS GCPhys, uint8_t const *pbRun, size_t cbRun)
+{
+    if (   pWriter
+        && pWriter->cbQueued + cbRun <= PGM_SAVE_BG_WRITER_MAX)
+    {
+        PPGMSAVEBGRUN pRun = (PPGMSAVEBGRUN)RTMemAlloc(RT_UOFFSETOF_DYN(PGMSAVEBGRUN, abData[cbRun]));
+        if (pRun)
+        {
+            pRun->pNext  = NULL;
+            pRun->GCPhys = GCPhys;
+            pRun->cb     = cbRun;
+            memcpy(pRun->abData, pbRun, cbRun);
+            if (pWriter->pTail)
+                pWriter->pTail->pNext = pRun;
+            else
+                pWriter->pHead = pRun;
+            pWriter->pTail     = pRun;
+            pWriter->cbQueued += cbRun;
+            return VINF_SUCCESS;
+        }
+    }
+    return RTFileWriteAt(hRamFile, GCPhys, pbRun, cbRun, NULL);
+}
+
+
+/**
+ * Starts the background writer after the final pass, or cleans it up if the
+ * pass failed.
+ *
+ * @returns VBox status code.
+ * @param   pVM                 The cross context VM structure.
+ * @param   pWriter             The background writer.
+ * @param   rc                  The status of the final pass.
+ */
+static int pgmR3SaveBgWriterStart(PVM pVM, PPGMSAVEBGWRITER pWriter, int rc)
+{
+    if (RT_SUCCESS(rc))
+    {
+        Assert(!pVM->pgm.s.pSaveBgWriterR3);
+        rc = RTThreadCreate(&pWriter->hThread, pgmR3SaveBgWriterThread, pWriter, 0 /*cbStack*/,
+                            RTTHREADTYPE_IO, RTTHREADFLAGS_WAITABLE, "PGMSaveRam");
+        if (RT_SUCCESS(rc))
+        {
+            pVM->pgm.s.pSaveBgWriterR3 = pWriter;
+            return VINF_SUCCESS;
+        }
+
+        /* No thread, do it here then. */
+        pWriter->hThread = NIL_RTTHREAD;
+        rc = pgmR3SaveBgWriterFlush(pWriter);
+    }
+    else
+    {
+        PPGMSAVEBGRUN pRun = pWriter->pHead;
+        while (pRun)
+        {
+            PPGMSAVEBGRUN pNext = pRun->pNext;
+            RTMemFree(pRun);
+            pRun = pNext;
+        }
+        RTFileClose(pWriter->hFile);
+    }
+    RTMemFree(pWriter);
+    return rc;
+}
+
+
+/**
+ * Waits for the background side file writer of the last live save to finish.
+ *
+ * @returns The status of the write out.
+ * @param   pVM                 The cross context VM structure.
+ */
+int pgmR3SaveBgWriterWait(PVM pVM)
+{
+    PPGMSAVEBGWRITER pWriter = pVM->pgm.s.pSaveBgWriterR3;
+    if (!pWriter)
+        return VINF_SUCCESS;
+
+    int rc = RTThreadWait(pWriter->hThread, RT_INDEFINITE_WAIT, NULL);
+    AssertLogRelRC(rc);
+    rc = pWriter->rc;
+    pVM->pgm.s.pSaveBgWriterR3 = NULL;
+    RTMemFree(pWriter);
+    return rc;
 }
 
 
@@ -1639,8 +2456,20 @@ static void pgmR3ScanRamPages(PVM pVM, bool fFinalPass)
  * @param   pSSM                The SSM handle.
  * @param   fLiveSave           Whether it's a live save or not.
  * @param   uPass               The pass number.
+ * @param   hRamFile            The RAM side file to put the non-zero pages in,
+ *                              NIL_RTFILE to put them in the saved state.
+ * @param   fPostCopy           Post-copy teleportation: leave the non-zero pages
+ *                              for the target to fetch, i.e. emit payload less
+ *                              PGM_STATE_REC_RAM_FILE records for them.
+ * @param   pBgWriter           The background writer to queue the side file
+ *                              runs for, NULL to write them right away.
+ *
+ * @remarks With a side file, pages an incremental save finds unchanged in an
+ *          earlier side file (see pgmR3IncrSaveBegin) become
+ *          PGM_STATE_REC_RAM_PARENT records instead.
  */
-static int pgmR3SaveRamPages(PVM pVM, PSSMHANDLE pSSM, bool fLiveSave, uint32_t uPass)
+static int pgmR3SaveRamPages(PVM pVM, PSSMHANDLE pSSM, bool fLiveSave, uint32_t uPass, RTFILE hRamFile, bool fPostCopy,
+                             PPGMSAVEBGWRITER pBgWriter)
 {
     NOREF(fLiveSave);
 
@@ -1652,6 +2481,33 @@ static int pgmR3SaveRamPages(PVM pVM, PSSMHANDLE pSSM, bool fLiveSave, uint32_t
     uint32_t idxLookup;
     uint32_t cRamRangeLookupEntries;
 
+    /*
+     * The records are collected in a staging buffer and passed to SSM in big
+     * chunks.  The resulting byte stream is exactly what the individual puts
+     * would have produced, but SSM gets to compress it on its worker threads
+     * and we don't have to drop the PGM lock for every single page.
+     */
+    uint8_t *pbBatch = (uint8_t *)RTMemPageAlloc(PGM_SAVE_RAM_BATCH_SIZE);
+    AssertReturn(pbBatch, VERR_NO_PAGE_MEMORY);
+    size_t   offBatch = 0;
+
+    /*
+     * Pages going to the RAM side file are collected in runs of adjacent
+     * pages, each written with a single call at offset GCPhys.  The page
+     * content is still needed for the zero check in post-copy mode, the
+     * record space in the staging buffer serves as scratch for it.
+     */
+    Assert(!fPostCopy || hRamFile == NIL_RTFILE);
+    PPGMINCRSAVE const pIncr = hRamFile != NIL_RTFILE ? pVM->pgm.s.pIncrSavePendingR3 : NULL;
+    uint8_t *pbRun     = NULL;
+    size_t   cbRun     = 0;
+    RTGCPHYS GCPhysRun = NIL_RTGCPHYS;
+    if (hRamFile != NIL_RTFILE)
+    {
+        pbRun = (uint8_t *)RTMemPageAlloc(PGM_SAVE_RAM_FILE_RUN_SIZE);
+        AssertReturnStmt(pbRun, RTMemPageFree(pbBatch, PGM_SAVE_RAM_BATCH_SIZE), VERR_NO_PAGE_MEMORY);
+    }
+
     PGM_LOCK_VOID(pVM);
     do
     {
@@ -1727,56 +2583,81 @@ static int pgmR3SaveRamPages(PVM pVM, PSSMHANDLE pSSM, bool fLiveSave, uint32_t
                     }
 
                     /*
-                     * Do the saving outside the PGM critsect since SSM may block on I/O.
+                     * Add the record to the staging buffer: type byte, address
+                     * (unless it follows the previous one) and the page bits.
                      */
-                    int         rc;
                     RTGCPHYS    GCPhys = pCur->GCPhys + ((RTGCPHYS)iPage << GUEST_PAGE_SHIFT);
                     bool        fZero  = PGM_PAGE_IS_ZERO(pCurPage);
                     bool        fBallooned = PGM_PAGE_IS_BALLOONED(pCurPage);
-                    bool        fSkipped = false;
+                    uint8_t    *pbRec  = &pbBatch[offBatch];
+                    size_t      cbRec  = 1;
+                    uint8_t     u8RecType;
+                    bool const  fAddr  = GCPhys != GCPhysLast + GUEST_PAGE_SIZE;
+                    if (fAddr)
+                    {
+                        memcpy(&pbRec[1], &GCPhys, sizeof(GCPhys));
+                        cbRec += sizeof(GCPhys);
+                    }
 
                     if (!fZero && !fBallooned)
                     {
-                        /*
-                         * Copy the page and then save it outside the lock (since any
-                         * SSM call may block).
-                         */
-                        uint8_t         abPage[GUEST_PAGE_SIZE];
+                        /* Side file: write out the current run if this page doesn't extend it. */
+                        int rc = VINF_SUCCESS;
+                        if (   cbRun
+                            && (   GCPhys != GCPhysRun + cbRun
+                                || cbRun >= PGM_SAVE_RAM_FILE_RUN_SIZE))
+                        {
+                            rc = pgmR3SaveRamFileRun(hRamFile, pBgWriter, GCPhysRun, pbRun, cbRun);
+                            cbRun = 0;
+                        }
+                        if (!cbRun)
+                            GCPhysRun = GCPhys;
+                        uint8_t * const pbDst = hRamFile == NIL_RTFILE ? &pbRec[cbRec] : &pbRun[cbRun];
+
                         PGMPAGEMAPLOCK  PgMpLck;
                         void const     *pvPage;
-                        rc = pgmPhysGCPhys2CCPtrInternalReadOnly(pVM, pCurPage, GCPhys, &pvPage, &PgMpLck);
+                        if (RT_SUCCESS(rc))
+                            rc = pgmPhysGCPhys2CCPtrInternalReadOnly(pVM, pCurPage, GCPhys, &pvPage, &PgMpLck);
                         if (RT_SUCCESS(rc))
                         {
-                            memcpy(abPage, pvPage, GUEST_PAGE_SIZE);
+                            memcpy(pbDst, pvPage, GUEST_PAGE_SIZE);
 #ifdef PGMLIVESAVERAMPAGE_WITH_CRC32
                             if (paLSPages)
-                                pgmR3StateVerifyCrc32ForPage(abPage, pCur, paLSPages, iPage, "save#3");
+                                pgmR3StateVerifyCrc32ForPage(pbDst, pCur, paLSPages, iPage, "save#3");
 #endif
                             pgmPhysReleaseInternalPageMappingLock(pVM, &PgMpLck);
                         }
-                        PGM_UNLOCK(pVM);
-                        AssertLogRelMsgRCReturn(rc, ("rc=%Rrc GCPhys=%RGp\n", rc, GCPhys), rc);
+                        else
+                        {
+                            PGM_UNLOCK(pVM);
+                            RTMemPageFree(pbBatch, PGM_SAVE_RAM_BATCH_SIZE);
+                            if (pbRun)
+                                RTMemPageFree(pbRun, PGM_SAVE_RAM_FILE_RUN_SIZE);
+                            AssertLogRelMsgFailedReturn(("rc=%Rrc GCPhys=%RGp\n", rc, GCPhys), rc);
+                        }
 
                         /* Try save some memory when restoring. */
-                        if (!ASMMemIsZero(pvPage, GUEST_PAGE_SIZE))
+                        if (ASMMemIsZero(pbDst, GUEST_PAGE_SIZE))
+                            u8RecType = PGM_STATE_REC_RAM_ZERO;
+                        else if (fPostCopy)
+                            u8RecType = PGM_STATE_REC_RAM_FILE;
+                        else if (hRamFile == NIL_RTFILE)
                         {
-                            if (GCPhys == GCPhysLast + GUEST_PAGE_SIZE)
-                                SSMR3PutU8(pSSM, PGM_STATE_REC_RAM_RAW);
-                            else
-                            {
-                                SSMR3PutU8(pSSM, PGM_STATE_REC_RAM_RAW | PGM_STATE_REC_FLAG_ADDR);
-                                SSMR3PutGCPhys(pSSM, GCPhys);
-                            }
-                            rc = SSMR3PutMem(pSSM, abPage, GUEST_PAGE_SIZE);
+                            u8RecType = PGM_STATE_REC_RAM_RAW;
+                            cbRec    += GUEST_PAGE_SIZE;
                         }
                         else
                         {
-                            if (GCPhys == GCPhysLast + GUEST_PAGE_SIZE)
-                                rc = SSMR3PutU8(pSSM, PGM_STATE_REC_RAM_ZERO);
+                            uint8_t const iFile = pIncr ? pgmR3IncrSaveCheckPage(pVM, pIncr, pCur, iPage, pbDst) : 0;
+                            if (!iFile)
+                            {
+                                u8RecType = PGM_STATE_REC_RAM_FILE;
+                                cbRun    += GUEST_PAGE_SIZE;
+                            }
                             else
                             {
-                                SSMR3PutU8(pSSM, PGM_STATE_REC_RAM_ZERO | PGM_STATE_REC_FLAG_ADDR);
-                                rc = SSMR3PutGCPhys(pSSM, GCPhys);
+                                u8RecType      = PGM_STATE_REC_RAM_PARENT;
+                                pbRec[cbRec++] = iFile;
                             }
                         }
                     }
@@ -1789,23 +2670,31 @@ static int pgmR3SaveRamPages(PVM pVM, PSSMHANDLE pSSM, bool fLiveSave, uint32_t
                         if (paLSPages)
                             pgmR3StateVerifyCrc32ForRamPage(pVM, pCur, paLSPages, iPage, "save#2");
 #endif
-                        PGM_UNLOCK(pVM);
+                        u8RecType = fBallooned ? PGM_STATE_REC_RAM_BALLOONED : PGM_STATE_REC_RAM_ZERO;
+                    }
+                    pbRec[0]  = fAddr ? u8RecType | PGM_STATE_REC_FLAG_ADDR : u8RecType;
+                    offBatch += cbRec;
 
-                        uint8_t u8RecType = fBallooned ? PGM_STATE_REC_RAM_BALLOONED : PGM_STATE_REC_RAM_ZERO;
-                        if (GCPhys == GCPhysLast + GUEST_PAGE_SIZE)
-                            rc = SSMR3PutU8(pSSM, u8RecType);
-                        else
+                    /*
+                     * Flush the staging buffer when full.  This is done outside
+                     * the PGM critsect since SSM may block on I/O.
+                     */
+                    if (offBatch > PGM_SAVE_RAM_BATCH_SIZE - PGM_SAVE_RAM_BATCH_REC_MAX)
+                    {
+                        PGM_UNLOCK(pVM);
+                        int rc = SSMR3PutMem(pSSM, pbBatch, offBatch);
+                        offBatch = 0;
+                        if (RT_FAILURE(rc))
                         {
-                            SSMR3PutU8(pSSM, u8RecType | PGM_STATE_REC_FLAG_ADDR);
-                            rc = SSMR3PutGCPhys(pSSM, GCPhys);
+                            RTMemPageFree(pbBatch, PGM_SAVE_RAM_BATCH_SIZE);
+                            if (pbRun)
+                                RTMemPageFree(pbRun, PGM_SAVE_RAM_FILE_RUN_SIZE);
+                            return rc;
                         }
+                        PGM_LOCK_VOID(pVM);
                     }
-                    if (RT_FAILURE(rc))
-                        return rc;
 
-                    PGM_LOCK_VOID(pVM);
-                    if (!fSkipped)
-                        GCPhysLast = GCPhys;
+                    GCPhysLast = GCPhys;
                     if (paLSPages)
                     {
                         paLSPages[iPage].fDirty = 0;
@@ -1836,7 +2725,15 @@ static int pgmR3SaveRamPages(PVM pVM, PSSMHANDLE pSSM, bool fLiveSave, uint32_t
 
     PGM_UNLOCK(pVM);
 
-    return VINF_SUCCESS;
+    int rc = VINF_SUCCESS;
+    if (cbRun)
+        rc = pgmR3SaveRamFileRun(hRamFile, pBgWriter, GCPhysRun, pbRun, cbRun);
+    if (offBatch && RT_SUCCESS(rc))
+        rc = SSMR3PutMem(pSSM, pbBatch, offBatch);
+    RTMemPageFree(pbBatch, PGM_SAVE_RAM_BATCH_SIZE);
+    if (pbRun)
+        RTMemPageFree(pbRun, PGM_SAVE_RAM_FILE_RUN_SIZE);
+    return rc;
 }
 
 
@@ -1886,6 +2783,11 @@ static void pgmR3DoneRamPages(PVM pVM)
                 pvToFree = pCur->paLSPages;
                 pCur->paLSPages = NULL;
 
+#ifdef VBOX_WITH_NATIVE_NEM
+                if (PGM_LS_RAM_RANGE_USES_NEM_DIRTY_LOG(pVM, pCur))
+                    NEMR3PhysRamDirtyTracking(pVM, pCur->GCPhys, pCur->cb, pCur->pbR3, pCur->uNemRange, false /*fEnable*/);
+#endif
+
                 uint32_t iPage = pCur->cb >> GUEST_PAGE_SHIFT;
                 while (iPage--)
                 {
@@ -1906,6 +2808,7 @@ static void pgmR3DoneRamPages(PVM pVM)
         pVM->pgm.s.cMonitoredPages = 0;
     else
         pVM->pgm.s.cMonitoredPages -= cMonitoredPages;
+    pVM->pgm.s.LiveSave.fNemDirtyLog = false;
 
     PGM_UNLOCK(pVM);
 
@@ -1968,13 +2871,70 @@ static DECLCALLBACK(int) pgmR3LiveExec(PVM pVM, PSSMHANDLE pSSM, uint32_t uPass)
     if (RT_SUCCESS(rc))
         rc = pgmR3SaveMmio2Pages(      pVM, pSSM, true /*fLiveSave*/, uPass);
     if (RT_SUCCESS(rc))
-        rc = pgmR3SaveRamPages(        pVM, pSSM, true /*fLiveSave*/, uPass);
+        rc = pgmR3SaveRamPages(        pVM, pSSM, true /*fLiveSave*/, uPass, NIL_RTFILE, false /*fPostCopy*/, NULL);
     SSMR3PutU8(pSSM, PGM_STATE_REC_END);    /* (Ignore the rc, SSM takes care of it.) */
 
     return rc;
 }
 
 
+/**
+ * Auto-converge worker for pgmR3LiveVote.
+ *
+ * When the guest keeps dirtying memory faster than we can save it, the
+ * predicted downtime won't approach the limit and the live save never
+ * converges.  So, tighten the CPU execution cap a step every few passes until
+ * the dirty rate comes down or we hit the floor.  pgmR3SaveDone restores it.
+ *
+ * @param   pVM                 The cross context VM structure.
+ * @param   pSSM                The saved state handle.
+ * @param   cDirtyPagesShort    The short term dirty page average.
+ * @param   cDirtyPagesLong     The long term dirty page average.
+ * @param   cPagesPerSecond     The estimated save speed.
+ */
+static void pgmR3LiveAutoConverge(PVM pVM, PSSMHANDLE pSSM, uint32_t cDirtyPagesShort, uint32_t cDirtyPagesLong,
+                                  uint32_t cPagesPerSecond)
+{
+    if (pVM->pgm.s.LiveSave.cPassesSinceThrottle < PGM_LIVE_AUTO_CONVERGE_PASSES)
+    {
+        pVM->pgm.s.LiveSave.cPassesSinceThrottle++;
+        return;
+    }
+
+    uint32_t const cMsLeftShort   = (uint32_t)(cDirtyPagesShort / (long double)RT_MAX(cPagesPerSecond, 1) * 1000.0);
+    uint32_t const cMsMaxDowntime = RT_MAX(SSMR3HandleMaxDowntime(pSSM), 32);
+    if (   cMsLeftShort <= cMsMaxDowntime * 2
+        || cDirtyPagesShort < cDirtyPagesLong - cDirtyPagesLong / 8)
+        return; /* Converging by itself. */
+
+    uint32_t uCurCap = pVM->pgm.s.LiveSave.uThrottleCap;
+    if (!uCurCap)
+    {
+        uCurCap = pVM->uCpuExecutionCap;
+        pVM->pgm.s.LiveSave.uOrgCpuExecutionCap = (uint8_t)uCurCap;
+    }
+    else if (pVM->uCpuExecutionCap != uCurCap)
+    {
+        /* Someone else changed the cap, back off. */
+        LogRel(("PGM: Auto-converge: execution cap changed to %u%% behind our back, giving up\n", pVM->uCpuExecutionCap));
+        pVM->pgm.s.LiveSave.fAutoConverge = false;
+        pVM->pgm.s.LiveSave.uThrottleCap  = 0;
+        return;
+    }
+
+    uint32_t const uMinCap = pVM->pgm.s.LiveSave.uThrottleMinCap;
+    uint32_t const uNewCap = uCurCap > uMinCap + PGM_LIVE_AUTO_CONVERGE_STEP ? uCurCap - PGM_LIVE_AUTO_CONVERGE_STEP : uMinCap;
+    if (uNewCap >= uCurCap)
+        return;
+
+    LogRel(("PGM: Auto-converge: %u dirty pages (long %u), %u pages/s, predicted downtime %u ms (max %u ms) - capping vCPUs at %u%%\n",
+            cDirtyPagesShort, cDirtyPagesLong, cPagesPerSecond, cMsLeftShort, cMsMaxDowntime, uNewCap));
+    pVM->pgm.s.LiveSave.uThrottleCap         = (uint8_t)uNewCap;
+    pVM->pgm.s.LiveSave.cPassesSinceThrottle = 0;
+    pVM->uCpuExecutionCap = uNewCap;
+}
+
+
 /**
  * @callback_method_impl{FNSSMINTLIVEVOTE}
  */
@@ -2023,6 +2983,18 @@ static DECLCALLBACK(int)  pgmR3LiveVote(PVM pVM, PSSMHANDLE pSSM, uint32_t uPass
                                           / ((long double)cNsElapsed / 1000000000.0) );
     pVM->pgm.s.LiveSave.cPagesPerSecond = cPagesPerSecond;
 
+    /*
+     * Post-copy doesn't need to converge, the target fetches whatever is
+     * still dirty after the hand-over.  A few passes get the bulk of the
+     * memory (the hot subset) over while the guest keeps running.
+     */
+    if (   pVM->pgm.s.fPostCopySave
+        && uPass >= PGM_LIVE_POST_COPY_PASSES)
+    {
+        LogRel(("PGM: Post-copy: handing over after pass %u with %u dirty pages left\n", uPass, cDirtyNow));
+        return VINF_SUCCESS;
+    }
+
     /*
      * Try make a decision.
      */
@@ -2062,6 +3034,13 @@ static DECLCALLBACK(int)  pgmR3LiveVote(PVM pVM, PSSMHANDLE pSSM, uint32_t uPass
         }
     }
 
+    /*
+     * Throttle the guest if it's outrunning us.
+     */
+    if (   pVM->pgm.s.LiveSave.fAutoConverge
+        && uPass > 10)
+        pgmR3LiveAutoConverge(pVM, pSSM, cDirtyPagesShort, cDirtyPagesLong, cPagesPerSecond);
+
     /*
      * Come up with a completion percentage.  Currently this is a simple
      * dirty page (long term) vs. total pages ratio + some pass trickery.
@@ -2087,6 +3066,15 @@ static DECLCALLBACK(int)  pgmR3LiveVote(PVM pVM, PSSMHANDLE pSSM, uint32_t uPass
  */
 static DECLCALLBACK(int) pgmR3LivePrep(PVM pVM, PSSMHANDLE pSSM)
 {
+    /*
+     * Finish any lazy restore first, the scanning doesn't respect handlers.
+     * Also wait for the side file of the previous live save, the new one
+     * might replace it.
+     */
+    int rc = pgmR3PhysLazyRestoreFlush(pVM);
+    AssertLogRelRCReturn(rc, rc);
+    pgmR3SaveBgWriterWait(pVM);
+
     /*
      * Indicate that we will be using the write monitoring.
      */
@@ -2117,11 +3105,28 @@ static DECLCALLBACK(int) pgmR3LivePrep(PVM pVM, PSSMHANDLE pSSM)
     pVM->pgm.s.LiveSave.cSavedPages       = 0;
     pVM->pgm.s.LiveSave.uSaveStartNS      = RTTimeNanoTS();
     pVM->pgm.s.LiveSave.cPagesPerSecond   = 8192;
+    pVM->pgm.s.LiveSave.uThrottleCap      = 0;
+    pVM->pgm.s.LiveSave.cPassesSinceThrottle = 0;
+
+    /** @cfgm{/PGM/LiveSave/AutoConverge, boolean, true}
+     * Whether to progressively cap the vCPU execution when the guest dirties
+     * memory faster than the live save can keep up with, so the save converges
+     * within the max downtime.
+     * @cfgm{/PGM/LiveSave/AutoConvergeMinCap, uint8_t, 1, 100, 20}
+     * The lowest CPU execution cap (percent) auto-converge will impose. */
+    PCFGMNODE const pCfg = CFGMR3GetChild(CFGMR3GetRoot(pVM), "/PGM/LiveSave");
+    rc = CFGMR3QueryBoolDef(pCfg, "AutoConverge", &pVM->pgm.s.LiveSave.fAutoConverge, true);
+    AssertLogRelRCReturn(rc, rc);
+    if (pVM->pgm.s.fPostCopySave)
+        pVM->pgm.s.LiveSave.fAutoConverge = false; /* No need to slow down the guest. */
+    rc = CFGMR3QueryU8Def(pCfg, "AutoConvergeMinCap", &pVM->pgm.s.LiveSave.uThrottleMinCap, 20);
+    AssertLogRelRCReturn(rc, rc);
+    pVM->pgm.s.LiveSave.uThrottleMinCap = RT_MIN(RT_MAX(pVM->pgm.s.LiveSave.uThrottleMinCap, 1), 100);
 
     /*
      * Per page type.
      */
-    int rc = pgmR3PrepRomPages(pVM);
+    rc = pgmR3PrepRomPages(pVM);
     if (RT_SUCCESS(rc))
         rc = pgmR3PrepMmio2Pages(pVM);
     if (RT_SUCCESS(rc))
@@ -2132,6 +3137,46 @@ static DECLCALLBACK(int) pgmR3LivePrep(PVM pVM, PSSMHANDLE pSSM)
 }
 
 
+/**
+ * Creates the RAM side file for a non-live save when so configured.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pSSM        The SSM handle.
+ * @param   phRamFile   Where to return the file handle.  NIL_RTFILE if the
+ *                      pages should go into the saved state as usual.
+ */
+static int pgmR3SaveOpenRamFile(PVM pVM, PSSMHANDLE pSSM, PRTFILE phRamFile)
+{
+    *phRamFile = NIL_RTFILE;
+    const char * const pszState = SSMR3HandleFilename(pSSM);
+    if (   !pVM->pgm.s.fSaveRamToSideFile
+        || !pszState)
+        return VINF_SUCCESS;
+
+    char *pszFile = RTStrAPrintf2("%s" PGM_SAVED_STATE_RAM_FILE_SUFFIX, pszState);
+    AssertReturn(pszFile, VERR_NO_STR_MEMORY);
+    int rc = RTFileOpen(phRamFile, pszFile, RTFILE_O_WRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_WRITE);
+    if (RT_SUCCESS(rc))
+    {
+        LogRel(("PGM: Saving RAM pages to '%s'\n", pszFile));
+        if (pVM->pgm.s.fIncrementalSave)
+        {
+            rc = pgmR3IncrSaveBegin(pVM, pSSM, pszFile);
+            if (RT_FAILURE(rc))
+            {
+                RTFileClose(*phRamFile);
+                *phRamFile = NIL_RTFILE;
+            }
+        }
+    }
+    else
+        LogRel(("PGM: Failed to create the RAM side file '%s': %Rrc\n", pszFile, rc));
+    RTStrFree(pszFile);
+    return rc;
+}
+
+
 /**
  * @callback_method_impl{FNSSMINTSAVEEXEC}
  */
@@ -2139,6 +3184,15 @@ static DECLCALLBACK(int) pgmR3SaveExec(PVM pVM, PSSMHANDLE pSSM)
 {
     PPGM pPGM = &pVM->pgm.s;
 
+    /*
+     * Pages still to be read back by a lazy restore must be read now, we
+     * access guest RAM directly below.
+     */
+    int rc = pgmR3PhysLazyRestoreFlush(pVM);
+    AssertLogRelRCReturn(rc, rc);
+    if (!pVM->pgm.s.LiveSave.fActive)
+        pgmR3SaveBgWriterWait(pVM);
+
     /*
      * Lock PGM and set the no-more-writes indicator.
      */
@@ -2148,7 +3202,7 @@ static DECLCALLBACK(int) pgmR3SaveExec(PVM pVM, PSSMHANDLE pSSM)
     /*
      * Save basic data (required / unaffected by relocation).
      */
-    int rc = SSMR3PutStructEx(pSSM, pPGM, sizeof(*pPGM), 0 /*fFlags*/, &s_aPGMFields[0], NULL /*pvUser*/);
+    rc = SSMR3PutStructEx(pSSM, pPGM, sizeof(*pPGM), 0 /*fFlags*/, &s_aPGMFields[0], NULL /*pvUser*/);
 
     for (VMCPUID idCpu = 0; idCpu < pVM->cCpus && RT_SUCCESS(rc); idCpu++)
         rc = SSMR3PutStruct(pSSM, &pVM->apCpusR3[idCpu]->pgm.s, &s_aPGMCpuFields[0]);
@@ -2167,8 +3221,17 @@ static DECLCALLBACK(int) pgmR3SaveExec(PVM pVM, PSSMHANDLE pSSM)
             rc = pgmR3SaveShadowedRomPages(    pVM, pSSM, true /*fLiveSave*/, true /*fFinalPass*/);
             if (RT_SUCCESS(rc))
                 rc = pgmR3SaveMmio2Pages(      pVM, pSSM, true /*fLiveSave*/, SSM_PASS_FINAL);
+            /* With a background writer the dirty pages are only copied to memory
+               here, so the VM can resume while they're written to the side file. */
+            PPGMSAVEBGWRITER pBgWriter = NULL;
+            if (RT_SUCCESS(rc))
+                rc = pgmR3SaveBgWriterCreate(pVM, pSSM, &pBgWriter);
             if (RT_SUCCESS(rc))
-                rc = pgmR3SaveRamPages(        pVM, pSSM, true /*fLiveSave*/, SSM_PASS_FINAL);
+                rc = pgmR3SaveRamPages(        pVM, pSSM, true /*fLiveSave*/, SSM_PASS_FINAL,
+                                               pBgWriter ? pBgWriter->hFile : NIL_RTFILE,
+                                               pVM->pgm.s.fPostCopySave, pBgWriter);
+            if (pBgWriter)
+                rc = pgmR3SaveBgWriterStart(pVM, pBgWriter, rc);
         }
         else
         {
@@ -2184,7 +3247,20 @@ static DECLCALLBACK(int) pgmR3SaveExec(PVM pVM, PSSMHANDLE pSSM)
             if (RT_SUCCESS(rc))
                 rc = pgmR3SaveMmio2Pages(      pVM, pSSM, false /*fLiveSave*/, SSM_PASS_FINAL);
             if (RT_SUCCESS(rc))
-                rc = pgmR3SaveRamPages(        pVM, pSSM, false /*fLiveSave*/, SSM_PASS_FINAL);
+            {
+                RTFILE hRamFile = NIL_RTFILE;
+                rc = pgmR3SaveOpenRamFile(pVM, pSSM, &hRamFile);
+                if (RT_SUCCESS(rc))
+                {
+                    rc = pgmR3SaveRamPages(    pVM, pSSM, false /*fLiveSave*/, SSM_PASS_FINAL, hRamFile, false /*fPostCopy*/, NULL);
+                    if (hRamFile != NIL_RTFILE)
+                    {
+                        int rc2 = RTFileClose(hRamFile);
+                        if (RT_SUCCESS(rc))
+                            rc = rc2;
+                    }
+                }
+            }
         }
         SSMR3PutU8(pSSM, PGM_STATE_REC_END);    /* (Ignore the rc, SSM takes of it.) */
     }
@@ -2209,11 +3285,25 @@ static DECLCALLBACK(int) pgmR3SaveDone(PVM pVM, PSSMHANDLE pSSM)
         pgmR3DoneRamPages(pVM);
     }
 
+    pgmR3IncrSaveDone(pVM, pSSM);
+
+    /*
+     * Lift any auto-converge throttling, unless someone changed the cap.
+     */
+    if (pVM->pgm.s.LiveSave.uThrottleCap)
+    {
+        if (pVM->uCpuExecutionCap == pVM->pgm.s.LiveSave.uThrottleCap)
+            pVM->uCpuExecutionCap = pVM->pgm.s.LiveSave.uOrgCpuExecutionCap;
+        LogRel(("PGM: Auto-converge: lifted the %u%% execution cap\n", pVM->pgm.s.LiveSave.uThrottleCap));
+        pVM->pgm.s.LiveSave.uThrottleCap = 0;
+    }
+
     /*
      * Clear the live save indicator and disengage write monitoring.
      */
     PGM_LOCK_VOID(pVM);
     pVM->pgm.s.LiveSave.fActive = false;
+    pVM->pgm.s.fPostCopySave    = false;
     /** @todo this is blindly assuming that we're the only user of write
      *        monitoring. Fix this when more users are added. */
     pVM->pgm.s.fPhysWriteMonitoringEngaged = false;
@@ -2234,6 +3324,10 @@ static DECLCALLBACK(int) pgmR3LoadPrep(PVM pVM, PSSMHANDLE pSSM)
      */
     PGMR3Reset(pVM);
     pVM->pgm.s.LiveSave.fActive = false;
+    pgmR3IncrLoadTerm(pVM);
+
+    /* The state being loaded might be the one still being written out. */
+    pgmR3SaveBgWriterWait(pVM);
     NOREF(pSSM);
     return VINF_SUCCESS;
 }
@@ -2766,6 +3860,8 @@ static int pgmR3LoadMemory(PVM pVM, PSSMHANDLE pSSM, uint32_t uVersion, uint32_t
             case PGM_STATE_REC_RAM_ZERO:
             case PGM_STATE_REC_RAM_RAW:
             case PGM_STATE_REC_RAM_BALLOONED:
+            case PGM_STATE_REC_RAM_FILE:
+            case PGM_STATE_REC_RAM_PARENT:
             {
                 /*
                  * Get the address and resolve it into a page descriptor.
@@ -2886,6 +3982,37 @@ static int pgmR3LoadMemory(PVM pVM, PSSMHANDLE pSSM, uint32_t uVersion, uint32_t
                         break;
                     }
 
+                    case PGM_STATE_REC_RAM_FILE:
+                    {
+                        rc = pgmR3PhysLazyRestoreAddPage(pVM, pSSM, pRamHint, pPage, GCPhys);
+                        if (RT_FAILURE(rc))
+                            return rc;
+                        break;
+                    }
+
+                    case PGM_STATE_REC_RAM_PARENT:
+                    {
+                        uint8_t iFile = 0;
+                        rc = SSMR3GetU8(pSSM, &iFile);
+                        if (RT_FAILURE(rc))
+                            return rc;
+                        PPGMINCRLOAD const pIncrLoad = pVM->pgm.s.pIncrLoadR3;
+                        AssertLogRelMsgReturn(pIncrLoad && iFile > 0 && iFile < pIncrLoad->cFiles,
+                                              ("GCPhys=%RGp iFile=%u\n", GCPhys, iFile), VERR_SSM_DATA_UNIT_FORMAT_CHANGED);
+
+                        PGMPAGEMAPLOCK PgMpLck;
+                        void          *pvDstPage;
+                        rc = pgmPhysGCPhys2CCPtrInternal(pVM, pPage, GCPhys, &pvDstPage, &PgMpLck);
+                        AssertLogRelMsgRCReturn(rc, ("GCPhys=%RGp %R[pgmpage] rc=%Rrc\n", GCPhys, pPage, rc), rc);
+                        rc = RTFileReadAt(pIncrLoad->ahFiles[iFile], GCPhys, pvDstPage, GUEST_PAGE_SIZE, NULL);
+                        pgmPhysReleaseInternalPageMappingLock(pVM, &PgMpLck);
+                        if (RT_FAILURE(rc))
+                            return SSMR3SetLoadError(pSSM, rc, RT_SRC_POS,
+                                                     N_("Failed to read page %RGp from the RAM side file of an earlier saved state"),
+                                                     GCPhys);
+                        break;
+                    }
+
                     default:
                         AssertMsgFailedReturn(("%#x\n", u8), VERR_PGM_SAVED_REC_TYPE);
                 }
@@ -3091,6 +4218,16 @@ static int pgmR3LoadMemory(PVM pVM, PSSMHANDLE pSSM, uint32_t uVersion, uint32_t
                 break;
             }
 
+            /*
+             * The earlier side files of an incremental state.
+             */
+            case PGM_STATE_REC_RAM_FILE_CHAIN:
+                AssertLogRelMsgReturn(!(u8 & PGM_STATE_REC_FLAG_ADDR), ("%#x\n", u8), VERR_SSM_DATA_UNIT_FORMAT_CHANGED);
+                rc = pgmR3IncrLoadChain(pVM, pSSM);
+                if (RT_FAILURE(rc))
+                    return rc;
+                break;
+
             /*
              * Unknown type.
              */
@@ -3427,7 +4564,12 @@ static DECLCALLBACK(int) pgmR3LoadDone(PVM pVM, PSSMHANDLE pSSM)
 {
     pVM->pgm.s.fRestoreRomPagesOnReset = true;
     NOREF(pSSM);
-    return VINF_SUCCESS;
+    pgmR3IncrLoadTerm(pVM);
+    int rc = pgmR3PhysLazyRestoreArm(pVM);
+#ifdef VBOX_WITH_PAGE_SHARING
+    pgmR3PageScanStateLoaded(pVM);
+#endif
+    return rc;
 }
 
 
@@ -33,6 +33,8 @@
 #define VBOX_WITHOUT_PAGING_BIT_FIELDS /* 64-bit bitfields are just asking for trouble. See @bugref{9841} and others. */
 #include <VBox/vmm/pgm.h>
 #include <VBox/vmm/stam.h>
+#include <VBox/vmm/cfgm.h>
+#include <VBox/vmm/tm.h>
 #include <VBox/vmm/uvm.h>
 #include "PGMInternal.h"
 #include <VBox/vmm/vmcc.h>
@@ -284,6 +286,207 @@ VMMR3DECL(int) PGMR3SharedModuleCheckAll(PVM pVM)
 }
 
 
+/**
+ * Rendezvous callback doing one run of the background duplicate page scanner.
+ *
+ * @returns VBox strict status code.
+ * @param   pVM                 The cross context VM structure.
+ * @param   pVCpu               The cross context virtual CPU structure of the calling EMT.
+ * @param   pvUser              Pointer to a VMCPUID with the requester's ID.
+ */
+static DECLCALLBACK(VBOXSTRICTRC) pgmR3PageScanRendezvous(PVM pVM, PVMCPU pVCpu, void *pvUser)
+{
+    VMCPUID idCpu = *(VMCPUID *)pvUser;
+
+    /* Only the requesting EMT does the work, the others just wait. */
+    if (pVCpu->idCpu != idCpu)
+    {
+        Assert(pVM->cCpus > 1);
+        return VINF_SUCCESS;
+    }
+
+    /* Flush all pending handy page operations before changing any shared page assignments. */
+    int rc = PGMR3PhysAllocateHandyPages(pVM);
+    AssertRC(rc);
+
+    GMMSCANDUPLICATEPAGESREQ Req;
+    RT_ZERO(Req);
+
+    PGM_LOCK_VOID(pVM);
+    Req.idRamRange = pVM->pgm.s.idPageScanRamRange;
+    Req.iPage      = pVM->pgm.s.iPageScanPage;
+    Req.cMaxPages  = pVM->pgm.s.cPageScanBurstLeft ? pVM->pgm.s.cPageScanBurstLeft : pVM->pgm.s.cPageScanPagesPerRun;
+    rc = GMMR3ScanDuplicatePages(pVM, &Req);
+    if (RT_SUCCESS(rc))
+    {
+        pVM->pgm.s.idPageScanRamRange = Req.idRamRange;
+        pVM->pgm.s.iPageScanPage      = Req.iPage;
+    }
+    pgmR3PhysAssertSharedPageChecksums(pVM);
+    PGM_UNLOCK(pVM);
+
+    if (RT_SUCCESS(rc))
+    {
+        STAM_REL_COUNTER_ADD(&pVM->pgm.s.StatPageScanScanned, Req.cScanned);
+        STAM_REL_COUNTER_ADD(&pVM->pgm.s.StatPageScanMerged, Req.cMerged);
+        STAM_REL_COUNTER_ADD(&pVM->pgm.s.StatPageScanShared, Req.cShared);
+        STAM_REL_COUNTER_ADD(&pVM->pgm.s.StatPageScanZero, Req.cZero);
+        if (Req.fWrapped)
+            STAM_REL_COUNTER_INC(&pVM->pgm.s.StatPageScanPasses);
+        if (pVM->pgm.s.cPageScanBurstLeft)
+        {
+            if (Req.cScanned && Req.cScanned < pVM->pgm.s.cPageScanBurstLeft)
+                pVM->pgm.s.cPageScanBurstLeft -= Req.cScanned;
+            else
+            {
+                pVM->pgm.s.cPageScanBurstLeft = 0;
+                LogRel(("PGM: Duplicate page scanner finished the post-restore pass, %RU64 pages shared so far\n",
+                        pVM->pgm.s.StatPageScanMerged.c + pVM->pgm.s.StatPageScanShared.c));
+            }
+        }
+        Log(("pgmR3PageScanRendezvous: scanned=%u merged=%u shared=%u zero=%u next=%u/%#x\n",
+             Req.cScanned, Req.cMerged, Req.cShared, Req.cZero, Req.idRamRange, Req.iPage));
+    }
+    return rc;
+}
+
+
+/**
+ * Runs the background duplicate page scanner once and re-arms its timer.
+ *
+ * @param   pVM         The cross context VM structure.
+ */
+static DECLCALLBACK(void) pgmR3PageScanHelper(PVM pVM)
+{
+    /* We must stall other VCPUs as we'd otherwise have to send IPI flush commands for every single change we make. */
+    VMCPUID idCpu = VMMGetCpuId(pVM);
+    STAM_REL_PROFILE_START(&pVM->pgm.s.StatPageScan, a);
+    int rc = VMMR3EmtRendezvous(pVM, VMMEMTRENDEZVOUS_FLAGS_TYPE_ALL_AT_ONCE, pgmR3PageScanRendezvous, &idCpu);
+    STAM_REL_PROFILE_STOP(&pVM->pgm.s.StatPageScan, a);
+    if (RT_SUCCESS(rc))
+        TMTimerSetMillies(pVM, pVM->pgm.s.hPageScanTimer, pVM->pgm.s.cPageScanBurstLeft ? 1 : pVM->pgm.s.cMsPageScanInterval);
+    else
+        LogRel(("PGM: Duplicate page scanner failed (%Rrc), disabled\n", rc));
+}
+
+
+/**
+ * @callback_method_impl{FNTMTIMERINT, Kicks off a duplicate page scanner run.}
+ */
+static DECLCALLBACK(void) pgmR3PageScanTimer(PVM pVM, TMTIMERHANDLE hTimer, void *pvUser)
+{
+    RT_NOREF(pvUser);
+
+    /* Hold off while a lazy restore is still filling in guest RAM, there is no
+       point in merging pages that are about to be overwritten. */
+    if (pVM->pgm.s.pLazyRestoreR3)
+    {
+        TMTimerSetMillies(pVM, hTimer, pVM->pgm.s.cMsPageScanInterval);
+        return;
+    }
+
+    /* Can't rendezvous from here, so queue the work for an EMT.  The timer is re-armed when it's done. */
+    int rc = VMR3ReqCallNoWait(pVM, VMCPUID_ANY_QUEUE, (PFNRT)pgmR3PageScanHelper, 1, pVM);
+    AssertLogRelRC(rc);
+}
+
+
+/**
+ * Sets up the background duplicate page scanner if configured.
+ *
+ * The scanner walks guest RAM in small slices, hashing private pages and
+ * merging identical ones (within the VM and across VMs) through the GMM shared
+ * page machinery.  Unlike page fusion it needs no guest additions.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ */
+int pgmR3PageScanInit(PVM pVM)
+{
+    pVM->pgm.s.hPageScanTimer = NIL_TMTIMERHANDLE;
+
+    PCFGMNODE pCfg = CFGMR3GetChild(CFGMR3GetRoot(pVM), "/PGM/PageScan");
+
+    /** @cfgm{/PGM/PageScan/Enabled, bool, false}
+     * Whether to run the background duplicate page scanner. */
+    bool fEnabled;
+    int rc = CFGMR3QueryBoolDef(pCfg, "Enabled", &fEnabled, false);
+    AssertLogRelRCReturn(rc, rc);
+    if (!fEnabled)
+        return VINF_SUCCESS;
+
+    /** @cfgm{/PGM/PageScan/PagesPerSecond, uint32_t, 8192}
+     * The max number of pages the scanner looks at per second. */
+    uint32_t cPagesPerSec;
+    rc = CFGMR3QueryU32Def(pCfg, "PagesPerSecond", &cPagesPerSec, 8192);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/PGM/PageScan/IntervalMs, uint32_t, 100}
+     * The interval between scanner runs.  All EMTs are stalled during a run. */
+    rc = CFGMR3QueryU32Def(pCfg, "IntervalMs", &pVM->pgm.s.cMsPageScanInterval, 100);
+    AssertLogRelRCReturn(rc, rc);
+    if (   pVM->pgm.s.cMsPageScanInterval < 10
+        || pVM->pgm.s.cMsPageScanInterval > RT_MS_1MIN)
+        return VMSetError(pVM, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                          "Configuration error: /PGM/PageScan/IntervalMs=%u is out of range (10..60000)",
+                          pVM->pgm.s.cMsPageScanInterval);
+
+    pVM->pgm.s.cPageScanPagesPerRun = RT_MAX((uint32_t)((uint64_t)cPagesPerSec * pVM->pgm.s.cMsPageScanInterval / RT_MS_1SEC), 1);
+
+    /** @cfgm{/PGM/PageScan/RestoreBurst, bool, false}
+     * Whether to do one pass over all of guest RAM at full speed (ignoring
+     * PagesPerSecond) right after restoring a saved state.  This is meant for
+     * many VMs started from copies of the same saved template state: the
+     * restored pages are identical, so they get merged into copy-on-write
+     * shared pages right away instead of over the course of several minutes. */
+    rc = CFGMR3QueryBoolDef(pCfg, "RestoreBurst", &pVM->pgm.s.fPageScanRestoreBurst, false);
+    AssertLogRelRCReturn(rc, rc);
+
+    if (   PGM_IS_IN_NEM_MODE(pVM)
+        || pVM->pgm.s.fRamPreAlloc
+        || pVM->pgm.s.fPciPassthrough
+        || SUPR3IsDriverless())
+    {
+        LogRel(("PGM: Duplicate page scanner not supported in this configuration, ignoring\n"));
+        return VINF_SUCCESS;
+    }
+
+    rc = TMR3TimerCreate(pVM, TMCLOCK_REAL, pgmR3PageScanTimer, NULL, TMTIMER_FLAGS_NO_RING0,
+                         "PGM duplicate page scanner", &pVM->pgm.s.hPageScanTimer);
+    AssertLogRelRCReturn(rc, rc);
+    rc = TMTimerSetMillies(pVM, pVM->pgm.s.hPageScanTimer, pVM->pgm.s.cMsPageScanInterval);
+    AssertLogRelRCReturn(rc, rc);
+
+    LogRel(("PGM: Duplicate page scanner enabled: %u pages every %u ms\n",
+            pVM->pgm.s.cPageScanPagesPerRun, pVM->pgm.s.cMsPageScanInterval));
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Called when a saved state has been loaded, starts the post-restore burst of
+ * the background duplicate page scanner if configured.
+ *
+ * @param   pVM         The cross context VM structure.
+ */
+void pgmR3PageScanStateLoaded(PVM pVM)
+{
+    if (   pVM->pgm.s.hPageScanTimer == NIL_TMTIMERHANDLE
+        || !pVM->pgm.s.fPageScanRestoreBurst)
+        return;
+
+    PGM_LOCK_VOID(pVM);
+    pVM->pgm.s.idPageScanRamRange = 0;
+    pVM->pgm.s.iPageScanPage      = 0;
+    pVM->pgm.s.cPageScanBurstLeft = RT_MAX(pVM->pgm.s.cAllPages, 1);
+    PGM_UNLOCK(pVM);
+
+    LogRel(("PGM: Duplicate page scanner doing a full speed pass over %u pages after restore\n", pVM->pgm.s.cPageScanBurstLeft));
+    int rc = TMTimerSetMillies(pVM, pVM->pgm.s.hPageScanTimer, 1);
+    AssertLogRelRC(rc);
+}
+
+
 # ifdef DEBUG
 /**
  * Query the state of a page in a shared module
@@ -155,6 +155,7 @@
 *********************************************************************************************************************************/
 #define LOG_GROUP LOG_GROUP_SSM
 #include <VBox/vmm/ssm.h>
+#include <VBox/vmm/cfgm.h>
 #include <VBox/vmm/dbgf.h>
 #include <VBox/vmm/pdmapi.h>
 #include <VBox/vmm/pdmcritsect.h>
@@ -172,7 +173,9 @@
 #include <iprt/crc.h>
 #include <iprt/file.h>
 #include <iprt/mem.h>
+#include <iprt/mp.h>
 #include <iprt/param.h>
+#include <iprt/req.h>
 #include <iprt/thread.h>
 #include <iprt/semaphore.h>
 #include <iprt/string.h>
@@ -238,10 +241,13 @@
 /** Named data items.
  * A length prefix zero terminated string (i.e. max 255) followed by the data.  */
 #define SSM_REC_TYPE_NAMED                      5
+/** Raw data compressed by zlib (deflate with zlib header).
+ * Same layout as SSM_REC_TYPE_RAW_LZF.  Not understood by older versions. */
+#define SSM_REC_TYPE_RAW_ZLIB                   6
 /** Macro for validating the record type.
  * This can be used with the flags+type byte, no need to mask out the type first. */
 #define SSM_REC_TYPE_IS_VALID(u8Type)           (   ((u8Type) & SSM_REC_TYPE_MASK) >  SSM_REC_TYPE_INVALID \
-                                                 && ((u8Type) & SSM_REC_TYPE_MASK) <= SSM_REC_TYPE_NAMED )
+                                                 && ((u8Type) & SSM_REC_TYPE_MASK) <= SSM_REC_TYPE_RAW_ZLIB )
 /** @} */
 
 /** The flag mask. */
@@ -295,6 +301,15 @@
  * Must be a multiple of 1KB.  */
 #define SSM_ZIP_BLOCK_SIZE                      _4K
 AssertCompile(SSM_ZIP_BLOCK_SIZE / _1K * _1K == SSM_ZIP_BLOCK_SIZE);
+/** The max size of a compressed block record (header, size byte and data). */
+#define SSM_ZIP_BLOCK_REC_MAX                   (1 + 3 + 1 + SSM_ZIP_BLOCK_SIZE)
+/** The minimum number of blocks each compression worker should get before it
+ * is worth handing a big write to the compression thread pool. */
+#define SSM_ZIP_PAR_MIN_BLOCKS                  16
+/** The max number of blocks compressed in parallel in one go (1MB input). */
+#define SSM_ZIP_PAR_MAX_BLOCKS                  256
+/** The max number of compression worker threads. */
+#define SSM_ZIP_PAR_MAX_THREADS                 16
 
 
 /**
@@ -532,6 +547,18 @@ typedef struct SSMHANDLE
             uint32_t        cDirEntriesAlloced;
             /** SSMSTATE_OPEN_WRITE: The directory. */
             struct SSMFILEDIR *pDir;
+
+            /** The number of compression worker threads to use for big writes,
+             *  0 if compression is done on the calling thread only. */
+            uint32_t        cZipThreads;
+            /** The compression thread pool, created on first use. */
+            RTREQPOOL       hZipPool;
+            /** Output buffer for the compression workers, SSM_ZIP_PAR_MAX_BLOCKS
+             *  times SSMZIPBLOCKREC. */
+            struct SSMZIPBLOCKREC *paZipRecs;
+            /** The record type used for compressed blocks: SSM_REC_TYPE_RAW_LZF,
+             *  SSM_REC_TYPE_RAW_ZLIB or SSM_REC_TYPE_RAW (no compression). */
+            uint8_t         u8ZipRecType;
         } Write;
 
         /** Read data. */
@@ -883,6 +910,20 @@ typedef SSMFILEFTR *PSSMFILEFTR;
 typedef SSMFILEFTR const *PCSSMFILEFTR;
 
 
+/**
+ * A data record produced by a compression worker thread.
+ */
+typedef struct SSMZIPBLOCKREC
+{
+    /** The size of the record in abRec. */
+    uint32_t        cbRec;
+    /** The complete record (header, size and payload). */
+    uint8_t         abRec[SSM_ZIP_BLOCK_REC_MAX];
+} SSMZIPBLOCKREC;
+/** Pointer to a compression worker record. */
+typedef SSMZIPBLOCKREC *PSSMZIPBLOCKREC;
+
+
 /*********************************************************************************************************************************
 *   Global Variables                                                                                                             *
 *********************************************************************************************************************************/
@@ -3464,6 +3505,184 @@ static int ssmR3DataFlushBuffer(PSSMHANDLE pSSM)
 }
 
 
+/**
+ * Compresses one block into a complete data record.
+ *
+ * This is used both on the calling thread and on the compression workers.
+ *
+ * @returns The size of the record.
+ * @param   pvBlock         The block to compress, SSM_ZIP_BLOCK_SIZE bytes.
+ * @param   pb              Where to put the record, SSM_ZIP_BLOCK_REC_MAX bytes.
+ * @param   u8RecType       The compressed record type, see
+ *                          SSMHANDLE::u.Write.u8ZipRecType.
+ */
+static size_t ssmR3DataZipBlock(const void *pvBlock, uint8_t *pb, uint8_t u8RecType)
+{
+    AssertCompile(SSM_ZIP_BLOCK_REC_MAX < 0x00010000);
+    size_t cbRec = SSM_ZIP_BLOCK_SIZE - (SSM_ZIP_BLOCK_SIZE / 16);
+    int rc = VERR_NOT_SUPPORTED;
+    if (u8RecType == SSM_REC_TYPE_RAW_LZF)
+        rc = RTZipBlockCompress(RTZIPTYPE_LZF, RTZIPLEVEL_FAST, 0 /*fFlags*/,
+                                pvBlock, SSM_ZIP_BLOCK_SIZE,
+                                pb + 1 + 3 + 1, cbRec, &cbRec);
+    else if (u8RecType == SSM_REC_TYPE_RAW_ZLIB)
+        rc = RTZipBlockCompress(RTZIPTYPE_ZLIB, RTZIPLEVEL_DEFAULT, 0 /*fFlags*/,
+                                pvBlock, SSM_ZIP_BLOCK_SIZE,
+                                pb + 1 + 3 + 1, cbRec, &cbRec);
+    if (RT_SUCCESS(rc))
+    {
+        pb[0] = SSM_REC_FLAGS_FIXED | SSM_REC_FLAGS_IMPORTANT | u8RecType;
+        pb[4] = SSM_ZIP_BLOCK_SIZE / _1K;
+        cbRec += 1;
+    }
+    else
+    {
+        pb[0] = SSM_REC_FLAGS_FIXED | SSM_REC_FLAGS_IMPORTANT | SSM_REC_TYPE_RAW;
+        memcpy(&pb[4], pvBlock, SSM_ZIP_BLOCK_SIZE);
+        cbRec = SSM_ZIP_BLOCK_SIZE;
+    }
+    pb[1] = (uint8_t)(0xe0 | ( cbRec >> 12));
+    pb[2] = (uint8_t)(0x80 | ((cbRec >>  6) & 0x3f));
+    pb[3] = (uint8_t)(0x80 | ( cbRec        & 0x3f));
+    return cbRec + 1 + 3;
+}
+
+
+/**
+ * Compression worker thread function, turns a series of blocks into records.
+ *
+ * @param   pbSrc           The first block.
+ * @param   paRecs          Where to put the records.
+ * @param   cBlocks         The number of blocks to process.
+ * @param   u8RecType       The compressed record type.
+ */
+static DECLCALLBACK(void) ssmR3DataZipWorker(uint8_t const *pbSrc, PSSMZIPBLOCKREC paRecs, uint32_t cBlocks, uint32_t u8RecType)
+{
+    for (uint32_t i = 0; i < cBlocks; i++, pbSrc += SSM_ZIP_BLOCK_SIZE)
+    {
+        if (    ((uintptr_t)pbSrc & 0xf)
+            ||  !ASMMemIsZero(pbSrc, SSM_ZIP_BLOCK_SIZE))
+            paRecs[i].cbRec = (uint32_t)ssmR3DataZipBlock(pbSrc, paRecs[i].abRec, (uint8_t)u8RecType);
+        else
+        {
+            paRecs[i].abRec[0] = SSM_REC_FLAGS_FIXED | SSM_REC_FLAGS_IMPORTANT | SSM_REC_TYPE_RAW_ZERO;
+            paRecs[i].abRec[1] = 1;
+            paRecs[i].abRec[2] = SSM_ZIP_BLOCK_SIZE / _1K;
+            paRecs[i].cbRec    = 3;
+        }
+    }
+}
+
+
+/**
+ * Destroys the compression thread pool of a save handle, if any.
+ *
+ * @param   pSSM            The saved state handle.
+ */
+static void ssmR3DataZipPoolDestroy(PSSMHANDLE pSSM)
+{
+    if (pSSM->u.Write.hZipPool != NIL_RTREQPOOL)
+    {
+        RTReqPoolRelease(pSSM->u.Write.hZipPool);
+        pSSM->u.Write.hZipPool = NIL_RTREQPOOL;
+    }
+    if (pSSM->u.Write.paZipRecs)
+    {
+        RTMemPageFree(pSSM->u.Write.paZipRecs, SSM_ZIP_PAR_MAX_BLOCKS * sizeof(SSMZIPBLOCKREC));
+        pSSM->u.Write.paZipRecs = NULL;
+    }
+}
+
+
+/**
+ * ssmR3DataWriteBig worker that compresses whole blocks on the compression
+ * thread pool and writes the resulting records in order.
+ *
+ * @returns VBox status code.  VERR_NOT_SUPPORTED if the pool isn't available,
+ *          in which case nothing was written.
+ * @param   pSSM            The saved state handle.
+ * @param   pbBuf           The blocks to write.
+ * @param   cBlocks         The number of blocks, at least SSM_ZIP_PAR_MIN_BLOCKS * 2.
+ */
+static int ssmR3DataWriteBigParallel(PSSMHANDLE pSSM, uint8_t const *pbBuf, size_t cBlocks)
+{
+    /*
+     * Lazily create the pool and the output buffer.
+     */
+    if (pSSM->u.Write.hZipPool == NIL_RTREQPOOL)
+    {
+        pSSM->u.Write.paZipRecs = (PSSMZIPBLOCKREC)RTMemPageAlloc(SSM_ZIP_PAR_MAX_BLOCKS * sizeof(SSMZIPBLOCKREC));
+        int rc = pSSM->u.Write.paZipRecs ? VINF_SUCCESS : VERR_NO_PAGE_MEMORY;
+        if (RT_SUCCESS(rc))
+            rc = RTReqPoolCreate(pSSM->u.Write.cZipThreads, RT_MS_10SEC /*cMsMinIdle*/, UINT32_MAX /*cThreadsPushBackThreshold*/,
+                                 0 /*cMsMaxPushBack*/, "SSMZip", &pSSM->u.Write.hZipPool);
+        if (RT_FAILURE(rc))
+        {
+            LogRel(("SSM: Failed to create compression thread pool (%u threads): %Rrc - compressing serially\n",
+                    pSSM->u.Write.cZipThreads, rc));
+            ssmR3DataZipPoolDestroy(pSSM);
+            pSSM->u.Write.cZipThreads = 0;
+            return VERR_NOT_SUPPORTED;
+        }
+    }
+
+    while (cBlocks > 0)
+    {
+        /*
+         * Divide the round between the workers and ourselves.
+         */
+        uint32_t const cRound   = (uint32_t)RT_MIN(cBlocks, SSM_ZIP_PAR_MAX_BLOCKS);
+        uint32_t const cJobs    = RT_MAX(RT_MIN(pSSM->u.Write.cZipThreads + 1, cRound / SSM_ZIP_PAR_MIN_BLOCKS), 1);
+        uint32_t const cPerJob  = cRound / cJobs;
+        PSSMZIPBLOCKREC const paRecs = pSSM->u.Write.paZipRecs;
+
+        PRTREQ   ahReqs[SSM_ZIP_PAR_MAX_THREADS];
+        uint32_t iJob;
+        for (iJob = 0; iJob < cJobs - 1; iJob++)
+        {
+            ahReqs[iJob] = NIL_RTREQ;
+            int rc = RTReqPoolCallEx(pSSM->u.Write.hZipPool, 0 /*cMillies*/, &ahReqs[iJob], RTREQFLAGS_VOID,
+                                     (PFNRT)ssmR3DataZipWorker, 4,
+                                     pbBuf + (size_t)iJob * cPerJob * SSM_ZIP_BLOCK_SIZE, &paRecs[iJob * cPerJob], cPerJob,
+                                     (uint32_t)pSSM->u.Write.u8ZipRecType);
+            if (rc != VERR_TIMEOUT && RT_FAILURE(rc))
+            {
+                /* Couldn't queue it, do it ourselves. */
+                RTReqRelease(ahReqs[iJob]);
+                ahReqs[iJob] = NIL_RTREQ;
+                ssmR3DataZipWorker(pbBuf + (size_t)iJob * cPerJob * SSM_ZIP_BLOCK_SIZE, &paRecs[iJob * cPerJob], cPerJob,
+                                   pSSM->u.Write.u8ZipRecType);
+            }
+        }
+        ssmR3DataZipWorker(pbBuf + (size_t)iJob * cPerJob * SSM_ZIP_BLOCK_SIZE, &paRecs[iJob * cPerJob],
+                           cRound - iJob * cPerJob, pSSM->u.Write.u8ZipRecType);
+
+        for (iJob = 0; iJob < cJobs - 1; iJob++)
+            if (ahReqs[iJob] != NIL_RTREQ)
+            {
+                int rc = RTReqWait(ahReqs[iJob], RT_INDEFINITE_WAIT);
+                AssertRC(rc);
+                RTReqRelease(ahReqs[iJob]);
+            }
+
+        /*
+         * Write the records in order.
+         */
+        for (uint32_t i = 0; i < cRound; i++)
+        {
+            int rc = ssmR3DataWriteRaw(pSSM, paRecs[i].abRec, paRecs[i].cbRec);
+            if (RT_FAILURE(rc))
+                return rc;
+            ssmR3ProgressByByte(pSSM, SSM_ZIP_BLOCK_SIZE);
+        }
+
+        cBlocks -= cRound;
+        pbBuf   += (size_t)cRound * SSM_ZIP_BLOCK_SIZE;
+    }
+    return VINF_SUCCESS;
+}
+
+
 /**
  * ssmR3DataWrite worker that writes big stuff.
  *
@@ -3479,6 +3698,28 @@ static int ssmR3DataWriteBig(PSSMHANDLE pSSM, const void *pvBuf, size_t cbBuf)
     {
         pSSM->offUnitUser += cbBuf;
 
+        /*
+         * Hand the whole blocks of sufficiently big writes to the compression
+         * thread pool.  The records end up in the stream exactly as if we'd
+         * compressed them here, so this doesn't affect the format.
+         */
+        if (   pSSM->u.Write.cZipThreads > 0
+            && cbBuf >= SSM_ZIP_PAR_MIN_BLOCKS * 2 * SSM_ZIP_BLOCK_SIZE)
+        {
+            size_t const cBlocks = cbBuf / SSM_ZIP_BLOCK_SIZE;
+            rc = ssmR3DataWriteBigParallel(pSSM, (uint8_t const *)pvBuf, cBlocks);
+            if (rc != VERR_NOT_SUPPORTED)
+            {
+                if (RT_FAILURE(rc))
+                    return rc;
+                cbBuf -= cBlocks * SSM_ZIP_BLOCK_SIZE;
+                if (!cbBuf)
+                    return VINF_SUCCESS;
+                pvBuf = (uint8_t const *)pvBuf + cBlocks * SSM_ZIP_BLOCK_SIZE;
+            }
+            rc = VINF_SUCCESS;
+        }
+
         /*
          * Split it up into compression blocks.
          */
@@ -3492,31 +3733,11 @@ static int ssmR3DataWriteBig(PSSMHANDLE pSSM, const void *pvBuf, size_t cbBuf)
                 /*
                  * Compress it.
                  */
-                AssertCompile(1 + 3 + 1 + SSM_ZIP_BLOCK_SIZE < 0x00010000);
                 uint8_t *pb;
-                rc = ssmR3StrmReserveWriteBufferSpace(&pSSM->Strm, 1 + 3 + 1 + SSM_ZIP_BLOCK_SIZE, &pb);
+                rc = ssmR3StrmReserveWriteBufferSpace(&pSSM->Strm, SSM_ZIP_BLOCK_REC_MAX, &pb);
                 if (RT_FAILURE(rc))
                     break;
-                size_t cbRec = SSM_ZIP_BLOCK_SIZE - (SSM_ZIP_BLOCK_SIZE / 16);
-                rc = RTZipBlockCompress(RTZIPTYPE_LZF, RTZIPLEVEL_FAST, 0 /*fFlags*/,
-                                        pvBuf, SSM_ZIP_BLOCK_SIZE,
-                                        pb + 1 + 3 + 1, cbRec, &cbRec);
-                if (RT_SUCCESS(rc))
-                {
-                    pb[0] = SSM_REC_FLAGS_FIXED | SSM_REC_FLAGS_IMPORTANT | SSM_REC_TYPE_RAW_LZF;
-                    pb[4] = SSM_ZIP_BLOCK_SIZE / _1K;
-                    cbRec += 1;
-                }
-                else
-                {
-                    pb[0] = SSM_REC_FLAGS_FIXED | SSM_REC_FLAGS_IMPORTANT | SSM_REC_TYPE_RAW;
-                    memcpy(&pb[4], pvBuf, SSM_ZIP_BLOCK_SIZE);
-                    cbRec = SSM_ZIP_BLOCK_SIZE;
-                }
-                pb[1] = (uint8_t)(0xe0 | ( cbRec >> 12));
-                pb[2] = (uint8_t)(0x80 | ((cbRec >>  6) & 0x3f));
-                pb[3] = (uint8_t)(0x80 | ( cbRec        & 0x3f));
-                cbRec += 1 + 3;
+                size_t const cbRec = ssmR3DataZipBlock(pvBuf, pb, pSSM->u.Write.u8ZipRecType);
                 rc = ssmR3StrmCommitWriteBufferSpace(&pSSM->Strm, cbRec);
                 if (RT_FAILURE(rc))
                     break;
@@ -4642,6 +4863,7 @@ static int ssmR3SaveDoClose(PVM pVM, PSSMHANDLE pSSM)
     pSSM->pVM = NULL;
     pSSM->enmAfter = SSMAFTER_INVALID;
     pSSM->enmOp = SSMSTATE_INVALID;
+    ssmR3DataZipPoolDestroy(pSSM);
     RTMemFree(pSSM);
 
     return rc;
@@ -5451,8 +5673,45 @@ static int ssmR3SaveDoCreateFile(PVM pVM, const char *pszFilename, PCSSMSTRMOPS
     pSSM->pszFilename               = pszFilename;
     pSSM->u.Write.offDataBuffer     = 0;
     pSSM->u.Write.cMsMaxDowntime    = UINT32_MAX;
+    pSSM->u.Write.hZipPool          = NIL_RTREQPOOL;
+    pSSM->u.Write.paZipRecs         = NULL;
+    pSSM->u.Write.u8ZipRecType      = SSM_REC_TYPE_RAW_LZF;
+
+    /** @cfgm{/SSM/CompressionThreads, uint32_t, 0, 16, min(\#cpus / 2\, 4)}
+     * The number of worker threads compressing big writes (like the guest RAM)
+     * in parallel with the saving thread.  0 compresses on the saving thread
+     * only, like in older versions.  The saved state format is the same either
+     * way. */
+    uint32_t const cCpusHalf = RTMpGetOnlineCount() / 2;
+    int rc = CFGMR3QueryU32Def(CFGMR3GetChild(CFGMR3GetRoot(pVM), "SSM"), "CompressionThreads",
+                               &pSSM->u.Write.cZipThreads, RT_MIN(cCpusHalf, 4));
+    AssertRC(rc);
+    pSSM->u.Write.cZipThreads = RT_MIN(pSSM->u.Write.cZipThreads, SSM_ZIP_PAR_MAX_THREADS - 1);
+    if (pSSM->u.Write.cZipThreads <= 1)
+        pSSM->u.Write.cZipThreads = 0; /* Not worth the trouble with a single helper. */
+
+    /** @cfgm{/SSM/Compression, string, lzf}
+     * The compression method for saved state files: "lzf" (fast, the default),
+     * "zlib" (denser, slower, not loadable by older versions) or "none".
+     * @cfgm{/SSM/StreamCompression, string, lzf}
+     * The same for stream saves, i.e. teleportation, where the link speed
+     * usually makes the fast method the better choice. */
+    const char * const pszZipKey = pStreamOps ? "StreamCompression" : "Compression";
+    char szZip[16];
+    rc = CFGMR3QueryStringDef(CFGMR3GetChild(CFGMR3GetRoot(pVM), "SSM"), pszZipKey, szZip, sizeof(szZip), "lzf");
+    if (RT_SUCCESS(rc))
+    {
+        if (!RTStrICmp(szZip, "zlib"))
+            pSSM->u.Write.u8ZipRecType = SSM_REC_TYPE_RAW_ZLIB;
+        else if (!RTStrICmp(szZip, "none"))
+            pSSM->u.Write.u8ZipRecType = SSM_REC_TYPE_RAW;
+        else if (RTStrICmp(szZip, "lzf"))
+            LogRel(("SSM: Unknown /SSM/%s value '%s', using lzf\n", pszZipKey, szZip));
+    }
+    else
+        LogRel(("SSM: Failed to query /SSM/%s: %Rrc, using lzf\n", pszZipKey, rc));
+
 
-    int rc;
     if (pStreamOps)
         rc = ssmR3StrmInit(&pSSM->Strm, pStreamOps, pvStreamOpsUser, true /*fWrite*/, true /*fChecksummed*/, 8 /*cBuffers*/);
     else
@@ -6316,15 +6575,16 @@ DECLINLINE(int) ssmR3DataReadV2RawLzfHdr(PSSMHANDLE pSSM, uint32_t *pcbDecompr)
 
 
 /**
- * Reads an LZF block from the stream and decompresses into the specified
- * buffer.
+ * Reads an LZF or zlib block from the stream and decompresses into the
+ * specified buffer.
  *
  * @returns VBox status code. Sets pSSM->rc on error.
  * @param   pSSM            The saved state handle.
  * @param   pvDst           Pointer to the output buffer.
  * @param   cbDecompr       The size of the decompressed data.
+ * @param   enmZipType      RTZIPTYPE_LZF or RTZIPTYPE_ZLIB.
  */
-static int ssmR3DataReadV2RawLzf(PSSMHANDLE pSSM, void *pvDst, size_t cbDecompr)
+static int ssmR3DataReadV2RawLzf(PSSMHANDLE pSSM, void *pvDst, size_t cbDecompr, RTZIPTYPE enmZipType)
 {
     int         rc;
     uint32_t    cbCompr    = pSSM->u.Read.cbRecLeft;
@@ -6351,7 +6611,7 @@ static int ssmR3DataReadV2RawLzf(PSSMHANDLE pSSM, void *pvDst, size_t cbDecompr)
      * Decompress it.
      */
     size_t cbDstActual;
-    rc = RTZipBlockDecompress(RTZIPTYPE_LZF, 0 /*fFlags*/,
+    rc = RTZipBlockDecompress(enmZipType, 0 /*fFlags*/,
                               pb, cbCompr, NULL /*pcbSrcActual*/,
                               pvDst, cbDecompr, &cbDstActual);
     if (RT_SUCCESS(rc))
@@ -6628,20 +6888,23 @@ static int ssmR3DataReadUnbufferedV2(PSSMHANDLE pSSM, void *pvBuf, size_t cbBuf)
             }
 
             case SSM_REC_TYPE_RAW_LZF:
+            case SSM_REC_TYPE_RAW_ZLIB:
             {
+                RTZIPTYPE const enmZipType = (pSSM->u.Read.u8TypeAndFlags & SSM_REC_TYPE_MASK) == SSM_REC_TYPE_RAW_LZF
+                                           ? RTZIPTYPE_LZF : RTZIPTYPE_ZLIB;
                 int rc = ssmR3DataReadV2RawLzfHdr(pSSM, &cbToRead);
                 if (RT_FAILURE(rc))
                     return rc;
                 if (cbToRead <= cbBuf)
                 {
-                    rc = ssmR3DataReadV2RawLzf(pSSM, pvBuf, cbToRead);
+                    rc = ssmR3DataReadV2RawLzf(pSSM, pvBuf, cbToRead, enmZipType);
                     if (RT_FAILURE(rc))
                         return rc;
                 }
                 else
                 {
                     /* The output buffer is too small, use the data buffer. */
-                    rc = ssmR3DataReadV2RawLzf(pSSM, &pSSM->u.Read.abDataBuffer[0], cbToRead);
+                    rc = ssmR3DataReadV2RawLzf(pSSM, &pSSM->u.Read.abDataBuffer[0], cbToRead, enmZipType);
                     if (RT_FAILURE(rc))
                         return rc;
                     pSSM->u.Read.cbDataBuffer  = cbToRead;
@@ -6751,11 +7014,14 @@ static int ssmR3DataReadBufferedV2(PSSMHANDLE pSSM, void *pvBuf, size_t cbBuf)
             }
 
             case SSM_REC_TYPE_RAW_LZF:
+            case SSM_REC_TYPE_RAW_ZLIB:
             {
+                RTZIPTYPE const enmZipType = (pSSM->u.Read.u8TypeAndFlags & SSM_REC_TYPE_MASK) == SSM_REC_TYPE_RAW_LZF
+                                           ? RTZIPTYPE_LZF : RTZIPTYPE_ZLIB;
                 int rc = ssmR3DataReadV2RawLzfHdr(pSSM, &cbToRead);
                 if (RT_FAILURE(rc))
                     return rc;
-                rc = ssmR3DataReadV2RawLzf(pSSM, &pSSM->u.Read.abDataBuffer[0], cbToRead);
+                rc = ssmR3DataReadV2RawLzf(pSSM, &pSSM->u.Read.abDataBuffer[0], cbToRead, enmZipType);
                 if (RT_FAILURE(rc))
                     return rc;
                 pSSM->u.Read.cbDataBuffer = cbToRead;
@@ -10069,6 +10335,20 @@ VMMR3DECL(bool) SSMR3HandleIsLiveSave(PSSMHANDLE pSSM)
 }
 
 
+/**
+ * Gets the name of the file being saved to or loaded from.
+ *
+ * @returns Pointer to a read only string, NULL if it is a stream operation
+ *          (e.g. teleportation).  Only valid while the operation is active.
+ * @param   pSSM            The saved state handle.
+ */
+VMMR3DECL(const char *) SSMR3HandleFilename(PSSMHANDLE pSSM)
+{
+    SSM_ASSERT_VALID_HANDLE(pSSM);
+    return pSSM->pszFilename;
+}
+
+
 /**
  * Gets the maximum downtime for a live operation.
  *
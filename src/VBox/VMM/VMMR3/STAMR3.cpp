@@ -61,6 +61,8 @@
 #define LOG_GROUP LOG_GROUP_STAM
 #include <VBox/vmm/stam.h>
 #include "STAMInternal.h"
+#include <VBox/vmm/cfgm.h>
+#include <VBox/vmm/mm.h>
 #include <VBox/vmm/vmcc.h>
 
 #include <VBox/err.h>
@@ -70,8 +72,12 @@
 #include <iprt/assert.h>
 #include <iprt/asm.h>
 #include <iprt/mem.h>
+#include <iprt/semaphore.h>
+#include <iprt/shmem.h>
 #include <iprt/stream.h>
 #include <iprt/string.h>
+#include <iprt/thread.h>
+#include <iprt/time.h>
 
 
 /*********************************************************************************************************************************
@@ -129,6 +135,75 @@ typedef struct STAMR3SNAPSHOTONE
 } STAMR3SNAPSHOTONE, *PSTAMR3SNAPSHOTONE;
 
 
+/** The max number of values a sample has in the shared memory export. */
+#define STAMSHM_MAX_VALUES  (4 + STAM_HISTOGRAM_BUCKETS)
+
+/**
+ * The shared memory export instance data.
+ */
+typedef struct STAMSHMEXPORT
+{
+    /** Pointer to the user mode VM structure. */
+    PUVM                pUVM;
+    /** The shared memory handle. */
+    RTSHMEM             hShMem;
+    /** The mapping of the region. */
+    PSTAMSHMHDR         pHdr;
+    /** Pointer to the value array in the region. */
+    uint64_t           *pau64Values;
+    /** The size of the region. */
+    uint32_t            cbShMem;
+    /** The update interval in milliseconds. */
+    uint32_t            cMsInterval;
+    /** The export thread. */
+    RTTHREAD            hThread;
+    /** Event semaphore the export thread sleeps on. */
+    RTSEMEVENT          hEvtWakeup;
+    /** Set when the thread should terminate. */
+    bool volatile       fTerminate;
+    /** Set when doing a layout rebuild walk. */
+    bool                fRebuild;
+    /** Set once the generation has been checked during the walk. */
+    bool                fGenChecked;
+    /** Set if the samples didn't all fit. */
+    bool                fTruncated;
+    /** Whether we've complained about truncation. */
+    bool                fLoggedTruncation;
+    /** Whether we've complained about update failures. */
+    bool                fLoggedFailure;
+    /** The STAM generation the published layout reflects, UINT32_MAX if none. */
+    uint32_t            uGenLayout;
+    /** The STAM generation the current walk is based on. */
+    uint32_t            uGenWalk;
+    /** The current descriptor index in a value update walk. */
+    uint32_t            iDesc;
+    /** Number of descriptors in paDescs. */
+    uint32_t            cDescs;
+    /** Number of descriptors allocated. */
+    uint32_t            cDescsAlloc;
+    /** Number of values used in pau64Staging. */
+    uint32_t            cValues;
+    /** Number of values allocated. */
+    uint32_t            cValuesAlloc;
+    /** Bytes used in the string table staging buffer. */
+    uint32_t            cbStrings;
+    /** Bytes allocated for the string table staging buffer. */
+    uint32_t            cbStringsAlloc;
+    /** Private copy of the descriptor table. */
+    PSTAMSHMDESC        paDescs;
+    /** The string table staging buffer. */
+    char               *pchStrings;
+    /** The value staging buffer used during layout rebuilds. */
+    uint64_t           *pau64Staging;
+    /** The sample pattern (MM heap). */
+    char               *pszPattern;
+    /** The region name. */
+    char                szName[128];
+} STAMSHMEXPORT;
+/** Pointer to the shared memory export instance data. */
+typedef STAMSHMEXPORT *PSTAMSHMEXPORT;
+
+
 /**
  * Init record for a ring-0 statistic sample.
  */
@@ -255,6 +330,7 @@ static const STAMR0SAMPLE g_aGMMStats[] =
     { RT_UOFFSETOF(GMMSTATS, cFreedChunks),                     STAMTYPE_U32,   STAMUNIT_COUNT, "/GMM/cFreedChunks",                "The number of freed chunks ever." },
     { RT_UOFFSETOF(GMMSTATS, cShareableModules),                STAMTYPE_U32,   STAMUNIT_COUNT, "/GMM/cShareableModules",           "The number of shareable modules." },
     { RT_UOFFSETOF(GMMSTATS, idFreeGeneration),                 STAMTYPE_U64,   STAMUNIT_NONE,  "/GMM/idFreeGeneration",            "The current chunk freeing generation number (for per-VM chunk lookup TLB versioning)." },
+    { RT_UOFFSETOF(GMMSTATS, cPreZeroedPages),                  STAMTYPE_U64,   STAMUNIT_PAGES, "/GMM/cPreZeroedPages",             "The number of free pages zeroed ahead of allocation by the background thread." },
     { RT_UOFFSETOF(GMMSTATS, VMStats.Reserved.cBasePages),      STAMTYPE_U64,   STAMUNIT_PAGES, "/GMM/VM/Reserved/cBasePages",      "The amount of base memory (RAM, ROM, ++) reserved by the VM." },
     { RT_UOFFSETOF(GMMSTATS, VMStats.Reserved.cShadowPages),    STAMTYPE_U32,   STAMUNIT_PAGES, "/GMM/VM/Reserved/cShadowPages",    "The amount of memory reserved for shadow/nested page tables." },
     { RT_UOFFSETOF(GMMSTATS, VMStats.Reserved.cFixedPages),     STAMTYPE_U32,   STAMUNIT_PAGES, "/GMM/VM/Reserved/cFixedPages",     "The amount of memory reserved for fixed allocations like MMIO2 and the hyper heap." },
@@ -294,6 +370,7 @@ VMMR3DECL(int) STAMR3InitUVM(PUVM pUVM)
      */
     AssertCompile(sizeof(pUVM->stam.s) <= sizeof(pUVM->stam.padding));
     AssertRelease(sizeof(pUVM->stam.s) <= sizeof(pUVM->stam.padding));
+    AssertCompileMemberOffset(STAMHISTOGRAM, Core, 0); /* Treated like STAMPROFILE in most places. */
 
     /*
      * Initialize the read/write lock and list.
@@ -720,7 +797,8 @@ static void stamR3SumRefresh(PSTAMSUMSAMPLE pSum)
             {
                 PSTAMDESC const pDesc = pSum->apSummands[i];
                 AssertContinue(   pDesc->enmType == STAMTYPE_PROFILE
-                               || pDesc->enmType == STAMTYPE_PROFILE_ADV);
+                               || pDesc->enmType == STAMTYPE_PROFILE_ADV
+                               || pDesc->enmType == STAMTYPE_HISTOGRAM);
                 PSTAMPROFILE const pProfile = pDesc->u.pProfile;
                 cPeriods += pProfile->cPeriods;
                 uTotal   += pProfile->cTicks;
@@ -781,6 +859,7 @@ static int stamR3RegisterSumEnumCallback(PSTAMDESC pDesc, void *pvArg)
 
             case STAMTYPE_PROFILE:
             case STAMTYPE_PROFILE_ADV:
+            case STAMTYPE_HISTOGRAM:
                 pSum->enmType = STAMTYPE_PROFILE;
                 break;
 
@@ -828,7 +907,8 @@ static int stamR3RegisterSumEnumCallback(PSTAMDESC pDesc, void *pvArg)
 
                 case STAMTYPE_PROFILE:
                     AssertMsgReturn(   pDesc->enmType == STAMTYPE_PROFILE
-                                    || pDesc->enmType == STAMTYPE_PROFILE_ADV,
+                                    || pDesc->enmType == STAMTYPE_PROFILE_ADV
+                                    || pDesc->enmType == STAMTYPE_HISTOGRAM,
                                     ("Unsupported type mixup: %d & %d (%s)\n", pSum->enmType, pDesc->enmType, pDesc->pszName),
                                     VERR_MISMATCH);
                     break;
@@ -973,6 +1053,7 @@ static void stamR3PctOfSumRefresh(PSTAMDESC pDesc, PSTAMSUMSAMPLE pSum)
 
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             uValue = pValDesc->u.pProfile->cTicks;
             break;
 
@@ -1035,6 +1116,7 @@ static void stamR3PctOfSumRefresh(PSTAMDESC pDesc, PSTAMSUMSAMPLE pSum)
 
             case STAMTYPE_PROFILE:
             case STAMTYPE_PROFILE_ADV:
+            case STAMTYPE_HISTOGRAM:
                 uSum += pSummandDesc->u.pProfile->cTicks;
                 break;
 
@@ -1119,6 +1201,7 @@ static int stamR3RegisterPctOfSumEnumCallbackForValue(PSTAMDESC pDesc, void *pvA
         case STAMTYPE_X8_RESET:
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
         case STAMTYPE_INTERNAL_SUM:
             break;
 
@@ -1175,6 +1258,7 @@ static int stamR3RegisterPctOfSumEnumCallbackForSummands(PSTAMDESC pDesc, void *
             case STAMTYPE_X8_RESET:
             case STAMTYPE_PROFILE:
             case STAMTYPE_PROFILE_ADV:
+            case STAMTYPE_HISTOGRAM:
             case STAMTYPE_INTERNAL_SUM:
                 break;
 
@@ -2227,6 +2311,7 @@ static int stamR3RegisterU(PUVM pUVM, void *pvSample, PFNSTAMR3CALLBACKRESET pfn
         case STAMTYPE_COUNTER:
         case STAMTYPE_PROFILE:
         case STAMTYPE_PROFILE_ADV:
+        case STAMTYPE_HISTOGRAM:
             AssertMsg(!((uintptr_t)pvSample & 7), ("%p - %s\n", pvSample, pszName));
             break;
 
@@ -2299,6 +2384,7 @@ static int stamR3RegisterU(PUVM pUVM, void *pvSample, PFNSTAMR3CALLBACKRESET pfn
         pNew->pLookup       = pLookup;
         pLookup->pDesc      = pNew;
         stamR3LookupIncUsage(pLookup);
+        ASMAtomicIncU32(&pUVM->stam.s.uGeneration);
 
         stamR3ResetOne(pNew, pUVM->pVM);
         rc = VINF_SUCCESS;
@@ -2315,10 +2401,12 @@ static int stamR3RegisterU(PUVM pUVM, void *pvSample, PFNSTAMR3CALLBACKRESET pfn
  * Destroys the statistics descriptor, unlinking it and freeing all resources.
  *
  * @returns VINF_SUCCESS
+ * @param   pUVM        Pointer to the user mode VM structure.
  * @param   pCur        The descriptor to destroy.
  */
-static int stamR3DestroyDesc(PSTAMDESC pCur)
+static int stamR3DestroyDesc(PUVM pUVM, PSTAMDESC pCur)
 {
+    ASMAtomicIncU32(&pUVM->stam.s.uGeneration);
     RTListNodeRemove(&pCur->ListEntry);
     pCur->pLookup->pDesc = NULL; /** @todo free lookup nodes once it's working. */
     stamR3LookupDecUsage(pCur->pLookup);
@@ -2364,7 +2452,7 @@ VMMR3DECL(int)  STAMR3DeregisterByAddr(PUVM pUVM, void *pvSample)
     RTListForEachSafe(&pUVM->stam.s.List, pCur, pNext, STAMDESC, ListEntry)
     {
         if (pCur->u.pv == pvSample)
-            rc = stamR3DestroyDesc(pCur);
+            rc = stamR3DestroyDesc(pUVM, pCur);
     }
 
     STAM_UNLOCK_WR(pUVM);
@@ -2397,7 +2485,7 @@ static int stamR3DeregisterByPattern(PUVM pUVM, const char *pszPat)
             PSTAMDESC pNext = RTListNodeGetNext(&pCur->ListEntry, STAMDESC, ListEntry);
 
             if (RTStrSimplePatternMatch(pszPat, pCur->pszName))
-                rc = stamR3DestroyDesc(pCur);
+                rc = stamR3DestroyDesc(pUVM, pCur);
 
             /* advance. */
             if (pCur == pLast)
@@ -2512,7 +2600,7 @@ VMMR3DECL(int)  STAMR3DeregisterByPrefix(PUVM pUVM, const char *pszPrefix)
             PSTAMDESC const pNext = RTListNodeGetNext(&pCur->ListEntry, STAMDESC, ListEntry);
             Assert(strncmp(pCur->pszName, pszPrefix, cchPrefix) == 0);
 
-            rc = stamR3DestroyDesc(pCur);
+            rc = stamR3DestroyDesc(pUVM, pCur);
 
             /* advance. */
             if (pCur == pLast)
@@ -2657,6 +2745,15 @@ static int stamR3ResetOne(PSTAMDESC pDesc, void *pvArg)
             ASMAtomicXchgU64(&pDesc->u.pProfile->cTicksMin, UINT64_MAX);
             break;
 
+        case STAMTYPE_HISTOGRAM:
+            ASMAtomicXchgU64(&pDesc->u.pHistogram->Core.cPeriods, 0);
+            ASMAtomicXchgU64(&pDesc->u.pHistogram->Core.cTicks, 0);
+            ASMAtomicXchgU64(&pDesc->u.pHistogram->Core.cTicksMax, 0);
+            ASMAtomicXchgU64(&pDesc->u.pHistogram->Core.cTicksMin, UINT64_MAX);
+            for (unsigned i = 0; i < RT_ELEMENTS(pDesc->u.pHistogram->acBuckets); i++)
+                ASMAtomicXchgU32(&pDesc->u.pHistogram->acBuckets[i], 0);
+            break;
+
         case STAMTYPE_RATIO_U32_RESET:
             ASMAtomicXchgU32(&pDesc->u.pRatioU32->u32A, 0);
             ASMAtomicXchgU32(&pDesc->u.pRatioU32->u32B, 0);
@@ -2769,6 +2866,37 @@ VMMR3DECL(int) STAMR3Snapshot(PUVM pUVM, const char *pszPat, char **ppszSnapshot
 }
 
 
+/**
+ * Calculates a percentile of a histogram sample.
+ *
+ * Since the buckets are log2 sized, this is an upper bound, i.e. the end of
+ * the bucket the percentile falls into (or the max value for the last one).
+ *
+ * @returns The upper bound, 0 if the histogram is empty.
+ * @param   pHist       The histogram.
+ * @param   uPermille   The percentile in permille (e.g. 990 for p99).
+ */
+static uint64_t stamR3HistogramPercentile(PCSTAMHISTOGRAM pHist, uint32_t uPermille)
+{
+    uint64_t const cPeriods = pHist->Core.cPeriods;
+    if (cPeriods)
+    {
+        uint64_t cSoFar = 0;
+        for (unsigned i = 0; i < RT_ELEMENTS(pHist->acBuckets); i++)
+        {
+            cSoFar += pHist->acBuckets[i];
+            if (cSoFar * 1000 >= cPeriods * uPermille)
+                return i + 1 < RT_ELEMENTS(pHist->acBuckets)
+                     ? RT_MIN(RT_BIT_64(i + STAM_HISTOGRAM_FIRST_SHIFT), pHist->Core.cTicksMax)
+                     : pHist->Core.cTicksMax;
+        }
+        /* The buckets are updated separately from the core, so they may lag behind a little. */
+        return pHist->Core.cTicksMax;
+    }
+    return 0;
+}
+
+
 /**
  * stamR3EnumU callback employed by STAMR3Snapshot.
  *
@@ -2797,6 +2925,22 @@ static int stamR3SnapshotOne(PSTAMDESC pDesc, void *pvArg)
                                  pDesc->u.pProfile->cTicksMax);
             break;
 
+        case STAMTYPE_HISTOGRAM:
+        {
+            PCSTAMHISTOGRAM const pHist = pDesc->u.pHistogram;
+            if (pDesc->enmVisibility == STAMVISIBILITY_USED && pHist->Core.cPeriods == 0)
+                return VINF_SUCCESS;
+            stamR3SnapshotPrintf(pThis, "<Histogram cPeriods=\"%lld\" cTicks=\"%lld\" cTicksMin=\"%lld\" cTicksMax=\"%lld\""
+                                 " p50=\"%llu\" p99=\"%llu\" p999=\"%llu\" uShift=\"%u\" acBuckets=\"",
+                                 pHist->Core.cPeriods, pHist->Core.cTicks, pHist->Core.cTicksMin, pHist->Core.cTicksMax,
+                                 stamR3HistogramPercentile(pHist, 500), stamR3HistogramPercentile(pHist, 990),
+                                 stamR3HistogramPercentile(pHist, 999), STAM_HISTOGRAM_FIRST_SHIFT);
+            for (unsigned i = 0; i < RT_ELEMENTS(pHist->acBuckets); i++)
+                stamR3SnapshotPrintf(pThis, i ? ",%u" : "%u", pHist->acBuckets[i]);
+            stamR3SnapshotPrintf(pThis, "\"");
+            break;
+        }
+
         case STAMTYPE_RATIO_U32:
         case STAMTYPE_RATIO_U32_RESET:
             if (pDesc->enmVisibility == STAMVISIBILITY_USED && !pDesc->u.pRatioU32->u32A && !pDesc->u.pRatioU32->u32B)
@@ -3059,6 +3203,513 @@ VMMR3DECL(int)  STAMR3SnapshotFree(PUVM pUVM, char *pszSnapshot)
 }
 
 
+/**
+ * Gets the shared memory export values for a sample.
+ *
+ * @returns Number of values stored in @a pau64, 0 if the sample isn't exported.
+ * @param   pDesc       The sample descriptor.
+ * @param   pau64       Where to store the values (STAMSHM_MAX_VALUES entries).
+ * @param   penmType    Where to return the type to report for the sample.
+ */
+static uint8_t stamR3ShmGetValues(PSTAMDESC pDesc, uint64_t *pau64, STAMTYPE *penmType)
+{
+    *penmType = pDesc->enmType;
+    switch (pDesc->enmType)
+    {
+        case STAMTYPE_COUNTER:
+            pau64[0] = pDesc->u.pCounter->c;
+            return 1;
+
+        case STAMTYPE_PROFILE:
+        case STAMTYPE_PROFILE_ADV:
+            pau64[0] = pDesc->u.pProfile->cPeriods;
+            pau64[1] = pDesc->u.pProfile->cTicks;
+            pau64[2] = pDesc->u.pProfile->cTicksMin;
+            pau64[3] = pDesc->u.pProfile->cTicksMax;
+            return 4;
+
+        case STAMTYPE_HISTOGRAM:
+        {
+            PCSTAMHISTOGRAM const pHist = pDesc->u.pHistogram;
+            pau64[0] = pHist->Core.cPeriods;
+            pau64[1] = pHist->Core.cTicks;
+            pau64[2] = pHist->Core.cTicksMin;
+            pau64[3] = pHist->Core.cTicksMax;
+            for (unsigned i = 0; i < RT_ELEMENTS(pHist->acBuckets); i++)
+                pau64[4 + i] = pHist->acBuckets[i];
+            return 4 + STAM_HISTOGRAM_BUCKETS;
+        }
+
+        case STAMTYPE_RATIO_U32:
+        case STAMTYPE_RATIO_U32_RESET:
+            pau64[0] = pDesc->u.pRatioU32->u32A;
+            pau64[1] = pDesc->u.pRatioU32->u32B;
+            return 2;
+
+        case STAMTYPE_U8:
+        case STAMTYPE_U8_RESET:
+        case STAMTYPE_X8:
+        case STAMTYPE_X8_RESET:
+            pau64[0] = *pDesc->u.pu8;
+            return 1;
+
+        case STAMTYPE_U16:
+        case STAMTYPE_U16_RESET:
+        case STAMTYPE_X16:
+        case STAMTYPE_X16_RESET:
+            pau64[0] = *pDesc->u.pu16;
+            return 1;
+
+        case STAMTYPE_U32:
+        case STAMTYPE_U32_RESET:
+        case STAMTYPE_X32:
+        case STAMTYPE_X32_RESET:
+            pau64[0] = *pDesc->u.pu32;
+            return 1;
+
+        case STAMTYPE_U64:
+        case STAMTYPE_U64_RESET:
+        case STAMTYPE_X64:
+        case STAMTYPE_X64_RESET:
+            pau64[0] = *pDesc->u.pu64;
+            return 1;
+
+        case STAMTYPE_BOOL:
+        case STAMTYPE_BOOL_RESET:
+            pau64[0] = *pDesc->u.pf;
+            return 1;
+
+        case STAMTYPE_INTERNAL_SUM:
+        {
+            PSTAMSUMSAMPLE const pSum = pDesc->u.pSum;
+            stamR3SumRefresh(pSum);
+            *penmType = (STAMTYPE)pSum->enmType;
+            if (pSum->enmType == STAMTYPE_COUNTER)
+            {
+                pau64[0] = pSum->u.Counter.c;
+                return 1;
+            }
+            AssertMsgReturn(pSum->enmType == STAMTYPE_PROFILE, ("%d\n", pSum->enmType), 0);
+            pau64[0] = pSum->u.Profile.cPeriods;
+            pau64[1] = pSum->u.Profile.cTicks;
+            pau64[2] = pSum->u.Profile.cTicksMin;
+            pau64[3] = pSum->u.Profile.cTicksMax;
+            return 4;
+        }
+
+        case STAMTYPE_INTERNAL_PCT_OF_SUM:
+            stamR3PctOfSumRefresh(pDesc, pDesc->u.pSum);
+            *penmType = STAMTYPE_COUNTER;
+            pau64[0] = pDesc->u.pSum->u.Counter.c;
+            return 1;
+
+        case STAMTYPE_CALLBACK:
+            return 0;
+
+        default:
+            AssertMsgFailedReturn(("%d\n", pDesc->enmType), 0);
+    }
+}
+
+
+/**
+ * Appends a string to the shared memory export string table staging buffer.
+ *
+ * @returns Offset of the string, UINT32_MAX on allocation failure.
+ * @param   pThis       The shared memory export instance.
+ * @param   psz         The string.
+ */
+static uint32_t stamR3ShmAddString(PSTAMSHMEXPORT pThis, const char *psz)
+{
+    size_t const cb = strlen(psz) + 1;
+    if (pThis->cbStrings + cb > pThis->cbStringsAlloc)
+    {
+        uint32_t const cbNew = RT_ALIGN_32(pThis->cbStrings + (uint32_t)cb + _64K, _64K);
+        void *pvNew = RTMemRealloc(pThis->pchStrings, cbNew);
+        if (!pvNew)
+            return UINT32_MAX;
+        pThis->pchStrings     = (char *)pvNew;
+        pThis->cbStringsAlloc = cbNew;
+    }
+    uint32_t const off = pThis->cbStrings;
+    memcpy(&pThis->pchStrings[off], psz, cb);
+    pThis->cbStrings += (uint32_t)cb;
+    return off;
+}
+
+
+/**
+ * Calculates the region layout for the current staging buffer content.
+ *
+ * @returns Number of bytes needed.
+ * @param   cDescs      Number of descriptors.
+ * @param   cbStrings   Size of the string table.
+ * @param   cValues     Number of values.
+ */
+DECLINLINE(size_t) stamR3ShmCalcSize(uint32_t cDescs, uint32_t cbStrings, uint32_t cValues)
+{
+    return RT_ALIGN_Z(RT_ALIGN_Z(sizeof(STAMSHMHDR), 64) + cDescs * sizeof(STAMSHMDESC) + cbStrings, 64)
+         + cValues * sizeof(uint64_t);
+}
+
+
+/**
+ * Enumeration callback used by stamR3ShmUpdate.
+ *
+ * @returns VINF_SUCCESS, VERR_TRY_AGAIN if the layout must be rebuilt,
+ *          VERR_NO_MEMORY.
+ * @param   pDesc       Pointer to the current descriptor.
+ * @param   pvArg       The shared memory export instance.
+ */
+static int stamR3ShmUpdateOne(PSTAMDESC pDesc, void *pvArg)
+{
+    PSTAMSHMEXPORT const pThis = (PSTAMSHMEXPORT)pvArg;
+
+    /* We're called with the STAM lock held, so the generation can only have
+       changed before the first call. */
+    if (!pThis->fGenChecked)
+    {
+        if (ASMAtomicReadU32(&pThis->pUVM->stam.s.uGeneration) != pThis->uGenWalk)
+            return VERR_TRY_AGAIN;
+        pThis->fGenChecked = true;
+    }
+
+    uint64_t au64[STAMSHM_MAX_VALUES];
+    STAMTYPE enmType;
+    uint8_t const cValues = stamR3ShmGetValues(pDesc, au64, &enmType);
+    if (!cValues)
+        return VINF_SUCCESS;
+
+    if (!pThis->fRebuild)
+    {
+        /*
+         * Value only update, straight into the shared memory.
+         */
+        if (pThis->iDesc >= pThis->cDescs)
+            return VINF_SUCCESS; /* truncated */
+        PCSTAMSHMDESC const pShmDesc = &pThis->paDescs[pThis->iDesc++];
+        if (RT_UNLIKELY(   pShmDesc->enmType != (uint8_t)enmType
+                        || pShmDesc->cValues != cValues))
+            return VERR_TRY_AGAIN;
+        memcpy(&pThis->pau64Values[pShmDesc->iValue], au64, cValues * sizeof(uint64_t));
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Layout rebuild, everything goes into the staging buffers.
+     */
+    if (pThis->fTruncated)
+        return VINF_SUCCESS;
+    size_t const cbDesc = pDesc->pszDesc ? strlen(pDesc->pszDesc) + 1 : 0;
+    if (  stamR3ShmCalcSize(pThis->cDescs + 1, pThis->cbStrings + (uint32_t)(strlen(pDesc->pszName) + 1 + cbDesc),
+                            pThis->cValues + cValues)
+        > pThis->cbShMem)
+    {
+        pThis->fTruncated = true;
+        return VINF_SUCCESS;
+    }
+
+    if (pThis->cDescs >= pThis->cDescsAlloc)
+    {
+        uint32_t const cNew = pThis->cDescsAlloc + 1024;
+        void *pvNew = RTMemRealloc(pThis->paDescs, cNew * sizeof(pThis->paDescs[0]));
+        if (!pvNew)
+            return VERR_NO_MEMORY;
+        pThis->paDescs     = (PSTAMSHMDESC)pvNew;
+        pThis->cDescsAlloc = cNew;
+    }
+    if (pThis->cValues + cValues > pThis->cValuesAlloc)
+    {
+        uint32_t const cNew = pThis->cValuesAlloc + 4096;
+        void *pvNew = RTMemRealloc(pThis->pau64Staging, cNew * sizeof(uint64_t));
+        if (!pvNew)
+            return VERR_NO_MEMORY;
+        pThis->pau64Staging = (uint64_t *)pvNew;
+        pThis->cValuesAlloc = cNew;
+    }
+
+    PSTAMSHMDESC const pShmDesc = &pThis->paDescs[pThis->cDescs];
+    pShmDesc->offName       = stamR3ShmAddString(pThis, pDesc->pszName);
+    pShmDesc->offDesc       = pDesc->pszDesc ? stamR3ShmAddString(pThis, pDesc->pszDesc) : UINT32_MAX;
+    if (pShmDesc->offName == UINT32_MAX || (pDesc->pszDesc && pShmDesc->offDesc == UINT32_MAX))
+        return VERR_NO_MEMORY;
+    pShmDesc->iValue        = pThis->cValues;
+    pShmDesc->enmType       = (uint8_t)enmType;
+    pShmDesc->enmUnit       = (uint8_t)pDesc->enmUnit;
+    pShmDesc->enmVisibility = (uint8_t)pDesc->enmVisibility;
+    pShmDesc->cValues       = cValues;
+    memcpy(&pThis->pau64Staging[pThis->cValues], au64, cValues * sizeof(uint64_t));
+    pThis->cValues += cValues;
+    pThis->cDescs++;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Updates the shared memory export region.
+ *
+ * @param   pThis       The shared memory export instance.
+ */
+static void stamR3ShmUpdate(PSTAMSHMEXPORT pThis)
+{
+    PSTAMSHMHDR const pHdr = pThis->pHdr;
+    uint32_t const    uGen = ASMAtomicReadU32(&pThis->pUVM->stam.s.uGeneration);
+
+    pThis->fRebuild    = uGen != pThis->uGenLayout;
+    pThis->uGenWalk    = uGen;
+    pThis->fGenChecked = false;
+    pThis->iDesc       = 0;
+    if (pThis->fRebuild)
+    {
+        pThis->cDescs     = 0;
+        pThis->cValues    = 0;
+        pThis->cbStrings  = 0;
+        pThis->fTruncated = false;
+    }
+    else
+        ASMAtomicIncU32(&pHdr->uSeq); /* odd - values being updated. */
+
+    int rc = stamR3EnumU(pThis->pUVM, pThis->pszPattern, true /*fUpdateRing0*/, stamR3ShmUpdateOne, pThis);
+
+    if (!pThis->fRebuild)
+    {
+        ASMAtomicWriteU64(&pHdr->u64NanoTS, RTTimeNanoTS());
+        ASMAtomicIncU32(&pHdr->uSeq); /* even - consistent again. */
+        if (rc == VERR_TRY_AGAIN)
+            pThis->uGenLayout = UINT32_MAX; /* rebuild next time. */
+        return;
+    }
+
+    if (RT_FAILURE(rc))
+    {
+        pThis->uGenLayout = UINT32_MAX;
+        if (rc != VERR_TRY_AGAIN && !pThis->fLoggedFailure)
+        {
+            LogRel(("STAM: Updating the shared memory export failed: %Rrc\n", rc));
+            pThis->fLoggedFailure = true;
+        }
+        return;
+    }
+
+    /*
+     * Publish the new layout.
+     */
+    uint32_t const offDescs   = RT_ALIGN_32(sizeof(STAMSHMHDR), 64);
+    uint32_t const offStrings = offDescs + pThis->cDescs * (uint32_t)sizeof(STAMSHMDESC);
+    uint32_t const offValues  = RT_ALIGN_32(offStrings + pThis->cbStrings, 64);
+    uint32_t const cbUsed     = offValues + pThis->cValues * (uint32_t)sizeof(uint64_t);
+    Assert(cbUsed <= pThis->cbShMem);
+
+    ASMAtomicIncU32(&pHdr->uSeq);
+    pHdr->cDescs      = pThis->cDescs;
+    pHdr->cValues     = pThis->cValues;
+    pHdr->offDescs    = offDescs;
+    pHdr->offStrings  = offStrings;
+    pHdr->offValues   = offValues;
+    pHdr->cbUsed      = cbUsed;
+    pHdr->fFlags      = pThis->fTruncated ? STAMSHM_F_TRUNCATED : 0;
+    memcpy((uint8_t *)pHdr + offDescs, pThis->paDescs, pThis->cDescs * sizeof(STAMSHMDESC));
+    memcpy((uint8_t *)pHdr + offStrings, pThis->pchStrings, pThis->cbStrings);
+    pThis->pau64Values = (uint64_t *)((uint8_t *)pHdr + offValues);
+    memcpy(pThis->pau64Values, pThis->pau64Staging, pThis->cValues * sizeof(uint64_t));
+    ASMAtomicIncU32(&pHdr->uGeneration);
+    ASMAtomicWriteU64(&pHdr->u64NanoTS, RTTimeNanoTS());
+    ASMAtomicIncU32(&pHdr->uSeq);
+
+    if (pThis->fTruncated && !pThis->fLoggedTruncation)
+    {
+        LogRel(("STAM: The shared memory export is too small, only %u samples were exported\n", pThis->cDescs));
+        pThis->fLoggedTruncation = true;
+    }
+    pThis->uGenLayout = uGen;
+}
+
+
+/**
+ * @callback_method_impl{FNRTTHREAD, The shared memory export thread.}
+ */
+static DECLCALLBACK(int) stamR3ShmThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    PSTAMSHMEXPORT const pThis = (PSTAMSHMEXPORT)pvUser;
+    RT_NOREF(hThreadSelf);
+
+    while (!ASMAtomicReadBool(&pThis->fTerminate))
+    {
+        stamR3ShmUpdate(pThis);
+        RTSemEventWait(pThis->hEvtWakeup, pThis->cMsInterval);
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Destroys the shared memory export instance.
+ *
+ * @param   pThis       The shared memory export instance.
+ */
+static void stamR3ShmDestroy(PSTAMSHMEXPORT pThis)
+{
+    if (pThis->hThread != NIL_RTTHREAD)
+    {
+        ASMAtomicWriteBool(&pThis->fTerminate, true);
+        RTSemEventSignal(pThis->hEvtWakeup);
+        int rc = RTThreadWait(pThis->hThread, RT_MS_30SEC, NULL);
+        AssertLogRelRC(rc);
+        pThis->hThread = NIL_RTTHREAD;
+    }
+    if (pThis->hEvtWakeup != NIL_RTSEMEVENT)
+    {
+        RTSemEventDestroy(pThis->hEvtWakeup);
+        pThis->hEvtWakeup = NIL_RTSEMEVENT;
+    }
+    if (pThis->hShMem != NIL_RTSHMEM)
+    {
+        if (pThis->pHdr)
+            RTShMemUnmapRegion(pThis->hShMem, pThis->pHdr);
+        RTShMemClose(pThis->hShMem);
+        RTShMemDelete(pThis->szName);
+        pThis->hShMem = NIL_RTSHMEM;
+    }
+    RTMemFree(pThis->paDescs);
+    RTMemFree(pThis->pchStrings);
+    RTMemFree(pThis->pau64Staging);
+    MMR3HeapFree(pThis->pszPattern);
+    RTMemFree(pThis);
+}
+
+
+/**
+ * Called when ring-3 init has completed, sets up the shared memory export
+ * if configured.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ */
+VMMR3_INT_DECL(int) STAMR3InitCompleted(PVM pVM)
+{
+    PUVM const      pUVM    = pVM->pUVM;
+    PCFGMNODE const pCfgShm = CFGMR3GetChild(CFGMR3GetRoot(pVM), "STAM/SharedMemory");
+    if (!pCfgShm)
+        return VINF_SUCCESS;
+
+    int rc = CFGMR3ValidateConfig(pCfgShm, "/STAM/SharedMemory/", "Name|Pattern|IntervalMs|MaxSize", "", "STAM", 0);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    PSTAMSHMEXPORT pThis = (PSTAMSHMEXPORT)RTMemAllocZ(sizeof(*pThis));
+    AssertReturn(pThis, VERR_NO_MEMORY);
+    pThis->pUVM       = pUVM;
+    pThis->hShMem     = NIL_RTSHMEM;
+    pThis->hThread    = NIL_RTTHREAD;
+    pThis->hEvtWakeup = NIL_RTSEMEVENT;
+    pThis->uGenLayout = UINT32_MAX;
+
+    /** @cfgm{/STAM/SharedMemory/Name, string}
+     * The name of the shared memory region to export the statistics in, see
+     * grp_stam_shm for the layout.  The region is created when the VM is
+     * constructed and deleted when it is destroyed.  Leave the
+     * /STAM/SharedMemory node out to disable the export. */
+    rc = CFGMR3QueryString(pCfgShm, "Name", pThis->szName, sizeof(pThis->szName));
+    if (RT_FAILURE(rc))
+    {
+        RTMemFree(pThis);
+        return VMSetError(pVM, rc, RT_SRC_POS, N_("Configuration error: Querying \"/STAM/SharedMemory/Name\" failed"));
+    }
+
+    /** @cfgm{/STAM/SharedMemory/Pattern, string, "*"}
+     * The STAM pattern selecting the samples to export. */
+    rc = CFGMR3QueryStringAllocDef(pCfgShm, "Pattern", &pThis->pszPattern, "*");
+    if (RT_SUCCESS(rc))
+    {
+        /** @cfgm{/STAM/SharedMemory/IntervalMs, uint32_t, ms, 10, 3600000, 1000}
+         * How often to update the values in the shared memory region. */
+        rc = CFGMR3QueryU32Def(pCfgShm, "IntervalMs", &pThis->cMsInterval, RT_MS_1SEC);
+        if (RT_SUCCESS(rc) && (pThis->cMsInterval < 10 || pThis->cMsInterval > RT_MS_1HOUR))
+            rc = VMSetError(pVM, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                            N_("Configuration error: \"/STAM/SharedMemory/IntervalMs\" must be between 10 and 3600000, not %u"),
+                            pThis->cMsInterval);
+    }
+    if (RT_SUCCESS(rc))
+    {
+        /** @cfgm{/STAM/SharedMemory/MaxSize, uint32_t, bytes, 64K, 1G, 16M}
+         * The size of the shared memory region.  Samples that don't fit aren't
+         * exported and STAMSHM_F_TRUNCATED is set. */
+        uint32_t cbMax = 0;
+        rc = CFGMR3QueryU32Def(pCfgShm, "MaxSize", &cbMax, _16M);
+        if (RT_SUCCESS(rc) && (cbMax < _64K || cbMax > _1G))
+            rc = VMSetError(pVM, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                            N_("Configuration error: \"/STAM/SharedMemory/MaxSize\" must be between 64K and 1G, not %#x"), cbMax);
+        pThis->cbShMem = RT_ALIGN_32(cbMax, _4K);
+    }
+
+    /*
+     * Create and map the region, then start the thread doing the updating.
+     */
+    if (RT_SUCCESS(rc))
+    {
+        rc = RTShMemOpen(&pThis->hShMem, pThis->szName, RTSHMEM_O_F_CREATE | RTSHMEM_O_F_READWRITE | RTSHMEM_O_F_TRUNCATE,
+                         pThis->cbShMem, 1 /*cMappingsHint*/);
+        if (RT_SUCCESS(rc))
+        {
+            rc = RTShMemSetSize(pThis->hShMem, pThis->cbShMem);
+            if (RT_SUCCESS(rc))
+                rc = RTShMemMapRegion(pThis->hShMem, 0, pThis->cbShMem, RTSHMEM_MAP_F_READ | RTSHMEM_MAP_F_WRITE,
+                                      (void **)&pThis->pHdr);
+            if (RT_SUCCESS(rc))
+            {
+                RT_BZERO(pThis->pHdr, sizeof(*pThis->pHdr));
+                pThis->pHdr->u32Version  = STAMSHM_VERSION;
+                pThis->pHdr->cMsInterval = pThis->cMsInterval;
+                pThis->pHdr->offDescs    = RT_ALIGN_32(sizeof(STAMSHMHDR), 64);
+                pThis->pHdr->offStrings  = pThis->pHdr->offDescs;
+                pThis->pHdr->offValues   = pThis->pHdr->offDescs;
+                pThis->pHdr->cbUsed      = pThis->pHdr->offDescs;
+                ASMAtomicWriteU32(&pThis->pHdr->u32Magic, STAMSHM_MAGIC);
+
+                rc = RTSemEventCreate(&pThis->hEvtWakeup);
+                if (RT_SUCCESS(rc))
+                    rc = RTThreadCreate(&pThis->hThread, stamR3ShmThread, pThis, 0 /*cbStack*/, RTTHREADTYPE_INFREQUENT_POLLER,
+                                        RTTHREADFLAGS_WAITABLE, "StamShm");
+            }
+            if (RT_FAILURE(rc))
+                rc = VMSetError(pVM, rc, RT_SRC_POS, N_("Failed to set up the STAM shared memory export '%s'"), pThis->szName);
+        }
+        else
+            rc = VMSetError(pVM, rc, RT_SRC_POS, N_("Failed to create the STAM shared memory region '%s'"), pThis->szName);
+    }
+    if (RT_FAILURE(rc))
+    {
+        stamR3ShmDestroy(pThis);
+        return rc;
+    }
+
+    LogRel(("STAM: Exporting statistics matching '%s' in shared memory region '%s' (%#x bytes) every %u ms\n",
+            pThis->pszPattern, pThis->szName, pThis->cbShMem, pThis->cMsInterval));
+    pUVM->stam.s.pShmExport = pThis;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Terminates the VM bound STAM bits, i.e. the shared memory export.
+ *
+ * This is called before the other components are terminated, so the samples
+ * they registered are still valid while the export thread is shut down.
+ *
+ * @param   pVM         The cross context VM structure.
+ */
+VMMR3_INT_DECL(void) STAMR3Term(PVM pVM)
+{
+    PUVM const           pUVM  = pVM->pUVM;
+    PSTAMSHMEXPORT const pThis = pUVM->stam.s.pShmExport;
+    if (pThis)
+    {
+        pUVM->stam.s.pShmExport = NULL;
+        stamR3ShmDestroy(pThis);
+    }
+}
+
+
 /**
  * Dumps the selected statistics to the log.
  *
@@ -3214,6 +3865,28 @@ static int stamR3PrintOne(PSTAMDESC pDesc, void *pvArg)
             break;
         }
 
+        case STAMTYPE_HISTOGRAM:
+        {
+            PCSTAMHISTOGRAM const pHist = pDesc->u.pHistogram;
+            if (pDesc->enmVisibility == STAMVISIBILITY_USED && pHist->Core.cPeriods == 0)
+                return VINF_SUCCESS;
+
+            uint64_t const u64 = pHist->Core.cPeriods ? pHist->Core.cPeriods : 1;
+            pArgs->pfnPrintf(pArgs, "%-42s %9llu %s (%12llu %s, %7llu %s, max %9llu, min %7lld)\n", pDesc->pszName,
+                             pHist->Core.cTicks / u64, STAMR3GetUnit(pDesc->enmUnit),
+                             pHist->Core.cTicks, STAMR3GetUnit1(pDesc->enmUnit),
+                             pHist->Core.cPeriods, STAMR3GetUnit2(pDesc->enmUnit),
+                             pHist->Core.cTicksMax, pHist->Core.cTicksMin);
+            if (pHist->Core.cPeriods)
+            {
+                /* The percentiles are upper bounds, i.e. the end of the bucket they fall into. */
+                pArgs->pfnPrintf(pArgs, "%-42s p50<=%llu p90<=%llu p99<=%llu p99.9<=%llu\n", "",
+                                 stamR3HistogramPercentile(pHist, 500), stamR3HistogramPercentile(pHist, 900),
+                                 stamR3HistogramPercentile(pHist, 990), stamR3HistogramPercentile(pHist, 999));
+            }
+            break;
+        }
+
         case STAMTYPE_RATIO_U32:
         case STAMTYPE_RATIO_U32_RESET:
             if (pDesc->enmVisibility == STAMVISIBILITY_USED && !pDesc->u.pRatioU32->u32A && !pDesc->u.pRatioU32->u32B)
@@ -3810,6 +4483,16 @@ static void stamR3Ring0StatsRegisterU(PUVM pUVM)
         stamR3RegisterU(pUVM, &pUVM->stam.s.GVMMStats.aVCpus[i].cWakeUpTimerSameCpu, NULL, NULL,
                         STAMTYPE_U32, STAMVISIBILITY_ALWAYS, szName, STAMUNIT_OCCURENCES, "", STAM_REFRESH_GRP_GVMM);
 
+        strcpy(&szName[cchBase], "cHaltPollHits");
+        stamR3RegisterU(pUVM, &pUVM->stam.s.GVMMStats.aVCpus[i].cHaltPollHits, NULL, NULL,
+                        STAMTYPE_U32, STAMVISIBILITY_ALWAYS, szName, STAMUNIT_OCCURENCES,
+                        "Halts that ended while polling.", STAM_REFRESH_GRP_GVMM);
+
+        strcpy(&szName[cchBase], "cHaltPollMisses");
+        stamR3RegisterU(pUVM, &pUVM->stam.s.GVMMStats.aVCpus[i].cHaltPollMisses, NULL, NULL,
+                        STAMTYPE_U32, STAMVISIBILITY_ALWAYS, szName, STAMUNIT_OCCURENCES,
+                        "Halts that polled and blocked anyway.", STAM_REFRESH_GRP_GVMM);
+
         strcpy(&szName[cchBase], "Start");
         stamR3RegisterU(pUVM, &pUVM->stam.s.GVMMStats.aVCpus[i].Start, NULL, NULL,
                         STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, szName, STAMUNIT_TICKS_PER_CALL, "", STAM_REFRESH_GRP_GVMM);
@@ -176,6 +176,8 @@
 *********************************************************************************************************************************/
 /** The current saved state version.*/
 #define TM_SAVED_STATE_VERSION  3
+/** The minimum interval between two steal time samples (TMR3CpuUpdateStealTime). */
+#define TM_STEAL_TIME_SAMPLE_INTERVAL_NS    (RT_NS_1MS * 4)
 
 
 /*********************************************************************************************************************************
@@ -254,6 +256,7 @@ VMM_INT_DECL(int) TMR3Init(PVM pVM)
         pVM->tm.s.aTimerQueues[i].enmClock          = (TMCLOCK)i;
         pVM->tm.s.aTimerQueues[i].u64Expire         = INT64_MAX;
         pVM->tm.s.aTimerQueues[i].idxActive         = UINT32_MAX;
+        pVM->tm.s.aTimerQueues[i].idxActiveTail     = UINT32_MAX;
         pVM->tm.s.aTimerQueues[i].idxSchedule       = UINT32_MAX;
         pVM->tm.s.aTimerQueues[i].idxFreeHint       = 1;
         pVM->tm.s.aTimerQueues[i].fBeingProcessed   = false;
@@ -368,6 +371,7 @@ VMM_INT_DECL(int) TMR3Init(PVM pVM)
                               "HostHzFudgeFactorCatchUp100|"
                               "HostHzFudgeFactorCatchUp200|"
                               "HostHzFudgeFactorCatchUp400|"
+                              "Tickless|"
                               "TimerMillies"
                               ,
                               "",
@@ -677,15 +681,28 @@ VMM_INT_DECL(int) TMR3Init(PVM pVM)
             pVM->tm.s.cTSCTicksPerSecondHost, pVM->tm.s.cTSCTicksPerSecondHost,
             pVM->tm.s.fTSCTiedToExecution, pVM->tm.s.fTSCNotTiedToHalt));
 
+    /** @cfgm{/TM/Tickless, bool, false}
+     * Tickless EMT waits.  The halted timer EMT already sleeps until the
+     * deadline of the next expiring timer across all queues (high resolution
+     * host wait), this makes TM wake it up to re-arm that deadline whenever
+     * another thread arms a timer which becomes the new queue head.  The
+     * watchdog timer below then only serves as a backstop, so it defaults to a
+     * one second interval instead of ticking every 10 ms.  Intended for hosts
+     * running many mostly idle VMs. */
+    rc = CFGMR3QueryBoolDef(pCfgHandle, "Tickless", &pVM->tm.s.fTickless, false);
+    if (RT_FAILURE(rc))
+        return VMSetError(pVM, rc, RT_SRC_POS,
+                          N_("Configuration error: Failed to querying bool value \"Tickless\""));
+
     /*
      * Start the timer (guard against REM not yielding).
      */
     /** @cfgm{/TM/TimerMillies, uint32_t, ms, 1, 1000, 10}
-     * The watchdog timer interval.  */
+     * The watchdog timer interval.  Defaults to 1000 with HM or /TM/Tickless. */
     uint32_t u32Millies;
     rc = CFGMR3QueryU32(pCfgHandle, "TimerMillies", &u32Millies);
     if (rc == VERR_CFGM_VALUE_NOT_FOUND)
-        u32Millies = VM_IS_HM_ENABLED(pVM) ? 1000 : 10;
+        u32Millies = VM_IS_HM_ENABLED(pVM) || pVM->tm.s.fTickless ? 1000 : 10;
     else if (RT_FAILURE(rc))
         return VMSetError(pVM, rc, RT_SRC_POS,
                           N_("Configuration error: Failed to query uint32_t value \"TimerMillies\""));
@@ -696,6 +713,8 @@ VMM_INT_DECL(int) TMR3Init(PVM pVM)
         return rc;
     }
     Log(("TM: Created timer %p firing every %d milliseconds\n", pVM->tm.s.pTimer, u32Millies));
+    if (pVM->tm.s.fTickless)
+        LogRel(("TM: Tickless EMT waits enabled, watchdog interval %u ms\n", u32Millies));
     pVM->tm.s.u32TimerMillies = u32Millies;
 
     /*
@@ -725,6 +744,10 @@ VMM_INT_DECL(int) TMR3Init(PVM pVM)
         rc = STAMR3RegisterF(pVM, (void *)&pVM->tm.s.aTimerQueues[i].uMaxHzHint, STAMTYPE_U32, STAMVISIBILITY_ALWAYS, STAMUNIT_HZ,
                              "", "/TM/MaxHzHint/%s", pVM->tm.s.aTimerQueues[i].szName);
         AssertRC(rc);
+        rc = STAMR3RegisterF(pVM, (void *)&pVM->tm.s.aTimerQueues[i].cActive, STAMTYPE_U32, STAMVISIBILITY_ALWAYS,
+                             STAMUNIT_OCCURENCES, "Number of active timers.", "/TM/QueueDepth/%s",
+                             pVM->tm.s.aTimerQueues[i].szName);
+        AssertRC(rc);
     }
 
 #ifdef VBOX_WITH_STATISTICS
@@ -754,6 +777,12 @@ VMM_INT_DECL(int) TMR3Init(PVM pVM)
     STAM_REG(pVM, &pVM->tm.s.StatScheduleOneR3,                       STAMTYPE_PROFILE, "/TM/ScheduleOneR3",               STAMUNIT_TICKS_PER_CALL, "Profiling the scheduling of one queue during a TMTimer* call in EMT.");
     STAM_REG(pVM, &pVM->tm.s.StatScheduleOneRZ,                       STAMTYPE_PROFILE, "/TM/ScheduleOneRZ",               STAMUNIT_TICKS_PER_CALL, "Profiling the scheduling of one queue during a TMTimer* call in EMT.");
     STAM_REG(pVM, &pVM->tm.s.StatScheduleSetFF,                       STAMTYPE_COUNTER, "/TM/ScheduleSetFF",                   STAMUNIT_OCCURENCES, "The number of times the timer FF was set instead of doing scheduling.");
+    STAM_REG(pVM, &pVM->tm.s.StatTicklessWakeups,                     STAMTYPE_COUNTER, "/TM/TicklessWakeups",                 STAMUNIT_OCCURENCES, "Times the halted timer EMT was woken up to re-arm its deadline (/TM/Tickless).");
+    STAM_REG(pVM, &pVM->tm.s.StatLinkActive,                          STAMTYPE_PROFILE, "/TM/LinkActive",                  STAMUNIT_TICKS_PER_CALL, "Profiling inserting a timer into the active list of its queue.");
+    for (uint32_t i = 0; i < RT_ELEMENTS(pVM->tm.s.aTimerQueues); i++)
+        STAMR3RegisterF(pVM, &pVM->tm.s.aStatLinkActiveSteps[i], STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                        "Active list entries walked when inserting a timer.", "/TM/LinkActive/Steps/%s",
+                        pVM->tm.s.aTimerQueues[i].szName);
 
     STAM_REG(pVM, &pVM->tm.s.StatTimerSet,                            STAMTYPE_COUNTER, "/TM/TimerSet",                        STAMUNIT_OCCURENCES, "Calls, except virtual sync timers");
     STAM_REG(pVM, &pVM->tm.s.StatTimerSetOpt,                         STAMTYPE_COUNTER, "/TM/TimerSet/Opt",                    STAMUNIT_OCCURENCES, "Optimized path taken.");
@@ -852,6 +881,8 @@ VMM_INT_DECL(int) TMR3Init(PVM pVM)
         STAMR3RegisterF(pVM, &pVCpu->tm.s.cNsOtherStat,          STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_NS,    "Time spent in the VMM or preempted.",          "/TM/CPU/%02u/cNsOther", i);
         STAMR3RegisterF(pVM, &pVCpu->tm.s.cPeriodsExecuting,     STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT, "Times executed guest code.",                   "/TM/CPU/%02u/cPeriodsExecuting", i);
         STAMR3RegisterF(pVM, &pVCpu->tm.s.cPeriodsHalted,        STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT, "Times halted.",                                "/TM/CPU/%02u/cPeriodsHalted", i);
+        STAMR3RegisterF(pVM, &pVCpu->tm.s.cNsHaltedRing0,        STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_NS,    "Time spent halted in ring-0.",                 "/TM/CPU/%02u/cNsHaltedRing0", i);
+        STAMR3RegisterF(pVM, &pVCpu->tm.s.cNsSteal,              STAMTYPE_U64, STAMVISIBILITY_ALWAYS, STAMUNIT_NS,    "Time runnable but not scheduled by the host.", "/TM/CPU/%02u/cNsSteal", i);
         STAMR3RegisterF(pVM, &pVCpu->tm.s.CpuLoad.cPctExecuting, STAMTYPE_U8,  STAMVISIBILITY_ALWAYS, STAMUNIT_PCT,   "Time spent executing guest code recently.",    "/TM/CPU/%02u/pctExecuting", i);
         STAMR3RegisterF(pVM, &pVCpu->tm.s.CpuLoad.cPctHalted,    STAMTYPE_U8,  STAMVISIBILITY_ALWAYS, STAMUNIT_PCT,   "Time spent halted recently.",                  "/TM/CPU/%02u/pctHalted", i);
         STAMR3RegisterF(pVM, &pVCpu->tm.s.CpuLoad.cPctOther,     STAMTYPE_U8,  STAMVISIBILITY_ALWAYS, STAMUNIT_PCT,   "Time spent in the VMM or preempted recently.", "/TM/CPU/%02u/pctOther", i);
@@ -2065,21 +2096,7 @@ static int tmR3TimerDestroy(PVMCC pVM, PTMTIMERQUEUE pQueue, PTMTIMER pTimer)
      * Unlink from the active list.
      */
     if (fActive)
-    {
-        const PTMTIMER pPrev = tmTimerGetPrev(pQueue, pTimer);
-        const PTMTIMER pNext = tmTimerGetNext(pQueue, pTimer);
-        if (pPrev)
-            tmTimerSetNext(pQueue, pPrev, pNext);
-        else
-        {
-            tmTimerQueueSetHead(pQueue, pQueue, pNext);
-            pQueue->u64Expire = pNext ? pNext->u64Expire : INT64_MAX;
-        }
-        if (pNext)
-            tmTimerSetPrev(pQueue, pNext, pPrev);
-        pTimer->idxNext = UINT32_MAX;
-        pTimer->idxPrev = UINT32_MAX;
-    }
+        tmTimerQueueUnlinkActiveWorker(pVM, pQueue, pQueue, pTimer);
 
     /*
      * Unlink from the schedule list by running it.
@@ -2421,18 +2438,7 @@ static void tmR3TimerQueueRun(PVM pVM, PTMTIMERQUEUE pQueue, PTMTIMER pTimer)
             Assert(pTimer->idxScheduleNext == UINT32_MAX); /* this can trigger falsely */
 
             /* unlink */
-            const PTMTIMER pPrev = tmTimerGetPrev(pQueue, pTimer);
-            if (pPrev)
-                tmTimerSetNext(pQueue, pPrev, pNext);
-            else
-            {
-                tmTimerQueueSetHead(pQueue, pQueue, pNext);
-                pQueue->u64Expire = pNext ? pNext->u64Expire : INT64_MAX;
-            }
-            if (pNext)
-                tmTimerSetPrev(pQueue, pNext, pPrev);
-            pTimer->idxNext = UINT32_MAX;
-            pTimer->idxPrev = UINT32_MAX;
+            tmTimerQueueUnlinkActiveWorker(pVM, pQueue, pQueue, pTimer);
 
             /* fire */
             TM_SET_STATE(pTimer, TMTIMERSTATE_EXPIRED_DELIVER);
@@ -2877,6 +2883,35 @@ VMMR3_INT_DECL(void) TMR3VirtualSyncFF(PVM pVM, PVMCPU pVCpu)
 }
 
 
+/**
+ * Notification from VMR3HotUnplugCpu that the calling virtual CPU goes offline.
+ *
+ * The EMT of an unplugged CPU is parked and doesn't run the timer queues, so
+ * when it is the timer EMT that job is handed over to EMT(0), which cannot be
+ * unplugged.  The timer EMT stays EMT(0) when the CPU is plugged in again.
+ *
+ * @param   pVM     The cross context VM structure.
+ * @param   pVCpu   The cross context virtual CPU structure of the calling EMT.
+ *
+ * @thread  The EMT of @a pVCpu.
+ */
+VMMR3_INT_DECL(void) TMR3CpuHotUnplug(PVM pVM, PVMCPU pVCpu)
+{
+    VMCPU_ASSERT_EMT(pVCpu);
+    if (   pVCpu->idCpu == pVM->tm.s.idTimerCpu
+        && pVCpu->idCpu != 0)
+    {
+        LogRel(("TM: Moving the timer queues from CPU %u to CPU 0 (hot unplug)\n", pVCpu->idCpu));
+        ASMAtomicWriteU32(&pVM->tm.s.idTimerCpu, 0);
+
+        /* Make EMT(0) check the queues right away rather than at its next halt deadline. */
+        PVMCPU pVCpuDst = pVM->apCpusR3[0];
+        VMCPU_FF_SET(pVCpuDst, VMCPU_FF_TIMER);
+        VMR3NotifyCpuFFU(pVCpuDst->pUVCpu, VMNOTIFYFF_FLAGS_DONE_REM | VMNOTIFYFF_FLAGS_POKE);
+    }
+}
+
+
 /**
  * Service the special virtual sync timer queue.
  *
@@ -3345,6 +3380,10 @@ VMMR3DECL(int) TMR3NotifyResume(PVM pVM, PVMCPU pVCpu)
     pVCpu->tm.s.nsStartTotal = RTTimeNanoTS() - pVCpu->tm.s.nsStartTotal;
     pVCpu->tm.s.fSuspended   = false;
     ASMAtomicWriteU32(&pVCpu->tm.s.uTimesGen, (uGen | 1) + 1);
+
+    /* Whatever the EMT did while suspended must not count against the steal
+       time, so take a new base on the next sample. */
+    pVCpu->tm.s.nsStealLastSample = 0;
 #endif
 
     /*
@@ -3646,6 +3685,101 @@ VMMR3DECL(int) TMR3GetCpuLoadPercents(PUVM pUVM, VMCPUID idCpu, uint64_t *pcMsIn
 #endif
 }
 
+
+/**
+ * Samples the steal time of the calling EMT's virtual CPU.
+ *
+ * The steal time is the part of the time the VCPU was runnable (neither halted
+ * nor suspended) that the host didn't let the EMT spend on a CPU.  It is
+ * derived from the thread CPU time the host reports for the EMT, so it has the
+ * millisecond granularity of RTThreadGetExecutionTimeMilli and includes time
+ * the EMT spends blocking in ring-3 on something other than a halt.  The value
+ * only ever grows and a new base is taken whenever the two sources disagree
+ * about the direction, and when resuming the VM.
+ *
+ * This is rate limited and cheap enough to be called each time the EMT passes
+ * through the EM loop.
+ *
+ * @returns true if the steal time changed and paravirt. interfaces should be
+ *          updated, false if not.
+ * @param   pVM         The cross context VM structure.
+ * @param   pVCpu       The cross context virtual CPU structure of the caller.
+ * @thread  EMT(pVCpu)
+ */
+VMMR3_INT_DECL(bool) TMR3CpuUpdateStealTime(PVM pVM, PVMCPU pVCpu)
+{
+    VMCPU_ASSERT_EMT(pVCpu);
+    RT_NOREF(pVM);
+
+#ifndef VBOX_WITHOUT_NS_ACCOUNTING
+    uint64_t const nsNow  = RTTimeNanoTS();
+    uint64_t const nsLast = pVCpu->tm.s.nsStealLastSample;
+    if (   (nsLast && nsNow - nsLast < TM_STEAL_TIME_SAMPLE_INTERVAL_NS)
+        || pVCpu->tm.s.fSuspended)
+        return false;
+
+    uint64_t cMsKernel = 0;
+    uint64_t cMsUser   = 0;
+    int rc = RTThreadGetExecutionTimeMilli(&cMsKernel, &cMsUser);
+    if (RT_FAILURE(rc))
+        return false;
+
+    uint64_t const cMsCpu      = cMsKernel + cMsUser;
+    uint64_t const cNsRunnable = nsNow - pVCpu->tm.s.nsStartTotal - pVCpu->tm.s.cNsHalted - pVCpu->tm.s.cNsHaltedRing0;
+    pVCpu->tm.s.nsStealLastSample = nsNow;
+
+    int64_t const cNsStolen = nsLast
+                            ?   (int64_t)(cNsRunnable - pVCpu->tm.s.cNsRunnableBase)
+                              - (int64_t)((cMsCpu - pVCpu->tm.s.cMsCpuBase) * RT_NS_1MS)
+                            : -1;
+    if (cNsStolen < 0)
+    {
+        /* First sample or the EMT burned CPU time while not runnable (halt loop). */
+        pVCpu->tm.s.cNsStealBase    = pVCpu->tm.s.cNsSteal;
+        pVCpu->tm.s.cNsRunnableBase = cNsRunnable;
+        pVCpu->tm.s.cMsCpuBase      = cMsCpu;
+        return false;
+    }
+
+    uint64_t const cNsStealNew = pVCpu->tm.s.cNsStealBase + (uint64_t)cNsStolen;
+    if (cNsStealNew <= pVCpu->tm.s.cNsSteal)
+        return false;
+    ASMAtomicUoWriteU64(&pVCpu->tm.s.cNsSteal, cNsStealNew);
+    return true;
+
+#else
+    RT_NOREF(pVCpu);
+    return false;
+#endif
+}
+
+
+/**
+ * Gets the time the calling EMT's virtual CPU actually spent running, i.e.
+ * the time it wasn't halted, suspended or had its time stolen by the host.
+ *
+ * @returns Run time in nanoseconds.
+ * @param   pVM         The cross context VM structure.
+ * @param   pVCpu       The cross context virtual CPU structure of the caller.
+ * @thread  EMT(pVCpu)
+ */
+VMMR3_INT_DECL(uint64_t) TMR3CpuGetRunTime(PVM pVM, PVMCPU pVCpu)
+{
+    VMCPU_ASSERT_EMT(pVCpu);
+    RT_NOREF(pVM);
+
+#ifndef VBOX_WITHOUT_NS_ACCOUNTING
+    uint64_t const cNsTotal    = pVCpu->tm.s.fSuspended
+                               ? pVCpu->tm.s.nsStartTotal : RTTimeNanoTS() - pVCpu->tm.s.nsStartTotal;
+    uint64_t const cNsRunnable = cNsTotal - pVCpu->tm.s.cNsHalted - pVCpu->tm.s.cNsHaltedRing0;
+    uint64_t const cNsSteal    = pVCpu->tm.s.cNsSteal;
+    return cNsRunnable > cNsSteal ? cNsRunnable - cNsSteal : 0;
+#else
+    RT_NOREF(pVCpu);
+    return 0;
+#endif
+}
+
 #ifndef VBOX_WITHOUT_NS_ACCOUNTING
 
 /**
@@ -3795,7 +3929,7 @@ static DECLCALLBACK(void) tmR3CpuLoadTimer(PVM pVM, TMTIMERHANDLE hTimer, void *
 static DECLCALLBACK(VBOXSTRICTRC) tmR3CpuTickParavirtEnable(PVM pVM, PVMCPU pVCpuEmt, void *pvData)
 {
     AssertPtr(pVM); Assert(pVM->tm.s.fTSCModeSwitchAllowed); NOREF(pVCpuEmt); NOREF(pvData);
-    Assert(pVM->tm.s.enmTSCMode != TMTSCMODE_NATIVE_API); /** @todo figure out NEM/win and paravirt */
+    Assert(pVM->tm.s.enmTSCMode != TMTSCMODE_NATIVE_API); /* Handled by the caller. */
     Assert(tmR3HasFixedTSC(pVM));
 
     if (pVM->tm.s.enmTSCMode != TMTSCMODE_REAL_TSC_OFFSET)
@@ -3845,7 +3979,15 @@ static DECLCALLBACK(VBOXSTRICTRC) tmR3CpuTickParavirtEnable(PVM pVM, PVMCPU pVCp
 VMMR3_INT_DECL(int) TMR3CpuTickParavirtEnable(PVM pVM)
 {
     int rc = VINF_SUCCESS;
-    if (pVM->tm.s.fTSCModeSwitchAllowed)
+    if (pVM->tm.s.enmTSCMode == TMTSCMODE_NATIVE_API)
+    {
+        /* The native API backends hand the guest the host TSC (plus an offset), which
+           is already what a paravirtualized TSC (e.g. the Hyper-V reference TSC page)
+           needs, so there is nothing to switch. */
+        if (!pVM->tm.s.fParavirtTscEnabled)
+            LogRel(("TM: Paravirtualized TSC enabled, keeping TSC mode '%s'\n", tmR3GetTSCModeName(pVM)));
+    }
+    else if (pVM->tm.s.fTSCModeSwitchAllowed)
         rc = VMMR3EmtRendezvous(pVM, VMMEMTRENDEZVOUS_FLAGS_TYPE_ONCE, tmR3CpuTickParavirtEnable, NULL);
     else
         LogRel(("TM: Host/VM is not suitable for using TSC mode '%s', request to change TSC mode ignored\n",
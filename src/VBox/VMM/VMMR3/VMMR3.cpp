@@ -248,6 +248,22 @@ VMMR3_INT_DECL(int) VMMR3Init(PVM pVM)
     int rc = CFGMR3QueryBoolDef(pCfgVMM, "UsePeriodicPreemptionTimers", &pVM->vmm.s.fUsePeriodicPreemptionTimers, true);
     AssertMsgRCReturn(rc, ("Configuration error. Failed to query \"VMM/UsePeriodicPreemptionTimers\", rc=%Rrc\n", rc), rc);
 
+    /** @cfgm{/VMM/HaltPollMaxNs, uint32_t, 0, 1000000, 0, ns}
+     * The upper bound of the adaptive halt poll window.  When non-zero, an EMT
+     * halting in ring-0 spins for up to this long waiting for a wake-up before
+     * blocking, with the actual window growing and shrinking according to how
+     * long recent halts lasted.  This trades host CPU time for lower wake-up
+     * latency, so it is disabled by default.
+     */
+    rc = CFGMR3QueryU32Def(pCfgVMM, "HaltPollMaxNs", &pVM->vmm.s.cNsHaltPollMax, 0);
+    AssertMsgRCReturn(rc, ("Configuration error. Failed to query \"VMM/HaltPollMaxNs\", rc=%Rrc\n", rc), rc);
+    if (pVM->vmm.s.cNsHaltPollMax > RT_NS_1MS)
+        return VMSetError(pVM, VERR_OUT_OF_RANGE, RT_SRC_POS,
+                          "Configuration error: VMM/HaltPollMaxNs=%u is out of range (max %u)",
+                          pVM->vmm.s.cNsHaltPollMax, RT_NS_1MS);
+    if (pVM->vmm.s.cNsHaltPollMax)
+        LogRel(("VMM: cNsHaltPollMax=%u\n", pVM->vmm.s.cNsHaltPollMax));
+
     /*
      * Initialize the VMM rendezvous semaphores.
      */
@@ -270,6 +270,7 @@ static void vmmR3FatalDumpInfoHlpDelete(PVMMR3FATALDUMPINFOHLP pHlp)
     if (pHlp->pRelLogger)
     {
         RTLogFlush(pHlp->pRelLogger);
+        RTLogAsyncOutputFlushAll(); /* Must hit the disk before we possibly go down. */
         RTLogChangeFlags(pHlp->pRelLogger,
                          pHlp->fRelLoggerFlags & RTLOGFLAGS_DISABLED,
                          pHlp->fRelLoggerFlags & RTLOGFLAGS_BUFFERED);
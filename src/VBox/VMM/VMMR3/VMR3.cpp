@@ -90,6 +90,7 @@
 #include <iprt/assert.h>
 #include <iprt/alloca.h>
 #include <iprt/asm.h>
+#include <iprt/cpuset.h>
 #include <iprt/env.h>
 #include <iprt/mem.h>
 #include <iprt/semaphore.h>
@@ -108,6 +109,7 @@
 static int                  vmR3CreateUVM(uint32_t cCpus, PCVMM2USERMETHODS pVmm2UserMethods, PUVM *ppUVM);
 static DECLCALLBACK(int)    vmR3CreateU(PUVM pUVM, uint32_t cCpus, PFNCFGMCONSTRUCTOR pfnCFGMConstructor, void *pvUserCFGM);
 static int                  vmR3ReadBaseConfig(PVM pVM, PUVM pUVM, uint32_t cCpus);
+static int                  vmR3ConfigureEmtAffinity(PVM pVM);
 static int                  vmR3InitRing3(PVM pVM, PUVM pUVM);
 static int                  vmR3InitRing0(PVM pVM);
 static int                  vmR3InitDoCompleted(PVM pVM, VMINITCOMPLETED enmWhat);
@@ -597,7 +599,9 @@ static DECLCALLBACK(int) vmR3CreateU(PUVM pUVM, uint32_t cCpus, PFNCFGMCONSTRUCT
      * Request GVMM to create a new VM for us.
      */
     RTR0PTR pVMR0;
+    uint64_t const nsStart = RTTimeNanoTS();
     int rc = GVMMR3CreateVM(pUVM, VMTARGET_DEFAULT, cCpus, pUVM->vm.s.pSession, &pUVM->pVM, &pVMR0);
+    uint64_t const nsCreated = RTTimeNanoTS();
     if (RT_SUCCESS(rc))
     {
         PVM pVM = pUVM->pVM;
@@ -643,6 +647,7 @@ static DECLCALLBACK(int) vmR3CreateU(PUVM pUVM, uint32_t cCpus, PFNCFGMCONSTRUCT
                  * Init the ring-3 components and ring-3 per cpu data, finishing it off
                  * by a relocation round (intermediate context finalization will do this).
                  */
+                uint64_t const nsConfigured = RTTimeNanoTS();
                 rc = vmR3InitRing3(pVM, pUVM);
                 if (RT_SUCCESS(rc))
                 {
@@ -651,9 +656,17 @@ static DECLCALLBACK(int) vmR3CreateU(PUVM pUVM, uint32_t cCpus, PFNCFGMCONSTRUCT
                     /*
                      * Init the Ring-0 components.
                      */
+                    uint64_t const nsRing3 = RTTimeNanoTS();
                     rc = vmR3InitRing0(pVM);
                     if (RT_SUCCESS(rc))
                     {
+                        /* Startup timeline, the per device/driver constructor times are under /PDM/Startup/. */
+                        uint64_t const nsRing0 = RTTimeNanoTS();
+                        LogRel(("VM: Created in %RU64 ms: GVMM %RU64 ms, config %RU64 ms, ring-3 init %RU64 ms, ring-0 init %RU64 ms\n",
+                                (nsRing0 - nsStart) / RT_NS_1MS, (nsCreated - nsStart) / RT_NS_1MS,
+                                (nsConfigured - nsCreated) / RT_NS_1MS, (nsRing3 - nsConfigured) / RT_NS_1MS,
+                                (nsRing0 - nsRing3) / RT_NS_1MS));
+
                         /* Relocate again, because some switcher fixups depends on R0 init results. */
                         VMR3Relocate(pVM, 0 /* offDelta */);
 
@@ -790,6 +803,121 @@ static int vmR3ReadBaseConfig(PVM pVM, PUVM pUVM, uint32_t cCpus)
     rc = CFGMR3QueryBoolDef(pRoot, "PowerOffInsteadOfReset", &pVM->vm.s.fPowerOffInsteadOfReset, false);
     AssertLogRelMsgRCReturn(rc, ("Configuration error: Querying \"PowerOffInsteadOfReset\" failed, rc=%Rrc\n", rc), rc);
 
+    /*
+     * Pin the EMTs to host CPUs if so configured.  This is done before any
+     * guest RAM is allocated so that the host's first-touch policy places the
+     * memory on the NUMA node(s) the EMTs are bound to.
+     */
+    return vmR3ConfigureEmtAffinity(pVM);
+}
+
+
+/**
+ * Parses a host CPU list like "0-7,16-23" into a CPU set.
+ *
+ * Used for the EMT affinity here and for the PDM I/O thread groups.
+ *
+ * @returns VBox status code.
+ * @param   pszList     The CPU list.  Host CPUs are given by set index.
+ * @param   pCpuSet     Where to return the CPU set.
+ */
+VMMR3_INT_DECL(int) VMR3ParseCpuList(const char *pszList, PRTCPUSET pCpuSet)
+{
+    RTCpuSetEmpty(pCpuSet);
+    const char *psz = RTStrStripL(pszList);
+    while (*psz)
+    {
+        uint32_t iFirst;
+        int rc = RTStrToUInt32Ex(psz, (char **)&psz, 10, &iFirst);
+        if (rc != VINF_SUCCESS && rc != VWRN_TRAILING_CHARS && rc != VWRN_TRAILING_SPACES)
+            return VERR_INVALID_PARAMETER;
+        uint32_t iLast = iFirst;
+        psz = RTStrStripL(psz);
+        if (*psz == '-')
+        {
+            rc = RTStrToUInt32Ex(RTStrStripL(psz + 1), (char **)&psz, 10, &iLast);
+            if (rc != VINF_SUCCESS && rc != VWRN_TRAILING_CHARS && rc != VWRN_TRAILING_SPACES)
+                return VERR_INVALID_PARAMETER;
+            psz = RTStrStripL(psz);
+        }
+        if (iFirst > iLast || iLast >= RTCPUSET_MAX_CPUS)
+            return VERR_OUT_OF_RANGE;
+        for (uint32_t iCpu = iFirst; iCpu <= iLast; iCpu++)
+            RTCpuSetAddByIndex(pCpuSet, (int)iCpu);
+
+        if (*psz == ',')
+            psz = RTStrStripL(psz + 1);
+        else if (*psz)
+            return VERR_INVALID_PARAMETER;
+    }
+    return RTCpuSetCount(pCpuSet) > 0 ? VINF_SUCCESS : VERR_INVALID_PARAMETER;
+}
+
+
+/**
+ * EMT worker for vmR3ConfigureEmtAffinity.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ * @param   pCpuSet     The host CPUs the calling EMT should run on.
+ */
+static DECLCALLBACK(int) vmR3SetEmtAffinity(PVM pVM, PCRTCPUSET pCpuSet)
+{
+    int rc = RTThreadSetAffinity(pCpuSet);
+    if (RT_FAILURE(rc))
+        LogRel(("VM: Failed to set the affinity of EMT #%u: %Rrc\n", VMMGetCpuId(pVM), rc));
+    return rc;
+}
+
+
+/**
+ * Binds the EMTs to the host CPUs given in the configuration.
+ *
+ * @returns VBox status code.
+ * @param   pVM         The cross context VM structure.
+ */
+static int vmR3ConfigureEmtAffinity(PVM pVM)
+{
+    /** @cfgm{/EmtAffinity/, node}
+     * Host CPU affinity for the EMTs.  Each value is a list of host CPU set
+     * indexes and ranges, e.g. "0-7,16-23".  This is typically used to keep a
+     * VM's vCPUs (and thereby its memory) on one host NUMA node.
+     *
+     * @cfgm{/EmtAffinity/Default, string, none}
+     * The host CPUs for all EMTs that have no specific entry.
+     *
+     * @cfgm{/EmtAffinity/vCpuN, string, /EmtAffinity/Default}
+     * The host CPUs for the EMT of virtual CPU N. */
+    PCFGMNODE const pCfg = CFGMR3GetChild(CFGMR3GetRoot(pVM), "EmtAffinity");
+    if (!pCfg)
+        return VINF_SUCCESS;
+
+    char szDefault[256];
+    int rc = CFGMR3QueryStringDef(pCfg, "Default", szDefault, sizeof(szDefault), "");
+    AssertLogRelMsgRCReturn(rc, ("Configuration error: Querying \"EmtAffinity/Default\" failed, rc=%Rrc\n", rc), rc);
+
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+    {
+        char szName[32];
+        RTStrPrintf(szName, sizeof(szName), "vCpu%u", idCpu);
+        char szList[256];
+        rc = CFGMR3QueryStringDef(pCfg, szName, szList, sizeof(szList), szDefault);
+        AssertLogRelMsgRCReturn(rc, ("Configuration error: Querying \"EmtAffinity/%s\" failed, rc=%Rrc\n", szName, rc), rc);
+        if (!szList[0])
+            continue;
+
+        RTCPUSET CpuSet;
+        rc = VMR3ParseCpuList(szList, &CpuSet);
+        if (RT_FAILURE(rc))
+            return VMSetError(pVM, rc, RT_SRC_POS,
+                              N_("Configuration error: Invalid host CPU list \"%s\" for EmtAffinity/%s"), szList, szName);
+
+        rc = VMR3ReqCallWait(pVM, idCpu, (PFNRT)vmR3SetEmtAffinity, 2, pVM, &CpuSet);
+        if (RT_FAILURE(rc))
+            return VMSetError(pVM, rc, RT_SRC_POS,
+                              N_("Failed to bind the EMT of vCPU %u to host CPUs \"%s\""), idCpu, szList);
+        LogRel(("VM: EMT #%u affinity: %s\n", idCpu, szList));
+    }
     return VINF_SUCCESS;
 }
 
@@ -931,6 +1059,7 @@ static int vmR3InitRing3(PVM pVM, PUVM pUVM)
                                                                             return VINF_SUCCESS;
                                                                         }
 
+                                                                        STAMR3Term(pVM);
                                                                         int rc2 = PDMR3Term(pVM);
                                                                         AssertRC(rc2);
                                                                     }
@@ -1055,6 +1184,11 @@ static int vmR3InitDoCompleted(PVM pVM, VMINITCOMPLETED enmWhat)
        handlers in their init completion method. */
     if (RT_SUCCESS(rc))
         rc = IOMR3InitCompleted(pVM, enmWhat);
+
+    /* STAM goes last so the shared memory export (if any) picks up all the
+       samples registered during init. */
+    if (RT_SUCCESS(rc) && enmWhat == VMINITCOMPLETED_RING3)
+        rc = STAMR3InitCompleted(pVM);
     return rc;
 }
 
@@ -2217,6 +2351,7 @@ DECLCALLBACK(int) vmR3Destroy(PVM pVM)
         /*
          * Destroy the VM components.
          */
+        STAMR3Term(pVM);
         int rc = TMR3Term(pVM);
         AssertRC(rc);
 #ifdef VBOX_WITH_DEBUGGER
@@ -2520,6 +2655,9 @@ static DECLCALLBACK(VBOXSTRICTRC) vmR3SoftReset(PVM pVM, PVMCPU pVCpu, void *pvU
     /* Reset the VCpu state. */
     VMCPU_ASSERT_STATE(pVCpu, VMCPUSTATE_STARTED);
 
+    /* A hot-unplugged CPU isn't parked across a reset, see vmR3HotUnplugCpu. */
+    ASMAtomicWriteBool(&pVCpu->pUVCpu->vm.s.fParked, false);
+
     /*
      * Soft reset the VM components.
      */
@@ -2611,6 +2749,9 @@ static DECLCALLBACK(VBOXSTRICTRC) vmR3HardReset(PVM pVM, PVMCPU pVCpu, void *pvU
     /* Reset the VCpu state. */
     VMCPU_ASSERT_STATE(pVCpu, VMCPUSTATE_STARTED);
 
+    /* A hot-unplugged CPU isn't parked across a reset, see vmR3HotUnplugCpu. */
+    ASMAtomicWriteBool(&pVCpu->pUVCpu->vm.s.fParked, false);
+
     /* Clear all pending forced actions. */
     VMCPU_FF_CLEAR_MASK(pVCpu, VMCPU_FF_ALL_MASK & ~VMCPU_FF_REQUEST);
 
@@ -4392,6 +4533,12 @@ static DECLCALLBACK(int) vmR3HotUnplugCpu(PVM pVM, VMCPUID idCpu)
     EMR3ResetCpu(pVCpu);
     HMR3ResetCpu(pVCpu);
     NEMR3ResetCpu(pVCpu, false /*fInitIpi*/);
+
+    /*
+     * Park the EMT until the CPU is plugged in again, see VMR3WaitParked.
+     */
+    TMR3CpuHotUnplug(pVM, pVCpu);
+    ASMAtomicWriteBool(&pVCpu->pUVCpu->vm.s.fParked, true);
     return VINF_EM_WAIT_SIPI;
 }
 
@@ -4418,6 +4565,25 @@ VMMR3DECL(int) VMR3HotUnplugCpu(PUVM pUVM, VMCPUID idCpu)
 }
 
 
+/**
+ * Worker for VMR3HotPlugCpu.
+ *
+ * @returns VINF_SUCCESS.
+ * @param   pVM                 The cross context VM structure.
+ * @param   idCpu               The current CPU.
+ */
+static DECLCALLBACK(int) vmR3HotPlugCpu(PVM pVM, VMCPUID idCpu)
+{
+    PVMCPU pVCpu = VMMGetCpuById(pVM, idCpu);
+    VMCPU_ASSERT_EMT(pVCpu);
+
+    /* Unpark the EMT, it goes back to waiting on SIPI the normal way. */
+    Log(("vmR3HotPlugCpu for VCPU %u\n", idCpu));
+    ASMAtomicWriteBool(&pVCpu->pUVCpu->vm.s.fParked, false);
+    return VINF_SUCCESS;
+}
+
+
 /**
  * Hot-plugs a CPU on the guest.
  *
@@ -4432,8 +4598,9 @@ VMMR3DECL(int) VMR3HotPlugCpu(PUVM pUVM, VMCPUID idCpu)
     VM_ASSERT_VALID_EXT_RETURN(pVM, VERR_INVALID_VM_HANDLE);
     AssertReturn(idCpu < pVM->cCpus, VERR_INVALID_CPU_ID);
 
-    /** @todo r-bird: Just mark it online and make sure it waits on SPIP. */
-    return VINF_SUCCESS;
+    /* Always queued so it's ordered after any pending unplug request; the
+       request itself is what wakes up a parked EMT. */
+    return VMR3ReqCallNoWaitU(pUVM, idCpu, (PFNRT)vmR3HotPlugCpu, 2, pVM, idCpu);
 }
 
 
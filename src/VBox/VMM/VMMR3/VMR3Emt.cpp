@@ -33,6 +33,7 @@
 #include <VBox/vmm/tm.h>
 #include <VBox/vmm/dbgf.h>
 #include <VBox/vmm/em.h>
+#include <VBox/vmm/gim.h>
 #include <VBox/vmm/gvmm.h>
 #include <VBox/vmm/nem.h>
 #include <VBox/vmm/pdmapi.h>
@@ -1214,6 +1215,12 @@ VMMR3_INT_DECL(int) VMR3WaitHalted(PVM pVM, PVMCPU pVCpu, uint32_t fFlags)
         return VINF_SUCCESS;
     }
 
+    /*
+     * Account for any steal time before we stop being runnable.
+     */
+    if (TMR3CpuUpdateStealTime(pVM, pVCpu))
+        GIMR3UpdateStealTime(pVM, pVCpu);
+
     /*
      * The yielder is suspended while we're halting, while TM might have clock(s) running
      * only at certain times and need to be notified..
@@ -1309,6 +1316,59 @@ VMMR3_INT_DECL(int) VMR3WaitU(PUVMCPU pUVCpu)
 }
 
 
+/**
+ * Checks whether the given virtual CPU is hot-unplugged and its EMT should be
+ * parked using VMR3WaitParked.
+ *
+ * @returns true if parked, false if not.
+ * @param   pVCpu               The cross context virtual CPU structure.
+ */
+VMMR3_INT_DECL(bool) VMR3IsCpuParked(PVMCPU pVCpu)
+{
+    return ASMAtomicUoReadBool(&pVCpu->pUVCpu->vm.s.fParked);
+}
+
+
+/**
+ * Parks the EMT of a hot-unplugged virtual CPU.
+ *
+ * Unlike VMR3WaitHalted this doesn't run timers, doesn't spin and doesn't wake
+ * up for timer deadlines, so the parked EMT costs next to nothing on the host.
+ * The CPU can only leave the EMSTATE_WAIT_SIPI state via a request (startup
+ * and init IPIs are delivered that way, as is VMR3HotPlugCpu), so that's all
+ * we wait for besides VM state changes.
+ *
+ * @returns VINF_SUCCESS unless a fatal error occurred.
+ * @param   pVM                 The cross context VM structure.
+ * @param   pVCpu               The cross context virtual CPU structure of the
+ *                              calling EMT.
+ * @thread  The emulation thread.
+ */
+VMMR3_INT_DECL(int) VMR3WaitParked(PVM pVM, PVMCPU pVCpu)
+{
+    LogFlow(("VMR3WaitParked: idCpu=%u\n", pVCpu->idCpu));
+    VMCPU_ASSERT_EMT(pVCpu);
+
+    if (    VM_FF_IS_ANY_SET(pVM, VM_FF_EXTERNAL_SUSPENDED_MASK)
+        ||  VMCPU_FF_IS_ANY_SET(pVCpu, VMCPU_FF_EXTERNAL_SUSPENDED_MASK))
+        return VINF_SUCCESS;
+
+    /* Keep TM's CPU load accounting showing the parked CPU as halted. */
+    TMNotifyStartOfHalt(pVCpu);
+    VMCPUSTATE enmStateOld = VMCPU_GET_STATE(pVCpu);
+    VMCPU_SET_STATE(pVCpu, VMCPUSTATE_STARTED_HALTED);
+
+    PUVMCPU pUVCpu = pVCpu->pUVCpu;
+    int rc = g_aHaltMethods[pUVCpu->pUVM->vm.s.iHaltMethod].pfnWait(pUVCpu);
+
+    VMCPU_SET_STATE(pVCpu, enmStateOld);
+    TMNotifyEndOfHalt(pVCpu);
+
+    LogFlow(("VMR3WaitParked: returns %Rrc (FF %#x)\n", rc, pVM->fGlobalForcedActions));
+    return rc;
+}
+
+
 /**
  * Interface that PDMR3Suspend, PDMR3PowerOff and PDMR3Reset uses when they wait
  * for the handling of asynchronous notifications to complete.
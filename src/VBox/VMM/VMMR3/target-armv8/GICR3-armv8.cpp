@@ -1239,7 +1239,10 @@ DECLCALLBACK(int) gicR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGMNODE pC
     GIC_REG_COUNTER(&pGitsDev->StatLpiCacheHit,     "ITS/Cache/Hit",        "Number of LPI cache hits.");
     GIC_REG_COUNTER(&pGitsDev->StatLpiCacheMiss,    "ITS/Cache/Miss",       "Number of LPI cache misses.");
     GIC_REG_COUNTER(&pGitsDev->StatLpiCacheAdd,     "ITS/Cache/Add",        "Number of LPI cache additions.");
+    GIC_REG_COUNTER(&pGitsDev->StatLpiCacheEvict,   "ITS/Cache/Evict",      "Number of LPI cache entries evicted to make room.");
     GIC_REG_COUNTER(&pGitsDev->StatLpiCacheInvOne,  "ITS/Cache/InvOne",     "Number of LPI cache invalidations for one entry.");
+    GIC_REG_COUNTER(&pGitsDev->StatLpiCacheInvDev,  "ITS/Cache/InvDev",     "Number of LPI cache invalidations for a device.");
+    GIC_REG_COUNTER(&pGitsDev->StatLpiCacheInvCollection, "ITS/Cache/InvCollection", "Number of LPI cache invalidations for an interrupt collection.");
     GIC_REG_COUNTER(&pGitsDev->StatLpiCacheInvAll,  "ITS/Cache/InvAll",     "Number of LPI cache invalidations for all entries.");
 
 # undef GIC_REG_COUNTER
@@ -846,6 +846,7 @@ static int apicR3InitState(PVM pVM)
                 uint32_t const offApicPib  = idCpu * sizeof(APICPIB);
                 pApicCpu->pvApicPibR0      = !fDriverless ? (RTR0PTR)((RTR0UINTPTR)pApic->pvApicPibR0 + offApicPib) : NIL_RTR0PTR;
                 pApicCpu->pvApicPibR3      = (RTR3PTR)((RTR3UINTPTR)pApic->pvApicPibR3 + offApicPib);
+                pApicCpu->HCPhysApicPib    = !fDriverless ? pApic->HCPhysApicPib + offApicPib : NIL_RTHCPHYS;
 
                 /* Initialize the virtual-APIC state. */
                 RT_BZERO(pApicCpu->pvApicPageR3, pApicCpu->cbApicPage);
@@ -1087,6 +1088,8 @@ DECLCALLBACK(int) apicR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGMNODE p
 
         APIC_REG_COUNTER(&pApicCpu->StatPostIntrAlreadyPending,
                                                        "%u/PostInterruptAlreadyPending", "Number of times an interrupt is already pending.");
+        APIC_REG_COUNTER(&pApicCpu->StatPostIntrNotify,
+                                                       "%u/PostInterruptNotify", "Number of posted-interrupt notification IPIs sent.");
         APIC_REG_COUNTER(&pApicCpu->StatTimerCallback, "%u/TimerCallback",  "Number of times the timer callback is invoked.");
 
         APIC_REG_COUNTER(&pApicCpu->StatTprWrite,      "%u/TprWrite",       "Number of TPR writes.");
@@ -277,6 +277,7 @@ VMMR3_INT_DECL(int) HMR3Init(PVM pVM)
                               "|VmxPleWindow"
                               "|VmxLbr"
                               "|UseVmxPreemptTimer"
+                              "|UsePostedInterrupts"
                               "|SvmPauseFilter"
                               "|SvmPauseFilterThreshold"
                               "|SvmVirtVmsaveVmload"
@@ -284,6 +285,7 @@ VMMR3_INT_DECL(int) HMR3Init(PVM pVM)
                               "|LovelyMesaDrvWorkaround"
                               "|MissingOS2TlbFlushWorkaround"
                               "|AlwaysInterceptVmxMovDRx"
+                              "|ExitHistograms"
                               , "" /* pszValidNodes */, "HM" /* pszWho */, 0 /* uInstance */);
     if (RT_FAILURE(rc))
         return rc;
@@ -462,6 +464,14 @@ VMMR3_INT_DECL(int) HMR3Init(PVM pVM)
     rc = CFGMR3QueryBoolDef(pCfgHm, "UseVmxPreemptTimer", &pVM->hm.s.vmx.fUsePreemptTimerCfg, true);
     AssertLogRelRCReturn(rc, rc);
 
+    /** @cfgm{/HM/UsePostedInterrupts, bool, false}
+     * Whether to use VT-x posted-interrupt processing together with
+     * virtual-interrupt delivery if the CPU and the host OS support it (Linux
+     * hosts only).  Edge-triggered interrupts from other threads are then
+     * delivered without forcing the target EMT out of the guest. */
+    rc = CFGMR3QueryBoolDef(pCfgHm, "UsePostedInterrupts", &pVM->hm.s.vmx.fPostedIntrsCfg, false);
+    AssertLogRelRCReturn(rc, rc);
+
     /** @cfgm{/HM/IBPBOnVMExit, bool}
      * Costly paranoia setting. */
     rc = CFGMR3QueryBoolDef(pCfgHm, "IBPBOnVMExit", &pVM->hm.s.fIbpbOnVmExit, false);
@@ -546,6 +556,22 @@ VMMR3_INT_DECL(int) HMR3Init(PVM pVM)
     rc = CFGMR3QueryS8Def(pCfgHm, "AlwaysInterceptVmxMovDRx", &pVM->hm.s.vmx.fAlwaysInterceptMovDRxCfg, 0);
     AssertLogRelRCReturn(rc, rc);
 
+#ifdef VBOX_WITH_STATISTICS
+    /** @cfgm{/HM/ExitHistograms, bool, false}
+     * Whether to sample per exit reason latency histograms, split into ring-0
+     * handling time and the time ring-3 spends completing the exit.  Costs a
+     * couple of TSC reads per exit, so it is off by default. */
+    bool fExitHistograms;
+    rc = CFGMR3QueryBoolDef(pCfgHm, "ExitHistograms", &fExitHistograms, false);
+    AssertLogRelRCReturn(rc, rc);
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+    {
+        PVMCPU pVCpu = pVM->apCpusR3[idCpu];
+        pVCpu->hm.s.fExitHistograms = fExitHistograms;
+        pVCpu->hm.s.idxExitHistLast = UINT32_MAX;
+    }
+#endif
+
     /*
      * Check if VT-x or AMD-v support according to the users wishes.
      *
@@ -1022,6 +1048,33 @@ static int hmR3InitFinalizeR3(PVM pVM)
         }
         HM_REG_COUNTER(&pHmCpu->StatExitReasonNpf, "/HM/CPU%u/Exit/Reason/#NPF", "Nested page faults");
 
+        /*
+         * Exit latency histograms (opt-in).
+         */
+        if (pHmCpu->fExitHistograms)
+        {
+            for (unsigned j = 0; j < MAX_EXITREASON_STAT; j++)
+            {
+                const char *pszExitName = fCpuSupportsVmx ? HMGetVmxExitName(j) : HMGetSvmExitName(j);
+                if (pszExitName)
+                {
+                    rc = STAMR3RegisterF(pVM, &pHmCpu->aStatExitHistR0[j], STAMTYPE_HISTOGRAM, STAMVISIBILITY_USED,
+                                         STAMUNIT_TICKS_PER_CALL, pszExitName, "/HM/CPU%u/Exit/Latency/R0/%02x", idCpu, j);
+                    AssertRC(rc);
+                    rc = STAMR3RegisterF(pVM, &pHmCpu->aStatExitHistR3[j], STAMTYPE_HISTOGRAM, STAMVISIBILITY_USED,
+                                         STAMUNIT_TICKS_PER_CALL, pszExitName, "/HM/CPU%u/Exit/Latency/R3/%02x", idCpu, j);
+                    AssertRC(rc);
+                }
+            }
+            if (!fCpuSupportsVmx)
+            {
+                HM_REG_STAT(&pHmCpu->aStatExitHistR0[HM_EXIT_HIST_IDX_NPF], STAMTYPE_HISTOGRAM, STAMVISIBILITY_USED,
+                            STAMUNIT_TICKS_PER_CALL, "/HM/CPU%u/Exit/Latency/R0/#NPF", "Nested page faults");
+                HM_REG_STAT(&pHmCpu->aStatExitHistR3[HM_EXIT_HIST_IDX_NPF], STAMTYPE_HISTOGRAM, STAMVISIBILITY_USED,
+                            STAMUNIT_TICKS_PER_CALL, "/HM/CPU%u/Exit/Latency/R3/#NPF", "Nested page faults");
+            }
+        }
+
 #if defined(VBOX_WITH_NESTED_HWVIRT_SVM) || defined(VBOX_WITH_NESTED_HWVIRT_VMX)
         /*
          * Nested-guest VM-exit reason stats.
@@ -1983,13 +2036,6 @@ static int hmR3InitFinalizeR0Amd(PVM pVM)
                        || (pVM->hm.s.ForR3.svm.fFeatures & X86_CPUID_SVM_FEATURE_EDX_NESTED_PAGING),
                        VERR_HM_IPE_1);
 
-#if 0
-    /** @todo Add and query IPRT API for host OS support for posted-interrupt IPI
-     *        here. */
-    if (RTR0IsPostIpiSupport())
-        pVM->hm.s.fPostedIntrs = true;
-#endif
-
     /*
      * Determine whether we need to intercept #UD in SVM mode for emulating
      * intel SYSENTER/SYSEXIT on AMD64, as these instructions results in #UD
@@ -2825,6 +2871,30 @@ VMMR3_INT_DECL(void) HMR3NotifyDebugEventChangedPerCpu(PVM pVM, PVMCPU pVCpu)
 }
 
 
+/**
+ * Notification from EM that it is done with the status code ring-0 returned.
+ *
+ * This charges the ring-3 time to the exit latency histogram of the VM-exit
+ * that caused the return to ring-3, if any and if enabled.
+ *
+ * @param   pVCpu       The cross context virtual CPU structure.
+ * @param   uTscStart   The TSC value when VMMR3HmRunGC returned.
+ */
+VMMR3_INT_DECL(void) HMR3NoteExitCompletedInR3(PVMCPU pVCpu, uint64_t uTscStart)
+{
+#if defined(VBOX_WITH_STATISTICS) && (defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86))
+    uint32_t const idxExit = pVCpu->hm.s.idxExitHistLast;
+    if (idxExit < RT_ELEMENTS(pVCpu->hm.s.aStatExitHistR3))
+    {
+        pVCpu->hm.s.idxExitHistLast = UINT32_MAX;
+        STAM_HISTOGRAM_ADD_PERIOD(&pVCpu->hm.s.aStatExitHistR3[idxExit], ASMReadTSC() - uTscStart);
+    }
+#else
+    RT_NOREF(pVCpu, uTscStart);
+#endif
+}
+
+
 #if 0 /* evil */
 /**
  * Checks if we are currently using hardware acceleration.
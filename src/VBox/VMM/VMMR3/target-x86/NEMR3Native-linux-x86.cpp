@@ -41,8 +41,11 @@
 #include <VBox/vmm/vmcc.h>
 
 #include <iprt/alloca.h>
+#include <iprt/critsect.h>
+#include <iprt/mem.h>
 #include <iprt/string.h>
 #include <iprt/system.h>
+#include <iprt/thread.h>
 #include <iprt/x86.h>
 
 #include <errno.h>
@@ -50,6 +53,8 @@
 #include <sys/ioctl.h>
 #include <sys/fcntl.h>
 #include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
 #include <linux/kvm.h>
 
 
@@ -1713,7 +1718,8 @@ VMMR3_INT_DECL(VBOXSTRICTRC) NEMR3RunGC(PVM pVM, PVMCPU pVCpu)
                 int rcLnx = ioctl(pVCpu->nem.s.fdVCpu, KVM_RUN, 0UL);
 
                 VMCPU_CMPXCHG_STATE(pVCpu, VMCPUSTATE_STARTED_EXEC_NEM, VMCPUSTATE_STARTED_EXEC_NEM_WAIT);
-                TMNotifyEndOfExecution(pVM, pVCpu, ASMReadTSC());
+                uint64_t const uTscExit = ASMReadTSC();
+                TMNotifyEndOfExecution(pVM, pVCpu, uTscExit);
 
 #ifdef LOG_ENABLED
                 if (LogIsFlowEnabled())
@@ -1730,9 +1736,16 @@ VMMR3_INT_DECL(VBOXSTRICTRC) NEMR3RunGC(PVM pVM, PVMCPU pVCpu)
                 if (RT_LIKELY(rcLnx == 0 || errno == EINTR))
                 {
                     /*
-                     * Deal with the exit.
+                     * Replay any buffered writes first, then deal with the exit.
                      */
+                    nemR3LnxCoalescedMmioDrain(pVM);
+                    uint32_t const uExitReason = pRun->exit_reason;
                     rcStrict = nemHCLnxHandleExit(pVM, pVCpu, pRun, &fStatefulExit);
+                    if (!pVCpu->nem.s.paStatExitHist)
+                    { /* likely */ }
+                    else
+                        STAM_REL_HISTOGRAM_ADD_PERIOD(&pVCpu->nem.s.paStatExitHist[RT_MIN(uExitReason, NEM_LNX_EXIT_HIST_COUNT - 1)],
+                                                      ASMReadTSC() - uTscExit);
                     if (rcStrict == VINF_SUCCESS)
                     { /* hopefully likely */ }
                     else
@@ -1814,6 +1827,7 @@ VMMR3_INT_DECL(VBOXSTRICTRC) NEMR3RunGC(PVM pVM, PVMCPU pVCpu)
             AssertLogRelMsgBreakStmt(rcLnx == 0 && pRun->exit_reason == uOrgExit,
                                      ("rcLnx=%d errno=%d exit_reason=%d uOrgExit=%d\n", rcLnx, errno, pRun->exit_reason, uOrgExit),
                                      rcStrict = VERR_NEM_IPE_6);
+            nemR3LnxCoalescedMmioDrain(pVM);
             VBOXSTRICTRC rcStrict2 = nemHCLnxHandleExit(pVM, pVCpu, pRun, &fStatefulExit);
             if (rcStrict2 == VINF_SUCCESS || rcStrict2 == rcStrict)
             { /* likely */ }
@@ -1833,6 +1847,9 @@ VMMR3_INT_DECL(VBOXSTRICTRC) NEMR3RunGC(PVM pVM, PVMCPU pVCpu)
         pRun->immediate_exit = 0;
     }
 
+    /* Make sure EM and other EMTs see the device state as the guest left it. */
+    nemR3LnxCoalescedMmioDrain(pVM);
+
     /*
      * If the CPU is running, make sure to stop it before we try sync back the
      * state and return to EM.  We don't sync back the whole state if we can help it.
@@ -142,6 +142,7 @@ typedef PGMPOOLCHECKERSTATE *PPGMPOOLCHECKERSTATE;
 *********************************************************************************************************************************/
 static FNDBGFHANDLERINT pgmR3PoolInfoPages;
 static FNDBGFHANDLERINT pgmR3PoolInfoRoots;
+static const char *pgmPoolPoolKindToStr(uint8_t enmKind);
 
 #ifdef VBOX_WITH_DEBUGGER
 static FNDBGCCMD pgmR3PoolCmdCheck;
@@ -465,6 +466,11 @@ int pgmR3PoolInit(PVM pVM)
     STAM_REG(pVM, &pPool->StatCacheFreeUpOne,           STAMTYPE_COUNTER,   "/PGM/Pool/Cache/FreeUpOne",            STAMUNIT_OCCURENCES, "The number of times the cache was asked to free up a page.");
     STAM_REG(pVM, &pPool->StatCacheCacheable,           STAMTYPE_COUNTER,   "/PGM/Pool/Cache/Cacheable",            STAMUNIT_OCCURENCES, "The number of cacheable allocations.");
     STAM_REG(pVM, &pPool->StatCacheUncacheable,         STAMTYPE_COUNTER,   "/PGM/Pool/Cache/Uncacheable",          STAMUNIT_OCCURENCES, "The number of uncacheable allocations.");
+    STAM_REG(pVM, &pPool->StatCacheFreeUpOneLeaf,       STAMTYPE_COUNTER,   "/PGM/Pool/Cache/FreeUpOneLeaf",        STAMUNIT_OCCURENCES, "The number of times a leaf page table was evicted in favour of a non-leaf age list tail.");
+    STAM_REG(pVM, &pPool->StatCacheFreeUpOneNonLeaf,    STAMTYPE_COUNTER,   "/PGM/Pool/Cache/FreeUpOneNonLeaf",     STAMUNIT_OCCURENCES, "The number of times a non-leaf table had to be evicted.");
+    for (unsigned enmKind = PGMPOOLKIND_FREE + 1; enmKind <= PGMPOOLKIND_LAST; enmKind++)
+        STAMR3RegisterF(pVM, &pPool->acPagesPerKind[enmKind], STAMTYPE_U16, STAMVISIBILITY_USED, STAMUNIT_PAGES,
+                        "The number of pages in use of this kind.", "/PGM/Pool/Kinds/%s", pgmPoolPoolKindToStr(enmKind));
 #endif /* VBOX_WITH_STATISTICS */
 
     DBGFR3InfoRegisterInternalEx(pVM, "pgmpoolpages", "Lists page pool pages.", pgmR3PoolInfoPages, 0);
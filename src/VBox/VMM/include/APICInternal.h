@@ -328,6 +328,9 @@ typedef struct APICCPU
     /** Number of times an interrupt is already pending in
      *  apicPostInterrupts().*/
     STAMCOUNTER                 StatPostIntrAlreadyPending;
+    /** Number of posted-interrupt notification IPIs sent by
+     *  apicPostInterrupt(). */
+    STAMCOUNTER                 StatPostIntrNotify;
     /** Number of times the timer callback is invoked. */
     STAMCOUNTER                 StatTimerCallback;
     /** Number of times the TPR is written. */
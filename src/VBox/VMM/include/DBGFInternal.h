@@ -57,7 +57,7 @@
 /** The maximum tracers instance (total) size, ring-3 only tracers. */
 #define DBGF_MAX_TRACER_INSTANCE_SIZE_R3 _1G
 /** Event ringbuffer header size. */
-#define DBGF_TRACER_EVT_HDR_SZ           (32)
+#define DBGF_TRACER_EVT_HDR_SZ           (48)
 /** Event ringbuffer payload size. */
 #define DBGF_TRACER_EVT_PAYLOAD_SZ       (32)
 /** Event ringbuffer entry size. */
@@ -452,6 +452,13 @@ typedef struct DBGFTRACEREVTHDR
     DBGFTRACEREVT                           enmEvt;
     /** Flags for this event. */
     uint32_t                                fFlags;
+    /** RTTimeNanoTS() when the event was posted. */
+    uint64_t                                u64TsNano;
+    /** The ID of the virtual CPU posting the event, NIL_VMCPUID if not posted
+     * by an EMT. */
+    VMCPUID                                 idCpu;
+    /** Padding. */
+    uint32_t                                u32Pad0;
 } DBGFTRACEREVTHDR;
 /** Pointer to a trace event header. */
 typedef DBGFTRACEREVTHDR *PDBGFTRACEREVTHDR;
@@ -554,6 +561,13 @@ typedef struct DBGFTRACERINSR3
     uint64_t                                idEvtLast;
     /** The trace log writer handle. */
     RTTRACELOGWR                            hTraceLog;
+    /** The CTF stream file when writing a CTF trace, NIL_RTFILE when using the
+     * trace log writer. */
+    RTFILE                                  hFileCtf;
+    /** The CTF stream write buffer. */
+    R3PTRTYPE(uint8_t *)                    pbCtfBuf;
+    /** Number of bytes used in the CTF stream write buffer. */
+    size_t                                  offCtfBuf;
     /** Guest memory data aggregation structures to track
      * currently pending guest memory reads/writes. */
     DBGFTRACERGCPHYSRWAGG                   aGstMemRwData[10];
@@ -121,6 +121,15 @@ int emR3NemHandleRC(PVM pVM, PVMCPU pVCpu, int rc)
         case VINF_EM_PENDING_R3_IOPORT_READ:
             rc = VBOXSTRICTRC_TODO(emR3ExecutePendingIoPortRead(pVM, pVCpu));
             break;
+# ifdef EMHANDLERC_WITH_HM
+
+        /*
+         * Finish a virtualized ICR write that needs ring-3 (INIT / SIPI).
+         */
+        case VINF_EM_PENDING_R3_APIC_ICR_WRITE:
+            rc = VBOXSTRICTRC_TODO(PDMApicSetIcrLoVirtualized(pVCpu));
+            break;
+# endif
 #endif
 
         /*
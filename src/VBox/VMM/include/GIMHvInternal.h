@@ -163,8 +163,12 @@
 #define GIM_HV_MISC_FEAT_SINT_POLLING_MODE                  RT_BIT(17)
 /** Hypercall MSR lock available. */
 #define GIM_HV_MISC_FEAT_HYPERCALL_MSR_LOCK                 RT_BIT(18)
-/** Use direct synthetic MSRs. */
+/** Use direct synthetic MSRs.
+ * @note The Hyper-V TLFS calls this "direct synthetic timers", see
+ *       GIM_HV_MISC_FEAT_STIMER_DIRECT_MODE. */
 #define GIM_HV_MISC_FEAT_USE_DIRECT_SYNTH_MSRS              RT_BIT(19)
+/** Synthetic timers in direct mode (interrupt via APIC vector) available. */
+#define GIM_HV_MISC_FEAT_STIMER_DIRECT_MODE                 GIM_HV_MISC_FEAT_USE_DIRECT_SYNTH_MSRS
 /** @}  */
 
 /** @name Hyper-V implementation recommendations.
@@ -552,6 +556,14 @@ AssertCompile(MSR_GIM_HV_RANGE11_FIRST <= MSR_GIM_HV_RANGE11_LAST);
 #define MSR_GIM_HV_STIMER_AUTO_ENABLE             RT_BIT_64(3)
 /** Whether Stimer is enabled or not. */
 #define MSR_GIM_HV_STIMER_IS_AUTO_ENABLED(a)      RT_BOOL((a) & MSR_GIM_HV_STIMER_AUTO_ENABLE)
+/** The Stimer APIC vector mask (bits 4:11), direct mode only. */
+#define MSR_GIM_HV_STIMER_APIC_VECTOR             UINT64_C(0xff0)
+/** Gets the Stimer APIC vector used in direct mode. */
+#define MSR_GIM_HV_STIMER_GET_APIC_VECTOR(a)      (((a) >> 4) & 0xff)
+/** The Stimer direct mode mask. */
+#define MSR_GIM_HV_STIMER_DIRECT_MODE             RT_BIT_64(12)
+/** Whether Stimer is in direct mode or not. */
+#define MSR_GIM_HV_STIMER_IS_DIRECT_MODE(a)       RT_BOOL((a) & MSR_GIM_HV_STIMER_DIRECT_MODE)
 /** The Stimer SINTx mask (bits 16:19). */
 #define MSR_GIM_HV_STIMER_SINTX                   UINT64_C(0xf0000)
 /** Gets the Stimer synthetic interrupt source. */
@@ -559,7 +571,8 @@ AssertCompile(MSR_GIM_HV_RANGE11_FIRST <= MSR_GIM_HV_RANGE11_LAST);
 /** The Stimer valid read/write mask. */
 #define MSR_GIM_HV_STIMER_RW_VALID                (  MSR_GIM_HV_STIMER_ENABLE | MSR_GIM_HV_STIMER_PERIODIC    \
                                                    | MSR_GIM_HV_STIMER_LAZY   | MSR_GIM_HV_STIMER_AUTO_ENABLE \
-                                                   | MSR_GIM_HV_STIMER_SINTX)
+                                                   | MSR_GIM_HV_STIMER_SINTX  | MSR_GIM_HV_STIMER_APIC_VECTOR \
+                                                   | MSR_GIM_HV_STIMER_DIRECT_MODE)
 /** @} */
 
 
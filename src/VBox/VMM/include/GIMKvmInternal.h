@@ -125,6 +125,19 @@ AssertCompile(MSR_GIM_KVM_RANGE1_FIRST <= MSR_GIM_KVM_RANGE1_LAST);
 #define MSR_GIM_KVM_SYSTEM_TIME_GUEST_GPA(a)      ((a) & ~MSR_GIM_KVM_SYSTEM_TIME_ENABLE_BIT)
 /** @} */
 
+/** @name KVM MSR - Steal time (MSR_GIM_KVM_STEAL_TIME).
+ * @{
+ */
+/** The steal-time enable bit. */
+#define MSR_GIM_KVM_STEAL_TIME_ENABLE_BIT          RT_BIT_64(0)
+/** Whether the steal-time struct. is enabled or not. */
+#define MSR_GIM_KVM_STEAL_TIME_IS_ENABLED(a)       RT_BOOL((a) & MSR_GIM_KVM_STEAL_TIME_ENABLE_BIT)
+/** Reserved bits, the struct. must be 64-byte aligned. */
+#define MSR_GIM_KVM_STEAL_TIME_RSVD_MASK           UINT64_C(0x3e)
+/** Guest-physical address of the steal-time struct. */
+#define MSR_GIM_KVM_STEAL_TIME_GUEST_GPA(a)        ((a) & ~UINT64_C(0x3f))
+/** @} */
+
 /** @name KVM MSR - Wall clock (MSR_GIM_KVM_WALL_CLOCK and
  * MSR_GIM_KVM_WALL_CLOCK_OLD).
  * @{
@@ -181,6 +194,31 @@ typedef GIMKVMSYSTEMTIME const *PCGIMKVMSYSTEMTIME;
 AssertCompileSize(GIMKVMSYSTEMTIME, 32);
 
 
+/**
+ * KVM per-VCPU steal-time structure.
+ */
+typedef struct GIMKVMSTEALTIME
+{
+    /** The time (nanoseconds) the VCPU was runnable but not running. */
+    uint64_t        u64Steal;
+    /** Version (sequence number). */
+    uint32_t        u32Version;
+    /** Flags, currently none defined. */
+    uint32_t        fFlags;
+    /** Whether the VCPU has been preempted by the host (not used by us). */
+    uint8_t         fPreempted;
+    /** Alignment padding. */
+    uint8_t         abPadding0[3];
+    /** Reserved. */
+    uint32_t        au32Reserved[11];
+} GIMKVMSTEALTIME;
+/** Pointer to KVM steal-time struct. */
+typedef GIMKVMSTEALTIME *PGIMKVMSTEALTIME;
+/** Pointer to a const KVM steal-time struct. */
+typedef GIMKVMSTEALTIME const *PCGIMKVMSTEALTIME;
+AssertCompileSize(GIMKVMSTEALTIME, 64);
+
+
 /**
  * KVM per-VM wall-clock structure.
  */
@@ -244,6 +282,16 @@ typedef struct GIMKVMCPU
     uint64_t                    uVirtNanoTS;
     /** The flags of the system-time struct. */
     uint8_t                     fSystemTimeFlags;
+    /** Steal-time MSR. */
+    uint64_t                    u64StealTimeMsr;
+    /** The guest-physical address of the steal-time struct. */
+    RTGCPHYS                    GCPhysStealTime;
+    /** The (even) version of the steal-time struct last written. */
+    uint32_t                    u32StealTimeVersion;
+    /** The steal time last written to the guest struct. */
+    uint64_t                    uStealTime;
+    /** The TM steal time of the VCPU when uStealTime was last updated. */
+    uint64_t                    cNsStealLast;
 } GIMKVMCPU;
 /** Pointer to per-VCPU GIM KVM instance data. */
 typedef GIMKVMCPU *PGIMKVMCPU;
@@ -265,6 +313,8 @@ VMMR3_INT_DECL(int)             gimR3KvmLoad(PVM pVM, PSSMHANDLE pSSM);
 VMMR3_INT_DECL(int)             gimR3KvmDisableSystemTime(PVM pVM);
 VMMR3_INT_DECL(int)             gimR3KvmEnableSystemTime(PVM pVM, PVMCPU pVCpu, uint64_t uMsrSystemTime);
 VMMR3_INT_DECL(int)             gimR3KvmEnableWallClock(PVM pVM, RTGCPHYS GCPhysSysTime);
+VMMR3_INT_DECL(int)             gimR3KvmEnableStealTime(PVM pVM, PVMCPU pVCpu, uint64_t uMsrStealTime);
+VMMR3_INT_DECL(void)            gimR3KvmUpdateStealTime(PVM pVM, PVMCPU pVCpu);
 #endif /* IN_RING3 */
 
 VMM_INT_DECL(bool)              gimKvmIsParavirtTscEnabled(PVMCC pVM);
@@ -190,14 +190,25 @@ AssertCompileSize(GITSDIAG, 4);
 /** The last valid event ID value. */
 #define GITS_EVENT_ID_LAST              UINT16_MAX
 
+/** Number of sets in the LPI map cache (must be a power of two). */
+#define GITS_LPI_MAP_CACHE_SETS         32
+/** Number of ways (entries) in each set of the LPI map cache. */
+#define GITS_LPI_MAP_CACHE_WAYS         4
 /** Number of entries in the LPI map cache. */
-#define GITS_LPI_MAP_CACHE_COUNT        32
+#define GITS_LPI_MAP_CACHE_COUNT        (GITS_LPI_MAP_CACHE_SETS * GITS_LPI_MAP_CACHE_WAYS)
+AssertCompile(RT_IS_POWER_OF_TWO(GITS_LPI_MAP_CACHE_SETS));
+AssertCompile(GITS_LPI_MAP_CACHE_WAYS <= 8);
 
 /**
  * GITS LPI map.
  * Maps device ID/event ID combinations to pINTID and target CPUs. Using this cache
  * avoids expensive guest memory accesses.
  *
+ * The cache is set-associative, the set is picked by hashing the device ID and
+ * event ID and entry @a iWay of set @a iSet lives at index
+ * (iSet * GITS_LPI_MAP_CACHE_WAYS + iWay). Since a device ID/event ID of zero is
+ * perfectly valid, each set keeps a bitmap of its valid ways.
+ *
  * This is a structure of arrays rather than an array of structures since we
  * prioritize search performance over modifying the cache. Searching elements by
  * iterating @c uDevIdEventId is faster as they would trample far fewer cache lines.
@@ -212,6 +223,10 @@ typedef struct GITSLPIMAP
     uint16_t        uIntId[GITS_LPI_MAP_CACHE_COUNT];
     /** The target VCPU ID of the LPI. */
     VMCPUID         idCpu[GITS_LPI_MAP_CACHE_COUNT];
+    /** Bitmap of valid ways for each set. */
+    uint8_t         bmValid[GITS_LPI_MAP_CACHE_SETS];
+    /** The way to replace next when a set is full (round-robin). */
+    uint8_t         idxVictim[GITS_LPI_MAP_CACHE_SETS];
 } GITSLPIMAP;
 /** Pointer to GITS LPI map. */
 typedef GITSLPIMAP *PGITSLPIMAP;
@@ -300,10 +315,8 @@ typedef struct GITSDEV
      * @{ */
     /** The LPI map cache. */
     GITSLPIMAP              LpiMap;
-    /** Index of the entry to use while adding an entry to the LPI map cache. */
-    uint8_t                idxLpiMap;
     /** Number of valid items in the LPI map cache. */
-    uint8_t                cLpiMap;
+    uint16_t                cLpiMap;
     /** @} */
 
     /** @name Configurables.
@@ -328,7 +341,10 @@ typedef struct GITSDEV
     STAMCOUNTER             StatLpiCacheHit;
     STAMCOUNTER             StatLpiCacheMiss;
     STAMCOUNTER             StatLpiCacheAdd;
+    STAMCOUNTER             StatLpiCacheEvict;
     STAMCOUNTER             StatLpiCacheInvOne;
+    STAMCOUNTER             StatLpiCacheInvDev;
+    STAMCOUNTER             StatLpiCacheInvCollection;
     STAMCOUNTER             StatLpiCacheInvAll;
     /** @} */
 #endif
@@ -345,7 +361,7 @@ AssertCompileMemberAlignment(GITSDEV, pCmdQueueThread, 8);
 AssertCompileMemberAlignment(GITSDEV, hEvtCmdQueue, 8);
 AssertCompileMemberAlignment(GITSDEV, aCtes, sizeof(GITSCTE));
 AssertCompileMemberAlignment(GITSDEV, LpiMap, RT_SIZEOFMEMB(GITSLPIMAPENTRY, uDevIdEventId));
-AssertCompileMemberAlignment(GITSDEV, idxLpiMap, 4);
+AssertCompileMemberAlignment(GITSDEV, cLpiMap, 4);
 #ifdef VBOX_WITH_STATISTICS
 AssertCompileMemberAlignment(GITSDEV, StatCmdMapd, 8);
 #endif
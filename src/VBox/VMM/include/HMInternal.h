@@ -106,6 +106,40 @@ RT_C_DECLS_BEGIN
 /** @} */
 
 
+/** @name Exit latency histograms (VBOX_WITH_STATISTICS only).
+ * @{ */
+/** The histogram index used for SVM_EXIT_NPF, which doesn't fit
+ *  MASK_EXITREASON_STAT. */
+#define HM_EXIT_HIST_IDX_NPF                        MAX_EXITREASON_STAT
+/** Number of entries in HMCPU::aStatExitHistR0 and HMCPU::aStatExitHistR3. */
+#define HM_EXIT_HIST_COUNT                          (MAX_EXITREASON_STAT + 1)
+
+/** @def HM_EXIT_HIST_R0_ADD
+ * Records the ring-0 handling time of the current VM-exit, measured from the
+ * TSC value HMR0A.asm took right after the world switch.
+ *
+ * @param   a_pVCpu         The cross context virtual CPU structure.
+ * @param   a_idxExit       The histogram index of the exit.
+ */
+#ifdef VBOX_WITH_STATISTICS
+# define HM_EXIT_HIST_R0_ADD(a_pVCpu, a_idxExit) \
+    do { \
+        if (!(a_pVCpu)->hm.s.fExitHistograms) \
+        { /* likely */ } \
+        else \
+        { \
+            uint32_t const HmExitHist_idx = (a_idxExit); \
+            (a_pVCpu)->hm.s.idxExitHistLast = HmExitHist_idx; \
+            STAM_HISTOGRAM_ADD_PERIOD(&(a_pVCpu)->hm.s.aStatExitHistR0[HmExitHist_idx], \
+                                      ASMReadTSC() - (a_pVCpu)->hmr0.s.uTscExit); \
+        } \
+    } while (0)
+#else
+# define HM_EXIT_HIST_R0_ADD(a_pVCpu, a_idxExit)    do { } while (0)
+#endif
+/** @} */
+
+
 /**
  * HM physical (host) CPU information.
  */
@@ -292,6 +326,9 @@ typedef struct HM
          * In the default case it is only always intercepted when setting DR6 to 0 on
          * the host results in a value different from X86_DR6_RA1_MASK. */
         int8_t                      fAlwaysInterceptMovDRxCfg;
+        /** Set if posted-interrupt processing should be used if available.  Ring-0
+         * decides whether it actually is, see HM::fPostedIntrs. */
+        bool                        fPostedIntrsCfg;
         /** @} */
 
         /** Pause-loop exiting (PLE) gap in ticks. */
@@ -532,7 +569,11 @@ typedef struct HMR0PERVM
         bool                        fLbr;
         /** Set always intercept MOV DRx. */
         bool                        fAlwaysInterceptMovDRx;
-        bool                        afAlignment2[2];
+        /** Set if posted-interrupt processing and virtual-interrupt delivery are
+         *  used (copy in HM::fPostedIntrs). */
+        bool                        fPostedIntrs;
+        /** The host vector used for posted-interrupt notifications. */
+        uint8_t                     uPostedIntrNotifyVector;
 
         /** Set if VPID is supported (copy in HM::vmx::fVpidForRing3). */
         bool                        fVpid;
@@ -1018,6 +1059,19 @@ typedef struct HMCPU
     STAMCOUNTER             aStatNestedExitReason[MAX_EXITREASON_STAT];
     STAMCOUNTER             aStatInjectedIrqs[256];
     STAMCOUNTER             aStatInjectedXcpts[X86_XCPT_LAST + 1];
+
+    /** Whether to sample the exit latency histograms below (/HM/ExitHistograms). */
+    bool                    fExitHistograms;
+    bool                    afExitHistPadding[3];
+    /** The histogram index of the last VM-exit handled in ring-0, UINT32_MAX if
+     * none.  Used for attributing the ring-3 time to an exit reason. */
+    uint32_t                idxExitHistLast;
+    /** Ring-0 exit latency per exit reason, from the VM-exit TSC until the exit
+     * handler returns. */
+    STAMHISTOGRAM           aStatExitHistR0[HM_EXIT_HIST_COUNT];
+    /** Time spent in ring-3 completing exits passed up by ring-0, indexed by the
+     * reason of the exit that caused the return to ring-3. */
+    STAMHISTOGRAM           aStatExitHistR3[HM_EXIT_HIST_COUNT];
 #endif
 #ifdef HM_PROFILE_EXIT_DISPATCH
     STAMPROFILEADV          StatExitDispatch;
@@ -1093,9 +1147,16 @@ typedef struct HMR0PERVCPU
         /* Whether the nested-guest VMCS was the last current VMCS (authoritative copy).
          * @see HMCPU::vmx.fSwitchedToNstGstVmcsCopyForRing3  */
         bool                        fSwitchedToNstGstVmcs;
-        bool                        afAlignment0[7];
+        bool                        afAlignment0[1];
+        /** The guest-interrupt status last written to the guest VMCS (RVI in
+         *  bits 7:0, SVI in bits 15:8), when using virtual-interrupt delivery. */
+        uint16_t                    u16GuestIntrStatus;
+        bool                        afAlignment1[4];
         /** Pointer to the VMX transient info during VM-exit. */
         PVMXTRANSIENT               pVmxTransient;
+        /** The EOI-exit bitmap last written to the guest VMCS, when using
+         *  virtual-interrupt delivery. */
+        uint64_t                    au64EoiExitBitmap[4];
         /** @} */
 
         /** @name Host information.
@@ -753,6 +753,48 @@ AssertCompile(RT_BIT_32(IEMTLB_ENTRY_COUNT_AS_POWER_OF_TWO) == IEMTLB_ENTRY_COUN
 # define IEMTLB_WITH_LARGE_PAGE_BITMAP
 #endif
 
+
+/** @def IEMTLB_WITH_L2_LARGE_PAGES
+ * Enables the second level TLB for large pages.
+ *
+ * The main TLB only holds 4KB entries, so a guest touching a lot of memory
+ * mapped by 2MB/4MB/1GB pages will do one page walk per 4KB page even though
+ * the walk result is the same for all of them.  The second level TLB caches the
+ * walk result for 2MB granules of large pages, allowing main TLB misses within
+ * such granules to be resolved w/o walking the guest page tables again.  The
+ * entries are tagged with the same revisions as the main TLB, so flushes are
+ * free. */
+#if defined(VBOX_VMM_TARGET_X86) || defined(DOXYGEN_RUNNING)
+# define IEMTLB_WITH_L2_LARGE_PAGES
+#endif
+/** Number of second level large page TLB entries (2MB granules). */
+#define IEMTLB_L2_ENTRY_COUNT                   256
+/** The granule shift of the second level large page TLB. */
+#define IEMTLB_L2_GRANULE_SHIFT                 21
+AssertCompile(RT_IS_POWER_OF_TWO(IEMTLB_L2_ENTRY_COUNT));
+
+/**
+ * A second level large page TLB entry.
+ */
+typedef struct IEMTLBL2ENTRY
+{
+    /** The granule tag: GCPtr bits 47:21 ORed with the TLB revision (uTlbRevision
+     *  or, if fGlobal is true, uTlbRevisionGlobal). */
+    uint64_t            uTag;
+    /** The guest physical address of the granule. */
+    RTGCPHYS            GCPhys;
+    /** The effective page table attributes from the walk (PGM_PTATTRS_XXX). */
+    uint64_t            fEffective;
+    /** The walk info flags (PGM_WALKINFO_XXX). */
+    uint32_t            fInfo;
+    /** Whether the entry is tagged with uTlbRevisionGlobal. */
+    bool                fGlobal;
+    bool                afPadding[3];
+} IEMTLBL2ENTRY;
+AssertCompileSize(IEMTLBL2ENTRY, 32);
+/** Pointer to a second level large page TLB entry. */
+typedef IEMTLBL2ENTRY *PIEMTLBL2ENTRY;
+
 #if (IEMTLB_ENTRY_COUNT > 1 && defined(VBOX_VMM_TARGET_X86)) || defined(DOXYGEN_RUNNING)
 /** Tests if the TLB entry is global (odd). */
 # define IEMTLBE_IS_GLOBAL(a_pTlbe)      (((uintptr_t)(a_pTlbe) / sizeof(IEMTLBENTRY)) & 1)
@@ -923,8 +965,19 @@ typedef struct IEMTLB
     /** Subset of cTlbInvlPg that involved global large pages. */
     uint32_t            cTlbInvlPgLargeGlobal;
 
+#ifdef IEMTLB_WITH_L2_LARGE_PAGES
+    /** Main TLB misses resolved by the second level large page TLB. */
+    uint32_t            cTlbL2Hits;
+    /** Second level large page TLB entries loaded. */
+    uint32_t            cTlbL2Loads;
+    /** Number of 1GB page entries in the second level TLB since it was last
+     * wiped.  INVLPG must wipe all of it when non-zero, as a 1GB page spans
+     * many entries. */
+    uint32_t            cTlbL2CurGiganticLoads;
+#endif
+
 #ifdef VBOX_VMM_TARGET_X86
-    uint32_t            au32Padding[13];
+    uint32_t            au32Padding[13 - 3];
 #else
     uint32_t            au32Padding[13 + 8];
 #endif
@@ -938,6 +991,10 @@ typedef struct IEMTLB
      * This duplicates IEMTLBE_F_PT_LARGE_PAGE for each TLB entry. */
     uint64_t            bmLargePage[IEMTLB_ENTRY_COUNT * IEMTLB_ENTRY_COUNT_FACTOR / 64];
 #endif
+#ifdef IEMTLB_WITH_L2_LARGE_PAGES
+    /** The second level large page TLB entries (direct mapped). */
+    IEMTLBL2ENTRY       aL2Entries[IEMTLB_L2_ENTRY_COUNT];
+#endif
 } IEMTLB;
 AssertCompileMemberAlignment(IEMTLB, aEntries, 64);
 AssertCompileSizeAlignment(IEMTLB, 64);
@@ -1702,6 +1759,11 @@ typedef IEMTHRDEDCALLENTRY const *PCIEMTHRDEDCALLENTRY;
 
 /** The call entry is a jump target. */
 #define IEMTHREADEDCALLENTRY_F_JUMP_TARGET              UINT8_C(0x01)
+/** The EFLAGS status bits produced by the call are dead, i.e. all of them
+ * will be overwritten before anyone gets to look at them, so the function
+ * from g_apfnIemThreadedFunctionsNoEfl is used instead.  This is set by
+ * iemNativeLivenessMarkDeadEFlagsCalls. */
+#define IEMTHREADEDCALLENTRY_F_EFL_DEAD                 UINT8_C(0x02)
 
 
 /**
@@ -2019,11 +2081,24 @@ typedef struct IEMTBCACHE
     STAMCOUNTER     cLookupHits;
     /** Statistics: Number of TB lookup hits via TB associated lookup table (debug only). */
     STAMCOUNTER     cLookupHitsViaTbLookupTable;
-    STAMCOUNTER     auPadding2[2];
+    /** Statistics: Number of new threaded TBs fast-tracked for native
+     *  recompilation because another EMT already recompiled them. */
+    STAMCOUNTER     cHintHits;
+    /** The VM-wide hot TB hint table shared by all EMTs, NULL if disabled. */
+    struct IEMTBHINTS *pHints;
     /** Statistics: Collision list length pruning. */
     STAMPROFILE     StatPrune;
+    /** Statistics: Number of calls in new threaded TBs whose EFLAGS status bit
+     *  output is dead (IEMTHREADEDCALLENTRY_F_EFL_DEAD). */
+    STAMCOUNTER     cThrdEflDeadCalls;
+    /** Statistics: Number of threaded calls executed w/o status flag
+     *  calculations (IEMTHREADEDCALLENTRY_F_EFL_DEAD). */
+    STAMCOUNTER     cThrdEflDeadCallsExecuted;
     /** @} */
 
+    /** TB-to-TB transition profile, NULL if not enabled (/IEM/TbChainProfiling). */
+    struct IEMTBCHAINPROF *pChainProf;
+
     /** The hash table itself.
      * @note The lower 6 bits of the pointer is used for keeping the collision
      *       list length, so we can take action when it grows too long.
@@ -2055,6 +2130,63 @@ typedef IEMTBCACHE *PIEMTBCACHE;
  *  IEMTBCACHE::apHash entry. */
 #define IEMTBCACHE_PTR_GET_COUNT(a_pHashEntry)  ((uintptr_t)(a_pHashEntry) & IEMTBCACHE_PTR_COUNT_MASK)
 
+/**
+ * A TB-to-TB transition profile entry.
+ *
+ * The TB pointers are only used as identifiers and may be stale, the physical
+ * PCs are recorded so stale entries can be recognized when reporting.
+ */
+typedef struct IEMTBCHAINEDGE
+{
+    /** The TB we came from. */
+    PCIEMTB         pFrom;
+    /** The TB we went to. */
+    PCIEMTB         pTo;
+    /** The IEMTB::GCPhysPc of pFrom at the time of recording. */
+    RTGCPHYS        GCPhysFrom;
+    /** The IEMTB::GCPhysPc of pTo at the time of recording. */
+    RTGCPHYS        GCPhysTo;
+    /** Number of times this transition was seen. */
+    uint32_t        cTransitions;
+    uint32_t        uPadding;
+} IEMTBCHAINEDGE;
+/** Pointer to a TB-to-TB transition profile entry. */
+typedef IEMTBCHAINEDGE *PIEMTBCHAINEDGE;
+/** Pointer to a const TB-to-TB transition profile entry. */
+typedef IEMTBCHAINEDGE const *PCIEMTBCHAINEDGE;
+
+/** Number of entries in IEMTBCHAINPROF::aEdges (power of two). */
+#define IEMTBCHAINPROF_EDGES        4096
+/** The IEMTBCHAINEDGE::cTransitions value at which an edge is considered hot,
+ * i.e. a candidate for superblock formation. */
+#define IEMTBCHAINPROF_HOT_COUNT    _64K
+
+/**
+ * Per-EMT profile of TB-to-TB transitions going thru the run loop.
+ *
+ * This records the transitions that are not handled by direct linking inside
+ * the native code and pay for a full TB lookup.  It is direct mapped, with a
+ * new edge replacing an old one when they collide.
+ */
+typedef struct IEMTBCHAINPROF
+{
+    /** The TB executed last, NULL after leaving the run loop. */
+    PCIEMTB         pPrevTb;
+    /** Statistics: Number of transitions recorded. */
+    STAMCOUNTER     StatTransitions;
+    /** Statistics: Number of edges reaching IEMTBCHAINPROF_HOT_COUNT. */
+    STAMCOUNTER     StatHotEdges;
+    /** Statistics: Number of edges evicted by a colliding one. */
+    STAMCOUNTER     StatEvictions;
+    /** The edges. */
+    IEMTBCHAINEDGE  aEdges[IEMTBCHAINPROF_EDGES];
+} IEMTBCHAINPROF;
+/** Pointer to a TB-to-TB transition profile. */
+typedef IEMTBCHAINPROF *PIEMTBCHAINPROF;
+/** Pointer to a const TB-to-TB transition profile. */
+typedef IEMTBCHAINPROF const *PCIEMTBCHAINPROF;
+
+
 /**
  * Calculates the hash table slot for a TB from physical PC address and TB flags.
  */
@@ -2069,6 +2201,114 @@ typedef IEMTBCACHE *PIEMTBCACHE;
     (((uint32_t)(a_GCPhysPc) ^ (a_fTbFlags)) & (a_paCache)->uHashMask)
 
 
+/**
+ * Translation block warm-start profile entry.
+ *
+ * This is what we persist about a native TB between VM runs.  The native code
+ * itself is full of host addresses (helpers, exec memory, the VMCPU structure),
+ * so instead we remember which blocks got hot enough to be natively recompiled
+ * and the opcode bytes they were compiled from, so a matching threaded TB can
+ * skip most of the warm-up and be natively recompiled on its next use.
+ */
+typedef struct IEMTBPROFILEENTRY
+{
+    /** The physical PC of the TB (IEMTB::GCPhysPc). */
+    RTGCPHYS        GCPhysPc;
+    /** The key part of the TB flags (IEMTB::fFlags & IEMTB_F_KEY_MASK). */
+    uint32_t        fFlags;
+    /** CRC-32 of the opcode bytes. */
+    uint32_t        uOpcodeCrc32;
+    /** Number of opcode bytes (IEMTB::cbOpcodes). */
+    uint16_t        cbOpcodes;
+    /** The relevant CS attribute bits (IEMTB::x86.fAttr). */
+    uint16_t        fAttr;
+    /** Reserved, MBZ. */
+    uint32_t        uReserved;
+} IEMTBPROFILEENTRY;
+AssertCompileSize(IEMTBPROFILEENTRY, 24);
+/** Pointer to a TB warm-start profile entry. */
+typedef IEMTBPROFILEENTRY *PIEMTBPROFILEENTRY;
+/** Pointer to a const TB warm-start profile entry. */
+typedef IEMTBPROFILEENTRY const *PCIEMTBPROFILEENTRY;
+
+/**
+ * TB warm-start profile file header.
+ */
+typedef struct IEMTBPROFILEHDR
+{
+    /** Magic value (IEMTBPROFILEHDR_MAGIC). */
+    uint32_t        uMagic;
+    /** The format version (IEMTBPROFILEHDR_VERSION). */
+    uint32_t        uVersion;
+    /** Size of each entry (sizeof(IEMTBPROFILEENTRY)). */
+    uint32_t        cbEntry;
+    /** Number of entries following the header. */
+    uint32_t        cEntries;
+    /** The layout of IEMTB_F_KEY_MASK at the time of writing. */
+    uint32_t        fKeyMask;
+    /** Reserved, MBZ. */
+    uint32_t        uReserved;
+} IEMTBPROFILEHDR;
+AssertCompileSize(IEMTBPROFILEHDR, 24);
+/** Magic value for IEMTBPROFILEHDR (Alan Turing). */
+#define IEMTBPROFILEHDR_MAGIC       UINT32_C(0x19120623)
+/** The current IEMTBPROFILEHDR::uVersion value. */
+#define IEMTBPROFILEHDR_VERSION     UINT32_C(0x00010000)
+
+/**
+ * A loaded TB warm-start profile, shared read-only by all EMTs.
+ */
+typedef struct IEMTBPROFILE
+{
+    /** Number of entries. */
+    uint32_t                cEntries;
+    uint32_t                uPadding;
+    /** The entries, sorted by GCPhysPc, fFlags and fAttr (iemTbProfileCompare). */
+    RT_FLEXIBLE_ARRAY_EXTENSION
+    IEMTBPROFILEENTRY       aEntries[RT_FLEXIBLE_ARRAY];
+} IEMTBPROFILE;
+/** Pointer to a TB warm-start profile. */
+typedef IEMTBPROFILE *PIEMTBPROFILE;
+/** Pointer to a const TB warm-start profile. */
+typedef IEMTBPROFILE const *PCIEMTBPROFILE;
+
+
+/**
+ * VM-wide hot translation block hint table.
+ *
+ * Each EMT has its own TB cache and executable memory, so sharing the actual
+ * TBs would require reference counting or an RCU-like scheme for freeing them
+ * safely.  What this table shares instead is the knowledge that a block has
+ * become hot: when an EMT natively recompiles a TB it publishes a 64-bit key
+ * (see iemTbHintsCalcKey) here, and any other EMT compiling a threaded TB with
+ * the same key will natively recompile it on the next use instead of warming
+ * it up all over again.
+ *
+ * The table uses open addressing with a short linear probe sequence and is
+ * only ever added to, using atomic compare-and-exchange.  A false positive
+ * merely causes an early native recompilation, so no locking is required and
+ * nothing bad happens if the table fills up.
+ */
+typedef struct IEMTBHINTS
+{
+    /** Magic value (IEMTBHINTS_MAGIC). */
+    uint32_t            uMagic;
+    /** The hash mask (number of entries - 1). */
+    uint32_t            uHashMask;
+    /** The keys, zero if the entry is free. */
+    RT_FLEXIBLE_ARRAY_EXTENSION
+    uint64_t volatile   au64Keys[RT_FLEXIBLE_ARRAY];
+} IEMTBHINTS;
+/** Pointer to a VM-wide TB hint table. */
+typedef IEMTBHINTS *PIEMTBHINTS;
+/** Pointer to a const VM-wide TB hint table. */
+typedef IEMTBHINTS const *PCIEMTBHINTS;
+/** Magic value for IEMTBHINTS (Grace Hopper). */
+#define IEMTBHINTS_MAGIC            UINT32_C(0x19061209)
+/** Number of entries to probe in IEMTBHINTS::au64Keys before giving up. */
+#define IEMTBHINTS_MAX_PROBES       8
+
+
 /** @name IEMBRANCHED_F_XXX - Branched indicator (IEMCPU::fTbBranched).
  *
  * These flags parallels the main IEM_CIMPL_F_BRANCH_XXX flags.
@@ -2277,7 +2517,14 @@ typedef struct IEMCPURECOMP
     uint8_t                 fHostICacheInvalidation;
 #define IEMNATIVE_ICACHE_F_USE_HOST_API     UINT8_C(0x01) /**< Use the host API (macOS) instead of our code. */
 #define IEMNATIVE_ICACHE_F_END_WITH_ISH     UINT8_C(0x02) /**< Whether to end with a ISH barrier (arm). */
-    bool                    afRecompilerStuff2[7];
+    /** Executable memory allocator configuration (IEMEXECMEM_F_XXX), consumed
+     *  by iemExecMemAllocatorInit. */
+    uint8_t                 fExecMemFlags;
+#define IEMEXECMEM_F_DUAL_MAPPING           UINT8_C(0x01) /**< W^X: separate RW and RX views of each chunk (linux). */
+#define IEMEXECMEM_F_LARGE_PAGES            UINT8_C(0x02) /**< Try back chunks with 2 MiB host pages (implies dual mapping). */
+#define IEMEXECMEM_F_PERF_MAP               UINT8_C(0x04) /**< Write /tmp/perf-<pid>.map entries for TBs (linux). */
+#define IEMEXECMEM_F_PERF_JITDUMP           UINT8_C(0x08) /**< Write /tmp/jit-<pid>.dump records for TBs (linux). */
+    bool                    afRecompilerStuff2[6];
     /** @} */
 
 } IEMCPURECOMP;
@@ -2629,10 +2876,19 @@ typedef struct IEMCPU
 
     STAMCOUNTER             aStatAdHoc[8];
 
+    /** The TB warm-start profile loaded at VM start, NULL if none.
+     * This is shared by all EMTs and read-only while the VM is running. */
+    R3PTRTYPE(PCIEMTBPROFILE) pTbProfileR3;
+    /** Statistics: Threaded TBs matching a warm-start profile entry. */
+    STAMCOUNTER             StatTbProfileHits;
+    /** Statistics: Threaded TBs matching a warm-start profile entry by key but
+     *  with different opcode bytes. */
+    STAMCOUNTER             StatTbProfileStale;
+
 #ifdef IEM_WITH_TLB_TRACE
-    uint64_t                au64Padding[0+4];
+    uint64_t                au64Padding[0+1];
 #else
-    uint64_t                au64Padding[2+4];
+    uint64_t                au64Padding[2+1];
 #endif
 
 #ifdef IEM_WITH_TLB_TRACE
@@ -3562,6 +3818,11 @@ DECLHIDDEN(void)    iemThreadedDisassembleTb(PCIEMTB pTb, PCDBGFINFOHLP pHlp) RT
 #if defined(VBOX_WITH_IEM_NATIVE_RECOMPILER) && defined(VBOX_WITH_SAVE_THREADED_TBS_FOR_PROFILING)
 DECLHIDDEN(void)    iemThreadedSaveTbForProfilingCleanup(PVMCPU pVCpu);
 #endif
+#ifdef VBOX_WITH_IEM_NATIVE_RECOMPILER
+DECLCALLBACK(int)   iemTbProfileCompare(void const *pvElement1, void const *pvElement2, void *pvUser);
+DECLHIDDEN(void)    iemTbProfileEntryInit(PIEMTBPROFILEENTRY pEntry, PCIEMTB pTb) RT_NOEXCEPT;
+DECLHIDDEN(void)    iemTbHintsPublish(PVMCPUCC pVCpu, PCIEMTB pTb) RT_NOEXCEPT;
+#endif
 
 
 /** @todo FNIEMTHREADEDFUNC and friends may need more work... */
@@ -3586,6 +3847,7 @@ typedef FNIEMTHREADEDFUNC *PFNIEMTHREADEDFUNC;
 /* Native recompiler public bits: */
 
 DECLHIDDEN(PIEMTB)  iemNativeRecompile(PVMCPUCC pVCpu, PIEMTB pTb) RT_NOEXCEPT;
+DECLHIDDEN(uint32_t) iemNativeLivenessMarkDeadEFlagsCalls(PVMCPUCC pVCpu, PIEMTB pTb) RT_NOEXCEPT;
 DECLHIDDEN(void)    iemNativeDisassembleTb(PVMCPU pVCpu, PCIEMTB pTb, PCDBGFINFOHLP pHlp) RT_NOEXCEPT;
 int                 iemExecMemAllocatorInit(PVMCPU pVCpu, uint64_t cbMax, uint64_t cbInitial, uint32_t cbChunk) RT_NOEXCEPT;
 DECLHIDDEN(PIEMNATIVEINSTR) iemExecMemAllocatorAlloc(PVMCPU pVCpu, uint32_t cbReq, PIEMTB pTb, PIEMNATIVEINSTR *ppaExec,
@@ -3593,6 +3855,9 @@ DECLHIDDEN(PIEMNATIVEINSTR) iemExecMemAllocatorAlloc(PVMCPU pVCpu, uint32_t cbRe
 DECLHIDDEN(PIEMNATIVEINSTR) iemExecMemAllocatorAllocFromChunk(PVMCPU pVCpu, uint32_t idxChunk, uint32_t cbReq,
                                                               PIEMNATIVEINSTR *ppaExec);
 DECLHIDDEN(void)    iemExecMemAllocatorReadyForUse(PVMCPUCC pVCpu, void *pv, size_t cb) RT_NOEXCEPT;
+#if defined(RT_OS_LINUX) && defined(IN_RING3)
+DECLHIDDEN(void)    iemExecMemAllocatorAnnounceTb(PVMCPUCC pVCpu, PCIEMTB pTb) RT_NOEXCEPT;
+#endif
 void                iemExecMemAllocatorFree(PVMCPU pVCpu, void *pv, size_t cb) RT_NOEXCEPT;
 DECLASM(DECL_NO_RETURN(void)) iemNativeTbLongJmp(void *pvFramePointer, int rc) RT_NOEXCEPT;
 DECLHIDDEN(struct IEMNATIVEPERCHUNKCTX const *) iemExecMemGetTbChunkCtx(PVMCPU pVCpu, PCIEMTB pTb);
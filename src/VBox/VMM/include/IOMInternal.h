@@ -277,7 +277,11 @@ typedef struct IOMMMIOENTRYR3
     bool                                fRing0 : 1;
     /** Set if there is an raw-mode entry too. */
     bool                                fRawMode : 1;
-    bool                                fPadding : 6;
+    /** Set if the current mapping is registered for coalesced writes with NEM
+     * (IOMMMIO_FLAGS_COALESCE_WRITES).  Only updated when the critsect is held
+     * exclusively. */
+    bool                                fCoalesced : 1;
+    bool                                fPadding : 5;
     /** Pre-registered ad-hoc RAM range ID. */
     uint16_t                            idRamRange;
     /** Same as the handle index. */
@@ -396,6 +400,40 @@ typedef struct IOMCPU
 typedef IOMCPU *PIOMCPU;
 
 
+/**
+ * MMIO doorbell registration (IOMR3MmioDoorbellRegister).
+ *
+ * These are kept on a simple list hanging off IOM as there are typically only
+ * a handful of them and they are only looked at when mapping and unmapping.
+ */
+typedef struct IOMMMIODOORBELL
+{
+    /** Pointer to the next doorbell. */
+    struct IOMMMIODOORBELL         *pNext;
+    /** The device instance owning the region. */
+    PPDMDEVINSR3                    pDevIns;
+    /** The MMIO region handle. */
+    IOMMMIOHANDLE                   hRegion;
+    /** The offset of the doorbell into the region. */
+    RTGCPHYS                        off;
+    /** The access size. */
+    uint32_t                        cb;
+    /** IOMMMIO_DOORBELL_F_XXX. */
+    uint32_t                        fFlags;
+    /** The value to match (IOMMMIO_DOORBELL_F_DATAMATCH). */
+    uint64_t                        uDataMatch;
+    /** The NEM doorbell handle while the region is mapped,
+     *  NEM_DOORBELL_HANDLE_NIL if not. */
+    uint32_t                        hNemDoorbell;
+    /** The device callback. */
+    R3PTRTYPE(PFNIOMMMIODOORBELL)   pfnNotify;
+    /** User argument for the callback. */
+    RTR3PTR                         pvUser;
+} IOMMMIODOORBELL;
+/** Pointer to a MMIO doorbell registration. */
+typedef IOMMMIODOORBELL *PIOMMMIODOORBELL;
+
+
 /**
  * IOM Data (part of VM)
  */
@@ -464,6 +502,9 @@ typedef struct IOM
     R3PTRTYPE(PIOMMMIOSTATSENTRY)   paMmioStats;
     /** Dummy stats entry so we don't need to check for NULL pointers so much. */
     IOMMMIOSTATSENTRY               MmioDummyStats;
+    /** MMIO doorbell registrations (see IOMR3MmioDoorbellRegister).
+     * Protected by the IOM lock. */
+    R3PTRTYPE(PIOMMMIODOORBELL)     pMmioDoorbellsR3;
     /** @} */
 
     /** @name I/O Port statistics.
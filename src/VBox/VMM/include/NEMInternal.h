@@ -40,6 +40,8 @@
 #ifdef RT_OS_WINDOWS
 # include <iprt/nt/hyperv.h>
 # include <iprt/critsect.h>
+#elif defined(RT_OS_LINUX)
+# include <iprt/critsect.h>
 #elif defined(RT_OS_DARWIN) && defined(VBOX_WITH_NATIVE_NEM)
 # ifdef VBOX_VMM_TARGET_ARMV8
 #  include <Hypervisor/Hypervisor.h>
@@ -110,6 +112,13 @@ typedef struct NEMWINIOCTL
 #endif /* RT_OS_WINDOWS */
 
 
+#ifdef RT_OS_LINUX
+/** Linux: Number of entries in NEMCPU::paStatExitHist, the last one collects
+ *  all the exit reasons that don't fit. */
+# define NEM_LNX_EXIT_HIST_COUNT        64
+#endif
+
+
 #if defined(RT_OS_DARWIN) && defined(VBOX_WITH_NATIVE_NEM)
 # ifndef VBOX_VMM_TARGET_ARMV8
 /** vCPU ID declaration to avoid dragging in HV headers here. */
@@ -239,6 +248,39 @@ typedef struct NEM
     /** Memory slot ID allocation bitmap. */
     uint64_t                    bmSlotIds[_32K / 8 / sizeof(uint64_t)];
 
+    /** KVM_CAP_IOEVENTFD. */
+    bool                        fIoEventFd;
+    /** Whether to use KVM_IOEVENTFD for doorbells (/NEM/IoEventFd). */
+    bool                        fUseIoEventFd;
+    bool                        afPadding1[6];
+    /** The doorbell (ioeventfd) dispatcher state, NULL if not in use. */
+    R3PTRTYPE(struct NEMLNXDOORBELLS *) pDoorbells;
+
+    /** KVM_CAP_COALESCED_MMIO: The page offset of the coalesced MMIO ring in the
+     * vCPU mapping, zero if not supported. */
+    uint8_t                     uCoalescedMmioPageOff;
+    /** Whether to use coalesced MMIO for IOMMMIO_FLAGS_COALESCE_WRITES regions
+     * (/NEM/CoalescedMmio). */
+    bool                        fUseCoalescedMmio;
+    /** Whether to sample the exit latency histograms (/NEM/ExitHistograms). */
+    bool                        fExitHistograms;
+    bool                        afPadding2[1];
+    /** Number of registered coalesced MMIO zones. */
+    uint32_t volatile           cCoalescedMmioZones;
+    /** Number of entries in the coalesced MMIO ring. */
+    uint32_t                    cCoalescedMmioRingEntries;
+    uint32_t                    u32Padding3;
+    /** The coalesced MMIO ring (part of the vCPU 0 mapping, shared by all
+     *  vCPUs), NULL if not in use. */
+    R3PTRTYPE(struct kvm_coalesced_mmio_ring *) pCoalescedMmioRing;
+    /** Serializes draining of the coalesced MMIO ring, which is shared by all
+     * vCPUs. */
+    RTCRITSECT                  CoalescedMmioCritSect;
+    /** Number of coalesced MMIO writes replayed. */
+    STAMCOUNTER                 StatCoalescedMmioWrites;
+    /** Number of times the coalesced MMIO ring was found non-empty. */
+    STAMCOUNTER                 StatCoalescedMmioDrains;
+
 #elif defined(RT_OS_WINDOWS)
     /** Set if we've created the EMTs. */
     bool                        fCreatedEmts : 1;
@@ -469,6 +511,10 @@ typedef struct NEMCPU
     /** The MSR_IA32_APICBASE value known to KVM. */
     uint64_t                    uKvmApicBase;
 # endif
+    /** Ring-3 exit handling latency per KVM exit reason, from the return of
+     * KVM_RUN until the exit has been handled.  NEM_LNX_EXIT_HIST_COUNT entries,
+     * NULL unless /NEM/ExitHistograms is set. */
+    R3PTRTYPE(PSTAMHISTOGRAM)   paStatExitHist;
 
     /** @name Statistics
      * @{ */
@@ -854,6 +900,24 @@ DECLHIDDEN(bool)    nemR3NativeNotifyDebugEventChanged(PVM pVM, bool fUseDebugLo
  */
 DECLHIDDEN(bool)    nemR3NativeNotifyDebugEventChangedPerCpu(PVM pVM, PVMCPU pVCpu, bool fUseDebugLoop);
 
+# ifdef RT_OS_LINUX
+/** Worker for NEMR3DoorbellRegister (KVM_IOEVENTFD). */
+DECLHIDDEN(int)     nemR3NativeDoorbellRegister(PVM pVM, uint32_t fFlags, RTGCPHYS GCPhysOrPort, uint32_t cb, uint64_t uDataMatch,
+                                                PFNNEMR3DOORBELL pfnNotify, void *pvUser, uint32_t *phDoorbell);
+/** Worker for NEMR3DoorbellDeregister. */
+DECLHIDDEN(int)     nemR3NativeDoorbellDeregister(PVM pVM, uint32_t hDoorbell);
+/** Worker for NEMR3MmioCoalesceRegister (KVM_REGISTER_COALESCED_MMIO). */
+DECLHIDDEN(int)     nemR3NativeMmioCoalesceRegister(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb);
+/** Worker for NEMR3MmioCoalesceDeregister. */
+DECLHIDDEN(int)     nemR3NativeMmioCoalesceDeregister(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb);
+/** Worker for NEMR3PhysRamDirtyTracking (KVM_MEM_LOG_DIRTY_PAGES). */
+DECLHIDDEN(int)     nemR3NativePhysRamDirtyTracking(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb, void *pvR3, uint32_t uNemRange,
+                                                    bool fEnable);
+/** Worker for NEMR3PhysRamQueryAndResetDirtyBitmap (KVM_GET_DIRTY_LOG). */
+DECLHIDDEN(int)     nemR3NativePhysRamQueryAndResetDirtyBitmap(PVM pVM, RTGCPHYS GCPhys, RTGCPHYS cb, uint32_t uNemRange,
+                                                               void *pvBitmap, size_t cbBitmap);
+# endif
+
 #endif /* IN_RING3 */
 
 /** All stubs. */
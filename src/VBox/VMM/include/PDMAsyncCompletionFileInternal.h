@@ -36,6 +36,7 @@
 #include <VBox/vmm/tm.h>
 #include <iprt/types.h>
 #include <iprt/file.h>
+#include <iprt/ioqueue.h>
 #include <iprt/thread.h>
 #include <iprt/semaphore.h>
 #include <iprt/critsect.h>
@@ -110,6 +111,8 @@ typedef enum PDMACEPFILEMGRTYPE
     PDMACEPFILEMGRTYPE_SIMPLE = 0,
     /** Async I/O with host cache enabled. */
     PDMACEPFILEMGRTYPE_ASYNC,
+    /** Async I/O through an I/O queue (io_uring on Linux hosts). */
+    PDMACEPFILEMGRTYPE_IOQUEUE,
     /** 32bit hack */
     PDMACEPFILEMGRTYPE_32BIT_HACK = 0x7fffffff
 } PDMACEPFILEMGRTYPE;
@@ -168,6 +171,12 @@ typedef struct PDMACEPFILEMGR
     RTTHREAD                               Thread;
     /** The async I/O context for this manager. */
     RTFILEAIOCTX                           hAioCtx;
+    /** The I/O queue for this manager (PDMACEPFILEMGRTYPE_IOQUEUE only). */
+    RTIOQUEUE                              hIoQueue;
+    /** Flag whether the thread waits for completions in the I/O queue. */
+    volatile bool                          fWaitingIoQueue;
+    /** Number of requests prepared in the I/O queue but not committed yet. */
+    uint32_t                               cIoQueueReqsPrepared;
     /** Flag whether the I/O manager was woken up. */
     volatile bool                          fWokenUp;
     /** List of endpoints assigned to this manager. */
@@ -284,6 +293,8 @@ typedef struct PDMASYNCCOMPLETIONEPCLASSFILE
     RTR3UINTPTR                         uBitmaskAlignment;
     /** Flag whether the out of resources warning was printed already. */
     bool                                fOutOfResourcesWarningPrinted;
+    /** Flag whether I/O queue managers should let the host kernel poll for new requests. */
+    bool                                fIoQueueSqPoll;
 #ifdef PDM_ASYNC_COMPLETION_FILE_WITH_DELAY
     /** Timer for delayed request completion. */
     TMTIMERHANDLE                       hTimer;
@@ -542,10 +553,14 @@ typedef struct PDMASYNCCOMPLETIONTASKFILE
 
 DECLCALLBACK(int) pdmacFileAioMgrFailsafe(RTTHREAD hThreadSelf, void *pvUser);
 DECLCALLBACK(int) pdmacFileAioMgrNormal(RTTHREAD hThreadSelf, void *pvUser);
+DECLCALLBACK(int) pdmacFileAioMgrIoQueue(RTTHREAD hThreadSelf, void *pvUser);
 
 int pdmacFileAioMgrNormalInit(PPDMACEPFILEMGR pAioMgr);
 void pdmacFileAioMgrNormalDestroy(PPDMACEPFILEMGR pAioMgr);
 
+int pdmacFileAioMgrIoQueueInit(PPDMACEPFILEMGR pAioMgr, bool fSqPoll);
+void pdmacFileAioMgrIoQueueDestroy(PPDMACEPFILEMGR pAioMgr);
+
 int pdmacFileAioMgrCreate(PPDMASYNCCOMPLETIONEPCLASSFILE pEpClass, PPPDMACEPFILEMGR ppAioMgr, PDMACEPFILEMGRTYPE enmMgrType);
 
 int pdmacFileAioMgrAddEndpoint(PPDMACEPFILEMGR pAioMgr, PPDMASYNCCOMPLETIONENDPOINTFILE pEndpoint);
@@ -192,6 +192,9 @@ typedef struct PDMASYNCCOMPLETIONEPCLASS
     R3PTRTYPE(PPDMASYNCCOMPLETIONENDPOINT)      pEndpointsHead;
     /** Head of the bandwidth managers for this class. */
     R3PTRTYPE(PPDMACBWMGR)                      pBwMgrsHead;
+    /** Critical section serializing the bandwidth accounting, which has to
+     * update a manager and all its ancestors atomically. */
+    RTCRITSECT                                  CritSectBw;
     /** Pointer to the callback table. */
     R3PTRTYPE(PCPDMASYNCCOMPLETIONEPCLASSOPS)   pEndpointOps;
     /** Task cache. */
@@ -109,6 +109,23 @@ typedef struct PDMBLKLRULIST
     uint32_t          cbCached;
 } PDMBLKLRULIST;
 
+/**
+ * Cache replacement policy.
+ */
+typedef enum PDMBLKCACHEPOLICY
+{
+    /** Invalid. */
+    PDMBLKCACHEPOLICY_INVALID = 0,
+    /** 2Q: Fixed size A1in, A1out (ghost) and Am lists. */
+    PDMBLKCACHEPOLICY_2Q,
+    /** ARC: Adaptive replacement cache.
+     * T1 (recently used), T2 (frequently used) and the B1 and B2 ghost lists,
+     * with the T1 target size adapting to ghost hits. */
+    PDMBLKCACHEPOLICY_ARC,
+    /** The usual 32-bit hack. */
+    PDMBLKCACHEPOLICY_32BIT_HACK = 0x7fffffff
+} PDMBLKCACHEPOLICY;
+
 /**
  * Global cache data.
  */
@@ -132,6 +149,19 @@ typedef struct PDMBLKCACHEGLOBAL
     PDMBLKLRULIST       LruRecentlyUsedOut;
     /** List of frequently used cache entries */
     PDMBLKLRULIST       LruFrequentlyUsed;
+    /** Ghost list of entries evicted from the frequently used list (ARC only). */
+    PDMBLKLRULIST       LruFrequentlyUsedOut;
+    /** The replacement policy. */
+    PDMBLKCACHEPOLICY   enmPolicy;
+    /** ARC: The adaptive target size of the recently used list in bytes. */
+    uint32_t            cbRecentlyUsedTarget;
+    /** Number of bytes a sequential stream must have read or written before the
+     * rest of it bypasses the cache, 0 if disabled. */
+    uint32_t            cbSeqThreshold;
+    /** Default minimum share of the cache for each user, in percent. */
+    uint8_t             uMinSharePct;
+    /** Default maximum share of the cache for each user, in percent. */
+    uint8_t             uMaxSharePct;
     /** Commit timeout in milli seconds */
     uint32_t            u32CommitTimeoutMs;
     /** Number of dirty bytes needed to start a commit of the data to the disk. */
@@ -188,6 +218,20 @@ typedef enum PDMBLKCACHETYPE
     PDMBLKCACHETYPE_USB
 } PDMBLKCACHETYPE;
 
+/** Number of sequential streams tracked per cache user. */
+#define PDMBLKCACHE_SEQ_STREAMS     4
+
+/**
+ * Sequential stream tracker.
+ */
+typedef struct PDMBLKCACHESEQSTREAM
+{
+    /** The offset the next request of the stream is expected at. */
+    uint64_t                offNext;
+    /** Number of bytes transferred by the stream so far. */
+    uint64_t                cbRun;
+} PDMBLKCACHESEQSTREAM, *PPDMBLKCACHESEQSTREAM;
+
 /**
  * Per user cache data.
  */
@@ -275,10 +319,41 @@ typedef struct PDMBLKCACHE
     /** Number of outstanding I/O transfers. */
     volatile uint32_t             cIoXfersActive;
 
+    /** @name Cache share.
+     * @note Protected by the global cache critical section.
+     * @{ */
+    /** Number of bytes this user has in the data carrying lists. */
+    uint32_t                      cbCached;
+    /** Minimum number of bytes, entries are not evicted for other users below this. */
+    uint32_t                      cbMinShare;
+    /** Maximum number of bytes, the user evicts its own entries beyond this. */
+    uint32_t                      cbMaxShare;
+    /** @} */
+
+    /** @name Sequential stream detection.
+     * @note Protected by LockList.
+     * @{ */
+    /** The index of the stream tracker to recycle next. */
+    uint32_t                      idxSeqStreamNext;
+    /** The stream trackers. */
+    PDMBLKCACHESEQSTREAM          aSeqStreams[PDMBLKCACHE_SEQ_STREAMS];
+    /** @} */
+
+    /** Stat: Requests completely served from the cache. */
+    STAMCOUNTER                   StatHits;
+    /** Stat: Requests partially served from the cache. */
+    STAMCOUNTER                   StatPartialHits;
+    /** Stat: Requests not served from the cache. */
+    STAMCOUNTER                   StatMisses;
+    /** Stat: Bytes of sequential streams passed by the cache. */
+    STAMCOUNTER                   StatSeqBypassed;
+    /** Stat: Bytes evicted to keep the user within its maximum share. */
+    STAMCOUNTER                   StatShareEvicted;
 } PDMBLKCACHE, *PPDMBLKCACHE;
 #ifdef VBOX_WITH_STATISTICS
 AssertCompileMemberAlignment(PDMBLKCACHE, StatWriteDeferred, sizeof(uint64_t));
 #endif
+AssertCompileMemberAlignment(PDMBLKCACHE, StatHits, sizeof(uint64_t));
 
 /**
  * I/O task.
@@ -97,6 +97,9 @@ RT_C_DECLS_BEGIN
 #define PDM_MAX_DEVICE_INSTANCE_SIZE_R3   _8M
 /** The maximum size for the DBGF tracing tracking structure allocated for each device. */
 #define PDM_MAX_DEVICE_DBGF_TRACING_TRACK HOST_PAGE_SIZE_DYNAMIC
+/** Device and driver constructors taking longer than this many nanoseconds
+ * are called out in the release log (startup timeline). */
+#define PDM_CONSTRUCT_SLOW_NS             RT_NS_10MS
 
 
 
@@ -230,6 +233,8 @@ typedef struct PDMDEVINSINTR3
     uint32_t                        uLastIrqTag;
     /** The ring-0 device index (for making ring-0 calls). */
     uint32_t                        idxR0Device;
+    /** Nanoseconds spent in the ring-3 constructor (startup timeline). */
+    uint64_t                        cNsConstruct;
 } PDMDEVINSINTR3;
 
 
@@ -424,9 +429,62 @@ typedef struct PDMDRVINSINT
     PFNPDMDRVREQHANDLERR0           pfnReqHandlerR0;
     /** Pointer to the next instance (starts at PDMDRV::pInstances). */
     R3PTRTYPE(PPDMDRVINS)           pNext;
+    /** Nanoseconds spent in the constructor (startup timeline). */
+    uint64_t                        cNsConstruct;
 } PDMDRVINSINT;
 
 
+/** The number of call sites tracked by a PDMCRITSECTPROF. */
+#define PDMCRITSECTPROF_MAX_CALLERS         16
+
+/**
+ * A call site in a critical section contention profile.
+ */
+typedef struct PDMCRITSECTPROFCALLER
+{
+    /** The return address of the enter call, 0 if the entry is unused. */
+    uint64_t volatile               uCaller;
+    /** Number of times this call site had to wait for the section. */
+    uint64_t volatile               cWaits;
+    /** Nanoseconds this call site spent waiting for the section. */
+    uint64_t volatile               cNsWaited;
+    /** Number of times someone had to wait while this call site owned the
+     * section. */
+    uint64_t volatile               cBlocked;
+} PDMCRITSECTPROFCALLER;
+/** Pointer to a critical section contention profile call site. */
+typedef PDMCRITSECTPROFCALLER *PPDMCRITSECTPROFCALLER;
+
+/**
+ * Opt-in contention profile of a critical section.
+ *
+ * This is allocated from the ring-3 heap for sections matching the
+ * /PDM/CritSectProfiling pattern and is only updated in ring-3.  The ring-0
+ * contention is still covered by the StatContentionRZ* counters.
+ */
+typedef struct PDMCRITSECTPROF
+{
+    /** Time spent waiting for (exclusive) ownership, in nanoseconds. */
+    STAMHISTOGRAM                   WaitHist;
+    /** Time spent waiting for shared ownership, in nanoseconds.  Only used by
+     * read/write sections. */
+    STAMHISTOGRAM                   WaitSharedHist;
+    /** Time the section was (exclusively) owned, in nanoseconds. */
+    STAMHISTOGRAM                   HoldHist;
+    /** RTTimeNanoTS when the current owner entered the section, 0 if not owned
+     * or entered outside ring-3. */
+    uint64_t                        nsEntered;
+    /** The call site of the current owner, 0 if unknown. */
+    uint64_t volatile               uOwnerCaller;
+    /** Waits that didn't fit in aCallers. */
+    uint64_t volatile               cWaitsOther;
+    /** The call sites, unsorted. */
+    PDMCRITSECTPROFCALLER           aCallers[PDMCRITSECTPROF_MAX_CALLERS];
+} PDMCRITSECTPROF;
+/** Pointer to a critical section contention profile. */
+typedef PDMCRITSECTPROF *PPDMCRITSECTPROF;
+
+
 /**
  * Private critical section data.
  */
@@ -471,6 +529,8 @@ typedef struct PDMCRITSECTINT
     STAMPROFILE                     StatContentionR3Wait;
     /** Profiling the time the section is locked. */
     STAMPROFILEADV                  StatLocked;
+    /** The contention profile, NULL if not profiled. */
+    R3PTRTYPE(PPDMCRITSECTPROF)     pProfR3;
 } PDMCRITSECTINT;
 AssertCompileMemberAlignment(PDMCRITSECTINT, StatContentionRZLock, 8);
 /** Pointer to private critical section data. */
@@ -532,6 +592,8 @@ typedef struct PDMCRITSECTRWINT
     STAMCOUNTER                         StatR3EnterShared;
     /** Profiling the time the section is write locked. */
     STAMPROFILEADV                      StatWriteLocked;
+    /** The contention profile, NULL if not profiled. */
+    R3PTRTYPE(PPDMCRITSECTPROF)         pProfR3;
 } PDMCRITSECTRWINT;
 AssertCompileMemberAlignment(PDMCRITSECTRWINT, StatContentionRZEnterExcl, 8);
 AssertCompileMemberAlignment(PDMCRITSECTRWINT, Core.u, 16);
@@ -580,9 +642,40 @@ typedef struct PDMTHREADINT
     R3PTRTYPE(struct PDMTHREAD *)   pNext;
     /** The thread type. */
     PDMTHREADTYPE                   enmType;
+    /** The index of the thread within its I/O thread group. */
+    uint32_t                        iIoThread;
+    /** The I/O thread group the thread belongs to, NULL if none. */
+    R3PTRTYPE(struct PDMIOTHREADGROUP *) pIoThreadGroup;
 } PDMTHREADINT;
 
 
+/**
+ * PDM I/O thread group.
+ *
+ * Places the worker threads of the devices assigned to it on a set of host
+ * CPUs, typically ones not used by the EMTs.  Configured under /PDM/IoThreads/
+ * and assigned using the IoThreads key of the device instance node.
+ */
+typedef struct PDMIOTHREADGROUP
+{
+    /** Pointer to the next group. */
+    R3PTRTYPE(struct PDMIOTHREADGROUP *) pNext;
+    /** The host CPUs the threads of the group run on. */
+    RTCPUSET                        CpuSet;
+    /** Number of CPUs in CpuSet. */
+    uint32_t                        cCpus;
+    /** Number of threads placed in the group so far. */
+    uint32_t volatile               cThreads;
+    /** Whether each thread is bound to a single CPU of the set, round robin,
+     * instead of floating over the whole set. */
+    bool                            fSpread;
+    /** The group name. */
+    char                            szName[RT_FLEXIBLE_ARRAY];
+} PDMIOTHREADGROUP;
+/** Pointer to an I/O thread group. */
+typedef PDMIOTHREADGROUP *PPDMIOTHREADGROUP;
+
+
 
 /* Must be included after PDMDEVINSINT is defined. */
 #define PDMDEVINSINT_DECLARED
@@ -1119,7 +1212,8 @@ typedef struct PDMQUEUE
 
     /** This is VINF_SUCCESS if the queue is okay, error status if not. */
     int32_t                 rcOkay;
-    uint32_t                u32Padding;
+    /** Queue flags (PDMQUEUE_F_XXX). */
+    uint32_t                fFlags;
 
     /** Queue type. */
     PDMQUEUETYPE            enmType;
@@ -1183,13 +1277,36 @@ typedef struct PDMQUEUE
     STAMCOUNTER                     StatFlushLeftovers;
     /** State: Profiling the flushing. */
     STAMPROFILE                     StatFlushPrf;
-    uint64_t                        au64Padding[3];
-
-    /** Allocation bitmap: Set bits means free, clear means allocated. */
+    /** The consumer task (PDMQUEUE_F_CONSUMER_THREAD), NIL_PDMTASKHANDLE if the
+     * queue is flushed by the EMTs. */
+    PDMTASKHANDLE                   hConsumerTask;
+    /** Stat: Ring depth seen by each flush (PDMQUEUE_F_RING). */
+    STAMPROFILE                     StatRingDepth;
+    /** Stat: Insert to flush latency in nanoseconds (PDMQUEUE_F_RING). */
+    STAMHISTOGRAM                   StatRingLatency;
+    uint64_t                        au64Padding[6];
+
+    /** The ring producer position (PDMQUEUE_F_RING).
+     * This is the position of the next slot to allocate, advanced by the
+     * producers using compare and exchange. */
+    uint64_t volatile               uRingProducer;
+    uint64_t                        au64Padding2[7];
+    /** The ring consumer position (PDMQUEUE_F_RING).
+     * This is the position of the next slot to flush and is only written by the
+     * consumer. */
+    uint64_t volatile               uRingConsumer;
+    uint64_t                        au64Padding3[7];
+
+    /** Allocation bitmap: Set bits means free, clear means allocated.
+     * For PDMQUEUE_F_RING queues this is instead an array of cItems insert
+     * timestamps (RTTimeNanoTS), PDMQUEUE_RING_TS_FREED for items given back
+     * by PDMQueueFree. */
     RT_FLEXIBLE_ARRAY_EXTENSION
     uint64_t                        bmAlloc[RT_FLEXIBLE_ARRAY];
     /* The items follows after the end of the bitmap */
 } PDMQUEUE;
+AssertCompileMemberAlignment(PDMQUEUE, uRingProducer, 64);
+AssertCompileMemberAlignment(PDMQUEUE, uRingConsumer, 64);
 AssertCompileMemberAlignment(PDMQUEUE, bmAlloc, 64);
 /** Pointer to a PDM Queue. */
 typedef struct PDMQUEUE *PPDMQUEUE;
@@ -1199,6 +1316,46 @@ typedef struct PDMQUEUE *PPDMQUEUE;
 /** Magic value PDMQUEUE::u32Magic after destroy. */
 #define PDMQUEUE_MAGIC_DEAD         UINT32_C(0x19660731)
 
+/** @name PDMQUEUE_F_XXX - Queue flags.
+ * @{ */
+/** Lock-free multi-producer, single-consumer ring instead of the allocation
+ * bitmap and the pending LIFO.
+ *
+ * Each slot is claimed by advancing PDMQUEUE::uRingProducer and the
+ * PDMQUEUEITEMCORE::u64View member of the slot carries a sequence number that
+ * tells the producers and the consumer who owns it: It is the position when
+ * the slot is free, the position plus one once the item has been inserted, and
+ * it is moved on by cItems when the consumer is done with it.  Items are
+ * flushed in FIFO order and the flush needs neither the LIFO reversal nor any
+ * atomic operation per item. */
+#define PDMQUEUE_F_RING             RT_BIT_32(0)
+/** Flush the queue on a PDM task thread instead of setting VM_FF_PDM_QUEUES.
+ * The consumer callback is then called on that thread and not on an EMT. */
+#define PDMQUEUE_F_CONSUMER_THREAD  RT_BIT_32(1)
+/** Valid flags. */
+#define PDMQUEUE_F_VALID_MASK       UINT32_C(0x00000003)
+/** @} */
+
+/** The insert timestamp of a PDMQUEUE_F_RING slot that was freed by
+ * PDMQueueFree instead of being inserted.  The slot is published like an
+ * inserted item so the consumer can get past it, but it is skipped. */
+#define PDMQUEUE_RING_TS_FREED      UINT64_MAX
+
+/**
+ * Calculates the size of the area between the queue structure and the items.
+ *
+ * This is the allocation bitmap, or the timestamp array for ring queues.  It
+ * is padded to a cache line.
+ *
+ * @returns Size in bytes.
+ * @param   cItems      Number of queue items.
+ * @param   fFlags      PDMQUEUE_F_XXX.
+ */
+#define PDMQUEUE_CALC_BITMAP_SIZE(cItems, fFlags) \
+    ( (fFlags) & PDMQUEUE_F_RING \
+      ? RT_ALIGN_32((uint32_t)(cItems) * (uint32_t)sizeof(uint64_t), 64) \
+      : RT_ALIGN_32(RT_ALIGN_32((cItems), 64) / 8, 64) /* keep bitmap in it's own cacheline */ )
+
 /** @name PDM::fQueueFlushing
  * @{ */
 /** Used to make sure only one EMT will flush the queues.
@@ -1232,7 +1389,8 @@ typedef struct PDMQUEUER0
     uint32_t                cItems;
     /** Offset of the the queue items relative to the PDMQUEUE structure. */
     uint32_t                offItems;
-    uint32_t                u32Reserved;
+    /** Queue flags (PDMQUEUE_F_XXX), the trusted copy. */
+    uint32_t                fFlags;
 } PDMQUEUER0;
 
 
@@ -1341,8 +1499,25 @@ typedef struct PDMNSBWGROUP
     volatile uint64_t                           tsUpdatedLast;
     /** Number of times a filter was choked. */
     volatile uint64_t                           cTotalChokings;
-    /** Pad the structure to a multiple of 64 bytes. */
-    uint64_t                                    au64Padding[1];
+    /** The parent group index + 1, zero if this is a root group.
+     * Traffic must be granted by this group and all its ancestors. */
+    uint32_t                                    iParent;
+    /** Configured burst size in bytes, zero for the default derived from
+     * cbPerSecMax and PDM_NETSHAPER_MAX_LATENCY. */
+    uint32_t                                    cbBurst;
+    /** Maximum number of packets per second, zero if not limited. */
+    volatile uint32_t                           cPacketsPerSecMax;
+    /** Packet bucket size in milli-packets. */
+    volatile uint32_t                           cMilliPktBucket;
+    /** Number of milli-packets we were allowed to transfer at the last update. */
+    volatile uint32_t                           cMilliPktTokensLast;
+    uint32_t                                    uPadding2;
+    /** Number of bytes granted. */
+    volatile uint64_t                           cbTotalTransferred;
+    /** Number of packets granted. */
+    volatile uint64_t                           cTotalPackets;
+    /** Time filters of this group spent choked. */
+    STAMPROFILE                                 StatChokeLatency;
 } PDMNSBWGROUP;
 AssertCompileSizeAlignment(PDMNSBWGROUP, 64);
 /** Pointer to a bandwidth group. */
@@ -1742,10 +1917,17 @@ typedef struct PDMUSERPERVM
     R3PTRTYPE(PPDMCRITSECTINT)      pCritSects;
     /** List of initialized read/write critical sections. (LIFO) */
     R3PTRTYPE(PPDMCRITSECTRWINT)    pRwCritSects;
+    /** Name pattern of the critical sections to profile (/PDM/CritSectProfiling),
+     * NULL if profiling is disabled. */
+    R3PTRTYPE(char *)               pszCritSectProfPattern;
     /** Head of the PDM Thread list. (singly linked) */
     R3PTRTYPE(PPDMTHREAD)           pThreads;
     /** Tail of the PDM Thread list. (singly linked) */
     R3PTRTYPE(PPDMTHREAD)           pThreadsTail;
+    /** Head of the I/O thread groups (read-only after init). */
+    R3PTRTYPE(struct PDMIOTHREADGROUP *) pIoThreadGroups;
+    /** Head of the device guest physical mapping caches. (singly linked) */
+    R3PTRTYPE(struct PDMPHYSMAPCACHE *) pPhysMapCaches;
 
     /** @name   PDM Async Completion
      * @{ */
@@ -1862,6 +2044,10 @@ int         pdmR3CritSectRwInitDeviceAuto(  PVM pVM, PPDMDEVINS pDevIns, PPDMCRI
                                             const char *pszNameFmt, ...);
 int         pdmR3CritSectRwInitDriver(      PVM pVM, PPDMDRVINS pDrvIns, PPDMCRITSECTRW pCritSect, RT_SRC_POS_DECL,
                                             const char *pszNameFmt, ...);
+void        pdmR3CritSectProfEntered(PPDMCRITSECTPROF pProf, PCRTLOCKVALSRCPOS pSrcPos);
+void        pdmR3CritSectProfLeaving(PPDMCRITSECTPROF pProf);
+void        pdmR3CritSectProfWaited(PPDMCRITSECTPROF pProf, PSTAMHISTOGRAM pHist, PCRTLOCKVALSRCPOS pSrcPos,
+                                    uint64_t uOwnerCaller, uint64_t nsWaitStart);
 
 int         pdmR3DevInit(PVM pVM);
 int         pdmR3DevInitComplete(PVM pVM);
@@ -1888,7 +2074,7 @@ char       *pdmR3FileR3(const char *pszFile, bool fShared);
 int         pdmR3LoadR3U(PUVM pUVM, const char *pszFilename, const char *pszName);
 #endif /* IN_RING3 */
 
-void        pdmQueueInit(PPDMQUEUE pQueue, uint32_t cbBitmap, uint32_t cbItem, uint32_t cItems,
+void        pdmQueueInit(PPDMQUEUE pQueue, uint32_t cbBitmap, uint32_t cbItem, uint32_t cItems, uint32_t fFlags,
                          const char *pszName, PDMQUEUETYPE enmType, RTR3PTR pfnCallback, RTR3PTR pvOwner);
 
 #ifdef IN_RING3
@@ -1905,6 +2091,14 @@ int         pdmR3ThreadDestroyDevice(PVM pVM, PPDMDEVINS pDevIns);
 int         pdmR3ThreadDestroyUsb(PVM pVM, PPDMUSBINS pUsbIns);
 int         pdmR3ThreadDestroyDriver(PVM pVM, PPDMDRVINS pDrvIns);
 void        pdmR3ThreadDestroyAll(PVM pVM);
+int         pdmR3IoThreadGroupsInit(PVM pVM);
+void        pdmR3IoThreadGroupsTerm(PVM pVM);
+int         pdmR3PhysMapCacheCreate(PVM pVM, PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t cEntries, const char *pszName,
+                                    PPDMPHYSMAPCACHE *ppCache);
+int         pdmR3PhysMapCacheDestroy(PVM pVM, PPDMDEVINS pDevIns, PPDMPHYSMAPCACHE pCache);
+void        pdmR3PhysMapCacheDestroyDevice(PVM pVM, PPDMDEVINS pDevIns);
+void        pdmR3PhysMapCacheFlush(PVM pVM, PPDMPHYSMAPCACHE pCache);
+int         pdmR3PhysMapCacheMap(PVM pVM, PPDMPHYSMAPCACHE pCache, RTGCPHYS GCPhys, bool fWrite, void **ppv);
 int         pdmR3ThreadResumeAll(PVM pVM);
 int         pdmR3ThreadSuspendAll(PVM pVM);
 
@@ -1982,6 +2176,8 @@ DECL_HIDDEN_CALLBACK(int)  pdmR3DevHlpTracing_PCIPhysRead(PPDMDEVINS pDevIns, PP
 DECL_HIDDEN_CALLBACK(int)  pdmR3DevHlpTracing_PCIPhysWrite(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, RTGCPHYS GCPhys, const void *pvBuf, size_t cbWrite, uint32_t fFlags);
 DECL_HIDDEN_CALLBACK(void) pdmR3DevHlpTracing_PCISetIrq(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, int iIrq, int iLevel);
 DECL_HIDDEN_CALLBACK(void) pdmR3DevHlpTracing_PCISetIrqNoWait(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, int iIrq, int iLevel);
+DECL_HIDDEN_CALLBACK(void) pdmR3DevHlpTracing_PCISetIrqMulti(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs,
+                                                             uint32_t cIrqs, int iLevel);
 DECL_HIDDEN_CALLBACK(void) pdmR3DevHlpTracing_ISASetIrq(PPDMDEVINS pDevIns, int iIrq, int iLevel);
 DECL_HIDDEN_CALLBACK(void) pdmR3DevHlpTracing_ISASetIrqNoWait(PPDMDEVINS pDevIns, int iIrq, int iLevel);
 # elif defined(IN_RING0)
@@ -1997,6 +2193,8 @@ DECL_HIDDEN_CALLBACK(int)  pdmR0DevHlpTracing_PCIPhysRead(PPDMDEVINS pDevIns, PP
 DECL_HIDDEN_CALLBACK(int)  pdmR0DevHlpTracing_PCIPhysWrite(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, RTGCPHYS GCPhys, const void *pvBuf, size_t cbWrite, uint32_t fFlags);
 DECL_HIDDEN_CALLBACK(void) pdmR0DevHlpTracing_PCISetIrq(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, int iIrq, int iLevel);
 DECL_HIDDEN_CALLBACK(void) pdmR0DevHlpTracing_PCISetIrqNoWait(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, int iIrq, int iLevel);
+DECL_HIDDEN_CALLBACK(void) pdmR0DevHlpTracing_PCISetIrqMulti(PPDMDEVINS pDevIns, PPDMPCIDEV pPciDev, uint32_t const *pbmIrqs,
+                                                             uint32_t cIrqs, int iLevel);
 DECL_HIDDEN_CALLBACK(void) pdmR0DevHlpTracing_ISASetIrq(PPDMDEVINS pDevIns, int iIrq, int iLevel);
 DECL_HIDDEN_CALLBACK(void) pdmR0DevHlpTracing_ISASetIrqNoWait(PPDMDEVINS pDevIns, int iIrq, int iLevel);
 # else
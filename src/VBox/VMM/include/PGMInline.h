@@ -1092,7 +1092,8 @@ DECLINLINE(PX86PML4E) pgmShwGetLongModePML4EPtr(PVMCPUCC pVCpu, unsigned int iPm
  */
 DECLINLINE(int) pgmHandlerPhysicalLookup(PVMCC pVM, RTGCPHYS GCPhys, PPGMPHYSHANDLER *ppHandler)
 {
-    PPGMPHYSHANDLER pHandler = pVM->VMCC_CTX(pgm).s.PhysHandlerAllocator.ptrFromInt(pVM->pgm.s.idxLastPhysHandler);
+    uint32_t const  idxCache = PGM_PHYS_HANDLER_CACHE_IDX(GCPhys);
+    PPGMPHYSHANDLER pHandler = pVM->VMCC_CTX(pgm).s.PhysHandlerAllocator.ptrFromInt(pVM->pgm.s.aidxPhysHandlerCache[idxCache]);
     if (   pHandler
         && pVM->VMCC_CTX(pgm).s.PhysHandlerAllocator.isPtrRetOkay(pHandler)
         && GCPhys >= pHandler->Key
@@ -1112,7 +1113,7 @@ DECLINLINE(int) pgmHandlerPhysicalLookup(PVMCC pVM, RTGCPHYS GCPhys, PPGMPHYSHAN
     if (RT_SUCCESS(rc))
     {
         *ppHandler = pHandler;
-        pVM->pgm.s.idxLastPhysHandler = pVM->VMCC_CTX(pgm).s.PhysHandlerAllocator.ptrToInt(pHandler);
+        pVM->pgm.s.aidxPhysHandlerCache[idxCache] = pVM->VMCC_CTX(pgm).s.PhysHandlerAllocator.ptrToInt(pHandler);
         return VINF_SUCCESS;
     }
     *ppHandler = NULL;
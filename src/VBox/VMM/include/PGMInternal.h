@@ -118,6 +118,10 @@
  * @note This can be increased to 4096 (at least when targeting x86). */
 #define PGM_MAX_RAM_RANGES              3072
 
+/** The suffix appended to the saved state filename to form the name of the
+ * page aligned RAM side file (see PGM_STATE_REC_RAM_FILE). */
+#define PGM_SAVED_STATE_RAM_FILE_SUFFIX ".ram"
+
 /** Maximum pages per RAM range.
  *
  * The PGMRAMRANGE structures for the high memory can get very big. There
@@ -667,6 +671,16 @@ typedef RTCHardAvlRangeTree<PGMPHYSHANDLER, RTGCPHYS> PGMPHYSHANDLERTREE;
 /** Pointer to a physical access handler tree. */
 typedef PGMPHYSHANDLERTREE                           *PPGMPHYSHANDLERTREE;
 
+/** Number of entries in the physical access handler lookup cache
+ * (PGM::aidxPhysHandlerCache).  Must be a power of two. */
+#define PGM_PHYS_HANDLER_CACHE_ENTRIES  8
+/** Calculates the physical access handler lookup cache index for a given
+ * guest physical address.  Adjacent pages map to different entries so that
+ * guests hammering several small MMIO BARs or ROM shadows in turn don't keep
+ * evicting each other. */
+#define PGM_PHYS_HANDLER_CACHE_IDX(a_GCPhys) \
+    ((uint32_t)((a_GCPhys) >> GUEST_PAGE_SHIFT) & (PGM_PHYS_HANDLER_CACHE_ENTRIES - 1))
+
 
 /**
  * A Physical Guest Page tracking structure.
@@ -2052,6 +2066,10 @@ typedef enum
     PGMPOOLACCESS_SUPERVISOR_R_NX
 } PGMPOOLACCESS;
 
+/** The number of age list entries pgmPoolCacheFreeOne looks at when trying to
+ * find a leaf page table to evict instead of a non-leaf age list tail. */
+#define PGMPOOL_CACHE_FREE_LEAF_SCAN    16
+
 /**
  * The tracking data for a page in the pool.
  */
@@ -2348,6 +2366,14 @@ typedef struct PGMPOOL
     STAMCOUNTER                 StatCacheCacheable;
     /** The number of uncacheable allocations. */
     STAMCOUNTER                 StatCacheUncacheable;
+    /** Number of times pgmPoolCacheFreeOne passed over a non-leaf age list tail
+     *  in favour of a leaf page table. */
+    STAMCOUNTER                 StatCacheFreeUpOneLeaf;
+    /** Number of times pgmPoolCacheFreeOne had to evict a non-leaf table
+     *  (page directory and above), taking its children along. */
+    STAMCOUNTER                 StatCacheFreeUpOneNonLeaf;
+    /** Number of pages currently in use, per PGMPOOLKIND. */
+    uint16_t                    acPagesPerKind[RT_ALIGN_32(PGMPOOLKIND_LAST + 1, 4)];
 #else
     uint32_t                    Alignment3;         /**< Align the next member on a 64-bit boundary. */
 #endif
@@ -3168,10 +3194,16 @@ typedef struct PGM
 #endif
     /** The pointer to the ring-3 mapping of the physical access handler tree. */
     R3PTRTYPE(PPGMPHYSHANDLERTREE)  pPhysHandlerTree;
-    /** Caching the last physical handler we looked. */
-    uint32_t                        idxLastPhysHandler;
-
-    uint32_t                        au32Padding3[9];
+    /** Direct mapped cache of recently looked up physical handlers (allocator
+     * indexes, 0 if unused), indexed by PGM_PHYS_HANDLER_CACHE_IDX(GCPhys).
+     * Entries are validated against the handler range on use. */
+    uint32_t                        aidxPhysHandlerCache[PGM_PHYS_HANDLER_CACHE_ENTRIES];
+
+    /** The page mapping generation, incremented whenever the page map TLBs are
+     * (partially) invalidated.  Used by PDM to validate device mapping caches.
+     * @sa PGMR3PhysGetMapGenerationPtr */
+    uint32_t volatile               uPhysMapGen;
+    uint32_t                        u32Padding3;
 #ifdef VBOX_WITH_ONLY_PGM_NEM_MODE
     uint64_t                        au64Padding4[3];
 #endif
@@ -3240,7 +3272,16 @@ typedef struct PGM
     uint64_t                        nsLargePageRetry;
     /** Number of repeated long allocation times.   */
     uint32_t                        cLargePageLongAllocRepeats;
-    uint32_t                        uPadding4;
+    /** @cfgm{/PGM/LargePagePrealloc, boolean, false}
+     * Whether to back all suitable guest RAM with large pages up front. */
+    bool                            fLargePagePrealloc;
+    /** @cfgm{/PGM/LargePageRequired, boolean, false}
+     * Whether large pages are a hard requirement, failing VM creation instead
+     * of falling back to small pages when preallocating. */
+    bool                            fLargePageRequired;
+    /** Set once a fallback to small pages has been logged. */
+    bool                            fLargePageFallbackLogged;
+    bool                            fPadding4;
 
     /**
      * Live save data.
@@ -3265,8 +3306,12 @@ typedef struct PGM
         uint32_t                    cIgnoredPages;
         /** Indicates that a live save operation is active. */
         bool                        fActive;
-        /** Padding. */
-        bool                        afReserved[2];
+        /** Set if NEM dirty page logging is used for catching guest writes to
+         * write monitored RAM pages (see NEMR3PhysRamDirtyTracking). */
+        bool                        fNemDirtyLog;
+        /** Whether to throttle the vCPUs when the guest dirties memory faster than
+         * we can save it (/PGM/LiveSave/AutoConverge). */
+        bool                        fAutoConverge;
         /** The next history index. */
         uint8_t                     iDirtyPagesHistory;
         /** History of the total amount of dirty pages. */
@@ -3284,7 +3329,15 @@ typedef struct PGM
         uint64_t                    uSaveStartNS;
         /** Pages per second (for statistics). */
         uint32_t                    cPagesPerSecond;
-        uint32_t                    cAlignment;
+        /** The CPU execution cap imposed by auto-converge, 0 if not throttling. */
+        uint8_t                     uThrottleCap;
+        /** The lowest execution cap auto-converge may impose
+         * (/PGM/LiveSave/AutoConvergeMinCap). */
+        uint8_t                     uThrottleMinCap;
+        /** The CPU execution cap to restore when done throttling. */
+        uint8_t                     uOrgCpuExecutionCap;
+        /** Passes since auto-converge last changed the execution cap. */
+        uint8_t                     cPassesSinceThrottle;
     } LiveSave;
 
     /** @name   Error injection.
@@ -3296,6 +3349,86 @@ typedef struct PGM
     bool                            afReserved[3];
     /** @} */
 
+    /** @name Background duplicate page scanner.
+     * @{ */
+    /** The timer kicking off scanner runs, NIL_TMTIMERHANDLE if disabled. */
+    TMTIMERHANDLE                   hPageScanTimer;
+    /** @cfgm{/PGM/PageScan/IntervalMs, uint32_t, 100}
+     * The interval between scanner runs in milliseconds. */
+    uint32_t                        cMsPageScanInterval;
+    /** The number of pages to look at per scanner run, derived from
+     * @cfgm{/PGM/PageScan/PagesPerSecond, uint32_t, 8192}. */
+    uint32_t                        cPageScanPagesPerRun;
+    /** The RAM range ID to continue scanning at. */
+    uint32_t                        idPageScanRamRange;
+    /** The page index to continue scanning at. */
+    uint32_t                        iPageScanPage;
+    /** The number of pages left to scan at full speed after restoring a saved
+     * state, 0 if not bursting. */
+    uint32_t                        cPageScanBurstLeft;
+    /** @cfgm{/PGM/PageScan/RestoreBurst, bool, false}
+     * Whether to do a full speed pass over guest RAM after restoring a state. */
+    bool                            fPageScanRestoreBurst;
+    /** Padding. */
+    bool                            afPageScanPadding[3];
+    /** @} */
+
+    /** @name Page aligned saved state RAM side file and lazy restore.
+     * @{ */
+    /** The lazy restore state, NULL if not restoring from a RAM side file
+     * (ring-3 only, see PGMR3Phys.cpp). */
+    R3PTRTYPE(struct PGMLAZYRESTORE *) pLazyRestoreR3;
+    /** Physical access handler type for RAM pages not yet read back from the
+     * side file. */
+    PGMPHYSHANDLERTYPE              hLazyRestorePhysHandlerType;
+    /** The timer kicking off background prefetching of lazily restored pages. */
+    TMTIMERHANDLE                   hLazyRestoreTimer;
+    /** @cfgm{/PGM/LazyRestore/PrefetchPages, uint32_t, 1024}
+     * The number of pages to prefetch per timer tick, 0 for demand only. */
+    uint32_t                        cLazyRestorePrefetchPages;
+    /** @cfgm{/PGM/LazyRestore/PrefetchIntervalMs, uint32_t, 10}
+     * The interval between prefetch runs. */
+    uint32_t                        cMsLazyRestorePrefetchInterval;
+    /** @cfgm{/PGM/SaveRamToSideFile, bool, false}
+     * Whether a plain (non-live) save puts RAM pages in a side file. */
+    bool                            fSaveRamToSideFile;
+    /** @cfgm{/PGM/LazyRestore/Enabled, bool, true}
+     * Whether to read side file pages on demand instead of at load time. */
+    bool                            fLazyRestore;
+    /** Whether the final pass of the next live save should leave the dirty RAM
+     * pages for the target to fetch (post-copy teleportation). */
+    bool                            fPostCopySave;
+    /** @cfgm{/PGM/IncrementalSave, bool, false}
+     * Whether plain saves with a RAM side file only write the pages changed
+     * since the previous save, referencing its side file for the rest. */
+    bool                            fIncrementalSave;
+    /** @cfgm{/PGM/IncrementalSaveMaxDepth, uint8_t, 2, 32, 8}
+     * The max length of the side file chain of an incremental save. */
+    uint8_t                         cIncrementalSaveMaxDepth;
+    /** @cfgm{/PGM/LiveSaveRamBackground, bool, false}
+     * Whether the final pass of a live save to a file puts the dirty RAM pages
+     * in a side file written by a background thread after the VM resumed. */
+    bool                            fLiveSaveRamBackground;
+    /** Padding. */
+    bool                            afLazyRestorePadding[2];
+    /** The post-copy page fetcher for the next state load, NULL if none.  Passed
+     * on to the lazy restore state by the first PGM_STATE_REC_RAM_FILE record. */
+    R3PTRTYPE(PFNPGMPOSTCOPYFETCH)  pfnPostCopyFetchR3;
+    /** The user argument of pfnPostCopyFetchR3. */
+    RTR3PTR                         pvPostCopyUserR3;
+    /** Page checksums and side file chain of the last save made with
+     * fIncrementalSave, NULL if none (ring-3 only, see PGMR3SavedState.cpp). */
+    R3PTRTYPE(struct PGMINCRSAVE *) pIncrSaveR3;
+    /** The tracking for the save in progress, installed as pIncrSaveR3 by
+     * pgmR3SaveDone if the save succeeds. */
+    R3PTRTYPE(struct PGMINCRSAVE *) pIncrSavePendingR3;
+    /** The ancestor side files of the incremental state being loaded. */
+    R3PTRTYPE(struct PGMINCRLOAD *) pIncrLoadR3;
+    /** The background side file writer of the last live save, NULL if none
+     * (ring-3 only, see PGMR3SavedState.cpp). */
+    R3PTRTYPE(struct PGMSAVEBGWRITER *) pSaveBgWriterR3;
+    /** @} */
+
     /** @name Release Statistics
      * @{ */
     uint32_t                        cAllPages;              /**< The total number of pages. (Should be Private + Shared + Zero + Pure MMIO.) */
@@ -3325,8 +3458,17 @@ typedef struct PGM
     STAMCOUNTER                     StatLargePageRecheck;   /**< The number of times we rechecked a disabled large page.*/
     STAMCOUNTER                     StatLargePageTlbFlush;  /**< The number of a full VCPU TLB flush was required after allocation. */
     STAMCOUNTER                     StatLargePageZeroEvict; /**< The number of zero page mappings we had to evict when allocating a large page. */
+    STAMCOUNTER                     StatLargePageFallback;  /**< The number of 2 MB regions backed by small pages after a failed large page allocation. */
+    STAMCOUNTER                     StatLargePagePrealloc;  /**< The number of large pages allocated by the preallocation pass. */
 
     STAMPROFILE                     StatShModCheck;         /**< Profiles shared module checks. */
+    STAMPROFILE                     StatPageScan;           /**< Profiles duplicate page scanner runs. */
+    STAMCOUNTER                     StatPageScanScanned;    /**< Pages looked at by the duplicate page scanner. */
+    STAMCOUNTER                     StatPageScanMerged;     /**< Pages replaced by an existing shared page. */
+    STAMCOUNTER                     StatPageScanShared;     /**< Pages converted into new shared pages. */
+    STAMCOUNTER                     StatPageScanZero;       /**< Merged or converted pages that were all zeros. */
+    STAMCOUNTER                     StatPageScanPasses;     /**< Complete passes over guest RAM. */
+    STAMCOUNTER                     StatSharedPageBroken;   /**< Shared pages replaced by a private copy on write. */
 
     STAMPROFILE                     StatMmio2QueryAndResetDirtyBitmap; /**< Profiling PGMR3PhysMmio2QueryAndResetDirtyBitmap. */
     /** @} */
@@ -3950,6 +4092,10 @@ DECLCALLBACK(FNPGMRZPHYSPFHANDLER)  pgmR0HandlerPhysicalPfHandlerToRing3;
 #endif
 
 int             pgmR3InitSavedState(PVM pVM, uint64_t cbRam);
+void            pgmR3TermSavedState(PVM pVM);
+int             pgmR3SaveBgWriterWait(PVM pVM);
+void            pgmR3ScanWriteMonitoredRamPage(PVM pVM, PPGMRAMRANGE pCur, PPGMLIVESAVERAMPAGE paLSPages, uint32_t iPage,
+                                               bool fNemDirty);
 
 int             pgmPhysAllocPage(PVMCC pVM, PPGMPAGE pPage, RTGCPHYS GCPhys);
 int             pgmPhysAllocLargePage(PVMCC pVM, RTGCPHYS GCPhys);
@@ -4014,6 +4160,7 @@ DECLHIDDEN(void)            pgmPhysSetNemStateForPages(PPGMPAGE paPages, RTGCPHY
 #ifdef IN_RING3
 # ifndef VBOX_WITH_ONLY_PGM_NEM_MODE
 int             pgmR3PhysRamPreAllocate(PVM pVM);
+int             pgmR3PhysLargePagePreAllocate(PVM pVM);
 # endif
 int             pgmR3PhysRamReset(PVM pVM);
 int             pgmR3PhysRomReset(PVM pVM);
@@ -4022,6 +4169,15 @@ int             pgmR3PhysChunkMap(PVM pVM, uint32_t idChunk, PPPGMCHUNKR3MAP ppC
 int             pgmR3PhysRamTerm(PVM pVM);
 void            pgmR3PhysRomTerm(PVM pVM);
 void            pgmR3PhysAssertSharedPageChecksums(PVM pVM);
+int             pgmR3PhysLazyRestoreInit(PVM pVM);
+int             pgmR3PhysLazyRestoreAddPage(PVM pVM, PSSMHANDLE pSSM, PPGMRAMRANGE pRam, PPGMPAGE pPage, RTGCPHYS GCPhys);
+int             pgmR3PhysLazyRestoreArm(PVM pVM);
+int             pgmR3PhysLazyRestoreFlush(PVM pVM);
+void            pgmR3PhysLazyRestoreTerm(PVM pVM, bool fTerm);
+#ifdef VBOX_WITH_PAGE_SHARING
+int             pgmR3PageScanInit(PVM pVM);
+void            pgmR3PageScanStateLoaded(PVM pVM);
+#endif
 
 # ifndef VBOX_WITH_ONLY_PGM_NEM_MODE
 int             pgmR3PoolInit(PVM pVM);
@@ -137,6 +137,8 @@ typedef struct STAMDESC
         PSTAMPROFILE    pProfile;
         /** Advanced profile. */
         PSTAMPROFILEADV pProfileAdv;
+        /** Histogram. */
+        PSTAMHISTOGRAM  pHistogram;
         /** Ratio, unsigned 32-bit. */
         PSTAMRATIOU32   pRatioU32;
         /** unsigned 8-bit. */
@@ -185,14 +187,17 @@ typedef struct STAMUSERPERVM
 
     /** RW Lock for the list and tree. */
     RTSEMRW                 RWSem;
+    /** The shared memory export, NULL if not configured. */
+    struct STAMSHMEXPORT   *pShmExport;
 
     /** The copy of the GVMM statistics. */
     GVMMSTATS               GVMMStats;
     /** The number of registered host CPU leaves. */
     uint32_t                cRegisteredHostCpus;
 
-    /** Explicit alignment padding. */
-    uint32_t                uAlignment;
+    /** The registration generation, incremented whenever a sample is registered
+     * or deregistered.  Used by the shared memory export. */
+    uint32_t volatile       uGeneration;
     /** The copy of the GMM statistics. */
     GMMSTATS                GMMStats;
 } STAMUSERPERVM;
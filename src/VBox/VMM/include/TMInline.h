@@ -67,6 +67,37 @@ DECLINLINE(void) tmTimerQueueSetHead(PTMTIMERQUEUECC pQueueCC, PTMTIMERQUEUE pQu
 }
 
 
+/**
+ * Get the tail of the active list - translates TMTIMERQUEUE::idxActiveTail.
+ */
+DECLINLINE(PTMTIMER) tmTimerQueueGetTail(PTMTIMERQUEUECC pQueueCC, PTMTIMERQUEUE pQueueShared)
+{
+    uint32_t const idx = pQueueShared->idxActiveTail;
+    if (idx < pQueueCC->cTimersAlloc)
+        return &pQueueCC->paTimers[idx];
+    return NULL;
+}
+
+
+/**
+ * Set the tail of the active list (TMTIMERQUEUE::idxActiveTail).
+ */
+DECLINLINE(void) tmTimerQueueSetTail(PTMTIMERQUEUECC pQueueCC, PTMTIMERQUEUE pQueueShared, PTMTIMER pTail)
+{
+    uint32_t idx;
+    if (pTail)
+    {
+        idx = (uint32_t)(pTail - &pQueueCC->paTimers[0]);
+        AssertMsgStmt(idx < pQueueCC->cTimersAlloc,
+                      ("idx=%u (%s) cTimersAlloc=%u\n", idx, pTail->szName, pQueueCC->cTimersAlloc),
+                      idx = UINT32_MAX);
+    }
+    else
+        idx = UINT32_MAX;
+    pQueueShared->idxActiveTail = idx;
+}
+
+
 /**
  * Get the previous timer - translates TMTIMER::idxPrev.
  */
@@ -136,24 +167,18 @@ DECLINLINE(void) tmTimerSetNext(PTMTIMERQUEUECC pQueueCC, PTMTIMER pTimer, PTMTI
 
 
 /**
- * Used to unlink a timer from the active list.
+ * Unlinks a timer from the active list, no state assertions.
  *
  * @param   pVM         The cross context VM structure.
  * @param   pQueueCC    The context specific queue data (same as @a pQueue for
  *                      ring-3).
  * @param   pQueue      The shared timer queue data.
- * @param   pTimer      The timer that needs linking.
+ * @param   pTimer      The timer that needs unlinking.
  *
  * @remarks Called while owning the relevant queue lock.
  */
-DECL_FORCE_INLINE(void) tmTimerQueueUnlinkActive(PVMCC pVM, PTMTIMERQUEUECC pQueueCC, PTMTIMERQUEUE pQueue, PTMTIMER pTimer)
+DECL_FORCE_INLINE(void) tmTimerQueueUnlinkActiveWorker(PVMCC pVM, PTMTIMERQUEUECC pQueueCC, PTMTIMERQUEUE pQueue, PTMTIMER pTimer)
 {
-#ifdef VBOX_STRICT
-    TMTIMERSTATE const enmState = pTimer->enmState;
-    Assert(  pQueue->enmClock == TMCLOCK_VIRTUAL_SYNC
-           ? enmState == TMTIMERSTATE_ACTIVE
-           : enmState == TMTIMERSTATE_PENDING_SCHEDULE || enmState == TMTIMERSTATE_PENDING_STOP_SCHEDULE);
-#endif
     RT_NOREF(pVM);
 
     const PTMTIMER pPrev = tmTimerGetPrev(pQueueCC, pTimer);
@@ -168,8 +193,35 @@ DECL_FORCE_INLINE(void) tmTimerQueueUnlinkActive(PVMCC pVM, PTMTIMERQUEUECC pQue
     }
     if (pNext)
         tmTimerSetPrev(pQueueCC, pNext, pPrev);
+    else
+        tmTimerQueueSetTail(pQueueCC, pQueue, pPrev);
     pTimer->idxNext = UINT32_MAX;
     pTimer->idxPrev = UINT32_MAX;
+    Assert(pQueue->cActive > 0);
+    pQueue->cActive--;
+}
+
+
+/**
+ * Used to unlink a timer from the active list.
+ *
+ * @param   pVM         The cross context VM structure.
+ * @param   pQueueCC    The context specific queue data (same as @a pQueue for
+ *                      ring-3).
+ * @param   pQueue      The shared timer queue data.
+ * @param   pTimer      The timer that needs linking.
+ *
+ * @remarks Called while owning the relevant queue lock.
+ */
+DECL_FORCE_INLINE(void) tmTimerQueueUnlinkActive(PVMCC pVM, PTMTIMERQUEUECC pQueueCC, PTMTIMERQUEUE pQueue, PTMTIMER pTimer)
+{
+#ifdef VBOX_STRICT
+    TMTIMERSTATE const enmState = pTimer->enmState;
+    Assert(  pQueue->enmClock == TMCLOCK_VIRTUAL_SYNC
+           ? enmState == TMTIMERSTATE_ACTIVE
+           : enmState == TMTIMERSTATE_PENDING_SCHEDULE || enmState == TMTIMERSTATE_PENDING_STOP_SCHEDULE);
+#endif
+    tmTimerQueueUnlinkActiveWorker(pVM, pQueueCC, pQueue, pTimer);
 }
 
 /** @def TMTIMER_HANDLE_TO_VARS_RETURN_EX
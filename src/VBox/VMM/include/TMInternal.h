@@ -287,6 +287,7 @@ typedef struct TMTIMERQUEUE
      *
      * When no scheduling is pending, this list is will be ordered by expire time (ascending).
      * Access is serialized by only letting the emulation thread (EMT) do changes.
+     * @sa idxActiveTail
      */
     uint32_t                idxActive;
     /** List of timers pending scheduling of some kind.
@@ -326,7 +327,13 @@ typedef struct TMTIMERQUEUE
     SUPSEMEVENT             hWorkerEvt;
     /** Absolute sleep deadline for the worker (enmClock time). */
     uint64_t volatile       tsWorkerWakeup;
-    uint64_t                u64Alignment2;
+    /** The tail of the active timer list (idxActive), UINT32_MAX if empty.
+     * This allows tmTimerQueueLinkActive to search from whichever end of the
+     * list is closer to the new expire time and to append in O(1), which is
+     * the common case for periodic timers being re-armed. */
+    uint32_t                idxActiveTail;
+    /** Number of timers in the active list (queue depth). */
+    uint32_t                cActive;
 
     /** Lock serializing the active timer list and associated work. */
     PDMCRITSECT             TimerLock;
@@ -600,8 +607,12 @@ typedef struct TM
     bool volatile               fRunningQueues;
     /** Indicates that the virtual sync queue is being run. */
     bool volatile               fRunningVirtualSyncQueue;
+    /** Tickless EMT waits (/TM/Tickless): wake up a halted timer EMT when a
+     * queue gets a new, earlier head timer, so it can re-arm its wait deadline,
+     * and don't tick the pTimer watchdog at a high rate. */
+    bool                        fTickless;
     /** Alignment */
-    bool                        afAlignment3[2];
+    bool                        afAlignment3[1];
 
     /** Lock serializing access to the VirtualSync clock and the associated
      * timer queue.
@@ -624,6 +635,12 @@ typedef struct TM
     STAMCOUNTER                 StatPostponedR3;
     STAMCOUNTER                 StatPostponedRZ;
     /** @} */
+    /** tmTimerQueueLinkActive
+     * @{ */
+    STAMPROFILE                 StatLinkActive;
+    STAMCOUNTER                 aStatLinkActiveSteps[TMCLOCK_MAX];
+    STAMCOUNTER                 StatTicklessWakeups;
+    /** @} */
     /** Read the time
      * @{ */
     STAMCOUNTER                 StatVirtualGet;
@@ -841,6 +858,25 @@ typedef struct TMCPU
 
     /** CPU load state for this virtual CPU (tmR3CpuLoadTimer). */
     TMCPULOADSTATE              CpuLoad;
+
+    /** @name Steal time accounting (TMR3CpuUpdateStealTime).
+     * @note Only written to by the EMT owning it.
+     * @{ */
+    /** Time spent blocking in ring-0 halts (GVMMR0SchedHalt), which isn't
+     * part of cNsHalted. */
+    uint64_t                    cNsHaltedRing0;
+    /** The time (nanoseconds) this VCPU was runnable but not running on a host
+     * CPU, i.e. the steal time reported to the guest. */
+    uint64_t                    cNsSteal;
+    /** RTTimeNanoTS() of the last steal time sample, 0 if a new base is needed. */
+    uint64_t                    nsStealLastSample;
+    /** cNsSteal when the current base was taken. */
+    uint64_t                    cNsStealBase;
+    /** The runnable time (total minus halted) when the current base was taken. */
+    uint64_t                    cNsRunnableBase;
+    /** The EMT thread's CPU time (milliseconds) when the current base was taken. */
+    uint64_t                    cMsCpuBase;
+    /** @} */
 #endif
 } TMCPU;
 #ifndef VBOX_WITHOUT_NS_ACCOUNTING
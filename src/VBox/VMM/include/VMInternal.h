@@ -372,8 +372,10 @@ typedef struct VMINTUSERPERVMCPU
     /** Set if we've been thru vmR3Destroy and decremented the active EMT count
      *  already. */
     bool volatile                   fBeenThruVmDestroy;
+    /** Set while the CPU is hot-unplugged and the EMT parked (VMR3WaitParked). */
+    bool volatile                   fParked;
     /** Align the next bit. */
-    bool                            afAlignment[6];
+    bool                            afAlignment[5];
 
     /** @name Generic Halt data
      * @{
@@ -251,7 +251,10 @@ typedef struct VMM
     /** Whether we should use the periodic preemption timers. */
     bool                        fUsePeriodicPreemptionTimers;
     /** Alignment padding. */
-    bool                        afPadding0[7];
+    bool                        afPadding0[3];
+    /** The max adaptive halt poll window for GVMMR0SchedHalt in nanoseconds,
+     * zero to disable (/VMM/HaltPollMaxNs). */
+    uint32_t                    cNsHaltPollMax;
 
 #if 0 /* pointless when timers doesn't run on EMT */
     /** The EMT yield timer. */
@@ -66,6 +66,7 @@
 # error "port me"
 #endif
 
+#include <iprt/err.h>
 #include <iprt/stream.h>
 #include <iprt/stdarg.h>
 #include <iprt/types.h>
@@ -90,6 +91,8 @@
 # define MY_TERM_PORT           0x01
 /** The no-op test port number. */
 # define MY_NOP_PORT            0x7f
+/** The no-op test MSR, picked so that no hypervisor implements it. */
+# define MY_NOP_MSR             0x00001bad
 #else
 /** No-op MMIO access address.   */
 # define MY_TERM_MMIO           0x0800
@@ -100,6 +103,22 @@
 #if defined(RT_ARCH_AMD64)
 # define MY_TEST_F_CPUID        (1U<<1)
 # define MY_TEST_F_NOP_IO       (1U<<2)
+# define MY_TEST_F_NOP_MSR      (1U<<3)
+# define MY_TEST_F_HLT          (1U<<4)
+#endif
+
+/** The name of the backend we're using, for the CSV output. */
+#ifdef RT_OS_WINDOWS
+# define MY_BACKEND_NAME        "WinHvPlatform"
+#elif defined(RT_OS_LINUX)
+# define MY_BACKEND_NAME        "KVM"
+#elif defined(RT_OS_DARWIN)
+# define MY_BACKEND_NAME        "Hypervisor.framework"
+#endif
+#ifdef RT_ARCH_AMD64
+# define MY_ARCH_NAME           "amd64"
+#else
+# define MY_ARCH_NAME           "arm64"
 #endif
 
 #if defined(RT_OS_LINUX) && defined(RT_ARCH_ARM64)
@@ -115,6 +134,12 @@
 static unsigned char           *g_pbMem;
 /** Amount of RAM at address 0x1000 (MY_MEM_BASE). */
 static size_t                   g_cbMem;
+/** The CSV output stream (--csv), NULL if not requested. */
+static PRTSTREAM                g_pCsv = NULL;
+/** The label for the CSV rows (--label). */
+static const char              *g_pszLabel = "";
+/** Set if RDMSR/WRMSR of MY_NOP_MSR causes a userland exit with this backend. */
+static bool                     g_fMsrExits = true;
 #ifdef RT_OS_WINDOWS
 static WHV_PARTITION_HANDLE     g_hPartition = NULL;
 
@@ -231,6 +256,11 @@ int reportResult(const char *pszInstruction, uint32_t cInstructions, uint64_t ns
              formatNum(cInstrPerSec, 10, szTmp1, sizeof(szTmp1)), pszInstruction,
              formatNum(cExits, 0, szTmp2, sizeof(szTmp2)),
              formatNum(nsElapsed, 0, szTmp3, sizeof(szTmp3)));
+    if (g_pCsv)
+        RTStrmPrintf(g_pCsv, "%s,%s,%s,%s,%u,%u,%llu,%llu,%llu\n",
+                     g_pszLabel, MY_BACKEND_NAME, MY_ARCH_NAME, pszInstruction, cInstructions, cExits,
+                     (unsigned long long)nsElapsed, (unsigned long long)cInstrPerSec,
+                     (unsigned long long)(cInstructions ? nsElapsed / cInstructions : 0));
     return 0;
 }
 
@@ -395,8 +425,6 @@ static int runRealModeTest(unsigned cInstructions, const char *pszInstruction, u
                            unsigned uEax, unsigned uEcx, unsigned uEdx, unsigned uEbx,
                            unsigned uEsp, unsigned uEbp, unsigned uEsi, unsigned uEdi)
 {
-    (void)fTest;
-
     /*
      * Initialize the real mode context.
      */
@@ -504,6 +532,47 @@ static int runRealModeTest(unsigned cInstructions, const char *pszInstruction, u
                 else
                     return runtimeError("VpContext.InstructionLength is zero (for %s)\n", pszInstruction);
             }
+            else if (ExitInfo.ExitReason == WHvRunVpExitReasonX64MsrAccess)
+            {
+                if (ExitInfo.MsrAccess.MsrNumber == MY_NOP_MSR)
+                { /* likely: nop MSR */ }
+                else
+                    return runtimeError("Unexpected MSR access (for %s): %#x\n", pszInstruction, ExitInfo.MsrAccess.MsrNumber);
+
+                /* Advance RIP and on reads return zero in EDX:EAX. */
+                if (ExitInfo.VpContext.InstructionLength)
+                {
+                    aenmNames[0] = WHvX64RegisterRip;
+                    aValues[0].Reg64 = ExitInfo.VpContext.Rip + ExitInfo.VpContext.InstructionLength;
+                    aenmNames[1] = WHvX64RegisterRax;
+                    aValues[1].Reg64 = ExitInfo.MsrAccess.AccessInfo.IsWrite ? ExitInfo.MsrAccess.Rax : 0;
+                    aenmNames[2] = WHvX64RegisterRdx;
+                    aValues[2].Reg64 = ExitInfo.MsrAccess.AccessInfo.IsWrite ? ExitInfo.MsrAccess.Rdx : 0;
+                    hrc = WHvSetVirtualProcessorRegisters(g_hPartition, 0 /*idCpu*/, aenmNames, 3, aValues);
+                    if (SUCCEEDED(hrc))
+                    { /* likely */ }
+                    else
+                        return runtimeError("Error advancing RIP (for %s): %#x\n", pszInstruction, hrc);
+                }
+                else
+                    return runtimeError("VpContext.InstructionLength is zero (for %s)\n", pszInstruction);
+            }
+            else if (ExitInfo.ExitReason == WHvRunVpExitReasonX64Halt && (fTest & MY_TEST_F_HLT))
+            {
+                /* The test code pads each HLT with a NOP, so we can tell whether RIP
+                   still points at the HLT or has already been advanced past it. */
+                uint64_t const offPc = ExitInfo.VpContext.Rip - MY_MEM_BASE;
+                if (offPc < g_cbMem && g_pbMem[offPc] == 0xf4)
+                {
+                    aenmNames[0] = WHvX64RegisterRip;
+                    aValues[0].Reg64 = ExitInfo.VpContext.Rip + 1;
+                    hrc = WHvSetVirtualProcessorRegisters(g_hPartition, 0 /*idCpu*/, aenmNames, 1, aValues);
+                    if (SUCCEEDED(hrc))
+                    { /* likely */ }
+                    else
+                        return runtimeError("Error advancing RIP (for %s): %#x\n", pszInstruction, hrc);
+                }
+            }
             else if (ExitInfo.ExitReason == WHvRunVpExitReasonMemoryAccess)
             {
                 if (ExitInfo.MemoryAccess.Gpa == MY_NOP_MMIO)
@@ -554,6 +623,27 @@ static int createVM(void)
     if (g_fdVm < 0)
         return error("KVM_CREATE_VM failed: %d\n", errno);
 
+# ifdef RT_ARCH_AMD64
+    /* Get accesses to unknown MSRs (MY_NOP_MSR) forwarded to us instead of having KVM raise #GP. */
+    g_fMsrExits = false;
+#  ifdef KVM_CAP_X86_USER_SPACE_MSR
+    if (ioctl(fd, KVM_CHECK_EXTENSION, (uintptr_t)KVM_CAP_X86_USER_SPACE_MSR) > 0)
+    {
+        struct kvm_enable_cap EnableCap;
+        memset(&EnableCap, 0, sizeof(EnableCap));
+        EnableCap.cap     = KVM_CAP_X86_USER_SPACE_MSR;
+        EnableCap.args[0] = KVM_MSR_EXIT_REASON_UNKNOWN;
+        rc = ioctl(g_fdVm, KVM_ENABLE_CAP, &EnableCap);
+        if (rc == 0)
+            g_fMsrExits = true;
+        else
+            RTPrintf("info: KVM_ENABLE_CAP/KVM_CAP_X86_USER_SPACE_MSR failed: %d (rc=%d)\n", errno, rc);
+    }
+#  endif
+    if (!g_fMsrExits)
+        RTPrintf("info: No KVM_CAP_X86_USER_SPACE_MSR, skipping the MSR tests.\n");
+# endif
+
     /* Create the VCpu. */
     g_cbVCpuRun = ioctl(fd, KVM_GET_VCPU_MMAP_SIZE, (uintptr_t)0);
     if (g_cbVCpuRun <= 0x1000 || (g_cbVCpuRun & 0xfff))
@@ -571,7 +661,7 @@ static int createVM(void)
         return error("KVM_ARM_VCPU_INIT failed: %d (rc=%d)\n", errno, rc);
 # endif
 
-    g_pVCpuRun = (struct kvm_run *)mmap(NULL, g_cbVCpuRun, PROT_READ | PROT_WRITE, MAP_PRIVATE, g_fdVCpu, 0);
+    g_pVCpuRun = (struct kvm_run *)mmap(NULL, g_cbVCpuRun, PROT_READ | PROT_WRITE, MAP_SHARED, g_fdVCpu, 0);
     if ((void *)g_pVCpuRun == MAP_FAILED)
         return error("mmap kvm_run failed: %d\n", errno);
 
@@ -722,8 +812,6 @@ static int runRealModeTest(unsigned cInstructions, const char *pszInstruction, u
                            unsigned uEax, unsigned uEcx, unsigned uEdx, unsigned uEbx,
                            unsigned uEsp, unsigned uEbp, unsigned uEsi, unsigned uEdi)
 {
-    (void)fTest;
-
     /*
      * Setup real mode context.
      */
@@ -805,6 +893,22 @@ static int runRealModeTest(unsigned cInstructions, const char *pszInstruction, u
                 else
                     return runtimeError("Unexpected memory access (for %s): %#llx\n", pszInstruction, g_pVCpuRun->mmio.phys_addr);
             }
+#  ifdef KVM_CAP_X86_USER_SPACE_MSR
+            else if (   (   g_pVCpuRun->exit_reason == KVM_EXIT_X86_RDMSR
+                         || g_pVCpuRun->exit_reason == KVM_EXIT_X86_WRMSR)
+                     && (fTest & MY_TEST_F_NOP_MSR))
+            {
+                if (g_pVCpuRun->msr.index == MY_NOP_MSR)
+                { /* likely: nop MSR */ }
+                else
+                    return runtimeError("Unexpected MSR access (for %s): %#x\n", pszInstruction, g_pVCpuRun->msr.index);
+                /* KVM completes the instruction on the next KVM_RUN. */
+                g_pVCpuRun->msr.error = 0;
+                g_pVCpuRun->msr.data  = 0;
+            }
+#  endif
+            else if (g_pVCpuRun->exit_reason == KVM_EXIT_HLT && (fTest & MY_TEST_F_HLT))
+            { /* likely: KVM has already advanced RIP, so just resume. */ }
             else
                 return runtimeError("Unexpected exit (for %s): %d\n", pszInstruction, g_pVCpuRun->exit_reason);
         }
@@ -1236,6 +1340,36 @@ static int runRealModeTest(unsigned cInstructions, const char *pszInstruction, u
                     READ_REG_RET(HV_X86_RIP, &uRip);
                     WRITE_REG_RET(HV_X86_RIP, uRip + cbInstr);
                 }
+                else if (   (uExitReason == VMX_REASON_RDMSR || uExitReason == VMX_REASON_WRMSR)
+                         && (fTest & MY_TEST_F_NOP_MSR))
+                {
+                    uint64_t uMsr = UINT64_MAX;
+                    READ_REG_RET(HV_X86_RCX, &uMsr);
+                    if ((uint32_t)uMsr != MY_NOP_MSR)
+                        return runtimeError("Unexpected MSR access (for %s): %#llx\n", pszInstruction, uMsr);
+
+                    /* Return zero for reads and advance RIP. */
+                    if (uExitReason == VMX_REASON_RDMSR)
+                    {
+                        WRITE_REG_RET(HV_X86_RAX, 0);
+                        WRITE_REG_RET(HV_X86_RDX, 0);
+                    }
+
+                    uint64_t cbInstr = UINT64_MAX;
+                    READ_VMCS_RET(VMCS_RO_VMEXIT_INSTR_LEN, &cbInstr);
+                    if (cbInstr < 1 || cbInstr > 15)
+                        return runtimeError("Bad instr len: %#llx\n", cbInstr);
+                    uint64_t uRip = UINT64_MAX;
+                    READ_REG_RET(HV_X86_RIP, &uRip);
+                    WRITE_REG_RET(HV_X86_RIP, uRip + cbInstr);
+                }
+                else if (uExitReason == VMX_REASON_HLT && (fTest & MY_TEST_F_HLT))
+                {
+                    /* Advance RIP past the HLT, which is how we 'wake up' the vCPU. */
+                    uint64_t uRip = UINT64_MAX;
+                    READ_REG_RET(HV_X86_RIP, &uRip);
+                    WRITE_REG_RET(HV_X86_RIP, uRip + 1);
+                }
                 else if (uExitReason == VMX_REASON_IRQ)
                 { /* ignore */ }
                 else
@@ -1374,6 +1508,113 @@ int mmioTest(unsigned cFactor)
 }
 
 
+int mmioWriteTest(unsigned cFactor)
+{
+    /*
+     * Produce realmode code writing to the MY_MMIO_NOP address assuming it's low.
+     */
+    unsigned char *pb = &g_pbMem[MY_TEST_PC - MY_MEM_BASE];
+    unsigned char * const pbStart = pb;
+    for (unsigned i = 0; i < 10; i++)
+    {
+        /* MOV DS:[BX],AL */
+        *pb++ = 0x88;
+        *pb++ = 0x07;
+    }
+    /* DEC ESI */
+    *pb++ = 0x66;
+    *pb++ = 0x48 + 6;
+    /* JNZ MY_TEST_PC */
+    *pb++ = 0x75;
+    *pb   = (signed char)(pbStart - pb - 1);
+    pb++;
+    /* OUT 1, AL -  Temination port call. */
+    *pb++ = 0xe6;
+    *pb++ = MY_TERM_PORT;
+    /* JMP to previous instruction */
+    *pb++ = 0xeb;
+    *pb++ = 0xfc;
+    dumpCode(pbStart, pb);
+
+    return runRealModeTest(100000 * cFactor, "MMIO/w1", MY_TEST_F_NOP_MMIO,
+                           42 /*eax*/, 0 /*ecx*/, 0 /*edx*/, MY_NOP_MMIO /*ebx*/,
+                           0 /*esp*/, 0 /*ebp*/, 10000 * cFactor /*esi*/, 0 /*uEdi*/);
+}
+
+
+int msrTest(unsigned cFactor)
+{
+    if (!g_fMsrExits)
+        return 0;
+
+    /*
+     * Produce realmode code reading MY_NOP_MSR (ECX) into EDX:EAX.
+     */
+    unsigned char *pb = &g_pbMem[MY_TEST_PC - MY_MEM_BASE];
+    unsigned char * const pbStart = pb;
+    for (unsigned i = 0; i < 10; i++)
+    {
+        /* RDMSR */
+        *pb++ = 0x0f;
+        *pb++ = 0x32;
+    }
+    /* DEC ESI */
+    *pb++ = 0x66;
+    *pb++ = 0x48 + 6;
+    /* JNZ MY_TEST_PC */
+    *pb++ = 0x75;
+    *pb   = (signed char)(pbStart - pb - 1);
+    pb++;
+    /* OUT 1, AL -  Temination port call. */
+    *pb++ = 0xe6;
+    *pb++ = MY_TERM_PORT;
+    /* JMP to previous instruction */
+    *pb++ = 0xeb;
+    *pb++ = 0xfc;
+    dumpCode(pbStart, pb);
+
+    return runRealModeTest(100000 * cFactor, "RDMSR", MY_TEST_F_NOP_MSR,
+                           0 /*eax*/, MY_NOP_MSR /*ecx*/, 0 /*edx*/, 0 /*ebx*/,
+                           0 /*esp*/, 0 /*ebp*/, 10000 * cFactor /*esi*/, 0 /*uEdi*/);
+}
+
+
+int hltTest(unsigned cFactor)
+{
+    /*
+     * Produce realmode code halting with interrupts disabled, relying on the
+     * runloop to resume execution after each HLT.
+     */
+    unsigned char *pb = &g_pbMem[MY_TEST_PC - MY_MEM_BASE];
+    unsigned char * const pbStart = pb;
+    for (unsigned i = 0; i < 10; i++)
+    {
+        /* HLT */
+        *pb++ = 0xf4;
+        /* NOP - lets the runloop tell whether RIP has been advanced past the HLT. */
+        *pb++ = 0x90;
+    }
+    /* DEC ESI */
+    *pb++ = 0x66;
+    *pb++ = 0x48 + 6;
+    /* JNZ MY_TEST_PC */
+    *pb++ = 0x75;
+    *pb   = (signed char)(pbStart - pb - 1);
+    pb++;
+    /* OUT 1, AL -  Temination port call. */
+    *pb++ = 0xe6;
+    *pb++ = MY_TERM_PORT;
+    /* JMP to previous instruction */
+    *pb++ = 0xeb;
+    *pb++ = 0xfc;
+    dumpCode(pbStart, pb);
+
+    return runRealModeTest(100000 * cFactor, "HLT", MY_TEST_F_HLT,
+                           0 /*eax*/, 0 /*ecx*/, 0 /*edx*/, 0 /*ebx*/,
+                           0 /*esp*/, 0 /*ebp*/, 10000 * cFactor /*esi*/, 0 /*uEdi*/);
+}
+
+
 #elif defined(RT_ARCH_ARM64)
 
 
@@ -1438,6 +1679,7 @@ int main(int argc, char **argv)
     unsigned const  cFactorDefault = 24;
 #endif
     unsigned        cFactor = cFactorDefault;
+    const char     *pszCsv  = NULL;
     for (int i = 1; i < argc; i++)
     {
         const char *pszArg = argv[i];
@@ -1449,12 +1691,16 @@ int main(int argc, char **argv)
         {
             RTPrintf("Does some benchmarking of the native NEM engine.\n"
                      "\n"
-                     "Usage: NemRawBench-1 --factor <factor>\n"
+                     "Usage: NemRawBench-1 [--factor <factor>] [--csv <file>] [--label <label>]\n"
                      "\n"
                      "Options\n"
                      "  --factor <factor>\n"
                      "        Iteration count factor.  Default is %u.\n"
-                     "        Lower it if execution is slow, increase if quick.\n",
+                     "        Lower it if execution is slow, increase if quick.\n"
+                     "  --csv <file>\n"
+                     "        Write the results to <file> as comma separated values, one row per test.\n"
+                     "  --label <label>\n"
+                     "        Value for the first CSV column, e.g. the host name and release.\n",
                      cFactorDefault);
             return 0;
         }
@@ -1469,6 +1715,19 @@ int main(int argc, char **argv)
                 return 2;
             }
         }
+        else if (strcmp(pszArg, "--csv") == 0 || strcmp(pszArg, "--label") == 0)
+        {
+            i++;
+            if (i >= argc)
+            {
+                RTStrmPrintf(g_pStdErr, "syntax error: Option %s is takes a value!\n", pszArg);
+                return 2;
+            }
+            if (pszArg[2] == 'c')
+                pszCsv = argv[i];
+            else
+                g_pszLabel = argv[i];
+        }
         else
         {
             RTStrmPrintf(g_pStdErr, "syntax error: Unknown option: %s\n", pszArg);
@@ -1479,6 +1738,14 @@ int main(int argc, char **argv)
     /*
      * Create the VM
      */
+    if (pszCsv)
+    {
+        int rc = RTStrmOpen(pszCsv, "w", &g_pCsv);
+        if (RT_FAILURE(rc))
+            return error("Failed to open '%s' for writing: %Rrc\n", pszCsv, rc);
+        RTStrmPrintf(g_pCsv, "label,backend,arch,test,instructions,exits,ns,instr_per_sec,ns_per_instr\n");
+    }
+
     g_cbMem = 128*1024 - MY_MEM_BASE;
     int rcExit = createVM();
     if (rcExit == 0)
@@ -1493,9 +1760,16 @@ int main(int argc, char **argv)
         cpuidTest(cFactor);
 #endif
         mmioTest(cFactor);
+#ifdef RT_ARCH_AMD64
+        mmioWriteTest(cFactor);
+        msrTest(cFactor);
+        hltTest(cFactor);
+#endif
 
         RTPrintf("tstNemBench-1: done\n");
     }
+    if (g_pCsv)
+        RTStrmClose(g_pCsv);
     return rcExit;
 }
 
@@ -44,6 +44,7 @@
 #include <iprt/param.h>
 #include <iprt/stream.h>
 #include <iprt/string.h>
+#include <iprt/thread.h>
 #include <iprt/time.h>
 #include <iprt/zip.h>
 
@@ -52,6 +53,38 @@
 *   Defined Constants And Macros                                                                                                 *
 *********************************************************************************************************************************/
 #define MY_BLOCK_SIZE       _4K     /**< Same as SSM uses. */
+#define MY_MAX_THREADS      64      /**< Max number of threads for the block tests. */
+
+
+/*********************************************************************************************************************************
+*   Structures and Typedefs                                                                                                      *
+*********************************************************************************************************************************/
+/**
+ * The share of the blocks a thread works on in the block tests.
+ */
+typedef struct MYSLICE
+{
+    /** The compression type. */
+    RTZIPTYPE       enmType;
+    /** The compression level. */
+    RTZIPLEVEL      enmLevel;
+    /** Compress (true) or decompress (false). */
+    bool            fCompress;
+    /** Number of blocks to pass to the API at a time. */
+    uint32_t        cBlocksAtATime;
+    /** The first block. */
+    size_t          iFirstBlock;
+    /** Number of blocks. */
+    size_t          cBlocks;
+    /** The part of g_pabCompr this slice owns. */
+    uint8_t        *pbCompr;
+    /** Size of the part of g_pabCompr this slice owns. */
+    size_t          cbComprAlloc;
+    /** The amount of compressed data. */
+    size_t          cbCompr;
+    /** The status of the last run. */
+    int             rc;
+} MYSLICE;
 
 
 /*********************************************************************************************************************************
@@ -73,6 +106,9 @@ static size_t   g_offComprIn;
 /** The amount of space allocated for compressed data. */
 static size_t   g_cbComprAlloc;
 
+/** The slices of the block tests, one per thread. */
+static MYSLICE  g_aSlices[MY_MAX_THREADS];
+
 
 /**
  * Store compressed data in the g_pabCompr buffer.
@@ -102,6 +138,118 @@ static DECLCALLBACK(int) DecomprInCallback(void *pvUser, void *pvBuf, size_t cbB
 }
 
 
+/**
+ * Compresses the blocks of a slice, storing a 32-bit size before each chunk.
+ *
+ * @returns iprt status code.
+ * @param   pSlice      The slice.
+ */
+static int tstCompressSlice(MYSLICE *pSlice)
+{
+    size_t          cbLeft     = pSlice->cbComprAlloc;
+    uint8_t const  *pbSrcBlock = &g_pabSrc[pSlice->iFirstBlock * MY_BLOCK_SIZE];
+    uint8_t        *pbDstBlock = pSlice->pbCompr;
+    for (size_t iBlock = 0; iBlock < pSlice->cBlocks; iBlock += pSlice->cBlocksAtATime)
+    {
+        size_t  cbSrc = RT_MIN(pSlice->cBlocks - iBlock, pSlice->cBlocksAtATime) * MY_BLOCK_SIZE;
+        AssertReturn(cbLeft > cbSrc + sizeof(uint32_t), VERR_BUFFER_OVERFLOW);
+        uint32_t *pcb = (uint32_t *)pbDstBlock;
+        pbDstBlock   += sizeof(uint32_t);
+        cbLeft       -= sizeof(uint32_t);
+        size_t  cbDst;
+        int rc = RTZipBlockCompress(pSlice->enmType, pSlice->enmLevel, 0 /*fFlags*/,
+                                    pbSrcBlock, cbSrc,
+                                    pbDstBlock, cbLeft, &cbDst);
+        if (RT_FAILURE(rc))
+            return rc;
+        *pcb        = (uint32_t)cbDst;
+        cbLeft     -= cbDst;
+        pbDstBlock += cbDst;
+        pbSrcBlock += cbSrc;
+    }
+    pSlice->cbCompr = pbDstBlock - pSlice->pbCompr;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Decompresses the blocks of a slice compressed by tstCompressSlice.
+ *
+ * @returns iprt status code.
+ * @param   pSlice      The slice.
+ */
+static int tstDecompressSlice(MYSLICE *pSlice)
+{
+    uint8_t const  *pbSrcBlock = pSlice->pbCompr;
+    uint8_t        *pbDstBlock = &g_pabDecompr[pSlice->iFirstBlock * MY_BLOCK_SIZE];
+    for (size_t iBlock = 0; iBlock < pSlice->cBlocks; iBlock += pSlice->cBlocksAtATime)
+    {
+        size_t   cbDst = RT_MIN(pSlice->cBlocks - iBlock, pSlice->cBlocksAtATime) * MY_BLOCK_SIZE;
+        size_t   cbSrc = *(uint32_t *)pbSrcBlock;
+        pbSrcBlock    += sizeof(uint32_t);
+        int rc = RTZipBlockDecompress(pSlice->enmType, 0 /*fFlags*/,
+                                      pbSrcBlock, cbSrc, &cbSrc,
+                                      pbDstBlock, cbDst, &cbDst);
+        if (RT_FAILURE(rc))
+            return rc;
+        pbDstBlock += cbDst;
+        pbSrcBlock += cbSrc;
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @callback_method_impl{FNRTTHREAD, Works on one slice.}
+ */
+static DECLCALLBACK(int) tstSliceThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    RT_NOREF(hThreadSelf);
+    MYSLICE *pSlice = (MYSLICE *)pvUser;
+    pSlice->rc = pSlice->fCompress ? tstCompressSlice(pSlice) : tstDecompressSlice(pSlice);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Runs a block test on @a cThreads threads, each working on its own share of
+ * the blocks and of the compressed data buffer.
+ *
+ * @returns iprt status code.
+ * @param   cThreads    Number of threads, the slices must be set up.
+ * @param   fCompress   Compress (true) or decompress (false).
+ */
+static int tstRunSlices(uint32_t cThreads, bool fCompress)
+{
+    RTTHREAD ahThreads[MY_MAX_THREADS];
+    int      rc = VINF_SUCCESS;
+    uint32_t i;
+    for (i = 0; i < cThreads; i++)
+        g_aSlices[i].fCompress = fCompress;
+    if (cThreads == 1)
+        tstSliceThread(NIL_RTTHREAD, &g_aSlices[0]);
+    else
+    {
+        for (i = 0; i < cThreads; i++)
+        {
+            rc = RTThreadCreateF(&ahThreads[i], tstSliceThread, &g_aSlices[i], 0, RTTHREADTYPE_DEFAULT,
+                                 RTTHREADFLAGS_WAITABLE, "slice%u", i);
+            if (RT_FAILURE(rc))
+                break;
+        }
+        while (i-- > 0)
+            RTThreadWait(ahThreads[i], RT_INDEFINITE_WAIT, NULL);
+        if (RT_FAILURE(rc))
+            return rc;
+    }
+
+    for (i = 0; i < cThreads; i++)
+        if (RT_FAILURE(g_aSlices[i].rc))
+            return g_aSlices[i].rc;
+    return VINF_SUCCESS;
+}
+
+
 /**
  * Benchmark RTCrc routines potentially relevant for SSM or PGM - All in one go.
  *
@@ -262,12 +410,14 @@ int main(int argc, char **argv)
         { "--block-at-a-time", 'c', RTGETOPT_REQ_UINT32 },
         { "--block-file",      'f', RTGETOPT_REQ_STRING },
         { "--offset",          'o', RTGETOPT_REQ_UINT64 },
+        { "--threads",         't', RTGETOPT_REQ_UINT32 },
     };
 
     const char     *pszBlockFile = NULL;
     uint64_t        offBlockFile = 0;
     uint32_t        cIterations = 1;
     uint32_t        cBlocksAtATime = 1;
+    uint32_t        cThreads = 1;
     RTGETOPTUNION   Val;
     RTGETOPTSTATE   State;
     int rc = RTGetOptInit(&State, argc, argv, &s_aOptions[0], RT_ELEMENTS(s_aOptions), 1, 0);
@@ -306,6 +456,12 @@ int main(int argc, char **argv)
                 offBlockFile = Val.u64;
                 break;
 
+            case 't':
+                cThreads = Val.u32;
+                if (cThreads < 1 || cThreads > MY_MAX_THREADS)
+                    return Error("The specified thread count is out of range: %u (max %u)\n", cThreads, MY_MAX_THREADS);
+                break;
+
             case 'O':
                 offBlockFile = Val.u64 * MY_BLOCK_SIZE;
                 break;
@@ -324,9 +480,14 @@ int main(int argc, char **argv)
                          "    Number of blocks at a time.\n"
                          "  -f, --block-file <filename>\n"
                          "    File or device to read the block from. The default\n"
-                         "    is to generate some garbage.\n"
+                         "    is to generate some garbage. Use a guest core dump\n"
+                         "    ('VBoxManage debugvm <vm> dumpvmcore') for realistic\n"
+                         "    saved state page samples.\n"
                          "  -o, --offset <file-offset>\n"
-                         "    Offset into the block file to start reading at.\n");
+                         "    Offset into the block file to start reading at.\n"
+                         "  -t, --threads <num>\n"
+                         "    Number of threads to split the blocks across for the\n"
+                         "    RTZipBlock tests. The stream tests are single threaded.\n");
                 return 0;
 
             case 'V':
@@ -339,6 +500,8 @@ int main(int argc, char **argv)
     }
 
     g_cbBlocks = g_cBlocks * MY_BLOCK_SIZE;
+    if (cThreads > g_cBlocks)
+        cThreads = (uint32_t)g_cBlocks;
     uint64_t cbTotal = (uint64_t)g_cBlocks * MY_BLOCK_SIZE * cIterations;
     uint64_t cbTotalKB = cbTotal / _1K;
     if (cbTotal / cIterations != g_cbBlocks)
@@ -416,6 +579,9 @@ int main(int argc, char **argv)
         { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_LZF,   RTZIPLEVEL_DEFAULT, "RTZipBlock/LZF"   },
         { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_LZJB,  RTZIPLEVEL_DEFAULT, "RTZipBlock/LZJB"  },
         { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_LZO,   RTZIPLEVEL_DEFAULT, "RTZipBlock/LZO"   },
+        { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_LZ4,   RTZIPLEVEL_DEFAULT, "RTZipBlock/LZ4"   },
+        { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_ZLIB,  RTZIPLEVEL_FAST,    "RTZipBlock/zlib-1" },
+        { 0, 0, 0, VINF_SUCCESS, true,  RTZIPTYPE_ZLIB,  RTZIPLEVEL_DEFAULT, "RTZipBlock/zlib"  },
     };
     RTPrintf("tstCompressionBenchmark: TESTING..");
     for (uint32_t i = 0; i < cIterations; i++)
@@ -436,34 +602,32 @@ int main(int argc, char **argv)
             uint64_t NanoTS = RTTimeNanoTS();
             if (aTests[j].fBlock)
             {
-                size_t          cbLeft     = g_cbComprAlloc;
-                uint8_t const  *pbSrcBlock = g_pabSrc;
-                uint8_t        *pbDstBlock = g_pabCompr;
-                for (size_t iBlock = 0; iBlock < g_cBlocks; iBlock += cBlocksAtATime)
+                /* Each thread gets an equal share of the blocks and of the output buffer. */
+                size_t const cBlocksPerSlice = g_cBlocks / cThreads;
+                size_t const cbComprPerSlice = (g_cbComprAlloc / cThreads) & ~(size_t)7;
+                for (uint32_t iSlice = 0; iSlice < cThreads; iSlice++)
                 {
-                    AssertBreakStmt(cbLeft > MY_BLOCK_SIZE * 4, aTests[j].rc = rc = VERR_BUFFER_OVERFLOW);
-                    uint32_t *pcb = (uint32_t *)pbDstBlock;
-                    pbDstBlock   += sizeof(uint32_t);
-                    cbLeft       -= sizeof(uint32_t);
-                    size_t  cbSrc = RT_MIN(g_cBlocks - iBlock, cBlocksAtATime) * MY_BLOCK_SIZE;
-                    size_t  cbDst;
-                    rc = RTZipBlockCompress(aTests[j].enmType, aTests[j].enmLevel, 0 /*fFlags*/,
-                                            pbSrcBlock, cbSrc,
-                                            pbDstBlock, cbLeft, &cbDst);
-                    if (RT_FAILURE(rc))
-                    {
-                        Error("RTZipBlockCompress failed for '%s' (#%u): %Rrc\n", aTests[j].pszName, j, rc);
-                        aTests[j].rc = rc;
-                        break;
-                    }
-                    *pcb        = (uint32_t)cbDst;
-                    cbLeft     -= cbDst;
-                    pbDstBlock += cbDst;
-                    pbSrcBlock += cbSrc;
+                    g_aSlices[iSlice].enmType        = aTests[j].enmType;
+                    g_aSlices[iSlice].enmLevel       = aTests[j].enmLevel;
+                    g_aSlices[iSlice].cBlocksAtATime = cBlocksAtATime;
+                    g_aSlices[iSlice].iFirstBlock    = iSlice * cBlocksPerSlice;
+                    g_aSlices[iSlice].cBlocks        = iSlice + 1 < cThreads ? cBlocksPerSlice
+                                                     : g_cBlocks - iSlice * cBlocksPerSlice;
+                    g_aSlices[iSlice].pbCompr        = &g_pabCompr[iSlice * cbComprPerSlice];
+                    g_aSlices[iSlice].cbComprAlloc   = cbComprPerSlice;
+                    g_aSlices[iSlice].cbCompr        = 0;
+                    g_aSlices[iSlice].rc             = VINF_SUCCESS;
                 }
+
+                rc = tstRunSlices(cThreads, true /*fCompress*/);
                 if (RT_FAILURE(rc))
+                {
+                    Error("RTZipBlockCompress failed for '%s' (#%u): %Rrc\n", aTests[j].pszName, j, rc);
+                    aTests[j].rc = rc;
                     continue;
-                g_cbCompr = pbDstBlock - g_pabCompr;
+                }
+                for (uint32_t iSlice = 0; iSlice < cThreads; iSlice++)
+                    g_cbCompr += g_aSlices[iSlice].cbCompr;
             }
             else
             {
@@ -510,27 +674,13 @@ int main(int argc, char **argv)
             NanoTS = RTTimeNanoTS();
             if (aTests[j].fBlock)
             {
-                uint8_t const  *pbSrcBlock = g_pabCompr;
-                uint8_t        *pbDstBlock = g_pabDecompr;
-                for (size_t iBlock = 0; iBlock < g_cBlocks; iBlock += cBlocksAtATime)
-                {
-                    size_t   cbDst = RT_MIN(g_cBlocks - iBlock, cBlocksAtATime) * MY_BLOCK_SIZE;
-                    size_t   cbSrc = *(uint32_t *)pbSrcBlock;
-                    pbSrcBlock    += sizeof(uint32_t);
-                    rc = RTZipBlockDecompress(aTests[j].enmType, 0 /*fFlags*/,
-                                              pbSrcBlock, cbSrc, &cbSrc,
-                                              pbDstBlock, cbDst, &cbDst);
-                    if (RT_FAILURE(rc))
-                    {
-                        Error("RTZipBlockDecompress failed for '%s' (#%u): %Rrc\n", aTests[j].pszName, j, rc);
-                        aTests[j].rc = rc;
-                        break;
-                    }
-                    pbDstBlock += cbDst;
-                    pbSrcBlock += cbSrc;
-                }
+                rc = tstRunSlices(cThreads, false /*fCompress*/);
                 if (RT_FAILURE(rc))
+                {
+                    Error("RTZipBlockDecompress failed for '%s' (#%u): %Rrc\n", aTests[j].pszName, j, rc);
+                    aTests[j].rc = rc;
                     continue;
+                }
             }
             else
             {
@@ -616,6 +766,7 @@ int main(int argc, char **argv)
     else
         RTPrintf("Input: %'10zu Blocks of generated rubbish              %'11zu bytes\n",
                  g_cBlocks, g_cbBlocks);
+    RTPrintf("       %'10u thread(s) for the RTZipBlock tests\n", cThreads);
 
     /*
      * Count zero blocks in the data set.
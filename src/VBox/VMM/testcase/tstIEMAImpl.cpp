@@ -4564,6 +4564,29 @@ DUMP_ALL_FN(FpuBinaryR80, g_aFpuBinaryR80)
 #endif
 
 
+static uint64_t FpuBinaryR80Bench(uint32_t cIterations, PFNIEMAIMPLFPUR80 pfn, FPU_BINARY_R80_TEST_T const *pEntry)
+{
+    X86FXSTATE State;
+    RT_ZERO(State);
+    State.FCW = pEntry->fFcw;
+    State.FSW = pEntry->fFswIn;
+    RTFLOAT80U const InVal1 = pEntry->InVal1;
+    RTFLOAT80U const InVal2 = pEntry->InVal2;
+    IEMFPURESULT     Res;
+    cIterations /= 4;
+    RTThreadYield();
+    uint64_t const nsStart = RTTimeNanoTS();
+    for (uint32_t i = 0; i < cIterations; i++)
+    {
+        pfn(&State, &Res, &InVal1, &InVal2);
+        pfn(&State, &Res, &InVal1, &InVal2);
+        pfn(&State, &Res, &InVal1, &InVal2);
+        pfn(&State, &Res, &InVal1, &InVal2);
+    }
+    return RTTimeNanoTS() - nsStart;
+}
+
+
 static void FpuBinaryR80Test(void)
 {
     X86FXSTATE State;
@@ -4601,6 +4624,17 @@ static void FpuBinaryR80Test(void)
                                  !RTFLOAT80U_ARE_IDENTICAL(&Res.r80Result, &paTests[iTest].OutVal) ? " - val" : "",
                                  FormatFcw(paTests[iTest].fFcw) );
             }
+
+            /* Benchmark if all succeeded. */
+            if (g_cPicoSecBenchmark && cTests && RTTestSubErrorCount(g_hTest) == 0)
+            {
+                uint32_t const iTest       = cTests / 2;
+                uint32_t const cIterations = EstimateIterations(_64K, FpuBinaryR80Bench(_64K, pfn, &paTests[iTest]));
+                uint64_t const cNsRealRun  = FpuBinaryR80Bench(cIterations, pfn, &paTests[iTest]);
+                RTTestValueF(g_hTest, cNsRealRun * 1000 / cIterations, RTTESTUNIT_PS_PER_CALL,
+                             "%s%s", g_aFpuBinaryR80[iFn].pszName, iVar ? "-native" : "");
+            }
+
             pfn = g_aFpuBinaryR80[iFn].pfnNative;
         }
 
@@ -5694,6 +5728,26 @@ static RTEXITCODE SseBinaryR32Generate(uint32_t cTests, const char * const *paps
 }
 #endif
 
+static uint64_t SseBinaryBench(uint32_t cIterations, PFNIEMAIMPLFPSSEF2U128 pfn, SSE_BINARY_TEST_T const *pEntry)
+{
+    uint32_t const  fMxCsrIn = pEntry->fMxcsrIn;
+    X86XMMREG const InVal1   = pEntry->InVal1;
+    X86XMMREG const InVal2   = pEntry->InVal2;
+    X86XMMREG       Res;
+    cIterations /= 4;
+    RTThreadYield();
+    uint64_t const nsStart = RTTimeNanoTS();
+    for (uint32_t i = 0; i < cIterations; i++)
+    {
+        pfn(fMxCsrIn, &Res, &InVal1, &InVal2);
+        pfn(fMxCsrIn, &Res, &InVal1, &InVal2);
+        pfn(fMxCsrIn, &Res, &InVal1, &InVal2);
+        pfn(fMxCsrIn, &Res, &InVal1, &InVal2);
+    }
+    return RTTimeNanoTS() - nsStart;
+}
+
+
 static void SseBinaryR32Test(void)
 {
     for (size_t iFn = 0; iFn < RT_ELEMENTS(g_aSseBinaryR32); iFn++)
@@ -5737,6 +5791,17 @@ static void SseBinaryR32Test(void)
                                  !fValsIdentical ? " - val" : "",
                                  FormatMxcsr(paTests[iTest].fMxcsrIn) );
             }
+
+            /* Benchmark if all succeeded. */
+            if (g_cPicoSecBenchmark && cbTests / sizeof(paTests[0]) && RTTestSubErrorCount(g_hTest) == 0)
+            {
+                uint32_t const iTest       = cbTests / sizeof(paTests[0]) / 2;
+                uint32_t const cIterations = EstimateIterations(_64K, SseBinaryBench(_64K, pfn, &paTests[iTest]));
+                uint64_t const cNsRealRun  = SseBinaryBench(cIterations, pfn, &paTests[iTest]);
+                RTTestValueF(g_hTest, cNsRealRun * 1000 / cIterations, RTTESTUNIT_PS_PER_CALL,
+                             "%s%s", g_aSseBinaryR32[iFn].pszName, iVar ? "-native" : "");
+            }
+
             pfn = g_aSseBinaryR32[iFn].pfnNative;
         }
 
@@ -5914,6 +5979,17 @@ static void SseBinaryR64Test(void)
                                  ? " - val" : "",
                                  FormatMxcsr(paTests[iTest].fMxcsrIn) );
             }
+
+            /* Benchmark if all succeeded. */
+            if (g_cPicoSecBenchmark && cTests && RTTestSubErrorCount(g_hTest) == 0)
+            {
+                uint32_t const iTest       = cTests / 2;
+                uint32_t const cIterations = EstimateIterations(_64K, SseBinaryBench(_64K, pfn, &paTests[iTest]));
+                uint64_t const cNsRealRun  = SseBinaryBench(cIterations, pfn, &paTests[iTest]);
+                RTTestValueF(g_hTest, cNsRealRun * 1000 / cIterations, RTTESTUNIT_PS_PER_CALL,
+                             "%s%s", g_aSseBinaryR64[iFn].pszName, iVar ? "-native" : "");
+            }
+
             pfn = g_aSseBinaryR64[iFn].pfnNative;
         }
 
@@ -10111,6 +10187,8 @@ int main(int argc, char **argv)
                          "  -b, --benchmark\n"
                          "    Execute tests and do 1/2 seconds of benchmarking.\n"
                          "    Repeating the option increases the benchmark duration by 0.5 seconds.\n"
+                         "    The ps/call values are reported as test values, so setting IPRT_TEST_FILE\n"
+                         "    gets them into the XML report for machine consumption.\n"
                          "\n"
                          "Test selection (both modes):\n"
                          "  -a, --all\n"
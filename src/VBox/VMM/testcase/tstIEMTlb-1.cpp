@@ -0,0 +1,116 @@
+/* $Id$ */
+/** @file
+ * IEM TLB unit tests.
+ */
+
+/*
+ * Copyright (C) 2025 Oracle and/or its affiliates.
+ *
+ * This file is part of VirtualBox base platform packages, as
+ * available from https://www.virtualbox.org.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, in version 3 of the
+ * License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+
+/*********************************************************************************************************************************
+*   Header Files                                                                                                                 *
+*********************************************************************************************************************************/
+#define LOG_GROUP LOG_GROUP_IEM
+#define VMCPU_INCL_CPUM_GST_CTX
+#include <VBox/vmm/iem.h>
+#include <VBox/vmm/pgm.h>
+#include <VBox/vmm/vmapi.h>
+#include <VBox/err.h>
+#include "IEMInternal.h"
+#include <VBox/vmm/vmcc.h>
+#ifdef VBOX_VMM_TARGET_X86
+# include "../VMMAll/target-x86/IEMAllTlbInline-x86.h"
+#endif
+
+#include <iprt/assert.h>
+
+#include "tstVMMUnitTests-1.h"
+
+
+#if defined(VBOX_VMM_TARGET_X86) && defined(IEM_WITH_DATA_TLB) && defined(IEMTLB_WITH_L2_LARGE_PAGES)
+
+/**
+ * Loads a second level TLB entry for a 2MB page mapping @a GCPtr 1:1.
+ */
+static void testL2LoadBigPage(PVMCPUCC pVCpu, IEMTLB *pTlb, RTGCPTR GCPtr)
+{
+    PGMPTWALKFAST Walk;
+    PGMPTWALKFAST_ZERO(&Walk);
+    Walk.GCPtr      = GCPtr;
+    Walk.GCPhys     = GCPtr;
+    Walk.fInfo      = PGM_WALKINFO_SUCCEEDED | PGM_WALKINFO_BIG_PAGE;
+    Walk.fFailed    = PGM_WALKFAIL_SUCCESS;
+    Walk.fEffective = X86_PTE_P | X86_PTE_RW | X86_PTE_US | X86_PTE_A | X86_PTE_D;
+    iemTlbL2Load(pVCpu, pTlb, &Walk);
+}
+
+
+/**
+ * Checks the second level large page TLB, on the EMT.
+ */
+static DECLCALLBACK(void) testL2LargePagesOnEmt(PVM pVM)
+{
+    PVMCPUCC const pVCpu = pVM->apCpusR3[0];
+    IEMTLB * const pTlb  = &ITLBS(pVCpu).Data;
+    RTGCPTR const  GCPtr = UINT32_C(0x00345678); /* bit 20 set in the granule offset */
+    PGMPTWALKFAST  Walk;
+
+    RTTESTI_CHECK_RETV(PGMPhysIsA20Enabled(pVCpu));
+    iemTlbL2InvalidateAll(pTlb);
+
+    /* A20 enabled: hits come straight out of the L2. */
+    testL2LoadBigPage(pVCpu, pTlb, GCPtr & ~(RTGCPTR)(_2M - 1));
+    uint64_t cHits = pTlb->cTlbL2Hits;
+    RTTESTI_CHECK_RC(iemTlbQueryPageFast(pVCpu, pTlb, GCPtr, PGMQPAGE_F_READ, &Walk), VINF_SUCCESS);
+    RTTESTI_CHECK(pTlb->cTlbL2Hits == cHits + 1);
+    RTTESTI_CHECK(Walk.GCPhys == GCPtr);
+    RTTESTI_CHECK(Walk.fInfo & PGM_WALKINFO_BIG_PAGE);
+
+    /* A20 disabled: the L2 cannot mask bit 20 of the offset, so it must be
+       neither consulted nor loaded.  (The A20 change flushes the IEM TLBs, so
+       reload the entry to make sure it would otherwise hit.) */
+    PGMR3PhysSetA20(pVCpu, false);
+    testL2LoadBigPage(pVCpu, pTlb, GCPtr & ~(RTGCPTR)(_2M - 1));
+    cHits                 = pTlb->cTlbL2Hits;
+    uint64_t const cLoads = pTlb->cTlbL2Loads;
+    RTTESTI_CHECK_RC(iemTlbQueryPageFast(pVCpu, pTlb, GCPtr, PGMQPAGE_F_READ, &Walk), VINF_SUCCESS);
+    RTTESTI_CHECK(pTlb->cTlbL2Hits == cHits);
+    RTTESTI_CHECK(pTlb->cTlbL2Loads == cLoads);
+    RTTESTI_CHECK(!(Walk.fInfo & PGM_WALKINFO_BIG_PAGE));
+
+    PGMR3PhysSetA20(pVCpu, true);
+    iemTlbL2InvalidateAll(pTlb);
+}
+
+#endif /* VBOX_VMM_TARGET_X86 && IEM_WITH_DATA_TLB && IEMTLB_WITH_L2_LARGE_PAGES */
+
+
+void testIEMTlb(PVM pVM)
+{
+    RTTestISub("iemTlbQueryPageFast (L2 large pages)");
+#if defined(VBOX_VMM_TARGET_X86) && defined(IEM_WITH_DATA_TLB) && defined(IEMTLB_WITH_L2_LARGE_PAGES)
+    RTTESTI_CHECK_RC_OK(VMR3ReqCallVoidWait(pVM, 0, (PFNRT)testL2LargePagesOnEmt, 1, pVM));
+#else
+    RT_NOREF(pVM);
+    RTTestSkipped(g_hTest, "No second level data TLB in this build");
+#endif
+}
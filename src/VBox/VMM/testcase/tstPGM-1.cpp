@@ -37,6 +37,7 @@
 #include "PGMInline.h"
 
 #include <iprt/assert.h>
+#include <iprt/mem.h>
 
 #include "tstVMMUnitTests-1.h"
 
@@ -302,6 +303,63 @@ static DECLCALLBACK(int) AddTopRamRange(PVM pVM)
 }
 
 
+/**
+ * Checks that a write monitored page the NEM dirty log reports as written to
+ * after it was saved gets marked dirty again, so the next pass re-sends it.
+ */
+static void testLiveSaveRescan(PVM pVM)
+{
+    RTTestISub("pgmR3ScanWriteMonitoredRamPage");
+
+    PPGMRAMRANGE pRam = (PPGMRAMRANGE)RTMemAllocZ(RT_UOFFSETOF_DYN(PGMRAMRANGE, aPages[2]));
+    RTTESTI_CHECK_RETV(pRam);
+    pRam->cb = 2 * GUEST_PAGE_SIZE;
+    for (uint32_t iPage = 0; iPage < 2; iPage++)
+        PGM_PAGE_INIT(&pRam->aPages[iPage], 0, NIL_GMM_PAGEID, PGMPAGETYPE_RAM, PGM_PAGE_STATE_WRITE_MONITORED);
+
+    /* Both pages were sent by pass 1, so they are write monitored, clean and ready. */
+    PGMLIVESAVERAMPAGE aLSPages[2];
+    RT_ZERO(aLSPages);
+    aLSPages[0].fWriteMonitored = aLSPages[1].fWriteMonitored = 1;
+
+    uint32_t const cSavedReady = pVM->pgm.s.LiveSave.Ram.cReadyPages;
+    uint32_t const cSavedDirty = pVM->pgm.s.LiveSave.Ram.cDirtyPages;
+    pVM->pgm.s.LiveSave.Ram.cReadyPages = 2;
+    pVM->pgm.s.LiveSave.Ram.cDirtyPages = 0;
+
+    /* The guest writes page 0 behind our back (KVM), the dirty log reports it. */
+    pgmR3ScanWriteMonitoredRamPage(pVM, pRam, aLSPages, 0, true /*fNemDirty*/);
+    pgmR3ScanWriteMonitoredRamPage(pVM, pRam, aLSPages, 1, false /*fNemDirty*/);
+    RTTESTI_CHECK(aLSPages[0].fDirty == 1);
+    RTTESTI_CHECK(aLSPages[0].fWriteMonitoredJustNow == 1);
+    RTTESTI_CHECK(aLSPages[0].cDirtied == 1);
+    RTTESTI_CHECK(aLSPages[1].fDirty == 0);
+    RTTESTI_CHECK(pVM->pgm.s.LiveSave.Ram.cReadyPages == 1);
+    RTTESTI_CHECK(pVM->pgm.s.LiveSave.Ram.cDirtyPages == 1);
+
+    /* Reported again: still dirty, but must not be counted twice. */
+    pgmR3ScanWriteMonitoredRamPage(pVM, pRam, aLSPages, 0, true /*fNemDirty*/);
+    RTTESTI_CHECK(pVM->pgm.s.LiveSave.Ram.cDirtyPages == 1);
+    RTTESTI_CHECK(aLSPages[0].cDirtied == 1);
+
+    /* Quiet for a scan: now due for the next pass (dirty and not just monitored). */
+    pgmR3ScanWriteMonitoredRamPage(pVM, pRam, aLSPages, 0, false /*fNemDirty*/);
+    RTTESTI_CHECK(aLSPages[0].fDirty == 1 && aLSPages[0].fWriteMonitoredJustNow == 0);
+    RTTESTI_CHECK(aLSPages[1].fDirty == 0 && aLSPages[1].fWriteMonitoredJustNow == 0);
+
+    /* Write locked pages count as modified just the same. */
+    PGM_PAGE_INC_WRITE_LOCKS(&pRam->aPages[1]);
+    pgmR3ScanWriteMonitoredRamPage(pVM, pRam, aLSPages, 1, false /*fNemDirty*/);
+    RTTESTI_CHECK(aLSPages[1].fDirty == 1);
+    RTTESTI_CHECK(pVM->pgm.s.LiveSave.Ram.cReadyPages == 0);
+    RTTESTI_CHECK(pVM->pgm.s.LiveSave.Ram.cDirtyPages == 2);
+
+    pVM->pgm.s.LiveSave.Ram.cReadyPages = cSavedReady;
+    pVM->pgm.s.LiveSave.Ram.cDirtyPages = cSavedDirty;
+    RTMemFree(pRam);
+}
+
+
 void testPGM(PVM pVM)
 {
     /*
@@ -336,5 +394,7 @@ void testPGM(PVM pVM)
     testPhysGetPage<testPgmPhysGetPageExSlow>(pVM);
     RTTestISub("pgmPhysGetPageAndRangeExSlowLockless (2nd round)");
     testPhysGetPage<testPgmPhysGetPageAndRangeExSlowLockless, true>(pVM);
+
+    testLiveSaveRescan(pVM);
 }
 
@@ -1126,6 +1126,7 @@
     GEN_CHECK_OFF(VMM, fRCLoggerFlushingDisabled);
     GEN_CHECK_OFF(VMM, fStackGuardsStationed);
     GEN_CHECK_OFF(VMM, fUsePeriodicPreemptionTimers);
+    GEN_CHECK_OFF(VMM, cNsHaltPollMax);
     GEN_CHECK_OFF(VMM, pYieldTimer);
     GEN_CHECK_OFF(VMM, cYieldResumeMillies);
     GEN_CHECK_OFF(VMM, cYieldEveryMillies);